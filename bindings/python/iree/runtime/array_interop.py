@@ -22,6 +22,7 @@ from .binding import (
 __all__ = [
     "asdevicearray",
     "DeviceArray",
+    "from_dlpack",
 ]
 
 _DEVICE_HANDLED_FUNCTIONS = {}
@@ -143,6 +144,17 @@ class DeviceArray(numpy.lib.mixins.NDArrayOperatorsMixin):
     host_ary = self.to_host()
     return host_ary.astype(dtype, casting=casting, copy=copy)
 
+  def __dlpack__(self, stream=None):
+    """Exports the array as a DLPack capsule without copying.
+
+    Only arrays backed by host-visible memory can be exported. The consumer
+    shares the memory with this array.
+    """
+    return self._buffer_view.__dlpack__(stream)
+
+  def __dlpack_device__(self):
+    return self._buffer_view.__dlpack_device__()
+
   def __reduce__(self):
     # Since this is used for making deep copies and pickling, we map
     # separately from any interactive state. We just reduce to the actual
@@ -206,6 +218,33 @@ def asdevicearray(device: HalDevice,
                      override_dtype=a.dtype)
 
 
+def from_dlpack(device: HalDevice,
+                x,
+                *,
+                implicit_host_transfer: bool = False,
+                memory_type=MemoryType.DEVICE_LOCAL | MemoryType.DEVICE_VISIBLE,
+                allowed_usage=BufferUsage.ALL) -> DeviceArray:
+  """Creates a DeviceArray aliasing a DLPack tensor without copying.
+
+  `x` may be any object implementing `__dlpack__` (such as a PyTorch tensor or
+  a numpy array) or a DLPack capsule. Only compact tensors in host memory that
+  the device can access directly are supported; use `asdevicearray` to copy
+  other tensors. The producer's memory is kept alive for as long as the
+  returned array (or any buffer derived from it) is in use.
+  """
+  capsule = x.__dlpack__() if hasattr(x, "__dlpack__") else x
+  buffer_view = device.allocator.import_dlpack(memory_type=memory_type,
+                                               allowed_usage=allowed_usage,
+                                               capsule=capsule)
+  override_dtype = None
+  if buffer_view.element_type == int(HalElementType.BOOL_8):
+    override_dtype = np.bool_
+  return DeviceArray(device,
+                     buffer_view,
+                     implicit_host_transfer=implicit_host_transfer,
+                     override_dtype=override_dtype)
+
+
 # NOTE: Numpy dtypes are not hashable and exist in a hierarchy that should
 # be queried via isinstance checks. This should be done as a fallback but
 # this is a linear list for quick access to the most common. There may also
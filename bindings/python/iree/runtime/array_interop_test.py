@@ -107,6 +107,33 @@ class DeviceHalTest(unittest.TestCase):
     self.assertEqual(f32_copy.dtype, np.float32)
     np.testing.assert_array_equal(orig_ary.astype(np.float32), f32_copy)
 
+  @unittest.skipUnless(hasattr(np, "from_dlpack"), "requires numpy DLPack")
+  def testDLPackExport(self):
+    init_ary = np.zeros([3, 4], dtype=np.float32) + 2
+    ary = iree.runtime.asdevicearray(self.device, init_ary)
+    self.assertEqual((1, 0), ary.__dlpack_device__())
+    host_ary = np.from_dlpack(ary)
+    np.testing.assert_array_equal(host_ary, init_ary)
+
+  @unittest.skipUnless(hasattr(np, "from_dlpack"), "requires numpy DLPack")
+  def testDLPackImport(self):
+    storage = np.zeros(3 * 4 * 4 + 16, dtype=np.uint8)
+    offset = -storage.ctypes.data % 16
+    init_ary = storage[offset:offset + 48].view(np.float32).reshape([3, 4])
+    init_ary[...] = 2
+    ary = iree.runtime.from_dlpack(self.device, init_ary)
+    self.assertEqual([3, 4], ary.shape)
+    self.assertEqual(np.float32, ary.dtype)
+    # The device array aliases the producer's memory.
+    init_ary[0, 0] = 5
+    np.testing.assert_array_equal(ary.to_host(), init_ary)
+
+  @unittest.skipUnless(hasattr(np, "from_dlpack"), "requires numpy DLPack")
+  def testDLPackImportNonCompact(self):
+    init_ary = np.zeros([4, 4], dtype=np.float32)[:, ::2]
+    with self.assertRaises(ValueError):
+      iree.runtime.from_dlpack(self.device, init_ary)
+
 
 if __name__ == "__main__":
   unittest.main()
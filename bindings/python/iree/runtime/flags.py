@@ -10,3 +10,10 @@ from .binding import parse_flags
 # event of errors, this will yield nicer error messages but comes with a
 # runtime cost.
 FUNCTION_INPUT_VALIDATION = True
+
+# When enabled, host arrays passed as function inputs alias the device buffer
+# without a copy when the device can access host memory directly and the array
+# is writable, C-contiguous and 16-byte aligned. The array is kept alive for as
+# long as the device buffer is in use and must not be modified until the
+# function returns (and any results aliasing it are released).
+FUNCTION_INPUT_ZERO_COPY = True
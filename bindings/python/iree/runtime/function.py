@@ -7,13 +7,16 @@
 
 from typing import Dict, Optional
 
+import concurrent.futures
 import json
 import logging
+import threading
 
 import numpy as np
 
 from .binding import (
     BufferUsage,
+    CallPlan,
     HalBufferView,
     HalDevice,
     HalElementType,
@@ -29,10 +32,13 @@ from .array_interop import (
     DeviceArray,
 )
 from .flags import (
-    FUNCTION_INPUT_VALIDATION,)
+    FUNCTION_INPUT_VALIDATION,
+    FUNCTION_INPUT_ZERO_COPY,
+)
 
 __all__ = [
     "FunctionInvoker",
+    "set_async_invoke_executor",
 ]
 
 
@@ -73,6 +79,30 @@ class Invocation:
     return f"{vm_repr} with description {self.current_desc}"
 
 
+_async_invoke_executor = None  # type: Optional[concurrent.futures.Executor]
+_async_invoke_executor_lock = threading.Lock()
+
+
+def _get_async_invoke_executor() -> concurrent.futures.Executor:
+  global _async_invoke_executor
+  with _async_invoke_executor_lock:
+    if _async_invoke_executor is None:
+      _async_invoke_executor = concurrent.futures.ThreadPoolExecutor(
+          thread_name_prefix="iree-invoke")
+    return _async_invoke_executor
+
+
+def set_async_invoke_executor(executor: concurrent.futures.Executor):
+  """Sets the executor used by `FunctionInvoker.invoke_async`.
+
+  Defaults to a shared thread pool sized by the Python runtime. Serving
+  frontends may want a pool sized to the number of contexts being driven.
+  """
+  global _async_invoke_executor
+  with _async_invoke_executor_lock:
+    _async_invoke_executor = executor
+
+
 class FunctionInvoker:
   """Wraps a VmFunction, enabling invocations against it."""
   __slots__ = [
@@ -86,12 +116,22 @@ class FunctionInvoker:
       "_max_named_arg_index",
       "_has_inlined_results",
       "_tracer",
+      "_invoke_lock",
+      "_call_plan",
+      "_ret_dtypes",
   ]
 
-  def __init__(self, vm_context: VmContext, device: HalDevice,
+  def __init__(self,
+               vm_context: VmContext,
+               device: HalDevice,
                vm_function: VmFunction,
-               tracer: Optional[tracing.ContextTracer]):
+               tracer: Optional[tracing.ContextTracer],
+               invoke_lock: Optional[threading.Lock] = None):
     self._vm_context = vm_context
+    # VM contexts are thread-compatible: invocations against the same context
+    # from multiple threads are serialized with this lock, if provided. The
+    # marshaling of arguments and results happens outside of the lock.
+    self._invoke_lock = invoke_lock
     # TODO: Needing to know the precise device to allocate on here is bad
     # layering and will need to be fixed in some fashion if/when doing
     # heterogenous dispatch.
@@ -104,13 +144,21 @@ class FunctionInvoker:
     self._has_inlined_results = False
     self._named_arg_indices: Dict[str, int] = {}
     self._max_named_arg_index: int = -1
+    self._call_plan: Optional[CallPlan] = None
+    self._ret_dtypes = None
     self._parse_abi_dict(vm_function)
+    self._build_call_plan()
 
   @property
   def vm_function(self) -> VmFunction:
     return self._vm_function
 
   def __call__(self, *args, **kwargs):
+    if self._call_plan is not None and not kwargs and not self._tracer:
+      lists = self._call_plan.marshal(args)
+      if lists is not None:
+        return self._call_with_plan(*lists)
+
     call_trace = None  # type: Optional[tracing.CallTrace]
     if self._tracer:
       call_trace = self._tracer.start_call(self._vm_function)
@@ -142,8 +190,10 @@ class FunctionInvoker:
       _merge_python_sequence_to_vm(inv, arg_list, args, self._arg_descs)
       if call_trace:
         call_trace.add_vm_list(arg_list, "args")
+        call_trace.begin_invoke()
       self._invoke(arg_list, ret_list)
       if call_trace:
+        call_trace.end_invoke()
         call_trace.add_vm_list(ret_list, "results")
 
       # Un-inline the results to align with reflection, as needed.
@@ -164,9 +214,72 @@ class FunctionInvoker:
       if call_trace:
         call_trace.end_call()
 
+  def _call_with_plan(self, arg_list, ret_list):
+    try:
+      self._invoke(arg_list, ret_list)
+      buffer_views = self._call_plan.unmarshal(ret_list)
+    finally:
+      self._call_plan.recycle(arg_list, ret_list)
+    returns = [
+        DeviceArray(self._device,
+                    buffer_view,
+                    implicit_host_transfer=True,
+                    override_dtype=dtype)
+        for buffer_view, dtype in zip(buffer_views, self._ret_dtypes)
+    ]
+    if len(returns) == 1:
+      return returns[0]
+    elif not returns:
+      return None
+    return tuple(returns)
+
+  def _build_call_plan(self):
+    # Functions with signatures of only ndarrays (the common case for models)
+    # are marshaled natively. Anything else, or arguments that need conversion
+    # or produce validation errors, use the general Python converters.
+    if self._arg_descs is None or self._has_inlined_results:
+      return
+    argument_specs = []
+    for desc in self._arg_descs:
+      if not _is_ndarray_descriptor(desc):
+        return
+      dtype = ABI_TYPE_TO_DTYPE.get(desc[1])
+      element_type = map_dtype_to_element_type(dtype)
+      if element_type is None:
+        return
+      dims = [-1 if dim is None else dim for dim in desc[3:]]
+      argument_specs.append((element_type, np.dtype(dtype), dims))
+    ret_dtypes = []
+    for desc in self._ret_descs:
+      if not _is_ndarray_descriptor(desc) or desc[1] not in ABI_TYPE_TO_DTYPE:
+        return
+      ret_dtypes.append(ABI_TYPE_TO_DTYPE[desc[1]])
+    self._ret_dtypes = ret_dtypes
+    self._call_plan = CallPlan(device=self._device,
+                               memory_type=IMPLICIT_BUFFER_ARG_MEMORY_TYPE,
+                               allowed_usage=IMPLICIT_BUFFER_ARG_USAGE,
+                               zero_copy=FUNCTION_INPUT_ZERO_COPY,
+                               device_array_type=DeviceArray,
+                               argument_specs=argument_specs,
+                               result_count=len(ret_dtypes))
+
+  def invoke_async(self, *args, **kwargs) -> concurrent.futures.Future:
+    """Invokes the function on a background thread.
+
+    Returns a future resolving to the same results as `__call__`. The GIL is
+    released while the function executes so that the caller (and other
+    invocations on other contexts) can make progress. Use
+    `asyncio.wrap_future` to await the result from an asyncio event loop.
+    """
+    return _get_async_invoke_executor().submit(self, *args, **kwargs)
+
   # Break out invoke so it shows up in profiles.
   def _invoke(self, arg_list, ret_list):
-    self._vm_context.invoke(self._vm_function, arg_list, ret_list)
+    if self._invoke_lock is None:
+      self._vm_context.invoke(self._vm_function, arg_list, ret_list)
+      return
+    with self._invoke_lock:
+      self._vm_context.invoke(self._vm_function, arg_list, ret_list)
 
   def _parse_abi_dict(self, vm_function: VmFunction):
     reflection = vm_function.reflection
@@ -259,7 +372,11 @@ def _list_or_tuple_to_vm(inv: Invocation, t: VmVariantList, x, desc):
     _raise_argument_error(inv,
                           f"mismatched list/tuple arity: {len(x)} vs {arity}")
   sub_list = VmVariantList(arity)
-  _merge_python_sequence_to_vm(inv, sub_list, x, sub_descriptors)
+  if _is_int_sequence(x, sub_descriptors):
+    # Homogeneous integer sequences (such as shapes) are copied in bulk.
+    sub_list.push_ints(x)
+  else:
+    _merge_python_sequence_to_vm(inv, sub_list, x, sub_descriptors)
   t.push_list(sub_list)
 
 
@@ -326,12 +443,22 @@ def _ndarray_to_vm(inv: Invocation, t: VmVariantList, x, desc):
     # Already one of ours and did not get implicitly converted.
     buffer_view = x._buffer_view
   else:
-    # Not one of ours. Put it on the device.
-    buffer_view = inv.device.allocator.allocate_buffer_copy(
-        memory_type=IMPLICIT_BUFFER_ARG_MEMORY_TYPE,
-        allowed_usage=IMPLICIT_BUFFER_ARG_USAGE,
-        buffer=np.asarray(x),
-        element_type=element_type)
+    # Not one of ours. Alias it if the device can access the host memory
+    # directly and otherwise put it on the device.
+    x = np.asarray(x)
+    buffer_view = None
+    if FUNCTION_INPUT_ZERO_COPY:
+      buffer_view = inv.device.allocator.try_wrap_buffer_view(
+          memory_type=IMPLICIT_BUFFER_ARG_MEMORY_TYPE,
+          allowed_usage=IMPLICIT_BUFFER_ARG_USAGE,
+          buffer=x,
+          element_type=element_type)
+    if buffer_view is None:
+      buffer_view = inv.device.allocator.allocate_buffer_copy(
+          memory_type=IMPLICIT_BUFFER_ARG_MEMORY_TYPE,
+          allowed_usage=IMPLICIT_BUFFER_ARG_USAGE,
+          buffer=x,
+          element_type=element_type)
 
   t.push_buffer_view(buffer_view)
 
@@ -443,6 +570,9 @@ def _vm_to_pylist(inv: Invocation, vm_list: VmVariantList, vm_index: int, desc):
   #   ['pylist', element_type]
   sub_vm_list = vm_list.get_as_list(vm_index)
   element_type_desc = desc[1:]
+  if len(element_type_desc) == 1 and _is_int_descriptor(element_type_desc[0]):
+    # Integer lists are read in bulk.
+    return sub_vm_list.get_as_ints(0, len(sub_vm_list))
   py_items = _extract_vm_sequence_to_python(
       inv, sub_vm_list, element_type_desc * len(sub_vm_list))
   return py_items
@@ -493,6 +623,17 @@ def _is_0d_ndarray_descriptor(desc):
   return desc and desc[0] == "ndarray" and desc[2] == 0
 
 
+def _is_int_descriptor(desc):
+  return desc in ("i8", "i16", "i32", "i64")
+
+
+def _is_int_sequence(py_list, descs):
+  # Python bools are ints and are passed as such (see _bool_to_vm).
+  return (len(py_list) > 0 and
+          all(x.__class__ in (int, bool) for x in py_list) and
+          all(_is_int_descriptor(d) for d in descs))
+
+
 def _cast_scalar_to_ndarray(inv: Invocation, x, desc):
   # Example descriptor: ["ndarray", "f32", 0]
   dtype_str = desc[1]
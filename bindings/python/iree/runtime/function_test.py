@@ -7,6 +7,7 @@
 
 import json
 import numpy as np
+import threading
 
 from absl.testing import absltest
 
@@ -61,6 +62,68 @@ class FunctionTest(absltest.TestCase):
     self.assertEqual("[<VmVariantList(2): [1, 2]>]", vm_context.mock_arg_reprs)
     self.assertEqual((3, 4), result)
 
+  def testCallPlanReusesArgumentLists(self):
+    invoked_arg_lists = []
+
+    def invoke(arg_list, ret_list):
+      invoked_arg_lists.append(arg_list)
+      ret_list.push_buffer_view(arg_list.get_as_buffer_view(0))
+
+    vm_context = MockVmContext(invoke)
+    vm_function = MockVmFunction(reflection={
+        "iree.abi": json.dumps({
+            "a": [["ndarray", "i32", 1, None]],
+            "r": [["ndarray", "i32", 1, None]],
+        })
+    })
+    invoker = FunctionInvoker(vm_context, self.device, vm_function, tracer=None)
+    result0 = invoker(np.asarray([1, 2], dtype=np.int32))
+    result1 = invoker(np.asarray([3, 4, 5], dtype=np.int32))
+    np.testing.assert_array_equal([1, 2], result0)
+    np.testing.assert_array_equal([3, 4, 5], result1)
+    # Lists are cleared after each call and reused by the next.
+    self.assertIs(invoked_arg_lists[0], invoked_arg_lists[1])
+    self.assertEqual(0, len(invoked_arg_lists[0]))
+
+  def testCallPlanFallback(self):
+    invoked_arg_list = None
+
+    def invoke(arg_list, ret_list):
+      nonlocal invoked_arg_list
+      invoked_arg_list = repr(arg_list)
+
+    vm_context = MockVmContext(invoke)
+    vm_function = MockVmFunction(reflection={
+        "iree.abi": json.dumps({
+            "a": [["ndarray", "i32", 1, 2]],
+            "r": [],
+        })
+    })
+    invoker = FunctionInvoker(vm_context, self.device, vm_function, tracer=None)
+    # Python lists need conversion and take the general path.
+    invoker([1, 0])
+    self.assertEqual("<VmVariantList(1): [HalBufferView(2:0x20000011)]>",
+                     invoked_arg_list)
+
+  def testInvokeAsync(self):
+    invoke_lock = threading.Lock()
+
+    def invoke(arg_list, ret_list):
+      # Invocations happen with the context lock held.
+      self.assertTrue(invoke_lock.locked())
+      ret_list.push_int(arg_list.get_variant(0) + 1)
+
+    vm_context = MockVmContext(invoke)
+    vm_function = MockVmFunction(reflection={})
+    invoker = FunctionInvoker(vm_context,
+                              self.device,
+                              vm_function,
+                              tracer=None,
+                              invoke_lock=invoke_lock)
+    futures = [invoker.invoke_async(i) for i in range(8)]
+    self.assertEqual([i + 1 for i in range(8)], [f.result() for f in futures])
+    self.assertEqual(8, len(vm_context.invocations))
+
   def testKeywordArgs(self):
 
     def invoke(arg_list, ret_list):
@@ -251,7 +314,8 @@ class FunctionTest(absltest.TestCase):
 
     def invoke(arg_list, ret_list):
       nonlocal invoked_arg_list
-      invoked_arg_list = arg_list
+      # Captured during the invocation as argument lists are reused.
+      invoked_arg_list = repr(arg_list)
 
     vm_context = MockVmContext(invoke)
     vm_function = MockVmFunction(reflection={
@@ -263,7 +327,7 @@ class FunctionTest(absltest.TestCase):
     invoker = FunctionInvoker(vm_context, self.device, vm_function, tracer=None)
     result = invoker(arg_array)
     self.assertEqual("<VmVariantList(1): [HalBufferView(2:0x20000011)]>",
-                     repr(invoked_arg_list))
+                     invoked_arg_list)
 
   def testDeviceArrayArg(self):
     # Note that since the device array is set up to disallow implicit host
@@ -277,7 +341,8 @@ class FunctionTest(absltest.TestCase):
 
     def invoke(arg_list, ret_list):
       nonlocal invoked_arg_list
-      invoked_arg_list = arg_list
+      # Captured during the invocation as argument lists are reused.
+      invoked_arg_list = repr(arg_list)
 
     vm_context = MockVmContext(invoke)
     vm_function = MockVmFunction(reflection={
@@ -289,7 +354,7 @@ class FunctionTest(absltest.TestCase):
     invoker = FunctionInvoker(vm_context, self.device, vm_function, tracer=None)
     result = invoker(arg_array)
     self.assertEqual("<VmVariantList(1): [HalBufferView(2:0x20000011)]>",
-                     repr(invoked_arg_list))
+                     invoked_arg_list)
 
   def testBufferViewArg(self):
     arg_buffer_view = self.device.allocator.allocate_buffer_copy(
@@ -302,7 +367,8 @@ class FunctionTest(absltest.TestCase):
 
     def invoke(arg_list, ret_list):
       nonlocal invoked_arg_list
-      invoked_arg_list = arg_list
+      # Captured during the invocation as argument lists are reused.
+      invoked_arg_list = repr(arg_list)
 
     vm_context = MockVmContext(invoke)
     vm_function = MockVmFunction(reflection={
@@ -314,7 +380,7 @@ class FunctionTest(absltest.TestCase):
     invoker = FunctionInvoker(vm_context, self.device, vm_function, tracer=None)
     _ = invoker(arg_buffer_view)
     self.assertEqual("<VmVariantList(1): [HalBufferView(2:0x20000011)]>",
-                     repr(invoked_arg_list))
+                     invoked_arg_list)
 
   def testBufferViewArgNoReflection(self):
     arg_buffer_view = self.device.allocator.allocate_buffer_copy(
@@ -327,14 +393,15 @@ class FunctionTest(absltest.TestCase):
 
     def invoke(arg_list, ret_list):
       nonlocal invoked_arg_list
-      invoked_arg_list = arg_list
+      # Captured during the invocation as argument lists are reused.
+      invoked_arg_list = repr(arg_list)
 
     vm_context = MockVmContext(invoke)
     vm_function = MockVmFunction(reflection={})
     invoker = FunctionInvoker(vm_context, self.device, vm_function, tracer=None)
     _ = invoker(arg_buffer_view)
     self.assertEqual("<VmVariantList(1): [HalBufferView(2:0x20000011)]>",
-                     repr(invoked_arg_list))
+                     invoked_arg_list)
 
   def testReturnBufferView(self):
     result_array = np.asarray([1, 0], dtype=np.int32)
@@ -6,6 +6,9 @@
 
 #include "bindings/python/iree/runtime/hal.h"
 
+#include <functional>
+#include <mutex>
+
 #include "iree/hal/api.h"
 #include "pybind11/numpy.h"
 
@@ -39,6 +42,231 @@ static std::string ToHexString(uint32_t value) {
   return ToHexString((const uint8_t*)&value, sizeof(value));
 }
 
+// Minimum alignment of wrapped host memory. Matches the alignment of heap
+// buffers allocated by the HAL (see iree/hal/buffer_heap.c).
+static constexpr uintptr_t kMinWrappedBufferAlignment = 16;
+
+// Releases of Python-owned memory backing HAL buffers.
+// HAL buffers may be destroyed on runtime threads that do not hold the GIL
+// (such as task executor workers retiring a submission) while the thread that
+// owns the GIL is blocked waiting on them. Releases requested without the GIL
+// are queued and performed the next time the bindings are entered.
+class DeferredReleases {
+ public:
+  static void Release(std::function<void()> release_fn) {
+    if (Py_IsInitialized() && PyGILState_Check()) {
+      release_fn();
+      return;
+    }
+    std::lock_guard<std::mutex> lock(mutex());
+    pending().push_back(std::move(release_fn));
+  }
+
+  // Performs all pending releases. Must be called with the GIL held.
+  static void Flush() {
+    std::vector<std::function<void()>> releases;
+    {
+      std::lock_guard<std::mutex> lock(mutex());
+      releases.swap(pending());
+    }
+    for (auto& release_fn : releases) release_fn();
+  }
+
+ private:
+  static std::mutex& mutex() {
+    static std::mutex* mutex = new std::mutex();
+    return *mutex;
+  }
+  static std::vector<std::function<void()>>& pending() {
+    static auto* pending = new std::vector<std::function<void()>>();
+    return *pending;
+  }
+};
+
+// An iree_allocator_t that invokes |release_fn| when the buffer wrapping the
+// memory frees it.
+struct WrappedMemoryReleaser {
+  std::function<void()> release_fn;
+
+  static iree_status_t Ctl(void* self, iree_allocator_command_t command,
+                           const void* params, void** inout_ptr) {
+    if (command != IREE_ALLOCATOR_COMMAND_FREE) {
+      return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                              "wrapped Python memory can only be freed");
+    }
+    auto* releaser = static_cast<WrappedMemoryReleaser*>(self);
+    DeferredReleases::Release(std::move(releaser->release_fn));
+    delete releaser;
+    return iree_ok_status();
+  }
+
+  static iree_allocator_t Create(std::function<void()> release_fn) {
+    iree_allocator_t allocator;
+    allocator.self = new WrappedMemoryReleaser{std::move(release_fn)};
+    allocator.ctl = &WrappedMemoryReleaser::Ctl;
+    return allocator;
+  }
+};
+
+// Wraps |data| in a buffer view of the given shape and element type.
+// |release_fn| is invoked once the buffer is destroyed or the wrap fails.
+static iree_status_t WrapBufferView(iree_hal_allocator_t* allocator,
+                                    int memory_type, int allowed_usage,
+                                    iree_byte_span_t data,
+                                    const std::vector<iree_hal_dim_t>& dims,
+                                    iree_hal_element_type_t element_type,
+                                    std::function<void()> release_fn,
+                                    iree_hal_buffer_view_t** out_buffer_view) {
+  iree_allocator_t data_allocator =
+      WrappedMemoryReleaser::Create(std::move(release_fn));
+  iree_hal_buffer_t* hal_buffer = nullptr;
+  iree_status_t status = iree_hal_allocator_wrap_buffer(
+      allocator, memory_type, IREE_HAL_MEMORY_ACCESS_ALL, allowed_usage, data,
+      data_allocator, &hal_buffer);
+  if (!iree_status_is_ok(status)) {
+    // The buffer was not created and will not free the data.
+    iree_allocator_free(data_allocator, data.data);
+    return status;
+  }
+  status = iree_hal_buffer_view_create(
+      hal_buffer, dims.data(), dims.size(), element_type,
+      IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR,
+      iree_hal_allocator_host_allocator(allocator), out_buffer_view);
+  iree_hal_buffer_release(hal_buffer);
+  return status;
+}
+
+//------------------------------------------------------------------------------
+// DLPack
+//------------------------------------------------------------------------------
+// ABI-stable subset of dlpack.h (v0.8) used for exchanging tensors with other
+// frameworks (PyTorch, JAX, CuPy, etc) via the Python array API
+// __dlpack__/__dlpack_device__ protocol.
+// See: https://dmlc.github.io/dlpack/latest/python_spec.html
+
+enum DLDeviceType : int32_t {
+  kDLCPU = 1,
+  kDLCUDA = 2,
+  kDLCUDAHost = 3,
+};
+
+struct DLDevice {
+  int32_t device_type;
+  int32_t device_id;
+};
+
+enum DLDataTypeCode : uint8_t {
+  kDLInt = 0,
+  kDLUInt = 1,
+  kDLFloat = 2,
+  kDLBfloat = 4,
+  kDLBool = 6,
+};
+
+struct DLDataType {
+  uint8_t code;
+  uint8_t bits;
+  uint16_t lanes;
+};
+
+struct DLTensor {
+  void* data;
+  DLDevice device;
+  int32_t ndim;
+  DLDataType dtype;
+  int64_t* shape;
+  int64_t* strides;
+  uint64_t byte_offset;
+};
+
+struct DLManagedTensor {
+  DLTensor dl_tensor;
+  void* manager_ctx;
+  void (*deleter)(DLManagedTensor* self);
+};
+
+static const char kDLPackCapsuleName[] = "dltensor";
+static const char kDLPackUsedCapsuleName[] = "used_dltensor";
+
+static bool MapElementTypeToDLDataType(iree_hal_element_type_t element_type,
+                                       DLDataType* out_dtype) {
+  out_dtype->lanes = 1;
+  out_dtype->bits = iree_hal_element_bit_count(element_type);
+  if (element_type ==
+      IREE_HAL_ELEMENT_TYPE_VALUE(IREE_HAL_NUMERICAL_TYPE_INTEGER_SIGNED, 1)) {
+    // Booleans are stored as bytes.
+    out_dtype->code = kDLBool;
+    out_dtype->bits = 8;
+    return true;
+  }
+  if (!iree_hal_element_is_byte_aligned(element_type)) return false;
+  switch (iree_hal_element_numerical_type(element_type)) {
+    case IREE_HAL_NUMERICAL_TYPE_INTEGER:
+    case IREE_HAL_NUMERICAL_TYPE_INTEGER_SIGNED:
+      out_dtype->code = kDLInt;
+      return true;
+    case IREE_HAL_NUMERICAL_TYPE_INTEGER_UNSIGNED:
+      out_dtype->code = kDLUInt;
+      return true;
+    case IREE_HAL_NUMERICAL_TYPE_FLOAT_IEEE:
+      out_dtype->code = kDLFloat;
+      return true;
+    case IREE_HAL_NUMERICAL_TYPE_FLOAT_BRAIN:
+      out_dtype->code = kDLBfloat;
+      return true;
+    default:
+      return false;
+  }
+}
+
+static bool MapDLDataTypeToElementType(DLDataType dtype,
+                                       iree_hal_element_type_t* out_type) {
+  if (dtype.lanes != 1 || (dtype.bits % 8) != 0) return false;
+  switch (dtype.code) {
+    case kDLInt:
+      *out_type = IREE_HAL_ELEMENT_TYPE_VALUE(
+          IREE_HAL_NUMERICAL_TYPE_INTEGER_SIGNED, dtype.bits);
+      return true;
+    case kDLUInt:
+      *out_type = IREE_HAL_ELEMENT_TYPE_VALUE(
+          IREE_HAL_NUMERICAL_TYPE_INTEGER_UNSIGNED, dtype.bits);
+      return true;
+    case kDLFloat:
+      *out_type = IREE_HAL_ELEMENT_TYPE_VALUE(
+          IREE_HAL_NUMERICAL_TYPE_FLOAT_IEEE, dtype.bits);
+      return true;
+    case kDLBfloat:
+      *out_type = IREE_HAL_ELEMENT_TYPE_VALUE(
+          IREE_HAL_NUMERICAL_TYPE_FLOAT_BRAIN, dtype.bits);
+      return true;
+    case kDLBool:
+      if (dtype.bits != 8) return false;
+      *out_type = IREE_HAL_ELEMENT_TYPE_VALUE(
+          IREE_HAL_NUMERICAL_TYPE_INTEGER_SIGNED, 1);
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Manager context of an exported DLPack tensor. Owns the mapping of the buffer
+// (and through it a reference to the buffer view) along with the shape storage.
+struct DLPackExportContext {
+  DLManagedTensor managed;
+  iree_hal_buffer_view_t* buffer_view = nullptr;
+  iree_hal_buffer_mapping_t mapping = {{0}};
+  std::vector<int64_t> shape;
+
+  ~DLPackExportContext() {
+    iree_status_ignore(iree_hal_buffer_unmap_range(&mapping));
+    iree_hal_buffer_view_release(buffer_view);
+  }
+
+  static void Deleter(DLManagedTensor* managed) {
+    delete static_cast<DLPackExportContext*>(managed->manager_ctx);
+  }
+};
+
 }  // namespace
 
 //------------------------------------------------------------------------------
@@ -125,6 +353,108 @@ py::object HalAllocator::AllocateBufferCopy(
                   py::return_value_policy::move);
 }
 
+py::object HalAllocator::TryWrapBufferView(
+    int memory_type, int allowed_usage, py::object buffer,
+    iree_hal_element_types_t element_type) {
+  DeferredReleases::Flush();
+
+  // Only writable C-contiguous buffers can be wrapped as the HAL buffer aliases
+  // the memory for its entire lifetime.
+  Py_buffer* py_view = new Py_buffer();
+  int flags = PyBUF_FORMAT | PyBUF_C_CONTIGUOUS | PyBUF_WRITABLE;
+  if (PyObject_GetBuffer(buffer.ptr(), py_view, flags) != 0) {
+    PyErr_Clear();
+    delete py_view;
+    return py::none();
+  }
+  auto release_fn = [py_view]() {
+    PyBuffer_Release(py_view);
+    delete py_view;
+  };
+  if ((reinterpret_cast<uintptr_t>(py_view->buf) &
+       (kMinWrappedBufferAlignment - 1)) != 0 ||
+      !iree_all_bits_set(iree_hal_allocator_query_buffer_compatibility(
+                             raw_ptr(), memory_type, allowed_usage,
+                             allowed_usage, py_view->len),
+                         IREE_HAL_BUFFER_COMPATIBILITY_IMPORTABLE)) {
+    release_fn();
+    return py::none();
+  }
+
+  std::vector<iree_hal_dim_t> dims(py_view->ndim);
+  std::copy(py_view->shape, py_view->shape + py_view->ndim, dims.begin());
+  iree_hal_buffer_view_t* hal_buffer_view = nullptr;
+  iree_status_t status = WrapBufferView(
+      raw_ptr(), memory_type, allowed_usage,
+      iree_make_byte_span(py_view->buf, py_view->len), dims, element_type,
+      std::move(release_fn), &hal_buffer_view);
+  if (iree_status_is_unavailable(status)) {
+    // The allocator does not support wrapping this memory; callers fall back
+    // to copying.
+    iree_status_ignore(status);
+    return py::none();
+  }
+  CheckApiStatus(status, "Error wrapping buffer");
+  return py::cast(HalBufferView::StealFromRawPtr(hal_buffer_view),
+                  py::return_value_policy::move);
+}
+
+HalBufferView HalAllocator::ImportDLPack(int memory_type, int allowed_usage,
+                                         py::capsule capsule) {
+  DeferredReleases::Flush();
+  if (!PyCapsule_IsValid(capsule.ptr(), kDLPackCapsuleName)) {
+    throw RaiseValueError("expected an unconsumed DLPack capsule");
+  }
+  auto* managed = static_cast<DLManagedTensor*>(
+      PyCapsule_GetPointer(capsule.ptr(), kDLPackCapsuleName));
+  const DLTensor& tensor = managed->dl_tensor;
+
+  // Device memory would need to be imported through the allocator of that
+  // device; only host memory can be wrapped today.
+  if (tensor.device.device_type != kDLCPU &&
+      tensor.device.device_type != kDLCUDAHost) {
+    throw RaiseValueError(
+        "only DLPack tensors in host memory can be imported");
+  }
+  iree_hal_element_type_t element_type = IREE_HAL_ELEMENT_TYPE_NONE;
+  if (!MapDLDataTypeToElementType(tensor.dtype, &element_type)) {
+    throw RaiseValueError("unsupported DLPack tensor dtype");
+  }
+
+  // Strides are in elements and NULL indicates a compact row-major layout.
+  std::vector<iree_hal_dim_t> dims(tensor.ndim);
+  iree_device_size_t element_count = 1;
+  for (int32_t i = tensor.ndim - 1; i >= 0; --i) {
+    if (tensor.strides && tensor.shape[i] != 1 &&
+        tensor.strides[i] != static_cast<int64_t>(element_count)) {
+      throw RaiseValueError(
+          "only compact row-major DLPack tensors can be imported");
+    }
+    dims[i] = static_cast<iree_hal_dim_t>(tensor.shape[i]);
+    element_count *= tensor.shape[i];
+  }
+  iree_host_size_t byte_length =
+      element_count * iree_hal_element_dense_byte_count(element_type);
+  uint8_t* data = static_cast<uint8_t*>(tensor.data) + tensor.byte_offset;
+  if ((reinterpret_cast<uintptr_t>(data) &
+       (kMinWrappedBufferAlignment - 1)) != 0) {
+    throw RaiseValueError("DLPack tensor data is insufficiently aligned");
+  }
+
+  // Ownership transfers to us once the capsule is marked as consumed.
+  iree_hal_buffer_view_t* hal_buffer_view = nullptr;
+  iree_status_t status = WrapBufferView(
+      raw_ptr(), memory_type, allowed_usage,
+      iree_make_byte_span(data, byte_length), dims, element_type,
+      [managed]() {
+        if (managed->deleter) managed->deleter(managed);
+      },
+      &hal_buffer_view);
+  PyCapsule_SetName(capsule.ptr(), kDLPackUsedCapsuleName);
+  CheckApiStatus(status, "Error importing DLPack tensor");
+  return HalBufferView::StealFromRawPtr(hal_buffer_view);
+}
+
 //------------------------------------------------------------------------------
 // HalBuffer
 //------------------------------------------------------------------------------
@@ -195,6 +525,59 @@ py::str HalBufferView::Repr() {
   return py::str(repr);
 }
 
+py::capsule HalBufferView::ToDLPack() {
+  DLPackExportContext* context = new DLPackExportContext();
+  context->buffer_view = raw_ptr();
+  iree_hal_buffer_view_retain(context->buffer_view);
+
+  DLTensor& tensor = context->managed.dl_tensor;
+  iree_hal_element_type_t element_type =
+      iree_hal_buffer_view_element_type(raw_ptr());
+  if (!MapElementTypeToDLDataType(element_type, &tensor.dtype)) {
+    delete context;
+    throw RaiseValueError("element type cannot be represented in DLPack");
+  }
+
+  // Device-local memory would need to be exported through the allocator as an
+  // external buffer; only host-visible memory can be exported today.
+  iree_hal_buffer_t* buffer = iree_hal_buffer_view_buffer(raw_ptr());
+  iree_status_t status = iree_hal_buffer_map_range(
+      buffer, IREE_HAL_MAPPING_MODE_SCOPED, IREE_HAL_MEMORY_ACCESS_ALL, 0,
+      IREE_WHOLE_BUFFER, &context->mapping);
+  if (!iree_status_is_ok(status)) {
+    delete context;
+    CheckApiStatus(status, "Only host-visible buffers can be exported");
+  }
+
+  iree_host_size_t rank = iree_hal_buffer_view_shape_rank(raw_ptr());
+  const iree_hal_dim_t* dims = iree_hal_buffer_view_shape_dims(raw_ptr());
+  context->shape.assign(dims, dims + rank);
+  tensor.data = context->mapping.contents.data;
+  tensor.device = {kDLCPU, 0};
+  tensor.ndim = static_cast<int32_t>(rank);
+  tensor.shape = context->shape.data();
+  tensor.strides = nullptr;  // compact row-major
+  tensor.byte_offset = 0;
+  context->managed.manager_ctx = context;
+  context->managed.deleter = &DLPackExportContext::Deleter;
+
+  // Consumers rename the capsule once they take ownership; if the capsule is
+  // destroyed unconsumed we release the tensor ourselves.
+  return py::capsule(&context->managed, kDLPackCapsuleName,
+                     [](PyObject* capsule) {
+                       if (!PyCapsule_IsValid(capsule, kDLPackCapsuleName)) {
+                         return;
+                       }
+                       auto* managed = static_cast<DLManagedTensor*>(
+                           PyCapsule_GetPointer(capsule, kDLPackCapsuleName));
+                       managed->deleter(managed);
+                     });
+}
+
+py::tuple HalBufferView::DLPackDevice() {
+  return py::make_tuple(static_cast<int>(kDLCPU), 0);
+}
+
 //------------------------------------------------------------------------------
 // HalDriver
 //------------------------------------------------------------------------------
@@ -454,7 +837,19 @@ void SetupHalBindings(pybind11::module m) {
            "object. If an element type is specified, wraps in a BufferView "
            "matching the characteristics of the Python buffer. The format is "
            "requested as ND/C-Contiguous, which may incur copies if not "
-           "already in that format.");
+           "already in that format.")
+      .def("try_wrap_buffer_view", &HalAllocator::TryWrapBufferView,
+           py::arg("memory_type"), py::arg("allowed_usage"), py::arg("buffer"),
+           py::arg("element_type"),
+           "Wraps the memory of a Python buffer object in a BufferView without "
+           "copying, keeping the object alive for as long as the buffer is in "
+           "use. Returns None if the allocator cannot wrap host memory or the "
+           "buffer is not writable, C-Contiguous and 16-byte aligned.")
+      .def("import_dlpack", &HalAllocator::ImportDLPack,
+           py::arg("memory_type"), py::arg("allowed_usage"),
+           py::arg("capsule"),
+           "Imports a DLPack capsule as a BufferView without copying. Only "
+           "compact host tensors are supported.");
 
   py::class_<HalBuffer>(m, "HalBuffer")
       .def("fill_zero", &HalBuffer::FillZero, py::arg("byte_offset"),
@@ -482,6 +877,14 @@ void SetupHalBindings(pybind11::module m) {
           [](HalBufferView& self) {
             return iree_hal_buffer_view_element_type(self.raw_ptr());
           })
+      .def(
+          "__dlpack__",
+          [](HalBufferView& self, py::object stream) {
+            // Host memory requires no stream synchronization.
+            return self.ToDLPack();
+          },
+          py::arg("stream") = py::none())
+      .def("__dlpack_device__", &HalBufferView::DLPackDevice)
       .def("__repr__", &HalBufferView::Repr);
 
   py::class_<HalMappedMemory>(m, "MappedMemory", py::buffer_protocol())
@@ -83,6 +83,21 @@ class HalAllocator : public ApiRefCounted<HalAllocator, iree_hal_allocator_t> {
   py::object AllocateBufferCopy(
       int memory_type, int allowed_usage, py::object buffer,
       std::optional<iree_hal_element_types_t> element_type);
+
+  // Wraps the memory of a Python buffer object in a buffer view without
+  // copying. The Python object is kept alive until the HAL buffer is destroyed.
+  // Returns None if the allocator cannot wrap host memory or the buffer is not
+  // writable, C-contiguous, and suitably aligned.
+  py::object TryWrapBufferView(int memory_type, int allowed_usage,
+                               py::object buffer,
+                               iree_hal_element_types_t element_type);
+
+  // Imports a DLPack capsule as a buffer view without copying. The producer's
+  // tensor is kept alive until the HAL buffer is destroyed and the capsule is
+  // consumed. Raises if the tensor is not compact or its device is not
+  // accessible by this allocator.
+  HalBufferView ImportDLPack(int memory_type, int allowed_usage,
+                             py::capsule capsule);
 };
 
 struct HalShape {
@@ -100,6 +115,13 @@ class HalBufferView
     : public ApiRefCounted<HalBufferView, iree_hal_buffer_view_t> {
  public:
   py::str Repr();
+
+  // Exports the buffer view as a DLPack capsule. Only host-visible buffers can
+  // be exported and the buffer remains mapped until the consumer releases it.
+  py::capsule ToDLPack();
+
+  // Returns the DLPack (device_type, device_id) the buffer view is exported as.
+  py::tuple DLPackDevice();
 };
 
 class HalBuffer : public ApiRefCounted<HalBuffer, iree_hal_buffer_t> {
@@ -127,6 +127,50 @@ class DeviceHalTest(unittest.TestCase):
         "<HalBufferView (3, 4), element_type=0x20000011, 48 bytes (at offset 0 into 48), memory_type=DEVICE_LOCAL|HOST_VISIBLE, allowed_access=ALL, allowed_usage=CONSTANT|TRANSFER|MAPPING>"
     )
 
+  def _aligned_array(self, shape, dtype, alignment=16):
+    count = int(np.prod(shape))
+    itemsize = np.dtype(dtype).itemsize
+    storage = np.zeros(count * itemsize + alignment, dtype=np.uint8)
+    offset = -storage.ctypes.data % alignment
+    return storage[offset:offset + count * itemsize].view(dtype).reshape(shape)
+
+  def testTryWrapBufferView(self):
+    ary = self._aligned_array([3, 4], np.int32)
+    ary[...] = 2
+    buffer_view = self.allocator.try_wrap_buffer_view(
+        memory_type=iree.runtime.MemoryType.DEVICE_LOCAL,
+        allowed_usage=iree.runtime.BufferUsage.CONSTANT,
+        buffer=ary,
+        element_type=iree.runtime.HalElementType.SINT_32)
+    self.assertIsNotNone(buffer_view)
+    self.assertEqual([3, 4], buffer_view.shape)
+    # The buffer aliases the array.
+    ary[1, 2] = 7
+    mapped = buffer_view.map().asarray([3, 4], np.int32)
+    np.testing.assert_array_equal(mapped, ary)
+    # The array must be kept alive by the buffer.
+    del ary
+    self.assertEqual(7, buffer_view.map().asarray([3, 4], np.int32)[1, 2])
+
+  def testTryWrapBufferViewUnsupported(self):
+    # Read-only arrays are not wrapped.
+    readonly = self._aligned_array([4], np.int32)
+    readonly.flags.writeable = False
+    self.assertIsNone(
+        self.allocator.try_wrap_buffer_view(
+            memory_type=iree.runtime.MemoryType.DEVICE_LOCAL,
+            allowed_usage=iree.runtime.BufferUsage.CONSTANT,
+            buffer=readonly,
+            element_type=iree.runtime.HalElementType.SINT_32))
+    # Misaligned arrays are not wrapped.
+    misaligned = self._aligned_array([5], np.uint8)[1:]
+    self.assertIsNone(
+        self.allocator.try_wrap_buffer_view(
+            memory_type=iree.runtime.MemoryType.DEVICE_LOCAL,
+            allowed_usage=iree.runtime.BufferUsage.CONSTANT,
+            buffer=misaligned,
+            element_type=iree.runtime.HalElementType.UINT_8))
+
 
 if __name__ == "__main__":
   unittest.main()
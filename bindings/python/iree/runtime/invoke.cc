@@ -0,0 +1,174 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "bindings/python/iree/runtime/invoke.h"
+
+#include "iree/hal/api.h"
+#include "iree/vm/api.h"
+
+namespace iree {
+namespace python {
+
+//------------------------------------------------------------------------------
+// CallPlan
+//------------------------------------------------------------------------------
+
+CallPlan::CallPlan(HalDevice& device, int memory_type, int allowed_usage,
+                   bool zero_copy, py::object device_array_type,
+                   std::vector<py::tuple> argument_specs, int result_count)
+    : device_(HalDevice::BorrowFromRawPtr(device.raw_ptr())),
+      memory_type_(memory_type),
+      allowed_usage_(allowed_usage),
+      zero_copy_(zero_copy),
+      device_array_type_(std::move(device_array_type)),
+      result_count_(result_count) {
+  arguments_.reserve(argument_specs.size());
+  for (auto& spec : argument_specs) {
+    if (spec.size() != 3) {
+      throw RaiseValueError(
+          "expected argument specs of (element_type, dtype, dims)");
+    }
+    Argument argument;
+    argument.element_type = py::cast<iree_hal_element_types_t>(spec[0]);
+    argument.dtype = py::dtype::from_args(spec[1]);
+    argument.dims = py::cast<std::vector<int64_t>>(spec[2]);
+    arguments_.push_back(std::move(argument));
+  }
+}
+
+bool CallPlan::MarshalArgument(const Argument& argument, py::handle arg,
+                               VmVariantList& list) {
+  // Buffer views are passed through unvalidated as on the general path.
+  if (py::isinstance<HalBufferView>(arg)) {
+    list.PushBufferView(py::cast<HalBufferView&>(arg));
+    return true;
+  }
+
+  // DeviceArrays already resident on the device are passed by reference if
+  // they require no dtype conversion.
+  if (!device_array_type_.is_none() &&
+      py::isinstance(arg, device_array_type_)) {
+    if (!argument.dtype.equal(py::dtype::from_args(arg.attr("dtype")))) {
+      return false;
+    }
+    auto& buffer_view = py::cast<HalBufferView&>(arg.attr("_buffer_view"));
+    iree_host_size_t rank =
+        iree_hal_buffer_view_shape_rank(buffer_view.raw_ptr());
+    if (rank != argument.dims.size()) return false;
+    for (iree_host_size_t i = 0; i < rank; ++i) {
+      int64_t dim = iree_hal_buffer_view_shape_dim(buffer_view.raw_ptr(), i);
+      if (argument.dims[i] >= 0 && argument.dims[i] != dim) return false;
+    }
+    list.PushBufferView(buffer_view);
+    return true;
+  }
+
+  // Host arrays must match the expected dtype and shape exactly; anything
+  // requiring conversion (or producing a validation error) takes the general
+  // path.
+  if (!py::isinstance<py::array>(arg)) return false;
+  auto array = py::reinterpret_borrow<py::array>(arg);
+  if (!argument.dtype.equal(array.dtype())) return false;
+  if (static_cast<size_t>(array.ndim()) != argument.dims.size()) return false;
+  for (size_t i = 0; i < argument.dims.size(); ++i) {
+    if (argument.dims[i] >= 0 && argument.dims[i] != array.shape(i)) {
+      return false;
+    }
+  }
+  if (!(array.flags() & py::array::c_style)) return false;
+
+  auto allocator = HalAllocator::BorrowFromRawPtr(device_.allocator());
+  py::object buffer_view = py::none();
+  if (zero_copy_) {
+    buffer_view = allocator.TryWrapBufferView(memory_type_, allowed_usage_,
+                                              array, argument.element_type);
+  }
+  if (buffer_view.is_none()) {
+    buffer_view = allocator.AllocateBufferCopy(memory_type_, allowed_usage_,
+                                               array, argument.element_type);
+  }
+  list.PushBufferView(py::cast<HalBufferView&>(buffer_view));
+  return true;
+}
+
+py::object CallPlan::Marshal(py::tuple args) {
+  if (args.size() != arguments_.size()) return py::none();
+
+  std::pair<py::object, py::object> lists;
+  if (!free_lists_.empty()) {
+    lists = std::move(free_lists_.back());
+    free_lists_.pop_back();
+  } else {
+    lists.first = py::cast(VmVariantList::Create(arguments_.size()));
+    lists.second = py::cast(VmVariantList::Create(result_count_));
+  }
+
+  auto& arg_list = py::cast<VmVariantList&>(lists.first);
+  for (size_t i = 0; i < arguments_.size(); ++i) {
+    if (!MarshalArgument(arguments_[i], args[i], arg_list)) {
+      Recycle(std::move(lists.first), std::move(lists.second));
+      return py::none();
+    }
+  }
+  return py::make_tuple(std::move(lists.first), std::move(lists.second));
+}
+
+py::list CallPlan::Unmarshal(VmVariantList& ret_list) {
+  iree_host_size_t count = ret_list.size();
+  if (count != static_cast<iree_host_size_t>(result_count_)) {
+    throw RaiseValueError("mismatched result count");
+  }
+  py::list results(count);
+  for (iree_host_size_t i = 0; i < count; ++i) {
+    iree_vm_ref_t ref = {0};
+    CheckApiStatus(iree_vm_list_get_ref_assign(ret_list.raw_ptr(), i, &ref),
+                   "Could not access result");
+    iree_hal_buffer_view_t* buffer_view = iree_hal_buffer_view_deref(ref);
+    if (!buffer_view) {
+      throw RaiseValueError("Could not deref result buffer view (wrong type?)");
+    }
+    results[i] = py::cast(HalBufferView::BorrowFromRawPtr(buffer_view),
+                          py::return_value_policy::move);
+  }
+  return results;
+}
+
+void CallPlan::Recycle(py::object arg_list, py::object ret_list) {
+  // Resizing to zero releases the references held by the lists while keeping
+  // their storage for the next call.
+  CheckApiStatus(
+      iree_vm_list_resize(py::cast<VmVariantList&>(arg_list).raw_ptr(), 0),
+      "Error clearing argument list");
+  CheckApiStatus(
+      iree_vm_list_resize(py::cast<VmVariantList&>(ret_list).raw_ptr(), 0),
+      "Error clearing result list");
+  free_lists_.emplace_back(std::move(arg_list), std::move(ret_list));
+}
+
+//------------------------------------------------------------------------------
+// Bindings
+//------------------------------------------------------------------------------
+
+void SetupInvokeBindings(pybind11::module m) {
+  py::class_<CallPlan>(m, "CallPlan")
+      .def(py::init<HalDevice&, int, int, bool, py::object,
+                    std::vector<py::tuple>, int>(),
+           py::arg("device"), py::arg("memory_type"), py::arg("allowed_usage"),
+           py::arg("zero_copy"), py::arg("device_array_type"),
+           py::arg("argument_specs"), py::arg("result_count"))
+      .def("marshal", &CallPlan::Marshal, py::arg("args"),
+           "Marshals a tuple of arguments into pooled (arg_list, ret_list) "
+           "VmVariantLists or returns None if any argument requires the "
+           "general conversion path.")
+      .def("unmarshal", &CallPlan::Unmarshal, py::arg("ret_list"),
+           "Returns the result HalBufferViews of an invocation.")
+      .def("recycle", &CallPlan::Recycle, py::arg("arg_list"),
+           py::arg("ret_list"),
+           "Clears lists returned by marshal and returns them to the pool.");
+}
+
+}  // namespace python
+}  // namespace iree
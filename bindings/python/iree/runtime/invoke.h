@@ -0,0 +1,74 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_BINDINGS_PYTHON_IREE_RT_INVOKE_H_
+#define IREE_BINDINGS_PYTHON_IREE_RT_INVOKE_H_
+
+#include <utility>
+#include <vector>
+
+#include "bindings/python/iree/runtime/binding.h"
+#include "bindings/python/iree/runtime/hal.h"
+#include "bindings/python/iree/runtime/vm.h"
+#include "pybind11/numpy.h"
+
+namespace iree {
+namespace python {
+
+// A precompiled plan for marshaling the arguments and results of a function
+// whose signature consists only of ndarrays. Built once from the reflection
+// ABI of a function and used on each call to replace the per-argument Python
+// converters with a single native call.
+//
+// Argument and result lists are pooled and reused across calls. All methods
+// must be called with the GIL held.
+class CallPlan {
+ public:
+  // Describes one ndarray argument: its element type, the numpy dtype it is
+  // expected to have, and its dims (with -1 for dynamic dims).
+  struct Argument {
+    iree_hal_element_types_t element_type;
+    py::dtype dtype;
+    std::vector<int64_t> dims;
+  };
+
+  CallPlan(HalDevice& device, int memory_type, int allowed_usage,
+           bool zero_copy, py::object device_array_type,
+           std::vector<py::tuple> argument_specs, int result_count);
+
+  // Marshals |args| into a (arg_list, ret_list) tuple of pooled VM lists.
+  // Returns None if any argument is not an exactly matching ndarray,
+  // DeviceArray, or HalBufferView and must take the general path.
+  py::object Marshal(py::tuple args);
+
+  // Returns the buffer views from |ret_list|.
+  py::list Unmarshal(VmVariantList& ret_list);
+
+  // Clears and returns lists acquired from Marshal to the pool.
+  void Recycle(py::object arg_list, py::object ret_list);
+
+ private:
+  // Returns true and pushes the buffer view for |arg| into |list| if |arg| can
+  // be marshaled on the fast path.
+  bool MarshalArgument(const Argument& argument, py::handle arg,
+                       VmVariantList& list);
+
+  HalDevice device_;
+  int memory_type_;
+  int allowed_usage_;
+  bool zero_copy_;
+  py::object device_array_type_;
+  std::vector<Argument> arguments_;
+  int result_count_;
+  std::vector<std::pair<py::object, py::object>> free_lists_;
+};
+
+void SetupInvokeBindings(pybind11::module m);
+
+}  // namespace python
+}  // namespace iree
+
+#endif  // IREE_BINDINGS_PYTHON_IREE_RT_INVOKE_H_
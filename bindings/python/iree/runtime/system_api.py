@@ -31,6 +31,7 @@ __all__ = [
 import logging
 import os
 import sys
+import threading
 
 from typing import Any, List, Mapping, Optional, Sequence, Tuple, Union
 
@@ -225,8 +226,10 @@ class BoundModule:
     # layering and will need to be fixed in some fashion if/when doing
     # heterogenous dispatch.
     return FunctionInvoker(self._context.vm_context,
-                           self._context.config.device, vm_function,
-                           self._context._tracer)
+                           self._context.config.device,
+                           vm_function,
+                           self._context._tracer,
+                           invoke_lock=self._context._invoke_lock)
 
   def __repr__(self):
     return f"<BoundModule {repr(self._vm_module)}>"
@@ -249,6 +252,9 @@ class SystemContext:
     self._config = config if config is not None else _get_global_config()
     logging.debug("SystemContext driver=%r", self._config.driver)
     self._is_dynamic = vm_modules is None
+    # Serializes use of the VM context (which is thread-compatible) when
+    # functions are invoked from multiple threads.
+    self._invoke_lock = threading.Lock()
     if self._is_dynamic:
       init_vm_modules = None
     else:
@@ -304,7 +310,8 @@ class SystemContext:
       self._bound_modules[m.name] = bound_module
       if self._tracer:
         self._tracer.add_module(bound_module.traced_module)
-    self._vm_context.register_modules(vm_modules)
+    with self._invoke_lock:
+      self._vm_context.register_modules(vm_modules)
 
   def add_vm_module(self, vm_module):
     self.add_vm_modules((vm_module,))
@@ -7,11 +7,15 @@
 # SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
 from genericpath import exists
-from typing import Dict, List, Optional, Sequence
+from typing import Dict, List, Optional, Sequence, TextIO
 
+import atexit
 import logging
 import os
+import queue
 import sys
+import threading
+import time
 
 from . import binding as _binding
 
@@ -21,28 +25,117 @@ except ModuleNotFoundError:
   _has_yaml = False
 else:
   _has_yaml = True
+  # The libyaml-backed dumper is an order of magnitude faster when available.
+  _YamlDumper = getattr(yaml, "CSafeDumper", yaml.SafeDumper)
 
 __all__ = [
     "get_default_tracer",
     "Tracer",
     "TRACE_PATH_ENV_KEY",
+    "TRACE_SAMPLE_EVERY_ENV_KEY",
 ]
 
 TRACE_PATH_ENV_KEY = "IREE_SAVE_CALLS"
+TRACE_SAMPLE_EVERY_ENV_KEY = "IREE_SAVE_CALLS_SAMPLE_EVERY"
+
+
+class _TraceWriter:
+  """Writes trace frames as YAML documents, optionally on a background thread.
+
+  In asynchronous mode the calling thread only enqueues the frame; YAML
+  serialization and file I/O happen on a daemon thread that is drained on
+  flush() and at interpreter exit.
+  """
+
+  def __init__(self, asynchronous: bool):
+    self._files = dict()  # type: Dict[str, TextIO]
+    self._queue = None  # type: Optional[queue.Queue]
+    if asynchronous:
+      self._queue = queue.Queue()
+      thread = threading.Thread(target=self._run,
+                                name="iree-trace-writer",
+                                daemon=True)
+      thread.start()
+      atexit.register(self.close)
+
+  def write(self, file_path: str, frame: dict, is_first: bool):
+    if self._queue is not None:
+      self._queue.put((file_path, frame, is_first))
+    else:
+      self._write(file_path, frame, is_first)
+      self._files[file_path].flush()
+
+  def flush(self):
+    if self._queue is not None:
+      self._queue.join()
+    for f in self._files.values():
+      f.flush()
+
+  def close(self):
+    if self._queue is not None:
+      self._queue.put(None)
+      self._queue.join()
+      self._queue = None
+    for f in self._files.values():
+      f.close()
+    self._files.clear()
+
+  def _run(self):
+    while True:
+      item = self._queue.get()
+      try:
+        if item is None:
+          return
+        self._write(*item)
+      except Exception:  # pylint: disable=broad-except
+        logging.exception("Failed to write trace frame")
+      finally:
+        self._queue.task_done()
+
+  def _write(self, file_path: str, frame: dict, is_first: bool):
+    f = self._files.get(file_path)
+    if f is None:
+      f = open(file_path, "at")
+      self._files[file_path] = f
+    if not is_first:
+      f.write("---\n")
+    f.write(yaml.dump(frame, Dumper=_YamlDumper, sort_keys=False))
 
 
 class Tracer:
-  """Object for tracing calls made into the runtime."""
+  """Object for tracing calls made into the runtime.
+
+  By default every call is recorded with the full contents of its arguments
+  and results. For production use the overhead can be bounded with:
 
-  def __init__(self, trace_path: str):
+  * `sample_every`: only every Nth call records buffer contents; all other
+    calls record just the shapes, element types and invocation time. A value
+    of 0 never records contents. Calls without contents replay with
+    zero-filled inputs in `iree-run-trace`.
+  * `asynchronous`: serializes and writes frames on a background thread.
+  """
+
+  def __init__(self,
+               trace_path: str,
+               *,
+               sample_every: int = 1,
+               asynchronous: bool = False):
     if not _has_yaml:
       self.enabled = False
       logging.warning("PyYAML not installed: tracing will be disabled")
       return
+    if sample_every < 0:
+      raise ValueError(f"sample_every must be >= 0 (got {sample_every})")
     self.enabled = True
     self.trace_path = trace_path
+    self.sample_every = sample_every
     os.makedirs(trace_path, exist_ok=True)
     self._name_count = dict()  # type: Dict[str, int]
+    self._writer = _TraceWriter(asynchronous)
+
+  def flush(self):
+    """Blocks until all pending trace frames have been written."""
+    self._writer.flush()
 
   def persist_vm_module(self, vm_module: _binding.VmModule) -> "TracedModule":
     # Depending on how the module was created, there are different bits
@@ -102,6 +195,7 @@ class ContextTracer:
     self._parent = parent
     self._modules = list(modules)  # type: List[TracedModule]
     self._frame_count = 0
+    self._call_count = 0
     self._file_path = os.path.join(parent.trace_path,
                                    parent.get_unique_name("calls.yaml"))
     if os.path.exists(self._file_path):
@@ -128,36 +222,50 @@ class ContextTracer:
     })
 
   def start_call(self, function: _binding.VmFunction):
-    logging.info("Tracing call to %s.%s", function.module_name, function.name)
+    logging.debug("Tracing call to %s.%s", function.module_name, function.name)
+    sample_every = self._parent.sample_every
+    include_contents = (sample_every > 0 and
+                        self._call_count % sample_every == 0)
+    self._call_count += 1
 
     # Start assembling the call record.
     record = {
         "type": "call",
         "function": "%s.%s" % (function.module_name, function.name),
     }
-    return CallTrace(self, record)
+    return CallTrace(self, record, include_contents)
 
   def emit_frame(self, frame: dict):
     self._frame_count += 1
-    with open(self._file_path, "at") as f:
-      if self._frame_count != 1:
-        f.write("---\n")
-      contents = yaml.dump(frame, sort_keys=False)
-      f.write(contents)
+    self._parent._writer.write(self._file_path,
+                               frame,
+                               is_first=self._frame_count == 1)
 
 
 class CallTrace:
 
-  def __init__(self, parent: ContextTracer, record: dict):
+  def __init__(self, parent: ContextTracer, record: dict,
+               include_contents: bool):
     self._parent = parent
     self._record = record
+    self._include_contents = include_contents
+    self._invoke_start_ns = 0
 
   def add_vm_list(self, vm_list: _binding.VmVariantList, key: str):
     mapped = []
     for i in range(len(vm_list)):
-      mapped.append(vm_list.get_serialized_trace_value(i))
+      mapped.append(
+          vm_list.get_serialized_trace_value(
+              i, include_contents=self._include_contents))
     self._record[key] = mapped
 
+  def begin_invoke(self):
+    self._invoke_start_ns = time.perf_counter_ns()
+
+  def end_invoke(self):
+    self._record["duration_ns"] = (time.perf_counter_ns() -
+                                   self._invoke_start_ns)
+
   def end_call(self):
     self._parent.emit_frame(self._record)
 
@@ -167,4 +275,9 @@ def get_default_tracer() -> Optional[Tracer]:
   default_path = os.getenv(TRACE_PATH_ENV_KEY)
   if not default_path:
     return None
-  return Tracer(default_path)
+  sample_every = int(os.getenv(TRACE_SAMPLE_EVERY_ENV_KEY, "1"))
+  # Sampled tracing is meant for long-running processes so also take the
+  # serialization off the calling thread.
+  return Tracer(default_path,
+                sample_every=sample_every,
+                asynchronous=sample_every != 1)
@@ -112,10 +112,16 @@ void VmContext::RegisterModules(std::vector<VmModule*> modules) {
 
 void VmContext::Invoke(iree_vm_function_t f, VmVariantList& inputs,
                        VmVariantList& outputs) {
-  CheckApiStatus(iree_vm_invoke(raw_ptr(), f, IREE_VM_INVOCATION_FLAG_NONE,
-                                nullptr, inputs.raw_ptr(), outputs.raw_ptr(),
-                                iree_allocator_system()),
-                 "Error invoking function");
+  iree_status_t status;
+  {
+    // The invocation may block on the device for its entire duration and never
+    // calls back into Python so other Python threads are allowed to run.
+    py::gil_scoped_release release;
+    status = iree_vm_invoke(raw_ptr(), f, IREE_VM_INVOCATION_FLAG_NONE, nullptr,
+                            inputs.raw_ptr(), outputs.raw_ptr(),
+                            iree_allocator_system());
+  }
+  CheckApiStatus(status, "Error invoking function");
 }
 
 //------------------------------------------------------------------------------
@@ -185,6 +191,18 @@ void VmVariantList::PushInt(int64_t ivalue) {
                  "Could not push int");
 }
 
+void VmVariantList::PushInts(const std::vector<int64_t>& ivalues) {
+  // Extends the list and copies all values at once instead of pushing them
+  // one at a time.
+  iree_host_size_t base_index = size();
+  CheckApiStatus(iree_vm_list_resize(raw_ptr(), base_index + ivalues.size()),
+                 "Could not resize list");
+  CheckApiStatus(
+      iree_vm_list_set_values(raw_ptr(), base_index, ivalues.size(),
+                              IREE_VM_VALUE_TYPE_I64, ivalues.data()),
+      "Could not push ints");
+}
+
 void VmVariantList::PushList(VmVariantList& other) {
   iree_vm_ref_t retained = iree_vm_list_retain_ref(other.raw_ptr());
   iree_vm_list_push_ref_move(raw_ptr(), &retained);
@@ -208,6 +226,18 @@ py::object VmVariantList::GetAsList(int index) {
   return py::cast(VmVariantList(sub_list));
 }
 
+std::vector<int64_t> VmVariantList::GetAsInts(int index, int count) {
+  if (index < 0 || count < 0) {
+    throw RaiseValueError("List range must be non-negative");
+  }
+  std::vector<int64_t> ivalues(count);
+  CheckApiStatus(iree_vm_list_get_values_as(raw_ptr(), index, count,
+                                            IREE_VM_VALUE_TYPE_I64,
+                                            ivalues.data()),
+                 "Could not access list elements as ints");
+  return ivalues;
+}
+
 py::object VmVariantList::GetVariant(int index) {
   iree_vm_variant_t v = iree_vm_variant_empty();
   CheckApiStatus(iree_vm_list_get_variant(raw_ptr(), index, &v),
@@ -244,7 +274,8 @@ py::object VmVariantList::GetVariant(int index) {
   throw RaiseValueError("Unsupported VM to Python Type Conversion");
 }
 
-py::object VmVariantList::GetAsSerializedTraceValue(int index) {
+py::object VmVariantList::GetAsSerializedTraceValue(int index,
+                                                     bool include_contents) {
   iree_vm_variant_t v = iree_vm_variant_empty();
   CheckApiStatus(iree_vm_list_get_variant(raw_ptr(), index, &v),
                  "Could not access list element");
@@ -291,7 +322,8 @@ py::object VmVariantList::GetAsSerializedTraceValue(int index) {
       iree_vm_list_retain(sub_list);
       VmVariantList sub_list_object(sub_list);
       for (int i = 0, e = sub_list_object.size(); i < e; ++i) {
-        items.append(sub_list_object.GetAsSerializedTraceValue(i));
+        items.append(
+            sub_list_object.GetAsSerializedTraceValue(i, include_contents));
       }
       record["items"] = std::move(items);
       return std::move(record);
@@ -327,6 +359,7 @@ py::object VmVariantList::GetAsSerializedTraceValue(int index) {
           iree_hal_buffer_view_element_type(buffer_view);
       // TODO: Would be nice to output as hex.
       record["element_type"] = element_type;
+      if (!include_contents) return std::move(record);
 
       // Map memory.
       iree_device_size_t byte_length = iree_hal_buffer_byte_length(raw_buffer);
@@ -492,11 +525,15 @@ void SetupVmBindings(pybind11::module m) {
       .def("__len__", &VmVariantList::size)
       .def("get_as_buffer_view", &VmVariantList::GetAsBufferView)
       .def("get_as_list", &VmVariantList::GetAsList)
+      .def("get_as_ints", &VmVariantList::GetAsInts, py::arg("index"),
+           py::arg("count"))
       .def("get_variant", &VmVariantList::GetVariant)
       .def("get_serialized_trace_value",
-           &VmVariantList::GetAsSerializedTraceValue)
+           &VmVariantList::GetAsSerializedTraceValue, py::arg("index"),
+           py::arg("include_contents") = true)
       .def("push_float", &VmVariantList::PushFloat)
       .def("push_int", &VmVariantList::PushInt)
+      .def("push_ints", &VmVariantList::PushInts)
       .def("push_list", &VmVariantList::PushList)
       .def("push_buffer_view", &VmVariantList::PushBufferView)
       .def("__repr__", &VmVariantList::DebugString);
@@ -93,12 +93,15 @@ class VmVariantList {
   std::string DebugString() const;
   void PushFloat(double fvalue);
   void PushInt(int64_t ivalue);
+  void PushInts(const std::vector<int64_t>& ivalues);
   void PushList(VmVariantList& other);
   void PushBufferView(HalBufferView& buffer_view);
   py::object GetAsList(int index);
   py::object GetAsBufferView(int index);
+  std::vector<int64_t> GetAsInts(int index, int count);
   py::object GetVariant(int index);
-  py::object GetAsSerializedTraceValue(int index);
+  // Buffer contents are only read back when |include_contents| is set.
+  py::object GetAsSerializedTraceValue(int index, bool include_contents);
 
  private:
   VmVariantList(iree_vm_list_t* list) : list_(list) {}
@@ -148,7 +151,10 @@ class VmContext : public ApiRefCounted<VmContext, iree_vm_context_t> {
   // Unique id for this context.
   int context_id() const { return iree_vm_context_id(raw_ptr()); }
 
-  // Synchronously invokes the given function.
+  // Synchronously invokes the given function. The GIL is released for the
+  // duration of the invocation. Contexts are thread-compatible and callers
+  // must not invoke functions on the same context from multiple threads
+  // concurrently.
   void Invoke(iree_vm_function_t f, VmVariantList& inputs,
               VmVariantList& outputs);
 };
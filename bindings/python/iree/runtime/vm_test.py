@@ -84,6 +84,16 @@ class VmTest(absltest.TestCase):
     l.push_int(10 * 1000 * 1000 * 1000)
     self.assertEqual(str(l), "<VmVariantList(1): [10000000000]>")
 
+  def test_variant_list_ints(self):
+    l = iree.runtime.VmVariantList(4)
+    l.push_int(1)
+    l.push_ints([2, 3, 10 * 1000 * 1000 * 1000])
+    self.assertEqual(l.size, 4)
+    self.assertEqual(l.get_as_ints(0, 4), [1, 2, 3, 10 * 1000 * 1000 * 1000])
+    self.assertEqual(l.get_as_ints(1, 2), [2, 3])
+    with self.assertRaises(IndexError):
+      l.get_as_ints(2, 3)
+
   def test_variant_list_buffers(self):
     ET = iree.runtime.HalElementType
     for dt, et in ((np.int8, ET.SINT_8), (np.int16, ET.SINT_16),
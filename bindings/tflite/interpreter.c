@@ -25,9 +25,10 @@ static void _TfLiteInterpreterRegisterDrivers(void) {
       iree_hal_driver_registry_default()));
 }
 
-// TODO(#3977): if already provided a HAL device in the options use that.
-static iree_status_t _TfLiteInterpreterPrepareHAL(
-    TfLiteInterpreter* interpreter) {
+// Creates the HAL driver and device shared by all interpreters of |model|.
+// Must be called with the model device_mutex held.
+static iree_status_t _TfLiteModelCreateSharedDevice(
+    TfLiteModel* model, iree_allocator_t allocator) {
   iree_call_once(&_TfLiteInterpreterRegisterDriverFlag,
                  _TfLiteInterpreterRegisterDrivers);
 
@@ -37,8 +38,7 @@ static iree_status_t _TfLiteInterpreterPrepareHAL(
   iree_hal_driver_info_t* driver_infos = NULL;
   iree_host_size_t driver_info_count = 0;
   IREE_RETURN_IF_ERROR(iree_hal_driver_registry_enumerate(
-      driver_registry, interpreter->allocator, &driver_infos,
-      &driver_info_count));
+      driver_registry, allocator, &driver_infos, &driver_info_count));
 
   // TODO(benvanik): figure out how we want to emulate device selection; may
   // just say "whatever is first" on a query.
@@ -48,18 +48,47 @@ static iree_status_t _TfLiteInterpreterPrepareHAL(
 
   // TODO(benvanik): switch to iree_hal_driver_registry_try_create when
   // implemented.
+  iree_hal_driver_t* driver = NULL;
   iree_status_t status = iree_hal_driver_registry_try_create_by_name(
-      driver_registry, driver_name, interpreter->allocator,
-      &interpreter->driver);
-  iree_allocator_free(interpreter->allocator, driver_infos);
+      driver_registry, driver_name, allocator, &driver);
+  iree_allocator_free(allocator, driver_infos);
   IREE_RETURN_IF_ERROR(status, "failed to create driver '%.*s'",
                        (int)driver_name.size, driver_name.data);
 
-  IREE_RETURN_IF_ERROR(
-      iree_hal_driver_create_default_device(
-          interpreter->driver, interpreter->allocator, &interpreter->device),
-      "failed creating the default device for driver '%.*s'",
-      (int)driver_name.size, driver_name.data);
+  iree_hal_device_t* device = NULL;
+  status = iree_hal_driver_create_default_device(driver, allocator, &device);
+  if (!iree_status_is_ok(status)) {
+    iree_hal_driver_release(driver);
+    return iree_status_annotate_f(
+        status, "failed creating the default device for driver '%.*s'",
+        (int)driver_name.size, driver_name.data);
+  }
+
+  model->driver = driver;
+  model->device = device;
+  return iree_ok_status();
+}
+
+// TODO(#3977): if already provided a HAL device in the options use that.
+static iree_status_t _TfLiteInterpreterPrepareHAL(
+    TfLiteInterpreter* interpreter) {
+  // All interpreters created from the same model share a single device. HAL
+  // devices are thread-safe and this avoids re-creating the driver, device,
+  // and its executable caches for each interpreter in a pool.
+  TfLiteModel* model = interpreter->model;
+  iree_slim_mutex_lock(&model->device_mutex);
+  iree_status_t status = iree_ok_status();
+  if (!model->device) {
+    status = _TfLiteModelCreateSharedDevice(model, interpreter->allocator);
+  }
+  if (iree_status_is_ok(status)) {
+    interpreter->driver = model->driver;
+    iree_hal_driver_retain(interpreter->driver);
+    interpreter->device = model->device;
+    iree_hal_device_retain(interpreter->device);
+  }
+  iree_slim_mutex_unlock(&model->device_mutex);
+  IREE_RETURN_IF_ERROR(status);
 
   IREE_RETURN_IF_ERROR(iree_hal_module_create(
       interpreter->device, interpreter->allocator, &interpreter->hal_module));
@@ -426,6 +455,8 @@ TFL_CAPI_EXPORT extern void TfLiteInterpreterDelete(
   iree_vm_context_release(interpreter->context);
   iree_vm_module_release(interpreter->hal_module);
   iree_vm_module_release(interpreter->user_module);
+  iree_hal_device_release(interpreter->device);
+  iree_hal_driver_release(interpreter->driver);
   iree_vm_instance_release(interpreter->instance);
 
   _TfLiteModelRelease(interpreter->model);
@@ -570,26 +601,39 @@ TFL_CAPI_EXPORT extern TfLiteStatus TfLiteInterpreterAllocateTensors(
 }
 
 static iree_status_t _TfLiteInterpreterInvoke(TfLiteInterpreter* interpreter) {
+  // Input tensors are persistently mapped and written in-place by the user;
+  // make their contents visible to the device before running.
+  for (iree_host_size_t i = 0; i < interpreter->model->input_count; ++i) {
+    IREE_RETURN_IF_ERROR(_TfLiteTensorFlush(&interpreter->input_tensors[i]));
+  }
+
   // tflite models only have a single entry point and the IREE converter
-  // emits it as '_main'.
+  // emits it as '_main'. The input and output lists are reused across
+  // invocations.
   IREE_RETURN_IF_ERROR(
       iree_vm_invoke(interpreter->context, interpreter->model->exports._main,
                      IREE_VM_INVOCATION_FLAG_NONE,
                      /*policy=*/NULL, interpreter->input_list,
                      interpreter->output_list, interpreter->allocator));
 
-  // Refresh output shapes.
-  // TODO(#3975): just use buffer view results or at least just refresh outputs.
-  IREE_RETURN_IF_ERROR(_TfLiteInterpreterRefreshIOShapes(interpreter));
+  // Refresh output shapes. Input shapes only change on resize and were
+  // already queried as part of TfLiteInterpreterAllocateTensors.
+  // TODO(#3975): just use buffer view results.
+  _TfLiteInterpreterShapeFrame frame;
+  IREE_RETURN_IF_ERROR(_TfLiteInterpreterShapeFrameInitialize(&frame));
+  iree_status_t status =
+      _TfLiteInterpreterRefreshOutputShapes(interpreter, &frame);
+  _TfLiteInterpreterShapeFrameDeinitialize(&frame);
+  IREE_RETURN_IF_ERROR(status);
 
-  // Map the output buffers.
-  // NOTE: we could defer the mapping unless requested and ensure state buffers
-  // remain where they currently are for the next invocation.
+  // Map the output buffers. Outputs returned in the same buffer as the prior
+  // invocation (such as state buffers) keep their existing mapping.
   for (iree_host_size_t i = 0; i < interpreter->model->output_count; ++i) {
     iree_hal_buffer_t* buffer = (iree_hal_buffer_t*)iree_vm_list_get_ref_deref(
         interpreter->output_list, i, iree_hal_buffer_get_descriptor());
     TfLiteTensor* tensor = &interpreter->output_tensors[i];
     IREE_RETURN_IF_ERROR(_TfLiteTensorBind(tensor, buffer));
+    IREE_RETURN_IF_ERROR(_TfLiteTensorInvalidate(tensor));
   }
 
   return iree_ok_status();
@@ -90,6 +90,8 @@ import java.util.Map;
  * <p><b>WARNING:</b>Instances of {@link Interpreter} are <b>not</b> thread-safe.
  * A {@link Interpreter} owns resources that <b>must</b> be explicitly freed by
  * invoking {@link #close()}
+ *
+ * <p>Use an {@link InterpreterPool} to run the same model from multiple threads.
  */
 public final class Interpreter implements AutoCloseable {
   private static final String TAG = Interpreter.class.getCanonicalName();
@@ -154,6 +156,24 @@ public final class Interpreter implements AutoCloseable {
     outputTensors = new Tensor[outputTensorCount];
   }
 
+  /**
+   * Initializes an Interpreter sharing an already loaded native model (and its HAL device).
+   *
+   * <p>Used by {@link InterpreterPool}; the model must outlive the interpreter.
+   */
+  Interpreter(long nativeModelAddress, @NonNull Options options) {
+    TensorFlowLite.init();
+    nativeAddress = nativeNewFromModel(nativeModelAddress, options.numThreads);
+    if (nativeAddress == 0) {
+      throw new IllegalArgumentException("Could not create Interpreter");
+    }
+
+    inputTensorCount = nativeInputTensorCount();
+    outputTensorCount = nativeOutputTensorCount();
+    inputTensors = new Tensor[inputTensorCount];
+    outputTensors = new Tensor[outputTensorCount];
+  }
+
   /**
    * Runs model inference with a single input/output pair.
    *
@@ -246,6 +266,28 @@ public final class Interpreter implements AutoCloseable {
       getInputTensor(i).copyFromBuffer(inputs[i]);
     }
 
+    invoke();
+
+    for (Map.Entry<Integer, Buffer> output : outputs.entrySet()) {
+      getOutputTensor(output.getKey()).copyToBuffer(output.getValue());
+    }
+  }
+
+  /**
+   * Runs model inference on the current contents of the input tensors.
+   *
+   * <p>This is the zero-copy path: inputs are written directly into the memory returned by {@link
+   * Tensor#buffer()} of each input tensor and outputs are read from {@link Tensor#buffer()} of each
+   * output tensor after this returns. The buffers stay valid across invocations until the tensors
+   * are reallocated, so they can be fetched once and reused for every frame.
+   *
+   * @throws IllegalStateException if the tensors could not be allocated or inference fails.
+   */
+  public void invoke() {
+    if (!tensorsAllocated) {
+      allocateTensors();
+    }
+
     long inferenceStartNanos = System.nanoTime();
     int status = nativeInvoke();
     inferenceDurationNanoseconds = System.nanoTime() - inferenceStartNanos;
@@ -254,10 +296,6 @@ public final class Interpreter implements AutoCloseable {
       throw new IllegalStateException(
           String.format("Failed to run Interpreter. Returned status code: %d", status));
     }
-
-    for (Map.Entry<Integer, Buffer> output : outputs.entrySet()) {
-      getOutputTensor(output.getKey()).copyToBuffer(output.getValue());
-    }
   }
 
   /**
@@ -391,6 +429,8 @@ public final class Interpreter implements AutoCloseable {
 
   private native long nativeNew(ByteBuffer modelByteBuffer, int numThreads);
 
+  private native long nativeNewFromModel(long nativeModelAddress, int numThreads);
+
   private native void nativeFree();
 
   private native int nativeInputTensorCount();
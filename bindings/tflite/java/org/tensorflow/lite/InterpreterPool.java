@@ -0,0 +1,141 @@
+/*
+ * Copyright 2021 The IREE Authors
+ *
+ * Licensed under the Apache License v2.0 with LLVM Exceptions.
+ * See https://llvm.org/LICENSE.txt for license information.
+ * SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+ */
+
+package org.tensorflow.lite;
+
+import androidx.annotation.NonNull;
+import java.nio.ByteBuffer;
+import java.util.ArrayDeque;
+import java.util.ArrayList;
+import java.util.List;
+
+/**
+ * A thread-safe pool of {@link Interpreter}s that share a single loaded model and HAL device.
+ *
+ * <p>The model is loaded once and each pooled interpreter only owns its own execution context and
+ * I/O tensors. Interpreters are created lazily up to {@code maxInterpreters} and are reused across
+ * {@link #acquire()}/{@link #release(Interpreter)} pairs, so the {@link Tensor#buffer()} views of
+ * a returned interpreter remain valid the next time it is acquired.
+ *
+ * <pre>{@code
+ * try (InterpreterPool pool = new InterpreterPool(modelByteBuffer, options, 2)) {
+ *   // On any thread:
+ *   Interpreter interpreter = pool.acquire();
+ *   try {
+ *     interpreter.getInputTensor(0).buffer().put(frame);
+ *     interpreter.invoke();
+ *     ... read interpreter.getOutputTensor(0).buffer() ...
+ *   } finally {
+ *     pool.release(interpreter);
+ *   }
+ * }
+ * }</pre>
+ */
+public final class InterpreterPool implements AutoCloseable {
+  private static final String TAG = InterpreterPool.class.getCanonicalName();
+
+  // The native model references the model data and must keep it alive.
+  private final ByteBuffer modelByteBuffer;
+  private final Interpreter.Options options;
+  private final int maxInterpreters;
+  private final long nativeModelAddress;
+
+  private final List<Interpreter> allInterpreters = new ArrayList<>();
+  private final ArrayDeque<Interpreter> idleInterpreters = new ArrayDeque<>();
+  private boolean closed;
+
+  /**
+   * Loads the model and initializes an empty pool.
+   *
+   * @param modelByteBuffer: a directly allocated, native {@link java.nio.ByteOrder} byte buffer of
+   *     an IREE compatible TFLite model. It must not be modified while the pool is open.
+   * @param options: options for each interpreter, or null (to use defaults).
+   * @param maxInterpreters: the maximum number of interpreters that may be acquired at once.
+   * @throws IllegalArgumentException if the model cannot be loaded or {@code maxInterpreters} is
+   *     not positive.
+   */
+  public InterpreterPool(@NonNull ByteBuffer modelByteBuffer, Interpreter.Options options,
+      int maxInterpreters) throws IllegalArgumentException {
+    if (maxInterpreters <= 0) {
+      throw new IllegalArgumentException(
+          String.format("Invalid interpreter pool size: %d", maxInterpreters));
+    }
+    TensorFlowLite.init();
+    if (options == null) {
+      options = new Interpreter.Options();
+      options.setNumThreads(2);
+    }
+    this.modelByteBuffer = modelByteBuffer;
+    this.options = options;
+    this.maxInterpreters = maxInterpreters;
+
+    nativeModelAddress = nativeNewModel(modelByteBuffer);
+    if (nativeModelAddress == 0) {
+      throw new IllegalArgumentException("Could not load model");
+    }
+  }
+
+  /**
+   * Returns an idle interpreter, creating one if the pool has not yet reached its maximum size and
+   * otherwise blocking until another thread releases one.
+   *
+   * @throws IllegalStateException if the pool has been closed.
+   * @throws InterruptedException if interrupted while waiting for an interpreter.
+   */
+  public synchronized Interpreter acquire() throws InterruptedException {
+    while (!closed && idleInterpreters.isEmpty() && allInterpreters.size() >= maxInterpreters) {
+      wait();
+    }
+    if (closed) {
+      throw new IllegalStateException("Interpreter pool has been closed");
+    }
+    if (!idleInterpreters.isEmpty()) {
+      return idleInterpreters.pop();
+    }
+    Interpreter interpreter = new Interpreter(nativeModelAddress, options);
+    allInterpreters.add(interpreter);
+    return interpreter;
+  }
+
+  /**
+   * Returns an interpreter previously returned by {@link #acquire()} to the pool.
+   *
+   * @throws IllegalArgumentException if {@code interpreter} is not owned by this pool.
+   */
+  public synchronized void release(@NonNull Interpreter interpreter) {
+    if (!allInterpreters.contains(interpreter)) {
+      throw new IllegalArgumentException("Interpreter is not owned by this pool");
+    }
+    idleInterpreters.push(interpreter);
+    notifyAll();
+  }
+
+  /**
+   * Releases all interpreters and the shared model.
+   *
+   * <p>Interpreters must not be in use by other threads when the pool is closed.
+   */
+  @Override
+  public synchronized void close() {
+    if (closed) {
+      return;
+    }
+    closed = true;
+    for (Interpreter interpreter : allInterpreters) {
+      interpreter.close();
+    }
+    allInterpreters.clear();
+    idleInterpreters.clear();
+    nativeFreeModel(nativeModelAddress);
+    notifyAll();
+  }
+
+  private static native long nativeNewModel(ByteBuffer modelByteBuffer);
+
+  private static native void nativeFreeModel(long nativeModelAddress);
+}
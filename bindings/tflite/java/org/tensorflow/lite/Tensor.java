@@ -162,19 +162,34 @@ public final class Tensor {
     return quantizationParams;
   }
 
+  /**
+   * Returns a direct {@link ByteBuffer} in native byte order that aliases the tensor memory.
+   *
+   * <p>Input data written into the returned buffer is used directly by the next call to {@link
+   * Interpreter#invoke()} and output data can be read from it afterward without any additional
+   * copies. Passing the buffer (or a typed view of it) to {@link Interpreter#run(Buffer, Buffer)}
+   * is also supported and skips the copy.
+   *
+   * <p>The buffer is only valid until the tensors are reallocated (such as after {@link
+   * Interpreter#resizeInput(int, int[])}) or the owning {@link Interpreter} is closed.
+   */
+  public ByteBuffer buffer() {
+    return getNativeBuffer();
+  }
+
   void copyFromBuffer(Buffer inputBuffer) {
     checkBufferCapacity(inputBuffer);
     if (isDirectBuffer(inputBuffer)) {
       copyFromDirectBuffer(inputBuffer);
     } else {
       if (inputBuffer instanceof ByteBuffer) {
-        ((ByteBuffer) inputBuffer).put(getNativeBuffer());
+        getNativeBuffer().put((ByteBuffer) inputBuffer);
       } else if (inputBuffer instanceof FloatBuffer) {
-        ((FloatBuffer) inputBuffer).put(getNativeBuffer().asFloatBuffer());
+        getNativeBuffer().asFloatBuffer().put((FloatBuffer) inputBuffer);
       } else if (inputBuffer instanceof IntBuffer) {
-        ((IntBuffer) inputBuffer).put(getNativeBuffer().asIntBuffer());
+        getNativeBuffer().asIntBuffer().put((IntBuffer) inputBuffer);
       } else if (inputBuffer instanceof LongBuffer) {
-        ((LongBuffer) inputBuffer).put(getNativeBuffer().asLongBuffer());
+        getNativeBuffer().asLongBuffer().put((LongBuffer) inputBuffer);
       } else {
         throw new IllegalArgumentException(
             "Unexpected input buffer type: " + inputBuffer.getClass());
@@ -188,13 +203,13 @@ public final class Tensor {
       copyToDirectBuffer(outputBuffer);
     } else {
       if (outputBuffer instanceof ByteBuffer) {
-        getNativeBuffer().put((ByteBuffer) outputBuffer);
+        ((ByteBuffer) outputBuffer).put(getNativeBuffer());
       } else if (outputBuffer instanceof FloatBuffer) {
-        getNativeBuffer().asFloatBuffer().put((FloatBuffer) outputBuffer);
+        ((FloatBuffer) outputBuffer).put(getNativeBuffer().asFloatBuffer());
       } else if (outputBuffer instanceof IntBuffer) {
-        getNativeBuffer().asIntBuffer().put((IntBuffer) outputBuffer);
+        ((IntBuffer) outputBuffer).put(getNativeBuffer().asIntBuffer());
       } else if (outputBuffer instanceof LongBuffer) {
-        getNativeBuffer().asLongBuffer().put((LongBuffer) outputBuffer);
+        ((LongBuffer) outputBuffer).put(getNativeBuffer().asLongBuffer());
       } else {
         throw new IllegalArgumentException(
             "Unexpected output buffer type: " + outputBuffer.getClass());
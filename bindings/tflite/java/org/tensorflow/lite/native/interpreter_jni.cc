@@ -57,6 +57,25 @@ JNI_FUNC jlong JNI_PREFIX(nativeNew)(JNIEnv* env, jobject thiz,
   return reinterpret_cast<jlong>(interpreter);
 }
 
+JNI_FUNC jlong JNI_PREFIX(nativeNewFromModel)(JNIEnv* env, jobject thiz,
+                                              jlong model_handle,
+                                              jint num_threads) {
+  TfLiteModel* model = reinterpret_cast<TfLiteModel*>(model_handle);
+  if (!model) {
+    return 0;  // Failed get handle. Returning to error in Java.
+  }
+
+  TfLiteInterpreterOptions* options = TfLiteInterpreterOptionsCreate();
+  TfLiteInterpreterOptionsSetNumThreads(options, num_threads);
+
+  // The interpreter retains the model (and the HAL device it shares with all
+  // other interpreters of the model).
+  TfLiteInterpreter* interpreter = TfLiteInterpreterCreate(model, options);
+  TfLiteInterpreterOptionsDelete(options);
+
+  return reinterpret_cast<jlong>(interpreter);
+}
+
 JNI_FUNC void JNI_PREFIX(nativeFree)(JNIEnv* env, jobject thiz) {
   TfLiteInterpreter* interpreter = GetInterpreter(env, thiz);
   IREE_DCHECK_NE(interpreter, nullptr);
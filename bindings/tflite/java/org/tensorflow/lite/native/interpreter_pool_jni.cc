@@ -0,0 +1,36 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <jni.h>
+
+#include "iree/base/logging.h"
+
+// NOTE: we pull in our own copy here in case the tflite API changes upstream.
+#define TFL_COMPILE_LIBRARY 1
+#include "bindings/tflite/include/tensorflow/lite/c/c_api.h"
+
+#define JNI_FUNC extern "C" JNIEXPORT
+#define JNI_PREFIX(METHOD) Java_org_tensorflow_lite_InterpreterPool_##METHOD
+
+JNI_FUNC jlong JNI_PREFIX(nativeNewModel)(JNIEnv* env, jclass clazz,
+                                          jobject model_byte_buffer) {
+  // NOTE: the model references the buffer contents directly and the Java pool
+  // keeps the buffer alive for as long as the model exists.
+  const char* buf =
+      static_cast<char*>(env->GetDirectBufferAddress(model_byte_buffer));
+  if (!buf) {
+    return 0;  // Not a direct buffer. Returning to error in Java.
+  }
+  jlong capacity = env->GetDirectBufferCapacity(model_byte_buffer);
+  return reinterpret_cast<jlong>(TfLiteModelCreate(buf, capacity));
+}
+
+JNI_FUNC void JNI_PREFIX(nativeFreeModel)(JNIEnv* env, jclass clazz,
+                                          jlong model_handle) {
+  TfLiteModel* model = reinterpret_cast<TfLiteModel*>(model_handle);
+  IREE_DCHECK_NE(model, nullptr);
+  TfLiteModelDelete(model);
+}
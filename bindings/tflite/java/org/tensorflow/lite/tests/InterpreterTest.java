@@ -10,6 +10,8 @@ package org.tensorflow.lite;
 
 import static org.junit.Assert.assertArrayEquals;
 import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertNotSame;
+import static org.junit.Assert.assertSame;
 
 import android.content.Context;
 import android.content.res.Resources;
@@ -69,6 +71,40 @@ public final class InterpreterTest {
     }
   }
 
+  @Test
+  public void testPoolWithTensorBuffers() throws Exception {
+    Context context = ApplicationProvider.getApplicationContext();
+    Resources resources = context.getResources();
+    InputStream moduleInputStream = resources.openRawResource(R.raw.simple_add_bytecode_module);
+    ByteBuffer moduleByteBuffer = convertInputStreamToByteBuffer(moduleInputStream);
+
+    try (InterpreterPool pool = new InterpreterPool(moduleByteBuffer, null, 2)) {
+      Interpreter interpreter0 = pool.acquire();
+      Interpreter interpreter1 = pool.acquire();
+      assertNotSame(interpreter0, interpreter1);
+
+      interpreter0.allocateTensors();
+      FloatBuffer inputBuffer = interpreter0.getInputTensor(0).buffer().asFloatBuffer();
+      FloatBuffer outputBuffer = interpreter0.getOutputTensor(0).buffer().asFloatBuffer();
+      for (int i = 0; i < 2; ++i) {
+        float[] input = {1 + i, 3 + i};
+        float[] output = new float[2];
+        inputBuffer.rewind();
+        inputBuffer.put(input);
+        interpreter0.invoke();
+        outputBuffer.rewind();
+        outputBuffer.get(output);
+        float[] expectedOutput = {2 * input[0], 2 * input[1]};
+        assertArrayEquals(expectedOutput, output, EPSILON);
+      }
+
+      pool.release(interpreter1);
+      assertSame(interpreter1, pool.acquire());
+      pool.release(interpreter0);
+      pool.release(interpreter1);
+    }
+  }
+
   private static FloatBuffer allocateNativeFloatBuffer(int floatLength) {
     return ByteBuffer.allocateDirect(BYTES_IN_FLOAT * floatLength)
         .order(ByteOrder.nativeOrder())
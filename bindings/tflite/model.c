@@ -119,6 +119,7 @@ TFL_CAPI_EXPORT extern TfLiteModel* TfLiteModelCreate(const void* model_data,
   memset(model, 0, sizeof(*model));
   iree_atomic_ref_count_init(&model->ref_count);
   model->allocator = allocator;
+  iree_slim_mutex_initialize(&model->device_mutex);
 
   status =
       _TfLiteModelInitializeModule(model_data, model_size, allocator, model);
@@ -158,6 +159,7 @@ TFL_CAPI_EXPORT extern TfLiteModel* TfLiteModelCreateFromFile(
   memset(model, 0, sizeof(*model));
   iree_atomic_ref_count_init(&model->ref_count);
   model->allocator = allocator;
+  iree_slim_mutex_initialize(&model->device_mutex);
   model->owned_model_data = (uint8_t*)model + file_size;
   int ret = fread(model->owned_model_data, 1, file_size, file);
   fclose(file);
@@ -188,6 +190,9 @@ void _TfLiteModelRelease(TfLiteModel* model) {
   if (model && iree_atomic_ref_count_dec(&model->ref_count) == 1) {
     IREE_TRACE_ZONE_BEGIN(z0);
     iree_vm_module_release(model->module);
+    iree_hal_device_release(model->device);
+    iree_hal_driver_release(model->driver);
+    iree_slim_mutex_deinitialize(&model->device_mutex);
     iree_allocator_free(model->allocator, model);
     IREE_TRACE_ZONE_END(z0);
   }
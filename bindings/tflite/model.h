@@ -9,6 +9,8 @@
 
 #include "iree/base/api.h"
 #include "iree/base/internal/atomics.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/hal/api.h"
 #include "iree/vm/api.h"
 
 // NOTE: we pull in our own copy here in case the tflite API changes upstream.
@@ -33,6 +35,14 @@ struct TfLiteModel {
   _TfLiteModelExports exports;
   int32_t input_count;
   int32_t output_count;
+
+  // HAL driver and device shared by all interpreters created from the model.
+  // Created by the first interpreter that needs them and released along with
+  // the model so that pools of interpreters on multiple threads only pay for
+  // device creation once.
+  iree_slim_mutex_t device_mutex;
+  iree_hal_driver_t* driver;
+  iree_hal_device_t* device;
 };
 
 void _TfLiteModelRetain(TfLiteModel* model);
@@ -127,39 +127,47 @@ iree_status_t _TfLiteTensorReallocateIfNeeded(
               IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR, &allocation_size));
   allocation_size *= storage_scalar;
 
-  // If the old buffer is the same size then no need to realloc.
+  // If the old buffer is the same size then no need to realloc. The buffer
+  // (and its mapping) persist across invocations so that pointers returned
+  // from TfLiteTensorData remain valid until the next resize.
   if (tensor->buffer &&
       iree_hal_buffer_byte_length(tensor->buffer) == allocation_size) {
     IREE_TRACE_ZONE_END(z0);
     return iree_ok_status();
   }
 
+  // Drop the old buffer before allocating the new one so that we aren't
+  // holding both at the same time.
+  _TfLiteTensorDiscardBuffer(tensor);
+
   // Allocate the underlying buffer for the tensor.
+  iree_hal_buffer_t* buffer = NULL;
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
       z0,
       iree_hal_allocator_allocate_buffer(
           buffer_allocator,
           IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE,
           IREE_HAL_BUFFER_USAGE_ALL, allocation_size,
-          iree_const_byte_span_empty(), &tensor->buffer));
+          iree_const_byte_span_empty(), &buffer));
 
   // Map the buffer memory immediately. The tflite API doesn't let us know if
   // this is a buffer the user will actually touch or some state buffer that is
   // just going to be passed to future invocations. We could move this to an
   // on-demand mapping when the user calls TfLiteTensorData but this at least
   // puts potential errors in the same easy to find place.
-  IREE_RETURN_AND_END_ZONE_IF_ERROR(
-      z0,
-      iree_hal_buffer_map_range(tensor->buffer, IREE_HAL_MAPPING_MODE_SCOPED,
-                                IREE_HAL_MEMORY_ACCESS_ALL, 0,
-                                IREE_WHOLE_BUFFER, &tensor->buffer_mapping));
+  iree_status_t status = _TfLiteTensorBind(tensor, buffer);
+  iree_hal_buffer_release(buffer);
 
   IREE_TRACE_ZONE_END(z0);
-  return iree_ok_status();
+  return status;
 }
 
 iree_status_t _TfLiteTensorBind(TfLiteTensor* tensor,
                                 iree_hal_buffer_t* buffer) {
+  // Rebinding the same buffer (such as a persistent state buffer returned on
+  // each invocation) keeps the existing mapping.
+  if (buffer && buffer == tensor->buffer) return iree_ok_status();
+
   IREE_TRACE_ZONE_BEGIN(z0);
   _TfLiteTensorDiscardBuffer(tensor);
   if (!buffer) {
@@ -172,11 +180,20 @@ iree_status_t _TfLiteTensorBind(TfLiteTensor* tensor,
   // should be read or read/write - or if we even need to map at all. We could
   // move this to an on-demand mapping when the user calls TfLiteTensorData but
   // this at least puts potential errors in the same easy to find place.
+  // Host-visible buffers are mapped persistently so that the pointer can be
+  // handed directly to the user and remain valid across invocations.
+  iree_hal_mapping_mode_t mapping_mode = IREE_HAL_MAPPING_MODE_SCOPED;
+  if (iree_all_bits_set(iree_hal_buffer_memory_type(buffer),
+                        IREE_HAL_MEMORY_TYPE_HOST_VISIBLE) &&
+      iree_all_bits_set(iree_hal_buffer_allowed_usage(buffer),
+                        IREE_HAL_BUFFER_USAGE_MAPPING)) {
+    mapping_mode = IREE_HAL_MAPPING_MODE_PERSISTENT;
+  }
   iree_device_size_t byte_offset = 0;
   iree_device_size_t byte_length = IREE_WHOLE_BUFFER;
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
       z0, iree_hal_buffer_map_range(
-              buffer, IREE_HAL_MAPPING_MODE_SCOPED,
+              buffer, mapping_mode,
               IREE_HAL_MEMORY_ACCESS_READ | IREE_HAL_MEMORY_ACCESS_WRITE,
               byte_offset, byte_length, &tensor->buffer_mapping));
 
@@ -191,13 +208,33 @@ iree_status_t _TfLiteTensorBind(TfLiteTensor* tensor,
 void _TfLiteTensorDiscardBuffer(TfLiteTensor* tensor) {
   IREE_TRACE_ZONE_BEGIN(z0);
   if (tensor->buffer_mapping.contents.data != NULL) {
-    iree_hal_buffer_unmap_range(&tensor->buffer_mapping);
+    iree_status_ignore(iree_hal_buffer_unmap_range(&tensor->buffer_mapping));
   }
   iree_hal_buffer_release(tensor->buffer);
   tensor->buffer = NULL;
   IREE_TRACE_ZONE_END(z0);
 }
 
+iree_status_t _TfLiteTensorFlush(TfLiteTensor* tensor) {
+  if (!tensor->buffer || tensor->buffer_mapping.contents.data == NULL ||
+      iree_all_bits_set(iree_hal_buffer_memory_type(tensor->buffer),
+                        IREE_HAL_MEMORY_TYPE_HOST_COHERENT)) {
+    return iree_ok_status();
+  }
+  return iree_hal_buffer_flush_range(&tensor->buffer_mapping, 0,
+                                     IREE_WHOLE_BUFFER);
+}
+
+iree_status_t _TfLiteTensorInvalidate(TfLiteTensor* tensor) {
+  if (!tensor->buffer || tensor->buffer_mapping.contents.data == NULL ||
+      iree_all_bits_set(iree_hal_buffer_memory_type(tensor->buffer),
+                        IREE_HAL_MEMORY_TYPE_HOST_COHERENT)) {
+    return iree_ok_status();
+  }
+  return iree_hal_buffer_invalidate_range(&tensor->buffer_mapping, 0,
+                                          IREE_WHOLE_BUFFER);
+}
+
 void _TfLiteTensorReset(TfLiteTensor* tensor, iree_allocator_t allocator) {
   _TfLiteTensorDiscardBuffer(tensor);
   if (tensor->name.data) {
@@ -248,7 +285,11 @@ TFL_CAPI_EXPORT extern TfLiteStatus TfLiteTensorCopyFromBuffer(
   // the buffer mapped. If we knew the user would never use TfLiteTensorData and
   // could avoid mapping the buffer it would be more efficient and portable to
   // do the iree_hal_buffer_copy_data.
-  memcpy(tensor->buffer_mapping.contents.data, input_data, input_data_size);
+  // Callers that filled the tensor in-place via TfLiteTensorData (such as
+  // through a direct ByteBuffer wrapping it) pass the mapping back to us.
+  if (input_data != tensor->buffer_mapping.contents.data) {
+    memcpy(tensor->buffer_mapping.contents.data, input_data, input_data_size);
+  }
 
   IREE_TRACE_ZONE_END(z0);
   return kTfLiteOk;
@@ -265,8 +306,10 @@ TFL_CAPI_EXPORT extern TfLiteStatus TfLiteTensorCopyToBuffer(
       z0, output_tensor->buffer_mapping.contents.data_length);
 
   // NOTE: as with above we should use an iree_hal_buffer_read_data here.
-  memcpy(output_data, output_tensor->buffer_mapping.contents.data,
-         output_data_size);
+  if (output_data != output_tensor->buffer_mapping.contents.data) {
+    memcpy(output_data, output_tensor->buffer_mapping.contents.data,
+           output_data_size);
+  }
 
   IREE_TRACE_ZONE_END(z0);
   return kTfLiteOk;
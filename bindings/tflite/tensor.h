@@ -34,9 +34,12 @@ struct TfLiteTensor {
   int32_t shape_rank;
   int32_t shape_dims[IREE_BINDINGS_TFLITE_MAX_RANK];
 
-  // Allocated buffer view referencing the backing tensor memory.
+  // Allocated buffer referencing the backing tensor memory. Input buffers are
+  // allocated once and reused across invocations until resized.
   iree_hal_buffer_t* buffer;
-  // Persistently mapped buffer; invalidated when buffer is resized.
+  // Persistently mapped buffer; invalidated when buffer is resized or an
+  // output is rebound to a new buffer. TfLiteTensorData returns this pointer
+  // directly so that users can read and write tensor data in place.
   iree_hal_buffer_mapping_t buffer_mapping;
 };
 
@@ -68,6 +71,14 @@ iree_status_t _TfLiteTensorBind(TfLiteTensor* tensor,
 // Discards the current buffer view, if any, resetting it to NULL.
 void _TfLiteTensorDiscardBuffer(TfLiteTensor* tensor);
 
+// Flushes host writes to the tensor mapping so that they are visible to the
+// device. No-op for host-coherent memory.
+iree_status_t _TfLiteTensorFlush(TfLiteTensor* tensor);
+
+// Invalidates the tensor mapping so that device writes are visible to the
+// host. No-op for host-coherent memory.
+iree_status_t _TfLiteTensorInvalidate(TfLiteTensor* tensor);
+
 // Resets the tensor back to its initial state (no buffers, etc).
 void _TfLiteTensorReset(TfLiteTensor* tensor, iree_allocator_t allocator);
 
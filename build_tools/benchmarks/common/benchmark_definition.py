@@ -346,6 +346,34 @@ class BenchmarkResults(object):
       raise ValueError(f"Cannot found real_time_{kind} in benchmark results")
     return time
 
+  def get_function_aggregate_times(self, benchmark_index: int,
+                                   kind: str) -> Dict[str, float]:
+    """Returns the Google Benchmark aggregate time of each benchmarked function.
+
+      This is used for benchmarks running multiple functions from the same
+      module, like per-dispatch benchmarks.
+
+      Args:
+      - benchmark_index: the benchmark's index.
+      - kind: what kind of aggregate time to get; choices:
+        'mean', 'median', 'stddev'.
+
+      Returns:
+      - A dict mapping function names to their aggregate time in milliseconds.
+      """
+    times = {}
+    for bench_case in self.benchmarks[benchmark_index].results:
+      name = bench_case["name"]
+      if not name.startswith("BM_") or not name.endswith(f"real_time_{kind}"):
+        continue
+      if bench_case["time_unit"] != "ms":
+        raise ValueError(f"Expected ms as time unit")
+      function_name = name[len("BM_"):].split("/")[0]
+      times[function_name] = bench_case["real_time"]
+    if not times:
+      raise ValueError(f"Cannot found real_time_{kind} in benchmark results")
+    return times
+
   def to_json_str(self) -> str:
     json_object = {"commit": self.commit, "benchmarks": []}
     json_object["benchmarks"] = [b.to_json_object() for b in self.benchmarks]
@@ -40,6 +40,11 @@ class BenchmarkThreshold:
 # Order matters here: if multiple regexes match a single benchmark, the first
 # match is used.
 BENCHMARK_THRESHOLDS = [
+    # Per-dispatch benchmarks are reported in microseconds so the absolute
+    # thresholds below do not apply to them.
+    BenchmarkThreshold(re.compile(r".*per-dispatch:"), 10,
+                       ThresholdUnit.PERCENTAGE),
+
     # Fluctuating benchmarks on CPUs.
     BenchmarkThreshold(re.compile(r"^DeepLabV3.*big-core.*Dylib.* @ Pixel"), 20,
                        ThresholdUnit.PERCENTAGE),
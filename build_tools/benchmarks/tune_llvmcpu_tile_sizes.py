@@ -0,0 +1,283 @@
+#!/usr/bin/env python3
+# Copyright 2022 The IREE Authors
+#
+# Licensed under the Apache License v2.0 with LLVM Exceptions.
+# See https://llvm.org/LICENSE.txt for license information.
+# SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+"""Tunes LLVMCPU dispatch tile sizes and writes a tuning database.
+
+The input program is compiled with `--iree-flow-export-benchmark-funcs` and
+`--iree-codegen-llvmcpu-print-tuning-keys` to find the tuning key and default
+compilation info of each dispatch root op. Candidate workgroup tile sizes are
+then swept one key at a time: each candidate is compiled into the whole
+program through `--iree-codegen-llvmcpu-tuning-database` and timed with
+`iree-benchmark-module`, and the fastest configuration of each key is kept for
+the keys that follow.
+
+The resulting database can be passed to the compiler with
+`--iree-codegen-llvmcpu-tuning-database=<output>` when compiling for the same
+target triple.
+
+Example usage:
+  python3 tune_llvmcpu_tile_sizes.py \\
+      --input=/path/to/model.mlir \\
+      --output=/path/to/tuning_database.mlir \\
+      --target_triple=aarch64-unknown-linux-gnu \\
+      --iree_translate=/path/to/iree-translate \\
+      --iree_benchmark_module=/path/to/iree-benchmark-module
+"""
+
+import argparse
+import itertools
+import json
+import os
+import re
+import subprocess
+import tempfile
+from typing import Dict, List, Optional, Sequence, Tuple
+
+# Remarks emitted by --iree-codegen-llvmcpu-print-tuning-keys.
+TUNING_KEY_REMARK_RE = re.compile(
+    r'remark: tuning key "(?P<key>[^"]+)" = (?P<info>#iree_codegen\..*)$')
+LOWERING_CONFIG_RE = re.compile(
+    r"tile_sizes = \[(?P<tile_sizes>.*)\], native_vector_size = "
+    r"\[(?P<native_vector_size>[^\]]*)\]")
+TRANSLATION_INFO_RE = re.compile(
+    r'#iree_codegen\.translation\.info<"(?P<pipeline>\w+)"'
+    r"(?:, workload_per_wg = \[(?P<workload_per_wg>[^\]]*)\])?>")
+
+# Pipelines whose workgroup tile sizes are swept.
+TUNABLE_PIPELINES = ("CPUDoubleTilingExpert", "CPUTileFuseAndVectorize")
+
+# Factors applied to each default workload per workgroup entry.
+WORKLOAD_SCALE_FACTORS = (0.5, 1, 2, 4)
+
+TIME_UNITS_TO_NS = {"ns": 1, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+
+def _parse_int_list(text: str) -> List[int]:
+  return [int(x) for x in text.split(",") if x.strip()]
+
+
+def _format_int_list(values: Sequence[int]) -> str:
+  return "[" + ", ".join(str(v) for v in values) + "]"
+
+
+class CompilationInfo:
+  """Tile sizes and pipeline of an `#iree_codegen.compilation.info`."""
+
+  def __init__(self, tile_sizes: List[List[int]],
+               native_vector_size: List[int], pipeline: str,
+               workload_per_wg: List[int]):
+    self.tile_sizes = tile_sizes
+    self.native_vector_size = native_vector_size
+    self.pipeline = pipeline
+    self.workload_per_wg = workload_per_wg
+
+  @staticmethod
+  def parse(text: str) -> Optional["CompilationInfo"]:
+    config = LOWERING_CONFIG_RE.search(text)
+    translation = TRANSLATION_INFO_RE.search(text)
+    if not config or not translation:
+      return None
+    tile_sizes = [
+        _parse_int_list(level)
+        for level in re.findall(r"\[([^\[\]]*)\]",
+                                "[" + config.group("tile_sizes") + "]")
+    ]
+    return CompilationInfo(
+        tile_sizes=tile_sizes,
+        native_vector_size=_parse_int_list(
+            config.group("native_vector_size")),
+        pipeline=translation.group("pipeline"),
+        workload_per_wg=_parse_int_list(
+            translation.group("workload_per_wg") or ""))
+
+  def with_workload_per_wg(self,
+                           workload_per_wg: List[int]) -> "CompilationInfo":
+    """Returns a copy distributing `workload_per_wg` to each workgroup."""
+    tile_sizes = [list(level) for level in self.tile_sizes]
+    # When set, the first level tile sizes of the partitioned loops are the
+    # workload per workgroup in reverse order.
+    if tile_sizes and tile_sizes[0]:
+      partitioned_loops = [i for i, v in enumerate(tile_sizes[0]) if v != 0]
+      for loop, workload in zip(reversed(partitioned_loops), workload_per_wg):
+        tile_sizes[0][loop] = workload
+    return CompilationInfo(tile_sizes, self.native_vector_size, self.pipeline,
+                           workload_per_wg)
+
+  def __str__(self) -> str:
+    tile_sizes = "[" + ", ".join(
+        _format_int_list(level) for level in self.tile_sizes) + "]"
+    return ("#iree_codegen.compilation.info<"
+            "#iree_codegen.lowering.config<"
+            f"tile_sizes = {tile_sizes}, "
+            f"native_vector_size = {_format_int_list(self.native_vector_size)}"
+            ">, "
+            f'#iree_codegen.translation.info<"{self.pipeline}", '
+            f"workload_per_wg = {_format_int_list(self.workload_per_wg)}>, "
+            "workgroup_size = []>")
+
+
+def get_candidates(default: CompilationInfo,
+                   max_candidates: int) -> List[CompilationInfo]:
+  """Returns candidate configurations with the default first."""
+  if default.pipeline not in TUNABLE_PIPELINES or not default.workload_per_wg:
+    return [default]
+  per_dim_values = []
+  for workload in default.workload_per_wg:
+    values = sorted(
+        set(max(1, int(workload * f)) for f in WORKLOAD_SCALE_FACTORS))
+    per_dim_values.append(values)
+  candidates = [default]
+  for workload_per_wg in itertools.product(*per_dim_values):
+    if len(candidates) >= max_candidates:
+      break
+    if list(workload_per_wg) == default.workload_per_wg:
+      continue
+    candidates.append(default.with_workload_per_wg(list(workload_per_wg)))
+  return candidates
+
+
+def write_database(path: str, target_triple: str,
+                   entries: Dict[str, CompilationInfo]):
+  lines = ["{", f'  "{target_triple}" = {{']
+  items = [f'    "{key}" =\n        {info}' for key, info in entries.items()]
+  lines.append(",\n".join(items))
+  lines.append("  }")
+  lines.append("}")
+  with open(path, "w") as f:
+    f.write("\n".join(lines) + "\n")
+
+
+class Tuner:
+
+  def __init__(self, args: argparse.Namespace, work_dir: str):
+    self.args = args
+    self.work_dir = work_dir
+
+  def compile(self, database_path: Optional[str],
+              print_tuning_keys: bool = False) -> Tuple[str, str]:
+    """Compiles the input and returns the module path and compiler stderr."""
+    module_path = os.path.join(self.work_dir, "module.vmfb")
+    cmd = [
+        self.args.iree_translate,
+        self.args.input,
+        "--iree-mlir-to-vm-bytecode-module",
+        "--iree-hal-target-backends=dylib-llvm-aot",
+        f"--iree-llvm-target-triple={self.args.target_triple}",
+        "--iree-flow-export-benchmark-funcs",
+        f"--o={module_path}",
+    ] + self.args.compile_flag
+    if database_path:
+      cmd.append(f"--iree-codegen-llvmcpu-tuning-database={database_path}")
+    if print_tuning_keys:
+      cmd.append("--iree-codegen-llvmcpu-print-tuning-keys")
+    result = subprocess.run(cmd,
+                            stdout=subprocess.PIPE,
+                            stderr=subprocess.PIPE,
+                            universal_newlines=True)
+    if result.returncode != 0:
+      raise RuntimeError(f"compilation failed:\n{result.stderr}")
+    return module_path, result.stderr
+
+  def benchmark(self, module_path: str) -> float:
+    """Returns the total time in nanoseconds of all benchmark functions."""
+    cmd = [
+        self.args.iree_benchmark_module,
+        f"--module_file={module_path}",
+        "--driver=dylib",
+        "--benchmark_format=json",
+        f"--benchmark_repetitions={self.args.repetitions}",
+        "--benchmark_report_aggregates_only",
+    ] + self.args.benchmark_flag
+    result = subprocess.run(cmd,
+                            stdout=subprocess.PIPE,
+                            stderr=subprocess.PIPE,
+                            universal_newlines=True,
+                            check=True)
+    total_time_ns = 0.0
+    for benchmark in json.loads(result.stdout)["benchmarks"]:
+      if benchmark.get("aggregate_name", "median") != "median":
+        continue
+      total_time_ns += (benchmark["real_time"] *
+                        TIME_UNITS_TO_NS[benchmark["time_unit"]])
+    return total_time_ns
+
+  def tune(self) -> Dict[str, CompilationInfo]:
+    _, stderr = self.compile(database_path=None, print_tuning_keys=True)
+    defaults = {}
+    for line in stderr.splitlines():
+      match = TUNING_KEY_REMARK_RE.search(line)
+      if not match:
+        continue
+      info = CompilationInfo.parse(match.group("info"))
+      if info:
+        defaults.setdefault(match.group("key"), info)
+    print(f"Found {len(defaults)} tuning keys")
+
+    database_path = os.path.join(self.work_dir, "candidate_database.mlir")
+    tuned = {}
+    for key, default in defaults.items():
+      best_info, best_time_ns = None, None
+      for candidate in get_candidates(default, self.args.max_candidates):
+        write_database(database_path, self.args.target_triple,
+                       dict(tuned, **{key: candidate}))
+        try:
+          time_ns = self.benchmark(self.compile(database_path)[0])
+        except (RuntimeError, subprocess.CalledProcessError) as e:
+          print(f"  skipping candidate {candidate}: {e}")
+          continue
+        print(f"  {key}: {candidate.workload_per_wg} -> {time_ns:.0f} ns")
+        if best_time_ns is None or time_ns < best_time_ns:
+          best_info, best_time_ns = candidate, time_ns
+      if best_info is not None:
+        tuned[key] = best_info
+    return tuned
+
+
+def parse_arguments():
+  parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+  parser.add_argument("--input",
+                      required=True,
+                      help="MLIR input program to tune")
+  parser.add_argument("--output",
+                      required=True,
+                      help="Path of the tuning database to write")
+  parser.add_argument("--target_triple",
+                      required=True,
+                      help="LLVM target triple to compile for")
+  parser.add_argument("--iree_translate",
+                      default="iree-translate",
+                      help="Path to the iree-translate tool")
+  parser.add_argument("--iree_benchmark_module",
+                      default="iree-benchmark-module",
+                      help="Path to the iree-benchmark-module tool")
+  parser.add_argument("--compile_flag",
+                      action="append",
+                      default=[],
+                      help="Additional flag passed to iree-translate")
+  parser.add_argument("--benchmark_flag",
+                      action="append",
+                      default=[],
+                      help="Additional flag passed to iree-benchmark-module")
+  parser.add_argument("--repetitions",
+                      type=int,
+                      default=5,
+                      help="Benchmark repetitions per candidate")
+  parser.add_argument("--max_candidates",
+                      type=int,
+                      default=16,
+                      help="Maximum number of candidates swept per key")
+  return parser.parse_args()
+
+
+def main(args):
+  with tempfile.TemporaryDirectory() as work_dir:
+    tuned = Tuner(args, work_dir).tune()
+  write_database(args.output, args.target_triple, tuned)
+  print(f"Wrote {len(tuned)} entries to {args.output}")
+
+
+if __name__ == "__main__":
+  main(parse_arguments())
@@ -17,6 +17,7 @@ Example usage:
 """
 
 import argparse
+import dataclasses
 import json
 import os
 import re
@@ -31,6 +32,8 @@ from common.benchmark_definition import (BenchmarkInfo, BenchmarkResults,
 from common.benchmark_thresholds import BENCHMARK_THRESHOLDS
 
 IREE_GITHUB_COMMIT_URL_PREFIX = 'https://github.com/google/iree/commit'
+# The benchmark mode of benchmarks running each dispatch of a module separately.
+PER_DISPATCH_MODE = 'per-dispatch'
 IREE_PROJECT_ID = 'IREE'
 THIS_DIRECTORY = os.path.dirname(os.path.realpath(__file__))
 
@@ -44,6 +47,12 @@ https://github.com/google/iree/tree/main/benchmarks/dashboard.md
 </a> for benchmark philosophy, specification, and definitions.
 """
 
+PER_DISPATCH_DESCRIPTION = """
+<br>
+This series tracks a single dispatch of the model, benchmarked on its own with
+placeholder inputs. Its y axis is in microseconds instead of milliseconds.
+"""
+
 # A non-exhaustive list of models and their source URLs.
 # For models listed here we can provide a nicer description for them on
 # webpage.
@@ -66,6 +75,21 @@ IREE_TFLITE_MODEL_SOURCE_URL = {
 }
 
 
+def get_dispatch_benchmark_info(benchmark_info: BenchmarkInfo,
+                                function_name: str) -> BenchmarkInfo:
+  """Returns the benchmark info of one dispatch of a per-dispatch benchmark.
+
+  The dispatch is identified by suffixing the per-dispatch benchmark mode with
+  the dispatch name, e.g. 'per-dispatch:main_dispatch_0'.
+  """
+  dispatch_name = re.sub(r"_benchmark$", "", function_name)
+  bench_mode = [
+      f"{mode}:{dispatch_name}" if mode == PER_DISPATCH_MODE else mode
+      for mode in benchmark_info.bench_mode
+  ]
+  return dataclasses.replace(benchmark_info, bench_mode=bench_mode)
+
+
 def get_model_description(benchmark_info: BenchmarkInfo) -> Optional[str]:
   """Gets the model description for the given benchmark."""
   url = None
@@ -314,6 +338,21 @@ def main(args):
     benchmark_case = all_results.benchmarks[benchmark_index]
     benchmark_info = benchmark_case.benchmark_info
 
+    if PER_DISPATCH_MODE in benchmark_info.bench_mode:
+      # Each dispatch gets its own series, in microseconds given that most
+      # dispatches complete in well under a millisecond.
+      mean_times = all_results.get_function_aggregate_times(
+          benchmark_index, "mean")
+      for function_name, mean_time in mean_times.items():
+        dispatch_info = get_dispatch_benchmark_info(benchmark_info,
+                                                    function_name)
+        name = str(dispatch_info)
+        if name in aggregate_results:
+          raise ValueError(f"Duplicated benchmarks: {name}")
+        aggregate_results[name] = (int(round(mean_time * 1000)),
+                                   dispatch_info)
+      continue
+
     # Make sure each benchmark has a unique name.
     name = str(benchmark_info)
     if name in aggregate_results:
@@ -328,6 +367,10 @@ def main(args):
     if description is None:
       description = ""
     description += COMMON_DESCRIIPTION
+    if any(
+        mode.startswith(f"{PER_DISPATCH_MODE}:")
+        for mode in benchmark_info.bench_mode):
+      description += PER_DISPATCH_DESCRIPTION
 
     # Override by default to allow updates to the series.
     add_new_iree_series(series_id,
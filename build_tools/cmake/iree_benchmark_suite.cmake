@@ -38,6 +38,11 @@
 #   DRIVER: The runtime driver.
 #   RUNTIME_FLAGS: A list of command-line options and their values to pass
 #       to the IREE runtime during benchmark exectuion.
+#   DISPATCH_BENCHMARKS: Benchmarks each unique dispatch of the modules
+#       individually instead of the module entry function. The modules are
+#       translated with `--iree-flow-export-benchmark-funcs` and all exported
+#       dispatch functions are run. Benchmark modes of such suites should
+#       include the `per-dispatch` tag.
 #
 # The above parameters largely fall into two categories: 1) for specifying
 # the MLIR input module and its metadata, 2) for specifying the translation/
@@ -67,7 +72,7 @@ function(iree_benchmark_suite)
   cmake_parse_arguments(
     PARSE_ARGV 0
     _RULE
-    ""
+    "DISPATCH_BENCHMARKS"
     "DRIVER;TARGET_BACKEND;TARGET_ARCHITECTURE"
     "BENCHMARK_MODES;BENCHMARK_TOOL;MODULES;TRANSLATION_FLAGS;RUNTIME_FLAGS"
   )
@@ -183,6 +188,9 @@ function(iree_benchmark_suite)
       list(APPEND _TRANSLATION_ARGS "--iree-hal-target-backends=${_RULE_TARGET_BACKEND}")
       list(SORT _RULE_TRANSLATION_FLAGS)
       list(APPEND _TRANSLATION_ARGS ${_RULE_TRANSLATION_FLAGS})
+      if(_RULE_DISPATCH_BENCHMARKS)
+        list(APPEND _TRANSLATION_ARGS "--iree-flow-export-benchmark-funcs")
+      endif()
 
       # Get a unique identifier for this IREE module file by hashing the command
       # line flags and input file. We will also use this for the CMake target.
@@ -221,6 +229,11 @@ function(iree_benchmark_suite)
 
         # Mark dependency so that we have one target to drive them all.
         add_dependencies(iree-benchmark-suites "${_TRANSLATION_TARGET_NAME}")
+        if(_RULE_DISPATCH_BENCHMARKS)
+          add_dependencies(iree-dispatch-benchmark-suites
+            "${_TRANSLATION_TARGET_NAME}"
+          )
+        endif()
       endif(NOT TARGET "${_TRANSLATION_TARGET_NAME}")
 
       # Add a friendly target name to drive this benchmark and any others that
@@ -239,7 +252,19 @@ function(iree_benchmark_suite)
       # Create the command and target for the flagfile spec used to execute
       # the generated artifacts.
       set(_FLAG_FILE "${_RUN_SPEC_DIR}/flagfile")
-      set(_ADDITIONAL_ARGS_CL "--additional_args=\"${_RULE_RUNTIME_FLAGS}\"")
+      set(_RUNTIME_FLAGS ${_RULE_RUNTIME_FLAGS})
+      if(_RULE_DISPATCH_BENCHMARKS)
+        # Dispatch functions take no inputs; run all of them instead of the
+        # entry function.
+        set(_FUNCTION_ARGS_CL "")
+        list(APPEND _RUNTIME_FLAGS "--exported_benchmark_type=dispatch")
+      else()
+        set(_FUNCTION_ARGS_CL
+          "--entry_function=${_MODULE_ENTRY_FUNCTION}"
+          "--function_inputs=${_MODULE_FUNCTION_INPUTS}"
+        )
+      endif()
+      set(_ADDITIONAL_ARGS_CL "--additional_args=\"${_RUNTIME_FLAGS}\"")
       file(RELATIVE_PATH _MODULE_FILE_FLAG "${_RUN_SPEC_DIR}" "${_VMFB_FILE}")
       add_custom_command(
         OUTPUT "${_FLAG_FILE}"
@@ -247,8 +272,7 @@ function(iree_benchmark_suite)
           "${Python3_EXECUTABLE}" "${IREE_ROOT_DIR}/scripts/generate_flagfile.py"
             --module_file="${_MODULE_FILE_FLAG}"
             --driver=${_RULE_DRIVER}
-            --entry_function=${_MODULE_ENTRY_FUNCTION}
-            --function_inputs=${_MODULE_FUNCTION_INPUTS}
+            ${_FUNCTION_ARGS_CL}
             "${_ADDITIONAL_ARGS_CL}"
             -o "${_FLAG_FILE}"
         DEPENDS
@@ -296,6 +320,12 @@ function(iree_benchmark_suite)
         "${_FLAGFILE_GEN_TARGET_NAME}"
         "${_TOOLFILE_GEN_TARGET_NAME}"
       )
+      if(_RULE_DISPATCH_BENCHMARKS)
+        add_dependencies(iree-dispatch-benchmark-suites
+          "${_FLAGFILE_GEN_TARGET_NAME}"
+          "${_TOOLFILE_GEN_TARGET_NAME}"
+        )
+      endif()
     endforeach(_BENCHMARK_MODE IN LISTS _RULE_BENCHMARK_MODES)
 
   endforeach(_MODULE IN LISTS _RULE_MODULES)
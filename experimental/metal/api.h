@@ -0,0 +1,97 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// See iree/base/api.h for documentation on the API conventions used.
+
+#ifndef IREE_HAL_METAL_API_H_
+#define IREE_HAL_METAL_API_H_
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#if defined(__OBJC__)
+#import <Metal/Metal.h>
+#endif  // __OBJC__
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+//===----------------------------------------------------------------------===//
+// iree_hal_metal_device_t
+//===----------------------------------------------------------------------===//
+
+// Buffer index of the push constants of a dispatch. Descriptor sets are bound
+// as argument buffers at the buffer index matching their set ordinal and the
+// push constants follow them.
+#define IREE_HAL_METAL_PUSH_CONSTANT_BUFFER_INDEX 3
+
+// Maximum number of descriptor sets an executable layout may have.
+#define IREE_HAL_METAL_MAX_DESCRIPTOR_SET_COUNT \
+  IREE_HAL_METAL_PUSH_CONSTANT_BUFFER_INDEX
+
+// Maximum number of bindings in a descriptor set.
+#define IREE_HAL_METAL_MAX_DESCRIPTOR_SET_BINDING_COUNT 32
+
+// Maximum number of 32-bit push constants an executable layout may have.
+#define IREE_HAL_METAL_MAX_PUSH_CONSTANT_COUNT 64
+
+// Parameters configuring an iree_hal_metal_device_t.
+// Must be initialized with iree_hal_metal_device_options_initialize prior to
+// use.
+typedef struct iree_hal_metal_device_options_t {
+  // Size, in bytes, of the block pool used to record command buffers.
+  iree_host_size_t arena_block_size;
+
+  // Size, in bytes, of the shared-storage blocks that argument buffers of
+  // pushed descriptor sets are sub-allocated from during a submission.
+  iree_host_size_t argument_buffer_block_size;
+} iree_hal_metal_device_options_t;
+
+// Initializes |out_options| to default values.
+IREE_API_EXPORT void iree_hal_metal_device_options_initialize(
+    iree_hal_metal_device_options_t* out_options);
+
+#if defined(__OBJC__)
+
+// Wraps an existing Metal |handle| in a HAL device. The device is retained
+// for the lifetime of the HAL device and a new command queue is created on it.
+//
+// |out_device| must be released by the caller (see iree_hal_device_release).
+IREE_API_EXPORT iree_status_t iree_hal_metal_wrap_device(
+    iree_string_view_t identifier,
+    const iree_hal_metal_device_options_t* options, id<MTLDevice> handle,
+    iree_allocator_t host_allocator, iree_hal_device_t** out_device);
+
+#endif  // __OBJC__
+
+//===----------------------------------------------------------------------===//
+// iree_hal_metal_driver_t
+//===----------------------------------------------------------------------===//
+
+// Metal driver creation options.
+typedef struct iree_hal_metal_driver_options_t {
+  // Options used for all devices created by the driver.
+  iree_hal_metal_device_options_t default_device_options;
+} iree_hal_metal_driver_options_t;
+
+// Initializes |out_options| to default values.
+IREE_API_EXPORT void iree_hal_metal_driver_options_initialize(
+    iree_hal_metal_driver_options_t* out_options);
+
+// Creates a Metal HAL driver enumerating the system Metal devices.
+//
+// |out_driver| must be released by the caller (see iree_hal_driver_release).
+IREE_API_EXPORT iree_status_t iree_hal_metal_driver_create(
+    iree_string_view_t identifier,
+    const iree_hal_metal_driver_options_t* options,
+    iree_allocator_t host_allocator, iree_hal_driver_t** out_driver);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_METAL_API_H_
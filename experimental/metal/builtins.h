@@ -0,0 +1,52 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_METAL_BUILTINS_H_
+#define IREE_HAL_METAL_BUILTINS_H_
+
+#import <Metal/Metal.h>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Threadgroup size of the fill_buffer builtin.
+#define IREE_HAL_METAL_FILL_BUFFER_THREADGROUP_SIZE 64
+
+// Number of bytes each thread of the fill_buffer builtin writes.
+#define IREE_HAL_METAL_FILL_BUFFER_BYTES_PER_THREAD 4
+
+// Parameters of the fill_buffer builtin bound at buffer index 1.
+typedef struct iree_hal_metal_fill_buffer_params_t {
+  // Offset, in bytes, of the first byte to fill in the target buffer.
+  uint32_t offset;
+  // Number of bytes to fill.
+  uint32_t length;
+  // Pattern splatted to 32 bits starting at |offset|.
+  uint32_t pattern;
+} iree_hal_metal_fill_buffer_params_t;
+
+// Pipelines implementing HAL commands Metal has no native equivalent for.
+// Metal blit encoders can only fill buffers with a single byte value.
+typedef struct iree_hal_metal_builtins_t {
+  // Fills a byte range of the buffer at index 0 with a repeating pattern.
+  // Each thread writes IREE_HAL_METAL_FILL_BUFFER_BYTES_PER_THREAD bytes.
+  id<MTLComputePipelineState> fill_buffer_pipeline;
+} iree_hal_metal_builtins_t;
+
+iree_status_t iree_hal_metal_builtins_initialize(
+    id<MTLDevice> device, iree_hal_metal_builtins_t* out_builtins);
+
+void iree_hal_metal_builtins_deinitialize(iree_hal_metal_builtins_t* builtins);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_METAL_BUILTINS_H_
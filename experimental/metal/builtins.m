@@ -0,0 +1,71 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "experimental/metal/builtins.h"
+
+#include <string.h>
+
+#include "iree/base/api.h"
+#include "iree/base/tracing.h"
+
+// Builtins are small enough to compile from source when the device is created.
+// The layout of |params| matches iree_hal_metal_fill_buffer_params_t.
+static const char iree_hal_metal_builtins_source[] =
+    "#include <metal_stdlib>\n"
+    "using namespace metal;\n"
+    "struct fill_buffer_params {\n"
+    "  uint offset;\n"
+    "  uint length;\n"
+    "  uint pattern;\n"
+    "};\n"
+    "kernel void fill_buffer(\n"
+    "    device uchar* target [[buffer(0)]],\n"
+    "    constant fill_buffer_params& params [[buffer(1)]],\n"
+    "    uint id [[thread_position_in_grid]]) {\n"
+    "  uint begin = id * 4;\n"
+    "  uint end = min(begin + 4, params.length);\n"
+    "  for (uint i = begin; i < end; ++i) {\n"
+    "    target[params.offset + i] =\n"
+    "        (uchar)((params.pattern >> ((i & 3) * 8)) & 0xFF);\n"
+    "  }\n"
+    "}\n";
+
+iree_status_t iree_hal_metal_builtins_initialize(
+    id<MTLDevice> device, iree_hal_metal_builtins_t* out_builtins) {
+  IREE_ASSERT_ARGUMENT(device);
+  IREE_ASSERT_ARGUMENT(out_builtins);
+  memset(out_builtins, 0, sizeof(*out_builtins));
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  NSString* source =
+      [[NSString alloc] initWithUTF8String:iree_hal_metal_builtins_source];
+  NSError* error = nil;
+  id<MTLLibrary> library = [device newLibraryWithSource:source
+                                                options:nil
+                                                  error:&error];
+  [source release];
+  id<MTLFunction> function = [library newFunctionWithName:@"fill_buffer"];
+  [library release];
+  if (function) {
+    out_builtins->fill_buffer_pipeline =
+        [device newComputePipelineStateWithFunction:function error:&error];
+    [function release];
+  }
+
+  iree_status_t status = iree_ok_status();
+  if (!out_builtins->fill_buffer_pipeline) {
+    status = iree_make_status(
+        IREE_STATUS_INTERNAL, "failed to create the fill_buffer builtin: %s",
+        error ? error.localizedDescription.UTF8String : "unknown error");
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+void iree_hal_metal_builtins_deinitialize(iree_hal_metal_builtins_t* builtins) {
+  [builtins->fill_buffer_pipeline release];
+  memset(builtins, 0, sizeof(*builtins));
+}
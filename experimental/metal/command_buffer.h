@@ -0,0 +1,44 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_METAL_COMMAND_BUFFER_H_
+#define IREE_HAL_METAL_COMMAND_BUFFER_H_
+
+#import <Metal/Metal.h>
+
+#include "experimental/metal/builtins.h"
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Creates a command buffer that encodes directly into |handle|.
+//
+// MTLCommandBuffers are single-use and cannot be replayed so the device
+// records the commands of all HAL command buffers into deferred command
+// buffers and replays them into an instance of this command buffer per
+// submission batch. |handle| is retained and the caller commits it after the
+// command buffer has ended.
+//
+// Descriptor sets are encoded into argument buffers sub-allocated from
+// shared-storage blocks of |argument_buffer_block_size| bytes that live as
+// long as |handle| references them.
+//
+// |builtins| are owned by the device and must remain valid for the lifetime of
+// the command buffer.
+iree_status_t iree_hal_metal_command_buffer_create(
+    iree_hal_device_t* base_device, id<MTLDevice> device,
+    id<MTLCommandBuffer> handle, iree_host_size_t argument_buffer_block_size,
+    iree_hal_metal_builtins_t* builtins, iree_allocator_t host_allocator,
+    iree_hal_command_buffer_t** out_command_buffer);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_METAL_COMMAND_BUFFER_H_
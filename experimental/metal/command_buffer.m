@@ -0,0 +1,628 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "experimental/metal/command_buffer.h"
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "experimental/metal/api.h"
+#include "experimental/metal/descriptor_set.h"
+#include "experimental/metal/descriptor_set_layout.h"
+#include "experimental/metal/executable.h"
+#include "experimental/metal/executable_layout.h"
+#include "experimental/metal/metal_buffer.h"
+#include "iree/base/api.h"
+#include "iree/base/tracing.h"
+
+typedef struct iree_hal_metal_descriptor_set_state_t {
+  // Argument buffer block holding the encoded set and the offset of the set in
+  // it; nil if the set has not been bound.
+  id<MTLBuffer> argument_buffer;
+  iree_host_size_t argument_offset;
+  // Buffers referenced by the argument buffer. Metal does not track resources
+  // accessed indirectly so they are made resident for each dispatch.
+  iree_host_size_t resource_count;
+  id<MTLBuffer> resources[IREE_HAL_METAL_MAX_DESCRIPTOR_SET_BINDING_COUNT];
+} iree_hal_metal_descriptor_set_state_t;
+
+typedef struct iree_hal_metal_command_buffer_t {
+  iree_hal_command_buffer_t base;
+  iree_allocator_t host_allocator;
+  id<MTLDevice> device;
+  id<MTLCommandBuffer> handle;
+  iree_hal_metal_builtins_t* builtins;
+
+  // Encoder of the current run of dispatches or transfers; only one of these
+  // is open at a time and both are ended when switching between them.
+  id<MTLComputeCommandEncoder> compute_encoder;
+  id<MTLBlitCommandEncoder> blit_encoder;
+
+  // Shared-storage blocks that argument buffers are sub-allocated from. All
+  // blocks are retained until the command buffer is destroyed; |handle| keeps
+  // the ones it uses alive until it completes.
+  NSMutableArray<id<MTLBuffer>>* argument_blocks;
+  iree_host_size_t argument_block_size;
+  // Offset of the next free byte in the last block of |argument_blocks|.
+  iree_host_size_t argument_block_offset;
+
+  struct {
+    // Push constants for the next dispatch.
+    uint32_t push_constants[IREE_HAL_METAL_MAX_PUSH_CONSTANT_COUNT];
+    iree_hal_metal_descriptor_set_state_t
+        sets[IREE_HAL_METAL_MAX_DESCRIPTOR_SET_COUNT];
+  } state;
+} iree_hal_metal_command_buffer_t;
+
+static const iree_hal_command_buffer_vtable_t
+    iree_hal_metal_command_buffer_vtable;
+
+static iree_hal_metal_command_buffer_t* iree_hal_metal_command_buffer_cast(
+    iree_hal_command_buffer_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_hal_metal_command_buffer_vtable);
+  return (iree_hal_metal_command_buffer_t*)base_value;
+}
+
+iree_status_t iree_hal_metal_command_buffer_create(
+    iree_hal_device_t* base_device, id<MTLDevice> device,
+    id<MTLCommandBuffer> handle, iree_host_size_t argument_buffer_block_size,
+    iree_hal_metal_builtins_t* builtins, iree_allocator_t host_allocator,
+    iree_hal_command_buffer_t** out_command_buffer) {
+  IREE_ASSERT_ARGUMENT(base_device);
+  IREE_ASSERT_ARGUMENT(device);
+  IREE_ASSERT_ARGUMENT(handle);
+  IREE_ASSERT_ARGUMENT(builtins);
+  IREE_ASSERT_ARGUMENT(out_command_buffer);
+  *out_command_buffer = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_metal_command_buffer_t* command_buffer = NULL;
+  iree_status_t status = iree_allocator_malloc(
+      host_allocator, sizeof(*command_buffer), (void**)&command_buffer);
+  if (iree_status_is_ok(status)) {
+    memset(command_buffer, 0, sizeof(*command_buffer));
+    iree_hal_command_buffer_initialize(
+        base_device, IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT,
+        IREE_HAL_COMMAND_CATEGORY_ANY, IREE_HAL_QUEUE_AFFINITY_ANY,
+        &iree_hal_metal_command_buffer_vtable, &command_buffer->base);
+    command_buffer->host_allocator = host_allocator;
+    command_buffer->device = [device retain];
+    command_buffer->handle = [handle retain];
+    command_buffer->builtins = builtins;
+    command_buffer->argument_blocks = [[NSMutableArray alloc] init];
+    command_buffer->argument_block_size = argument_buffer_block_size;
+    *out_command_buffer = &command_buffer->base;
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_metal_command_buffer_end_encoders(
+    iree_hal_metal_command_buffer_t* command_buffer) {
+  if (command_buffer->compute_encoder) {
+    [command_buffer->compute_encoder endEncoding];
+    [command_buffer->compute_encoder release];
+    command_buffer->compute_encoder = nil;
+  }
+  if (command_buffer->blit_encoder) {
+    [command_buffer->blit_encoder endEncoding];
+    [command_buffer->blit_encoder release];
+    command_buffer->blit_encoder = nil;
+  }
+}
+
+static void iree_hal_metal_command_buffer_destroy(
+    iree_hal_command_buffer_t* base_command_buffer) {
+  iree_hal_metal_command_buffer_t* command_buffer =
+      iree_hal_metal_command_buffer_cast(base_command_buffer);
+  iree_allocator_t host_allocator = command_buffer->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Encoders must be ended before they are released.
+  iree_hal_metal_command_buffer_end_encoders(command_buffer);
+  [command_buffer->argument_blocks release];
+  [command_buffer->handle release];
+  [command_buffer->device release];
+  iree_allocator_free(host_allocator, command_buffer);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+static void* iree_hal_metal_command_buffer_dyn_cast(
+    iree_hal_command_buffer_t* command_buffer, const void* vtable) {
+  if (vtable == &iree_hal_metal_command_buffer_vtable) {
+    IREE_HAL_ASSERT_TYPE(command_buffer, vtable);
+    return command_buffer;
+  }
+  return NULL;
+}
+
+// Returns the compute encoder for the next dispatch, beginning one if needed.
+static id<MTLComputeCommandEncoder>
+iree_hal_metal_command_buffer_acquire_compute_encoder(
+    iree_hal_metal_command_buffer_t* command_buffer) {
+  if (!command_buffer->compute_encoder) {
+    iree_hal_metal_command_buffer_end_encoders(command_buffer);
+    // Dispatches are serialized; hazards between them are tracked by Metal.
+    command_buffer->compute_encoder =
+        [[command_buffer->handle computeCommandEncoder] retain];
+  }
+  return command_buffer->compute_encoder;
+}
+
+// Returns the blit encoder for the next transfer, beginning one if needed.
+static id<MTLBlitCommandEncoder>
+iree_hal_metal_command_buffer_acquire_blit_encoder(
+    iree_hal_metal_command_buffer_t* command_buffer) {
+  if (!command_buffer->blit_encoder) {
+    iree_hal_metal_command_buffer_end_encoders(command_buffer);
+    command_buffer->blit_encoder =
+        [[command_buffer->handle blitCommandEncoder] retain];
+  }
+  return command_buffer->blit_encoder;
+}
+
+static void iree_hal_metal_command_buffer_reset_state(
+    iree_hal_metal_command_buffer_t* command_buffer) {
+  memset(&command_buffer->state, 0, sizeof(command_buffer->state));
+}
+
+static iree_status_t iree_hal_metal_command_buffer_begin(
+    iree_hal_command_buffer_t* base_command_buffer) {
+  iree_hal_metal_command_buffer_t* command_buffer =
+      iree_hal_metal_command_buffer_cast(base_command_buffer);
+  iree_hal_metal_command_buffer_reset_state(command_buffer);
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_metal_command_buffer_end(
+    iree_hal_command_buffer_t* base_command_buffer) {
+  iree_hal_metal_command_buffer_t* command_buffer =
+      iree_hal_metal_command_buffer_cast(base_command_buffer);
+  // The device encodes event signals on the command buffer after this and that
+  // requires no encoder to be open.
+  iree_hal_metal_command_buffer_end_encoders(command_buffer);
+  iree_hal_metal_command_buffer_reset_state(command_buffer);
+  return iree_ok_status();
+}
+
+static void iree_hal_metal_command_buffer_begin_debug_group(
+    iree_hal_command_buffer_t* base_command_buffer, iree_string_view_t label,
+    iree_hal_label_color_t label_color,
+    const iree_hal_label_location_t* location) {
+  iree_hal_metal_command_buffer_t* command_buffer =
+      iree_hal_metal_command_buffer_cast(base_command_buffer);
+  // Groups are recorded on the command buffer as encoders may end within a
+  // group.
+  iree_hal_metal_command_buffer_end_encoders(command_buffer);
+  NSString* label_string =
+      [[NSString alloc] initWithBytes:label.data
+                               length:label.size
+                             encoding:NSUTF8StringEncoding];
+  [command_buffer->handle pushDebugGroup:label_string];
+  [label_string release];
+}
+
+static void iree_hal_metal_command_buffer_end_debug_group(
+    iree_hal_command_buffer_t* base_command_buffer) {
+  iree_hal_metal_command_buffer_t* command_buffer =
+      iree_hal_metal_command_buffer_cast(base_command_buffer);
+  iree_hal_metal_command_buffer_end_encoders(command_buffer);
+  [command_buffer->handle popDebugGroup];
+}
+
+static iree_status_t iree_hal_metal_command_buffer_execution_barrier(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_execution_stage_t source_stage_mask,
+    iree_hal_execution_stage_t target_stage_mask,
+    iree_hal_execution_barrier_flags_t flags,
+    iree_host_size_t memory_barrier_count,
+    const iree_hal_memory_barrier_t* memory_barriers,
+    iree_host_size_t buffer_barrier_count,
+    const iree_hal_buffer_barrier_t* buffer_barriers) {
+  // Encoders are serial and Metal tracks hazards on all buffers we allocate;
+  // resources made resident with useResource are tracked as well.
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_metal_command_buffer_signal_event(
+    iree_hal_command_buffer_t* base_command_buffer, iree_hal_event_t* event,
+    iree_hal_execution_stage_t source_stage_mask) {
+  // Metal executes encoders in order; events are never needed.
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_metal_command_buffer_reset_event(
+    iree_hal_command_buffer_t* base_command_buffer, iree_hal_event_t* event,
+    iree_hal_execution_stage_t source_stage_mask) {
+  // Metal executes encoders in order; events are never needed.
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_metal_command_buffer_wait_events(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_host_size_t event_count, const iree_hal_event_t** events,
+    iree_hal_execution_stage_t source_stage_mask,
+    iree_hal_execution_stage_t target_stage_mask,
+    iree_host_size_t memory_barrier_count,
+    const iree_hal_memory_barrier_t* memory_barriers,
+    iree_host_size_t buffer_barrier_count,
+    const iree_hal_buffer_barrier_t* buffer_barriers) {
+  // Metal executes encoders in order; events are never needed.
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_metal_command_buffer_discard_buffer(
+    iree_hal_command_buffer_t* base_command_buffer, iree_hal_buffer_t* buffer) {
+  // We could mark the memory as purgeable but it may be reused by later
+  // submissions.
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_metal_command_buffer_fill_buffer(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_buffer_t* target_buffer, iree_device_size_t target_offset,
+    iree_device_size_t length, const void* pattern,
+    iree_host_size_t pattern_length) {
+  iree_hal_metal_command_buffer_t* command_buffer =
+      iree_hal_metal_command_buffer_cast(base_command_buffer);
+  id<MTLBuffer> target_handle = iree_hal_metal_buffer_handle(
+      iree_hal_buffer_allocated_buffer(target_buffer));
+  iree_device_size_t absolute_offset =
+      iree_hal_buffer_byte_offset(target_buffer) + target_offset;
+
+  // Blit encoders natively fill with a single byte value.
+  uint32_t pattern_word = 0;
+  switch (pattern_length) {
+    case 1: {
+      id<MTLBlitCommandEncoder> encoder =
+          iree_hal_metal_command_buffer_acquire_blit_encoder(command_buffer);
+      [encoder fillBuffer:target_handle
+                    range:NSMakeRange(absolute_offset, length)
+                    value:*(const uint8_t*)pattern];
+      return iree_ok_status();
+    }
+    case 2:
+      pattern_word = *(const uint16_t*)pattern;
+      pattern_word *= 0x00010001u;
+      break;
+    case 4:
+      pattern_word = *(const uint32_t*)pattern;
+      break;
+    default:
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "unsupported fill pattern length %zu",
+                              pattern_length);
+  }
+  if (absolute_offset + length > UINT32_MAX) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "fill range end %" PRIu64
+                            " over the builtin limit of 4GiB",
+                            (uint64_t)(absolute_offset + length));
+  }
+
+  // The builtin addresses bytes from the start of the buffer so that there is
+  // no alignment requirement on the bound offset.
+  iree_hal_metal_fill_buffer_params_t params = {
+      .offset = (uint32_t)absolute_offset,
+      .length = (uint32_t)length,
+      .pattern = pattern_word,
+  };
+  id<MTLComputeCommandEncoder> encoder =
+      iree_hal_metal_command_buffer_acquire_compute_encoder(command_buffer);
+  [encoder setComputePipelineState:command_buffer->builtins
+                                       ->fill_buffer_pipeline];
+  [encoder setBuffer:target_handle offset:0 atIndex:0];
+  [encoder setBytes:&params length:sizeof(params) atIndex:1];
+  const uint64_t bytes_per_threadgroup =
+      IREE_HAL_METAL_FILL_BUFFER_THREADGROUP_SIZE *
+      IREE_HAL_METAL_FILL_BUFFER_BYTES_PER_THREAD;
+  [encoder
+       dispatchThreadgroups:MTLSizeMake(iree_host_align(length,
+                                                        bytes_per_threadgroup) /
+                                            bytes_per_threadgroup,
+                                        1, 1)
+      threadsPerThreadgroup:MTLSizeMake(
+                                IREE_HAL_METAL_FILL_BUFFER_THREADGROUP_SIZE, 1,
+                                1)];
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_metal_command_buffer_update_buffer(
+    iree_hal_command_buffer_t* base_command_buffer, const void* source_buffer,
+    iree_host_size_t source_offset, iree_hal_buffer_t* target_buffer,
+    iree_device_size_t target_offset, iree_device_size_t length) {
+  iree_hal_metal_command_buffer_t* command_buffer =
+      iree_hal_metal_command_buffer_cast(base_command_buffer);
+
+  // The contents are captured in a new shared buffer now and copied when the
+  // command buffer executes; |handle| retains the buffer until then.
+  id<MTLBuffer> staging_buffer = [command_buffer->device
+      newBufferWithBytes:(const uint8_t*)source_buffer + source_offset
+                  length:length
+                 options:MTLResourceStorageModeShared |
+                         MTLResourceCPUCacheModeWriteCombined];
+  if (!staging_buffer) {
+    return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                            "failed to create a %" PRIu64
+                            "B update staging buffer",
+                            (uint64_t)length);
+  }
+  id<MTLBlitCommandEncoder> encoder =
+      iree_hal_metal_command_buffer_acquire_blit_encoder(command_buffer);
+  [encoder copyFromBuffer:staging_buffer
+             sourceOffset:0
+                 toBuffer:iree_hal_metal_buffer_handle(
+                              iree_hal_buffer_allocated_buffer(target_buffer))
+        destinationOffset:iree_hal_buffer_byte_offset(target_buffer) +
+                          target_offset
+                     size:length];
+  [staging_buffer release];
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_metal_command_buffer_copy_buffer(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_buffer_t* source_buffer, iree_device_size_t source_offset,
+    iree_hal_buffer_t* target_buffer, iree_device_size_t target_offset,
+    iree_device_size_t length) {
+  iree_hal_metal_command_buffer_t* command_buffer =
+      iree_hal_metal_command_buffer_cast(base_command_buffer);
+  id<MTLBlitCommandEncoder> encoder =
+      iree_hal_metal_command_buffer_acquire_blit_encoder(command_buffer);
+  [encoder copyFromBuffer:iree_hal_metal_buffer_handle(
+                              iree_hal_buffer_allocated_buffer(source_buffer))
+             sourceOffset:iree_hal_buffer_byte_offset(source_buffer) +
+                          source_offset
+                 toBuffer:iree_hal_metal_buffer_handle(
+                              iree_hal_buffer_allocated_buffer(target_buffer))
+        destinationOffset:iree_hal_buffer_byte_offset(target_buffer) +
+                          target_offset
+                     size:length];
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_metal_command_buffer_push_constants(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_executable_layout_t* executable_layout, iree_host_size_t offset,
+    const void* values, iree_host_size_t values_length) {
+  iree_hal_metal_command_buffer_t* command_buffer =
+      iree_hal_metal_command_buffer_cast(base_command_buffer);
+  if (IREE_UNLIKELY(offset + values_length >
+                    sizeof(command_buffer->state.push_constants))) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "push constant range %zu (length=%zu) out of range",
+                            offset, values_length);
+  }
+  memcpy((uint8_t*)&command_buffer->state.push_constants + offset, values,
+         values_length);
+  return iree_ok_status();
+}
+
+// Sub-allocates |length| bytes aligned to |alignment| for an argument buffer.
+static iree_status_t iree_hal_metal_command_buffer_allocate_arguments(
+    iree_hal_metal_command_buffer_t* command_buffer, iree_host_size_t length,
+    iree_host_size_t alignment, id<MTLBuffer>* out_buffer,
+    iree_host_size_t* out_offset) {
+  id<MTLBuffer> block = command_buffer->argument_blocks.lastObject;
+  iree_host_size_t offset =
+      iree_host_align(command_buffer->argument_block_offset, alignment);
+  if (!block || offset + length > block.length) {
+    iree_host_size_t block_size =
+        iree_max(command_buffer->argument_block_size, length);
+    block = [command_buffer->device
+        newBufferWithLength:block_size
+                    options:MTLResourceStorageModeShared |
+                            MTLResourceCPUCacheModeWriteCombined];
+    if (!block) {
+      return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                              "failed to create a %zuB argument buffer block",
+                              block_size);
+    }
+    [command_buffer->argument_blocks addObject:block];
+    [block release];
+    offset = 0;
+  }
+  command_buffer->argument_block_offset = offset + length;
+  *out_buffer = block;
+  *out_offset = offset;
+  return iree_ok_status();
+}
+
+// Encodes |bindings| with |set_layout| into a new argument buffer for |set|.
+static iree_status_t iree_hal_metal_command_buffer_encode_set(
+    iree_hal_metal_command_buffer_t* command_buffer, uint32_t set,
+    iree_hal_descriptor_set_layout_t* set_layout,
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_binding_t* bindings) {
+  if (set >= IREE_HAL_METAL_MAX_DESCRIPTOR_SET_COUNT) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "descriptor set %u over the limit of %d", set,
+                            IREE_HAL_METAL_MAX_DESCRIPTOR_SET_COUNT);
+  }
+  if (binding_count > IREE_HAL_METAL_MAX_DESCRIPTOR_SET_BINDING_COUNT) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "binding count %zu over the limit of %d",
+                            binding_count,
+                            IREE_HAL_METAL_MAX_DESCRIPTOR_SET_BINDING_COUNT);
+  }
+
+  iree_hal_metal_descriptor_set_state_t* state =
+      &command_buffer->state.sets[set];
+  id<MTLBuffer> argument_buffer = nil;
+  iree_host_size_t argument_offset = 0;
+  IREE_RETURN_IF_ERROR(iree_hal_metal_command_buffer_allocate_arguments(
+      command_buffer,
+      iree_max(iree_hal_metal_descriptor_set_layout_encoded_length(set_layout),
+               1),
+      iree_hal_metal_descriptor_set_layout_alignment(set_layout),
+      &argument_buffer, &argument_offset));
+  IREE_RETURN_IF_ERROR(iree_hal_metal_descriptor_set_layout_encode(
+      set_layout, binding_count, bindings, argument_buffer, argument_offset));
+
+  state->argument_buffer = argument_buffer;
+  state->argument_offset = argument_offset;
+  state->resource_count = 0;
+  for (iree_host_size_t i = 0; i < binding_count; ++i) {
+    if (!bindings[i].buffer) continue;
+    state->resources[state->resource_count++] = iree_hal_metal_buffer_handle(
+        iree_hal_buffer_allocated_buffer(bindings[i].buffer));
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_metal_command_buffer_push_descriptor_set(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_executable_layout_t* executable_layout, uint32_t set,
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_binding_t* bindings) {
+  iree_hal_metal_command_buffer_t* command_buffer =
+      iree_hal_metal_command_buffer_cast(base_command_buffer);
+  iree_hal_descriptor_set_layout_t* set_layout =
+      iree_hal_metal_executable_layout_set_layout(executable_layout, set);
+  if (!set_layout) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "descriptor set %u not in the executable layout",
+                            set);
+  }
+  return iree_hal_metal_command_buffer_encode_set(
+      command_buffer, set, set_layout, binding_count, bindings);
+}
+
+static iree_status_t iree_hal_metal_command_buffer_bind_descriptor_set(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_executable_layout_t* executable_layout, uint32_t set,
+    iree_hal_descriptor_set_t* descriptor_set,
+    iree_host_size_t dynamic_offset_count,
+    const iree_device_size_t* dynamic_offsets) {
+  iree_hal_metal_command_buffer_t* command_buffer =
+      iree_hal_metal_command_buffer_cast(base_command_buffer);
+  if (dynamic_offset_count > 0) {
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "dynamic descriptor offsets are not supported");
+  }
+  iree_host_size_t binding_count = 0;
+  const iree_hal_descriptor_set_binding_t* bindings =
+      iree_hal_metal_descriptor_set_bindings(descriptor_set, &binding_count);
+  return iree_hal_metal_command_buffer_encode_set(
+      command_buffer, set, iree_hal_metal_descriptor_set_layout(descriptor_set),
+      binding_count, bindings);
+}
+
+// Begins a dispatch of |entry_point| by setting its pipeline, the argument
+// buffers of its descriptor sets, and its push constants.
+static iree_status_t iree_hal_metal_command_buffer_prepare_dispatch(
+    iree_hal_metal_command_buffer_t* command_buffer,
+    iree_hal_executable_t* executable, int32_t entry_point,
+    id<MTLComputeCommandEncoder>* out_encoder, MTLSize* out_threadgroup_size) {
+  const iree_hal_metal_entry_point_t* entry =
+      iree_hal_metal_executable_lookup_entry_point(executable,
+                                                   (uint32_t)entry_point);
+  if (!entry) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "entry point %d not found in the executable",
+                            entry_point);
+  }
+  iree_host_size_t set_count =
+      iree_hal_metal_executable_layout_set_layout_count(entry->layout);
+  iree_host_size_t push_constant_count =
+      iree_hal_metal_executable_layout_push_constant_count(entry->layout);
+  for (iree_host_size_t i = 0; i < set_count; ++i) {
+    if (!command_buffer->state.sets[i].argument_buffer) {
+      return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                              "descriptor set %zu not bound before dispatch",
+                              i);
+    }
+  }
+
+  id<MTLComputeCommandEncoder> encoder =
+      iree_hal_metal_command_buffer_acquire_compute_encoder(command_buffer);
+  [encoder setComputePipelineState:entry->pipeline];
+  for (iree_host_size_t i = 0; i < set_count; ++i) {
+    iree_hal_metal_descriptor_set_state_t* state =
+        &command_buffer->state.sets[i];
+    [encoder setBuffer:state->argument_buffer
+                offset:state->argument_offset
+               atIndex:i];
+    [encoder useResources:state->resources
+                    count:state->resource_count
+                    usage:MTLResourceUsageRead | MTLResourceUsageWrite];
+  }
+  if (push_constant_count > 0) {
+    [encoder setBytes:command_buffer->state.push_constants
+               length:push_constant_count * sizeof(uint32_t)
+              atIndex:IREE_HAL_METAL_PUSH_CONSTANT_BUFFER_INDEX];
+  }
+
+  *out_encoder = encoder;
+  *out_threadgroup_size = entry->threadgroup_size;
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_metal_command_buffer_dispatch(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_executable_t* executable, int32_t entry_point,
+    uint32_t workgroup_x, uint32_t workgroup_y, uint32_t workgroup_z) {
+  iree_hal_metal_command_buffer_t* command_buffer =
+      iree_hal_metal_command_buffer_cast(base_command_buffer);
+  id<MTLComputeCommandEncoder> encoder = nil;
+  MTLSize threadgroup_size;
+  IREE_RETURN_IF_ERROR(iree_hal_metal_command_buffer_prepare_dispatch(
+      command_buffer, executable, entry_point, &encoder, &threadgroup_size));
+  [encoder
+       dispatchThreadgroups:MTLSizeMake(workgroup_x, workgroup_y, workgroup_z)
+      threadsPerThreadgroup:threadgroup_size];
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_metal_command_buffer_dispatch_indirect(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_executable_t* executable, int32_t entry_point,
+    iree_hal_buffer_t* workgroups_buffer,
+    iree_device_size_t workgroups_offset) {
+  iree_hal_metal_command_buffer_t* command_buffer =
+      iree_hal_metal_command_buffer_cast(base_command_buffer);
+  id<MTLComputeCommandEncoder> encoder = nil;
+  MTLSize threadgroup_size;
+  IREE_RETURN_IF_ERROR(iree_hal_metal_command_buffer_prepare_dispatch(
+      command_buffer, executable, entry_point, &encoder, &threadgroup_size));
+  [encoder dispatchThreadgroupsWithIndirectBuffer:
+               iree_hal_metal_buffer_handle(
+                   iree_hal_buffer_allocated_buffer(workgroups_buffer))
+                             indirectBufferOffset:
+                                 iree_hal_buffer_byte_offset(
+                                     workgroups_buffer) +
+                                 workgroups_offset
+                            threadsPerThreadgroup:threadgroup_size];
+  return iree_ok_status();
+}
+
+static const iree_hal_command_buffer_vtable_t
+    iree_hal_metal_command_buffer_vtable = {
+        .destroy = iree_hal_metal_command_buffer_destroy,
+        .dyn_cast = iree_hal_metal_command_buffer_dyn_cast,
+        .begin = iree_hal_metal_command_buffer_begin,
+        .end = iree_hal_metal_command_buffer_end,
+        .begin_debug_group = iree_hal_metal_command_buffer_begin_debug_group,
+        .end_debug_group = iree_hal_metal_command_buffer_end_debug_group,
+        .execution_barrier = iree_hal_metal_command_buffer_execution_barrier,
+        .signal_event = iree_hal_metal_command_buffer_signal_event,
+        .reset_event = iree_hal_metal_command_buffer_reset_event,
+        .wait_events = iree_hal_metal_command_buffer_wait_events,
+        .discard_buffer = iree_hal_metal_command_buffer_discard_buffer,
+        .fill_buffer = iree_hal_metal_command_buffer_fill_buffer,
+        .update_buffer = iree_hal_metal_command_buffer_update_buffer,
+        .copy_buffer = iree_hal_metal_command_buffer_copy_buffer,
+        .push_constants = iree_hal_metal_command_buffer_push_constants,
+        .push_descriptor_set =
+            iree_hal_metal_command_buffer_push_descriptor_set,
+        .bind_descriptor_set =
+            iree_hal_metal_command_buffer_bind_descriptor_set,
+        .dispatch = iree_hal_metal_command_buffer_dispatch,
+        .dispatch_indirect = iree_hal_metal_command_buffer_dispatch_indirect,
+};
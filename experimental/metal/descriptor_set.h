@@ -0,0 +1,40 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_METAL_DESCRIPTOR_SET_H_
+#define IREE_HAL_METAL_DESCRIPTOR_SET_H_
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Creates a descriptor set retaining |bindings|.
+// The bindings are encoded into an argument buffer when the set is bound so
+// that persistent and pushed descriptor sets share the same encoding path.
+iree_status_t iree_hal_metal_descriptor_set_create(
+    iree_hal_descriptor_set_layout_t* set_layout,
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_binding_t* bindings,
+    iree_allocator_t host_allocator,
+    iree_hal_descriptor_set_t** out_descriptor_set);
+
+// Returns the layout the descriptor set was created with.
+iree_hal_descriptor_set_layout_t* iree_hal_metal_descriptor_set_layout(
+    iree_hal_descriptor_set_t* descriptor_set);
+
+// Returns the bindings of the descriptor set.
+const iree_hal_descriptor_set_binding_t* iree_hal_metal_descriptor_set_bindings(
+    iree_hal_descriptor_set_t* descriptor_set,
+    iree_host_size_t* out_binding_count);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_METAL_DESCRIPTOR_SET_H_
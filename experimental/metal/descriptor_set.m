@@ -0,0 +1,103 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "experimental/metal/descriptor_set.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "iree/base/api.h"
+#include "iree/base/tracing.h"
+
+typedef struct iree_hal_metal_descriptor_set_t {
+  iree_hal_resource_t resource;
+  iree_allocator_t host_allocator;
+  iree_hal_descriptor_set_layout_t* set_layout;
+  iree_host_size_t binding_count;
+  iree_hal_descriptor_set_binding_t bindings[];
+} iree_hal_metal_descriptor_set_t;
+
+static const iree_hal_descriptor_set_vtable_t
+    iree_hal_metal_descriptor_set_vtable;
+
+static iree_hal_metal_descriptor_set_t* iree_hal_metal_descriptor_set_cast(
+    iree_hal_descriptor_set_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_hal_metal_descriptor_set_vtable);
+  return (iree_hal_metal_descriptor_set_t*)base_value;
+}
+
+iree_status_t iree_hal_metal_descriptor_set_create(
+    iree_hal_descriptor_set_layout_t* set_layout,
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_binding_t* bindings,
+    iree_allocator_t host_allocator,
+    iree_hal_descriptor_set_t** out_descriptor_set) {
+  IREE_ASSERT_ARGUMENT(set_layout);
+  IREE_ASSERT_ARGUMENT(!binding_count || bindings);
+  IREE_ASSERT_ARGUMENT(out_descriptor_set);
+  *out_descriptor_set = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_metal_descriptor_set_t* descriptor_set = NULL;
+  iree_host_size_t total_size =
+      sizeof(*descriptor_set) +
+      binding_count * sizeof(*descriptor_set->bindings);
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, total_size,
+                                (void**)&descriptor_set));
+  iree_hal_resource_initialize(&iree_hal_metal_descriptor_set_vtable,
+                               &descriptor_set->resource);
+  descriptor_set->host_allocator = host_allocator;
+  descriptor_set->set_layout = set_layout;
+  iree_hal_descriptor_set_layout_retain(set_layout);
+  descriptor_set->binding_count = binding_count;
+  memcpy(descriptor_set->bindings, bindings,
+         binding_count * sizeof(*descriptor_set->bindings));
+  for (iree_host_size_t i = 0; i < binding_count; ++i) {
+    iree_hal_buffer_retain(descriptor_set->bindings[i].buffer);
+  }
+  *out_descriptor_set = (iree_hal_descriptor_set_t*)descriptor_set;
+
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+static void iree_hal_metal_descriptor_set_destroy(
+    iree_hal_descriptor_set_t* base_descriptor_set) {
+  iree_hal_metal_descriptor_set_t* descriptor_set =
+      iree_hal_metal_descriptor_set_cast(base_descriptor_set);
+  iree_allocator_t host_allocator = descriptor_set->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  for (iree_host_size_t i = 0; i < descriptor_set->binding_count; ++i) {
+    iree_hal_buffer_release(descriptor_set->bindings[i].buffer);
+  }
+  iree_hal_descriptor_set_layout_release(descriptor_set->set_layout);
+  iree_allocator_free(host_allocator, descriptor_set);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+iree_hal_descriptor_set_layout_t* iree_hal_metal_descriptor_set_layout(
+    iree_hal_descriptor_set_t* base_descriptor_set) {
+  iree_hal_metal_descriptor_set_t* descriptor_set =
+      iree_hal_metal_descriptor_set_cast(base_descriptor_set);
+  return descriptor_set->set_layout;
+}
+
+const iree_hal_descriptor_set_binding_t* iree_hal_metal_descriptor_set_bindings(
+    iree_hal_descriptor_set_t* base_descriptor_set,
+    iree_host_size_t* out_binding_count) {
+  iree_hal_metal_descriptor_set_t* descriptor_set =
+      iree_hal_metal_descriptor_set_cast(base_descriptor_set);
+  *out_binding_count = descriptor_set->binding_count;
+  return descriptor_set->bindings;
+}
+
+static const iree_hal_descriptor_set_vtable_t
+    iree_hal_metal_descriptor_set_vtable = {
+        .destroy = iree_hal_metal_descriptor_set_destroy,
+};
@@ -0,0 +1,54 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_METAL_DESCRIPTOR_SET_LAYOUT_H_
+#define IREE_HAL_METAL_DESCRIPTOR_SET_LAYOUT_H_
+
+#import <Metal/Metal.h>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Creates a descriptor set layout backed by an MTLArgumentEncoder.
+//
+// Descriptor sets are encoded as argument buffers with each binding stored as
+// a device pointer at [[id(binding)]], matching the argument buffers produced
+// by SPIRV-Cross from the executable SPIR-V.
+iree_status_t iree_hal_metal_descriptor_set_layout_create(
+    id<MTLDevice> device,
+    iree_hal_descriptor_set_layout_usage_type_t usage_type,
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_layout_binding_t* bindings,
+    iree_allocator_t host_allocator,
+    iree_hal_descriptor_set_layout_t** out_descriptor_set_layout);
+
+// Returns the size, in bytes, of an argument buffer encoded with the layout.
+iree_host_size_t iree_hal_metal_descriptor_set_layout_encoded_length(
+    iree_hal_descriptor_set_layout_t* descriptor_set_layout);
+
+// Returns the required alignment, in bytes, of argument buffers encoded with
+// the layout.
+iree_host_size_t iree_hal_metal_descriptor_set_layout_alignment(
+    iree_hal_descriptor_set_layout_t* descriptor_set_layout);
+
+// Encodes |bindings| into |argument_buffer| at |argument_offset|.
+// Bindings with a NULL buffer are left unset. The argument encoder is shared by
+// all uses of the layout and encoding is serialized internally.
+iree_status_t iree_hal_metal_descriptor_set_layout_encode(
+    iree_hal_descriptor_set_layout_t* descriptor_set_layout,
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_binding_t* bindings,
+    id<MTLBuffer> argument_buffer, iree_host_size_t argument_offset);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_METAL_DESCRIPTOR_SET_LAYOUT_H_
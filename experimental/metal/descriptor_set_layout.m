@@ -0,0 +1,200 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "experimental/metal/descriptor_set_layout.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "experimental/metal/api.h"
+#include "experimental/metal/metal_buffer.h"
+#include "iree/base/api.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/tracing.h"
+
+typedef struct iree_hal_metal_descriptor_set_layout_t {
+  iree_hal_resource_t resource;
+  iree_allocator_t host_allocator;
+
+  // Argument encoders hold the target buffer as state and are not thread-safe.
+  iree_slim_mutex_t encoder_mutex;
+  id<MTLArgumentEncoder> encoder IREE_GUARDED_BY(encoder_mutex);
+
+  iree_host_size_t encoded_length;
+  iree_host_size_t alignment;
+  iree_host_size_t binding_count;
+  iree_hal_descriptor_set_layout_binding_t bindings[];
+} iree_hal_metal_descriptor_set_layout_t;
+
+static const iree_hal_descriptor_set_layout_vtable_t
+    iree_hal_metal_descriptor_set_layout_vtable;
+
+static iree_hal_metal_descriptor_set_layout_t*
+iree_hal_metal_descriptor_set_layout_cast(
+    iree_hal_descriptor_set_layout_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value,
+                       &iree_hal_metal_descriptor_set_layout_vtable);
+  return (iree_hal_metal_descriptor_set_layout_t*)base_value;
+}
+
+static iree_status_t iree_hal_metal_verify_descriptor_set_layout_binding(
+    const iree_hal_descriptor_set_layout_binding_t* binding) {
+  if (binding->binding >= IREE_HAL_METAL_MAX_DESCRIPTOR_SET_BINDING_COUNT) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "binding %u over the limit of %d",
+                            binding->binding,
+                            IREE_HAL_METAL_MAX_DESCRIPTOR_SET_BINDING_COUNT);
+  }
+  switch (binding->type) {
+    case IREE_HAL_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+    case IREE_HAL_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+      return iree_ok_status();
+    default:
+      return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                              "unsupported descriptor type %d",
+                              (int)binding->type);
+  }
+}
+
+iree_status_t iree_hal_metal_descriptor_set_layout_create(
+    id<MTLDevice> device,
+    iree_hal_descriptor_set_layout_usage_type_t usage_type,
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_layout_binding_t* bindings,
+    iree_allocator_t host_allocator,
+    iree_hal_descriptor_set_layout_t** out_descriptor_set_layout) {
+  IREE_ASSERT_ARGUMENT(device);
+  IREE_ASSERT_ARGUMENT(!binding_count || bindings);
+  IREE_ASSERT_ARGUMENT(out_descriptor_set_layout);
+  *out_descriptor_set_layout = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  for (iree_host_size_t i = 0; i < binding_count; ++i) {
+    IREE_RETURN_AND_END_ZONE_IF_ERROR(
+        z0, iree_hal_metal_verify_descriptor_set_layout_binding(&bindings[i]));
+  }
+
+  // Each binding is a device pointer in the argument buffer; executables may
+  // both read and write storage buffers.
+  NSMutableArray<MTLArgumentDescriptor*>* arguments =
+      [[NSMutableArray alloc] initWithCapacity:binding_count];
+  for (iree_host_size_t i = 0; i < binding_count; ++i) {
+    MTLArgumentDescriptor* argument =
+        [MTLArgumentDescriptor argumentDescriptor];
+    argument.dataType = MTLDataTypePointer;
+    argument.index = bindings[i].binding;
+    argument.access =
+        bindings[i].type == IREE_HAL_DESCRIPTOR_TYPE_UNIFORM_BUFFER
+            ? MTLArgumentAccessReadOnly
+            : MTLArgumentAccessReadWrite;
+    [arguments addObject:argument];
+  }
+  id<MTLArgumentEncoder> encoder = nil;
+  if (binding_count > 0) {
+    encoder = [device newArgumentEncoderWithArguments:arguments];
+  }
+  [arguments release];
+  if (binding_count > 0 && !encoder) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(IREE_STATUS_INTERNAL,
+                            "failed to create an argument encoder");
+  }
+
+  iree_hal_metal_descriptor_set_layout_t* descriptor_set_layout = NULL;
+  iree_host_size_t total_size =
+      sizeof(*descriptor_set_layout) +
+      binding_count * sizeof(*descriptor_set_layout->bindings);
+  iree_status_t status = iree_allocator_malloc(
+      host_allocator, total_size, (void**)&descriptor_set_layout);
+  if (iree_status_is_ok(status)) {
+    iree_hal_resource_initialize(&iree_hal_metal_descriptor_set_layout_vtable,
+                                 &descriptor_set_layout->resource);
+    descriptor_set_layout->host_allocator = host_allocator;
+    iree_slim_mutex_initialize(&descriptor_set_layout->encoder_mutex);
+    descriptor_set_layout->encoder = encoder;
+    descriptor_set_layout->encoded_length = encoder ? encoder.encodedLength : 0;
+    descriptor_set_layout->alignment = encoder ? encoder.alignment : 1;
+    descriptor_set_layout->binding_count = binding_count;
+    memcpy(descriptor_set_layout->bindings, bindings,
+           binding_count * sizeof(*descriptor_set_layout->bindings));
+    *out_descriptor_set_layout =
+        (iree_hal_descriptor_set_layout_t*)descriptor_set_layout;
+  } else {
+    [encoder release];
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_metal_descriptor_set_layout_destroy(
+    iree_hal_descriptor_set_layout_t* base_descriptor_set_layout) {
+  iree_hal_metal_descriptor_set_layout_t* descriptor_set_layout =
+      iree_hal_metal_descriptor_set_layout_cast(base_descriptor_set_layout);
+  iree_allocator_t host_allocator = descriptor_set_layout->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  [descriptor_set_layout->encoder release];
+  iree_slim_mutex_deinitialize(&descriptor_set_layout->encoder_mutex);
+  iree_allocator_free(host_allocator, descriptor_set_layout);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+iree_host_size_t iree_hal_metal_descriptor_set_layout_encoded_length(
+    iree_hal_descriptor_set_layout_t* base_descriptor_set_layout) {
+  iree_hal_metal_descriptor_set_layout_t* descriptor_set_layout =
+      iree_hal_metal_descriptor_set_layout_cast(base_descriptor_set_layout);
+  return descriptor_set_layout->encoded_length;
+}
+
+iree_host_size_t iree_hal_metal_descriptor_set_layout_alignment(
+    iree_hal_descriptor_set_layout_t* base_descriptor_set_layout) {
+  iree_hal_metal_descriptor_set_layout_t* descriptor_set_layout =
+      iree_hal_metal_descriptor_set_layout_cast(base_descriptor_set_layout);
+  return descriptor_set_layout->alignment;
+}
+
+iree_status_t iree_hal_metal_descriptor_set_layout_encode(
+    iree_hal_descriptor_set_layout_t* base_descriptor_set_layout,
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_binding_t* bindings,
+    id<MTLBuffer> argument_buffer, iree_host_size_t argument_offset) {
+  iree_hal_metal_descriptor_set_layout_t* descriptor_set_layout =
+      iree_hal_metal_descriptor_set_layout_cast(base_descriptor_set_layout);
+  if (!descriptor_set_layout->encoder) return iree_ok_status();
+
+  // Verify all bindings before touching the argument buffer so that failures
+  // leave it unmodified.
+  for (iree_host_size_t i = 0; i < binding_count; ++i) {
+    if (bindings[i].binding >=
+        IREE_HAL_METAL_MAX_DESCRIPTOR_SET_BINDING_COUNT) {
+      return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                              "binding %u over the limit of %d",
+                              bindings[i].binding,
+                              IREE_HAL_METAL_MAX_DESCRIPTOR_SET_BINDING_COUNT);
+    }
+  }
+
+  iree_slim_mutex_lock(&descriptor_set_layout->encoder_mutex);
+  id<MTLArgumentEncoder> encoder = descriptor_set_layout->encoder;
+  [encoder setArgumentBuffer:argument_buffer offset:argument_offset];
+  for (iree_host_size_t i = 0; i < binding_count; ++i) {
+    if (!bindings[i].buffer) continue;
+    iree_hal_buffer_t* buffer = bindings[i].buffer;
+    [encoder setBuffer:iree_hal_metal_buffer_handle(
+                           iree_hal_buffer_allocated_buffer(buffer))
+                offset:iree_hal_buffer_byte_offset(buffer) + bindings[i].offset
+               atIndex:bindings[i].binding];
+  }
+  [encoder setArgumentBuffer:nil offset:0];
+  iree_slim_mutex_unlock(&descriptor_set_layout->encoder_mutex);
+  return iree_ok_status();
+}
+
+static const iree_hal_descriptor_set_layout_vtable_t
+    iree_hal_metal_descriptor_set_layout_vtable = {
+        .destroy = iree_hal_metal_descriptor_set_layout_destroy,
+};
@@ -0,0 +1,42 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_METAL_EXECUTABLE_H_
+#define IREE_HAL_METAL_EXECUTABLE_H_
+
+#import <Metal/Metal.h>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+typedef struct iree_hal_metal_entry_point_t {
+  id<MTLComputePipelineState> pipeline;
+  iree_hal_executable_layout_t* layout;
+  // Threadgroup size baked into the shader by the compiler; Metal takes it at
+  // dispatch time.
+  MTLSize threadgroup_size;
+} iree_hal_metal_entry_point_t;
+
+// Creates an executable from a MetalExecutableDef flatbuffer with one compute
+// pipeline state per entry point.
+iree_status_t iree_hal_metal_executable_create(
+    id<MTLDevice> device, const iree_hal_executable_spec_t* executable_spec,
+    iree_allocator_t host_allocator, iree_hal_executable_t** out_executable);
+
+// Returns the pipeline and layout of |entry_ordinal| or NULL if out of range.
+const iree_hal_metal_entry_point_t*
+iree_hal_metal_executable_lookup_entry_point(
+    iree_hal_executable_t* executable, uint32_t entry_ordinal);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_METAL_EXECUTABLE_H_
@@ -0,0 +1,332 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "experimental/metal/executable.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "iree/base/api.h"
+#include "iree/base/tracing.h"
+
+// flatcc schemas:
+#include "iree/base/internal/flatcc/parsing.h"
+#include "iree/schemas/metal_executable_def_reader.h"
+#include "iree/schemas/metal_executable_def_verifier.h"
+
+typedef struct iree_hal_metal_executable_t {
+  iree_hal_resource_t resource;
+  iree_allocator_t host_allocator;
+  iree_host_size_t entry_point_count;
+  iree_hal_metal_entry_point_t entry_points[];
+} iree_hal_metal_executable_t;
+
+static const iree_hal_executable_vtable_t iree_hal_metal_executable_vtable;
+
+static iree_hal_metal_executable_t* iree_hal_metal_executable_cast(
+    iree_hal_executable_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_hal_metal_executable_vtable);
+  return (iree_hal_metal_executable_t*)base_value;
+}
+
+// Verifies the structure of the flatbuffer so that we can avoid doing so during
+// runtime. There are still some conditions we must be aware of (such as omitted
+// names on functions with internal linkage), however we shouldn't need to
+// bounds check anything within the flatbuffer after this succeeds.
+static iree_status_t iree_hal_metal_executable_flatbuffer_verify(
+    iree_const_byte_span_t flatbuffer_data,
+    iree_host_size_t expected_entry_point_count) {
+  if (!flatbuffer_data.data || flatbuffer_data.data_length < 16) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "flatbuffer data is not present or less than 16 bytes (%zu total)",
+        flatbuffer_data.data_length);
+  }
+
+  // Run flatcc generated verification. This ensures all pointers are in-bounds
+  // and that we can safely walk the file, but not that the actual contents of
+  // the flatbuffer meet our expectations.
+  int verify_ret = iree_MetalExecutableDef_verify_as_root(
+      flatbuffer_data.data, flatbuffer_data.data_length);
+  if (verify_ret != flatcc_verify_ok) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "flatbuffer verification failed: %s",
+                            flatcc_verify_error_string(verify_ret));
+  }
+
+  iree_MetalExecutableDef_table_t executable_def =
+      iree_MetalExecutableDef_as_root(flatbuffer_data.data);
+
+  flatbuffers_string_vec_t entry_points_vec =
+      iree_MetalExecutableDef_entry_points_get(executable_def);
+  size_t entry_point_count = flatbuffers_string_vec_len(entry_points_vec);
+  if (entry_point_count != expected_entry_point_count) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "executable provides %zu entry points but caller "
+                            "provided %zu; must match",
+                            entry_point_count, expected_entry_point_count);
+  }
+  for (size_t i = 0; i < entry_point_count; ++i) {
+    if (!flatbuffers_string_len(
+            flatbuffers_string_vec_at(entry_points_vec, i))) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "executable entry point %zu has no name", i);
+    }
+  }
+
+  iree_MetalThreadgroupSize_vec_t threadgroup_sizes_vec =
+      iree_MetalExecutableDef_threadgroup_sizes_get(executable_def);
+  size_t threadgroup_size_count =
+      iree_MetalThreadgroupSize_vec_len(threadgroup_sizes_vec);
+  if (threadgroup_size_count != entry_point_count) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "executable has %zu entry points but %zu "
+                            "threadgroup sizes",
+                            entry_point_count, threadgroup_size_count);
+  }
+
+  // Either a precompiled library or one source per entry point is required.
+  flatbuffers_uint8_vec_t shader_library_vec =
+      iree_MetalExecutableDef_shader_library_get(executable_def);
+  flatbuffers_string_vec_t shader_sources_vec =
+      iree_MetalExecutableDef_shader_sources_get(executable_def);
+  size_t shader_source_count = flatbuffers_string_vec_len(shader_sources_vec);
+  if (!flatbuffers_uint8_vec_len(shader_library_vec)) {
+    if (shader_source_count != entry_point_count) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "executable has %zu entry points but %zu shader "
+                              "sources and no shader library",
+                              entry_point_count, shader_source_count);
+    }
+    for (size_t i = 0; i < shader_source_count; ++i) {
+      if (!flatbuffers_string_len(
+              flatbuffers_string_vec_at(shader_sources_vec, i))) {
+        return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                                "executable shader source %zu is empty", i);
+      }
+    }
+  }
+
+  return iree_ok_status();
+}
+
+// Returns an iree_status_t containing the description of |error|.
+static iree_status_t iree_hal_metal_status_from_error(iree_status_code_t code,
+                                                      const char* message,
+                                                      NSError* error) {
+  const char* description =
+      error ? error.localizedDescription.UTF8String : "unknown error";
+  return iree_make_status(code, "%s: %s", message, description);
+}
+
+// Creates a library from a serialized metallib in |library_data|.
+static iree_status_t iree_hal_metal_create_library_from_data(
+    id<MTLDevice> device, flatbuffers_uint8_vec_t library_data,
+    id<MTLLibrary>* out_library) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // The flatbuffer outlives the library creation so the data is referenced
+  // in place with an empty destructor instead of being copied.
+  dispatch_data_t data = dispatch_data_create(
+      library_data, flatbuffers_uint8_vec_len(library_data),
+      /*queue=*/NULL, ^{
+      });
+  NSError* error = nil;
+  *out_library = [device newLibraryWithData:data error:&error];
+  dispatch_release(data);
+
+  iree_status_t status = iree_ok_status();
+  if (!*out_library) {
+    status = iree_hal_metal_status_from_error(
+        IREE_STATUS_INVALID_ARGUMENT, "failed to load the shader library",
+        error);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Compiles a library from the MSL code in |source|.
+static iree_status_t iree_hal_metal_create_library_from_source(
+    id<MTLDevice> device, flatbuffers_string_t source,
+    id<MTLLibrary>* out_library) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  NSString* source_string =
+      [[NSString alloc] initWithUTF8String:(const char*)source];
+  MTLCompileOptions* options = [[MTLCompileOptions alloc] init];
+  options.fastMathEnabled = NO;
+  NSError* error = nil;
+  *out_library = [device newLibraryWithSource:source_string
+                                      options:options
+                                        error:&error];
+  [options release];
+  [source_string release];
+
+  iree_status_t status = iree_ok_status();
+  if (!*out_library) {
+    status = iree_hal_metal_status_from_error(
+        IREE_STATUS_INVALID_ARGUMENT, "failed to compile the shader source",
+        error);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static iree_status_t iree_hal_metal_create_pipeline(
+    id<MTLDevice> device, id<MTLLibrary> library,
+    flatbuffers_string_t entry_point_name,
+    id<MTLComputePipelineState>* out_pipeline) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  NSString* function_name =
+      [[NSString alloc] initWithUTF8String:(const char*)entry_point_name];
+  id<MTLFunction> function = [library newFunctionWithName:function_name];
+  [function_name release];
+  if (!function) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(IREE_STATUS_NOT_FOUND,
+                            "entry point '%s' not found in the shader library",
+                            (const char*)entry_point_name);
+  }
+
+  NSError* error = nil;
+  *out_pipeline = [device newComputePipelineStateWithFunction:function
+                                                        error:&error];
+  [function release];
+
+  iree_status_t status = iree_ok_status();
+  if (!*out_pipeline) {
+    status = iree_hal_metal_status_from_error(
+        IREE_STATUS_INTERNAL, "failed to create a compute pipeline state",
+        error);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+iree_status_t iree_hal_metal_executable_create(
+    id<MTLDevice> device, const iree_hal_executable_spec_t* executable_spec,
+    iree_allocator_t host_allocator, iree_hal_executable_t** out_executable) {
+  IREE_ASSERT_ARGUMENT(device);
+  IREE_ASSERT_ARGUMENT(executable_spec);
+  IREE_ASSERT_ARGUMENT(out_executable);
+  *out_executable = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_metal_executable_flatbuffer_verify(
+              executable_spec->executable_data,
+              executable_spec->executable_layout_count));
+
+  iree_MetalExecutableDef_table_t executable_def =
+      iree_MetalExecutableDef_as_root(executable_spec->executable_data.data);
+  flatbuffers_string_vec_t entry_points_vec =
+      iree_MetalExecutableDef_entry_points_get(executable_def);
+  iree_MetalThreadgroupSize_vec_t threadgroup_sizes_vec =
+      iree_MetalExecutableDef_threadgroup_sizes_get(executable_def);
+  flatbuffers_uint8_vec_t shader_library_vec =
+      iree_MetalExecutableDef_shader_library_get(executable_def);
+  flatbuffers_string_vec_t shader_sources_vec =
+      iree_MetalExecutableDef_shader_sources_get(executable_def);
+  iree_host_size_t entry_point_count =
+      flatbuffers_string_vec_len(entry_points_vec);
+
+  iree_hal_metal_executable_t* executable = NULL;
+  iree_host_size_t total_size =
+      sizeof(*executable) +
+      entry_point_count * sizeof(executable->entry_points[0]);
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, total_size,
+                                (void**)&executable));
+  memset(executable, 0, total_size);
+  iree_hal_resource_initialize(&iree_hal_metal_executable_vtable,
+                               &executable->resource);
+  executable->host_allocator = host_allocator;
+  executable->entry_point_count = entry_point_count;
+
+  // A precompiled library holds all entry points; otherwise each entry point
+  // has its own source translated from SPIR-V. Libraries are only needed while
+  // creating the pipelines.
+  iree_status_t status = iree_ok_status();
+  id<MTLLibrary> shared_library = nil;
+  if (flatbuffers_uint8_vec_len(shader_library_vec)) {
+    status = iree_hal_metal_create_library_from_data(device, shader_library_vec,
+                                                     &shared_library);
+  }
+
+  for (iree_host_size_t i = 0; i < entry_point_count; ++i) {
+    if (!iree_status_is_ok(status)) break;
+    iree_hal_metal_entry_point_t* entry_point = &executable->entry_points[i];
+    entry_point->layout = executable_spec->executable_layouts[i];
+    iree_hal_executable_layout_retain(entry_point->layout);
+    const iree_MetalThreadgroupSize_t* threadgroup_size =
+        iree_MetalThreadgroupSize_vec_at(threadgroup_sizes_vec, i);
+    entry_point->threadgroup_size =
+        MTLSizeMake(threadgroup_size->x, threadgroup_size->y,
+                    threadgroup_size->z);
+
+    id<MTLLibrary> library = [shared_library retain];
+    if (!library) {
+      status = iree_hal_metal_create_library_from_source(
+          device, flatbuffers_string_vec_at(shader_sources_vec, i), &library);
+    }
+    if (iree_status_is_ok(status)) {
+      status = iree_hal_metal_create_pipeline(
+          device, library, flatbuffers_string_vec_at(entry_points_vec, i),
+          &entry_point->pipeline);
+    }
+    [library release];
+    if (iree_status_is_ok(status) &&
+        threadgroup_size->x * threadgroup_size->y * threadgroup_size->z >
+            entry_point->pipeline.maxTotalThreadsPerThreadgroup) {
+      status = iree_make_status(
+          IREE_STATUS_INVALID_ARGUMENT,
+          "entry point %zu threadgroup size %ux%ux%u exceeds the pipeline "
+          "limit of %lu threads",
+          i, threadgroup_size->x, threadgroup_size->y, threadgroup_size->z,
+          (unsigned long)entry_point->pipeline.maxTotalThreadsPerThreadgroup);
+    }
+  }
+  [shared_library release];
+
+  if (iree_status_is_ok(status)) {
+    *out_executable = (iree_hal_executable_t*)executable;
+  } else {
+    iree_hal_executable_destroy((iree_hal_executable_t*)executable);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_metal_executable_destroy(
+    iree_hal_executable_t* base_executable) {
+  iree_hal_metal_executable_t* executable =
+      iree_hal_metal_executable_cast(base_executable);
+  iree_allocator_t host_allocator = executable->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  for (iree_host_size_t i = 0; i < executable->entry_point_count; ++i) {
+    iree_hal_metal_entry_point_t* entry_point = &executable->entry_points[i];
+    [entry_point->pipeline release];
+    iree_hal_executable_layout_release(entry_point->layout);
+  }
+  iree_allocator_free(host_allocator, executable);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+const iree_hal_metal_entry_point_t*
+iree_hal_metal_executable_lookup_entry_point(
+    iree_hal_executable_t* base_executable, uint32_t entry_ordinal) {
+  iree_hal_metal_executable_t* executable =
+      iree_hal_metal_executable_cast(base_executable);
+  if (entry_ordinal >= executable->entry_point_count) return NULL;
+  return &executable->entry_points[entry_ordinal];
+}
+
+static const iree_hal_executable_vtable_t iree_hal_metal_executable_vtable = {
+    .destroy = iree_hal_metal_executable_destroy,
+};
@@ -0,0 +1,44 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_METAL_EXECUTABLE_LAYOUT_H_
+#define IREE_HAL_METAL_EXECUTABLE_LAYOUT_H_
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Creates an executable layout.
+//
+// Metal has no pipeline layout object: descriptor sets are bound as argument
+// buffers at buffer indices 0 to IREE_HAL_METAL_MAX_DESCRIPTOR_SET_COUNT-1 and
+// push constants are bound at IREE_HAL_METAL_PUSH_CONSTANT_BUFFER_INDEX.
+iree_status_t iree_hal_metal_executable_layout_create(
+    iree_host_size_t set_layout_count,
+    iree_hal_descriptor_set_layout_t** set_layouts,
+    iree_host_size_t push_constant_count, iree_allocator_t host_allocator,
+    iree_hal_executable_layout_t** out_executable_layout);
+
+// Returns the number of descriptor sets in the layout.
+iree_host_size_t iree_hal_metal_executable_layout_set_layout_count(
+    iree_hal_executable_layout_t* executable_layout);
+
+// Returns the descriptor set layout for |set| or NULL if out of range.
+iree_hal_descriptor_set_layout_t* iree_hal_metal_executable_layout_set_layout(
+    iree_hal_executable_layout_t* executable_layout, uint32_t set);
+
+// Returns the number of 32-bit push constants in the layout.
+iree_host_size_t iree_hal_metal_executable_layout_push_constant_count(
+    iree_hal_executable_layout_t* executable_layout);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_METAL_EXECUTABLE_LAYOUT_H_
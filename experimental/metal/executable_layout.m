@@ -0,0 +1,118 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "experimental/metal/executable_layout.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "experimental/metal/api.h"
+#include "iree/base/api.h"
+#include "iree/base/tracing.h"
+
+typedef struct iree_hal_metal_executable_layout_t {
+  iree_hal_resource_t resource;
+  iree_allocator_t host_allocator;
+  iree_host_size_t push_constant_count;
+  iree_host_size_t set_layout_count;
+  iree_hal_descriptor_set_layout_t* set_layouts[];
+} iree_hal_metal_executable_layout_t;
+
+static const iree_hal_executable_layout_vtable_t
+    iree_hal_metal_executable_layout_vtable;
+
+static iree_hal_metal_executable_layout_t*
+iree_hal_metal_executable_layout_cast(
+    iree_hal_executable_layout_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_hal_metal_executable_layout_vtable);
+  return (iree_hal_metal_executable_layout_t*)base_value;
+}
+
+static void iree_hal_metal_executable_layout_destroy(
+    iree_hal_executable_layout_t* base_executable_layout) {
+  iree_hal_metal_executable_layout_t* executable_layout =
+      iree_hal_metal_executable_layout_cast(base_executable_layout);
+  iree_allocator_t host_allocator = executable_layout->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  for (iree_host_size_t i = 0; i < executable_layout->set_layout_count; ++i) {
+    iree_hal_descriptor_set_layout_release(executable_layout->set_layouts[i]);
+  }
+  iree_allocator_free(host_allocator, executable_layout);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+iree_status_t iree_hal_metal_executable_layout_create(
+    iree_host_size_t set_layout_count,
+    iree_hal_descriptor_set_layout_t** set_layouts,
+    iree_host_size_t push_constant_count, iree_allocator_t host_allocator,
+    iree_hal_executable_layout_t** out_executable_layout) {
+  IREE_ASSERT_ARGUMENT(!set_layout_count || set_layouts);
+  IREE_ASSERT_ARGUMENT(out_executable_layout);
+  *out_executable_layout = NULL;
+  if (set_layout_count > IREE_HAL_METAL_MAX_DESCRIPTOR_SET_COUNT) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "descriptor set count %zu over the limit of %d",
+                            set_layout_count,
+                            IREE_HAL_METAL_MAX_DESCRIPTOR_SET_COUNT);
+  }
+  if (push_constant_count > IREE_HAL_METAL_MAX_PUSH_CONSTANT_COUNT) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "push constant count %zu over the limit of %d",
+                            push_constant_count,
+                            IREE_HAL_METAL_MAX_PUSH_CONSTANT_COUNT);
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_metal_executable_layout_t* executable_layout = NULL;
+  iree_host_size_t total_size =
+      sizeof(*executable_layout) +
+      set_layout_count * sizeof(*executable_layout->set_layouts);
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, total_size,
+                                (void**)&executable_layout));
+  iree_hal_resource_initialize(&iree_hal_metal_executable_layout_vtable,
+                               &executable_layout->resource);
+  executable_layout->host_allocator = host_allocator;
+  executable_layout->push_constant_count = push_constant_count;
+  executable_layout->set_layout_count = set_layout_count;
+  for (iree_host_size_t i = 0; i < set_layout_count; ++i) {
+    executable_layout->set_layouts[i] = set_layouts[i];
+    iree_hal_descriptor_set_layout_retain(set_layouts[i]);
+  }
+  *out_executable_layout = (iree_hal_executable_layout_t*)executable_layout;
+
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+iree_host_size_t iree_hal_metal_executable_layout_set_layout_count(
+    iree_hal_executable_layout_t* base_executable_layout) {
+  iree_hal_metal_executable_layout_t* executable_layout =
+      iree_hal_metal_executable_layout_cast(base_executable_layout);
+  return executable_layout->set_layout_count;
+}
+
+iree_hal_descriptor_set_layout_t* iree_hal_metal_executable_layout_set_layout(
+    iree_hal_executable_layout_t* base_executable_layout, uint32_t set) {
+  iree_hal_metal_executable_layout_t* executable_layout =
+      iree_hal_metal_executable_layout_cast(base_executable_layout);
+  if (set >= executable_layout->set_layout_count) return NULL;
+  return executable_layout->set_layouts[set];
+}
+
+iree_host_size_t iree_hal_metal_executable_layout_push_constant_count(
+    iree_hal_executable_layout_t* base_executable_layout) {
+  iree_hal_metal_executable_layout_t* executable_layout =
+      iree_hal_metal_executable_layout_cast(base_executable_layout);
+  return executable_layout->push_constant_count;
+}
+
+static const iree_hal_executable_layout_vtable_t
+    iree_hal_metal_executable_layout_vtable = {
+        .destroy = iree_hal_metal_executable_layout_destroy,
+};
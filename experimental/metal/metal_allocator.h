@@ -0,0 +1,33 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_METAL_METAL_ALLOCATOR_H_
+#define IREE_HAL_METAL_METAL_ALLOCATOR_H_
+
+#import <Metal/Metal.h>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Creates an allocator of MTLBuffers from |device|.
+//
+// Host-visible buffers use MTLStorageModeShared and device-local buffers use
+// MTLStorageModePrivate. When |device| has unified memory (Apple silicon) all
+// buffers use shared storage and device-local buffers are also host-visible so
+// that they can be mapped without copies.
+iree_status_t iree_hal_metal_allocator_create(
+    iree_hal_device_t* base_device, id<MTLDevice> device,
+    iree_allocator_t host_allocator, iree_hal_allocator_t** out_allocator);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_METAL_METAL_ALLOCATOR_H_
@@ -0,0 +1,267 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "experimental/metal/metal_allocator.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "experimental/metal/metal_buffer.h"
+#include "iree/base/api.h"
+#include "iree/base/tracing.h"
+
+typedef struct iree_hal_metal_allocator_t {
+  iree_hal_resource_t resource;
+  iree_hal_device_t* base_device;
+  iree_allocator_t host_allocator;
+  id<MTLDevice> device;
+
+  // True if the CPU and GPU share memory and all buffers use shared storage.
+  bool is_unified_memory;
+
+  IREE_STATISTICS(iree_hal_allocator_statistics_t statistics;)
+} iree_hal_metal_allocator_t;
+
+static const iree_hal_allocator_vtable_t iree_hal_metal_allocator_vtable;
+
+static iree_hal_metal_allocator_t* iree_hal_metal_allocator_cast(
+    iree_hal_allocator_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_hal_metal_allocator_vtable);
+  return (iree_hal_metal_allocator_t*)base_value;
+}
+
+iree_status_t iree_hal_metal_allocator_create(
+    iree_hal_device_t* base_device, id<MTLDevice> device,
+    iree_allocator_t host_allocator, iree_hal_allocator_t** out_allocator) {
+  IREE_ASSERT_ARGUMENT(base_device);
+  IREE_ASSERT_ARGUMENT(device);
+  IREE_ASSERT_ARGUMENT(out_allocator);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_metal_allocator_t* allocator = NULL;
+  iree_status_t status = iree_allocator_malloc(
+      host_allocator, sizeof(*allocator), (void**)&allocator);
+  if (iree_status_is_ok(status)) {
+    memset(allocator, 0, sizeof(*allocator));
+    iree_hal_resource_initialize(&iree_hal_metal_allocator_vtable,
+                                 &allocator->resource);
+    allocator->base_device = base_device;
+    allocator->host_allocator = host_allocator;
+    allocator->device = [device retain];
+    allocator->is_unified_memory = device.hasUnifiedMemory;
+    *out_allocator = (iree_hal_allocator_t*)allocator;
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_metal_allocator_destroy(
+    iree_hal_allocator_t* base_allocator) {
+  iree_hal_metal_allocator_t* allocator =
+      iree_hal_metal_allocator_cast(base_allocator);
+  iree_allocator_t host_allocator = allocator->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  [allocator->device release];
+  iree_allocator_free(host_allocator, allocator);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+static iree_allocator_t iree_hal_metal_allocator_host_allocator(
+    const iree_hal_allocator_t* base_allocator) {
+  iree_hal_metal_allocator_t* allocator =
+      (iree_hal_metal_allocator_t*)base_allocator;
+  return allocator->host_allocator;
+}
+
+static iree_status_t iree_hal_metal_allocator_trim(
+    iree_hal_allocator_t* base_allocator) {
+  return iree_ok_status();
+}
+
+static void iree_hal_metal_allocator_query_statistics(
+    iree_hal_allocator_t* base_allocator,
+    iree_hal_allocator_statistics_t* out_statistics) {
+  IREE_STATISTICS({
+    iree_hal_metal_allocator_t* allocator =
+        iree_hal_metal_allocator_cast(base_allocator);
+    memcpy(out_statistics, &allocator->statistics, sizeof(*out_statistics));
+  });
+}
+
+static iree_hal_buffer_compatibility_t
+iree_hal_metal_allocator_query_buffer_compatibility(
+    iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_buffer_usage_t allowed_usage,
+    iree_hal_buffer_usage_t intended_usage,
+    iree_device_size_t allocation_size) {
+  iree_hal_metal_allocator_t* allocator =
+      iree_hal_metal_allocator_cast(base_allocator);
+
+  // Disallow usage not permitted by the buffer itself. Since we then use this
+  // to determine compatibility below we'll naturally set the right compat flags
+  // based on what's both allowed and intended.
+  intended_usage &= allowed_usage;
+
+  // Buffers larger than the device limit cannot be allocated at all.
+  if (allocation_size > allocator->device.maxBufferLength) {
+    return IREE_HAL_BUFFER_COMPATIBILITY_NONE;
+  }
+
+  // All buffers can be allocated; private storage cannot be mapped.
+  iree_hal_buffer_compatibility_t compatibility =
+      IREE_HAL_BUFFER_COMPATIBILITY_ALLOCATABLE;
+
+  // Buffers can only be used on the queue if they are device visible.
+  if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE)) {
+    if (iree_all_bits_set(intended_usage, IREE_HAL_BUFFER_USAGE_TRANSFER)) {
+      compatibility |= IREE_HAL_BUFFER_COMPATIBILITY_QUEUE_TRANSFER;
+    }
+    if (iree_all_bits_set(intended_usage, IREE_HAL_BUFFER_USAGE_DISPATCH)) {
+      compatibility |= IREE_HAL_BUFFER_COMPATIBILITY_QUEUE_DISPATCH;
+    }
+  }
+
+  return compatibility;
+}
+
+// Returns the storage mode used for buffers of |memory_type|.
+static MTLResourceOptions iree_hal_metal_allocator_select_storage_mode(
+    iree_hal_metal_allocator_t* allocator,
+    iree_hal_memory_type_t memory_type) {
+  if (allocator->is_unified_memory ||
+      iree_any_bit_set(memory_type, IREE_HAL_MEMORY_TYPE_HOST_VISIBLE)) {
+    return MTLResourceStorageModeShared;
+  }
+  return MTLResourceStorageModePrivate;
+}
+
+static iree_status_t iree_hal_metal_allocator_allocate_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_buffer_usage_t allowed_usage, iree_host_size_t allocation_size,
+    iree_const_byte_span_t initial_data, iree_hal_buffer_t** out_buffer) {
+  iree_hal_metal_allocator_t* allocator =
+      iree_hal_metal_allocator_cast(base_allocator);
+  // Metal buffers must be non-empty and we keep them 4-byte aligned so that
+  // builtin fills of whole words stay within the allocation.
+  allocation_size = iree_host_align(iree_max(allocation_size, 4), 4);
+
+  MTLResourceOptions options =
+      iree_hal_metal_allocator_select_storage_mode(allocator, memory_type);
+  if (options == MTLResourceStorageModeShared) {
+    // Shared storage is always host-visible and coherent; on unified memory
+    // this lets device-local buffers be mapped without any copies.
+    memory_type |=
+        IREE_HAL_MEMORY_TYPE_HOST_VISIBLE | IREE_HAL_MEMORY_TYPE_HOST_COHERENT;
+    allowed_usage |= IREE_HAL_BUFFER_USAGE_MAPPING;
+    // Write-combining speeds up host writes to buffers the host never reads.
+    if (!iree_any_bit_set(memory_type, IREE_HAL_MEMORY_TYPE_HOST_CACHED) &&
+        iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL)) {
+      options |= MTLResourceCPUCacheModeWriteCombined;
+    }
+  } else if (!iree_const_byte_span_is_empty(initial_data)) {
+    // Private storage can't be written by the host; upload through a
+    // temporary device-visible copy instead.
+    // TODO: stage through a blit once the allocator can reach the queue.
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "initial data is not supported for buffers in "
+                            "private storage");
+  }
+
+  IREE_TRACE_ZONE_BEGIN_NAMED(z0, "iree_hal_metal_buffer_allocate");
+  id<MTLBuffer> handle = nil;
+  if (!iree_const_byte_span_is_empty(initial_data) &&
+      initial_data.data_length == allocation_size) {
+    handle = [allocator->device newBufferWithBytes:initial_data.data
+                                            length:allocation_size
+                                           options:options];
+  } else {
+    handle = [allocator->device newBufferWithLength:allocation_size
+                                            options:options];
+    if (handle && !iree_const_byte_span_is_empty(initial_data)) {
+      memcpy(handle.contents, initial_data.data, initial_data.data_length);
+    }
+  }
+  IREE_TRACE_ZONE_END(z0);
+  if (!handle) {
+    return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                            "failed to create a %zuB Metal buffer",
+                            allocation_size);
+  }
+
+  iree_hal_buffer_t* buffer = NULL;
+  iree_status_t status = iree_hal_metal_buffer_wrap(
+      base_allocator, memory_type, IREE_HAL_MEMORY_ACCESS_ALL, allowed_usage,
+      allocation_size, /*byte_offset=*/0, /*byte_length=*/allocation_size,
+      handle, &buffer);
+  // The buffer retains the handle (if it was created).
+  [handle release];
+
+  if (iree_status_is_ok(status)) {
+    IREE_STATISTICS(iree_hal_allocator_statistics_record_alloc(
+        &allocator->statistics, memory_type, allocation_size));
+    *out_buffer = buffer;
+  }
+  return status;
+}
+
+static void iree_hal_metal_allocator_deallocate_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_buffer_t* base_buffer) {
+  iree_hal_metal_allocator_t* allocator =
+      iree_hal_metal_allocator_cast(base_allocator);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  IREE_STATISTICS(iree_hal_allocator_statistics_record_free(
+      &allocator->statistics, iree_hal_buffer_memory_type(base_buffer),
+      iree_hal_buffer_allocation_size(base_buffer)));
+
+  iree_hal_buffer_destroy(base_buffer);
+  IREE_TRACE_ZONE_END(z0);
+}
+
+static iree_status_t iree_hal_metal_allocator_wrap_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_memory_access_t allowed_access,
+    iree_hal_buffer_usage_t allowed_usage, iree_byte_span_t data,
+    iree_allocator_t data_allocator, iree_hal_buffer_t** out_buffer) {
+  return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                          "wrapping of host memory is not supported");
+}
+
+static iree_status_t iree_hal_metal_allocator_import_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_memory_access_t allowed_access,
+    iree_hal_buffer_usage_t allowed_usage,
+    iree_hal_external_buffer_t* external_buffer,
+    iree_hal_buffer_t** out_buffer) {
+  return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                          "importing from external buffers not supported");
+}
+
+static iree_status_t iree_hal_metal_allocator_export_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_buffer_t* buffer,
+    iree_hal_external_buffer_type_t requested_type,
+    iree_hal_external_buffer_flags_t requested_flags,
+    iree_hal_external_buffer_t* out_external_buffer) {
+  return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                          "exporting to external buffers not supported");
+}
+
+static const iree_hal_allocator_vtable_t iree_hal_metal_allocator_vtable = {
+    .destroy = iree_hal_metal_allocator_destroy,
+    .host_allocator = iree_hal_metal_allocator_host_allocator,
+    .trim = iree_hal_metal_allocator_trim,
+    .query_statistics = iree_hal_metal_allocator_query_statistics,
+    .query_buffer_compatibility =
+        iree_hal_metal_allocator_query_buffer_compatibility,
+    .allocate_buffer = iree_hal_metal_allocator_allocate_buffer,
+    .deallocate_buffer = iree_hal_metal_allocator_deallocate_buffer,
+    .wrap_buffer = iree_hal_metal_allocator_wrap_buffer,
+    .import_buffer = iree_hal_metal_allocator_import_buffer,
+    .export_buffer = iree_hal_metal_allocator_export_buffer,
+};
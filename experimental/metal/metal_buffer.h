@@ -0,0 +1,40 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_METAL_METAL_BUFFER_H_
+#define IREE_HAL_METAL_METAL_BUFFER_H_
+
+#import <Metal/Metal.h>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Wraps a Metal buffer |handle| allocated by |allocator|. The handle is
+// retained by the buffer and released when it is destroyed.
+//
+// Buffers in MTLStorageModeShared are mapped directly: on Apple silicon the
+// memory is shared by the CPU and GPU and mapping is zero-copy. Buffers in
+// MTLStorageModePrivate cannot be mapped.
+iree_status_t iree_hal_metal_buffer_wrap(
+    iree_hal_allocator_t* allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_memory_access_t allowed_access,
+    iree_hal_buffer_usage_t allowed_usage, iree_device_size_t allocation_size,
+    iree_device_size_t byte_offset, iree_device_size_t byte_length,
+    id<MTLBuffer> handle, iree_hal_buffer_t** out_buffer);
+
+// Returns the Metal handle backing |buffer|.
+// |buffer| must be an allocated Metal buffer and not a subspan.
+id<MTLBuffer> iree_hal_metal_buffer_handle(const iree_hal_buffer_t* buffer);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_METAL_METAL_BUFFER_H_
@@ -0,0 +1,542 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "experimental/metal/api.h"
+#include "experimental/metal/builtins.h"
+#include "experimental/metal/command_buffer.h"
+#include "experimental/metal/descriptor_set.h"
+#include "experimental/metal/descriptor_set_layout.h"
+#include "experimental/metal/executable_layout.h"
+#include "experimental/metal/metal_allocator.h"
+#include "experimental/metal/nop_event.h"
+#include "experimental/metal/nop_executable_cache.h"
+#include "experimental/metal/shared_event.h"
+#include "iree/base/internal/arena.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/tracing.h"
+#include "iree/hal/utils/buffer_transfer.h"
+#include "iree/hal/utils/deferred_command_buffer.h"
+
+//===----------------------------------------------------------------------===//
+// iree_hal_metal_device_t
+//===----------------------------------------------------------------------===//
+
+typedef struct iree_hal_metal_device_t {
+  iree_hal_resource_t resource;
+  iree_string_view_t identifier;
+
+  // Block pool used for command buffers with a larger block size (as command
+  // buffers can contain inlined data uploads).
+  iree_arena_block_pool_t block_pool;
+
+  iree_hal_metal_device_options_t options;
+  iree_allocator_t host_allocator;
+
+  id<MTLDevice> handle;
+  id<MTLCommandQueue> queue;
+
+  // Listener that host waits on shared events are notified through.
+  MTLSharedEventListener* event_listener;
+
+  iree_hal_allocator_t* device_allocator;
+
+  // Pipelines used to emulate commands Metal has no native equivalent for.
+  iree_hal_metal_builtins_t builtins;
+
+  // Serializes submissions so that |timeline| is signaled in commit order.
+  iree_slim_mutex_t submit_mutex;
+  // Semaphore signaled by every submission with increasing values; waiting on
+  // the last submitted value waits for the queue to become idle.
+  iree_hal_semaphore_t* timeline;
+  uint64_t timeline_value IREE_GUARDED_BY(submit_mutex);
+} iree_hal_metal_device_t;
+
+static const iree_hal_device_vtable_t iree_hal_metal_device_vtable;
+
+static iree_hal_metal_device_t* iree_hal_metal_device_cast(
+    iree_hal_device_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_hal_metal_device_vtable);
+  return (iree_hal_metal_device_t*)base_value;
+}
+
+IREE_API_EXPORT void iree_hal_metal_device_options_initialize(
+    iree_hal_metal_device_options_t* out_options) {
+  memset(out_options, 0, sizeof(*out_options));
+  out_options->arena_block_size = 32 * 1024;
+  out_options->argument_buffer_block_size = 64 * 1024;
+}
+
+static iree_status_t iree_hal_metal_device_check_options(
+    const iree_hal_metal_device_options_t* options) {
+  if (options->arena_block_size < 4096) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "arena block size too small (< 4096 bytes)");
+  }
+  if (options->argument_buffer_block_size < 4096) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "argument buffer block size too small (< 4096 bytes)");
+  }
+  return iree_ok_status();
+}
+
+static void iree_hal_metal_device_destroy(iree_hal_device_t* base_device);
+
+IREE_API_EXPORT iree_status_t iree_hal_metal_wrap_device(
+    iree_string_view_t identifier,
+    const iree_hal_metal_device_options_t* options, id<MTLDevice> handle,
+    iree_allocator_t host_allocator, iree_hal_device_t** out_device) {
+  IREE_ASSERT_ARGUMENT(options);
+  IREE_ASSERT_ARGUMENT(handle);
+  IREE_ASSERT_ARGUMENT(out_device);
+  *out_device = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_metal_device_check_options(options));
+
+  iree_hal_metal_device_t* device = NULL;
+  iree_host_size_t total_size = iree_sizeof_struct(*device) + identifier.size;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, total_size, (void**)&device));
+  memset(device, 0, total_size);
+  iree_hal_resource_initialize(&iree_hal_metal_device_vtable,
+                               &device->resource);
+  iree_string_view_append_to_buffer(
+      identifier, &device->identifier,
+      (char*)device + iree_sizeof_struct(*device));
+  iree_arena_block_pool_initialize(options->arena_block_size, host_allocator,
+                                   &device->block_pool);
+  device->options = *options;
+  device->host_allocator = host_allocator;
+  iree_slim_mutex_initialize(&device->submit_mutex);
+  device->handle = [handle retain];
+  device->queue = [handle newCommandQueue];
+  device->event_listener = [[MTLSharedEventListener alloc] init];
+
+  iree_status_t status = iree_ok_status();
+  if (!device->queue) {
+    status = iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                              "failed to create a command queue");
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_metal_allocator_create((iree_hal_device_t*)device,
+                                             device->handle, host_allocator,
+                                             &device->device_allocator);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_metal_builtins_initialize(device->handle,
+                                                &device->builtins);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_metal_shared_event_create(
+        device->handle, device->event_listener, /*initial_value=*/0,
+        host_allocator, &device->timeline);
+  }
+
+  if (iree_status_is_ok(status)) {
+    *out_device = (iree_hal_device_t*)device;
+  } else {
+    iree_hal_metal_device_destroy((iree_hal_device_t*)device);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_metal_device_destroy(iree_hal_device_t* base_device) {
+  iree_hal_metal_device_t* device = iree_hal_metal_device_cast(base_device);
+  iree_allocator_t host_allocator = device->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Wait for in-flight work so that their completion handlers run before the
+  // state they reference is released.
+  if (device->timeline) {
+    iree_status_ignore(iree_hal_semaphore_wait(
+        device->timeline, device->timeline_value, iree_infinite_timeout()));
+  }
+
+  // There should be no more buffers live that use the allocator.
+  iree_hal_semaphore_release(device->timeline);
+  iree_hal_metal_builtins_deinitialize(&device->builtins);
+  iree_hal_allocator_release(device->device_allocator);
+
+  iree_arena_block_pool_deinitialize(&device->block_pool);
+
+  [device->event_listener release];
+  [device->queue release];
+  [device->handle release];
+  iree_slim_mutex_deinitialize(&device->submit_mutex);
+
+  iree_allocator_free(host_allocator, device);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+static iree_string_view_t iree_hal_metal_device_id(
+    iree_hal_device_t* base_device) {
+  iree_hal_metal_device_t* device = iree_hal_metal_device_cast(base_device);
+  return device->identifier;
+}
+
+static iree_allocator_t iree_hal_metal_device_host_allocator(
+    iree_hal_device_t* base_device) {
+  iree_hal_metal_device_t* device = iree_hal_metal_device_cast(base_device);
+  return device->host_allocator;
+}
+
+static iree_hal_allocator_t* iree_hal_metal_device_allocator(
+    iree_hal_device_t* base_device) {
+  iree_hal_metal_device_t* device = iree_hal_metal_device_cast(base_device);
+  return device->device_allocator;
+}
+
+static iree_status_t iree_hal_metal_device_trim(
+    iree_hal_device_t* base_device) {
+  iree_hal_metal_device_t* device = iree_hal_metal_device_cast(base_device);
+  iree_arena_block_pool_trim(&device->block_pool);
+  return iree_hal_allocator_trim(device->device_allocator);
+}
+
+static iree_status_t iree_hal_metal_device_query_i32(
+    iree_hal_device_t* base_device, iree_string_view_t category,
+    iree_string_view_t key, int32_t* out_value) {
+  *out_value = 0;
+
+  if (iree_string_view_equal(category,
+                             iree_make_cstring_view("hal.executable.format"))) {
+    *out_value =
+        iree_string_view_equal(key, iree_make_cstring_view("metal-msl-fb"))
+            ? 1
+            : 0;
+    return iree_ok_status();
+  }
+
+  return iree_make_status(
+      IREE_STATUS_NOT_FOUND,
+      "unknown device configuration key value '%.*s :: %.*s'",
+      (int)category.size, category.data, (int)key.size, key.data);
+}
+
+static iree_status_t iree_hal_metal_device_create_command_buffer(
+    iree_hal_device_t* base_device, iree_hal_command_buffer_mode_t mode,
+    iree_hal_command_category_t command_categories,
+    iree_hal_queue_affinity_t queue_affinity,
+    iree_hal_command_buffer_t** out_command_buffer) {
+  iree_hal_metal_device_t* device = iree_hal_metal_device_cast(base_device);
+  // Commands are recorded and replayed into a new MTLCommandBuffer on each
+  // submission. Replay resolves indirect bindings from the batch binding table
+  // so all modes (including reusable command buffers) are supported.
+  return iree_hal_deferred_command_buffer_create(
+      base_device, mode, command_categories, &device->block_pool,
+      device->host_allocator, out_command_buffer);
+}
+
+static iree_status_t iree_hal_metal_device_create_descriptor_set(
+    iree_hal_device_t* base_device,
+    iree_hal_descriptor_set_layout_t* set_layout,
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_binding_t* bindings,
+    iree_hal_descriptor_set_t** out_descriptor_set) {
+  iree_hal_metal_device_t* device = iree_hal_metal_device_cast(base_device);
+  return iree_hal_metal_descriptor_set_create(set_layout, binding_count,
+                                              bindings, device->host_allocator,
+                                              out_descriptor_set);
+}
+
+static iree_status_t iree_hal_metal_device_create_descriptor_set_layout(
+    iree_hal_device_t* base_device,
+    iree_hal_descriptor_set_layout_usage_type_t usage_type,
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_layout_binding_t* bindings,
+    iree_hal_descriptor_set_layout_t** out_descriptor_set_layout) {
+  iree_hal_metal_device_t* device = iree_hal_metal_device_cast(base_device);
+  return iree_hal_metal_descriptor_set_layout_create(
+      device->handle, usage_type, binding_count, bindings,
+      device->host_allocator, out_descriptor_set_layout);
+}
+
+static iree_status_t iree_hal_metal_device_create_event(
+    iree_hal_device_t* base_device, iree_hal_event_t** out_event) {
+  iree_hal_metal_device_t* device = iree_hal_metal_device_cast(base_device);
+  return iree_hal_metal_nop_event_create(device->host_allocator, out_event);
+}
+
+static iree_status_t iree_hal_metal_device_create_executable_cache(
+    iree_hal_device_t* base_device, iree_string_view_t identifier,
+    iree_hal_executable_cache_t** out_executable_cache) {
+  iree_hal_metal_device_t* device = iree_hal_metal_device_cast(base_device);
+  return iree_hal_metal_nop_executable_cache_create(
+      device->handle, identifier, device->host_allocator,
+      out_executable_cache);
+}
+
+static iree_status_t iree_hal_metal_device_create_executable_layout(
+    iree_hal_device_t* base_device, iree_host_size_t push_constants,
+    iree_host_size_t set_layout_count,
+    iree_hal_descriptor_set_layout_t** set_layouts,
+    iree_hal_executable_layout_t** out_executable_layout) {
+  iree_hal_metal_device_t* device = iree_hal_metal_device_cast(base_device);
+  return iree_hal_metal_executable_layout_create(
+      set_layout_count, set_layouts, push_constants, device->host_allocator,
+      out_executable_layout);
+}
+
+static iree_status_t iree_hal_metal_device_create_semaphore(
+    iree_hal_device_t* base_device, uint64_t initial_value,
+    iree_hal_semaphore_t** out_semaphore) {
+  iree_hal_metal_device_t* device = iree_hal_metal_device_cast(base_device);
+  return iree_hal_metal_shared_event_create(
+      device->handle, device->event_listener, initial_value,
+      device->host_allocator, out_semaphore);
+}
+
+static iree_status_t iree_hal_metal_device_transfer_range(
+    iree_hal_device_t* base_device, iree_hal_transfer_buffer_t source,
+    iree_device_size_t source_offset, iree_hal_transfer_buffer_t target,
+    iree_device_size_t target_offset, iree_device_size_t data_length,
+    iree_hal_transfer_buffer_flags_t flags, iree_timeout_t timeout) {
+  // TODO: map shared-storage buffers directly instead of going through the
+  // queue when there is no other work in flight.
+  return iree_hal_device_submit_transfer_range_and_wait(
+      base_device, source, source_offset, target, target_offset, data_length,
+      flags, timeout);
+}
+
+// Signals all semaphores in |semaphore_list| to their payload values.
+static iree_status_t iree_hal_metal_device_signal_semaphores(
+    const iree_hal_semaphore_list_t* semaphore_list) {
+  for (iree_host_size_t i = 0; i < semaphore_list->count; ++i) {
+    IREE_RETURN_IF_ERROR(iree_hal_semaphore_signal(
+        semaphore_list->semaphores[i], semaphore_list->payload_values[i]));
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_metal_device_queue_alloca(
+    iree_hal_device_t* base_device, iree_hal_queue_affinity_t queue_affinity,
+    const iree_hal_semaphore_list_t wait_semaphore_list,
+    const iree_hal_semaphore_list_t signal_semaphore_list,
+    iree_hal_memory_type_t memory_type, iree_hal_buffer_usage_t allowed_usage,
+    iree_device_size_t allocation_size, iree_hal_buffer_t** out_buffer) {
+  iree_hal_metal_device_t* device = iree_hal_metal_device_cast(base_device);
+  // Metal has no queue-ordered allocation: wait on the host and allocate
+  // immediately. The queue orders the first use of the buffer after prior work.
+  IREE_RETURN_IF_ERROR(iree_hal_metal_shared_event_multi_wait(
+      IREE_HAL_WAIT_MODE_ALL, &wait_semaphore_list, iree_infinite_timeout()));
+  iree_hal_buffer_t* buffer = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_allocator_allocate_buffer(
+      device->device_allocator, memory_type, allowed_usage,
+      (iree_host_size_t)allocation_size, iree_const_byte_span_empty(),
+      &buffer));
+  iree_status_t status =
+      iree_hal_metal_device_signal_semaphores(&signal_semaphore_list);
+  if (iree_status_is_ok(status)) {
+    *out_buffer = buffer;
+  } else {
+    iree_hal_buffer_release(buffer);
+  }
+  return status;
+}
+
+static iree_status_t iree_hal_metal_device_queue_dealloca(
+    iree_hal_device_t* base_device, iree_hal_queue_affinity_t queue_affinity,
+    const iree_hal_semaphore_list_t wait_semaphore_list,
+    const iree_hal_semaphore_list_t signal_semaphore_list,
+    iree_hal_buffer_t* buffer) {
+  // The memory is returned when the last reference is released. Command
+  // buffers retain the MTLBuffers they reference until they complete.
+  IREE_RETURN_IF_ERROR(iree_hal_metal_shared_event_multi_wait(
+      IREE_HAL_WAIT_MODE_ALL, &wait_semaphore_list, iree_infinite_timeout()));
+  return iree_hal_metal_device_signal_semaphores(&signal_semaphore_list);
+}
+
+// Fails |semaphore_list| if |handle| completes with an error.
+// The semaphores are retained until then; on success the events are signaled
+// by the GPU itself.
+static iree_status_t iree_hal_metal_device_fail_on_error(
+    iree_hal_metal_device_t* device, id<MTLCommandBuffer> handle,
+    const iree_hal_semaphore_list_t* semaphore_list) {
+  iree_host_size_t count = semaphore_list->count;
+  if (count == 0) return iree_ok_status();
+  iree_allocator_t host_allocator = device->host_allocator;
+  iree_hal_semaphore_t** semaphores = NULL;
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+      host_allocator, count * sizeof(*semaphores), (void**)&semaphores));
+  for (iree_host_size_t i = 0; i < count; ++i) {
+    semaphores[i] = semaphore_list->semaphores[i];
+    iree_hal_semaphore_retain(semaphores[i]);
+  }
+  [handle addCompletedHandler:^(id<MTLCommandBuffer> command_buffer) {
+    for (iree_host_size_t i = 0; i < count; ++i) {
+      if (command_buffer.status == MTLCommandBufferStatusError) {
+        iree_hal_semaphore_fail(
+            semaphores[i],
+            iree_make_status(
+                IREE_STATUS_INTERNAL, "command buffer failed: %s",
+                command_buffer.error.localizedDescription.UTF8String));
+      }
+      iree_hal_semaphore_release(semaphores[i]);
+    }
+    iree_allocator_free(host_allocator, semaphores);
+  }];
+  return iree_ok_status();
+}
+
+// Encodes and commits |batch| as a single MTLCommandBuffer.
+// Must be called with |submit_mutex| held.
+static iree_status_t iree_hal_metal_device_submit_batch(
+    iree_hal_metal_device_t* device, const iree_hal_submission_batch_t* batch) {
+  // Retains all resources it references until it completes.
+  id<MTLCommandBuffer> handle = [device->queue commandBuffer];
+  if (!handle) {
+    return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                            "failed to create a command buffer");
+  }
+
+  // Waits and signals happen on the GPU timeline.
+  for (iree_host_size_t i = 0; i < batch->wait_semaphores.count; ++i) {
+    [handle encodeWaitForEvent:iree_hal_metal_shared_event_handle(
+                                   batch->wait_semaphores.semaphores[i])
+                         value:batch->wait_semaphores.payload_values[i]];
+  }
+
+  iree_hal_command_buffer_t* command_buffer = NULL;
+  iree_status_t status = iree_hal_metal_command_buffer_create(
+      (iree_hal_device_t*)device, device->handle, handle,
+      device->options.argument_buffer_block_size, &device->builtins,
+      device->host_allocator, &command_buffer);
+  for (iree_host_size_t i = 0;
+       i < batch->command_buffer_count && iree_status_is_ok(status); ++i) {
+    status = iree_hal_deferred_command_buffer_apply(
+        batch->command_buffers[i], command_buffer, batch->binding_table);
+  }
+  iree_hal_command_buffer_release(command_buffer);
+
+  if (iree_status_is_ok(status)) {
+    for (iree_host_size_t i = 0; i < batch->signal_semaphores.count; ++i) {
+      [handle encodeSignalEvent:iree_hal_metal_shared_event_handle(
+                                    batch->signal_semaphores.semaphores[i])
+                          value:batch->signal_semaphores.payload_values[i]];
+    }
+    [handle encodeSignalEvent:iree_hal_metal_shared_event_handle(
+                                  device->timeline)
+                        value:device->timeline_value + 1];
+    status = iree_hal_metal_device_fail_on_error(device, handle,
+                                                 &batch->signal_semaphores);
+  }
+
+  // Commands encoded before a failure are dropped with |handle|.
+  if (iree_status_is_ok(status)) {
+    [handle commit];
+    ++device->timeline_value;
+  }
+  return status;
+}
+
+static iree_status_t iree_hal_metal_device_queue_submit(
+    iree_hal_device_t* base_device,
+    iree_hal_command_category_t command_categories,
+    iree_hal_queue_affinity_t queue_affinity, iree_host_size_t batch_count,
+    const iree_hal_submission_batch_t* batches) {
+  iree_hal_metal_device_t* device = iree_hal_metal_device_cast(base_device);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_status_t status = iree_ok_status();
+  iree_slim_mutex_lock(&device->submit_mutex);
+  // Command buffers and encoders are returned autoreleased and callers may not
+  // have a pool of their own.
+  @autoreleasepool {
+    for (iree_host_size_t i = 0; i < batch_count && iree_status_is_ok(status);
+         ++i) {
+      status = iree_hal_metal_device_submit_batch(device, &batches[i]);
+    }
+  }
+  iree_slim_mutex_unlock(&device->submit_mutex);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static iree_status_t iree_hal_metal_device_submit_and_wait(
+    iree_hal_device_t* base_device,
+    iree_hal_command_category_t command_categories,
+    iree_hal_queue_affinity_t queue_affinity, iree_host_size_t batch_count,
+    const iree_hal_submission_batch_t* batches,
+    iree_hal_semaphore_t* wait_semaphore, uint64_t wait_value,
+    iree_timeout_t timeout) {
+  // Submit...
+  IREE_RETURN_IF_ERROR(iree_hal_metal_device_queue_submit(
+      base_device, command_categories, queue_affinity, batch_count, batches));
+
+  // ...and wait.
+  return iree_hal_semaphore_wait(wait_semaphore, wait_value, timeout);
+}
+
+static iree_status_t iree_hal_metal_device_wait_semaphores(
+    iree_hal_device_t* base_device, iree_hal_wait_mode_t wait_mode,
+    const iree_hal_semaphore_list_t* semaphore_list, iree_timeout_t timeout) {
+  return iree_hal_metal_shared_event_multi_wait(wait_mode, semaphore_list,
+                                                timeout);
+}
+
+static iree_status_t iree_hal_metal_device_wait_idle(
+    iree_hal_device_t* base_device, iree_timeout_t timeout) {
+  iree_hal_metal_device_t* device = iree_hal_metal_device_cast(base_device);
+  iree_slim_mutex_lock(&device->submit_mutex);
+  uint64_t timeline_value = device->timeline_value;
+  iree_slim_mutex_unlock(&device->submit_mutex);
+  return iree_hal_semaphore_wait(device->timeline, timeline_value, timeout);
+}
+
+static iree_status_t iree_hal_metal_device_profiling_begin(
+    iree_hal_device_t* base_device,
+    const iree_hal_device_profiling_options_t* options) {
+  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                          "device profiling not yet implemented");
+}
+
+static iree_status_t iree_hal_metal_device_profiling_flush(
+    iree_hal_device_t* base_device) {
+  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                          "device profiling not yet implemented");
+}
+
+static iree_status_t iree_hal_metal_device_profiling_end(
+    iree_hal_device_t* base_device) {
+  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                          "device profiling not yet implemented");
+}
+
+static const iree_hal_device_vtable_t iree_hal_metal_device_vtable = {
+    .destroy = iree_hal_metal_device_destroy,
+    .id = iree_hal_metal_device_id,
+    .host_allocator = iree_hal_metal_device_host_allocator,
+    .device_allocator = iree_hal_metal_device_allocator,
+    .trim = iree_hal_metal_device_trim,
+    .query_i32 = iree_hal_metal_device_query_i32,
+    .create_command_buffer = iree_hal_metal_device_create_command_buffer,
+    .create_descriptor_set = iree_hal_metal_device_create_descriptor_set,
+    .create_descriptor_set_layout =
+        iree_hal_metal_device_create_descriptor_set_layout,
+    .create_event = iree_hal_metal_device_create_event,
+    .create_executable_cache = iree_hal_metal_device_create_executable_cache,
+    .create_executable_layout = iree_hal_metal_device_create_executable_layout,
+    .create_semaphore = iree_hal_metal_device_create_semaphore,
+    .transfer_range = iree_hal_metal_device_transfer_range,
+    .queue_alloca = iree_hal_metal_device_queue_alloca,
+    .queue_dealloca = iree_hal_metal_device_queue_dealloca,
+    .queue_submit = iree_hal_metal_device_queue_submit,
+    .submit_and_wait = iree_hal_metal_device_submit_and_wait,
+    .wait_semaphores = iree_hal_metal_device_wait_semaphores,
+    .wait_idle = iree_hal_metal_device_wait_idle,
+    .profiling_begin = iree_hal_metal_device_profiling_begin,
+    .profiling_flush = iree_hal_metal_device_profiling_flush,
+    .profiling_end = iree_hal_metal_device_profiling_end,
+};
@@ -0,0 +1,169 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <string.h>
+
+#import <Metal/Metal.h>
+#include <TargetConditionals.h>
+
+#include "experimental/metal/api.h"
+#include "iree/base/api.h"
+#include "iree/base/tracing.h"
+#include "iree/hal/api.h"
+
+typedef struct iree_hal_metal_driver_t {
+  iree_hal_resource_t resource;
+  iree_allocator_t host_allocator;
+  // Identifier used for the driver in the IREE driver registry.
+  iree_string_view_t identifier;
+  iree_hal_metal_device_options_t default_device_options;
+} iree_hal_metal_driver_t;
+
+static const iree_hal_driver_vtable_t iree_hal_metal_driver_vtable;
+
+static iree_hal_metal_driver_t* iree_hal_metal_driver_cast(
+    iree_hal_driver_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_hal_metal_driver_vtable);
+  return (iree_hal_metal_driver_t*)base_value;
+}
+
+IREE_API_EXPORT void iree_hal_metal_driver_options_initialize(
+    iree_hal_metal_driver_options_t* out_options) {
+  memset(out_options, 0, sizeof(*out_options));
+  iree_hal_metal_device_options_initialize(
+      &out_options->default_device_options);
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_metal_driver_create(
+    iree_string_view_t identifier,
+    const iree_hal_metal_driver_options_t* options,
+    iree_allocator_t host_allocator, iree_hal_driver_t** out_driver) {
+  IREE_ASSERT_ARGUMENT(options);
+  IREE_ASSERT_ARGUMENT(out_driver);
+  *out_driver = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_metal_driver_t* driver = NULL;
+  iree_host_size_t total_size = sizeof(*driver) + identifier.size;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, total_size, (void**)&driver));
+  iree_hal_resource_initialize(&iree_hal_metal_driver_vtable,
+                               &driver->resource);
+  driver->host_allocator = host_allocator;
+  iree_string_view_append_to_buffer(
+      identifier, &driver->identifier,
+      (char*)driver + total_size - identifier.size);
+  driver->default_device_options = options->default_device_options;
+  *out_driver = (iree_hal_driver_t*)driver;
+
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+static void iree_hal_metal_driver_destroy(iree_hal_driver_t* base_driver) {
+  iree_hal_metal_driver_t* driver = iree_hal_metal_driver_cast(base_driver);
+  iree_allocator_t host_allocator = driver->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_allocator_free(host_allocator, driver);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+// Returns a retained array of all Metal devices in the system.
+// Only macOS supports multiple devices; elsewhere there is only the default.
+static NSArray<id<MTLDevice>>* iree_hal_metal_copy_all_devices(void) {
+#if TARGET_OS_OSX
+  return MTLCopyAllDevices();
+#else
+  id<MTLDevice> device = MTLCreateSystemDefaultDevice();
+  if (!device) return [[NSArray alloc] init];
+  NSArray<id<MTLDevice>>* devices =
+      [[NSArray alloc] initWithObjects:device, nil];
+  [device release];
+  return devices;
+#endif  // TARGET_OS_OSX
+}
+
+static iree_status_t iree_hal_metal_driver_query_available_devices(
+    iree_hal_driver_t* base_driver, iree_allocator_t host_allocator,
+    iree_hal_device_info_t** out_device_infos,
+    iree_host_size_t* out_device_info_count) {
+  NSArray<id<MTLDevice>>* devices = iree_hal_metal_copy_all_devices();
+  iree_host_size_t device_count = devices.count;
+
+  // Allocate the return infos with the device names appended.
+  iree_host_size_t total_size = device_count * sizeof(iree_hal_device_info_t);
+  for (id<MTLDevice> device in devices) {
+    total_size += strlen(device.name.UTF8String);
+  }
+  iree_hal_device_info_t* device_infos = NULL;
+  iree_status_t status =
+      iree_allocator_malloc(host_allocator, total_size, (void**)&device_infos);
+  if (iree_status_is_ok(status)) {
+    char* buffer_ptr =
+        (char*)device_infos + device_count * sizeof(*device_infos);
+    for (iree_host_size_t i = 0; i < device_count; ++i) {
+      id<MTLDevice> device = devices[i];
+      memset(&device_infos[i], 0, sizeof(device_infos[i]));
+      // Registry IDs are stable for the lifetime of the system and never 0.
+      device_infos[i].device_id = (iree_hal_device_id_t)device.registryID;
+      buffer_ptr += iree_string_view_append_to_buffer(
+          iree_make_cstring_view(device.name.UTF8String),
+          &device_infos[i].name, buffer_ptr);
+    }
+    *out_device_info_count = device_count;
+    *out_device_infos = device_infos;
+  }
+  [devices release];
+  return status;
+}
+
+static iree_status_t iree_hal_metal_driver_create_device(
+    iree_hal_driver_t* base_driver, iree_hal_device_id_t device_id,
+    iree_allocator_t host_allocator, iree_hal_device_t** out_device) {
+  iree_hal_metal_driver_t* driver = iree_hal_metal_driver_cast(base_driver);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Use either the specified device (enumerated earlier) or the system
+  // default.
+  id<MTLDevice> device = nil;
+  if (device_id == IREE_HAL_DEVICE_ID_INVALID) {
+    device = MTLCreateSystemDefaultDevice();
+  } else {
+    NSArray<id<MTLDevice>>* devices = iree_hal_metal_copy_all_devices();
+    for (id<MTLDevice> candidate in devices) {
+      if ((iree_hal_device_id_t)candidate.registryID == device_id) {
+        device = [candidate retain];
+        break;
+      }
+    }
+    [devices release];
+  }
+  if (!device) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(IREE_STATUS_NOT_FOUND,
+                            "Metal device %016" PRIx64 " not found",
+                            (uint64_t)device_id);
+  }
+
+  iree_string_view_t device_name = iree_make_cstring_view("metal");
+  iree_status_t status = iree_hal_metal_wrap_device(
+      device_name, &driver->default_device_options, device, host_allocator,
+      out_device);
+  [device release];
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static const iree_hal_driver_vtable_t iree_hal_metal_driver_vtable = {
+    .destroy = iree_hal_metal_driver_destroy,
+    .query_available_devices = iree_hal_metal_driver_query_available_devices,
+    .create_device = iree_hal_metal_driver_create_device,
+};
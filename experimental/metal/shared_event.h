@@ -0,0 +1,42 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_METAL_SHARED_EVENT_H_
+#define IREE_HAL_METAL_SHARED_EVENT_H_
+
+#import <Metal/Metal.h>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Creates a timeline semaphore backed by an MTLSharedEvent.
+//
+// The event value is the semaphore payload: command buffers wait on and signal
+// it on the GPU timeline and the host signals it directly. Host waits register
+// notifications on |listener|, which is shared by all semaphores of a device.
+iree_status_t iree_hal_metal_shared_event_create(
+    id<MTLDevice> device, MTLSharedEventListener* listener,
+    uint64_t initial_value, iree_allocator_t host_allocator,
+    iree_hal_semaphore_t** out_semaphore);
+
+// Returns the MTLSharedEvent handle of the semaphore.
+id<MTLSharedEvent> iree_hal_metal_shared_event_handle(
+    iree_hal_semaphore_t* semaphore);
+
+// Waits on all or any of the semaphores in |semaphore_list|.
+iree_status_t iree_hal_metal_shared_event_multi_wait(
+    iree_hal_wait_mode_t wait_mode,
+    const iree_hal_semaphore_list_t* semaphore_list, iree_timeout_t timeout);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_METAL_SHARED_EVENT_H_
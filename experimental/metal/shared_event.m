@@ -0,0 +1,243 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "experimental/metal/shared_event.h"
+
+#include <inttypes.h>
+#include <stddef.h>
+
+#include "iree/base/api.h"
+#include "iree/base/internal/atomics.h"
+#include "iree/base/tracing.h"
+
+// Event value signaled when a semaphore fails so that all waiters (including
+// GPU-side waits) are released; they then observe the failure status.
+#define IREE_HAL_METAL_SHARED_EVENT_FAILURE_VALUE UINT64_MAX
+
+typedef struct iree_hal_metal_shared_event_t {
+  iree_hal_resource_t resource;
+  iree_allocator_t host_allocator;
+  id<MTLSharedEvent> handle;
+  MTLSharedEventListener* listener;
+  // First failure of the semaphore (iree_status_t); OK while not failed.
+  iree_atomic_intptr_t failure_status;
+} iree_hal_metal_shared_event_t;
+
+static const iree_hal_semaphore_vtable_t iree_hal_metal_shared_event_vtable;
+
+static iree_hal_metal_shared_event_t* iree_hal_metal_shared_event_cast(
+    iree_hal_semaphore_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_hal_metal_shared_event_vtable);
+  return (iree_hal_metal_shared_event_t*)base_value;
+}
+
+iree_status_t iree_hal_metal_shared_event_create(
+    id<MTLDevice> device, MTLSharedEventListener* listener,
+    uint64_t initial_value, iree_allocator_t host_allocator,
+    iree_hal_semaphore_t** out_semaphore) {
+  IREE_ASSERT_ARGUMENT(device);
+  IREE_ASSERT_ARGUMENT(listener);
+  IREE_ASSERT_ARGUMENT(out_semaphore);
+  *out_semaphore = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  id<MTLSharedEvent> handle = [device newSharedEvent];
+  if (!handle) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                            "failed to create a shared event");
+  }
+  handle.signaledValue = initial_value;
+
+  iree_hal_metal_shared_event_t* semaphore = NULL;
+  iree_status_t status = iree_allocator_malloc(
+      host_allocator, sizeof(*semaphore), (void**)&semaphore);
+  if (iree_status_is_ok(status)) {
+    iree_hal_resource_initialize(&iree_hal_metal_shared_event_vtable,
+                                 &semaphore->resource);
+    semaphore->host_allocator = host_allocator;
+    semaphore->handle = handle;
+    semaphore->listener = [listener retain];
+    iree_atomic_store_intptr(&semaphore->failure_status,
+                             (intptr_t)iree_ok_status(),
+                             iree_memory_order_relaxed);
+    *out_semaphore = (iree_hal_semaphore_t*)semaphore;
+  } else {
+    [handle release];
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_metal_shared_event_destroy(
+    iree_hal_semaphore_t* base_semaphore) {
+  iree_hal_metal_shared_event_t* semaphore =
+      iree_hal_metal_shared_event_cast(base_semaphore);
+  iree_allocator_t host_allocator = semaphore->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  [semaphore->handle release];
+  [semaphore->listener release];
+  iree_status_ignore((iree_status_t)iree_atomic_load_intptr(
+      &semaphore->failure_status, iree_memory_order_acquire));
+  iree_allocator_free(host_allocator, semaphore);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+id<MTLSharedEvent> iree_hal_metal_shared_event_handle(
+    iree_hal_semaphore_t* base_semaphore) {
+  iree_hal_metal_shared_event_t* semaphore =
+      iree_hal_metal_shared_event_cast(base_semaphore);
+  return semaphore->handle;
+}
+
+static iree_status_t iree_hal_metal_shared_event_query(
+    iree_hal_semaphore_t* base_semaphore, uint64_t* out_value) {
+  iree_hal_metal_shared_event_t* semaphore =
+      iree_hal_metal_shared_event_cast(base_semaphore);
+  *out_value = semaphore->handle.signaledValue;
+  iree_status_t failure_status = (iree_status_t)iree_atomic_load_intptr(
+      &semaphore->failure_status, iree_memory_order_acquire);
+  if (!iree_status_is_ok(failure_status)) {
+    return iree_status_clone(failure_status);
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_metal_shared_event_signal(
+    iree_hal_semaphore_t* base_semaphore, uint64_t new_value) {
+  iree_hal_metal_shared_event_t* semaphore =
+      iree_hal_metal_shared_event_cast(base_semaphore);
+  uint64_t old_value = semaphore->handle.signaledValue;
+  if (new_value <= old_value) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "semaphore values must be monotonically "
+                            "increasing; current value is %" PRIu64
+                            " and new value is %" PRIu64,
+                            old_value, new_value);
+  }
+  semaphore->handle.signaledValue = new_value;
+  return iree_ok_status();
+}
+
+static void iree_hal_metal_shared_event_fail(
+    iree_hal_semaphore_t* base_semaphore, iree_status_t status) {
+  iree_hal_metal_shared_event_t* semaphore =
+      iree_hal_metal_shared_event_cast(base_semaphore);
+  iree_status_t old_status = iree_ok_status();
+  if (!iree_atomic_compare_exchange_strong_intptr(
+          &semaphore->failure_status, (intptr_t*)&old_status,
+          (intptr_t)status, iree_memory_order_acq_rel,
+          iree_memory_order_relaxed)) {
+    // Previous status was not OK; drop our new status.
+    IREE_IGNORE_ERROR(status);
+    return;
+  }
+  // Release all waiters; they check the failure status when woken.
+  semaphore->handle.signaledValue = IREE_HAL_METAL_SHARED_EVENT_FAILURE_VALUE;
+}
+
+// Returns true if |semaphore| has reached |value| and sets |out_status| to a
+// failure if the semaphore has failed.
+static bool iree_hal_metal_shared_event_is_reached(
+    iree_hal_metal_shared_event_t* semaphore, uint64_t value,
+    iree_status_t* out_status) {
+  if (iree_atomic_load_intptr(&semaphore->failure_status,
+                              iree_memory_order_acquire)) {
+    *out_status = iree_status_from_code(IREE_STATUS_ABORTED);
+    return true;
+  }
+  return semaphore->handle.signaledValue >= value;
+}
+
+// Converts |deadline_ns| to a dispatch time.
+static dispatch_time_t iree_hal_metal_deadline_to_dispatch_time(
+    iree_time_t deadline_ns) {
+  if (deadline_ns == IREE_TIME_INFINITE_FUTURE) return DISPATCH_TIME_FOREVER;
+  iree_time_t now_ns = iree_time_now();
+  if (deadline_ns <= now_ns) return DISPATCH_TIME_NOW;
+  return dispatch_time(DISPATCH_TIME_NOW, (int64_t)(deadline_ns - now_ns));
+}
+
+iree_status_t iree_hal_metal_shared_event_multi_wait(
+    iree_hal_wait_mode_t wait_mode,
+    const iree_hal_semaphore_list_t* semaphore_list, iree_timeout_t timeout) {
+  if (semaphore_list->count == 0) return iree_ok_status();
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // A single dispatch semaphore is signaled by the notification of any event
+  // reaching its payload; the waiter wakes and re-checks all of them.
+  iree_time_t deadline_ns = iree_timeout_as_deadline_ns(timeout);
+  dispatch_semaphore_t wake = dispatch_semaphore_create(0);
+  bool is_listening = false;
+  iree_status_t status = iree_ok_status();
+  for (;;) {
+    iree_host_size_t reached_count = 0;
+    for (iree_host_size_t i = 0; i < semaphore_list->count; ++i) {
+      iree_hal_metal_shared_event_t* semaphore =
+          iree_hal_metal_shared_event_cast(semaphore_list->semaphores[i]);
+      if (iree_hal_metal_shared_event_is_reached(
+              semaphore, semaphore_list->payload_values[i], &status)) {
+        ++reached_count;
+      }
+      if (!iree_status_is_ok(status)) break;
+    }
+    if (!iree_status_is_ok(status)) break;
+    if (reached_count == semaphore_list->count ||
+        (wait_mode == IREE_HAL_WAIT_MODE_ANY && reached_count > 0)) {
+      break;
+    }
+
+    // Register notifications once; events reached after the check above still
+    // fire their notification immediately.
+    if (!is_listening) {
+      for (iree_host_size_t i = 0; i < semaphore_list->count; ++i) {
+        iree_hal_metal_shared_event_t* semaphore =
+            iree_hal_metal_shared_event_cast(semaphore_list->semaphores[i]);
+        [semaphore->handle
+            notifyListener:semaphore->listener
+                   atValue:semaphore_list->payload_values[i]
+                     block:^(id<MTLSharedEvent> event, uint64_t value) {
+                       dispatch_semaphore_signal(wake);
+                     }];
+      }
+      is_listening = true;
+    }
+
+    if (dispatch_semaphore_wait(wake, iree_hal_metal_deadline_to_dispatch_time(
+                                          deadline_ns)) != 0) {
+      status = iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+      break;
+    }
+  }
+  // Pending notifications retain |wake| through their blocks.
+  dispatch_release(wake);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static iree_status_t iree_hal_metal_shared_event_wait(
+    iree_hal_semaphore_t* base_semaphore, uint64_t value,
+    iree_timeout_t timeout) {
+  iree_hal_semaphore_list_t semaphore_list = {
+      .count = 1,
+      .semaphores = &base_semaphore,
+      .payload_values = &value,
+  };
+  return iree_hal_metal_shared_event_multi_wait(IREE_HAL_WAIT_MODE_ALL,
+                                                &semaphore_list, timeout);
+}
+
+static const iree_hal_semaphore_vtable_t iree_hal_metal_shared_event_vtable = {
+    .destroy = iree_hal_metal_shared_event_destroy,
+    .query = iree_hal_metal_shared_event_query,
+    .signal = iree_hal_metal_shared_event_signal,
+    .fail = iree_hal_metal_shared_event_fail,
+    .wait = iree_hal_metal_shared_event_wait,
+};
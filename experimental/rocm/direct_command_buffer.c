@@ -26,6 +26,10 @@ typedef struct {
   iree_hal_command_buffer_t base;
   iree_hal_rocm_context_wrapper_t* context;
   iree_arena_block_pool_t* block_pool;
+  // Stream all commands are issued on as they are recorded.
+  hipStream_t stream;
+  // Optional device profiler that times dispatches.
+  iree_hal_rocm_dispatch_profiler_t* profiler;
 
   // Keep track of the current set of kernel arguments.
   int32_t push_constant[IREE_HAL_ROCM_MAX_PUSH_CONSTANT_COUNT];
@@ -51,7 +55,8 @@ iree_status_t iree_hal_rocm_direct_command_buffer_create(
     iree_hal_command_buffer_mode_t mode,
     iree_hal_command_category_t command_categories,
     iree_hal_queue_affinity_t queue_affinity,
-    iree_arena_block_pool_t* block_pool,
+    iree_arena_block_pool_t* block_pool, hipStream_t stream,
+    iree_hal_rocm_dispatch_profiler_t* profiler,
     iree_hal_command_buffer_t** out_command_buffer) {
   IREE_ASSERT_ARGUMENT(context);
   IREE_ASSERT_ARGUMENT(block_pool);
@@ -70,6 +75,8 @@ iree_status_t iree_hal_rocm_direct_command_buffer_create(
         &iree_hal_rocm_direct_command_buffer_vtable, &command_buffer->base);
     command_buffer->context = context;
     command_buffer->block_pool = block_pool;
+    command_buffer->stream = stream;
+    command_buffer->profiler = profiler;
     hipDeviceptr_t* device_ptrs =
         (hipDeviceptr_t*)(command_buffer->current_descriptor +
                           IREE_HAL_ROCM_MAX_KERNEL_ARG);
@@ -215,10 +222,9 @@ static iree_status_t iree_hal_rocm_direct_command_buffer_fill_buffer(
   hipDeviceptr_t dst = target_device_buffer + target_offset;
   int value = dword_pattern;
   size_t sizeBytes = length;
-  // TODO(raikonenfnu): Currently using NULL stream, need to figure out way to
-  // access proper stream from command buffer
   ROCM_RETURN_IF_ERROR(command_buffer->context->syms,
-                       hipMemsetAsync(dst, value, sizeBytes, 0),
+                       hipMemsetAsync(dst, value, sizeBytes,
+                                      command_buffer->stream),
                        "hipMemsetAsync");
   return iree_ok_status();
 }
@@ -245,12 +251,10 @@ static iree_status_t iree_hal_rocm_direct_command_buffer_copy_buffer(
   hipDeviceptr_t source_device_buffer = iree_hal_rocm_buffer_device_pointer(
       iree_hal_buffer_allocated_buffer(source_buffer));
   source_offset += iree_hal_buffer_byte_offset(source_buffer);
-  // TODO(raikonenfnu): Currently using NULL stream, need to figure out way to
-  // access proper stream from command buffer
   ROCM_RETURN_IF_ERROR(
       command_buffer->context->syms,
       hipMemcpyAsync(target_device_buffer, source_device_buffer, length,
-                     hipMemcpyDeviceToDevice, 0),
+                     hipMemcpyDeviceToDevice, command_buffer->stream),
       "hipMemcpyAsync");
   return iree_ok_status();
 }
@@ -353,15 +357,25 @@ static iree_status_t iree_hal_rocm_direct_command_buffer_dispatch(
       executable, entry_point, &block_size_x, &block_size_y, &block_size_z));
   hipFunction_t func =
       iree_hal_rocm_native_executable_for_entry_point(executable, entry_point);
-  // TODO(raikonenfnu): Currently using NULL stream, need to figure out way to
-  // access proper stream from command buffer
-  ROCM_RETURN_IF_ERROR(
+  const uint32_t workgroup_count[3] = {workgroup_x, workgroup_y, workgroup_z};
+  uint32_t profile_slot = iree_hal_rocm_dispatch_profiler_record_begin(
+      command_buffer->profiler, command_buffer->stream, executable,
+      entry_point, workgroup_count);
+  iree_status_t status = ROCM_RESULT_TO_STATUS(
       command_buffer->context->syms,
       hipModuleLaunchKernel(func, workgroup_x, workgroup_y, workgroup_z,
-                            block_size_x, block_size_y, block_size_z, 0, 0,
+                            block_size_x, block_size_y, block_size_z, 0,
+                            command_buffer->stream,
                             command_buffer->current_descriptor, NULL),
       "hipModuleLaunchKernel");
-  return iree_ok_status();
+  if (iree_status_is_ok(status)) {
+    iree_hal_rocm_dispatch_profiler_record_end(
+        command_buffer->profiler, command_buffer->stream, profile_slot);
+  } else {
+    iree_hal_rocm_dispatch_profiler_record_abort(command_buffer->profiler,
+                                                 profile_slot);
+  }
+  return status;
 }
 
 static iree_status_t iree_hal_rocm_direct_command_buffer_dispatch_indirect(
@@ -8,6 +8,7 @@
 #define IREE_HAL_ROCM_DIRECT_COMMAND_BUFFER_H_
 
 #include "experimental/rocm/context_wrapper.h"
+#include "experimental/rocm/dispatch_profiler.h"
 #include "experimental/rocm/dynamic_symbols.h"
 #include "experimental/rocm/rocm_headers.h"
 #include "iree/base/api.h"
@@ -31,13 +32,16 @@ typedef struct {
   void** kernelParams;
 } hip_launch_params;
 
-// Creates a rocm direct command buffer.
+// Creates a rocm direct command buffer that issues commands on |stream| as
+// they are recorded. Dispatches are timed by |profiler| when it is active. The
+// |profiler| is optional and must outlive the command buffer if provided.
 iree_status_t iree_hal_rocm_direct_command_buffer_create(
     iree_hal_device_t* device, iree_hal_rocm_context_wrapper_t* context,
     iree_hal_command_buffer_mode_t mode,
     iree_hal_command_category_t command_categories,
     iree_hal_queue_affinity_t queue_affinity,
-    iree_arena_block_pool_t* block_pool,
+    iree_arena_block_pool_t* block_pool, hipStream_t stream,
+    iree_hal_rocm_dispatch_profiler_t* profiler,
     iree_hal_command_buffer_t** out_command_buffer);
 
 // Returns true if |command_buffer| is a ROCM command buffer.
@@ -0,0 +1,106 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_ROCM_DISPATCH_PROFILER_H_
+#define IREE_HAL_ROCM_DISPATCH_PROFILER_H_
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "experimental/rocm/context_wrapper.h"
+#include "experimental/rocm/rocm_headers.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Maximum number of profiled dispatches that may be outstanding between
+// flushes. Dispatches issued while the ring is full are reported as dropped.
+#define IREE_HAL_ROCM_DISPATCH_PROFILER_EVENT_CAPACITY 1024
+
+// Returned by iree_hal_rocm_dispatch_profiler_record_begin when the dispatch
+// is not being profiled.
+#define IREE_HAL_ROCM_DISPATCH_PROFILER_NO_SLOT UINT32_MAX
+
+// Implements the iree_hal_device_profiling_* API for ROCm devices by recording
+// a pair of timing events around each dispatch issued to the device stream.
+//
+// Each profiled dispatch acquires a slot in a ring of events when it is issued
+// and the elapsed times are queried without waiting when the device is
+// flushed; dispatches that have not yet completed are delivered by a later
+// flush. Times are measured relative to an event recorded on the device
+// stream when profiling begins and converted to iree_time_now() nanoseconds.
+// The precision of the absolute times decreases the longer profiling remains
+// active while durations are measured directly between each pair of events.
+//
+// Only dispatches issued by direct command buffers are timed. Graph command
+// buffers capture their commands into a graph that is launched as a whole so
+// dispatches executed as part of a graph are reported as dropped.
+//
+// Thread-safe: command buffers may issue from multiple threads.
+typedef struct iree_hal_rocm_dispatch_profiler_t
+    iree_hal_rocm_dispatch_profiler_t;
+
+// Allocates a profiler in the inactive state. The epoch of each profiling
+// session is recorded on |stream|. Events are created when profiling first
+// begins.
+iree_status_t iree_hal_rocm_dispatch_profiler_allocate(
+    iree_hal_rocm_context_wrapper_t* context, hipStream_t stream,
+    iree_hal_rocm_dispatch_profiler_t** out_profiler);
+
+// Frees |profiler| and its events. All work issued while profiling must have
+// completed.
+void iree_hal_rocm_dispatch_profiler_free(
+    iree_hal_rocm_dispatch_profiler_t* profiler);
+
+// Begins profiling as with iree_hal_device_profiling_begin.
+iree_status_t iree_hal_rocm_dispatch_profiler_begin(
+    iree_hal_rocm_dispatch_profiler_t* profiler,
+    const iree_hal_device_profiling_options_t* options);
+
+// Queries all completed dispatches and delivers them to the sink as with
+// iree_hal_device_profiling_flush.
+iree_status_t iree_hal_rocm_dispatch_profiler_flush(
+    iree_hal_rocm_dispatch_profiler_t* profiler);
+
+// Ends profiling as with iree_hal_device_profiling_end. Dispatches that have
+// not completed are dropped.
+iree_status_t iree_hal_rocm_dispatch_profiler_end(
+    iree_hal_rocm_dispatch_profiler_t* profiler);
+
+// Returns true if |profiler| is capturing dispatches. |profiler| may be NULL.
+bool iree_hal_rocm_dispatch_profiler_is_active(
+    iree_hal_rocm_dispatch_profiler_t* profiler);
+
+// Records the event preceding a dispatch of |entry_point| in |executable| on
+// |stream| if profiling is active. Returns the slot that must be passed to
+// iree_hal_rocm_dispatch_profiler_record_end after the kernel is launched or
+// IREE_HAL_ROCM_DISPATCH_PROFILER_NO_SLOT if not profiling. |profiler| may be
+// NULL.
+uint32_t iree_hal_rocm_dispatch_profiler_record_begin(
+    iree_hal_rocm_dispatch_profiler_t* profiler, hipStream_t stream,
+    iree_hal_executable_t* executable, int32_t entry_point,
+    const uint32_t workgroup_count[3]);
+
+// Records the event following the dispatch profiled in |slot| on |stream|.
+void iree_hal_rocm_dispatch_profiler_record_end(
+    iree_hal_rocm_dispatch_profiler_t* profiler, hipStream_t stream,
+    uint32_t slot);
+
+// Releases |slot| without recording the end event when the dispatch could not
+// be issued. The dispatch is reported as dropped.
+void iree_hal_rocm_dispatch_profiler_record_abort(
+    iree_hal_rocm_dispatch_profiler_t* profiler, uint32_t slot);
+
+// Reports |count| dispatches that executed while profiling but could not be
+// timed. |profiler| may be NULL.
+void iree_hal_rocm_dispatch_profiler_append_dropped(
+    iree_hal_rocm_dispatch_profiler_t* profiler, iree_host_size_t count);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_ROCM_DISPATCH_PROFILER_H_
@@ -26,10 +26,16 @@ RC_PFN_DECL(hipModuleLaunchKernel, hipFunction_t, unsigned int, unsigned int,
             unsigned int, hipStream_t, void **, void **)
 RC_PFN_DECL(hipMemset, void *, int, size_t)
 RC_PFN_DECL(hipMemsetAsync, void *, int, size_t, hipStream_t)
+RC_PFN_DECL(hipMemsetD32Async, hipDeviceptr_t, int, size_t, hipStream_t)
+RC_PFN_DECL(hipMemsetD16Async, hipDeviceptr_t, unsigned short, size_t,
+            hipStream_t)
+RC_PFN_DECL(hipMemsetD8Async, hipDeviceptr_t, unsigned char, size_t,
+            hipStream_t)
 RC_PFN_DECL(hipMemcpy, void *, const void *, size_t, hipMemcpyKind)
 RC_PFN_DECL(hipMemcpyAsync, void *, const void *, size_t, hipMemcpyKind,
             hipStream_t)
 RC_PFN_DECL(hipMalloc, void **, size_t)
+RC_PFN_DECL(hipMallocAsync, void **, size_t, hipStream_t)
 RC_PFN_DECL(hipMallocManaged, hipDeviceptr_t *, size_t, unsigned int)
 RC_PFN_DECL(hipFree, void *)
 RC_PFN_DECL(hipHostFree, void *)
@@ -44,3 +50,16 @@ RC_PFN_DECL(hipStreamCreateWithFlags, hipStream_t *, unsigned int)
 RC_PFN_DECL(hipStreamDestroy, hipStream_t)
 RC_PFN_DECL(hipStreamSynchronize, hipStream_t)
 RC_PFN_DECL(hipStreamWaitEvent, hipStream_t, hipEvent_t, unsigned int)
+RC_PFN_DECL(hipStreamBeginCapture, hipStream_t, hipStreamCaptureMode)
+RC_PFN_DECL(hipStreamEndCapture, hipStream_t, hipGraph_t *)
+RC_PFN_DECL(hipEventCreateWithFlags, hipEvent_t *, unsigned int)
+RC_PFN_DECL(hipEventDestroy, hipEvent_t)
+RC_PFN_DECL(hipEventElapsedTime, float *, hipEvent_t, hipEvent_t)
+RC_PFN_DECL(hipEventQuery, hipEvent_t)
+RC_PFN_DECL(hipEventRecord, hipEvent_t, hipStream_t)
+RC_PFN_DECL(hipEventSynchronize, hipEvent_t)
+RC_PFN_DECL(hipGraphDestroy, hipGraph_t)
+RC_PFN_DECL(hipGraphExecDestroy, hipGraphExec_t)
+RC_PFN_DECL(hipGraphInstantiate, hipGraphExec_t *, hipGraph_t, hipGraphNode_t *,
+            char *, size_t)
+RC_PFN_DECL(hipGraphLaunch, hipGraphExec_t, hipStream_t)
@@ -6,15 +6,52 @@
 
 #include "experimental/rocm/event_semaphore.h"
 
+#include <inttypes.h>
 #include <stddef.h>
+#include <string.h>
 
+#include "experimental/rocm/status_util.h"
 #include "iree/base/api.h"
+#include "iree/base/internal/synchronization.h"
 #include "iree/base/tracing.h"
 
+// Maximum number of device signals that may be pending on a single semaphore.
+// When exceeded the oldest signal is waited on from the host before a new one
+// is recorded.
+#define IREE_HAL_ROCM_SEMAPHORE_MAX_TIMEPOINTS 16
+
+// Sentinel used the semaphore has failed and an error status is set.
+#define IREE_HAL_ROCM_SEMAPHORE_FAILURE_VALUE UINT64_MAX
+
+// A pending signal of the semaphore to |value| when |event| completes.
+typedef struct iree_hal_rocm_timepoint_t {
+  uint64_t value;
+  hipEvent_t event;
+} iree_hal_rocm_timepoint_t;
+
 typedef struct iree_hal_rocm_semaphore_t {
   iree_hal_resource_t resource;
   iree_hal_rocm_context_wrapper_t* context;
-  uint64_t initial_value;
+
+  // Guards all mutable fields. Events in |timepoints| are only destroyed while
+  // holding the mutex.
+  iree_slim_mutex_t mutex;
+
+  // Posted when |current_value| changes or the semaphore fails.
+  iree_notification_t notification;
+
+  // Current signaled value. May be IREE_HAL_ROCM_SEMAPHORE_FAILURE_VALUE to
+  // indicate that the semaphore has been signaled for failure and
+  // |failure_status| contains the error.
+  uint64_t current_value;
+
+  // OK or the status passed to iree_hal_semaphore_fail. Owned by the semaphore.
+  iree_status_t failure_status;
+
+  // Signals recorded on device streams that have not yet been observed as
+  // complete, in increasing value order.
+  iree_host_size_t timepoint_count;
+  iree_hal_rocm_timepoint_t timepoints[IREE_HAL_ROCM_SEMAPHORE_MAX_TIMEPOINTS];
 } iree_hal_rocm_semaphore_t;
 
 static const iree_hal_semaphore_vtable_t iree_hal_rocm_semaphore_vtable;
@@ -39,7 +76,11 @@ iree_status_t iree_hal_rocm_semaphore_create(
     iree_hal_resource_initialize(&iree_hal_rocm_semaphore_vtable,
                                  &semaphore->resource);
     semaphore->context = context;
-    semaphore->initial_value = initial_value;
+    iree_slim_mutex_initialize(&semaphore->mutex);
+    iree_notification_initialize(&semaphore->notification);
+    semaphore->current_value = initial_value;
+    semaphore->failure_status = iree_ok_status();
+    semaphore->timepoint_count = 0;
     *out_semaphore = (iree_hal_semaphore_t*)semaphore;
   }
 
@@ -54,34 +95,267 @@ static void iree_hal_rocm_semaphore_destroy(
   iree_allocator_t host_allocator = semaphore->context->host_allocator;
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  // Destroying an event that has not completed is deferred by the runtime.
+  for (iree_host_size_t i = 0; i < semaphore->timepoint_count; ++i) {
+    ROCM_IGNORE_ERROR(semaphore->context->syms,
+                      hipEventDestroy(semaphore->timepoints[i].event));
+  }
+  iree_status_free(semaphore->failure_status);
+  iree_notification_deinitialize(&semaphore->notification);
+  iree_slim_mutex_deinitialize(&semaphore->mutex);
   iree_allocator_free(host_allocator, semaphore);
 
   IREE_TRACE_ZONE_END(z0);
 }
 
+// Retires the oldest |count| timepoints and advances the current value to the
+// last of them. The semaphore mutex must be held.
+static void iree_hal_rocm_semaphore_retire_timepoints_unsafe(
+    iree_hal_rocm_semaphore_t* semaphore, iree_host_size_t count) {
+  if (count == 0) return;
+  for (iree_host_size_t i = 0; i < count; ++i) {
+    ROCM_IGNORE_ERROR(semaphore->context->syms,
+                      hipEventDestroy(semaphore->timepoints[i].event));
+  }
+  uint64_t value = semaphore->timepoints[count - 1].value;
+  if (iree_status_is_ok(semaphore->failure_status) &&
+      value > semaphore->current_value) {
+    semaphore->current_value = value;
+  }
+  semaphore->timepoint_count -= count;
+  memmove(semaphore->timepoints, semaphore->timepoints + count,
+          semaphore->timepoint_count * sizeof(semaphore->timepoints[0]));
+  iree_notification_post(&semaphore->notification, IREE_ALL_WAITERS);
+}
+
+// Retires all timepoints whose events have completed on the device. Events on a
+// single stream complete in order so polling stops at the first pending one.
+// The semaphore mutex must be held.
+static void iree_hal_rocm_semaphore_poll_unsafe(
+    iree_hal_rocm_semaphore_t* semaphore) {
+  iree_host_size_t completed_count = 0;
+  while (completed_count < semaphore->timepoint_count &&
+         semaphore->context->syms->hipEventQuery(
+             semaphore->timepoints[completed_count].event) == hipSuccess) {
+    ++completed_count;
+  }
+  iree_hal_rocm_semaphore_retire_timepoints_unsafe(semaphore, completed_count);
+}
+
+// Returns the first pending timepoint that signals at least |value| or NULL if
+// the value will only be reached by a host signal. The semaphore mutex must be
+// held.
+static const iree_hal_rocm_timepoint_t*
+iree_hal_rocm_semaphore_find_timepoint_unsafe(
+    iree_hal_rocm_semaphore_t* semaphore, uint64_t value) {
+  for (iree_host_size_t i = 0; i < semaphore->timepoint_count; ++i) {
+    if (semaphore->timepoints[i].value >= value) {
+      return &semaphore->timepoints[i];
+    }
+  }
+  return NULL;
+}
+
 static iree_status_t iree_hal_rocm_semaphore_query(
     iree_hal_semaphore_t* base_semaphore, uint64_t* out_value) {
-  // TODO: Support semaphores completely.
-  *out_value = 0;
-  return iree_make_status(IREE_STATUS_UNIMPLEMENTED, "Not impemented on rocm");
+  iree_hal_rocm_semaphore_t* semaphore =
+      iree_hal_rocm_semaphore_cast(base_semaphore);
+
+  iree_slim_mutex_lock(&semaphore->mutex);
+
+  iree_hal_rocm_semaphore_poll_unsafe(semaphore);
+  *out_value = semaphore->current_value;
+
+  iree_status_t status = iree_ok_status();
+  if (*out_value >= IREE_HAL_ROCM_SEMAPHORE_FAILURE_VALUE) {
+    status = iree_status_clone(semaphore->failure_status);
+  }
+
+  iree_slim_mutex_unlock(&semaphore->mutex);
+
+  return status;
 }
 
 static iree_status_t iree_hal_rocm_semaphore_signal(
     iree_hal_semaphore_t* base_semaphore, uint64_t new_value) {
-  // TODO: Support semaphores completely. Return OK currently as everything is
-  // synchronized for each submit to allow things to run.
+  iree_hal_rocm_semaphore_t* semaphore =
+      iree_hal_rocm_semaphore_cast(base_semaphore);
+
+  iree_slim_mutex_lock(&semaphore->mutex);
+
+  if (new_value <= semaphore->current_value) {
+    uint64_t current_value IREE_ATTRIBUTE_UNUSED = semaphore->current_value;
+    iree_slim_mutex_unlock(&semaphore->mutex);
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "semaphore values must be monotonically "
+                            "increasing; current_value=%" PRIu64
+                            ", new_value=%" PRIu64,
+                            current_value, new_value);
+  }
+  semaphore->current_value = new_value;
+
+  iree_slim_mutex_unlock(&semaphore->mutex);
+
+  iree_notification_post(&semaphore->notification, IREE_ALL_WAITERS);
   return iree_ok_status();
 }
 
 static void iree_hal_rocm_semaphore_fail(iree_hal_semaphore_t* base_semaphore,
-                                         iree_status_t status) {}
+                                         iree_status_t status) {
+  iree_hal_rocm_semaphore_t* semaphore =
+      iree_hal_rocm_semaphore_cast(base_semaphore);
+
+  iree_slim_mutex_lock(&semaphore->mutex);
+
+  // Try to set our local status - we only preserve the first failure so only
+  // do this if we are going from a valid semaphore to a failed one.
+  if (!iree_status_is_ok(semaphore->failure_status)) {
+    // Previous status was not OK; drop our new status.
+    IREE_IGNORE_ERROR(status);
+    iree_slim_mutex_unlock(&semaphore->mutex);
+    return;
+  }
+
+  // Signal to our failure sentinel value.
+  semaphore->current_value = IREE_HAL_ROCM_SEMAPHORE_FAILURE_VALUE;
+  semaphore->failure_status = status;
+
+  iree_slim_mutex_unlock(&semaphore->mutex);
+
+  iree_notification_post(&semaphore->notification, IREE_ALL_WAITERS);
+}
 
 static iree_status_t iree_hal_rocm_semaphore_wait(
     iree_hal_semaphore_t* base_semaphore, uint64_t value,
     iree_timeout_t timeout) {
-  // TODO: Support semaphores completely. Return OK currently as everything is
-  // synchronized for each submit to allow things to run.
-  return iree_ok_status();
+  iree_hal_rocm_semaphore_t* semaphore =
+      iree_hal_rocm_semaphore_cast(base_semaphore);
+  iree_time_t deadline_ns = iree_timeout_as_deadline_ns(timeout);
+
+  iree_slim_mutex_lock(&semaphore->mutex);
+  while (true) {
+    iree_hal_rocm_semaphore_poll_unsafe(semaphore);
+    if (!iree_status_is_ok(semaphore->failure_status)) {
+      // Failed; return an error to tell callers to query for it.
+      iree_slim_mutex_unlock(&semaphore->mutex);
+      return iree_status_from_code(IREE_STATUS_ABORTED);
+    } else if (semaphore->current_value >= value) {
+      iree_slim_mutex_unlock(&semaphore->mutex);
+      return iree_ok_status();
+    } else if (iree_timeout_is_immediate(timeout)) {
+      iree_slim_mutex_unlock(&semaphore->mutex);
+      return iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+    }
+
+    const iree_hal_rocm_timepoint_t* timepoint =
+        iree_hal_rocm_semaphore_find_timepoint_unsafe(semaphore, value);
+    if (timepoint) {
+      // The value will be reached by work already submitted to the device.
+      // TODO(raikonenfnu): HIP doesn't support a deadline for event waits; the
+      // timeout is only honored for signals from the host.
+      iree_status_t status = ROCM_RESULT_TO_STATUS(
+          semaphore->context->syms, hipEventSynchronize(timepoint->event));
+      if (!iree_status_is_ok(status)) {
+        iree_slim_mutex_unlock(&semaphore->mutex);
+        return status;
+      }
+      continue;
+    }
+
+    // The value will be reached by a signal from the host.
+    iree_wait_token_t wait_token =
+        iree_notification_prepare_wait(&semaphore->notification);
+    iree_slim_mutex_unlock(&semaphore->mutex);
+    if (!iree_notification_commit_wait(&semaphore->notification, wait_token,
+                                       deadline_ns)) {
+      return iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+    }
+    iree_slim_mutex_lock(&semaphore->mutex);
+  }
+}
+
+iree_status_t iree_hal_rocm_semaphore_enqueue_signal(
+    iree_hal_semaphore_t* base_semaphore, uint64_t value, hipStream_t stream) {
+  iree_hal_rocm_semaphore_t* semaphore =
+      iree_hal_rocm_semaphore_cast(base_semaphore);
+  iree_hal_rocm_dynamic_symbols_t* syms = semaphore->context->syms;
+
+  hipEvent_t event = NULL;
+  ROCM_RETURN_IF_ERROR(
+      syms, hipEventCreateWithFlags(&event, hipEventDisableTiming),
+      "hipEventCreateWithFlags");
+  iree_status_t status =
+      ROCM_RESULT_TO_STATUS(syms, hipEventRecord(event, stream));
+  if (!iree_status_is_ok(status)) {
+    ROCM_IGNORE_ERROR(syms, hipEventDestroy(event));
+    return status;
+  }
+
+  iree_slim_mutex_lock(&semaphore->mutex);
+  uint64_t last_value =
+      semaphore->timepoint_count
+          ? semaphore->timepoints[semaphore->timepoint_count - 1].value
+          : semaphore->current_value;
+  if (value <= last_value) {
+    iree_slim_mutex_unlock(&semaphore->mutex);
+    ROCM_IGNORE_ERROR(syms, hipEventDestroy(event));
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "semaphore values must be monotonically "
+                            "increasing; last_value=%" PRIu64
+                            ", new_value=%" PRIu64,
+                            last_value, value);
+  }
+  if (semaphore->timepoint_count == IREE_HAL_ROCM_SEMAPHORE_MAX_TIMEPOINTS) {
+    // Make room by waiting for the oldest signal to complete.
+    status = ROCM_RESULT_TO_STATUS(
+        syms, hipEventSynchronize(semaphore->timepoints[0].event));
+    if (iree_status_is_ok(status)) {
+      iree_hal_rocm_semaphore_retire_timepoints_unsafe(semaphore, 1);
+    }
+  }
+  if (iree_status_is_ok(status)) {
+    semaphore->timepoints[semaphore->timepoint_count++] =
+        (iree_hal_rocm_timepoint_t){
+            .value = value,
+            .event = event,
+        };
+  } else {
+    ROCM_IGNORE_ERROR(syms, hipEventDestroy(event));
+  }
+  iree_slim_mutex_unlock(&semaphore->mutex);
+  return status;
+}
+
+iree_status_t iree_hal_rocm_semaphore_enqueue_wait(
+    iree_hal_semaphore_t* base_semaphore, uint64_t value, hipStream_t stream) {
+  iree_hal_rocm_semaphore_t* semaphore =
+      iree_hal_rocm_semaphore_cast(base_semaphore);
+
+  iree_slim_mutex_lock(&semaphore->mutex);
+  iree_hal_rocm_semaphore_poll_unsafe(semaphore);
+  if (!iree_status_is_ok(semaphore->failure_status)) {
+    iree_slim_mutex_unlock(&semaphore->mutex);
+    return iree_status_from_code(IREE_STATUS_ABORTED);
+  } else if (semaphore->current_value >= value) {
+    iree_slim_mutex_unlock(&semaphore->mutex);
+    return iree_ok_status();
+  }
+  const iree_hal_rocm_timepoint_t* timepoint =
+      iree_hal_rocm_semaphore_find_timepoint_unsafe(semaphore, value);
+  if (timepoint) {
+    // Order the stream after the signaling work without blocking the host.
+    iree_status_t status = ROCM_RESULT_TO_STATUS(
+        semaphore->context->syms,
+        hipStreamWaitEvent(stream, timepoint->event, /*flags=*/0));
+    iree_slim_mutex_unlock(&semaphore->mutex);
+    return status;
+  }
+  iree_slim_mutex_unlock(&semaphore->mutex);
+
+  // TODO(raikonenfnu): defer submissions waiting on host signals instead of
+  // blocking the submitting thread.
+  return iree_hal_rocm_semaphore_wait(base_semaphore, value,
+                                      iree_infinite_timeout());
 }
 
 static const iree_hal_semaphore_vtable_t iree_hal_rocm_semaphore_vtable = {
@@ -23,6 +23,19 @@ iree_status_t iree_hal_rocm_semaphore_create(
     iree_hal_rocm_context_wrapper_t* context, uint64_t initial_value,
     iree_hal_semaphore_t** out_semaphore);
 
+// Records an event on |stream| that signals |semaphore| to |value| once all
+// work previously enqueued on the stream has completed. The host is not
+// blocked.
+iree_status_t iree_hal_rocm_semaphore_enqueue_signal(
+    iree_hal_semaphore_t* semaphore, uint64_t value, hipStream_t stream);
+
+// Orders all work subsequently enqueued on |stream| after |semaphore| reaches
+// |value|. Values signaled by device work are waited on by the stream without
+// blocking the host; values that can only be reached by a signal from the host
+// are waited on before returning.
+iree_status_t iree_hal_rocm_semaphore_enqueue_wait(
+    iree_hal_semaphore_t* semaphore, uint64_t value, hipStream_t stream);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
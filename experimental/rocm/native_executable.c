@@ -7,6 +7,7 @@
 #include "experimental/rocm/native_executable.h"
 
 #include <stddef.h>
+#include <string.h>
 
 #include "experimental/rocm/dynamic_symbols.h"
 #include "experimental/rocm/executable_layout.h"
@@ -24,6 +25,8 @@ typedef struct iree_hal_rocm_native_executable_function_t {
   uint32_t block_size_x;
   uint32_t block_size_y;
   uint32_t block_size_z;
+  // Name of the kernel function; references storage owned by the executable.
+  iree_string_view_t name;
 } iree_hal_rocm_native_executable_function_t;
 
 typedef struct iree_hal_rocm_native_executable_t {
@@ -68,15 +71,25 @@ iree_status_t iree_hal_rocm_native_executable_create(
   iree_ROCMBlockSizeDef_vec_t block_sizes_vec =
       iree_ROCMExecutableDef_block_sizes_get(executable_def);
   iree_host_size_t entry_count = flatbuffers_string_vec_len(entry_points_vec);
+  // Entry point names are copied so that they remain available for profiling
+  // after the executable data is released.
+  iree_host_size_t total_name_length = 0;
+  for (iree_host_size_t i = 0; i < entry_count; i++) {
+    total_name_length += flatbuffers_string_len(
+        flatbuffers_string_vec_at(entry_points_vec, i));
+  }
   iree_host_size_t total_size =
       sizeof(*executable) +
       entry_count * sizeof(iree_hal_rocm_native_executable_function_t) +
-      entry_count * sizeof(iree_hal_executable_layout_t*);
+      entry_count * sizeof(iree_hal_executable_layout_t*) + total_name_length;
   iree_status_t status = iree_allocator_malloc(context->host_allocator,
                                                total_size, (void**)&executable);
   executable->executable_layouts =
       (void*)((char*)executable + sizeof(*executable) +
               entry_count * sizeof(iree_hal_rocm_native_executable_function_t));
+  char* name_storage =
+      (char*)executable->executable_layouts +
+      entry_count * sizeof(iree_hal_executable_layout_t*);
   hipModule_t module = NULL;
   if (iree_status_is_ok(status)) {
     status = ROCM_RESULT_TO_STATUS(
@@ -95,6 +108,11 @@ iree_status_t iree_hal_rocm_native_executable_create(
       executable->entry_functions[i].block_size_x = block_sizes_vec[i].x;
       executable->entry_functions[i].block_size_y = block_sizes_vec[i].y;
       executable->entry_functions[i].block_size_z = block_sizes_vec[i].z;
+      iree_host_size_t entry_name_length = flatbuffers_string_len(entry_name);
+      memcpy(name_storage, entry_name, entry_name_length);
+      executable->entry_functions[i].name =
+          iree_make_string_view(name_storage, entry_name_length);
+      name_storage += entry_name_length;
       executable->executable_layouts[i] =
           executable_spec->executable_layouts[i];
       iree_hal_executable_layout_retain(executable_spec->executable_layouts[i]);
@@ -115,6 +133,13 @@ iree_status_t iree_hal_rocm_native_executable_create(
   return status;
 }
 
+iree_string_view_t iree_hal_rocm_native_executable_entry_point_name(
+    iree_hal_executable_t* base_executable, int32_t entry_point) {
+  iree_hal_rocm_native_executable_t* executable =
+      iree_hal_rocm_native_executable_cast(base_executable);
+  return executable->entry_functions[entry_point].name;
+}
+
 hipFunction_t iree_hal_rocm_native_executable_for_entry_point(
     iree_hal_executable_t* base_executable, int32_t entry_point) {
   iree_hal_rocm_native_executable_t* executable =
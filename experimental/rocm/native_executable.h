@@ -25,6 +25,11 @@ iree_status_t iree_hal_rocm_native_executable_create(
     const iree_hal_executable_spec_t* executable_spec,
     iree_hal_executable_t** out_executable);
 
+// Returns the kernel function name of |entry_point|. The name remains valid for
+// the lifetime of the executable.
+iree_string_view_t iree_hal_rocm_native_executable_entry_point_name(
+    iree_hal_executable_t* executable, int32_t entry_point);
+
 hipFunction_t iree_hal_rocm_native_executable_for_entry_point(
     iree_hal_executable_t* executable, int32_t entry_point);
 
@@ -18,6 +18,8 @@ typedef struct iree_hal_rocm_allocator_t {
   iree_hal_resource_t resource;
   iree_hal_device_t* base_device;
   iree_hal_rocm_context_wrapper_t* context;
+  // Stream that stream-ordered allocations are made on.
+  hipStream_t stream;
 
   IREE_STATISTICS(iree_hal_allocator_statistics_t statistics;)
 } iree_hal_rocm_allocator_t;
@@ -32,7 +34,7 @@ static iree_hal_rocm_allocator_t* iree_hal_rocm_allocator_cast(
 
 iree_status_t iree_hal_rocm_allocator_create(
     iree_hal_device_t* base_device, iree_hal_rocm_context_wrapper_t* context,
-    iree_hal_allocator_t** out_allocator) {
+    hipStream_t stream, iree_hal_allocator_t** out_allocator) {
   IREE_ASSERT_ARGUMENT(base_device);
   IREE_ASSERT_ARGUMENT(context);
   IREE_TRACE_ZONE_BEGIN(z0);
@@ -44,6 +46,7 @@ iree_status_t iree_hal_rocm_allocator_create(
                                  &allocator->resource);
     allocator->context = context;
     allocator->base_device = base_device;
+    allocator->stream = stream;
     *out_allocator = (iree_hal_allocator_t*)allocator;
   }
 
@@ -204,6 +207,48 @@ static iree_status_t iree_hal_rocm_allocator_allocate_buffer(
   return status;
 }
 
+iree_status_t iree_hal_rocm_allocator_alloca(
+    iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_buffer_usage_t allowed_usage, iree_device_size_t allocation_size,
+    iree_hal_buffer_t** out_buffer) {
+  iree_hal_rocm_allocator_t* allocator =
+      iree_hal_rocm_allocator_cast(base_allocator);
+  if (!iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL) ||
+      iree_any_bit_set(memory_type, IREE_HAL_MEMORY_TYPE_HOST_VISIBLE)) {
+    return iree_hal_allocator_allocate_buffer(
+        base_allocator, memory_type, allowed_usage, allocation_size,
+        iree_const_byte_span_empty(), out_buffer);
+  }
+  if (allocation_size == 0) allocation_size = 4;
+
+  hipDeviceptr_t device_ptr = 0;
+  IREE_TRACE_ZONE_BEGIN_NAMED(z0, "iree_hal_rocm_buffer_alloca");
+  iree_status_t status = ROCM_RESULT_TO_STATUS(
+      allocator->context->syms,
+      hipMallocAsync(&device_ptr, allocation_size, allocator->stream));
+  IREE_TRACE_ZONE_END(z0);
+
+  // NOTE: stream-ordered allocations may be freed with hipFree and are
+  // released through the normal deallocate_buffer path.
+  iree_hal_buffer_t* buffer = NULL;
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_rocm_buffer_wrap(
+        base_allocator, memory_type, IREE_HAL_MEMORY_ACCESS_ALL, allowed_usage,
+        allocation_size, /*byte_offset=*/0, /*byte_length=*/allocation_size,
+        device_ptr, /*host_ptr=*/NULL, &buffer);
+  }
+
+  if (iree_status_is_ok(status)) {
+    IREE_STATISTICS(iree_hal_allocator_statistics_record_alloc(
+        &allocator->statistics, memory_type, allocation_size));
+    *out_buffer = buffer;
+  } else if (device_ptr) {
+    iree_hal_rocm_buffer_free(allocator->context, memory_type, device_ptr,
+                              /*host_ptr=*/NULL);
+  }
+  return status;
+}
+
 static void iree_hal_rocm_allocator_deallocate_buffer(
     iree_hal_allocator_t* base_allocator, iree_hal_buffer_t* base_buffer) {
   iree_hal_rocm_allocator_t* allocator =
@@ -19,7 +19,16 @@ extern "C" {
 // Create a ROCM allocator.
 iree_status_t iree_hal_rocm_allocator_create(
     iree_hal_device_t* base_device, iree_hal_rocm_context_wrapper_t* context,
-    iree_hal_allocator_t** out_allocator);
+    hipStream_t stream, iree_hal_allocator_t** out_allocator);
+
+// Allocates a buffer ordered on the allocator stream. Device-local memory that
+// is not host-visible is allocated with hipMallocAsync such that memory
+// released by prior work on the stream can be reused without synchronizing
+// with the host. Other memory types are allocated immediately.
+iree_status_t iree_hal_rocm_allocator_alloca(
+    iree_hal_allocator_t* allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_buffer_usage_t allowed_usage, iree_device_size_t allocation_size,
+    iree_hal_buffer_t** out_buffer);
 
 #ifdef __cplusplus
 }  // extern "C"
@@ -13,16 +13,35 @@
 #include "experimental/rocm/context_wrapper.h"
 #include "experimental/rocm/descriptor_set_layout.h"
 #include "experimental/rocm/direct_command_buffer.h"
+#include "experimental/rocm/dispatch_profiler.h"
 #include "experimental/rocm/dynamic_symbols.h"
 #include "experimental/rocm/event_semaphore.h"
 #include "experimental/rocm/executable_layout.h"
+#include "experimental/rocm/graph_command_buffer.h"
 #include "experimental/rocm/nop_executable_cache.h"
 #include "experimental/rocm/rocm_allocator.h"
 #include "experimental/rocm/rocm_event.h"
 #include "experimental/rocm/status_util.h"
 #include "iree/base/internal/arena.h"
+#include "iree/base/internal/synchronization.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/utils/buffer_transfer.h"
+#include "iree/hal/utils/resource_set.h"
+
+// Interval at which semaphores are polled when waiting for any of several.
+#define IREE_HAL_ROCM_WAIT_ANY_POLL_INTERVAL_NS (50 * 1000)
+
+//===----------------------------------------------------------------------===//
+// iree_hal_rocm_submission_t
+//===----------------------------------------------------------------------===//
+
+// Work enqueued on the device stream that has not yet been observed as
+// complete. Retains the resources it uses until |event| has completed.
+typedef struct iree_hal_rocm_submission_t {
+  struct iree_hal_rocm_submission_t* next;
+  hipEvent_t event;
+  iree_hal_resource_set_t* resource_set;
+} iree_hal_rocm_submission_t;
 
 //===----------------------------------------------------------------------===//
 // iree_hal_rocm_device_t
@@ -47,6 +66,14 @@ typedef struct iree_hal_rocm_device_t {
   iree_hal_rocm_context_wrapper_t context_wrapper;
   iree_hal_allocator_t* device_allocator;
 
+  // Times dispatches issued by direct command buffers while profiling.
+  iree_hal_rocm_dispatch_profiler_t* dispatch_profiler;
+
+  // Guards the list of in-flight submissions.
+  iree_slim_mutex_t submission_mutex;
+  // In-flight submissions in the order they were enqueued on |stream|.
+  iree_hal_rocm_submission_t* submission_head;
+  iree_hal_rocm_submission_t* submission_tail;
 } iree_hal_rocm_device_t;
 
 static const iree_hal_device_vtable_t iree_hal_rocm_device_vtable;
@@ -57,16 +84,98 @@ static iree_hal_rocm_device_t* iree_hal_rocm_device_cast(
   return (iree_hal_rocm_device_t*)base_value;
 }
 
+// Releases the resources of all submissions that have completed. If |wait| is
+// true all submissions are assumed to have completed, such as after the stream
+// has been synchronized.
+static void iree_hal_rocm_device_retire_submissions(
+    iree_hal_rocm_device_t* device, bool wait) {
+  iree_hal_rocm_dynamic_symbols_t* syms = device->context_wrapper.syms;
+  iree_allocator_t host_allocator = device->context_wrapper.host_allocator;
+  iree_slim_mutex_lock(&device->submission_mutex);
+  while (device->submission_head) {
+    iree_hal_rocm_submission_t* submission = device->submission_head;
+    // Work on the stream completes in order so retiring stops at the first
+    // submission still in flight.
+    if (!wait && syms->hipEventQuery(submission->event) != hipSuccess) break;
+    device->submission_head = submission->next;
+    ROCM_IGNORE_ERROR(syms, hipEventDestroy(submission->event));
+    iree_hal_resource_set_free(submission->resource_set);
+    iree_allocator_free(host_allocator, submission);
+  }
+  if (!device->submission_head) device->submission_tail = NULL;
+  iree_slim_mutex_unlock(&device->submission_mutex);
+}
+
+// Retains |command_buffers| until all work enqueued on the device stream so far
+// has completed.
+static iree_status_t iree_hal_rocm_device_track_submission(
+    iree_hal_rocm_device_t* device, iree_host_size_t command_buffer_count,
+    iree_hal_command_buffer_t* const* command_buffers) {
+  iree_hal_rocm_dynamic_symbols_t* syms = device->context_wrapper.syms;
+  iree_hal_rocm_submission_t* submission = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_allocator_malloc(device->context_wrapper.host_allocator,
+                            sizeof(*submission), (void**)&submission));
+  submission->next = NULL;
+  submission->event = NULL;
+  submission->resource_set = NULL;
+  iree_status_t status = iree_hal_resource_set_allocate(
+      &device->block_pool, &submission->resource_set);
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_resource_set_insert(submission->resource_set,
+                                          command_buffer_count,
+                                          command_buffers);
+  }
+  if (iree_status_is_ok(status)) {
+    status = ROCM_RESULT_TO_STATUS(
+        syms,
+        hipEventCreateWithFlags(&submission->event, hipEventDisableTiming));
+  }
+  if (iree_status_is_ok(status)) {
+    status = ROCM_RESULT_TO_STATUS(
+        syms, hipEventRecord(submission->event, device->stream));
+  }
+  if (!iree_status_is_ok(status)) {
+    if (submission->event) {
+      ROCM_IGNORE_ERROR(syms, hipEventDestroy(submission->event));
+    }
+    if (submission->resource_set) {
+      iree_hal_resource_set_free(submission->resource_set);
+    }
+    iree_allocator_free(device->context_wrapper.host_allocator, submission);
+    return status;
+  }
+
+  iree_slim_mutex_lock(&device->submission_mutex);
+  if (device->submission_tail) {
+    device->submission_tail->next = submission;
+  } else {
+    device->submission_head = submission;
+  }
+  device->submission_tail = submission;
+  iree_slim_mutex_unlock(&device->submission_mutex);
+  return iree_ok_status();
+}
+
 static void iree_hal_rocm_device_destroy(iree_hal_device_t* base_device) {
   iree_hal_rocm_device_t* device = iree_hal_rocm_device_cast(base_device);
   iree_allocator_t host_allocator = iree_hal_device_host_allocator(base_device);
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  // Wait for all in-flight work and release the resources it retains.
+  ROCM_IGNORE_ERROR(device->context_wrapper.syms,
+                    hipStreamSynchronize(device->stream));
+  iree_hal_rocm_device_retire_submissions(device, /*wait=*/true);
+  iree_slim_mutex_deinitialize(&device->submission_mutex);
+  iree_hal_rocm_dispatch_profiler_free(device->dispatch_profiler);
+
   // There should be no more buffers live that use the allocator.
   iree_hal_allocator_release(device->device_allocator);
   ROCM_IGNORE_ERROR(device->context_wrapper.syms,
                     hipStreamDestroy(device->stream));
 
+  iree_arena_block_pool_deinitialize(&device->block_pool);
+
   // Finally, destroy the device.
   iree_hal_driver_release(device->driver);
 
@@ -96,9 +205,16 @@ static iree_status_t iree_hal_rocm_device_create_internal(
   device->context_wrapper.rocm_context = context;
   device->context_wrapper.host_allocator = host_allocator;
   device->context_wrapper.syms = syms;
+  iree_arena_block_pool_initialize(32 * 1024, host_allocator,
+                                   &device->block_pool);
+  iree_slim_mutex_initialize(&device->submission_mutex);
   iree_status_t status = iree_hal_rocm_allocator_create(
-      (iree_hal_device_t*)device, &device->context_wrapper,
+      (iree_hal_device_t*)device, &device->context_wrapper, device->stream,
       &device->device_allocator);
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_rocm_dispatch_profiler_allocate(
+        &device->context_wrapper, device->stream, &device->dispatch_profiler);
+  }
   if (iree_status_is_ok(status)) {
     *out_device = (iree_hal_device_t*)device;
   } else {
@@ -187,7 +303,24 @@ static iree_status_t iree_hal_rocm_device_create_command_buffer(
     iree_hal_queue_affinity_t queue_affinity,
     iree_hal_command_buffer_t** out_command_buffer) {
   iree_hal_rocm_device_t* device = iree_hal_rocm_device_cast(base_device);
-  return iree_hal_rocm_direct_command_buffer_create(
+  if (iree_all_bits_set(mode,
+                        IREE_HAL_COMMAND_BUFFER_MODE_INDIRECT_BINDINGS)) {
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "indirect command buffer bindings not supported");
+  }
+  if (iree_all_bits_set(mode,
+                        IREE_HAL_COMMAND_BUFFER_MODE_ALLOW_INLINE_EXECUTION)) {
+    // The caller has indicated the command buffer can be executed as it is
+    // recorded, implying that the command buffer cannot be reused and doesn't
+    // need to be persisted. Commands are issued directly on the device stream.
+    return iree_hal_rocm_direct_command_buffer_create(
+        base_device, &device->context_wrapper, mode, command_categories,
+        queue_affinity, &device->block_pool, device->stream,
+        device->dispatch_profiler, out_command_buffer);
+  }
+  // Graphs amortize the launch overhead of all recorded commands into a single
+  // launch per submission.
+  return iree_hal_rocm_graph_command_buffer_create(
       base_device, &device->context_wrapper, mode, command_categories,
       queue_affinity, &device->block_pool, out_command_buffer);
 }
@@ -247,20 +380,115 @@ static iree_status_t iree_hal_rocm_device_create_semaphore(
                                         out_semaphore);
 }
 
+// Orders all work subsequently enqueued on the device stream after all
+// semaphores in |semaphore_list| reach their payload values.
+static iree_status_t iree_hal_rocm_device_enqueue_waits(
+    iree_hal_rocm_device_t* device,
+    const iree_hal_semaphore_list_t* semaphore_list) {
+  for (iree_host_size_t i = 0; i < semaphore_list->count; ++i) {
+    IREE_RETURN_IF_ERROR(iree_hal_rocm_semaphore_enqueue_wait(
+        semaphore_list->semaphores[i], semaphore_list->payload_values[i],
+        device->stream));
+  }
+  return iree_ok_status();
+}
+
+// Signals all semaphores in |semaphore_list| to their payload values once all
+// work enqueued on the device stream so far has completed.
+static iree_status_t iree_hal_rocm_device_enqueue_signals(
+    iree_hal_rocm_device_t* device,
+    const iree_hal_semaphore_list_t* semaphore_list) {
+  for (iree_host_size_t i = 0; i < semaphore_list->count; ++i) {
+    IREE_RETURN_IF_ERROR(iree_hal_rocm_semaphore_enqueue_signal(
+        semaphore_list->semaphores[i], semaphore_list->payload_values[i],
+        device->stream));
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_rocm_device_queue_alloca(
+    iree_hal_device_t* base_device, iree_hal_queue_affinity_t queue_affinity,
+    const iree_hal_semaphore_list_t wait_semaphore_list,
+    const iree_hal_semaphore_list_t signal_semaphore_list,
+    iree_hal_memory_type_t memory_type, iree_hal_buffer_usage_t allowed_usage,
+    iree_device_size_t allocation_size, iree_hal_buffer_t** out_buffer) {
+  iree_hal_rocm_device_t* device = iree_hal_rocm_device_cast(base_device);
+  IREE_RETURN_IF_ERROR(
+      iree_hal_rocm_device_enqueue_waits(device, &wait_semaphore_list));
+  iree_hal_buffer_t* buffer = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_rocm_allocator_alloca(
+      device->device_allocator, memory_type, allowed_usage, allocation_size,
+      &buffer));
+  iree_status_t status =
+      iree_hal_rocm_device_enqueue_signals(device, &signal_semaphore_list);
+  if (iree_status_is_ok(status)) {
+    *out_buffer = buffer;
+  } else {
+    iree_hal_buffer_release(buffer);
+  }
+  return status;
+}
+
+static iree_status_t iree_hal_rocm_device_queue_dealloca(
+    iree_hal_device_t* base_device, iree_hal_queue_affinity_t queue_affinity,
+    const iree_hal_semaphore_list_t wait_semaphore_list,
+    const iree_hal_semaphore_list_t signal_semaphore_list,
+    iree_hal_buffer_t* buffer) {
+  // The memory is returned when the last reference is released. Command
+  // buffers using the buffer retain it until their submission has completed.
+  iree_hal_rocm_device_t* device = iree_hal_rocm_device_cast(base_device);
+  IREE_RETURN_IF_ERROR(
+      iree_hal_rocm_device_enqueue_waits(device, &wait_semaphore_list));
+  return iree_hal_rocm_device_enqueue_signals(device, &signal_semaphore_list);
+}
+
 static iree_status_t iree_hal_rocm_device_queue_submit(
     iree_hal_device_t* base_device,
     iree_hal_command_category_t command_categories,
     iree_hal_queue_affinity_t queue_affinity, iree_host_size_t batch_count,
     const iree_hal_submission_batch_t* batches) {
   iree_hal_rocm_device_t* device = iree_hal_rocm_device_cast(base_device);
-  // TODO(raikonenfnu): Once semaphore is implemented wait for semaphores
-  // TODO(thomasraoux): implement semaphores - for now this conservatively
-  // synchronizes after every submit.
-  // TODO(raikonenfnu): currently run on default/null stream, when cmd buffer
-  // stream work with device->stream, we'll change
-  ROCM_RETURN_IF_ERROR(device->context_wrapper.syms, hipStreamSynchronize(0),
-                       "hipStreamSynchronize");
-  return iree_ok_status();
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Release the resources of prior submissions that have since completed.
+  iree_hal_rocm_device_retire_submissions(device, /*wait=*/false);
+
+  iree_status_t status = iree_ok_status();
+  for (iree_host_size_t i = 0; i < batch_count && iree_status_is_ok(status);
+       i++) {
+    const iree_hal_submission_batch_t* batch = &batches[i];
+    status =
+        iree_hal_rocm_device_enqueue_waits(device, &batch->wait_semaphores);
+    for (iree_host_size_t j = 0;
+         j < batch->command_buffer_count && iree_status_is_ok(status); j++) {
+      iree_hal_command_buffer_t* command_buffer = batch->command_buffers[j];
+      if (iree_hal_rocm_graph_command_buffer_isa(command_buffer)) {
+        hipGraphExec_t exec =
+            iree_hal_rocm_graph_command_buffer_exec(command_buffer);
+        status = ROCM_RESULT_TO_STATUS(device->context_wrapper.syms,
+                                       hipGraphLaunch(exec, device->stream));
+        if (iree_status_is_ok(status)) {
+          iree_hal_rocm_dispatch_profiler_append_dropped(
+              device->dispatch_profiler,
+              iree_hal_rocm_graph_command_buffer_dispatch_count(
+                  command_buffer));
+        }
+      }
+      // Nothing to do for an inline command buffer; all the work has already
+      // been issued on the device stream.
+    }
+    if (iree_status_is_ok(status) && batch->command_buffer_count > 0) {
+      status = iree_hal_rocm_device_track_submission(
+          device, batch->command_buffer_count, batch->command_buffers);
+    }
+    if (iree_status_is_ok(status)) {
+      status = iree_hal_rocm_device_enqueue_signals(device,
+                                                    &batch->signal_semaphores);
+    }
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
 }
 
 static iree_status_t iree_hal_rocm_device_submit_and_wait(
@@ -281,8 +509,34 @@ static iree_status_t iree_hal_rocm_device_submit_and_wait(
 static iree_status_t iree_hal_rocm_device_wait_semaphores(
     iree_hal_device_t* base_device, iree_hal_wait_mode_t wait_mode,
     const iree_hal_semaphore_list_t* semaphore_list, iree_timeout_t timeout) {
-  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
-                          "semaphore not implemented");
+  if (!semaphore_list || semaphore_list->count == 0) return iree_ok_status();
+  iree_time_t deadline_ns = iree_timeout_as_deadline_ns(timeout);
+
+  if (wait_mode == IREE_HAL_WAIT_MODE_ALL || semaphore_list->count == 1) {
+    for (iree_host_size_t i = 0; i < semaphore_list->count; ++i) {
+      IREE_RETURN_IF_ERROR(iree_hal_semaphore_wait(
+          semaphore_list->semaphores[i], semaphore_list->payload_values[i],
+          iree_make_deadline(deadline_ns)));
+    }
+    return iree_ok_status();
+  }
+
+  // Semaphores may be signaled from the host or from different points on the
+  // device stream so waiting for any of them polls each in turn.
+  while (true) {
+    for (iree_host_size_t i = 0; i < semaphore_list->count; ++i) {
+      iree_status_t status = iree_hal_semaphore_wait(
+          semaphore_list->semaphores[i], semaphore_list->payload_values[i],
+          iree_immediate_timeout());
+      if (!iree_status_is_deadline_exceeded(status)) return status;
+    }
+    iree_time_t now_ns = iree_time_now();
+    if (now_ns >= deadline_ns) {
+      return iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+    }
+    iree_wait_until(iree_min(deadline_ns,
+                             now_ns + IREE_HAL_ROCM_WAIT_ANY_POLL_INTERVAL_NS));
+  }
 }
 
 static iree_status_t iree_hal_rocm_device_wait_idle(
@@ -294,9 +548,30 @@ static iree_status_t iree_hal_rocm_device_wait_idle(
   ROCM_RETURN_IF_ERROR(device->context_wrapper.syms,
                        hipStreamSynchronize(device->stream),
                        "hipStreamSynchronize");
+  iree_hal_rocm_device_retire_submissions(device, /*wait=*/true);
   return iree_ok_status();
 }
 
+static iree_status_t iree_hal_rocm_device_profiling_begin(
+    iree_hal_device_t* base_device,
+    const iree_hal_device_profiling_options_t* options) {
+  iree_hal_rocm_device_t* device = iree_hal_rocm_device_cast(base_device);
+  return iree_hal_rocm_dispatch_profiler_begin(device->dispatch_profiler,
+                                               options);
+}
+
+static iree_status_t iree_hal_rocm_device_profiling_flush(
+    iree_hal_device_t* base_device) {
+  iree_hal_rocm_device_t* device = iree_hal_rocm_device_cast(base_device);
+  return iree_hal_rocm_dispatch_profiler_flush(device->dispatch_profiler);
+}
+
+static iree_status_t iree_hal_rocm_device_profiling_end(
+    iree_hal_device_t* base_device) {
+  iree_hal_rocm_device_t* device = iree_hal_rocm_device_cast(base_device);
+  return iree_hal_rocm_dispatch_profiler_end(device->dispatch_profiler);
+}
+
 static const iree_hal_device_vtable_t iree_hal_rocm_device_vtable = {
     .destroy = iree_hal_rocm_device_destroy,
     .id = iree_hal_rocm_device_id,
@@ -313,8 +588,13 @@ static const iree_hal_device_vtable_t iree_hal_rocm_device_vtable = {
     .create_executable_layout = iree_hal_rocm_device_create_executable_layout,
     .create_semaphore = iree_hal_rocm_device_create_semaphore,
     .transfer_range = iree_hal_device_submit_transfer_range_and_wait,
+    .queue_alloca = iree_hal_rocm_device_queue_alloca,
+    .queue_dealloca = iree_hal_rocm_device_queue_dealloca,
     .queue_submit = iree_hal_rocm_device_queue_submit,
     .submit_and_wait = iree_hal_rocm_device_submit_and_wait,
     .wait_semaphores = iree_hal_rocm_device_wait_semaphores,
     .wait_idle = iree_hal_rocm_device_wait_idle,
+    .profiling_begin = iree_hal_rocm_device_profiling_begin,
+    .profiling_flush = iree_hal_rocm_device_profiling_flush,
+    .profiling_end = iree_hal_rocm_device_profiling_end,
 };
@@ -20,16 +20,6 @@ fi
 CMAKE_BIN=${CMAKE_BIN:-$(which cmake)}
 ROOT_DIR=$(git rev-parse --show-toplevel)
 
-BUILD_DIR=${ROOT_DIR?}/build-emscripten
-mkdir -p ${BUILD_DIR}
-
-BINARY_DIR=${BUILD_DIR}/experimental/sample_web_static/
-mkdir -p ${BINARY_DIR}
-
-###############################################################################
-# Compile from .mlir input to static C source files using host tools          #
-###############################################################################
-
 # TODO(scotttodd): portable path ... discover from python install if on $PATH?
 INSTALL_ROOT="D:\dev\projects\iree-build\install\bin"
 TRANSLATE_TOOL="${INSTALL_ROOT?}/iree-translate.exe"
@@ -37,48 +27,77 @@ EMBED_DATA_TOOL="${INSTALL_ROOT?}/generate_embed_data.exe"
 INPUT_NAME="mnist"
 INPUT_PATH="${ROOT_DIR?}/iree/samples/models/mnist.mlir"
 
-echo "=== Translating MLIR to static library output (.vmfb, .h, .o) ==="
-${TRANSLATE_TOOL?} ${INPUT_PATH} \
-  --iree-mlir-to-vm-bytecode-module \
-  --iree-input-type=mhlo \
-  --iree-hal-target-backends=llvm \
-  --iree-llvm-target-triple=wasm32-unknown-unknown \
-  --iree-llvm-link-embedded=false \
-  --iree-llvm-link-static \
-  --iree-llvm-static-library-output-path=${BINARY_DIR}/${INPUT_NAME}_static.o \
-  --o ${BINARY_DIR}/${INPUT_NAME}.vmfb
-
-echo "=== Embedding bytecode module (.vmfb) into C source files (.h, .c) ==="
-${EMBED_DATA_TOOL?} ${BINARY_DIR}/${INPUT_NAME}.vmfb \
-  --output_header=${BINARY_DIR}/${INPUT_NAME}_bytecode.h \
-  --output_impl=${BINARY_DIR}/${INPUT_NAME}_bytecode.c \
-  --identifier=iree_static_${INPUT_NAME} \
-  --flatten
-
-###############################################################################
-# Build the web artifacts using Emscripten                                    #
-###############################################################################
-
-echo "=== Building web artifacts using Emscripten ==="
-
-pushd ${ROOT_DIR?}/build-emscripten
-
-# Configure using Emscripten's CMake wrapper, then build.
-# Note: The sample creates a task device directly, so no drivers are required,
-#       but some targets are gated on specific CMake options.
-emcmake "${CMAKE_BIN?}" -G Ninja .. \
-  -DCMAKE_BUILD_TYPE=RelWithDebInfo \
-  -DIREE_HOST_BINARY_ROOT=$PWD/../build-host/install \
-  -DIREE_BUILD_EXPERIMENTAL_WEB_SAMPLES=ON \
-  -DIREE_HAL_DRIVER_DEFAULTS=OFF \
-  -DIREE_HAL_DRIVER_DYLIB=ON \
-  -DIREE_BUILD_COMPILER=OFF \
-  -DIREE_BUILD_TESTS=OFF
-
-"${CMAKE_BIN?}" --build . --target \
+# All code in a program using threads must be built with the wasm atomics and
+# bulk-memory features so the sync and multithreaded variants are built in
+# separate build directories. Both use 128-bit SIMD.
+#   build_variant BUILD_DIR CPU_FEATURES C_FLAGS TARGET
+build_variant() {
+  local BUILD_DIR=$1
+  local CPU_FEATURES=$2
+  local C_FLAGS=$3
+  local TARGET=$4
+
+  mkdir -p ${BUILD_DIR}
+  local BINARY_DIR=${BUILD_DIR}/experimental/sample_web_static/
+  mkdir -p ${BINARY_DIR}
+
+  #############################################################################
+  # Compile from .mlir input to static C source files using host tools        #
+  #############################################################################
+
+  echo "=== Translating MLIR to static library output (.vmfb, .h, .o) ==="
+  ${TRANSLATE_TOOL?} ${INPUT_PATH} \
+    --iree-mlir-to-vm-bytecode-module \
+    --iree-input-type=mhlo \
+    --iree-hal-target-backends=llvm \
+    --iree-llvm-target-triple=wasm32-unknown-unknown \
+    --iree-llvm-target-cpu-features=${CPU_FEATURES} \
+    --iree-llvm-link-embedded=false \
+    --iree-llvm-link-static \
+    --iree-llvm-static-library-output-path=${BINARY_DIR}/${INPUT_NAME}_static.o \
+    --o ${BINARY_DIR}/${INPUT_NAME}.vmfb
+
+  echo "=== Embedding bytecode module (.vmfb) into C source files (.h, .c) ==="
+  ${EMBED_DATA_TOOL?} ${BINARY_DIR}/${INPUT_NAME}.vmfb \
+    --output_header=${BINARY_DIR}/${INPUT_NAME}_bytecode.h \
+    --output_impl=${BINARY_DIR}/${INPUT_NAME}_bytecode.c \
+    --identifier=iree_static_${INPUT_NAME} \
+    --flatten
+
+  #############################################################################
+  # Build the web artifacts using Emscripten                                  #
+  #############################################################################
+
+  echo "=== Building web artifacts using Emscripten ==="
+
+  pushd ${BUILD_DIR?}
+
+  # Configure using Emscripten's CMake wrapper, then build.
+  # Note: The sample creates a task device directly, so no drivers are
+  #       required, but some targets are gated on specific CMake options.
+  emcmake "${CMAKE_BIN?}" -G Ninja ${ROOT_DIR?} \
+    -DCMAKE_BUILD_TYPE=RelWithDebInfo \
+    -DCMAKE_C_FLAGS="${C_FLAGS}" \
+    -DCMAKE_CXX_FLAGS="${C_FLAGS}" \
+    -DIREE_HOST_BINARY_ROOT=${ROOT_DIR?}/../build-host/install \
+    -DIREE_BUILD_EXPERIMENTAL_WEB_SAMPLES=ON \
+    -DIREE_HAL_DRIVER_DEFAULTS=OFF \
+    -DIREE_HAL_DRIVER_DYLIB=ON \
+    -DIREE_BUILD_COMPILER=OFF \
+    -DIREE_BUILD_TESTS=OFF
+
+  "${CMAKE_BIN?}" --build . --target ${TARGET}
+  popd
+}
+
+SYNC_BUILD_DIR=${ROOT_DIR?}/build-emscripten
+THREADS_BUILD_DIR=${ROOT_DIR?}/build-emscripten-threads
+BINARY_DIR=${SYNC_BUILD_DIR}/experimental/sample_web_static/
+
+build_variant ${SYNC_BUILD_DIR} "+simd128" "-msimd128" \
   iree_experimental_sample_web_static_sync
-  # iree_experimental_sample_web_static_multithreaded
-popd
+build_variant ${THREADS_BUILD_DIR} "+simd128,+atomics,+bulk-memory" \
+  "-msimd128 -pthread" iree_experimental_sample_web_static_multithreaded
 
 ###############################################################################
 # Serve the demo using a local webserver                                      #
@@ -86,7 +105,9 @@ popd
 
 echo "=== Copying static files to the build directory ==="
 
+cp ${THREADS_BUILD_DIR}/experimental/sample_web_static/sample-web-static-multithreaded* ${BINARY_DIR}
 cp ${ROOT_DIR?}/experimental/sample_web_static/index.html ${BINARY_DIR}
+cp ${ROOT_DIR?}/experimental/sample_web_static/benchmark.html ${BINARY_DIR}
 cp ${ROOT_DIR?}/experimental/sample_web_static/iree_api.js ${BINARY_DIR}
 cp ${ROOT_DIR?}/experimental/sample_web_static/iree_worker.js ${BINARY_DIR}
 
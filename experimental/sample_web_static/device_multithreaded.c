@@ -7,6 +7,7 @@
 #include "iree/hal/local/loaders/static_library_loader.h"
 #include "iree/hal/local/task_device.h"
 #include "iree/task/api.h"
+#include "iree/task/topology_cpuinfo.h"
 #include "mnist_static.h"
 
 iree_status_t create_device_with_static_loader(iree_allocator_t host_allocator,
@@ -31,10 +32,12 @@ iree_status_t create_device_with_static_loader(iree_allocator_t host_allocator,
   iree_task_executor_t* executor = NULL;
   iree_task_scheduling_mode_t scheduling_mode = 0;
   iree_host_size_t worker_local_memory = 0;
+  // One worker per logical core reported by the browser. Each worker is a web
+  // worker from the pthread pool which must be large enough to hold them all
+  // (see -sPTHREAD_POOL_SIZE in CMakeLists.txt).
   iree_task_topology_t topology;
-  iree_task_topology_initialize(&topology);
-  // TODO(scotttodd): Try with more threads
-  iree_task_topology_initialize_from_group_count(/*group_count=*/1, &topology);
+  iree_task_topology_initialize_from_physical_cores(
+      IREE_TASK_EXECUTOR_MAX_WORKER_COUNT, &topology);
   if (iree_status_is_ok(status)) {
     status = iree_task_executor_create(scheduling_mode, &topology,
                                        worker_local_memory, host_allocator,
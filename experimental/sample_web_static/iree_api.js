@@ -28,8 +28,9 @@ function _handleMessageFromWorker(messageEvent) {
   if (messageType == 'initialized') {
     pendingPromises['initialize']['resolve']();
     delete pendingPromises['initialize'];
-  } else if (messageType == 'predictResult') {
-    if (payload) {
+  } else if (
+      messageType == 'predictResult' || messageType == 'benchmarkResult') {
+    if (!error) {
       pendingPromises[id]['resolve'](payload);
     } else {
       pendingPromises[id]['reject'](error);
@@ -39,19 +40,30 @@ function _handleMessageFromWorker(messageEvent) {
 }
 
 // Initializes IREE's web worker asynchronously.
+// |variant| selects the runtime build: 'sync' or 'multithreaded'. The
+// multithreaded variant requires SharedArrayBuffer and thus a cross-origin
+// isolated page (see scripts/local_web_server.py).
 // Resolves when the worker is fully initialized.
-function ireeInitializeWorker() {
+function ireeInitializeWorker(variant = 'sync') {
   return new Promise((resolve, reject) => {
     pendingPromises['initialize'] = {
       'resolve': resolve,
       'reject': reject,
     };
 
-    ireeWorker = new Worker('iree_worker.js');
+    ireeWorker = new Worker('iree_worker.js?variant=' + variant);
     ireeWorker.onmessage = _handleMessageFromWorker;
   });
 }
 
+// Terminates IREE's web worker, if any, so that another may be initialized.
+function ireeTerminateWorker() {
+  if (ireeWorker) {
+    ireeWorker.terminate();
+    ireeWorker = null;
+  }
+}
+
 // Predicts the handwritten digit in a provided image asynchronously.
 // Input: 28x28 pixel data from CanvasRenderingContext2D.getImageData()
 // Resolves with a Number in [0, 9] (inclusive) on success
@@ -72,3 +84,23 @@ function ireePredictDigit(imageData) {
     ireeWorker.postMessage(message);
   });
 }
+
+// Runs the model |iterationCount| times on a blank image asynchronously.
+// Resolves with the average time of each run in milliseconds.
+function ireeBenchmark(iterationCount) {
+  return new Promise((resolve, reject) => {
+    const messageId = nextMessageId++;
+    const message = {
+      'messageType': 'benchmark',
+      'id': messageId,
+      'payload': iterationCount,
+    };
+
+    pendingPromises[messageId] = {
+      'resolve': resolve,
+      'reject': reject,
+    };
+
+    ireeWorker.postMessage(message);
+  });
+}
@@ -7,6 +7,7 @@
 let wasmSetupSampleFn;
 let wasmCleanupSampleFn;
 let wasmRunSampleFn;
+let wasmBenchmarkSampleFn;
 let wasmState;
 let initialized = false;
 
@@ -28,6 +29,8 @@ var Module = {
     wasmCleanupSampleFn = Module.cwrap('cleanup_sample', null, ['number']);
     wasmRunSampleFn =
         Module.cwrap('run_sample', 'number', ['number', 'number']);
+    wasmBenchmarkSampleFn = Module.cwrap(
+        'benchmark_sample', 'number', ['number', 'number', 'number']);
 
     initializeSample();
   },
@@ -96,13 +99,42 @@ function handlePredict(id, canvasData) {
   }
 }
 
+function handleBenchmark(id, iterationCount) {
+  if (!initialized) return;
+
+  // Benchmark on a blank image; the model does the same work for any input.
+  imageTypedArray.fill(0);
+  Module.HEAPF32.set(imageTypedArray, imageBuffer >> 2);
+  const averageMs =
+      wasmBenchmarkSampleFn(wasmState, imageBuffer, iterationCount);
+
+  if (averageMs < 0) {
+    postMessage({
+      'messageType': 'benchmarkResult',
+      'id': id,
+      'error': 'Wasm module error, check console for details',
+    });
+  } else {
+    postMessage({
+      'messageType': 'benchmarkResult',
+      'id': id,
+      'payload': averageMs,
+    });
+  }
+}
+
 onmessage = function(messageEvent) {
   const {messageType, id, payload} = messageEvent.data;
 
   if (messageType == 'predict') {
     handlePredict(id, payload);
+  } else if (messageType == 'benchmark') {
+    handleBenchmark(id, payload);
   }
 };
 
-importScripts('sample-web-static-sync.js');
-// importScripts('sample-web-static-multithreaded.js');
+// The runtime variant is selected by the page creating the worker, e.g.
+// `iree_worker.js?variant=multithreaded`.
+const variant =
+    new URLSearchParams(self.location.search).get('variant') || 'sync';
+importScripts('sample-web-static-' + variant + '.js');
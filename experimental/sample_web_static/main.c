@@ -25,6 +25,11 @@ void cleanup_sample(iree_sample_state_t* state);
 
 int run_sample(iree_sample_state_t* state, float* image_data);
 
+// Runs the sample |iteration_count| times on |image_data| and returns the
+// average wall time of each run in milliseconds or -1 on failure.
+double benchmark_sample(iree_sample_state_t* state, float* image_data,
+                        int iteration_count);
+
 //===----------------------------------------------------------------------===//
 // Implementation
 //===----------------------------------------------------------------------===//
@@ -113,7 +118,10 @@ void cleanup_sample(iree_sample_state_t* state) {
   free(state);
 }
 
-int run_sample(iree_sample_state_t* state, float* image_data) {
+// Runs the model on |image_data| and stores the 1x10 prediction confidence
+// values for each digit in [0, 9] in |out_predictions|.
+static iree_status_t predict(iree_sample_state_t* state, float* image_data,
+                             float* out_predictions) {
   iree_status_t status = iree_ok_status();
 
   iree_runtime_call_reset(&state->call);
@@ -148,16 +156,19 @@ int run_sample(iree_sample_state_t* state, float* image_data) {
                                                              &ret_buffer_view);
   }
 
-  // Read back the results. The output of the mnist model is a 1x10 prediction
-  // confidence values for each digit in [0, 9].
-  float predictions[1 * 10] = {0.0f};
+  // Read back the results.
   if (iree_status_is_ok(status)) {
-    status =
-        iree_hal_buffer_read_data(iree_hal_buffer_view_buffer(ret_buffer_view),
-                                  0, predictions, sizeof(predictions));
+    status = iree_hal_buffer_read_data(
+        iree_hal_buffer_view_buffer(ret_buffer_view), 0, out_predictions,
+        sizeof(float) * 10);
   }
   iree_hal_buffer_view_release(ret_buffer_view);
+  return status;
+}
 
+int run_sample(iree_sample_state_t* state, float* image_data) {
+  float predictions[1 * 10] = {0.0f};
+  iree_status_t status = predict(state, image_data, predictions);
   if (!iree_status_is_ok(status)) {
     iree_status_fprint(stderr, status);
     iree_status_free(status);
@@ -181,3 +192,26 @@ int run_sample(iree_sample_state_t* state, float* image_data) {
           predictions[7], predictions[8], predictions[9]);
   return result_idx;
 }
+
+double benchmark_sample(iree_sample_state_t* state, float* image_data,
+                        int iteration_count) {
+  if (iteration_count <= 0) return -1;
+
+  // Warm up once so that one-time executable loading and allocations are not
+  // included in the timing.
+  float predictions[1 * 10] = {0.0f};
+  iree_status_t status = predict(state, image_data, predictions);
+
+  iree_time_t start_ns = iree_time_now();
+  for (int i = 0; i < iteration_count && iree_status_is_ok(status); ++i) {
+    status = predict(state, image_data, predictions);
+  }
+  iree_time_t end_ns = iree_time_now();
+
+  if (!iree_status_is_ok(status)) {
+    iree_status_fprint(stderr, status);
+    iree_status_free(status);
+    return -1;
+  }
+  return (double)(end_ns - start_ns) / 1000000.0 / iteration_count;
+}
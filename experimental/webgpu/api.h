@@ -0,0 +1,81 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// See iree/base/api.h for documentation on the API conventions used.
+
+#ifndef IREE_HAL_WEBGPU_API_H_
+#define IREE_HAL_WEBGPU_API_H_
+
+#include "experimental/webgpu/webgpu_headers.h"
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+//===----------------------------------------------------------------------===//
+// iree_hal_webgpu_device_t
+//===----------------------------------------------------------------------===//
+
+// Bind group index reserved for the push constant uniform buffer.
+// Executables access push constants as a single uniform buffer bound at
+// @group(3) @binding(0) and HAL descriptor sets are limited to groups 0-2. The
+// WebGPU default limit is 4 bind groups per pipeline.
+#define IREE_HAL_WEBGPU_PARAMS_BIND_GROUP_INDEX 3
+
+// Maximum number of descriptor sets an executable layout may have.
+#define IREE_HAL_WEBGPU_MAX_DESCRIPTOR_SET_COUNT \
+  IREE_HAL_WEBGPU_PARAMS_BIND_GROUP_INDEX
+
+// Maximum number of 32-bit push constants an executable layout may have.
+#define IREE_HAL_WEBGPU_MAX_PUSH_CONSTANT_COUNT 64
+
+// Parameters configuring an iree_hal_webgpu_device_t.
+// Must be initialized with iree_hal_webgpu_device_options_initialize prior to
+// use.
+typedef struct iree_hal_webgpu_device_options_t {
+  // Size, in bytes, of the block pool used to record command buffers.
+  iree_host_size_t arena_block_size;
+
+  // Size, in bytes, of the ring buffer used to upload push constants and
+  // iree_hal_command_buffer_update_buffer contents. Command buffers recording
+  // more uploads than fit in the ring are split into multiple submissions.
+  iree_host_size_t staging_buffer_size;
+
+  // Maximum number of bind groups retained for reuse by push descriptor sets.
+  // Dispatches pushing the same buffer ranges with the same layout reuse the
+  // cached bind group instead of creating a new one.
+  iree_host_size_t bind_group_cache_capacity;
+} iree_hal_webgpu_device_options_t;
+
+// Initializes |out_options| to default values.
+IREE_API_EXPORT void iree_hal_webgpu_device_options_initialize(
+    iree_hal_webgpu_device_options_t* out_options);
+
+// Wraps an existing WebGPU |handle| in a HAL device. The device and its default
+// queue are retained for the lifetime of the HAL device.
+//
+// WebGPU adapters and devices are requested asynchronously and how that is
+// done varies between browsers, Dawn, and wgpu-native. Applications request
+// the device as appropriate for their platform and then wrap it here.
+//
+// Blocking operations (semaphore waits, buffer mapping, and synchronous
+// transfers) poll the device until the work completes. When targeting the web
+// this requires building with Emscripten's ASYNCIFY so that polling can yield
+// to the browser event loop.
+//
+// |out_device| must be released by the caller (see iree_hal_device_release).
+IREE_API_EXPORT iree_status_t iree_hal_webgpu_wrap_device(
+    iree_string_view_t identifier,
+    const iree_hal_webgpu_device_options_t* options, WGPUDevice handle,
+    iree_allocator_t host_allocator, iree_hal_device_t** out_device);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_WEBGPU_API_H_
@@ -0,0 +1,214 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "experimental/webgpu/bind_group_cache.h"
+
+#include <string.h>
+
+#include "experimental/webgpu/buffer.h"
+#include "iree/base/tracing.h"
+
+// Resolves |binding| to a range of its allocated buffer.
+static void iree_hal_webgpu_resolve_binding(
+    const iree_hal_descriptor_set_binding_t* binding,
+    iree_hal_webgpu_bind_group_binding_t* out_binding) {
+  iree_device_size_t length = binding->length;
+  if (length == IREE_WHOLE_BUFFER) {
+    length = iree_hal_buffer_byte_length(binding->buffer) - binding->offset;
+  }
+  out_binding->binding = binding->binding;
+  out_binding->buffer = iree_hal_buffer_allocated_buffer(binding->buffer);
+  out_binding->offset =
+      iree_hal_buffer_byte_offset(binding->buffer) + binding->offset;
+  out_binding->length = length;
+}
+
+static iree_status_t iree_hal_webgpu_bind_group_create_resolved(
+    WGPUDevice device, WGPUBindGroupLayout layout,
+    iree_host_size_t binding_count,
+    const iree_hal_webgpu_bind_group_binding_t* bindings,
+    WGPUBindGroup* out_bind_group) {
+  WGPUBindGroupEntry* entries = NULL;
+  if (binding_count > 0) {
+    entries = (WGPUBindGroupEntry*)iree_alloca(binding_count *
+                                               sizeof(*entries));
+    memset(entries, 0, binding_count * sizeof(*entries));
+  }
+  for (iree_host_size_t i = 0; i < binding_count; ++i) {
+    entries[i].binding = bindings[i].binding;
+    entries[i].buffer = iree_hal_webgpu_buffer_handle(bindings[i].buffer);
+    entries[i].offset = bindings[i].offset;
+    entries[i].size = bindings[i].length;
+  }
+  WGPUBindGroupDescriptor descriptor;
+  memset(&descriptor, 0, sizeof(descriptor));
+  descriptor.layout = layout;
+  descriptor.entryCount = (uint32_t)binding_count;
+  descriptor.entries = entries;
+  *out_bind_group = wgpuDeviceCreateBindGroup(device, &descriptor);
+  if (!*out_bind_group) {
+    return iree_make_status(IREE_STATUS_INTERNAL,
+                            "failed to create a bind group");
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_webgpu_verify_bindings(
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_binding_t* bindings) {
+  for (iree_host_size_t i = 0; i < binding_count; ++i) {
+    if (!bindings[i].buffer) {
+      return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                              "binding %u has no buffer; indirect bindings "
+                              "must be resolved before recording",
+                              bindings[i].binding);
+    }
+  }
+  return iree_ok_status();
+}
+
+iree_status_t iree_hal_webgpu_bind_group_create(
+    WGPUDevice device, WGPUBindGroupLayout layout,
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_binding_t* bindings,
+    WGPUBindGroup* out_bind_group) {
+  IREE_ASSERT_ARGUMENT(out_bind_group);
+  *out_bind_group = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_hal_webgpu_verify_bindings(binding_count, bindings));
+  iree_hal_webgpu_bind_group_binding_t* resolved_bindings = NULL;
+  if (binding_count > 0) {
+    resolved_bindings = (iree_hal_webgpu_bind_group_binding_t*)iree_alloca(
+        binding_count * sizeof(*resolved_bindings));
+  }
+  for (iree_host_size_t i = 0; i < binding_count; ++i) {
+    iree_hal_webgpu_resolve_binding(&bindings[i], &resolved_bindings[i]);
+  }
+  return iree_hal_webgpu_bind_group_create_resolved(
+      device, layout, binding_count, resolved_bindings, out_bind_group);
+}
+
+iree_status_t iree_hal_webgpu_bind_group_cache_initialize(
+    WGPUDevice device, iree_host_size_t capacity,
+    iree_allocator_t host_allocator,
+    iree_hal_webgpu_bind_group_cache_t* out_cache) {
+  IREE_ASSERT_ARGUMENT(out_cache);
+  memset(out_cache, 0, sizeof(*out_cache));
+  out_cache->device = device;
+  out_cache->host_allocator = host_allocator;
+  // A single entry is required to own the most recently acquired bind group.
+  capacity = iree_max(capacity, 1);
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+      host_allocator, capacity * sizeof(*out_cache->entries),
+      (void**)&out_cache->entries));
+  out_cache->capacity = capacity;
+  return iree_ok_status();
+}
+
+void iree_hal_webgpu_bind_group_cache_deinitialize(
+    iree_hal_webgpu_bind_group_cache_t* cache) {
+  iree_hal_webgpu_bind_group_cache_trim(cache);
+  iree_allocator_free(cache->host_allocator, cache->entries);
+  memset(cache, 0, sizeof(*cache));
+}
+
+static void iree_hal_webgpu_bind_group_cache_entry_reset(
+    iree_hal_webgpu_bind_group_cache_entry_t* entry) {
+  wgpuBindGroupRelease(entry->handle);
+  for (iree_host_size_t i = 0; i < entry->binding_count; ++i) {
+    iree_hal_buffer_release(entry->bindings[i].buffer);
+  }
+  entry->layout = NULL;
+  entry->handle = NULL;
+  entry->binding_count = 0;
+}
+
+void iree_hal_webgpu_bind_group_cache_trim(
+    iree_hal_webgpu_bind_group_cache_t* cache) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  for (iree_host_size_t i = 0; i < cache->count; ++i) {
+    iree_hal_webgpu_bind_group_cache_entry_reset(&cache->entries[i]);
+  }
+  cache->count = 0;
+  cache->next_eviction = 0;
+  IREE_TRACE_ZONE_END(z0);
+}
+
+static bool iree_hal_webgpu_bind_group_cache_entry_matches(
+    const iree_hal_webgpu_bind_group_cache_entry_t* entry,
+    WGPUBindGroupLayout layout, iree_host_size_t binding_count,
+    const iree_hal_webgpu_bind_group_binding_t* bindings) {
+  if (entry->layout != layout || entry->binding_count != binding_count) {
+    return false;
+  }
+  for (iree_host_size_t i = 0; i < binding_count; ++i) {
+    const iree_hal_webgpu_bind_group_binding_t* lhs = &entry->bindings[i];
+    const iree_hal_webgpu_bind_group_binding_t* rhs = &bindings[i];
+    if (lhs->binding != rhs->binding || lhs->buffer != rhs->buffer ||
+        lhs->offset != rhs->offset || lhs->length != rhs->length) {
+      return false;
+    }
+  }
+  return true;
+}
+
+iree_status_t iree_hal_webgpu_bind_group_cache_acquire(
+    iree_hal_webgpu_bind_group_cache_t* cache, WGPUBindGroupLayout layout,
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_binding_t* bindings,
+    WGPUBindGroup* out_bind_group) {
+  IREE_ASSERT_ARGUMENT(cache);
+  IREE_ASSERT_ARGUMENT(out_bind_group);
+  *out_bind_group = NULL;
+  if (binding_count > IREE_HAL_WEBGPU_BIND_GROUP_CACHE_MAX_BINDING_COUNT) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "binding count %zu over the limit of %d",
+                            binding_count,
+                            IREE_HAL_WEBGPU_BIND_GROUP_CACHE_MAX_BINDING_COUNT);
+  }
+  IREE_RETURN_IF_ERROR(
+      iree_hal_webgpu_verify_bindings(binding_count, bindings));
+
+  iree_hal_webgpu_bind_group_binding_t
+      resolved_bindings[IREE_HAL_WEBGPU_BIND_GROUP_CACHE_MAX_BINDING_COUNT];
+  for (iree_host_size_t i = 0; i < binding_count; ++i) {
+    iree_hal_webgpu_resolve_binding(&bindings[i], &resolved_bindings[i]);
+  }
+
+  for (iree_host_size_t i = 0; i < cache->count; ++i) {
+    iree_hal_webgpu_bind_group_cache_entry_t* entry = &cache->entries[i];
+    if (iree_hal_webgpu_bind_group_cache_entry_matches(
+            entry, layout, binding_count, resolved_bindings)) {
+      *out_bind_group = entry->handle;
+      return iree_ok_status();
+    }
+  }
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+  WGPUBindGroup handle = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_webgpu_bind_group_create_resolved(
+              cache->device, layout, binding_count, resolved_bindings,
+              &handle));
+  iree_hal_webgpu_bind_group_cache_entry_t* entry = NULL;
+  if (cache->count < cache->capacity) {
+    entry = &cache->entries[cache->count++];
+  } else {
+    entry = &cache->entries[cache->next_eviction];
+    cache->next_eviction = (cache->next_eviction + 1) % cache->capacity;
+    iree_hal_webgpu_bind_group_cache_entry_reset(entry);
+  }
+  entry->layout = layout;
+  entry->handle = handle;
+  entry->binding_count = binding_count;
+  for (iree_host_size_t i = 0; i < binding_count; ++i) {
+    entry->bindings[i] = resolved_bindings[i];
+    iree_hal_buffer_retain(entry->bindings[i].buffer);
+  }
+  *out_bind_group = handle;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
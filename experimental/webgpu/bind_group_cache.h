@@ -0,0 +1,95 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_WEBGPU_BIND_GROUP_CACHE_H_
+#define IREE_HAL_WEBGPU_BIND_GROUP_CACHE_H_
+
+#include "experimental/webgpu/webgpu_headers.h"
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Maximum number of bindings in a bind group acquired from the cache.
+#define IREE_HAL_WEBGPU_BIND_GROUP_CACHE_MAX_BINDING_COUNT 32
+
+// Creates a bind group with |layout| from the given HAL |bindings|.
+// All bindings must reference buffers allocated by the WebGPU allocator (or
+// subspans of them).
+iree_status_t iree_hal_webgpu_bind_group_create(
+    WGPUDevice device, WGPUBindGroupLayout layout,
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_binding_t* bindings,
+    WGPUBindGroup* out_bind_group);
+
+typedef struct iree_hal_webgpu_bind_group_binding_t {
+  uint32_t binding;
+  // Retained allocated buffer backing the binding.
+  iree_hal_buffer_t* buffer;
+  // Offset within the allocated buffer.
+  iree_device_size_t offset;
+  iree_device_size_t length;
+} iree_hal_webgpu_bind_group_binding_t;
+
+typedef struct iree_hal_webgpu_bind_group_cache_entry_t {
+  WGPUBindGroupLayout layout;
+  WGPUBindGroup handle;
+  iree_host_size_t binding_count;
+  iree_hal_webgpu_bind_group_binding_t
+      bindings[IREE_HAL_WEBGPU_BIND_GROUP_CACHE_MAX_BINDING_COUNT];
+} iree_hal_webgpu_bind_group_cache_entry_t;
+
+// A fixed-capacity cache of bind groups created for push descriptor sets.
+//
+// Bind groups are immutable and creating one per dispatch is expensive in
+// browsers where each creation crosses into the GPU process. Programs usually
+// dispatch with the same few combinations of buffer ranges and reusing the
+// bind groups for them avoids nearly all creations after warmup.
+//
+// Entries retain the buffers they reference so that a buffer freed and
+// reallocated with the same handle never matches a stale bind group. Entries
+// are replaced round-robin once the cache is full and iree_hal_device_trim
+// empties the cache.
+//
+// Thread-compatible; the device serializes access.
+typedef struct iree_hal_webgpu_bind_group_cache_t {
+  WGPUDevice device;
+  iree_allocator_t host_allocator;
+  iree_host_size_t capacity;
+  iree_host_size_t count;
+  // Index of the entry replaced by the next miss once the cache is full.
+  iree_host_size_t next_eviction;
+  iree_hal_webgpu_bind_group_cache_entry_t* entries;
+} iree_hal_webgpu_bind_group_cache_t;
+
+iree_status_t iree_hal_webgpu_bind_group_cache_initialize(
+    WGPUDevice device, iree_host_size_t capacity,
+    iree_allocator_t host_allocator,
+    iree_hal_webgpu_bind_group_cache_t* out_cache);
+
+void iree_hal_webgpu_bind_group_cache_deinitialize(
+    iree_hal_webgpu_bind_group_cache_t* cache);
+
+// Releases all cached bind groups and the buffers they reference.
+void iree_hal_webgpu_bind_group_cache_trim(
+    iree_hal_webgpu_bind_group_cache_t* cache);
+
+// Returns a bind group with |layout| for |bindings|, creating it on a miss.
+// The returned bind group is owned by the cache and only valid until the next
+// acquire or trim; command encoders retain bind groups set on them.
+iree_status_t iree_hal_webgpu_bind_group_cache_acquire(
+    iree_hal_webgpu_bind_group_cache_t* cache, WGPUBindGroupLayout layout,
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_binding_t* bindings,
+    WGPUBindGroup* out_bind_group);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_WEBGPU_BIND_GROUP_CACHE_H_
@@ -0,0 +1,41 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_WEBGPU_BUFFER_H_
+#define IREE_HAL_WEBGPU_BUFFER_H_
+
+#include "experimental/webgpu/webgpu_headers.h"
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Wraps a WebGPU buffer |handle| allocated from |device|.
+// The handle is owned by the allocator and destroyed when the buffer is
+// deallocated.
+//
+// WebGPU only allows mapping buffers that are not usable as storage buffers
+// and mapping is asynchronous. Host-visible buffers are instead mapped by
+// reading their contents into host memory (unless discarded) and writing
+// them back on unmap with queue writes. Only scoped mappings are supported.
+iree_status_t iree_hal_webgpu_buffer_wrap(
+    WGPUDevice device, WGPUQueue queue, iree_hal_allocator_t* allocator,
+    iree_hal_memory_type_t memory_type, iree_hal_memory_access_t allowed_access,
+    iree_hal_buffer_usage_t allowed_usage, iree_device_size_t allocation_size,
+    iree_device_size_t byte_offset, iree_device_size_t byte_length,
+    WGPUBuffer handle, iree_hal_buffer_t** out_buffer);
+
+// Returns the WebGPU handle backing |buffer|.
+// |buffer| must be an allocated webgpu buffer and not a subspan.
+WGPUBuffer iree_hal_webgpu_buffer_handle(const iree_hal_buffer_t* buffer);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_WEBGPU_BUFFER_H_
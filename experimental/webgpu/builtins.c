@@ -0,0 +1,108 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "experimental/webgpu/builtins.h"
+
+#include <string.h>
+
+#include "experimental/webgpu/descriptor_set_layout.h"
+#include "experimental/webgpu/executable_layout.h"
+#include "iree/base/tracing.h"
+
+// Each invocation fills one word; dispatches are split by the command buffer
+// so that the workgroup count stays within the 65535 per-dimension limit.
+static const char iree_hal_webgpu_fill_buffer_wgsl[] =
+    "struct Params {\n"
+    "  offset: u32,\n"
+    "  length: u32,\n"
+    "  pattern: u32,\n"
+    "}\n"
+    "@group(0) @binding(0) var<storage, read_write> buffer: array<u32>;\n"
+    "@group(3) @binding(0) var<uniform> params: Params;\n"
+    "@compute @workgroup_size(64)\n"
+    "fn d0(@builtin(global_invocation_id) id: vec3<u32>) {\n"
+    "  if (id.x < params.length) {\n"
+    "    buffer[params.offset + id.x] = params.pattern;\n"
+    "  }\n"
+    "}\n";
+
+static iree_status_t iree_hal_webgpu_builtins_create_fill_buffer(
+    WGPUDevice device, iree_hal_webgpu_staging_buffer_t* staging_buffer,
+    iree_allocator_t host_allocator, iree_hal_webgpu_builtins_t* builtins) {
+  const iree_hal_descriptor_set_layout_binding_t binding = {
+      .binding = 0,
+      .type = IREE_HAL_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+  };
+  IREE_RETURN_IF_ERROR(iree_hal_webgpu_descriptor_set_layout_create(
+      device, IREE_HAL_DESCRIPTOR_SET_LAYOUT_USAGE_TYPE_PUSH_ONLY, 1, &binding,
+      host_allocator, &builtins->fill_buffer_set_layout));
+  IREE_RETURN_IF_ERROR(iree_hal_webgpu_executable_layout_create(
+      device, 1, &builtins->fill_buffer_set_layout,
+      sizeof(iree_hal_webgpu_fill_buffer_params_t) / sizeof(uint32_t),
+      staging_buffer->params_layout, staging_buffer->empty_layout,
+      host_allocator,
+      &builtins->fill_buffer_layout));
+
+  WGPUShaderModuleWGSLDescriptor wgsl_descriptor;
+  memset(&wgsl_descriptor, 0, sizeof(wgsl_descriptor));
+  wgsl_descriptor.chain.sType = WGPUSType_ShaderModuleWGSLDescriptor;
+  wgsl_descriptor.source = iree_hal_webgpu_fill_buffer_wgsl;
+  WGPUShaderModuleDescriptor module_descriptor;
+  memset(&module_descriptor, 0, sizeof(module_descriptor));
+  module_descriptor.nextInChain = &wgsl_descriptor.chain;
+  module_descriptor.label = "iree-hal-webgpu-fill-buffer";
+  WGPUShaderModule shader_module =
+      wgpuDeviceCreateShaderModule(device, &module_descriptor);
+  if (!shader_module) {
+    return iree_make_status(IREE_STATUS_INTERNAL,
+                            "failed to create the fill_buffer shader module");
+  }
+
+  WGPUComputePipelineDescriptor pipeline_descriptor;
+  memset(&pipeline_descriptor, 0, sizeof(pipeline_descriptor));
+  pipeline_descriptor.label = "iree-hal-webgpu-fill-buffer";
+  pipeline_descriptor.layout =
+      iree_hal_webgpu_executable_layout_handle(builtins->fill_buffer_layout);
+  pipeline_descriptor.compute.module = shader_module;
+  pipeline_descriptor.compute.entryPoint = "d0";
+  builtins->fill_buffer_pipeline =
+      wgpuDeviceCreateComputePipeline(device, &pipeline_descriptor);
+  wgpuShaderModuleRelease(shader_module);
+  if (!builtins->fill_buffer_pipeline) {
+    return iree_make_status(IREE_STATUS_INTERNAL,
+                            "failed to create the fill_buffer pipeline");
+  }
+  return iree_ok_status();
+}
+
+iree_status_t iree_hal_webgpu_builtins_initialize(
+    WGPUDevice device, iree_hal_webgpu_staging_buffer_t* staging_buffer,
+    iree_allocator_t host_allocator, iree_hal_webgpu_builtins_t* out_builtins) {
+  IREE_ASSERT_ARGUMENT(device);
+  IREE_ASSERT_ARGUMENT(staging_buffer);
+  IREE_ASSERT_ARGUMENT(out_builtins);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  memset(out_builtins, 0, sizeof(*out_builtins));
+
+  iree_status_t status = iree_hal_webgpu_builtins_create_fill_buffer(
+      device, staging_buffer, host_allocator, out_builtins);
+
+  if (!iree_status_is_ok(status)) {
+    iree_hal_webgpu_builtins_deinitialize(out_builtins);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+void iree_hal_webgpu_builtins_deinitialize(
+    iree_hal_webgpu_builtins_t* builtins) {
+  if (builtins->fill_buffer_pipeline) {
+    wgpuComputePipelineRelease(builtins->fill_buffer_pipeline);
+  }
+  iree_hal_executable_layout_release(builtins->fill_buffer_layout);
+  iree_hal_descriptor_set_layout_release(builtins->fill_buffer_set_layout);
+  memset(builtins, 0, sizeof(*builtins));
+}
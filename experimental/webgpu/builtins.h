@@ -0,0 +1,56 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_WEBGPU_BUILTINS_H_
+#define IREE_HAL_WEBGPU_BUILTINS_H_
+
+#include "experimental/webgpu/staging_buffer.h"
+#include "experimental/webgpu/webgpu_headers.h"
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Workgroup size of the fill_buffer builtin.
+#define IREE_HAL_WEBGPU_FILL_BUFFER_WORKGROUP_SIZE 64
+
+// Push constants of the fill_buffer builtin.
+typedef struct iree_hal_webgpu_fill_buffer_params_t {
+  // Offset, in 32-bit words, of the first word to fill in the binding.
+  uint32_t offset;
+  // Number of 32-bit words to fill.
+  uint32_t length;
+  // 32-bit pattern to fill with.
+  uint32_t pattern;
+} iree_hal_webgpu_fill_buffer_params_t;
+
+// Pipelines implementing HAL commands WebGPU has no native equivalent for.
+// Builtins use the same layouts as compiled executables so that command
+// buffers dispatch them through the same push constant and push descriptor
+// set paths.
+typedef struct iree_hal_webgpu_builtins_t {
+  // Fills 4-byte aligned ranges of a storage buffer with a 32-bit pattern.
+  // Set 0 binding 0 is the target buffer and the push constants are
+  // iree_hal_webgpu_fill_buffer_params_t.
+  iree_hal_descriptor_set_layout_t* fill_buffer_set_layout;
+  iree_hal_executable_layout_t* fill_buffer_layout;
+  WGPUComputePipeline fill_buffer_pipeline;
+} iree_hal_webgpu_builtins_t;
+
+iree_status_t iree_hal_webgpu_builtins_initialize(
+    WGPUDevice device, iree_hal_webgpu_staging_buffer_t* staging_buffer,
+    iree_allocator_t host_allocator, iree_hal_webgpu_builtins_t* out_builtins);
+
+void iree_hal_webgpu_builtins_deinitialize(
+    iree_hal_webgpu_builtins_t* builtins);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_WEBGPU_BUILTINS_H_
@@ -0,0 +1,749 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "experimental/webgpu/command_buffer.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "experimental/webgpu/api.h"
+#include "experimental/webgpu/buffer.h"
+#include "experimental/webgpu/descriptor_set.h"
+#include "experimental/webgpu/descriptor_set_layout.h"
+#include "experimental/webgpu/executable.h"
+#include "experimental/webgpu/executable_layout.h"
+#include "iree/base/api.h"
+#include "iree/base/tracing.h"
+
+// Total number of bind groups including the params bind group.
+#define IREE_HAL_WEBGPU_BIND_GROUP_COUNT \
+  (IREE_HAL_WEBGPU_PARAMS_BIND_GROUP_INDEX + 1)
+
+// Maximum number of dynamic offsets of a single descriptor set. This is the
+// WebGPU default limit of dynamic uniform buffers per pipeline layout.
+#define IREE_HAL_WEBGPU_MAX_DYNAMIC_OFFSET_COUNT 8
+
+// Maximum number of workgroups in a single dimension of a dispatch.
+#define IREE_HAL_WEBGPU_MAX_WORKGROUP_COUNT 65535
+
+// Offsets of storage buffer bindings must be aligned to the device
+// minStorageBufferOffsetAlignment; this is the WebGPU default (and maximum).
+#define IREE_HAL_WEBGPU_STORAGE_BUFFER_OFFSET_ALIGNMENT 256
+
+typedef struct iree_hal_webgpu_bind_group_state_t {
+  WGPUBindGroup handle;
+  uint32_t dynamic_offset_count;
+  uint32_t dynamic_offsets[IREE_HAL_WEBGPU_MAX_DYNAMIC_OFFSET_COUNT];
+} iree_hal_webgpu_bind_group_state_t;
+
+typedef struct iree_hal_webgpu_command_buffer_t {
+  iree_hal_command_buffer_t base;
+  iree_allocator_t host_allocator;
+  WGPUDevice device;
+  WGPUQueue queue;
+  iree_hal_webgpu_staging_buffer_t* staging_buffer;
+  iree_hal_webgpu_bind_group_cache_t* bind_group_cache;
+  iree_hal_webgpu_builtins_t* builtins;
+
+  // Encoder of the commands recorded since the last submission; created on
+  // demand.
+  WGPUCommandEncoder encoder;
+  // Compute pass the dispatches are recorded into; ended before any transfer
+  // or debug group command.
+  WGPUComputePassEncoder compute_pass;
+
+  // Bind groups currently set on |compute_pass|, used to elide redundant
+  // bindings. The encoder retains these so the handles remain unique while
+  // the pass is open.
+  iree_hal_webgpu_bind_group_state_t
+      bound_groups[IREE_HAL_WEBGPU_BIND_GROUP_COUNT];
+
+  struct {
+    // Push constants for the next dispatch.
+    uint32_t push_constants[IREE_HAL_WEBGPU_MAX_PUSH_CONSTANT_COUNT];
+    // Retained bind groups of each descriptor set.
+    iree_hal_webgpu_bind_group_state_t
+        sets[IREE_HAL_WEBGPU_MAX_DESCRIPTOR_SET_COUNT];
+  } state;
+} iree_hal_webgpu_command_buffer_t;
+
+static const iree_hal_command_buffer_vtable_t
+    iree_hal_webgpu_command_buffer_vtable;
+
+static iree_hal_webgpu_command_buffer_t* iree_hal_webgpu_command_buffer_cast(
+    iree_hal_command_buffer_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_hal_webgpu_command_buffer_vtable);
+  return (iree_hal_webgpu_command_buffer_t*)base_value;
+}
+
+iree_status_t iree_hal_webgpu_command_buffer_create(
+    iree_hal_device_t* base_device, WGPUDevice device, WGPUQueue queue,
+    iree_hal_webgpu_staging_buffer_t* staging_buffer,
+    iree_hal_webgpu_bind_group_cache_t* bind_group_cache,
+    iree_hal_webgpu_builtins_t* builtins, iree_allocator_t host_allocator,
+    iree_hal_command_buffer_t** out_command_buffer) {
+  IREE_ASSERT_ARGUMENT(base_device);
+  IREE_ASSERT_ARGUMENT(device);
+  IREE_ASSERT_ARGUMENT(staging_buffer);
+  IREE_ASSERT_ARGUMENT(bind_group_cache);
+  IREE_ASSERT_ARGUMENT(builtins);
+  IREE_ASSERT_ARGUMENT(out_command_buffer);
+  *out_command_buffer = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_webgpu_command_buffer_t* command_buffer = NULL;
+  iree_status_t status = iree_allocator_malloc(
+      host_allocator, sizeof(*command_buffer), (void**)&command_buffer);
+  if (iree_status_is_ok(status)) {
+    memset(command_buffer, 0, sizeof(*command_buffer));
+    iree_hal_command_buffer_initialize(
+        base_device, IREE_HAL_COMMAND_BUFFER_MODE_REUSABLE,
+        IREE_HAL_COMMAND_CATEGORY_ANY, IREE_HAL_QUEUE_AFFINITY_ANY,
+        &iree_hal_webgpu_command_buffer_vtable, &command_buffer->base);
+    command_buffer->host_allocator = host_allocator;
+    command_buffer->device = device;
+    command_buffer->queue = queue;
+    command_buffer->staging_buffer = staging_buffer;
+    command_buffer->bind_group_cache = bind_group_cache;
+    command_buffer->builtins = builtins;
+    *out_command_buffer = &command_buffer->base;
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_webgpu_command_buffer_reset_state(
+    iree_hal_webgpu_command_buffer_t* command_buffer) {
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(command_buffer->state.sets);
+       ++i) {
+    if (command_buffer->state.sets[i].handle) {
+      wgpuBindGroupRelease(command_buffer->state.sets[i].handle);
+    }
+  }
+  memset(&command_buffer->state, 0, sizeof(command_buffer->state));
+}
+
+// Drops any commands recorded since the last submission.
+static void iree_hal_webgpu_command_buffer_discard(
+    iree_hal_webgpu_command_buffer_t* command_buffer) {
+  if (command_buffer->compute_pass) {
+    wgpuComputePassEncoderRelease(command_buffer->compute_pass);
+    command_buffer->compute_pass = NULL;
+  }
+  if (command_buffer->encoder) {
+    wgpuCommandEncoderRelease(command_buffer->encoder);
+    command_buffer->encoder = NULL;
+  }
+}
+
+static void iree_hal_webgpu_command_buffer_destroy(
+    iree_hal_command_buffer_t* base_command_buffer) {
+  iree_hal_webgpu_command_buffer_t* command_buffer =
+      iree_hal_webgpu_command_buffer_cast(base_command_buffer);
+  iree_allocator_t host_allocator = command_buffer->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_webgpu_command_buffer_discard(command_buffer);
+  iree_hal_webgpu_command_buffer_reset_state(command_buffer);
+  iree_allocator_free(host_allocator, command_buffer);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+static void* iree_hal_webgpu_command_buffer_dyn_cast(
+    iree_hal_command_buffer_t* command_buffer, const void* vtable) {
+  if (vtable == &iree_hal_webgpu_command_buffer_vtable) {
+    IREE_HAL_ASSERT_TYPE(command_buffer, vtable);
+    return command_buffer;
+  }
+  return NULL;
+}
+
+// Returns the encoder for the next commands, creating one if needed.
+static iree_status_t iree_hal_webgpu_command_buffer_acquire_encoder(
+    iree_hal_webgpu_command_buffer_t* command_buffer,
+    WGPUCommandEncoder* out_encoder) {
+  if (!command_buffer->encoder) {
+    WGPUCommandEncoderDescriptor descriptor;
+    memset(&descriptor, 0, sizeof(descriptor));
+    command_buffer->encoder =
+        wgpuDeviceCreateCommandEncoder(command_buffer->device, &descriptor);
+    if (!command_buffer->encoder) {
+      return iree_make_status(IREE_STATUS_INTERNAL,
+                              "failed to create a command encoder");
+    }
+  }
+  *out_encoder = command_buffer->encoder;
+  return iree_ok_status();
+}
+
+static void iree_hal_webgpu_command_buffer_end_compute_pass(
+    iree_hal_webgpu_command_buffer_t* command_buffer) {
+  if (!command_buffer->compute_pass) return;
+  wgpuComputePassEncoderEnd(command_buffer->compute_pass);
+  wgpuComputePassEncoderRelease(command_buffer->compute_pass);
+  command_buffer->compute_pass = NULL;
+}
+
+// Returns the compute pass for the next dispatch, beginning one if needed.
+static iree_status_t iree_hal_webgpu_command_buffer_acquire_compute_pass(
+    iree_hal_webgpu_command_buffer_t* command_buffer,
+    WGPUComputePassEncoder* out_compute_pass) {
+  if (!command_buffer->compute_pass) {
+    WGPUCommandEncoder encoder = NULL;
+    IREE_RETURN_IF_ERROR(
+        iree_hal_webgpu_command_buffer_acquire_encoder(command_buffer,
+                                                       &encoder));
+    WGPUComputePassDescriptor descriptor;
+    memset(&descriptor, 0, sizeof(descriptor));
+    command_buffer->compute_pass =
+        wgpuCommandEncoderBeginComputePass(encoder, &descriptor);
+    if (!command_buffer->compute_pass) {
+      return iree_make_status(IREE_STATUS_INTERNAL,
+                              "failed to begin a compute pass");
+    }
+    memset(command_buffer->bound_groups, 0,
+           sizeof(command_buffer->bound_groups));
+  }
+  *out_compute_pass = command_buffer->compute_pass;
+  return iree_ok_status();
+}
+
+// Uploads staged data and submits all commands recorded so far.
+static iree_status_t iree_hal_webgpu_command_buffer_flush(
+    iree_hal_webgpu_command_buffer_t* command_buffer) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_hal_webgpu_command_buffer_end_compute_pass(command_buffer);
+
+  // Queue writes are ordered before the submission below.
+  iree_hal_webgpu_staging_buffer_flush(command_buffer->staging_buffer);
+
+  iree_status_t status = iree_ok_status();
+  if (command_buffer->encoder) {
+    WGPUCommandBufferDescriptor descriptor;
+    memset(&descriptor, 0, sizeof(descriptor));
+    WGPUCommandBuffer handle =
+        wgpuCommandEncoderFinish(command_buffer->encoder, &descriptor);
+    wgpuCommandEncoderRelease(command_buffer->encoder);
+    command_buffer->encoder = NULL;
+    if (handle) {
+      wgpuQueueSubmit(command_buffer->queue, 1, &handle);
+      wgpuCommandBufferRelease(handle);
+    } else {
+      status = iree_make_status(IREE_STATUS_INTERNAL,
+                                "failed to finish the command encoder");
+    }
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Stages |data| for upload and returns its offset in the staging buffer. If
+// the staging buffer is full the commands recorded so far are submitted so
+// that it can be reused.
+static iree_status_t iree_hal_webgpu_command_buffer_stage(
+    iree_hal_webgpu_command_buffer_t* command_buffer, const void* data,
+    iree_host_size_t data_length, uint32_t* out_offset) {
+  iree_status_t status = iree_hal_webgpu_staging_buffer_append(
+      command_buffer->staging_buffer, data, data_length, out_offset);
+  if (!iree_status_is_resource_exhausted(status)) return status;
+  iree_status_ignore(status);
+  IREE_RETURN_IF_ERROR(iree_hal_webgpu_command_buffer_flush(command_buffer));
+  return iree_hal_webgpu_staging_buffer_append(
+      command_buffer->staging_buffer, data, data_length, out_offset);
+}
+
+static iree_status_t iree_hal_webgpu_command_buffer_begin(
+    iree_hal_command_buffer_t* base_command_buffer) {
+  iree_hal_webgpu_command_buffer_t* command_buffer =
+      iree_hal_webgpu_command_buffer_cast(base_command_buffer);
+  // Drop anything left over from a recording that failed part way through.
+  iree_hal_webgpu_command_buffer_discard(command_buffer);
+  iree_hal_webgpu_command_buffer_reset_state(command_buffer);
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_webgpu_command_buffer_end(
+    iree_hal_command_buffer_t* base_command_buffer) {
+  iree_hal_webgpu_command_buffer_t* command_buffer =
+      iree_hal_webgpu_command_buffer_cast(base_command_buffer);
+  iree_status_t status = iree_hal_webgpu_command_buffer_flush(command_buffer);
+  iree_hal_webgpu_command_buffer_reset_state(command_buffer);
+  return status;
+}
+
+static void iree_hal_webgpu_command_buffer_begin_debug_group(
+    iree_hal_command_buffer_t* base_command_buffer, iree_string_view_t label,
+    iree_hal_label_color_t label_color,
+    const iree_hal_label_location_t* location) {
+  iree_hal_webgpu_command_buffer_t* command_buffer =
+      iree_hal_webgpu_command_buffer_cast(base_command_buffer);
+  // Groups are recorded on the encoder as passes may end within a group.
+  iree_hal_webgpu_command_buffer_end_compute_pass(command_buffer);
+  WGPUCommandEncoder encoder = NULL;
+  iree_status_t status =
+      iree_hal_webgpu_command_buffer_acquire_encoder(command_buffer, &encoder);
+  if (!iree_status_is_ok(status)) {
+    // The failure will be reported when the encoder is next required.
+    iree_status_ignore(status);
+    return;
+  }
+  char label_str[128];
+  iree_host_size_t label_length =
+      iree_min(label.size, IREE_ARRAYSIZE(label_str) - 1);
+  memcpy(label_str, label.data, label_length);
+  label_str[label_length] = 0;
+  wgpuCommandEncoderPushDebugGroup(encoder, label_str);
+}
+
+static void iree_hal_webgpu_command_buffer_end_debug_group(
+    iree_hal_command_buffer_t* base_command_buffer) {
+  iree_hal_webgpu_command_buffer_t* command_buffer =
+      iree_hal_webgpu_command_buffer_cast(base_command_buffer);
+  iree_hal_webgpu_command_buffer_end_compute_pass(command_buffer);
+  if (command_buffer->encoder) {
+    wgpuCommandEncoderPopDebugGroup(command_buffer->encoder);
+  }
+}
+
+static iree_status_t iree_hal_webgpu_command_buffer_execution_barrier(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_execution_stage_t source_stage_mask,
+    iree_hal_execution_stage_t target_stage_mask,
+    iree_hal_execution_barrier_flags_t flags,
+    iree_host_size_t memory_barrier_count,
+    const iree_hal_memory_barrier_t* memory_barriers,
+    iree_host_size_t buffer_barrier_count,
+    const iree_hal_buffer_barrier_t* buffer_barriers) {
+  // WebGPU synchronizes all usage between dispatches and passes.
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_webgpu_command_buffer_signal_event(
+    iree_hal_command_buffer_t* base_command_buffer, iree_hal_event_t* event,
+    iree_hal_execution_stage_t source_stage_mask) {
+  // WebGPU executes commands in order; events are never needed.
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_webgpu_command_buffer_reset_event(
+    iree_hal_command_buffer_t* base_command_buffer, iree_hal_event_t* event,
+    iree_hal_execution_stage_t source_stage_mask) {
+  // WebGPU executes commands in order; events are never needed.
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_webgpu_command_buffer_wait_events(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_host_size_t event_count, const iree_hal_event_t** events,
+    iree_hal_execution_stage_t source_stage_mask,
+    iree_hal_execution_stage_t target_stage_mask,
+    iree_host_size_t memory_barrier_count,
+    const iree_hal_memory_barrier_t* memory_barriers,
+    iree_host_size_t buffer_barrier_count,
+    const iree_hal_buffer_barrier_t* buffer_barriers) {
+  // WebGPU executes commands in order; events are never needed.
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_webgpu_command_buffer_discard_buffer(
+    iree_hal_command_buffer_t* base_command_buffer, iree_hal_buffer_t* buffer) {
+  // We could mark the memory as invalidated so that if this is a managed buffer
+  // WebGPU does not try to copy it back to the host.
+  return iree_ok_status();
+}
+
+// Sets |state| to bind group |index| on the compute pass unless already set.
+static void iree_hal_webgpu_command_buffer_bind_group(
+    iree_hal_webgpu_command_buffer_t* command_buffer, uint32_t index,
+    const iree_hal_webgpu_bind_group_state_t* state) {
+  iree_hal_webgpu_bind_group_state_t* bound_group =
+      &command_buffer->bound_groups[index];
+  if (bound_group->handle == state->handle &&
+      bound_group->dynamic_offset_count == state->dynamic_offset_count &&
+      memcmp(bound_group->dynamic_offsets, state->dynamic_offsets,
+             state->dynamic_offset_count * sizeof(uint32_t)) == 0) {
+    return;
+  }
+  wgpuComputePassEncoderSetBindGroup(command_buffer->compute_pass, index,
+                                     state->handle,
+                                     state->dynamic_offset_count,
+                                     state->dynamic_offsets);
+  *bound_group = *state;
+}
+
+// Begins a dispatch of |pipeline| with |layout| by staging |push_constants|
+// and setting the pipeline and all bind groups required by the layout.
+// |sets| contains the bind groups of the layout's descriptor sets.
+static iree_status_t iree_hal_webgpu_command_buffer_prepare_dispatch(
+    iree_hal_webgpu_command_buffer_t* command_buffer,
+    WGPUComputePipeline pipeline, iree_hal_executable_layout_t* layout,
+    const iree_hal_webgpu_bind_group_state_t* sets,
+    const uint32_t* push_constants, WGPUComputePassEncoder* out_compute_pass) {
+  iree_host_size_t set_count =
+      iree_hal_webgpu_executable_layout_set_layout_count(layout);
+  iree_host_size_t push_constant_count =
+      iree_hal_webgpu_executable_layout_push_constant_count(layout);
+  for (iree_host_size_t i = 0; i < set_count; ++i) {
+    if (!sets[i].handle) {
+      return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                              "descriptor set %zu not bound before dispatch",
+                              i);
+    }
+  }
+
+  // Staging may submit the commands recorded so far and must happen before
+  // the compute pass is acquired.
+  iree_hal_webgpu_bind_group_state_t params_state;
+  memset(&params_state, 0, sizeof(params_state));
+  if (push_constant_count > 0) {
+    params_state.handle = command_buffer->staging_buffer->params_bind_group;
+    params_state.dynamic_offset_count = 1;
+    IREE_RETURN_IF_ERROR(iree_hal_webgpu_command_buffer_stage(
+        command_buffer, push_constants, push_constant_count * sizeof(uint32_t),
+        &params_state.dynamic_offsets[0]));
+  }
+
+  WGPUComputePassEncoder compute_pass = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_webgpu_command_buffer_acquire_compute_pass(
+      command_buffer, &compute_pass));
+  wgpuComputePassEncoderSetPipeline(compute_pass, pipeline);
+  for (iree_host_size_t i = 0; i < set_count; ++i) {
+    iree_hal_webgpu_command_buffer_bind_group(command_buffer, (uint32_t)i,
+                                              &sets[i]);
+  }
+  if (push_constant_count > 0) {
+    iree_hal_webgpu_bind_group_state_t empty_state;
+    memset(&empty_state, 0, sizeof(empty_state));
+    empty_state.handle = command_buffer->staging_buffer->empty_bind_group;
+    for (iree_host_size_t i = set_count;
+         i < IREE_HAL_WEBGPU_PARAMS_BIND_GROUP_INDEX; ++i) {
+      iree_hal_webgpu_command_buffer_bind_group(command_buffer, (uint32_t)i,
+                                                &empty_state);
+    }
+    iree_hal_webgpu_command_buffer_bind_group(
+        command_buffer, IREE_HAL_WEBGPU_PARAMS_BIND_GROUP_INDEX,
+        &params_state);
+  }
+
+  *out_compute_pass = compute_pass;
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_webgpu_command_buffer_fill_buffer(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_buffer_t* target_buffer, iree_device_size_t target_offset,
+    iree_device_size_t length, const void* pattern,
+    iree_host_size_t pattern_length) {
+  iree_hal_webgpu_command_buffer_t* command_buffer =
+      iree_hal_webgpu_command_buffer_cast(base_command_buffer);
+  iree_hal_webgpu_builtins_t* builtins = command_buffer->builtins;
+
+  // The builtin writes whole 32-bit words.
+  iree_device_size_t absolute_offset =
+      iree_hal_buffer_byte_offset(target_buffer) + target_offset;
+  if ((absolute_offset % 4) != 0 || (length % 4) != 0) {
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "fill offset and length must be 4-byte aligned");
+  }
+  uint32_t pattern_word = 0;
+  switch (pattern_length) {
+    case 1:
+      pattern_word = *(const uint8_t*)pattern;
+      pattern_word *= 0x01010101u;
+      break;
+    case 2:
+      pattern_word = *(const uint16_t*)pattern;
+      pattern_word *= 0x00010001u;
+      break;
+    case 4:
+      pattern_word = *(const uint32_t*)pattern;
+      break;
+    default:
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "unsupported fill pattern length %zu",
+                              pattern_length);
+  }
+
+  // Storage bindings must start at an aligned offset; the remainder is
+  // handled by the word offset passed to the builtin.
+  iree_device_size_t binding_offset =
+      absolute_offset -
+      (absolute_offset % IREE_HAL_WEBGPU_STORAGE_BUFFER_OFFSET_ALIGNMENT);
+  iree_hal_descriptor_set_binding_t binding = {
+      .binding = 0,
+      .buffer_slot = 0,
+      .buffer = iree_hal_buffer_allocated_buffer(target_buffer),
+      .offset = binding_offset,
+      .length = IREE_WHOLE_BUFFER,
+  };
+  iree_hal_webgpu_bind_group_state_t set_state;
+  memset(&set_state, 0, sizeof(set_state));
+  IREE_RETURN_IF_ERROR(iree_hal_webgpu_bind_group_cache_acquire(
+      command_buffer->bind_group_cache,
+      iree_hal_webgpu_descriptor_set_layout_handle(
+          builtins->fill_buffer_set_layout),
+      1, &binding, &set_state.handle));
+
+  // Split the fill into dispatches within the workgroup count limit.
+  const uint32_t max_words_per_dispatch =
+      IREE_HAL_WEBGPU_MAX_WORKGROUP_COUNT *
+      IREE_HAL_WEBGPU_FILL_BUFFER_WORKGROUP_SIZE;
+  uint64_t word_offset = (absolute_offset - binding_offset) / 4;
+  uint64_t word_count = length / 4;
+  while (word_count > 0) {
+    uint32_t dispatch_words =
+        (uint32_t)iree_min(word_count, (uint64_t)max_words_per_dispatch);
+    iree_hal_webgpu_fill_buffer_params_t params = {
+        .offset = (uint32_t)word_offset,
+        .length = dispatch_words,
+        .pattern = pattern_word,
+    };
+    WGPUComputePassEncoder compute_pass = NULL;
+    IREE_RETURN_IF_ERROR(iree_hal_webgpu_command_buffer_prepare_dispatch(
+        command_buffer, builtins->fill_buffer_pipeline,
+        builtins->fill_buffer_layout, &set_state, (const uint32_t*)&params,
+        &compute_pass));
+    uint32_t workgroup_count =
+        (dispatch_words + IREE_HAL_WEBGPU_FILL_BUFFER_WORKGROUP_SIZE - 1) /
+        IREE_HAL_WEBGPU_FILL_BUFFER_WORKGROUP_SIZE;
+    wgpuComputePassEncoderDispatchWorkgroups(compute_pass, workgroup_count, 1,
+                                             1);
+    word_offset += dispatch_words;
+    word_count -= dispatch_words;
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_webgpu_command_buffer_update_buffer(
+    iree_hal_command_buffer_t* base_command_buffer, const void* source_buffer,
+    iree_host_size_t source_offset, iree_hal_buffer_t* target_buffer,
+    iree_device_size_t target_offset, iree_device_size_t length) {
+  iree_hal_webgpu_command_buffer_t* command_buffer =
+      iree_hal_webgpu_command_buffer_cast(base_command_buffer);
+  iree_device_size_t absolute_offset =
+      iree_hal_buffer_byte_offset(target_buffer) + target_offset;
+  if ((absolute_offset % 4) != 0 || (length % 4) != 0) {
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "update offset and length must be 4-byte aligned");
+  }
+  WGPUBuffer target_handle = iree_hal_webgpu_buffer_handle(
+      iree_hal_buffer_allocated_buffer(target_buffer));
+
+  // Updates are staged and copied in chunks no larger than the staging buffer.
+  const uint8_t* source = (const uint8_t*)source_buffer + source_offset;
+  iree_host_size_t remaining = (iree_host_size_t)length;
+  while (remaining > 0) {
+    iree_host_size_t chunk_length =
+        iree_min(remaining, command_buffer->staging_buffer->capacity);
+    uint32_t staging_offset = 0;
+    IREE_RETURN_IF_ERROR(iree_hal_webgpu_command_buffer_stage(
+        command_buffer, source, chunk_length, &staging_offset));
+    iree_hal_webgpu_command_buffer_end_compute_pass(command_buffer);
+    WGPUCommandEncoder encoder = NULL;
+    IREE_RETURN_IF_ERROR(
+        iree_hal_webgpu_command_buffer_acquire_encoder(command_buffer,
+                                                       &encoder));
+    wgpuCommandEncoderCopyBufferToBuffer(
+        encoder, command_buffer->staging_buffer->device_buffer,
+        staging_offset, target_handle, absolute_offset, chunk_length);
+    source += chunk_length;
+    absolute_offset += chunk_length;
+    remaining -= chunk_length;
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_webgpu_command_buffer_copy_buffer(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_buffer_t* source_buffer, iree_device_size_t source_offset,
+    iree_hal_buffer_t* target_buffer, iree_device_size_t target_offset,
+    iree_device_size_t length) {
+  iree_hal_webgpu_command_buffer_t* command_buffer =
+      iree_hal_webgpu_command_buffer_cast(base_command_buffer);
+  source_offset += iree_hal_buffer_byte_offset(source_buffer);
+  target_offset += iree_hal_buffer_byte_offset(target_buffer);
+  if ((source_offset % 4) != 0 || (target_offset % 4) != 0 ||
+      (length % 4) != 0) {
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "copy offsets and length must be 4-byte aligned");
+  }
+  iree_hal_webgpu_command_buffer_end_compute_pass(command_buffer);
+  WGPUCommandEncoder encoder = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_hal_webgpu_command_buffer_acquire_encoder(command_buffer, &encoder));
+  wgpuCommandEncoderCopyBufferToBuffer(
+      encoder,
+      iree_hal_webgpu_buffer_handle(
+          iree_hal_buffer_allocated_buffer(source_buffer)),
+      source_offset,
+      iree_hal_webgpu_buffer_handle(
+          iree_hal_buffer_allocated_buffer(target_buffer)),
+      target_offset, length);
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_webgpu_command_buffer_push_constants(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_executable_layout_t* executable_layout, iree_host_size_t offset,
+    const void* values, iree_host_size_t values_length) {
+  iree_hal_webgpu_command_buffer_t* command_buffer =
+      iree_hal_webgpu_command_buffer_cast(base_command_buffer);
+  if (IREE_UNLIKELY(offset + values_length >
+                    sizeof(command_buffer->state.push_constants))) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "push constant range %zu (length=%zu) out of range",
+                            offset, values_length);
+  }
+  memcpy((uint8_t*)&command_buffer->state.push_constants + offset, values,
+         values_length);
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_webgpu_command_buffer_set_bind_group(
+    iree_hal_webgpu_command_buffer_t* command_buffer, uint32_t set,
+    WGPUBindGroup handle, iree_host_size_t dynamic_offset_count,
+    const iree_device_size_t* dynamic_offsets) {
+  if (set >= IREE_HAL_WEBGPU_MAX_DESCRIPTOR_SET_COUNT) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "descriptor set %u over the limit of %d", set,
+                            IREE_HAL_WEBGPU_MAX_DESCRIPTOR_SET_COUNT);
+  }
+  if (dynamic_offset_count > IREE_HAL_WEBGPU_MAX_DYNAMIC_OFFSET_COUNT) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "dynamic offset count %zu over the limit of %d",
+                            dynamic_offset_count,
+                            IREE_HAL_WEBGPU_MAX_DYNAMIC_OFFSET_COUNT);
+  }
+  iree_hal_webgpu_bind_group_state_t* state = &command_buffer->state.sets[set];
+  wgpuBindGroupReference(handle);
+  if (state->handle) wgpuBindGroupRelease(state->handle);
+  state->handle = handle;
+  state->dynamic_offset_count = (uint32_t)dynamic_offset_count;
+  for (iree_host_size_t i = 0; i < dynamic_offset_count; ++i) {
+    state->dynamic_offsets[i] = dynamic_offsets ? (uint32_t)dynamic_offsets[i]
+                                                : 0;
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_webgpu_command_buffer_push_descriptor_set(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_executable_layout_t* executable_layout, uint32_t set,
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_binding_t* bindings) {
+  iree_hal_webgpu_command_buffer_t* command_buffer =
+      iree_hal_webgpu_command_buffer_cast(base_command_buffer);
+  iree_hal_descriptor_set_layout_t* set_layout =
+      iree_hal_webgpu_executable_layout_set_layout(executable_layout, set);
+  if (!set_layout) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "descriptor set %u not in the executable layout",
+                            set);
+  }
+  WGPUBindGroup handle = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_webgpu_bind_group_cache_acquire(
+      command_buffer->bind_group_cache,
+      iree_hal_webgpu_descriptor_set_layout_handle(set_layout), binding_count,
+      bindings, &handle));
+  // Dynamic bindings of pushed sets are bound at offset 0; the binding offsets
+  // already include the ranges.
+  return iree_hal_webgpu_command_buffer_set_bind_group(
+      command_buffer, set, handle,
+      iree_hal_webgpu_descriptor_set_layout_dynamic_binding_count(set_layout),
+      /*dynamic_offsets=*/NULL);
+}
+
+static iree_status_t iree_hal_webgpu_command_buffer_bind_descriptor_set(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_executable_layout_t* executable_layout, uint32_t set,
+    iree_hal_descriptor_set_t* descriptor_set,
+    iree_host_size_t dynamic_offset_count,
+    const iree_device_size_t* dynamic_offsets) {
+  iree_hal_webgpu_command_buffer_t* command_buffer =
+      iree_hal_webgpu_command_buffer_cast(base_command_buffer);
+  return iree_hal_webgpu_command_buffer_set_bind_group(
+      command_buffer, set,
+      iree_hal_webgpu_descriptor_set_handle(descriptor_set),
+      dynamic_offset_count, dynamic_offsets);
+}
+
+static iree_status_t iree_hal_webgpu_command_buffer_prepare_entry_dispatch(
+    iree_hal_webgpu_command_buffer_t* command_buffer,
+    iree_hal_executable_t* executable, int32_t entry_point,
+    WGPUComputePassEncoder* out_compute_pass) {
+  const iree_hal_webgpu_entry_point_t* entry =
+      iree_hal_webgpu_executable_lookup_entry_point(executable,
+                                                    (uint32_t)entry_point);
+  if (!entry) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "entry point %d not found in the executable",
+                            entry_point);
+  }
+  return iree_hal_webgpu_command_buffer_prepare_dispatch(
+      command_buffer, entry->pipeline, entry->layout,
+      command_buffer->state.sets, command_buffer->state.push_constants,
+      out_compute_pass);
+}
+
+static iree_status_t iree_hal_webgpu_command_buffer_dispatch(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_executable_t* executable, int32_t entry_point,
+    uint32_t workgroup_x, uint32_t workgroup_y, uint32_t workgroup_z) {
+  iree_hal_webgpu_command_buffer_t* command_buffer =
+      iree_hal_webgpu_command_buffer_cast(base_command_buffer);
+  WGPUComputePassEncoder compute_pass = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_webgpu_command_buffer_prepare_entry_dispatch(
+      command_buffer, executable, entry_point, &compute_pass));
+  wgpuComputePassEncoderDispatchWorkgroups(compute_pass, workgroup_x,
+                                           workgroup_y, workgroup_z);
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_webgpu_command_buffer_dispatch_indirect(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_executable_t* executable, int32_t entry_point,
+    iree_hal_buffer_t* workgroups_buffer,
+    iree_device_size_t workgroups_offset) {
+  iree_hal_webgpu_command_buffer_t* command_buffer =
+      iree_hal_webgpu_command_buffer_cast(base_command_buffer);
+  WGPUComputePassEncoder compute_pass = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_webgpu_command_buffer_prepare_entry_dispatch(
+      command_buffer, executable, entry_point, &compute_pass));
+  wgpuComputePassEncoderDispatchWorkgroupsIndirect(
+      compute_pass,
+      iree_hal_webgpu_buffer_handle(
+          iree_hal_buffer_allocated_buffer(workgroups_buffer)),
+      iree_hal_buffer_byte_offset(workgroups_buffer) + workgroups_offset);
+  return iree_ok_status();
+}
+
+static const iree_hal_command_buffer_vtable_t
+    iree_hal_webgpu_command_buffer_vtable = {
+        .destroy = iree_hal_webgpu_command_buffer_destroy,
+        .dyn_cast = iree_hal_webgpu_command_buffer_dyn_cast,
+        .begin = iree_hal_webgpu_command_buffer_begin,
+        .end = iree_hal_webgpu_command_buffer_end,
+        .begin_debug_group = iree_hal_webgpu_command_buffer_begin_debug_group,
+        .end_debug_group = iree_hal_webgpu_command_buffer_end_debug_group,
+        .execution_barrier = iree_hal_webgpu_command_buffer_execution_barrier,
+        .signal_event = iree_hal_webgpu_command_buffer_signal_event,
+        .reset_event = iree_hal_webgpu_command_buffer_reset_event,
+        .wait_events = iree_hal_webgpu_command_buffer_wait_events,
+        .discard_buffer = iree_hal_webgpu_command_buffer_discard_buffer,
+        .fill_buffer = iree_hal_webgpu_command_buffer_fill_buffer,
+        .update_buffer = iree_hal_webgpu_command_buffer_update_buffer,
+        .copy_buffer = iree_hal_webgpu_command_buffer_copy_buffer,
+        .push_constants = iree_hal_webgpu_command_buffer_push_constants,
+        .push_descriptor_set =
+            iree_hal_webgpu_command_buffer_push_descriptor_set,
+        .bind_descriptor_set =
+            iree_hal_webgpu_command_buffer_bind_descriptor_set,
+        .dispatch = iree_hal_webgpu_command_buffer_dispatch,
+        .dispatch_indirect = iree_hal_webgpu_command_buffer_dispatch_indirect,
+};
@@ -0,0 +1,45 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_WEBGPU_COMMAND_BUFFER_H_
+#define IREE_HAL_WEBGPU_COMMAND_BUFFER_H_
+
+#include "experimental/webgpu/bind_group_cache.h"
+#include "experimental/webgpu/builtins.h"
+#include "experimental/webgpu/staging_buffer.h"
+#include "experimental/webgpu/webgpu_headers.h"
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Creates a command buffer that records directly into WGPUCommandEncoders and
+// submits them to |queue| when ended.
+//
+// WebGPU command encoders are single-use and cannot be replayed so the device
+// records the commands of all HAL command buffers into deferred command
+// buffers and replays them into a single instance of this command buffer at
+// submission time. Commands requiring more staging memory than remains in
+// |staging_buffer| submit the work recorded so far and continue in a new
+// encoder; because WebGPU executes all submissions of a queue in order this is
+// not observable.
+//
+// |staging_buffer|, |bind_group_cache|, and |builtins| are owned by the device
+// and must remain valid for the lifetime of the command buffer.
+iree_status_t iree_hal_webgpu_command_buffer_create(
+    iree_hal_device_t* base_device, WGPUDevice device, WGPUQueue queue,
+    iree_hal_webgpu_staging_buffer_t* staging_buffer,
+    iree_hal_webgpu_bind_group_cache_t* bind_group_cache,
+    iree_hal_webgpu_builtins_t* builtins, iree_allocator_t host_allocator,
+    iree_hal_command_buffer_t** out_command_buffer);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_WEBGPU_COMMAND_BUFFER_H_
@@ -0,0 +1,89 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "experimental/webgpu/descriptor_set.h"
+
+#include <stddef.h>
+
+#include "experimental/webgpu/bind_group_cache.h"
+#include "experimental/webgpu/descriptor_set_layout.h"
+#include "iree/base/api.h"
+#include "iree/base/tracing.h"
+
+typedef struct iree_hal_webgpu_descriptor_set_t {
+  iree_hal_resource_t resource;
+  iree_allocator_t host_allocator;
+  WGPUBindGroup handle;
+} iree_hal_webgpu_descriptor_set_t;
+
+static const iree_hal_descriptor_set_vtable_t
+    iree_hal_webgpu_descriptor_set_vtable;
+
+static iree_hal_webgpu_descriptor_set_t* iree_hal_webgpu_descriptor_set_cast(
+    iree_hal_descriptor_set_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_hal_webgpu_descriptor_set_vtable);
+  return (iree_hal_webgpu_descriptor_set_t*)base_value;
+}
+
+iree_status_t iree_hal_webgpu_descriptor_set_create(
+    WGPUDevice device, iree_hal_descriptor_set_layout_t* set_layout,
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_binding_t* bindings,
+    iree_allocator_t host_allocator,
+    iree_hal_descriptor_set_t** out_descriptor_set) {
+  IREE_ASSERT_ARGUMENT(device);
+  IREE_ASSERT_ARGUMENT(set_layout);
+  IREE_ASSERT_ARGUMENT(!binding_count || bindings);
+  IREE_ASSERT_ARGUMENT(out_descriptor_set);
+  *out_descriptor_set = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  WGPUBindGroup handle = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_webgpu_bind_group_create(
+              device, iree_hal_webgpu_descriptor_set_layout_handle(set_layout),
+              binding_count, bindings, &handle));
+
+  iree_hal_webgpu_descriptor_set_t* descriptor_set = NULL;
+  iree_status_t status = iree_allocator_malloc(
+      host_allocator, sizeof(*descriptor_set), (void**)&descriptor_set);
+  if (iree_status_is_ok(status)) {
+    iree_hal_resource_initialize(&iree_hal_webgpu_descriptor_set_vtable,
+                                 &descriptor_set->resource);
+    descriptor_set->host_allocator = host_allocator;
+    descriptor_set->handle = handle;
+    *out_descriptor_set = (iree_hal_descriptor_set_t*)descriptor_set;
+  } else {
+    wgpuBindGroupRelease(handle);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_webgpu_descriptor_set_destroy(
+    iree_hal_descriptor_set_t* base_descriptor_set) {
+  iree_hal_webgpu_descriptor_set_t* descriptor_set =
+      iree_hal_webgpu_descriptor_set_cast(base_descriptor_set);
+  iree_allocator_t host_allocator = descriptor_set->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  wgpuBindGroupRelease(descriptor_set->handle);
+  iree_allocator_free(host_allocator, descriptor_set);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+WGPUBindGroup iree_hal_webgpu_descriptor_set_handle(
+    iree_hal_descriptor_set_t* base_descriptor_set) {
+  iree_hal_webgpu_descriptor_set_t* descriptor_set =
+      iree_hal_webgpu_descriptor_set_cast(base_descriptor_set);
+  return descriptor_set->handle;
+}
+
+static const iree_hal_descriptor_set_vtable_t
+    iree_hal_webgpu_descriptor_set_vtable = {
+        .destroy = iree_hal_webgpu_descriptor_set_destroy,
+};
@@ -0,0 +1,157 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "experimental/webgpu/descriptor_set_layout.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "iree/base/api.h"
+#include "iree/base/tracing.h"
+
+typedef struct iree_hal_webgpu_descriptor_set_layout_t {
+  iree_hal_resource_t resource;
+  iree_allocator_t host_allocator;
+  WGPUBindGroupLayout handle;
+  iree_host_size_t binding_count;
+  iree_host_size_t dynamic_binding_count;
+} iree_hal_webgpu_descriptor_set_layout_t;
+
+static const iree_hal_descriptor_set_layout_vtable_t
+    iree_hal_webgpu_descriptor_set_layout_vtable;
+
+static iree_hal_webgpu_descriptor_set_layout_t*
+iree_hal_webgpu_descriptor_set_layout_cast(
+    iree_hal_descriptor_set_layout_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value,
+                       &iree_hal_webgpu_descriptor_set_layout_vtable);
+  return (iree_hal_webgpu_descriptor_set_layout_t*)base_value;
+}
+
+static iree_status_t iree_hal_webgpu_populate_bind_group_layout_entry(
+    const iree_hal_descriptor_set_layout_binding_t* binding,
+    WGPUBindGroupLayoutEntry* out_entry) {
+  memset(out_entry, 0, sizeof(*out_entry));
+  out_entry->binding = binding->binding;
+  out_entry->visibility = WGPUShaderStage_Compute;
+  switch (binding->type) {
+    case IREE_HAL_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+      out_entry->buffer.type = WGPUBufferBindingType_Uniform;
+      break;
+    case IREE_HAL_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+      out_entry->buffer.type = WGPUBufferBindingType_Uniform;
+      out_entry->buffer.hasDynamicOffset = true;
+      break;
+    case IREE_HAL_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+      out_entry->buffer.type = WGPUBufferBindingType_Storage;
+      break;
+    case IREE_HAL_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+      out_entry->buffer.type = WGPUBufferBindingType_Storage;
+      out_entry->buffer.hasDynamicOffset = true;
+      break;
+    default:
+      return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                              "unsupported descriptor type %d",
+                              (int)binding->type);
+  }
+  return iree_ok_status();
+}
+
+iree_status_t iree_hal_webgpu_descriptor_set_layout_create(
+    WGPUDevice device, iree_hal_descriptor_set_layout_usage_type_t usage_type,
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_layout_binding_t* bindings,
+    iree_allocator_t host_allocator,
+    iree_hal_descriptor_set_layout_t** out_descriptor_set_layout) {
+  IREE_ASSERT_ARGUMENT(device);
+  IREE_ASSERT_ARGUMENT(!binding_count || bindings);
+  IREE_ASSERT_ARGUMENT(out_descriptor_set_layout);
+  *out_descriptor_set_layout = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  WGPUBindGroupLayoutEntry* entries = NULL;
+  if (binding_count > 0) {
+    entries = (WGPUBindGroupLayoutEntry*)iree_alloca(binding_count *
+                                                     sizeof(*entries));
+  }
+  iree_host_size_t dynamic_binding_count = 0;
+  for (iree_host_size_t i = 0; i < binding_count; ++i) {
+    IREE_RETURN_AND_END_ZONE_IF_ERROR(
+        z0, iree_hal_webgpu_populate_bind_group_layout_entry(&bindings[i],
+                                                             &entries[i]));
+    if (entries[i].buffer.hasDynamicOffset) ++dynamic_binding_count;
+  }
+
+  WGPUBindGroupLayoutDescriptor descriptor;
+  memset(&descriptor, 0, sizeof(descriptor));
+  descriptor.entryCount = (uint32_t)binding_count;
+  descriptor.entries = entries;
+  WGPUBindGroupLayout handle =
+      wgpuDeviceCreateBindGroupLayout(device, &descriptor);
+  if (!handle) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(IREE_STATUS_INTERNAL,
+                            "failed to create a bind group layout");
+  }
+
+  iree_hal_webgpu_descriptor_set_layout_t* descriptor_set_layout = NULL;
+  iree_status_t status =
+      iree_allocator_malloc(host_allocator, sizeof(*descriptor_set_layout),
+                            (void**)&descriptor_set_layout);
+  if (iree_status_is_ok(status)) {
+    iree_hal_resource_initialize(&iree_hal_webgpu_descriptor_set_layout_vtable,
+                                 &descriptor_set_layout->resource);
+    descriptor_set_layout->host_allocator = host_allocator;
+    descriptor_set_layout->handle = handle;
+    descriptor_set_layout->binding_count = binding_count;
+    descriptor_set_layout->dynamic_binding_count = dynamic_binding_count;
+    *out_descriptor_set_layout =
+        (iree_hal_descriptor_set_layout_t*)descriptor_set_layout;
+  } else {
+    wgpuBindGroupLayoutRelease(handle);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_webgpu_descriptor_set_layout_destroy(
+    iree_hal_descriptor_set_layout_t* base_descriptor_set_layout) {
+  iree_hal_webgpu_descriptor_set_layout_t* descriptor_set_layout =
+      iree_hal_webgpu_descriptor_set_layout_cast(base_descriptor_set_layout);
+  iree_allocator_t host_allocator = descriptor_set_layout->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  wgpuBindGroupLayoutRelease(descriptor_set_layout->handle);
+  iree_allocator_free(host_allocator, descriptor_set_layout);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+WGPUBindGroupLayout iree_hal_webgpu_descriptor_set_layout_handle(
+    iree_hal_descriptor_set_layout_t* base_descriptor_set_layout) {
+  iree_hal_webgpu_descriptor_set_layout_t* descriptor_set_layout =
+      iree_hal_webgpu_descriptor_set_layout_cast(base_descriptor_set_layout);
+  return descriptor_set_layout->handle;
+}
+
+iree_host_size_t iree_hal_webgpu_descriptor_set_layout_binding_count(
+    iree_hal_descriptor_set_layout_t* base_descriptor_set_layout) {
+  iree_hal_webgpu_descriptor_set_layout_t* descriptor_set_layout =
+      iree_hal_webgpu_descriptor_set_layout_cast(base_descriptor_set_layout);
+  return descriptor_set_layout->binding_count;
+}
+
+iree_host_size_t iree_hal_webgpu_descriptor_set_layout_dynamic_binding_count(
+    iree_hal_descriptor_set_layout_t* base_descriptor_set_layout) {
+  iree_hal_webgpu_descriptor_set_layout_t* descriptor_set_layout =
+      iree_hal_webgpu_descriptor_set_layout_cast(base_descriptor_set_layout);
+  return descriptor_set_layout->dynamic_binding_count;
+}
+
+static const iree_hal_descriptor_set_layout_vtable_t
+    iree_hal_webgpu_descriptor_set_layout_vtable = {
+        .destroy = iree_hal_webgpu_descriptor_set_layout_destroy,
+};
@@ -0,0 +1,255 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "experimental/webgpu/executable.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "experimental/webgpu/executable_layout.h"
+#include "iree/base/api.h"
+#include "iree/base/tracing.h"
+
+// flatcc schemas:
+#include "iree/base/internal/flatcc/parsing.h"
+#include "iree/schemas/wgsl_executable_def_reader.h"
+#include "iree/schemas/wgsl_executable_def_verifier.h"
+
+typedef struct iree_hal_webgpu_executable_t {
+  iree_hal_resource_t resource;
+  iree_allocator_t host_allocator;
+  iree_host_size_t entry_point_count;
+  iree_hal_webgpu_entry_point_t entry_points[];
+} iree_hal_webgpu_executable_t;
+
+static const iree_hal_executable_vtable_t iree_hal_webgpu_executable_vtable;
+
+static iree_hal_webgpu_executable_t* iree_hal_webgpu_executable_cast(
+    iree_hal_executable_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_hal_webgpu_executable_vtable);
+  return (iree_hal_webgpu_executable_t*)base_value;
+}
+
+// Verifies the structure of the flatbuffer so that we can avoid doing so during
+// runtime. There are still some conditions we must be aware of (such as omitted
+// names on functions with internal linkage), however we shouldn't need to
+// bounds check anything within the flatbuffer after this succeeds.
+static iree_status_t iree_hal_webgpu_executable_flatbuffer_verify(
+    iree_const_byte_span_t flatbuffer_data,
+    iree_host_size_t expected_entry_point_count) {
+  if (!flatbuffer_data.data || flatbuffer_data.data_length < 16) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "flatbuffer data is not present or less than 16 bytes (%zu total)",
+        flatbuffer_data.data_length);
+  }
+
+  // Run flatcc generated verification. This ensures all pointers are in-bounds
+  // and that we can safely walk the file, but not that the actual contents of
+  // the flatbuffer meet our expectations.
+  int verify_ret = iree_WGSLExecutableDef_verify_as_root(
+      flatbuffer_data.data, flatbuffer_data.data_length);
+  if (verify_ret != flatcc_verify_ok) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "flatbuffer verification failed: %s",
+                            flatcc_verify_error_string(verify_ret));
+  }
+
+  iree_WGSLExecutableDef_table_t executable_def =
+      iree_WGSLExecutableDef_as_root(flatbuffer_data.data);
+
+  iree_WGSLShaderModuleDef_vec_t shader_modules_vec =
+      iree_WGSLExecutableDef_shader_modules_get(executable_def);
+  size_t shader_module_count =
+      iree_WGSLShaderModuleDef_vec_len(shader_modules_vec);
+  for (size_t i = 0; i < shader_module_count; ++i) {
+    iree_WGSLShaderModuleDef_table_t shader_module_def =
+        iree_WGSLShaderModuleDef_vec_at(shader_modules_vec, i);
+    if (!flatbuffers_string_len(
+            iree_WGSLShaderModuleDef_code_get(shader_module_def))) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "shader module %zu has no WGSL code", i);
+    }
+  }
+
+  flatbuffers_int32_vec_t entry_points_vec =
+      iree_WGSLExecutableDef_entry_points_get(executable_def);
+  size_t entry_point_count = flatbuffers_int32_vec_len(entry_points_vec);
+  if (entry_point_count != expected_entry_point_count) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "executable provides %zu entry points but caller "
+                            "provided %zu; must match",
+                            entry_point_count, expected_entry_point_count);
+  }
+  for (size_t i = 0; i < entry_point_count; ++i) {
+    int32_t module_ordinal = flatbuffers_int32_vec_at(entry_points_vec, i);
+    if (module_ordinal < 0 || (size_t)module_ordinal >= shader_module_count) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "executable entry point %zu references an "
+                              "invalid shader module %d",
+                              i, module_ordinal);
+    }
+  }
+
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_webgpu_create_shader_module(
+    WGPUDevice device, iree_WGSLShaderModuleDef_table_t shader_module_def,
+    WGPUShaderModule* out_shader_module) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  WGPUShaderModuleWGSLDescriptor wgsl_descriptor;
+  memset(&wgsl_descriptor, 0, sizeof(wgsl_descriptor));
+  wgsl_descriptor.chain.sType = WGPUSType_ShaderModuleWGSLDescriptor;
+  wgsl_descriptor.source = iree_WGSLShaderModuleDef_code_get(shader_module_def);
+  WGPUShaderModuleDescriptor descriptor;
+  memset(&descriptor, 0, sizeof(descriptor));
+  descriptor.nextInChain = &wgsl_descriptor.chain;
+  *out_shader_module = wgpuDeviceCreateShaderModule(device, &descriptor);
+
+  IREE_TRACE_ZONE_END(z0);
+  if (!*out_shader_module) {
+    return iree_make_status(IREE_STATUS_INTERNAL,
+                            "failed to create a WGSL shader module");
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_webgpu_create_pipeline(
+    WGPUDevice device, WGPUShaderModule shader_module, uint32_t entry_ordinal,
+    iree_hal_executable_layout_t* executable_layout,
+    WGPUComputePipeline* out_pipeline) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Entry points are named by their executable-wide ordinal.
+  char entry_name[16];
+  snprintf(entry_name, sizeof(entry_name), "d%u", entry_ordinal);
+
+  WGPUComputePipelineDescriptor descriptor;
+  memset(&descriptor, 0, sizeof(descriptor));
+  descriptor.layout =
+      iree_hal_webgpu_executable_layout_handle(executable_layout);
+  descriptor.compute.module = shader_module;
+  descriptor.compute.entryPoint = entry_name;
+  *out_pipeline = wgpuDeviceCreateComputePipeline(device, &descriptor);
+
+  IREE_TRACE_ZONE_END(z0);
+  if (!*out_pipeline) {
+    return iree_make_status(IREE_STATUS_INTERNAL,
+                            "failed to create a compute pipeline for entry "
+                            "point %u",
+                            entry_ordinal);
+  }
+  return iree_ok_status();
+}
+
+iree_status_t iree_hal_webgpu_executable_create(
+    WGPUDevice device, const iree_hal_executable_spec_t* executable_spec,
+    iree_allocator_t host_allocator, iree_hal_executable_t** out_executable) {
+  IREE_ASSERT_ARGUMENT(device);
+  IREE_ASSERT_ARGUMENT(executable_spec);
+  IREE_ASSERT_ARGUMENT(out_executable);
+  *out_executable = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_webgpu_executable_flatbuffer_verify(
+              executable_spec->executable_data,
+              executable_spec->executable_layout_count));
+
+  iree_WGSLExecutableDef_table_t executable_def =
+      iree_WGSLExecutableDef_as_root(executable_spec->executable_data.data);
+  iree_WGSLShaderModuleDef_vec_t shader_modules_vec =
+      iree_WGSLExecutableDef_shader_modules_get(executable_def);
+  iree_host_size_t shader_module_count =
+      iree_WGSLShaderModuleDef_vec_len(shader_modules_vec);
+  flatbuffers_int32_vec_t entry_points_vec =
+      iree_WGSLExecutableDef_entry_points_get(executable_def);
+  iree_host_size_t entry_point_count =
+      flatbuffers_int32_vec_len(entry_points_vec);
+
+  iree_hal_webgpu_executable_t* executable = NULL;
+  iree_host_size_t total_size =
+      sizeof(*executable) +
+      entry_point_count * sizeof(executable->entry_points[0]);
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, total_size,
+                                (void**)&executable));
+  memset(executable, 0, total_size);
+  iree_hal_resource_initialize(&iree_hal_webgpu_executable_vtable,
+                               &executable->resource);
+  executable->host_allocator = host_allocator;
+  executable->entry_point_count = entry_point_count;
+
+  // Shader modules are only needed while creating the pipelines; pipelines
+  // retain what they need from them.
+  WGPUShaderModule* shader_modules = (WGPUShaderModule*)iree_alloca(
+      shader_module_count * sizeof(WGPUShaderModule));
+  memset(shader_modules, 0, shader_module_count * sizeof(WGPUShaderModule));
+  iree_status_t status = iree_ok_status();
+  for (iree_host_size_t i = 0; i < shader_module_count; ++i) {
+    status = iree_hal_webgpu_create_shader_module(
+        device, iree_WGSLShaderModuleDef_vec_at(shader_modules_vec, i),
+        &shader_modules[i]);
+    if (!iree_status_is_ok(status)) break;
+  }
+
+  for (iree_host_size_t i = 0; i < entry_point_count; ++i) {
+    if (!iree_status_is_ok(status)) break;
+    iree_hal_webgpu_entry_point_t* entry_point = &executable->entry_points[i];
+    entry_point->layout = executable_spec->executable_layouts[i];
+    iree_hal_executable_layout_retain(entry_point->layout);
+    int32_t module_ordinal = flatbuffers_int32_vec_at(entry_points_vec, i);
+    status = iree_hal_webgpu_create_pipeline(
+        device, shader_modules[module_ordinal], (uint32_t)i,
+        entry_point->layout, &entry_point->pipeline);
+  }
+
+  for (iree_host_size_t i = 0; i < shader_module_count; ++i) {
+    if (shader_modules[i]) wgpuShaderModuleRelease(shader_modules[i]);
+  }
+
+  if (iree_status_is_ok(status)) {
+    *out_executable = (iree_hal_executable_t*)executable;
+  } else {
+    iree_hal_executable_destroy((iree_hal_executable_t*)executable);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_webgpu_executable_destroy(
+    iree_hal_executable_t* base_executable) {
+  iree_hal_webgpu_executable_t* executable =
+      iree_hal_webgpu_executable_cast(base_executable);
+  iree_allocator_t host_allocator = executable->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  for (iree_host_size_t i = 0; i < executable->entry_point_count; ++i) {
+    iree_hal_webgpu_entry_point_t* entry_point = &executable->entry_points[i];
+    if (entry_point->pipeline) {
+      wgpuComputePipelineRelease(entry_point->pipeline);
+    }
+    iree_hal_executable_layout_release(entry_point->layout);
+  }
+  iree_allocator_free(host_allocator, executable);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+const iree_hal_webgpu_entry_point_t*
+iree_hal_webgpu_executable_lookup_entry_point(
+    iree_hal_executable_t* base_executable, uint32_t entry_ordinal) {
+  iree_hal_webgpu_executable_t* executable =
+      iree_hal_webgpu_executable_cast(base_executable);
+  if (entry_ordinal >= executable->entry_point_count) return NULL;
+  return &executable->entry_points[entry_ordinal];
+}
+
+static const iree_hal_executable_vtable_t iree_hal_webgpu_executable_vtable = {
+    .destroy = iree_hal_webgpu_executable_destroy,
+};
@@ -0,0 +1,195 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "experimental/webgpu/executable_layout.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "experimental/webgpu/api.h"
+#include "experimental/webgpu/descriptor_set_layout.h"
+#include "iree/base/api.h"
+#include "iree/base/tracing.h"
+
+typedef struct iree_hal_webgpu_executable_layout_t {
+  iree_hal_resource_t resource;
+  iree_allocator_t host_allocator;
+  WGPUPipelineLayout handle;
+  // Shared layout used for bind groups not covered by a descriptor set; only
+  // retained when the params bind group requires padding.
+  WGPUBindGroupLayout empty_layout;
+  // Shared layout of the push constant bind group; NULL if there are no
+  // constants.
+  WGPUBindGroupLayout params_layout;
+  iree_host_size_t push_constant_count;
+  iree_host_size_t set_layout_count;
+  iree_hal_descriptor_set_layout_t* set_layouts[];
+} iree_hal_webgpu_executable_layout_t;
+
+static const iree_hal_executable_layout_vtable_t
+    iree_hal_webgpu_executable_layout_vtable;
+
+static iree_hal_webgpu_executable_layout_t*
+iree_hal_webgpu_executable_layout_cast(
+    iree_hal_executable_layout_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_hal_webgpu_executable_layout_vtable);
+  return (iree_hal_webgpu_executable_layout_t*)base_value;
+}
+
+static void iree_hal_webgpu_executable_layout_destroy(
+    iree_hal_executable_layout_t* base_executable_layout) {
+  iree_hal_webgpu_executable_layout_t* executable_layout =
+      iree_hal_webgpu_executable_layout_cast(base_executable_layout);
+  iree_allocator_t host_allocator = executable_layout->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  if (executable_layout->handle) {
+    wgpuPipelineLayoutRelease(executable_layout->handle);
+  }
+  if (executable_layout->params_layout) {
+    wgpuBindGroupLayoutRelease(executable_layout->params_layout);
+  }
+  if (executable_layout->empty_layout) {
+    wgpuBindGroupLayoutRelease(executable_layout->empty_layout);
+  }
+  for (iree_host_size_t i = 0; i < executable_layout->set_layout_count; ++i) {
+    iree_hal_descriptor_set_layout_release(executable_layout->set_layouts[i]);
+  }
+  iree_allocator_free(host_allocator, executable_layout);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+iree_status_t iree_hal_webgpu_executable_layout_create(
+    WGPUDevice device, iree_host_size_t set_layout_count,
+    iree_hal_descriptor_set_layout_t** set_layouts,
+    iree_host_size_t push_constant_count, WGPUBindGroupLayout params_layout,
+    WGPUBindGroupLayout empty_layout, iree_allocator_t host_allocator,
+    iree_hal_executable_layout_t** out_executable_layout) {
+  IREE_ASSERT_ARGUMENT(device);
+  IREE_ASSERT_ARGUMENT(params_layout);
+  IREE_ASSERT_ARGUMENT(empty_layout);
+  IREE_ASSERT_ARGUMENT(!set_layout_count || set_layouts);
+  IREE_ASSERT_ARGUMENT(out_executable_layout);
+  *out_executable_layout = NULL;
+  if (set_layout_count > IREE_HAL_WEBGPU_MAX_DESCRIPTOR_SET_COUNT) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "descriptor set count %zu over the limit of %d",
+                            set_layout_count,
+                            IREE_HAL_WEBGPU_MAX_DESCRIPTOR_SET_COUNT);
+  }
+  if (push_constant_count > IREE_HAL_WEBGPU_MAX_PUSH_CONSTANT_COUNT) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "push constant count %zu over the limit of %d",
+                            push_constant_count,
+                            IREE_HAL_WEBGPU_MAX_PUSH_CONSTANT_COUNT);
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_webgpu_executable_layout_t* executable_layout = NULL;
+  iree_host_size_t total_size =
+      sizeof(*executable_layout) +
+      set_layout_count * sizeof(*executable_layout->set_layouts);
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, total_size,
+                                (void**)&executable_layout));
+  memset(executable_layout, 0, total_size);
+  iree_hal_resource_initialize(&iree_hal_webgpu_executable_layout_vtable,
+                               &executable_layout->resource);
+  executable_layout->host_allocator = host_allocator;
+  executable_layout->push_constant_count = push_constant_count;
+  executable_layout->set_layout_count = set_layout_count;
+  for (iree_host_size_t i = 0; i < set_layout_count; ++i) {
+    executable_layout->set_layouts[i] = set_layouts[i];
+    iree_hal_descriptor_set_layout_retain(set_layouts[i]);
+  }
+
+  if (push_constant_count > 0) {
+    executable_layout->params_layout = params_layout;
+    wgpuBindGroupLayoutReference(params_layout);
+    if (set_layout_count < IREE_HAL_WEBGPU_PARAMS_BIND_GROUP_INDEX) {
+      executable_layout->empty_layout = empty_layout;
+      wgpuBindGroupLayoutReference(empty_layout);
+    }
+  }
+
+  WGPUBindGroupLayout
+      bind_group_layouts[IREE_HAL_WEBGPU_PARAMS_BIND_GROUP_INDEX + 1];
+  uint32_t bind_group_layout_count = 0;
+  for (iree_host_size_t i = 0; i < set_layout_count; ++i) {
+    bind_group_layouts[bind_group_layout_count++] =
+        iree_hal_webgpu_descriptor_set_layout_handle(set_layouts[i]);
+  }
+  if (executable_layout->params_layout) {
+    while (bind_group_layout_count < IREE_HAL_WEBGPU_PARAMS_BIND_GROUP_INDEX) {
+      bind_group_layouts[bind_group_layout_count++] =
+          executable_layout->empty_layout;
+    }
+    bind_group_layouts[bind_group_layout_count++] =
+        executable_layout->params_layout;
+  }
+  WGPUPipelineLayoutDescriptor descriptor;
+  memset(&descriptor, 0, sizeof(descriptor));
+  descriptor.bindGroupLayoutCount = bind_group_layout_count;
+  descriptor.bindGroupLayouts = bind_group_layouts;
+  executable_layout->handle =
+      wgpuDeviceCreatePipelineLayout(device, &descriptor);
+  iree_status_t status = iree_ok_status();
+  if (!executable_layout->handle) {
+    status = iree_make_status(IREE_STATUS_INTERNAL,
+                              "failed to create a pipeline layout");
+  }
+
+  if (iree_status_is_ok(status)) {
+    *out_executable_layout = (iree_hal_executable_layout_t*)executable_layout;
+  } else {
+    iree_hal_executable_layout_release(
+        (iree_hal_executable_layout_t*)executable_layout);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+WGPUPipelineLayout iree_hal_webgpu_executable_layout_handle(
+    iree_hal_executable_layout_t* base_executable_layout) {
+  iree_hal_webgpu_executable_layout_t* executable_layout =
+      iree_hal_webgpu_executable_layout_cast(base_executable_layout);
+  return executable_layout->handle;
+}
+
+iree_hal_descriptor_set_layout_t* iree_hal_webgpu_executable_layout_set_layout(
+    iree_hal_executable_layout_t* base_executable_layout, uint32_t set) {
+  iree_hal_webgpu_executable_layout_t* executable_layout =
+      iree_hal_webgpu_executable_layout_cast(base_executable_layout);
+  if (set >= executable_layout->set_layout_count) return NULL;
+  return executable_layout->set_layouts[set];
+}
+
+iree_host_size_t iree_hal_webgpu_executable_layout_set_layout_count(
+    iree_hal_executable_layout_t* base_executable_layout) {
+  iree_hal_webgpu_executable_layout_t* executable_layout =
+      iree_hal_webgpu_executable_layout_cast(base_executable_layout);
+  return executable_layout->set_layout_count;
+}
+
+iree_host_size_t iree_hal_webgpu_executable_layout_push_constant_count(
+    iree_hal_executable_layout_t* base_executable_layout) {
+  iree_hal_webgpu_executable_layout_t* executable_layout =
+      iree_hal_webgpu_executable_layout_cast(base_executable_layout);
+  return executable_layout->push_constant_count;
+}
+
+WGPUBindGroupLayout iree_hal_webgpu_executable_layout_params_layout(
+    iree_hal_executable_layout_t* base_executable_layout) {
+  iree_hal_webgpu_executable_layout_t* executable_layout =
+      iree_hal_webgpu_executable_layout_cast(base_executable_layout);
+  return executable_layout->params_layout;
+}
+
+static const iree_hal_executable_layout_vtable_t
+    iree_hal_webgpu_executable_layout_vtable = {
+        .destroy = iree_hal_webgpu_executable_layout_destroy,
+};
@@ -0,0 +1,59 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_WEBGPU_EXECUTABLE_LAYOUT_H_
+#define IREE_HAL_WEBGPU_EXECUTABLE_LAYOUT_H_
+
+#include "experimental/webgpu/webgpu_headers.h"
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Creates an executable layout backed by a WGPUPipelineLayout.
+//
+// Descriptor sets map to bind groups 0 to
+// IREE_HAL_WEBGPU_MAX_DESCRIPTOR_SET_COUNT-1. When the layout has push
+// constants they are bound as a dynamic uniform buffer at
+// @group(IREE_HAL_WEBGPU_PARAMS_BIND_GROUP_INDEX) @binding(0) and any unused
+// groups before it are given |empty_layout|. |params_layout| and
+// |empty_layout| are shared by all executable layouts of a device so that the
+// same bind groups can be used with all of them.
+iree_status_t iree_hal_webgpu_executable_layout_create(
+    WGPUDevice device, iree_host_size_t set_layout_count,
+    iree_hal_descriptor_set_layout_t** set_layouts,
+    iree_host_size_t push_constant_count, WGPUBindGroupLayout params_layout,
+    WGPUBindGroupLayout empty_layout, iree_allocator_t host_allocator,
+    iree_hal_executable_layout_t** out_executable_layout);
+
+// Returns the WGPUPipelineLayout handle of the layout.
+WGPUPipelineLayout iree_hal_webgpu_executable_layout_handle(
+    iree_hal_executable_layout_t* executable_layout);
+
+// Returns the number of descriptor sets in the layout.
+iree_host_size_t iree_hal_webgpu_executable_layout_set_layout_count(
+    iree_hal_executable_layout_t* executable_layout);
+
+// Returns the descriptor set layout for |set| or NULL if out of range.
+iree_hal_descriptor_set_layout_t* iree_hal_webgpu_executable_layout_set_layout(
+    iree_hal_executable_layout_t* executable_layout, uint32_t set);
+
+// Returns the number of 32-bit push constants in the layout.
+iree_host_size_t iree_hal_webgpu_executable_layout_push_constant_count(
+    iree_hal_executable_layout_t* executable_layout);
+
+// Returns the layout of the push constant bind group or NULL if the layout has
+// no push constants.
+WGPUBindGroupLayout iree_hal_webgpu_executable_layout_params_layout(
+    iree_hal_executable_layout_t* executable_layout);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_WEBGPU_EXECUTABLE_LAYOUT_H_
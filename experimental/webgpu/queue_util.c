@@ -0,0 +1,250 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "experimental/webgpu/queue_util.h"
+
+#include <inttypes.h>
+#include <string.h>
+
+#include "iree/base/internal/atomics.h"
+#include "iree/base/tracing.h"
+
+#if !defined(IREE_HAL_WEBGPU_POLL)
+#if defined(IREE_PLATFORM_EMSCRIPTEN)
+#define IREE_HAL_WEBGPU_POLL(device) emscripten_sleep(0)
+#else
+#define IREE_HAL_WEBGPU_POLL(device) wgpuDeviceTick(device)
+#endif  // IREE_PLATFORM_EMSCRIPTEN
+#endif  // !IREE_HAL_WEBGPU_POLL
+
+void iree_hal_webgpu_poll(WGPUDevice device) { IREE_HAL_WEBGPU_POLL(device); }
+
+//===----------------------------------------------------------------------===//
+// iree_hal_webgpu_completion_t
+//===----------------------------------------------------------------------===//
+
+// Tracks the completion of an asynchronous WebGPU operation.
+// The completion is referenced by both the waiter and the callback so that a
+// waiter timing out before the callback fires does not free it from under the
+// callback.
+typedef struct iree_hal_webgpu_completion_t {
+  iree_atomic_ref_count_t ref_count;
+  iree_allocator_t host_allocator;
+  iree_atomic_int32_t is_signaled;
+  // WGPU*Status value the operation completed with.
+  int32_t result;
+} iree_hal_webgpu_completion_t;
+
+static iree_status_t iree_hal_webgpu_completion_create(
+    iree_allocator_t host_allocator,
+    iree_hal_webgpu_completion_t** out_completion) {
+  iree_hal_webgpu_completion_t* completion = NULL;
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+      host_allocator, sizeof(*completion), (void**)&completion));
+  // One reference for the waiter and one for the callback.
+  iree_atomic_ref_count_init(&completion->ref_count);
+  iree_atomic_ref_count_inc(&completion->ref_count);
+  completion->host_allocator = host_allocator;
+  iree_atomic_store_int32(&completion->is_signaled, 0,
+                          iree_memory_order_relaxed);
+  completion->result = 0;
+  *out_completion = completion;
+  return iree_ok_status();
+}
+
+static void iree_hal_webgpu_completion_release(
+    iree_hal_webgpu_completion_t* completion) {
+  if (iree_atomic_ref_count_dec(&completion->ref_count) == 1) {
+    iree_allocator_free(completion->host_allocator, completion);
+  }
+}
+
+static void iree_hal_webgpu_completion_signal(
+    iree_hal_webgpu_completion_t* completion, int32_t result) {
+  completion->result = result;
+  iree_atomic_store_int32(&completion->is_signaled, 1,
+                          iree_memory_order_release);
+  iree_hal_webgpu_completion_release(completion);
+}
+
+static void iree_hal_webgpu_queue_work_done_callback(
+    WGPUQueueWorkDoneStatus status, void* userdata) {
+  iree_hal_webgpu_completion_signal((iree_hal_webgpu_completion_t*)userdata,
+                                    (int32_t)status);
+}
+
+static void iree_hal_webgpu_buffer_map_callback(WGPUBufferMapAsyncStatus status,
+                                                void* userdata) {
+  iree_hal_webgpu_completion_signal((iree_hal_webgpu_completion_t*)userdata,
+                                    (int32_t)status);
+}
+
+// Polls |device| until |completion| is signaled or |timeout| elapses and
+// releases the waiter reference.
+static iree_status_t iree_hal_webgpu_completion_wait(
+    WGPUDevice device, iree_hal_webgpu_completion_t* completion,
+    iree_timeout_t timeout, int32_t* out_result) {
+  iree_time_t deadline_ns = iree_timeout_as_deadline_ns(timeout);
+  iree_status_t status = iree_ok_status();
+  for (;;) {
+    iree_hal_webgpu_poll(device);
+    if (iree_atomic_load_int32(&completion->is_signaled,
+                               iree_memory_order_acquire)) {
+      *out_result = completion->result;
+      break;
+    }
+    if (iree_time_now() >= deadline_ns) {
+      status = iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+      break;
+    }
+  }
+  iree_hal_webgpu_completion_release(completion);
+  return status;
+}
+
+//===----------------------------------------------------------------------===//
+// Queue operations
+//===----------------------------------------------------------------------===//
+
+iree_status_t iree_hal_webgpu_queue_wait_idle(WGPUDevice device,
+                                              WGPUQueue queue,
+                                              iree_allocator_t host_allocator,
+                                              iree_timeout_t timeout) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_hal_webgpu_completion_t* completion = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_webgpu_completion_create(host_allocator, &completion));
+  wgpuQueueOnSubmittedWorkDone(queue, /*signalValue=*/0,
+                               iree_hal_webgpu_queue_work_done_callback,
+                               completion);
+  int32_t result = 0;
+  iree_status_t status =
+      iree_hal_webgpu_completion_wait(device, completion, timeout, &result);
+  if (iree_status_is_ok(status) && result != WGPUQueueWorkDoneStatus_Success) {
+    status = iree_make_status(IREE_STATUS_INTERNAL,
+                              "queue work failed to complete (status %d)",
+                              (int)result);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+iree_status_t iree_hal_webgpu_queue_read_buffer(
+    WGPUDevice device, WGPUQueue queue, WGPUBuffer source,
+    uint64_t source_offset, void* target, iree_host_size_t length,
+    iree_allocator_t host_allocator, iree_timeout_t timeout) {
+  if (length == 0) return iree_ok_status();
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)length);
+
+  // Copies must be 4-byte aligned so widen the range and skip the leading
+  // bytes when reading it back.
+  uint64_t aligned_offset = source_offset & ~3ull;
+  iree_host_size_t lead_length =
+      (iree_host_size_t)(source_offset - aligned_offset);
+  uint64_t aligned_length = iree_host_align(lead_length + length, 4);
+
+  WGPUBufferDescriptor descriptor;
+  memset(&descriptor, 0, sizeof(descriptor));
+  descriptor.label = "iree-hal-webgpu-readback";
+  descriptor.usage = WGPUBufferUsage_MapRead | WGPUBufferUsage_CopyDst;
+  descriptor.size = aligned_length;
+  WGPUBuffer readback_buffer = wgpuDeviceCreateBuffer(device, &descriptor);
+  if (!readback_buffer) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                            "failed to create a %" PRIu64 "B readback buffer",
+                            aligned_length);
+  }
+
+  WGPUCommandEncoderDescriptor encoder_descriptor;
+  memset(&encoder_descriptor, 0, sizeof(encoder_descriptor));
+  WGPUCommandEncoder encoder =
+      wgpuDeviceCreateCommandEncoder(device, &encoder_descriptor);
+  wgpuCommandEncoderCopyBufferToBuffer(encoder, source, aligned_offset,
+                                       readback_buffer, 0, aligned_length);
+  WGPUCommandBufferDescriptor command_buffer_descriptor;
+  memset(&command_buffer_descriptor, 0, sizeof(command_buffer_descriptor));
+  WGPUCommandBuffer command_buffer =
+      wgpuCommandEncoderFinish(encoder, &command_buffer_descriptor);
+  wgpuCommandEncoderRelease(encoder);
+  wgpuQueueSubmit(queue, 1, &command_buffer);
+  wgpuCommandBufferRelease(command_buffer);
+
+  // Mapping completes once the copy has executed.
+  iree_hal_webgpu_completion_t* completion = NULL;
+  iree_status_t status =
+      iree_hal_webgpu_completion_create(host_allocator, &completion);
+  if (iree_status_is_ok(status)) {
+    wgpuBufferMapAsync(readback_buffer, WGPUMapMode_Read, 0,
+                       (size_t)aligned_length,
+                       iree_hal_webgpu_buffer_map_callback, completion);
+    int32_t result = 0;
+    status =
+        iree_hal_webgpu_completion_wait(device, completion, timeout, &result);
+    if (iree_status_is_ok(status) &&
+        result != WGPUBufferMapAsyncStatus_Success) {
+      status = iree_make_status(IREE_STATUS_INTERNAL,
+                                "failed to map readback buffer (status %d)",
+                                (int)result);
+    }
+  }
+  if (iree_status_is_ok(status)) {
+    const uint8_t* mapped_ptr = (const uint8_t*)wgpuBufferGetConstMappedRange(
+        readback_buffer, 0, (size_t)aligned_length);
+    memcpy(target, mapped_ptr + lead_length, length);
+  }
+
+  // Destroying the buffer unmaps it and aborts any map still pending.
+  wgpuBufferDestroy(readback_buffer);
+  wgpuBufferRelease(readback_buffer);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+iree_status_t iree_hal_webgpu_queue_write_buffer(
+    WGPUDevice device, WGPUQueue queue, WGPUBuffer target,
+    uint64_t target_offset, const void* source, iree_host_size_t length,
+    iree_allocator_t host_allocator, iree_timeout_t timeout) {
+  if (length == 0) return iree_ok_status();
+  if ((target_offset % 4) == 0 && (length % 4) == 0) {
+    wgpuQueueWriteBuffer(queue, target, target_offset, source, length);
+    return iree_ok_status();
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Queue writes must be 4-byte aligned: widen the range and fill the bytes
+  // outside of the requested range with their current contents.
+  uint64_t aligned_offset = target_offset & ~3ull;
+  uint64_t aligned_end = iree_host_align(target_offset + length, 4);
+  iree_host_size_t aligned_length =
+      (iree_host_size_t)(aligned_end - aligned_offset);
+  uint8_t* staging = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, aligned_length,
+                                (void**)&staging));
+  iree_status_t status = iree_ok_status();
+  if (aligned_offset != target_offset) {
+    status = iree_hal_webgpu_queue_read_buffer(device, queue, target,
+                                               aligned_offset, staging, 4,
+                                               host_allocator, timeout);
+  }
+  if (iree_status_is_ok(status) && aligned_end != target_offset + length) {
+    status = iree_hal_webgpu_queue_read_buffer(
+        device, queue, target, aligned_end - 4, staging + aligned_length - 4,
+        4, host_allocator, timeout);
+  }
+  if (iree_status_is_ok(status)) {
+    memcpy(staging + (target_offset - aligned_offset), source, length);
+    wgpuQueueWriteBuffer(queue, target, aligned_offset, staging,
+                         aligned_length);
+  }
+  iree_allocator_free(host_allocator, staging);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
@@ -0,0 +1,51 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_WEBGPU_QUEUE_UTIL_H_
+#define IREE_HAL_WEBGPU_QUEUE_UTIL_H_
+
+#include "experimental/webgpu/webgpu_headers.h"
+#include "iree/base/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Processes pending WebGPU callbacks on |device|. With Dawn this ticks the
+// device and in browsers this yields to the event loop (requires ASYNCIFY).
+// Implementations with other polling mechanisms (such as wgpu-native's
+// wgpuDevicePoll) can be used by defining IREE_HAL_WEBGPU_POLL(device).
+void iree_hal_webgpu_poll(WGPUDevice device);
+
+// Polls |device| until all work submitted to |queue| has completed.
+iree_status_t iree_hal_webgpu_queue_wait_idle(WGPUDevice device,
+                                              WGPUQueue queue,
+                                              iree_allocator_t host_allocator,
+                                              iree_timeout_t timeout);
+
+// Reads |length| bytes from |source| starting at |source_offset| into
+// |target| by copying them to a temporary mappable buffer. Blocks until the
+// data is available. Offsets and lengths need not be 4-byte aligned so long as
+// the aligned range is within the buffer.
+iree_status_t iree_hal_webgpu_queue_read_buffer(
+    WGPUDevice device, WGPUQueue queue, WGPUBuffer source,
+    uint64_t source_offset, void* target, iree_host_size_t length,
+    iree_allocator_t host_allocator, iree_timeout_t timeout);
+
+// Writes |length| bytes from |source| to |target| starting at
+// |target_offset| on |queue|. The write is ordered after all prior
+// submissions and before all subsequent ones. Unaligned writes preserve the
+// surrounding bytes of the partially written words and block to read them.
+iree_status_t iree_hal_webgpu_queue_write_buffer(
+    WGPUDevice device, WGPUQueue queue, WGPUBuffer target,
+    uint64_t target_offset, const void* source, iree_host_size_t length,
+    iree_allocator_t host_allocator, iree_timeout_t timeout);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_WEBGPU_QUEUE_UTIL_H_
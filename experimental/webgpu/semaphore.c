@@ -0,0 +1,194 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "experimental/webgpu/semaphore.h"
+
+#include <inttypes.h>
+#include <stddef.h>
+
+#include "experimental/webgpu/queue_util.h"
+#include "iree/base/api.h"
+#include "iree/base/internal/atomics.h"
+#include "iree/base/tracing.h"
+
+typedef struct iree_hal_webgpu_semaphore_t {
+  iree_hal_resource_t resource;
+  iree_allocator_t host_allocator;
+  WGPUDevice device;
+  iree_atomic_int64_t value;
+  // First failure of the semaphore (iree_status_t); OK while not failed.
+  iree_atomic_intptr_t failure_status;
+} iree_hal_webgpu_semaphore_t;
+
+static const iree_hal_semaphore_vtable_t iree_hal_webgpu_semaphore_vtable;
+
+static iree_hal_webgpu_semaphore_t* iree_hal_webgpu_semaphore_cast(
+    iree_hal_semaphore_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_hal_webgpu_semaphore_vtable);
+  return (iree_hal_webgpu_semaphore_t*)base_value;
+}
+
+iree_status_t iree_hal_webgpu_semaphore_create(
+    WGPUDevice device, uint64_t initial_value, iree_allocator_t host_allocator,
+    iree_hal_semaphore_t** out_semaphore) {
+  IREE_ASSERT_ARGUMENT(device);
+  IREE_ASSERT_ARGUMENT(out_semaphore);
+  *out_semaphore = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_webgpu_semaphore_t* semaphore = NULL;
+  iree_status_t status = iree_allocator_malloc(
+      host_allocator, sizeof(*semaphore), (void**)&semaphore);
+  if (iree_status_is_ok(status)) {
+    iree_hal_resource_initialize(&iree_hal_webgpu_semaphore_vtable,
+                                 &semaphore->resource);
+    semaphore->host_allocator = host_allocator;
+    semaphore->device = device;
+    iree_atomic_store_int64(&semaphore->value, (int64_t)initial_value,
+                            iree_memory_order_relaxed);
+    iree_atomic_store_intptr(&semaphore->failure_status,
+                             (intptr_t)iree_ok_status(),
+                             iree_memory_order_relaxed);
+    *out_semaphore = (iree_hal_semaphore_t*)semaphore;
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_webgpu_semaphore_destroy(
+    iree_hal_semaphore_t* base_semaphore) {
+  iree_hal_webgpu_semaphore_t* semaphore =
+      iree_hal_webgpu_semaphore_cast(base_semaphore);
+  iree_allocator_t host_allocator = semaphore->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_status_ignore((iree_status_t)iree_atomic_load_intptr(
+      &semaphore->failure_status, iree_memory_order_acquire));
+  iree_allocator_free(host_allocator, semaphore);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+static iree_status_t iree_hal_webgpu_semaphore_query(
+    iree_hal_semaphore_t* base_semaphore, uint64_t* out_value) {
+  iree_hal_webgpu_semaphore_t* semaphore =
+      iree_hal_webgpu_semaphore_cast(base_semaphore);
+  *out_value = (uint64_t)iree_atomic_load_int64(&semaphore->value,
+                                                iree_memory_order_acquire);
+  iree_status_t failure_status = (iree_status_t)iree_atomic_load_intptr(
+      &semaphore->failure_status, iree_memory_order_acquire);
+  if (!iree_status_is_ok(failure_status)) {
+    return iree_status_clone(failure_status);
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_webgpu_semaphore_signal(
+    iree_hal_semaphore_t* base_semaphore, uint64_t new_value) {
+  iree_hal_webgpu_semaphore_t* semaphore =
+      iree_hal_webgpu_semaphore_cast(base_semaphore);
+  uint64_t old_value = (uint64_t)iree_atomic_load_int64(
+      &semaphore->value, iree_memory_order_acquire);
+  if (new_value <= old_value) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "semaphore values must be monotonically "
+                            "increasing; current value is %" PRIu64
+                            " and new value is %" PRIu64,
+                            old_value, new_value);
+  }
+  iree_atomic_store_int64(&semaphore->value, (int64_t)new_value,
+                          iree_memory_order_release);
+  return iree_ok_status();
+}
+
+static void iree_hal_webgpu_semaphore_fail(iree_hal_semaphore_t* base_semaphore,
+                                           iree_status_t status) {
+  iree_hal_webgpu_semaphore_t* semaphore =
+      iree_hal_webgpu_semaphore_cast(base_semaphore);
+  iree_status_t old_status = iree_ok_status();
+  if (!iree_atomic_compare_exchange_strong_intptr(
+          &semaphore->failure_status, (intptr_t*)&old_status,
+          (intptr_t)status, iree_memory_order_acq_rel,
+          iree_memory_order_relaxed)) {
+    // Previous status was not OK; drop our new status.
+    IREE_IGNORE_ERROR(status);
+  }
+}
+
+// Returns true if |semaphore| has reached |value| and sets |out_status| to a
+// failure if the semaphore has failed.
+static bool iree_hal_webgpu_semaphore_is_reached(
+    iree_hal_semaphore_t* base_semaphore, uint64_t value,
+    iree_status_t* out_status) {
+  iree_hal_webgpu_semaphore_t* semaphore =
+      iree_hal_webgpu_semaphore_cast(base_semaphore);
+  if (iree_atomic_load_intptr(&semaphore->failure_status,
+                              iree_memory_order_acquire)) {
+    *out_status = iree_status_from_code(IREE_STATUS_ABORTED);
+    return true;
+  }
+  return (uint64_t)iree_atomic_load_int64(&semaphore->value,
+                                          iree_memory_order_acquire) >= value;
+}
+
+iree_status_t iree_hal_webgpu_semaphore_multi_wait(
+    WGPUDevice device, iree_hal_wait_mode_t wait_mode,
+    const iree_hal_semaphore_list_t* semaphore_list, iree_timeout_t timeout) {
+  if (semaphore_list->count == 0) return iree_ok_status();
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_time_t deadline_ns = iree_timeout_as_deadline_ns(timeout);
+  iree_status_t status = iree_ok_status();
+  for (;;) {
+    iree_host_size_t reached_count = 0;
+    for (iree_host_size_t i = 0; i < semaphore_list->count; ++i) {
+      if (iree_hal_webgpu_semaphore_is_reached(
+              semaphore_list->semaphores[i], semaphore_list->payload_values[i],
+              &status)) {
+        ++reached_count;
+      }
+      if (!iree_status_is_ok(status)) break;
+    }
+    if (!iree_status_is_ok(status)) break;
+    if (reached_count == semaphore_list->count ||
+        (wait_mode == IREE_HAL_WAIT_MODE_ANY && reached_count > 0)) {
+      break;
+    }
+    if (iree_time_now() >= deadline_ns) {
+      status = iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+      break;
+    }
+    // Semaphores are signaled from queue callbacks that only run while the
+    // device is polled.
+    iree_hal_webgpu_poll(device);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static iree_status_t iree_hal_webgpu_semaphore_wait(
+    iree_hal_semaphore_t* base_semaphore, uint64_t value,
+    iree_timeout_t timeout) {
+  iree_hal_webgpu_semaphore_t* semaphore =
+      iree_hal_webgpu_semaphore_cast(base_semaphore);
+  iree_hal_semaphore_list_t semaphore_list = {
+      .count = 1,
+      .semaphores = &base_semaphore,
+      .payload_values = &value,
+  };
+  return iree_hal_webgpu_semaphore_multi_wait(
+      semaphore->device, IREE_HAL_WAIT_MODE_ALL, &semaphore_list, timeout);
+}
+
+static const iree_hal_semaphore_vtable_t iree_hal_webgpu_semaphore_vtable = {
+    .destroy = iree_hal_webgpu_semaphore_destroy,
+    .query = iree_hal_webgpu_semaphore_query,
+    .signal = iree_hal_webgpu_semaphore_signal,
+    .fail = iree_hal_webgpu_semaphore_fail,
+    .wait = iree_hal_webgpu_semaphore_wait,
+};
@@ -0,0 +1,36 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_WEBGPU_SEMAPHORE_H_
+#define IREE_HAL_WEBGPU_SEMAPHORE_H_
+
+#include "experimental/webgpu/webgpu_headers.h"
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Creates a host-side timeline semaphore.
+// WebGPU has no device-side synchronization primitives: the device signals
+// semaphores when queue work completes and waits poll the device until the
+// payload is reached.
+iree_status_t iree_hal_webgpu_semaphore_create(
+    WGPUDevice device, uint64_t initial_value, iree_allocator_t host_allocator,
+    iree_hal_semaphore_t** out_semaphore);
+
+// Waits on all or any of the semaphores in |semaphore_list| by polling
+// |device|.
+iree_status_t iree_hal_webgpu_semaphore_multi_wait(
+    WGPUDevice device, iree_hal_wait_mode_t wait_mode,
+    const iree_hal_semaphore_list_t* semaphore_list, iree_timeout_t timeout);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_WEBGPU_SEMAPHORE_H_
@@ -0,0 +1,186 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "experimental/webgpu/staging_buffer.h"
+
+#include <string.h>
+
+#include "experimental/webgpu/api.h"
+#include "iree/base/tracing.h"
+
+static iree_status_t iree_hal_webgpu_staging_buffer_create_params(
+    WGPUDevice device, iree_hal_webgpu_staging_buffer_t* staging_buffer) {
+  WGPUBindGroupLayoutEntry layout_entry;
+  memset(&layout_entry, 0, sizeof(layout_entry));
+  layout_entry.binding = 0;
+  layout_entry.visibility = WGPUShaderStage_Compute;
+  layout_entry.buffer.type = WGPUBufferBindingType_Uniform;
+  layout_entry.buffer.hasDynamicOffset = true;
+  layout_entry.buffer.minBindingSize = IREE_HAL_WEBGPU_PARAMS_BINDING_SIZE;
+  WGPUBindGroupLayoutDescriptor layout_descriptor;
+  memset(&layout_descriptor, 0, sizeof(layout_descriptor));
+  layout_descriptor.label = "iree-hal-webgpu-params";
+  layout_descriptor.entryCount = 1;
+  layout_descriptor.entries = &layout_entry;
+  staging_buffer->params_layout =
+      wgpuDeviceCreateBindGroupLayout(device, &layout_descriptor);
+  if (!staging_buffer->params_layout) {
+    return iree_make_status(IREE_STATUS_INTERNAL,
+                            "failed to create the params bind group layout");
+  }
+
+  WGPUBindGroupEntry entry;
+  memset(&entry, 0, sizeof(entry));
+  entry.binding = 0;
+  entry.buffer = staging_buffer->device_buffer;
+  entry.offset = 0;
+  entry.size = IREE_HAL_WEBGPU_PARAMS_BINDING_SIZE;
+  WGPUBindGroupDescriptor descriptor;
+  memset(&descriptor, 0, sizeof(descriptor));
+  descriptor.label = "iree-hal-webgpu-params";
+  descriptor.layout = staging_buffer->params_layout;
+  descriptor.entryCount = 1;
+  descriptor.entries = &entry;
+  staging_buffer->params_bind_group =
+      wgpuDeviceCreateBindGroup(device, &descriptor);
+  if (!staging_buffer->params_bind_group) {
+    return iree_make_status(IREE_STATUS_INTERNAL,
+                            "failed to create the params bind group");
+  }
+
+  memset(&layout_descriptor, 0, sizeof(layout_descriptor));
+  layout_descriptor.label = "iree-hal-webgpu-empty";
+  staging_buffer->empty_layout =
+      wgpuDeviceCreateBindGroupLayout(device, &layout_descriptor);
+  if (!staging_buffer->empty_layout) {
+    return iree_make_status(IREE_STATUS_INTERNAL,
+                            "failed to create an empty bind group layout");
+  }
+  memset(&descriptor, 0, sizeof(descriptor));
+  descriptor.label = "iree-hal-webgpu-empty";
+  descriptor.layout = staging_buffer->empty_layout;
+  staging_buffer->empty_bind_group =
+      wgpuDeviceCreateBindGroup(device, &descriptor);
+  if (!staging_buffer->empty_bind_group) {
+    return iree_make_status(IREE_STATUS_INTERNAL,
+                            "failed to create an empty bind group");
+  }
+  return iree_ok_status();
+}
+
+iree_status_t iree_hal_webgpu_staging_buffer_initialize(
+    WGPUDevice device, WGPUQueue queue, iree_host_size_t capacity,
+    iree_allocator_t host_allocator,
+    iree_hal_webgpu_staging_buffer_t* out_staging_buffer) {
+  IREE_ASSERT_ARGUMENT(device);
+  IREE_ASSERT_ARGUMENT(out_staging_buffer);
+  memset(out_staging_buffer, 0, sizeof(*out_staging_buffer));
+  // The params binding may start at any allocation and must fit in the
+  // device buffer.
+  const iree_host_size_t params_size = IREE_HAL_WEBGPU_PARAMS_BINDING_SIZE;
+  capacity =
+      iree_host_align(capacity, IREE_HAL_WEBGPU_STAGING_BUFFER_ALIGNMENT);
+  if (capacity < params_size) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "staging buffer capacity %zu is smaller than the "
+                            "%zu byte push constant binding",
+                            capacity, params_size);
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  out_staging_buffer->queue = queue;
+  out_staging_buffer->host_allocator = host_allocator;
+  out_staging_buffer->capacity = capacity;
+  // The device buffer has room for a full params binding at the last
+  // allocation in the buffer.
+  iree_host_size_t device_size = capacity + params_size;
+  iree_status_t status = iree_allocator_malloc(
+      host_allocator, capacity, (void**)&out_staging_buffer->host_buffer);
+
+  if (iree_status_is_ok(status)) {
+    WGPUBufferDescriptor descriptor;
+    memset(&descriptor, 0, sizeof(descriptor));
+    descriptor.label = "iree-hal-webgpu-staging";
+    descriptor.usage = WGPUBufferUsage_Uniform | WGPUBufferUsage_CopySrc |
+                       WGPUBufferUsage_CopyDst;
+    descriptor.size = device_size;
+    out_staging_buffer->device_buffer =
+        wgpuDeviceCreateBuffer(device, &descriptor);
+    if (!out_staging_buffer->device_buffer) {
+      status = iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                                "failed to create a %zuB staging buffer",
+                                device_size);
+    }
+  }
+
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_webgpu_staging_buffer_create_params(device,
+                                                          out_staging_buffer);
+  }
+
+  if (!iree_status_is_ok(status)) {
+    iree_hal_webgpu_staging_buffer_deinitialize(out_staging_buffer);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+void iree_hal_webgpu_staging_buffer_deinitialize(
+    iree_hal_webgpu_staging_buffer_t* staging_buffer) {
+  if (staging_buffer->empty_bind_group) {
+    wgpuBindGroupRelease(staging_buffer->empty_bind_group);
+  }
+  if (staging_buffer->empty_layout) {
+    wgpuBindGroupLayoutRelease(staging_buffer->empty_layout);
+  }
+  if (staging_buffer->params_bind_group) {
+    wgpuBindGroupRelease(staging_buffer->params_bind_group);
+  }
+  if (staging_buffer->params_layout) {
+    wgpuBindGroupLayoutRelease(staging_buffer->params_layout);
+  }
+  if (staging_buffer->device_buffer) {
+    wgpuBufferDestroy(staging_buffer->device_buffer);
+    wgpuBufferRelease(staging_buffer->device_buffer);
+  }
+  iree_allocator_free(staging_buffer->host_allocator,
+                      staging_buffer->host_buffer);
+  memset(staging_buffer, 0, sizeof(*staging_buffer));
+}
+
+iree_status_t iree_hal_webgpu_staging_buffer_append(
+    iree_hal_webgpu_staging_buffer_t* staging_buffer, const void* data,
+    iree_host_size_t data_length, uint32_t* out_offset) {
+  iree_host_size_t aligned_length =
+      iree_host_align(data_length, IREE_HAL_WEBGPU_STAGING_BUFFER_ALIGNMENT);
+  if (aligned_length > staging_buffer->capacity) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "%zu bytes is larger than the %zu byte staging "
+                            "buffer",
+                            data_length, staging_buffer->capacity);
+  }
+  if (staging_buffer->offset + aligned_length > staging_buffer->capacity) {
+    return iree_status_from_code(IREE_STATUS_RESOURCE_EXHAUSTED);
+  }
+  uint8_t* target = staging_buffer->host_buffer + staging_buffer->offset;
+  memcpy(target, data, data_length);
+  // Zero the padding so that uploads are deterministic.
+  memset(target + data_length, 0, aligned_length - data_length);
+  *out_offset = (uint32_t)staging_buffer->offset;
+  staging_buffer->offset += aligned_length;
+  return iree_ok_status();
+}
+
+void iree_hal_webgpu_staging_buffer_flush(
+    iree_hal_webgpu_staging_buffer_t* staging_buffer) {
+  if (staging_buffer->offset == 0) return;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)staging_buffer->offset);
+  wgpuQueueWriteBuffer(staging_buffer->queue, staging_buffer->device_buffer, 0,
+                       staging_buffer->host_buffer, staging_buffer->offset);
+  staging_buffer->offset = 0;
+  IREE_TRACE_ZONE_END(z0);
+}
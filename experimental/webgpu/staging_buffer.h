@@ -0,0 +1,86 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_WEBGPU_STAGING_BUFFER_H_
+#define IREE_HAL_WEBGPU_STAGING_BUFFER_H_
+
+#include "experimental/webgpu/api.h"
+#include "experimental/webgpu/webgpu_headers.h"
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Alignment of staged allocations. This is the WebGPU default (and maximum)
+// minUniformBufferOffsetAlignment so that any allocation can be bound as a
+// dynamic uniform buffer offset.
+#define IREE_HAL_WEBGPU_STAGING_BUFFER_ALIGNMENT 256
+
+// Size, in bytes, of the push constant uniform binding.
+#define IREE_HAL_WEBGPU_PARAMS_BINDING_SIZE \
+  (IREE_HAL_WEBGPU_MAX_PUSH_CONSTANT_COUNT * sizeof(uint32_t))
+
+// A linear allocator of host memory uploaded to a device uniform buffer.
+//
+// Push constants and iree_hal_command_buffer_update_buffer contents are
+// appended to the host shadow while recording and uploaded with a single
+// queue write before the command buffer referencing them is submitted. Queue
+// writes are ordered with submissions so the buffer can be reset and reused
+// as soon as the upload has been issued.
+//
+// Push constants are bound with the params bind group which references the
+// device buffer with a dynamic offset selecting the staged constants of each
+// dispatch. WebGPU considers bind group layouts created with the same entries
+// equivalent and the params and padding bind groups are shared by all
+// executable layouts.
+//
+// Thread-compatible; the device serializes access.
+typedef struct iree_hal_webgpu_staging_buffer_t {
+  WGPUQueue queue;
+  iree_allocator_t host_allocator;
+  iree_host_size_t capacity;
+  // Offset of the next allocation in the host shadow.
+  iree_host_size_t offset;
+  uint8_t* host_buffer;
+  WGPUBuffer device_buffer;
+  // Shared layout of the push constant bind group used by all executable
+  // layouts with push constants.
+  WGPUBindGroupLayout params_layout;
+  // Bind group referencing |device_buffer| with |params_layout|.
+  WGPUBindGroup params_bind_group;
+  // Shared empty layout and bind group used to fill the bind groups between
+  // the last descriptor set of an executable layout and the params group.
+  WGPUBindGroupLayout empty_layout;
+  WGPUBindGroup empty_bind_group;
+} iree_hal_webgpu_staging_buffer_t;
+
+iree_status_t iree_hal_webgpu_staging_buffer_initialize(
+    WGPUDevice device, WGPUQueue queue, iree_host_size_t capacity,
+    iree_allocator_t host_allocator,
+    iree_hal_webgpu_staging_buffer_t* out_staging_buffer);
+
+void iree_hal_webgpu_staging_buffer_deinitialize(
+    iree_hal_webgpu_staging_buffer_t* staging_buffer);
+
+// Copies |data| into the staging buffer and returns its offset in the device
+// buffer. Returns IREE_STATUS_RESOURCE_EXHAUSTED if the buffer has no more
+// room, in which case the caller must flush and retry.
+iree_status_t iree_hal_webgpu_staging_buffer_append(
+    iree_hal_webgpu_staging_buffer_t* staging_buffer, const void* data,
+    iree_host_size_t data_length, uint32_t* out_offset);
+
+// Uploads all staged data to the device buffer and resets the buffer.
+// Must be called before submitting the work referencing staged data.
+void iree_hal_webgpu_staging_buffer_flush(
+    iree_hal_webgpu_staging_buffer_t* staging_buffer);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_WEBGPU_STAGING_BUFFER_H_
@@ -0,0 +1,246 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "experimental/webgpu/webgpu_allocator.h"
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "experimental/webgpu/buffer.h"
+#include "experimental/webgpu/queue_util.h"
+#include "iree/base/api.h"
+#include "iree/base/tracing.h"
+
+typedef struct iree_hal_webgpu_allocator_t {
+  iree_hal_resource_t resource;
+  iree_hal_device_t* base_device;
+  iree_allocator_t host_allocator;
+  WGPUDevice device;
+  WGPUQueue queue;
+
+  IREE_STATISTICS(iree_hal_allocator_statistics_t statistics;)
+} iree_hal_webgpu_allocator_t;
+
+static const iree_hal_allocator_vtable_t iree_hal_webgpu_allocator_vtable;
+
+static iree_hal_webgpu_allocator_t* iree_hal_webgpu_allocator_cast(
+    iree_hal_allocator_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_hal_webgpu_allocator_vtable);
+  return (iree_hal_webgpu_allocator_t*)base_value;
+}
+
+iree_status_t iree_hal_webgpu_allocator_create(
+    iree_hal_device_t* base_device, WGPUDevice device, WGPUQueue queue,
+    iree_allocator_t host_allocator, iree_hal_allocator_t** out_allocator) {
+  IREE_ASSERT_ARGUMENT(base_device);
+  IREE_ASSERT_ARGUMENT(device);
+  IREE_ASSERT_ARGUMENT(out_allocator);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_webgpu_allocator_t* allocator = NULL;
+  iree_status_t status = iree_allocator_malloc(
+      host_allocator, sizeof(*allocator), (void**)&allocator);
+  if (iree_status_is_ok(status)) {
+    memset(allocator, 0, sizeof(*allocator));
+    iree_hal_resource_initialize(&iree_hal_webgpu_allocator_vtable,
+                                 &allocator->resource);
+    allocator->base_device = base_device;
+    allocator->host_allocator = host_allocator;
+    allocator->device = device;
+    allocator->queue = queue;
+    *out_allocator = (iree_hal_allocator_t*)allocator;
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_webgpu_allocator_destroy(
+    iree_hal_allocator_t* base_allocator) {
+  iree_hal_webgpu_allocator_t* allocator =
+      iree_hal_webgpu_allocator_cast(base_allocator);
+  iree_allocator_t host_allocator = allocator->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_allocator_free(host_allocator, allocator);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+static iree_allocator_t iree_hal_webgpu_allocator_host_allocator(
+    const iree_hal_allocator_t* base_allocator) {
+  iree_hal_webgpu_allocator_t* allocator =
+      (iree_hal_webgpu_allocator_t*)base_allocator;
+  return allocator->host_allocator;
+}
+
+static iree_status_t iree_hal_webgpu_allocator_trim(
+    iree_hal_allocator_t* base_allocator) {
+  return iree_ok_status();
+}
+
+static void iree_hal_webgpu_allocator_query_statistics(
+    iree_hal_allocator_t* base_allocator,
+    iree_hal_allocator_statistics_t* out_statistics) {
+  IREE_STATISTICS({
+    iree_hal_webgpu_allocator_t* allocator =
+        iree_hal_webgpu_allocator_cast(base_allocator);
+    memcpy(out_statistics, &allocator->statistics, sizeof(*out_statistics));
+  });
+}
+
+static iree_hal_buffer_compatibility_t
+iree_hal_webgpu_allocator_query_buffer_compatibility(
+    iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_buffer_usage_t allowed_usage,
+    iree_hal_buffer_usage_t intended_usage,
+    iree_device_size_t allocation_size) {
+  // Disallow usage not permitted by the buffer itself. Since we then use this
+  // to determine compatibility below we'll naturally set the right compat flags
+  // based on what's both allowed and intended.
+  intended_usage &= allowed_usage;
+
+  // All buffers are device buffers; host-visible ones are mapped by copying.
+  iree_hal_buffer_compatibility_t compatibility =
+      IREE_HAL_BUFFER_COMPATIBILITY_ALLOCATABLE;
+
+  // Buffers can only be used on the queue if they are device visible.
+  if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE)) {
+    if (iree_all_bits_set(intended_usage, IREE_HAL_BUFFER_USAGE_TRANSFER)) {
+      compatibility |= IREE_HAL_BUFFER_COMPATIBILITY_QUEUE_TRANSFER;
+    }
+    if (iree_all_bits_set(intended_usage, IREE_HAL_BUFFER_USAGE_DISPATCH)) {
+      compatibility |= IREE_HAL_BUFFER_COMPATIBILITY_QUEUE_DISPATCH;
+    }
+  }
+
+  return compatibility;
+}
+
+static iree_status_t iree_hal_webgpu_allocator_allocate_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_buffer_usage_t allowed_usage, iree_host_size_t allocation_size,
+    iree_const_byte_span_t initial_data, iree_hal_buffer_t** out_buffer) {
+  iree_hal_webgpu_allocator_t* allocator =
+      iree_hal_webgpu_allocator_cast(base_allocator);
+  // WebGPU buffers must be non-empty and copies and queue writes operate on
+  // 4-byte aligned ranges. Rounding up the allocation keeps widened copies of
+  // unaligned ranges within the buffer.
+  allocation_size = iree_host_align(iree_max(allocation_size, 4), 4);
+
+  // All buffers may be copied to and from so that they can be transferred and
+  // mapped through the queue.
+  WGPUBufferUsageFlags usage_flags =
+      WGPUBufferUsage_CopySrc | WGPUBufferUsage_CopyDst;
+  if (iree_all_bits_set(allowed_usage, IREE_HAL_BUFFER_USAGE_DISPATCH)) {
+    usage_flags |= WGPUBufferUsage_Storage | WGPUBufferUsage_Uniform |
+                   WGPUBufferUsage_Indirect;
+  }
+
+  IREE_TRACE_ZONE_BEGIN_NAMED(z0, "iree_hal_webgpu_buffer_allocate");
+  WGPUBufferDescriptor descriptor;
+  memset(&descriptor, 0, sizeof(descriptor));
+  descriptor.usage = usage_flags;
+  descriptor.size = allocation_size;
+  WGPUBuffer handle = wgpuDeviceCreateBuffer(allocator->device, &descriptor);
+  IREE_TRACE_ZONE_END(z0);
+  if (!handle) {
+    return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                            "failed to create a %zuB WebGPU buffer",
+                            allocation_size);
+  }
+
+  iree_hal_buffer_t* buffer = NULL;
+  iree_status_t status = iree_hal_webgpu_buffer_wrap(
+      allocator->device, allocator->queue, base_allocator, memory_type,
+      IREE_HAL_MEMORY_ACCESS_ALL, allowed_usage, allocation_size,
+      /*byte_offset=*/0, /*byte_length=*/allocation_size, handle, &buffer);
+
+  // Upload the initial contents; queue writes are ordered before any
+  // subsequently submitted work.
+  if (iree_status_is_ok(status) &&
+      !iree_const_byte_span_is_empty(initial_data)) {
+    status = iree_hal_webgpu_queue_write_buffer(
+        allocator->device, allocator->queue, handle, 0, initial_data.data,
+        initial_data.data_length, allocator->host_allocator,
+        iree_infinite_timeout());
+  }
+
+  if (iree_status_is_ok(status)) {
+    IREE_STATISTICS(iree_hal_allocator_statistics_record_alloc(
+        &allocator->statistics, memory_type, allocation_size));
+    *out_buffer = buffer;
+  } else if (!buffer) {
+    wgpuBufferDestroy(handle);
+    wgpuBufferRelease(handle);
+  } else {
+    iree_hal_buffer_release(buffer);
+  }
+  return status;
+}
+
+static void iree_hal_webgpu_allocator_deallocate_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_buffer_t* base_buffer) {
+  iree_hal_webgpu_allocator_t* allocator =
+      iree_hal_webgpu_allocator_cast(base_allocator);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Destroying the buffer releases its memory immediately; WebGPU defers the
+  // destruction until work already submitted using the buffer has completed.
+  WGPUBuffer handle = iree_hal_webgpu_buffer_handle(base_buffer);
+  wgpuBufferDestroy(handle);
+  wgpuBufferRelease(handle);
+
+  IREE_STATISTICS(iree_hal_allocator_statistics_record_free(
+      &allocator->statistics, iree_hal_buffer_memory_type(base_buffer),
+      iree_hal_buffer_allocation_size(base_buffer)));
+
+  iree_hal_buffer_destroy(base_buffer);
+  IREE_TRACE_ZONE_END(z0);
+}
+
+static iree_status_t iree_hal_webgpu_allocator_wrap_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_memory_access_t allowed_access,
+    iree_hal_buffer_usage_t allowed_usage, iree_byte_span_t data,
+    iree_allocator_t data_allocator, iree_hal_buffer_t** out_buffer) {
+  return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                          "wrapping of host memory is not supported");
+}
+
+static iree_status_t iree_hal_webgpu_allocator_import_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_memory_access_t allowed_access,
+    iree_hal_buffer_usage_t allowed_usage,
+    iree_hal_external_buffer_t* external_buffer,
+    iree_hal_buffer_t** out_buffer) {
+  return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                          "importing from external buffers not supported");
+}
+
+static iree_status_t iree_hal_webgpu_allocator_export_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_buffer_t* buffer,
+    iree_hal_external_buffer_type_t requested_type,
+    iree_hal_external_buffer_flags_t requested_flags,
+    iree_hal_external_buffer_t* out_external_buffer) {
+  return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                          "exporting to external buffers not supported");
+}
+
+static const iree_hal_allocator_vtable_t iree_hal_webgpu_allocator_vtable = {
+    .destroy = iree_hal_webgpu_allocator_destroy,
+    .host_allocator = iree_hal_webgpu_allocator_host_allocator,
+    .trim = iree_hal_webgpu_allocator_trim,
+    .query_statistics = iree_hal_webgpu_allocator_query_statistics,
+    .query_buffer_compatibility =
+        iree_hal_webgpu_allocator_query_buffer_compatibility,
+    .allocate_buffer = iree_hal_webgpu_allocator_allocate_buffer,
+    .deallocate_buffer = iree_hal_webgpu_allocator_deallocate_buffer,
+    .wrap_buffer = iree_hal_webgpu_allocator_wrap_buffer,
+    .import_buffer = iree_hal_webgpu_allocator_import_buffer,
+    .export_buffer = iree_hal_webgpu_allocator_export_buffer,
+};
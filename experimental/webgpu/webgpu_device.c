@@ -0,0 +1,604 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "experimental/webgpu/api.h"
+#include "experimental/webgpu/bind_group_cache.h"
+#include "experimental/webgpu/buffer.h"
+#include "experimental/webgpu/builtins.h"
+#include "experimental/webgpu/command_buffer.h"
+#include "experimental/webgpu/descriptor_set.h"
+#include "experimental/webgpu/descriptor_set_layout.h"
+#include "experimental/webgpu/executable_layout.h"
+#include "experimental/webgpu/nop_event.h"
+#include "experimental/webgpu/nop_executable_cache.h"
+#include "experimental/webgpu/queue_util.h"
+#include "experimental/webgpu/semaphore.h"
+#include "experimental/webgpu/staging_buffer.h"
+#include "experimental/webgpu/webgpu_allocator.h"
+#include "iree/base/internal/arena.h"
+#include "iree/base/tracing.h"
+#include "iree/hal/utils/deferred_command_buffer.h"
+
+//===----------------------------------------------------------------------===//
+// iree_hal_webgpu_device_t
+//===----------------------------------------------------------------------===//
+
+typedef struct iree_hal_webgpu_device_t {
+  iree_hal_resource_t resource;
+  iree_string_view_t identifier;
+
+  // Block pool used for command buffers with a larger block size (as command
+  // buffers can contain inlined data uploads).
+  iree_arena_block_pool_t block_pool;
+
+  iree_hal_webgpu_device_options_t options;
+  iree_allocator_t host_allocator;
+
+  WGPUDevice handle;
+  WGPUQueue queue;
+
+  iree_hal_allocator_t* device_allocator;
+
+  // Ring buffer of push constants and update_buffer source data shared by all
+  // command buffers executed on the queue.
+  iree_hal_webgpu_staging_buffer_t staging_buffer;
+
+  // Bind groups created for push descriptor sets and builtin dispatches.
+  iree_hal_webgpu_bind_group_cache_t bind_group_cache;
+
+  // Pipelines used to emulate commands WebGPU has no native equivalent for.
+  iree_hal_webgpu_builtins_t builtins;
+
+  // Command buffer encoding directly to the queue that deferred command buffers
+  // are replayed into on submission.
+  iree_hal_command_buffer_t* command_buffer;
+} iree_hal_webgpu_device_t;
+
+static const iree_hal_device_vtable_t iree_hal_webgpu_device_vtable;
+
+static iree_hal_webgpu_device_t* iree_hal_webgpu_device_cast(
+    iree_hal_device_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_hal_webgpu_device_vtable);
+  return (iree_hal_webgpu_device_t*)base_value;
+}
+
+IREE_API_EXPORT void iree_hal_webgpu_device_options_initialize(
+    iree_hal_webgpu_device_options_t* out_options) {
+  memset(out_options, 0, sizeof(*out_options));
+  out_options->arena_block_size = 32 * 1024;
+  out_options->staging_buffer_size = 64 * 1024;
+  out_options->bind_group_cache_capacity = 64;
+}
+
+static iree_status_t iree_hal_webgpu_device_check_options(
+    const iree_hal_webgpu_device_options_t* options) {
+  if (options->arena_block_size < 4096) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "arena block size too small (< 4096 bytes)");
+  }
+  if (options->staging_buffer_size < IREE_HAL_WEBGPU_PARAMS_BINDING_SIZE) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "staging buffer too small to hold push constants (< %zu bytes)",
+        (size_t)IREE_HAL_WEBGPU_PARAMS_BINDING_SIZE);
+  }
+  return iree_ok_status();
+}
+
+static void iree_hal_webgpu_device_destroy(iree_hal_device_t* base_device);
+
+IREE_API_EXPORT iree_status_t iree_hal_webgpu_wrap_device(
+    iree_string_view_t identifier,
+    const iree_hal_webgpu_device_options_t* options, WGPUDevice handle,
+    iree_allocator_t host_allocator, iree_hal_device_t** out_device) {
+  IREE_ASSERT_ARGUMENT(options);
+  IREE_ASSERT_ARGUMENT(handle);
+  IREE_ASSERT_ARGUMENT(out_device);
+  *out_device = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_webgpu_device_check_options(options));
+
+  iree_hal_webgpu_device_t* device = NULL;
+  iree_host_size_t total_size = iree_sizeof_struct(*device) + identifier.size;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, total_size, (void**)&device));
+  memset(device, 0, total_size);
+  iree_hal_resource_initialize(&iree_hal_webgpu_device_vtable,
+                               &device->resource);
+  iree_string_view_append_to_buffer(
+      identifier, &device->identifier,
+      (char*)device + iree_sizeof_struct(*device));
+  iree_arena_block_pool_initialize(options->arena_block_size, host_allocator,
+                                   &device->block_pool);
+  device->options = *options;
+  device->host_allocator = host_allocator;
+  wgpuDeviceReference(handle);
+  device->handle = handle;
+  device->queue = wgpuDeviceGetQueue(handle);
+
+  iree_status_t status = iree_hal_webgpu_allocator_create(
+      (iree_hal_device_t*)device, device->handle, device->queue,
+      host_allocator, &device->device_allocator);
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_webgpu_staging_buffer_initialize(
+        device->handle, device->queue, options->staging_buffer_size,
+        host_allocator, &device->staging_buffer);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_webgpu_bind_group_cache_initialize(
+        device->handle, options->bind_group_cache_capacity, host_allocator,
+        &device->bind_group_cache);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_webgpu_builtins_initialize(
+        device->handle, &device->staging_buffer, host_allocator,
+        &device->builtins);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_webgpu_command_buffer_create(
+        (iree_hal_device_t*)device, device->handle, device->queue,
+        &device->staging_buffer, &device->bind_group_cache,
+        &device->builtins, host_allocator, &device->command_buffer);
+  }
+
+  if (iree_status_is_ok(status)) {
+    *out_device = (iree_hal_device_t*)device;
+  } else {
+    iree_hal_webgpu_device_destroy((iree_hal_device_t*)device);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_webgpu_device_destroy(iree_hal_device_t* base_device) {
+  iree_hal_webgpu_device_t* device = iree_hal_webgpu_device_cast(base_device);
+  iree_allocator_t host_allocator = device->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Wait for in-flight work so that their completion callbacks run before the
+  // state they reference is released.
+  if (device->queue) {
+    iree_status_ignore(iree_hal_webgpu_queue_wait_idle(
+        device->handle, device->queue, host_allocator,
+        iree_infinite_timeout()));
+  }
+
+  // There should be no more buffers live that use the allocator.
+  iree_hal_command_buffer_release(device->command_buffer);
+  iree_hal_webgpu_builtins_deinitialize(&device->builtins);
+  iree_hal_webgpu_bind_group_cache_deinitialize(&device->bind_group_cache);
+  iree_hal_webgpu_staging_buffer_deinitialize(&device->staging_buffer);
+  iree_hal_allocator_release(device->device_allocator);
+
+  iree_arena_block_pool_deinitialize(&device->block_pool);
+
+  if (device->queue) wgpuQueueRelease(device->queue);
+  wgpuDeviceRelease(device->handle);
+
+  iree_allocator_free(host_allocator, device);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+static iree_string_view_t iree_hal_webgpu_device_id(
+    iree_hal_device_t* base_device) {
+  iree_hal_webgpu_device_t* device = iree_hal_webgpu_device_cast(base_device);
+  return device->identifier;
+}
+
+static iree_allocator_t iree_hal_webgpu_device_host_allocator(
+    iree_hal_device_t* base_device) {
+  iree_hal_webgpu_device_t* device = iree_hal_webgpu_device_cast(base_device);
+  return device->host_allocator;
+}
+
+static iree_hal_allocator_t* iree_hal_webgpu_device_allocator(
+    iree_hal_device_t* base_device) {
+  iree_hal_webgpu_device_t* device = iree_hal_webgpu_device_cast(base_device);
+  return device->device_allocator;
+}
+
+static iree_status_t iree_hal_webgpu_device_trim(
+    iree_hal_device_t* base_device) {
+  iree_hal_webgpu_device_t* device = iree_hal_webgpu_device_cast(base_device);
+  iree_arena_block_pool_trim(&device->block_pool);
+  iree_hal_webgpu_bind_group_cache_trim(&device->bind_group_cache);
+  return iree_hal_allocator_trim(device->device_allocator);
+}
+
+static iree_status_t iree_hal_webgpu_device_query_i32(
+    iree_hal_device_t* base_device, iree_string_view_t category,
+    iree_string_view_t key, int32_t* out_value) {
+  *out_value = 0;
+
+  if (iree_string_view_equal(category,
+                             iree_make_cstring_view("hal.executable.format"))) {
+    *out_value =
+        iree_string_view_equal(key, iree_make_cstring_view("webgpu-wgsl-fb"))
+            ? 1
+            : 0;
+    return iree_ok_status();
+  }
+
+  return iree_make_status(
+      IREE_STATUS_NOT_FOUND,
+      "unknown device configuration key value '%.*s :: %.*s'",
+      (int)category.size, category.data, (int)key.size, key.data);
+}
+
+static iree_status_t iree_hal_webgpu_device_create_command_buffer(
+    iree_hal_device_t* base_device, iree_hal_command_buffer_mode_t mode,
+    iree_hal_command_category_t command_categories,
+    iree_hal_queue_affinity_t queue_affinity,
+    iree_hal_command_buffer_t** out_command_buffer) {
+  iree_hal_webgpu_device_t* device = iree_hal_webgpu_device_cast(base_device);
+  // Commands are recorded and replayed into the queue command buffer on
+  // submission. Replay resolves indirect bindings from the batch binding table
+  // so all modes are supported.
+  return iree_hal_deferred_command_buffer_create(
+      base_device, mode, command_categories, &device->block_pool,
+      device->host_allocator, out_command_buffer);
+}
+
+static iree_status_t iree_hal_webgpu_device_create_descriptor_set(
+    iree_hal_device_t* base_device,
+    iree_hal_descriptor_set_layout_t* set_layout,
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_binding_t* bindings,
+    iree_hal_descriptor_set_t** out_descriptor_set) {
+  iree_hal_webgpu_device_t* device = iree_hal_webgpu_device_cast(base_device);
+  return iree_hal_webgpu_descriptor_set_create(
+      device->handle, set_layout, binding_count, bindings,
+      device->host_allocator, out_descriptor_set);
+}
+
+static iree_status_t iree_hal_webgpu_device_create_descriptor_set_layout(
+    iree_hal_device_t* base_device,
+    iree_hal_descriptor_set_layout_usage_type_t usage_type,
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_layout_binding_t* bindings,
+    iree_hal_descriptor_set_layout_t** out_descriptor_set_layout) {
+  iree_hal_webgpu_device_t* device = iree_hal_webgpu_device_cast(base_device);
+  return iree_hal_webgpu_descriptor_set_layout_create(
+      device->handle, usage_type, binding_count, bindings,
+      device->host_allocator, out_descriptor_set_layout);
+}
+
+static iree_status_t iree_hal_webgpu_device_create_event(
+    iree_hal_device_t* base_device, iree_hal_event_t** out_event) {
+  iree_hal_webgpu_device_t* device = iree_hal_webgpu_device_cast(base_device);
+  return iree_hal_webgpu_nop_event_create(device->host_allocator, out_event);
+}
+
+static iree_status_t iree_hal_webgpu_device_create_executable_cache(
+    iree_hal_device_t* base_device, iree_string_view_t identifier,
+    iree_hal_executable_cache_t** out_executable_cache) {
+  iree_hal_webgpu_device_t* device = iree_hal_webgpu_device_cast(base_device);
+  return iree_hal_webgpu_nop_executable_cache_create(
+      device->handle, identifier, device->host_allocator,
+      out_executable_cache);
+}
+
+static iree_status_t iree_hal_webgpu_device_create_executable_layout(
+    iree_hal_device_t* base_device, iree_host_size_t push_constants,
+    iree_host_size_t set_layout_count,
+    iree_hal_descriptor_set_layout_t** set_layouts,
+    iree_hal_executable_layout_t** out_executable_layout) {
+  iree_hal_webgpu_device_t* device = iree_hal_webgpu_device_cast(base_device);
+  return iree_hal_webgpu_executable_layout_create(
+      device->handle, set_layout_count, set_layouts, push_constants,
+      device->staging_buffer.params_layout, device->staging_buffer.empty_layout,
+      device->host_allocator, out_executable_layout);
+}
+
+static iree_status_t iree_hal_webgpu_device_create_semaphore(
+    iree_hal_device_t* base_device, uint64_t initial_value,
+    iree_hal_semaphore_t** out_semaphore) {
+  iree_hal_webgpu_device_t* device = iree_hal_webgpu_device_cast(base_device);
+  return iree_hal_webgpu_semaphore_create(device->handle, initial_value,
+                                          device->host_allocator,
+                                          out_semaphore);
+}
+
+// Returns the WebGPU buffer backing |buffer| and the absolute offset of
+// |offset| within it.
+static WGPUBuffer iree_hal_webgpu_device_resolve_buffer(
+    iree_hal_buffer_t* buffer, iree_device_size_t offset,
+    uint64_t* out_offset) {
+  *out_offset = iree_hal_buffer_byte_offset(buffer) + offset;
+  return iree_hal_webgpu_buffer_handle(
+      iree_hal_buffer_allocated_buffer(buffer));
+}
+
+static iree_status_t iree_hal_webgpu_device_transfer_range(
+    iree_hal_device_t* base_device, iree_hal_transfer_buffer_t source,
+    iree_device_size_t source_offset, iree_hal_transfer_buffer_t target,
+    iree_device_size_t target_offset, iree_device_size_t data_length,
+    iree_hal_transfer_buffer_flags_t flags, iree_timeout_t timeout) {
+  iree_hal_webgpu_device_t* device = iree_hal_webgpu_device_cast(base_device);
+  if (data_length == 0) return iree_ok_status();
+
+  uint64_t source_device_offset = 0;
+  uint64_t target_device_offset = 0;
+  if (!source.device_buffer && !target.device_buffer) {
+    // Host->host.
+    memcpy(target.host_buffer.data + target_offset,
+           source.host_buffer.data + source_offset, (size_t)data_length);
+    return iree_ok_status();
+  } else if (!source.device_buffer) {
+    // Host->device: queue writes are ordered with prior submissions.
+    WGPUBuffer target_handle = iree_hal_webgpu_device_resolve_buffer(
+        target.device_buffer, target_offset, &target_device_offset);
+    return iree_hal_webgpu_queue_write_buffer(
+        device->handle, device->queue, target_handle, target_device_offset,
+        source.host_buffer.data + source_offset, (iree_host_size_t)data_length,
+        device->host_allocator, timeout);
+  } else if (!target.device_buffer) {
+    // Device->host: read back through a staging buffer once prior work has
+    // completed.
+    WGPUBuffer source_handle = iree_hal_webgpu_device_resolve_buffer(
+        source.device_buffer, source_offset, &source_device_offset);
+    return iree_hal_webgpu_queue_read_buffer(
+        device->handle, device->queue, source_handle, source_device_offset,
+        target.host_buffer.data + target_offset, (iree_host_size_t)data_length,
+        device->host_allocator, timeout);
+  }
+
+  // Device->device.
+  WGPUBuffer source_handle = iree_hal_webgpu_device_resolve_buffer(
+      source.device_buffer, source_offset, &source_device_offset);
+  WGPUBuffer target_handle = iree_hal_webgpu_device_resolve_buffer(
+      target.device_buffer, target_offset, &target_device_offset);
+  if ((source_device_offset % 4) != 0 || (target_device_offset % 4) != 0 ||
+      (data_length % 4) != 0) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "device to device transfers must be 4-byte aligned");
+  }
+  WGPUCommandEncoderDescriptor encoder_descriptor;
+  memset(&encoder_descriptor, 0, sizeof(encoder_descriptor));
+  WGPUCommandEncoder encoder =
+      wgpuDeviceCreateCommandEncoder(device->handle, &encoder_descriptor);
+  wgpuCommandEncoderCopyBufferToBuffer(encoder, source_handle,
+                                       source_device_offset, target_handle,
+                                       target_device_offset, data_length);
+  WGPUCommandBufferDescriptor command_buffer_descriptor;
+  memset(&command_buffer_descriptor, 0, sizeof(command_buffer_descriptor));
+  WGPUCommandBuffer command_buffer =
+      wgpuCommandEncoderFinish(encoder, &command_buffer_descriptor);
+  wgpuCommandEncoderRelease(encoder);
+  wgpuQueueSubmit(device->queue, 1, &command_buffer);
+  wgpuCommandBufferRelease(command_buffer);
+  return iree_hal_webgpu_queue_wait_idle(device->handle, device->queue,
+                                         device->host_allocator, timeout);
+}
+
+// Signals all semaphores in |semaphore_list| to their payload values.
+static iree_status_t iree_hal_webgpu_device_signal_semaphores(
+    const iree_hal_semaphore_list_t* semaphore_list) {
+  for (iree_host_size_t i = 0; i < semaphore_list->count; ++i) {
+    IREE_RETURN_IF_ERROR(iree_hal_semaphore_signal(
+        semaphore_list->semaphores[i], semaphore_list->payload_values[i]));
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_webgpu_device_queue_alloca(
+    iree_hal_device_t* base_device, iree_hal_queue_affinity_t queue_affinity,
+    const iree_hal_semaphore_list_t wait_semaphore_list,
+    const iree_hal_semaphore_list_t signal_semaphore_list,
+    iree_hal_memory_type_t memory_type, iree_hal_buffer_usage_t allowed_usage,
+    iree_device_size_t allocation_size, iree_hal_buffer_t** out_buffer) {
+  iree_hal_webgpu_device_t* device = iree_hal_webgpu_device_cast(base_device);
+  // WebGPU has no queue-ordered allocation: wait on the host and allocate
+  // immediately. The queue orders the first use of the buffer after prior work.
+  IREE_RETURN_IF_ERROR(iree_hal_webgpu_semaphore_multi_wait(
+      device->handle, IREE_HAL_WAIT_MODE_ALL, &wait_semaphore_list,
+      iree_infinite_timeout()));
+  iree_hal_buffer_t* buffer = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_allocator_allocate_buffer(
+      device->device_allocator, memory_type, allowed_usage,
+      (iree_host_size_t)allocation_size, iree_const_byte_span_empty(),
+      &buffer));
+  iree_status_t status =
+      iree_hal_webgpu_device_signal_semaphores(&signal_semaphore_list);
+  if (iree_status_is_ok(status)) {
+    *out_buffer = buffer;
+  } else {
+    iree_hal_buffer_release(buffer);
+  }
+  return status;
+}
+
+static iree_status_t iree_hal_webgpu_device_queue_dealloca(
+    iree_hal_device_t* base_device, iree_hal_queue_affinity_t queue_affinity,
+    const iree_hal_semaphore_list_t wait_semaphore_list,
+    const iree_hal_semaphore_list_t signal_semaphore_list,
+    iree_hal_buffer_t* buffer) {
+  iree_hal_webgpu_device_t* device = iree_hal_webgpu_device_cast(base_device);
+  // The memory is returned when the last reference is released. WebGPU defers
+  // destruction of buffers still referenced by in-flight work.
+  IREE_RETURN_IF_ERROR(iree_hal_webgpu_semaphore_multi_wait(
+      device->handle, IREE_HAL_WAIT_MODE_ALL, &wait_semaphore_list,
+      iree_infinite_timeout()));
+  return iree_hal_webgpu_device_signal_semaphores(&signal_semaphore_list);
+}
+
+// Signal semaphores of a batch retained until the queue has completed the work
+// submitted prior to it.
+typedef struct iree_hal_webgpu_signal_state_t {
+  iree_allocator_t host_allocator;
+  iree_host_size_t count;
+  iree_hal_semaphore_t** semaphores;
+  uint64_t* payload_values;
+} iree_hal_webgpu_signal_state_t;
+
+static void iree_hal_webgpu_device_work_done_callback(
+    WGPUQueueWorkDoneStatus status, void* userdata) {
+  iree_hal_webgpu_signal_state_t* state =
+      (iree_hal_webgpu_signal_state_t*)userdata;
+  for (iree_host_size_t i = 0; i < state->count; ++i) {
+    if (status == WGPUQueueWorkDoneStatus_Success) {
+      iree_status_ignore(iree_hal_semaphore_signal(state->semaphores[i],
+                                                   state->payload_values[i]));
+    } else {
+      iree_hal_semaphore_fail(
+          state->semaphores[i],
+          iree_make_status(IREE_STATUS_INTERNAL,
+                           "queue work failed to complete (status %d)",
+                           (int)status));
+    }
+    iree_hal_semaphore_release(state->semaphores[i]);
+  }
+  iree_allocator_free(state->host_allocator, state);
+}
+
+// Signals |semaphore_list| once all work submitted to the queue so far has
+// completed.
+static iree_status_t iree_hal_webgpu_device_signal_on_completion(
+    iree_hal_webgpu_device_t* device,
+    const iree_hal_semaphore_list_t* semaphore_list) {
+  if (semaphore_list->count == 0) return iree_ok_status();
+  iree_hal_webgpu_signal_state_t* state = NULL;
+  iree_host_size_t total_size =
+      iree_sizeof_struct(*state) +
+      semaphore_list->count * sizeof(state->semaphores[0]) +
+      semaphore_list->count * sizeof(state->payload_values[0]);
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(device->host_allocator,
+                                             total_size, (void**)&state));
+  state->host_allocator = device->host_allocator;
+  state->count = semaphore_list->count;
+  state->payload_values =
+      (uint64_t*)((uint8_t*)state + iree_sizeof_struct(*state));
+  state->semaphores =
+      (iree_hal_semaphore_t**)(state->payload_values + state->count);
+  for (iree_host_size_t i = 0; i < state->count; ++i) {
+    state->semaphores[i] = semaphore_list->semaphores[i];
+    iree_hal_semaphore_retain(state->semaphores[i]);
+    state->payload_values[i] = semaphore_list->payload_values[i];
+  }
+  wgpuQueueOnSubmittedWorkDone(device->queue, /*signalValue=*/0,
+                               iree_hal_webgpu_device_work_done_callback,
+                               state);
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_webgpu_device_queue_submit(
+    iree_hal_device_t* base_device,
+    iree_hal_command_category_t command_categories,
+    iree_hal_queue_affinity_t queue_affinity, iree_host_size_t batch_count,
+    const iree_hal_submission_batch_t* batches) {
+  iree_hal_webgpu_device_t* device = iree_hal_webgpu_device_cast(base_device);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_status_t status = iree_ok_status();
+  for (iree_host_size_t i = 0; i < batch_count && iree_status_is_ok(status);
+       ++i) {
+    // WebGPU queues have no semaphores: waits happen on the host before the
+    // batch is encoded. Waits on semaphores signaled by prior submissions
+    // return once the queue has made progress.
+    status = iree_hal_webgpu_semaphore_multi_wait(
+        device->handle, IREE_HAL_WAIT_MODE_ALL, &batches[i].wait_semaphores,
+        iree_infinite_timeout());
+    for (iree_host_size_t j = 0;
+         j < batches[i].command_buffer_count && iree_status_is_ok(status);
+         ++j) {
+      status = iree_hal_deferred_command_buffer_apply(
+          batches[i].command_buffers[j], device->command_buffer,
+          batches[i].binding_table);
+    }
+    if (iree_status_is_ok(status)) {
+      status = iree_hal_webgpu_device_signal_on_completion(
+          device, &batches[i].signal_semaphores);
+    }
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static iree_status_t iree_hal_webgpu_device_submit_and_wait(
+    iree_hal_device_t* base_device,
+    iree_hal_command_category_t command_categories,
+    iree_hal_queue_affinity_t queue_affinity, iree_host_size_t batch_count,
+    const iree_hal_submission_batch_t* batches,
+    iree_hal_semaphore_t* wait_semaphore, uint64_t wait_value,
+    iree_timeout_t timeout) {
+  // Submit...
+  IREE_RETURN_IF_ERROR(iree_hal_webgpu_device_queue_submit(
+      base_device, command_categories, queue_affinity, batch_count, batches));
+
+  // ...and wait.
+  return iree_hal_semaphore_wait(wait_semaphore, wait_value, timeout);
+}
+
+static iree_status_t iree_hal_webgpu_device_wait_semaphores(
+    iree_hal_device_t* base_device, iree_hal_wait_mode_t wait_mode,
+    const iree_hal_semaphore_list_t* semaphore_list, iree_timeout_t timeout) {
+  iree_hal_webgpu_device_t* device = iree_hal_webgpu_device_cast(base_device);
+  return iree_hal_webgpu_semaphore_multi_wait(device->handle, wait_mode,
+                                              semaphore_list, timeout);
+}
+
+static iree_status_t iree_hal_webgpu_device_wait_idle(
+    iree_hal_device_t* base_device, iree_timeout_t timeout) {
+  iree_hal_webgpu_device_t* device = iree_hal_webgpu_device_cast(base_device);
+  return iree_hal_webgpu_queue_wait_idle(device->handle, device->queue,
+                                         device->host_allocator, timeout);
+}
+
+static iree_status_t iree_hal_webgpu_device_profiling_begin(
+    iree_hal_device_t* base_device,
+    const iree_hal_device_profiling_options_t* options) {
+  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                          "device profiling not yet implemented");
+}
+
+static iree_status_t iree_hal_webgpu_device_profiling_flush(
+    iree_hal_device_t* base_device) {
+  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                          "device profiling not yet implemented");
+}
+
+static iree_status_t iree_hal_webgpu_device_profiling_end(
+    iree_hal_device_t* base_device) {
+  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                          "device profiling not yet implemented");
+}
+
+static const iree_hal_device_vtable_t iree_hal_webgpu_device_vtable = {
+    .destroy = iree_hal_webgpu_device_destroy,
+    .id = iree_hal_webgpu_device_id,
+    .host_allocator = iree_hal_webgpu_device_host_allocator,
+    .device_allocator = iree_hal_webgpu_device_allocator,
+    .trim = iree_hal_webgpu_device_trim,
+    .query_i32 = iree_hal_webgpu_device_query_i32,
+    .create_command_buffer = iree_hal_webgpu_device_create_command_buffer,
+    .create_descriptor_set = iree_hal_webgpu_device_create_descriptor_set,
+    .create_descriptor_set_layout =
+        iree_hal_webgpu_device_create_descriptor_set_layout,
+    .create_event = iree_hal_webgpu_device_create_event,
+    .create_executable_cache = iree_hal_webgpu_device_create_executable_cache,
+    .create_executable_layout =
+        iree_hal_webgpu_device_create_executable_layout,
+    .create_semaphore = iree_hal_webgpu_device_create_semaphore,
+    .transfer_range = iree_hal_webgpu_device_transfer_range,
+    .queue_alloca = iree_hal_webgpu_device_queue_alloca,
+    .queue_dealloca = iree_hal_webgpu_device_queue_dealloca,
+    .queue_submit = iree_hal_webgpu_device_queue_submit,
+    .submit_and_wait = iree_hal_webgpu_device_submit_and_wait,
+    .wait_semaphores = iree_hal_webgpu_device_wait_semaphores,
+    .wait_idle = iree_hal_webgpu_device_wait_idle,
+    .profiling_begin = iree_hal_webgpu_device_profiling_begin,
+    .profiling_flush = iree_hal_webgpu_device_profiling_flush,
+    .profiling_end = iree_hal_webgpu_device_profiling_end,
+};
@@ -0,0 +1,20 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_WEBGPU_WEBGPU_HEADERS_H_
+#define IREE_HAL_WEBGPU_WEBGPU_HEADERS_H_
+
+#include "iree/base/target_platform.h"
+
+// The standard C API header is provided by all implementations: Emscripten
+// (browsers), Dawn, and wgpu-native.
+#include <webgpu/webgpu.h>  // IWYU pragma: export
+
+#if defined(IREE_PLATFORM_EMSCRIPTEN)
+#include <emscripten.h>  // IWYU pragma: export
+#endif  // IREE_PLATFORM_EMSCRIPTEN
+
+#endif  // IREE_HAL_WEBGPU_WEBGPU_HEADERS_H_
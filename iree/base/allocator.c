@@ -8,8 +8,14 @@
 #include <string.h>
 
 #include "iree/base/api.h"
+#include "iree/base/target_platform.h"
 #include "iree/base/tracing.h"
 
+#if defined(IREE_PLATFORM_ANDROID) || defined(IREE_PLATFORM_LINUX)
+#define IREE_ALLOCATOR_HAVE_MMAP 1
+#include <sys/mman.h>
+#endif  // IREE_PLATFORM_ANDROID || IREE_PLATFORM_LINUX
+
 static iree_status_t iree_allocator_issue_alloc(
     iree_allocator_t allocator, iree_allocator_command_t command,
     iree_host_size_t byte_length, void** inout_ptr) {
@@ -128,3 +134,283 @@ iree_allocator_system_ctl(void* self, iree_allocator_command_t command,
                               "unsupported system allocator command");
   }
 }
+
+//===----------------------------------------------------------------------===//
+// iree_allocator_large_page_ctl
+//===----------------------------------------------------------------------===//
+
+// Size of the large pages used for transparent huge page backed mappings.
+// Transparent huge pages are only used for ranges aligned to this size.
+#define IREE_ALLOCATOR_LARGE_PAGE_SIZE (2 * 1024 * 1024)
+
+// Prepended to every allocation made with iree_allocator_large_page_ctl such
+// that frees and reallocs can tell how the allocation was made.
+typedef struct iree_allocator_large_page_header_t {
+  // Base pointer of the underlying allocation.
+  void* base;
+  // Length of the mapping backing the allocation or 0 if it was made with the
+  // system allocator.
+  iree_host_size_t mapping_length;
+  // Usable length of the allocation following the header.
+  iree_host_size_t byte_length;
+} iree_allocator_large_page_header_t;
+
+// Offset of the user data from the base of mapped allocations. Mapped
+// allocations are page aligned and we keep the data cache line aligned.
+#define IREE_ALLOCATOR_LARGE_PAGE_MAPPED_OFFSET 64
+
+// Offset of the user data from the base of allocations made with the system
+// allocator; preserves the alignment malloc provides.
+static inline iree_host_size_t iree_allocator_large_page_system_offset(void) {
+  return iree_host_align(sizeof(iree_allocator_large_page_header_t),
+                         iree_max_align_t);
+}
+
+static inline iree_allocator_large_page_header_t*
+iree_allocator_large_page_header(void* ptr) {
+  return (iree_allocator_large_page_header_t*)ptr - 1;
+}
+
+#if defined(IREE_ALLOCATOR_HAVE_MMAP)
+
+// Maps at least |*inout_length| bytes of zeroed memory backed by large pages
+// when possible and updates |*inout_length| to the length of the mapping.
+// Returns NULL if the memory could not be mapped.
+static void* iree_allocator_large_page_map(iree_host_size_t* inout_length) {
+  const int prot = PROT_READ | PROT_WRITE;
+  const int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+  iree_host_size_t length =
+      iree_host_align(*inout_length, IREE_ALLOCATOR_LARGE_PAGE_SIZE);
+
+#if defined(MAP_HUGETLB)
+  // Explicit huge pages only succeed if the system has reserved enough of them
+  // (vm.nr_hugepages) and otherwise fail immediately.
+#if defined(MAP_HUGE_1GB)
+  const iree_host_size_t gigantic_page_size = 1024 * 1024 * 1024;
+  if (length >= gigantic_page_size &&
+      length <= ~(iree_host_size_t)0 - gigantic_page_size) {
+    iree_host_size_t gigantic_length =
+        iree_host_align(length, gigantic_page_size);
+    void* ptr = mmap(NULL, gigantic_length, prot,
+                     flags | MAP_HUGETLB | MAP_HUGE_1GB, -1, 0);
+    if (ptr != MAP_FAILED) {
+      *inout_length = gigantic_length;
+      return ptr;
+    }
+  }
+#endif  // MAP_HUGE_1GB
+  void* hugetlb_ptr = mmap(NULL, length, prot, flags | MAP_HUGETLB, -1, 0);
+  if (hugetlb_ptr != MAP_FAILED) {
+    *inout_length = length;
+    return hugetlb_ptr;
+  }
+#endif  // MAP_HUGETLB
+
+  // Fall back to transparent huge pages. The kernel only backs huge page
+  // aligned ranges with them so we over-reserve and trim the mapping down to
+  // the aligned range.
+  iree_host_size_t reserve_length = length + IREE_ALLOCATOR_LARGE_PAGE_SIZE;
+  uint8_t* reserve_ptr =
+      (uint8_t*)mmap(NULL, reserve_length, prot, flags, -1, 0);
+  if (reserve_ptr == (uint8_t*)MAP_FAILED) return NULL;
+  uint8_t* ptr = (uint8_t*)iree_host_align((uintptr_t)reserve_ptr,
+                                           IREE_ALLOCATOR_LARGE_PAGE_SIZE);
+  if (ptr != reserve_ptr) munmap(reserve_ptr, ptr - reserve_ptr);
+  uint8_t* reserve_end = reserve_ptr + reserve_length;
+  if (ptr + length != reserve_end) {
+    munmap(ptr + length, reserve_end - (ptr + length));
+  }
+#if defined(MADV_HUGEPAGE)
+  // Advisory only; fails if transparent huge pages are disabled.
+  madvise(ptr, length, MADV_HUGEPAGE);
+#endif  // MADV_HUGEPAGE
+  *inout_length = length;
+  return ptr;
+}
+
+static void iree_allocator_large_page_unmap(void* ptr,
+                                            iree_host_size_t length) {
+  munmap(ptr, length);
+}
+
+#elif defined(IREE_PLATFORM_WINDOWS)
+
+static void* iree_allocator_large_page_map(iree_host_size_t* inout_length) {
+  // Large pages require SeLockMemoryPrivilege and contiguous physical memory;
+  // the allocation fails if either is not available.
+  SIZE_T large_page_size = GetLargePageMinimum();
+  if (large_page_size) {
+    iree_host_size_t length = iree_host_align(*inout_length, large_page_size);
+    void* ptr = VirtualAlloc(NULL, length,
+                             MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+                             PAGE_READWRITE);
+    if (ptr) {
+      *inout_length = length;
+      return ptr;
+    }
+  }
+  void* ptr = VirtualAlloc(NULL, *inout_length, MEM_RESERVE | MEM_COMMIT,
+                           PAGE_READWRITE);
+  return ptr;
+}
+
+static void iree_allocator_large_page_unmap(void* ptr,
+                                            iree_host_size_t length) {
+  VirtualFree(ptr, 0, MEM_RELEASE);
+}
+
+#else
+
+// No large page support; all allocations use the system allocator.
+static void* iree_allocator_large_page_map(iree_host_size_t* inout_length) {
+  return NULL;
+}
+
+static void iree_allocator_large_page_unmap(void* ptr,
+                                            iree_host_size_t length) {}
+
+#endif  // IREE_ALLOCATOR_HAVE_MMAP
+
+// Allocates |byte_length| bytes with a header and returns the user pointer.
+// Returns NULL if the allocation failed.
+static void* iree_allocator_large_page_allocate(
+    iree_allocator_command_t command, iree_host_size_t byte_length) {
+  if (byte_length >= IREE_ALLOCATOR_LARGE_PAGE_MIN_SIZE) {
+    // Mapped memory is always zeroed.
+    iree_host_size_t mapping_length =
+        IREE_ALLOCATOR_LARGE_PAGE_MAPPED_OFFSET + byte_length;
+    uint8_t* base = (uint8_t*)iree_allocator_large_page_map(&mapping_length);
+    if (base) {
+      void* ptr = base + IREE_ALLOCATOR_LARGE_PAGE_MAPPED_OFFSET;
+      iree_allocator_large_page_header_t* header =
+          iree_allocator_large_page_header(ptr);
+      header->base = base;
+      header->mapping_length = mapping_length;
+      header->byte_length = byte_length;
+      return ptr;
+    }
+  }
+
+  iree_host_size_t offset = iree_allocator_large_page_system_offset();
+  uint8_t* base = command == IREE_ALLOCATOR_COMMAND_CALLOC
+                      ? (uint8_t*)calloc(1, offset + byte_length)
+                      : (uint8_t*)malloc(offset + byte_length);
+  if (!base) return NULL;
+  void* ptr = base + offset;
+  iree_allocator_large_page_header_t* header =
+      iree_allocator_large_page_header(ptr);
+  header->base = base;
+  header->mapping_length = 0;
+  header->byte_length = byte_length;
+  return ptr;
+}
+
+// Frees |ptr| as allocated by iree_allocator_large_page_allocate.
+static void iree_allocator_large_page_release(void* ptr) {
+  iree_allocator_large_page_header_t* header =
+      iree_allocator_large_page_header(ptr);
+  if (header->mapping_length) {
+    iree_allocator_large_page_unmap(header->base, header->mapping_length);
+  } else {
+    free(header->base);
+  }
+}
+
+static iree_status_t iree_allocator_large_page_alloc(
+    iree_allocator_command_t command,
+    const iree_allocator_alloc_params_t* params, void** inout_ptr) {
+  IREE_ASSERT_ARGUMENT(params);
+  IREE_ASSERT_ARGUMENT(inout_ptr);
+  iree_host_size_t byte_length = params->byte_length;
+  if (byte_length == 0) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "allocations must be >0 bytes");
+  } else if (byte_length > ~(iree_host_size_t)0 -
+                               IREE_ALLOCATOR_LARGE_PAGE_SIZE -
+                               IREE_ALLOCATOR_LARGE_PAGE_MAPPED_OFFSET) {
+    return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                            "allocation size overflow");
+  }
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  void* existing_ptr =
+      command == IREE_ALLOCATOR_COMMAND_REALLOC ? *inout_ptr : NULL;
+  void* new_ptr = NULL;
+  if (existing_ptr) {
+    iree_allocator_large_page_header_t* header =
+        iree_allocator_large_page_header(existing_ptr);
+    if (header->mapping_length &&
+        byte_length <= header->mapping_length -
+                           IREE_ALLOCATOR_LARGE_PAGE_MAPPED_OFFSET) {
+      // Fits within the existing mapping.
+      header->byte_length = byte_length;
+      new_ptr = existing_ptr;
+    } else if (!header->mapping_length &&
+               byte_length < IREE_ALLOCATOR_LARGE_PAGE_MIN_SIZE) {
+      // Remains a system allocation.
+      iree_host_size_t offset = iree_allocator_large_page_system_offset();
+      uint8_t* base = (uint8_t*)realloc(header->base, offset + byte_length);
+      if (base) {
+        new_ptr = base + offset;
+        header = iree_allocator_large_page_header(new_ptr);
+        header->base = base;
+        header->byte_length = byte_length;
+      }
+    } else {
+      // Moving between system and mapped allocations (or to a larger mapping).
+      new_ptr = iree_allocator_large_page_allocate(command, byte_length);
+      if (new_ptr) {
+        memcpy(new_ptr, existing_ptr,
+               iree_min(header->byte_length, byte_length));
+        iree_allocator_large_page_release(existing_ptr);
+      }
+    }
+  } else {
+    new_ptr = iree_allocator_large_page_allocate(command, byte_length);
+  }
+  if (!new_ptr) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                            "large page allocator failed the request");
+  }
+
+  if (existing_ptr) {
+    IREE_TRACE_FREE(existing_ptr);
+  }
+  IREE_TRACE_ALLOC(new_ptr, byte_length);
+
+  *inout_ptr = new_ptr;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+static iree_status_t iree_allocator_large_page_free(void** inout_ptr) {
+  IREE_ASSERT_ARGUMENT(inout_ptr);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  void* ptr = *inout_ptr;
+  if (IREE_LIKELY(ptr != NULL)) {
+    IREE_TRACE_FREE(ptr);
+    iree_allocator_large_page_release(ptr);
+    *inout_ptr = NULL;
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_status_t
+iree_allocator_large_page_ctl(void* self, iree_allocator_command_t command,
+                              const void* params, void** inout_ptr) {
+  switch (command) {
+    case IREE_ALLOCATOR_COMMAND_MALLOC:
+    case IREE_ALLOCATOR_COMMAND_CALLOC:
+    case IREE_ALLOCATOR_COMMAND_REALLOC:
+      return iree_allocator_large_page_alloc(
+          command, (const iree_allocator_alloc_params_t*)params, inout_ptr);
+    case IREE_ALLOCATOR_COMMAND_FREE:
+      return iree_allocator_large_page_free(inout_ptr);
+    default:
+      return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                              "unsupported large page allocator command");
+  }
+}
@@ -269,6 +269,30 @@ static inline iree_allocator_t iree_allocator_system(void) {
   return v;
 }
 
+// Allocator controller backing large allocations with large pages.
+//
+// Allocations of at least IREE_ALLOCATOR_LARGE_PAGE_MIN_SIZE bytes are mapped
+// directly from the system and rounded up to a whole number of large pages:
+//  - Linux/Android: 1GB and then 2MB pages from the hugetlbfs pool when
+//    reserved by the system (MAP_HUGETLB) and otherwise 2MB-aligned anonymous
+//    memory advised to use transparent huge pages (MADV_HUGEPAGE).
+//  - Windows: large pages (MEM_LARGE_PAGES) when the process holds the
+//    SeLockMemoryPrivilege and otherwise regular pages.
+// Smaller allocations and those on other platforms use malloc and free.
+// Large pages greatly reduce TLB misses when streaming through large
+// buffers such as model weights at the cost of rounding up allocation sizes.
+//
+// Returned pointers are aligned to at least iree_max_align_t.
+IREE_API_EXPORT iree_status_t
+iree_allocator_large_page_ctl(void* self, iree_allocator_command_t command,
+                              const void* params, void** inout_ptr);
+
+// Allocates using iree_allocator_large_page_ctl.
+static inline iree_allocator_t iree_allocator_large_page(void) {
+  iree_allocator_t v = {NULL, iree_allocator_large_page_ctl};
+  return v;
+}
+
 // Does not perform any allocation or deallocation; used to wrap objects that
 // are owned by external code/live in read-only memory/etc.
 static inline iree_allocator_t iree_allocator_null(void) {
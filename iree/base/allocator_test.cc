@@ -0,0 +1,72 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <cstdint>
+#include <cstring>
+
+#include "iree/base/api.h"
+#include "iree/testing/gtest.h"
+
+namespace {
+
+// Returns true if all |byte_length| bytes at |ptr| are |value|.
+static bool AllBytesEqual(const void* ptr, iree_host_size_t byte_length,
+                          uint8_t value) {
+  const uint8_t* bytes = (const uint8_t*)ptr;
+  for (iree_host_size_t i = 0; i < byte_length; ++i) {
+    if (bytes[i] != value) return false;
+  }
+  return true;
+}
+
+TEST(LargePageAllocatorTest, SmallAllocations) {
+  iree_allocator_t allocator = iree_allocator_large_page();
+  void* ptr = NULL;
+  IREE_CHECK_OK(iree_allocator_malloc(allocator, 123, &ptr));
+  EXPECT_EQ(0u, (uintptr_t)ptr % iree_max_align_t);
+  EXPECT_TRUE(AllBytesEqual(ptr, 123, 0));
+  iree_allocator_free(allocator, ptr);
+}
+
+TEST(LargePageAllocatorTest, LargeAllocations) {
+  iree_allocator_t allocator = iree_allocator_large_page();
+  const iree_host_size_t byte_length = IREE_ALLOCATOR_LARGE_PAGE_MIN_SIZE * 3;
+  void* ptr = NULL;
+  IREE_CHECK_OK(iree_allocator_malloc(allocator, byte_length, &ptr));
+  EXPECT_EQ(0u, (uintptr_t)ptr % iree_max_align_t);
+  EXPECT_TRUE(AllBytesEqual(ptr, byte_length, 0));
+  memset(ptr, 0xCD, byte_length);
+  iree_allocator_free(allocator, ptr);
+}
+
+// Reallocations moving between system and large page allocations must
+// preserve the contents.
+TEST(LargePageAllocatorTest, Realloc) {
+  iree_allocator_t allocator = iree_allocator_large_page();
+  const iree_host_size_t small_length = 100;
+  const iree_host_size_t large_length = IREE_ALLOCATOR_LARGE_PAGE_MIN_SIZE * 2;
+  void* ptr = NULL;
+  IREE_CHECK_OK(iree_allocator_malloc(allocator, small_length, &ptr));
+  memset(ptr, 0xAB, small_length);
+
+  IREE_CHECK_OK(iree_allocator_realloc(allocator, small_length * 2, &ptr));
+  EXPECT_TRUE(AllBytesEqual(ptr, small_length, 0xAB));
+  memset(ptr, 0xAB, small_length * 2);
+
+  IREE_CHECK_OK(iree_allocator_realloc(allocator, large_length, &ptr));
+  EXPECT_TRUE(AllBytesEqual(ptr, small_length * 2, 0xAB));
+  memset(ptr, 0xAB, large_length);
+
+  IREE_CHECK_OK(iree_allocator_realloc(allocator, large_length * 2, &ptr));
+  EXPECT_TRUE(AllBytesEqual(ptr, large_length, 0xAB));
+
+  IREE_CHECK_OK(iree_allocator_realloc(allocator, small_length, &ptr));
+  EXPECT_TRUE(AllBytesEqual(ptr, small_length, 0xAB));
+
+  iree_allocator_free(allocator, ptr);
+}
+
+}  // namespace
@@ -137,6 +137,17 @@ typedef IREE_DEVICE_SIZE_T iree_device_size_t;
 #define IREE_FILE_IO_ENABLE 1
 #endif  // !IREE_FILE_IO_ENABLE
 
+//===----------------------------------------------------------------------===//
+// Large page allocation
+//===----------------------------------------------------------------------===//
+// Minimum size, in bytes, of allocations made with iree_allocator_large_page
+// that are backed by large pages. Smaller allocations are made with the system
+// allocator as rounding them up to a whole large page would waste memory.
+
+#if !defined(IREE_ALLOCATOR_LARGE_PAGE_MIN_SIZE)
+#define IREE_ALLOCATOR_LARGE_PAGE_MIN_SIZE (2 * 1024 * 1024)
+#endif  // !IREE_ALLOCATOR_LARGE_PAGE_MIN_SIZE
+
 //===----------------------------------------------------------------------===//
 // Statistics/reporting
 //===----------------------------------------------------------------------===//
@@ -217,6 +228,13 @@ typedef IREE_DEVICE_SIZE_T iree_device_size_t;
 #define IREE_VM_EXECUTION_TRACING_SRC_LOC_ENABLE 0
 #endif  // !IREE_VM_EXECUTION_TRACING_SRC_LOC_ENABLE
 
+#if !defined(IREE_VM_EXECUTION_SAMPLING_ENABLE)
+// Enables sampling of vm bytecode execution by an iree_vm_sampler_t attached
+// to the context. When no sampler is attached the cost is a single predictable
+// branch at each control flow instruction.
+#define IREE_VM_EXECUTION_SAMPLING_ENABLE 1
+#endif  // !IREE_VM_EXECUTION_SAMPLING_ENABLE
+
 #if !defined(IREE_VM_EXT_I64_ENABLE)
 // Enables the 64-bit integer instruction extension.
 // Targeted from the compiler with `-iree-vm-target-extension-i64`.
@@ -25,7 +25,14 @@ void iree_arena_block_pool_initialize(iree_host_size_t total_block_size,
   out_block_pool->usable_block_size =
       total_block_size - sizeof(iree_arena_block_t);
   out_block_pool->block_allocator = block_allocator;
-  iree_atomic_arena_block_slist_initialize(&out_block_pool->available_slist);
+  for (iree_host_size_t i = 0; i < IREE_ARENA_BLOCK_POOL_SHARD_COUNT; ++i) {
+    iree_atomic_arena_block_slist_initialize(
+        &out_block_pool->available_slists[i]);
+  }
+  for (iree_host_size_t i = 0; i < IREE_ARENA_OVERSIZED_CLASS_COUNT; ++i) {
+    iree_atomic_arena_oversized_slist_initialize(
+        &out_block_pool->oversized_slists[i]);
+  }
 
   IREE_TRACE_ZONE_END(z0);
 }
@@ -36,7 +43,14 @@ void iree_arena_block_pool_deinitialize(iree_arena_block_pool_t* block_pool) {
   // Since all blocks must have been released we can just reuse trim (today) as
   // it doesn't retain any blocks.
   iree_arena_block_pool_trim(block_pool);
-  iree_atomic_arena_block_slist_deinitialize(&block_pool->available_slist);
+  for (iree_host_size_t i = 0; i < IREE_ARENA_BLOCK_POOL_SHARD_COUNT; ++i) {
+    iree_atomic_arena_block_slist_deinitialize(
+        &block_pool->available_slists[i]);
+  }
+  for (iree_host_size_t i = 0; i < IREE_ARENA_OVERSIZED_CLASS_COUNT; ++i) {
+    iree_atomic_arena_oversized_slist_deinitialize(
+        &block_pool->oversized_slists[i]);
+  }
 
   IREE_TRACE_ZONE_END(z0);
 }
@@ -44,25 +58,58 @@ void iree_arena_block_pool_deinitialize(iree_arena_block_pool_t* block_pool) {
 void iree_arena_block_pool_trim(iree_arena_block_pool_t* block_pool) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  iree_arena_block_t* head = NULL;
-  iree_atomic_arena_block_slist_flush(
-      &block_pool->available_slist,
-      IREE_ATOMIC_SLIST_FLUSH_ORDER_APPROXIMATE_LIFO, &head, NULL);
-  while (head) {
-    void* ptr = (uint8_t*)head - block_pool->usable_block_size;
-    head = head->next;
-    iree_allocator_free(block_pool->block_allocator, ptr);
+  for (iree_host_size_t i = 0; i < IREE_ARENA_BLOCK_POOL_SHARD_COUNT; ++i) {
+    iree_arena_block_t* head = NULL;
+    iree_atomic_arena_block_slist_flush(
+        &block_pool->available_slists[i],
+        IREE_ATOMIC_SLIST_FLUSH_ORDER_APPROXIMATE_LIFO, &head, NULL);
+    while (head) {
+      void* ptr = (uint8_t*)head - block_pool->usable_block_size;
+      head = head->next;
+      iree_allocator_free(block_pool->block_allocator, ptr);
+    }
+  }
+
+  for (iree_host_size_t i = 0; i < IREE_ARENA_OVERSIZED_CLASS_COUNT; ++i) {
+    iree_arena_oversized_allocation_t* head = NULL;
+    iree_atomic_arena_oversized_slist_flush(
+        &block_pool->oversized_slists[i],
+        IREE_ATOMIC_SLIST_FLUSH_ORDER_APPROXIMATE_LIFO, &head, NULL);
+    while (head) {
+      void* ptr = (void*)head;
+      head = head->next;
+      iree_allocator_free(block_pool->block_allocator, ptr);
+    }
   }
 
   IREE_TRACE_ZONE_END(z0);
 }
 
+// Returns the index of the available block list the calling thread should try
+// first. Each thread has its own stack and hashing the address of a local gives
+// a stable per-thread index without needing thread-local storage. Any thread
+// may use any list; this only reduces contention.
+static iree_host_size_t iree_arena_block_pool_shard_index(void) {
+  uintptr_t stack_marker = 0;
+  uint64_t hash = (uint64_t)(((uintptr_t)&stack_marker) >> 14) *
+                  0x9E3779B97F4A7C15ull;
+  return (iree_host_size_t)(hash >> 32) % IREE_ARENA_BLOCK_POOL_SHARD_COUNT;
+}
+
 iree_status_t iree_arena_block_pool_acquire(iree_arena_block_pool_t* block_pool,
                                             iree_arena_block_t** out_block) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  iree_arena_block_t* block =
-      iree_atomic_arena_block_slist_pop(&block_pool->available_slist);
+  // Try the list of the calling thread first and then the others before
+  // allocating a new block.
+  iree_arena_block_t* block = NULL;
+  iree_host_size_t shard_index = iree_arena_block_pool_shard_index();
+  for (iree_host_size_t i = 0; i < IREE_ARENA_BLOCK_POOL_SHARD_COUNT && !block;
+       ++i) {
+    block = iree_atomic_arena_block_slist_pop(
+        &block_pool->available_slists[(shard_index + i) %
+                                      IREE_ARENA_BLOCK_POOL_SHARD_COUNT]);
+  }
 
   if (!block) {
     // No blocks available; allocate one now.
@@ -90,11 +137,76 @@ void iree_arena_block_pool_release(iree_arena_block_pool_t* block_pool,
                                    iree_arena_block_t* block_head,
                                    iree_arena_block_t* block_tail) {
   IREE_TRACE_ZONE_BEGIN(z0);
-  iree_atomic_arena_block_slist_concat(&block_pool->available_slist, block_head,
-                                       block_tail);
+  iree_atomic_arena_block_slist_concat(
+      &block_pool->available_slists[iree_arena_block_pool_shard_index()],
+      block_head, block_tail);
   IREE_TRACE_ZONE_END(z0);
 }
 
+// Byte offset of the user data in an oversized allocation.
+#define IREE_ARENA_OVERSIZED_HEADER_SIZE \
+  iree_host_align(sizeof(iree_arena_oversized_allocation_t), iree_max_align_t)
+
+// Returns the total allocation size of oversized allocations in |size_class|.
+static iree_host_size_t iree_arena_block_pool_oversized_class_size(
+    iree_arena_block_pool_t* block_pool, iree_host_size_t size_class) {
+  return block_pool->total_block_size << (size_class + 1);
+}
+
+// Acquires an oversized allocation with at least |byte_length| usable bytes
+// from the pool or the block allocator. Returns the total size of the
+// allocation in |out_allocation_size|.
+static iree_status_t iree_arena_block_pool_acquire_oversized(
+    iree_arena_block_pool_t* block_pool, iree_host_size_t byte_length,
+    iree_arena_oversized_allocation_t** out_allocation,
+    iree_host_size_t* out_allocation_size) {
+  iree_host_size_t required_size =
+      IREE_ARENA_OVERSIZED_HEADER_SIZE + byte_length;
+
+  // Find the smallest size class that can hold the allocation, if any.
+  iree_host_size_t size_class = 0;
+  while (size_class < IREE_ARENA_OVERSIZED_CLASS_COUNT &&
+         iree_arena_block_pool_oversized_class_size(block_pool, size_class) <
+             required_size) {
+    ++size_class;
+  }
+
+  iree_arena_oversized_allocation_t* allocation = NULL;
+  iree_host_size_t allocation_size = required_size;
+  if (size_class < IREE_ARENA_OVERSIZED_CLASS_COUNT) {
+    allocation_size =
+        iree_arena_block_pool_oversized_class_size(block_pool, size_class);
+    allocation = iree_atomic_arena_oversized_slist_pop(
+        &block_pool->oversized_slists[size_class]);
+  }
+  if (!allocation) {
+    IREE_RETURN_IF_ERROR(iree_allocator_malloc_uninitialized(
+        block_pool->block_allocator, allocation_size, (void**)&allocation));
+  }
+  allocation->next = NULL;
+  allocation->size_class = size_class;
+  *out_allocation = allocation;
+  *out_allocation_size = allocation_size;
+  return iree_ok_status();
+}
+
+// Releases a list of oversized allocations back to the pool. Those too large
+// to pool are freed.
+static void iree_arena_block_pool_release_oversized(
+    iree_arena_block_pool_t* block_pool,
+    iree_arena_oversized_allocation_t* allocation_head) {
+  while (allocation_head) {
+    iree_arena_oversized_allocation_t* allocation = allocation_head;
+    allocation_head = allocation->next;
+    if (allocation->size_class < IREE_ARENA_OVERSIZED_CLASS_COUNT) {
+      iree_atomic_arena_oversized_slist_push(
+          &block_pool->oversized_slists[allocation->size_class], allocation);
+    } else {
+      iree_allocator_free(block_pool->block_allocator, allocation);
+    }
+  }
+}
+
 //===----------------------------------------------------------------------===//
 // iree_arena_allocator_t
 //===----------------------------------------------------------------------===//
@@ -113,12 +225,8 @@ void iree_arena_reset(iree_arena_allocator_t* arena) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
   if (arena->allocation_head != NULL) {
-    iree_arena_oversized_allocation_t* head = arena->allocation_head;
-    do {
-      void* ptr = (void*)head;
-      head = head->next;
-      iree_allocator_free(arena->block_pool->block_allocator, ptr);
-    } while (head);
+    iree_arena_block_pool_release_oversized(arena->block_pool,
+                                            arena->allocation_head);
     arena->allocation_head = NULL;
   }
   if (arena->block_head != NULL) {
@@ -139,22 +247,20 @@ iree_status_t iree_arena_allocate(iree_arena_allocator_t* arena,
   iree_arena_block_pool_t* block_pool = arena->block_pool;
 
   if (byte_length > block_pool->usable_block_size) {
-    // Oversized allocation that can't be handled by the block pool. We'll
-    // allocate directly from the system allocator and track it ourselves for
-    // freeing during reset.
+    // Oversized allocation that can't be handled by a block. We'll get one
+    // from the oversized allocations of the pool and track it ourselves for
+    // returning during reset.
     IREE_TRACE_ZONE_BEGIN(z0);
-    iree_host_size_t allocation_size =
-        sizeof(iree_arena_oversized_allocation_t) + byte_length;
     iree_arena_oversized_allocation_t* allocation = NULL;
+    iree_host_size_t allocation_size = 0;
     IREE_RETURN_AND_END_ZONE_IF_ERROR(
-        z0,
-        iree_allocator_malloc_uninitialized(
-            block_pool->block_allocator, allocation_size, (void**)&allocation));
+        z0, iree_arena_block_pool_acquire_oversized(
+                block_pool, byte_length, &allocation, &allocation_size));
     allocation->next = arena->allocation_head;
     arena->allocation_head = allocation;
     arena->total_allocation_size += allocation_size;
     arena->used_allocation_size += byte_length;
-    *out_ptr = (uint8_t*)allocation + sizeof(iree_arena_oversized_allocation_t);
+    *out_ptr = (uint8_t*)allocation + IREE_ARENA_OVERSIZED_HEADER_SIZE;
     IREE_TRACE_ZONE_END(z0);
     return iree_ok_status();
   }
@@ -34,6 +34,32 @@ typedef struct iree_arena_block_t {
 IREE_TYPED_ATOMIC_SLIST_WRAPPER(iree_atomic_arena_block, iree_arena_block_t,
                                 offsetof(iree_arena_block_t, next));
 
+// Header of an allocation made by an arena that exceeds the pool block size.
+// Allocations within a size class are recycled by the block pool while larger
+// allocations are made directly from the block allocator.
+typedef struct iree_arena_oversized_allocation_t {
+  struct iree_arena_oversized_allocation_t* next;
+  // Size class of the allocation or IREE_ARENA_OVERSIZED_CLASS_COUNT if it was
+  // too large to be pooled.
+  iree_host_size_t size_class;
+} iree_arena_oversized_allocation_t;
+
+// An atomic approximately LIFO singly-linked list.
+IREE_TYPED_ATOMIC_SLIST_WRAPPER(iree_atomic_arena_oversized,
+                                iree_arena_oversized_allocation_t,
+                                offsetof(iree_arena_oversized_allocation_t,
+                                         next));
+
+// Number of lists the available blocks of a pool are spread across. Threads
+// acquire and release blocks to the list associated with them first such that
+// arenas on different threads rarely contend.
+#define IREE_ARENA_BLOCK_POOL_SHARD_COUNT 4
+
+// Number of power-of-two size classes of oversized allocations retained by a
+// block pool. Class i holds allocations with a total size of up to
+// total_block_size << (i + 1); anything larger is not pooled.
+#define IREE_ARENA_OVERSIZED_CLASS_COUNT 8
+
 // A simple atomic fixed-size block pool.
 // Blocks are allocated from the system as required and kept in the pool to
 // satisfy future requests. Blocks are all of a uniform size specified when the
@@ -41,6 +67,11 @@ IREE_TYPED_ATOMIC_SLIST_WRAPPER(iree_atomic_arena_block, iree_arena_block_t,
 // blocks so that the underlying allocator is more likely to bucket them
 // appropriately.
 //
+// Oversized allocations made by arenas using the pool are also retained (in
+// power-of-two size classes larger than the block size) so that arenas that
+// repeatedly make large allocations - such as command buffers with large
+// inline updates - don't go to the system allocator each time they are reset.
+//
 // Thread-safe; multiple threads may acquire and release blocks from the pool.
 // The underlying allocator must also be thread-safe.
 typedef struct iree_arena_block_pool_t {
@@ -51,8 +82,12 @@ typedef struct iree_arena_block_pool_t {
   iree_host_size_t usable_block_size;
   // Allocator used for allocating/freeing each allocation block.
   iree_allocator_t block_allocator;
-  // Linked list of free blocks (LIFO).
-  iree_atomic_arena_block_slist_t available_slist;
+  // Linked lists of free blocks (LIFO) sharded by thread.
+  iree_atomic_arena_block_slist_t
+      available_slists[IREE_ARENA_BLOCK_POOL_SHARD_COUNT];
+  // Linked lists of free oversized allocations (LIFO) by size class.
+  iree_atomic_arena_oversized_slist_t
+      oversized_slists[IREE_ARENA_OVERSIZED_CLASS_COUNT];
 } iree_arena_block_pool_t;
 
 // Initializes a new block pool in |out_block_pool|.
@@ -68,7 +103,8 @@ void iree_arena_block_pool_initialize(iree_host_size_t total_block_size,
 // back to it.
 void iree_arena_block_pool_deinitialize(iree_arena_block_pool_t* block_pool);
 
-// Trims the pool by freeing unused blocks back to the allocator.
+// Trims the pool by freeing unused blocks and oversized allocations back to
+// the allocator.
 // Acquired blocks are not freed and remain valid.
 void iree_arena_block_pool_trim(iree_arena_block_pool_t* block_pool);
 
@@ -89,10 +125,6 @@ void iree_arena_block_pool_release(iree_arena_block_pool_t* block_pool,
 // iree_arena_allocator_t
 //===----------------------------------------------------------------------===//
 
-typedef struct iree_arena_oversized_allocation_t {
-  struct iree_arena_oversized_allocation_t* next;
-} iree_arena_oversized_allocation_t;
-
 // A lightweight bump-pointer arena allocator using a shared block pool.
 // As allocations are made from the arena and block capacity is exhausted new
 // blocks will be acquired from the pool. Upon being reset all blocks will be
@@ -100,9 +132,10 @@ typedef struct iree_arena_oversized_allocation_t {
 // other arenas sharing the same pool.
 //
 // The size of each allocated block used by the arena is inherited from the
-// block pool. Allocations from the arena may exceed the block size but will
-// incur additional allocation overhead as the block pool is bypassed and the
-// system allocator is directly used to service the request.
+// block pool. Allocations from the arena may exceed the block size and are
+// serviced from the oversized allocations retained by the block pool (or the
+// system allocator if none are available or the allocation is too large to be
+// pooled).
 //
 // Thread-compatible; the shared block pool is thread-safe and may be used by
 // arenas on multiple threads but each arena must only be used by a single
@@ -115,8 +148,7 @@ typedef struct iree_arena_allocator_t {
   // Total bytes allocated from the arena; the utilization of the arena can be
   // checked with `used_allocation_size / total_allocation_size`.
   iree_host_size_t used_allocation_size;
-  // Linked list of oversized allocations made directly from the system
-  // allocator used by the block pool.
+  // Linked list of oversized allocations acquired from the block pool.
   iree_arena_oversized_allocation_t* allocation_head;
   // Linked list of allocated blocks maintained so that reset can release them.
   iree_arena_block_t* block_head;
@@ -0,0 +1,51 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <cstring>
+
+#include "benchmark/benchmark.h"
+#include "iree/base/internal/arena.h"
+
+namespace {
+
+// Emulates command buffer recording: each thread records a number of small
+// commands interleaved with occasional large ones (like inline buffer updates)
+// into its own arena and then resets it as if the command buffer were released.
+// All threads share a single block pool as command buffers on a device do.
+void BM_RecordAndReset(benchmark::State& state) {
+  static iree_arena_block_pool_t* block_pool =
+      ([]() -> iree_arena_block_pool_t* {
+        auto* block_pool = new iree_arena_block_pool_t();
+        iree_arena_block_pool_initialize(32 * 1024, iree_allocator_system(),
+                                         block_pool);
+        return block_pool;
+      })();
+  const int64_t command_count = state.range(0);
+  iree_arena_allocator_t arena;
+  iree_arena_initialize(block_pool, &arena);
+  for (auto _ : state) {
+    for (int64_t i = 0; i < command_count; ++i) {
+      iree_host_size_t byte_length = (i % 64) == 63 ? 100 * 1024 : 96;
+      void* ptr = NULL;
+      IREE_CHECK_OK(iree_arena_allocate(&arena, byte_length, &ptr));
+      memset(ptr, 0, 64);
+      benchmark::DoNotOptimize(ptr);
+    }
+    iree_arena_reset(&arena);
+  }
+  iree_arena_deinitialize(&arena);
+  state.SetItemsProcessed(state.iterations() * command_count);
+}
+BENCHMARK(BM_RecordAndReset)
+    ->UseRealTime()
+    ->Arg(256)
+    ->Arg(4096)
+    ->Threads(1)
+    ->Threads(8)
+    ->Threads(32)
+    ->ThreadPerCpu();
+
+}  // namespace
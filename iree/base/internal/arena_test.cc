@@ -0,0 +1,92 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/base/internal/arena.h"
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace {
+
+TEST(ArenaTest, BlockAllocations) {
+  iree_arena_block_pool_t block_pool;
+  iree_arena_block_pool_initialize(1024, iree_allocator_system(), &block_pool);
+  iree_arena_allocator_t arena;
+  iree_arena_initialize(&block_pool, &arena);
+
+  for (int i = 0; i < 100; ++i) {
+    void* ptr = NULL;
+    IREE_ASSERT_OK(iree_arena_allocate(&arena, 100, &ptr));
+    ASSERT_NE(nullptr, ptr);
+    memset(ptr, 0xCD, 100);
+  }
+  EXPECT_GE(arena.total_allocation_size, arena.used_allocation_size);
+
+  iree_arena_deinitialize(&arena);
+  iree_arena_block_pool_deinitialize(&block_pool);
+}
+
+// Oversized allocations released by an arena are reused by subsequent arenas
+// when they fit in the same size class.
+TEST(ArenaTest, OversizedAllocationsArePooled) {
+  iree_arena_block_pool_t block_pool;
+  iree_arena_block_pool_initialize(1024, iree_allocator_system(), &block_pool);
+  iree_arena_allocator_t arena;
+  iree_arena_initialize(&block_pool, &arena);
+
+  void* first_ptr = NULL;
+  IREE_ASSERT_OK(iree_arena_allocate(&arena, 3000, &first_ptr));
+  memset(first_ptr, 0xCD, 3000);
+  iree_arena_reset(&arena);
+
+  void* second_ptr = NULL;
+  IREE_ASSERT_OK(iree_arena_allocate(&arena, 2500, &second_ptr));
+  EXPECT_EQ(first_ptr, second_ptr);
+  memset(second_ptr, 0xCD, 2500);
+
+  // Allocations too large for any size class are not pooled but must still
+  // work.
+  void* huge_ptr = NULL;
+  IREE_ASSERT_OK(iree_arena_allocate(&arena, 1024 * 1024, &huge_ptr));
+  memset(huge_ptr, 0xCD, 1024 * 1024);
+
+  iree_arena_deinitialize(&arena);
+  iree_arena_block_pool_trim(&block_pool);
+  iree_arena_block_pool_deinitialize(&block_pool);
+}
+
+// Arenas on many threads share a pool and exchange blocks through it.
+TEST(ArenaTest, ConcurrentArenas) {
+  iree_arena_block_pool_t block_pool;
+  iree_arena_block_pool_initialize(1024, iree_allocator_system(), &block_pool);
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 8; ++i) {
+    threads.emplace_back([&block_pool, i]() {
+      iree_arena_allocator_t arena;
+      iree_arena_initialize(&block_pool, &arena);
+      for (int j = 0; j < 100; ++j) {
+        for (int k = 0; k < 32; ++k) {
+          iree_host_size_t byte_length = (k % 8 == i % 8) ? 2048 : 128;
+          void* ptr = NULL;
+          IREE_ASSERT_OK(iree_arena_allocate(&arena, byte_length, &ptr));
+          memset(ptr, i, byte_length);
+        }
+        iree_arena_reset(&arena);
+      }
+      iree_arena_deinitialize(&arena);
+    });
+  }
+  for (auto& thread : threads) thread.join();
+
+  iree_arena_block_pool_deinitialize(&block_pool);
+}
+
+}  // namespace
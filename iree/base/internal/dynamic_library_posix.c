@@ -15,7 +15,7 @@
 #include "iree/base/tracing.h"
 
 #if defined(IREE_PLATFORM_ANDROID) || defined(IREE_PLATFORM_APPLE) || \
-    defined(IREE_PLATFORM_LINUX)
+    defined(IREE_PLATFORM_EMSCRIPTEN) || defined(IREE_PLATFORM_LINUX)
 
 #include <dlfcn.h>
 #include <errno.h>
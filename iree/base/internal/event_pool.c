@@ -8,29 +8,60 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <string.h>
 
+#include "iree/base/internal/atomics.h"
 #include "iree/base/internal/synchronization.h"
 #include "iree/base/tracing.h"
 
-struct iree_event_pool_t {
-  // Allocator used to create the event pool.
-  iree_allocator_t host_allocator;
-  // Guards the pool. Since this pool is used to get operating system-level
-  // event objects that will be signaled and waited on using syscalls it's got
-  // relatively low contention: callers are rate limited by how fast they can
-  // signal and wait on the events they get.
+// Maximum number of shards the pool is split into. Each shard has its own lock
+// and list of available events such that threads acquiring and releasing
+// concurrently (such as task workers and HAL waiters) rarely touch the same
+// cache lines or contend on the same lock.
+#define IREE_EVENT_POOL_MAX_SHARD_COUNT 8
+
+typedef struct iree_event_pool_shard_t {
+  // Guards the shard.
   iree_slim_mutex_t mutex;
-  // Maximum number of events that will be maintained in the pool. More events
-  // may be allocated at any time but when they are no longer needed they will
-  // be disposed directly.
+  // Maximum number of events that will be maintained in the shard.
   iree_host_size_t available_capacity;
-  // Total number of available
+  // Total number of available events in the shard.
   iree_host_size_t available_count;
   // Dense left-aligned list of available_count events.
-  iree_event_t available_list[];
+  iree_event_t* available_list;
+} iree_event_pool_shard_t;
+
+struct iree_event_pool_t {
+  // Allocator used to create the event pool.
+  iree_allocator_t host_allocator;
+  // Number of shards in the pool; always a power of two.
+  iree_host_size_t shard_count;
+  // Byte stride between shards in |shard_storage|. Shards are padded to avoid
+  // false sharing between threads using different shards.
+  iree_host_size_t shard_stride;
+  // Shards followed by the available lists of each shard.
+  uint8_t shard_storage[];
 };
 
+static iree_event_pool_shard_t* iree_event_pool_shard_at(
+    iree_event_pool_t* event_pool, iree_host_size_t shard_index) {
+  return (iree_event_pool_shard_t*)(event_pool->shard_storage +
+                                    shard_index * event_pool->shard_stride);
+}
+
+// Returns the index of the shard the calling thread should use first.
+// Threads run on distinct stacks and the address of a local variable is a
+// cheap (and portable) way of distinguishing them without thread-local
+// storage. Any shard may be used by any thread and this only affects locality.
+static iree_host_size_t iree_event_pool_select_shard(
+    iree_event_pool_t* event_pool) {
+  uintptr_t stack_marker = 0;
+  uint64_t hash = (uint64_t)(((uintptr_t)&stack_marker) >> 14) *
+                  0x9E3779B97F4A7C15ull;
+  return (iree_host_size_t)(hash >> 32) & (event_pool->shard_count - 1);
+}
+
 iree_status_t iree_event_pool_allocate(iree_host_size_t available_capacity,
                                        iree_allocator_t host_allocator,
                                        iree_event_pool_t** out_event_pool) {
@@ -38,23 +69,52 @@ iree_status_t iree_event_pool_allocate(iree_host_size_t available_capacity,
   *out_event_pool = NULL;
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  // Small pools are not worth splitting.
+  iree_host_size_t shard_count = 1;
+  while (shard_count < IREE_EVENT_POOL_MAX_SHARD_COUNT &&
+         shard_count * 2 <= available_capacity) {
+    shard_count *= 2;
+  }
+  iree_host_size_t shard_capacity =
+      (available_capacity + shard_count - 1) / shard_count;
+  iree_host_size_t shard_stride =
+      iree_host_align(sizeof(iree_event_pool_shard_t),
+                      iree_hardware_destructive_interference_size);
+
   iree_event_pool_t* event_pool = NULL;
   iree_host_size_t total_size =
-      sizeof(*event_pool) +
-      available_capacity * sizeof(event_pool->available_list[0]);
+      sizeof(*event_pool) + shard_count * shard_stride +
+      shard_count * shard_capacity * sizeof(iree_event_t);
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
       z0,
       iree_allocator_malloc(host_allocator, total_size, (void**)&event_pool));
   event_pool->host_allocator = host_allocator;
-  event_pool->available_capacity = available_capacity;
-  event_pool->available_count = 0;
+  event_pool->shard_count = shard_count;
+  event_pool->shard_stride = shard_stride;
+
+  iree_event_t* list_base =
+      (iree_event_t*)(event_pool->shard_storage + shard_count * shard_stride);
+  iree_host_size_t remaining_capacity = available_capacity;
+  for (iree_host_size_t i = 0; i < shard_count; ++i) {
+    iree_event_pool_shard_t* shard = iree_event_pool_shard_at(event_pool, i);
+    iree_slim_mutex_initialize(&shard->mutex);
+    shard->available_capacity = iree_min(shard_capacity, remaining_capacity);
+    shard->available_count = 0;
+    shard->available_list = list_base + i * shard_capacity;
+    remaining_capacity -= shard->available_capacity;
+  }
 
   iree_status_t status = iree_ok_status();
-  for (iree_host_size_t i = 0; i < available_capacity; ++i) {
-    status = iree_event_initialize(
-        /*initial_state=*/false,
-        &event_pool->available_list[event_pool->available_count++]);
-    if (!iree_status_is_ok(status)) break;
+  for (iree_host_size_t i = 0; i < shard_count && iree_status_is_ok(status);
+       ++i) {
+    iree_event_pool_shard_t* shard = iree_event_pool_shard_at(event_pool, i);
+    for (iree_host_size_t j = 0; j < shard->available_capacity; ++j) {
+      status = iree_event_initialize(
+          /*initial_state=*/false,
+          &shard->available_list[shard->available_count]);
+      if (!iree_status_is_ok(status)) break;
+      ++shard->available_count;
+    }
   }
 
   if (iree_status_is_ok(status)) {
@@ -70,15 +130,52 @@ void iree_event_pool_free(iree_event_pool_t* event_pool) {
   iree_allocator_t host_allocator = event_pool->host_allocator;
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  for (iree_host_size_t i = 0; i < event_pool->available_count; ++i) {
-    iree_event_deinitialize(&event_pool->available_list[i]);
+  for (iree_host_size_t i = 0; i < event_pool->shard_count; ++i) {
+    iree_event_pool_shard_t* shard = iree_event_pool_shard_at(event_pool, i);
+    for (iree_host_size_t j = 0; j < shard->available_count; ++j) {
+      iree_event_deinitialize(&shard->available_list[j]);
+    }
+    iree_slim_mutex_deinitialize(&shard->mutex);
   }
-  iree_slim_mutex_deinitialize(&event_pool->mutex);
   iree_allocator_free(host_allocator, event_pool);
 
   IREE_TRACE_ZONE_END(z0);
 }
 
+// Moves up to |event_count| available events from |shard| into |out_events|
+// and returns the number moved.
+static iree_host_size_t iree_event_pool_shard_take(
+    iree_event_pool_shard_t* shard, iree_host_size_t event_count,
+    iree_event_t* out_events) {
+  iree_slim_mutex_lock(&shard->mutex);
+  iree_host_size_t take_count = iree_min(shard->available_count, event_count);
+  if (take_count > 0) {
+    iree_host_size_t base_index = shard->available_count - take_count;
+    memcpy(out_events, &shard->available_list[base_index],
+           take_count * sizeof(iree_event_t));
+    shard->available_count -= take_count;
+  }
+  iree_slim_mutex_unlock(&shard->mutex);
+  return take_count;
+}
+
+// Moves up to |event_count| |events| into the available list of |shard| and
+// returns the number moved. The events must have already been reset.
+static iree_host_size_t iree_event_pool_shard_put(
+    iree_event_pool_shard_t* shard, iree_host_size_t event_count,
+    iree_event_t* events) {
+  iree_slim_mutex_lock(&shard->mutex);
+  iree_host_size_t put_count = iree_min(
+      shard->available_capacity - shard->available_count, event_count);
+  if (put_count > 0) {
+    memcpy(&shard->available_list[shard->available_count], events,
+           put_count * sizeof(iree_event_t));
+    shard->available_count += put_count;
+  }
+  iree_slim_mutex_unlock(&shard->mutex);
+  return put_count;
+}
+
 iree_status_t iree_event_pool_acquire(iree_event_pool_t* event_pool,
                                       iree_host_size_t event_count,
                                       iree_event_t* out_events) {
@@ -87,22 +184,19 @@ iree_status_t iree_event_pool_acquire(iree_event_pool_t* event_pool,
   IREE_ASSERT_ARGUMENT(out_events);
 
   // We'll try to get what we can from the pool and fall back to initializing
-  // new events.
-  iree_host_size_t remaining_count = event_count;
-
-  // Try first to grab from the pool.
-  iree_slim_mutex_lock(&event_pool->mutex);
-  iree_host_size_t from_pool_count =
-      iree_min(event_pool->available_count, event_count);
-  if (from_pool_count > 0) {
-    iree_host_size_t pool_base_index =
-        event_pool->available_count - from_pool_count;
-    memcpy(out_events, &event_pool->available_list[pool_base_index],
-           from_pool_count * sizeof(iree_event_t));
-    event_pool->available_count -= from_pool_count;
-    remaining_count -= from_pool_count;
+  // new events. The shard of the calling thread is tried first and then the
+  // others before paying for new events.
+  iree_host_size_t from_pool_count = 0;
+  iree_host_size_t home_index = iree_event_pool_select_shard(event_pool);
+  for (iree_host_size_t i = 0;
+       i < event_pool->shard_count && from_pool_count < event_count; ++i) {
+    iree_event_pool_shard_t* shard = iree_event_pool_shard_at(
+        event_pool, (home_index + i) & (event_pool->shard_count - 1));
+    from_pool_count +=
+        iree_event_pool_shard_take(shard, event_count - from_pool_count,
+                                   &out_events[from_pool_count]);
   }
-  iree_slim_mutex_unlock(&event_pool->mutex);
+  iree_host_size_t remaining_count = event_count - from_pool_count;
 
   // Allocate the rest of the events.
   if (remaining_count > 0) {
@@ -131,31 +225,27 @@ void iree_event_pool_release(iree_event_pool_t* event_pool,
   if (!event_count) return;
   IREE_ASSERT_ARGUMENT(events);
 
-  // We'll try to release all we can back to the pool and then deinitialize
-  // the ones that won't fit.
-  iree_host_size_t remaining_count = event_count;
-
-  // Try first to release to the pool.
   // Note that we reset the events we add back to the pool so that they are
-  // ready to be acquired again.
-  iree_slim_mutex_lock(&event_pool->mutex);
-  iree_host_size_t to_pool_count =
-      iree_min(event_pool->available_capacity - event_pool->available_count,
-               event_count);
-  if (to_pool_count > 0) {
-    iree_host_size_t pool_base_index = event_pool->available_count;
-    for (iree_host_size_t i = 0; i < to_pool_count; ++i) {
-      iree_event_reset(&events[i]);
-    }
-    memcpy(&event_pool->available_list[pool_base_index], events,
-           to_pool_count * sizeof(iree_event_t));
-    event_pool->available_count += to_pool_count;
-    remaining_count -= to_pool_count;
+  // ready to be acquired again. This is done outside of the shard locks as it
+  // may be a syscall.
+  for (iree_host_size_t i = 0; i < event_count; ++i) {
+    iree_event_reset(&events[i]);
+  }
+
+  // We'll try to release all we can back to the pool (preferring the shard of
+  // the calling thread) and then deinitialize the ones that won't fit.
+  iree_host_size_t to_pool_count = 0;
+  iree_host_size_t home_index = iree_event_pool_select_shard(event_pool);
+  for (iree_host_size_t i = 0;
+       i < event_pool->shard_count && to_pool_count < event_count; ++i) {
+    iree_event_pool_shard_t* shard = iree_event_pool_shard_at(
+        event_pool, (home_index + i) & (event_pool->shard_count - 1));
+    to_pool_count += iree_event_pool_shard_put(
+        shard, event_count - to_pool_count, &events[to_pool_count]);
   }
-  iree_slim_mutex_unlock(&event_pool->mutex);
+  iree_host_size_t remaining_count = event_count - to_pool_count;
 
-  // Deallocate the rest of the events. We don't bother resetting them as we are
-  // getting rid of them.
+  // Deallocate the rest of the events.
   if (remaining_count > 0) {
     IREE_TRACE_ZONE_BEGIN(z0);
     for (iree_host_size_t i = 0; i < remaining_count; ++i) {
@@ -16,6 +16,11 @@ extern "C" {
 
 // A simple pool of iree_event_ts to recycle.
 //
+// The pool is split into shards that each hold a portion of the available
+// events behind their own lock. Threads acquire from and release to the shard
+// associated with them first and only touch the others when their shard is
+// empty or full, keeping contention low when many threads churn events.
+//
 // Thread-safe; multiple threads may acquire and release events from the pool.
 typedef struct iree_event_pool_t iree_event_pool_t;
 
@@ -0,0 +1,81 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/base/internal/event_pool.h"
+
+#include <thread>
+#include <vector>
+
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace {
+
+TEST(EventPoolTest, Lifetime) {
+  iree_event_pool_t* event_pool = NULL;
+  IREE_ASSERT_OK(
+      iree_event_pool_allocate(16, iree_allocator_system(), &event_pool));
+  iree_event_pool_free(event_pool);
+}
+
+TEST(EventPoolTest, EmptyPool) {
+  iree_event_pool_t* event_pool = NULL;
+  IREE_ASSERT_OK(
+      iree_event_pool_allocate(0, iree_allocator_system(), &event_pool));
+  iree_event_t events[2];
+  IREE_ASSERT_OK(iree_event_pool_acquire(event_pool, 2, events));
+  iree_event_pool_release(event_pool, 2, events);
+  iree_event_pool_free(event_pool);
+}
+
+// Acquires more events than the pool holds and ensures that released events
+// are unsignaled when reacquired.
+TEST(EventPoolTest, AcquireBeyondCapacity) {
+  iree_event_pool_t* event_pool = NULL;
+  IREE_ASSERT_OK(
+      iree_event_pool_allocate(16, iree_allocator_system(), &event_pool));
+
+  iree_event_t events[32];
+  IREE_ASSERT_OK(iree_event_pool_acquire(event_pool, 32, events));
+  for (auto& event : events) iree_event_set(&event);
+  iree_event_pool_release(event_pool, 32, events);
+
+  IREE_ASSERT_OK(iree_event_pool_acquire(event_pool, 32, events));
+  for (auto& event : events) {
+    EXPECT_EQ(IREE_STATUS_DEADLINE_EXCEEDED,
+              iree_status_consume_code(
+                  iree_wait_one(&event, IREE_TIME_INFINITE_PAST)));
+  }
+  iree_event_pool_release(event_pool, 32, events);
+
+  iree_event_pool_free(event_pool);
+}
+
+// Acquires and releases from many threads at once such that all shards are
+// used concurrently and events move between them.
+TEST(EventPoolTest, ConcurrentAcquireRelease) {
+  iree_event_pool_t* event_pool = NULL;
+  IREE_ASSERT_OK(
+      iree_event_pool_allocate(32, iree_allocator_system(), &event_pool));
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 8; ++i) {
+    threads.emplace_back([event_pool, i]() {
+      iree_event_t events[4];
+      for (int j = 0; j < 1000; ++j) {
+        iree_host_size_t count = 1 + (i + j) % 4;
+        IREE_ASSERT_OK(iree_event_pool_acquire(event_pool, count, events));
+        iree_event_set(&events[0]);
+        iree_event_pool_release(event_pool, count, events);
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+
+  iree_event_pool_free(event_pool);
+}
+
+}  // namespace
@@ -29,6 +29,33 @@ iree_status_t iree_file_read_contents(const char* path,
                                       iree_allocator_t allocator,
                                       iree_byte_span_t* out_contents);
 
+// Maps a file's contents into memory read-only.
+//
+// Where supported (POSIX mmap and Windows file mappings) the returned
+// |out_contents| alias the file in the system page cache: no copy is made,
+// pages are only brought into memory as they are touched, and the pages are
+// shared with other processes mapping the same file. On other platforms the
+// file is read into memory allocated from |host_allocator| as with
+// iree_file_read_contents. On Linux large files are mapped at huge page aligned
+// addresses and advised to use transparent huge pages where the kernel
+// supports them for file-backed memory.
+//
+// |out_deallocator| receives an allocator that releases the contents when
+// asked to free |out_contents|.data. It matches the ownership conventions of
+// APIs that take a data allocator (such as iree_vm_bytecode_module_create and
+// iree_hal_allocator_wrap_buffer) and can be passed directly to them.
+// Otherwise callers must release the contents with
+// iree_allocator_free(*out_deallocator, out_contents->data). The deallocator
+// may only be used once. Empty files produce empty contents and a null
+// deallocator.
+//
+// The contents must not be written and must not be made mutable: the mapping
+// is read-only and writes will fault.
+iree_status_t iree_file_map_contents(const char* path,
+                                     iree_allocator_t host_allocator,
+                                     iree_const_byte_span_t* out_contents,
+                                     iree_allocator_t* out_deallocator);
+
 // Synchronously writes a byte buffer into a file.
 // Existing contents are overwritten.
 iree_status_t iree_file_write_contents(const char* path,
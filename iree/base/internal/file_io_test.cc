@@ -73,6 +73,68 @@ TEST(FileIO, ReadWriteContents) {
   iree_allocator_free(iree_allocator_system(), read_contents.data);
 }
 
+TEST(FileIO, MapContents) {
+  constexpr const char* kUniqueName = "MapContents";
+  auto path = GetUniquePath(kUniqueName);
+
+  // Generate file contents and write them to disk.
+  auto write_contents = GetUniqueContents(kUniqueName);
+  IREE_ASSERT_OK(iree_file_write_contents(
+      path.c_str(),
+      iree_make_const_byte_span(write_contents.data(), write_contents.size())));
+
+  // Map the contents from disk.
+  iree_const_byte_span_t mapped_contents;
+  iree_allocator_t deallocator;
+  IREE_ASSERT_OK(iree_file_map_contents(path.c_str(), iree_allocator_system(),
+                                        &mapped_contents, &deallocator));
+
+  // Expect the contents are equal.
+  EXPECT_EQ(write_contents.size(), mapped_contents.data_length);
+  EXPECT_EQ(memcmp(write_contents.data(), mapped_contents.data,
+                   mapped_contents.data_length),
+            0);
+
+  iree_allocator_free(deallocator, (void*)mapped_contents.data);
+}
+
+// Files large enough to be mapped with huge pages take a different path.
+TEST(FileIO, MapLargeContents) {
+  constexpr const char* kUniqueName = "MapLargeContents";
+  auto path = GetUniquePath(kUniqueName);
+
+  // Generate file contents that don't end on a page boundary.
+  std::string write_contents(4 * 1024 * 1024 + 123, 0);
+  for (size_t i = 0; i < write_contents.size(); ++i) {
+    write_contents[i] = (char)(i * 31);
+  }
+  IREE_ASSERT_OK(iree_file_write_contents(
+      path.c_str(),
+      iree_make_const_byte_span(write_contents.data(), write_contents.size())));
+
+  iree_const_byte_span_t mapped_contents;
+  iree_allocator_t deallocator;
+  IREE_ASSERT_OK(iree_file_map_contents(path.c_str(), iree_allocator_system(),
+                                        &mapped_contents, &deallocator));
+
+  EXPECT_EQ(write_contents.size(), mapped_contents.data_length);
+  EXPECT_EQ(memcmp(write_contents.data(), mapped_contents.data,
+                   mapped_contents.data_length),
+            0);
+
+  iree_allocator_free(deallocator, (void*)mapped_contents.data);
+}
+
+TEST(FileIO, MapContentsNotFound) {
+  auto path = GetUniquePath("MapContentsNotFound");
+  iree_const_byte_span_t mapped_contents;
+  iree_allocator_t deallocator;
+  IREE_EXPECT_STATUS_IS(
+      IREE_STATUS_NOT_FOUND,
+      iree_file_map_contents(path.c_str(), iree_allocator_system(),
+                             &mapped_contents, &deallocator));
+}
+
 }  // namespace
 }  // namespace file_io
 }  // namespace iree
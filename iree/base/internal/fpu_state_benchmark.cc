@@ -121,4 +121,33 @@ void BM_VectorizedDenormalsNotFlushedToZero(benchmark::State& state) {
 }
 BENCHMARK(BM_VectorizedDenormalsNotFlushedToZero);
 
+// Measures the cost of a push/pop pair that matches the current state and is
+// elided, as when consecutive dispatches share the same requirements.
+void BM_PushPopUnchanged(benchmark::State& state) {
+  iree_fpu_state_t outer_state =
+      iree_fpu_state_push(IREE_FPU_STATE_FLAG_FLUSH_DENORMALS_TO_ZERO);
+  for (auto _ : state) {
+    iree_fpu_state_t fpu_state =
+        iree_fpu_state_push(IREE_FPU_STATE_FLAG_FLUSH_DENORMALS_TO_ZERO);
+    benchmark::ClobberMemory();
+    iree_fpu_state_pop(fpu_state);
+  }
+  iree_fpu_state_pop(outer_state);
+}
+BENCHMARK(BM_PushPopUnchanged);
+
+// Measures the cost of a push/pop pair that switches the state, as when a
+// dispatch requiring IEEE denormals runs on a worker flushing them to zero.
+void BM_PushPopChanged(benchmark::State& state) {
+  iree_fpu_state_t outer_state =
+      iree_fpu_state_push(IREE_FPU_STATE_FLAG_FLUSH_DENORMALS_TO_ZERO);
+  for (auto _ : state) {
+    iree_fpu_state_t fpu_state = iree_fpu_state_push(IREE_FPU_STATE_DEFAULT);
+    benchmark::ClobberMemory();
+    iree_fpu_state_pop(fpu_state);
+  }
+  iree_fpu_state_pop(outer_state);
+}
+BENCHMARK(BM_PushPopChanged);
+
 }  // namespace
@@ -0,0 +1,333 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/base/internal/io_uring.h"
+
+#include <string.h>
+
+#include "iree/base/tracing.h"
+
+#if defined(IREE_HAVE_IO_URING)
+
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static_assert(sizeof(((iree_io_uring_t*)NULL)->timeout_ts) ==
+                  sizeof(struct __kernel_timespec),
+              "timeout storage must match the kernel timespec layout");
+
+//===----------------------------------------------------------------------===//
+// Syscalls
+//===----------------------------------------------------------------------===//
+// glibc does not provide wrappers for the io_uring syscalls.
+//
+// Documentation: https://man.archlinux.org/man/io_uring.7
+
+static int iree_syscall_io_uring_setup(uint32_t entries,
+                                       struct io_uring_params* params) {
+  return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int iree_syscall_io_uring_enter(int fd, uint32_t to_submit,
+                                       uint32_t min_complete, uint32_t flags) {
+  return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags,
+                      NULL, 0);
+}
+
+//===----------------------------------------------------------------------===//
+// iree_io_uring_t
+//===----------------------------------------------------------------------===//
+
+// The ring head/tail indices are shared with the kernel and must be accessed
+// with acquire/release semantics. They are plain uint32_t in the kernel ABI so
+// we can't use the iree_atomic_* types.
+#define iree_io_uring_load_acquire(ptr) __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#define iree_io_uring_store_release(ptr, value) \
+  __atomic_store_n(ptr, value, __ATOMIC_RELEASE)
+
+iree_status_t iree_io_uring_initialize(uint32_t entry_count,
+                                       iree_io_uring_t* out_ring) {
+  IREE_ASSERT_ARGUMENT(out_ring);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  memset(out_ring, 0, sizeof(*out_ring));
+  out_ring->fd = -1;
+
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  int fd = iree_syscall_io_uring_setup(entry_count, &params);
+  if (fd < 0) {
+    // ENOSYS: kernel too old; EPERM: disabled by policy (sysctl or seccomp).
+    int error = errno;
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(error == ENOSYS || error == EPERM
+                                ? IREE_STATUS_UNAVAILABLE
+                                : iree_status_code_from_errno(error),
+                            "io_uring_setup failed (%d)", error);
+  }
+  out_ring->fd = fd;
+  out_ring->sq_entries = params.sq_entries;
+  out_ring->cq_entries = params.cq_entries;
+
+  iree_status_t status = iree_ok_status();
+  out_ring->sq_ring_size =
+      params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+  out_ring->cq_ring_size =
+      params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    out_ring->sq_ring_size =
+        iree_max(out_ring->sq_ring_size, out_ring->cq_ring_size);
+    out_ring->cq_ring_size = out_ring->sq_ring_size;
+  }
+  out_ring->sq_ring_ptr =
+      mmap(NULL, out_ring->sq_ring_size, PROT_READ | PROT_WRITE,
+           MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  if (out_ring->sq_ring_ptr == MAP_FAILED) {
+    out_ring->sq_ring_ptr = NULL;
+    status = iree_make_status(iree_status_code_from_errno(errno),
+                              "failed to map io_uring submission ring");
+  }
+  if (iree_status_is_ok(status)) {
+    if (single_mmap) {
+      out_ring->cq_ring_ptr = out_ring->sq_ring_ptr;
+    } else {
+      out_ring->cq_ring_ptr =
+          mmap(NULL, out_ring->cq_ring_size, PROT_READ | PROT_WRITE,
+               MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+      if (out_ring->cq_ring_ptr == MAP_FAILED) {
+        out_ring->cq_ring_ptr = NULL;
+        status = iree_make_status(iree_status_code_from_errno(errno),
+                                  "failed to map io_uring completion ring");
+      }
+    }
+  }
+  if (iree_status_is_ok(status)) {
+    out_ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    out_ring->sqes =
+        (struct io_uring_sqe*)mmap(NULL, out_ring->sqes_size,
+                                   PROT_READ | PROT_WRITE,
+                                   MAP_SHARED | MAP_POPULATE, fd,
+                                   IORING_OFF_SQES);
+    if (out_ring->sqes == MAP_FAILED) {
+      out_ring->sqes = NULL;
+      status = iree_make_status(iree_status_code_from_errno(errno),
+                                "failed to map io_uring submission entries");
+    }
+  }
+
+  if (iree_status_is_ok(status)) {
+    uint8_t* sq_ptr = (uint8_t*)out_ring->sq_ring_ptr;
+    out_ring->sq_head = (uint32_t*)(sq_ptr + params.sq_off.head);
+    out_ring->sq_tail = (uint32_t*)(sq_ptr + params.sq_off.tail);
+    out_ring->sq_ring_mask = (uint32_t*)(sq_ptr + params.sq_off.ring_mask);
+    out_ring->sq_array = (uint32_t*)(sq_ptr + params.sq_off.array);
+    out_ring->sq_local_tail = *out_ring->sq_tail;
+    uint8_t* cq_ptr = (uint8_t*)out_ring->cq_ring_ptr;
+    out_ring->cq_head = (uint32_t*)(cq_ptr + params.cq_off.head);
+    out_ring->cq_tail = (uint32_t*)(cq_ptr + params.cq_off.tail);
+    out_ring->cq_ring_mask = (uint32_t*)(cq_ptr + params.cq_off.ring_mask);
+    out_ring->cqes = (struct io_uring_cqe*)(cq_ptr + params.cq_off.cqes);
+  } else {
+    iree_io_uring_deinitialize(out_ring);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+void iree_io_uring_deinitialize(iree_io_uring_t* ring) {
+  IREE_ASSERT_ARGUMENT(ring);
+  if (ring->sqes) munmap(ring->sqes, ring->sqes_size);
+  if (ring->cq_ring_ptr && ring->cq_ring_ptr != ring->sq_ring_ptr) {
+    munmap(ring->cq_ring_ptr, ring->cq_ring_size);
+  }
+  if (ring->sq_ring_ptr) munmap(ring->sq_ring_ptr, ring->sq_ring_size);
+  // Closing the ring cancels any operations still in flight.
+  if (ring->fd >= 0) close(ring->fd);
+  memset(ring, 0, sizeof(*ring));
+  ring->fd = -1;
+}
+
+// Returns a zeroed submission entry at the local tail of the submission ring.
+// If the ring is full the queued entries are submitted without waiting to make
+// room.
+static iree_status_t iree_io_uring_acquire_sqe(
+    iree_io_uring_t* ring, struct io_uring_sqe** out_sqe) {
+  uint32_t head = iree_io_uring_load_acquire(ring->sq_head);
+  if (ring->sq_local_tail - head >= ring->sq_entries) {
+    IREE_RETURN_IF_ERROR(iree_io_uring_submit(ring, 0));
+    head = iree_io_uring_load_acquire(ring->sq_head);
+    if (ring->sq_local_tail - head >= ring->sq_entries) {
+      return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                              "io_uring submission ring full");
+    }
+  }
+  uint32_t index = ring->sq_local_tail & *ring->sq_ring_mask;
+  struct io_uring_sqe* sqe = &ring->sqes[index];
+  memset(sqe, 0, sizeof(*sqe));
+  ring->sq_array[index] = index;
+  ++ring->sq_local_tail;
+  *out_sqe = sqe;
+  return iree_ok_status();
+}
+
+iree_status_t iree_io_uring_queue_poll_add(iree_io_uring_t* ring, int fd,
+                                           uint32_t poll_events,
+                                           uint64_t user_data) {
+  struct io_uring_sqe* sqe = NULL;
+  IREE_RETURN_IF_ERROR(iree_io_uring_acquire_sqe(ring, &sqe));
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = fd;
+  sqe->poll32_events = poll_events;
+  sqe->user_data = user_data;
+  return iree_ok_status();
+}
+
+iree_status_t iree_io_uring_queue_poll_remove(iree_io_uring_t* ring,
+                                              uint64_t target_user_data,
+                                              uint64_t user_data) {
+  struct io_uring_sqe* sqe = NULL;
+  IREE_RETURN_IF_ERROR(iree_io_uring_acquire_sqe(ring, &sqe));
+  sqe->opcode = IORING_OP_POLL_REMOVE;
+  sqe->fd = -1;
+  sqe->addr = target_user_data;
+  sqe->user_data = user_data;
+  return iree_ok_status();
+}
+
+iree_status_t iree_io_uring_queue_timeout(iree_io_uring_t* ring,
+                                          iree_duration_t timeout_ns,
+                                          uint64_t user_data) {
+  struct io_uring_sqe* sqe = NULL;
+  IREE_RETURN_IF_ERROR(iree_io_uring_acquire_sqe(ring, &sqe));
+  timeout_ns = iree_max(0, timeout_ns);
+  ring->timeout_ts.tv_sec = timeout_ns / 1000000000ll;
+  ring->timeout_ts.tv_nsec = timeout_ns % 1000000000ll;
+  sqe->opcode = IORING_OP_TIMEOUT;
+  sqe->fd = -1;
+  sqe->addr = (uint64_t)(uintptr_t)&ring->timeout_ts;
+  sqe->len = 1;
+  sqe->user_data = user_data;
+  return iree_ok_status();
+}
+
+iree_status_t iree_io_uring_queue_timeout_remove(iree_io_uring_t* ring,
+                                                 uint64_t target_user_data,
+                                                 uint64_t user_data) {
+  struct io_uring_sqe* sqe = NULL;
+  IREE_RETURN_IF_ERROR(iree_io_uring_acquire_sqe(ring, &sqe));
+  sqe->opcode = IORING_OP_TIMEOUT_REMOVE;
+  sqe->fd = -1;
+  sqe->addr = target_user_data;
+  sqe->user_data = user_data;
+  return iree_ok_status();
+}
+
+iree_status_t iree_io_uring_queue_read(iree_io_uring_t* ring, int fd,
+                                       void* buffer, uint32_t length,
+                                       uint64_t offset, uint64_t user_data) {
+  struct io_uring_sqe* sqe = NULL;
+  IREE_RETURN_IF_ERROR(iree_io_uring_acquire_sqe(ring, &sqe));
+  sqe->opcode = IORING_OP_READ;
+  sqe->fd = fd;
+  sqe->addr = (uint64_t)(uintptr_t)buffer;
+  sqe->len = length;
+  sqe->off = offset;
+  sqe->user_data = user_data;
+  return iree_ok_status();
+}
+
+iree_status_t iree_io_uring_submit(iree_io_uring_t* ring,
+                                   uint32_t wait_count) {
+  // Publish all locally queued entries to the kernel. Entries published by a
+  // previous submission that was interrupted are still between the kernel head
+  // and our tail and will be submitted along with the new ones.
+  iree_io_uring_store_release(ring->sq_tail, ring->sq_local_tail);
+  uint32_t to_submit =
+      ring->sq_local_tail - iree_io_uring_load_acquire(ring->sq_head);
+  // GETEVENTS is always passed (even when not waiting) so that operations that
+  // complete inline during submission (such as polls of ready fds) have posted
+  // their completions by the time the syscall returns.
+  int rv = iree_syscall_io_uring_enter(ring->fd, to_submit, wait_count,
+                                       IORING_ENTER_GETEVENTS);
+  if (IREE_UNLIKELY(rv < 0)) {
+    if (errno == EINTR) {
+      return iree_status_from_code(IREE_STATUS_DEFERRED);
+    }
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "io_uring_enter failure %d", errno);
+  }
+  return iree_ok_status();
+}
+
+bool iree_io_uring_pop_completion(iree_io_uring_t* ring,
+                                  uint64_t* out_user_data,
+                                  int32_t* out_result) {
+  uint32_t head = *ring->cq_head;
+  if (head == iree_io_uring_load_acquire(ring->cq_tail)) return false;
+  const struct io_uring_cqe* cqe = &ring->cqes[head & *ring->cq_ring_mask];
+  *out_user_data = cqe->user_data;
+  *out_result = cqe->res;
+  iree_io_uring_store_release(ring->cq_head, head + 1);
+  return true;
+}
+
+#else
+
+iree_status_t iree_io_uring_initialize(uint32_t entry_count,
+                                       iree_io_uring_t* out_ring) {
+  memset(out_ring, 0, sizeof(*out_ring));
+  return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                          "io_uring is not available on this platform");
+}
+
+void iree_io_uring_deinitialize(iree_io_uring_t* ring) {}
+
+iree_status_t iree_io_uring_queue_poll_add(iree_io_uring_t* ring, int fd,
+                                           uint32_t poll_events,
+                                           uint64_t user_data) {
+  return iree_make_status(IREE_STATUS_UNAVAILABLE);
+}
+
+iree_status_t iree_io_uring_queue_poll_remove(iree_io_uring_t* ring,
+                                              uint64_t target_user_data,
+                                              uint64_t user_data) {
+  return iree_make_status(IREE_STATUS_UNAVAILABLE);
+}
+
+iree_status_t iree_io_uring_queue_timeout(iree_io_uring_t* ring,
+                                          iree_duration_t timeout_ns,
+                                          uint64_t user_data) {
+  return iree_make_status(IREE_STATUS_UNAVAILABLE);
+}
+
+iree_status_t iree_io_uring_queue_timeout_remove(iree_io_uring_t* ring,
+                                                 uint64_t target_user_data,
+                                                 uint64_t user_data) {
+  return iree_make_status(IREE_STATUS_UNAVAILABLE);
+}
+
+iree_status_t iree_io_uring_queue_read(iree_io_uring_t* ring, int fd,
+                                       void* buffer, uint32_t length,
+                                       uint64_t offset, uint64_t user_data) {
+  return iree_make_status(IREE_STATUS_UNAVAILABLE);
+}
+
+iree_status_t iree_io_uring_submit(iree_io_uring_t* ring,
+                                   uint32_t wait_count) {
+  return iree_make_status(IREE_STATUS_UNAVAILABLE);
+}
+
+bool iree_io_uring_pop_completion(iree_io_uring_t* ring,
+                                  uint64_t* out_user_data,
+                                  int32_t* out_result) {
+  return false;
+}
+
+#endif  // IREE_HAVE_IO_URING
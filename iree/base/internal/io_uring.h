@@ -0,0 +1,136 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_BASE_INTERNAL_IO_URING_H_
+#define IREE_BASE_INTERNAL_IO_URING_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "iree/base/api.h"
+#include "iree/base/target_platform.h"
+
+#if defined(IREE_PLATFORM_LINUX) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define IREE_HAVE_IO_URING 1
+#endif  // __has_include(<linux/io_uring.h>)
+#endif  // IREE_PLATFORM_LINUX
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+//===----------------------------------------------------------------------===//
+// iree_io_uring_t
+//===----------------------------------------------------------------------===//
+
+// A minimal Linux io_uring submission/completion ring pair.
+// Operations are queued into the submission ring without making any syscalls
+// and are submitted to the kernel in a single batch with iree_io_uring_submit,
+// which can also block until completions arrive. Completions are then popped
+// from the completion ring without syscalls.
+//
+// The ring is implemented directly on the io_uring syscalls so there is no
+// dependency on liburing. Rings are not supported on all kernels (and may be
+// disabled by seccomp policies in containers) and initialization will fail
+// with IREE_STATUS_UNAVAILABLE in those cases such that callers can fall back
+// to other mechanisms.
+//
+// Thread-compatible; a ring must only be used by one thread at a time.
+typedef struct iree_io_uring_t {
+#if defined(IREE_HAVE_IO_URING)
+  int fd;
+  uint32_t sq_entries;
+  uint32_t cq_entries;
+
+  // Submission ring shared with the kernel.
+  void* sq_ring_ptr;
+  iree_host_size_t sq_ring_size;
+  uint32_t* sq_head;
+  uint32_t* sq_tail;
+  uint32_t* sq_ring_mask;
+  uint32_t* sq_array;
+  struct io_uring_sqe* sqes;
+  iree_host_size_t sqes_size;
+  // Local tail of entries queued but not yet published to the kernel.
+  uint32_t sq_local_tail;
+
+  // Completion ring shared with the kernel. May alias the submission ring
+  // mapping on kernels supporting IORING_FEAT_SINGLE_MMAP.
+  void* cq_ring_ptr;
+  iree_host_size_t cq_ring_size;
+  uint32_t* cq_head;
+  uint32_t* cq_tail;
+  uint32_t* cq_ring_mask;
+  struct io_uring_cqe* cqes;
+
+  // Storage for the timespec of a queued timeout; the kernel reads it when the
+  // timeout is submitted.
+  struct {
+    int64_t tv_sec;
+    long long tv_nsec;
+  } timeout_ts;
+#else
+  int reserved;
+#endif  // IREE_HAVE_IO_URING
+} iree_io_uring_t;
+
+// Initializes |out_ring| with room for at least |entry_count| queued
+// submissions. Returns IREE_STATUS_UNAVAILABLE if io_uring is not supported by
+// the platform or the running kernel.
+iree_status_t iree_io_uring_initialize(uint32_t entry_count,
+                                       iree_io_uring_t* out_ring);
+
+// Deinitializes |ring|. Operations still in flight in the kernel are cancelled.
+void iree_io_uring_deinitialize(iree_io_uring_t* ring);
+
+// Queues a one-shot poll of |fd| for |poll_events| (POLLIN/etc). The
+// completion result is the triggered poll events or a negative errno.
+iree_status_t iree_io_uring_queue_poll_add(iree_io_uring_t* ring, int fd,
+                                           uint32_t poll_events,
+                                           uint64_t user_data);
+
+// Queues the removal of the pending poll queued with |target_user_data|.
+iree_status_t iree_io_uring_queue_poll_remove(iree_io_uring_t* ring,
+                                              uint64_t target_user_data,
+                                              uint64_t user_data);
+
+// Queues a timeout that completes with -ETIME after |timeout_ns|.
+// Only one timeout may be queued per submission.
+iree_status_t iree_io_uring_queue_timeout(iree_io_uring_t* ring,
+                                          iree_duration_t timeout_ns,
+                                          uint64_t user_data);
+
+// Queues the removal of the pending timeout queued with |target_user_data|.
+iree_status_t iree_io_uring_queue_timeout_remove(iree_io_uring_t* ring,
+                                                 uint64_t target_user_data,
+                                                 uint64_t user_data);
+
+// Queues a read of |length| bytes from |fd| at |offset| into |buffer|. The
+// completion result is the number of bytes read or a negative errno.
+// |buffer| must remain valid until the read completes.
+iree_status_t iree_io_uring_queue_read(iree_io_uring_t* ring, int fd,
+                                       void* buffer, uint32_t length,
+                                       uint64_t offset, uint64_t user_data);
+
+// Submits all queued operations to the kernel in a single syscall and, if
+// |wait_count| is non-zero, blocks until at least that many completions are
+// available. Operations that complete inline during submission have their
+// completions available upon return even if |wait_count| is zero. Returns
+// IREE_STATUS_DEFERRED if interrupted by a signal; queued operations that were
+// not yet submitted remain queued.
+iree_status_t iree_io_uring_submit(iree_io_uring_t* ring, uint32_t wait_count);
+
+// Pops the next completion from the ring, if any, without making a syscall.
+bool iree_io_uring_pop_completion(iree_io_uring_t* ring,
+                                  uint64_t* out_user_data,
+                                  int32_t* out_result);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_BASE_INTERNAL_IO_URING_H_
@@ -0,0 +1,362 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/base/internal/mpmc_queue.h"
+
+#include <string.h>
+
+#include "iree/base/tracing.h"
+
+//==============================================================================
+// iree_mpmc_queue_t
+//==============================================================================
+
+// Set on the enqueue position of a queue once no more values may be enqueued.
+// Only used by segmented queues to seal segments that have been superseded.
+#define IREE_MPMC_QUEUE_SEALED_BIT (1ll << 62)
+
+iree_host_size_t iree_mpmc_queue_storage_size(iree_host_size_t capacity) {
+  return capacity * sizeof(iree_mpmc_queue_cell_t);
+}
+
+void iree_mpmc_queue_initialize(iree_host_size_t capacity, void* storage,
+                                iree_mpmc_queue_t* out_queue) {
+  IREE_ASSERT_ARGUMENT(storage);
+  IREE_ASSERT_ARGUMENT(out_queue);
+  IREE_ASSERT(capacity >= 2 && (capacity & (capacity - 1)) == 0);
+  memset(out_queue, 0, sizeof(*out_queue));
+  out_queue->cells = (iree_mpmc_queue_cell_t*)storage;
+  out_queue->capacity_mask = (int64_t)capacity - 1;
+  for (iree_host_size_t i = 0; i < capacity; ++i) {
+    iree_atomic_store_int64(&out_queue->cells[i].sequence, (int64_t)i,
+                            iree_memory_order_relaxed);
+    out_queue->cells[i].value = NULL;
+  }
+  iree_atomic_store_int64(&out_queue->enqueue_position, 0,
+                          iree_memory_order_relaxed);
+  iree_atomic_store_int64(&out_queue->dequeue_position, 0,
+                          iree_memory_order_release);
+}
+
+void iree_mpmc_queue_deinitialize(iree_mpmc_queue_t* queue) {
+  IREE_ASSERT_ARGUMENT(queue);
+  memset(queue, 0, sizeof(*queue));
+}
+
+bool iree_mpmc_queue_try_enqueue(iree_mpmc_queue_t* queue, void* value) {
+  IREE_ASSERT_ARGUMENT(queue);
+  iree_mpmc_queue_cell_t* cell = NULL;
+  int64_t position = iree_atomic_load_int64(&queue->enqueue_position,
+                                            iree_memory_order_relaxed);
+  while (true) {
+    // Sealed queues reject all enqueues; the sealed bit is part of the
+    // position such that the CAS below fails if the queue is sealed while we
+    // are trying to claim the cell.
+    if (IREE_UNLIKELY(position & IREE_MPMC_QUEUE_SEALED_BIT)) return false;
+    cell = &queue->cells[position & queue->capacity_mask];
+    int64_t sequence =
+        iree_atomic_load_int64(&cell->sequence, iree_memory_order_acquire);
+    int64_t difference = sequence - position;
+    if (difference == 0) {
+      // Cell is available; try to claim it.
+      if (iree_atomic_compare_exchange_weak_int64(
+              &queue->enqueue_position, &position, position + 1,
+              iree_memory_order_relaxed, iree_memory_order_relaxed)) {
+        break;
+      }
+    } else if (difference < 0) {
+      // Cell still holds a value from the previous lap: full.
+      return false;
+    } else {
+      // Another producer claimed the cell; reload and try the next.
+      position = iree_atomic_load_int64(&queue->enqueue_position,
+                                        iree_memory_order_relaxed);
+    }
+  }
+  cell->value = value;
+  iree_atomic_store_int64(&cell->sequence, position + 1,
+                          iree_memory_order_release);
+  return true;
+}
+
+bool iree_mpmc_queue_try_dequeue(iree_mpmc_queue_t* queue, void** out_value) {
+  IREE_ASSERT_ARGUMENT(queue);
+  IREE_ASSERT_ARGUMENT(out_value);
+  iree_mpmc_queue_cell_t* cell = NULL;
+  int64_t position = iree_atomic_load_int64(&queue->dequeue_position,
+                                            iree_memory_order_relaxed);
+  while (true) {
+    cell = &queue->cells[position & queue->capacity_mask];
+    int64_t sequence =
+        iree_atomic_load_int64(&cell->sequence, iree_memory_order_acquire);
+    int64_t difference = sequence - (position + 1);
+    if (difference == 0) {
+      // Cell holds a value; try to claim it.
+      if (iree_atomic_compare_exchange_weak_int64(
+              &queue->dequeue_position, &position, position + 1,
+              iree_memory_order_relaxed, iree_memory_order_relaxed)) {
+        break;
+      }
+    } else if (difference < 0) {
+      // Cell has not been written yet: empty (or an enqueue is in flight).
+      return false;
+    } else {
+      // Another consumer claimed the cell; reload and try the next.
+      position = iree_atomic_load_int64(&queue->dequeue_position,
+                                        iree_memory_order_relaxed);
+    }
+  }
+  *out_value = cell->value;
+  iree_atomic_store_int64(&cell->sequence, position + queue->capacity_mask + 1,
+                          iree_memory_order_release);
+  return true;
+}
+
+// Seals |queue| such that all subsequent enqueues fail.
+static void iree_mpmc_queue_seal(iree_mpmc_queue_t* queue) {
+  iree_atomic_fetch_or_int64(&queue->enqueue_position,
+                             IREE_MPMC_QUEUE_SEALED_BIT,
+                             iree_memory_order_acq_rel);
+}
+
+// Returns true if |queue| has been sealed and all values enqueued prior to
+// sealing have been dequeued.
+static bool iree_mpmc_queue_is_drained(iree_mpmc_queue_t* queue) {
+  int64_t enqueue_position = iree_atomic_load_int64(&queue->enqueue_position,
+                                                    iree_memory_order_acquire);
+  if (!(enqueue_position & IREE_MPMC_QUEUE_SEALED_BIT)) return false;
+  int64_t dequeue_position = iree_atomic_load_int64(&queue->dequeue_position,
+                                                    iree_memory_order_acquire);
+  return dequeue_position == (enqueue_position & ~IREE_MPMC_QUEUE_SEALED_BIT);
+}
+
+//==============================================================================
+// iree_mpmc_segmented_queue_t
+//==============================================================================
+
+struct iree_mpmc_segmented_queue_segment_t {
+  // Next segment in FIFO order; set once the tail segment is sealed.
+  iree_atomic_intptr_t next;
+  // Next segment in the retired list.
+  iree_mpmc_segmented_queue_segment_t* next_retired;
+  // Ring holding the values of the segment in the trailing storage.
+  iree_mpmc_queue_t ring;
+  // + trailing iree_mpmc_queue_cell_t storage
+};
+
+static iree_status_t iree_mpmc_segmented_queue_allocate_segment(
+    iree_mpmc_segmented_queue_t* queue,
+    iree_mpmc_segmented_queue_segment_t** out_segment) {
+  *out_segment = NULL;
+  iree_mpmc_segmented_queue_segment_t* segment = NULL;
+  iree_host_size_t header_size =
+      iree_host_align(sizeof(*segment), iree_max_align_t);
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+      queue->host_allocator,
+      header_size + iree_mpmc_queue_storage_size(queue->segment_capacity),
+      (void**)&segment));
+  iree_mpmc_queue_initialize(queue->segment_capacity,
+                             (uint8_t*)segment + header_size, &segment->ring);
+  *out_segment = segment;
+  return iree_ok_status();
+}
+
+static void iree_mpmc_segmented_queue_free_segment(
+    iree_mpmc_segmented_queue_t* queue,
+    iree_mpmc_segmented_queue_segment_t* segment) {
+  iree_mpmc_queue_deinitialize(&segment->ring);
+  iree_allocator_free(queue->host_allocator, segment);
+}
+
+iree_status_t iree_mpmc_segmented_queue_initialize(
+    iree_host_size_t segment_capacity, iree_allocator_t host_allocator,
+    iree_mpmc_segmented_queue_t* out_queue) {
+  IREE_ASSERT_ARGUMENT(out_queue);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  memset(out_queue, 0, sizeof(*out_queue));
+  out_queue->host_allocator = host_allocator;
+  out_queue->segment_capacity = segment_capacity;
+  iree_slim_mutex_initialize(&out_queue->mutex);
+
+  // NOTE: the queue is left empty with no segments on failure such that it can
+  // still be deinitialized.
+  iree_mpmc_segmented_queue_segment_t* segment = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_mpmc_segmented_queue_allocate_segment(out_queue, &segment));
+  iree_atomic_store_intptr(&out_queue->head_segment, (intptr_t)segment,
+                           iree_memory_order_relaxed);
+  iree_atomic_store_intptr(&out_queue->tail_segment, (intptr_t)segment,
+                           iree_memory_order_relaxed);
+
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+void iree_mpmc_segmented_queue_deinitialize(
+    iree_mpmc_segmented_queue_t* queue) {
+  IREE_ASSERT_ARGUMENT(queue);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_mpmc_segmented_queue_segment_t* segment =
+      (iree_mpmc_segmented_queue_segment_t*)iree_atomic_load_intptr(
+          &queue->head_segment, iree_memory_order_acquire);
+  while (segment) {
+    iree_mpmc_segmented_queue_segment_t* next_segment =
+        (iree_mpmc_segmented_queue_segment_t*)iree_atomic_load_intptr(
+            &segment->next, iree_memory_order_acquire);
+    iree_mpmc_segmented_queue_free_segment(queue, segment);
+    segment = next_segment;
+  }
+  while (queue->retired_list) {
+    segment = queue->retired_list;
+    queue->retired_list = segment->next_retired;
+    iree_mpmc_segmented_queue_free_segment(queue, segment);
+  }
+  if (queue->free_segment) {
+    iree_mpmc_segmented_queue_free_segment(queue, queue->free_segment);
+  }
+  iree_slim_mutex_deinitialize(&queue->mutex);
+  memset(queue, 0, sizeof(*queue));
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+// Begins an enqueue or dequeue operation. Segments reachable from the queue
+// when the operation begins will not be reused until it ends.
+static void iree_mpmc_segmented_queue_begin_operation(
+    iree_mpmc_segmented_queue_t* queue) {
+  iree_atomic_fetch_add_int32(&queue->active_count, 1,
+                              iree_memory_order_seq_cst);
+}
+
+// Ends an operation started with iree_mpmc_segmented_queue_begin_operation.
+// If this was the last operation in progress then all retired segments are
+// reclaimed.
+static void iree_mpmc_segmented_queue_end_operation(
+    iree_mpmc_segmented_queue_t* queue) {
+  if (iree_atomic_fetch_sub_int32(&queue->active_count, 1,
+                                  iree_memory_order_seq_cst) != 1 ||
+      iree_atomic_load_int32(&queue->retired_count,
+                             iree_memory_order_relaxed) == 0) {
+    return;
+  }
+
+  // Segments are only retired while an operation is in progress and retired
+  // segments are unreachable from the queue. If no operations are in progress
+  // while we hold the lock then nothing can still reference the segments that
+  // were retired prior to now.
+  iree_mpmc_segmented_queue_segment_t* reclaim_list = NULL;
+  iree_slim_mutex_lock(&queue->mutex);
+  if (iree_atomic_load_int32(&queue->active_count,
+                             iree_memory_order_seq_cst) == 0) {
+    reclaim_list = queue->retired_list;
+    queue->retired_list = NULL;
+    iree_atomic_store_int32(&queue->retired_count, 0,
+                            iree_memory_order_relaxed);
+    if (reclaim_list && !queue->free_segment) {
+      queue->free_segment = reclaim_list;
+      reclaim_list = reclaim_list->next_retired;
+    }
+  }
+  iree_slim_mutex_unlock(&queue->mutex);
+
+  while (reclaim_list) {
+    iree_mpmc_segmented_queue_segment_t* segment = reclaim_list;
+    reclaim_list = segment->next_retired;
+    iree_mpmc_segmented_queue_free_segment(queue, segment);
+  }
+}
+
+// Appends a new segment after |full_segment| if it is still the tail.
+static iree_status_t iree_mpmc_segmented_queue_grow(
+    iree_mpmc_segmented_queue_t* queue,
+    iree_mpmc_segmented_queue_segment_t* full_segment) {
+  iree_status_t status = iree_ok_status();
+  iree_slim_mutex_lock(&queue->mutex);
+  if ((iree_mpmc_segmented_queue_segment_t*)iree_atomic_load_intptr(
+          &queue->tail_segment, iree_memory_order_acquire) == full_segment) {
+    iree_mpmc_segmented_queue_segment_t* new_segment = queue->free_segment;
+    if (new_segment) {
+      queue->free_segment = NULL;
+      iree_mpmc_queue_initialize(queue->segment_capacity,
+                                 new_segment->ring.cells, &new_segment->ring);
+    } else {
+      status = iree_mpmc_segmented_queue_allocate_segment(queue, &new_segment);
+    }
+    if (iree_status_is_ok(status)) {
+      iree_atomic_store_intptr(&new_segment->next, 0,
+                               iree_memory_order_relaxed);
+      new_segment->next_retired = NULL;
+      // Seal the full segment before linking the new one: once consumers
+      // observe the next segment they can retire this one as soon as all of
+      // the values that made it in are dequeued.
+      iree_mpmc_queue_seal(&full_segment->ring);
+      iree_atomic_store_intptr(&full_segment->next, (intptr_t)new_segment,
+                               iree_memory_order_release);
+      iree_atomic_store_intptr(&queue->tail_segment, (intptr_t)new_segment,
+                               iree_memory_order_release);
+    }
+  }
+  iree_slim_mutex_unlock(&queue->mutex);
+  return status;
+}
+
+iree_status_t iree_mpmc_segmented_queue_enqueue(
+    iree_mpmc_segmented_queue_t* queue, void* value) {
+  IREE_ASSERT_ARGUMENT(queue);
+  iree_mpmc_segmented_queue_begin_operation(queue);
+  iree_status_t status = iree_ok_status();
+  while (true) {
+    iree_mpmc_segmented_queue_segment_t* segment =
+        (iree_mpmc_segmented_queue_segment_t*)iree_atomic_load_intptr(
+            &queue->tail_segment, iree_memory_order_acquire);
+    if (iree_mpmc_queue_try_enqueue(&segment->ring, value)) break;
+    status = iree_mpmc_segmented_queue_grow(queue, segment);
+    if (!iree_status_is_ok(status)) break;
+  }
+  iree_mpmc_segmented_queue_end_operation(queue);
+  return status;
+}
+
+bool iree_mpmc_segmented_queue_try_dequeue(iree_mpmc_segmented_queue_t* queue,
+                                           void** out_value) {
+  IREE_ASSERT_ARGUMENT(queue);
+  IREE_ASSERT_ARGUMENT(out_value);
+  iree_mpmc_segmented_queue_begin_operation(queue);
+  bool did_dequeue = false;
+  while (true) {
+    iree_mpmc_segmented_queue_segment_t* segment =
+        (iree_mpmc_segmented_queue_segment_t*)iree_atomic_load_intptr(
+            &queue->head_segment, iree_memory_order_acquire);
+    if (iree_mpmc_queue_try_dequeue(&segment->ring, out_value)) {
+      did_dequeue = true;
+      break;
+    }
+    iree_mpmc_segmented_queue_segment_t* next_segment =
+        (iree_mpmc_segmented_queue_segment_t*)iree_atomic_load_intptr(
+            &segment->next, iree_memory_order_acquire);
+    if (!next_segment || !iree_mpmc_queue_is_drained(&segment->ring)) {
+      // Empty or the value at the front is still being enqueued.
+      break;
+    }
+
+    // The head segment is sealed and drained; advance to the next one. Only
+    // one consumer wins the exchange and retires the segment.
+    intptr_t expected_segment = (intptr_t)segment;
+    if (iree_atomic_compare_exchange_strong_intptr(
+            &queue->head_segment, &expected_segment, (intptr_t)next_segment,
+            iree_memory_order_acq_rel, iree_memory_order_acquire)) {
+      iree_slim_mutex_lock(&queue->mutex);
+      segment->next_retired = queue->retired_list;
+      queue->retired_list = segment;
+      iree_atomic_fetch_add_int32(&queue->retired_count, 1,
+                                  iree_memory_order_relaxed);
+      iree_slim_mutex_unlock(&queue->mutex);
+    }
+  }
+  iree_mpmc_segmented_queue_end_operation(queue);
+  return did_dequeue;
+}
@@ -0,0 +1,148 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_BASE_INTERNAL_MPMC_QUEUE_H_
+#define IREE_BASE_INTERNAL_MPMC_QUEUE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "iree/base/api.h"
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/synchronization.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+//==============================================================================
+// iree_mpmc_queue_t
+//==============================================================================
+
+typedef struct iree_mpmc_queue_cell_t {
+  // Sequence number of the cell used to determine whether it is available for
+  // an enqueue (== enqueue position) or a dequeue (== dequeue position + 1).
+  iree_atomic_int64_t sequence;
+  void* value;
+} iree_mpmc_queue_cell_t;
+
+// Bounded lock-free multi-producer/multi-consumer FIFO queue of pointers.
+// This is the ring buffer described by Dmitry Vyukov:
+// https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+//
+// Each enqueue and dequeue costs a single CAS on the respective position and
+// producers and consumers do not contend with each other unless the queue is
+// nearly empty or full. Values are dequeued in the order their enqueues
+// claimed positions in the queue.
+//
+// Dequeues may fail while an enqueue of the next value is in flight (the
+// producer has claimed the position but not yet stored the value); the queue
+// is linearizable only for enqueues/dequeues that have completed.
+//
+// Thread-safe; any number of threads may enqueue and dequeue concurrently.
+typedef struct iree_mpmc_queue_t {
+  iree_mpmc_queue_cell_t* cells;
+  int64_t capacity_mask;
+  // Positions live on their own cache lines so that producers and consumers
+  // don't false-share.
+  uint8_t reserved0[iree_hardware_destructive_interference_size -
+                    sizeof(void*) - sizeof(int64_t)];
+  iree_atomic_int64_t enqueue_position;
+  uint8_t reserved1[iree_hardware_destructive_interference_size -
+                    sizeof(iree_atomic_int64_t)];
+  iree_atomic_int64_t dequeue_position;
+  uint8_t reserved2[iree_hardware_destructive_interference_size -
+                    sizeof(iree_atomic_int64_t)];
+} iree_mpmc_queue_t;
+
+// Returns the size in bytes of the storage required by a queue with the given
+// |capacity|.
+iree_host_size_t iree_mpmc_queue_storage_size(iree_host_size_t capacity);
+
+// Initializes |out_queue| to an empty queue with |capacity| using |storage|
+// of at least iree_mpmc_queue_storage_size bytes. |capacity| must be a power
+// of two >= 2. The storage must remain valid until the queue is deinitialized.
+void iree_mpmc_queue_initialize(iree_host_size_t capacity, void* storage,
+                                iree_mpmc_queue_t* out_queue);
+
+// Deinitializes |queue|. Any values remaining in the queue are dropped.
+void iree_mpmc_queue_deinitialize(iree_mpmc_queue_t* queue);
+
+// Enqueues |value| at the back of the queue.
+// Returns false if the queue is full.
+bool iree_mpmc_queue_try_enqueue(iree_mpmc_queue_t* queue, void* value);
+
+// Dequeues the value at the front of the queue into |out_value|.
+// Returns false if the queue is empty.
+bool iree_mpmc_queue_try_dequeue(iree_mpmc_queue_t* queue, void** out_value);
+
+//==============================================================================
+// iree_mpmc_segmented_queue_t
+//==============================================================================
+
+typedef struct iree_mpmc_segmented_queue_segment_t
+    iree_mpmc_segmented_queue_segment_t;
+
+// Unbounded multi-producer/multi-consumer FIFO queue of pointers.
+// Values are stored in a linked list of bounded iree_mpmc_queue_t segments.
+// Enqueues and dequeues are lock-free while the current segments have capacity
+// and only adding a new segment when the tail segment fills takes a lock.
+//
+// Drained segments are retired and only reused (or freed) once no enqueue or
+// dequeue is in progress so that threads racing on a segment never observe it
+// being recycled. Under constant contention retired segments accumulate until
+// the queue is idle for a moment.
+//
+// Thread-safe; any number of threads may enqueue and dequeue concurrently.
+typedef struct iree_mpmc_segmented_queue_t {
+  iree_allocator_t host_allocator;
+  // Capacity of each segment.
+  iree_host_size_t segment_capacity;
+  // Segment consumers dequeue from.
+  iree_atomic_intptr_t head_segment;
+  // Segment producers enqueue into.
+  iree_atomic_intptr_t tail_segment;
+  // Number of enqueues and dequeues in progress.
+  iree_atomic_int32_t active_count;
+  // Number of segments in |retired_list|; used to avoid taking the lock when
+  // there is nothing to reclaim.
+  iree_atomic_int32_t retired_count;
+  // Guards adding segments and the retired and free lists.
+  iree_slim_mutex_t mutex;
+  // Drained segments that may still be referenced by in-progress operations.
+  iree_mpmc_segmented_queue_segment_t* retired_list;
+  // A drained segment that can be reused when adding a segment.
+  iree_mpmc_segmented_queue_segment_t* free_segment;
+} iree_mpmc_segmented_queue_t;
+
+// Initializes |out_queue| to an empty queue that allocates segments of
+// |segment_capacity| values from |host_allocator|. |segment_capacity| must be
+// a power of two >= 2. The queue must be deinitialized with
+// iree_mpmc_segmented_queue_deinitialize even if initialization fails.
+iree_status_t iree_mpmc_segmented_queue_initialize(
+    iree_host_size_t segment_capacity, iree_allocator_t host_allocator,
+    iree_mpmc_segmented_queue_t* out_queue);
+
+// Deinitializes |queue| and frees all segments. No operations may be in
+// progress and any values remaining in the queue are dropped.
+void iree_mpmc_segmented_queue_deinitialize(iree_mpmc_segmented_queue_t* queue);
+
+// Enqueues |value| at the back of the queue.
+// Fails only if a new segment was required and could not be allocated.
+iree_status_t iree_mpmc_segmented_queue_enqueue(
+    iree_mpmc_segmented_queue_t* queue, void* value);
+
+// Dequeues the value at the front of the queue into |out_value|.
+// Returns false if the queue is empty.
+bool iree_mpmc_segmented_queue_try_dequeue(iree_mpmc_segmented_queue_t* queue,
+                                           void** out_value);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_BASE_INTERNAL_MPMC_QUEUE_H_
@@ -0,0 +1,78 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <cstdint>
+
+#include "benchmark/benchmark.h"
+#include "iree/base/internal/mpmc_queue.h"
+
+namespace {
+
+//==============================================================================
+// iree_mpmc_queue_t
+//==============================================================================
+
+// Each thread alternates an enqueue and a dequeue on a shared bounded queue.
+void BM_BoundedEnqueueDequeue(benchmark::State& state) {
+  static iree_mpmc_queue_t* queue = ([]() -> iree_mpmc_queue_t* {
+    auto* queue = new iree_mpmc_queue_t();
+    iree_mpmc_queue_initialize(
+        1024, new uint8_t[iree_mpmc_queue_storage_size(1024)], queue);
+    return queue;
+  })();
+  uintptr_t value = 1;
+  for (auto _ : state) {
+    iree_mpmc_queue_try_enqueue(queue, (void*)value++);
+    void* out_value = NULL;
+    iree_mpmc_queue_try_dequeue(queue, &out_value);
+    benchmark::DoNotOptimize(out_value);
+  }
+}
+BENCHMARK(BM_BoundedEnqueueDequeue)
+    ->UseRealTime()
+    ->Threads(1)
+    ->Threads(4)
+    ->Threads(16)
+    ->ThreadPerCpu();
+
+//==============================================================================
+// iree_mpmc_segmented_queue_t
+//==============================================================================
+
+// Each thread enqueues a burst of values (forcing segments to be added) and
+// then dequeues the same number on a shared segmented queue.
+void BM_SegmentedEnqueueDequeue(benchmark::State& state) {
+  static iree_mpmc_segmented_queue_t* queue =
+      ([]() -> iree_mpmc_segmented_queue_t* {
+        auto* queue = new iree_mpmc_segmented_queue_t();
+        IREE_CHECK_OK(iree_mpmc_segmented_queue_initialize(
+            256, iree_allocator_system(), queue));
+        return queue;
+      })();
+  const int64_t burst_size = state.range(0);
+  for (auto _ : state) {
+    for (int64_t i = 0; i < burst_size; ++i) {
+      IREE_CHECK_OK(
+          iree_mpmc_segmented_queue_enqueue(queue, (void*)(uintptr_t)(i + 1)));
+    }
+    for (int64_t i = 0; i < burst_size; ++i) {
+      void* out_value = NULL;
+      iree_mpmc_segmented_queue_try_dequeue(queue, &out_value);
+      benchmark::DoNotOptimize(out_value);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * burst_size);
+}
+BENCHMARK(BM_SegmentedEnqueueDequeue)
+    ->UseRealTime()
+    ->Arg(16)
+    ->Arg(1024)
+    ->Threads(1)
+    ->Threads(4)
+    ->Threads(16)
+    ->ThreadPerCpu();
+
+}  // namespace
@@ -0,0 +1,160 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/base/internal/mpmc_queue.h"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace {
+
+static void* ToValue(uintptr_t value) { return (void*)value; }
+static uintptr_t FromValue(void* value) { return (uintptr_t)value; }
+
+//==============================================================================
+// iree_mpmc_queue_t
+//==============================================================================
+
+TEST(MPMCQueueTest, Lifetime) {
+  std::vector<uint8_t> storage(iree_mpmc_queue_storage_size(4));
+  iree_mpmc_queue_t queue;
+  iree_mpmc_queue_initialize(4, storage.data(), &queue);
+  void* value = NULL;
+  EXPECT_FALSE(iree_mpmc_queue_try_dequeue(&queue, &value));
+  iree_mpmc_queue_deinitialize(&queue);
+}
+
+// Fills and drains the queue a few laps around the ring to ensure FIFO order
+// and that full/empty are reported.
+TEST(MPMCQueueTest, FIFOOrder) {
+  std::vector<uint8_t> storage(iree_mpmc_queue_storage_size(4));
+  iree_mpmc_queue_t queue;
+  iree_mpmc_queue_initialize(4, storage.data(), &queue);
+  uintptr_t next_value = 1;
+  uintptr_t expected_value = 1;
+  for (int lap = 0; lap < 3; ++lap) {
+    for (int i = 0; i < 4; ++i) {
+      EXPECT_TRUE(iree_mpmc_queue_try_enqueue(&queue, ToValue(next_value++)));
+    }
+    EXPECT_FALSE(iree_mpmc_queue_try_enqueue(&queue, ToValue(next_value)));
+    for (int i = 0; i < 4; ++i) {
+      void* value = NULL;
+      EXPECT_TRUE(iree_mpmc_queue_try_dequeue(&queue, &value));
+      EXPECT_EQ(expected_value++, FromValue(value));
+    }
+    void* value = NULL;
+    EXPECT_FALSE(iree_mpmc_queue_try_dequeue(&queue, &value));
+  }
+  iree_mpmc_queue_deinitialize(&queue);
+}
+
+//==============================================================================
+// iree_mpmc_segmented_queue_t
+//==============================================================================
+
+TEST(MPMCSegmentedQueueTest, Lifetime) {
+  iree_mpmc_segmented_queue_t queue;
+  IREE_ASSERT_OK(iree_mpmc_segmented_queue_initialize(
+      4, iree_allocator_system(), &queue));
+  void* value = NULL;
+  EXPECT_FALSE(iree_mpmc_segmented_queue_try_dequeue(&queue, &value));
+  iree_mpmc_segmented_queue_deinitialize(&queue);
+}
+
+// Enqueues enough values to require several segments and ensures they are
+// dequeued in order.
+TEST(MPMCSegmentedQueueTest, FIFOOrderAcrossSegments) {
+  iree_mpmc_segmented_queue_t queue;
+  IREE_ASSERT_OK(iree_mpmc_segmented_queue_initialize(
+      4, iree_allocator_system(), &queue));
+  for (int round = 0; round < 3; ++round) {
+    for (uintptr_t i = 1; i <= 37; ++i) {
+      IREE_ASSERT_OK(iree_mpmc_segmented_queue_enqueue(&queue, ToValue(i)));
+    }
+    for (uintptr_t i = 1; i <= 37; ++i) {
+      void* value = NULL;
+      ASSERT_TRUE(iree_mpmc_segmented_queue_try_dequeue(&queue, &value));
+      EXPECT_EQ(i, FromValue(value));
+    }
+    void* value = NULL;
+    EXPECT_FALSE(iree_mpmc_segmented_queue_try_dequeue(&queue, &value));
+  }
+  iree_mpmc_segmented_queue_deinitialize(&queue);
+}
+
+// Deinitializing with values remaining must free all segments.
+TEST(MPMCSegmentedQueueTest, DeinitializeNonEmpty) {
+  iree_mpmc_segmented_queue_t queue;
+  IREE_ASSERT_OK(iree_mpmc_segmented_queue_initialize(
+      2, iree_allocator_system(), &queue));
+  for (uintptr_t i = 1; i <= 9; ++i) {
+    IREE_ASSERT_OK(iree_mpmc_segmented_queue_enqueue(&queue, ToValue(i)));
+  }
+  void* value = NULL;
+  ASSERT_TRUE(iree_mpmc_segmented_queue_try_dequeue(&queue, &value));
+  iree_mpmc_segmented_queue_deinitialize(&queue);
+}
+
+// Producers enqueue increasing values tagged with their index while consumers
+// dequeue concurrently. Every value must be dequeued exactly once and values
+// from any single producer must be observed in order by each consumer.
+TEST(MPMCSegmentedQueueTest, ConcurrentProducersConsumers) {
+  static constexpr int kProducerCount = 4;
+  static constexpr int kConsumerCount = 4;
+  static constexpr uintptr_t kValuesPerProducer = 20000;
+  iree_mpmc_segmented_queue_t queue;
+  IREE_ASSERT_OK(iree_mpmc_segmented_queue_initialize(
+      8, iree_allocator_system(), &queue));
+
+  std::atomic<int> remaining_count{kProducerCount * kValuesPerProducer};
+  std::vector<std::atomic<int>> seen_counts(kProducerCount *
+                                            kValuesPerProducer);
+  std::atomic<bool> out_of_order{false};
+  std::vector<std::thread> threads;
+  for (int p = 0; p < kProducerCount; ++p) {
+    threads.emplace_back([&, p]() {
+      for (uintptr_t i = 0; i < kValuesPerProducer; ++i) {
+        uintptr_t value = (uintptr_t)p * kValuesPerProducer + i + 1;
+        IREE_ASSERT_OK(
+            iree_mpmc_segmented_queue_enqueue(&queue, ToValue(value)));
+      }
+    });
+  }
+  for (int c = 0; c < kConsumerCount; ++c) {
+    threads.emplace_back([&]() {
+      uintptr_t last_values[kProducerCount] = {0};
+      while (remaining_count.load() > 0) {
+        void* value = NULL;
+        if (!iree_mpmc_segmented_queue_try_dequeue(&queue, &value)) {
+          std::this_thread::yield();
+          continue;
+        }
+        uintptr_t index = FromValue(value) - 1;
+        int producer = (int)(index / kValuesPerProducer);
+        if (FromValue(value) <= last_values[producer]) out_of_order = true;
+        last_values[producer] = FromValue(value);
+        seen_counts[index].fetch_add(1);
+        remaining_count.fetch_sub(1);
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+
+  EXPECT_FALSE(out_of_order.load());
+  for (auto& seen_count : seen_counts) {
+    ASSERT_EQ(1, seen_count.load());
+  }
+  void* value = NULL;
+  EXPECT_FALSE(iree_mpmc_segmented_queue_try_dequeue(&queue, &value));
+  iree_mpmc_segmented_queue_deinitialize(&queue);
+}
+
+}  // namespace
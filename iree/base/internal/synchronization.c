@@ -9,6 +9,12 @@
 #include <assert.h>
 #include <string.h>
 
+#if defined(IREE_ARCH_X86_32) || defined(IREE_ARCH_X86_64)
+#include <xmmintrin.h>
+#elif defined(IREE_COMPILER_MSVC)
+#include <intrin.h>
+#endif  // IREE_ARCH_X86_*
+
 #if IREE_SYNCHRONIZATION_DISABLE_UNSAFE
 
 // Disabled.
@@ -574,27 +580,64 @@ void iree_notification_deinitialize(iree_notification_t* notification) {
 #endif  // IREE_PLATFORM_HAS_FUTEX
 }
 
+// Wakes up to |count| waiters of |notification| after its epoch has been
+// advanced by a post.
+static void iree_notification_wake_waiters(iree_notification_t* notification,
+                                           int32_t count) {
+#if IREE_SYNCHRONIZATION_DISABLE_UNSAFE
+  // No-op.
+#elif defined(IREE_PLATFORM_HAS_FUTEX)
+  iree_futex_wake(iree_notification_epoch_address(notification), count);
+#else
+  pthread_mutex_lock(&notification->mutex);
+  if (count == IREE_ALL_WAITERS) {
+    pthread_cond_broadcast(&notification->cond);
+  } else {
+    for (int32_t i = 0; i < count; ++i) {
+      pthread_cond_signal(&notification->cond);
+    }
+  }
+  pthread_mutex_unlock(&notification->mutex);
+#endif  // IREE_PLATFORM_HAS_FUTEX
+}
+
 void iree_notification_post(iree_notification_t* notification, int32_t count) {
   uint64_t previous_value = iree_atomic_fetch_add_int64(
       &notification->value, IREE_NOTIFICATION_EPOCH_INC,
       iree_memory_order_acq_rel);
   // Ensure we have at least one waiter; wake up to |count| of them.
   if (IREE_UNLIKELY(previous_value & IREE_NOTIFICATION_WAITER_MASK)) {
-#if IREE_SYNCHRONIZATION_DISABLE_UNSAFE
-    // No-op.
-#elif defined(IREE_PLATFORM_HAS_FUTEX)
-    iree_futex_wake(iree_notification_epoch_address(notification), count);
-#else
-    pthread_mutex_lock(&notification->mutex);
-    if (count == IREE_ALL_WAITERS) {
-      pthread_cond_broadcast(&notification->cond);
-    } else {
-      for (int32_t i = 0; i < count; ++i) {
-        pthread_cond_signal(&notification->cond);
+    iree_notification_wake_waiters(notification, count);
+  }
+}
+
+void iree_notification_post_many(iree_notification_t* const* notifications,
+                                 iree_host_size_t notification_count,
+                                 int32_t count) {
+  // Notifications are processed in groups so that we can track which ones
+  // have waiters in a bitmask on the stack.
+  for (iree_host_size_t base = 0; base < notification_count; base += 64) {
+    iree_host_size_t group_count = iree_min(notification_count - base, 64);
+
+    // Advance all epochs first: spinning waiters and those that have not yet
+    // committed their wait observe the post immediately instead of after the
+    // wake syscalls of the waiters preceding them.
+    uint64_t waiting_mask = 0;
+    for (iree_host_size_t i = 0; i < group_count; ++i) {
+      uint64_t previous_value = iree_atomic_fetch_add_int64(
+          &notifications[base + i]->value, IREE_NOTIFICATION_EPOCH_INC,
+          iree_memory_order_acq_rel);
+      if (previous_value & IREE_NOTIFICATION_WAITER_MASK) {
+        waiting_mask |= 1ull << i;
+      }
+    }
+
+    // Wake only the notifications that had waiters in the kernel.
+    for (iree_host_size_t i = 0; waiting_mask; ++i, waiting_mask >>= 1) {
+      if (waiting_mask & 1) {
+        iree_notification_wake_waiters(notifications[base + i], count);
       }
     }
-    pthread_mutex_unlock(&notification->mutex);
-#endif  // IREE_PLATFORM_HAS_FUTEX
   }
 }
 
@@ -651,6 +694,40 @@ bool iree_notification_commit_wait(iree_notification_t* notification,
   return result;
 }
 
+// Hints to the processor that we are in a spin-wait loop.
+static inline void iree_notification_spin_pause(void) {
+#if defined(IREE_ARCH_X86_32) || defined(IREE_ARCH_X86_64)
+  _mm_pause();
+#elif (defined(IREE_ARCH_ARM_32) || defined(IREE_ARCH_ARM_64)) && \
+    defined(IREE_COMPILER_MSVC)
+  __yield();
+#elif defined(IREE_ARCH_ARM_32) || defined(IREE_ARCH_ARM_64)
+  __asm__ __volatile__("yield");
+#endif  // IREE_ARCH_*
+}
+
+// Number of spin iterations between deadline checks in
+// iree_notification_spin_wait. Querying the time is much more expensive than
+// checking the epoch so we amortize it over a batch of pauses.
+#define IREE_NOTIFICATION_SPIN_ITERATIONS_PER_TIME_CHECK 64
+
+bool iree_notification_spin_wait(iree_notification_t* notification,
+                                 iree_wait_token_t wait_token,
+                                 iree_time_t spin_deadline_ns) {
+  do {
+    for (int i = 0; i < IREE_NOTIFICATION_SPIN_ITERATIONS_PER_TIME_CHECK;
+         ++i) {
+      if ((iree_atomic_load_int64(&notification->value,
+                                  iree_memory_order_acquire) >>
+           IREE_NOTIFICATION_EPOCH_SHIFT) != wait_token) {
+        return true;
+      }
+      iree_notification_spin_pause();
+    }
+  } while (iree_time_now() < spin_deadline_ns);
+  return false;
+}
+
 void iree_notification_cancel_wait(iree_notification_t* notification) {
   // TODO(benvanik): benchmark under real workloads.
   // iree_memory_order_relaxed would suffice for correctness but the faster
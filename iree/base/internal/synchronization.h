@@ -328,6 +328,22 @@ void iree_notification_deinitialize(iree_notification_t* notification);
 //   variable become visible in other threads that consume the same atomic.
 void iree_notification_post(iree_notification_t* notification, int32_t count);
 
+// Posts to each of the |notification_count| |notifications| as if by
+// iree_notification_post with |count|.
+//
+// All notifications are posted before any waiters are woken such that waiters
+// that are spinning or about to commit their wait observe the post without
+// waiting for the wakes of the preceding notifications. Only notifications with
+// waiters blocked in the kernel incur a wake syscall. There is no OS primitive
+// for waking waiters on distinct addresses in one syscall (futex_waitv and
+// WaitOnAddress only batch waits) and the wakes are issued back-to-back.
+//
+// Has the same memory ordering guarantees as iree_notification_post for each
+// notification.
+void iree_notification_post_many(iree_notification_t* const* notifications,
+                                 iree_host_size_t notification_count,
+                                 int32_t count);
+
 typedef uint32_t iree_wait_token_t;  // opaque
 
 // Prepares for a wait operation, returning a token that must be passed to
@@ -357,6 +373,20 @@ bool iree_notification_commit_wait(iree_notification_t* notification,
                                    iree_wait_token_t wait_token,
                                    iree_time_t deadline_ns);
 
+// Spins until a notification has been posted since |wait_token| was returned
+// from iree_notification_prepare_wait or |spin_deadline_ns| is reached.
+// Returns true if a notification was posted. This never blocks in the kernel
+// and the pending wait must still be either committed or cancelled.
+//
+// Use this prior to iree_notification_commit_wait when notifications are
+// expected to arrive shortly in order to avoid the latency of a sleep/wake.
+// Spinning burns the core and should only be done for short durations.
+//
+// Acts as (at least) a memory_order_acquire barrier when returning true.
+bool iree_notification_spin_wait(iree_notification_t* notification,
+                                 iree_wait_token_t wait_token,
+                                 iree_time_t spin_deadline_ns);
+
 // Cancels a pending wait operation without blocking.
 //
 // Acts as (at least) a memory_order_relaxed barrier:
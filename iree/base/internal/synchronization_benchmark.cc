@@ -4,8 +4,12 @@
 // See https://llvm.org/LICENSE.txt for license information.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+#include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <mutex>
+#include <thread>
+#include <vector>
 
 #include "benchmark/benchmark.h"
 #include "iree/base/internal/synchronization.h"
@@ -249,8 +253,92 @@ BENCHMARK_TEMPLATE(BM_Contended, std::mutex)
 // iree_notification_t
 //==============================================================================
 
-// TODO(benvanik): benchmark this; it should in the worst case be as bad as
-// mutex/futex (as that's what is used), but at the moment we don't really
-// care beyond that.
+// Measures the time from a post until the last of N waiters (each waiting on
+// its own notification as task workers do) has woken: the wake latency tail.
+// |kBatched| posts to all notifications with iree_notification_post_many
+// instead of one iree_notification_post per waiter.
+template <bool kBatched>
+void BM_NotificationWakeAll(benchmark::State& state) {
+  const int waiter_count = static_cast<int>(state.range(0));
+  std::vector<iree_notification_t> notifications(waiter_count);
+  std::vector<iree_notification_t*> notification_ptrs(waiter_count);
+  for (int i = 0; i < waiter_count; ++i) {
+    iree_notification_initialize(&notifications[i]);
+    notification_ptrs[i] = &notifications[i];
+  }
+
+  std::atomic<int> generation{0};
+  std::atomic<int> waiting_count{0};
+  std::atomic<int> woken_count{0};
+  std::atomic<bool> exit{false};
+  std::vector<std::thread> threads;
+  for (int i = 0; i < waiter_count; ++i) {
+    threads.emplace_back([&, i]() {
+      int last_generation = 0;
+      bool is_counted = false;
+      while (true) {
+        iree_wait_token_t wait_token =
+            iree_notification_prepare_wait(&notifications[i]);
+        if (exit.load() || generation.load() != last_generation) {
+          iree_notification_cancel_wait(&notifications[i]);
+        } else {
+          // Only count once per generation in case of spurious wakes.
+          if (!is_counted) waiting_count.fetch_add(1);
+          is_counted = true;
+          iree_notification_commit_wait(&notifications[i], wait_token,
+                                        IREE_TIME_INFINITE_FUTURE);
+        }
+        if (exit.load()) break;
+        int current_generation = generation.load();
+        if (current_generation != last_generation) {
+          last_generation = current_generation;
+          is_counted = false;
+          woken_count.fetch_add(1);
+        }
+      }
+    });
+  }
+
+  for (auto _ : state) {
+    // Wait for all waiters to block.
+    while (waiting_count.load() < waiter_count) std::this_thread::yield();
+    waiting_count.store(0);
+    woken_count.store(0);
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+    generation.fetch_add(1);
+    if (kBatched) {
+      iree_notification_post_many(notification_ptrs.data(), waiter_count, 1);
+    } else {
+      for (int i = 0; i < waiter_count; ++i) {
+        iree_notification_post(&notifications[i], 1);
+      }
+    }
+    while (woken_count.load() < waiter_count) {
+    }
+    auto end_time = std::chrono::high_resolution_clock::now();
+    state.SetIterationTime(
+        std::chrono::duration<double>(end_time - start_time).count());
+  }
+
+  exit.store(true);
+  iree_notification_post_many(notification_ptrs.data(), waiter_count,
+                              IREE_ALL_WAITERS);
+  for (auto& thread : threads) thread.join();
+  for (auto& notification : notifications) {
+    iree_notification_deinitialize(&notification);
+  }
+}
+
+BENCHMARK_TEMPLATE(BM_NotificationWakeAll, false)
+    ->UseManualTime()
+    ->Arg(8)
+    ->Arg(32)
+    ->Arg(64);
+BENCHMARK_TEMPLATE(BM_NotificationWakeAll, true)
+    ->UseManualTime()
+    ->Arg(8)
+    ->Arg(32)
+    ->Arg(64);
 
 }  // namespace
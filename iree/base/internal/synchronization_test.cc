@@ -6,6 +6,7 @@
 
 #include "iree/base/internal/synchronization.h"
 
+#include <chrono>
 #include <thread>
 
 #include "iree/testing/gtest.h"
@@ -215,4 +216,45 @@ TEST(NotificationTest, Timeout) {
   iree_notification_deinitialize(&notification);
 }
 
+TEST(NotificationTest, SpinWaitTimeout) {
+  iree_notification_t notification;
+  iree_notification_initialize(&notification);
+
+  iree_time_t start_ns = iree_time_now();
+  iree_wait_token_t wait_token = iree_notification_prepare_wait(&notification);
+  EXPECT_FALSE(iree_notification_spin_wait(&notification, wait_token,
+                                           start_ns + 10 * 1000000));
+  iree_notification_cancel_wait(&notification);
+
+  iree_duration_t delta_ns = iree_time_now() - start_ns;
+  EXPECT_GE(delta_ns, 10 * 1000000);
+
+  iree_notification_deinitialize(&notification);
+}
+
+TEST(NotificationTest, SpinWaitPosted) {
+  iree_notification_t notification;
+  iree_notification_initialize(&notification);
+
+  // Posts made after preparing the wait must be observed.
+  iree_wait_token_t wait_token = iree_notification_prepare_wait(&notification);
+  iree_notification_post(&notification, IREE_ALL_WAITERS);
+  EXPECT_TRUE(iree_notification_spin_wait(&notification, wait_token,
+                                          IREE_TIME_INFINITE_FUTURE));
+  iree_notification_cancel_wait(&notification);
+
+  // Posts from another thread while spinning must be observed.
+  wait_token = iree_notification_prepare_wait(&notification);
+  std::thread post_thread([&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    iree_notification_post(&notification, IREE_ALL_WAITERS);
+  });
+  EXPECT_TRUE(iree_notification_spin_wait(&notification, wait_token,
+                                          IREE_TIME_INFINITE_FUTURE));
+  iree_notification_cancel_wait(&notification);
+  post_thread.join();
+
+  iree_notification_deinitialize(&notification);
+}
+
 }  // namespace
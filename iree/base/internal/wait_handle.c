@@ -8,6 +8,8 @@
 
 #include <string.h>
 
+#include "iree/base/tracing.h"
+
 //===----------------------------------------------------------------------===//
 // iree_wait_handle_t
 //===----------------------------------------------------------------------===//
@@ -91,6 +93,220 @@ IREE_API_EXPORT iree_status_t iree_wait_source_import(
   return iree_ok_status();
 }
 
+//===----------------------------------------------------------------------===//
+// iree_wait_source_wait_all/any
+//===----------------------------------------------------------------------===//
+
+// Interval at which wait sources that cannot be exported to system wait
+// primitives are polled by iree_wait_source_wait_any.
+#define IREE_WAIT_SOURCE_POLL_INTERVAL_NS (1000000ll)
+
+// Exports |wait_source| to a system wait primitive and inserts it into |set|.
+// |out_primitive| is set to immediate if the source is unavailable for export
+// (delays, user-defined sources, etc) or has already resolved.
+static iree_status_t iree_wait_set_insert_source(
+    iree_wait_set_t* set, iree_wait_source_t wait_source,
+    iree_timeout_t timeout, iree_wait_primitive_t* out_primitive) {
+  *out_primitive = iree_wait_primitive_immediate();
+  if (iree_wait_source_is_immediate(wait_source) ||
+      iree_wait_source_is_delay(wait_source)) {
+    return iree_ok_status();
+  }
+  iree_status_t status = iree_wait_source_export(
+      wait_source, IREE_WAIT_PRIMITIVE_TYPE_ANY, timeout, out_primitive);
+  if (iree_status_is_unavailable(status) ||
+      iree_status_is_unimplemented(status)) {
+    *out_primitive = iree_wait_primitive_immediate();
+    return iree_status_ignore(status);
+  }
+  IREE_RETURN_IF_ERROR(status);
+  if (iree_wait_primitive_is_immediate(*out_primitive)) {
+    return iree_ok_status();
+  }
+  iree_wait_handle_t wait_handle;
+  IREE_RETURN_IF_ERROR(iree_wait_handle_wrap_primitive(
+      out_primitive->type, out_primitive->value, &wait_handle));
+  return iree_wait_set_insert(set, wait_handle);
+}
+
+IREE_API_EXPORT iree_status_t iree_wait_source_wait_all(
+    iree_host_size_t count, const iree_wait_source_t* wait_sources,
+    iree_timeout_t timeout) {
+  IREE_ASSERT_ARGUMENT(!count || wait_sources);
+  if (count == 0) return iree_ok_status();
+  if (count == 1) return iree_wait_source_wait_one(wait_sources[0], timeout);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_time_t deadline_ns = iree_timeout_as_deadline_ns(timeout);
+  iree_wait_set_t* set = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_wait_set_allocate(count, iree_allocator_system(), &set));
+
+  // Multiplex all exportable sources into a single system wait.
+  iree_status_t status = iree_ok_status();
+  bool any_exported = false;
+  for (iree_host_size_t i = 0; i < count && iree_status_is_ok(status); ++i) {
+    iree_wait_primitive_t primitive;
+    status = iree_wait_set_insert_source(set, wait_sources[i],
+                                         iree_make_deadline(deadline_ns),
+                                         &primitive);
+    any_exported |= !iree_wait_primitive_is_immediate(primitive);
+  }
+  if (iree_status_is_ok(status) && any_exported) {
+    status = iree_wait_all(set, deadline_ns);
+  }
+  iree_wait_set_free(set);
+
+  // Wait on each source individually. Exported sources have already resolved
+  // and only need to be checked for failures.
+  for (iree_host_size_t i = 0; i < count && iree_status_is_ok(status); ++i) {
+    status = iree_wait_source_wait_one(wait_sources[i],
+                                       iree_make_deadline(deadline_ns));
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+IREE_API_EXPORT iree_status_t iree_wait_source_wait_any(
+    iree_host_size_t count, const iree_wait_source_t* wait_sources,
+    iree_timeout_t timeout, iree_host_size_t* out_index) {
+  IREE_ASSERT_ARGUMENT(!count || wait_sources);
+  IREE_ASSERT_ARGUMENT(out_index);
+  *out_index = 0;
+  if (count == 0) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "at least one wait source is required");
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_time_t deadline_ns = iree_timeout_as_deadline_ns(timeout);
+
+  // Scan for sources that have already resolved so that we can avoid the
+  // system wait entirely.
+  for (iree_host_size_t i = 0; i < count; ++i) {
+    iree_status_code_t wait_status_code = IREE_STATUS_OK;
+    iree_status_t status =
+        iree_wait_source_query(wait_sources[i], &wait_status_code);
+    if (!iree_status_is_ok(status) ||
+        wait_status_code != IREE_STATUS_DEFERRED) {
+      *out_index = i;
+      IREE_TRACE_ZONE_END(z0);
+      return status;
+    }
+  }
+  if (deadline_ns == IREE_TIME_INFINITE_PAST) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+  }
+
+  iree_wait_set_t* set = NULL;
+  iree_wait_primitive_t* primitives = NULL;
+  iree_status_t status =
+      iree_wait_set_allocate(count, iree_allocator_system(), &set);
+  if (iree_status_is_ok(status)) {
+    status = iree_allocator_malloc(iree_allocator_system(),
+                                   count * sizeof(*primitives),
+                                   (void**)&primitives);
+  }
+  if (iree_status_is_ok(status)) {
+    memset(primitives, 0, count * sizeof(*primitives));
+  }
+
+  // Export what we can and track the earliest delay and whether any sources
+  // need to be polled.
+  iree_time_t delay_deadline_ns = IREE_TIME_INFINITE_FUTURE;
+  iree_host_size_t delay_index = 0;
+  bool any_exported = false;
+  bool any_polled = false;
+  for (iree_host_size_t i = 0; i < count && iree_status_is_ok(status); ++i) {
+    iree_wait_source_t wait_source = wait_sources[i];
+    if (iree_wait_source_is_delay(wait_source)) {
+      if ((iree_time_t)wait_source.data < delay_deadline_ns) {
+        delay_deadline_ns = (iree_time_t)wait_source.data;
+        delay_index = i;
+      }
+      primitives[i] = iree_wait_primitive_immediate();
+      continue;
+    }
+    status = iree_wait_set_insert_source(
+        set, wait_source, iree_make_deadline(deadline_ns), &primitives[i]);
+    if (iree_wait_primitive_is_immediate(primitives[i])) {
+      any_polled = true;
+    } else {
+      any_exported = true;
+    }
+  }
+
+  bool resolved = false;
+  while (iree_status_is_ok(status) && !resolved) {
+    iree_time_t now_ns = iree_time_now();
+    if (now_ns >= delay_deadline_ns) {
+      *out_index = delay_index;
+      break;
+    } else if (now_ns >= deadline_ns) {
+      status = iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+      break;
+    }
+
+    // Wake no later than the timeout, the earliest delay, or the next poll.
+    iree_time_t wait_deadline_ns = iree_min(deadline_ns, delay_deadline_ns);
+    if (any_polled) {
+      wait_deadline_ns = iree_min(wait_deadline_ns,
+                                  now_ns + IREE_WAIT_SOURCE_POLL_INTERVAL_NS);
+    }
+
+    if (any_exported) {
+      iree_wait_handle_t wake_handle;
+      memset(&wake_handle, 0, sizeof(wake_handle));
+      status = iree_wait_any(set, wait_deadline_ns, &wake_handle);
+      if (iree_status_is_ok(status)) {
+        for (iree_host_size_t i = 0; i < count; ++i) {
+          if (primitives[i].type == wake_handle.type &&
+              memcmp(&primitives[i].value, &wake_handle.value,
+                     sizeof(wake_handle.value)) == 0) {
+            *out_index = i;
+            resolved = true;
+            break;
+          }
+        }
+      } else if (iree_status_is_deadline_exceeded(status)) {
+        status = iree_status_ignore(status);
+      }
+    } else {
+      iree_wait_until(wait_deadline_ns);
+    }
+
+    for (iree_host_size_t i = 0;
+         i < count && iree_status_is_ok(status) && !resolved && any_polled;
+         ++i) {
+      if (!iree_wait_primitive_is_immediate(primitives[i]) ||
+          iree_wait_source_is_delay(wait_sources[i])) {
+        continue;
+      }
+      iree_status_code_t wait_status_code = IREE_STATUS_OK;
+      status = iree_wait_source_query(wait_sources[i], &wait_status_code);
+      if (!iree_status_is_ok(status) ||
+          wait_status_code != IREE_STATUS_DEFERRED) {
+        *out_index = i;
+        resolved = true;
+      }
+    }
+  }
+
+  iree_allocator_free(iree_allocator_system(), primitives);
+  if (set) iree_wait_set_free(set);
+
+  // Surface any failure of the resolved wait source.
+  if (iree_status_is_ok(status)) {
+    status = iree_wait_source_wait_one(wait_sources[*out_index],
+                                       iree_immediate_timeout());
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
 //===----------------------------------------------------------------------===//
 // iree_event_t
 //===----------------------------------------------------------------------===//
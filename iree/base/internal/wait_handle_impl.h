@@ -41,6 +41,10 @@
 #define IREE_WAIT_API_PPOLL 4
 #define IREE_WAIT_API_EPOLL 5
 #define IREE_WAIT_API_KQUEUE 6
+// Linux io_uring (wait_handle_io_uring.c). Not selected by default as it
+// requires Linux 5.4+ and io_uring is commonly disabled in containers; opt-in
+// with -DIREE_WAIT_API=IREE_WAIT_API_IO_URING.
+#define IREE_WAIT_API_IO_URING 7
 
 // We allow overriding the wait API via command line flags. If unspecified we
 // try to guess based on the target platform.
@@ -73,7 +77,8 @@
 #if (IREE_WAIT_API == IREE_WAIT_API_POLL) ||  \
     (IREE_WAIT_API == IREE_WAIT_API_PPOLL) || \
     (IREE_WAIT_API == IREE_WAIT_API_EPOLL) || \
-    (IREE_WAIT_API == IREE_WAIT_API_KQUEUE)
+    (IREE_WAIT_API == IREE_WAIT_API_KQUEUE) || \
+    (IREE_WAIT_API == IREE_WAIT_API_IO_URING)
 #define IREE_WAIT_API_POSIX_LIKE 1
 #endif  // IREE_WAIT_API = posix-like
 
@@ -0,0 +1,438 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// NOTE: must be first to ensure that we can define settings for all includes.
+#include "iree/base/internal/wait_handle_impl.h"
+
+#if IREE_WAIT_API == IREE_WAIT_API_IO_URING
+
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+
+#include "iree/base/internal/io_uring.h"
+#include "iree/base/internal/wait_handle_posix.h"
+#include "iree/base/tracing.h"
+
+#if !defined(IREE_HAVE_IO_URING)
+#error "IREE_WAIT_API_IO_URING requires linux/io_uring.h"
+#endif  // !IREE_HAVE_IO_URING
+
+//===----------------------------------------------------------------------===//
+// iree_wait_set_t
+//===----------------------------------------------------------------------===//
+
+// Each handle in the set owns a slot with a stable index. Polls are queued
+// into the ring with user data identifying the slot and its generation so that
+// completions of polls that were removed (or of slots that have been reused)
+// are ignored.
+//
+// Unlike poll/ppoll, where the full fd list is registered with the kernel on
+// every wait, polls stay registered in the ring across waits and only the
+// handles that were inserted or whose polls completed since the last wait are
+// (re)registered. All registrations, removals, and the deadline timeout are
+// batched into the same io_uring_enter that blocks for completions so that
+// each wait is a single syscall regardless of how the set changed.
+//
+// NOTE: polls are one-shot and not multishot (IORING_POLL_ADD_MULTI). Wait
+// handles are level-triggered (an event stays signaled until it is reset) and
+// a multishot poll only reports wakeups. A handle that was already reported
+// signaled or that was reset after its poll completed would be misreported by
+// a cached result. Re-arming a completed poll checks the current state of the
+// handle in the kernel and completes inline if it is still signaled.
+
+// User data of operations whose completions are ignored (removals).
+#define IREE_WAIT_SET_USER_DATA_IGNORE UINT64_MAX
+// Bit set in the user data of timeouts; the remaining bits are the generation.
+#define IREE_WAIT_SET_USER_DATA_TIMEOUT_BIT (1ull << 63)
+
+typedef enum iree_wait_set_slot_state_e {
+  // Slot is not in use.
+  IREE_WAIT_SET_SLOT_FREE = 0,
+  // Handle is in the set but has no poll registered in the ring.
+  IREE_WAIT_SET_SLOT_UNARMED,
+  // Handle has a poll registered in the ring.
+  IREE_WAIT_SET_SLOT_ARMED,
+  // The poll of the handle has completed with |result|.
+  IREE_WAIT_SET_SLOT_COMPLETED,
+} iree_wait_set_slot_state_t;
+
+typedef struct iree_wait_set_slot_t {
+  iree_wait_handle_t user_handle;
+  int fd;
+  uint8_t state;  // iree_wait_set_slot_state_t
+  // Incremented each time the slot is freed to invalidate in-flight polls.
+  uint32_t generation;
+  // Poll events of the completed poll or a negative errno.
+  int32_t result;
+} iree_wait_set_slot_t;
+
+struct iree_wait_set_t {
+  iree_allocator_t allocator;
+  iree_io_uring_t ring;
+
+  // Total capacity of the slot list.
+  iree_host_size_t handle_capacity;
+  // Total number of slots in use.
+  iree_host_size_t handle_count;
+  // One past the highest slot index that has been used since the last clear.
+  iree_host_size_t slot_limit;
+
+  // Generation of the most recent timeout queued and whether it is still
+  // pending in the ring.
+  uint64_t timeout_generation;
+  bool timeout_pending;
+  bool timed_out;
+
+  iree_wait_set_slot_t* slots;
+};
+
+static uint64_t iree_wait_set_slot_user_data(const iree_wait_set_slot_t* slot,
+                                             iree_host_size_t index) {
+  return ((uint64_t)slot->generation << 32) | (uint64_t)index;
+}
+
+iree_status_t iree_wait_set_allocate(iree_host_size_t capacity,
+                                     iree_allocator_t allocator,
+                                     iree_wait_set_t** out_set) {
+  if (capacity >= UINT16_MAX) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "wait set capacity of %zu is unreasonably large",
+                            capacity);
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_host_size_t total_size = iree_sizeof_struct(iree_wait_set_t) +
+                                capacity * sizeof(iree_wait_set_slot_t);
+  iree_wait_set_t* set = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(allocator, total_size, (void**)&set));
+  memset(set, 0, total_size);
+  set->allocator = allocator;
+  set->handle_capacity = capacity;
+  set->slots = (iree_wait_set_slot_t*)((uint8_t*)set +
+                                       iree_sizeof_struct(iree_wait_set_t));
+
+  // Room for a poll per handle plus the deadline timeout and its removal. Polls
+  // being removed may briefly exceed this and the ring will flush to make room.
+  iree_status_t status =
+      iree_io_uring_initialize((uint32_t)capacity + 4, &set->ring);
+  if (iree_status_is_ok(status)) {
+    *out_set = set;
+  } else {
+    iree_allocator_free(allocator, set);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+void iree_wait_set_free(iree_wait_set_t* set) {
+  // Closing the ring cancels all registered polls.
+  iree_io_uring_deinitialize(&set->ring);
+  iree_allocator_free(set->allocator, set);
+}
+
+iree_status_t iree_wait_set_insert(iree_wait_set_t* set,
+                                   iree_wait_handle_t handle) {
+  if (set->handle_count + 1 > set->handle_capacity) {
+    return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                            "wait set capacity reached");
+  }
+
+  // Reuse the first free slot; slots are only freed by erase so in the common
+  // case of a set that is filled and then cleared this is the slot limit.
+  iree_host_size_t index = set->slot_limit;
+  if (set->handle_count < set->slot_limit) {
+    for (iree_host_size_t i = 0; i < set->slot_limit; ++i) {
+      if (set->slots[i].state == IREE_WAIT_SET_SLOT_FREE) {
+        index = i;
+        break;
+      }
+    }
+  }
+  set->slot_limit = iree_max(set->slot_limit, index + 1);
+  ++set->handle_count;
+
+  // The poll is registered in a batch with the next wait.
+  iree_wait_set_slot_t* slot = &set->slots[index];
+  IREE_IGNORE_ERROR(iree_wait_handle_wrap_primitive(handle.type, handle.value,
+                                                    &slot->user_handle));
+  slot->user_handle.set_internal.index = index;
+  slot->fd = iree_wait_primitive_get_read_fd(&handle);
+  slot->state = IREE_WAIT_SET_SLOT_UNARMED;
+  slot->result = 0;
+  return iree_ok_status();
+}
+
+// Frees the slot at |index| and removes its poll from the ring, if any.
+static void iree_wait_set_free_slot(iree_wait_set_t* set,
+                                    iree_host_size_t index) {
+  iree_wait_set_slot_t* slot = &set->slots[index];
+  if (slot->state == IREE_WAIT_SET_SLOT_ARMED) {
+    // The removal is batched with the next submission. If the ring is full and
+    // cannot be flushed the stale poll completion is ignored by generation.
+    iree_status_ignore(iree_io_uring_queue_poll_remove(
+        &set->ring, iree_wait_set_slot_user_data(slot, index),
+        IREE_WAIT_SET_USER_DATA_IGNORE));
+  }
+  slot->state = IREE_WAIT_SET_SLOT_FREE;
+  ++slot->generation;
+  --set->handle_count;
+}
+
+void iree_wait_set_erase(iree_wait_set_t* set, iree_wait_handle_t handle) {
+  // Use the slot index stashed in the handle when it came from the set and
+  // otherwise fall back to a linear scan.
+  iree_host_size_t index = handle.set_internal.index;
+  if (IREE_UNLIKELY(index >= set->slot_limit) ||
+      set->slots[index].state == IREE_WAIT_SET_SLOT_FREE ||
+      IREE_UNLIKELY(!iree_wait_primitive_compare_identical(
+          &set->slots[index].user_handle, &handle))) {
+    index = set->slot_limit;
+    for (iree_host_size_t i = 0; i < set->slot_limit; ++i) {
+      if (set->slots[i].state != IREE_WAIT_SET_SLOT_FREE &&
+          iree_wait_primitive_compare_identical(&set->slots[i].user_handle,
+                                                &handle)) {
+        index = i;
+        break;
+      }
+    }
+    if (index == set->slot_limit) return;  // not found
+  }
+  iree_wait_set_free_slot(set, index);
+}
+
+void iree_wait_set_clear(iree_wait_set_t* set) {
+  for (iree_host_size_t i = 0; i < set->slot_limit; ++i) {
+    if (set->slots[i].state != IREE_WAIT_SET_SLOT_FREE) {
+      iree_wait_set_free_slot(set, i);
+    }
+  }
+  set->slot_limit = 0;
+}
+
+// Drains all completions from the ring and updates the slots they target.
+static void iree_wait_set_process_completions(iree_wait_set_t* set) {
+  uint64_t user_data = 0;
+  int32_t result = 0;
+  while (iree_io_uring_pop_completion(&set->ring, &user_data, &result)) {
+    if (user_data == IREE_WAIT_SET_USER_DATA_IGNORE) continue;
+    if (user_data & IREE_WAIT_SET_USER_DATA_TIMEOUT_BIT) {
+      if ((user_data & ~IREE_WAIT_SET_USER_DATA_TIMEOUT_BIT) ==
+          set->timeout_generation) {
+        set->timeout_pending = false;
+        // -ETIME indicates expiration and -ECANCELED removal.
+        set->timed_out = result == -ETIME;
+      }
+      continue;
+    }
+    iree_host_size_t index = (iree_host_size_t)(user_data & UINT32_MAX);
+    uint32_t generation = (uint32_t)(user_data >> 32);
+    if (index >= set->slot_limit) continue;
+    iree_wait_set_slot_t* slot = &set->slots[index];
+    if (slot->state != IREE_WAIT_SET_SLOT_ARMED ||
+        slot->generation != generation) {
+      continue;  // stale completion of a removed poll
+    }
+    slot->state = IREE_WAIT_SET_SLOT_COMPLETED;
+    slot->result = result;
+  }
+}
+
+// Maps a poll completion result to a status (on failure) and an indicator of
+// whether the handle was signaled.
+static iree_status_t iree_wait_set_resolve_poll_result(int32_t result,
+                                                       bool* out_signaled) {
+  *out_signaled = false;
+  if (result < 0) {
+    return iree_make_status(iree_status_code_from_errno(-result),
+                            "io_uring poll failure %d", -result);
+  } else if (result & POLLERR) {
+    return iree_make_status(IREE_STATUS_INTERNAL, "POLLERR on fd");
+  } else if (result & POLLHUP) {
+    return iree_make_status(IREE_STATUS_CANCELLED, "POLLHUP on fd");
+  } else if (result & POLLNVAL) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT, "POLLNVAL on fd");
+  }
+  *out_signaled = (result & POLLIN) != 0;
+  return iree_ok_status();
+}
+
+// Queues polls for all handles that have none registered in the ring.
+static iree_status_t iree_wait_set_arm(iree_wait_set_t* set) {
+  for (iree_host_size_t i = 0; i < set->slot_limit; ++i) {
+    iree_wait_set_slot_t* slot = &set->slots[i];
+    if (slot->state != IREE_WAIT_SET_SLOT_UNARMED) continue;
+    IREE_RETURN_IF_ERROR(iree_io_uring_queue_poll_add(
+        &set->ring, slot->fd, POLLIN | POLLPRI,
+        iree_wait_set_slot_user_data(slot, i)));
+    slot->state = IREE_WAIT_SET_SLOT_ARMED;
+  }
+  return iree_ok_status();
+}
+
+// Checks the completed polls of the set. For wait-any returns the index of the
+// first signaled handle in |out_index|; for wait-all returns true in
+// |out_resolved| only when all handles are signaled. Polls that completed
+// without being signaled are re-armed.
+static iree_status_t iree_wait_set_check(iree_wait_set_t* set, bool wait_all,
+                                         bool* out_resolved,
+                                         iree_host_size_t* out_index) {
+  *out_resolved = false;
+  bool all_signaled = true;
+  for (iree_host_size_t i = 0; i < set->slot_limit; ++i) {
+    iree_wait_set_slot_t* slot = &set->slots[i];
+    if (slot->state == IREE_WAIT_SET_SLOT_FREE) continue;
+    bool signaled = false;
+    if (slot->state == IREE_WAIT_SET_SLOT_COMPLETED) {
+      IREE_RETURN_IF_ERROR(
+          iree_wait_set_resolve_poll_result(slot->result, &signaled));
+      if (!signaled) slot->state = IREE_WAIT_SET_SLOT_UNARMED;
+    }
+    if (signaled && !wait_all) {
+      *out_resolved = true;
+      *out_index = i;
+      return iree_ok_status();
+    }
+    all_signaled = all_signaled && signaled;
+  }
+  *out_resolved = wait_all && all_signaled;
+  return iree_ok_status();
+}
+
+static iree_status_t iree_wait_set_wait(iree_wait_set_t* set, bool wait_all,
+                                        iree_time_t deadline_ns,
+                                        iree_host_size_t* out_index) {
+  // Polls that completed during previous waits may no longer reflect the state
+  // of their handles; re-arm them so the kernel checks again.
+  for (iree_host_size_t i = 0; i < set->slot_limit; ++i) {
+    if (set->slots[i].state == IREE_WAIT_SET_SLOT_COMPLETED) {
+      set->slots[i].state = IREE_WAIT_SET_SLOT_UNARMED;
+    }
+  }
+
+  // Queue the deadline; it is submitted along with the polls.
+  set->timed_out = false;
+  bool is_polling = deadline_ns == IREE_TIME_INFINITE_PAST;
+  if (!is_polling && deadline_ns != IREE_TIME_INFINITE_FUTURE) {
+    ++set->timeout_generation;
+    IREE_RETURN_IF_ERROR(iree_io_uring_queue_timeout(
+        &set->ring, deadline_ns - iree_time_now(),
+        IREE_WAIT_SET_USER_DATA_TIMEOUT_BIT | set->timeout_generation));
+    set->timeout_pending = true;
+  }
+
+  iree_status_t status = iree_ok_status();
+  bool resolved = false;
+  while (iree_status_is_ok(status)) {
+    status = iree_wait_set_arm(set);
+    if (!iree_status_is_ok(status)) break;
+    // Polls of signaled handles complete inline during submission so the
+    // non-blocking (polling) wait still observes them.
+    status = iree_io_uring_submit(&set->ring, is_polling ? 0 : 1);
+    if (iree_status_is_deferred(status)) {
+      // Interrupted by a signal; the deadline timeout remains in the ring.
+      iree_status_ignore(status);
+      status = iree_ok_status();
+      continue;
+    } else if (!iree_status_is_ok(status)) {
+      break;
+    }
+    iree_wait_set_process_completions(set);
+    status = iree_wait_set_check(set, wait_all, &resolved, out_index);
+    if (!iree_status_is_ok(status) || resolved) break;
+    if (is_polling || set->timed_out) {
+      status = iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+    }
+  }
+
+  // Cancel the timeout if the wait finished before it expired. The removal is
+  // submitted with the next wait; if the timeout fires first its completion is
+  // ignored by generation.
+  if (set->timeout_pending) {
+    set->timeout_pending = false;
+    uint64_t timeout_user_data =
+        IREE_WAIT_SET_USER_DATA_TIMEOUT_BIT | set->timeout_generation;
+    iree_status_ignore(iree_io_uring_queue_timeout_remove(
+        &set->ring, timeout_user_data, IREE_WAIT_SET_USER_DATA_IGNORE));
+  }
+  return status;
+}
+
+iree_status_t iree_wait_all(iree_wait_set_t* set, iree_time_t deadline_ns) {
+  // Make the syscall only when we have at least one valid fd.
+  // Don't use this as a sleep.
+  if (set->handle_count <= 0) {
+    return iree_ok_status();
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_host_size_t index = 0;
+  iree_status_t status = iree_wait_set_wait(set, /*wait_all=*/true,
+                                            deadline_ns, &index);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+iree_status_t iree_wait_any(iree_wait_set_t* set, iree_time_t deadline_ns,
+                            iree_wait_handle_t* out_wake_handle) {
+  memset(out_wake_handle, 0, sizeof(*out_wake_handle));
+  // Make the syscall only when we have at least one valid fd.
+  // Don't use this as a sleep.
+  if (set->handle_count <= 0) {
+    return iree_ok_status();
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_host_size_t index = 0;
+  iree_status_t status = iree_wait_set_wait(set, /*wait_all=*/false,
+                                            deadline_ns, &index);
+  if (iree_status_is_ok(status)) {
+    memcpy(out_wake_handle, &set->slots[index].user_handle,
+           sizeof(*out_wake_handle));
+    out_wake_handle->set_internal.index = index;
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// NOTE: single-handle waits don't benefit from a persistent registration and
+// setting up a ring per wait would cost more than the wait itself so we use
+// ppoll directly.
+iree_status_t iree_wait_one(iree_wait_handle_t* handle,
+                            iree_time_t deadline_ns) {
+  struct pollfd poll_fd;
+  poll_fd.fd = iree_wait_primitive_get_read_fd(handle);
+  if (poll_fd.fd == -1) return iree_ok_status();
+  poll_fd.events = POLLIN;
+  poll_fd.revents = 0;
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+  int rv = -1;
+  do {
+    struct timespec timeout_ts;
+    struct timespec* tmo_p = &timeout_ts;
+    if (deadline_ns == IREE_TIME_INFINITE_FUTURE) {
+      tmo_p = NULL;
+    } else {
+      iree_duration_t timeout_ns = deadline_ns == IREE_TIME_INFINITE_PAST
+                                       ? 0
+                                       : deadline_ns - iree_time_now();
+      timeout_ns = iree_max(0, timeout_ns);
+      timeout_ts.tv_sec = (time_t)(timeout_ns / 1000000000ull);
+      timeout_ts.tv_nsec = (long)(timeout_ns % 1000000000ull);
+    }
+    rv = ppoll(&poll_fd, 1, tmo_p, NULL);
+  } while (rv < 0 && errno == EINTR);
+  IREE_TRACE_ZONE_END(z0);
+
+  if (rv < 0) {
+    return iree_make_status(iree_status_code_from_errno(errno),
+                            "ppoll failure %d", errno);
+  }
+  return rv > 0 ? iree_ok_status()
+                : iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+}
+
+#endif  // IREE_WAIT_API == IREE_WAIT_API_IO_URING
@@ -55,21 +55,20 @@ void iree_wait_set_erase(iree_wait_set_t* set, iree_wait_handle_t handle) {}
 
 void iree_wait_set_clear(iree_wait_set_t* set) {}
 
+// Timeouts are returned as bare status codes (without messages) as callers
+// poll waits in loops and must not allocate on each attempt.
 iree_status_t iree_wait_all(iree_wait_set_t* set, iree_time_t deadline_ns) {
-  return iree_make_status(IREE_STATUS_DEADLINE_EXCEEDED,
-                          "wait primitives not available on this platform");
+  return iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
 }
 
 iree_status_t iree_wait_any(iree_wait_set_t* set, iree_time_t deadline_ns,
                             iree_wait_handle_t* out_wake_handle) {
-  return iree_make_status(IREE_STATUS_DEADLINE_EXCEEDED,
-                          "wait primitives not available on this platform");
+  return iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
 }
 
 iree_status_t iree_wait_one(iree_wait_handle_t* handle,
                             iree_time_t deadline_ns) {
-  return iree_make_status(IREE_STATUS_DEADLINE_EXCEEDED,
-                          "wait primitives not available on this platform");
+  return iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
 }
 
 //===----------------------------------------------------------------------===//
@@ -87,6 +87,28 @@ TEST(Event, WaitOneInitialFalse) {
   iree_event_deinitialize(&event);
 }
 
+// Tests that polling timeouts are returned as bare status codes. Polling loops
+// create and drop these as part of normal control flow and must not allocate.
+TEST(Event, PollingTimeoutIsCodeOnly) {
+  iree_event_t event;
+  IREE_ASSERT_OK(iree_event_initialize(/*initial_state=*/false, &event));
+  iree_wait_set_t* wait_set = NULL;
+  IREE_ASSERT_OK(iree_wait_set_allocate(1, iree_allocator_system(), &wait_set));
+  IREE_ASSERT_OK(iree_wait_set_insert(wait_set, event));
+
+  const iree_status_t deadline_exceeded =
+      iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+  EXPECT_EQ(deadline_exceeded, iree_wait_one(&event, IREE_TIME_INFINITE_PAST));
+  EXPECT_EQ(deadline_exceeded,
+            iree_wait_all(wait_set, IREE_TIME_INFINITE_PAST));
+  iree_wait_handle_t wake_handle;
+  EXPECT_EQ(deadline_exceeded,
+            iree_wait_any(wait_set, IREE_TIME_INFINITE_PAST, &wake_handle));
+
+  iree_wait_set_free(wait_set);
+  iree_event_deinitialize(&event);
+}
+
 TEST(Event, WaitOneInitialTrue) {
   iree_event_t event;
   IREE_ASSERT_OK(iree_event_initialize(/*initial_state=*/true, &event));
@@ -226,6 +248,87 @@ TEST(Event, WaitSourceBlocking) {
   iree_event_deinitialize(&event);
 }
 
+// Tests waiting on a mix of event and delay wait sources.
+TEST(Event, WaitSourceWaitAll) {
+  iree_event_t ev_a, ev_b;
+  IREE_ASSERT_OK(iree_event_initialize(/*initial_state=*/false, &ev_a));
+  IREE_ASSERT_OK(iree_event_initialize(/*initial_state=*/false, &ev_b));
+  iree_wait_source_t wait_sources[3] = {
+      iree_event_await(&ev_a),
+      iree_event_await(&ev_b),
+      iree_wait_source_delay(iree_time_now()),
+  };
+
+  IREE_EXPECT_STATUS_IS(
+      IREE_STATUS_DEADLINE_EXCEEDED,
+      iree_wait_source_wait_all(IREE_ARRAYSIZE(wait_sources), wait_sources,
+                                iree_immediate_timeout()));
+
+  // Only one set is not enough.
+  iree_event_set(&ev_a);
+  IREE_EXPECT_STATUS_IS(
+      IREE_STATUS_DEADLINE_EXCEEDED,
+      iree_wait_source_wait_all(IREE_ARRAYSIZE(wait_sources), wait_sources,
+                                iree_immediate_timeout()));
+
+  // Signal from another thread while blocking.
+  std::thread thread([&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    iree_event_set(&ev_b);
+  });
+  IREE_EXPECT_OK(iree_wait_source_wait_all(IREE_ARRAYSIZE(wait_sources),
+                                           wait_sources,
+                                           iree_infinite_timeout()));
+  thread.join();
+
+  iree_event_deinitialize(&ev_a);
+  iree_event_deinitialize(&ev_b);
+}
+
+// Tests that waiting for any wait source returns the one that resolved.
+TEST(Event, WaitSourceWaitAny) {
+  iree_event_t ev_a, ev_b;
+  IREE_ASSERT_OK(iree_event_initialize(/*initial_state=*/false, &ev_a));
+  IREE_ASSERT_OK(iree_event_initialize(/*initial_state=*/false, &ev_b));
+  iree_wait_source_t wait_sources[3] = {
+      iree_event_await(&ev_a),
+      iree_event_await(&ev_b),
+      iree_wait_source_delay(IREE_TIME_INFINITE_FUTURE),
+  };
+
+  iree_host_size_t index = 0;
+  IREE_EXPECT_STATUS_IS(
+      IREE_STATUS_DEADLINE_EXCEEDED,
+      iree_wait_source_wait_any(IREE_ARRAYSIZE(wait_sources), wait_sources,
+                                iree_immediate_timeout(), &index));
+  IREE_EXPECT_STATUS_IS(
+      IREE_STATUS_DEADLINE_EXCEEDED,
+      iree_wait_source_wait_any(IREE_ARRAYSIZE(wait_sources), wait_sources,
+                                iree_make_timeout(10 * 1000000ll), &index));
+
+  // Signal from another thread while blocking.
+  std::thread thread([&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    iree_event_set(&ev_b);
+  });
+  IREE_EXPECT_OK(iree_wait_source_wait_any(IREE_ARRAYSIZE(wait_sources),
+                                           wait_sources,
+                                           iree_infinite_timeout(), &index));
+  EXPECT_EQ(1, index);
+  thread.join();
+
+  // Delays resolve once their deadline is reached.
+  wait_sources[1] = iree_wait_source_delay(iree_time_now() + 1000000);
+  iree_event_reset(&ev_b);
+  IREE_EXPECT_OK(iree_wait_source_wait_any(IREE_ARRAYSIZE(wait_sources),
+                                           wait_sources,
+                                           iree_infinite_timeout(), &index));
+  EXPECT_EQ(1, index);
+
+  iree_event_deinitialize(&ev_a);
+  iree_event_deinitialize(&ev_b);
+}
+
 //===----------------------------------------------------------------------===//
 // iree_wait_set_t
 //===----------------------------------------------------------------------===//
@@ -13,9 +13,9 @@
 // iree_wait_source_t
 //===----------------------------------------------------------------------===//
 
-// NOTE: iree_wait_source_import lives in iree/base/internal/wait_handle.c
-// for now as that lets us compile out native wait handle support at a coarse
-// level.
+// NOTE: iree_wait_source_import, iree_wait_source_wait_all, and
+// iree_wait_source_wait_any live in iree/base/internal/wait_handle.c for now as
+// that lets us compile out native wait handle support at a coarse level.
 
 IREE_API_EXPORT iree_status_t iree_wait_source_export(
     iree_wait_source_t wait_source, iree_wait_primitive_type_t target_type,
@@ -325,9 +325,27 @@ IREE_API_EXPORT iree_status_t iree_wait_source_query(
 IREE_API_EXPORT iree_status_t iree_wait_source_wait_one(
     iree_wait_source_t wait_source, iree_timeout_t timeout);
 
-// TODO(benvanik): iree_wait_source_wait_any/all: allow multiple wait sources
-// that share the same control function. The implementation can decide if it
-// wants to coalesce them or not.
+// Blocks the caller and waits for all of |wait_sources| to resolve.
+// Sources that can be exported to system wait primitives are multiplexed into
+// a single system wait and any others are waited on individually afterward.
+// Returns IREE_STATUS_DEADLINE_EXCEEDED if |timeout| is reached before all wait
+// sources resolve. If any wait source resolved with a failure then the error
+// status will be returned.
+IREE_API_EXPORT iree_status_t iree_wait_source_wait_all(
+    iree_host_size_t count, const iree_wait_source_t* wait_sources,
+    iree_timeout_t timeout);
+
+// Blocks the caller and waits for any of |wait_sources| to resolve.
+// The index of a resolved wait source is returned in |out_index|; if more than
+// one resolved which is returned is unspecified. Sources that can be exported
+// to system wait primitives are multiplexed into a single system wait while
+// any others are polled periodically during the wait.
+// Returns IREE_STATUS_DEADLINE_EXCEEDED if |timeout| is reached before any wait
+// source resolves. If the resolved wait source resolved with a failure then the
+// error status will be returned.
+IREE_API_EXPORT iree_status_t iree_wait_source_wait_any(
+    iree_host_size_t count, const iree_wait_source_t* wait_sources,
+    iree_timeout_t timeout, iree_host_size_t* out_index);
 
 #ifdef __cplusplus
 }  // extern "C"
@@ -0,0 +1,177 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/builtins/mmt4d/mmt4d.h"
+
+#include <string.h>
+
+#include "iree/base/internal/math.h"
+#include "iree/builtins/mmt4d/mmt4d_impl.h"
+#include "iree/hal/local/executable_library.h"
+
+//===----------------------------------------------------------------------===//
+// Portable implementations
+//===----------------------------------------------------------------------===//
+
+static inline int32_t iree_mmt4d_i8_to_i32(int8_t value) {
+  return (int32_t)value;
+}
+
+static inline float iree_mmt4d_f32_to_f32(float value) { return value; }
+
+static inline float iree_mmt4d_bf16_to_f32(uint16_t value) {
+  uint32_t bits = (uint32_t)value << 16;
+  float result;
+  memcpy(&result, &bits, sizeof(result));
+  return result;
+}
+
+// Defines a portable tile function |tile_name| accumulating into a dense
+// [M0, N0] output tile from dense [k1, M0, K0] lhs and [k1, N0, K0] rhs tiles.
+// Values are converted to |out_t| with |lhs_cvt| and |rhs_cvt|.
+#define IREE_MMT4D_DEFINE_GENERIC_TILE(tile_name, lhs_t, rhs_t, out_t, M0, N0, \
+                                       K0, lhs_cvt, rhs_cvt)                   \
+  static void tile_name(const lhs_t* IREE_RESTRICT lhs,                        \
+                        const rhs_t* IREE_RESTRICT rhs,                        \
+                        out_t* IREE_RESTRICT out, int64_t k1) {                \
+    for (int64_t k = 0; k < k1; ++k) {                                         \
+      for (int m0 = 0; m0 < (M0); ++m0) {                                      \
+        for (int n0 = 0; n0 < (N0); ++n0) {                                    \
+          const lhs_t* lhs_row = lhs + m0 * (K0);                              \
+          const rhs_t* rhs_row = rhs + n0 * (K0);                              \
+          out_t acc = out[m0 * (N0) + n0];                                     \
+          for (int k0 = 0; k0 < (K0); ++k0) {                                  \
+            acc += lhs_cvt(lhs_row[k0]) * rhs_cvt(rhs_row[k0]);                \
+          }                                                                    \
+          out[m0 * (N0) + n0] = acc;                                           \
+        }                                                                      \
+      }                                                                        \
+      lhs += (M0) * (K0);                                                      \
+      rhs += (N0) * (K0);                                                      \
+    }                                                                          \
+  }
+
+#define IREE_MMT4D_DEFINE_GENERIC_KERNEL(name, lhs_t, rhs_t, out_t, M0, N0, \
+                                         K0, lhs_cvt, rhs_cvt)              \
+  IREE_MMT4D_DEFINE_GENERIC_TILE(name##_tile, lhs_t, rhs_t, out_t, M0, N0,  \
+                                 K0, lhs_cvt, rhs_cvt)                      \
+  IREE_MMT4D_DEFINE_KERNEL(, name, name##_tile, lhs_t, rhs_t, out_t, M0, N0)
+
+IREE_MMT4D_DEFINE_GENERIC_KERNEL(iree_mmt4d_bf16bf16f32_8x8x1_generic, uint16_t,
+                                 uint16_t, float, 8, 8, 1,
+                                 iree_mmt4d_bf16_to_f32, iree_mmt4d_bf16_to_f32)
+IREE_MMT4D_DEFINE_GENERIC_KERNEL(iree_mmt4d_bf16bf16f32_8x8x2_generic, uint16_t,
+                                 uint16_t, float, 8, 8, 2,
+                                 iree_mmt4d_bf16_to_f32, iree_mmt4d_bf16_to_f32)
+IREE_MMT4D_DEFINE_GENERIC_KERNEL(iree_mmt4d_bf16bf16f32_8x8x4_generic, uint16_t,
+                                 uint16_t, float, 8, 8, 4,
+                                 iree_mmt4d_bf16_to_f32, iree_mmt4d_bf16_to_f32)
+IREE_MMT4D_DEFINE_GENERIC_KERNEL(iree_mmt4d_f16f16f32_8x8x1_generic, uint16_t,
+                                 uint16_t, float, 8, 8, 1, iree_math_f16_to_f32,
+                                 iree_math_f16_to_f32)
+IREE_MMT4D_DEFINE_GENERIC_KERNEL(iree_mmt4d_f32f32f32_8x8x1_generic, float,
+                                 float, float, 8, 8, 1, iree_mmt4d_f32_to_f32,
+                                 iree_mmt4d_f32_to_f32)
+IREE_MMT4D_DEFINE_GENERIC_KERNEL(iree_mmt4d_i8i8i32_8x8x2_generic, int8_t,
+                                 int8_t, int32_t, 8, 8, 2, iree_mmt4d_i8_to_i32,
+                                 iree_mmt4d_i8_to_i32)
+IREE_MMT4D_DEFINE_GENERIC_KERNEL(iree_mmt4d_i8i8i32_8x8x4_generic, int8_t,
+                                 int8_t, int32_t, 8, 8, 4, iree_mmt4d_i8_to_i32,
+                                 iree_mmt4d_i8_to_i32)
+IREE_MMT4D_DEFINE_GENERIC_KERNEL(iree_mmt4d_i8i8i32_8x8x8_generic, int8_t,
+                                 int8_t, int32_t, 8, 8, 8, iree_mmt4d_i8_to_i32,
+                                 iree_mmt4d_i8_to_i32)
+
+//===----------------------------------------------------------------------===//
+// Microkernel table
+//===----------------------------------------------------------------------===//
+
+// Sorted by name with the most specialized implementation of each name first.
+// Lookups take the first implementation supported by the processor and every
+// name ends with a portable implementation that is always supported.
+static const iree_mmt4d_kernel_t iree_mmt4d_kernel_table[] = {
+#if defined(IREE_MMT4D_HAVE_X86_64)
+    {"iree_mmt4d_bf16bf16f32_8x8x1",
+     IREE_HAL_PROCESSOR_DATA0_X86_64_AVX2 | IREE_HAL_PROCESSOR_DATA0_X86_64_FMA,
+     iree_mmt4d_bf16bf16f32_8x8x1_x86_64_avx2_fma},
+#endif  // IREE_MMT4D_HAVE_X86_64
+#if defined(IREE_MMT4D_HAVE_ARM_64)
+    {"iree_mmt4d_bf16bf16f32_8x8x1", 0, iree_mmt4d_bf16bf16f32_8x8x1_arm_64},
+#endif  // IREE_MMT4D_HAVE_ARM_64
+    {"iree_mmt4d_bf16bf16f32_8x8x1", 0, iree_mmt4d_bf16bf16f32_8x8x1_generic},
+#if defined(IREE_MMT4D_HAVE_X86_64_AVX512BF16)
+    {"iree_mmt4d_bf16bf16f32_8x8x2",
+     IREE_HAL_PROCESSOR_DATA0_X86_64_AVX2 |
+         IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512VL |
+         IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512BF16,
+     iree_mmt4d_bf16bf16f32_8x8x2_x86_64_avx512bf16},
+#endif  // IREE_MMT4D_HAVE_X86_64_AVX512BF16
+    {"iree_mmt4d_bf16bf16f32_8x8x2", 0, iree_mmt4d_bf16bf16f32_8x8x2_generic},
+#if defined(IREE_MMT4D_HAVE_ARM_64_BF16)
+    {"iree_mmt4d_bf16bf16f32_8x8x4", IREE_HAL_PROCESSOR_DATA0_ARM_64_BF16,
+     iree_mmt4d_bf16bf16f32_8x8x4_arm_64_bf16},
+#endif  // IREE_MMT4D_HAVE_ARM_64_BF16
+    {"iree_mmt4d_bf16bf16f32_8x8x4", 0, iree_mmt4d_bf16bf16f32_8x8x4_generic},
+#if defined(IREE_MMT4D_HAVE_X86_64)
+    {"iree_mmt4d_f16f16f32_8x8x1",
+     IREE_HAL_PROCESSOR_DATA0_X86_64_AVX2 |
+         IREE_HAL_PROCESSOR_DATA0_X86_64_FMA |
+         IREE_HAL_PROCESSOR_DATA0_X86_64_F16C,
+     iree_mmt4d_f16f16f32_8x8x1_x86_64_avx2_fma_f16c},
+#endif  // IREE_MMT4D_HAVE_X86_64
+#if defined(IREE_MMT4D_HAVE_ARM_64)
+    {"iree_mmt4d_f16f16f32_8x8x1", 0, iree_mmt4d_f16f16f32_8x8x1_arm_64},
+#endif  // IREE_MMT4D_HAVE_ARM_64
+    {"iree_mmt4d_f16f16f32_8x8x1", 0, iree_mmt4d_f16f16f32_8x8x1_generic},
+#if defined(IREE_MMT4D_HAVE_X86_64)
+    {"iree_mmt4d_f32f32f32_8x8x1",
+     IREE_HAL_PROCESSOR_DATA0_X86_64_AVX2 | IREE_HAL_PROCESSOR_DATA0_X86_64_FMA,
+     iree_mmt4d_f32f32f32_8x8x1_x86_64_avx2_fma},
+#endif  // IREE_MMT4D_HAVE_X86_64
+#if defined(IREE_MMT4D_HAVE_ARM_64)
+    {"iree_mmt4d_f32f32f32_8x8x1", 0, iree_mmt4d_f32f32f32_8x8x1_arm_64},
+#endif  // IREE_MMT4D_HAVE_ARM_64
+    {"iree_mmt4d_f32f32f32_8x8x1", 0, iree_mmt4d_f32f32f32_8x8x1_generic},
+#if defined(IREE_MMT4D_HAVE_X86_64)
+    {"iree_mmt4d_i8i8i32_8x8x2",
+     IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512VL |
+         IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512VNNI,
+     iree_mmt4d_i8i8i32_8x8x2_x86_64_avx512vnni},
+    {"iree_mmt4d_i8i8i32_8x8x2", IREE_HAL_PROCESSOR_DATA0_X86_64_AVX2,
+     iree_mmt4d_i8i8i32_8x8x2_x86_64_avx2},
+#endif  // IREE_MMT4D_HAVE_X86_64
+    {"iree_mmt4d_i8i8i32_8x8x2", 0, iree_mmt4d_i8i8i32_8x8x2_generic},
+#if defined(IREE_MMT4D_HAVE_ARM_64_DOTPROD)
+    {"iree_mmt4d_i8i8i32_8x8x4", IREE_HAL_PROCESSOR_DATA0_ARM_64_DOTPROD,
+     iree_mmt4d_i8i8i32_8x8x4_arm_64_dotprod},
+#endif  // IREE_MMT4D_HAVE_ARM_64_DOTPROD
+    {"iree_mmt4d_i8i8i32_8x8x4", 0, iree_mmt4d_i8i8i32_8x8x4_generic},
+#if defined(IREE_MMT4D_HAVE_ARM_64_I8MM)
+    {"iree_mmt4d_i8i8i32_8x8x8", IREE_HAL_PROCESSOR_DATA0_ARM_64_I8MM,
+     iree_mmt4d_i8i8i32_8x8x8_arm_64_i8mm},
+#endif  // IREE_MMT4D_HAVE_ARM_64_I8MM
+    {"iree_mmt4d_i8i8i32_8x8x8", 0, iree_mmt4d_i8i8i32_8x8x8_generic},
+};
+
+iree_mmt4d_kernel_fn_t iree_mmt4d_kernel_lookup(iree_string_view_t name,
+                                                uint64_t processor_data0) {
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(iree_mmt4d_kernel_table);
+       ++i) {
+    const iree_mmt4d_kernel_t* kernel = &iree_mmt4d_kernel_table[i];
+    if (!iree_string_view_equal(name, iree_make_cstring_view(kernel->name))) {
+      continue;
+    }
+    if (iree_all_bits_set(processor_data0, kernel->required_processor_data0)) {
+      return kernel->fn;
+    }
+  }
+  return NULL;
+}
+
+const iree_mmt4d_kernel_t* iree_mmt4d_kernels(iree_host_size_t* out_count) {
+  *out_count = IREE_ARRAYSIZE(iree_mmt4d_kernel_table);
+  return iree_mmt4d_kernel_table;
+}
@@ -0,0 +1,85 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_BUILTINS_MMT4D_MMT4D_H_
+#define IREE_BUILTINS_MMT4D_MMT4D_H_
+
+#include "iree/base/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+//===----------------------------------------------------------------------===//
+// mmt4d microkernels
+//===----------------------------------------------------------------------===//
+// Microkernels computing the `linalg.mmt4d` inner loops for fixed tile shapes:
+//
+//   out[m1, n1, m0, n0] += lhs[m1, k1, m0, k0] * rhs[n1, k1, n0, k0]
+//
+// Each microkernel is named after its element types and (M0, N0, K0) tile
+// shape, such as `iree_mmt4d_i8i8i32_8x8x4`, and is called by generated code
+// as an executable import (see iree/hal/local/executable_library.h) taking an
+// iree_mmt4d_params_t. The inner (k1, m0, k0) dimensions of lhs, (k1, n0, k0)
+// dimensions of rhs, and (m0, n0) dimensions of out must be dense row-major
+// while the outermost dimension of each may be strided.
+//
+// A portable implementation is provided for each tile shape along with
+// architecture-specific ones that are only usable when the processor
+// supports the features they require. iree_mmt4d_kernel_lookup returns the
+// implementation to use for a given processor.
+
+// Parameters passed to an mmt4d microkernel.
+// The layout of this struct is part of the executable import ABI and is
+// constructed by the compiler; it must only be extended.
+typedef struct iree_mmt4d_params_t {
+  // Base of the lhs tile with shape [m1, k1, M0, K0].
+  const void* lhs;
+  // Elements between consecutive m1 rows of lhs.
+  int64_t lhs_stride;
+  // Base of the rhs tile with shape [n1, k1, N0, K0].
+  const void* rhs;
+  // Elements between consecutive n1 rows of rhs.
+  int64_t rhs_stride;
+  // Base of the out tile with shape [m1, n1, M0, N0] that is accumulated into.
+  void* out;
+  // Elements between consecutive m1 rows of out.
+  int64_t out_stride;
+  int64_t m1;
+  int64_t n1;
+  int64_t k1;
+} iree_mmt4d_params_t;
+
+// Function signature of an mmt4d microkernel.
+// Matches iree_hal_executable_import_v0_t with an iree_mmt4d_params_t.
+// Returns 0 on success.
+typedef int (*iree_mmt4d_kernel_fn_t)(void* params);
+
+// An mmt4d microkernel implementation.
+typedef struct iree_mmt4d_kernel_t {
+  // Symbol name of the microkernel as imported by executables.
+  const char* name;
+  // IREE_HAL_PROCESSOR_DATA0_* bits that the processor must support for the
+  // implementation to be used.
+  uint64_t required_processor_data0;
+  iree_mmt4d_kernel_fn_t fn;
+} iree_mmt4d_kernel_t;
+
+// Returns the most specialized implementation of the microkernel |name| that
+// can be used on a processor supporting |processor_data0| features or NULL if
+// no microkernel with the name exists.
+iree_mmt4d_kernel_fn_t iree_mmt4d_kernel_lookup(iree_string_view_t name,
+                                                uint64_t processor_data0);
+
+// Returns all microkernel implementations ordered by name with the most
+// specialized implementations of each name first. Intended for testing.
+const iree_mmt4d_kernel_t* iree_mmt4d_kernels(iree_host_size_t* out_count);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_BUILTINS_MMT4D_MMT4D_H_
@@ -0,0 +1,239 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/builtins/mmt4d/mmt4d_impl.h"
+
+#if defined(IREE_MMT4D_HAVE_ARM_64)
+
+#include <arm_neon.h>
+
+//===----------------------------------------------------------------------===//
+// f32 += f32/f16/bf16 with NEON
+//===----------------------------------------------------------------------===//
+// The 8x8 output tile is held in 16 q registers with acc[i][j] holding columns
+// [4j, 4j + 4) of row i. Each k1 multiplies the 8 rhs values by each lhs value
+// selected by lane.
+
+// Accumulates the outer product of |lhs_0|:|lhs_1| and |rhs_0|:|rhs_1| into
+// the 8x8 |acc|. Lanes must be immediates and are unrolled here.
+#define IREE_MMT4D_F32_OUTER_PRODUCT_ROW(acc, lhs, i, lane, rhs_0, rhs_1) \
+  acc[i][0] = vfmaq_laneq_f32(acc[i][0], rhs_0, lhs, lane);               \
+  acc[i][1] = vfmaq_laneq_f32(acc[i][1], rhs_1, lhs, lane);
+#define IREE_MMT4D_F32_OUTER_PRODUCT(acc, lhs_0, lhs_1, rhs_0, rhs_1) \
+  IREE_MMT4D_F32_OUTER_PRODUCT_ROW(acc, lhs_0, 0, 0, rhs_0, rhs_1)    \
+  IREE_MMT4D_F32_OUTER_PRODUCT_ROW(acc, lhs_0, 1, 1, rhs_0, rhs_1)    \
+  IREE_MMT4D_F32_OUTER_PRODUCT_ROW(acc, lhs_0, 2, 2, rhs_0, rhs_1)    \
+  IREE_MMT4D_F32_OUTER_PRODUCT_ROW(acc, lhs_0, 3, 3, rhs_0, rhs_1)    \
+  IREE_MMT4D_F32_OUTER_PRODUCT_ROW(acc, lhs_1, 4, 0, rhs_0, rhs_1)    \
+  IREE_MMT4D_F32_OUTER_PRODUCT_ROW(acc, lhs_1, 5, 1, rhs_0, rhs_1)    \
+  IREE_MMT4D_F32_OUTER_PRODUCT_ROW(acc, lhs_1, 6, 2, rhs_0, rhs_1)    \
+  IREE_MMT4D_F32_OUTER_PRODUCT_ROW(acc, lhs_1, 7, 3, rhs_0, rhs_1)
+
+static inline float32x4_t iree_mmt4d_load_4xf32(const float* src) {
+  return vld1q_f32(src);
+}
+
+static inline float32x4_t iree_mmt4d_load_4xf16(const uint16_t* src) {
+  return vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(src)));
+}
+
+// bf16 values are widened to f32 by shifting them into the high half of each
+// 32-bit lane.
+static inline float32x4_t iree_mmt4d_load_4xbf16(const uint16_t* src) {
+  return vreinterpretq_f32_u32(vshll_n_u16(vld1_u16(src), 16));
+}
+
+#define IREE_MMT4D_DEFINE_F32_TILE(tile_name, src_t, load_fn)                \
+  static inline void tile_name(const src_t* IREE_RESTRICT lhs,               \
+                               const src_t* IREE_RESTRICT rhs,               \
+                               float* IREE_RESTRICT out, int64_t k1) {       \
+    float32x4_t acc[8][2];                                                   \
+    for (int i = 0; i < 8; ++i) {                                            \
+      acc[i][0] = vld1q_f32(out + 8 * i);                                    \
+      acc[i][1] = vld1q_f32(out + 8 * i + 4);                                \
+    }                                                                        \
+    for (int64_t k = 0; k < k1; ++k) {                                       \
+      float32x4_t lhs_0 = load_fn(lhs);                                      \
+      float32x4_t lhs_1 = load_fn(lhs + 4);                                  \
+      float32x4_t rhs_0 = load_fn(rhs);                                      \
+      float32x4_t rhs_1 = load_fn(rhs + 4);                                  \
+      IREE_MMT4D_F32_OUTER_PRODUCT(acc, lhs_0, lhs_1, rhs_0, rhs_1)          \
+      lhs += 8;                                                              \
+      rhs += 8;                                                              \
+    }                                                                        \
+    for (int i = 0; i < 8; ++i) {                                            \
+      vst1q_f32(out + 8 * i, acc[i][0]);                                     \
+      vst1q_f32(out + 8 * i + 4, acc[i][1]);                                 \
+    }                                                                        \
+  }
+
+IREE_MMT4D_DEFINE_F32_TILE(iree_mmt4d_f32f32f32_8x8x1_arm_64_tile, float,
+                           iree_mmt4d_load_4xf32)
+IREE_MMT4D_DEFINE_KERNEL(, iree_mmt4d_f32f32f32_8x8x1_arm_64,
+                         iree_mmt4d_f32f32f32_8x8x1_arm_64_tile, float, float,
+                         float, 8, 8)
+
+IREE_MMT4D_DEFINE_F32_TILE(iree_mmt4d_f16f16f32_8x8x1_arm_64_tile, uint16_t,
+                           iree_mmt4d_load_4xf16)
+IREE_MMT4D_DEFINE_KERNEL(, iree_mmt4d_f16f16f32_8x8x1_arm_64,
+                         iree_mmt4d_f16f16f32_8x8x1_arm_64_tile, uint16_t,
+                         uint16_t, float, 8, 8)
+
+IREE_MMT4D_DEFINE_F32_TILE(iree_mmt4d_bf16bf16f32_8x8x1_arm_64_tile, uint16_t,
+                           iree_mmt4d_load_4xbf16)
+IREE_MMT4D_DEFINE_KERNEL(, iree_mmt4d_bf16bf16f32_8x8x1_arm_64,
+                         iree_mmt4d_bf16bf16f32_8x8x1_arm_64_tile, uint16_t,
+                         uint16_t, float, 8, 8)
+
+//===----------------------------------------------------------------------===//
+// i32 += i8 * i8 with dotprod
+//===----------------------------------------------------------------------===//
+// Each 4-byte group of the [8, 4] lhs and rhs tiles is one row. sdot by lane
+// accumulates one lhs row against 4 rhs rows into 4 columns of acc[i][j].
+
+#if defined(IREE_MMT4D_HAVE_ARM_64_DOTPROD)
+
+#define IREE_MMT4D_I8_DOT_ROW(acc, lhs, i, lane, rhs_0, rhs_1) \
+  acc[i][0] = vdotq_laneq_s32(acc[i][0], rhs_0, lhs, lane);    \
+  acc[i][1] = vdotq_laneq_s32(acc[i][1], rhs_1, lhs, lane);
+
+static inline void iree_mmt4d_i8i8i32_8x8x4_arm_64_dotprod_tile(
+    const int8_t* IREE_RESTRICT lhs, const int8_t* IREE_RESTRICT rhs,
+    int32_t* IREE_RESTRICT out, int64_t k1) {
+  int32x4_t acc[8][2];
+  for (int i = 0; i < 8; ++i) {
+    acc[i][0] = vld1q_s32(out + 8 * i);
+    acc[i][1] = vld1q_s32(out + 8 * i + 4);
+  }
+  for (int64_t k = 0; k < k1; ++k) {
+    int8x16_t lhs_0 = vld1q_s8(lhs);
+    int8x16_t lhs_1 = vld1q_s8(lhs + 16);
+    int8x16_t rhs_0 = vld1q_s8(rhs);
+    int8x16_t rhs_1 = vld1q_s8(rhs + 16);
+    IREE_MMT4D_I8_DOT_ROW(acc, lhs_0, 0, 0, rhs_0, rhs_1)
+    IREE_MMT4D_I8_DOT_ROW(acc, lhs_0, 1, 1, rhs_0, rhs_1)
+    IREE_MMT4D_I8_DOT_ROW(acc, lhs_0, 2, 2, rhs_0, rhs_1)
+    IREE_MMT4D_I8_DOT_ROW(acc, lhs_0, 3, 3, rhs_0, rhs_1)
+    IREE_MMT4D_I8_DOT_ROW(acc, lhs_1, 4, 0, rhs_0, rhs_1)
+    IREE_MMT4D_I8_DOT_ROW(acc, lhs_1, 5, 1, rhs_0, rhs_1)
+    IREE_MMT4D_I8_DOT_ROW(acc, lhs_1, 6, 2, rhs_0, rhs_1)
+    IREE_MMT4D_I8_DOT_ROW(acc, lhs_1, 7, 3, rhs_0, rhs_1)
+    lhs += 32;
+    rhs += 32;
+  }
+  for (int i = 0; i < 8; ++i) {
+    vst1q_s32(out + 8 * i, acc[i][0]);
+    vst1q_s32(out + 8 * i + 4, acc[i][1]);
+  }
+}
+IREE_MMT4D_DEFINE_KERNEL(, iree_mmt4d_i8i8i32_8x8x4_arm_64_dotprod,
+                         iree_mmt4d_i8i8i32_8x8x4_arm_64_dotprod_tile, int8_t,
+                         int8_t, int32_t, 8, 8)
+
+#endif  // IREE_MMT4D_HAVE_ARM_64_DOTPROD
+
+//===----------------------------------------------------------------------===//
+// i32 += i8 * i8 with i8mm
+//===----------------------------------------------------------------------===//
+// smmla multiplies 2 consecutive 8-byte rows of lhs by 2 consecutive 8-byte
+// rows of rhs producing a 2x2 block of the output. acc[p][q] holds rows
+// [2p, 2p + 2) and columns [2q, 2q + 2) and is rearranged into rows at the
+// end.
+
+#if defined(IREE_MMT4D_HAVE_ARM_64_I8MM)
+
+static inline void iree_mmt4d_i8i8i32_8x8x8_arm_64_i8mm_tile(
+    const int8_t* IREE_RESTRICT lhs, const int8_t* IREE_RESTRICT rhs,
+    int32_t* IREE_RESTRICT out, int64_t k1) {
+  int32x4_t acc[4][4];
+  for (int p = 0; p < 4; ++p) {
+    for (int q = 0; q < 4; ++q) acc[p][q] = vdupq_n_s32(0);
+  }
+  for (int64_t k = 0; k < k1; ++k) {
+    int8x16_t rhs_pairs[4];
+    for (int q = 0; q < 4; ++q) rhs_pairs[q] = vld1q_s8(rhs + 16 * q);
+    for (int p = 0; p < 4; ++p) {
+      int8x16_t lhs_pair = vld1q_s8(lhs + 16 * p);
+      for (int q = 0; q < 4; ++q) {
+        acc[p][q] = vmmlaq_s32(acc[p][q], lhs_pair, rhs_pairs[q]);
+      }
+    }
+    lhs += 64;
+    rhs += 64;
+  }
+  for (int p = 0; p < 4; ++p) {
+    for (int half = 0; half < 2; ++half) {
+      int64x2_t block_0 = vreinterpretq_s64_s32(acc[p][2 * half]);
+      int64x2_t block_1 = vreinterpretq_s64_s32(acc[p][2 * half + 1]);
+      int32_t* row_0 = out + 16 * p + 4 * half;
+      int32_t* row_1 = row_0 + 8;
+      int32x4_t sum_0 = vreinterpretq_s32_s64(vzip1q_s64(block_0, block_1));
+      int32x4_t sum_1 = vreinterpretq_s32_s64(vzip2q_s64(block_0, block_1));
+      vst1q_s32(row_0, vaddq_s32(vld1q_s32(row_0), sum_0));
+      vst1q_s32(row_1, vaddq_s32(vld1q_s32(row_1), sum_1));
+    }
+  }
+}
+IREE_MMT4D_DEFINE_KERNEL(, iree_mmt4d_i8i8i32_8x8x8_arm_64_i8mm,
+                         iree_mmt4d_i8i8i32_8x8x8_arm_64_i8mm_tile, int8_t,
+                         int8_t, int32_t, 8, 8)
+
+#endif  // IREE_MMT4D_HAVE_ARM_64_I8MM
+
+//===----------------------------------------------------------------------===//
+// f32 += bf16 * bf16 with bf16
+//===----------------------------------------------------------------------===//
+// bfmmla is the bf16 counterpart of smmla: it multiplies 2 consecutive 4-value
+// rows of lhs by 2 consecutive 4-value rows of rhs producing a 2x2 f32 block
+// of the output laid out as in the i8mm kernel above.
+
+#if defined(IREE_MMT4D_HAVE_ARM_64_BF16)
+
+static inline bfloat16x8_t iree_mmt4d_load_8xbf16(const uint16_t* src) {
+  return vreinterpretq_bf16_u16(vld1q_u16(src));
+}
+
+static inline void iree_mmt4d_bf16bf16f32_8x8x4_arm_64_bf16_tile(
+    const uint16_t* IREE_RESTRICT lhs, const uint16_t* IREE_RESTRICT rhs,
+    float* IREE_RESTRICT out, int64_t k1) {
+  float32x4_t acc[4][4];
+  for (int p = 0; p < 4; ++p) {
+    for (int q = 0; q < 4; ++q) acc[p][q] = vdupq_n_f32(0.0f);
+  }
+  for (int64_t k = 0; k < k1; ++k) {
+    bfloat16x8_t rhs_pairs[4];
+    for (int q = 0; q < 4; ++q) {
+      rhs_pairs[q] = iree_mmt4d_load_8xbf16(rhs + 8 * q);
+    }
+    for (int p = 0; p < 4; ++p) {
+      bfloat16x8_t lhs_pair = iree_mmt4d_load_8xbf16(lhs + 8 * p);
+      for (int q = 0; q < 4; ++q) {
+        acc[p][q] = vbfmmlaq_f32(acc[p][q], lhs_pair, rhs_pairs[q]);
+      }
+    }
+    lhs += 32;
+    rhs += 32;
+  }
+  for (int p = 0; p < 4; ++p) {
+    for (int half = 0; half < 2; ++half) {
+      uint64x2_t block_0 = vreinterpretq_u64_f32(acc[p][2 * half]);
+      uint64x2_t block_1 = vreinterpretq_u64_f32(acc[p][2 * half + 1]);
+      float* row_0 = out + 16 * p + 4 * half;
+      float* row_1 = row_0 + 8;
+      float32x4_t sum_0 = vreinterpretq_f32_u64(vzip1q_u64(block_0, block_1));
+      float32x4_t sum_1 = vreinterpretq_f32_u64(vzip2q_u64(block_0, block_1));
+      vst1q_f32(row_0, vaddq_f32(vld1q_f32(row_0), sum_0));
+      vst1q_f32(row_1, vaddq_f32(vld1q_f32(row_1), sum_1));
+    }
+  }
+}
+IREE_MMT4D_DEFINE_KERNEL(, iree_mmt4d_bf16bf16f32_8x8x4_arm_64_bf16,
+                         iree_mmt4d_bf16bf16f32_8x8x4_arm_64_bf16_tile,
+                         uint16_t, uint16_t, float, 8, 8)
+
+#endif  // IREE_MMT4D_HAVE_ARM_64_BF16
+
+#endif  // IREE_MMT4D_HAVE_ARM_64
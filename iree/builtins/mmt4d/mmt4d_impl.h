@@ -0,0 +1,98 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_BUILTINS_MMT4D_MMT4D_IMPL_H_
+#define IREE_BUILTINS_MMT4D_MMT4D_IMPL_H_
+
+#include "iree/base/api.h"
+#include "iree/builtins/mmt4d/mmt4d.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Defines an mmt4d microkernel |kernel_name| that loops over the m1 and n1
+// dimensions of the params and calls |tile_fn| to accumulate each [M0, N0]
+// output tile over all k1:
+//   void tile_fn(const lhs_t* lhs, const rhs_t* rhs, out_t* out, int64_t k1);
+// |attrs| are applied to the microkernel, such as target attributes matching
+// those of |tile_fn|.
+#define IREE_MMT4D_DEFINE_KERNEL(attrs, kernel_name, tile_fn, lhs_t, rhs_t, \
+                                 out_t, M0, N0)                             \
+  attrs int kernel_name(void* params_ptr) {                                 \
+    const iree_mmt4d_params_t* params =                                     \
+        (const iree_mmt4d_params_t*)params_ptr;                             \
+    for (int64_t m1 = 0; m1 < params->m1; ++m1) {                           \
+      const lhs_t* lhs = (const lhs_t*)params->lhs + m1 * params->lhs_stride; \
+      out_t* out = (out_t*)params->out + m1 * params->out_stride;           \
+      for (int64_t n1 = 0; n1 < params->n1; ++n1) {                         \
+        const rhs_t* rhs =                                                  \
+            (const rhs_t*)params->rhs + n1 * params->rhs_stride;            \
+        tile_fn(lhs, rhs, out + n1 * (M0) * (N0), params->k1);              \
+      }                                                                     \
+    }                                                                       \
+    return 0;                                                               \
+  }
+
+// Portable implementations available on all architectures.
+int iree_mmt4d_bf16bf16f32_8x8x1_generic(void* params);
+int iree_mmt4d_bf16bf16f32_8x8x2_generic(void* params);
+int iree_mmt4d_bf16bf16f32_8x8x4_generic(void* params);
+int iree_mmt4d_f16f16f32_8x8x1_generic(void* params);
+int iree_mmt4d_f32f32f32_8x8x1_generic(void* params);
+int iree_mmt4d_i8i8i32_8x8x2_generic(void* params);
+int iree_mmt4d_i8i8i32_8x8x4_generic(void* params);
+int iree_mmt4d_i8i8i32_8x8x8_generic(void* params);
+
+#if defined(IREE_ARCH_ARM_64)
+
+// NEON is part of the arm64 baseline.
+#define IREE_MMT4D_HAVE_ARM_64 1
+int iree_mmt4d_bf16bf16f32_8x8x1_arm_64(void* params);
+int iree_mmt4d_f16f16f32_8x8x1_arm_64(void* params);
+int iree_mmt4d_f32f32f32_8x8x1_arm_64(void* params);
+
+// The dotprod and i8mm instructions are only available to the compiler when
+// the runtime itself is built for them (such as with -march=armv8.2-a+dotprod).
+#if defined(__ARM_FEATURE_DOTPROD)
+#define IREE_MMT4D_HAVE_ARM_64_DOTPROD 1
+int iree_mmt4d_i8i8i32_8x8x4_arm_64_dotprod(void* params);
+#endif  // __ARM_FEATURE_DOTPROD
+#if defined(__ARM_FEATURE_MATMUL_INT8)
+#define IREE_MMT4D_HAVE_ARM_64_I8MM 1
+int iree_mmt4d_i8i8i32_8x8x8_arm_64_i8mm(void* params);
+#endif  // __ARM_FEATURE_MATMUL_INT8
+#if defined(__ARM_FEATURE_BF16_VECTOR_ARITHMETIC)
+#define IREE_MMT4D_HAVE_ARM_64_BF16 1
+int iree_mmt4d_bf16bf16f32_8x8x4_arm_64_bf16(void* params);
+#endif  // __ARM_FEATURE_BF16_VECTOR_ARITHMETIC
+
+#elif defined(IREE_ARCH_X86_64) && \
+    (defined(IREE_COMPILER_GCC_COMPAT) || defined(IREE_COMPILER_MSVC))
+
+// x86-64 implementations are compiled with per-function target attributes
+// and selected at runtime based on the processor features.
+#define IREE_MMT4D_HAVE_X86_64 1
+int iree_mmt4d_bf16bf16f32_8x8x1_x86_64_avx2_fma(void* params);
+int iree_mmt4d_f16f16f32_8x8x1_x86_64_avx2_fma_f16c(void* params);
+int iree_mmt4d_f32f32f32_8x8x1_x86_64_avx2_fma(void* params);
+int iree_mmt4d_i8i8i32_8x8x2_x86_64_avx2(void* params);
+int iree_mmt4d_i8i8i32_8x8x2_x86_64_avx512vnni(void* params);
+
+// The bf16 vector types used by the AVX512-BF16 intrinsics are only
+// interchangeable with the integer vector types on GCC and clang.
+#if defined(IREE_COMPILER_GCC_COMPAT)
+#define IREE_MMT4D_HAVE_X86_64_AVX512BF16 1
+int iree_mmt4d_bf16bf16f32_8x8x2_x86_64_avx512bf16(void* params);
+#endif  // IREE_COMPILER_GCC_COMPAT
+
+#endif  // IREE_ARCH_*
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_BUILTINS_MMT4D_MMT4D_IMPL_H_
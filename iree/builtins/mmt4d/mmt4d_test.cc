@@ -0,0 +1,169 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/builtins/mmt4d/mmt4d.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/hal/local/executable_environment.h"
+#include "iree/testing/gtest.h"
+
+namespace {
+
+// Tile shape and element sizes parsed from a microkernel name such as
+// `iree_mmt4d_i8i8i32_8x8x4`.
+struct KernelShape {
+  int m0 = 0;
+  int n0 = 0;
+  int k0 = 0;
+  bool is_integer = false;
+  iree_host_size_t input_size = 0;
+};
+
+KernelShape ParseKernelShape(const std::string& name) {
+  KernelShape shape;
+  size_t types_end = name.rfind('_');
+  sscanf(name.c_str() + types_end + 1, "%dx%dx%d", &shape.m0, &shape.n0,
+         &shape.k0);
+  std::string types = name.substr(0, types_end);
+  if (types.find("i8i8i32") != std::string::npos) {
+    shape.is_integer = true;
+    shape.input_size = 1;
+  } else if (types.find("f16") != std::string::npos) {
+    shape.input_size = 2;
+  } else {
+    shape.input_size = 4;
+  }
+  return shape;
+}
+
+// Fills |data| with values that are exactly representable in the input type
+// and whose products sum exactly in the output type so that results of all
+// implementations are bitwise identical.
+void FillInputs(const std::string& name, const KernelShape& shape,
+                std::minstd_rand& engine, std::vector<uint8_t>& data) {
+  std::uniform_int_distribution<int> dist(-4, 4);
+  if (shape.input_size == 1) {
+    for (auto& value : data) value = (uint8_t)(int8_t)(dist(engine) * 31);
+  } else if (shape.input_size == 2) {
+    // Small integers in f16 (1 sign, 5 exponent, 10 mantissa bits) or bf16 (1
+    // sign, 8 exponent, 7 mantissa bits).
+    bool is_bf16 = name.find("bf16") != std::string::npos;
+    for (size_t i = 0; i < data.size() / 2; ++i) {
+      float f = (float)dist(engine);
+      uint32_t bits;
+      memcpy(&bits, &f, sizeof(bits));
+      uint16_t value;
+      if (is_bf16) {
+        value = (uint16_t)(bits >> 16);
+      } else if (f == 0.0f) {
+        value = 0;
+      } else {
+        uint32_t exp = ((bits >> 23) & 0xFF) - 127 + 15;
+        value = (uint16_t)(((bits >> 16) & 0x8000) | (exp << 10) |
+                           ((bits >> 13) & 0x3FF));
+      }
+      memcpy(&data[i * 2], &value, sizeof(value));
+    }
+  } else {
+    for (size_t i = 0; i < data.size() / 4; ++i) {
+      float value = (float)dist(engine);
+      memcpy(&data[i * 4], &value, sizeof(value));
+    }
+  }
+}
+
+// Returns the portable implementation of |name|, which is always listed last.
+iree_mmt4d_kernel_fn_t LookupReferenceKernel(const char* name) {
+  iree_host_size_t count = 0;
+  const iree_mmt4d_kernel_t* kernels = iree_mmt4d_kernels(&count);
+  iree_mmt4d_kernel_fn_t fn = NULL;
+  for (iree_host_size_t i = 0; i < count; ++i) {
+    if (strcmp(kernels[i].name, name) == 0) fn = kernels[i].fn;
+  }
+  return fn;
+}
+
+TEST(Mmt4dTest, KernelsAreSorted) {
+  iree_host_size_t count = 0;
+  const iree_mmt4d_kernel_t* kernels = iree_mmt4d_kernels(&count);
+  ASSERT_GT(count, 0);
+  for (iree_host_size_t i = 1; i < count; ++i) {
+    EXPECT_LE(strcmp(kernels[i - 1].name, kernels[i].name), 0);
+  }
+  // The last implementation of each name is portable.
+  for (iree_host_size_t i = 0; i < count; ++i) {
+    if (i + 1 == count || strcmp(kernels[i].name, kernels[i + 1].name) != 0) {
+      EXPECT_EQ(kernels[i].required_processor_data0, 0) << kernels[i].name;
+    }
+  }
+}
+
+TEST(Mmt4dTest, Lookup) {
+  EXPECT_NE(nullptr,
+            iree_mmt4d_kernel_lookup(
+                iree_make_cstring_view("iree_mmt4d_f32f32f32_8x8x1"), 0));
+  EXPECT_EQ(nullptr, iree_mmt4d_kernel_lookup(
+                         iree_make_cstring_view("iree_mmt4d_unknown"), 0));
+}
+
+// Compares every implementation supported by the host processor against the
+// portable implementation of the same microkernel.
+TEST(Mmt4dTest, MatchesReference) {
+  iree_hal_processor_v0_t processor;
+  iree_hal_processor_query(&processor);
+
+  const int64_t m1 = 3, n1 = 2, k1 = 5;
+  std::minstd_rand engine(0);
+  iree_host_size_t count = 0;
+  const iree_mmt4d_kernel_t* kernels = iree_mmt4d_kernels(&count);
+  for (iree_host_size_t i = 0; i < count; ++i) {
+    const iree_mmt4d_kernel_t& kernel = kernels[i];
+    if (!iree_all_bits_set(processor.data[0],
+                           kernel.required_processor_data0)) {
+      continue;
+    }
+    SCOPED_TRACE(kernel.name);
+    KernelShape shape = ParseKernelShape(kernel.name);
+    ASSERT_GT(shape.m0 * shape.n0 * shape.k0, 0);
+
+    // Pad the outer strides to check that they are honored.
+    int64_t lhs_stride = k1 * shape.m0 * shape.k0 + shape.k0;
+    int64_t rhs_stride = k1 * shape.n0 * shape.k0 + shape.k0;
+    int64_t out_stride = n1 * shape.m0 * shape.n0 + shape.n0;
+    std::vector<uint8_t> lhs(m1 * lhs_stride * shape.input_size);
+    std::vector<uint8_t> rhs(n1 * rhs_stride * shape.input_size);
+    FillInputs(kernel.name, shape, engine, lhs);
+    FillInputs(kernel.name, shape, engine, rhs);
+    std::vector<uint32_t> expected(m1 * out_stride);
+    for (size_t j = 0; j < expected.size(); ++j) {
+      if (shape.is_integer) {
+        expected[j] = (uint32_t)j;
+      } else {
+        float value = (float)j;
+        memcpy(&expected[j], &value, sizeof(value));
+      }
+    }
+    std::vector<uint32_t> actual = expected;
+
+    iree_mmt4d_params_t params = {
+        lhs.data(), lhs_stride, rhs.data(), rhs_stride, expected.data(),
+        out_stride, m1,         n1,         k1,
+    };
+    ASSERT_EQ(0, LookupReferenceKernel(kernel.name)(&params));
+    params.out = actual.data();
+    ASSERT_EQ(0, kernel.fn(&params));
+    EXPECT_EQ(expected, actual);
+  }
+}
+
+}  // namespace
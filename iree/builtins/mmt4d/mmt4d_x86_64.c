@@ -0,0 +1,222 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/builtins/mmt4d/mmt4d_impl.h"
+
+#if defined(IREE_MMT4D_HAVE_X86_64)
+
+#include <immintrin.h>
+#include <string.h>
+
+// Enables the instruction set |features| for a single function so that the
+// runtime can be built for the x86-64 baseline and select at runtime.
+#if defined(IREE_COMPILER_GCC_COMPAT)
+#define IREE_MMT4D_TARGET(features) __attribute__((target(features)))
+#else
+#define IREE_MMT4D_TARGET(features)
+#endif  // IREE_COMPILER_GCC_COMPAT
+
+//===----------------------------------------------------------------------===//
+// f32 += f32 * f32 with AVX2 and FMA
+//===----------------------------------------------------------------------===//
+// Each of the 8 rows of the output tile is held in a ymm register and updated
+// with a broadcast lhs value times the 8 rhs values of each k1.
+
+IREE_MMT4D_TARGET("avx2,fma")
+static inline void iree_mmt4d_f32f32f32_8x8x1_x86_64_avx2_fma_tile(
+    const float* IREE_RESTRICT lhs, const float* IREE_RESTRICT rhs,
+    float* IREE_RESTRICT out, int64_t k1) {
+  __m256 acc[8];
+  for (int i = 0; i < 8; ++i) acc[i] = _mm256_loadu_ps(out + 8 * i);
+  for (int64_t k = 0; k < k1; ++k) {
+    __m256 rhs_row = _mm256_loadu_ps(rhs);
+    for (int i = 0; i < 8; ++i) {
+      acc[i] = _mm256_fmadd_ps(_mm256_broadcast_ss(lhs + i), rhs_row, acc[i]);
+    }
+    lhs += 8;
+    rhs += 8;
+  }
+  for (int i = 0; i < 8; ++i) _mm256_storeu_ps(out + 8 * i, acc[i]);
+}
+IREE_MMT4D_DEFINE_KERNEL(IREE_MMT4D_TARGET("avx2,fma"),
+                         iree_mmt4d_f32f32f32_8x8x1_x86_64_avx2_fma,
+                         iree_mmt4d_f32f32f32_8x8x1_x86_64_avx2_fma_tile,
+                         float, float, float, 8, 8)
+
+//===----------------------------------------------------------------------===//
+// f32 += bf16 * bf16 with AVX2 and FMA
+//===----------------------------------------------------------------------===//
+// bf16 values are widened to f32 by shifting them into the high half of each
+// 32-bit lane.
+
+IREE_MMT4D_TARGET("avx2,fma")
+static inline __m256 iree_mmt4d_load_8xbf16_x86_64_avx2(const uint16_t* src) {
+  __m256i bits = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)src));
+  return _mm256_castsi256_ps(_mm256_slli_epi32(bits, 16));
+}
+
+IREE_MMT4D_TARGET("avx2,fma")
+static inline void iree_mmt4d_bf16bf16f32_8x8x1_x86_64_avx2_fma_tile(
+    const uint16_t* IREE_RESTRICT lhs, const uint16_t* IREE_RESTRICT rhs,
+    float* IREE_RESTRICT out, int64_t k1) {
+  __m256 acc[8];
+  for (int i = 0; i < 8; ++i) acc[i] = _mm256_loadu_ps(out + 8 * i);
+  float lhs_col[8];
+  for (int64_t k = 0; k < k1; ++k) {
+    _mm256_storeu_ps(lhs_col, iree_mmt4d_load_8xbf16_x86_64_avx2(lhs));
+    __m256 rhs_row = iree_mmt4d_load_8xbf16_x86_64_avx2(rhs);
+    for (int i = 0; i < 8; ++i) {
+      acc[i] =
+          _mm256_fmadd_ps(_mm256_broadcast_ss(lhs_col + i), rhs_row, acc[i]);
+    }
+    lhs += 8;
+    rhs += 8;
+  }
+  for (int i = 0; i < 8; ++i) _mm256_storeu_ps(out + 8 * i, acc[i]);
+}
+IREE_MMT4D_DEFINE_KERNEL(IREE_MMT4D_TARGET("avx2,fma"),
+                         iree_mmt4d_bf16bf16f32_8x8x1_x86_64_avx2_fma,
+                         iree_mmt4d_bf16bf16f32_8x8x1_x86_64_avx2_fma_tile,
+                         uint16_t, uint16_t, float, 8, 8)
+
+//===----------------------------------------------------------------------===//
+// f32 += f16 * f16 with AVX2, FMA, and F16C
+//===----------------------------------------------------------------------===//
+
+IREE_MMT4D_TARGET("avx2,fma,f16c")
+static inline void iree_mmt4d_f16f16f32_8x8x1_x86_64_avx2_fma_f16c_tile(
+    const uint16_t* IREE_RESTRICT lhs, const uint16_t* IREE_RESTRICT rhs,
+    float* IREE_RESTRICT out, int64_t k1) {
+  __m256 acc[8];
+  for (int i = 0; i < 8; ++i) acc[i] = _mm256_loadu_ps(out + 8 * i);
+  float lhs_col[8];
+  for (int64_t k = 0; k < k1; ++k) {
+    _mm256_storeu_ps(lhs_col,
+                     _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)lhs)));
+    __m256 rhs_row = _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)rhs));
+    for (int i = 0; i < 8; ++i) {
+      acc[i] =
+          _mm256_fmadd_ps(_mm256_broadcast_ss(lhs_col + i), rhs_row, acc[i]);
+    }
+    lhs += 8;
+    rhs += 8;
+  }
+  for (int i = 0; i < 8; ++i) _mm256_storeu_ps(out + 8 * i, acc[i]);
+}
+IREE_MMT4D_DEFINE_KERNEL(IREE_MMT4D_TARGET("avx2,fma,f16c"),
+                         iree_mmt4d_f16f16f32_8x8x1_x86_64_avx2_fma_f16c,
+                         iree_mmt4d_f16f16f32_8x8x1_x86_64_avx2_fma_f16c_tile,
+                         uint16_t, uint16_t, float, 8, 8)
+
+//===----------------------------------------------------------------------===//
+// i32 += i8 * i8 with AVX2 and AVX512-VNNI
+//===----------------------------------------------------------------------===//
+// The [8, 2] rhs tile of each k1 is sign-extended to 16 x i16 such that each
+// 32-bit lane holds the K0 pair of one column. Multiplying it with a lhs row
+// pair broadcast to all lanes and summing adjacent products yields the 8
+// partial sums of that output row; this maps directly to vpmaddwd on AVX2 and
+// to the fused vpdpwssd on AVX512-VNNI.
+
+static inline int32_t iree_mmt4d_i8_pair(const int8_t* src) {
+  return (int32_t)(((uint32_t)(uint16_t)(int16_t)src[1] << 16) |
+                   (uint32_t)(uint16_t)(int16_t)src[0]);
+}
+
+IREE_MMT4D_TARGET("avx2")
+static inline void iree_mmt4d_i8i8i32_8x8x2_x86_64_avx2_tile(
+    const int8_t* IREE_RESTRICT lhs, const int8_t* IREE_RESTRICT rhs,
+    int32_t* IREE_RESTRICT out, int64_t k1) {
+  __m256i acc[8];
+  for (int i = 0; i < 8; ++i) {
+    acc[i] = _mm256_loadu_si256((const __m256i*)(out + 8 * i));
+  }
+  for (int64_t k = 0; k < k1; ++k) {
+    __m256i rhs_tile =
+        _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)rhs));
+    for (int i = 0; i < 8; ++i) {
+      __m256i lhs_pair = _mm256_set1_epi32(iree_mmt4d_i8_pair(lhs + 2 * i));
+      acc[i] = _mm256_add_epi32(acc[i], _mm256_madd_epi16(rhs_tile, lhs_pair));
+    }
+    lhs += 16;
+    rhs += 16;
+  }
+  for (int i = 0; i < 8; ++i) {
+    _mm256_storeu_si256((__m256i*)(out + 8 * i), acc[i]);
+  }
+}
+IREE_MMT4D_DEFINE_KERNEL(IREE_MMT4D_TARGET("avx2"),
+                         iree_mmt4d_i8i8i32_8x8x2_x86_64_avx2,
+                         iree_mmt4d_i8i8i32_8x8x2_x86_64_avx2_tile, int8_t,
+                         int8_t, int32_t, 8, 8)
+
+IREE_MMT4D_TARGET("avx2,avx512vl,avx512vnni")
+static inline void iree_mmt4d_i8i8i32_8x8x2_x86_64_avx512vnni_tile(
+    const int8_t* IREE_RESTRICT lhs, const int8_t* IREE_RESTRICT rhs,
+    int32_t* IREE_RESTRICT out, int64_t k1) {
+  __m256i acc[8];
+  for (int i = 0; i < 8; ++i) {
+    acc[i] = _mm256_loadu_si256((const __m256i*)(out + 8 * i));
+  }
+  for (int64_t k = 0; k < k1; ++k) {
+    __m256i rhs_tile =
+        _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)rhs));
+    for (int i = 0; i < 8; ++i) {
+      __m256i lhs_pair = _mm256_set1_epi32(iree_mmt4d_i8_pair(lhs + 2 * i));
+      acc[i] = _mm256_dpwssd_epi32(acc[i], rhs_tile, lhs_pair);
+    }
+    lhs += 16;
+    rhs += 16;
+  }
+  for (int i = 0; i < 8; ++i) {
+    _mm256_storeu_si256((__m256i*)(out + 8 * i), acc[i]);
+  }
+}
+IREE_MMT4D_DEFINE_KERNEL(IREE_MMT4D_TARGET("avx2,avx512vl,avx512vnni"),
+                         iree_mmt4d_i8i8i32_8x8x2_x86_64_avx512vnni,
+                         iree_mmt4d_i8i8i32_8x8x2_x86_64_avx512vnni_tile,
+                         int8_t, int8_t, int32_t, 8, 8)
+
+//===----------------------------------------------------------------------===//
+// f32 += bf16 * bf16 with AVX512-BF16
+//===----------------------------------------------------------------------===//
+// Like the i8 kernels above each 32-bit lane of the [8, 2] rhs tile holds the
+// K0 pair of one column. vdpbf16ps multiplies it with a lhs row pair broadcast
+// to all lanes and accumulates both products into the f32 lane.
+
+#if defined(IREE_MMT4D_HAVE_X86_64_AVX512BF16)
+
+static inline int32_t iree_mmt4d_bf16_pair(const uint16_t* src) {
+  int32_t pair;
+  memcpy(&pair, src, sizeof(pair));
+  return pair;
+}
+
+IREE_MMT4D_TARGET("avx2,avx512vl,avx512bf16")
+static inline void iree_mmt4d_bf16bf16f32_8x8x2_x86_64_avx512bf16_tile(
+    const uint16_t* IREE_RESTRICT lhs, const uint16_t* IREE_RESTRICT rhs,
+    float* IREE_RESTRICT out, int64_t k1) {
+  __m256 acc[8];
+  for (int i = 0; i < 8; ++i) acc[i] = _mm256_loadu_ps(out + 8 * i);
+  for (int64_t k = 0; k < k1; ++k) {
+    __m256bh rhs_tile = (__m256bh)_mm256_loadu_si256((const __m256i*)rhs);
+    for (int i = 0; i < 8; ++i) {
+      __m256bh lhs_pair =
+          (__m256bh)_mm256_set1_epi32(iree_mmt4d_bf16_pair(lhs + 2 * i));
+      acc[i] = _mm256_dpbf16_ps(acc[i], rhs_tile, lhs_pair);
+    }
+    lhs += 16;
+    rhs += 16;
+  }
+  for (int i = 0; i < 8; ++i) _mm256_storeu_ps(out + 8 * i, acc[i]);
+}
+IREE_MMT4D_DEFINE_KERNEL(IREE_MMT4D_TARGET("avx2,avx512vl,avx512bf16"),
+                         iree_mmt4d_bf16bf16f32_8x8x2_x86_64_avx512bf16,
+                         iree_mmt4d_bf16bf16f32_8x8x2_x86_64_avx512bf16_tile,
+                         uint16_t, uint16_t, float, 8, 8)
+
+#endif  // IREE_MMT4D_HAVE_X86_64_AVX512BF16
+
+#endif  // IREE_MMT4D_HAVE_X86_64
@@ -5,8 +5,12 @@
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 #include "iree/compiler/Codegen/PassDetail.h"
 #include "iree/compiler/Codegen/Passes.h"
+#include "iree/compiler/Dialect/HAL/IR/HALOps.h"
+#include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
+#include "mlir/Dialect/Math/IR/Math.h"
 #include "mlir/Dialect/Math/Transforms/Approximation.h"
 #include "mlir/Dialect/Math/Transforms/Passes.h"
+#include "mlir/Dialect/X86Vector/X86VectorDialect.h"
 #include "mlir/Pass/Pass.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
 
@@ -21,17 +25,93 @@ static llvm::cl::opt<bool> clNativeMathPrecision(
         "Skip polynomial lowering for math op natively available on GPU"),
     llvm::cl::init(false));
 
+/// Command line to trade accuracy for speed in the approximations used.
+static llvm::cl::opt<bool> clFastMathApproximation(
+    "iree-codegen-fast-math-approximation",
+    llvm::cl::desc(
+        "Use faster, less accurate approximations when the target supports "
+        "them. On x86 targets with AVX2 math.rsqrt on vector<8xf32> is "
+        "lowered to the hardware reciprocal square root estimate refined "
+        "with one Newton-Raphson step (~2 ulp instead of correctly rounded)"),
+    llvm::cl::init(false));
+
 namespace {
 
+/// Computes f16 and bf16 math ops in f32 so that they use the same
+/// approximations as f32. The polynomial approximations only handle f32 and
+/// the result is rounded back to the narrow type, which hides the f32 error
+/// (a few ulp) in all but rare ties.
+template <typename OpTy>
+struct ExpandNarrowFloatMathOp : public OpRewritePattern<OpTy> {
+  using OpRewritePattern<OpTy>::OpRewritePattern;
+  LogicalResult matchAndRewrite(OpTy op,
+                                PatternRewriter &rewriter) const override {
+    Type type = op.getType();
+    Type elementType = getElementTypeOrSelf(type);
+    if (!elementType.isF16() && !elementType.isBF16()) return failure();
+    Type wideType = rewriter.getF32Type();
+    if (auto vectorType = type.dyn_cast<VectorType>()) {
+      wideType = VectorType::get(vectorType.getShape(), wideType);
+    }
+    SmallVector<Value> operands;
+    for (Value operand : op->getOperands()) {
+      operands.push_back(
+          rewriter.create<arith::ExtFOp>(op.getLoc(), wideType, operand));
+    }
+    Value result = rewriter.create<OpTy>(op.getLoc(), wideType, operands,
+                                         op->getAttrs());
+    rewriter.replaceOpWithNewOp<arith::TruncFOp>(op, type, result);
+    return success();
+  }
+};
+
+/// Returns true if the executable target of |op| has AVX2 enabled.
+static bool hasAVX2Feature(Operation *op) {
+  auto variantOp = op->getParentOfType<IREE::HAL::ExecutableVariantOp>();
+  if (!variantOp) return false;
+  auto config = variantOp.target().getConfiguration();
+  if (!config) return false;
+  auto cpuFeatures = config.getAs<StringAttr>("cpu_features");
+  if (!cpuFeatures) return false;
+  SmallVector<StringRef> features;
+  cpuFeatures.getValue().split(features, ',', /*MaxSplit=*/-1,
+                               /*KeepEmpty=*/false);
+  return llvm::is_contained(features, "+avx2");
+}
+
 /// math dialect elementry functions -> polynomial form.
 class PolynomialApproximationPass
     : public PolynomialApproximationPassBase<PolynomialApproximationPass> {
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<arith::ArithmeticDialect, x86vector::X86VectorDialect>();
+  }
+
   void runOnOperation() override {
-    RewritePatternSet mathPatterns(&getContext());
+    MLIRContext *context = &getContext();
+    {
+      RewritePatternSet expandPatterns(context);
+      expandPatterns.add<ExpandNarrowFloatMathOp<math::ErfOp>,
+                         ExpandNarrowFloatMathOp<math::ExpOp>,
+                         ExpandNarrowFloatMathOp<math::ExpM1Op>,
+                         ExpandNarrowFloatMathOp<math::LogOp>,
+                         ExpandNarrowFloatMathOp<math::Log1pOp>,
+                         ExpandNarrowFloatMathOp<math::Log2Op>,
+                         ExpandNarrowFloatMathOp<math::RsqrtOp>,
+                         ExpandNarrowFloatMathOp<math::TanhOp>>(context);
+      if (failed(applyPatternsAndFoldGreedily(getOperation(),
+                                              std::move(expandPatterns)))) {
+        return signalPassFailure();
+      }
+    }
+
+    RewritePatternSet mathPatterns(context);
     if (clNativeMathPrecision) {
-      mathPatterns.add<math::ErfPolynomialApproximation>(&getContext());
+      mathPatterns.add<math::ErfPolynomialApproximation>(context);
     } else {
-      populateMathPolynomialApproximationPatterns(mathPatterns);
+      MathPolynomialApproximationOptions options;
+      options.enableAvx2 =
+          clFastMathApproximation && hasAVX2Feature(getOperation());
+      populateMathPolynomialApproximationPatterns(mathPatterns, options);
     }
     if (failed(applyPatternsAndFoldGreedily(getOperation(),
                                             std::move(mathPatterns)))) {
@@ -0,0 +1,33 @@
+// RUN: iree-opt -split-input-file -iree-codegen-polynomial-approximation %s | FileCheck %s
+
+// CHECK-LABEL: func @exp_f32
+//   CHECK-NOT:   math.exp
+func @exp_f32(%arg0: vector<8xf32>) -> vector<8xf32> {
+  %0 = math.exp %arg0 : vector<8xf32>
+  return %0 : vector<8xf32>
+}
+
+// -----
+
+// CHECK-LABEL: func @exp_f16
+//  CHECK-SAME:   (%[[ARG0:.+]]: vector<8xf16>)
+//       CHECK:   %[[EXT:.+]] = arith.extf %[[ARG0]] : vector<8xf16> to vector<8xf32>
+//   CHECK-NOT:   math.exp
+//       CHECK:   %[[TRUNC:.+]] = arith.truncf %{{.+}} : vector<8xf32> to vector<8xf16>
+//       CHECK:   return %[[TRUNC]]
+func @exp_f16(%arg0: vector<8xf16>) -> vector<8xf16> {
+  %0 = math.exp %arg0 : vector<8xf16>
+  return %0 : vector<8xf16>
+}
+
+// -----
+
+// CHECK-LABEL: func @tanh_bf16
+//  CHECK-SAME:   (%[[ARG0:.+]]: bf16)
+//       CHECK:   arith.extf %[[ARG0]] : bf16 to f32
+//   CHECK-NOT:   math.tanh
+//       CHECK:   arith.truncf %{{.+}} : f32 to bf16
+func @tanh_bf16(%arg0: bf16) -> bf16 {
+  %0 = math.tanh %arg0 : bf16
+  return %0 : bf16
+}
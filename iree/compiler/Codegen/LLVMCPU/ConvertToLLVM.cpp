@@ -4,6 +4,7 @@
 // See https://llvm.org/LICENSE.txt for license information.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+#include "iree/compiler/Codegen/LLVMCPU/Mmt4dMicrokernels.h"
 #include "iree/compiler/Codegen/PassDetail.h"
 #include "iree/compiler/Codegen/Passes.h"
 #include "iree/compiler/Codegen/Utils/Utils.h"
@@ -41,6 +42,8 @@
 #include "mlir/Dialect/StandardOps/Transforms/Passes.h"
 #include "mlir/Dialect/Tosa/IR/TosaOps.h"
 #include "mlir/Dialect/Vector/IR/VectorOps.h"
+#include "mlir/Dialect/X86Vector/Transforms.h"
+#include "mlir/Dialect/X86Vector/X86VectorDialect.h"
 #include "mlir/IR/BuiltinAttributes.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/Pass/Pass.h"
@@ -613,12 +616,110 @@ class ConvertHALInterfaceBindingSubspanOp : public ConvertToLLVMPattern {
   }
 };
 
+/// Rewrites calls to mmt4d microkernel import declarations (see
+/// LLVMCPUMmt4dToMicrokernels) to calls through the executable import table.
+/// The memref operands are packed into an iree_mmt4d_params_t on the stack:
+///   typedef struct {
+///     const void* lhs; int64_t lhs_stride;
+///     const void* rhs; int64_t rhs_stride;
+///     void* out; int64_t out_stride;
+///     int64_t m1; int64_t n1; int64_t k1;
+///   } iree_mmt4d_params_t;
+///
+/// The parent LLVMFuncOp must be compatible with HALDispatchABI.
+class ConvertMmt4dMicrokernelCallOp : public ConvertOpToLLVMPattern<CallOp> {
+ public:
+  explicit ConvertMmt4dMicrokernelCallOp(MLIRContext *context,
+                                         LLVMTypeConverter &converter)
+      : ConvertOpToLLVMPattern<CallOp>(converter, /*benefit=*/100) {}
+
+  LogicalResult matchAndRewrite(
+      CallOp callOp, OpAdaptor adaptor,
+      ConversionPatternRewriter &rewriter) const override {
+    auto moduleOp = callOp->getParentOfType<ModuleOp>();
+    auto importsAttr =
+        moduleOp->getAttrOfType<ArrayAttr>(kExecutableImportsAttrName);
+    if (!importsAttr) return failure();
+    auto it =
+        llvm::find(importsAttr, rewriter.getStringAttr(callOp.getCallee()));
+    if (it == importsAttr.end()) return failure();
+    int64_t importOrdinal = std::distance(importsAttr.begin(), it);
+    if (callOp.getNumOperands() != 3 || callOp.getNumResults() != 0) {
+      return rewriter.notifyMatchFailure(callOp,
+                                         "unexpected microkernel signature");
+    }
+
+    auto llvmFuncOp = callOp->getParentOfType<LLVM::LLVMFuncOp>();
+    if (!llvmFuncOp) return failure();
+    HALDispatchABI abi(llvmFuncOp, getTypeConverter());
+    Location loc = callOp.getLoc();
+
+    // Each memref is passed as a pointer to its first element and the
+    // element distance between two consecutive outer rows.
+    auto i8PtrType = LLVM::LLVMPointerType::get(rewriter.getIntegerType(8));
+    auto i64Type = rewriter.getI64Type();
+    auto toI64 = [&](Value value) -> Value {
+      if (value.getType() == i64Type) return value;
+      return rewriter.create<LLVM::SExtOp>(loc, i64Type, value);
+    };
+    SmallVector<Value> fieldValues;
+    for (Value operand : adaptor.getOperands()) {
+      MemRefDescriptor desc(operand);
+      Value basePtr = rewriter.create<LLVM::GEPOp>(
+          loc, desc.getElementPtrType(), desc.alignedPtr(rewriter, loc),
+          ValueRange{desc.offset(rewriter, loc)});
+      fieldValues.push_back(
+          rewriter.create<LLVM::BitcastOp>(loc, i8PtrType, basePtr));
+      fieldValues.push_back(toI64(desc.stride(rewriter, loc, 0)));
+    }
+    MemRefDescriptor lhsDesc(adaptor.getOperands()[0]);
+    MemRefDescriptor rhsDesc(adaptor.getOperands()[1]);
+    fieldValues.push_back(toI64(lhsDesc.size(rewriter, loc, 0)));  // m1
+    fieldValues.push_back(toI64(rhsDesc.size(rewriter, loc, 0)));  // n1
+    fieldValues.push_back(toI64(lhsDesc.size(rewriter, loc, 1)));  // k1
+
+    SmallVector<Type> fieldTypes;
+    for (Value value : fieldValues) fieldTypes.push_back(value.getType());
+    auto paramsType =
+        LLVM::LLVMStructType::getLiteral(rewriter.getContext(), fieldTypes);
+    Value paramsValue = rewriter.create<LLVM::UndefOp>(loc, paramsType);
+    for (auto field : llvm::enumerate(fieldValues)) {
+      paramsValue = rewriter.create<LLVM::InsertValueOp>(
+          loc, paramsValue, field.value(),
+          rewriter.getI64ArrayAttr(field.index()));
+    }
+
+    // Allocate the params in the entry block so that calls within loops reuse
+    // the same stack slot.
+    Value paramsPtr;
+    {
+      OpBuilder::InsertionGuard guard(rewriter);
+      rewriter.setInsertionPointToStart(&llvmFuncOp.getBody().front());
+      Value one = rewriter.create<LLVM::ConstantOp>(
+          loc, i64Type, rewriter.getI64IntegerAttr(1));
+      paramsPtr = rewriter.create<LLVM::AllocaOp>(
+          loc, LLVM::LLVMPointerType::get(paramsType), one,
+          /*alignment=*/0);
+    }
+    rewriter.create<LLVM::StoreOp>(loc, paramsValue, paramsPtr);
+    Value paramsI8Ptr =
+        rewriter.create<LLVM::BitcastOp>(loc, i8PtrType, paramsPtr);
+
+    // The microkernels cannot fail once the import has been resolved at load
+    // time so the result is ignored.
+    abi.callImport(loc, importOrdinal, paramsI8Ptr, rewriter);
+    rewriter.eraseOp(callOp);
+    return success();
+  }
+};
+
 class ConvertToLLVMPass : public ConvertToLLVMBase<ConvertToLLVMPass> {
  public:
   ConvertToLLVMPass() = default;
   ConvertToLLVMPass(const ConvertToLLVMPass &pass) {}
   void getDependentDialects(DialectRegistry &registry) const override {
-    registry.insert<LLVM::LLVMDialect, arm_neon::ArmNeonDialect>();
+    registry.insert<LLVM::LLVMDialect, arm_neon::ArmNeonDialect,
+                    x86vector::X86VectorDialect>();
   }
 
   void runOnOperation() override;
@@ -667,6 +768,26 @@ void ConvertToLLVMPass::runOnOperation() {
   module->setAttr(LLVM::LLVMDialect::getDataLayoutAttrName(),
                   StringAttr::get(module->getContext(), dataLayoutStr));
 
+  // Assign import ordinals to the microkernels declared in the module. The
+  // target backends register the imports in the same order.
+  SmallVector<FuncOp> importDecls;
+  for (auto funcOp : module.getOps<FuncOp>()) {
+    if (funcOp->hasAttr(kExecutableImportAttrName)) {
+      importDecls.push_back(funcOp);
+    }
+  }
+  llvm::sort(importDecls, [](FuncOp lhs, FuncOp rhs) {
+    return lhs.getName() < rhs.getName();
+  });
+  if (!importDecls.empty()) {
+    SmallVector<Attribute> importNames;
+    for (auto funcOp : importDecls) {
+      importNames.push_back(StringAttr::get(&getContext(), funcOp.getName()));
+    }
+    module->setAttr(kExecutableImportsAttrName,
+                    ArrayAttr::get(&getContext(), importNames));
+  }
+
   // Run Vector -> Vector transformations ahead of conversion to LLVM.
   {
     RewritePatternSet patterns(&getContext());
@@ -722,6 +843,7 @@ void ConvertToLLVMPass::runOnOperation() {
   populateVectorToSCFConversionPatterns(patterns);
   populateVectorToLLVMMatrixConversionPatterns(converter, patterns);
   populateVectorToLLVMConversionPatterns(converter, patterns);
+  populateX86VectorLegalizeForLLVMExportPatterns(converter, patterns);
   populateLinalgToLLVMConversionPatterns(converter, patterns);
   populateReconcileUnrealizedCastsPatterns(patterns);
 
@@ -732,7 +854,8 @@ void ConvertToLLVMPass::runOnOperation() {
     ConvertHALInterfaceWorkgroupSizeOp,
     ConvertHALInterfaceWorkgroupCountOp,
     ConvertHALInterfaceLoadConstant,
-    ConvertHALInterfaceBindingSubspanOp
+    ConvertHALInterfaceBindingSubspanOp,
+    ConvertMmt4dMicrokernelCallOp
   >(&getContext(), converter);
   // clang-format on
 
@@ -742,6 +865,7 @@ void ConvertToLLVMPass::runOnOperation() {
                            IREE::Util::UtilDialect, IREE::HAL::HALDialect,
                            math::MathDialect, tosa::TosaDialect>();
   target.addIllegalOp<UnrealizedConversionCastOp>();
+  configureX86VectorLegalizeForExportTarget(target);
 
   // Don't apply patterns to private function (e.g num_workgroups func).
   target.addDynamicallyLegalOp<FuncOp>([&](FuncOp funcOp) {
@@ -764,6 +888,9 @@ void ConvertToLLVMPass::runOnOperation() {
     return;
   }
 
+  // All calls to imports have been rewritten to go through the import table.
+  for (auto funcOp : importDecls) funcOp.erase();
+
   // Post conversion patterns.
   {
     RewritePatternSet postPatterns(&getContext());
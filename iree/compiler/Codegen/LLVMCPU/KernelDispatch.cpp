@@ -7,12 +7,14 @@
 #include "iree/compiler/Codegen/LLVMCPU/KernelDispatch.h"
 
 #include "iree-dialects/Dialect/LinalgExt/IR/LinalgExtOps.h"
+#include "iree/compiler/Codegen/LLVMCPU/Mmt4dMicrokernels.h"
 #include "iree/compiler/Codegen/Transforms/Transforms.h"
 #include "iree/compiler/Codegen/Utils/MarkerUtils.h"
 #include "iree/compiler/Codegen/Utils/Utils.h"
 #include "iree/compiler/Dialect/Flow/IR/FlowOps.h"
 #include "llvm/ADT/TypeSwitch.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FormatVariadic.h"
 #include "llvm/Support/TargetSelect.h"
 #include "mlir/Dialect/Linalg/IR/Linalg.h"
 #include "mlir/Dialect/Linalg/IR/LinalgInterfaces.h"
@@ -21,6 +23,8 @@
 #include "mlir/Dialect/StandardOps/IR/Ops.h"
 #include "mlir/Dialect/Utils/StaticValueUtils.h"
 #include "mlir/IR/Matchers.h"
+#include "mlir/Parser.h"
+#include "mlir/Support/FileUtilities.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
 
 namespace mlir {
@@ -56,12 +60,41 @@ static llvm::cl::list<int> mmt4dVectorSizes(
     llvm::cl::desc("linalg.mmt4d vector tile size"), llvm::cl::ZeroOrMore,
     llvm::cl::MiscFlags::CommaSeparated);
 
+// Microkernels are imported from the runtime when the executable is loaded and
+// need a loader that resolves imports (embedded or system libraries). Static
+// libraries cannot import and fail to load executables using them.
+static llvm::cl::opt<bool> clEnableMmt4dMicrokernels(
+    "iree-codegen-llvmcpu-enable-mmt4d-microkernels",
+    llvm::cl::desc("lower linalg.mmt4d ops with supported tile shapes to calls "
+                   "to runtime microkernels"),
+    llvm::cl::init(false));
+
 static llvm::cl::opt<int> defaultWorkgroupTileSize(
     "iree-codegen-llvm-generic-ops-workgroup-size",
     llvm::cl::desc(
         "linalg.generic and linalg.indexed_generic workgroup tile size"),
     llvm::cl::init(64));
 
+static llvm::cl::opt<bool> clSymbolicBatchDim(
+    "iree-codegen-llvmcpu-symbolic-batch-dim",
+    llvm::cl::desc("distribute the outermost loop with a workload per "
+                   "workgroup of 1 when it is the only dynamic distributed "
+                   "loop so that the tiles processed by each workgroup keep "
+                   "static shapes"),
+    llvm::cl::init(false));
+
+static llvm::cl::opt<std::string> clTuningDatabase(
+    "iree-codegen-llvmcpu-tuning-database",
+    llvm::cl::desc("path to a tuning database of compilation info keyed by "
+                   "target triple and dispatch signature"),
+    llvm::cl::init(""));
+
+static llvm::cl::opt<bool> clPrintTuningKeys(
+    "iree-codegen-llvmcpu-print-tuning-keys",
+    llvm::cl::desc("emit a remark with the tuning database key and the "
+                   "selected compilation info of each root op"),
+    llvm::cl::init(false));
+
 using IREE::Codegen::DispatchLoweringPassPipeline;
 
 static bool isVMVX(FuncOp entryPointFn) {
@@ -88,6 +121,23 @@ static Optional<int64_t> getNativeVectorSizeInBytes(FuncOp entryPointFn) {
   return nativeVectorSizeVal;
 }
 
+/// Looks for the `l2_cache_tiers` attribute in the hal.executable.variant op
+/// and returns the L2 cache sizes in KiB it lists.
+static SmallVector<int64_t> getL2CacheTiers(FuncOp entryPointFn) {
+  auto variantOp =
+      entryPointFn->getParentOfType<IREE::HAL::ExecutableVariantOp>();
+  if (!variantOp) return {};
+  IREE::HAL::ExecutableTargetAttr targetAttr = variantOp.target();
+  if (!targetAttr) return {};
+  auto config = targetAttr.getConfiguration();
+  if (!config) return {};
+  auto l2CacheTiersAttr = config.getAs<ArrayAttr>("l2_cache_tiers");
+  if (!l2CacheTiersAttr) return {};
+  return llvm::to_vector(llvm::map_range(
+      l2CacheTiersAttr.getAsValueRange<IntegerAttr>(),
+      [](APInt value) { return value.getSExtValue(); }));
+}
+
 /// For a given `shapedType` or (`byteWidth` of element type) return the number
 /// of elements that correspond to the native vector size. Returns 1 as the
 /// fallback.
@@ -150,11 +200,29 @@ static SmallVector<int64_t> getDefaultWorkloadPerWorkgroup(
     return (ofr ? getConstantIntValue(ofr) : llvm::None);
   };
   auto ceilFn = [](int64_t a, int64_t b) { return (a + b - 1) / b; };
+  auto isStaticLoop = [&](const LoopTilingAndDistributionInfo &tiledLoop) {
+    return getStaticValue(tiledLoop.untiledLowerBound) &&
+           getStaticValue(tiledLoop.untiledUpperBound);
+  };
+
+  // A dynamic outermost loop with all inner loops static is treated as a
+  // batch dimension: it is only distributed across workgroups, one iteration
+  // each, so the code generated for each workgroup is specialized to the
+  // static inner shapes and serves all batch sizes.
+  bool isSymbolicBatch =
+      clSymbolicBatchDim && tiledLoops.size() > 1 &&
+      !isStaticLoop(tiledLoops.front()) &&
+      llvm::all_of(tiledLoops.drop_front(), isStaticLoop);
 
   for (auto tiledLoop : enumerate(tiledLoops)) {
     Optional<int64_t> lb = getStaticValue(tiledLoop.value().untiledLowerBound);
     Optional<int64_t> ub = getStaticValue(tiledLoop.value().untiledUpperBound);
     unsigned dim = tiledLoop.value().processorDistributionDim;
+    if (isSymbolicBatch && tiledLoop.index() == 0) {
+      workloadPerWorkgroup[dim] = 1;
+      workload[dim] = ShapedType::kDynamicSize;
+      continue;
+    }
     if (!lb || !ub) {
       workloadPerWorkgroup[dim] = defaultWorkgroupTileSize;
       workload[dim] = ShapedType::kDynamicSize;
@@ -377,6 +445,44 @@ static LogicalResult setARMRootConfig(FuncOp entryPointFn,
   return success();
 }
 
+static LogicalResult setRISCVRootConfig(FuncOp entryPointFn,
+                                        linalg::ContractionOpInterface op,
+                                        ArrayRef<int64_t> flowTileSizes,
+                                        int vectorSize) {
+  // Hardcoded tile sizes, where v is the native vector size derived from VLEN.
+  // RVV instructions operate on groups of LMUL vector registers; an 8 x 2v
+  // accumulator tile is held in 8 register groups of LMUL=2 (16 of the 32
+  // vector registers) and updated with one vector-scalar FMA per LHS element
+  // along K, leaving the remaining registers for RHS rows.
+  // L1 tile sizes are {1, ..., 16, 4v, 4v}.
+  // Vector tile sizes are {1, ..., 8, 2v, 1}
+  SmallVector<int64_t> l1TileSizes, vectorTileSizes;
+  int64_t nLoops = cast<linalg::LinalgOp>(op.getOperation()).getNumLoops();
+  l1TileSizes.append(nLoops - 3, 1);
+  l1TileSizes.push_back(getMaxTileSize(0, flowTileSizes[nLoops - 3], 16, 8));
+  l1TileSizes.push_back(getMaxTileSize(0, flowTileSizes[nLoops - 2],
+                                       4 * vectorSize, 2 * vectorSize));
+  vectorTileSizes.append(nLoops - 3, 1);
+  vectorTileSizes.push_back(8);
+  vectorTileSizes.push_back(2 * vectorSize);
+
+  // L1/vector tile size for k dimensions.
+  auto lhsShapedType = op.lhs().getType().cast<ShapedType>();
+  int64_t K = lhsShapedType.getShape().back();
+  l1TileSizes.push_back(getMaxTileSize(0, K, 4 * vectorSize, 1));
+  vectorTileSizes.push_back(1);
+  TileSizesListType tileSizes;
+  tileSizes.push_back({});  // Empty here since there is nothing to do in first
+                            // level tiling.
+  tileSizes.push_back(l1TileSizes);
+  tileSizes.push_back(vectorTileSizes);
+  auto config = IREE::Codegen::LoweringConfigAttr::get(
+      entryPointFn.getContext(), tileSizes, vectorTileSizes);
+  setLoweringConfig(op, config);
+
+  return success();
+}
+
 /// Sets the lowering configuration for dispatch region with root op that
 /// implements the contraction operation interface.
 static LogicalResult setRootConfig(
@@ -440,6 +546,12 @@ static LogicalResult setRootConfig(
         return failure();
       }
     }
+  } else if (isRISCV(entryPointFn)) {
+    passPipeline = DispatchLoweringPassPipeline::CPUTileFuseAndVectorize;
+    if (failed(setRISCVRootConfig(entryPointFn, contractionOp, flowTileSizes,
+                                  vectorSize))) {
+      return failure();
+    }
   } else {
     // Fall back to ARM configurations.
     passPipeline = DispatchLoweringPassPipeline::CPUTileFuseAndVectorize;
@@ -501,6 +613,20 @@ static LogicalResult setRootConfig(
     return {1, 1, 1, M0, N0, K0};
   };
 
+  // Microkernels process whole workgroup tiles so only the first level of
+  // tiling is used.
+  if (clEnableMmt4dMicrokernels && !isVMVX(entryPointFn)) {
+    auto variantOp =
+        entryPointFn->getParentOfType<IREE::HAL::ExecutableVariantOp>();
+    if (getMmt4dMicrokernelName(mmt4dOp, variantOp)) {
+      TileSizesListType tileSizes = {getWorkgroupTileSizes()};
+      return setOpConfigAndEntryPointFnTranslation(
+          entryPointFn, mmt4dOp, tileSizes,
+          /*nativeVectorSize=*/ArrayRef<int64_t>{},
+          DispatchLoweringPassPipeline::CPUMmt4dMicrokernels);
+    }
+  }
+
   SmallVector<int64_t> nativeVectorSize = getVectorSizes();
 
   TileSizesListType tileSizes = {getWorkgroupTileSizes(), getL1TileSizes(),
@@ -635,6 +761,12 @@ static LogicalResult setRootConfigImpl(
 static LogicalResult setRootConfig(
     FuncOp entryPointFn, ArrayRef<Operation *> computeOps,
     ArrayRef<LoopTilingAndDistributionInfo> tiledLoops) {
+  // Reductions fused with their broadcasting consumers are only distributed
+  // along the loops left parallel by the reductions. None of the root
+  // configurations handle that form, so use the default configuration based
+  // on the distributed loops.
+  if (getReductionFusedWithConsumers(computeOps)) return success();
+
   Operation *rootOp = nullptr;
   for (auto computeOp : computeOps) {
     if (failed(setRootConfigImpl(entryPointFn, computeOp, tiledLoops))) {
@@ -677,10 +809,274 @@ static LogicalResult setRootConfig(
   return success();
 }
 
+//===----------------------------------------------------------------------===//
+// Tuning database
+//===----------------------------------------------------------------------===//
+
+/// Returns the key used to look up `linalgOp` in the tuning database. This is
+/// the op name followed by the untiled shapes of its inputs and results, e.g.
+/// `linalg.matmul:128x256xf32,256x512xf32->128x512xf32`.
+static std::string getTuningKey(linalg::LinalgOp linalgOp) {
+  std::string key;
+  llvm::raw_string_ostream os(key);
+  auto printShape = [&](ArrayRef<int64_t> shape, Type type) {
+    for (int64_t dim : shape) {
+      if (ShapedType::isDynamic(dim)) {
+        os << "?";
+      } else {
+        os << dim;
+      }
+      os << "x";
+    }
+    os << getElementTypeOrSelf(type);
+  };
+  os << linalgOp->getName() << ":";
+  llvm::interleave(
+      linalgOp.inputs(), os,
+      [&](Value input) { printShape(getUntiledShape(input), input.getType()); },
+      ",");
+  os << "->";
+  llvm::interleave(
+      llvm::seq<unsigned>(0, linalgOp.getNumOutputs()), os,
+      [&](unsigned i) {
+        printShape(getUntiledResultShape(linalgOp, i),
+                   linalgOp.outputs()[i].getType());
+      },
+      ",");
+  return os.str();
+}
+
+/// Loads the tuning database named by `clTuningDatabase`, if any. The database
+/// is a dictionary attribute mapping target triples to dictionaries from
+/// tuning keys (see `getTuningKey`) to `#iree_codegen.compilation.info`:
+///
+/// ```
+/// {
+///   "x86_64-unknown-linux-gnu" = {
+///     "linalg.matmul:128x256xf32,256x512xf32->128x512xf32" =
+///         #iree_codegen.compilation.info<...>
+///   }
+/// }
+/// ```
+static FailureOr<DictionaryAttr> loadTuningDatabase(ModuleOp moduleOp) {
+  if (clTuningDatabase.empty()) return DictionaryAttr();
+  std::string errorMessage;
+  std::unique_ptr<llvm::MemoryBuffer> file =
+      openInputFile(clTuningDatabase, &errorMessage);
+  if (!file) {
+    moduleOp.emitError() << "failed to open tuning database '"
+                         << clTuningDatabase << "': " << errorMessage;
+    return failure();
+  }
+  auto database = parseAttribute(file->getBuffer(), moduleOp.getContext())
+                      .dyn_cast_or_null<DictionaryAttr>();
+  if (!database) {
+    moduleOp.emitError() << "tuning database '" << clTuningDatabase
+                         << "' is not a dictionary attribute";
+    return failure();
+  }
+  return database;
+}
+
+/// Returns the tuning database entries for the target of `entryPointFn`.
+static DictionaryAttr getTargetTuningEntries(FuncOp entryPointFn,
+                                             DictionaryAttr tuningDatabase) {
+  if (!tuningDatabase) return nullptr;
+  auto variantOp =
+      entryPointFn->getParentOfType<IREE::HAL::ExecutableVariantOp>();
+  Optional<llvm::Triple> triple = getTargetTriple(variantOp);
+  if (!triple) return nullptr;
+  return tuningDatabase.getAs<DictionaryAttr>(triple->str());
+}
+
+/// Sets the compilation info of the first compute op with an entry in
+/// `tuningEntries` as if it had been preset on the op.
+static void setTunedCompilationInfo(ArrayRef<Operation *> computeOps,
+                                    DictionaryAttr tuningEntries) {
+  for (auto computeOp : computeOps) {
+    auto linalgOp = dyn_cast<linalg::LinalgOp>(computeOp);
+    if (!linalgOp || isa<linalg::FillOp>(computeOp)) continue;
+    auto compilationInfo =
+        tuningEntries.getAs<IREE::Codegen::CompilationInfoAttr>(
+            getTuningKey(linalgOp));
+    if (!compilationInfo) continue;
+    setCompilationInfo(computeOp, compilationInfo);
+    return;
+  }
+}
+
+/// Emits a remark on the root op of `entryPointFn` with its tuning key and the
+/// compilation info selected for it. This is the format consumed by
+/// `build_tools/benchmarks/tune_llvmcpu_tile_sizes.py`.
+static void printTuningKey(FuncOp entryPointFn,
+                           ArrayRef<Operation *> computeOps) {
+  auto entryPointOp = getEntryPoint(entryPointFn);
+  IREE::Codegen::TranslationInfoAttr translationInfo =
+      getTranslationInfo(entryPointOp);
+  if (!translationInfo) return;
+  for (auto computeOp : computeOps) {
+    auto linalgOp = dyn_cast<linalg::LinalgOp>(computeOp);
+    if (!linalgOp) continue;
+    IREE::Codegen::LoweringConfigAttr loweringConfig =
+        getLoweringConfig(computeOp);
+    if (!loweringConfig) continue;
+    Builder builder(computeOp->getContext());
+    auto compilationInfo = IREE::Codegen::CompilationInfoAttr::get(
+        computeOp->getContext(), loweringConfig, translationInfo,
+        builder.getI64ArrayAttr(getWorkgroupSize(entryPointOp)));
+    computeOp->emitRemark() << "tuning key \"" << getTuningKey(linalgOp)
+                            << "\" = " << compilationInfo;
+    return;
+  }
+}
+
+/// Returns the L1 tile sizes of the contraction `op` grown from `l1TileSizes`
+/// by doubling the M, N and K tiles for as long as the operand tiles fit in
+/// `cacheSizeInBytes`. Tiles stay within and divide the workgroup tiles
+/// `flowTileSizes` (and K) such that no partial tiles are introduced.
+static SmallVector<int64_t> getCacheTierL1TileSizes(
+    linalg::ContractionOpInterface op, ArrayRef<int64_t> flowTileSizes,
+    ArrayRef<int64_t> l1TileSizes, int64_t cacheSizeInBytes) {
+  auto getByteWidth = [](Value value) {
+    return IREE::Util::getRoundedElementByteWidth(
+        getElementTypeOrSelf(value.getType()));
+  };
+  int64_t lhsByteWidth = getByteWidth(op.lhs());
+  int64_t rhsByteWidth = getByteWidth(op.rhs());
+  int64_t accByteWidth = getByteWidth(op->getResult(0));
+  int64_t nLoops = l1TileSizes.size();
+  auto getFootprint = [&](ArrayRef<int64_t> tileSizes) {
+    int64_t M = tileSizes[nLoops - 3];
+    int64_t N = tileSizes[nLoops - 2];
+    int64_t K = tileSizes[nLoops - 1];
+    return lhsByteWidth * M * K + rhsByteWidth * K * N + accByteWidth * M * N;
+  };
+
+  SmallVector<int64_t> upperBounds(flowTileSizes.begin(), flowTileSizes.end());
+  upperBounds.back() = op.lhs().getType().cast<ShapedType>().getShape().back();
+  SmallVector<int64_t> tileSizes(l1TileSizes.begin(), l1TileSizes.end());
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (int64_t i = nLoops - 3; i < nLoops; ++i) {
+      int64_t ub = upperBounds[i];
+      int64_t tileSize = tileSizes[i] * 2;
+      if (!tileSize || ub == ShapedType::kDynamicSize || tileSize > ub ||
+          ub % tileSize != 0) {
+        continue;
+      }
+      SmallVector<int64_t> candidate = tileSizes;
+      candidate[i] = tileSize;
+      if (getFootprint(candidate) > cacheSizeInBytes) continue;
+      tileSizes = std::move(candidate);
+      changed = true;
+    }
+  }
+  return tileSizes;
+}
+
+/// Clones `entryPointFn` for each L2 cache tier of the target such that the
+/// runtime can select tile sizes matching the cache of the processor when the
+/// executable is loaded. Only the L1 tiles of contraction ops lowered with
+/// CPUTileFuseAndVectorize are specialized: the workgroup count is computed
+/// on the host from the workload per workgroup and must be shared by all
+/// tiers. The clones are named `{entry point}_cache_tier{index}` and their
+/// entry points are marked with `kCacheTierAttrName`.
+static LogicalResult createCacheTierEntryPoints(
+    FuncOp entryPointFn, ArrayRef<Operation *> computeOps) {
+  SmallVector<int64_t> l2CacheTiers = getL2CacheTiers(entryPointFn);
+  if (l2CacheTiers.empty()) return success();
+  auto entryPointOp = getEntryPoint(entryPointFn);
+  IREE::Codegen::TranslationInfoAttr translationInfo =
+      getTranslationInfo(entryPointOp);
+  if (!translationInfo ||
+      translationInfo.getDispatchLoweringPassPipeline() !=
+          DispatchLoweringPassPipeline::CPUTileFuseAndVectorize) {
+    return success();
+  }
+  auto rootOpIt = llvm::find_if(computeOps, [](Operation *computeOp) {
+    return isa<linalg::ContractionOpInterface>(computeOp) &&
+           getLoweringConfig(computeOp);
+  });
+  if (rootOpIt == computeOps.end()) return success();
+  unsigned rootOpIndex = std::distance(computeOps.begin(), rootOpIt);
+  IREE::Codegen::LoweringConfigAttr loweringConfig =
+      getLoweringConfig(*rootOpIt);
+  TileSizesListType tileSizes = loweringConfig.getTileSizeVals();
+  if (tileSizes.size() != static_cast<unsigned>(TilingLevel::NumTileLevels)) {
+    return success();
+  }
+  SmallVector<int64_t> flowTileSizes = getDistributedTileSizes(
+      cast<IREE::Flow::PartitionableLoopsInterface>(*rootOpIt),
+      translationInfo.getWorkloadPerWorkgroupVals());
+
+  auto variantOp =
+      entryPointOp->getParentOfType<IREE::HAL::ExecutableVariantOp>();
+  int64_t nextOrdinal = 0;
+  for (auto op :
+       variantOp.getBlock().getOps<IREE::HAL::ExecutableEntryPointOp>()) {
+    if (IntegerAttr ordinalAttr = op.ordinalAttr()) {
+      nextOrdinal = std::max(nextOrdinal, ordinalAttr.getInt() + 1);
+    }
+  }
+
+  OpBuilder entryPointBuilder(entryPointOp);
+  entryPointBuilder.setInsertionPointAfter(entryPointOp);
+  OpBuilder funcBuilder(entryPointFn);
+  funcBuilder.setInsertionPointAfter(entryPointFn);
+  unsigned l1Level = static_cast<unsigned>(TilingLevel::L1Tiles);
+  for (auto l2CacheTier : llvm::enumerate(l2CacheTiers)) {
+    // Half of the cache is left for the other operands of the dispatch and
+    // the data of the other cores sharing it.
+    TileSizesListType tierTileSizes = tileSizes;
+    tierTileSizes[l1Level] = getCacheTierL1TileSizes(
+        cast<linalg::ContractionOpInterface>(*rootOpIt), flowTileSizes,
+        tileSizes[l1Level], l2CacheTier.value() * 1024 / 2);
+    if (tierTileSizes == tileSizes) continue;
+
+    std::string name = llvm::formatv("{0}_cache_tier{1}",
+                                     entryPointFn.getName(),
+                                     l2CacheTier.index());
+    auto clonedEntryPointOp = cast<IREE::HAL::ExecutableEntryPointOp>(
+        entryPointBuilder.clone(*entryPointOp));
+    clonedEntryPointOp.setName(name);
+    clonedEntryPointOp->setAttr("ordinal",
+                                entryPointBuilder.getIndexAttr(nextOrdinal++));
+    clonedEntryPointOp->setAttr(
+        kCacheTierAttrName,
+        entryPointBuilder.getIndexAttr(l2CacheTier.index()));
+    auto clonedFn = cast<FuncOp>(funcBuilder.clone(*entryPointFn));
+    clonedFn.setName(name);
+
+    SmallVector<Operation *> clonedComputeOps;
+    SmallVector<LoopTilingAndDistributionInfo> clonedTiledLoops;
+    if (failed(getComputeOps(clonedFn, clonedComputeOps, clonedTiledLoops))) {
+      return failure();
+    }
+    setLoweringConfig(
+        clonedComputeOps[rootOpIndex],
+        IREE::Codegen::LoweringConfigAttr::get(
+            entryPointFn.getContext(), tierTileSizes,
+            loweringConfig.getNativeVectorSizeVals()));
+  }
+  return success();
+}
+
 /// Sets the translation information to use for a dispatch region.
 static LogicalResult setTranslationInfoAndRootConfig(
     FuncOp entryPointFn, ArrayRef<Operation *> computeOps,
-    ArrayRef<LoopTilingAndDistributionInfo> tiledLoops) {
+    ArrayRef<LoopTilingAndDistributionInfo> tiledLoops,
+    DictionaryAttr tuningDatabase) {
+  // Ops without a preset configuration use the tuned one if available.
+  if (DictionaryAttr tuningEntries =
+          getTargetTuningEntries(entryPointFn, tuningDatabase)) {
+    if (llvm::none_of(computeOps, [](Operation *computeOp) {
+          return getCompilationInfo(computeOp);
+        })) {
+      setTunedCompilationInfo(computeOps, tuningEntries);
+    }
+  }
+
   // First check if the operations have a preset pipeline.
   for (auto computeOp : computeOps) {
     if (IREE::Codegen::CompilationInfoAttr compilationInfo =
@@ -717,6 +1113,9 @@ static LogicalResult setTranslationInfoAndRootConfig(
 }
 
 LogicalResult initCPULaunchConfig(ModuleOp moduleOp) {
+  FailureOr<DictionaryAttr> tuningDatabase = loadTuningDatabase(moduleOp);
+  if (failed(tuningDatabase)) return failure();
+
   llvm::StringMap<IREE::HAL::ExecutableEntryPointOp> entryPointOps =
       getAllEntryPoints(moduleOp);
   for (auto funcOp : moduleOp.getOps<FuncOp>()) {
@@ -731,8 +1130,12 @@ LogicalResult initCPULaunchConfig(ModuleOp moduleOp) {
       return failure();
     }
 
-    if (failed(
-            setTranslationInfoAndRootConfig(funcOp, computeOps, tiledLoops))) {
+    if (failed(setTranslationInfoAndRootConfig(funcOp, computeOps, tiledLoops,
+                                               *tuningDatabase))) {
+      return failure();
+    }
+    if (clPrintTuningKeys) printTuningKey(funcOp, computeOps);
+    if (failed(createCacheTierEntryPoints(funcOp, computeOps))) {
       return failure();
     }
   }
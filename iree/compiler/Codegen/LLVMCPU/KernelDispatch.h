@@ -23,6 +23,11 @@ enum class TilingLevel : unsigned {
   NumTileLevels = 3
 };
 
+/// Attribute marking the `hal.executable.entry_point` ops of the functions
+/// cloned for an L2 cache tier. The clones are selected at runtime through the
+/// library query function and are not exported themselves.
+static constexpr StringLiteral kCacheTierAttrName = "iree.llvmcpu.cache_tier";
+
 LogicalResult initCPULaunchConfig(ModuleOp moduleOp);
 
 }  // namespace iree_compiler
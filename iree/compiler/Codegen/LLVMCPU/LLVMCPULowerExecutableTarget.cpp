@@ -187,6 +187,10 @@ void LLVMCPULowerExecutableTargetPass::runOnOperation() {
               CPUTileFuseAndVectorize:
             addTileFuseAndVectorizePassPipeline(nestedModulePM, lowerToVectors);
             break;
+          case IREE::Codegen::DispatchLoweringPassPipeline::
+              CPUMmt4dMicrokernels:
+            addMmt4dMicrokernelsPassPipeline(nestedModulePM);
+            break;
           default:
             llvm_unreachable("Unsupported pipeline on CPU target.");
         }
@@ -197,6 +201,13 @@ void LLVMCPULowerExecutableTargetPass::runOnOperation() {
   if (failed(runPipeline(executableLoweringPipeline, variantOp))) {
     return signalPassFailure();
   }
+
+  // Functions cloned for L2 cache tiers have been lowered along with their
+  // entry points but must not be exported or given ordinals when linking.
+  for (auto entryPointOp : llvm::make_early_inc_range(
+           variantOp.getBlock().getOps<IREE::HAL::ExecutableEntryPointOp>())) {
+    if (entryPointOp->hasAttr(kCacheTierAttrName)) entryPointOp.erase();
+  }
 }
 
 std::unique_ptr<OperationPass<IREE::HAL::ExecutableVariantOp>>
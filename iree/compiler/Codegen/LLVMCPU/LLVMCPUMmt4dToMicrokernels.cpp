@@ -0,0 +1,115 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Codegen/LLVMCPU/Mmt4dMicrokernels.h"
+#include "iree/compiler/Codegen/PassDetail.h"
+#include "iree/compiler/Codegen/Passes.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/Dialect/StandardOps/IR/Ops.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/SymbolTable.h"
+#include "mlir/Pass/Pass.h"
+
+namespace mlir {
+namespace iree_compiler {
+
+namespace {
+
+/// Returns true if the [*, *, X0, K0] inner tiles of `value` are dense and
+/// consecutive along dimension 1 as assumed by the microkernels. Only the
+/// stride of dimension 0 and the offset may be dynamic.
+static bool hasDenseInnerTiles(Value value) {
+  auto memrefType = value.getType().dyn_cast<MemRefType>();
+  if (!memrefType || memrefType.getRank() != 4) return false;
+  SmallVector<int64_t> strides;
+  int64_t offset;
+  if (failed(getStridesAndOffset(memrefType, strides, offset))) return false;
+  ArrayRef<int64_t> shape = memrefType.getShape();
+  if (ShapedType::isDynamic(shape[2]) || ShapedType::isDynamic(shape[3])) {
+    return false;
+  }
+  return strides[3] == 1 && strides[2] == shape[3] &&
+         strides[1] == shape[2] * shape[3];
+}
+
+/// Returns the fully dynamic rank-4 strided memref type with `elementType` used
+/// for the microkernel declarations.
+static MemRefType getMicrokernelOperandType(Type elementType) {
+  int64_t dynamic = ShapedType::kDynamicStrideOrOffset;
+  AffineMap layout = makeStridedLinearLayoutMap(
+      {dynamic, dynamic, dynamic, dynamic}, dynamic, elementType.getContext());
+  return MemRefType::get({ShapedType::kDynamicSize, ShapedType::kDynamicSize,
+                          ShapedType::kDynamicSize, ShapedType::kDynamicSize},
+                         elementType, layout);
+}
+
+/// Returns the declaration of the import `name` taking `operandTypes`,
+/// inserting it into `moduleOp` if needed.
+static FuncOp getOrCreateImportDecl(ModuleOp moduleOp, StringRef name,
+                                    TypeRange operandTypes) {
+  if (auto funcOp = moduleOp.lookupSymbol<FuncOp>(name)) return funcOp;
+  auto builder = OpBuilder::atBlockBegin(moduleOp.getBody());
+  auto funcOp = builder.create<FuncOp>(
+      moduleOp.getLoc(), name,
+      builder.getFunctionType(operandTypes, /*results=*/{}));
+  funcOp.setPrivate();
+  funcOp->setAttr(kExecutableImportAttrName, builder.getUnitAttr());
+  return funcOp;
+}
+
+struct LLVMCPUMmt4dToMicrokernelsPass
+    : public LLVMCPUMmt4dToMicrokernelsBase<LLVMCPUMmt4dToMicrokernelsPass> {
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<memref::MemRefDialect, StandardOpsDialect>();
+  }
+
+  void runOnOperation() override {
+    ModuleOp moduleOp = getOperation();
+    auto variantOp =
+        moduleOp->getParentOfType<IREE::HAL::ExecutableVariantOp>();
+    if (!variantOp) return;
+
+    SmallVector<linalg::Mmt4DOp> mmt4dOps;
+    moduleOp.walk([&](linalg::Mmt4DOp op) {
+      if (op.hasBufferSemantics()) mmt4dOps.push_back(op);
+    });
+
+    for (auto mmt4dOp : mmt4dOps) {
+      Optional<std::string> name = getMmt4dMicrokernelName(mmt4dOp, variantOp);
+      if (!name) continue;
+      SmallVector<Value> operands = {mmt4dOp.inputs()[0], mmt4dOp.inputs()[1],
+                                     mmt4dOp.outputs()[0]};
+      // Ops that don't match the microkernel layout remain and are lowered to
+      // loops like any other linalg op.
+      if (!llvm::all_of(operands, hasDenseInnerTiles)) continue;
+
+      OpBuilder builder(mmt4dOp);
+      SmallVector<Value> castOperands;
+      SmallVector<Type> castTypes;
+      for (Value operand : operands) {
+        MemRefType castType = getMicrokernelOperandType(
+            operand.getType().cast<MemRefType>().getElementType());
+        castOperands.push_back(builder.create<memref::CastOp>(
+            mmt4dOp.getLoc(), castType, operand));
+        castTypes.push_back(castType);
+      }
+      FuncOp importDecl = getOrCreateImportDecl(moduleOp, *name, castTypes);
+      builder.create<CallOp>(mmt4dOp.getLoc(), importDecl, castOperands);
+      mmt4dOp.erase();
+    }
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<OperationPass<ModuleOp>>
+createLLVMCPUMmt4dToMicrokernelsPass() {
+  return std::make_unique<LLVMCPUMmt4dToMicrokernelsPass>();
+}
+
+}  // namespace iree_compiler
+}  // namespace mlir
@@ -0,0 +1,124 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Codegen/LLVMCPU/Mmt4dMicrokernels.h"
+
+#include "iree/compiler/Codegen/Utils/Utils.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace mlir {
+namespace iree_compiler {
+
+namespace {
+
+/// A runtime microkernel and the target features required to prefer it.
+struct Mmt4dMicrokernelInfo {
+  const char *name;
+  const char *lhsType;
+  const char *rhsType;
+  const char *outType;
+  int64_t M0;
+  int64_t N0;
+  int64_t K0;
+  // Comma-separated LLVM features required on each architecture. nullptr if
+  // the microkernel is not used on that architecture.
+  const char *aarch64Features;
+  const char *x86_64Features;
+};
+
+}  // namespace
+
+// Every microkernel has a portable implementation in the runtime so these
+// only select which tile shapes the runtime has specialized paths for.
+static const Mmt4dMicrokernelInfo kMmt4dMicrokernels[] = {
+    {"iree_mmt4d_f32f32f32_8x8x1", "f32", "f32", "f32", 8, 8, 1, "",
+     "+avx2,+fma"},
+    {"iree_mmt4d_f16f16f32_8x8x1", "f16", "f16", "f32", 8, 8, 1, "",
+     "+avx2,+fma,+f16c"},
+    {"iree_mmt4d_bf16bf16f32_8x8x1", "bf16", "bf16", "f32", 8, 8, 1, "",
+     "+avx2,+fma"},
+    {"iree_mmt4d_bf16bf16f32_8x8x2", "bf16", "bf16", "f32", 8, 8, 2, nullptr,
+     "+avx512bf16"},
+    {"iree_mmt4d_bf16bf16f32_8x8x4", "bf16", "bf16", "f32", 8, 8, 4, "+bf16",
+     nullptr},
+    {"iree_mmt4d_i8i8i32_8x8x2", "i8", "i8", "i32", 8, 8, 2, nullptr,
+     "+avx2"},
+    {"iree_mmt4d_i8i8i32_8x8x4", "i8", "i8", "i32", 8, 8, 4, "+dotprod",
+     nullptr},
+    {"iree_mmt4d_i8i8i32_8x8x8", "i8", "i8", "i32", 8, 8, 8, "+i8mm",
+     nullptr},
+};
+
+static std::string getTypeName(Type type) {
+  std::string name;
+  llvm::raw_string_ostream os(name);
+  type.print(os);
+  return os.str();
+}
+
+/// Returns true if all of the comma-separated `requiredFeatures` are present
+/// in `cpuFeatures`.
+static bool hasAllFeatures(StringRef cpuFeatures, StringRef requiredFeatures) {
+  SmallVector<StringRef> available;
+  cpuFeatures.split(available, ',', /*MaxSplit=*/-1, /*KeepEmpty=*/false);
+  SmallVector<StringRef> required;
+  requiredFeatures.split(required, ',', /*MaxSplit=*/-1, /*KeepEmpty=*/false);
+  return llvm::all_of(required, [&](StringRef feature) {
+    return llvm::is_contained(available, feature);
+  });
+}
+
+Optional<std::string> getMmt4dMicrokernelName(
+    linalg::Mmt4DOp mmt4dOp, IREE::HAL::ExecutableVariantOp variantOp) {
+  Optional<llvm::Triple> triple = getTargetTriple(variantOp);
+  if (!triple) return llvm::None;
+  StringRef cpuFeatures;
+  if (auto config = variantOp.target().getConfiguration()) {
+    if (auto attr = config.getAs<StringAttr>("cpu_features")) {
+      cpuFeatures = attr.getValue();
+    }
+  }
+
+  auto lhsType = mmt4dOp.inputs()[0].getType().cast<ShapedType>();
+  auto rhsType = mmt4dOp.inputs()[1].getType().cast<ShapedType>();
+  auto outType = mmt4dOp.outputs()[0].getType().cast<ShapedType>();
+  if (lhsType.getRank() != 4 || rhsType.getRank() != 4 ||
+      outType.getRank() != 4) {
+    return llvm::None;
+  }
+  ArrayRef<int64_t> lhsShape = lhsType.getShape();
+  ArrayRef<int64_t> rhsShape = rhsType.getShape();
+  std::string lhsTypeName = getTypeName(lhsType.getElementType());
+  std::string rhsTypeName = getTypeName(rhsType.getElementType());
+  std::string outTypeName = getTypeName(outType.getElementType());
+
+  for (const auto &info : kMmt4dMicrokernels) {
+    if (lhsTypeName != info.lhsType || rhsTypeName != info.rhsType ||
+        outTypeName != info.outType) {
+      continue;
+    }
+    if (lhsShape[2] != info.M0 || rhsShape[2] != info.N0 ||
+        lhsShape[3] != info.K0 || rhsShape[3] != info.K0) {
+      continue;
+    }
+    const char *requiredFeatures = nullptr;
+    if (triple->isAArch64()) {
+      requiredFeatures = info.aarch64Features;
+    } else if (triple->getArch() == llvm::Triple::x86_64) {
+      requiredFeatures = info.x86_64Features;
+    }
+    if (!requiredFeatures) continue;
+    if (!hasAllFeatures(cpuFeatures, requiredFeatures)) continue;
+    return std::string(info.name);
+  }
+  return llvm::None;
+}
+
+}  // namespace iree_compiler
+}  // namespace mlir
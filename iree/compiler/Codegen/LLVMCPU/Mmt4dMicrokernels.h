@@ -0,0 +1,36 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_COMPILER_CODEGEN_LLVMCPU_MMT4DMICROKERNELS_H_
+#define IREE_COMPILER_CODEGEN_LLVMCPU_MMT4DMICROKERNELS_H_
+
+#include <string>
+
+#include "iree/compiler/Dialect/HAL/IR/HALOps.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+
+namespace mlir {
+namespace iree_compiler {
+
+/// Unit attribute marking private function declarations that are resolved at
+/// runtime through the executable import table instead of being linked in.
+constexpr StringLiteral kExecutableImportAttrName = "hal.executable.import";
+
+/// Module attribute listing the executable import names in ordinal order.
+/// Set during conversion to LLVM and consumed by the LLVM target backends.
+constexpr StringLiteral kExecutableImportsAttrName = "hal.executable.imports";
+
+/// Returns the name of the runtime microkernel (see
+/// iree/builtins/mmt4d/mmt4d.h) implementing `mmt4dOp` for the target of
+/// `variantOp` or None if the element types, tile shape or target are not
+/// supported. Works on both tensor and buffer semantics.
+Optional<std::string> getMmt4dMicrokernelName(
+    linalg::Mmt4DOp mmt4dOp, IREE::HAL::ExecutableVariantOp variantOp);
+
+}  // namespace iree_compiler
+}  // namespace mlir
+
+#endif  // IREE_COMPILER_CODEGEN_LLVMCPU_MMT4DMICROKERNELS_H_
@@ -302,6 +302,12 @@ void addCPUDefaultPassPipeline(OpPassManager &passManager) {
   addLinalgBufferizePasses(passManager, cpuAllocationFunction);
 }
 
+void addMmt4dMicrokernelsPassPipeline(OpPassManager &passManager) {
+  addCPUDefaultPassPipeline(passManager);
+  passManager.addPass(createLLVMCPUMmt4dToMicrokernelsPass());
+  passManager.addNestedPass<FuncOp>(createCanonicalizerPass());
+}
+
 static void addLowerToLLVMPasses(OpPassManager &passManager) {
   // LinalgExt -> SCF
   passManager.addNestedPass<FuncOp>(
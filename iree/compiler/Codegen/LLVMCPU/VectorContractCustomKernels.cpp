@@ -383,6 +383,8 @@ class MMTKernelGenerator {
     switch (kernel.arch) {
       case CustomKernelTargetArch::Aarch64:
         return "w";
+      case CustomKernelTargetArch::Riscv64:
+      case CustomKernelTargetArch::X86_64:
       case CustomKernelTargetArch::None:
         break;
     }
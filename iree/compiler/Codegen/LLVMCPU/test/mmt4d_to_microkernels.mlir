@@ -0,0 +1,97 @@
+// RUN: iree-opt -split-input-file -pass-pipeline='hal.executable(hal.executable.variant(builtin.module(iree-llvmcpu-mmt4d-to-microkernels)))' %s | FileCheck %s
+
+#executable_target_embedded_elf_arm_64_ = #hal.executable.target<"llvm", "embedded-elf-arm_64", {cpu_features = "+dotprod", data_layout = "e-m:e-i8:8:32-i16:16:32-i64:64-i128:128-n32:64-S128", native_vector_size = 16 : index, target_triple = "aarch64-unknown-unknown-eabi-elf"}>
+#executable_layout = #hal.executable.layout<push_constants = 0, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>,
+    #hal.descriptor_set.binding<1, storage_buffer>,
+    #hal.descriptor_set.binding<2, storage_buffer>
+  ]>
+]>
+hal.executable private @mmt4d_i8 {
+  hal.executable.variant public @embedded_elf_arm_64, target = #executable_target_embedded_elf_arm_64_ {
+    hal.executable.entry_point public @mmt4d_i8 layout(#executable_layout)
+    builtin.module {
+      func @mmt4d_i8() {
+        %0 = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) : memref<16x64x8x4xi8>
+        %1 = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) : memref<32x64x8x4xi8>
+        %2 = hal.interface.binding.subspan set(0) binding(2) type(storage_buffer) : memref<16x32x8x8xi32>
+        linalg.mmt4d ins(%0, %1 : memref<16x64x8x4xi8>, memref<32x64x8x4xi8>) outs(%2 : memref<16x32x8x8xi32>)
+        return
+      }
+    }
+  }
+}
+
+//      CHECK: func private @iree_mmt4d_i8i8i32_8x8x4(memref<?x?x?x?xi8, #{{.+}}>, memref<?x?x?x?xi8, #{{.+}}>, memref<?x?x?x?xi32, #{{.+}}>)
+// CHECK-SAME:     attributes {hal.executable.import}
+//      CHECK: func @mmt4d_i8()
+//  CHECK-DAG:   %[[LHS:.+]] = hal.interface.binding.subspan set(0) binding(0)
+//  CHECK-DAG:   %[[RHS:.+]] = hal.interface.binding.subspan set(0) binding(1)
+//  CHECK-DAG:   %[[OUT:.+]] = hal.interface.binding.subspan set(0) binding(2)
+//  CHECK-DAG:   %[[LHS_CAST:.+]] = memref.cast %[[LHS]]
+//  CHECK-DAG:   %[[RHS_CAST:.+]] = memref.cast %[[RHS]]
+//  CHECK-DAG:   %[[OUT_CAST:.+]] = memref.cast %[[OUT]]
+//      CHECK:   call @iree_mmt4d_i8i8i32_8x8x4(%[[LHS_CAST]], %[[RHS_CAST]], %[[OUT_CAST]])
+//  CHECK-NOT:   linalg.mmt4d
+
+// -----
+
+// Tile shapes without a microkernel are left to the default lowering.
+
+#executable_target_embedded_elf_arm_64_ = #hal.executable.target<"llvm", "embedded-elf-arm_64", {data_layout = "e-m:e-i8:8:32-i16:16:32-i64:64-i128:128-n32:64-S128", native_vector_size = 16 : index, target_triple = "aarch64-unknown-unknown-eabi-elf"}>
+#executable_layout = #hal.executable.layout<push_constants = 0, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>,
+    #hal.descriptor_set.binding<1, storage_buffer>,
+    #hal.descriptor_set.binding<2, storage_buffer>
+  ]>
+]>
+hal.executable private @mmt4d_f32_unsupported_tile {
+  hal.executable.variant public @embedded_elf_arm_64, target = #executable_target_embedded_elf_arm_64_ {
+    hal.executable.entry_point public @mmt4d_f32_unsupported_tile layout(#executable_layout)
+    builtin.module {
+      func @mmt4d_f32_unsupported_tile() {
+        %0 = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) : memref<16x64x4x1xf32>
+        %1 = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) : memref<32x64x4x1xf32>
+        %2 = hal.interface.binding.subspan set(0) binding(2) type(storage_buffer) : memref<16x32x4x4xf32>
+        linalg.mmt4d ins(%0, %1 : memref<16x64x4x1xf32>, memref<32x64x4x1xf32>) outs(%2 : memref<16x32x4x4xf32>)
+        return
+      }
+    }
+  }
+}
+
+// CHECK-LABEL: func @mmt4d_f32_unsupported_tile()
+//   CHECK-NOT:   call
+//       CHECK:   linalg.mmt4d
+
+// -----
+
+#executable_target_embedded_elf_x86_64_ = #hal.executable.target<"llvm", "embedded-elf-x86_64", {cpu_features = "+avx2,+avx512vl,+avx512bf16", data_layout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128", native_vector_size = 32 : index, target_triple = "x86_64-unknown-unknown-eabi-elf"}>
+#executable_layout = #hal.executable.layout<push_constants = 0, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>,
+    #hal.descriptor_set.binding<1, storage_buffer>,
+    #hal.descriptor_set.binding<2, storage_buffer>
+  ]>
+]>
+hal.executable private @mmt4d_bf16 {
+  hal.executable.variant public @embedded_elf_x86_64, target = #executable_target_embedded_elf_x86_64_ {
+    hal.executable.entry_point public @mmt4d_bf16 layout(#executable_layout)
+    builtin.module {
+      func @mmt4d_bf16() {
+        %0 = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) : memref<16x64x8x2xbf16>
+        %1 = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) : memref<32x64x8x2xbf16>
+        %2 = hal.interface.binding.subspan set(0) binding(2) type(storage_buffer) : memref<16x32x8x8xf32>
+        linalg.mmt4d ins(%0, %1 : memref<16x64x8x2xbf16>, memref<32x64x8x2xbf16>) outs(%2 : memref<16x32x8x8xf32>)
+        return
+      }
+    }
+  }
+}
+
+//      CHECK: func private @iree_mmt4d_bf16bf16f32_8x8x2(memref<?x?x?x?xbf16, #{{.+}}>, memref<?x?x?x?xbf16, #{{.+}}>, memref<?x?x?x?xf32, #{{.+}}>)
+// CHECK-LABEL: func @mmt4d_bf16()
+//      CHECK:   call @iree_mmt4d_bf16bf16f32_8x8x2(
+//  CHECK-NOT:   linalg.mmt4d
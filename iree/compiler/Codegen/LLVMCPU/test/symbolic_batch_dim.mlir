@@ -0,0 +1,69 @@
+// RUN: iree-opt -pass-pipeline='hal.executable(hal.executable.variant(iree-llvmcpu-lower-executable-target{test-lowering-configuration=true}))' -iree-codegen-llvmcpu-symbolic-batch-dim -cse -canonicalize -split-input-file %s | FileCheck %s
+
+#executable_layout = #hal.executable.layout<push_constants = 1, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>,
+    #hal.descriptor_set.binding<1, storage_buffer>,
+    #hal.descriptor_set.binding<2, storage_buffer>
+  ]>
+]>
+hal.executable private @add_dynamic_batch  {
+  hal.executable.variant @llvm, target = <"llvm", "embedded-elf-x86_64", {
+       data_layout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128",
+       native_vector_size = 16 : index,
+       target_triple = "x86_64-unknown-linux-gnu"
+    }> {
+    hal.executable.entry_point @add_dynamic_batch layout(#executable_layout)
+    builtin.module  {
+      func @add_dynamic_batch() {
+        %c0 = arith.constant 0 : index
+        %c128 = arith.constant 128 : index
+        %batch = hal.interface.constant.load[0] : index
+        %0 = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) : !flow.dispatch.tensor<readonly:?x128xf32>{%batch}
+        %1 = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) : !flow.dispatch.tensor<readonly:128xf32>
+        %2 = hal.interface.binding.subspan set(0) binding(2) type(storage_buffer) : !flow.dispatch.tensor<writeonly:?x128xf32>{%batch}
+        %workgroup_size_x = hal.interface.workgroup.size[0] : index
+        %workgroup_size_y = hal.interface.workgroup.size[1] : index
+        %workgroup_id_x = hal.interface.workgroup.id[0] : index
+        %workgroup_count_x = hal.interface.workgroup.count[0] : index
+        %workgroup_id_y = hal.interface.workgroup.id[1] : index
+        %workgroup_count_y = hal.interface.workgroup.count[1] : index
+        %3 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_size_y, %workgroup_id_y]
+        %4 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_size_y, %workgroup_count_y]
+        scf.for %arg0 = %3 to %batch step %4 {
+          %5 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_size_x, %workgroup_id_x]
+          %6 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_size_x, %workgroup_count_x]
+          scf.for %arg1 = %5 to %c128 step %6 {
+            %7 = affine.min affine_map<(d0)[s0, s1] -> (s0, -d0 + s1)>(%arg0)[%workgroup_size_y, %batch]
+            %8 = affine.min affine_map<(d0)[s0] -> (s0, -d0 + 128)>(%arg1)[%workgroup_size_x]
+            %9 = flow.dispatch.tensor.load %0, offsets=[%arg0, %arg1], sizes=[%7, %8], strides=[1, 1] : !flow.dispatch.tensor<readonly:?x128xf32>{%batch} -> tensor<?x?xf32>
+            %10 = flow.dispatch.tensor.load %1, offsets=[%arg1], sizes=[%8], strides=[1] : !flow.dispatch.tensor<readonly:128xf32> -> tensor<?xf32>
+            %11 = linalg.init_tensor [%7, %8] : tensor<?x?xf32>
+            %12 = linalg.generic {
+              indexing_maps = [affine_map<(d0, d1) -> (d0, d1)>,
+                               affine_map<(d0, d1) -> (d1)>,
+                               affine_map<(d0, d1) -> (d0, d1)>],
+              iterator_types = ["parallel", "parallel"]}
+              ins(%9, %10 : tensor<?x?xf32>, tensor<?xf32>) outs(%11 : tensor<?x?xf32>) {
+              ^bb0(%arg2: f32, %arg3: f32, %arg4: f32):  // no predecessors
+                %13 = arith.addf %arg2, %arg3 : f32
+                linalg.yield %13 : f32
+              } -> tensor<?x?xf32>
+            flow.dispatch.tensor.store %12, %2, offsets=[%arg0, %arg1], sizes=[%7, %8], strides=[1, 1] : tensor<?x?xf32> -> !flow.dispatch.tensor<writeonly:?x128xf32>{%batch}
+          }
+        }
+        return
+      }
+    }
+  }
+}
+//  CHECK-DAG: #[[TRANSLATION:.+]] = #iree_codegen.translation.info<"CPUSingleTilingExpert", workload_per_wg = [64, 1]>
+//  CHECK-DAG: #[[MAP0:.+]] = affine_map<()[s0] -> (s0 ceildiv 64)>
+//      CHECK: hal.executable.entry_point public @add_dynamic_batch
+// CHECK-SAME:   translation.info = #[[TRANSLATION]]
+// CHECK-NEXT:   (%[[ARG0:[a-zA-Z0-9_]+]]: index
+// CHECK-SAME:    %[[ARG1:[a-zA-Z0-9_]+]]: index
+// CHECK-SAME:    %[[ARG2:[a-zA-Z0-9_]+]]: index)
+//  CHECK-DAG:    %[[C1:.+]] = arith.constant 1 : index
+//  CHECK-DAG:    %[[D0:.+]] = affine.apply #[[MAP0]]()[%[[ARG0]]]
+//      CHECK:    hal.return %[[D0]], %[[ARG1]], %[[C1]] : index, index, index
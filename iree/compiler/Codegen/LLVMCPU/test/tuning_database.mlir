@@ -0,0 +1,66 @@
+// RUN: echo '{"x86_64-unknown-linux-gnu" = {"linalg.matmul:128x256xf32,256x512xf32->128x512xf32" = #iree_codegen.compilation.info<#iree_codegen.lowering.config<tile_sizes = [[], [16, 8, 32]], native_vector_size = [16, 8, 32]>, #iree_codegen.translation.info<"CPUDoubleTilingExpert", workload_per_wg = [8, 16]>, workgroup_size = []>}}' > %t
+// RUN: iree-opt -pass-pipeline='hal.executable(hal.executable.variant(iree-llvmcpu-lower-executable-target{test-lowering-configuration=true}))' -iree-codegen-llvmcpu-tuning-database=%t -iree-codegen-llvmcpu-print-tuning-keys %s 2>&1 | FileCheck %s
+
+#executable_layout = #hal.executable.layout<push_constants = 0, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>,
+    #hal.descriptor_set.binding<1, storage_buffer>,
+    #hal.descriptor_set.binding<2, storage_buffer>
+  ]>
+]>
+hal.executable private @tuned_matmul_tensors {
+  hal.executable.variant @system_elf_x86_64, target = <"llvm", "system-elf-x86_64", {
+    target_triple = "x86_64-unknown-linux-gnu"
+  }> {
+    hal.executable.entry_point @tuned_matmul layout(#executable_layout)
+    builtin.module {
+      builtin.func @tuned_matmul() {
+        %c0 = arith.constant 0 : index
+        %c512 = arith.constant 512 : index
+        %c128 = arith.constant 128 : index
+        %cst = arith.constant 0.000000e+00 : f32
+        %0 = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) : !flow.dispatch.tensor<readonly:128x256xf32>
+        %1 = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) : !flow.dispatch.tensor<readonly:256x512xf32>
+        %2 = hal.interface.binding.subspan set(0) binding(2) type(storage_buffer) : !flow.dispatch.tensor<writeonly:128x512xf32>
+        %workgroup_size_x = hal.interface.workgroup.size[0] : index
+        %workgroup_size_y = hal.interface.workgroup.size[1] : index
+        %workgroup_id_x = hal.interface.workgroup.id[0] : index
+        %workgroup_count_x = hal.interface.workgroup.count[0] : index
+        %workgroup_id_y = hal.interface.workgroup.id[1] : index
+        %workgroup_count_y = hal.interface.workgroup.count[1] : index
+        %3 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_id_y, %workgroup_size_y]
+        %4 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_count_y, %workgroup_size_y]
+        scf.for %arg0 = %3 to %c128 step %4 {
+          %5 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_id_x, %workgroup_size_x]
+          %6 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_count_x, %workgroup_size_x]
+          scf.for %arg1 = %5 to %c512 step %6 {
+            %7 = affine.min affine_map<(d0)[s0] -> (s0, -d0 + 128)>(%arg0)[%workgroup_size_y]
+            %8 = flow.dispatch.tensor.load %0, offsets = [%arg0, 0], sizes = [%7, 256], strides = [1, 1] : !flow.dispatch.tensor<readonly:128x256xf32> -> tensor<?x256xf32>
+            %9 = affine.min affine_map<(d0)[s0] -> (s0, -d0 + 512)>(%arg1)[%workgroup_size_x]
+            %10 = flow.dispatch.tensor.load %1, offsets = [0, %arg1], sizes = [256, %9], strides = [1, 1] : !flow.dispatch.tensor<readonly:256x512xf32> -> tensor<256x?xf32>
+            %11 = affine.min affine_map<(d0)[s0] -> (s0, -d0 + 128)>(%arg0)[%workgroup_size_y]
+            %12 = affine.min affine_map<(d0)[s0] -> (s0, -d0 + 512)>(%arg1)[%workgroup_size_x]
+            %13 = affine.min affine_map<(d0)[s0] -> (-d0 + 128, s0)>(%arg0)[%workgroup_size_y]
+            %14 = affine.min affine_map<(d0)[s0] -> (-d0 + 512, s0)>(%arg1)[%workgroup_size_x]
+            %15 = linalg.init_tensor [%13, %14] : tensor<?x?xf32>
+            %16 = linalg.fill(%cst, %15) : f32, tensor<?x?xf32> -> tensor<?x?xf32>
+            %17 = linalg.matmul
+                 ins(%8, %10 : tensor<?x256xf32>, tensor<256x?xf32>)
+                 outs(%16 : tensor<?x?xf32>) -> tensor<?x?xf32>
+            flow.dispatch.tensor.store %17, %2, offsets = [%arg0, %arg1], sizes = [%11, %12], strides = [1, 1] : tensor<?x?xf32> -> !flow.dispatch.tensor<writeonly:128x512xf32>
+          }
+        }
+        return
+      }
+    }
+  }
+}
+
+//      CHECK: remark: tuning key "linalg.matmul:128x256xf32,256x512xf32->128x512xf32" = #iree_codegen.compilation.info<#iree_codegen.lowering.config<tile_sizes = {{\[}}[], [16, 8, 32]{{\]}}, native_vector_size = [16, 8, 32]>, #iree_codegen.translation.info<"CPUDoubleTilingExpert", workload_per_wg = [8, 16]>, workgroup_size = []>
+//  CHECK-DAG: #[[CONFIG:.+]] = #iree_codegen.lowering.config<tile_sizes = {{\[}}[], [16, 8, 32]{{\]}}, native_vector_size = [16, 8, 32]>
+//  CHECK-DAG: #[[TRANSLATION:.+]] = #iree_codegen.translation.info<"CPUDoubleTilingExpert", workload_per_wg = [8, 16]>
+//      CHECK: hal.executable.entry_point public @tuned_matmul
+// CHECK-SAME:     translation.info = #[[TRANSLATION]]
+//      CHECK:   func @tuned_matmul
+//      CHECK:     linalg.matmul
+// CHECK-SAME:         lowering.config = #[[CONFIG]]
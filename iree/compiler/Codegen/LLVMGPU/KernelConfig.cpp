@@ -10,10 +10,13 @@
 
 #include "iree-dialects/Dialect/LinalgExt/IR/LinalgExtOps.h"
 #include "iree/compiler/Codegen/Dialect/LoweringConfig.h"
+#include "iree/compiler/Codegen/LLVMGPU/LLVMGPUUtils.h"
 #include "iree/compiler/Dialect/Flow/IR/FlowOps.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/MathExtras.h"
 #include "mlir/Dialect/Linalg/Transforms/Transforms.h"
 #include "mlir/IR/Matchers.h"
+#include "mlir/IR/TypeUtilities.h"
 #include "mlir/IR/Types.h"
 #include "mlir/IR/Value.h"
 
@@ -49,12 +52,22 @@ static void getMatmulConfig(SmallVectorImpl<TileWorkgroupSizePair> &tileSizes) {
 /// Return the best combination of tile size and wg size when using tensorcore
 /// operations.
 static void getTensorCoreConfig(
-    SmallVectorImpl<TileWorkgroupSizePair> &tileSizes) {
+    SmallVectorImpl<TileWorkgroupSizePair> &tileSizes, Type elementType) {
   // Tile sizes are skewed towards small matmul for now. Long term the plan is
   // to not rely on hardcoded configurations.
+  // 16-bit inputs take half the shared memory and registers per element so a
+  // larger tile that amortizes each load over more MMA ops still fits.
+  if (elementType.isF16()) {
+    tileSizes.push_back(TileWorkgroupSizePair({{64, 64, 32}, {64, 2, 1}}));
+  }
   tileSizes.push_back(TileWorkgroupSizePair({{32, 32, 16}, {64, 2, 1}}));
 }
 
+/// Minimum number of workgroups a tensorcore configuration must produce to be
+/// picked over the smaller configurations that follow it. Skinny matmuls would
+/// otherwise leave most of the SMs (108 on an A100) idle.
+static constexpr int64_t kMinTensorCoreWorkgroupCount = 108;
+
 static std::string getTargetArch(FuncOp entryPoint) {
   if (auto variantOp =
           entryPoint->getParentOfType<IREE::HAL::ExecutableVariantOp>()) {
@@ -181,18 +194,25 @@ static LogicalResult setContractConfig(FuncOp entryPoint, linalg::LinalgOp op) {
     /// Try tensorcore config first.
     if (supportsTensorCore(entryPoint, op)) {
       SmallVector<TileWorkgroupSizePair> TCtileSizeConfig;
-      getTensorCoreConfig(TCtileSizeConfig);
+      getTensorCoreConfig(TCtileSizeConfig,
+                          getElementTypeOrSelf(op.getInputOperand(0)->get()));
       // Pick the best configuration where the original shape is aligned on the
-      // tile size.
-      for (TileWorkgroupSizePair &config : TCtileSizeConfig) {
-        if (sizeK % config.tileSize[2] == 0 &&
-            sizeN % config.tileSize[1] == 0 &&
-            sizeM % config.tileSize[0] == 0) {
-          return setMatmulConfig(config.tileSize[0], config.tileSize[1],
-                                 config.tileSize[2], config.workgroupSize,
-                                 IREE::Codegen::DispatchLoweringPassPipeline::
-                                     LLVMGPUMatmulTensorCore);
+      // tile size and that produces enough workgroups to fill the device.
+      for (auto config : llvm::enumerate(TCtileSizeConfig)) {
+        std::array<int64_t, 3> &tileSize = config.value().tileSize;
+        if (sizeK % tileSize[2] != 0 || sizeN % tileSize[1] != 0 ||
+            sizeM % tileSize[0] != 0) {
+          continue;
         }
+        int64_t workgroupCount = (sizeM / tileSize[0]) * (sizeN / tileSize[1]);
+        if (workgroupCount < kMinTensorCoreWorkgroupCount &&
+            config.index() + 1 < TCtileSizeConfig.size()) {
+          continue;
+        }
+        return setMatmulConfig(tileSize[0], tileSize[1], tileSize[2],
+                               config.value().workgroupSize,
+                               IREE::Codegen::DispatchLoweringPassPipeline::
+                                   LLVMGPUMatmulTensorCore);
       }
     }
     // Special case for very small matrices.
@@ -295,6 +315,97 @@ static LogicalResult setSortConfig(FuncOp entryPoint, Operation *op) {
       workgroupSize);
 }
 
+/// Sets the configuration of a reduction fused with its broadcasting consumers
+/// in the same dispatch region. Each thread computes whole reductions and the
+/// consumers of their results, so the reduction loops are left untiled and no
+/// synchronization across threads is needed. This is the same distribution as
+/// the one used for sort.
+static LogicalResult setFusedReductionConfig(FuncOp entryPoint,
+                                             linalg::GenericOp op) {
+  return setSortConfig(entryPoint, op);
+}
+
+/// Minimum size of the reduced loop for a reduction to be distributed across
+/// the threads of a workgroup. Shorter reductions are faster when each thread
+/// reduces whole rows.
+static constexpr int64_t kMinWarpReductionSize = 4 * cudaWarpSize;
+
+/// Number of elements of the reduced loop each thread reduces serially before
+/// the partial results are combined across threads.
+static constexpr int64_t kWarpReductionElementsPerThread = 4;
+
+/// Returns the reduction that drives the configuration of the dispatch if all
+/// of `computeOps` can be lowered with the LLVMGPUWarpReduction pipeline,
+/// nullptr otherwise. These are reductions along a long and static innermost
+/// loop, and the elementwise ops fused with them (e.g. softmax or layernorm).
+static linalg::GenericOp getWarpReductionRoot(
+    FuncOp entryPoint, ArrayRef<Operation *> computeOps) {
+  // gpu.shuffle is only lowered to NVVM.
+  auto variantOp =
+      entryPoint->getParentOfType<IREE::HAL::ExecutableVariantOp>();
+  if (!variantOp || variantOp.target().getBackend().getValue() != "cuda") {
+    return nullptr;
+  }
+  linalg::GenericOp reductionOp;
+  for (Operation *op : computeOps) {
+    auto linalgOp = dyn_cast<linalg::LinalgOp>(op);
+    if (!linalgOp || getCompilationInfo(op) ||
+        llvm::any_of(linalgOp.getIndexingMaps(), [](AffineMap map) {
+          return !map.isProjectedPermutation();
+        })) {
+      return nullptr;
+    }
+    if (linalgOp.getNumReductionLoops() == 0) continue;
+    auto genericOp = dyn_cast<linalg::GenericOp>(op);
+    if (!genericOp || !getWarpReductionCombiner(genericOp)) return nullptr;
+    reductionOp = genericOp;
+  }
+  if (!reductionOp) return nullptr;
+  // Consecutive threads must read consecutive elements along the reduced loop
+  // for the loads to be coalesced.
+  unsigned reductionDim = reductionOp.getNumLoops() - 1;
+  for (OpOperand *input : reductionOp.getInputOperands()) {
+    AffineMap map = reductionOp.getTiedIndexingMap(input);
+    if (map.isFunctionOfDim(reductionDim) &&
+        map.getDimPosition(map.getNumResults() - 1) != reductionDim) {
+      return nullptr;
+    }
+  }
+  Optional<SmallVector<int64_t, 4>> staticLoopRanges =
+      reductionOp.getStaticLoopRanges();
+  if (!staticLoopRanges) return nullptr;
+  int64_t reductionSize = staticLoopRanges->back();
+  if (ShapedType::isDynamic(reductionSize) ||
+      reductionSize < kMinWarpReductionSize) {
+    return nullptr;
+  }
+  return reductionOp;
+}
+
+/// Sets the configuration of a reduction along its innermost loop distributed
+/// across the threads of a workgroup. Each workgroup computes a single
+/// reduction and the threads each reduce a strided slice of the reduced loop
+/// before combining their partial results with warp shuffles.
+static LogicalResult setWarpReductionConfig(FuncOp entryPoint,
+                                            linalg::GenericOp op) {
+  auto interfaceOp = cast<IREE::Flow::PartitionableLoopsInterface>(*op);
+  auto partitionedLoops =
+      interfaceOp.getPartitionableLoops(kNumMaxParallelDims);
+  SmallVector<int64_t, 4> workgroupTileSizes(op.getNumLoops(), 0);
+  for (int64_t loopIndex : partitionedLoops) {
+    workgroupTileSizes[loopIndex] = 1;
+  }
+  int64_t reductionSize = op.getStaticLoopRanges()->back();
+  int64_t numThreads = std::min<int64_t>(
+      1024, llvm::PowerOf2Floor(reductionSize /
+                                kWarpReductionElementsPerThread));
+  TileSizesListType tileSizes = {workgroupTileSizes};
+  return setOpConfigAndEntryPointFnTranslation(
+      entryPoint, op, tileSizes, /*nativeVectorSizes=*/ArrayRef<int64_t>{},
+      IREE::Codegen::DispatchLoweringPassPipeline::LLVMGPUWarpReduction,
+      {numThreads, 1, 1});
+}
+
 // Basic default properties for linalg ops that haven't been tuned.
 static LogicalResult setRootDefaultConfig(FuncOp entryPoint, Operation *op) {
   IREE::Codegen::DispatchLoweringPassPipeline passPipeline =
@@ -450,6 +561,34 @@ LogicalResult initGPULaunchConfig(ModuleOp moduleOp) {
       continue;
     }
 
+    // Long reductions, along with the ops fused with them, are distributed
+    // across the threads of a workgroup.
+    if (linalg::GenericOp reductionOp =
+            getWarpReductionRoot(funcOp, computeOps)) {
+      if (failed(setWarpReductionConfig(funcOp, reductionOp))) continue;
+      IREE::Codegen::LoweringConfigAttr config = getLoweringConfig(reductionOp);
+      for (auto op : computeOps) {
+        if (op == reductionOp) continue;
+        setLoweringConfig(op, config);
+      }
+      continue;
+    }
+
+    // Reductions fused with their consumers are distributed along the loops
+    // left parallel by the reduction and need a configuration of their own.
+    if (Operation *reductionOp = getReductionFusedWithConsumers(computeOps)) {
+      if (failed(setFusedReductionConfig(
+              funcOp, cast<linalg::GenericOp>(reductionOp)))) {
+        continue;
+      }
+      IREE::Codegen::LoweringConfigAttr config = getLoweringConfig(reductionOp);
+      for (auto op : computeOps) {
+        if (op == reductionOp) continue;
+        setLoweringConfig(op, config);
+      }
+      continue;
+    }
+
     Operation *rootOperation = nullptr;
     // Find the root operation. linalg.generic and linalg.fill are not root
     // operations if there are other compute operations present.
@@ -7,6 +7,8 @@
 #include "iree/compiler/Codegen/PassDetail.h"
 #include "iree/compiler/Codegen/Passes.h"
 #include "iree/compiler/Codegen/Utils/Utils.h"
+#include "llvm/Support/MathExtras.h"
+#include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
 #include "mlir/Dialect/GPU/Passes.h"
 #include "mlir/Dialect/SCF/Transforms.h"
 #include "mlir/Dialect/Vector/IR/VectorOps.h"
@@ -33,11 +35,47 @@ static void addDepOps(llvm::SmallDenseSet<Operation*>& dep, Operation* op,
   }
 }
 
+/// Maximum number of 32-bit registers per thread holding values loaded from
+/// global memory ahead of their use. Each additional stage keeps one more
+/// iteration of loaded values live in registers until it is stored to shared
+/// memory.
+static constexpr int64_t kMaxPrefetchRegisters = 32;
+
+/// Returns the number of iterations ahead to issue the global memory loads of
+/// `forOp`. This is the largest depth up to `maxDepth` such that the prefetched
+/// values fit in the register budget and that leaves at least one iteration of
+/// the loop to pipeline.
+static unsigned getPipelineDepth(scf::ForOp forOp, unsigned maxDepth) {
+  int64_t registersPerStage = 0;
+  for (Operation& op : forOp.getBody()->getOperations()) {
+    if (!op.hasAttr(kPipeliningGlobalLoad)) continue;
+    auto vectorType = cast<vector::TransferReadOp>(op).getVectorType();
+    int64_t bitWidth = vectorType.getNumElements() *
+                       vectorType.getElementType().getIntOrFloatBitWidth();
+    registersPerStage += llvm::divideCeil(bitWidth, 32);
+  }
+  int64_t depth = maxDepth;
+  if (registersPerStage > 0) {
+    depth = std::min(depth, kMaxPrefetchRegisters / registersPerStage);
+  }
+  auto lb = forOp.getLowerBound().getDefiningOp<arith::ConstantIndexOp>();
+  auto ub = forOp.getUpperBound().getDefiningOp<arith::ConstantIndexOp>();
+  auto step = forOp.getStep().getDefiningOp<arith::ConstantIndexOp>();
+  if (lb && ub && step) {
+    int64_t tripCount = llvm::divideCeil(ub.value() - lb.value(), step.value());
+    depth = std::min(depth, tripCount - 1);
+  }
+  return std::max<int64_t>(depth, 1);
+}
+
 /// Assign stages to the loop ops. Simple logic for now, put load from global
-/// memory in stage 0 and the rest in stage 1.
+/// memory in stage 0 and the rest in stage `depth` so that the loads are issued
+/// `depth` iterations ahead of their use.
 static void getPipelineStages(
-    scf::ForOp forOp, std::vector<std::pair<Operation*, unsigned>>& ops) {
+    scf::ForOp forOp, unsigned maxDepth,
+    std::vector<std::pair<Operation*, unsigned>>& ops) {
   if (!forOp->hasAttr(kPipeliningLoopMarker)) return;
+  unsigned depth = getPipelineDepth(forOp, maxDepth);
 
   // Track dependencies of the global memory load.
   llvm::SmallDenseSet<Operation*> loadDep;
@@ -48,11 +86,11 @@ static void getPipelineStages(
   }
   // Create a modulo schedule with loads from global memory and the operations
   // it depends on in stage 0. Store to shared memory and computation are in
-  // stage 1. In order to have a correct scheduling even with back edges we
-  // order stages in decreasing order.
+  // the last stage. In order to have a correct scheduling even with back edges
+  // we order stages in decreasing order.
   for (Operation& op : forOp.getBody()->getOperations()) {
     if (!loadDep.count(&op) && !isa<scf::YieldOp>(op))
-      ops.push_back(std::make_pair(&op, 1));
+      ops.push_back(std::make_pair(&op, depth));
   }
   for (Operation& op : forOp.getBody()->getOperations()) {
     if (loadDep.count(&op)) ops.push_back(std::make_pair(&op, 0));
@@ -62,6 +100,11 @@ static void getPipelineStages(
 namespace {
 struct LLVMGPUPipeliningPass
     : public LLVMGPUPipeliningBase<LLVMGPUPipeliningPass> {
+  LLVMGPUPipeliningPass(unsigned depth) { this->depth = depth; }
+  LLVMGPUPipeliningPass(const LLVMGPUPipeliningPass& pass) {
+    this->depth = pass.depth.getValue();
+  }
+
   void runOnOperation() override {
     auto funcOp = getOperation();
     MLIRContext* context = &getContext();
@@ -91,7 +134,12 @@ struct LLVMGPUPipeliningPass
       }
     });
     scf::PipeliningOption options;
-    options.getScheduleFn = getPipelineStages;
+    unsigned maxDepth = depth;
+    options.getScheduleFn =
+        [maxDepth](scf::ForOp forOp,
+                   std::vector<std::pair<Operation*, unsigned>>& ops) {
+          getPipelineStages(forOp, maxDepth, ops);
+        };
     RewritePatternSet pipeliningPatterns(context);
     scf::populateSCFLoopPipeliningPatterns(pipeliningPatterns, options);
     if (failed(applyPatternsAndFoldGreedily(funcOp,
@@ -102,8 +150,9 @@ struct LLVMGPUPipeliningPass
 };
 }  // namespace
 
-std::unique_ptr<OperationPass<FuncOp>> createLLVMGPUPipeliningPass() {
-  return std::make_unique<LLVMGPUPipeliningPass>();
+std::unique_ptr<OperationPass<FuncOp>> createLLVMGPUPipeliningPass(
+    unsigned depth) {
+  return std::make_unique<LLVMGPUPipeliningPass>(depth);
 }
 
 }  // namespace iree_compiler
@@ -65,5 +65,17 @@ std::array<int64_t, 3> getWorkgroupSize(mlir::FuncOp funcOp) {
   return workgroupSize;
 }
 
+mlir::Operation *getWarpReductionCombiner(mlir::linalg::GenericOp genericOp) {
+  mlir::Operation *combiner = getReductionCombiner(genericOp);
+  if (!combiner) return nullptr;
+  // gpu.shuffle only supports 32-bit values.
+  mlir::Type elementType = combiner->getResult(0).getType();
+  if (!elementType.isIntOrFloat() ||
+      elementType.getIntOrFloatBitWidth() != 32) {
+    return nullptr;
+  }
+  return combiner;
+}
+
 }  // namespace iree_compiler
 }  // namespace mlir
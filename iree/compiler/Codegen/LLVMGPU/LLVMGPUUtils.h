@@ -32,6 +32,12 @@ llvm::SmallVector<mlir::linalg::ProcInfo, 2> getSubgroupIdsAndCounts(
 /// return the workgroup size associated to the funcOp entry point.
 std::array<int64_t, 3> getWorkgroupSize(mlir::FuncOp funcOp);
 
+/// Returns the op of the body of `genericOp` combining its output with the
+/// values computed from its inputs if `genericOp` is a reduction along its
+/// innermost loop that can be distributed across the threads of a workgroup
+/// using warp shuffles. Returns nullptr otherwise.
+mlir::Operation *getWarpReductionCombiner(mlir::linalg::GenericOp genericOp);
+
 }  // namespace iree_compiler
 }  // namespace mlir
 #endif  // IREE_COMPILER_CODEGEN_LLVMGPU_LLVMGPUUTILS_H_
@@ -0,0 +1,93 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Codegen/LLVMGPU/LLVMGPUUtils.h"
+#include "iree/compiler/Codegen/PassDetail.h"
+#include "iree/compiler/Codegen/Passes.h"
+#include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
+#include "mlir/Dialect/GPU/GPUDialect.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/Dialect/SCF/SCF.h"
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/IR/Builders.h"
+
+//====---------------------------------------------------------------------===//
+// Pass to distribute reductions along their innermost loop, and the ops fused
+// with them, onto the threads of a workgroup using warp shuffles.
+//====---------------------------------------------------------------------===//
+
+namespace mlir {
+namespace iree_compiler {
+
+/// Combines `lhs` and `rhs` with a clone of the reduction `combiner`.
+static Value combine(OpBuilder &builder, Operation *combiner, Value lhs,
+                     Value rhs) {
+  BlockAndValueMapping mapping;
+  mapping.map(combiner->getOperand(0), lhs);
+  mapping.map(combiner->getOperand(1), rhs);
+  return builder.clone(*combiner, mapping)->getResult(0);
+}
+
+/// Reduces `value` across the lanes of a warp using butterfly shuffles. All
+/// lanes hold the result.
+static Value warpReduce(OpBuilder &builder, Location loc, Operation *combiner,
+                        Value value) {
+  // gpu.shuffle only supports 32-bit values.
+  if (value.getType().getIntOrFloatBitWidth() != 32) return nullptr;
+  Value width = builder.create<arith::ConstantIntOp>(loc, kWarpSize, 32);
+  for (int64_t offset = kWarpSize / 2; offset > 0; offset /= 2) {
+    Value offsetValue = builder.create<arith::ConstantIntOp>(loc, offset, 32);
+    Value shuffled =
+        builder
+            .create<gpu::ShuffleOp>(loc, value.getType(), builder.getI1Type(),
+                                    value, offsetValue, width,
+                                    gpu::ShuffleMode::XOR)
+            .getResult(0);
+    value = combine(builder, combiner, value, shuffled);
+  }
+  return value;
+}
+
+namespace {
+struct LLVMGPUWarpReductionPass
+    : public LLVMGPUWarpReductionBase<LLVMGPUWarpReductionPass> {
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<arith::ArithmeticDialect, gpu::GPUDialect,
+                    memref::MemRefDialect, scf::SCFDialect>();
+  }
+
+  void runOnOperation() override {
+    FuncOp funcOp = getOperation();
+    if (!getEntryPoint(funcOp)) return;
+    std::array<int64_t, 3> workgroupSize = getWorkgroupSize(funcOp);
+    if (workgroupSize[1] != 1 || workgroupSize[2] != 1) {
+      funcOp.emitOpError("expected a 1-D workgroup, got ")
+          << workgroupSize[0] << "x" << workgroupSize[1] << "x"
+          << workgroupSize[2];
+      return signalPassFailure();
+    }
+
+    WorkgroupReductionOptions options;
+    options.numThreads = workgroupSize[0];
+    options.subgroupSize = kWarpSize;
+    options.sharedMemorySpace = gpu::GPUDialect::getWorkgroupAddressSpace();
+    options.subgroupReduce = warpReduce;
+    options.buildBarrier = [](OpBuilder &builder, Location loc) {
+      builder.create<gpu::BarrierOp>(loc);
+    };
+    if (failed(distributeReductionsToWorkgroup(funcOp, options))) {
+      return signalPassFailure();
+    }
+  }
+};
+}  // namespace
+
+std::unique_ptr<OperationPass<FuncOp>> createLLVMGPUWarpReductionPass() {
+  return std::make_unique<LLVMGPUWarpReductionPass>();
+}
+
+}  // namespace iree_compiler
+}  // namespace mlir
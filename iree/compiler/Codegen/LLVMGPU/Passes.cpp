@@ -8,6 +8,7 @@
 
 #include "iree-dialects/Dialect/LinalgExt/Transforms/Passes.h"
 #include "iree/compiler/Codegen/PassDetail.h"
+#include "llvm/Support/CommandLine.h"
 #include "mlir/Conversion/AffineToStandard/AffineToStandard.h"
 #include "mlir/Conversion/GPUToNVVM/GPUToNVVMPass.h"
 #include "mlir/Conversion/SCFToControlFlow/SCFToControlFlow.h"
@@ -24,6 +25,12 @@
 namespace mlir {
 namespace iree_compiler {
 
+static llvm::cl::opt<unsigned> clTensorCorePipelineDepth(
+    "iree-codegen-llvmgpu-tensorcore-pipeline-depth",
+    llvm::cl::desc("Maximum number of iterations ahead that the tensor core "
+                   "matmul pipeline issues loads from global memory"),
+    llvm::cl::init(3));
+
 static Value gpuAllocationFunction(OpBuilder &builder, Location loc,
                                    ArrayRef<int64_t> staticShape,
                                    Type elementType,
@@ -137,8 +144,10 @@ void addGPUMatmulTensorCorePassPipeline(OpPassManager &pm) {
   pm.addPass(createCanonicalizerPass());
   pm.addPass(createCSEPass());
 
-  // Pipeline memory operations.
-  pm.addNestedPass<FuncOp>(createLLVMGPUPipeliningPass());
+  // Pipeline memory operations. Loads are issued several iterations ahead so
+  // that the global memory latency is hidden behind the MMA ops.
+  pm.addNestedPass<FuncOp>(
+      createLLVMGPUPipeliningPass(clTensorCorePipelineDepth));
 }
 
 void addGPUSimpleDistributePassPipeline(OpPassManager &pm) {
@@ -156,6 +165,22 @@ void addGPUSimpleDistributePassPipeline(OpPassManager &pm) {
   pm.addNestedPass<FuncOp>(createRemoveSingleIterationLoopPass());
 }
 
+void addGPUWarpReductionPassPipeline(OpPassManager &pm) {
+  //===--------------------------------------------------------------------===//
+  // Initial clean up.
+  //===--------------------------------------------------------------------===//
+  pm.addPass(createCanonicalizerPass());
+  pm.addPass(createCSEPass());
+
+  // Distribute the reductions and their fused ops onto threads within the
+  // workgroup.
+  pm.addNestedPass<FuncOp>(createLLVMGPUWarpReductionPass());
+  pm.addPass(createCanonicalizerPass());
+  pm.addPass(createCSEPass());
+
+  pm.addNestedPass<FuncOp>(createRemoveSingleIterationLoopPass());
+}
+
 static void addLowerToLLVMGPUPasses(OpPassManager &pm, bool useROCM) {
   pm.addPass(createLowerAffinePass());
   pm.addPass(createCanonicalizerPass());
@@ -508,3 +508,179 @@ hal.executable private @sort_op {
 //       CHECK: func @sort_op()
 //       CHECK:   iree_linalg_ext.sort
 //  CHECK-SAME:     lowering.config = #[[CONFIG]]
+
+// -----
+
+// Large f16 matmuls use the larger tensorcore tile.
+
+#executable_layout = #hal.executable.layout<push_constants = 0, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>,
+    #hal.descriptor_set.binding<1, storage_buffer>,
+    #hal.descriptor_set.binding<2, storage_buffer>
+  ]>
+]>
+hal.executable @large_matmul_f16 {
+hal.executable.variant public @cuda_nvptx_fb, target = <"cuda", "cuda-nvptx-fb", {target_arch = "sm_80"}> {
+  hal.executable.entry_point public @large_matmul_f16 layout(#executable_layout)
+  builtin.module {
+    func @large_matmul_f16() {
+      %cst = arith.constant 0.000000e+00 : f16
+      %c1024 = arith.constant 1024 : index
+      %c1024 = arith.constant 1024 : index
+      %c0 = arith.constant 0 : index
+      %0 = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) : !flow.dispatch.tensor<readonly:1024x1024xf16>
+      %1 = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) : !flow.dispatch.tensor<readonly:1024x1024xf16>
+      %2 = hal.interface.binding.subspan set(0) binding(2) type(storage_buffer) : !flow.dispatch.tensor<writeonly:1024x1024xf16>
+      %workgroup_size_x = hal.interface.workgroup.size[0] : index
+      %workgroup_size_y = hal.interface.workgroup.size[1] : index
+      %workgroup_id_x = hal.interface.workgroup.id[0] : index
+      %workgroup_count_x = hal.interface.workgroup.count[0] : index
+      %workgroup_id_y = hal.interface.workgroup.id[1] : index
+      %workgroup_count_y = hal.interface.workgroup.count[1] : index
+      %3 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_id_y, %workgroup_size_y]
+      %4 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_count_y, %workgroup_size_y]
+      scf.for %arg0 = %3 to %c1024 step %4 {
+        %5 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_id_x, %workgroup_size_x]
+        %6 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_count_x, %workgroup_size_x]
+        scf.for %arg1 = %5 to %c1024 step %6 {
+          %7 = affine.min affine_map<(d0)[s0] -> (s0, -d0 + 1024)>(%arg0)[%workgroup_size_y]
+          %8 = flow.dispatch.tensor.load %0, offsets = [%arg0, 0], sizes = [%7, 1024], strides = [1, 1] : !flow.dispatch.tensor<readonly:1024x1024xf16> -> tensor<?x1024xf16>
+          %9 = affine.min affine_map<(d0)[s0] -> (s0, -d0 + 1024)>(%arg1)[%workgroup_size_x]
+          %10 = flow.dispatch.tensor.load %1, offsets = [0, %arg1], sizes = [1024, %9], strides = [1, 1] : !flow.dispatch.tensor<readonly:1024x1024xf16> -> tensor<1024x?xf16>
+          %11 = linalg.init_tensor [%7, %9] : tensor<?x?xf16>
+          %12 = linalg.fill(%cst, %11) : f16, tensor<?x?xf16> -> tensor<?x?xf16>
+          %13 = linalg.matmul ins(%8, %10 : tensor<?x1024xf16>, tensor<1024x?xf16>) outs(%12 : tensor<?x?xf16>) -> tensor<?x?xf16>
+          flow.dispatch.tensor.store %13, %2, offsets = [%arg0, %arg1], sizes = [%7, %9], strides = [1, 1] : tensor<?x?xf16> -> !flow.dispatch.tensor<writeonly:1024x1024xf16>
+        }
+      }
+      return
+    }
+  }
+}
+}
+
+//  CHECK-DAG: #[[CONFIG:.+]] = #iree_codegen.lowering.config<tile_sizes = {{\[}}[64, 64, 32]{{\]}}
+//  CHECK-DAG: #[[TRANSLATION:.+]] = #iree_codegen.translation.info<"LLVMGPUMatmulTensorCore", workload_per_wg = [64, 64]>
+//      CHECK: hal.executable.entry_point public @large_matmul_f16
+// CHECK-SAME:     translation.info = #[[TRANSLATION]]
+// CHECK-SAME:     workgroup_size = [64 : index, 2 : index, 1 : index]
+//      CHECK: func @large_matmul_f16
+//      CHECK:   linalg.matmul
+// CHECK-SAME:       lowering.config = #[[CONFIG]]
+
+// -----
+
+// Skinny f16 matmuls that would produce too few workgroups with the larger tile
+// use the smaller tensorcore tile instead.
+
+#executable_layout = #hal.executable.layout<push_constants = 0, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>,
+    #hal.descriptor_set.binding<1, storage_buffer>,
+    #hal.descriptor_set.binding<2, storage_buffer>
+  ]>
+]>
+hal.executable @skinny_matmul_f16 {
+hal.executable.variant public @cuda_nvptx_fb, target = <"cuda", "cuda-nvptx-fb", {target_arch = "sm_80"}> {
+  hal.executable.entry_point public @skinny_matmul_f16 layout(#executable_layout)
+  builtin.module {
+    func @skinny_matmul_f16() {
+      %cst = arith.constant 0.000000e+00 : f16
+      %c128 = arith.constant 128 : index
+      %c256 = arith.constant 256 : index
+      %c0 = arith.constant 0 : index
+      %0 = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) : !flow.dispatch.tensor<readonly:128x1024xf16>
+      %1 = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) : !flow.dispatch.tensor<readonly:1024x256xf16>
+      %2 = hal.interface.binding.subspan set(0) binding(2) type(storage_buffer) : !flow.dispatch.tensor<writeonly:128x256xf16>
+      %workgroup_size_x = hal.interface.workgroup.size[0] : index
+      %workgroup_size_y = hal.interface.workgroup.size[1] : index
+      %workgroup_id_x = hal.interface.workgroup.id[0] : index
+      %workgroup_count_x = hal.interface.workgroup.count[0] : index
+      %workgroup_id_y = hal.interface.workgroup.id[1] : index
+      %workgroup_count_y = hal.interface.workgroup.count[1] : index
+      %3 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_id_y, %workgroup_size_y]
+      %4 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_count_y, %workgroup_size_y]
+      scf.for %arg0 = %3 to %c128 step %4 {
+        %5 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_id_x, %workgroup_size_x]
+        %6 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_count_x, %workgroup_size_x]
+        scf.for %arg1 = %5 to %c256 step %6 {
+          %7 = affine.min affine_map<(d0)[s0] -> (s0, -d0 + 128)>(%arg0)[%workgroup_size_y]
+          %8 = flow.dispatch.tensor.load %0, offsets = [%arg0, 0], sizes = [%7, 1024], strides = [1, 1] : !flow.dispatch.tensor<readonly:128x1024xf16> -> tensor<?x1024xf16>
+          %9 = affine.min affine_map<(d0)[s0] -> (s0, -d0 + 256)>(%arg1)[%workgroup_size_x]
+          %10 = flow.dispatch.tensor.load %1, offsets = [0, %arg1], sizes = [1024, %9], strides = [1, 1] : !flow.dispatch.tensor<readonly:1024x256xf16> -> tensor<1024x?xf16>
+          %11 = linalg.init_tensor [%7, %9] : tensor<?x?xf16>
+          %12 = linalg.fill(%cst, %11) : f16, tensor<?x?xf16> -> tensor<?x?xf16>
+          %13 = linalg.matmul ins(%8, %10 : tensor<?x1024xf16>, tensor<1024x?xf16>) outs(%12 : tensor<?x?xf16>) -> tensor<?x?xf16>
+          flow.dispatch.tensor.store %13, %2, offsets = [%arg0, %arg1], sizes = [%7, %9], strides = [1, 1] : tensor<?x?xf16> -> !flow.dispatch.tensor<writeonly:128x256xf16>
+        }
+      }
+      return
+    }
+  }
+}
+}
+
+//  CHECK-DAG: #[[CONFIG:.+]] = #iree_codegen.lowering.config<tile_sizes = {{\[}}[32, 32, 16]{{\]}}
+//  CHECK-DAG: #[[TRANSLATION:.+]] = #iree_codegen.translation.info<"LLVMGPUMatmulTensorCore", workload_per_wg = [32, 32]>
+//      CHECK: hal.executable.entry_point public @skinny_matmul_f16
+// CHECK-SAME:     translation.info = #[[TRANSLATION]]
+// CHECK-SAME:     workgroup_size = [64 : index, 2 : index, 1 : index]
+//      CHECK: func @skinny_matmul_f16
+//      CHECK:   linalg.matmul
+// CHECK-SAME:       lowering.config = #[[CONFIG]]
+
+// -----
+
+// Reductions along a long innermost loop are distributed across the threads of
+// a workgroup.
+
+#executable_layout = #hal.executable.layout<push_constants = 0, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>,
+    #hal.descriptor_set.binding<1, storage_buffer>
+  ]>
+]>
+hal.executable @row_reduction {
+hal.executable.variant public @cuda_nvptx_fb, target = <"cuda", "cuda-nvptx-fb"> {
+  hal.executable.entry_point public @row_reduction layout(#executable_layout)
+  builtin.module {
+    func @row_reduction() {
+      %c0 = arith.constant 0 : index
+      %c512 = arith.constant 512 : index
+      %cst = arith.constant 0.000000e+00 : f32
+      %0 = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) : !flow.dispatch.tensor<readonly:512x1024xf32>
+      %1 = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) : !flow.dispatch.tensor<writeonly:512xf32>
+      %workgroup_size_x = hal.interface.workgroup.size[0] : index
+      %workgroup_id_x = hal.interface.workgroup.id[0] : index
+      %workgroup_count_x = hal.interface.workgroup.count[0] : index
+      %2 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_id_x, %workgroup_size_x]
+      %3 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_count_x, %workgroup_size_x]
+      scf.for %arg0 = %2 to %c512 step %3 {
+        %4 = affine.min affine_map<(d0)[s0] -> (s0, -d0 + 512)>(%arg0)[%workgroup_size_x]
+        %5 = flow.dispatch.tensor.load %0, offsets = [%arg0, 0], sizes = [%4, 1024], strides = [1, 1] : !flow.dispatch.tensor<readonly:512x1024xf32> -> tensor<?x1024xf32>
+        %6 = linalg.init_tensor [%4] : tensor<?xf32>
+        %7 = linalg.fill(%cst, %6) : f32, tensor<?xf32> -> tensor<?xf32>
+        %8 = linalg.generic {indexing_maps = [affine_map<(d0, d1) -> (d0, d1)>, affine_map<(d0, d1) -> (d0)>], iterator_types = ["parallel", "reduction"]} ins(%5 : tensor<?x1024xf32>) outs(%7 : tensor<?xf32>) {
+        ^bb0(%arg1: f32, %arg2: f32):
+          %9 = arith.addf %arg1, %arg2 : f32
+          linalg.yield %9 : f32
+        } -> tensor<?xf32>
+        flow.dispatch.tensor.store %8, %1, offsets = [%arg0], sizes = [%4], strides = [1] : tensor<?xf32> -> !flow.dispatch.tensor<writeonly:512xf32>
+      }
+      return
+    }
+  }
+}
+}
+
+//  CHECK-DAG: #[[CONFIG:.+]] = #iree_codegen.lowering.config<tile_sizes = {{\[}}[1, 0]{{\]}}, native_vector_size = []>
+//  CHECK-DAG: #[[TRANSLATION:.+]] = #iree_codegen.translation.info<"LLVMGPUWarpReduction", workload_per_wg = [1]>
+//      CHECK: hal.executable.entry_point public @row_reduction
+// CHECK-SAME:     translation.info = #[[TRANSLATION]]
+// CHECK-SAME:     workgroup_size = [256 : index, 1 : index, 1 : index]
+//      CHECK: func @row_reduction
+//      CHECK:   linalg.fill
+// CHECK-SAME:       lowering.config = #[[CONFIG]]
+//      CHECK:   linalg.generic
+// CHECK-SAME:       lowering.config = #[[CONFIG]]
@@ -0,0 +1,79 @@
+// RUN: iree-opt -pass-pipeline='hal.executable(hal.executable.variant(builtin.module(builtin.func(iree-llvmgpu-warp-reduction))))' %s | FileCheck %s
+
+#executable_layout = #hal.executable.layout<push_constants = 0, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>,
+    #hal.descriptor_set.binding<1, storage_buffer>
+  ]>
+]>
+hal.executable private @normalize_rows  {
+  hal.executable.variant @cuda, target = <"cuda", "cuda-nvptx-fb"> {
+    hal.executable.entry_point @normalize_rows layout(#executable_layout) attributes {
+      workgroup_size = [64: index, 1: index, 1: index]
+    }
+    builtin.module {
+      builtin.func @normalize_rows(%in : memref<1x1024xf32>, %out : memref<1x1024xf32>) {
+        %cst = arith.constant 0.000000e+00 : f32
+        %sum = memref.alloc() : memref<1xf32, 3>
+        linalg.fill(%cst, %sum) : f32, memref<1xf32, 3>
+        linalg.generic {
+            indexing_maps = [affine_map<(d0, d1) -> (d0, d1)>, affine_map<(d0, d1) -> (d0)>],
+            iterator_types = ["parallel", "reduction"]}
+            ins(%in : memref<1x1024xf32>) outs(%sum : memref<1xf32, 3>) {
+        ^bb0(%arg0: f32, %arg1: f32):
+          %0 = arith.addf %arg0, %arg1 : f32
+          linalg.yield %0 : f32
+        }
+        linalg.generic {
+            indexing_maps = [affine_map<(d0, d1) -> (d0, d1)>, affine_map<(d0, d1) -> (d0)>, affine_map<(d0, d1) -> (d0, d1)>],
+            iterator_types = ["parallel", "parallel"]}
+            ins(%in, %sum : memref<1x1024xf32>, memref<1xf32, 3>) outs(%out : memref<1x1024xf32>) {
+        ^bb0(%arg0: f32, %arg1: f32, %arg2: f32):
+          %0 = arith.divf %arg0, %arg1 : f32
+          linalg.yield %0 : f32
+        }
+        return
+      }
+    }
+  }
+}
+
+// CHECK-LABEL: func @normalize_rows
+//  CHECK-SAME:     (%[[IN:.+]]: memref<1x1024xf32>, %[[OUT:.+]]: memref<1x1024xf32>)
+//       CHECK:   %[[SUM:.+]] = memref.alloc() : memref<1xf32, 3>
+//       CHECK:   %[[TID0:.+]] = gpu.thread_id x
+//       CHECK:   scf.for %[[J0:.+]] = %[[TID0]] to %{{.+}} step %{{.+}} {
+//       CHECK:     memref.store %{{.+}}, %[[SUM]][%[[J0]]] : memref<1xf32, 3>
+//       CHECK:   gpu.barrier
+//       CHECK:   %[[TID1:.+]] = gpu.thread_id x
+//       CHECK:   %[[IDENTITY:.+]] = arith.constant 0.000000e+00 : f32
+//       CHECK:   %[[WARP_SUMS:.+]] = memref.alloc() : memref<2xf32, 3>
+//       CHECK:   scf.for %[[I:.+]] = %{{.+}} to %{{.+}} step %{{.+}} {
+//       CHECK:     %[[PARTIAL:.+]] = scf.for %[[K:.+]] = %[[TID1]] to %{{.+}} step %{{.+}} iter_args(%[[ACC:.+]] = %[[IDENTITY]]) -> (f32) {
+//       CHECK:       %[[V:.+]] = memref.load %[[IN]][%[[I]], %[[K]]] : memref<1x1024xf32>
+//       CHECK:       %[[ADD:.+]] = arith.addf %[[V]], %[[ACC]] : f32
+//       CHECK:       scf.yield %[[ADD]] : f32
+//       CHECK:     }
+//  CHECK-COUNT-5:     gpu.shuffle xor
+//       CHECK:     scf.if
+//       CHECK:       memref.store %{{.+}}, %[[WARP_SUMS]][%{{.+}}] : memref<2xf32, 3>
+//       CHECK:     gpu.barrier
+//       CHECK:     scf.if
+//       CHECK:       memref.load %[[WARP_SUMS]]
+//       CHECK:     } else {
+//       CHECK:       scf.yield %[[IDENTITY]] : f32
+//  CHECK-COUNT-5:     gpu.shuffle xor
+//       CHECK:     scf.if
+//       CHECK:       %[[INIT:.+]] = memref.load %[[SUM]][%[[I]]] : memref<1xf32, 3>
+//       CHECK:       %[[TOTAL:.+]] = arith.addf %{{.+}}, %[[INIT]] : f32
+//       CHECK:       memref.store %[[TOTAL]], %[[SUM]][%[[I]]] : memref<1xf32, 3>
+//       CHECK:     gpu.barrier
+//       CHECK:   gpu.barrier
+//       CHECK:   %[[TID2:.+]] = gpu.thread_id x
+//       CHECK:   scf.for %[[I2:.+]] = %{{.+}} to %{{.+}} step %{{.+}} {
+//       CHECK:     scf.for %[[J2:.+]] = %[[TID2]] to %{{.+}} step %{{.+}} {
+//   CHECK-DAG:       %[[X:.+]] = memref.load %[[IN]][%[[I2]], %[[J2]]] : memref<1x1024xf32>
+//   CHECK-DAG:       %[[S:.+]] = memref.load %[[SUM]][%[[I2]]] : memref<1xf32, 3>
+//       CHECK:       %[[DIV:.+]] = arith.divf %[[X]], %[[S]] : f32
+//       CHECK:       memref.store %[[DIV]], %[[OUT]][%[[I2]], %[[J2]]] : memref<1x1024xf32>
+//   CHECK-NOT:   linalg.generic
@@ -168,6 +168,11 @@ createLLVMCPUCheckIRBeforeLLVMConversionPass();
 std::unique_ptr<OperationPass<IREE::HAL::ExecutableVariantOp>>
 createLLVMCPULowerExecutableTargetPass();
 
+/// Converts linalg.mmt4d ops on buffers to calls to microkernels imported from
+/// the runtime.
+std::unique_ptr<OperationPass<ModuleOp>>
+createLLVMCPUMmt4dToMicrokernelsPass();
+
 /// Synchronizes LLVM linkage with MLIR symbol visibility.
 std::unique_ptr<OperationPass<ModuleOp>>
 createLLVMCPUSynchronizeSymbolVisibilityPass();
@@ -203,6 +208,11 @@ void populateUnfusedFMAOpsPassPatterns(MLIRContext *context,
 /// to memrefs
 void addCPUDefaultPassPipeline(OpPassManager &passManager);
 
+/// Populates the passes to lower linalg.mmt4d ops to calls to runtime
+/// microkernels. The microkernels handle the tiles within each workgroup so
+/// this only bufferizes before replacing the ops.
+void addMmt4dMicrokernelsPassPipeline(OpPassManager &passManager);
+
 /// Populates the passes needed to multi level tile and lowering of linalg ops
 /// on tensors to vectors operations.
 LogicalResult verifyTensorToVectorsPassPipelineConfig(
@@ -261,6 +271,11 @@ void addGPUMatmulTensorCorePassPipeline(OpPassManager &pm);
 /// pass manager.
 void addGPUSimpleDistributePassPipeline(OpPassManager &pm);
 
+/// Lowering reductions along their innermost loop by distributing the reduced
+/// loop onto the threads of a workgroup and combining the partial results with
+/// warp shuffles. Expects pass manager to be a module-level pass manager.
+void addGPUWarpReductionPassPipeline(OpPassManager &pm);
+
 /// Populates passes needed to lower a XLA HLO op to NVVM/ROCDL dialect via the
 /// structured ops path. The pass manager `pm` in here should operate on the
 /// module within the IREE::HAL::ExecutableOp.
@@ -295,7 +310,12 @@ std::unique_ptr<OperationPass<FuncOp>>
 createLLVMGPUDistributeSharedMemoryCopy();
 
 /// Apply software pipelining.
-std::unique_ptr<OperationPass<FuncOp>> createLLVMGPUPipeliningPass();
+std::unique_ptr<OperationPass<FuncOp>> createLLVMGPUPipeliningPass(
+    unsigned depth = 1);
+
+/// Distribute reductions along their innermost loop, and the elementwise ops
+/// fused with them, onto the threads of a workgroup.
+std::unique_ptr<OperationPass<FuncOp>> createLLVMGPUWarpReductionPass();
 
 //------------------------------------------------------------------------------
 // SPIR-V Passes
@@ -317,6 +337,11 @@ void addSPIRVTileAndDistributeCopyPassPipeline(OpPassManager &pm);
 /// performs distribution to threads with vectorization.
 void addSPIRVTileAndVectorizePassPipeline(OpPassManager &pm);
 
+/// Pass pipeline to lower IREE HAL executables with one workgroup tiled
+/// reduction, and the ops fused with it, per workgroup to SPIR-V code where the
+/// reduction is distributed across invocations using subgroup arithmetic ops.
+void addSPIRVSubgroupReducePassPipeline(OpPassManager &pm);
+
 /// Pass pipeline to lower IREE HAL executables with workgroup tiled and
 /// distributed Linalg ops to SPIR-V cooperative matrix code. Additionally
 /// performs distribution to threads with vectorization.
@@ -327,7 +352,12 @@ void addSPIRVTileAndVectorizeToCooperativeOpsPassPipeline(OpPassManager &pm);
 /// This pass converts remaining interface ops into SPIR-V global variables,
 /// GPU processor ID ops into SPIR-V global variables, loop/standard ops into
 /// corresponding SPIR-V ops.
-std::unique_ptr<OperationPass<ModuleOp>> createConvertToSPIRVPass();
+///
+/// If `specializePushConstants` is set each push constant load is guarded by
+/// a pair of specialization constants allowing runtimes to substitute the
+/// value when creating pipelines (see spirv_executable_def.fbs).
+std::unique_ptr<OperationPass<ModuleOp>> createConvertToSPIRVPass(
+    bool specializePushConstants = false);
 
 /// Creates a pass to fold processor ID uses where possible.
 std::unique_ptr<OperationPass<FuncOp>> createSPIRVFoldProcessorIDUsesPass();
@@ -342,6 +372,10 @@ createSPIRVLowerExecutableTargetPass();
 std::unique_ptr<OperationPass<IREE::HAL::ExecutableVariantOp>>
 createSPIRVInitConfigPass();
 
+/// Pass to distribute reductions with buffer semantics, and the ops fused with
+/// them, to invocations using subgroup arithmetic ops.
+std::unique_ptr<OperationPass<FuncOp>> createSPIRVSubgroupReducePass();
+
 /// Pass to tile and distribute Linalg ops with buffer semantics to invocations.
 std::unique_ptr<OperationPass<FuncOp>> createSPIRVTileAndDistributePass();
 
@@ -379,7 +413,10 @@ std::unique_ptr<OperationPass<ModuleOp>> createSPIRVVectorizeLoadStore();
 /// testing purposes only. The pass pipeline will set an appropriate workgroup
 /// size.
 /// TODO: Are both of these needed and does this one still work on HLO?
-void buildSPIRVCodegenPassPipeline(OpPassManager &pm);
+///
+/// `specializePushConstants` is forwarded to the final SPIR-V conversion.
+void buildSPIRVCodegenPassPipeline(OpPassManager &pm,
+                                   bool specializePushConstants = false);
 
 //------------------------------------------------------------------------------
 // Test passes
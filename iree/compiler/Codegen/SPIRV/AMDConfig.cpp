@@ -0,0 +1,48 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+//===- AMDConfig.h - AMD CodeGen Configurations ---------------------------===//
+//
+// This file contains CodeGen configurations for AMD GPUs.
+//
+//===----------------------------------------------------------------------===//
+
+#include "iree/compiler/Codegen/SPIRV/KernelConfig.h"
+#include "llvm/ADT/TypeSwitch.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/IR/BuiltinOps.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace detail {
+
+//===----------------------------------------------------------------------===//
+// Entry Point
+//===----------------------------------------------------------------------===//
+
+LogicalResult setAMDCodeGenConfig(const spirv::TargetEnv &targetEnv,
+                                  Operation *rootOp) {
+  int64_t subgroupSize = targetEnv.getResourceLimits().subgroup_size().getInt();
+  return TypeSwitch<Operation *, LogicalResult>(rootOp)
+      .Case<linalg::MatmulOp>([&targetEnv](auto op) {
+        // Leave the op to the default configuration if cooperative matrix
+        // is not supported.
+        return setCooperativeMatrixConfig(targetEnv, op);
+      })
+      .Case<linalg::Conv2DNhwcHwcfOp>([subgroupSize](auto op) {
+        return setConvOpConfig(op, subgroupSize,
+                               /*bestTilingFactor=*/32);
+      })
+      .Case<linalg::DepthwiseConv2DNhwcHwcOp>([subgroupSize](auto op) {
+        return setConvOpConfig(op, subgroupSize,
+                               /*bestTilingFactor=*/32);
+      })
+      .Default([](Operation *) { return success(); });
+}
+
+}  // namespace detail
+}  // namespace iree_compiler
+}  // namespace mlir
@@ -25,6 +25,7 @@
 #include "llvm/ADT/DenseMapInfo.h"
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SetVector.h"
 #include "llvm/Support/FormatVariadic.h"
 #include "mlir/Conversion/ArithmeticToSPIRV/ArithmeticToSPIRV.h"
 #include "mlir/Conversion/GPUToSPIRV/GPUToSPIRV.h"
@@ -147,6 +148,53 @@ InterfaceResourceMap createResourceVariables(mlir::ModuleOp module) {
   return interfaceToResourceVars;
 }
 
+/// Map from push constant indices to the pair of spv.SpecConstant ops holding
+/// their specialized value and whether the value is specialized.
+using PushConstantSpecMap =
+    llvm::DenseMap<unsigned,
+                   std::pair<spirv::SpecConstantOp, spirv::SpecConstantOp>>;
+
+/// Name of the spv.module attribute recording the number of leading push
+/// constants exposed as specialization constants.
+constexpr StringLiteral kSpecializablePushConstantCountAttrName =
+    "iree.spirv.specializable_push_constant_count";
+
+/// Scans all hal.interface.constant.load ops in `module` and creates the
+/// specialization constants of each loaded push constant index. The value of
+/// push constant `i` uses spec ID `2*i` and the boolean selecting it uses spec
+/// ID `2*i+1`, matching the convention in spirv_executable_def.fbs.
+PushConstantSpecMap createPushConstantSpecConstants(mlir::ModuleOp module) {
+  SymbolTable symbolTable(module);
+  PushConstantSpecMap specConstants;
+
+  llvm::SmallSetVector<unsigned, 8> indices;
+  module.walk([&](IREE::HAL::InterfaceConstantLoadOp loadOp) {
+    indices.insert(loadOp.index().getZExtValue());
+  });
+
+  OpBuilder builder(module.getContext());
+  auto i32Type = builder.getIntegerType(32);
+  for (unsigned index : llvm::reverse(indices)) {
+    Location loc = module.getLoc();
+    auto valueOp = builder.create<spirv::SpecConstantOp>(
+        loc,
+        builder.getStringAttr(
+            llvm::formatv("__push_constant_spec_value_{0}_", index).str()),
+        builder.getIntegerAttr(i32Type, 0));
+    valueOp->setAttr("spec_id", builder.getI32IntegerAttr(2 * index));
+    auto enabledOp = builder.create<spirv::SpecConstantOp>(
+        loc,
+        builder.getStringAttr(
+            llvm::formatv("__push_constant_spec_enabled_{0}_", index).str()),
+        builder.getBoolAttr(false));
+    enabledOp->setAttr("spec_id", builder.getI32IntegerAttr(2 * index + 1));
+    symbolTable.insert(valueOp, module.getBody()->begin());
+    symbolTable.insert(enabledOp, module.getBody()->begin());
+    specConstants[index] = {valueOp, enabledOp};
+  }
+  return specConstants;
+}
+
 }  // namespace
 
 //===----------------------------------------------------------------------===//
@@ -158,7 +206,12 @@ namespace {
 /// ops to load from a global variable representing the push constant storage.
 struct HALInterfaceLoadConstantConverter final
     : public OpConversionPattern<IREE::HAL::InterfaceConstantLoadOp> {
-  using OpConversionPattern::OpConversionPattern;
+  HALInterfaceLoadConstantConverter(TypeConverter &typeConverter,
+                                    MLIRContext *context,
+                                    const PushConstantSpecMap &specConstants,
+                                    PatternBenefit benefit = 1)
+      : OpConversionPattern(typeConverter, context, benefit),
+        specConstants(specConstants) {}
 
   LogicalResult matchAndRewrite(
       IREE::HAL::InterfaceConstantLoadOp loadOp, OpAdaptor adaptor,
@@ -177,12 +230,28 @@ struct HALInterfaceLoadConstantConverter final
     // The following function generates SPIR-V ops with i32 types. So it does
     // type "conversion" (index -> i32) implicitly.
     auto i32Type = rewriter.getIntegerType(32);
-    auto value = spirv::getPushConstantValue(loadOp, elementCount, index,
-                                             i32Type, rewriter);
+    Value value = spirv::getPushConstantValue(loadOp, elementCount, index,
+                                              i32Type, rewriter);
+
+    // Prefer the specialized value when the pipeline provides one. Drivers
+    // fold the select away when creating the pipeline.
+    auto it = specConstants.find(index);
+    if (it != specConstants.end()) {
+      auto loc = loadOp.getLoc();
+      Value specValue = rewriter.create<spirv::ReferenceOfOp>(
+          loc, i32Type, SymbolRefAttr::get(it->second.first));
+      Value specEnabled = rewriter.create<spirv::ReferenceOfOp>(
+          loc, rewriter.getI1Type(), SymbolRefAttr::get(it->second.second));
+      value = rewriter.create<spirv::SelectOp>(loc, specEnabled, specValue,
+                                               value);
+    }
 
     rewriter.replaceOp(loadOp, value);
     return success();
   }
+
+ private:
+  const PushConstantSpecMap &specConstants;
 };
 
 /// A pattern to convert hal.interface.workgroup.id/count into corresponding
@@ -290,8 +359,12 @@ struct ConvertToSPIRVPass : public ConvertToSPIRVBase<ConvertToSPIRVPass> {
     registry.insert<spirv::SPIRVDialect>();
   }
 
-  ConvertToSPIRVPass() {}
-  ConvertToSPIRVPass(const ConvertToSPIRVPass &pass) {}
+  ConvertToSPIRVPass(bool specializePushConstants) {
+    this->specializePushConstants = specializePushConstants;
+  }
+  ConvertToSPIRVPass(const ConvertToSPIRVPass &pass) {
+    this->specializePushConstants = pass.specializePushConstants;
+  }
 
   void runOnOperation() override;
 };
@@ -366,9 +439,16 @@ void ConvertToSPIRVPass::runOnOperation() {
   // Pull in builtin func to spv.func conversion.
   populateBuiltinFuncToSPIRVPatterns(typeConverter, patterns);
 
-  // Add IREE HAL interface op conversions.
+  // Add IREE HAL interface op conversions. Specialization constants for push
+  // constants are created ahead of time so they can be referenced from all
+  // functions.
+  PushConstantSpecMap pushConstantSpecConstants;
+  if (specializePushConstants) {
+    pushConstantSpecConstants = createPushConstantSpecConstants(moduleOp);
+  }
+  patterns.insert<HALInterfaceLoadConstantConverter>(
+      typeConverter, context, pushConstantSpecConstants);
   patterns.insert<
-      HALInterfaceLoadConstantConverter,
       HALInterfaceWorkgroupIdAndCountConverter<
           IREE::HAL::InterfaceWorkgroupIDOp, spirv::BuiltIn::WorkgroupId>,
       HALInterfaceWorkgroupIdAndCountConverter<
@@ -423,14 +503,26 @@ void ConvertToSPIRVPass::runOnOperation() {
     if (&op == spvModule) continue;
     if (op.getDialect() == spvDialect) op.moveBefore(body, body->end());
   }
+
+  // Record how many leading push constants may be specialized so the target
+  // backend can describe it to the runtime.
+  if (specializePushConstants) {
+    uint64_t specializableCount = 0;
+    for (auto &it : pushConstantSpecConstants) {
+      specializableCount = std::max<uint64_t>(specializableCount, it.first + 1);
+    }
+    spvModule->setAttr(kSpecializablePushConstantCountAttrName,
+                       builder.getI32IntegerAttr(specializableCount));
+  }
 }
 
 //===----------------------------------------------------------------------===//
 // Pass entry point and registration
 //===----------------------------------------------------------------------===//
 
-std::unique_ptr<OperationPass<ModuleOp>> createConvertToSPIRVPass() {
-  return std::make_unique<ConvertToSPIRVPass>();
+std::unique_ptr<OperationPass<ModuleOp>> createConvertToSPIRVPass(
+    bool specializePushConstants) {
+  return std::make_unique<ConvertToSPIRVPass>(specializePushConstants);
 }
 
 }  // namespace iree_compiler
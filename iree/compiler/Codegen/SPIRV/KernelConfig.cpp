@@ -258,6 +258,100 @@ LogicalResult setMatmulOpConfig(linalg::LinalgOp op,
 
 }  // namespace detail
 
+//===----------------------------------------------------------------------===//
+// Cooperative Matrix Default Configuration
+//===----------------------------------------------------------------------===//
+
+namespace detail {
+
+struct CooperativeMatrixSize {
+  int64_t m;
+  int64_t n;
+  int64_t k;
+};
+
+/// Returns the cooperative matrix (M, N, K) sizes that are supported by the
+/// target environment and match the given parameters.
+static Optional<CooperativeMatrixSize> getCooperativeMatrixSize(
+    spirv::ResourceLimitsAttr resourceLimits, Type lhsType, Type rhsType,
+    Type resultType, int64_t m, int64_t n, int64_t k) {
+  auto properties = resourceLimits.cooperative_matrix_properties_nv()
+                        .getAsRange<spirv::CooperativeMatrixPropertiesNVAttr>();
+  for (auto property : properties) {
+    if (property.a_type().getValue() == lhsType &&
+        property.b_type().getValue() == rhsType &&
+        property.c_type().getValue() == resultType &&
+        property.result_type().getValue() == resultType &&
+        property.scope().getValue() == spirv::Scope::Subgroup) {
+      int64_t matmulM = property.m_size().getValue().getZExtValue();
+      int64_t matmulN = property.n_size().getValue().getZExtValue();
+      int64_t matmulK = property.k_size().getValue().getZExtValue();
+      if (m % matmulM == 0 && n % matmulN == 0 && k % matmulK == 0) {
+        return CooperativeMatrixSize{matmulM, matmulN, matmulK};
+      }
+    }
+  }
+  return llvm::None;
+}
+
+LogicalResult setCooperativeMatrixConfig(const spirv::TargetEnv &targetEnv,
+                                         linalg::MatmulOp op) {
+  // This configuration is only for cooperative matrix.
+  if (!targetEnv.allows(spirv::Capability::CooperativeMatrixNV) ||
+      !targetEnv.allows(spirv::Extension::SPV_NV_cooperative_matrix)) {
+    return success();
+  }
+
+  Value lhs = op.inputs()[0], rhs = op.inputs()[1], init = op.outputs()[0];
+
+  ArrayRef<int64_t> lhsShape = getUntiledShape(lhs);
+  ArrayRef<int64_t> rhsShape = getUntiledShape(rhs);
+  if (llvm::any_of(lhsShape, ShapedType::isDynamic)) return success();
+  if (llvm::any_of(rhsShape, ShapedType::isDynamic)) return success();
+
+  // TODO: Cooperative matrix support is fairly restricted. We can only have
+  // a curated list of fused element wise ops as defined in the extension
+  // SPV_NV_cooperative_matrix. Check that once we move bufferization after
+  // vectorization.
+
+  auto getElementType = [](Value v) {
+    return v.getType().cast<ShapedType>().getElementType();
+  };
+
+  auto resourceLimits = targetEnv.getResourceLimits();
+  auto coopMatSize = getCooperativeMatrixSize(
+      resourceLimits, getElementType(lhs), getElementType(rhs),
+      getElementType(init), lhsShape[0], rhsShape[1], lhsShape[1]);
+  if (!coopMatSize) return success();
+
+  auto pipeline = IREE::Codegen::DispatchLoweringPassPipeline::
+      SPIRVVectorizeToCooperativeOps;
+
+  // For now only support one subgroup per workgroup because in the above
+  // configuration deduction step we only consider whether the input workload is
+  // perfectly divisible by some native cooperative matrix size.
+  //
+  // TODO: Use some heuristics to deduce how many subgroups should be used and
+  // the tile sizes for each subgroup, considering the input workload size and
+  // native cooperative matrix size choices.
+  int64_t subgroupSize = resourceLimits.subgroup_size().getInt();
+  std::array<int64_t, 3> workgroupSize = {subgroupSize, 1, 1};
+
+  TileSizesListType tileSizes;
+  // Again because we only consider whether the input workload is perfectly
+  // divisible by some native cooperative matrix size, not some multiples of it,
+  // need to make sure the subgroup tile sizes are the same as the workgroup
+  // one.
+  tileSizes.push_back({coopMatSize->m, coopMatSize->n, coopMatSize->k});
+  tileSizes.push_back({coopMatSize->m, coopMatSize->n, coopMatSize->k});
+
+  return setOpConfigAndEntryPointFnTranslation(op->getParentOfType<FuncOp>(),
+                                               op, tileSizes, {}, pipeline,
+                                               workgroupSize);
+}
+
+}  // namespace detail
+
 //===----------------------------------------------------------------------===//
 // FFT Default Configuration
 //===----------------------------------------------------------------------===//
@@ -532,6 +626,9 @@ static LogicalResult setSPIRVOpConfig(const spirv::TargetEnv &targetEnv,
   // First try to find a proper CodeGen configuration to tile and vectorize for
   // the current target architecture.
   switch (targetEnv.getVendorID()) {
+    case spirv::Vendor::AMD:
+      result = detail::setAMDCodeGenConfig(targetEnv, rootOp);
+      break;
     case spirv::Vendor::ARM:
       result = detail::setMaliCodeGenConfig(targetEnv, rootOp);
       break;
@@ -553,8 +650,16 @@ static LogicalResult setSPIRVOpConfig(const spirv::TargetEnv &targetEnv,
   // distributes/vectorizes.
   spirv::ResourceLimitsAttr limits = targetEnv.getResourceLimits();
   return TypeSwitch<Operation *, LogicalResult>(rootOp)
-      .Case<linalg::BatchMatmulOp, linalg::MatmulOp>([limits](auto op) {
-        // Try to tile and vectorize first.
+      .Case<linalg::BatchMatmulOp, linalg::MatmulOp>([limits,
+                                                       &targetEnv](auto op) {
+        // Use cooperative matrix ops if the target supports them.
+        if (auto matmulOp = dyn_cast<linalg::MatmulOp>(op.getOperation())) {
+          auto result = detail::setCooperativeMatrixConfig(targetEnv, matmulOp);
+          if (failed(result)) return result;
+          if (getLoweringConfig(op)) return result;
+        }
+
+        // Otherwise try to tile and vectorize.
         std::array<int64_t, 2> workgroupXY = {32, 2};
         std::array<int64_t, 3> threadMNK = {8, 8, 4};
         auto result = detail::setMatmulOpConfig(op, workgroupXY, threadMNK);
@@ -591,6 +696,95 @@ static LogicalResult setSPIRVOpConfig(const spirv::TargetEnv &targetEnv,
       .Default([](Operation *) { return success(); });
 };
 
+//===----------------------------------------------------------------------===//
+// Subgroup Reduction Configuration
+//===----------------------------------------------------------------------===//
+
+/// Number of elements of the reduced loop each invocation reduces serially
+/// before the partial results are combined across invocations.
+static constexpr int64_t kSubgroupReductionElementsPerInvocation = 4;
+
+/// Returns the reduction that drives the configuration of the dispatch if all
+/// of `computeOps` can be lowered with the SPIRVSubgroupReduce pipeline,
+/// nullptr otherwise. These are reductions along a long and static innermost
+/// loop, and the elementwise ops fused with them (e.g. softmax).
+static linalg::GenericOp getSubgroupReductionRoot(
+    const spirv::TargetEnv &targetEnv, ArrayRef<Operation *> computeOps) {
+  if (!targetEnv.allows(spirv::Capability::GroupNonUniformArithmetic)) {
+    return nullptr;
+  }
+  linalg::GenericOp reductionOp;
+  for (Operation *op : computeOps) {
+    auto linalgOp = dyn_cast<linalg::LinalgOp>(op);
+    if (!linalgOp ||
+        llvm::any_of(linalgOp.getIndexingMaps(), [](AffineMap map) {
+          return !map.isProjectedPermutation();
+        })) {
+      return nullptr;
+    }
+    if (linalgOp.getNumReductionLoops() == 0) continue;
+    auto genericOp = dyn_cast<linalg::GenericOp>(op);
+    if (!genericOp || reductionOp || !getSubgroupReductionCombiner(genericOp))
+      return nullptr;
+    reductionOp = genericOp;
+  }
+  if (!reductionOp) return nullptr;
+  // Consecutive invocations must read consecutive elements along the reduced
+  // loop for the loads to be coalesced.
+  unsigned reductionDim = reductionOp.getNumLoops() - 1;
+  for (OpOperand *input : reductionOp.getInputOperands()) {
+    AffineMap map = reductionOp.getTiedIndexingMap(input);
+    if (map.isFunctionOfDim(reductionDim) &&
+        map.getDimPosition(map.getNumResults() - 1) != reductionDim) {
+      return nullptr;
+    }
+  }
+  Optional<SmallVector<int64_t, 4>> staticLoopRanges =
+      reductionOp.getStaticLoopRanges();
+  if (!staticLoopRanges) return nullptr;
+  int64_t reductionSize = staticLoopRanges->back();
+  int64_t subgroupSize = targetEnv.getResourceLimits().subgroup_size().getInt();
+  if (ShapedType::isDynamic(reductionSize) ||
+      reductionSize < subgroupSize * kSubgroupReductionElementsPerInvocation) {
+    return nullptr;
+  }
+  return reductionOp;
+}
+
+/// Sets the configuration of a reduction along its innermost loop distributed
+/// across the invocations of a workgroup. Each workgroup computes a single
+/// reduction and the invocations each reduce a strided slice of the reduced
+/// loop before combining their partial results with subgroup operations.
+static LogicalResult setSubgroupReductionConfig(
+    const spirv::TargetEnv &targetEnv, linalg::GenericOp op) {
+  auto interfaceOp = cast<IREE::Flow::PartitionableLoopsInterface>(*op);
+  auto partitionedLoops =
+      interfaceOp.getPartitionableLoops(kNumMaxParallelDims);
+  SmallVector<int64_t, 4> workgroupTileSizes(op.getNumLoops(), 0);
+  for (int64_t loopIndex : partitionedLoops) {
+    workgroupTileSizes[loopIndex] = 1;
+  }
+
+  // Subgroup sizes differ widely across vendors (e.g. 16 on Mali and 64 on
+  // Adreno). The results of all subgroups are combined by a single subgroup so
+  // there can be at most as many subgroups as invocations in a subgroup.
+  spirv::ResourceLimitsAttr limits = targetEnv.getResourceLimits();
+  int64_t subgroupSize = limits.subgroup_size().getInt();
+  int64_t reductionSize = op.getStaticLoopRanges()->back();
+  int64_t numThreads = std::min<int64_t>(
+      {limits.max_compute_workgroup_invocations().getInt(),
+       subgroupSize * subgroupSize,
+       llvm::PowerOf2Floor(reductionSize /
+                           kSubgroupReductionElementsPerInvocation)});
+  numThreads = std::max<int64_t>(numThreads / subgroupSize, 1) * subgroupSize;
+
+  TileSizesListType tileSizes = {workgroupTileSizes};
+  return setOpConfigAndEntryPointFnTranslation(
+      op->getParentOfType<FuncOp>(), op, tileSizes, {},
+      IREE::Codegen::DispatchLoweringPassPipeline::SPIRVSubgroupReduce,
+      {numThreads, 1, 1});
+}
+
 //===----------------------------------------------------------------------===//
 // Entry Point
 //===----------------------------------------------------------------------===//
@@ -617,6 +811,21 @@ LogicalResult initSPIRVLaunchConfig(ModuleOp module) {
       return funcOp.emitOpError("failed to get compute ops");
     }
 
+    // Long reductions, along with the ops fused with them, are distributed
+    // across the invocations of a workgroup.
+    if (linalg::GenericOp reductionOp =
+            getSubgroupReductionRoot(targetEnv, computeOps)) {
+      if (failed(setSubgroupReductionConfig(targetEnv, reductionOp))) {
+        return failure();
+      }
+      IREE::Codegen::LoweringConfigAttr config = getLoweringConfig(reductionOp);
+      for (auto op : computeOps) {
+        if (op == reductionOp) continue;
+        setLoweringConfig(op, config);
+      }
+      continue;
+    }
+
     Operation *rootOperation = nullptr;
     // Try to find a configuration according to a matmul/convolution op and use
     // it as the root op.
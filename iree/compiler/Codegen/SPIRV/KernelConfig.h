@@ -17,6 +17,7 @@
 
 #include <array>
 
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
 #include "mlir/Dialect/Linalg/IR/LinalgInterfaces.h"
 #include "mlir/Dialect/SPIRV/IR/TargetAndABI.h"
 #include "mlir/IR/BuiltinOps.h"
@@ -39,6 +40,13 @@ LogicalResult setMatmulOpConfig(linalg::LinalgOp linalgOp,
                                 std::array<int64_t, 2> bestWorkgroupSizeXY,
                                 std::array<int64_t, 3> bestThreadTileSizeMNK);
 
+/// Sets CodeGen configurations via attributes to the given matmul `op` to
+/// lower it to cooperative matrix ops if the target environment supports the
+/// cooperative matrix capability and advertises a cooperative matrix size that
+/// tiles the matmul.
+LogicalResult setCooperativeMatrixConfig(const spirv::TargetEnv &targetEnv,
+                                         linalg::MatmulOp op);
+
 /// Sets CodeGen configuration for GPUs from a specific vendor.
 ///
 /// If the given `rootOp` has known good CodeGen configuration, attaches a
@@ -49,6 +57,8 @@ LogicalResult setMatmulOpConfig(linalg::LinalgOp linalgOp,
 /// successfullly attached as attribute. Returns failure only when there is an
 /// issue attaching the attribute.
 
+LogicalResult setAMDCodeGenConfig(const spirv::TargetEnv &targetEnv,
+                                  Operation *rootOp);
 LogicalResult setAdrenoCodeGenConfig(const spirv::TargetEnv &targetEnv,
                                      Operation *rootOp);
 LogicalResult setMaliCodeGenConfig(const spirv::TargetEnv &targetEnv,
@@ -109,6 +109,9 @@ void SPIRVLowerExecutableTargetPass::runOnOperation() {
       case IREE::Codegen::DispatchLoweringPassPipeline::SPIRVDistributeCopy:
         addSPIRVTileAndDistributeCopyPassPipeline(executableLoweringPipeline);
         break;
+      case IREE::Codegen::DispatchLoweringPassPipeline::SPIRVSubgroupReduce:
+        addSPIRVSubgroupReducePassPipeline(nestedModulePM);
+        break;
       case IREE::Codegen::DispatchLoweringPassPipeline::SPIRVVectorize:
         addSPIRVTileAndVectorizePassPipeline(nestedModulePM);
         break;
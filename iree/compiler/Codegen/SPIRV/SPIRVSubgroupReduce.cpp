@@ -0,0 +1,102 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+//===- SPIRVSubgroupReduce.cpp --------------------------------------------===//
+//
+// This pass distributes reductions along their innermost loop, and the ops
+// fused with them, onto the invocations of a workgroup. Partial results are
+// combined within subgroups using SPIR-V non-uniform group arithmetic ops and
+// across subgroups through workgroup memory.
+//
+//===----------------------------------------------------------------------===//
+
+#include "iree/compiler/Codegen/Dialect/LoweringConfig.h"
+#include "iree/compiler/Codegen/PassDetail.h"
+#include "iree/compiler/Codegen/Passes.h"
+#include "iree/compiler/Codegen/SPIRV/MemorySpace.h"
+#include "iree/compiler/Codegen/SPIRV/Utils.h"
+#include "iree/compiler/Codegen/Transforms/Transforms.h"
+#include "iree/compiler/Codegen/Utils/Utils.h"
+#include "llvm/Support/Debug.h"
+#include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
+#include "mlir/Dialect/GPU/GPUDialect.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/Dialect/SCF/SCF.h"
+#include "mlir/Dialect/SPIRV/IR/SPIRVDialect.h"
+#include "mlir/Dialect/SPIRV/IR/SPIRVOps.h"
+#include "mlir/Dialect/SPIRV/IR/TargetAndABI.h"
+
+#define DEBUG_TYPE "iree-spirv-subgroup-reduce"
+
+namespace mlir {
+namespace iree_compiler {
+namespace {
+
+class SPIRVSubgroupReducePass
+    : public SPIRVSubgroupReduceBase<SPIRVSubgroupReducePass> {
+ public:
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<arith::ArithmeticDialect, gpu::GPUDialect,
+                    memref::MemRefDialect, scf::SCFDialect,
+                    spirv::SPIRVDialect>();
+  }
+
+  void runOnOperation() override {
+    FuncOp funcOp = getOperation();
+    auto entryPointOp = getEntryPoint(funcOp);
+    if (!entryPointOp) return;
+
+    spirv::TargetEnvAttr targetEnvAttr = getSPIRVTargetEnvAttr(funcOp);
+    if (!targetEnvAttr) {
+      funcOp.emitOpError("expected parent hal.executable.variant to have "
+                         "spv.target_env attribute");
+      return signalPassFailure();
+    }
+    spirv::TargetEnv targetEnv(targetEnvAttr);
+    if (!targetEnv.allows(spirv::Capability::GroupNonUniformArithmetic)) {
+      funcOp.emitOpError("expected the target environment to support "
+                         "GroupNonUniformArithmetic");
+      return signalPassFailure();
+    }
+
+    SmallVector<int64_t> workgroupSize = getWorkgroupSize(entryPointOp);
+    if (workgroupSize.size() != 3 || workgroupSize[1] != 1 ||
+        workgroupSize[2] != 1) {
+      funcOp.emitOpError("expected a 1-D workgroup");
+      return signalPassFailure();
+    }
+
+    WorkgroupReductionOptions options;
+    options.numThreads = workgroupSize[0];
+    // The subgroup size reported by the target environment is the one used
+    // when dispatching without subgroup size control.
+    options.subgroupSize =
+        targetEnv.getResourceLimits().subgroup_size().getInt();
+    options.sharedMemorySpace = getWorkgroupMemorySpace();
+    options.subgroupReduce = buildSubgroupReduce;
+    options.buildBarrier = [](OpBuilder &builder, Location loc) {
+      builder.create<spirv::ControlBarrierOp>(
+          loc, spirv::Scope::Workgroup, spirv::Scope::Workgroup,
+          spirv::MemorySemantics::AcquireRelease |
+              spirv::MemorySemantics::WorkgroupMemory);
+    };
+    LLVM_DEBUG(llvm::dbgs() << "distributing reductions onto "
+                            << options.numThreads << " invocations, "
+                            << options.subgroupSize << " per subgroup\n");
+    if (failed(distributeReductionsToWorkgroup(funcOp, options))) {
+      return signalPassFailure();
+    }
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<OperationPass<FuncOp>> createSPIRVSubgroupReducePass() {
+  return std::make_unique<SPIRVSubgroupReducePass>();
+}
+
+}  // namespace iree_compiler
+}  // namespace mlir
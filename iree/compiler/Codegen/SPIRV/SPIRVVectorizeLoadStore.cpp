@@ -14,6 +14,7 @@
 
 #include "iree/compiler/Codegen/PassDetail.h"
 #include "iree/compiler/Codegen/Passes.h"
+#include "iree/compiler/Codegen/SPIRV/Utils.h"
 #include "iree/compiler/Codegen/Utils/Utils.h"
 #include "iree/compiler/Dialect/Util/IR/UtilOps.h"
 #include "llvm/ADT/TypeSwitch.h"
@@ -21,6 +22,7 @@
 #include "mlir/Dialect/Affine/IR/AffineOps.h"
 #include "mlir/Dialect/Linalg/IR/Linalg.h"
 #include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/Dialect/SPIRV/IR/TargetAndABI.h"
 #include "mlir/Dialect/StandardOps/IR/Ops.h"
 #include "mlir/Dialect/Vector/IR/VectorOps.h"
 #include "mlir/IR/AffineExpr.h"
@@ -80,10 +82,33 @@ static unsigned calculateMemRefVectorNumBits(
   return minBits;
 }
 
+/// Returns true if the memref `value` can only be accessed with whole 32-bit
+/// words as the target environment doesn't support 8/16-bit storage accesses
+/// for its element type. Without a target environment all accesses are assumed
+/// to be supported.
+static bool requires32BitWords(Value value) {
+  auto memrefType = value.getType().dyn_cast<MemRefType>();
+  if (!memrefType || !memrefType.getElementType().isIntOrFloat()) return false;
+  Operation *op = value.getDefiningOp();
+  if (!op) op = value.getParentBlock()->getParentOp();
+  spirv::TargetEnvAttr targetEnvAttr = getSPIRVTargetEnvAttr(op);
+  if (!targetEnvAttr) return false;
+  spirv::TargetEnv targetEnv(targetEnvAttr);
+  switch (memrefType.getElementTypeBitWidth()) {
+    case 8:
+      return !targetEnv.allows(spirv::Capability::StorageBuffer8BitAccess);
+    case 16:
+      return !targetEnv.allows(spirv::Capability::StorageBuffer16BitAccess);
+    default:
+      return false;
+  }
+}
+
 /// If the memref is vectorizable return the vector bit count we want to use,
 /// otherwise return 0. If it returns a value greater than 0 it also returns the
-/// memref uses.
-static unsigned isMemRefVectorizable(Value value,
+/// memref uses. If `requires32BitWords` is true the memref can only be accessed
+/// with whole 32-bit words.
+static unsigned isMemRefVectorizable(Value value, bool requires32BitWords,
                                      SmallVectorImpl<Operation *> &uses) {
   auto memrefType = value.getType().dyn_cast<MemRefType>();
 
@@ -107,6 +132,7 @@ static unsigned isMemRefVectorizable(Value value,
     unsigned vectorSize = vectorBits / elementNumBits;
     // Again make sure we don't have vectors of odd numbers.
     if (vectorSize % 2 != 0) return 0;
+    if (requires32BitWords && vectorBits % 32 != 0) return 0;
     return vectorBits;
   }
 
@@ -136,6 +162,13 @@ class MemRefUsageAnalysis {
     return transferOps.count(op);
   }
 
+  // Returns true if the memref should be accessed as packed 32-bit words
+  // because the target cannot load or store its narrower element type from
+  // storage buffers directly. Packed words are bitcast to vectors of the
+  // original element type in registers, which avoids emulating each narrow
+  // access with a full 32-bit load and bit manipulation.
+  bool shouldPackMemRef(Value value) const { return packedValues.count(value); }
+
  private:
   void analyzeMemRefValue(Value value);
 
@@ -144,6 +177,8 @@ class MemRefUsageAnalysis {
   llvm::DenseMap<Value, unsigned> valueToVectorBitsMap;
   // A list of transfer ops that should be adjusted for memref vectorization.
   llvm::DenseSet<Operation *> transferOps;
+  // The vectorized MemRef values that should be accessed as 32-bit words.
+  llvm::DenseSet<Value> packedValues;
 };
 
 MemRefUsageAnalysis::MemRefUsageAnalysis(mlir::Operation *op) {
@@ -160,10 +195,12 @@ MemRefUsageAnalysis::MemRefUsageAnalysis(mlir::Operation *op) {
 }
 
 void MemRefUsageAnalysis::analyzeMemRefValue(Value value) {
+  bool packed = requires32BitWords(value);
   SmallVector<Operation *, 4> vectorUses;
-  if (unsigned vectorSize = isMemRefVectorizable(value, vectorUses)) {
+  if (unsigned vectorSize = isMemRefVectorizable(value, packed, vectorUses)) {
     valueToVectorBitsMap.insert(std::make_pair(value, vectorSize));
     transferOps.insert(vectorUses.begin(), vectorUses.end());
+    if (packed) packedValues.insert(value);
   }
 }
 
@@ -316,6 +353,10 @@ class ProcessTransferWrite final
 /// memref<256xvec<4xf16>>
 /// * memref<1024xf16> vectorized with a size of 128bits will return
 /// memref<128xvec<4xf32>>
+/// The larger type is also used when the target requires packed 32-bit words
+/// for the original type, e.g.:
+/// * memref<1024xi8> vectorized with a size of 32bits will return
+/// memref<256xvec<1xi32>> if the target lacks 8-bit storage
 template <typename OpTy>
 Optional<MemRefType> MemRefConversionPattern<OpTy>::getVectorizedMemRefType(
     ConversionPatternRewriter &rewriter, Value memRefValue) const {
@@ -328,7 +369,8 @@ Optional<MemRefType> MemRefConversionPattern<OpTy>::getVectorizedMemRefType(
   unsigned vectorNumElements = vectorNumBits / scalarNumBits;
   // If the vector we need to generate is bigger than the the max vector size
   // allowed for loads use a larger element type.
-  if (vectorNumElements > kMaxVectorNumElements) {
+  if (vectorNumElements > kMaxVectorNumElements ||
+      memrefUsageAnalysis.shouldPackMemRef(memRefValue)) {
     scalarType = scalarType.isa<IntegerType>()
                      ? rewriter.getI32Type().cast<Type>()
                      : rewriter.getF32Type().cast<Type>();
@@ -12,10 +12,14 @@
 
 #include "iree/compiler/Codegen/SPIRV/Utils.h"
 
+#include "iree/compiler/Codegen/Utils/Utils.h"
 #include "iree/compiler/Dialect/HAL/IR/HALOps.h"
+#include "llvm/ADT/TypeSwitch.h"
+#include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
 #include "mlir/Dialect/GPU/GPUDialect.h"
 #include "mlir/Dialect/Linalg/IR/Linalg.h"
 #include "mlir/Dialect/Linalg/Utils/Utils.h"
+#include "mlir/Dialect/SPIRV/IR/SPIRVOps.h"
 #include "mlir/Dialect/SPIRV/IR/TargetAndABI.h"
 #include "mlir/Support/LogicalResult.h"
 
@@ -71,5 +75,77 @@ template SmallVector<linalg::ProcInfo, 2>
 getGPUProcessorIdsAndCounts<gpu::ThreadIdOp, gpu::BlockDimOp>(
     OpBuilder &builder, Location loc, unsigned numDims);
 
+Operation *getSubgroupReductionCombiner(linalg::GenericOp genericOp) {
+  Operation *combiner = getReductionCombiner(genericOp);
+  if (!combiner) return nullptr;
+  // Only 32-bit types are supported by the group ops without further
+  // capabilities on all targets.
+  Type elementType = combiner->getResult(0).getType();
+  if (!elementType.isIntOrFloat() ||
+      elementType.getIntOrFloatBitWidth() != 32) {
+    return nullptr;
+  }
+  if (!isa<arith::AddFOp, arith::MulFOp, arith::MaxFOp, arith::MinFOp,
+           arith::AddIOp, arith::MulIOp, arith::MaxSIOp, arith::MinSIOp,
+           arith::MaxUIOp, arith::MinUIOp>(combiner)) {
+    return nullptr;
+  }
+  return combiner;
+}
+
+template <typename GroupOp>
+static Value buildGroupNonUniformReduce(OpBuilder &builder, Location loc,
+                                        Value value) {
+  return builder.create<GroupOp>(loc, value.getType(), spirv::Scope::Subgroup,
+                                 spirv::GroupOperation::Reduce, value,
+                                 /*cluster_size=*/Value());
+}
+
+Value buildSubgroupReduce(OpBuilder &builder, Location loc,
+                          Operation *combiner, Value value) {
+  return TypeSwitch<Operation *, Value>(combiner)
+      .Case<arith::AddFOp>([&](auto) {
+        return buildGroupNonUniformReduce<spirv::GroupNonUniformFAddOp>(
+            builder, loc, value);
+      })
+      .Case<arith::MulFOp>([&](auto) {
+        return buildGroupNonUniformReduce<spirv::GroupNonUniformFMulOp>(
+            builder, loc, value);
+      })
+      .Case<arith::MaxFOp>([&](auto) {
+        return buildGroupNonUniformReduce<spirv::GroupNonUniformFMaxOp>(
+            builder, loc, value);
+      })
+      .Case<arith::MinFOp>([&](auto) {
+        return buildGroupNonUniformReduce<spirv::GroupNonUniformFMinOp>(
+            builder, loc, value);
+      })
+      .Case<arith::AddIOp>([&](auto) {
+        return buildGroupNonUniformReduce<spirv::GroupNonUniformIAddOp>(
+            builder, loc, value);
+      })
+      .Case<arith::MulIOp>([&](auto) {
+        return buildGroupNonUniformReduce<spirv::GroupNonUniformIMulOp>(
+            builder, loc, value);
+      })
+      .Case<arith::MaxSIOp>([&](auto) {
+        return buildGroupNonUniformReduce<spirv::GroupNonUniformSMaxOp>(
+            builder, loc, value);
+      })
+      .Case<arith::MinSIOp>([&](auto) {
+        return buildGroupNonUniformReduce<spirv::GroupNonUniformSMinOp>(
+            builder, loc, value);
+      })
+      .Case<arith::MaxUIOp>([&](auto) {
+        return buildGroupNonUniformReduce<spirv::GroupNonUniformUMaxOp>(
+            builder, loc, value);
+      })
+      .Case<arith::MinUIOp>([&](auto) {
+        return buildGroupNonUniformReduce<spirv::GroupNonUniformUMinOp>(
+            builder, loc, value);
+      })
+      .Default([](Operation *) { return Value(); });
+}
+
 }  // namespace iree_compiler
 }  // namespace mlir
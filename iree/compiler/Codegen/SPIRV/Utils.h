@@ -13,6 +13,7 @@
 #ifndef IREE_COMPILER_CODEGEN_SPIRV_UTILS_H_
 #define IREE_COMPILER_CODEGEN_SPIRV_UTILS_H_
 
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
 #include "mlir/Dialect/Linalg/Utils/Utils.h"
 #include "mlir/Dialect/SPIRV/IR/SPIRVAttributes.h"
 #include "mlir/IR/Builders.h"
@@ -35,6 +36,19 @@ SmallVector<linalg::ProcInfo, 2> getGPUProcessorIdsAndCounts(OpBuilder &builder,
                                                              Location loc,
                                                              unsigned numDims);
 
+/// Returns the op of the body of `genericOp` combining its output with the
+/// values computed from its inputs if `genericOp` is a reduction along its
+/// innermost loop that can be distributed across the invocations of a
+/// workgroup using SPIR-V non-uniform group arithmetic ops. Returns nullptr
+/// otherwise.
+Operation *getSubgroupReductionCombiner(linalg::GenericOp genericOp);
+
+/// Builds the reduction of `value` with the reduction `combiner` across the
+/// invocations of a subgroup using `spv.GroupNonUniform*` ops. Returns a null
+/// value if there is no such op for `combiner`.
+Value buildSubgroupReduce(OpBuilder &builder, Location loc,
+                          Operation *combiner, Value value);
+
 }  // namespace iree_compiler
 }  // namespace mlir
 
@@ -0,0 +1,171 @@
+// RUN: iree-opt -split-input-file -pass-pipeline='hal.executable(hal.executable.variant(iree-spirv-lower-executable-target-pass{test-lowering-configuration=true}))' %s | FileCheck %s
+
+// Mali: at most 16 subgroups of 16 invocations.
+
+#executable_layout = #hal.executable.layout<push_constants = 0, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>,
+    #hal.descriptor_set.binding<1, storage_buffer>
+  ]>
+]>
+hal.executable @row_reduction_mali {
+  hal.executable.variant @vulkan_spirv_fb, target = <"vulkan", "vulkan-spirv-fb", {
+      spv.target_env = #spv.target_env<#spv.vce<v1.4, [Shader, GroupNonUniform, GroupNonUniformArithmetic], []>, ARM:IntegratedGPU, {
+        max_compute_shared_memory_size = 32768 : i32,
+        max_compute_workgroup_invocations = 512 : i32,
+        max_compute_workgroup_size = dense<512> : vector<3xi32>,
+        subgroup_size = 16 : i32}>
+    }> {
+    hal.executable.entry_point @row_reduction_mali layout(#executable_layout)
+    builtin.module {
+      func @row_reduction_mali() {
+        %c0 = arith.constant 0 : index
+        %c512 = arith.constant 512 : index
+        %cst = arith.constant 0.000000e+00 : f32
+        %0 = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) : !flow.dispatch.tensor<readonly:512x4096xf32>
+        %1 = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) : !flow.dispatch.tensor<writeonly:512xf32>
+        %workgroup_size_x = hal.interface.workgroup.size[0] : index
+        %workgroup_id_x = hal.interface.workgroup.id[0] : index
+        %workgroup_count_x = hal.interface.workgroup.count[0] : index
+        %2 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_id_x, %workgroup_size_x]
+        %3 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_count_x, %workgroup_size_x]
+        scf.for %arg0 = %2 to %c512 step %3 {
+          %4 = affine.min affine_map<(d0)[s0] -> (s0, -d0 + 512)>(%arg0)[%workgroup_size_x]
+          %5 = flow.dispatch.tensor.load %0, offsets = [%arg0, 0], sizes = [%4, 4096], strides = [1, 1] : !flow.dispatch.tensor<readonly:512x4096xf32> -> tensor<?x4096xf32>
+          %6 = linalg.init_tensor [%4] : tensor<?xf32>
+          %7 = linalg.fill(%cst, %6) : f32, tensor<?xf32> -> tensor<?xf32>
+          %8 = linalg.generic {indexing_maps = [affine_map<(d0, d1) -> (d0, d1)>, affine_map<(d0, d1) -> (d0)>], iterator_types = ["parallel", "reduction"]} ins(%5 : tensor<?x4096xf32>) outs(%7 : tensor<?xf32>) {
+          ^bb0(%arg1: f32, %arg2: f32):
+            %9 = arith.addf %arg1, %arg2 : f32
+            linalg.yield %9 : f32
+          } -> tensor<?xf32>
+          flow.dispatch.tensor.store %8, %1, offsets = [%arg0], sizes = [%4], strides = [1] : tensor<?xf32> -> !flow.dispatch.tensor<writeonly:512xf32>
+        }
+        return
+      }
+    }
+  }
+}
+
+//  CHECK-DAG: #[[CONFIG:.+]] = #iree_codegen.lowering.config<tile_sizes = {{\[}}[1, 0]{{\]}}, native_vector_size = []>
+//  CHECK-DAG: #[[TRANSLATION:.+]] = #iree_codegen.translation.info<"SPIRVSubgroupReduce", workload_per_wg = [1]>
+//      CHECK: hal.executable.entry_point public @row_reduction_mali
+// CHECK-SAME:   translation.info = #[[TRANSLATION]]
+// CHECK-SAME:   workgroup_size = [256 : index, 1 : index, 1 : index]
+//      CHECK: func @row_reduction_mali()
+//      CHECK:   linalg.fill
+// CHECK-SAME:     lowering.config = #[[CONFIG]]
+//      CHECK:   linalg.generic
+// CHECK-SAME:     lowering.config = #[[CONFIG]]
+
+// -----
+
+// Adreno: the workgroup is bounded by the reduction size.
+
+#executable_layout = #hal.executable.layout<push_constants = 0, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>,
+    #hal.descriptor_set.binding<1, storage_buffer>
+  ]>
+]>
+hal.executable @row_reduction_adreno {
+  hal.executable.variant @vulkan_spirv_fb, target = <"vulkan", "vulkan-spirv-fb", {
+      spv.target_env = #spv.target_env<#spv.vce<v1.4, [Shader, GroupNonUniform, GroupNonUniformArithmetic], []>, Qualcomm:IntegratedGPU, {
+        max_compute_shared_memory_size = 32768 : i32,
+        max_compute_workgroup_invocations = 1024 : i32,
+        max_compute_workgroup_size = dense<[1024, 1024, 64]> : vector<3xi32>,
+        subgroup_size = 64 : i32}>
+    }> {
+    hal.executable.entry_point @row_reduction_adreno layout(#executable_layout)
+    builtin.module {
+      func @row_reduction_adreno() {
+        %c0 = arith.constant 0 : index
+        %c512 = arith.constant 512 : index
+        %cst = arith.constant 0.000000e+00 : f32
+        %0 = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) : !flow.dispatch.tensor<readonly:512x4096xf32>
+        %1 = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) : !flow.dispatch.tensor<writeonly:512xf32>
+        %workgroup_size_x = hal.interface.workgroup.size[0] : index
+        %workgroup_id_x = hal.interface.workgroup.id[0] : index
+        %workgroup_count_x = hal.interface.workgroup.count[0] : index
+        %2 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_id_x, %workgroup_size_x]
+        %3 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_count_x, %workgroup_size_x]
+        scf.for %arg0 = %2 to %c512 step %3 {
+          %4 = affine.min affine_map<(d0)[s0] -> (s0, -d0 + 512)>(%arg0)[%workgroup_size_x]
+          %5 = flow.dispatch.tensor.load %0, offsets = [%arg0, 0], sizes = [%4, 4096], strides = [1, 1] : !flow.dispatch.tensor<readonly:512x4096xf32> -> tensor<?x4096xf32>
+          %6 = linalg.init_tensor [%4] : tensor<?xf32>
+          %7 = linalg.fill(%cst, %6) : f32, tensor<?xf32> -> tensor<?xf32>
+          %8 = linalg.generic {indexing_maps = [affine_map<(d0, d1) -> (d0, d1)>, affine_map<(d0, d1) -> (d0)>], iterator_types = ["parallel", "reduction"]} ins(%5 : tensor<?x4096xf32>) outs(%7 : tensor<?xf32>) {
+          ^bb0(%arg1: f32, %arg2: f32):
+            %9 = arith.addf %arg1, %arg2 : f32
+            linalg.yield %9 : f32
+          } -> tensor<?xf32>
+          flow.dispatch.tensor.store %8, %1, offsets = [%arg0], sizes = [%4], strides = [1] : tensor<?xf32> -> !flow.dispatch.tensor<writeonly:512xf32>
+        }
+        return
+      }
+    }
+  }
+}
+
+//  CHECK-DAG: #[[CONFIG:.+]] = #iree_codegen.lowering.config<tile_sizes = {{\[}}[1, 0]{{\]}}, native_vector_size = []>
+//  CHECK-DAG: #[[TRANSLATION:.+]] = #iree_codegen.translation.info<"SPIRVSubgroupReduce", workload_per_wg = [1]>
+//      CHECK: hal.executable.entry_point public @row_reduction_adreno
+// CHECK-SAME:   translation.info = #[[TRANSLATION]]
+// CHECK-SAME:   workgroup_size = [1024 : index, 1 : index, 1 : index]
+//      CHECK: func @row_reduction_adreno()
+//      CHECK:   linalg.fill
+// CHECK-SAME:     lowering.config = #[[CONFIG]]
+//      CHECK:   linalg.generic
+// CHECK-SAME:     lowering.config = #[[CONFIG]]
+
+// -----
+
+// No subgroup arithmetic ops: fall back to the default configuration.
+
+#executable_layout = #hal.executable.layout<push_constants = 0, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>,
+    #hal.descriptor_set.binding<1, storage_buffer>
+  ]>
+]>
+hal.executable @row_reduction_no_subgroup_arithmetic {
+  hal.executable.variant @vulkan_spirv_fb, target = <"vulkan", "vulkan-spirv-fb", {
+      spv.target_env = #spv.target_env<#spv.vce<v1.4, [Shader], []>, ARM:IntegratedGPU, {
+        max_compute_shared_memory_size = 32768 : i32,
+        max_compute_workgroup_invocations = 512 : i32,
+        max_compute_workgroup_size = dense<512> : vector<3xi32>,
+        subgroup_size = 16 : i32}>
+    }> {
+    hal.executable.entry_point @row_reduction_no_subgroup_arithmetic layout(#executable_layout)
+    builtin.module {
+      func @row_reduction_no_subgroup_arithmetic() {
+        %c0 = arith.constant 0 : index
+        %c512 = arith.constant 512 : index
+        %cst = arith.constant 0.000000e+00 : f32
+        %0 = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) : !flow.dispatch.tensor<readonly:512x4096xf32>
+        %1 = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) : !flow.dispatch.tensor<writeonly:512xf32>
+        %workgroup_size_x = hal.interface.workgroup.size[0] : index
+        %workgroup_id_x = hal.interface.workgroup.id[0] : index
+        %workgroup_count_x = hal.interface.workgroup.count[0] : index
+        %2 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_id_x, %workgroup_size_x]
+        %3 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_count_x, %workgroup_size_x]
+        scf.for %arg0 = %2 to %c512 step %3 {
+          %4 = affine.min affine_map<(d0)[s0] -> (s0, -d0 + 512)>(%arg0)[%workgroup_size_x]
+          %5 = flow.dispatch.tensor.load %0, offsets = [%arg0, 0], sizes = [%4, 4096], strides = [1, 1] : !flow.dispatch.tensor<readonly:512x4096xf32> -> tensor<?x4096xf32>
+          %6 = linalg.init_tensor [%4] : tensor<?xf32>
+          %7 = linalg.fill(%cst, %6) : f32, tensor<?xf32> -> tensor<?xf32>
+          %8 = linalg.generic {indexing_maps = [affine_map<(d0, d1) -> (d0, d1)>, affine_map<(d0, d1) -> (d0)>], iterator_types = ["parallel", "reduction"]} ins(%5 : tensor<?x4096xf32>) outs(%7 : tensor<?xf32>) {
+          ^bb0(%arg1: f32, %arg2: f32):
+            %9 = arith.addf %arg1, %arg2 : f32
+            linalg.yield %9 : f32
+          } -> tensor<?xf32>
+          flow.dispatch.tensor.store %8, %1, offsets = [%arg0], sizes = [%4], strides = [1] : tensor<?xf32> -> !flow.dispatch.tensor<writeonly:512xf32>
+        }
+        return
+      }
+    }
+  }
+}
+
+//  CHECK-NOT: "SPIRVSubgroupReduce"
+//      CHECK: hal.executable.entry_point public @row_reduction_no_subgroup_arithmetic
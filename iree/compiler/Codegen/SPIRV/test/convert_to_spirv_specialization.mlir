@@ -0,0 +1,38 @@
+// RUN: iree-opt -split-input-file -pass-pipeline='hal.executable(hal.executable.variant(builtin.module(iree-convert-to-spirv{specialize-push-constants=true})))' %s | FileCheck %s
+
+#executable_layout = #hal.executable.layout<push_constants = 5, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>
+  ]>
+]>
+hal.executable private @specialize_push_constants {
+  hal.executable.variant @vulkan, target = <"vulkan-spirv", "vulkan-spirv-fb", {
+      spv.target_env = #spv.target_env<#spv.vce<v1.3, [Shader], []>, {}>}> {
+    hal.executable.entry_point @specialize_push_constants layout(#executable_layout) attributes {
+      workgroup_size = [32: index, 1: index, 1: index]
+    }
+    builtin.module {
+      // CHECK-LABEL: spv.module
+      // CHECK-SAME: iree.spirv.specializable_push_constant_count = 3 : i32
+      // CHECK-DAG: spv.SpecConstant @[[VALUE0:.+]] spec_id(0) = 0 : i32
+      // CHECK-DAG: spv.SpecConstant @[[ENABLED0:.+]] spec_id(1) = false
+      // CHECK-DAG: spv.SpecConstant @[[VALUE2:.+]] spec_id(4) = 0 : i32
+      // CHECK-DAG: spv.SpecConstant @[[ENABLED2:.+]] spec_id(5) = false
+      // CHECK-NOT: spv.SpecConstant
+      // CHECK: spv.func @specialize_push_constants()
+      func @specialize_push_constants() {
+        // CHECK: %[[LOAD0:.+]] = spv.Load "PushConstant"
+        // CHECK-DAG: %[[SPEC_VALUE0:.+]] = spv.mlir.referenceof @[[VALUE0]] : i32
+        // CHECK-DAG: %[[SPEC_ENABLED0:.+]] = spv.mlir.referenceof @[[ENABLED0]] : i1
+        // CHECK: spv.Select %[[SPEC_ENABLED0]], %[[SPEC_VALUE0]], %[[LOAD0]] : i1, i32
+        %0 = hal.interface.constant.load[0] : index
+        // CHECK: %[[LOAD2:.+]] = spv.Load "PushConstant"
+        // CHECK-DAG: %[[SPEC_VALUE2:.+]] = spv.mlir.referenceof @[[VALUE2]] : i32
+        // CHECK-DAG: %[[SPEC_ENABLED2:.+]] = spv.mlir.referenceof @[[ENABLED2]] : i1
+        // CHECK: spv.Select %[[SPEC_ENABLED2]], %[[SPEC_VALUE2]], %[[LOAD2]] : i1, i32
+        %1 = hal.interface.constant.load[2] : index
+        return
+      }
+    }
+  }
+}
@@ -0,0 +1,85 @@
+// RUN: iree-opt -pass-pipeline='hal.executable(hal.executable.variant(builtin.module(builtin.func(iree-spirv-subgroup-reduce))))' %s | FileCheck %s
+
+#executable_layout = #hal.executable.layout<push_constants = 0, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>,
+    #hal.descriptor_set.binding<1, storage_buffer>
+  ]>
+]>
+hal.executable private @normalize_rows  {
+  hal.executable.variant @vulkan_spirv_fb, target = <"vulkan", "vulkan-spirv-fb", {
+      spv.target_env = #spv.target_env<#spv.vce<v1.4, [Shader, GroupNonUniform, GroupNonUniformArithmetic], []>, ARM:IntegratedGPU, {
+        max_compute_shared_memory_size = 32768 : i32,
+        max_compute_workgroup_invocations = 512 : i32,
+        max_compute_workgroup_size = dense<512> : vector<3xi32>,
+        subgroup_size = 16 : i32}>
+    }> {
+    hal.executable.entry_point @normalize_rows layout(#executable_layout) attributes {
+      workgroup_size = [64: index, 1: index, 1: index]
+    }
+    builtin.module {
+      builtin.func @normalize_rows(%in : memref<1x1024xf32>, %out : memref<1x1024xf32>) {
+        %cst = arith.constant 0.000000e+00 : f32
+        %max = memref.alloc() : memref<1xf32, 3>
+        linalg.fill(%cst, %max) : f32, memref<1xf32, 3>
+        linalg.generic {
+            indexing_maps = [affine_map<(d0, d1) -> (d0, d1)>, affine_map<(d0, d1) -> (d0)>],
+            iterator_types = ["parallel", "reduction"]}
+            ins(%in : memref<1x1024xf32>) outs(%max : memref<1xf32, 3>) {
+        ^bb0(%arg0: f32, %arg1: f32):
+          %0 = arith.maxf %arg0, %arg1 : f32
+          linalg.yield %0 : f32
+        }
+        linalg.generic {
+            indexing_maps = [affine_map<(d0, d1) -> (d0, d1)>, affine_map<(d0, d1) -> (d0)>, affine_map<(d0, d1) -> (d0, d1)>],
+            iterator_types = ["parallel", "parallel"]}
+            ins(%in, %max : memref<1x1024xf32>, memref<1xf32, 3>) outs(%out : memref<1x1024xf32>) {
+        ^bb0(%arg0: f32, %arg1: f32, %arg2: f32):
+          %0 = arith.subf %arg0, %arg1 : f32
+          linalg.yield %0 : f32
+        }
+        return
+      }
+    }
+  }
+}
+
+// CHECK-LABEL: func @normalize_rows
+//  CHECK-SAME:     (%[[IN:.+]]: memref<1x1024xf32>, %[[OUT:.+]]: memref<1x1024xf32>)
+//       CHECK:   %[[MAX:.+]] = memref.alloc() : memref<1xf32, 3>
+//       CHECK:   %[[TID0:.+]] = gpu.thread_id x
+//       CHECK:   scf.for %[[J0:.+]] = %[[TID0]] to %{{.+}} step %{{.+}} {
+//       CHECK:     memref.store %{{.+}}, %[[MAX]][%[[J0]]] : memref<1xf32, 3>
+//       CHECK:   spv.ControlBarrier Workgroup, Workgroup, "AcquireRelease|WorkgroupMemory"
+//       CHECK:   %[[TID1:.+]] = gpu.thread_id x
+//       CHECK:   %[[IDENTITY:.+]] = arith.constant 0xFF800000 : f32
+//       CHECK:   %[[SUBGROUP_MAXS:.+]] = memref.alloc() : memref<4xf32, 3>
+//       CHECK:   scf.for %[[I:.+]] = %{{.+}} to %{{.+}} step %{{.+}} {
+//       CHECK:     %[[PARTIAL:.+]] = scf.for %[[K:.+]] = %[[TID1]] to %{{.+}} step %{{.+}} iter_args(%[[ACC:.+]] = %[[IDENTITY]]) -> (f32) {
+//       CHECK:       %[[V:.+]] = memref.load %[[IN]][%[[I]], %[[K]]] : memref<1x1024xf32>
+//       CHECK:       %[[M:.+]] = arith.maxf %[[V]], %[[ACC]] : f32
+//       CHECK:       scf.yield %[[M]] : f32
+//       CHECK:     }
+//       CHECK:     %[[SUBGROUP_MAX:.+]] = spv.GroupNonUniformFMax "Subgroup" "Reduce" %[[PARTIAL]] : f32
+//       CHECK:     scf.if
+//       CHECK:       memref.store %[[SUBGROUP_MAX]], %[[SUBGROUP_MAXS]][%{{.+}}] : memref<4xf32, 3>
+//       CHECK:     spv.ControlBarrier
+//       CHECK:     %[[LOADED:.+]] = scf.if
+//       CHECK:       memref.load %[[SUBGROUP_MAXS]]
+//       CHECK:     } else {
+//       CHECK:       scf.yield %[[IDENTITY]] : f32
+//       CHECK:     spv.GroupNonUniformFMax "Subgroup" "Reduce" %[[LOADED]] : f32
+//       CHECK:     scf.if
+//       CHECK:       %[[INIT:.+]] = memref.load %[[MAX]][%[[I]]] : memref<1xf32, 3>
+//       CHECK:       %[[TOTAL:.+]] = arith.maxf %{{.+}}, %[[INIT]] : f32
+//       CHECK:       memref.store %[[TOTAL]], %[[MAX]][%[[I]]] : memref<1xf32, 3>
+//       CHECK:     spv.ControlBarrier
+//       CHECK:   spv.ControlBarrier
+//       CHECK:   %[[TID2:.+]] = gpu.thread_id x
+//       CHECK:   scf.for %[[I2:.+]] = %{{.+}} to %{{.+}} step %{{.+}} {
+//       CHECK:     scf.for %[[J2:.+]] = %[[TID2]] to %{{.+}} step %{{.+}} {
+//   CHECK-DAG:       %[[X:.+]] = memref.load %[[IN]][%[[I2]], %[[J2]]] : memref<1x1024xf32>
+//   CHECK-DAG:       %[[S:.+]] = memref.load %[[MAX]][%[[I2]]] : memref<1xf32, 3>
+//       CHECK:       %[[SUB:.+]] = arith.subf %[[X]], %[[S]] : f32
+//       CHECK:       memref.store %[[SUB]], %[[OUT]][%[[I2]], %[[J2]]] : memref<1x1024xf32>
+//   CHECK-NOT:   linalg.generic
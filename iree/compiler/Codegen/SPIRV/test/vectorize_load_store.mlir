@@ -205,3 +205,31 @@ func @scalarize_vector_transfer_op(%arg: vector<3xf32>) -> (vector<3xf32>) {
   vector.transfer_write %arg, %2[%c3] : vector<3xf32>, memref<20xf32>
   return %3: vector<3xf32>
 }
+
+// -----
+
+// Without 8-bit storage capabilities i8 buffers are accessed as 32-bit words.
+
+hal.executable private @pack_i8_storage {
+  hal.executable.variant @vulkan, target = <"vulkan-spirv", "vulkan-spirv-fb", {
+      spv.target_env = #spv.target_env<#spv.vce<v1.4, [Shader], []>, {}>}> {
+    builtin.module {
+      // CHECK-LABEL: func @pack_i8_storage
+      //       CHECK: %[[A:.+]] = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) : memref<1024xvector<1xi32>>
+      //       CHECK: %[[B:.+]] = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) : memref<1024xvector<1xi32>>
+      //       CHECK: %[[LOAD:.+]] = memref.load %[[A]][%{{.+}}] : memref<1024xvector<1xi32>>
+      //       CHECK: %[[CAST:.+]] = vector.bitcast %[[LOAD]] : vector<1xi32> to vector<4xi8>
+      //       CHECK: %[[STORE:.+]] = vector.bitcast %[[CAST]] : vector<4xi8> to vector<1xi32>
+      //       CHECK: memref.store %[[STORE]], %[[B]][%{{.+}}] : memref<1024xvector<1xi32>>
+      func @pack_i8_storage(%i: index) {
+        %c0 = arith.constant 0 : index
+        %c0_i8 = arith.constant 0 : i8
+        %0 = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) : memref<4096xi8>
+        %1 = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) : memref<4096xi8>
+        %v = vector.transfer_read %0[%i], %c0_i8 : memref<4096xi8>, vector<4xi8>
+        vector.transfer_write %v, %1[%i] : vector<4xi8>, memref<4096xi8>
+        return
+      }
+    }
+  }
+}
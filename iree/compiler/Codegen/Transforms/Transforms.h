@@ -56,6 +56,35 @@ using GetMinMaxExprFn =
 void populateRemoveSingleIterationLoopPattern(RewritePatternSet &patterns,
                                               GetMinMaxExprFn getMinMaxFn);
 
+/// Target-specific hooks used to distribute reductions onto the threads of a
+/// workgroup with `distributeReductionsToWorkgroup`.
+struct WorkgroupReductionOptions {
+  /// Number of threads of the 1-D workgroup.
+  int64_t numThreads;
+  /// Number of threads of a subgroup (warp on CUDA).
+  int64_t subgroupSize;
+  /// Memory space of the buffer exchanging the results of the subgroups.
+  unsigned sharedMemorySpace;
+  /// Builds the reduction of `value` across the threads of a subgroup with the
+  /// reduction `combiner`, such that all threads hold the result. Returns a
+  /// null value if `combiner` or the type of `value` is not supported.
+  std::function<Value(OpBuilder &builder, Location loc, Operation *combiner,
+                      Value value)>
+      subgroupReduce;
+  /// Builds a barrier across the threads of the workgroup which also makes the
+  /// writes to shared memory visible.
+  std::function<void(OpBuilder &builder, Location loc)> buildBarrier;
+};
+
+/// Replaces the linalg ops of `funcOp`, which must have been tiled to a single
+/// reduction (or row of elementwise ops) per workgroup, with loops distributed
+/// onto the threads of the workgroup. Parallel ops are distributed cyclically
+/// along their innermost loop. Reductions along their innermost loop are
+/// computed by each thread over a strided slice, then combined across each
+/// subgroup and finally across subgroups through shared memory.
+LogicalResult distributeReductionsToWorkgroup(
+    FuncOp funcOp, const WorkgroupReductionOptions &options);
+
 /// Insert pattern to fold chains of `affine.min` operations.
 // TODO: It is not clear what this pattern is doing and should be deprecated.
 void populateAffineMinCanonicalizationPattern(RewritePatternSet &patterns);
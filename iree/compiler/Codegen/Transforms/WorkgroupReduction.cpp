@@ -0,0 +1,299 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+//===- WorkgroupReduction.cpp - Distribute reductions onto threads --------===//
+//
+// Implements the distribution of reductions along their innermost loop, and of
+// the ops fused with them, onto the threads of a 1-D workgroup. The parts that
+// differ between GPU targets are provided through WorkgroupReductionOptions.
+//
+//===----------------------------------------------------------------------===//
+
+#include "iree/compiler/Codegen/Transforms/Transforms.h"
+#include "iree/compiler/Codegen/Utils/Utils.h"
+#include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
+#include "mlir/Dialect/GPU/GPUDialect.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/Dialect/SCF/SCF.h"
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/IR/Builders.h"
+
+namespace mlir {
+namespace iree_compiler {
+
+/// Returns the indices into an operand accessed with the projected permutation
+/// `map` at the iteration `ivs`.
+static SmallVector<Value> getIndices(AffineMap map, ValueRange ivs) {
+  SmallVector<Value> indices;
+  for (unsigned i = 0, e = map.getNumResults(); i < e; ++i) {
+    indices.push_back(ivs[map.getDimPosition(i)]);
+  }
+  return indices;
+}
+
+/// Returns the values of the operands of `linalgOp` at the iteration `ivs`.
+/// Memref operands are loaded and scalar operands are used as is.
+static SmallVector<Value> loadOperands(OpBuilder &builder, Location loc,
+                                       linalg::LinalgOp linalgOp,
+                                       ArrayRef<OpOperand *> operands,
+                                       ValueRange ivs) {
+  SmallVector<Value> values;
+  for (OpOperand *operand : operands) {
+    if (!operand->get().getType().isa<MemRefType>()) {
+      values.push_back(operand->get());
+      continue;
+    }
+    values.push_back(builder.create<memref::LoadOp>(
+        loc, operand->get(),
+        getIndices(linalgOp.getTiedIndexingMap(operand), ivs)));
+  }
+  return values;
+}
+
+/// Clones the body of `linalgOp` for the iteration `ivs` with its arguments
+/// replaced by `args` and returns the yielded values.
+static SmallVector<Value> cloneBody(OpBuilder &builder,
+                                    linalg::LinalgOp linalgOp, ValueRange ivs,
+                                    ValueRange args) {
+  Block *body = linalgOp.getBlock();
+  BlockAndValueMapping mapping;
+  mapping.map(body->getArguments(), args);
+  for (Operation &op : body->without_terminator()) {
+    if (auto indexOp = dyn_cast<linalg::IndexOp>(op)) {
+      mapping.map(indexOp.getResult(), ivs[indexOp.dim()]);
+      continue;
+    }
+    builder.clone(op, mapping);
+  }
+  return llvm::to_vector(llvm::map_range(
+      body->getTerminator()->getOperands(),
+      [&](Value value) { return mapping.lookupOrDefault(value); }));
+}
+
+/// Combines `lhs` and `rhs` with a clone of the reduction `combiner`.
+static Value combine(OpBuilder &builder, Operation *combiner, Value lhs,
+                     Value rhs) {
+  BlockAndValueMapping mapping;
+  mapping.map(combiner->getOperand(0), lhs);
+  mapping.map(combiner->getOperand(1), rhs);
+  return builder.clone(*combiner, mapping)->getResult(0);
+}
+
+/// Builds the loops along all but the innermost loop of `linalgOp` and calls
+/// `bodyBuilder` with the induction variables of the outer loops.
+static void buildOuterLoops(
+    OpBuilder &builder, Location loc, ArrayRef<Range> loopRanges,
+    function_ref<void(OpBuilder &, SmallVectorImpl<Value> &)> bodyBuilder) {
+  SmallVector<Value> ivs;
+  OpBuilder::InsertionGuard guard(builder);
+  for (const Range &range : loopRanges.drop_back()) {
+    auto forOp = builder.create<scf::ForOp>(loc, range.offset, range.size,
+                                            range.stride);
+    ivs.push_back(forOp.getInductionVar());
+    builder.setInsertionPoint(forOp.getBody()->getTerminator());
+  }
+  bodyBuilder(builder, ivs);
+}
+
+/// Replaces `linalgOp`, which only has parallel loops, with loops where the
+/// innermost one is distributed cyclically onto the `numThreads` threads of
+/// the workgroup so that accesses to contiguous memory are coalesced.
+static void distributeParallelOp(OpBuilder &builder, linalg::LinalgOp linalgOp,
+                                 Value threadId, Value numThreads) {
+  Location loc = linalgOp.getLoc();
+  SmallVector<Range> loopRanges = linalgOp.createLoopRanges(builder, loc);
+  buildOuterLoops(
+      builder, loc, loopRanges,
+      [&](OpBuilder &builder, SmallVectorImpl<Value> &ivs) {
+        auto forOp = builder.create<scf::ForOp>(
+            loc, threadId, loopRanges.back().size, numThreads);
+        OpBuilder::InsertionGuard guard(builder);
+        builder.setInsertionPoint(forOp.getBody()->getTerminator());
+        ivs.push_back(forOp.getInductionVar());
+        SmallVector<Value> args = loadOperands(
+            builder, loc, linalgOp, linalgOp.getInputAndOutputOperands(), ivs);
+        SmallVector<Value> results = cloneBody(builder, linalgOp, ivs, args);
+        for (auto output : llvm::enumerate(linalgOp.getOutputOperands())) {
+          builder.create<memref::StoreOp>(
+              loc, results[output.index()], output.value()->get(),
+              getIndices(linalgOp.getTiedIndexingMap(output.value()), ivs));
+        }
+      });
+}
+
+/// Replaces the reduction `genericOp` with loops where each of the threads of
+/// the workgroup reduces a strided slice of the innermost loop. The partial
+/// results are combined within each subgroup using the target-specific
+/// `options.subgroupReduce` and across subgroups through shared memory.
+///
+/// Example with 64 threads and warp shuffles on CUDA:
+///   %partial = scf.for %k = %tid to %size step %c64
+///       iter_args(%acc = %identity) -> (f32) {
+///     %in = memref.load %input[%i, %k] : memref<?x?xf32>
+///     %sum = arith.addf %in, %acc : f32
+///     scf.yield %sum : f32
+///   }
+///   %warp_sum = (gpu.shuffle xor + arith.addf) x 5
+///   scf.if %lane_is_0 {
+///     memref.store %warp_sum, %shared[%warp_id] : memref<2xf32, 3>
+///   }
+///   gpu.barrier
+///   %sum = (gpu.shuffle xor + arith.addf) x 5 of %shared[%lane] or %identity
+///   scf.if %tid_is_0 {
+///     ... combine %sum with %output[%i] and store it ...
+///   }
+static LogicalResult distributeReductionOp(
+    OpBuilder &builder, linalg::GenericOp genericOp, Operation *combiner,
+    Value threadId, const WorkgroupReductionOptions &options) {
+  Location loc = genericOp.getLoc();
+  Type elementType = combiner->getResult(0).getType();
+  Value identity =
+      builder.create<arith::ConstantOp>(loc, getReductionIdentity(combiner));
+  Value zero = builder.create<arith::ConstantIndexOp>(loc, 0);
+  Value numThreadsValue =
+      builder.create<arith::ConstantIndexOp>(loc, options.numThreads);
+  Value subgroupSize =
+      builder.create<arith::ConstantIndexOp>(loc, options.subgroupSize);
+  Value laneId = builder.create<arith::RemUIOp>(loc, threadId, subgroupSize);
+  Value subgroupId =
+      builder.create<arith::DivUIOp>(loc, threadId, subgroupSize);
+  Value isLane0 = builder.create<arith::CmpIOp>(loc, arith::CmpIPredicate::eq,
+                                                laneId, zero);
+  Value isThread0 = builder.create<arith::CmpIOp>(
+      loc, arith::CmpIPredicate::eq, threadId, zero);
+
+  // Partial results of each subgroup are exchanged through shared memory.
+  int64_t numSubgroups = options.numThreads / options.subgroupSize;
+  Value sharedMemory;
+  if (numSubgroups > 1) {
+    sharedMemory = builder.create<memref::AllocOp>(
+        loc, MemRefType::get({numSubgroups}, elementType, {},
+                             options.sharedMemorySpace));
+  }
+
+  SmallVector<Range> loopRanges = genericOp.createLoopRanges(builder, loc);
+  bool isSupported = true;
+  buildOuterLoops(
+      builder, loc, loopRanges,
+      [&](OpBuilder &builder, SmallVectorImpl<Value> &ivs) {
+        auto forOp =
+            builder.create<scf::ForOp>(loc, threadId, loopRanges.back().size,
+                                       numThreadsValue, ValueRange{identity});
+        {
+          OpBuilder::InsertionGuard guard(builder);
+          builder.setInsertionPointToStart(forOp.getBody());
+          ivs.push_back(forOp.getInductionVar());
+          SmallVector<Value> args = loadOperands(
+              builder, loc, genericOp, genericOp.getInputOperands(), ivs);
+          args.push_back(forOp.getRegionIterArgs().front());
+          SmallVector<Value> results =
+              cloneBody(builder, genericOp, ivs, args);
+          builder.create<scf::YieldOp>(loc, results);
+          ivs.pop_back();
+        }
+        Value result =
+            options.subgroupReduce(builder, loc, combiner, forOp.getResult(0));
+        if (!result) {
+          isSupported = false;
+          return;
+        }
+
+        if (numSubgroups > 1) {
+          builder.create<scf::IfOp>(
+              loc, isLane0, [&](OpBuilder &builder, Location loc) {
+                builder.create<memref::StoreOp>(loc, result, sharedMemory,
+                                                subgroupId);
+                builder.create<scf::YieldOp>(loc);
+              });
+          options.buildBarrier(builder, loc);
+          Value isSubgroupResult = builder.create<arith::CmpIOp>(
+              loc, arith::CmpIPredicate::ult, laneId,
+              builder.create<arith::ConstantIndexOp>(loc, numSubgroups));
+          auto ifOp = builder.create<scf::IfOp>(
+              loc, elementType, isSubgroupResult,
+              [&](OpBuilder &builder, Location loc) {
+                Value subgroupResult =
+                    builder.create<memref::LoadOp>(loc, sharedMemory, laneId);
+                builder.create<scf::YieldOp>(loc, subgroupResult);
+              },
+              [&](OpBuilder &builder, Location loc) {
+                builder.create<scf::YieldOp>(loc, identity);
+              });
+          result = options.subgroupReduce(builder, loc, combiner,
+                                          ifOp.getResult(0));
+        }
+
+        // The reduction is combined with the initial value of the output
+        // once.
+        OpOperand *output = genericOp.getOutputOperand(0);
+        builder.create<scf::IfOp>(
+            loc, isThread0, [&](OpBuilder &builder, Location loc) {
+              SmallVector<Value> indices =
+                  getIndices(genericOp.getTiedIndexingMap(output), ivs);
+              Value init =
+                  builder.create<memref::LoadOp>(loc, output->get(), indices);
+              builder.create<memref::StoreOp>(
+                  loc, combine(builder, combiner, result, init),
+                  output->get(), indices);
+              builder.create<scf::YieldOp>(loc);
+            });
+        // Shared memory is reused by the next iteration.
+        if (numSubgroups > 1) options.buildBarrier(builder, loc);
+      });
+  return success(isSupported);
+}
+
+LogicalResult distributeReductionsToWorkgroup(
+    FuncOp funcOp, const WorkgroupReductionOptions &options) {
+  int64_t numSubgroups = options.numThreads / options.subgroupSize;
+  if (options.numThreads % options.subgroupSize != 0 ||
+      numSubgroups > options.subgroupSize) {
+    return funcOp.emitOpError("expected a 1-D workgroup of at most ")
+           << options.subgroupSize << " whole subgroups of "
+           << options.subgroupSize << " threads, got " << options.numThreads
+           << " threads";
+  }
+
+  SmallVector<linalg::LinalgOp> linalgOps;
+  funcOp.walk(
+      [&](linalg::LinalgOp linalgOp) { linalgOps.push_back(linalgOp); });
+  for (linalg::LinalgOp linalgOp : linalgOps) {
+    if (!linalgOp.hasBufferSemantics() ||
+        llvm::any_of(linalgOp.getIndexingMaps(), [](AffineMap map) {
+          return !map.isProjectedPermutation();
+        })) {
+      return linalgOp.emitOpError("unsupported op for workgroup reduction");
+    }
+  }
+
+  // Each op reads the values written by the threads that distributed the
+  // previous ops so they are separated by barriers.
+  for (auto linalgOp : llvm::enumerate(linalgOps)) {
+    OpBuilder builder(linalgOp.value());
+    Location loc = linalgOp.value().getLoc();
+    if (linalgOp.index() != 0) options.buildBarrier(builder, loc);
+    Value threadId = builder.create<gpu::ThreadIdOp>(
+        loc, builder.getIndexType(), gpu::Dimension::x);
+    auto genericOp = dyn_cast<linalg::GenericOp>(*linalgOp.value());
+    Operation *combiner = genericOp ? getReductionCombiner(genericOp) : nullptr;
+    if (linalgOp.value().getNumReductionLoops() == 0) {
+      distributeParallelOp(
+          builder, linalgOp.value(), threadId,
+          builder.create<arith::ConstantIndexOp>(loc, options.numThreads));
+    } else if (!combiner || failed(distributeReductionOp(
+                                builder, genericOp, combiner, threadId,
+                                options))) {
+      return linalgOp.value().emitOpError(
+          "unsupported reduction for workgroup reduction");
+    }
+    linalgOp.value()->erase();
+  }
+  return success();
+}
+
+}  // namespace iree_compiler
+}  // namespace mlir
@@ -15,6 +15,7 @@
 #include "llvm/ADT/SmallSet.h"
 #include "llvm/ADT/TypeSwitch.h"
 #include "llvm/Support/Debug.h"
+#include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
 #include "mlir/Dialect/Linalg/Utils/Utils.h"
 #include "mlir/IR/AffineExprVisitor.h"
 #include "mlir/IR/Matchers.h"
@@ -51,9 +52,7 @@ llvm::StringMap<IREE::HAL::ExecutableEntryPointOp> getAllEntryPoints(
   return entryPointOps;
 }
 
-/// Returns the LLVM Target triple associated with the `hal.executable.variant`
-/// operation if set.
-static Optional<llvm::Triple> getTargetTriple(
+Optional<llvm::Triple> getTargetTriple(
     IREE::HAL::ExecutableVariantOp variantOp) {
   IREE::HAL::ExecutableTargetAttr targetAttr = variantOp.target();
   if (!targetAttr) return llvm::None;
@@ -69,6 +68,11 @@ bool isX86(IREE::HAL::ExecutableVariantOp variantOp) {
   return triple && triple.getValue().isX86();
 }
 
+bool isRISCV(IREE::HAL::ExecutableVariantOp variantOp) {
+  Optional<llvm::Triple> triple = getTargetTriple(variantOp);
+  return triple && triple.getValue().isRISCV();
+}
+
 //===----------------------------------------------------------------------===//
 // Utility functions to get untiled op shapes
 //===----------------------------------------------------------------------===//
@@ -584,6 +588,25 @@ LogicalResult getComputeOps(
   return success();
 }
 
+Operation *getReductionFusedWithConsumers(ArrayRef<Operation *> computeOps) {
+  llvm::SmallPtrSet<Operation *, 4> computeOpsSet(computeOps.begin(),
+                                                  computeOps.end());
+  Operation *fusedReduction = nullptr;
+  for (Operation *op : computeOps) {
+    auto genericOp = dyn_cast<linalg::GenericOp>(op);
+    if (!genericOp || genericOp.getNumReductionLoops() == 0) continue;
+    for (Operation *user : genericOp->getUsers()) {
+      auto consumer = dyn_cast<linalg::LinalgOp>(user);
+      if (consumer && computeOpsSet.count(user) &&
+          consumer.getNumLoops() == genericOp.getNumLoops()) {
+        fusedReduction = op;
+        break;
+      }
+    }
+  }
+  return fusedReduction;
+}
+
 SmallVector<LoopTilingAndDistributionInfo> getTiledAndDistributedLoopInfo(
     FuncOp funcOp) {
   SmallVector<LoopTilingAndDistributionInfo> info;
@@ -598,6 +621,70 @@ SmallVector<LoopTilingAndDistributionInfo> getTiledAndDistributedLoopInfo(
 /// Create a linalg::GenericOp version of an n-D copy that can further tile,
 /// lower to loops or vectorize, unlike the current implementation of
 /// memref::CopyOp.
+Operation *getReductionCombiner(linalg::GenericOp genericOp) {
+  unsigned numLoops = genericOp.getNumLoops();
+  if (genericOp.getNumOutputs() != 1 || genericOp.getNumReductionLoops() != 1 ||
+      !isReductionIterator(genericOp.iterator_types()[numLoops - 1])) {
+    return nullptr;
+  }
+  if (llvm::any_of(genericOp.getIndexingMaps(), [](AffineMap map) {
+        return !map.isProjectedPermutation();
+      })) {
+    return nullptr;
+  }
+
+  // The output must only be used by the combiner yielded by the body so that
+  // partial results can be computed independently and combined in any order.
+  Block *body = genericOp.getBody();
+  BlockArgument outputArg = body->getArgument(genericOp.getNumInputs());
+  Operation *combiner = body->getTerminator()->getOperand(0).getDefiningOp();
+  if (!combiner || combiner->getBlock() != body ||
+      combiner->getNumOperands() != 2 || !outputArg.hasOneUse() ||
+      !llvm::is_contained(combiner->getOperands(), outputArg)) {
+    return nullptr;
+  }
+  if (!getReductionIdentity(combiner)) return nullptr;
+  return combiner;
+}
+
+Attribute getReductionIdentity(Operation *combiner) {
+  Type type = combiner->getResult(0).getType();
+  Builder builder(combiner->getContext());
+  auto getFloatIdentity = [&](bool isInf, bool isNegative, double value) {
+    auto floatType = type.cast<FloatType>();
+    if (!isInf) return builder.getFloatAttr(floatType, value);
+    return builder.getFloatAttr(
+        floatType,
+        llvm::APFloat::getInf(floatType.getFloatSemantics(), isNegative));
+  };
+  unsigned bitWidth = type.getIntOrFloatBitWidth();
+  return TypeSwitch<Operation *, Attribute>(combiner)
+      .Case<arith::AddFOp>(
+          [&](auto) { return getFloatIdentity(false, false, 0.0); })
+      .Case<arith::MulFOp>(
+          [&](auto) { return getFloatIdentity(false, false, 1.0); })
+      .Case<arith::MaxFOp>(
+          [&](auto) { return getFloatIdentity(true, true, 0.0); })
+      .Case<arith::MinFOp>(
+          [&](auto) { return getFloatIdentity(true, false, 0.0); })
+      .Case<arith::AddIOp, arith::OrIOp, arith::XOrIOp, arith::MaxUIOp>(
+          [&](auto) { return builder.getIntegerAttr(type, 0); })
+      .Case<arith::MulIOp>(
+          [&](auto) { return builder.getIntegerAttr(type, 1); })
+      .Case<arith::AndIOp, arith::MinUIOp>([&](auto) {
+        return builder.getIntegerAttr(type, llvm::APInt::getAllOnes(bitWidth));
+      })
+      .Case<arith::MaxSIOp>([&](auto) {
+        return builder.getIntegerAttr(
+            type, llvm::APInt::getSignedMinValue(bitWidth));
+      })
+      .Case<arith::MinSIOp>([&](auto) {
+        return builder.getIntegerAttr(
+            type, llvm::APInt::getSignedMaxValue(bitWidth));
+      })
+      .Default([](Operation *) { return Attribute(); });
+}
+
 Operation *createLinalgCopyOp(OpBuilder &b, Location loc, Value from,
                               Value to) {
   auto memrefTypeFrom = from.getType().cast<MemRefType>();
@@ -34,6 +34,11 @@ llvm::StringMap<IREE::HAL::ExecutableEntryPointOp> getAllEntryPoints(
 /// Returns the entry point op for the `funcOp`. Returns `nullptr` on failure.
 IREE::HAL::ExecutableEntryPointOp getEntryPoint(FuncOp funcOp);
 
+/// Returns the LLVM Target triple associated with the `hal.executable.variant`
+/// operation if set.
+Optional<llvm::Triple> getTargetTriple(
+    IREE::HAL::ExecutableVariantOp variantOp);
+
 /// Methods to get backend information.
 bool isX86(IREE::HAL::ExecutableVariantOp variantOp);
 inline bool isX86(FuncOp entryPointFn) {
@@ -41,6 +46,12 @@ inline bool isX86(FuncOp entryPointFn) {
       entryPointFn->getParentOfType<IREE::HAL::ExecutableVariantOp>();
   return isX86(variantOp);
 }
+bool isRISCV(IREE::HAL::ExecutableVariantOp variantOp);
+inline bool isRISCV(FuncOp entryPointFn) {
+  auto variantOp =
+      entryPointFn->getParentOfType<IREE::HAL::ExecutableVariantOp>();
+  return isRISCV(variantOp);
+}
 inline bool isVMVXBackend(IREE::HAL::ExecutableVariantOp variantOp) {
   return variantOp.target().getBackend().getValue() == "vmvx";
 }
@@ -148,6 +159,23 @@ LogicalResult getComputeOps(
     FuncOp funcOp, SmallVectorImpl<Operation *> &computeOps,
     SmallVectorImpl<LoopTilingAndDistributionInfo> &tiledLoops);
 
+/// Returns the reduction `linalg.generic` in `computeOps` whose result is
+/// consumed by another op of `computeOps` iterating over the same loops, i.e.
+/// a reduction fused with its broadcasting consumers at the Flow level (see
+/// `iree-flow-enable-fusion-across-reductions`). Returns nullptr if there is
+/// none.
+Operation *getReductionFusedWithConsumers(ArrayRef<Operation *> computeOps);
+
+/// Returns the op of the body of `genericOp` combining its output with the
+/// values computed from its inputs if `genericOp` is a reduction along its
+/// innermost loop whose partial results can be combined in any order, e.g. once
+/// distributed across the threads of a workgroup. Returns nullptr otherwise.
+Operation *getReductionCombiner(linalg::GenericOp genericOp);
+
+/// Returns the identity value of the reduction combined by `combiner` or
+/// nullptr if it isn't known.
+Attribute getReductionIdentity(Operation *combiner);
+
 /// If the given `forOp` is a tiled and distributed loop, returns its tiling and
 /// distribution information.
 Optional<LoopTilingAndDistributionInfo> isTiledAndDistributedLoop(
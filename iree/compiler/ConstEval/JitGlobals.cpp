@@ -115,6 +115,34 @@ struct ProgramExtractor {
   SmallVector<StringAttr> symbolImportWorklist;
 };
 
+// Returns true if |initializerOp| can be evaluated at compile time given the
+// set of |runtimeGlobals| that will only be initialized at runtime.
+bool canEvaluateInitializer(IREE::Util::InitializerOp initializerOp,
+                            const llvm::DenseSet<StringAttr> &runtimeGlobals) {
+  auto result = initializerOp.walk([&](Operation *op) {
+    // Indirect accesses may target any global.
+    if (isa<IREE::Util::GlobalLoadIndirectOp,
+            IREE::Util::GlobalStoreIndirectOp>(op)) {
+      return WalkResult::interrupt();
+    }
+    if (auto loadOp = dyn_cast<IREE::Util::GlobalLoadOp>(op)) {
+      if (runtimeGlobals.contains(loadOp.globalAttr().getAttr())) {
+        return WalkResult::interrupt();
+      }
+    } else if (auto storeOp = dyn_cast<IREE::Util::GlobalStoreOp>(op)) {
+      Type type = storeOp.value().getType();
+      if (!CompiledBinary::isSupportedResultType(type)) {
+        LLVM_DEBUG(dbgs() << "JitGlobals: not evaluating initializer storing "
+                             "unsupported type "
+                          << type << "\n");
+        return WalkResult::interrupt();
+      }
+    }
+    return WalkResult::advance();
+  });
+  return !result.wasInterrupted();
+}
+
 // These options structs are not copy-constructable so we have to allocate them
 // shared.
 // TODO: See if we can make them copyable?
@@ -160,8 +188,18 @@ struct JitGlobalsPass : public JitGlobalsBase<JitGlobalsPass> {
     ProgramExtractor extractor(outerModule, innerModule);
     SmallVector<Operation *> pruneOps;
 
-    // Import initializers.
+    // Import initializers that can be evaluated. Initializers that store any
+    // global of a type the runtime bridge cannot convert to an attribute must
+    // run at runtime, as must initializers that depend on them. Initializers
+    // are visited in order so that dependent initializers are seen last.
+    llvm::DenseSet<StringAttr> runtimeGlobals;
     for (auto childOp : outerModule.getOps<IREE::Util::InitializerOp>()) {
+      if (!canEvaluateInitializer(childOp, runtimeGlobals)) {
+        childOp.walk([&](IREE::Util::GlobalStoreOp storeOp) {
+          runtimeGlobals.insert(storeOp.globalAttr().getAttr());
+        });
+        continue;
+      }
       extractor.importOperation(childOp);
       pruneOps.push_back(childOp);
     }
@@ -188,6 +226,8 @@ struct JitGlobalsPass : public JitGlobalsBase<JitGlobalsPass> {
         continue;
       }
 
+      if (runtimeGlobals.contains(globalOp.sym_nameAttr())) continue;
+
       StringAttr funcSymbol = extractor.createAccessor(globalOp);
       uninitializedGlobals.emplace_back(funcSymbol, globalOp.sym_nameAttr());
     }
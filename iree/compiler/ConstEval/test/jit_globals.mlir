@@ -221,3 +221,69 @@ module @eval_i64_tensor {
     util.initializer.return
   }
 }
+
+// -----
+// CHECK-LABEL: @eval_transposed_weights
+// CHECK: util.global private @{{.*}} = dense<{{\[}}[1, 4], [2, 5], [3, 6]]> : tensor<3x2xi32>
+// CHECK-NOT: util.initializer
+#map0 = affine_map<(d0, d1) -> (d1, d0)>
+#map1 = affine_map<(d0, d1) -> (d0, d1)>
+module @eval_transposed_weights {
+  util.global private @hoisted : tensor<3x2xi32>
+  func @main() -> tensor<3x2xi32> {
+    %hoisted = util.global.load @hoisted : tensor<3x2xi32>
+    return %hoisted : tensor<3x2xi32>
+  }
+  util.initializer {
+    %cst = arith.constant dense<[[1, 2, 3], [4, 5, 6]]> : tensor<2x3xi32>
+    %0 = linalg.init_tensor [3, 2] : tensor<3x2xi32>
+    %1 = linalg.generic {indexing_maps = [#map0, #map1], iterator_types = ["parallel", "parallel"]} ins(%cst : tensor<2x3xi32>) outs(%0 : tensor<3x2xi32>) {
+    ^bb0(%arg0: i32, %arg1: i32):  // no predecessors
+      linalg.yield %arg0 : i32
+    } -> tensor<3x2xi32>
+    util.global.store %1, @hoisted : tensor<3x2xi32>
+    util.initializer.return
+  }
+}
+
+// -----
+// Initializers storing unsupported types, and those depending on them, must
+// be preserved while the others are evaluated.
+// CHECK-LABEL: @partially_supported_initializers
+module @partially_supported_initializers {
+  // CHECK: util.global private @a : tensor<2xi32>
+  util.global private @a : tensor<2xi32>
+  // CHECK: util.global private @b : tensor<2xi4>
+  util.global private @b : tensor<2xi4>
+  // CHECK: util.global private @c : tensor<2xi32>
+  util.global private @c : tensor<2xi32>
+  // CHECK: util.global private @d = dense<[5, 6]> : tensor<2xi32>
+  util.global private @d : tensor<2xi32>
+  func @main() -> (tensor<2xi32>, tensor<2xi4>, tensor<2xi32>, tensor<2xi32>) {
+    %a = util.global.load @a : tensor<2xi32>
+    %b = util.global.load @b : tensor<2xi4>
+    %c = util.global.load @c : tensor<2xi32>
+    %d = util.global.load @d : tensor<2xi32>
+    return %a, %b, %c, %d : tensor<2xi32>, tensor<2xi4>, tensor<2xi32>, tensor<2xi32>
+  }
+  // CHECK: util.initializer
+  util.initializer {
+    %cst = arith.constant dense<[1, 2]> : tensor<2xi32>
+    util.global.store %cst, @a : tensor<2xi32>
+    %cst_0 = arith.constant dense<3> : tensor<2xi4>
+    util.global.store %cst_0, @b : tensor<2xi4>
+    util.initializer.return
+  }
+  // CHECK: util.initializer
+  util.initializer {
+    %a = util.global.load @a : tensor<2xi32>
+    util.global.store %a, @c : tensor<2xi32>
+    util.initializer.return
+  }
+  // CHECK-NOT: util.initializer
+  util.initializer {
+    %cst = arith.constant dense<[5, 6]> : tensor<2xi32>
+    util.global.store %cst, @d : tensor<2xi32>
+    util.initializer.return
+  }
+}
@@ -0,0 +1,331 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Dialect/Flow/Transforms/PassDetail.h"
+#include "iree/compiler/Dialect/Flow/Transforms/Passes.h"
+#include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/Dialect/Tensor/IR/Tensor.h"
+#include "mlir/Dialect/Tensor/Utils/Utils.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace Flow {
+
+namespace {
+
+// Output tile size (m) and filter size (r) of the F(m x m, r x r) algorithm.
+// The input tile size is m + r - 1.
+static constexpr int64_t kOutputTileSize = 4;
+static constexpr int64_t kFilterSize = 3;
+static constexpr int64_t kInputTileSize = kOutputTileSize + kFilterSize - 1;
+
+// Convolutions with fewer input or output channels than this are left alone:
+// the input/output transforms are not amortized by the batch matmul and the
+// img2col or direct lowering is faster.
+static constexpr int64_t kMinChannelCount = 8;
+
+// Transform matrices for F(4x4, 3x3) from Lavin & Gray, "Fast Algorithms for
+// Convolutional Neural Networks".
+// clang-format off
+static const double kBT[kInputTileSize * kInputTileSize] = {
+    4,  0, -5,  0, 1, 0,
+    0, -4, -4,  1, 1, 0,
+    0,  4, -4, -1, 1, 0,
+    0, -2, -1,  2, 1, 0,
+    0,  2, -1, -2, 1, 0,
+    0,  4,  0, -5, 0, 1,
+};
+static const double kG[kInputTileSize * kFilterSize] = {
+     1.0 / 4,       0,           0,
+    -1.0 / 6,  -1.0 / 6,   -1.0 / 6,
+    -1.0 / 6,   1.0 / 6,   -1.0 / 6,
+     1.0 / 24,  1.0 / 12,   1.0 / 6,
+     1.0 / 24, -1.0 / 12,   1.0 / 6,
+           0,         0,          1,
+};
+static const double kAT[kOutputTileSize * kInputTileSize] = {
+    1, 1,  1, 1,  1, 0,
+    0, 1, -1, 2, -2, 0,
+    0, 1,  1, 4,  4, 0,
+    0, 1, -1, 8, -8, 1,
+};
+// clang-format on
+
+static Value createConstantMatrix(OpBuilder &builder, Location loc,
+                                  Type elementType, int64_t rows,
+                                  int64_t cols, const double *values) {
+  SmallVector<Attribute> attrs;
+  attrs.reserve(rows * cols);
+  for (int64_t i = 0; i < rows * cols; ++i) {
+    attrs.push_back(builder.getFloatAttr(elementType, values[i]));
+  }
+  auto type = RankedTensorType::get({rows, cols}, elementType);
+  return builder.create<arith::ConstantOp>(
+      loc, DenseElementsAttr::get(type, attrs));
+}
+
+static Value createZeroFilledTensor(OpBuilder &builder, Location loc,
+                                    ArrayRef<int64_t> shape,
+                                    Type elementType) {
+  Value init = builder.create<linalg::InitTensorOp>(loc, shape, elementType);
+  Value zero = builder.create<arith::ConstantOp>(
+      loc, builder.getZeroAttr(elementType));
+  return builder.create<linalg::FillOp>(loc, zero, init).result();
+}
+
+// Creates a linalg.generic computing
+//   result[outer] = sum_{i,j} lhs[a, i] * source[...] * rhs[b, j]
+// where the last two loops are the (i, j) reductions. This is the form of all
+// three Winograd transforms (G g G^T, B^T d B and A^T M A).
+static Value createTwoSidedTransform(OpBuilder &builder, Location loc,
+                                     Value lhs, Value source, Value rhs,
+                                     ArrayRef<int64_t> resultShape,
+                                     ArrayRef<AffineMap> indexingMaps) {
+  auto elementType = source.getType().cast<ShapedType>().getElementType();
+  Value init = createZeroFilledTensor(builder, loc, resultShape, elementType);
+  SmallVector<StringRef> iteratorTypes(resultShape.size(),
+                                       getParallelIteratorTypeName());
+  iteratorTypes.append(2, getReductionIteratorTypeName());
+  auto genericOp = builder.create<linalg::GenericOp>(
+      loc, init.getType(), ValueRange{lhs, source, rhs}, init, indexingMaps,
+      iteratorTypes,
+      [&](OpBuilder &nestedBuilder, Location nestedLoc, ValueRange args) {
+        Value product =
+            nestedBuilder.create<arith::MulFOp>(nestedLoc, args[0], args[1]);
+        product =
+            nestedBuilder.create<arith::MulFOp>(nestedLoc, product, args[2]);
+        Value sum =
+            nestedBuilder.create<arith::AddFOp>(nestedLoc, product, args[3]);
+        nestedBuilder.create<linalg::YieldOp>(nestedLoc, sum);
+      });
+  return genericOp.getResult(0);
+}
+
+// Convert linalg.conv_2d_nhwc_hwcf ops with 3x3 filters and unit strides and
+// dilations into the Winograd F(4x4, 3x3) form:
+//   U = G g G^T  (filter transform, [6, 6, C, F])
+//   V = B^T d B  (input transform of each 6x6 tile, [6, 6, N, TH, TW, C])
+//   M = U (.) V  (batch matmul over the 36 tile positions)
+//   Y = A^T M A  (output transform of each 4x4 tile)
+// Each 4x4 output tile needs 36 * C * F multiplies instead of 144 * C * F.
+//
+// The filter transform only depends on the filter and is expressed as a
+// standalone linalg op so that when the filter is a constant (as it is with
+// most inference models) const-expr hoisting and evaluation fold it at compile
+// time.
+class Conv2DWinogradConversion
+    : public OpRewritePattern<linalg::Conv2DNhwcHwcfOp> {
+ public:
+  using OpRewritePattern<linalg::Conv2DNhwcHwcfOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(linalg::Conv2DNhwcHwcfOp convOp,
+                                PatternRewriter &rewriter) const override {
+    Value input = convOp.getInputOperand(0)->get();
+    Value filter = convOp.getInputOperand(1)->get();
+    Value output = convOp.getOutputOperand(0)->get();
+    auto inputType = input.getType().dyn_cast<RankedTensorType>();
+    auto filterType = filter.getType().dyn_cast<RankedTensorType>();
+    auto outputType = output.getType().dyn_cast<RankedTensorType>();
+    if (!inputType || !filterType || !outputType) return failure();
+    if (!inputType.hasStaticShape() || !filterType.hasStaticShape() ||
+        !outputType.hasStaticShape()) {
+      return failure();
+    }
+
+    Type elementType = inputType.getElementType();
+    if (!elementType.isa<FloatType>() ||
+        filterType.getElementType() != elementType ||
+        outputType.getElementType() != elementType) {
+      return failure();
+    }
+
+    auto isOne = [](APInt element) { return element.getSExtValue() == 1; };
+    if (!llvm::all_of(convOp.strides(), isOne) ||
+        !llvm::all_of(convOp.dilations(), isOne)) {
+      return failure();
+    }
+
+    auto inputShape = inputType.getShape();
+    auto filterShape = filterType.getShape();
+    auto outputShape = outputType.getShape();
+    if (filterShape[0] != kFilterSize || filterShape[1] != kFilterSize) {
+      return failure();
+    }
+    if (filterShape[2] < kMinChannelCount ||
+        filterShape[3] < kMinChannelCount) {
+      return failure();
+    }
+
+    auto loc = convOp.getLoc();
+    MLIRContext *context = rewriter.getContext();
+    auto d = [&](unsigned i) { return rewriter.getAffineDimExpr(i); };
+
+    int64_t n = outputShape[0];
+    int64_t c = filterShape[2];
+    int64_t f = filterShape[3];
+    int64_t tileH = llvm::divideCeil(outputShape[1], kOutputTileSize);
+    int64_t tileW = llvm::divideCeil(outputShape[2], kOutputTileSize);
+
+    // Filter transform: U[a, b, c, f] = G[a, i] * g[i, j, c, f] * G[b, j].
+    Value gMatrix = createConstantMatrix(rewriter, loc, elementType,
+                                         kInputTileSize, kFilterSize, kG);
+    Value transformedFilter = createTwoSidedTransform(
+        rewriter, loc, gMatrix, filter, gMatrix,
+        {kInputTileSize, kInputTileSize, c, f},
+        {AffineMap::get(6, 0, {d(0), d(4)}, context),
+         AffineMap::get(6, 0, {d(4), d(5), d(2), d(3)}, context),
+         AffineMap::get(6, 0, {d(1), d(5)}, context),
+         AffineMap::get(6, 0, {d(0), d(1), d(2), d(3)}, context)});
+
+    // Pad the input on the high side so that it contains a whole number of
+    // overlapping 6x6 input tiles.
+    int64_t paddedH = tileH * kOutputTileSize + kFilterSize - 1;
+    int64_t paddedW = tileW * kOutputTileSize + kFilterSize - 1;
+    Value paddedInput = input;
+    if (paddedH != inputShape[1] || paddedW != inputShape[2]) {
+      auto paddedType = RankedTensorType::get(
+          {inputShape[0], paddedH, paddedW, inputShape[3]}, elementType);
+      Value zero = rewriter.create<arith::ConstantOp>(
+          loc, rewriter.getZeroAttr(elementType));
+      auto createPadding = [&](ArrayRef<int64_t> padding) {
+        SmallVector<OpFoldResult> result;
+        for (auto pad : padding) {
+          result.push_back(rewriter.getI64IntegerAttr(pad));
+        }
+        return result;
+      };
+      paddedInput = tensor::createPadScalarOp(
+          paddedType, input, zero, createPadding({0, 0, 0, 0}),
+          createPadding(
+              {0, paddedH - inputShape[1], paddedW - inputShape[2], 0}),
+          /*nofold=*/false, loc, rewriter);
+    }
+
+    // Input transform:
+    //   V[a, b, n, th, tw, c] =
+    //       B^T[a, i] * d[n, 4th + i, 4tw + j, c] * B^T[b, j]
+    Value bt = createConstantMatrix(rewriter, loc, elementType, kInputTileSize,
+                                    kInputTileSize, kBT);
+    Value transformedInput = createTwoSidedTransform(
+        rewriter, loc, bt, paddedInput, bt,
+        {kInputTileSize, kInputTileSize, n, tileH, tileW, c},
+        {AffineMap::get(8, 0, {d(0), d(6)}, context),
+         AffineMap::get(8, 0,
+                        {d(2), d(3) * kOutputTileSize + d(6),
+                         d(4) * kOutputTileSize + d(7), d(5)},
+                        context),
+         AffineMap::get(8, 0, {d(1), d(7)}, context),
+         AffineMap::get(8, 0, {d(0), d(1), d(2), d(3), d(4), d(5)}, context)});
+
+    // Elementwise product in the transformed domain as a batch matmul over
+    // the 36 tile positions: [36, tiles, C] x [36, C, F] -> [36, tiles, F].
+    int64_t positionCount = kInputTileSize * kInputTileSize;
+    int64_t tileCount = n * tileH * tileW;
+    SmallVector<ReassociationIndices> tileReassociationIndices = {
+        {0, 1}, {2, 3, 4}, {5}};
+    SmallVector<ReassociationIndices> filterReassociationIndices = {
+        {0, 1}, {2}, {3}};
+    Value collapsedInput = rewriter.create<tensor::CollapseShapeOp>(
+        loc, RankedTensorType::get({positionCount, tileCount, c}, elementType),
+        transformedInput, tileReassociationIndices);
+    Value collapsedFilter = rewriter.create<tensor::CollapseShapeOp>(
+        loc, RankedTensorType::get({positionCount, c, f}, elementType),
+        transformedFilter, filterReassociationIndices);
+    Value matmulInit = createZeroFilledTensor(
+        rewriter, loc, {positionCount, tileCount, f}, elementType);
+    Value matmulResult =
+        rewriter
+            .create<linalg::BatchMatmulOp>(
+                loc, matmulInit.getType(),
+                ValueRange{collapsedInput, collapsedFilter}, matmulInit)
+            .getResult(0);
+    Value expandedResult = rewriter.create<tensor::ExpandShapeOp>(
+        loc,
+        RankedTensorType::get(
+            {kInputTileSize, kInputTileSize, n, tileH, tileW, f}, elementType),
+        matmulResult, tileReassociationIndices);
+
+    // Output transform:
+    //   Y[n, th, p, tw, q, f] = A^T[p, a] * M[a, b, n, th, tw, f] * A^T[q, b]
+    Value at = createConstantMatrix(rewriter, loc, elementType,
+                                    kOutputTileSize, kInputTileSize, kAT);
+    Value transformedOutput = createTwoSidedTransform(
+        rewriter, loc, at, expandedResult, at,
+        {n, tileH, kOutputTileSize, tileW, kOutputTileSize, f},
+        {AffineMap::get(8, 0, {d(2), d(6)}, context),
+         AffineMap::get(8, 0, {d(6), d(7), d(0), d(1), d(3), d(5)}, context),
+         AffineMap::get(8, 0, {d(4), d(7)}, context),
+         AffineMap::get(8, 0, {d(0), d(1), d(2), d(3), d(4), d(5)}, context)});
+
+    // Untile and drop the rows/columns produced from the input padding.
+    Value untiledOutput = rewriter.create<tensor::CollapseShapeOp>(
+        loc,
+        RankedTensorType::get(
+            {n, tileH * kOutputTileSize, tileW * kOutputTileSize, f},
+            elementType),
+        transformedOutput,
+        SmallVector<ReassociationIndices>{{0}, {1, 2}, {3, 4}, {5}});
+    if (tileH * kOutputTileSize != outputShape[1] ||
+        tileW * kOutputTileSize != outputShape[2]) {
+      SmallVector<OpFoldResult> offsets(4, rewriter.getI64IntegerAttr(0));
+      SmallVector<OpFoldResult> strides(4, rewriter.getI64IntegerAttr(1));
+      SmallVector<OpFoldResult> sizes;
+      for (int64_t size : outputShape) {
+        sizes.push_back(rewriter.getI64IntegerAttr(size));
+      }
+      untiledOutput = rewriter.create<tensor::ExtractSliceOp>(
+          loc, outputType, untiledOutput, offsets, sizes, strides);
+    }
+
+    // Convolutions accumulate into their output operand.
+    auto identityMap = AffineMap::getMultiDimIdentityMap(4, context);
+    SmallVector<StringRef> iteratorTypes(4, getParallelIteratorTypeName());
+    auto accumulateOp = rewriter.create<linalg::GenericOp>(
+        loc, outputType, untiledOutput, output,
+        ArrayRef<AffineMap>{identityMap, identityMap}, iteratorTypes,
+        [&](OpBuilder &nestedBuilder, Location nestedLoc, ValueRange args) {
+          Value sum =
+              nestedBuilder.create<arith::AddFOp>(nestedLoc, args[0], args[1]);
+          nestedBuilder.create<linalg::YieldOp>(nestedLoc, sum);
+        });
+
+    rewriter.replaceOp(convOp, accumulateOp.getResults());
+    return success();
+  }
+};
+
+struct ConvertConv2DToWinogradPass
+    : ConvertConv2DToWinogradBase<ConvertConv2DToWinogradPass> {
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<arith::ArithmeticDialect, linalg::LinalgDialect,
+                    tensor::TensorDialect>();
+  }
+  void runOnOperation() override {
+    MLIRContext *context = &getContext();
+    RewritePatternSet patterns(&getContext());
+    patterns.insert<Conv2DWinogradConversion>(context);
+    if (failed(applyPatternsAndFoldGreedily(getOperation(),
+                                            std::move(patterns)))) {
+      return signalPassFailure();
+    }
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<Pass> createConvertConv2DToWinogradPass() {
+  return std::make_unique<ConvertConv2DToWinogradPass>();
+}
+
+}  // namespace Flow
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
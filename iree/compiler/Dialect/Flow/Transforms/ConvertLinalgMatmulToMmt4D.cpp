@@ -12,6 +12,7 @@
 #include "llvm/ADT/Optional.h"
 #include "mlir/Dialect/Linalg/IR/Linalg.h"
 #include "mlir/Dialect/Tensor/Utils/Utils.h"
+#include "mlir/Dialect/Utils/StaticValueUtils.h"
 #include "mlir/IR/PatternMatch.h"
 #include "mlir/Pass/Pass.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
@@ -217,6 +218,70 @@ static bool haveEqualShapeDim(Value x, Value y, int i) {
          y.getType().cast<ShapedType>().getDimSize(i);
 }
 
+// Returns true if |genericOp| is a transpose of its input as created by
+// transpose() with the same permutation |indices|.
+static bool isTransposeOp(linalg::GenericOp genericOp,
+                          ArrayRef<int64_t> indices) {
+  if (genericOp.getNumInputs() != 1 || genericOp.getNumOutputs() != 1 ||
+      genericOp.getNumLoops() != indices.size() ||
+      genericOp.getNumParallelLoops() != genericOp.getNumLoops()) {
+    return false;
+  }
+  Block *body = genericOp.getBody();
+  auto yieldOp = dyn_cast<linalg::YieldOp>(&body->front());
+  if (!yieldOp || yieldOp.values().size() != 1) return false;
+  auto blockArgument = yieldOp.values()[0].dyn_cast<BlockArgument>();
+  if (!blockArgument || blockArgument.getArgNumber() != 0) return false;
+  SmallVector<AffineExpr, 4> exprs = llvm::to_vector<4>(
+      llvm::map_range(indices, [&](int64_t index) -> AffineExpr {
+        return getAffineDimExpr(index, genericOp.getContext());
+      }));
+  AffineMap inputMap = inversePermutation(
+      AffineMap::get(indices.size(), 0, exprs, genericOp.getContext()));
+  return genericOp.getTiedIndexingMap(genericOp.getInputOperand(0)) ==
+             inputMap &&
+         genericOp.getTiedIndexingMap(genericOp.getOutputOperand(0))
+             .isIdentity();
+}
+
+// Returns true if |reassociation| maps (M, N) to (M1, M0, N1, N0) as used by
+// expandTo4D()/collapseTo2D().
+static bool isTiledReassociation(
+    ArrayRef<ReassociationIndices> reassociation) {
+  return reassociation.size() == 2 &&
+         reassociation[0] == ReassociationIndices{0, 1} &&
+         reassociation[1] == ReassociationIndices{2, 3};
+}
+
+// Returns the statically shaped tiled (M1, N1, M0, N0) tensor that |value| was
+// unpacked from as done for the mmt4d result: a transpose to (M1, M0, N1, N0),
+// a collapse to (M1 * M0, N1 * N0) and an optional top-left slice to (M, N).
+// Returns null if |value| was not produced by an unpack.
+static Value getTiledSourceOfUnpack(Value value) {
+  if (auto sliceOp = value.getDefiningOp<tensor::ExtractSliceOp>()) {
+    auto isZero = [](OpFoldResult ofr) { return isConstantIntValue(ofr, 0); };
+    auto isOne = [](OpFoldResult ofr) { return isConstantIntValue(ofr, 1); };
+    if (sliceOp.getType().getRank() != 2 ||
+        !llvm::all_of(sliceOp.getMixedOffsets(), isZero) ||
+        !llvm::all_of(sliceOp.getMixedStrides(), isOne)) {
+      return nullptr;
+    }
+    value = sliceOp.source();
+  }
+  auto collapseOp = value.getDefiningOp<tensor::CollapseShapeOp>();
+  if (!collapseOp ||
+      !isTiledReassociation(collapseOp.getReassociationIndices())) {
+    return nullptr;
+  }
+  auto transposeOp = collapseOp.src().getDefiningOp<linalg::GenericOp>();
+  if (!transposeOp || !isTransposeOp(transposeOp, {0, 2, 1, 3})) {
+    return nullptr;
+  }
+  Value tiled = transposeOp.getInputOperand(0)->get();
+  if (!tiled.getType().cast<ShapedType>().hasStaticShape()) return nullptr;
+  return tiled;
+}
+
 class Mmt4DTileParams {
  public:
   Mmt4DTileParams(int64_t M0, int64_t K0, int64_t N0, std::string comment)
@@ -324,6 +389,23 @@ LinalgMatmulOpToLinalgMmt4DOpPattern::chooseTileParams(Value lhs, Value rhs,
       target_info.has(CustomKernelTargetFeature::Aarch64Dotprod)) {
     return Mmt4DTileParams(8, 4, 8, "i8*i8->i32, aarch64 +dotprod");
   }
+  if (lhsElemType.isBF16() && rhsElemType.isBF16() && accElemType.isF32()) {
+    if (target_info.has(CustomKernelTargetFeature::Aarch64Bf16)) {
+      // bfmmla multiplies 2x4 lhs and rhs blocks into a 2x2 accumulator block.
+      return Mmt4DTileParams(8, 4, 8, "bf16*bf16->f32, aarch64 +bf16");
+    }
+    if (target_info.has(CustomKernelTargetFeature::X86_64Avx512Bf16)) {
+      // vdpbf16ps accumulates the dot product of bf16 pairs into each f32 lane
+      // so each rhs row of 8 bf16 pairs fills one ymm register.
+      return Mmt4DTileParams(8, 2, 8, "bf16*bf16->f32, x86_64 +avx512bf16");
+    }
+  }
+  if (lhsElemType.isF32() && rhsElemType.isF32() && accElemType.isF32() &&
+      target_info.has(CustomKernelTargetFeature::RiscvVector)) {
+    // 8 accumulator rows of 8 f32 each span register groups of LMUL=2 at the
+    // minimum VLEN of 128 and are updated with vector-scalar FMAs along K.
+    return Mmt4DTileParams(8, 1, 8, "f32*f32->f32, riscv64 +v");
+  }
   if (enable_generic_slow) {
     return Mmt4DTileParams(8, 2, 4,
                            "generic tiling parameters, as no known kernel was "
@@ -375,6 +457,149 @@ struct FoldFillGenericOpPattern : public OpRewritePattern<linalg::GenericOp> {
   }
 };
 
+/// Folds the packing of an mmt4d lhs or accumulator that was unpacked from an
+/// identically tiled tensor, such as the result of a previous mmt4d, into a use
+/// of the tiled tensor directly (shown with padding):
+///   [tiled -> transpose -> collapse_shape -> extract_slice] ->
+///   [pad -> expand_shape -> transpose] -> linalg.mmt4d
+/// ->
+///   tiled -> linalg.mmt4d
+/// The padding of the tiled tensor may hold any value and is only allowed to
+/// replace the zero padding when it cannot contribute to unpadded results:
+/// padding of the accumulator only reaches padded results while the lhs must
+/// not be padded along the reduction dimension.
+struct FoldPackOfUnpackPattern : public OpRewritePattern<linalg::GenericOp> {
+  using OpRewritePattern<linalg::GenericOp>::OpRewritePattern;
+  LogicalResult matchAndRewrite(linalg::GenericOp genericOp,
+                                PatternRewriter &rewriter) const override {
+    if (!isTransposeOp(genericOp, {0, 2, 1, 3})) return failure();
+    Value source = genericOp.getInputOperand(0)->get();
+
+    // The transpose is its own inverse. This is the unpadded case once the
+    // expand_shape of the collapse_shape has been folded away.
+    if (auto transposeOp = source.getDefiningOp<linalg::GenericOp>()) {
+      if (!isTransposeOp(transposeOp, {0, 2, 1, 3})) return failure();
+      rewriter.replaceOp(genericOp, transposeOp.getInputOperand(0)->get());
+      return success();
+    }
+
+    auto expandOp = source.getDefiningOp<tensor::ExpandShapeOp>();
+    if (!expandOp ||
+        !isTiledReassociation(expandOp.getReassociationIndices())) {
+      return failure();
+    }
+
+    Value unpacked = expandOp.src();
+    bool hasReductionPadding = false;
+    if (auto padOp = unpacked.getDefiningOp<tensor::PadOp>()) {
+      if (!llvm::all_of(padOp.getMixedLowPad(), [](OpFoldResult ofr) {
+            return isConstantIntValue(ofr, 0);
+          })) {
+        return failure();
+      }
+      hasReductionPadding = !isConstantIntValue(padOp.getMixedHighPad()[1], 0);
+      unpacked = padOp.source();
+    }
+
+    // Matching types ensure both the tile shape and the padded shape match.
+    Value tiled = getTiledSourceOfUnpack(unpacked);
+    if (!tiled || tiled.getType() != genericOp.getResult(0).getType()) {
+      return failure();
+    }
+
+    for (OpOperand &use : genericOp.getResult(0).getUses()) {
+      auto mmt4dOp = dyn_cast<linalg::Mmt4DOp>(use.getOwner());
+      if (!mmt4dOp) return failure();
+      if (mmt4dOp.isOutputTensor(&use)) continue;
+      if (use.getOperandNumber() == 0 && !hasReductionPadding) continue;
+      return failure();
+    }
+
+    rewriter.replaceOp(genericOp, tiled);
+    return success();
+  }
+};
+
+/// Propagates the tiled layout of unpacked values through elementwise ops
+/// whose results are packed again such that FoldPackOfUnpackPattern can remove
+/// the repacking:
+///   [tiled -> unpack] -> linalg.generic (2D) -> pack
+/// ->
+///   tiled -> linalg.generic (4D) -> [unpack -> pack]
+/// All inputs must be unpacked from identically shaped tiled tensors and
+/// indexed with identity maps. The padding of the tiled result holds the
+/// elementwise op applied to the padding of the inputs.
+struct PropagateUnpackThroughElementwisePattern
+    : public OpRewritePattern<linalg::GenericOp> {
+  using OpRewritePattern<linalg::GenericOp>::OpRewritePattern;
+  LogicalResult matchAndRewrite(linalg::GenericOp genericOp,
+                                PatternRewriter &rewriter) const override {
+    if (genericOp.getNumInputs() == 0 || genericOp.getNumOutputs() != 1 ||
+        genericOp.getNumLoops() != 2 ||
+        genericOp.getNumParallelLoops() != genericOp.getNumLoops()) {
+      return failure();
+    }
+    if (!llvm::all_of(genericOp.getIndexingMaps(),
+                      [](AffineMap map) { return map.isIdentity(); })) {
+      return failure();
+    }
+    OpOperand *outputOperand = genericOp.getOutputOperand(0);
+    if (genericOp.payloadUsesValueFromOperand(outputOperand) ||
+        !genericOp.getBody()->getOps<linalg::IndexOp>().empty()) {
+      return failure();
+    }
+    Value result = genericOp.getResult(0);
+    auto resultType = result.getType().cast<RankedTensorType>();
+    if (!resultType.hasStaticShape()) return failure();
+
+    // Only propagate when the result will be packed again.
+    if (llvm::none_of(result.getUsers(), [](Operation *user) {
+          return isa<tensor::PadOp, tensor::ExpandShapeOp>(user);
+        })) {
+      return failure();
+    }
+
+    SmallVector<Value> tiledInputs;
+    for (OpOperand *inputOperand : genericOp.getInputOperands()) {
+      Value tiled = getTiledSourceOfUnpack(inputOperand->get());
+      if (!tiled) return failure();
+      if (!tiledInputs.empty() &&
+          tiled.getType().cast<ShapedType>().getShape() !=
+              tiledInputs.front().getType().cast<ShapedType>().getShape()) {
+        return failure();
+      }
+      tiledInputs.push_back(tiled);
+    }
+    ArrayRef<int64_t> tiledShape =
+        tiledInputs.front().getType().cast<ShapedType>().getShape();
+
+    Location loc = genericOp.getLoc();
+    Value tiledInit = rewriter.create<linalg::InitTensorOp>(
+        loc, tiledShape, resultType.getElementType());
+    SmallVector<AffineMap> indexingMaps(
+        tiledInputs.size() + 1,
+        AffineMap::getMultiDimIdentityMap(4, rewriter.getContext()));
+    SmallVector<StringRef> iteratorTypes(4, getParallelIteratorTypeName());
+    auto tiledOp = rewriter.create<linalg::GenericOp>(
+        loc, tiledInit.getType(), tiledInputs, tiledInit, indexingMaps,
+        iteratorTypes);
+    rewriter.cloneRegionBefore(genericOp.region(), tiledOp.region(),
+                               tiledOp.region().begin());
+
+    Value unpacked =
+        transpose(loc, rewriter, tiledOp.getResult(0), {0, 2, 1, 3});
+    Value paddedResult =
+        collapseTo2D(loc, rewriter, unpacked,
+                     {tiledShape[0] * tiledShape[2],
+                      tiledShape[1] * tiledShape[3]});
+    if (paddedResult.getType() != resultType) {
+      paddedResult = extractSliceLike(loc, rewriter, paddedResult, result);
+    }
+    rewriter.replaceOp(genericOp, paddedResult);
+    return success();
+  }
+};
+
 class ConvertLinalgMatmulToMmt4DPass final
     : public ConvertLinalgMatmulToMmt4DBase<ConvertLinalgMatmulToMmt4DPass> {
  public:
@@ -406,7 +631,8 @@ class ConvertLinalgMatmulToMmt4DPass final
       tensor::ExpandShapeOp::getCanonicalizationPatterns(patterns, context);
       linalg::InitTensorOp::getCanonicalizationPatterns(patterns, context);
       linalg::FillOp::getCanonicalizationPatterns(patterns, context);
-      patterns.insert<FoldFillGenericOpPattern>(context);
+      patterns.insert<FoldFillGenericOpPattern, FoldPackOfUnpackPattern,
+                      PropagateUnpackThroughElementwisePattern>(context);
       if (failed(applyPatternsAndFoldGreedily(getOperation(),
                                               std::move(patterns)))) {
         return signalPassFailure();
@@ -423,6 +649,13 @@ std::unique_ptr<OperationPass<FuncOp>> createConvertLinalgMatmulToMmt4DPass() {
   return std::make_unique<ConvertLinalgMatmulToMmt4DPass>();
 }
 
+std::unique_ptr<OperationPass<FuncOp>> createConvertLinalgMatmulToMmt4DPass(
+    StringRef options) {
+  auto pass = std::make_unique<ConvertLinalgMatmulToMmt4DPass>();
+  (void)pass->initializeOptions(options);
+  return pass;
+}
+
 }  // namespace Flow
 }  // namespace IREE
 }  // namespace iree_compiler
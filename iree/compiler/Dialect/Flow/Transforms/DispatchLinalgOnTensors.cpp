@@ -14,6 +14,7 @@
 #include "iree/compiler/Dialect/Flow/Transforms/PassDetail.h"
 #include "iree/compiler/Dialect/Flow/Transforms/Passes.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SetVector.h"
 #include "llvm/ADT/TypeSwitch.h"
 #include "llvm/Support/CommandLine.h"
 #include "mlir/Dialect/Linalg/IR/Linalg.h"
@@ -31,6 +32,7 @@
 #include "mlir/IR/Matchers.h"
 #include "mlir/IR/PatternMatch.h"
 #include "mlir/IR/TypeRange.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
 #include "mlir/Pass/Pass.h"
 #include "mlir/Pass/PassManager.h"
 #include "mlir/Support/LLVM.h"
@@ -52,8 +54,22 @@ static llvm::cl::list<int64_t> clLinalgOnTensorsTileSizes(
     llvm::cl::desc("Comma-separated list of tile sizes for tiling on tensors"),
     llvm::cl::CommaSeparated);
 
+static llvm::cl::opt<bool> clEnableFusionAcrossReductions(
+    "iree-flow-enable-fusion-across-reductions",
+    llvm::cl::desc("Form dispatch regions that contain reductions along with "
+                   "the elementwise operations producing their operands and "
+                   "consuming their broadcasted results (e.g. softmax)"),
+    llvm::cl::init(false));
+
+static llvm::cl::opt<bool> clEnableInPlaceElementwiseDispatches(
+    "iree-flow-enable-inplace-elementwise-dispatches",
+    llvm::cl::desc("Compute the results of elementwise dispatches in place of "
+                   "inputs that are not used after the dispatch"),
+    llvm::cl::init(true));
+
 static const char kRootOpAttr[] = "__root_op__";
 static const char kFusionGroupsAttr[] = "__fused_op__";
+static const char kPartitionedLoopsAttr[] = "__partitioned_loops__";
 
 namespace mlir {
 namespace iree_compiler {
@@ -70,9 +86,11 @@ static unsigned kNumMaxParallelDims = 3;
 static bool hasRootOpAttribute(Operation *op) {
   return static_cast<bool>(op->getAttrOfType<IntegerAttr>(kRootOpAttr));
 }
-/// Removes root attribute. Asserts if root attribute is not present.
+/// Removes root attribute (and the partitioned loops set along with it).
+/// Asserts if root attribute is not present.
 static void removeRootOpAttribute(Operation *op) {
   op->removeAttr(kRootOpAttr);
+  op->removeAttr(kPartitionedLoopsAttr);
 }
 /// Sets the root attribute for an operation. The root attribute needs a number
 /// to identify the root. Asserts if root attribute is already set on an
@@ -122,6 +140,24 @@ static bool isInFusionGroup(Operation *op, unsigned targetGroup) {
 static void removeFusionGroupsAttribute(Operation *op) {
   op->removeAttr(kFusionGroupsAttr);
 }
+/// Sets the loops of the root `op` to partition across workgroups, overriding
+/// the partitionable loops of the op.
+static void setPartitionedLoopsAttribute(Operation *op,
+                                         ArrayRef<unsigned> partitionedLoops) {
+  SmallVector<int64_t> loops(partitionedLoops.begin(), partitionedLoops.end());
+  op->setAttr(kPartitionedLoopsAttr, Builder(op).getI64ArrayAttr(loops));
+}
+/// Returns the loops of `op` that are partitioned across workgroups. These are
+/// the partitionable loops of the op unless set explicitly on the root op.
+static SmallVector<unsigned> getPartitionedLoops(Operation *op) {
+  if (auto loopsAttr = op->getAttrOfType<ArrayAttr>(kPartitionedLoopsAttr)) {
+    return llvm::to_vector(llvm::map_range(loopsAttr, [](Attribute attr) {
+      return static_cast<unsigned>(attr.cast<IntegerAttr>().getInt());
+    }));
+  }
+  return cast<PartitionableLoopsInterface>(op).getPartitionableLoops(
+      kNumMaxParallelDims);
+}
 
 //===----------------------------------------------------------------------===//
 // Utility methods
@@ -544,6 +580,161 @@ static BlockArgument getTiedOperandBlockArgument(BlockArgument resultArg) {
   return tiedArg;
 }
 
+/// Returns true if `value`, an operand of `dispatchOp`, is not used after the
+/// dispatch so that its storage can be reused for a result.
+static bool isDyingOperand(Value value,
+                           IREE::Flow::DispatchWorkgroupsOp dispatchOp) {
+  // Arguments may be used by the caller and constants are immutable.
+  Operation *definingOp = value.getDefiningOp();
+  if (!definingOp || definingOp->hasTrait<OpTrait::ConstantLike>()) {
+    return false;
+  }
+  Block *block = dispatchOp->getBlock();
+  if (definingOp->getBlock() != block) return false;
+  unsigned numDispatchUses = 0;
+  for (OpOperand &use : value.getUses()) {
+    if (use.getOwner() == dispatchOp) {
+      ++numDispatchUses;
+      continue;
+    }
+    // Shape queries do not read the contents.
+    if (isa<tensor::DimOp>(use.getOwner())) continue;
+    Operation *user = block->findAncestorOpInBlock(*use.getOwner());
+    if (!user || !user->isBeforeInBlock(dispatchOp)) return false;
+  }
+  return numDispatchUses == 1;
+}
+
+/// Returns the operands of `dispatchOp` captured by the block arguments in
+/// `args`.
+static SmallVector<Value> getCapturedOperands(
+    IREE::Flow::DispatchWorkgroupsOp dispatchOp, ValueRange args) {
+  SmallVector<Value> operands;
+  for (Value arg : args) {
+    auto blockArg = arg.dyn_cast<BlockArgument>();
+    if (!blockArg || blockArg.getOwner() != dispatchOp.getBody(0) ||
+        blockArg.getArgNumber() >= dispatchOp.operands().size()) {
+      return {};
+    }
+    operands.push_back(dispatchOp.operands()[blockArg.getArgNumber()]);
+  }
+  return operands;
+}
+
+/// Returns true if `lhs` and `rhs` are the same value or are computed by
+/// equivalent side-effect free ops from equivalent operands. The tiled loads
+/// and stores of a dispatch compute their offsets and sizes independently.
+static bool isEquivalentValue(Value lhs, Value rhs) {
+  if (lhs == rhs) return true;
+  auto lhsResult = lhs.dyn_cast<OpResult>();
+  auto rhsResult = rhs.dyn_cast<OpResult>();
+  if (!lhsResult || !rhsResult ||
+      lhsResult.getResultNumber() != rhsResult.getResultNumber() ||
+      !MemoryEffectOpInterface::hasNoEffect(lhsResult.getOwner())) {
+    return false;
+  }
+  return OperationEquivalence::isEquivalentTo(
+      lhsResult.getOwner(), rhsResult.getOwner(),
+      [](Value lhsOperand, Value rhsOperand) {
+        return success(isEquivalentValue(lhsOperand, rhsOperand));
+      },
+      [](Value, Value) { return success(); },
+      OperationEquivalence::Flags::IgnoreLocations);
+}
+
+static bool isEquivalentOpFoldResults(ArrayRef<OpFoldResult> lhs,
+                                      ArrayRef<OpFoldResult> rhs) {
+  if (lhs.size() != rhs.size()) return false;
+  for (auto it : llvm::zip(lhs, rhs)) {
+    OpFoldResult lhsValue = std::get<0>(it);
+    OpFoldResult rhsValue = std::get<1>(it);
+    if (lhsValue == rhsValue) continue;
+    if (!lhsValue.is<Value>() || !rhsValue.is<Value>() ||
+        !isEquivalentValue(lhsValue.get<Value>(), rhsValue.get<Value>())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// Rewrites the elementwise ops in `dispatchOp` that compute a result into a
+/// new tensor to compute it in place of an input instead. This is done when
+/// the input has the same type and shape, is read at the same indices as the
+/// result is written and is not used after the dispatch. The result is then
+/// tied to the input by `tryToTieOperandsAndResults`, avoiding the allocation
+/// of a new buffer for the result.
+static void tryToComputeInPlace(IREE::Flow::DispatchWorkgroupsOp dispatchOp) {
+  Block *block = dispatchOp.getBody(0);
+  unsigned numOperands = dispatchOp.getODSOperandIndexAndLength(1).second;
+  for (auto result : llvm::enumerate(dispatchOp.getResults())) {
+    if (dispatchOp.getTiedResultOperand(result.value())) continue;
+    BlockArgument outputArgument =
+        block->getArgument(numOperands + result.index());
+    if (!outputArgument.hasOneUse()) continue;
+    auto storeOp = dyn_cast<IREE::Flow::DispatchTensorStoreOp>(
+        outputArgument.use_begin()->getOwner());
+    if (!storeOp) continue;
+    auto genericOp = storeOp.value().getDefiningOp<linalg::GenericOp>();
+    if (!genericOp ||
+        genericOp.getNumLoops() != genericOp.getNumParallelLoops()) {
+      continue;
+    }
+    OpOperand *outputOperand = genericOp.getOutputOperand(
+        storeOp.value().cast<OpResult>().getResultNumber());
+    if (!outputOperand->get().getDefiningOp<linalg::InitTensorOp>() ||
+        genericOp.payloadUsesValueForOperand(outputOperand)) {
+      continue;
+    }
+    SmallVector<Value> resultDims =
+        getCapturedOperands(dispatchOp, storeOp.target_dims());
+    if (resultDims.size() != storeOp.target_dims().size()) continue;
+
+    AffineMap outputMap = genericOp.getTiedIndexingMap(outputOperand);
+    for (OpOperand *inputOperand : genericOp.getInputOperands()) {
+      auto loadOp = inputOperand->get()
+                        .getDefiningOp<IREE::Flow::DispatchTensorLoadOp>();
+      if (!loadOp || !loadOp.result().hasOneUse() ||
+          loadOp.getType() != outputOperand->get().getType() ||
+          genericOp.getTiedIndexingMap(inputOperand) != outputMap) {
+        continue;
+      }
+      // Only the elements of the input overwritten by this workgroup may be
+      // read by it.
+      auto inputArgument = loadOp.source().dyn_cast<BlockArgument>();
+      if (!inputArgument || !inputArgument.hasOneUse() ||
+          inputArgument.getOwner() != block ||
+          inputArgument.getArgNumber() >= numOperands) {
+        continue;
+      }
+      auto inputType =
+          inputArgument.getType().cast<IREE::Flow::DispatchTensorType>();
+      auto resultType =
+          outputArgument.getType().cast<IREE::Flow::DispatchTensorType>();
+      if (inputType.getAccess() != IREE::Flow::TensorAccess::ReadOnly ||
+          inputType.getShape() != resultType.getShape() ||
+          inputType.getElementType() != resultType.getElementType() ||
+          getCapturedOperands(dispatchOp, loadOp.source_dims()) !=
+              resultDims) {
+        continue;
+      }
+      if (!isEquivalentOpFoldResults(loadOp.getMixedOffsets(),
+                                     storeOp.getMixedOffsets()) ||
+          !isEquivalentOpFoldResults(loadOp.getMixedSizes(),
+                                     storeOp.getMixedSizes()) ||
+          !isEquivalentOpFoldResults(loadOp.getMixedStrides(),
+                                     storeOp.getMixedStrides())) {
+        continue;
+      }
+      if (!isDyingOperand(dispatchOp.operands()[inputArgument.getArgNumber()],
+                          dispatchOp)) {
+        continue;
+      }
+      outputOperand->set(loadOp.result());
+      break;
+    }
+  }
+}
+
 /// Modifies `dispatchOp` to attach operand-result tie information when
 /// possible.
 static void tryToTieOperandsAndResults(
@@ -744,9 +935,7 @@ struct TileAndDistributeLinalgOpsPattern : public linalg::LinalgTilingPattern {
     // of the outermost parallel loops that can be distributed.
     Location loc = linalgOp->getLoc();
     SmallVector<Range> loopRanges = linalgOp.createLoopRanges(rewriter, loc);
-    SmallVector<unsigned> partitionedLoops =
-        cast<PartitionableLoopsInterface>(linalgOp.getOperation())
-            .getPartitionableLoops(kNumMaxParallelDims);
+    SmallVector<unsigned> partitionedLoops = getPartitionedLoops(linalgOp);
     SmallVector<Value> count;
     for (auto dim : partitionedLoops) {
       count.push_back(loopRanges[dim].size);
@@ -888,6 +1077,149 @@ struct TiledOpInterfacePattern
 // Heuristics for fusing dispatchble ops with root ops using tile + fuse.
 //===----------------------------------------------------------------------===//
 
+/// Returns true if the result of `producer` can be computed within the same
+/// tiled loops as its `use` in a fusion group across reductions. Both ops need
+/// to iterate over the same static loop ranges and the consumer must access
+/// the result with the loops that compute it, so that tiling the consumer
+/// along a loop tiles the producer along the same loop.
+static bool isFusableAcrossReductions(linalg::GenericOp producer,
+                                      OpOperand &use) {
+  auto consumer = dyn_cast<linalg::LinalgOp>(use.getOwner());
+  if (!consumer || !consumer.isInputTensor(&use)) return false;
+  if (!producer.hasTensorSemantics() || producer->getNumResults() != 1 ||
+      producer->getBlock() != consumer->getBlock()) {
+    return false;
+  }
+  if (hasRootOpAttribute(producer) || hasFusionGroupsAttribute(producer)) {
+    return false;
+  }
+  if (producer.getNumLoops() != consumer.getNumLoops()) return false;
+  Optional<SmallVector<int64_t, 4>> producerLoopRanges =
+      producer.getStaticLoopRanges();
+  Optional<SmallVector<int64_t, 4>> consumerLoopRanges =
+      consumer.getStaticLoopRanges();
+  if (!producerLoopRanges || !consumerLoopRanges ||
+      *producerLoopRanges != *consumerLoopRanges ||
+      llvm::any_of(*producerLoopRanges, ShapedType::isDynamic)) {
+    return false;
+  }
+  return consumer.getTiedIndexingMap(&use) ==
+         producer.getTiedIndexingMap(producer.getOutputOperand(0));
+}
+
+/// Forms a fusion group with the elementwise `rootOp` as root that contains
+/// the reductions and elementwise operations computing its operands, e.g. the
+/// max, exp, sum and division of a softmax, so that the reduction results are
+/// never written to memory. The group is distributed only along the loops that
+/// stay parallel in all of its reductions, and each workgroup computes whole
+/// reductions. Returns false, without changing anything, if there is no such
+/// group with at least one reduction.
+static bool formFusionGroupAcrossReductions(linalg::GenericOp rootOp,
+                                            int64_t groupNum) {
+  if (!rootOp.hasTensorSemantics() || rootOp.getNumLoops() == 0 ||
+      rootOp.getNumLoops() != rootOp.getNumParallelLoops()) {
+    return false;
+  }
+  if (hasRootOpAttribute(rootOp) || hasFusionGroupsAttribute(rootOp) ||
+      rootOp->getParentOfType<IREE::Flow::DispatchWorkgroupsOp>()) {
+    return false;
+  }
+  if (llvm::any_of(rootOp.getOutputOperands(), [&](OpOperand *operand) {
+        return !rootOp.getTiedIndexingMap(operand).isIdentity();
+      })) {
+    return false;
+  }
+
+  // Collect the transitive producers of the root op that can be fused.
+  llvm::SetVector<Operation *> groupOps;
+  SmallVector<linalg::GenericOp> worklist = {rootOp};
+  while (!worklist.empty()) {
+    linalg::GenericOp consumer = worklist.pop_back_val();
+    for (OpOperand *operand : consumer.getInputOperands()) {
+      auto producer = operand->get().getDefiningOp<linalg::GenericOp>();
+      if (!producer || groupOps.count(producer) ||
+          !isFusableAcrossReductions(producer, *operand)) {
+        continue;
+      }
+      groupOps.insert(producer);
+      worklist.push_back(producer);
+    }
+  }
+
+  // Drop the producers that have uses outside of the group until a fixed
+  // point is reached; the results of those would have to be materialized.
+  auto isUsedInGroup = [&](linalg::GenericOp producer, OpOperand &use) {
+    Operation *user = use.getOwner();
+    return (user == rootOp || groupOps.count(user)) &&
+           isFusableAcrossReductions(producer, use);
+  };
+  while (true) {
+    SmallVector<Operation *> droppedOps;
+    for (Operation *op : groupOps) {
+      auto producer = cast<linalg::GenericOp>(op);
+      if (!llvm::all_of(op->getUses(), [&](OpOperand &use) {
+            return isUsedInGroup(producer, use);
+          })) {
+        droppedOps.push_back(op);
+      }
+    }
+    if (droppedOps.empty()) break;
+    for (Operation *op : droppedOps) groupOps.remove(op);
+  }
+
+  // All reductions must leave the same loops parallel. Partition those, which
+  // requires the reduction loops to be the innermost partitionable loops of
+  // every op in the group so that codegen can distribute the partitioned
+  // loops of each op in order.
+  llvm::SmallDenseSet<unsigned> reductionLoops;
+  Optional<SmallVector<unsigned>> partitionedLoops;
+  for (Operation *op : groupOps) {
+    auto genericOp = cast<linalg::GenericOp>(op);
+    if (genericOp.getNumReductionLoops() == 0) continue;
+    SmallVector<unsigned> dims;
+    genericOp.getReductionDims(dims);
+    reductionLoops.insert(dims.begin(), dims.end());
+    SmallVector<unsigned> loops = getPartitionedLoops(op);
+    if (partitionedLoops && *partitionedLoops != loops) return false;
+    partitionedLoops = loops;
+  }
+  if (!partitionedLoops || partitionedLoops->empty()) return false;
+  SmallVector<Operation *> allOps = {rootOp};
+  allOps.append(groupOps.begin(), groupOps.end());
+  for (Operation *op : allOps) {
+    SmallVector<unsigned> loops = getPartitionedLoops(op);
+    if (loops.size() < partitionedLoops->size() ||
+        !std::equal(partitionedLoops->begin(), partitionedLoops->end(),
+                    loops.begin())) {
+      return false;
+    }
+    ArrayRef<unsigned> remainingLoops =
+        ArrayRef<unsigned>(loops).drop_front(partitionedLoops->size());
+    if (llvm::any_of(remainingLoops, [&](unsigned loop) {
+          return !reductionLoops.count(loop);
+        })) {
+      return false;
+    }
+  }
+
+  setRootAttribute(rootOp.getContext(), rootOp, groupNum);
+  setPartitionedLoopsAttribute(rootOp, *partitionedLoops);
+  for (Operation *op : allOps) {
+    if (op != rootOp) appendToFusionGroup(op, groupNum);
+    // Also fuse the producers of the `outs` operands, e.g. the fill of the
+    // reduction initial values.
+    for (OpOperand *operand :
+         cast<linalg::LinalgOp>(op).getOutputTensorOperands()) {
+      auto producer = operand->get().getDefiningOp<linalg::LinalgOp>();
+      if (!producer) continue;
+      if (producer.getNumLoops() != producer.getNumParallelLoops()) continue;
+      if (isInFusionGroup(producer, groupNum)) continue;
+      appendToFusionGroup(producer, groupNum);
+    }
+  }
+  return true;
+}
+
 /// Some heuristic is needed to fuse a dispatchble op with root operations using
 /// tile + fuse. Using some heuristic, each root operation is tagged with an ID
 /// (using an IntegerAttr with name `kRootOpAttr`) and all dispatchable ops to
@@ -904,6 +1236,16 @@ static unsigned decideFusableLinalgOps(FunctionOpInterface funcOp) {
     // Tiling and fusion works by tiling the last operation in the fusion group
     // and then pull producer ops into the tiled loops. So go in the reverse
     // order here.
+    if (clEnableFusionAcrossReductions) {
+      for (Operation &op : llvm::reverse(block)) {
+        auto genericOp = dyn_cast<linalg::GenericOp>(&op);
+        if (!genericOp) continue;
+        if (formFusionGroupAcrossReductions(genericOp, numRootOps)) {
+          numRootOps++;
+        }
+      }
+    }
+
     for (Operation &op : llvm::reverse(block)) {
       // Start with a root operation and fuse its producers.
       if (hasFusionGroupsAttribute(&op) || !isRootOp(&op)) continue;
@@ -933,7 +1275,11 @@ static unsigned decideFusableLinalgOps(FunctionOpInterface funcOp) {
     // group.
     for (linalg::LinalgOp linalgOp : block.getOps<linalg::LinalgOp>()) {
       Operation *op = linalgOp.getOperation();
-      if (!hasRootOpAttribute(op)) continue;
+      // Roots of fusion groups across reductions are already fused with all
+      // the consumers that iterate over the same loops.
+      if (!hasRootOpAttribute(op) || op->hasAttr(kPartitionedLoopsAttr)) {
+        continue;
+      }
       if (op->getNumResults() != 1 || !op->hasOneUse()) continue;
       OpOperand &use = *op->use_begin();
       Operation *user = use.getOwner();
@@ -1019,11 +1365,8 @@ LogicalResult createDispatchRegionsFromRootOps(mlir::Operation *funcOp) {
   // workgroup size specified by the backend.
   auto tileSizeFn = [&](OpBuilder &builder,
                         Operation *op) -> SmallVector<Value, 4> {
-    PartitionableLoopsInterface interfaceOp =
-        dyn_cast<PartitionableLoopsInterface>(op);
-    if (!interfaceOp) return {};
-    SmallVector<unsigned> partitionedLoops =
-        interfaceOp.getPartitionableLoops(kNumMaxParallelDims);
+    if (!isa<PartitionableLoopsInterface>(op)) return {};
+    SmallVector<unsigned> partitionedLoops = getPartitionedLoops(op);
     if (partitionedLoops.empty()) return {};
     unsigned maxDepth = partitionedLoops.back() + 1;
 
@@ -1230,6 +1573,7 @@ void DispatchLinalgOnTensorsPass::runOnOperation() {
   // access region block arguments for input/output tensors, which aren't
   // available until now.
   funcOp->walk([&](IREE::Flow::DispatchWorkgroupsOp op) {
+    if (clEnableInPlaceElementwiseDispatches) tryToComputeInPlace(op);
     tryToTieOperandsAndResults(op);
   });
 }
@@ -0,0 +1,188 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Dialect/Flow/Transforms/PassDetail.h"
+#include "iree/compiler/Dialect/Flow/Transforms/Passes.h"
+#include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/Dialect/Tensor/IR/Tensor.h"
+#include "mlir/IR/BuiltinAttributes.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace Flow {
+
+namespace {
+
+// Matmuls are only split when at least this fraction (1/N) of the weight
+// blocks are zero; below that the extra matmuls cost more than they save.
+static constexpr int64_t kMinZeroBlockFractionDenominator = 4;
+
+// Returns a bit per row of the 2D |weights| indicating whether the row is
+// entirely zero.
+static SmallVector<bool> getZeroRows(DenseElementsAttr weights, int64_t rows,
+                                     int64_t cols) {
+  SmallVector<bool> zeroRows(rows, true);
+  int64_t index = 0;
+  if (weights.getElementType().isa<FloatType>()) {
+    for (const APFloat &value : weights.getValues<APFloat>()) {
+      if (!value.isZero()) zeroRows[index / cols] = false;
+      ++index;
+    }
+  } else {
+    for (const APInt &value : weights.getValues<APInt>()) {
+      if (!value.isZero()) zeroRows[index / cols] = false;
+      ++index;
+    }
+  }
+  return zeroRows;
+}
+
+/// Splits linalg.matmul ops whose RHS is a constant with blocks of all-zero
+/// rows along the reduction (K) dimension into a chain of matmuls over only
+/// the non-zero row ranges:
+///
+///   C = A[:, k0:k1] * W[k0:k1, :] + A[:, k2:k3] * W[k2:k3, :] + ... + C
+///
+/// This is how block-sparse (structured-pruned) weights are exploited: the
+/// zero blocks are dropped at compile time and never loaded or multiplied,
+/// and the remaining dense matmuls go through the regular codegen paths.
+class ElideZeroWeightBlocksInMatmul
+    : public OpRewritePattern<linalg::MatmulOp> {
+ public:
+  ElideZeroWeightBlocksInMatmul(MLIRContext *context, int64_t blockSize,
+                                PatternBenefit benefit = 1)
+      : OpRewritePattern<linalg::MatmulOp>(context, benefit),
+        blockSize(blockSize) {}
+
+  LogicalResult matchAndRewrite(linalg::MatmulOp matmulOp,
+                                PatternRewriter &rewriter) const override {
+    if (blockSize <= 0) return failure();
+    auto loc = matmulOp.getLoc();
+    Value lhs = matmulOp.inputs()[0];
+    Value rhs = matmulOp.inputs()[1];
+    Value result = matmulOp.outputs()[0];
+
+    auto lhsType = lhs.getType().dyn_cast<RankedTensorType>();
+    auto rhsType = rhs.getType().dyn_cast<RankedTensorType>();
+    auto resultType = result.getType().dyn_cast<RankedTensorType>();
+    if (!lhsType || !rhsType || !resultType) return failure();
+    if (!rhsType.hasStaticShape()) return failure();
+
+    DenseElementsAttr weights;
+    if (!matchPattern(rhs, m_Constant(&weights)) || weights.isSplat()) {
+      return failure();
+    }
+    Type weightType = weights.getElementType();
+    if (!weightType.isa<FloatType, IntegerType>()) return failure();
+
+    int64_t K = rhsType.getDimSize(0);
+    int64_t N = rhsType.getDimSize(1);
+    SmallVector<bool> zeroRows = getZeroRows(weights, K, N);
+
+    // Gather the ranges of rows [begin, end) covering the non-zero blocks.
+    SmallVector<std::pair<int64_t, int64_t>> ranges;
+    int64_t blockCount = llvm::divideCeil(K, blockSize);
+    int64_t zeroBlockCount = 0;
+    for (int64_t block = 0; block < blockCount; ++block) {
+      int64_t begin = block * blockSize;
+      int64_t end = std::min(K, begin + blockSize);
+      if (std::all_of(zeroRows.begin() + begin, zeroRows.begin() + end,
+                      [](bool isZero) { return isZero; })) {
+        ++zeroBlockCount;
+      } else if (!ranges.empty() && ranges.back().second == begin) {
+        ranges.back().second = end;
+      } else {
+        ranges.emplace_back(begin, end);
+      }
+    }
+    if (zeroBlockCount * kMinZeroBlockFractionDenominator < blockCount) {
+      return failure();
+    }
+
+    // All weights are zero; the matmul accumulates nothing.
+    if (ranges.empty()) {
+      rewriter.replaceOp(matmulOp, result);
+      return success();
+    }
+
+    SmallVector<Attribute> weightValues =
+        llvm::to_vector(weights.getValues<Attribute>());
+    OpFoldResult mSize =
+        lhsType.isDynamicDim(0)
+            ? OpFoldResult(rewriter.createOrFold<tensor::DimOp>(loc, lhs, 0))
+            : OpFoldResult(rewriter.getIndexAttr(lhsType.getDimSize(0)));
+    SmallVector<OpFoldResult> strides(2, rewriter.getIndexAttr(1));
+
+    Value accumulator = result;
+    for (auto range : ranges) {
+      int64_t rangeSize = range.second - range.first;
+      SmallVector<OpFoldResult> offsets = {rewriter.getIndexAttr(0),
+                                           rewriter.getIndexAttr(range.first)};
+      SmallVector<OpFoldResult> sizes = {mSize,
+                                         rewriter.getIndexAttr(rangeSize)};
+      auto lhsSliceType = RankedTensorType::get(
+          {lhsType.getDimSize(0), rangeSize}, lhsType.getElementType());
+      Value lhsSlice = rewriter.create<tensor::ExtractSliceOp>(
+          loc, lhsSliceType, lhs, offsets, sizes, strides);
+
+      auto rhsSliceType = RankedTensorType::get({rangeSize, N}, weightType);
+      Value rhsSlice = rewriter.create<arith::ConstantOp>(
+          loc, DenseElementsAttr::get(
+                   rhsSliceType,
+                   llvm::makeArrayRef(weightValues)
+                       .slice(range.first * N, rangeSize * N)));
+
+      accumulator = rewriter
+                        .create<linalg::MatmulOp>(
+                            loc, resultType, ValueRange{lhsSlice, rhsSlice},
+                            accumulator)
+                        .getResult(0);
+    }
+
+    rewriter.replaceOp(matmulOp, accumulator);
+    return success();
+  }
+
+ private:
+  int64_t blockSize;
+};
+
+class ElideZeroWeightBlocksPass
+    : public ElideZeroWeightBlocksBase<ElideZeroWeightBlocksPass> {
+ public:
+  ElideZeroWeightBlocksPass() = default;
+  ElideZeroWeightBlocksPass(int64_t blockSize) {
+    this->blockSize = blockSize;
+  }
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<arith::ArithmeticDialect, linalg::LinalgDialect,
+                    tensor::TensorDialect>();
+  }
+  void runOnOperation() override {
+    MLIRContext *context = &getContext();
+    RewritePatternSet patterns(context);
+    patterns.insert<ElideZeroWeightBlocksInMatmul>(context, blockSize);
+    if (failed(applyPatternsAndFoldGreedily(getOperation(),
+                                            std::move(patterns)))) {
+      return signalPassFailure();
+    }
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<Pass> createElideZeroWeightBlocksPass(int64_t blockSize) {
+  return std::make_unique<ElideZeroWeightBlocksPass>(blockSize);
+}
+
+}  // namespace Flow
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
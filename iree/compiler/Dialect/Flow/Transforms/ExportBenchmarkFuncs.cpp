@@ -13,6 +13,7 @@
 #include "mlir/IR/BlockAndValueMapping.h"
 #include "mlir/IR/Builders.h"
 #include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Matchers.h"
 #include "mlir/Pass/Pass.h"
 
 namespace mlir {
@@ -22,7 +23,8 @@ namespace Flow {
 
 // Clones each exported functions (including those just created) with
 // placeholder constant inputs instead of arguments and removes the exported
-// attribute from the old functions.
+// attribute from the old functions. Also exports one function per unique
+// flow.executable entry point that dispatches it once with placeholder inputs.
 // The input are provided using util.globals.
 class ExportBenchmarkFuncsPass
     : public ExportBenchmarkFuncsBase<ExportBenchmarkFuncsPass> {
@@ -49,6 +51,27 @@ class ExportBenchmarkFuncsPass
         return;
       }
     }
+
+    // Find the first dispatch of each entry point. Executables have already
+    // been deduplicated so each entry point is a unique dispatch.
+    DenseMap<Attribute, DispatchOp> firstDispatchOps;
+    for (auto funcOp : moduleOp.getOps<mlir::FuncOp>()) {
+      funcOp.walk([&](DispatchOp dispatchOp) {
+        firstDispatchOps.try_emplace(dispatchOp.entry_point(), dispatchOp);
+      });
+    }
+    auto executableOps = llvm::to_vector<8>(moduleOp.getOps<ExecutableOp>());
+    for (auto executableOp : executableOps) {
+      for (auto entryOp : executableOp.getBlock().getOps<DispatchEntryOp>()) {
+        auto entryPointRef = SymbolRefAttr::get(
+            &getContext(), executableOp.getName(),
+            {SymbolRefAttr::get(&getContext(), entryOp.sym_name())});
+        auto it = firstDispatchOps.find(entryPointRef);
+        if (it == firstDispatchOps.end()) continue;
+        createDispatchBenchmarkFunc(moduleOp, executableOp, entryOp,
+                                    it->second);
+      }
+    }
   }
 
  private:
@@ -122,6 +145,74 @@ class ExportBenchmarkFuncsPass
     return success();
   }
 
+  // Creates a `() -> ()` function that performs |dispatchOp| once with
+  // placeholder tensor operands. Dispatches with dynamically shaped or
+  // non-constant scalar operands are skipped as there is no meaningful
+  // placeholder value for them.
+  void createDispatchBenchmarkFunc(mlir::ModuleOp moduleOp,
+                                   ExecutableOp executableOp,
+                                   DispatchEntryOp entryOp,
+                                   DispatchOp dispatchOp) {
+    // Check that all operands can be materialized before creating anything.
+    for (auto operand : dispatchOp->getOperands()) {
+      if (matchPattern(operand, m_Constant())) continue;
+      auto tensorType = operand.getType().dyn_cast<RankedTensorType>();
+      if (!tensorType || !tensorType.hasStaticShape()) return;
+    }
+
+    OpBuilder moduleBuilder(&getContext());
+    moduleBuilder.setInsertionPointToEnd(moduleOp.getBody());
+    Location loc = dispatchOp.getLoc();
+
+    // Create a `() -> ()` entry point op the benchmark tool can run. Most
+    // executables have a single entry point with the same name.
+    std::string funcName = executableOp.getName().str();
+    if (entryOp.sym_name() != executableOp.getName()) {
+      funcName += "_" + entryOp.sym_name().str();
+    }
+    funcName += "_benchmark";
+    auto funcOp = moduleBuilder.create<mlir::FuncOp>(
+        loc, funcName, moduleBuilder.getFunctionType({}, {}));
+    funcOp.setPublic();
+    funcOp->setAttr("iree.abi.stub", moduleBuilder.getUnitAttr());
+    SmallVector<NamedAttribute> reflectionAttrs = {
+        moduleBuilder.getNamedAttr("benchmark",
+                                   moduleBuilder.getStringAttr("dispatch")),
+    };
+    funcOp->setAttr("iree.reflection",
+                    moduleBuilder.getDictionaryAttr(reflectionAttrs));
+    Block* block = funcOp.addEntryBlock();
+
+    // Constants (workgroup counts, scalar push constants) are cloned as-is
+    // while tensors are loaded from placeholder globals.
+    moduleBuilder.setInsertionPoint(funcOp);
+    auto blockBuilder = OpBuilder::atBlockBegin(block);
+    BlockAndValueMapping mapping;
+    for (auto operand : dispatchOp->getOperands()) {
+      if (mapping.contains(operand)) continue;
+      if (matchPattern(operand, m_Constant())) {
+        blockBuilder.clone(*operand.getDefiningOp(), mapping);
+        continue;
+      }
+      auto dummyVar =
+          createDummyInputVariableOp(loc, operand.getType(), moduleBuilder);
+      if (!dummyVar) {
+        funcOp.erase();
+        return;
+      }
+      mapping.map(operand, blockBuilder.createOrFold<IREE::Util::GlobalLoadOp>(
+                               loc, dummyVar));
+    }
+    auto newDispatchOp = blockBuilder.clone(*dispatchOp, mapping);
+
+    // Sink all results with do_not_optimize to ensure that DCE does not
+    // remove the dispatch.
+    for (auto result : newDispatchOp->getResults()) {
+      blockBuilder.create<IREE::Util::DoNotOptimizeOp>(loc, result);
+    }
+    blockBuilder.create<mlir::ReturnOp>(loc);
+  }
+
   int uniqueId = 0;
 };
 
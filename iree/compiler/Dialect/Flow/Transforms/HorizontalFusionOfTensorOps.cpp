@@ -0,0 +1,276 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+//===--- HorizontalFusionOfTensorOps.cpp ----------------------------------===//
+//
+// Fuses independent elementwise operations on tensors with the same iteration
+// domain into a single multi-result linalg.generic. Each such operation would
+// otherwise be formed into its own dispatch region; after fusion they share a
+// single dispatch, saving a launch and a barrier for each fused operation.
+//
+// This complements the vertical (producer-consumer) fusion performed by
+// FusionOfTensorOps and DispatchLinalgOnTensors: operations that those will
+// fuse into a root operation are not considered here.
+//
+//===----------------------------------------------------------------------===//
+
+#include "iree-dialects/Dialect/LinalgExt/IR/LinalgExtOps.h"
+#include "iree/compiler/Dialect/Flow/IR/FlowOps.h"
+#include "iree/compiler/Dialect/Flow/Transforms/PassDetail.h"
+#include "iree/compiler/Dialect/Flow/Transforms/Passes.h"
+#include "llvm/ADT/SetVector.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/Dialect/Tensor/IR/Tensor.h"
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/IR/Dominance.h"
+#include "mlir/Transforms/RegionUtils.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace Flow {
+
+namespace {
+
+// Limit the number of operands. We have hard limit (32) of bindings passing
+// down to HAL -- IREE_HAL_MODULE_MAX_DESCRIPTOR_BINDING_COUNT.
+constexpr int64_t kIreeMaxOperandCount = 32;
+
+/// Returns true if `op` will be the root of a dispatch region (mirrors
+/// `isRootOp` in DispatchLinalgOnTensors).
+static bool isRootLikeOp(Operation *op) {
+  if (auto linalgOp = dyn_cast<linalg::LinalgOp>(op)) {
+    if (isa<linalg::GenericOp>(op)) {
+      return linalgOp.getNumReductionLoops() != 0;
+    }
+    return !isa<linalg::FillOp>(op);
+  }
+  return isa<IREE::LinalgExt::TiledOpInterface>(op) &&
+         !isa<tensor::ExtractSliceOp>(op);
+}
+
+/// Returns true if `genericOp` is an elementwise operation that would form a
+/// dispatch region of its own and can be fused horizontally.
+static bool isHorizontalFusionCandidate(linalg::GenericOp genericOp) {
+  if (!genericOp.hasTensorSemantics()) return false;
+  if (genericOp->getParentOfType<IREE::Flow::DispatchWorkgroupsOp>()) {
+    return false;
+  }
+  if (genericOp.getNumLoops() == 0 ||
+      genericOp.getNumLoops() != genericOp.getNumParallelLoops()) {
+    return false;
+  }
+  if (llvm::any_of(genericOp.getOutputOperands(), [&](OpOperand *operand) {
+        return !genericOp.getTiedIndexingMap(operand).isIdentity();
+      })) {
+    return false;
+  }
+  Optional<SmallVector<int64_t, 4>> staticLoopRanges =
+      genericOp.getStaticLoopRanges();
+  if (!staticLoopRanges ||
+      llvm::any_of(*staticLoopRanges, ShapedType::isDynamic)) {
+    return false;
+  }
+
+  // Elementwise consumers of a root op are fused into its dispatch region.
+  for (Value input : genericOp.inputs()) {
+    Operation *producer = input.getDefiningOp();
+    if (producer && isRootLikeOp(producer)) return false;
+  }
+  // Producers of the outputs of a root op are fused into its dispatch region.
+  for (OpOperand &use : genericOp->getUses()) {
+    auto consumer = dyn_cast<linalg::LinalgOp>(use.getOwner());
+    if (consumer && consumer.isOutputTensor(&use)) return false;
+  }
+  return true;
+}
+
+/// Returns the values used by `op` including those captured by its region.
+static SetVector<Value> getAllUsedValues(Operation *op) {
+  SetVector<Value> values;
+  values.insert(op->operand_begin(), op->operand_end());
+  getUsedValuesDefinedAbove(op->getRegions(), values);
+  return values;
+}
+
+/// Returns the operation at which the fusion of `earlierOp` and `laterOp`
+/// can be inserted, or nullptr if they are not independent. `earlierOp` must
+/// be before `laterOp` in the same block.
+static Operation *getFusedOpInsertionPoint(linalg::GenericOp earlierOp,
+                                           linalg::GenericOp laterOp,
+                                           DominanceInfo &dominanceInfo) {
+  // All values used by `laterOp` are available before `earlierOp`.
+  if (llvm::all_of(getAllUsedValues(laterOp), [&](Value value) {
+        return dominanceInfo.properlyDominates(value, earlierOp);
+      })) {
+    return earlierOp;
+  }
+  // No uses of `earlierOp` (including by `laterOp`) before `laterOp`.
+  Block *block = laterOp->getBlock();
+  for (Operation *user : earlierOp->getUsers()) {
+    Operation *ancestor = block->findAncestorOpInBlock(*user);
+    if (ancestor && !laterOp->isBeforeInBlock(ancestor)) return nullptr;
+  }
+  return laterOp;
+}
+
+/// Returns the indexing maps of the inputs of `genericOp` followed by those of
+/// its outputs.
+static SmallVector<AffineMap> getInputAndOutputMaps(
+    linalg::GenericOp genericOp) {
+  SmallVector<AffineMap> maps;
+  for (OpOperand *operand : genericOp.getInputOperands()) {
+    maps.push_back(genericOp.getTiedIndexingMap(operand));
+  }
+  for (OpOperand *operand : genericOp.getOutputOperands()) {
+    maps.push_back(genericOp.getTiedIndexingMap(operand));
+  }
+  return maps;
+}
+
+/// Fuses `earlierOp` and `laterOp` into a single linalg.generic at
+/// `insertionPoint` that yields the results of `earlierOp` followed by those
+/// of `laterOp`. Returns nullptr if the fused op would have too many operands.
+static linalg::GenericOp fuseHorizontally(linalg::GenericOp earlierOp,
+                                          linalg::GenericOp laterOp,
+                                          Operation *insertionPoint) {
+  SmallVector<linalg::GenericOp, 2> ops = {earlierOp, laterOp};
+
+  // Inputs with the same indexing map are shared between the ops.
+  SmallVector<Value> inputs;
+  SmallVector<AffineMap> inputMaps;
+  SmallVector<Value> outputs;
+  SmallVector<AffineMap> outputMaps;
+  SmallVector<SmallVector<unsigned>> inputArgNumbers(ops.size());
+  SmallVector<Type> resultTypes;
+  for (auto op : llvm::enumerate(ops)) {
+    SmallVector<AffineMap> maps = getInputAndOutputMaps(op.value());
+    for (auto input : llvm::enumerate(op.value().inputs())) {
+      AffineMap map = maps[input.index()];
+      unsigned argNumber = inputs.size();
+      for (unsigned i = 0, e = inputs.size(); i < e; ++i) {
+        if (inputs[i] == input.value() && inputMaps[i] == map) {
+          argNumber = i;
+          break;
+        }
+      }
+      if (argNumber == inputs.size()) {
+        inputs.push_back(input.value());
+        inputMaps.push_back(map);
+      }
+      inputArgNumbers[op.index()].push_back(argNumber);
+    }
+    llvm::append_range(outputs, op.value().outputs());
+    outputMaps.append(maps.begin() + op.value().getNumInputs(), maps.end());
+    llvm::append_range(resultTypes, op.value()->getResultTypes());
+  }
+  SetVector<Value> uniqueOperands;
+  uniqueOperands.insert(inputs.begin(), inputs.end());
+  uniqueOperands.insert(outputs.begin(), outputs.end());
+  if (uniqueOperands.size() >= kIreeMaxOperandCount) return nullptr;
+
+  SmallVector<AffineMap> indexingMaps = inputMaps;
+  llvm::append_range(indexingMaps, outputMaps);
+  SmallVector<StringRef> iteratorTypes = llvm::to_vector(
+      earlierOp.iterator_types().getAsValueRange<StringAttr>());
+
+  OpBuilder builder(insertionPoint);
+  Location fusedLoc = FusedLoc::get(builder.getContext(),
+                                    {earlierOp.getLoc(), laterOp.getLoc()});
+  auto fusedOp = builder.create<linalg::GenericOp>(
+      fusedLoc, resultTypes, inputs, outputs, indexingMaps, iteratorTypes,
+      [&](OpBuilder &nestedBuilder, Location loc, ValueRange args) {
+        SmallVector<Value> yieldedValues;
+        unsigned outputArgNumber = inputs.size();
+        for (auto op : llvm::enumerate(ops)) {
+          Block *body = op.value().getBody();
+          BlockAndValueMapping mapping;
+          for (auto argNumber : llvm::enumerate(inputArgNumbers[op.index()])) {
+            mapping.map(body->getArgument(argNumber.index()),
+                        args[argNumber.value()]);
+          }
+          for (unsigned i = 0, e = op.value().getNumOutputs(); i < e; ++i) {
+            mapping.map(body->getArgument(op.value().getNumInputs() + i),
+                        args[outputArgNumber++]);
+          }
+          for (Operation &bodyOp : body->without_terminator()) {
+            nestedBuilder.clone(bodyOp, mapping);
+          }
+          for (Value value : body->getTerminator()->getOperands()) {
+            yieldedValues.push_back(mapping.lookupOrDefault(value));
+          }
+        }
+        nestedBuilder.create<linalg::YieldOp>(loc, yieldedValues);
+      });
+
+  unsigned numEarlierResults = earlierOp->getNumResults();
+  earlierOp->replaceAllUsesWith(
+      fusedOp->getResults().take_front(numEarlierResults));
+  laterOp->replaceAllUsesWith(
+      fusedOp->getResults().drop_front(numEarlierResults));
+  earlierOp->erase();
+  laterOp->erase();
+  return fusedOp;
+}
+
+/// Greedily fuses the candidates in `block` in program order. Each candidate
+/// is fused into the first earlier (possibly already fused) op with the same
+/// iteration domain that it is independent of.
+static void fuseHorizontallyInBlock(Block &block,
+                                    DominanceInfo &dominanceInfo) {
+  SmallVector<linalg::GenericOp> fusionHeads;
+  for (auto genericOp :
+       llvm::make_early_inc_range(block.getOps<linalg::GenericOp>())) {
+    if (!isHorizontalFusionCandidate(genericOp)) continue;
+    bool fused = false;
+    for (auto &head : fusionHeads) {
+      if (head.iterator_types() != genericOp.iterator_types() ||
+          head.getStaticLoopRanges() != genericOp.getStaticLoopRanges()) {
+        continue;
+      }
+      Operation *insertionPoint =
+          getFusedOpInsertionPoint(head, genericOp, dominanceInfo);
+      if (!insertionPoint) continue;
+      linalg::GenericOp fusedOp =
+          fuseHorizontally(head, genericOp, insertionPoint);
+      if (!fusedOp) continue;
+      head = fusedOp;
+      fused = true;
+      break;
+    }
+    if (!fused) fusionHeads.push_back(genericOp);
+  }
+}
+
+struct HorizontalFusionOfTensorOpsPass
+    : public HorizontalFusionOfTensorOpsBase<HorizontalFusionOfTensorOpsPass> {
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<linalg::LinalgDialect>();
+  }
+
+  void runOnOperation() override {
+    Operation *op = getOperation();
+    // Fusion only creates and erases ops within blocks so the dominance tree
+    // remains valid throughout.
+    DominanceInfo dominanceInfo(op);
+    for (Region &region : op->getRegions()) {
+      for (Block &block : region) {
+        fuseHorizontallyInBlock(block, dominanceInfo);
+      }
+    }
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<Pass> createHorizontalFusionOfTensorOpsPass() {
+  return std::make_unique<HorizontalFusionOfTensorOpsPass>();
+}
+
+}  // namespace Flow
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
@@ -4,12 +4,19 @@
 // See https://llvm.org/LICENSE.txt for license information.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+#include <limits>
 #include <utility>
 
 #include "iree/compiler/Dialect/Flow/IR/FlowOps.h"
+#include "iree/compiler/Dialect/Flow/IR/FlowTypes.h"
 #include "iree/compiler/Dialect/Flow/Transforms/PassDetail.h"
 #include "iree/compiler/Dialect/Flow/Transforms/Passes.h"
+#include "iree/compiler/Dialect/Util/IR/UtilTypes.h"
+#include "llvm/ADT/STLExtras.h"
+#include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
 #include "mlir/Dialect/StandardOps/IR/Ops.h"
+#include "mlir/IR/AffineMap.h"
 #include "mlir/IR/Builders.h"
 #include "mlir/IR/BuiltinTypes.h"
 #include "mlir/IR/Diagnostics.h"
@@ -28,14 +35,180 @@ static SmallVector<Value, 4> filterTensorValues(ValueRange&& range) {
   return result;
 }
 
+// Builds the body of a summary dispatch reducing |tensorType| loaded from the
+// first block argument of |block| to the summary values stored into the
+// trailing result block arguments.
+static void buildSummaryDispatchBody(Location loc, RankedTensorType tensorType,
+                                     Block* block, OpBuilder& builder) {
+  auto i64Type = builder.getI64Type();
+  auto f32Type = builder.getF32Type();
+  auto elementType = tensorType.getElementType();
+  unsigned bitWidth = elementType.getIntOrFloatBitWidth();
+  bool isFloat = elementType.isa<FloatType>();
+
+  Value source = block->getArgument(0);
+  auto dynamicDims =
+      block->getArguments().slice(1, tensorType.getNumDynamicDims());
+  Value tensor = builder.create<DispatchTensorLoadOp>(loc, tensorType, source,
+                                                      dynamicDims);
+
+  // The mean is accumulated as the sum of each element scaled by the inverse
+  // element count to avoid a separate division step.
+  int64_t staticElementCount = 1;
+  for (int64_t dim : tensorType.getShape()) {
+    if (dim != ShapedType::kDynamicSize) staticElementCount *= dim;
+  }
+  Value elementCount =
+      builder.create<arith::ConstantIndexOp>(loc, staticElementCount);
+  for (Value dim : dynamicDims) {
+    elementCount = builder.create<arith::MulIOp>(loc, elementCount, dim);
+  }
+  Value inverseCount = builder.create<arith::DivFOp>(
+      loc, builder.create<arith::ConstantFloatOp>(loc, APFloat(1.0f), f32Type),
+      builder.create<arith::SIToFPOp>(
+          loc, f32Type,
+          builder.create<arith::IndexCastOp>(loc, i64Type, elementCount)));
+
+  // Initial values of [checksum, min, max, mean, nan count].
+  SmallVector<Attribute> initialValues = {
+      builder.getI64IntegerAttr(0),
+      builder.getF32FloatAttr(std::numeric_limits<float>::infinity()),
+      builder.getF32FloatAttr(-std::numeric_limits<float>::infinity()),
+      builder.getF32FloatAttr(0.0f),
+      builder.getI64IntegerAttr(0),
+  };
+  SmallVector<Value> inits;
+  for (auto initialValue : initialValues) {
+    Value init = builder.create<linalg::InitTensorOp>(
+        loc, ValueRange{}, ArrayRef<int64_t>{}, initialValue.getType());
+    Value value = builder.create<arith::ConstantOp>(loc, initialValue);
+    inits.push_back(builder.create<linalg::FillOp>(loc, value, init).result());
+  }
+
+  MLIRContext* context = builder.getContext();
+  SmallVector<AffineMap> indexingMaps = {
+      builder.getMultiDimIdentityMap(tensorType.getRank())};
+  indexingMaps.append(inits.size(),
+                      AffineMap::get(tensorType.getRank(), 0, context));
+  SmallVector<StringRef> iteratorTypes(tensorType.getRank(),
+                                       getReductionIteratorTypeName());
+  auto genericOp = builder.create<linalg::GenericOp>(
+      loc, TypeRange(ValueRange(inits)), tensor, inits, indexingMaps,
+      iteratorTypes, [&](OpBuilder& b, Location loc, ValueRange args) {
+        Value element = args[0];
+        Value checksum = args[1];
+        Value min = args[2];
+        Value max = args[3];
+        Value mean = args[4];
+        Value nanCount = args[5];
+
+        // The checksum is the wrapping sum of the element bit patterns so
+        // that it is sensitive to changes that do not affect the statistics.
+        Value bits = element;
+        Value value = element;
+        if (isFloat) {
+          bits = b.create<arith::BitcastOp>(loc, b.getIntegerType(bitWidth),
+                                            element);
+          if (bitWidth < 32) {
+            value = b.create<arith::ExtFOp>(loc, f32Type, element);
+          } else if (bitWidth > 32) {
+            value = b.create<arith::TruncFOp>(loc, f32Type, element);
+          }
+        } else {
+          value = b.create<arith::SIToFPOp>(loc, f32Type, element);
+        }
+        if (bitWidth < 64) bits = b.create<arith::ExtUIOp>(loc, i64Type, bits);
+        checksum = b.create<arith::AddIOp>(loc, checksum, bits);
+
+        Value newMin = b.create<arith::MinFOp>(loc, min, value);
+        Value newMax = b.create<arith::MaxFOp>(loc, max, value);
+        mean = b.create<arith::AddFOp>(
+            loc, mean, b.create<arith::MulFOp>(loc, value, inverseCount));
+        if (isFloat) {
+          // NaNs are counted instead of being propagated into min/max.
+          Value isNaN = b.create<arith::CmpFOp>(loc, arith::CmpFPredicate::UNO,
+                                                value, value);
+          newMin = b.create<arith::SelectOp>(loc, isNaN, min, newMin);
+          newMax = b.create<arith::SelectOp>(loc, isNaN, max, newMax);
+          nanCount = b.create<arith::AddIOp>(
+              loc, nanCount, b.create<arith::ExtUIOp>(loc, i64Type, isNaN));
+        }
+        b.create<linalg::YieldOp>(
+            loc, ValueRange{checksum, newMin, newMax, mean, nanCount});
+      });
+
+  auto targets = block->getArguments().take_back(genericOp.getNumResults());
+  for (auto it : llvm::zip(genericOp.getResults(), targets)) {
+    builder.create<DispatchTensorStoreOp>(loc, std::get<0>(it),
+                                          std::get<1>(it), ValueRange{});
+  }
+  builder.create<IREE::Flow::ReturnOp>(loc);
+}
+
+// Returns the values to trace for the tensors in |values| when summarizing.
+// Each integer or floating-point tensor is replaced with the results of a small
+// dispatch computing its [checksum, min, max, mean, nan count] such that only
+// a few scalars are read back per tensor. Tensors of other types are traced
+// in full.
+static SmallVector<Value, 4> summarizeTensorValues(Location loc,
+                                                   ValueRange values,
+                                                   ValueRange valueDims,
+                                                   OpBuilder& builder) {
+  SmallVector<Value, 4> result;
+  for (auto value : llvm::enumerate(values)) {
+    if (!value.value().getType().isa<TensorType>()) continue;
+    auto tensorType = value.value().getType().dyn_cast<RankedTensorType>();
+    if (!tensorType || !tensorType.getElementType().isIntOrFloat()) {
+      result.push_back(value.value());
+      continue;
+    }
+
+    // Operands are the tensor followed by its dynamic dimensions so that the
+    // dimensions are available within the dispatch region.
+    auto dynamicDims =
+        IREE::Util::findVariadicDynamicDims(value.index(), values, valueDims);
+    SmallVector<Value> operands = {value.value()};
+    operands.append(dynamicDims.begin(), dynamicDims.end());
+    SmallVector<Type> resultTypes = {
+        RankedTensorType::get({}, builder.getI64Type()),
+        RankedTensorType::get({}, builder.getF32Type()),
+        RankedTensorType::get({}, builder.getF32Type()),
+        RankedTensorType::get({}, builder.getF32Type()),
+        RankedTensorType::get({}, builder.getI64Type()),
+    };
+
+    // The summary is a full reduction of the tensor to scalars and runs in a
+    // single workgroup.
+    Value workload = builder.create<arith::ConstantIndexOp>(loc, 1);
+    auto summaryOp = builder.create<DispatchWorkgroupsOp>(
+        loc, ValueRange{workload}, resultTypes, /*resultDims=*/ValueRange{},
+        operands, dynamicDims, /*tiedOperands=*/ArrayRef<int64_t>{});
+    {
+      OpBuilder::InsertionGuard g(builder);
+      builder.setInsertionPointToStart(&summaryOp.body().front());
+      buildSummaryDispatchBody(loc, tensorType, &summaryOp.body().front(),
+                               builder);
+    }
+    llvm::append_range(result, summaryOp.getResults());
+  }
+  return result;
+}
+
 class InjectDispatchTracingPass
     : public InjectDispatchTracingBase<InjectDispatchTracingPass> {
  public:
   InjectDispatchTracingPass() = default;
+  InjectDispatchTracingPass(bool summarize) { this->summarize = summarize; }
+
+  void getDependentDialects(DialectRegistry& registry) const override {
+    registry.insert<arith::ArithmeticDialect, linalg::LinalgDialect>();
+  }
 
   void runOnOperation() override {
     auto funcOp = llvm::cast<FunctionOpInterface>(getOperation());
-    for (auto dispatchOp : funcOp.getBody().getOps<DispatchOp>()) {
+    auto dispatchOps =
+        llvm::to_vector<8>(funcOp.getBody().getOps<DispatchOp>());
+    for (auto dispatchOp : dispatchOps) {
       std::string entryPointName =
           dispatchOp.entry_point().getRootReference().getValue().str();
       for (FlatSymbolRefAttr nestedRef :
@@ -45,23 +218,31 @@ class InjectDispatchTracingPass
 
       // Input tensors:
       OpBuilder builder(dispatchOp);
+      auto inputValues =
+          summarize ? summarizeTensorValues(
+                          dispatchOp.getLoc(), dispatchOp.operands(),
+                          dispatchOp.operand_dims(), builder)
+                    : filterTensorValues(dispatchOp.operands());
       builder.create<TensorTraceOp>(
           dispatchOp.getLoc(),
-          builder.getStringAttr(entryPointName + " inputs"),
-          filterTensorValues(dispatchOp.operands()));
+          builder.getStringAttr(entryPointName + " inputs"), inputValues);
 
       // Output tensors:
       builder.setInsertionPointAfter(dispatchOp);
+      auto outputValues =
+          summarize ? summarizeTensorValues(
+                          dispatchOp.getLoc(), dispatchOp.results(),
+                          dispatchOp.result_dims(), builder)
+                    : filterTensorValues(dispatchOp.results());
       builder.create<TensorTraceOp>(
           dispatchOp.getLoc(),
-          builder.getStringAttr(entryPointName + " outputs"),
-          filterTensorValues(dispatchOp.results()));
+          builder.getStringAttr(entryPointName + " outputs"), outputValues);
     }
   }
 };
 
-std::unique_ptr<Pass> createInjectDispatchTracingPass() {
-  return std::make_unique<InjectDispatchTracingPass>();
+std::unique_ptr<Pass> createInjectDispatchTracingPass(bool summarize) {
+  return std::make_unique<InjectDispatchTracingPass>(summarize);
 }
 
 }  // namespace Flow
@@ -148,106 +148,183 @@ struct LinalgFillCast
   }
 };
 
-// For narrowable inputs, selects
-struct LinalgFpMatmulToLowP : public OpRewritePattern<linalg::MatmulOp> {
-  using OpRewritePattern::OpRewritePattern;
+// Integer operands selected for executing a floating point contraction with
+// narrowable inputs in low precision.
+struct LowPContraction {
+  Value lhs;
+  Value rhs;
+  Value accum;
+  bool isSigned;
+};
 
-  LogicalResult matchAndRewrite(linalg::MatmulOp matmulOp,
-                                PatternRewriter &rewriter) const override {
-    Location loc = matmulOp.getLoc();
-    Type origResultType = matmulOp.getResult(0).getType();
-    auto lhsParams = NarrowParams::forValue(matmulOp.inputs()[0]);
-    auto rhsParams = NarrowParams::forValue(matmulOp.inputs()[1]);
-    auto accumParams = NarrowParams::forValue(matmulOp.outputs()[0]);
-    if (!lhsParams || !rhsParams || !accumParams) {
-      return rewriter.notifyMatchFailure(matmulOp, "no narrowing annotations");
-    }
+// Matches a floating point contraction |op| whose lhs, rhs and accumulator
+// are annotated as narrowable to integers and casts them to the integer types
+// the contraction can be executed in: <= 8-bit inputs accumulated in 32 bits.
+// If |allowUnsigned| is false (the op has no unsigned variant) unsigned
+// inputs are promoted to signed ones.
+FailureOr<LowPContraction> matchLowPContraction(linalg::LinalgOp op,
+                                                bool allowUnsigned,
+                                                PatternRewriter &rewriter) {
+  auto lhsParams = NarrowParams::forValue(op.inputs()[0]);
+  auto rhsParams = NarrowParams::forValue(op.inputs()[1]);
+  auto accumParams = NarrowParams::forValue(op.outputs()[0]);
+  if (!lhsParams || !rhsParams || !accumParams) {
+    return rewriter.notifyMatchFailure(op, "no narrowing annotations");
+  }
 
-    // TODO(#7987): This could be more flexible, allowing mix and match
-    // integer/float types.
-    if (!lhsParams->isFromFloat() || !rhsParams->isFromFloat()) {
-      return rewriter.notifyMatchFailure(matmulOp, "not from floating point");
-    }
+  // TODO(#7987): This could be more flexible, allowing mix and match
+  // integer/float types.
+  if (!lhsParams->isFromFloat() || !rhsParams->isFromFloat()) {
+    return rewriter.notifyMatchFailure(op, "not from floating point");
+  }
 
-    // TODO(#7987): Could support partial conversion to integer.
-    if (!lhsParams->isToInteger() || !rhsParams->isToInteger() ||
-        !accumParams->isToInteger()) {
-      return rewriter.notifyMatchFailure(matmulOp, "not to an integer type");
-    }
+  // TODO(#7987): Could support partial conversion to integer.
+  if (!lhsParams->isToInteger() || !rhsParams->isToInteger() ||
+      !accumParams->isToInteger()) {
+    return rewriter.notifyMatchFailure(op, "not to an integer type");
+  }
 
-    int lhsBitWidth = lhsParams->getToBitWidth();
-    int rhsBitWidth = rhsParams->getToBitWidth();
-
-    // Handle signed/unsigned mismatch.
-    // TODO(#7987): Implement a proper unsigned->signed widening.
-    bool isSigned;
-    if (lhsParams->isToSigned() != rhsParams->isToSigned()) {
-      // Mixed signed/unsigned. Promote to signed.
-      isSigned = true;
-      if (!lhsParams->isToSigned()) {
-        lhsBitWidth += 1;
-      }
-      if (!rhsParams->isToSigned()) {
-        rhsBitWidth += 1;
-      }
-    } else {
-      // Uniform signed/unsigned.
-      isSigned = lhsParams->isToSigned();
+  int lhsBitWidth = lhsParams->getToBitWidth();
+  int rhsBitWidth = rhsParams->getToBitWidth();
+
+  // Handle signed/unsigned mismatch.
+  // TODO(#7987): Implement a proper unsigned->signed widening.
+  bool isSigned;
+  if (lhsParams->isToSigned() != rhsParams->isToSigned() ||
+      (!allowUnsigned && !lhsParams->isToSigned())) {
+    // Mixed signed/unsigned or no unsigned variant. Promote to signed.
+    isSigned = true;
+    if (!lhsParams->isToSigned()) {
+      lhsBitWidth += 1;
     }
+    if (!rhsParams->isToSigned()) {
+      rhsBitWidth += 1;
+    }
+  } else {
+    // Uniform signed/unsigned.
+    isSigned = lhsParams->isToSigned();
+  }
 
-    // Round up to a suitable POT width.
-    lhsBitWidth = getNextPotBitWidth(lhsBitWidth);
-    rhsBitWidth = getNextPotBitWidth(rhsBitWidth);
+  // Round up to a suitable POT width.
+  lhsBitWidth = getNextPotBitWidth(lhsBitWidth);
+  rhsBitWidth = getNextPotBitWidth(rhsBitWidth);
 
-    // Promote accumulator to match signedness.
-    int accumBitWidth = accumParams->getToBitWidth();
-    if (isSigned && !accumParams->isToSigned()) {
-      // TODO(#7987): A proper unsigned widening based on range.
-      accumBitWidth += 1;
-    }
+  // Promote accumulator to match signedness.
+  int accumBitWidth = accumParams->getToBitWidth();
+  if (isSigned && !accumParams->isToSigned()) {
+    // TODO(#7987): A proper unsigned widening based on range.
+    accumBitWidth += 1;
+  }
 
-    // Determine an appropriate accumulator size.
-    // TODO(#7987): Apply the clamp of:
-    // lhsBitWidth + rhsBitWidth + log2_ceil(contraction_dim + 1) to determine
-    // the accumulator size. Note: Can drop the +1 if one of lhs/rhs is signed
-    // and symmetric (i.e. does not use the asymmetric lower bound).
-    if (lhsBitWidth > 8 || rhsBitWidth > 8) {
-      return rewriter.notifyMatchFailure(matmulOp, "outside of low-p range");
-    }
-    accumBitWidth = getNextPotBitWidth(accumBitWidth, 32);
-    if (accumBitWidth > 32) {
-      return rewriter.notifyMatchFailure(matmulOp, "accumulator > 32 bits");
-    }
+  // Determine an appropriate accumulator size.
+  // TODO(#7987): Apply the clamp of:
+  // lhsBitWidth + rhsBitWidth + log2_ceil(contraction_dim + 1) to determine
+  // the accumulator size. Note: Can drop the +1 if one of lhs/rhs is signed
+  // and symmetric (i.e. does not use the asymmetric lower bound).
+  if (lhsBitWidth > 8 || rhsBitWidth > 8) {
+    return rewriter.notifyMatchFailure(op, "outside of low-p range");
+  }
+  accumBitWidth = getNextPotBitWidth(accumBitWidth, 32);
+  if (accumBitWidth > 32) {
+    return rewriter.notifyMatchFailure(op, "accumulator > 32 bits");
+  }
 
-    Type lhsLowPType = makeLowPType(lhsParams->fromType, lhsBitWidth);
-    Type rhsLowPType = makeLowPType(rhsParams->fromType, rhsBitWidth);
-    Type accumLowPType = makeLowPType(accumParams->fromType, accumBitWidth);
+  Type lhsLowPType = makeLowPType(lhsParams->fromType, lhsBitWidth);
+  Type rhsLowPType = makeLowPType(rhsParams->fromType, rhsBitWidth);
+  Type accumLowPType = makeLowPType(accumParams->fromType, accumBitWidth);
+
+  LowPContraction lowP;
+  lowP.lhs = castNumeric(lhsParams->producer, lhsLowPType, isSigned, rewriter);
+  lowP.rhs = castNumeric(rhsParams->producer, rhsLowPType, isSigned, rewriter);
+  lowP.accum =
+      castNumeric(accumParams->producer, accumLowPType, isSigned, rewriter);
+  lowP.isSigned = isSigned;
+  return lowP;
+}
 
-    // Replace the matmul op.
-    Value newLhs =
-        castNumeric(lhsParams->producer, lhsLowPType, isSigned, rewriter);
-    Value newRhs =
-        castNumeric(rhsParams->producer, rhsLowPType, isSigned, rewriter);
-    Value newAccum =
-        castNumeric(accumParams->producer, accumLowPType, isSigned, rewriter);
-    Value newResult;
+// Creates the low precision equivalent of a contraction. Specialized for each
+// op supported by LinalgFpContractionToLowP.
+template <typename OpTy>
+Value createLowPContraction(OpTy op, const LowPContraction &lowP,
+                            OpBuilder &builder);
+
+template <>
+Value createLowPContraction(linalg::MatmulOp op, const LowPContraction &lowP,
+                            OpBuilder &builder) {
+  if (lowP.isSigned) {
+    return builder
+        .create<linalg::MatmulOp>(op.getLoc(), ValueRange{lowP.lhs, lowP.rhs},
+                                  ValueRange{lowP.accum})
+        .getResult(0);
+  }
+  return builder
+      .create<linalg::MatmulUnsignedOp>(op.getLoc(),
+                                        ValueRange{lowP.lhs, lowP.rhs},
+                                        ValueRange{lowP.accum})
+      .getResult(0);
+}
 
-    if (isSigned) {
-      newResult = rewriter
-                      .create<linalg::MatmulOp>(loc, ValueRange{newLhs, newRhs},
-                                                ValueRange{newAccum})
-                      .getResult(0);
-    } else {
-      newResult = rewriter
-                      .create<linalg::MatmulUnsignedOp>(
-                          loc, ValueRange{newLhs, newRhs}, ValueRange{newAccum})
-                      .getResult(0);
-    }
+template <>
+Value createLowPContraction(linalg::BatchMatmulOp op,
+                            const LowPContraction &lowP, OpBuilder &builder) {
+  return builder
+      .create<linalg::BatchMatmulOp>(op.getLoc(),
+                                     ValueRange{lowP.lhs, lowP.rhs},
+                                     ValueRange{lowP.accum})
+      .getResult(0);
+}
 
-    // Cast back.
-    newResult = castNumeric(newResult, origResultType, isSigned, rewriter);
-    rewriter.replaceOp(matmulOp, ValueRange{newResult});
+// Creates a convolution |OpTy| with the same strides and dilations as |op|.
+template <typename OpTy>
+Value createLowPConvolution(OpTy op, const LowPContraction &lowP,
+                            OpBuilder &builder) {
+  SmallVector<NamedAttribute> attributes = {
+      builder.getNamedAttr("strides", op.strides()),
+      builder.getNamedAttr("dilations", op.dilations()),
+  };
+  return builder
+      .create<OpTy>(op.getLoc(), TypeRange{lowP.accum.getType()},
+                    ValueRange{lowP.lhs, lowP.rhs}, ValueRange{lowP.accum},
+                    attributes)
+      .getResult(0);
+}
 
+template <>
+Value createLowPContraction(linalg::Conv2DNhwcHwcfOp op,
+                            const LowPContraction &lowP, OpBuilder &builder) {
+  return createLowPConvolution(op, lowP, builder);
+}
+
+template <>
+Value createLowPContraction(linalg::DepthwiseConv2DNhwcHwcOp op,
+                            const LowPContraction &lowP, OpBuilder &builder) {
+  return createLowPConvolution(op, lowP, builder);
+}
+
+// For narrowable inputs, selects an integer contraction with 8-bit inputs
+// and a 32-bit accumulator and casts the result back to the original type.
+// The cast is elementwise and fuses into the dispatch of the contraction
+// where it acts as the dequantizing epilogue. Only matmuls have an unsigned
+// variant; other ops have unsigned inputs promoted to signed.
+template <typename OpTy>
+struct LinalgFpContractionToLowP : public OpRewritePattern<OpTy> {
+  using OpRewritePattern<OpTy>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(OpTy op,
+                                PatternRewriter &rewriter) const override {
+    Type origResultType = op->getResult(0).getType();
+    auto lowP = matchLowPContraction(
+        cast<linalg::LinalgOp>(op.getOperation()),
+        /*allowUnsigned=*/std::is_same<OpTy, linalg::MatmulOp>::value,
+        rewriter);
+    if (failed(lowP)) return failure();
+
+    Value newResult = createLowPContraction(op, *lowP, rewriter);
+
+    // Cast back.
+    newResult =
+        castNumeric(newResult, origResultType, lowP->isSigned, rewriter);
+    rewriter.replaceOp(op, ValueRange{newResult});
     return success();
   }
 };
@@ -258,7 +335,12 @@ class OptimizeNumericsPass : public OptimizeNumericsBase<OptimizeNumericsPass> {
     RewritePatternSet patterns(context);
 
     // Precision reduction.
-    patterns.insert<LinalgFpMatmulToLowP>(context);
+    patterns.insert<LinalgFpContractionToLowP<linalg::MatmulOp>,
+                    LinalgFpContractionToLowP<linalg::BatchMatmulOp>,
+                    LinalgFpContractionToLowP<linalg::Conv2DNhwcHwcfOp>>(
+        context);
+    patterns.insert<
+        LinalgFpContractionToLowP<linalg::DepthwiseConv2DNhwcHwcOp>>(context);
 
     // Cast propagation.
     patterns.insert<LinalgInitTensorCast>(context);
@@ -114,7 +114,8 @@ static mlir::FuncOp createWorkgroupFunc(Location loc, StringRef functionName,
 // Outlines a dispatch region into a flow.executable and replaces the region op
 // with a dispatch to that outlined executable.
 static LogicalResult outlineDispatchWorkgroupsOp(
-    std::string namePrefix, DispatchWorkgroupsOp regionOp) {
+    std::string namePrefix, DispatchWorkgroupsOp regionOp,
+    SymbolTable &moduleSymbolTable) {
   // Convert the region to a free-floating function.
   auto workgroupFuncOp =
       createWorkgroupFunc(regionOp.getLoc(), namePrefix, regionOp.body());
@@ -130,6 +131,10 @@ static LogicalResult outlineDispatchWorkgroupsOp(
   executableOp.getOperation()->moveBefore(parentFuncOp);
   executableOp.setPrivate();
 
+  // Rename the executable if the name is already taken, such as when outlining
+  // dispatch regions created after an earlier outlining.
+  moduleSymbolTable.insert(executableOp);
+
   // Add executable entry point pointing at the function.
   OpBuilder builder(executableOp.body());
   auto entryPointOp = builder.create<DispatchEntryOp>(
@@ -150,6 +155,7 @@ class OutlineDispatchRegionsPass
 
   void runOnOperation() override {
     // Convert each dispatch region into a flow.executable + dispatch op.
+    SymbolTable moduleSymbolTable(getOperation());
     int initializerCount = 0;
     for (auto it :
          llvm::enumerate(getOperation().getOps<FunctionOpInterface>())) {
@@ -173,8 +179,8 @@ class OutlineDispatchRegionsPass
           llvm::to_vector<8>(bodyRegion.getOps<DispatchWorkgroupsOp>());
       for (int i = 0; i < dispatchWorkgroupsOps.size(); ++i) {
         std::string namePrefix = (opName + "_dispatch_" + llvm::Twine(i)).str();
-        if (failed(outlineDispatchWorkgroupsOp(namePrefix,
-                                               dispatchWorkgroupsOps[i]))) {
+        if (failed(outlineDispatchWorkgroupsOp(
+                namePrefix, dispatchWorkgroupsOps[i], moduleSymbolTable))) {
           return signalPassFailure();
         }
       }
@@ -31,6 +31,14 @@ static llvm::cl::opt<bool> clTraceDispatchTensors(
         "Trace runtime input/output tensors for each dispatch function."),
     llvm::cl::init(false));
 
+static llvm::cl::opt<bool> clTraceDispatchTensorsSummary(
+    "iree-flow-trace-dispatch-tensors-summary",
+    llvm::cl::desc("Trace a checksum and min/max/mean/NaN count of the runtime "
+                   "input/output tensors for each dispatch function. The "
+                   "summaries are computed on device so that only a few "
+                   "values are read back per tensor."),
+    llvm::cl::init(false));
+
 static llvm::cl::opt<bool> clDemoteF32ToF16(
     "iree-flow-demote-f32-to-f16",
     llvm::cl::desc("Convert all f32 ops and values into f16 counterparts "
@@ -42,6 +50,24 @@ static llvm::cl::opt<bool> clEnableConvToImg2Col(
     llvm::cl::desc("Enable converting convolution ops to img2col form."),
     llvm::cl::init(false));
 
+static llvm::cl::opt<bool> clEnableConvToWinograd(
+    "iree-flow-enable-conv-winograd-transform",
+    llvm::cl::desc("Enable converting 3x3 convolution ops to Winograd form. "
+                   "Takes precedence over the img2col transform."),
+    llvm::cl::init(false));
+
+static llvm::cl::opt<bool> clEnableZeroWeightBlockElision(
+    "iree-flow-enable-zero-weight-block-elision",
+    llvm::cl::desc("Enable skipping all-zero blocks of constant (pruned) "
+                   "matmul weights."),
+    llvm::cl::init(false));
+
+static llvm::cl::opt<int> clZeroWeightBlockSize(
+    "iree-flow-zero-weight-block-size",
+    llvm::cl::desc("Number of weight rows along the reduction dimension per "
+                   "block when eliding zero weight blocks."),
+    llvm::cl::init(16));
+
 static llvm::cl::opt<bool> clEnablePaddingLinalgOps(
     "iree-flow-enable-padding-linalg-ops",
     llvm::cl::desc("Enable padding linalg ops to an integer multiple of "
@@ -61,6 +87,21 @@ static llvm::cl::opt<bool> clEnableLinalgDetensorize(
     llvm::cl::desc("Enable detensorizing linalg ops to operate on primitives"),
     llvm::cl::init(false));
 
+static llvm::cl::opt<bool> clEnableHorizontalFusion(
+    "iree-flow-enable-horizontal-fusion",
+    llvm::cl::desc("Fuse independent elementwise operations with the same "
+                   "iteration domain into a single dispatch region"),
+    llvm::cl::init(false));
+
+static llvm::cl::opt<std::string> clMmt4dTargetOptions(
+    "iree-flow-mmt4d-target-options",
+    llvm::cl::desc("Converts linalg.matmul ops to linalg.mmt4d ops with "
+                   "their operands packed into tiled layouts for the given "
+                   "target, e.g. 'arch=aarch64 features=+dotprod'. Packing of "
+                   "constant operands is hoisted and may be evaluated at "
+                   "compile time with -iree-opt-const-eval"),
+    llvm::cl::init(""));
+
 namespace mlir {
 namespace iree_compiler {
 namespace IREE {
@@ -117,8 +158,15 @@ void buildFlowTransformPassPipeline(OpPassManager &passManager,
   // Special case peephole optimizations.
   FunctionLikeNest(passManager)
       .addPass(createConvertConv2D1x1ToMatmulPass)
+      .addPredicatedPass(clEnableConvToWinograd,
+                         createConvertConv2DToWinogradPass)
       .addPredicatedPass(clEnableConvToImg2Col,
                          createConvertConv2DToImg2ColPass)
+      .addPredicatedPass(clEnableZeroWeightBlockElision,
+                         []() {
+                           return createElideZeroWeightBlocksPass(
+                               clZeroWeightBlockSize);
+                         })
       // Pad linalg op
       .addPredicatedPass(clEnablePaddingLinalgOps,
                          []() {
@@ -129,6 +177,13 @@ void buildFlowTransformPassPipeline(OpPassManager &passManager,
       // Input should now be legal.
       .addPass(createVerifyInputLegalityPass);
 
+  // Data-tiling of matmuls happens prior to global optimization so that the
+  // packing of constant operands (weights) is hoisted into globals.
+  if (!clMmt4dTargetOptions.empty()) {
+    passManager.addNestedPass<FuncOp>(
+        createConvertLinalgMatmulToMmt4DPass(clMmt4dTargetOptions));
+  }
+
   passManager.addPass(mlir::createLinalgNamedOpConversionPass());
   buildGlobalOptimizationPassPipeline(passManager, transformOptions);
 
@@ -142,12 +197,15 @@ void buildFlowTransformPassPipeline(OpPassManager &passManager,
       .addPass(mlir::createConvertElementwiseToLinalgPass)
       .addPass(mlir::createLinalgFoldUnitExtentDimsPass)
       .addPass(createInterchangeGenericOpsPass)
+      .addPass(createPropagateTransposesPass)
       .addPass(mlir::createCanonicalizerPass)
       .addPass(memref::createResolveShapedTypeResultDimsPass)
 
       // Fusion.
       .addPass(createFusionOfTensorOpsPass)
       .addPass(mlir::createCSEPass)
+      .addPredicatedPass(clEnableHorizontalFusion,
+                         createHorizontalFusionOfTensorOpsPass)
       .addPredicatedPass(clEnableLinalgDetensorize,
                          mlir::createLinalgDetensorizePass)
       // Dispatch region formation.
@@ -196,12 +254,22 @@ void buildFlowTransformPassPipeline(OpPassManager &passManager,
       // Inject tracing that logs both input and output tensors from all
       // dispatches. We do this after deduping so that the executable names
       // match later stages.
-      .addPredicatedPass(clTraceDispatchTensors,
-                         IREE::Flow::createInjectDispatchTracingPass)
+      .addPredicatedPass(
+          clTraceDispatchTensors || clTraceDispatchTensorsSummary,
+          []() {
+            return IREE::Flow::createInjectDispatchTracingPass(
+                clTraceDispatchTensorsSummary);
+          })
       // Cleanup the IR after we are done.
       .addPass(mlir::createCanonicalizerPass)
       .addPass(mlir::createCSEPass);
 
+  // Outline the dispatch regions computing tensor summaries.
+  if (clTraceDispatchTensorsSummary) {
+    passManager.addPass(createOutlineDispatchRegionsPass());
+    passManager.addPass(createDeduplicateExecutablesPass());
+  }
+
   passManager.addNestedPass<IREE::Flow::ExecutableOp>(
       mlir::createCanonicalizerPass());
   passManager.addNestedPass<IREE::Flow::ExecutableOp>(mlir::createCSEPass());
@@ -72,6 +72,10 @@ std::unique_ptr<Pass> createConvertConv2D1x1ToMatmulPass();
 // using im2col tranformation.
 std::unique_ptr<Pass> createConvertConv2DToImg2ColPass();
 
+// Converts 3x3 unit stride linalg.conv_2d_nhwc_hwcf ops into Winograd
+// F(4x4, 3x3) input/filter/output transforms around a linalg.batch_matmul.
+std::unique_ptr<Pass> createConvertConv2DToWinogradPass();
+
 // Pass to convert a linalg.pad_tensor operation into a linalg.fill +
 // subtensor_insert. This allows lowering the operation into a single kernel.
 std::unique_ptr<Pass> createPadTensorToSubTensorInsertPass();
@@ -79,10 +83,17 @@ std::unique_ptr<Pass> createPadTensorToSubTensorInsertPass();
 // Pass to convert a linalg.matmul into linalg.mmt4d given some target ISA
 // information currently passed as pass options.
 std::unique_ptr<OperationPass<FuncOp>> createConvertLinalgMatmulToMmt4DPass();
+std::unique_ptr<OperationPass<FuncOp>> createConvertLinalgMatmulToMmt4DPass(
+    StringRef options);
 
 // Creates a pass to fuse Linalg operations on tensors.
 std::unique_ptr<Pass> createFusionOfTensorOpsPass();
 
+// Creates a pass to fuse independent elementwise Linalg operations on tensors
+// with the same iteration domain into a single operation so that they are
+// formed into a single dispatch region.
+std::unique_ptr<Pass> createHorizontalFusionOfTensorOpsPass();
+
 // Infers and inserts util.numeric.optional_narrow ops at points that may be
 // beneficial.
 std::unique_ptr<Pass> createInferNumericNarrowingPass();
@@ -91,6 +102,10 @@ std::unique_ptr<Pass> createInferNumericNarrowingPass();
 // the most inner loops.
 std::unique_ptr<Pass> createInterchangeGenericOpsPass();
 
+// Creates a pass to fold transposes into the indexing maps of the generic ops
+// producing and consuming them.
+std::unique_ptr<Pass> createPropagateTransposesPass();
+
 // Convert operations to equivalent flow ops before dispatch region creation.
 std::unique_ptr<Pass> createConvertToFlowBeforeDispatchFormation();
 
@@ -126,7 +141,9 @@ std::unique_ptr<OperationPass<mlir::ModuleOp>>
 createOutlineDispatchRegionsPass();
 
 // Injects tracing markers for dispatch operation tensor inputs and outputs.
-std::unique_ptr<Pass> createInjectDispatchTracingPass();
+// When |summarize| is set each tensor is reduced on device to a few summary
+// values by a new dispatch region and only those are traced.
+std::unique_ptr<Pass> createInjectDispatchTracingPass(bool summarize = false);
 
 // Exports all functions and dispatch executables as `() -> ()` benchmark funcs.
 std::unique_ptr<OperationPass<mlir::ModuleOp>> createExportBenchmarkFuncsPass();
@@ -139,6 +156,11 @@ std::unique_ptr<OperationPass<mlir::ModuleOp>> createExportBenchmarkFuncsPass();
 std::unique_ptr<Pass> createPadLinalgOpsToIntegerMultiplePass(
     int paddingSize = 4);
 
+// Splits linalg.matmul ops with constant weights containing all-zero blocks
+// of |blockSize| rows along the reduction dimension into matmuls over only the
+// non-zero rows.
+std::unique_ptr<Pass> createElideZeroWeightBlocksPass(int64_t blockSize = 16);
+
 //===----------------------------------------------------------------------===//
 // Optimizations
 //===----------------------------------------------------------------------===//
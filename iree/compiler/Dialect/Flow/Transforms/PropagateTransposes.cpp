@@ -0,0 +1,162 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+//===--- PropagateTransposes.cpp ------------------------------------------===//
+//
+// Folds transposes expressed as linalg.generic ops into the indexing maps of
+// the generic ops that produce and consume them. Imported programs carry
+// many layout changes (NHWC<->NCHW, attention head shuffles) that otherwise
+// become standalone copy dispatches making a full pass over memory.
+//
+// Transposes are folded into all consuming generic ops regardless of how many
+// uses they have as only the access pattern of the consumer changes. Chains
+// of transposes compose and cancelling pairs leave identity generic ops that
+// are erased by canonicalization. A transpose whose source is produced by an
+// elementwise generic op used only by the transpose is folded into the
+// producer by having it write its result directly in the transposed layout.
+//
+//===----------------------------------------------------------------------===//
+
+#include "iree/compiler/Dialect/Flow/Transforms/PassDetail.h"
+#include "iree/compiler/Dialect/Flow/Transforms/Passes.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/IR/AffineMap.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace Flow {
+
+namespace {
+
+// Returns the permutation mapping result indices of |genericOp| to indices of
+// its source if it is a pure transpose.
+static Optional<AffineMap> getTransposePermutation(
+    linalg::GenericOp genericOp) {
+  if (genericOp.getNumInputs() != 1 || genericOp.getNumOutputs() != 1) {
+    return llvm::None;
+  }
+  if (genericOp.getNumParallelLoops() != genericOp.getNumLoops()) {
+    return llvm::None;
+  }
+  auto yieldOp = dyn_cast<linalg::YieldOp>(genericOp.getBody()->front());
+  if (!yieldOp ||
+      yieldOp.getOperand(0) != genericOp.getBody()->getArgument(0)) {
+    return llvm::None;
+  }
+  AffineMap inputMap =
+      genericOp.getTiedIndexingMap(genericOp.getInputOperand(0));
+  AffineMap outputMap =
+      genericOp.getTiedIndexingMap(genericOp.getOutputOperand(0));
+  if (!inputMap.isPermutation() || !outputMap.isPermutation() ||
+      inputMap == outputMap) {
+    return llvm::None;
+  }
+  return inputMap.compose(inversePermutation(outputMap));
+}
+
+// Folds transposes feeding inputs of a generic op into the indexing maps of
+// those inputs so that the consumer reads the transpose source directly.
+struct FoldTransposeIntoConsumer : public OpRewritePattern<linalg::GenericOp> {
+  using OpRewritePattern<linalg::GenericOp>::OpRewritePattern;
+  LogicalResult matchAndRewrite(linalg::GenericOp consumerOp,
+                                PatternRewriter &rewriter) const override {
+    SmallVector<AffineMap> indexingMaps = consumerOp.getIndexingMaps();
+    SmallVector<std::pair<OpOperand *, Value>> foldedOperands;
+    for (OpOperand *opOperand : consumerOp.getInputOperands()) {
+      auto transposeOp = opOperand->get().getDefiningOp<linalg::GenericOp>();
+      if (!transposeOp) continue;
+      auto permutation = getTransposePermutation(transposeOp);
+      if (!permutation) continue;
+      unsigned operandNumber = opOperand->getOperandNumber();
+      indexingMaps[operandNumber] =
+          permutation->compose(indexingMaps[operandNumber]);
+      foldedOperands.emplace_back(opOperand,
+                                  transposeOp.getInputOperand(0)->get());
+    }
+    if (foldedOperands.empty()) return failure();
+    rewriter.updateRootInPlace(consumerOp, [&]() {
+      for (auto it : foldedOperands) it.first->set(it.second);
+      consumerOp.indexing_mapsAttr(
+          rewriter.getAffineMapArrayAttr(indexingMaps));
+    });
+    return success();
+  }
+};
+
+// Folds a transpose into the elementwise generic op producing its source when
+// the transpose is the only user. The producer is updated to write its result
+// in the transposed layout into the transpose's init tensor.
+struct FoldTransposeIntoProducer : public OpRewritePattern<linalg::GenericOp> {
+  using OpRewritePattern<linalg::GenericOp>::OpRewritePattern;
+  LogicalResult matchAndRewrite(linalg::GenericOp transposeOp,
+                                PatternRewriter &rewriter) const override {
+    auto permutation = getTransposePermutation(transposeOp);
+    if (!permutation) return failure();
+    Value source = transposeOp.getInputOperand(0)->get();
+    auto producerOp = source.getDefiningOp<linalg::GenericOp>();
+    if (!producerOp || !source.hasOneUse() ||
+        producerOp->getNumResults() != 1 ||
+        producerOp->getBlock() != transposeOp->getBlock() ||
+        producerOp.getNumParallelLoops() != producerOp.getNumLoops()) {
+      return failure();
+    }
+    // Chains of transposes are composed by FoldTransposeIntoConsumer.
+    if (getTransposePermutation(producerOp)) return failure();
+    // The producer must not read its init tensor as it is replaced with the
+    // (differently shaped) init tensor of the transpose.
+    OpOperand *outputOperand = producerOp.getOutputOperand(0);
+    if (!producerOp.getTiedBlockArgument(outputOperand).use_empty()) {
+      return failure();
+    }
+
+    SmallVector<AffineMap> indexingMaps = producerOp.getIndexingMaps();
+    unsigned operandNumber = outputOperand->getOperandNumber();
+    indexingMaps[operandNumber] = inversePermutation(*permutation)
+                                      .compose(indexingMaps[operandNumber]);
+    Value init = transposeOp.getOutputOperand(0)->get();
+    rewriter.updateRootInPlace(producerOp, [&]() {
+      producerOp->moveBefore(transposeOp);
+      outputOperand->set(init);
+      producerOp.indexing_mapsAttr(
+          rewriter.getAffineMapArrayAttr(indexingMaps));
+      producerOp->getResult(0).setType(init.getType());
+    });
+    rewriter.replaceOp(transposeOp, producerOp->getResults());
+    return success();
+  }
+};
+
+struct PropagateTransposesPass
+    : public PropagateTransposesBase<PropagateTransposesPass> {
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<linalg::LinalgDialect>();
+  }
+
+  void runOnOperation() override {
+    MLIRContext *context = &getContext();
+    RewritePatternSet patterns(context);
+    patterns.add<FoldTransposeIntoConsumer, FoldTransposeIntoProducer>(
+        context);
+    linalg::GenericOp::getCanonicalizationPatterns(patterns, context);
+    if (failed(applyPatternsAndFoldGreedily(getOperation(),
+                                            std::move(patterns)))) {
+      return signalPassFailure();
+    }
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<Pass> createPropagateTransposesPass() {
+  return std::make_unique<PropagateTransposesPass>();
+}
+
+}  // namespace Flow
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
@@ -0,0 +1,91 @@
+// RUN: iree-opt -split-input-file -iree-flow-convert-conv2d-to-winograd %s | FileCheck %s
+
+func @conv_3x3_tiled(%arg0: tensor<1x10x10x8xf32>, %arg1: tensor<3x3x8x16xf32>, %arg2: tensor<1x8x8x16xf32>) -> tensor<1x8x8x16xf32> {
+    %0 = linalg.conv_2d_nhwc_hwcf
+      {dilations = dense<1> : tensor<2xi64>, strides = dense<1> : tensor<2xi64> }
+       ins(%arg0, %arg1: tensor<1x10x10x8xf32>, tensor<3x3x8x16xf32>)
+      outs(%arg2: tensor<1x8x8x16xf32>) -> tensor<1x8x8x16xf32>
+    return %0 : tensor<1x8x8x16xf32>
+}
+// CHECK-DAG: #[[G_MAP:.+]] = affine_map<(d0, d1, d2, d3, d4, d5) -> (d0, d4)>
+// CHECK-DAG: #[[FILTER_MAP:.+]] = affine_map<(d0, d1, d2, d3, d4, d5) -> (d4, d5, d2, d3)>
+// CHECK-DAG: #[[INPUT_MAP:.+]] = affine_map<(d0, d1, d2, d3, d4, d5, d6, d7) -> (d2, d3 * 4 + d6, d4 * 4 + d7, d5)>
+// CHECK-DAG: #[[M_MAP:.+]] = affine_map<(d0, d1, d2, d3, d4, d5, d6, d7) -> (d6, d7, d0, d1, d3, d5)>
+//     CHECK: @conv_3x3_tiled
+//     CHECK: %[[INPUT:.+]]: tensor<1x10x10x8xf32>
+//     CHECK: %[[FILTER:.+]]: tensor<3x3x8x16xf32>
+//     CHECK: %[[OUTPUT:.+]]: tensor<1x8x8x16xf32>
+//     CHECK: %[[G:.+]] = arith.constant dense<{{.+}}> : tensor<6x3xf32>
+//     CHECK: %[[U:.+]] = linalg.generic
+// CHECK-SAME:   indexing_maps = [#[[G_MAP]], #[[FILTER_MAP]]
+// CHECK-SAME:   ins(%[[G]], %[[FILTER]], %[[G]] : tensor<6x3xf32>, tensor<3x3x8x16xf32>, tensor<6x3xf32>)
+// CHECK-SAME:   -> tensor<6x6x8x16xf32>
+// CHECK-NOT: tensor.pad
+//     CHECK: %[[BT:.+]] = arith.constant dense<{{.+}}> : tensor<6x6xf32>
+//     CHECK: %[[V:.+]] = linalg.generic
+// CHECK-SAME:   #[[INPUT_MAP]]
+// CHECK-SAME:   ins(%[[BT]], %[[INPUT]], %[[BT]] : tensor<6x6xf32>, tensor<1x10x10x8xf32>, tensor<6x6xf32>)
+// CHECK-SAME:   -> tensor<6x6x1x2x2x8xf32>
+// CHECK-DAG: %[[COLLAPSED_V:.+]] = tensor.collapse_shape %[[V]] {{\[}}[0, 1], [2, 3, 4], [5]] : tensor<6x6x1x2x2x8xf32> into tensor<36x4x8xf32>
+// CHECK-DAG: %[[COLLAPSED_U:.+]] = tensor.collapse_shape %[[U]] {{\[}}[0, 1], [2], [3]] : tensor<6x6x8x16xf32> into tensor<36x8x16xf32>
+//     CHECK: %[[M:.+]] = linalg.batch_matmul ins(%[[COLLAPSED_V]], %[[COLLAPSED_U]] : tensor<36x4x8xf32>, tensor<36x8x16xf32>)
+//     CHECK: %[[EXPANDED_M:.+]] = tensor.expand_shape %[[M]] {{\[}}[0, 1], [2, 3, 4], [5]] : tensor<36x4x16xf32> into tensor<6x6x1x2x2x16xf32>
+//     CHECK: %[[AT:.+]] = arith.constant dense<{{.+}}> : tensor<4x6xf32>
+//     CHECK: %[[Y:.+]] = linalg.generic
+// CHECK-SAME:   #[[M_MAP]]
+// CHECK-SAME:   ins(%[[AT]], %[[EXPANDED_M]], %[[AT]] : tensor<4x6xf32>, tensor<6x6x1x2x2x16xf32>, tensor<4x6xf32>)
+// CHECK-SAME:   -> tensor<1x2x4x2x4x16xf32>
+//     CHECK: %[[UNTILED:.+]] = tensor.collapse_shape %[[Y]] {{\[}}[0], [1, 2], [3, 4], [5]] : tensor<1x2x4x2x4x16xf32> into tensor<1x8x8x16xf32>
+// CHECK-NOT: tensor.extract_slice
+//     CHECK: %[[RESULT:.+]] = linalg.generic
+// CHECK-SAME:   ins(%[[UNTILED]] : tensor<1x8x8x16xf32>) outs(%[[OUTPUT]] : tensor<1x8x8x16xf32>)
+//     CHECK: arith.addf
+//     CHECK: return %[[RESULT]]
+
+// -----
+
+func @conv_3x3_partial_tiles(%arg0: tensor<2x9x9x8xf32>, %arg1: tensor<3x3x8x8xf32>, %arg2: tensor<2x7x7x8xf32>) -> tensor<2x7x7x8xf32> {
+    %0 = linalg.conv_2d_nhwc_hwcf
+      {dilations = dense<1> : tensor<2xi64>, strides = dense<1> : tensor<2xi64> }
+       ins(%arg0, %arg1: tensor<2x9x9x8xf32>, tensor<3x3x8x8xf32>)
+      outs(%arg2: tensor<2x7x7x8xf32>) -> tensor<2x7x7x8xf32>
+    return %0 : tensor<2x7x7x8xf32>
+}
+//     CHECK: @conv_3x3_partial_tiles
+//     CHECK: %[[INPUT:.+]]: tensor<2x9x9x8xf32>
+//     CHECK: %[[PADDED:.+]] = tensor.pad %[[INPUT]] low[0, 0, 0, 0] high[0, 1, 1, 0]
+//     CHECK: tensor<2x9x9x8xf32> to tensor<2x10x10x8xf32>
+//     CHECK: linalg.generic
+// CHECK-SAME:   ins(%{{.+}}, %[[PADDED]], %{{.+}} : tensor<6x6xf32>, tensor<2x10x10x8xf32>, tensor<6x6xf32>)
+// CHECK-SAME:   -> tensor<6x6x2x2x2x8xf32>
+//     CHECK: linalg.batch_matmul
+// CHECK-SAME:   tensor<36x8x8xf32>, tensor<36x8x8xf32>
+//     CHECK: %[[UNTILED:.+]] = tensor.collapse_shape
+// CHECK-SAME:   tensor<2x2x4x2x4x8xf32> into tensor<2x8x8x8xf32>
+//     CHECK: tensor.extract_slice %[[UNTILED]][0, 0, 0, 0] [2, 7, 7, 8] [1, 1, 1, 1] : tensor<2x8x8x8xf32> to tensor<2x7x7x8xf32>
+
+// -----
+
+func @conv_3x3_strided(%arg0: tensor<1x17x17x8xf32>, %arg1: tensor<3x3x8x16xf32>, %arg2: tensor<1x8x8x16xf32>) -> tensor<1x8x8x16xf32> {
+    %0 = linalg.conv_2d_nhwc_hwcf
+      {dilations = dense<1> : tensor<2xi64>, strides = dense<2> : tensor<2xi64> }
+       ins(%arg0, %arg1: tensor<1x17x17x8xf32>, tensor<3x3x8x16xf32>)
+      outs(%arg2: tensor<1x8x8x16xf32>) -> tensor<1x8x8x16xf32>
+    return %0 : tensor<1x8x8x16xf32>
+}
+//     CHECK: @conv_3x3_strided
+//     CHECK: linalg.conv_2d_nhwc_hwcf
+// CHECK-NOT: linalg.batch_matmul
+
+// -----
+
+func @conv_3x3_few_channels(%arg0: tensor<1x10x10x3xf32>, %arg1: tensor<3x3x3x16xf32>, %arg2: tensor<1x8x8x16xf32>) -> tensor<1x8x8x16xf32> {
+    %0 = linalg.conv_2d_nhwc_hwcf
+      {dilations = dense<1> : tensor<2xi64>, strides = dense<1> : tensor<2xi64> }
+       ins(%arg0, %arg1: tensor<1x10x10x3xf32>, tensor<3x3x3x16xf32>)
+      outs(%arg2: tensor<1x8x8x16xf32>) -> tensor<1x8x8x16xf32>
+    return %0 : tensor<1x8x8x16xf32>
+}
+//     CHECK: @conv_3x3_few_channels
+//     CHECK: linalg.conv_2d_nhwc_hwcf
+// CHECK-NOT: linalg.batch_matmul
@@ -139,3 +139,47 @@ func @tile_parallel_reduction(%arg0: tensor<7x7x1280xf32>) -> tensor<1280xf32> {
 //      CHECK:     flow.dispatch.tensor.store %[[GENERIC]], %[[ARG2]], {{.*}}
 
 //      CHECK: return %[[REDUCE]]
+
+// -----
+
+func @inplace_elementwise_chain(%A: tensor<4x8xf32>, %B: tensor<4x8xf32>) -> tensor<4x8xf32> {
+  %0 = linalg.init_tensor [4, 8] : tensor<4x8xf32>
+  %1 = linalg.generic {
+    indexing_maps = [affine_map<(d0, d1) -> (d0, d1)>,
+                     affine_map<(d0, d1) -> (d0, d1)>,
+                     affine_map<(d0, d1) -> (d0, d1)>],
+    iterator_types = ["parallel", "parallel"]}
+    ins (%A, %B: tensor<4x8xf32>, tensor<4x8xf32>)
+    outs (%0 : tensor<4x8xf32>) {
+      ^bb0(%arg0 : f32, %arg1 : f32, %arg2 : f32):
+        %2 = arith.addf %arg0, %arg1 : f32
+        linalg.yield %2 : f32
+    } -> tensor<4x8xf32>
+  %3 = linalg.init_tensor [4, 8] : tensor<4x8xf32>
+  %4 = linalg.generic {
+    indexing_maps = [affine_map<(d0, d1) -> (d0, d1)>,
+                     affine_map<(d0, d1) -> (d0, d1)>,
+                     affine_map<(d0, d1) -> (d0, d1)>],
+    iterator_types = ["parallel", "parallel"]}
+    ins (%1, %B: tensor<4x8xf32>, tensor<4x8xf32>)
+    outs (%3 : tensor<4x8xf32>) {
+      ^bb0(%arg0 : f32, %arg1 : f32, %arg2 : f32):
+        %5 = arith.mulf %arg0, %arg1 : f32
+        linalg.yield %5 : f32
+    } -> tensor<4x8xf32>
+  return %4 : tensor<4x8xf32>
+}
+//      CHECK: func @inplace_elementwise_chain
+// CHECK-SAME:   %[[ARG0:[a-zA-Z0-9_]+]]: tensor<4x8xf32>
+// CHECK-SAME:   %[[ARG1:[a-zA-Z0-9_]+]]: tensor<4x8xf32>
+//      CHECK:   %[[ADD:.+]] = flow.dispatch.workgroups
+// CHECK-SAME:     (%[[ARG0]], %[[ARG1]]) : (tensor<4x8xf32>, tensor<4x8xf32>) -> tensor<4x8xf32> =
+// CHECK-NEXT:     (%{{.+}}: !flow.dispatch.tensor<readonly:4x8xf32>, %{{.+}}: !flow.dispatch.tensor<readonly:4x8xf32>, %{{.+}}: !flow.dispatch.tensor<writeonly:4x8xf32>)
+//      CHECK:   %[[MUL:.+]] = flow.dispatch.workgroups
+// CHECK-SAME:     (%[[ADD]], %[[ARG1]]) : (tensor<4x8xf32>, tensor<4x8xf32>) -> %[[ADD]] =
+// CHECK-NEXT:     (%[[ADD_CAPTURE:[a-zA-Z0-9_]+]]: !flow.dispatch.tensor<readwrite:4x8xf32>, %{{.+}}: !flow.dispatch.tensor<readonly:4x8xf32>)
+//      CHECK:         %[[LOAD:.+]] = flow.dispatch.tensor.load %[[ADD_CAPTURE]]
+//      CHECK:         %[[RESULT:.+]] = linalg.generic
+// CHECK-SAME:           outs(%[[LOAD]] : tensor<?x?xf32>)
+//      CHECK:         flow.dispatch.tensor.store %[[RESULT]], %[[ADD_CAPTURE]]
+//      CHECK:   return %[[MUL]]
@@ -0,0 +1,123 @@
+// RUN: iree-opt -split-input-file -verify-diagnostics -pass-pipeline="builtin.func(iree-flow-dispatch-linalg-on-tensors-pass)" -iree-flow-enable-fusion-across-reductions -canonicalize -cse %s | FileCheck %s
+
+func @softmax(%input: tensor<12x128x128xf32>) -> tensor<12x128x128xf32> {
+  %cst = arith.constant -3.40282347E+38 : f32
+  %cst_0 = arith.constant 0.000000e+00 : f32
+  %0 = linalg.init_tensor [12, 128] : tensor<12x128xf32>
+  %1 = linalg.fill(%cst, %0) : f32, tensor<12x128xf32> -> tensor<12x128xf32>
+  %2 = linalg.generic {
+         indexing_maps = [
+           affine_map<(d0, d1, d2) -> (d0, d1, d2)>,
+           affine_map<(d0, d1, d2) -> (d0, d1)>],
+         iterator_types = ["parallel", "parallel", "reduction"]}
+         ins(%input : tensor<12x128x128xf32>) outs(%1 : tensor<12x128xf32>) {
+         ^bb0(%arg0: f32, %arg1: f32):
+           %9 = arith.maxf %arg0, %arg1 : f32
+           linalg.yield %9 : f32
+         } -> tensor<12x128xf32>
+  %3 = linalg.init_tensor [12, 128, 128] : tensor<12x128x128xf32>
+  %4 = linalg.generic {
+         indexing_maps = [
+           affine_map<(d0, d1, d2) -> (d0, d1, d2)>,
+           affine_map<(d0, d1, d2) -> (d0, d1)>,
+           affine_map<(d0, d1, d2) -> (d0, d1, d2)>],
+         iterator_types = ["parallel", "parallel", "parallel"]}
+         ins(%input, %2 : tensor<12x128x128xf32>, tensor<12x128xf32>)
+         outs(%3 : tensor<12x128x128xf32>) {
+         ^bb0(%arg0: f32, %arg1: f32, %arg2: f32):
+           %9 = arith.subf %arg0, %arg1 : f32
+           %10 = math.exp %9 : f32
+           linalg.yield %10 : f32
+         } -> tensor<12x128x128xf32>
+  %5 = linalg.fill(%cst_0, %0) : f32, tensor<12x128xf32> -> tensor<12x128xf32>
+  %6 = linalg.generic {
+         indexing_maps = [
+           affine_map<(d0, d1, d2) -> (d0, d1, d2)>,
+           affine_map<(d0, d1, d2) -> (d0, d1)>],
+         iterator_types = ["parallel", "parallel", "reduction"]}
+         ins(%4 : tensor<12x128x128xf32>) outs(%5 : tensor<12x128xf32>) {
+         ^bb0(%arg0: f32, %arg1: f32):
+           %9 = arith.addf %arg0, %arg1 : f32
+           linalg.yield %9 : f32
+         } -> tensor<12x128xf32>
+  %7 = linalg.generic {
+         indexing_maps = [
+           affine_map<(d0, d1, d2) -> (d0, d1, d2)>,
+           affine_map<(d0, d1, d2) -> (d0, d1)>,
+           affine_map<(d0, d1, d2) -> (d0, d1, d2)>],
+         iterator_types = ["parallel", "parallel", "parallel"]}
+         ins(%4, %6 : tensor<12x128x128xf32>, tensor<12x128xf32>)
+         outs(%3 : tensor<12x128x128xf32>) {
+         ^bb0(%arg0: f32, %arg1: f32, %arg2: f32):
+           %9 = arith.divf %arg0, %arg1 : f32
+           linalg.yield %9 : f32
+         } -> tensor<12x128x128xf32>
+  return %7 : tensor<12x128x128xf32>
+}
+
+// Check that the whole softmax is formed into a single dispatch region that is
+// distributed only along the loops that are parallel in both reductions.
+
+//      CHECK: func @softmax
+//  CHECK-DAG:   %[[C12:.+]] = arith.constant 12 : index
+//  CHECK-DAG:   %[[C128:.+]] = arith.constant 128 : index
+//      CHECK:   %[[DISPATCH:.+]] = flow.dispatch.workgroups[%[[C128]], %[[C12]], %{{.+}}]
+//  CHECK-NOT:     flow.dispatch.workgroups
+//      CHECK:     scf.for
+//      CHECK:       scf.for
+//  CHECK-NOT:         scf.for
+//      CHECK:         %[[FILL0:.+]] = linalg.fill
+//      CHECK:         %[[MAX:.+]] = linalg.generic
+// CHECK-SAME:           outs(%[[FILL0]] :
+//      CHECK:         %[[EXP:.+]] = linalg.generic
+// CHECK-SAME:           ins(%{{.+}}, %[[MAX]] :
+//      CHECK:         %[[FILL1:.+]] = linalg.fill
+//      CHECK:         %[[SUM:.+]] = linalg.generic
+// CHECK-SAME:           outs(%[[FILL1]] :
+//      CHECK:         %[[DIV:.+]] = linalg.generic
+// CHECK-SAME:           ins(%{{.+}}, %[[SUM]] :
+//      CHECK:         flow.dispatch.tensor.store %[[DIV]]
+//      CHECK:   return %[[DISPATCH]]
+
+// -----
+
+func @dont_fuse_reduction_with_external_use(%input: tensor<12x128xf32>)
+    -> (tensor<12xf32>, tensor<12x128xf32>) {
+  %cst = arith.constant 0.000000e+00 : f32
+  %0 = linalg.init_tensor [12] : tensor<12xf32>
+  %1 = linalg.fill(%cst, %0) : f32, tensor<12xf32> -> tensor<12xf32>
+  %2 = linalg.generic {
+         indexing_maps = [
+           affine_map<(d0, d1) -> (d0, d1)>,
+           affine_map<(d0, d1) -> (d0)>],
+         iterator_types = ["parallel", "reduction"]}
+         ins(%input : tensor<12x128xf32>) outs(%1 : tensor<12xf32>) {
+         ^bb0(%arg0: f32, %arg1: f32):
+           %5 = arith.addf %arg0, %arg1 : f32
+           linalg.yield %5 : f32
+         } -> tensor<12xf32>
+  %3 = linalg.init_tensor [12, 128] : tensor<12x128xf32>
+  %4 = linalg.generic {
+         indexing_maps = [
+           affine_map<(d0, d1) -> (d0, d1)>,
+           affine_map<(d0, d1) -> (d0)>,
+           affine_map<(d0, d1) -> (d0, d1)>],
+         iterator_types = ["parallel", "parallel"]}
+         ins(%input, %2 : tensor<12x128xf32>, tensor<12xf32>)
+         outs(%3 : tensor<12x128xf32>) {
+         ^bb0(%arg0: f32, %arg1: f32, %arg2: f32):
+           %5 = arith.divf %arg0, %arg1 : f32
+           linalg.yield %5 : f32
+         } -> tensor<12x128xf32>
+  return %2, %4 : tensor<12xf32>, tensor<12x128xf32>
+}
+
+// The reduction result is also returned so it is not fused with its consumer.
+
+// CHECK-LABEL: func @dont_fuse_reduction_with_external_use
+//       CHECK:   flow.dispatch.workgroups
+//       CHECK:     linalg.generic
+//  CHECK-SAME:       iterator_types = ["parallel", "reduction"]
+//       CHECK:   flow.dispatch.workgroups
+//       CHECK:     linalg.generic
+//  CHECK-SAME:       iterator_types = ["parallel", "parallel"]
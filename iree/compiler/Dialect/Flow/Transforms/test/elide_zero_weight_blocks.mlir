@@ -0,0 +1,58 @@
+// RUN: iree-opt -split-input-file --iree-flow-elide-zero-weight-blocks=block-size=2 %s | FileCheck %s
+
+func @matmul_block_sparse(%lhs: tensor<?x8xf32>, %acc: tensor<?x4xf32>) -> tensor<?x4xf32> {
+  %rhs = arith.constant dense<[[1.0, 2.0, 3.0, 4.0], [5.0, 6.0, 7.0, 8.0], [0.0, 0.0, 0.0, 0.0], [0.0, 0.0, 0.0, 0.0], [0.0, 0.0, 0.0, 0.0], [0.0, 0.0, 0.0, 0.0], [9.0, 10.0, 11.0, 12.0], [13.0, 14.0, 15.0, 16.0]]> : tensor<8x4xf32>
+  %0 = linalg.matmul ins(%lhs, %rhs : tensor<?x8xf32>, tensor<8x4xf32>) outs(%acc : tensor<?x4xf32>) -> tensor<?x4xf32>
+  return %0 : tensor<?x4xf32>
+}
+//      CHECK: func @matmul_block_sparse
+// CHECK-SAME:   %[[LHS:[a-zA-Z0-9_]+]]: tensor<?x8xf32>
+// CHECK-SAME:   %[[ACC:[a-zA-Z0-9_]+]]: tensor<?x4xf32>
+//  CHECK-DAG:   %[[RHS0:.+]] = arith.constant dense<{{\[}}[1.000000e+00, 2.000000e+00, 3.000000e+00, 4.000000e+00], [5.000000e+00, 6.000000e+00, 7.000000e+00, 8.000000e+00]]> : tensor<2x4xf32>
+//  CHECK-DAG:   %[[RHS1:.+]] = arith.constant dense<{{\[}}[9.000000e+00, 1.000000e+01, 1.100000e+01, 1.200000e+01], [1.300000e+01, 1.400000e+01, 1.500000e+01, 1.600000e+01]]> : tensor<2x4xf32>
+//  CHECK-DAG:   %[[C0:.+]] = arith.constant 0 : index
+//  CHECK-DAG:   %[[M:.+]] = tensor.dim %[[LHS]], %[[C0]]
+//      CHECK:   %[[LHS0:.+]] = tensor.extract_slice %[[LHS]][0, 0] [%[[M]], 2] [1, 1] : tensor<?x8xf32> to tensor<?x2xf32>
+//      CHECK:   %[[MATMUL0:.+]] = linalg.matmul ins(%[[LHS0]], %[[RHS0]] : tensor<?x2xf32>, tensor<2x4xf32>) outs(%[[ACC]] : tensor<?x4xf32>)
+//      CHECK:   %[[LHS1:.+]] = tensor.extract_slice %[[LHS]][0, 6] [%[[M]], 2] [1, 1] : tensor<?x8xf32> to tensor<?x2xf32>
+//      CHECK:   %[[MATMUL1:.+]] = linalg.matmul ins(%[[LHS1]], %[[RHS1]] : tensor<?x2xf32>, tensor<2x4xf32>) outs(%[[MATMUL0]] : tensor<?x4xf32>)
+//      CHECK:   return %[[MATMUL1]]
+
+// -----
+
+func @matmul_i8_block_sparse(%lhs: tensor<3x8xi8>, %acc: tensor<3x4xi32>) -> tensor<3x4xi32> {
+  %rhs = arith.constant dense<[[0, 0, 0, 0], [0, 0, 0, 0], [1, 2, 3, 4], [0, 0, 0, 0], [0, 0, 0, 0], [0, 0, 0, 0], [0, 0, 0, 0], [0, 0, 0, 0]]> : tensor<8x4xi8>
+  %0 = linalg.matmul ins(%lhs, %rhs : tensor<3x8xi8>, tensor<8x4xi8>) outs(%acc : tensor<3x4xi32>) -> tensor<3x4xi32>
+  return %0 : tensor<3x4xi32>
+}
+//      CHECK: func @matmul_i8_block_sparse
+// CHECK-SAME:   %[[LHS:[a-zA-Z0-9_]+]]: tensor<3x8xi8>
+// CHECK-SAME:   %[[ACC:[a-zA-Z0-9_]+]]: tensor<3x4xi32>
+//  CHECK-DAG:   %[[RHS0:.+]] = arith.constant dense<{{\[}}[1, 2, 3, 4], [0, 0, 0, 0]]> : tensor<2x4xi8>
+//      CHECK:   %[[LHS0:.+]] = tensor.extract_slice %[[LHS]][0, 2] [3, 2] [1, 1] : tensor<3x8xi8> to tensor<3x2xi8>
+//      CHECK:   %[[MATMUL:.+]] = linalg.matmul ins(%[[LHS0]], %[[RHS0]] : tensor<3x2xi8>, tensor<2x4xi8>) outs(%[[ACC]] : tensor<3x4xi32>)
+//  CHECK-NOT:   linalg.matmul
+//      CHECK:   return %[[MATMUL]]
+
+// -----
+
+func @matmul_all_zero(%lhs: tensor<3x8xf32>, %acc: tensor<3x4xf32>) -> tensor<3x4xf32> {
+  %rhs = arith.constant dense<0.0> : tensor<8x4xf32>
+  %0 = linalg.matmul ins(%lhs, %rhs : tensor<3x8xf32>, tensor<8x4xf32>) outs(%acc : tensor<3x4xf32>) -> tensor<3x4xf32>
+  return %0 : tensor<3x4xf32>
+}
+// Splat weights are left to the canonicalizer.
+//      CHECK: func @matmul_all_zero
+//      CHECK:   linalg.matmul
+
+// -----
+
+func @matmul_dense(%lhs: tensor<3x8xf32>, %acc: tensor<3x4xf32>) -> tensor<3x4xf32> {
+  %rhs = arith.constant dense<[[1.0, 2.0, 3.0, 4.0], [5.0, 6.0, 7.0, 8.0], [1.0, 0.0, 0.0, 0.0], [0.0, 0.0, 0.0, 0.0], [0.0, 0.0, 0.0, 1.0], [0.0, 0.0, 0.0, 0.0], [9.0, 10.0, 11.0, 12.0], [13.0, 14.0, 15.0, 16.0]]> : tensor<8x4xf32>
+  %0 = linalg.matmul ins(%lhs, %rhs : tensor<3x8xf32>, tensor<8x4xf32>) outs(%acc : tensor<3x4xf32>) -> tensor<3x4xf32>
+  return %0 : tensor<3x4xf32>
+}
+// No block is entirely zero.
+//      CHECK: func @matmul_dense
+//      CHECK:   linalg.matmul
+//  CHECK-NOT:   tensor.extract_slice
@@ -17,6 +17,18 @@ module {
 // CHECK-DAG: util.do_not_optimize(%[[RET]]#0) : tensor<5x5xf32>
 // CHECK-DAG: util.do_not_optimize(%[[RET]]#1) : tensor<3x5xf32>
 
+// CHECK-DAG: util.global private @[[DISPATCH0_IN_0:.+]] {noinline} = dense<{{.*}}> : tensor<5x3xf32>
+// CHECK-DAG: util.global private @[[DISPATCH0_IN_1:.+]] {noinline} = dense<{{.*}}> : tensor<3x5xf32>
+//     CHECK: func @two_dispatch_dispatch_0_benchmark() attributes {iree.abi.stub, iree.reflection = {benchmark = "dispatch"}}
+// CHECK-DAG: %[[IN0:.+]] = util.global.load @[[DISPATCH0_IN_0]] : tensor<5x3xf32>
+// CHECK-DAG: %[[IN1:.+]] = util.global.load @[[DISPATCH0_IN_1]] : tensor<3x5xf32>
+//     CHECK: %[[RET0:.+]] = flow.dispatch @two_dispatch_dispatch_0::@two_dispatch_dispatch_0{{.+}}(%[[IN0]], %[[IN1]])
+//     CHECK: util.do_not_optimize(%[[RET0]]) : tensor<5x5xf32>
+
+//     CHECK: func @two_dispatch_dispatch_1_benchmark() attributes {iree.abi.stub, iree.reflection = {benchmark = "dispatch"}}
+//     CHECK: %[[RET1:.+]] = flow.dispatch @two_dispatch_dispatch_1::@two_dispatch_dispatch_1
+//     CHECK: util.do_not_optimize(%[[RET1]]) : tensor<3x5xf32>
+
 // -----
 
 func @while(%start: tensor<i32>, %bound: tensor<i32>) -> tensor<i32> {
@@ -0,0 +1,93 @@
+// RUN: iree-opt -split-input-file -iree-flow-horizontal-fusion-of-tensor-ops %s | FileCheck %s
+
+#map = affine_map<(d0, d1) -> (d0, d1)>
+#bcast = affine_map<(d0, d1) -> (d1)>
+func @independent_bias_adds(%arg0: tensor<4x64xf32>, %arg1: tensor<4x64xf32>,
+                            %bias0: tensor<64xf32>, %bias1: tensor<64xf32>)
+    -> (tensor<4x64xf32>, tensor<4x64xf32>) {
+  %init = linalg.init_tensor [4, 64] : tensor<4x64xf32>
+  %0 = linalg.generic {indexing_maps = [#map, #bcast, #map], iterator_types = ["parallel", "parallel"]}
+      ins(%arg0, %bias0 : tensor<4x64xf32>, tensor<64xf32>) outs(%init : tensor<4x64xf32>) {
+  ^bb0(%a: f32, %b: f32, %out: f32):
+    %add = arith.addf %a, %b : f32
+    linalg.yield %add : f32
+  } -> tensor<4x64xf32>
+  %1 = linalg.generic {indexing_maps = [#map, #bcast, #map], iterator_types = ["parallel", "parallel"]}
+      ins(%arg1, %bias1 : tensor<4x64xf32>, tensor<64xf32>) outs(%init : tensor<4x64xf32>) {
+  ^bb0(%a: f32, %b: f32, %out: f32):
+    %add = arith.addf %a, %b : f32
+    linalg.yield %add : f32
+  } -> tensor<4x64xf32>
+  return %0, %1 : tensor<4x64xf32>, tensor<4x64xf32>
+}
+//      CHECK: func @independent_bias_adds
+// CHECK-SAME:   %[[ARG0:[a-zA-Z0-9_]+]]: tensor<4x64xf32>
+// CHECK-SAME:   %[[ARG1:[a-zA-Z0-9_]+]]: tensor<4x64xf32>
+// CHECK-SAME:   %[[BIAS0:[a-zA-Z0-9_]+]]: tensor<64xf32>
+// CHECK-SAME:   %[[BIAS1:[a-zA-Z0-9_]+]]: tensor<64xf32>
+//      CHECK:   %[[INIT:.+]] = linalg.init_tensor
+//      CHECK:   %[[FUSED:.+]]:2 = linalg.generic
+// CHECK-SAME:       ins(%[[ARG0]], %[[BIAS0]], %[[ARG1]], %[[BIAS1]] :
+// CHECK-SAME:       outs(%[[INIT]], %[[INIT]] :
+//      CHECK:     ^bb0(%[[A0:.+]]: f32, %[[B0:.+]]: f32, %[[A1:.+]]: f32, %[[B1:.+]]: f32, %{{.+}}: f32, %{{.+}}: f32)
+//  CHECK-DAG:       %[[ADD0:.+]] = arith.addf %[[A0]], %[[B0]]
+//  CHECK-DAG:       %[[ADD1:.+]] = arith.addf %[[A1]], %[[B1]]
+//      CHECK:       linalg.yield %[[ADD0]], %[[ADD1]]
+//  CHECK-NOT:   linalg.generic
+//      CHECK:   return %[[FUSED]]#0, %[[FUSED]]#1
+
+// -----
+
+#map = affine_map<(d0) -> (d0)>
+func @dependent_ops(%arg0: tensor<64xf32>) -> tensor<64xf32> {
+  %init = linalg.init_tensor [64] : tensor<64xf32>
+  %0 = linalg.generic {indexing_maps = [#map, #map], iterator_types = ["parallel"]}
+      ins(%arg0 : tensor<64xf32>) outs(%init : tensor<64xf32>) {
+  ^bb0(%a: f32, %out: f32):
+    %neg = arith.negf %a : f32
+    linalg.yield %neg : f32
+  } -> tensor<64xf32>
+  %1 = linalg.generic {indexing_maps = [#map, #map], iterator_types = ["parallel"]}
+      ins(%0 : tensor<64xf32>) outs(%init : tensor<64xf32>) {
+  ^bb0(%a: f32, %out: f32):
+    %add = arith.addf %a, %a : f32
+    linalg.yield %add : f32
+  } -> tensor<64xf32>
+  return %1 : tensor<64xf32>
+}
+// CHECK-LABEL: func @dependent_ops
+//       CHECK:   linalg.generic
+//       CHECK:   linalg.generic
+
+// -----
+
+// Elementwise consumers of root ops are left for dispatch region formation.
+#map = affine_map<(d0, d1) -> (d0, d1)>
+func @consumers_of_roots(%lhs: tensor<4x8xf32>, %rhs0: tensor<8x16xf32>,
+                         %rhs1: tensor<8x16xf32>, %init: tensor<4x16xf32>)
+    -> (tensor<4x16xf32>, tensor<4x16xf32>) {
+  %0 = linalg.matmul ins(%lhs, %rhs0 : tensor<4x8xf32>, tensor<8x16xf32>)
+      outs(%init : tensor<4x16xf32>) -> tensor<4x16xf32>
+  %1 = linalg.matmul ins(%lhs, %rhs1 : tensor<4x8xf32>, tensor<8x16xf32>)
+      outs(%init : tensor<4x16xf32>) -> tensor<4x16xf32>
+  %2 = linalg.generic {indexing_maps = [#map, #map], iterator_types = ["parallel", "parallel"]}
+      ins(%0 : tensor<4x16xf32>) outs(%init : tensor<4x16xf32>) {
+  ^bb0(%a: f32, %out: f32):
+    %neg = arith.negf %a : f32
+    linalg.yield %neg : f32
+  } -> tensor<4x16xf32>
+  %3 = linalg.generic {indexing_maps = [#map, #map], iterator_types = ["parallel", "parallel"]}
+      ins(%1 : tensor<4x16xf32>) outs(%init : tensor<4x16xf32>) {
+  ^bb0(%a: f32, %out: f32):
+    %neg = arith.negf %a : f32
+    linalg.yield %neg : f32
+  } -> tensor<4x16xf32>
+  return %2, %3 : tensor<4x16xf32>, tensor<4x16xf32>
+}
+// CHECK-LABEL: func @consumers_of_roots
+//       CHECK:   %[[MM0:.+]] = linalg.matmul
+//       CHECK:   %[[MM1:.+]] = linalg.matmul
+//       CHECK:   linalg.generic
+//  CHECK-SAME:     ins(%[[MM0]] :
+//       CHECK:   linalg.generic
+//  CHECK-SAME:     ins(%[[MM1]] :
@@ -0,0 +1,30 @@
+// RUN: iree-opt -split-input-file -pass-pipeline='builtin.func(iree-flow-inject-dispatch-tracing{summarize=true})' %s | FileCheck %s
+
+// CHECK-LABEL: func @summarizeDispatch
+// CHECK-SAME: (%[[ARG0:.+]]: tensor<4x?xf32>, %[[DIM:.+]]: index)
+func @summarizeDispatch(%arg0: tensor<4x?xf32>, %dim: index) -> tensor<4xi32> {
+  %c4 = arith.constant 4 : index
+
+  //      CHECK: %[[IN:.+]]:5 = flow.dispatch.workgroups[%{{.+}}](%[[ARG0]], %[[DIM]])
+  // CHECK-SAME:     : (tensor<4x?xf32>{%[[DIM]]}, index) -> (tensor<i64>, tensor<f32>, tensor<f32>, tensor<f32>, tensor<i64>)
+  //      CHECK:   %[[TENSOR:.+]] = flow.dispatch.tensor.load
+  //      CHECK:   linalg.generic
+  // CHECK-SAME:       iterator_types = ["reduction", "reduction"]
+  // CHECK-SAME:       ins(%[[TENSOR]] : tensor<4x?xf32>)
+  //      CHECK:     arith.bitcast %{{.+}} : f32 to i32
+  //      CHECK:     arith.minf
+  //      CHECK:     arith.maxf
+  //      CHECK:     arith.cmpf uno
+  //      CHECK:   flow.dispatch.tensor.store
+  //      CHECK: flow.tensor.trace {key = "ex::entry0 inputs"} %[[IN]]#0, %[[IN]]#1, %[[IN]]#2, %[[IN]]#3, %[[IN]]#4
+  //      CHECK: %[[RET0:.+]] = flow.dispatch @ex::@entry0
+  %0 = flow.dispatch @ex::@entry0[%c4](%arg0, %dim) : (tensor<4x?xf32>{%dim}, index) -> tensor<4xi32>
+
+  //      CHECK: %[[OUT:.+]]:5 = flow.dispatch.workgroups[%{{.+}}](%[[RET0]])
+  // CHECK-SAME:     : (tensor<4xi32>) -> (tensor<i64>, tensor<f32>, tensor<f32>, tensor<f32>, tensor<i64>)
+  //      CHECK:   arith.sitofp %{{.+}} : i32 to f32
+  //  CHECK-NOT:   arith.cmpf
+  //      CHECK: flow.tensor.trace {key = "ex::entry0 outputs"} %[[OUT]]#0, %[[OUT]]#1, %[[OUT]]#2, %[[OUT]]#3, %[[OUT]]#4
+  // CHECK-NEXT: return %[[RET0]]
+  return %0 : tensor<4xi32>
+}
@@ -1,4 +1,7 @@
 // RUN: iree-opt -split-input-file --iree-flow-convert-linalg-matmul-to-mmt4d=enable_generic_slow %s | FileCheck %s
+// RUN: iree-opt -split-input-file --iree-flow-convert-linalg-matmul-to-mmt4d='arch=riscv64 features=+v' %s | FileCheck %s --check-prefix=RISCV
+// RUN: iree-opt -split-input-file --iree-flow-convert-linalg-matmul-to-mmt4d='arch=aarch64 features=+bf16' %s | FileCheck %s --check-prefix=AARCH64-BF16
+// RUN: iree-opt -split-input-file --iree-flow-convert-linalg-matmul-to-mmt4d='arch=x86_64 features=+avx2,+avx512bf16' %s | FileCheck %s --check-prefix=X86-BF16
 
 func @check_mmt4d_f32_static_nopad(%arg0: tensor<24x8xf32>, %arg1: tensor<8x32xf32>, %arg2: tensor<24x32xf32>) -> tensor<24x32xf32> {
     %0 = linalg.matmul ins(%arg0, %arg1 : tensor<24x8xf32>, tensor<8x32xf32>) outs(%arg2 : tensor<24x32xf32>) -> tensor<24x32xf32>
@@ -128,3 +131,70 @@ func @check_mmt4d_i8_dynamic(%arg0: tensor<?x?xi8>, %arg1: tensor<?x?xi8>, %arg2
 //      CHECK: %[[RES:.+]] = tensor.extract_slice %[[RESPAD]][0, 0] [{{.*}}] [1, 1]
 // CHECK-SAME: tensor<?x?xi32> to tensor<?x?xi32>
 //      CEHCK: return %[[RES]] : tensor<?x?xi32>
+
+// -----
+func @check_mmt4d_accumulator_chain(%arg0: tensor<24x8xf32>, %arg1: tensor<8x32xf32>, %arg2: tensor<24x8xf32>, %arg3: tensor<8x32xf32>, %arg4: tensor<24x32xf32>) -> tensor<24x32xf32> {
+    %0 = linalg.matmul ins(%arg0, %arg1 : tensor<24x8xf32>, tensor<8x32xf32>) outs(%arg4 : tensor<24x32xf32>) -> tensor<24x32xf32>
+    %1 = linalg.matmul ins(%arg2, %arg3 : tensor<24x8xf32>, tensor<8x32xf32>) outs(%0 : tensor<24x32xf32>) -> tensor<24x32xf32>
+    return %1 : tensor<24x32xf32>
+}
+// The result of the first mmt4d is used as the accumulator of the second
+// without being unpacked and packed again.
+//  CHECK-LABEL: @check_mmt4d_accumulator_chain(
+//        CHECK: %[[MMT4D0:.+]] = linalg.mmt4d
+//   CHECK-SAME:   -> tensor<3x8x8x4xf32>
+//    CHECK-NOT: tensor.collapse_shape
+//        CHECK: %[[MMT4D1:.+]] = linalg.mmt4d
+//   CHECK-SAME:   outs(%[[MMT4D0]] : tensor<3x8x8x4xf32>)
+//        CHECK: %[[RESULT:.+]] = tensor.collapse_shape
+//        CHECK: return %[[RESULT]] : tensor<24x32xf32>
+
+// -----
+#map = affine_map<(d0, d1) -> (d0, d1)>
+func @check_mmt4d_elementwise_chain(%arg0: tensor<24x8xf32>, %arg1: tensor<8x32xf32>, %arg2: tensor<24x8xf32>, %arg3: tensor<8x32xf32>, %arg4: tensor<24x32xf32>) -> tensor<24x32xf32> {
+    %0 = linalg.matmul ins(%arg0, %arg1 : tensor<24x8xf32>, tensor<8x32xf32>) outs(%arg4 : tensor<24x32xf32>) -> tensor<24x32xf32>
+    %1 = linalg.init_tensor [24, 32] : tensor<24x32xf32>
+    %2 = linalg.generic {indexing_maps = [#map, #map, #map], iterator_types = ["parallel", "parallel"]} ins(%0, %0 : tensor<24x32xf32>, tensor<24x32xf32>) outs(%1 : tensor<24x32xf32>) {
+    ^bb0(%arg5: f32, %arg6: f32, %arg7: f32):
+      %4 = arith.mulf %arg5, %arg6 : f32
+      linalg.yield %4 : f32
+    } -> tensor<24x32xf32>
+    %3 = linalg.matmul ins(%arg2, %arg3 : tensor<24x8xf32>, tensor<8x32xf32>) outs(%2 : tensor<24x32xf32>) -> tensor<24x32xf32>
+    return %3 : tensor<24x32xf32>
+}
+// The elementwise op is applied in the tiled layout between the two mmt4ds.
+//  CHECK-LABEL: @check_mmt4d_elementwise_chain(
+//        CHECK: %[[MMT4D0:.+]] = linalg.mmt4d
+//        CHECK: %[[MUL:.+]] = linalg.generic
+//   CHECK-SAME:   ins(%[[MMT4D0]], %[[MMT4D0]] : tensor<3x8x8x4xf32>, tensor<3x8x8x4xf32>)
+//        CHECK:   arith.mulf
+//        CHECK: -> tensor<3x8x8x4xf32>
+//    CHECK-NOT: tensor.collapse_shape
+//        CHECK: %[[MMT4D1:.+]] = linalg.mmt4d
+//   CHECK-SAME:   outs(%[[MUL]] : tensor<3x8x8x4xf32>)
+//        CHECK: %[[RESULT:.+]] = tensor.collapse_shape
+//        CHECK: return %[[RESULT]] : tensor<24x32xf32>
+
+// -----
+func @check_mmt4d_f32_riscv_vector(%arg0: tensor<16x4xf32>, %arg1: tensor<4x16xf32>, %arg2: tensor<16x16xf32>) -> tensor<16x16xf32> {
+    %0 = linalg.matmul ins(%arg0, %arg1 : tensor<16x4xf32>, tensor<4x16xf32>) outs(%arg2 : tensor<16x16xf32>) -> tensor<16x16xf32>
+    return %0 : tensor<16x16xf32>
+}
+//      RISCV: @check_mmt4d_f32_riscv_vector
+//      RISCV: linalg.mmt4d
+// RISCV-SAME:    {comment = "f32*f32->f32, riscv64 +v"}
+// RISCV-SAME:    ins(%{{.+}}, %{{.+}} : tensor<2x4x8x1xf32>, tensor<2x4x8x1xf32>) outs(%{{.+}} : tensor<2x2x8x8xf32>) -> tensor<2x2x8x8xf32>
+
+// -----
+func @check_mmt4d_bf16(%arg0: tensor<16x8xbf16>, %arg1: tensor<8x16xbf16>, %arg2: tensor<16x16xf32>) -> tensor<16x16xf32> {
+    %0 = linalg.matmul ins(%arg0, %arg1 : tensor<16x8xbf16>, tensor<8x16xbf16>) outs(%arg2 : tensor<16x16xf32>) -> tensor<16x16xf32>
+    return %0 : tensor<16x16xf32>
+}
+//      AARCH64-BF16: @check_mmt4d_bf16
+//      AARCH64-BF16: linalg.mmt4d
+// AARCH64-BF16-SAME:    {comment = "bf16*bf16->f32, aarch64 +bf16"}
+// AARCH64-BF16-SAME:    ins(%{{.+}}, %{{.+}} : tensor<2x2x8x4xbf16>, tensor<2x2x8x4xbf16>) outs(%{{.+}} : tensor<2x2x8x8xf32>) -> tensor<2x2x8x8xf32>
+//          X86-BF16: @check_mmt4d_bf16
+//          X86-BF16: linalg.mmt4d
+//     X86-BF16-SAME:    {comment = "bf16*bf16->f32, x86_64 +avx512bf16"}
+//     X86-BF16-SAME:    ins(%{{.+}}, %{{.+}} : tensor<2x4x8x2xbf16>, tensor<2x4x8x2xbf16>) outs(%{{.+}} : tensor<2x2x8x8xf32>) -> tensor<2x2x8x8xf32>
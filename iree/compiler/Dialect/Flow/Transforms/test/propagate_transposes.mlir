@@ -0,0 +1,98 @@
+// RUN: iree-opt -split-input-file -iree-flow-propagate-transposes %s | FileCheck %s
+
+#map0 = affine_map<(d0, d1) -> (d1, d0)>
+#map1 = affine_map<(d0, d1) -> (d0, d1)>
+
+// CHECK-DAG: #[[MAP0:.+]] = affine_map<(d0, d1) -> (d1, d0)>
+// CHECK-DAG: #[[MAP1:.+]] = affine_map<(d0, d1) -> (d0, d1)>
+//     CHECK: func @foldIntoConsumers
+// CHECK-SAME:  (%[[ARG0:.+]]: tensor<4x8xf32>, %[[ARG1:.+]]: tensor<8x4xf32>)
+func @foldIntoConsumers(%arg0: tensor<4x8xf32>, %arg1: tensor<8x4xf32>) -> (tensor<8x4xf32>, tensor<8x4xf32>) {
+  %init = linalg.init_tensor [8, 4] : tensor<8x4xf32>
+  // CHECK-NOT: linalg.yield %{{.+}} : f32
+  %transpose = linalg.generic {indexing_maps = [#map0, #map1], iterator_types = ["parallel", "parallel"]}
+      ins(%arg0 : tensor<4x8xf32>) outs(%init : tensor<8x4xf32>) {
+  ^bb0(%in: f32, %out: f32):
+    linalg.yield %in : f32
+  } -> tensor<8x4xf32>
+  //      CHECK: linalg.generic
+  // CHECK-SAME:   indexing_maps = [#[[MAP0]], #[[MAP1]], #[[MAP1]]]
+  // CHECK-SAME:   ins(%[[ARG0]], %[[ARG1]] : tensor<4x8xf32>, tensor<8x4xf32>)
+  %add = linalg.generic {indexing_maps = [#map1, #map1, #map1], iterator_types = ["parallel", "parallel"]}
+      ins(%transpose, %arg1 : tensor<8x4xf32>, tensor<8x4xf32>) outs(%init : tensor<8x4xf32>) {
+  ^bb0(%lhs: f32, %rhs: f32, %out: f32):
+    %0 = arith.addf %lhs, %rhs : f32
+    linalg.yield %0 : f32
+  } -> tensor<8x4xf32>
+  //      CHECK: linalg.generic
+  // CHECK-SAME:   indexing_maps = [#[[MAP0]], #[[MAP1]]]
+  // CHECK-SAME:   ins(%[[ARG0]] : tensor<4x8xf32>)
+  %neg = linalg.generic {indexing_maps = [#map1, #map1], iterator_types = ["parallel", "parallel"]}
+      ins(%transpose : tensor<8x4xf32>) outs(%init : tensor<8x4xf32>) {
+  ^bb0(%in: f32, %out: f32):
+    %0 = arith.negf %in : f32
+    linalg.yield %0 : f32
+  } -> tensor<8x4xf32>
+  return %add, %neg : tensor<8x4xf32>, tensor<8x4xf32>
+}
+
+// -----
+
+#map0 = affine_map<(d0, d1, d2, d3) -> (d0, d3, d1, d2)>
+#map1 = affine_map<(d0, d1, d2, d3) -> (d0, d1, d2, d3)>
+#map2 = affine_map<(d0, d1, d2, d3) -> (d0, d2, d3, d1)>
+
+// CHECK-LABEL: func @cancelTransposePair
+//  CHECK-SAME:   (%[[ARG0:.+]]: tensor<1x2x3x4xf32>)
+func @cancelTransposePair(%arg0: tensor<1x2x3x4xf32>) -> tensor<1x2x3x4xf32> {
+  // NHWC -> NCHW
+  %init0 = linalg.init_tensor [1, 4, 2, 3] : tensor<1x4x2x3xf32>
+  %0 = linalg.generic {indexing_maps = [#map2, #map1], iterator_types = ["parallel", "parallel", "parallel", "parallel"]}
+      ins(%arg0 : tensor<1x2x3x4xf32>) outs(%init0 : tensor<1x4x2x3xf32>) {
+  ^bb0(%in: f32, %out: f32):
+    linalg.yield %in : f32
+  } -> tensor<1x4x2x3xf32>
+  // NCHW -> NHWC
+  %init1 = linalg.init_tensor [1, 2, 3, 4] : tensor<1x2x3x4xf32>
+  %1 = linalg.generic {indexing_maps = [#map0, #map1], iterator_types = ["parallel", "parallel", "parallel", "parallel"]}
+      ins(%0 : tensor<1x4x2x3xf32>) outs(%init1 : tensor<1x2x3x4xf32>) {
+  ^bb0(%in: f32, %out: f32):
+    linalg.yield %in : f32
+  } -> tensor<1x2x3x4xf32>
+  //  CHECK-NOT: linalg.generic
+  //      CHECK: return %[[ARG0]]
+  return %1 : tensor<1x2x3x4xf32>
+}
+
+// -----
+
+#map0 = affine_map<(d0, d1) -> (d1, d0)>
+#map1 = affine_map<(d0, d1) -> (d0, d1)>
+
+// CHECK-DAG: #[[MAP0:.+]] = affine_map<(d0, d1) -> (d0, d1)>
+// CHECK-DAG: #[[MAP1:.+]] = affine_map<(d0, d1) -> (d1, d0)>
+//     CHECK: func @foldIntoProducer
+// CHECK-SAME:  (%[[ARG0:.+]]: tensor<4x8xf32>)
+func @foldIntoProducer(%arg0: tensor<4x8xf32>) -> tensor<8x4xf32> {
+  %init0 = linalg.init_tensor [4, 8] : tensor<4x8xf32>
+  %0 = linalg.generic {indexing_maps = [#map1, #map1], iterator_types = ["parallel", "parallel"]}
+      ins(%arg0 : tensor<4x8xf32>) outs(%init0 : tensor<4x8xf32>) {
+  ^bb0(%in: f32, %out: f32):
+    %e = math.exp %in : f32
+    linalg.yield %e : f32
+  } -> tensor<4x8xf32>
+  //      CHECK: %[[INIT:.+]] = linalg.init_tensor [8, 4]
+  //      CHECK: %[[RESULT:.+]] = linalg.generic
+  // CHECK-SAME:   indexing_maps = [#[[MAP0]], #[[MAP1]]]
+  // CHECK-SAME:   ins(%[[ARG0]] : tensor<4x8xf32>) outs(%[[INIT]] : tensor<8x4xf32>)
+  //      CHECK:   math.exp
+  //  CHECK-NOT: linalg.generic
+  //      CHECK: return %[[RESULT]]
+  %init1 = linalg.init_tensor [8, 4] : tensor<8x4xf32>
+  %1 = linalg.generic {indexing_maps = [#map0, #map1], iterator_types = ["parallel", "parallel"]}
+      ins(%0 : tensor<4x8xf32>) outs(%init1 : tensor<8x4xf32>) {
+  ^bb0(%in: f32, %out: f32):
+    linalg.yield %in : f32
+  } -> tensor<8x4xf32>
+  return %1 : tensor<8x4xf32>
+}
@@ -92,6 +92,8 @@ void populateHALAllocatorToVMPatterns(MLIRContext *context,
                                       RewritePatternSet &patterns) {
   patterns.insert<VMImportOpConversion<IREE::HAL::AllocatorAllocateOp>>(
       context, importSymbols, typeConverter, "hal.allocator.allocate");
+  patterns.insert<VMImportOpConversion<IREE::HAL::AllocatorImportOp>>(
+      context, importSymbols, typeConverter, "hal.allocator.import");
   patterns.insert<AllocatorMapOpConversion>(typeConverter, context,
                                             importSymbols);
   patterns.insert<AllocatorTryMapOpConversion>(typeConverter, context,
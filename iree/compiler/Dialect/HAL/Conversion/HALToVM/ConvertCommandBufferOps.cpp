@@ -116,6 +116,65 @@ class CommandBufferPushDescriptorSetOpConversion
   mutable IREE::VM::ImportOp importOp;
 };
 
+class CommandBufferExecuteCommandsOpConversion
+    : public OpConversionPattern<IREE::HAL::CommandBufferExecuteCommandsOp> {
+ public:
+  CommandBufferExecuteCommandsOpConversion(MLIRContext *context,
+                                           SymbolTable &importSymbols,
+                                           TypeConverter &typeConverter,
+                                           StringRef importName)
+      : OpConversionPattern(typeConverter, context) {
+    importOp = importSymbols.lookup<IREE::VM::ImportOp>(importName);
+    assert(importOp);
+  }
+
+  LogicalResult matchAndRewrite(
+      IREE::HAL::CommandBufferExecuteCommandsOp op, OpAdaptor adaptor,
+      ConversionPatternRewriter &rewriter) const override {
+    auto importType = importOp.getType();
+    auto loc = op.getLoc();
+
+    // Gather the refs referenced by the command stream into a list so that the
+    // values can be passed as the single variadic segment of the import.
+    auto listType = IREE::VM::RefType::get(
+        IREE::VM::ListType::get(IREE::VM::OpaqueType::get(getContext())));
+    auto refCount = rewriter.create<IREE::VM::ConstI32Op>(
+        loc, rewriter.getI32IntegerAttr(adaptor.refs().size()));
+    auto refList =
+        rewriter.create<IREE::VM::ListAllocOp>(loc, listType, refCount);
+    rewriter.create<IREE::VM::ListResizeOp>(loc, refList, refCount);
+    for (auto ref : llvm::enumerate(adaptor.refs())) {
+      auto index = rewriter.create<IREE::VM::ConstI32Op>(
+          loc, rewriter.getI32IntegerAttr(ref.index()));
+      rewriter.create<IREE::VM::ListSetRefOp>(loc, refList, index,
+                                              ref.value());
+    }
+
+    SmallVector<Value, 8> callOperands = {
+        adaptor.command_buffer(),
+        adaptor.commands(),
+        refList,
+    };
+    SmallVector<int16_t, 4> segmentSizes = {
+        /*command_buffer=*/-1,
+        /*commands=*/-1,
+        /*refs=*/-1,
+        /*values=*/
+        static_cast<int16_t>(adaptor.values().size()),
+    };
+    llvm::append_range(callOperands, adaptor.values());
+
+    auto callOp = rewriter.replaceOpWithNewOp<IREE::VM::CallVariadicOp>(
+        op, SymbolRefAttr::get(importOp), importType.getResults(), segmentSizes,
+        importType.getInputs(), callOperands);
+    copyImportAttrs(importOp, callOp);
+    return success();
+  }
+
+ private:
+  mutable IREE::VM::ImportOp importOp;
+};
+
 }  // namespace
 
 void populateHALCommandBufferToVMPatterns(MLIRContext *context,
@@ -161,6 +220,9 @@ void populateHALCommandBufferToVMPatterns(MLIRContext *context,
       .insert<VMImportOpConversion<IREE::HAL::CommandBufferDispatchIndirectOp>>(
           context, importSymbols, typeConverter,
           "hal.command_buffer.dispatch.indirect");
+  patterns.insert<CommandBufferExecuteCommandsOpConversion>(
+      context, importSymbols, typeConverter,
+      "hal.command_buffer.execute_commands");
 }
 
 }  // namespace iree_compiler
@@ -10,6 +10,16 @@ func @allocatorAllocate(%arg0 : !hal.allocator) -> !hal.buffer {
 
 // -----
 
+// CHECK-LABEL: vm.func private @allocatorImport
+func @allocatorImport(%arg0 : !hal.allocator, %arg1 : !hal.buffer) -> !hal.buffer {
+  %length = arith.constant 256 : index
+  // CHECK: = vm.call @hal.allocator.import(%arg0, %arg1, %{{.+}}, %c256, %{{.+}}, %{{.+}}) : (!vm.ref<!hal.allocator>, !vm.ref<!hal.buffer>, !vm.buffer, i32, i32, i32) -> !vm.ref<!hal.buffer>
+  %buffer = hal.allocator.import<%arg0 : !hal.allocator> source(%arg1 : !hal.buffer) message("tensor") minimum_length(%length) type(DeviceLocal) usage(Dispatch) : !hal.buffer
+  return %buffer : !hal.buffer
+}
+
+// -----
+
 // CHECK-LABEL: vm.func private @allocatorMapByteBuffer
 func @allocatorMapByteBuffer(%arg0 : !hal.allocator, %arg1 : !util.byte_buffer) -> !hal.buffer {
   %offset = arith.constant 128 : index
@@ -161,3 +161,26 @@ func @command_buffer_dispatch_indirect(
       workgroups(%arg2 : !hal.buffer)[%c100]
   return
 }
+
+// -----
+
+// CHECK-LABEL: @command_buffer_execute_commands
+func @command_buffer_execute_commands(
+  %arg0: !hal.command_buffer,
+  %arg1: !hal.executable_layout,
+  %arg2: !hal.executable,
+  %arg3: i32
+) {
+  // CHECK: %[[COMMANDS:.+]] = vm.rodata.inline
+  %commands = util.byte_buffer.constant {alignment = 4 : i64} : !util.byte_buffer = dense<[772, 0, 0, 42, 1286, 1, 0, -2147483648, 1, 1]> : vector<10xi32>
+  // CHECK: %[[REFS:.+]] = vm.list.alloc %c2 : (i32) -> !vm.list<?>
+  // CHECK: vm.list.resize %[[REFS]], %c2
+  // CHECK: vm.list.set.ref %[[REFS]], %zero, %arg1
+  // CHECK: vm.list.set.ref %[[REFS]], %c1, %arg2
+  // CHECK: vm.call.variadic @hal.command_buffer.execute_commands(%arg0, %[[COMMANDS]], %[[REFS]], [%arg3]) : (!vm.ref<!hal.command_buffer>, !vm.buffer, !vm.list<?>, i32 ...)
+  hal.command_buffer.execute_commands<%arg0 : !hal.command_buffer>
+      commands(%commands : !util.byte_buffer)
+      refs([%arg1, %arg2 : !hal.executable_layout, !hal.executable])
+      values([%arg3]) : i32
+  return
+}
@@ -14,7 +14,9 @@
 #include "iree/compiler/Dialect/Stream/IR/StreamOps.h"
 #include "iree/compiler/Dialect/Stream/IR/StreamTypes.h"
 #include "iree/compiler/Dialect/Util/IR/UtilOps.h"
+#include "llvm/ADT/TypeSwitch.h"
 #include "mlir/Dialect/StandardOps/IR/Ops.h"
+#include "mlir/IR/Matchers.h"
 #include "mlir/Transforms/DialectConversion.h"
 
 namespace mlir {
@@ -415,12 +417,12 @@ struct ResourceSubviewOpPattern
   }
 };
 
-// Inserts IR to assert that the underlying buffer storage is compatible with
-// the intended usage in the program. The allocator used to allocate the
-// buffer must have compatibility with our target device allocator and the
+// Inserts IR to import the underlying buffer storage for the intended usage in
+// the program. Buffers compatible with our target device allocator are used
+// directly and others are copied into a compatible allocation at runtime. The
 // buffer must have at least the minimum expected size (additional padding is
 // ok).
-static LogicalResult buildStorageAssertions(
+static FailureOr<Value> buildStorageImport(
     Location loc, Value buffer, StringAttr message, Value allocator,
     Value minimumLength, IREE::Stream::ResourceType resourceType,
     OpBuilder &builder) {
@@ -436,10 +438,11 @@ static LogicalResult buildStorageAssertions(
   auto requiredUsage = IREE::HAL::BufferUsageBitfieldAttr::get(
       builder.getContext(), bufferUsage);
 
-  builder.create<IREE::HAL::BufferAssertOp>(loc, buffer, message, allocator,
-                                            minimumLength, requiredTypes,
-                                            requiredUsage);
-  return success();
+  return builder
+      .create<IREE::HAL::AllocatorImportOp>(
+          loc, builder.getType<IREE::HAL::BufferType>(), allocator, buffer,
+          message, minimumLength, requiredTypes, requiredUsage)
+      .result();
 }
 
 struct TensorImportBufferOpPattern
@@ -455,19 +458,17 @@ struct TensorImportBufferOpPattern
     // TODO(benvanik): get a name for the tensor (argument name/etc).
     auto message = rewriter.getStringAttr("tensor");
 
-    // Directly use the buffer.
-    auto buffer = adaptor.source();
-    rewriter.replaceOp(importOp, buffer);
-
-    // Assert the storage is compatible with our expected device and usage.
+    // Import the storage for use with our expected device and usage. This
+    // directly uses the buffer when it is compatible.
     auto targetAllocator = lookupAllocatorFor(importOp, rewriter);
     auto resourceType =
         importOp.result().getType().cast<IREE::Stream::ResourceType>();
-    if (failed(buildStorageAssertions(
-            importOp.getLoc(), adaptor.source(), message, targetAllocator,
-            adaptor.result_size(), resourceType, rewriter))) {
-      return failure();
-    }
+    auto buffer = buildStorageImport(importOp.getLoc(), adaptor.source(),
+                                     message, targetAllocator,
+                                     adaptor.result_size(), resourceType,
+                                     rewriter);
+    if (failed(buffer)) return failure();
+    rewriter.replaceOp(importOp, *buffer);
 
     return success();
   }
@@ -492,18 +493,19 @@ struct TensorImportBufferViewOpPattern
 
     auto bufferView = adaptor.source();
     auto bufferType = rewriter.getType<IREE::HAL::BufferType>();
-    auto bufferOp = rewriter.replaceOpWithNewOp<IREE::HAL::BufferViewBufferOp>(
-        importOp, bufferType, bufferView);
+    auto bufferOp = rewriter.create<IREE::HAL::BufferViewBufferOp>(
+        loc, bufferType, bufferView);
 
-    // Assert the storage is compatible with our expected device and usage.
+    // Import the storage for use with our expected device and usage. This
+    // directly uses the buffer when it is compatible.
     auto targetAllocator = lookupAllocatorFor(importOp, rewriter);
     auto resourceType =
         importOp.result().getType().cast<IREE::Stream::ResourceType>();
-    if (failed(buildStorageAssertions(loc, bufferOp.result(), message,
-                                      targetAllocator, adaptor.result_size(),
-                                      resourceType, rewriter))) {
-      return failure();
-    }
+    auto buffer = buildStorageImport(loc, bufferOp.result(), message,
+                                     targetAllocator, adaptor.result_size(),
+                                     resourceType, rewriter);
+    if (failed(buffer)) return failure();
+    rewriter.replaceOp(importOp, *buffer);
 
     return success();
   }
@@ -878,6 +880,129 @@ struct CmdDispatchOpPattern
   }
 };
 
+namespace {
+
+// A byte range of a resource accessed by a stream command.
+struct ResourceAccessRange {
+  Value resource;
+  Value offset;
+  Value length;
+  bool isWrite;
+};
+
+}  // namespace
+
+// Appends the resource ranges accessed by |op| and any ops nested within it
+// to |ranges|. Returns false if the accesses of |op| are unknown.
+static bool gatherResourceAccesses(
+    Operation *op, SmallVectorImpl<ResourceAccessRange> &ranges) {
+  return TypeSwitch<Operation *, bool>(op)
+      .Case([&](IREE::Stream::CmdFlushOp op) {
+        ranges.push_back({op.target(), op.target_offset(), op.target_length(),
+                          /*isWrite=*/true});
+        return true;
+      })
+      .Case([&](IREE::Stream::CmdInvalidateOp op) {
+        ranges.push_back({op.target(), op.target_offset(), op.target_length(),
+                          /*isWrite=*/true});
+        return true;
+      })
+      .Case([&](IREE::Stream::CmdDiscardOp op) {
+        ranges.push_back({op.target(), op.target_offset(), op.target_length(),
+                          /*isWrite=*/true});
+        return true;
+      })
+      .Case([&](IREE::Stream::CmdFillOp op) {
+        ranges.push_back({op.target(), op.target_offset(), op.target_length(),
+                          /*isWrite=*/true});
+        return true;
+      })
+      .Case([&](IREE::Stream::CmdCopyOp op) {
+        ranges.push_back(
+            {op.source(), op.source_offset(), op.length(), /*isWrite=*/false});
+        ranges.push_back(
+            {op.target(), op.target_offset(), op.length(), /*isWrite=*/true});
+        return true;
+      })
+      .Case([&](IREE::Stream::CmdDispatchOp op) {
+        for (unsigned i = 0; i < op.resources().size(); ++i) {
+          auto access = op.resource_accesses()[i]
+                            .cast<IREE::Stream::ResourceAccessBitfieldAttr>()
+                            .getValue();
+          ranges.push_back(
+              {op.resources()[i], op.resource_offsets()[i],
+               op.resource_lengths()[i],
+               bitEnumContains(access,
+                               IREE::Stream::ResourceAccessBitfield::Write)});
+        }
+        return true;
+      })
+      .Case<IREE::Stream::CmdSerialOp, IREE::Stream::CmdConcurrentOp>(
+          [&](Operation *op) {
+            for (auto &nestedOp : op->getRegion(0).front()) {
+              if (nestedOp.hasTrait<OpTrait::IsTerminator>()) continue;
+              if (!gatherResourceAccesses(&nestedOp, ranges)) return false;
+            }
+            return true;
+          })
+      .Default([](Operation *op) { return false; });
+}
+
+// Returns the resource captured by the execution region argument |value| or
+// |value| if it is not a capture.
+static Value getCapturedResource(Value value) {
+  auto arg = value.dyn_cast<BlockArgument>();
+  if (!arg) return value;
+  auto executeOp = dyn_cast_or_null<IREE::Stream::CmdExecuteOp>(
+      arg.getOwner()->getParentOp());
+  if (!executeOp) return value;
+  return executeOp.operands()[arg.getArgNumber()];
+}
+
+// Returns true if |value| is known to be an allocation that does not alias
+// any other resource.
+static bool isUniqueAllocation(Value value) {
+  return isa_and_nonnull<IREE::Stream::ResourceAllocOp,
+                         IREE::Stream::ResourceAllocaOp,
+                         IREE::HAL::AllocatorAllocateOp>(value.getDefiningOp());
+}
+
+// Returns true if the |lhs| and |rhs| ranges may refer to the same memory.
+static bool mayOverlap(const ResourceAccessRange &lhs,
+                       const ResourceAccessRange &rhs) {
+  Value lhsResource = getCapturedResource(lhs.resource);
+  Value rhsResource = getCapturedResource(rhs.resource);
+  if (lhsResource != rhsResource) {
+    return !isUniqueAllocation(lhsResource) ||
+           !isUniqueAllocation(rhsResource);
+  }
+  APInt lhsOffset, lhsLength, rhsOffset, rhsLength;
+  if (!matchPattern(lhs.offset, m_ConstantInt(&lhsOffset)) ||
+      !matchPattern(lhs.length, m_ConstantInt(&lhsLength)) ||
+      !matchPattern(rhs.offset, m_ConstantInt(&rhsOffset)) ||
+      !matchPattern(rhs.length, m_ConstantInt(&rhsLength))) {
+    return true;
+  }
+  int64_t lhsBegin = lhsOffset.getSExtValue();
+  int64_t lhsEnd = lhsBegin + lhsLength.getSExtValue();
+  int64_t rhsBegin = rhsOffset.getSExtValue();
+  int64_t rhsEnd = rhsBegin + rhsLength.getSExtValue();
+  return lhsBegin < rhsEnd && rhsBegin < lhsEnd;
+}
+
+// Returns true if any access in |before| conflicts with any access in |after|
+// (read-after-write, write-after-read, or write-after-write).
+static bool hasHazard(ArrayRef<ResourceAccessRange> before,
+                      ArrayRef<ResourceAccessRange> after) {
+  for (auto &beforeRange : before) {
+    for (auto &afterRange : after) {
+      if (!beforeRange.isWrite && !afterRange.isWrite) continue;
+      if (mayOverlap(beforeRange, afterRange)) return true;
+    }
+  }
+  return false;
+}
+
 static void insertSerializationBarriers(Location loc, Block &block,
                                         Value commandBuffer,
                                         OpBuilder builder) {
@@ -892,14 +1017,36 @@ static void insertSerializationBarriers(Location loc, Block &block,
                      IREE::HAL::ExecutionStageBitfield::Dispatch;
   auto flags = IREE::HAL::ExecutionBarrierFlagBitfield::None;
 
-  // Insert barriers after every op.
+  // Insert barriers between ops only where they have a hazard on the resource
+  // ranges they access; ops touching independent ranges since the last barrier
+  // are allowed to execute concurrently. Ops with unknown accesses are always
+  // fenced. A trailing barrier is kept after the last op.
   // Note that we can't mutate the block while iterating it so we first grab
   // all the original ops.
   SmallVector<Operation *> serialOps;
-  for (auto &op : block) serialOps.push_back(&op);
-  for (auto *op : serialOps) {
-    if (op->hasTrait<OpTrait::IsTerminator>()) continue;
-    builder.setInsertionPointAfter(op);
+  for (auto &op : block) {
+    if (op.hasTrait<OpTrait::IsTerminator>()) continue;
+    serialOps.push_back(&op);
+  }
+  SmallVector<ResourceAccessRange> pendingRanges;
+  bool isPendingKnown = true;
+  for (auto it : llvm::enumerate(serialOps)) {
+    Operation *op = it.value();
+    SmallVector<ResourceAccessRange> opRanges;
+    bool isOpKnown = gatherResourceAccesses(op, opRanges);
+    if (it.index() > 0 &&
+        (!isPendingKnown || !isOpKnown || hasHazard(pendingRanges, opRanges))) {
+      builder.setInsertionPointAfter(serialOps[it.index() - 1]);
+      builder.create<IREE::HAL::CommandBufferExecutionBarrierOp>(
+          loc, commandBuffer, sourceStage, targetStage, flags);
+      pendingRanges.clear();
+      isPendingKnown = true;
+    }
+    pendingRanges.append(opRanges.begin(), opRanges.end());
+    isPendingKnown = isPendingKnown && isOpKnown;
+  }
+  if (!serialOps.empty()) {
+    builder.setInsertionPointAfter(serialOps.back());
     builder.create<IREE::HAL::CommandBufferExecutionBarrierOp>(
         loc, commandBuffer, sourceStage, targetStage, flags);
   }
@@ -5,3 +5,32 @@
 func @todo() {
   return
 }
+
+// -----
+
+// Tests that barriers are only inserted between commands with hazards on the
+// resource ranges they access.
+
+// CHECK-LABEL: @cmdExecuteBarriers
+func @cmdExecuteBarriers(%arg0: !stream.resource<transient>, %arg1: index) -> !stream.timepoint {
+  %c0 = arith.constant 0 : index
+  %c128 = arith.constant 128 : index
+  %c256 = arith.constant 256 : index
+  %c255_i32 = arith.constant 255 : i32
+  // CHECK: hal.command_buffer.begin
+  %0 = stream.cmd.execute with(%arg0 as %arg2: !stream.resource<transient>{%arg1}) {
+    stream.cmd.serial {
+      // CHECK-NEXT: hal.command_buffer.fill_buffer
+      stream.cmd.fill %c255_i32, %arg2[%c0 for %c128] : i32 -> !stream.resource<transient>{%arg1}
+      // Writes a disjoint range and needs no barrier.
+      // CHECK-NEXT: hal.command_buffer.fill_buffer
+      stream.cmd.fill %c255_i32, %arg2[%c128 for %c128] : i32 -> !stream.resource<transient>{%arg1}
+      // Reads the range written by the first fill.
+      // CHECK-NEXT: hal.command_buffer.execution_barrier
+      // CHECK-NEXT: hal.command_buffer.copy_buffer
+      stream.cmd.copy %arg2[%c0], %arg2[%c256], %c128 : !stream.resource<transient>{%arg1} -> !stream.resource<transient>{%arg1}
+      // CHECK-NEXT: hal.command_buffer.execution_barrier
+    }
+  } => !stream.timepoint
+  return %0 : !stream.timepoint
+}
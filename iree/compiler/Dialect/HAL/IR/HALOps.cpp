@@ -312,6 +312,15 @@ Value AllocatorAllocateOp::getOperandSize(unsigned idx) { return {}; }
 
 Value AllocatorAllocateOp::getResultSize(unsigned idx) { return result_size(); }
 
+//===----------------------------------------------------------------------===//
+// hal.allocator.import
+//===----------------------------------------------------------------------===//
+
+void AllocatorImportOp::getAsmResultNames(
+    function_ref<void(Value, StringRef)> setNameFn) {
+  setNameFn(result(), "imported");
+}
+
 //===----------------------------------------------------------------------===//
 // hal.allocator.map
 //===----------------------------------------------------------------------===//
@@ -16,6 +16,28 @@ func @allocator_allocate(%allocator: !hal.allocator) {
 
 // -----
 
+// CHECK-LABEL: @allocator_import
+//  CHECK-SAME: (%[[ALLOCATOR:.+]]: !hal.allocator, %[[SOURCE:.+]]: !hal.buffer)
+func @allocator_import(%allocator: !hal.allocator, %source: !hal.buffer) {
+  // CHECK-DAG: %[[LENGTH:.+]] = arith.constant 123
+  %length = arith.constant 123 : index
+  //      CHECK: = hal.allocator.import<%[[ALLOCATOR]] : !hal.allocator>
+  // CHECK-SAME:   source(%[[SOURCE]] : !hal.buffer)
+  // CHECK-SAME:   message("tensor")
+  // CHECK-SAME:   minimum_length(%[[LENGTH]])
+  // CHECK-SAME:   type("DeviceVisible|DeviceLocal")
+  // CHECK-SAME:   usage(Dispatch)
+  // CHECK-SAME:   : !hal.buffer
+  %ref = hal.allocator.import<%allocator : !hal.allocator>
+                    source(%source : !hal.buffer)
+                    message("tensor")
+                    minimum_length(%length)
+                    type(DeviceLocal) usage(Dispatch) : !hal.buffer
+  return
+}
+
+// -----
+
 // CHECK-LABEL: @allocator_map_byte_buffer
 //  CHECK-SAME: %[[ALLOCATOR:.+]]: !hal.allocator
 func @allocator_map_byte_buffer(%allocator: !hal.allocator, %arg1: !util.byte_buffer) {
@@ -213,6 +213,7 @@ class CUDATargetBackend final : public TargetBackend {
     }
     std::vector<std::array<int32_t, 3>> workgroupSizes;
     std::vector<std::string> entryPointNames;
+    std::vector<DispatchCost> dispatchCosts;
     for (auto func : innerModuleOp.getOps<LLVM::LLVMFuncOp>()) {
       auto *llvmFunc = llvmModule->getFunction(func.getName());
       if (llvmFunc->isDeclaration()) continue;
@@ -230,6 +231,7 @@ class CUDATargetBackend final : public TargetBackend {
         workgroup_size = {1, 1, 1};
       }
       workgroupSizes.push_back(workgroup_size);
+      dispatchCosts.push_back(getDispatchCost(entryPointOp));
       llvm::Metadata *llvmMetadata[] = {
           llvm::ValueAsMetadata::get(llvmFunc),
           llvm::MDString::get(llvmModule->getContext(), "kernel"),
@@ -287,9 +289,27 @@ class CUDATargetBackend final : public TargetBackend {
     }
     auto blockSizesRef = iree_CUDABlockSizeDef_vec_end(builder);
 
+    // Compiler-estimated costs are only emitted if known for any entry point.
+    iree_CUDADispatchCostDef_vec_ref_t dispatchCostsRef = 0;
+    if (llvm::any_of(dispatchCosts, [](const DispatchCost &cost) {
+          return !cost.isDefault();
+        })) {
+      iree_CUDADispatchCostDef_vec_start(builder);
+      for (const DispatchCost &cost : dispatchCosts) {
+        iree_CUDADispatchCostDef_vec_push_create(
+            builder, cost.flopCount, cost.readByteCount, cost.writeByteCount,
+            static_cast<uint32_t>(
+                std::min<int64_t>(cost.workgroupCount, UINT32_MAX)));
+      }
+      dispatchCostsRef = iree_CUDADispatchCostDef_vec_end(builder);
+    }
+
     iree_CUDAExecutableDef_entry_points_add(builder, entryPointsRef);
     iree_CUDAExecutableDef_block_sizes_add(builder, blockSizesRef);
     iree_CUDAExecutableDef_ptx_image_add(builder, ptxCudeRef);
+    if (dispatchCostsRef) {
+      iree_CUDAExecutableDef_dispatch_costs_add(builder, dispatchCostsRef);
+    }
     iree_CUDAExecutableDef_end_as_root(builder);
 
     // Add the binary data to the target executable.
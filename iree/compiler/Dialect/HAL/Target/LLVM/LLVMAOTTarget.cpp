@@ -17,13 +17,23 @@
 #include "iree/compiler/Dialect/HAL/Target/LLVM/LinkerTool.h"
 #include "iree/compiler/Dialect/HAL/Target/LLVM/StaticLibraryGenerator.h"
 #include "iree/compiler/Dialect/HAL/Target/TargetRegistry.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/Bitcode/BitcodeReader.h"
 #include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/Linker/Linker.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/FileUtilities.h"
 #include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/SHA1.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/ValueMapper.h"
 #include "mlir/Dialect/ArmNeon/ArmNeonDialect.h"
 #include "mlir/Dialect/LLVMIR/LLVMDialect.h"
 #include "mlir/Target/LLVMIR/Dialect/LLVMIR/LLVMToLLVMIRTranslation.h"
@@ -39,6 +49,11 @@ namespace HAL {
 static constexpr char kQueryFunctionName[] =
     "iree_hal_executable_library_query";
 
+// Must match IREE_HAL_EXECUTABLE_LIBRARY_PROFILE_WRITE_NAME in
+// iree/hal/local/executable_library.h.
+static constexpr char kProfileWriteFunctionName[] =
+    "iree_hal_executable_library_write_profile";
+
 static llvm::Optional<FileLineColLoc> findFirstFileLoc(Location baseLoc) {
   if (auto loc = baseLoc.dyn_cast<FusedLoc>()) {
     for (auto &childLoc : loc.getLocations()) {
@@ -51,6 +66,69 @@ static llvm::Optional<FileLineColLoc> findFirstFileLoc(Location baseLoc) {
   return llvm::None;
 }
 
+// Returns the mask of IREE_HAL_PROCESSOR_DATA0_* bits the runtime must report
+// for code compiled with the LLVM |tierFeatures| (such as `+avx2,+fma`) to run.
+static FailureOr<uint64_t> getFeatureTierMask(Location loc,
+                                              llvm::Triple::ArchType arch,
+                                              StringRef tierFeatures) {
+  SmallVector<StringRef> features;
+  tierFeatures.split(features, ',', /*MaxSplit=*/-1, /*KeepEmpty=*/false);
+  uint64_t mask = 0;
+  for (auto feature : features) {
+    feature = feature.trim();
+    // Disabled features don't need to be checked.
+    if (feature.consume_front("-")) continue;
+    feature.consume_front("+");
+    auto bit = LibraryBuilder::getProcessorData0Bit(arch, feature);
+    if (!bit) {
+      mlir::emitError(loc) << "CPU feature '" << feature << "' of tier '"
+                           << tierFeatures
+                           << "' cannot be queried at runtime on "
+                           << llvm::Triple::getArchTypeName(arch);
+      return failure();
+    }
+    mask |= *bit;
+  }
+  if (!mask) {
+    mlir::emitError(loc) << "CPU feature tier '" << tierFeatures
+                         << "' does not enable any features";
+    return failure();
+  }
+  return mask;
+}
+
+// Clones all functions defined in |module| with |nameSuffix| appended to their
+// names and compiled with |targetFeatures|. Calls between the functions are
+// redirected to their clones so that the tier is self-contained.
+// |clonedValues| will contain the mapping from the original functions.
+static void cloneFunctionsForFeatureTier(
+    llvm::Module *module, StringRef nameSuffix, StringRef targetFeatures,
+    llvm::ValueToValueMapTy &clonedValues) {
+  SmallVector<llvm::Function *> sourceFuncs;
+  for (auto &func : *module) {
+    if (!func.isDeclaration()) sourceFuncs.push_back(&func);
+  }
+  // All clones must exist prior to cloning bodies so that calls are remapped.
+  for (auto *func : sourceFuncs) {
+    clonedValues[func] = llvm::Function::Create(
+        func->getFunctionType(), func->getLinkage(), func->getAddressSpace(),
+        func->getName() + nameSuffix, module);
+  }
+  for (auto *func : sourceFuncs) {
+    auto *clonedFunc = cast<llvm::Function>(clonedValues[func]);
+    auto clonedArg = clonedFunc->arg_begin();
+    for (auto &arg : func->args()) {
+      clonedArg->setName(arg.getName());
+      clonedValues[&arg] = &*clonedArg++;
+    }
+    SmallVector<llvm::ReturnInst *> returns;
+    llvm::CloneFunctionInto(clonedFunc, func, clonedValues,
+                            llvm::CloneFunctionChangeType::LocalChangesOnly,
+                            returns);
+    clonedFunc->addFnAttr("target-features", targetFeatures);
+  }
+}
+
 static std::string guessModuleName(mlir::ModuleOp moduleOp) {
   std::string moduleName =
       moduleOp.getName().hasValue() ? moduleOp.getName().getValue().str() : "";
@@ -101,6 +179,80 @@ static LogicalResult appendDebugDatabase(std::vector<int8_t> &baseFile,
   return success();
 }
 
+// Appends the |options| that influence code generation to |os|.
+static void appendOptionsCacheKey(llvm::raw_ostream &os,
+                                  const LLVMTargetOptions &options) {
+  os << options.targetTriple << ";" << options.targetCPU << ";"
+     << options.targetCPUFeatures << ";";
+  for (auto &tier : options.targetCPUFeatureTiers) os << tier << ";";
+  for (auto tier : options.targetL2CacheTiers) os << tier << "k;";
+  os << options.sveVectorBits << ";";
+  os << options.debugSymbols << ";" << static_cast<int>(options.sanitizerKind)
+     << ";" << options.linkEmbedded << ";" << options.linkerPath << ";"
+     << options.embeddedLinkerPath << ";"
+     << options.pipelineTuningOptions.MergeFunctions << ";";
+  os << options.pgoInstrumentProfileFile << ";" << options.pgoRuntimeLibrary
+     << ";";
+}
+
+// Returns the path of the executable cache entry for |variantOp| when
+// compiled with |options| or an empty string if caching is disabled.
+// The key covers the variant IR (and its locations when they are embedded as
+// debug info), the options that influence code generation, and the LLVM
+// version.
+static std::string getExecutableCachePath(
+    IREE::HAL::ExecutableVariantOp variantOp,
+    const LLVMTargetOptions &options) {
+  if (options.executableCacheDir.empty() || options.linkStatic) return {};
+  std::string key;
+  llvm::raw_string_ostream os(key);
+  os << "iree-llvm-v1;" << LLVM_VERSION_STRING << ";";
+  appendOptionsCacheKey(os, options);
+  if (!options.pgoProfile.empty()) {
+    // Executables are only reusable with the same profile contents.
+    auto profileFile = llvm::MemoryBuffer::getFile(
+        options.pgoProfile, /*IsText=*/false, /*RequiresNullTerminator=*/false);
+    if (!profileFile) return {};
+    os << llvm::toHex(llvm::SHA1::hash(llvm::arrayRefFromStringRef(
+              (*profileFile)->getBuffer())))
+       << ";";
+  }
+  os << "\n";
+  // Printing in a local scope avoids walking the parent module that other
+  // threads may be concurrently modifying.
+  OpPrintingFlags flags;
+  flags.useLocalScope();
+  if (options.debugSymbols) flags.enableDebugInfo();
+  os << variantOp->getParentOfType<IREE::HAL::ExecutableOp>().getName()
+     << "\n";
+  variantOp->print(os, flags);
+  os.flush();
+  auto hash = llvm::SHA1::hash(llvm::arrayRefFromStringRef(key));
+  SmallString<256> path(options.executableCacheDir);
+  llvm::sys::path::append(path, llvm::toHex(hash, /*LowerCase=*/true) + ".bin");
+  return path.str().str();
+}
+
+// Creates the exported function that the runtime calls to write the raw
+// profile of an executable instrumented for profile-guided optimization prior
+// to unloading it. The LLVM profile runtime linked into the library is not
+// initialized by its own static constructors as libraries do not link the CRT.
+static llvm::Function *createProfileWriteFunction(llvm::Module &module) {
+  auto &context = module.getContext();
+  auto *i32Type = llvm::Type::getInt32Ty(context);
+  auto initializeFn = module.getOrInsertFunction(
+      "__llvm_profile_initialize_file", llvm::Type::getVoidTy(context));
+  auto writeFn = module.getOrInsertFunction("__llvm_profile_write_file",
+                                            i32Type);
+  auto *func = llvm::Function::Create(
+      llvm::FunctionType::get(i32Type, /*isVarArg=*/false),
+      llvm::GlobalValue::ExternalLinkage, kProfileWriteFunctionName, module);
+  llvm::IRBuilder<> builder(llvm::BasicBlock::Create(context, "entry", func));
+  builder.CreateCall(initializeFn);
+  builder.CreateRet(builder.CreateCall(writeFn));
+  return func;
+}
+
 // Verifies builtin bitcode is loaded correctly and appends it to |linker|.
 //
 // Example:
@@ -131,6 +283,54 @@ static LogicalResult linkBuiltinLibrary(
   return success();
 }
 
+// Returns the minimum vector register length in bytes guaranteed by the RISC-V
+// vector extension features in |cpuFeatures| or 0 if the vector extension is
+// not enabled. The V extension implies VLEN >= 128 and `+zvl<N>b` raises the
+// guaranteed minimum to N bits.
+static int64_t getRISCVMinVectorLengthInBytes(StringRef cpuFeatures) {
+  SmallVector<StringRef> features;
+  cpuFeatures.split(features, ',', /*MaxSplit=*/-1, /*KeepEmpty=*/false);
+  bool hasVector = false;
+  int64_t minVectorBits = 0;
+  for (auto feature : features) {
+    if (feature == "+v") {
+      hasVector = true;
+      minVectorBits = std::max<int64_t>(minVectorBits, 128);
+    }
+    int64_t vectorBits = 0;
+    if (feature.consume_front("+zvl") && feature.consume_back("b") &&
+        !feature.getAsInteger(10, vectorBits)) {
+      minVectorBits = std::max(minVectorBits, vectorBits);
+    }
+  }
+  return hasVector ? minVectorBits / 8 : 0;
+}
+
+// Returns the vscale used for all SVE code generated for |options| or 0 if
+// the SVE vector length is not fixed. Fails if the vector length is invalid
+// for the target.
+static FailureOr<unsigned> getSVEVectorScale(Location loc,
+                                             const LLVMTargetOptions &options) {
+  if (!options.sveVectorBits) return 0u;
+  SmallVector<StringRef> features;
+  StringRef(options.targetCPUFeatures)
+      .split(features, ',', /*MaxSplit=*/-1, /*KeepEmpty=*/false);
+  bool hasSVE = llvm::any_of(features, [](StringRef feature) {
+    return feature == "+sve" || feature == "+sve2";
+  });
+  if (!llvm::Triple(options.targetTriple).isAArch64() || !hasSVE) {
+    return mlir::emitError(loc) << "SVE vector length requires an aarch64 "
+                                   "target with the +sve CPU feature";
+  }
+  // SVE vector lengths are multiples of 128 bits up to 2048 bits.
+  if (options.sveVectorBits % 128 != 0 || options.sveVectorBits > 2048) {
+    return mlir::emitError(loc)
+           << "invalid SVE vector length " << options.sveVectorBits
+           << "; must be a multiple of 128 bits no larger than 2048";
+  }
+  return options.sveVectorBits / 128;
+}
+
 class LLVMAOTTargetBackend final : public TargetBackend {
  public:
   explicit LLVMAOTTargetBackend(LLVMTargetOptions options)
@@ -166,6 +366,10 @@ class LLVMAOTTargetBackend final : public TargetBackend {
     buildLLVMCPUCodegenPassPipeline(passManager);
   }
 
+  void appendCacheKey(llvm::raw_ostream &os) const override {
+    appendOptionsCacheKey(os, options_);
+  }
+
   LogicalResult linkExecutables(mlir::ModuleOp moduleOp) override {
     OpBuilder builder = OpBuilder::atBlockBegin(moduleOp.getBody());
 
@@ -219,6 +423,42 @@ class LLVMAOTTargetBackend final : public TargetBackend {
       return variantOp.emitError()
              << "cannot embed ELF and produce static library simultaneously";
     }
+    bool pgoInstrument = !options_.pgoInstrumentProfileFile.empty();
+    if (pgoInstrument) {
+      // The profile runtime depends on libc and is linked into the library.
+      if (options_.linkEmbedded || options_.linkStatic ||
+          !llvm::Triple(options_.targetTriple).isOSLinux()) {
+        return variantOp.emitError()
+               << "profile-guided optimization instrumentation requires "
+                  "system libraries (-iree-llvm-link-embedded=false) "
+                  "targeting Linux";
+      }
+      if (options_.pgoRuntimeLibrary.empty()) {
+        return variantOp.emitError()
+               << "profile-guided optimization instrumentation requires the "
+                  "LLVM profile runtime (-iree-llvm-pgo-runtime-library)";
+      }
+    } else if (!options_.pgoProfile.empty() &&
+               !llvm::sys::fs::exists(options_.pgoProfile)) {
+      return variantOp.emitError()
+             << "profile '" << options_.pgoProfile << "' not found";
+    }
+
+    // Reuse the binary produced by a prior compilation of the same variant.
+    // This must happen prior to any mutation of the variant below.
+    std::string cachePath = getExecutableCachePath(variantOp, options_);
+    if (!cachePath.empty()) {
+      if (auto cachedFile = llvm::MemoryBuffer::getFile(
+              cachePath, /*IsText=*/false, /*RequiresNullTerminator=*/false)) {
+        LLVM_DEBUG(llvm::dbgs() << "reusing cached executable " << cachePath
+                                << " for " << libraryName << "\n");
+        StringRef contents = (*cachedFile)->getBuffer();
+        addDynamicLibraryBinary(
+            variantOp, executableBuilder,
+            std::vector<int8_t>(contents.begin(), contents.end()));
+        return success();
+      }
+    }
 
     // Specialize the module to the target triple.
     // The executable will have been cloned into other ExecutableVariantOps for
@@ -228,6 +468,22 @@ class LLVMAOTTargetBackend final : public TargetBackend {
         LLVM::LLVMDialect::getTargetTripleAttrName(),
         executableBuilder.getStringAttr(targetTriple.str()));
 
+    // Imports resolved by the runtime loader, in ordinal order. The attribute
+    // is not understood by the LLVM IR translation and is removed here.
+    SmallVector<StringRef> importNames;
+    if (auto importsAttr = variantOp.getInnerModule()->getAttrOfType<ArrayAttr>(
+            "hal.executable.imports")) {
+      for (auto nameAttr : importsAttr.getAsRange<StringAttr>()) {
+        importNames.push_back(nameAttr.getValue());
+      }
+      variantOp.getInnerModule()->removeAttr("hal.executable.imports");
+    }
+    if (!importNames.empty() && options_.linkStatic) {
+      return variantOp.emitError()
+             << "static libraries cannot resolve executable imports; disable "
+                "microkernels when producing static libraries";
+    }
+
     // At this moment we are leaving MLIR LLVM dialect land translating module
     // into target independent LLVMIR.
     auto llvmModule = mlir::translateModuleToLLVMIR(variantOp.getInnerModule(),
@@ -237,6 +493,9 @@ class LLVMAOTTargetBackend final : public TargetBackend {
                                       "dialect to the native llvm::Module";
     }
 
+    auto sveVectorScale = getSVEVectorScale(variantOp.getLoc(), options_);
+    if (failed(sveVectorScale)) return failure();
+
     // Configure the functions in the module. This may override defaults set
     // during the MLIR->LLVM conversion.
     for (auto &func : *llvmModule) {
@@ -253,6 +512,13 @@ class LLVMAOTTargetBackend final : public TargetBackend {
       // Our dispatches are all hot - that's kind of the point.
       // This may favor more aggressive optimizations.
       func.addFnAttr("hot");
+
+      // Fixing vscale lets LLVM lower fixed-width vectors wider than NEON
+      // registers to SVE instructions.
+      if (*sveVectorScale) {
+        func.addFnAttr(llvm::Attribute::getWithVScaleRangeArgs(
+            context, *sveVectorScale, *sveVectorScale));
+      }
     }
 
     // Build the IREE HAL executable library metadata. The runtime uses this to
@@ -274,6 +540,52 @@ class LLVMAOTTargetBackend final : public TargetBackend {
         }
       } break;
     }
+    libraryBuilder.setEmitRangeEntryPoints(options_.workgroupRangeEntryPoints);
+    for (auto importName : importNames) {
+      libraryBuilder.addImport(importName, /*weak=*/false);
+    }
+
+    // Clone all code for each CPU feature tier into its own library. The
+    // query function selects the library to use based on the processor the
+    // runtime is executing on.
+    struct FeatureTier {
+      uint64_t processorData0Mask;
+      std::unique_ptr<llvm::ValueToValueMapTy> clonedValues;
+      LibraryBuilder libraryBuilder;
+    };
+    SmallVector<FeatureTier> featureTiers;
+    for (auto tierFeatures : llvm::enumerate(options_.targetCPUFeatureTiers)) {
+      auto maskOr = getFeatureTierMask(
+          variantOp.getLoc(), targetTriple.getArch(), tierFeatures.value());
+      if (failed(maskOr)) return failure();
+      std::string targetFeatures = options_.targetCPUFeatures;
+      if (!targetFeatures.empty()) targetFeatures += ",";
+      targetFeatures += tierFeatures.value();
+      auto clonedValues = std::make_unique<llvm::ValueToValueMapTy>();
+      cloneFunctionsForFeatureTier(
+          llvmModule.get(),
+          llvm::formatv("_tier{0}", tierFeatures.index()).str(),
+          targetFeatures, *clonedValues);
+      featureTiers.push_back(
+          {*maskOr, std::move(clonedValues), libraryBuilder});
+    }
+
+    // Entry points tiled for an L2 cache tier have a clone named
+    // `{entry point}_cache_tier{index}` emitted during codegen. Each cache tier
+    // gets a library for the base features and each feature tier whose exports
+    // use the clones where available.
+    struct CacheTier {
+      uint32_t l2CacheSizeKB;
+      LibraryBuilder baseLibraryBuilder;
+      SmallVector<LibraryBuilder> featureTierLibraryBuilders;
+    };
+    SmallVector<CacheTier> cacheTiers;
+    for (auto l2CacheSizeKB : options_.targetL2CacheTiers) {
+      cacheTiers.push_back(
+          {l2CacheSizeKB, libraryBuilder,
+           SmallVector<LibraryBuilder>(featureTiers.size(), libraryBuilder)});
+    }
+
     for (auto entryPointOp :
          variantOp.getBlock().getOps<ExecutableEntryPointOp>()) {
       // Find the matching function in the LLVM module.
@@ -288,9 +600,55 @@ class LLVMAOTTargetBackend final : public TargetBackend {
                                     .getValueOr(APInt(64, 0))
                                     .getSExtValue();
 
-      libraryBuilder.addExport(entryPointOp.getName(), "",
-                               LibraryBuilder::DispatchAttrs{localMemorySize},
-                               llvmFunc);
+      // Compiler-estimated costs are embedded so that runtime schedulers and
+      // tooling can reason about the dispatch without executing it.
+      auto dispatchCost = getDispatchCost(entryPointOp);
+      LibraryBuilder::DispatchCost libraryCost{
+          dispatchCost.flopCount, dispatchCost.readByteCount,
+          dispatchCost.writeByteCount, dispatchCost.workgroupCount};
+
+      // The runtime flushes denormals to zero unless the export was compiled
+      // to require IEEE behavior.
+      LibraryBuilder::DispatchAttrs dispatchAttrs;
+      dispatchAttrs.localMemorySize = localMemorySize;
+      dispatchAttrs.preserveDenormals =
+          options_.preserveDenormals ||
+          (llvmFunc->hasFnAttribute("denormal-fp-math") &&
+           llvmFunc->getDenormalMode(llvm::APFloat::IEEEsingle()) ==
+               llvm::DenormalMode::getIEEE());
+
+      libraryBuilder.addExport(entryPointOp.getName(), "", dispatchAttrs,
+                               llvmFunc, libraryCost);
+      for (auto &featureTier : featureTiers) {
+        featureTier.libraryBuilder.addExport(
+            entryPointOp.getName(), "", dispatchAttrs,
+            cast<llvm::Function>((*featureTier.clonedValues)[llvmFunc]),
+            libraryCost);
+      }
+      for (auto cacheTier : llvm::enumerate(cacheTiers)) {
+        auto *cacheTierFunc = llvmModule->getFunction(
+            llvm::formatv("{0}_cache_tier{1}", entryPointOp.getName(),
+                          cacheTier.index())
+                .str());
+        if (cacheTierFunc) {
+          cacheTierFunc->setLinkage(
+              llvm::GlobalValue::LinkageTypes::InternalLinkage);
+          cacheTierFunc->setDSOLocal(true);
+        } else {
+          cacheTierFunc = llvmFunc;
+        }
+        cacheTier.value().baseLibraryBuilder.addExport(
+            entryPointOp.getName(), "", dispatchAttrs, cacheTierFunc,
+            libraryCost);
+        for (auto featureTier : llvm::enumerate(featureTiers)) {
+          auto &clonedValues = *featureTier.value().clonedValues;
+          cacheTier.value()
+              .featureTierLibraryBuilders[featureTier.index()]
+              .addExport(entryPointOp.getName(), "", dispatchAttrs,
+                         cast<llvm::Function>(clonedValues[cacheTierFunc]),
+                         libraryCost);
+        }
+      }
     }
 
     auto queryFunctionName = std::string(kQueryFunctionName);
@@ -299,7 +657,45 @@ class LLVMAOTTargetBackend final : public TargetBackend {
       // libraries in the same namespace.
       queryFunctionName = libraryName + "_library_query";
     }
-    auto *queryLibraryFunc = libraryBuilder.build(queryFunctionName);
+    llvm::Function *queryLibraryFunc = nullptr;
+    if (featureTiers.empty() && cacheTiers.empty()) {
+      queryLibraryFunc = libraryBuilder.build(queryFunctionName);
+    } else {
+      // Feature tiers take precedence over cache tiers as they have a larger
+      // impact on performance.
+      SmallVector<LibraryBuilder::QueryVariant> queryVariants;
+      for (auto featureTier : llvm::enumerate(featureTiers)) {
+        for (auto cacheTier : llvm::enumerate(cacheTiers)) {
+          queryVariants.push_back(
+              {featureTier.value().processorData0Mask,
+               cacheTier.value()
+                   .featureTierLibraryBuilders[featureTier.index()]
+                   .build(llvm::formatv("{0}_tier{1}_cache_tier{2}",
+                                        queryFunctionName, featureTier.index(),
+                                        cacheTier.index())
+                              .str()),
+               cacheTier.value().l2CacheSizeKB});
+        }
+        queryVariants.push_back(
+            {featureTier.value().processorData0Mask,
+             featureTier.value().libraryBuilder.build(
+                 llvm::formatv("{0}_tier{1}", queryFunctionName,
+                               featureTier.index())
+                     .str())});
+      }
+      for (auto cacheTier : llvm::enumerate(cacheTiers)) {
+        queryVariants.push_back(
+            {/*processorData0Mask=*/0,
+             cacheTier.value().baseLibraryBuilder.build(
+                 llvm::formatv("{0}_cache_tier{1}", queryFunctionName,
+                               cacheTier.index())
+                     .str()),
+             cacheTier.value().l2CacheSizeKB});
+      }
+      queryLibraryFunc = LibraryBuilder::buildVariantQuery(
+          llvmModule.get(), queryFunctionName, queryVariants,
+          libraryBuilder.build(queryFunctionName + "_base"));
+    }
 
     // The query function must be exported for dynamic libraries.
     queryLibraryFunc->setVisibility(
@@ -367,6 +763,17 @@ class LLVMAOTTargetBackend final : public TargetBackend {
     auto *llvmIdent = llvmModule->getNamedMetadata("llvm.ident");
     if (llvmIdent) llvmIdent->clearOperands();
 
+    // Codegen only ever loads from the private constants it emits (constant
+    // tables, etc) and never takes their identity, so mark them as
+    // unnamed_addr; this lets identical rodata from each of the linked
+    // executables be merged into one. Any future codegen relying on the
+    // address of a constant being unique must not emit it as private.
+    for (auto &global : llvmModule->globals()) {
+      if (global.isConstant() && global.hasPrivateLinkage()) {
+        global.setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+      }
+    }
+
     // LLVM opt passes that perform code generation optimizations/transformation
     // similar to what a frontend would do.
     if (failed(
@@ -377,10 +784,15 @@ class LLVMAOTTargetBackend final : public TargetBackend {
              << options_.targetTriple << "'";
     }
 
+    llvm::Function *profileWriteFunc = nullptr;
+    if (pgoInstrument) {
+      profileWriteFunc = createProfileWriteFunction(*llvmModule);
+    }
+
     // Fixup visibility from any symbols we may link in - we want to hide all
     // but the query entry point.
     for (auto &func : *llvmModule) {
-      if (&func == queryLibraryFunc) {
+      if (&func == queryLibraryFunc || &func == profileWriteFunc) {
         // Leave our library query function as public/external so that it is
         // exported from shared objects and available for linking in static
         // objects.
@@ -394,6 +806,13 @@ class LLVMAOTTargetBackend final : public TargetBackend {
       func.setLinkage(llvm::GlobalValue::LinkageTypes::InternalLinkage);
     }
     for (auto &global : llvmModule->getGlobalList()) {
+      // Profile counters and variables (such as the raw profile version and
+      // file name) keep the linkage given by the instrumentation as they are
+      // referenced by the profile runtime linked into the library.
+      if (pgoInstrument && (global.getName().startswith("__llvm_") ||
+                            global.getName().startswith("__prof"))) {
+        continue;
+      }
       global.setDSOLocal(true);
       global.setLinkage(llvm::GlobalValue::LinkageTypes::InternalLinkage);
     }
@@ -456,7 +875,7 @@ class LLVMAOTTargetBackend final : public TargetBackend {
     } else {
       return serializeDynamicLibraryExecutable(variantOp, executableBuilder,
                                                libraryName, objectFiles,
-                                               linkerTool.get());
+                                               linkerTool.get(), cachePath);
     }
   }
 
@@ -491,7 +910,7 @@ class LLVMAOTTargetBackend final : public TargetBackend {
   LogicalResult serializeDynamicLibraryExecutable(
       IREE::HAL::ExecutableVariantOp variantOp, OpBuilder &executableBuilder,
       const std::string &libraryName, const SmallVector<Artifact> &objectFiles,
-      LinkerTool *linkerTool) {
+      LinkerTool *linkerTool, StringRef cachePath) {
     // Link the generated object files into a dylib.
     auto linkArtifactsOr =
         linkerTool->linkDynamicLibrary(libraryName, objectFiles);
@@ -511,53 +930,61 @@ class LLVMAOTTargetBackend final : public TargetBackend {
       }
     }
 
-    if (options_.linkEmbedded) {
-      // Load the linked ELF file and pack into an attr.
-      auto elfFile = linkArtifacts.libraryFile.read();
-      if (!elfFile.hasValue()) {
-        return variantOp.emitError()
-               << "failed to read back dylib temp file at "
-               << linkArtifacts.libraryFile.path;
-      }
-      auto bufferAttr = DenseIntElementsAttr::get(
-          VectorType::get({static_cast<int64_t>(elfFile->size())},
-                          IntegerType::get(executableBuilder.getContext(), 8)),
-          std::move(elfFile.getValue()));
-
-      // Add the binary to the parent hal.executable.
-      auto binaryOp = executableBuilder.create<IREE::HAL::ExecutableBinaryOp>(
-          variantOp.getLoc(), variantOp.sym_name(),
-          variantOp.target().getFormat(), bufferAttr);
-      binaryOp.mime_typeAttr(
-          executableBuilder.getStringAttr("application/x-elf"));
-    } else {
-      // Load the linked system library and optionally tag on the debug
-      // database. This debug database sits at the tail of the file and is
-      // ignored by system loaders and tools but still accessible to the runtime
-      // loader. Not all platforms have separate debug databases and need this.
-      auto libraryFileOr = linkArtifacts.libraryFile.read();
-      if (!libraryFileOr.hasValue()) {
+    // Load the linked library. System libraries optionally get the debug
+    // database tagged on: it sits at the tail of the file and is ignored by
+    // system loaders and tools but still accessible to the runtime loader. Not
+    // all platforms have separate debug databases and need this.
+    auto libraryFileOr = linkArtifacts.libraryFile.read();
+    if (!libraryFileOr.hasValue()) {
+      return variantOp.emitError() << "failed to read back dylib temp file at "
+                                   << linkArtifacts.libraryFile.path;
+    }
+    auto libraryFile = std::move(libraryFileOr).getValue();
+    if (!options_.linkEmbedded && options_.debugSymbols &&
+        linkArtifacts.debugFile.outputFile) {
+      if (failed(appendDebugDatabase(libraryFile, linkArtifacts.debugFile))) {
         return variantOp.emitError()
-               << "failed to read back dylib temp file at "
-               << linkArtifacts.libraryFile.path;
+               << "failed to append debug database to dylib file";
       }
-      auto libraryFile = std::move(libraryFileOr).getValue();
-      if (options_.debugSymbols && linkArtifacts.debugFile.outputFile) {
-        if (failed(appendDebugDatabase(libraryFile, linkArtifacts.debugFile))) {
-          return variantOp.emitError()
-                 << "failed to append debug database to dylib file";
-        }
+    }
+
+    // Store the library for reuse by later compilations. The file is written
+    // atomically so that concurrent compilations never observe partial
+    // entries. Failing to update the cache only loses the reuse.
+    if (!cachePath.empty()) {
+      llvm::sys::fs::create_directories(options_.executableCacheDir);
+      auto error = llvm::writeFileAtomically(
+          (cachePath + ".tmp%%%%%%%%").str(), cachePath,
+          StringRef(reinterpret_cast<const char *>(libraryFile.data()),
+                    libraryFile.size()));
+      if (error) {
+        mlir::emitWarning(variantOp.getLoc())
+            << "failed to write executable cache entry " << cachePath << ": "
+            << llvm::toString(std::move(error));
       }
-      auto bufferAttr = DenseIntElementsAttr::get(
-          VectorType::get({static_cast<int64_t>(libraryFile.size())},
-                          IntegerType::get(executableBuilder.getContext(), 8)),
-          std::move(libraryFile));
-
-      // Add the binary to the parent hal.executable.
-      auto binaryOp = executableBuilder.create<IREE::HAL::ExecutableBinaryOp>(
-          variantOp.getLoc(), variantOp.sym_name(),
-          variantOp.target().getFormat(), bufferAttr);
-      const char *mimeType = nullptr;
+    }
+
+    addDynamicLibraryBinary(variantOp, executableBuilder,
+                            std::move(libraryFile));
+    return success();
+  }
+
+  // Adds a hal.executable.binary containing the linked |libraryFile| to the
+  // parent hal.executable of |variantOp|.
+  void addDynamicLibraryBinary(IREE::HAL::ExecutableVariantOp variantOp,
+                               OpBuilder &executableBuilder,
+                               std::vector<int8_t> libraryFile) {
+    auto bufferAttr = DenseIntElementsAttr::get(
+        VectorType::get({static_cast<int64_t>(libraryFile.size())},
+                        IntegerType::get(executableBuilder.getContext(), 8)),
+        std::move(libraryFile));
+    auto binaryOp = executableBuilder.create<IREE::HAL::ExecutableBinaryOp>(
+        variantOp.getLoc(), variantOp.sym_name(),
+        variantOp.target().getFormat(), bufferAttr);
+    const char *mimeType = nullptr;
+    if (options_.linkEmbedded) {
+      mimeType = "application/x-elf";
+    } else {
       llvm::Triple targetTriple(options_.targetTriple);
       switch (targetTriple.getObjectFormat()) {
         case llvm::Triple::ObjectFormatType::COFF:
@@ -576,10 +1003,8 @@ class LLVMAOTTargetBackend final : public TargetBackend {
           mimeType = "application/octet-stream";
           break;
       }
-      binaryOp.mime_typeAttr(executableBuilder.getStringAttr(mimeType));
     }
-
-    return success();
+    binaryOp.mime_typeAttr(executableBuilder.getStringAttr(mimeType));
   }
 
  private:
@@ -676,6 +1101,13 @@ class LLVMAOTTargetBackend final : public TargetBackend {
     addConfig("cpu_features",
               StringAttr::get(context, options_.targetCPUFeatures));
 
+    // Set the L2 cache sizes (in KiB) dispatches are additionally tiled for.
+    if (!options_.targetL2CacheTiers.empty()) {
+      SmallVector<int64_t> tiers(options_.targetL2CacheTiers.begin(),
+                                 options_.targetL2CacheTiers.end());
+      addConfig("l2_cache_tiers", Builder(context).getI64ArrayAttr(tiers));
+    }
+
     return IREE::HAL::ExecutableTargetAttr::get(
         context, StringAttr::get(context, "llvm"),
         StringAttr::get(context, format), DictionaryAttr::get(context, config));
@@ -703,6 +1135,18 @@ class LLVMAOTTargetBackend final : public TargetBackend {
     config_.vectorSize = tti.getRegisterBitWidth(
                              llvm::TargetTransformInfo::RGK_FixedWidthVector) /
                          8;
+    if (options_.sveVectorBits && targetMachine->getTargetTriple().isAArch64()) {
+      // Vectors are sized for the full SVE registers; the vector length is
+      // validated when serializing.
+      config_.vectorSize = std::max<int64_t>(config_.vectorSize,
+                                             options_.sveVectorBits / 8);
+    }
+    if (!config_.vectorSize && targetMachine->getTargetTriple().isRISCV()) {
+      // RVV registers are scalable and LLVM only reports a fixed width when
+      // the minimum VLEN is specified through backend flags.
+      config_.vectorSize =
+          getRISCVMinVectorLengthInBytes(options_.targetCPUFeatures);
+    }
     LLVM_DEBUG({
       llvm::dbgs() << "CPU : " << targetMachine->getTargetCPU() << "\n";
       llvm::dbgs() << "Target Triple : "
@@ -69,8 +69,20 @@ LogicalResult runLLVMIRPasses(const LLVMTargetOptions &options,
       /*DebugLogging=*/false);
   standardInstrumentations.registerCallbacks(passInstrumentationCallbacks);
 
-  llvm::PassBuilder passBuilder(machine, options.pipelineTuningOptions, {},
-                                &passInstrumentationCallbacks);
+  // Profile-guided optimization either instruments the code to produce raw
+  // profiles or uses a profile merged from them for block layout, inlining,
+  // and unrolling decisions.
+  llvm::Optional<llvm::PGOOptions> pgoOptions;
+  if (!options.pgoInstrumentProfileFile.empty()) {
+    pgoOptions = llvm::PGOOptions(options.pgoInstrumentProfileFile, "", "",
+                                  llvm::PGOOptions::IRInstr);
+  } else if (!options.pgoProfile.empty()) {
+    pgoOptions =
+        llvm::PGOOptions(options.pgoProfile, "", "", llvm::PGOOptions::IRUse);
+  }
+
+  llvm::PassBuilder passBuilder(machine, options.pipelineTuningOptions,
+                                pgoOptions, &passInstrumentationCallbacks);
   llvm::AAManager aa = passBuilder.buildDefaultAAPipeline();
   functionAnalysisManager.registerPass([&] { return std::move(aa); });
 
@@ -47,6 +47,10 @@ LLVMTargetOptions getDefaultLLVMTargetOptions() {
     // LLVM SLP Auto vectorizer.
     targetOptions.pipelineTuningOptions.SLPVectorization = true;
 
+    // Fold identical functions (such as helpers duplicated across linked
+    // executables) into one.
+    targetOptions.pipelineTuningOptions.MergeFunctions = true;
+
     // LLVM -O3.
     // TODO(benvanik): add an option for this.
     targetOptions.optLevel = llvm::OptimizationLevel::O3;
@@ -76,6 +80,30 @@ LLVMTargetOptions getLLVMTargetOptionsFromFlags() {
       llvm::cl::desc("LLVM target machine CPU features; use 'host' for your "
                      "host native CPU"),
       llvm::cl::init(""));
+  static llvm::cl::list<std::string> clTargetCPUFeatureTiers(
+      "iree-llvm-target-cpu-feature-tier",
+      llvm::cl::desc("Additional LLVM target machine CPU features (such as "
+                     "'+avx2,+fma') to compile executables for and select "
+                     "between at runtime; may be repeated and tiers are "
+                     "tried in order before falling back to the base "
+                     "features"),
+      llvm::cl::ZeroOrMore);
+  static llvm::cl::list<unsigned> clTargetL2CacheTiers(
+      "iree-llvm-target-l2-cache-tier",
+      llvm::cl::desc("L2 cache size in KiB (such as 1024) to additionally "
+                     "tile heavy dispatches for and select between at "
+                     "runtime based on the detected cache sizes; may be "
+                     "repeated and tiers are tried in order before falling "
+                     "back to the default tile sizes"),
+      llvm::cl::ZeroOrMore);
+
+  static llvm::cl::opt<unsigned> clTargetSVEVectorBits(
+      "iree-llvm-target-sve-vector-bits",
+      llvm::cl::desc("Vector length in bits of the AArch64 SVE implementation "
+                     "targeted (such as 256 for Neoverse V1); requires +sve "
+                     "and produces code that only runs on that vector length"),
+      llvm::cl::init(targetOptions.sveVectorBits));
+  targetOptions.sveVectorBits = clTargetSVEVectorBits;
 
   static llvm::cl::opt<bool> llvmLoopInterleaving(
       "iree-llvm-loop-interleaving", llvm::cl::init(false),
@@ -89,6 +117,10 @@ LLVMTargetOptions getLLVMTargetOptionsFromFlags() {
   static llvm::cl::opt<bool> llvmSLPVectorization(
       "iree-llvm-slp-vectorization", llvm::cl::init(false),
       llvm::cl::desc("Enable LLVM SLP Vectorization opt"));
+  static llvm::cl::opt<bool> llvmMergeFunctions(
+      "iree-llvm-merge-functions", llvm::cl::init(true),
+      llvm::cl::desc("Merge identical functions across the executables linked "
+                     "into a library"));
 
   targetOptions.targetTriple = clTargetTriple;
   if (clTargetCPU != "host") {
@@ -97,12 +129,17 @@ LLVMTargetOptions getLLVMTargetOptionsFromFlags() {
   if (clTargetCPUFeatures != "host") {
     targetOptions.targetCPUFeatures = clTargetCPUFeatures;
   }
+  targetOptions.targetCPUFeatureTiers.assign(clTargetCPUFeatureTiers.begin(),
+                                             clTargetCPUFeatureTiers.end());
+  targetOptions.targetL2CacheTiers.assign(clTargetL2CacheTiers.begin(),
+                                          clTargetL2CacheTiers.end());
 
   // LLVM opt options.
   targetOptions.pipelineTuningOptions.LoopInterleaving = llvmLoopInterleaving;
   targetOptions.pipelineTuningOptions.LoopVectorization = llvmLoopVectorization;
   targetOptions.pipelineTuningOptions.LoopUnrolling = llvmLoopUnrolling;
   targetOptions.pipelineTuningOptions.SLPVectorization = llvmSLPVectorization;
+  targetOptions.pipelineTuningOptions.MergeFunctions = llvmMergeFunctions;
 
   static llvm::cl::opt<SanitizerKind> clSanitizerKind(
       "iree-llvm-sanitize", llvm::cl::desc("Apply LLVM sanitize feature"),
@@ -111,6 +148,31 @@ LLVMTargetOptions getLLVMTargetOptionsFromFlags() {
                                   "Address sanitizer support")));
   targetOptions.sanitizerKind = clSanitizerKind;
 
+  static llvm::cl::opt<std::string> clPGOInstrumentProfileFile(
+      "iree-llvm-pgo-instrument-profile-file",
+      llvm::cl::desc("Instruments executables for profile-guided optimization "
+                     "and writes raw profiles to this file name pattern (such "
+                     "as 'iree-%m.profraw') when executables are unloaded; "
+                     "requires -iree-llvm-link-embedded=false on Linux"),
+      llvm::cl::init(targetOptions.pgoInstrumentProfileFile));
+  targetOptions.pgoInstrumentProfileFile = clPGOInstrumentProfileFile;
+
+  static llvm::cl::opt<std::string> clPGORuntimeLibrary(
+      "iree-llvm-pgo-runtime-library",
+      llvm::cl::desc("LLVM profile runtime archive (such as "
+                     "libclang_rt.profile-x86_64.a) linked into executables "
+                     "instrumented for profile-guided optimization"),
+      llvm::cl::init(targetOptions.pgoRuntimeLibrary));
+  targetOptions.pgoRuntimeLibrary = clPGORuntimeLibrary;
+
+  static llvm::cl::opt<std::string> clPGOProfile(
+      "iree-llvm-pgo-profile",
+      llvm::cl::desc("Indexed profile (.profdata) merged from the raw profiles "
+                     "of instrumented executables used for profile-guided "
+                     "optimization"),
+      llvm::cl::init(targetOptions.pgoProfile));
+  targetOptions.pgoProfile = clPGOProfile;
+
   static llvm::cl::opt<std::string> clTargetABI(
       "iree-llvm-target-abi",
       llvm::cl::desc("LLVM target machine ABI; specify for -mabi"),
@@ -136,6 +198,20 @@ LLVMTargetOptions getLLVMTargetOptionsFromFlags() {
       llvm::cl::init(targetOptions.debugSymbols));
   targetOptions.debugSymbols = clDebugSymbols;
 
+  static llvm::cl::opt<bool> clPreserveDenormals(
+      "iree-llvm-preserve-denormals",
+      llvm::cl::desc("Requires IEEE denormal behavior for all exports instead "
+                     "of the runtime default of flushing denormals to zero"),
+      llvm::cl::init(targetOptions.preserveDenormals));
+  targetOptions.preserveDenormals = clPreserveDenormals;
+
+  static llvm::cl::opt<bool> clWorkgroupRangeEntryPoints(
+      "iree-llvm-workgroup-range-entry-points",
+      llvm::cl::desc("Emits an entry point per export that executes a range of "
+                     "workgroups per call to amortize dispatch overheads"),
+      llvm::cl::init(targetOptions.workgroupRangeEntryPoints));
+  targetOptions.workgroupRangeEntryPoints = clWorkgroupRangeEntryPoints;
+
   static llvm::cl::opt<std::string> clLinkerPath(
       "iree-llvm-system-linker-path",
       llvm::cl::desc("Tool used to link system shared libraries produced by "
@@ -180,6 +256,16 @@ LLVMTargetOptions getLLVMTargetOptionsFromFlags() {
       llvm::cl::init(targetOptions.staticLibraryOutput));
   targetOptions.staticLibraryOutput = clStaticLibraryOutputPath;
 
+  static llvm::cl::opt<std::string> clExecutableCacheDir(
+      "iree-llvm-executable-cache-dir",
+      llvm::cl::desc(
+          "Directory used to cache linked executables across compilations. "
+          "Executables whose IR and target options are unchanged reuse the "
+          "cached binary. Entries are not invalidated when the compiler "
+          "itself changes and the directory should be cleared on upgrade."),
+      llvm::cl::init(targetOptions.executableCacheDir));
+  targetOptions.executableCacheDir = clExecutableCacheDir;
+
   static llvm::cl::opt<bool> clListTargets(
       "iree-llvm-list-targets",
       llvm::cl::desc("Lists all registered targets that the LLVM backend can "
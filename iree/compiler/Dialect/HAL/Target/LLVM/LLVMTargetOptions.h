@@ -28,6 +28,26 @@ struct LLVMTargetOptions {
   std::string targetCPU;
   std::string targetCPUFeatures;
 
+  // Additional CPU feature sets (such as `+avx2,+fma`) each executable is
+  // compiled for on top of targetCPUFeatures. The runtime selects the first
+  // tier supported by the processor it is executing on and otherwise falls
+  // back to the base targetCPUFeatures code. Tiers multiply the code size of
+  // each executable and are ordered from most to least specialized.
+  std::vector<std::string> targetCPUFeatureTiers;
+
+  // L2 cache sizes in KiB that heavy dispatches are additionally tiled for.
+  // The runtime selects the first tier that fits within the L2 cache size of
+  // the cores it is executing on and otherwise falls back to the default tile
+  // sizes. Tiers are ordered from largest to smallest.
+  std::vector<unsigned> targetL2CacheTiers;
+
+  // Vector length in bits of the AArch64 SVE implementation being targeted or
+  // 0 if unknown. When set code is generated for exactly this vector length
+  // (like clang's -msve-vector-bits) such that fixed-width vectors wider than
+  // 128 bits are lowered to SVE instructions. The resulting executables only
+  // behave correctly on hardware with this vector length.
+  unsigned sveVectorBits = 0;
+
   llvm::PipelineTuningOptions pipelineTuningOptions;
   llvm::OptimizationLevel optLevel;
   llvm::TargetOptions options;
@@ -38,9 +58,32 @@ struct LLVMTargetOptions {
   // and benchmarking
   bool debugSymbols = true;
 
+  // Marks all exports as requiring IEEE denormal behavior. By default the
+  // runtime flushes denormals to zero; exports may also opt out individually
+  // with the LLVM "denormal-fp-math" function attribute.
+  bool preserveDenormals = false;
+
+  // Emits a workgroup-range entry point alongside each export so that the
+  // runtime can execute a contiguous range of workgroups in a single call.
+  bool workgroupRangeEntryPoints = true;
+
   // Sanitizer Kind for CPU Kernels
   SanitizerKind sanitizerKind = SanitizerKind::kNone;
 
+  // Profile file name pattern (like LLVM_PROFILE_FILE) that executables
+  // instrumented for profile-guided optimization write their raw profiles to
+  // when unloaded. Empty to disable instrumentation. Only supported for system
+  // libraries targeting Linux.
+  std::string pgoInstrumentProfileFile;
+
+  // Path of the LLVM profile runtime archive (libclang_rt.profile-*.a) linked
+  // into instrumented executables.
+  std::string pgoRuntimeLibrary;
+
+  // Indexed profile (.profdata merged with llvm-profdata from the raw profiles
+  // of instrumented executables) used to optimize executables.
+  std::string pgoProfile;
+
   // Tool to use for linking (like lld). Acts as a prefix to the command line
   // and can contain additional arguments.
   std::string linkerPath;
@@ -65,6 +108,12 @@ struct LLVMTargetOptions {
   //
   // This option is incompatible with the linkEmbedded option.
   std::string staticLibraryOutput;
+
+  // Directory used to cache linked dynamic libraries across compilations.
+  // Entries are keyed by a hash of the executable variant IR and these options
+  // so that executables that have not changed skip code generation and
+  // linking. Empty to disable the cache.
+  std::string executableCacheDir;
 };
 
 // Returns LLVMTargetOptions struct intialized with the iree-llvm-* flags.
@@ -6,6 +6,7 @@
 
 #include "iree/compiler/Dialect/HAL/Target/LLVM/LibraryBuilder.h"
 
+#include "llvm/ADT/StringSwitch.h"
 #include "llvm/IR/IRBuilder.h"
 
 // =============================================================================
@@ -109,33 +110,105 @@ static llvm::FunctionType *makeDispatchFunctionType(
                                  /*isVarArg=*/false);
 }
 
+// %struct.iree_hal_executable_workgroup_range_v0_t = type {
+//   i32,
+//   i32
+// }
+static llvm::StructType *makeWorkgroupRangeType(llvm::LLVMContext &context) {
+  if (auto *existingType = llvm::StructType::getTypeByName(
+          context, "iree_hal_executable_workgroup_range_v0_t")) {
+    return existingType;
+  }
+  auto *i32Type = llvm::IntegerType::getInt32Ty(context);
+  auto *type =
+      llvm::StructType::create(context,
+                               {
+                                   i32Type,
+                                   i32Type,
+                               },
+                               "iree_hal_executable_workgroup_range_v0_t",
+                               /*isPacked=*/false);
+  return type;
+}
+
+// i32 (%struct.iree_hal_executable_dispatch_state_v0_t*,
+//      %struct.iree_hal_executable_workgroup_range_v0_t*,
+//      i8*)
+static llvm::FunctionType *makeDispatchRangeFunctionType(
+    llvm::LLVMContext &context) {
+  auto *dispatchStateType = makeDispatchStateType(context);
+  auto *workgroupRangeType = makeWorkgroupRangeType(context);
+  auto *i8Type = llvm::IntegerType::getInt8Ty(context);
+  auto *i32Type = llvm::IntegerType::getInt32Ty(context);
+  return llvm::FunctionType::get(i32Type,
+                                 {
+                                     dispatchStateType->getPointerTo(),
+                                     workgroupRangeType->getPointerTo(),
+                                     i8Type->getPointerTo(),
+                                 },
+                                 /*isVarArg=*/false);
+}
+
 // %struct.iree_hal_executable_dispatch_attrs_v0_t = type {
 //   i16,
-//   i16
+//   i8,
+//   i8
 // }
 static llvm::StructType *makeDispatchAttrsType(llvm::LLVMContext &context) {
   if (auto *existingType = llvm::StructType::getTypeByName(
           context, "iree_hal_executable_dispatch_attrs_v0_t")) {
     return existingType;
   }
+  auto *i8Type = llvm::IntegerType::getInt8Ty(context);
   auto *i16Type = llvm::IntegerType::getInt16Ty(context);
   auto *type =
       llvm::StructType::create(context,
                                {
                                    i16Type,
-                                   i16Type,
+                                   i8Type,
+                                   i8Type,
                                },
                                "iree_hal_executable_dispatch_attrs_v0_t",
                                /*isPacked=*/false);
   return type;
 }
 
+// %struct.iree_hal_executable_dispatch_cost_v0_t = type {
+//   i64,
+//   i64,
+//   i64,
+//   i32,
+//   i32
+// }
+static llvm::StructType *makeDispatchCostType(llvm::LLVMContext &context) {
+  if (auto *existingType = llvm::StructType::getTypeByName(
+          context, "iree_hal_executable_dispatch_cost_v0_t")) {
+    return existingType;
+  }
+  auto *i32Type = llvm::IntegerType::getInt32Ty(context);
+  auto *i64Type = llvm::IntegerType::getInt64Ty(context);
+  auto *type =
+      llvm::StructType::create(context,
+                               {
+                                   i64Type,
+                                   i64Type,
+                                   i64Type,
+                                   i32Type,
+                                   i32Type,
+                               },
+                               "iree_hal_executable_dispatch_cost_v0_t",
+                               /*isPacked=*/false);
+  return type;
+}
+
 // %struct.iree_hal_executable_export_table_v0_t = type {
 //   i32,
 //   %struct.iree_hal_executable_dispatch_attrs_v0_t*,
 //   i32*,
 //   i8**,
-//   i8**
+//   i8**,
+//   %struct.iree_hal_executable_dispatch_cost_v0_t*,
+//   i32 (...)**
 // }
 static llvm::StructType *makeExportTableType(llvm::LLVMContext &context) {
   if (auto *existingType = llvm::StructType::getTypeByName(
@@ -145,6 +218,8 @@ static llvm::StructType *makeExportTableType(llvm::LLVMContext &context) {
   auto *i32Type = llvm::IntegerType::getInt32Ty(context);
   auto *dispatchFunctionType = makeDispatchFunctionType(context);
   auto *dispatchAttrsType = makeDispatchAttrsType(context);
+  auto *dispatchCostType = makeDispatchCostType(context);
+  auto *dispatchRangeFunctionType = makeDispatchRangeFunctionType(context);
   auto *i8PtrType = llvm::IntegerType::getInt8PtrTy(context);
   auto *type = llvm::StructType::create(
       context,
@@ -154,6 +229,8 @@ static llvm::StructType *makeExportTableType(llvm::LLVMContext &context) {
           dispatchAttrsType->getPointerTo(),
           i8PtrType->getPointerTo(),
           i8PtrType->getPointerTo(),
+          dispatchCostType->getPointerTo(),
+          dispatchRangeFunctionType->getPointerTo()->getPointerTo(),
       },
       "iree_hal_executable_export_table_v0_t",
       /*isPacked=*/false);
@@ -245,7 +322,9 @@ llvm::Function *LibraryBuilder::build(StringRef queryFuncName) {
   auto *libraryHeaderType = makeLibraryHeaderType(context);
 
   // %struct.iree_hal_executable_library_header_t**
-  // @iree_hal_library_query(i32, void*)
+  // @iree_hal_library_query(i32, %struct.iree_hal_executable_environment_v0_t*)
+  // The environment is passed as an opaque pointer as only variant queries
+  // built with buildVariantQuery read it.
   auto *queryFuncType =
       llvm::FunctionType::get(libraryHeaderType->getPointerTo(),
                               {
@@ -272,6 +351,121 @@ llvm::Function *LibraryBuilder::build(StringRef queryFuncName) {
   return func;
 }
 
+// %struct.iree_hal_processor_v0_t = type {
+//   [8 x i64]
+// }
+// %struct.iree_hal_executable_environment_v0_t = type {
+//   %struct.iree_hal_processor_v0_t
+// }
+//
+// processor.data[0] holds the feature bits and processor.data[1] the cache
+// sizes. As the processor is at offset 0 of the environment the query function
+// loads them directly through the pointer.
+llvm::Optional<uint64_t> LibraryBuilder::getProcessorData0Bit(
+    llvm::Triple::ArchType arch, StringRef feature) {
+  switch (arch) {
+    case llvm::Triple::x86_64:
+      // IREE_HAL_PROCESSOR_DATA0_X86_64_*
+      return llvm::StringSwitch<llvm::Optional<uint64_t>>(feature)
+          .Case("avx", 1ull << 0)
+          .Case("avx2", 1ull << 1)
+          .Case("fma", 1ull << 2)
+          .Case("avx512f", 1ull << 3)
+          .Case("avx512bw", 1ull << 4)
+          .Case("avx512dq", 1ull << 5)
+          .Case("avx512vl", 1ull << 6)
+          .Case("avx512vnni", 1ull << 7)
+          .Case("f16c", 1ull << 8)
+          .Case("avx512bf16", 1ull << 9)
+          .Default(llvm::None);
+    case llvm::Triple::aarch64:
+      // IREE_HAL_PROCESSOR_DATA0_ARM_64_*
+      return llvm::StringSwitch<llvm::Optional<uint64_t>>(feature)
+          .Case("dotprod", 1ull << 0)
+          .Case("i8mm", 1ull << 1)
+          .Case("bf16", 1ull << 2)
+          .Default(llvm::None);
+    default:
+      return llvm::None;
+  }
+}
+
+llvm::Function *LibraryBuilder::buildVariantQuery(
+    llvm::Module *module, StringRef queryFuncName,
+    ArrayRef<QueryVariant> variants, llvm::Function *baseQueryFunc) {
+  auto &context = module->getContext();
+  auto *i64Type = llvm::IntegerType::getInt64Ty(context);
+  auto *func = llvm::Function::Create(baseQueryFunc->getFunctionType(),
+                                      llvm::GlobalValue::InternalLinkage,
+                                      queryFuncName, *module);
+  auto *maxVersionArg = func->getArg(0);
+  auto *environmentArg = func->getArg(1);
+
+  // The environment is optional and when omitted we use the base library:
+  //   if (!environment) return base_query(max_version, NULL);
+  //   uint64_t data0 = environment->processor.data[0];
+  //   uint64_t l2_cache_kb = (environment->processor.data[1] >> 16) & 0xFFFF;
+  //   if ((data0 & variant0_mask) == variant0_mask &&
+  //       l2_cache_kb >= variant0_l2_cache_kb) {
+  //     return variant0_query(max_version, environment);
+  //   }
+  //   ...
+  //   return base_query(max_version, environment);
+  auto *entryBlock = llvm::BasicBlock::Create(context, "entry", func);
+  auto *selectBlock = llvm::BasicBlock::Create(context, "select", func);
+  auto *baseBlock = llvm::BasicBlock::Create(context, "base", func);
+  llvm::IRBuilder<> builder(entryBlock);
+  builder.CreateCondBr(builder.CreateIsNull(environmentArg), baseBlock,
+                       selectBlock);
+
+  builder.SetInsertPoint(selectBlock);
+  auto *data0 = builder.CreateLoad(
+      i64Type, builder.CreatePointerCast(environmentArg,
+                                         i64Type->getPointerTo()),
+      "processor_data0");
+  llvm::Value *l2CacheSizeKB = nullptr;
+  if (llvm::any_of(variants, [](const QueryVariant &variant) {
+        return variant.l2CacheSizeKB != 0;
+      })) {
+    // IREE_HAL_PROCESSOR_DATA1_L2_CACHE_KB_SHIFT/MASK
+    auto *data1 = builder.CreateLoad(
+        i64Type,
+        builder.CreateConstGEP1_32(
+            i64Type,
+            builder.CreatePointerCast(environmentArg, i64Type->getPointerTo()),
+            1),
+        "processor_data1");
+    l2CacheSizeKB = builder.CreateAnd(builder.CreateLShr(data1, 16), 0xFFFF,
+                                      "l2_cache_kb");
+  }
+  for (auto variant : variants) {
+    auto *mask = llvm::ConstantInt::get(i64Type, variant.processorData0Mask);
+    auto *variantBlock = llvm::BasicBlock::Create(context, "variant", func);
+    auto *nextBlock = llvm::BasicBlock::Create(context, "next", func);
+    auto *condition =
+        builder.CreateICmpEQ(builder.CreateAnd(data0, mask), mask);
+    if (variant.l2CacheSizeKB) {
+      condition = builder.CreateAnd(
+          condition,
+          builder.CreateICmpUGE(
+              l2CacheSizeKB,
+              llvm::ConstantInt::get(i64Type, variant.l2CacheSizeKB)));
+    }
+    builder.CreateCondBr(condition, variantBlock, nextBlock);
+    builder.SetInsertPoint(variantBlock);
+    builder.CreateRet(builder.CreateCall(variant.queryFunc,
+                                         {maxVersionArg, environmentArg}));
+    builder.SetInsertPoint(nextBlock);
+  }
+  builder.CreateBr(baseBlock);
+
+  builder.SetInsertPoint(baseBlock);
+  builder.CreateRet(
+      builder.CreateCall(baseQueryFunc, {maxVersionArg, environmentArg}));
+
+  return func;
+}
+
 llvm::Constant *LibraryBuilder::buildLibraryV0ImportTable(
     std::string libraryName) {
   auto &context = module->getContext();
@@ -311,15 +505,147 @@ llvm::Constant *LibraryBuilder::buildLibraryV0ImportTable(
                        });
 }
 
+// Builds (or returns the existing) range entry point for |dispatchFunc|:
+//   int dispatch_range(const dispatch_state_v0_t* state,
+//                      const workgroup_range_v0_t* range,
+//                      void* local_memory) {
+//     uint32_t workgroup_id[3] = {
+//         range->workgroup_base % count_x,
+//         (range->workgroup_base / count_x) % count_y,
+//         range->workgroup_base / (count_x * count_y)};
+//     for (uint32_t i = 0; i < range->workgroup_count; ++i) {
+//       int ret = dispatch(state, workgroup_id, local_memory);
+//       if (ret) return ret;
+//       if (++workgroup_id[0] == count_x) {
+//         workgroup_id[0] = 0;
+//         if (++workgroup_id[1] == count_y) {
+//           workgroup_id[1] = 0;
+//           ++workgroup_id[2];
+//         }
+//       }
+//     }
+//     return 0;
+//   }
+// The call to |dispatchFunc| is marked always-inline so that LLVM can hoist
+// the per-dispatch loads of the state (bindings, push constants) out of the
+// loop and schedule across workgroup boundaries.
+llvm::Function *LibraryBuilder::buildDispatchRangeFunction(
+    llvm::Function *dispatchFunc) {
+  std::string rangeFuncName = (dispatchFunc->getName() + "_range").str();
+  if (auto *existingFunc = module->getFunction(rangeFuncName)) {
+    return existingFunc;
+  }
+
+  auto &context = module->getContext();
+  auto *dispatchStateType = makeDispatchStateType(context);
+  auto *workgroupRangeType = makeWorkgroupRangeType(context);
+  auto *i32Type = llvm::IntegerType::getInt32Ty(context);
+  auto *workgroupIdType = llvm::ArrayType::get(i32Type, 3);
+  auto *func = llvm::Function::Create(makeDispatchRangeFunctionType(context),
+                                      llvm::GlobalValue::InternalLinkage,
+                                      rangeFuncName, *module);
+  for (StringRef attrName : {"target-cpu", "target-features", "hot"}) {
+    if (dispatchFunc->hasFnAttribute(attrName)) {
+      func->addFnAttr(dispatchFunc->getFnAttribute(attrName));
+    }
+  }
+  if (dispatchFunc->hasFnAttribute(llvm::Attribute::VScaleRange)) {
+    func->addFnAttr(dispatchFunc->getFnAttribute(llvm::Attribute::VScaleRange));
+  }
+  auto *stateArg = func->getArg(0);
+  auto *rangeArg = func->getArg(1);
+  auto *localMemoryArg = func->getArg(2);
+
+  auto *entryBlock = llvm::BasicBlock::Create(context, "entry", func);
+  auto *loopBlock = llvm::BasicBlock::Create(context, "loop", func);
+  auto *continueBlock = llvm::BasicBlock::Create(context, "continue", func);
+  auto *errorBlock = llvm::BasicBlock::Create(context, "error", func);
+  auto *exitBlock = llvm::BasicBlock::Create(context, "exit", func);
+  llvm::IRBuilder<> builder(entryBlock);
+  auto *zero = llvm::ConstantInt::get(i32Type, 0);
+  auto *one = llvm::ConstantInt::get(i32Type, 1);
+  auto *two = llvm::ConstantInt::get(i32Type, 2);
+
+  auto *workgroupBase = builder.CreateLoad(
+      i32Type, builder.CreateStructGEP(workgroupRangeType, rangeArg, 0),
+      "workgroup_base");
+  auto *workgroupCount = builder.CreateLoad(
+      i32Type, builder.CreateStructGEP(workgroupRangeType, rangeArg, 1),
+      "workgroup_count");
+  auto *countX = builder.CreateLoad(
+      i32Type,
+      builder.CreateInBoundsGEP(dispatchStateType, stateArg,
+                                {zero, zero, zero}),
+      "workgroup_count_x");
+  auto *countY = builder.CreateLoad(
+      i32Type,
+      builder.CreateInBoundsGEP(dispatchStateType, stateArg, {zero, zero, one}),
+      "workgroup_count_y");
+  auto *workgroupId = builder.CreateAlloca(workgroupIdType, nullptr,
+                                           "workgroup_id");
+  auto *initialYZ = builder.CreateUDiv(workgroupBase, countX);
+  auto *initialX = builder.CreateURem(workgroupBase, countX);
+  auto *initialY = builder.CreateURem(initialYZ, countY);
+  auto *initialZ = builder.CreateUDiv(initialYZ, countY);
+  builder.CreateCondBr(builder.CreateICmpEQ(workgroupCount, zero), exitBlock,
+                       loopBlock);
+
+  builder.SetInsertPoint(loopBlock);
+  auto *i = builder.CreatePHI(i32Type, 2, "i");
+  auto *x = builder.CreatePHI(i32Type, 2, "x");
+  auto *y = builder.CreatePHI(i32Type, 2, "y");
+  auto *z = builder.CreatePHI(i32Type, 2, "z");
+  i->addIncoming(zero, entryBlock);
+  x->addIncoming(initialX, entryBlock);
+  y->addIncoming(initialY, entryBlock);
+  z->addIncoming(initialZ, entryBlock);
+  builder.CreateStore(
+      x, builder.CreateInBoundsGEP(workgroupIdType, workgroupId, {zero, zero}));
+  builder.CreateStore(
+      y, builder.CreateInBoundsGEP(workgroupIdType, workgroupId, {zero, one}));
+  builder.CreateStore(
+      z, builder.CreateInBoundsGEP(workgroupIdType, workgroupId, {zero, two}));
+  auto *call = builder.CreateCall(
+      dispatchFunc, {stateArg, workgroupId, localMemoryArg});
+  call->addFnAttr(llvm::Attribute::AlwaysInline);
+  builder.CreateCondBr(builder.CreateICmpNE(call, zero), errorBlock,
+                       continueBlock);
+
+  builder.SetInsertPoint(errorBlock);
+  builder.CreateRet(call);
+
+  builder.SetInsertPoint(continueBlock);
+  auto *nextX = builder.CreateAdd(x, one);
+  auto *wrapX = builder.CreateICmpEQ(nextX, countX);
+  auto *carryY = builder.CreateAdd(y, builder.CreateZExt(wrapX, i32Type));
+  auto *wrapY = builder.CreateICmpEQ(carryY, countY);
+  auto *nextI = builder.CreateAdd(i, one);
+  i->addIncoming(nextI, continueBlock);
+  x->addIncoming(builder.CreateSelect(wrapX, zero, nextX), continueBlock);
+  y->addIncoming(builder.CreateSelect(wrapY, zero, carryY), continueBlock);
+  z->addIncoming(builder.CreateAdd(z, builder.CreateZExt(wrapY, i32Type)),
+                 continueBlock);
+  builder.CreateCondBr(builder.CreateICmpEQ(nextI, workgroupCount), exitBlock,
+                       loopBlock);
+
+  builder.SetInsertPoint(exitBlock);
+  builder.CreateRet(zero);
+
+  return func;
+}
+
 llvm::Constant *LibraryBuilder::buildLibraryV0ExportTable(
     std::string libraryName) {
   auto &context = module->getContext();
   auto *exportTableType = makeExportTableType(context);
   auto *dispatchFunctionType = makeDispatchFunctionType(context);
   auto *dispatchAttrsType = makeDispatchAttrsType(context);
+  auto *dispatchCostType = makeDispatchCostType(context);
+  auto *dispatchRangeFunctionType = makeDispatchRangeFunctionType(context);
   auto *i8Type = llvm::IntegerType::getInt8Ty(context);
   auto *i16Type = llvm::IntegerType::getInt16Ty(context);
   auto *i32Type = llvm::IntegerType::getInt32Ty(context);
+  auto *i64Type = llvm::IntegerType::getInt64Ty(context);
   llvm::Constant *zero = llvm::ConstantInt::get(i32Type, 0);
 
   // iree_hal_executable_export_table_v0_t::ptrs
@@ -345,7 +671,7 @@ llvm::Constant *LibraryBuilder::buildLibraryV0ExportTable(
       llvm::find_if(exports, [](const Dispatch &dispatch) {
         return !dispatch.attrs.isDefault();
       }) != exports.end();
-  if (!hasNonDefaultAttrs) {
+  if (hasNonDefaultAttrs) {
     SmallVector<llvm::Constant *, 4> exportAttrValues;
     for (auto dispatch : exports) {
       exportAttrValues.push_back(llvm::ConstantStruct::get(
@@ -356,8 +682,15 @@ llvm::Constant *LibraryBuilder::buildLibraryV0ExportTable(
                   i16Type, RoundUpToAlignment(dispatch.attrs.localMemorySize,
                                               kWorkgroupLocalMemoryPageSize) /
                                kWorkgroupLocalMemoryPageSize),
-              // reserved=
-              llvm::ConstantInt::get(i16Type, 0),
+              // workgroup_grain_size=
+              llvm::ConstantInt::get(
+                  i8Type, std::min<int64_t>(dispatch.attrs.workgroupGrainSize,
+                                            UINT8_MAX)),
+              // flags=
+              llvm::ConstantInt::get(
+                  i8Type, dispatch.attrs.preserveDenormals
+                              ? kDispatchFlagPreserveDenormals
+                              : 0),
           }));
     }
     auto *exportAttrsType =
@@ -412,6 +745,64 @@ llvm::Constant *LibraryBuilder::buildLibraryV0ExportTable(
         exportTagsType, global, ArrayRef<llvm::Constant *>{zero, zero});
   }
 
+  // iree_hal_executable_export_table_v0_t::costs
+  llvm::Constant *exportCosts =
+      llvm::Constant::getNullValue(dispatchCostType->getPointerTo());
+  bool hasNonDefaultCosts =
+      llvm::find_if(exports, [](const Dispatch &dispatch) {
+        return !dispatch.cost.isDefault();
+      }) != exports.end();
+  if (hasNonDefaultCosts) {
+    SmallVector<llvm::Constant *, 4> exportCostValues;
+    for (auto dispatch : exports) {
+      exportCostValues.push_back(llvm::ConstantStruct::get(
+          dispatchCostType,
+          {
+              // flop_count=
+              llvm::ConstantInt::get(i64Type, dispatch.cost.flopCount),
+              // read_byte_count=
+              llvm::ConstantInt::get(i64Type, dispatch.cost.readByteCount),
+              // write_byte_count=
+              llvm::ConstantInt::get(i64Type, dispatch.cost.writeByteCount),
+              // workgroup_count=
+              llvm::ConstantInt::get(
+                  i32Type, std::min<int64_t>(dispatch.cost.workgroupCount,
+                                             UINT32_MAX)),
+              // reserved=
+              llvm::ConstantInt::get(i32Type, 0),
+          }));
+    }
+    auto *exportCostsType =
+        llvm::ArrayType::get(dispatchCostType, exportCostValues.size());
+    auto *global = new llvm::GlobalVariable(
+        *module, exportCostsType, /*isConstant=*/true,
+        llvm::GlobalVariable::PrivateLinkage,
+        llvm::ConstantArray::get(exportCostsType, exportCostValues),
+        /*Name=*/libraryName + "_costs");
+    exportCosts = llvm::ConstantExpr::getInBoundsGetElementPtr(
+        exportCostsType, global, ArrayRef<llvm::Constant *>{zero, zero});
+  }
+
+  // iree_hal_executable_export_table_v0_t::range_ptrs
+  llvm::Constant *exportRangePtrs = llvm::Constant::getNullValue(
+      dispatchRangeFunctionType->getPointerTo()->getPointerTo());
+  if (emitRangeEntryPoints && !exports.empty()) {
+    SmallVector<llvm::Constant *, 4> exportRangePtrValues;
+    for (auto dispatch : exports) {
+      exportRangePtrValues.push_back(buildDispatchRangeFunction(dispatch.func));
+    }
+    auto *exportRangePtrsType =
+        llvm::ArrayType::get(dispatchRangeFunctionType->getPointerTo(),
+                             exportRangePtrValues.size());
+    auto *global = new llvm::GlobalVariable(
+        *module, exportRangePtrsType, /*isConstant=*/true,
+        llvm::GlobalVariable::PrivateLinkage,
+        llvm::ConstantArray::get(exportRangePtrsType, exportRangePtrValues),
+        /*Name=*/libraryName + "_range_funcs");
+    exportRangePtrs = llvm::ConstantExpr::getInBoundsGetElementPtr(
+        exportRangePtrsType, global, ArrayRef<llvm::Constant *>{zero, zero});
+  }
+
   return llvm::ConstantStruct::get(
       exportTableType, {
                            // count=
@@ -424,6 +815,10 @@ llvm::Constant *LibraryBuilder::buildLibraryV0ExportTable(
                            exportNames,
                            // tags=
                            exportTags,
+                           // costs=
+                           exportCosts,
+                           // range_ptrs=
+                           exportRangePtrs,
                        });
 }
 
@@ -11,6 +11,7 @@
 #include <string>
 
 #include "iree/compiler/Dialect/HAL/Target/LLVM/LLVMTargetOptions.h"
+#include "llvm/ADT/Optional.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/IR/Module.h"
 #include "mlir/Support/LogicalResult.h"
@@ -68,16 +69,59 @@ class LibraryBuilder {
     UNDEFINED = 4u,
   };
 
+  // A library query function that may be selected at runtime when the hosting
+  // processor supports all features in |processorData0Mask| and has an L2
+  // cache of at least |l2CacheSizeKB|.
+  struct QueryVariant {
+    // Mask of IREE_HAL_PROCESSOR_DATA0_* bits required by the variant.
+    uint64_t processorData0Mask = 0;
+    // iree_hal_executable_library_query_fn_t of the variant library.
+    llvm::Function *queryFunc = nullptr;
+    // Minimum IREE_HAL_PROCESSOR_DATA1_L2_CACHE_KB required by the variant or
+    // 0 if the variant can run with any cache size.
+    uint32_t l2CacheSizeKB = 0;
+  };
+
   // IREE_HAL_WORKGROUP_LOCAL_MEMORY_PAGE_SIZE
   static const int64_t kWorkgroupLocalMemoryPageSize = 4096;
 
+  // IREE_HAL_EXECUTABLE_DISPATCH_FLAG_V0_PRESERVE_DENORMALS
+  static const uint8_t kDispatchFlagPreserveDenormals = 1u << 0;
+
   // iree_hal_executable_dispatch_attrs_v0_t
   struct DispatchAttrs {
     // Required workgroup local memory size, in bytes.
     int64_t localMemorySize = 0;
+    // Suggested number of workgroups to schedule together or 0 to let the
+    // runtime decide. Clamped to 255.
+    int64_t workgroupGrainSize = 0;
+    // True if the dispatch requires IEEE denormal behavior instead of the
+    // flush-to-zero mode the runtime uses by default.
+    bool preserveDenormals = false;
 
     // True if all values are default and the attributes may be omitted.
-    constexpr bool isDefault() const { return localMemorySize == 0; }
+    constexpr bool isDefault() const {
+      return localMemorySize == 0 && workgroupGrainSize == 0 &&
+             !preserveDenormals;
+    }
+  };
+
+  // iree_hal_executable_dispatch_cost_v0_t
+  struct DispatchCost {
+    // Estimated number of arithmetic operations per dispatch or 0 if unknown.
+    int64_t flopCount = 0;
+    // Estimated number of bytes read from bindings or 0 if unknown.
+    int64_t readByteCount = 0;
+    // Estimated number of bytes written to bindings or 0 if unknown.
+    int64_t writeByteCount = 0;
+    // Total number of workgroups or 0 if dependent on the workload.
+    int64_t workgroupCount = 0;
+
+    // True if all values are unknown and the cost may be omitted.
+    constexpr bool isDefault() const {
+      return flopCount == 0 && readByteCount == 0 && writeByteCount == 0 &&
+             workgroupCount == 0;
+    }
   };
 
   LibraryBuilder(llvm::Module *module, Mode mode,
@@ -97,6 +141,12 @@ class LibraryBuilder {
     this->sanitizerKind = sanitizerKind;
   }
 
+  // Sets whether each export is also emitted as a workgroup-range entry point
+  // that runs a contiguous range of workgroups in a single call.
+  void setEmitRangeEntryPoints(bool emitRangeEntryPoints) {
+    this->emitRangeEntryPoints = emitRangeEntryPoints;
+  }
+
   // Defines a new runtime import function and returns its ordinal.
   unsigned addImport(StringRef name, bool weak) {
     imports.push_back({name.str(), weak});
@@ -105,10 +155,11 @@ class LibraryBuilder {
 
   // Defines a new entry point on the library implemented by |func|.
   // |name| will be used as the library export and an optional |tag| will be
-  // attached.
+  // attached. An optional compiler-estimated |cost| will be recorded in the
+  // export table for use by runtime schedulers and tooling.
   void addExport(StringRef name, StringRef tag, DispatchAttrs attrs,
-                 llvm::Function *func) {
-    exports.push_back({name.str(), tag.str(), attrs, func});
+                 llvm::Function *func, DispatchCost cost = {}) {
+    exports.push_back({name.str(), tag.str(), attrs, func, cost});
   }
 
   // Builds a `iree_hal_executable_library_query_fn_t` with the given
@@ -121,17 +172,37 @@ class LibraryBuilder {
   // unit, etc).
   llvm::Function *build(StringRef queryFuncName);
 
+  // Returns the IREE_HAL_PROCESSOR_DATA0_* bit for the LLVM target |feature|
+  // (such as `avx2`) on |arch| or None if the runtime does not query it.
+  static llvm::Optional<uint64_t> getProcessorData0Bit(
+      llvm::Triple::ArchType arch, StringRef feature);
+
+  // Builds a `iree_hal_executable_library_query_fn_t` with the given
+  // |queryFuncName| that forwards to the first of |variants| supported by the
+  // processor in the environment provided by the runtime and otherwise to
+  // |baseQueryFunc|. Variants are checked in order and should be listed from
+  // most to least specialized.
+  //
+  // The returned function will be inserted into |module| with internal linkage
+  // as with build.
+  static llvm::Function *buildVariantQuery(llvm::Module *module,
+                                           StringRef queryFuncName,
+                                           ArrayRef<QueryVariant> variants,
+                                           llvm::Function *baseQueryFunc);
+
  private:
   // Builds and returns an iree_hal_executable_library_v0_t global constant.
   llvm::Constant *buildLibraryV0(std::string libraryName);
   llvm::Constant *buildLibraryV0ImportTable(std::string libraryName);
   llvm::Constant *buildLibraryV0ExportTable(std::string libraryName);
+  llvm::Function *buildDispatchRangeFunction(llvm::Function *dispatchFunc);
 
   llvm::Module *module = nullptr;
   Mode mode = Mode::INCLUDE_REFLECTION_ATTRS;
   Version version = Version::V_0;
   Features features = Features::NONE;
   SanitizerKind sanitizerKind = SanitizerKind::NONE;
+  bool emitRangeEntryPoints = true;
 
   struct Import {
     std::string symbol_name;
@@ -144,6 +215,7 @@ class LibraryBuilder {
     std::string tag;
     DispatchAttrs attrs;
     llvm::Function *func;
+    DispatchCost cost;
   };
   SmallVector<Dispatch> exports;
 };
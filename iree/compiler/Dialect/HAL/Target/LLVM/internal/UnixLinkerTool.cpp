@@ -86,6 +86,13 @@ class UnixLinkerTool : public LinkerTool {
       flags.push_back(objectFile.path);
     }
 
+    // Executables instrumented for profile-guided optimization carry their own
+    // copy of the profile runtime. Its libc dependencies are resolved against
+    // the hosting process when the library is loaded.
+    if (!targetOptions.pgoInstrumentProfileFile.empty()) {
+      flags.push_back(targetOptions.pgoRuntimeLibrary);
+    }
+
     auto commandLine = llvm::join(flags, " ");
     if (failed(runLinkCommand(commandLine))) return llvm::None;
     return artifacts;
@@ -5,6 +5,8 @@
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
 #include "iree/compiler/Dialect/HAL/Target/LLVM/LinkerTool.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/Support/FormatVariadic.h"
@@ -16,6 +18,14 @@ namespace iree_compiler {
 namespace IREE {
 namespace HAL {
 
+// Splits a comma-separated LLVM feature string such as `+simd128,+atomics`.
+static SmallVector<StringRef> splitFeatures(StringRef features) {
+  SmallVector<StringRef> result;
+  features.split(result, ',', /*MaxSplit=*/-1, /*KeepEmpty=*/false);
+  for (auto &feature : result) feature = feature.trim();
+  return result;
+}
+
 // Wasm linker using wasm-ld for producing WebAssembly binaries.
 // wasm-ld behaves like traditional ELF linkers and uses similar flags.
 //
@@ -54,8 +64,8 @@ class WasmLinkerTool : public LinkerTool {
       llvm::Module *llvmModule,
       ArrayRef<llvm::Function *> exportedFuncs) override {
     // https://lld.llvm.org/WebAssembly.html#exports
-    // Note: once we can set --shared this shouldn't be needed, since we set
-    // default visibility on exported functions.
+    // Note: --shared already exports functions with default visibility; the
+    // explicit export names keep the exports independent of visibility.
     for (auto func : exportedFuncs) {
       func->addFnAttr("wasm-export-name", func->getName());
     }
@@ -86,13 +96,23 @@ class WasmLinkerTool : public LinkerTool {
         // Treat warnings as errors.
         "--fatal-warnings",
 
-        // Generated a shared object, not an executable.
-        // Note: disabled since creating shared libraries is not yet supported.
-        // "--shared",
+        // Generate a shared object, not an executable. The result is a side
+        // module that Emscripten programs linked with -sMAIN_MODULE can
+        // dlopen; all code is already generated as position independent.
+        "--shared",
+        "--experimental-pic",
 
         "-o " + artifacts.libraryFile.path,
     };
 
+    // Side modules loaded into multithreaded programs must import the shared
+    // memory of the main module used by all of its web workers. This requires
+    // the +atomics,+bulk-memory features.
+    if (llvm::is_contained(splitFeatures(targetOptions.targetCPUFeatures),
+                           "+atomics")) {
+      flags.push_back("--shared-memory");
+    }
+
     // Strip debug information when not requested.
     if (!targetOptions.debugSymbols) {
       flags.push_back("--strip-debug");
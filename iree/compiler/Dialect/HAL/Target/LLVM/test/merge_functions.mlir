@@ -0,0 +1,88 @@
+// RUN: iree-opt -iree-stream-transformation-pipeline -iree-hal-transformation-pipeline -print-after=rel-lookup-table-converter %s 2>&1 | FileCheck %s --check-prefix=ON
+// RUN: iree-opt -iree-stream-transformation-pipeline -iree-hal-transformation-pipeline -iree-llvm-merge-functions=false -print-after=rel-lookup-table-converter %s 2>&1 | FileCheck %s --check-prefix=OFF
+
+// Tests that identical functions and constant tables from the executables
+// linked into one library are emitted once. The LLVM IR is checked after the
+// last pass of the optimization pipeline as it is what gets emitted into the
+// library.
+
+module attributes {
+  hal.device.targets = [
+    #hal.device.target<"dylib", {
+      executable_targets = [
+        #hal.executable.target<"llvm", "embedded-elf-x86_64">
+      ]
+    }>
+  ]
+} {
+
+stream.executable public @lookup_dispatch_0 {
+  stream.executable.export @lookup_dispatch_0
+  builtin.module  {
+    func @lookup_dispatch_0(%arg0_binding: !stream.binding, %arg1_binding: !stream.binding) {
+      %c0 = arith.constant 0 : index
+      %table = arith.constant dense<[3.0, 1.0, 4.0, 1.0, 5.0, 9.0, 2.0, 6.0, 5.0, 3.0, 5.0, 8.0, 9.0, 7.0, 9.0, 3.0]> : tensor<16xf32>
+      %arg0 = stream.binding.subspan %arg0_binding[%c0] : !stream.binding -> !flow.dispatch.tensor<readonly:16xi32>
+      %arg1 = stream.binding.subspan %arg1_binding[%c0] : !stream.binding -> !flow.dispatch.tensor<writeonly:16xf32>
+      %0 = linalg.init_tensor [16] : tensor<16xf32>
+      %1 = flow.dispatch.tensor.load %arg0, offsets=[0], sizes=[16], strides=[1] : !flow.dispatch.tensor<readonly:16xi32> -> tensor<16xi32>
+      %2 = linalg.generic {indexing_maps = [affine_map<(d0) -> (d0)>, affine_map<(d0) -> (d0)>], iterator_types = ["parallel"]} ins(%1 : tensor<16xi32>) outs(%0 : tensor<16xf32>) {
+      ^bb0(%arg2: i32, %arg3: f32):
+        %3 = arith.index_cast %arg2 : i32 to index
+        %4 = tensor.extract %table[%3] : tensor<16xf32>
+        linalg.yield %4 : f32
+      } -> tensor<16xf32>
+      flow.dispatch.tensor.store %2, %arg1, offsets=[0], sizes=[16], strides=[1] : tensor<16xf32> -> !flow.dispatch.tensor<writeonly:16xf32>
+      return
+    }
+  }
+}
+
+stream.executable public @lookup_dispatch_1 {
+  stream.executable.export @lookup_dispatch_1
+  builtin.module  {
+    func @lookup_dispatch_1(%arg0_binding: !stream.binding, %arg1_binding: !stream.binding) {
+      %c0 = arith.constant 0 : index
+      %table = arith.constant dense<[3.0, 1.0, 4.0, 1.0, 5.0, 9.0, 2.0, 6.0, 5.0, 3.0, 5.0, 8.0, 9.0, 7.0, 9.0, 3.0]> : tensor<16xf32>
+      %arg0 = stream.binding.subspan %arg0_binding[%c0] : !stream.binding -> !flow.dispatch.tensor<readonly:16xi32>
+      %arg1 = stream.binding.subspan %arg1_binding[%c0] : !stream.binding -> !flow.dispatch.tensor<writeonly:16xf32>
+      %0 = linalg.init_tensor [16] : tensor<16xf32>
+      %1 = flow.dispatch.tensor.load %arg0, offsets=[0], sizes=[16], strides=[1] : !flow.dispatch.tensor<readonly:16xi32> -> tensor<16xi32>
+      %2 = linalg.generic {indexing_maps = [affine_map<(d0) -> (d0)>, affine_map<(d0) -> (d0)>], iterator_types = ["parallel"]} ins(%1 : tensor<16xi32>) outs(%0 : tensor<16xf32>) {
+      ^bb0(%arg2: i32, %arg3: f32):
+        %3 = arith.index_cast %arg2 : i32 to index
+        %4 = tensor.extract %table[%3] : tensor<16xf32>
+        linalg.yield %4 : f32
+      } -> tensor<16xf32>
+      flow.dispatch.tensor.store %2, %arg1, offsets=[0], sizes=[16], strides=[1] : tensor<16xf32> -> !flow.dispatch.tensor<writeonly:16xf32>
+      return
+    }
+  }
+}
+
+}
+
+// Both executables are linked into a single library.
+// ON: IR Dump After RelLookupTableConverterPass
+// OFF: IR Dump After RelLookupTableConverterPass
+
+// The constant tables are merged regardless of -iree-llvm-merge-functions.
+// ON: @[[TABLE:[^ ]+]] = private unnamed_addr constant [16 x float] [float 3.000000e+00
+// ON-NOT: private unnamed_addr constant [16 x float]
+// OFF: @[[TABLE:[^ ]+]] = private unnamed_addr constant [16 x float] [float 3.000000e+00
+// OFF-NOT: private unnamed_addr constant [16 x float]
+
+// With function merging the second dispatch function is reduced to a thunk
+// calling the first one; the library export table still needs both.
+// ON: define internal {{.+}} @lookup_dispatch_0(
+// ON: @[[TABLE]]
+// ON: define internal {{.+}} @lookup_dispatch_1(
+// ON-NEXT: tail call {{.+}} @lookup_dispatch_0(
+// ON-NEXT: ret
+
+// Without it both function bodies are kept.
+// OFF: define internal {{.+}} @lookup_dispatch_0(
+// OFF: @[[TABLE]]
+// OFF: define internal {{.+}} @lookup_dispatch_1(
+// OFF-NOT: tail call {{.+}} @lookup_dispatch_0(
+// OFF: @[[TABLE]]
@@ -1,5 +1,6 @@
 // RUN: iree-opt -split-input-file -iree-stream-transformation-pipeline -iree-hal-transformation-pipeline %s | FileCheck %s
 // RUN: iree-opt -split-input-file -iree-stream-transformation-pipeline -iree-hal-transformation-pipeline -iree-llvm-link-embedded=false %s | FileCheck %s
+// RUN: iree-opt -split-input-file -iree-stream-transformation-pipeline -iree-hal-transformation-pipeline -iree-llvm-target-cpu-feature-tier=+avx512f,+avx512bw -iree-llvm-target-cpu-feature-tier=+avx2,+fma %s | FileCheck %s
 
 #map = affine_map<(d0) -> (d0)>
 
@@ -8,9 +8,17 @@
 
 #include <algorithm>
 
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/FileUtilities.h"
 #include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/SHA1.h"
 #include "mlir/IR/Dialect.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/Parser.h"
 
 namespace mlir {
 namespace iree_compiler {
@@ -29,6 +37,28 @@ void TargetOptions::bindOptions(OptionsBinder &binder) {
       "iree-hal-target-backends", targets,
       llvm::cl::desc("Target backends for executable compilation"),
       llvm::cl::ZeroOrMore, llvm::cl::cat(halTargetOptionsCategory));
+
+  binder.opt<std::string>(
+      "iree-hal-executable-cache-dir", executableCacheDir,
+      llvm::cl::desc(
+          "Directory used to cache translated executables across "
+          "compilations. Entries are not invalidated when the compiler itself "
+          "changes and the directory should be cleared on upgrade."),
+      llvm::cl::cat(halTargetOptionsCategory));
+
+  binder.opt<bool>(
+      "iree-hal-memoize-command-buffers", memoizeCommandBuffers,
+      llvm::cl::desc(
+          "Records command buffers with invocation-invariant commands once at "
+          "initialization time and reuses them on each invocation."),
+      llvm::cl::cat(halTargetOptionsCategory));
+
+  binder.opt<bool>(
+      "iree-hal-pack-command-buffers", packCommandBuffers,
+      llvm::cl::desc(
+          "Packs runs of command buffer commands into constant command streams "
+          "recorded with a single call to reduce VM call overhead."),
+      llvm::cl::cat(halTargetOptionsCategory));
 }
 
 // Renames |op| within |moduleOp| with a new name that is unique within both
@@ -222,6 +252,115 @@ LogicalResult TargetBackend::linkExecutablesInto(
   return success();
 }
 
+std::string getExecutableCachePath(StringRef cacheDir,
+                                   const TargetBackend &targetBackend,
+                                   IREE::HAL::ExecutableVariantOp variantOp) {
+  std::string key;
+  llvm::raw_string_ostream os(key);
+  os << "iree-hal-v1;" << LLVM_VERSION_STRING << ";" << targetBackend.name()
+     << ";";
+  targetBackend.appendCacheKey(os);
+  os << "\n";
+  // Locations are excluded so that edits elsewhere in the source program do
+  // not invalidate every executable; cached translations retain the locations
+  // of the compilation that produced them. Printing in a local scope avoids
+  // walking the parent module that other threads may be modifying.
+  OpPrintingFlags flags;
+  flags.useLocalScope();
+  variantOp->print(os, flags);
+  os.flush();
+  auto hash = llvm::SHA1::hash(llvm::arrayRefFromStringRef(key));
+  SmallString<256> path(cacheDir);
+  llvm::sys::path::append(path,
+                          llvm::toHex(hash, /*LowerCase=*/true) + ".mlir");
+  return path.str().str();
+}
+
+LogicalResult loadCachedExecutableVariant(
+    StringRef cachePath, IREE::HAL::ExecutableVariantOp variantOp) {
+  if (!llvm::sys::fs::exists(cachePath)) return failure();
+  Block block;
+  if (failed(parseSourceFile(cachePath, &block, variantOp.getContext()))) {
+    return variantOp.emitError()
+           << "failed to parse executable cache entry " << cachePath
+           << "; the cache may be from an incompatible compiler";
+  }
+  auto cachedOp = dyn_cast<IREE::HAL::ExecutableVariantOp>(block.front());
+  if (!cachedOp || cachedOp.sym_name() != variantOp.sym_name()) {
+    return variantOp.emitError()
+           << "executable cache entry " << cachePath
+           << " does not contain a translation of the variant";
+  }
+  variantOp->setAttrs(cachedOp->getAttrDictionary());
+  variantOp.body().takeBody(cachedOp.body());
+  return success();
+}
+
+void storeCachedExecutableVariant(StringRef cachePath,
+                                  IREE::HAL::ExecutableVariantOp variantOp) {
+  std::string contents;
+  llvm::raw_string_ostream os(contents);
+  OpPrintingFlags flags;
+  flags.useLocalScope();
+  flags.enableDebugInfo();
+  variantOp->print(os, flags);
+  os.flush();
+  // Entries are written atomically so that concurrent compilations sharing
+  // the directory never observe partial files.
+  llvm::sys::fs::create_directories(llvm::sys::path::parent_path(cachePath));
+  auto error = llvm::writeFileAtomically((cachePath + ".tmp%%%%%%%%").str(),
+                                         cachePath, contents);
+  if (error) {
+    mlir::emitWarning(variantOp.getLoc())
+        << "failed to write executable cache entry " << cachePath << ": "
+        << llvm::toString(std::move(error));
+  }
+}
+
+static constexpr char kDispatchCostAttrName[] = "hal.dispatch.cost";
+
+void setDispatchCost(IREE::HAL::ExecutableEntryPointOp entryPointOp,
+                     const DispatchCost &cost) {
+  Builder builder(entryPointOp.getContext());
+  entryPointOp->setAttr(
+      kDispatchCostAttrName,
+      builder.getDictionaryAttr({
+          builder.getNamedAttr("flops",
+                               builder.getI64IntegerAttr(cost.flopCount)),
+          builder.getNamedAttr("read_bytes",
+                               builder.getI64IntegerAttr(cost.readByteCount)),
+          builder.getNamedAttr("write_bytes",
+                               builder.getI64IntegerAttr(cost.writeByteCount)),
+      }));
+}
+
+DispatchCost getDispatchCost(IREE::HAL::ExecutableEntryPointOp entryPointOp) {
+  DispatchCost cost;
+  if (auto costAttr =
+          entryPointOp->getAttrOfType<DictionaryAttr>(kDispatchCostAttrName)) {
+    auto getValue = [&](StringRef name) -> int64_t {
+      auto valueAttr = costAttr.getAs<IntegerAttr>(name);
+      return valueAttr ? valueAttr.getInt() : 0;
+    };
+    cost.flopCount = getValue("flops");
+    cost.readByteCount = getValue("read_bytes");
+    cost.writeByteCount = getValue("write_bytes");
+  }
+  if (Block *block = entryPointOp.getBlock()) {
+    int64_t workgroupCount = 1;
+    for (Value value : block->getTerminator()->getOperands()) {
+      APInt count;
+      if (!matchPattern(value, m_ConstantInt(&count))) {
+        workgroupCount = 0;
+        break;
+      }
+      workgroupCount *= count.getSExtValue();
+    }
+    cost.workgroupCount = workgroupCount;
+  }
+  return cost;
+}
+
 }  // namespace HAL
 }  // namespace IREE
 }  // namespace iree_compiler
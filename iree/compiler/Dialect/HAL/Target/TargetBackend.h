@@ -36,6 +36,22 @@ struct TargetOptions {
   // the best we can do is a coarse flag as to whether source maps should be
   // embedded, however we could be much better here on the TargetBackend
   // interface.
+
+  // Directory used to persist translated executables across compilations.
+  // Variants whose source IR, target, and backend configuration are unchanged
+  // reuse the cached translation instead of running the backend pipeline.
+  // Empty to disable the cache.
+  std::string executableCacheDir;
+
+  // Records command buffers whose commands are the same on every invocation
+  // once at initialization time as reusable command buffers and only submits
+  // them at runtime. Requires devices that support reusable command buffers.
+  bool memoizeCommandBuffers = false;
+
+  // Packs runs of command buffer commands into constant command streams that
+  // are recorded with a single hal.command_buffer.execute_commands call.
+  bool packCommandBuffers = false;
+
   void bindOptions(OptionsBinder &binder);
   using FromFlags = OptionsFromFlags<TargetOptions>;
 };
@@ -119,6 +135,11 @@ class TargetBackend {
   virtual IREE::HAL::DeviceTargetAttr getDefaultDeviceTarget(
       MLIRContext *context) const = 0;
 
+  // Appends backend configuration that changes the result of translation or
+  // serialization but is not captured by the executable target attribute (such
+  // as command line flags) to |os|. Used to key persistent executable caches.
+  virtual void appendCacheKey(llvm::raw_ostream &os) const {}
+
   // Inserts passes used to translate the `hal.executable.variant` op contents.
   // The pass manager will be nested on `hal.executable` such that the pipeline
   // will only run on executable contents.
@@ -219,6 +240,53 @@ class TargetBackend {
       OpBuilder &builder);
 };
 
+// Compiler-estimated cost of a single dispatch of an entry point.
+// Values are 0 when unknown. Mirrors iree_hal_executable_dispatch_cost_v0_t and
+// may be serialized by target backends into their executable formats.
+struct DispatchCost {
+  // Estimated number of arithmetic operations.
+  int64_t flopCount = 0;
+  // Estimated number of bytes read from bindings.
+  int64_t readByteCount = 0;
+  // Estimated number of bytes written to bindings.
+  int64_t writeByteCount = 0;
+  // Total number of workgroups or 0 if dependent on the workload.
+  int64_t workgroupCount = 0;
+
+  // True if all values are unknown.
+  bool isDefault() const {
+    return flopCount == 0 && readByteCount == 0 && writeByteCount == 0 &&
+           workgroupCount == 0;
+  }
+};
+
+// Attaches |cost| to |entryPointOp| as a `hal.dispatch.cost` attribute.
+void setDispatchCost(IREE::HAL::ExecutableEntryPointOp entryPointOp,
+                     const DispatchCost &cost);
+
+// Returns the cost of |entryPointOp| as annotated by the
+// AnnotateDispatchCosts pass. The workgroup count is derived from the
+// workgroup count region when it returns constant values independent of the
+// workload.
+DispatchCost getDispatchCost(IREE::HAL::ExecutableEntryPointOp entryPointOp);
+
+// Returns the path of the entry in |cacheDir| holding the translation of
+// |variantOp| by |targetBackend|. Must be called prior to translation as the
+// entry is keyed on the source contents of the variant.
+std::string getExecutableCachePath(StringRef cacheDir,
+                                   const TargetBackend &targetBackend,
+                                   IREE::HAL::ExecutableVariantOp variantOp);
+
+// Replaces the contents of |variantOp| with the translated variant stored at
+// |cachePath|. Returns failure if no entry exists.
+LogicalResult loadCachedExecutableVariant(
+    StringRef cachePath, IREE::HAL::ExecutableVariantOp variantOp);
+
+// Stores the translated |variantOp| at |cachePath|. Failing to write the entry
+// is reported as a warning as only the reuse is lost.
+void storeCachedExecutableVariant(StringRef cachePath,
+                                  IREE::HAL::ExecutableVariantOp variantOp);
+
 }  // namespace HAL
 }  // namespace IREE
 }  // namespace iree_compiler
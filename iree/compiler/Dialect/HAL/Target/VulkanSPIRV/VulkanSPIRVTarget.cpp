@@ -16,6 +16,7 @@
 #include "iree/schemas/spirv_executable_def_builder.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/FormatVariadic.h"
@@ -84,10 +85,17 @@ VulkanSPIRVTargetOptions getVulkanSPIRVTargetOptionsFromFlags() {
       llvm::cl::desc("Save SPIR-V shader modules to disk separately"),
       llvm::cl::init(false));
 
+  static llvm::cl::opt<bool> clVulkanSpecializePushConstants(
+      "iree-vulkan-specialize-push-constants",
+      llvm::cl::desc("Allow the runtime to specialize pipelines on recurring "
+                     "push constant values (such as dynamic dimensions)"),
+      llvm::cl::init(false));
+
   VulkanSPIRVTargetOptions targetOptions;
   targetOptions.vulkanTargetEnv = clVulkanTargetEnv;
   targetOptions.vulkanTargetTriple = clVulkanTargetTriple;
   targetOptions.keepShaderModules = clVulkanKeepShaderModules;
+  targetOptions.specializePushConstants = clVulkanSpecializePushConstants;
 
   return targetOptions;
 }
@@ -156,7 +164,8 @@ class VulkanSPIRVTargetBackend : public TargetBackend {
   }
 
   void buildTranslationPassPipeline(OpPassManager &passManager) override {
-    buildSPIRVCodegenPassPipeline(passManager);
+    buildSPIRVCodegenPassPipeline(passManager,
+                                  options_.specializePushConstants);
   }
 
   // TODO(antiagainst): Re-enable SPIR-V linking once the tensorflow integration
@@ -303,8 +312,48 @@ class VulkanSPIRVTargetBackend : public TargetBackend {
     });
     auto entryPointsRef = builder.createStringVec(entryPointNames);
 
+    // Compiler-estimated costs are only emitted if known for any entry point.
+    llvm::StringMap<DispatchCost> dispatchCosts;
+    bool hasDispatchCosts = false;
+    for (auto entryPointOp :
+         variantOp.getOps<IREE::HAL::ExecutableEntryPointOp>()) {
+      auto cost = getDispatchCost(entryPointOp);
+      hasDispatchCosts |= !cost.isDefault();
+      dispatchCosts[entryPointOp.sym_name()] = cost;
+    }
+    iree_SpirVDispatchCostDef_vec_ref_t dispatchCostsRef = 0;
+    if (hasDispatchCosts) {
+      iree_SpirVDispatchCostDef_vec_start(builder);
+      for (auto entryPointName : entryPointNames) {
+        const DispatchCost &cost = dispatchCosts[entryPointName];
+        iree_SpirVDispatchCostDef_vec_push_create(
+            builder, cost.flopCount, cost.readByteCount, cost.writeByteCount,
+            static_cast<uint32_t>(
+                std::min<int64_t>(cost.workgroupCount, UINT32_MAX)));
+      }
+      dispatchCostsRef = iree_SpirVDispatchCostDef_vec_end(builder);
+    }
+
+    // The SPIR-V conversion records how many leading push constants it exposed
+    // as specialization constants. All entry points in the module share them.
+    flatbuffers_uint32_vec_ref_t specializableCountsRef = 0;
+    if (auto countAttr = spvModuleOp->getAttrOfType<IntegerAttr>(
+            "iree.spirv.specializable_push_constant_count")) {
+      SmallVector<uint32_t, 8> specializableCounts(
+          entryPointNames.size(), static_cast<uint32_t>(countAttr.getInt()));
+      specializableCountsRef = flatbuffers_uint32_vec_create(
+          builder, specializableCounts.data(), specializableCounts.size());
+    }
+
     iree_SpirVExecutableDef_entry_points_add(builder, entryPointsRef);
     iree_SpirVExecutableDef_code_add(builder, spvCodeRef);
+    if (dispatchCostsRef) {
+      iree_SpirVExecutableDef_dispatch_costs_add(builder, dispatchCostsRef);
+    }
+    if (specializableCountsRef) {
+      iree_SpirVExecutableDef_specializable_push_constant_counts_add(
+          builder, specializableCountsRef);
+    }
     iree_SpirVExecutableDef_end_as_root(builder);
 
     // Add the binary data to the target executable.
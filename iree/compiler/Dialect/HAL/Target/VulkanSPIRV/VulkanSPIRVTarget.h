@@ -24,6 +24,10 @@ struct VulkanSPIRVTargetOptions {
 
   // True to keep shader modules for debugging.
   bool keepShaderModules;
+
+  // True to expose push constants as specialization constants such that the
+  // runtime can create pipelines specialized on recurring values.
+  bool specializePushConstants;
 };
 
 // Returns a VulkanSPIRVTargetOptions struct initialized with Vulkan/SPIR-V
@@ -0,0 +1,154 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Dialect/Flow/IR/FlowOps.h"
+#include "iree/compiler/Dialect/HAL/IR/HALOps.h"
+#include "iree/compiler/Dialect/HAL/Target/TargetBackend.h"
+#include "iree/compiler/Dialect/HAL/Transforms/Passes.h"
+#include "iree/compiler/Dialect/Util/IR/UtilTypes.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/Pass/Pass.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace HAL {
+
+// Returns the shape of the full tensor |value| is a tile of, tracing back
+// through linalg ops to the dispatch tensor it was loaded from. Dispatch
+// functions are already distributed across workgroups at this point and
+// operate on tiles with dynamic sizes while the cost of interest is that of the
+// whole dispatch. Returns None if the full shape cannot be determined.
+static Optional<SmallVector<int64_t>> getFullShape(Value value) {
+  if (auto loadOp = value.getDefiningOp<IREE::Flow::DispatchTensorLoadOp>()) {
+    auto sourceType =
+        loadOp.source().getType().cast<IREE::Flow::DispatchTensorType>();
+    if (sourceType.hasStaticShape() &&
+        sourceType.getRank() == loadOp.getType().getRank()) {
+      return llvm::to_vector(sourceType.getShape());
+    }
+  } else if (auto linalgOp = value.getDefiningOp<linalg::LinalgOp>()) {
+    unsigned resultNumber = value.cast<OpResult>().getResultNumber();
+    return getFullShape(linalgOp.getOutputOperand(resultNumber)->get());
+  }
+  auto tensorType = value.getType().dyn_cast<RankedTensorType>();
+  if (tensorType && tensorType.hasStaticShape()) {
+    return llvm::to_vector(tensorType.getShape());
+  }
+  return llvm::None;
+}
+
+// Returns the number of iterations of the full loop nest of |linalgOp| over the
+// untiled operands or None if it cannot be determined.
+static Optional<int64_t> getFullIterationCount(linalg::LinalgOp linalgOp) {
+  SmallVector<int64_t> operandDims;
+  for (OpOperand *opOperand : linalgOp.getInputAndOutputOperands()) {
+    int64_t rank = linalgOp.getRank(opOperand);
+    auto shape = getFullShape(opOperand->get());
+    if (shape && static_cast<int64_t>(shape->size()) == rank) {
+      operandDims.append(shape->begin(), shape->end());
+    } else {
+      operandDims.append(rank, ShapedType::kDynamicSize);
+    }
+  }
+  AffineMap shapesToLoopsMap = linalgOp.getShapesToLoopsMap();
+  if (!shapesToLoopsMap) return llvm::None;
+  int64_t iterationCount = 1;
+  for (AffineExpr expr : shapesToLoopsMap.getResults()) {
+    auto dimExpr = expr.dyn_cast<AffineDimExpr>();
+    if (!dimExpr) return llvm::None;
+    int64_t range = operandDims[dimExpr.getPosition()];
+    if (ShapedType::isDynamic(range)) return llvm::None;
+    iterationCount *= range;
+  }
+  return iterationCount;
+}
+
+// Estimates the cost of a single dispatch of |funcOp|. Returns None if any part
+// of the dispatch is dynamically shaped and a meaningful estimate cannot be
+// made.
+//
+// The estimate is intentionally coarse: bytes are counted as the full size of
+// each interface binding based on its access and operations are counted as
+// one per scalar op in each linalg op body per iteration of its loop nest.
+static Optional<DispatchCost> estimateDispatchCost(FuncOp funcOp) {
+  DispatchCost cost;
+  auto walkResult = funcOp.walk([&](Operation *op) -> WalkResult {
+    if (auto subspanOp = dyn_cast<IREE::HAL::InterfaceBindingSubspanOp>(op)) {
+      auto tensorType =
+          subspanOp.getType().dyn_cast<IREE::Flow::DispatchTensorType>();
+      if (!tensorType || !tensorType.hasStaticShape()) {
+        return WalkResult::interrupt();
+      }
+      int64_t byteSize =
+          tensorType.getNumElements() *
+          IREE::Util::getRoundedElementByteWidth(tensorType.getElementType());
+      if (tensorType.getAccess() != IREE::Flow::TensorAccess::WriteOnly) {
+        cost.readByteCount += byteSize;
+      }
+      if (tensorType.getAccess() != IREE::Flow::TensorAccess::ReadOnly) {
+        cost.writeByteCount += byteSize;
+      }
+    } else if (auto linalgOp = dyn_cast<linalg::LinalgOp>(op)) {
+      // Ops that only move data (such as fills and copies) have no arithmetic
+      // in their bodies and contribute no operations.
+      int64_t opsPerIteration =
+          llvm::size(linalgOp.getBlock()->without_terminator());
+      if (opsPerIteration == 0) return WalkResult::skip();
+      auto iterationCount = getFullIterationCount(linalgOp);
+      if (!iterationCount) return WalkResult::interrupt();
+      cost.flopCount += *iterationCount * opsPerIteration;
+      return WalkResult::skip();
+    }
+    return WalkResult::advance();
+  });
+  if (walkResult.wasInterrupted()) return llvm::None;
+  return cost;
+}
+
+class AnnotateDispatchCostsPass
+    : public PassWrapper<AnnotateDispatchCostsPass,
+                         OperationPass<IREE::HAL::ExecutableOp>> {
+ public:
+  StringRef getArgument() const override {
+    return "iree-hal-annotate-dispatch-costs";
+  }
+
+  StringRef getDescription() const override {
+    return "Annotates hal.executable.entry_point ops with estimated costs";
+  }
+
+  void runOnOperation() override {
+    auto executableOp = getOperation();
+    for (auto variantOp :
+         executableOp.getBlock().getOps<IREE::HAL::ExecutableVariantOp>()) {
+      auto innerModuleOp = variantOp.getInnerModule();
+      if (!innerModuleOp) continue;
+      for (auto entryPointOp :
+           variantOp.getBlock().getOps<IREE::HAL::ExecutableEntryPointOp>()) {
+        auto funcOp =
+            innerModuleOp.lookupSymbol<FuncOp>(entryPointOp.getName());
+        if (!funcOp) continue;
+        auto cost = estimateDispatchCost(funcOp);
+        if (!cost) continue;
+        setDispatchCost(entryPointOp, *cost);
+      }
+    }
+  }
+};
+
+std::unique_ptr<OperationPass<IREE::HAL::ExecutableOp>>
+createAnnotateDispatchCostsPass() {
+  return std::make_unique<AnnotateDispatchCostsPass>();
+}
+
+static PassRegistration<AnnotateDispatchCostsPass> pass;
+
+}  // namespace HAL
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
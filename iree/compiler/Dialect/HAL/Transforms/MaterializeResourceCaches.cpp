@@ -11,11 +11,15 @@
 #include "iree/compiler/Dialect/HAL/Transforms/Passes.h"
 #include "iree/compiler/Dialect/HAL/Utils/DeviceSwitchBuilder.h"
 #include "iree/compiler/Dialect/Util/IR/UtilOps.h"
+#include "llvm/ADT/SetVector.h"
 #include "mlir/Dialect/StandardOps/IR/Ops.h"
 #include "mlir/IR/Attributes.h"
+#include "mlir/IR/BlockAndValueMapping.h"
 #include "mlir/IR/Builders.h"
 #include "mlir/IR/BuiltinTypes.h"
 #include "mlir/IR/Diagnostics.h"
+#include "mlir/IR/SymbolTable.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
 #include "mlir/Pass/Pass.h"
 
 namespace mlir {
@@ -23,6 +27,46 @@ namespace iree_compiler {
 namespace IREE {
 namespace HAL {
 
+// Returns true if |value| is the same on every invocation of the function
+// using it: constants, the shared device, and loads of immutable globals along
+// with side-effect free ops computed only from those. The ops producing the
+// value are added to |producerOps| in definition order.
+static bool isInvocationInvariant(Value value, SymbolTable &symbolTable,
+                                  llvm::SetVector<Operation *> &producerOps) {
+  Operation *op = value.getDefiningOp();
+  if (!op) return false;
+  if (producerOps.contains(op)) return true;
+  if (auto loadOp = dyn_cast<IREE::Util::GlobalLoadOp>(op)) {
+    auto globalOp = symbolTable.lookup<IREE::Util::GlobalOp>(loadOp.global());
+    if (!globalOp || globalOp.isMutable()) return false;
+  } else {
+    if (op->getNumRegions() != 0 ||
+        !MemoryEffectOpInterface::hasNoEffect(op)) {
+      return false;
+    }
+    for (Value operand : op->getOperands()) {
+      if (!isInvocationInvariant(operand, symbolTable, producerOps)) {
+        return false;
+      }
+    }
+  }
+  producerOps.insert(op);
+  return true;
+}
+
+// Returns true if |op| may be part of a memoized command buffer recording.
+static bool isRecordableOp(Operation *op, SymbolTable &symbolTable) {
+  if (op->getName().getStringRef().startswith("hal.command_buffer.")) {
+    return true;
+  }
+  if (isa<DeviceSwitchOp, IREE::HAL::ReturnOp>(op)) return true;
+  if (auto loadOp = dyn_cast<IREE::Util::GlobalLoadOp>(op)) {
+    auto globalOp = symbolTable.lookup<IREE::Util::GlobalOp>(loadOp.global());
+    return globalOp && !globalOp.isMutable();
+  }
+  return op->getNumRegions() == 0 && MemoryEffectOpInterface::hasNoEffect(op);
+}
+
 class MaterializeResourceCachesPass
     : public PassWrapper<MaterializeResourceCachesPass,
                          OperationPass<ModuleOp>> {
@@ -87,6 +131,21 @@ class MaterializeResourceCachesPass
         });
       }
     }
+
+    // Hoist command buffers with invocation-invariant recordings into
+    // initializers now that the resources they use are all cached.
+    if (targetOptions_.memoizeCommandBuffers) {
+      SymbolTable symbolTable(moduleOp);
+      for (auto funcOp : llvm::to_vector<4>(moduleOp.getOps<mlir::FuncOp>())) {
+        SmallVector<CommandBufferCreateOp> createOps;
+        funcOp.walk([&](CommandBufferCreateOp createOp) {
+          createOps.push_back(createOp);
+        });
+        for (auto createOp : createOps) {
+          memoizeCommandBuffer(funcOp, createOp, symbolTable);
+        }
+      }
+    }
   }
 
  private:
@@ -278,6 +337,128 @@ class MaterializeResourceCachesPass
     lookupOp.erase();
   }
 
+  // Moves the recording of the command buffer created by |createOp| into an
+  // initializer if every command recorded into it is the same on each
+  // invocation of |funcOp|. Only the submission remains in the function, which
+  // loads the reusable command buffer from a global.
+  //
+  // Expects the create -> begin -> commands -> end -> submit sequence produced
+  // by stream conversion with all commands nested between the begin and end.
+  void memoizeCommandBuffer(mlir::FuncOp funcOp, CommandBufferCreateOp createOp,
+                            SymbolTable &symbolTable) {
+    Value commandBuffer = createOp.result();
+    Block *block = createOp->getBlock();
+    CommandBufferBeginOp beginOp;
+    CommandBufferEndOp endOp;
+    for (Operation *user : commandBuffer.getUsers()) {
+      if (auto op = dyn_cast<CommandBufferBeginOp>(user)) {
+        if (beginOp || op->getBlock() != block) return;
+        beginOp = op;
+      } else if (auto op = dyn_cast<CommandBufferEndOp>(user)) {
+        if (endOp || op->getBlock() != block) return;
+        endOp = op;
+      }
+    }
+    if (!beginOp || !endOp || !beginOp->isBeforeInBlock(endOp)) return;
+
+    // Gather the recording ops and ensure nothing in them varies per call.
+    DenseSet<Operation *> recordingOpSet;
+    SmallVector<Operation *> recordingOps;
+    for (auto it = Block::iterator(beginOp); &*it != endOp; ++it) {
+      recordingOps.push_back(&*it);
+      recordingOpSet.insert(&*it);
+    }
+    recordingOps.push_back(endOp);
+    recordingOpSet.insert(endOp);
+    auto isDefinedInRecording = [&](Value value) {
+      Operation *definingOp = value.isa<BlockArgument>()
+                                  ? value.getParentBlock()->getParentOp()
+                                  : value.getDefiningOp();
+      Operation *ancestorOp = block->findAncestorOpInBlock(*definingOp);
+      return ancestorOp && recordingOpSet.contains(ancestorOp);
+    };
+    llvm::SetVector<Operation *> producerOps;
+    if (!isInvocationInvariant(createOp.device(), symbolTable, producerOps)) {
+      return;
+    }
+    for (Operation *recordingOp : recordingOps) {
+      auto walkResult = recordingOp->walk([&](Operation *op) {
+        if (!isRecordableOp(op, symbolTable)) return WalkResult::interrupt();
+        for (Value operand : op->getOperands()) {
+          if (operand == commandBuffer || isDefinedInRecording(operand)) {
+            continue;
+          }
+          if (!isInvocationInvariant(operand, symbolTable, producerOps)) {
+            return WalkResult::interrupt();
+          }
+        }
+        return WalkResult::advance();
+      });
+      if (walkResult.wasInterrupted()) return;
+      for (Value result : recordingOp->getResults()) {
+        for (Operation *user : result.getUsers()) {
+          if (!recordingOpSet.contains(block->findAncestorOpInBlock(*user))) {
+            return;
+          }
+        }
+      }
+    }
+
+    // The only other allowed uses are submissions after recording ends.
+    for (Operation *user : commandBuffer.getUsers()) {
+      Operation *ancestorOp = block->findAncestorOpInBlock(*user);
+      if (ancestorOp && recordingOpSet.contains(ancestorOp)) continue;
+      if (!isa<ExSubmitAndWaitOp>(user) || user->getBlock() != block ||
+          !endOp->isBeforeInBlock(user)) {
+        return;
+      }
+    }
+
+    // Record the command buffer once at initialization time. The initializer
+    // goes immediately before the function so that it runs after those of the
+    // resources it uses.
+    auto loc = createOp.getLoc();
+    auto commandBufferType = CommandBufferType::get(loc.getContext());
+    OpBuilder funcBuilder(funcOp);
+    auto globalOp = funcBuilder.create<IREE::Util::GlobalOp>(
+        loc,
+        (StringRef("_command_buffer_") +
+         std::to_string(nextUniqueCommandBufferId++))
+            .str(),
+        /*isMutable=*/false, commandBufferType);
+    globalOp.setPrivate();
+    symbolTable.insert(globalOp);
+
+    auto initializerOp = funcBuilder.create<IREE::Util::InitializerOp>(loc);
+    OpBuilder blockBuilder =
+        OpBuilder::atBlockEnd(initializerOp.addEntryBlock());
+    BlockAndValueMapping mapping;
+    for (Operation *producerOp : producerOps) {
+      blockBuilder.clone(*producerOp, mapping);
+    }
+    auto newCreateOp = blockBuilder.create<CommandBufferCreateOp>(
+        loc, commandBufferType, mapping.lookup(createOp.device()),
+        IREE::HAL::CommandBufferModeBitfield::Reusable,
+        createOp.command_categories());
+    mapping.map(commandBuffer, newCreateOp.result());
+    for (Operation *recordingOp : recordingOps) {
+      blockBuilder.clone(*recordingOp, mapping);
+    }
+    blockBuilder.create<IREE::Util::GlobalStoreOp>(loc, newCreateOp.result(),
+                                                   globalOp.getName());
+    blockBuilder.create<IREE::Util::InitializerReturnOp>(loc);
+
+    // Submit the cached command buffer in place of the recording.
+    for (Operation *recordingOp : llvm::reverse(recordingOps)) {
+      recordingOp->erase();
+    }
+    OpBuilder builder(createOp);
+    auto loadOp = builder.create<IREE::Util::GlobalLoadOp>(
+        loc, commandBufferType, globalOp.getName());
+    createOp.replaceAllUsesWith(loadOp.getOperation());
+    createOp.erase();
+  }
+
   TargetOptions targetOptions_;
 
   OpBuilder moduleBuilder{static_cast<MLIRContext *>(nullptr)};
@@ -287,6 +468,7 @@ class MaterializeResourceCachesPass
 
   int nextUniqueExecutableLayoutId = 0;
   int nextUniqueDescriptorSetLayoutId = 0;
+  int nextUniqueCommandBufferId = 0;
 };
 
 std::unique_ptr<OperationPass<ModuleOp>> createMaterializeResourceCachesPass(
@@ -0,0 +1,296 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <utility>
+
+#include "iree/compiler/Dialect/HAL/IR/HALOps.h"
+#include "iree/compiler/Dialect/HAL/Transforms/Passes.h"
+#include "iree/compiler/Dialect/Util/IR/UtilOps.h"
+#include "llvm/ADT/SetVector.h"
+#include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
+#include "mlir/Dialect/SCF/SCF.h"
+#include "mlir/IR/Attributes.h"
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/SymbolTable.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
+#include "mlir/Pass/Pass.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace HAL {
+
+// Functions need at least this many shape computation ops for the cache
+// lookup (one compare per key and a load per value) to be cheaper than the
+// recomputation.
+static constexpr int kMinComputationOpCount = 8;
+
+// Maximum number of dynamic dimensions used as the cache key.
+static constexpr int kMaxKeyCount = 8;
+
+static bool isIntegerLike(Type type) {
+  return type.isa<IndexType, IntegerType>();
+}
+
+// Returns true if |value| is a shape source that the cache is keyed on: an
+// integer argument of the function or a dynamic dimension of an input buffer
+// view.
+static bool isShapeKey(Value value, Block *entryBlock) {
+  if (!isIntegerLike(value.getType())) return false;
+  if (auto arg = value.dyn_cast<BlockArgument>()) {
+    return arg.getOwner() == entryBlock;
+  }
+  return isa<IREE::HAL::BufferViewDimOp>(value.getDefiningOp());
+}
+
+// Returns true if |op| is a side-effect free integer arith op.
+static bool isShapeComputationOp(Operation *op) {
+  if (!isa<arith::ArithmeticDialect>(op->getDialect())) return false;
+  if (op->getNumRegions() != 0 || !MemoryEffectOpInterface::hasNoEffect(op)) {
+    return false;
+  }
+  return llvm::all_of(op->getResultTypes(), isIntegerLike);
+}
+
+namespace {
+
+// The shape computations of a function that will be memoized.
+struct ShapeComputation {
+  // Values the computation depends on in the order they are defined.
+  SmallVector<Value> keys;
+  // Computation ops (including constants) in block order.
+  SmallVector<Operation *> ops;
+  // Results of |ops| used outside of the computation.
+  SmallVector<Value> results;
+  // Op after which the cache lookup is inserted (null for the block start).
+  Operation *insertionPoint = nullptr;
+};
+
+}  // namespace
+
+// Finds the integer computations in the entry block of |funcOp| that depend
+// only on shape keys and constants. Returns None if there is nothing worth
+// memoizing.
+static Optional<ShapeComputation> findShapeComputation(
+    FunctionOpInterface funcOp) {
+  Region &body = funcOp->getRegion(0);
+  if (body.empty()) return llvm::None;
+  Block *entryBlock = &body.front();
+
+  // Forward pass over the block marking values derived only from keys and
+  // constants.
+  DenseSet<Value> derivedValues;
+  llvm::SetVector<Operation *> computationOps;
+  llvm::SetVector<Value> keys;
+  int nonConstantOpCount = 0;
+  for (Operation &op : *entryBlock) {
+    if (!isShapeComputationOp(&op)) continue;
+    bool isDerived = llvm::all_of(op.getOperands(), [&](Value operand) {
+      return derivedValues.contains(operand) ||
+             isShapeKey(operand, entryBlock);
+    });
+    if (!isDerived) continue;
+    for (Value operand : op.getOperands()) {
+      if (isShapeKey(operand, entryBlock)) keys.insert(operand);
+    }
+    derivedValues.insert(op.result_begin(), op.result_end());
+    computationOps.insert(&op);
+    if (!isa<arith::ConstantOp>(op)) ++nonConstantOpCount;
+  }
+  if (nonConstantOpCount < kMinComputationOpCount) return llvm::None;
+  if (keys.empty() || keys.size() > kMaxKeyCount) return llvm::None;
+
+  ShapeComputation computation;
+  computation.keys = keys.takeVector();
+  computation.ops = computationOps.takeVector();
+
+  // The lookup must come after all keys are defined.
+  for (Value key : computation.keys) {
+    Operation *definingOp = key.getDefiningOp();
+    if (!definingOp) continue;
+    if (!computation.insertionPoint ||
+        computation.insertionPoint->isBeforeInBlock(definingOp)) {
+      computation.insertionPoint = definingOp;
+    }
+  }
+
+  // Results are the non-constant values used outside of the computation. All
+  // such uses must follow the lookup.
+  DenseSet<Operation *> computationOpSet(computation.ops.begin(),
+                                         computation.ops.end());
+  for (Operation *op : computation.ops) {
+    if (isa<arith::ConstantOp>(op)) continue;
+    for (Value result : op->getResults()) {
+      bool isResult = false;
+      for (Operation *user : result.getUsers()) {
+        if (computationOpSet.contains(user)) continue;
+        isResult = true;
+        if (user->getBlock() != entryBlock) continue;
+        if (computation.insertionPoint &&
+            !computation.insertionPoint->isBeforeInBlock(user)) {
+          return llvm::None;
+        }
+      }
+      if (isResult) computation.results.push_back(result);
+    }
+  }
+  if (computation.results.empty()) return llvm::None;
+  return computation;
+}
+
+// Replaces |computation| in |funcOp| with a lookup into a cache of the
+// results of the last call stored in module globals.
+static void memoizeShapeComputation(FunctionOpInterface funcOp,
+                                    ShapeComputation &computation,
+                                    SymbolTable &symbolTable) {
+  auto moduleOp = funcOp->getParentOfType<ModuleOp>();
+  auto loc = funcOp.getLoc();
+  auto moduleBuilder = OpBuilder::atBlockBegin(moduleOp.getBody());
+  std::string namePrefix =
+      ("_" + SymbolTable::getSymbolName(funcOp).getValue() + "_shape_cache")
+          .str();
+  auto createGlobal = [&](StringRef suffix, Type type,
+                          Optional<Attribute> initialValue) {
+    auto globalOp = moduleBuilder.create<IREE::Util::GlobalOp>(
+        loc, namePrefix + suffix.str(), /*isMutable=*/true, type,
+        initialValue);
+    globalOp.setPrivate();
+    symbolTable.insert(globalOp);
+    return globalOp;
+  };
+
+  auto validGlobalOp = createGlobal("_valid", moduleBuilder.getI1Type(),
+                                    moduleBuilder.getBoolAttr(false));
+  SmallVector<IREE::Util::GlobalOp> keyGlobalOps;
+  for (auto key : llvm::enumerate(computation.keys)) {
+    keyGlobalOps.push_back(createGlobal("_key_" + std::to_string(key.index()),
+                                        key.value().getType(), llvm::None));
+  }
+  SmallVector<IREE::Util::GlobalOp> resultGlobalOps;
+  for (auto result : llvm::enumerate(computation.results)) {
+    resultGlobalOps.push_back(
+        createGlobal("_value_" + std::to_string(result.index()),
+                     result.value().getType(), llvm::None));
+  }
+
+  // Check whether the cached results were computed for the same keys.
+  Block *entryBlock = &funcOp->getRegion(0).front();
+  OpBuilder builder(funcOp.getContext());
+  if (computation.insertionPoint) {
+    builder.setInsertionPointAfter(computation.insertionPoint);
+  } else {
+    builder.setInsertionPointToStart(entryBlock);
+  }
+  Value isHit = builder.create<IREE::Util::GlobalLoadOp>(
+      loc, validGlobalOp.type(), validGlobalOp.getName());
+  for (auto it : llvm::zip(computation.keys, keyGlobalOps)) {
+    Value key = std::get<0>(it);
+    IREE::Util::GlobalOp keyGlobalOp = std::get<1>(it);
+    Value cachedKey = builder.create<IREE::Util::GlobalLoadOp>(
+        loc, keyGlobalOp.type(), keyGlobalOp.getName());
+    Value isEqual = builder.create<arith::CmpIOp>(
+        loc, arith::CmpIPredicate::eq, key, cachedKey);
+    isHit = builder.create<arith::AndIOp>(loc, isHit, isEqual);
+  }
+
+  auto resultTypes = llvm::to_vector(llvm::map_range(
+      computation.results, [](Value value) { return value.getType(); }));
+  auto ifOp = builder.create<scf::IfOp>(
+      loc, resultTypes, isHit,
+      [&](OpBuilder &builder, Location loc) {
+        SmallVector<Value> cachedResults;
+        for (auto resultGlobalOp : resultGlobalOps) {
+          cachedResults.push_back(builder.create<IREE::Util::GlobalLoadOp>(
+              loc, resultGlobalOp.type(), resultGlobalOp.getName()));
+        }
+        builder.create<scf::YieldOp>(loc, cachedResults);
+      },
+      [&](OpBuilder &builder, Location loc) {
+        BlockAndValueMapping mapping;
+        for (Operation *op : computation.ops) builder.clone(*op, mapping);
+        SmallVector<Value> newResults;
+        for (auto it : llvm::zip(computation.results, resultGlobalOps)) {
+          Value newResult = mapping.lookup(std::get<0>(it));
+          builder.create<IREE::Util::GlobalStoreOp>(
+              loc, newResult, std::get<1>(it).getName());
+          newResults.push_back(newResult);
+        }
+        for (auto it : llvm::zip(computation.keys, keyGlobalOps)) {
+          builder.create<IREE::Util::GlobalStoreOp>(loc, std::get<0>(it),
+                                                    std::get<1>(it).getName());
+        }
+        Value trueValue = builder.create<arith::ConstantIntOp>(loc, 1, 1);
+        builder.create<IREE::Util::GlobalStoreOp>(loc, trueValue,
+                                                  validGlobalOp.getName());
+        builder.create<scf::YieldOp>(loc, newResults);
+      });
+
+  DenseSet<Operation *> computationOpSet(computation.ops.begin(),
+                                         computation.ops.end());
+  for (auto it : llvm::zip(computation.results, ifOp.getResults())) {
+    std::get<0>(it).replaceUsesWithIf(std::get<1>(it), [&](OpOperand &use) {
+      return !computationOpSet.contains(use.getOwner());
+    });
+  }
+
+  // Erase the original computation; constants may still have other users.
+  for (Operation *op : llvm::reverse(computation.ops)) {
+    if (op->use_empty()) op->erase();
+  }
+}
+
+// Caches integer computations that only depend on the dynamic dimensions of
+// function inputs (workgroup counts, buffer sizes and offsets, etc) in module
+// globals keyed on those dimensions. Repeated calls with the same shapes load
+// the cached values instead of recomputing them.
+//
+// NOTE: the cache is part of the module state and is not synchronized; like
+// the rest of the module state concurrent calls into the same context must be
+// externally synchronized.
+class MemoizeShapeComputationsPass
+    : public PassWrapper<MemoizeShapeComputationsPass,
+                         OperationPass<ModuleOp>> {
+ public:
+  StringRef getArgument() const override {
+    return "iree-hal-memoize-shape-computations";
+  }
+
+  StringRef getDescription() const override {
+    return "Caches shape-dependent computations across calls keyed on the "
+           "dynamic dimensions they depend on";
+  }
+
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<arith::ArithmeticDialect, scf::SCFDialect,
+                    IREE::Util::UtilDialect>();
+  }
+
+  void runOnOperation() override {
+    auto moduleOp = getOperation();
+    SymbolTable symbolTable(moduleOp);
+    for (auto funcOp :
+         llvm::to_vector(moduleOp.getOps<FunctionOpInterface>())) {
+      // Initializers only run once.
+      if (isa<IREE::Util::InitializerOp>(funcOp.getOperation())) continue;
+      auto computation = findShapeComputation(funcOp);
+      if (!computation) continue;
+      memoizeShapeComputation(funcOp, *computation, symbolTable);
+    }
+  }
+};
+
+std::unique_ptr<OperationPass<ModuleOp>> createMemoizeShapeComputationsPass() {
+  return std::make_unique<MemoizeShapeComputationsPass>();
+}
+
+static PassRegistration<MemoizeShapeComputationsPass> pass;
+
+}  // namespace HAL
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
@@ -0,0 +1,267 @@
+// Copyright 2021 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Dialect/HAL/IR/HALDialect.h"
+#include "iree/compiler/Dialect/HAL/IR/HALOps.h"
+#include "iree/compiler/Dialect/HAL/Transforms/Passes.h"
+#include "iree/compiler/Dialect/Util/IR/UtilDialect.h"
+#include "iree/compiler/Dialect/Util/IR/UtilOps.h"
+#include "iree/compiler/Dialect/Util/IR/UtilTypes.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/TypeSwitch.h"
+#include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
+#include "mlir/IR/Attributes.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/Pass/Pass.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace HAL {
+namespace {
+
+// Opcodes of the packed command stream.
+// Must match iree_hal_module_command_opcode_e in iree/modules/hal/module.c.
+enum class PackedOpcode : uint32_t {
+  kExecutionBarrier = 1,
+  kFillBuffer = 2,
+  kCopyBuffer = 3,
+  kPushConstants = 4,
+  kPushDescriptorSet = 5,
+  kDispatch = 6,
+  kDispatchIndirect = 7,
+};
+
+// Operand words with this bit set index into the dynamic values list.
+static constexpr uint32_t kDynamicBit = 0x80000000u;
+
+// Commands that have been packed for a single command buffer.
+struct PackedCommands {
+  SmallVector<Operation *> ops;
+  SmallVector<uint32_t> words;
+  llvm::MapVector<Value, uint32_t> refs;
+  llvm::MapVector<Value, uint32_t> values;
+
+  // Appends a command header and returns the word index of the header so the
+  // operand count can be patched once all operands are appended.
+  size_t beginCommand(PackedOpcode opcode) {
+    words.push_back(static_cast<uint32_t>(opcode));
+    return words.size() - 1;
+  }
+  void endCommand(size_t headerIndex) {
+    uint32_t operandCount = words.size() - headerIndex - 1;
+    words[headerIndex] |= operandCount << 8;
+  }
+
+  void addImmediate(uint64_t value) {
+    assert(value < kDynamicBit && "immediate overflows operand word");
+    words.push_back(static_cast<uint32_t>(value));
+  }
+  void addRef(Value ref) {
+    auto it = refs.insert({ref, refs.size()}).first;
+    words.push_back(it->second);
+  }
+  void addValue(Value value) {
+    APInt constantValue;
+    if (matchPattern(value, m_ConstantInt(&constantValue)) &&
+        constantValue.getActiveBits() < 32) {
+      words.push_back(static_cast<uint32_t>(constantValue.getZExtValue()));
+      return;
+    }
+    auto it = values.insert({value, values.size()}).first;
+    words.push_back(kDynamicBit | it->second);
+  }
+};
+
+// Appends |op| to |commands| if it is a command that can be packed.
+static LogicalResult packCommand(Operation *op, PackedCommands &commands) {
+  return TypeSwitch<Operation *, LogicalResult>(op)
+      .Case([&](IREE::HAL::CommandBufferExecutionBarrierOp op) {
+        auto header = commands.beginCommand(PackedOpcode::kExecutionBarrier);
+        commands.addImmediate(static_cast<uint32_t>(op.source_stage_mask()));
+        commands.addImmediate(static_cast<uint32_t>(op.target_stage_mask()));
+        commands.addImmediate(static_cast<uint32_t>(op.flags()));
+        commands.endCommand(header);
+        return success();
+      })
+      .Case([&](IREE::HAL::CommandBufferFillBufferOp op) {
+        // Patterns are widened to 32-bits the same way the VM conversion does;
+        // anything else is left for the import.
+        auto patternType = op.pattern().getType().dyn_cast<IntegerType>();
+        if (!patternType || patternType.getWidth() > 32) return failure();
+        auto header = commands.beginCommand(PackedOpcode::kFillBuffer);
+        commands.addRef(op.target_buffer());
+        commands.addValue(op.target_offset());
+        commands.addValue(op.length());
+        commands.addValue(op.pattern());
+        commands.addImmediate(
+            IREE::Util::getRoundedElementByteWidth(patternType));
+        commands.endCommand(header);
+        return success();
+      })
+      .Case([&](IREE::HAL::CommandBufferCopyBufferOp op) {
+        auto header = commands.beginCommand(PackedOpcode::kCopyBuffer);
+        commands.addRef(op.source_buffer());
+        commands.addValue(op.source_offset());
+        commands.addRef(op.target_buffer());
+        commands.addValue(op.target_offset());
+        commands.addValue(op.length());
+        commands.endCommand(header);
+        return success();
+      })
+      .Case([&](IREE::HAL::CommandBufferPushConstantsOp op) {
+        auto header = commands.beginCommand(PackedOpcode::kPushConstants);
+        commands.addRef(op.executable_layout());
+        commands.addImmediate(op.offset().getZExtValue());
+        for (auto value : op.values()) commands.addValue(value);
+        commands.endCommand(header);
+        return success();
+      })
+      .Case([&](IREE::HAL::CommandBufferPushDescriptorSetOp op) {
+        auto header = commands.beginCommand(PackedOpcode::kPushDescriptorSet);
+        commands.addRef(op.executable_layout());
+        commands.addValue(op.set());
+        for (size_t i = 0; i < op.binding_ordinals().size(); ++i) {
+          commands.addValue(op.binding_ordinals()[i]);
+          commands.addRef(op.binding_buffers()[i]);
+          commands.addValue(op.binding_offsets()[i]);
+          commands.addValue(op.binding_lengths()[i]);
+        }
+        commands.endCommand(header);
+        return success();
+      })
+      .Case([&](IREE::HAL::CommandBufferDispatchOp op) {
+        auto header = commands.beginCommand(PackedOpcode::kDispatch);
+        commands.addRef(op.executable());
+        commands.addImmediate(op.entry_point().getZExtValue());
+        commands.addValue(op.workgroup_x());
+        commands.addValue(op.workgroup_y());
+        commands.addValue(op.workgroup_z());
+        commands.endCommand(header);
+        return success();
+      })
+      .Case([&](IREE::HAL::CommandBufferDispatchIndirectOp op) {
+        auto header = commands.beginCommand(PackedOpcode::kDispatchIndirect);
+        commands.addRef(op.executable());
+        commands.addImmediate(op.entry_point().getZExtValue());
+        commands.addRef(op.workgroups_buffer());
+        commands.addValue(op.workgroups_offset());
+        commands.endCommand(header);
+        return success();
+      })
+      .Default([&](Operation *op) { return failure(); });
+}
+
+// Replaces the ops in |commands| with a single execute_commands op recording
+// the packed stream. Single commands are left as-is as there's no call
+// overhead to save.
+static void flushCommands(Value commandBuffer, PackedCommands &commands) {
+  if (commands.ops.size() < 2) {
+    commands = {};
+    return;
+  }
+
+  // All operands dominate the last op in the run so we insert there.
+  auto *lastOp = commands.ops.back();
+  auto loc = lastOp->getLoc();
+  OpBuilder builder(lastOp);
+
+  auto i32Type = builder.getI32Type();
+  auto commandsAttr = DenseIntElementsAttr::get(
+      VectorType::get({static_cast<int64_t>(commands.words.size())}, i32Type),
+      ArrayRef<uint32_t>(commands.words));
+  auto commandsBuffer = builder.create<IREE::Util::ByteBufferConstantOp>(
+      loc, builder.getType<IREE::Util::ByteBufferType>(), commandsAttr,
+      builder.getI64IntegerAttr(sizeof(uint32_t)));
+
+  SmallVector<Value> refs;
+  for (auto &it : commands.refs) refs.push_back(it.first);
+  SmallVector<Value> values;
+  for (auto &it : commands.values) {
+    Value value = it.first;
+    if (value.getType().isIndex()) {
+      value = builder.createOrFold<arith::IndexCastOp>(loc, i32Type, value);
+    } else if (value.getType().getIntOrFloatBitWidth() < 32) {
+      value = builder.createOrFold<arith::ExtUIOp>(loc, i32Type, value);
+    }
+    values.push_back(value);
+  }
+
+  builder.create<IREE::HAL::CommandBufferExecuteCommandsOp>(
+      loc, commandBuffer, commandsBuffer, refs, values);
+  for (auto *op : commands.ops) op->erase();
+  commands = {};
+}
+
+class PackCommandBuffersPass
+    : public PassWrapper<PackCommandBuffersPass, OperationPass<void>> {
+ public:
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<arith::ArithmeticDialect>();
+    registry.insert<IREE::HAL::HALDialect>();
+    registry.insert<IREE::Util::UtilDialect>();
+  }
+
+  StringRef getArgument() const override {
+    return "iree-hal-pack-command-buffers";
+  }
+
+  StringRef getDescription() const override {
+    return "Packs runs of command buffer ops into a constant command stream "
+           "recorded with a single call.";
+  }
+
+  void runOnOperation() override {
+    auto parentOp = getOperation();
+    for (auto &region : parentOp->getRegions()) {
+      for (auto &block : region.getBlocks()) {
+        // Commands are only recorded and not executed so they can be moved
+        // across any op that doesn't itself use the command buffer. Runs are
+        // flushed whenever the command buffer is used by anything else (such
+        // as hal.command_buffer.end) and at the end of the block.
+        llvm::MapVector<Value, PackedCommands> pendingCommands;
+        for (auto &op : llvm::make_early_inc_range(block.getOperations())) {
+          if (op.getNumRegions() > 0) {
+            // Nested regions may use any command buffer; flush conservatively.
+            for (auto &it : pendingCommands) flushCommands(it.first, it.second);
+            pendingCommands.clear();
+            continue;
+          }
+          if (op.getNumOperands() > 0 &&
+              op.getOperand(0).getType().isa<IREE::HAL::CommandBufferType>()) {
+            auto commandBuffer = op.getOperand(0);
+            auto &commands = pendingCommands[commandBuffer];
+            if (succeeded(packCommand(&op, commands))) {
+              commands.ops.push_back(&op);
+              continue;
+            }
+          }
+          for (auto operand : op.getOperands()) {
+            auto it = pendingCommands.find(operand);
+            if (it == pendingCommands.end()) continue;
+            flushCommands(it->first, it->second);
+          }
+        }
+        for (auto &it : pendingCommands) flushCommands(it.first, it.second);
+      }
+    }
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<OperationPass<void>> createPackCommandBuffersPass() {
+  return std::make_unique<PackCommandBuffersPass>();
+}
+
+static PassRegistration<PackCommandBuffersPass> pass;
+
+}  // namespace HAL
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
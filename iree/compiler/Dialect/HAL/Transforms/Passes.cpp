@@ -48,6 +48,13 @@ static llvm::cl::opt<unsigned> benchmarkDispatchRepeatCount{
         "structures.)"),
     llvm::cl::init(1)};
 
+static llvm::cl::opt<bool> clMemoizeShapeComputations{
+    "iree-hal-memoize-shape-computations",
+    llvm::cl::desc("Caches host-side computations that depend only on input "
+                   "shapes (workgroup counts, buffer sizes, etc) across calls "
+                   "with the same dynamic dimensions."),
+    llvm::cl::init(false)};
+
 }  // namespace
 
 static void addCleanupPatterns(OpPassManager &passManager) {
@@ -117,6 +124,11 @@ void buildHALTransformPassPipeline(OpPassManager &passManager,
   // device communicate across the ABI boundary.
   passManager.addPass(createMaterializeInterfacesPass());
 
+  // Estimate the cost of each dispatch while the untranslated IR is still
+  // available so target backends can embed it in their executables.
+  passManager.addNestedPass<IREE::HAL::ExecutableOp>(
+      createAnnotateDispatchCostsPass());
+
   // TODO(benvanik): move translation after conversion; today translation
   // inserts the workgroup count logic we need to convert but we could instead
   // insert placeholder ops that are expanded after translation.
@@ -128,7 +140,7 @@ void buildHALTransformPassPipeline(OpPassManager &passManager,
   // After this point the executables are opaque blobs and we cannot change
   // their interfaces.
   passManager.addNestedPass<IREE::HAL::ExecutableOp>(
-      createTranslateExecutablesPass());
+      createTranslateExecutablesPass(targetOptions));
 
   //----------------------------------------------------------------------------
   // Host program conversion
@@ -189,10 +201,24 @@ void buildHALTransformPassPipeline(OpPassManager &passManager,
       createElideRedundantCommandsPass());
   passManager.addNestedPass<mlir::FuncOp>(createElideRedundantCommandsPass());
 
+  // Pack the remaining command buffer ops into constant command streams so
+  // that recording takes a single call per run of commands.
+  if (targetOptions.packCommandBuffers) {
+    passManager.addNestedPass<IREE::Util::InitializerOp>(
+        createPackCommandBuffersPass());
+    passManager.addNestedPass<mlir::FuncOp>(createPackCommandBuffersPass());
+  }
+
   // Fixup workgroup count calculations that may have used the affine dialect.
   // Kind of random here but can happen if the benchmarking code does things.
   passManager.addPass(createLowerAffinePass());
 
+  // Cache shape-dependent computations across calls now that they are all
+  // expressed as arith ops.
+  if (clMemoizeShapeComputations) {
+    passManager.addPass(createMemoizeShapeComputationsPass());
+  }
+
   // Combine the initializers we emitted during resource cache materialization.
   passManager.addPass(IREE::Util::createCombineInitializersPass());
   addCleanupPatterns(passManager);
@@ -65,6 +65,11 @@ std::unique_ptr<OperationPass<void>> createInlineDeviceSwitchesPass();
 // Finds hal.device.query ops and creates variables initialized on startup.
 std::unique_ptr<OperationPass<ModuleOp>> createMemoizeDeviceQueriesPass();
 
+// Caches integer computations that depend only on function input shapes in
+// globals keyed on the dynamic dimensions so repeated calls with the same
+// shapes skip recomputing them.
+std::unique_ptr<OperationPass<ModuleOp>> createMemoizeShapeComputationsPass();
+
 //===----------------------------------------------------------------------===//
 // Executable translation
 //===----------------------------------------------------------------------===//
@@ -77,13 +82,21 @@ std::unique_ptr<OperationPass<ModuleOp>> createPackDispatchOperandsPass();
 // device placements are made.
 std::unique_ptr<OperationPass<ModuleOp>> createMaterializeInterfacesPass();
 
+// Annotates hal.executable.entry_point ops with compiler-estimated dispatch
+// costs derived from the untranslated dispatch functions.
+std::unique_ptr<OperationPass<IREE::HAL::ExecutableOp>>
+createAnnotateDispatchCostsPass();
+
 // Translates hal.executable.variant ops via a nested translation pipeline.
+// Translations are reused from |targetOptions|.executableCacheDir if set.
 std::unique_ptr<OperationPass<IREE::HAL::ExecutableOp>>
-createTranslateExecutablesPass();
+createTranslateExecutablesPass(TargetOptions targetOptions);
 
 // Translates hal.executable.variant ops for the specified |target| backend.
+// Translations are reused from |cacheDir| when not empty.
 std::unique_ptr<OperationPass<IREE::HAL::ExecutableVariantOp>>
-createTranslateTargetExecutableVariantsPass(StringRef target);
+createTranslateTargetExecutableVariantsPass(StringRef target,
+                                            StringRef cacheDir = "");
 
 // Calls into each target backend to have it link multiple hal.executables
 // together (if that makes sense). For example, the LLVM AOT backend may combine
@@ -126,6 +139,10 @@ std::unique_ptr<OperationPass<FuncOp>> createCSEVariableLoadsPass();
 // Elides stateful command buffer ops that set redundant state.
 std::unique_ptr<OperationPass<void>> createElideRedundantCommandsPass();
 
+// Packs runs of command buffer ops into constant command streams recorded with
+// hal.command_buffer.execute_commands.
+std::unique_ptr<OperationPass<void>> createPackCommandBuffersPass();
+
 // Repeats dispatches `iree-hal-repeat-dispatch-num` times, which is 1 by
 // default.
 std::unique_ptr<OperationPass<FuncOp>> createBenchmarkBatchDispatchesPass(
@@ -138,6 +155,7 @@ std::unique_ptr<OperationPass<FuncOp>> createBenchmarkBatchDispatchesPass(
 inline void registerHALPasses() {
   registerHALTransformPassPipeline();
   auto targetOptions = TargetOptions::FromFlags::get();
+  createAnnotateDispatchCostsPass();
   createAssignTargetDevicesPass({});
   createBenchmarkBatchDispatchesPass(/*repeatCount=*/1);
   createConvertToHALPass();
@@ -148,11 +166,13 @@ inline void registerHALPasses() {
   createMaterializeInterfacesPass();
   createMaterializeResourceCachesPass(targetOptions);
   createMemoizeDeviceQueriesPass();
+  createMemoizeShapeComputationsPass();
+  createPackCommandBuffersPass();
   createPackDispatchOperandsPass();
   createResolveEntryPointOrdinalsPass();
   createSerializeExecutablesPass();
   createSerializeTargetExecutablesPass("");
-  createTranslateExecutablesPass();
+  createTranslateExecutablesPass(targetOptions);
   createTranslateTargetExecutableVariantsPass("");
   createVerifyTargetEnvironmentPass();
 }
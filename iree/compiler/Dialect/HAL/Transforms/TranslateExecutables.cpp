@@ -12,6 +12,7 @@
 #include "iree/compiler/Dialect/HAL/Target/TargetBackend.h"
 #include "iree/compiler/Dialect/HAL/Target/TargetRegistry.h"
 #include "llvm/ADT/StringSet.h"
+#include "llvm/Support/FileSystem.h"
 #include "mlir/Dialect/Bufferization/IR/Bufferization.h"
 #include "mlir/IR/Attributes.h"
 #include "mlir/IR/Builders.h"
@@ -31,8 +32,10 @@ class TranslateTargetExecutableVariantsPass
   TranslateTargetExecutableVariantsPass() = default;
   TranslateTargetExecutableVariantsPass(
       const TranslateTargetExecutableVariantsPass &pass) {}
-  TranslateTargetExecutableVariantsPass(StringRef target) {
+  TranslateTargetExecutableVariantsPass(StringRef target,
+                                        StringRef cacheDir) {
     this->target = target.str();
+    this->cacheDir = cacheDir.str();
   }
 
   StringRef getArgument() const override {
@@ -62,6 +65,16 @@ class TranslateTargetExecutableVariantsPass
       return signalPassFailure();
     }
 
+    // Reuse the translation produced by a prior compilation of the same
+    // source variant, if any.
+    std::string cachePath;
+    if (!cacheDir.empty()) {
+      cachePath = getExecutableCachePath(cacheDir, *targetBackend, variantOp);
+      if (succeeded(loadCachedExecutableVariant(cachePath, variantOp))) return;
+      // A present but unusable entry has already emitted an error.
+      if (llvm::sys::fs::exists(cachePath)) return signalPassFailure();
+    }
+
     OpPassManager passManager(variantOp.getOperationName());
     targetBackend->buildTranslationPassPipeline(passManager);
     if (failed(runPipeline(passManager, variantOp))) {
@@ -70,6 +83,8 @@ class TranslateTargetExecutableVariantsPass
                             << variantOp.target();
       return signalPassFailure();
     }
+
+    if (!cachePath.empty()) storeCachedExecutableVariant(cachePath, variantOp);
   }
 
  private:
@@ -78,11 +93,17 @@ class TranslateTargetExecutableVariantsPass
       llvm::cl::desc(
           "Target backend name whose executables will be translated by "
           "this pass.")};
+  Option<std::string> cacheDir{
+      *this, "cache-dir",
+      llvm::cl::desc("Directory used to cache translated executables across "
+                     "compilations. Empty to disable the cache.")};
 };
 
 std::unique_ptr<OperationPass<IREE::HAL::ExecutableVariantOp>>
-createTranslateTargetExecutableVariantsPass(StringRef target) {
-  return std::make_unique<TranslateTargetExecutableVariantsPass>(target);
+createTranslateTargetExecutableVariantsPass(StringRef target,
+                                            StringRef cacheDir) {
+  return std::make_unique<TranslateTargetExecutableVariantsPass>(target,
+                                                                 cacheDir);
 }
 
 static PassRegistration<TranslateTargetExecutableVariantsPass> linkTargetPass(
@@ -92,7 +113,8 @@ class TranslateExecutablesPass
     : public PassWrapper<TranslateExecutablesPass,
                          OperationPass<IREE::HAL::ExecutableOp>> {
  public:
-  TranslateExecutablesPass() = default;
+  explicit TranslateExecutablesPass(TargetOptions targetOptions)
+      : targetOptions_(targetOptions) {}
 
   StringRef getArgument() const override {
     return "iree-hal-translate-executables";
@@ -116,22 +138,27 @@ class TranslateExecutablesPass
     OpPassManager passManager(executableOp.getOperationName());
     for (const auto &targetName : gatherExecutableTargetNames(executableOp)) {
       passManager.addNestedPass<IREE::HAL::ExecutableVariantOp>(
-          createTranslateTargetExecutableVariantsPass(targetName));
+          createTranslateTargetExecutableVariantsPass(
+              targetName, targetOptions_.executableCacheDir));
     }
     if (failed(runPipeline(passManager, executableOp))) {
       executableOp.emitError() << "failed to serialize executables";
       return signalPassFailure();
     }
   }
+
+ private:
+  TargetOptions targetOptions_;
 };
 
 std::unique_ptr<OperationPass<IREE::HAL::ExecutableOp>>
-createTranslateExecutablesPass() {
-  return std::make_unique<TranslateExecutablesPass>();
+createTranslateExecutablesPass(TargetOptions targetOptions) {
+  return std::make_unique<TranslateExecutablesPass>(targetOptions);
 }
 
 static PassRegistration<TranslateExecutablesPass> translatePass([] {
-  return std::make_unique<TranslateExecutablesPass>();
+  auto options = TargetOptions::FromFlags::get();
+  return std::make_unique<TranslateExecutablesPass>(options);
 });
 
 }  // namespace HAL
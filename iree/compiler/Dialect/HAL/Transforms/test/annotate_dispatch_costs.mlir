@@ -0,0 +1,79 @@
+// RUN: iree-opt -split-input-file -pass-pipeline='hal.executable(iree-hal-annotate-dispatch-costs)' %s | FileCheck %s
+
+#executable_layout = #hal.executable.layout<push_constants = 0, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>,
+    #hal.descriptor_set.binding<1, storage_buffer>,
+    #hal.descriptor_set.binding<2, storage_buffer>,
+    #hal.descriptor_set.binding<3, storage_buffer>
+  ]>
+]>
+
+// Tests that the cost of a distributed matmul is estimated from the full
+// bindings and not the tiles each workgroup operates on.
+
+// CHECK-LABEL: hal.executable private @static_matmul
+hal.executable private @static_matmul {
+  hal.executable.variant @embedded_elf_x86_64, target = #hal.executable.target<"llvm", "embedded-elf-x86_64"> {
+    // 4*8*16 iterations * (mulf + addf) = 1024
+    // 4x16xf32 + 16x8xf32 + 4x8xf32 = 896 bytes read, 4x8xf32 = 128 written
+    // CHECK: hal.executable.entry_point public @static_matmul
+    // CHECK-SAME: hal.dispatch.cost = {flops = 1024 : i64, read_bytes = 896 : i64, write_bytes = 128 : i64}
+    hal.executable.entry_point @static_matmul layout(#executable_layout)
+    builtin.module {
+      func @static_matmul() {
+        %c0 = arith.constant 0 : index
+        %c4 = arith.constant 4 : index
+        %c8 = arith.constant 8 : index
+        %0 = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) : !flow.dispatch.tensor<readonly:4x16xf32>
+        %1 = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) : !flow.dispatch.tensor<readonly:16x8xf32>
+        %2 = hal.interface.binding.subspan set(0) binding(2) type(storage_buffer) : !flow.dispatch.tensor<readonly:4x8xf32>
+        %3 = hal.interface.binding.subspan set(0) binding(3) type(storage_buffer) : !flow.dispatch.tensor<writeonly:4x8xf32>
+        %workgroup_size_x = hal.interface.workgroup.size[0] : index
+        %workgroup_id_x = hal.interface.workgroup.id[0] : index
+        %workgroup_count_x = hal.interface.workgroup.count[0] : index
+        %4 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_size_x, %workgroup_id_x]
+        %5 = affine.apply affine_map<()[s0, s1] -> (s0 * s1)>()[%workgroup_size_x, %workgroup_count_x]
+        scf.for %arg0 = %4 to %c8 step %5 {
+          %6 = affine.min affine_map<(d0)[s0] -> (s0, -d0 + 8)>(%arg0)[%workgroup_size_x]
+          %7 = flow.dispatch.tensor.load %0, offsets = [0, 0], sizes = [4, 16], strides = [1, 1] : !flow.dispatch.tensor<readonly:4x16xf32> -> tensor<4x16xf32>
+          %8 = flow.dispatch.tensor.load %1, offsets = [0, %arg0], sizes = [16, %6], strides = [1, 1] : !flow.dispatch.tensor<readonly:16x8xf32> -> tensor<16x?xf32>
+          %9 = flow.dispatch.tensor.load %2, offsets = [0, %arg0], sizes = [4, %6], strides = [1, 1] : !flow.dispatch.tensor<readonly:4x8xf32> -> tensor<4x?xf32>
+          %10 = linalg.matmul ins(%7, %8 : tensor<4x16xf32>, tensor<16x?xf32>) outs(%9 : tensor<4x?xf32>) -> tensor<4x?xf32>
+          flow.dispatch.tensor.store %10, %3, offsets = [0, %arg0], sizes = [4, %6], strides = [1, 1] : tensor<4x?xf32> -> !flow.dispatch.tensor<writeonly:4x8xf32>
+        }
+        return
+      }
+    }
+  }
+}
+
+// -----
+
+#executable_layout = #hal.executable.layout<push_constants = 1, sets = [
+  #hal.descriptor_set.layout<0, bindings = [
+    #hal.descriptor_set.binding<0, storage_buffer>,
+    #hal.descriptor_set.binding<1, storage_buffer>
+  ]>
+]>
+
+// Tests that dynamically-shaped dispatches are not annotated.
+
+// CHECK-LABEL: hal.executable private @dynamic_copy
+hal.executable private @dynamic_copy {
+  hal.executable.variant @embedded_elf_x86_64, target = #hal.executable.target<"llvm", "embedded-elf-x86_64"> {
+    // CHECK: hal.executable.entry_point public @dynamic_copy
+    // CHECK-NOT: hal.dispatch.cost
+    hal.executable.entry_point @dynamic_copy layout(#executable_layout)
+    builtin.module {
+      func @dynamic_copy() {
+        %n = hal.interface.constant.load[0] : index
+        %0 = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) : !flow.dispatch.tensor<readonly:?xf32>{%n}
+        %1 = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) : !flow.dispatch.tensor<writeonly:?xf32>{%n}
+        %2 = flow.dispatch.tensor.load %0, offsets = [0], sizes = [%n], strides = [1] : !flow.dispatch.tensor<readonly:?xf32>{%n} -> tensor<?xf32>
+        flow.dispatch.tensor.store %2, %1, offsets = [0], sizes = [%n], strides = [1] : tensor<?xf32> -> !flow.dispatch.tensor<writeonly:?xf32>{%n}
+        return
+      }
+    }
+  }
+}
@@ -48,18 +48,18 @@ module attributes {hal.device.targets = [#device_target_cpu]}  {
     // CHECK-DAG: %[[DEVICE:.+]] = hal.ex.shared_device : !hal.device
     // CHECK-DAG: %[[ALLOCATOR:.+]] = hal.device.allocator<%[[DEVICE]] : !hal.device> : !hal.allocator
 
-    // CHECK: hal.buffer.assert<%[[ARG0_BUFFER]] : !hal.buffer>
+    // CHECK: %[[ARG0_IMPORT:.+]] = hal.allocator.import<%[[ALLOCATOR]] : !hal.allocator>
+    // CHECK-SAME: source(%[[ARG0_BUFFER]] : !hal.buffer)
     // CHECK-SAME: message("tensor")
-    // CHECK-SAME: allocator(%[[ALLOCATOR]] : !hal.allocator)
     // CHECK-SAME: minimum_length(%c16)
     // CHECK-SAME: type(DeviceVisible)
     // CHECK-SAME: usage("Transfer|Dispatch")
     %arg0_resource = stream.tensor.import %arg0 : !hal.buffer_view -> tensor<4xf32> in !stream.resource<external>{%c16}
 
     // CHECK: %[[ARG1_BUFFER:.+]] = hal.buffer_view.buffer<%[[ARG1]] : !hal.buffer_view> : !hal.buffer
-    // CHECK: hal.buffer.assert<%[[ARG1_BUFFER]] : !hal.buffer>
+    // CHECK: %[[ARG1_IMPORT:.+]] = hal.allocator.import<%[[ALLOCATOR]] : !hal.allocator>
+    // CHECK-SAME: source(%[[ARG1_BUFFER]] : !hal.buffer)
     // CHECK-SAME: message("tensor")
-    // CHECK-SAME: allocator(%[[ALLOCATOR]] : !hal.allocator)
     // CHECK-SAME: minimum_length(%c16)
     // CHECK-SAME: type(DeviceVisible)
     // CHECK-SAME: usage("Transfer|Dispatch")
@@ -89,8 +89,8 @@ module attributes {hal.device.targets = [#device_target_cpu]}  {
       // CHECK:   hal.command_buffer.push_descriptor_set<%[[CMD]] : !hal.command_buffer>
       // CHECK-SAME: layout(%[[EXECUTABLE_LAYOUT]] : !hal.executable_layout)[%c0]
       // CHECK-SAME: bindings([
-      // CHECK:     %c0 = (%[[ARG0_BUFFER]] : !hal.buffer)[%c0, %c16],
-      // CHECK:     %c1 = (%[[ARG1_BUFFER]] : !hal.buffer)[%c0, %c16],
+      // CHECK:     %c0 = (%[[ARG0_IMPORT]] : !hal.buffer)[%c0, %c16],
+      // CHECK:     %c1 = (%[[ARG1_IMPORT]] : !hal.buffer)[%c0, %c16],
       // CHECK:     %c2 = (%[[RESULT_BUFFER]] : !hal.buffer)[%c0, %c16]
       // CHECK:   ])
       // CHECK:   hal.command_buffer.dispatch.symbol<%[[CMD]] : !hal.command_buffer>
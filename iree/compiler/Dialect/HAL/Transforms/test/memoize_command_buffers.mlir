@@ -0,0 +1,77 @@
+// RUN: iree-opt -split-input-file -iree-hal-materialize-resource-caches -iree-hal-memoize-command-buffers %s | FileCheck %s
+
+// Tests that a command buffer only referencing constants and immutable globals
+// is recorded once in an initializer.
+
+util.global private @buffer : !hal.buffer
+
+//      CHECK: util.global private @_command_buffer_0 : !hal.command_buffer
+// CHECK-NEXT: util.initializer {
+// CHECK-NEXT:   %[[DEVICE:.+]] = hal.ex.shared_device : !hal.device
+// CHECK-NEXT:   %[[BUFFER:.+]] = util.global.load @buffer : !hal.buffer
+//  CHECK-DAG:   %[[C0:.+]] = arith.constant 0 : index
+//  CHECK-DAG:   %[[C128:.+]] = arith.constant 128 : index
+//  CHECK-DAG:   %[[PATTERN:.+]] = arith.constant 1 : i32
+//      CHECK:   %[[CMD:.+]] = hal.command_buffer.create device(%[[DEVICE]] : !hal.device) mode(Reusable) categories("Transfer|Dispatch")
+// CHECK-NEXT:   hal.command_buffer.begin<%[[CMD]] : !hal.command_buffer>
+// CHECK-NEXT:   hal.command_buffer.fill_buffer<%[[CMD]] : !hal.command_buffer> target(%[[BUFFER]] : !hal.buffer)[%[[C0]], %[[C128]]] pattern(%[[PATTERN]] : i32)
+// CHECK-NEXT:   hal.command_buffer.execution_barrier<%[[CMD]] : !hal.command_buffer>
+// CHECK-NEXT:   hal.command_buffer.end<%[[CMD]] : !hal.command_buffer>
+// CHECK-NEXT:   util.global.store %[[CMD]], @_command_buffer_0 : !hal.command_buffer
+// CHECK-NEXT:   util.initializer.return
+
+// CHECK-LABEL: func @staticRecording
+func @staticRecording() {
+  %device = hal.ex.shared_device : !hal.device
+  %buffer = util.global.load @buffer : !hal.buffer
+  %c0 = arith.constant 0 : index
+  %c128 = arith.constant 128 : index
+  %pattern = arith.constant 1 : i32
+  // CHECK-NOT: hal.command_buffer.create
+  // CHECK: %[[CMD:.+]] = util.global.load @_command_buffer_0 : !hal.command_buffer
+  %cmd = hal.command_buffer.create device(%device : !hal.device)
+                                     mode("OneShot|AllowInlineExecution")
+                               categories("Transfer|Dispatch") : !hal.command_buffer
+  // CHECK-NOT: hal.command_buffer.begin
+  hal.command_buffer.begin<%cmd : !hal.command_buffer>
+  hal.command_buffer.fill_buffer<%cmd : !hal.command_buffer>
+      target(%buffer : !hal.buffer)[%c0, %c128]
+      pattern(%pattern : i32)
+  hal.command_buffer.execution_barrier<%cmd : !hal.command_buffer>
+      source(CommandIssue)
+      target(CommandProcess)
+      flags(None)
+  // CHECK-NOT: hal.command_buffer.end
+  hal.command_buffer.end<%cmd : !hal.command_buffer>
+  // CHECK: hal.ex.submit_and_wait %{{.+}}, %[[CMD]]
+  hal.ex.submit_and_wait %device, %cmd
+  return
+}
+
+// -----
+
+// Tests that command buffers referencing per-invocation buffers are recorded
+// on each invocation.
+
+// CHECK-NOT: util.global private @_command_buffer_0
+// CHECK-LABEL: func @dynamicRecording
+func @dynamicRecording(%buffer: !hal.buffer) {
+  %device = hal.ex.shared_device : !hal.device
+  %c0 = arith.constant 0 : index
+  %c128 = arith.constant 128 : index
+  %pattern = arith.constant 1 : i32
+  // CHECK: hal.command_buffer.create
+  %cmd = hal.command_buffer.create device(%device : !hal.device)
+                                     mode("OneShot|AllowInlineExecution")
+                               categories("Transfer|Dispatch") : !hal.command_buffer
+  // CHECK: hal.command_buffer.begin
+  hal.command_buffer.begin<%cmd : !hal.command_buffer>
+  // CHECK: hal.command_buffer.fill_buffer
+  hal.command_buffer.fill_buffer<%cmd : !hal.command_buffer>
+      target(%buffer : !hal.buffer)[%c0, %c128]
+      pattern(%pattern : i32)
+  // CHECK: hal.command_buffer.end
+  hal.command_buffer.end<%cmd : !hal.command_buffer>
+  hal.ex.submit_and_wait %device, %cmd
+  return
+}
@@ -0,0 +1,61 @@
+// RUN: iree-opt -split-input-file -iree-hal-memoize-shape-computations %s | FileCheck %s
+
+// CHECK-DAG: util.global private mutable @_shape_math_shape_cache_valid = false
+// CHECK-DAG: util.global private mutable @_shape_math_shape_cache_key_0 : index
+// CHECK-DAG: util.global private mutable @_shape_math_shape_cache_key_1 : index
+// CHECK-DAG: util.global private mutable @_shape_math_shape_cache_value_0 : index
+
+// CHECK-LABEL: func @shape_math
+// CHECK-SAME: (%[[VIEW:.+]]: !hal.buffer_view, %[[ARG:.+]]: index)
+func @shape_math(%view: !hal.buffer_view, %arg: index) -> index {
+  // CHECK: %[[DIM:.+]] = hal.buffer_view.dim
+  %dim = hal.buffer_view.dim<%view : !hal.buffer_view>[0] : index
+  // CHECK-NEXT: %[[VALID:.+]] = util.global.load @_shape_math_shape_cache_valid : i1
+  // CHECK-NEXT: %[[KEY0:.+]] = util.global.load @_shape_math_shape_cache_key_0 : index
+  // CHECK-NEXT: %[[EQ0:.+]] = arith.cmpi eq, %[[ARG]], %[[KEY0]] : index
+  // CHECK-NEXT: %[[HIT0:.+]] = arith.andi %[[VALID]], %[[EQ0]] : i1
+  // CHECK-NEXT: %[[KEY1:.+]] = util.global.load @_shape_math_shape_cache_key_1 : index
+  // CHECK-NEXT: %[[EQ1:.+]] = arith.cmpi eq, %[[DIM]], %[[KEY1]] : index
+  // CHECK-NEXT: %[[HIT:.+]] = arith.andi %[[HIT0]], %[[EQ1]] : i1
+  // CHECK-NEXT: %[[RESULT:.+]] = scf.if %[[HIT]] -> (index) {
+  // CHECK-NEXT:   %[[CACHED:.+]] = util.global.load @_shape_math_shape_cache_value_0 : index
+  // CHECK-NEXT:   scf.yield %[[CACHED]] : index
+  // CHECK-NEXT: } else {
+  // CHECK:        %[[NEW:.+]] = arith.shli
+  // CHECK-NEXT:   util.global.store %[[NEW]], @_shape_math_shape_cache_value_0 : index
+  // CHECK-NEXT:   util.global.store %[[ARG]], @_shape_math_shape_cache_key_0 : index
+  // CHECK-NEXT:   util.global.store %[[DIM]], @_shape_math_shape_cache_key_1 : index
+  // CHECK-NEXT:   %[[TRUE:.+]] = arith.constant true
+  // CHECK-NEXT:   util.global.store %[[TRUE]], @_shape_math_shape_cache_valid : i1
+  // CHECK-NEXT:   scf.yield %[[NEW]] : index
+  // CHECK-NEXT: }
+  %c4 = arith.constant 4 : index
+  %c16 = arith.constant 16 : index
+  %c64 = arith.constant 64 : index
+  %0 = arith.addi %arg, %c4 : index
+  %1 = arith.muli %0, %dim : index
+  %2 = arith.addi %1, %c16 : index
+  %3 = arith.divui %2, %c16 : index
+  %4 = arith.muli %3, %c64 : index
+  %5 = arith.subi %4, %arg : index
+  %6 = arith.remui %5, %c64 : index
+  %7 = arith.addi %6, %dim : index
+  %8 = arith.shli %7, %3 : index
+  // CHECK: return %[[RESULT]]
+  return %8 : index
+}
+
+// -----
+
+// Too few ops to be worth caching.
+
+// CHECK-NOT: util.global
+// CHECK-LABEL: func @cheap_shape_math
+func @cheap_shape_math(%view: !hal.buffer_view) -> index {
+  %c4 = arith.constant 4 : index
+  %dim = hal.buffer_view.dim<%view : !hal.buffer_view>[0] : index
+  // CHECK-NOT: scf.if
+  // CHECK: arith.muli
+  %0 = arith.muli %dim, %c4 : index
+  return %0 : index
+}
@@ -0,0 +1,51 @@
+// RUN: iree-opt -split-input-file -pass-pipeline='builtin.func(iree-hal-pack-command-buffers)' %s | FileCheck %s
+
+// Tests that a run of commands is packed into a single command stream with
+// constants inlined and dynamic values passed alongside.
+
+// CHECK-LABEL: @packCommands
+// CHECK-SAME: (%[[CMD:.+]]: !hal.command_buffer, %[[LAYOUT:.+]]: !hal.executable_layout, %[[EXE:.+]]: !hal.executable, %[[X:.+]]: index)
+func @packCommands(%cmd: !hal.command_buffer, %executable_layout: !hal.executable_layout, %executable: !hal.executable, %x: index) {
+  %c1 = arith.constant 1 : index
+  %c42_i32 = arith.constant 42 : i32
+  // CHECK-NOT: hal.command_buffer.push_constants
+  hal.command_buffer.push_constants<%cmd : !hal.command_buffer> layout(%executable_layout : !hal.executable_layout) offset(0) values([%c42_i32]) : i32
+  // CHECK-NOT: hal.command_buffer.execution_barrier
+  hal.command_buffer.execution_barrier<%cmd : !hal.command_buffer> source("Dispatch") target("Dispatch") flags("None")
+  // CHECK-NOT: hal.command_buffer.dispatch
+  // CHECK-DAG: %[[COMMANDS:.+]] = util.byte_buffer.constant {alignment = 4 : i64} : !util.byte_buffer = dense<[772, 0, 0, 42, 769, 4, 4, 0, 1286, 1, 0, -2147483648, 1, 1]> : vector<14xi32>
+  // CHECK-DAG: %[[X_I32:.+]] = arith.index_cast %[[X]] : index to i32
+  // CHECK: hal.command_buffer.execute_commands<%[[CMD]] : !hal.command_buffer>
+  // CHECK-SAME: commands(%[[COMMANDS]] : !util.byte_buffer)
+  // CHECK-SAME: refs([%[[LAYOUT]], %[[EXE]] : !hal.executable_layout, !hal.executable])
+  // CHECK-SAME: values([%[[X_I32]]]) : i32
+  hal.command_buffer.dispatch<%cmd : !hal.command_buffer> target(%executable : !hal.executable)[0] workgroups([%x, %c1, %c1])
+  // CHECK-NEXT: hal.command_buffer.end<%[[CMD]] : !hal.command_buffer>
+  hal.command_buffer.end<%cmd : !hal.command_buffer>
+  return
+}
+
+// -----
+
+// Tests that runs are split around other uses of the command buffer and that
+// single commands are left unpacked.
+
+// CHECK-LABEL: @splitRuns
+func @splitRuns(%cmd: !hal.command_buffer, %buffer: !hal.buffer, %executable: !hal.executable) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c128 = arith.constant 128 : index
+  %c0_i8 = arith.constant 0 : i8
+  // CHECK: hal.command_buffer.fill_buffer
+  hal.command_buffer.fill_buffer<%cmd : !hal.command_buffer> target(%buffer : !hal.buffer)[%c0, %c128] pattern(%c0_i8 : i8)
+  // CHECK-NEXT: hal.command_buffer.begin_debug_group
+  hal.command_buffer.begin_debug_group<%cmd : !hal.command_buffer> label("group")
+  // CHECK-NEXT: util.byte_buffer.constant
+  // CHECK-SAME: dense<[1282, 0, 0, 128, 0, 1, 1286, 1, 0, 1, 1, 1]>
+  // CHECK-NEXT: hal.command_buffer.execute_commands
+  hal.command_buffer.fill_buffer<%cmd : !hal.command_buffer> target(%buffer : !hal.buffer)[%c0, %c128] pattern(%c0_i8 : i8)
+  hal.command_buffer.dispatch<%cmd : !hal.command_buffer> target(%executable : !hal.executable)[0] workgroups([%c1, %c1, %c1])
+  // CHECK-NEXT: hal.command_buffer.end_debug_group
+  hal.command_buffer.end_debug_group<%cmd : !hal.command_buffer>
+  return
+}
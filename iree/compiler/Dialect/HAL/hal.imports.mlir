@@ -28,6 +28,17 @@ vm.import @allocator.allocate(
   %allocation_size : i32
 ) -> !vm.ref<!hal.buffer>
 
+// Imports an external buffer for use with the allocator. Compatible buffers
+// are returned as-is and others are copied into a new allocation.
+vm.import @allocator.import(
+  %allocator : !vm.ref<!hal.allocator>,
+  %source : !vm.ref<!hal.buffer>,
+  %message : !vm.buffer,
+  %minimum_length : i32,
+  %memory_types : i32,
+  %buffer_usage : i32
+) -> !vm.ref<!hal.buffer>
+
 // Maps a host byte buffer into a device buffer.
 // If try!=0 then returns null if the given memory type cannot be mapped.
 // Host-local+constant requests will always succeed.
@@ -224,6 +235,15 @@ vm.import @command_buffer.copy_buffer(
   %length : i32
 )
 
+// Records a packed command stream. Command operands reference |refs| and
+// |values| by ordinal.
+vm.import @command_buffer.execute_commands(
+  %command_buffer : !vm.ref<!hal.command_buffer>,
+  %commands : !vm.buffer,
+  %refs : !vm.list<?>,
+  %values : i32 ...
+)
+
 // Pushes constants for consumption by dispatches.
 vm.import @command_buffer.push_constants(
   %command_buffer : !vm.ref<!hal.command_buffer>,
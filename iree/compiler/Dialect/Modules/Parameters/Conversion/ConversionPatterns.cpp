@@ -0,0 +1,89 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Dialect/Modules/Parameters/Conversion/ConversionPatterns.h"
+
+#include "iree/compiler/Dialect/HAL/IR/HALOps.h"
+#include "iree/compiler/Dialect/Modules/Parameters/IR/ParametersOps.h"
+#include "iree/compiler/Dialect/VM/Conversion/ImportUtils.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Transforms/DialectConversion.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace Parameters {
+
+namespace {
+
+// Assigns the allocator and placement of a tensor-level parameter load.
+// Loaded parameters are only ever used as constants and are placed in
+// device-local memory so that importing them into the program does not copy.
+struct LoadOpPlacementPattern : public OpConversionPattern<LoadOp> {
+  using OpConversionPattern::OpConversionPattern;
+  LogicalResult matchAndRewrite(
+      LoadOp loadOp, OpAdaptor adaptor,
+      ConversionPatternRewriter &rewriter) const override {
+    if (loadOp.allocator()) return failure();
+    auto loc = loadOp.getLoc();
+
+    // Matches the shared device used when converting stream ops.
+    auto device = rewriter.create<IREE::HAL::ExSharedDeviceOp>(loc);
+    auto allocator =
+        rewriter.create<IREE::HAL::DeviceAllocatorOp>(loc, device.result());
+
+    auto memoryTypes = IREE::HAL::MemoryTypeBitfield::DeviceLocal;
+    auto bufferUsage = IREE::HAL::BufferUsageBitfield::Constant |
+                       IREE::HAL::BufferUsageBitfield::Transfer |
+                       IREE::HAL::BufferUsageBitfield::Dispatch;
+    rewriter.replaceOpWithNewOp<LoadOp>(
+        loadOp, loadOp.result().getType(), allocator.result(),
+        loadOp.keyAttr(), adaptor.offset(), adaptor.length(),
+        IREE::HAL::MemoryTypeBitfieldAttr::get(rewriter.getContext(),
+                                               memoryTypes),
+        IREE::HAL::BufferUsageBitfieldAttr::get(rewriter.getContext(),
+                                                bufferUsage));
+    return success();
+  }
+};
+
+// Loads must have been placed by HAL conversion as the allocator and
+// placement are passed to the runtime import.
+struct LoadOpImportConversion : public VMImportOpConversion<LoadOp> {
+  using VMImportOpConversion::VMImportOpConversion;
+  LogicalResult matchAndRewrite(
+      LoadOp loadOp, OpAdaptor adaptor,
+      ConversionPatternRewriter &rewriter) const override {
+    if (!loadOp.allocator()) {
+      return rewriter.notifyMatchFailure(loadOp, "load has no allocator");
+    }
+    return VMImportOpConversion::matchAndRewrite(loadOp, adaptor, rewriter);
+  }
+};
+
+}  // namespace
+
+void populateParametersToVMPatterns(MLIRContext *context,
+                                    SymbolTable &importSymbols,
+                                    RewritePatternSet &patterns,
+                                    TypeConverter &typeConverter) {
+  patterns.insert<LoadOpImportConversion>(context, importSymbols,
+                                          typeConverter, "parameters.load");
+}
+
+void populateParametersToHALPatterns(MLIRContext *context,
+                                     ConversionTarget &target,
+                                     RewritePatternSet &patterns,
+                                     TypeConverter &typeConverter) {
+  target.addDynamicallyLegalOp<LoadOp>(
+      [](LoadOp op) { return op.allocator() != nullptr; });
+  patterns.insert<LoadOpPlacementPattern>(typeConverter, context);
+}
+
+}  // namespace Parameters
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
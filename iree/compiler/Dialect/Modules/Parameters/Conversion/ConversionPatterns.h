@@ -0,0 +1,36 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_COMPILER_DIALECT_MODULES_PARAMETERS_CONVERSION_CONVERSION_PATTERNS_H_
+#define IREE_COMPILER_DIALECT_MODULES_PARAMETERS_CONVERSION_CONVERSION_PATTERNS_H_
+
+#include "mlir/Pass/Pass.h"
+#include "mlir/Transforms/DialectConversion.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace Parameters {
+
+// Populates conversion patterns from the Parameters dialect to the VM dialect.
+void populateParametersToVMPatterns(MLIRContext *context,
+                                    SymbolTable &importSymbols,
+                                    RewritePatternSet &patterns,
+                                    TypeConverter &typeConverter);
+
+// Populates conversion patterns from the Parameters dialect to the HAL dialect.
+// Assigns an allocator and buffer placement to tensor-level loads.
+void populateParametersToHALPatterns(MLIRContext *context,
+                                     ConversionTarget &target,
+                                     RewritePatternSet &patterns,
+                                     TypeConverter &typeConverter);
+
+}  // namespace Parameters
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
+
+#endif  // IREE_COMPILER_DIALECT_MODULES_PARAMETERS_CONVERSION_CONVERSION_PATTERNS_H_
@@ -0,0 +1,14 @@
+// RUN: iree-opt -split-input-file -iree-hal-conversion %s | FileCheck %s
+
+// CHECK-LABEL: @load
+func @load() -> !hal.buffer {
+  %offset = arith.constant 0 : index
+  %length = arith.constant 128 : index
+  // CHECK: %[[DEVICE:.+]] = hal.ex.shared_device
+  // CHECK: %[[ALLOCATOR:.+]] = hal.device.allocator<%[[DEVICE]] : !hal.device>
+  // CHECK: %[[BUFFER:.+]] = parameters.load<%[[ALLOCATOR]] : !hal.allocator> "weight"[%c0 for %c128]
+  // CHECK-SAME: type(DeviceLocal) usage({{.+}}) : !hal.buffer
+  %buffer = parameters.load "weight"[%offset for %length] : !hal.buffer
+  // CHECK: return %[[BUFFER]]
+  return %buffer : !hal.buffer
+}
@@ -0,0 +1,12 @@
+// RUN: iree-opt -split-input-file -iree-vm-conversion %s | FileCheck %s
+
+// CHECK-LABEL: vm.func private @load
+// CHECK-SAME: %[[ALLOCATOR:[a-zA-Z0-9$._-]+]]
+func @load(%allocator : !hal.allocator) -> !hal.buffer {
+  %offset = arith.constant 64 : index
+  %length = arith.constant 128 : index
+  // CHECK-DAG: %[[KEY:.+]] = vm.rodata.inline "_utf8_weight_
+  // CHECK: = vm.call @parameters.load(%[[ALLOCATOR]], %c48, %c{{[0-9]+}}, %[[KEY]], %c64, %c128) : (!vm.ref<!hal.allocator>, i32, i32, !vm.buffer, i32, i32) -> !vm.ref<!hal.buffer>
+  %buffer = parameters.load<%allocator : !hal.allocator> "weight"[%offset for %length] type(DeviceLocal) usage(Dispatch) : !hal.buffer
+  return %buffer : !hal.buffer
+}
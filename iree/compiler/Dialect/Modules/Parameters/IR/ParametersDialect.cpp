@@ -0,0 +1,71 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Dialect/Modules/Parameters/IR/ParametersDialect.h"
+
+#include "iree/compiler/Dialect/HAL/Conversion/ConversionDialectInterface.h"
+#include "iree/compiler/Dialect/Modules/Parameters/Conversion/ConversionPatterns.h"
+#include "iree/compiler/Dialect/Modules/Parameters/IR/ParametersOps.h"
+#include "iree/compiler/Dialect/Modules/Parameters/parameters.imports.h"
+#include "iree/compiler/Dialect/VM/Conversion/ConversionDialectInterface.h"
+#include "mlir/IR/PatternMatch.h"
+#include "mlir/Parser.h"
+#include "mlir/Transforms/DialectConversion.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace Parameters {
+
+namespace {
+class ParametersToVMConversionInterface : public VMConversionDialectInterface {
+ public:
+  using VMConversionDialectInterface::VMConversionDialectInterface;
+
+  OwningOpRef<mlir::ModuleOp> parseVMImportModule() const override {
+    return mlir::parseSourceString(
+        StringRef(iree_parameters_imports_create()->data,
+                  iree_parameters_imports_create()->size),
+        getDialect()->getContext());
+  }
+
+  void populateVMConversionPatterns(
+      SymbolTable &importSymbols, RewritePatternSet &patterns,
+      TypeConverter &typeConverter) const override {
+    populateParametersToVMPatterns(getDialect()->getContext(), importSymbols,
+                                   patterns, typeConverter);
+  }
+};
+
+class ParametersToHALConversionInterface
+    : public HALConversionDialectInterface {
+ public:
+  using HALConversionDialectInterface::HALConversionDialectInterface;
+
+  void setupConversionTarget(ConversionTarget &target,
+                             RewritePatternSet &patterns,
+                             TypeConverter &typeConverter) const override {
+    populateParametersToHALPatterns(getDialect()->getContext(), target,
+                                    patterns, typeConverter);
+  }
+};
+}  // namespace
+
+ParametersDialect::ParametersDialect(MLIRContext *context)
+    : Dialect(getDialectNamespace(), context,
+              TypeID::get<ParametersDialect>()) {
+  addInterfaces<ParametersToVMConversionInterface>();
+  addInterfaces<ParametersToHALConversionInterface>();
+#define GET_OP_LIST
+  addOperations<
+#include "iree/compiler/Dialect/Modules/Parameters/IR/ParametersOps.cpp.inc"
+      >();
+}
+
+}  // namespace Parameters
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
@@ -0,0 +1,28 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_COMPILER_DIALECT_MODULES_PARAMETERS_IR_PARAMETERS_DIALECT_H_
+#define IREE_COMPILER_DIALECT_MODULES_PARAMETERS_IR_PARAMETERS_DIALECT_H_
+
+#include "mlir/IR/Dialect.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace Parameters {
+
+class ParametersDialect : public Dialect {
+ public:
+  explicit ParametersDialect(MLIRContext *context);
+  static StringRef getDialectNamespace() { return "parameters"; }
+};
+
+}  // namespace Parameters
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
+
+#endif  // IREE_COMPILER_DIALECT_MODULES_PARAMETERS_IR_PARAMETERS_DIALECT_H_
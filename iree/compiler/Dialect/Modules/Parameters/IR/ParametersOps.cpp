@@ -0,0 +1,35 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Dialect/Modules/Parameters/IR/ParametersOps.h"
+
+#include "mlir/IR/OpImplementation.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace Parameters {
+
+static LogicalResult verifyLoadOp(LoadOp op) {
+  // The allocator and the placement it implies are populated together during
+  // HAL conversion.
+  bool hasAllocator = op.allocator() != nullptr;
+  if (op.memory_types().hasValue() != hasAllocator ||
+      op.buffer_usage().hasValue() != hasAllocator) {
+    return op.emitOpError()
+           << "memory types and buffer usage must be specified if and only if "
+              "an allocator is";
+  }
+  return success();
+}
+
+}  // namespace Parameters
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
+
+#define GET_OP_CLASSES
+#include "iree/compiler/Dialect/Modules/Parameters/IR/ParametersOps.cpp.inc"
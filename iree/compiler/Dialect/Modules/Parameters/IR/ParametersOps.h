@@ -0,0 +1,17 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_COMPILER_DIALECT_MODULES_PARAMETERS_IR_PARAMETERS_OPS_H_
+#define IREE_COMPILER_DIALECT_MODULES_PARAMETERS_IR_PARAMETERS_OPS_H_
+
+#include "iree/compiler/Dialect/HAL/IR/HALTypes.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/OpDefinition.h"
+
+#define GET_OP_CLASSES
+#include "iree/compiler/Dialect/Modules/Parameters/IR/ParametersOps.h.inc"  // IWYU pragma: export
+
+#endif  // IREE_COMPILER_DIALECT_MODULES_PARAMETERS_IR_PARAMETERS_OPS_H_
@@ -0,0 +1,165 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <memory>
+#include <utility>
+
+#include "iree/compiler/Dialect/HAL/IR/HALDialect.h"
+#include "iree/compiler/Dialect/HAL/IR/HALOps.h"
+#include "iree/compiler/Dialect/Modules/Parameters/IR/ParametersDialect.h"
+#include "iree/compiler/Dialect/Modules/Parameters/IR/ParametersOps.h"
+#include "iree/compiler/Dialect/Modules/Parameters/Transforms/Passes.h"
+#include "iree/compiler/Dialect/Util/IR/UtilDialect.h"
+#include "iree/compiler/Dialect/Util/IR/UtilOps.h"
+#include "iree/compiler/Dialect/Util/IR/UtilTypes.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/ToolOutputFile.h"
+#include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
+#include "mlir/IR/Attributes.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Diagnostics.h"
+#include "mlir/Pass/Pass.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace Parameters {
+
+// Returns the contents of |globalOp| if it is a constant that can be served as
+// a parameter. Parameters are imported as-is so only byte-aligned element
+// types whose host and device layouts match are supported.
+static IREE::Util::SerializableAttrInterface getExternalizableValue(
+    IREE::Util::GlobalOp globalOp) {
+  if (globalOp.isMutable()) return {};
+  auto tensorType = globalOp.type().dyn_cast<RankedTensorType>();
+  if (!tensorType || !tensorType.hasStaticShape()) return {};
+  auto elementType = tensorType.getElementType();
+  if (!elementType.isIntOrFloat() ||
+      elementType.getIntOrFloatBitWidth() % 8 != 0) {
+    return {};
+  }
+  // Splats are left in the program as they turn into fills.
+  auto elementsAttr =
+      globalOp.initial_valueAttr().dyn_cast_or_null<DenseElementsAttr>();
+  if (!elementsAttr || elementsAttr.isSplat()) return {};
+  return elementsAttr.dyn_cast<IREE::Util::SerializableAttrInterface>();
+}
+
+// Writes |value| to `<outputDirectory>/<key>.bin`.
+static LogicalResult writeParameterFile(
+    Location loc, StringRef outputDirectory, StringRef key,
+    IREE::Util::SerializableAttrInterface value) {
+  SmallString<128> filePath(outputDirectory);
+  llvm::sys::path::append(filePath, key + ".bin");
+  std::error_code error;
+  auto file = std::make_unique<llvm::ToolOutputFile>(filePath, error,
+                                                     llvm::sys::fs::OF_None);
+  if (error) {
+    return mlir::emitError(loc) << "failed to open parameter file '"
+                                << filePath << "': " << error.message();
+  }
+  if (failed(value.serializeToStream(llvm::support::endianness::little,
+                                     file->os()))) {
+    return mlir::emitError(loc) << "failed to serialize parameter '" << key
+                                << "'";
+  }
+  file->keep();
+  return success();
+}
+
+// Replaces the initial value of |globalOp| with an initializer loading the
+// parameter |key| of |length| bytes.
+static void replaceWithParameterLoad(IREE::Util::GlobalOp globalOp,
+                                     StringRef key, int64_t length) {
+  auto loc = globalOp.getLoc();
+  OpBuilder moduleBuilder(globalOp);
+  moduleBuilder.setInsertionPointAfter(globalOp);
+  auto initializerOp = moduleBuilder.create<IREE::Util::InitializerOp>(loc);
+  OpBuilder builder(initializerOp.getContext());
+  builder.createBlock(&initializerOp.getBody());
+  auto offsetOp = builder.create<arith::ConstantIndexOp>(loc, 0);
+  auto lengthOp = builder.create<arith::ConstantIndexOp>(loc, length);
+  auto loadOp = builder.create<IREE::Parameters::LoadOp>(
+      loc, builder.getType<IREE::HAL::BufferType>(), /*allocator=*/Value{},
+      builder.getStringAttr(key), offsetOp, lengthOp,
+      /*memory_types=*/nullptr, /*buffer_usage=*/nullptr);
+  auto importOp = builder.create<IREE::HAL::TensorImportOp>(
+      loc, globalOp.type(), loadOp.result());
+  builder.create<IREE::Util::GlobalStoreOp>(loc, importOp.target(),
+                                            globalOp.getSymbolName());
+  builder.create<IREE::Util::InitializerReturnOp>(loc);
+  globalOp.clearInitialValue();
+}
+
+class ExternalizeGlobalsPass
+    : public PassWrapper<ExternalizeGlobalsPass,
+                         OperationPass<mlir::ModuleOp>> {
+ public:
+  ExternalizeGlobalsPass() = default;
+  ExternalizeGlobalsPass(const ExternalizeGlobalsPass &pass) {}
+  ExternalizeGlobalsPass(int64_t minimumSize, StringRef outputDirectory) {
+    this->minimumSize = minimumSize;
+    this->outputDirectory = outputDirectory.str();
+  }
+
+  StringRef getArgument() const override {
+    return "iree-parameters-externalize-globals";
+  }
+
+  StringRef getDescription() const override {
+    return "Moves large constant globals into external parameters";
+  }
+
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<mlir::arith::ArithmeticDialect>();
+    registry.insert<IREE::HAL::HALDialect>();
+    registry.insert<IREE::Parameters::ParametersDialect>();
+    registry.insert<IREE::Util::UtilDialect>();
+  }
+
+  void runOnOperation() override {
+    auto moduleOp = getOperation();
+    for (auto globalOp :
+         llvm::make_early_inc_range(moduleOp.getOps<IREE::Util::GlobalOp>())) {
+      auto value = getExternalizableValue(globalOp);
+      if (!value) continue;
+      int64_t storageSize = value.getStorageSize();
+      if (storageSize < minimumSize) continue;
+      auto key = globalOp.getSymbolName();
+      if (!outputDirectory.empty() &&
+          failed(writeParameterFile(globalOp.getLoc(), outputDirectory, key,
+                                    value))) {
+        return signalPassFailure();
+      }
+      replaceWithParameterLoad(globalOp, key, storageSize);
+    }
+  }
+
+ private:
+  Option<int64_t> minimumSize{
+      *this, "minimum-size",
+      llvm::cl::desc("Minimum size in bytes of globals to externalize."),
+      llvm::cl::init(0)};
+  Option<std::string> outputDirectory{
+      *this, "output-directory",
+      llvm::cl::desc("Directory the externalized parameters are written to."),
+      llvm::cl::init("")};
+};
+
+std::unique_ptr<OperationPass<mlir::ModuleOp>> createExternalizeGlobalsPass(
+    int64_t minimumSize, StringRef outputDirectory) {
+  return std::make_unique<ExternalizeGlobalsPass>(minimumSize,
+                                                  outputDirectory);
+}
+
+void registerParametersPasses() { PassRegistration<ExternalizeGlobalsPass>(); }
+
+}  // namespace Parameters
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
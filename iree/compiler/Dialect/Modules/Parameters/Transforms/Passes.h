@@ -0,0 +1,39 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_COMPILER_DIALECT_MODULES_PARAMETERS_TRANSFORMS_PASSES_H_
+#define IREE_COMPILER_DIALECT_MODULES_PARAMETERS_TRANSFORMS_PASSES_H_
+
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Support/LLVM.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace Parameters {
+
+// Moves the contents of large constant globals out of the module and replaces
+// them with initializers that load named parameters at runtime. Globals whose
+// contents are at least |minimumSize| bytes are externalized and keyed by
+// their symbol name. If |outputDirectory| is not empty the contents of each
+// parameter are written to `<outputDirectory>/<key>.bin` so that they can be
+// served by the runtime parameters module.
+std::unique_ptr<OperationPass<mlir::ModuleOp>> createExternalizeGlobalsPass(
+    int64_t minimumSize = 0, StringRef outputDirectory = "");
+
+//===----------------------------------------------------------------------===//
+// Register all Passes
+//===----------------------------------------------------------------------===//
+
+void registerParametersPasses();
+
+}  // namespace Parameters
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
+
+#endif  // IREE_COMPILER_DIALECT_MODULES_PARAMETERS_TRANSFORMS_PASSES_H_
@@ -0,0 +1,43 @@
+// RUN: iree-opt -split-input-file -iree-parameters-externalize-globals='minimum-size=16' %s | FileCheck %s
+
+// CHECK: util.global private @large : tensor<2x4xf32>
+// CHECK-NEXT: util.initializer {
+// CHECK-DAG:   %[[OFFSET:.+]] = arith.constant 0 : index
+// CHECK-DAG:   %[[LENGTH:.+]] = arith.constant 32 : index
+// CHECK:       %[[BUFFER:.+]] = parameters.load "large"[%[[OFFSET]] for %[[LENGTH]]] : !hal.buffer
+// CHECK:       %[[VALUE:.+]] = hal.tensor.import %[[BUFFER]] : !hal.buffer -> tensor<2x4xf32>
+// CHECK:       util.global.store %[[VALUE]], @large : tensor<2x4xf32>
+// CHECK:       util.initializer.return
+util.global private @large = dense<[[1.0, 2.0, 3.0, 4.0], [5.0, 6.0, 7.0, 8.0]]> : tensor<2x4xf32>
+
+// -----
+
+// Values below the minimum size stay in the module.
+
+// CHECK: util.global private @small = dense<[1, 2]> : tensor<2xi32>
+// CHECK-NOT: parameters.load
+util.global private @small = dense<[1, 2]> : tensor<2xi32>
+
+// -----
+
+// Splats stay in the module as they lower to fills.
+
+// CHECK: util.global private @splat = dense<1.000000e+00> : tensor<64xf32>
+// CHECK-NOT: parameters.load
+util.global private @splat = dense<1.0> : tensor<64xf32>
+
+// -----
+
+// Mutable globals may be stored to and stay in the module.
+
+// CHECK: util.global private mutable @mutable = dense<
+// CHECK-NOT: parameters.load
+util.global private mutable @mutable = dense<[1, 2, 3, 4, 5, 6, 7, 8]> : tensor<8xi32>
+
+// -----
+
+// Sub-byte elements are packed on devices and stay in the module.
+
+// CHECK: util.global private @packed = dense<
+// CHECK-NOT: parameters.load
+util.global private @packed = dense<[true, false, true, false, true, false, true, false, true, false, true, false, true, false, true, false, true, false, true, false, true, false, true, false, true, false, true, false, true, false, true, false]> : tensor<32xi1>
@@ -0,0 +1,26 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// Parameters runtime module imports.
+//
+// This is embedded in the compiler binary and inserted into any module
+// containing parameters dialect ops (parameters.*) that is lowered to the VM
+// dialect.
+vm.module @parameters {
+
+// Loads the |length| bytes at |offset| of the parameter named |key| into a
+// buffer compatible with |allocator|. A |length| of -1 loads the remainder of
+// the parameter.
+vm.import @load(
+  %allocator : !vm.ref<!hal.allocator>,
+  %memory_types : i32,
+  %buffer_usage : i32,
+  %key : !vm.buffer,
+  %offset : i32,
+  %length : i32
+) -> !vm.ref<!hal.buffer>
+
+}  // module
@@ -0,0 +1,27 @@
+// Tests the printing/parsing of the Parameters dialect ops.
+
+// RUN: iree-opt -split-input-file %s | iree-opt -split-input-file | FileCheck %s
+
+// CHECK-LABEL: @load
+func @load() -> !hal.buffer {
+  // CHECK-DAG: %[[OFFSET:.+]] = arith.constant 0
+  %offset = arith.constant 0 : index
+  // CHECK-DAG: %[[LENGTH:.+]] = arith.constant 128
+  %length = arith.constant 128 : index
+  // CHECK: = parameters.load "weight"[%[[OFFSET]] for %[[LENGTH]]] : !hal.buffer
+  %buffer = parameters.load "weight"[%offset for %length] : !hal.buffer
+  return %buffer : !hal.buffer
+}
+
+// -----
+
+// CHECK-LABEL: @loadPlaced
+// CHECK-SAME: %[[ALLOCATOR:[a-zA-Z0-9$._-]+]]
+func @loadPlaced(%allocator : !hal.allocator) -> !hal.buffer {
+  %offset = arith.constant 0 : index
+  %length = arith.constant 128 : index
+  // CHECK: = parameters.load<%[[ALLOCATOR]] : !hal.allocator> "weight"[%{{.+}} for %{{.+}}]
+  // CHECK-SAME: type(DeviceLocal) usage(Dispatch) : !hal.buffer
+  %buffer = parameters.load<%allocator : !hal.allocator> "weight"[%offset for %length] type(DeviceLocal) usage(Dispatch) : !hal.buffer
+  return %buffer : !hal.buffer
+}
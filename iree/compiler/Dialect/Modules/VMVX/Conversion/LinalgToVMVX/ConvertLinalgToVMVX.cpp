@@ -0,0 +1,446 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Dialect/Modules/VMVX/Conversion/LinalgToVMVX/ConvertLinalgToVMVX.h"
+
+#include "iree/compiler/Dialect/HAL/IR/HALOps.h"
+#include "iree/compiler/Dialect/Modules/VMVX/IR/VMVXOps.h"
+#include "iree/compiler/Dialect/Util/IR/UtilTypes.h"
+#include "llvm/ADT/STLExtras.h"
+#include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/IR/PatternMatch.h"
+
+namespace mlir {
+namespace iree_compiler {
+
+namespace {
+
+// An N-D memref expressed as an element offset, per-dimension element strides,
+// and sizes into an identity layout base memref.
+struct StridedView {
+  Value base;
+  Value offset;
+  SmallVector<Value> strides;
+  SmallVector<Value> sizes;
+};
+
+// A 2D row-major view of a rank-1 memref as taken by VMVX ops.
+struct Buffer2D {
+  Value buffer;
+  Value offset;
+  Value stride;
+  Value size0;
+  Value size1;
+};
+
+static Value materializeIndex(OpBuilder &builder, Location loc,
+                              OpFoldResult value) {
+  if (auto attr = value.dyn_cast<Attribute>()) {
+    return builder.createOrFold<arith::ConstantIndexOp>(
+        loc, attr.cast<IntegerAttr>().getInt());
+  }
+  return value.get<Value>();
+}
+
+static bool isUnitIndex(OpFoldResult value) {
+  if (auto attr = value.dyn_cast<Attribute>()) {
+    return attr.cast<IntegerAttr>().getInt() == 1;
+  }
+  return matchPattern(value.get<Value>(), m_One());
+}
+
+// Returns true if the dimensions of the identity layout |memref| are available
+// from its definition.
+static bool hasBaseDims(Value memref) {
+  if (memref.getType().cast<MemRefType>().hasStaticShape()) return true;
+  Operation *sourceOp = memref.getDefiningOp();
+  return isa_and_nonnull<IREE::Util::ShapeAwareOpInterface, memref::AllocOp,
+                         memref::AllocaOp>(sourceOp);
+}
+
+// Returns the dimensions of an identity layout |memref| that is not a view.
+static SmallVector<Value> getBaseDims(Value memref, OpBuilder &builder) {
+  auto loc = memref.getLoc();
+  auto memrefType = memref.getType().cast<MemRefType>();
+  Operation *sourceOp = memref.getDefiningOp();
+  if (auto shapeAwareOp =
+          dyn_cast_or_null<IREE::Util::ShapeAwareOpInterface>(sourceOp)) {
+    return shapeAwareOp.buildResultValueShape(memref, builder);
+  }
+  ValueRange dynamicDims;
+  if (auto allocOp = dyn_cast_or_null<memref::AllocOp>(sourceOp)) {
+    dynamicDims = allocOp.getDynamicSizes();
+  } else if (auto allocaOp = dyn_cast_or_null<memref::AllocaOp>(sourceOp)) {
+    dynamicDims = allocaOp.getDynamicSizes();
+  }
+  SmallVector<Value> dims;
+  unsigned dynamicDimIndex = 0;
+  for (int64_t dim : memrefType.getShape()) {
+    if (ShapedType::isDynamic(dim)) {
+      dims.push_back(dynamicDims[dynamicDimIndex++]);
+    } else {
+      dims.push_back(builder.create<arith::ConstantIndexOp>(loc, dim));
+    }
+  }
+  return dims;
+}
+
+// Returns true if |memref| is a rank 1 or 2 memref that resolves through
+// unit-stride subviews to an identity layout base memref and can be passed to
+// VMVX ops.
+static bool isSupportedBuffer(Value memref) {
+  auto memrefType = memref.getType().dyn_cast<MemRefType>();
+  if (!memrefType || memrefType.getRank() < 1 || memrefType.getRank() > 2) {
+    return false;
+  }
+  while (auto subViewOp = memref.getDefiningOp<memref::SubViewOp>()) {
+    if (subViewOp.getSourceType().getRank() != subViewOp.getType().getRank() ||
+        !llvm::all_of(subViewOp.getMixedStrides(), isUnitIndex)) {
+      return false;
+    }
+    memref = subViewOp.source();
+  }
+  auto baseType = memref.getType().dyn_cast<MemRefType>();
+  return baseType && baseType.getLayout().isIdentity() && hasBaseDims(memref);
+}
+
+// Resolves a supported |memref| through any subviews to its identity layout
+// base memref. Binding subspans with a byte offset are replaced by a subspan
+// at offset 0 with the byte offset folded into the element offset.
+static StridedView getStridedView(Value memref, OpBuilder &builder) {
+  auto loc = memref.getLoc();
+  if (auto subViewOp = memref.getDefiningOp<memref::SubViewOp>()) {
+    StridedView view = getStridedView(subViewOp.source(), builder);
+    for (auto offset : llvm::enumerate(subViewOp.getMixedOffsets())) {
+      Value scaledOffset = builder.createOrFold<arith::MulIOp>(
+          loc, materializeIndex(builder, loc, offset.value()),
+          view.strides[offset.index()]);
+      view.offset =
+          builder.createOrFold<arith::AddIOp>(loc, view.offset, scaledOffset);
+    }
+    view.sizes = llvm::to_vector(llvm::map_range(
+        subViewOp.getMixedSizes(), [&](OpFoldResult size) {
+          return materializeIndex(builder, loc, size);
+        }));
+    return view;
+  }
+
+  auto memrefType = memref.getType().cast<MemRefType>();
+  StridedView view;
+  view.base = memref;
+  view.offset = builder.create<arith::ConstantIndexOp>(loc, 0);
+  view.sizes = getBaseDims(memref, builder);
+  view.strides.resize(memrefType.getRank());
+  Value stride = builder.create<arith::ConstantIndexOp>(loc, 1);
+  for (int64_t i = memrefType.getRank() - 1; i >= 0; --i) {
+    view.strides[i] = stride;
+    stride = builder.createOrFold<arith::MulIOp>(loc, stride, view.sizes[i]);
+  }
+
+  auto subspanOp = memref.getDefiningOp<IREE::HAL::InterfaceBindingSubspanOp>();
+  if (subspanOp && subspanOp.byte_offset() &&
+      !matchPattern(subspanOp.byte_offset(), m_Zero())) {
+    // We assume that upper layers guarantee the byte offset is aligned to the
+    // element size as with loads and stores.
+    {
+      OpBuilder::InsertionGuard guard(builder);
+      builder.setInsertionPointAfter(subspanOp);
+      Value zero = builder.create<arith::ConstantIndexOp>(loc, 0);
+      view.base = builder.create<IREE::HAL::InterfaceBindingSubspanOp>(
+          loc, subspanOp.getType(), subspanOp.set(), subspanOp.binding(),
+          subspanOp.type(), zero, subspanOp.dynamic_dims(),
+          subspanOp.alignmentAttr());
+    }
+    Value elementByteWidth = builder.create<arith::ConstantIndexOp>(
+        loc, IREE::Util::getRoundedElementByteWidth(
+                 memrefType.getElementType()));
+    view.offset = builder.createOrFold<arith::DivUIOp>(
+        loc, subspanOp.byte_offset(), elementByteWidth);
+  }
+  return view;
+}
+
+// Returns a supported |memref| as a 2D row-major view of a rank-1 memref.
+// Rank-1 memrefs are treated as a single row.
+static Buffer2D getBuffer2D(Value memref, OpBuilder &builder) {
+  auto memrefType = memref.getType().cast<MemRefType>();
+  StridedView view = getStridedView(memref, builder);
+
+  // The base memref is flattened to rank 1 along with all of its other uses
+  // and the cast folds away after that.
+  auto loc = memref.getLoc();
+  Buffer2D buffer;
+  auto bufferType = MemRefType::get({ShapedType::kDynamicSize},
+                                    memrefType.getElementType());
+  buffer.buffer = view.base;
+  if (view.base.getType() != bufferType) {
+    buffer.buffer =
+        builder.create<UnrealizedConversionCastOp>(loc, bufferType, view.base)
+            .getResult(0);
+  }
+  buffer.offset = view.offset;
+  if (memrefType.getRank() == 2) {
+    buffer.stride = view.strides[0];
+    buffer.size0 = view.sizes[0];
+    buffer.size1 = view.sizes[1];
+  } else {
+    buffer.stride = view.sizes[0];
+    buffer.size0 = builder.create<arith::ConstantIndexOp>(loc, 1);
+    buffer.size1 = view.sizes[0];
+  }
+  return buffer;
+}
+
+static bool isSupportedElementType(Type type) {
+  return type.isF32() || type.isInteger(32);
+}
+
+// Returns true if |map| reads the same rank-1 operand for every row of a 2D
+// loop nest: `(d0, d1) -> (d1)`.
+static bool isRowBroadcastMap(AffineMap map) {
+  return map.getNumDims() == 2 && map.getNumSymbols() == 0 &&
+         map.getNumResults() == 1 &&
+         map.getResult(0) == getAffineDimExpr(1, map.getContext());
+}
+
+// Returns true if the op only has buffer operands of rank 1 or 2 and parallel
+// iterators with identity indexing maps on outputs and identity or row
+// broadcast indexing maps on inputs.
+static bool isElementwise2D(linalg::LinalgOp op) {
+  if (!op.hasBufferSemantics() || op.getNumLoops() < 1 ||
+      op.getNumLoops() > 2 || op.getNumParallelLoops() != op.getNumLoops()) {
+    return false;
+  }
+  return llvm::all_of(op.getInputOperands(),
+                      [&](OpOperand *operand) {
+                        AffineMap map = op.getTiedIndexingMap(operand);
+                        return map.isIdentity() || isRowBroadcastMap(map);
+                      }) &&
+         llvm::all_of(op.getOutputOperands(), [&](OpOperand *operand) {
+           return op.getTiedIndexingMap(operand).isIdentity();
+         });
+}
+
+// Returns the operand of |op| whose payload block argument is |value| or
+// nullptr if |value| is not a payload block argument.
+static OpOperand *getPayloadOperand(linalg::LinalgOp op, Value value) {
+  auto blockArg = value.dyn_cast<BlockArgument>();
+  if (!blockArg || blockArg.getOwner() != op.getBlock()) return nullptr;
+  return op.getInputAndOutputOperands()[blockArg.getArgNumber()];
+}
+
+// Returns |operand| of an elementwise |op| as a 2D view. Row broadcast
+// operands are read with a row stride of 0.
+static Buffer2D getOperandBuffer2D(linalg::LinalgOp op, OpOperand *operand,
+                                   OpBuilder &builder) {
+  Buffer2D buffer = getBuffer2D(operand->get(), builder);
+  if (isRowBroadcastMap(op.getTiedIndexingMap(operand))) {
+    buffer.stride =
+        builder.create<arith::ConstantIndexOp>(operand->get().getLoc(), 0);
+  }
+  return buffer;
+}
+
+// Rewrites linalg.fill of 32-bit elements to vmvx.fill.
+struct LinalgFillToVMVX : public OpRewritePattern<linalg::FillOp> {
+  using OpRewritePattern::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(linalg::FillOp op,
+                                PatternRewriter &rewriter) const override {
+    if (!op.hasBufferSemantics() ||
+        !isSupportedElementType(op.value().getType()) ||
+        !isSupportedBuffer(op.output())) {
+      return failure();
+    }
+    Buffer2D target = getBuffer2D(op.output(), rewriter);
+    Value pattern = op.value();
+    if (!pattern.getType().isInteger(32)) {
+      pattern = rewriter.create<arith::BitcastOp>(
+          op.getLoc(), rewriter.getI32Type(), pattern);
+    }
+    rewriter.replaceOpWithNewOp<IREE::VMVX::FillOp>(
+        op, pattern, target.buffer, target.offset, target.stride,
+        target.size0, target.size1);
+    return success();
+  }
+};
+
+static bool isSupportedCopy(Value source, Value target) {
+  auto elementType = source.getType().cast<MemRefType>().getElementType();
+  return isSupportedElementType(elementType) && isSupportedBuffer(source) &&
+         isSupportedBuffer(target);
+}
+
+static void replaceWithCopy(Operation *op, const Buffer2D &sourceBuffer,
+                            const Buffer2D &targetBuffer,
+                            PatternRewriter &rewriter) {
+  rewriter.replaceOpWithNewOp<IREE::VMVX::CopyOp>(
+      op, sourceBuffer.buffer, sourceBuffer.offset, sourceBuffer.stride,
+      targetBuffer.buffer, targetBuffer.offset, targetBuffer.stride,
+      targetBuffer.size0, targetBuffer.size1);
+}
+
+// Rewrites memref.copy of 32-bit elements to vmvx.copy.
+struct MemRefCopyToVMVX : public OpRewritePattern<memref::CopyOp> {
+  using OpRewritePattern::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(memref::CopyOp op,
+                                PatternRewriter &rewriter) const override {
+    auto sourceType = op.source().getType().dyn_cast<MemRefType>();
+    auto targetType = op.target().getType().dyn_cast<MemRefType>();
+    if (!sourceType || !targetType ||
+        sourceType.getShape() != targetType.getShape()) {
+      return failure();
+    }
+    if (!isSupportedCopy(op.source(), op.target())) return failure();
+    replaceWithCopy(op, getBuffer2D(op.source(), rewriter),
+                    getBuffer2D(op.target(), rewriter), rewriter);
+    return success();
+  }
+};
+
+// Rewrites elementwise linalg.generic ops that are copies (as produced by
+// bufferization), a single f32 add/mul/sub, or an f32 multiply followed by an
+// add to the corresponding VMVX op. Payload operands may be any of the inputs
+// or the output itself (such as when accumulating into the output).
+struct LinalgGenericToVMVX : public OpRewritePattern<linalg::GenericOp> {
+  using OpRewritePattern::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(linalg::GenericOp op,
+                                PatternRewriter &rewriter) const override {
+    if (op.getNumOutputs() != 1 || !isElementwise2D(op)) return failure();
+    Block *body = op.getBody();
+    auto yieldOp = cast<linalg::YieldOp>(body->getTerminator());
+    Value yieldedValue = yieldOp.getOperand(0);
+    OpOperand *out = op.getOutputOperand(0);
+
+    // out = in
+    if (op.getNumInputs() == 1 && yieldedValue == body->getArgument(0)) {
+      OpOperand *in = op.getInputOperand(0);
+      if (!isSupportedCopy(in->get(), out->get())) return failure();
+      replaceWithCopy(op, getOperandBuffer2D(op, in, rewriter),
+                      getOperandBuffer2D(op, out, rewriter), rewriter);
+      return success();
+    }
+
+    Operation *computeOp = yieldedValue.getDefiningOp();
+    if (!computeOp || computeOp->getNumOperands() != 2 ||
+        !computeOp->getResult(0).getType().isF32()) {
+      return failure();
+    }
+
+    // out = a * b + c
+    if (body->getOperations().size() == 3 && isa<arith::AddFOp>(computeOp)) {
+      Value addend = computeOp->getOperand(1);
+      auto mulOp = computeOp->getOperand(0).getDefiningOp<arith::MulFOp>();
+      if (!mulOp) {
+        addend = computeOp->getOperand(0);
+        mulOp = computeOp->getOperand(1).getDefiningOp<arith::MulFOp>();
+      }
+      if (!mulOp) return failure();
+      return rewriteFma(op, getPayloadOperand(op, mulOp.getLhs()),
+                        getPayloadOperand(op, mulOp.getRhs()),
+                        getPayloadOperand(op, addend), rewriter);
+    }
+
+    // out = lhs <op> rhs
+    if (body->getOperations().size() != 2) return failure();
+    OpOperand *lhs = getPayloadOperand(op, computeOp->getOperand(0));
+    OpOperand *rhs = getPayloadOperand(op, computeOp->getOperand(1));
+    if (isa<arith::AddFOp>(computeOp)) {
+      return rewriteBinary<IREE::VMVX::AddOp>(op, lhs, rhs, rewriter);
+    } else if (isa<arith::MulFOp>(computeOp)) {
+      return rewriteBinary<IREE::VMVX::MulOp>(op, lhs, rhs, rewriter);
+    } else if (isa<arith::SubFOp>(computeOp)) {
+      return rewriteBinary<IREE::VMVX::SubOp>(op, lhs, rhs, rewriter);
+    }
+    return failure();
+  }
+
+ private:
+  static bool areSupportedOperands(ArrayRef<OpOperand *> operands) {
+    return llvm::all_of(operands, [](OpOperand *operand) {
+      return operand && isSupportedBuffer(operand->get());
+    });
+  }
+
+  template <typename OpTy>
+  LogicalResult rewriteBinary(linalg::GenericOp op, OpOperand *lhs,
+                              OpOperand *rhs, PatternRewriter &rewriter) const {
+    OpOperand *out = op.getOutputOperand(0);
+    if (!areSupportedOperands({lhs, rhs, out})) return failure();
+    Buffer2D lhsBuffer = getOperandBuffer2D(op, lhs, rewriter);
+    Buffer2D rhsBuffer = getOperandBuffer2D(op, rhs, rewriter);
+    Buffer2D outBuffer = getOperandBuffer2D(op, out, rewriter);
+    rewriter.replaceOpWithNewOp<OpTy>(
+        op, lhsBuffer.buffer, lhsBuffer.offset, lhsBuffer.stride,
+        rhsBuffer.buffer, rhsBuffer.offset, rhsBuffer.stride, outBuffer.buffer,
+        outBuffer.offset, outBuffer.stride, outBuffer.size0, outBuffer.size1);
+    return success();
+  }
+
+  LogicalResult rewriteFma(linalg::GenericOp op, OpOperand *a, OpOperand *b,
+                           OpOperand *c, PatternRewriter &rewriter) const {
+    OpOperand *out = op.getOutputOperand(0);
+    if (!areSupportedOperands({a, b, c, out})) return failure();
+    Buffer2D aBuffer = getOperandBuffer2D(op, a, rewriter);
+    Buffer2D bBuffer = getOperandBuffer2D(op, b, rewriter);
+    Buffer2D cBuffer = getOperandBuffer2D(op, c, rewriter);
+    Buffer2D outBuffer = getOperandBuffer2D(op, out, rewriter);
+    rewriter.replaceOpWithNewOp<IREE::VMVX::FmaOp>(
+        op, aBuffer.buffer, aBuffer.offset, aBuffer.stride, bBuffer.buffer,
+        bBuffer.offset, bBuffer.stride, cBuffer.buffer, cBuffer.offset,
+        cBuffer.stride, outBuffer.buffer, outBuffer.offset, outBuffer.stride,
+        outBuffer.size0, outBuffer.size1);
+    return success();
+  }
+};
+
+// Rewrites f32 linalg.matmul to vmvx.matmul.
+struct LinalgMatmulToVMVX : public OpRewritePattern<linalg::MatmulOp> {
+  using OpRewritePattern::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(linalg::MatmulOp op,
+                                PatternRewriter &rewriter) const override {
+    if (!op.hasBufferSemantics()) return failure();
+    Value lhs = op.getInputOperand(0)->get();
+    Value rhs = op.getInputOperand(1)->get();
+    Value out = op.getOutputOperand(0)->get();
+    if (!llvm::all_of(ValueRange{lhs, rhs, out}, [](Value value) {
+          auto memrefType = value.getType().cast<MemRefType>();
+          return memrefType.getRank() == 2 &&
+                 memrefType.getElementType().isF32() &&
+                 isSupportedBuffer(value);
+        })) {
+      return failure();
+    }
+    Buffer2D lhsBuffer = getBuffer2D(lhs, rewriter);
+    Buffer2D rhsBuffer = getBuffer2D(rhs, rewriter);
+    Buffer2D outBuffer = getBuffer2D(out, rewriter);
+    rewriter.replaceOpWithNewOp<IREE::VMVX::MatmulOp>(
+        op, lhsBuffer.buffer, lhsBuffer.offset, lhsBuffer.stride,
+        rhsBuffer.buffer, rhsBuffer.offset, rhsBuffer.stride, outBuffer.buffer,
+        outBuffer.offset, outBuffer.stride,
+        /*m=*/outBuffer.size0, /*n=*/outBuffer.size1, /*k=*/lhsBuffer.size1);
+    return success();
+  }
+};
+
+}  // namespace
+
+void populateLinalgToVMVXPatterns(MLIRContext *context,
+                                  RewritePatternSet &patterns) {
+  patterns.insert<LinalgFillToVMVX, LinalgGenericToVMVX, LinalgMatmulToVMVX,
+                  MemRefCopyToVMVX>(context);
+}
+
+}  // namespace iree_compiler
+}  // namespace mlir
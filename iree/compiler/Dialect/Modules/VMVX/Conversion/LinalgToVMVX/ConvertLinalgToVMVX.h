@@ -0,0 +1,26 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_COMPILER_DIALECT_VMVX_CONVERSION_LINALGTOVMVX_CONVERTLINALGTOVMVX_H_
+#define IREE_COMPILER_DIALECT_VMVX_CONVERSION_LINALGTOVMVX_CONVERTLINALGTOVMVX_H_
+
+#include "mlir/IR/PatternMatch.h"
+
+namespace mlir {
+namespace iree_compiler {
+
+// Populates patterns rewriting linalg ops on buffers to VMVX microkernel ops.
+// Only ops with rank 1 or 2 operands formed from unit-stride subviews of
+// identity layout buffers are matched; all others are left for the loop
+// lowering.
+void populateLinalgToVMVXPatterns(MLIRContext *context,
+                                  RewritePatternSet &patterns);
+
+}  // namespace iree_compiler
+}  // namespace mlir
+
+#endif  // IREE_COMPILER_DIALECT_VMVX_CONVERSION_LINALGTOVMVX_CONVERTLINALGTOVMVX_H_
+        // // NOLINT
@@ -20,6 +20,7 @@
 #include "mlir/IR/BuiltinTypes.h"
 #include "mlir/IR/Matchers.h"
 #include "mlir/IR/SymbolTable.h"
+#include "mlir/IR/TypeUtilities.h"
 #include "mlir/Transforms/DialectConversion.h"
 
 namespace mlir {
@@ -115,12 +116,69 @@ class VMVXImportOpConversion : public OpConversionPattern<T> {
   patterns.insert<VMVXImportOpConversion<op_type>>( \
       context, importSymbols, typeConverter, op_mnemonic);
 
+// Suffixes the import name with the bit width of the target buffer elements
+// for ops that only move bits around (`vmvx.copy.2d` -> `vmvx.copy.2d.x32`).
+template <typename T>
+class VMVXSizedImportOpConversion : public VMVXImportOpConversion<T> {
+ public:
+  using VMVXImportOpConversion<T>::VMVXImportOpConversion;
+
+ protected:
+  std::string getImportSuffix(T op) const override {
+    return "." + this->getSizedTypeStr(
+                     getElementTypeOrSelf(op.target_buffer().getType()));
+  }
+};
+
+// Suffixes the import name with the element type of the output buffer
+// (`vmvx.add.2d` -> `vmvx.add.2d.f32`).
+template <typename T>
+class VMVXTypedImportOpConversion : public VMVXImportOpConversion<T> {
+ public:
+  using VMVXImportOpConversion<T>::VMVXImportOpConversion;
+
+ protected:
+  std::string getImportSuffix(T op) const override {
+    return "." + this->getTypedTypeStr(op.out_buffer().getType());
+  }
+};
+
+// Suffixes the import name with the lhs, rhs, and output element types
+// (`vmvx.matmul` -> `vmvx.matmul.f32f32f32`).
+class VMVXMatmulImportOpConversion
+    : public VMVXImportOpConversion<IREE::VMVX::MatmulOp> {
+ public:
+  using VMVXImportOpConversion::VMVXImportOpConversion;
+
+ protected:
+  std::string getImportSuffix(IREE::VMVX::MatmulOp op) const override {
+    return "." + getTypedTypeStr(op.lhs_buffer().getType()) +
+           getTypedTypeStr(op.rhs_buffer().getType()) +
+           getTypedTypeStr(op.out_buffer().getType());
+  }
+};
+
 }  // namespace
 
 void populateVMVXToVMPatterns(MLIRContext *context,
                               TypeConverter &typeConverter,
                               SymbolTable &importSymbols,
-                              RewritePatternSet &patterns) {}
+                              RewritePatternSet &patterns) {
+  patterns.insert<VMVXSizedImportOpConversion<IREE::VMVX::CopyOp>>(
+      context, importSymbols, typeConverter, "vmvx.copy.2d");
+  patterns.insert<VMVXSizedImportOpConversion<IREE::VMVX::FillOp>>(
+      context, importSymbols, typeConverter, "vmvx.fill.2d");
+  patterns.insert<VMVXTypedImportOpConversion<IREE::VMVX::AddOp>>(
+      context, importSymbols, typeConverter, "vmvx.add.2d");
+  patterns.insert<VMVXTypedImportOpConversion<IREE::VMVX::MulOp>>(
+      context, importSymbols, typeConverter, "vmvx.mul.2d");
+  patterns.insert<VMVXTypedImportOpConversion<IREE::VMVX::SubOp>>(
+      context, importSymbols, typeConverter, "vmvx.sub.2d");
+  patterns.insert<VMVXTypedImportOpConversion<IREE::VMVX::FmaOp>>(
+      context, importSymbols, typeConverter, "vmvx.fma.2d");
+  patterns.insert<VMVXMatmulImportOpConversion>(context, importSymbols,
+                                                typeConverter, "vmvx.matmul");
+}
 
 }  // namespace iree_compiler
 }  // namespace mlir
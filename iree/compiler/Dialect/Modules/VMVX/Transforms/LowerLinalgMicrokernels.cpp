@@ -0,0 +1,60 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Dialect/HAL/IR/HALDialect.h"
+#include "iree/compiler/Dialect/Modules/VMVX/Conversion/LinalgToVMVX/ConvertLinalgToVMVX.h"
+#include "iree/compiler/Dialect/Modules/VMVX/IR/VMVXDialect.h"
+#include "iree/compiler/Dialect/Modules/VMVX/Transforms/Passes.h"
+#include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/IR/PatternMatch.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Pass/PassRegistry.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace VMVX {
+
+// Rewrites linalg ops with VMVX microkernels to the VMVX ops calling them.
+// Any op not matched is left for the linalg-to-loops lowering.
+class LowerLinalgMicrokernelsPass
+    : public PassWrapper<LowerLinalgMicrokernelsPass, OperationPass<FuncOp>> {
+ public:
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<IREE::HAL::HALDialect, IREE::VMVX::VMVXDialect,
+                    arith::ArithmeticDialect, memref::MemRefDialect>();
+  }
+
+  StringRef getArgument() const override {
+    return "iree-vmvx-lower-linalg-microkernels";
+  }
+
+  StringRef getDescription() const override {
+    return "Lowers linalg ops to VMVX microkernel ops where possible";
+  }
+
+  void runOnOperation() override {
+    RewritePatternSet patterns(&getContext());
+    populateLinalgToVMVXPatterns(&getContext(), patterns);
+    if (failed(applyPatternsAndFoldGreedily(getOperation(),
+                                            std::move(patterns)))) {
+      return signalPassFailure();
+    }
+  }
+};
+
+std::unique_ptr<OperationPass<FuncOp>> createLowerLinalgMicrokernelsPass() {
+  return std::make_unique<LowerLinalgMicrokernelsPass>();
+}
+
+static PassRegistration<LowerLinalgMicrokernelsPass> pass;
+
+}  // namespace VMVX
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
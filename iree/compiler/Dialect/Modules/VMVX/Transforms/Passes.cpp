@@ -45,6 +45,10 @@ static void buildVectorVMVXTransformPassPipeline(OpPassManager &passManager) {
   // nestedModulePM.addNestedPass<FuncOp>(
   //     createLinalgTileAndVectorizeWorkgroupsPass());
 
+  // Linalg -> VMVX microkernels; anything not matched is lowered to loops.
+  nestedModulePM.addNestedPass<FuncOp>(createLowerLinalgMicrokernelsPass());
+  nestedModulePM.addNestedPass<FuncOp>(createCanonicalizerPass());
+
   // Linalg -> SCF.
   nestedModulePM.addNestedPass<FuncOp>(
       IREE::LinalgExt::createLinalgExtToLoopsPass());
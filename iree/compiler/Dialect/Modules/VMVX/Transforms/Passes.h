@@ -44,6 +44,9 @@ void createVMVXTransformPassPipeline();
 // Converts from various dialects (HAL, standard, etc) to the VMVX dialect.
 std::unique_ptr<OperationPass<mlir::ModuleOp>> createConversionPass();
 
+// Lowers linalg ops on buffers to VMVX microkernel ops where supported.
+std::unique_ptr<OperationPass<FuncOp>> createLowerLinalgMicrokernelsPass();
+
 //===----------------------------------------------------------------------===//
 // Register all Passes
 //===----------------------------------------------------------------------===//
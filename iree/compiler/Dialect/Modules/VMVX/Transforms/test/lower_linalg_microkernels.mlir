@@ -0,0 +1,152 @@
+// RUN: iree-opt -split-input-file -iree-vmvx-lower-linalg-microkernels -canonicalize %s | FileCheck %s
+
+#map_lhs = affine_map<(d0, d1)[s0] -> (d0 * 32 + s0 + d1)>
+#map_out = affine_map<(d0, d1)[s0] -> (d0 * 16 + s0 + d1)>
+
+// CHECK-LABEL: func @matmul
+//  CHECK-SAME: (%[[I:.+]]: index, %[[J:.+]]: index)
+func @matmul(%i: index, %j: index) {
+  //  CHECK-DAG: %[[C4:.+]] = arith.constant 4 : index
+  //  CHECK-DAG: %[[C8:.+]] = arith.constant 8 : index
+  //  CHECK-DAG: %[[C16:.+]] = arith.constant 16 : index
+  //  CHECK-DAG: %[[C32:.+]] = arith.constant 32 : index
+  %c0 = arith.constant 0 : index
+  %lhs = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) offset(%c0) : memref<64x32xf32>
+  %rhs = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) offset(%c0) : memref<32x16xf32>
+  %out = hal.interface.binding.subspan set(0) binding(2) type(storage_buffer) offset(%c0) : memref<64x16xf32>
+  %lhs_tile = memref.subview %lhs[%i, 0] [8, 32] [1, 1] : memref<64x32xf32> to memref<8x32xf32, #map_lhs>
+  %rhs_tile = memref.subview %rhs[0, %j] [32, 4] [1, 1] : memref<32x16xf32> to memref<32x4xf32, #map_out>
+  %out_tile = memref.subview %out[%i, %j] [8, 4] [1, 1] : memref<64x16xf32> to memref<8x4xf32, #map_out>
+  //  CHECK-DAG: %[[LHS_OFFSET:.+]] = arith.muli %[[I]], %[[C32]]
+  //  CHECK-DAG: %[[LHS:.+]] = builtin.unrealized_conversion_cast %{{.+}} : memref<64x32xf32> to memref<?xf32>
+  //  CHECK-DAG: %[[RHS:.+]] = builtin.unrealized_conversion_cast %{{.+}} : memref<32x16xf32> to memref<?xf32>
+  //  CHECK-DAG: %[[OUT_ROW:.+]] = arith.muli %[[I]], %[[C16]]
+  //  CHECK-DAG: %[[OUT_OFFSET:.+]] = arith.addi %[[OUT_ROW]], %[[J]]
+  //  CHECK-DAG: %[[OUT:.+]] = builtin.unrealized_conversion_cast %{{.+}} : memref<64x16xf32> to memref<?xf32>
+  //      CHECK: vmvx.matmul
+  // CHECK-SAME:   lhs(%[[LHS]] : memref<?xf32>)[%[[LHS_OFFSET]], %[[C32]]]
+  // CHECK-SAME:   rhs(%[[RHS]] : memref<?xf32>)[%[[J]], %[[C16]]]
+  // CHECK-SAME:   out(%[[OUT]] : memref<?xf32>)[%[[OUT_OFFSET]], %[[C16]]]
+  // CHECK-SAME:   mnk(%[[C8]], %[[C4]], %[[C32]])
+  linalg.matmul ins(%lhs_tile, %rhs_tile : memref<8x32xf32, #map_lhs>, memref<32x4xf32, #map_out>)
+                outs(%out_tile : memref<8x4xf32, #map_out>)
+  return
+}
+
+// -----
+
+// CHECK-LABEL: func @fill_f32
+func @fill_f32(%value: f32) {
+  //  CHECK-DAG: %[[C0:.+]] = arith.constant 0 : index
+  //  CHECK-DAG: %[[C1:.+]] = arith.constant 1 : index
+  //  CHECK-DAG: %[[C128:.+]] = arith.constant 128 : index
+  %c0 = arith.constant 0 : index
+  %c512 = arith.constant 512 : index
+  // CHECK: %[[SUBSPAN:.+]] = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) offset(%[[C0]]) : memref<128xf32>
+  %out = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) offset(%c512) : memref<128xf32>
+  //      CHECK: %[[PATTERN:.+]] = arith.bitcast %{{.+}} : f32 to i32
+  //      CHECK: %[[BUFFER:.+]] = builtin.unrealized_conversion_cast %[[SUBSPAN]] : memref<128xf32> to memref<?xf32>
+  //      CHECK: vmvx.fill pattern(%[[PATTERN]] : i32)
+  // CHECK-SAME:   target(%[[BUFFER]] : memref<?xf32>)[%[[C128]], %[[C128]]]
+  // CHECK-SAME:   sizes(%[[C1]], %[[C128]])
+  linalg.fill(%value, %out) : f32, memref<128xf32>
+  return
+}
+
+// -----
+
+#map = affine_map<(d0, d1) -> (d0, d1)>
+
+// The generic computes `in1 - in0` and the operands are swapped to match.
+
+// CHECK-LABEL: func @sub_swapped
+//  CHECK-SAME: (%[[IN0:.+]]: memref<4x8xf32>, %[[IN1:.+]]: memref<4x8xf32>, %[[OUT:.+]]: memref<4x8xf32>)
+func @sub_swapped(%in0: memref<4x8xf32>, %in1: memref<4x8xf32>, %out: memref<4x8xf32>) {
+  //  CHECK-DAG: %[[IN0_BUFFER:.+]] = builtin.unrealized_conversion_cast %[[IN0]] : memref<4x8xf32> to memref<?xf32>
+  //  CHECK-DAG: %[[IN1_BUFFER:.+]] = builtin.unrealized_conversion_cast %[[IN1]] : memref<4x8xf32> to memref<?xf32>
+  //  CHECK-DAG: %[[OUT_BUFFER:.+]] = builtin.unrealized_conversion_cast %[[OUT]] : memref<4x8xf32> to memref<?xf32>
+  //      CHECK: vmvx.sub
+  // CHECK-SAME:   lhs(%[[IN1_BUFFER]] : memref<?xf32>)
+  // CHECK-SAME:   rhs(%[[IN0_BUFFER]] : memref<?xf32>)
+  // CHECK-SAME:   out(%[[OUT_BUFFER]] : memref<?xf32>)
+  linalg.generic {indexing_maps = [#map, #map, #map], iterator_types = ["parallel", "parallel"]}
+      ins(%in0, %in1 : memref<4x8xf32>, memref<4x8xf32>) outs(%out : memref<4x8xf32>) {
+  ^bb0(%a: f32, %b: f32, %c: f32):
+    %0 = arith.subf %b, %a : f32
+    linalg.yield %0 : f32
+  }
+  return
+}
+
+// -----
+
+#map = affine_map<(d0, d1) -> (d0, d1)>
+#map_row = affine_map<(d0, d1) -> (d1)>
+
+// The rank-1 bias is read for every row with a row stride of 0.
+
+// CHECK-LABEL: func @add_row_broadcast
+//  CHECK-SAME: (%[[IN:.+]]: memref<4x8xf32>, %[[BIAS:.+]]: memref<8xf32>, %[[OUT:.+]]: memref<4x8xf32>)
+func @add_row_broadcast(%in: memref<4x8xf32>, %bias: memref<8xf32>, %out: memref<4x8xf32>) {
+  //  CHECK-DAG: %[[C0:.+]] = arith.constant 0 : index
+  //  CHECK-DAG: %[[C4:.+]] = arith.constant 4 : index
+  //  CHECK-DAG: %[[C8:.+]] = arith.constant 8 : index
+  //  CHECK-DAG: %[[BIAS_BUFFER:.+]] = builtin.unrealized_conversion_cast %[[BIAS]] : memref<8xf32> to memref<?xf32>
+  //      CHECK: vmvx.add
+  // CHECK-SAME:   lhs(%{{.+}} : memref<?xf32>)[%[[C0]], %[[C8]]]
+  // CHECK-SAME:   rhs(%[[BIAS_BUFFER]] : memref<?xf32>)[%[[C0]], %[[C0]]]
+  // CHECK-SAME:   out(%{{.+}} : memref<?xf32>)[%[[C0]], %[[C8]]]
+  // CHECK-SAME:   sizes(%[[C4]], %[[C8]])
+  linalg.generic {indexing_maps = [#map, #map_row, #map], iterator_types = ["parallel", "parallel"]}
+      ins(%in, %bias : memref<4x8xf32>, memref<8xf32>) outs(%out : memref<4x8xf32>) {
+  ^bb0(%a: f32, %b: f32, %c: f32):
+    %0 = arith.addf %a, %b : f32
+    linalg.yield %0 : f32
+  }
+  return
+}
+
+// -----
+
+#map = affine_map<(d0, d1) -> (d0, d1)>
+
+// Multiply-accumulate into the output reads the output as the addend.
+
+// CHECK-LABEL: func @fma_accumulate
+//  CHECK-SAME: (%[[A:.+]]: memref<4x8xf32>, %[[B:.+]]: memref<4x8xf32>, %[[OUT:.+]]: memref<4x8xf32>)
+func @fma_accumulate(%a: memref<4x8xf32>, %b: memref<4x8xf32>, %out: memref<4x8xf32>) {
+  //  CHECK-DAG: %[[A_BUFFER:.+]] = builtin.unrealized_conversion_cast %[[A]] : memref<4x8xf32> to memref<?xf32>
+  //  CHECK-DAG: %[[B_BUFFER:.+]] = builtin.unrealized_conversion_cast %[[B]] : memref<4x8xf32> to memref<?xf32>
+  //  CHECK-DAG: %[[OUT_BUFFER:.+]] = builtin.unrealized_conversion_cast %[[OUT]] : memref<4x8xf32> to memref<?xf32>
+  //      CHECK: vmvx.fma
+  // CHECK-SAME:   a(%[[A_BUFFER]] : memref<?xf32>)
+  // CHECK-SAME:   b(%[[B_BUFFER]] : memref<?xf32>)
+  // CHECK-SAME:   c(%[[OUT_BUFFER]] : memref<?xf32>)
+  // CHECK-SAME:   out(%[[OUT_BUFFER]] : memref<?xf32>)
+  linalg.generic {indexing_maps = [#map, #map, #map], iterator_types = ["parallel", "parallel"]}
+      ins(%a, %b : memref<4x8xf32>, memref<4x8xf32>) outs(%out : memref<4x8xf32>) {
+  ^bb0(%x: f32, %y: f32, %acc: f32):
+    %0 = arith.mulf %x, %y : f32
+    %1 = arith.addf %acc, %0 : f32
+    linalg.yield %1 : f32
+  }
+  return
+}
+
+// -----
+
+#map_strided = affine_map<(d0, d1)[s0] -> (d0 * 64 + s0 + d1 * 2)>
+
+// Non-unit inner strides are left for the loop lowering.
+
+// CHECK-LABEL: func @copy_strided
+func @copy_strided(%i: index) {
+  %c0 = arith.constant 0 : index
+  %in = hal.interface.binding.subspan set(0) binding(0) type(storage_buffer) offset(%c0) : memref<32x32xf32>
+  %out = hal.interface.binding.subspan set(0) binding(1) type(storage_buffer) offset(%c0) : memref<8x8xf32>
+  %tile = memref.subview %in[%i, 0] [8, 8] [1, 2] : memref<32x32xf32> to memref<8x8xf32, #map_strided>
+  // CHECK-NOT: vmvx.copy
+  // CHECK: memref.copy
+  memref.copy %tile, %out : memref<8x8xf32, #map_strided> to memref<8x8xf32>
+  return
+}
@@ -25,8 +25,116 @@
 // module must be prefixed with `ex.` like `vmvx.ex.my_test_op`.
 vm.module @vmvx {
 
+// NOTE: all buffer offsets, strides, and sizes are in elements and all 2D
+// operands are row-major with contiguous rows. Input strides may be 0 to read
+// the same row for every row of the output.
+
+//===----------------------------------------------------------------------===//
+// VMVX Ops: data movement
+//===----------------------------------------------------------------------===//
+
+vm.import @copy.2d.x32(
+  %source_buffer : !vm.buffer,
+  %source_offset : i32,
+  %source_stride : i32,
+  %target_buffer : !vm.buffer,
+  %target_offset : i32,
+  %target_stride : i32,
+  %size0 : i32,
+  %size1 : i32
+)
+
+vm.import @fill.2d.x32(
+  %pattern : i32,
+  %target_buffer : !vm.buffer,
+  %target_offset : i32,
+  %target_stride : i32,
+  %size0 : i32,
+  %size1 : i32
+)
+
+//===----------------------------------------------------------------------===//
+// VMVX Ops: elementwise arithmetic
 //===----------------------------------------------------------------------===//
-// VMVX Ops: TODO
+
+vm.import @add.2d.f32(
+  %lhs_buffer : !vm.buffer,
+  %lhs_offset : i32,
+  %lhs_stride : i32,
+  %rhs_buffer : !vm.buffer,
+  %rhs_offset : i32,
+  %rhs_stride : i32,
+  %out_buffer : !vm.buffer,
+  %out_offset : i32,
+  %out_stride : i32,
+  %size0 : i32,
+  %size1 : i32
+)
+
+vm.import @mul.2d.f32(
+  %lhs_buffer : !vm.buffer,
+  %lhs_offset : i32,
+  %lhs_stride : i32,
+  %rhs_buffer : !vm.buffer,
+  %rhs_offset : i32,
+  %rhs_stride : i32,
+  %out_buffer : !vm.buffer,
+  %out_offset : i32,
+  %out_stride : i32,
+  %size0 : i32,
+  %size1 : i32
+)
+
+vm.import @sub.2d.f32(
+  %lhs_buffer : !vm.buffer,
+  %lhs_offset : i32,
+  %lhs_stride : i32,
+  %rhs_buffer : !vm.buffer,
+  %rhs_offset : i32,
+  %rhs_stride : i32,
+  %out_buffer : !vm.buffer,
+  %out_offset : i32,
+  %out_stride : i32,
+  %size0 : i32,
+  %size1 : i32
+)
+
+// Computes `out = a * b + c`.
+vm.import @fma.2d.f32(
+  %a_buffer : !vm.buffer,
+  %a_offset : i32,
+  %a_stride : i32,
+  %b_buffer : !vm.buffer,
+  %b_offset : i32,
+  %b_stride : i32,
+  %c_buffer : !vm.buffer,
+  %c_offset : i32,
+  %c_stride : i32,
+  %out_buffer : !vm.buffer,
+  %out_offset : i32,
+  %out_stride : i32,
+  %size0 : i32,
+  %size1 : i32
+)
+
+//===----------------------------------------------------------------------===//
+// VMVX Ops: linear algebra
 //===----------------------------------------------------------------------===//
 
+// Computes `out[m, n] += lhs[m, k] * rhs[k, n]`.
+vm.import @matmul.f32f32f32(
+  %lhs_buffer : !vm.buffer,
+  %lhs_offset : i32,
+  %lhs_stride : i32,
+  %rhs_buffer : !vm.buffer,
+  %rhs_offset : i32,
+  %rhs_stride : i32,
+  %out_buffer : !vm.buffer,
+  %out_offset : i32,
+  %out_stride : i32,
+  %m : i32,
+  %n : i32,
+  %k : i32
+)
+
 }  // module
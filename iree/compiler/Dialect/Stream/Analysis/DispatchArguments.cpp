@@ -0,0 +1,558 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Dialect/Stream/Analysis/DispatchArguments.h"
+
+#include <utility>
+
+#include "iree/compiler/Dialect/Stream/IR/StreamDialect.h"
+#include "iree/compiler/Dialect/Stream/IR/StreamOps.h"
+#include "iree/compiler/Dialect/Util/Analysis/DFX/Element.h"
+#include "iree/compiler/Dialect/Util/IR/UtilOps.h"
+#include "llvm/Support/Debug.h"
+#include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
+#include "mlir/Dialect/StandardOps/IR/Ops.h"
+#include "mlir/IR/BuiltinTypes.h"
+#include "mlir/IR/Matchers.h"
+
+#define DEBUG_TYPE "iree-util-dfx"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace Stream {
+
+//===----------------------------------------------------------------------===//
+// Analysis state
+//===----------------------------------------------------------------------===//
+
+// TODO(benvanik): move to Util/Analysis/ as this would be useful in other
+// passes as well and only depends on util.align and upstream ops.
+
+static std::string getPVSAsStr(
+    const DFX::PotentialConstantIntValuesState &pvs) {
+  std::string str;
+  llvm::raw_string_ostream sstream(str);
+  sstream << "pvs: ";
+  if (pvs.isValidState()) {
+    sstream << "[";
+    if (pvs.isUndefContained()) {
+      sstream << "undef, ";
+    }
+    llvm::interleaveComma(pvs.getAssumedSet(), sstream,
+                          [&](APInt value) { value.print(sstream, false); });
+    sstream << "]";
+  } else {
+    sstream << "(invalid)";
+  }
+  sstream.flush();
+  return str;
+}
+
+// Returns the bit width used to store constant values of |type|.
+static unsigned getStorageBitWidth(Type type) {
+  if (type.isIndex()) return IndexType::kInternalStorageBitWidth;
+  return type.getIntOrFloatBitWidth();
+}
+
+// Unions the results of applying |fn| to every pair of values in |lhs| and
+// |rhs| into |newState|. If either side is not fully known then |newState| is
+// made pessimistic. The set size limit of the state bounds the fan-out.
+template <typename FnT>
+static void unionBinaryOp(const DFX::PotentialConstantIntValuesState &lhs,
+                          const DFX::PotentialConstantIntValuesState &rhs,
+                          DFX::PotentialConstantIntValuesState &newState,
+                          FnT fn) {
+  if (!lhs.isValidState() || !rhs.isValidState() || lhs.isUndefContained() ||
+      rhs.isUndefContained()) {
+    newState.unionAssumedWithUndef();
+    newState.indicatePessimisticFixpoint();
+    return;
+  }
+  for (auto &lhsValue : lhs.getAssumedSet()) {
+    for (auto &rhsValue : rhs.getAssumedSet()) {
+      newState.unionAssumed(fn(lhsValue, rhsValue));
+    }
+  }
+}
+
+class GlobalPVS : public DFX::StateWrapper<
+                      DFX::PotentialConstantIntValuesState,
+                      DFX::TypedOperationElement<IREE::Util::GlobalOp>> {
+ public:
+  using BaseType =
+      DFX::StateWrapper<DFX::PotentialConstantIntValuesState,
+                        DFX::TypedOperationElement<IREE::Util::GlobalOp>>;
+
+  static GlobalPVS &createForPosition(const Position &pos,
+                                      DFX::Solver &solver) {
+    return *(new (solver.getAllocator()) GlobalPVS(pos));
+  }
+
+  const std::string getName() const override { return "GlobalPVS"; }
+  const void *getID() const override { return &ID; }
+  static bool classof(const DFX::AbstractElement *element) {
+    return (element->getID() == &ID);
+  }
+  static const char ID;
+
+  const std::string getAsStr() const override {
+    return getPVSAsStr(getState());
+  }
+
+ private:
+  explicit GlobalPVS(const Position &pos) : BaseType(pos) {}
+
+  void initializeOperation(IREE::Util::GlobalOp globalOp,
+                           DFX::Solver &solver) override;
+  ChangeStatus updateOperation(IREE::Util::GlobalOp globalOp,
+                               DFX::Solver &solver) override;
+
+  friend class DFX::Solver;
+};
+const char GlobalPVS::ID = 0;
+
+class ValuePVS : public DFX::StateWrapper<DFX::PotentialConstantIntValuesState,
+                                          DFX::ValueElement> {
+ public:
+  using BaseType = DFX::StateWrapper<DFX::PotentialConstantIntValuesState,
+                                     DFX::ValueElement>;
+
+  static ValuePVS &createForPosition(const Position &pos, DFX::Solver &solver) {
+    return *(new (solver.getAllocator()) ValuePVS(pos));
+  }
+
+  const std::string getName() const override { return "ValuePVS"; }
+  const void *getID() const override { return &ID; }
+  static bool classof(const DFX::AbstractElement *element) {
+    return (element->getID() == &ID);
+  }
+  static const char ID;
+
+  const std::string getAsStr() const override {
+    return getPVSAsStr(getState());
+  }
+
+ private:
+  explicit ValuePVS(const Position &pos) : BaseType(pos) {}
+
+  void initializeValue(Value value, DFX::Solver &solver) override {
+    APInt staticValue;
+    if (matchPattern(value, m_ConstantInt(&staticValue))) {
+      unionAssumed(staticValue);
+      indicateOptimisticFixpoint();
+    }
+  }
+
+  // Unions the PVS of the binary |op| applied to the PVS of its operands.
+  template <typename OpT, typename FnT>
+  void unionBinaryOpPVS(OpT op, StateType &newState, DFX::Solver &solver,
+                        FnT fn) {
+    auto lhs = solver.getElementFor<ValuePVS>(
+        *this, Position::forValue(op.getLhs()), DFX::Resolution::REQUIRED);
+    auto rhs = solver.getElementFor<ValuePVS>(
+        *this, Position::forValue(op.getRhs()), DFX::Resolution::REQUIRED);
+    unionBinaryOp(lhs.getState(), rhs.getState(), newState, fn);
+  }
+
+  ChangeStatus updateValue(Value value, DFX::Solver &solver) override {
+    StateType newState;
+    if (solver.getExplorer().walkDefiningOps(value, [&](OpResult result) {
+          APInt staticValue;
+          if (matchPattern(result, m_ConstantInt(&staticValue))) {
+            newState.unionAssumed(staticValue);
+            return WalkResult::advance();
+          }
+
+          if (auto loadOp =
+                  dyn_cast<IREE::Util::GlobalLoadOp>(result.getDefiningOp())) {
+            auto *globalInfo = solver.getExplorer().queryGlobalInfoFrom(
+                loadOp.global(), loadOp);
+            auto global = solver.getElementFor<GlobalPVS>(
+                *this, Position::forOperation(globalInfo->op),
+                DFX::Resolution::REQUIRED);
+            if (global.isValidState()) {
+              newState.unionAssumed(global);
+              return WalkResult::advance();
+            }
+          }
+
+          // Simple integer math is common when computing offsets and sizes
+          // and folding through it lets us turn strides derived from constant
+          // arguments into constants. The set size limit of the state keeps
+          // the combinations from growing unbounded.
+          if (auto addOp =
+                  dyn_cast<mlir::arith::AddIOp>(result.getDefiningOp())) {
+            unionBinaryOpPVS(addOp, newState, solver,
+                             [](const APInt &lhs, const APInt &rhs) {
+                               return lhs + rhs;
+                             });
+            return WalkResult::advance();
+          }
+          if (auto subOp =
+                  dyn_cast<mlir::arith::SubIOp>(result.getDefiningOp())) {
+            unionBinaryOpPVS(subOp, newState, solver,
+                             [](const APInt &lhs, const APInt &rhs) {
+                               return lhs - rhs;
+                             });
+            return WalkResult::advance();
+          }
+          if (auto mulOp =
+                  dyn_cast<mlir::arith::MulIOp>(result.getDefiningOp())) {
+            unionBinaryOpPVS(mulOp, newState, solver,
+                             [](const APInt &lhs, const APInt &rhs) {
+                               return lhs * rhs;
+                             });
+            return WalkResult::advance();
+          }
+          if (auto castOp =
+                  dyn_cast<mlir::arith::IndexCastOp>(result.getDefiningOp())) {
+            auto source = solver.getElementFor<ValuePVS>(
+                *this, Position::forValue(castOp.getIn()),
+                DFX::Resolution::REQUIRED);
+            if (!source.isValidState() || source.isUndefContained()) {
+              newState.unionAssumedWithUndef();
+              newState.indicatePessimisticFixpoint();
+              return WalkResult::advance();
+            }
+            unsigned bitWidth = getStorageBitWidth(castOp.getType());
+            for (auto &sourceValue : source.getAssumedSet()) {
+              newState.unionAssumed(sourceValue.sextOrTrunc(bitWidth));
+            }
+            return WalkResult::advance();
+          }
+
+          // TODO(benvanik): move select op walking to the explorer.
+          if (auto selectOp =
+                  dyn_cast<mlir::arith::SelectOp>(result.getDefiningOp())) {
+            auto lhs = solver.getElementFor<ValuePVS>(
+                *this, Position::forValue(selectOp.getTrueValue()),
+                DFX::Resolution::REQUIRED);
+            auto rhs = solver.getElementFor<ValuePVS>(
+                *this, Position::forValue(selectOp.getFalseValue()),
+                DFX::Resolution::REQUIRED);
+            if (!lhs.isValidState() || !rhs.isValidState()) {
+              newState.unionAssumedWithUndef();
+              newState.indicatePessimisticFixpoint();
+            } else {
+              newState.unionAssumed(lhs);
+              newState.unionAssumed(rhs);
+            }
+            return WalkResult::advance();
+          }
+
+          // Some other dynamic value we can't analyze (yet).
+          newState.unionAssumedWithUndef();
+          newState.indicatePessimisticFixpoint();
+          return WalkResult::advance();
+        }) == TraversalResult::INCOMPLETE) {
+      newState.unionAssumedWithUndef();
+      newState.indicatePessimisticFixpoint();
+    }
+    return DFX::clampStateAndIndicateChange(getState(), newState);
+  }
+
+  friend class DFX::Solver;
+};
+const char ValuePVS::ID = 0;
+
+void GlobalPVS::initializeOperation(IREE::Util::GlobalOp globalOp,
+                                    DFX::Solver &solver) {
+  auto *globalInfo = solver.getExplorer().getGlobalInfo(globalOp);
+  if (!globalInfo || globalInfo->isIndirect) {
+    // Cannot perform analysis.
+    indicatePessimisticFixpoint();
+  } else if (globalInfo) {
+    if (auto initialValue =
+            globalOp.initial_valueAttr().dyn_cast_or_null<IntegerAttr>()) {
+      // Initial value is available for use; stored values from the rest of the
+      // program will come during iteration.
+      unionAssumed(initialValue.getValue());
+    }
+  }
+}
+
+ChangeStatus GlobalPVS::updateOperation(IREE::Util::GlobalOp globalOp,
+                                        DFX::Solver &solver) {
+  StateType newState;
+  auto *globalInfo = solver.getExplorer().getGlobalInfo(globalOp);
+  for (auto use : globalInfo->uses) {
+    auto storeOp = dyn_cast<IREE::Util::GlobalStoreOp>(use);
+    if (!storeOp) continue;
+    auto value = solver.getElementFor<ValuePVS>(
+        *this, Position::forValue(storeOp.value()), DFX::Resolution::REQUIRED);
+    if (value.isValidState()) {
+      newState.unionAssumed(value);
+    } else {
+      newState.unionAssumedWithUndef();
+      newState.indicatePessimisticFixpoint();
+    }
+  }
+  return DFX::clampStateAndIndicateChange(getState(), newState);
+}
+
+static constexpr uint64_t kMaximumAlignment = 1ull << 32;
+
+using AlignmentStateType = DFX::IncIntegerState<uint64_t, kMaximumAlignment, 1>;
+class ValueAlignment
+    : public DFX::StateWrapper<AlignmentStateType, DFX::ValueElement> {
+ public:
+  using BaseType = DFX::StateWrapper<AlignmentStateType, DFX::ValueElement>;
+
+  static ValueAlignment &createForPosition(const Position &pos,
+                                           DFX::Solver &solver) {
+    return *(new (solver.getAllocator()) ValueAlignment(pos));
+  }
+
+  llvm::MaybeAlign getAssumedAlignment() const {
+    return llvm::MaybeAlign(getAssumed());
+  }
+
+  llvm::MaybeAlign getKnownAlignment() const {
+    return llvm::MaybeAlign(getKnown());
+  }
+
+  const std::string getName() const override { return "ValueAlignment"; }
+  const void *getID() const override { return &ID; }
+  static bool classof(const DFX::AbstractElement *element) {
+    return (element->getID() == &ID);
+  }
+  static const char ID;
+
+  const std::string getAsStr() const override {
+    return std::string("alignment: ") +
+           std::to_string(getAssumedAlignment().valueOrOne().value());
+  }
+
+ private:
+  explicit ValueAlignment(const Position &pos) : BaseType(pos) {}
+
+  void initializeValue(Value value, DFX::Solver &solver) override {
+    // Integers are tracked so that we can see through index casts.
+    if (!value.getType().isIntOrIndex()) {
+      indicatePessimisticFixpoint();
+      return;
+    }
+  }
+
+  static llvm::MaybeAlign computeAlignment(const ValuePVS::SetTy &set) {
+    if (set.empty()) return llvm::MaybeAlign();
+    llvm::MaybeAlign alignment;
+    for (auto value : set) {
+      APInt valueDivisor = (value & (~(value - 1)));
+      alignment = llvm::commonAlignment(
+          alignment, llvm::MaybeAlign(valueDivisor.getZExtValue()));
+    }
+    return alignment;
+  }
+
+  ChangeStatus updateValue(Value value, DFX::Solver &solver) override {
+    StateType newState = getState();
+
+    // If we can get a full potential value set then we can derive an alignment
+    // from that.
+    auto pvs = solver.getElementFor<ValuePVS>(*this, Position::forValue(value),
+                                              DFX::Resolution::OPTIONAL);
+    if (pvs.isValidState() && !pvs.isUndefContained()) {
+      auto alignment = computeAlignment(pvs.getAssumedSet());
+      if (alignment.hasValue()) {
+        newState.takeAssumedMinimum(alignment.valueOrOne().value());
+        newState.indicateOptimisticFixpoint();
+      }
+    }
+
+    if (!newState.isAtFixpoint()) {
+      // Scan IR to see if we can infer the alignment.
+      // TODO(benvanik): look through exts/etc and affine.apply.
+      if (solver.getExplorer().walkDefiningOps(value, [&](OpResult result) {
+            auto *definingOp = result.getDefiningOp();
+            if (auto alignOp = dyn_cast<IREE::Util::AlignOp>(definingOp)) {
+              auto alignment = solver.getElementFor<ValueAlignment>(
+                  *this, Position::forValue(alignOp.alignment()),
+                  DFX::Resolution::REQUIRED);
+              newState ^= alignment;
+            } else if (auto mulOp = dyn_cast<mlir::arith::MulIOp>(definingOp)) {
+              // The product is aligned to the product of the alignments of its
+              // factors. An unaligned factor (invalid state) still contributes
+              // so the dependence is optional.
+              auto lhs = solver.getElementFor<ValueAlignment>(
+                  *this, Position::forValue(mulOp.getLhs()),
+                  DFX::Resolution::OPTIONAL);
+              auto rhs = solver.getElementFor<ValueAlignment>(
+                  *this, Position::forValue(mulOp.getRhs()),
+                  DFX::Resolution::OPTIONAL);
+              uint64_t lhsAlignment = lhs.getAssumed();
+              uint64_t rhsAlignment = rhs.getAssumed();
+              newState.takeAssumedMinimum(
+                  lhsAlignment >= kMaximumAlignment / rhsAlignment
+                      ? kMaximumAlignment
+                      : lhsAlignment * rhsAlignment);
+            } else if (isa<mlir::arith::AddIOp, mlir::arith::SubIOp>(
+                           definingOp)) {
+              // Sums and differences are aligned to the smaller alignment of
+              // their operands.
+              for (auto operand : definingOp->getOperands()) {
+                auto alignment = solver.getElementFor<ValueAlignment>(
+                    *this, Position::forValue(operand),
+                    DFX::Resolution::REQUIRED);
+                newState ^= alignment;
+              }
+            } else if (auto castOp =
+                           dyn_cast<mlir::arith::IndexCastOp>(definingOp)) {
+              auto alignment = solver.getElementFor<ValueAlignment>(
+                  *this, Position::forValue(castOp.getIn()),
+                  DFX::Resolution::REQUIRED);
+              newState ^= alignment;
+            } else if (auto selectOp =
+                           dyn_cast<mlir::arith::SelectOp>(definingOp)) {
+              auto lhs = solver.getElementFor<ValueAlignment>(
+                  *this, Position::forValue(selectOp.getTrueValue()),
+                  DFX::Resolution::REQUIRED);
+              auto rhs = solver.getElementFor<ValueAlignment>(
+                  *this, Position::forValue(selectOp.getFalseValue()),
+                  DFX::Resolution::REQUIRED);
+              newState ^= lhs;
+              newState ^= rhs;
+            } else {
+              // Some other dynamic value we can't analyze (yet).
+              newState.indicatePessimisticFixpoint();
+            }
+            return WalkResult::advance();
+          }) == TraversalResult::INCOMPLETE) {
+        newState.indicatePessimisticFixpoint();
+      }
+    }
+
+    return DFX::clampStateAndIndicateChange(getState(), newState);
+  }
+
+  friend class DFX::Solver;
+};
+const char ValueAlignment::ID = 0;
+
+//===----------------------------------------------------------------------===//
+// DispatchArgumentAnalysis
+//===----------------------------------------------------------------------===//
+
+DispatchArgumentAnalysis::DispatchArgumentAnalysis(Operation *rootOp)
+    : explorer(rootOp, TraversalAction::SHALLOW), solver(explorer, allocator) {
+  explorer.setOpAction<IREE::Util::InitializerOp>(TraversalAction::RECURSE);
+  explorer.setOpAction<mlir::FuncOp>(TraversalAction::RECURSE);
+  explorer.setDialectAction<IREE::Stream::StreamDialect>(
+      TraversalAction::RECURSE);
+  // Ignore the contents of executables (linalg goo, etc).
+  explorer.setOpAction<IREE::Stream::ExecutableOp>(TraversalAction::IGNORE);
+  explorer.initialize();
+
+  // Find all dispatches and bucket by their target entry point.
+  rootOp->walk([&](IREE::Stream::CmdDispatchOp dispatchOp) {
+    auto exportOp = explorer.getSymbolTables().lookupNearestSymbolFrom(
+        dispatchOp, dispatchOp.entry_point());
+    entryDispatchMap[exportOp].push_back(dispatchOp);
+  });
+}
+
+DispatchArgumentAnalysis::~DispatchArgumentAnalysis() = default;
+
+LogicalResult DispatchArgumentAnalysis::run() {
+  // Seed all dispatch arguments we want to analyze.
+  for (auto it : entryDispatchMap) {
+    for (auto dispatchOp : it.second) {
+      for (auto operand : dispatchOp.operands()) {
+        solver.getOrCreateElementFor<ValuePVS>(Position::forValue(operand));
+        solver.getOrCreateElementFor<ValueAlignment>(
+            Position::forValue(operand));
+      }
+      for (auto resourceOffset : dispatchOp.resource_offsets()) {
+        solver.getOrCreateElementFor<ValueAlignment>(
+            Position::forValue(resourceOffset));
+      }
+    }
+  }
+
+  // Run solver to completion.
+  return solver.run();
+}
+
+ArrayRef<IREE::Stream::CmdDispatchOp>
+DispatchArgumentAnalysis::getDispatchSites(
+    IREE::Stream::ExecutableExportOp exportOp) {
+  auto it = entryDispatchMap.find(exportOp);
+  if (it == entryDispatchMap.end()) return {};
+  return it->second;
+}
+
+llvm::Optional<APInt> DispatchArgumentAnalysis::getConstantValue(Value value) {
+  auto element = solver.lookupElementFor<ValuePVS>(Position::forValue(value));
+  if (!element || !element->isValidState() || element->isUndefContained()) {
+    return llvm::None;
+  }
+  auto &set = element->getAssumedSet();
+  if (set.size() != 1) return llvm::None;
+  return *set.begin();
+}
+
+// TODO(benvanik): replace these with dedicated
+// ArgumentAlignment/ResourceOffsetAlignment state that does this unioning as
+// part of the solver. It's not strictly required as this is unidirectional
+// (the alignment of the export arguments is dictated by the dispatch sites
+// and not the other way around) but would be cleaner.
+
+DFX::PotentialConstantIntValuesState DispatchArgumentAnalysis::getOperandPVS(
+    IREE::Stream::ExecutableExportOp exportOp, unsigned operandIdx) {
+  DFX::PotentialConstantIntValuesState state;
+  for (auto dispatchOp : getDispatchSites(exportOp)) {
+    auto element = solver.lookupElementFor<ValuePVS>(
+        Position::forValue(dispatchOp.operands()[operandIdx]));
+    if (!element) {
+      state.unionAssumedWithUndef();
+      state.indicatePessimisticFixpoint();
+      break;
+    }
+    state ^= element->getState();
+  }
+  return state;
+}
+
+llvm::MaybeAlign DispatchArgumentAnalysis::getOperandAlignment(
+    IREE::Stream::ExecutableExportOp exportOp, unsigned operandIdx) {
+  llvm::MaybeAlign alignment;
+  for (auto dispatchOp : getDispatchSites(exportOp)) {
+    auto element = solver.lookupElementFor<ValueAlignment>(
+        Position::forValue(dispatchOp.operands()[operandIdx]));
+    if (!element || !element->isValidState()) return llvm::MaybeAlign();
+    alignment =
+        llvm::commonAlignment(alignment, element->getAssumedAlignment());
+  }
+  if (alignment.valueOrOne().value() == kMaximumAlignment) {
+    return llvm::MaybeAlign();
+  }
+  return alignment;
+}
+
+llvm::MaybeAlign DispatchArgumentAnalysis::getResourceOffsetAlignment(
+    IREE::Stream::ExecutableExportOp exportOp, unsigned resourceIdx) {
+  llvm::MaybeAlign alignment;
+  for (auto dispatchOp : getDispatchSites(exportOp)) {
+    auto element = solver.lookupElementFor<ValueAlignment>(
+        Position::forValue(dispatchOp.resource_offsets()[resourceIdx]));
+    if (!element || !element->isValidState()) return llvm::MaybeAlign();
+    alignment =
+        llvm::commonAlignment(alignment, element->getAssumedAlignment());
+  }
+  if (alignment.valueOrOne().value() == kMaximumAlignment) {
+    // Alignment is natural, which for resources means the base resource
+    // alignment.
+    auto configAttr = IREE::Stream::ResourceConfigAttr::lookup(exportOp);
+    return llvm::MaybeAlign(configAttr.getMinBufferOffsetAlignment());
+  }
+  return alignment;
+}
+
+}  // namespace Stream
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
@@ -0,0 +1,80 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_COMPILER_DIALECT_STREAM_ANALYSIS_DISPATCH_ARGUMENTS_H_
+#define IREE_COMPILER_DIALECT_STREAM_ANALYSIS_DISPATCH_ARGUMENTS_H_
+
+#include "iree/compiler/Dialect/Stream/IR/StreamOps.h"
+#include "iree/compiler/Dialect/Util/Analysis/DFX/Solver.h"
+#include "iree/compiler/Dialect/Util/Analysis/DFX/State.h"
+#include "iree/compiler/Dialect/Util/Analysis/Explorer.h"
+#include "llvm/ADT/APInt.h"
+#include "llvm/Support/Alignment.h"
+#include "mlir/IR/Attributes.h"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace Stream {
+
+//===----------------------------------------------------------------------===//
+// Dispatch argument analysis
+//===----------------------------------------------------------------------===//
+
+// Performs whole-program analysis of the values passed to dispatches.
+// All operands and resource offsets of `stream.cmd.dispatch` ops are analyzed
+// for their potential constant values and alignment. Values are tracked
+// through globals, calls, branches and simple integer arithmetic so that
+// dispatch sites in functions called with constant arguments are handled the
+// same as those with the constants available locally.
+class DispatchArgumentAnalysis {
+ public:
+  explicit DispatchArgumentAnalysis(Operation *rootOp);
+  ~DispatchArgumentAnalysis();
+
+  // Runs analysis and populates the state cache.
+  // May fail if analysis cannot be completed due to unsupported or unknown IR.
+  LogicalResult run();
+
+  // Returns a list of dispatch sites in arbitrary order to the given
+  // |exportOp|.
+  ArrayRef<IREE::Stream::CmdDispatchOp> getDispatchSites(
+      IREE::Stream::ExecutableExportOp exportOp);
+
+  // Returns the constant value of |value| if it was analyzed and has the same
+  // value on all paths that reach it.
+  llvm::Optional<APInt> getConstantValue(Value value);
+
+  // Returns the potential constant values across all dispatch sites to
+  // |exportOp| for the operand at |operandIdx|.
+  DFX::PotentialConstantIntValuesState getOperandPVS(
+      IREE::Stream::ExecutableExportOp exportOp, unsigned operandIdx);
+
+  // Returns the minimum alignment across all dispatch sites to |exportOp| for
+  // the operand at |operandIdx| or None if natural alignment should be assumed.
+  llvm::MaybeAlign getOperandAlignment(
+      IREE::Stream::ExecutableExportOp exportOp, unsigned operandIdx);
+
+  // Returns the minimum alignment across all dispatch sites to |exportOp| for
+  // the resource offset at |resourceIdx|.
+  llvm::MaybeAlign getResourceOffsetAlignment(
+      IREE::Stream::ExecutableExportOp exportOp, unsigned resourceIdx);
+
+ private:
+  Explorer explorer;
+  llvm::BumpPtrAllocator allocator;
+  DFX::Solver solver;
+
+  DenseMap<Operation *, SmallVector<IREE::Stream::CmdDispatchOp>>
+      entryDispatchMap;
+};
+
+}  // namespace Stream
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
+
+#endif  // IREE_COMPILER_DIALECT_STREAM_ANALYSIS_DISPATCH_ARGUMENTS_H_
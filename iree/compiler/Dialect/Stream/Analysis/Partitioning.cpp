@@ -9,6 +9,7 @@
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/Support/Debug.h"
 #include "mlir/IR/AsmState.h"
+#include "mlir/IR/BuiltinAttributes.h"
 #include "mlir/IR/PatternMatch.h"
 
 #define DEBUG_TYPE "iree-stream-partitioning"
@@ -153,6 +154,11 @@ void PartitionSet::topologicalSort() {
   partitions = std::move(sortedSet);
 }
 
+int64_t getOpDuration(Operation *op) {
+  auto durationAttr = op->getAttrOfType<IntegerAttr>(kDurationAttrName);
+  return durationAttr ? durationAttr.getInt() : 0;
+}
+
 PartitionSet partitionStreamableOps(IREE::Stream::PartitioningConfigAttr config,
                                     Block *block) {
   // Only one algorithm today.
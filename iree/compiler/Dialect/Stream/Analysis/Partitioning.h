@@ -22,6 +22,9 @@ namespace Stream {
 
 // A single slice of ops.
 struct Partition {
+  // Affinity all ops in the partition are compatible with, if any.
+  // Carried over to the execution region formed from the partition.
+  IREE::Stream::AffinityAttr affinity;
   // SSA values defined outside of the partition.
   // All values not defined by ops in the partition must be declared.
   // Multiple partitions may capture the same value.
@@ -60,6 +63,17 @@ struct PartitionSet {
   void topologicalSort();
 };
 
+//===----------------------------------------------------------------------===//
+// Cost model
+//===----------------------------------------------------------------------===//
+
+// Attribute carrying the measured duration of an op in nanoseconds as imported
+// from a runtime profile by -iree-stream-import-dispatch-profile.
+static constexpr StringLiteral kDurationAttrName = "stream.duration_ns";
+
+// Returns the measured duration of |op| in nanoseconds or 0 if unknown.
+int64_t getOpDuration(Operation *op);
+
 //===----------------------------------------------------------------------===//
 // Stream partitioning algorithms
 //===----------------------------------------------------------------------===//
@@ -120,6 +134,8 @@ PartitionSet partitionStreamableOpsReference(
 
 // Similarly poor algorithm to partitionStreamableOpsReference but for use
 // within partitioned streams to produce waves of concurrently executable work.
+// Ops with measured durations are packed into waves with ops of similar
+// durations to shorten the critical path.
 PartitionSet partitionRegionConcurrencyReference(
     IREE::Stream::PartitioningConfigAttr config, Block *block);
 
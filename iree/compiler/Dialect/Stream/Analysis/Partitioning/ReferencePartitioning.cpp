@@ -188,6 +188,7 @@ PartitionSet partitionStreamableOpsReference(
   // reverse order from our bottom-up walk).
   for (auto &builder : llvm::reverse(builders)) {
     Partition partition;
+    partition.affinity = builder->affinity;
 
     SetVector<Value> consumedValues;
     SetVector<Value> producedValues;
@@ -235,6 +236,9 @@ PartitionSet partitionRegionConcurrencyReference(
     unsigned ordinal;
     // Ops present in the wave; ops may be present in multiple waves.
     SetVector<Operation *> ops;
+    // Longest measured duration of any op in the wave. Waves are separated by
+    // barriers so each runs for as long as its longest op.
+    int64_t duration = 0;
   };
   SmallVector<std::unique_ptr<PartitionBuilder>> builders;
 
@@ -307,10 +311,32 @@ PartitionSet partitionRegionConcurrencyReference(
     int firstCandidateOrdinal = favor == IREE::Stream::Favor::MaxConcurrency
                                     ? candidates.find_first()
                                     : candidates.find_last();
+
+    // If we have measured durations then prefer the candidate wave that the op
+    // extends the least. The critical path through the region is the sum of
+    // the wave durations so packing long ops together and short ops together
+    // shortens it.
+    int64_t duration = getOpDuration(&op);
+    if (duration > 0 && firstCandidateOrdinal != -1) {
+      auto getGrowth = [&](int ordinal) {
+        return std::max(duration - builders[ordinal]->duration, int64_t(0));
+      };
+      int64_t minGrowth = getGrowth(firstCandidateOrdinal);
+      for (auto ordinal : candidates.set_bits()) {
+        int64_t growth = getGrowth(ordinal);
+        if (growth < minGrowth) {
+          firstCandidateOrdinal = ordinal;
+          minGrowth = growth;
+        }
+      }
+    }
+
     if (firstCandidateOrdinal != -1) {
       LLVM_DEBUG(llvm::dbgs() << "Moving to last candidate wave "
                               << firstCandidateOrdinal << " (continue)\n");
       builders[firstCandidateOrdinal]->ops.insert(&op);
+      builders[firstCandidateOrdinal]->duration =
+          std::max(builders[firstCandidateOrdinal]->duration, duration);
       opInfo.membership.set(firstCandidateOrdinal);
       opInfo.hazards.set(0, firstCandidateOrdinal);
       opInfo.hazards.reset(firstCandidateOrdinal);
@@ -325,6 +351,7 @@ PartitionSet partitionRegionConcurrencyReference(
     auto builder = std::make_unique<PartitionBuilder>();
     builder->ordinal = builders.size();
     builder->ops.insert(&op);
+    builder->duration = duration;
     LLVM_DEBUG(llvm::dbgs() << "Created wave " << builder->ordinal << "\n");
     builders.push_back(std::move(builder));
   }
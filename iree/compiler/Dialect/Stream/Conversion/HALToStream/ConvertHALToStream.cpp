@@ -159,7 +159,9 @@ struct ConvertTensorExportOp
           TypeAttr::get(sourceType), adaptor.source_dims(), storageSize,
           /*affinity=*/nullptr);
 
-      // Copy the source value into the imported target storage.
+      // Copy the source value into the imported target storage. Allocation
+      // will place the producer of the source value directly into the storage
+      // when possible such that no copy is performed at runtime.
       auto zeroOffset = rewriter.create<arith::ConstantIndexOp>(op.getLoc(), 0);
       auto updateOp = rewriter.create<IREE::Stream::AsyncUpdateOp>(
           op.getLoc(), externalType, importOp.result(), importOp.result_size(),
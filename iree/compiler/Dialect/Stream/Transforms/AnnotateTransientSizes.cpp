@@ -0,0 +1,105 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Dialect/Stream/IR/StreamOps.h"
+#include "iree/compiler/Dialect/Stream/IR/StreamTypes.h"
+#include "iree/compiler/Dialect/Stream/Transforms/PassDetail.h"
+#include "iree/compiler/Dialect/Stream/Transforms/Passes.h"
+#include "llvm/Support/Debug.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/IR/SymbolTable.h"
+#include "mlir/Interfaces/CallInterfaces.h"
+#include "mlir/Pass/Pass.h"
+
+#define DEBUG_TYPE "iree-stream-annotate-transient-sizes"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace Stream {
+namespace {
+
+// Returns an upper bound of the total size of the transient allocations live
+// at any point during an invocation of |funcOp| or None if it is not known
+// statically.
+static llvm::Optional<uint64_t> calculatePeakTransientSize(
+    mlir::FuncOp funcOp, SymbolTable &symbolTable) {
+  uint64_t peakSize = 0;
+  auto walkResult = funcOp.walk([&](Operation *op) -> WalkResult {
+    if (auto callOp = dyn_cast<CallOpInterface>(op)) {
+      // Callees may allocate their own transients.
+      auto calleeRef = callOp.getCallableForCallee().dyn_cast<SymbolRefAttr>();
+      if (!calleeRef) return WalkResult::interrupt();
+      auto calleeOp = symbolTable.lookup<mlir::FuncOp>(
+          calleeRef.getLeafReference().getValue());
+      if (calleeOp && !calleeOp.isExternal()) return WalkResult::interrupt();
+      return WalkResult::advance();
+    }
+    auto allocaOp = dyn_cast<IREE::Stream::ResourceAllocaOp>(op);
+    if (!allocaOp) return WalkResult::advance();
+    auto resourceType =
+        allocaOp.result().getType().cast<IREE::Stream::ResourceType>();
+    if (resourceType.getLifetime() != IREE::Stream::Lifetime::Transient) {
+      return WalkResult::advance();
+    }
+    // Transients are packed into a single arena per block by now and summing
+    // the arenas of all blocks is conservative for programs with control flow.
+    APInt size;
+    if (!matchPattern(allocaOp.storage_size(), m_ConstantInt(&size))) {
+      LLVM_DEBUG(llvm::dbgs() << "! dynamically sized transient: " << allocaOp
+                              << "\n");
+      return WalkResult::interrupt();
+    }
+    peakSize += size.getZExtValue();
+    return WalkResult::advance();
+  });
+  if (walkResult.wasInterrupted()) return llvm::None;
+  return peakSize;
+}
+
+//===----------------------------------------------------------------------===//
+// -iree-stream-annotate-transient-sizes
+//===----------------------------------------------------------------------===//
+
+class AnnotateTransientSizesPass
+    : public AnnotateTransientSizesBase<AnnotateTransientSizesPass> {
+ public:
+  void runOnOperation() override {
+    auto moduleOp = getOperation();
+    SymbolTable symbolTable(moduleOp);
+
+    // Annotate public functions with the peak size of their transients such
+    // that the runtime can check whether a call fits in the memory available
+    // before issuing it. Reflection attributes are carried through to the VM
+    // function exports.
+    for (auto funcOp : moduleOp.getOps<mlir::FuncOp>()) {
+      if (!funcOp.isPublic() || funcOp.isExternal()) continue;
+      auto peakSize = calculatePeakTransientSize(funcOp, symbolTable);
+      if (!peakSize.hasValue() || peakSize.getValue() == 0) continue;
+      NamedAttrList reflectionAttrs(
+          funcOp->getAttrOfType<DictionaryAttr>("iree.reflection"));
+      reflectionAttrs.set(
+          "iree.peak_transient_size",
+          StringAttr::get(&getContext(), std::to_string(peakSize.getValue())));
+      funcOp->setAttr("iree.reflection",
+                      reflectionAttrs.getDictionary(&getContext()));
+    }
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<OperationPass<mlir::ModuleOp>>
+createAnnotateTransientSizesPass() {
+  return std::make_unique<AnnotateTransientSizesPass>();
+}
+
+}  // namespace Stream
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
@@ -0,0 +1,252 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Dialect/Stream/IR/StreamDialect.h"
+#include "iree/compiler/Dialect/Stream/IR/StreamOps.h"
+#include "iree/compiler/Dialect/Stream/IR/StreamTypes.h"
+#include "iree/compiler/Dialect/Stream/Transforms/PassDetail.h"
+#include "iree/compiler/Dialect/Stream/Transforms/Passes.h"
+#include "iree/compiler/Dialect/Util/IR/UtilDialect.h"
+#include "iree/compiler/Dialect/Util/IR/UtilOps.h"
+#include "llvm/Support/Debug.h"
+#include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
+#include "mlir/Dialect/SCF/SCF.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/SymbolTable.h"
+#include "mlir/Interfaces/CallInterfaces.h"
+#include "mlir/Pass/Pass.h"
+
+#define DEBUG_TYPE "iree-stream-cache-transients"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace Stream {
+namespace {
+
+//===----------------------------------------------------------------------===//
+// Transient slice matching
+//===----------------------------------------------------------------------===//
+
+// A stream.resource.alloca/stream.resource.dealloca pair in a block.
+struct TransientSlice {
+  IREE::Stream::ResourceAllocaOp allocaOp;
+  IREE::Stream::ResourceDeallocaOp deallocaOp;
+};
+
+// Returns the slice of |allocaOp| if it is deallocated in the same block, all
+// uses are before the deallocation, and no calls are made while it is live.
+// Calls may re-enter the function and would then reuse the cached arena while
+// it is still in use by the caller.
+static llvm::Optional<TransientSlice> matchTransientSlice(
+    IREE::Stream::ResourceAllocaOp allocaOp) {
+  auto resourceType =
+      allocaOp.result().getType().cast<IREE::Stream::ResourceType>();
+  if (resourceType.getLifetime() != IREE::Stream::Lifetime::Transient) {
+    return llvm::None;
+  }
+
+  Block *block = allocaOp->getBlock();
+  TransientSlice slice;
+  slice.allocaOp = allocaOp;
+  SmallVector<Operation *> userOps;
+  for (auto &use : allocaOp.result().getUses()) {
+    auto *userOp = block->findAncestorOpInBlock(*use.getOwner());
+    if (!userOp) return llvm::None;
+    if (auto deallocaOp = dyn_cast<IREE::Stream::ResourceDeallocaOp>(userOp)) {
+      if (slice.deallocaOp) return llvm::None;
+      slice.deallocaOp = deallocaOp;
+    } else {
+      userOps.push_back(userOp);
+    }
+  }
+  if (!slice.deallocaOp) return llvm::None;
+  for (auto *userOp : userOps) {
+    if (slice.deallocaOp->isBeforeInBlock(userOp)) return llvm::None;
+  }
+
+  for (auto *op = allocaOp->getNextNode(); op != slice.deallocaOp;
+       op = op->getNextNode()) {
+    auto walkResult = op->walk([](CallOpInterface callOp) {
+      return WalkResult::interrupt();
+    });
+    if (walkResult.wasInterrupted()) {
+      LLVM_DEBUG(llvm::dbgs() << "! call made while transient is live: "
+                              << allocaOp << "\n");
+      return llvm::None;
+    }
+  }
+  return slice;
+}
+
+//===----------------------------------------------------------------------===//
+// Arena caching
+//===----------------------------------------------------------------------===//
+
+// Globals holding the cached arena of a transient slice.
+struct CachedArena {
+  // Cached !stream.resource<transient> arena or null if not yet allocated.
+  IREE::Util::GlobalOp resourceOp;
+  // Size of the cached arena in bytes or 0 if not yet allocated.
+  IREE::Util::GlobalOp resourceSizeOp;
+  // Timepoint reached when the previous user of the arena has deallocated it.
+  IREE::Util::GlobalOp timepointOp;
+};
+
+static CachedArena createCachedArenaGlobals(Location loc, StringRef namePrefix,
+                                            Type resourceType,
+                                            SymbolTable &symbolTable,
+                                            OpBuilder &moduleBuilder) {
+  auto timepointType = moduleBuilder.getType<IREE::Stream::TimepointType>();
+  CachedArena arena;
+  arena.resourceOp = moduleBuilder.create<IREE::Util::GlobalOp>(
+      loc, (namePrefix + "__transient_arena").str(), /*isMutable=*/true,
+      resourceType);
+  arena.resourceSizeOp = moduleBuilder.create<IREE::Util::GlobalOp>(
+      loc, (namePrefix + "__transient_arena_size").str(), /*isMutable=*/true,
+      moduleBuilder.getIndexType(), moduleBuilder.getIndexAttr(0));
+  arena.timepointOp = moduleBuilder.create<IREE::Util::GlobalOp>(
+      loc, (namePrefix + "__transient_arena_timepoint").str(),
+      /*isMutable=*/true, timepointType,
+      IREE::Stream::TimepointAttr::get(moduleBuilder.getContext(),
+                                       timepointType));
+  for (auto globalOp :
+       {arena.resourceOp, arena.resourceSizeOp, arena.timepointOp}) {
+    globalOp.setPrivate();
+    symbolTable.insert(globalOp);  // uniques name
+  }
+  return arena;
+}
+
+// Replaces the allocation of |slice| with the cached |arena|, reallocating the
+// arena when it is smaller than required. Reusing the arena waits until the
+// previous invocation has deallocated it and the deallocation only records
+// when that happens.
+static void cacheTransientSlice(TransientSlice &slice, CachedArena &arena) {
+  auto allocaOp = slice.allocaOp;
+  auto loc = allocaOp.getLoc();
+  auto resourceType = allocaOp.result().getType();
+  auto timepointType = allocaOp.result_timepoint().getType();
+  auto indexType = allocaOp.storage_size().getType();
+  OpBuilder builder(allocaOp);
+
+  // %fits = 0 < %cached_size && %size <= %cached_size
+  auto cachedResource =
+      builder.create<IREE::Util::GlobalLoadOp>(loc, arena.resourceOp);
+  auto cachedSize =
+      builder.create<IREE::Util::GlobalLoadOp>(loc, arena.resourceSizeOp);
+  auto cachedTimepoint =
+      builder.create<IREE::Util::GlobalLoadOp>(loc, arena.timepointOp);
+  auto requiredSize = allocaOp.storage_size();
+  auto zero = builder.create<arith::ConstantIndexOp>(loc, 0);
+  auto fits = builder.create<arith::AndIOp>(
+      loc,
+      builder.create<arith::CmpIOp>(loc, arith::CmpIPredicate::ult, zero,
+                                    cachedSize),
+      builder.create<arith::CmpIOp>(loc, arith::CmpIPredicate::ule,
+                                    requiredSize, cachedSize));
+  auto ifOp = builder.create<scf::IfOp>(
+      loc, TypeRange{resourceType, indexType, timepointType}, fits,
+      [&](OpBuilder &thenBuilder, Location loc) {
+        thenBuilder.create<scf::YieldOp>(
+            loc, ValueRange{cachedResource, cachedSize, cachedTimepoint});
+      },
+      [&](OpBuilder &elseBuilder, Location loc) {
+        // The previous arena (if any) is released once its users complete.
+        auto newAllocaOp = elseBuilder.create<IREE::Stream::ResourceAllocaOp>(
+            loc, resourceType, timepointType, requiredSize,
+            /*await_timepoint=*/nullptr, allocaOp.affinityAttr());
+        elseBuilder.create<IREE::Util::GlobalStoreOp>(
+            loc, newAllocaOp.result(), arena.resourceOp.getName());
+        elseBuilder.create<IREE::Util::GlobalStoreOp>(
+            loc, requiredSize, arena.resourceSizeOp.getName());
+        elseBuilder.create<scf::YieldOp>(
+            loc, ValueRange{newAllocaOp.result(), requiredSize,
+                            newAllocaOp.result_timepoint()});
+      });
+  auto arenaResource = ifOp.getResult(0);
+  auto arenaSize = ifOp.getResult(1);
+  Value readyTimepoint = ifOp.getResult(2);
+  if (allocaOp.await_timepoint()) {
+    readyTimepoint = builder.create<IREE::Stream::TimepointJoinOp>(
+        loc, timepointType,
+        ValueRange{readyTimepoint, allocaOp.await_timepoint()});
+  }
+  auto subviewOp = builder.create<IREE::Stream::ResourceSubviewOp>(
+      loc, arenaResource, arenaSize, zero, requiredSize);
+  allocaOp.result().replaceAllUsesWith(subviewOp.result());
+  allocaOp.result_timepoint().replaceAllUsesWith(readyTimepoint);
+  allocaOp.erase();
+
+  // The arena is available to the next invocation once all users complete.
+  auto deallocaOp = slice.deallocaOp;
+  OpBuilder deallocaBuilder(deallocaOp);
+  Value releaseTimepoint = deallocaOp.await_timepoint();
+  if (!releaseTimepoint) {
+    releaseTimepoint =
+        deallocaBuilder.create<IREE::Stream::TimepointImmediateOp>(
+            deallocaOp.getLoc());
+  }
+  deallocaBuilder.create<IREE::Util::GlobalStoreOp>(
+      deallocaOp.getLoc(), releaseTimepoint, arena.timepointOp.getName());
+  deallocaOp.result_timepoint().replaceAllUsesWith(releaseTimepoint);
+  deallocaOp.erase();
+}
+
+//===----------------------------------------------------------------------===//
+// -iree-stream-cache-transients
+//===----------------------------------------------------------------------===//
+
+class CacheTransientsPass : public CacheTransientsBase<CacheTransientsPass> {
+ public:
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<mlir::arith::ArithmeticDialect>();
+    registry.insert<mlir::scf::SCFDialect>();
+    registry.insert<IREE::Stream::StreamDialect>();
+    registry.insert<IREE::Util::UtilDialect>();
+  }
+
+  void runOnOperation() override {
+    auto moduleOp = getOperation();
+    SymbolTable symbolTable(moduleOp);
+    OpBuilder moduleBuilder(moduleOp.getBody(), moduleOp.getBody()->begin());
+
+    // Transient arenas (packed by -iree-stream-pack-transients) are allocated
+    // and deallocated on each invocation of a function. Here we keep each
+    // arena in a global once allocated and reuse it across invocations such
+    // that steady-state invocations don't touch the allocator. The arena is
+    // grown when an invocation requires more memory than it has. Invocations
+    // of a module are externally synchronized on the host and reuse on the
+    // device waits for the previous invocation to deallocate the arena.
+    // Initializers only run once and are skipped.
+    for (auto funcOp : moduleOp.getOps<mlir::FuncOp>()) {
+      SmallVector<TransientSlice> slices;
+      funcOp.walk([&](IREE::Stream::ResourceAllocaOp allocaOp) {
+        if (auto slice = matchTransientSlice(allocaOp)) {
+          slices.push_back(*slice);
+        }
+      });
+      for (auto &slice : slices) {
+        auto arena = createCachedArenaGlobals(
+            slice.allocaOp.getLoc(), funcOp.getName(),
+            slice.allocaOp.result().getType(), symbolTable, moduleBuilder);
+        cacheTransientSlice(slice, arena);
+      }
+    }
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<OperationPass<mlir::ModuleOp>> createCacheTransientsPass() {
+  return std::make_unique<CacheTransientsPass>();
+}
+
+}  // namespace Stream
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
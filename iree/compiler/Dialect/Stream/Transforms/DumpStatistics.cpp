@@ -106,6 +106,10 @@ struct Statistics {
   size_t submissionCount = 0;
   int64_t transientSize = 0;
   bool transientSizeDynamic = false;
+  // Transient size if each allocation packed into an arena had been allocated
+  // on its own (see -iree-stream-pack-transients).
+  int64_t unpackedTransientSize = 0;
+  bool unpackedTransientSizeDynamic = false;
   // TODO(benvanik): add fill/copy sizes (when possible).
   size_t fillCount = 0;
   size_t copyCount = 0;
@@ -139,11 +143,21 @@ struct Statistics {
     submissionCount = usageInfo.executeOps.size();
     for (auto allocaOp : usageInfo.allocaOps) {
       APInt allocaSize;
-      if (matchPattern(allocaOp.storage_size(), m_ConstantInt(&allocaSize))) {
+      bool isStatic =
+          matchPattern(allocaOp.storage_size(), m_ConstantInt(&allocaSize));
+      if (isStatic) {
         transientSize += allocaSize.getSExtValue();
       } else {
         transientSizeDynamic = true;
       }
+      if (auto unpackedSizeAttr =
+              allocaOp->getAttrOfType<IntegerAttr>("stream.unpacked_size")) {
+        unpackedTransientSize += unpackedSizeAttr.getInt();
+      } else if (isStatic) {
+        unpackedTransientSize += allocaSize.getSExtValue();
+      } else {
+        unpackedTransientSizeDynamic = true;
+      }
     }
     for (auto executeOp : usageInfo.executeOps) {
       executeOp.walk([&](Operation *op) {
@@ -223,6 +237,15 @@ static void prettyPrintStatistics(const UsageInfo &usageInfo,
       "{0}{1} B ({2:F2} MiB)\n", stats.transientSizeDynamic ? "minimum " : "",
       stats.transientSize, stats.transientSize / (1 * 1024 * 1024.0f));
 
+  os << llvm::formatv(
+      "//  Transients: {0}{1} B ({2:F2} MiB) planned peak, ",
+      stats.transientSizeDynamic ? "minimum " : "", stats.transientSize,
+      stats.transientSize / (1 * 1024 * 1024.0f));
+  os << llvm::formatv("{0}{1} B ({2:F2} MiB) unplanned sum\n",
+                      stats.unpackedTransientSizeDynamic ? "minimum " : "",
+                      stats.unpackedTransientSize,
+                      stats.unpackedTransientSize / (1 * 1024 * 1024.0f));
+
   os << llvm::formatv("//   DMA Fills: {0}\n", stats.fillCount);
   os << llvm::formatv("//  DMA Copies: {0}\n", stats.copyCount);
   os << llvm::formatv("//  Dispatches: {0}\n", stats.dispatchCount);
@@ -379,7 +402,7 @@ static void dumpAggregateCSVTable(const UsageInfo &usageInfo,
   Statistics stats;
   stats.analyze(usageInfo);
 
-  os << R"("Constants","Constant Size","Variables","Variable Size","Awaits","Submissions","Transient Size","Fills","Copies","Dispatches","Executables")";
+  os << R"("Constants","Constant Size","Variables","Variable Size","Awaits","Submissions","Transient Size","Unpacked Transient Size","Fills","Copies","Dispatches","Executables")";
   os << "\n";
 
   // Globals:
@@ -391,9 +414,9 @@ static void dumpAggregateCSVTable(const UsageInfo &usageInfo,
   os << llvm::formatv("{0},", stats.awaitCount);
 
   // Execution:
-  os << llvm::formatv("{0},{1},{2},{3},{4},", stats.submissionCount,
-                      stats.transientSize, stats.fillCount, stats.copyCount,
-                      stats.dispatchCount);
+  os << llvm::formatv("{0},{1},{2},{3},{4},{5},", stats.submissionCount,
+                      stats.transientSize, stats.unpackedTransientSize,
+                      stats.fillCount, stats.copyCount, stats.dispatchCount);
 
   // Executables:
   os << llvm::formatv("{0}", stats.executableCount);
@@ -501,6 +524,8 @@ static void dumpAggregateJSONStructure(const UsageInfo &usageInfo,
   os << "  \"execution\": {\n";
   os << llvm::formatv(kvPair, "submission-count", stats.submissionCount);
   os << llvm::formatv(kvPair, "transient-memory-size", stats.transientSize);
+  os << llvm::formatv(kvPair, "unpacked-transient-memory-size",
+                      stats.unpackedTransientSize);
   os << llvm::formatv(kvPair, "fill-count", stats.fillCount);
   os << llvm::formatv(kvPair, "copy-count", stats.copyCount);
   os << llvm::formatv(kvPairNoComma, "dispatch-count", stats.dispatchCount);
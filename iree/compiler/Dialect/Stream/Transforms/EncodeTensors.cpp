@@ -16,8 +16,10 @@
 #include "iree/compiler/Dialect/Util/IR/UtilOps.h"
 #include "iree/compiler/Dialect/Util/IR/UtilTypes.h"
 #include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
+#include "mlir/Dialect/Linalg/IR/Linalg.h"
 #include "mlir/Dialect/StandardOps/IR/Ops.h"
 #include "mlir/Dialect/Tensor/IR/Tensor.h"
+#include "mlir/Dialect/Utils/StaticValueUtils.h"
 #include "mlir/IR/Attributes.h"
 #include "mlir/IR/Builders.h"
 #include "mlir/IR/BuiltinOps.h"
@@ -81,6 +83,41 @@ static RankedTensorType alignTensorType(RankedTensorType originalType) {
                                originalType.getEncoding());
 }
 
+// Returns true if tensors of |shape| and |elementType| are stored with two
+// elements packed into each byte when i4 packing is enabled. The innermost
+// dimension must be static and even so that every row begins on a byte
+// boundary; all other i4 tensors are widened to i8.
+//
+// Element 2k is stored in the low nibble of byte k and element 2k+1 in the
+// high nibble.
+static bool isPackedI4Type(ArrayRef<int64_t> shape, Type elementType,
+                           bool packI4) {
+  if (!packI4 || shape.empty()) return false;
+  auto intType = elementType.dyn_cast<IntegerType>();
+  if (!intType || !intType.isSignless() || intType.getWidth() != 4) {
+    return false;
+  }
+  return !ShapedType::isDynamic(shape.back()) && shape.back() % 2 == 0;
+}
+static bool isPackedI4Type(RankedTensorType tensorType, bool packI4) {
+  return isPackedI4Type(tensorType.getShape(), tensorType.getElementType(),
+                        packI4);
+}
+
+// Returns the shape of the i8 storage of a packed i4 tensor of |shape|.
+static SmallVector<int64_t> getPackedI4StorageShape(ArrayRef<int64_t> shape) {
+  SmallVector<int64_t> storageShape(shape.begin(), shape.end());
+  storageShape.back() /= 2;
+  return storageShape;
+}
+
+// Returns the i8 tensor type used to store a packed i4 |tensorType|.
+static RankedTensorType getPackedI4StorageType(RankedTensorType tensorType) {
+  return RankedTensorType::get(
+      getPackedI4StorageShape(tensorType.getShape()),
+      IntegerType::get(tensorType.getContext(), 8));
+}
+
 // Returns the element count of a tensor with optional dynamic dimensions.
 // Many of these will be static and since this is used _a lot_ we do a bit of
 // work to try to avoid a bunch of trivially foldable ops.
@@ -140,19 +177,45 @@ static Value calculateElementOffset(Location loc, RankedTensorType tensorType,
 }
 
 // Returns an element offset within a dense tensor based on indices, in bytes.
+// Packed i4 offsets are rounded down to the byte containing the element.
 static Value calculateElementByteOffset(Location loc,
                                         RankedTensorType tensorType,
                                         ValueRange dynamicDims,
-                                        ValueRange indices,
+                                        ValueRange indices, bool packI4,
                                         PatternRewriter &rewriter) {
+  auto elementOffset =
+      calculateElementOffset(loc, tensorType, dynamicDims, indices, rewriter);
+  if (isPackedI4Type(tensorType, packI4)) {
+    return rewriter.createOrFold<arith::DivUIOp>(
+        loc, elementOffset, rewriter.create<arith::ConstantIndexOp>(loc, 2));
+  }
   return rewriter.createOrFold<arith::MulIOp>(
-      loc,
-      calculateElementOffset(loc, tensorType, dynamicDims, indices, rewriter),
+      loc, elementOffset,
       rewriter.create<arith::ConstantIndexOp>(
           loc,
           IREE::Util::getRoundedElementByteWidth(tensorType.getElementType())));
 }
 
+// Returns the bit offset of the packed i4 element at |elementOffset| within
+// its byte as an i8 shift amount.
+static Value calculatePackedI4Shift(Location loc, Value elementOffset,
+                                    PatternRewriter &rewriter) {
+  auto nibble = rewriter.createOrFold<arith::RemUIOp>(
+      loc, elementOffset, rewriter.create<arith::ConstantIndexOp>(loc, 2));
+  auto shift = rewriter.createOrFold<arith::MulIOp>(
+      loc, nibble, rewriter.create<arith::ConstantIndexOp>(loc, 4));
+  return rewriter.createOrFold<arith::IndexCastOp>(loc, rewriter.getI8Type(),
+                                                   shift);
+}
+
+// Base for host encoding patterns that depend on the i4 packing policy.
+template <typename OpTy>
+struct EncodingPattern : public OpRewritePattern<OpTy> {
+  EncodingPattern(MLIRContext *context, bool packI4)
+      : OpRewritePattern<OpTy>(context), packI4(packI4) {}
+  bool packI4;
+};
+
 //===----------------------------------------------------------------------===//
 // stream.tensor.import
 //===----------------------------------------------------------------------===//
@@ -204,8 +267,8 @@ struct EncodeTensorExportOp
 //===----------------------------------------------------------------------===//
 
 struct EncodeTensorSizeOfOp
-    : public OpRewritePattern<IREE::Stream::TensorSizeOfOp> {
-  using OpRewritePattern::OpRewritePattern;
+    : public EncodingPattern<IREE::Stream::TensorSizeOfOp> {
+  using EncodingPattern::EncodingPattern;
   LogicalResult matchAndRewrite(IREE::Stream::TensorSizeOfOp op,
                                 PatternRewriter &rewriter) const override {
     auto encodingType = op.encoding().cast<RankedTensorType>();
@@ -214,6 +277,15 @@ struct EncodeTensorSizeOfOp
       return failure();
     }
 
+    // Packed i4: one byte per pair of elements.
+    if (isPackedI4Type(encodingType, packI4)) {
+      rewriter.replaceOp(
+          op, calculateElementCount(op.getLoc(),
+                                    getPackedI4StorageType(encodingType),
+                                    encodingDims, 1, rewriter));
+      return success();
+    }
+
     // Dense: element count * element size.
     auto elementByteSize =
         IREE::Util::getRoundedElementByteWidth(encodingType.getElementType());
@@ -229,9 +301,29 @@ struct EncodeTensorSizeOfOp
 // stream.tensor.constant
 //===----------------------------------------------------------------------===//
 
+// Packs the i4 elements of |attr| two per byte into an i8 elements attr with
+// the innermost dimension halved. Returns nullptr if |attr| is not dense.
+static ElementsAttr packI4Constant(ElementsAttr attr) {
+  auto sourceAttr = attr.dyn_cast<DenseIntElementsAttr>();
+  if (!sourceAttr) return {};
+  auto storageType =
+      getPackedI4StorageType(sourceAttr.getType().cast<RankedTensorType>());
+  if (sourceAttr.isSplat()) {
+    uint8_t nibble = sourceAttr.getSplatValue<APInt>().getZExtValue() & 0xFu;
+    return DenseElementsAttr::get(
+        storageType, static_cast<uint8_t>(nibble | (nibble << 4)));
+  }
+  SmallVector<uint8_t> packedValues(storageType.getNumElements(), 0);
+  for (auto it : llvm::enumerate(sourceAttr.getValues<APInt>())) {
+    uint8_t nibble = it.value().getZExtValue() & 0xFu;
+    packedValues[it.index() / 2] |= nibble << ((it.index() % 2) * 4);
+  }
+  return DenseElementsAttr::get(storageType, llvm::makeArrayRef(packedValues));
+}
+
 struct EncodeTensorConstantOp
-    : public OpRewritePattern<IREE::Stream::TensorConstantOp> {
-  using OpRewritePattern::OpRewritePattern;
+    : public EncodingPattern<IREE::Stream::TensorConstantOp> {
+  using EncodingPattern::EncodingPattern;
   LogicalResult matchAndRewrite(IREE::Stream::TensorConstantOp op,
                                 PatternRewriter &rewriter) const override {
     auto resultType = op.result_encoding().cast<RankedTensorType>();
@@ -253,6 +345,22 @@ struct EncodeTensorConstantOp
     // can make the tradeoff for minimizing file size vs minimizing startup
     // cost.
 
+    // Packed i4 constants store two elements per byte.
+    if (isPackedI4Type(resultType, packI4)) {
+      auto encodedAttr = packI4Constant(op.value());
+      if (!encodedAttr) {
+        return rewriter.notifyMatchFailure(
+            op, "packed i4 constants must be dense integer elements");
+      }
+      auto resultSize = calculateElementCount(
+          op.getLoc(), getPackedI4StorageType(resultType), resultDims, 1,
+          rewriter);
+      rewriter.replaceOpWithNewOp<IREE::Stream::AsyncConstantOp>(
+          op, op.result().getType(), encodedAttr, resultSize,
+          op.affinityAttr());
+      return success();
+    }
+
     // Sub-byte aligned constants need to be expanded to a power of 2
     // byte-aligned width. This is unfortunate: it's wasted bits in the final
     // binary that we could otherwise use productively.
@@ -329,9 +437,20 @@ static Value canonicalizeFillPattern(Value pattern, PatternRewriter &rewriter) {
   return pattern;
 }
 
+// Returns an i8 fill pattern that writes the i4 |pattern| into both nibbles of
+// each byte of packed i4 storage.
+static Value packI4FillPattern(Value pattern, PatternRewriter &rewriter) {
+  auto loc = pattern.getLoc();
+  auto lo =
+      rewriter.createOrFold<arith::ExtUIOp>(loc, rewriter.getI8Type(), pattern);
+  auto hi = rewriter.createOrFold<arith::ShLIOp>(
+      loc, lo, rewriter.create<arith::ConstantIntOp>(loc, 4, 8));
+  return rewriter.createOrFold<arith::OrIOp>(loc, lo, hi);
+}
+
 struct EncodeTensorSplatOp
-    : public OpRewritePattern<IREE::Stream::TensorSplatOp> {
-  using OpRewritePattern::OpRewritePattern;
+    : public EncodingPattern<IREE::Stream::TensorSplatOp> {
+  using EncodingPattern::EncodingPattern;
   LogicalResult matchAndRewrite(IREE::Stream::TensorSplatOp op,
                                 PatternRewriter &rewriter) const override {
     auto resultType = op.result_encoding().cast<RankedTensorType>();
@@ -343,7 +462,9 @@ struct EncodeTensorSplatOp
     // Dense:
 
     // Canonicalize the fill pattern into one of [i8, i16, i32, i64].
-    auto pattern = canonicalizeFillPattern(op.value(), rewriter);
+    auto pattern = isPackedI4Type(resultType, packI4)
+                       ? packI4FillPattern(op.value(), rewriter)
+                       : canonicalizeFillPattern(op.value(), rewriter);
     if (!pattern) {
       return rewriter.notifyMatchFailure(
           op, "unsupported pattern width; encoding policy required");
@@ -396,8 +517,8 @@ struct EncodeTensorCloneOp
 //===----------------------------------------------------------------------===//
 
 struct EncodeTensorSliceOp
-    : public OpRewritePattern<IREE::Stream::TensorSliceOp> {
-  using OpRewritePattern::OpRewritePattern;
+    : public EncodingPattern<IREE::Stream::TensorSliceOp> {
+  using EncodingPattern::EncodingPattern;
   LogicalResult matchAndRewrite(IREE::Stream::TensorSliceOp op,
                                 PatternRewriter &rewriter) const override {
     auto sourceType = op.source_encoding().cast<RankedTensorType>();
@@ -411,9 +532,16 @@ struct EncodeTensorSliceOp
       return failure();
     }
 
+    if (isPackedI4Type(sourceType, packI4) !=
+        isPackedI4Type(resultType, packI4)) {
+      return rewriter.notifyMatchFailure(
+          op, "slices of packed i4 tensors must be packed");
+    }
+
     // Dense:
-    auto sourceOffset = calculateElementByteOffset(
-        op.getLoc(), sourceType, sourceDims, op.start_indices(), rewriter);
+    auto sourceOffset =
+        calculateElementByteOffset(op.getLoc(), sourceType, sourceDims,
+                                   op.start_indices(), packI4, rewriter);
     auto sourceEnd = rewriter.createOrFold<arith::AddIOp>(
         op.getLoc(), sourceOffset, op.result_size());
     rewriter.replaceOpWithNewOp<IREE::Stream::AsyncSliceOp>(
@@ -429,8 +557,8 @@ struct EncodeTensorSliceOp
 //===----------------------------------------------------------------------===//
 
 struct EncodeTensorFillOp
-    : public OpRewritePattern<IREE::Stream::TensorFillOp> {
-  using OpRewritePattern::OpRewritePattern;
+    : public EncodingPattern<IREE::Stream::TensorFillOp> {
+  using EncodingPattern::EncodingPattern;
   LogicalResult matchAndRewrite(IREE::Stream::TensorFillOp op,
                                 PatternRewriter &rewriter) const override {
     auto targetType = op.target_encoding().cast<RankedTensorType>();
@@ -440,15 +568,18 @@ struct EncodeTensorFillOp
     }
 
     // Dense:
-    auto targetOffset = calculateElementByteOffset(
-        op.getLoc(), targetType, targetDims, op.start_indices(), rewriter);
+    auto targetOffset =
+        calculateElementByteOffset(op.getLoc(), targetType, targetDims,
+                                   op.start_indices(), packI4, rewriter);
     auto targetLength = calculateElementByteOffset(
-        op.getLoc(), targetType, targetDims, op.lengths(), rewriter);
+        op.getLoc(), targetType, targetDims, op.lengths(), packI4, rewriter);
     auto targetEnd = rewriter.createOrFold<arith::AddIOp>(
         op.getLoc(), targetOffset, targetLength);
 
     // Canonicalize the fill pattern into one of [i8, i16, i32, i64].
-    auto pattern = canonicalizeFillPattern(op.value(), rewriter);
+    auto pattern = isPackedI4Type(targetType, packI4)
+                       ? packI4FillPattern(op.value(), rewriter)
+                       : canonicalizeFillPattern(op.value(), rewriter);
     if (!pattern) {
       return rewriter.notifyMatchFailure(
           op, "unsupported pattern width; encoding policy required");
@@ -471,8 +602,8 @@ struct EncodeTensorFillOp
 //===----------------------------------------------------------------------===//
 
 struct EncodeTensorUpdateOp
-    : public OpRewritePattern<IREE::Stream::TensorUpdateOp> {
-  using OpRewritePattern::OpRewritePattern;
+    : public EncodingPattern<IREE::Stream::TensorUpdateOp> {
+  using EncodingPattern::EncodingPattern;
   LogicalResult matchAndRewrite(IREE::Stream::TensorUpdateOp op,
                                 PatternRewriter &rewriter) const override {
     auto updateType = op.update_encoding().cast<RankedTensorType>();
@@ -486,9 +617,16 @@ struct EncodeTensorUpdateOp
       return failure();
     }
 
+    if (isPackedI4Type(updateType, packI4) !=
+        isPackedI4Type(targetType, packI4)) {
+      return rewriter.notifyMatchFailure(
+          op, "updates of packed i4 tensors must be packed");
+    }
+
     // Dense:
-    auto targetOffset = calculateElementByteOffset(
-        op.getLoc(), targetType, targetDims, op.start_indices(), rewriter);
+    auto targetOffset =
+        calculateElementByteOffset(op.getLoc(), targetType, targetDims,
+                                   op.start_indices(), packI4, rewriter);
     auto targetEnd = rewriter.createOrFold<arith::AddIOp>(
         op.getLoc(), targetOffset, op.update_size());
     rewriter.replaceOpWithNewOp<IREE::Stream::AsyncUpdateOp>(
@@ -504,8 +642,8 @@ struct EncodeTensorUpdateOp
 //===----------------------------------------------------------------------===//
 
 struct EncodeTensorLoadOp
-    : public OpRewritePattern<IREE::Stream::TensorLoadOp> {
-  using OpRewritePattern::OpRewritePattern;
+    : public EncodingPattern<IREE::Stream::TensorLoadOp> {
+  using EncodingPattern::EncodingPattern;
   LogicalResult matchAndRewrite(IREE::Stream::TensorLoadOp op,
                                 PatternRewriter &rewriter) const override {
     auto sourceType = op.source_encoding().cast<RankedTensorType>();
@@ -514,9 +652,27 @@ struct EncodeTensorLoadOp
       return failure();
     }
 
+    // Packed i4: load the containing byte and shift the element out of it.
+    if (isPackedI4Type(sourceType, packI4)) {
+      auto loc = op.getLoc();
+      auto elementOffset = calculateElementOffset(loc, sourceType, sourceDims,
+                                                  op.indices(), rewriter);
+      auto byteOffset = calculateElementByteOffset(
+          loc, sourceType, sourceDims, op.indices(), packI4, rewriter);
+      Value byteValue = rewriter.create<IREE::Stream::AsyncLoadOp>(
+          loc, rewriter.getI8Type(), op.source(), op.source_size(),
+          byteOffset);
+      byteValue = rewriter.createOrFold<arith::ShRUIOp>(
+          loc, byteValue, calculatePackedI4Shift(loc, elementOffset, rewriter));
+      rewriter.replaceOpWithNewOp<arith::TruncIOp>(op, op.result().getType(),
+                                                   byteValue);
+      return success();
+    }
+
     // Dense:
-    auto sourceOffset = calculateElementByteOffset(
-        op.getLoc(), sourceType, sourceDims, op.indices(), rewriter);
+    auto sourceOffset =
+        calculateElementByteOffset(op.getLoc(), sourceType, sourceDims,
+                                   op.indices(), packI4, rewriter);
     rewriter.replaceOpWithNewOp<IREE::Stream::AsyncLoadOp>(
         op, op.result().getType(), op.source(), op.source_size(), sourceOffset);
 
@@ -529,8 +685,8 @@ struct EncodeTensorLoadOp
 //===----------------------------------------------------------------------===//
 
 struct EncodeTensorStoreOp
-    : public OpRewritePattern<IREE::Stream::TensorStoreOp> {
-  using OpRewritePattern::OpRewritePattern;
+    : public EncodingPattern<IREE::Stream::TensorStoreOp> {
+  using EncodingPattern::EncodingPattern;
   LogicalResult matchAndRewrite(IREE::Stream::TensorStoreOp op,
                                 PatternRewriter &rewriter) const override {
     auto targetType = op.target_encoding().cast<RankedTensorType>();
@@ -539,9 +695,40 @@ struct EncodeTensorStoreOp
       return failure();
     }
 
+    // Packed i4: read-modify-write the byte containing the element.
+    if (isPackedI4Type(targetType, packI4)) {
+      auto loc = op.getLoc();
+      auto elementOffset = calculateElementOffset(loc, targetType, targetDims,
+                                                  op.indices(), rewriter);
+      auto byteOffset = calculateElementByteOffset(
+          loc, targetType, targetDims, op.indices(), packI4, rewriter);
+      auto shift = calculatePackedI4Shift(loc, elementOffset, rewriter);
+      Value byteValue = rewriter.create<IREE::Stream::AsyncLoadOp>(
+          loc, rewriter.getI8Type(), op.target(), op.target_size(),
+          byteOffset);
+      auto keepMask = rewriter.createOrFold<arith::XOrIOp>(
+          loc,
+          rewriter.createOrFold<arith::ShLIOp>(
+              loc, rewriter.create<arith::ConstantIntOp>(loc, 0xF, 8), shift),
+          rewriter.create<arith::ConstantIntOp>(loc, -1, 8));
+      byteValue =
+          rewriter.createOrFold<arith::AndIOp>(loc, byteValue, keepMask);
+      auto elementValue = rewriter.createOrFold<arith::ShLIOp>(
+          loc,
+          rewriter.createOrFold<arith::ExtUIOp>(loc, rewriter.getI8Type(),
+                                                op.value()),
+          shift);
+      byteValue =
+          rewriter.createOrFold<arith::OrIOp>(loc, byteValue, elementValue);
+      rewriter.replaceOpWithNewOp<IREE::Stream::AsyncStoreOp>(
+          op, op.target(), op.target_size(), byteOffset, byteValue);
+      return success();
+    }
+
     // Dense:
-    auto targetOffset = calculateElementByteOffset(
-        op.getLoc(), targetType, targetDims, op.indices(), rewriter);
+    auto targetOffset =
+        calculateElementByteOffset(op.getLoc(), targetType, targetDims,
+                                   op.indices(), packI4, rewriter);
     rewriter.replaceOpWithNewOp<IREE::Stream::AsyncStoreOp>(
         op, op.target(), op.target_size(), targetOffset, op.value());
 
@@ -556,6 +743,9 @@ struct EncodeTensorStoreOp
 class EncodeHostTensorsPass
     : public EncodeHostTensorsBase<EncodeHostTensorsPass> {
  public:
+  EncodeHostTensorsPass() = default;
+  EncodeHostTensorsPass(bool packI4) { this->packI4 = packI4; }
+
   void getDependentDialects(DialectRegistry &registry) const override {
     registry.insert<mlir::StandardOpsDialect>();
     registry.insert<mlir::arith::ArithmeticDialect>();
@@ -565,11 +755,13 @@ class EncodeHostTensorsPass
 
   void runOnOperation() override {
     RewritePatternSet patterns(&getContext());
-    patterns.insert<
-        EncodeTensorImportOp, EncodeTensorExportOp, EncodeTensorSizeOfOp,
-        EncodeTensorConstantOp, EncodeTensorSplatOp, EncodeTensorCloneOp,
-        EncodeTensorSliceOp, EncodeTensorFillOp, EncodeTensorUpdateOp,
-        EncodeTensorLoadOp, EncodeTensorStoreOp>(&getContext());
+    patterns.insert<EncodeTensorImportOp, EncodeTensorExportOp,
+                    EncodeTensorCloneOp>(&getContext());
+    patterns.insert<EncodeTensorSizeOfOp, EncodeTensorConstantOp,
+                    EncodeTensorSplatOp, EncodeTensorSliceOp,
+                    EncodeTensorFillOp, EncodeTensorUpdateOp,
+                    EncodeTensorLoadOp, EncodeTensorStoreOp>(&getContext(),
+                                                             packI4);
     FrozenRewritePatternSet frozenPatterns(std::move(patterns));
     if (failed(applyPatternsAndFoldGreedily(getOperation(), frozenPatterns))) {
       return signalPassFailure();
@@ -684,6 +876,224 @@ struct EncodeDispatchTensorStoreOp
   }
 };
 
+//===----------------------------------------------------------------------===//
+// Packed i4 bindings
+//===----------------------------------------------------------------------===//
+
+// Halves the innermost offset and size of an access to a packed i4 binding.
+// Fails if the access is strided along the innermost dimension or does not
+// start and end on byte boundaries.
+static LogicalResult getPackedI4Access(
+    OffsetSizeAndStrideOpInterface op, unsigned rank, Builder &builder,
+    SmallVectorImpl<OpFoldResult> &offsets,
+    SmallVectorImpl<OpFoldResult> &sizes,
+    SmallVectorImpl<OpFoldResult> &strides) {
+  offsets = op.getMixedOffsets();
+  sizes = op.getMixedSizes();
+  strides = op.getMixedStrides();
+  if (offsets.size() != rank || sizes.size() != rank) return failure();
+  auto offset = getConstantIntValue(offsets.back());
+  auto size = getConstantIntValue(sizes.back());
+  auto stride = getConstantIntValue(strides.back());
+  if (!offset || !size || !stride || *stride != 1 || *offset % 2 != 0 ||
+      *size % 2 != 0) {
+    return failure();
+  }
+  offsets.back() = builder.getIndexAttr(*offset / 2);
+  sizes.back() = builder.getIndexAttr(*size / 2);
+  return success();
+}
+
+// Returns the dynamic dimensions of |value| as tensor.dim ops.
+static SmallVector<Value> getDynamicDims(Location loc, Value value,
+                                         OpBuilder &builder) {
+  auto valueType = value.getType().cast<RankedTensorType>();
+  SmallVector<Value> dynamicDims;
+  for (unsigned i = 0; i < valueType.getRank(); ++i) {
+    if (valueType.isDynamicDim(i)) {
+      dynamicDims.push_back(builder.createOrFold<tensor::DimOp>(loc, value, i));
+    }
+  }
+  return dynamicDims;
+}
+
+// Returns the reassociation splitting the innermost dimension of a |rank|
+// tensor into [rank - 1, rank].
+static SmallVector<ReassociationIndices> getPackedI4Reassociation(
+    unsigned rank) {
+  SmallVector<ReassociationIndices> reassociation;
+  for (unsigned i = 0; i < rank - 1; ++i) reassociation.push_back({i});
+  reassociation.push_back({rank - 1, rank});
+  return reassociation;
+}
+
+// Unpacks |packed| i8 storage of shape [..., M] into i4 elements of shape
+// [..., 2 * M] cast to |resultType|. The unpacking is an elementwise
+// linalg.generic broadcasting each byte to its two nibbles so that it can be
+// fused with and vectorized along its consumers.
+static Value unpackI4Tensor(Location loc, Value packed,
+                            RankedTensorType resultType, OpBuilder &builder) {
+  auto packedType = packed.getType().cast<RankedTensorType>();
+  unsigned rank = packedType.getRank();
+  auto elementType = resultType.getElementType();
+
+  SmallVector<int64_t> expandedShape(packedType.getShape().begin(),
+                                     packedType.getShape().end());
+  expandedShape.push_back(2);
+  Value init = builder.create<linalg::InitTensorOp>(
+      loc, getDynamicDims(loc, packed, builder), expandedShape, elementType);
+  SmallVector<AffineExpr> packedExprs;
+  for (unsigned i = 0; i < rank; ++i) {
+    packedExprs.push_back(builder.getAffineDimExpr(i));
+  }
+  auto unpackOp = builder.create<linalg::GenericOp>(
+      loc, TypeRange{init.getType()}, ValueRange{packed}, ValueRange{init},
+      ArrayRef<AffineMap>{
+          AffineMap::get(rank + 1, 0, packedExprs, builder.getContext()),
+          builder.getMultiDimIdentityMap(rank + 1),
+      },
+      SmallVector<StringRef>(rank + 1, getParallelIteratorTypeName()),
+      [&](OpBuilder &b, Location nestedLoc, ValueRange args) {
+        Value shift = b.create<arith::MulIOp>(
+            nestedLoc, b.create<linalg::IndexOp>(nestedLoc, rank),
+            b.create<arith::ConstantIndexOp>(nestedLoc, 4));
+        shift = b.create<arith::IndexCastOp>(nestedLoc, b.getI8Type(), shift);
+        Value value = b.create<arith::ShRUIOp>(nestedLoc, args[0], shift);
+        value = b.create<arith::TruncIOp>(nestedLoc, elementType, value);
+        b.create<linalg::YieldOp>(nestedLoc, value);
+      });
+
+  SmallVector<int64_t> unpackedShape(packedType.getShape().begin(),
+                                     packedType.getShape().end());
+  if (!ShapedType::isDynamic(unpackedShape.back())) unpackedShape.back() *= 2;
+  Value unpacked = builder.create<tensor::CollapseShapeOp>(
+      loc, RankedTensorType::get(unpackedShape, elementType),
+      unpackOp.getResult(0), getPackedI4Reassociation(rank));
+  if (unpacked.getType() != resultType) {
+    unpacked = builder.create<tensor::CastOp>(loc, resultType, unpacked);
+  }
+  return unpacked;
+}
+
+// Packs |value| i4 elements of shape [..., N] into i8 storage of shape
+// [..., N / 2]. The innermost dimension of |value| must be even.
+static Value packI4Tensor(Location loc, Value value, OpBuilder &builder) {
+  auto valueType = value.getType().cast<RankedTensorType>();
+  unsigned rank = valueType.getRank();
+  auto i8Type = builder.getI8Type();
+
+  SmallVector<int64_t> expandedShape(valueType.getShape().begin(),
+                                     valueType.getShape().end());
+  if (!ShapedType::isDynamic(expandedShape.back())) expandedShape.back() /= 2;
+  expandedShape.push_back(2);
+  Value expanded = builder.create<tensor::ExpandShapeOp>(
+      loc, RankedTensorType::get(expandedShape, valueType.getElementType()),
+      value, getPackedI4Reassociation(rank));
+
+  SmallVector<Value> dynamicDims;
+  for (unsigned i = 0; i < rank; ++i) {
+    if (ShapedType::isDynamic(expandedShape[i])) {
+      dynamicDims.push_back(
+          builder.createOrFold<tensor::DimOp>(loc, expanded, i));
+    }
+  }
+  Value init = builder.create<linalg::InitTensorOp>(
+      loc, dynamicDims, ArrayRef<int64_t>(expandedShape).drop_back(), i8Type);
+  Value zero = builder.create<arith::ConstantIntOp>(loc, 0, 8);
+  init = builder.create<linalg::FillOp>(loc, zero, init).result();
+
+  SmallVector<AffineExpr> packedExprs;
+  for (unsigned i = 0; i < rank; ++i) {
+    packedExprs.push_back(builder.getAffineDimExpr(i));
+  }
+  SmallVector<StringRef> iteratorTypes(rank, getParallelIteratorTypeName());
+  iteratorTypes.push_back(getReductionIteratorTypeName());
+  auto packOp = builder.create<linalg::GenericOp>(
+      loc, TypeRange{init.getType()}, ValueRange{expanded}, ValueRange{init},
+      ArrayRef<AffineMap>{
+          builder.getMultiDimIdentityMap(rank + 1),
+          AffineMap::get(rank + 1, 0, packedExprs, builder.getContext()),
+      },
+      iteratorTypes,
+      [&](OpBuilder &b, Location nestedLoc, ValueRange args) {
+        Value shift = b.create<arith::MulIOp>(
+            nestedLoc, b.create<linalg::IndexOp>(nestedLoc, rank),
+            b.create<arith::ConstantIndexOp>(nestedLoc, 4));
+        shift = b.create<arith::IndexCastOp>(nestedLoc, i8Type, shift);
+        Value nibble = b.create<arith::ExtUIOp>(nestedLoc, i8Type, args[0]);
+        nibble = b.create<arith::ShLIOp>(nestedLoc, nibble, shift);
+        b.create<linalg::YieldOp>(
+            nestedLoc, b.create<arith::OrIOp>(nestedLoc, args[1], nibble)
+                           .getResult());
+      });
+  return packOp.getResult(0);
+}
+
+// Rewrites a binding of packed i4 elements to its i8 storage type and updates
+// all loads and stores to unpack/pack the elements around the access.
+// Host and device must agree on the packing so any access that cannot be
+// rewritten is an error.
+static LogicalResult packI4Binding(IREE::Stream::BindingSubspanOp op) {
+  auto originalType =
+      op.result().getType().cast<IREE::Flow::DispatchTensorType>();
+  unsigned rank = originalType.getRank();
+  auto storageType = IREE::Flow::DispatchTensorType::get(
+      originalType.getAccess(),
+      getPackedI4StorageShape(originalType.getShape()),
+      IntegerType::get(op.getContext(), 8));
+
+  OpBuilder builder(op.getContext());
+  SmallVector<Operation *> users(op.result().getUsers());
+  for (auto *user : users) {
+    SmallVector<OpFoldResult> offsets, sizes, strides;
+    if (auto loadOp = dyn_cast<IREE::Flow::DispatchTensorLoadOp>(user)) {
+      auto resultType = loadOp.result().getType().cast<RankedTensorType>();
+      if (resultType.getRank() != rank ||
+          failed(getPackedI4Access(
+              cast<OffsetSizeAndStrideOpInterface>(user), rank, builder,
+              offsets, sizes, strides))) {
+        return loadOp.emitOpError()
+               << "unsupported access to packed i4 binding; loads must be "
+                  "unit-strided and byte-aligned along the innermost "
+                  "dimension";
+      }
+      builder.setInsertionPoint(loadOp);
+      auto packedType = IREE::Flow::DispatchTensorLoadOp::inferResultType(
+          storageType, sizes);
+      Value packed = builder.create<IREE::Flow::DispatchTensorLoadOp>(
+          loadOp.getLoc(), packedType, loadOp.source(), loadOp.source_dims(),
+          offsets, sizes, strides);
+      loadOp.result().replaceAllUsesWith(
+          unpackI4Tensor(loadOp.getLoc(), packed, resultType, builder));
+      loadOp.erase();
+    } else if (auto storeOp =
+                   dyn_cast<IREE::Flow::DispatchTensorStoreOp>(user)) {
+      if (storeOp.target() != op.result() ||
+          storeOp.value().getType().cast<RankedTensorType>().getRank() !=
+              rank ||
+          failed(getPackedI4Access(
+              cast<OffsetSizeAndStrideOpInterface>(user), rank, builder,
+              offsets, sizes, strides))) {
+        return storeOp.emitOpError()
+               << "unsupported access to packed i4 binding; stores must be "
+                  "unit-strided and byte-aligned along the innermost "
+                  "dimension";
+      }
+      builder.setInsertionPoint(storeOp);
+      auto packed = packI4Tensor(storeOp.getLoc(), storeOp.value(), builder);
+      builder.create<IREE::Flow::DispatchTensorStoreOp>(
+          storeOp.getLoc(), packed, storeOp.target(), storeOp.target_dims(),
+          offsets, sizes, strides);
+      storeOp.erase();
+    } else {
+      return user->emitOpError() << "unsupported use of packed i4 binding";
+    }
+  }
+
+  op.result().setType(storageType);
+  return success();
+}
+
 //===----------------------------------------------------------------------===//
 // -iree-stream-encode-device-tensors
 //===----------------------------------------------------------------------===//
@@ -691,15 +1101,38 @@ struct EncodeDispatchTensorStoreOp
 class EncodeDeviceTensorsPass
     : public EncodeDeviceTensorsBase<EncodeDeviceTensorsPass> {
  public:
+  EncodeDeviceTensorsPass() = default;
+  EncodeDeviceTensorsPass(bool packI4) { this->packI4 = packI4; }
+
   void getDependentDialects(DialectRegistry &registry) const override {
     registry.insert<mlir::StandardOpsDialect>();
     registry.insert<mlir::arith::ArithmeticDialect>();
+    registry.insert<mlir::linalg::LinalgDialect>();
+    registry.insert<mlir::tensor::TensorDialect>();
     registry.insert<IREE::Flow::FlowDialect>();
     registry.insert<IREE::Stream::StreamDialect>();
     registry.insert<IREE::Util::UtilDialect>();
   }
 
   void runOnOperation() override {
+    // Packed bindings are rewritten directly as all of their loads and stores
+    // must change together; the remaining sub-byte types are widened below.
+    if (packI4) {
+      SmallVector<IREE::Stream::BindingSubspanOp> packedOps;
+      getOperation()->walk([&](IREE::Stream::BindingSubspanOp op) {
+        auto bindingType =
+            op.result().getType().dyn_cast<IREE::Flow::DispatchTensorType>();
+        if (bindingType && isPackedI4Type(bindingType.getShape(),
+                                          bindingType.getElementType(),
+                                          packI4)) {
+          packedOps.push_back(op);
+        }
+      });
+      for (auto op : packedOps) {
+        if (failed(packI4Binding(op))) return signalPassFailure();
+      }
+    }
+
     RewritePatternSet patterns(&getContext());
     patterns.insert<EncodeBindingSubspanOp, EncodeDispatchTensorLoadOp,
                     EncodeDispatchTensorStoreOp>(&getContext());
@@ -712,12 +1145,12 @@ class EncodeDeviceTensorsPass
 
 }  // namespace
 
-std::unique_ptr<OperationPass<>> createEncodeHostTensorsPass() {
-  return std::make_unique<EncodeHostTensorsPass>();
+std::unique_ptr<OperationPass<>> createEncodeHostTensorsPass(bool packI4) {
+  return std::make_unique<EncodeHostTensorsPass>(packI4);
 }
 
-std::unique_ptr<OperationPass<>> createEncodeDeviceTensorsPass() {
-  return std::make_unique<EncodeDeviceTensorsPass>();
+std::unique_ptr<OperationPass<>> createEncodeDeviceTensorsPass(bool packI4) {
+  return std::make_unique<EncodeDeviceTensorsPass>(packI4);
 }
 
 }  // namespace Stream
@@ -7,6 +7,7 @@
 #include <memory>
 #include <utility>
 
+#include "iree/compiler/Dialect/Stream/Analysis/DispatchArguments.h"
 #include "iree/compiler/Dialect/Stream/IR/StreamOps.h"
 #include "iree/compiler/Dialect/Stream/Transforms/PassDetail.h"
 #include "iree/compiler/Dialect/Stream/Transforms/Passes.h"
@@ -155,7 +156,9 @@ static void deduplicateOperands(
 
 // Inlines constant values passed in at dispatch sites that are uniform across
 // all sites. These may be shape dimensions, resource offsets/sizes, or
-// user-provided values that folded to constants.
+// user-provided values that folded to constants. Values that are only constant
+// interprocedurally (passed in as function arguments, loaded from globals, or
+// computed with simple arithmetic from such values) are found by |analysis|.
 //
 // Example:
 //   stream.cmd.dispatch @foo(%c1, %c100 : index, index)
@@ -165,8 +168,8 @@ static void deduplicateOperands(
 //   stream.cmd.dispatch @foo(%c101 : index)
 // + inlined %c1 in the executable
 static void inlineUniformConstants(
-    mlir::FuncOp funcOp,
-    SmallVector<IREE::Stream::CmdDispatchOp> &dispatchOps) {
+    mlir::FuncOp funcOp, SmallVector<IREE::Stream::CmdDispatchOp> &dispatchOps,
+    DispatchArgumentAnalysis &analysis) {
   auto &entryBlock = funcOp.front();
   auto anyDispatchOp = dispatchOps.front();
   unsigned operandCount = anyDispatchOp.operands().size();
@@ -181,9 +184,13 @@ static void inlineUniformConstants(
       auto value = dispatchOp.operands()[idx];
       APInt intValue;
       if (!matchPattern(value, m_ConstantInt(&intValue))) {
-        // Non-constant breaks the operand uniformity.
-        uniformOperandMap.reset(idx);
-        continue;
+        auto analyzedValue = analysis.getConstantValue(value);
+        if (!analyzedValue.hasValue()) {
+          // Non-constant breaks the operand uniformity.
+          uniformOperandMap.reset(idx);
+          continue;
+        }
+        intValue = analyzedValue.getValue();
       }
       if (!operandValues[idx].hasValue()) {
         // First constant seen for this operand.
@@ -259,23 +266,21 @@ class FoldUniformOperandsPass
   }
 
   void runOnOperation() override {
-    SymbolTable symbolTable(getOperation());
-
-    // Find all dispatches and bucket by their target entry point.
-    DenseMap<Operation *, SmallVector<IREE::Stream::CmdDispatchOp>>
-        entryDispatchMap;
-    getOperation()->walk([&](IREE::Stream::CmdDispatchOp dispatchOp) {
-      auto exportOp = symbolTable.lookupNearestSymbolFrom(
-          dispatchOp, dispatchOp.entry_point());
-      entryDispatchMap[exportOp].push_back(dispatchOp);
-    });
+    // Perform argument value analysis so that we can see through function
+    // boundaries when looking for constants. This also buckets all dispatches
+    // by their target entry point.
+    DispatchArgumentAnalysis analysis(getOperation());
+    if (failed(analysis.run())) {
+      return signalPassFailure();
+    }
 
     // Optimize each dispatch op.
     for (auto executableOp :
          getOperation().body().getOps<IREE::Stream::ExecutableOp>()) {
       for (auto exportOp :
            executableOp.getOps<IREE::Stream::ExecutableExportOp>()) {
-        auto &dispatchOps = entryDispatchMap[exportOp];
+        auto dispatchOps =
+            llvm::to_vector(analysis.getDispatchSites(exportOp));
         if (dispatchOps.empty()) continue;  // no-op if no dispatches
 
         auto funcOp = exportOp.getFunctionRef();
@@ -286,7 +291,7 @@ class FoldUniformOperandsPass
         deduplicateOperands(funcOp, dispatchOps);
 
         // Inline constants that have the same value at all sites.
-        inlineUniformConstants(funcOp, dispatchOps);
+        inlineUniformConstants(funcOp, dispatchOps, analysis);
       }
     }
   }
@@ -0,0 +1,128 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <memory>
+#include <string>
+
+#include "iree/compiler/Dialect/Stream/Analysis/Partitioning.h"
+#include "iree/compiler/Dialect/Stream/IR/StreamDialect.h"
+#include "iree/compiler/Dialect/Stream/IR/StreamOps.h"
+#include "iree/compiler/Dialect/Stream/Transforms/PassDetail.h"
+#include "iree/compiler/Dialect/Stream/Transforms/Passes.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "mlir/IR/Attributes.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Support/FileUtilities.h"
+
+#define DEBUG_TYPE "iree-stream-import-dispatch-profile"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace Stream {
+namespace {
+
+// Parses a CSV dispatch profile into a map of export name to duration in
+// nanoseconds. Each line is `name,duration_ns`; if the first line is a header
+// with `name` and `mean_ns` columns (as produced by tracy-csvexport) those
+// columns are used instead. Lines that don't parse are ignored and the longest
+// duration is used if a name is listed multiple times.
+static llvm::StringMap<int64_t> parseDispatchProfile(StringRef contents) {
+  llvm::StringMap<int64_t> durations;
+  size_t nameColumn = 0;
+  size_t durationColumn = 1;
+  bool isFirstLine = true;
+  SmallVector<StringRef> lines;
+  contents.split(lines, '\n', /*MaxSplit=*/-1, /*KeepEmpty=*/false);
+  for (auto line : lines) {
+    line = line.trim();
+    if (line.empty() || line.startswith("#")) continue;
+    SmallVector<StringRef> columns;
+    line.split(columns, ',');
+    for (auto &column : columns) column = column.trim().trim('"');
+    if (isFirstLine) {
+      isFirstLine = false;
+      auto nameIt = llvm::find(columns, "name");
+      auto meanIt = llvm::find(columns, "mean_ns");
+      if (nameIt != columns.end() && meanIt != columns.end()) {
+        nameColumn = std::distance(columns.begin(), nameIt);
+        durationColumn = std::distance(columns.begin(), meanIt);
+        continue;
+      }
+    }
+    if (columns.size() <= std::max(nameColumn, durationColumn)) continue;
+    double duration = 0.0;
+    if (columns[durationColumn].getAsDouble(duration) || duration < 0.0) {
+      continue;
+    }
+    auto &entry = durations[columns[nameColumn]];
+    entry = std::max(entry, static_cast<int64_t>(duration));
+  }
+  return durations;
+}
+
+//===----------------------------------------------------------------------===//
+// -iree-stream-import-dispatch-profile
+//===----------------------------------------------------------------------===//
+
+class ImportDispatchProfilePass
+    : public ImportDispatchProfileBase<ImportDispatchProfilePass> {
+ public:
+  ImportDispatchProfilePass() = default;
+  ImportDispatchProfilePass(StringRef profileFile) {
+    this->profileFile = profileFile.str();
+  }
+
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<IREE::Stream::StreamDialect>();
+  }
+
+  void runOnOperation() override {
+    if (profileFile.empty()) return;
+    auto moduleOp = getOperation();
+
+    std::string errorMessage;
+    std::unique_ptr<llvm::MemoryBuffer> file =
+        openInputFile(profileFile, &errorMessage);
+    if (!file) {
+      moduleOp.emitError() << "failed to open dispatch profile '"
+                           << profileFile << "': " << errorMessage;
+      return signalPassFailure();
+    }
+    auto durations = parseDispatchProfile(file->getBuffer());
+    LLVM_DEBUG(llvm::dbgs() << "imported " << durations.size()
+                            << " dispatch durations from " << profileFile
+                            << "\n");
+
+    // Profiles identify dispatches by the name of the executable export as
+    // that is what the runtime reports them as.
+    Builder builder(&getContext());
+    moduleOp.walk([&](IREE::Stream::AsyncDispatchOp dispatchOp) {
+      auto it = durations.find(
+          dispatchOp.entry_point().getLeafReference().getValue());
+      if (it == durations.end()) return;
+      dispatchOp->setAttr(kDurationAttrName,
+                          builder.getI64IntegerAttr(it->second));
+    });
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<OperationPass<mlir::ModuleOp>> createImportDispatchProfilePass(
+    StringRef profileFile) {
+  return std::make_unique<ImportDispatchProfilePass>(profileFile);
+}
+
+}  // namespace Stream
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
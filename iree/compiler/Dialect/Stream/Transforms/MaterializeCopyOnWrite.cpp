@@ -34,15 +34,113 @@ namespace {
 // Copy-on-write (🐄)
 //===----------------------------------------------------------------------===//
 
+// Returns true if |use| mutates the value in-place by way of a tied result.
+static bool isTiedUse(OpOperand &use) {
+  if (auto tiedOp = dyn_cast<IREE::Util::TiedOpInterface>(use.getOwner())) {
+    return tiedOp.isOperandTied(use.getOperandNumber());
+  }
+  return false;
+}
+
+// Returns true if all uses of |value| other than |excludedUse| are
+// non-mutating uses that precede |op| in its block.
+static bool areOtherUsesBefore(Value value, OpOperand *excludedUse,
+                               Operation *op) {
+  for (auto &use : value.getUses()) {
+    if (&use == excludedUse) continue;
+    auto *user = use.getOwner();
+    if (user->getBlock() != op->getBlock() || !user->isBeforeInBlock(op) ||
+        isTiedUse(use)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns true if any of |values| is (transitively through transfers and
+// in-place operations within the same block) stored back into |globalName|.
+static bool isStoredToGlobal(ValueRange values, StringRef globalName) {
+  SmallVector<Value> worklist(values.begin(), values.end());
+  while (!worklist.empty()) {
+    auto value = worklist.pop_back_val();
+    for (auto &use : value.getUses()) {
+      auto *user = use.getOwner();
+      if (user->getBlock() != value.getParentBlock()) continue;
+      if (auto storeOp = dyn_cast<IREE::Util::GlobalStoreOp>(user)) {
+        if (storeOp.global() == globalName) return true;
+      } else if (auto transferOp =
+                     dyn_cast<IREE::Stream::AsyncTransferOp>(user)) {
+        worklist.push_back(transferOp.result());
+      } else if (auto tiedOp = dyn_cast<IREE::Util::TiedOpInterface>(user)) {
+        llvm::append_range(worklist, tiedOp.getOperandTiedResults(
+                                         use.getOperandNumber()));
+      }
+    }
+  }
+  return false;
+}
+
+// Returns true if |operand| is a resource loaded from a mutable global that
+// |tiedOp| updates in-place before the result is stored back into the same
+// global. This is the common pattern for stateful programs (such as caches in
+// decoding loops) where only a small slice of a large global is updated each
+// invocation and copying the whole resource would dominate the cost.
+//
+// Example:
+//  %0 = util.global.load @cache : !stream.resource<variable>
+//  %1 = stream.async.transfer %0 : !stream.resource<variable>{%size} ->
+//                                  !stream.resource<*>{%size}
+//  %2 = stream.async.update %slice, %1[%offset to %end] : ... -> %1
+//  %3 = stream.async.transfer %2 : !stream.resource<*>{%size} ->
+//                                  !stream.resource<variable>{%size}
+//  util.global.store %3, @cache : !stream.resource<variable>
+//
+// Any other uses of the loaded value must be reads that happen prior to the
+// update so that they observe the original contents.
+static bool isGlobalUpdateInPlace(OpOperand &operand,
+                                  IREE::Util::TiedOpInterface tiedOp) {
+  // Walk up through transfers to find the load of the global.
+  OpOperand *chainUse = &operand;
+  Value value = operand.get();
+  IREE::Util::GlobalLoadOp loadOp;
+  while (!loadOp) {
+    if (!areOtherUsesBefore(value, chainUse, tiedOp)) return false;
+    auto *definingOp = value.getDefiningOp();
+    if (!definingOp || definingOp->getBlock() != tiedOp->getBlock()) {
+      return false;
+    }
+    if (auto transferOp = dyn_cast<IREE::Stream::AsyncTransferOp>(definingOp)) {
+      chainUse = &transferOp->getOpOperand(0);
+      value = transferOp.source();
+    } else if (auto globalLoadOp =
+                   dyn_cast<IREE::Util::GlobalLoadOp>(definingOp)) {
+      loadOp = globalLoadOp;
+    } else {
+      return false;
+    }
+  }
+  if (loadOp.isGlobalImmutable()) return false;
+
+  // The updated value must be stored back into the same global. If it isn't
+  // then the global must retain its original contents and we need a copy.
+  return isStoredToGlobal(
+      tiedOp.getOperandTiedResults(operand.getOperandNumber()),
+      loadOp.global());
+}
+
 // Returns true if the given |operand| value does not need a copy on write.
 // This is a conservative check and will return false ("not safe to elide") in
 // many cases that otherwise don't need a copy. The
 // -iree-stream-elide-async-copies pass will do a whole-program analysis and
 // remove the copies we insert here when possible.
-static bool isSafeToElideCOW(Value operand, IREE::Stream::ResourceType type) {
+static bool isSafeToElideCOW(OpOperand &operand,
+                             IREE::Util::TiedOpInterface tiedOp,
+                             IREE::Stream::ResourceType type) {
+  auto value = operand.get();
+
   // Can't do anything with block args without analysis - we don't know if the
   // value they carry is the last user (move semantics).
-  if (operand.isa<BlockArgument>()) return false;
+  if (value.isa<BlockArgument>()) return false;
 
   // If our value is a constant then we need to ensure that we aren't
   // tied to a constant operand. If we are we need to clone to a
@@ -51,10 +149,14 @@ static bool isSafeToElideCOW(Value operand, IREE::Stream::ResourceType type) {
   // where no mutations will occur on the constant transfer target.
   if (type.getLifetime() == IREE::Stream::Lifetime::Constant) return false;
 
+  // Updates of mutable globals that are stored back can happen in-place on the
+  // global storage even if there are other (prior) readers.
+  if (isGlobalUpdateInPlace(operand, tiedOp)) return true;
+
   // If there's more than one user we can't make a local decision. It's
   // expensive to query relative operation order within a block and within a
   // region the lifetime of values may vary - all things we can't tell here.
-  if (!operand.hasOneUse()) return false;
+  if (!value.hasOneUse()) return false;
 
   // We are the only user and the value is contained entirely within the
   // current region. We by construction know we do not need to worry.
@@ -65,6 +167,7 @@ static bool isSafeToElideCOW(Value operand, IREE::Stream::ResourceType type) {
 // If it's determined that eliding the copy is safe it will be omitted.
 // Returns true if the copy was required and materialized.
 static bool materializeOperandCOW(Location loc, OpOperand &operand,
+                                  IREE::Util::TiedOpInterface tiedOp,
                                   IREE::Stream::AffinityAttr affinity,
                                   OpBuilder &builder) {
   // If we can safely elide the copy early we do so here to avoid adding too
@@ -73,7 +176,7 @@ static bool materializeOperandCOW(Location loc, OpOperand &operand,
   auto resourceType =
       operand.get().getType().dyn_cast<IREE::Stream::ResourceType>();
   if (!resourceType) return false;
-  if (isSafeToElideCOW(operand.get(), resourceType)) return false;
+  if (isSafeToElideCOW(operand, tiedOp, resourceType)) return false;
 
   // Materialize a clone operation just for the operand provided.
   auto sizeAwareType = resourceType.cast<IREE::Util::SizeAwareTypeInterface>();
@@ -105,7 +208,8 @@ static bool materializeTiedOpCOW(IREE::Util::TiedOpInterface tiedOp) {
     if (operandIdx == IREE::Util::TiedOpInterface::kUntiedIndex) continue;
     auto &operand = tiedOp->getOpOperand(operandIdx);
     didChange =
-        materializeOperandCOW(tiedOp.getLoc(), operand, affinity, builder) ||
+        materializeOperandCOW(tiedOp.getLoc(), operand, tiedOp, affinity,
+                              builder) ||
         didChange;
   }
 
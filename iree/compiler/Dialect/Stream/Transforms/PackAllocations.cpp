@@ -29,6 +29,98 @@ namespace IREE {
 namespace Stream {
 namespace {
 
+//===----------------------------------------------------------------------===//
+// Variable allocation merging
+//===----------------------------------------------------------------------===//
+
+// Returns true if all results of |allocOp| have variable lifetime.
+static bool isVariableAllocation(IREE::Stream::ResourceAllocOp allocOp) {
+  return llvm::all_of(allocOp.results().getTypes(), [](Type type) {
+    return type.cast<IREE::Stream::ResourceType>().getLifetime() ==
+           IREE::Stream::Lifetime::Variable;
+  });
+}
+
+// Returns true if all storage sizes of |allocOp| are available at |insertOp|.
+// Both ops must be in the same block: any size defined outside of the block
+// dominates the entire block and only sizes defined by ops within the block
+// need to be checked.
+static bool areSizesAvailableAt(IREE::Stream::ResourceAllocOp allocOp,
+                                Operation *insertOp) {
+  return llvm::all_of(allocOp.storage_sizes(), [&](Value size) {
+    auto *definingOp = size.getDefiningOp();
+    if (!definingOp || definingOp->getBlock() != insertOp->getBlock()) {
+      return true;
+    }
+    return definingOp->isBeforeInBlock(insertOp);
+  });
+}
+
+// Merges all variable allocations within |block| into as few allocations as
+// possible. Variables live until they are replaced by a later store and as
+// such all variable resources allocated together have compatible lifetimes.
+// Once merged the allocations will be packed into a single slab and after
+// subview propagation all globals stored from the slab will share the same
+// resource (and be fused into one global).
+//
+// Example:
+//  %0 = stream.resource.alloc : !stream.resource<variable>{%size_a}
+//  ...
+//  %1 = stream.resource.alloc : !stream.resource<variable>{%size_b}
+// ->
+//  %0:2 = stream.resource.alloc : !stream.resource<variable>{%size_a},
+//                                 !stream.resource<variable>{%size_b}
+static void mergeVariableAllocations(Block &block) {
+  // Allocations can only be merged if they have matching parameters and the
+  // sizes of all of them are available at the first one.
+  SmallVector<SmallVector<IREE::Stream::ResourceAllocOp>> mergeSets;
+  for (auto allocOp : block.getOps<IREE::Stream::ResourceAllocOp>()) {
+    if (!isVariableAllocation(allocOp)) continue;
+    auto mergeSet = llvm::find_if(mergeSets, [&](auto &mergeSet) {
+      auto leaderOp = mergeSet.front();
+      return leaderOp.affinityAttr() == allocOp.affinityAttr() &&
+             leaderOp.uninitializedAttr() == allocOp.uninitializedAttr() &&
+             areSizesAvailableAt(allocOp, leaderOp);
+    });
+    if (mergeSet != mergeSets.end()) {
+      mergeSet->push_back(allocOp);
+    } else {
+      mergeSets.push_back({allocOp});
+    }
+  }
+
+  for (auto &mergeSet : mergeSets) {
+    if (mergeSet.size() == 1) continue;
+    auto leaderOp = mergeSet.front();
+    SmallVector<Location> locs;
+    SmallVector<Type> resultTypes;
+    SmallVector<Value> storageSizes;
+    for (auto allocOp : mergeSet) {
+      locs.push_back(allocOp.getLoc());
+      llvm::append_range(resultTypes, allocOp.results().getTypes());
+      llvm::append_range(storageSizes, allocOp.storage_sizes());
+    }
+    OpBuilder builder(leaderOp);
+    auto newOp = builder.create<IREE::Stream::ResourceAllocOp>(
+        builder.getFusedLoc(locs), resultTypes, storageSizes,
+        leaderOp.uninitializedAttr(), leaderOp.affinityAttr());
+    LLVM_DEBUG({
+      AsmState asmState(newOp->getParentOp());
+      llvm::dbgs() << "merged " << mergeSet.size()
+                   << " variable allocations into ";
+      newOp.print(llvm::dbgs(), asmState);
+      llvm::dbgs() << "\n";
+    });
+    ValueRange newResults = newOp.results();
+    for (auto allocOp : mergeSet) {
+      size_t count = allocOp.results().size();
+      allocOp->replaceAllUsesWith(newResults.take_front(count));
+      newResults = newResults.drop_front(count);
+      allocOp.erase();
+    }
+  }
+}
+
 //===----------------------------------------------------------------------===//
 // -iree-stream-pack-allocations
 //===----------------------------------------------------------------------===//
@@ -48,6 +140,13 @@ class PackAllocationsPass : public PackAllocationsBase<PackAllocationsPass> {
       return;
     }
 
+    // Merge variable allocations performed in the same block (such as those
+    // made for the results of independent execution regions updating mutable
+    // globals) so that they get packed into a single slab below.
+    SmallVector<Block *> blocks;
+    parentOp->walk([&](Block *block) { blocks.push_back(block); });
+    for (auto *block : blocks) mergeVariableAllocations(*block);
+
     // This is pretty lazy: we just turn stream.resource.alloc ops into a
     // stream.resource.pack + stream.resource.alloc of a single resource.
     // This way we reuse all the resource constraints stuff that the pack op
@@ -73,6 +73,9 @@ struct PackedSpan {
   // any additional padding for other spans within the buffer (like start
   // offset alignment).
   uint64_t length = 0;
+  // True if the span aliases the data of a span placed earlier in the same
+  // storage resource and has no data of its own.
+  bool isAlias = false;
 };
 
 struct StorageResource {
@@ -88,14 +91,29 @@ struct StorageResource {
 };
 
 // Buckets |slices| into 1+ storage resources based on |resourceConfig|.
+// When |deduplicate| is set slices with identical values are aliased to the
+// storage of the first occurrence.
 static SmallVector<StorageResource, 8> bucketValuesIntoStorageResources(
     ArrayRef<ConstantSlice> slices,
-    IREE::Stream::ResourceConfigAttr resourceConfig) {
+    IREE::Stream::ResourceConfigAttr resourceConfig, bool deduplicate) {
   // TODO(benvanik): replace with a better strategy (best-fit, etc).
   SmallVector<StorageResource, 8> storageBuffers;
   storageBuffers.push_back({UnknownLoc::get(resourceConfig.getContext())});
   StorageResource *currentBuffer = &storageBuffers.back();
+  // Constant values are uniqued and identical values will have the same
+  // attribute. Maps to the {storage buffer index, span} they were placed at.
+  DenseMap<Attribute, std::pair<size_t, PackedSpan>> placedValues;
   for (auto slice : slices) {
+    if (deduplicate) {
+      auto it = placedValues.find(slice.value);
+      if (it != placedValues.end()) {
+        PackedSpan aliasSpan = it->second.second;
+        aliasSpan.slice = slice;
+        aliasSpan.isAlias = true;
+        storageBuffers[it->second.first].spans.push_back(aliasSpan);
+        continue;
+      }
+    }
     uint64_t offset = IREE::Util::align(
         currentBuffer->totalSize, resourceConfig.getMinBufferOffsetAlignment());
     uint64_t unpaddedLength = slice.getRawLength();
@@ -108,6 +126,10 @@ static SmallVector<StorageResource, 8> bucketValuesIntoStorageResources(
       offset = 0;
     }
     currentBuffer->spans.push_back({slice, offset, unpaddedLength});
+    if (deduplicate) {
+      placedValues[slice.value] = {storageBuffers.size() - 1,
+                                   currentBuffer->spans.back()};
+    }
     currentBuffer->totalSize =
         std::max(currentBuffer->totalSize, offset + paddedLength);
   }
@@ -145,7 +167,7 @@ static void packStorageResourceData(StorageResource &storageBuffer,
   SmallVector<Attribute> values;
   int64_t offset = 0;
   for (auto &constantSpan : storageBuffer.spans) {
-    if (constantSpan.length == 0) continue;
+    if (constantSpan.length == 0 || constantSpan.isAlias) continue;
 
     int64_t start = constantSpan.offset;
     int64_t end = start + constantSpan.length;
@@ -188,9 +210,13 @@ static void packStorageResourceData(StorageResource &storageBuffer,
 // Assume that |slices| have been ordered by prior passes and that order may
 // have some performance-sensitivity (constants are grouped by
 // locality/lifetime/etc).
+//
+// When |deduplicate| is set identical values (such as tied weights) share
+// storage. This must only be used when the results are immutable.
 static SmallVector<StorageResource, 8> computePackingMap(
     ArrayRef<ConstantSlice> slices,
-    IREE::Stream::ResourceConfigAttr resourceConfig, MLIRContext *context) {
+    IREE::Stream::ResourceConfigAttr resourceConfig, bool deduplicate,
+    MLIRContext *context) {
   // This is literally all my brain has brain for right now. The ideal here is
   // that we have a basic static (and ideally profile-guided) sorting pass
   // that keeps constant values that are accessed sorted together.
@@ -219,12 +245,13 @@ static SmallVector<StorageResource, 8> computePackingMap(
   //
   // Here it's all descriptor sets and mapped pages but same thing pretty
   // much, and passes earlier on may duplicate constants in the pool if it
-  // means they can improve locality at runtime. This pass doesn't dedupe and
-  // just sticks to packing for that reason.
+  // means they can improve locality at runtime. Exact duplicates within a
+  // single pool gain nothing from being stored twice as they are already
+  // accessed together and are aliased when |deduplicate| is set.
 
   // Build a list of resources and spans (append to current or spill to new).
   auto storageBuffers =
-      bucketValuesIntoStorageResources(slices, resourceConfig);
+      bucketValuesIntoStorageResources(slices, resourceConfig, deduplicate);
 
   // Pack each storage resource bucket into a single data blob.
   for (auto &storageBuffer : storageBuffers) {
@@ -481,9 +508,15 @@ class PackConstantsPass : public PackConstantsBase<PackConstantsPass> {
       }
 
       // Perform the packing of dense values to compute the storage resources we
-      // will need and where each value will be placed.
-      auto storageResources =
-          computePackingMap(slices, resourceConfig, constantsOp.getContext());
+      // will need and where each value will be placed. Only constants may
+      // share storage as variables are independently mutable.
+      auto anyResult = constantsOp.results().front();
+      auto resourceType =
+          anyResult.getType().cast<IREE::Stream::ResourceType>();
+      bool deduplicate =
+          resourceType.getLifetime() == IREE::Stream::Lifetime::Constant;
+      auto storageResources = computePackingMap(
+          slices, resourceConfig, deduplicate, constantsOp.getContext());
       if (storageResources.empty()) return;
 
       OpBuilder builder(constantsOp);
@@ -506,9 +539,6 @@ class PackConstantsPass : public PackConstantsBase<PackConstantsPass> {
       // If this is producing constants (vs variables) we can try to go on a
       // fast-path where we directly map the constant memory. If producing
       // variables then we always need to stage and clone.
-      auto anyResult = constantsOp.results().front();
-      auto resourceType =
-          anyResult.getType().cast<IREE::Stream::ResourceType>();
       UploadResult uploadResult;
       if (resourceType.getLifetime() == IREE::Stream::Lifetime::Constant) {
         uploadResult = buildTryMapConstantResources(
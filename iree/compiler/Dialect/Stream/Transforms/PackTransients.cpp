@@ -0,0 +1,305 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/compiler/Dialect/Stream/IR/StreamDialect.h"
+#include "iree/compiler/Dialect/Stream/IR/StreamOps.h"
+#include "iree/compiler/Dialect/Stream/IR/StreamTypes.h"
+#include "iree/compiler/Dialect/Stream/Transforms/PassDetail.h"
+#include "iree/compiler/Dialect/Stream/Transforms/Passes.h"
+#include "iree/compiler/Dialect/Util/IR/UtilDialect.h"
+#include "iree/compiler/Dialect/Util/IR/UtilOps.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/Support/Debug.h"
+#include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
+#include "mlir/Dialect/StandardOps/IR/Ops.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/Dominance.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
+#include "mlir/Pass/Pass.h"
+
+#define DEBUG_TYPE "iree-stream-pack-transients"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace Stream {
+namespace {
+
+//===----------------------------------------------------------------------===//
+// Transient lifetime analysis
+//===----------------------------------------------------------------------===//
+
+// A stream.resource.alloca/stream.resource.dealloca pair in a block and the
+// inclusive range of op ordinals in the block during which it is live.
+struct TransientSlice {
+  IREE::Stream::ResourceAllocaOp allocaOp;
+  IREE::Stream::ResourceDeallocaOp deallocaOp;
+  int64_t start = 0;
+  int64_t end = 0;
+};
+
+// Returns the slice of |allocaOp| if it is deallocated in the same block and
+// all uses are between the allocation and the deallocation.
+static llvm::Optional<TransientSlice> matchTransientSlice(
+    IREE::Stream::ResourceAllocaOp allocaOp,
+    const DenseMap<Operation *, int64_t> &opOrdinals) {
+  auto resourceType =
+      allocaOp.result().getType().cast<IREE::Stream::ResourceType>();
+  if (resourceType.getLifetime() != IREE::Stream::Lifetime::Transient) {
+    return llvm::None;
+  }
+
+  Block *block = allocaOp->getBlock();
+  TransientSlice slice;
+  slice.allocaOp = allocaOp;
+  slice.start = opOrdinals.lookup(allocaOp);
+  SmallVector<int64_t> useOrdinals;
+  for (auto &use : allocaOp.result().getUses()) {
+    auto *userOp = block->findAncestorOpInBlock(*use.getOwner());
+    if (!userOp) return llvm::None;
+    if (auto deallocaOp = dyn_cast<IREE::Stream::ResourceDeallocaOp>(userOp)) {
+      if (slice.deallocaOp) return llvm::None;
+      slice.deallocaOp = deallocaOp;
+      slice.end = opOrdinals.lookup(deallocaOp);
+    } else {
+      useOrdinals.push_back(opOrdinals.lookup(userOp));
+    }
+  }
+  if (!slice.deallocaOp) return llvm::None;
+  for (int64_t ordinal : useOrdinals) {
+    if (ordinal < slice.start || ordinal > slice.end) return llvm::None;
+  }
+  return slice;
+}
+
+// Moves the side-effect free ops producing |value| before |insertionPoint| so
+// that it can be used there. Returns false if that is not possible.
+static bool hoistValueBefore(Value value, Operation *insertionPoint,
+                             DominanceInfo &dominanceInfo) {
+  if (dominanceInfo.properlyDominates(value, insertionPoint)) return true;
+  auto *definingOp = value.getDefiningOp();
+  if (!definingOp || definingOp->getBlock() != insertionPoint->getBlock() ||
+      definingOp->getNumRegions() != 0 ||
+      !MemoryEffectOpInterface::hasNoEffect(definingOp)) {
+    return false;
+  }
+  for (auto operand : definingOp->getOperands()) {
+    if (!hoistValueBefore(operand, insertionPoint, dominanceInfo)) {
+      return false;
+    }
+  }
+  definingOp->moveBefore(insertionPoint);
+  return true;
+}
+
+//===----------------------------------------------------------------------===//
+// Arena packing
+//===----------------------------------------------------------------------===//
+
+// Returns a timepoint that is reached when all of |timepoints| are.
+static Value joinTimepoints(Location loc, ArrayRef<Value> timepoints,
+                            OpBuilder &builder) {
+  SetVector<Value> uniqueTimepoints;
+  uniqueTimepoints.insert(timepoints.begin(), timepoints.end());
+  if (uniqueTimepoints.empty()) return nullptr;
+  if (uniqueTimepoints.size() == 1) return uniqueTimepoints.front();
+  return builder.create<IREE::Stream::TimepointJoinOp>(
+      loc, builder.getType<IREE::Stream::TimepointType>(),
+      uniqueTimepoints.getArrayRef());
+}
+
+// Replaces the allocations of |slices| with subviews into a single arena whose
+// slices alias when their lifetimes do not overlap. Reusing the memory of a
+// slice requires the new user to wait for the deallocation of the old one:
+// each allocation timepoint is joined with those of all the deallocations
+// that happen before it.
+static void packSlicesIntoArena(ArrayRef<TransientSlice> slices,
+                                IREE::Stream::AffinityAttr affinityAttr) {
+  auto firstAllocaOp = slices.front().allocaOp;
+  OpBuilder builder(firstAllocaOp);
+  SmallVector<Location> locs;
+  SmallVector<int64_t> lifetimeIntervals;
+  SmallVector<Value> sliceSizes;
+  int64_t unpackedSize = 0;
+  bool unpackedSizeDynamic = false;
+  for (auto &slice : slices) {
+    locs.push_back(slice.allocaOp.getLoc());
+    lifetimeIntervals.push_back(slice.start);
+    lifetimeIntervals.push_back(slice.end);
+    sliceSizes.push_back(slice.allocaOp.storage_size());
+    APInt staticSize;
+    if (matchPattern(slice.allocaOp.storage_size(),
+                     m_ConstantInt(&staticSize))) {
+      unpackedSize += staticSize.getSExtValue();
+    } else {
+      unpackedSizeDynamic = true;
+    }
+  }
+
+  auto fusedLoc = builder.getFusedLoc(locs);
+  auto indexType = builder.getIndexType();
+  SmallVector<Type> packedOffsetTypes(slices.size(), indexType);
+  auto packOp = builder.create<IREE::Stream::ResourcePackOp>(
+      fusedLoc, indexType, packedOffsetTypes, /*offset=*/nullptr,
+      builder.getIndexArrayAttr(lifetimeIntervals), sliceSizes, affinityAttr);
+  auto transientType = builder.getType<IREE::Stream::ResourceType>(
+      IREE::Stream::Lifetime::Transient);
+  auto timepointType = builder.getType<IREE::Stream::TimepointType>();
+  auto arenaOp = builder.create<IREE::Stream::ResourceAllocaOp>(
+      fusedLoc, transientType, timepointType, packOp.total_length(),
+      /*await_timepoint=*/nullptr, affinityAttr);
+  // Track the size the allocations would have had without packing for
+  // reporting purposes (see -iree-stream-dump-statistics).
+  if (!unpackedSizeDynamic) {
+    arenaOp->setAttr("stream.unpacked_size",
+                     builder.getIndexAttr(unpackedSize));
+  }
+  auto arena = arenaOp.result();
+  auto arenaSize = arenaOp.storage_size();
+
+  // Replace each allocation with a subview of the arena available once the
+  // slices that may alias it are no longer used.
+  for (auto it : llvm::enumerate(slices)) {
+    auto &slice = it.value();
+    auto allocaOp = slice.allocaOp;
+    auto offset = packOp.packed_offsets()[it.index()];
+    OpBuilder sliceBuilder(allocaOp);
+    auto subviewOp = sliceBuilder.create<IREE::Stream::ResourceSubviewOp>(
+        allocaOp.getLoc(), arena, arenaSize, offset, allocaOp.storage_size());
+    SmallVector<Value> timepoints = {arenaOp.result_timepoint()};
+    if (allocaOp.await_timepoint()) {
+      timepoints.push_back(allocaOp.await_timepoint());
+    }
+    for (auto &otherSlice : slices) {
+      if (otherSlice.end < slice.start &&
+          otherSlice.deallocaOp.await_timepoint()) {
+        timepoints.push_back(otherSlice.deallocaOp.await_timepoint());
+      }
+    }
+    allocaOp.result().replaceAllUsesWith(subviewOp.result());
+    allocaOp.result_timepoint().replaceAllUsesWith(
+        joinTimepoints(allocaOp.getLoc(), timepoints, sliceBuilder));
+  }
+
+  // Deallocate the arena once all slices are no longer used. The original
+  // deallocations are dropped and only wait on their users.
+  auto lastDeallocaOp = slices.front().deallocaOp;
+  SmallVector<Value> deallocaTimepoints;
+  for (auto &slice : slices) {
+    if (lastDeallocaOp->isBeforeInBlock(slice.deallocaOp)) {
+      lastDeallocaOp = slice.deallocaOp;
+    }
+    if (slice.deallocaOp.await_timepoint()) {
+      deallocaTimepoints.push_back(slice.deallocaOp.await_timepoint());
+    }
+  }
+  builder.setInsertionPointAfter(lastDeallocaOp);
+  auto arenaDeallocaOp = builder.create<IREE::Stream::ResourceDeallocaOp>(
+      fusedLoc, arena, arenaSize,
+      joinTimepoints(fusedLoc, deallocaTimepoints, builder), affinityAttr);
+  for (auto &slice : slices) {
+    auto deallocaOp = slice.deallocaOp;
+    Value timepoint = deallocaOp.await_timepoint();
+    if (!timepoint) {
+      timepoint = OpBuilder(deallocaOp)
+                      .create<IREE::Stream::TimepointImmediateOp>(
+                          deallocaOp.getLoc())
+                      .getResult();
+    }
+    if (deallocaOp == lastDeallocaOp) {
+      timepoint = arenaDeallocaOp.result_timepoint();
+    }
+    deallocaOp.result_timepoint().replaceAllUsesWith(timepoint);
+    deallocaOp.erase();
+    slice.allocaOp.erase();
+  }
+}
+
+// Packs all transient slices in |block| with the same affinity into an arena.
+static void packTransientsInBlock(Block &block, DominanceInfo &dominanceInfo) {
+  DenseMap<Operation *, int64_t> opOrdinals;
+  int64_t ordinal = 0;
+  for (auto &op : block) opOrdinals[&op] = ordinal++;
+
+  llvm::MapVector<Attribute, SmallVector<TransientSlice>> affinitySlices;
+  for (auto allocaOp : block.getOps<IREE::Stream::ResourceAllocaOp>()) {
+    auto slice = matchTransientSlice(allocaOp, opOrdinals);
+    if (!slice) continue;
+    affinitySlices[allocaOp.affinityAttr()].push_back(*slice);
+  }
+
+  for (auto &it : affinitySlices) {
+    auto &candidateSlices = it.second;
+    if (candidateSlices.size() < 2) continue;
+
+    // The arena is allocated before the first slice and must have the sizes
+    // of all slices available.
+    Operation *insertionPoint = candidateSlices.front().allocaOp;
+    SmallVector<TransientSlice> slices;
+    for (auto &slice : candidateSlices) {
+      if (slice.allocaOp != insertionPoint &&
+          !hoistValueBefore(slice.allocaOp.storage_size(), insertionPoint,
+                            dominanceInfo)) {
+        LLVM_DEBUG(llvm::dbgs() << "! transient size not available at arena: "
+                                << slice.allocaOp << "\n");
+        continue;
+      }
+      slices.push_back(slice);
+    }
+    if (slices.size() < 2) continue;
+
+    packSlicesIntoArena(
+        slices, it.first.dyn_cast_or_null<IREE::Stream::AffinityAttr>());
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// -iree-stream-pack-transients
+//===----------------------------------------------------------------------===//
+
+class PackTransientsPass : public PackTransientsBase<PackTransientsPass> {
+ public:
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<mlir::StandardOpsDialect>();
+    registry.insert<mlir::arith::ArithmeticDialect>();
+    registry.insert<IREE::Stream::StreamDialect>();
+    registry.insert<IREE::Util::UtilDialect>();
+  }
+
+  void runOnOperation() override {
+    auto parentOp = dyn_cast<CallableOpInterface>(getOperation());
+    if (!parentOp || !parentOp.getCallableRegion() ||
+        parentOp.getCallableRegion()->empty()) {
+      return;
+    }
+
+    // Each stream.resource.alloca of a transient allocates the resources of
+    // one execution region (packed by -iree-stream-schedule-allocation). Here
+    // we reserve a single arena for all of those with a lifetime within the
+    // same block and alias their memory when the lifetimes don't overlap.
+    // This bounds the peak transient memory of an invocation ahead of time
+    // instead of relying on the runtime allocator to reuse memory. Lifetimes
+    // spanning blocks or calls are left to the runtime allocator.
+    DominanceInfo dominanceInfo(parentOp);
+    for (auto &block : *parentOp.getCallableRegion()) {
+      packTransientsInBlock(block, dominanceInfo);
+    }
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<OperationPass<>> createPackTransientsPass() {
+  return std::make_unique<PackTransientsPass>();
+}
+
+}  // namespace Stream
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
@@ -62,6 +62,12 @@ void buildStreamTensorPassPipeline(OpPassManager &passManager,
   // able to kick in.
   addCleanupPatterns(passManager);
 
+  // Move outlined constants out of the program if requested. This happens
+  // after cleanup so that deduplicated constants are only externalized once.
+  if (transformOptions.buildExternalizeConstantsPassPipeline) {
+    transformOptions.buildExternalizeConstantsPassPipeline(passManager);
+  }
+
   //----------------------------------------------------------------------------
   // Conversion
   //----------------------------------------------------------------------------
@@ -108,11 +114,11 @@ void buildStreamAsyncPassPipeline(OpPassManager &passManager,
   // Lower stream.tensor.* ops to stream.async.* ops based on
   // affinity/configuration assigned during placement.
   passManager.addNestedPass<IREE::Util::InitializerOp>(
-      IREE::Stream::createEncodeHostTensorsPass());
+      IREE::Stream::createEncodeHostTensorsPass(transformOptions.packI4));
   passManager.addNestedPass<mlir::FuncOp>(
-      IREE::Stream::createEncodeHostTensorsPass());
+      IREE::Stream::createEncodeHostTensorsPass(transformOptions.packI4));
   passManager.addNestedPass<IREE::Stream::ExecutableOp>(
-      IREE::Stream::createEncodeDeviceTensorsPass());
+      IREE::Stream::createEncodeDeviceTensorsPass(transformOptions.packI4));
 
   // Expand builtins to dispatches. This may introduce new executables.
   passManager.addPass(IREE::Stream::createMaterializeBuiltinsPass());
@@ -141,6 +147,13 @@ void buildStreamAsyncPassPipeline(OpPassManager &passManager,
   // Stream formation and scheduling
   //----------------------------------------------------------------------------
 
+  // Annotate dispatches with their measured durations so that scheduling can
+  // balance and order work based on real costs.
+  if (!transformOptions.dispatchProfileFile.empty()) {
+    passManager.addPass(IREE::Stream::createImportDispatchProfilePass(
+        transformOptions.dispatchProfileFile));
+  }
+
   // Combine async work into execution regions.
   passManager.addNestedPass<IREE::Util::InitializerOp>(
       IREE::Stream::createScheduleExecutionPass());
@@ -204,6 +217,29 @@ void buildStreamCmdPassPipeline(OpPassManager &passManager,
   passManager.addNestedPass<mlir::FuncOp>(
       IREE::Stream::createLayoutSlicesPass());
 
+  // Pack the transient allocations of all execution regions into a single
+  // arena per block, aliasing those with non-overlapping lifetimes, and
+  // layout the arena slices. This runs after the slices of each execution
+  // region have been laid out so that the allocation sizes are known.
+  passManager.addNestedPass<IREE::Util::InitializerOp>(
+      IREE::Stream::createPackTransientsPass());
+  passManager.addNestedPass<mlir::FuncOp>(
+      IREE::Stream::createPackTransientsPass());
+  passManager.addNestedPass<IREE::Util::InitializerOp>(
+      IREE::Stream::createLayoutSlicesPass());
+  passManager.addNestedPass<mlir::FuncOp>(
+      IREE::Stream::createLayoutSlicesPass());
+
+  // Record the peak transient size of each public function for admission
+  // control at runtime.
+  passManager.addPass(IREE::Stream::createAnnotateTransientSizesPass());
+
+  // Keep the transient arenas of functions alive across invocations so that
+  // steady-state invocations don't allocate.
+  if (transformOptions.cacheTransients) {
+    passManager.addPass(IREE::Stream::createCacheTransientsPass());
+  }
+
   // Propagate subviews throughout the program to unify resource storage access.
   // After propagation many resource SSA values can be deduped or folded by the
   // cleanup patterns.
@@ -234,6 +270,14 @@ void buildStreamOptimizationPassPipeline(
   //----------------------------------------------------------------------------
 
   if (transformOptions.optimizeBindings) {
+    // Specialize executables for the expected values of dynamic operands. The
+    // specialized values are inlined into the executables when folding uniform
+    // operands below.
+    if (!transformOptions.specializeDynamicValues.empty()) {
+      passManager.addPass(IREE::Stream::createSpecializeDynamicDispatchesPass(
+          llvm::to_vector(transformOptions.specializeDynamicValues)));
+    }
+
     passManager.addPass(IREE::Stream::createFuseDispatchBindingsPass());
 
     // Folding operands requires that CSE folds the inputs that we check for.
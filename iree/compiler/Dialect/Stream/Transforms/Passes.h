@@ -7,6 +7,8 @@
 #ifndef IREE_COMPILER_DIALECT_STREAM_TRANSFORMS_PASSES_H_
 #define IREE_COMPILER_DIALECT_STREAM_TRANSFORMS_PASSES_H_
 
+#include <functional>
+
 #include "iree/compiler/Dialect/Stream/IR/StreamOps.h"
 #include "iree/compiler/Dialect/Stream/Transforms/PassDetail.h"
 #include "llvm/ADT/StringMap.h"
@@ -35,6 +37,41 @@ struct TransformOptions : public PassPipelineOptions<TransformOptions> {
       llvm::cl::init(true),
   };
 
+  ListOption<int64_t> specializeDynamicValues{
+      *this,
+      "specialize-dynamic-values",
+      llvm::cl::desc(
+          "Values of dynamic dispatch operands (such as shape dimensions) for "
+          "which specialized executables are produced; others use the "
+          "dynamic executables."),
+      llvm::cl::ZeroOrMore,
+      llvm::cl::CommaSeparated,
+  };
+
+  Option<std::string> dispatchProfileFile{
+      *this,
+      "dispatch-profile",
+      llvm::cl::desc(
+          "Runtime profile of dispatch durations used to guide scheduling."),
+      llvm::cl::init(""),
+  };
+
+  Option<bool> packI4{
+      *this,
+      "pack-i4",
+      llvm::cl::desc("Stores i4 tensors packed two elements per byte instead "
+                     "of widening them to i8."),
+      llvm::cl::init(false),
+  };
+
+  Option<bool> cacheTransients{
+      *this,
+      "cache-transients",
+      llvm::cl::desc("Keeps transient arenas in globals and reuses them across "
+                     "invocations instead of reallocating them each call."),
+      llvm::cl::init(true),
+  };
+
   Option<DumpOutputFormat> dumpStatisticsFormat{
       *this,
       "dump-statistics-format",
@@ -55,6 +92,13 @@ struct TransformOptions : public PassPipelineOptions<TransformOptions> {
           "File path to write to; or `` for stderr or `-` for stdout."),
       llvm::cl::init(""),
   };
+
+  // Hook to populate a pass pipeline that moves outlined constants out of the
+  // program (such as into external parameter files). If nullptr, constants
+  // remain embedded in the module. This must be injected in because the
+  // runtime modules serving the constants are not part of the stream dialect.
+  std::function<void(OpPassManager &passManager)>
+      buildExternalizeConstantsPassPipeline;
 };
 
 // Adds a set of passes to the given pass manager that run the required flow
@@ -107,8 +151,10 @@ std::unique_ptr<OperationPass<mlir::ModuleOp>> createConvertToStreamPass();
 // Tensor lowering and resource management
 //===----------------------------------------------------------------------===//
 
-std::unique_ptr<OperationPass<>> createEncodeHostTensorsPass();
-std::unique_ptr<OperationPass<>> createEncodeDeviceTensorsPass();
+std::unique_ptr<OperationPass<>> createEncodeHostTensorsPass(
+    bool packI4 = false);
+std::unique_ptr<OperationPass<>> createEncodeDeviceTensorsPass(
+    bool packI4 = false);
 std::unique_ptr<OperationPass<mlir::ModuleOp>> createMaterializeBuiltinsPass();
 std::unique_ptr<OperationPass<>> createMaterializeCopyOnWritePass();
 std::unique_ptr<OperationPass<mlir::ModuleOp>> createElideAsyncCopiesPass();
@@ -118,6 +164,8 @@ std::unique_ptr<OperationPass<mlir::ModuleOp>> createRefineUsagePass();
 // Stream formation and scheduling
 //===----------------------------------------------------------------------===//
 
+std::unique_ptr<OperationPass<mlir::ModuleOp>> createImportDispatchProfilePass(
+    StringRef profileFile = "");
 std::unique_ptr<OperationPass<>> createScheduleExecutionPass();
 std::unique_ptr<OperationPass<>> createScheduleConcurrencyPass();
 
@@ -131,6 +179,10 @@ std::unique_ptr<OperationPass<>> createScheduleAllocationPass();
 
 std::unique_ptr<OperationPass<>> createPackConstantsPass();
 std::unique_ptr<OperationPass<>> createPackAllocationsPass();
+std::unique_ptr<OperationPass<>> createPackTransientsPass();
+std::unique_ptr<OperationPass<mlir::ModuleOp>>
+createAnnotateTransientSizesPass();
+std::unique_ptr<OperationPass<mlir::ModuleOp>> createCacheTransientsPass();
 std::unique_ptr<OperationPass<>> createLayoutSlicesPass();
 
 std::unique_ptr<OperationPass<mlir::ModuleOp>> createPropagateSubviewsPass();
@@ -149,6 +201,8 @@ std::unique_ptr<OperationPass<mlir::ModuleOp>> createPropagateSubviewsPass();
 std::unique_ptr<OperationPass<mlir::ModuleOp>> createFoldUniformOperandsPass();
 std::unique_ptr<OperationPass<mlir::ModuleOp>> createFuseDispatchBindingsPass();
 std::unique_ptr<OperationPass<mlir::ModuleOp>> createSpecializeDispatchesPass();
+std::unique_ptr<OperationPass<mlir::ModuleOp>>
+createSpecializeDynamicDispatchesPass(ArrayRef<int64_t> values = {});
 
 std::unique_ptr<OperationPass<mlir::ModuleOp>>
 createAnnotateDispatchArgumentsPass();
@@ -16,6 +16,7 @@
 #include "llvm/ADT/BreadthFirstIterator.h"
 #include "llvm/ADT/TypeSwitch.h"
 #include "llvm/Support/Debug.h"
+#include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
 #include "mlir/Dialect/ControlFlow/IR/ControlFlowOps.h"
 #include "mlir/Dialect/StandardOps/IR/Ops.h"
 #include "mlir/IR/Attributes.h"
@@ -124,8 +125,8 @@ static std::pair<Value, Value> consumeTimepoint(
     Location loc, Value value, BlockAndValueMapping &resourceTimepointMap,
     OpBuilder &builder) {
   // TODO(benvanik): follow ties on value to try to consume there; there are a
-  // few other ops we could look through as well (such as select, where we could
-  // join). For now we just look at immediate defining ops.
+  // few other ops we could look through as well. For now we just look at
+  // immediate defining ops and selects.
   auto timepoint = resourceTimepointMap.lookupOrNull(value);
   if (timepoint) {
     return std::make_pair(timepoint, value);
@@ -138,6 +139,34 @@ static std::pair<Value, Value> consumeTimepoint(
   } else if (auto executeOp = dyn_cast_or_null<IREE::Stream::AsyncExecuteOp>(
                  value.getDefiningOp())) {
     return std::make_pair(executeOp.result_timepoint(), value);
+  } else if (auto selectOp = dyn_cast_or_null<mlir::arith::SelectOp>(
+                 value.getDefiningOp())) {
+    // Select between the timepoints of both values so that we only wait on
+    // the one that was chosen. Both values are already available here as the
+    // select dominates the consumer.
+    //
+    // Example:
+    //  %0 = stream.timepoint.await %t0, %r0
+    //  %1 = stream.timepoint.await %t1, %r1
+    //  %2 = arith.select %cond, %0, %1
+    //  ->
+    //  %t = arith.select %cond, %t0, %t1
+    //  %r = arith.select %cond, %r0, %r1
+    auto trueOperand = consumeTimepoint(loc, selectOp.getTrueValue(),
+                                        resourceTimepointMap, builder);
+    auto falseOperand = consumeTimepoint(loc, selectOp.getFalseValue(),
+                                         resourceTimepointMap, builder);
+    auto selectedTimepoint = builder.createOrFold<mlir::arith::SelectOp>(
+        loc, selectOp.getCondition(), trueOperand.first, falseOperand.first);
+    Value selectedResource = value;
+    if (trueOperand.second != selectOp.getTrueValue() ||
+        falseOperand.second != selectOp.getFalseValue()) {
+      selectedResource = builder.createOrFold<mlir::arith::SelectOp>(
+          loc, selectOp.getCondition(), trueOperand.second,
+          falseOperand.second);
+    }
+    resourceTimepointMap.map(selectedResource, selectedTimepoint);
+    return std::make_pair(selectedTimepoint, selectedResource);
   } else {
     return std::make_pair(
         builder.create<IREE::Stream::TimepointImmediateOp>(loc).getResult(),
@@ -581,6 +610,7 @@ class PropagateTimepointsPass
 
   void getDependentDialects(DialectRegistry &registry) const override {
     registry.insert<mlir::StandardOpsDialect>();
+    registry.insert<mlir::arith::ArithmeticDialect>();
     registry.insert<mlir::cf::ControlFlowDialect>();
     registry.insert<IREE::Stream::StreamDialect>();
     registry.insert<IREE::Util::UtilDialect>();
@@ -366,6 +366,17 @@ struct AllocationScope {
     return resourceRangeMap.count(resource) != 0;
   }
 
+  // Marks |updateOp| as having had its update value placed directly into the
+  // target range such that no copy is required.
+  void markPlacedUpdate(IREE::Stream::AsyncUpdateOp updateOp) {
+    placedUpdateOps.insert(updateOp);
+  }
+
+  // Returns true if the update value of |updateOp| was placed in the target.
+  bool isPlacedUpdate(IREE::Stream::AsyncUpdateOp updateOp) const {
+    return placedUpdateOps.contains(updateOp);
+  }
+
   // Calls |callback| for |resource| and each value aliasing it.
   void forEachResourceAlias(Value resource,
                             std::function<void(Value)> callback) const {
@@ -391,6 +402,9 @@ struct AllocationScope {
 
   // Maps resource values inside the stream to a storage range.
   DenseMap<Value, ResourceRange> resourceRangeMap;
+
+  // Update ops whose update value is produced directly into the target.
+  SmallPtrSet<Operation *, 4> placedUpdateOps;
 };
 
 static LogicalResult applyResourceSubviewOp(
@@ -476,7 +490,11 @@ static LogicalResult applyAsyncFillOp(IREE::Stream::AsyncFillOp asyncOp,
 static LogicalResult applyAsyncUpdateOp(IREE::Stream::AsyncUpdateOp asyncOp,
                                         AllocationScope &scope,
                                         OpBuilder builder) {
-  // TODO(benvanik): place the allocation instead.
+  if (scope.isPlacedUpdate(asyncOp)) {
+    // The update value was produced directly into the target range.
+    asyncOp.erase();
+    return success();
+  }
   auto sourceRange = scope.lookupResourceRange(asyncOp.update());
   auto sourceOffset = sourceRange.offset;
   auto targetRange = scope.lookupResourceRange(asyncOp.result());
@@ -947,6 +965,78 @@ static ResultAllocation reserveResultAllocation(
   return ResultAllocation{sets};
 }
 
+//===----------------------------------------------------------------------===//
+// Update placement
+//===----------------------------------------------------------------------===//
+
+// Returns true if |value| is produced by an op that can write its result into
+// any storage range. The value must be an untied result with a single use.
+// Results of stream.async.concurrent waves are looked through to the op in the
+// wave producing them.
+static bool isPlaceableValue(Value value, const AllocationScope &scope) {
+  if (!value.hasOneUse() || scope.hasResourceRange(value) ||
+      scope.getValueAliases().count(value)) {
+    return false;
+  }
+  auto *definingOp = value.getDefiningOp();
+  if (!definingOp) return false;
+  if (auto concurrentOp =
+          dyn_cast<IREE::Stream::AsyncConcurrentOp>(definingOp)) {
+    auto yieldOp = cast<IREE::Stream::YieldOp>(
+        concurrentOp.body().front().getTerminator());
+    auto resultNumber = value.cast<OpResult>().getResultNumber();
+    return isPlaceableValue(yieldOp.operands()[resultNumber], scope);
+  }
+  if (auto tiedOp = dyn_cast<IREE::Util::TiedOpInterface>(definingOp)) {
+    if (tiedOp.getTiedResultOperand(value)) return false;
+  }
+  return isa<IREE::Stream::AsyncDispatchOp, IREE::Stream::AsyncSplatOp,
+             IREE::Stream::AsyncCloneOp>(definingOp);
+}
+
+// Places the update values of stream.async.update ops directly into the
+// target storage when the target range is already known, such as when the
+// target is a captured external resource. The producer of the update value
+// then writes in-place and the update is dropped instead of becoming a copy.
+// This lets results exported into caller-provided storage be written directly
+// by the dispatch producing them.
+static void placeUpdateValues(IREE::Stream::AsyncExecuteOp executeOp,
+                              AllocationScope &scope) {
+  auto &entryBlock = executeOp.body().front();
+  for (auto updateOp : entryBlock.getOps<IREE::Stream::AsyncUpdateOp>()) {
+    auto target = updateOp.target();
+    auto update = updateOp.update();
+    if (!scope.hasResourceRange(target) || !isPlaceableValue(update, scope)) {
+      continue;
+    }
+
+    // Other users of the target could observe the producer writing into it
+    // before the update. The target must also be available before the update
+    // value is produced so that the producer's writes are not clobbered.
+    if (!target.hasOneUse()) continue;
+    auto *targetOp = target.getDefiningOp();
+    if (targetOp && !targetOp->isBeforeInBlock(update.getDefiningOp())) {
+      continue;
+    }
+
+    auto targetRange = scope.lookupResourceRange(target);
+    auto targetOffset = scope.add(updateOp.getLoc(), targetRange.offset,
+                                  updateOp.target_offset());
+    LLVM_DEBUG({
+      AsmState asmState(executeOp->getParentOp());
+      llvm::dbgs() << "  + placing update value ";
+      update.printAsOperand(llvm::dbgs(), asmState);
+      llvm::dbgs() << " into target ";
+      target.printAsOperand(llvm::dbgs(), asmState);
+      llvm::dbgs() << "\n";
+    });
+    scope.mapResourceRange(
+        update, ResourceRange(targetRange.resource, targetRange.resourceSize,
+                              targetOffset, updateOp.update_size()));
+    scope.markPlacedUpdate(updateOp);
+  }
+}
+
 //===----------------------------------------------------------------------===//
 // Execution region allocation
 //===----------------------------------------------------------------------===//
@@ -1227,6 +1317,11 @@ static LogicalResult allocateExecutionRegion(
     }
   }
 
+  // Place values that are only produced to update other resources with known
+  // storage. This must happen before transients are allocated so that the
+  // placed values are not given their own storage.
+  placeUpdateValues(executeOp, scope);
+
   // Allocate local transients that are scoped entirely within the region.
   // All locals are packed into a single slab and reserved as one.
   // Note that not all regions need transients.
@@ -36,6 +36,20 @@ namespace {
 // TODO(benvanik): deduplicate this with ScheduleExecution - almost all of this
 // is identical.
 
+// Stable sorts the ops in |block| by their measured durations with the longest
+// first. The block must not yet have a terminator.
+static void sortByDescendingDuration(Block &block) {
+  SmallVector<Operation *> ops;
+  for (auto &op : block) ops.push_back(&op);
+  if (llvm::none_of(ops, [](Operation *op) { return getOpDuration(op) > 0; })) {
+    return;
+  }
+  llvm::stable_sort(ops, [](Operation *lhs, Operation *rhs) {
+    return getOpDuration(lhs) > getOpDuration(rhs);
+  });
+  for (auto *op : ops) op->moveBefore(&block, block.end());
+}
+
 // Incremental builder for a partitioned region of executable work.
 // Must be constructed in a topological order of all partitions.
 struct WavePartitionBuilder {
@@ -144,6 +158,11 @@ struct WavePartitionBuilder {
   }
 
   void finish() {
+    // Issue the longest running ops first so that they aren't left running
+    // alone at the end of the wave. Ops within a wave are independent and can
+    // be issued in any order.
+    sortByDescendingDuration(concurrentOp.body().front());
+
     // Gather results mapped into the SSA values we've cloned.
     SmallVector<Value> results;
     SmallVector<Value> resultSizes;
@@ -7,6 +7,7 @@
 #include <memory>
 #include <utility>
 
+#include "iree/compiler/Dialect/Stream/Analysis/DispatchArguments.h"
 #include "iree/compiler/Dialect/Stream/IR/StreamOps.h"
 #include "iree/compiler/Dialect/Stream/Transforms/PassDetail.h"
 #include "iree/compiler/Dialect/Stream/Transforms/Passes.h"
@@ -51,12 +52,23 @@ struct ConstantTable {
   SmallVector<ConstantSet> sets;
 };
 
+// Returns the constant value of the dispatch site |operand|, if any. Integer
+// values that are only constant interprocedurally are found by |analysis|.
+static Attribute lookupConstantOperand(Value operand,
+                                       DispatchArgumentAnalysis &analysis) {
+  Attribute constantValue;
+  if (matchPattern(operand, m_Constant(&constantValue))) return constantValue;
+  auto analyzedValue = analysis.getConstantValue(operand);
+  if (!analyzedValue.hasValue()) return {};
+  return IntegerAttr::get(operand.getType(), analyzedValue.getValue());
+}
+
 // Builds a constant table composed of unique per-dispatch constant values.
 // Each dispatch gets a row in the table that can be selected based on the
 // dispatch ordinal.
 static ConstantTable buildConstantTable(
-    mlir::FuncOp funcOp,
-    SmallVector<IREE::Stream::CmdDispatchOp> &dispatchOps) {
+    mlir::FuncOp funcOp, SmallVector<IREE::Stream::CmdDispatchOp> &dispatchOps,
+    DispatchArgumentAnalysis &analysis) {
   auto anyDispatchOp = dispatchOps.front();
   unsigned operandCount = anyDispatchOp.operands().size();
 
@@ -66,8 +78,7 @@ static ConstantTable buildConstantTable(
     for (unsigned idx = 0; idx < operandCount; ++idx) {
       if (!constantOperandMap.test(idx)) continue;
       auto value = dispatchOp.operands()[idx];
-      Attribute constantValue;
-      if (!matchPattern(value, m_Constant(&constantValue))) {
+      if (!lookupConstantOperand(value, analysis)) {
         // Non-constant breaks the operand constant uniformity.
         constantOperandMap.reset(idx);
         continue;
@@ -95,9 +106,7 @@ static ConstantTable buildConstantTable(
     SmallVector<Attribute> values;
     for (auto dispatchOp : dispatchOps) {
       auto operand = dispatchOp.operands()[idx];
-      Attribute constantValue;
-      matchPattern(operand, m_Constant(&constantValue));
-      values.push_back(constantValue);
+      values.push_back(lookupConstantOperand(operand, analysis));
       set.locs.insert(operand.getLoc());
     }
     set.values.push_back(std::make_pair(idx, values));
@@ -285,13 +294,14 @@ static void specializeDispatches(
     IREE::Stream::ExecutableOp executableOp,
     IREE::Stream::ExecutableExportOp exportOp,
     SmallVector<IREE::Stream::CmdDispatchOp> &dispatchOps,
+    DispatchArgumentAnalysis &analysis,
     MemoizedCmdConstants &memoizedConstants) {
   if (dispatchOps.empty()) return;  // no-op if no dispatches
 
   auto funcOp = exportOp.getFunctionRef();
 
   // Build a constant table for unique per-dispatch constant values.
-  auto constantTable = buildConstantTable(funcOp, dispatchOps);
+  auto constantTable = buildConstantTable(funcOp, dispatchOps, analysis);
   if (constantTable.coveredOperands.none()) return;
 
   LLVM_DEBUG({
@@ -338,16 +348,13 @@ class SpecializeDispatchesPass
   }
 
   void runOnOperation() override {
-    SymbolTable symbolTable(getOperation());
-
-    // Find all dispatches and bucket by their target entry point.
-    DenseMap<Operation *, SmallVector<IREE::Stream::CmdDispatchOp>>
-        entryDispatchMap;
-    getOperation()->walk([&](IREE::Stream::CmdDispatchOp dispatchOp) {
-      auto exportOp = symbolTable.lookupNearestSymbolFrom(
-          dispatchOp, dispatchOp.entry_point());
-      entryDispatchMap[exportOp].push_back(dispatchOp);
-    });
+    // Perform argument value analysis so that we can see through function
+    // boundaries when looking for constants. This also buckets all dispatches
+    // by their target entry point.
+    DispatchArgumentAnalysis analysis(getOperation());
+    if (failed(analysis.run())) {
+      return signalPassFailure();
+    }
 
     // Optimize each dispatchable function and its dispatch sites.
     MemoizedCmdConstants memoizedConstants;
@@ -355,7 +362,9 @@ class SpecializeDispatchesPass
          getOperation().body().getOps<IREE::Stream::ExecutableOp>()) {
       for (auto exportOp :
            executableOp.getOps<IREE::Stream::ExecutableExportOp>()) {
-        specializeDispatches(executableOp, exportOp, entryDispatchMap[exportOp],
+        auto dispatchOps =
+            llvm::to_vector(analysis.getDispatchSites(exportOp));
+        specializeDispatches(executableOp, exportOp, dispatchOps, analysis,
                              memoizedConstants);
       }
     }
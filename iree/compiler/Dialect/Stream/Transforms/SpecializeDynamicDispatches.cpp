@@ -0,0 +1,254 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <functional>
+#include <memory>
+#include <utility>
+
+#include "iree/compiler/Dialect/Stream/IR/StreamDialect.h"
+#include "iree/compiler/Dialect/Stream/IR/StreamOps.h"
+#include "iree/compiler/Dialect/Stream/Transforms/PassDetail.h"
+#include "iree/compiler/Dialect/Stream/Transforms/Passes.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
+#include "mlir/Dialect/SCF/SCF.h"
+#include "mlir/Dialect/StandardOps/IR/Ops.h"
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/Matchers.h"
+#include "mlir/IR/SymbolTable.h"
+#include "mlir/Pass/Pass.h"
+
+#define DEBUG_TYPE "iree-stream-specialize-dynamic-dispatches"
+
+namespace mlir {
+namespace iree_compiler {
+namespace IREE {
+namespace Stream {
+namespace {
+
+//===----------------------------------------------------------------------===//
+// Specialized executable exports
+//===----------------------------------------------------------------------===//
+
+// Clones of executable exports and their functions that are only dispatched
+// with a particular value of a dynamic operand. Keyed by the original export
+// and the specialized value.
+class SpecializedExports {
+ public:
+  explicit SpecializedExports(mlir::ModuleOp moduleOp) : moduleOp(moduleOp) {}
+
+  // Returns the entry point of a clone of the export referenced by
+  // |entryPoint|. Clones are created on first use and shared across all sites
+  // dispatching with the same |value|.
+  SymbolRefAttr getOrCreate(SymbolRefAttr entryPoint, int64_t value) {
+    auto exportOp = SymbolTable::lookupNearestSymbolFrom<
+        IREE::Stream::ExecutableExportOp>(moduleOp, entryPoint);
+    if (!exportOp) return {};
+    auto &clonedEntryPoint = clonedEntryPoints[{exportOp, value}];
+    if (clonedEntryPoint) return clonedEntryPoint;
+
+    auto executableOp = exportOp->getParentOfType<IREE::Stream::ExecutableOp>();
+    auto funcOp = exportOp.getFunctionRef();
+    if (!funcOp) return {};
+    std::string name = llvm::formatv("{0}_{1}", exportOp.sym_name(), value);
+
+    // Functions and exports are in different symbol tables and may be
+    // renamed independently when there are conflicts.
+    auto clonedFuncOp = funcOp.clone();
+    clonedFuncOp.setName(name);
+    SymbolTable(executableOp.getInnerModule()).insert(clonedFuncOp);
+    auto clonedExportOp = exportOp.clone();
+    clonedExportOp.sym_nameAttr(StringAttr::get(exportOp.getContext(), name));
+    clonedExportOp.function_refAttr(FlatSymbolRefAttr::get(clonedFuncOp));
+    SymbolTable(executableOp)
+        .insert(clonedExportOp,
+                Block::iterator(executableOp.getInnerModule().getOperation()));
+
+    clonedEntryPoint = SymbolRefAttr::get(
+        executableOp.sym_nameAttr(),
+        {FlatSymbolRefAttr::get(clonedExportOp.sym_nameAttr())});
+    return clonedEntryPoint;
+  }
+
+ private:
+  mlir::ModuleOp moduleOp;
+  DenseMap<std::pair<Operation *, int64_t>, SymbolRefAttr> clonedEntryPoints;
+};
+
+//===----------------------------------------------------------------------===//
+// Execution region specialization
+//===----------------------------------------------------------------------===//
+
+// Returns the dynamic index operand dispatched by the most dispatches within
+// |executeOp| or nullptr if there are none. Dynamic shape dimensions (such as
+// sequence lengths) are usually shared by all dispatches of a region.
+static Value findSpecializableOperand(IREE::Stream::CmdExecuteOp executeOp) {
+  llvm::MapVector<Value, unsigned> useCounts;
+  executeOp.walk([&](IREE::Stream::CmdDispatchOp dispatchOp) {
+    SetVector<Value> dynamicOperands;
+    for (auto operand : dispatchOp.operands()) {
+      if (!operand.getType().isIndex() || matchPattern(operand, m_Constant()) ||
+          executeOp.body().isAncestor(operand.getParentRegion())) {
+        continue;
+      }
+      dynamicOperands.insert(operand);
+    }
+    for (auto operand : dynamicOperands) ++useCounts[operand];
+  });
+  Value specializableOperand;
+  unsigned maxUseCount = 0;
+  for (auto &it : useCounts) {
+    if (it.second > maxUseCount) {
+      specializableOperand = it.first;
+      maxUseCount = it.second;
+    }
+  }
+  return specializableOperand;
+}
+
+// Builds a clone of |executeOp| where |operand| is known to be |value|. All
+// dispatches within the clone are to specialized exports so that the value can
+// be folded into the executables (see -iree-stream-fold-uniform-operands).
+static Value cloneSpecializedExecuteOp(IREE::Stream::CmdExecuteOp executeOp,
+                                       Value operand, int64_t value,
+                                       SpecializedExports &specializedExports,
+                                       OpBuilder &builder) {
+  BlockAndValueMapping mapping;
+  mapping.map(operand, builder.create<arith::ConstantIndexOp>(
+                           operand.getLoc(), value));
+  auto clonedOp = cast<IREE::Stream::CmdExecuteOp>(
+      builder.clone(*executeOp.getOperation(), mapping));
+  clonedOp.walk([&](IREE::Stream::CmdDispatchOp dispatchOp) {
+    if (auto entryPoint = specializedExports.getOrCreate(
+            dispatchOp.entry_point(), value)) {
+      dispatchOp.entry_pointAttr(entryPoint);
+    }
+  });
+  return clonedOp.result_timepoint();
+}
+
+// Replaces |executeOp| with a switch on its most commonly dispatched dynamic
+// operand that selects between clones specialized for each of |values| and the
+// original dynamic |executeOp|.
+//
+// Example:
+//   %t = stream.cmd.execute ... {
+//     stream.cmd.dispatch @ex::@dispatch(%dim : index) ...
+//   } => !stream.timepoint
+// ->
+//   %is_128 = arith.cmpi eq, %dim, %c128 : index
+//   %t = scf.if %is_128 -> !stream.timepoint {
+//     %t_128 = stream.cmd.execute ... {
+//       stream.cmd.dispatch @ex::@dispatch_128(%c128 : index) ...
+//     } => !stream.timepoint
+//     scf.yield %t_128
+//   } else {
+//     %t_dynamic = stream.cmd.execute ... {
+//       stream.cmd.dispatch @ex::@dispatch(%dim : index) ...
+//     } => !stream.timepoint
+//     scf.yield %t_dynamic
+//   }
+static void specializeExecuteOp(IREE::Stream::CmdExecuteOp executeOp,
+                                ArrayRef<int64_t> values,
+                                SpecializedExports &specializedExports) {
+  auto operand = findSpecializableOperand(executeOp);
+  if (!operand) return;
+
+  LLVM_DEBUG(llvm::dbgs() << "specializing execution region at "
+                          << executeOp.getLoc() << " on " << operand << "\n");
+
+  auto loc = executeOp.getLoc();
+  auto timepointType = executeOp.result_timepoint().getType();
+  OpBuilder builder(executeOp);
+  std::function<Value(OpBuilder &, ArrayRef<int64_t>)> buildSwitch =
+      [&](OpBuilder &switchBuilder, ArrayRef<int64_t> values) -> Value {
+    if (values.empty()) {
+      return cast<IREE::Stream::CmdExecuteOp>(
+                 switchBuilder.clone(*executeOp.getOperation()))
+          .result_timepoint();
+    }
+    int64_t value = values.front();
+    Value isValue = switchBuilder.create<arith::CmpIOp>(
+        loc, arith::CmpIPredicate::eq, operand,
+        switchBuilder.create<arith::ConstantIndexOp>(loc, value));
+    auto ifOp = switchBuilder.create<scf::IfOp>(
+        loc, TypeRange{timepointType}, isValue,
+        [&](OpBuilder &thenBuilder, Location loc) {
+          thenBuilder.create<scf::YieldOp>(
+              loc, cloneSpecializedExecuteOp(executeOp, operand, value,
+                                             specializedExports, thenBuilder));
+        },
+        [&](OpBuilder &elseBuilder, Location loc) {
+          elseBuilder.create<scf::YieldOp>(
+              loc, buildSwitch(elseBuilder, values.drop_front()));
+        });
+    return ifOp.getResult(0);
+  };
+  auto newTimepoint = buildSwitch(builder, values);
+  executeOp.result_timepoint().replaceAllUsesWith(newTimepoint);
+  executeOp.erase();
+}
+
+//===----------------------------------------------------------------------===//
+// -iree-stream-specialize-dynamic-dispatches
+//===----------------------------------------------------------------------===//
+
+class SpecializeDynamicDispatchesPass
+    : public SpecializeDynamicDispatchesBase<SpecializeDynamicDispatchesPass> {
+ public:
+  SpecializeDynamicDispatchesPass() = default;
+  SpecializeDynamicDispatchesPass(ArrayRef<int64_t> values) {
+    this->values = values;
+  }
+
+  void getDependentDialects(DialectRegistry &registry) const override {
+    registry.insert<mlir::arith::ArithmeticDialect>();
+    registry.insert<mlir::scf::SCFDialect>();
+    registry.insert<IREE::Stream::StreamDialect>();
+  }
+
+  void runOnOperation() override {
+    if (values.empty()) return;
+    SmallVector<int64_t> uniqueValues;
+    for (int64_t value : values) {
+      if (!llvm::is_contained(uniqueValues, value)) {
+        uniqueValues.push_back(value);
+      }
+    }
+
+    // Specialization happens on execution regions as a whole so that the
+    // switch is evaluated once on the host per submission. Each region is
+    // specialized on a single dynamic value to bound the code size.
+    SmallVector<IREE::Stream::CmdExecuteOp> executeOps;
+    for (auto callableOp : getOperation().getOps<CallableOpInterface>()) {
+      if (auto *region = callableOp.getCallableRegion()) {
+        region->walk([&](IREE::Stream::CmdExecuteOp executeOp) {
+          executeOps.push_back(executeOp);
+        });
+      }
+    }
+    SpecializedExports specializedExports(getOperation());
+    for (auto executeOp : executeOps) {
+      specializeExecuteOp(executeOp, uniqueValues, specializedExports);
+    }
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<OperationPass<mlir::ModuleOp>>
+createSpecializeDynamicDispatchesPass(ArrayRef<int64_t> values) {
+  return std::make_unique<SpecializeDynamicDispatchesPass>(values);
+}
+
+}  // namespace Stream
+}  // namespace IREE
+}  // namespace iree_compiler
+}  // namespace mlir
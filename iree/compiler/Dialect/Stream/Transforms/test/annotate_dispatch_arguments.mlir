@@ -139,3 +139,47 @@ func @annotateBindingAlignment(%arg0: index, %arg1: index) {
   } => !stream.timepoint
   return
 }
+
+// -----
+
+// Tests that alignment is propagated through function calls and integer math.
+// %arg0: aligned argument scaled by a constant.
+// %arg1: sum of aligned values takes the smaller alignment.
+// %arg2: product of an unaligned value and a constant.
+
+// CHECK-LABEL: @annotateInterproceduralAlignmentEx
+stream.executable private @annotateInterproceduralAlignmentEx {
+  stream.executable.export public @dispatch
+  builtin.module  {
+    // CHECK: func @dispatch(
+    // CHECK-SAME: %arg0: index {stream.alignment = 64 : index},
+    // CHECK-SAME: %arg1: index {stream.alignment = 16 : index},
+    // CHECK-SAME: %arg2: index {stream.alignment = 8 : index})
+    func @dispatch(%arg0: index, %arg1: index, %arg2: index) {
+      return
+    }
+  }
+}
+func private @annotateInterproceduralAlignmentCallee(%aligned: index, %unaligned: index) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c4 = arith.constant 4 : index
+  %c8 = arith.constant 8 : index
+  %c64 = arith.constant 64 : index
+  %scaled = arith.muli %aligned, %c4 : index
+  %sum = arith.addi %aligned, %c64 : index
+  %strided = arith.muli %unaligned, %c8 : index
+  %alloc = stream.resource.alloc uninitialized : !stream.resource<transient>{%c1}
+  %result_timepoint = stream.cmd.execute with(%alloc as %capture: !stream.resource<transient>{%c1}) {
+    stream.cmd.dispatch @annotateInterproceduralAlignmentEx::@dispatch[%c1, %c1, %c1](%scaled, %sum, %strided : index, index, index) {
+      rw %capture[%c0 for %c1] : !stream.resource<transient>{%c1}
+    }
+  } => !stream.timepoint
+  return
+}
+func @annotateInterproceduralAlignment(%arg0: index, %arg1: index) {
+  %c16 = arith.constant 16 : index
+  %aligned = util.align %arg0, %c16 : index
+  call @annotateInterproceduralAlignmentCallee(%aligned, %arg1) : (index, index) -> ()
+  return
+}
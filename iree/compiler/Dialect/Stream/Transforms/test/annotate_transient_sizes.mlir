@@ -0,0 +1,52 @@
+// RUN: iree-opt -split-input-file -iree-stream-annotate-transient-sizes %s | FileCheck %s
+
+// Tests that the static transient sizes of all blocks are summed into the
+// reflection attributes of public functions.
+
+// CHECK-LABEL: @staticTransients
+// CHECK-SAME: iree.reflection = {iree.abi = "{}", iree.peak_transient_size = "300"}
+func @staticTransients(%cond: i1) -> !stream.timepoint attributes {iree.reflection = {iree.abi = "{}"}} {
+  %c100 = arith.constant 100 : index
+  %c200 = arith.constant 200 : index
+  %0, %t0 = stream.resource.alloca uninitialized : !stream.resource<transient>{%c100} => !stream.timepoint
+  %d0 = stream.resource.dealloca await(%t0) => %0 : !stream.resource<transient>{%c100} => !stream.timepoint
+  %d1 = scf.if %cond -> !stream.timepoint {
+    %1, %t1 = stream.resource.alloca uninitialized : !stream.resource<transient>{%c200} => !stream.timepoint
+    %d = stream.resource.dealloca await(%t1) => %1 : !stream.resource<transient>{%c200} => !stream.timepoint
+    scf.yield %d : !stream.timepoint
+  } else {
+    scf.yield %d0 : !stream.timepoint
+  }
+  return %d1 : !stream.timepoint
+}
+
+// -----
+
+// Tests that functions with dynamically sized transients are not annotated.
+
+// CHECK-LABEL: @dynamicTransients
+// CHECK-NOT: iree.peak_transient_size
+func @dynamicTransients(%size: index) -> !stream.timepoint {
+  %0, %t0 = stream.resource.alloca uninitialized : !stream.resource<transient>{%size} => !stream.timepoint
+  %d0 = stream.resource.dealloca await(%t0) => %0 : !stream.resource<transient>{%size} => !stream.timepoint
+  return %d0 : !stream.timepoint
+}
+
+// -----
+
+// Tests that functions calling into functions that may allocate their own
+// transients are not annotated.
+
+func private @callee() {
+  return
+}
+
+// CHECK-LABEL: @callsWithTransients
+// CHECK-NOT: iree.peak_transient_size
+func @callsWithTransients() -> !stream.timepoint {
+  %c100 = arith.constant 100 : index
+  %0, %t0 = stream.resource.alloca uninitialized : !stream.resource<transient>{%c100} => !stream.timepoint
+  call @callee() : () -> ()
+  %d0 = stream.resource.dealloca await(%t0) => %0 : !stream.resource<transient>{%c100} => !stream.timepoint
+  return %d0 : !stream.timepoint
+}
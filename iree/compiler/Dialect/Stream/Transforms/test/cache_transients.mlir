@@ -0,0 +1,72 @@
+// RUN: iree-opt -split-input-file -iree-stream-cache-transients %s | FileCheck %s
+
+// Tests that the transient arena of a function is kept in globals and reused
+// across invocations once it is large enough and the previous invocation has
+// released it.
+
+//      CHECK: util.global private mutable @cacheTransients__transient_arena : !stream.resource<transient>
+// CHECK-NEXT: util.global private mutable @cacheTransients__transient_arena_size = 0 : index
+// CHECK-NEXT: util.global private mutable @cacheTransients__transient_arena_timepoint = #stream.timepoint<immediate> : !stream.timepoint
+
+// CHECK-LABEL: @cacheTransients
+// CHECK-SAME: (%[[AWAIT:.+]]: !stream.timepoint, %[[SIZE:.+]]: index, %{{.+}}: index, %{{.+}}: i32)
+func @cacheTransients(%await: !stream.timepoint, %size: index, %offset: index, %value: i32) -> !stream.timepoint {
+  // CHECK-DAG: %[[CACHED:.+]] = util.global.load @cacheTransients__transient_arena : !stream.resource<transient>
+  // CHECK-DAG: %[[CACHED_SIZE:.+]] = util.global.load @cacheTransients__transient_arena_size : index
+  // CHECK-DAG: %[[CACHED_TIMEPOINT:.+]] = util.global.load @cacheTransients__transient_arena_timepoint : !stream.timepoint
+  // CHECK-DAG: %[[C0:.+]] = arith.constant 0 : index
+  // CHECK-DAG: %[[NOT_EMPTY:.+]] = arith.cmpi ult, %[[C0]], %[[CACHED_SIZE]] : index
+  // CHECK-DAG: %[[LARGE_ENOUGH:.+]] = arith.cmpi ule, %[[SIZE]], %[[CACHED_SIZE]] : index
+  // CHECK: %[[FITS:.+]] = arith.andi %[[NOT_EMPTY]], %[[LARGE_ENOUGH]] : i1
+  // CHECK: %[[ARENA:.+]]:3 = scf.if %[[FITS]]
+  // CHECK-NEXT:   scf.yield %[[CACHED]], %[[CACHED_SIZE]], %[[CACHED_TIMEPOINT]]
+  // CHECK-NEXT: } else {
+  // CHECK-NEXT:   %[[NEW:.+]], %[[NEW_TIMEPOINT:.+]] = stream.resource.alloca uninitialized : !stream.resource<transient>{%[[SIZE]]} => !stream.timepoint
+  // CHECK-NEXT:   util.global.store %[[NEW]], @cacheTransients__transient_arena : !stream.resource<transient>
+  // CHECK-NEXT:   util.global.store %[[SIZE]], @cacheTransients__transient_arena_size : index
+  // CHECK-NEXT:   scf.yield %[[NEW]], %[[SIZE]], %[[NEW_TIMEPOINT]]
+  // CHECK-NEXT: }
+  // CHECK-NEXT: %[[READY:.+]] = stream.timepoint.join max(%[[ARENA]]#2, %[[AWAIT]]) => !stream.timepoint
+  // CHECK-NEXT: %[[SLICE:.+]] = stream.resource.subview %[[ARENA]]#0[%[[C0]]] : !stream.resource<transient>{%[[ARENA]]#1} -> !stream.resource<transient>{%[[SIZE]]}
+  %0, %t0 = stream.resource.alloca uninitialized await(%await) => !stream.resource<transient>{%size} => !stream.timepoint
+  // CHECK: %[[EXEC:.+]] = stream.cmd.execute await(%[[READY]]) => with(%[[SLICE]] as
+  %e0 = stream.cmd.execute await(%t0) => with(%0 as %arg0: !stream.resource<transient>{%size}) {
+    stream.cmd.fill %value, %arg0[%offset for %size] : i32 -> !stream.resource<transient>{%size}
+  } => !stream.timepoint
+  // CHECK-NOT: stream.resource.dealloca
+  // CHECK: util.global.store %[[EXEC]], @cacheTransients__transient_arena_timepoint : !stream.timepoint
+  %d0 = stream.resource.dealloca await(%e0) => %0 : !stream.resource<transient>{%size} => !stream.timepoint
+  // CHECK: return %[[EXEC]]
+  return %d0 : !stream.timepoint
+}
+
+// -----
+
+// Tests that transients live across calls are not cached as the callee may
+// re-enter the function and reuse the arena while it is still in use.
+
+// CHECK-NOT: util.global
+
+func private @callee()
+
+// CHECK-LABEL: @dontCacheTransientsAcrossCalls
+func @dontCacheTransientsAcrossCalls(%size: index) -> !stream.timepoint {
+  // CHECK: stream.resource.alloca
+  %0, %t0 = stream.resource.alloca uninitialized : !stream.resource<transient>{%size} => !stream.timepoint
+  call @callee() : () -> ()
+  // CHECK: stream.resource.dealloca
+  %d0 = stream.resource.dealloca await(%t0) => %0 : !stream.resource<transient>{%size} => !stream.timepoint
+  return %d0 : !stream.timepoint
+}
+
+// -----
+
+// Tests that transients escaping the block are not cached.
+
+// CHECK-LABEL: @dontCacheEscapingTransients
+func @dontCacheEscapingTransients(%size: index) -> !stream.resource<transient> {
+  // CHECK-NOT: util.global.load
+  // CHECK: stream.resource.alloca
+  %0, %t0 = stream.resource.alloca uninitialized : !stream.resource<transient>{%size} => !stream.timepoint
+  return %0 : !stream.resource<transient>
+}
@@ -6,14 +6,15 @@
 // CHECK-PRETTY:   Variables: 0, 0 B
 // CHECK-PRETTY:  D->H Syncs: 2
 // CHECK-PRETTY: Submissions: 3, using cumulative 0 B
+// CHECK-PRETTY:  Transients: 0 B (0.00 MiB) planned peak, 0 B (0.00 MiB) unplanned sum
 // CHECK-PRETTY:   DMA Fills: 0
 // CHECK-PRETTY:  DMA Copies: 2
 // CHECK-PRETTY:  Dispatches: 3
 // CHECK-PRETTY: Executables: 2, 33% reuse
 
 // CHECK-CSV: ; Aggregate Statistics
-// CHECK-CSV: "Constants","Constant Size","Variables","Variable Size","Awaits","Submissions","Transient Size","Fills","Copies","Dispatches","Executables"
-// CHECK-CSV: 1,0,0,0,2,3,0,0,2,3,2
+// CHECK-CSV: "Constants","Constant Size","Variables","Variable Size","Awaits","Submissions","Transient Size","Unpacked Transient Size","Fills","Copies","Dispatches","Executables"
+// CHECK-CSV: 1,0,0,0,2,3,0,0,0,2,3,2
 
 util.global private mutable @_constant__timepoint = #stream.timepoint<immediate>
 util.global private @_constant : !stream.resource<constant>
@@ -0,0 +1,50 @@
+// RUN: iree-opt -split-input-file -pass-pipeline='iree-stream-encode-device-tensors{pack-i4=true}' %s | FileCheck %s
+
+// CHECK-LABEL: @packed_load_i4
+stream.executable private @packed_load_i4 {
+  stream.executable.export public @dispatch
+  builtin.module {
+    func @dispatch(%arg0: !stream.binding) {
+      %c0 = arith.constant 0 : index
+      // CHECK: %[[BINDING:.+]] = stream.binding.subspan {{.+}} -> !flow.dispatch.tensor<readonly:4x4xi8>
+      %binding = stream.binding.subspan %arg0[%c0] : !stream.binding -> !flow.dispatch.tensor<readonly:4x8xi4>
+      // CHECK: %[[PACKED:.+]] = flow.dispatch.tensor.load %[[BINDING]], offsets = [0, 0], sizes = [4, 4], strides = [1, 1] : !flow.dispatch.tensor<readonly:4x4xi8> -> tensor<4x4xi8>
+      // CHECK: %[[INIT:.+]] = linalg.init_tensor [4, 4, 2] : tensor<4x4x2xi4>
+      // CHECK: %[[UNPACKED:.+]] = linalg.generic
+      // CHECK-SAME: ins(%[[PACKED]] : tensor<4x4xi8>) outs(%[[INIT]] : tensor<4x4x2xi4>)
+      // CHECK: linalg.index 2 : index
+      // CHECK: arith.shrui
+      // CHECK: arith.trunci {{.+}} : i8 to i4
+      // CHECK: %[[TILE:.+]] = tensor.collapse_shape %[[UNPACKED]] {{\[}}[0], [1, 2]] : tensor<4x4x2xi4> into tensor<4x8xi4>
+      %tile = flow.dispatch.tensor.load %binding, offsets = [0, 0], sizes = [4, 8], strides = [1, 1] : !flow.dispatch.tensor<readonly:4x8xi4> -> tensor<4x8xi4>
+      // CHECK: do_not_optimize(%[[TILE]])
+      util.do_not_optimize(%tile) : tensor<4x8xi4>
+      return
+    }
+  }
+}
+
+// -----
+
+// CHECK-LABEL: @packed_store_i4
+stream.executable private @packed_store_i4 {
+  stream.executable.export public @dispatch
+  builtin.module {
+    func @dispatch(%arg0: !stream.binding, %arg1: tensor<4x8xi4>) {
+      %c0 = arith.constant 0 : index
+      // CHECK: %[[BINDING:.+]] = stream.binding.subspan {{.+}} -> !flow.dispatch.tensor<writeonly:4x4xi8>
+      %binding = stream.binding.subspan %arg0[%c0] : !stream.binding -> !flow.dispatch.tensor<writeonly:4x8xi4>
+      // CHECK: %[[EXPANDED:.+]] = tensor.expand_shape %arg1 {{\[}}[0], [1, 2]] : tensor<4x8xi4> into tensor<4x4x2xi4>
+      // CHECK: %[[FILL:.+]] = linalg.fill
+      // CHECK: %[[PACKED:.+]] = linalg.generic
+      // CHECK-SAME: iterator_types = ["parallel", "parallel", "reduction"]
+      // CHECK-SAME: ins(%[[EXPANDED]] : tensor<4x4x2xi4>) outs(%[[FILL]] : tensor<4x4xi8>)
+      // CHECK: arith.extui {{.+}} : i4 to i8
+      // CHECK: arith.shli
+      // CHECK: arith.ori
+      // CHECK: flow.dispatch.tensor.store %[[PACKED]], %[[BINDING]], offsets = [0, 0], sizes = [4, 4], strides = [1, 1] : tensor<4x4xi8> -> !flow.dispatch.tensor<writeonly:4x4xi8>
+      flow.dispatch.tensor.store %arg1, %binding, offsets = [0, 0], sizes = [4, 8], strides = [1, 1] : tensor<4x8xi4> -> !flow.dispatch.tensor<writeonly:4x8xi4>
+      return
+    }
+  }
+}
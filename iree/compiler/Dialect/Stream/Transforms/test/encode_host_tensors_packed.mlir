@@ -0,0 +1,61 @@
+// RUN: iree-opt -split-input-file -pass-pipeline='iree-stream-encode-host-tensors{pack-i4=true}' %s | FileCheck %s
+
+// CHECK-LABEL: @packedTensorSizeOfI4
+func @packedTensorSizeOfI4(%arg0: index) -> index {
+  // CHECK: %[[STATIC_SIZE:.+]] = arith.constant 4 : index
+  // CHECK: %[[DYNAMIC_SIZE:.+]] = arith.muli %arg0, %[[STATIC_SIZE]] : index
+  %0 = stream.tensor.sizeof tensor<?x8xi4>{%arg0} : index
+  // CHECK: return %[[DYNAMIC_SIZE]]
+  return %0 : index
+}
+
+// -----
+
+// Tests that i4 tensors with an odd innermost dimension are still widened.
+
+// CHECK-LABEL: @unpackedTensorSizeOfI4
+func @unpackedTensorSizeOfI4() -> index {
+  // CHECK: %[[STATIC_SIZE:.+]] = arith.constant 6 : index
+  %0 = stream.tensor.sizeof tensor<2x3xi4> : index
+  // CHECK: return %[[STATIC_SIZE]]
+  return %0 : index
+}
+
+// -----
+
+// CHECK-LABEL: @packedTensorConstantI4
+func @packedTensorConstantI4() -> !stream.resource<constant> {
+  // CHECK: %[[STATIC_SIZE:.+]] = arith.constant 4 : index
+  // CHECK: %[[RET:.+]] = stream.async.constant : !stream.resource<constant>{%[[STATIC_SIZE]]} = dense<{{\[}}[33, 67], [101, 7]]> : tensor<2x2xi8>
+  %0 = stream.tensor.constant : tensor<2x4xi4> in !stream.resource<constant> = dense<[[1, 2, 3, 4], [5, 6, 7, 0]]> : tensor<2x4xi4>
+  // CHECK: return %[[RET]]
+  return %0 : !stream.resource<constant>
+}
+
+// -----
+
+// CHECK-LABEL: @packedTensorSplatI4
+func @packedTensorSplatI4(%arg0: i4, %arg1: index, %arg2: index) -> !stream.resource<*> {
+  // CHECK-DAG: %[[C4:.+]] = arith.constant 4 : i8
+  // CHECK-DAG: %[[LO:.+]] = arith.extui %arg0 : i4 to i8
+  // CHECK: %[[HI:.+]] = arith.shli %[[LO]], %[[C4]] : i8
+  // CHECK: %[[PATTERN:.+]] = arith.ori %[[LO]], %[[HI]] : i8
+  // CHECK: %[[RET:.+]] = stream.async.splat %[[PATTERN]] : i8 -> !stream.resource<*>{%arg2}
+  %0 = stream.tensor.splat %arg0 : i4 -> tensor<?x8xi4>{%arg1} in !stream.resource<*>{%arg2}
+  // CHECK: return %[[RET]]
+  return %0 : !stream.resource<*>
+}
+
+// -----
+
+// CHECK-LABEL: @packedTensorLoadI4
+func @packedTensorLoadI4(%arg0: !stream.resource<staging>, %arg1: index) -> i4 {
+  %c0 = arith.constant 0 : index
+  %c3 = arith.constant 3 : index
+  // CHECK: %[[BYTE:.+]] = stream.async.load %arg0[%c1] : !stream.resource<staging>{%arg1} -> i8
+  // CHECK: %[[SHIFTED:.+]] = arith.shrui %[[BYTE]], %c4_i8 : i8
+  // CHECK: %[[VALUE:.+]] = arith.trunci %[[SHIFTED]] : i8 to i4
+  %0 = stream.tensor.load %arg0[%c0, %c3] : tensor<2x4xi4> in !stream.resource<staging>{%arg1} -> i4
+  // CHECK: return %[[VALUE]]
+  return %0 : i4
+}
@@ -95,3 +95,52 @@ func @inlineConstantOperands(%a: i32) {
   } => !stream.timepoint
   return
 }
+
+// -----
+
+// Tests that operands that are only constant interprocedurally are inlined.
+//
+// In this test %b is passed to the dispatch as a function argument that is 20
+// at the only call site and %c is derived from it. %a comes from outside the
+// program and is left as-is.
+
+// CHECK-LABEL: @inlineInterproceduralConstantsEx
+stream.executable private @inlineInterproceduralConstantsEx {
+  stream.executable.export public @dispatch
+  builtin.module  {
+    // CHECK: func @dispatch(%[[BINDING:.+]]: !stream.binding, %[[A:.+]]: index)
+    func @dispatch(%binding: !stream.binding, %a: index, %b: index, %c: index) {
+      // CHECK-DAG: %[[B:.+]] = arith.constant 20 : index
+      // CHECK-DAG: %[[C:.+]] = arith.constant 80 : index
+      // CHECK: util.do_not_optimize(%[[BINDING]]) : !stream.binding
+      util.do_not_optimize(%binding) : !stream.binding
+      // CHECK-NEXT: util.do_not_optimize(%[[A]]) : index
+      util.do_not_optimize(%a) : index
+      // CHECK-NEXT: util.do_not_optimize(%[[B]]) : index
+      util.do_not_optimize(%b) : index
+      // CHECK-NEXT: util.do_not_optimize(%[[C]]) : index
+      util.do_not_optimize(%c) : index
+      return
+    }
+  }
+}
+func private @inlineInterproceduralConstantsCallee(%a: index, %b: index) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c4 = arith.constant 4 : index
+  %c = arith.muli %b, %c4 : index
+  %alloc = stream.resource.alloc uninitialized : !stream.resource<transient>{%c}
+  %result_timepoint = stream.cmd.execute with(%alloc as %capture: !stream.resource<transient>{%c}) {
+    // CHECK: stream.cmd.dispatch {{.+}}(%arg0 : index)
+    stream.cmd.dispatch @inlineInterproceduralConstantsEx::@dispatch[%c1, %c1, %c1](%a, %b, %c : index, index, index) {
+      rw %capture[%c0 for %c] : !stream.resource<transient>{%c}
+    }
+  } => !stream.timepoint
+  return
+}
+// CHECK: func @inlineInterproceduralConstants(%[[A:.+]]: index)
+func @inlineInterproceduralConstants(%a: index) {
+  %c20 = arith.constant 20 : index
+  call @inlineInterproceduralConstantsCallee(%a, %c20) : (index, index) -> ()
+  return
+}
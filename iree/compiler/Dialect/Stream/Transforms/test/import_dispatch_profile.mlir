@@ -0,0 +1,19 @@
+// RUN: printf 'name,src_file,src_line,total_ns,total_perc,counts,mean_ns\ndispatch_0,,0,3000,75,2,1500\ndispatch_1,,0,1000,25,4,250\n' > %t.csv
+// RUN: iree-opt -iree-stream-import-dispatch-profile='profile=%t.csv' %s | FileCheck %s
+
+// Tests that dispatches are annotated with the mean durations of their exports
+// from tracy-csvexport output and that dispatches not in the profile are left
+// unannotated.
+
+// CHECK-LABEL: @importDispatchProfile
+func @importDispatchProfile(%arg0: !stream.resource<*>, %arg1: index) -> (!stream.resource<*>, !stream.resource<*>, !stream.resource<*>) {
+  %c1 = arith.constant 1 : index
+  // CHECK: stream.async.dispatch @ex::@dispatch_0{{.+}} {stream.duration_ns = 1500 : i64}
+  %0 = stream.async.dispatch @ex::@dispatch_0[%c1, %c1, %c1](%arg0) : (!stream.resource<*>{%arg1}) -> !stream.resource<*>{%arg1}
+  // CHECK: stream.async.dispatch @ex::@dispatch_1{{.+}} {stream.duration_ns = 250 : i64}
+  %1 = stream.async.dispatch @ex::@dispatch_1[%c1, %c1, %c1](%0) : (!stream.resource<*>{%arg1}) -> !stream.resource<*>{%arg1}
+  // CHECK: stream.async.dispatch @ex::@dispatch_2
+  // CHECK-NOT: stream.duration_ns
+  %2 = stream.async.dispatch @ex::@dispatch_2[%c1, %c1, %c1](%1) : (!stream.resource<*>{%arg1}) -> !stream.resource<*>{%arg1}
+  return %0, %1, %2 : !stream.resource<*>, !stream.resource<*>, !stream.resource<*>
+}
@@ -125,3 +125,52 @@ func @blockArgMove(%cond: i1, %size: index) -> (!stream.resource<*>, !stream.res
 ^bb2(%bb2_0: !stream.resource<*>, %bb2_1: !stream.resource<*>):
   return %bb2_0, %bb2_1 : !stream.resource<*>, !stream.resource<*>
 }
+
+// -----
+
+// Tests that in-place updates of a mutable global that are stored back into the
+// same global do not get copies even when the loaded value has prior readers.
+
+util.global private mutable @cache : !stream.resource<variable>
+util.global private mutable @cache__size : index
+
+// CHECK-LABEL: @globalUpdateInPlace
+func @globalUpdateInPlace(%update: !stream.resource<*>, %update_size: index) -> !stream.resource<*> {
+  %c0 = arith.constant 0 : index
+  // CHECK: %[[VAR:.+]] = util.global.load @cache
+  %var = util.global.load @cache : !stream.resource<variable>
+  %size = util.global.load @cache__size : index
+  // CHECK: %[[LOAD_T:.+]] = stream.async.transfer %[[VAR]]
+  %load_t = stream.async.transfer %var : !stream.resource<variable>{%size} -> !stream.resource<*>{%size}
+  // CHECK: %[[READ:.+]] = stream.async.slice %[[LOAD_T]]
+  %read = stream.async.slice %load_t[%c0 to %update_size] : !stream.resource<*>{%size} -> !stream.resource<*>{%update_size}
+  // CHECK-NOT: stream.async.clone
+  // CHECK: %[[UPDATED:.+]] = stream.async.update %arg0, %[[LOAD_T]]
+  %updated = stream.async.update %update, %load_t[%c0 to %update_size] : !stream.resource<*>{%update_size} -> %load_t as !stream.resource<*>{%size}
+  %store_t = stream.async.transfer %updated : !stream.resource<*>{%size} -> !stream.resource<variable>{%size}
+  util.global.store %store_t, @cache : !stream.resource<variable>
+  return %read : !stream.resource<*>
+}
+
+// -----
+
+// Tests that updates of a loaded global that are not stored back into the
+// global get copies as the global must retain its original contents.
+
+util.global private mutable @cache : !stream.resource<variable>
+util.global private mutable @cache__size : index
+
+// CHECK-LABEL: @globalUpdateNotStored
+func @globalUpdateNotStored(%update: !stream.resource<*>, %update_size: index) -> (!stream.resource<*>, !stream.resource<*>) {
+  %c0 = arith.constant 0 : index
+  %var = util.global.load @cache : !stream.resource<variable>
+  %size = util.global.load @cache__size : index
+  // CHECK: %[[LOAD_T:.+]] = stream.async.transfer
+  %load_t = stream.async.transfer %var : !stream.resource<variable>{%size} -> !stream.resource<*>{%size}
+  // CHECK: %[[READ:.+]] = stream.async.slice %[[LOAD_T]]
+  %read = stream.async.slice %load_t[%c0 to %update_size] : !stream.resource<*>{%size} -> !stream.resource<*>{%update_size}
+  // CHECK: %[[CLONE:.+]] = stream.async.clone %[[LOAD_T]]
+  // CHECK: stream.async.update %arg0, %[[CLONE]]
+  %updated = stream.async.update %update, %load_t[%c0 to %update_size] : !stream.resource<*>{%update_size} -> %load_t as !stream.resource<*>{%size}
+  return %read, %updated : !stream.resource<*>, !stream.resource<*>
+}
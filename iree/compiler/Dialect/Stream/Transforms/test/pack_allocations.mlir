@@ -23,3 +23,50 @@ func @packAllocations(%size_a: index, %size_b: index) {
   util.do_not_optimize(%0#1) : !stream.resource<transient>
   return
 }
+
+// -----
+
+// Tests that variable allocations made independently within the same block
+// are merged and packed into a single slab.
+
+// CHECK-LABEL: @packVariableAllocations
+// CHECK-SAME: (%[[SIZE_A:.+]]: index, %[[SIZE_B:.+]]: index)
+func @packVariableAllocations(%size_a: index, %size_b: index) {
+  //      CHECK: %[[SLICES:.+]]:3 = stream.resource.pack slices({
+  // CHECK-NEXT:   [0, 0] = %[[SIZE_A]],
+  // CHECK-NEXT:   [0, 0] = %[[SIZE_B]]
+  // CHECK-NEXT: }) : index
+  // CHECK: %[[ALLOC:.+]] = stream.resource.alloc uninitialized : !stream.resource<variable>{%[[SLICES]]#0}
+  // CHECK-NOT: stream.resource.alloc
+  %0 = stream.resource.alloc uninitialized : !stream.resource<variable>{%size_a}
+
+  // CHECK: %[[SLICE_A:.+]] = stream.resource.subview %[[ALLOC]][%[[SLICES]]#1]
+  // CHECK-SAME: !stream.resource<variable>{%[[SLICES]]#0} -> !stream.resource<variable>{%[[SIZE_A]]}
+  // CHECK: %[[SLICE_B:.+]] = stream.resource.subview %[[ALLOC]][%[[SLICES]]#2]
+  // CHECK-SAME: !stream.resource<variable>{%[[SLICES]]#0} -> !stream.resource<variable>{%[[SIZE_B]]}
+
+  // CHECK: util.do_not_optimize(%[[SLICE_A]])
+  util.do_not_optimize(%0) : !stream.resource<variable>
+  %1 = stream.resource.alloc uninitialized : !stream.resource<variable>{%size_b}
+  // CHECK: util.do_not_optimize(%[[SLICE_B]])
+  util.do_not_optimize(%1) : !stream.resource<variable>
+  return
+}
+
+// -----
+
+// Tests that variable allocations whose sizes are not available at the first
+// allocation are not merged.
+
+// CHECK-LABEL: @packVariableAllocationsDependentSize
+func @packVariableAllocationsDependentSize(%size_a: index) {
+  // CHECK: stream.resource.alloc uninitialized : !stream.resource<variable>{%arg0}
+  %0 = stream.resource.alloc uninitialized : !stream.resource<variable>{%size_a}
+  util.do_not_optimize(%0) : !stream.resource<variable>
+  // CHECK: %[[SIZE_B:.+]] = arith.addi
+  %size_b = arith.addi %size_a, %size_a : index
+  // CHECK: stream.resource.alloc uninitialized : !stream.resource<variable>{%[[SIZE_B]]}
+  %1 = stream.resource.alloc uninitialized : !stream.resource<variable>{%size_b}
+  util.do_not_optimize(%1) : !stream.resource<variable>
+  return
+}
@@ -109,3 +109,36 @@ func @splitResourceConstants() -> (!stream.resource<constant>, !stream.resource<
   // CHECK: return %[[RES0]], %[[RES1]], %[[IF]]#2
   return %0#0, %0#1, %0#2 : !stream.resource<constant>, !stream.resource<constant>, !stream.timepoint
 }
+
+// -----
+
+// Tests that identical constant values share storage.
+
+// CHECK: #composite_of_64b = #util.composite<64xi8, [
+// CHECK-NEXT:   dense<100> : tensor<1xi32>,
+// CHECK-NEXT:   dense<0> : vector<28xi8>,
+// CHECK-NEXT:   dense<[101, 102]> : tensor<2xi32>,
+// CHECK-NEXT:   dense<0> : vector<24xi8>,
+// CHECK-NEXT: ]>
+
+// CHECK-LABEL: @deduplicateResourceConstants
+func @deduplicateResourceConstants() -> (!stream.resource<constant>, !stream.resource<constant>, !stream.resource<constant>, !stream.timepoint) {
+  %c4 = arith.constant 4 : index
+  %c8 = arith.constant 8 : index
+
+  // CHECK: util.byte_buffer.constant {alignment = 32 : i64} : !util.byte_buffer = #composite_of_64b
+  %0:4 = stream.resource.constants :
+    !stream.resource<constant>{%c4} = dense<100> : tensor<1xi32>,
+    !stream.resource<constant>{%c8} = dense<[101, 102]> : tensor<2xi32>,
+    !stream.resource<constant>{%c4} = dense<100> : tensor<1xi32>
+    => !stream.timepoint
+
+  // CHECK: %[[IF:.+]]:2 = scf.if
+
+  // CHECK: %[[RES0:.+]] = stream.resource.subview %[[IF]]#0[%c0] : !stream.resource<constant>{%c64} -> !stream.resource<constant>{%c4}
+  // CHECK: %[[RES1:.+]] = stream.resource.subview %[[IF]]#0[%c32] : !stream.resource<constant>{%c64} -> !stream.resource<constant>{%c8}
+  // CHECK: %[[RES2:.+]] = stream.resource.subview %[[IF]]#0[%c0] : !stream.resource<constant>{%c64} -> !stream.resource<constant>{%c4}
+
+  // CHECK: return %[[RES0]], %[[RES1]], %[[RES2]], %[[IF]]#1
+  return %0#0, %0#1, %0#2, %0#3 : !stream.resource<constant>, !stream.resource<constant>, !stream.resource<constant>, !stream.timepoint
+}
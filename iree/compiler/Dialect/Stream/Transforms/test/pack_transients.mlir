@@ -0,0 +1,58 @@
+// RUN: iree-opt -split-input-file -pass-pipeline='builtin.func(iree-stream-pack-transients)' %s | FileCheck %s
+
+// Tests that transients of sequential execution regions are packed into one
+// arena where the slices with non-overlapping lifetimes may alias and reuse
+// waits on the deallocation of the previous user.
+
+// CHECK-LABEL: @packTransients
+// CHECK-SAME: (%[[AWAIT:.+]]: !stream.timepoint, %{{.+}}: i32)
+func @packTransients(%await: !stream.timepoint, %value: i32) -> !stream.timepoint {
+  // CHECK-DAG: %[[C100:.+]] = arith.constant 100 : index
+  // CHECK-DAG: %[[C200:.+]] = arith.constant 200 : index
+  %c0 = arith.constant 0 : index
+  %c100 = arith.constant 100 : index
+  //      CHECK: %[[SLICES:.+]]:3 = stream.resource.pack slices({
+  // CHECK-NEXT:   [2, 4] = %[[C100]],
+  // CHECK-NEXT:   [6, 8] = %[[C200]]
+  // CHECK-NEXT: }) : index
+  // CHECK-NEXT: %[[ARENA:.+]], %[[ARENA_TIMEPOINT:.+]] = stream.resource.alloca uninitialized : {stream.unpacked_size = 300 : index} !stream.resource<transient>{%[[SLICES]]#0} => !stream.timepoint
+  // CHECK-NEXT: %[[SLICE_A:.+]] = stream.resource.subview %[[ARENA]][%[[SLICES]]#1] : !stream.resource<transient>{%[[SLICES]]#0} -> !stream.resource<transient>{%[[C100]]}
+  // CHECK-NEXT: %[[READY_A:.+]] = stream.timepoint.join max(%[[ARENA_TIMEPOINT]], %[[AWAIT]]) => !stream.timepoint
+  %0, %t0 = stream.resource.alloca uninitialized await(%await) => !stream.resource<transient>{%c100} => !stream.timepoint
+  // CHECK: %[[EXEC_A:.+]] = stream.cmd.execute await(%[[READY_A]]) => with(%[[SLICE_A]] as
+  %e0 = stream.cmd.execute await(%t0) => with(%0 as %arg0: !stream.resource<transient>{%c100}) {
+    stream.cmd.fill %value, %arg0[%c0 for %c100] : i32 -> !stream.resource<transient>{%c100}
+  } => !stream.timepoint
+  // CHECK-NOT: stream.resource.dealloca
+  %d0 = stream.resource.dealloca await(%e0) => %0 : !stream.resource<transient>{%c100} => !stream.timepoint
+  %c200 = arith.constant 200 : index
+  // CHECK: %[[SLICE_B:.+]] = stream.resource.subview %[[ARENA]][%[[SLICES]]#2] : !stream.resource<transient>{%[[SLICES]]#0} -> !stream.resource<transient>{%[[C200]]}
+  // CHECK-NEXT: %[[READY_B:.+]] = stream.timepoint.join max(%[[ARENA_TIMEPOINT]], %[[EXEC_A]]) => !stream.timepoint
+  %1, %t1 = stream.resource.alloca uninitialized await(%e0) => !stream.resource<transient>{%c200} => !stream.timepoint
+  // CHECK: %[[EXEC_B:.+]] = stream.cmd.execute await(%[[READY_B]]) => with(%[[SLICE_B]] as
+  %e1 = stream.cmd.execute await(%t1) => with(%1 as %arg0: !stream.resource<transient>{%c200}) {
+    stream.cmd.fill %value, %arg0[%c0 for %c100] : i32 -> !stream.resource<transient>{%c200}
+  } => !stream.timepoint
+  // CHECK: %[[EXEC_AB:.+]] = stream.timepoint.join max(%[[EXEC_A]], %[[EXEC_B]]) => !stream.timepoint
+  // CHECK-NEXT: %[[DEALLOCA:.+]] = stream.resource.dealloca await(%[[EXEC_AB]]) => %[[ARENA]] : !stream.resource<transient>{%[[SLICES]]#0} => !stream.timepoint
+  %d1 = stream.resource.dealloca await(%e1) => %1 : !stream.resource<transient>{%c200} => !stream.timepoint
+  // CHECK: %[[JOIN:.+]] = stream.timepoint.join max(%[[EXEC_A]], %[[DEALLOCA]])
+  %join = stream.timepoint.join max(%d0, %d1) => !stream.timepoint
+  // CHECK: return %[[JOIN]]
+  return %join : !stream.timepoint
+}
+
+// -----
+
+// Tests that transients escaping the block are not packed.
+
+// CHECK-LABEL: @dontPackEscapingTransients
+func @dontPackEscapingTransients(%size: index) -> !stream.resource<transient> {
+  // CHECK-NOT: stream.resource.pack
+  // CHECK: stream.resource.alloca
+  %0, %t0 = stream.resource.alloca uninitialized : !stream.resource<transient>{%size} => !stream.timepoint
+  %d0 = stream.resource.dealloca await(%t0) => %0 : !stream.resource<transient>{%size} => !stream.timepoint
+  // CHECK: stream.resource.alloca
+  %1, %t1 = stream.resource.alloca uninitialized : !stream.resource<transient>{%size} => !stream.timepoint
+  return %1 : !stream.resource<transient>
+}
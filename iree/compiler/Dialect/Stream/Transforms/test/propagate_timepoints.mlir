@@ -186,3 +186,26 @@ func @asyncExecuteConsume(%arg0: !stream.resource<external>, %arg1: !stream.reso
   util.do_not_optimize(%ready_results#1) : !stream.resource<transient>
   return
 }
+
+// -----
+
+// Tests that selects between resources select between their timepoints so
+// that consumers only wait on the chosen resource.
+//
+// This rotates waits on select operands to waits on the selected value.
+
+// CHECK-LABEL: @selectConsume
+// CHECK-SAME: (%[[COND:.+]]: i1,
+// CHECK-SAME:  %[[TIMEPOINT0:.+]]: !stream.timepoint, %[[UNREADY0:.+]]: !stream.resource<transient>,
+// CHECK-SAME:  %[[TIMEPOINT1:.+]]: !stream.timepoint, %[[UNREADY1:.+]]: !stream.resource<transient>)
+// CHECK-SAME: -> (!stream.timepoint, !stream.resource<transient>)
+func @selectConsume(%cond: i1, %arg0: !stream.resource<transient>, %arg1: !stream.resource<transient>) -> !stream.resource<transient> {
+  // NOTE: there will be extra stuff here from the arg insertion. The return
+  // consumes the selected resource and we expect the timepoints and unready
+  // resources to be selected directly.
+  %0 = arith.select %cond, %arg0, %arg1 : !stream.resource<transient>
+  // CHECK: %[[SELECTED_TIMEPOINT:.+]] = arith.select %[[COND]], %[[TIMEPOINT0]], %[[TIMEPOINT1]] : !stream.timepoint
+  // CHECK-NEXT: %[[SELECTED_UNREADY:.+]] = arith.select %[[COND]], %[[UNREADY0]], %[[UNREADY1]] : !stream.resource<transient>
+  // CHECK-NEXT: return %[[SELECTED_TIMEPOINT]], %[[SELECTED_UNREADY]]
+  return %0 : !stream.resource<transient>
+}
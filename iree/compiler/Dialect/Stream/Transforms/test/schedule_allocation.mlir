@@ -311,6 +311,35 @@ func @applyAsyncUpdateOp(%update: !stream.resource<external>, %operand: !stream.
 
 // -----
 
+// Tests that values produced only to update a captured resource are placed
+// directly into the target range instead of being copied.
+
+// CHECK-LABEL: @placeAsyncUpdateOp
+// CHECK-SAME: (%[[TARGET:.+]]: !stream.resource<external>,
+// CHECK-SAME:  %[[TARGET_SIZE:.+]]: index, %[[SIZE:.+]]: index)
+func @placeAsyncUpdateOp(%target: !stream.resource<external>, %target_size: index, %size: index) {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c4 = arith.constant 4 : index
+  // CHECK-NOT: stream.resource.alloc
+  // CHECK: stream.cmd.execute
+  // CHECK-SAME: with(%[[TARGET]] as %[[TARGET_CAPTURE:.+]]: !stream.resource<external>{%[[TARGET_SIZE]]})
+  %result, %result_timepoint = stream.async.execute with(%target as %captured_target: !stream.resource<external>{%target_size}) -> (%target as !stream.resource<external>{%target_size}) {
+    // CHECK-NEXT: stream.cmd.dispatch @executable::@dispatch[%c1, %c1, %c1](%c4 : index) {
+    // CHECK-NEXT:   wo %[[TARGET_CAPTURE]][%c0{{.*}} for %[[SIZE]]] : !stream.resource<external>{%[[TARGET_SIZE]]}
+    // CHECK-NEXT: }
+    // CHECK-NOT: stream.cmd.copy
+    %0 = stream.async.dispatch @executable::@dispatch[%c1, %c1, %c1](%c4) : (index) -> !stream.resource<transient>{%size}
+    %1 = stream.async.update %0, %captured_target[%c0 to %size] : !stream.resource<transient>{%size} -> %captured_target as !stream.resource<external>{%target_size}
+    stream.yield %1 : !stream.resource<external>{%target_size}
+  } => !stream.timepoint
+  // CHECK: util.do_not_optimize(%[[TARGET]])
+  util.do_not_optimize(%result) : !stream.resource<external>
+  return
+}
+
+// -----
+
 // CHECK-LABEL: @applyAsyncCopyOp
 // CHECK-SAME: (%[[SOURCE:.+]]: !stream.resource<external>,
 // CHECK-SAME:  %[[TARGET:.+]]: !stream.resource<transient>,
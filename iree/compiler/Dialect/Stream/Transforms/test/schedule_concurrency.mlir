@@ -98,3 +98,46 @@ func @partitioningForMaxConcurrency(%arg0: !stream.resource<external>, %arg1: !s
   %0 = stream.timepoint.await %result_timepoint => %results : !stream.resource<external>{%c20}
   return %0 : !stream.resource<external>
 }
+
+// -----
+
+// Tests that measured durations are used to place ops into the waves they
+// extend the least and to issue the longest ops within each wave first.
+
+// CHECK-LABEL: @partitioningWithDurations
+// CHECK-SAME: (%[[ARG0:.+]]: !stream.resource<external>)
+func @partitioningWithDurations(%arg0: !stream.resource<external>) -> (!stream.resource<external>, !stream.resource<external>, !stream.resource<external>)
+    attributes {stream.partitioning = #stream.partitioning_config<"max-concurrency">} {
+  %c1 = arith.constant 1 : index
+  %c20 = arith.constant 20 : index
+  // CHECK: stream.async.execute
+  %results:3, %result_timepoint = stream.async.execute
+      // CHECK-SAME: with(%[[ARG0]] as %[[ARG0_CAPTURE:.+]]: !stream.resource<external>{%c20})
+      with(%arg0 as %arg1: !stream.resource<external>{%c20})
+      -> (!stream.resource<external>{%c20}, !stream.resource<external>{%c20}, !stream.resource<external>{%c20}) {
+
+    // Without durations %c would be placed in the second wave alongside the
+    // short ops.
+    // CHECK: %[[CON0:.+]]:3 = stream.async.concurrent
+    // CHECK-SAME: with(%[[ARG0_CAPTURE]] as %[[ARG0_CON0_CAPTURE:.+]]: !stream.resource<external>{%c20})
+    // CHECK-NEXT: stream.async.dispatch @ex::@c
+    // CHECK-NEXT: stream.async.dispatch @ex::@b0
+    // CHECK-NEXT: stream.async.dispatch @ex::@a0
+    // CHECK-NEXT: stream.yield
+    %c = stream.async.dispatch @ex::@c[%c1, %c1, %c1](%arg1) {stream.duration_ns = 2000 : i64} : (!stream.resource<external>{%c20}) -> !stream.resource<external>{%c20}
+    %a0 = stream.async.dispatch @ex::@a0[%c1, %c1, %c1](%arg1) {stream.duration_ns = 1000 : i64} : (!stream.resource<external>{%c20}) -> !stream.resource<transient>{%c20}
+    %b0 = stream.async.dispatch @ex::@b0[%c1, %c1, %c1](%arg1) {stream.duration_ns = 1500 : i64} : (!stream.resource<external>{%c20}) -> !stream.resource<transient>{%c20}
+
+    // CHECK: %[[CON1:.+]]:2 = stream.async.concurrent
+    // CHECK-NEXT: stream.async.dispatch @ex::@b1
+    // CHECK-NEXT: stream.async.dispatch @ex::@a1
+    // CHECK-NEXT: stream.yield
+    %a1 = stream.async.dispatch @ex::@a1[%c1, %c1, %c1](%a0) {stream.duration_ns = 10 : i64} : (!stream.resource<transient>{%c20}) -> !stream.resource<external>{%c20}
+    %b1 = stream.async.dispatch @ex::@b1[%c1, %c1, %c1](%b0) {stream.duration_ns = 20 : i64} : (!stream.resource<transient>{%c20}) -> !stream.resource<external>{%c20}
+
+    // CHECK: stream.yield
+    stream.yield %c, %a1, %b1 : !stream.resource<external>{%c20}, !stream.resource<external>{%c20}, !stream.resource<external>{%c20}
+  } => !stream.timepoint
+  %0:3 = stream.timepoint.await %result_timepoint => %results#0, %results#1, %results#2 : !stream.resource<external>{%c20}, !stream.resource<external>{%c20}, !stream.resource<external>{%c20}
+  return %0#0, %0#1, %0#2 : !stream.resource<external>, !stream.resource<external>, !stream.resource<external>
+}
@@ -211,3 +211,31 @@ func @deviceHostDeviceCrossing(%arg0: i1) -> !stream.resource<transient> {
   // CHECK: return
   return %4 : !stream.resource<transient>
 }
+
+// -----
+
+// Tests that ops with different affinities are placed in different partitions
+// and that each execution region and the awaits on its results carry the
+// affinity of its ops. Ops without an affinity form regions without one.
+// NOTE: #stream.affinity has no parameters yet so the only distinct affinities
+// are the attribute and its absence.
+
+// CHECK-LABEL: @partitionWithAffinities
+// CHECK-SAME: (%[[ARG0:.+]]: !stream.resource<external>)
+func @partitionWithAffinities(%arg0: !stream.resource<external>) -> !stream.resource<external> {
+  %c1 = arith.constant 1 : index
+  %c20 = arith.constant 20 : index
+  // CHECK: %[[RESULT0:.+]], %[[TIMEPOINT0:.+]] = stream.async.execute on(#stream.affinity)
+  // CHECK-SAME: with(%[[ARG0]] as %[[ARG0_CAPTURE:.+]]: !stream.resource<external>{%c20})
+  // CHECK-NEXT: %[[DISPATCH0:.+]] = stream.async.dispatch on(#stream.affinity) @ex::@dispatch_0[%c1, %c1, %c1](%[[ARG0_CAPTURE]])
+  %0 = stream.async.dispatch on(#stream.affinity) @ex::@dispatch_0[%c1, %c1, %c1](%arg0) : (!stream.resource<external>{%c20}) -> !stream.resource<external>{%c20}
+  // CHECK-NEXT: stream.yield %[[DISPATCH0]]
+  // CHECK: %[[READY0:.+]] = stream.timepoint.await on(#stream.affinity) %[[TIMEPOINT0]] => %[[RESULT0]] : !stream.resource<external>{%c20}
+  // CHECK: %[[RESULT1:.+]], %[[TIMEPOINT1:.+]] = stream.async.execute with(%[[READY0]] as %[[READY0_CAPTURE:.+]]: !stream.resource<external>{%c20})
+  // CHECK-NEXT: %[[DISPATCH1:.+]] = stream.async.dispatch @ex::@dispatch_1[%c1, %c1, %c1](%[[READY0_CAPTURE]])
+  %1 = stream.async.dispatch @ex::@dispatch_1[%c1, %c1, %c1](%0) : (!stream.resource<external>{%c20}) -> !stream.resource<external>{%c20}
+  // CHECK-NEXT: stream.yield %[[DISPATCH1]]
+  // CHECK: %[[READY1:.+]] = stream.timepoint.await %[[TIMEPOINT1]] => %[[RESULT1]] : !stream.resource<external>{%c20}
+  // CHECK: return %[[READY1]]
+  return %1 : !stream.resource<external>
+}
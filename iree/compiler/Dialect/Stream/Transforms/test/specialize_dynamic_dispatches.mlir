@@ -0,0 +1,95 @@
+// RUN: iree-opt -split-input-file -iree-stream-specialize-dynamic-dispatches='values=128,256' %s | FileCheck %s
+
+// Tests that execution regions dispatching with a dynamic operand are switched
+// on the value of that operand between clones specialized for each value and
+// the original dynamic region. Each specialized export is shared by all
+// dispatches in regions specialized for the same value.
+
+// CHECK-LABEL: @specializeEx
+stream.executable private @specializeEx {
+  // CHECK: stream.executable.export public @dispatch
+  // CHECK-NEXT: stream.executable.export public @dispatch_128
+  // CHECK-NEXT: stream.executable.export public @dispatch_256
+  stream.executable.export public @dispatch
+  builtin.module  {
+    // CHECK: func @dispatch(
+    // CHECK: func @dispatch_128(
+    // CHECK: func @dispatch_256(
+    func @dispatch(%binding: !stream.binding, %dim: index) {
+      util.do_not_optimize(%dim) : index
+      return
+    }
+  }
+}
+// CHECK-LABEL: func @specialize
+// CHECK-SAME: (%[[DIM:.+]]: index, %[[SIZE:.+]]: index)
+func @specialize(%dim: index, %size: index) -> !stream.timepoint {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %alloc = stream.resource.alloc uninitialized : !stream.resource<transient>{%size}
+  // CHECK: %[[C128:.+]] = arith.constant 128 : index
+  // CHECK: %[[IS_128:.+]] = arith.cmpi eq, %[[DIM]], %[[C128]] : index
+  // CHECK: %[[TIMEPOINT:.+]] = scf.if %[[IS_128]] -> (!stream.timepoint) {
+  // CHECK:   %[[C128_INNER:.+]] = arith.constant 128 : index
+  // CHECK:   %[[TIMEPOINT_128:.+]] = stream.cmd.execute
+  // CHECK:     stream.cmd.dispatch @specializeEx::@dispatch_128[%c1, %c1, %c1](%[[C128_INNER]] : index)
+  // CHECK:     stream.cmd.dispatch @specializeEx::@dispatch_128[%c1, %c1, %c1](%[[C128_INNER]] : index)
+  // CHECK:   scf.yield %[[TIMEPOINT_128]]
+  // CHECK: } else {
+  // CHECK:   %[[C256:.+]] = arith.constant 256 : index
+  // CHECK:   %[[IS_256:.+]] = arith.cmpi eq, %[[DIM]], %[[C256]] : index
+  // CHECK:   %[[TIMEPOINT_ELSE:.+]] = scf.if %[[IS_256]] -> (!stream.timepoint) {
+  // CHECK:     stream.cmd.execute
+  // CHECK:       stream.cmd.dispatch @specializeEx::@dispatch_256
+  // CHECK:       stream.cmd.dispatch @specializeEx::@dispatch_256
+  // CHECK:   } else {
+  // CHECK:     %[[TIMEPOINT_DYNAMIC:.+]] = stream.cmd.execute
+  // CHECK:       stream.cmd.dispatch @specializeEx::@dispatch[%c1, %c1, %c1](%[[DIM]] : index)
+  // CHECK:       stream.cmd.dispatch @specializeEx::@dispatch[%c1, %c1, %c1](%[[DIM]] : index)
+  // CHECK:     scf.yield %[[TIMEPOINT_DYNAMIC]]
+  // CHECK:   }
+  // CHECK:   scf.yield %[[TIMEPOINT_ELSE]]
+  // CHECK: }
+  %timepoint = stream.cmd.execute with(%alloc as %capture: !stream.resource<transient>{%size}) {
+    stream.cmd.dispatch @specializeEx::@dispatch[%c1, %c1, %c1](%dim : index) {
+      rw %capture[%c0 for %size] : !stream.resource<transient>{%size}
+    }
+    stream.cmd.dispatch @specializeEx::@dispatch[%c1, %c1, %c1](%dim : index) {
+      rw %capture[%c0 for %size] : !stream.resource<transient>{%size}
+    }
+  } => !stream.timepoint
+  // CHECK: return %[[TIMEPOINT]]
+  return %timepoint : !stream.timepoint
+}
+
+// -----
+
+// Tests that execution regions without dynamic operands are not specialized.
+
+// CHECK-LABEL: @staticEx
+stream.executable private @staticEx {
+  // CHECK: stream.executable.export public @dispatch
+  // CHECK-NOT: stream.executable.export
+  stream.executable.export public @dispatch
+  builtin.module  {
+    func @dispatch(%binding: !stream.binding, %dim: index) {
+      util.do_not_optimize(%dim) : index
+      return
+    }
+  }
+}
+// CHECK-LABEL: func @dontSpecializeStatic
+func @dontSpecializeStatic(%size: index) -> !stream.timepoint {
+  %c0 = arith.constant 0 : index
+  %c1 = arith.constant 1 : index
+  %c64 = arith.constant 64 : index
+  %alloc = stream.resource.alloc uninitialized : !stream.resource<transient>{%size}
+  // CHECK-NOT: scf.if
+  // CHECK: stream.cmd.execute
+  %timepoint = stream.cmd.execute with(%alloc as %capture: !stream.resource<transient>{%size}) {
+    stream.cmd.dispatch @staticEx::@dispatch[%c1, %c1, %c1](%c64 : index) {
+      rw %capture[%c0 for %size] : !stream.resource<transient>{%size}
+    }
+  } => !stream.timepoint
+  return %timepoint : !stream.timepoint
+}
@@ -57,3 +57,29 @@ module @broadcast_treated_as_leaf {
   }
   // CHECK-NOT: util.initializer
 }
+
+// -----
+// Verifies that the packing of constant mmt4d operands into a tiled layout is
+// hoisted as a single leaf.
+// CHECK-LABEL: @mmt4d_packing_hoisted
+#map0 = affine_map<(d0, d1, d2, d3) -> (d1, d3, d0, d2)>
+#map1 = affine_map<(d0, d1, d2, d3) -> (d0, d1, d2, d3)>
+module @mmt4d_packing_hoisted {
+  // CHECK: util.global private @[[HOISTED:.*]] : tensor<8x4x4x2xf32>
+  // CHECK: func @main
+  builtin.func @main(%arg0: tensor<3x4x8x2xf32>, %arg1: tensor<3x8x8x4xf32>) -> (tensor<3x8x8x4xf32>) {
+    %cst = arith.constant dense<1.0> : tensor<8x32xf32>
+    %0 = tensor.expand_shape %cst [[0, 1], [2, 3]] : tensor<8x32xf32> into tensor<4x2x8x4xf32>
+    %1 = linalg.init_tensor [8, 4, 4, 2] : tensor<8x4x4x2xf32>
+    %2 = linalg.generic {indexing_maps = [#map0, #map1], iterator_types = ["parallel", "parallel", "parallel", "parallel"]} ins(%0 : tensor<4x2x8x4xf32>) outs(%1 : tensor<8x4x4x2xf32>) {
+    ^bb0(%arg2: f32, %arg3: f32):  // no predecessors
+      linalg.yield %arg2 : f32
+    } -> tensor<8x4x4x2xf32>
+    // CHECK: %[[RHS:.*]] = util.global.load @[[HOISTED]] : tensor<8x4x4x2xf32>
+    // CHECK: linalg.mmt4d
+    // CHECK-SAME: ins(%arg0, %[[RHS]] : tensor<3x4x8x2xf32>, tensor<8x4x4x2xf32>)
+    %3 = linalg.mmt4d ins(%arg0, %2 : tensor<3x4x8x2xf32>, tensor<8x4x4x2xf32>) outs(%arg1 : tensor<3x8x8x4xf32>) -> tensor<3x8x8x4xf32>
+    return %3 : tensor<3x8x8x4xf32>
+  }
+  // CHECK: util.initializer
+}
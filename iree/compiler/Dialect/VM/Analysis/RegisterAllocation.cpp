@@ -159,6 +159,22 @@ struct RegisterUsage {
     }
   }
 
+  // Returns true if all ordinals covered by |reg| are unused.
+  bool isRegisterAvailable(Register reg) {
+    int ordinalStart = reg.ordinal();
+    if (reg.isRef()) {
+      return ordinalStart < Register::kRefRegisterCount &&
+             !refRegisters.test(ordinalStart);
+    }
+    unsigned int ordinalEnd = ordinalStart + (reg.byteWidth() / 4) - 1;
+    if (ordinalEnd >= Register::kInt32RegisterCount) return false;
+    for (unsigned int ordinal = ordinalStart; ordinal <= ordinalEnd;
+         ++ordinal) {
+      if (intRegisters.test(ordinal)) return false;
+    }
+    return true;
+  }
+
   void releaseRegister(Register reg) {
     int ordinalStart = reg.ordinal();
     if (reg.isRef()) {
@@ -202,6 +218,29 @@ static SmallVector<Block *, 8> sortBlocksInDominanceOrder(
   return orderedBlocks;
 }
 
+// Returns the register of a value passed to |blockArg| by a predecessor that
+// has already been allocated, if any is available in |registerUsage|. Sharing
+// the register with the incoming value elides the remapping on that edge.
+static Optional<Register> findCoalescableRegister(
+    BlockArgument blockArg, llvm::DenseMap<Value, Register> &map,
+    RegisterUsage &registerUsage) {
+  auto *block = blockArg.getOwner();
+  for (auto *predecessor : block->getPredecessors()) {
+    auto branchOp = dyn_cast<BranchOpInterface>(predecessor->getTerminator());
+    if (!branchOp) continue;
+    for (unsigned i = 0; i < branchOp->getNumSuccessors(); ++i) {
+      if (branchOp->getSuccessor(i) != block) continue;
+      auto operands = branchOp.getSuccessorOperands(i);
+      if (!operands.hasValue()) continue;
+      auto it = map.find((*operands)[blockArg.getArgNumber()]);
+      if (it == map.end()) continue;  // back edge not yet allocated
+      auto reg = it->second.asBaseRegister();
+      if (registerUsage.isRegisterAvailable(reg)) return reg;
+    }
+  }
+  return llvm::None;
+}
+
 // NOTE: this is not a good algorithm, nor is it a good allocator. If you're
 // looking at this and have ideas of how to do this for real please feel
 // free to rip it all apart :)
@@ -211,6 +250,11 @@ static SmallVector<Block *, 8> sortBlocksInDominanceOrder(
 // ensure we are avoiding as many moves as possible. The special case we need to
 // handle is when values are not defined within the current block (as values in
 // dominators are allowed to cross block boundaries outside of arguments).
+//
+// Block arguments are coalesced with the registers of the values passed in
+// from predecessors when those registers are free on entry to the block. As
+// blocks are visited in dominance order this covers forward edges; back edges
+// (loops) still remap their operands.
 LogicalResult RegisterAllocation::recalculate(IREE::VM::FuncOp funcOp) {
   map_.clear();
 
@@ -237,9 +281,15 @@ LogicalResult RegisterAllocation::recalculate(IREE::VM::FuncOp funcOp) {
       registerUsage.markRegisterUsed(mapToRegister(liveInValue));
     }
 
-    // Allocate arguments first from left-to-right.
+    // Allocate arguments first from left-to-right, preferring the registers
+    // that incoming values already occupy.
     for (auto blockArg : block->getArguments()) {
-      auto reg = registerUsage.allocateRegister(blockArg.getType());
+      auto reg = findCoalescableRegister(blockArg, map_, registerUsage);
+      if (reg.hasValue()) {
+        registerUsage.markRegisterUsed(reg.getValue());
+      } else {
+        reg = registerUsage.allocateRegister(blockArg.getType());
+      }
       if (!reg.hasValue()) {
         return funcOp.emitError() << "register allocation failed for block arg "
                                   << blockArg.getArgNumber();
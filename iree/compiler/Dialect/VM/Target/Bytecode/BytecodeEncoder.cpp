@@ -326,6 +326,58 @@ class V0BytecodeEncoder : public BytecodeEncoder {
 
 }  // namespace
 
+// Returns the opcode of the fused compare-and-branch superinstruction that can
+// replace |op| and the vm.cond_br immediately following it, if any.
+// The comparison must only be used as the branch condition as its result is
+// never written to a register.
+static Optional<Opcode> matchCondBranchCmpOp(Operation &op,
+                                             CondBranchOp &condBranchOp) {
+  Optional<Opcode> opcode;
+  if (isa<CmpEQI32Op>(op)) {
+    opcode = Opcode::CondBranchEQI32;
+  } else if (isa<CmpNEI32Op>(op)) {
+    opcode = Opcode::CondBranchNEI32;
+  } else if (isa<CmpLTI32SOp>(op)) {
+    opcode = Opcode::CondBranchLTI32S;
+  } else if (isa<CmpLTI32UOp>(op)) {
+    opcode = Opcode::CondBranchLTI32U;
+  } else {
+    return llvm::None;
+  }
+  condBranchOp = dyn_cast_or_null<CondBranchOp>(op.getNextNode());
+  if (!condBranchOp) return llvm::None;
+  Value result = op.getResult(0);
+  if (condBranchOp.condition() != result || !result.hasOneUse()) {
+    return llvm::None;
+  }
+  return opcode;
+}
+
+// Encodes |cmpOp| and |condBranchOp| as a single fused compare-and-branch
+// superinstruction. The encoding matches vm.cond_br with the condition operand
+// replaced by the lhs and rhs operands of the comparison.
+static LogicalResult encodeCondBranchCmpOp(Opcode opcode, Operation &cmpOp,
+                                           CondBranchOp condBranchOp,
+                                           BytecodeEncoder &encoder) {
+  if (failed(encoder.beginOp(&cmpOp)) ||
+      failed(encoder.encodeOpcode(stringifyOpcode(opcode),
+                                  static_cast<int>(opcode))) ||
+      failed(encoder.encodeOperand(cmpOp.getOperand(0), 0)) ||
+      failed(encoder.encodeOperand(cmpOp.getOperand(1), 1)) ||
+      failed(encoder.endOp(&cmpOp))) {
+    return failure();
+  }
+  if (failed(encoder.beginOp(condBranchOp)) ||
+      failed(encoder.encodeBranch(condBranchOp.getTrueDest(),
+                                  condBranchOp.getTrueOperands(), 0)) ||
+      failed(encoder.encodeBranch(condBranchOp.getFalseDest(),
+                                  condBranchOp.getFalseOperands(), 1)) ||
+      failed(encoder.endOp(condBranchOp))) {
+    return failure();
+  }
+  return success();
+}
+
 // static
 Optional<EncodedBytecodeFunction> BytecodeEncoder::encodeFunction(
     IREE::VM::FuncOp funcOp, llvm::DenseMap<Type, int> &typeTable,
@@ -349,7 +401,8 @@ Optional<EncodedBytecodeFunction> BytecodeEncoder::encodeFunction(
       return llvm::None;
     }
 
-    for (auto &op : block.getOperations()) {
+    for (auto opIt = block.begin(); opIt != block.end(); ++opIt) {
+      auto &op = *opIt;
       auto serializableOp = dyn_cast<IREE::VM::VMSerializableOp>(op);
       if (!serializableOp) {
         op.emitOpError() << "is not serializable";
@@ -357,6 +410,20 @@ Optional<EncodedBytecodeFunction> BytecodeEncoder::encodeFunction(
       }
       sourceMap.locations.push_back(
           {static_cast<int32_t>(encoder.getOffset()), op.getLoc()});
+
+      // Fuse comparisons only used by the branch following them into a single
+      // compare-and-branch op to save a dispatch and register write in loops.
+      CondBranchOp condBranchOp;
+      if (auto opcode = matchCondBranchCmpOp(op, condBranchOp)) {
+        if (failed(encodeCondBranchCmpOp(opcode.getValue(), op, condBranchOp,
+                                         encoder))) {
+          op.emitOpError() << "failed to encode fused with branch";
+          return llvm::None;
+        }
+        ++opIt;
+        continue;
+      }
+
       if (failed(encoder.beginOp(&op)) ||
           failed(serializableOp.encode(symbolTable, encoder)) ||
           failed(encoder.endOp(&op))) {
@@ -0,0 +1,48 @@
+// RUN: iree-translate -split-input-file -iree-vm-ir-to-bytecode-module -iree-vm-bytecode-module-output-format=flatbuffer-text %s | FileCheck %s
+
+// Comparisons only used by the vm.cond_br following them are encoded as a
+// single fused CondBranchLTI32S (0x58) op.
+
+// CHECK: "name": "fused_module"
+vm.module @fused_module {
+  vm.export @func
+  vm.func @func(%arg0 : i32, %arg1 : i32) -> i32 {
+    %0 = vm.cmp.lt.i32.s %arg0, %arg1 : i32
+    vm.cond_br %0, ^bb1, ^bb2
+  ^bb1:
+    vm.return %arg0 : i32
+  ^bb2:
+    vm.return %arg1 : i32
+  }
+
+  //      CHECK: "bytecode_data": [
+  // CHECK-NEXT:   88,
+  // CHECK-NEXT:   0,
+  // CHECK-NEXT:   0,
+  // CHECK-NEXT:   1,
+  // CHECK-NEXT:   0,
+}
+
+// -----
+
+// Comparisons with other uses are not fused and encode as CmpLTI32S (0x42).
+
+// CHECK: "name": "unfused_module"
+vm.module @unfused_module {
+  vm.export @func
+  vm.func @func(%arg0 : i32, %arg1 : i32) -> i32 {
+    %0 = vm.cmp.lt.i32.s %arg0, %arg1 : i32
+    vm.cond_br %0, ^bb1, ^bb2
+  ^bb1:
+    vm.return %0 : i32
+  ^bb2:
+    vm.return %arg1 : i32
+  }
+
+  //      CHECK: "bytecode_data": [
+  // CHECK-NEXT:   66,
+  // CHECK-NEXT:   0,
+  // CHECK-NEXT:   0,
+  // CHECK-NEXT:   1,
+  // CHECK-NEXT:   0,
+}
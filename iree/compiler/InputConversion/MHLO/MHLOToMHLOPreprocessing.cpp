@@ -6,9 +6,11 @@
 
 #include <numeric>
 #include <random>
+#include <type_traits>
 
 #include "iree/compiler/InputConversion/MHLO/PassDetail.h"
 #include "iree/compiler/InputConversion/MHLO/Passes.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/Support/Casting.h"
 #include "mlir-hlo/Dialect/mhlo/IR/chlo_ops.h"
@@ -21,7 +23,9 @@
 #include "mlir/IR/Attributes.h"
 #include "mlir/IR/BuiltinTypes.h"
 #include "mlir/IR/ImplicitLocOpBuilder.h"
+#include "mlir/IR/Matchers.h"
 #include "mlir/IR/TypeUtilities.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
 #include "mlir/Pass/Pass.h"
 #include "mlir/Support/LogicalResult.h"
 #include "mlir/Transforms/GreedyPatternRewriteDriver.h"
@@ -828,6 +832,278 @@ class ReorderBroadcastInDimOpAndElementwiseOp
   }
 };
 
+// Returns true if |value| is computed only from constants. Such values are
+// folded during compilation (by the op folders or ConstEval) and so moving
+// computation onto them has no runtime cost.
+static bool isConstantExpression(Value value) {
+  SmallVector<Value> worklist = {value};
+  llvm::SmallDenseSet<Operation *> visitedOps;
+  while (!worklist.empty()) {
+    Operation *op = worklist.pop_back_val().getDefiningOp();
+    if (!op) return false;
+    if (!visitedOps.insert(op).second) continue;
+    if (op->hasTrait<OpTrait::ConstantLike>()) continue;
+    if (op->getNumRegions() != 0 ||
+        !MemoryEffectOpInterface::hasNoEffect(op)) {
+      return false;
+    }
+    worklist.append(op->operand_begin(), op->operand_end());
+  }
+  return true;
+}
+
+// Matches a per-channel constant broadcast along a single dimension:
+//   %0 = "mhlo.broadcast_in_dim"(%c) {broadcast_dimensions = dense<D>}
+// Returns the 1-D channel value and the dimension D.
+static Optional<std::pair<Value, int64_t>> matchChannelBroadcast(Value value) {
+  auto bcastOp = value.getDefiningOp<mhlo::BroadcastInDimOp>();
+  if (!bcastOp) return llvm::None;
+  auto operandType = bcastOp.operand().getType().dyn_cast<RankedTensorType>();
+  if (!operandType || operandType.getRank() != 1 ||
+      !operandType.hasStaticShape()) {
+    return llvm::None;
+  }
+  if (!isConstantExpression(bcastOp.operand())) return llvm::None;
+  auto dims = bcastOp.broadcast_dimensions();
+  return std::make_pair(bcastOp.operand(),
+                        (*dims.getValues<int64_t>().begin()));
+}
+
+// Returns true if |value| is a convolution or dot, optionally followed by
+// per-channel offsets/scales, whose weights can absorb a per-channel scale.
+static bool isChannelScalable(Value value) {
+  while (Operation *op = value.getDefiningOp()) {
+    if (isa<mhlo::ConvOp, mhlo::DotOp>(op)) return true;
+    if (!isa<mhlo::AddOp, mhlo::SubOp, mhlo::MulOp, mhlo::DivOp>(op)) {
+      return false;
+    }
+    if (matchChannelBroadcast(op->getOperand(1))) {
+      value = op->getOperand(0);
+    } else if (matchChannelBroadcast(op->getOperand(0))) {
+      value = op->getOperand(1);
+    } else {
+      return false;
+    }
+  }
+  return false;
+}
+
+// Folds a per-channel scale (as produced by unfused inference batch norm) of
+// the output of a convolution or dot into its weights. The scale is applied
+// to the weights along the dimension producing the output channels and the
+// new weights are constant folded when the original weights are constant.
+//
+// Example:
+//  %0 = mhlo.convolution(%input, %weights) ...
+//  %1 = "mhlo.broadcast_in_dim"(%scale) {broadcast_dimensions = dense<3>}
+//  %2 = mhlo.multiply %0, %1
+// ->
+//  %0 = "mhlo.broadcast_in_dim"(%scale) {broadcast_dimensions = dense<3>}
+//  %1 = mhlo.multiply %weights, %0
+//  %2 = mhlo.convolution(%input, %1) ...
+template <typename ScaleOpT>
+class FoldChannelScaleIntoWeights : public OpRewritePattern<ScaleOpT> {
+ public:
+  using OpRewritePattern<ScaleOpT>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(ScaleOpT op,
+                                PatternRewriter &rewriter) const override {
+    if (!getElementTypeOrSelf(op.getType()).template isa<FloatType>()) {
+      return failure();
+    }
+    // Division is only distributive over the lhs.
+    unsigned numCandidates =
+        std::is_same<ScaleOpT, mhlo::DivOp>::value ? 1 : 2;
+    for (unsigned i = 0; i < numCandidates; ++i) {
+      Value producer = op->getOperand(i);
+      if (!producer.hasOneUse()) continue;
+      auto scale = matchChannelBroadcast(op->getOperand(1 - i));
+      if (!scale) continue;
+      if (auto convOp = producer.getDefiningOp<mhlo::ConvOp>()) {
+        auto dimensionNumbers = convOp.dimension_numbers();
+        if (scale->second != dimensionNumbers.getOutputFeatureDimension()) {
+          continue;
+        }
+        Value newWeights = scaleWeights(
+            rewriter, op.getLoc(), convOp.rhs(), scale->first,
+            dimensionNumbers.getKernelOutputFeatureDimension());
+        if (!newWeights) continue;
+        auto newOp = rewriter.create<mhlo::ConvOp>(
+            convOp.getLoc(), convOp.getType(),
+            ValueRange{convOp.lhs(), newWeights}, convOp->getAttrs());
+        rewriter.replaceOp(op, newOp.getResult());
+        return success();
+      } else if (auto dotOp = producer.getDefiningOp<mhlo::DotOp>()) {
+        // Only matrix outputs where the channels come from the rhs columns.
+        auto rhsType = dotOp.rhs().getType().dyn_cast<RankedTensorType>();
+        auto resultType = dotOp.getType().dyn_cast<RankedTensorType>();
+        if (!rhsType || !resultType || rhsType.getRank() != 2 ||
+            resultType.getRank() != 2 || scale->second != 1) {
+          continue;
+        }
+        Value newWeights = scaleWeights(rewriter, op.getLoc(), dotOp.rhs(),
+                                        scale->first, /*dim=*/1);
+        if (!newWeights) continue;
+        auto newOp = rewriter.create<mhlo::DotOp>(
+            dotOp.getLoc(), dotOp.getType(),
+            ValueRange{dotOp.lhs(), newWeights}, dotOp->getAttrs());
+        rewriter.replaceOp(op, newOp.getResult());
+        return success();
+      }
+    }
+    return failure();
+  }
+
+ private:
+  // Returns |weights| scaled by |scale| along |dim| or nullptr if the types
+  // are not compatible.
+  static Value scaleWeights(PatternRewriter &rewriter, Location loc,
+                            Value weights, Value scale, int64_t dim) {
+    auto weightsType = weights.getType().dyn_cast<RankedTensorType>();
+    auto scaleType = scale.getType().cast<RankedTensorType>();
+    if (!weightsType || !weightsType.hasStaticShape() ||
+        weightsType.getElementType() != scaleType.getElementType() ||
+        weightsType.getDimSize(dim) != scaleType.getDimSize(0)) {
+      return {};
+    }
+    Value bcast = rewriter.create<mhlo::BroadcastInDimOp>(
+        loc, weightsType, scale, make1DElementsAttr(rewriter, {dim}));
+    return rewriter.create<ScaleOpT>(loc, weightsType,
+                                     ValueRange{weights, bcast});
+  }
+};
+
+// Moves a per-channel scale ahead of a per-channel offset so that it can be
+// folded into the weights of the producer with FoldChannelScaleIntoWeights.
+// The offset is scaled instead, which is constant folded.
+//
+// Example:
+//  %0 = mhlo.subtract %conv, %mean_bcast
+//  %1 = mhlo.multiply %0, %scale_bcast
+// ->
+//  %0 = mhlo.multiply %conv, %scale_bcast
+//  %1 = mhlo.multiply %mean, %scale
+//  %2 = "mhlo.broadcast_in_dim"(%1)
+//  %3 = mhlo.subtract %0, %2
+template <typename ScaleOpT>
+class ReorderChannelScaleAndOffset : public OpRewritePattern<ScaleOpT> {
+ public:
+  using OpRewritePattern<ScaleOpT>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(ScaleOpT op,
+                                PatternRewriter &rewriter) const override {
+    if (!getElementTypeOrSelf(op.getType()).template isa<FloatType>()) {
+      return failure();
+    }
+    auto scale = matchChannelBroadcast(op.rhs());
+    if (!scale) return failure();
+    Operation *offsetOp = op.lhs().getDefiningOp();
+    if (!offsetOp || !isa<mhlo::AddOp, mhlo::SubOp>(offsetOp) ||
+        !offsetOp->hasOneUse()) {
+      return failure();
+    }
+
+    // One side of the offset must be a matching channel broadcast and the
+    // other must lead to weights that can absorb the scale.
+    for (unsigned i = 0; i < 2; ++i) {
+      auto offset = matchChannelBroadcast(offsetOp->getOperand(i));
+      Value input = offsetOp->getOperand(1 - i);
+      if (!offset || offset->second != scale->second ||
+          offset->first.getType() != scale->first.getType() ||
+          !isChannelScalable(input)) {
+        continue;
+      }
+      auto loc = op.getLoc();
+      auto type = op.getType();
+      Value scaledInput = rewriter.create<ScaleOpT>(
+          loc, type, ValueRange{input, op.rhs()});
+      Value scaledOffset = rewriter.create<ScaleOpT>(
+          loc, offset->first.getType(), ValueRange{offset->first, scale->first});
+      Value scaledOffsetBcast = rewriter.create<mhlo::BroadcastInDimOp>(
+          loc, type, scaledOffset,
+          make1DElementsAttr(rewriter, {scale->second}));
+      SmallVector<Value, 2> operands(2);
+      operands[i] = scaledOffsetBcast;
+      operands[1 - i] = scaledInput;
+      OperationState state(offsetOp->getLoc(), offsetOp->getName());
+      state.addOperands(operands);
+      state.addTypes(type);
+      state.addAttributes(offsetOp->getAttrs());
+      rewriter.replaceOp(op, rewriter.createOperation(state)->getResults());
+      return success();
+    }
+    return failure();
+  }
+};
+
+// Folds an explicit zero mhlo.pad of the spatial dimensions of a convolution
+// input into the convolution padding. This is the inverse of
+// ExtractConvOpPaddingAttributes and only used when that is not.
+class FoldPadIntoConv : public OpRewritePattern<mhlo::ConvOp> {
+ public:
+  using OpRewritePattern<mhlo::ConvOp>::OpRewritePattern;
+
+  LogicalResult matchAndRewrite(mhlo::ConvOp op,
+                                PatternRewriter &rewriter) const override {
+    auto padOp = op.lhs().getDefiningOp<mhlo::PadOp>();
+    if (!padOp) return failure();
+
+    // Padding is applied after lhs dilation so they can't be combined.
+    if (op.lhs_dilation().hasValue() &&
+        !isSplatValue(op.lhs_dilation().getValue(), 1)) {
+      return failure();
+    }
+
+    // Only zero padding matches the implicit convolution padding.
+    DenseElementsAttr padValueAttr;
+    if (!matchPattern(padOp.padding_value(), m_Constant(&padValueAttr)) ||
+        !padValueAttr.isSplat()) {
+      return failure();
+    }
+    if (padValueAttr.getType().getElementType().isa<FloatType>()) {
+      if (!padValueAttr.getSplatValue<APFloat>().isPosZero()) return failure();
+    } else if (!padValueAttr.getSplatValue<APInt>().isZero()) {
+      return failure();
+    }
+    if (!isAllZero(padOp.interior_padding())) return failure();
+
+    auto paddingLow = extract1DVector(padOp.edge_padding_low());
+    auto paddingHigh = extract1DVector(padOp.edge_padding_high());
+    auto dimensionNumbers = op.dimension_numbers();
+    auto spatialDims = dimensionNumbers.getInputSpatialDimensions();
+    for (unsigned dim = 0; dim < paddingLow.size(); ++dim) {
+      if (paddingLow[dim] < 0 || paddingHigh[dim] < 0) return failure();
+      if (!llvm::is_contained(spatialDims, dim) &&
+          (paddingLow[dim] != 0 || paddingHigh[dim] != 0)) {
+        return failure();
+      }
+    }
+
+    SmallVector<int64_t> padding;
+    for (auto it : llvm::enumerate(spatialDims)) {
+      int64_t low = paddingLow[it.value()];
+      int64_t high = paddingHigh[it.value()];
+      if (op.padding().hasValue()) {
+        low += op.paddingAttr().getValues<int64_t>()[{it.index(), 0}];
+        high += op.paddingAttr().getValues<int64_t>()[{it.index(), 1}];
+      }
+      padding.push_back(low);
+      padding.push_back(high);
+    }
+    auto paddingAttr = DenseIntElementsAttr::get(
+        RankedTensorType::get({static_cast<int64_t>(spatialDims.size()), 2},
+                              rewriter.getI64Type()),
+        padding);
+
+    auto newOp = rewriter.create<mhlo::ConvOp>(
+        op.getLoc(), op.getType(), ValueRange{padOp.operand(), op.rhs()},
+        op->getAttrs());
+    newOp.paddingAttr(paddingAttr);
+    rewriter.replaceOp(op, newOp.getResult());
+    return success();
+  }
+};
+
 struct MHLOToMHLOPreprocessingPass
     : public MHLOToMHLOPreprocessingBase<MHLOToMHLOPreprocessingPass> {
   void getDependentDialects(DialectRegistry &registry) const override {
@@ -910,8 +1186,15 @@ struct MHLOToMHLOPreprocessingPass
         ReorderBroadcastInDimOpAndElementwiseOp<mhlo::AndOp>,
         ReorderBroadcastInDimOpAndElementwiseOp<mhlo::OrOp>,
         ReorderBroadcastInDimOpAndElementwiseOp<mhlo::XorOp>>(context);
+    // Inference batch norm (unfused above) and other per-channel scales.
+    patterns.insert<FoldChannelScaleIntoWeights<mhlo::MulOp>,
+                    FoldChannelScaleIntoWeights<mhlo::DivOp>,
+                    ReorderChannelScaleAndOffset<mhlo::MulOp>,
+                    ReorderChannelScaleAndOffset<mhlo::DivOp>>(context);
     if (extractPadFromConv) {
       patterns.insert<ExtractConvOpPaddingAttributes>(context);
+    } else {
+      patterns.insert<FoldPadIntoConv>(context);
     }
     if (orderConvFeatures) {
       patterns.insert<ReorderConvOpInputDimensions>(context);
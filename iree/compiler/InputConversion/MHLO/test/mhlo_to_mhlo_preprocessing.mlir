@@ -338,3 +338,76 @@ func @scatter_rank0(%arg0: tensor<5x5xi32>, %arg1: tensor<2xi32>, %arg2: tensor<
 // CHECK-DAG: %[[RE_U:.+]] = "mhlo.reshape"(%arg2) : (tensor<i32>) -> tensor<1xi32>
 // CHECK:     %[[SCATTER:.+]] = "mhlo.scatter"(%arg0, %[[RE_I]], %[[RE_U]])
 // CHECK:       "mhlo.return"(%arg4)
+
+// -----
+
+// Tests that a per-channel scale of the conv output is folded into the weights.
+
+// CHECK-LABEL: @fold_channel_scale_into_conv
+// CHECK-SAME: (%[[INPUT:.+]]: tensor<1x4x4x2xf32>, %[[WEIGHTS:.+]]: tensor<3x3x2x4xf32>)
+func @fold_channel_scale_into_conv(%input: tensor<1x4x4x2xf32>, %weights: tensor<3x3x2x4xf32>) -> tensor<1x2x2x4xf32> {
+  // CHECK: %[[SCALE:.+]] = mhlo.constant dense<[1.000000e+00, 2.000000e+00, 3.000000e+00, 4.000000e+00]>
+  %scale = mhlo.constant dense<[1.0, 2.0, 3.0, 4.0]> : tensor<4xf32>
+  // CHECK: %[[SCALE_BCAST:.+]] = "mhlo.broadcast_in_dim"(%[[SCALE]]) {broadcast_dimensions = dense<3> : tensor<1xi64>} : (tensor<4xf32>) -> tensor<3x3x2x4xf32>
+  // CHECK: %[[SCALED_WEIGHTS:.+]] = mhlo.multiply %[[WEIGHTS]], %[[SCALE_BCAST]] : tensor<3x3x2x4xf32>
+  // CHECK: %[[CONV:.+]] = mhlo.convolution(%[[INPUT]], %[[SCALED_WEIGHTS]])
+  %0 = "mhlo.convolution"(%input, %weights) {
+    batch_group_count = 1 : i64,
+    dimension_numbers = #mhlo.conv<raw
+      input_batch_dimension = 0,
+      input_feature_dimension = 3,
+      input_spatial_dimensions = [1, 2],
+      kernel_input_feature_dimension = 2,
+      kernel_output_feature_dimension = 3,
+      kernel_spatial_dimensions = [0, 1],
+      output_batch_dimension = 0,
+      output_feature_dimension = 3,
+      output_spatial_dimensions = [1, 2]
+    >,
+    feature_group_count = 1 : i64,
+    rhs_dilation = dense<1> : tensor<2xi64>,
+    window_strides = dense<1> : tensor<2xi64>
+  } : (tensor<1x4x4x2xf32>, tensor<3x3x2x4xf32>) -> tensor<1x2x2x4xf32>
+  %1 = "mhlo.broadcast_in_dim"(%scale) {broadcast_dimensions = dense<3> : tensor<1xi64>} : (tensor<4xf32>) -> tensor<1x2x2x4xf32>
+  // CHECK-NOT: mhlo.multiply
+  %2 = mhlo.multiply %0, %1 : tensor<1x2x2x4xf32>
+  // CHECK: return %[[CONV]]
+  return %2 : tensor<1x2x2x4xf32>
+}
+
+// -----
+
+// Tests that a per-channel scale following a per-channel offset (as in unfused
+// batch norm) is reordered and folded into the weights of a dot.
+
+// CHECK-LABEL: @fold_channel_scale_through_offset_into_dot
+// CHECK-SAME: (%[[LHS:.+]]: tensor<2x3xf32>, %[[RHS:.+]]: tensor<3x4xf32>)
+func @fold_channel_scale_through_offset_into_dot(%lhs: tensor<2x3xf32>, %rhs: tensor<3x4xf32>) -> tensor<2x4xf32> {
+  %mean = mhlo.constant dense<[1.0, 2.0, 3.0, 4.0]> : tensor<4xf32>
+  %scale = mhlo.constant dense<[5.0, 6.0, 7.0, 8.0]> : tensor<4xf32>
+  // CHECK: %[[SCALED_RHS:.+]] = mhlo.multiply %[[RHS]], %{{.+}} : tensor<3x4xf32>
+  // CHECK: %[[DOT:.+]] = "mhlo.dot"(%[[LHS]], %[[SCALED_RHS]])
+  %0 = "mhlo.dot"(%lhs, %rhs) : (tensor<2x3xf32>, tensor<3x4xf32>) -> tensor<2x4xf32>
+  %1 = "mhlo.broadcast_in_dim"(%mean) {broadcast_dimensions = dense<1> : tensor<1xi64>} : (tensor<4xf32>) -> tensor<2x4xf32>
+  // CHECK: %[[RESULT:.+]] = mhlo.subtract %[[DOT]], %{{.+}} : tensor<2x4xf32>
+  %2 = mhlo.subtract %0, %1 : tensor<2x4xf32>
+  %3 = "mhlo.broadcast_in_dim"(%scale) {broadcast_dimensions = dense<1> : tensor<1xi64>} : (tensor<4xf32>) -> tensor<2x4xf32>
+  // CHECK-NOT: mhlo.multiply
+  %4 = mhlo.multiply %2, %3 : tensor<2x4xf32>
+  // CHECK: return %[[RESULT]]
+  return %4 : tensor<2x4xf32>
+}
+
+// -----
+
+// Tests that scales that are not constant are not folded into the weights.
+
+// CHECK-LABEL: @no_fold_dynamic_channel_scale
+func @no_fold_dynamic_channel_scale(%lhs: tensor<2x3xf32>, %rhs: tensor<3x4xf32>, %scale: tensor<4xf32>) -> tensor<2x4xf32> {
+  // CHECK: %[[DOT:.+]] = "mhlo.dot"(%arg0, %arg1)
+  %0 = "mhlo.dot"(%lhs, %rhs) : (tensor<2x3xf32>, tensor<3x4xf32>) -> tensor<2x4xf32>
+  %1 = "mhlo.broadcast_in_dim"(%scale) {broadcast_dimensions = dense<1> : tensor<1xi64>} : (tensor<4xf32>) -> tensor<2x4xf32>
+  // CHECK: mhlo.multiply %[[DOT]]
+  %2 = mhlo.multiply %0, %1 : tensor<2x4xf32>
+  return %2 : tensor<2x4xf32>
+}
@@ -0,0 +1,68 @@
+// RUN: iree-opt -split-input-file -iree-mhlo-to-mhlo-preprocessing{extract-pad-from-conv=false} %s | FileCheck %s
+
+// CHECK-LABEL: @fold_pad_into_conv
+// CHECK-SAME: (%[[INPUTS:.+]]: tensor<1x4x5x2xf32>, %[[WEIGHTS:.+]]: tensor<3x2x2x1xf32>)
+//   CHECK-NOT: mhlo.pad
+//       CHECK: mhlo.convolution(%[[INPUTS]], %[[WEIGHTS]])
+//  CHECK-SAME: pad = {{\[}}[2, 1], [0, 2]]
+func @fold_pad_into_conv(%inputs: tensor<1x4x5x2xf32>, %weights: tensor<3x2x2x1xf32>) -> tensor<1x5x6x1xf32> {
+  %zero = mhlo.constant dense<0.0> : tensor<f32>
+  %0 = "mhlo.pad"(%inputs, %zero) {
+    edge_padding_high = dense<[0, 0, 1, 0]> : tensor<4xi64>,
+    edge_padding_low = dense<[0, 1, 0, 0]> : tensor<4xi64>,
+    interior_padding = dense<0> : tensor<4xi64>
+  } : (tensor<1x4x5x2xf32>, tensor<f32>) -> tensor<1x5x6x2xf32>
+  %1 = "mhlo.convolution"(%0, %weights) {
+    batch_group_count = 1 : i64,
+    dimension_numbers = #mhlo.conv<raw
+      input_batch_dimension = 0,
+      input_feature_dimension = 3,
+      input_spatial_dimensions = [1, 2],
+      kernel_input_feature_dimension = 2,
+      kernel_output_feature_dimension = 3,
+      kernel_spatial_dimensions = [0, 1],
+      output_batch_dimension = 0,
+      output_feature_dimension = 3,
+      output_spatial_dimensions = [1, 2]
+    >,
+    feature_group_count = 1 : i64,
+    padding = dense<[[1, 1], [0, 1]]> : tensor<2x2xi64>,
+    rhs_dilation = dense<1> : tensor<2xi64>,
+    window_strides = dense<1> : tensor<2xi64>
+  } : (tensor<1x5x6x2xf32>, tensor<3x2x2x1xf32>) -> tensor<1x5x6x1xf32>
+  return %1 : tensor<1x5x6x1xf32>
+}
+
+// -----
+
+// Tests that non-zero padding is not folded.
+
+// CHECK-LABEL: @no_fold_nonzero_pad_into_conv
+//       CHECK: mhlo.pad
+//       CHECK: mhlo.convolution
+func @no_fold_nonzero_pad_into_conv(%inputs: tensor<1x4x5x2xf32>, %weights: tensor<3x2x2x1xf32>) -> tensor<1x3x5x1xf32> {
+  %one = mhlo.constant dense<1.0> : tensor<f32>
+  %0 = "mhlo.pad"(%inputs, %one) {
+    edge_padding_high = dense<[0, 0, 1, 0]> : tensor<4xi64>,
+    edge_padding_low = dense<[0, 1, 0, 0]> : tensor<4xi64>,
+    interior_padding = dense<0> : tensor<4xi64>
+  } : (tensor<1x4x5x2xf32>, tensor<f32>) -> tensor<1x5x6x2xf32>
+  %1 = "mhlo.convolution"(%0, %weights) {
+    batch_group_count = 1 : i64,
+    dimension_numbers = #mhlo.conv<raw
+      input_batch_dimension = 0,
+      input_feature_dimension = 3,
+      input_spatial_dimensions = [1, 2],
+      kernel_input_feature_dimension = 2,
+      kernel_output_feature_dimension = 3,
+      kernel_spatial_dimensions = [0, 1],
+      output_batch_dimension = 0,
+      output_feature_dimension = 3,
+      output_spatial_dimensions = [1, 2]
+    >,
+    feature_group_count = 1 : i64,
+    rhs_dilation = dense<1> : tensor<2xi64>,
+    window_strides = dense<1> : tensor<2xi64>
+  } : (tensor<1x5x6x2xf32>, tensor<3x2x2x1xf32>) -> tensor<1x3x5x1xf32>
+  return %1 : tensor<1x3x5x1xf32>
+}
@@ -11,6 +11,7 @@
 #include "iree/compiler/ConstEval/Passes.h"
 #include "iree/compiler/Dialect/Flow/Transforms/Passes.h"
 #include "iree/compiler/Dialect/HAL/Transforms/Passes.h"
+#include "iree/compiler/Dialect/Modules/Parameters/Transforms/Passes.h"
 #include "iree/compiler/Dialect/Stream/Transforms/Passes.h"
 #include "iree/compiler/Dialect/Util/Transforms/Passes.h"
 #include "iree/compiler/Dialect/VM/Transforms/Passes.h"
@@ -90,6 +91,22 @@ void HighLevelOptimizationOptions::bindOptions(OptionsBinder &binder) {
                    llvm::cl::desc("Strips debug assertions after any useful "
                                   "information has been extracted."),
                    llvm::cl::cat(category));
+  binder.opt<bool>(
+      "iree-opt-externalize-parameters", externalizeParameters,
+      llvm::cl::desc("Moves large constants out of the module into named "
+                     "parameters loaded at runtime."),
+      llvm::cl::cat(category));
+  binder.opt<int64_t>(
+      "iree-opt-externalize-parameters-minimum-size",
+      externalizeParametersMinimumSize,
+      llvm::cl::desc("Minimum size in bytes of constants to externalize."),
+      llvm::cl::cat(category));
+  binder.opt<std::string>(
+      "iree-opt-externalize-parameters-directory",
+      externalizeParametersDirectory,
+      llvm::cl::desc("Directory externalized parameters are written to as "
+                     "`<name>.bin` files."),
+      llvm::cl::cat(category));
 }
 
 void SchedulingOptions::bindOptions(OptionsBinder &binder) {
@@ -113,6 +130,21 @@ void SchedulingOptions::bindOptions(OptionsBinder &binder) {
                           llvm::cl::desc("File path to write statistics to; or "
                                          "`` for stderr or `-` for stdout."),
                           llvm::cl::cat(category));
+  binder.opt<std::string>(
+      "iree-scheduling-dispatch-profile", dispatchProfileFile,
+      llvm::cl::desc("CSV file of measured dispatch durations (such as from "
+                     "tracy-csvexport) used to guide scheduling."),
+      llvm::cl::cat(category));
+  binder.list<int64_t>(
+      "iree-scheduling-specialize-dynamic-values", specializeDynamicValues,
+      llvm::cl::desc("Values of dynamic dispatch operands (such as shape "
+                     "dimensions) to produce specialized executables for."),
+      llvm::cl::ZeroOrMore, llvm::cl::CommaSeparated, llvm::cl::cat(category));
+  binder.opt<bool>(
+      "iree-scheduling-pack-i4", packI4,
+      llvm::cl::desc("Stores i4 tensors packed two elements per byte instead "
+                     "of widening them to i8."),
+      llvm::cl::cat(category));
 }
 
 void buildIREEVMTransformPassPipeline(
@@ -171,6 +203,18 @@ void buildIREEVMTransformPassPipeline(
   streamOptions.dumpStatisticsFormat =
       (IREE::Stream::DumpOutputFormat)schedulingOptions.dumpStatisticsFormat;
   streamOptions.dumpStatisticsFile = schedulingOptions.dumpStatisticsFile;
+  streamOptions.specializeDynamicValues =
+      schedulingOptions.specializeDynamicValues;
+  streamOptions.dispatchProfileFile = schedulingOptions.dispatchProfileFile;
+  streamOptions.packI4 = schedulingOptions.packI4;
+  if (highLevelOptimizationOptions.externalizeParameters) {
+    streamOptions.buildExternalizeConstantsPassPipeline =
+        [=](OpPassManager &passManager) {
+          passManager.addPass(IREE::Parameters::createExternalizeGlobalsPass(
+              highLevelOptimizationOptions.externalizeParametersMinimumSize,
+              highLevelOptimizationOptions.externalizeParametersDirectory));
+        };
+  }
 
   IREE::Flow::buildFlowTransformPassPipeline(passManager, flowOptions);
   IREE::Stream::buildStreamTransformPassPipeline(passManager, streamOptions);
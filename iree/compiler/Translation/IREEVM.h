@@ -75,6 +75,14 @@ struct HighLevelOptimizationOptions {
   // Strips debug assertions after any useful information has been extracted.
   bool stripAssertions = false;
 
+  // Moves large constants out of the module into named parameters that are
+  // loaded at runtime by the parameters module.
+  bool externalizeParameters = false;
+  // Minimum size in bytes of constants that are externalized.
+  int64_t externalizeParametersMinimumSize = 0;
+  // Directory the externalized parameter contents are written to, if any.
+  std::string externalizeParametersDirectory = "";
+
   void bindOptions(OptionsBinder &binder);
   using FromFlags = OptionsFromFlags<HighLevelOptimizationOptions>;
 };
@@ -102,6 +110,18 @@ struct SchedulingOptions {
   // File path to write statistics to; or `` for stderr or `-` for stdout.
   std::string dumpStatisticsFile = "";
 
+  // Values of dynamic dispatch operands (such as shape dimensions) to
+  // specialize executables for with a runtime switch to the dynamic variants.
+  std::vector<int64_t> specializeDynamicValues;
+
+  // CSV file of measured dispatch durations (such as from tracy-csvexport)
+  // used to balance and order concurrently executable work.
+  std::string dispatchProfileFile = "";
+
+  // Stores i4 tensors packed two elements per byte in memory instead of
+  // widening each element to a byte.
+  bool packI4 = false;
+
   // TODO(benvanik): favor size/speed/etc for partitioning.
   // TODO(benvanik): execution model to optimize for (unified/discrete memory,
   //                 single/multiple processors, etc).
@@ -18,6 +18,8 @@ LogicalResult ParseCustomKernelTargetFeaturesForAarch64(
   for (auto f : features) {
     if (f == "+dotprod") {
       target_info.add(CustomKernelTargetFeature::Aarch64Dotprod);
+    } else if (f == "+bf16") {
+      target_info.add(CustomKernelTargetFeature::Aarch64Bf16);
     } else {
       return failure();
     }
@@ -25,6 +27,32 @@ LogicalResult ParseCustomKernelTargetFeaturesForAarch64(
   return success();
 }
 
+// RISC-V targets commonly list many base extensions (+m, +a, +f, ...) that
+// don't affect kernel selection so unknown features are ignored.
+LogicalResult ParseCustomKernelTargetFeaturesForRiscv64(
+    const llvm::SmallVector<llvm::StringRef> &features,
+    CustomKernelsTargetInfo &target_info) {
+  for (auto f : features) {
+    if (f == "+v") {
+      target_info.add(CustomKernelTargetFeature::RiscvVector);
+    }
+  }
+  return success();
+}
+
+// x86-64 feature lists (such as those produced for `host`) enumerate every
+// extension of the CPU so unknown features are ignored as on RISC-V.
+LogicalResult ParseCustomKernelTargetFeaturesForX86_64(
+    const llvm::SmallVector<llvm::StringRef> &features,
+    CustomKernelsTargetInfo &target_info) {
+  for (auto f : features) {
+    if (f == "+avx512bf16") {
+      target_info.add(CustomKernelTargetFeature::X86_64Avx512Bf16);
+    }
+  }
+  return success();
+}
+
 LogicalResult ParseCustomKernelsTargetInfo(
     llvm::StringRef archStr, llvm::StringRef featuresStr,
     CustomKernelsTargetInfo &target_info) {
@@ -43,6 +71,14 @@ LogicalResult ParseCustomKernelsTargetInfo(
     target_info.init(CustomKernelTargetArch::Aarch64);
     return ParseCustomKernelTargetFeaturesForAarch64(features, target_info);
   }
+  if (archStr == "riscv64") {
+    target_info.init(CustomKernelTargetArch::Riscv64);
+    return ParseCustomKernelTargetFeaturesForRiscv64(features, target_info);
+  }
+  if (archStr == "x86_64") {
+    target_info.init(CustomKernelTargetArch::X86_64);
+    return ParseCustomKernelTargetFeaturesForX86_64(features, target_info);
+  }
 
   return failure();
 }
@@ -18,7 +18,7 @@ namespace iree_compiler {
 
 // Enumerates target ISAs that we care about. 'int8_t' because we somewhat
 // care because this is used in struct MMTKernel, which is passed by value.
-enum class CustomKernelTargetArch : int8_t { None, Aarch64 };
+enum class CustomKernelTargetArch : int8_t { None, Aarch64, Riscv64, X86_64 };
 
 // Enumerates arch-specific target features that we care about.
 // We explicitly want to stick to the default enumeration values (0, 1, 2, ...,
@@ -33,6 +33,11 @@ enum class CustomKernelTargetFeature {
   Intrinsics,
   // Aarch64 features.
   Aarch64Dotprod,
+  Aarch64Bf16,
+  // RISC-V features.
+  RiscvVector,
+  // x86-64 features.
+  X86_64Avx512Bf16,
 };
 
 inline bool isFeatureForArch(CustomKernelTargetFeature feature,
@@ -41,7 +46,12 @@ inline bool isFeatureForArch(CustomKernelTargetFeature feature,
     case CustomKernelTargetFeature::Intrinsics:
       return true;
     case CustomKernelTargetFeature::Aarch64Dotprod:
+    case CustomKernelTargetFeature::Aarch64Bf16:
       return arch == CustomKernelTargetArch::Aarch64;
+    case CustomKernelTargetFeature::RiscvVector:
+      return arch == CustomKernelTargetArch::Riscv64;
+    case CustomKernelTargetFeature::X86_64Avx512Bf16:
+      return arch == CustomKernelTargetArch::X86_64;
   }
   assert(false && "Unhandled CustomKernelTargetFeature value");
   return false;
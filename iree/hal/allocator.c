@@ -36,12 +36,115 @@ IREE_API_EXPORT iree_status_t iree_hal_allocator_statistics_format(
       statistics->device_bytes_freed,
       (statistics->device_bytes_allocated - statistics->device_bytes_freed)));
 
+  // Only pooling allocators report reservations.
+  if (statistics->device_bytes_reserved) {
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_format(
+        builder,
+        "   RESERVED: %12" PRIdsz "B reserved / %12" PRIdsz "B live\n",
+        statistics->device_bytes_reserved,
+        (statistics->device_bytes_allocated - statistics->device_bytes_freed)));
+  }
+
+  // Only allocators with budget information report budgets.
+  if (statistics->device_bytes_budget) {
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_format(
+        builder,
+        "     BUDGET: %12" PRIdsz "B budget / %12" PRIdsz "B usage\n",
+        statistics->device_bytes_budget, statistics->device_bytes_usage));
+  }
+
+  // Only allocators segregating allocations by usage report usage classes.
+  if (statistics->constant_bytes_live || statistics->transient_bytes_live ||
+      statistics->staging_bytes_live) {
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_format(
+        builder,
+        "      POOLS: %12" PRIdsz "B constant / %12" PRIdsz
+        "B transient / %12" PRIdsz "B staging live\n",
+        statistics->constant_bytes_live, statistics->transient_bytes_live,
+        statistics->staging_bytes_live));
+  }
+
+  // Only caching allocators report hits/misses.
+  if (statistics->cache_hit_count || statistics->cache_miss_count) {
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_format(
+        builder,
+        "      CACHE: %12" PRIu64 " hits / %12" PRIu64 " misses\n",
+        statistics->cache_hit_count, statistics->cache_miss_count));
+  }
+
 #else
   // No-op when disabled.
 #endif  // IREE_STATISTICS_ENABLE
   return iree_ok_status();
 }
 
+//===----------------------------------------------------------------------===//
+// Allocation events
+//===----------------------------------------------------------------------===//
+
+#if IREE_STATISTICS_ENABLE
+
+static iree_hal_allocator_event_listener_t iree_hal_allocator_event_listener_ =
+    {NULL, NULL};
+
+IREE_API_EXPORT void iree_hal_allocator_set_event_listener(
+    iree_hal_allocator_event_listener_t listener) {
+  iree_hal_allocator_event_listener_ = listener;
+}
+
+IREE_API_EXPORT bool iree_hal_allocator_has_event_listener(void) {
+  return iree_hal_allocator_event_listener_.fn != NULL;
+}
+
+static void iree_hal_allocator_emit_event(
+    iree_hal_allocator_event_type_t type, const iree_hal_allocator_t* allocator,
+    iree_hal_buffer_t* buffer, iree_string_view_t name) {
+  iree_hal_allocator_event_listener_t listener =
+      iree_hal_allocator_event_listener_;
+  if (IREE_LIKELY(!listener.fn)) return;
+  iree_hal_allocator_event_t event = {
+      .type = type,
+      .timestamp_ns = iree_time_now(),
+      .allocator = allocator,
+      .buffer = buffer,
+      .allocation_size = iree_hal_buffer_allocation_size(buffer),
+      .memory_type = iree_hal_buffer_memory_type(buffer),
+      .allowed_usage = iree_hal_buffer_allowed_usage(buffer),
+      .name = name,
+  };
+  listener.fn(listener.user_data, &event);
+}
+
+IREE_API_EXPORT void iree_hal_allocator_name_buffer(iree_hal_buffer_t* buffer,
+                                                    iree_string_view_t name) {
+  IREE_ASSERT_ARGUMENT(buffer);
+  iree_hal_buffer_t* allocated_buffer =
+      iree_hal_buffer_allocated_buffer(buffer);
+  iree_hal_allocator_emit_event(IREE_HAL_ALLOCATOR_EVENT_TYPE_NAME,
+                                allocated_buffer->device_allocator,
+                                allocated_buffer, name);
+}
+
+#else
+
+IREE_API_EXPORT void iree_hal_allocator_set_event_listener(
+    iree_hal_allocator_event_listener_t listener) {}
+
+IREE_API_EXPORT bool iree_hal_allocator_has_event_listener(void) {
+  return false;
+}
+
+#define iree_hal_allocator_emit_event(...)
+
+IREE_API_EXPORT void iree_hal_allocator_name_buffer(iree_hal_buffer_t* buffer,
+                                                    iree_string_view_t name) {}
+
+#endif  // IREE_STATISTICS_ENABLE
+
+//===----------------------------------------------------------------------===//
+// iree_hal_allocator_t
+//===----------------------------------------------------------------------===//
+
 #define _VTABLE_DISPATCH(allocator, method_name) \
   IREE_HAL_VTABLE_DISPATCH(allocator, iree_hal_allocator, method_name)
 
@@ -126,6 +229,11 @@ IREE_API_EXPORT iree_status_t iree_hal_allocator_allocate_buffer(
   iree_status_t status = _VTABLE_DISPATCH(allocator, allocate_buffer)(
       allocator, memory_type, allowed_usage, allocation_size, initial_data,
       out_buffer);
+  if (iree_status_is_ok(status)) {
+    iree_hal_allocator_emit_event(IREE_HAL_ALLOCATOR_EVENT_TYPE_ALLOCATE,
+                                  allocator, *out_buffer,
+                                  iree_string_view_empty());
+  }
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
@@ -135,6 +243,8 @@ IREE_API_EXPORT void iree_hal_allocator_deallocate_buffer(
   IREE_ASSERT_ARGUMENT(allocator);
   IREE_ASSERT_ARGUMENT(buffer);
   IREE_TRACE_ZONE_BEGIN(z0);
+  iree_hal_allocator_emit_event(IREE_HAL_ALLOCATOR_EVENT_TYPE_DEALLOCATE,
+                                allocator, buffer, iree_string_view_empty());
   _VTABLE_DISPATCH(allocator, deallocate_buffer)(allocator, buffer);
   IREE_TRACE_ZONE_END(z0);
 }
@@ -151,6 +261,11 @@ IREE_API_EXPORT iree_status_t iree_hal_allocator_wrap_buffer(
   iree_status_t status = _VTABLE_DISPATCH(allocator, wrap_buffer)(
       allocator, memory_type, allowed_access, allowed_usage, data,
       data_allocator, out_buffer);
+  if (iree_status_is_ok(status)) {
+    iree_hal_allocator_emit_event(IREE_HAL_ALLOCATOR_EVENT_TYPE_ALLOCATE,
+                                  allocator, *out_buffer,
+                                  iree_string_view_empty());
+  }
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
@@ -169,6 +284,11 @@ IREE_API_EXPORT iree_status_t iree_hal_allocator_import_buffer(
   iree_status_t status = _VTABLE_DISPATCH(allocator, import_buffer)(
       allocator, memory_type, allowed_access, allowed_usage, external_buffer,
       out_buffer);
+  if (iree_status_is_ok(status)) {
+    iree_hal_allocator_emit_event(IREE_HAL_ALLOCATOR_EVENT_TYPE_ALLOCATE,
+                                  allocator, *out_buffer,
+                                  iree_string_view_empty());
+  }
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
@@ -119,6 +119,18 @@ typedef enum iree_hal_external_buffer_type_e {
   //  Uses VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_WIN32_BIT.
   IREE_HAL_EXTERNAL_BUFFER_TYPE_OPAQUE_WIN32 = 3,
 
+  // A driver/device-specific device memory allocation, such as a pointer
+  // returned by a native device allocation API or exported from another device
+  // of the same driver. An imported/exported buffer does not own a reference
+  // to the memory and the caller is responsible for ensuring the memory
+  // remains live for as long as the iree_hal_buffer_t referencing it.
+  //
+  // CUDA:
+  //  A CUdeviceptr within the unified address space. Allocations owned by
+  //  another device may be imported once peer access has been enabled (see
+  //  iree_hal_cuda_device_enable_peer_access).
+  IREE_HAL_EXTERNAL_BUFFER_TYPE_DEVICE_ALLOCATION = 4,
+
   // TODO(benvanik): additional memory types:
   //  shared memory fd (shmem)/mapped file
   //  VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT
@@ -149,6 +161,11 @@ typedef struct iree_hal_external_buffer_t {
       // Host memory pointer.
       void* ptr;
     } host_allocation;
+    // IREE_HAL_EXTERNAL_BUFFER_TYPE_DEVICE_ALLOCATION
+    struct {
+      // Device memory pointer.
+      uint64_t ptr;
+    } device_allocation;
     // IREE_HAL_EXTERNAL_BUFFER_TYPE_OPAQUE_FD
     struct {
       int fd;
@@ -173,6 +190,29 @@ typedef struct iree_hal_allocator_statistics_t {
   iree_device_size_t device_bytes_peak;
   iree_device_size_t device_bytes_allocated;
   iree_device_size_t device_bytes_freed;
+  // Number of allocations serviced by a caching allocator from previously
+  // released buffers without calling into the underlying allocator.
+  uint64_t cache_hit_count;
+  // Number of cacheable allocations that had to be serviced by the underlying
+  // allocator.
+  uint64_t cache_miss_count;
+  // Bytes of device memory currently reserved by pooling allocators. This
+  // includes memory released back to the pool and retained for reuse and as
+  // such may exceed the live (allocated - freed) byte count. 0 for allocators
+  // that do not pool.
+  iree_device_size_t device_bytes_reserved;
+  // Bytes of device memory the process may use before allocations fail and
+  // the bytes of it currently in use by the process (including other
+  // allocators) as reported by the implementation, such as with
+  // VK_EXT_memory_budget. 0 if unknown.
+  iree_device_size_t device_bytes_budget;
+  iree_device_size_t device_bytes_usage;
+  // Live bytes of allocations serviced from pools dedicated to each usage
+  // class by allocators that segregate allocations by usage. 0 for allocators
+  // that do not.
+  iree_device_size_t constant_bytes_live;
+  iree_device_size_t transient_bytes_live;
+  iree_device_size_t staging_bytes_live;
   // TODO(benvanik): mapping information (discarded, mapping ranges,
   //                 flushed/invalidated, etc).
 #else
@@ -185,6 +225,68 @@ IREE_API_EXPORT iree_status_t iree_hal_allocator_statistics_format(
     const iree_hal_allocator_statistics_t* statistics,
     iree_string_builder_t* builder);
 
+//===----------------------------------------------------------------------===//
+// Allocation events
+//===----------------------------------------------------------------------===//
+
+// Identifies the kind of an allocation event.
+typedef enum iree_hal_allocator_event_type_e {
+  // A buffer was allocated, wrapped, or imported by an allocator.
+  IREE_HAL_ALLOCATOR_EVENT_TYPE_ALLOCATE = 0,
+  // A buffer previously reported as allocated was returned to its allocator.
+  IREE_HAL_ALLOCATOR_EVENT_TYPE_DEALLOCATE = 1,
+  // A name was associated with a live buffer by its user, such as the program
+  // location that requested the allocation. See iree_hal_allocator_name_buffer.
+  IREE_HAL_ALLOCATOR_EVENT_TYPE_NAME = 2,
+} iree_hal_allocator_event_type_t;
+
+// An allocation event reported to the allocation event listener.
+typedef struct iree_hal_allocator_event_t {
+  iree_hal_allocator_event_type_t type;
+  // Host time the event occurred at.
+  iree_time_t timestamp_ns;
+  // Allocator the event occurred on. Allocators that wrap other allocators
+  // (such as the caching allocator) report events for the buffers they return
+  // while the underlying allocator reports the buffers it actually allocates.
+  const iree_hal_allocator_t* allocator;
+  // Buffer the event applies to. Only valid for identity comparison as the
+  // buffer may be in the process of being allocated or freed.
+  const iree_hal_buffer_t* buffer;
+  // Properties of the buffer at the time of allocation.
+  iree_device_size_t allocation_size;
+  iree_hal_memory_type_t memory_type;
+  iree_hal_buffer_usage_t allowed_usage;
+  // Name associated with the buffer for IREE_HAL_ALLOCATOR_EVENT_TYPE_NAME.
+  // Only valid for the duration of the listener callback.
+  iree_string_view_t name;
+} iree_hal_allocator_event_t;
+
+// Receives allocation events from all allocators in the process.
+// Events may be reported from any thread and the listener is responsible for
+// its own synchronization.
+typedef struct iree_hal_allocator_event_listener_t {
+  void(IREE_API_PTR* fn)(void* user_data,
+                         const iree_hal_allocator_event_t* event);
+  void* user_data;
+} iree_hal_allocator_event_listener_t;
+
+// Sets the process-wide |listener| receiving allocation events from every
+// allocator. Pass a listener with a NULL fn to stop listening.
+// Not thread-safe: must only be called while no allocators are in use.
+//
+// NOTE: events are compiled out when IREE_STATISTICS_ENABLE is 0.
+IREE_API_EXPORT void iree_hal_allocator_set_event_listener(
+    iree_hal_allocator_event_listener_t listener);
+
+// Returns true if an allocation event listener is set. Can be used to avoid
+// producing names for iree_hal_allocator_name_buffer when no one is listening.
+IREE_API_EXPORT bool iree_hal_allocator_has_event_listener(void);
+
+// Reports an IREE_HAL_ALLOCATOR_EVENT_TYPE_NAME event associating |name| with
+// the allocated |buffer|. No-op if no listener is set.
+IREE_API_EXPORT void iree_hal_allocator_name_buffer(iree_hal_buffer_t* buffer,
+                                                    iree_string_view_t name);
+
 //===----------------------------------------------------------------------===//
 // iree_hal_allocator_t
 //===----------------------------------------------------------------------===//
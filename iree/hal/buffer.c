@@ -74,17 +74,27 @@ IREE_API_EXPORT iree_string_view_t iree_hal_buffer_usage_format(
 // Subspan indirection buffer
 //===----------------------------------------------------------------------===//
 
+typedef struct iree_hal_subspan_buffer_t {
+  iree_hal_buffer_t base;
+  // Optional buffer owning the range of the allocated buffer referenced by the
+  // subspan, such as a block suballocated from a larger allocation that is
+  // reused once released. Retained so that the range stays reserved for as
+  // long as the subspan is live.
+  iree_hal_buffer_t* owner_buffer;
+} iree_hal_subspan_buffer_t;
+
 static const iree_hal_buffer_vtable_t iree_hal_subspan_buffer_vtable;
 
-IREE_API_EXPORT iree_status_t iree_hal_subspan_buffer_create(
-    iree_hal_buffer_t* allocated_buffer, iree_device_size_t byte_offset,
-    iree_device_size_t byte_length, iree_hal_allocator_t* device_allocator,
-    iree_allocator_t host_allocator, iree_hal_buffer_t** out_buffer) {
+static iree_status_t iree_hal_subspan_buffer_create_with_owner(
+    iree_hal_buffer_t* allocated_buffer, iree_hal_buffer_t* owner_buffer,
+    iree_device_size_t byte_offset, iree_device_size_t byte_length,
+    iree_hal_allocator_t* device_allocator, iree_allocator_t host_allocator,
+    iree_hal_buffer_t** out_buffer) {
   IREE_ASSERT_ARGUMENT(allocated_buffer);
   IREE_ASSERT_ARGUMENT(out_buffer);
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  iree_hal_buffer_t* buffer = NULL;
+  iree_hal_subspan_buffer_t* buffer = NULL;
   iree_status_t status =
       iree_allocator_malloc(host_allocator, sizeof(*buffer), (void**)&buffer);
   if (iree_status_is_ok(status)) {
@@ -93,20 +103,47 @@ IREE_API_EXPORT iree_status_t iree_hal_subspan_buffer_create(
         allocated_buffer->allocation_size, byte_offset, byte_length,
         allocated_buffer->memory_type, allocated_buffer->allowed_access,
         allocated_buffer->allowed_usage, &iree_hal_subspan_buffer_vtable,
-        buffer);
-    *out_buffer = buffer;
+        &buffer->base);
+    buffer->owner_buffer = owner_buffer;
+    iree_hal_buffer_retain(owner_buffer);
+    *out_buffer = &buffer->base;
   }
 
   IREE_TRACE_ZONE_END(z0);
-  return iree_ok_status();
+  return status;
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_subspan_buffer_create(
+    iree_hal_buffer_t* allocated_buffer, iree_device_size_t byte_offset,
+    iree_device_size_t byte_length, iree_hal_allocator_t* device_allocator,
+    iree_allocator_t host_allocator, iree_hal_buffer_t** out_buffer) {
+  return iree_hal_subspan_buffer_create_with_owner(
+      allocated_buffer, /*owner_buffer=*/NULL, byte_offset, byte_length,
+      device_allocator, host_allocator, out_buffer);
+}
+
+// Returns the buffer that owns the range of its allocated buffer referenced by
+// |buffer| or NULL if the range needs no owner beyond the allocated buffer.
+static iree_hal_buffer_t* iree_hal_buffer_range_owner(
+    iree_hal_buffer_t* buffer) {
+  if (buffer->allocated_buffer == buffer) return NULL;
+  // Buffers returned to an allocator when released (such as suballocated
+  // blocks) own their range while plain subspans forward their owner.
+  if (!buffer->device_allocator &&
+      buffer->resource.vtable == &iree_hal_subspan_buffer_vtable) {
+    return ((iree_hal_subspan_buffer_t*)buffer)->owner_buffer;
+  }
+  return buffer;
 }
 
 static void iree_hal_subspan_buffer_destroy(iree_hal_buffer_t* base_buffer) {
+  iree_hal_subspan_buffer_t* buffer = (iree_hal_subspan_buffer_t*)base_buffer;
   iree_allocator_t host_allocator = base_buffer->host_allocator;
   IREE_TRACE_ZONE_BEGIN(z0);
 
   iree_hal_buffer_release(base_buffer->allocated_buffer);
-  iree_allocator_free(host_allocator, base_buffer);
+  iree_hal_buffer_release(buffer->owner_buffer);
+  iree_allocator_free(host_allocator, buffer);
 
   IREE_TRACE_ZONE_END(z0);
 }
@@ -412,6 +449,15 @@ IREE_API_EXPORT iree_status_t iree_hal_buffer_subspan(
     iree_hal_buffer_t* buffer, iree_device_size_t byte_offset,
     iree_device_size_t byte_length, iree_hal_buffer_t** out_buffer) {
   IREE_ASSERT_ARGUMENT(buffer);
+  return iree_hal_buffer_subspan_with_allocator(
+      buffer, byte_offset, byte_length, buffer->host_allocator, out_buffer);
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_buffer_subspan_with_allocator(
+    iree_hal_buffer_t* buffer, iree_device_size_t byte_offset,
+    iree_device_size_t byte_length, iree_allocator_t host_allocator,
+    iree_hal_buffer_t** out_buffer) {
+  IREE_ASSERT_ARGUMENT(buffer);
   IREE_ASSERT_ARGUMENT(out_buffer);
   *out_buffer = NULL;
 
@@ -429,17 +475,21 @@ IREE_API_EXPORT iree_status_t iree_hal_buffer_subspan(
   // To avoid heavy nesting of subspans that just add indirection we go to the
   // parent buffer directly. If we wanted better accounting (to track where
   // buffers came from) we'd want to avoid this but I'm not sure that's worth
-  // the super deep indirection that could arise.
+  // the super deep indirection that could arise. The owner of the range in the
+  // parent is retained instead so that it is not reused while the new subspan
+  // is live.
   iree_hal_buffer_t* allocated_buffer =
       iree_hal_buffer_allocated_buffer(buffer);
-  if (allocated_buffer != buffer) {
-    return iree_hal_buffer_subspan(allocated_buffer, byte_offset, byte_length,
-                                   out_buffer);
+  iree_hal_buffer_t* owner_buffer = iree_hal_buffer_range_owner(buffer);
+  if (!owner_buffer && byte_offset == 0 &&
+      byte_length == iree_hal_buffer_byte_length(allocated_buffer)) {
+    iree_hal_buffer_retain(allocated_buffer);
+    *out_buffer = allocated_buffer;
+    return iree_ok_status();
   }
-
-  return iree_hal_subspan_buffer_create(buffer, byte_offset, byte_length,
-                                        /*device_allocator=*/NULL,
-                                        buffer->host_allocator, out_buffer);
+  return iree_hal_subspan_buffer_create_with_owner(
+      allocated_buffer, owner_buffer, byte_offset, byte_length,
+      /*device_allocator=*/NULL, host_allocator, out_buffer);
 }
 
 IREE_API_EXPORT iree_hal_buffer_t* iree_hal_buffer_allocated_buffer(
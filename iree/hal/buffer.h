@@ -333,6 +333,15 @@ IREE_API_EXPORT iree_status_t iree_hal_buffer_subspan(
     iree_hal_buffer_t* buffer, iree_device_size_t byte_offset,
     iree_device_size_t byte_length, iree_hal_buffer_t** out_buffer);
 
+// Returns a reference to a subspan of the |buffer| as with
+// iree_hal_buffer_subspan but allocates any new subspan buffer from
+// |host_allocator| instead of the allocator of |buffer|. Callers creating many
+// short-lived subspans can use this to allocate them from a pool.
+IREE_API_EXPORT iree_status_t iree_hal_buffer_subspan_with_allocator(
+    iree_hal_buffer_t* buffer, iree_device_size_t byte_offset,
+    iree_device_size_t byte_length, iree_allocator_t host_allocator,
+    iree_hal_buffer_t** out_buffer);
+
 // Retains the given |buffer| for the caller.
 IREE_API_EXPORT void iree_hal_buffer_retain(iree_hal_buffer_t* buffer);
 
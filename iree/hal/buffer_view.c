@@ -43,8 +43,7 @@ IREE_API_EXPORT iree_status_t iree_hal_buffer_view_create(
   // Note that we have the dynamically-sized shape dimensions on the end.
   iree_hal_buffer_view_t* buffer_view = NULL;
   iree_status_t status = iree_allocator_malloc(
-      host_allocator,
-      sizeof(*buffer_view) + sizeof(iree_hal_dim_t) * shape_rank,
+      host_allocator, iree_hal_buffer_view_allocation_size(shape_rank),
       (void**)&buffer_view);
   if (iree_status_is_ok(status)) {
     iree_atomic_ref_count_init(&buffer_view->ref_count);
@@ -67,6 +66,11 @@ IREE_API_EXPORT iree_status_t iree_hal_buffer_view_create(
   return status;
 }
 
+IREE_API_EXPORT iree_host_size_t
+iree_hal_buffer_view_allocation_size(iree_host_size_t shape_rank) {
+  return sizeof(iree_hal_buffer_view_t) + sizeof(iree_hal_dim_t) * shape_rank;
+}
+
 IREE_API_EXPORT void iree_hal_buffer_view_retain(
     iree_hal_buffer_view_t* buffer_view) {
   if (IREE_LIKELY(buffer_view)) {
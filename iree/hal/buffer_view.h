@@ -174,6 +174,12 @@ IREE_API_EXPORT iree_status_t iree_hal_buffer_view_create(
     iree_hal_encoding_type_t encoding_type, iree_allocator_t host_allocator,
     iree_hal_buffer_view_t** out_buffer_view);
 
+// Returns the number of bytes allocated from the host allocator for a buffer
+// view with |shape_rank| dimensions. The shape is stored inline with the view
+// so pools sized for a small rank can recycle all views up to that rank.
+IREE_API_EXPORT iree_host_size_t
+iree_hal_buffer_view_allocation_size(iree_host_size_t shape_rank);
+
 // Retains the given |buffer_view| for the caller.
 IREE_API_EXPORT void iree_hal_buffer_view_retain(
     iree_hal_buffer_view_t* buffer_view);
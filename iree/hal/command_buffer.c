@@ -39,9 +39,12 @@ iree_hal_command_buffer_mode_format(iree_hal_command_buffer_mode_t value,
                                     iree_bitfield_string_temp_t* out_temp) {
   static const iree_bitfield_string_mapping_t mappings[] = {
       {IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT, IREE_SVL("ONE_SHOT")},
+      {IREE_HAL_COMMAND_BUFFER_MODE_REUSABLE, IREE_SVL("REUSABLE")},
       {IREE_HAL_COMMAND_BUFFER_MODE_ALLOW_INLINE_EXECUTION,
        IREE_SVL("ALLOW_INLINE_EXECUTION")},
       {IREE_HAL_COMMAND_BUFFER_MODE_UNVALIDATED, IREE_SVL("UNVALIDATED")},
+      {IREE_HAL_COMMAND_BUFFER_MODE_INDIRECT_BINDINGS,
+       IREE_SVL("INDIRECT_BINDINGS")},
   };
   return iree_bitfield_format_inline(value, mappings, IREE_ARRAYSIZE(mappings),
                                      out_temp);
@@ -93,6 +96,13 @@ IREE_API_EXPORT iree_status_t iree_hal_command_buffer_create(
   IREE_ASSERT_ARGUMENT(out_command_buffer);
   *out_command_buffer = NULL;
 
+  if (iree_all_bits_set(mode, IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT |
+                                  IREE_HAL_COMMAND_BUFFER_MODE_REUSABLE)) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "command buffers cannot be both one-shot and reusable");
+  }
+
   if (iree_all_bits_set(mode,
                         IREE_HAL_COMMAND_BUFFER_MODE_ALLOW_INLINE_EXECUTION)) {
     // Inline command buffers must be one-shot and primary.
@@ -101,6 +111,13 @@ IREE_API_EXPORT iree_status_t iree_hal_command_buffer_create(
           IREE_STATUS_INVALID_ARGUMENT,
           "inline command buffers must be one-shot and primary");
     }
+    // Inline command buffers execute before the binding table is available.
+    if (iree_all_bits_set(mode,
+                          IREE_HAL_COMMAND_BUFFER_MODE_INDIRECT_BINDINGS)) {
+      return iree_make_status(
+          IREE_STATUS_INVALID_ARGUMENT,
+          "inline command buffers cannot use indirect bindings");
+    }
   }
 
   IREE_TRACE_ZONE_BEGIN(z0);
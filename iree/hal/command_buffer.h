@@ -36,7 +36,15 @@ enum iree_hal_command_buffer_mode_bits_t {
   // when it's known that command buffers will not be reused.
   IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT = 1u << 0,
 
-  // TODO(benvanik): IREE_HAL_COMMAND_BUFFER_MODE_REUSABLE = 1u << 1,
+  // Command buffer may be submitted multiple times once recorded.
+  // Implementations may build their execution structures once at the end of
+  // recording and reset them in place on each submission. Submissions of the
+  // same command buffer must not overlap in execution: a resubmission must be
+  // ordered after the completion of the prior one (such as via a semaphore).
+  //
+  // Mutually exclusive with IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT.
+  IREE_HAL_COMMAND_BUFFER_MODE_REUSABLE = 1u << 1,
+
   // TODO(benvanik): IREE_HAL_COMMAND_BUFFER_MODE_PRIMARY = 1u << 2,
   // TODO(benvanik): IREE_HAL_COMMAND_BUFFER_MODE_SECONDARY = 1u << 3,
 
@@ -66,6 +74,15 @@ enum iree_hal_command_buffer_mode_bits_t {
   // `IREE_HAL_COMMAND_BUFFER_VALIDATION_ENABLE=1` - if shimming command buffers
   // or performing replay this validation can be disabled per-command buffer.
   IREE_HAL_COMMAND_BUFFER_MODE_UNVALIDATED = 1u << 5,
+
+  // Descriptor set bindings with a NULL buffer reference a slot in the binding
+  // table provided with each submission of the command buffer instead of a
+  // buffer captured at recording time. This allows a command buffer to be
+  // recorded once and executed against different buffers each submission.
+  // See iree_hal_descriptor_set_binding_t::buffer_slot.
+  //
+  // Incompatible with IREE_HAL_COMMAND_BUFFER_MODE_ALLOW_INLINE_EXECUTION.
+  IREE_HAL_COMMAND_BUFFER_MODE_INDIRECT_BINDINGS = 1u << 6,
 };
 typedef uint32_t iree_hal_command_buffer_mode_t;
 
@@ -124,6 +141,18 @@ typedef uint32_t iree_hal_execution_stage_t;
 // Maps to VkDependencyFlags.
 enum iree_hal_execution_barrier_flag_bits_t {
   IREE_HAL_EXECUTION_BARRIER_FLAG_NONE = 0,
+
+  // The barrier only orders each workgroup of the dispatch recorded
+  // immediately after it against the workgroup with the same index in the
+  // dispatch recorded immediately before it. Both dispatches must have the same
+  // workgroup count and no other commands may be recorded between them or
+  // alongside them (since the previous barrier).
+  //
+  // This lets implementations start consumer workgroups as soon as their
+  // producer workgroups complete instead of waiting for the entire producer
+  // dispatch. Implementations that cannot take advantage of it (or barriers
+  // where the above does not hold) treat it as a full execution barrier.
+  IREE_HAL_EXECUTION_BARRIER_FLAG_WORKGROUP_LOCAL = 1u << 1,
 };
 typedef uint32_t iree_hal_execution_barrier_flags_t;
 
@@ -188,6 +217,35 @@ typedef struct iree_hal_buffer_barrier_t {
   iree_device_size_t length;
 } iree_hal_buffer_barrier_t;
 
+// A buffer range in a binding table referenced by indirect command buffer
+// bindings. The range of the command buffer binding is applied relative to the
+// range specified here.
+typedef struct iree_hal_buffer_binding_t {
+  // Buffer bound to the slot. May be NULL if the slot is not used.
+  iree_hal_buffer_t* buffer;
+  // Offset, in bytes, into the buffer that the slot starts at.
+  iree_device_size_t offset;
+  // Length, in bytes, of the buffer range available to commands or
+  // IREE_WHOLE_BUFFER.
+  iree_device_size_t length;
+} iree_hal_buffer_binding_t;
+
+// A table of buffer ranges resolved at submission time by command buffers
+// recorded with IREE_HAL_COMMAND_BUFFER_MODE_INDIRECT_BINDINGS.
+// The table and its buffers need only remain valid until the submission it is
+// provided with has been issued; implementations retain what they need.
+typedef struct iree_hal_buffer_binding_table_t {
+  iree_host_size_t count;
+  const iree_hal_buffer_binding_t* bindings;
+} iree_hal_buffer_binding_table_t;
+
+// Returns an empty binding table.
+static inline iree_hal_buffer_binding_table_t
+iree_hal_buffer_binding_table_empty(void) {
+  iree_hal_buffer_binding_table_t table = {0, NULL};
+  return table;
+}
+
 // An RGBA color.
 typedef struct iree_hal_label_color_t {
   uint8_t r;
@@ -7,6 +7,8 @@
 #ifndef IREE_HAL_CTS_ALLOCATOR_TEST_H_
 #define IREE_HAL_CTS_ALLOCATOR_TEST_H_
 
+#include <cstring>
+
 #include "iree/base/api.h"
 #include "iree/hal/api.h"
 #include "iree/hal/cts/cts_test_base.h"
@@ -114,6 +116,54 @@ TEST_P(allocator_test, AllocateEmptyBuffer) {
   iree_hal_buffer_release(buffer);
 }
 
+// Device allocations exported from an allocator can be imported back as a
+// buffer aliasing the same memory. Optional; skipped if unsupported.
+TEST_P(allocator_test, ExportImportDeviceAllocation) {
+  uint8_t initial_data[kAllocationSize];
+  memset(initial_data, 0xAB, sizeof(initial_data));
+  iree_hal_buffer_t* buffer = NULL;
+  IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+      device_allocator_, IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL,
+      IREE_HAL_BUFFER_USAGE_TRANSFER, kAllocationSize,
+      iree_make_const_byte_span(initial_data, sizeof(initial_data)), &buffer));
+
+  iree_hal_external_buffer_t external_buffer;
+  iree_status_t status = iree_hal_allocator_export_buffer(
+      device_allocator_, buffer,
+      IREE_HAL_EXTERNAL_BUFFER_TYPE_DEVICE_ALLOCATION,
+      IREE_HAL_EXTERNAL_BUFFER_FLAG_NONE, &external_buffer);
+  if (iree_status_is_unavailable(status)) {
+    iree_status_ignore(status);
+    iree_hal_buffer_release(buffer);
+    GTEST_SKIP() << "device allocation export not supported by the allocator";
+  }
+  IREE_ASSERT_OK(status);
+  EXPECT_EQ(external_buffer.size, iree_hal_buffer_byte_length(buffer));
+
+  iree_hal_buffer_t* imported_buffer = NULL;
+  IREE_ASSERT_OK(iree_hal_allocator_import_buffer(
+      device_allocator_, IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL,
+      IREE_HAL_MEMORY_ACCESS_ALL, IREE_HAL_BUFFER_USAGE_TRANSFER,
+      &external_buffer, &imported_buffer));
+  EXPECT_EQ(iree_hal_buffer_byte_length(imported_buffer), kAllocationSize);
+
+  // Contents written through the original buffer are visible through the
+  // imported one.
+  uint8_t readback_data[kAllocationSize];
+  memset(readback_data, 0, sizeof(readback_data));
+  IREE_ASSERT_OK(iree_hal_device_transfer_range(
+      device_, iree_hal_make_device_transfer_buffer(imported_buffer), 0,
+      iree_hal_make_host_transfer_buffer_span(readback_data,
+                                              sizeof(readback_data)),
+      0, sizeof(readback_data), IREE_HAL_TRANSFER_BUFFER_FLAG_DEFAULT,
+      iree_infinite_timeout()));
+  EXPECT_EQ(0, memcmp(initial_data, readback_data, sizeof(initial_data)));
+
+  // The imported buffer does not own the memory and must be released first.
+  iree_hal_buffer_release(imported_buffer);
+  iree_hal_buffer_release(buffer);
+}
+
 }  // namespace cts
 }  // namespace hal
 }  // namespace iree
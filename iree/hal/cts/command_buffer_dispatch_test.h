@@ -7,6 +7,8 @@
 #ifndef IREE_HAL_CTS_COMMAND_BUFFER_DISPATCH_TEST_H_
 #define IREE_HAL_CTS_COMMAND_BUFFER_DISPATCH_TEST_H_
 
+#include <cmath>
+
 #include "iree/base/api.h"
 #include "iree/base/string_view.h"
 #include "iree/hal/api.h"
@@ -96,9 +98,11 @@ TEST_P(command_buffer_dispatch_test, DispatchAbs) {
       sizeof(float), iree_const_byte_span_empty(), &output_buffer));
 
   iree_hal_descriptor_set_binding_t descriptor_set_bindings[] = {
-      {/*binding=*/0, iree_hal_buffer_view_buffer(input_buffer_view),
+      {/*binding=*/0, /*buffer_slot=*/0,
+       iree_hal_buffer_view_buffer(input_buffer_view),
        /*offset=*/0, iree_hal_buffer_view_byte_length(input_buffer_view)},
-      {/*binding=*/1, output_buffer, iree_hal_buffer_byte_offset(output_buffer),
+      {/*binding=*/1, /*buffer_slot=*/0, output_buffer,
+       iree_hal_buffer_byte_offset(output_buffer),
        iree_hal_buffer_byte_length(output_buffer)},
   };
 
@@ -136,6 +140,146 @@ TEST_P(command_buffer_dispatch_test, DispatchAbs) {
   CleanupExecutable();
 }
 
+// Chains two dispatches with a workgroup-local barrier: the second reads the
+// result of the first and must observe it whether or not the device pipelines
+// the workgroups of the two dispatches.
+TEST_P(command_buffer_dispatch_test, DispatchAbsWorkgroupLocalBarrier) {
+  PrepareAbsExecutable();
+
+  iree_hal_command_buffer_t* command_buffer;
+  IREE_ASSERT_OK(iree_hal_command_buffer_create(
+      device_, IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT,
+      IREE_HAL_COMMAND_CATEGORY_DISPATCH, IREE_HAL_QUEUE_AFFINITY_ANY,
+      &command_buffer));
+
+  IREE_ASSERT_OK(iree_hal_command_buffer_begin(command_buffer));
+
+  float input_data[1] = {-2.5f};
+  iree_hal_buffer_t* buffers[3] = {NULL, NULL, NULL};
+  for (int i = 0; i < IREE_ARRAYSIZE(buffers); ++i) {
+    IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+        device_allocator_,
+        IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE,
+        IREE_HAL_BUFFER_USAGE_DISPATCH | IREE_HAL_BUFFER_USAGE_TRANSFER |
+            IREE_HAL_BUFFER_USAGE_MAPPING,
+        sizeof(float),
+        i == 0 ? iree_make_const_byte_span(input_data, sizeof(input_data))
+               : iree_const_byte_span_empty(),
+        &buffers[i]));
+  }
+
+  for (int i = 0; i < 2; ++i) {
+    iree_hal_descriptor_set_binding_t descriptor_set_bindings[] = {
+        {/*binding=*/0, /*buffer_slot=*/0, buffers[i], /*offset=*/0,
+         sizeof(float)},
+        {/*binding=*/1, /*buffer_slot=*/0, buffers[i + 1], /*offset=*/0,
+         sizeof(float)},
+    };
+    IREE_ASSERT_OK(iree_hal_command_buffer_push_descriptor_set(
+        command_buffer, executable_layout_, /*set=*/0,
+        IREE_ARRAYSIZE(descriptor_set_bindings), descriptor_set_bindings));
+    IREE_ASSERT_OK(iree_hal_command_buffer_dispatch(
+        command_buffer, executable_, /*entry_point=*/0,
+        /*workgroup_x=*/1, /*workgroup_y=*/1, /*workgroup_z=*/1));
+    IREE_ASSERT_OK(iree_hal_command_buffer_execution_barrier(
+        command_buffer,
+        /*source_stage_mask=*/IREE_HAL_EXECUTION_STAGE_DISPATCH,
+        /*target_stage_mask=*/IREE_HAL_EXECUTION_STAGE_DISPATCH,
+        IREE_HAL_EXECUTION_BARRIER_FLAG_WORKGROUP_LOCAL,
+        /*memory_barrier_count=*/0, /*memory_barriers=*/NULL,
+        /*buffer_barrier_count=*/0, /*buffer_barriers=*/NULL));
+  }
+
+  IREE_ASSERT_OK(iree_hal_command_buffer_end(command_buffer));
+
+  IREE_ASSERT_OK(SubmitCommandBufferAndWait(IREE_HAL_COMMAND_CATEGORY_DISPATCH,
+                                            command_buffer));
+
+  float out_value;
+  IREE_ASSERT_OK(iree_hal_buffer_read_data(buffers[2], /*source_offset=*/0,
+                                           &out_value, sizeof(out_value)));
+  EXPECT_EQ(2.5f, out_value);
+
+  iree_hal_command_buffer_release(command_buffer);
+  for (int i = 0; i < IREE_ARRAYSIZE(buffers); ++i) {
+    iree_hal_buffer_release(buffers[i]);
+  }
+  CleanupExecutable();
+}
+
+TEST_P(command_buffer_dispatch_test, DispatchAbsIndirectBindings) {
+  iree_hal_command_buffer_t* command_buffer = NULL;
+  iree_status_t status = iree_hal_command_buffer_create(
+      device_,
+      IREE_HAL_COMMAND_BUFFER_MODE_REUSABLE |
+          IREE_HAL_COMMAND_BUFFER_MODE_INDIRECT_BINDINGS,
+      IREE_HAL_COMMAND_CATEGORY_DISPATCH, IREE_HAL_QUEUE_AFFINITY_ANY,
+      &command_buffer);
+  if (iree_status_is_unimplemented(status)) {
+    iree_status_free(status);
+    GTEST_SKIP() << "indirect bindings not supported by the device";
+  }
+  IREE_ASSERT_OK(status);
+
+  PrepareAbsExecutable();
+
+  // Record the dispatch once with both bindings referencing the binding table.
+  IREE_ASSERT_OK(iree_hal_command_buffer_begin(command_buffer));
+  iree_hal_descriptor_set_binding_t descriptor_set_bindings[] = {
+      {/*binding=*/0, /*buffer_slot=*/0, /*buffer=*/NULL, /*offset=*/0,
+       /*length=*/sizeof(float)},
+      {/*binding=*/1, /*buffer_slot=*/1, /*buffer=*/NULL, /*offset=*/0,
+       /*length=*/sizeof(float)},
+  };
+  IREE_ASSERT_OK(iree_hal_command_buffer_push_descriptor_set(
+      command_buffer, executable_layout_, /*set=*/0,
+      IREE_ARRAYSIZE(descriptor_set_bindings), descriptor_set_bindings));
+  IREE_ASSERT_OK(iree_hal_command_buffer_dispatch(
+      command_buffer, executable_, /*entry_point=*/0,
+      /*workgroup_x=*/1, /*workgroup_y=*/1, /*workgroup_z=*/1));
+  IREE_ASSERT_OK(iree_hal_command_buffer_end(command_buffer));
+
+  // Submit the same command buffer against different buffers each time.
+  float input_values[2] = {-2.5f, 4.0f};
+  for (int i = 0; i < 2; ++i) {
+    iree_hal_buffer_t* input_buffer = NULL;
+    IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+        device_allocator_,
+        IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE,
+        IREE_HAL_BUFFER_USAGE_DISPATCH | IREE_HAL_BUFFER_USAGE_TRANSFER,
+        sizeof(float),
+        iree_make_const_byte_span(&input_values[i], sizeof(float)),
+        &input_buffer));
+    iree_hal_buffer_t* output_buffer = NULL;
+    IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+        device_allocator_,
+        IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE,
+        IREE_HAL_BUFFER_USAGE_DISPATCH | IREE_HAL_BUFFER_USAGE_MAPPING,
+        sizeof(float), iree_const_byte_span_empty(), &output_buffer));
+
+    iree_hal_buffer_binding_t bindings[] = {
+        {input_buffer, /*offset=*/0, IREE_WHOLE_BUFFER},
+        {output_buffer, /*offset=*/0, IREE_WHOLE_BUFFER},
+    };
+    iree_hal_buffer_binding_table_t binding_table;
+    binding_table.count = IREE_ARRAYSIZE(bindings);
+    binding_table.bindings = bindings;
+    IREE_ASSERT_OK(SubmitCommandBufferAndWait(
+        IREE_HAL_COMMAND_CATEGORY_DISPATCH, command_buffer, binding_table));
+
+    float out_value = 0.0f;
+    IREE_ASSERT_OK(iree_hal_buffer_read_data(output_buffer, /*source_offset=*/0,
+                                             &out_value, sizeof(out_value)));
+    EXPECT_EQ(std::abs(input_values[i]), out_value);
+
+    iree_hal_buffer_release(output_buffer);
+    iree_hal_buffer_release(input_buffer);
+  }
+
+  iree_hal_command_buffer_release(command_buffer);
+  CleanupExecutable();
+}
+
 }  // namespace cts
 }  // namespace hal
 }  // namespace iree
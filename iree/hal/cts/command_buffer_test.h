@@ -8,6 +8,7 @@
 #define IREE_HAL_CTS_COMMAND_BUFFER_TEST_H_
 
 #include <cstdint>
+#include <cstring>
 #include <vector>
 
 #include "iree/base/api.h"
@@ -129,6 +130,153 @@ TEST_P(command_buffer_test, SubmitEmpty) {
   iree_hal_command_buffer_release(command_buffer);
 }
 
+TEST_P(command_buffer_test, SubmitReusableTwice) {
+  iree_hal_command_buffer_t* command_buffer = NULL;
+  IREE_ASSERT_OK(iree_hal_command_buffer_create(
+      device_, IREE_HAL_COMMAND_BUFFER_MODE_REUSABLE,
+      IREE_HAL_COMMAND_CATEGORY_TRANSFER, IREE_HAL_QUEUE_AFFINITY_ANY,
+      &command_buffer));
+
+  iree_hal_buffer_t* device_buffer = NULL;
+  IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+      device_allocator_,
+      IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE,
+      IREE_HAL_BUFFER_USAGE_ALL, kBufferSize, iree_const_byte_span_empty(),
+      &device_buffer));
+
+  // Zero the whole buffer and then fill the middle with a pattern such that
+  // the command buffer has more than one synchronization scope.
+  IREE_ASSERT_OK(iree_hal_command_buffer_begin(command_buffer));
+  uint8_t zero_val = 0x00;
+  IREE_ASSERT_OK(iree_hal_command_buffer_fill_buffer(
+      command_buffer, device_buffer, /*target_offset=*/0,
+      /*length=*/kBufferSize, &zero_val, /*pattern_length=*/sizeof(zero_val)));
+  IREE_ASSERT_OK(iree_hal_command_buffer_execution_barrier(
+      command_buffer, IREE_HAL_EXECUTION_STAGE_TRANSFER,
+      IREE_HAL_EXECUTION_STAGE_TRANSFER, IREE_HAL_EXECUTION_BARRIER_FLAG_NONE,
+      /*memory_barrier_count=*/0, NULL, /*buffer_barrier_count=*/0, NULL));
+  uint8_t i8_val = 0x88;
+  IREE_ASSERT_OK(iree_hal_command_buffer_fill_buffer(
+      command_buffer, device_buffer, /*target_offset=*/16,
+      /*length=*/kBufferSize - 32, &i8_val, /*pattern_length=*/sizeof(i8_val)));
+  IREE_ASSERT_OK(iree_hal_command_buffer_end(command_buffer));
+
+  std::vector<uint8_t> reference_buffer(kBufferSize);
+  std::memset(reference_buffer.data(), zero_val, kBufferSize);
+  std::memset(reference_buffer.data() + 16, i8_val, kBufferSize - 32);
+
+  // Submit the same command buffer twice, clobbering the buffer in between
+  // to ensure the second submission actually executes.
+  for (int i = 0; i < 2; ++i) {
+    IREE_ASSERT_OK(SubmitCommandBufferAndWait(
+        IREE_HAL_COMMAND_CATEGORY_TRANSFER, command_buffer));
+    std::vector<uint8_t> actual_data(kBufferSize);
+    IREE_ASSERT_OK(iree_hal_buffer_read_data(
+        device_buffer, /*source_offset=*/0,
+        /*target_buffer=*/actual_data.data(), /*data_length=*/kBufferSize));
+    EXPECT_THAT(actual_data, ContainerEq(reference_buffer));
+
+    std::vector<uint8_t> clobber_data(kBufferSize, 0xFF);
+    IREE_ASSERT_OK(iree_hal_buffer_write_data(
+        device_buffer, /*target_offset=*/0, clobber_data.data(), kBufferSize));
+  }
+
+  // Must release the command buffer before resources used by it.
+  iree_hal_command_buffer_release(command_buffer);
+  iree_hal_buffer_release(device_buffer);
+}
+
+// Records a chain of fills separated by barriers into a command buffer that
+// allows inline execution. Implementations may begin executing the chain while
+// it is still being recorded but the result must match in-order execution.
+TEST_P(command_buffer_test, SubmitInlineExecutionChain) {
+  iree_hal_command_buffer_t* command_buffer = NULL;
+  IREE_ASSERT_OK(iree_hal_command_buffer_create(
+      device_,
+      IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT |
+          IREE_HAL_COMMAND_BUFFER_MODE_ALLOW_INLINE_EXECUTION,
+      IREE_HAL_COMMAND_CATEGORY_TRANSFER, IREE_HAL_QUEUE_AFFINITY_ANY,
+      &command_buffer));
+
+  iree_hal_buffer_t* device_buffer = NULL;
+  IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+      device_allocator_,
+      IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE,
+      IREE_HAL_BUFFER_USAGE_ALL, kBufferSize, iree_const_byte_span_empty(),
+      &device_buffer));
+
+  // Each fill covers a smaller range than the one before it such that the
+  // result is only correct if every barrier was respected.
+  IREE_ASSERT_OK(iree_hal_command_buffer_begin(command_buffer));
+  const int kFillCount = 8;
+  for (int i = 0; i < kFillCount; ++i) {
+    uint8_t i8_val = (uint8_t)(0x10 + i);
+    IREE_ASSERT_OK(iree_hal_command_buffer_fill_buffer(
+        command_buffer, device_buffer, /*target_offset=*/i * 16,
+        /*length=*/kBufferSize - i * 32, &i8_val,
+        /*pattern_length=*/sizeof(i8_val)));
+    IREE_ASSERT_OK(iree_hal_command_buffer_execution_barrier(
+        command_buffer, IREE_HAL_EXECUTION_STAGE_TRANSFER,
+        IREE_HAL_EXECUTION_STAGE_TRANSFER, IREE_HAL_EXECUTION_BARRIER_FLAG_NONE,
+        /*memory_barrier_count=*/0, NULL, /*buffer_barrier_count=*/0, NULL));
+  }
+  IREE_ASSERT_OK(iree_hal_command_buffer_end(command_buffer));
+
+  std::vector<uint8_t> reference_buffer(kBufferSize);
+  for (int i = 0; i < kFillCount; ++i) {
+    std::memset(reference_buffer.data() + i * 16, 0x10 + i,
+                kBufferSize - i * 32);
+  }
+
+  IREE_ASSERT_OK(SubmitCommandBufferAndWait(IREE_HAL_COMMAND_CATEGORY_TRANSFER,
+                                            command_buffer));
+  std::vector<uint8_t> actual_data(kBufferSize);
+  IREE_ASSERT_OK(iree_hal_buffer_read_data(device_buffer, /*source_offset=*/0,
+                                           /*target_buffer=*/actual_data.data(),
+                                           /*data_length=*/kBufferSize));
+  EXPECT_THAT(actual_data, ContainerEq(reference_buffer));
+
+  // Must release the command buffer before resources used by it.
+  iree_hal_command_buffer_release(command_buffer);
+  iree_hal_buffer_release(device_buffer);
+}
+
+// Releases a command buffer that allows inline execution without submitting
+// it. Any work that began executing during recording must be safely drained.
+TEST_P(command_buffer_test, ReleaseInlineExecutionUnsubmitted) {
+  iree_hal_command_buffer_t* command_buffer = NULL;
+  IREE_ASSERT_OK(iree_hal_command_buffer_create(
+      device_,
+      IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT |
+          IREE_HAL_COMMAND_BUFFER_MODE_ALLOW_INLINE_EXECUTION,
+      IREE_HAL_COMMAND_CATEGORY_TRANSFER, IREE_HAL_QUEUE_AFFINITY_ANY,
+      &command_buffer));
+
+  iree_hal_buffer_t* device_buffer = NULL;
+  IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+      device_allocator_,
+      IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE,
+      IREE_HAL_BUFFER_USAGE_ALL, kBufferSize, iree_const_byte_span_empty(),
+      &device_buffer));
+
+  IREE_ASSERT_OK(iree_hal_command_buffer_begin(command_buffer));
+  for (int i = 0; i < 4; ++i) {
+    uint8_t i8_val = (uint8_t)i;
+    IREE_ASSERT_OK(iree_hal_command_buffer_fill_buffer(
+        command_buffer, device_buffer, /*target_offset=*/0,
+        /*length=*/kBufferSize, &i8_val, /*pattern_length=*/sizeof(i8_val)));
+    IREE_ASSERT_OK(iree_hal_command_buffer_execution_barrier(
+        command_buffer, IREE_HAL_EXECUTION_STAGE_TRANSFER,
+        IREE_HAL_EXECUTION_STAGE_TRANSFER, IREE_HAL_EXECUTION_BARRIER_FLAG_NONE,
+        /*memory_barrier_count=*/0, NULL, /*buffer_barrier_count=*/0, NULL));
+  }
+  IREE_ASSERT_OK(iree_hal_command_buffer_end(command_buffer));
+
+  iree_hal_command_buffer_release(command_buffer);
+  IREE_ASSERT_OK(iree_hal_device_wait_idle(device_, iree_infinite_timeout()));
+  iree_hal_buffer_release(device_buffer);
+}
+
 TEST_P(command_buffer_test, CopyWholeBuffer) {
   iree_hal_command_buffer_t* command_buffer;
   IREE_ASSERT_OK(iree_hal_command_buffer_create(
@@ -90,10 +90,12 @@ class CtsTestBase : public ::testing::TestWithParam<std::string> {
   }
 
   // Submits |command_buffer| to the device and waits for it to complete before
-  // returning.
+  // returning. |binding_table| resolves any indirect command buffer bindings.
   iree_status_t SubmitCommandBufferAndWait(
       iree_hal_command_category_t command_categories,
-      iree_hal_command_buffer_t* command_buffer) {
+      iree_hal_command_buffer_t* command_buffer,
+      iree_hal_buffer_binding_table_t binding_table =
+          iree_hal_buffer_binding_table_empty()) {
     iree_hal_semaphore_t* signal_semaphore = NULL;
     IREE_RETURN_IF_ERROR(
         iree_hal_semaphore_create(device_, 0ull, &signal_semaphore));
@@ -116,6 +118,7 @@ class CtsTestBase : public ::testing::TestWithParam<std::string> {
         IREE_ARRAYSIZE(signal_semaphore_ptrs);
     submission_batch.signal_semaphores.semaphores = signal_semaphore_ptrs;
     submission_batch.signal_semaphores.payload_values = payload_values;
+    submission_batch.binding_table = binding_table;
 
     iree_status_t status =
         iree_hal_device_queue_submit(device_, command_categories,
@@ -31,8 +31,10 @@ TEST_P(descriptor_set_test, CreateWithTwoBindings) {
       descriptor_set_layout_bindings, &descriptor_set_layout));
 
   iree_hal_descriptor_set_binding_t descriptor_set_bindings[] = {
-      {/*binding=*/0, /*buffer=*/NULL, /*offset=*/0, /*length=*/0},
-      {/*binding=*/1, /*buffer=*/NULL, /*offset=*/0, /*length=*/0},
+      {/*binding=*/0, /*buffer_slot=*/0, /*buffer=*/NULL, /*offset=*/0,
+       /*length=*/0},
+      {/*binding=*/1, /*buffer_slot=*/0, /*buffer=*/NULL, /*offset=*/0,
+       /*length=*/0},
   };
 
   iree_hal_descriptor_set_t* descriptor_set;
@@ -102,6 +102,7 @@ TEST_P(event_test, SubmitWithChainedCommandBuffers) {
   submission_batch.signal_semaphores.semaphores = signal_semaphore_ptrs;
   uint64_t payload_values[] = {1ull};
   submission_batch.signal_semaphores.payload_values = payload_values;
+  submission_batch.binding_table = iree_hal_buffer_binding_table_empty();
 
   IREE_ASSERT_OK(
       iree_hal_device_queue_submit(device_, IREE_HAL_COMMAND_CATEGORY_DISPATCH,
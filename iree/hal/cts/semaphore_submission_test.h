@@ -37,6 +37,7 @@ TEST_P(semaphore_submission_test, SubmitWithNoCommandBuffers) {
   submission_batch.signal_semaphores.semaphores = signal_semaphore_ptrs;
   uint64_t payload_values[] = {1ull};
   submission_batch.signal_semaphores.payload_values = payload_values;
+  submission_batch.binding_table = iree_hal_buffer_binding_table_empty();
 
   IREE_ASSERT_OK(
       iree_hal_device_queue_submit(device_, IREE_HAL_COMMAND_CATEGORY_DISPATCH,
@@ -73,6 +74,7 @@ TEST_P(semaphore_submission_test, SubmitAndSignal) {
   submission_batch.signal_semaphores.semaphores = signal_semaphore_ptrs;
   uint64_t payload_values[] = {1ull};
   submission_batch.signal_semaphores.payload_values = payload_values;
+  submission_batch.binding_table = iree_hal_buffer_binding_table_empty();
 
   IREE_ASSERT_OK(
       iree_hal_device_queue_submit(device_, IREE_HAL_COMMAND_CATEGORY_DISPATCH,
@@ -114,6 +116,7 @@ TEST_P(semaphore_submission_test, SubmitWithWait) {
       IREE_ARRAYSIZE(signal_semaphore_ptrs);
   submission_batch.signal_semaphores.semaphores = signal_semaphore_ptrs;
   submission_batch.signal_semaphores.payload_values = signal_payload_values;
+  submission_batch.binding_table = iree_hal_buffer_binding_table_empty();
 
   IREE_ASSERT_OK(
       iree_hal_device_queue_submit(device_, IREE_HAL_COMMAND_CATEGORY_DISPATCH,
@@ -169,6 +172,7 @@ TEST_P(semaphore_submission_test, SubmitWithMultipleSemaphores) {
       IREE_ARRAYSIZE(signal_semaphore_ptrs);
   submission_batch.signal_semaphores.semaphores = signal_semaphore_ptrs;
   submission_batch.signal_semaphores.payload_values = signal_payload_values;
+  submission_batch.binding_table = iree_hal_buffer_binding_table_empty();
 
   IREE_ASSERT_OK(
       iree_hal_device_queue_submit(device_, IREE_HAL_COMMAND_CATEGORY_DISPATCH,
@@ -202,6 +206,55 @@ TEST_P(semaphore_submission_test, SubmitWithMultipleSemaphores) {
   iree_hal_semaphore_release(signal_semaphore_2);
 }
 
+TEST_P(semaphore_submission_test, QueueAllocaDealloca) {
+  iree_hal_semaphore_t* wait_semaphore;
+  iree_hal_semaphore_t* alloca_semaphore;
+  iree_hal_semaphore_t* dealloca_semaphore;
+  IREE_ASSERT_OK(iree_hal_semaphore_create(device_, 0ull, &wait_semaphore));
+  IREE_ASSERT_OK(iree_hal_semaphore_create(device_, 0ull, &alloca_semaphore));
+  IREE_ASSERT_OK(
+      iree_hal_semaphore_create(device_, 0ull, &dealloca_semaphore));
+  uint64_t payload_values[] = {1ull};
+
+  // Allocation waits on |wait_semaphore| and signals |alloca_semaphore|.
+  iree_hal_semaphore_list_t wait_semaphore_list;
+  wait_semaphore_list.count = 1;
+  wait_semaphore_list.semaphores = &wait_semaphore;
+  wait_semaphore_list.payload_values = payload_values;
+  iree_hal_semaphore_list_t alloca_semaphore_list;
+  alloca_semaphore_list.count = 1;
+  alloca_semaphore_list.semaphores = &alloca_semaphore;
+  alloca_semaphore_list.payload_values = payload_values;
+  iree_hal_buffer_t* buffer = NULL;
+  IREE_ASSERT_OK(iree_hal_device_queue_alloca(
+      device_, IREE_HAL_QUEUE_AFFINITY_ANY, wait_semaphore_list,
+      alloca_semaphore_list, IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL,
+      IREE_HAL_BUFFER_USAGE_DISPATCH | IREE_HAL_BUFFER_USAGE_TRANSFER,
+      /*allocation_size=*/128, &buffer));
+  ASSERT_NE(nullptr, buffer);
+  EXPECT_LE(128, iree_hal_buffer_allocation_size(buffer));
+
+  IREE_ASSERT_OK(iree_hal_semaphore_signal(wait_semaphore, 1ull));
+  IREE_ASSERT_OK(
+      iree_hal_semaphore_wait(alloca_semaphore, 1ull, iree_infinite_timeout()));
+
+  // Deallocation waits on the allocation and signals |dealloca_semaphore|.
+  iree_hal_semaphore_list_t dealloca_semaphore_list;
+  dealloca_semaphore_list.count = 1;
+  dealloca_semaphore_list.semaphores = &dealloca_semaphore;
+  dealloca_semaphore_list.payload_values = payload_values;
+  IREE_ASSERT_OK(iree_hal_device_queue_dealloca(
+      device_, IREE_HAL_QUEUE_AFFINITY_ANY, alloca_semaphore_list,
+      dealloca_semaphore_list, buffer));
+  iree_hal_buffer_release(buffer);
+  IREE_ASSERT_OK(iree_hal_semaphore_wait(dealloca_semaphore, 1ull,
+                                         iree_infinite_timeout()));
+
+  iree_hal_semaphore_release(wait_semaphore);
+  iree_hal_semaphore_release(alloca_semaphore);
+  iree_hal_semaphore_release(dealloca_semaphore);
+}
+
 }  // namespace cts
 }  // namespace hal
 }  // namespace iree
@@ -0,0 +1,173 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "iree/base/api.h"
+#include "iree/base/internal/flags.h"
+#include "iree/base/internal/threading.h"
+#include "iree/hal/api.h"
+#include "iree/hal/drivers/init.h"
+#include "iree/testing/benchmark.h"
+
+IREE_FLAG(string, driver, "local-task", "HAL driver to benchmark.");
+
+// Creates the default device of the driver named by --driver.
+static iree_status_t iree_hal_semaphore_throughput_create_device(
+    iree_allocator_t host_allocator, iree_hal_device_t** out_device) {
+  iree_hal_driver_t* driver = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_driver_registry_try_create_by_name(
+      iree_hal_driver_registry_default(), iree_make_cstring_view(FLAG_driver),
+      host_allocator, &driver));
+  iree_status_t status =
+      iree_hal_driver_create_default_device(driver, host_allocator, out_device);
+  iree_hal_driver_release(driver);
+  return status;
+}
+
+// Signals and queries a semaphore that nothing is waiting on. Measures the
+// cost of host signals in the common case of pipelined work where the waiter
+// only checks the value later on.
+static iree_status_t iree_hal_semaphore_throughput_run_signal_query(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  iree_hal_device_t* device = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_semaphore_throughput_create_device(
+      benchmark_state->host_allocator, &device));
+  iree_hal_semaphore_t* semaphore = NULL;
+  iree_status_t status = iree_hal_semaphore_create(device, 0ull, &semaphore);
+
+  uint64_t value = 0;
+  while (iree_status_is_ok(status) &&
+         iree_benchmark_keep_running(benchmark_state, /*batch_count=*/1)) {
+    status = iree_hal_semaphore_signal(semaphore, ++value);
+    uint64_t current_value = 0;
+    if (iree_status_is_ok(status)) {
+      status = iree_hal_semaphore_query(semaphore, &current_value);
+    }
+  }
+  iree_benchmark_set_items_processed(benchmark_state, (int64_t)value);
+
+  iree_hal_semaphore_release(semaphore);
+  iree_hal_device_release(device);
+  return status;
+}
+
+typedef struct iree_hal_semaphore_throughput_ping_pong_t {
+  iree_hal_semaphore_t* ping;
+  iree_hal_semaphore_t* pong;
+} iree_hal_semaphore_throughput_ping_pong_t;
+
+// Signals |pong| each time |ping| is signaled until |ping| is failed.
+static int iree_hal_semaphore_throughput_pong_main(void* entry_arg) {
+  iree_hal_semaphore_throughput_ping_pong_t* ping_pong =
+      (iree_hal_semaphore_throughput_ping_pong_t*)entry_arg;
+  for (uint64_t value = 1;; ++value) {
+    iree_status_t status = iree_hal_semaphore_wait(ping_pong->ping, value,
+                                                   iree_infinite_timeout());
+    if (iree_status_is_ok(status)) {
+      status = iree_hal_semaphore_signal(ping_pong->pong, value);
+    }
+    if (!iree_status_is_ok(status)) {
+      iree_status_ignore(status);
+      break;
+    }
+  }
+  return 0;
+}
+
+// Signals a semaphore waited on by another thread and waits for that thread to
+// signal back. Measures the round-trip cost of signals that must wake waiters.
+static iree_status_t iree_hal_semaphore_throughput_run_ping_pong(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  iree_hal_device_t* device = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_semaphore_throughput_create_device(
+      benchmark_state->host_allocator, &device));
+  iree_hal_semaphore_throughput_ping_pong_t ping_pong = {
+      .ping = NULL,
+      .pong = NULL,
+  };
+  iree_status_t status =
+      iree_hal_semaphore_create(device, 0ull, &ping_pong.ping);
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_semaphore_create(device, 0ull, &ping_pong.pong);
+  }
+
+  // The thread only returns once the ping semaphore is failed below so
+  // |ping_pong| outlives it.
+  iree_thread_t* thread = NULL;
+  if (iree_status_is_ok(status)) {
+    iree_thread_create_params_t params;
+    memset(&params, 0, sizeof(params));
+    params.name = iree_make_cstring_view("pong");
+    status = iree_thread_create(iree_hal_semaphore_throughput_pong_main,
+                                &ping_pong, params,
+                                benchmark_state->host_allocator, &thread);
+  }
+
+  uint64_t value = 0;
+  while (iree_status_is_ok(status) &&
+         iree_benchmark_keep_running(benchmark_state, /*batch_count=*/1)) {
+    status = iree_hal_semaphore_signal(ping_pong.ping, ++value);
+    if (iree_status_is_ok(status)) {
+      status = iree_hal_semaphore_wait(ping_pong.pong, value,
+                                       iree_infinite_timeout());
+    }
+  }
+  iree_benchmark_set_items_processed(benchmark_state, (int64_t)value);
+
+  if (thread) {
+    iree_hal_semaphore_fail(ping_pong.ping,
+                            iree_status_from_code(IREE_STATUS_CANCELLED));
+    iree_thread_release(thread);  // joins
+  }
+  iree_hal_semaphore_release(ping_pong.pong);
+  iree_hal_semaphore_release(ping_pong.ping);
+  iree_hal_device_release(device);
+  return status;
+}
+
+int main(int argc, char** argv) {
+  iree_flags_set_usage(
+      "semaphore_throughput_benchmark",
+      "Benchmarks the host cost of signaling, querying, and waiting on\n"
+      "semaphores of a HAL driver.\n"
+      "\n"
+      "Example:\n"
+      "  semaphore_throughput_benchmark --driver=local-task\n"
+      "\n");
+
+  iree_flags_parse_checked(IREE_FLAGS_PARSE_MODE_UNDEFINED_OK, &argc, &argv);
+  iree_benchmark_initialize(&argc, argv);
+
+  IREE_CHECK_OK(iree_hal_register_all_available_drivers(
+      iree_hal_driver_registry_default()));
+
+  iree_benchmark_def_t signal_query_def = {
+      .flags = IREE_BENCHMARK_FLAG_USE_REAL_TIME,
+      .time_unit = IREE_BENCHMARK_UNIT_NANOSECOND,
+      .minimum_duration_ns = 0,
+      .iteration_count = 0,
+      .run = iree_hal_semaphore_throughput_run_signal_query,
+  };
+  iree_benchmark_register(iree_make_cstring_view("signal_query"),
+                          &signal_query_def);
+
+  iree_benchmark_def_t ping_pong_def = {
+      .flags = IREE_BENCHMARK_FLAG_USE_REAL_TIME,
+      .time_unit = IREE_BENCHMARK_UNIT_NANOSECOND,
+      .minimum_duration_ns = 0,
+      .iteration_count = 0,
+      .run = iree_hal_semaphore_throughput_run_ping_pong,
+  };
+  iree_benchmark_register(iree_make_cstring_view("ping_pong"), &ping_pong_def);
+
+  iree_benchmark_run_specified();
+  return 0;
+}
@@ -0,0 +1,165 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "iree/base/api.h"
+#include "iree/base/internal/flags.h"
+#include "iree/hal/api.h"
+#include "iree/hal/drivers/init.h"
+#include "iree/testing/benchmark.h"
+
+IREE_FLAG(string, driver, "vulkan", "HAL driver to benchmark.");
+
+IREE_FLAG(int32_t, chain_length, 16,
+          "Number of submissions chained together with semaphores per\n"
+          "iteration of the chained benchmark. Each submission waits on the\n"
+          "value signaled by the previous one.");
+
+// Creates the default device of the driver named by --driver.
+static iree_status_t iree_hal_submission_latency_create_device(
+    iree_allocator_t host_allocator, iree_hal_device_t** out_device) {
+  iree_hal_driver_t* driver = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_driver_registry_try_create_by_name(
+      iree_hal_driver_registry_default(), iree_make_cstring_view(FLAG_driver),
+      host_allocator, &driver));
+  iree_status_t status =
+      iree_hal_driver_create_default_device(driver, host_allocator, out_device);
+  iree_hal_driver_release(driver);
+  return status;
+}
+
+// Submits an empty batch signaling a semaphore and waits for it on the host.
+// Measures the round-trip latency of a single submission.
+static iree_status_t iree_hal_submission_latency_run_single(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  iree_hal_device_t* device = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_submission_latency_create_device(
+      benchmark_state->host_allocator, &device));
+  iree_hal_semaphore_t* semaphore = NULL;
+  iree_status_t status = iree_hal_semaphore_create(device, 0ull, &semaphore);
+
+  uint64_t value = 0;
+  while (iree_status_is_ok(status) &&
+         iree_benchmark_keep_running(benchmark_state, /*batch_count=*/1)) {
+    ++value;
+    iree_hal_submission_batch_t batch = {
+        .signal_semaphores =
+            {
+                .count = 1,
+                .semaphores = &semaphore,
+                .payload_values = &value,
+            },
+    };
+    status = iree_hal_device_submit_and_wait(
+        device, IREE_HAL_COMMAND_CATEGORY_ANY, IREE_HAL_QUEUE_AFFINITY_ANY, 1,
+        &batch, semaphore, value, iree_infinite_timeout());
+  }
+
+  iree_hal_semaphore_release(semaphore);
+  iree_hal_device_release(device);
+  return status;
+}
+
+// Submits --chain_length empty submissions where each waits on the value the
+// previous one signals, all submitted before the first is signaled, and then
+// waits for the last on the host. Measures the per-submission cost of
+// wait-before-signal ordering resolved on the device.
+static iree_status_t iree_hal_submission_latency_run_chained(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  iree_hal_device_t* device = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_submission_latency_create_device(
+      benchmark_state->host_allocator, &device));
+  iree_hal_semaphore_t* semaphore = NULL;
+  iree_status_t status = iree_hal_semaphore_create(device, 0ull, &semaphore);
+
+  int64_t submission_count = 0;
+  uint64_t value = 0;
+  while (iree_status_is_ok(status) &&
+         iree_benchmark_keep_running(benchmark_state, /*batch_count=*/1)) {
+    // The first submission waits on a value only signaled from the host after
+    // the whole chain has been submitted.
+    uint64_t start_value = ++value;
+    for (int32_t i = 0; i < FLAG_chain_length && iree_status_is_ok(status);
+         ++i) {
+      uint64_t wait_value = value;
+      uint64_t signal_value = ++value;
+      iree_hal_submission_batch_t batch = {
+          .wait_semaphores =
+              {
+                  .count = 1,
+                  .semaphores = &semaphore,
+                  .payload_values = &wait_value,
+              },
+          .signal_semaphores =
+              {
+                  .count = 1,
+                  .semaphores = &semaphore,
+                  .payload_values = &signal_value,
+              },
+      };
+      status = iree_hal_device_queue_submit(
+          device, IREE_HAL_COMMAND_CATEGORY_ANY, IREE_HAL_QUEUE_AFFINITY_ANY, 1,
+          &batch);
+    }
+    if (iree_status_is_ok(status)) {
+      status = iree_hal_semaphore_signal(semaphore, start_value);
+    }
+    if (iree_status_is_ok(status)) {
+      status =
+          iree_hal_semaphore_wait(semaphore, value, iree_infinite_timeout());
+    }
+    submission_count += FLAG_chain_length;
+  }
+  iree_benchmark_set_items_processed(benchmark_state, submission_count);
+
+  iree_hal_semaphore_release(semaphore);
+  iree_hal_device_release(device);
+  return status;
+}
+
+int main(int argc, char** argv) {
+  iree_flags_set_usage(
+      "submission_latency_benchmark",
+      "Benchmarks the host and device overhead of queue submissions and\n"
+      "semaphore signaling/waiting of a HAL driver using empty batches.\n"
+      "\n"
+      "Example:\n"
+      "  submission_latency_benchmark --driver=vulkan\n"
+      "\n");
+
+  iree_flags_parse_checked(IREE_FLAGS_PARSE_MODE_UNDEFINED_OK, &argc, &argv);
+  iree_benchmark_initialize(&argc, argv);
+
+  IREE_CHECK_OK(iree_hal_register_all_available_drivers(
+      iree_hal_driver_registry_default()));
+
+  iree_benchmark_def_t single_def = {
+      .flags = IREE_BENCHMARK_FLAG_USE_REAL_TIME,
+      .time_unit = IREE_BENCHMARK_UNIT_NANOSECOND,
+      .minimum_duration_ns = 0,
+      .iteration_count = 0,
+      .run = iree_hal_submission_latency_run_single,
+  };
+  iree_benchmark_register(iree_make_cstring_view("submit_and_wait"),
+                          &single_def);
+
+  iree_benchmark_def_t chained_def = {
+      .flags = IREE_BENCHMARK_FLAG_USE_REAL_TIME,
+      .time_unit = IREE_BENCHMARK_UNIT_NANOSECOND,
+      .minimum_duration_ns = 0,
+      .iteration_count = 0,
+      .run = iree_hal_submission_latency_run_chained,
+  };
+  iree_benchmark_register(iree_make_cstring_view("chained_wait_before_signal"),
+                          &chained_def);
+
+  iree_benchmark_run_specified();
+  return 0;
+}
@@ -0,0 +1,232 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "iree/base/api.h"
+#include "iree/base/internal/flags.h"
+#include "iree/hal/api.h"
+#include "iree/hal/drivers/init.h"
+#include "iree/testing/benchmark.h"
+
+IREE_FLAG(string, driver, "dylib", "HAL driver to benchmark.");
+
+IREE_FLAG(int64_t, transfer_size, 256 * 1024 * 1024,
+          "Size in bytes of each fill or copy.");
+
+// Creates the default device of the driver named by --driver.
+static iree_status_t iree_hal_transfer_bandwidth_create_device(
+    iree_allocator_t host_allocator, iree_hal_device_t** out_device) {
+  iree_hal_driver_t* driver = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_driver_registry_try_create_by_name(
+      iree_hal_driver_registry_default(), iree_make_cstring_view(FLAG_driver),
+      host_allocator, &driver));
+  iree_status_t status =
+      iree_hal_driver_create_default_device(driver, host_allocator, out_device);
+  iree_hal_driver_release(driver);
+  return status;
+}
+
+static iree_status_t iree_hal_transfer_bandwidth_allocate(
+    iree_hal_device_t* device, iree_hal_buffer_t** out_buffer) {
+  return iree_hal_allocator_allocate_buffer(
+      iree_hal_device_allocator(device),
+      IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE,
+      IREE_HAL_BUFFER_USAGE_ALL, (iree_host_size_t)FLAG_transfer_size,
+      iree_const_byte_span_empty(), out_buffer);
+}
+
+typedef enum iree_hal_transfer_bandwidth_op_e {
+  IREE_HAL_TRANSFER_BANDWIDTH_OP_COPY = 0,
+  IREE_HAL_TRANSFER_BANDWIDTH_OP_FILL1,
+  IREE_HAL_TRANSFER_BANDWIDTH_OP_FILL4,
+} iree_hal_transfer_bandwidth_op_t;
+
+// Records a command buffer with a single transfer of --transfer_size bytes and
+// submits it once per iteration; the command buffer is reused across
+// iterations so only the transfer itself is measured.
+static iree_status_t iree_hal_transfer_bandwidth_run_command_buffer(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  iree_hal_transfer_bandwidth_op_t op =
+      (iree_hal_transfer_bandwidth_op_t)(uintptr_t)benchmark_def->user_data;
+  iree_hal_device_t* device = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_transfer_bandwidth_create_device(
+      benchmark_state->host_allocator, &device));
+
+  iree_hal_buffer_t* source_buffer = NULL;
+  iree_hal_buffer_t* target_buffer = NULL;
+  iree_hal_command_buffer_t* command_buffer = NULL;
+  iree_hal_semaphore_t* semaphore = NULL;
+  iree_status_t status =
+      iree_hal_transfer_bandwidth_allocate(device, &source_buffer);
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_transfer_bandwidth_allocate(device, &target_buffer);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_command_buffer_create(
+        device, IREE_HAL_COMMAND_BUFFER_MODE_REUSABLE,
+        IREE_HAL_COMMAND_CATEGORY_TRANSFER, IREE_HAL_QUEUE_AFFINITY_ANY,
+        &command_buffer);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_command_buffer_begin(command_buffer);
+  }
+  if (iree_status_is_ok(status)) {
+    const uint32_t pattern = 0xCDCDCDCDu;
+    switch (op) {
+      case IREE_HAL_TRANSFER_BANDWIDTH_OP_COPY:
+        status = iree_hal_command_buffer_copy_buffer(
+            command_buffer, source_buffer, 0, target_buffer, 0,
+            (iree_device_size_t)FLAG_transfer_size);
+        break;
+      case IREE_HAL_TRANSFER_BANDWIDTH_OP_FILL1:
+        status = iree_hal_command_buffer_fill_buffer(
+            command_buffer, target_buffer, 0,
+            (iree_device_size_t)FLAG_transfer_size, &pattern, 1);
+        break;
+      case IREE_HAL_TRANSFER_BANDWIDTH_OP_FILL4:
+        status = iree_hal_command_buffer_fill_buffer(
+            command_buffer, target_buffer, 0,
+            (iree_device_size_t)FLAG_transfer_size, &pattern, sizeof(pattern));
+        break;
+    }
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_command_buffer_end(command_buffer);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_semaphore_create(device, 0ull, &semaphore);
+  }
+
+  uint64_t value = 0;
+  int64_t iteration_count = 0;
+  while (iree_status_is_ok(status) &&
+         iree_benchmark_keep_running(benchmark_state, /*batch_count=*/1)) {
+    ++value;
+    iree_hal_submission_batch_t batch = {
+        .command_buffer_count = 1,
+        .command_buffers = &command_buffer,
+        .signal_semaphores =
+            {
+                .count = 1,
+                .semaphores = &semaphore,
+                .payload_values = &value,
+            },
+    };
+    status = iree_hal_device_submit_and_wait(
+        device, IREE_HAL_COMMAND_CATEGORY_TRANSFER, IREE_HAL_QUEUE_AFFINITY_ANY,
+        1, &batch, semaphore, value, iree_infinite_timeout());
+    ++iteration_count;
+  }
+  iree_benchmark_set_bytes_processed(benchmark_state,
+                                     iteration_count * FLAG_transfer_size);
+
+  iree_hal_semaphore_release(semaphore);
+  iree_hal_command_buffer_release(command_buffer);
+  iree_hal_buffer_release(target_buffer);
+  iree_hal_buffer_release(source_buffer);
+  iree_hal_device_release(device);
+  return status;
+}
+
+// Single-threaded memcpy/memset of --transfer_size bytes on the host as the
+// baseline for the command buffer transfers.
+static iree_status_t iree_hal_transfer_bandwidth_run_host(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  iree_hal_transfer_bandwidth_op_t op =
+      (iree_hal_transfer_bandwidth_op_t)(uintptr_t)benchmark_def->user_data;
+  iree_host_size_t length = (iree_host_size_t)FLAG_transfer_size;
+  uint8_t* source = NULL;
+  uint8_t* target = NULL;
+  iree_status_t status = iree_allocator_malloc(benchmark_state->host_allocator,
+                                               length, (void**)&source);
+  if (iree_status_is_ok(status)) {
+    status = iree_allocator_malloc(benchmark_state->host_allocator, length,
+                                   (void**)&target);
+  }
+  if (iree_status_is_ok(status)) {
+    // Touch all pages so that page faults are not measured.
+    memset(source, 1, length);
+    memset(target, 1, length);
+  }
+
+  int64_t iteration_count = 0;
+  while (iree_status_is_ok(status) &&
+         iree_benchmark_keep_running(benchmark_state, /*batch_count=*/1)) {
+    if (op == IREE_HAL_TRANSFER_BANDWIDTH_OP_COPY) {
+      memcpy(target, source, length);
+    } else {
+      memset(target, 0xCD, length);
+    }
+    ++iteration_count;
+  }
+  iree_benchmark_set_bytes_processed(benchmark_state,
+                                     iteration_count * FLAG_transfer_size);
+
+  iree_allocator_free(benchmark_state->host_allocator, target);
+  iree_allocator_free(benchmark_state->host_allocator, source);
+  return status;
+}
+
+static void iree_hal_transfer_bandwidth_register(
+    const char* name,
+    iree_status_t (*run)(const iree_benchmark_def_t* benchmark_def,
+                         iree_benchmark_state_t* benchmark_state),
+    iree_hal_transfer_bandwidth_op_t op) {
+  iree_benchmark_def_t benchmark_def = {
+      .flags = IREE_BENCHMARK_FLAG_USE_REAL_TIME,
+      .time_unit = IREE_BENCHMARK_UNIT_MILLISECOND,
+      .minimum_duration_ns = 0,
+      .iteration_count = 0,
+      .run = run,
+      .user_data = (const void*)(uintptr_t)op,
+  };
+  iree_benchmark_register(iree_make_cstring_view(name), &benchmark_def);
+}
+
+int main(int argc, char** argv) {
+  iree_flags_set_usage(
+      "transfer_bandwidth_benchmark",
+      "Benchmarks the bandwidth of command buffer fills and copies of a HAL\n"
+      "driver against single-threaded host memset/memcpy.\n"
+      "\n"
+      "Example:\n"
+      "  transfer_bandwidth_benchmark --driver=dylib --transfer_size=1073741824"
+      "\n"
+      "\n");
+
+  iree_flags_parse_checked(IREE_FLAGS_PARSE_MODE_UNDEFINED_OK, &argc, &argv);
+  iree_benchmark_initialize(&argc, argv);
+
+  IREE_CHECK_OK(iree_hal_register_all_available_drivers(
+      iree_hal_driver_registry_default()));
+
+  iree_hal_transfer_bandwidth_register(
+      "host_memcpy", iree_hal_transfer_bandwidth_run_host,
+      IREE_HAL_TRANSFER_BANDWIDTH_OP_COPY);
+  iree_hal_transfer_bandwidth_register(
+      "host_memset", iree_hal_transfer_bandwidth_run_host,
+      IREE_HAL_TRANSFER_BANDWIDTH_OP_FILL1);
+  iree_hal_transfer_bandwidth_register(
+      "command_buffer_copy_buffer",
+      iree_hal_transfer_bandwidth_run_command_buffer,
+      IREE_HAL_TRANSFER_BANDWIDTH_OP_COPY);
+  iree_hal_transfer_bandwidth_register(
+      "command_buffer_fill_buffer_1",
+      iree_hal_transfer_bandwidth_run_command_buffer,
+      IREE_HAL_TRANSFER_BANDWIDTH_OP_FILL1);
+  iree_hal_transfer_bandwidth_register(
+      "command_buffer_fill_buffer_4",
+      iree_hal_transfer_bandwidth_run_command_buffer,
+      IREE_HAL_TRANSFER_BANDWIDTH_OP_FILL4);
+
+  iree_benchmark_run_specified();
+  return 0;
+}
@@ -44,6 +44,51 @@ typedef struct iree_hal_cuda_device_params_t {
   // Only command buffers produced by the compiler that have the
   // IREE_HAL_COMMAND_BUFFER_MODE_ALLOW_INLINE_EXECUTION bit set will use this.
   bool allow_inline_execution;
+
+  // Number of CUDA streams commands are distributed across when executing
+  // command buffers against streams. Commands between execution barriers (such
+  // as those in stream.cmd.concurrent regions) are independent and issued
+  // round-robin across the streams and each barrier joins them with events.
+  // 1 issues all commands in order on a single stream.
+  iree_host_size_t concurrent_stream_count;
+
+  // Number of threads used to load executables in the background. PTX is JIT
+  // compiled when loaded and doing so concurrently hides most of the cost.
+  // Dispatches block only on the executables they use. 0 loads executables
+  // synchronously during creation.
+  iree_host_size_t executable_load_worker_count;
+
+  // Optional directory used to persist cubins JIT compiled from PTX across
+  // processes. Keys include the device compute capability and driver version
+  // so the directory may be shared by multiple devices. The directory must
+  // exist. Empty disables persistent caching. The path is copied by drivers
+  // and devices and need not outlive their creation.
+  iree_string_view_t executable_cache_path;
+
+  // Allocates device-local memory from a CUDA memory pool with stream-ordered
+  // allocation and release (cuMemAllocFromPoolAsync/cuMemFreeAsync) instead of
+  // cuMemAlloc/cuMemFree. cuMemFree implicitly synchronizes the device while
+  // pooled memory is returned to the pool in order on the device stream.
+  // Ignored if the device does not support memory pools.
+  bool use_memory_pools;
+
+  // Bytes of released memory the memory pool retains for reuse when the device
+  // stream synchronizes; memory above the threshold is returned to the device.
+  // iree_hal_device_trim returns all unused memory regardless of threshold.
+  uint64_t memory_pool_release_threshold;
+
+  // Size, in bytes, of each chunk of the page-locked host staging ring that
+  // iree_hal_device_transfer_range copies between host memory and device-only
+  // memory through. Transfers are split into chunks such that copying host
+  // data into one chunk overlaps with the DMA of the others.
+  iree_host_size_t staging_chunk_size;
+
+  // Number of chunks in the staging ring, up to
+  // IREE_HAL_CUDA_STAGING_RING_MAX_CHUNK_COUNT. The ring is allocated on the
+  // first transfer. 0 disables the ring and transfers are issued as transfer
+  // command buffers from pageable memory. CUDA has no timed waits and staged
+  // transfers block until they complete regardless of the transfer timeout.
+  iree_host_size_t staging_chunk_count;
 } iree_hal_cuda_device_params_t;
 
 // Initializes |out_params| to default values.
@@ -66,6 +111,11 @@ IREE_API_EXPORT void iree_hal_cuda_driver_options_initialize(
 
 // Creates a CUDA HAL driver that manage its own CUcontext.
 //
+// The CUDA library is not loaded until devices are first queried or created
+// so that registering or creating the driver in processes that never use it
+// is cheap. Errors from a missing or incompatible CUDA installation are
+// reported at that time.
+//
 // |out_driver| must be released by the caller (see |iree_hal_driver_release|).
 IREE_API_EXPORT iree_status_t iree_hal_cuda_driver_create(
     iree_string_view_t identifier,
@@ -75,6 +125,79 @@ IREE_API_EXPORT iree_status_t iree_hal_cuda_driver_create(
 
 // TODO(thomasraoux): Support importing a CUcontext from app.
 
+//===----------------------------------------------------------------------===//
+// iree_hal_cuda_graph_capture_t
+//===----------------------------------------------------------------------===//
+
+// A single CUDA graph containing all work submitted to a device between
+// iree_hal_cuda_device_begin_capture and iree_hal_cuda_device_end_capture.
+//
+// Capturing an entire invocation (such as iree_runtime_call_invoke) allows it
+// to be replayed with a single graph launch, skipping the VM and all command
+// buffer recording and submission. This is only valid for invocations whose
+// device work does not depend on host decisions made during the invocation:
+// static shapes and no reads of device results on the host while capturing.
+//
+// Work submitted while capturing is not executed until the capture is ended.
+// Host-side buffer operations (mapping, iree_hal_buffer_write_data, etc) are
+// not captured and happen immediately. All buffers referenced by the captured
+// work are retained by the capture and replays read and write the same
+// buffers that were used during capture unless updated with
+// iree_hal_cuda_graph_capture_update_buffer.
+//
+// Thread-compatible: replays and updates must be externally synchronized.
+typedef struct iree_hal_cuda_graph_capture_t iree_hal_cuda_graph_capture_t;
+
+// Begins capturing all command buffers submitted to the CUDA |device|.
+// Command buffers created while capturing are recorded into the capture in
+// recording order and must be recorded one at a time; submissions of them are
+// ordered by the capture and not executed. Command buffers created before the
+// capture began cannot be submitted until it ends.
+IREE_API_EXPORT iree_status_t
+iree_hal_cuda_device_begin_capture(iree_hal_device_t* device);
+
+// Ends capturing on |device| and returns the captured graph. The captured
+// work is executed once before returning so that the results of the captured
+// invocation are available to the caller.
+IREE_API_EXPORT iree_status_t iree_hal_cuda_device_end_capture(
+    iree_hal_device_t* device, iree_hal_cuda_graph_capture_t** out_capture);
+
+// Retains the given |capture| for the caller.
+IREE_API_EXPORT void iree_hal_cuda_graph_capture_retain(
+    iree_hal_cuda_graph_capture_t* capture);
+
+// Releases the given |capture| from the caller.
+IREE_API_EXPORT void iree_hal_cuda_graph_capture_release(
+    iree_hal_cuda_graph_capture_t* capture);
+
+// Redirects all captured uses of |captured_buffer| to |buffer| in subsequent
+// replays by updating the parameters of the captured graph nodes in place.
+// |buffer| must be at least as large as |captured_buffer| and is retained by
+// the capture. Used to bind new inputs and outputs without recapturing.
+IREE_API_EXPORT iree_status_t iree_hal_cuda_graph_capture_update_buffer(
+    iree_hal_cuda_graph_capture_t* capture, iree_hal_buffer_t* captured_buffer,
+    iree_hal_buffer_t* buffer);
+
+// Launches the captured graph and waits for it to complete.
+IREE_API_EXPORT iree_status_t
+iree_hal_cuda_graph_capture_replay(iree_hal_cuda_graph_capture_t* capture);
+
+//===----------------------------------------------------------------------===//
+// Peer access
+//===----------------------------------------------------------------------===//
+
+// Enables |device| to directly access memory allocated by |peer_device|.
+// Once enabled, transfers issued on |device| that read from or write to
+// buffers of |peer_device| (such as with iree_hal_device_transfer_range) are
+// performed as peer-to-peer copies over the device interconnect instead of
+// being staged through host memory. Access is one-directional; enable it on
+// both devices for bidirectional transfers.
+//
+// Returns IREE_STATUS_UNAVAILABLE if the devices are not able to access each
+// other and succeeds if access was already enabled.
+IREE_API_EXPORT iree_status_t iree_hal_cuda_device_enable_peer_access(
+    iree_hal_device_t* device, iree_hal_device_t* peer_device);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
@@ -7,6 +7,7 @@
 #include "iree/hal/cuda/cuda_allocator.h"
 
 #include <stddef.h>
+#include <string.h>
 
 #include "iree/base/api.h"
 #include "iree/base/tracing.h"
@@ -21,6 +22,14 @@ typedef struct iree_hal_cuda_allocator_t {
   CUdevice device;
   CUstream stream;
   bool supports_concurrent_managed_access;
+  // True if the device is integrated with the host and shares its physical
+  // memory (such as Jetson). All allocations are made from page-locked host
+  // memory mapped into the device address space and are host-visible.
+  bool is_integrated;
+
+  // Pool device-local memory is allocated from with stream-ordered allocation
+  // and release on |stream|. NULL if memory pools are disabled or unsupported.
+  CUmemoryPool memory_pool;
 
   IREE_STATISTICS(iree_hal_allocator_statistics_t statistics;)
 } iree_hal_cuda_allocator_t;
@@ -33,11 +42,55 @@ static iree_hal_cuda_allocator_t* iree_hal_cuda_allocator_cast(
   return (iree_hal_cuda_allocator_t*)base_value;
 }
 
+// Creates a pool for device-local allocations on |device| if supported.
+// |out_memory_pool| is set to NULL if the device does not support pools.
+static iree_status_t iree_hal_cuda_allocator_create_memory_pool(
+    iree_hal_cuda_context_wrapper_t* context, CUdevice device,
+    uint64_t release_threshold, CUmemoryPool* out_memory_pool) {
+  *out_memory_pool = NULL;
+  int supports_memory_pools = 0;
+  IREE_RETURN_IF_ERROR(CU_RESULT_TO_STATUS(
+      context->syms,
+      cuDeviceGetAttribute(&supports_memory_pools,
+                           CU_DEVICE_ATTRIBUTE_MEMORY_POOLS_SUPPORTED, device),
+      "cuDeviceGetAttribute"));
+  if (!supports_memory_pools) return iree_ok_status();
+
+  CUmemPoolProps pool_props;
+  memset(&pool_props, 0, sizeof(pool_props));
+  pool_props.allocType = CU_MEM_ALLOCATION_TYPE_PINNED;
+  pool_props.handleTypes = CU_MEM_HANDLE_TYPE_NONE;
+  pool_props.location.type = CU_MEM_LOCATION_TYPE_DEVICE;
+  pool_props.location.id = device;
+  CUmemoryPool memory_pool = NULL;
+  IREE_RETURN_IF_ERROR(CU_RESULT_TO_STATUS(
+      context->syms, cuMemPoolCreate(&memory_pool, &pool_props),
+      "cuMemPoolCreate"));
+
+  // Without a threshold all released memory is returned to the device each
+  // time the stream synchronizes and subsequent allocations hit the driver.
+  cuuint64_t threshold = (cuuint64_t)release_threshold;
+  iree_status_t status = CU_RESULT_TO_STATUS(
+      context->syms,
+      cuMemPoolSetAttribute(memory_pool, CU_MEMPOOL_ATTR_RELEASE_THRESHOLD,
+                            &threshold),
+      "cuMemPoolSetAttribute");
+  if (iree_status_is_ok(status)) {
+    *out_memory_pool = memory_pool;
+  } else {
+    CUDA_IGNORE_ERROR(context->syms, cuMemPoolDestroy(memory_pool));
+  }
+  return status;
+}
+
 iree_status_t iree_hal_cuda_allocator_create(
     iree_hal_device_t* base_device, iree_hal_cuda_context_wrapper_t* context,
-    CUdevice device, CUstream stream, iree_hal_allocator_t** out_allocator) {
+    CUdevice device, CUstream stream,
+    const iree_hal_cuda_device_params_t* params,
+    iree_hal_allocator_t** out_allocator) {
   IREE_ASSERT_ARGUMENT(base_device);
   IREE_ASSERT_ARGUMENT(context);
+  IREE_ASSERT_ARGUMENT(params);
   IREE_TRACE_ZONE_BEGIN(z0);
 
   // To support device-local + host-visible memory we need concurrent managed
@@ -61,6 +114,32 @@ iree_status_t iree_hal_cuda_allocator_create(
               : "no CONCURRENT_MANAGED_ACCESS (expect slow accesses on "
                 "device-local + host-visible memory)");
 
+  // Integrated devices have no dedicated device memory and device-local
+  // allocations live in the same physical memory as the host. Routing them
+  // through page-locked host memory lets uploads and readbacks map and memcpy
+  // instead of staging through a separate allocation and copy.
+  int is_integrated = 0;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, CU_RESULT_TO_STATUS(
+              context->syms,
+              cuDeviceGetAttribute(&is_integrated,
+                                   CU_DEVICE_ATTRIBUTE_INTEGRATED, device),
+              "cuDeviceGetAttribute"));
+  if (is_integrated) {
+    IREE_TRACE_ZONE_APPEND_TEXT(z0, "INTEGRATED (unified memory)");
+  }
+
+  // Integrated devices allocate from page-locked host memory and don't use the
+  // device memory pool.
+  CUmemoryPool memory_pool = NULL;
+  if (params->use_memory_pools && !is_integrated) {
+    IREE_RETURN_AND_END_ZONE_IF_ERROR(
+        z0, iree_hal_cuda_allocator_create_memory_pool(
+                context, device, params->memory_pool_release_threshold,
+                &memory_pool));
+    if (memory_pool) IREE_TRACE_ZONE_APPEND_TEXT(z0, "MEMORY_POOLS");
+  }
+
   iree_hal_cuda_allocator_t* allocator = NULL;
   iree_status_t status = iree_allocator_malloc(
       context->host_allocator, sizeof(*allocator), (void**)&allocator);
@@ -73,7 +152,11 @@ iree_status_t iree_hal_cuda_allocator_create(
     allocator->stream = stream;
     allocator->supports_concurrent_managed_access =
         supports_concurrent_managed_access != 0;
+    allocator->is_integrated = is_integrated != 0;
+    allocator->memory_pool = memory_pool;
     *out_allocator = (iree_hal_allocator_t*)allocator;
+  } else if (memory_pool) {
+    CUDA_IGNORE_ERROR(context->syms, cuMemPoolDestroy(memory_pool));
   }
 
   IREE_TRACE_ZONE_END(z0);
@@ -87,6 +170,14 @@ static void iree_hal_cuda_allocator_destroy(
   iree_allocator_t host_allocator = allocator->context->host_allocator;
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  if (allocator->memory_pool) {
+    // Pending stream-ordered frees must complete before the pool is destroyed.
+    CUDA_IGNORE_ERROR(allocator->context->syms,
+                      cuStreamSynchronize(allocator->stream));
+    CUDA_IGNORE_ERROR(allocator->context->syms,
+                      cuMemPoolDestroy(allocator->memory_pool));
+  }
+
   iree_allocator_free(host_allocator, allocator);
 
   IREE_TRACE_ZONE_END(z0);
@@ -101,7 +192,25 @@ static iree_allocator_t iree_hal_cuda_allocator_host_allocator(
 
 static iree_status_t iree_hal_cuda_allocator_trim(
     iree_hal_allocator_t* base_allocator) {
-  return iree_ok_status();
+  iree_hal_cuda_allocator_t* allocator =
+      iree_hal_cuda_allocator_cast(base_allocator);
+  if (!allocator->memory_pool) return iree_ok_status();
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Memory released with cuMemFreeAsync only returns to the pool once the
+  // stream reaches the free; wait for that so that it can be trimmed.
+  iree_status_t status = CU_RESULT_TO_STATUS(
+      allocator->context->syms, cuStreamSynchronize(allocator->stream),
+      "cuStreamSynchronize");
+  if (iree_status_is_ok(status)) {
+    status = CU_RESULT_TO_STATUS(
+        allocator->context->syms,
+        cuMemPoolTrimTo(allocator->memory_pool, /*minBytesToKeep=*/0),
+        "cuMemPoolTrimTo");
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
 }
 
 static void iree_hal_cuda_allocator_query_statistics(
@@ -111,6 +220,18 @@ static void iree_hal_cuda_allocator_query_statistics(
     iree_hal_cuda_allocator_t* allocator =
         iree_hal_cuda_allocator_cast(base_allocator);
     memcpy(out_statistics, &allocator->statistics, sizeof(*out_statistics));
+    if (allocator->memory_pool) {
+      // Reservations include memory released to the pool and not yet returned
+      // to the device; in-use memory is tracked by the allocation counts.
+      cuuint64_t reserved_bytes = 0;
+      CUDA_IGNORE_ERROR(
+          allocator->context->syms,
+          cuMemPoolGetAttribute(allocator->memory_pool,
+                                CU_MEMPOOL_ATTR_RESERVED_MEM_CURRENT,
+                                &reserved_bytes));
+      out_statistics->device_bytes_reserved =
+          (iree_device_size_t)reserved_bytes;
+    }
   });
 }
 
@@ -144,11 +265,29 @@ iree_hal_cuda_allocator_query_buffer_compatibility(
   return compatibility;
 }
 
-static void iree_hal_cuda_buffer_free(iree_hal_cuda_context_wrapper_t* context,
+// Returns true if buffers of |memory_type| are allocated from the allocator
+// memory pool.
+static bool iree_hal_cuda_allocator_uses_memory_pool(
+    iree_hal_cuda_allocator_t* allocator, iree_hal_memory_type_t memory_type) {
+  return allocator->memory_pool &&
+         iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL) &&
+         !iree_any_bit_set(memory_type, IREE_HAL_MEMORY_TYPE_HOST_VISIBLE);
+}
+
+static void iree_hal_cuda_buffer_free(iree_hal_cuda_allocator_t* allocator,
                                       iree_hal_memory_type_t memory_type,
                                       CUdeviceptr device_ptr, void* host_ptr) {
+  iree_hal_cuda_context_wrapper_t* context = allocator->context;
   IREE_TRACE_ZONE_BEGIN(z0);
-  if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL)) {
+  if (iree_hal_cuda_allocator_uses_memory_pool(allocator, memory_type)) {
+    // Device local (pooled): returned to the pool in stream order without
+    // synchronizing the device. All work using the buffer has been issued to
+    // or joined with the allocator stream by the time it is released.
+    CUDA_IGNORE_ERROR(context->syms,
+                      cuMemFreeAsync(device_ptr, allocator->stream));
+  } else if (!allocator->is_integrated &&
+             iree_all_bits_set(memory_type,
+                               IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL)) {
     // Device local.
     CUDA_IGNORE_ERROR(context->syms, cuMemFree(device_ptr));
   } else {
@@ -183,11 +322,26 @@ static iree_status_t iree_hal_cuda_allocator_allocate_buffer(
         IREE_HAL_MEMORY_TYPE_HOST_LOCAL | IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE;
   }
 
+  // On integrated devices all memory is both device-local and host-visible:
+  // allocations are made from page-locked host memory mapped into the device
+  // address space and are made mappable so that transfers into and out of them
+  // (including the initial data upload below) are performed with a memcpy
+  // instead of a staging buffer and queue copy.
+  if (allocator->is_integrated) {
+    if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL)) {
+      memory_type |= IREE_HAL_MEMORY_TYPE_HOST_VISIBLE;
+    } else {
+      memory_type |= IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE;
+    }
+    allowed_usage |= IREE_HAL_BUFFER_USAGE_MAPPING;
+  }
+
   iree_status_t status = iree_ok_status();
   void* host_ptr = NULL;
   CUdeviceptr device_ptr = 0;
   IREE_TRACE_ZONE_BEGIN_NAMED(z0, "iree_hal_cuda_buffer_allocate");
-  if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL)) {
+  if (!allocator->is_integrated &&
+      iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL)) {
     // Device local case.
     if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_HOST_VISIBLE)) {
       status =
@@ -202,6 +356,20 @@ static iree_status_t iree_hal_cuda_allocator_allocate_buffer(
                                allocator->stream));
       }
       host_ptr = (void*)device_ptr;
+    } else if (iree_hal_cuda_allocator_uses_memory_pool(allocator,
+                                                        memory_type)) {
+      // Device only (pooled). The allocation is ordered on the stream and
+      // synchronizing makes it usable immediately from any stream as
+      // required by synchronous allocation. The stream is usually idle as
+      // submissions synchronize after they are issued.
+      status = CU_RESULT_TO_STATUS(
+          allocator->context->syms,
+          cuMemAllocFromPoolAsync(&device_ptr, allocation_size,
+                                  allocator->memory_pool, allocator->stream));
+      if (iree_status_is_ok(status)) {
+        status = CU_RESULT_TO_STATUS(allocator->context->syms,
+                                     cuStreamSynchronize(allocator->stream));
+      }
     } else {
       // Device only.
       status = CU_RESULT_TO_STATUS(allocator->context->syms,
@@ -229,7 +397,8 @@ static iree_status_t iree_hal_cuda_allocator_allocate_buffer(
         (iree_hal_allocator_t*)allocator, memory_type,
         IREE_HAL_MEMORY_ACCESS_ALL, allowed_usage, allocation_size,
         /*byte_offset=*/0,
-        /*byte_length=*/allocation_size, device_ptr, host_ptr, &buffer);
+        /*byte_length=*/allocation_size, IREE_HAL_CUDA_BUFFER_TYPE_OWNED,
+        allocator->context->cu_context, device_ptr, host_ptr, &buffer);
   }
 
   // Copy the initial contents into the buffer. This may require staging.
@@ -250,8 +419,7 @@ static iree_status_t iree_hal_cuda_allocator_allocate_buffer(
     *out_buffer = buffer;
   } else {
     if (!buffer) {
-      iree_hal_cuda_buffer_free(allocator->context, memory_type, device_ptr,
-                                host_ptr);
+      iree_hal_cuda_buffer_free(allocator, memory_type, device_ptr, host_ptr);
     } else {
       iree_hal_buffer_release(buffer);
     }
@@ -259,12 +427,71 @@ static iree_status_t iree_hal_cuda_allocator_allocate_buffer(
   return status;
 }
 
+iree_status_t iree_hal_cuda_allocator_alloca(
+    iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_buffer_usage_t allowed_usage, iree_device_size_t allocation_size,
+    iree_hal_buffer_t** out_buffer) {
+  iree_hal_cuda_allocator_t* allocator =
+      iree_hal_cuda_allocator_cast(base_allocator);
+  if (allocator->is_integrated ||
+      !iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL) ||
+      iree_any_bit_set(memory_type, IREE_HAL_MEMORY_TYPE_HOST_VISIBLE)) {
+    return iree_hal_allocator_allocate_buffer(
+        base_allocator, memory_type, allowed_usage, allocation_size,
+        iree_const_byte_span_empty(), out_buffer);
+  }
+  if (allocation_size == 0) allocation_size = 4;
+
+  CUdeviceptr device_ptr = 0;
+  IREE_TRACE_ZONE_BEGIN_NAMED(z0, "iree_hal_cuda_buffer_alloca");
+  iree_status_t status = iree_ok_status();
+  if (allocator->memory_pool) {
+    status = CU_RESULT_TO_STATUS(
+        allocator->context->syms,
+        cuMemAllocFromPoolAsync(&device_ptr, allocation_size,
+                                allocator->memory_pool, allocator->stream));
+  } else {
+    status = CU_RESULT_TO_STATUS(
+        allocator->context->syms,
+        cuMemAllocAsync(&device_ptr, allocation_size, allocator->stream));
+  }
+  IREE_TRACE_ZONE_END(z0);
+
+  // NOTE: stream-ordered allocations are released through the normal
+  // deallocate_buffer path: to the memory pool with cuMemFreeAsync when
+  // pooling and otherwise with cuMemFree.
+  iree_hal_buffer_t* buffer = NULL;
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_cuda_buffer_wrap(
+        base_allocator, memory_type, IREE_HAL_MEMORY_ACCESS_ALL, allowed_usage,
+        allocation_size, /*byte_offset=*/0, /*byte_length=*/allocation_size,
+        IREE_HAL_CUDA_BUFFER_TYPE_OWNED, allocator->context->cu_context,
+        device_ptr, /*host_ptr=*/NULL, &buffer);
+  }
+
+  if (iree_status_is_ok(status)) {
+    IREE_STATISTICS(iree_hal_allocator_statistics_record_alloc(
+        &allocator->statistics, memory_type, allocation_size));
+    *out_buffer = buffer;
+  } else if (device_ptr) {
+    iree_hal_cuda_buffer_free(allocator, memory_type, device_ptr,
+                              /*host_ptr=*/NULL);
+  }
+  return status;
+}
+
 static void iree_hal_cuda_allocator_deallocate_buffer(
     iree_hal_allocator_t* base_allocator, iree_hal_buffer_t* base_buffer) {
   iree_hal_cuda_allocator_t* allocator =
       iree_hal_cuda_allocator_cast(base_allocator);
+  if (iree_hal_cuda_buffer_type(base_buffer) ==
+      IREE_HAL_CUDA_BUFFER_TYPE_EXTERNAL) {
+    // Imported memory remains owned by the caller.
+    iree_hal_buffer_destroy(base_buffer);
+    return;
+  }
   iree_hal_memory_type_t memory_type = iree_hal_buffer_memory_type(base_buffer);
-  iree_hal_cuda_buffer_free(allocator->context, memory_type,
+  iree_hal_cuda_buffer_free(allocator, memory_type,
                             iree_hal_cuda_buffer_device_pointer(base_buffer),
                             iree_hal_cuda_buffer_host_pointer(base_buffer));
 
@@ -290,8 +517,44 @@ static iree_status_t iree_hal_cuda_allocator_import_buffer(
     iree_hal_buffer_usage_t allowed_usage,
     iree_hal_external_buffer_t* external_buffer,
     iree_hal_buffer_t** out_buffer) {
-  return iree_make_status(IREE_STATUS_UNAVAILABLE,
-                          "importing from external buffers not supported");
+  iree_hal_cuda_allocator_t* allocator =
+      iree_hal_cuda_allocator_cast(base_allocator);
+  if (external_buffer->type !=
+      IREE_HAL_EXTERNAL_BUFFER_TYPE_DEVICE_ALLOCATION) {
+    return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                            "external buffer type %d not supported",
+                            (int)external_buffer->type);
+  }
+  if (iree_any_bit_set(memory_type, IREE_HAL_MEMORY_TYPE_HOST_VISIBLE) ||
+      iree_any_bit_set(allowed_usage, IREE_HAL_BUFFER_USAGE_MAPPING)) {
+    return iree_make_status(
+        IREE_STATUS_UNAVAILABLE,
+        "imported device allocations are not host-visible or mappable");
+  }
+  CUdeviceptr device_ptr =
+      (CUdeviceptr)external_buffer->handle.device_allocation.ptr;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // The allocation may be owned by a peer device; the owning context is
+  // retained on the buffer so that copies can be issued as peer copies.
+  // Stream-ordered and memory pool allocations have no context and are
+  // addressed through unified addressing instead.
+  CUcontext context = NULL;
+  iree_status_t status = CU_RESULT_TO_STATUS(
+      allocator->context->syms,
+      cuPointerGetAttribute(&context, CU_POINTER_ATTRIBUTE_CONTEXT,
+                            device_ptr),
+      "cuPointerGetAttribute");
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_cuda_buffer_wrap(
+        base_allocator, memory_type, allowed_access, allowed_usage,
+        external_buffer->size, /*byte_offset=*/0,
+        /*byte_length=*/external_buffer->size,
+        IREE_HAL_CUDA_BUFFER_TYPE_EXTERNAL, context, device_ptr,
+        /*host_ptr=*/NULL, out_buffer);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
 }
 
 static iree_status_t iree_hal_cuda_allocator_export_buffer(
@@ -299,8 +562,22 @@ static iree_status_t iree_hal_cuda_allocator_export_buffer(
     iree_hal_external_buffer_type_t requested_type,
     iree_hal_external_buffer_flags_t requested_flags,
     iree_hal_external_buffer_t* out_external_buffer) {
-  return iree_make_status(IREE_STATUS_UNAVAILABLE,
-                          "exporting to external buffers not supported");
+  if (requested_type != IREE_HAL_EXTERNAL_BUFFER_TYPE_DEVICE_ALLOCATION) {
+    return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                            "external buffer type %d not supported",
+                            (int)requested_type);
+  }
+  // Exported pointers are valid on all devices with peer access and may be
+  // imported into the allocator of any of them.
+  memset(out_external_buffer, 0, sizeof(*out_external_buffer));
+  out_external_buffer->type = requested_type;
+  out_external_buffer->flags = requested_flags;
+  out_external_buffer->size = iree_hal_buffer_byte_length(buffer);
+  out_external_buffer->handle.device_allocation.ptr =
+      (uint64_t)(iree_hal_cuda_buffer_device_pointer(
+                     iree_hal_buffer_allocated_buffer(buffer)) +
+                 iree_hal_buffer_byte_offset(buffer));
+  return iree_ok_status();
 }
 
 static const iree_hal_allocator_vtable_t iree_hal_cuda_allocator_vtable = {
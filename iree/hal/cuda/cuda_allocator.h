@@ -9,6 +9,7 @@
 
 #include "iree/base/api.h"
 #include "iree/hal/api.h"
+#include "iree/hal/cuda/api.h"
 #include "iree/hal/cuda/context_wrapper.h"
 #include "iree/hal/cuda/status_util.h"
 
@@ -17,9 +18,23 @@ extern "C" {
 #endif  // __cplusplus
 
 // Create a cuda allocator.
+// Device-local allocations are made from a memory pool with stream-ordered
+// allocation and release on |stream| if enabled in |params| and supported by
+// |device|.
 iree_status_t iree_hal_cuda_allocator_create(
     iree_hal_device_t* base_device, iree_hal_cuda_context_wrapper_t* context,
-    CUdevice device, CUstream stream, iree_hal_allocator_t** out_allocator);
+    CUdevice device, CUstream stream,
+    const iree_hal_cuda_device_params_t* params,
+    iree_hal_allocator_t** out_allocator);
+
+// Allocates a buffer ordered on the allocator stream. Device-local memory that
+// is not host-visible is allocated with the stream-ordered allocator (from the
+// allocator memory pool if enabled) such that memory released by prior work on
+// the stream can be reused. Other memory types are allocated immediately.
+iree_status_t iree_hal_cuda_allocator_alloca(
+    iree_hal_allocator_t* allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_buffer_usage_t allowed_usage, iree_device_size_t allocation_size,
+    iree_hal_buffer_t** out_buffer);
 
 #ifdef __cplusplus
 }  // extern "C"
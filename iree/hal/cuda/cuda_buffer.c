@@ -15,6 +15,8 @@
 
 typedef struct iree_hal_cuda_buffer_t {
   iree_hal_buffer_t base;
+  iree_hal_cuda_buffer_type_t type;
+  CUcontext context;
   void* host_ptr;
   CUdeviceptr device_ptr;
 } iree_hal_cuda_buffer_t;
@@ -32,6 +34,7 @@ iree_status_t iree_hal_cuda_buffer_wrap(
     iree_hal_memory_access_t allowed_access,
     iree_hal_buffer_usage_t allowed_usage, iree_device_size_t allocation_size,
     iree_device_size_t byte_offset, iree_device_size_t byte_length,
+    iree_hal_cuda_buffer_type_t buffer_type, CUcontext context,
     CUdeviceptr device_ptr, void* host_ptr, iree_hal_buffer_t** out_buffer) {
   IREE_ASSERT_ARGUMENT(allocator);
   IREE_ASSERT_ARGUMENT(out_buffer);
@@ -47,6 +50,8 @@ iree_status_t iree_hal_cuda_buffer_wrap(
                                allocation_size, byte_offset, byte_length,
                                memory_type, allowed_access, allowed_usage,
                                &iree_hal_cuda_buffer_vtable, &buffer->base);
+    buffer->type = buffer_type;
+    buffer->context = context;
     buffer->host_ptr = host_ptr;
     buffer->device_ptr = device_ptr;
     *out_buffer = &buffer->base;
@@ -56,6 +61,10 @@ iree_status_t iree_hal_cuda_buffer_wrap(
   return status;
 }
 
+bool iree_hal_cuda_buffer_isa(iree_hal_buffer_t* buffer) {
+  return iree_hal_resource_is(buffer, &iree_hal_cuda_buffer_vtable);
+}
+
 static void iree_hal_cuda_buffer_destroy(iree_hal_buffer_t* base_buffer) {
   iree_hal_cuda_buffer_t* buffer = iree_hal_cuda_buffer_cast(base_buffer);
   iree_allocator_t host_allocator = base_buffer->host_allocator;
@@ -115,6 +124,17 @@ static iree_status_t iree_hal_cuda_buffer_flush_range(
   return iree_ok_status();
 }
 
+iree_hal_cuda_buffer_type_t iree_hal_cuda_buffer_type(
+    iree_hal_buffer_t* base_buffer) {
+  iree_hal_cuda_buffer_t* buffer = iree_hal_cuda_buffer_cast(base_buffer);
+  return buffer->type;
+}
+
+CUcontext iree_hal_cuda_buffer_context(iree_hal_buffer_t* base_buffer) {
+  iree_hal_cuda_buffer_t* buffer = iree_hal_cuda_buffer_cast(base_buffer);
+  return buffer->context;
+}
+
 CUdeviceptr iree_hal_cuda_buffer_device_pointer(
     iree_hal_buffer_t* base_buffer) {
   iree_hal_cuda_buffer_t* buffer = iree_hal_cuda_buffer_cast(base_buffer);
@@ -15,14 +15,36 @@
 extern "C" {
 #endif  // __cplusplus
 
+typedef enum iree_hal_cuda_buffer_type_e {
+  // Allocated by the allocator and released back to it when destroyed.
+  IREE_HAL_CUDA_BUFFER_TYPE_OWNED = 0,
+  // Imported from an external allocation that remains owned by the caller.
+  IREE_HAL_CUDA_BUFFER_TYPE_EXTERNAL,
+} iree_hal_cuda_buffer_type_t;
+
 // Wraps a CUDA allocation in an iree_hal_buffer_t.
+// |context| is the context owning the allocation and may differ from the
+// context of |allocator| when wrapping memory of a peer device. It is NULL if
+// the allocation is not associated with a context (such as memory pool
+// allocations) and only accessible through unified addressing.
 iree_status_t iree_hal_cuda_buffer_wrap(
     iree_hal_allocator_t* allocator, iree_hal_memory_type_t memory_type,
     iree_hal_memory_access_t allowed_access,
     iree_hal_buffer_usage_t allowed_usage, iree_device_size_t allocation_size,
     iree_device_size_t byte_offset, iree_device_size_t byte_length,
+    iree_hal_cuda_buffer_type_t buffer_type, CUcontext context,
     CUdeviceptr device_ptr, void* host_ptr, iree_hal_buffer_t** out_buffer);
 
+// Returns true if |buffer| is a CUDA buffer.
+bool iree_hal_cuda_buffer_isa(iree_hal_buffer_t* buffer);
+
+// Returns the ownership type of the given |buffer|.
+iree_hal_cuda_buffer_type_t iree_hal_cuda_buffer_type(
+    iree_hal_buffer_t* buffer);
+
+// Returns the CUDA context owning the allocation of the given |buffer|, if any.
+CUcontext iree_hal_cuda_buffer_context(iree_hal_buffer_t* buffer);
+
 // Returns the CUDA base pointer for the given |buffer|.
 // This is the entire allocated_buffer and must be offset by the buffer
 // byte_offset and byte_length when used.
@@ -14,17 +14,24 @@
 #include "iree/base/tracing.h"
 #include "iree/hal/cuda/context_wrapper.h"
 #include "iree/hal/cuda/cuda_allocator.h"
+#include "iree/hal/cuda/cuda_buffer.h"
 #include "iree/hal/cuda/cuda_event.h"
 #include "iree/hal/cuda/descriptor_set_layout.h"
+#include "iree/hal/cuda/dispatch_profiler.h"
 #include "iree/hal/cuda/dynamic_symbols.h"
 #include "iree/hal/cuda/event_semaphore.h"
 #include "iree/hal/cuda/executable_layout.h"
+#include "iree/hal/cuda/graph_capture.h"
 #include "iree/hal/cuda/graph_command_buffer.h"
+#include "iree/hal/cuda/module_cache.h"
 #include "iree/hal/cuda/nop_executable_cache.h"
+#include "iree/hal/cuda/staging_ring.h"
 #include "iree/hal/cuda/status_util.h"
 #include "iree/hal/cuda/stream_command_buffer.h"
+#include "iree/hal/cuda/stream_pool.h"
 #include "iree/hal/utils/buffer_transfer.h"
 #include "iree/hal/utils/deferred_command_buffer.h"
+#include "iree/hal/utils/preparation_pool.h"
 
 //===----------------------------------------------------------------------===//
 // iree_hal_cuda_device_t
@@ -47,14 +54,34 @@ typedef struct iree_hal_cuda_device_t {
 
   CUdevice device;
 
-  // TODO: support multiple streams.
+  // Primary stream all queue work is ordered against.
+  // TODO: support multiple queues.
   CUstream stream;
+  // Streams independent commands from stream command buffers are issued
+  // across. Includes |stream| as the primary stream.
+  iree_hal_cuda_stream_pool_t stream_pool;
+  // Pinned host memory host<->device transfers are staged through on a copy
+  // stream. Unused if params.staging_chunk_count is 0.
+  iree_hal_cuda_staging_ring_t staging_ring;
   iree_hal_cuda_context_wrapper_t context_wrapper;
   iree_hal_allocator_t* device_allocator;
 
+  // Pool used to load executables asynchronously, if enabled.
+  iree_hal_preparation_pool_t* preparation_pool;
+
+  // Persistent cache of compiled modules, if enabled.
+  iree_hal_cuda_module_cache_t* module_cache;
+
   // Cache of the direct stream command buffer initialized when in stream mode.
   // TODO: have one cached per stream once there are multiple streams.
   iree_hal_command_buffer_t* stream_command_buffer;
+
+  // Times dispatches issued by stream command buffers while profiling.
+  iree_hal_cuda_dispatch_profiler_t* dispatch_profiler;
+
+  // Capture that all command buffers record into between
+  // iree_hal_cuda_device_begin_capture and iree_hal_cuda_device_end_capture.
+  iree_hal_cuda_graph_capture_t* active_capture;
 } iree_hal_cuda_device_t;
 
 static const iree_hal_device_vtable_t iree_hal_cuda_device_vtable;
@@ -71,6 +98,13 @@ void iree_hal_cuda_device_params_initialize(
   out_params->queue_count = 8;
   out_params->command_buffer_mode = IREE_HAL_CUDA_COMMAND_BUFFER_MODE_GRAPH;
   out_params->allow_inline_execution = false;
+  out_params->concurrent_stream_count = 4;
+  out_params->executable_load_worker_count = 4;
+  out_params->executable_cache_path = iree_string_view_empty();
+  out_params->use_memory_pools = true;
+  out_params->memory_pool_release_threshold = UINT64_MAX;
+  out_params->staging_chunk_size = 4 * 1024 * 1024;
+  out_params->staging_chunk_count = 4;
 }
 
 static iree_status_t iree_hal_cuda_device_check_params(
@@ -83,6 +117,23 @@ static iree_status_t iree_hal_cuda_device_check_params(
     return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
                             "at least one queue is required");
   }
+  if (params->concurrent_stream_count == 0 ||
+      params->concurrent_stream_count >
+          IREE_HAL_CUDA_MAX_CONCURRENT_STREAM_COUNT) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "concurrent stream count must be in [1, %d]",
+                            IREE_HAL_CUDA_MAX_CONCURRENT_STREAM_COUNT);
+  }
+  if (params->staging_chunk_count >
+      IREE_HAL_CUDA_STAGING_RING_MAX_CHUNK_COUNT) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "staging chunk count must be in [0, %d]",
+                            IREE_HAL_CUDA_STAGING_RING_MAX_CHUNK_COUNT);
+  }
+  if (params->staging_chunk_count > 0 && params->staging_chunk_size == 0) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "staging chunks must be non-empty");
+  }
   return iree_ok_status();
 }
 
@@ -113,15 +164,46 @@ static iree_status_t iree_hal_cuda_device_create_internal(
 
   iree_status_t status = iree_hal_cuda_allocator_create(
       (iree_hal_device_t*)device, &device->context_wrapper, cu_device, stream,
-      &device->device_allocator);
+      params, &device->device_allocator);
+
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_cuda_stream_pool_initialize(
+        &device->context_wrapper, device->stream,
+        params->concurrent_stream_count, &device->stream_pool);
+  }
+
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_cuda_dispatch_profiler_allocate(
+        &device->context_wrapper, device->stream, &device->dispatch_profiler);
+  }
+
+  if (iree_status_is_ok(status) && params->staging_chunk_count > 0) {
+    status = iree_hal_cuda_staging_ring_initialize(
+        &device->context_wrapper, params->staging_chunk_size,
+        params->staging_chunk_count, &device->staging_ring);
+  }
+
+  if (iree_status_is_ok(status) && params->executable_load_worker_count > 0) {
+    status = iree_hal_preparation_pool_create(
+        iree_make_cstring_view("iree-cuda-load"),
+        params->executable_load_worker_count, host_allocator,
+        &device->preparation_pool);
+  }
+
+  if (iree_status_is_ok(status) &&
+      !iree_string_view_is_empty(params->executable_cache_path)) {
+    status = iree_hal_cuda_module_cache_create(
+        &device->context_wrapper, cu_device, params->executable_cache_path,
+        &device->module_cache);
+  }
 
   if (iree_status_is_ok(status) &&
       params->command_buffer_mode == IREE_HAL_CUDA_COMMAND_BUFFER_MODE_STREAM) {
     status = iree_hal_cuda_stream_command_buffer_create(
         (iree_hal_device_t*)device, &device->context_wrapper,
         IREE_HAL_COMMAND_BUFFER_MODE_ALLOW_INLINE_EXECUTION,
-        IREE_HAL_COMMAND_CATEGORY_ANY, device->stream,
-        &device->stream_command_buffer);
+        IREE_HAL_COMMAND_CATEGORY_ANY, &device->stream_pool,
+        device->dispatch_profiler, &device->stream_command_buffer);
   }
 
   if (iree_status_is_ok(status)) {
@@ -168,9 +250,17 @@ static void iree_hal_cuda_device_destroy(iree_hal_device_t* base_device) {
   iree_allocator_t host_allocator = iree_hal_device_host_allocator(base_device);
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  // Finish any pending executable loads before tearing down the context state.
+  iree_hal_preparation_pool_free(device->preparation_pool);
+  iree_hal_cuda_module_cache_free(device->module_cache);
+
   // There should be no more buffers live that use the allocator.
+  iree_hal_cuda_graph_capture_release(device->active_capture);
   iree_hal_command_buffer_release(device->stream_command_buffer);
+  iree_hal_cuda_dispatch_profiler_free(device->dispatch_profiler);
   iree_hal_allocator_release(device->device_allocator);
+  iree_hal_cuda_staging_ring_deinitialize(&device->staging_ring);
+  iree_hal_cuda_stream_pool_deinitialize(&device->stream_pool);
   CUDA_IGNORE_ERROR(device->context_wrapper.syms,
                     cuStreamDestroy(device->stream));
 
@@ -235,6 +325,20 @@ static iree_status_t iree_hal_cuda_device_create_command_buffer(
     iree_hal_queue_affinity_t queue_affinity,
     iree_hal_command_buffer_t** out_command_buffer) {
   iree_hal_cuda_device_t* device = iree_hal_cuda_device_cast(base_device);
+  if (iree_all_bits_set(mode,
+                        IREE_HAL_COMMAND_BUFFER_MODE_INDIRECT_BINDINGS)) {
+    // Requires patching graph kernel node parameters from the binding table
+    // on submission.
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "indirect command buffer bindings not supported");
+  }
+  if (device->active_capture) {
+    // All work is recorded into the capture graph regardless of mode.
+    return iree_hal_cuda_graph_command_buffer_create(
+        base_device, &device->context_wrapper, mode, command_categories,
+        queue_affinity, &device->block_pool, device->active_capture,
+        out_command_buffer);
+  }
   if (device->params.allow_inline_execution &&
       iree_all_bits_set(mode,
                         IREE_HAL_COMMAND_BUFFER_MODE_ALLOW_INLINE_EXECUTION)) {
@@ -244,13 +348,14 @@ static iree_status_t iree_hal_cuda_device_create_command_buffer(
     // directly route commands to a CUDA stream and let it eagerly flush.
     return iree_hal_cuda_stream_command_buffer_create(
         base_device, &device->context_wrapper, mode, command_categories,
-        device->stream, out_command_buffer);
+        &device->stream_pool, device->dispatch_profiler, out_command_buffer);
   }
   switch (device->params.command_buffer_mode) {
     case IREE_HAL_CUDA_COMMAND_BUFFER_MODE_GRAPH:
       return iree_hal_cuda_graph_command_buffer_create(
           base_device, &device->context_wrapper, mode, command_categories,
-          queue_affinity, &device->block_pool, out_command_buffer);
+          queue_affinity, &device->block_pool, /*capture=*/NULL,
+          out_command_buffer);
     case IREE_HAL_CUDA_COMMAND_BUFFER_MODE_STREAM:
       return iree_hal_deferred_command_buffer_create(
           base_device, mode, command_categories, &device->block_pool,
@@ -294,7 +399,8 @@ static iree_status_t iree_hal_cuda_device_create_executable_cache(
     iree_hal_executable_cache_t** out_executable_cache) {
   iree_hal_cuda_device_t* device = iree_hal_cuda_device_cast(base_device);
   return iree_hal_cuda_nop_executable_cache_create(
-      &device->context_wrapper, identifier, out_executable_cache);
+      &device->context_wrapper, device->preparation_pool, device->module_cache,
+      identifier, out_executable_cache);
 }
 
 static iree_status_t iree_hal_cuda_device_create_executable_layout(
@@ -316,12 +422,156 @@ static iree_status_t iree_hal_cuda_device_create_semaphore(
                                         out_semaphore);
 }
 
+static iree_status_t iree_hal_cuda_device_transfer_range(
+    iree_hal_device_t* base_device, iree_hal_transfer_buffer_t source,
+    iree_device_size_t source_offset, iree_hal_transfer_buffer_t target,
+    iree_device_size_t target_offset, iree_device_size_t data_length,
+    iree_hal_transfer_buffer_flags_t flags, iree_timeout_t timeout) {
+  iree_hal_cuda_device_t* device = iree_hal_cuda_device_cast(base_device);
+
+  // Stage host<->device transfers of device-only memory through the pinned
+  // ring. Host-visible memory is mapped and device<->device transfers are
+  // issued as transfer command buffers. The ring blocks until the transfer
+  // completes as CUDA has no timed waits.
+  if (device->params.staging_chunk_count > 0 &&
+      !source.device_buffer != !target.device_buffer) {
+    iree_hal_buffer_t* device_buffer =
+        source.device_buffer ? source.device_buffer : target.device_buffer;
+    iree_hal_buffer_t* allocated_buffer =
+        iree_hal_buffer_allocated_buffer(device_buffer);
+    if (!iree_all_bits_set(iree_hal_buffer_memory_type(device_buffer),
+                           IREE_HAL_MEMORY_TYPE_HOST_VISIBLE) &&
+        iree_hal_cuda_buffer_isa(allocated_buffer)) {
+      IREE_RETURN_IF_ERROR(iree_hal_buffer_validate_usage(
+          iree_hal_buffer_allowed_usage(device_buffer),
+          IREE_HAL_BUFFER_USAGE_TRANSFER));
+      IREE_RETURN_IF_ERROR(iree_hal_buffer_validate_access(
+          iree_hal_buffer_allowed_access(device_buffer),
+          target.device_buffer ? IREE_HAL_MEMORY_ACCESS_WRITE
+                               : IREE_HAL_MEMORY_ACCESS_READ));
+      iree_device_size_t buffer_offset =
+          target.device_buffer ? target_offset : source_offset;
+      if (data_length == IREE_WHOLE_BUFFER) {
+        IREE_RETURN_IF_ERROR(
+            iree_hal_buffer_validate_range(device_buffer, buffer_offset, 0));
+        data_length =
+            iree_hal_buffer_byte_length(device_buffer) - buffer_offset;
+      }
+      IREE_RETURN_IF_ERROR(iree_hal_buffer_validate_range(
+          device_buffer, buffer_offset, data_length));
+      CUdeviceptr device_ptr =
+          iree_hal_cuda_buffer_device_pointer(allocated_buffer) +
+          iree_hal_buffer_byte_offset(device_buffer) + buffer_offset;
+      if (target.device_buffer) {
+        return iree_hal_cuda_staging_ring_upload(
+            &device->staging_ring, device->stream,
+            source.host_buffer.data + source_offset, device_ptr,
+            (iree_host_size_t)data_length);
+      } else {
+        return iree_hal_cuda_staging_ring_download(
+            &device->staging_ring, device->stream, device_ptr,
+            target.host_buffer.data + target_offset,
+            (iree_host_size_t)data_length);
+      }
+    }
+  }
+
+  return iree_hal_device_submit_transfer_range_and_wait(
+      base_device, source, source_offset, target, target_offset, data_length,
+      flags, timeout);
+}
+
+// Waits on the host for all semaphores in |semaphore_list| to reach their
+// payload values. Work is issued in order on the device stream so waiting for
+// semaphores signaled by other queues or the host is all that's needed before
+// issuing dependent work.
+static iree_status_t iree_hal_cuda_device_wait_semaphore_list(
+    const iree_hal_semaphore_list_t* semaphore_list) {
+  for (iree_host_size_t i = 0; i < semaphore_list->count; ++i) {
+    IREE_RETURN_IF_ERROR(iree_hal_semaphore_wait(
+        semaphore_list->semaphores[i], semaphore_list->payload_values[i],
+        iree_infinite_timeout()));
+  }
+  return iree_ok_status();
+}
+
+// Signals all semaphores in |semaphore_list| to their payload values.
+static iree_status_t iree_hal_cuda_device_signal_semaphores(
+    const iree_hal_semaphore_list_t* semaphore_list) {
+  for (iree_host_size_t i = 0; i < semaphore_list->count; ++i) {
+    IREE_RETURN_IF_ERROR(iree_hal_semaphore_signal(
+        semaphore_list->semaphores[i], semaphore_list->payload_values[i]));
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_cuda_device_queue_alloca(
+    iree_hal_device_t* base_device, iree_hal_queue_affinity_t queue_affinity,
+    const iree_hal_semaphore_list_t wait_semaphore_list,
+    const iree_hal_semaphore_list_t signal_semaphore_list,
+    iree_hal_memory_type_t memory_type, iree_hal_buffer_usage_t allowed_usage,
+    iree_device_size_t allocation_size, iree_hal_buffer_t** out_buffer) {
+  iree_hal_cuda_device_t* device = iree_hal_cuda_device_cast(base_device);
+  // The allocation is ordered after prior work on the device stream once the
+  // waits have been satisfied.
+  IREE_RETURN_IF_ERROR(
+      iree_hal_cuda_device_wait_semaphore_list(&wait_semaphore_list));
+  iree_hal_buffer_t* buffer = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_cuda_allocator_alloca(
+      device->device_allocator, memory_type, allowed_usage, allocation_size,
+      &buffer));
+  iree_status_t status =
+      iree_hal_cuda_device_signal_semaphores(&signal_semaphore_list);
+  if (iree_status_is_ok(status)) {
+    *out_buffer = buffer;
+  } else {
+    iree_hal_buffer_release(buffer);
+  }
+  return status;
+}
+
+static iree_status_t iree_hal_cuda_device_queue_dealloca(
+    iree_hal_device_t* base_device, iree_hal_queue_affinity_t queue_affinity,
+    const iree_hal_semaphore_list_t wait_semaphore_list,
+    const iree_hal_semaphore_list_t signal_semaphore_list,
+    iree_hal_buffer_t* buffer) {
+  // The memory is returned when the last reference is released and frees are
+  // ordered after prior work on the device stream. Signaling is deferred until
+  // the waits have been satisfied such that users of the buffer guarded by
+  // them have been issued.
+  IREE_RETURN_IF_ERROR(
+      iree_hal_cuda_device_wait_semaphore_list(&wait_semaphore_list));
+  return iree_hal_cuda_device_signal_semaphores(&signal_semaphore_list);
+}
+
 static iree_status_t iree_hal_cuda_device_queue_submit(
     iree_hal_device_t* base_device,
     iree_hal_command_category_t command_categories,
     iree_hal_queue_affinity_t queue_affinity, iree_host_size_t batch_count,
     const iree_hal_submission_batch_t* batches) {
   iree_hal_cuda_device_t* device = iree_hal_cuda_device_cast(base_device);
+  if (device->active_capture) {
+    // Captured command buffers have already been appended to the capture graph
+    // in recording order and execute when the capture ends.
+    for (int i = 0; i < batch_count; i++) {
+      for (int j = 0; j < batches[i].command_buffer_count; j++) {
+        iree_hal_command_buffer_t* command_buffer =
+            batches[i].command_buffers[j];
+        if (!iree_hal_cuda_graph_command_buffer_isa(command_buffer) ||
+            iree_hal_cuda_graph_command_buffer_capture(command_buffer) !=
+                device->active_capture) {
+          return iree_make_status(
+              IREE_STATUS_FAILED_PRECONDITION,
+              "command buffers recorded outside of the active capture cannot "
+              "be submitted while capturing");
+        }
+        iree_hal_cuda_dispatch_profiler_append_dropped(
+            device->dispatch_profiler,
+            iree_hal_cuda_graph_command_buffer_dispatch_count(command_buffer));
+      }
+    }
+    return iree_ok_status();
+  }
   for (int i = 0; i < batch_count; i++) {
     for (int j = 0; j < batches[i].command_buffer_count; j++) {
       iree_hal_command_buffer_t* command_buffer = batches[i].command_buffers[j];
@@ -331,14 +581,25 @@ static iree_status_t iree_hal_cuda_device_queue_submit(
         // their completion but do not have to worry about any waits: if there
         // were waits we wouldn't have been able to execute inline!
       } else if (iree_hal_cuda_graph_command_buffer_isa(command_buffer)) {
+        if (iree_hal_cuda_graph_command_buffer_capture(command_buffer)) {
+          return iree_make_status(
+              IREE_STATUS_FAILED_PRECONDITION,
+              "captured command buffers can only be executed by replaying "
+              "their capture");
+        }
         CUgraphExec exec = iree_hal_cuda_graph_command_buffer_exec(
             batches[i].command_buffers[j]);
         CUDA_RETURN_IF_ERROR(device->context_wrapper.syms,
                              cuGraphLaunch(exec, device->stream),
                              "cuGraphLaunch");
+        // Dispatches within graphs are not timed individually.
+        iree_hal_cuda_dispatch_profiler_append_dropped(
+            device->dispatch_profiler,
+            iree_hal_cuda_graph_command_buffer_dispatch_count(command_buffer));
       } else {
         IREE_RETURN_IF_ERROR(iree_hal_deferred_command_buffer_apply(
-            batches[i].command_buffers[j], device->stream_command_buffer));
+            batches[i].command_buffers[j], device->stream_command_buffer,
+            batches[i].binding_table));
       }
     }
   }
@@ -384,6 +645,26 @@ static iree_status_t iree_hal_cuda_device_wait_idle(
   return iree_ok_status();
 }
 
+static iree_status_t iree_hal_cuda_device_profiling_begin(
+    iree_hal_device_t* base_device,
+    const iree_hal_device_profiling_options_t* options) {
+  iree_hal_cuda_device_t* device = iree_hal_cuda_device_cast(base_device);
+  return iree_hal_cuda_dispatch_profiler_begin(device->dispatch_profiler,
+                                               options);
+}
+
+static iree_status_t iree_hal_cuda_device_profiling_flush(
+    iree_hal_device_t* base_device) {
+  iree_hal_cuda_device_t* device = iree_hal_cuda_device_cast(base_device);
+  return iree_hal_cuda_dispatch_profiler_flush(device->dispatch_profiler);
+}
+
+static iree_status_t iree_hal_cuda_device_profiling_end(
+    iree_hal_device_t* base_device) {
+  iree_hal_cuda_device_t* device = iree_hal_cuda_device_cast(base_device);
+  return iree_hal_cuda_dispatch_profiler_end(device->dispatch_profiler);
+}
+
 static const iree_hal_device_vtable_t iree_hal_cuda_device_vtable = {
     .destroy = iree_hal_cuda_device_destroy,
     .id = iree_hal_cuda_device_id,
@@ -399,9 +680,132 @@ static const iree_hal_device_vtable_t iree_hal_cuda_device_vtable = {
     .create_executable_cache = iree_hal_cuda_device_create_executable_cache,
     .create_executable_layout = iree_hal_cuda_device_create_executable_layout,
     .create_semaphore = iree_hal_cuda_device_create_semaphore,
-    .transfer_range = iree_hal_device_submit_transfer_range_and_wait,
+    .transfer_range = iree_hal_cuda_device_transfer_range,
+    .queue_alloca = iree_hal_cuda_device_queue_alloca,
+    .queue_dealloca = iree_hal_cuda_device_queue_dealloca,
     .queue_submit = iree_hal_cuda_device_queue_submit,
     .submit_and_wait = iree_hal_cuda_device_submit_and_wait,
     .wait_semaphores = iree_hal_cuda_device_wait_semaphores,
     .wait_idle = iree_hal_cuda_device_wait_idle,
+    .profiling_begin = iree_hal_cuda_device_profiling_begin,
+    .profiling_flush = iree_hal_cuda_device_profiling_flush,
+    .profiling_end = iree_hal_cuda_device_profiling_end,
 };
+
+//===----------------------------------------------------------------------===//
+// Graph capture
+//===----------------------------------------------------------------------===//
+
+IREE_API_EXPORT iree_status_t
+iree_hal_cuda_device_begin_capture(iree_hal_device_t* base_device) {
+  IREE_ASSERT_ARGUMENT(base_device);
+  if (!iree_hal_resource_is(base_device, &iree_hal_cuda_device_vtable)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "device is not a CUDA device");
+  }
+  iree_hal_cuda_device_t* device = iree_hal_cuda_device_cast(base_device);
+  if (device->active_capture) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "device is already capturing");
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Flush prior work so that it is not reordered with the captured work.
+  iree_status_t status = CU_RESULT_TO_STATUS(
+      device->context_wrapper.syms, cuStreamSynchronize(device->stream),
+      "cuStreamSynchronize");
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_cuda_graph_capture_create(
+        base_device, &device->context_wrapper, device->stream,
+        &device->block_pool, &device->active_capture);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_cuda_device_end_capture(
+    iree_hal_device_t* base_device,
+    iree_hal_cuda_graph_capture_t** out_capture) {
+  IREE_ASSERT_ARGUMENT(base_device);
+  IREE_ASSERT_ARGUMENT(out_capture);
+  *out_capture = NULL;
+  if (!iree_hal_resource_is(base_device, &iree_hal_cuda_device_vtable)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "device is not a CUDA device");
+  }
+  iree_hal_cuda_device_t* device = iree_hal_cuda_device_cast(base_device);
+  if (!device->active_capture) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "device is not capturing");
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // The capture is detached even on failure so that the device can continue
+  // executing work normally.
+  iree_hal_cuda_graph_capture_t* capture = device->active_capture;
+  device->active_capture = NULL;
+
+  // Run the captured work once so that its results are available.
+  iree_status_t status = iree_hal_cuda_graph_capture_finalize(capture);
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_cuda_graph_capture_replay(capture);
+  }
+
+  if (iree_status_is_ok(status)) {
+    *out_capture = capture;
+  } else {
+    iree_hal_cuda_graph_capture_release(capture);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_cuda_device_enable_peer_access(
+    iree_hal_device_t* base_device, iree_hal_device_t* base_peer_device) {
+  IREE_ASSERT_ARGUMENT(base_device);
+  IREE_ASSERT_ARGUMENT(base_peer_device);
+  if (!iree_hal_resource_is(base_device, &iree_hal_cuda_device_vtable) ||
+      !iree_hal_resource_is(base_peer_device, &iree_hal_cuda_device_vtable)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "devices must both be CUDA devices");
+  }
+  iree_hal_cuda_device_t* device = iree_hal_cuda_device_cast(base_device);
+  iree_hal_cuda_device_t* peer_device =
+      iree_hal_cuda_device_cast(base_peer_device);
+  if (device == peer_device) return iree_ok_status();
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_hal_cuda_dynamic_symbols_t* syms = device->context_wrapper.syms;
+
+  int can_access_peer = 0;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, CU_RESULT_TO_STATUS(
+              syms,
+              cuDeviceCanAccessPeer(&can_access_peer, device->device,
+                                    peer_device->device),
+              "cuDeviceCanAccessPeer"));
+  if (!can_access_peer) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                            "device %.*s cannot access memory of device %.*s",
+                            (int)device->identifier.size,
+                            device->identifier.data,
+                            (int)peer_device->identifier.size,
+                            peer_device->identifier.data);
+  }
+
+  // Peer access is enabled from the current context to the given context.
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, CU_RESULT_TO_STATUS(
+              syms, cuCtxSetCurrent(device->context_wrapper.cu_context),
+              "cuCtxSetCurrent"));
+  CUresult result = syms->cuCtxEnablePeerAccess(
+      peer_device->context_wrapper.cu_context, /*Flags=*/0);
+  iree_status_t status = iree_ok_status();
+  if (result != CUDA_ERROR_PEER_ACCESS_ALREADY_ENABLED) {
+    status = iree_hal_cuda_result_to_status(syms, result, __FILE__, __LINE__);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
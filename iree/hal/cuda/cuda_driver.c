@@ -8,6 +8,7 @@
 #include <string.h>
 
 #include "iree/base/api.h"
+#include "iree/base/internal/synchronization.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/api.h"
 #include "iree/hal/cuda/api.h"
@@ -24,7 +25,13 @@ typedef struct iree_hal_cuda_driver_t {
   iree_string_view_t identifier;
   iree_hal_cuda_device_params_t default_params;
   int default_device_index;
-  // CUDA symbols.
+  // Guards the lazy loading of |syms|.
+  iree_slim_mutex_t syms_mutex;
+  // True once |syms| have been loaded and CUDA has been initialized.
+  bool syms_loaded;
+  // CUDA symbols. Loaded on first use with
+  // iree_hal_cuda_driver_ensure_symbols so that creating the driver does not
+  // touch libcuda.
   iree_hal_cuda_dynamic_symbols_t syms;
 } iree_hal_cuda_driver_t;
 
@@ -51,7 +58,8 @@ static iree_status_t iree_hal_cuda_driver_create_internal(
     const iree_hal_cuda_driver_options_t* options,
     iree_allocator_t host_allocator, iree_hal_driver_t** out_driver) {
   iree_hal_cuda_driver_t* driver = NULL;
-  iree_host_size_t total_size = iree_sizeof_struct(*driver) + identifier.size;
+  iree_host_size_t total_size = iree_sizeof_struct(*driver) + identifier.size +
+                                default_params->executable_cache_path.size;
   IREE_RETURN_IF_ERROR(
       iree_allocator_malloc(host_allocator, total_size, (void**)&driver));
 
@@ -62,16 +70,16 @@ static iree_status_t iree_hal_cuda_driver_create_internal(
       (char*)driver + iree_sizeof_struct(*driver));
   memcpy(&driver->default_params, default_params,
          sizeof(driver->default_params));
+  iree_string_view_append_to_buffer(
+      default_params->executable_cache_path,
+      &driver->default_params.executable_cache_path,
+      (char*)driver + iree_sizeof_struct(*driver) + identifier.size);
   driver->default_device_index = options->default_device_index;
+  iree_slim_mutex_initialize(&driver->syms_mutex);
+  driver->syms_loaded = false;
 
-  iree_status_t status =
-      iree_hal_cuda_dynamic_symbols_initialize(host_allocator, &driver->syms);
-  if (iree_status_is_ok(status)) {
-    *out_driver = (iree_hal_driver_t*)driver;
-  } else {
-    iree_hal_driver_release((iree_hal_driver_t*)driver);
-  }
-  return status;
+  *out_driver = (iree_hal_driver_t*)driver;
+  return iree_ok_status();
 }
 
 static void iree_hal_cuda_driver_destroy(iree_hal_driver_t* base_driver) {
@@ -79,7 +87,10 @@ static void iree_hal_cuda_driver_destroy(iree_hal_driver_t* base_driver) {
   iree_allocator_t host_allocator = driver->host_allocator;
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  iree_hal_cuda_dynamic_symbols_deinitialize(&driver->syms);
+  if (driver->syms_loaded) {
+    iree_hal_cuda_dynamic_symbols_deinitialize(&driver->syms);
+  }
+  iree_slim_mutex_deinitialize(&driver->syms_mutex);
   iree_allocator_free(host_allocator, driver);
 
   IREE_TRACE_ZONE_END(z0);
@@ -102,6 +113,31 @@ IREE_API_EXPORT iree_status_t iree_hal_cuda_driver_create(
   return status;
 }
 
+// Loads the CUDA symbols and initializes CUDA if this has not yet happened.
+// Failures are not cached so that a later call may retry.
+static iree_status_t iree_hal_cuda_driver_ensure_symbols(
+    iree_hal_cuda_driver_t* driver) {
+  iree_slim_mutex_lock(&driver->syms_mutex);
+  if (driver->syms_loaded) {
+    iree_slim_mutex_unlock(&driver->syms_mutex);
+    return iree_ok_status();
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_status_t status = iree_hal_cuda_dynamic_symbols_initialize(
+      driver->host_allocator, &driver->syms);
+  if (iree_status_is_ok(status)) {
+    status = CU_RESULT_TO_STATUS(&driver->syms, cuInit(0), "cuInit");
+    if (iree_status_is_ok(status)) {
+      driver->syms_loaded = true;
+    } else {
+      iree_hal_cuda_dynamic_symbols_deinitialize(&driver->syms);
+    }
+  }
+  IREE_TRACE_ZONE_END(z0);
+  iree_slim_mutex_unlock(&driver->syms_mutex);
+  return status;
+}
+
 // Populates device information from the given CUDA physical device handle.
 // |out_device_info| must point to valid memory and additional data will be
 // appended to |buffer_ptr| and the new pointer is returned.
@@ -132,6 +168,8 @@ static iree_status_t iree_hal_cuda_driver_query_available_devices(
     iree_hal_device_info_t** out_device_infos,
     iree_host_size_t* out_device_info_count) {
   iree_hal_cuda_driver_t* driver = iree_hal_cuda_driver_cast(base_driver);
+  IREE_RETURN_IF_ERROR(iree_hal_cuda_driver_ensure_symbols(driver));
+
   // Query the number of available CUDA devices.
   int device_count = 0;
   CUDA_RETURN_IF_ERROR(&driver->syms, cuDeviceGetCount(&device_count),
@@ -198,8 +236,8 @@ static iree_status_t iree_hal_cuda_driver_create_device(
   iree_hal_cuda_driver_t* driver = iree_hal_cuda_driver_cast(base_driver);
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  IREE_RETURN_AND_END_ZONE_IF_ERROR(
-      z0, CU_RESULT_TO_STATUS(&driver->syms, cuInit(0), "cuInit"));
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(z0,
+                                    iree_hal_cuda_driver_ensure_symbols(driver));
   // Use either the specified device (enumerated earlier) or whatever default
   // one was specified when the driver was created.
   CUdevice device = (CUdevice)device_id;
@@ -0,0 +1,430 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/cuda/dispatch_profiler.h"
+
+#include <string.h>
+
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/tracing.h"
+#include "iree/hal/cuda/native_executable.h"
+#include "iree/hal/cuda/status_util.h"
+#include "iree/hal/utils/dispatch_profiler.h"
+
+typedef enum iree_hal_cuda_profiled_dispatch_state_e {
+  // Acquired by a command buffer that has not yet recorded the end event.
+  IREE_HAL_CUDA_PROFILED_DISPATCH_STATE_PENDING = 0,
+  // Both events have been recorded and complete along with the dispatch.
+  IREE_HAL_CUDA_PROFILED_DISPATCH_STATE_RECORDED,
+  // Recording an event or issuing the dispatch failed and the dispatch is
+  // reported as dropped.
+  IREE_HAL_CUDA_PROFILED_DISPATCH_STATE_FAILED,
+} iree_hal_cuda_profiled_dispatch_state_t;
+
+// Events and metadata of a dispatch recorded into a slot.
+typedef struct iree_hal_cuda_profiled_dispatch_t {
+  CUevent begin_event;
+  CUevent end_event;
+  // Guarded by the profiler mutex.
+  iree_hal_cuda_profiled_dispatch_state_t state;
+  uint32_t entry_point;
+  uint32_t workgroup_count[3];
+  iree_host_size_t name_length;
+  char name[IREE_HAL_DISPATCH_PROFILER_MAX_NAME_LENGTH];
+} iree_hal_cuda_profiled_dispatch_t;
+
+struct iree_hal_cuda_dispatch_profiler_t {
+  iree_hal_cuda_context_wrapper_t* context;
+  CUstream stream;
+
+  // Stores the completed dispatches until they are delivered to the sink.
+  iree_hal_dispatch_profiler_t profiler;
+
+  // Guards the fields below.
+  iree_slim_mutex_t mutex;
+
+  // Event recorded on |stream| when profiling began and the iree_time_now()
+  // time it was observed to complete at.
+  CUevent epoch_event;
+  iree_time_t epoch_host_ns;
+
+  // Ring of event slots. Slots in [tail, head) have been acquired and not yet
+  // queried.
+  uint32_t head;
+  uint32_t tail;
+  iree_hal_cuda_profiled_dispatch_t* dispatches;
+};
+
+// Creates the events and slot storage if they do not yet exist.
+// Must be called with the profiler mutex held.
+static iree_status_t iree_hal_cuda_dispatch_profiler_prepare(
+    iree_hal_cuda_dispatch_profiler_t* profiler) {
+  if (profiler->dispatches) return iree_ok_status();
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_hal_cuda_dynamic_symbols_t* syms = profiler->context->syms;
+
+  iree_hal_cuda_profiled_dispatch_t* dispatches = NULL;
+  iree_status_t status = iree_allocator_malloc(
+      profiler->context->host_allocator,
+      IREE_HAL_CUDA_DISPATCH_PROFILER_EVENT_CAPACITY * sizeof(*dispatches),
+      (void**)&dispatches);
+  if (iree_status_is_ok(status)) {
+    memset(dispatches, 0,
+           IREE_HAL_CUDA_DISPATCH_PROFILER_EVENT_CAPACITY *
+               sizeof(*dispatches));
+    // Timing must remain enabled on all events (no CU_EVENT_DISABLE_TIMING).
+    status = CU_RESULT_TO_STATUS(
+        syms, cuEventCreate(&profiler->epoch_event, CU_EVENT_DEFAULT),
+        "cuEventCreate");
+  }
+  for (uint32_t i = 0; i < IREE_HAL_CUDA_DISPATCH_PROFILER_EVENT_CAPACITY &&
+                       iree_status_is_ok(status);
+       ++i) {
+    status = CU_RESULT_TO_STATUS(
+        syms, cuEventCreate(&dispatches[i].begin_event, CU_EVENT_DEFAULT),
+        "cuEventCreate");
+    if (iree_status_is_ok(status)) {
+      status = CU_RESULT_TO_STATUS(
+          syms, cuEventCreate(&dispatches[i].end_event, CU_EVENT_DEFAULT),
+          "cuEventCreate");
+    }
+  }
+
+  if (iree_status_is_ok(status)) {
+    profiler->dispatches = dispatches;
+    profiler->head = 0;
+    profiler->tail = 0;
+  } else if (dispatches) {
+    for (uint32_t i = 0; i < IREE_HAL_CUDA_DISPATCH_PROFILER_EVENT_CAPACITY;
+         ++i) {
+      if (dispatches[i].begin_event) {
+        CUDA_IGNORE_ERROR(syms, cuEventDestroy(dispatches[i].begin_event));
+      }
+      if (dispatches[i].end_event) {
+        CUDA_IGNORE_ERROR(syms, cuEventDestroy(dispatches[i].end_event));
+      }
+    }
+    if (profiler->epoch_event) {
+      CUDA_IGNORE_ERROR(syms, cuEventDestroy(profiler->epoch_event));
+      profiler->epoch_event = NULL;
+    }
+    iree_allocator_free(profiler->context->host_allocator, dispatches);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Records the epoch event that dispatch times are measured relative to.
+// Blocks until the work already issued to the stream has completed such that
+// the host time can be observed when the event completes.
+// Must be called with the profiler mutex held.
+static iree_status_t iree_hal_cuda_dispatch_profiler_calibrate(
+    iree_hal_cuda_dispatch_profiler_t* profiler) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_hal_cuda_dynamic_symbols_t* syms = profiler->context->syms;
+  iree_status_t status = CU_RESULT_TO_STATUS(
+      syms, cuEventRecord(profiler->epoch_event, profiler->stream),
+      "cuEventRecord");
+  if (iree_status_is_ok(status)) {
+    status = CU_RESULT_TO_STATUS(
+        syms, cuEventSynchronize(profiler->epoch_event), "cuEventSynchronize");
+  }
+  if (iree_status_is_ok(status)) {
+    profiler->epoch_host_ns = iree_time_now();
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+iree_status_t iree_hal_cuda_dispatch_profiler_allocate(
+    iree_hal_cuda_context_wrapper_t* context, CUstream stream,
+    iree_hal_cuda_dispatch_profiler_t** out_profiler) {
+  IREE_ASSERT_ARGUMENT(context);
+  IREE_ASSERT_ARGUMENT(out_profiler);
+  *out_profiler = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_cuda_dispatch_profiler_t* profiler = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(context->host_allocator, sizeof(*profiler),
+                                (void**)&profiler));
+  memset(profiler, 0, sizeof(*profiler));
+  profiler->context = context;
+  profiler->stream = stream;
+  iree_hal_dispatch_profiler_initialize(context->host_allocator,
+                                        &profiler->profiler);
+  iree_slim_mutex_initialize(&profiler->mutex);
+
+  *out_profiler = profiler;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+void iree_hal_cuda_dispatch_profiler_free(
+    iree_hal_cuda_dispatch_profiler_t* profiler) {
+  if (!profiler) return;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_hal_cuda_dynamic_symbols_t* syms = profiler->context->syms;
+  iree_allocator_t host_allocator = profiler->context->host_allocator;
+
+  if (profiler->dispatches) {
+    for (uint32_t i = 0; i < IREE_HAL_CUDA_DISPATCH_PROFILER_EVENT_CAPACITY;
+         ++i) {
+      CUDA_IGNORE_ERROR(syms,
+                        cuEventDestroy(profiler->dispatches[i].begin_event));
+      CUDA_IGNORE_ERROR(syms,
+                        cuEventDestroy(profiler->dispatches[i].end_event));
+    }
+    CUDA_IGNORE_ERROR(syms, cuEventDestroy(profiler->epoch_event));
+    iree_allocator_free(host_allocator, profiler->dispatches);
+  }
+
+  iree_slim_mutex_deinitialize(&profiler->mutex);
+  iree_hal_dispatch_profiler_deinitialize(&profiler->profiler);
+  iree_allocator_free(host_allocator, profiler);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+iree_status_t iree_hal_cuda_dispatch_profiler_begin(
+    iree_hal_cuda_dispatch_profiler_t* profiler,
+    const iree_hal_device_profiling_options_t* options) {
+  IREE_ASSERT_ARGUMENT(profiler);
+  IREE_ASSERT_ARGUMENT(options);
+  if (options->mode & ~IREE_HAL_DEVICE_PROFILING_MODE_DISPATCH_TIMESTAMPS) {
+    // CUDA has no equivalent of pipeline statistics queries; invocation
+    // counts would require CUPTI.
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "unsupported profiling mode 0x%08X",
+                            options->mode);
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // The lock is held across beginning the base profiler so that no dispatch
+  // can acquire a slot before the ring and epoch are reset.
+  iree_slim_mutex_lock(&profiler->mutex);
+  iree_status_t status = iree_ok_status();
+  if (iree_hal_dispatch_profiler_is_active(&profiler->profiler)) {
+    status = iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                              "device is already profiling");
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_cuda_dispatch_profiler_prepare(profiler);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_cuda_dispatch_profiler_calibrate(profiler);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_dispatch_profiler_begin(&profiler->profiler, options);
+  }
+  iree_slim_mutex_unlock(&profiler->mutex);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Returns the time of |event| in iree_time_now() nanoseconds. |event| must
+// have completed.
+static iree_status_t iree_hal_cuda_dispatch_profiler_event_time(
+    iree_hal_cuda_dispatch_profiler_t* profiler, CUevent event,
+    iree_time_t* out_time_ns) {
+  float elapsed_ms = 0.0f;
+  IREE_RETURN_IF_ERROR(CU_RESULT_TO_STATUS(
+      profiler->context->syms,
+      cuEventElapsedTime(&elapsed_ms, profiler->epoch_event, event),
+      "cuEventElapsedTime"));
+  *out_time_ns =
+      profiler->epoch_host_ns + (iree_time_t)((double)elapsed_ms * 1000000.0);
+  return iree_ok_status();
+}
+
+// Queries all slots that have completed in ring order and appends them to the
+// base profiler. Stops at the first slot that has not yet completed.
+// Must be called with the profiler mutex held.
+static void iree_hal_cuda_dispatch_profiler_collect(
+    iree_hal_cuda_dispatch_profiler_t* profiler) {
+  iree_hal_cuda_dynamic_symbols_t* syms = profiler->context->syms;
+  while (profiler->tail != profiler->head) {
+    iree_hal_cuda_profiled_dispatch_t* slot =
+        &profiler->dispatches[profiler->tail];
+    if (slot->state == IREE_HAL_CUDA_PROFILED_DISPATCH_STATE_PENDING) break;
+
+    bool captured = false;
+    if (slot->state == IREE_HAL_CUDA_PROFILED_DISPATCH_STATE_RECORDED) {
+      // The begin event precedes the end event on the same stream and has
+      // completed if the end event has.
+      CUresult result = syms->cuEventQuery(slot->end_event);
+      if (result == CUDA_ERROR_NOT_READY) break;
+      iree_hal_device_profiling_dispatch_t dispatch;
+      memset(&dispatch, 0, sizeof(dispatch));
+      iree_status_t status =
+          iree_hal_cuda_result_to_status(syms, result, __FILE__, __LINE__);
+      if (iree_status_is_ok(status)) {
+        status = iree_hal_cuda_dispatch_profiler_event_time(
+            profiler, slot->begin_event, &dispatch.begin_time_ns);
+      }
+      if (iree_status_is_ok(status)) {
+        // The duration is measured directly for full event resolution.
+        float duration_ms = 0.0f;
+        status = CU_RESULT_TO_STATUS(
+            syms,
+            cuEventElapsedTime(&duration_ms, slot->begin_event,
+                               slot->end_event),
+            "cuEventElapsedTime");
+        dispatch.end_time_ns =
+            dispatch.begin_time_ns +
+            (iree_time_t)((double)duration_ms * 1000000.0);
+      }
+      if (iree_status_is_ok(status)) {
+        dispatch.entry_point_name =
+            iree_make_string_view(slot->name, slot->name_length);
+        dispatch.entry_point = slot->entry_point;
+        memcpy(dispatch.workgroup_count, slot->workgroup_count,
+               sizeof(dispatch.workgroup_count));
+        iree_hal_dispatch_profiler_append(&profiler->profiler, &dispatch);
+        captured = true;
+      } else {
+        iree_status_ignore(status);
+      }
+    }
+    if (!captured) {
+      iree_hal_dispatch_profiler_append_dropped(&profiler->profiler, 1);
+    }
+
+    slot->state = IREE_HAL_CUDA_PROFILED_DISPATCH_STATE_PENDING;
+    profiler->tail =
+        (profiler->tail + 1) % IREE_HAL_CUDA_DISPATCH_PROFILER_EVENT_CAPACITY;
+  }
+}
+
+iree_status_t iree_hal_cuda_dispatch_profiler_flush(
+    iree_hal_cuda_dispatch_profiler_t* profiler) {
+  IREE_ASSERT_ARGUMENT(profiler);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_slim_mutex_lock(&profiler->mutex);
+  if (iree_hal_dispatch_profiler_is_active(&profiler->profiler)) {
+    iree_hal_cuda_dispatch_profiler_collect(profiler);
+  }
+  iree_slim_mutex_unlock(&profiler->mutex);
+  iree_status_t status = iree_hal_dispatch_profiler_flush(&profiler->profiler);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+iree_status_t iree_hal_cuda_dispatch_profiler_end(
+    iree_hal_cuda_dispatch_profiler_t* profiler) {
+  IREE_ASSERT_ARGUMENT(profiler);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_slim_mutex_lock(&profiler->mutex);
+  if (iree_hal_dispatch_profiler_is_active(&profiler->profiler)) {
+    iree_hal_cuda_dispatch_profiler_collect(profiler);
+
+    // Drop the slots of dispatches that have not completed. Their events are
+    // recorded again when the slots are reused.
+    uint32_t outstanding_count =
+        (profiler->head + IREE_HAL_CUDA_DISPATCH_PROFILER_EVENT_CAPACITY -
+         profiler->tail) %
+        IREE_HAL_CUDA_DISPATCH_PROFILER_EVENT_CAPACITY;
+    iree_hal_dispatch_profiler_append_dropped(&profiler->profiler,
+                                              outstanding_count);
+    while (profiler->tail != profiler->head) {
+      profiler->dispatches[profiler->tail].state =
+          IREE_HAL_CUDA_PROFILED_DISPATCH_STATE_PENDING;
+      profiler->tail =
+          (profiler->tail + 1) % IREE_HAL_CUDA_DISPATCH_PROFILER_EVENT_CAPACITY;
+    }
+  }
+  iree_slim_mutex_unlock(&profiler->mutex);
+  iree_status_t status = iree_hal_dispatch_profiler_end(&profiler->profiler);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+bool iree_hal_cuda_dispatch_profiler_is_active(
+    iree_hal_cuda_dispatch_profiler_t* profiler) {
+  return profiler && iree_hal_dispatch_profiler_is_active(&profiler->profiler);
+}
+
+uint32_t iree_hal_cuda_dispatch_profiler_record_begin(
+    iree_hal_cuda_dispatch_profiler_t* profiler, CUstream stream,
+    iree_hal_executable_t* executable, int32_t entry_point,
+    const uint32_t workgroup_count[3]) {
+  if (!iree_hal_cuda_dispatch_profiler_is_active(profiler)) {
+    return IREE_HAL_CUDA_DISPATCH_PROFILER_NO_SLOT;
+  }
+
+  iree_slim_mutex_lock(&profiler->mutex);
+  if (!iree_hal_dispatch_profiler_is_active(&profiler->profiler)) {
+    // Raced with the end of profiling.
+    iree_slim_mutex_unlock(&profiler->mutex);
+    return IREE_HAL_CUDA_DISPATCH_PROFILER_NO_SLOT;
+  }
+  uint32_t next_head =
+      (profiler->head + 1) % IREE_HAL_CUDA_DISPATCH_PROFILER_EVENT_CAPACITY;
+  if (next_head == profiler->tail) {
+    // All slots are outstanding; the device must be flushed more frequently.
+    iree_slim_mutex_unlock(&profiler->mutex);
+    iree_hal_dispatch_profiler_append_dropped(&profiler->profiler, 1);
+    return IREE_HAL_CUDA_DISPATCH_PROFILER_NO_SLOT;
+  }
+  uint32_t slot_index = profiler->head;
+  profiler->head = next_head;
+  iree_hal_cuda_profiled_dispatch_t* slot = &profiler->dispatches[slot_index];
+  slot->state = IREE_HAL_CUDA_PROFILED_DISPATCH_STATE_PENDING;
+  iree_slim_mutex_unlock(&profiler->mutex);
+
+  // The slot is owned by the caller until its state is changed and is not
+  // read until then.
+  iree_string_view_t name =
+      iree_hal_cuda_native_executable_entry_point_name(executable,
+                                                       entry_point);
+  slot->entry_point = (uint32_t)entry_point;
+  memcpy(slot->workgroup_count, workgroup_count,
+         sizeof(slot->workgroup_count));
+  slot->name_length = iree_min(name.size, IREE_ARRAYSIZE(slot->name) - 1);
+  memcpy(slot->name, name.data, slot->name_length);
+  slot->name[slot->name_length] = 0;
+
+  CUresult result =
+      profiler->context->syms->cuEventRecord(slot->begin_event, stream);
+  if (result != CUDA_SUCCESS) {
+    iree_slim_mutex_lock(&profiler->mutex);
+    slot->state = IREE_HAL_CUDA_PROFILED_DISPATCH_STATE_FAILED;
+    iree_slim_mutex_unlock(&profiler->mutex);
+    return IREE_HAL_CUDA_DISPATCH_PROFILER_NO_SLOT;
+  }
+  return slot_index;
+}
+
+void iree_hal_cuda_dispatch_profiler_record_end(
+    iree_hal_cuda_dispatch_profiler_t* profiler, CUstream stream,
+    uint32_t slot_index) {
+  if (slot_index == IREE_HAL_CUDA_DISPATCH_PROFILER_NO_SLOT) return;
+  iree_hal_cuda_profiled_dispatch_t* slot = &profiler->dispatches[slot_index];
+  CUresult result =
+      profiler->context->syms->cuEventRecord(slot->end_event, stream);
+  iree_slim_mutex_lock(&profiler->mutex);
+  slot->state = result == CUDA_SUCCESS
+                    ? IREE_HAL_CUDA_PROFILED_DISPATCH_STATE_RECORDED
+                    : IREE_HAL_CUDA_PROFILED_DISPATCH_STATE_FAILED;
+  iree_slim_mutex_unlock(&profiler->mutex);
+}
+
+void iree_hal_cuda_dispatch_profiler_record_abort(
+    iree_hal_cuda_dispatch_profiler_t* profiler, uint32_t slot_index) {
+  if (slot_index == IREE_HAL_CUDA_DISPATCH_PROFILER_NO_SLOT) return;
+  iree_slim_mutex_lock(&profiler->mutex);
+  profiler->dispatches[slot_index].state =
+      IREE_HAL_CUDA_PROFILED_DISPATCH_STATE_FAILED;
+  iree_slim_mutex_unlock(&profiler->mutex);
+}
+
+void iree_hal_cuda_dispatch_profiler_append_dropped(
+    iree_hal_cuda_dispatch_profiler_t* profiler, iree_host_size_t count) {
+  if (!iree_hal_cuda_dispatch_profiler_is_active(profiler) || !count) return;
+  iree_hal_dispatch_profiler_append_dropped(&profiler->profiler, count);
+}
@@ -6,12 +6,24 @@
 
 CU_PFN_DECL(cuCtxCreate, CUcontext*, unsigned int, CUdevice)
 CU_PFN_DECL(cuCtxDestroy, CUcontext)
+CU_PFN_DECL(cuCtxEnablePeerAccess, CUcontext, unsigned int)
+CU_PFN_DECL(cuCtxSetCurrent, CUcontext)
 CU_PFN_DECL(cuDeviceGet, CUdevice*, int)
+CU_PFN_DECL(cuDeviceCanAccessPeer, int*, CUdevice, CUdevice)
 CU_PFN_DECL(cuDeviceGetCount, int*)
 CU_PFN_DECL(cuDeviceGetName, char*, int, CUdevice)
 CU_PFN_DECL(cuDeviceGetAttribute, int *, CUdevice_attribute, CUdevice)
+CU_PFN_DECL(cuDriverGetVersion, int*)
+CU_PFN_DECL(cuEventCreate, CUevent*, unsigned int)
+CU_PFN_DECL(cuEventDestroy, CUevent)
+CU_PFN_DECL(cuEventElapsedTime, float*, CUevent, CUevent)
+CU_PFN_DECL(cuEventQuery, CUevent)
+CU_PFN_DECL(cuEventRecord, CUevent, CUstream)
+CU_PFN_DECL(cuEventSynchronize, CUevent)
 CU_PFN_DECL(cuGetErrorName, CUresult, const char**)
 CU_PFN_DECL(cuGetErrorString, CUresult, const char**)
+CU_PFN_DECL(cuGraphAddEmptyNode, CUgraphNode*, CUgraph, const CUgraphNode*,
+            size_t)
 CU_PFN_DECL(cuGraphAddMemcpyNode, CUgraphNode*, CUgraph, const CUgraphNode*,
             size_t, const CUDA_MEMCPY3D*, CUcontext)
 CU_PFN_DECL(cuGraphAddMemsetNode, CUgraphNode*, CUgraph, const CUgraphNode*,
@@ -21,6 +33,12 @@ CU_PFN_DECL(cuGraphAddKernelNode, CUgraphNode*, CUgraph, const CUgraphNode*,
 CU_PFN_DECL(cuGraphCreate, CUgraph*, unsigned int)
 CU_PFN_DECL(cuGraphDestroy, CUgraph)
 CU_PFN_DECL(cuGraphExecDestroy, CUgraphExec)
+CU_PFN_DECL(cuGraphExecKernelNodeSetParams, CUgraphExec, CUgraphNode,
+            const CUDA_KERNEL_NODE_PARAMS*)
+CU_PFN_DECL(cuGraphExecMemcpyNodeSetParams, CUgraphExec, CUgraphNode,
+            const CUDA_MEMCPY3D*, CUcontext)
+CU_PFN_DECL(cuGraphExecMemsetNodeSetParams, CUgraphExec, CUgraphNode,
+            const CUDA_MEMSET_NODE_PARAMS*, CUcontext)
 CU_PFN_DECL(cuGraphGetNodes, CUgraph, CUgraphNode*, size_t*)
 CU_PFN_DECL(cuGraphInstantiate, CUgraphExec*, CUgraph, CUgraphNode*, char*,
             size_t)
@@ -29,11 +47,27 @@ CU_PFN_DECL(cuInit, unsigned int)
 CU_PFN_DECL(cuMemAllocManaged, CUdeviceptr*, size_t, unsigned int)
 CU_PFN_DECL(cuMemPrefetchAsync, CUdeviceptr, size_t, CUdevice, CUstream)
 CU_PFN_DECL(cuMemAlloc, CUdeviceptr*, size_t)
+CU_PFN_DECL(cuMemAllocAsync, CUdeviceptr*, size_t, CUstream)
+CU_PFN_DECL(cuMemAllocFromPoolAsync, CUdeviceptr*, size_t, CUmemoryPool,
+            CUstream)
 CU_PFN_DECL(cuMemFree, CUdeviceptr)
+CU_PFN_DECL(cuMemFreeAsync, CUdeviceptr, CUstream)
 CU_PFN_DECL(cuMemFreeHost, void*)
 CU_PFN_DECL(cuMemHostAlloc, void**, size_t, unsigned int)
 CU_PFN_DECL(cuMemHostGetDevicePointer, CUdeviceptr*, void*, unsigned int)
+CU_PFN_DECL(cuMemPoolCreate, CUmemoryPool*, const CUmemPoolProps*)
+CU_PFN_DECL(cuMemPoolDestroy, CUmemoryPool)
+CU_PFN_DECL(cuMemPoolGetAttribute, CUmemoryPool, CUmemPool_attribute, void*)
+CU_PFN_DECL(cuMemPoolSetAttribute, CUmemoryPool, CUmemPool_attribute, void*)
+CU_PFN_DECL(cuMemPoolTrimTo, CUmemoryPool, size_t)
+CU_PFN_DECL(cuPointerGetAttribute, void*, CUpointer_attribute, CUdeviceptr)
+CU_PFN_DECL(cuLinkAddData, CUlinkState, CUjitInputType, void*, size_t,
+            const char*, unsigned int, CUjit_option*, void**)
+CU_PFN_DECL(cuLinkComplete, CUlinkState, void**, size_t*)
+CU_PFN_DECL(cuLinkCreate, unsigned int, CUjit_option*, void**, CUlinkState*)
+CU_PFN_DECL(cuLinkDestroy, CUlinkState)
 CU_PFN_DECL(cuModuleGetFunction, CUfunction*, CUmodule, const char*)
+CU_PFN_DECL(cuModuleLoadData, CUmodule*, const void*)
 CU_PFN_DECL(cuModuleLoadDataEx, CUmodule*, const void*, unsigned int,
             CUjit_option*, void**)
 CU_PFN_DECL(cuModuleUnload, CUmodule)
@@ -49,6 +83,9 @@ CU_PFN_DECL(cuMemsetD8Async, unsigned long long, unsigned char, size_t,
             CUstream)
 
 CU_PFN_DECL(cuMemcpyAsync, CUdeviceptr, CUdeviceptr, size_t, CUstream)
+CU_PFN_DECL(cuMemcpyDtoH, void*, CUdeviceptr, size_t)
+CU_PFN_DECL(cuMemcpyPeerAsync, CUdeviceptr, CUcontext, CUdeviceptr, CUcontext,
+            size_t, CUstream)
 CU_PFN_DECL(cuLaunchKernel, CUfunction, unsigned int, unsigned int,
             unsigned int, unsigned int, unsigned int, unsigned int,
             unsigned int, CUstream, void **, void **)
@@ -17,7 +17,11 @@ typedef struct iree_hal_cuda_executable_layout_t {
   iree_hal_cuda_context_wrapper_t* context;
   iree_host_size_t push_constant_base_index;
   iree_host_size_t push_constant_count;
+  // Size of the packed kernel arguments precomputed from the layout.
+  iree_host_size_t kernel_args_size;
   iree_host_size_t set_layout_count;
+  // Base binding index of each set, in trailing storage after |set_layouts|.
+  iree_host_size_t* set_base_bindings;
   iree_hal_descriptor_set_layout_t* set_layouts[];
 } iree_hal_cuda_executable_layout_t;
 
@@ -57,19 +61,37 @@ iree_status_t iree_hal_cuda_executable_layout_create(
   IREE_TRACE_ZONE_BEGIN(z0);
 
   if (push_constant_count > IREE_HAL_CUDA_MAX_PUSH_CONSTANT_COUNT) {
+    IREE_TRACE_ZONE_END(z0);
     return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
                             "push constant count %zu over the limit of %d",
                             push_constant_count,
                             IREE_HAL_CUDA_MAX_PUSH_CONSTANT_COUNT);
   }
 
-  // Currently the executable layout doesn't do anything.
-  // TODO: Handle creating the argument layout at that time hadling both push
-  // constant and buffers.
+  // Compute the packed kernel argument layout once such that dispatches only
+  // need to copy the push constants into place.
+  iree_host_size_t binding_count = 0;
+  for (iree_host_size_t i = 0; i < set_layout_count; ++i) {
+    binding_count +=
+        iree_hal_cuda_descriptor_set_layout_binding_count(set_layouts[i]);
+  }
+  iree_host_size_t kernel_args_size = binding_count * sizeof(CUdeviceptr) +
+                                      push_constant_count * sizeof(uint32_t);
+  if (kernel_args_size > IREE_HAL_CUDA_MAX_KERNEL_ARG_SIZE) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "%zu bindings and %zu push constants exceed the kernel argument limit "
+        "of %zu bytes",
+        binding_count, push_constant_count,
+        (iree_host_size_t)IREE_HAL_CUDA_MAX_KERNEL_ARG_SIZE);
+  }
+
   iree_hal_cuda_executable_layout_t* executable_layout = NULL;
   iree_host_size_t total_size =
       sizeof(*executable_layout) +
-      set_layout_count * sizeof(*executable_layout->set_layouts);
+      set_layout_count * sizeof(*executable_layout->set_layouts) +
+      set_layout_count * sizeof(*executable_layout->set_base_bindings);
   iree_status_t status = iree_allocator_malloc(
       context->host_allocator, total_size, (void**)&executable_layout);
   if (iree_status_is_ok(status)) {
@@ -77,15 +99,19 @@ iree_status_t iree_hal_cuda_executable_layout_create(
                                  &executable_layout->resource);
     executable_layout->context = context;
     executable_layout->set_layout_count = set_layout_count;
+    executable_layout->set_base_bindings =
+        (iree_host_size_t*)(executable_layout->set_layouts + set_layout_count);
     iree_host_size_t binding_number = 0;
     for (iree_host_size_t i = 0; i < set_layout_count; ++i) {
       executable_layout->set_layouts[i] = set_layouts[i];
       iree_hal_descriptor_set_layout_retain(set_layouts[i]);
+      executable_layout->set_base_bindings[i] = binding_number;
       binding_number +=
           iree_hal_cuda_descriptor_set_layout_binding_count(set_layouts[i]);
     }
     executable_layout->push_constant_base_index = binding_number;
     executable_layout->push_constant_count = push_constant_count;
+    executable_layout->kernel_args_size = kernel_args_size;
     *out_executable_layout = (iree_hal_executable_layout_t*)executable_layout;
   }
   IREE_TRACE_ZONE_END(z0);
@@ -96,14 +122,9 @@ iree_host_size_t iree_hal_cuda_base_binding_index(
     iree_hal_executable_layout_t* base_executable_layout, uint32_t set) {
   iree_hal_cuda_executable_layout_t* executable_layout =
       iree_hal_cuda_executable_layout_cast(base_executable_layout);
-  iree_host_size_t base_binding = 0;
-  for (iree_host_size_t i = 0; i < set; ++i) {
-    iree_host_size_t binding_count =
-        iree_hal_cuda_descriptor_set_layout_binding_count(
-            executable_layout->set_layouts[i]);
-    base_binding += binding_count;
-  }
-  return base_binding;
+  return set < executable_layout->set_layout_count
+             ? executable_layout->set_base_bindings[set]
+             : executable_layout->push_constant_base_index;
 }
 
 iree_host_size_t iree_hal_cuda_push_constant_index(
@@ -120,6 +141,20 @@ iree_host_size_t iree_hal_cuda_executable_layout_num_constants(
   return executable_layout->push_constant_count;
 }
 
+iree_host_size_t iree_hal_cuda_executable_layout_push_constant_offset(
+    iree_hal_executable_layout_t* base_executable_layout) {
+  iree_hal_cuda_executable_layout_t* executable_layout =
+      iree_hal_cuda_executable_layout_cast(base_executable_layout);
+  return executable_layout->push_constant_base_index * sizeof(CUdeviceptr);
+}
+
+iree_host_size_t iree_hal_cuda_executable_layout_kernel_args_size(
+    iree_hal_executable_layout_t* base_executable_layout) {
+  iree_hal_cuda_executable_layout_t* executable_layout =
+      iree_hal_cuda_executable_layout_cast(base_executable_layout);
+  return executable_layout->kernel_args_size;
+}
+
 static const iree_hal_executable_layout_vtable_t
     iree_hal_cuda_executable_layout_vtable = {
         .destroy = iree_hal_cuda_executable_layout_destroy,
@@ -17,6 +17,9 @@ extern "C" {
 
 #define IREE_HAL_CUDA_MAX_PUSH_CONSTANT_COUNT 64
 
+// Maximum size, in bytes, of the packed kernel arguments of a dispatch.
+#define IREE_HAL_CUDA_MAX_KERNEL_ARG_SIZE (128 * sizeof(CUdeviceptr))
+
 // Creates the kernel arguments.
 iree_status_t iree_hal_cuda_executable_layout_create(
     iree_hal_cuda_context_wrapper_t* context, iree_host_size_t set_layout_count,
@@ -36,6 +39,19 @@ iree_host_size_t iree_hal_cuda_push_constant_index(
 iree_host_size_t iree_hal_cuda_executable_layout_num_constants(
     iree_hal_executable_layout_t* base_executable_layout);
 
+// Kernel arguments of dispatches using the layout are packed into a single
+// argument buffer passed with CU_LAUNCH_PARAM_BUFFER_POINTER: one device
+// pointer per binding in binding order followed by the 32-bit push constants,
+// each naturally aligned as the kernel parameters are laid out.
+
+// Return the byte offset of the push constants in the packed kernel arguments.
+iree_host_size_t iree_hal_cuda_executable_layout_push_constant_offset(
+    iree_hal_executable_layout_t* base_executable_layout);
+
+// Return the total size, in bytes, of the packed kernel arguments.
+iree_host_size_t iree_hal_cuda_executable_layout_kernel_args_size(
+    iree_hal_executable_layout_t* base_executable_layout);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
@@ -0,0 +1,418 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/cuda/graph_capture.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "iree/base/internal/atomics.h"
+#include "iree/base/tracing.h"
+#include "iree/hal/cuda/cuda_buffer.h"
+#include "iree/hal/cuda/dynamic_symbols.h"
+#include "iree/hal/cuda/graph_dependencies.h"
+#include "iree/hal/cuda/status_util.h"
+#include "iree/hal/utils/resource_set.h"
+
+typedef enum iree_hal_cuda_graph_capture_node_type_e {
+  IREE_HAL_CUDA_GRAPH_CAPTURE_NODE_TYPE_KERNEL = 0,
+  IREE_HAL_CUDA_GRAPH_CAPTURE_NODE_TYPE_MEMSET,
+  IREE_HAL_CUDA_GRAPH_CAPTURE_NODE_TYPE_MEMCPY,
+} iree_hal_cuda_graph_capture_node_type_t;
+
+// Parameters of a captured node retained so that they can be updated.
+typedef struct iree_hal_cuda_graph_capture_node_t {
+  struct iree_hal_cuda_graph_capture_node_t* next;
+  iree_hal_cuda_graph_capture_node_type_t type;
+  CUgraphNode node;
+  union {
+    struct {
+      CUDA_KERNEL_NODE_PARAMS params;
+      iree_host_size_t binding_count;
+      iree_host_size_t args_size;
+      // Copy of the packed kernel arguments stored in trailing storage;
+      // params.extra is rebuilt to point at it when updating the node.
+      CUdeviceptr* args;
+    } kernel;
+    CUDA_MEMSET_NODE_PARAMS memset;
+    CUDA_MEMCPY3D memcpy;
+  };
+} iree_hal_cuda_graph_capture_node_t;
+
+struct iree_hal_cuda_graph_capture_t {
+  iree_atomic_ref_count_t ref_count;
+  iree_hal_device_t* device;
+  iree_hal_cuda_context_wrapper_t* context;
+  CUstream stream;
+
+  // Captured node records; allocated from the arena.
+  iree_arena_allocator_t arena;
+  iree_hal_cuda_graph_capture_node_t* node_head;
+  iree_hal_cuda_graph_capture_node_t* node_tail;
+
+  // Retains all command buffers and buffers referenced by the graph.
+  iree_hal_resource_set_t* resource_set;
+
+  // Graph being recorded into. Kept after instantiation as updating the
+  // executable graph requires the node handles of the source graph.
+  CUgraph graph;
+  // Orders nodes across barriers from captured commands and command buffers.
+  iree_hal_cuda_graph_dependencies_t dependencies;
+  CUgraphExec exec;
+};
+
+iree_status_t iree_hal_cuda_graph_capture_create(
+    iree_hal_device_t* device, iree_hal_cuda_context_wrapper_t* context,
+    CUstream stream, iree_arena_block_pool_t* block_pool,
+    iree_hal_cuda_graph_capture_t** out_capture) {
+  IREE_ASSERT_ARGUMENT(device);
+  IREE_ASSERT_ARGUMENT(context);
+  IREE_ASSERT_ARGUMENT(block_pool);
+  IREE_ASSERT_ARGUMENT(out_capture);
+  *out_capture = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_cuda_graph_capture_t* capture = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(context->host_allocator, sizeof(*capture),
+                                (void**)&capture));
+  memset(capture, 0, sizeof(*capture));
+  iree_atomic_ref_count_init(&capture->ref_count);
+  capture->device = device;
+  iree_hal_device_retain(capture->device);
+  capture->context = context;
+  capture->stream = stream;
+  iree_arena_initialize(block_pool, &capture->arena);
+  iree_hal_cuda_graph_dependencies_initialize(context, &capture->dependencies);
+
+  iree_status_t status =
+      iree_hal_resource_set_allocate(block_pool, &capture->resource_set);
+  if (iree_status_is_ok(status)) {
+    status = CU_RESULT_TO_STATUS(context->syms,
+                                 cuGraphCreate(&capture->graph, /*flags=*/0),
+                                 "cuGraphCreate");
+  }
+
+  if (iree_status_is_ok(status)) {
+    *out_capture = capture;
+  } else {
+    iree_hal_cuda_graph_capture_release(capture);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_cuda_graph_capture_destroy(
+    iree_hal_cuda_graph_capture_t* capture) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_hal_cuda_context_wrapper_t* context = capture->context;
+  iree_hal_device_t* device = capture->device;
+
+  if (capture->exec) {
+    CUDA_IGNORE_ERROR(context->syms, cuGraphExecDestroy(capture->exec));
+  }
+  if (capture->graph) {
+    CUDA_IGNORE_ERROR(context->syms, cuGraphDestroy(capture->graph));
+  }
+  if (capture->resource_set) {
+    iree_hal_resource_set_free(capture->resource_set);
+  }
+  iree_hal_cuda_graph_dependencies_deinitialize(&capture->dependencies);
+  iree_arena_deinitialize(&capture->arena);
+  iree_allocator_free(context->host_allocator, capture);
+
+  // The device owns the context and must outlive all uses of it.
+  iree_hal_device_release(device);
+  IREE_TRACE_ZONE_END(z0);
+}
+
+IREE_API_EXPORT void iree_hal_cuda_graph_capture_retain(
+    iree_hal_cuda_graph_capture_t* capture) {
+  if (IREE_LIKELY(capture)) {
+    iree_atomic_ref_count_inc(&capture->ref_count);
+  }
+}
+
+IREE_API_EXPORT void iree_hal_cuda_graph_capture_release(
+    iree_hal_cuda_graph_capture_t* capture) {
+  if (IREE_LIKELY(capture) &&
+      iree_atomic_ref_count_dec(&capture->ref_count) == 1) {
+    iree_hal_cuda_graph_capture_destroy(capture);
+  }
+}
+
+iree_status_t iree_hal_cuda_graph_capture_insert_resources(
+    iree_hal_cuda_graph_capture_t* capture, iree_host_size_t count,
+    const void* resources) {
+  return iree_hal_resource_set_insert(capture->resource_set, count, resources);
+}
+
+// Allocates a node record of |type| with |trailing_size| bytes of storage.
+static iree_status_t iree_hal_cuda_graph_capture_allocate_node(
+    iree_hal_cuda_graph_capture_t* capture,
+    iree_hal_cuda_graph_capture_node_type_t type,
+    iree_host_size_t trailing_size,
+    iree_hal_cuda_graph_capture_node_t** out_node) {
+  if (IREE_UNLIKELY(capture->exec)) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "capture has ended and cannot be recorded into");
+  }
+  iree_hal_cuda_graph_capture_node_t* node = NULL;
+  IREE_RETURN_IF_ERROR(iree_arena_allocate(
+      &capture->arena, sizeof(*node) + trailing_size, (void**)&node));
+  memset(node, 0, sizeof(*node));
+  node->type = type;
+  *out_node = node;
+  return iree_ok_status();
+}
+
+// Links |node| after all prior nodes once it has been added to the graph.
+static iree_status_t iree_hal_cuda_graph_capture_link_node(
+    iree_hal_cuda_graph_capture_t* capture,
+    iree_hal_cuda_graph_capture_node_t* node) {
+  if (capture->node_tail) {
+    capture->node_tail->next = node;
+  } else {
+    capture->node_head = node;
+  }
+  capture->node_tail = node;
+  return iree_hal_cuda_graph_dependencies_append(&capture->dependencies,
+                                                 node->node);
+}
+
+iree_status_t iree_hal_cuda_graph_capture_barrier(
+    iree_hal_cuda_graph_capture_t* capture) {
+  return iree_hal_cuda_graph_dependencies_barrier(&capture->dependencies,
+                                                  capture->graph);
+}
+
+iree_status_t iree_hal_cuda_graph_capture_add_kernel_node(
+    iree_hal_cuda_graph_capture_t* capture,
+    const CUDA_KERNEL_NODE_PARAMS* params, iree_host_size_t binding_count,
+    const void* args, iree_host_size_t args_size) {
+  iree_hal_cuda_graph_capture_node_t* node = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_cuda_graph_capture_allocate_node(
+      capture, IREE_HAL_CUDA_GRAPH_CAPTURE_NODE_TYPE_KERNEL, args_size,
+      &node));
+  node->kernel.params = *params;
+  node->kernel.params.kernelParams = NULL;
+  node->kernel.params.extra = NULL;
+  node->kernel.args = (CUdeviceptr*)(node + 1);
+  node->kernel.binding_count = binding_count;
+  node->kernel.args_size = args_size;
+  memcpy(node->kernel.args, args, args_size);
+
+  size_t dep_count = 0;
+  const CUgraphNode* deps = iree_hal_cuda_graph_dependencies_nodes(
+      &capture->dependencies, &dep_count);
+  CUDA_RETURN_IF_ERROR(capture->context->syms,
+                       cuGraphAddKernelNode(&node->node, capture->graph, deps,
+                                            dep_count, params),
+                       "cuGraphAddKernelNode");
+  return iree_hal_cuda_graph_capture_link_node(capture, node);
+}
+
+iree_status_t iree_hal_cuda_graph_capture_add_memset_node(
+    iree_hal_cuda_graph_capture_t* capture,
+    const CUDA_MEMSET_NODE_PARAMS* params) {
+  iree_hal_cuda_graph_capture_node_t* node = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_cuda_graph_capture_allocate_node(
+      capture, IREE_HAL_CUDA_GRAPH_CAPTURE_NODE_TYPE_MEMSET, 0, &node));
+  node->memset = *params;
+
+  size_t dep_count = 0;
+  const CUgraphNode* deps = iree_hal_cuda_graph_dependencies_nodes(
+      &capture->dependencies, &dep_count);
+  CUDA_RETURN_IF_ERROR(
+      capture->context->syms,
+      cuGraphAddMemsetNode(&node->node, capture->graph, deps, dep_count, params,
+                           capture->context->cu_context),
+      "cuGraphAddMemsetNode");
+  return iree_hal_cuda_graph_capture_link_node(capture, node);
+}
+
+iree_status_t iree_hal_cuda_graph_capture_add_memcpy_node(
+    iree_hal_cuda_graph_capture_t* capture, const CUDA_MEMCPY3D* params) {
+  iree_hal_cuda_graph_capture_node_t* node = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_cuda_graph_capture_allocate_node(
+      capture, IREE_HAL_CUDA_GRAPH_CAPTURE_NODE_TYPE_MEMCPY, 0, &node));
+  node->memcpy = *params;
+
+  size_t dep_count = 0;
+  const CUgraphNode* deps = iree_hal_cuda_graph_dependencies_nodes(
+      &capture->dependencies, &dep_count);
+  CUDA_RETURN_IF_ERROR(
+      capture->context->syms,
+      cuGraphAddMemcpyNode(&node->node, capture->graph, deps, dep_count, params,
+                           capture->context->cu_context),
+      "cuGraphAddMemcpyNode");
+  return iree_hal_cuda_graph_capture_link_node(capture, node);
+}
+
+iree_status_t iree_hal_cuda_graph_capture_finalize(
+    iree_hal_cuda_graph_capture_t* capture) {
+  IREE_ASSERT_ARGUMENT(capture);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  CUgraphNode error_node = NULL;
+  iree_status_t status = CU_RESULT_TO_STATUS(
+      capture->context->syms,
+      cuGraphInstantiate(&capture->exec, capture->graph, &error_node,
+                         /*logBuffer=*/NULL, /*bufferSize=*/0),
+      "cuGraphInstantiate");
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Rebases |*ptr| from the |old_ptr| range of |length| bytes to |new_ptr|.
+// Returns true if |*ptr| was within the range and updated.
+static bool iree_hal_cuda_graph_capture_rebase(CUdeviceptr* ptr,
+                                               CUdeviceptr old_ptr,
+                                               iree_device_size_t length,
+                                               CUdeviceptr new_ptr) {
+  if (*ptr < old_ptr || *ptr >= old_ptr + length) return false;
+  *ptr = new_ptr + (*ptr - old_ptr);
+  return true;
+}
+
+// Updates a kernel |node| if any of its bindings reference the old range.
+static iree_status_t iree_hal_cuda_graph_capture_update_kernel_node(
+    iree_hal_cuda_graph_capture_t* capture,
+    iree_hal_cuda_graph_capture_node_t* node, CUdeviceptr old_ptr,
+    iree_device_size_t length, CUdeviceptr new_ptr) {
+  bool any_updated = false;
+  for (iree_host_size_t i = 0; i < node->kernel.binding_count; ++i) {
+    any_updated |= iree_hal_cuda_graph_capture_rebase(&node->kernel.args[i],
+                                                      old_ptr, length, new_ptr);
+  }
+  if (!any_updated) return iree_ok_status();
+  size_t args_size = node->kernel.args_size;
+  void* extra[] = {
+      CU_LAUNCH_PARAM_BUFFER_POINTER, node->kernel.args,
+      CU_LAUNCH_PARAM_BUFFER_SIZE,    &args_size,
+      CU_LAUNCH_PARAM_END,
+  };
+  CUDA_KERNEL_NODE_PARAMS params = node->kernel.params;
+  params.extra = extra;
+  return CU_RESULT_TO_STATUS(
+      capture->context->syms,
+      cuGraphExecKernelNodeSetParams(capture->exec, node->node, &params),
+      "cuGraphExecKernelNodeSetParams");
+}
+
+// Updates a memset |node| if its target references the old range.
+static iree_status_t iree_hal_cuda_graph_capture_update_memset_node(
+    iree_hal_cuda_graph_capture_t* capture,
+    iree_hal_cuda_graph_capture_node_t* node, CUdeviceptr old_ptr,
+    iree_device_size_t length, CUdeviceptr new_ptr) {
+  if (!iree_hal_cuda_graph_capture_rebase(&node->memset.dst, old_ptr, length,
+                                          new_ptr)) {
+    return iree_ok_status();
+  }
+  return CU_RESULT_TO_STATUS(
+      capture->context->syms,
+      cuGraphExecMemsetNodeSetParams(capture->exec, node->node, &node->memset,
+                                     capture->context->cu_context),
+      "cuGraphExecMemsetNodeSetParams");
+}
+
+// Updates a memcpy |node| if its source or target references the old range.
+static iree_status_t iree_hal_cuda_graph_capture_update_memcpy_node(
+    iree_hal_cuda_graph_capture_t* capture,
+    iree_hal_cuda_graph_capture_node_t* node, CUdeviceptr old_ptr,
+    iree_device_size_t length, CUdeviceptr new_ptr) {
+  // Copies are recorded as base pointers with offsets; fold them together so
+  // that the effective address is what is tested against the range.
+  CUDA_MEMCPY3D* params = &node->memcpy;
+  CUdeviceptr src = params->srcDevice + params->srcXInBytes;
+  CUdeviceptr dst = params->dstDevice + params->dstXInBytes;
+  bool src_updated =
+      iree_hal_cuda_graph_capture_rebase(&src, old_ptr, length, new_ptr);
+  bool dst_updated =
+      iree_hal_cuda_graph_capture_rebase(&dst, old_ptr, length, new_ptr);
+  if (!src_updated && !dst_updated) return iree_ok_status();
+  params->srcDevice = src;
+  params->srcXInBytes = 0;
+  params->dstDevice = dst;
+  params->dstXInBytes = 0;
+  return CU_RESULT_TO_STATUS(
+      capture->context->syms,
+      cuGraphExecMemcpyNodeSetParams(capture->exec, node->node, params,
+                                     capture->context->cu_context),
+      "cuGraphExecMemcpyNodeSetParams");
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_cuda_graph_capture_update_buffer(
+    iree_hal_cuda_graph_capture_t* capture, iree_hal_buffer_t* captured_buffer,
+    iree_hal_buffer_t* buffer) {
+  IREE_ASSERT_ARGUMENT(capture);
+  IREE_ASSERT_ARGUMENT(captured_buffer);
+  IREE_ASSERT_ARGUMENT(buffer);
+  if (IREE_UNLIKELY(!capture->exec)) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "capture has not ended");
+  }
+  iree_device_size_t length = iree_hal_buffer_byte_length(captured_buffer);
+  if (IREE_UNLIKELY(iree_hal_buffer_byte_length(buffer) < length)) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "replacement buffer of %" PRIdsz " bytes is smaller than the %" PRIdsz
+        " byte captured buffer",
+        iree_hal_buffer_byte_length(buffer), length);
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Keep the new buffer live for as long as the graph may reference it. The
+  // captured buffer remains retained as other ranges may alias it.
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_resource_set_insert(capture->resource_set, 1, &buffer));
+
+  CUdeviceptr old_ptr = iree_hal_cuda_buffer_device_pointer(
+                            iree_hal_buffer_allocated_buffer(captured_buffer)) +
+                        iree_hal_buffer_byte_offset(captured_buffer);
+  CUdeviceptr new_ptr = iree_hal_cuda_buffer_device_pointer(
+                            iree_hal_buffer_allocated_buffer(buffer)) +
+                        iree_hal_buffer_byte_offset(buffer);
+  iree_status_t status = iree_ok_status();
+  for (iree_hal_cuda_graph_capture_node_t* node = capture->node_head;
+       node != NULL && iree_status_is_ok(status); node = node->next) {
+    switch (node->type) {
+      case IREE_HAL_CUDA_GRAPH_CAPTURE_NODE_TYPE_KERNEL:
+        status = iree_hal_cuda_graph_capture_update_kernel_node(
+            capture, node, old_ptr, length, new_ptr);
+        break;
+      case IREE_HAL_CUDA_GRAPH_CAPTURE_NODE_TYPE_MEMSET:
+        status = iree_hal_cuda_graph_capture_update_memset_node(
+            capture, node, old_ptr, length, new_ptr);
+        break;
+      case IREE_HAL_CUDA_GRAPH_CAPTURE_NODE_TYPE_MEMCPY:
+        status = iree_hal_cuda_graph_capture_update_memcpy_node(
+            capture, node, old_ptr, length, new_ptr);
+        break;
+    }
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+IREE_API_EXPORT iree_status_t
+iree_hal_cuda_graph_capture_replay(iree_hal_cuda_graph_capture_t* capture) {
+  IREE_ASSERT_ARGUMENT(capture);
+  if (IREE_UNLIKELY(!capture->exec)) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "capture has not ended");
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_hal_cuda_dynamic_symbols_t* syms = capture->context->syms;
+  iree_status_t status = CU_RESULT_TO_STATUS(
+      syms, cuGraphLaunch(capture->exec, capture->stream), "cuGraphLaunch");
+  if (iree_status_is_ok(status)) {
+    status = CU_RESULT_TO_STATUS(syms, cuStreamSynchronize(capture->stream),
+                                 "cuStreamSynchronize");
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
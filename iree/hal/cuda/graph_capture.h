@@ -0,0 +1,65 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_CUDA_GRAPH_CAPTURE_H_
+#define IREE_HAL_CUDA_GRAPH_CAPTURE_H_
+
+#include "iree/base/api.h"
+#include "iree/base/internal/arena.h"
+#include "iree/hal/api.h"
+#include "iree/hal/cuda/api.h"
+#include "iree/hal/cuda/context_wrapper.h"
+#include "iree/hal/cuda/cuda_headers.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Creates an empty capture that records into a new CUDA graph.
+// Graph command buffers created with the capture append their nodes to it in
+// recording order. |block_pool| must outlive the capture.
+iree_status_t iree_hal_cuda_graph_capture_create(
+    iree_hal_device_t* device, iree_hal_cuda_context_wrapper_t* context,
+    CUstream stream, iree_arena_block_pool_t* block_pool,
+    iree_hal_cuda_graph_capture_t** out_capture);
+
+// Retains |count| |resources| for the lifetime of the capture.
+iree_status_t iree_hal_cuda_graph_capture_insert_resources(
+    iree_hal_cuda_graph_capture_t* capture, iree_host_size_t count,
+    const void* resources);
+
+// Orders all nodes added after the barrier after all nodes added before it.
+// Nodes added between barriers may execute concurrently.
+iree_status_t iree_hal_cuda_graph_capture_barrier(
+    iree_hal_cuda_graph_capture_t* capture);
+
+// Appends a kernel node with the given |params| after the last barrier.
+// |args| is the packed kernel argument buffer of |args_size| bytes referenced
+// by |params|. Its first |binding_count| values are device pointers that may
+// be updated with iree_hal_cuda_graph_capture_update_buffer.
+iree_status_t iree_hal_cuda_graph_capture_add_kernel_node(
+    iree_hal_cuda_graph_capture_t* capture,
+    const CUDA_KERNEL_NODE_PARAMS* params, iree_host_size_t binding_count,
+    const void* args, iree_host_size_t args_size);
+
+// Appends a memset node with the given |params| after the last barrier.
+iree_status_t iree_hal_cuda_graph_capture_add_memset_node(
+    iree_hal_cuda_graph_capture_t* capture,
+    const CUDA_MEMSET_NODE_PARAMS* params);
+
+// Appends a memcpy node with the given |params| after the last barrier.
+iree_status_t iree_hal_cuda_graph_capture_add_memcpy_node(
+    iree_hal_cuda_graph_capture_t* capture, const CUDA_MEMCPY3D* params);
+
+// Instantiates the recorded graph. No more nodes may be added afterward.
+iree_status_t iree_hal_cuda_graph_capture_finalize(
+    iree_hal_cuda_graph_capture_t* capture);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_CUDA_GRAPH_CAPTURE_H_
@@ -9,19 +9,20 @@
 #include <assert.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "iree/base/api.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/cuda/cuda_buffer.h"
 #include "iree/hal/cuda/dynamic_symbols.h"
 #include "iree/hal/cuda/executable_layout.h"
+#include "iree/hal/cuda/graph_capture.h"
+#include "iree/hal/cuda/graph_dependencies.h"
 #include "iree/hal/cuda/native_executable.h"
 #include "iree/hal/cuda/status_util.h"
 #include "iree/hal/utils/resource_set.h"
 
 #define IREE_HAL_CUDA_MAX_BINDING_COUNT 64
-// Kernel arguments contains binding and push constants.
-#define IREE_HAL_CUDA_MAX_KERNEL_ARG 128
 
 // Command buffer implementation that directly maps to cuda graph.
 // This records the commands on the calling thread without additional threading
@@ -35,15 +36,26 @@ typedef struct iree_hal_cuda_graph_command_buffer_t {
   // Reset on each begin.
   iree_hal_resource_set_t* resource_set;
 
+  // Retained device capture the command buffer records into, if any. When set
+  // all nodes are appended to the capture graph and resources are retained by
+  // the capture instead of |graph| and |resource_set|.
+  iree_hal_cuda_graph_capture_t* capture;
+
   CUgraph graph;
   CUgraphExec exec;
 
-  // Keep track of the last node added to the command buffer as we are currently
-  // serializing all the nodes (each node depends on the previous one).
-  CUgraphNode last_node;
+  // Orders the nodes added to |graph| across execution barriers. Nodes between
+  // barriers have no edges between them and may execute concurrently.
+  iree_hal_cuda_graph_dependencies_t dependencies;
+  // Number of kernel nodes recorded; reported to the device profiler as the
+  // dispatches of a graph cannot be timed individually.
+  iree_host_size_t dispatch_count;
   int32_t push_constant[IREE_HAL_CUDA_MAX_PUSH_CONSTANT_COUNT];
-  // Keep track of the current set of kernel arguments.
-  void* current_descriptor[];
+  // Packed kernel arguments of the next dispatch as laid out by its
+  // executable layout. Kernel nodes copy the arguments when they are added to
+  // the graph and the buffer is reused by all dispatches.
+  CUdeviceptr kernel_args[IREE_HAL_CUDA_MAX_KERNEL_ARG_SIZE /
+                          sizeof(CUdeviceptr)];
 } iree_hal_cuda_graph_command_buffer_t;
 
 static const iree_hal_command_buffer_vtable_t
@@ -61,6 +73,7 @@ iree_status_t iree_hal_cuda_graph_command_buffer_create(
     iree_hal_command_category_t command_categories,
     iree_hal_queue_affinity_t queue_affinity,
     iree_arena_block_pool_t* block_pool,
+    iree_hal_cuda_graph_capture_t* capture,
     iree_hal_command_buffer_t** out_command_buffer) {
   IREE_ASSERT_ARGUMENT(context);
   IREE_ASSERT_ARGUMENT(block_pool);
@@ -68,27 +81,21 @@ iree_status_t iree_hal_cuda_graph_command_buffer_create(
   IREE_TRACE_ZONE_BEGIN(z0);
 
   iree_hal_cuda_graph_command_buffer_t* command_buffer = NULL;
-  size_t total_size = sizeof(*command_buffer) +
-                      IREE_HAL_CUDA_MAX_KERNEL_ARG * sizeof(void*) +
-                      IREE_HAL_CUDA_MAX_KERNEL_ARG * sizeof(CUdeviceptr);
-  iree_status_t status = iree_allocator_malloc(
-      context->host_allocator, total_size, (void**)&command_buffer);
+  iree_status_t status =
+      iree_allocator_malloc(context->host_allocator, sizeof(*command_buffer),
+                            (void**)&command_buffer);
   if (iree_status_is_ok(status)) {
     iree_hal_command_buffer_initialize(
         device, mode, command_categories, queue_affinity,
         &iree_hal_cuda_graph_command_buffer_vtable, &command_buffer->base);
     command_buffer->context = context;
     command_buffer->block_pool = block_pool;
+    command_buffer->capture = capture;
+    iree_hal_cuda_graph_capture_retain(command_buffer->capture);
     command_buffer->graph = NULL;
     command_buffer->exec = NULL;
-    command_buffer->last_node = NULL;
-
-    CUdeviceptr* device_ptrs =
-        (CUdeviceptr*)(command_buffer->current_descriptor +
-                       IREE_HAL_CUDA_MAX_KERNEL_ARG);
-    for (size_t i = 0; i < IREE_HAL_CUDA_MAX_KERNEL_ARG; i++) {
-      command_buffer->current_descriptor[i] = &device_ptrs[i];
-    }
+    iree_hal_cuda_graph_dependencies_initialize(context,
+                                                &command_buffer->dependencies);
 
     status = iree_hal_resource_set_allocate(block_pool,
                                             &command_buffer->resource_set);
@@ -117,7 +124,8 @@ static void iree_hal_cuda_graph_command_buffer_reset(
     command_buffer->exec = NULL;
   }
 
-  command_buffer->last_node = NULL;
+  iree_hal_cuda_graph_dependencies_reset(&command_buffer->dependencies);
+  command_buffer->dispatch_count = 0;
 
   iree_hal_resource_set_reset(command_buffer->resource_set);
 }
@@ -129,7 +137,9 @@ static void iree_hal_cuda_graph_command_buffer_destroy(
   IREE_TRACE_ZONE_BEGIN(z0);
 
   iree_hal_cuda_graph_command_buffer_reset(command_buffer);
+  iree_hal_cuda_graph_dependencies_deinitialize(&command_buffer->dependencies);
   iree_hal_resource_set_free(command_buffer->resource_set);
+  iree_hal_cuda_graph_capture_release(command_buffer->capture);
   iree_allocator_free(command_buffer->context->host_allocator, command_buffer);
 
   IREE_TRACE_ZONE_END(z0);
@@ -142,6 +152,20 @@ CUgraphExec iree_hal_cuda_graph_command_buffer_handle(
   return command_buffer->exec;
 }
 
+iree_hal_cuda_graph_capture_t* iree_hal_cuda_graph_command_buffer_capture(
+    iree_hal_command_buffer_t* base_command_buffer) {
+  iree_hal_cuda_graph_command_buffer_t* command_buffer =
+      iree_hal_cuda_graph_command_buffer_cast(base_command_buffer);
+  return command_buffer->capture;
+}
+
+iree_host_size_t iree_hal_cuda_graph_command_buffer_dispatch_count(
+    iree_hal_command_buffer_t* base_command_buffer) {
+  iree_hal_cuda_graph_command_buffer_t* command_buffer =
+      iree_hal_cuda_graph_command_buffer_cast(base_command_buffer);
+  return command_buffer->dispatch_count;
+}
+
 bool iree_hal_cuda_graph_command_buffer_isa(
     iree_hal_command_buffer_t* command_buffer) {
   return iree_hal_command_buffer_dyn_cast(
@@ -165,6 +189,12 @@ static iree_status_t iree_hal_cuda_graph_command_buffer_begin(
   // Reset any prior recorded commands.
   iree_hal_cuda_graph_command_buffer_reset(command_buffer);
 
+  // Captured commands are appended to the capture graph after all commands
+  // from prior command buffers.
+  if (command_buffer->capture) {
+    return iree_hal_cuda_graph_capture_barrier(command_buffer->capture);
+  }
+
   // Create a new empty graph to record into.
   CUDA_RETURN_IF_ERROR(command_buffer->context->syms,
                        cuGraphCreate(&command_buffer->graph, /*flags=*/0),
@@ -179,7 +209,12 @@ static iree_status_t iree_hal_cuda_graph_command_buffer_end(
       iree_hal_cuda_graph_command_buffer_cast(base_command_buffer);
 
   // Reset state used during recording.
-  command_buffer->last_node = NULL;
+  iree_hal_cuda_graph_dependencies_reset(&command_buffer->dependencies);
+
+  // The capture graph is compiled when the capture ends.
+  if (command_buffer->capture) {
+    return iree_hal_cuda_graph_capture_barrier(command_buffer->capture);
+  }
 
   // Compile the graph.
   CUgraphNode error_node = NULL;
@@ -199,6 +234,18 @@ static iree_status_t iree_hal_cuda_graph_command_buffer_end(
   return iree_ok_status();
 }
 
+// Retains |count| |resources| for as long as the recorded commands may run.
+static iree_status_t iree_hal_cuda_graph_command_buffer_insert_resources(
+    iree_hal_cuda_graph_command_buffer_t* command_buffer,
+    iree_host_size_t count, const void* resources) {
+  if (command_buffer->capture) {
+    return iree_hal_cuda_graph_capture_insert_resources(command_buffer->capture,
+                                                        count, resources);
+  }
+  return iree_hal_resource_set_insert(command_buffer->resource_set, count,
+                                      resources);
+}
+
 static void iree_hal_cuda_graph_command_buffer_begin_debug_group(
     iree_hal_command_buffer_t* base_command_buffer, iree_string_view_t label,
     iree_hal_label_color_t label_color,
@@ -220,9 +267,13 @@ static iree_status_t iree_hal_cuda_graph_command_buffer_execution_barrier(
     const iree_hal_memory_barrier_t* memory_barriers,
     iree_host_size_t buffer_barrier_count,
     const iree_hal_buffer_barrier_t* buffer_barriers) {
-  // TODO: Implement barrier with Graph edges. Right now all the nodes are
-  // serialized.
-  return iree_ok_status();
+  iree_hal_cuda_graph_command_buffer_t* command_buffer =
+      iree_hal_cuda_graph_command_buffer_cast(base_command_buffer);
+  if (command_buffer->capture) {
+    return iree_hal_cuda_graph_capture_barrier(command_buffer->capture);
+  }
+  return iree_hal_cuda_graph_dependencies_barrier(&command_buffer->dependencies,
+                                                  command_buffer->graph);
 }
 
 static iree_status_t iree_hal_cuda_graph_command_buffer_signal_event(
@@ -250,9 +301,12 @@ static iree_status_t iree_hal_cuda_graph_command_buffer_wait_events(
     const iree_hal_memory_barrier_t* memory_barriers,
     iree_host_size_t buffer_barrier_count,
     const iree_hal_buffer_barrier_t* buffer_barriers) {
-  // TODO: Implement barrier with Graph edges. Right now all the nodes are
-  // serialized.
-  return iree_ok_status();
+  // TODO: Implement events with graph edges. Until then waits conservatively
+  // order all prior commands before all subsequent ones.
+  return iree_hal_cuda_graph_command_buffer_execution_barrier(
+      base_command_buffer, source_stage_mask, target_stage_mask,
+      IREE_HAL_EXECUTION_BARRIER_FLAG_NONE, memory_barrier_count,
+      memory_barriers, buffer_barrier_count, buffer_barriers);
 }
 
 static iree_status_t iree_hal_cuda_graph_command_buffer_discard_buffer(
@@ -291,8 +345,8 @@ static iree_status_t iree_hal_cuda_graph_command_buffer_fill_buffer(
   iree_hal_cuda_graph_command_buffer_t* command_buffer =
       iree_hal_cuda_graph_command_buffer_cast(base_command_buffer);
 
-  IREE_RETURN_IF_ERROR(iree_hal_resource_set_insert(
-      command_buffer->resource_set, 1, &target_buffer));
+  IREE_RETURN_IF_ERROR(iree_hal_cuda_graph_command_buffer_insert_resources(
+      command_buffer, 1, &target_buffer));
 
   CUdeviceptr target_device_buffer = iree_hal_cuda_buffer_device_pointer(
       iree_hal_buffer_allocated_buffer(target_buffer));
@@ -306,16 +360,21 @@ static iree_status_t iree_hal_cuda_graph_command_buffer_fill_buffer(
       .height = 1,
       .value = dword_pattern,
   };
-  // Serialize all the nodes for now.
-  CUgraphNode dep[] = {command_buffer->last_node};
-  size_t numNode = command_buffer->last_node ? 1 : 0;
+  if (command_buffer->capture) {
+    return iree_hal_cuda_graph_capture_add_memset_node(command_buffer->capture,
+                                                       &params);
+  }
+  size_t dep_count = 0;
+  const CUgraphNode* deps = iree_hal_cuda_graph_dependencies_nodes(
+      &command_buffer->dependencies, &dep_count);
+  CUgraphNode node = NULL;
   CUDA_RETURN_IF_ERROR(
       command_buffer->context->syms,
-      cuGraphAddMemsetNode(&command_buffer->last_node, command_buffer->graph,
-                           dep, numNode, &params,
-                           command_buffer->context->cu_context),
+      cuGraphAddMemsetNode(&node, command_buffer->graph, deps, dep_count,
+                           &params, command_buffer->context->cu_context),
       "cuGraphAddMemsetNode");
-  return iree_ok_status();
+  return iree_hal_cuda_graph_dependencies_append(&command_buffer->dependencies,
+                                                 node);
 }
 
 static iree_status_t iree_hal_cuda_graph_command_buffer_update_buffer(
@@ -335,8 +394,8 @@ static iree_status_t iree_hal_cuda_graph_command_buffer_copy_buffer(
       iree_hal_cuda_graph_command_buffer_cast(base_command_buffer);
 
   const iree_hal_buffer_t* buffers[2] = {source_buffer, target_buffer};
-  IREE_RETURN_IF_ERROR(
-      iree_hal_resource_set_insert(command_buffer->resource_set, 2, buffers));
+  IREE_RETURN_IF_ERROR(iree_hal_cuda_graph_command_buffer_insert_resources(
+      command_buffer, 2, buffers));
 
   CUdeviceptr target_device_buffer = iree_hal_cuda_buffer_device_pointer(
       iree_hal_buffer_allocated_buffer(target_buffer));
@@ -355,16 +414,21 @@ static iree_status_t iree_hal_cuda_graph_command_buffer_copy_buffer(
       .srcMemoryType = CU_MEMORYTYPE_DEVICE,
       .dstMemoryType = CU_MEMORYTYPE_DEVICE,
   };
-  // Serialize all the nodes for now.
-  CUgraphNode dep[] = {command_buffer->last_node};
-  size_t numNode = command_buffer->last_node ? 1 : 0;
+  if (command_buffer->capture) {
+    return iree_hal_cuda_graph_capture_add_memcpy_node(command_buffer->capture,
+                                                       &params);
+  }
+  size_t dep_count = 0;
+  const CUgraphNode* deps = iree_hal_cuda_graph_dependencies_nodes(
+      &command_buffer->dependencies, &dep_count);
+  CUgraphNode node = NULL;
   CUDA_RETURN_IF_ERROR(
       command_buffer->context->syms,
-      cuGraphAddMemcpyNode(&command_buffer->last_node, command_buffer->graph,
-                           dep, numNode, &params,
-                           command_buffer->context->cu_context),
+      cuGraphAddMemcpyNode(&node, command_buffer->graph, deps, dep_count,
+                           &params, command_buffer->context->cu_context),
       "cuGraphAddMemcpyNode");
-  return iree_ok_status();
+  return iree_hal_cuda_graph_dependencies_append(&command_buffer->dependencies,
+                                                 node);
 }
 
 static iree_status_t iree_hal_cuda_graph_command_buffer_push_constants(
@@ -426,10 +490,9 @@ static iree_status_t iree_hal_cuda_graph_command_buffer_push_descriptor_set(
         iree_hal_cuda_buffer_device_pointer(
             iree_hal_buffer_allocated_buffer(binding->buffer)) +
         iree_hal_buffer_byte_offset(binding->buffer) + binding->offset;
-    *((CUdeviceptr*)command_buffer->current_descriptor[i + base_binding]) =
-        device_ptr;
-    IREE_RETURN_IF_ERROR(iree_hal_resource_set_insert(
-        command_buffer->resource_set, 1, &binding->buffer));
+    command_buffer->kernel_args[i + base_binding] = device_ptr;
+    IREE_RETURN_IF_ERROR(iree_hal_cuda_graph_command_buffer_insert_resources(
+        command_buffer, 1, &binding->buffer));
   }
   return iree_ok_status();
 }
@@ -450,42 +513,57 @@ static iree_status_t iree_hal_cuda_graph_command_buffer_dispatch(
     uint32_t workgroup_x, uint32_t workgroup_y, uint32_t workgroup_z) {
   iree_hal_cuda_graph_command_buffer_t* command_buffer =
       iree_hal_cuda_graph_command_buffer_cast(base_command_buffer);
-  IREE_RETURN_IF_ERROR(iree_hal_resource_set_insert(
-      command_buffer->resource_set, 1, &executable));
+  IREE_RETURN_IF_ERROR(iree_hal_cuda_graph_command_buffer_insert_resources(
+      command_buffer, 1, &executable));
   iree_hal_executable_layout_t* layout =
       iree_hal_cuda_executable_get_layout(executable, entry_point);
-  iree_host_size_t num_constants =
-      iree_hal_cuda_executable_layout_num_constants(layout);
-  iree_host_size_t constant_base_index =
-      iree_hal_cuda_push_constant_index(layout);
-  // Patch the push constants in the kernel arguments.
-  for (iree_host_size_t i = 0; i < num_constants; i++) {
-    *((uint32_t*)command_buffer->current_descriptor[i + constant_base_index]) =
-        command_buffer->push_constant[i];
-  }
+  // Copy the push constants into place after the bindings.
+  memcpy((uint8_t*)command_buffer->kernel_args +
+             iree_hal_cuda_executable_layout_push_constant_offset(layout),
+         command_buffer->push_constant,
+         iree_hal_cuda_executable_layout_num_constants(layout) *
+             sizeof(int32_t));
+  size_t kernel_args_size =
+      iree_hal_cuda_executable_layout_kernel_args_size(layout);
+  void* extra[] = {
+      CU_LAUNCH_PARAM_BUFFER_POINTER, command_buffer->kernel_args,
+      CU_LAUNCH_PARAM_BUFFER_SIZE,    &kernel_args_size,
+      CU_LAUNCH_PARAM_END,
+  };
   int32_t block_size_x, block_size_y, block_size_z;
   IREE_RETURN_IF_ERROR(iree_hal_cuda_native_executable_block_size(
       executable, entry_point, &block_size_x, &block_size_y, &block_size_z));
+  CUfunction func = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_cuda_native_executable_for_entry_point(
+      executable, entry_point, &func));
   CUDA_KERNEL_NODE_PARAMS params = {
-      .func = iree_hal_cuda_native_executable_for_entry_point(executable,
-                                                              entry_point),
+      .func = func,
       .blockDimX = block_size_x,
       .blockDimY = block_size_y,
       .blockDimZ = block_size_z,
       .gridDimX = workgroup_x,
       .gridDimY = workgroup_y,
       .gridDimZ = workgroup_z,
-      .kernelParams = command_buffer->current_descriptor,
+      .extra = kernel_args_size ? extra : NULL,
   };
-  // Serialize all the nodes for now.
-  CUgraphNode dep[] = {command_buffer->last_node};
-  size_t numNodes = command_buffer->last_node ? 1 : 0;
+  ++command_buffer->dispatch_count;
+  if (command_buffer->capture) {
+    return iree_hal_cuda_graph_capture_add_kernel_node(
+        command_buffer->capture, &params,
+        /*binding_count=*/iree_hal_cuda_push_constant_index(layout),
+        command_buffer->kernel_args, kernel_args_size);
+  }
+  size_t dep_count = 0;
+  const CUgraphNode* deps = iree_hal_cuda_graph_dependencies_nodes(
+      &command_buffer->dependencies, &dep_count);
+  CUgraphNode node = NULL;
   CUDA_RETURN_IF_ERROR(
       command_buffer->context->syms,
-      cuGraphAddKernelNode(&command_buffer->last_node, command_buffer->graph,
-                           dep, numNodes, &params),
+      cuGraphAddKernelNode(&node, command_buffer->graph, deps, dep_count,
+                           &params),
       "cuGraphAddKernelNode");
-  return iree_ok_status();
+  return iree_hal_cuda_graph_dependencies_append(&command_buffer->dependencies,
+                                                 node);
 }
 
 static iree_status_t iree_hal_cuda_graph_command_buffer_dispatch_indirect(
@@ -493,8 +571,12 @@ static iree_status_t iree_hal_cuda_graph_command_buffer_dispatch_indirect(
     iree_hal_executable_t* executable, int32_t entry_point,
     iree_hal_buffer_t* workgroups_buffer,
     iree_device_size_t workgroups_offset) {
+  // Kernel node grid dimensions are fixed when the graph is instantiated and
+  // CUDA has no node type that reads them from device memory. Stream command
+  // buffers (--cuda_use_streams) read the workgroup count back when issued.
   return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
-                          "need cuda implementation");
+                          "indirect dispatch is not supported in CUDA graphs; "
+                          "use stream command buffers");
 }
 
 CUgraphExec iree_hal_cuda_graph_command_buffer_exec(
@@ -12,6 +12,7 @@
 #include "iree/hal/cuda/context_wrapper.h"
 #include "iree/hal/cuda/cuda_headers.h"
 #include "iree/hal/cuda/dynamic_symbols.h"
+#include "iree/hal/cuda/graph_capture.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -20,6 +21,8 @@ extern "C" {
 typedef struct iree_arena_block_pool_t iree_arena_block_pool_t;
 
 // Creates a command buffer that records into a CUDA graph.
+// If |capture| is provided all commands are appended to the capture graph in
+// recording order and submitting the command buffer is a no-op.
 //
 // NOTE: the |block_pool| must remain live for the lifetime of the command
 // buffers that use it.
@@ -29,8 +32,18 @@ iree_status_t iree_hal_cuda_graph_command_buffer_create(
     iree_hal_command_category_t command_categories,
     iree_hal_queue_affinity_t queue_affinity,
     iree_arena_block_pool_t* block_pool,
+    iree_hal_cuda_graph_capture_t* capture,
     iree_hal_command_buffer_t** out_command_buffer);
 
+// Returns the capture |command_buffer| records into or NULL if it records into
+// its own graph.
+iree_hal_cuda_graph_capture_t* iree_hal_cuda_graph_command_buffer_capture(
+    iree_hal_command_buffer_t* command_buffer);
+
+// Returns the number of dispatches recorded into |command_buffer|.
+iree_host_size_t iree_hal_cuda_graph_command_buffer_dispatch_count(
+    iree_hal_command_buffer_t* command_buffer);
+
 // Returns true if |command_buffer| is a CUDA graph-based command buffer.
 bool iree_hal_cuda_graph_command_buffer_isa(
     iree_hal_command_buffer_t* command_buffer);
@@ -0,0 +1,73 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/cuda/graph_dependencies.h"
+
+#include <string.h>
+
+#include "iree/base/tracing.h"
+#include "iree/hal/cuda/dynamic_symbols.h"
+#include "iree/hal/cuda/status_util.h"
+
+void iree_hal_cuda_graph_dependencies_initialize(
+    iree_hal_cuda_context_wrapper_t* context,
+    iree_hal_cuda_graph_dependencies_t* out_dependencies) {
+  memset(out_dependencies, 0, sizeof(*out_dependencies));
+  out_dependencies->context = context;
+}
+
+void iree_hal_cuda_graph_dependencies_deinitialize(
+    iree_hal_cuda_graph_dependencies_t* dependencies) {
+  iree_allocator_free(dependencies->context->host_allocator,
+                      dependencies->scope_nodes);
+  memset(dependencies, 0, sizeof(*dependencies));
+}
+
+void iree_hal_cuda_graph_dependencies_reset(
+    iree_hal_cuda_graph_dependencies_t* dependencies) {
+  dependencies->barrier_node = NULL;
+  dependencies->scope_count = 0;
+}
+
+const CUgraphNode* iree_hal_cuda_graph_dependencies_nodes(
+    iree_hal_cuda_graph_dependencies_t* dependencies, size_t* out_count) {
+  *out_count = dependencies->barrier_node ? 1 : 0;
+  return &dependencies->barrier_node;
+}
+
+iree_status_t iree_hal_cuda_graph_dependencies_append(
+    iree_hal_cuda_graph_dependencies_t* dependencies, CUgraphNode node) {
+  if (dependencies->scope_count == dependencies->scope_capacity) {
+    iree_host_size_t new_capacity =
+        iree_max(16, dependencies->scope_capacity * 2);
+    IREE_RETURN_IF_ERROR(iree_allocator_realloc(
+        dependencies->context->host_allocator,
+        new_capacity * sizeof(dependencies->scope_nodes[0]),
+        (void**)&dependencies->scope_nodes));
+    dependencies->scope_capacity = new_capacity;
+  }
+  dependencies->scope_nodes[dependencies->scope_count++] = node;
+  return iree_ok_status();
+}
+
+iree_status_t iree_hal_cuda_graph_dependencies_barrier(
+    iree_hal_cuda_graph_dependencies_t* dependencies, CUgraph graph) {
+  if (dependencies->scope_count == 0) {
+    // Nothing added since the last barrier so it still orders the next node.
+    return iree_ok_status();
+  } else if (dependencies->scope_count == 1) {
+    dependencies->barrier_node = dependencies->scope_nodes[0];
+  } else {
+    CUDA_RETURN_IF_ERROR(
+        dependencies->context->syms,
+        cuGraphAddEmptyNode(&dependencies->barrier_node, graph,
+                            dependencies->scope_nodes,
+                            dependencies->scope_count),
+        "cuGraphAddEmptyNode");
+  }
+  dependencies->scope_count = 0;
+  return iree_ok_status();
+}
@@ -0,0 +1,64 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_CUDA_GRAPH_DEPENDENCIES_H_
+#define IREE_HAL_CUDA_GRAPH_DEPENDENCIES_H_
+
+#include "iree/base/api.h"
+#include "iree/hal/cuda/context_wrapper.h"
+#include "iree/hal/cuda/cuda_headers.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Tracks the dependencies of nodes added to a CUDA graph from HAL commands.
+// HAL command buffers only order commands across execution barriers: nodes
+// added between two barriers are left independent so that CUDA can run them
+// concurrently and each barrier joins them before any subsequent node.
+typedef struct iree_hal_cuda_graph_dependencies_t {
+  iree_hal_cuda_context_wrapper_t* context;
+  // Node that all nodes added since the last barrier depend on, if any.
+  CUgraphNode barrier_node;
+  // Nodes added since the last barrier.
+  CUgraphNode* scope_nodes;
+  iree_host_size_t scope_count;
+  iree_host_size_t scope_capacity;
+} iree_hal_cuda_graph_dependencies_t;
+
+// Initializes |out_dependencies| with no prior nodes.
+void iree_hal_cuda_graph_dependencies_initialize(
+    iree_hal_cuda_context_wrapper_t* context,
+    iree_hal_cuda_graph_dependencies_t* out_dependencies);
+
+// Deinitializes |dependencies| and frees its storage.
+void iree_hal_cuda_graph_dependencies_deinitialize(
+    iree_hal_cuda_graph_dependencies_t* dependencies);
+
+// Forgets all nodes while retaining storage for reuse with a new graph.
+void iree_hal_cuda_graph_dependencies_reset(
+    iree_hal_cuda_graph_dependencies_t* dependencies);
+
+// Returns the nodes the next added node must depend on.
+// The returned pointer is valid until the next barrier or reset.
+const CUgraphNode* iree_hal_cuda_graph_dependencies_nodes(
+    iree_hal_cuda_graph_dependencies_t* dependencies, size_t* out_count);
+
+// Records |node| as added to the graph since the last barrier.
+iree_status_t iree_hal_cuda_graph_dependencies_append(
+    iree_hal_cuda_graph_dependencies_t* dependencies, CUgraphNode node);
+
+// Makes all nodes added to |graph| after this call depend on all nodes added
+// before it. Multiple prior nodes are joined with an empty node to avoid
+// adding an edge for every pair of nodes across the barrier.
+iree_status_t iree_hal_cuda_graph_dependencies_barrier(
+    iree_hal_cuda_graph_dependencies_t* dependencies, CUgraph graph);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_CUDA_GRAPH_DEPENDENCIES_H_
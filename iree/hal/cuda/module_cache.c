@@ -0,0 +1,221 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/cuda/module_cache.h"
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "iree/base/internal/file_io.h"
+#include "iree/base/tracing.h"
+#include "iree/hal/cuda/dynamic_symbols.h"
+#include "iree/hal/cuda/status_util.h"
+
+// Maximum length of a cache file path including the NUL terminator.
+#define IREE_HAL_CUDA_MODULE_CACHE_MAX_PATH_LENGTH 2048
+
+struct iree_hal_cuda_module_cache_t {
+  iree_hal_cuda_context_wrapper_t* context;
+  // Device compute capability and driver version mixed into all keys.
+  int compute_capability_major;
+  int compute_capability_minor;
+  int driver_version;
+  iree_string_view_t directory;
+};
+
+iree_status_t iree_hal_cuda_module_cache_create(
+    iree_hal_cuda_context_wrapper_t* context, CUdevice device,
+    iree_string_view_t directory, iree_hal_cuda_module_cache_t** out_cache) {
+  IREE_ASSERT_ARGUMENT(context);
+  IREE_ASSERT_ARGUMENT(out_cache);
+  *out_cache = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  int compute_capability_major = 0;
+  int compute_capability_minor = 0;
+  int driver_version = 0;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, CU_RESULT_TO_STATUS(
+              context->syms,
+              cuDeviceGetAttribute(&compute_capability_major,
+                                   CU_DEVICE_ATTRIBUTE_COMPUTE_CAPABILITY_MAJOR,
+                                   device),
+              "cuDeviceGetAttribute"));
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, CU_RESULT_TO_STATUS(
+              context->syms,
+              cuDeviceGetAttribute(&compute_capability_minor,
+                                   CU_DEVICE_ATTRIBUTE_COMPUTE_CAPABILITY_MINOR,
+                                   device),
+              "cuDeviceGetAttribute"));
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, CU_RESULT_TO_STATUS(context->syms,
+                              cuDriverGetVersion(&driver_version),
+                              "cuDriverGetVersion"));
+
+  iree_hal_cuda_module_cache_t* cache = NULL;
+  iree_host_size_t total_size = iree_sizeof_struct(*cache) + directory.size;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(context->host_allocator, total_size,
+                                (void**)&cache));
+  cache->context = context;
+  cache->compute_capability_major = compute_capability_major;
+  cache->compute_capability_minor = compute_capability_minor;
+  cache->driver_version = driver_version;
+  iree_string_view_append_to_buffer(directory, &cache->directory,
+                                    (char*)cache + iree_sizeof_struct(*cache));
+
+  *out_cache = cache;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+void iree_hal_cuda_module_cache_free(iree_hal_cuda_module_cache_t* cache) {
+  if (!cache) return;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_allocator_free(cache->context->host_allocator, cache);
+  IREE_TRACE_ZONE_END(z0);
+}
+
+// 64-bit FNV-1a; the key only needs to be stable across processes.
+static uint64_t iree_hal_cuda_module_cache_hash(iree_string_view_t data) {
+  uint64_t hash = 0xCBF29CE484222325ull;
+  for (iree_host_size_t i = 0; i < data.size; ++i) {
+    hash ^= (uint8_t)data.data[i];
+    hash *= 0x100000001B3ull;
+  }
+  return hash;
+}
+
+// Formats the cache file path for |ptx_image| into |path|.
+// Returns false if the path does not fit.
+static bool iree_hal_cuda_module_cache_format_path(
+    iree_hal_cuda_module_cache_t* cache, iree_string_view_t ptx_image,
+    char path[IREE_HAL_CUDA_MODULE_CACHE_MAX_PATH_LENGTH]) {
+  int length = snprintf(
+      path, IREE_HAL_CUDA_MODULE_CACHE_MAX_PATH_LENGTH,
+      "%.*s/%016" PRIx64 "-%" PRIhsz "-sm%d%d-%d.cubin",
+      (int)cache->directory.size, cache->directory.data,
+      iree_hal_cuda_module_cache_hash(ptx_image), ptx_image.size,
+      cache->compute_capability_major, cache->compute_capability_minor,
+      cache->driver_version);
+  return length > 0 && length < IREE_HAL_CUDA_MODULE_CACHE_MAX_PATH_LENGTH;
+}
+
+#if IREE_FILE_IO_ENABLE
+
+// Tries to load a module from a cached cubin at |path|.
+static bool iree_hal_cuda_module_cache_try_load_file(
+    iree_hal_cuda_module_cache_t* cache, const char* path,
+    CUmodule* out_module) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_byte_span_t contents = iree_make_byte_span(NULL, 0);
+  iree_status_t status = iree_file_read_contents(
+      path, cache->context->host_allocator, &contents);
+  if (iree_status_is_ok(status)) {
+    // A corrupt or incompatible cubin fails to load and is replaced.
+    status = CU_RESULT_TO_STATUS(cache->context->syms,
+                                 cuModuleLoadData(out_module, contents.data),
+                                 "cuModuleLoadData");
+  }
+  iree_allocator_free(cache->context->host_allocator, contents.data);
+  bool loaded = iree_status_is_ok(status);
+  iree_status_ignore(status);
+  IREE_TRACE_ZONE_END(z0);
+  return loaded;
+}
+
+// Writes |cubin| to |path| by way of a temporary file so that concurrent
+// readers never observe a partial write.
+static void iree_hal_cuda_module_cache_store_file(
+    const char* path, iree_const_byte_span_t cubin) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  char temp_path[IREE_HAL_CUDA_MODULE_CACHE_MAX_PATH_LENGTH + 32];
+  snprintf(temp_path, sizeof(temp_path), "%s.%016" PRIx64 ".tmp", path,
+           (uint64_t)iree_time_now() ^ (uint64_t)(uintptr_t)&temp_path);
+  iree_status_t status = iree_file_write_contents(temp_path, cubin);
+  if (iree_status_is_ok(status) && rename(temp_path, path) != 0) {
+    // Another process may have won the race (rename does not replace
+    // existing files on all platforms); either way the entry is usable.
+    remove(temp_path);
+  }
+  iree_status_ignore(status);
+  IREE_TRACE_ZONE_END(z0);
+}
+
+#endif  // IREE_FILE_IO_ENABLE
+
+// JIT compiles |ptx_image| into a cubin and loads it. The cubin is written to
+// |path| if provided.
+static iree_status_t iree_hal_cuda_module_cache_compile(
+    iree_hal_cuda_module_cache_t* cache, iree_string_view_t ptx_image,
+    const char* path, CUmodule* out_module) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_hal_cuda_dynamic_symbols_t* syms = cache->context->syms;
+
+  CUlinkState link_state = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, CU_RESULT_TO_STATUS(syms, cuLinkCreate(0, NULL, NULL, &link_state),
+                              "cuLinkCreate"));
+
+  // PTX images must include their NUL terminator.
+  iree_status_t status = CU_RESULT_TO_STATUS(
+      syms,
+      cuLinkAddData(link_state, CU_JIT_INPUT_PTX, (void*)ptx_image.data,
+                    ptx_image.size + 1, "ptx", 0, NULL, NULL),
+      "cuLinkAddData");
+  void* cubin_data = NULL;
+  size_t cubin_size = 0;
+  if (iree_status_is_ok(status)) {
+    status = CU_RESULT_TO_STATUS(
+        syms, cuLinkComplete(link_state, &cubin_data, &cubin_size),
+        "cuLinkComplete");
+  }
+  if (iree_status_is_ok(status)) {
+    status = CU_RESULT_TO_STATUS(syms, cuModuleLoadData(out_module, cubin_data),
+                                 "cuModuleLoadData");
+  }
+#if IREE_FILE_IO_ENABLE
+  if (iree_status_is_ok(status) && path) {
+    iree_hal_cuda_module_cache_store_file(
+        path, iree_make_const_byte_span(cubin_data, cubin_size));
+  }
+#endif  // IREE_FILE_IO_ENABLE
+
+  // The cubin is owned by the link state.
+  CUDA_IGNORE_ERROR(syms, cuLinkDestroy(link_state));
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+iree_status_t iree_hal_cuda_module_cache_load(
+    iree_hal_cuda_module_cache_t* cache, iree_string_view_t ptx_image,
+    CUmodule* out_module) {
+  IREE_ASSERT_ARGUMENT(cache);
+  IREE_ASSERT_ARGUMENT(out_module);
+  *out_module = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  char path[IREE_HAL_CUDA_MODULE_CACHE_MAX_PATH_LENGTH];
+  bool has_path =
+      IREE_FILE_IO_ENABLE &&
+      iree_hal_cuda_module_cache_format_path(cache, ptx_image, path);
+
+#if IREE_FILE_IO_ENABLE
+  if (has_path &&
+      iree_hal_cuda_module_cache_try_load_file(cache, path, out_module)) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_ok_status();
+  }
+#endif  // IREE_FILE_IO_ENABLE
+
+  iree_status_t status = iree_hal_cuda_module_cache_compile(
+      cache, ptx_image, has_path ? path : NULL, out_module);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
@@ -0,0 +1,52 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_CUDA_MODULE_CACHE_H_
+#define IREE_HAL_CUDA_MODULE_CACHE_H_
+
+#include "iree/base/api.h"
+#include "iree/hal/cuda/context_wrapper.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// A persistent on-disk cache of cubins JIT compiled from PTX.
+//
+// Cubins are keyed by a hash of the PTX image along with the device compute
+// capability and driver version so that a cache directory may be shared
+// across devices and driver upgrades. Cache misses JIT the PTX with
+// cuLinkComplete and write the resulting cubin to the cache directory.
+//
+// Thread-safe: modules may be loaded from multiple threads concurrently.
+// Multiple processes may share the same cache directory; entries are written
+// to a temporary file and renamed into place so that readers never observe
+// partially written files.
+typedef struct iree_hal_cuda_module_cache_t iree_hal_cuda_module_cache_t;
+
+// Creates a module cache persisting cubins for |device| under |directory|.
+// The directory must exist.
+iree_status_t iree_hal_cuda_module_cache_create(
+    iree_hal_cuda_context_wrapper_t* context, CUdevice device,
+    iree_string_view_t directory, iree_hal_cuda_module_cache_t** out_cache);
+
+// Frees |cache|. Cached files remain on disk.
+void iree_hal_cuda_module_cache_free(iree_hal_cuda_module_cache_t* cache);
+
+// Loads a module from |ptx_image| into the current context, using the cached
+// cubin if one exists and otherwise JIT compiling and caching it.
+// |ptx_image| must be NUL terminated (as flatbuffer strings are).
+// Failures to read or write the cache are not errors and fall back to
+// compiling the PTX.
+iree_status_t iree_hal_cuda_module_cache_load(
+    iree_hal_cuda_module_cache_t* cache, iree_string_view_t ptx_image,
+    CUmodule* out_module);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_CUDA_MODULE_CACHE_H_
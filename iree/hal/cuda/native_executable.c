@@ -6,7 +6,9 @@
 
 #include "iree/hal/cuda/native_executable.h"
 
+#include <stdbool.h>
 #include <stddef.h>
+#include <string.h>
 
 #include "iree/base/api.h"
 #include "iree/base/tracing.h"
@@ -24,6 +26,8 @@ typedef struct iree_hal_cuda_native_executable_function_t {
   uint32_t block_size_x;
   uint32_t block_size_y;
   uint32_t block_size_z;
+  // Name of the kernel function; references storage owned by the executable.
+  iree_string_view_t name;
 } iree_hal_cuda_native_executable_function_t;
 
 typedef struct iree_hal_cuda_native_executable_t {
@@ -31,6 +35,20 @@ typedef struct iree_hal_cuda_native_executable_t {
   iree_hal_cuda_context_wrapper_t* context;
   iree_hal_executable_layout_t** executable_layouts;
   iree_host_size_t entry_count;
+
+  // Loads the module and resolves the entry functions, possibly on a pool
+  // worker. Everything below is only valid once the preparation completes.
+  iree_hal_preparation_t preparation;
+  // True if the preparation runs on a pool worker that needs the context made
+  // current.
+  bool is_async;
+  // Optional persistent cache of compiled modules.
+  iree_hal_cuda_module_cache_t* module_cache;
+  // PTX image and entry point names; references the executable data which
+  // must remain live until the preparation completes.
+  flatbuffers_string_t ptx_image;
+  flatbuffers_string_vec_t entry_points_vec;
+
   CUmodule module;
   iree_hal_cuda_native_executable_function_t entry_functions[];
 } iree_hal_cuda_native_executable_t;
@@ -44,8 +62,54 @@ static iree_hal_cuda_native_executable_t* iree_hal_cuda_native_executable_cast(
   return (iree_hal_cuda_native_executable_t*)base_value;
 }
 
+// Loads the PTX module and looks up the entry point functions. PTX is JIT
+// compiled by the driver here and dominates executable creation time.
+static iree_status_t iree_hal_cuda_native_executable_load(void* user_data) {
+  iree_hal_cuda_native_executable_t* executable =
+      (iree_hal_cuda_native_executable_t*)user_data;
+  iree_hal_cuda_context_wrapper_t* context = executable->context;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Pool workers are not bound to any context.
+  iree_status_t status = iree_ok_status();
+  if (executable->is_async) {
+    status = CU_RESULT_TO_STATUS(
+        context->syms, cuCtxSetCurrent(context->cu_context), "cuCtxSetCurrent");
+  }
+
+  if (iree_status_is_ok(status) && executable->module_cache) {
+    status = iree_hal_cuda_module_cache_load(
+        executable->module_cache,
+        iree_make_string_view(executable->ptx_image,
+                              flatbuffers_string_len(executable->ptx_image)),
+        &executable->module);
+  } else if (iree_status_is_ok(status)) {
+    status = CU_RESULT_TO_STATUS(
+        context->syms,
+        cuModuleLoadDataEx(&executable->module, executable->ptx_image, 0, NULL,
+                           NULL),
+        "cuModuleLoadDataEx");
+  }
+
+  for (iree_host_size_t i = 0; i < executable->entry_count; i++) {
+    if (!iree_status_is_ok(status)) break;
+    const char* entry_name =
+        flatbuffers_string_vec_at(executable->entry_points_vec, i);
+    status = CU_RESULT_TO_STATUS(
+        context->syms,
+        cuModuleGetFunction(&executable->entry_functions[i].cu_function,
+                            executable->module, entry_name),
+        "cuModuleGetFunction");
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
 iree_status_t iree_hal_cuda_native_executable_create(
     iree_hal_cuda_context_wrapper_t* context,
+    iree_hal_preparation_pool_t* preparation_pool,
+    iree_hal_cuda_module_cache_t* module_cache,
     const iree_hal_executable_spec_t* executable_spec,
     iree_hal_executable_t** out_executable) {
   IREE_ASSERT_ARGUMENT(context);
@@ -60,7 +124,6 @@ iree_status_t iree_hal_cuda_native_executable_create(
   iree_CUDAExecutableDef_table_t executable_def =
       iree_CUDAExecutableDef_as_root(executable_spec->executable_data.data);
 
-  // Create the kernel module.
   flatbuffers_string_t ptx_image =
       iree_CUDAExecutableDef_ptx_image_get(executable_def);
   flatbuffers_string_vec_t entry_points_vec =
@@ -68,44 +131,64 @@ iree_status_t iree_hal_cuda_native_executable_create(
   iree_CUDABlockSizeDef_vec_t block_sizes_vec =
       iree_CUDAExecutableDef_block_sizes_get(executable_def);
   iree_host_size_t entry_count = flatbuffers_string_vec_len(entry_points_vec);
+  // Entry point names are copied so that they remain available for profiling
+  // after the executable data is released.
+  iree_host_size_t total_name_length = 0;
+  for (iree_host_size_t i = 0; i < entry_count; i++) {
+    total_name_length += flatbuffers_string_len(
+        flatbuffers_string_vec_at(entry_points_vec, i));
+  }
   iree_host_size_t total_size =
       sizeof(*executable) +
       entry_count * sizeof(iree_hal_cuda_native_executable_function_t) +
+      entry_count * sizeof(iree_hal_executable_layout_t*) + total_name_length;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(context->host_allocator, total_size,
+                                (void**)&executable));
+  memset(executable, 0, total_size);
+  iree_hal_resource_initialize(&iree_hal_cuda_native_executable_vtable,
+                               &executable->resource);
+  executable->context = context;
+  executable->executable_layouts =
+      (void*)((char*)executable + sizeof(*executable) +
+              entry_count * sizeof(iree_hal_cuda_native_executable_function_t));
+  executable->entry_count = entry_count;
+  executable->ptx_image = ptx_image;
+  executable->entry_points_vec = entry_points_vec;
+  executable->module_cache = module_cache;
+  char* name_storage =
+      (char*)executable->executable_layouts +
       entry_count * sizeof(iree_hal_executable_layout_t*);
-  iree_status_t status = iree_allocator_malloc(context->host_allocator,
-                                               total_size, (void**)&executable);
-  CUmodule module = NULL;
-  if (iree_status_is_ok(status)) {
-    iree_hal_resource_initialize(&iree_hal_cuda_native_executable_vtable,
-                                 &executable->resource);
-    executable->module = module;
-    executable->context = context;
-
-    executable->executable_layouts =
-        (void*)((char*)executable + sizeof(*executable) +
-                entry_count *
-                    sizeof(iree_hal_cuda_native_executable_function_t));
-    status = CU_RESULT_TO_STATUS(
-        context->syms, cuModuleLoadDataEx(&module, ptx_image, 0, NULL, NULL),
-        "cuModuleLoadDataEx");
+  for (iree_host_size_t i = 0; i < entry_count; i++) {
+    flatbuffers_string_t entry_name =
+        flatbuffers_string_vec_at(entry_points_vec, i);
+    iree_host_size_t entry_name_length = flatbuffers_string_len(entry_name);
+    memcpy(name_storage, entry_name, entry_name_length);
+    executable->entry_functions[i].name =
+        iree_make_string_view(name_storage, entry_name_length);
+    name_storage += entry_name_length;
+    executable->entry_functions[i].block_size_x = block_sizes_vec[i].x;
+    executable->entry_functions[i].block_size_y = block_sizes_vec[i].y;
+    executable->entry_functions[i].block_size_z = block_sizes_vec[i].z;
+    executable->executable_layouts[i] = executable_spec->executable_layouts[i];
+    iree_hal_executable_layout_retain(executable_spec->executable_layouts[i]);
   }
 
-  executable->entry_count = entry_count;
-  for (iree_host_size_t i = 0; i < entry_count; i++) {
-    if (iree_status_is_ok(status)) {
-      CUfunction function = NULL;
-      const char* entry_name = flatbuffers_string_vec_at(entry_points_vec, i);
-      status = CU_RESULT_TO_STATUS(
-          context->syms, cuModuleGetFunction(&function, module, entry_name),
-          "cuModuleGetFunction");
-      executable->entry_functions[i].cu_function = function;
-      executable->entry_functions[i].block_size_x = block_sizes_vec[i].x;
-      executable->entry_functions[i].block_size_y = block_sizes_vec[i].y;
-      executable->entry_functions[i].block_size_z = block_sizes_vec[i].z;
-      executable->executable_layouts[i] =
-          executable_spec->executable_layouts[i];
-      iree_hal_executable_layout_retain(executable_spec->executable_layouts[i]);
-    }
+  // Loading can only be deferred if the executable data outlives the call;
+  // otherwise load inline so that failures are reported immediately.
+  if (!iree_all_bits_set(
+          executable_spec->caching_mode,
+          IREE_HAL_EXECUTABLE_CACHING_MODE_ALIAS_PROVIDED_DATA)) {
+    preparation_pool = NULL;
+  }
+  executable->is_async = preparation_pool != NULL;
+  iree_hal_preparation_initialize(preparation_pool,
+                                  iree_hal_cuda_native_executable_load,
+                                  executable, &executable->preparation);
+
+  iree_status_t status = iree_ok_status();
+  if (!executable->is_async) {
+    status = iree_hal_preparation_wait(&executable->preparation);
   }
 
   if (iree_status_is_ok(status)) {
@@ -125,6 +208,13 @@ static void iree_hal_cuda_native_executable_destroy(
   iree_allocator_t host_allocator = executable->context->host_allocator;
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  // Cancels or waits for any pending load.
+  iree_hal_preparation_deinitialize(&executable->preparation);
+  if (executable->module) {
+    CUDA_IGNORE_ERROR(executable->context->syms,
+                      cuModuleUnload(executable->module));
+  }
+
   for (iree_host_size_t i = 0; i < executable->entry_count; ++i) {
     iree_hal_executable_layout_release(executable->executable_layouts[i]);
   }
@@ -133,11 +223,15 @@ static void iree_hal_cuda_native_executable_destroy(
   IREE_TRACE_ZONE_END(z0);
 }
 
-CUfunction iree_hal_cuda_native_executable_for_entry_point(
-    iree_hal_executable_t* base_executable, int32_t entry_point) {
+iree_status_t iree_hal_cuda_native_executable_for_entry_point(
+    iree_hal_executable_t* base_executable, int32_t entry_point,
+    CUfunction* out_function) {
   iree_hal_cuda_native_executable_t* executable =
       iree_hal_cuda_native_executable_cast(base_executable);
-  return executable->entry_functions[entry_point].cu_function;
+  *out_function = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_preparation_wait(&executable->preparation));
+  *out_function = executable->entry_functions[entry_point].cu_function;
+  return iree_ok_status();
 }
 
 iree_status_t iree_hal_cuda_native_executable_block_size(
@@ -151,6 +245,13 @@ iree_status_t iree_hal_cuda_native_executable_block_size(
   return iree_ok_status();
 }
 
+iree_string_view_t iree_hal_cuda_native_executable_entry_point_name(
+    iree_hal_executable_t* base_executable, int32_t entry_point) {
+  iree_hal_cuda_native_executable_t* executable =
+      iree_hal_cuda_native_executable_cast(base_executable);
+  return executable->entry_functions[entry_point].name;
+}
+
 iree_hal_executable_layout_t* iree_hal_cuda_executable_get_layout(
     iree_hal_executable_t* base_executable, int32_t entry_point) {
   iree_hal_cuda_native_executable_t* executable =
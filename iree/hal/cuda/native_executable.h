@@ -13,6 +13,8 @@
 #include "iree/hal/api.h"
 #include "iree/hal/cuda/context_wrapper.h"
 #include "iree/hal/cuda/cuda_headers.h"
+#include "iree/hal/cuda/module_cache.h"
+#include "iree/hal/utils/preparation_pool.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -20,19 +22,36 @@ extern "C" {
 
 // Creates an executable from a PTX module. The module may contain several
 // kernels that can be extracted along with the associated block size.
+//
+// If |preparation_pool| is provided and the executable data is aliased the
+// module is loaded asynchronously on the pool and load failures are reported
+// when the executable is first dispatched.
+//
+// If |module_cache| is provided the module is loaded from a persisted cubin
+// when available instead of JIT compiling the PTX.
 iree_status_t iree_hal_cuda_native_executable_create(
     iree_hal_cuda_context_wrapper_t* context,
+    iree_hal_preparation_pool_t* preparation_pool,
+    iree_hal_cuda_module_cache_t* module_cache,
     const iree_hal_executable_spec_t* executable_spec,
     iree_hal_executable_t** out_executable);
 
-CUfunction iree_hal_cuda_native_executable_for_entry_point(
-    iree_hal_executable_t* executable, int32_t entry_point);
+// Returns the kernel function of |entry_point| in |out_function|, blocking
+// until the executable has finished loading.
+iree_status_t iree_hal_cuda_native_executable_for_entry_point(
+    iree_hal_executable_t* executable, int32_t entry_point,
+    CUfunction* out_function);
 
 // Return the block size of the given |entry_point| within the executable.
 iree_status_t iree_hal_cuda_native_executable_block_size(
     iree_hal_executable_t* executable, int32_t entry_point, uint32_t* x,
     uint32_t* y, uint32_t* z);
 
+// Returns the kernel function name of |entry_point|. The name remains valid for
+// the lifetime of the executable.
+iree_string_view_t iree_hal_cuda_native_executable_entry_point_name(
+    iree_hal_executable_t* executable, int32_t entry_point);
+
 /// Return the layout associated with the entry point.
 iree_hal_executable_layout_t* iree_hal_cuda_executable_get_layout(
     iree_hal_executable_t* executable, int32_t entry_point);
@@ -16,6 +16,10 @@
 typedef struct iree_hal_cuda_nop_executable_cache_t {
   iree_hal_resource_t resource;
   iree_hal_cuda_context_wrapper_t* context;
+  // Unowned pool used to load executables asynchronously, if any.
+  iree_hal_preparation_pool_t* preparation_pool;
+  // Unowned persistent cache of compiled modules, if any.
+  iree_hal_cuda_module_cache_t* module_cache;
 } iree_hal_cuda_nop_executable_cache_t;
 
 static const iree_hal_executable_cache_vtable_t
@@ -29,7 +33,9 @@ iree_hal_cuda_nop_executable_cache_cast(
 }
 
 iree_status_t iree_hal_cuda_nop_executable_cache_create(
-    iree_hal_cuda_context_wrapper_t* context, iree_string_view_t identifier,
+    iree_hal_cuda_context_wrapper_t* context,
+    iree_hal_preparation_pool_t* preparation_pool,
+    iree_hal_cuda_module_cache_t* module_cache, iree_string_view_t identifier,
     iree_hal_executable_cache_t** out_executable_cache) {
   IREE_ASSERT_ARGUMENT(out_executable_cache);
   *out_executable_cache = NULL;
@@ -43,6 +49,8 @@ iree_status_t iree_hal_cuda_nop_executable_cache_create(
     iree_hal_resource_initialize(&iree_hal_cuda_nop_executable_cache_vtable,
                                  &executable_cache->resource);
     executable_cache->context = context;
+    executable_cache->preparation_pool = preparation_pool;
+    executable_cache->module_cache = module_cache;
 
     *out_executable_cache = (iree_hal_executable_cache_t*)executable_cache;
   }
@@ -77,7 +85,8 @@ static iree_status_t iree_hal_cuda_nop_executable_cache_prepare_executable(
   iree_hal_cuda_nop_executable_cache_t* executable_cache =
       iree_hal_cuda_nop_executable_cache_cast(base_executable_cache);
   return iree_hal_cuda_native_executable_create(
-      executable_cache->context, executable_spec, out_executable);
+      executable_cache->context, executable_cache->preparation_pool,
+      executable_cache->module_cache, executable_spec, out_executable);
 }
 
 static const iree_hal_executable_cache_vtable_t
@@ -10,16 +10,23 @@
 #include "iree/base/api.h"
 #include "iree/hal/api.h"
 #include "iree/hal/cuda/context_wrapper.h"
+#include "iree/hal/cuda/module_cache.h"
+#include "iree/hal/utils/preparation_pool.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif  // __cplusplus
 
-// Creates a no-op executable cache that does not cache at all.
+// Creates an executable cache that does not cache executables in memory.
 // This is useful to isolate pipeline caching behavior and verify compilation
 // behavior.
+//
+// |preparation_pool| and |module_cache| are optional and unowned. When
+// |module_cache| is provided compiled modules are persisted across processes.
 iree_status_t iree_hal_cuda_nop_executable_cache_create(
-    iree_hal_cuda_context_wrapper_t* context, iree_string_view_t identifier,
+    iree_hal_cuda_context_wrapper_t* context,
+    iree_hal_preparation_pool_t* preparation_pool,
+    iree_hal_cuda_module_cache_t* module_cache, iree_string_view_t identifier,
     iree_hal_executable_cache_t** out_executable_cache);
 
 #ifdef __cplusplus
@@ -26,6 +26,26 @@ IREE_FLAG(bool, cuda_allow_inline_execution, false,
           "Allow command buffers to execute inline against CUDA streams when "
           "possible.");
 
+IREE_FLAG(int32_t, cuda_concurrent_stream_count, 4,
+          "Number of CUDA streams independent commands are distributed across "
+          "when executing command buffers against streams.");
+
+IREE_FLAG(int32_t, cuda_staging_chunk_count, 4,
+          "Number of pinned host chunks host<->device transfers are staged "
+          "through. 0 transfers directly from pageable memory.");
+
+IREE_FLAG(string, cuda_executable_cache_path, "",
+          "Directory used to persist cubins JIT compiled from PTX across runs. "
+          "Disabled if empty.");
+
+IREE_FLAG(bool, cuda_use_memory_pools, true,
+          "Allocate device-local memory from a CUDA memory pool with "
+          "stream-ordered allocation and release.");
+
+IREE_FLAG(int64_t, cuda_memory_pool_release_threshold, -1,
+          "Bytes of released memory the CUDA memory pool retains for reuse. "
+          "-1 retains all memory until the device is trimmed.");
+
 static iree_status_t iree_hal_cuda_driver_factory_enumerate(
     void* self, const iree_hal_driver_info_t** out_driver_infos,
     iree_host_size_t* out_driver_info_count) {
@@ -60,6 +80,17 @@ static iree_status_t iree_hal_cuda_driver_factory_try_create(
         IREE_HAL_CUDA_COMMAND_BUFFER_MODE_STREAM;
   }
   default_params.allow_inline_execution = FLAG_cuda_allow_inline_execution;
+  default_params.concurrent_stream_count =
+      FLAG_cuda_concurrent_stream_count;
+  default_params.executable_cache_path =
+      iree_make_cstring_view(FLAG_cuda_executable_cache_path);
+  default_params.staging_chunk_count =
+      (iree_host_size_t)iree_max(0, FLAG_cuda_staging_chunk_count);
+  default_params.use_memory_pools = FLAG_cuda_use_memory_pools;
+  if (FLAG_cuda_memory_pool_release_threshold >= 0) {
+    default_params.memory_pool_release_threshold =
+        (uint64_t)FLAG_cuda_memory_pool_release_threshold;
+  }
 
   iree_hal_cuda_driver_options_t driver_options;
   iree_hal_cuda_driver_options_initialize(&driver_options);
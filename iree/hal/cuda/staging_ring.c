@@ -0,0 +1,256 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/cuda/staging_ring.h"
+
+#include <string.h>
+
+#include "iree/base/tracing.h"
+#include "iree/hal/cuda/dynamic_symbols.h"
+#include "iree/hal/cuda/status_util.h"
+
+iree_status_t iree_hal_cuda_staging_ring_initialize(
+    iree_hal_cuda_context_wrapper_t* context, iree_host_size_t chunk_size,
+    iree_host_size_t chunk_count, iree_hal_cuda_staging_ring_t* out_ring) {
+  IREE_ASSERT_ARGUMENT(context);
+  IREE_ASSERT_ARGUMENT(out_ring);
+  memset(out_ring, 0, sizeof(*out_ring));
+  if (chunk_count == 0 ||
+      chunk_count > IREE_HAL_CUDA_STAGING_RING_MAX_CHUNK_COUNT) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "staging ring chunk count %zu outside of [1, %d]",
+                            chunk_count,
+                            IREE_HAL_CUDA_STAGING_RING_MAX_CHUNK_COUNT);
+  }
+  if (chunk_size == 0) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "staging ring chunks must be non-empty");
+  }
+  out_ring->context = context;
+  out_ring->chunk_size = chunk_size;
+  out_ring->chunk_count = chunk_count;
+  iree_slim_mutex_initialize(&out_ring->mutex);
+  return iree_ok_status();
+}
+
+static void iree_hal_cuda_staging_ring_release_resources(
+    iree_hal_cuda_staging_ring_t* ring) {
+  iree_hal_cuda_context_wrapper_t* context = ring->context;
+  if (ring->copy_stream) {
+    CUDA_IGNORE_ERROR(context->syms, cuStreamSynchronize(ring->copy_stream));
+  }
+  for (iree_host_size_t i = 0; i < ring->chunk_count; ++i) {
+    if (ring->chunk_events[i]) {
+      CUDA_IGNORE_ERROR(context->syms, cuEventDestroy(ring->chunk_events[i]));
+      ring->chunk_events[i] = NULL;
+    }
+  }
+  if (ring->primary_event) {
+    CUDA_IGNORE_ERROR(context->syms, cuEventDestroy(ring->primary_event));
+    ring->primary_event = NULL;
+  }
+  if (ring->copy_stream) {
+    CUDA_IGNORE_ERROR(context->syms, cuStreamDestroy(ring->copy_stream));
+    ring->copy_stream = NULL;
+  }
+  if (ring->host_base) {
+    CUDA_IGNORE_ERROR(context->syms, cuMemFreeHost(ring->host_base));
+    ring->host_base = NULL;
+  }
+}
+
+void iree_hal_cuda_staging_ring_deinitialize(
+    iree_hal_cuda_staging_ring_t* ring) {
+  if (!ring->context) return;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_hal_cuda_staging_ring_release_resources(ring);
+  iree_slim_mutex_deinitialize(&ring->mutex);
+  memset(ring, 0, sizeof(*ring));
+  IREE_TRACE_ZONE_END(z0);
+}
+
+// Creates the stream, events, and host memory on first use.
+// Must be called with the ring mutex held.
+static iree_status_t iree_hal_cuda_staging_ring_ensure_resources(
+    iree_hal_cuda_staging_ring_t* ring) {
+  if (ring->host_base) return iree_ok_status();
+  iree_hal_cuda_context_wrapper_t* context = ring->context;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Portable so that the memory is pinned for all contexts; the same ring is
+  // used for reads and writes and as such is not write-combined.
+  void* host_base = NULL;
+  iree_status_t status = CU_RESULT_TO_STATUS(
+      context->syms,
+      cuMemHostAlloc(&host_base, ring->chunk_count * ring->chunk_size,
+                     CU_MEMHOSTALLOC_PORTABLE),
+      "cuMemHostAlloc");
+  ring->host_base = (uint8_t*)host_base;
+  if (iree_status_is_ok(status)) {
+    status = CU_RESULT_TO_STATUS(
+        context->syms,
+        cuStreamCreate(&ring->copy_stream, CU_STREAM_NON_BLOCKING),
+        "cuStreamCreate");
+  }
+  if (iree_status_is_ok(status)) {
+    status = CU_RESULT_TO_STATUS(
+        context->syms,
+        cuEventCreate(&ring->primary_event, CU_EVENT_DISABLE_TIMING),
+        "cuEventCreate");
+  }
+  for (iree_host_size_t i = 0;
+       i < ring->chunk_count && iree_status_is_ok(status); ++i) {
+    status = CU_RESULT_TO_STATUS(
+        context->syms,
+        cuEventCreate(&ring->chunk_events[i], CU_EVENT_DISABLE_TIMING),
+        "cuEventCreate");
+  }
+
+  if (!iree_status_is_ok(status)) {
+    iree_hal_cuda_staging_ring_release_resources(ring);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Orders the copy stream after all work issued to |primary_stream| so far.
+static iree_status_t iree_hal_cuda_staging_ring_wait_primary(
+    iree_hal_cuda_staging_ring_t* ring, CUstream primary_stream) {
+  iree_hal_cuda_context_wrapper_t* context = ring->context;
+  IREE_RETURN_IF_ERROR(CU_RESULT_TO_STATUS(
+      context->syms, cuEventRecord(ring->primary_event, primary_stream),
+      "cuEventRecord"));
+  return CU_RESULT_TO_STATUS(
+      context->syms,
+      cuStreamWaitEvent(ring->copy_stream, ring->primary_event, 0),
+      "cuStreamWaitEvent");
+}
+
+iree_status_t iree_hal_cuda_staging_ring_upload(
+    iree_hal_cuda_staging_ring_t* ring, CUstream primary_stream,
+    const void* source, CUdeviceptr target, iree_host_size_t length) {
+  if (length == 0) return iree_ok_status();
+  iree_hal_cuda_context_wrapper_t* context = ring->context;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)length);
+  iree_slim_mutex_lock(&ring->mutex);
+
+  iree_status_t status = iree_hal_cuda_staging_ring_ensure_resources(ring);
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_cuda_staging_ring_wait_primary(ring, primary_stream);
+  }
+
+  // Fill each chunk once the copy previously using it has completed and issue
+  // its copy; the host fills the next chunk while the copy engine drains this
+  // one.
+  const uint8_t* source_ptr = (const uint8_t*)source;
+  iree_host_size_t chunk_ordinal = 0;
+  for (iree_host_size_t offset = 0;
+       offset < length && iree_status_is_ok(status);
+       offset += ring->chunk_size, ++chunk_ordinal) {
+    iree_host_size_t slot = chunk_ordinal % ring->chunk_count;
+    iree_host_size_t chunk_length = iree_min(ring->chunk_size, length - offset);
+    uint8_t* chunk_ptr = ring->host_base + slot * ring->chunk_size;
+    if (chunk_ordinal >= ring->chunk_count) {
+      status = CU_RESULT_TO_STATUS(
+          context->syms, cuEventSynchronize(ring->chunk_events[slot]),
+          "cuEventSynchronize");
+      if (!iree_status_is_ok(status)) break;
+    }
+    memcpy(chunk_ptr, source_ptr + offset, chunk_length);
+    status = CU_RESULT_TO_STATUS(
+        context->syms,
+        cuMemcpyAsync(target + offset, (CUdeviceptr)chunk_ptr, chunk_length,
+                      ring->copy_stream),
+        "cuMemcpyAsync");
+    if (iree_status_is_ok(status)) {
+      status = CU_RESULT_TO_STATUS(
+          context->syms,
+          cuEventRecord(ring->chunk_events[slot], ring->copy_stream),
+          "cuEventRecord");
+    }
+  }
+
+  // Wait for the tail even on failure so the chunks are idle for reuse.
+  if (ring->copy_stream) {
+    iree_status_t sync_status = CU_RESULT_TO_STATUS(
+        context->syms, cuStreamSynchronize(ring->copy_stream),
+        "cuStreamSynchronize");
+    status = iree_status_join(status, sync_status);
+  }
+
+  iree_slim_mutex_unlock(&ring->mutex);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+iree_status_t iree_hal_cuda_staging_ring_download(
+    iree_hal_cuda_staging_ring_t* ring, CUstream primary_stream,
+    CUdeviceptr source, void* target, iree_host_size_t length) {
+  if (length == 0) return iree_ok_status();
+  iree_hal_cuda_context_wrapper_t* context = ring->context;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)length);
+  iree_slim_mutex_lock(&ring->mutex);
+
+  iree_status_t status = iree_hal_cuda_staging_ring_ensure_resources(ring);
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_cuda_staging_ring_wait_primary(ring, primary_stream);
+  }
+
+  // Keep up to |chunk_count| copies in flight: drain the oldest chunk into
+  // |target| and reissue its slot for the next range while the copy engine
+  // fills the others.
+  uint8_t* target_ptr = (uint8_t*)target;
+  iree_host_size_t chunk_total =
+      (length + ring->chunk_size - 1) / ring->chunk_size;
+  iree_host_size_t issued_count = 0;
+  for (iree_host_size_t drained_count = 0;
+       drained_count < chunk_total && iree_status_is_ok(status);
+       ++drained_count) {
+    while (issued_count < chunk_total &&
+           issued_count < drained_count + ring->chunk_count &&
+           iree_status_is_ok(status)) {
+      iree_host_size_t slot = issued_count % ring->chunk_count;
+      iree_host_size_t offset = issued_count * ring->chunk_size;
+      iree_host_size_t chunk_length =
+          iree_min(ring->chunk_size, length - offset);
+      uint8_t* chunk_ptr = ring->host_base + slot * ring->chunk_size;
+      status = CU_RESULT_TO_STATUS(
+          context->syms,
+          cuMemcpyAsync((CUdeviceptr)chunk_ptr, source + offset, chunk_length,
+                        ring->copy_stream),
+          "cuMemcpyAsync");
+      if (iree_status_is_ok(status)) {
+        status = CU_RESULT_TO_STATUS(
+            context->syms,
+            cuEventRecord(ring->chunk_events[slot], ring->copy_stream),
+            "cuEventRecord");
+      }
+      ++issued_count;
+    }
+    if (!iree_status_is_ok(status)) break;
+    iree_host_size_t slot = drained_count % ring->chunk_count;
+    iree_host_size_t offset = drained_count * ring->chunk_size;
+    iree_host_size_t chunk_length = iree_min(ring->chunk_size, length - offset);
+    status = CU_RESULT_TO_STATUS(context->syms,
+                                 cuEventSynchronize(ring->chunk_events[slot]),
+                                 "cuEventSynchronize");
+    if (iree_status_is_ok(status)) {
+      memcpy(target_ptr + offset, ring->host_base + slot * ring->chunk_size,
+             chunk_length);
+    }
+  }
+
+  // Wait for any copies still in flight on failure so the chunks are idle.
+  if (!iree_status_is_ok(status) && ring->copy_stream) {
+    CUDA_IGNORE_ERROR(context->syms, cuStreamSynchronize(ring->copy_stream));
+  }
+
+  iree_slim_mutex_unlock(&ring->mutex);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
@@ -0,0 +1,76 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_CUDA_STAGING_RING_H_
+#define IREE_HAL_CUDA_STAGING_RING_H_
+
+#include "iree/base/api.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/hal/cuda/context_wrapper.h"
+#include "iree/hal/cuda/cuda_headers.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Maximum number of chunks a staging ring may be split into.
+#define IREE_HAL_CUDA_STAGING_RING_MAX_CHUNK_COUNT 8
+
+// A ring of page-locked host memory chunks that host<->device transfers are
+// staged through on a dedicated copy stream.
+//
+// Copies from pageable memory are staged by the driver through its own small
+// pinned buffers at reduced bandwidth. Staging through persistent pinned
+// chunks lets the copy engine run at full bandwidth while the host fills (or
+// drains) the next chunk: transfers are split into chunks and each chunk's
+// memcpy overlaps with the DMA of the chunks before it. The copy stream is
+// independent of the compute streams and only waits on the work issued to the
+// primary stream prior to the transfer.
+//
+// Thread-safe: concurrent transfers are serialized.
+typedef struct iree_hal_cuda_staging_ring_t {
+  iree_hal_cuda_context_wrapper_t* context;
+  iree_host_size_t chunk_size;
+  iree_host_size_t chunk_count;
+
+  // Guards the resources below, which are created on the first transfer.
+  iree_slim_mutex_t mutex;
+  CUstream copy_stream;
+  // Base of |chunk_count| * |chunk_size| bytes of page-locked host memory.
+  uint8_t* host_base;
+  // |chunk_events[i]| is recorded after the last copy using chunk |i|.
+  CUevent chunk_events[IREE_HAL_CUDA_STAGING_RING_MAX_CHUNK_COUNT];
+  // Recorded on the primary stream to order transfers after prior work.
+  CUevent primary_event;
+} iree_hal_cuda_staging_ring_t;
+
+// Initializes |out_ring| with |chunk_count| chunks of |chunk_size| bytes.
+// Host memory and streams are not allocated until the first transfer.
+iree_status_t iree_hal_cuda_staging_ring_initialize(
+    iree_hal_cuda_context_wrapper_t* context, iree_host_size_t chunk_size,
+    iree_host_size_t chunk_count, iree_hal_cuda_staging_ring_t* out_ring);
+
+// Waits for pending copies and releases all resources held by |ring|.
+void iree_hal_cuda_staging_ring_deinitialize(
+    iree_hal_cuda_staging_ring_t* ring);
+
+// Copies |length| bytes from the pageable host |source| to |target| after all
+// work previously issued to |primary_stream|. Returns once the copy completes.
+iree_status_t iree_hal_cuda_staging_ring_upload(
+    iree_hal_cuda_staging_ring_t* ring, CUstream primary_stream,
+    const void* source, CUdeviceptr target, iree_host_size_t length);
+
+// Copies |length| bytes from |source| to the pageable host |target| after all
+// work previously issued to |primary_stream|. Returns once the copy completes.
+iree_status_t iree_hal_cuda_staging_ring_download(
+    iree_hal_cuda_staging_ring_t* ring, CUstream primary_stream,
+    CUdeviceptr source, void* target, iree_host_size_t length);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_CUDA_STAGING_RING_H_
@@ -6,6 +6,8 @@
 
 #include "iree/hal/cuda/stream_command_buffer.h"
 
+#include <string.h>
+
 #include "iree/base/tracing.h"
 #include "iree/hal/cuda/cuda_buffer.h"
 #include "iree/hal/cuda/cuda_event.h"
@@ -14,20 +16,33 @@
 #include "iree/hal/cuda/status_util.h"
 
 #define IREE_HAL_CUDA_MAX_BINDING_COUNT 64
-// Kernel arguments contains binding and push constants.
-#define IREE_HAL_CUDA_MAX_KERNEL_ARG 128
 // This records the commands on the calling thread without additional threading
 // indirection.
 
 typedef struct {
   iree_hal_command_buffer_t base;
   iree_hal_cuda_context_wrapper_t* context;
-  CUstream stream;
+
+  // Streams commands are issued on. Commands between execution barriers are
+  // independent and distributed round-robin across the pool; each barrier joins
+  // all streams used since the previous one back into the primary stream.
+  iree_hal_cuda_stream_pool_t* stream_pool;
+  // Index of the stream in |stream_pool| the next command is issued on.
+  iree_host_size_t next_stream_index;
+  // Bit i is set if |stream_pool| stream i has been forked from the primary
+  // stream since the last barrier.
+  uint32_t forked_stream_mask;
+
+  // Optional device profiler that times dispatches.
+  iree_hal_cuda_dispatch_profiler_t* profiler;
 
   int32_t push_constant[IREE_HAL_CUDA_MAX_PUSH_CONSTANT_COUNT];
-  // Keep track of the current set of kernel arguments.
-  void* current_descriptor[IREE_HAL_CUDA_MAX_KERNEL_ARG];
-  CUdeviceptr* device_ptrs[IREE_HAL_CUDA_MAX_KERNEL_ARG];
+  // Packed kernel arguments of the next dispatch as laid out by its
+  // executable layout. Bindings are written as they are pushed and constants
+  // are copied into place on dispatch. cuLaunchKernel copies the arguments
+  // when the launch is issued and the buffer is reused by all dispatches.
+  CUdeviceptr kernel_args[IREE_HAL_CUDA_MAX_KERNEL_ARG_SIZE /
+                          sizeof(CUdeviceptr)];
 } iree_hal_cuda_stream_command_buffer_t;
 
 static const iree_hal_command_buffer_vtable_t
@@ -43,9 +58,12 @@ iree_hal_cuda_stream_command_buffer_cast(
 iree_status_t iree_hal_cuda_stream_command_buffer_create(
     iree_hal_device_t* device, iree_hal_cuda_context_wrapper_t* context,
     iree_hal_command_buffer_mode_t mode,
-    iree_hal_command_category_t command_categories, CUstream stream,
+    iree_hal_command_category_t command_categories,
+    iree_hal_cuda_stream_pool_t* stream_pool,
+    iree_hal_cuda_dispatch_profiler_t* profiler,
     iree_hal_command_buffer_t** out_command_buffer) {
   IREE_ASSERT_ARGUMENT(context);
+  IREE_ASSERT_ARGUMENT(stream_pool);
   IREE_ASSERT_ARGUMENT(out_command_buffer);
   *out_command_buffer = NULL;
   IREE_TRACE_ZONE_BEGIN(z0);
@@ -59,10 +77,10 @@ iree_status_t iree_hal_cuda_stream_command_buffer_create(
         device, mode, command_categories, IREE_HAL_QUEUE_AFFINITY_ANY,
         &iree_hal_cuda_stream_command_buffer_vtable, &command_buffer->base);
     command_buffer->context = context;
-    command_buffer->stream = stream;
-    for (size_t i = 0; i < IREE_HAL_CUDA_MAX_KERNEL_ARG; i++) {
-      command_buffer->current_descriptor[i] = &command_buffer->device_ptrs[i];
-    }
+    command_buffer->stream_pool = stream_pool;
+    command_buffer->next_stream_index = 0;
+    command_buffer->forked_stream_mask = 0;
+    command_buffer->profiler = profiler;
   }
 
   *out_command_buffer = &command_buffer->base;
@@ -96,14 +114,75 @@ static void* iree_hal_cuda_stream_command_buffer_dyn_cast(
   return NULL;
 }
 
+// Records the point on the primary stream that streams forked in the current
+// barrier scope wait on. Must be called at the start of each scope before any
+// command is issued so that forked streams don't also wait on the first
+// command of the scope issued to the primary stream.
+static iree_status_t iree_hal_cuda_stream_command_buffer_fork_streams(
+    iree_hal_cuda_stream_command_buffer_t* command_buffer) {
+  iree_hal_cuda_stream_pool_t* stream_pool = command_buffer->stream_pool;
+  if (stream_pool->count <= 1) return iree_ok_status();
+  CUDA_RETURN_IF_ERROR(
+      command_buffer->context->syms,
+      cuEventRecord(stream_pool->events[0], stream_pool->streams[0]),
+      "cuEventRecord");
+  return iree_ok_status();
+}
+
+// Returns the stream the next command should be issued on in |out_stream|.
+// Streams other than the primary stream first wait for all work issued on the
+// primary stream prior to the last barrier.
+static iree_status_t iree_hal_cuda_stream_command_buffer_acquire_stream(
+    iree_hal_cuda_stream_command_buffer_t* command_buffer,
+    CUstream* out_stream) {
+  iree_hal_cuda_stream_pool_t* stream_pool = command_buffer->stream_pool;
+  iree_host_size_t index = command_buffer->next_stream_index;
+  command_buffer->next_stream_index = (index + 1) % stream_pool->count;
+  uint32_t stream_bit = 1u << index;
+  if (index != 0 && !(command_buffer->forked_stream_mask & stream_bit)) {
+    CUDA_RETURN_IF_ERROR(command_buffer->context->syms,
+                         cuStreamWaitEvent(stream_pool->streams[index],
+                                           stream_pool->events[0], 0),
+                         "cuStreamWaitEvent");
+    command_buffer->forked_stream_mask |= stream_bit;
+  }
+  *out_stream = stream_pool->streams[index];
+  return iree_ok_status();
+}
+
+// Makes the primary stream wait on all work issued to other streams.
+static iree_status_t iree_hal_cuda_stream_command_buffer_join_streams(
+    iree_hal_cuda_stream_command_buffer_t* command_buffer) {
+  iree_hal_cuda_stream_pool_t* stream_pool = command_buffer->stream_pool;
+  for (iree_host_size_t i = 1; i < stream_pool->count; ++i) {
+    if (!(command_buffer->forked_stream_mask & (1u << i))) continue;
+    CUDA_RETURN_IF_ERROR(
+        command_buffer->context->syms,
+        cuEventRecord(stream_pool->events[i], stream_pool->streams[i]),
+        "cuEventRecord");
+    CUDA_RETURN_IF_ERROR(command_buffer->context->syms,
+                         cuStreamWaitEvent(stream_pool->streams[0],
+                                           stream_pool->events[i], 0),
+                         "cuStreamWaitEvent");
+  }
+  command_buffer->forked_stream_mask = 0;
+  command_buffer->next_stream_index = 0;
+  return iree_ok_status();
+}
+
 static iree_status_t iree_hal_cuda_stream_command_buffer_begin(
     iree_hal_command_buffer_t* base_command_buffer) {
-  return iree_ok_status();
+  iree_hal_cuda_stream_command_buffer_t* command_buffer =
+      iree_hal_cuda_stream_command_buffer_cast(base_command_buffer);
+  return iree_hal_cuda_stream_command_buffer_fork_streams(command_buffer);
 }
 
 static iree_status_t iree_hal_cuda_stream_command_buffer_end(
     iree_hal_command_buffer_t* base_command_buffer) {
-  return iree_ok_status();
+  iree_hal_cuda_stream_command_buffer_t* command_buffer =
+      iree_hal_cuda_stream_command_buffer_cast(base_command_buffer);
+  // Anything waiting on the command buffer waits on the primary stream.
+  return iree_hal_cuda_stream_command_buffer_join_streams(command_buffer);
 }
 
 static iree_status_t iree_hal_cuda_stream_command_buffer_execution_barrier(
@@ -115,8 +194,11 @@ static iree_status_t iree_hal_cuda_stream_command_buffer_execution_barrier(
     const iree_hal_memory_barrier_t* memory_barriers,
     iree_host_size_t buffer_barrier_count,
     const iree_hal_buffer_barrier_t* buffer_barriers) {
-  // TODO(jinchen62): implement CUDA barrier
-  return iree_ok_status();
+  iree_hal_cuda_stream_command_buffer_t* command_buffer =
+      iree_hal_cuda_stream_command_buffer_cast(base_command_buffer);
+  IREE_RETURN_IF_ERROR(
+      iree_hal_cuda_stream_command_buffer_join_streams(command_buffer));
+  return iree_hal_cuda_stream_command_buffer_fork_streams(command_buffer);
 }
 
 static iree_status_t iree_hal_cuda_stream_command_buffer_signal_event(
@@ -142,8 +224,13 @@ static iree_status_t iree_hal_cuda_stream_command_buffer_wait_events(
     const iree_hal_memory_barrier_t* memory_barriers,
     iree_host_size_t buffer_barrier_count,
     const iree_hal_buffer_barrier_t* buffer_barriers) {
-  // TODO(jinchen62): implement CUDA barrier
-  return iree_ok_status();
+  // TODO(jinchen62): implement CUDA events. Until then waits conservatively
+  // order all prior commands before all subsequent ones.
+  iree_hal_cuda_stream_command_buffer_t* command_buffer =
+      iree_hal_cuda_stream_command_buffer_cast(base_command_buffer);
+  IREE_RETURN_IF_ERROR(
+      iree_hal_cuda_stream_command_buffer_join_streams(command_buffer));
+  return iree_hal_cuda_stream_command_buffer_fork_streams(command_buffer);
 }
 
 static iree_status_t iree_hal_cuda_stream_command_buffer_discard_buffer(
@@ -165,12 +252,16 @@ static iree_status_t iree_hal_cuda_stream_command_buffer_fill_buffer(
   target_offset += iree_hal_buffer_byte_offset(target_buffer);
   CUdeviceptr dst = target_device_buffer + target_offset;
   size_t num_elements = length / pattern_length;
+  CUstream stream = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_hal_cuda_stream_command_buffer_acquire_stream(command_buffer,
+                                                         &stream));
   switch (pattern_length) {
     case 4: {
       CUDA_RETURN_IF_ERROR(
           command_buffer->context->syms,
           cuMemsetD32Async(dst, *(const uint32_t*)(pattern), num_elements,
-                           command_buffer->stream),
+                           stream),
           "cuMemsetD32Async");
       break;
     }
@@ -178,7 +269,7 @@ static iree_status_t iree_hal_cuda_stream_command_buffer_fill_buffer(
       CUDA_RETURN_IF_ERROR(
           command_buffer->context->syms,
           cuMemsetD16Async(dst, *(const uint16_t*)(pattern), num_elements,
-                           command_buffer->stream),
+                           stream),
           "cuMemsetD16Async");
       break;
     }
@@ -186,7 +277,7 @@ static iree_status_t iree_hal_cuda_stream_command_buffer_fill_buffer(
       CUDA_RETURN_IF_ERROR(
           command_buffer->context->syms,
           cuMemsetD8Async(dst, *(const uint8_t*)(pattern), num_elements,
-                          command_buffer->stream),
+                          stream),
           "cuMemsetD8Async");
       break;
     }
@@ -221,9 +312,28 @@ static iree_status_t iree_hal_cuda_stream_command_buffer_copy_buffer(
   source_offset += iree_hal_buffer_byte_offset(source_buffer);
   CUdeviceptr dst = target_device_buffer + target_offset;
   CUdeviceptr src = source_device_buffer + source_offset;
-  CUDA_RETURN_IF_ERROR(command_buffer->context->syms,
-                       cuMemcpyAsync(dst, src, length, command_buffer->stream),
-                       "cuMemcpyAsync");
+  CUstream stream = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_hal_cuda_stream_command_buffer_acquire_stream(command_buffer,
+                                                         &stream));
+
+  // Copies between buffers owned by different devices are issued as peer
+  // copies over the device interconnect (when peer access is enabled) instead
+  // of being staged by the driver through host memory.
+  CUcontext target_context = iree_hal_cuda_buffer_context(
+      iree_hal_buffer_allocated_buffer(target_buffer));
+  CUcontext source_context = iree_hal_cuda_buffer_context(
+      iree_hal_buffer_allocated_buffer(source_buffer));
+  if (target_context && source_context && target_context != source_context) {
+    CUDA_RETURN_IF_ERROR(command_buffer->context->syms,
+                         cuMemcpyPeerAsync(dst, target_context, src,
+                                           source_context, length, stream),
+                         "cuMemcpyPeerAsync");
+  } else {
+    CUDA_RETURN_IF_ERROR(command_buffer->context->syms,
+                         cuMemcpyAsync(dst, src, length, stream),
+                         "cuMemcpyAsync");
+  }
   return iree_ok_status();
 }
 
@@ -285,8 +395,7 @@ static iree_status_t iree_hal_cuda_stream_command_buffer_push_descriptor_set(
         iree_hal_cuda_buffer_device_pointer(
             iree_hal_buffer_allocated_buffer(binding.buffer)) +
         iree_hal_buffer_byte_offset(binding.buffer) + binding.offset;
-    *((CUdeviceptr*)command_buffer->current_descriptor[i + base_binding]) =
-        device_ptr;
+    command_buffer->kernel_args[i + base_binding] = device_ptr;
   }
   return iree_ok_status();
 }
@@ -309,28 +418,48 @@ static iree_status_t iree_hal_cuda_stream_command_buffer_dispatch(
       iree_hal_cuda_stream_command_buffer_cast(base_command_buffer);
   iree_hal_executable_layout_t* layout =
       iree_hal_cuda_executable_get_layout(executable, entry_point);
-  iree_host_size_t num_constants =
-      iree_hal_cuda_executable_layout_num_constants(layout);
-  iree_host_size_t constant_base_index =
-      iree_hal_cuda_push_constant_index(layout);
-  // Patch the push constants in the kernel arguments.
-  for (iree_host_size_t i = 0; i < num_constants; i++) {
-    *((uint32_t*)command_buffer->current_descriptor[i + constant_base_index]) =
-        command_buffer->push_constant[i];
-  }
+  // Copy the push constants into place after the bindings.
+  memcpy((uint8_t*)command_buffer->kernel_args +
+             iree_hal_cuda_executable_layout_push_constant_offset(layout),
+         command_buffer->push_constant,
+         iree_hal_cuda_executable_layout_num_constants(layout) *
+             sizeof(int32_t));
+  size_t kernel_args_size =
+      iree_hal_cuda_executable_layout_kernel_args_size(layout);
+  void* extra[] = {
+      CU_LAUNCH_PARAM_BUFFER_POINTER, command_buffer->kernel_args,
+      CU_LAUNCH_PARAM_BUFFER_SIZE,    &kernel_args_size,
+      CU_LAUNCH_PARAM_END,
+  };
 
   int32_t block_size_x, block_size_y, block_size_z;
   IREE_RETURN_IF_ERROR(iree_hal_cuda_native_executable_block_size(
       executable, entry_point, &block_size_x, &block_size_y, &block_size_z));
-  CUfunction func =
-      iree_hal_cuda_native_executable_for_entry_point(executable, entry_point);
-  CUDA_RETURN_IF_ERROR(
+  CUfunction func = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_cuda_native_executable_for_entry_point(
+      executable, entry_point, &func));
+  CUstream stream = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_hal_cuda_stream_command_buffer_acquire_stream(command_buffer,
+                                                         &stream));
+  const uint32_t workgroup_count[3] = {workgroup_x, workgroup_y, workgroup_z};
+  uint32_t profile_slot = iree_hal_cuda_dispatch_profiler_record_begin(
+      command_buffer->profiler, stream, executable, entry_point,
+      workgroup_count);
+  iree_status_t status = CU_RESULT_TO_STATUS(
       command_buffer->context->syms,
       cuLaunchKernel(func, workgroup_x, workgroup_y, workgroup_z, block_size_x,
-                     block_size_y, block_size_z, 0, command_buffer->stream,
-                     command_buffer->current_descriptor, NULL),
+                     block_size_y, block_size_z, 0, stream,
+                     /*kernelParams=*/NULL, kernel_args_size ? extra : NULL),
       "cuLaunchKernel");
-  return iree_ok_status();
+  if (iree_status_is_ok(status)) {
+    iree_hal_cuda_dispatch_profiler_record_end(command_buffer->profiler,
+                                               stream, profile_slot);
+  } else {
+    iree_hal_cuda_dispatch_profiler_record_abort(command_buffer->profiler,
+                                                 profile_slot);
+  }
+  return status;
 }
 
 static iree_status_t iree_hal_cuda_stream_command_buffer_dispatch_indirect(
@@ -338,8 +467,48 @@ static iree_status_t iree_hal_cuda_stream_command_buffer_dispatch_indirect(
     iree_hal_executable_t* executable, int32_t entry_point,
     iree_hal_buffer_t* workgroups_buffer,
     iree_device_size_t workgroups_offset) {
-  return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
-                          "need cuda implementation of dispatch indirect");
+  iree_hal_cuda_stream_command_buffer_t* command_buffer =
+      iree_hal_cuda_stream_command_buffer_cast(base_command_buffer);
+
+  // CUDA has no indirect launch so the workgroup count has to be known on the
+  // host when the kernel is issued. Commands are issued as they are recorded
+  // and we only need to wait for the work issued so far (which includes
+  // whatever produced the workgroup count) before reading it back.
+  IREE_RETURN_IF_ERROR(
+      iree_hal_cuda_stream_command_buffer_join_streams(command_buffer));
+  IREE_RETURN_IF_ERROR(
+      iree_hal_cuda_stream_command_buffer_fork_streams(command_buffer));
+  CUDA_RETURN_IF_ERROR(
+      command_buffer->context->syms,
+      cuStreamSynchronize(command_buffer->stream_pool->streams[0]),
+      "cuStreamSynchronize");
+
+  uint32_t workgroup_count[3] = {0, 0, 0};
+  iree_hal_buffer_t* allocated_buffer =
+      iree_hal_buffer_allocated_buffer(workgroups_buffer);
+  workgroups_offset += iree_hal_buffer_byte_offset(workgroups_buffer);
+  uint8_t* host_ptr =
+      (uint8_t*)iree_hal_cuda_buffer_host_pointer(allocated_buffer);
+  if (host_ptr) {
+    memcpy(workgroup_count, host_ptr + workgroups_offset,
+           sizeof(workgroup_count));
+  } else {
+    CUdeviceptr device_ptr =
+        iree_hal_cuda_buffer_device_pointer(allocated_buffer) +
+        workgroups_offset;
+    CUDA_RETURN_IF_ERROR(
+        command_buffer->context->syms,
+        cuMemcpyDtoH(workgroup_count, device_ptr, sizeof(workgroup_count)),
+        "cuMemcpyDtoH");
+  }
+
+  // Zero-sized dispatches are valid in HAL but rejected by cuLaunchKernel.
+  if (!workgroup_count[0] || !workgroup_count[1] || !workgroup_count[2]) {
+    return iree_ok_status();
+  }
+  return iree_hal_cuda_stream_command_buffer_dispatch(
+      base_command_buffer, executable, entry_point, workgroup_count[0],
+      workgroup_count[1], workgroup_count[2]);
 }
 
 static const iree_hal_command_buffer_vtable_t
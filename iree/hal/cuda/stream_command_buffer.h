@@ -11,21 +11,30 @@
 #include "iree/hal/api.h"
 #include "iree/hal/cuda/context_wrapper.h"
 #include "iree/hal/cuda/cuda_headers.h"
+#include "iree/hal/cuda/dispatch_profiler.h"
 #include "iree/hal/cuda/dynamic_symbols.h"
+#include "iree/hal/cuda/stream_pool.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif  // __cplusplus
 
 // Creates a cuda stream command buffer that immediately
-// issues commands against the given |stream|.
-// Access to |stream| must be synchronized by the user.
+// issues commands against the streams in |stream_pool|.
+// Commands between execution barriers are distributed across the streams and
+// all work is joined into the primary stream by each barrier and on end.
+// Access to |stream_pool| must be synchronized by the user.
 // Used for replaying commands in special situations and
 // never returned to a user from the device_create_command_buffer
+//
+// Dispatches are timed by |profiler| when it is active. The |profiler| is
+// optional and must outlive the command buffer if provided.
 iree_status_t iree_hal_cuda_stream_command_buffer_create(
     iree_hal_device_t *device, iree_hal_cuda_context_wrapper_t *context,
     iree_hal_command_buffer_mode_t mode,
-    iree_hal_command_category_t command_categories, CUstream stream,
+    iree_hal_command_category_t command_categories,
+    iree_hal_cuda_stream_pool_t *stream_pool,
+    iree_hal_cuda_dispatch_profiler_t *profiler,
     iree_hal_command_buffer_t **out_command_buffer);
 
 // Returns true if |command_buffer| is a CUDA stream-based command buffer.
@@ -0,0 +1,77 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/cuda/stream_pool.h"
+
+#include <string.h>
+
+#include "iree/base/tracing.h"
+#include "iree/hal/cuda/dynamic_symbols.h"
+#include "iree/hal/cuda/status_util.h"
+
+iree_status_t iree_hal_cuda_stream_pool_initialize(
+    iree_hal_cuda_context_wrapper_t* context, CUstream primary_stream,
+    iree_host_size_t count, iree_hal_cuda_stream_pool_t* out_pool) {
+  IREE_ASSERT_ARGUMENT(context);
+  IREE_ASSERT_ARGUMENT(out_pool);
+  memset(out_pool, 0, sizeof(*out_pool));
+  if (count == 0 || count > IREE_HAL_CUDA_MAX_CONCURRENT_STREAM_COUNT) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "concurrent stream count %zu outside of [1, %d]",
+                            count, IREE_HAL_CUDA_MAX_CONCURRENT_STREAM_COUNT);
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+  out_pool->context = context;
+  out_pool->streams[0] = primary_stream;
+
+  // A single stream needs no synchronization and everything is issued in order
+  // on the primary stream.
+  iree_status_t status = iree_ok_status();
+  if (count > 1) {
+    status = CU_RESULT_TO_STATUS(
+        context->syms,
+        cuEventCreate(&out_pool->events[0], CU_EVENT_DISABLE_TIMING),
+        "cuEventCreate");
+  }
+  out_pool->count = 1;
+  for (iree_host_size_t i = 1; i < count && iree_status_is_ok(status); ++i) {
+    status = CU_RESULT_TO_STATUS(
+        context->syms,
+        cuStreamCreate(&out_pool->streams[i], CU_STREAM_NON_BLOCKING),
+        "cuStreamCreate");
+    if (iree_status_is_ok(status)) {
+      status = CU_RESULT_TO_STATUS(
+          context->syms,
+          cuEventCreate(&out_pool->events[i], CU_EVENT_DISABLE_TIMING),
+          "cuEventCreate");
+      if (!iree_status_is_ok(status)) {
+        CUDA_IGNORE_ERROR(context->syms,
+                          cuStreamDestroy(out_pool->streams[i]));
+      }
+    }
+    if (iree_status_is_ok(status)) out_pool->count = i + 1;
+  }
+
+  if (!iree_status_is_ok(status)) {
+    iree_hal_cuda_stream_pool_deinitialize(out_pool);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+void iree_hal_cuda_stream_pool_deinitialize(iree_hal_cuda_stream_pool_t* pool) {
+  if (!pool->context) return;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  for (iree_host_size_t i = 1; i < pool->count; ++i) {
+    CUDA_IGNORE_ERROR(pool->context->syms, cuEventDestroy(pool->events[i]));
+    CUDA_IGNORE_ERROR(pool->context->syms, cuStreamDestroy(pool->streams[i]));
+  }
+  if (pool->events[0]) {
+    CUDA_IGNORE_ERROR(pool->context->syms, cuEventDestroy(pool->events[0]));
+  }
+  memset(pool, 0, sizeof(*pool));
+  IREE_TRACE_ZONE_END(z0);
+}
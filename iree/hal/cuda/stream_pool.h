@@ -0,0 +1,47 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_CUDA_STREAM_POOL_H_
+#define IREE_HAL_CUDA_STREAM_POOL_H_
+
+#include "iree/base/api.h"
+#include "iree/hal/cuda/context_wrapper.h"
+#include "iree/hal/cuda/cuda_headers.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Maximum number of streams commands may be distributed across.
+#define IREE_HAL_CUDA_MAX_CONCURRENT_STREAM_COUNT 16
+
+// A fixed set of CUDA streams that independent commands are issued across.
+// |streams[0]| is the primary stream owned by the device: work on the other
+// streams forks from it and joins back into it with events such that waiting
+// on the primary stream waits for all work issued to the pool.
+typedef struct iree_hal_cuda_stream_pool_t {
+  iree_hal_cuda_context_wrapper_t* context;
+  iree_host_size_t count;
+  CUstream streams[IREE_HAL_CUDA_MAX_CONCURRENT_STREAM_COUNT];
+  // |events[i]| is recorded on |streams[i]| when other streams need to wait on
+  // the work issued to it so far.
+  CUevent events[IREE_HAL_CUDA_MAX_CONCURRENT_STREAM_COUNT];
+} iree_hal_cuda_stream_pool_t;
+
+// Initializes |out_pool| with |primary_stream| and |count| - 1 new streams.
+// |primary_stream| is not owned by the pool and must outlive it.
+iree_status_t iree_hal_cuda_stream_pool_initialize(
+    iree_hal_cuda_context_wrapper_t* context, CUstream primary_stream,
+    iree_host_size_t count, iree_hal_cuda_stream_pool_t* out_pool);
+
+// Destroys all streams and events created by the pool.
+void iree_hal_cuda_stream_pool_deinitialize(iree_hal_cuda_stream_pool_t* pool);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_CUDA_STREAM_POOL_H_
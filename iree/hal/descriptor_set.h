@@ -39,10 +39,16 @@ typedef struct iree_hal_descriptor_set_binding_t {
   // The binding number of this entry and corresponds to a resource of the
   // same binding number in the executable interface.
   uint32_t binding;
+  // Slot in the binding table provided at submission that is bound when
+  // |buffer| is NULL and the command buffer was created with
+  // IREE_HAL_COMMAND_BUFFER_MODE_INDIRECT_BINDINGS. Ignored otherwise.
+  uint32_t buffer_slot;
   // Buffer bound to the binding number.
-  // May be NULL if the binding is not used by the executable.
+  // May be NULL if the binding is not used by the executable or if it
+  // references |buffer_slot| in the submission binding table.
   iree_hal_buffer_t* buffer;
-  // Offset, in bytes, into the buffer that the binding starts at.
+  // Offset, in bytes, into the buffer (or binding table slot range) that the
+  // binding starts at.
   // If the descriptor type is dynamic this will be added to the dynamic
   // offset provided during binding.
   iree_device_size_t offset;
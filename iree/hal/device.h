@@ -142,6 +142,11 @@ typedef struct iree_hal_submission_batch_t {
 
   // Semaphores to signal once all command buffers have completed execution.
   iree_hal_semaphore_list_t signal_semaphores;
+
+  // Buffer ranges referenced by command buffers in the batch that were
+  // recorded with IREE_HAL_COMMAND_BUFFER_MODE_INDIRECT_BINDINGS.
+  // May be empty if no command buffer uses indirect bindings.
+  iree_hal_buffer_binding_table_t binding_table;
 } iree_hal_submission_batch_t;
 
 // Defines how a multi-wait operation treats the results of multiple semaphores.
@@ -282,6 +287,39 @@ IREE_API_EXPORT iree_status_t iree_hal_device_transfer_and_wait(
     const iree_hal_transfer_command_t* transfer_commands,
     iree_timeout_t timeout);
 
+// Allocates a transient buffer in queue order.
+//
+// The returned |out_buffer| is available immediately but its contents are
+// undefined and it must not be used by the device until all
+// |signal_semaphore_list| semaphores have been signaled. The allocation is
+// made only after all |wait_semaphore_list| semaphores have been signaled such
+// that backends with stream-ordered allocators can reuse memory released by
+// prior queue work. Backends without queue-ordered allocation may allocate
+// immediately and only order the signal.
+//
+// The buffer lifetime is still managed by reference counting. Pair with
+// iree_hal_device_queue_dealloca to return the memory to the device in queue
+// order once all users of the buffer have completed.
+IREE_API_EXPORT iree_status_t iree_hal_device_queue_alloca(
+    iree_hal_device_t* device, iree_hal_queue_affinity_t queue_affinity,
+    const iree_hal_semaphore_list_t wait_semaphore_list,
+    const iree_hal_semaphore_list_t signal_semaphore_list,
+    iree_hal_memory_type_t memory_type, iree_hal_buffer_usage_t allowed_usage,
+    iree_device_size_t allocation_size, iree_hal_buffer_t** out_buffer);
+
+// Deallocates a buffer in queue order.
+//
+// |buffer| is released by the queue once all |wait_semaphore_list| semaphores
+// have been signaled and then all |signal_semaphore_list| semaphores are
+// signaled. The device retains |buffer| until then and callers may release
+// their reference immediately after this returns. The contents of the buffer
+// are undefined after the wait semaphores are reached.
+IREE_API_EXPORT iree_status_t iree_hal_device_queue_dealloca(
+    iree_hal_device_t* device, iree_hal_queue_affinity_t queue_affinity,
+    const iree_hal_semaphore_list_t wait_semaphore_list,
+    const iree_hal_semaphore_list_t signal_semaphore_list,
+    iree_hal_buffer_t* buffer);
+
 // Submits one or more batches of work to a device queue.
 //
 // The queue is selected based on the flags set in |command_categories| and the
@@ -354,6 +392,87 @@ IREE_API_EXPORT iree_status_t iree_hal_device_wait_semaphores(
 IREE_API_EXPORT iree_status_t
 iree_hal_device_wait_idle(iree_hal_device_t* device, iree_timeout_t timeout);
 
+//===----------------------------------------------------------------------===//
+// iree_hal_device_t profiling
+//===----------------------------------------------------------------------===//
+
+// Bitfield specifying what is captured while a device is profiling.
+enum iree_hal_device_profiling_mode_bits_t {
+  IREE_HAL_DEVICE_PROFILING_MODE_NONE = 0u,
+  // Captures the execution begin and end timestamps of each dispatch.
+  IREE_HAL_DEVICE_PROFILING_MODE_DISPATCH_TIMESTAMPS = 1u << 0,
+  // Captures pipeline statistics of each dispatch such as the number of
+  // invocations executed. Only available on devices that can query them.
+  IREE_HAL_DEVICE_PROFILING_MODE_DISPATCH_STATISTICS = 1u << 1,
+};
+typedef uint32_t iree_hal_device_profiling_mode_t;
+
+// A dispatch that completed execution while the device was profiling.
+typedef struct iree_hal_device_profiling_dispatch_t {
+  // Name of the executable entry point dispatched or empty if the executable
+  // has no names available. Only valid for the duration of the sink callback.
+  iree_string_view_t entry_point_name;
+  // Ordinal of the entry point within its executable.
+  uint32_t entry_point;
+  // XYZ workgroup count the dispatch executed with.
+  uint32_t workgroup_count[3];
+  // Timestamps in nanoseconds of when the dispatch began and ended execution.
+  // Only the differences between timestamps from the same device are
+  // meaningful.
+  iree_time_t begin_time_ns;
+  iree_time_t end_time_ns;
+  // Total number of invocations (workgroup count times workgroup size) the
+  // dispatch executed if IREE_HAL_DEVICE_PROFILING_MODE_DISPATCH_STATISTICS
+  // was captured and otherwise 0.
+  uint64_t invocation_count;
+} iree_hal_device_profiling_dispatch_t;
+
+// Receives captured dispatches when a profiling device is flushed.
+// |dropped_count| is the number of dispatches that completed since the prior
+// flush but were not captured as the record buffer was full.
+typedef struct iree_hal_device_profiling_sink_t {
+  iree_status_t(IREE_API_PTR* fn)(
+      void* user_data, iree_host_size_t dispatch_count,
+      const iree_hal_device_profiling_dispatch_t* dispatches,
+      iree_host_size_t dropped_count);
+  void* user_data;
+} iree_hal_device_profiling_sink_t;
+
+// Controls device profiling.
+typedef struct iree_hal_device_profiling_options_t {
+  // What is captured while profiling.
+  iree_hal_device_profiling_mode_t mode;
+  // Maximum number of dispatches buffered between flushes or 0 to use the
+  // device default. Dispatches completing while the buffer is full are dropped.
+  iree_host_size_t dispatch_capacity;
+  // Receives the captured dispatches on each flush.
+  iree_hal_device_profiling_sink_t sink;
+} iree_hal_device_profiling_options_t;
+
+// Begins capturing profiling information as specified by |options|.
+// Profiling is designed to be cheap enough to leave enabled on a sampled
+// subset of production traffic: dispatches are appended into a fixed-capacity
+// record buffer and no device synchronization is performed beyond what the
+// timestamps themselves require.
+//
+// Only work that completes after this call returns is captured. Returns
+// IREE_STATUS_FAILED_PRECONDITION if the device is already profiling and
+// IREE_STATUS_UNIMPLEMENTED if the device does not support the requested mode.
+IREE_API_EXPORT iree_status_t iree_hal_device_profiling_begin(
+    iree_hal_device_t* device,
+    const iree_hal_device_profiling_options_t* options);
+
+// Delivers all dispatches captured since the prior flush to the sink provided
+// to iree_hal_device_profiling_begin. Work that has not yet completed is not
+// included and will be delivered by a future flush.
+IREE_API_EXPORT iree_status_t
+iree_hal_device_profiling_flush(iree_hal_device_t* device);
+
+// Ends profiling after flushing all captured dispatches to the sink.
+// Work still executing when this is called may not be captured.
+IREE_API_EXPORT iree_status_t
+iree_hal_device_profiling_end(iree_hal_device_t* device);
+
 //===----------------------------------------------------------------------===//
 // iree_hal_device_t implementation details
 //===----------------------------------------------------------------------===//
@@ -416,6 +535,19 @@ typedef struct iree_hal_device_vtable_t {
       iree_device_size_t target_offset, iree_device_size_t data_length,
       iree_hal_transfer_buffer_flags_t flags, iree_timeout_t timeout);
 
+  iree_status_t(IREE_API_PTR* queue_alloca)(
+      iree_hal_device_t* device, iree_hal_queue_affinity_t queue_affinity,
+      const iree_hal_semaphore_list_t wait_semaphore_list,
+      const iree_hal_semaphore_list_t signal_semaphore_list,
+      iree_hal_memory_type_t memory_type, iree_hal_buffer_usage_t allowed_usage,
+      iree_device_size_t allocation_size, iree_hal_buffer_t** out_buffer);
+
+  iree_status_t(IREE_API_PTR* queue_dealloca)(
+      iree_hal_device_t* device, iree_hal_queue_affinity_t queue_affinity,
+      const iree_hal_semaphore_list_t wait_semaphore_list,
+      const iree_hal_semaphore_list_t signal_semaphore_list,
+      iree_hal_buffer_t* buffer);
+
   iree_status_t(IREE_API_PTR* queue_submit)(
       iree_hal_device_t* device, iree_hal_command_category_t command_categories,
       iree_hal_queue_affinity_t queue_affinity, iree_host_size_t batch_count,
@@ -434,6 +566,14 @@ typedef struct iree_hal_device_vtable_t {
 
   iree_status_t(IREE_API_PTR* wait_idle)(iree_hal_device_t* device,
                                          iree_timeout_t timeout);
+
+  iree_status_t(IREE_API_PTR* profiling_begin)(
+      iree_hal_device_t* device,
+      const iree_hal_device_profiling_options_t* options);
+
+  iree_status_t(IREE_API_PTR* profiling_flush)(iree_hal_device_t* device);
+
+  iree_status_t(IREE_API_PTR* profiling_end)(iree_hal_device_t* device);
 } iree_hal_device_vtable_t;
 IREE_HAL_ASSERT_VTABLE_LAYOUT(iree_hal_device_vtable_t);
 
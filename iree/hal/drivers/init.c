@@ -36,6 +36,10 @@
 #include "experimental/rocm/registration/driver_module.h"
 #endif  // IREE_HAL_HAVE_EXPERIMENTAL_ROCM_DRIVER_MODULE
 
+#if defined(IREE_HAL_HAVE_EXPERIMENTAL_METAL_DRIVER_MODULE)
+#include "experimental/metal/registration/driver_module.h"
+#endif  // IREE_HAL_HAVE_EXPERIMENTAL_METAL_DRIVER_MODULE
+
 IREE_API_EXPORT iree_status_t
 iree_hal_register_all_available_drivers(iree_hal_driver_registry_t* registry) {
   IREE_TRACE_ZONE_BEGIN(z0);
@@ -75,6 +79,11 @@ iree_hal_register_all_available_drivers(iree_hal_driver_registry_t* registry) {
       z0, iree_hal_rocm_driver_module_register(registry));
 #endif  // IREE_HAL_HAVE_EXPERIMENTAL_ROCM_DRIVER_MODULE
 
+#if defined(IREE_HAL_HAVE_EXPERIMENTAL_METAL_DRIVER_MODULE)
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_metal_driver_module_register(registry));
+#endif  // IREE_HAL_HAVE_EXPERIMENTAL_METAL_DRIVER_MODULE
+
   IREE_TRACE_ZONE_END(z0);
   return iree_ok_status();
 }
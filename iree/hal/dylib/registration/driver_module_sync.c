@@ -10,6 +10,7 @@
 #include <stddef.h>
 
 #include "iree/base/api.h"
+#include "iree/hal/local/builtin_imports.h"
 #include "iree/hal/local/executable_loader.h"
 #include "iree/hal/local/loaders/embedded_library_loader.h"
 #include "iree/hal/local/sync_device.h"
@@ -53,7 +54,7 @@ static iree_status_t iree_hal_dylib_sync_driver_factory_try_create(
   iree_hal_executable_loader_t* loaders[1] = {NULL};
   if (iree_status_is_ok(status)) {
     status = iree_hal_embedded_library_loader_create(
-        iree_hal_executable_import_provider_null(), host_allocator,
+        iree_hal_builtin_import_provider(), host_allocator,
         &loaders[0]);
   }
 
@@ -0,0 +1,40 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/local/builtin_imports.h"
+
+#include "iree/builtins/mmt4d/mmt4d.h"
+#include "iree/hal/local/executable_environment.h"
+
+static iree_status_t iree_hal_builtin_import_provider_resolve(
+    void* self, iree_string_view_t symbol_name, void** out_fn_ptr) {
+  *out_fn_ptr = NULL;
+
+  iree_hal_processor_v0_t processor;
+  iree_hal_processor_query(&processor);
+
+  if (iree_string_view_starts_with(symbol_name,
+                                   iree_make_cstring_view("iree_mmt4d_"))) {
+    iree_mmt4d_kernel_fn_t fn =
+        iree_mmt4d_kernel_lookup(symbol_name, processor.data[0]);
+    if (fn) {
+      *out_fn_ptr = (void*)fn;
+      return iree_ok_status();
+    }
+  }
+
+  return iree_make_status(IREE_STATUS_NOT_FOUND,
+                          "no builtin import named '%.*s'",
+                          (int)symbol_name.size, symbol_name.data);
+}
+
+iree_hal_executable_import_provider_t iree_hal_builtin_import_provider(void) {
+  iree_hal_executable_import_provider_t provider = {
+      .self = NULL,
+      .resolve = iree_hal_builtin_import_provider_resolve,
+  };
+  return provider;
+}
@@ -0,0 +1,29 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_LOCAL_BUILTIN_IMPORTS_H_
+#define IREE_HAL_LOCAL_BUILTIN_IMPORTS_H_
+
+#include "iree/base/api.h"
+#include "iree/hal/local/executable_loader.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Returns an import provider resolving the builtin functions that executables
+// compiled by IREE may import, such as the mmt4d microkernels in
+// iree/builtins/mmt4d/. The implementation of each import is selected for the
+// processor of the hosting process when it is resolved.
+//
+// The provider is stateless and may be shared by any number of loaders.
+iree_hal_executable_import_provider_t iree_hal_builtin_import_provider(void);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_LOCAL_BUILTIN_IMPORTS_H_
@@ -9,6 +9,8 @@
 #include <inttypes.h>
 #include <string.h>
 
+#include "iree/base/internal/call_once.h"
+#include "iree/base/internal/synchronization.h"
 #include "iree/base/target_platform.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/local/elf/arch.h"
@@ -502,6 +504,234 @@ static iree_status_t iree_elf_module_apply_relocations(
   return iree_elf_arch_apply_relocations(&reloc_state);
 }
 
+//==============================================================================
+// Shared segment images
+//==============================================================================
+
+// Pages of read-only segments shared by all modules in the process loaded from
+// the same ELF data. Images are reference counted by the modules mapping them.
+typedef struct iree_elf_shared_image_t {
+  struct iree_elf_shared_image_t* next;
+  // Number of modules that mapped pages of the image; guarded by the registry
+  // mutex.
+  iree_host_size_t ref_count;
+  // Identifies the ELF data the image was produced from.
+  uint64_t data_hash;
+  iree_host_size_t data_length;
+  iree_host_size_t vaddr_size;
+  // Segment pages at the same offsets as they are in the module vaddr range.
+  iree_memory_shared_object_t* object;
+} iree_elf_shared_image_t;
+
+// Process-wide list of live shared images. Images outlive the modules that
+// created them and as such are allocated from the system allocator.
+typedef struct iree_elf_shared_image_registry_t {
+  iree_slim_mutex_t mutex;
+  iree_elf_shared_image_t* image_head;
+} iree_elf_shared_image_registry_t;
+
+static iree_elf_shared_image_registry_t iree_elf_shared_image_registry_;
+static iree_once_flag iree_elf_shared_image_registry_flag_ =
+    IREE_ONCE_FLAG_INIT;
+static void iree_elf_shared_image_registry_initialize(void) {
+  memset(&iree_elf_shared_image_registry_, 0,
+         sizeof(iree_elf_shared_image_registry_));
+  iree_slim_mutex_initialize(&iree_elf_shared_image_registry_.mutex);
+}
+
+static iree_elf_shared_image_registry_t* iree_elf_shared_image_registry(void) {
+  iree_call_once(&iree_elf_shared_image_registry_flag_,
+                 iree_elf_shared_image_registry_initialize);
+  return &iree_elf_shared_image_registry_;
+}
+
+// 64-bit FNV-1a; only used to find the candidate image and the contents are
+// compared before any page is shared.
+static uint64_t iree_elf_module_hash_data(iree_const_byte_span_t raw_data) {
+  uint64_t hash = 0xCBF29CE484222325ull;
+  for (iree_host_size_t i = 0; i < raw_data.data_length; ++i) {
+    hash ^= raw_data.data[i];
+    hash *= 0x100000001B3ull;
+  }
+  return hash;
+}
+
+// Calculates the host page ranges relative to vaddr_base of all PT_LOAD
+// segments without write access that do not share pages with any writable
+// segment along with the final access of each segment. Returns the number of
+// ranges written to |out_ranges| and |out_accesses|, which must have capacity
+// for one entry per phdr.
+static iree_host_size_t iree_elf_module_calculate_shareable_ranges(
+    iree_elf_module_load_state_t* load_state, iree_elf_module_t* module,
+    iree_byte_range_t* out_ranges, iree_memory_access_t* out_accesses) {
+  const iree_host_size_t page_size = load_state->memory_info.normal_page_size;
+  const iree_host_size_t bias_offset =
+      (iree_host_size_t)(module->vaddr_bias - module->vaddr_base);
+  iree_host_size_t range_count = 0;
+  for (iree_elf_half_t i = 0; i < load_state->ehdr->e_phnum; ++i) {
+    const iree_elf_phdr_t* phdr = &load_state->phdr_table[i];
+    if (phdr->p_type != IREE_ELF_PT_LOAD || phdr->p_memsz == 0) continue;
+    if (phdr->p_flags & IREE_ELF_PF_W) continue;
+    iree_host_size_t start =
+        iree_page_align_start(bias_offset + phdr->p_vaddr, page_size);
+    iree_host_size_t end = iree_page_align_end(
+        bias_offset + phdr->p_vaddr + phdr->p_memsz, page_size);
+    bool overlaps_writable = false;
+    for (iree_elf_half_t j = 0; j < load_state->ehdr->e_phnum; ++j) {
+      const iree_elf_phdr_t* other_phdr = &load_state->phdr_table[j];
+      if (other_phdr->p_type != IREE_ELF_PT_LOAD) continue;
+      if (!(other_phdr->p_flags & IREE_ELF_PF_W)) continue;
+      iree_host_size_t other_start =
+          iree_page_align_start(bias_offset + other_phdr->p_vaddr, page_size);
+      iree_host_size_t other_end = iree_page_align_end(
+          bias_offset + other_phdr->p_vaddr + other_phdr->p_memsz, page_size);
+      if (start < other_end && other_start < end) {
+        overlaps_writable = true;
+        break;
+      }
+    }
+    if (overlaps_writable) continue;
+    out_ranges[range_count].offset = start;
+    out_ranges[range_count].length = end - start;
+    out_accesses[range_count] = IREE_MEMORY_ACCESS_READ;
+    if (phdr->p_flags & IREE_ELF_PF_X) {
+      out_accesses[range_count] |= IREE_MEMORY_ACCESS_EXECUTE;
+    }
+    ++range_count;
+  }
+  return range_count;
+}
+
+// Returns the live image produced from |raw_data| or NULL if not found.
+// Must be called with the registry mutex held.
+static iree_elf_shared_image_t* iree_elf_shared_image_find_locked(
+    iree_elf_shared_image_registry_t* registry, uint64_t data_hash,
+    iree_const_byte_span_t raw_data, iree_host_size_t vaddr_size) {
+  for (iree_elf_shared_image_t* image = registry->image_head; image != NULL;
+       image = image->next) {
+    if (image->data_hash == data_hash &&
+        image->data_length == raw_data.data_length &&
+        image->vaddr_size == vaddr_size) {
+      return image;
+    }
+  }
+  return NULL;
+}
+
+// Replaces the private pages of read-only segments with pages shared with
+// other modules loaded from the same ELF. Must be called after relocations
+// have been applied: only pages that are byte-identical to the shared image
+// are replaced and as such pages written by relocation (text relocations or
+// relocations into read-only data) stay private.
+//
+// Sharing is an optimization only and failures leave the private pages in
+// place; the pages that were replaced prior to the failure are identical.
+static void iree_elf_module_share_segments(
+    iree_const_byte_span_t raw_data, iree_elf_module_load_state_t* load_state,
+    iree_elf_module_t* module) {
+  iree_host_size_t phdr_count = load_state->ehdr->e_phnum;
+  iree_byte_range_t* ranges = NULL;
+  if (!iree_status_is_ok(iree_allocator_malloc(
+          module->host_allocator,
+          phdr_count * (sizeof(*ranges) + sizeof(iree_memory_access_t)),
+          (void**)&ranges))) {
+    return;
+  }
+  iree_memory_access_t* accesses = (iree_memory_access_t*)(ranges + phdr_count);
+  iree_host_size_t range_count = iree_elf_module_calculate_shareable_ranges(
+      load_state, module, ranges, accesses);
+  if (range_count == 0) {
+    iree_allocator_free(module->host_allocator, ranges);
+    return;
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  uint64_t data_hash = iree_elf_module_hash_data(raw_data);
+  iree_elf_shared_image_registry_t* registry = iree_elf_shared_image_registry();
+  iree_slim_mutex_lock(&registry->mutex);
+
+  // Create the image from the pages of this module if this is the first load
+  // of the ELF (or all previous modules have been unloaded).
+  iree_elf_shared_image_t* image = iree_elf_shared_image_find_locked(
+      registry, data_hash, raw_data, module->vaddr_size);
+  if (!image) {
+    iree_allocator_t image_allocator = iree_allocator_system();
+    iree_status_t status = iree_allocator_malloc(
+        image_allocator, sizeof(*image), (void**)&image);
+    if (iree_status_is_ok(status)) {
+      memset(image, 0, sizeof(*image));
+      image->data_hash = data_hash;
+      image->data_length = raw_data.data_length;
+      image->vaddr_size = module->vaddr_size;
+      status = iree_memory_shared_object_create(
+          module->vaddr_base, module->vaddr_size, range_count, ranges,
+          image_allocator, &image->object);
+    }
+    if (iree_status_is_ok(status)) {
+      image->next = registry->image_head;
+      registry->image_head = image;
+    } else {
+      iree_allocator_free(image_allocator, image);
+      image = NULL;
+      IREE_IGNORE_ERROR(status);
+    }
+  }
+
+  // Map the image over each range with identical contents. The final access
+  // is applied here as some platforms restrict changing the protection of
+  // shared mappings (such as making them executable) after mapping.
+  iree_host_size_t shared_count = 0;
+  if (image) {
+    const uint8_t* contents = iree_memory_shared_object_contents(image->object);
+    for (iree_host_size_t i = 0; i < range_count; ++i) {
+      if (memcmp(module->vaddr_base + ranges[i].offset,
+                 contents + ranges[i].offset, ranges[i].length) != 0) {
+        continue;
+      }
+      iree_status_t status = iree_memory_view_map_shared_ranges(
+          module->vaddr_base, image->object, 1, &ranges[i], accesses[i]);
+      if (!iree_status_is_ok(status)) {
+        IREE_IGNORE_ERROR(status);
+        break;
+      }
+      ++shared_count;
+    }
+  }
+  if (shared_count > 0) {
+    ++image->ref_count;
+    module->shared_image = image;
+  } else if (image && image->ref_count == 0) {
+    // Newly created image that could not be mapped; drop it so that future
+    // loads don't retry with it.
+    registry->image_head = image->next;
+    iree_memory_shared_object_release(image->object);
+    iree_allocator_free(iree_allocator_system(), image);
+  }
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)shared_count);
+
+  iree_slim_mutex_unlock(&registry->mutex);
+  iree_allocator_free(module->host_allocator, ranges);
+  IREE_TRACE_ZONE_END(z0);
+}
+
+// Releases the reference |module| holds on its shared image, if any.
+// Must be called after the module pages have been unmapped.
+static void iree_elf_module_release_shared_image(iree_elf_module_t* module) {
+  iree_elf_shared_image_t* image = module->shared_image;
+  if (!image) return;
+  module->shared_image = NULL;
+  iree_elf_shared_image_registry_t* registry = iree_elf_shared_image_registry();
+  iree_slim_mutex_lock(&registry->mutex);
+  if (--image->ref_count == 0) {
+    iree_elf_shared_image_t** image_ptr = &registry->image_head;
+    while (*image_ptr != image) image_ptr = &(*image_ptr)->next;
+    *image_ptr = image->next;
+    iree_memory_shared_object_release(image->object);
+    iree_allocator_free(iree_allocator_system(), image);
+  }
+  iree_slim_mutex_unlock(&registry->mutex);
+}
+
 //==============================================================================
 // Initialization/finalization
 //==============================================================================
@@ -609,6 +839,11 @@ iree_status_t iree_elf_module_initialize_from_memory(
     status = iree_elf_module_apply_relocations(&load_state, out_module);
   }
 
+  // Share the unmodified read-only pages with other loads of the same ELF.
+  if (iree_status_is_ok(status)) {
+    iree_elf_module_share_segments(raw_data, &load_state, out_module);
+  }
+
   // Apply final protections to the loaded pages now that relocations have been
   // performed.
   if (iree_status_is_ok(status)) {
@@ -635,6 +870,7 @@ void iree_elf_module_deinitialize(iree_elf_module_t* module) {
 
   iree_elf_module_run_finalizers(module);
   iree_elf_module_unload_segments(module);
+  iree_elf_module_release_shared_image(module);
   memset(module, 0, sizeof(*module));
 
   IREE_TRACE_ZONE_END(z0);
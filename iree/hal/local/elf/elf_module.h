@@ -56,6 +56,10 @@ typedef struct iree_elf_module_t {
   // Dynamic symbol table (.dynsym).
   const iree_elf_sym_t* dynsym;   // DT_SYMTAB
   iree_host_size_t dynsym_count;  // DT_SYMENT (bytes) / sizeof(iree_elf_sym_t)
+
+  // Process-wide image of the read-only segment pages shared with other
+  // modules loaded from the same ELF, or NULL if all pages are private.
+  struct iree_elf_shared_image_t* shared_image;
 } iree_elf_module_t;
 
 // Initializes an ELF module from the ELF |raw_data| in memory.
@@ -67,6 +71,11 @@ typedef struct iree_elf_module_t {
 // system and initialization will fail if any are not present in the provided
 // table.
 //
+// Where the platform supports it the pages of read-only and executable segments
+// that are unmodified by relocation are shared with all other modules in the
+// process loaded from the same ELF. Writable segments (and any pages that had
+// relocations applied) remain private to each module.
+//
 // Upon return |out_module| is initialized and ready for use with any present
 // .init initialization functions having been executed. To release memory
 // allocated by the module during loading iree_elf_module_deinitialize must be
@@ -50,19 +50,10 @@ static iree_status_t query_arch_test_file_data(
                           "the application for the current target platform");
 }
 
-static iree_status_t run_test() {
-  iree_const_byte_span_t file_data;
-  IREE_RETURN_IF_ERROR(query_arch_test_file_data(&file_data));
-
-  iree_elf_import_table_t import_table;
-  memset(&import_table, 0, sizeof(import_table));
-  iree_elf_module_t module;
-  IREE_RETURN_IF_ERROR(iree_elf_module_initialize_from_memory(
-      file_data, &import_table, iree_allocator_system(), &module));
-
+static iree_status_t run_module(iree_elf_module_t* module) {
   void* query_fn_ptr = NULL;
   IREE_RETURN_IF_ERROR(iree_elf_module_lookup_export(
-      &module, IREE_HAL_EXECUTABLE_LIBRARY_EXPORT_NAME, &query_fn_ptr));
+      module, IREE_HAL_EXECUTABLE_LIBRARY_EXPORT_NAME, &query_fn_ptr));
 
   union {
     const iree_hal_executable_library_header_t** header;
@@ -71,7 +62,7 @@ static iree_status_t run_test() {
   library.header =
       (const iree_hal_executable_library_header_t**)iree_elf_call_p_ip(
           query_fn_ptr, IREE_HAL_EXECUTABLE_LIBRARY_LATEST_VERSION,
-          /*reserved=*/NULL);
+          /*environment=*/NULL);
   if (library.header == NULL) {
     return iree_make_status(IREE_STATUS_NOT_FOUND, "library header is empty");
   }
@@ -127,18 +118,46 @@ static iree_status_t run_test() {
                             "dispatch function returned failure: %d", ret);
   }
 
-  iree_status_t status = iree_ok_status();
   for (int i = 0; i < IREE_ARRAYSIZE(expected); ++i) {
     if (ret0[i] != expected[i]) {
-      status =
-          iree_make_status(IREE_STATUS_INTERNAL,
-                           "output mismatch: ret[%d] = %.1f, expected %.1f", i,
-                           ret0[i], expected[i]);
-      break;
+      return iree_make_status(IREE_STATUS_INTERNAL,
+                              "output mismatch: ret[%d] = %.1f, expected %.1f",
+                              i, ret0[i], expected[i]);
     }
   }
+  return iree_ok_status();
+}
 
+static iree_status_t run_test() {
+  iree_const_byte_span_t file_data;
+  IREE_RETURN_IF_ERROR(query_arch_test_file_data(&file_data));
+
+  iree_elf_import_table_t import_table;
+  memset(&import_table, 0, sizeof(import_table));
+  iree_elf_module_t module;
+  IREE_RETURN_IF_ERROR(iree_elf_module_initialize_from_memory(
+      file_data, &import_table, iree_allocator_system(), &module));
+
+  // Load a second instance of the same ELF that may share read-only pages
+  // with the first and ensure both work and that the second outlives the
+  // first.
+  iree_elf_module_t other_module;
+  iree_status_t status = iree_elf_module_initialize_from_memory(
+      file_data, &import_table, iree_allocator_system(), &other_module);
+  if (!iree_status_is_ok(status)) {
+    iree_elf_module_deinitialize(&module);
+    return status;
+  }
+
+  status = run_module(&module);
+  if (iree_status_is_ok(status)) {
+    status = run_module(&other_module);
+  }
   iree_elf_module_deinitialize(&module);
+  if (iree_status_is_ok(status)) {
+    status = run_module(&other_module);
+  }
+  iree_elf_module_deinitialize(&other_module);
   return status;
 }
 
@@ -174,4 +174,43 @@ iree_status_t iree_memory_view_protect_ranges(void* base_address,
 // executing code from any pages that have been written during load.
 void iree_memory_view_flush_icache(void* base_address, iree_host_size_t length);
 
+//==============================================================================
+// Shared memory objects
+//==============================================================================
+
+// An anonymous memory object whose pages can be mapped into multiple memory
+// views at once with all views referencing the same physical pages.
+typedef struct iree_memory_shared_object_t iree_memory_shared_object_t;
+
+// Creates a shared memory object of |total_length| bytes and initializes the
+// pages overlapping |ranges| with the contents at the same offsets from
+// |base_address|. All other pages are zeroed.
+//
+// Returns IREE_STATUS_UNAVAILABLE if the platform does not support shared
+// memory objects; callers are expected to fall back to private commits.
+//
+// Implemented by memfd_create+mmap(MAP_SHARED).
+iree_status_t iree_memory_shared_object_create(
+    const void* base_address, iree_host_size_t total_length,
+    iree_host_size_t range_count, const iree_byte_range_t* ranges,
+    iree_allocator_t allocator, iree_memory_shared_object_t** out_object);
+
+// Releases |object|. Views that have mapped the object keep their pages.
+void iree_memory_shared_object_release(iree_memory_shared_object_t* object);
+
+// Returns a read-only pointer to the contents of |object|.
+const uint8_t* iree_memory_shared_object_contents(
+    iree_memory_shared_object_t* object);
+
+// Maps the pages of |object| overlapping the byte ranges defined by |ranges|
+// into the view at |base_address| at the same offsets with |access|, replacing
+// any pages committed there. Ranges will be adjusted to the page granularity of
+// the view. On failure the pages of any ranges not yet mapped are unchanged.
+//
+// Implemented by mmap(MAP_SHARED|MAP_FIXED).
+iree_status_t iree_memory_view_map_shared_ranges(
+    void* base_address, iree_memory_shared_object_t* object,
+    iree_host_size_t range_count, const iree_byte_range_t* ranges,
+    iree_memory_access_t access);
+
 #endif  // IREE_HAL_LOCAL_ELF_PLATFORM_H_
@@ -176,4 +176,32 @@ void iree_memory_view_flush_icache(void* base_address,
   sys_icache_invalidate(base_address, length);
 }
 
+//==============================================================================
+// Shared memory objects
+//==============================================================================
+
+iree_status_t iree_memory_shared_object_create(
+    const void* base_address, iree_host_size_t total_length,
+    iree_host_size_t range_count, const iree_byte_range_t* ranges,
+    iree_allocator_t allocator, iree_memory_shared_object_t** out_object) {
+  *out_object = NULL;
+  return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                          "shared memory objects not supported");
+}
+
+void iree_memory_shared_object_release(iree_memory_shared_object_t* object) {}
+
+const uint8_t* iree_memory_shared_object_contents(
+    iree_memory_shared_object_t* object) {
+  return NULL;
+}
+
+iree_status_t iree_memory_view_map_shared_ranges(
+    void* base_address, iree_memory_shared_object_t* object,
+    iree_host_size_t range_count, const iree_byte_range_t* ranges,
+    iree_memory_access_t access) {
+  return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                          "shared memory objects not supported");
+}
+
 #endif  // IREE_PLATFORM_APPLE
@@ -12,8 +12,15 @@
 
 #include <errno.h>
 #include <sys/mman.h>
+#include <sys/syscall.h>
 #include <unistd.h>
 
+// Not all libcs expose memfd_create (added in glibc 2.27 and Android API 30)
+// so we call it through syscall when the kernel headers define it.
+#if !defined(MFD_CLOEXEC)
+#define MFD_CLOEXEC 0x0001U
+#endif  // !MFD_CLOEXEC
+
 //==============================================================================
 // Memory subsystem information and control
 //==============================================================================
@@ -161,4 +168,145 @@ void iree_memory_view_flush_icache(void* base_address,
   IREE_ELF_CLEAR_CACHE(base_address, base_address + length);
 }
 
+//==============================================================================
+// Shared memory objects
+//==============================================================================
+
+struct iree_memory_shared_object_t {
+  iree_allocator_t allocator;
+  int fd;
+  iree_host_size_t total_length;
+  // Read-only mapping of the entire object.
+  uint8_t* contents;
+};
+
+static int iree_memory_memfd_create(const char* name) {
+#if defined(SYS_memfd_create)
+  return (int)syscall(SYS_memfd_create, name, MFD_CLOEXEC);
+#else
+  errno = ENOSYS;
+  return -1;
+#endif  // SYS_memfd_create
+}
+
+iree_status_t iree_memory_shared_object_create(
+    const void* base_address, iree_host_size_t total_length,
+    iree_host_size_t range_count, const iree_byte_range_t* ranges,
+    iree_allocator_t allocator, iree_memory_shared_object_t** out_object) {
+  *out_object = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_memory_shared_object_t* object = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(allocator, sizeof(*object), (void**)&object));
+  object->allocator = allocator;
+  object->total_length = total_length;
+  object->contents = NULL;
+
+  iree_status_t status = iree_ok_status();
+  object->fd = iree_memory_memfd_create("iree-shared-object");
+  if (object->fd < 0) {
+    status = iree_make_status(IREE_STATUS_UNAVAILABLE,
+                              "memfd_create failed (%d)", errno);
+  } else if (ftruncate(object->fd, (off_t)total_length) != 0) {
+    status = iree_make_status(iree_status_code_from_errno(errno),
+                              "shared object resize failed");
+  }
+
+  // Populate the pages through a temporary writable mapping and then drop
+  // write access so that the contents can't be modified through this process.
+  uint8_t* contents = NULL;
+  if (iree_status_is_ok(status)) {
+    contents = (uint8_t*)mmap(NULL, total_length, PROT_READ | PROT_WRITE,
+                              MAP_SHARED, object->fd, 0);
+    if (contents == MAP_FAILED) {
+      contents = NULL;
+      status = iree_make_status(iree_status_code_from_errno(errno),
+                                "shared object mmap failed");
+    }
+  }
+  if (iree_status_is_ok(status)) {
+    object->contents = contents;
+    for (iree_host_size_t i = 0; i < range_count; ++i) {
+      void* range_start = NULL;
+      iree_host_size_t aligned_length = 0;
+      iree_page_align_range((void*)base_address, ranges[i], getpagesize(),
+                            &range_start, &aligned_length);
+      iree_host_size_t offset =
+          (iree_host_size_t)((uint8_t*)range_start - (uint8_t*)base_address);
+      memcpy(contents + offset, range_start, aligned_length);
+    }
+    if (mprotect(contents, total_length, PROT_READ) != 0) {
+      status = iree_make_status(iree_status_code_from_errno(errno),
+                                "mprotect failed");
+    }
+  }
+
+  if (iree_status_is_ok(status)) {
+    *out_object = object;
+  } else {
+    iree_memory_shared_object_release(object);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+void iree_memory_shared_object_release(iree_memory_shared_object_t* object) {
+  if (!object) return;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // NOTE: return values ignored as this is a shutdown path. Any views mapping
+  // the object hold their own reference to the pages.
+  if (object->contents) munmap(object->contents, object->total_length);
+  if (object->fd >= 0) close(object->fd);
+  iree_allocator_free(object->allocator, object);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+const uint8_t* iree_memory_shared_object_contents(
+    iree_memory_shared_object_t* object) {
+  return object->contents;
+}
+
+iree_status_t iree_memory_view_map_shared_ranges(
+    void* base_address, iree_memory_shared_object_t* object,
+    iree_host_size_t range_count, const iree_byte_range_t* ranges,
+    iree_memory_access_t access) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  int mmap_prot = iree_memory_access_to_prot(access);
+
+  iree_status_t status = iree_ok_status();
+  for (iree_host_size_t i = 0; i < range_count; ++i) {
+    void* range_start = NULL;
+    iree_host_size_t aligned_length = 0;
+    iree_page_align_range(base_address, ranges[i], getpagesize(), &range_start,
+                          &aligned_length);
+    off_t offset = (off_t)((uint8_t*)range_start - (uint8_t*)base_address);
+
+    // A failed MAP_FIXED may leave the target range unmapped so we first map
+    // the pages elsewhere: this fails for the same reasons (such as policies
+    // disallowing executable shared mappings) without touching the view.
+    void* probe =
+        mmap(NULL, aligned_length, mmap_prot, MAP_SHARED, object->fd, offset);
+    if (probe == MAP_FAILED) {
+      status = iree_make_status(iree_status_code_from_errno(errno),
+                                "shared object mmap failed");
+      break;
+    }
+    void* result = mmap(range_start, aligned_length, mmap_prot,
+                        MAP_SHARED | MAP_FIXED, object->fd, offset);
+    munmap(probe, aligned_length);
+    if (result == MAP_FAILED) {
+      status = iree_make_status(iree_status_code_from_errno(errno),
+                                "shared object mmap failed");
+      break;
+    }
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
 #endif  // IREE_PLATFORM_*
@@ -0,0 +1,185 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/local/executable_environment.h"
+
+#include <string.h>
+
+#if defined(IREE_ARCH_X86_64)
+#if defined(IREE_COMPILER_MSVC)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif  // IREE_COMPILER_MSVC
+#elif defined(IREE_ARCH_ARM_64) && \
+    (defined(IREE_PLATFORM_LINUX) || defined(IREE_PLATFORM_ANDROID))
+#include <sys/auxv.h>
+#endif  // IREE_ARCH_*
+
+//===----------------------------------------------------------------------===//
+// x86-64
+//===----------------------------------------------------------------------===//
+
+#if defined(IREE_ARCH_X86_64)
+
+static void iree_hal_cpuid(uint32_t leaf, uint32_t subleaf, uint32_t out[4]) {
+#if defined(IREE_COMPILER_MSVC)
+  __cpuidex((int*)out, (int)leaf, (int)subleaf);
+#else
+  __cpuid_count(leaf, subleaf, out[0], out[1], out[2], out[3]);
+#endif  // IREE_COMPILER_MSVC
+}
+
+// Returns the XCR0 register indicating which register state the operating
+// system saves. Only valid when CPUID reports OSXSAVE.
+static uint64_t iree_hal_xgetbv0(void) {
+#if defined(IREE_COMPILER_MSVC)
+  return _xgetbv(0);
+#else
+  uint32_t eax = 0, edx = 0;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return ((uint64_t)edx << 32) | eax;
+#endif  // IREE_COMPILER_MSVC
+}
+
+static void iree_hal_processor_query_x86_64(
+    iree_hal_processor_v0_t* out_processor) {
+  uint32_t leaf0[4] = {0};
+  iree_hal_cpuid(0, 0, leaf0);
+  uint32_t max_leaf = leaf0[0];
+  if (max_leaf < 1) return;
+
+  uint32_t leaf1[4] = {0};
+  iree_hal_cpuid(1, 0, leaf1);
+  const uint32_t leaf1_ecx = leaf1[2];
+  if (!(leaf1_ecx & (1u << 27))) return;  // OSXSAVE
+
+  // AVX requires the OS to save XMM and YMM state and AVX-512 additionally
+  // requires the opmask and ZMM state.
+  uint64_t xcr0 = iree_hal_xgetbv0();
+  bool os_avx = (xcr0 & 0x6) == 0x6;
+  bool os_avx512 = os_avx && (xcr0 & 0xE0) == 0xE0;
+  if (!os_avx) return;
+
+  uint64_t* data0 = &out_processor->data[0];
+  if (leaf1_ecx & (1u << 28)) *data0 |= IREE_HAL_PROCESSOR_DATA0_X86_64_AVX;
+  if (leaf1_ecx & (1u << 12)) *data0 |= IREE_HAL_PROCESSOR_DATA0_X86_64_FMA;
+  if (leaf1_ecx & (1u << 29)) *data0 |= IREE_HAL_PROCESSOR_DATA0_X86_64_F16C;
+
+  if (max_leaf < 7) return;
+  uint32_t leaf7[4] = {0};
+  iree_hal_cpuid(7, 0, leaf7);
+  const uint32_t leaf7_ebx = leaf7[1];
+  const uint32_t leaf7_ecx = leaf7[2];
+  if (leaf7_ebx & (1u << 5)) *data0 |= IREE_HAL_PROCESSOR_DATA0_X86_64_AVX2;
+  if (!os_avx512) return;
+  if (leaf7_ebx & (1u << 16)) {
+    *data0 |= IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512F;
+  }
+  if (leaf7_ebx & (1u << 17)) {
+    *data0 |= IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512DQ;
+  }
+  if (leaf7_ebx & (1u << 30)) {
+    *data0 |= IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512BW;
+  }
+  if (leaf7_ebx & (1u << 31)) {
+    *data0 |= IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512VL;
+  }
+  if (leaf7_ecx & (1u << 11)) {
+    *data0 |= IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512VNNI;
+  }
+
+  // AVX512-BF16 is reported in subleaf 1 of leaf 7.
+  const uint32_t max_leaf7_subleaf = leaf7[0];
+  if (max_leaf7_subleaf < 1) return;
+  uint32_t leaf7_1[4] = {0};
+  iree_hal_cpuid(7, 1, leaf7_1);
+  const uint32_t leaf7_1_eax = leaf7_1[0];
+  if (leaf7_1_eax & (1u << 5)) {
+    *data0 |= IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512BF16;
+  }
+}
+
+#endif  // IREE_ARCH_X86_64
+
+//===----------------------------------------------------------------------===//
+// arm64
+//===----------------------------------------------------------------------===//
+
+#if defined(IREE_ARCH_ARM_64) && \
+    (defined(IREE_PLATFORM_LINUX) || defined(IREE_PLATFORM_ANDROID))
+
+// From the Linux uapi asm/hwcap.h; defined here as older sysroots lack them.
+#define IREE_HAL_ARM_64_HWCAP_ASIMDDP (1ul << 20)
+#define IREE_HAL_ARM_64_HWCAP2_I8MM (1ul << 13)
+#define IREE_HAL_ARM_64_HWCAP2_BF16 (1ul << 14)
+#if !defined(AT_HWCAP2)
+#define AT_HWCAP2 26
+#endif  // !AT_HWCAP2
+
+static void iree_hal_processor_query_arm_64(
+    iree_hal_processor_v0_t* out_processor) {
+  unsigned long hwcap = getauxval(AT_HWCAP);
+  unsigned long hwcap2 = getauxval(AT_HWCAP2);
+  uint64_t* data0 = &out_processor->data[0];
+  if (hwcap & IREE_HAL_ARM_64_HWCAP_ASIMDDP) {
+    *data0 |= IREE_HAL_PROCESSOR_DATA0_ARM_64_DOTPROD;
+  }
+  if (hwcap2 & IREE_HAL_ARM_64_HWCAP2_I8MM) {
+    *data0 |= IREE_HAL_PROCESSOR_DATA0_ARM_64_I8MM;
+  }
+  if (hwcap2 & IREE_HAL_ARM_64_HWCAP2_BF16) {
+    *data0 |= IREE_HAL_PROCESSOR_DATA0_ARM_64_BF16;
+  }
+}
+
+#endif  // IREE_ARCH_ARM_64
+
+//===----------------------------------------------------------------------===//
+// iree_hal_executable_environment_v0_t
+//===----------------------------------------------------------------------===//
+
+void iree_hal_processor_query(iree_hal_processor_v0_t* out_processor) {
+  IREE_ASSERT_ARGUMENT(out_processor);
+  memset(out_processor, 0, sizeof(*out_processor));
+#if defined(IREE_ARCH_X86_64)
+  iree_hal_processor_query_x86_64(out_processor);
+#elif defined(IREE_ARCH_ARM_64) && \
+    (defined(IREE_PLATFORM_LINUX) || defined(IREE_PLATFORM_ANDROID))
+  iree_hal_processor_query_arm_64(out_processor);
+#endif  // IREE_ARCH_*
+}
+
+// Encodes |cache_size| in bytes as KiB in the field at |shift| of data[1].
+static uint64_t iree_hal_processor_encode_cache_size(
+    iree_host_size_t cache_size, uint64_t mask, uint32_t shift) {
+  uint64_t cache_size_kb = iree_min((uint64_t)cache_size / 1024, mask);
+  return cache_size_kb << shift;
+}
+
+void iree_hal_processor_set_cache_sizes(iree_host_size_t l1d_cache_size,
+                                        iree_host_size_t l2_cache_size,
+                                        iree_host_size_t l3_cache_size,
+                                        iree_hal_processor_v0_t* processor) {
+  IREE_ASSERT_ARGUMENT(processor);
+  processor->data[1] =
+      iree_hal_processor_encode_cache_size(
+          l1d_cache_size, IREE_HAL_PROCESSOR_DATA1_L1D_CACHE_KB_MASK,
+          IREE_HAL_PROCESSOR_DATA1_L1D_CACHE_KB_SHIFT) |
+      iree_hal_processor_encode_cache_size(
+          l2_cache_size, IREE_HAL_PROCESSOR_DATA1_L2_CACHE_KB_MASK,
+          IREE_HAL_PROCESSOR_DATA1_L2_CACHE_KB_SHIFT) |
+      iree_hal_processor_encode_cache_size(
+          l3_cache_size, IREE_HAL_PROCESSOR_DATA1_L3_CACHE_KB_MASK,
+          IREE_HAL_PROCESSOR_DATA1_L3_CACHE_KB_SHIFT);
+}
+
+void iree_hal_executable_environment_initialize(
+    iree_hal_executable_environment_v0_t* out_environment) {
+  IREE_ASSERT_ARGUMENT(out_environment);
+  memset(out_environment, 0, sizeof(*out_environment));
+  iree_hal_processor_query(&out_environment->processor);
+}
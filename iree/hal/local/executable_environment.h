@@ -0,0 +1,40 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_LOCAL_EXECUTABLE_ENVIRONMENT_H_
+#define IREE_HAL_LOCAL_EXECUTABLE_ENVIRONMENT_H_
+
+#include "iree/base/api.h"
+#include "iree/hal/local/executable_library.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Queries the features of the processor the calling thread is executing on.
+// Only features supported by both the processor and the operating system are
+// reported. Processors are assumed to be homogeneous.
+void iree_hal_processor_query(iree_hal_processor_v0_t* out_processor);
+
+// Sets the data cache sizes in bytes reported by |processor|. A size of 0
+// indicates that the size of that cache level is unknown. Sizes are rounded
+// down to KiB and clamped to the maximum that can be represented.
+void iree_hal_processor_set_cache_sizes(iree_host_size_t l1d_cache_size,
+                                        iree_host_size_t l2_cache_size,
+                                        iree_host_size_t l3_cache_size,
+                                        iree_hal_processor_v0_t* processor);
+
+// Initializes |out_environment| to the environment of the hosting process.
+// The environment is passed to executable libraries when they are queried so
+// that they may select code specialized for the host.
+void iree_hal_executable_environment_initialize(
+    iree_hal_executable_environment_v0_t* out_environment);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_LOCAL_EXECUTABLE_ENVIRONMENT_H_
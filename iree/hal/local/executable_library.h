@@ -109,18 +109,90 @@ typedef struct iree_hal_executable_library_header_t {
   iree_hal_executable_library_sanitizer_kind_t sanitizer;
 } iree_hal_executable_library_header_t;
 
+//===----------------------------------------------------------------------===//
+// Hosting environment
+//===----------------------------------------------------------------------===//
+
+// Number of 64-bit words of processor information.
+#define IREE_HAL_PROCESSOR_DATA_CAPACITY_V0 8
+
+// Processor feature bits in iree_hal_processor_v0_t::data[0] on x86-64.
+// Bits are only set when the feature is also enabled by the operating system
+// (such as AVX register state being saved across context switches).
+#define IREE_HAL_PROCESSOR_DATA0_X86_64_AVX (1ull << 0)
+#define IREE_HAL_PROCESSOR_DATA0_X86_64_AVX2 (1ull << 1)
+#define IREE_HAL_PROCESSOR_DATA0_X86_64_FMA (1ull << 2)
+#define IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512F (1ull << 3)
+#define IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512BW (1ull << 4)
+#define IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512DQ (1ull << 5)
+#define IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512VL (1ull << 6)
+#define IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512VNNI (1ull << 7)
+#define IREE_HAL_PROCESSOR_DATA0_X86_64_F16C (1ull << 8)
+#define IREE_HAL_PROCESSOR_DATA0_X86_64_AVX512BF16 (1ull << 9)
+
+// Processor feature bits in iree_hal_processor_v0_t::data[0] on arm64.
+#define IREE_HAL_PROCESSOR_DATA0_ARM_64_DOTPROD (1ull << 0)
+#define IREE_HAL_PROCESSOR_DATA0_ARM_64_I8MM (1ull << 1)
+#define IREE_HAL_PROCESSOR_DATA0_ARM_64_BF16 (1ull << 2)
+
+// Data cache sizes in KiB in iree_hal_processor_v0_t::data[1] on all
+// architectures. Sizes are those of the caches used by a single core (with the
+// L3 cache usually shared with other cores) and are 0 when unknown. Systems
+// with heterogeneous cores report the smallest size of each level.
+#define IREE_HAL_PROCESSOR_DATA1_L1D_CACHE_KB_SHIFT 0
+#define IREE_HAL_PROCESSOR_DATA1_L1D_CACHE_KB_MASK 0xFFFFull
+#define IREE_HAL_PROCESSOR_DATA1_L2_CACHE_KB_SHIFT 16
+#define IREE_HAL_PROCESSOR_DATA1_L2_CACHE_KB_MASK 0xFFFFull
+#define IREE_HAL_PROCESSOR_DATA1_L3_CACHE_KB_SHIFT 32
+#define IREE_HAL_PROCESSOR_DATA1_L3_CACHE_KB_MASK 0xFFFFFFFFull
+
+// Information about the processor the library is executing on.
+// The meaning of data[0] is architecture-specific and any bits not declared
+// above must be zero.
+typedef struct iree_hal_processor_v0_t {
+  uint64_t data[IREE_HAL_PROCESSOR_DATA_CAPACITY_V0];
+} iree_hal_processor_v0_t;
+static_assert(sizeof(iree_hal_processor_v0_t) == 64, "must be 64 bytes");
+
+// Information about the hosting environment provided to libraries when they
+// are queried. Libraries may use this to select between multiple versions of
+// their exports, such as those compiled for different processor features.
+typedef struct iree_hal_executable_environment_v0_t {
+  // Processor the library will be executing on.
+  iree_hal_processor_v0_t processor;
+} iree_hal_executable_environment_v0_t;
+
+//===----------------------------------------------------------------------===//
+// Library querying
+//===----------------------------------------------------------------------===//
+
 // Exported function from dynamic libraries for querying library information.
 // The provided |max_version| is the maximum version the caller supports;
 // callees must return NULL if their lowest available version is greater
 // than the max version supported by the caller.
+//
+// The optional |environment| describes where the library will execute and may
+// be used to select the library version returned. If NULL then the library
+// must assume the baseline environment it was compiled for. The environment is
+// only valid for the duration of the call.
 typedef const iree_hal_executable_library_header_t** (
     *iree_hal_executable_library_query_fn_t)(
-    iree_hal_executable_library_version_t max_version, void* reserved);
+    iree_hal_executable_library_version_t max_version,
+    const iree_hal_executable_environment_v0_t* environment);
 
 // Function name exported from dynamic libraries (pass to dlsym).
 #define IREE_HAL_EXECUTABLE_LIBRARY_EXPORT_NAME \
   "iree_hal_executable_library_query"
 
+// Writes the raw profile collected by a dynamic library compiled with
+// profile-guided optimization instrumentation. Returns 0 on success.
+typedef int (*iree_hal_executable_library_write_profile_fn_t)(void);
+
+// Function name exported from instrumented dynamic libraries (pass to dlsym).
+// Only present in libraries compiled with instrumentation.
+#define IREE_HAL_EXECUTABLE_LIBRARY_PROFILE_WRITE_NAME \
+  "iree_hal_executable_library_write_profile"
+
 //===----------------------------------------------------------------------===//
 // IREE_HAL_EXECUTABLE_LIBRARY_VERSION_0
 //===----------------------------------------------------------------------===//
@@ -255,6 +327,35 @@ typedef int (*iree_hal_executable_dispatch_v0_t)(
     const iree_hal_executable_dispatch_state_v0_t* dispatch_state,
     const iree_hal_vec3_t* workgroup_id, void* local_memory);
 
+// A contiguous range of workgroups in a dispatch.
+// Workgroups are linearized in x-major order such that workgroup index `i`
+// corresponds to the workgroup ID:
+//   x = i % workgroup_count.x
+//   y = (i / workgroup_count.x) % workgroup_count.y
+//   z = i / (workgroup_count.x * workgroup_count.y)
+typedef struct iree_hal_executable_workgroup_range_v0_t {
+  // Linearized index of the first workgroup in the range.
+  uint32_t workgroup_base;
+  // Total number of workgroups in the range. Always > 0.
+  uint32_t workgroup_count;
+} iree_hal_executable_workgroup_range_v0_t;
+static_assert(sizeof(iree_hal_executable_workgroup_range_v0_t) == 8,
+              "must be 8 bytes");
+
+// Function signature of exported executable range entry points.
+// Executes all workgroups in |workgroup_range| in order, as if the
+// iree_hal_executable_dispatch_v0_t entry point with the same ordinal was
+// called once per workgroup with the same |dispatch_state| and |local_memory|.
+// Range entry points allow executables to hoist per-dispatch work out of the
+// workgroup loop and amortize the call overhead across many workgroups.
+//
+// Returns 0 on success and the first non-zero workgroup result on failure; the
+// remaining workgroups in the range are not executed.
+typedef int (*iree_hal_executable_dispatch_range_v0_t)(
+    const iree_hal_executable_dispatch_state_v0_t* dispatch_state,
+    const iree_hal_executable_workgroup_range_v0_t* workgroup_range,
+    void* local_memory);
+
 // Bytes per page of workgroup local memory.
 // This is chosen to match the common page size of devices.
 #define IREE_HAL_WORKGROUP_LOCAL_MEMORY_PAGE_SIZE 4096
@@ -262,17 +363,54 @@ typedef int (*iree_hal_executable_dispatch_v0_t)(
 // Attributes for exported dispatch functions defining how they are to be
 // executed. 0 defaults are well-specified and the entire attributes table may
 // be omitted if no dispatch functions require these fields.
+// Bitfield specifying the behavior of a dispatch.
+enum iree_hal_executable_dispatch_flag_bits_v0_t {
+  IREE_HAL_EXECUTABLE_DISPATCH_FLAG_V0_NONE = 0u,
+  // Dispatch requires IEEE denormal behavior. Runtimes flush denormals to zero
+  // by default as denormal arithmetic can be orders of magnitude slower on
+  // some architectures; this opts out for exports that depend on them.
+  IREE_HAL_EXECUTABLE_DISPATCH_FLAG_V0_PRESERVE_DENORMALS = 1u << 0,
+};
+typedef uint8_t iree_hal_executable_dispatch_flags_v0_t;
+
 typedef struct iree_hal_executable_dispatch_attrs_v0_t {
   // Number of IREE_HAL_WORKGROUP_LOCAL_MEMORY_PAGE_SIZE byte pages (or 0)
   // indicating how much workgroup local memory is required for the dispatch.
   // This is the size of the buffer referenced by the `local_memory` argument.
   uint16_t local_memory_pages;
-  // Must be 0. May be used in the future for flags controlling the dispatch
-  // behavior/synchronization requirements.
-  uint16_t reserved;
+  // Suggested number of workgroups (or 0) a scheduler should group together
+  // when distributing the dispatch across workers. Cheap workgroups benefit
+  // from larger groups that amortize scheduling overhead while expensive ones
+  // benefit from smaller groups that balance better. Schedulers may treat this
+  // as a starting point and adapt based on observed execution time.
+  uint8_t workgroup_grain_size;
+  // Flags controlling the dispatch behavior/synchronization requirements.
+  iree_hal_executable_dispatch_flags_v0_t flags;
 } iree_hal_executable_dispatch_attrs_v0_t;
 static_assert(sizeof(iree_hal_executable_dispatch_attrs_v0_t) == 4, "uint32_t");
 
+// Compiler-estimated cost of a single dispatch of an export.
+// Values are derived from the static shapes and operations in the dispatch
+// region and are only estimates; a value of 0 indicates that the compiler was
+// unable to compute it (such as when shapes are dynamic). Schedulers,
+// benchmarks, and profilers can use these to compute achieved throughput
+// without needing to know the contents of the dispatch.
+typedef struct iree_hal_executable_dispatch_cost_v0_t {
+  // Total number of arithmetic operations performed by the dispatch.
+  uint64_t flop_count;
+  // Total number of bytes read from bindings by the dispatch.
+  uint64_t read_byte_count;
+  // Total number of bytes written to bindings by the dispatch.
+  uint64_t write_byte_count;
+  // Total number of workgroups the dispatch was tiled into (or 0 if it depends
+  // on the workload).
+  uint32_t workgroup_count;
+  // Must be 0.
+  uint32_t reserved;
+} iree_hal_executable_dispatch_cost_v0_t;
+static_assert(sizeof(iree_hal_executable_dispatch_cost_v0_t) == 32,
+              "must be 32 bytes");
+
 // A table of exported functions arranged as a struct-of-arrays for more
 // efficient packing and faster lookup. Each subarray - when not omitted and
 // NULL - is indexed by export ordinal and has up to |count| entries.
@@ -298,6 +436,15 @@ typedef struct iree_hal_executable_export_table_v0_t {
   // verbose logging. The string values, when present, may be attached to
   // tracing/debugging events related to the entry point.
   const char* const* tags;
+
+  // Optional table of compiler-estimated dispatch costs 1:1 with ptrs.
+  // Omitted when the compiler was unable to estimate the cost of any export.
+  const iree_hal_executable_dispatch_cost_v0_t* costs;
+
+  // Optional table of range entry points 1:1 with ptrs.
+  // Individual entries may be NULL if an export has no range entry point in
+  // which case the runtime calls the per-workgroup entry point instead.
+  const iree_hal_executable_dispatch_range_v0_t* range_ptrs;
 } iree_hal_executable_export_table_v0_t;
 
 // Structure used for v0 library interfaces.
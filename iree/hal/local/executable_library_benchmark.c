@@ -45,6 +45,27 @@ IREE_FLAG(int32_t, workgroup_size_y, 1,
 IREE_FLAG(int32_t, workgroup_size_z, 1,
           "Z dimension of the workgroup size passed to the executable.");
 
+IREE_FLAG(int64_t, flops_per_dispatch, 0,
+          "Number of operations performed by one dispatch of the whole\n"
+          "workgroup grid. When set the achieved FLOP/s and the arithmetic\n"
+          "intensity (FLOP/byte) are reported. Defaults to the compiler\n"
+          "estimate embedded in the executable, if any.");
+IREE_FLAG(int64_t, bytes_per_dispatch, 0,
+          "Number of bytes of memory traffic of one dispatch of the whole\n"
+          "workgroup grid. Defaults to the compiler estimate embedded in the\n"
+          "executable or otherwise to the total size of all bindings, which\n"
+          "assumes each binding is accessed exactly once.");
+IREE_FLAG(double, peak_gflops, 0.0,
+          "Peak compute throughput of the machine in GFLOP/s. When set along\n"
+          "with --peak_gbps and --flops_per_dispatch the dispatch is placed\n"
+          "on the roofline and labeled memory-bound or compute-bound.");
+IREE_FLAG(double, peak_gbps, 0.0,
+          "Peak memory bandwidth of the machine in GB/s.");
+IREE_FLAG(bool, perf_counters, false,
+          "Reads hardware performance counters (cycles, instructions, cache\n"
+          "misses) around the dispatches and reports per-dispatch averages.\n"
+          "Only available on Linux/Android with perf_event access.");
+
 // Total number of bindings we (currently) allow any executable to have.
 #define IREE_HAL_LOCAL_MAX_TOTAL_BINDING_COUNT \
   (IREE_HAL_LOCAL_MAX_DESCRIPTOR_SET_COUNT *   \
@@ -126,6 +147,183 @@ IREE_FLAG_CALLBACK(
     "  # 2 4-byte floating-point values with contents [[1.4], [2.1]]:\n"
     "  --binding=2x1xf32=1.4,2.1");
 
+//===----------------------------------------------------------------------===//
+// Hardware performance counters
+//===----------------------------------------------------------------------===//
+
+#if defined(IREE_PLATFORM_LINUX)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif  // IREE_PLATFORM_LINUX
+
+typedef enum iree_perf_counter_e {
+  IREE_PERF_COUNTER_CYCLES = 0,
+  IREE_PERF_COUNTER_INSTRUCTIONS,
+  IREE_PERF_COUNTER_L1D_MISSES,
+  // On most cores references to the last-level cache are the misses of the
+  // cache level below it (L2).
+  IREE_PERF_COUNTER_LLC_REFERENCES,
+  IREE_PERF_COUNTER_LLC_MISSES,
+  IREE_PERF_COUNTER_COUNT,
+} iree_perf_counter_t;
+
+static const char* iree_perf_counter_names[IREE_PERF_COUNTER_COUNT] = {
+    "cycles", "instructions", "L1D_misses", "LLC_refs", "LLC_misses",
+};
+
+// Per-thread hardware counters measuring the inline dispatches.
+// Counters the kernel or hardware does not support have an fd of -1 and are
+// not reported.
+typedef struct iree_perf_counters_t {
+  int fds[IREE_PERF_COUNTER_COUNT];
+  uint64_t values[IREE_PERF_COUNTER_COUNT];
+} iree_perf_counters_t;
+
+#if defined(IREE_PLATFORM_LINUX)
+
+static int iree_perf_counter_open(uint32_t type, uint64_t config) {
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = type;
+  attr.config = config;
+  attr.disabled = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  // Dispatches run inline on the calling thread so only it is measured.
+  return (int)syscall(__NR_perf_event_open, &attr, /*pid=*/0, /*cpu=*/-1,
+                      /*group_fd=*/-1, /*flags=*/0);
+}
+
+static iree_status_t iree_perf_counters_open(iree_perf_counters_t* counters) {
+  memset(counters, 0, sizeof(*counters));
+  const uint64_t l1d_read_miss = PERF_COUNT_HW_CACHE_L1D |
+                                 (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                 (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+  const uint64_t llc_read_access = PERF_COUNT_HW_CACHE_LL |
+                                   (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                   (PERF_COUNT_HW_CACHE_RESULT_ACCESS << 16);
+  const uint64_t llc_read_miss = PERF_COUNT_HW_CACHE_LL |
+                                 (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                 (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+  counters->fds[IREE_PERF_COUNTER_CYCLES] =
+      iree_perf_counter_open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+  counters->fds[IREE_PERF_COUNTER_INSTRUCTIONS] =
+      iree_perf_counter_open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+  counters->fds[IREE_PERF_COUNTER_L1D_MISSES] =
+      iree_perf_counter_open(PERF_TYPE_HW_CACHE, l1d_read_miss);
+  counters->fds[IREE_PERF_COUNTER_LLC_REFERENCES] =
+      iree_perf_counter_open(PERF_TYPE_HW_CACHE, llc_read_access);
+  counters->fds[IREE_PERF_COUNTER_LLC_MISSES] =
+      iree_perf_counter_open(PERF_TYPE_HW_CACHE, llc_read_miss);
+  for (int i = 0; i < IREE_PERF_COUNTER_COUNT; ++i) {
+    if (counters->fds[i] >= 0) return iree_ok_status();
+  }
+  return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                          "no perf_event counters available; check "
+                          "/proc/sys/kernel/perf_event_paranoid");
+}
+
+static void iree_perf_counters_close(iree_perf_counters_t* counters) {
+  for (int i = 0; i < IREE_PERF_COUNTER_COUNT; ++i) {
+    if (counters->fds[i] >= 0) close(counters->fds[i]);
+    counters->fds[i] = -1;
+  }
+}
+
+static void iree_perf_counters_start(iree_perf_counters_t* counters) {
+  for (int i = 0; i < IREE_PERF_COUNTER_COUNT; ++i) {
+    if (counters->fds[i] < 0) continue;
+    ioctl(counters->fds[i], PERF_EVENT_IOC_RESET, 0);
+    ioctl(counters->fds[i], PERF_EVENT_IOC_ENABLE, 0);
+  }
+}
+
+static void iree_perf_counters_stop(iree_perf_counters_t* counters) {
+  for (int i = 0; i < IREE_PERF_COUNTER_COUNT; ++i) {
+    if (counters->fds[i] < 0) continue;
+    ioctl(counters->fds[i], PERF_EVENT_IOC_DISABLE, 0);
+    uint64_t value = 0;
+    if (read(counters->fds[i], &value, sizeof(value)) != sizeof(value)) {
+      value = 0;
+    }
+    counters->values[i] = value;
+  }
+}
+
+#else
+
+static iree_status_t iree_perf_counters_open(iree_perf_counters_t* counters) {
+  for (int i = 0; i < IREE_PERF_COUNTER_COUNT; ++i) counters->fds[i] = -1;
+  return iree_make_status(IREE_STATUS_UNAVAILABLE,
+                          "perf counters are only available on Linux");
+}
+static void iree_perf_counters_close(iree_perf_counters_t* counters) {}
+static void iree_perf_counters_start(iree_perf_counters_t* counters) {}
+static void iree_perf_counters_stop(iree_perf_counters_t* counters) {}
+
+#endif  // IREE_PLATFORM_LINUX
+
+// Reports the per-dispatch average of each available counter and the IPC.
+static void iree_perf_counters_report(const iree_perf_counters_t* counters,
+                                      iree_benchmark_state_t* benchmark_state) {
+  for (int i = 0; i < IREE_PERF_COUNTER_COUNT; ++i) {
+    if (counters->fds[i] < 0) continue;
+    iree_benchmark_set_counter(benchmark_state, iree_perf_counter_names[i],
+                               (double)counters->values[i],
+                               IREE_BENCHMARK_COUNTER_FLAG_AVERAGE_ITERATIONS);
+  }
+  uint64_t cycles = counters->values[IREE_PERF_COUNTER_CYCLES];
+  if (counters->fds[IREE_PERF_COUNTER_INSTRUCTIONS] >= 0 &&
+      counters->fds[IREE_PERF_COUNTER_CYCLES] >= 0 && cycles > 0) {
+    iree_benchmark_set_counter(
+        benchmark_state, "IPC",
+        (double)counters->values[IREE_PERF_COUNTER_INSTRUCTIONS] / cycles,
+        IREE_BENCHMARK_COUNTER_FLAG_NONE);
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// Roofline
+//===----------------------------------------------------------------------===//
+
+// Reports throughput and roofline counters of |dispatch_count| dispatches that
+// took |duration_ns| in total.
+static void iree_hal_executable_library_report_roofline(
+    int64_t dispatch_count, iree_duration_t duration_ns,
+    int64_t flops_per_dispatch, int64_t bytes_per_dispatch,
+    iree_benchmark_state_t* benchmark_state) {
+  iree_benchmark_set_bytes_processed(benchmark_state,
+                                     dispatch_count * bytes_per_dispatch);
+  if (flops_per_dispatch <= 0 || dispatch_count <= 0) return;
+  iree_benchmark_set_counter(
+      benchmark_state, "FLOP/s",
+      (double)flops_per_dispatch * (double)dispatch_count,
+      IREE_BENCHMARK_COUNTER_FLAG_RATE);
+  if (bytes_per_dispatch <= 0 || duration_ns <= 0) return;
+
+  // Intensity is independent of time; the ridge point where the memory and
+  // compute ceilings meet splits memory-bound from compute-bound dispatches.
+  double intensity = (double)flops_per_dispatch / (double)bytes_per_dispatch;
+  iree_benchmark_set_counter(benchmark_state, "FLOP/byte", intensity,
+                             IREE_BENCHMARK_COUNTER_FLAG_NONE);
+  if (FLAG_peak_gflops <= 0.0 || FLAG_peak_gbps <= 0.0) return;
+  double achieved_gflops = (double)flops_per_dispatch *
+                           (double)dispatch_count / (double)duration_ns;
+  double ridge_intensity = FLAG_peak_gflops / FLAG_peak_gbps;
+  double attainable_gflops = intensity < ridge_intensity
+                                 ? intensity * FLAG_peak_gbps
+                                 : FLAG_peak_gflops;
+  iree_benchmark_set_counter(benchmark_state, "roofline_%",
+                             100.0 * achieved_gflops / attainable_gflops,
+                             IREE_BENCHMARK_COUNTER_FLAG_NONE);
+  iree_benchmark_set_label(benchmark_state, intensity < ridge_intensity
+                                                ? "memory-bound"
+                                                : "compute-bound");
+}
+
 #if defined(IREE_HAL_HAVE_EMBEDDED_LIBRARY_LOADER)
 #include "iree/hal/local/loaders/embedded_library_loader.h"
 #endif  // IREE_HAL_HAVE_EMBEDDED_LIBRARY_LOADER
@@ -240,9 +438,11 @@ static iree_status_t iree_hal_executable_library_run(
   // there was an issue with the layouts.
   iree_hal_executable_t* executable = NULL;
   IREE_RETURN_IF_ERROR(iree_hal_executable_loader_try_load(
-      executable_loader, &executable_spec, &executable));
+      executable_loader, &executable_spec, /*environment=*/NULL, &executable));
   iree_hal_local_executable_t* local_executable =
       iree_hal_local_executable_cast(executable);
+  IREE_RETURN_IF_ERROR(
+      iree_hal_local_executable_ensure_loaded(local_executable));
 
   // Allocate workgroup-local memory that each invocation can use.
   iree_byte_span_t local_memory = iree_make_byte_span(NULL, 0);
@@ -268,6 +468,7 @@ static iree_status_t iree_hal_executable_library_run(
   iree_hal_buffer_view_t* buffer_views[IREE_HAL_LOCAL_MAX_TOTAL_BINDING_COUNT];
   void* binding_ptrs[IREE_HAL_LOCAL_MAX_TOTAL_BINDING_COUNT];
   size_t binding_lengths[IREE_HAL_LOCAL_MAX_TOTAL_BINDING_COUNT];
+  int64_t total_binding_length = 0;
   for (iree_host_size_t i = 0; i < dispatch_params.binding_count; ++i) {
     IREE_RETURN_IF_ERROR(iree_hal_buffer_view_parse(
         dispatch_params.bindings[i], heap_allocator, &buffer_views[i]));
@@ -281,6 +482,7 @@ static iree_status_t iree_hal_executable_library_run(
         buffer_length, &buffer_mapping));
     binding_ptrs[i] = buffer_mapping.contents.data;
     binding_lengths[i] = (size_t)buffer_mapping.contents.data_length;
+    total_binding_length += (int64_t)binding_lengths[i];
   }
 
   // Setup dispatch state.
@@ -309,12 +511,24 @@ static iree_status_t iree_hal_executable_library_run(
   // we are testing the memory access patterns: if we just ran the same single
   // tile processing the same exact region of memory over and over we are not
   // testing cache effects.
+  iree_perf_counters_t perf_counters;
+  if (FLAG_perf_counters) {
+    IREE_RETURN_IF_ERROR(iree_perf_counters_open(&perf_counters));
+    iree_perf_counters_start(&perf_counters);
+  }
   int64_t dispatch_count = 0;
+  iree_time_t start_time_ns = iree_time_now();
   while (iree_benchmark_keep_running(benchmark_state, /*batch_count=*/1)) {
     IREE_RETURN_IF_ERROR(iree_hal_local_executable_issue_dispatch_inline(
         local_executable, FLAG_entry_point, &dispatch_state, local_memory));
     ++dispatch_count;
   }
+  iree_duration_t duration_ns = iree_time_now() - start_time_ns;
+  if (FLAG_perf_counters) {
+    iree_perf_counters_stop(&perf_counters);
+    iree_perf_counters_report(&perf_counters, benchmark_state);
+    iree_perf_counters_close(&perf_counters);
+  }
 
   // To get a total time per invocation we set the item count to the total
   // invocations dispatched. That gives us both total dispatch and single
@@ -323,6 +537,26 @@ static iree_status_t iree_hal_executable_library_run(
       dispatch_count * dispatch_state.workgroup_count.x *
       dispatch_state.workgroup_count.y * dispatch_state.workgroup_count.z;
   iree_benchmark_set_items_processed(benchmark_state, total_invocations);
+  // Compiler-estimated costs are used when not explicitly specified. Note that
+  // these assume the workgroup count the compiler selected for the dispatch.
+  const iree_hal_executable_dispatch_cost_v0_t* dispatch_cost =
+      local_executable->dispatch_costs
+          ? &local_executable->dispatch_costs[FLAG_entry_point]
+          : NULL;
+  int64_t flops_per_dispatch = FLAG_flops_per_dispatch;
+  if (flops_per_dispatch <= 0 && dispatch_cost) {
+    flops_per_dispatch = (int64_t)dispatch_cost->flop_count;
+  }
+  int64_t bytes_per_dispatch = FLAG_bytes_per_dispatch;
+  if (bytes_per_dispatch <= 0 && dispatch_cost) {
+    bytes_per_dispatch = (int64_t)(dispatch_cost->read_byte_count +
+                                   dispatch_cost->write_byte_count);
+  }
+  if (bytes_per_dispatch <= 0) bytes_per_dispatch = total_binding_length;
+  iree_hal_executable_library_report_roofline(dispatch_count, duration_ns,
+                                              flops_per_dispatch,
+                                              bytes_per_dispatch,
+                                              benchmark_state);
 
   // Deallocate buffers.
   for (iree_host_size_t i = 0; i < dispatch_params.binding_count; ++i) {
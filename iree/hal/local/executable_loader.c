@@ -89,6 +89,7 @@ bool iree_hal_query_any_executable_loader_support(
 iree_status_t iree_hal_executable_loader_try_load(
     iree_hal_executable_loader_t* executable_loader,
     const iree_hal_executable_spec_t* executable_spec,
+    const iree_hal_executable_environment_v0_t* environment,
     iree_hal_executable_t** out_executable) {
   IREE_ASSERT_ARGUMENT(executable_loader);
   IREE_ASSERT_ARGUMENT(executable_spec);
@@ -98,5 +99,5 @@ iree_status_t iree_hal_executable_loader_try_load(
                        executable_spec->executable_data.data);
   IREE_ASSERT_ARGUMENT(out_executable);
   return executable_loader->vtable->try_load(executable_loader, executable_spec,
-                                             out_executable);
+                                             environment, out_executable);
 }
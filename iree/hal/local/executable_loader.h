@@ -13,6 +13,7 @@
 #include "iree/base/api.h"
 #include "iree/base/internal/atomics.h"
 #include "iree/hal/api.h"
+#include "iree/hal/local/executable_library.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -117,11 +118,16 @@ bool iree_hal_query_any_executable_loader_support(
 // features and cooperation of both the compiler producing the executables and
 // the runtime loader and system are required.
 //
+// The optional |environment| describes the host the executable will run on and
+// is provided to libraries when they are queried so that they may select code
+// specialized for it. If NULL the environment of the hosting process is used.
+//
 // Returns IREE_STATUS_CANCELLED when the loader cannot load the file in the
 // given format.
 iree_status_t iree_hal_executable_loader_try_load(
     iree_hal_executable_loader_t* executable_loader,
     const iree_hal_executable_spec_t* executable_spec,
+    const iree_hal_executable_environment_v0_t* environment,
     iree_hal_executable_t** out_executable);
 
 //===----------------------------------------------------------------------===//
@@ -139,6 +145,7 @@ typedef struct iree_hal_executable_loader_vtable_t {
   iree_status_t(IREE_API_PTR* try_load)(
       iree_hal_executable_loader_t* executable_loader,
       const iree_hal_executable_spec_t* executable_spec,
+      const iree_hal_executable_environment_v0_t* environment,
       iree_hal_executable_t** out_executable);
 } iree_hal_executable_loader_vtable_t;
 
@@ -28,6 +28,12 @@ typedef struct iree_hal_inline_command_buffer_t {
   iree_hal_command_buffer_t base;
   iree_allocator_t host_allocator;
 
+  // Optional parallel-for used to split the workgroups of large dispatches.
+  const iree_hal_parallel_for_t* parallel_for;
+
+  // Optional device profiler that dispatches report their execution times to.
+  iree_hal_dispatch_profiler_t* profiler;
+
   struct {
     // A flattened list of all available descriptor set bindings.
     // As descriptor sets are pushed/bound the bindings will be updated to
@@ -84,7 +90,9 @@ static void iree_hal_inline_command_buffer_reset(
 iree_status_t iree_hal_inline_command_buffer_create(
     iree_hal_device_t* device, iree_hal_command_buffer_mode_t mode,
     iree_hal_command_category_t command_categories,
-    iree_hal_queue_affinity_t queue_affinity, iree_allocator_t host_allocator,
+    iree_hal_queue_affinity_t queue_affinity,
+    const iree_hal_parallel_for_t* parallel_for,
+    iree_hal_dispatch_profiler_t* profiler, iree_allocator_t host_allocator,
     iree_hal_command_buffer_t** out_command_buffer) {
   IREE_ASSERT_ARGUMENT(out_command_buffer);
   *out_command_buffer = NULL;
@@ -109,6 +117,9 @@ iree_status_t iree_hal_inline_command_buffer_create(
         device, mode, command_categories, queue_affinity,
         &iree_hal_inline_command_buffer_vtable, &command_buffer->base);
     command_buffer->host_allocator = host_allocator;
+    command_buffer->parallel_for =
+        iree_hal_parallel_for_is_available(parallel_for) ? parallel_for : NULL;
+    command_buffer->profiler = profiler;
     iree_hal_inline_command_buffer_reset(command_buffer);
 
     *out_command_buffer = &command_buffer->base;
@@ -378,6 +389,114 @@ static iree_status_t iree_hal_inline_command_buffer_bind_descriptor_set(
 // iree_hal_command_buffer_dispatch
 //===----------------------------------------------------------------------===//
 
+// State shared by all workgroups of a dispatch split across a parallel-for.
+typedef struct iree_hal_inline_parallel_dispatch_t {
+  iree_hal_local_executable_t* executable;
+  int32_t entry_point;
+  const iree_hal_executable_dispatch_state_v0_t* dispatch_state;
+  // FPU state required by the dispatch.
+  iree_fpu_state_flags_t fpu_flags;
+  // Local memory of |local_memory_size| bytes per worker.
+  uint8_t* local_memory_base;
+  iree_host_size_t local_memory_size;
+} iree_hal_inline_parallel_dispatch_t;
+
+static iree_status_t IREE_API_PTR iree_hal_inline_parallel_dispatch_item(
+    void* user_data, iree_host_size_t worker_index, uint32_t item_index) {
+  const iree_hal_inline_parallel_dispatch_t* dispatch =
+      (const iree_hal_inline_parallel_dispatch_t*)user_data;
+  const iree_hal_vec3_t workgroup_count =
+      dispatch->dispatch_state->workgroup_count;
+  iree_hal_vec3_t workgroup_id;
+  workgroup_id.x = item_index % workgroup_count.x;
+  workgroup_id.y = (item_index / workgroup_count.x) % workgroup_count.y;
+  workgroup_id.z = item_index / (workgroup_count.x * workgroup_count.y);
+  iree_byte_span_t local_memory = iree_make_byte_span(
+      dispatch->local_memory_base
+          ? dispatch->local_memory_base +
+                worker_index * dispatch->local_memory_size
+          : NULL,
+      dispatch->local_memory_size);
+  // Workers are borrowed threads just like the caller; see below.
+  iree_fpu_state_t fpu_state = iree_fpu_state_push(dispatch->fpu_flags);
+  iree_status_t status = iree_hal_local_executable_issue_call(
+      dispatch->executable, dispatch->entry_point, dispatch->dispatch_state,
+      &workgroup_id, local_memory);
+  iree_fpu_state_pop(fpu_state);
+  return status;
+}
+
+// Executes the workgroups of the dispatch described by |dispatch_state| across
+// |parallel_for| and returns once all have completed.
+static iree_status_t iree_hal_inline_command_buffer_dispatch_parallel(
+    iree_hal_inline_command_buffer_t* command_buffer,
+    iree_hal_local_executable_t* local_executable, int32_t entry_point,
+    const iree_hal_executable_dispatch_state_v0_t* dispatch_state,
+    iree_fpu_state_flags_t fpu_flags, uint32_t workgroup_total,
+    iree_host_size_t local_memory_size) {
+  const iree_hal_parallel_for_t* parallel_for = command_buffer->parallel_for;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, workgroup_total);
+
+  iree_hal_inline_parallel_dispatch_t dispatch = {
+      .executable = local_executable,
+      .entry_point = entry_point,
+      .dispatch_state = dispatch_state,
+      .fpu_flags = fpu_flags,
+      .local_memory_base = NULL,
+      .local_memory_size = local_memory_size,
+  };
+  if (local_memory_size > 0) {
+    IREE_RETURN_AND_END_ZONE_IF_ERROR(
+        z0, iree_allocator_malloc(command_buffer->host_allocator,
+                                  local_memory_size * parallel_for->concurrency,
+                                  (void**)&dispatch.local_memory_base));
+  }
+
+  iree_status_t status =
+      parallel_for->run(parallel_for->self, workgroup_total,
+                        iree_hal_inline_parallel_dispatch_item, &dispatch);
+
+  iree_allocator_free(command_buffer->host_allocator,
+                      dispatch.local_memory_base);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Executes all workgroups of the dispatch described by |dispatch_state| on the
+// calling thread.
+static iree_status_t iree_hal_inline_command_buffer_dispatch_serial(
+    iree_hal_inline_command_buffer_t* command_buffer,
+    iree_hal_local_executable_t* local_executable, int32_t entry_point,
+    iree_hal_executable_dispatch_state_v0_t* dispatch_state,
+    iree_fpu_state_flags_t fpu_flags, iree_host_size_t local_memory_size) {
+  // TODO(benvanik): plumb through an arena or fixed-size reservation to use.
+  // For now when deploying to devices where you want something like the
+  // inline command buffer you probably don't want 256KB of transient memory
+  // getting allocated and retained implicitly - this should be a compiler
+  // option. For now we just malloc here to make things work and strongly
+  // encourage the kind of user who wants synchronous inline execution to not
+  // also want tons of scratch memory.
+  iree_byte_span_t local_memory = iree_make_byte_span(NULL, local_memory_size);
+  if (local_memory_size > 0) {
+    IREE_RETURN_IF_ERROR(iree_allocator_malloc(command_buffer->host_allocator,
+                                               local_memory_size,
+                                               (void**)&local_memory.data));
+  }
+
+  // Since we are running on a borrowed thread, we know nothing about the
+  // floating point state. Reset it.
+  iree_fpu_state_t fpu_state = iree_fpu_state_push(fpu_flags);
+  iree_status_t status = iree_hal_local_executable_issue_dispatch_inline(
+      local_executable, entry_point, dispatch_state, local_memory);
+  iree_fpu_state_pop(fpu_state);
+
+  if (local_memory.data) {
+    iree_allocator_free(command_buffer->host_allocator, local_memory.data);
+  }
+  return status;
+}
+
 static iree_status_t iree_hal_inline_command_buffer_dispatch(
     iree_hal_command_buffer_t* base_command_buffer,
     iree_hal_executable_t* executable, int32_t entry_point,
@@ -387,6 +506,8 @@ static iree_status_t iree_hal_inline_command_buffer_dispatch(
 
   iree_hal_local_executable_t* local_executable =
       iree_hal_local_executable_cast(executable);
+  IREE_RETURN_IF_ERROR(
+      iree_hal_local_executable_ensure_loaded(local_executable));
   iree_hal_local_executable_layout_t* local_layout =
       local_executable->executable_layouts[entry_point];
   iree_host_size_t local_memory_size =
@@ -395,6 +516,15 @@ static iree_status_t iree_hal_inline_command_buffer_dispatch(
                 IREE_HAL_WORKGROUP_LOCAL_MEMORY_PAGE_SIZE
           : 0;
 
+  // Denormals are flushed to zero unless the dispatch requires otherwise.
+  iree_fpu_state_flags_t fpu_flags =
+      local_executable->dispatch_attrs &&
+              iree_all_bits_set(
+                  local_executable->dispatch_attrs[entry_point].flags,
+                  IREE_HAL_EXECUTABLE_DISPATCH_FLAG_V0_PRESERVE_DENORMALS)
+          ? IREE_FPU_STATE_DEFAULT
+          : IREE_FPU_STATE_FLAG_FLUSH_DENORMALS_TO_ZERO;
+
   iree_hal_executable_dispatch_state_v0_t* dispatch_state =
       &command_buffer->state.dispatch_state;
   dispatch_state->import_thunk = local_executable->import_thunk;
@@ -442,30 +572,44 @@ static iree_status_t iree_hal_inline_command_buffer_dispatch(
         command_buffer->state.full_binding_lengths[binding_ordinal];
   }
 
-  // TODO(benvanik): plumb through an arena or fixed-size reservation to use.
-  // For now when deploying to devices where you want something like the
-  // inline command buffer you probably don't want 256KB of transient memory
-  // getting allocated and retained implicitly - this should be a compiler
-  // option. For now we just malloc here to make things work and strongly
-  // encourage the kind of user who wants synchronous inline execution to not
-  // also want tons of scratch memory.
-  iree_byte_span_t local_memory = iree_make_byte_span(NULL, local_memory_size);
-  if (local_memory_size > 0) {
-    IREE_RETURN_IF_ERROR(iree_allocator_malloc(command_buffer->host_allocator,
-                                               local_memory_size,
-                                               (void**)&local_memory.data));
+  // Timestamps are taken on the calling thread which waits for all workgroups
+  // to complete, including any split across the parallel-for.
+  const bool profiling =
+      command_buffer->profiler &&
+      iree_hal_dispatch_profiler_is_active(command_buffer->profiler);
+  iree_time_t begin_time_ns = profiling ? iree_time_now() : 0;
+
+  // Large dispatches are split across the parallel-for, if available. The
+  // workgroups are linearized and must fit in the item index.
+  uint64_t workgroup_total =
+      (uint64_t)workgroup_x * (uint64_t)workgroup_y * (uint64_t)workgroup_z;
+  iree_status_t status = iree_ok_status();
+  if (command_buffer->parallel_for &&
+      workgroup_total >= command_buffer->parallel_for->min_item_count &&
+      workgroup_total <= UINT32_MAX) {
+    status = iree_hal_inline_command_buffer_dispatch_parallel(
+        command_buffer, local_executable, entry_point, dispatch_state,
+        fpu_flags, (uint32_t)workgroup_total, local_memory_size);
+  } else {
+    status = iree_hal_inline_command_buffer_dispatch_serial(
+        command_buffer, local_executable, entry_point, dispatch_state,
+        fpu_flags, local_memory_size);
   }
 
-  // Since we are running on a borrowed thread, we know nothing about the
-  // floating point state. Reset it.
-  iree_fpu_state_t fpu_state =
-      iree_fpu_state_push(IREE_FPU_STATE_FLAG_FLUSH_DENORMALS_TO_ZERO);
-  iree_status_t status = iree_hal_local_executable_issue_dispatch_inline(
-      local_executable, entry_point, dispatch_state, local_memory);
-  iree_fpu_state_pop(fpu_state);
-
-  if (local_memory.data) {
-    iree_allocator_free(command_buffer->host_allocator, local_memory.data);
+  if (profiling && iree_status_is_ok(status)) {
+    iree_hal_device_profiling_dispatch_t dispatch;
+    const char* const* names = local_executable->entry_point_names;
+    dispatch.entry_point_name = names && names[entry_point]
+                                    ? iree_make_cstring_view(names[entry_point])
+                                    : iree_string_view_empty();
+    dispatch.entry_point = (uint32_t)entry_point;
+    dispatch.workgroup_count[0] = workgroup_x;
+    dispatch.workgroup_count[1] = workgroup_y;
+    dispatch.workgroup_count[2] = workgroup_z;
+    dispatch.begin_time_ns = begin_time_ns;
+    dispatch.end_time_ns = iree_time_now();
+    dispatch.invocation_count = 0;
+    iree_hal_dispatch_profiler_append(command_buffer->profiler, &dispatch);
   }
   return status;
 }
@@ -9,24 +9,84 @@
 
 #include "iree/base/api.h"
 #include "iree/hal/api.h"
+#include "iree/hal/utils/dispatch_profiler.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif  // __cplusplus
 
-// Creates an inline synchronous one-shot single-threaded command "buffer".
+//===----------------------------------------------------------------------===//
+// iree_hal_parallel_for_t
+//===----------------------------------------------------------------------===//
+
+// Executes work item |item_index| on behalf of iree_hal_parallel_for_t::run.
+// |worker_index| is unique among the concurrently executing items and in the
+// range [0, concurrency) such that it can be used to select per-worker scratch
+// storage.
+typedef iree_status_t(IREE_API_PTR* iree_hal_parallel_for_item_fn_t)(
+    void* user_data, iree_host_size_t worker_index, uint32_t item_index);
+
+// A fork-join parallel-for used by inline command buffers to split the
+// workgroups of large dispatches across threads. There's no task graph or
+// scheduling involved: |run| must execute all items and return only once they
+// have completed.
+//
+// This is an interface so that the inline command buffer and the devices using
+// it remain usable in environments without threads.
+typedef struct iree_hal_parallel_for_t {
+  void* self;
+
+  // Maximum number of items executed concurrently by |run|, including any run
+  // on the calling thread. 0 if no parallel-for is available.
+  iree_host_size_t concurrency;
+
+  // Dispatches with fewer workgroups than this are executed entirely on the
+  // calling thread as the fork-join would cost more than it saves.
+  uint32_t min_item_count;
+
+  void(IREE_API_PTR* retain)(void* self);
+  void(IREE_API_PTR* release)(void* self);
+
+  // Executes |item_count| items by calling |item_fn| for each. Returns the
+  // first failure of any item; items not yet started when a failure occurs may
+  // be skipped.
+  iree_status_t(IREE_API_PTR* run)(void* self, uint32_t item_count,
+                                   iree_hal_parallel_for_item_fn_t item_fn,
+                                   void* user_data);
+} iree_hal_parallel_for_t;
+
+// Returns true if |parallel_for| is available for use.
+static inline bool iree_hal_parallel_for_is_available(
+    const iree_hal_parallel_for_t* parallel_for) {
+  return parallel_for && parallel_for->run && parallel_for->concurrency > 1;
+}
+
+//===----------------------------------------------------------------------===//
+// iree_hal_inline_command_buffer_t
+//===----------------------------------------------------------------------===//
+
+// Creates an inline synchronous one-shot command "buffer".
 // This is designed for ultra-low latency situations where we know the command
 // buffer is going to be submitted with no wait semaphores indicating that it
 // can begin execution immediately. No inter-command-buffer scheduling will be
 // performed and all barriers and events are ignored.
 //
-// Executes all work on the calling thread synchronously (today).
+// Executes all commands on the calling thread synchronously in order. If
+// |parallel_for| is provided then the workgroups of dispatches with at least
+// |parallel_for->min_item_count| workgroups are split across it; the calling
+// thread still waits for each dispatch to complete before moving on. The
+// |parallel_for| must remain valid for the lifetime of the command buffer.
+//
+// Dispatches report their execution times to |profiler| when it is active.
+// The |profiler| is optional and must outlive the command buffer if provided.
 //
 // Must have IREE_HAL_COMMAND_BUFFER_MODE_ALLOW_INLINE_EXECUTION set.
 iree_status_t iree_hal_inline_command_buffer_create(
     iree_hal_device_t* device, iree_hal_command_buffer_mode_t mode,
     iree_hal_command_category_t command_categories,
-    iree_hal_queue_affinity_t queue_affinity, iree_allocator_t host_allocator,
+    iree_hal_queue_affinity_t queue_affinity,
+    const iree_hal_parallel_for_t* parallel_for,
+    iree_hal_dispatch_profiler_t* profiler, iree_allocator_t host_allocator,
     iree_hal_command_buffer_t** out_command_buffer);
 
 // Returns true if |command_buffer| is an inline command buffer.
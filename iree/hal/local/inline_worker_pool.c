@@ -0,0 +1,293 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/local/inline_worker_pool.h"
+
+#include <string.h>
+
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/internal/threading.h"
+#include "iree/base/tracing.h"
+
+typedef struct iree_hal_inline_worker_t {
+  iree_hal_inline_worker_pool_t* pool;
+  iree_host_size_t worker_index;
+  // Epoch of the last job the worker participated in.
+  int32_t epoch;
+  iree_thread_t* thread;
+} iree_hal_inline_worker_t;
+
+struct iree_hal_inline_worker_pool_t {
+  iree_atomic_ref_count_t ref_count;
+  iree_allocator_t host_allocator;
+  uint32_t min_item_count;
+
+  // Held by the caller of the job currently executing on the workers.
+  iree_slim_mutex_t job_mutex;
+
+  // Posted when |epoch| is advanced for a new job or |exit_requested| is set.
+  iree_notification_t job_notification;
+  // Posted when the last worker has finished the current job.
+  iree_notification_t done_notification;
+  // Posted when the last worker has returned from its thread main.
+  iree_notification_t exit_notification;
+
+  iree_atomic_int32_t epoch;
+  iree_atomic_int32_t exit_requested;
+  // Number of workers that have not yet returned from their thread main.
+  iree_atomic_int32_t live_worker_count;
+
+  // Current job; only valid while |job_mutex| is held.
+  iree_hal_parallel_for_item_fn_t item_fn;
+  void* user_data;
+  uint32_t item_count;
+  iree_atomic_int32_t next_item;
+  iree_atomic_int32_t active_worker_count;
+  // First failure of the current job (iree_status_t).
+  iree_atomic_intptr_t failure_status;
+
+  iree_host_size_t worker_count;
+  iree_hal_inline_worker_t workers[];
+};
+
+static void iree_hal_inline_worker_pool_try_set_failure(
+    iree_hal_inline_worker_pool_t* pool, iree_status_t new_status) {
+  iree_status_t old_status = iree_ok_status();
+  if (!iree_atomic_compare_exchange_strong_intptr(
+          &pool->failure_status, (intptr_t*)&old_status, (intptr_t)new_status,
+          iree_memory_order_acq_rel, iree_memory_order_relaxed)) {
+    // Previous status was not OK; drop our new status.
+    IREE_IGNORE_ERROR(new_status);
+  }
+}
+
+// Claims and executes items of the current job until all have been claimed or
+// any item has failed.
+static void iree_hal_inline_worker_pool_execute_items(
+    iree_hal_inline_worker_pool_t* pool, iree_host_size_t worker_index) {
+  while (!iree_atomic_load_intptr(&pool->failure_status,
+                                  iree_memory_order_relaxed)) {
+    uint32_t item_index = (uint32_t)iree_atomic_fetch_add_int32(
+        &pool->next_item, 1, iree_memory_order_relaxed);
+    if (item_index >= pool->item_count) break;
+    iree_status_t status =
+        pool->item_fn(pool->user_data, worker_index, item_index);
+    if (!iree_status_is_ok(status)) {
+      iree_hal_inline_worker_pool_try_set_failure(pool, status);
+    }
+  }
+}
+
+static bool iree_hal_inline_worker_has_job(void* arg) {
+  iree_hal_inline_worker_t* worker = (iree_hal_inline_worker_t*)arg;
+  iree_hal_inline_worker_pool_t* pool = worker->pool;
+  return iree_atomic_load_int32(&pool->exit_requested,
+                                iree_memory_order_acquire) ||
+         iree_atomic_load_int32(&pool->epoch, iree_memory_order_acquire) !=
+             worker->epoch;
+}
+
+static int iree_hal_inline_worker_main(void* entry_arg) {
+  iree_hal_inline_worker_t* worker = (iree_hal_inline_worker_t*)entry_arg;
+  iree_hal_inline_worker_pool_t* pool = worker->pool;
+  for (;;) {
+    iree_notification_await(&pool->job_notification,
+                            iree_hal_inline_worker_has_job, worker,
+                            iree_infinite_timeout());
+    if (iree_atomic_load_int32(&pool->exit_requested,
+                               iree_memory_order_acquire)) {
+      break;
+    }
+
+    // The caller waits for all workers to finish each job before publishing
+    // the next and as such each worker observes every epoch.
+    ++worker->epoch;
+    IREE_TRACE_ZONE_BEGIN(z0);
+    iree_hal_inline_worker_pool_execute_items(pool, worker->worker_index);
+    IREE_TRACE_ZONE_END(z0);
+
+    if (iree_atomic_fetch_sub_int32(&pool->active_worker_count, 1,
+                                    iree_memory_order_acq_rel) == 1) {
+      iree_notification_post(&pool->done_notification, IREE_ALL_WAITERS);
+    }
+  }
+  if (iree_atomic_fetch_sub_int32(&pool->live_worker_count, 1,
+                                  iree_memory_order_acq_rel) == 1) {
+    iree_notification_post(&pool->exit_notification, IREE_ALL_WAITERS);
+  }
+  return 0;
+}
+
+static void iree_hal_inline_worker_pool_destroy(
+    iree_hal_inline_worker_pool_t* pool);
+
+iree_status_t iree_hal_inline_worker_pool_create(
+    iree_host_size_t worker_count, uint32_t min_item_count,
+    iree_allocator_t host_allocator, iree_hal_inline_worker_pool_t** out_pool) {
+  IREE_ASSERT_ARGUMENT(out_pool);
+  *out_pool = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)worker_count);
+
+  iree_hal_inline_worker_pool_t* pool = NULL;
+  iree_host_size_t total_size =
+      sizeof(*pool) + worker_count * sizeof(pool->workers[0]);
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, total_size, (void**)&pool));
+  memset(pool, 0, total_size);
+  iree_atomic_ref_count_init(&pool->ref_count);
+  pool->host_allocator = host_allocator;
+  pool->min_item_count = min_item_count;
+  iree_slim_mutex_initialize(&pool->job_mutex);
+  iree_notification_initialize(&pool->job_notification);
+  iree_notification_initialize(&pool->done_notification);
+  iree_notification_initialize(&pool->exit_notification);
+
+  iree_status_t status = iree_ok_status();
+  for (iree_host_size_t i = 0; i < worker_count; ++i) {
+    iree_hal_inline_worker_t* worker = &pool->workers[i];
+    worker->pool = pool;
+    worker->worker_index = i;
+    iree_thread_create_params_t thread_params;
+    memset(&thread_params, 0, sizeof(thread_params));
+    thread_params.name = iree_make_cstring_view("iree-hal-inline-worker");
+    iree_atomic_fetch_add_int32(&pool->live_worker_count, 1,
+                                iree_memory_order_relaxed);
+    status = iree_thread_create(iree_hal_inline_worker_main, worker,
+                                thread_params, host_allocator, &worker->thread);
+    if (!iree_status_is_ok(status)) {
+      iree_atomic_fetch_sub_int32(&pool->live_worker_count, 1,
+                                  iree_memory_order_relaxed);
+      break;
+    }
+    ++pool->worker_count;
+  }
+
+  if (iree_status_is_ok(status)) {
+    *out_pool = pool;
+  } else {
+    iree_hal_inline_worker_pool_destroy(pool);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static bool iree_hal_inline_worker_pool_has_exited(void* arg) {
+  iree_hal_inline_worker_pool_t* pool = (iree_hal_inline_worker_pool_t*)arg;
+  return iree_atomic_load_int32(&pool->live_worker_count,
+                                iree_memory_order_acquire) == 0;
+}
+
+static void iree_hal_inline_worker_pool_destroy(
+    iree_hal_inline_worker_pool_t* pool) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Wake all workers and wait for them to return from their thread main. A
+  // thread that has not yet started still holds its own reference such that
+  // releasing ours would not join it and it could observe the freed pool.
+  iree_atomic_store_int32(&pool->exit_requested, 1, iree_memory_order_release);
+  iree_notification_post(&pool->job_notification, IREE_ALL_WAITERS);
+  iree_notification_await(&pool->exit_notification,
+                          iree_hal_inline_worker_pool_has_exited, pool,
+                          iree_infinite_timeout());
+  for (iree_host_size_t i = 0; i < pool->worker_count; ++i) {
+    iree_thread_release(pool->workers[i].thread);
+  }
+
+  iree_notification_deinitialize(&pool->exit_notification);
+  iree_notification_deinitialize(&pool->done_notification);
+  iree_notification_deinitialize(&pool->job_notification);
+  iree_slim_mutex_deinitialize(&pool->job_mutex);
+  iree_allocator_free(pool->host_allocator, pool);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+void iree_hal_inline_worker_pool_retain(iree_hal_inline_worker_pool_t* pool) {
+  if (pool) {
+    iree_atomic_ref_count_inc(&pool->ref_count);
+  }
+}
+
+void iree_hal_inline_worker_pool_release(iree_hal_inline_worker_pool_t* pool) {
+  if (pool && iree_atomic_ref_count_dec(&pool->ref_count) == 1) {
+    iree_hal_inline_worker_pool_destroy(pool);
+  }
+}
+
+static bool iree_hal_inline_worker_pool_is_done(void* arg) {
+  iree_hal_inline_worker_pool_t* pool = (iree_hal_inline_worker_pool_t*)arg;
+  return iree_atomic_load_int32(&pool->active_worker_count,
+                                iree_memory_order_acquire) == 0;
+}
+
+static iree_status_t iree_hal_inline_worker_pool_run(
+    void* self, uint32_t item_count, iree_hal_parallel_for_item_fn_t item_fn,
+    void* user_data) {
+  iree_hal_inline_worker_pool_t* pool = (iree_hal_inline_worker_pool_t*)self;
+
+  // Run on the calling thread if there's nothing to split or another caller is
+  // already using the workers. Worker index 0 is safe to reuse as scratch
+  // storage is owned by each caller.
+  if (item_count <= 1 || !iree_slim_mutex_try_lock(&pool->job_mutex)) {
+    for (uint32_t i = 0; i < item_count; ++i) {
+      IREE_RETURN_IF_ERROR(item_fn(user_data, 0, i));
+    }
+    return iree_ok_status();
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)item_count);
+
+  // Publish the job; the release on |epoch| makes the fields visible to the
+  // workers that observe the new epoch.
+  pool->item_fn = item_fn;
+  pool->user_data = user_data;
+  pool->item_count = item_count;
+  iree_atomic_store_int32(&pool->next_item, 0, iree_memory_order_relaxed);
+  iree_atomic_store_intptr(&pool->failure_status, (intptr_t)iree_ok_status(),
+                           iree_memory_order_relaxed);
+  iree_atomic_store_int32(&pool->active_worker_count,
+                          (int32_t)pool->worker_count,
+                          iree_memory_order_relaxed);
+  iree_atomic_fetch_add_int32(&pool->epoch, 1, iree_memory_order_release);
+  iree_notification_post(&pool->job_notification, IREE_ALL_WAITERS);
+
+  // The calling thread takes the last worker index.
+  iree_hal_inline_worker_pool_execute_items(pool, pool->worker_count);
+  iree_notification_await(&pool->done_notification,
+                          iree_hal_inline_worker_pool_is_done, pool,
+                          iree_infinite_timeout());
+
+  iree_status_t status = (iree_status_t)iree_atomic_exchange_intptr(
+      &pool->failure_status, (intptr_t)iree_ok_status(),
+      iree_memory_order_acquire);
+  iree_slim_mutex_unlock(&pool->job_mutex);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_inline_worker_pool_retain_self(void* self) {
+  iree_hal_inline_worker_pool_retain((iree_hal_inline_worker_pool_t*)self);
+}
+
+static void iree_hal_inline_worker_pool_release_self(void* self) {
+  iree_hal_inline_worker_pool_release((iree_hal_inline_worker_pool_t*)self);
+}
+
+iree_hal_parallel_for_t iree_hal_inline_worker_pool_parallel_for(
+    iree_hal_inline_worker_pool_t* pool) {
+  iree_hal_parallel_for_t parallel_for;
+  memset(&parallel_for, 0, sizeof(parallel_for));
+  if (!pool) return parallel_for;
+  parallel_for.self = pool;
+  parallel_for.concurrency = pool->worker_count + 1;
+  parallel_for.min_item_count = pool->min_item_count;
+  parallel_for.retain = iree_hal_inline_worker_pool_retain_self;
+  parallel_for.release = iree_hal_inline_worker_pool_release_self;
+  parallel_for.run = iree_hal_inline_worker_pool_run;
+  return parallel_for;
+}
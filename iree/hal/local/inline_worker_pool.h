@@ -0,0 +1,52 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_LOCAL_INLINE_WORKER_POOL_H_
+#define IREE_HAL_LOCAL_INLINE_WORKER_POOL_H_
+
+#include "iree/base/api.h"
+#include "iree/hal/local/inline_command_buffer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// A minimal fork-join thread pool implementing iree_hal_parallel_for_t for
+// inline command buffers.
+//
+// Each parallel-for publishes its items to the pool, wakes the workers, and
+// executes items on the calling thread alongside them. Items are claimed with
+// a single atomic increment and the caller returns once the last worker has
+// finished: there are no tasks, queues, or dependency tracking. Only one
+// parallel-for runs at a time; concurrent callers (such as submissions from
+// multiple threads to the same device) execute their items serially on their
+// own thread instead of waiting for the pool.
+typedef struct iree_hal_inline_worker_pool_t iree_hal_inline_worker_pool_t;
+
+// Creates a pool with |worker_count| threads in addition to the calling thread
+// of each parallel-for. The pool is reference counted and returned with a
+// single reference held by the caller.
+iree_status_t iree_hal_inline_worker_pool_create(
+    iree_host_size_t worker_count, uint32_t min_item_count,
+    iree_allocator_t host_allocator, iree_hal_inline_worker_pool_t** out_pool);
+
+// Retains the given |pool| for the caller.
+void iree_hal_inline_worker_pool_retain(iree_hal_inline_worker_pool_t* pool);
+
+// Releases the given |pool| from the caller. The worker threads are joined
+// when the last reference is released.
+void iree_hal_inline_worker_pool_release(iree_hal_inline_worker_pool_t* pool);
+
+// Returns a parallel-for interface executing on |pool|. The interface does not
+// hold a reference; users must retain it through the interface as needed.
+iree_hal_parallel_for_t iree_hal_inline_worker_pool_parallel_for(
+    iree_hal_inline_worker_pool_t* pool);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_LOCAL_INLINE_WORKER_POOL_H_
@@ -0,0 +1,169 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/local/inline_worker_pool.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace {
+
+// Records the items executed by a single parallel-for and checks that
+// concurrently executing items never share a worker index.
+struct ItemRecorder {
+  explicit ItemRecorder(uint32_t item_count, iree_host_size_t concurrency)
+      : item_counts(item_count), worker_in_use(concurrency) {}
+
+  static iree_status_t Execute(void* user_data, iree_host_size_t worker_index,
+                               uint32_t item_index) {
+    auto* recorder = reinterpret_cast<ItemRecorder*>(user_data);
+    if (worker_index >= recorder->worker_in_use.size()) {
+      return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                              "worker index %" PRIhsz " out of range",
+                              worker_index);
+    }
+    if (recorder->worker_in_use[worker_index].exchange(true)) {
+      return iree_make_status(IREE_STATUS_ALREADY_EXISTS,
+                              "worker index %" PRIhsz " in use", worker_index);
+    }
+    recorder->item_counts[item_index].fetch_add(1);
+    recorder->worker_in_use[worker_index].store(false);
+    return iree_ok_status();
+  }
+
+  void ExpectAllItemsExecutedOnce() {
+    for (size_t i = 0; i < item_counts.size(); ++i) {
+      EXPECT_EQ(1, item_counts[i].load()) << "item " << i;
+    }
+  }
+
+  std::vector<std::atomic<int>> item_counts;
+  std::vector<std::atomic<bool>> worker_in_use;
+};
+
+class InlineWorkerPoolTest : public ::testing::TestWithParam<iree_host_size_t> {
+ protected:
+  void SetUp() override {
+    IREE_ASSERT_OK(iree_hal_inline_worker_pool_create(
+        GetParam(), /*min_item_count=*/2, iree_allocator_system(), &pool_));
+    parallel_for_ = iree_hal_inline_worker_pool_parallel_for(pool_);
+  }
+
+  void TearDown() override { iree_hal_inline_worker_pool_release(pool_); }
+
+  iree_status_t Run(uint32_t item_count, iree_hal_parallel_for_item_fn_t fn,
+                    void* user_data) {
+    return parallel_for_.run(parallel_for_.self, item_count, fn, user_data);
+  }
+
+  iree_hal_inline_worker_pool_t* pool_ = NULL;
+  iree_hal_parallel_for_t parallel_for_;
+};
+
+TEST_P(InlineWorkerPoolTest, Interface) {
+  EXPECT_EQ(GetParam() + 1, parallel_for_.concurrency);
+  EXPECT_EQ(2u, parallel_for_.min_item_count);
+  EXPECT_EQ(GetParam() > 0,
+            iree_hal_parallel_for_is_available(&parallel_for_));
+}
+
+// Runs jobs of various sizes, including those smaller than the pool, and
+// checks that each item is executed exactly once per job.
+TEST_P(InlineWorkerPoolTest, ItemCoverage) {
+  for (uint32_t item_count : {0u, 1u, 2u, 3u, 7u, 64u, 1000u}) {
+    ItemRecorder recorder(item_count, parallel_for_.concurrency);
+    IREE_ASSERT_OK(Run(item_count, ItemRecorder::Execute, &recorder));
+    recorder.ExpectAllItemsExecutedOnce();
+  }
+}
+
+// Runs many small jobs back to back to exercise workers observing each epoch.
+TEST_P(InlineWorkerPoolTest, RepeatedJobs) {
+  for (int i = 0; i < 500; ++i) {
+    ItemRecorder recorder(16, parallel_for_.concurrency);
+    IREE_ASSERT_OK(Run(16, ItemRecorder::Execute, &recorder));
+    recorder.ExpectAllItemsExecutedOnce();
+  }
+}
+
+// Fails a single item and checks that the failure is returned from the job and
+// does not leak into the next job.
+TEST_P(InlineWorkerPoolTest, FailurePropagation) {
+  static const uint32_t kFailingItem = 37;
+  auto fail_item = [](void* user_data, iree_host_size_t worker_index,
+                      uint32_t item_index) -> iree_status_t {
+    auto* executed_count = reinterpret_cast<std::atomic<int>*>(user_data);
+    executed_count->fetch_add(1);
+    if (item_index == kFailingItem) {
+      return iree_make_status(IREE_STATUS_DATA_LOSS, "item %u", item_index);
+    }
+    return iree_ok_status();
+  };
+  std::atomic<int> executed_count = {0};
+  iree_status_t status = Run(100, fail_item, &executed_count);
+  EXPECT_EQ(IREE_STATUS_DATA_LOSS, iree_status_code(status));
+  iree_status_ignore(status);
+  EXPECT_GT(executed_count.load(), 0);
+  EXPECT_LE(executed_count.load(), 100);
+
+  ItemRecorder recorder(100, parallel_for_.concurrency);
+  IREE_ASSERT_OK(Run(100, ItemRecorder::Execute, &recorder));
+  recorder.ExpectAllItemsExecutedOnce();
+}
+
+// Fails every item and checks that exactly one failure is returned while the
+// others are dropped.
+TEST_P(InlineWorkerPoolTest, FailureInAllItems) {
+  auto fail_item = [](void* user_data, iree_host_size_t worker_index,
+                      uint32_t item_index) -> iree_status_t {
+    return iree_make_status(IREE_STATUS_DATA_LOSS, "item %u", item_index);
+  };
+  iree_status_t status = Run(100, fail_item, NULL);
+  EXPECT_EQ(IREE_STATUS_DATA_LOSS, iree_status_code(status));
+  iree_status_ignore(status);
+}
+
+// Runs jobs from multiple threads at once. Callers that find the pool busy
+// execute on their own thread; all items of every job must still run once.
+TEST_P(InlineWorkerPoolTest, ConcurrentCallers) {
+  static const int kCallerCount = 4;
+  static const int kJobCount = 50;
+  static const uint32_t kItemCount = 128;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kCallerCount; ++i) {
+    threads.emplace_back([&]() {
+      for (int j = 0; j < kJobCount; ++j) {
+        ItemRecorder recorder(kItemCount, parallel_for_.concurrency);
+        IREE_EXPECT_OK(Run(kItemCount, ItemRecorder::Execute, &recorder));
+        recorder.ExpectAllItemsExecutedOnce();
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+}
+
+// Releases the pool while another reference is held through the interface.
+TEST_P(InlineWorkerPoolTest, RetainThroughInterface) {
+  parallel_for_.retain(parallel_for_.self);
+  iree_hal_inline_worker_pool_release(pool_);
+  pool_ = NULL;
+  ItemRecorder recorder(64, parallel_for_.concurrency);
+  IREE_ASSERT_OK(Run(64, ItemRecorder::Execute, &recorder));
+  recorder.ExpectAllItemsExecutedOnce();
+  parallel_for_.release(parallel_for_.self);
+}
+
+INSTANTIATE_TEST_SUITE_P(WorkerCounts, InlineWorkerPoolTest,
+                         ::testing::Values(0, 1, 3));
+
+}  // namespace
@@ -9,10 +9,12 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "iree/base/tracing.h"
 #include "iree/hal/api.h"
 #include "iree/hal/local/elf/elf_module.h"
+#include "iree/hal/local/executable_environment.h"
 #include "iree/hal/local/executable_library.h"
 #include "iree/hal/local/local_executable.h"
 #include "iree/hal/local/local_executable_layout.h"
@@ -24,6 +26,14 @@
 typedef struct iree_hal_elf_executable_t {
   iree_hal_local_executable_t base;
 
+  // State retained for loading. When the load is deferred the ELF data is
+  // aliased and the loader is retained so that its import provider remains
+  // valid until the first dispatch.
+  iree_hal_executable_caching_mode_t caching_mode;
+  iree_const_byte_span_t elf_data;
+  iree_hal_executable_loader_t* loader;
+  iree_hal_executable_environment_v0_t environment;
+
   // Loaded ELF module.
   iree_elf_module_t module;
 
@@ -49,11 +59,11 @@ static iree_status_t iree_hal_elf_executable_query_library(
       &executable->module, IREE_HAL_EXECUTABLE_LIBRARY_EXPORT_NAME,
       (void**)&query_fn));
 
-  // Query for a compatible version of the library.
+  // Query for a compatible version of the library specialized for the host.
   executable->library.header =
       (const iree_hal_executable_library_header_t**)iree_elf_call_p_ip(
           query_fn, IREE_HAL_EXECUTABLE_LIBRARY_LATEST_VERSION,
-          /*reserved=*/NULL);
+          &executable->environment);
   if (!executable->library.header) {
     return iree_make_status(
         IREE_STATUS_FAILED_PRECONDITION,
@@ -82,6 +92,10 @@ static iree_status_t iree_hal_elf_executable_query_library(
   executable->identifier = iree_make_cstring_view(header->name);
 
   executable->base.dispatch_attrs = executable->library.v0->exports.attrs;
+  executable->base.entry_point_names = executable->library.v0->exports.names;
+  executable->base.dispatch_costs = executable->library.v0->exports.costs;
+  executable->base.dispatch_range_ptrs =
+      executable->library.v0->exports.range_ptrs;
 
   return iree_ok_status();
 }
@@ -124,62 +138,100 @@ static iree_status_t iree_hal_elf_executable_resolve_imports(
   return iree_ok_status();
 }
 
-static iree_status_t iree_hal_elf_executable_create(
-    iree_hal_executable_caching_mode_t caching_mode,
-    iree_const_byte_span_t elf_data, iree_host_size_t executable_layout_count,
-    iree_hal_executable_layout_t* const* executable_layouts,
-    const iree_hal_executable_import_provider_t import_provider,
-    iree_allocator_t host_allocator, iree_hal_executable_t** out_executable) {
-  IREE_ASSERT_ARGUMENT(elf_data.data && elf_data.data_length);
-  IREE_ASSERT_ARGUMENT(!executable_layout_count || executable_layouts);
-  IREE_ASSERT_ARGUMENT(out_executable);
-  *out_executable = NULL;
+// Loads the ELF, queries the library, and resolves its imports. Dominates
+// executable creation time for large executables as the entire ELF is
+// relocated.
+static iree_status_t iree_hal_elf_executable_load(
+    iree_hal_local_executable_t* base_executable) {
+  iree_hal_elf_executable_t* executable =
+      (iree_hal_elf_executable_t*)base_executable;
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  // TODO(benvanik): rework this so that we load and query the library before
-  // allocating so that we know the import count. Today since we allocate first
-  // we need an additional allocation once we've seen the import table.
-  iree_hal_elf_executable_t* executable = NULL;
-  iree_host_size_t total_size =
-      sizeof(*executable) +
-      executable_layout_count * sizeof(*executable->layouts);
-  iree_status_t status =
-      iree_allocator_malloc(host_allocator, total_size, (void**)&executable);
-  if (iree_status_is_ok(status)) {
-    iree_hal_local_executable_initialize(
-        &iree_hal_elf_executable_vtable, executable_layout_count,
-        executable_layouts, &executable->layouts[0], host_allocator,
-        &executable->base);
-  }
-  if (iree_status_is_ok(status)) {
-    // Attempt to load the ELF module.
-    status = iree_elf_module_initialize_from_memory(
-        elf_data, /*import_table=*/NULL, host_allocator, &executable->module);
-  }
+  // Attempt to load the ELF module.
+  iree_status_t status = iree_elf_module_initialize_from_memory(
+      executable->elf_data, /*import_table=*/NULL,
+      executable->base.host_allocator, &executable->module);
   if (iree_status_is_ok(status)) {
     // Query metadata and get the entry point function pointers.
     status = iree_hal_elf_executable_query_library(executable);
   }
   if (iree_status_is_ok(status)) {
     // Resolve imports, if any.
-    status =
-        iree_hal_elf_executable_resolve_imports(executable, import_provider);
+    status = iree_hal_elf_executable_resolve_imports(
+        executable, executable->loader->import_provider);
   }
   if (iree_status_is_ok(status) &&
       !iree_all_bits_set(
-          caching_mode,
+          executable->caching_mode,
           IREE_HAL_EXECUTABLE_CACHING_MODE_DISABLE_VERIFICATION)) {
     // Check to make sure that the entry point count matches the layouts
     // provided.
-    if (executable->library.v0->exports.count != executable_layout_count) {
+    if (executable->library.v0->exports.count !=
+        executable->base.executable_layout_count) {
       status = iree_make_status(
           IREE_STATUS_FAILED_PRECONDITION,
           "executable provides %u entry points but caller "
           "provided %zu; must match",
-          executable->library.v0->exports.count, executable_layout_count);
+          executable->library.v0->exports.count,
+          executable->base.executable_layout_count);
     }
   }
 
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static iree_status_t iree_hal_elf_executable_create(
+    iree_hal_executable_caching_mode_t caching_mode,
+    iree_const_byte_span_t elf_data, iree_host_size_t executable_layout_count,
+    iree_hal_executable_layout_t* const* executable_layouts,
+    iree_hal_executable_loader_t* loader,
+    const iree_hal_executable_environment_v0_t* environment,
+    iree_allocator_t host_allocator, iree_hal_executable_t** out_executable) {
+  IREE_ASSERT_ARGUMENT(elf_data.data && elf_data.data_length);
+  IREE_ASSERT_ARGUMENT(!executable_layout_count || executable_layouts);
+  IREE_ASSERT_ARGUMENT(loader);
+  IREE_ASSERT_ARGUMENT(out_executable);
+  *out_executable = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // TODO(benvanik): rework this so that we load and query the library before
+  // allocating so that we know the import count. Today since we allocate first
+  // we need an additional allocation once we've seen the import table.
+  iree_hal_elf_executable_t* executable = NULL;
+  iree_host_size_t total_size =
+      sizeof(*executable) +
+      executable_layout_count * sizeof(*executable->layouts);
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0,
+      iree_allocator_malloc(host_allocator, total_size, (void**)&executable));
+  memset(executable, 0, total_size);
+  iree_hal_local_executable_initialize(
+      &iree_hal_elf_executable_vtable, executable_layout_count,
+      executable_layouts, &executable->layouts[0], host_allocator,
+      &executable->base);
+  executable->caching_mode = caching_mode;
+  executable->elf_data = elf_data;
+  executable->loader = loader;
+  iree_hal_executable_loader_retain(executable->loader);
+  if (environment) {
+    executable->environment = *environment;
+  } else {
+    iree_hal_executable_environment_initialize(&executable->environment);
+  }
+
+  // If the ELF data outlives the executable we can defer loading until the
+  // first dispatch. Executables that are never dispatched then cost only this
+  // allocation instead of their fully relocated image. Load errors are
+  // reported when the executable is first used.
+  iree_status_t status = iree_ok_status();
+  if (iree_all_bits_set(caching_mode,
+                        IREE_HAL_EXECUTABLE_CACHING_MODE_ALIAS_PROVIDED_DATA)) {
+    iree_hal_local_executable_defer_load(&executable->base);
+  } else {
+    status = iree_hal_elf_executable_load(&executable->base);
+  }
+
   if (iree_status_is_ok(status)) {
     *out_executable = (iree_hal_executable_t*)executable;
   } else {
@@ -202,6 +254,8 @@ static void iree_hal_elf_executable_destroy(
     iree_allocator_free(host_allocator, (void*)executable->base.imports);
   }
 
+  iree_hal_executable_loader_release(executable->loader);
+
   iree_hal_local_executable_deinitialize(
       (iree_hal_local_executable_t*)base_executable);
   iree_allocator_free(host_allocator, executable);
@@ -254,6 +308,47 @@ static iree_status_t iree_hal_elf_executable_issue_call(
                         ret);
 }
 
+static iree_status_t iree_hal_elf_executable_issue_range_call(
+    iree_hal_local_executable_t* base_executable, iree_host_size_t ordinal,
+    const iree_hal_executable_dispatch_state_v0_t* dispatch_state,
+    const iree_hal_executable_workgroup_range_v0_t* workgroup_range,
+    iree_byte_span_t local_memory) {
+  iree_hal_elf_executable_t* executable =
+      (iree_hal_elf_executable_t*)base_executable;
+  const iree_hal_executable_library_v0_t* library = executable->library.v0;
+
+  if (IREE_UNLIKELY(ordinal >= library->exports.count)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "entry point ordinal out of bounds");
+  }
+
+#if IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION
+  iree_string_view_t entry_point_name = iree_string_view_empty();
+  if (library->exports.names != NULL) {
+    entry_point_name = iree_make_cstring_view(library->exports.names[ordinal]);
+  }
+  if (iree_string_view_is_empty(entry_point_name)) {
+    entry_point_name = iree_make_cstring_view("unknown_elf_call");
+  }
+  IREE_TRACE_ZONE_BEGIN_EXTERNAL(
+      z0, executable->identifier.data, executable->identifier.size, ordinal,
+      entry_point_name.data, entry_point_name.size, NULL, 0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, workgroup_range->workgroup_count);
+#endif  // IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION
+
+  int ret = iree_elf_call_i_ppp(library->exports.range_ptrs[ordinal],
+                                (void*)dispatch_state, (void*)workgroup_range,
+                                (void*)local_memory.data);
+
+  IREE_TRACE_ZONE_END(z0);
+
+  return ret == 0 ? iree_ok_status()
+                  : iree_make_status(
+                        IREE_STATUS_INTERNAL,
+                        "executable entry point returned catastrophic error %d",
+                        ret);
+}
+
 static const iree_hal_local_executable_vtable_t iree_hal_elf_executable_vtable =
     {
         .base =
@@ -261,6 +356,8 @@ static const iree_hal_local_executable_vtable_t iree_hal_elf_executable_vtable =
                 .destroy = iree_hal_elf_executable_destroy,
             },
         .issue_call = iree_hal_elf_executable_issue_call,
+        .issue_range_call = iree_hal_elf_executable_issue_range_call,
+        .load = iree_hal_elf_executable_load,
 };
 
 //===----------------------------------------------------------------------===//
@@ -321,6 +418,7 @@ static bool iree_hal_embedded_library_loader_query_support(
 static iree_status_t iree_hal_embedded_library_loader_try_load(
     iree_hal_executable_loader_t* base_executable_loader,
     const iree_hal_executable_spec_t* executable_spec,
+    const iree_hal_executable_environment_v0_t* environment,
     iree_hal_executable_t** out_executable) {
   iree_hal_embedded_library_loader_t* executable_loader =
       (iree_hal_embedded_library_loader_t*)base_executable_loader;
@@ -330,8 +428,7 @@ static iree_status_t iree_hal_embedded_library_loader_try_load(
   iree_status_t status = iree_hal_elf_executable_create(
       executable_spec->caching_mode, executable_spec->executable_data,
       executable_spec->executable_layout_count,
-      executable_spec->executable_layouts,
-      base_executable_loader->import_provider,
+      executable_spec->executable_layouts, base_executable_loader, environment,
       executable_loader->host_allocator, out_executable);
 
   IREE_TRACE_ZONE_END(z0);
@@ -16,6 +16,14 @@
 #include "iree/hal/local/local_executable.h"
 #include "iree/hal/local/local_executable_layout.h"
 
+typedef struct iree_hal_static_library_loader_t
+    iree_hal_static_library_loader_t;
+typedef struct iree_hal_static_library_slot_t iree_hal_static_library_slot_t;
+
+static void iree_hal_static_library_loader_release_slot(
+    iree_hal_static_library_loader_t* executable_loader,
+    iree_hal_static_library_slot_t* slot);
+
 //===----------------------------------------------------------------------===//
 // iree_hal_static_executable_t
 //===----------------------------------------------------------------------===//
@@ -23,6 +31,12 @@
 typedef struct iree_hal_static_executable_t {
   iree_hal_local_executable_t base;
 
+  // Loader and slot providing the storage of the executable or NULL if the
+  // executable was allocated from the host allocator. The loader is retained
+  // for as long as the executable uses its storage.
+  iree_hal_static_library_loader_t* loader;
+  iree_hal_static_library_slot_t* slot;
+
   // Name used for the file field in tracy and debuggers.
   iree_string_view_t identifier;
 
@@ -37,25 +51,34 @@ typedef struct iree_hal_static_executable_t {
 static const iree_hal_local_executable_vtable_t
     iree_hal_static_executable_vtable;
 
+// Creates a static executable in |storage| if provided or otherwise allocated
+// from |host_allocator|. |storage| must have capacity for at least
+// |executable_layout_count| layouts.
 static iree_status_t iree_hal_static_executable_create(
     const iree_hal_executable_library_header_t** library_header,
     iree_host_size_t executable_layout_count,
     iree_hal_executable_layout_t* const* executable_layouts,
     const iree_hal_executable_import_provider_t import_provider,
-    iree_allocator_t host_allocator, iree_hal_executable_t** out_executable) {
+    iree_hal_static_executable_t* storage, iree_allocator_t host_allocator,
+    iree_hal_executable_t** out_executable) {
   IREE_ASSERT_ARGUMENT(library_header);
   IREE_ASSERT_ARGUMENT(!executable_layout_count || executable_layouts);
   IREE_ASSERT_ARGUMENT(out_executable);
   *out_executable = NULL;
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  iree_hal_static_executable_t* executable = NULL;
-  iree_host_size_t total_size =
-      sizeof(*executable) +
-      executable_layout_count * sizeof(*executable->layouts);
-  iree_status_t status =
-      iree_allocator_malloc(host_allocator, total_size, (void**)&executable);
+  iree_hal_static_executable_t* executable = storage;
+  iree_status_t status = iree_ok_status();
+  if (!executable) {
+    iree_host_size_t total_size =
+        sizeof(*executable) +
+        executable_layout_count * sizeof(*executable->layouts);
+    status =
+        iree_allocator_malloc(host_allocator, total_size, (void**)&executable);
+  }
   if (iree_status_is_ok(status)) {
+    executable->loader = NULL;
+    executable->slot = NULL;
     iree_hal_local_executable_initialize(
         &iree_hal_static_executable_vtable, executable_layout_count,
         executable_layouts, &executable->layouts[0], host_allocator,
@@ -63,6 +86,10 @@ static iree_status_t iree_hal_static_executable_create(
     executable->library.header = library_header;
     executable->identifier = iree_make_cstring_view((*library_header)->name);
     executable->base.dispatch_attrs = executable->library.v0->exports.attrs;
+    executable->base.entry_point_names = executable->library.v0->exports.names;
+    executable->base.dispatch_costs = executable->library.v0->exports.costs;
+    executable->base.dispatch_range_ptrs =
+        executable->library.v0->exports.range_ptrs;
   }
 
   if (iree_status_is_ok(status)) {
@@ -92,7 +119,13 @@ static void iree_hal_static_executable_destroy(
 
   iree_hal_local_executable_deinitialize(
       (iree_hal_local_executable_t*)base_executable);
-  iree_allocator_free(host_allocator, executable);
+  if (executable->slot) {
+    // NOTE: this may destroy the loader and the storage of the executable.
+    iree_hal_static_library_loader_release_slot(executable->loader,
+                                                executable->slot);
+  } else {
+    iree_allocator_free(host_allocator, executable);
+  }
 
   IREE_TRACE_ZONE_END(z0);
 }
@@ -141,6 +174,46 @@ static iree_status_t iree_hal_static_executable_issue_call(
                         ret);
 }
 
+static iree_status_t iree_hal_static_executable_issue_range_call(
+    iree_hal_local_executable_t* base_executable, iree_host_size_t ordinal,
+    const iree_hal_executable_dispatch_state_v0_t* dispatch_state,
+    const iree_hal_executable_workgroup_range_v0_t* workgroup_range,
+    iree_byte_span_t local_memory) {
+  iree_hal_static_executable_t* executable =
+      (iree_hal_static_executable_t*)base_executable;
+  const iree_hal_executable_library_v0_t* library = executable->library.v0;
+
+  if (IREE_UNLIKELY(ordinal >= library->exports.count)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "entry point ordinal out of bounds");
+  }
+
+#if IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION
+  iree_string_view_t entry_point_name = iree_string_view_empty();
+  if (library->exports.names != NULL) {
+    entry_point_name = iree_make_cstring_view(library->exports.names[ordinal]);
+  }
+  if (iree_string_view_is_empty(entry_point_name)) {
+    entry_point_name = iree_make_cstring_view("unknown_dylib_call");
+  }
+  IREE_TRACE_ZONE_BEGIN_EXTERNAL(
+      z0, executable->identifier.data, executable->identifier.size, ordinal,
+      entry_point_name.data, entry_point_name.size, NULL, 0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, workgroup_range->workgroup_count);
+#endif  // IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION
+
+  int ret = library->exports.range_ptrs[ordinal](
+      dispatch_state, workgroup_range, local_memory.data);
+
+  IREE_TRACE_ZONE_END(z0);
+
+  return ret == 0 ? iree_ok_status()
+                  : iree_make_status(
+                        IREE_STATUS_INTERNAL,
+                        "executable entry point returned catastrophic error %d",
+                        ret);
+}
+
 static const iree_hal_local_executable_vtable_t
     iree_hal_static_executable_vtable = {
         .base =
@@ -148,18 +221,32 @@ static const iree_hal_local_executable_vtable_t
                 .destroy = iree_hal_static_executable_destroy,
             },
         .issue_call = iree_hal_static_executable_issue_call,
+        .issue_range_call = iree_hal_static_executable_issue_range_call,
 };
 
 //===----------------------------------------------------------------------===//
 // iree_hal_static_library_loader_t
 //===----------------------------------------------------------------------===//
 
-typedef struct iree_hal_static_library_loader_t {
+// A registered library and preallocated storage for an executable loaded from
+// it. Static executables are usually loaded once per module and using the
+// storage avoids heap allocations when the module is initialized; additional
+// concurrently live executables of the same library are heap allocated.
+struct iree_hal_static_library_slot_t {
+  const iree_hal_executable_library_header_t** library;
+  // 1 while |executable| is in use by a live executable.
+  iree_atomic_int32_t in_use;
+  // Number of executable layouts |executable| has storage for.
+  iree_host_size_t layout_capacity;
+  iree_hal_static_executable_t* executable;
+};
+
+struct iree_hal_static_library_loader_t {
   iree_hal_executable_loader_t base;
   iree_allocator_t host_allocator;
   iree_host_size_t library_count;
-  const iree_hal_executable_library_header_t** const libraries[];
-} iree_hal_static_library_loader_t;
+  iree_hal_static_library_slot_t slots[];
+};
 
 static const iree_hal_executable_loader_vtable_t
     iree_hal_static_library_loader_vtable;
@@ -190,10 +277,23 @@ iree_status_t iree_hal_static_library_loader_create(
     }
   }
 
+  // Executables have one layout per export and the storage for each library is
+  // sized to match. All storage is allocated with the loader.
   iree_hal_static_library_loader_t* executable_loader = NULL;
-  iree_host_size_t total_size =
+  iree_host_size_t slots_size = iree_host_align(
       sizeof(*executable_loader) +
-      sizeof(executable_loader->libraries[0]) * library_count;
+          sizeof(executable_loader->slots[0]) * library_count,
+      iree_max_align_t);
+  iree_host_size_t total_size = slots_size;
+  for (iree_host_size_t i = 0; i < library_count; ++i) {
+    const iree_hal_executable_library_v0_t* library =
+        (const iree_hal_executable_library_v0_t*)libraries[i];
+    total_size += iree_host_align(
+        sizeof(iree_hal_static_executable_t) +
+            library->exports.count *
+                sizeof(((iree_hal_static_executable_t*)NULL)->layouts[0]),
+        iree_max_align_t);
+  }
   iree_status_t status = iree_allocator_malloc(host_allocator, total_size,
                                                (void**)&executable_loader);
   if (iree_status_is_ok(status)) {
@@ -202,8 +302,20 @@ iree_status_t iree_hal_static_library_loader_create(
         &executable_loader->base);
     executable_loader->host_allocator = host_allocator;
     executable_loader->library_count = library_count;
-    memcpy((void*)executable_loader->libraries, libraries,
-           sizeof(libraries[0]) * library_count);
+    uint8_t* storage_ptr = (uint8_t*)executable_loader + slots_size;
+    for (iree_host_size_t i = 0; i < library_count; ++i) {
+      const iree_hal_executable_library_v0_t* library =
+          (const iree_hal_executable_library_v0_t*)libraries[i];
+      iree_hal_static_library_slot_t* slot = &executable_loader->slots[i];
+      slot->library = libraries[i];
+      iree_atomic_store_int32(&slot->in_use, 0, iree_memory_order_relaxed);
+      slot->layout_capacity = library->exports.count;
+      slot->executable = (iree_hal_static_executable_t*)storage_ptr;
+      storage_ptr += iree_host_align(
+          sizeof(*slot->executable) +
+              slot->layout_capacity * sizeof(slot->executable->layouts[0]),
+          iree_max_align_t);
+    }
     *out_executable_loader = (iree_hal_executable_loader_t*)executable_loader;
   }
 
@@ -223,6 +335,32 @@ static void iree_hal_static_library_loader_destroy(
   IREE_TRACE_ZONE_END(z0);
 }
 
+// Claims the preallocated executable storage of |slot| if it is unused and has
+// capacity for |executable_layout_count| layouts. Returns NULL if the storage
+// is unavailable and the executable must be allocated.
+static iree_hal_static_executable_t*
+iree_hal_static_library_loader_try_claim_slot(
+    iree_hal_static_library_loader_t* executable_loader,
+    iree_hal_static_library_slot_t* slot,
+    iree_host_size_t executable_layout_count) {
+  if (executable_layout_count > slot->layout_capacity) return NULL;
+  int32_t expected = 0;
+  if (!iree_atomic_compare_exchange_strong_int32(
+          &slot->in_use, &expected, 1, iree_memory_order_acquire,
+          iree_memory_order_relaxed)) {
+    return NULL;
+  }
+  iree_hal_executable_loader_retain(&executable_loader->base);
+  return slot->executable;
+}
+
+static void iree_hal_static_library_loader_release_slot(
+    iree_hal_static_library_loader_t* executable_loader,
+    iree_hal_static_library_slot_t* slot) {
+  iree_atomic_store_int32(&slot->in_use, 0, iree_memory_order_release);
+  iree_hal_executable_loader_release(&executable_loader->base);
+}
+
 static bool iree_hal_static_library_loader_query_support(
     iree_hal_executable_loader_t* base_executable_loader,
     iree_hal_executable_caching_mode_t caching_mode,
@@ -234,6 +372,7 @@ static bool iree_hal_static_library_loader_query_support(
 static iree_status_t iree_hal_static_library_loader_try_load(
     iree_hal_executable_loader_t* base_executable_loader,
     const iree_hal_executable_spec_t* executable_spec,
+    const iree_hal_executable_environment_v0_t* environment,
     iree_hal_executable_t** out_executable) {
   iree_hal_static_library_loader_t* executable_loader =
       (iree_hal_static_library_loader_t*)base_executable_loader;
@@ -249,17 +388,31 @@ static iree_status_t iree_hal_static_library_loader_try_load(
   // creation to perform a binary-search fairly easily, though, at the cost of
   // the additional code size.
   for (iree_host_size_t i = 0; i < executable_loader->library_count; ++i) {
-    const iree_hal_executable_library_header_t* header =
-        *executable_loader->libraries[i];
-    if (iree_string_view_equal(library_name,
-                               iree_make_cstring_view(header->name))) {
-      return iree_hal_static_executable_create(
-          executable_loader->libraries[i],
-          executable_spec->executable_layout_count,
-          executable_spec->executable_layouts,
-          base_executable_loader->import_provider,
-          executable_loader->host_allocator, out_executable);
+    iree_hal_static_library_slot_t* slot = &executable_loader->slots[i];
+    const iree_hal_executable_library_header_t* header = *slot->library;
+    if (!iree_string_view_equal(library_name,
+                                iree_make_cstring_view(header->name))) {
+      continue;
+    }
+    iree_hal_static_executable_t* storage =
+        iree_hal_static_library_loader_try_claim_slot(
+            executable_loader, slot, executable_spec->executable_layout_count);
+    iree_status_t status = iree_hal_static_executable_create(
+        slot->library, executable_spec->executable_layout_count,
+        executable_spec->executable_layouts,
+        base_executable_loader->import_provider, storage,
+        executable_loader->host_allocator, out_executable);
+    if (storage) {
+      if (iree_status_is_ok(status)) {
+        iree_hal_static_executable_t* executable =
+            (iree_hal_static_executable_t*)*out_executable;
+        executable->loader = executable_loader;
+        executable->slot = slot;
+      } else {
+        iree_hal_static_library_loader_release_slot(executable_loader, slot);
+      }
     }
+    return status;
   }
   return iree_make_status(IREE_STATUS_NOT_FOUND,
                           "no static library with the name '%.*s' registered",
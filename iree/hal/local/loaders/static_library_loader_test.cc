@@ -0,0 +1,168 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/local/loaders/static_library_loader.h"
+
+#include <cstring>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/hal/local/executable_library.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace {
+
+static int TestDispatch(
+    const iree_hal_executable_dispatch_state_v0_t* dispatch_state,
+    const iree_hal_vec3_t* workgroup_id, void* local_memory) {
+  return 0;
+}
+
+static const iree_hal_executable_dispatch_v0_t kTestDispatchPtrs[1] = {
+    TestDispatch,
+};
+
+static const iree_hal_executable_library_header_t kTestLibraryHeader = {
+    /*.version=*/IREE_HAL_EXECUTABLE_LIBRARY_LATEST_VERSION,
+    /*.name=*/"test_library",
+    /*.features=*/IREE_HAL_EXECUTABLE_LIBRARY_FEATURE_NONE,
+    /*.sanitizer=*/IREE_HAL_EXECUTABLE_LIBRARY_SANITIZER_NONE,
+};
+
+static const iree_hal_executable_library_v0_t kTestLibrary = {
+    /*.header=*/&kTestLibraryHeader,
+    /*.imports=*/{/*.count=*/0},
+    /*.exports=*/
+    {
+        /*.count=*/1,
+        /*.ptrs=*/kTestDispatchPtrs,
+    },
+};
+
+// Host allocator tracking the number of live allocations.
+struct CountingAllocator {
+  int live_count = 0;
+
+  static iree_status_t Ctl(void* self, iree_allocator_command_t command,
+                           const void* params, void** inout_ptr) {
+    auto* allocator = reinterpret_cast<CountingAllocator*>(self);
+    switch (command) {
+      case IREE_ALLOCATOR_COMMAND_MALLOC:
+      case IREE_ALLOCATOR_COMMAND_CALLOC:
+        ++allocator->live_count;
+        break;
+      case IREE_ALLOCATOR_COMMAND_FREE:
+        --allocator->live_count;
+        break;
+      default:
+        break;
+    }
+    return iree_allocator_system_ctl(/*self=*/NULL, command, params, inout_ptr);
+  }
+
+  iree_allocator_t allocator() {
+    iree_allocator_t v = {this, Ctl};
+    return v;
+  }
+};
+
+class StaticLibraryLoaderTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    const iree_hal_executable_library_header_t** const libraries[1] = {
+        (const iree_hal_executable_library_header_t**)&kTestLibrary,
+    };
+    IREE_ASSERT_OK(iree_hal_static_library_loader_create(
+        IREE_ARRAYSIZE(libraries), libraries,
+        iree_hal_executable_import_provider_null(),
+        host_allocator_.allocator(), &loader_));
+    // The loader and the storage for one executable of each library.
+    EXPECT_EQ(1, host_allocator_.live_count);
+  }
+
+  void TearDown() override {
+    iree_hal_executable_loader_release(loader_);
+    EXPECT_EQ(0, host_allocator_.live_count);
+  }
+
+  iree_status_t LoadExecutable(iree_hal_executable_t** out_executable) {
+    iree_hal_executable_spec_t spec;
+    iree_hal_executable_spec_initialize(&spec);
+    spec.executable_format = iree_make_cstring_view("static");
+    spec.executable_data = iree_make_const_byte_span(
+        (const uint8_t*)kTestLibraryHeader.name,
+        strlen(kTestLibraryHeader.name));
+    return iree_hal_executable_loader_try_load(loader_, &spec,
+                                               /*environment=*/NULL,
+                                               out_executable);
+  }
+
+  CountingAllocator host_allocator_;
+  iree_hal_executable_loader_t* loader_ = NULL;
+};
+
+// The first executable of a library uses the storage preallocated with the
+// loader.
+TEST_F(StaticLibraryLoaderTest, FirstLoadUsesSlot) {
+  iree_hal_executable_t* executable = NULL;
+  IREE_ASSERT_OK(LoadExecutable(&executable));
+  EXPECT_EQ(1, host_allocator_.live_count);
+  iree_hal_executable_release(executable);
+  EXPECT_EQ(1, host_allocator_.live_count);
+}
+
+// Executables of a library loaded while the slot is in use are allocated from
+// the host allocator.
+TEST_F(StaticLibraryLoaderTest, ConcurrentLoadUsesHostAllocator) {
+  iree_hal_executable_t* executable0 = NULL;
+  IREE_ASSERT_OK(LoadExecutable(&executable0));
+  iree_hal_executable_t* executable1 = NULL;
+  IREE_ASSERT_OK(LoadExecutable(&executable1));
+  EXPECT_NE(executable0, executable1);
+  EXPECT_EQ(2, host_allocator_.live_count);
+
+  iree_hal_executable_release(executable1);
+  EXPECT_EQ(1, host_allocator_.live_count);
+  iree_hal_executable_release(executable0);
+  EXPECT_EQ(1, host_allocator_.live_count);
+}
+
+// The slot is reused once the executable using it has been released.
+TEST_F(StaticLibraryLoaderTest, SlotReusedAfterRelease) {
+  iree_hal_executable_t* executable0 = NULL;
+  IREE_ASSERT_OK(LoadExecutable(&executable0));
+  iree_hal_executable_t* executable1 = NULL;
+  IREE_ASSERT_OK(LoadExecutable(&executable1));
+  iree_hal_executable_release(executable0);
+
+  iree_hal_executable_t* executable2 = NULL;
+  IREE_ASSERT_OK(LoadExecutable(&executable2));
+  EXPECT_EQ(executable0, executable2);
+  EXPECT_EQ(2, host_allocator_.live_count);
+
+  iree_hal_executable_release(executable1);
+  iree_hal_executable_release(executable2);
+  EXPECT_EQ(1, host_allocator_.live_count);
+}
+
+// Executables using the slot retain the loader as it owns their storage.
+TEST_F(StaticLibraryLoaderTest, ExecutableOutlivesLoader) {
+  iree_hal_executable_t* executable0 = NULL;
+  IREE_ASSERT_OK(LoadExecutable(&executable0));
+  iree_hal_executable_t* executable1 = NULL;
+  IREE_ASSERT_OK(LoadExecutable(&executable1));
+  iree_hal_executable_loader_release(loader_);
+  loader_ = NULL;
+  EXPECT_EQ(2, host_allocator_.live_count);
+
+  iree_hal_executable_release(executable1);
+  EXPECT_EQ(1, host_allocator_.live_count);
+  iree_hal_executable_release(executable0);
+  EXPECT_EQ(0, host_allocator_.live_count);
+}
+
+}  // namespace
@@ -13,6 +13,7 @@
 #include "iree/base/internal/dynamic_library.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/api.h"
+#include "iree/hal/local/executable_environment.h"
 #include "iree/hal/local/executable_library.h"
 #include "iree/hal/local/local_executable.h"
 #include "iree/hal/local/local_executable_layout.h"
@@ -83,6 +84,9 @@ typedef struct iree_hal_system_executable_t {
   // Name used for the file field in tracy and debuggers.
   iree_string_view_t identifier;
 
+  // Environment the library is queried with.
+  iree_hal_executable_environment_v0_t environment;
+
   // Queried metadata from the library.
   union {
     const iree_hal_executable_library_header_t** header;
@@ -145,9 +149,9 @@ static iree_status_t iree_hal_system_executable_query_library(
       executable->handle, IREE_HAL_EXECUTABLE_LIBRARY_EXPORT_NAME,
       (void**)&query_fn));
 
-  // Query for a compatible version of the library.
-  executable->library.header =
-      query_fn(IREE_HAL_EXECUTABLE_LIBRARY_LATEST_VERSION, /*reserved=*/NULL);
+  // Query for a compatible version of the library specialized for the host.
+  executable->library.header = query_fn(
+      IREE_HAL_EXECUTABLE_LIBRARY_LATEST_VERSION, &executable->environment);
   if (!executable->library.header) {
     return iree_make_status(
         IREE_STATUS_FAILED_PRECONDITION,
@@ -189,6 +193,10 @@ static iree_status_t iree_hal_system_executable_query_library(
   executable->identifier = iree_make_cstring_view(header->name);
 
   executable->base.dispatch_attrs = executable->library.v0->exports.attrs;
+  executable->base.entry_point_names = executable->library.v0->exports.names;
+  executable->base.dispatch_costs = executable->library.v0->exports.costs;
+  executable->base.dispatch_range_ptrs =
+      executable->library.v0->exports.range_ptrs;
 
   return iree_ok_status();
 }
@@ -239,6 +247,7 @@ static iree_status_t iree_hal_system_executable_create(
     iree_host_size_t executable_layout_count,
     iree_hal_executable_layout_t* const* executable_layouts,
     const iree_hal_executable_import_provider_t import_provider,
+    const iree_hal_executable_environment_v0_t* environment,
     iree_allocator_t host_allocator, iree_hal_executable_t** out_executable) {
   IREE_ASSERT_ARGUMENT(executable_data.data && executable_data.data_length);
   IREE_ASSERT_ARGUMENT(!executable_layout_count || executable_layouts);
@@ -257,6 +266,11 @@ static iree_status_t iree_hal_system_executable_create(
         &iree_hal_system_executable_vtable, executable_layout_count,
         executable_layouts, &executable->layouts[0], host_allocator,
         &executable->base);
+    if (environment) {
+      executable->environment = *environment;
+    } else {
+      iree_hal_executable_environment_initialize(&executable->environment);
+    }
   }
   if (iree_status_is_ok(status)) {
     // Attempt to extract the embedded library and load it.
@@ -300,6 +314,18 @@ static void iree_hal_system_executable_destroy(
   iree_allocator_t host_allocator = executable->base.host_allocator;
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  // Libraries instrumented for profile-guided optimization write out their
+  // profile before they are unloaded. Most libraries don't export the function
+  // and the failed lookup is ignored.
+  iree_hal_executable_library_write_profile_fn_t write_profile_fn = NULL;
+  iree_status_t status = iree_dynamic_library_lookup_symbol(
+      executable->handle, IREE_HAL_EXECUTABLE_LIBRARY_PROFILE_WRITE_NAME,
+      (void**)&write_profile_fn);
+  if (iree_status_is_ok(status) && write_profile_fn) {
+    write_profile_fn();
+  }
+  iree_status_ignore(status);
+
   iree_dynamic_library_release(executable->handle);
 
   iree_hal_local_executable_deinitialize(
@@ -353,6 +379,46 @@ static iree_status_t iree_hal_system_executable_issue_call(
                         ret);
 }
 
+static iree_status_t iree_hal_system_executable_issue_range_call(
+    iree_hal_local_executable_t* base_executable, iree_host_size_t ordinal,
+    const iree_hal_executable_dispatch_state_v0_t* dispatch_state,
+    const iree_hal_executable_workgroup_range_v0_t* workgroup_range,
+    iree_byte_span_t local_memory) {
+  iree_hal_system_executable_t* executable =
+      (iree_hal_system_executable_t*)base_executable;
+  const iree_hal_executable_library_v0_t* library = executable->library.v0;
+
+  if (IREE_UNLIKELY(ordinal >= library->exports.count)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "entry point ordinal out of bounds");
+  }
+
+#if IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION
+  iree_string_view_t entry_point_name = iree_string_view_empty();
+  if (library->exports.names != NULL) {
+    entry_point_name = iree_make_cstring_view(library->exports.names[ordinal]);
+  }
+  if (iree_string_view_is_empty(entry_point_name)) {
+    entry_point_name = iree_make_cstring_view("unknown_dylib_call");
+  }
+  IREE_TRACE_ZONE_BEGIN_EXTERNAL(
+      z0, executable->identifier.data, executable->identifier.size, ordinal,
+      entry_point_name.data, entry_point_name.size, NULL, 0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, workgroup_range->workgroup_count);
+#endif  // IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION
+
+  int ret = library->exports.range_ptrs[ordinal](
+      dispatch_state, workgroup_range, local_memory.data);
+
+  IREE_TRACE_ZONE_END(z0);
+
+  return ret == 0 ? iree_ok_status()
+                  : iree_make_status(
+                        IREE_STATUS_INTERNAL,
+                        "executable entry point returned catastrophic error %d",
+                        ret);
+}
+
 static const iree_hal_local_executable_vtable_t
     iree_hal_system_executable_vtable = {
         .base =
@@ -360,6 +426,7 @@ static const iree_hal_local_executable_vtable_t
                 .destroy = iree_hal_system_executable_destroy,
             },
         .issue_call = iree_hal_system_executable_issue_call,
+        .issue_range_call = iree_hal_system_executable_issue_range_call,
 };
 
 //===----------------------------------------------------------------------===//
@@ -413,6 +480,10 @@ static void iree_hal_system_library_loader_destroy(
 #define IREE_PLATFORM_DYLIB_TYPE "dylib"
 #elif defined(IREE_PLATFORM_WINDOWS)
 #define IREE_PLATFORM_DYLIB_TYPE "dll"
+#elif defined(IREE_PLATFORM_EMSCRIPTEN)
+// WebAssembly side modules loaded through Emscripten's dynamic linking support.
+// Hosting programs must be linked with -sMAIN_MODULE.
+#define IREE_PLATFORM_DYLIB_TYPE "wasm"
 #else
 #define IREE_PLATFORM_DYLIB_TYPE "elf"
 #endif  // IREE_PLATFORM_*
@@ -429,6 +500,7 @@ static bool iree_hal_system_library_loader_query_support(
 static iree_status_t iree_hal_system_library_loader_try_load(
     iree_hal_executable_loader_t* base_executable_loader,
     const iree_hal_executable_spec_t* executable_spec,
+    const iree_hal_executable_environment_v0_t* environment,
     iree_hal_executable_t** out_executable) {
   iree_hal_system_library_loader_t* executable_loader =
       (iree_hal_system_library_loader_t*)base_executable_loader;
@@ -440,7 +512,7 @@ static iree_status_t iree_hal_system_library_loader_try_load(
               executable_spec->executable_data,
               executable_spec->executable_layout_count,
               executable_spec->executable_layouts,
-              base_executable_loader->import_provider,
+              base_executable_loader->import_provider, environment,
               executable_loader->host_allocator, out_executable));
 
   IREE_TRACE_ZONE_END(z0);
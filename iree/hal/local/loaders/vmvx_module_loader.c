@@ -127,6 +127,8 @@ static iree_status_t iree_hal_vmvx_executable_create(
       }
       local_memory_size /= IREE_HAL_WORKGROUP_LOCAL_MEMORY_PAGE_SIZE;
       dispatch_attrs[i].local_memory_pages = (uint16_t)local_memory_size;
+      dispatch_attrs[i].workgroup_grain_size = 0;
+      dispatch_attrs[i].flags = IREE_HAL_EXECUTABLE_DISPATCH_FLAG_V0_NONE;
     }
   }
 
@@ -408,6 +410,7 @@ static bool iree_hal_vmvx_module_loader_query_support(
 static iree_status_t iree_hal_vmvx_module_loader_try_load(
     iree_hal_executable_loader_t* base_executable_loader,
     const iree_hal_executable_spec_t* executable_spec,
+    const iree_hal_executable_environment_v0_t* environment,
     iree_hal_executable_t** out_executable) {
   iree_hal_vmvx_module_loader_t* executable_loader =
       (iree_hal_vmvx_module_loader_t*)base_executable_loader;
@@ -8,6 +8,15 @@
 
 #include "iree/base/tracing.h"
 
+typedef enum iree_hal_local_executable_load_state_e {
+  // Loaded (or never deferred) and ready for use.
+  IREE_HAL_LOCAL_EXECUTABLE_LOAD_STATE_LOADED = 0,
+  // Load deferred until first use.
+  IREE_HAL_LOCAL_EXECUTABLE_LOAD_STATE_PENDING,
+  // Deferred load failed and |load_status| holds the error.
+  IREE_HAL_LOCAL_EXECUTABLE_LOAD_STATE_FAILED,
+} iree_hal_local_executable_load_state_t;
+
 void iree_hal_local_executable_initialize(
     const iree_hal_local_executable_vtable_t* vtable,
     iree_host_size_t executable_layout_count,
@@ -28,10 +37,19 @@ void iree_hal_local_executable_initialize(
 
   // Function attributes are optional and populated by the parent type.
   out_base_executable->dispatch_attrs = NULL;
+  out_base_executable->entry_point_names = NULL;
+  out_base_executable->dispatch_costs = NULL;
+  out_base_executable->dispatch_range_ptrs = NULL;
 
   // Imports will be provided by the parent type, if needed.
   out_base_executable->import_thunk = NULL;
   out_base_executable->imports = NULL;
+
+  iree_atomic_store_int32(&out_base_executable->load_state,
+                          IREE_HAL_LOCAL_EXECUTABLE_LOAD_STATE_LOADED,
+                          iree_memory_order_relaxed);
+  iree_slim_mutex_initialize(&out_base_executable->load_mutex);
+  out_base_executable->load_status = iree_ok_status();
 }
 
 void iree_hal_local_executable_deinitialize(
@@ -41,6 +59,8 @@ void iree_hal_local_executable_deinitialize(
     iree_hal_executable_layout_release(
         (iree_hal_executable_layout_t*)base_executable->executable_layouts[i]);
   }
+  iree_status_free(base_executable->load_status);
+  iree_slim_mutex_deinitialize(&base_executable->load_mutex);
 }
 
 iree_hal_local_executable_t* iree_hal_local_executable_cast(
@@ -48,6 +68,49 @@ iree_hal_local_executable_t* iree_hal_local_executable_cast(
   return (iree_hal_local_executable_t*)base_value;
 }
 
+void iree_hal_local_executable_defer_load(
+    iree_hal_local_executable_t* executable) {
+  IREE_ASSERT_ARGUMENT(executable);
+  IREE_ASSERT(((const iree_hal_local_executable_vtable_t*)
+                   executable->resource.vtable)
+                  ->load);
+  iree_atomic_store_int32(&executable->load_state,
+                          IREE_HAL_LOCAL_EXECUTABLE_LOAD_STATE_PENDING,
+                          iree_memory_order_relaxed);
+}
+
+iree_status_t iree_hal_local_executable_ensure_loaded(
+    iree_hal_local_executable_t* executable) {
+  IREE_ASSERT_ARGUMENT(executable);
+  if (IREE_LIKELY(iree_atomic_load_int32(&executable->load_state,
+                                         iree_memory_order_acquire) ==
+                  IREE_HAL_LOCAL_EXECUTABLE_LOAD_STATE_LOADED)) {
+    return iree_ok_status();
+  }
+
+  iree_slim_mutex_lock(&executable->load_mutex);
+  int32_t load_state = iree_atomic_load_int32(&executable->load_state,
+                                              iree_memory_order_relaxed);
+  if (load_state == IREE_HAL_LOCAL_EXECUTABLE_LOAD_STATE_PENDING) {
+    IREE_TRACE_ZONE_BEGIN(z0);
+    executable->load_status = ((const iree_hal_local_executable_vtable_t*)
+                                   executable->resource.vtable)
+                                  ->load(executable);
+    load_state = iree_status_is_ok(executable->load_status)
+                     ? IREE_HAL_LOCAL_EXECUTABLE_LOAD_STATE_LOADED
+                     : IREE_HAL_LOCAL_EXECUTABLE_LOAD_STATE_FAILED;
+    iree_atomic_store_int32(&executable->load_state, load_state,
+                            iree_memory_order_release);
+    IREE_TRACE_ZONE_END(z0);
+  }
+  iree_status_t status =
+      load_state == IREE_HAL_LOCAL_EXECUTABLE_LOAD_STATE_FAILED
+          ? iree_status_clone(executable->load_status)
+          : iree_ok_status();
+  iree_slim_mutex_unlock(&executable->load_mutex);
+  return status;
+}
+
 iree_status_t iree_hal_local_executable_issue_call(
     iree_hal_local_executable_t* executable, iree_host_size_t ordinal,
     const iree_hal_executable_dispatch_state_v0_t* dispatch_state,
@@ -61,6 +124,46 @@ iree_status_t iree_hal_local_executable_issue_call(
                    local_memory);
 }
 
+iree_status_t iree_hal_local_executable_issue_range_call(
+    iree_hal_local_executable_t* executable, iree_host_size_t ordinal,
+    const iree_hal_executable_dispatch_state_v0_t* dispatch_state,
+    uint32_t workgroup_base, uint32_t workgroup_count,
+    iree_byte_span_t local_memory) {
+  IREE_ASSERT_ARGUMENT(executable);
+  IREE_ASSERT_ARGUMENT(dispatch_state);
+  const iree_hal_local_executable_vtable_t* vtable =
+      (const iree_hal_local_executable_vtable_t*)executable->resource.vtable;
+  if (vtable->issue_range_call && executable->dispatch_range_ptrs &&
+      executable->dispatch_range_ptrs[ordinal]) {
+    const iree_hal_executable_workgroup_range_v0_t workgroup_range = {
+        .workgroup_base = workgroup_base,
+        .workgroup_count = workgroup_count,
+    };
+    return vtable->issue_range_call(executable, ordinal, dispatch_state,
+                                    &workgroup_range, local_memory);
+  }
+
+  // No range entry point: walk the range and call per workgroup.
+  const uint32_t workgroup_count_x = dispatch_state->workgroup_count.x;
+  const uint32_t workgroup_count_y = dispatch_state->workgroup_count.y;
+  iree_hal_vec3_t workgroup_id;
+  workgroup_id.x = workgroup_base % workgroup_count_x;
+  workgroup_id.y = (workgroup_base / workgroup_count_x) % workgroup_count_y;
+  workgroup_id.z = workgroup_base / (workgroup_count_x * workgroup_count_y);
+  for (uint32_t i = 0; i < workgroup_count; ++i) {
+    IREE_RETURN_IF_ERROR(vtable->issue_call(executable, ordinal, dispatch_state,
+                                            &workgroup_id, local_memory));
+    if (++workgroup_id.x == workgroup_count_x) {
+      workgroup_id.x = 0;
+      if (++workgroup_id.y == workgroup_count_y) {
+        workgroup_id.y = 0;
+        ++workgroup_id.z;
+      }
+    }
+  }
+  return iree_ok_status();
+}
+
 iree_status_t iree_hal_local_executable_issue_dispatch_inline(
     iree_hal_local_executable_t* executable, iree_host_size_t ordinal,
     const iree_hal_executable_dispatch_state_v0_t* dispatch_state,
@@ -79,19 +182,12 @@ iree_status_t iree_hal_local_executable_issue_dispatch_inline(
 #endif  // IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION
 
   iree_status_t status = iree_ok_status();
-
-  iree_hal_vec3_t workgroup_id;
-  for (workgroup_id.z = 0; workgroup_id.z < workgroup_count.z;
-       ++workgroup_id.z) {
-    for (workgroup_id.y = 0; workgroup_id.y < workgroup_count.y;
-         ++workgroup_id.y) {
-      for (workgroup_id.x = 0; workgroup_id.x < workgroup_count.x;
-           ++workgroup_id.x) {
-        status = iree_hal_local_executable_issue_call(
-            executable, ordinal, dispatch_state, &workgroup_id, local_memory);
-        if (!iree_status_is_ok(status)) break;
-      }
-    }
+  const uint32_t total_workgroup_count =
+      workgroup_count.x * workgroup_count.y * workgroup_count.z;
+  if (total_workgroup_count > 0) {
+    status = iree_hal_local_executable_issue_range_call(
+        executable, ordinal, dispatch_state, /*workgroup_base=*/0,
+        total_workgroup_count, local_memory);
   }
 
   IREE_TRACE_ZONE_END(z0);
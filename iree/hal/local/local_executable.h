@@ -8,6 +8,8 @@
 #define IREE_HAL_LOCAL_LOCAL_EXECUTABLE_H_
 
 #include "iree/base/api.h"
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/synchronization.h"
 #include "iree/hal/api.h"
 #include "iree/hal/local/executable_library.h"
 #include "iree/hal/local/local_executable_layout.h"
@@ -28,12 +30,33 @@ typedef struct iree_hal_local_executable_t {
   // of memory required by the function.
   const iree_hal_executable_dispatch_attrs_v0_t* dispatch_attrs;
 
+  // Optional entry point names 1:1 with the entry points used for profiling.
+  // NULL if the executable was compiled without names.
+  const char* const* entry_point_names;
+
+  // Optional compiler-estimated dispatch costs 1:1 with the entry points.
+  // NULL if the compiler was unable to estimate the cost of any entry point.
+  const iree_hal_executable_dispatch_cost_v0_t* dispatch_costs;
+
+  // Optional range entry points 1:1 with the entry points. NULL (or NULL
+  // entries) if the executable only has per-workgroup entry points.
+  const iree_hal_executable_dispatch_range_v0_t* dispatch_range_ptrs;
+
   // Thunk function for calling imports. All calls must be made through this.
   iree_hal_executable_import_thunk_v0_t import_thunk;
   // Optional imported functions available for use within the executable.
   // Contains one entry per imported function. If an import was marked as weak
   // then the corresponding entry may be NULL.
   const iree_hal_executable_import_v0_t* imports;
+
+  // iree_hal_local_executable_load_state_e tracking deferred loading.
+  // Executables are loaded on creation unless they call
+  // iree_hal_local_executable_defer_load.
+  iree_atomic_int32_t load_state;
+  // Guards the deferred load so that only one thread performs it.
+  iree_slim_mutex_t load_mutex;
+  // Result of the deferred load; valid once the load state is not pending.
+  iree_status_t load_status;
 } iree_hal_local_executable_t;
 
 typedef struct iree_hal_local_executable_vtable_t {
@@ -43,6 +66,19 @@ typedef struct iree_hal_local_executable_vtable_t {
       iree_hal_local_executable_t* executable, iree_host_size_t ordinal,
       const iree_hal_executable_dispatch_state_v0_t* dispatch_state,
       const iree_hal_vec3_t* workgroup_id, iree_byte_span_t local_memory);
+
+  // Calls the range entry point |ordinal|. Only called for entry points with a
+  // non-NULL |dispatch_range_ptrs| entry. Optional.
+  iree_status_t(IREE_API_PTR* issue_range_call)(
+      iree_hal_local_executable_t* executable, iree_host_size_t ordinal,
+      const iree_hal_executable_dispatch_state_v0_t* dispatch_state,
+      const iree_hal_executable_workgroup_range_v0_t* workgroup_range,
+      iree_byte_span_t local_memory);
+
+  // Performs the deferred load work of executables that called
+  // iree_hal_local_executable_defer_load. Must populate |dispatch_attrs| and
+  // the imports. Called at most once.
+  iree_status_t(IREE_API_PTR* load)(iree_hal_local_executable_t* executable);
 } iree_hal_local_executable_vtable_t;
 
 // Initializes the local executable base type.
@@ -63,11 +99,35 @@ void iree_hal_local_executable_deinitialize(
 iree_hal_local_executable_t* iree_hal_local_executable_cast(
     iree_hal_executable_t* base_value);
 
+// Marks |executable| as requiring its vtable load method to be called before
+// first use. Implementations use this to defer expensive loading work (such as
+// linking) until the executable is dispatched so that executables that are
+// never used cost little more than their metadata.
+void iree_hal_local_executable_defer_load(
+    iree_hal_local_executable_t* executable);
+
+// Ensures that |executable| is loaded, performing any deferred load work if
+// this is the first use. Must be called before accessing any executable
+// metadata such as dispatch attributes or imports. Thread-safe and cheap once
+// loaded. Load failures are returned to every caller.
+iree_status_t iree_hal_local_executable_ensure_loaded(
+    iree_hal_local_executable_t* executable);
+
 iree_status_t iree_hal_local_executable_issue_call(
     iree_hal_local_executable_t* executable, iree_host_size_t ordinal,
     const iree_hal_executable_dispatch_state_v0_t* dispatch_state,
     const iree_hal_vec3_t* workgroup_id, iree_byte_span_t local_memory);
 
+// Executes |workgroup_count| workgroups of entry point |ordinal| starting at
+// the linearized workgroup index |workgroup_base| (see
+// iree_hal_executable_workgroup_range_v0_t). Uses the executable range entry
+// point when available and otherwise calls the entry point per workgroup.
+iree_status_t iree_hal_local_executable_issue_range_call(
+    iree_hal_local_executable_t* executable, iree_host_size_t ordinal,
+    const iree_hal_executable_dispatch_state_v0_t* dispatch_state,
+    uint32_t workgroup_base, uint32_t workgroup_count,
+    iree_byte_span_t local_memory);
+
 iree_status_t iree_hal_local_executable_issue_dispatch_inline(
     iree_hal_local_executable_t* executable, iree_host_size_t ordinal,
     const iree_hal_executable_dispatch_state_v0_t* dispatch_state,
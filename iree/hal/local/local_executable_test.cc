@@ -0,0 +1,154 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/local/local_executable.h"
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace {
+
+// Executable with a deferred load that records its invocations and fails with
+// |load_status_code| when not OK.
+struct TestExecutable {
+  iree_hal_local_executable_t base;
+  std::atomic<int> load_count;
+  iree_status_code_t load_status_code;
+  iree_hal_executable_dispatch_attrs_v0_t dispatch_attrs[1];
+};
+
+static void TestExecutableDestroy(iree_hal_executable_t* base_executable) {
+  auto* executable = reinterpret_cast<TestExecutable*>(base_executable);
+  iree_hal_local_executable_deinitialize(&executable->base);
+  delete executable;
+}
+
+static iree_status_t TestExecutableIssueCall(
+    iree_hal_local_executable_t* base_executable, iree_host_size_t ordinal,
+    const iree_hal_executable_dispatch_state_v0_t* dispatch_state,
+    const iree_hal_vec3_t* workgroup_id, iree_byte_span_t local_memory) {
+  return iree_make_status(IREE_STATUS_UNIMPLEMENTED);
+}
+
+static iree_status_t TestExecutableLoad(
+    iree_hal_local_executable_t* base_executable) {
+  auto* executable = reinterpret_cast<TestExecutable*>(base_executable);
+  executable->load_count.fetch_add(1);
+  if (executable->load_status_code != IREE_STATUS_OK) {
+    return iree_make_status(executable->load_status_code, "load failed");
+  }
+  executable->dispatch_attrs[0].local_memory_pages = 1;
+  executable->base.dispatch_attrs = executable->dispatch_attrs;
+  return iree_ok_status();
+}
+
+static const iree_hal_local_executable_vtable_t kTestExecutableVtable = {
+    /*.base=*/{
+        /*.destroy=*/TestExecutableDestroy,
+    },
+    /*.issue_call=*/TestExecutableIssueCall,
+    /*.issue_range_call=*/NULL,
+    /*.load=*/TestExecutableLoad,
+};
+
+class LocalExecutableTest : public ::testing::Test {
+ protected:
+  void TearDown() override {
+    iree_hal_executable_release((iree_hal_executable_t*)executable_);
+  }
+
+  // Creates |executable_| and defers its load if |defer_load| is set.
+  void CreateExecutable(bool defer_load,
+                        iree_status_code_t load_status_code) {
+    executable_ = new TestExecutable();
+    executable_->load_count.store(0);
+    executable_->load_status_code = load_status_code;
+    memset(executable_->dispatch_attrs, 0, sizeof(executable_->dispatch_attrs));
+    iree_hal_local_executable_initialize(
+        &kTestExecutableVtable, /*executable_layout_count=*/0,
+        /*source_executable_layouts=*/NULL,
+        /*target_executable_layouts=*/NULL, iree_allocator_system(),
+        &executable_->base);
+    if (defer_load) iree_hal_local_executable_defer_load(&executable_->base);
+  }
+
+  TestExecutable* executable_ = NULL;
+};
+
+// Executables that do not defer their load are usable immediately.
+TEST_F(LocalExecutableTest, NotDeferred) {
+  CreateExecutable(/*defer_load=*/false, IREE_STATUS_OK);
+  IREE_ASSERT_OK(iree_hal_local_executable_ensure_loaded(&executable_->base));
+  EXPECT_EQ(0, executable_->load_count.load());
+}
+
+// Deferred loads run once on first use and not on creation.
+TEST_F(LocalExecutableTest, DeferredLoadOnFirstUse) {
+  CreateExecutable(/*defer_load=*/true, IREE_STATUS_OK);
+  EXPECT_EQ(0, executable_->load_count.load());
+  EXPECT_EQ(NULL, executable_->base.dispatch_attrs);
+
+  IREE_ASSERT_OK(iree_hal_local_executable_ensure_loaded(&executable_->base));
+  EXPECT_EQ(1, executable_->load_count.load());
+  ASSERT_TRUE(executable_->base.dispatch_attrs);
+  EXPECT_EQ(1, executable_->base.dispatch_attrs[0].local_memory_pages);
+
+  IREE_ASSERT_OK(iree_hal_local_executable_ensure_loaded(&executable_->base));
+  EXPECT_EQ(1, executable_->load_count.load());
+}
+
+// A failing deferred load does not fail creation; the failure is reported on
+// first use and to every subsequent use without retrying the load.
+TEST_F(LocalExecutableTest, DeferredLoadFailureOnFirstUse) {
+  CreateExecutable(/*defer_load=*/true, IREE_STATUS_DATA_LOSS);
+  EXPECT_EQ(0, executable_->load_count.load());
+
+  for (int i = 0; i < 3; ++i) {
+    iree_status_t status =
+        iree_hal_local_executable_ensure_loaded(&executable_->base);
+    EXPECT_EQ(IREE_STATUS_DATA_LOSS, iree_status_code(status));
+    iree_status_ignore(status);
+  }
+  EXPECT_EQ(1, executable_->load_count.load());
+  EXPECT_EQ(NULL, executable_->base.dispatch_attrs);
+}
+
+// Concurrent first uses perform the deferred load once and all observe its
+// result.
+TEST_F(LocalExecutableTest, ConcurrentFirstUse) {
+  static const int kThreadCount = 8;
+  for (iree_status_code_t load_status_code :
+       {IREE_STATUS_OK, IREE_STATUS_DATA_LOSS}) {
+    iree_hal_executable_release((iree_hal_executable_t*)executable_);
+    CreateExecutable(/*defer_load=*/true, load_status_code);
+    std::atomic<bool> start = {false};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kThreadCount; ++i) {
+      threads.emplace_back([&]() {
+        while (!start.load()) std::this_thread::yield();
+        iree_status_t status =
+            iree_hal_local_executable_ensure_loaded(&executable_->base);
+        EXPECT_EQ(load_status_code, iree_status_code(status));
+        iree_status_ignore(status);
+        if (load_status_code == IREE_STATUS_OK) {
+          EXPECT_TRUE(executable_->base.dispatch_attrs);
+        }
+      });
+    }
+    start.store(true);
+    for (auto& thread : threads) thread.join();
+    EXPECT_EQ(1, executable_->load_count.load());
+  }
+}
+
+}  // namespace
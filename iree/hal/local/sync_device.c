@@ -19,6 +19,7 @@
 #include "iree/hal/local/sync_event.h"
 #include "iree/hal/local/sync_semaphore.h"
 #include "iree/hal/utils/buffer_transfer.h"
+#include "iree/hal/utils/dispatch_profiler.h"
 
 typedef struct iree_hal_sync_device_t {
   iree_hal_resource_t resource;
@@ -29,6 +30,12 @@ typedef struct iree_hal_sync_device_t {
 
   iree_hal_sync_semaphore_state_t semaphore_state;
 
+  // Optional parallel-for shared by all command buffers of the device.
+  iree_hal_parallel_for_t parallel_for;
+
+  // Captures dispatch timestamps from all command buffers while profiling.
+  iree_hal_dispatch_profiler_t profiler;
+
   iree_host_size_t loader_count;
   iree_hal_executable_loader_t* loaders[];
 } iree_hal_sync_device_t;
@@ -48,6 +55,11 @@ void iree_hal_sync_device_params_initialize(
 
 static iree_status_t iree_hal_sync_device_check_params(
     const iree_hal_sync_device_params_t* params) {
+  if (params->parallel_for.run &&
+      (!params->parallel_for.retain || !params->parallel_for.release)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "parallel-for must provide retain and release");
+  }
   return iree_ok_status();
 }
 
@@ -89,6 +101,12 @@ iree_status_t iree_hal_sync_device_create(
     }
 
     iree_hal_sync_semaphore_state_initialize(&device->semaphore_state);
+    iree_hal_dispatch_profiler_initialize(host_allocator, &device->profiler);
+
+    if (iree_hal_parallel_for_is_available(&params->parallel_for)) {
+      device->parallel_for = params->parallel_for;
+      device->parallel_for.retain(device->parallel_for.self);
+    }
   }
 
   if (iree_status_is_ok(status)) {
@@ -105,8 +123,13 @@ static void iree_hal_sync_device_destroy(iree_hal_device_t* base_device) {
   iree_allocator_t host_allocator = iree_hal_device_host_allocator(base_device);
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  iree_hal_dispatch_profiler_deinitialize(&device->profiler);
   iree_hal_sync_semaphore_state_deinitialize(&device->semaphore_state);
 
+  if (device->parallel_for.release) {
+    device->parallel_for.release(device->parallel_for.self);
+  }
+
   for (iree_host_size_t i = 0; i < device->loader_count; ++i) {
     iree_hal_executable_loader_release(device->loaders[i]);
   }
@@ -168,8 +191,15 @@ static iree_status_t iree_hal_sync_device_create_command_buffer(
     iree_hal_command_buffer_t** out_command_buffer) {
   // TODO(#4680): implement a non-inline command buffer that stores its commands
   // and can be submitted later on/multiple-times.
+  if (iree_all_bits_set(mode,
+                        IREE_HAL_COMMAND_BUFFER_MODE_INDIRECT_BINDINGS)) {
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "indirect command buffer bindings not supported");
+  }
+  iree_hal_sync_device_t* device = iree_hal_sync_device_cast(base_device);
   return iree_hal_inline_command_buffer_create(
       base_device, mode, command_categories, queue_affinity,
+      &device->parallel_for, &device->profiler,
       iree_hal_device_host_allocator(base_device), out_command_buffer);
 }
 
@@ -206,7 +236,8 @@ static iree_status_t iree_hal_sync_device_create_executable_cache(
   iree_hal_sync_device_t* device = iree_hal_sync_device_cast(base_device);
   return iree_hal_local_executable_cache_create(
       identifier, device->loader_count, device->loaders,
-      iree_hal_device_host_allocator(base_device), out_executable_cache);
+      /*environment=*/NULL, iree_hal_device_host_allocator(base_device),
+      out_executable_cache);
 }
 
 static iree_status_t iree_hal_sync_device_create_executable_layout(
@@ -227,6 +258,48 @@ static iree_status_t iree_hal_sync_device_create_semaphore(
                                         device->host_allocator, out_semaphore);
 }
 
+static iree_status_t iree_hal_sync_device_queue_alloca(
+    iree_hal_device_t* base_device, iree_hal_queue_affinity_t queue_affinity,
+    const iree_hal_semaphore_list_t wait_semaphore_list,
+    const iree_hal_semaphore_list_t signal_semaphore_list,
+    iree_hal_memory_type_t memory_type, iree_hal_buffer_usage_t allowed_usage,
+    iree_device_size_t allocation_size, iree_hal_buffer_t** out_buffer) {
+  iree_hal_sync_device_t* device = iree_hal_sync_device_cast(base_device);
+
+  // Everything executes inline and the queue order is the program order.
+  IREE_RETURN_IF_ERROR(iree_hal_sync_semaphore_multi_wait(
+      &device->semaphore_state, IREE_HAL_WAIT_MODE_ALL, &wait_semaphore_list,
+      iree_infinite_timeout()));
+  iree_hal_buffer_t* buffer = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_allocator_allocate_buffer(
+      device->device_allocator, memory_type, allowed_usage, allocation_size,
+      iree_const_byte_span_empty(), &buffer));
+  iree_status_t status = iree_hal_sync_semaphore_multi_signal(
+      &device->semaphore_state, &signal_semaphore_list);
+  if (iree_status_is_ok(status)) {
+    *out_buffer = buffer;
+  } else {
+    iree_hal_buffer_release(buffer);
+  }
+  return status;
+}
+
+static iree_status_t iree_hal_sync_device_queue_dealloca(
+    iree_hal_device_t* base_device, iree_hal_queue_affinity_t queue_affinity,
+    const iree_hal_semaphore_list_t wait_semaphore_list,
+    const iree_hal_semaphore_list_t signal_semaphore_list,
+    iree_hal_buffer_t* buffer) {
+  iree_hal_sync_device_t* device = iree_hal_sync_device_cast(base_device);
+
+  // Nothing is retained past the waits as all prior work has completed; the
+  // memory is returned when the caller releases its reference.
+  IREE_RETURN_IF_ERROR(iree_hal_sync_semaphore_multi_wait(
+      &device->semaphore_state, IREE_HAL_WAIT_MODE_ALL, &wait_semaphore_list,
+      iree_infinite_timeout()));
+  return iree_hal_sync_semaphore_multi_signal(&device->semaphore_state,
+                                              &signal_semaphore_list);
+}
+
 static iree_status_t iree_hal_sync_device_queue_submit(
     iree_hal_device_t* base_device,
     iree_hal_command_category_t command_categories,
@@ -289,6 +362,25 @@ static iree_status_t iree_hal_sync_device_wait_idle(
   return iree_ok_status();
 }
 
+static iree_status_t iree_hal_sync_device_profiling_begin(
+    iree_hal_device_t* base_device,
+    const iree_hal_device_profiling_options_t* options) {
+  iree_hal_sync_device_t* device = iree_hal_sync_device_cast(base_device);
+  return iree_hal_dispatch_profiler_begin(&device->profiler, options);
+}
+
+static iree_status_t iree_hal_sync_device_profiling_flush(
+    iree_hal_device_t* base_device) {
+  iree_hal_sync_device_t* device = iree_hal_sync_device_cast(base_device);
+  return iree_hal_dispatch_profiler_flush(&device->profiler);
+}
+
+static iree_status_t iree_hal_sync_device_profiling_end(
+    iree_hal_device_t* base_device) {
+  iree_hal_sync_device_t* device = iree_hal_sync_device_cast(base_device);
+  return iree_hal_dispatch_profiler_end(&device->profiler);
+}
+
 static const iree_hal_device_vtable_t iree_hal_sync_device_vtable = {
     .destroy = iree_hal_sync_device_destroy,
     .id = iree_hal_sync_device_id,
@@ -305,8 +397,13 @@ static const iree_hal_device_vtable_t iree_hal_sync_device_vtable = {
     .create_executable_layout = iree_hal_sync_device_create_executable_layout,
     .create_semaphore = iree_hal_sync_device_create_semaphore,
     .transfer_range = iree_hal_device_transfer_mappable_range,
+    .queue_alloca = iree_hal_sync_device_queue_alloca,
+    .queue_dealloca = iree_hal_sync_device_queue_dealloca,
     .queue_submit = iree_hal_sync_device_queue_submit,
     .submit_and_wait = iree_hal_sync_device_submit_and_wait,
     .wait_semaphores = iree_hal_sync_device_wait_semaphores,
     .wait_idle = iree_hal_sync_device_wait_idle,
+    .profiling_begin = iree_hal_sync_device_profiling_begin,
+    .profiling_flush = iree_hal_sync_device_profiling_flush,
+    .profiling_end = iree_hal_sync_device_profiling_end,
 };
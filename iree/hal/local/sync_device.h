@@ -10,6 +10,7 @@
 #include "iree/base/api.h"
 #include "iree/hal/api.h"
 #include "iree/hal/local/executable_loader.h"
+#include "iree/hal/local/inline_command_buffer.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -18,7 +19,11 @@ extern "C" {
 // Parameters configuring an iree_hal_sync_device_t.
 // Must be initialized with iree_hal_sync_device_params_initialize prior to use.
 typedef struct iree_hal_sync_device_params_t {
-  int reserved;
+  // Optional parallel-for used to split the workgroups of large dispatches
+  // across threads while all commands still execute in order on the thread
+  // issuing the submission. Retained by the device. Zero-initialized (the
+  // default) to execute everything on the calling thread.
+  iree_hal_parallel_for_t parallel_for;
 } iree_hal_sync_device_params_t;
 
 // Initializes |out_params| to default values.
@@ -64,6 +64,10 @@ iree_status_t iree_hal_sync_driver_create(
         (char*)driver + total_size - identifier.size);
     memcpy(&driver->default_params, default_params,
            sizeof(driver->default_params));
+    if (driver->default_params.parallel_for.retain) {
+      driver->default_params.parallel_for.retain(
+          driver->default_params.parallel_for.self);
+    }
 
     driver->loader_count = loader_count;
     for (iree_host_size_t i = 0; i < driver->loader_count; ++i) {
@@ -90,6 +94,10 @@ static void iree_hal_sync_driver_destroy(iree_hal_driver_t* base_driver) {
   for (iree_host_size_t i = 0; i < driver->loader_count; ++i) {
     iree_hal_executable_loader_release(driver->loaders[i]);
   }
+  if (driver->default_params.parallel_for.release) {
+    driver->default_params.parallel_for.release(
+        driver->default_params.parallel_for.self);
+  }
   iree_allocator_free(host_allocator, driver);
 
   IREE_TRACE_ZONE_END(z0);
@@ -12,6 +12,7 @@
 #include <string.h>
 
 #include "iree/base/api.h"
+#include "iree/base/internal/fpu_state.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/local/executable_library.h"
 #include "iree/hal/local/local_descriptor_set_layout.h"
@@ -23,10 +24,85 @@
 #include "iree/task/submission.h"
 #include "iree/task/task.h"
 
+#if defined(IREE_ARCH_X86_64)
+#include <emmintrin.h>
+#endif  // IREE_ARCH_X86_64
+
 //===----------------------------------------------------------------------===//
 // iree_hal_task_command_buffer_t
 //===----------------------------------------------------------------------===//
 
+// Number of task pointers stored in each recorded task block.
+#define IREE_HAL_TASK_COMMAND_BUFFER_RECORDED_BLOCK_CAPACITY 64
+
+// A block of tasks recorded into a reusable command buffer.
+// Blocks are allocated from the command buffer arena as recording proceeds and
+// are flattened into the replay table at the end of recording.
+typedef struct iree_hal_task_recorded_block_t {
+  struct iree_hal_task_recorded_block_t* next;
+  iree_host_size_t count;
+  iree_task_t* tasks[IREE_HAL_TASK_COMMAND_BUFFER_RECORDED_BLOCK_CAPACITY];
+} iree_hal_task_recorded_block_t;
+
+// The initial state of a recorded task as captured at the end of recording.
+// Execution consumes dependency counts, completion edges, and flags and this
+// is used to restore them prior to each submission of a reusable command
+// buffer.
+typedef struct iree_hal_task_replay_entry_t {
+  iree_task_t* task;
+  iree_task_t* completion_task;
+  // Source of the workgroup count for indirect dispatches; NULL otherwise.
+  const uint32_t* workgroup_count_ptr;
+  int32_t pending_dependency_count;
+  iree_task_flags_t flags;
+} iree_hal_task_replay_entry_t;
+
+// A dispatch binding that references a slot in the submission binding table.
+// Resolved into the dispatch binding tables on each issue of the command
+// buffer.
+typedef struct iree_hal_task_binding_fixup_t {
+  struct iree_hal_task_binding_fixup_t* next;
+  // Dispatch binding entries to populate.
+  void** binding_ptr;
+  size_t* binding_length;
+  // Binding table slot and the range within it of the binding.
+  uint32_t slot;
+  iree_device_size_t offset;
+  iree_device_size_t length;
+} iree_hal_task_binding_fixup_t;
+
+typedef struct iree_hal_task_command_buffer_t iree_hal_task_command_buffer_t;
+
+// Replay table of a reusable command buffer built at the end of recording.
+// All storage is allocated from the command buffer arena and lives until the
+// command buffer is reset or destroyed.
+typedef struct iree_hal_task_replay_t {
+  // Task that all leaf tasks of the DAG complete into. Its completion task is
+  // set to the retire task of the submission on each issue and its cleanup
+  // marks the command buffer as no longer executing. Must be first so that the
+  // cleanup function can get back to the replay table.
+  iree_task_nop_t join_task;
+  iree_hal_task_command_buffer_t* command_buffer;
+
+  // Initial ready tasks enqueued on each issue. The intrusive root task list
+  // is clobbered by execution and cannot be reused.
+  iree_host_size_t root_task_count;
+  iree_task_t** root_tasks;
+
+  // Initial state of every task in the DAG, including the join task.
+  iree_host_size_t entry_count;
+  iree_hal_task_replay_entry_t* entries;
+} iree_hal_task_replay_t;
+
+// Task that a streaming command buffer destroyed without having been issued
+// chains onto the tasks it already submitted. Its cleanup frees the command
+// buffer once they have all completed. Must be first so that the cleanup
+// function can get back to the command buffer.
+typedef struct iree_hal_task_stream_drain_t {
+  iree_task_nop_t task;
+  iree_hal_task_command_buffer_t* command_buffer;
+} iree_hal_task_stream_drain_t;
+
 // iree/task/-based command buffer.
 // We track a minimal amount of state here and incrementally build out the task
 // DAG that we can submit to the task system directly. There's no intermediate
@@ -35,12 +111,29 @@
 // additional allocations required during recording or execution. That means our
 // command buffer here is essentially just a builder for the task system types
 // and manager of the lifetime of the tasks.
-typedef struct iree_hal_task_command_buffer_t {
+//
+// Reusable (non-one-shot) command buffers build the task DAG once and capture
+// its initial state in a replay table at the end of recording. Each issue
+// restores the tasks in place and enqueues the roots again such that there is
+// no recording or allocation in the steady state. Submissions of the same
+// command buffer must not overlap and an issue while a prior one is still
+// executing fails.
+//
+// Command buffers allowing inline execution are streamed to the executor as
+// they are recorded: each global barrier submits the tasks recorded prior to it
+// such that execution overlaps with the remainder of the recording. The most
+// recent barrier is held with an additional dependency until the tasks after it
+// are known and the final hold is released when the command buffer is issued.
+struct iree_hal_task_command_buffer_t {
   iree_hal_command_buffer_t base;
   iree_allocator_t host_allocator;
 
+  iree_task_executor_t* executor;
   iree_task_scope_t* scope;
 
+  // Device profiler that dispatches report their execution times to.
+  iree_hal_dispatch_profiler_t* profiler;
+
   // Arena used for all allocations; references the shared device block pool.
   iree_arena_allocator_t arena;
 
@@ -60,6 +153,28 @@ typedef struct iree_hal_task_command_buffer_t {
   // An empty list indicates that root_tasks are also the leaves.
   iree_task_list_t leaf_tasks;
 
+  // Replay table built at the end of recording for reusable command buffers.
+  // NULL for one-shot command buffers and while recording.
+  iree_hal_task_replay_t* replay;
+
+  // 1 while a submission of a reusable command buffer is executing.
+  iree_atomic_int32_t replay_in_flight;
+
+  // Dispatch bindings resolved from the submission binding table on each issue
+  // when the command buffer was recorded with
+  // IREE_HAL_COMMAND_BUFFER_MODE_INDIRECT_BINDINGS.
+  iree_hal_task_binding_fixup_t* binding_fixups;
+
+  // The most recent global barrier of a streaming command buffer that has had
+  // prior tasks submitted for execution. Held with an additional pending
+  // dependency that is released once its dependent tasks have been recorded
+  // or on issue for the last barrier. NULL if nothing has been streamed.
+  iree_task_barrier_t* stream_barrier;
+
+  // Used to defer freeing of a streaming command buffer destroyed prior to
+  // issue until all of its submitted tasks have completed.
+  iree_hal_task_stream_drain_t stream_drain;
+
   // TODO(benvanik): move this out of the struct and allocate from the arena -
   // we only need this during recording and it's ~4KB of waste otherwise.
   // State tracked within the command buffer during recording only.
@@ -79,6 +194,20 @@ typedef struct iree_hal_task_command_buffer_t {
     // All execution tasks emitted that must execute after |open_barrier|.
     iree_task_list_t open_tasks;
 
+    // The number of execution tasks emitted since the last global barrier (or
+    // the start of the command buffer if there is none).
+    iree_host_size_t scope_task_count;
+
+    // The last dispatch recorded if it was the only task emitted since the last
+    // global barrier and a dispatch following a workgroup-local barrier may be
+    // chained to it. NULL if the next barrier must be a global barrier.
+    struct iree_hal_cmd_dispatch_t* chain_tail;
+
+    // True if a workgroup-local barrier was recorded after |chain_tail| and has
+    // not yet been resolved by chaining the next dispatch or emitting a global
+    // barrier in its place.
+    bool chain_barrier_pending;
+
     // A flattened list of all available descriptor set bindings.
     // As descriptor sets are pushed/bound the bindings will be updated to
     // represent the fully-translated binding data pointer.
@@ -90,12 +219,26 @@ typedef struct iree_hal_task_command_buffer_t {
         binding_lengths[IREE_HAL_LOCAL_MAX_DESCRIPTOR_SET_COUNT *
                         IREE_HAL_LOCAL_MAX_DESCRIPTOR_BINDING_COUNT];
 
+    // Binding table slot + 1 referenced by each indirect binding or 0 if the
+    // binding pointer was captured in |bindings|. Indirect bindings store the
+    // range within the slot in |binding_offsets| and |binding_lengths|.
+    uint32_t binding_slots[IREE_HAL_LOCAL_MAX_DESCRIPTOR_SET_COUNT *
+                           IREE_HAL_LOCAL_MAX_DESCRIPTOR_BINDING_COUNT];
+    iree_device_size_t
+        binding_offsets[IREE_HAL_LOCAL_MAX_DESCRIPTOR_SET_COUNT *
+                        IREE_HAL_LOCAL_MAX_DESCRIPTOR_BINDING_COUNT];
+
     // All available push constants updated each time push_constants is called.
     // Reset only with the command buffer and otherwise will maintain its values
     // during recording to allow for partial push_constants updates.
     uint32_t push_constants[IREE_HAL_LOCAL_MAX_PUSH_CONSTANT_COUNT];
+
+    // All tasks recorded so far when the command buffer is reusable.
+    iree_hal_task_recorded_block_t* recorded_head;
+    iree_hal_task_recorded_block_t* recorded_tail;
+    iree_host_size_t recorded_task_count;
   } state;
-} iree_hal_task_command_buffer_t;
+};
 
 static const iree_hal_command_buffer_vtable_t
     iree_hal_task_command_buffer_vtable;
@@ -107,28 +250,15 @@ static iree_hal_task_command_buffer_t* iree_hal_task_command_buffer_cast(
 }
 
 iree_status_t iree_hal_task_command_buffer_create(
-    iree_hal_device_t* device, iree_task_scope_t* scope,
-    iree_hal_command_buffer_mode_t mode,
+    iree_hal_device_t* device, iree_task_executor_t* executor,
+    iree_task_scope_t* scope, iree_hal_command_buffer_mode_t mode,
     iree_hal_command_category_t command_categories,
     iree_hal_queue_affinity_t queue_affinity,
-    iree_arena_block_pool_t* block_pool, iree_allocator_t host_allocator,
+    iree_arena_block_pool_t* block_pool,
+    iree_hal_dispatch_profiler_t* profiler, iree_allocator_t host_allocator,
     iree_hal_command_buffer_t** out_command_buffer) {
   IREE_ASSERT_ARGUMENT(out_command_buffer);
   *out_command_buffer = NULL;
-  if (!iree_all_bits_set(mode, IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT)) {
-    // If we want reuse we'd need to support duplicating the task DAG after
-    // recording or have some kind of copy-on-submit behavior that does so if
-    // a command buffer is submitted for execution twice. Allowing for the same
-    // command buffer to be enqueued multiple times would be fine so long as
-    // execution doesn't overlap (`cmdbuf|cmdbuf` vs
-    // `cmdbuf -> semaphore -> cmdbuf`) though we'd still need to be careful
-    // that we did the enqueuing and reset of the task structures at the right
-    // times. Definitely something that'll be useful in the future... but not
-    // today :)
-    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
-                            "only one-shot command buffer usage is supported");
-  }
-
   IREE_TRACE_ZONE_BEGIN(z0);
 
   iree_hal_task_command_buffer_t* command_buffer = NULL;
@@ -139,10 +269,17 @@ iree_status_t iree_hal_task_command_buffer_create(
         device, mode, command_categories, queue_affinity,
         &iree_hal_task_command_buffer_vtable, &command_buffer->base);
     command_buffer->host_allocator = host_allocator;
+    command_buffer->executor = executor;
     command_buffer->scope = scope;
+    command_buffer->profiler = profiler;
     iree_arena_initialize(block_pool, &command_buffer->arena);
     iree_task_list_initialize(&command_buffer->root_tasks);
     iree_task_list_initialize(&command_buffer->leaf_tasks);
+    command_buffer->replay = NULL;
+    iree_atomic_store_int32(&command_buffer->replay_in_flight, 0,
+                            iree_memory_order_relaxed);
+    command_buffer->binding_fixups = NULL;
+    command_buffer->stream_barrier = NULL;
     memset(&command_buffer->state, 0, sizeof(command_buffer->state));
     status = iree_hal_resource_set_allocate(block_pool,
                                             &command_buffer->resource_set);
@@ -160,23 +297,91 @@ iree_status_t iree_hal_task_command_buffer_create(
 static void iree_hal_task_command_buffer_reset(
     iree_hal_task_command_buffer_t* command_buffer) {
   memset(&command_buffer->state, 0, sizeof(command_buffer->state));
+  command_buffer->replay = NULL;
+  command_buffer->binding_fixups = NULL;
   iree_task_list_discard(&command_buffer->leaf_tasks);
   iree_task_list_discard(&command_buffer->root_tasks);
   iree_hal_resource_set_reset(command_buffer->resource_set);
   iree_arena_reset(&command_buffer->arena);
 }
 
+// Releases the hold on a |barrier| of a streaming command buffer. If all tasks
+// preceding the barrier have already completed it is ready to execute and is
+// enqueued into |pending_submission|.
+static void iree_hal_task_command_buffer_release_stream_barrier(
+    iree_task_barrier_t* barrier, iree_task_submission_t* pending_submission) {
+  if (iree_atomic_fetch_sub_int32(&barrier->header.pending_dependency_count, 1,
+                                  iree_memory_order_acq_rel) == 1) {
+    iree_task_submission_enqueue(pending_submission, &barrier->header);
+  }
+}
+
+static void iree_hal_task_command_buffer_free(
+    iree_hal_task_command_buffer_t* command_buffer) {
+  iree_allocator_t host_allocator = command_buffer->host_allocator;
+  iree_hal_task_command_buffer_reset(command_buffer);
+  iree_arena_deinitialize(&command_buffer->arena);
+  iree_hal_resource_set_free(command_buffer->resource_set);
+  iree_allocator_free(host_allocator, command_buffer);
+}
+
+// Called when the drain task of an abandoned streaming command buffer retires
+// or is discarded, indicating that all tasks that were submitted during
+// recording have completed and the command buffer can be freed.
+static void iree_hal_task_command_buffer_stream_drain_cleanup(
+    iree_task_t* task, iree_status_code_t status_code) {
+  iree_hal_task_stream_drain_t* drain = (iree_hal_task_stream_drain_t*)task;
+  iree_hal_task_command_buffer_t* command_buffer = drain->command_buffer;
+  iree_task_scope_t* scope = command_buffer->scope;
+  // The remaining tasks were never submitted and only their storage in the
+  // arena remains.
+  iree_task_list_initialize(&command_buffer->root_tasks);
+  iree_task_list_initialize(&command_buffer->leaf_tasks);
+  iree_hal_task_command_buffer_free(command_buffer);
+  iree_task_scope_end(scope);
+}
+
+// Abandons a streaming command buffer that has tasks executing but was never
+// issued. The tasks recorded after the held barrier are dropped and the drain
+// task is chained after it to free the command buffer once the submitted tasks
+// complete.
+static void iree_hal_task_command_buffer_abandon_stream(
+    iree_hal_task_command_buffer_t* command_buffer) {
+  iree_task_barrier_t* barrier = command_buffer->stream_barrier;
+  command_buffer->stream_barrier = NULL;
+  barrier->header.completion_task = NULL;
+  barrier->dependent_task_count = 0;
+  barrier->dependent_tasks = NULL;
+
+  iree_hal_task_stream_drain_t* drain = &command_buffer->stream_drain;
+  iree_task_nop_initialize(command_buffer->scope, &drain->task);
+  iree_task_set_cleanup_fn(&drain->task.header,
+                           iree_hal_task_command_buffer_stream_drain_cleanup);
+  drain->command_buffer = command_buffer;
+  iree_task_set_completion_task(&barrier->header, &drain->task.header);
+
+  iree_task_submission_t submission;
+  iree_task_submission_initialize(&submission);
+  iree_hal_task_command_buffer_release_stream_barrier(barrier, &submission);
+  if (!iree_task_submission_is_empty(&submission)) {
+    iree_task_executor_submit(command_buffer->executor, &submission);
+    iree_task_executor_flush(command_buffer->executor);
+  }
+}
+
 static void iree_hal_task_command_buffer_destroy(
     iree_hal_command_buffer_t* base_command_buffer) {
   iree_hal_task_command_buffer_t* command_buffer =
       iree_hal_task_command_buffer_cast(base_command_buffer);
-  iree_allocator_t host_allocator = command_buffer->host_allocator;
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  iree_hal_task_command_buffer_reset(command_buffer);
-  iree_arena_deinitialize(&command_buffer->arena);
-  iree_hal_resource_set_free(command_buffer->resource_set);
-  iree_allocator_free(host_allocator, command_buffer);
+  if (command_buffer->stream_barrier) {
+    // Tasks are still executing from the recording; freeing is deferred until
+    // they complete.
+    iree_hal_task_command_buffer_abandon_stream(command_buffer);
+  } else {
+    iree_hal_task_command_buffer_free(command_buffer);
+  }
 
   IREE_TRACE_ZONE_END(z0);
 }
@@ -203,10 +408,62 @@ static void* iree_hal_task_command_buffer_dyn_cast(
 static iree_status_t iree_hal_task_command_buffer_flush_tasks(
     iree_hal_task_command_buffer_t* command_buffer);
 
+// Returns true if the command buffer may be issued multiple times and must
+// retain the state required to restore its task DAG.
+static bool iree_hal_task_command_buffer_is_reusable(
+    iree_hal_task_command_buffer_t* command_buffer) {
+  return !iree_all_bits_set(iree_hal_command_buffer_mode(&command_buffer->base),
+                            IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT);
+}
+
+// Returns true if tasks may be submitted for execution as they are recorded.
+// Inline execution requires one-shot command buffers without indirect bindings
+// that are submitted without waits and as such all commands are ready to
+// execute as soon as they are recorded.
+static bool iree_hal_task_command_buffer_is_streaming(
+    iree_hal_task_command_buffer_t* command_buffer) {
+  return iree_all_bits_set(iree_hal_command_buffer_mode(&command_buffer->base),
+                           IREE_HAL_COMMAND_BUFFER_MODE_ALLOW_INLINE_EXECUTION);
+}
+
+// Tracks |task| for inclusion in the replay table if the command buffer is
+// reusable. One-shot command buffers need not track their tasks.
+static iree_status_t iree_hal_task_command_buffer_record_task(
+    iree_hal_task_command_buffer_t* command_buffer, iree_task_t* task) {
+  if (!iree_hal_task_command_buffer_is_reusable(command_buffer)) {
+    return iree_ok_status();
+  }
+  iree_hal_task_recorded_block_t* block = command_buffer->state.recorded_tail;
+  if (!block ||
+      block->count == IREE_HAL_TASK_COMMAND_BUFFER_RECORDED_BLOCK_CAPACITY) {
+    IREE_RETURN_IF_ERROR(iree_arena_allocate(
+        &command_buffer->arena, sizeof(*block), (void**)&block));
+    block->next = NULL;
+    block->count = 0;
+    if (command_buffer->state.recorded_tail) {
+      command_buffer->state.recorded_tail->next = block;
+    } else {
+      command_buffer->state.recorded_head = block;
+    }
+    command_buffer->state.recorded_tail = block;
+  }
+  block->tasks[block->count++] = task;
+  ++command_buffer->state.recorded_task_count;
+  return iree_ok_status();
+}
+
+static iree_status_t iree_hal_task_command_buffer_build_replay(
+    iree_hal_task_command_buffer_t* command_buffer);
+
 static iree_status_t iree_hal_task_command_buffer_begin(
     iree_hal_command_buffer_t* base_command_buffer) {
   iree_hal_task_command_buffer_t* command_buffer =
       iree_hal_task_command_buffer_cast(base_command_buffer);
+  if (command_buffer->stream_barrier) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "streaming command buffer has tasks executing and "
+                            "must be issued or destroyed before rerecording");
+  }
   iree_hal_task_command_buffer_reset(command_buffer);
   return iree_ok_status();
 }
@@ -221,13 +478,22 @@ static iree_status_t iree_hal_task_command_buffer_end(
       iree_hal_task_command_buffer_flush_tasks(command_buffer));
 
   // Move the tasks from the leaf list (tail) to the root list (head) if this
-  // was the first set of tasks recorded.
-  if (iree_task_list_is_empty(&command_buffer->root_tasks) &&
+  // was the first set of tasks recorded. Streamed command buffers have already
+  // submitted their roots.
+  if (!command_buffer->stream_barrier &&
+      iree_task_list_is_empty(&command_buffer->root_tasks) &&
       !iree_task_list_is_empty(&command_buffer->leaf_tasks)) {
     iree_task_list_move(&command_buffer->leaf_tasks,
                         &command_buffer->root_tasks);
   }
 
+  // Capture the initial state of the DAG so that it can be restored on each
+  // issue.
+  if (iree_hal_task_command_buffer_is_reusable(command_buffer)) {
+    IREE_RETURN_IF_ERROR(
+        iree_hal_task_command_buffer_build_replay(command_buffer));
+  }
+
   return iree_ok_status();
 }
 
@@ -280,6 +546,37 @@ static iree_status_t iree_hal_task_command_buffer_flush_tasks(
   return iree_ok_status();
 }
 
+// Submits all tasks recorded prior to the just-emitted global |barrier| for
+// execution. The barrier is held until the tasks recorded after it have been
+// linked on the next flush point and the previously held barrier is released
+// as its dependent tasks are now known.
+static void iree_hal_task_command_buffer_stream_tasks(
+    iree_hal_task_command_buffer_t* command_buffer,
+    iree_task_barrier_t* barrier) {
+  iree_atomic_fetch_add_int32(&barrier->header.pending_dependency_count, 1,
+                              iree_memory_order_relaxed);
+
+  iree_task_submission_t submission;
+  iree_task_submission_initialize(&submission);
+  if (command_buffer->stream_barrier) {
+    iree_hal_task_command_buffer_release_stream_barrier(
+        command_buffer->stream_barrier, &submission);
+  } else {
+    // First cut point: the root tasks are ready to run. The scope is kept
+    // active until the command buffer is issued so that waiters on it will not
+    // miss the tasks executing prior to the submission.
+    iree_task_scope_begin(command_buffer->scope);
+    iree_task_submission_enqueue_list(&submission,
+                                      &command_buffer->root_tasks);
+  }
+  command_buffer->stream_barrier = barrier;
+
+  if (!iree_task_submission_is_empty(&submission)) {
+    iree_task_executor_submit(command_buffer->executor, &submission);
+    iree_task_executor_flush(command_buffer->executor);
+  }
+}
+
 // Emits a global barrier, splitting execution into all prior recorded tasks
 // and all subsequent recorded tasks. This is currently the critical piece that
 // limits our concurrency: changing to fine-grained barriers (via barrier
@@ -287,6 +584,11 @@ static iree_status_t iree_hal_task_command_buffer_flush_tasks(
 // to build out the proper task graph.
 static iree_status_t iree_hal_task_command_buffer_emit_global_barrier(
     iree_hal_task_command_buffer_t* command_buffer) {
+  // A pending workgroup-local barrier is subsumed by this one.
+  command_buffer->state.scope_task_count = 0;
+  command_buffer->state.chain_tail = NULL;
+  command_buffer->state.chain_barrier_pending = false;
+
   // Flush open tasks to the previous barrier. This resets our state such that
   // we can assign the new open barrier and start recording tasks for it.
   // Previous tasks will be moved into the leaf_tasks list.
@@ -302,6 +604,8 @@ static iree_status_t iree_hal_task_command_buffer_emit_global_barrier(
   IREE_RETURN_IF_ERROR(iree_arena_allocate(&command_buffer->arena,
                                            sizeof(*barrier), (void**)&barrier));
   iree_task_barrier_initialize_empty(command_buffer->scope, barrier);
+  IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_record_task(
+      command_buffer, &barrier->header));
 
   // If there were previous tasks then join them to the barrier.
   for (iree_task_t* task = iree_task_list_front(&command_buffer->leaf_tasks);
@@ -311,7 +615,8 @@ static iree_status_t iree_hal_task_command_buffer_emit_global_barrier(
 
   // Move the tasks from the leaf list (tail) to the root list (head) if this
   // was the first set of tasks recorded.
-  if (iree_task_list_is_empty(&command_buffer->root_tasks) &&
+  if (!command_buffer->stream_barrier &&
+      iree_task_list_is_empty(&command_buffer->root_tasks) &&
       !iree_task_list_is_empty(&command_buffer->leaf_tasks)) {
     iree_task_list_move(&command_buffer->leaf_tasks,
                         &command_buffer->root_tasks);
@@ -327,6 +632,12 @@ static iree_status_t iree_hal_task_command_buffer_emit_global_barrier(
   command_buffer->state.open_barrier = barrier;
   command_buffer->state.open_task_count = 0;
 
+  // All tasks prior to the barrier are now fully linked and can begin
+  // executing while we continue recording.
+  if (iree_hal_task_command_buffer_is_streaming(command_buffer)) {
+    iree_hal_task_command_buffer_stream_tasks(command_buffer, barrier);
+  }
+
   return iree_ok_status();
 }
 
@@ -334,6 +645,17 @@ static iree_status_t iree_hal_task_command_buffer_emit_global_barrier(
 // scope (after state.open_barrier and before the next barrier).
 static iree_status_t iree_hal_task_command_buffer_emit_execution_task(
     iree_hal_task_command_buffer_t* command_buffer, iree_task_t* task) {
+  // Anything other than a chained dispatch after a workgroup-local barrier
+  // needs the barrier to be a real one.
+  if (command_buffer->state.chain_barrier_pending) {
+    IREE_RETURN_IF_ERROR(
+        iree_hal_task_command_buffer_emit_global_barrier(command_buffer));
+  }
+  command_buffer->state.chain_tail = NULL;
+  ++command_buffer->state.scope_task_count;
+
+  IREE_RETURN_IF_ERROR(
+      iree_hal_task_command_buffer_record_task(command_buffer, task));
   if (command_buffer->state.open_barrier == NULL) {
     // If there is no open barrier then we are at the head and going right into
     // the task DAG.
@@ -350,21 +672,282 @@ static iree_status_t iree_hal_task_command_buffer_emit_execution_task(
 // iree_hal_task_command_buffer_t execution
 //===----------------------------------------------------------------------===//
 
+// Resolves all indirect dispatch bindings against |binding_table|.
+// The dispatch binding tables are updated in place and must not be in use by
+// a prior submission.
+static iree_status_t iree_hal_task_command_buffer_apply_binding_table(
+    iree_hal_task_command_buffer_t* command_buffer,
+    const iree_hal_buffer_binding_table_t* binding_table) {
+  if (!command_buffer->binding_fixups) return iree_ok_status();
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_status_t status = iree_ok_status();
+  for (iree_hal_task_binding_fixup_t* fixup = command_buffer->binding_fixups;
+       fixup != NULL; fixup = fixup->next) {
+    if (IREE_UNLIKELY(fixup->slot >= binding_table->count)) {
+      status = iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                                "binding table slot %u out of range of the "
+                                "submission binding table (count=%zu)",
+                                fixup->slot, binding_table->count);
+      break;
+    }
+    const iree_hal_buffer_binding_t* binding =
+        &binding_table->bindings[fixup->slot];
+    if (IREE_UNLIKELY(!binding->buffer)) {
+      status = iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                                "binding table slot %u has no buffer",
+                                fixup->slot);
+      break;
+    }
+
+    // Apply the binding range relative to the slot range.
+    iree_device_size_t length = fixup->length;
+    if (binding->length != IREE_WHOLE_BUFFER) {
+      if (IREE_UNLIKELY(fixup->offset > binding->length)) {
+        status = iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                                  "binding offset exceeds the range of binding "
+                                  "table slot %u",
+                                  fixup->slot);
+        break;
+      }
+      iree_device_size_t remaining_length = binding->length - fixup->offset;
+      if (length == IREE_WHOLE_BUFFER) {
+        length = remaining_length;
+      } else if (IREE_UNLIKELY(length > remaining_length)) {
+        status = iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                                  "binding length exceeds the range of binding "
+                                  "table slot %u",
+                                  fixup->slot);
+        break;
+      }
+    }
+
+    // TODO(benvanik): track mapping so we can properly map/unmap/flush/etc.
+    iree_hal_buffer_mapping_t buffer_mapping = {{0}};
+    status = iree_hal_buffer_map_range(
+        binding->buffer, IREE_HAL_MAPPING_MODE_PERSISTENT,
+        IREE_HAL_MEMORY_ACCESS_ANY, binding->offset + fixup->offset, length,
+        &buffer_mapping);
+    if (!iree_status_is_ok(status)) break;
+    *fixup->binding_ptr = buffer_mapping.contents.data;
+    *fixup->binding_length = buffer_mapping.contents.data_length;
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Called when the join task of a reusable command buffer retires or is
+// discarded, indicating that all tasks of the submission have completed and
+// the command buffer may be issued again.
+static void iree_hal_task_command_buffer_replay_cleanup(
+    iree_task_t* task, iree_status_code_t status_code) {
+  iree_hal_task_replay_t* replay = (iree_hal_task_replay_t*)task;
+  iree_atomic_store_int32(&replay->command_buffer->replay_in_flight, 0,
+                          iree_memory_order_release);
+}
+
+// Builds the replay table of a reusable command buffer at the end of
+// recording. All leaf tasks are joined on a persistent task that gets chained
+// to the retire task of each submission and the initial state of every task is
+// captured so that it can be restored prior to each issue.
+static iree_status_t iree_hal_task_command_buffer_build_replay(
+    iree_hal_task_command_buffer_t* command_buffer) {
+  // Empty command buffers are no-ops and need no replay state.
+  if (iree_task_list_is_empty(&command_buffer->root_tasks)) {
+    return iree_ok_status();
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, command_buffer->state.recorded_task_count);
+
+  iree_hal_task_replay_t* replay = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_arena_allocate(&command_buffer->arena, sizeof(*replay),
+                              (void**)&replay));
+  iree_task_nop_initialize(command_buffer->scope, &replay->join_task);
+  iree_task_set_cleanup_fn(&replay->join_task.header,
+                           iree_hal_task_command_buffer_replay_cleanup);
+  replay->command_buffer = command_buffer;
+
+  // Join the leaf tasks. If we have no leaf tasks it means that this is a
+  // single layer DAG and the root tasks are also the leaves.
+  iree_task_list_t* tail_tasks =
+      iree_task_list_is_empty(&command_buffer->leaf_tasks)
+          ? &command_buffer->root_tasks
+          : &command_buffer->leaf_tasks;
+  for (iree_task_t* task = tail_tasks->head; task != NULL;
+       task = task->next_task) {
+    iree_task_set_completion_task(task, &replay->join_task.header);
+  }
+
+  replay->root_task_count = 0;
+  for (iree_task_t* task = command_buffer->root_tasks.head; task != NULL;
+       task = task->next_task) {
+    ++replay->root_task_count;
+  }
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_arena_allocate(&command_buffer->arena,
+                              replay->root_task_count * sizeof(iree_task_t*),
+                              (void**)&replay->root_tasks));
+  iree_host_size_t root_index = 0;
+  for (iree_task_t* task = command_buffer->root_tasks.head; task != NULL;
+       task = task->next_task) {
+    replay->root_tasks[root_index++] = task;
+  }
+
+  replay->entry_count = command_buffer->state.recorded_task_count + 1;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_arena_allocate(&command_buffer->arena,
+                              replay->entry_count * sizeof(*replay->entries),
+                              (void**)&replay->entries));
+  iree_host_size_t entry_index = 0;
+  for (iree_hal_task_recorded_block_t* block =
+           command_buffer->state.recorded_head;
+       block != NULL; block = block->next) {
+    for (iree_host_size_t i = 0; i < block->count; ++i) {
+      replay->entries[entry_index++].task = block->tasks[i];
+    }
+  }
+  replay->entries[entry_index++].task = &replay->join_task.header;
+  for (iree_host_size_t i = 0; i < replay->entry_count; ++i) {
+    iree_hal_task_replay_entry_t* entry = &replay->entries[i];
+    iree_task_t* task = entry->task;
+    entry->completion_task = task->completion_task;
+    entry->pending_dependency_count = iree_atomic_load_int32(
+        &task->pending_dependency_count, iree_memory_order_relaxed);
+    entry->flags = task->flags;
+    entry->workgroup_count_ptr = NULL;
+    if (task->type == IREE_TASK_TYPE_DISPATCH &&
+        iree_all_bits_set(task->flags, IREE_TASK_FLAG_DISPATCH_INDIRECT)) {
+      entry->workgroup_count_ptr =
+          ((iree_task_dispatch_t*)task)->workgroup_count.ptr;
+    }
+  }
+
+  // The replay table now owns the DAG. The intrusive lists are clobbered by
+  // execution and must not be walked (or discarded) again.
+  iree_task_list_initialize(&command_buffer->root_tasks);
+  iree_task_list_initialize(&command_buffer->leaf_tasks);
+  command_buffer->replay = replay;
+
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+// Restores the task DAG of a reusable command buffer to its recorded state and
+// enqueues its root tasks.
+static iree_status_t iree_hal_task_command_buffer_issue_replay(
+    iree_hal_task_command_buffer_t* command_buffer,
+    const iree_hal_buffer_binding_table_t* binding_table,
+    iree_task_t* retire_task, iree_task_submission_t* pending_submission) {
+  iree_hal_task_replay_t* replay = command_buffer->replay;
+
+  // The tasks are reset in place and cannot be shared by two submissions.
+  if (iree_atomic_exchange_int32(&command_buffer->replay_in_flight, 1,
+                                 iree_memory_order_acq_rel) != 0) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "reusable command buffer issued while a prior "
+                            "submission of it is still executing; submissions "
+                            "of the same command buffer must not overlap");
+  }
+
+  iree_status_t status = iree_hal_task_command_buffer_apply_binding_table(
+      command_buffer, binding_table);
+  if (!iree_status_is_ok(status)) {
+    iree_atomic_store_int32(&command_buffer->replay_in_flight, 0,
+                            iree_memory_order_release);
+    return status;
+  }
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, replay->entry_count);
+
+  for (iree_host_size_t i = 0; i < replay->entry_count; ++i) {
+    const iree_hal_task_replay_entry_t* entry = &replay->entries[i];
+    iree_task_t* task = entry->task;
+    task->next_task = NULL;
+    task->completion_task = entry->completion_task;
+    iree_atomic_store_int32(&task->pending_dependency_count,
+                            entry->pending_dependency_count,
+                            iree_memory_order_relaxed);
+    task->flags = entry->flags;
+    if (entry->workgroup_count_ptr) {
+      // Issuing an indirect dispatch replaces the pointer with the value.
+      ((iree_task_dispatch_t*)task)->workgroup_count.ptr =
+          entry->workgroup_count_ptr;
+    }
+  }
+
+  // Chain the retire task onto the join task as its completion indicates that
+  // all commands have completed.
+  iree_task_set_completion_task(&replay->join_task.header, retire_task);
+
+  // Enqueue all root tasks that are ready to run immediately. The tasks remain
+  // owned by the command buffer and are reset again on the next issue.
+  for (iree_host_size_t i = 0; i < replay->root_task_count; ++i) {
+    iree_task_submission_enqueue(pending_submission, replay->root_tasks[i]);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+// Issues a streaming command buffer that has had tasks submitted during
+// recording. All tasks after the held barrier are still pending on it and are
+// linked to |retire_task| prior to releasing the barrier.
+static void iree_hal_task_command_buffer_issue_stream(
+    iree_hal_task_command_buffer_t* command_buffer, iree_task_t* retire_task,
+    iree_task_submission_t* pending_submission) {
+  for (iree_task_t* task = command_buffer->leaf_tasks.head; task != NULL;
+       task = task->next_task) {
+    iree_task_set_completion_task(task, retire_task);
+  }
+  iree_task_list_initialize(&command_buffer->leaf_tasks);
+
+  iree_task_barrier_t* barrier = command_buffer->stream_barrier;
+  command_buffer->stream_barrier = NULL;
+  iree_hal_task_command_buffer_release_stream_barrier(barrier,
+                                                      pending_submission);
+
+  // The submission now keeps the scope active until the retire task runs.
+  iree_task_scope_end(command_buffer->scope);
+}
+
 iree_status_t iree_hal_task_command_buffer_issue(
     iree_hal_command_buffer_t* base_command_buffer,
-    iree_hal_task_queue_state_t* queue_state, iree_task_t* retire_task,
-    iree_arena_allocator_t* arena, iree_task_submission_t* pending_submission) {
+    iree_hal_task_queue_state_t* queue_state,
+    const iree_hal_buffer_binding_table_t* binding_table,
+    iree_task_t* retire_task, iree_arena_allocator_t* arena,
+    iree_task_submission_t* pending_submission) {
   iree_hal_task_command_buffer_t* command_buffer =
       iree_hal_command_buffer_dyn_cast(base_command_buffer,
                                        &iree_hal_task_command_buffer_vtable);
   IREE_ASSERT_TRUE(command_buffer);
 
+  // Reusable command buffers restore their DAG from the replay table.
+  if (command_buffer->replay) {
+    return iree_hal_task_command_buffer_issue_replay(
+        command_buffer, binding_table, retire_task, pending_submission);
+  }
+
+  // Streamed command buffers are already executing and only need their tail
+  // joined with the retire task before the last held barrier is released.
+  if (command_buffer->stream_barrier) {
+    iree_hal_task_command_buffer_issue_stream(command_buffer, retire_task,
+                                              pending_submission);
+    return iree_ok_status();
+  }
+
   // If the command buffer is empty (valid!) then we are a no-op.
   bool has_root_tasks = !iree_task_list_is_empty(&command_buffer->root_tasks);
   if (!has_root_tasks) {
     return iree_ok_status();
   }
 
+  // Resolve indirect bindings prior to the tasks becoming ready to execute.
+  IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_apply_binding_table(
+      command_buffer, binding_table));
+
   bool has_leaf_tasks = !iree_task_list_is_empty(&command_buffer->leaf_tasks);
   if (has_leaf_tasks) {
     // Chain the retire task onto the leaf tasks as their completion indicates
@@ -424,6 +1007,16 @@ static iree_status_t iree_hal_task_command_buffer_execution_barrier(
   iree_hal_task_command_buffer_t* command_buffer =
       iree_hal_task_command_buffer_cast(base_command_buffer);
 
+  // Workgroup-local barriers after a lone dispatch are deferred until the next
+  // command is recorded: if it is a compatible dispatch it is chained to the
+  // previous one and otherwise the global barrier is emitted then.
+  if (iree_all_bits_set(flags,
+                        IREE_HAL_EXECUTION_BARRIER_FLAG_WORKGROUP_LOCAL) &&
+      command_buffer->state.chain_tail) {
+    command_buffer->state.chain_barrier_pending = true;
+    return iree_ok_status();
+  }
+
   // TODO(benvanik): actual DAG construction. Right now we are just doing simple
   // global barriers each time and forcing a join-fork point.
   return iree_hal_task_command_buffer_emit_global_barrier(command_buffer);
@@ -480,16 +1073,130 @@ static iree_status_t iree_hal_task_command_buffer_discard_buffer(
 }
 
 //===----------------------------------------------------------------------===//
-// iree_hal_command_buffer_fill_buffer
+// Transfer tiling
 //===----------------------------------------------------------------------===//
-// NOTE: for large copies we dispatch this as tiles for parallelism.
-// We'd want to do some measurement for when it's worth it; filling a 200KB
-// buffer: maybe not, filling a 200MB buffer: yeah. For now we just do
-// arbitrarily sized chunks.
+// Large fills and copies are dispatched as tiles for parallelism: a single core
+// can only keep a fraction of the memory bandwidth of the system busy and it
+// takes several cores issuing requests to saturate it. Slices are sized such
+// that every worker gets a few of them to balance the load with stealing while
+// keeping the per-tile overhead small relative to the bytes moved.
+
+// Transfers up to this length are executed as a single tile as waking workers
+// costs more than the transfer itself.
+#define IREE_HAL_CMD_TRANSFER_MIN_SLICE_LENGTH (256 * 1024)
+
+// Maximum length of a single slice. Bounds the granularity of the work that
+// can be stolen for very large transfers.
+#define IREE_HAL_CMD_TRANSFER_MAX_SLICE_LENGTH (16 * 1024 * 1024)
+
+// Number of slices each worker should receive for a large transfer.
+#define IREE_HAL_CMD_TRANSFER_SLICES_PER_WORKER 4
+
+// Slices are aligned to pages such that neighboring slices executed on
+// different workers never share a cache line. Also a multiple of all fill
+// pattern lengths.
+#define IREE_HAL_CMD_TRANSFER_SLICE_ALIGNMENT 4096
+
+// Slices at least this large are written with non-temporal stores where
+// available. The written data is unlikely to still be in cache by the time it
+// is consumed and streaming it avoids evicting everything else (and the read
+// for ownership of each target line).
+#define IREE_HAL_CMD_TRANSFER_STREAMING_MIN_LENGTH (1024 * 1024)
+
+// Selects the slice length used to tile a transfer of |length| bytes.
+static uint32_t iree_hal_task_command_buffer_transfer_slice_length(
+    iree_hal_task_command_buffer_t* command_buffer, iree_device_size_t length) {
+  iree_host_size_t slice_count =
+      iree_task_executor_worker_count(command_buffer->executor) *
+      IREE_HAL_CMD_TRANSFER_SLICES_PER_WORKER;
+  iree_device_size_t slice_length =
+      iree_device_align(length / iree_max(1, slice_count),
+                        IREE_HAL_CMD_TRANSFER_SLICE_ALIGNMENT);
+  slice_length = iree_max(slice_length, IREE_HAL_CMD_TRANSFER_MIN_SLICE_LENGTH);
+  slice_length = iree_min(slice_length, IREE_HAL_CMD_TRANSFER_MAX_SLICE_LENGTH);
+  return (uint32_t)slice_length;
+}
+
+// Returns the number of slices of |slice_length| required to cover |length|.
+static uint32_t iree_hal_task_command_buffer_transfer_slice_count(
+    iree_device_size_t length, uint32_t slice_length) {
+  return (uint32_t)iree_max(1, (length + slice_length - 1) / slice_length);
+}
 
-// TODO(benvanik): make this a configurable setting. Must be aligned to pattern
-// length so pick a power of two.
-#define IREE_HAL_CMD_FILL_SLICE_LENGTH (128 * 1024)
+// Returns true if a transfer of |length| bytes into |target_buffer| should use
+// non-temporal stores.
+static bool iree_hal_cmd_transfer_should_stream(
+    iree_hal_buffer_t* target_buffer, iree_device_size_t length) {
+#if defined(IREE_ARCH_X86_64)
+  // Non-coherent memory requires flushes that we leave to the buffer utilities.
+  return length >= IREE_HAL_CMD_TRANSFER_STREAMING_MIN_LENGTH &&
+         iree_all_bits_set(iree_hal_buffer_memory_type(target_buffer),
+                           IREE_HAL_MEMORY_TYPE_HOST_COHERENT);
+#else
+  return false;
+#endif  // IREE_ARCH_X86_64
+}
+
+#if defined(IREE_ARCH_X86_64)
+
+// Fills |length| bytes of |target| with the 16-byte |value| using non-temporal
+// stores. |value| must be in phase with |target|: the byte at address A must be
+// byte A % 16 of the pattern.
+static void iree_hal_cmd_fill_streaming(uint8_t* target,
+                                        iree_host_size_t length,
+                                        __m128i value) {
+  uint8_t value_bytes[16];
+  _mm_storeu_si128((__m128i*)value_bytes, value);
+  // Unaligned head up to the first 16-byte boundary.
+  iree_host_size_t head_length =
+      iree_min(length, (16 - ((uintptr_t)target & 15)) & 15);
+  memcpy(target, value_bytes + ((uintptr_t)target & 15), head_length);
+  target += head_length;
+  length -= head_length;
+  iree_host_size_t body_length = length & ~(iree_host_size_t)63;
+  for (iree_host_size_t i = 0; i < body_length; i += 64) {
+    _mm_stream_si128((__m128i*)(target + i + 0), value);
+    _mm_stream_si128((__m128i*)(target + i + 16), value);
+    _mm_stream_si128((__m128i*)(target + i + 32), value);
+    _mm_stream_si128((__m128i*)(target + i + 48), value);
+  }
+  // Make the streamed stores visible to other cores before the tile completes.
+  _mm_sfence();
+  // Tail is aligned to 16 and so starts at byte 0 of the pattern.
+  for (iree_host_size_t i = body_length; i < length; i += 16) {
+    memcpy(target + i, value_bytes, iree_min(16, length - i));
+  }
+}
+
+// Copies |length| bytes from |source| to |target| using non-temporal stores.
+static void iree_hal_cmd_copy_streaming(uint8_t* target, const uint8_t* source,
+                                        iree_host_size_t length) {
+  iree_host_size_t head_length =
+      iree_min(length, (16 - ((uintptr_t)target & 15)) & 15);
+  memcpy(target, source, head_length);
+  target += head_length;
+  source += head_length;
+  length -= head_length;
+  iree_host_size_t body_length = length & ~(iree_host_size_t)63;
+  for (iree_host_size_t i = 0; i < body_length; i += 64) {
+    __m128i v0 = _mm_loadu_si128((const __m128i*)(source + i + 0));
+    __m128i v1 = _mm_loadu_si128((const __m128i*)(source + i + 16));
+    __m128i v2 = _mm_loadu_si128((const __m128i*)(source + i + 32));
+    __m128i v3 = _mm_loadu_si128((const __m128i*)(source + i + 48));
+    _mm_stream_si128((__m128i*)(target + i + 0), v0);
+    _mm_stream_si128((__m128i*)(target + i + 16), v1);
+    _mm_stream_si128((__m128i*)(target + i + 32), v2);
+    _mm_stream_si128((__m128i*)(target + i + 48), v3);
+  }
+  _mm_sfence();
+  memcpy(target + body_length, source + body_length, length - body_length);
+}
+
+#endif  // IREE_ARCH_X86_64
+
+//===----------------------------------------------------------------------===//
+// iree_hal_command_buffer_fill_buffer
+//===----------------------------------------------------------------------===//
 
 typedef struct iree_hal_cmd_fill_buffer_t {
   iree_task_dispatch_t task;
@@ -509,15 +1216,53 @@ static iree_status_t iree_hal_cmd_fill_tile(
 
   uint32_t length_per_slice = tile_context->workgroup_size[0];
   iree_device_size_t slice_offset =
-      tile_context->workgroup_xyz[0] * length_per_slice;
+      (iree_device_size_t)tile_context->workgroup_xyz[0] * length_per_slice;
   iree_device_size_t remaining_length = cmd->length - slice_offset;
   iree_device_size_t slice_length =
       iree_min(length_per_slice, remaining_length);
   IREE_TRACE_ZONE_APPEND_VALUE(z0, (uint64_t)slice_length);
 
-  iree_status_t status = iree_hal_buffer_fill(
-      cmd->target_buffer, cmd->target_offset + slice_offset, slice_length,
-      cmd->pattern, cmd->pattern_length);
+  iree_status_t status = iree_ok_status();
+#if defined(IREE_ARCH_X86_64)
+  if (iree_hal_cmd_transfer_should_stream(cmd->target_buffer, slice_length)) {
+    iree_hal_buffer_mapping_t target_mapping = {{0}};
+    status = iree_hal_buffer_map_range(
+        cmd->target_buffer, IREE_HAL_MAPPING_MODE_SCOPED,
+        IREE_HAL_MEMORY_ACCESS_DISCARD_WRITE, cmd->target_offset + slice_offset,
+        slice_length, &target_mapping);
+    if (iree_status_is_ok(status)) {
+      // Splat the pattern to 16 bytes in phase with the (pattern-aligned)
+      // target address.
+      uint32_t value_bits = 0;
+      switch (cmd->pattern_length) {
+        case 1:
+          value_bits = *(const uint8_t*)cmd->pattern * 0x01010101u;
+          break;
+        case 2:
+          value_bits = *(const uint16_t*)cmd->pattern * 0x00010001u;
+          break;
+        default:
+          value_bits = *(const uint32_t*)cmd->pattern;
+          break;
+      }
+      uint8_t* target_ptr = target_mapping.contents.data;
+      uint32_t phase = (uint32_t)((uintptr_t)target_ptr % 4) * 8;
+      if (phase) {
+        value_bits = (value_bits >> (32 - phase)) | (value_bits << phase);
+      }
+      iree_hal_cmd_fill_streaming(target_ptr,
+                                  target_mapping.contents.data_length,
+                                  _mm_set1_epi32((int32_t)value_bits));
+      status = iree_hal_buffer_unmap_range(&target_mapping);
+    }
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
+#endif  // IREE_ARCH_X86_64
+
+  status = iree_hal_buffer_fill(cmd->target_buffer,
+                                cmd->target_offset + slice_offset, slice_length,
+                                cmd->pattern, cmd->pattern_length);
 
   IREE_TRACE_ZONE_END(z0);
   return status;
@@ -539,12 +1284,14 @@ static iree_status_t iree_hal_task_command_buffer_fill_buffer(
       iree_arena_allocate(&command_buffer->arena, sizeof(*cmd), (void**)&cmd));
 
   const uint32_t workgroup_size[3] = {
-      /*x=*/IREE_HAL_CMD_FILL_SLICE_LENGTH,
+      /*x=*/iree_hal_task_command_buffer_transfer_slice_length(command_buffer,
+                                                               length),
       /*y=*/1,
       /*z=*/1,
   };
   const uint32_t workgroup_count[3] = {
-      /*x=*/length / workgroup_size[0] + 1,
+      /*x=*/iree_hal_task_command_buffer_transfer_slice_count(
+          length, workgroup_size[0]),
       /*y=*/1,
       /*z=*/1,
   };
@@ -621,14 +1368,6 @@ static iree_status_t iree_hal_task_command_buffer_update_buffer(
 //===----------------------------------------------------------------------===//
 // iree_hal_command_buffer_copy_buffer
 //===----------------------------------------------------------------------===//
-// NOTE: for large copies we dispatch this as tiles for parallelism.
-// We'd want to do some measurement for when it's worth it; copying a 200KB
-// buffer: maybe not, copying a 200MB buffer: yeah. For now we just do
-// arbitrarily sized chunks.
-
-// TODO(benvanik): make this a configurable setting. Must be aligned to pattern
-// length so pick a power of two.
-#define IREE_HAL_CMD_COPY_SLICE_LENGTH (128 * 1024)
 
 typedef struct iree_hal_cmd_copy_buffer_t {
   iree_task_dispatch_t task;
@@ -648,13 +1387,46 @@ static iree_status_t iree_hal_cmd_copy_tile(
 
   uint32_t length_per_slice = tile_context->workgroup_size[0];
   iree_device_size_t slice_offset =
-      tile_context->workgroup_xyz[0] * length_per_slice;
+      (iree_device_size_t)tile_context->workgroup_xyz[0] * length_per_slice;
   iree_device_size_t remaining_length = cmd->length - slice_offset;
   iree_device_size_t slice_length =
       iree_min(length_per_slice, remaining_length);
   IREE_TRACE_ZONE_APPEND_VALUE(z0, (uint64_t)slice_length);
 
-  iree_status_t status = iree_hal_buffer_copy_data(
+  iree_status_t status = iree_ok_status();
+#if defined(IREE_ARCH_X86_64)
+  if (iree_hal_cmd_transfer_should_stream(cmd->target_buffer, slice_length) &&
+      iree_hal_buffer_test_overlap(
+          cmd->source_buffer, cmd->source_offset + slice_offset, slice_length,
+          cmd->target_buffer, cmd->target_offset + slice_offset,
+          slice_length) == IREE_HAL_BUFFER_OVERLAP_DISJOINT) {
+    iree_hal_buffer_mapping_t source_mapping = {{0}};
+    iree_hal_buffer_mapping_t target_mapping = {{0}};
+    status = iree_hal_buffer_map_range(
+        cmd->source_buffer, IREE_HAL_MAPPING_MODE_SCOPED,
+        IREE_HAL_MEMORY_ACCESS_READ, cmd->source_offset + slice_offset,
+        slice_length, &source_mapping);
+    if (iree_status_is_ok(status)) {
+      status = iree_hal_buffer_map_range(
+          cmd->target_buffer, IREE_HAL_MAPPING_MODE_SCOPED,
+          IREE_HAL_MEMORY_ACCESS_DISCARD_WRITE,
+          cmd->target_offset + slice_offset, slice_length, &target_mapping);
+      if (iree_status_is_ok(status)) {
+        iree_hal_cmd_copy_streaming(
+            target_mapping.contents.data, source_mapping.contents.data,
+            iree_min(source_mapping.contents.data_length,
+                     target_mapping.contents.data_length));
+        status = iree_hal_buffer_unmap_range(&target_mapping);
+      }
+      status = iree_status_join(status,
+                                iree_hal_buffer_unmap_range(&source_mapping));
+    }
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
+#endif  // IREE_ARCH_X86_64
+
+  status = iree_hal_buffer_copy_data(
       cmd->source_buffer, cmd->source_offset + slice_offset, cmd->target_buffer,
       cmd->target_offset + slice_offset, slice_length);
 
@@ -679,12 +1451,14 @@ static iree_status_t iree_hal_task_command_buffer_copy_buffer(
       iree_arena_allocate(&command_buffer->arena, sizeof(*cmd), (void**)&cmd));
 
   const uint32_t workgroup_size[3] = {
-      /*x=*/IREE_HAL_CMD_COPY_SLICE_LENGTH,
+      /*x=*/iree_hal_task_command_buffer_transfer_slice_length(command_buffer,
+                                                               length),
       /*y=*/1,
       /*z=*/1,
   };
   const uint32_t workgroup_count[3] = {
-      /*x=*/length / workgroup_size[0] + 1,
+      /*x=*/iree_hal_task_command_buffer_transfer_slice_count(
+          length, workgroup_size[0]),
       /*y=*/1,
       /*z=*/1,
   };
@@ -755,6 +1529,25 @@ static iree_status_t iree_hal_task_command_buffer_push_descriptor_set(
     }
     iree_host_size_t binding_ordinal = binding_base + bindings[i].binding;
 
+    if (!bindings[i].buffer &&
+        iree_all_bits_set(iree_hal_command_buffer_mode(base_command_buffer),
+                          IREE_HAL_COMMAND_BUFFER_MODE_INDIRECT_BINDINGS)) {
+      // Indirect binding resolved from the binding table on each issue.
+      if (IREE_UNLIKELY(bindings[i].buffer_slot == UINT32_MAX)) {
+        return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                                "binding table slot out of bounds");
+      }
+      command_buffer->state.bindings[binding_ordinal] = NULL;
+      command_buffer->state.binding_slots[binding_ordinal] =
+          bindings[i].buffer_slot + 1;
+      command_buffer->state.binding_offsets[binding_ordinal] =
+          bindings[i].offset;
+      command_buffer->state.binding_lengths[binding_ordinal] =
+          bindings[i].length;
+      continue;
+    }
+    command_buffer->state.binding_slots[binding_ordinal] = 0;
+
     // TODO(benvanik): batch insert by getting the resources in their own list.
     IREE_RETURN_IF_ERROR(iree_hal_resource_set_insert(
         command_buffer->resource_set, 1, &bindings[i].buffer));
@@ -798,6 +1591,18 @@ typedef struct iree_hal_cmd_dispatch_t {
   iree_hal_local_executable_t* executable;
   int32_t ordinal;
 
+  // Dispatch executed for each workgroup after this one completes it when the
+  // two were recorded with a workgroup-local barrier between them. Only the
+  // task of the first dispatch in a chain is emitted.
+  struct iree_hal_cmd_dispatch_t* next_chained;
+
+  // Profiler the dispatch reports to when it retires, if any.
+  iree_hal_dispatch_profiler_t* profiler;
+
+  // FPU state required by the dispatch. Workers flush denormals to zero by
+  // default and only switch when this differs.
+  iree_fpu_state_flags_t fpu_flags;
+
   // Total number of available 4 byte push constant values in |push_constants|.
   uint16_t push_constant_count;
 
@@ -812,47 +1617,145 @@ typedef struct iree_hal_cmd_dispatch_t {
   // - const size_t binding_lengths[binding_count];
 } iree_hal_cmd_dispatch_t;
 
-static iree_status_t iree_hal_cmd_dispatch_tile(
-    void* user_context, const iree_task_tile_context_t* tile_context,
-    iree_task_submission_t* pending_submission) {
-  const iree_hal_cmd_dispatch_t* cmd =
-      (const iree_hal_cmd_dispatch_t*)user_context;
-  IREE_TRACE_ZONE_BEGIN(z0);
-
-  iree_hal_executable_dispatch_state_v0_t state;
-  memset(&state, 0, sizeof(state));
-  memcpy(state.workgroup_count.value, tile_context->workgroup_count,
-         sizeof(state.workgroup_count));
-  memcpy(state.workgroup_size.value, tile_context->workgroup_size,
-         sizeof(state.workgroup_size));
+// Populates the dispatch |state| shared by all workgroups of |cmd|.
+static void iree_hal_cmd_dispatch_prepare_state(
+    const iree_hal_cmd_dispatch_t* cmd,
+    const iree_task_tile_context_t* tile_context,
+    iree_hal_executable_dispatch_state_v0_t* state) {
+  memset(state, 0, sizeof(*state));
+  memcpy(state->workgroup_count.value, tile_context->workgroup_count,
+         sizeof(state->workgroup_count));
+  memcpy(state->workgroup_size.value, tile_context->workgroup_size,
+         sizeof(state->workgroup_size));
 
   uint8_t* cmd_ptr = (uint8_t*)cmd + sizeof(*cmd);
 
-  state.push_constant_count = cmd->push_constant_count;
-  state.push_constants = (uint32_t*)cmd_ptr;
-  cmd_ptr += cmd->push_constant_count * sizeof(*state.push_constants);
+  state->push_constant_count = cmd->push_constant_count;
+  state->push_constants = (uint32_t*)cmd_ptr;
+  cmd_ptr += cmd->push_constant_count * sizeof(*state->push_constants);
 
-  state.binding_count = cmd->binding_count;
-  state.binding_ptrs = (void**)cmd_ptr;
-  cmd_ptr += cmd->binding_count * sizeof(*state.binding_ptrs);
-  state.binding_lengths = (size_t*)cmd_ptr;
-  cmd_ptr += cmd->binding_count * sizeof(*state.binding_lengths);
+  state->binding_count = cmd->binding_count;
+  state->binding_ptrs = (void**)cmd_ptr;
+  cmd_ptr += cmd->binding_count * sizeof(*state->binding_ptrs);
+  state->binding_lengths = (size_t*)cmd_ptr;
+  cmd_ptr += cmd->binding_count * sizeof(*state->binding_lengths);
 
   // When we support imports we can populate those here based on what the
   // executable declared (as each executable may import a unique set of
   // functions).
-  state.import_thunk = cmd->executable->import_thunk;
-  state.imports = cmd->executable->imports;
+  state->import_thunk = cmd->executable->import_thunk;
+  state->imports = cmd->executable->imports;
+}
+
+static iree_status_t iree_hal_cmd_dispatch_tile(
+    void* user_context, const iree_task_tile_context_t* tile_context,
+    iree_task_submission_t* pending_submission) {
+  IREE_TRACE_ZONE_BEGIN(z0);
 
-  iree_status_t status = iree_hal_local_executable_issue_call(
-      cmd->executable, cmd->ordinal, &state,
-      (const iree_hal_vec3_t*)tile_context->workgroup_xyz,
-      tile_context->local_memory);
+  iree_status_t status = iree_ok_status();
+  for (const iree_hal_cmd_dispatch_t* cmd =
+           (const iree_hal_cmd_dispatch_t*)user_context;
+       cmd && iree_status_is_ok(status); cmd = cmd->next_chained) {
+    iree_hal_executable_dispatch_state_v0_t state;
+    iree_hal_cmd_dispatch_prepare_state(cmd, tile_context, &state);
+
+    iree_fpu_state_t fpu_state = iree_fpu_state_push(cmd->fpu_flags);
+    status = iree_hal_local_executable_issue_call(
+        cmd->executable, cmd->ordinal, &state,
+        (const iree_hal_vec3_t*)tile_context->workgroup_xyz,
+        tile_context->local_memory);
+    iree_fpu_state_pop(fpu_state);
+  }
 
   IREE_TRACE_ZONE_END(z0);
   return status;
 }
 
+// Executes a contiguous range of workgroups reserved by a task shard. The
+// dispatch state is built once and the executable range entry point (if any)
+// loops over the workgroups without returning to the task system.
+//
+// Chained dispatches run over the whole range one after the other: each
+// workgroup of a dispatch only depends on the same workgroup of the previous
+// one, which has completed by the time the next dispatch starts the range.
+static iree_status_t iree_hal_cmd_dispatch_tile_range(
+    void* user_context, const iree_task_tile_context_t* tile_context,
+    uint32_t tile_base, uint32_t tile_count,
+    iree_task_submission_t* pending_submission) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_status_t status = iree_ok_status();
+  for (const iree_hal_cmd_dispatch_t* cmd =
+           (const iree_hal_cmd_dispatch_t*)user_context;
+       cmd && iree_status_is_ok(status); cmd = cmd->next_chained) {
+    iree_hal_executable_dispatch_state_v0_t state;
+    iree_hal_cmd_dispatch_prepare_state(cmd, tile_context, &state);
+
+    iree_fpu_state_t fpu_state = iree_fpu_state_push(cmd->fpu_flags);
+    status = iree_hal_local_executable_issue_range_call(
+        cmd->executable, cmd->ordinal, &state, tile_base, tile_count,
+        tile_context->local_memory);
+    iree_fpu_state_pop(fpu_state);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Reports the execution of a dispatch to the device profiler.
+static void iree_hal_cmd_dispatch_profile(void* user_context,
+                                          const iree_task_dispatch_t* task,
+                                          iree_time_t issue_time,
+                                          iree_time_t retire_time) {
+  const iree_hal_cmd_dispatch_t* cmd =
+      (const iree_hal_cmd_dispatch_t*)user_context;
+  if (!iree_hal_dispatch_profiler_is_active(cmd->profiler)) return;
+  iree_hal_device_profiling_dispatch_t dispatch;
+  const char* const* names = cmd->executable->entry_point_names;
+  dispatch.entry_point_name = names && names[cmd->ordinal]
+                                  ? iree_make_cstring_view(names[cmd->ordinal])
+                                  : iree_string_view_empty();
+  dispatch.entry_point = (uint32_t)cmd->ordinal;
+  // Indirect dispatches have their workgroup count resolved on issue.
+  memcpy(dispatch.workgroup_count, task->workgroup_count.value,
+         sizeof(dispatch.workgroup_count));
+  dispatch.begin_time_ns = issue_time;
+  dispatch.end_time_ns = retire_time;
+  dispatch.invocation_count = 0;
+  iree_hal_dispatch_profiler_append(cmd->profiler, &dispatch);
+}
+
+// Records an indirect dispatch binding that will be populated from |slot| in
+// the submission binding table on each issue.
+static iree_status_t iree_hal_task_command_buffer_record_binding_fixup(
+    iree_hal_task_command_buffer_t* command_buffer, void** binding_ptr,
+    size_t* binding_length, uint32_t slot, iree_device_size_t offset,
+    iree_device_size_t length) {
+  iree_hal_task_binding_fixup_t* fixup = NULL;
+  IREE_RETURN_IF_ERROR(iree_arena_allocate(&command_buffer->arena,
+                                           sizeof(*fixup), (void**)&fixup));
+  fixup->binding_ptr = binding_ptr;
+  fixup->binding_length = binding_length;
+  fixup->slot = slot;
+  fixup->offset = offset;
+  fixup->length = length;
+  fixup->next = command_buffer->binding_fixups;
+  command_buffer->binding_fixups = fixup;
+  return iree_ok_status();
+}
+
+// Returns the FPU state required by |entry_point| in |executable|.
+static iree_fpu_state_flags_t iree_hal_task_dispatch_fpu_flags(
+    iree_hal_local_executable_t* executable, int32_t entry_point) {
+  if (executable->dispatch_attrs &&
+      iree_all_bits_set(
+          executable->dispatch_attrs[entry_point].flags,
+          IREE_HAL_EXECUTABLE_DISPATCH_FLAG_V0_PRESERVE_DENORMALS)) {
+    return IREE_FPU_STATE_DEFAULT;
+  }
+  return IREE_FPU_STATE_FLAG_FLUSH_DENORMALS_TO_ZERO;
+}
+
 static iree_status_t iree_hal_task_command_buffer_build_dispatch(
     iree_hal_command_buffer_t* base_command_buffer,
     iree_hal_executable_t* executable, int32_t entry_point,
@@ -863,6 +1766,8 @@ static iree_status_t iree_hal_task_command_buffer_build_dispatch(
 
   iree_hal_local_executable_t* local_executable =
       iree_hal_local_executable_cast(executable);
+  IREE_RETURN_IF_ERROR(
+      iree_hal_local_executable_ensure_loaded(local_executable));
   iree_hal_local_executable_layout_t* local_layout =
       local_executable->executable_layouts[entry_point];
   iree_host_size_t push_constant_count = local_layout->push_constants;
@@ -887,6 +1792,10 @@ static iree_status_t iree_hal_task_command_buffer_build_dispatch(
 
   cmd->executable = local_executable;
   cmd->ordinal = entry_point;
+  cmd->next_chained = NULL;
+  cmd->profiler = command_buffer->profiler;
+  cmd->fpu_flags = iree_hal_task_dispatch_fpu_flags(local_executable,
+                                                    entry_point);
   cmd->push_constant_count = push_constant_count;
   cmd->binding_count = used_binding_count;
 
@@ -897,6 +1806,8 @@ static iree_status_t iree_hal_task_command_buffer_build_dispatch(
       command_buffer->scope,
       iree_task_make_dispatch_closure(iree_hal_cmd_dispatch_tile, (void*)cmd),
       workgroup_size, workgroup_count, &cmd->task);
+  if (cmd->profiler) cmd->task.profile_fn = iree_hal_cmd_dispatch_profile;
+  cmd->task.range_fn = iree_hal_cmd_dispatch_tile_range;
 
   // Tell the task system how much workgroup local memory is required for the
   // dispatch; each invocation of the entry point will have at least as much
@@ -907,6 +1818,13 @@ static iree_status_t iree_hal_task_command_buffer_build_dispatch(
                 IREE_HAL_WORKGROUP_LOCAL_MEMORY_PAGE_SIZE
           : 0;
 
+  // Seed the task system tile reservation size with the executable's hint (if
+  // any); it'll still adapt to the measured workgroup cost during execution.
+  cmd->task.tiles_per_reservation_hint =
+      local_executable->dispatch_attrs
+          ? local_executable->dispatch_attrs[entry_point].workgroup_grain_size
+          : 0;
+
   // Copy only the push constant range used by the executable.
   uint8_t* cmd_ptr = (uint8_t*)cmd + sizeof(*cmd);
   uint32_t* push_constants = (uint32_t*)cmd_ptr;
@@ -934,15 +1852,51 @@ static iree_status_t iree_hal_task_command_buffer_build_dispatch(
     used_binding_mask = iree_shr(used_binding_mask, mask_offset + 1);
     binding_ptrs[i] = command_buffer->state.bindings[binding_ordinal];
     binding_lengths[i] = command_buffer->state.binding_lengths[binding_ordinal];
-    if (!binding_ptrs[i]) {
+    uint32_t binding_slot =
+        command_buffer->state.binding_slots[binding_ordinal];
+    if (binding_slot) {
+      // Populated from the binding table on each issue.
+      IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_record_binding_fixup(
+          command_buffer, &binding_ptrs[i], &binding_lengths[i],
+          binding_slot - 1,
+          command_buffer->state.binding_offsets[binding_ordinal],
+          command_buffer->state.binding_lengths[binding_ordinal]));
+    } else if (!binding_ptrs[i]) {
       return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
                               "(flat) binding %d is NULL", binding_ordinal);
     }
   }
 
   *out_cmd = cmd;
-  return iree_hal_task_command_buffer_emit_execution_task(command_buffer,
-                                                          &cmd->task.header);
+  return iree_ok_status();
+}
+
+// Chains |cmd| to the dispatch recorded before a pending workgroup-local
+// barrier if their grids match and returns true. The chained dispatch is then
+// executed by the task of the first dispatch in the chain and no task of its
+// own is emitted.
+static bool iree_hal_task_command_buffer_try_chain_dispatch(
+    iree_hal_task_command_buffer_t* command_buffer,
+    iree_hal_cmd_dispatch_t* cmd) {
+  if (!command_buffer->state.chain_barrier_pending) return false;
+  iree_hal_cmd_dispatch_t* chain_tail = command_buffer->state.chain_tail;
+  if (memcmp(chain_tail->task.workgroup_count.value,
+             cmd->task.workgroup_count.value,
+             sizeof(cmd->task.workgroup_count.value)) != 0) {
+    return false;
+  }
+
+  // The task of the chain head provides local memory for all dispatches in it.
+  iree_hal_cmd_dispatch_t* chain_head =
+      (iree_hal_cmd_dispatch_t*)chain_tail->task.closure.user_context;
+  chain_head->task.local_memory_size = iree_max(
+      chain_head->task.local_memory_size, cmd->task.local_memory_size);
+  cmd->task.closure.user_context = chain_head;
+
+  chain_tail->next_chained = cmd;
+  command_buffer->state.chain_tail = cmd;
+  command_buffer->state.chain_barrier_pending = false;
+  return true;
 }
 
 static iree_status_t iree_hal_task_command_buffer_dispatch(
@@ -954,9 +1908,22 @@ static iree_status_t iree_hal_task_command_buffer_dispatch(
   IREE_RETURN_IF_ERROR(iree_hal_resource_set_insert(
       command_buffer->resource_set, 1, &executable));
   iree_hal_cmd_dispatch_t* cmd = NULL;
-  return iree_hal_task_command_buffer_build_dispatch(
+  IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_build_dispatch(
       base_command_buffer, executable, entry_point, workgroup_x, workgroup_y,
-      workgroup_z, &cmd);
+      workgroup_z, &cmd));
+  if (iree_hal_task_command_buffer_try_chain_dispatch(command_buffer, cmd)) {
+    return iree_ok_status();
+  }
+  IREE_RETURN_IF_ERROR(iree_hal_task_command_buffer_emit_execution_task(
+      command_buffer, &cmd->task.header));
+
+  // Dispatches following a workgroup-local barrier may be chained to this one
+  // if it is the only task since the last barrier. Profiled dispatches are not
+  // chained so that each reports its own timing.
+  if (command_buffer->state.scope_task_count == 1 && !cmd->profiler) {
+    command_buffer->state.chain_tail = cmd;
+  }
+  return iree_ok_status();
 }
 
 static iree_status_t iree_hal_task_command_buffer_dispatch_indirect(
@@ -983,7 +1950,8 @@ static iree_status_t iree_hal_task_command_buffer_dispatch_indirect(
       base_command_buffer, executable, entry_point, 0, 0, 0, &cmd));
   cmd->task.workgroup_count.ptr = (const uint32_t*)buffer_mapping.contents.data;
   cmd->task.header.flags |= IREE_TASK_FLAG_DISPATCH_INDIRECT;
-  return iree_ok_status();
+  return iree_hal_task_command_buffer_emit_execution_task(command_buffer,
+                                                          &cmd->task.header);
 }
 
 //===----------------------------------------------------------------------===//
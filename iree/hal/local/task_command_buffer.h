@@ -11,6 +11,8 @@
 #include "iree/base/internal/arena.h"
 #include "iree/hal/api.h"
 #include "iree/hal/local/task_queue_state.h"
+#include "iree/hal/utils/dispatch_profiler.h"
+#include "iree/task/executor.h"
 #include "iree/task/scope.h"
 #include "iree/task/task.h"
 
@@ -18,12 +20,21 @@
 extern "C" {
 #endif  // __cplusplus
 
+// Creates a command buffer that records into a task DAG within |scope|.
+//
+// Command buffers with IREE_HAL_COMMAND_BUFFER_MODE_ALLOW_INLINE_EXECUTION
+// submit their tasks to |executor| at each global barrier during recording so
+// that execution can overlap with the remainder of the recording.
+//
+// Dispatches report their execution times to |profiler| when it is active.
+// The |profiler| is optional and must outlive the command buffer if provided.
 iree_status_t iree_hal_task_command_buffer_create(
-    iree_hal_device_t* device, iree_task_scope_t* scope,
-    iree_hal_command_buffer_mode_t mode,
+    iree_hal_device_t* device, iree_task_executor_t* executor,
+    iree_task_scope_t* scope, iree_hal_command_buffer_mode_t mode,
     iree_hal_command_category_t command_categories,
     iree_hal_queue_affinity_t queue_affinity,
-    iree_arena_block_pool_t* block_pool, iree_allocator_t host_allocator,
+    iree_arena_block_pool_t* block_pool,
+    iree_hal_dispatch_profiler_t* profiler, iree_allocator_t host_allocator,
     iree_hal_command_buffer_t** out_command_buffer);
 
 // Returns true if |command_buffer| is a task system command buffer.
@@ -35,6 +46,10 @@ bool iree_hal_task_command_buffer_isa(
 // prior commands such as signaled events and will be mutated as events are
 // reset or new events are signaled.
 //
+// |binding_table| is used to resolve indirect bindings of command buffers
+// recorded with IREE_HAL_COMMAND_BUFFER_MODE_INDIRECT_BINDINGS. The buffers it
+// references must remain live until |retire_task| has been scheduled.
+//
 // |retire_task| will be scheduled once all commands issued from the command
 // buffer retire and can be used as a fence point.
 //
@@ -46,10 +61,17 @@ bool iree_hal_task_command_buffer_isa(
 //
 // |pending_submission| will receive the ready list of commands and must be
 // submitted to the executor (or discarded on failure) by the caller.
+//
+// Reusable command buffers have their recorded tasks reset in place and can be
+// issued again once the |retire_task| of the prior issue has been scheduled;
+// issuing while a prior submission is still executing fails with
+// IREE_STATUS_FAILED_PRECONDITION.
 iree_status_t iree_hal_task_command_buffer_issue(
     iree_hal_command_buffer_t* command_buffer,
-    iree_hal_task_queue_state_t* queue_state, iree_task_t* retire_task,
-    iree_arena_allocator_t* arena, iree_task_submission_t* pending_submission);
+    iree_hal_task_queue_state_t* queue_state,
+    const iree_hal_buffer_binding_table_t* binding_table,
+    iree_task_t* retire_task, iree_arena_allocator_t* arena,
+    iree_task_submission_t* pending_submission);
 
 #ifdef __cplusplus
 }  // extern "C"
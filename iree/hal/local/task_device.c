@@ -12,6 +12,7 @@
 
 #include "iree/base/internal/arena.h"
 #include "iree/base/tracing.h"
+#include "iree/hal/local/executable_environment.h"
 #include "iree/hal/local/local_descriptor_set.h"
 #include "iree/hal/local/local_descriptor_set_layout.h"
 #include "iree/hal/local/local_executable_cache.h"
@@ -21,6 +22,7 @@
 #include "iree/hal/local/task_queue.h"
 #include "iree/hal/local/task_semaphore.h"
 #include "iree/hal/utils/buffer_transfer.h"
+#include "iree/hal/utils/dispatch_profiler.h"
 
 typedef struct iree_hal_task_device_t {
   iree_hal_resource_t resource;
@@ -35,12 +37,22 @@ typedef struct iree_hal_task_device_t {
 
   iree_task_executor_t* executor;
 
+  // Captures dispatch timestamps from all command buffers while profiling.
+  iree_hal_dispatch_profiler_t profiler;
+
   iree_host_size_t loader_count;
   iree_hal_executable_loader_t** loaders;
 
+  // Environment executables are loaded with. Includes the cache sizes of the
+  // cores the executor runs on so that libraries can select tile sizes.
+  iree_hal_executable_environment_v0_t executable_environment;
+
   iree_allocator_t host_allocator;
   iree_hal_allocator_t* device_allocator;
 
+  // Whether waiting threads are donated to the executor.
+  bool donate_waiting_threads;
+
   iree_host_size_t queue_count;
   iree_hal_task_queue_t queues[];
 } iree_hal_task_device_t;
@@ -57,6 +69,8 @@ void iree_hal_task_device_params_initialize(
     iree_hal_task_device_params_t* out_params) {
   out_params->arena_block_size = 32 * 1024;
   out_params->queue_count = 8;
+  out_params->high_priority_queue_affinity = 0;
+  out_params->donate_waiting_threads = true;
 }
 
 static iree_status_t iree_hal_task_device_check_params(
@@ -104,6 +118,7 @@ iree_status_t iree_hal_task_device_create(
     device->host_allocator = host_allocator;
     device->device_allocator = device_allocator;
     iree_hal_allocator_retain(device_allocator);
+    iree_hal_dispatch_profiler_initialize(host_allocator, &device->profiler);
 
     iree_arena_block_pool_initialize(4096, host_allocator,
                                      &device->small_block_pool);
@@ -113,6 +128,14 @@ iree_status_t iree_hal_task_device_create(
     device->executor = executor;
     iree_task_executor_retain(device->executor);
 
+    iree_hal_executable_environment_initialize(
+        &device->executable_environment);
+    iree_task_topology_cache_sizes_t cache_sizes =
+        iree_task_executor_cache_sizes(executor);
+    iree_hal_processor_set_cache_sizes(
+        cache_sizes.l1d, cache_sizes.l2, cache_sizes.l3,
+        &device->executable_environment.processor);
+
     device->loader_count = loader_count;
     device->loaders =
         (iree_hal_executable_loader_t**)((uint8_t*)device + sizeof(*device) +
@@ -123,10 +146,16 @@ iree_status_t iree_hal_task_device_create(
       iree_hal_executable_loader_retain(device->loaders[i]);
     }
 
+    device->donate_waiting_threads = params->donate_waiting_threads;
     device->queue_count = params->queue_count;
     for (iree_host_size_t i = 0; i < device->queue_count; ++i) {
       // TODO(benvanik): add a number to each queue ID.
-      iree_hal_task_queue_initialize(device->identifier, device->executor,
+      iree_task_priority_t priority = IREE_TASK_PRIORITY_NORMAL;
+      if (i < 64 && (params->high_priority_queue_affinity & (1ull << i))) {
+        priority = IREE_TASK_PRIORITY_HIGH;
+      }
+      iree_hal_task_queue_initialize(device->identifier, priority,
+                                     device->executor,
                                      &device->small_block_pool,
                                      &device->queues[i]);
     }
@@ -141,6 +170,11 @@ iree_status_t iree_hal_task_device_create(
   return status;
 }
 
+iree_task_executor_t* iree_hal_task_device_executor(iree_hal_device_t* device) {
+  if (!iree_hal_resource_is(device, &iree_hal_task_device_vtable)) return NULL;
+  return iree_hal_task_device_cast(device)->executor;
+}
+
 static void iree_hal_task_device_destroy(iree_hal_device_t* base_device) {
   iree_hal_task_device_t* device = iree_hal_task_device_cast(base_device);
   iree_allocator_t host_allocator = iree_hal_device_host_allocator(base_device);
@@ -155,6 +189,7 @@ static void iree_hal_task_device_destroy(iree_hal_device_t* base_device) {
   iree_task_executor_release(device->executor);
   iree_arena_block_pool_deinitialize(&device->large_block_pool);
   iree_arena_block_pool_deinitialize(&device->small_block_pool);
+  iree_hal_dispatch_profiler_deinitialize(&device->profiler);
   iree_hal_allocator_release(device->device_allocator);
   iree_allocator_free(host_allocator, device);
 
@@ -232,9 +267,9 @@ static iree_status_t iree_hal_task_device_create_command_buffer(
   iree_host_size_t queue_index = iree_hal_task_device_select_queue(
       device, command_categories, queue_affinity);
   return iree_hal_task_command_buffer_create(
-      base_device, &device->queues[queue_index].scope, mode, command_categories,
-      queue_affinity, &device->large_block_pool, device->host_allocator,
-      out_command_buffer);
+      base_device, device->executor, &device->queues[queue_index].scope, mode,
+      command_categories, queue_affinity, &device->large_block_pool,
+      &device->profiler, device->host_allocator, out_command_buffer);
 }
 
 static iree_status_t iree_hal_task_device_create_descriptor_set(
@@ -270,6 +305,7 @@ static iree_status_t iree_hal_task_device_create_executable_cache(
   iree_hal_task_device_t* device = iree_hal_task_device_cast(base_device);
   return iree_hal_local_executable_cache_create(
       identifier, device->loader_count, device->loaders,
+      &device->executable_environment,
       iree_hal_device_host_allocator(base_device), out_executable_cache);
 }
 
@@ -292,6 +328,71 @@ static iree_status_t iree_hal_task_device_create_semaphore(
       device->host_allocator, out_semaphore);
 }
 
+static iree_status_t iree_hal_task_device_queue_alloca(
+    iree_hal_device_t* base_device, iree_hal_queue_affinity_t queue_affinity,
+    const iree_hal_semaphore_list_t wait_semaphore_list,
+    const iree_hal_semaphore_list_t signal_semaphore_list,
+    iree_hal_memory_type_t memory_type, iree_hal_buffer_usage_t allowed_usage,
+    iree_device_size_t allocation_size, iree_hal_buffer_t** out_buffer) {
+  iree_hal_task_device_t* device = iree_hal_task_device_cast(base_device);
+  iree_host_size_t queue_index = iree_hal_task_device_select_queue(
+      device, IREE_HAL_COMMAND_CATEGORY_ANY, queue_affinity);
+
+  // TODO(benvanik): pool transient allocations per queue. Host memory is
+  // allocated immediately and only its availability is ordered on the queue.
+  iree_hal_buffer_t* buffer = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_allocator_allocate_buffer(
+      device->device_allocator, memory_type, allowed_usage, allocation_size,
+      iree_const_byte_span_empty(), &buffer));
+
+  // Issue a barrier on the queue that signals once the waits are satisfied.
+  iree_hal_submission_batch_t batch = {
+      .wait_semaphores = wait_semaphore_list,
+      .command_buffer_count = 0,
+      .command_buffers = NULL,
+      .signal_semaphores = signal_semaphore_list,
+      .binding_table = iree_hal_buffer_binding_table_empty(),
+  };
+  iree_status_t status =
+      iree_hal_task_queue_submit(&device->queues[queue_index], 1, &batch);
+  if (iree_status_is_ok(status)) {
+    *out_buffer = buffer;
+  } else {
+    iree_hal_buffer_release(buffer);
+  }
+  return status;
+}
+
+static iree_status_t iree_hal_task_device_queue_dealloca(
+    iree_hal_device_t* base_device, iree_hal_queue_affinity_t queue_affinity,
+    const iree_hal_semaphore_list_t wait_semaphore_list,
+    const iree_hal_semaphore_list_t signal_semaphore_list,
+    iree_hal_buffer_t* buffer) {
+  iree_hal_task_device_t* device = iree_hal_task_device_cast(base_device);
+  iree_host_size_t queue_index = iree_hal_task_device_select_queue(
+      device, IREE_HAL_COMMAND_CATEGORY_ANY, queue_affinity);
+
+  // The submission binding table retains the buffer until the barrier retires
+  // such that the last reference is dropped in queue order.
+  iree_hal_buffer_binding_t binding = {
+      .buffer = buffer,
+      .offset = 0,
+      .length = IREE_WHOLE_BUFFER,
+  };
+  iree_hal_submission_batch_t batch = {
+      .wait_semaphores = wait_semaphore_list,
+      .command_buffer_count = 0,
+      .command_buffers = NULL,
+      .signal_semaphores = signal_semaphore_list,
+      .binding_table =
+          {
+              .count = 1,
+              .bindings = &binding,
+          },
+  };
+  return iree_hal_task_queue_submit(&device->queues[queue_index], 1, &batch);
+}
+
 static iree_status_t iree_hal_task_device_queue_submit(
     iree_hal_device_t* base_device,
     iree_hal_command_category_t command_categories,
@@ -304,6 +405,89 @@ static iree_status_t iree_hal_task_device_queue_submit(
                                     batches);
 }
 
+// A wait on a list of semaphores that can be used as an iree_wait_source_t.
+typedef struct iree_hal_task_device_semaphore_wait_t {
+  iree_hal_task_device_t* device;
+  iree_hal_wait_mode_t wait_mode;
+  const iree_hal_semaphore_list_t* semaphore_list;
+} iree_hal_task_device_semaphore_wait_t;
+
+// Returns IREE_STATUS_OK if the |wait| is satisfied, IREE_STATUS_DEFERRED if
+// it is not yet, or the failure code if any semaphore has failed.
+static iree_status_code_t iree_hal_task_device_query_semaphore_wait(
+    const iree_hal_task_device_semaphore_wait_t* wait) {
+  iree_host_size_t reached_count = 0;
+  for (iree_host_size_t i = 0; i < wait->semaphore_list->count; ++i) {
+    uint64_t value = 0;
+    iree_status_t status = iree_hal_semaphore_query(
+        wait->semaphore_list->semaphores[i], &value);
+    if (!iree_status_is_ok(status)) {
+      return iree_status_consume_code(status);
+    }
+    if (value >= wait->semaphore_list->payload_values[i]) ++reached_count;
+  }
+  bool is_satisfied = wait->wait_mode == IREE_HAL_WAIT_MODE_ANY
+                          ? reached_count > 0
+                          : reached_count == wait->semaphore_list->count;
+  return is_satisfied ? IREE_STATUS_OK : IREE_STATUS_DEFERRED;
+}
+
+static iree_status_t iree_hal_task_device_semaphore_wait_ctl(
+    iree_wait_source_t wait_source, iree_wait_source_command_t command,
+    const void* params, void** inout_ptr) {
+  const iree_hal_task_device_semaphore_wait_t* wait =
+      (const iree_hal_task_device_semaphore_wait_t*)wait_source.self;
+  switch (command) {
+    case IREE_WAIT_SOURCE_COMMAND_QUERY: {
+      iree_status_code_t* out_wait_status_code = (iree_status_code_t*)inout_ptr;
+      *out_wait_status_code = iree_hal_task_device_query_semaphore_wait(wait);
+      return iree_ok_status();
+    }
+    case IREE_WAIT_SOURCE_COMMAND_WAIT_ONE: {
+      iree_timeout_t timeout =
+          ((const iree_wait_source_wait_params_t*)params)->timeout;
+      return iree_hal_task_semaphore_multi_wait(
+          wait->wait_mode, wait->semaphore_list, timeout,
+          iree_task_executor_event_pool(wait->device->executor),
+          &wait->device->large_block_pool);
+    }
+    case IREE_WAIT_SOURCE_COMMAND_EXPORT:
+      return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                              "semaphore waits cannot be exported");
+    default:
+      return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                              "unhandled wait source command");
+  }
+}
+
+static iree_status_t iree_hal_task_device_wait_semaphores(
+    iree_hal_device_t* base_device, iree_hal_wait_mode_t wait_mode,
+    const iree_hal_semaphore_list_t* semaphore_list, iree_timeout_t timeout) {
+  iree_hal_task_device_t* device = iree_hal_task_device_cast(base_device);
+  if (!device->donate_waiting_threads) {
+    return iree_hal_task_semaphore_multi_wait(
+        wait_mode, semaphore_list, timeout,
+        iree_task_executor_event_pool(device->executor),
+        &device->large_block_pool);
+  }
+
+  // Execute the work being waited on from this thread until the semaphores
+  // are reached and only then block for whatever work is still in-flight on
+  // the workers.
+  iree_hal_task_device_semaphore_wait_t wait = {
+      .device = device,
+      .wait_mode = wait_mode,
+      .semaphore_list = semaphore_list,
+  };
+  iree_wait_source_t wait_source = {
+      .self = &wait,
+      .data = 0,
+      .ctl = iree_hal_task_device_semaphore_wait_ctl,
+  };
+  return iree_task_executor_donate_caller(device->executor, wait_source,
+                                          timeout);
+}
+
 static iree_status_t iree_hal_task_device_submit_and_wait(
     iree_hal_device_t* base_device,
     iree_hal_command_category_t command_categories,
@@ -311,22 +495,22 @@ static iree_status_t iree_hal_task_device_submit_and_wait(
     const iree_hal_submission_batch_t* batches,
     iree_hal_semaphore_t* wait_semaphore, uint64_t wait_value,
     iree_timeout_t timeout) {
+  // Capture time as an absolute value as we don't know how long the submit
+  // will take.
+  iree_convert_timeout_to_absolute(&timeout);
+
   // Submit...
   IREE_RETURN_IF_ERROR(iree_hal_task_device_queue_submit(
       base_device, command_categories, queue_affinity, batch_count, batches));
 
-  // ...and wait.
-  return iree_hal_semaphore_wait(wait_semaphore, wait_value, timeout);
-}
-
-static iree_status_t iree_hal_task_device_wait_semaphores(
-    iree_hal_device_t* base_device, iree_hal_wait_mode_t wait_mode,
-    const iree_hal_semaphore_list_t* semaphore_list, iree_timeout_t timeout) {
-  iree_hal_task_device_t* device = iree_hal_task_device_cast(base_device);
-  return iree_hal_task_semaphore_multi_wait(
-      wait_mode, semaphore_list, timeout,
-      iree_task_executor_event_pool(device->executor),
-      &device->large_block_pool);
+  // ...and wait (possibly executing the submitted work on this thread).
+  iree_hal_semaphore_list_t semaphore_list = {
+      .count = 1,
+      .semaphores = &wait_semaphore,
+      .payload_values = &wait_value,
+  };
+  return iree_hal_task_device_wait_semaphores(
+      base_device, IREE_HAL_WAIT_MODE_ALL, &semaphore_list, timeout);
 }
 
 static iree_status_t iree_hal_task_device_wait_idle(
@@ -342,6 +526,25 @@ static iree_status_t iree_hal_task_device_wait_idle(
   return status;
 }
 
+static iree_status_t iree_hal_task_device_profiling_begin(
+    iree_hal_device_t* base_device,
+    const iree_hal_device_profiling_options_t* options) {
+  iree_hal_task_device_t* device = iree_hal_task_device_cast(base_device);
+  return iree_hal_dispatch_profiler_begin(&device->profiler, options);
+}
+
+static iree_status_t iree_hal_task_device_profiling_flush(
+    iree_hal_device_t* base_device) {
+  iree_hal_task_device_t* device = iree_hal_task_device_cast(base_device);
+  return iree_hal_dispatch_profiler_flush(&device->profiler);
+}
+
+static iree_status_t iree_hal_task_device_profiling_end(
+    iree_hal_device_t* base_device) {
+  iree_hal_task_device_t* device = iree_hal_task_device_cast(base_device);
+  return iree_hal_dispatch_profiler_end(&device->profiler);
+}
+
 static const iree_hal_device_vtable_t iree_hal_task_device_vtable = {
     .destroy = iree_hal_task_device_destroy,
     .id = iree_hal_task_device_id,
@@ -358,8 +561,13 @@ static const iree_hal_device_vtable_t iree_hal_task_device_vtable = {
     .create_executable_layout = iree_hal_task_device_create_executable_layout,
     .create_semaphore = iree_hal_task_device_create_semaphore,
     .transfer_range = iree_hal_device_transfer_mappable_range,
+    .queue_alloca = iree_hal_task_device_queue_alloca,
+    .queue_dealloca = iree_hal_task_device_queue_dealloca,
     .queue_submit = iree_hal_task_device_queue_submit,
     .submit_and_wait = iree_hal_task_device_submit_and_wait,
     .wait_semaphores = iree_hal_task_device_wait_semaphores,
     .wait_idle = iree_hal_task_device_wait_idle,
+    .profiling_begin = iree_hal_task_device_profiling_begin,
+    .profiling_flush = iree_hal_task_device_profiling_flush,
+    .profiling_end = iree_hal_task_device_profiling_end,
 };
@@ -24,6 +24,21 @@ typedef struct iree_hal_task_device_params_t {
   // concurrently unless prohibited by semaphores.
   iree_host_size_t queue_count;
 
+  // Bitmask of queues whose work executes with IREE_TASK_PRIORITY_HIGH.
+  // Workers drain high priority work before any other and normal priority
+  // dispatches yield at tile boundaries when it arrives, allowing
+  // latency-sensitive queues to share the executor with throughput-oriented
+  // ones without waiting for them to complete.
+  iree_hal_queue_affinity_t high_priority_queue_affinity;
+
+  // Donates threads waiting on the device (with iree_hal_device_wait_semaphores
+  // or iree_hal_device_submit_and_wait) to the executor such that they execute
+  // tiles of the work they are waiting on instead of blocking. This reduces the
+  // latency of synchronous requests by avoiding a wake-up handoff and adding
+  // an extra core but may oversubscribe the system if the waiting threads are
+  // pinned to cores used by the workers.
+  bool donate_waiting_threads;
+
   // Total size of each block in the device shared block pool.
   // Larger sizes will lower overhead and ensure the heap isn't hit for
   // transient allocations while also increasing memory consumption.
@@ -44,6 +59,10 @@ iree_status_t iree_hal_task_device_create(
     iree_hal_allocator_t* device_allocator, iree_allocator_t host_allocator,
     iree_hal_device_t** out_device);
 
+// Returns the executor that |device| schedules its work on or NULL if |device|
+// is not a task device. The executor is not retained.
+iree_task_executor_t* iree_hal_task_device_executor(iree_hal_device_t* device);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
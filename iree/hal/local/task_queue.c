@@ -182,6 +182,11 @@ typedef struct iree_hal_task_queue_issue_cmd_t {
   // if we are the last issue pending.
   iree_hal_task_queue_t* queue;
 
+  // Binding table used to resolve indirect command buffer bindings. Owned by
+  // the retire command so that the buffers stay live until all commands have
+  // completed.
+  const iree_hal_buffer_binding_table_t* binding_table;
+
   // Command buffers to be issued in the order the appeared in the submission.
   iree_host_size_t command_buffer_count;
   iree_hal_command_buffer_t* command_buffers[];
@@ -202,7 +207,7 @@ static iree_status_t iree_hal_task_queue_issue_cmd(
     for (iree_host_size_t i = 0; i < cmd->command_buffer_count; ++i) {
       if (iree_hal_task_command_buffer_isa(cmd->command_buffers[i])) {
         status = iree_hal_task_command_buffer_issue(
-            cmd->command_buffers[i], &cmd->queue->state,
+            cmd->command_buffers[i], &cmd->queue->state, cmd->binding_table,
             cmd->task.header.completion_task, cmd->arena, pending_submission);
       } else {
         status = iree_make_status(
@@ -236,6 +241,7 @@ static iree_status_t iree_hal_task_queue_issue_cmd_allocate(
     iree_task_scope_t* scope, iree_hal_task_queue_t* queue,
     iree_task_t* retire_task, iree_host_size_t command_buffer_count,
     iree_hal_command_buffer_t** const command_buffers,
+    const iree_hal_buffer_binding_table_t* binding_table,
     iree_arena_allocator_t* arena, iree_hal_task_queue_issue_cmd_t** out_cmd) {
   iree_hal_task_queue_issue_cmd_t* cmd = NULL;
   iree_host_size_t total_cmd_size =
@@ -250,6 +256,7 @@ static iree_status_t iree_hal_task_queue_issue_cmd_allocate(
                            iree_hal_task_queue_issue_cmd_cleanup);
   cmd->arena = arena;
   cmd->queue = queue;
+  cmd->binding_table = binding_table;
 
   cmd->command_buffer_count = command_buffer_count;
   memcpy(cmd->command_buffers, command_buffers,
@@ -278,8 +285,40 @@ typedef struct iree_hal_task_queue_retire_cmd_t {
 
   // A list of semaphores to signal upon retiring.
   iree_hal_semaphore_list_t signal_semaphores;
+
+  // Binding table of the submission with all buffers retained.
+  iree_hal_buffer_binding_table_t binding_table;
 } iree_hal_task_queue_retire_cmd_t;
 
+// Clones |source_table| into |arena| and retains all of its buffers.
+static iree_status_t iree_hal_task_queue_binding_table_clone(
+    const iree_hal_buffer_binding_table_t* source_table,
+    iree_arena_allocator_t* arena, iree_hal_buffer_binding_table_t* out_table) {
+  *out_table = iree_hal_buffer_binding_table_empty();
+  if (source_table->count == 0) return iree_ok_status();
+  iree_hal_buffer_binding_t* bindings = NULL;
+  IREE_RETURN_IF_ERROR(iree_arena_allocate(
+      arena, source_table->count * sizeof(*bindings), (void**)&bindings));
+  memcpy(bindings, source_table->bindings,
+         source_table->count * sizeof(*bindings));
+  for (iree_host_size_t i = 0; i < source_table->count; ++i) {
+    iree_hal_buffer_retain(bindings[i].buffer);
+  }
+  out_table->count = source_table->count;
+  out_table->bindings = bindings;
+  return iree_ok_status();
+}
+
+// Releases all buffers in a table cloned with
+// iree_hal_task_queue_binding_table_clone.
+static void iree_hal_task_queue_binding_table_release(
+    iree_hal_buffer_binding_table_t* table) {
+  for (iree_host_size_t i = 0; i < table->count; ++i) {
+    iree_hal_buffer_release(table->bindings[i].buffer);
+  }
+  *table = iree_hal_buffer_binding_table_empty();
+}
+
 // Retires a submission by signaling semaphores to their desired value and
 // disposing of the temporary arena memory used for the submission.
 static iree_status_t iree_hal_task_queue_retire_cmd(
@@ -321,8 +360,9 @@ static void iree_hal_task_queue_retire_cmd_cleanup(
     }
   }
 
-  // Release all semaphores.
+  // Release all semaphores and buffers.
   iree_hal_semaphore_list_release(&cmd->signal_semaphores);
+  iree_hal_task_queue_binding_table_release(&cmd->binding_table);
 
   // Drop all memory used by the submission (**including cmd**).
   iree_arena_allocator_t arena = cmd->arena;
@@ -336,6 +376,7 @@ static void iree_hal_task_queue_retire_cmd_cleanup(
 static iree_status_t iree_hal_task_queue_retire_cmd_allocate(
     iree_task_scope_t* scope,
     const iree_hal_semaphore_list_t* signal_semaphores,
+    const iree_hal_buffer_binding_table_t* binding_table,
     iree_arena_block_pool_t* block_pool,
     iree_hal_task_queue_retire_cmd_t** out_cmd) {
   // Make an arena we'll use for allocating the command itself.
@@ -361,6 +402,13 @@ static iree_status_t iree_hal_task_queue_retire_cmd_allocate(
                                            &cmd->signal_semaphores);
   }
 
+  // Clone the binding table - we retain the buffers until the submission
+  // retires.
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_task_queue_binding_table_clone(binding_table, &arena,
+                                                     &cmd->binding_table);
+  }
+
   if (iree_status_is_ok(status)) {
     // Transfer ownership of the arena to command.
     memcpy(&cmd->arena, &arena, sizeof(cmd->arena));
@@ -376,6 +424,7 @@ static iree_status_t iree_hal_task_queue_retire_cmd_allocate(
 //===----------------------------------------------------------------------===//
 
 void iree_hal_task_queue_initialize(iree_string_view_t identifier,
+                                    iree_task_priority_t priority,
                                     iree_task_executor_t* executor,
                                     iree_arena_block_pool_t* block_pool,
                                     iree_hal_task_queue_t* out_queue) {
@@ -389,6 +438,7 @@ void iree_hal_task_queue_initialize(iree_string_view_t identifier,
   out_queue->block_pool = block_pool;
 
   iree_task_scope_initialize(identifier, &out_queue->scope);
+  iree_task_scope_set_priority(&out_queue->scope, priority);
 
   iree_slim_mutex_initialize(&out_queue->mutex);
   iree_hal_task_queue_state_initialize(&out_queue->state);
@@ -422,8 +472,8 @@ static iree_status_t iree_hal_task_queue_submit_batch(
   // arena which we will use to allocate all other commands.
   iree_hal_task_queue_retire_cmd_t* retire_cmd = NULL;
   IREE_RETURN_IF_ERROR(iree_hal_task_queue_retire_cmd_allocate(
-      &queue->scope, &batch->signal_semaphores, queue->block_pool,
-      &retire_cmd));
+      &queue->scope, &batch->signal_semaphores, &batch->binding_table,
+      queue->block_pool, &retire_cmd));
 
   // NOTE: if we fail from here on we must drop the retire_cmd arena.
   iree_status_t status = iree_ok_status();
@@ -451,12 +501,13 @@ static iree_status_t iree_hal_task_queue_submit_batch(
   if (iree_status_is_ok(status)) {
     status = iree_hal_task_queue_issue_cmd_allocate(
         &queue->scope, queue, &retire_cmd->task.header,
-        batch->command_buffer_count, batch->command_buffers, &retire_cmd->arena,
-        &issue_cmd);
+        batch->command_buffer_count, batch->command_buffers,
+        &retire_cmd->binding_table, &retire_cmd->arena, &issue_cmd);
   }
 
   // Last chance for failure - from here on we are submitting.
   if (IREE_UNLIKELY(!iree_status_is_ok(status))) {
+    iree_hal_task_queue_binding_table_release(&retire_cmd->binding_table);
     iree_arena_deinitialize(&retire_cmd->arena);
     return status;
   }
@@ -52,7 +52,9 @@ typedef struct iree_hal_task_queue_t {
   iree_task_t* tail_issue_task;
 } iree_hal_task_queue_t;
 
+// Initializes a queue whose work is scheduled on |executor| with |priority|.
 void iree_hal_task_queue_initialize(iree_string_view_t identifier,
+                                    iree_task_priority_t priority,
                                     iree_task_executor_t* executor,
                                     iree_arena_block_pool_t* block_pool,
                                     iree_hal_task_queue_t* out_queue);
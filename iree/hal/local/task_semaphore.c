@@ -11,6 +11,7 @@
 #include <stddef.h>
 #include <string.h>
 
+#include "iree/base/internal/atomics.h"
 #include "iree/base/internal/synchronization.h"
 #include "iree/base/internal/wait_handle.h"
 #include "iree/base/tracing.h"
@@ -135,15 +136,16 @@ typedef struct iree_hal_task_semaphore_t {
   iree_allocator_t host_allocator;
   iree_event_pool_t* event_pool;
 
-  // Guards all mutable fields. We expect low contention on semaphores and since
-  // iree_slim_mutex_t is (effectively) just a CAS this keeps things simpler
-  // than trying to make the entire structure lock-free.
+  // Guards the timepoint list and failure status. Signals and queries only take
+  // the lock when there are waiters to wake or the semaphore has failed such
+  // that the common case of signaling without anyone waiting is lock-free.
   iree_slim_mutex_t mutex;
 
   // Current signaled value. May be IREE_HAL_TASK_SEMAPHORE_FAILURE_VALUE to
   // indicate that the semaphore has been signaled for failure and
-  // |failure_status| contains the error.
-  uint64_t current_value;
+  // |failure_status| contains the error. Stored as int64_t bits of the uint64_t
+  // payload value.
+  iree_atomic_int64_t current_value;
 
   // OK or the status passed to iree_hal_semaphore_fail. Owned by the semaphore.
   iree_status_t failure_status;
@@ -153,6 +155,15 @@ typedef struct iree_hal_task_semaphore_t {
   // handle operation.
   iree_notification_t notification;
 
+  // Number of threads waiting on |notification|.
+  iree_atomic_int32_t notification_waiters;
+
+  // Nonzero while |timepoint_list| may be non-empty. Set under the lock before
+  // the current value is checked when adding a timepoint so that a concurrent
+  // lock-free signal either observes the flag or the timepoint observes the
+  // signaled value.
+  iree_atomic_int32_t has_timepoints;
+
   // A list of all reserved timepoints waiting for the semaphore to reach a
   // certain payload value.
   iree_hal_task_timepoint_list_t timepoint_list;
@@ -184,9 +195,14 @@ iree_status_t iree_hal_task_semaphore_create(
     semaphore->event_pool = event_pool;
 
     iree_slim_mutex_initialize(&semaphore->mutex);
-    semaphore->current_value = initial_value;
+    iree_atomic_store_int64(&semaphore->current_value, (int64_t)initial_value,
+                            iree_memory_order_relaxed);
     semaphore->failure_status = iree_ok_status();
     iree_notification_initialize(&semaphore->notification);
+    iree_atomic_store_int32(&semaphore->notification_waiters, 0,
+                            iree_memory_order_relaxed);
+    iree_atomic_store_int32(&semaphore->has_timepoints, 0,
+                            iree_memory_order_relaxed);
     iree_hal_task_timepoint_list_initialize(&semaphore->timepoint_list);
 
     *out_semaphore = (iree_hal_semaphore_t*)semaphore;
@@ -211,22 +227,47 @@ static void iree_hal_task_semaphore_destroy(
   IREE_TRACE_ZONE_END(z0);
 }
 
+// Returns the current payload value of |semaphore|.
+static uint64_t iree_hal_task_semaphore_load_value(
+    iree_hal_task_semaphore_t* semaphore) {
+  return (uint64_t)iree_atomic_load_int64(&semaphore->current_value,
+                                          iree_memory_order_seq_cst);
+}
+
+// Returns true if a change in the value of |semaphore| may need to wake any
+// waiters.
+static bool iree_hal_task_semaphore_has_waiters(
+    iree_hal_task_semaphore_t* semaphore) {
+  return iree_atomic_load_int32(&semaphore->has_timepoints,
+                                iree_memory_order_seq_cst) != 0 ||
+         iree_atomic_load_int32(&semaphore->notification_waiters,
+                                iree_memory_order_seq_cst) != 0;
+}
+
+// Clears the timepoint flag if the timepoint list of |semaphore| is empty.
+// Must be called with the semaphore lock held.
+static void iree_hal_task_semaphore_update_timepoint_flag(
+    iree_hal_task_semaphore_t* semaphore) {
+  iree_atomic_store_int32(&semaphore->has_timepoints,
+                          semaphore->timepoint_list.head != NULL ? 1 : 0,
+                          iree_memory_order_seq_cst);
+}
+
 static iree_status_t iree_hal_task_semaphore_query(
     iree_hal_semaphore_t* base_semaphore, uint64_t* out_value) {
   iree_hal_task_semaphore_t* semaphore =
       iree_hal_task_semaphore_cast(base_semaphore);
 
-  iree_slim_mutex_lock(&semaphore->mutex);
-
-  *out_value = semaphore->current_value;
+  *out_value = iree_hal_task_semaphore_load_value(semaphore);
 
   iree_status_t status = iree_ok_status();
-  if (*out_value >= IREE_HAL_TASK_SEMAPHORE_FAILURE_VALUE) {
+  if (IREE_UNLIKELY(*out_value >= IREE_HAL_TASK_SEMAPHORE_FAILURE_VALUE)) {
+    // The failure status is set prior to the failure value being published.
+    iree_slim_mutex_lock(&semaphore->mutex);
     status = iree_status_clone(semaphore->failure_status);
+    iree_slim_mutex_unlock(&semaphore->mutex);
   }
 
-  iree_slim_mutex_unlock(&semaphore->mutex);
-
   return status;
 }
 
@@ -235,26 +276,36 @@ static iree_status_t iree_hal_task_semaphore_signal(
   iree_hal_task_semaphore_t* semaphore =
       iree_hal_task_semaphore_cast(base_semaphore);
 
-  iree_slim_mutex_lock(&semaphore->mutex);
-
-  if (new_value <= semaphore->current_value) {
-    uint64_t current_value IREE_ATTRIBUTE_UNUSED = semaphore->current_value;
-    iree_slim_mutex_unlock(&semaphore->mutex);
-    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
-                            "semaphore values must be monotonically "
-                            "increasing; current_value=%" PRIu64
-                            ", new_value=%" PRIu64,
-                            current_value, new_value);
+  // Fast path: lock-free update of the value.
+  int64_t current_value = iree_atomic_load_int64(&semaphore->current_value,
+                                                 iree_memory_order_seq_cst);
+  do {
+    if (new_value <= (uint64_t)current_value) {
+      return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                              "semaphore values must be monotonically "
+                              "increasing; current_value=%" PRIu64
+                              ", new_value=%" PRIu64,
+                              (uint64_t)current_value, new_value);
+    }
+  } while (!iree_atomic_compare_exchange_weak_int64(
+      &semaphore->current_value, &current_value, (int64_t)new_value,
+      iree_memory_order_seq_cst, iree_memory_order_seq_cst));
+  if (!iree_hal_task_semaphore_has_waiters(semaphore)) {
+    return iree_ok_status();
   }
 
-  semaphore->current_value = new_value;
+  // Slow path: wake waiters. Another thread may have signaled a larger value
+  // since our update so we take all timepoints satisfied by the latest value.
+  iree_slim_mutex_lock(&semaphore->mutex);
 
   // Scan for all timepoints that are now satisfied and move them to our local
   // ready list. This way we can notify them without needing to continue holding
   // the semaphore lock.
   iree_hal_task_timepoint_list_t ready_list;
-  iree_hal_task_timepoint_list_take_ready(&semaphore->timepoint_list, new_value,
-                                          &ready_list);
+  iree_hal_task_timepoint_list_take_ready(
+      &semaphore->timepoint_list, iree_hal_task_semaphore_load_value(semaphore),
+      &ready_list);
+  iree_hal_task_semaphore_update_timepoint_flag(semaphore);
 
   iree_notification_post(&semaphore->notification, IREE_ALL_WAITERS);
   iree_slim_mutex_unlock(&semaphore->mutex);
@@ -281,15 +332,19 @@ static void iree_hal_task_semaphore_fail(iree_hal_semaphore_t* base_semaphore,
     return;
   }
 
-  // Signal to our failure sentinel value.
-  semaphore->current_value = IREE_HAL_TASK_SEMAPHORE_FAILURE_VALUE;
+  // Signal to our failure sentinel value. The status is set first so that
+  // lock-free queries observing the failure value find it.
   semaphore->failure_status = status;
+  iree_atomic_store_int64(&semaphore->current_value,
+                          (int64_t)IREE_HAL_TASK_SEMAPHORE_FAILURE_VALUE,
+                          iree_memory_order_seq_cst);
 
   // Take the whole timepoint list as we'll be signaling all of them. Since
   // we hold the lock no other timepoints can be created while we are cleaning
   // up.
   iree_hal_task_timepoint_list_t ready_list;
   iree_hal_task_timepoint_list_move(&semaphore->timepoint_list, &ready_list);
+  iree_hal_task_semaphore_update_timepoint_flag(semaphore);
 
   iree_notification_post(&semaphore->notification, IREE_ALL_WAITERS);
   iree_slim_mutex_unlock(&semaphore->mutex);
@@ -298,6 +353,18 @@ static void iree_hal_task_semaphore_fail(iree_hal_semaphore_t* base_semaphore,
   iree_hal_task_timepoint_list_notify_ready(&ready_list);
 }
 
+// Marks |semaphore| as possibly having timepoints and returns true if the
+// semaphore has already reached |minimum_value|. Must be called with the
+// semaphore lock held and followed by
+// iree_hal_task_semaphore_update_timepoint_flag once any timepoint has been
+// acquired.
+static bool iree_hal_task_semaphore_prepare_timepoint(
+    iree_hal_task_semaphore_t* semaphore, uint64_t minimum_value) {
+  iree_atomic_store_int32(&semaphore->has_timepoints, 1,
+                          iree_memory_order_seq_cst);
+  return iree_hal_task_semaphore_load_value(semaphore) >= minimum_value;
+}
+
 // Acquires a timepoint waiting for the given value.
 // |out_timepoint| is owned by the caller and must be kept live until the
 // timepoint has been reached (or it is cancelled by the caller).
@@ -332,6 +399,7 @@ static void iree_hal_task_semaphore_wait_cmd_cleanup(
     iree_slim_mutex_lock(&cmd->semaphore->mutex);
     iree_hal_task_timepoint_list_erase(&cmd->semaphore->timepoint_list,
                                        &cmd->timepoint);
+    iree_hal_task_semaphore_update_timepoint_flag(cmd->semaphore);
     iree_slim_mutex_unlock(&cmd->semaphore->mutex);
   }
 }
@@ -346,7 +414,7 @@ iree_status_t iree_hal_task_semaphore_enqueue_timepoint(
   iree_slim_mutex_lock(&semaphore->mutex);
 
   iree_status_t status = iree_ok_status();
-  if (semaphore->current_value >= minimum_value) {
+  if (iree_hal_task_semaphore_prepare_timepoint(semaphore, minimum_value)) {
     // Fast path: already satisfied.
   } else {
     // Slow path: acquire a system wait handle and perform a full wait.
@@ -367,54 +435,69 @@ iree_status_t iree_hal_task_semaphore_enqueue_timepoint(
       iree_task_submission_enqueue(submission, &cmd->task.header);
     }
   }
+  iree_hal_task_semaphore_update_timepoint_flag(semaphore);
 
   iree_slim_mutex_unlock(&semaphore->mutex);
   return status;
 }
 
+typedef struct iree_hal_task_semaphore_wait_state_t {
+  iree_hal_task_semaphore_t* semaphore;
+  uint64_t value;
+} iree_hal_task_semaphore_wait_state_t;
+
+// Returns true if the semaphore has reached the wait value or failed.
+static bool iree_hal_task_semaphore_is_reached(void* arg) {
+  iree_hal_task_semaphore_wait_state_t* wait_state =
+      (iree_hal_task_semaphore_wait_state_t*)arg;
+  // Failure sets the current value to the maximum such that this also
+  // returns true for failed semaphores.
+  return iree_hal_task_semaphore_load_value(wait_state->semaphore) >=
+         wait_state->value;
+}
+
 static iree_status_t iree_hal_task_semaphore_wait(
     iree_hal_semaphore_t* base_semaphore, uint64_t value,
     iree_timeout_t timeout) {
   iree_hal_task_semaphore_t* semaphore =
       iree_hal_task_semaphore_cast(base_semaphore);
 
-  iree_slim_mutex_lock(&semaphore->mutex);
-
-  if (!iree_status_is_ok(semaphore->failure_status)) {
+  uint64_t current_value = iree_hal_task_semaphore_load_value(semaphore);
+  if (current_value >= IREE_HAL_TASK_SEMAPHORE_FAILURE_VALUE) {
     // Fastest path: failed; return an error to tell callers to query for it.
-    iree_slim_mutex_unlock(&semaphore->mutex);
     return iree_status_from_code(IREE_STATUS_ABORTED);
-  } else if (semaphore->current_value >= value) {
+  } else if (current_value >= value) {
     // Fast path: already satisfied.
-    iree_slim_mutex_unlock(&semaphore->mutex);
     return iree_ok_status();
   } else if (iree_timeout_is_immediate(timeout)) {
     // Not satisfied but a poll, so can avoid the expensive wait handle work.
-    iree_slim_mutex_unlock(&semaphore->mutex);
     return iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
   }
 
-  iree_time_t deadline_ns = iree_timeout_as_deadline_ns(timeout);
-
-  // Slow path: acquire a timepoint while we hold the lock.
-  iree_hal_task_timepoint_t timepoint;
-  iree_status_t status =
-      iree_hal_task_semaphore_acquire_timepoint(semaphore, value, &timepoint);
-
-  iree_slim_mutex_unlock(&semaphore->mutex);
-  if (IREE_UNLIKELY(!iree_status_is_ok(status))) return status;
-
-  // Wait until the timepoint resolves.
-  // If satisfied the timepoint is automatically cleaned up and we are done. If
-  // the deadline is reached before satisfied then we have to clean it up.
-  status = iree_wait_one(&timepoint.event, deadline_ns);
-  if (!iree_status_is_ok(status)) {
-    iree_slim_mutex_lock(&semaphore->mutex);
-    iree_hal_task_timepoint_list_erase(&semaphore->timepoint_list, &timepoint);
-    iree_slim_mutex_unlock(&semaphore->mutex);
+  // Slow path: wait on the in-process notification. This avoids acquiring an
+  // OS event from the pool (and the kernel wait handle operations on it) as
+  // only the semaphore signal/fail paths need to wake us. The waiter count is
+  // published before the condition is checked so that signals either observe
+  // it and post the notification or we observe their value.
+  iree_hal_task_semaphore_wait_state_t wait_state = {
+      .semaphore = semaphore,
+      .value = value,
+  };
+  iree_atomic_fetch_add_int32(&semaphore->notification_waiters, 1,
+                              iree_memory_order_seq_cst);
+  bool is_reached = iree_notification_await(
+      &semaphore->notification, iree_hal_task_semaphore_is_reached,
+      &wait_state, timeout);
+  iree_atomic_fetch_sub_int32(&semaphore->notification_waiters, 1,
+                              iree_memory_order_seq_cst);
+  if (!is_reached) {
+    return iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
   }
-  iree_event_pool_release(semaphore->event_pool, 1, &timepoint.event);
-  return status;
+
+  return iree_hal_task_semaphore_load_value(semaphore) >=
+                 IREE_HAL_TASK_SEMAPHORE_FAILURE_VALUE
+             ? iree_status_from_code(IREE_STATUS_ABORTED)
+             : iree_ok_status();
 }
 
 iree_status_t iree_hal_task_semaphore_multi_wait(
@@ -457,7 +540,8 @@ iree_status_t iree_hal_task_semaphore_multi_wait(
       iree_hal_task_semaphore_t* semaphore =
           iree_hal_task_semaphore_cast(semaphore_list->semaphores[i]);
       iree_slim_mutex_lock(&semaphore->mutex);
-      if (semaphore->current_value >= semaphore_list->payload_values[i]) {
+      if (iree_hal_task_semaphore_prepare_timepoint(
+              semaphore, semaphore_list->payload_values[i])) {
         // Fast path: already satisfied.
       } else {
         // Slow path: get a native wait handle for the timepoint.
@@ -468,6 +552,7 @@ iree_status_t iree_hal_task_semaphore_multi_wait(
           status = iree_wait_set_insert(wait_set, timepoint->event);
         }
       }
+      iree_hal_task_semaphore_update_timepoint_flag(semaphore);
       iree_slim_mutex_unlock(&semaphore->mutex);
       if (!iree_status_is_ok(status)) break;
     }
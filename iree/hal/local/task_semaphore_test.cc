@@ -0,0 +1,204 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/local/task_semaphore.h"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#include "iree/base/api.h"
+#include "iree/base/internal/arena.h"
+#include "iree/base/internal/event_pool.h"
+#include "iree/hal/api.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace {
+
+// Bounds all waits in these tests so that a lost wakeup fails the test instead
+// of hanging it.
+static const iree_duration_t kWaitTimeoutNs = 10 * 1000000000ll;
+
+class TaskSemaphoreTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    IREE_ASSERT_OK(
+        iree_event_pool_allocate(8, iree_allocator_system(), &event_pool_));
+    iree_arena_block_pool_initialize(4096, iree_allocator_system(),
+                                     &block_pool_);
+  }
+
+  void TearDown() override {
+    iree_arena_block_pool_deinitialize(&block_pool_);
+    iree_event_pool_free(event_pool_);
+  }
+
+  iree_hal_semaphore_t* CreateSemaphore(uint64_t initial_value) {
+    iree_hal_semaphore_t* semaphore = NULL;
+    IREE_CHECK_OK(iree_hal_task_semaphore_create(
+        event_pool_, initial_value, iree_allocator_system(), &semaphore));
+    return semaphore;
+  }
+
+  iree_event_pool_t* event_pool_ = NULL;
+  iree_arena_block_pool_t block_pool_;
+};
+
+// Signals a semaphore while another thread begins waiting on it such that the
+// signal races the waiter publishing itself. Every wait must observe the
+// signal regardless of which side wins.
+TEST_F(TaskSemaphoreTest, SignalRacesWaiter) {
+  iree_hal_semaphore_t* semaphore = CreateSemaphore(0ull);
+  static const uint64_t kIterationCount = 1000;
+
+  std::atomic<uint64_t> wait_value = {0};
+  std::thread thread([&]() {
+    for (uint64_t value = 1; value <= kIterationCount; ++value) {
+      while (wait_value.load() < value) std::this_thread::yield();
+      IREE_EXPECT_OK(iree_hal_semaphore_wait(
+          semaphore, value, iree_make_timeout(kWaitTimeoutNs)));
+    }
+  });
+  for (uint64_t value = 1; value <= kIterationCount; ++value) {
+    // Release the waiter and signal immediately to race its registration.
+    wait_value.store(value);
+    IREE_ASSERT_OK(iree_hal_semaphore_signal(semaphore, value));
+  }
+  thread.join();
+
+  iree_hal_semaphore_release(semaphore);
+}
+
+// Signals two semaphores while another thread registers timepoints on both as
+// part of a multi-wait. Timepoints registered concurrently with a lock-free
+// signal must either be satisfied immediately or be woken by the signal.
+TEST_F(TaskSemaphoreTest, SignalRacesTimepoint) {
+  iree_hal_semaphore_t* semaphore_a = CreateSemaphore(0ull);
+  iree_hal_semaphore_t* semaphore_b = CreateSemaphore(0ull);
+  static const uint64_t kIterationCount = 200;
+
+  std::atomic<uint64_t> wait_value = {0};
+  std::thread thread([&]() {
+    for (uint64_t value = 1; value <= kIterationCount; ++value) {
+      while (wait_value.load() < value) std::this_thread::yield();
+      iree_hal_semaphore_t* semaphores[] = {semaphore_a, semaphore_b};
+      uint64_t payload_values[] = {value, value};
+      iree_hal_semaphore_list_t semaphore_list = {
+          IREE_ARRAYSIZE(semaphores),
+          semaphores,
+          payload_values,
+      };
+      IREE_EXPECT_OK(iree_hal_task_semaphore_multi_wait(
+          IREE_HAL_WAIT_MODE_ALL, &semaphore_list,
+          iree_make_timeout(kWaitTimeoutNs), event_pool_, &block_pool_));
+    }
+  });
+  for (uint64_t value = 1; value <= kIterationCount; ++value) {
+    wait_value.store(value);
+    IREE_ASSERT_OK(iree_hal_semaphore_signal(semaphore_a, value));
+    IREE_ASSERT_OK(iree_hal_semaphore_signal(semaphore_b, value));
+  }
+  thread.join();
+
+  iree_hal_semaphore_release(semaphore_a);
+  iree_hal_semaphore_release(semaphore_b);
+}
+
+// Fails a semaphore while another thread is waiting on a value it will never
+// reach. The waiter must be woken with an error and queries must then return
+// the failure status.
+TEST_F(TaskSemaphoreTest, FailWhileWaiting) {
+  iree_hal_semaphore_t* semaphore = CreateSemaphore(0ull);
+
+  std::atomic<bool> is_waiting = {false};
+  iree_status_code_t wait_status_code = IREE_STATUS_OK;
+  std::thread thread([&]() {
+    is_waiting.store(true);
+    iree_status_t status = iree_hal_semaphore_wait(
+        semaphore, 1ull, iree_make_timeout(kWaitTimeoutNs));
+    wait_status_code = iree_status_code(status);
+    iree_status_ignore(status);
+  });
+  while (!is_waiting.load()) std::this_thread::yield();
+  iree_hal_semaphore_fail(semaphore,
+                          iree_status_from_code(IREE_STATUS_DATA_LOSS));
+  thread.join();
+  EXPECT_EQ(IREE_STATUS_ABORTED, wait_status_code);
+
+  uint64_t value = 0;
+  iree_status_t status = iree_hal_semaphore_query(semaphore, &value);
+  EXPECT_EQ(IREE_STATUS_DATA_LOSS, iree_status_code(status));
+  iree_status_ignore(status);
+
+  // Waits that begin after the failure return immediately.
+  status = iree_hal_semaphore_wait(semaphore, 1ull,
+                                   iree_make_timeout(kWaitTimeoutNs));
+  EXPECT_EQ(IREE_STATUS_ABORTED, iree_status_code(status));
+  iree_status_ignore(status);
+
+  iree_hal_semaphore_release(semaphore);
+}
+
+// Queries a semaphore while another thread signals it. Queries must never fail
+// and must observe monotonically increasing values that were signaled.
+TEST_F(TaskSemaphoreTest, QueryDuringSignal) {
+  iree_hal_semaphore_t* semaphore = CreateSemaphore(0ull);
+  static const uint64_t kSignalCount = 100000;
+
+  std::atomic<bool> is_done = {false};
+  std::thread thread([&]() {
+    for (uint64_t value = 1; value <= kSignalCount; ++value) {
+      IREE_EXPECT_OK(iree_hal_semaphore_signal(semaphore, value));
+    }
+    is_done.store(true);
+  });
+  uint64_t last_value = 0;
+  while (!is_done.load()) {
+    uint64_t value = 0;
+    IREE_EXPECT_OK(iree_hal_semaphore_query(semaphore, &value));
+    EXPECT_GE(value, last_value);
+    EXPECT_LE(value, kSignalCount);
+    last_value = value;
+  }
+  thread.join();
+
+  uint64_t value = 0;
+  IREE_ASSERT_OK(iree_hal_semaphore_query(semaphore, &value));
+  EXPECT_EQ(kSignalCount, value);
+
+  iree_hal_semaphore_release(semaphore);
+}
+
+// Queries a semaphore while another thread fails it. Queries must either
+// return a signaled value or the failure status.
+TEST_F(TaskSemaphoreTest, QueryDuringFail) {
+  iree_hal_semaphore_t* semaphore = CreateSemaphore(1ull);
+
+  std::atomic<bool> is_querying = {false};
+  std::thread thread([&]() {
+    while (!is_querying.load()) std::this_thread::yield();
+    iree_hal_semaphore_fail(semaphore,
+                            iree_status_from_code(IREE_STATUS_DATA_LOSS));
+  });
+  is_querying.store(true);
+  for (;;) {
+    uint64_t value = 0;
+    iree_status_t status = iree_hal_semaphore_query(semaphore, &value);
+    if (iree_status_is_ok(status)) {
+      ASSERT_EQ(1ull, value);
+      continue;
+    }
+    EXPECT_EQ(IREE_STATUS_DATA_LOSS, iree_status_code(status));
+    iree_status_ignore(status);
+    break;
+  }
+  thread.join();
+
+  iree_hal_semaphore_release(semaphore);
+}
+
+}  // namespace
@@ -0,0 +1,298 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/utils/budget_allocator.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/tracing.h"
+#include "iree/hal/detail.h"
+
+typedef struct iree_hal_budget_allocator_t {
+  iree_hal_resource_t resource;
+  iree_allocator_t host_allocator;
+  iree_hal_allocator_t* base_allocator;
+  iree_device_size_t max_allocated_bytes;
+  iree_duration_t max_wait_duration;
+
+  // Guards allocated_bytes.
+  iree_slim_mutex_t mutex;
+  // Total size of all live buffers plus the requested size of all allocations
+  // in progress.
+  iree_device_size_t allocated_bytes;
+
+  // Posted whenever allocated_bytes decreases.
+  iree_notification_t release_notification;
+} iree_hal_budget_allocator_t;
+
+static const iree_hal_allocator_vtable_t iree_hal_budget_allocator_vtable;
+
+static iree_hal_budget_allocator_t* iree_hal_budget_allocator_cast(
+    iree_hal_allocator_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_hal_budget_allocator_vtable);
+  return (iree_hal_budget_allocator_t*)base_value;
+}
+
+IREE_API_EXPORT void iree_hal_budget_allocator_params_initialize(
+    iree_hal_budget_allocator_params_t* out_params) {
+  memset(out_params, 0, sizeof(*out_params));
+  out_params->max_allocated_bytes = (iree_device_size_t)(-1);
+  out_params->max_wait_duration = IREE_DURATION_INFINITE;
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_budget_allocator_create(
+    iree_hal_allocator_t* base_allocator,
+    const iree_hal_budget_allocator_params_t* params,
+    iree_allocator_t host_allocator, iree_hal_allocator_t** out_allocator) {
+  IREE_ASSERT_ARGUMENT(base_allocator);
+  IREE_ASSERT_ARGUMENT(params);
+  IREE_ASSERT_ARGUMENT(out_allocator);
+  *out_allocator = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_budget_allocator_t* allocator = NULL;
+  iree_status_t status = iree_allocator_malloc(
+      host_allocator, sizeof(*allocator), (void**)&allocator);
+  if (iree_status_is_ok(status)) {
+    memset(allocator, 0, sizeof(*allocator));
+    iree_hal_resource_initialize(&iree_hal_budget_allocator_vtable,
+                                 &allocator->resource);
+    allocator->host_allocator = host_allocator;
+    allocator->base_allocator = base_allocator;
+    iree_hal_allocator_retain(base_allocator);
+    allocator->max_allocated_bytes = params->max_allocated_bytes;
+    allocator->max_wait_duration = params->max_wait_duration;
+    iree_slim_mutex_initialize(&allocator->mutex);
+    iree_notification_initialize(&allocator->release_notification);
+    *out_allocator = (iree_hal_allocator_t*)allocator;
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_budget_allocator_destroy(
+    iree_hal_allocator_t* base_allocator) {
+  iree_hal_budget_allocator_t* allocator =
+      iree_hal_budget_allocator_cast(base_allocator);
+  iree_allocator_t host_allocator = allocator->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_notification_deinitialize(&allocator->release_notification);
+  iree_slim_mutex_deinitialize(&allocator->mutex);
+  iree_hal_allocator_release(allocator->base_allocator);
+  iree_allocator_free(host_allocator, allocator);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+IREE_API_EXPORT iree_device_size_t iree_hal_budget_allocator_allocated_bytes(
+    iree_hal_allocator_t* base_allocator) {
+  iree_hal_budget_allocator_t* allocator =
+      iree_hal_budget_allocator_cast(base_allocator);
+  iree_slim_mutex_lock(&allocator->mutex);
+  iree_device_size_t allocated_bytes = allocator->allocated_bytes;
+  iree_slim_mutex_unlock(&allocator->mutex);
+  return allocated_bytes;
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_budget_allocator_admit(
+    iree_hal_allocator_t* base_allocator, iree_device_size_t required_bytes) {
+  iree_hal_budget_allocator_t* allocator =
+      iree_hal_budget_allocator_cast(base_allocator);
+  if (required_bytes > allocator->max_allocated_bytes) {
+    return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                            "%" PRIdsz " bytes required but the memory budget "
+                            "is %" PRIdsz " bytes",
+                            required_bytes, allocator->max_allocated_bytes);
+  }
+  return iree_ok_status();
+}
+
+static iree_allocator_t iree_hal_budget_allocator_host_allocator(
+    const iree_hal_allocator_t* base_allocator) {
+  iree_hal_budget_allocator_t* allocator =
+      (iree_hal_budget_allocator_t*)base_allocator;
+  return allocator->host_allocator;
+}
+
+static iree_status_t iree_hal_budget_allocator_trim(
+    iree_hal_allocator_t* base_allocator) {
+  iree_hal_budget_allocator_t* allocator =
+      iree_hal_budget_allocator_cast(base_allocator);
+  return iree_hal_allocator_trim(allocator->base_allocator);
+}
+
+static void iree_hal_budget_allocator_query_statistics(
+    iree_hal_allocator_t* base_allocator,
+    iree_hal_allocator_statistics_t* out_statistics) {
+  iree_hal_budget_allocator_t* allocator =
+      iree_hal_budget_allocator_cast(base_allocator);
+  iree_hal_allocator_query_statistics(allocator->base_allocator,
+                                      out_statistics);
+}
+
+static iree_hal_buffer_compatibility_t
+iree_hal_budget_allocator_query_buffer_compatibility(
+    iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_buffer_usage_t allowed_usage,
+    iree_hal_buffer_usage_t intended_usage,
+    iree_device_size_t allocation_size) {
+  iree_hal_budget_allocator_t* allocator =
+      iree_hal_budget_allocator_cast(base_allocator);
+  return iree_hal_allocator_query_buffer_compatibility(
+      allocator->base_allocator, memory_type, allowed_usage, intended_usage,
+      allocation_size);
+}
+
+// Returns |byte_length| bytes to the budget and wakes any waiting allocations.
+static void iree_hal_budget_allocator_release_bytes(
+    iree_hal_budget_allocator_t* allocator, iree_device_size_t byte_length) {
+  iree_slim_mutex_lock(&allocator->mutex);
+  allocator->allocated_bytes -= byte_length;
+  iree_slim_mutex_unlock(&allocator->mutex);
+  iree_notification_post(&allocator->release_notification, IREE_ALL_WAITERS);
+}
+
+// Takes |byte_length| bytes from the budget, waiting until the deadline for
+// other buffers to be released if the budget is exhausted.
+static iree_status_t iree_hal_budget_allocator_acquire_bytes(
+    iree_hal_budget_allocator_t* allocator, iree_device_size_t byte_length) {
+  if (byte_length > allocator->max_allocated_bytes) {
+    return iree_hal_budget_allocator_admit((iree_hal_allocator_t*)allocator,
+                                           byte_length);
+  }
+  iree_time_t deadline_ns =
+      iree_relative_timeout_to_deadline_ns(allocator->max_wait_duration);
+  for (;;) {
+    iree_wait_token_t wait_token =
+        iree_notification_prepare_wait(&allocator->release_notification);
+    iree_slim_mutex_lock(&allocator->mutex);
+    bool acquired = allocator->allocated_bytes <=
+                    allocator->max_allocated_bytes - byte_length;
+    if (acquired) allocator->allocated_bytes += byte_length;
+    iree_device_size_t allocated_bytes = allocator->allocated_bytes;
+    iree_slim_mutex_unlock(&allocator->mutex);
+    if (acquired) {
+      iree_notification_cancel_wait(&allocator->release_notification);
+      return iree_ok_status();
+    }
+    if (!iree_notification_commit_wait(&allocator->release_notification,
+                                       wait_token, deadline_ns)) {
+      return iree_make_status(
+          IREE_STATUS_RESOURCE_EXHAUSTED,
+          "allocation of %" PRIdsz " bytes exceeds the memory budget of "
+          "%" PRIdsz " bytes with %" PRIdsz " bytes in use",
+          byte_length, allocator->max_allocated_bytes, allocated_bytes);
+    }
+  }
+}
+
+static iree_status_t iree_hal_budget_allocator_allocate_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_buffer_usage_t allowed_usage, iree_host_size_t allocation_size,
+    iree_const_byte_span_t initial_data, iree_hal_buffer_t** out_buffer) {
+  iree_hal_budget_allocator_t* allocator =
+      iree_hal_budget_allocator_cast(base_allocator);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Reserve the requested size up front so that concurrent allocations cannot
+  // collectively exceed the budget.
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_budget_allocator_acquire_bytes(allocator, allocation_size));
+
+  iree_hal_buffer_t* buffer = NULL;
+  iree_status_t status = iree_hal_allocator_allocate_buffer(
+      allocator->base_allocator, memory_type, allowed_usage, allocation_size,
+      initial_data, &buffer);
+  if (!iree_status_is_ok(status)) {
+    iree_hal_budget_allocator_release_bytes(allocator, allocation_size);
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
+
+  if (buffer->device_allocator != allocator->base_allocator ||
+      buffer->allocated_buffer != buffer) {
+    // Not something we can observe the release of; let the base allocator own
+    // it uncounted.
+    iree_hal_budget_allocator_release_bytes(allocator, allocation_size);
+  } else {
+    // Charge the actual size, which may have been rounded up by the base
+    // allocator, and route the buffer back to us when it is released.
+    iree_slim_mutex_lock(&allocator->mutex);
+    allocator->allocated_bytes += buffer->allocation_size - allocation_size;
+    iree_slim_mutex_unlock(&allocator->mutex);
+    buffer->device_allocator = base_allocator;
+  }
+
+  *out_buffer = buffer;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+static void iree_hal_budget_allocator_deallocate_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_buffer_t* buffer) {
+  iree_hal_budget_allocator_t* allocator =
+      iree_hal_budget_allocator_cast(base_allocator);
+  iree_device_size_t allocation_size = buffer->allocation_size;
+  buffer->device_allocator = allocator->base_allocator;
+  iree_hal_allocator_deallocate_buffer(allocator->base_allocator, buffer);
+  iree_hal_budget_allocator_release_bytes(allocator, allocation_size);
+}
+
+static iree_status_t iree_hal_budget_allocator_wrap_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_memory_access_t allowed_access,
+    iree_hal_buffer_usage_t allowed_usage, iree_byte_span_t data,
+    iree_allocator_t data_allocator, iree_hal_buffer_t** out_buffer) {
+  iree_hal_budget_allocator_t* allocator =
+      iree_hal_budget_allocator_cast(base_allocator);
+  return iree_hal_allocator_wrap_buffer(allocator->base_allocator, memory_type,
+                                        allowed_access, allowed_usage, data,
+                                        data_allocator, out_buffer);
+}
+
+static iree_status_t iree_hal_budget_allocator_import_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_memory_access_t allowed_access,
+    iree_hal_buffer_usage_t allowed_usage,
+    iree_hal_external_buffer_t* external_buffer,
+    iree_hal_buffer_t** out_buffer) {
+  iree_hal_budget_allocator_t* allocator =
+      iree_hal_budget_allocator_cast(base_allocator);
+  return iree_hal_allocator_import_buffer(allocator->base_allocator,
+                                          memory_type, allowed_access,
+                                          allowed_usage, external_buffer,
+                                          out_buffer);
+}
+
+static iree_status_t iree_hal_budget_allocator_export_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_buffer_t* buffer,
+    iree_hal_external_buffer_type_t requested_type,
+    iree_hal_external_buffer_flags_t requested_flags,
+    iree_hal_external_buffer_t* out_external_buffer) {
+  iree_hal_budget_allocator_t* allocator =
+      iree_hal_budget_allocator_cast(base_allocator);
+  return iree_hal_allocator_export_buffer(allocator->base_allocator, buffer,
+                                          requested_type, requested_flags,
+                                          out_external_buffer);
+}
+
+static const iree_hal_allocator_vtable_t iree_hal_budget_allocator_vtable = {
+    .destroy = iree_hal_budget_allocator_destroy,
+    .host_allocator = iree_hal_budget_allocator_host_allocator,
+    .trim = iree_hal_budget_allocator_trim,
+    .query_statistics = iree_hal_budget_allocator_query_statistics,
+    .query_buffer_compatibility =
+        iree_hal_budget_allocator_query_buffer_compatibility,
+    .allocate_buffer = iree_hal_budget_allocator_allocate_buffer,
+    .deallocate_buffer = iree_hal_budget_allocator_deallocate_buffer,
+    .wrap_buffer = iree_hal_budget_allocator_wrap_buffer,
+    .import_buffer = iree_hal_budget_allocator_import_buffer,
+    .export_buffer = iree_hal_budget_allocator_export_buffer,
+};
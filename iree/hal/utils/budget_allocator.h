@@ -0,0 +1,70 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_UTILS_BUDGET_ALLOCATOR_H_
+#define IREE_HAL_UTILS_BUDGET_ALLOCATOR_H_
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Parameters configuring an iree_hal_budget_allocator_t.
+// Must be initialized with iree_hal_budget_allocator_params_initialize prior
+// to use.
+typedef struct iree_hal_budget_allocator_params_t {
+  // Total allocation size in bytes of all buffers that may be live at once.
+  iree_device_size_t max_allocated_bytes;
+
+  // Maximum duration an allocation that would exceed the budget waits for
+  // other buffers to be released before failing. IREE_DURATION_ZERO fails
+  // immediately and IREE_DURATION_INFINITE waits indefinitely.
+  iree_duration_t max_wait_duration;
+} iree_hal_budget_allocator_params_t;
+
+// Initializes |out_params| to default values.
+IREE_API_EXPORT void iree_hal_budget_allocator_params_initialize(
+    iree_hal_budget_allocator_params_t* out_params);
+
+// Creates an allocator that limits the total size of the buffers allocated
+// through it that are live at any time. Allocations are forwarded to
+// |base_allocator| which is retained for the lifetime of the budget allocator.
+//
+// An allocation that would exceed the budget waits for buffers to be released
+// (such as by another thread sharing the allocator or by device work
+// completing) and fails with IREE_STATUS_RESOURCE_EXHAUSTED if the budget is
+// still exhausted after the wait duration. Allocations larger than the entire
+// budget fail immediately. Wrapped and imported buffers are not owned by the
+// allocator and are not counted against the budget.
+//
+// Multiple users (such as sessions) may share one budget allocator to bound
+// their combined usage of a device. Like all allocators the budget allocator
+// must outlive any buffers allocated from it.
+IREE_API_EXPORT iree_status_t iree_hal_budget_allocator_create(
+    iree_hal_allocator_t* base_allocator,
+    const iree_hal_budget_allocator_params_t* params,
+    iree_allocator_t host_allocator, iree_hal_allocator_t** out_allocator);
+
+// Returns the total allocation size of all live buffers allocated from the
+// budget |allocator|.
+IREE_API_EXPORT iree_device_size_t iree_hal_budget_allocator_allocated_bytes(
+    iree_hal_allocator_t* allocator);
+
+// Checks whether work requiring up to |required_bytes| of live allocations can
+// ever be admitted by the budget |allocator|. Returns
+// IREE_STATUS_RESOURCE_EXHAUSTED if |required_bytes| exceeds the entire budget
+// such that the work can be rejected before it starts instead of failing
+// partway through.
+IREE_API_EXPORT iree_status_t iree_hal_budget_allocator_admit(
+    iree_hal_allocator_t* allocator, iree_device_size_t required_bytes);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_UTILS_BUDGET_ALLOCATOR_H_
@@ -0,0 +1,143 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/utils/budget_allocator.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace iree {
+namespace hal {
+namespace {
+
+using ::iree::testing::status::StatusIs;
+
+static const iree_hal_memory_type_t kMemoryType =
+    IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE;
+static const iree_hal_buffer_usage_t kUsage =
+    IREE_HAL_BUFFER_USAGE_DISPATCH | IREE_HAL_BUFFER_USAGE_TRANSFER;
+
+struct BudgetAllocatorTest : public ::testing::Test {
+  iree_allocator_t host_allocator = iree_allocator_system();
+  iree_hal_allocator_t* heap_allocator = NULL;
+
+  void SetUp() override {
+    IREE_ASSERT_OK(iree_hal_allocator_create_heap(
+        iree_make_cstring_view("heap"), host_allocator, host_allocator,
+        &heap_allocator));
+  }
+
+  void TearDown() override { iree_hal_allocator_release(heap_allocator); }
+
+  iree_hal_allocator_t* CreateBudgetAllocator(
+      iree_device_size_t max_allocated_bytes,
+      iree_duration_t max_wait_duration) {
+    iree_hal_budget_allocator_params_t params;
+    iree_hal_budget_allocator_params_initialize(&params);
+    params.max_allocated_bytes = max_allocated_bytes;
+    params.max_wait_duration = max_wait_duration;
+    iree_hal_allocator_t* allocator = NULL;
+    IREE_CHECK_OK(iree_hal_budget_allocator_create(
+        heap_allocator, &params, host_allocator, &allocator));
+    return allocator;
+  }
+
+  static iree_status_t Allocate(iree_hal_allocator_t* allocator,
+                                iree_device_size_t size,
+                                iree_hal_buffer_t** out_buffer) {
+    return iree_hal_allocator_allocate_buffer(allocator, kMemoryType, kUsage,
+                                              size,
+                                              iree_const_byte_span_empty(),
+                                              out_buffer);
+  }
+};
+
+// Tests that live buffers are counted until released.
+TEST_F(BudgetAllocatorTest, CountsLiveBuffers) {
+  iree_hal_allocator_t* allocator =
+      CreateBudgetAllocator(1024, IREE_DURATION_ZERO);
+
+  iree_hal_buffer_t* buffer0 = NULL;
+  IREE_ASSERT_OK(Allocate(allocator, 256, &buffer0));
+  iree_hal_buffer_t* buffer1 = NULL;
+  IREE_ASSERT_OK(Allocate(allocator, 512, &buffer1));
+  EXPECT_EQ(768, iree_hal_budget_allocator_allocated_bytes(allocator));
+
+  iree_hal_buffer_release(buffer0);
+  EXPECT_EQ(512, iree_hal_budget_allocator_allocated_bytes(allocator));
+  iree_hal_buffer_release(buffer1);
+  EXPECT_EQ(0, iree_hal_budget_allocator_allocated_bytes(allocator));
+
+  iree_hal_allocator_release(allocator);
+}
+
+// Tests that allocations exceeding the budget fail without waiting.
+TEST_F(BudgetAllocatorTest, ExhaustedWithoutWait) {
+  iree_hal_allocator_t* allocator =
+      CreateBudgetAllocator(1024, IREE_DURATION_ZERO);
+
+  iree_hal_buffer_t* buffer0 = NULL;
+  IREE_ASSERT_OK(Allocate(allocator, 768, &buffer0));
+  iree_hal_buffer_t* buffer1 = NULL;
+  EXPECT_THAT(Status(Allocate(allocator, 512, &buffer1)),
+              StatusIs(StatusCode::kResourceExhausted));
+  EXPECT_EQ(768, iree_hal_budget_allocator_allocated_bytes(allocator));
+
+  // Fits once the first buffer is released.
+  iree_hal_buffer_release(buffer0);
+  IREE_ASSERT_OK(Allocate(allocator, 512, &buffer1));
+  iree_hal_buffer_release(buffer1);
+
+  iree_hal_allocator_release(allocator);
+}
+
+// Tests that allocations exceeding the budget wait for buffers to be released.
+TEST_F(BudgetAllocatorTest, WaitsForRelease) {
+  iree_hal_allocator_t* allocator =
+      CreateBudgetAllocator(1024, IREE_DURATION_INFINITE);
+
+  iree_hal_buffer_t* buffer0 = NULL;
+  IREE_ASSERT_OK(Allocate(allocator, 768, &buffer0));
+  std::thread releaser([&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    iree_hal_buffer_release(buffer0);
+  });
+  iree_hal_buffer_t* buffer1 = NULL;
+  IREE_EXPECT_OK(Allocate(allocator, 512, &buffer1));
+  releaser.join();
+  EXPECT_EQ(512, iree_hal_budget_allocator_allocated_bytes(allocator));
+  iree_hal_buffer_release(buffer1);
+
+  iree_hal_allocator_release(allocator);
+}
+
+// Tests that work larger than the entire budget is rejected up front.
+TEST_F(BudgetAllocatorTest, Admit) {
+  iree_hal_allocator_t* allocator =
+      CreateBudgetAllocator(1024, IREE_DURATION_INFINITE);
+
+  IREE_EXPECT_OK(iree_hal_budget_allocator_admit(allocator, 1024));
+  EXPECT_THAT(Status(iree_hal_budget_allocator_admit(allocator, 1025)),
+              StatusIs(StatusCode::kResourceExhausted));
+
+  // Never waits as no amount of releases would make the allocation fit.
+  iree_hal_buffer_t* buffer = NULL;
+  EXPECT_THAT(Status(Allocate(allocator, 2048, &buffer)),
+              StatusIs(StatusCode::kResourceExhausted));
+
+  iree_hal_allocator_release(allocator);
+}
+
+}  // namespace
+}  // namespace hal
+}  // namespace iree
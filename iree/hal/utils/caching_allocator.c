@@ -0,0 +1,422 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/utils/caching_allocator.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "iree/base/internal/math.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/tracing.h"
+#include "iree/hal/detail.h"
+
+// Unused buffers of a single size class.
+typedef struct iree_hal_caching_allocator_bin_t {
+  iree_host_size_t count;
+  iree_host_size_t capacity;
+  iree_hal_buffer_t** buffers;
+} iree_hal_caching_allocator_bin_t;
+
+// Unused buffers with the same memory type and allowed usage.
+// Heaps are keyed on the properties of the buffers returned by the base
+// allocator as those may be a superset of what was requested.
+typedef struct iree_hal_caching_allocator_heap_t {
+  iree_hal_memory_type_t memory_type;
+  iree_hal_buffer_usage_t allowed_usage;
+  iree_hal_caching_allocator_bin_t
+      bins[IREE_HAL_CACHING_ALLOCATOR_MAX_SIZE_CLASS_COUNT];
+} iree_hal_caching_allocator_heap_t;
+
+typedef struct iree_hal_caching_allocator_t {
+  iree_hal_resource_t resource;
+  iree_allocator_t host_allocator;
+  iree_hal_allocator_t* base_allocator;
+
+  // log2 of the smallest size class.
+  int min_size_class_log2;
+  // Total number of size classes from min_size_class to max_size_class.
+  int size_class_count;
+  iree_device_size_t max_size_class;
+  iree_device_size_t max_retained_bytes;
+
+  // Guards all cache state below.
+  iree_slim_mutex_t mutex;
+
+  // Total allocation_size of all buffers retained in bins.
+  iree_device_size_t retained_bytes;
+
+  iree_host_size_t heap_count;
+  iree_hal_caching_allocator_heap_t
+      heaps[IREE_HAL_CACHING_ALLOCATOR_MAX_HEAP_COUNT];
+
+  IREE_STATISTICS(uint64_t hit_count; uint64_t miss_count;)
+} iree_hal_caching_allocator_t;
+
+static const iree_hal_allocator_vtable_t iree_hal_caching_allocator_vtable;
+
+static iree_hal_caching_allocator_t* iree_hal_caching_allocator_cast(
+    iree_hal_allocator_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_hal_caching_allocator_vtable);
+  return (iree_hal_caching_allocator_t*)base_value;
+}
+
+IREE_API_EXPORT void iree_hal_caching_allocator_params_initialize(
+    iree_hal_caching_allocator_params_t* out_params) {
+  memset(out_params, 0, sizeof(*out_params));
+  out_params->min_size_class = 256;
+  out_params->max_size_class = 64 * 1024 * 1024;
+  out_params->max_retained_bytes = 256 * 1024 * 1024;
+}
+
+static bool iree_hal_caching_allocator_is_pow2(iree_device_size_t value) {
+  return value != 0 && (value & (value - 1)) == 0;
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_caching_allocator_create(
+    iree_hal_allocator_t* base_allocator,
+    const iree_hal_caching_allocator_params_t* params,
+    iree_allocator_t host_allocator, iree_hal_allocator_t** out_allocator) {
+  IREE_ASSERT_ARGUMENT(base_allocator);
+  IREE_ASSERT_ARGUMENT(params);
+  IREE_ASSERT_ARGUMENT(out_allocator);
+  *out_allocator = NULL;
+
+  if (!iree_hal_caching_allocator_is_pow2(params->min_size_class) ||
+      !iree_hal_caching_allocator_is_pow2(params->max_size_class) ||
+      params->min_size_class > params->max_size_class) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "size classes must be powers of two with min <= max; "
+        "min=%" PRIdsz ", max=%" PRIdsz,
+        params->min_size_class, params->max_size_class);
+  }
+  int min_size_class_log2 =
+      iree_math_count_trailing_zeros_u64(params->min_size_class);
+  int max_size_class_log2 =
+      iree_math_count_trailing_zeros_u64(params->max_size_class);
+  int size_class_count = max_size_class_log2 - min_size_class_log2 + 1;
+  if (size_class_count > IREE_HAL_CACHING_ALLOCATOR_MAX_SIZE_CLASS_COUNT) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "%d size classes requested but only %d supported",
+                            size_class_count,
+                            IREE_HAL_CACHING_ALLOCATOR_MAX_SIZE_CLASS_COUNT);
+  }
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_caching_allocator_t* allocator = NULL;
+  iree_status_t status = iree_allocator_malloc(
+      host_allocator, sizeof(*allocator), (void**)&allocator);
+  if (iree_status_is_ok(status)) {
+    memset(allocator, 0, sizeof(*allocator));
+    iree_hal_resource_initialize(&iree_hal_caching_allocator_vtable,
+                                 &allocator->resource);
+    allocator->host_allocator = host_allocator;
+    allocator->base_allocator = base_allocator;
+    iree_hal_allocator_retain(base_allocator);
+    allocator->min_size_class_log2 = min_size_class_log2;
+    allocator->size_class_count = size_class_count;
+    allocator->max_size_class = params->max_size_class;
+    allocator->max_retained_bytes = params->max_retained_bytes;
+    iree_slim_mutex_initialize(&allocator->mutex);
+    *out_allocator = (iree_hal_allocator_t*)allocator;
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Returns all retained buffers to the base allocator.
+// Must be called with the mutex held.
+static void iree_hal_caching_allocator_flush_locked(
+    iree_hal_caching_allocator_t* allocator) {
+  for (iree_host_size_t i = 0; i < allocator->heap_count; ++i) {
+    iree_hal_caching_allocator_heap_t* heap = &allocator->heaps[i];
+    for (int j = 0; j < allocator->size_class_count; ++j) {
+      iree_hal_caching_allocator_bin_t* bin = &heap->bins[j];
+      for (iree_host_size_t k = 0; k < bin->count; ++k) {
+        iree_hal_buffer_t* buffer = bin->buffers[k];
+        buffer->device_allocator = allocator->base_allocator;
+        iree_hal_allocator_deallocate_buffer(allocator->base_allocator,
+                                             buffer);
+      }
+      bin->count = 0;
+    }
+  }
+  allocator->retained_bytes = 0;
+}
+
+static void iree_hal_caching_allocator_destroy(
+    iree_hal_allocator_t* base_allocator) {
+  iree_hal_caching_allocator_t* allocator =
+      iree_hal_caching_allocator_cast(base_allocator);
+  iree_allocator_t host_allocator = allocator->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_caching_allocator_flush_locked(allocator);
+  for (iree_host_size_t i = 0; i < allocator->heap_count; ++i) {
+    for (int j = 0; j < allocator->size_class_count; ++j) {
+      iree_allocator_free(host_allocator, allocator->heaps[i].bins[j].buffers);
+    }
+  }
+  iree_slim_mutex_deinitialize(&allocator->mutex);
+  iree_hal_allocator_release(allocator->base_allocator);
+  iree_allocator_free(host_allocator, allocator);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+static iree_allocator_t iree_hal_caching_allocator_host_allocator(
+    const iree_hal_allocator_t* base_allocator) {
+  iree_hal_caching_allocator_t* allocator =
+      (iree_hal_caching_allocator_t*)base_allocator;
+  return allocator->host_allocator;
+}
+
+static iree_status_t iree_hal_caching_allocator_trim(
+    iree_hal_allocator_t* base_allocator) {
+  iree_hal_caching_allocator_t* allocator =
+      iree_hal_caching_allocator_cast(base_allocator);
+  iree_slim_mutex_lock(&allocator->mutex);
+  iree_hal_caching_allocator_flush_locked(allocator);
+  iree_slim_mutex_unlock(&allocator->mutex);
+  return iree_hal_allocator_trim(allocator->base_allocator);
+}
+
+static void iree_hal_caching_allocator_query_statistics(
+    iree_hal_allocator_t* base_allocator,
+    iree_hal_allocator_statistics_t* out_statistics) {
+  IREE_STATISTICS({
+    iree_hal_caching_allocator_t* allocator =
+        iree_hal_caching_allocator_cast(base_allocator);
+    iree_hal_allocator_query_statistics(allocator->base_allocator,
+                                        out_statistics);
+    iree_slim_mutex_lock(&allocator->mutex);
+    out_statistics->cache_hit_count += allocator->hit_count;
+    out_statistics->cache_miss_count += allocator->miss_count;
+    iree_slim_mutex_unlock(&allocator->mutex);
+  });
+}
+
+static iree_hal_buffer_compatibility_t
+iree_hal_caching_allocator_query_buffer_compatibility(
+    iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_buffer_usage_t allowed_usage,
+    iree_hal_buffer_usage_t intended_usage,
+    iree_device_size_t allocation_size) {
+  iree_hal_caching_allocator_t* allocator =
+      iree_hal_caching_allocator_cast(base_allocator);
+  return iree_hal_allocator_query_buffer_compatibility(
+      allocator->base_allocator, memory_type, allowed_usage, intended_usage,
+      allocation_size);
+}
+
+// Returns the index of the smallest size class that can hold |size| bytes.
+static int iree_hal_caching_allocator_size_class_ceil(
+    iree_hal_caching_allocator_t* allocator, iree_device_size_t size) {
+  if (size <= ((iree_device_size_t)1 << allocator->min_size_class_log2)) {
+    return 0;
+  }
+  int size_log2 = 64 - iree_math_count_leading_zeros_u64(size - 1);
+  return size_log2 - allocator->min_size_class_log2;
+}
+
+// Returns the index of the largest size class that |size| bytes can satisfy.
+// Base allocators may round up allocations and we always want buffers in a bin
+// to be at least as large as the class size.
+static int iree_hal_caching_allocator_size_class_floor(
+    iree_hal_caching_allocator_t* allocator, iree_device_size_t size) {
+  int size_log2 = 63 - iree_math_count_leading_zeros_u64(size);
+  return iree_min(allocator->size_class_count - 1,
+                  size_log2 - allocator->min_size_class_log2);
+}
+
+// Pops a retained buffer compatible with the requested parameters, if any.
+// Must be called with the mutex held.
+static iree_hal_buffer_t* iree_hal_caching_allocator_pop_locked(
+    iree_hal_caching_allocator_t* allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_buffer_usage_t allowed_usage, int size_class) {
+  for (iree_host_size_t i = 0; i < allocator->heap_count; ++i) {
+    iree_hal_caching_allocator_heap_t* heap = &allocator->heaps[i];
+    if (!iree_all_bits_set(heap->memory_type, memory_type) ||
+        !iree_all_bits_set(heap->allowed_usage, allowed_usage)) {
+      continue;
+    }
+    iree_hal_caching_allocator_bin_t* bin = &heap->bins[size_class];
+    if (bin->count == 0) continue;
+    iree_hal_buffer_t* buffer = bin->buffers[--bin->count];
+    allocator->retained_bytes -= buffer->allocation_size;
+    return buffer;
+  }
+  return NULL;
+}
+
+static iree_status_t iree_hal_caching_allocator_allocate_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_buffer_usage_t allowed_usage, iree_host_size_t allocation_size,
+    iree_const_byte_span_t initial_data, iree_hal_buffer_t** out_buffer) {
+  iree_hal_caching_allocator_t* allocator =
+      iree_hal_caching_allocator_cast(base_allocator);
+
+  // Buffers with initial data are usually constants and large buffers would
+  // waste too much memory when rounded up: both go right to the base allocator.
+  if (!iree_const_byte_span_is_empty(initial_data) ||
+      allocation_size > allocator->max_size_class) {
+    return iree_hal_allocator_allocate_buffer(allocator->base_allocator,
+                                              memory_type, allowed_usage,
+                                              allocation_size, initial_data,
+                                              out_buffer);
+  }
+
+  int size_class =
+      iree_hal_caching_allocator_size_class_ceil(allocator, allocation_size);
+  iree_slim_mutex_lock(&allocator->mutex);
+  iree_hal_buffer_t* buffer = iree_hal_caching_allocator_pop_locked(
+      allocator, memory_type, allowed_usage, size_class);
+  IREE_STATISTICS({
+    if (buffer) {
+      ++allocator->hit_count;
+    } else {
+      ++allocator->miss_count;
+    }
+  });
+  iree_slim_mutex_unlock(&allocator->mutex);
+
+  if (buffer) {
+    // Revive the buffer; it was released with a ref count of 0.
+    iree_atomic_ref_count_init(&buffer->resource.ref_count);
+  } else {
+    iree_device_size_t size_class_size =
+        (iree_device_size_t)1 << (allocator->min_size_class_log2 + size_class);
+    IREE_RETURN_IF_ERROR(iree_hal_allocator_allocate_buffer(
+        allocator->base_allocator, memory_type, allowed_usage,
+        size_class_size, iree_const_byte_span_empty(), &buffer));
+    if (buffer->device_allocator != allocator->base_allocator ||
+        buffer->allocated_buffer != buffer) {
+      // Not something we know how to recycle; let the base allocator own it.
+      *out_buffer = buffer;
+      return iree_ok_status();
+    }
+    // Route the buffer back to us when its last reference is released.
+    buffer->device_allocator = base_allocator;
+  }
+
+  buffer->byte_length = allocation_size;
+  *out_buffer = buffer;
+  return iree_ok_status();
+}
+
+// Retains |buffer| in its bin if the budget allows.
+// Must be called with the mutex held.
+static bool iree_hal_caching_allocator_push_locked(
+    iree_hal_caching_allocator_t* allocator, iree_hal_buffer_t* buffer) {
+  if (allocator->retained_bytes + buffer->allocation_size >
+      allocator->max_retained_bytes) {
+    return false;
+  }
+
+  iree_hal_caching_allocator_heap_t* heap = NULL;
+  for (iree_host_size_t i = 0; i < allocator->heap_count; ++i) {
+    if (allocator->heaps[i].memory_type == buffer->memory_type &&
+        allocator->heaps[i].allowed_usage == buffer->allowed_usage) {
+      heap = &allocator->heaps[i];
+      break;
+    }
+  }
+  if (!heap) {
+    if (allocator->heap_count == IREE_ARRAYSIZE(allocator->heaps)) {
+      return false;
+    }
+    heap = &allocator->heaps[allocator->heap_count++];
+    heap->memory_type = buffer->memory_type;
+    heap->allowed_usage = buffer->allowed_usage;
+  }
+
+  iree_hal_caching_allocator_bin_t* bin =
+      &heap->bins[iree_hal_caching_allocator_size_class_floor(
+          allocator, buffer->allocation_size)];
+  if (bin->count == bin->capacity) {
+    iree_host_size_t new_capacity = iree_max(8, bin->capacity * 2);
+    iree_status_t status = iree_allocator_realloc(
+        allocator->host_allocator, new_capacity * sizeof(bin->buffers[0]),
+        (void**)&bin->buffers);
+    if (!iree_status_is_ok(status)) {
+      // Not fatal; we just drop the buffer instead of caching it.
+      iree_status_ignore(status);
+      return false;
+    }
+    bin->capacity = new_capacity;
+  }
+  bin->buffers[bin->count++] = buffer;
+  allocator->retained_bytes += buffer->allocation_size;
+  return true;
+}
+
+static void iree_hal_caching_allocator_deallocate_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_buffer_t* buffer) {
+  iree_hal_caching_allocator_t* allocator =
+      iree_hal_caching_allocator_cast(base_allocator);
+  iree_slim_mutex_lock(&allocator->mutex);
+  bool retained = iree_hal_caching_allocator_push_locked(allocator, buffer);
+  iree_slim_mutex_unlock(&allocator->mutex);
+  if (!retained) {
+    buffer->device_allocator = allocator->base_allocator;
+    iree_hal_allocator_deallocate_buffer(allocator->base_allocator, buffer);
+  }
+}
+
+static iree_status_t iree_hal_caching_allocator_wrap_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_memory_access_t allowed_access,
+    iree_hal_buffer_usage_t allowed_usage, iree_byte_span_t data,
+    iree_allocator_t data_allocator, iree_hal_buffer_t** out_buffer) {
+  iree_hal_caching_allocator_t* allocator =
+      iree_hal_caching_allocator_cast(base_allocator);
+  return iree_hal_allocator_wrap_buffer(allocator->base_allocator, memory_type,
+                                        allowed_access, allowed_usage, data,
+                                        data_allocator, out_buffer);
+}
+
+static iree_status_t iree_hal_caching_allocator_import_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_memory_access_t allowed_access,
+    iree_hal_buffer_usage_t allowed_usage,
+    iree_hal_external_buffer_t* external_buffer,
+    iree_hal_buffer_t** out_buffer) {
+  iree_hal_caching_allocator_t* allocator =
+      iree_hal_caching_allocator_cast(base_allocator);
+  return iree_hal_allocator_import_buffer(allocator->base_allocator,
+                                          memory_type, allowed_access,
+                                          allowed_usage, external_buffer,
+                                          out_buffer);
+}
+
+static iree_status_t iree_hal_caching_allocator_export_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_buffer_t* buffer,
+    iree_hal_external_buffer_type_t requested_type,
+    iree_hal_external_buffer_flags_t requested_flags,
+    iree_hal_external_buffer_t* out_external_buffer) {
+  iree_hal_caching_allocator_t* allocator =
+      iree_hal_caching_allocator_cast(base_allocator);
+  return iree_hal_allocator_export_buffer(allocator->base_allocator, buffer,
+                                          requested_type, requested_flags,
+                                          out_external_buffer);
+}
+
+static const iree_hal_allocator_vtable_t iree_hal_caching_allocator_vtable = {
+    .destroy = iree_hal_caching_allocator_destroy,
+    .host_allocator = iree_hal_caching_allocator_host_allocator,
+    .trim = iree_hal_caching_allocator_trim,
+    .query_statistics = iree_hal_caching_allocator_query_statistics,
+    .query_buffer_compatibility =
+        iree_hal_caching_allocator_query_buffer_compatibility,
+    .allocate_buffer = iree_hal_caching_allocator_allocate_buffer,
+    .deallocate_buffer = iree_hal_caching_allocator_deallocate_buffer,
+    .wrap_buffer = iree_hal_caching_allocator_wrap_buffer,
+    .import_buffer = iree_hal_caching_allocator_import_buffer,
+    .export_buffer = iree_hal_caching_allocator_export_buffer,
+};
@@ -0,0 +1,74 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_UTILS_CACHING_ALLOCATOR_H_
+#define IREE_HAL_UTILS_CACHING_ALLOCATOR_H_
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Maximum number of unique (memory type, allowed usage) pairs that can be
+// cached by a single caching allocator. Allocations with parameters beyond the
+// first pairs seen are passed through to the underlying allocator uncached.
+#define IREE_HAL_CACHING_ALLOCATOR_MAX_HEAP_COUNT 8
+
+// Maximum number of power-of-two size classes a caching allocator supports.
+#define IREE_HAL_CACHING_ALLOCATOR_MAX_SIZE_CLASS_COUNT 32
+
+// Parameters configuring an iree_hal_caching_allocator_t.
+// Must be initialized with iree_hal_caching_allocator_params_initialize prior
+// to use.
+typedef struct iree_hal_caching_allocator_params_t {
+  // Smallest size class in bytes; power-of-two. Allocations smaller than this
+  // are rounded up to it.
+  iree_device_size_t min_size_class;
+
+  // Largest size class in bytes; power-of-two. Allocations larger than this are
+  // passed through to the underlying allocator uncached.
+  iree_device_size_t max_size_class;
+
+  // Total bytes of unused buffers the allocator may retain across all size
+  // classes. Buffers released while the budget is exhausted are returned
+  // directly to the underlying allocator. 0 disables retention entirely.
+  iree_device_size_t max_retained_bytes;
+} iree_hal_caching_allocator_params_t;
+
+// Initializes |out_params| to default values.
+IREE_API_EXPORT void iree_hal_caching_allocator_params_initialize(
+    iree_hal_caching_allocator_params_t* out_params);
+
+// Creates an allocator that caches buffers released by users and reuses them
+// for subsequent allocations of the same memory type, usage, and size class.
+// All allocations that miss the cache are forwarded to |base_allocator| which
+// is retained for the lifetime of the caching allocator.
+//
+// Allocation sizes are rounded up to power-of-two size classes such that
+// buffers with similar (but not identical) sizes can be reused. Returned
+// buffers report the requested byte length with the rounded-up allocation
+// size. Allocations with initial data are passed through uncached as they are
+// usually long-lived constants.
+//
+// Cached buffers are returned to |base_allocator| when the retention budget is
+// exceeded, on iree_hal_allocator_trim, and when the caching allocator is
+// destroyed. Like all allocators the caching allocator must outlive any buffers
+// allocated from it.
+//
+// Cache hits and misses are reported via iree_hal_allocator_query_statistics
+// along with the statistics of |base_allocator|.
+IREE_API_EXPORT iree_status_t iree_hal_caching_allocator_create(
+    iree_hal_allocator_t* base_allocator,
+    const iree_hal_caching_allocator_params_t* params,
+    iree_allocator_t host_allocator, iree_hal_allocator_t** out_allocator);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_UTILS_CACHING_ALLOCATOR_H_
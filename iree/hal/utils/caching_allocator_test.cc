@@ -0,0 +1,174 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/utils/caching_allocator.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace iree {
+namespace hal {
+namespace {
+
+using ::iree::testing::status::StatusIs;
+
+static const iree_hal_memory_type_t kMemoryType =
+    IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE;
+static const iree_hal_buffer_usage_t kUsage =
+    IREE_HAL_BUFFER_USAGE_DISPATCH | IREE_HAL_BUFFER_USAGE_TRANSFER;
+
+struct CachingAllocatorTest : public ::testing::Test {
+  iree_allocator_t host_allocator = iree_allocator_system();
+  iree_hal_allocator_t* heap_allocator = NULL;
+
+  void SetUp() override {
+    IREE_ASSERT_OK(iree_hal_allocator_create_heap(
+        iree_make_cstring_view("heap"), host_allocator, host_allocator,
+        &heap_allocator));
+  }
+
+  void TearDown() override { iree_hal_allocator_release(heap_allocator); }
+
+  iree_hal_allocator_t* CreateCachingAllocator(
+      iree_device_size_t max_retained_bytes) {
+    iree_hal_caching_allocator_params_t params;
+    iree_hal_caching_allocator_params_initialize(&params);
+    params.min_size_class = 64;
+    params.max_size_class = 4096;
+    params.max_retained_bytes = max_retained_bytes;
+    iree_hal_allocator_t* allocator = NULL;
+    IREE_CHECK_OK(iree_hal_caching_allocator_create(
+        heap_allocator, &params, host_allocator, &allocator));
+    return allocator;
+  }
+
+  static iree_hal_buffer_t* Allocate(iree_hal_allocator_t* allocator,
+                                     iree_device_size_t size) {
+    iree_hal_buffer_t* buffer = NULL;
+    IREE_CHECK_OK(iree_hal_allocator_allocate_buffer(
+        allocator, kMemoryType, kUsage, size, iree_const_byte_span_empty(),
+        &buffer));
+    return buffer;
+  }
+};
+
+TEST_F(CachingAllocatorTest, InvalidParams) {
+  iree_hal_caching_allocator_params_t params;
+  iree_hal_caching_allocator_params_initialize(&params);
+  params.min_size_class = 100;
+  iree_hal_allocator_t* allocator = NULL;
+  EXPECT_THAT(Status(iree_hal_caching_allocator_create(
+                  heap_allocator, &params, host_allocator, &allocator)),
+              StatusIs(StatusCode::kInvalidArgument));
+}
+
+// Tests that a released buffer is reused for a request of the same size class.
+TEST_F(CachingAllocatorTest, ReuseSizeClass) {
+  iree_hal_allocator_t* allocator = CreateCachingAllocator(1024 * 1024);
+
+  iree_hal_buffer_t* buffer0 = Allocate(allocator, 100);
+  EXPECT_EQ(100, iree_hal_buffer_byte_length(buffer0));
+  EXPECT_EQ(128, iree_hal_buffer_allocation_size(buffer0));
+  iree_hal_buffer_release(buffer0);
+
+  // Same size class (65-128 bytes) and compatible parameters.
+  iree_hal_buffer_t* buffer1 = Allocate(allocator, 120);
+  EXPECT_EQ(buffer0, buffer1);
+  EXPECT_EQ(120, iree_hal_buffer_byte_length(buffer1));
+
+  // Different size class while buffer1 is live must miss.
+  iree_hal_buffer_t* buffer2 = Allocate(allocator, 1000);
+  EXPECT_NE(buffer1, buffer2);
+  EXPECT_EQ(1024, iree_hal_buffer_allocation_size(buffer2));
+
+  // The buffer contents must remain usable after reuse.
+  uint32_t pattern = 0xCAFEF00Du;
+  IREE_EXPECT_OK(iree_hal_buffer_fill(buffer1, 0, IREE_WHOLE_BUFFER,
+                                      &pattern, sizeof(pattern)));
+
+  iree_hal_buffer_release(buffer1);
+  iree_hal_buffer_release(buffer2);
+
+#if IREE_STATISTICS_ENABLE
+  iree_hal_allocator_statistics_t statistics;
+  iree_hal_allocator_query_statistics(allocator, &statistics);
+  EXPECT_EQ(1, statistics.cache_hit_count);
+  EXPECT_EQ(2, statistics.cache_miss_count);
+#endif  // IREE_STATISTICS_ENABLE
+
+  iree_hal_allocator_release(allocator);
+}
+
+// Tests that buffers are not retained beyond the retention budget.
+TEST_F(CachingAllocatorTest, RetentionBudget) {
+  iree_hal_allocator_t* allocator = CreateCachingAllocator(/*budget=*/128);
+
+  iree_hal_buffer_t* buffer0 = Allocate(allocator, 128);
+  iree_hal_buffer_t* buffer1 = Allocate(allocator, 128);
+  iree_hal_buffer_release(buffer0);  // retained
+  iree_hal_buffer_release(buffer1);  // over budget; freed
+
+  iree_hal_buffer_t* buffer2 = Allocate(allocator, 128);
+  EXPECT_EQ(buffer0, buffer2);
+  iree_hal_buffer_release(buffer2);
+
+#if IREE_STATISTICS_ENABLE
+  iree_hal_allocator_statistics_t statistics;
+  iree_hal_allocator_query_statistics(allocator, &statistics);
+  EXPECT_EQ(1, statistics.cache_hit_count);
+  EXPECT_EQ(2, statistics.cache_miss_count);
+  // 3 allocations would have been made without the cache.
+  EXPECT_EQ(2 * 128, statistics.host_bytes_allocated +
+                         statistics.device_bytes_allocated);
+#endif  // IREE_STATISTICS_ENABLE
+
+  iree_hal_allocator_release(allocator);
+}
+
+// Tests that trimming returns all retained buffers to the base allocator.
+TEST_F(CachingAllocatorTest, Trim) {
+  iree_hal_allocator_t* allocator = CreateCachingAllocator(1024 * 1024);
+
+  iree_hal_buffer_release(Allocate(allocator, 256));
+  iree_hal_buffer_release(Allocate(allocator, 512));
+  IREE_ASSERT_OK(iree_hal_allocator_trim(allocator));
+
+#if IREE_STATISTICS_ENABLE
+  iree_hal_allocator_statistics_t statistics;
+  iree_hal_allocator_query_statistics(allocator, &statistics);
+  EXPECT_EQ(statistics.host_bytes_allocated + statistics.device_bytes_allocated,
+            statistics.host_bytes_freed + statistics.device_bytes_freed);
+#endif  // IREE_STATISTICS_ENABLE
+
+  iree_hal_allocator_release(allocator);
+}
+
+// Tests that allocations larger than the max size class bypass the cache.
+TEST_F(CachingAllocatorTest, LargeAllocationsUncached) {
+  iree_hal_allocator_t* allocator = CreateCachingAllocator(1024 * 1024);
+
+  iree_hal_buffer_t* buffer = Allocate(allocator, 8192 + 1);
+  EXPECT_EQ(8192 + 1, iree_hal_buffer_allocation_size(buffer));
+  iree_hal_buffer_release(buffer);
+
+#if IREE_STATISTICS_ENABLE
+  iree_hal_allocator_statistics_t statistics;
+  iree_hal_allocator_query_statistics(allocator, &statistics);
+  EXPECT_EQ(0, statistics.cache_hit_count);
+  EXPECT_EQ(0, statistics.cache_miss_count);
+#endif  // IREE_STATISTICS_ENABLE
+
+  iree_hal_allocator_release(allocator);
+}
+
+}  // namespace
+}  // namespace hal
+}  // namespace iree
@@ -33,11 +33,11 @@ typedef enum iree_hal_command_type_e {
 // Header prefixed to all commands, forming a linked-list.
 //
 // Each command is allocated from the arena and does *not* retain any resources.
-// We could elide some of these commands by keeping local state however that
-// requires knowing more about the target device (executable layouts, etc) and
-// prevents using this as a way to debug or benchmark command buffers. The
-// intent is that each command captures the exact information passed during the
-// call such that the target command buffer cannot tell they were deferred.
+// When IREE_HAL_DEFERRED_COMMAND_BUFFER_COMPACTION_ENABLE is set commands are
+// compacted as they are recorded (see iree_hal_cmd_state_t) in ways that do not
+// require knowing anything about the target device. Otherwise each command
+// captures the exact information passed during the call such that the target
+// command buffer cannot tell they were deferred.
 //
 // As each command is variable sized we store pointers to the following command
 // to allow us to walk the list during replay. Storing just a size would be
@@ -50,8 +50,12 @@ typedef struct iree_hal_cmd_header_t {
   iree_hal_cmd_type_t type;
 } iree_hal_cmd_header_t;
 
+// Applies a recorded command to |target_command_buffer|. |binding_table| is
+// non-NULL only when replaying a command buffer recorded with
+// IREE_HAL_COMMAND_BUFFER_MODE_INDIRECT_BINDINGS.
 typedef iree_status_t (*iree_hal_cmd_apply_fn_t)(
     iree_hal_command_buffer_t* target_command_buffer,
+    const iree_hal_buffer_binding_table_t* binding_table,
     iree_hal_cmd_header_t* cmd_header);
 
 //===----------------------------------------------------------------------===//
@@ -128,6 +132,62 @@ static iree_status_t iree_hal_cmd_list_clone_data(iree_hal_cmd_list_t* cmd_list,
   return iree_ok_status();
 }
 
+// Concatenates two source buffers and returns the pointer into the arena.
+static iree_status_t iree_hal_cmd_list_concat_data(
+    iree_hal_cmd_list_t* cmd_list, const void* lhs_data,
+    iree_host_size_t lhs_length, const void* rhs_data,
+    iree_host_size_t rhs_length, void** out_target_data) {
+  uint8_t* target_data = NULL;
+  IREE_RETURN_IF_ERROR(iree_arena_allocate(
+      &cmd_list->arena, lhs_length + rhs_length, (void**)&target_data));
+  if (lhs_length) memcpy(target_data, lhs_data, lhs_length);
+  if (rhs_length) memcpy(target_data + lhs_length, rhs_data, rhs_length);
+  *out_target_data = target_data;
+  return iree_ok_status();
+}
+
+//===----------------------------------------------------------------------===//
+// Command compaction
+//===----------------------------------------------------------------------===//
+
+// Maximum descriptor set ordinal tracked for redundant push/bind elision.
+// Sets with higher ordinals are always recorded.
+#define IREE_HAL_CMD_STATE_MAX_DESCRIPTOR_SET_COUNT 4
+
+// Recording state used to compact commands as they are recorded:
+//  - adjacent fills and copies of contiguous ranges are coalesced
+//  - adjacent execution barriers are merged
+//  - push constants and descriptor set pushes/binds that match the current
+//    state established with the same executable layout are dropped
+//
+// All of these only rely on the HAL command buffer semantics and not on the
+// target device. Reordering dispatches is not performed as the target is in a
+// better position to schedule the commands between barriers than we are.
+typedef struct iree_hal_cmd_state_t {
+  // Executable layout the tracked state was established with. Switching
+  // layouts may disturb the state on some targets so everything is dropped.
+  iree_hal_executable_layout_t* executable_layout;
+  // Last recorded push constants command.
+  const struct iree_hal_cmd_push_constants_t* push_constants;
+  // Last recorded push or bind command per descriptor set.
+  const iree_hal_cmd_header_t*
+      descriptor_sets[IREE_HAL_CMD_STATE_MAX_DESCRIPTOR_SET_COUNT];
+} iree_hal_cmd_state_t;
+
+static void iree_hal_cmd_state_reset(iree_hal_cmd_state_t* state) {
+  memset(state, 0, sizeof(*state));
+}
+
+// Switches the tracked state to |executable_layout|, dropping all state
+// established with any other layout.
+static void iree_hal_cmd_state_use_layout(
+    iree_hal_cmd_state_t* state,
+    iree_hal_executable_layout_t* executable_layout) {
+  if (state->executable_layout == executable_layout) return;
+  iree_hal_cmd_state_reset(state);
+  state->executable_layout = executable_layout;
+}
+
 //===----------------------------------------------------------------------===//
 // iree_hal_deferred_command_buffer_t implementation
 //===----------------------------------------------------------------------===//
@@ -142,6 +202,9 @@ typedef struct iree_hal_deferred_command_buffer_t {
 
   // All commands in encoding order.
   iree_hal_cmd_list_t cmd_list;
+
+  // State of the recording used to compact commands. Reset on each begin.
+  iree_hal_cmd_state_t cmd_state;
 } iree_hal_deferred_command_buffer_t;
 
 static const iree_hal_command_buffer_vtable_t
@@ -172,6 +235,7 @@ IREE_API_EXPORT iree_status_t iree_hal_deferred_command_buffer_create(
         &iree_hal_deferred_command_buffer_vtable, &command_buffer->base);
     command_buffer->host_allocator = host_allocator;
     iree_hal_cmd_list_initialize(block_pool, &command_buffer->cmd_list);
+    iree_hal_cmd_state_reset(&command_buffer->cmd_state);
 
     status = iree_hal_resource_set_allocate(block_pool,
                                             &command_buffer->resource_set);
@@ -214,6 +278,7 @@ static iree_status_t iree_hal_deferred_command_buffer_begin(
   iree_hal_deferred_command_buffer_t* command_buffer =
       iree_hal_deferred_command_buffer_cast(base_command_buffer);
   iree_hal_cmd_list_reset(&command_buffer->cmd_list);
+  iree_hal_cmd_state_reset(&command_buffer->cmd_state);
   iree_hal_resource_set_reset(command_buffer->resource_set);
   return iree_ok_status();
 }
@@ -238,6 +303,38 @@ typedef struct iree_hal_cmd_execution_barrier_t {
   const iree_hal_buffer_barrier_t* buffer_barriers;
 } iree_hal_cmd_execution_barrier_t;
 
+// Merges a new barrier into the immediately preceding barrier |cmd|.
+static iree_status_t iree_hal_cmd_execution_barrier_merge(
+    iree_hal_cmd_list_t* cmd_list, iree_hal_cmd_execution_barrier_t* cmd,
+    iree_hal_execution_stage_t source_stage_mask,
+    iree_hal_execution_stage_t target_stage_mask,
+    iree_hal_execution_barrier_flags_t flags,
+    iree_host_size_t memory_barrier_count,
+    const iree_hal_memory_barrier_t* memory_barriers,
+    iree_host_size_t buffer_barrier_count,
+    const iree_hal_buffer_barrier_t* buffer_barriers) {
+  if (memory_barrier_count > 0) {
+    IREE_RETURN_IF_ERROR(iree_hal_cmd_list_concat_data(
+        cmd_list, cmd->memory_barriers,
+        sizeof(memory_barriers[0]) * cmd->memory_barrier_count,
+        memory_barriers, sizeof(memory_barriers[0]) * memory_barrier_count,
+        (void**)&cmd->memory_barriers));
+    cmd->memory_barrier_count += memory_barrier_count;
+  }
+  if (buffer_barrier_count > 0) {
+    IREE_RETURN_IF_ERROR(iree_hal_cmd_list_concat_data(
+        cmd_list, cmd->buffer_barriers,
+        sizeof(buffer_barriers[0]) * cmd->buffer_barrier_count,
+        buffer_barriers, sizeof(buffer_barriers[0]) * buffer_barrier_count,
+        (void**)&cmd->buffer_barriers));
+    cmd->buffer_barrier_count += buffer_barrier_count;
+  }
+  cmd->source_stage_mask |= source_stage_mask;
+  cmd->target_stage_mask |= target_stage_mask;
+  cmd->flags |= flags;
+  return iree_ok_status();
+}
+
 static iree_status_t iree_hal_deferred_command_buffer_execution_barrier(
     iree_hal_command_buffer_t* base_command_buffer,
     iree_hal_execution_stage_t source_stage_mask,
@@ -249,6 +346,15 @@ static iree_status_t iree_hal_deferred_command_buffer_execution_barrier(
     const iree_hal_buffer_barrier_t* buffer_barriers) {
   iree_hal_cmd_list_t* cmd_list =
       &iree_hal_deferred_command_buffer_cast(base_command_buffer)->cmd_list;
+  // Back-to-back barriers with nothing between them are equivalent to a single
+  // barrier covering the union of both.
+  if (IREE_HAL_DEFERRED_COMMAND_BUFFER_COMPACTION_ENABLE && cmd_list->tail &&
+      cmd_list->tail->type == IREE_HAL_CMD_EXECUTION_BARRIER) {
+    return iree_hal_cmd_execution_barrier_merge(
+        cmd_list, (iree_hal_cmd_execution_barrier_t*)cmd_list->tail,
+        source_stage_mask, target_stage_mask, flags, memory_barrier_count,
+        memory_barriers, buffer_barrier_count, buffer_barriers);
+  }
   iree_hal_cmd_execution_barrier_t* cmd = NULL;
   IREE_RETURN_IF_ERROR(iree_hal_cmd_list_append_command(
       cmd_list, IREE_HAL_CMD_EXECUTION_BARRIER, sizeof(*cmd), (void**)&cmd));
@@ -276,6 +382,7 @@ static iree_status_t iree_hal_deferred_command_buffer_execution_barrier(
 
 static iree_status_t iree_hal_deferred_command_buffer_apply_execution_barrier(
     iree_hal_command_buffer_t* target_command_buffer,
+    const iree_hal_buffer_binding_table_t* binding_table,
     const iree_hal_cmd_execution_barrier_t* cmd) {
   return iree_hal_command_buffer_execution_barrier(
       target_command_buffer, cmd->source_stage_mask, cmd->target_stage_mask,
@@ -311,6 +418,7 @@ static iree_status_t iree_hal_deferred_command_buffer_signal_event(
 
 static iree_status_t iree_hal_deferred_command_buffer_apply_signal_event(
     iree_hal_command_buffer_t* target_command_buffer,
+    const iree_hal_buffer_binding_table_t* binding_table,
     const iree_hal_cmd_signal_event_t* cmd) {
   return iree_hal_command_buffer_signal_event(target_command_buffer, cmd->event,
                                               cmd->source_stage_mask);
@@ -344,6 +452,7 @@ static iree_status_t iree_hal_deferred_command_buffer_reset_event(
 
 static iree_status_t iree_hal_deferred_command_buffer_apply_reset_event(
     iree_hal_command_buffer_t* target_command_buffer,
+    const iree_hal_buffer_binding_table_t* binding_table,
     const iree_hal_cmd_reset_event_t* cmd) {
   return iree_hal_command_buffer_reset_event(target_command_buffer, cmd->event,
                                              cmd->source_stage_mask);
@@ -408,6 +517,7 @@ static iree_status_t iree_hal_deferred_command_buffer_wait_events(
 
 static iree_status_t iree_hal_deferred_command_buffer_apply_wait_events(
     iree_hal_command_buffer_t* target_command_buffer,
+    const iree_hal_buffer_binding_table_t* binding_table,
     const iree_hal_cmd_wait_events_t* cmd) {
   return iree_hal_command_buffer_wait_events(
       target_command_buffer, cmd->event_count,
@@ -441,6 +551,7 @@ static iree_status_t iree_hal_deferred_command_buffer_discard_buffer(
 
 static iree_status_t iree_hal_deferred_command_buffer_apply_discard_buffer(
     iree_hal_command_buffer_t* target_command_buffer,
+    const iree_hal_buffer_binding_table_t* binding_table,
     const iree_hal_cmd_discard_buffer_t* cmd) {
   return iree_hal_command_buffer_discard_buffer(target_command_buffer,
                                                 cmd->buffer);
@@ -472,6 +583,22 @@ static iree_status_t iree_hal_deferred_command_buffer_fill_buffer(
     return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
                             "fill patterns must be < 8 bytes");
   }
+  // Extend the preceding fill if this one continues it with the same pattern.
+  // Fill lengths are a multiple of the pattern length so the pattern stays in
+  // phase across the two ranges.
+  if (IREE_HAL_DEFERRED_COMMAND_BUFFER_COMPACTION_ENABLE && cmd_list->tail &&
+      cmd_list->tail->type == IREE_HAL_CMD_FILL_BUFFER) {
+    iree_hal_cmd_fill_buffer_t* prev_cmd =
+        (iree_hal_cmd_fill_buffer_t*)cmd_list->tail;
+    if (prev_cmd->target_buffer == target_buffer &&
+        prev_cmd->pattern_length == pattern_length &&
+        memcmp(&prev_cmd->pattern, pattern, pattern_length) == 0 &&
+        prev_cmd->length != IREE_WHOLE_BUFFER && length != IREE_WHOLE_BUFFER &&
+        prev_cmd->target_offset + prev_cmd->length == target_offset) {
+      prev_cmd->length += length;
+      return iree_ok_status();
+    }
+  }
   IREE_RETURN_IF_ERROR(iree_hal_resource_set_insert(
       command_buffer->resource_set, 1, &target_buffer));
   IREE_RETURN_IF_ERROR(iree_hal_cmd_list_append_command(
@@ -486,6 +613,7 @@ static iree_status_t iree_hal_deferred_command_buffer_fill_buffer(
 
 static iree_status_t iree_hal_deferred_command_buffer_apply_fill_buffer(
     iree_hal_command_buffer_t* target_command_buffer,
+    const iree_hal_buffer_binding_table_t* binding_table,
     const iree_hal_cmd_fill_buffer_t* cmd) {
   return iree_hal_command_buffer_fill_buffer(
       target_command_buffer, cmd->target_buffer, cmd->target_offset,
@@ -527,6 +655,7 @@ static iree_status_t iree_hal_deferred_command_buffer_update_buffer(
 
 static iree_status_t iree_hal_deferred_command_buffer_apply_update_buffer(
     iree_hal_command_buffer_t* target_command_buffer,
+    const iree_hal_buffer_binding_table_t* binding_table,
     const iree_hal_cmd_update_buffer_t* cmd) {
   return iree_hal_command_buffer_update_buffer(
       target_command_buffer, cmd->source_buffer, 0, cmd->target_buffer,
@@ -554,6 +683,24 @@ static iree_status_t iree_hal_deferred_command_buffer_copy_buffer(
   iree_hal_deferred_command_buffer_t* command_buffer =
       iree_hal_deferred_command_buffer_cast(base_command_buffer);
   iree_hal_cmd_list_t* cmd_list = &command_buffer->cmd_list;
+  // Extend the preceding copy if this one continues both its source and target
+  // ranges. Only done across distinct allocations so that the first copy can't
+  // have written to what the second reads.
+  if (IREE_HAL_DEFERRED_COMMAND_BUFFER_COMPACTION_ENABLE && cmd_list->tail &&
+      cmd_list->tail->type == IREE_HAL_CMD_COPY_BUFFER) {
+    iree_hal_cmd_copy_buffer_t* prev_cmd =
+        (iree_hal_cmd_copy_buffer_t*)cmd_list->tail;
+    if (prev_cmd->source_buffer == source_buffer &&
+        prev_cmd->target_buffer == target_buffer &&
+        iree_hal_buffer_allocated_buffer(source_buffer) !=
+            iree_hal_buffer_allocated_buffer(target_buffer) &&
+        prev_cmd->length != IREE_WHOLE_BUFFER && length != IREE_WHOLE_BUFFER &&
+        prev_cmd->source_offset + prev_cmd->length == source_offset &&
+        prev_cmd->target_offset + prev_cmd->length == target_offset) {
+      prev_cmd->length += length;
+      return iree_ok_status();
+    }
+  }
   const void* buffers[2] = {source_buffer, target_buffer};
   IREE_RETURN_IF_ERROR(
       iree_hal_resource_set_insert(command_buffer->resource_set, 2, buffers));
@@ -570,6 +717,7 @@ static iree_status_t iree_hal_deferred_command_buffer_copy_buffer(
 
 static iree_status_t iree_hal_deferred_command_buffer_apply_copy_buffer(
     iree_hal_command_buffer_t* target_command_buffer,
+    const iree_hal_buffer_binding_table_t* binding_table,
     const iree_hal_cmd_copy_buffer_t* cmd) {
   return iree_hal_command_buffer_copy_buffer(
       target_command_buffer, cmd->source_buffer, cmd->source_offset,
@@ -595,6 +743,15 @@ static iree_status_t iree_hal_deferred_command_buffer_push_constants(
   iree_hal_deferred_command_buffer_t* command_buffer =
       iree_hal_deferred_command_buffer_cast(base_command_buffer);
   iree_hal_cmd_list_t* cmd_list = &command_buffer->cmd_list;
+  iree_hal_cmd_state_t* cmd_state = &command_buffer->cmd_state;
+  iree_hal_cmd_state_use_layout(cmd_state, executable_layout);
+  const iree_hal_cmd_push_constants_t* prev_cmd = cmd_state->push_constants;
+  if (IREE_HAL_DEFERRED_COMMAND_BUFFER_COMPACTION_ENABLE && prev_cmd &&
+      prev_cmd->offset == offset &&
+      prev_cmd->values_length == values_length &&
+      memcmp(prev_cmd->values, values, values_length) == 0) {
+    return iree_ok_status();
+  }
   IREE_RETURN_IF_ERROR(iree_hal_resource_set_insert(
       command_buffer->resource_set, 1, &executable_layout));
   iree_hal_cmd_push_constants_t* cmd = NULL;
@@ -605,11 +762,13 @@ static iree_status_t iree_hal_deferred_command_buffer_push_constants(
   cmd->offset = offset;
   cmd->values_length = values_length;
   memcpy(cmd->values, values, sizeof(cmd->values[0]) * values_length);
+  cmd_state->push_constants = cmd;
   return iree_ok_status();
 }
 
 static iree_status_t iree_hal_deferred_command_buffer_apply_push_constants(
     iree_hal_command_buffer_t* target_command_buffer,
+    const iree_hal_buffer_binding_table_t* binding_table,
     const iree_hal_cmd_push_constants_t* cmd) {
   return iree_hal_command_buffer_push_constants(
       target_command_buffer, cmd->executable_layout, cmd->offset, cmd->values,
@@ -628,6 +787,28 @@ typedef struct iree_hal_cmd_push_descriptor_set_t {
   iree_hal_descriptor_set_binding_t bindings[];
 } iree_hal_cmd_push_descriptor_set_t;
 
+// Returns true if |prev_header| is a push of the same bindings.
+static bool iree_hal_cmd_push_descriptor_set_matches(
+    const iree_hal_cmd_header_t* prev_header, iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_binding_t* bindings) {
+  if (!prev_header || prev_header->type != IREE_HAL_CMD_PUSH_DESCRIPTOR_SET) {
+    return false;
+  }
+  const iree_hal_cmd_push_descriptor_set_t* prev_cmd =
+      (const iree_hal_cmd_push_descriptor_set_t*)prev_header;
+  if (prev_cmd->binding_count != binding_count) return false;
+  for (iree_host_size_t i = 0; i < binding_count; ++i) {
+    const iree_hal_descriptor_set_binding_t* lhs = &prev_cmd->bindings[i];
+    const iree_hal_descriptor_set_binding_t* rhs = &bindings[i];
+    if (lhs->binding != rhs->binding || lhs->buffer != rhs->buffer ||
+        lhs->offset != rhs->offset || lhs->length != rhs->length ||
+        (!rhs->buffer && lhs->buffer_slot != rhs->buffer_slot)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 static iree_status_t iree_hal_deferred_command_buffer_push_descriptor_set(
     iree_hal_command_buffer_t* base_command_buffer,
     iree_hal_executable_layout_t* executable_layout, uint32_t set,
@@ -636,6 +817,14 @@ static iree_status_t iree_hal_deferred_command_buffer_push_descriptor_set(
   iree_hal_deferred_command_buffer_t* command_buffer =
       iree_hal_deferred_command_buffer_cast(base_command_buffer);
   iree_hal_cmd_list_t* cmd_list = &command_buffer->cmd_list;
+  iree_hal_cmd_state_t* cmd_state = &command_buffer->cmd_state;
+  iree_hal_cmd_state_use_layout(cmd_state, executable_layout);
+  if (IREE_HAL_DEFERRED_COMMAND_BUFFER_COMPACTION_ENABLE &&
+      set < IREE_HAL_CMD_STATE_MAX_DESCRIPTOR_SET_COUNT &&
+      iree_hal_cmd_push_descriptor_set_matches(cmd_state->descriptor_sets[set],
+                                               binding_count, bindings)) {
+    return iree_ok_status();
+  }
   IREE_RETURN_IF_ERROR(iree_hal_resource_set_insert(
       command_buffer->resource_set, 1, &executable_layout));
   for (iree_host_size_t i = 0; i < binding_count; ++i) {
@@ -650,15 +839,67 @@ static iree_status_t iree_hal_deferred_command_buffer_push_descriptor_set(
   cmd->set = set;
   cmd->binding_count = binding_count;
   memcpy(cmd->bindings, bindings, sizeof(cmd->bindings[0]) * binding_count);
+  if (set < IREE_HAL_CMD_STATE_MAX_DESCRIPTOR_SET_COUNT) {
+    cmd_state->descriptor_sets[set] = &cmd->header;
+  }
   return iree_ok_status();
 }
 
 static iree_status_t iree_hal_deferred_command_buffer_apply_push_descriptor_set(
     iree_hal_command_buffer_t* target_command_buffer,
+    const iree_hal_buffer_binding_table_t* binding_table,
     const iree_hal_cmd_push_descriptor_set_t* cmd) {
+  if (!binding_table) {
+    return iree_hal_command_buffer_push_descriptor_set(
+        target_command_buffer, cmd->executable_layout, cmd->set,
+        cmd->binding_count, cmd->bindings);
+  }
+
+  // Resolve bindings referencing binding table slots to the buffers in the
+  // table, applying the binding range relative to the slot range.
+  iree_hal_descriptor_set_binding_t* bindings =
+      (iree_hal_descriptor_set_binding_t*)iree_alloca(
+          cmd->binding_count * sizeof(iree_hal_descriptor_set_binding_t));
+  for (iree_host_size_t i = 0; i < cmd->binding_count; ++i) {
+    bindings[i] = cmd->bindings[i];
+    if (bindings[i].buffer) continue;
+    uint32_t slot = bindings[i].buffer_slot;
+    if (IREE_UNLIKELY(slot >= binding_table->count)) {
+      return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                              "binding table slot %u out of range of the "
+                              "submission binding table (count=%zu)",
+                              slot, binding_table->count);
+    }
+    const iree_hal_buffer_binding_t* slot_binding =
+        &binding_table->bindings[slot];
+    if (IREE_UNLIKELY(!slot_binding->buffer)) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "binding table slot %u has no buffer", slot);
+    }
+    if (slot_binding->length != IREE_WHOLE_BUFFER) {
+      if (IREE_UNLIKELY(bindings[i].offset > slot_binding->length)) {
+        return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                                "binding offset exceeds the range of binding "
+                                "table slot %u",
+                                slot);
+      }
+      iree_device_size_t remaining_length =
+          slot_binding->length - bindings[i].offset;
+      if (bindings[i].length == IREE_WHOLE_BUFFER) {
+        bindings[i].length = remaining_length;
+      } else if (IREE_UNLIKELY(bindings[i].length > remaining_length)) {
+        return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                                "binding length exceeds the range of binding "
+                                "table slot %u",
+                                slot);
+      }
+    }
+    bindings[i].buffer = slot_binding->buffer;
+    bindings[i].offset += slot_binding->offset;
+  }
   return iree_hal_command_buffer_push_descriptor_set(
       target_command_buffer, cmd->executable_layout, cmd->set,
-      cmd->binding_count, cmd->bindings);
+      cmd->binding_count, bindings);
 }
 
 //===----------------------------------------------------------------------===//
@@ -674,6 +915,25 @@ typedef struct iree_hal_cmd_bind_descriptor_set_t {
   iree_device_size_t dynamic_offsets[];
 } iree_hal_cmd_bind_descriptor_set_t;
 
+// Returns true if |prev_header| is a bind of the same descriptor set and
+// dynamic offsets.
+static bool iree_hal_cmd_bind_descriptor_set_matches(
+    const iree_hal_cmd_header_t* prev_header,
+    iree_hal_descriptor_set_t* descriptor_set,
+    iree_host_size_t dynamic_offset_count,
+    const iree_device_size_t* dynamic_offsets) {
+  if (!prev_header || prev_header->type != IREE_HAL_CMD_BIND_DESCRIPTOR_SET) {
+    return false;
+  }
+  const iree_hal_cmd_bind_descriptor_set_t* prev_cmd =
+      (const iree_hal_cmd_bind_descriptor_set_t*)prev_header;
+  return prev_cmd->descriptor_set == descriptor_set &&
+         prev_cmd->dynamic_offset_count == dynamic_offset_count &&
+         (dynamic_offset_count == 0 ||
+          memcmp(prev_cmd->dynamic_offsets, dynamic_offsets,
+                 sizeof(dynamic_offsets[0]) * dynamic_offset_count) == 0);
+}
+
 static iree_status_t iree_hal_deferred_command_buffer_bind_descriptor_set(
     iree_hal_command_buffer_t* base_command_buffer,
     iree_hal_executable_layout_t* executable_layout, uint32_t set,
@@ -683,6 +943,15 @@ static iree_status_t iree_hal_deferred_command_buffer_bind_descriptor_set(
   iree_hal_deferred_command_buffer_t* command_buffer =
       iree_hal_deferred_command_buffer_cast(base_command_buffer);
   iree_hal_cmd_list_t* cmd_list = &command_buffer->cmd_list;
+  iree_hal_cmd_state_t* cmd_state = &command_buffer->cmd_state;
+  iree_hal_cmd_state_use_layout(cmd_state, executable_layout);
+  if (IREE_HAL_DEFERRED_COMMAND_BUFFER_COMPACTION_ENABLE &&
+      set < IREE_HAL_CMD_STATE_MAX_DESCRIPTOR_SET_COUNT &&
+      iree_hal_cmd_bind_descriptor_set_matches(
+          cmd_state->descriptor_sets[set], descriptor_set, dynamic_offset_count,
+          dynamic_offsets)) {
+    return iree_ok_status();
+  }
   const void* resources[2] = {executable_layout, descriptor_set};
   IREE_RETURN_IF_ERROR(
       iree_hal_resource_set_insert(command_buffer->resource_set, 2, resources));
@@ -697,11 +966,15 @@ static iree_status_t iree_hal_deferred_command_buffer_bind_descriptor_set(
   cmd->dynamic_offset_count = dynamic_offset_count;
   memcpy(cmd->dynamic_offsets, dynamic_offsets,
          sizeof(cmd->dynamic_offsets[0]) * dynamic_offset_count);
+  if (set < IREE_HAL_CMD_STATE_MAX_DESCRIPTOR_SET_COUNT) {
+    cmd_state->descriptor_sets[set] = &cmd->header;
+  }
   return iree_ok_status();
 }
 
 static iree_status_t iree_hal_deferred_command_buffer_apply_bind_descriptor_set(
     iree_hal_command_buffer_t* target_command_buffer,
+    const iree_hal_buffer_binding_table_t* binding_table,
     const iree_hal_cmd_bind_descriptor_set_t* cmd) {
   return iree_hal_command_buffer_bind_descriptor_set(
       target_command_buffer, cmd->executable_layout, cmd->set,
@@ -743,6 +1016,7 @@ static iree_status_t iree_hal_deferred_command_buffer_dispatch(
 
 static iree_status_t iree_hal_deferred_command_buffer_apply_dispatch(
     iree_hal_command_buffer_t* target_command_buffer,
+    const iree_hal_buffer_binding_table_t* binding_table,
     const iree_hal_cmd_dispatch_t* cmd) {
   return iree_hal_command_buffer_dispatch(
       target_command_buffer, cmd->executable, cmd->entry_point,
@@ -784,6 +1058,7 @@ static iree_status_t iree_hal_deferred_command_buffer_dispatch_indirect(
 
 static iree_status_t iree_hal_deferred_command_buffer_apply_dispatch_indirect(
     iree_hal_command_buffer_t* target_command_buffer,
+    const iree_hal_buffer_binding_table_t* binding_table,
     const iree_hal_cmd_dispatch_indirect_t* cmd) {
   return iree_hal_command_buffer_dispatch_indirect(
       target_command_buffer, cmd->executable, cmd->entry_point,
@@ -825,19 +1100,26 @@ static const iree_hal_cmd_apply_fn_t iree_hal_cmd_apply_table[] = {
 
 IREE_API_EXPORT iree_status_t iree_hal_deferred_command_buffer_apply(
     iree_hal_command_buffer_t* base_command_buffer,
-    iree_hal_command_buffer_t* target_command_buffer) {
+    iree_hal_command_buffer_t* target_command_buffer,
+    iree_hal_buffer_binding_table_t binding_table) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
   iree_hal_deferred_command_buffer_t* command_buffer =
       (iree_hal_deferred_command_buffer_t*)iree_hal_command_buffer_dyn_cast(
           base_command_buffer, &iree_hal_deferred_command_buffer_vtable);
   iree_hal_cmd_list_t* cmd_list = &command_buffer->cmd_list;
+  const iree_hal_buffer_binding_table_t* cmd_binding_table =
+      iree_all_bits_set(command_buffer->base.mode,
+                        IREE_HAL_COMMAND_BUFFER_MODE_INDIRECT_BINDINGS)
+          ? &binding_table
+          : NULL;
 
   iree_status_t status = iree_hal_command_buffer_begin(target_command_buffer);
   if (iree_status_is_ok(status)) {
     for (iree_hal_cmd_header_t* cmd = cmd_list->head; cmd != NULL;
          cmd = cmd->next) {
-      status = iree_hal_cmd_apply_table[cmd->type](target_command_buffer, cmd);
+      status = iree_hal_cmd_apply_table[cmd->type](target_command_buffer,
+                                                   cmd_binding_table, cmd);
       if (!iree_status_is_ok(status)) break;
     }
   }
@@ -16,6 +16,14 @@ extern "C" {
 
 typedef struct iree_arena_block_pool_t iree_arena_block_pool_t;
 
+// Compacts commands as they are recorded by coalescing contiguous fills and
+// copies, merging adjacent barriers, and dropping redundant push constants and
+// descriptor set pushes/binds. Disable to replay exactly the recorded commands
+// when debugging or benchmarking the target command buffer.
+#if !defined(IREE_HAL_DEFERRED_COMMAND_BUFFER_COMPACTION_ENABLE)
+#define IREE_HAL_DEFERRED_COMMAND_BUFFER_COMPACTION_ENABLE 1
+#endif  // !IREE_HAL_DEFERRED_COMMAND_BUFFER_COMPACTION_ENABLE
+
 //===----------------------------------------------------------------------===//
 // iree_hal_command_buffer_t deferred record/replay wrapper
 //===----------------------------------------------------------------------===//
@@ -51,9 +59,17 @@ IREE_API_EXPORT iree_status_t iree_hal_deferred_command_buffer_create(
 // Replays a recorded |command_buffer| against a |target_command_buffer|.
 // If the command buffer was recorded in one-shot mode it will be reset upon
 // return.
+//
+// If the command buffer was recorded with
+// IREE_HAL_COMMAND_BUFFER_MODE_INDIRECT_BINDINGS then bindings referencing
+// slots are resolved against |binding_table| and the target command buffer
+// receives direct bindings to the buffers in the table. The target command
+// buffer must not have been created with the mode. |binding_table| is ignored
+// otherwise.
 IREE_API_EXPORT iree_status_t iree_hal_deferred_command_buffer_apply(
     iree_hal_command_buffer_t* command_buffer,
-    iree_hal_command_buffer_t* target_command_buffer);
+    iree_hal_command_buffer_t* target_command_buffer,
+    iree_hal_buffer_binding_table_t binding_table);
 
 #ifdef __cplusplus
 }  // extern "C"
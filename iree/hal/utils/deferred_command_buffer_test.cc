@@ -0,0 +1,320 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/utils/deferred_command_buffer.h"
+
+#include <cstring>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/base/internal/arena.h"
+#include "iree/hal/api.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace iree {
+namespace hal {
+namespace {
+
+enum class CommandType {
+  kBarrier,
+  kFill,
+  kCopy,
+  kPushConstants,
+};
+
+struct Command {
+  CommandType type;
+  iree_device_size_t offset;
+  iree_device_size_t length;
+  iree_host_size_t barrier_count;
+  iree_hal_execution_stage_t stage_mask;
+};
+
+// Target command buffer that captures the commands replayed onto it.
+struct RecordingCommandBuffer {
+  iree_hal_command_buffer_t base;
+  std::vector<Command> commands;
+
+  static RecordingCommandBuffer* Cast(iree_hal_command_buffer_t* base) {
+    return reinterpret_cast<RecordingCommandBuffer*>(base);
+  }
+
+  static void Destroy(iree_hal_command_buffer_t* base) {}
+
+  static iree_status_t Begin(iree_hal_command_buffer_t* base) {
+    Cast(base)->commands.clear();
+    return iree_ok_status();
+  }
+
+  static iree_status_t End(iree_hal_command_buffer_t* base) {
+    return iree_ok_status();
+  }
+
+  static iree_status_t ExecutionBarrier(
+      iree_hal_command_buffer_t* base,
+      iree_hal_execution_stage_t source_stage_mask,
+      iree_hal_execution_stage_t target_stage_mask,
+      iree_hal_execution_barrier_flags_t flags,
+      iree_host_size_t memory_barrier_count,
+      const iree_hal_memory_barrier_t* memory_barriers,
+      iree_host_size_t buffer_barrier_count,
+      const iree_hal_buffer_barrier_t* buffer_barriers) {
+    Cast(base)->commands.push_back({CommandType::kBarrier, 0, 0,
+                                    memory_barrier_count + buffer_barrier_count,
+                                    source_stage_mask | target_stage_mask});
+    return iree_ok_status();
+  }
+
+  static iree_status_t FillBuffer(iree_hal_command_buffer_t* base,
+                                  iree_hal_buffer_t* target_buffer,
+                                  iree_device_size_t target_offset,
+                                  iree_device_size_t length,
+                                  const void* pattern,
+                                  iree_host_size_t pattern_length) {
+    Cast(base)->commands.push_back(
+        {CommandType::kFill, target_offset, length, 0, 0});
+    return iree_ok_status();
+  }
+
+  static iree_status_t CopyBuffer(iree_hal_command_buffer_t* base,
+                                  iree_hal_buffer_t* source_buffer,
+                                  iree_device_size_t source_offset,
+                                  iree_hal_buffer_t* target_buffer,
+                                  iree_device_size_t target_offset,
+                                  iree_device_size_t length) {
+    Cast(base)->commands.push_back(
+        {CommandType::kCopy, target_offset, length, 0, 0});
+    return iree_ok_status();
+  }
+
+  static iree_status_t PushConstants(
+      iree_hal_command_buffer_t* base,
+      iree_hal_executable_layout_t* executable_layout, iree_host_size_t offset,
+      const void* values, iree_host_size_t values_length) {
+    Cast(base)->commands.push_back(
+        {CommandType::kPushConstants, offset, values_length, 0, 0});
+    return iree_ok_status();
+  }
+
+  static const iree_hal_command_buffer_vtable_t* vtable() {
+    static const iree_hal_command_buffer_vtable_t vtable = [] {
+      iree_hal_command_buffer_vtable_t vtable;
+      memset(&vtable, 0, sizeof(vtable));
+      vtable.destroy = Destroy;
+      vtable.begin = Begin;
+      vtable.end = End;
+      vtable.execution_barrier = ExecutionBarrier;
+      vtable.fill_buffer = FillBuffer;
+      vtable.copy_buffer = CopyBuffer;
+      vtable.push_constants = PushConstants;
+      return vtable;
+    }();
+    return &vtable;
+  }
+};
+
+// Minimal executable layout resource; only its identity matters.
+struct FakeExecutableLayout {
+  iree_hal_resource_t resource;
+
+  static void Destroy(iree_hal_executable_layout_t* executable_layout) {}
+
+  FakeExecutableLayout() {
+    static const iree_hal_executable_layout_vtable_t vtable = {Destroy};
+    iree_hal_resource_initialize(&vtable, &resource);
+  }
+
+  iree_hal_executable_layout_t* get() {
+    return reinterpret_cast<iree_hal_executable_layout_t*>(this);
+  }
+};
+
+class DeferredCommandBufferTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    iree_arena_block_pool_initialize(4096, iree_allocator_system(),
+                                     &block_pool_);
+    IREE_ASSERT_OK(iree_hal_allocator_create_heap(
+        iree_make_cstring_view("heap"), iree_allocator_system(),
+        iree_allocator_system(), &device_allocator_));
+    IREE_ASSERT_OK(iree_hal_deferred_command_buffer_create(
+        /*device=*/NULL,
+        IREE_HAL_COMMAND_BUFFER_MODE_REUSABLE |
+            IREE_HAL_COMMAND_BUFFER_MODE_UNVALIDATED,
+        IREE_HAL_COMMAND_CATEGORY_ANY, &block_pool_, iree_allocator_system(),
+        &command_buffer_));
+    iree_hal_command_buffer_initialize(
+        /*device=*/NULL, IREE_HAL_COMMAND_BUFFER_MODE_UNVALIDATED,
+        IREE_HAL_COMMAND_CATEGORY_ANY, IREE_HAL_QUEUE_AFFINITY_ANY,
+        RecordingCommandBuffer::vtable(), &target_.base);
+  }
+
+  void TearDown() override {
+    iree_hal_command_buffer_release(command_buffer_);
+    iree_hal_allocator_release(device_allocator_);
+    iree_arena_block_pool_deinitialize(&block_pool_);
+  }
+
+  iree_hal_buffer_t* AllocateBuffer(iree_device_size_t length) {
+    iree_hal_buffer_t* buffer = NULL;
+    IREE_CHECK_OK(iree_hal_allocator_allocate_buffer(
+        device_allocator_,
+        IREE_HAL_MEMORY_TYPE_HOST_LOCAL | IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE,
+        IREE_HAL_BUFFER_USAGE_ALL, length, iree_const_byte_span_empty(),
+        &buffer));
+    return buffer;
+  }
+
+  const std::vector<Command>& Replay() {
+    IREE_CHECK_OK(iree_hal_deferred_command_buffer_apply(
+        command_buffer_, &target_.base, iree_hal_buffer_binding_table_empty()));
+    return target_.commands;
+  }
+
+  iree_arena_block_pool_t block_pool_;
+  iree_hal_allocator_t* device_allocator_ = NULL;
+  iree_hal_command_buffer_t* command_buffer_ = NULL;
+  RecordingCommandBuffer target_;
+};
+
+#if IREE_HAL_DEFERRED_COMMAND_BUFFER_COMPACTION_ENABLE
+
+TEST_F(DeferredCommandBufferTest, CoalescesContiguousFills) {
+  iree_hal_buffer_t* buffer = AllocateBuffer(128);
+  const uint32_t pattern = 0xCDCDCDCDu;
+  const uint32_t other_pattern = 0xABABABABu;
+  IREE_ASSERT_OK(iree_hal_command_buffer_begin(command_buffer_));
+  IREE_ASSERT_OK(iree_hal_command_buffer_fill_buffer(
+      command_buffer_, buffer, 0, 16, &pattern, sizeof(pattern)));
+  IREE_ASSERT_OK(iree_hal_command_buffer_fill_buffer(
+      command_buffer_, buffer, 16, 16, &pattern, sizeof(pattern)));
+  // Not contiguous with the previous fill.
+  IREE_ASSERT_OK(iree_hal_command_buffer_fill_buffer(
+      command_buffer_, buffer, 48, 16, &pattern, sizeof(pattern)));
+  // Contiguous but with a different pattern.
+  IREE_ASSERT_OK(iree_hal_command_buffer_fill_buffer(
+      command_buffer_, buffer, 64, 16, &other_pattern, sizeof(other_pattern)));
+  IREE_ASSERT_OK(iree_hal_command_buffer_end(command_buffer_));
+
+  const auto& commands = Replay();
+  ASSERT_EQ(commands.size(), 3);
+  EXPECT_EQ(commands[0].offset, 0);
+  EXPECT_EQ(commands[0].length, 32);
+  EXPECT_EQ(commands[1].offset, 48);
+  EXPECT_EQ(commands[1].length, 16);
+  EXPECT_EQ(commands[2].offset, 64);
+  EXPECT_EQ(commands[2].length, 16);
+  iree_hal_buffer_release(buffer);
+}
+
+TEST_F(DeferredCommandBufferTest, CoalescesContiguousCopies) {
+  iree_hal_buffer_t* source_buffer = AllocateBuffer(128);
+  iree_hal_buffer_t* target_buffer = AllocateBuffer(128);
+  IREE_ASSERT_OK(iree_hal_command_buffer_begin(command_buffer_));
+  IREE_ASSERT_OK(iree_hal_command_buffer_copy_buffer(
+      command_buffer_, source_buffer, 0, target_buffer, 32, 16));
+  IREE_ASSERT_OK(iree_hal_command_buffer_copy_buffer(
+      command_buffer_, source_buffer, 16, target_buffer, 48, 16));
+  // Copies within the same buffer may depend on each other.
+  IREE_ASSERT_OK(iree_hal_command_buffer_copy_buffer(
+      command_buffer_, target_buffer, 0, target_buffer, 64, 16));
+  IREE_ASSERT_OK(iree_hal_command_buffer_copy_buffer(
+      command_buffer_, target_buffer, 16, target_buffer, 80, 16));
+  IREE_ASSERT_OK(iree_hal_command_buffer_end(command_buffer_));
+
+  const auto& commands = Replay();
+  ASSERT_EQ(commands.size(), 3);
+  EXPECT_EQ(commands[0].offset, 32);
+  EXPECT_EQ(commands[0].length, 32);
+  EXPECT_EQ(commands[1].offset, 64);
+  EXPECT_EQ(commands[2].offset, 80);
+  iree_hal_buffer_release(target_buffer);
+  iree_hal_buffer_release(source_buffer);
+}
+
+TEST_F(DeferredCommandBufferTest, MergesAdjacentBarriers) {
+  iree_hal_buffer_t* buffer = AllocateBuffer(128);
+  const uint32_t pattern = 0;
+  iree_hal_memory_barrier_t memory_barrier = {
+      IREE_HAL_ACCESS_SCOPE_DISPATCH_WRITE,
+      IREE_HAL_ACCESS_SCOPE_DISPATCH_READ,
+  };
+  IREE_ASSERT_OK(iree_hal_command_buffer_begin(command_buffer_));
+  IREE_ASSERT_OK(iree_hal_command_buffer_execution_barrier(
+      command_buffer_, IREE_HAL_EXECUTION_STAGE_DISPATCH,
+      IREE_HAL_EXECUTION_STAGE_TRANSFER, IREE_HAL_EXECUTION_BARRIER_FLAG_NONE,
+      1, &memory_barrier, 0, NULL));
+  IREE_ASSERT_OK(iree_hal_command_buffer_execution_barrier(
+      command_buffer_, IREE_HAL_EXECUTION_STAGE_TRANSFER,
+      IREE_HAL_EXECUTION_STAGE_DISPATCH, IREE_HAL_EXECUTION_BARRIER_FLAG_NONE,
+      1, &memory_barrier, 0, NULL));
+  IREE_ASSERT_OK(iree_hal_command_buffer_fill_buffer(
+      command_buffer_, buffer, 0, 16, &pattern, sizeof(pattern)));
+  IREE_ASSERT_OK(iree_hal_command_buffer_execution_barrier(
+      command_buffer_, IREE_HAL_EXECUTION_STAGE_TRANSFER,
+      IREE_HAL_EXECUTION_STAGE_TRANSFER, IREE_HAL_EXECUTION_BARRIER_FLAG_NONE,
+      0, NULL, 0, NULL));
+  IREE_ASSERT_OK(iree_hal_command_buffer_end(command_buffer_));
+
+  const auto& commands = Replay();
+  ASSERT_EQ(commands.size(), 3);
+  EXPECT_EQ(commands[0].type, CommandType::kBarrier);
+  EXPECT_EQ(commands[0].barrier_count, 2);
+  EXPECT_EQ(commands[0].stage_mask, IREE_HAL_EXECUTION_STAGE_DISPATCH |
+                                        IREE_HAL_EXECUTION_STAGE_TRANSFER);
+  EXPECT_EQ(commands[1].type, CommandType::kFill);
+  EXPECT_EQ(commands[2].type, CommandType::kBarrier);
+  iree_hal_buffer_release(buffer);
+}
+
+TEST_F(DeferredCommandBufferTest, DropsRedundantPushConstants) {
+  FakeExecutableLayout layout_a;
+  FakeExecutableLayout layout_b;
+  const uint32_t values[2] = {1, 2};
+  const uint32_t other_values[2] = {3, 4};
+  IREE_ASSERT_OK(iree_hal_command_buffer_begin(command_buffer_));
+  IREE_ASSERT_OK(iree_hal_command_buffer_push_constants(
+      command_buffer_, layout_a.get(), 0, values, sizeof(values)));
+  IREE_ASSERT_OK(iree_hal_command_buffer_push_constants(
+      command_buffer_, layout_a.get(), 0, values, sizeof(values)));
+  IREE_ASSERT_OK(iree_hal_command_buffer_push_constants(
+      command_buffer_, layout_a.get(), 0, other_values, sizeof(other_values)));
+  // Switching layouts drops the tracked state.
+  IREE_ASSERT_OK(iree_hal_command_buffer_push_constants(
+      command_buffer_, layout_b.get(), 0, other_values, sizeof(other_values)));
+  IREE_ASSERT_OK(iree_hal_command_buffer_end(command_buffer_));
+
+  const auto& commands = Replay();
+  EXPECT_EQ(commands.size(), 3);
+}
+
+TEST_F(DeferredCommandBufferTest, ReplaysAfterRerecording) {
+  iree_hal_buffer_t* buffer = AllocateBuffer(128);
+  const uint32_t pattern = 0;
+  IREE_ASSERT_OK(iree_hal_command_buffer_begin(command_buffer_));
+  IREE_ASSERT_OK(iree_hal_command_buffer_fill_buffer(
+      command_buffer_, buffer, 0, 16, &pattern, sizeof(pattern)));
+  IREE_ASSERT_OK(iree_hal_command_buffer_end(command_buffer_));
+  EXPECT_EQ(Replay().size(), 1);
+
+  // State from the first recording must not leak into the second.
+  IREE_ASSERT_OK(iree_hal_command_buffer_begin(command_buffer_));
+  IREE_ASSERT_OK(iree_hal_command_buffer_fill_buffer(
+      command_buffer_, buffer, 16, 16, &pattern, sizeof(pattern)));
+  IREE_ASSERT_OK(iree_hal_command_buffer_end(command_buffer_));
+  const auto& commands = Replay();
+  ASSERT_EQ(commands.size(), 1);
+  EXPECT_EQ(commands[0].offset, 16);
+  EXPECT_EQ(commands[0].length, 16);
+  iree_hal_buffer_release(buffer);
+}
+
+#endif  // IREE_HAL_DEFERRED_COMMAND_BUFFER_COMPACTION_ENABLE
+
+}  // namespace
+}  // namespace hal
+}  // namespace iree
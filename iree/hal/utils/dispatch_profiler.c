@@ -0,0 +1,190 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/utils/dispatch_profiler.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "iree/base/tracing.h"
+
+void iree_hal_dispatch_profiler_initialize(
+    iree_allocator_t host_allocator,
+    iree_hal_dispatch_profiler_t* out_profiler) {
+  IREE_ASSERT_ARGUMENT(out_profiler);
+  memset(out_profiler, 0, sizeof(*out_profiler));
+  out_profiler->host_allocator = host_allocator;
+  iree_atomic_store_int32(&out_profiler->active, 0, iree_memory_order_relaxed);
+  iree_slim_mutex_initialize(&out_profiler->flush_mutex);
+  iree_slim_mutex_initialize(&out_profiler->mutex);
+}
+
+void iree_hal_dispatch_profiler_deinitialize(
+    iree_hal_dispatch_profiler_t* profiler) {
+  IREE_ASSERT_ARGUMENT(profiler);
+  iree_allocator_free(profiler->host_allocator, profiler->storage);
+  iree_slim_mutex_deinitialize(&profiler->mutex);
+  iree_slim_mutex_deinitialize(&profiler->flush_mutex);
+  memset(profiler, 0, sizeof(*profiler));
+}
+
+iree_status_t iree_hal_dispatch_profiler_begin(
+    iree_hal_dispatch_profiler_t* profiler,
+    const iree_hal_device_profiling_options_t* options) {
+  IREE_ASSERT_ARGUMENT(profiler);
+  IREE_ASSERT_ARGUMENT(options);
+  if (options->mode & ~IREE_HAL_DEVICE_PROFILING_MODE_DISPATCH_TIMESTAMPS) {
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "unsupported profiling mode 0x%08X",
+                            options->mode);
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_host_size_t capacity = options->dispatch_capacity
+                                  ? options->dispatch_capacity
+                                  : IREE_HAL_DISPATCH_PROFILER_DEFAULT_CAPACITY;
+
+  // Both buffers are allocated up front so that appending never allocates.
+  iree_host_size_t dispatches_size =
+      capacity * sizeof(iree_hal_device_profiling_dispatch_t);
+  iree_host_size_t names_size =
+      capacity * IREE_HAL_DISPATCH_PROFILER_MAX_NAME_LENGTH;
+  uint8_t* storage = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0,
+      iree_allocator_malloc(profiler->host_allocator,
+                            2 * (dispatches_size + names_size),
+                            (void**)&storage));
+
+  // Holding the flush mutex prevents racing with a concurrent end releasing
+  // the storage of the prior profiling session.
+  iree_slim_mutex_lock(&profiler->flush_mutex);
+  iree_slim_mutex_lock(&profiler->mutex);
+  if (iree_hal_dispatch_profiler_is_active(profiler)) {
+    iree_slim_mutex_unlock(&profiler->mutex);
+    iree_slim_mutex_unlock(&profiler->flush_mutex);
+    iree_allocator_free(profiler->host_allocator, storage);
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "device is already profiling");
+  }
+  profiler->options = *options;
+  profiler->capacity = capacity;
+  profiler->count = 0;
+  profiler->dropped_count = 0;
+  profiler->current = 0;
+  profiler->dispatches[0] = (iree_hal_device_profiling_dispatch_t*)storage;
+  profiler->dispatches[1] =
+      (iree_hal_device_profiling_dispatch_t*)(storage + dispatches_size);
+  profiler->names[0] = (char*)(storage + 2 * dispatches_size);
+  profiler->names[1] = (char*)(storage + 2 * dispatches_size + names_size);
+  profiler->storage = storage;
+  iree_atomic_store_int32(&profiler->active, 1, iree_memory_order_relaxed);
+  iree_slim_mutex_unlock(&profiler->mutex);
+  iree_slim_mutex_unlock(&profiler->flush_mutex);
+
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+void iree_hal_dispatch_profiler_append(
+    iree_hal_dispatch_profiler_t* profiler,
+    const iree_hal_device_profiling_dispatch_t* dispatch) {
+  if (!iree_hal_dispatch_profiler_is_active(profiler)) return;
+  iree_slim_mutex_lock(&profiler->mutex);
+  if (!iree_hal_dispatch_profiler_is_active(profiler)) {
+    // Raced with the end of profiling.
+  } else if (profiler->count >= profiler->capacity) {
+    ++profiler->dropped_count;
+  } else {
+    iree_host_size_t index = profiler->count++;
+    iree_hal_device_profiling_dispatch_t* record =
+        &profiler->dispatches[profiler->current][index];
+    *record = *dispatch;
+    char* name = profiler->names[profiler->current] +
+                 index * IREE_HAL_DISPATCH_PROFILER_MAX_NAME_LENGTH;
+    iree_host_size_t name_length =
+        iree_min(dispatch->entry_point_name.size,
+                 IREE_HAL_DISPATCH_PROFILER_MAX_NAME_LENGTH - 1);
+    memcpy(name, dispatch->entry_point_name.data, name_length);
+    name[name_length] = 0;
+    record->entry_point_name = iree_make_string_view(name, name_length);
+  }
+  iree_slim_mutex_unlock(&profiler->mutex);
+}
+
+void iree_hal_dispatch_profiler_append_dropped(
+    iree_hal_dispatch_profiler_t* profiler, iree_host_size_t count) {
+  if (!count || !iree_hal_dispatch_profiler_is_active(profiler)) return;
+  iree_slim_mutex_lock(&profiler->mutex);
+  if (iree_hal_dispatch_profiler_is_active(profiler)) {
+    profiler->dropped_count += count;
+  }
+  iree_slim_mutex_unlock(&profiler->mutex);
+}
+
+// Swaps the buffers and delivers the previously current one to the sink.
+// If |deactivate| is set profiling ends under the same lock so that no
+// dispatches can be appended after the final delivery.
+// Must be called with the flush mutex held.
+static iree_status_t iree_hal_dispatch_profiler_deliver(
+    iree_hal_dispatch_profiler_t* profiler, bool deactivate) {
+  iree_slim_mutex_lock(&profiler->mutex);
+  if (!iree_hal_dispatch_profiler_is_active(profiler)) {
+    iree_slim_mutex_unlock(&profiler->mutex);
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "device is not profiling");
+  }
+  iree_hal_device_profiling_sink_t sink = profiler->options.sink;
+  const iree_hal_device_profiling_dispatch_t* dispatches =
+      profiler->dispatches[profiler->current];
+  iree_host_size_t dispatch_count = profiler->count;
+  iree_host_size_t dropped_count = profiler->dropped_count;
+  profiler->current ^= 1;
+  profiler->count = 0;
+  profiler->dropped_count = 0;
+  if (deactivate) {
+    iree_atomic_store_int32(&profiler->active, 0, iree_memory_order_relaxed);
+  }
+  iree_slim_mutex_unlock(&profiler->mutex);
+
+  if (dispatch_count == 0 && dropped_count == 0) return iree_ok_status();
+  return sink.fn(sink.user_data, dispatch_count, dispatches, dropped_count);
+}
+
+iree_status_t iree_hal_dispatch_profiler_flush(
+    iree_hal_dispatch_profiler_t* profiler) {
+  IREE_ASSERT_ARGUMENT(profiler);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_slim_mutex_lock(&profiler->flush_mutex);
+  iree_status_t status =
+      iree_hal_dispatch_profiler_deliver(profiler, /*deactivate=*/false);
+  iree_slim_mutex_unlock(&profiler->flush_mutex);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+iree_status_t iree_hal_dispatch_profiler_end(
+    iree_hal_dispatch_profiler_t* profiler) {
+  IREE_ASSERT_ARGUMENT(profiler);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_slim_mutex_lock(&profiler->flush_mutex);
+  iree_status_t status =
+      iree_hal_dispatch_profiler_deliver(profiler, /*deactivate=*/true);
+  if (!iree_hal_dispatch_profiler_is_active(profiler)) {
+    // No appends can reference the storage once inactive under the lock.
+    iree_slim_mutex_lock(&profiler->mutex);
+    iree_allocator_free(profiler->host_allocator, profiler->storage);
+    profiler->storage = NULL;
+    memset(profiler->dispatches, 0, sizeof(profiler->dispatches));
+    memset(profiler->names, 0, sizeof(profiler->names));
+    profiler->capacity = 0;
+    iree_slim_mutex_unlock(&profiler->mutex);
+  }
+  iree_slim_mutex_unlock(&profiler->flush_mutex);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
@@ -0,0 +1,111 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_UTILS_DISPATCH_PROFILER_H_
+#define IREE_HAL_UTILS_DISPATCH_PROFILER_H_
+
+#include "iree/base/api.h"
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/hal/device.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Default number of dispatches buffered between flushes when the profiling
+// options do not specify a capacity.
+#define IREE_HAL_DISPATCH_PROFILER_DEFAULT_CAPACITY 4096
+
+// Maximum length of an entry point name retained per dispatch, including the
+// NUL terminator. Longer names are truncated.
+#define IREE_HAL_DISPATCH_PROFILER_MAX_NAME_LENGTH 64
+
+//===----------------------------------------------------------------------===//
+// iree_hal_dispatch_profiler_t
+//===----------------------------------------------------------------------===//
+
+// Fixed-capacity double-buffered store of profiled dispatches that implements
+// the iree_hal_device_profiling_* API for devices that can produce dispatch
+// timestamps on the host.
+//
+// Appending is thread-safe and cheap enough to perform from the threads
+// executing work: when inactive it is a single relaxed atomic load and when
+// active it is a short critical section copying the record. Flushing swaps the
+// buffers and delivers the captured records to the sink outside of the lock
+// such that appends can continue while the sink processes the results.
+typedef struct iree_hal_dispatch_profiler_t {
+  iree_allocator_t host_allocator;
+
+  // Nonzero while profiling. Checked without the lock to skip all work when
+  // profiling is disabled and re-checked under the lock when appending.
+  iree_atomic_int32_t active;
+
+  // Serializes flushes such that a buffer is not reused while being delivered.
+  iree_slim_mutex_t flush_mutex;
+
+  // Guards the fields below.
+  iree_slim_mutex_t mutex;
+  iree_hal_device_profiling_options_t options;
+  iree_host_size_t capacity;
+  iree_host_size_t count;
+  iree_host_size_t dropped_count;
+  // Index into |dispatches| and |names| of the buffer being appended to.
+  iree_host_size_t current;
+  iree_hal_device_profiling_dispatch_t* dispatches[2];
+  char* names[2];
+  // Storage for the buffers above; allocated when profiling begins.
+  void* storage;
+} iree_hal_dispatch_profiler_t;
+
+// Initializes |out_profiler| in the inactive state.
+void iree_hal_dispatch_profiler_initialize(
+    iree_allocator_t host_allocator,
+    iree_hal_dispatch_profiler_t* out_profiler);
+
+// Deinitializes |profiler|, discarding any captured dispatches.
+void iree_hal_dispatch_profiler_deinitialize(
+    iree_hal_dispatch_profiler_t* profiler);
+
+// Begins profiling as with iree_hal_device_profiling_begin.
+iree_status_t iree_hal_dispatch_profiler_begin(
+    iree_hal_dispatch_profiler_t* profiler,
+    const iree_hal_device_profiling_options_t* options);
+
+// Delivers all captured dispatches as with iree_hal_device_profiling_flush.
+iree_status_t iree_hal_dispatch_profiler_flush(
+    iree_hal_dispatch_profiler_t* profiler);
+
+// Ends profiling as with iree_hal_device_profiling_end.
+iree_status_t iree_hal_dispatch_profiler_end(
+    iree_hal_dispatch_profiler_t* profiler);
+
+// Returns true if |profiler| is capturing dispatches. Callers can use this to
+// avoid the work of building records that would be discarded but must still
+// tolerate iree_hal_dispatch_profiler_append dropping them.
+static inline bool iree_hal_dispatch_profiler_is_active(
+    iree_hal_dispatch_profiler_t* profiler) {
+  return iree_atomic_load_int32(&profiler->active,
+                                iree_memory_order_relaxed) != 0;
+}
+
+// Appends a completed |dispatch| to the profile. The entry point name is
+// copied and need only remain valid for the duration of the call. Dispatches
+// appended while inactive or when the buffer is full are dropped.
+void iree_hal_dispatch_profiler_append(
+    iree_hal_dispatch_profiler_t* profiler,
+    const iree_hal_device_profiling_dispatch_t* dispatch);
+
+// Records |count| dispatches that completed while profiling but could not be
+// captured by the device. They are reported as dropped by the next flush.
+void iree_hal_dispatch_profiler_append_dropped(
+    iree_hal_dispatch_profiler_t* profiler, iree_host_size_t count);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_UTILS_DISPATCH_PROFILER_H_
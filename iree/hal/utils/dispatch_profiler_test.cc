@@ -0,0 +1,168 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/utils/dispatch_profiler.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace iree {
+namespace hal {
+namespace {
+
+using ::iree::testing::status::StatusIs;
+
+struct CapturedDispatch {
+  std::string name;
+  uint32_t entry_point;
+  iree_time_t duration_ns;
+};
+
+struct DispatchProfilerTest : public ::testing::Test {
+  iree_hal_dispatch_profiler_t profiler;
+  std::vector<CapturedDispatch> captured;
+  iree_host_size_t dropped_count = 0;
+  iree_host_size_t flush_count = 0;
+
+  void SetUp() override {
+    iree_hal_dispatch_profiler_initialize(iree_allocator_system(), &profiler);
+  }
+
+  void TearDown() override {
+    iree_hal_dispatch_profiler_deinitialize(&profiler);
+  }
+
+  static iree_status_t Sink(
+      void* user_data, iree_host_size_t dispatch_count,
+      const iree_hal_device_profiling_dispatch_t* dispatches,
+      iree_host_size_t dropped_count) {
+    auto* test = reinterpret_cast<DispatchProfilerTest*>(user_data);
+    ++test->flush_count;
+    for (iree_host_size_t i = 0; i < dispatch_count; ++i) {
+      test->captured.push_back({
+          std::string(dispatches[i].entry_point_name.data,
+                      dispatches[i].entry_point_name.size),
+          dispatches[i].entry_point,
+          dispatches[i].end_time_ns - dispatches[i].begin_time_ns,
+      });
+    }
+    test->dropped_count += dropped_count;
+    return iree_ok_status();
+  }
+
+  iree_hal_device_profiling_options_t MakeOptions(iree_host_size_t capacity) {
+    iree_hal_device_profiling_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.mode = IREE_HAL_DEVICE_PROFILING_MODE_DISPATCH_TIMESTAMPS;
+    options.dispatch_capacity = capacity;
+    options.sink.fn = Sink;
+    options.sink.user_data = this;
+    return options;
+  }
+
+  void Append(const char* name, uint32_t entry_point, iree_time_t begin,
+              iree_time_t end) {
+    iree_hal_device_profiling_dispatch_t dispatch;
+    memset(&dispatch, 0, sizeof(dispatch));
+    dispatch.entry_point_name = iree_make_cstring_view(name);
+    dispatch.entry_point = entry_point;
+    dispatch.begin_time_ns = begin;
+    dispatch.end_time_ns = end;
+    iree_hal_dispatch_profiler_append(&profiler, &dispatch);
+  }
+};
+
+TEST_F(DispatchProfilerTest, InactiveDropsSilently) {
+  EXPECT_FALSE(iree_hal_dispatch_profiler_is_active(&profiler));
+  Append("ignored", 0, 0, 1);
+  EXPECT_THAT(Status(iree_hal_dispatch_profiler_flush(&profiler)),
+              StatusIs(StatusCode::kFailedPrecondition));
+  EXPECT_TRUE(captured.empty());
+}
+
+TEST_F(DispatchProfilerTest, FlushDeliversInOrder) {
+  auto options = MakeOptions(8);
+  IREE_ASSERT_OK(iree_hal_dispatch_profiler_begin(&profiler, &options));
+  EXPECT_TRUE(iree_hal_dispatch_profiler_is_active(&profiler));
+  Append("a", 0, 10, 15);
+  Append("b", 1, 20, 40);
+  IREE_ASSERT_OK(iree_hal_dispatch_profiler_flush(&profiler));
+  ASSERT_EQ(captured.size(), 2);
+  EXPECT_EQ(captured[0].name, "a");
+  EXPECT_EQ(captured[0].duration_ns, 5);
+  EXPECT_EQ(captured[1].name, "b");
+  EXPECT_EQ(captured[1].entry_point, 1);
+  EXPECT_EQ(captured[1].duration_ns, 20);
+
+  // Dispatches appended after a flush land in the other buffer.
+  Append("c", 2, 50, 51);
+  IREE_ASSERT_OK(iree_hal_dispatch_profiler_end(&profiler));
+  ASSERT_EQ(captured.size(), 3);
+  EXPECT_EQ(captured[2].name, "c");
+  EXPECT_FALSE(iree_hal_dispatch_profiler_is_active(&profiler));
+}
+
+TEST_F(DispatchProfilerTest, FullBufferCountsDropped) {
+  auto options = MakeOptions(2);
+  IREE_ASSERT_OK(iree_hal_dispatch_profiler_begin(&profiler, &options));
+  Append("a", 0, 0, 1);
+  Append("b", 0, 0, 1);
+  Append("c", 0, 0, 1);
+  Append("d", 0, 0, 1);
+  IREE_ASSERT_OK(iree_hal_dispatch_profiler_end(&profiler));
+  EXPECT_EQ(captured.size(), 2);
+  EXPECT_EQ(dropped_count, 2);
+}
+
+TEST_F(DispatchProfilerTest, AppendDroppedReportedOnFlush) {
+  auto options = MakeOptions(4);
+  IREE_ASSERT_OK(iree_hal_dispatch_profiler_begin(&profiler, &options));
+  Append("a", 0, 0, 1);
+  iree_hal_dispatch_profiler_append_dropped(&profiler, 3);
+  IREE_ASSERT_OK(iree_hal_dispatch_profiler_flush(&profiler));
+  EXPECT_EQ(captured.size(), 1);
+  EXPECT_EQ(dropped_count, 3);
+  IREE_ASSERT_OK(iree_hal_dispatch_profiler_end(&profiler));
+}
+
+TEST_F(DispatchProfilerTest, LongNamesTruncated) {
+  auto options = MakeOptions(1);
+  IREE_ASSERT_OK(iree_hal_dispatch_profiler_begin(&profiler, &options));
+  std::string name(IREE_HAL_DISPATCH_PROFILER_MAX_NAME_LENGTH * 2, 'x');
+  Append(name.c_str(), 0, 0, 1);
+  IREE_ASSERT_OK(iree_hal_dispatch_profiler_end(&profiler));
+  ASSERT_EQ(captured.size(), 1);
+  EXPECT_EQ(captured[0].name.size(),
+            IREE_HAL_DISPATCH_PROFILER_MAX_NAME_LENGTH - 1);
+}
+
+TEST_F(DispatchProfilerTest, BeginTwiceFails) {
+  auto options = MakeOptions(1);
+  IREE_ASSERT_OK(iree_hal_dispatch_profiler_begin(&profiler, &options));
+  EXPECT_THAT(Status(iree_hal_dispatch_profiler_begin(&profiler, &options)),
+              StatusIs(StatusCode::kFailedPrecondition));
+  IREE_ASSERT_OK(iree_hal_dispatch_profiler_end(&profiler));
+  // Profiling can be restarted once ended.
+  IREE_ASSERT_OK(iree_hal_dispatch_profiler_begin(&profiler, &options));
+  IREE_ASSERT_OK(iree_hal_dispatch_profiler_end(&profiler));
+}
+
+TEST_F(DispatchProfilerTest, EmptyFlushSkipsSink) {
+  auto options = MakeOptions(1);
+  IREE_ASSERT_OK(iree_hal_dispatch_profiler_begin(&profiler, &options));
+  IREE_ASSERT_OK(iree_hal_dispatch_profiler_flush(&profiler));
+  IREE_ASSERT_OK(iree_hal_dispatch_profiler_end(&profiler));
+  EXPECT_EQ(flush_count, 0);
+}
+
+}  // namespace
+}  // namespace hal
+}  // namespace iree
@@ -0,0 +1,462 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/utils/executable_registry.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/tracing.h"
+
+// Object type prefixed to all keys so that keys of different types never
+// compare equal.
+typedef enum iree_hal_executable_registry_key_type_e {
+  IREE_HAL_EXECUTABLE_REGISTRY_KEY_TYPE_DESCRIPTOR_SET_LAYOUT = 0,
+  IREE_HAL_EXECUTABLE_REGISTRY_KEY_TYPE_EXECUTABLE_LAYOUT,
+  IREE_HAL_EXECUTABLE_REGISTRY_KEY_TYPE_EXECUTABLE,
+} iree_hal_executable_registry_key_type_t;
+
+typedef struct iree_hal_executable_registry_entry_t {
+  struct iree_hal_executable_registry_entry_t* next;
+  // Device the object was created on. Retained so that the pointer cannot be
+  // reused by another device while the entry exists.
+  iree_hal_device_t* device;
+  // Registered object; the registry holds one reference.
+  iree_hal_resource_t* resource;
+  iree_host_size_t key_length;
+  uint8_t key[];
+} iree_hal_executable_registry_entry_t;
+
+struct iree_hal_executable_registry_t {
+  iree_atomic_ref_count_t ref_count;
+  iree_allocator_t host_allocator;
+
+  // Guards the entry list.
+  iree_slim_mutex_t mutex;
+  // Most recently inserted first.
+  iree_hal_executable_registry_entry_t* entry_head;
+};
+
+IREE_API_EXPORT iree_status_t iree_hal_executable_registry_create(
+    iree_allocator_t host_allocator,
+    iree_hal_executable_registry_t** out_registry) {
+  IREE_ASSERT_ARGUMENT(out_registry);
+  *out_registry = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_executable_registry_t* registry = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, sizeof(*registry),
+                                (void**)&registry));
+  memset(registry, 0, sizeof(*registry));
+  iree_atomic_ref_count_init(&registry->ref_count);
+  registry->host_allocator = host_allocator;
+  iree_slim_mutex_initialize(&registry->mutex);
+
+  *out_registry = registry;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+static void iree_hal_executable_registry_entry_free(
+    iree_hal_executable_registry_t* registry,
+    iree_hal_executable_registry_entry_t* entry) {
+  iree_hal_resource_release(entry->resource);
+  iree_hal_device_release(entry->device);
+  iree_allocator_free(registry->host_allocator, entry);
+}
+
+static void iree_hal_executable_registry_destroy(
+    iree_hal_executable_registry_t* registry) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Entries were inserted after the entries they reference (executables after
+  // their layouts) so releasing from the head releases dependents first.
+  iree_hal_executable_registry_entry_t* entry = registry->entry_head;
+  while (entry) {
+    iree_hal_executable_registry_entry_t* next = entry->next;
+    iree_hal_executable_registry_entry_free(registry, entry);
+    entry = next;
+  }
+  iree_slim_mutex_deinitialize(&registry->mutex);
+  iree_allocator_free(registry->host_allocator, registry);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+IREE_API_EXPORT void iree_hal_executable_registry_retain(
+    iree_hal_executable_registry_t* registry) {
+  if (IREE_LIKELY(registry)) {
+    iree_atomic_ref_count_inc(&registry->ref_count);
+  }
+}
+
+IREE_API_EXPORT void iree_hal_executable_registry_release(
+    iree_hal_executable_registry_t* registry) {
+  if (IREE_LIKELY(registry) &&
+      iree_atomic_ref_count_dec(&registry->ref_count) == 1) {
+    iree_hal_executable_registry_destroy(registry);
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// Keys and entries
+//===----------------------------------------------------------------------===//
+
+// Serializes keys in two passes: the first with a NULL |data| to compute the
+// length and the second to write the key into storage of that length.
+typedef struct iree_hal_executable_registry_key_writer_t {
+  uint8_t* data;
+  iree_host_size_t length;
+} iree_hal_executable_registry_key_writer_t;
+
+static void iree_hal_executable_registry_key_append(
+    iree_hal_executable_registry_key_writer_t* writer, const void* value,
+    iree_host_size_t value_length) {
+  if (writer->data) memcpy(writer->data + writer->length, value, value_length);
+  writer->length += value_length;
+}
+
+static void iree_hal_executable_registry_key_append_u64(
+    iree_hal_executable_registry_key_writer_t* writer, uint64_t value) {
+  iree_hal_executable_registry_key_append(writer, &value, sizeof(value));
+}
+
+static void iree_hal_executable_registry_key_append_ptr(
+    iree_hal_executable_registry_key_writer_t* writer, const void* value) {
+  iree_hal_executable_registry_key_append(writer, &value, sizeof(value));
+}
+
+// 64-bit FNV-1a; tolerable for the sizes of executables loaded at startup.
+static uint64_t iree_hal_executable_registry_hash(iree_const_byte_span_t data) {
+  uint64_t hash = 0xCBF29CE484222325ull;
+  for (iree_host_size_t i = 0; i < data.data_length; ++i) {
+    hash ^= data.data[i];
+    hash *= 0x100000001B3ull;
+  }
+  return hash;
+}
+
+// Produces the key for an object into |writer|.
+typedef void(IREE_API_PTR* iree_hal_executable_registry_key_fn_t)(
+    const void* params, iree_hal_executable_registry_key_writer_t* writer);
+
+// Creates the object when no registered object matches the key.
+typedef iree_status_t(IREE_API_PTR* iree_hal_executable_registry_create_fn_t)(
+    const void* params, iree_hal_device_t* device,
+    iree_hal_resource_t** out_resource);
+
+// Returns the entry matching |device| and |key| or NULL if not found.
+// Must be called with the registry mutex held.
+static iree_hal_executable_registry_entry_t*
+iree_hal_executable_registry_find_locked(
+    iree_hal_executable_registry_t* registry, iree_hal_device_t* device,
+    const iree_hal_executable_registry_entry_t* key_entry) {
+  for (iree_hal_executable_registry_entry_t* entry = registry->entry_head;
+       entry != NULL; entry = entry->next) {
+    if (entry->device == device &&
+        entry->key_length == key_entry->key_length &&
+        memcmp(entry->key, key_entry->key, entry->key_length) == 0) {
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+// Returns a retained object matching the key produced by |key_fn| for
+// |params|, creating and registering it with |create_fn| on a miss.
+static iree_status_t iree_hal_executable_registry_acquire(
+    iree_hal_executable_registry_t* registry, iree_hal_device_t* device,
+    iree_hal_executable_registry_key_fn_t key_fn,
+    iree_hal_executable_registry_create_fn_t create_fn, const void* params,
+    iree_hal_resource_t** out_resource) {
+  *out_resource = NULL;
+
+  // Form the key directly into a new entry; it's discarded on a hit.
+  iree_hal_executable_registry_key_writer_t writer = {NULL, 0};
+  key_fn(params, &writer);
+  iree_hal_executable_registry_entry_t* new_entry = NULL;
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+      registry->host_allocator, sizeof(*new_entry) + writer.length,
+      (void**)&new_entry));
+  memset(new_entry, 0, sizeof(*new_entry));
+  new_entry->key_length = writer.length;
+  writer.data = new_entry->key;
+  writer.length = 0;
+  key_fn(params, &writer);
+
+  iree_slim_mutex_lock(&registry->mutex);
+  iree_hal_executable_registry_entry_t* entry =
+      iree_hal_executable_registry_find_locked(registry, device, new_entry);
+  if (entry) iree_hal_resource_retain(entry->resource);
+  iree_slim_mutex_unlock(&registry->mutex);
+  if (entry) {
+    iree_allocator_free(registry->host_allocator, new_entry);
+    *out_resource = entry->resource;
+    return iree_ok_status();
+  }
+
+  // Create outside of the lock as preparing executables may take some time.
+  iree_hal_resource_t* resource = NULL;
+  iree_status_t status = create_fn(params, device, &resource);
+  if (!iree_status_is_ok(status)) {
+    iree_allocator_free(registry->host_allocator, new_entry);
+    return status;
+  }
+
+  iree_slim_mutex_lock(&registry->mutex);
+  entry = iree_hal_executable_registry_find_locked(registry, device, new_entry);
+  if (entry) {
+    // Lost a race with another thread creating the same object; use theirs.
+    iree_hal_resource_retain(entry->resource);
+  } else {
+    new_entry->device = device;
+    iree_hal_device_retain(device);
+    new_entry->resource = resource;
+    iree_hal_resource_retain(resource);
+    new_entry->next = registry->entry_head;
+    registry->entry_head = new_entry;
+  }
+  iree_slim_mutex_unlock(&registry->mutex);
+  if (entry) {
+    iree_hal_resource_release(resource);
+    iree_allocator_free(registry->host_allocator, new_entry);
+    resource = entry->resource;
+  }
+
+  *out_resource = resource;
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT void iree_hal_executable_registry_trim(
+    iree_hal_executable_registry_t* registry) {
+  IREE_ASSERT_ARGUMENT(registry);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // New references to registered objects are only handed out under the lock
+  // and an object only referenced by the registry can be released. Objects
+  // referenced only by other entries (layouts of released executables) become
+  // releasable as their dependents are released so iterate until stable.
+  iree_slim_mutex_lock(&registry->mutex);
+  bool any_released = false;
+  do {
+    any_released = false;
+    iree_hal_executable_registry_entry_t** entry_ptr = &registry->entry_head;
+    while (*entry_ptr) {
+      iree_hal_executable_registry_entry_t* entry = *entry_ptr;
+      if (iree_atomic_load_int32(&entry->resource->ref_count,
+                                 iree_memory_order_acquire) == 1) {
+        *entry_ptr = entry->next;
+        iree_hal_executable_registry_entry_free(registry, entry);
+        any_released = true;
+      } else {
+        entry_ptr = &entry->next;
+      }
+    }
+  } while (any_released);
+  iree_slim_mutex_unlock(&registry->mutex);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+//===----------------------------------------------------------------------===//
+// iree_hal_descriptor_set_layout_t
+//===----------------------------------------------------------------------===//
+
+typedef struct iree_hal_executable_registry_descriptor_set_layout_params_t {
+  iree_hal_descriptor_set_layout_usage_type_t usage_type;
+  iree_host_size_t binding_count;
+  const iree_hal_descriptor_set_layout_binding_t* bindings;
+} iree_hal_executable_registry_descriptor_set_layout_params_t;
+
+static void iree_hal_executable_registry_descriptor_set_layout_key(
+    const void* params_ptr, iree_hal_executable_registry_key_writer_t* writer) {
+  const iree_hal_executable_registry_descriptor_set_layout_params_t* params =
+      (const iree_hal_executable_registry_descriptor_set_layout_params_t*)
+          params_ptr;
+  iree_hal_executable_registry_key_append_u64(
+      writer, IREE_HAL_EXECUTABLE_REGISTRY_KEY_TYPE_DESCRIPTOR_SET_LAYOUT);
+  iree_hal_executable_registry_key_append_u64(writer, params->usage_type);
+  iree_hal_executable_registry_key_append_u64(writer, params->binding_count);
+  for (iree_host_size_t i = 0; i < params->binding_count; ++i) {
+    // Fields are appended individually to avoid comparing struct padding.
+    iree_hal_executable_registry_key_append_u64(writer,
+                                                params->bindings[i].binding);
+    iree_hal_executable_registry_key_append_u64(writer,
+                                                params->bindings[i].type);
+  }
+}
+
+static iree_status_t iree_hal_executable_registry_make_descriptor_set_layout(
+    const void* params_ptr, iree_hal_device_t* device,
+    iree_hal_resource_t** out_resource) {
+  const iree_hal_executable_registry_descriptor_set_layout_params_t* params =
+      (const iree_hal_executable_registry_descriptor_set_layout_params_t*)
+          params_ptr;
+  return iree_hal_descriptor_set_layout_create(
+      device, params->usage_type, params->binding_count, params->bindings,
+      (iree_hal_descriptor_set_layout_t**)out_resource);
+}
+
+IREE_API_EXPORT iree_status_t
+iree_hal_executable_registry_descriptor_set_layout_create(
+    iree_hal_executable_registry_t* registry, iree_hal_device_t* device,
+    iree_hal_descriptor_set_layout_usage_type_t usage_type,
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_layout_binding_t* bindings,
+    iree_hal_descriptor_set_layout_t** out_descriptor_set_layout) {
+  IREE_ASSERT_ARGUMENT(registry);
+  IREE_ASSERT_ARGUMENT(device);
+  IREE_ASSERT_ARGUMENT(!binding_count || bindings);
+  IREE_ASSERT_ARGUMENT(out_descriptor_set_layout);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_hal_executable_registry_descriptor_set_layout_params_t params = {
+      .usage_type = usage_type,
+      .binding_count = binding_count,
+      .bindings = bindings,
+  };
+  iree_status_t status = iree_hal_executable_registry_acquire(
+      registry, device, iree_hal_executable_registry_descriptor_set_layout_key,
+      iree_hal_executable_registry_make_descriptor_set_layout, &params,
+      (iree_hal_resource_t**)out_descriptor_set_layout);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+//===----------------------------------------------------------------------===//
+// iree_hal_executable_layout_t
+//===----------------------------------------------------------------------===//
+
+typedef struct iree_hal_executable_registry_executable_layout_params_t {
+  iree_host_size_t push_constants;
+  iree_host_size_t set_layout_count;
+  iree_hal_descriptor_set_layout_t** set_layouts;
+} iree_hal_executable_registry_executable_layout_params_t;
+
+static void iree_hal_executable_registry_executable_layout_key(
+    const void* params_ptr, iree_hal_executable_registry_key_writer_t* writer) {
+  const iree_hal_executable_registry_executable_layout_params_t* params =
+      (const iree_hal_executable_registry_executable_layout_params_t*)
+          params_ptr;
+  iree_hal_executable_registry_key_append_u64(
+      writer, IREE_HAL_EXECUTABLE_REGISTRY_KEY_TYPE_EXECUTABLE_LAYOUT);
+  iree_hal_executable_registry_key_append_u64(writer, params->push_constants);
+  iree_hal_executable_registry_key_append_u64(writer,
+                                              params->set_layout_count);
+  for (iree_host_size_t i = 0; i < params->set_layout_count; ++i) {
+    iree_hal_executable_registry_key_append_ptr(writer,
+                                                params->set_layouts[i]);
+  }
+}
+
+static iree_status_t iree_hal_executable_registry_make_executable_layout(
+    const void* params_ptr, iree_hal_device_t* device,
+    iree_hal_resource_t** out_resource) {
+  const iree_hal_executable_registry_executable_layout_params_t* params =
+      (const iree_hal_executable_registry_executable_layout_params_t*)
+          params_ptr;
+  return iree_hal_executable_layout_create(
+      device, params->push_constants, params->set_layout_count,
+      params->set_layouts, (iree_hal_executable_layout_t**)out_resource);
+}
+
+IREE_API_EXPORT iree_status_t
+iree_hal_executable_registry_executable_layout_create(
+    iree_hal_executable_registry_t* registry, iree_hal_device_t* device,
+    iree_host_size_t push_constants, iree_host_size_t set_layout_count,
+    iree_hal_descriptor_set_layout_t** set_layouts,
+    iree_hal_executable_layout_t** out_executable_layout) {
+  IREE_ASSERT_ARGUMENT(registry);
+  IREE_ASSERT_ARGUMENT(device);
+  IREE_ASSERT_ARGUMENT(!set_layout_count || set_layouts);
+  IREE_ASSERT_ARGUMENT(out_executable_layout);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_hal_executable_registry_executable_layout_params_t params = {
+      .push_constants = push_constants,
+      .set_layout_count = set_layout_count,
+      .set_layouts = set_layouts,
+  };
+  iree_status_t status = iree_hal_executable_registry_acquire(
+      registry, device, iree_hal_executable_registry_executable_layout_key,
+      iree_hal_executable_registry_make_executable_layout, &params,
+      (iree_hal_resource_t**)out_executable_layout);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+//===----------------------------------------------------------------------===//
+// iree_hal_executable_t
+//===----------------------------------------------------------------------===//
+
+typedef struct iree_hal_executable_registry_executable_params_t {
+  iree_hal_executable_cache_t* executable_cache;
+  iree_hal_executable_spec_t spec;
+  // Hash of the executable data; computed once as keys are formed twice.
+  uint64_t data_hash;
+} iree_hal_executable_registry_executable_params_t;
+
+static void iree_hal_executable_registry_executable_key(
+    const void* params_ptr, iree_hal_executable_registry_key_writer_t* writer) {
+  const iree_hal_executable_registry_executable_params_t* params =
+      (const iree_hal_executable_registry_executable_params_t*)params_ptr;
+  const iree_hal_executable_spec_t* spec = &params->spec;
+  iree_hal_executable_registry_key_append_u64(
+      writer, IREE_HAL_EXECUTABLE_REGISTRY_KEY_TYPE_EXECUTABLE);
+  iree_hal_executable_registry_key_append_u64(writer, spec->caching_mode);
+  iree_hal_executable_registry_key_append_u64(writer,
+                                              spec->executable_format.size);
+  iree_hal_executable_registry_key_append(writer, spec->executable_format.data,
+                                          spec->executable_format.size);
+  iree_hal_executable_registry_key_append_u64(
+      writer, spec->executable_data.data_length);
+  iree_hal_executable_registry_key_append_u64(writer, params->data_hash);
+  iree_hal_executable_registry_key_append_u64(writer,
+                                              spec->executable_layout_count);
+  for (iree_host_size_t i = 0; i < spec->executable_layout_count; ++i) {
+    iree_hal_executable_registry_key_append_ptr(writer,
+                                                spec->executable_layouts[i]);
+  }
+}
+
+static iree_status_t iree_hal_executable_registry_make_executable(
+    const void* params_ptr, iree_hal_device_t* device,
+    iree_hal_resource_t** out_resource) {
+  const iree_hal_executable_registry_executable_params_t* params =
+      (const iree_hal_executable_registry_executable_params_t*)params_ptr;
+  return iree_hal_executable_cache_prepare_executable(
+      params->executable_cache, &params->spec,
+      (iree_hal_executable_t**)out_resource);
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_executable_registry_prepare_executable(
+    iree_hal_executable_registry_t* registry, iree_hal_device_t* device,
+    iree_hal_executable_cache_t* executable_cache,
+    const iree_hal_executable_spec_t* executable_spec,
+    iree_hal_executable_t** out_executable) {
+  IREE_ASSERT_ARGUMENT(registry);
+  IREE_ASSERT_ARGUMENT(device);
+  IREE_ASSERT_ARGUMENT(executable_cache);
+  IREE_ASSERT_ARGUMENT(executable_spec);
+  IREE_ASSERT_ARGUMENT(out_executable);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_hal_executable_registry_executable_params_t params = {
+      .executable_cache = executable_cache,
+      .spec = *executable_spec,
+      .data_hash =
+          iree_hal_executable_registry_hash(executable_spec->executable_data),
+  };
+  // Registered executables may outlive the user that provided the data.
+  params.spec.caching_mode &=
+      ~IREE_HAL_EXECUTABLE_CACHING_MODE_ALIAS_PROVIDED_DATA;
+  iree_status_t status = iree_hal_executable_registry_acquire(
+      registry, device, iree_hal_executable_registry_executable_key,
+      iree_hal_executable_registry_make_executable, &params,
+      (iree_hal_resource_t**)out_executable);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
@@ -0,0 +1,106 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_UTILS_EXECUTABLE_REGISTRY_H_
+#define IREE_HAL_UTILS_EXECUTABLE_REGISTRY_H_
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+//===----------------------------------------------------------------------===//
+// iree_hal_executable_registry_t
+//===----------------------------------------------------------------------===//
+
+// A refcounted registry of executables shared by all users on a device.
+//
+// Each VM context using the HAL module prepares its own copy of every
+// executable it references through its executable cache. When many contexts
+// load the same program (such as one session per tenant) this duplicates the
+// executable code, the driver objects, and the layouts they reference. The
+// registry deduplicates these by content so that all users preparing the same
+// executable on the same device receive the same iree_hal_executable_t.
+//
+// Executables always retain the layouts they were prepared with and so the
+// registry also deduplicates descriptor set layouts and executable layouts.
+// Users must create layouts through the registry for executables to be shared.
+//
+// Keys:
+//  descriptor set layouts: device, usage type, and bindings
+//  executable layouts: device, push constant count, and set layouts
+//  executables: device, caching mode, format, a 64-bit hash and length of the
+//               executable data, and executable layouts
+//
+// Entries retain their objects until no references outside of the registry
+// remain and iree_hal_executable_registry_trim is called. Hosting layers
+// should trim when users go away (such as when a VM context is freed).
+//
+// Executables prepared through the registry may outlive the data they were
+// prepared from and IREE_HAL_EXECUTABLE_CACHING_MODE_ALIAS_PROVIDED_DATA is
+// always removed from the spec when preparing them.
+//
+// Thread-safe: the registry may be used by multiple threads and devices
+// concurrently. Concurrent misses on the same key may prepare the object more
+// than once; all but the first inserted are discarded.
+typedef struct iree_hal_executable_registry_t iree_hal_executable_registry_t;
+
+// Creates an empty executable registry.
+IREE_API_EXPORT iree_status_t iree_hal_executable_registry_create(
+    iree_allocator_t host_allocator,
+    iree_hal_executable_registry_t** out_registry);
+
+// Retains the given |registry| for the caller.
+IREE_API_EXPORT void iree_hal_executable_registry_retain(
+    iree_hal_executable_registry_t* registry);
+
+// Releases the given |registry| from the caller.
+IREE_API_EXPORT void iree_hal_executable_registry_release(
+    iree_hal_executable_registry_t* registry);
+
+// Returns a descriptor set layout matching the given parameters, creating it
+// on |device| if no matching layout has been registered.
+// See iree_hal_descriptor_set_layout_create.
+IREE_API_EXPORT iree_status_t
+iree_hal_executable_registry_descriptor_set_layout_create(
+    iree_hal_executable_registry_t* registry, iree_hal_device_t* device,
+    iree_hal_descriptor_set_layout_usage_type_t usage_type,
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_layout_binding_t* bindings,
+    iree_hal_descriptor_set_layout_t** out_descriptor_set_layout);
+
+// Returns an executable layout matching the given parameters, creating it on
+// |device| if no matching layout has been registered.
+// See iree_hal_executable_layout_create.
+IREE_API_EXPORT iree_status_t
+iree_hal_executable_registry_executable_layout_create(
+    iree_hal_executable_registry_t* registry, iree_hal_device_t* device,
+    iree_host_size_t push_constants, iree_host_size_t set_layout_count,
+    iree_hal_descriptor_set_layout_t** set_layouts,
+    iree_hal_executable_layout_t** out_executable_layout);
+
+// Returns an executable matching |executable_spec|, preparing it with
+// |executable_cache| if no matching executable has been registered for
+// |device|. |executable_cache| must have been created on |device|.
+// See iree_hal_executable_cache_prepare_executable.
+IREE_API_EXPORT iree_status_t iree_hal_executable_registry_prepare_executable(
+    iree_hal_executable_registry_t* registry, iree_hal_device_t* device,
+    iree_hal_executable_cache_t* executable_cache,
+    const iree_hal_executable_spec_t* executable_spec,
+    iree_hal_executable_t** out_executable);
+
+// Releases all registered objects that are not referenced outside of the
+// registry.
+IREE_API_EXPORT void iree_hal_executable_registry_trim(
+    iree_hal_executable_registry_t* registry);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_UTILS_EXECUTABLE_REGISTRY_H_
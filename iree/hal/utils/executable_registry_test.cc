@@ -0,0 +1,280 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/utils/executable_registry.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/hal/local/sync_device.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace iree {
+namespace hal {
+namespace {
+
+//===----------------------------------------------------------------------===//
+// Test executables and executable cache
+//===----------------------------------------------------------------------===//
+
+typedef struct iree_hal_test_executable_t {
+  iree_hal_resource_t resource;
+  iree_allocator_t host_allocator;
+  int* live_count;
+  // Retained as with real executables.
+  iree_hal_executable_layout_t* executable_layout;
+} iree_hal_test_executable_t;
+
+static void iree_hal_test_executable_destroy(iree_hal_executable_t* base) {
+  iree_hal_test_executable_t* executable = (iree_hal_test_executable_t*)base;
+  iree_hal_executable_layout_release(executable->executable_layout);
+  --*executable->live_count;
+  iree_allocator_free(executable->host_allocator, executable);
+}
+
+static const iree_hal_executable_vtable_t iree_hal_test_executable_vtable = {
+    /*.destroy=*/iree_hal_test_executable_destroy,
+};
+
+// Executable cache that counts how many executables it has prepared.
+typedef struct iree_hal_test_executable_cache_t {
+  iree_hal_resource_t resource;
+  iree_allocator_t host_allocator;
+  int prepare_count;
+  int live_count;
+  iree_hal_executable_caching_mode_t last_caching_mode;
+} iree_hal_test_executable_cache_t;
+
+static void iree_hal_test_executable_cache_destroy(
+    iree_hal_executable_cache_t* base) {
+  iree_hal_test_executable_cache_t* executable_cache =
+      (iree_hal_test_executable_cache_t*)base;
+  iree_allocator_free(executable_cache->host_allocator, executable_cache);
+}
+
+static bool iree_hal_test_executable_cache_can_prepare_format(
+    iree_hal_executable_cache_t* base,
+    iree_hal_executable_caching_mode_t caching_mode,
+    iree_string_view_t executable_format) {
+  return true;
+}
+
+static iree_status_t iree_hal_test_executable_cache_prepare_executable(
+    iree_hal_executable_cache_t* base,
+    const iree_hal_executable_spec_t* executable_spec,
+    iree_hal_executable_t** out_executable) {
+  iree_hal_test_executable_cache_t* executable_cache =
+      (iree_hal_test_executable_cache_t*)base;
+  iree_hal_test_executable_t* executable = NULL;
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(executable_cache->host_allocator,
+                                             sizeof(*executable),
+                                             (void**)&executable));
+  iree_hal_resource_initialize(&iree_hal_test_executable_vtable,
+                               &executable->resource);
+  executable->host_allocator = executable_cache->host_allocator;
+  executable->live_count = &executable_cache->live_count;
+  executable->executable_layout = executable_spec->executable_layouts[0];
+  iree_hal_executable_layout_retain(executable->executable_layout);
+  ++executable_cache->prepare_count;
+  ++executable_cache->live_count;
+  executable_cache->last_caching_mode = executable_spec->caching_mode;
+  *out_executable = (iree_hal_executable_t*)executable;
+  return iree_ok_status();
+}
+
+static const iree_hal_executable_cache_vtable_t
+    iree_hal_test_executable_cache_vtable = {
+        /*.destroy=*/iree_hal_test_executable_cache_destroy,
+        /*.can_prepare_format=*/
+        iree_hal_test_executable_cache_can_prepare_format,
+        /*.prepare_executable=*/
+        iree_hal_test_executable_cache_prepare_executable,
+};
+
+//===----------------------------------------------------------------------===//
+// Tests
+//===----------------------------------------------------------------------===//
+
+struct ExecutableRegistryTest : public ::testing::Test {
+  iree_allocator_t host_allocator = iree_allocator_system();
+  iree_hal_device_t* device = NULL;
+  iree_hal_test_executable_cache_t* executable_cache = NULL;
+  iree_hal_executable_registry_t* registry = NULL;
+
+  void SetUp() override {
+    iree_hal_allocator_t* device_allocator = NULL;
+    IREE_ASSERT_OK(iree_hal_allocator_create_heap(
+        iree_make_cstring_view("test"), host_allocator, host_allocator,
+        &device_allocator));
+    iree_hal_sync_device_params_t params;
+    iree_hal_sync_device_params_initialize(&params);
+    IREE_ASSERT_OK(iree_hal_sync_device_create(
+        iree_make_cstring_view("test"), &params, /*loader_count=*/0,
+        /*loaders=*/NULL, device_allocator, host_allocator, &device));
+    iree_hal_allocator_release(device_allocator);
+
+    IREE_ASSERT_OK(iree_allocator_malloc(host_allocator,
+                                         sizeof(*executable_cache),
+                                         (void**)&executable_cache));
+    memset(executable_cache, 0, sizeof(*executable_cache));
+    iree_hal_resource_initialize(&iree_hal_test_executable_cache_vtable,
+                                 &executable_cache->resource);
+    executable_cache->host_allocator = host_allocator;
+
+    IREE_ASSERT_OK(
+        iree_hal_executable_registry_create(host_allocator, &registry));
+  }
+
+  void TearDown() override {
+    iree_hal_executable_registry_release(registry);
+    EXPECT_EQ(0, executable_cache->live_count);
+    iree_hal_executable_cache_release(
+        (iree_hal_executable_cache_t*)executable_cache);
+    iree_hal_device_release(device);
+  }
+
+  // Creates the layouts one VM context would for a single executable.
+  void CreateLayouts(iree_hal_descriptor_set_layout_t** out_set_layout,
+                     iree_hal_executable_layout_t** out_executable_layout) {
+    iree_hal_descriptor_set_layout_binding_t bindings[2] = {
+        {0, IREE_HAL_DESCRIPTOR_TYPE_STORAGE_BUFFER},
+        {1, IREE_HAL_DESCRIPTOR_TYPE_STORAGE_BUFFER},
+    };
+    IREE_ASSERT_OK(iree_hal_executable_registry_descriptor_set_layout_create(
+        registry, device, IREE_HAL_DESCRIPTOR_SET_LAYOUT_USAGE_TYPE_IMMUTABLE,
+        IREE_ARRAYSIZE(bindings), bindings, out_set_layout));
+    IREE_ASSERT_OK(iree_hal_executable_registry_executable_layout_create(
+        registry, device, /*push_constants=*/1, /*set_layout_count=*/1,
+        out_set_layout, out_executable_layout));
+  }
+
+  iree_status_t PrepareExecutable(iree_hal_executable_layout_t* layout,
+                                  iree_const_byte_span_t data,
+                                  iree_hal_executable_t** out_executable) {
+    iree_hal_executable_spec_t spec;
+    iree_hal_executable_spec_initialize(&spec);
+    spec.caching_mode |= IREE_HAL_EXECUTABLE_CACHING_MODE_ALIAS_PROVIDED_DATA;
+    spec.executable_format = iree_make_cstring_view("test");
+    spec.executable_data = data;
+    spec.executable_layout_count = 1;
+    spec.executable_layouts = &layout;
+    return iree_hal_executable_registry_prepare_executable(
+        registry, device, (iree_hal_executable_cache_t*)executable_cache,
+        &spec, out_executable);
+  }
+};
+
+// Tests that two users loading the same executable share all objects.
+TEST_F(ExecutableRegistryTest, SharedAcrossUsers) {
+  static const uint8_t data[] = {1, 2, 3, 4};
+  iree_const_byte_span_t data_span = iree_make_const_byte_span(data, 4);
+
+  iree_hal_descriptor_set_layout_t* set_layout_a = NULL;
+  iree_hal_executable_layout_t* executable_layout_a = NULL;
+  CreateLayouts(&set_layout_a, &executable_layout_a);
+  iree_hal_executable_t* executable_a = NULL;
+  IREE_ASSERT_OK(
+      PrepareExecutable(executable_layout_a, data_span, &executable_a));
+
+  // Use a separate copy of the data as another VM context would.
+  uint8_t data_copy[4];
+  memcpy(data_copy, data, sizeof(data_copy));
+  iree_hal_descriptor_set_layout_t* set_layout_b = NULL;
+  iree_hal_executable_layout_t* executable_layout_b = NULL;
+  CreateLayouts(&set_layout_b, &executable_layout_b);
+  iree_hal_executable_t* executable_b = NULL;
+  IREE_ASSERT_OK(PrepareExecutable(
+      executable_layout_b, iree_make_const_byte_span(data_copy, 4),
+      &executable_b));
+
+  EXPECT_EQ(set_layout_a, set_layout_b);
+  EXPECT_EQ(executable_layout_a, executable_layout_b);
+  EXPECT_EQ(executable_a, executable_b);
+  EXPECT_EQ(1, executable_cache->prepare_count);
+
+  // Shared executables must not alias the data of any one user.
+  EXPECT_FALSE(iree_all_bits_set(
+      executable_cache->last_caching_mode,
+      IREE_HAL_EXECUTABLE_CACHING_MODE_ALIAS_PROVIDED_DATA));
+
+  iree_hal_executable_release(executable_a);
+  iree_hal_executable_release(executable_b);
+  iree_hal_executable_layout_release(executable_layout_a);
+  iree_hal_executable_layout_release(executable_layout_b);
+  iree_hal_descriptor_set_layout_release(set_layout_a);
+  iree_hal_descriptor_set_layout_release(set_layout_b);
+}
+
+// Tests that executables with different contents are not shared.
+TEST_F(ExecutableRegistryTest, DistinctContents) {
+  static const uint8_t data_a[] = {1, 2, 3, 4};
+  static const uint8_t data_b[] = {1, 2, 3, 5};
+
+  iree_hal_descriptor_set_layout_t* set_layout = NULL;
+  iree_hal_executable_layout_t* executable_layout = NULL;
+  CreateLayouts(&set_layout, &executable_layout);
+  iree_hal_executable_t* executable_a = NULL;
+  IREE_ASSERT_OK(PrepareExecutable(executable_layout,
+                                   iree_make_const_byte_span(data_a, 4),
+                                   &executable_a));
+  iree_hal_executable_t* executable_b = NULL;
+  IREE_ASSERT_OK(PrepareExecutable(executable_layout,
+                                   iree_make_const_byte_span(data_b, 4),
+                                   &executable_b));
+  EXPECT_NE(executable_a, executable_b);
+  EXPECT_EQ(2, executable_cache->prepare_count);
+
+  iree_hal_executable_release(executable_a);
+  iree_hal_executable_release(executable_b);
+  iree_hal_executable_layout_release(executable_layout);
+  iree_hal_descriptor_set_layout_release(set_layout);
+}
+
+// Tests that trimming only releases objects without outside references.
+TEST_F(ExecutableRegistryTest, Trim) {
+  static const uint8_t data[] = {1, 2, 3, 4};
+  iree_const_byte_span_t data_span = iree_make_const_byte_span(data, 4);
+
+  iree_hal_descriptor_set_layout_t* set_layout = NULL;
+  iree_hal_executable_layout_t* executable_layout = NULL;
+  CreateLayouts(&set_layout, &executable_layout);
+  iree_hal_executable_t* executable = NULL;
+  IREE_ASSERT_OK(PrepareExecutable(executable_layout, data_span, &executable));
+  iree_hal_executable_layout_release(executable_layout);
+  iree_hal_descriptor_set_layout_release(set_layout);
+
+  // Still in use and must be kept.
+  iree_hal_executable_registry_trim(registry);
+  EXPECT_EQ(1, executable_cache->live_count);
+
+  // Unused but registered; a new user should receive the same executable.
+  iree_hal_executable_release(executable);
+  EXPECT_EQ(1, executable_cache->live_count);
+  CreateLayouts(&set_layout, &executable_layout);
+  IREE_ASSERT_OK(PrepareExecutable(executable_layout, data_span, &executable));
+  EXPECT_EQ(1, executable_cache->prepare_count);
+  iree_hal_executable_release(executable);
+  iree_hal_executable_layout_release(executable_layout);
+  iree_hal_descriptor_set_layout_release(set_layout);
+
+  // Unused objects are released along with the layouts they reference.
+  iree_hal_executable_registry_trim(registry);
+  EXPECT_EQ(0, executable_cache->live_count);
+  CreateLayouts(&set_layout, &executable_layout);
+  IREE_ASSERT_OK(PrepareExecutable(executable_layout, data_span, &executable));
+  EXPECT_EQ(2, executable_cache->prepare_count);
+  iree_hal_executable_release(executable);
+  iree_hal_executable_layout_release(executable_layout);
+  iree_hal_descriptor_set_layout_release(set_layout);
+}
+
+}  // namespace
+}  // namespace hal
+}  // namespace iree
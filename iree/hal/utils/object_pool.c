@@ -0,0 +1,215 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/utils/object_pool.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/tracing.h"
+
+// Prepended to every allocation made from the pool such that frees can tell
+// whether the allocation is a pooled block or passed through.
+typedef struct iree_hal_object_pool_header_t {
+  // Next block in the freelist; only valid while the block is free.
+  struct iree_hal_object_pool_header_t* next;
+  // Usable length of the allocation following the header. Equal to the pool
+  // block size for pooled blocks and larger for pass-through allocations.
+  iree_host_size_t byte_length;
+} iree_hal_object_pool_header_t;
+
+struct iree_hal_object_pool_t {
+  // One reference for each owner plus one for each outstanding allocation.
+  iree_atomic_ref_count_t ref_count;
+  iree_allocator_t host_allocator;
+  iree_host_size_t block_size;
+  iree_host_size_t max_free_count;
+
+  // Guards the freelist.
+  iree_slim_mutex_t mutex;
+  iree_hal_object_pool_header_t* free_head;
+  iree_host_size_t free_count;
+};
+
+// Offset of user data from the header; preserves the alignment the underlying
+// allocator provides.
+static inline iree_host_size_t iree_hal_object_pool_header_size(void) {
+  return iree_host_align(sizeof(iree_hal_object_pool_header_t),
+                         iree_max_align_t);
+}
+
+static inline iree_hal_object_pool_header_t* iree_hal_object_pool_header(
+    void* ptr) {
+  return (iree_hal_object_pool_header_t*)((uint8_t*)ptr -
+                                          iree_hal_object_pool_header_size());
+}
+
+static inline void* iree_hal_object_pool_header_data(
+    iree_hal_object_pool_header_t* header) {
+  return (uint8_t*)header + iree_hal_object_pool_header_size();
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_object_pool_create(
+    iree_host_size_t block_size, iree_host_size_t max_free_count,
+    iree_allocator_t host_allocator, iree_hal_object_pool_t** out_pool) {
+  IREE_ASSERT_ARGUMENT(out_pool);
+  *out_pool = NULL;
+  if (IREE_UNLIKELY(block_size == 0)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "object pool block size must be non-zero");
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_object_pool_t* pool = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, sizeof(*pool), (void**)&pool));
+  iree_atomic_ref_count_init(&pool->ref_count);
+  pool->host_allocator = host_allocator;
+  pool->block_size = iree_host_align(block_size, iree_max_align_t);
+  pool->max_free_count = max_free_count;
+  iree_slim_mutex_initialize(&pool->mutex);
+  pool->free_head = NULL;
+  pool->free_count = 0;
+
+  *out_pool = pool;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+static void iree_hal_object_pool_destroy(iree_hal_object_pool_t* pool) {
+  iree_allocator_t host_allocator = pool->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // All allocations retain the pool so any remaining blocks are free.
+  iree_hal_object_pool_header_t* header = pool->free_head;
+  while (header) {
+    iree_hal_object_pool_header_t* next = header->next;
+    iree_allocator_free(host_allocator, header);
+    header = next;
+  }
+  iree_slim_mutex_deinitialize(&pool->mutex);
+  iree_allocator_free(host_allocator, pool);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+IREE_API_EXPORT void iree_hal_object_pool_retain(iree_hal_object_pool_t* pool) {
+  if (IREE_LIKELY(pool)) {
+    iree_atomic_ref_count_inc(&pool->ref_count);
+  }
+}
+
+IREE_API_EXPORT void iree_hal_object_pool_release(
+    iree_hal_object_pool_t* pool) {
+  if (IREE_LIKELY(pool) && iree_atomic_ref_count_dec(&pool->ref_count) == 1) {
+    iree_hal_object_pool_destroy(pool);
+  }
+}
+
+// Allocates at least |byte_length| bytes, reusing a free block if possible.
+static iree_status_t iree_hal_object_pool_alloc(iree_hal_object_pool_t* pool,
+                                                iree_host_size_t byte_length,
+                                                bool zero_fill,
+                                                void** out_ptr) {
+  iree_hal_object_pool_header_t* header = NULL;
+  if (byte_length <= pool->block_size) {
+    iree_slim_mutex_lock(&pool->mutex);
+    header = pool->free_head;
+    if (header) {
+      pool->free_head = header->next;
+      --pool->free_count;
+    }
+    iree_slim_mutex_unlock(&pool->mutex);
+    byte_length = pool->block_size;
+    if (header && zero_fill) {
+      memset(iree_hal_object_pool_header_data(header), 0, byte_length);
+    }
+  }
+  if (!header) {
+    IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+        pool->host_allocator, iree_hal_object_pool_header_size() + byte_length,
+        (void**)&header));
+    header->byte_length = byte_length;
+  }
+  header->next = NULL;
+  iree_hal_object_pool_retain(pool);
+  *out_ptr = iree_hal_object_pool_header_data(header);
+  return iree_ok_status();
+}
+
+static void iree_hal_object_pool_free(iree_hal_object_pool_t* pool,
+                                      void* ptr) {
+  if (!ptr) return;
+  iree_hal_object_pool_header_t* header = iree_hal_object_pool_header(ptr);
+  bool recycled = false;
+  if (header->byte_length == pool->block_size) {
+    iree_slim_mutex_lock(&pool->mutex);
+    if (pool->free_count < pool->max_free_count) {
+      header->next = pool->free_head;
+      pool->free_head = header;
+      ++pool->free_count;
+      recycled = true;
+    }
+    iree_slim_mutex_unlock(&pool->mutex);
+  }
+  if (!recycled) {
+    iree_allocator_free(pool->host_allocator, header);
+  }
+  iree_hal_object_pool_release(pool);
+}
+
+static iree_status_t iree_hal_object_pool_realloc(iree_hal_object_pool_t* pool,
+                                                  iree_host_size_t byte_length,
+                                                  void** inout_ptr) {
+  if (!*inout_ptr) {
+    return iree_hal_object_pool_alloc(pool, byte_length, /*zero_fill=*/false,
+                                      inout_ptr);
+  }
+  iree_hal_object_pool_header_t* header =
+      iree_hal_object_pool_header(*inout_ptr);
+  if (byte_length <= header->byte_length) return iree_ok_status();
+  void* new_ptr = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_object_pool_alloc(
+      pool, byte_length, /*zero_fill=*/false, &new_ptr));
+  memcpy(new_ptr, *inout_ptr, header->byte_length);
+  iree_hal_object_pool_free(pool, *inout_ptr);
+  *inout_ptr = new_ptr;
+  return iree_ok_status();
+}
+
+static iree_status_t IREE_API_PTR iree_hal_object_pool_ctl(
+    void* self, iree_allocator_command_t command, const void* params,
+    void** inout_ptr) {
+  iree_hal_object_pool_t* pool = (iree_hal_object_pool_t*)self;
+  switch (command) {
+    case IREE_ALLOCATOR_COMMAND_MALLOC:
+    case IREE_ALLOCATOR_COMMAND_CALLOC:
+      return iree_hal_object_pool_alloc(
+          pool, ((const iree_allocator_alloc_params_t*)params)->byte_length,
+          command == IREE_ALLOCATOR_COMMAND_CALLOC, inout_ptr);
+    case IREE_ALLOCATOR_COMMAND_REALLOC:
+      return iree_hal_object_pool_realloc(
+          pool, ((const iree_allocator_alloc_params_t*)params)->byte_length,
+          inout_ptr);
+    case IREE_ALLOCATOR_COMMAND_FREE:
+      iree_hal_object_pool_free(pool, *inout_ptr);
+      return iree_ok_status();
+    default:
+      return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                              "unsupported object pool allocator command");
+  }
+}
+
+IREE_API_EXPORT iree_allocator_t
+iree_hal_object_pool_allocator(iree_hal_object_pool_t* pool) {
+  iree_allocator_t allocator = {
+      .self = pool,
+      .ctl = iree_hal_object_pool_ctl,
+  };
+  return allocator;
+}
@@ -0,0 +1,53 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_UTILS_OBJECT_POOL_H_
+#define IREE_HAL_UTILS_OBJECT_POOL_H_
+
+#include "iree/base/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// A host allocator that recycles small fixed-size blocks through a freelist.
+// Intended for the short-lived HAL objects created on every invocation such as
+// buffer views and subspan buffers: objects created with the pool allocator
+// return their memory to the pool when destroyed and the next object created
+// reuses it without touching the underlying host allocator.
+//
+// Allocations of up to |block_size| bytes are served from the freelist and
+// larger allocations pass through to the underlying allocator. At most
+// |max_free_count| blocks are retained once freed.
+//
+// Every outstanding allocation retains the pool so objects may safely outlive
+// the owner of the pool; the pool is destroyed when the last reference is
+// released.
+typedef struct iree_hal_object_pool_t iree_hal_object_pool_t;
+
+// Creates a pool serving blocks of |block_size| bytes allocated from
+// |host_allocator|.
+IREE_API_EXPORT iree_status_t iree_hal_object_pool_create(
+    iree_host_size_t block_size, iree_host_size_t max_free_count,
+    iree_allocator_t host_allocator, iree_hal_object_pool_t** out_pool);
+
+// Retains the given |pool| for the caller.
+IREE_API_EXPORT void iree_hal_object_pool_retain(iree_hal_object_pool_t* pool);
+
+// Releases the given |pool| from the caller.
+IREE_API_EXPORT void iree_hal_object_pool_release(
+    iree_hal_object_pool_t* pool);
+
+// Returns an allocator that allocates from |pool|.
+// The pool must remain retained while the allocator is used to allocate.
+IREE_API_EXPORT iree_allocator_t
+iree_hal_object_pool_allocator(iree_hal_object_pool_t* pool);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_UTILS_OBJECT_POOL_H_
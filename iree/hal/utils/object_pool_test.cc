@@ -0,0 +1,172 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/utils/object_pool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace iree {
+namespace hal {
+namespace {
+
+// Wraps the system allocator and counts the allocations made through it.
+struct CountingAllocator {
+  int alloc_count = 0;
+  int live_count = 0;
+
+  static iree_status_t Ctl(void* self, iree_allocator_command_t command,
+                           const void* params, void** inout_ptr) {
+    auto* allocator = reinterpret_cast<CountingAllocator*>(self);
+    if (command == IREE_ALLOCATOR_COMMAND_MALLOC ||
+        command == IREE_ALLOCATOR_COMMAND_CALLOC) {
+      ++allocator->alloc_count;
+      ++allocator->live_count;
+    } else if (command == IREE_ALLOCATOR_COMMAND_FREE) {
+      --allocator->live_count;
+    }
+    return iree_allocator_system_ctl(NULL, command, params, inout_ptr);
+  }
+
+  iree_allocator_t get() { return {this, Ctl}; }
+};
+
+TEST(ObjectPoolTest, RecyclesBlocks) {
+  CountingAllocator counter;
+  iree_hal_object_pool_t* pool = NULL;
+  IREE_ASSERT_OK(iree_hal_object_pool_create(
+      /*block_size=*/64, /*max_free_count=*/4, counter.get(), &pool));
+  iree_allocator_t allocator = iree_hal_object_pool_allocator(pool);
+
+  void* ptr0 = NULL;
+  IREE_ASSERT_OK(iree_allocator_malloc(allocator, 32, &ptr0));
+  memset(ptr0, 0xCD, 32);
+  iree_allocator_free(allocator, ptr0);
+  int warm_count = counter.alloc_count;
+
+  // Reusing the freed block must not allocate and must return zeroed memory.
+  for (int i = 0; i < 16; ++i) {
+    void* ptr = NULL;
+    IREE_ASSERT_OK(iree_allocator_malloc(allocator, 64, &ptr));
+    EXPECT_EQ(ptr, ptr0);
+    EXPECT_EQ(0, static_cast<uint8_t*>(ptr)[0]);
+    iree_allocator_free(allocator, ptr);
+  }
+  EXPECT_EQ(warm_count, counter.alloc_count);
+
+  iree_hal_object_pool_release(pool);
+  EXPECT_EQ(0, counter.live_count);
+}
+
+TEST(ObjectPoolTest, LargeAllocationsPassThrough) {
+  CountingAllocator counter;
+  iree_hal_object_pool_t* pool = NULL;
+  IREE_ASSERT_OK(iree_hal_object_pool_create(
+      /*block_size=*/64, /*max_free_count=*/4, counter.get(), &pool));
+  iree_allocator_t allocator = iree_hal_object_pool_allocator(pool);
+
+  void* ptr = NULL;
+  IREE_ASSERT_OK(iree_allocator_malloc(allocator, 16, &ptr));
+  memset(ptr, 0xAB, 16);
+  IREE_ASSERT_OK(iree_allocator_realloc(allocator, 1024, &ptr));
+  EXPECT_EQ(0xAB, static_cast<uint8_t*>(ptr)[15]);
+  iree_allocator_free(allocator, ptr);
+
+  // Only the small block is retained.
+  iree_hal_object_pool_release(pool);
+  EXPECT_EQ(0, counter.live_count);
+}
+
+TEST(ObjectPoolTest, FreeCountIsBounded) {
+  CountingAllocator counter;
+  iree_hal_object_pool_t* pool = NULL;
+  IREE_ASSERT_OK(iree_hal_object_pool_create(
+      /*block_size=*/64, /*max_free_count=*/2, counter.get(), &pool));
+  iree_allocator_t allocator = iree_hal_object_pool_allocator(pool);
+
+  void* ptrs[4] = {NULL};
+  for (auto& ptr : ptrs) {
+    IREE_ASSERT_OK(iree_allocator_malloc(allocator, 64, &ptr));
+  }
+  int live_count = counter.live_count;
+  for (auto& ptr : ptrs) iree_allocator_free(allocator, ptr);
+  EXPECT_EQ(live_count - 2, counter.live_count);
+
+  iree_hal_object_pool_release(pool);
+  EXPECT_EQ(0, counter.live_count);
+}
+
+// Objects keep the pool alive after the owner releases it.
+TEST(ObjectPoolTest, OutlivesOwner) {
+  CountingAllocator counter;
+  iree_hal_object_pool_t* pool = NULL;
+  IREE_ASSERT_OK(iree_hal_object_pool_create(
+      /*block_size=*/64, /*max_free_count=*/4, counter.get(), &pool));
+  iree_allocator_t allocator = iree_hal_object_pool_allocator(pool);
+
+  void* ptr = NULL;
+  IREE_ASSERT_OK(iree_allocator_malloc(allocator, 64, &ptr));
+  iree_hal_object_pool_release(pool);
+  EXPECT_NE(0, counter.live_count);
+  iree_allocator_free(allocator, ptr);
+  EXPECT_EQ(0, counter.live_count);
+}
+
+// Steady-state buffer view and subspan creation should not allocate.
+TEST(ObjectPoolTest, BufferViewsAndSubspans) {
+  iree_allocator_t host_allocator = iree_allocator_system();
+  iree_hal_allocator_t* device_allocator = NULL;
+  IREE_ASSERT_OK(iree_hal_allocator_create_heap(
+      iree_make_cstring_view("heap"), host_allocator, host_allocator,
+      &device_allocator));
+  iree_hal_buffer_t* buffer = NULL;
+  IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+      device_allocator,
+      IREE_HAL_MEMORY_TYPE_HOST_LOCAL | IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE,
+      IREE_HAL_BUFFER_USAGE_ALL, 256, iree_const_byte_span_empty(), &buffer));
+
+  CountingAllocator counter;
+  iree_hal_object_pool_t* pool = NULL;
+  IREE_ASSERT_OK(iree_hal_object_pool_create(
+      iree_max(sizeof(iree_hal_buffer_t),
+               iree_hal_buffer_view_allocation_size(4)),
+      /*max_free_count=*/8, counter.get(), &pool));
+  iree_allocator_t allocator = iree_hal_object_pool_allocator(pool);
+
+  auto run_invocation = [&]() {
+    iree_hal_buffer_t* subspan = NULL;
+    IREE_ASSERT_OK(iree_hal_buffer_subspan_with_allocator(buffer, 64, 128,
+                                                          allocator, &subspan));
+    const iree_hal_dim_t shape[4] = {2, 2, 2, 4};
+    iree_hal_buffer_view_t* buffer_view = NULL;
+    IREE_ASSERT_OK(iree_hal_buffer_view_create(
+        subspan, shape, IREE_ARRAYSIZE(shape), IREE_HAL_ELEMENT_TYPE_FLOAT_32,
+        IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR, allocator, &buffer_view));
+    EXPECT_EQ(128, iree_hal_buffer_view_byte_length(buffer_view));
+    iree_hal_buffer_release(subspan);
+    iree_hal_buffer_view_release(buffer_view);
+  };
+
+  run_invocation();
+  int warm_count = counter.alloc_count;
+  for (int i = 0; i < 8; ++i) run_invocation();
+  EXPECT_EQ(warm_count, counter.alloc_count);
+
+  iree_hal_object_pool_release(pool);
+  EXPECT_EQ(0, counter.live_count);
+  iree_hal_buffer_release(buffer);
+  iree_hal_allocator_release(device_allocator);
+}
+
+}  // namespace
+}  // namespace hal
+}  // namespace iree
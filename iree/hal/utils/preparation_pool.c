@@ -0,0 +1,280 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/utils/preparation_pool.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/internal/threading.h"
+#include "iree/base/tracing.h"
+
+typedef enum iree_hal_preparation_state_e {
+  // Queued on the pool and not yet claimed by any thread.
+  IREE_HAL_PREPARATION_STATE_PENDING = 0,
+  // Claimed by a worker or waiter and currently running.
+  IREE_HAL_PREPARATION_STATE_RUNNING,
+  // Completed (or cancelled) and the status is available.
+  IREE_HAL_PREPARATION_STATE_COMPLETE,
+} iree_hal_preparation_state_t;
+
+struct iree_hal_preparation_pool_t {
+  iree_allocator_t host_allocator;
+
+  // Guards the queue and exit flag.
+  iree_slim_mutex_t mutex;
+  iree_hal_preparation_t* queue_head;
+  iree_hal_preparation_t* queue_tail;
+  bool exit_requested;
+
+  // Posted when preparations are enqueued or exit is requested.
+  iree_notification_t work_notification;
+  // Posted when any preparation completes or a worker exits.
+  iree_notification_t done_notification;
+
+  // Number of workers that have not yet exited their main loop.
+  iree_atomic_int32_t live_worker_count;
+
+  iree_host_size_t worker_count;
+  iree_thread_t* workers[];
+};
+
+// Runs the preparation work and publishes the result.
+static void iree_hal_preparation_run(iree_hal_preparation_t* preparation) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  preparation->status = preparation->fn(preparation->user_data);
+  iree_hal_preparation_pool_t* pool = preparation->pool;
+  // NOTE: |preparation| may be deinitialized by a waiter as soon as the state
+  // is stored and must not be touched afterward.
+  iree_atomic_store_int32(&preparation->state,
+                          IREE_HAL_PREPARATION_STATE_COMPLETE,
+                          iree_memory_order_release);
+  if (pool) iree_notification_post(&pool->done_notification, IREE_ALL_WAITERS);
+  IREE_TRACE_ZONE_END(z0);
+}
+
+// Removes |preparation| from the pool queue if it has not yet been claimed.
+// Returns true if the caller now owns running (or cancelling) it.
+static bool iree_hal_preparation_try_claim(
+    iree_hal_preparation_t* preparation) {
+  iree_hal_preparation_pool_t* pool = preparation->pool;
+  bool claimed = false;
+  iree_slim_mutex_lock(&pool->mutex);
+  if (iree_atomic_load_int32(&preparation->state, iree_memory_order_relaxed) ==
+      IREE_HAL_PREPARATION_STATE_PENDING) {
+    iree_hal_preparation_t* prev = NULL;
+    iree_hal_preparation_t* it = pool->queue_head;
+    while (it != preparation) {
+      prev = it;
+      it = it->next;
+    }
+    if (prev) {
+      prev->next = preparation->next;
+    } else {
+      pool->queue_head = preparation->next;
+    }
+    if (pool->queue_tail == preparation) pool->queue_tail = prev;
+    preparation->next = NULL;
+    iree_atomic_store_int32(&preparation->state,
+                            IREE_HAL_PREPARATION_STATE_RUNNING,
+                            iree_memory_order_relaxed);
+    claimed = true;
+  }
+  iree_slim_mutex_unlock(&pool->mutex);
+  return claimed;
+}
+
+static bool iree_hal_preparation_is_complete(void* arg) {
+  iree_hal_preparation_t* preparation = (iree_hal_preparation_t*)arg;
+  return iree_atomic_load_int32(&preparation->state,
+                                iree_memory_order_acquire) ==
+         IREE_HAL_PREPARATION_STATE_COMPLETE;
+}
+
+static int iree_hal_preparation_pool_worker_main(void* entry_arg) {
+  iree_hal_preparation_pool_t* pool = (iree_hal_preparation_pool_t*)entry_arg;
+  for (;;) {
+    iree_wait_token_t wait_token =
+        iree_notification_prepare_wait(&pool->work_notification);
+    iree_slim_mutex_lock(&pool->mutex);
+    iree_hal_preparation_t* preparation = pool->queue_head;
+    if (preparation) {
+      pool->queue_head = preparation->next;
+      if (!pool->queue_head) pool->queue_tail = NULL;
+      preparation->next = NULL;
+      iree_atomic_store_int32(&preparation->state,
+                              IREE_HAL_PREPARATION_STATE_RUNNING,
+                              iree_memory_order_relaxed);
+    }
+    bool exit_requested = pool->exit_requested;
+    iree_slim_mutex_unlock(&pool->mutex);
+
+    if (preparation) {
+      iree_notification_cancel_wait(&pool->work_notification);
+      iree_hal_preparation_run(preparation);
+    } else if (exit_requested) {
+      iree_notification_cancel_wait(&pool->work_notification);
+      break;
+    } else {
+      iree_notification_commit_wait(&pool->work_notification, wait_token,
+                                    IREE_TIME_INFINITE_FUTURE);
+    }
+  }
+  iree_atomic_fetch_sub_int32(&pool->live_worker_count, 1,
+                              iree_memory_order_release);
+  iree_notification_post(&pool->done_notification, IREE_ALL_WAITERS);
+  return 0;
+}
+
+static bool iree_hal_preparation_pool_workers_exited(void* arg) {
+  iree_hal_preparation_pool_t* pool = (iree_hal_preparation_pool_t*)arg;
+  return iree_atomic_load_int32(&pool->live_worker_count,
+                                iree_memory_order_acquire) == 0;
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_preparation_pool_create(
+    iree_string_view_t name, iree_host_size_t worker_count,
+    iree_allocator_t host_allocator, iree_hal_preparation_pool_t** out_pool) {
+  IREE_ASSERT_ARGUMENT(out_pool);
+  *out_pool = NULL;
+  if (worker_count == 0) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "preparation pools require at least one worker");
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_preparation_pool_t* pool = NULL;
+  iree_host_size_t total_size =
+      sizeof(*pool) + worker_count * sizeof(pool->workers[0]);
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, total_size, (void**)&pool));
+  memset(pool, 0, total_size);
+  pool->host_allocator = host_allocator;
+  iree_slim_mutex_initialize(&pool->mutex);
+  iree_notification_initialize(&pool->work_notification);
+  iree_notification_initialize(&pool->done_notification);
+
+  iree_thread_create_params_t thread_params;
+  memset(&thread_params, 0, sizeof(thread_params));
+  thread_params.name = name;
+  thread_params.priority_class = IREE_THREAD_PRIORITY_CLASS_NORMAL;
+
+  iree_status_t status = iree_ok_status();
+  for (iree_host_size_t i = 0; i < worker_count; ++i) {
+    iree_atomic_fetch_add_int32(&pool->live_worker_count, 1,
+                                iree_memory_order_relaxed);
+    status = iree_thread_create(iree_hal_preparation_pool_worker_main, pool,
+                                thread_params, host_allocator,
+                                &pool->workers[i]);
+    if (!iree_status_is_ok(status)) {
+      iree_atomic_fetch_sub_int32(&pool->live_worker_count, 1,
+                                  iree_memory_order_relaxed);
+      break;
+    }
+    ++pool->worker_count;
+  }
+
+  if (iree_status_is_ok(status)) {
+    *out_pool = pool;
+  } else {
+    iree_hal_preparation_pool_free(pool);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+IREE_API_EXPORT void iree_hal_preparation_pool_free(
+    iree_hal_preparation_pool_t* pool) {
+  if (!pool) return;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Workers drain the queue before exiting.
+  iree_slim_mutex_lock(&pool->mutex);
+  pool->exit_requested = true;
+  iree_slim_mutex_unlock(&pool->mutex);
+  iree_notification_post(&pool->work_notification, IREE_ALL_WAITERS);
+  iree_notification_await(&pool->done_notification,
+                          iree_hal_preparation_pool_workers_exited, pool,
+                          iree_infinite_timeout());
+  for (iree_host_size_t i = 0; i < pool->worker_count; ++i) {
+    iree_thread_release(pool->workers[i]);
+  }
+
+  iree_notification_deinitialize(&pool->done_notification);
+  iree_notification_deinitialize(&pool->work_notification);
+  iree_slim_mutex_deinitialize(&pool->mutex);
+  iree_allocator_free(pool->host_allocator, pool);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+IREE_API_EXPORT void iree_hal_preparation_initialize(
+    iree_hal_preparation_pool_t* pool, iree_hal_preparation_fn_t fn,
+    void* user_data, iree_hal_preparation_t* out_preparation) {
+  IREE_ASSERT_ARGUMENT(fn);
+  IREE_ASSERT_ARGUMENT(out_preparation);
+  memset(out_preparation, 0, sizeof(*out_preparation));
+  out_preparation->pool = pool;
+  out_preparation->fn = fn;
+  out_preparation->user_data = user_data;
+  iree_atomic_store_int32(&out_preparation->state,
+                          IREE_HAL_PREPARATION_STATE_PENDING,
+                          iree_memory_order_relaxed);
+
+  if (!pool) {
+    iree_atomic_store_int32(&out_preparation->state,
+                            IREE_HAL_PREPARATION_STATE_RUNNING,
+                            iree_memory_order_relaxed);
+    iree_hal_preparation_run(out_preparation);
+    return;
+  }
+
+  iree_slim_mutex_lock(&pool->mutex);
+  if (pool->queue_tail) {
+    pool->queue_tail->next = out_preparation;
+  } else {
+    pool->queue_head = out_preparation;
+  }
+  pool->queue_tail = out_preparation;
+  iree_slim_mutex_unlock(&pool->mutex);
+  iree_notification_post(&pool->work_notification, 1);
+}
+
+IREE_API_EXPORT void iree_hal_preparation_deinitialize(
+    iree_hal_preparation_t* preparation) {
+  // NOTE: completed preparations never touch the pool as it may have been
+  // freed (after draining) by the time the preparation is deinitialized.
+  if (!iree_hal_preparation_is_complete(preparation)) {
+    if (!iree_hal_preparation_try_claim(preparation)) {
+      // Already running on a worker (or complete); wait for it to finish.
+      iree_notification_await(&preparation->pool->done_notification,
+                              iree_hal_preparation_is_complete, preparation,
+                              iree_infinite_timeout());
+    }
+  }
+  iree_status_free(preparation->status);
+  memset(preparation, 0, sizeof(*preparation));
+}
+
+IREE_API_EXPORT iree_status_t
+iree_hal_preparation_wait(iree_hal_preparation_t* preparation) {
+  if (!iree_hal_preparation_is_complete(preparation)) {
+    IREE_TRACE_ZONE_BEGIN(z0);
+    if (iree_hal_preparation_try_claim(preparation)) {
+      // Not yet started; run it here instead of waiting behind other work.
+      iree_hal_preparation_run(preparation);
+    } else {
+      iree_notification_await(&preparation->pool->done_notification,
+                              iree_hal_preparation_is_complete, preparation,
+                              iree_infinite_timeout());
+    }
+    IREE_TRACE_ZONE_END(z0);
+  }
+  return iree_status_is_ok(preparation->status)
+             ? iree_ok_status()
+             : iree_status_clone(preparation->status);
+}
@@ -0,0 +1,77 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_UTILS_PREPARATION_POOL_H_
+#define IREE_HAL_UTILS_PREPARATION_POOL_H_
+
+#include "iree/base/api.h"
+#include "iree/base/internal/atomics.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+typedef struct iree_hal_preparation_pool_t iree_hal_preparation_pool_t;
+
+// Performs the deferred work of a preparation.
+// Called exactly once per preparation from either a pool worker or the first
+// thread to wait on the preparation.
+typedef iree_status_t(IREE_API_PTR* iree_hal_preparation_fn_t)(
+    void* user_data);
+
+// A unit of deferred work, such as compiling an executable, that runs
+// asynchronously on a preparation pool. Preparations are embedded in the
+// object they prepare and act as a future: users call
+// iree_hal_preparation_wait before accessing the prepared state.
+//
+// If the work has not started by the time it is waited on the waiting thread
+// claims it and runs it inline instead of blocking behind other queued work.
+typedef struct iree_hal_preparation_t {
+  // Pool the preparation was enqueued on or NULL if it ran inline.
+  iree_hal_preparation_pool_t* pool;
+  // Next preparation in the pool queue; guarded by the pool mutex.
+  struct iree_hal_preparation_t* next;
+  // iree_hal_preparation_state_e.
+  iree_atomic_int32_t state;
+  iree_hal_preparation_fn_t fn;
+  void* user_data;
+  // Result of the preparation; valid once the state is complete.
+  iree_status_t status;
+} iree_hal_preparation_t;
+
+// Creates a pool of |worker_count| threads that run preparations.
+// |name| is used for the worker threads.
+IREE_API_EXPORT iree_status_t iree_hal_preparation_pool_create(
+    iree_string_view_t name, iree_host_size_t worker_count,
+    iree_allocator_t host_allocator, iree_hal_preparation_pool_t** out_pool);
+
+// Frees the |pool| after running any preparations still queued and joining
+// the worker threads.
+IREE_API_EXPORT void iree_hal_preparation_pool_free(
+    iree_hal_preparation_pool_t* pool);
+
+// Initializes |out_preparation| and enqueues it to run |fn| on |pool|.
+// If |pool| is NULL the preparation runs inline before this returns.
+// The preparation must remain valid until deinitialized.
+IREE_API_EXPORT void iree_hal_preparation_initialize(
+    iree_hal_preparation_pool_t* pool, iree_hal_preparation_fn_t fn,
+    void* user_data, iree_hal_preparation_t* out_preparation);
+
+// Deinitializes |preparation|, cancelling it if it has not yet started or
+// waiting for it to complete if it is running.
+IREE_API_EXPORT void iree_hal_preparation_deinitialize(
+    iree_hal_preparation_t* preparation);
+
+// Blocks until |preparation| has completed and returns its result.
+// Cheap once complete. Failures are returned to every waiter.
+IREE_API_EXPORT iree_status_t
+iree_hal_preparation_wait(iree_hal_preparation_t* preparation);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_UTILS_PREPARATION_POOL_H_
@@ -0,0 +1,144 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/utils/preparation_pool.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace iree {
+namespace hal {
+namespace {
+
+using ::iree::testing::status::StatusIs;
+
+struct Counter {
+  std::atomic<int> value = {0};
+};
+
+static iree_status_t IncrementFn(void* user_data) {
+  ++((Counter*)user_data)->value;
+  return iree_ok_status();
+}
+
+static iree_status_t FailFn(void* user_data) {
+  return iree_make_status(IREE_STATUS_DATA_LOSS, "bad executable");
+}
+
+// Blocks the worker running it until released.
+struct Gate {
+  std::atomic<bool> entered = {false};
+  std::atomic<bool> released = {false};
+};
+
+static iree_status_t GateFn(void* user_data) {
+  Gate* gate = (Gate*)user_data;
+  gate->entered = true;
+  while (!gate->released) std::this_thread::yield();
+  return iree_ok_status();
+}
+
+TEST(PreparationPoolTest, InlineWithoutPool) {
+  Counter counter;
+  iree_hal_preparation_t preparation;
+  iree_hal_preparation_initialize(/*pool=*/NULL, IncrementFn, &counter,
+                                  &preparation);
+  EXPECT_EQ(1, counter.value);
+  IREE_EXPECT_OK(iree_hal_preparation_wait(&preparation));
+  iree_hal_preparation_deinitialize(&preparation);
+  EXPECT_EQ(1, counter.value);
+}
+
+TEST(PreparationPoolTest, RunsAllPreparations) {
+  iree_hal_preparation_pool_t* pool = NULL;
+  IREE_ASSERT_OK(iree_hal_preparation_pool_create(
+      iree_make_cstring_view("prepare"), 4, iree_allocator_system(), &pool));
+
+  Counter counter;
+  std::vector<iree_hal_preparation_t> preparations(64);
+  for (auto& preparation : preparations) {
+    iree_hal_preparation_initialize(pool, IncrementFn, &counter, &preparation);
+  }
+  for (auto& preparation : preparations) {
+    IREE_EXPECT_OK(iree_hal_preparation_wait(&preparation));
+  }
+  EXPECT_EQ(64, counter.value);
+  for (auto& preparation : preparations) {
+    iree_hal_preparation_deinitialize(&preparation);
+  }
+
+  iree_hal_preparation_pool_free(pool);
+}
+
+TEST(PreparationPoolTest, FailurePropagatesToAllWaiters) {
+  iree_hal_preparation_pool_t* pool = NULL;
+  IREE_ASSERT_OK(iree_hal_preparation_pool_create(
+      iree_make_cstring_view("prepare"), 1, iree_allocator_system(), &pool));
+  iree_hal_preparation_t preparation;
+  iree_hal_preparation_initialize(pool, FailFn, NULL, &preparation);
+  EXPECT_THAT(Status(iree_hal_preparation_wait(&preparation)),
+              StatusIs(StatusCode::kDataLoss));
+  EXPECT_THAT(Status(iree_hal_preparation_wait(&preparation)),
+              StatusIs(StatusCode::kDataLoss));
+  iree_hal_preparation_deinitialize(&preparation);
+  iree_hal_preparation_pool_free(pool);
+}
+
+// Tests that waiting on a queued preparation runs it on the waiting thread
+// instead of blocking behind the busy worker.
+TEST(PreparationPoolTest, WaitClaimsPendingPreparation) {
+  iree_hal_preparation_pool_t* pool = NULL;
+  IREE_ASSERT_OK(iree_hal_preparation_pool_create(
+      iree_make_cstring_view("prepare"), 1, iree_allocator_system(), &pool));
+
+  Gate gate;
+  iree_hal_preparation_t gate_preparation;
+  iree_hal_preparation_initialize(pool, GateFn, &gate, &gate_preparation);
+  while (!gate.entered) std::this_thread::yield();
+
+  Counter counter;
+  iree_hal_preparation_t preparation;
+  iree_hal_preparation_initialize(pool, IncrementFn, &counter, &preparation);
+  IREE_EXPECT_OK(iree_hal_preparation_wait(&preparation));
+  EXPECT_EQ(1, counter.value);
+  iree_hal_preparation_deinitialize(&preparation);
+
+  gate.released = true;
+  IREE_EXPECT_OK(iree_hal_preparation_wait(&gate_preparation));
+  iree_hal_preparation_deinitialize(&gate_preparation);
+  iree_hal_preparation_pool_free(pool);
+}
+
+// Tests that deinitializing a queued preparation cancels it.
+TEST(PreparationPoolTest, DeinitializeCancelsPending) {
+  iree_hal_preparation_pool_t* pool = NULL;
+  IREE_ASSERT_OK(iree_hal_preparation_pool_create(
+      iree_make_cstring_view("prepare"), 1, iree_allocator_system(), &pool));
+
+  Gate gate;
+  iree_hal_preparation_t gate_preparation;
+  iree_hal_preparation_initialize(pool, GateFn, &gate, &gate_preparation);
+  while (!gate.entered) std::this_thread::yield();
+
+  Counter counter;
+  iree_hal_preparation_t preparation;
+  iree_hal_preparation_initialize(pool, IncrementFn, &counter, &preparation);
+  iree_hal_preparation_deinitialize(&preparation);
+
+  gate.released = true;
+  iree_hal_preparation_deinitialize(&gate_preparation);
+  iree_hal_preparation_pool_free(pool);
+  EXPECT_EQ(0, counter.value);
+}
+
+}  // namespace
+}  // namespace hal
+}  // namespace iree
@@ -26,6 +26,104 @@ static void iree_hal_resource_set_setup_inline_chunk(
   set->chunk_head = inlined_chunk;
 }
 
+//===----------------------------------------------------------------------===//
+// Resource hash table
+//===----------------------------------------------------------------------===//
+
+// Mixes the bits of |resource| as the low bits of pointers are always zero and
+// allocations are often close together.
+static inline iree_host_size_t iree_hal_resource_set_hash(
+    const iree_hal_resource_t* resource) {
+  uint64_t hash = (uint64_t)(uintptr_t)resource;
+  hash ^= hash >> 33;
+  hash *= 0xFF51AFD7ED558CCDull;
+  hash ^= hash >> 33;
+  return (iree_host_size_t)hash;
+}
+
+// Returns true if |resource| is present in |table|.
+static bool iree_hal_resource_set_table_contains(
+    const iree_hal_resource_set_table_t* table,
+    const iree_hal_resource_t* resource) {
+  iree_host_size_t mask = table->capacity - 1;
+  for (iree_host_size_t i = iree_hal_resource_set_hash(resource) & mask;;
+       i = (i + 1) & mask) {
+    const iree_hal_resource_t* entry = table->entries[i];
+    if (entry == resource) return true;
+    if (!entry) return false;
+  }
+}
+
+// Inserts |resource| into |table| if not already present. The table must have
+// at least one free entry.
+static void iree_hal_resource_set_table_insert(
+    iree_hal_resource_set_table_t* table, iree_hal_resource_t* resource) {
+  iree_host_size_t mask = table->capacity - 1;
+  for (iree_host_size_t i = iree_hal_resource_set_hash(resource) & mask;;
+       i = (i + 1) & mask) {
+    iree_hal_resource_t* entry = table->entries[i];
+    if (entry == resource) return;
+    if (!entry) {
+      table->entries[i] = resource;
+      ++table->count;
+      return;
+    }
+  }
+}
+
+static void iree_hal_resource_set_table_free(iree_hal_resource_set_t* set) {
+  iree_allocator_free(set->block_pool->block_allocator, set->table);
+  set->table = NULL;
+}
+
+// Reallocates the table of |set| to hold at least |min_count| resources under
+// the maximum load factor and inserts all resources retained in the chunks if
+// the table is being created.
+static iree_status_t iree_hal_resource_set_table_reserve(
+    iree_hal_resource_set_t* set, iree_host_size_t min_count) {
+  iree_hal_resource_set_table_t* old_table = set->table;
+  iree_host_size_t capacity = old_table
+                                  ? old_table->capacity
+                                  : IREE_HAL_RESOURCE_SET_MIN_TABLE_CAPACITY;
+  while (capacity < min_count * 2) capacity *= 2;
+  if (old_table && capacity == old_table->capacity) return iree_ok_status();
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)capacity);
+  iree_hal_resource_set_table_t* new_table = NULL;
+  iree_host_size_t total_size =
+      sizeof(*new_table) + capacity * sizeof(new_table->entries[0]);
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(set->block_pool->block_allocator, total_size,
+                                (void**)&new_table));
+  memset(new_table, 0, total_size);
+  new_table->capacity = capacity;
+  if (old_table) {
+    for (iree_host_size_t i = 0; i < old_table->capacity; ++i) {
+      if (old_table->entries[i]) {
+        iree_hal_resource_set_table_insert(new_table, old_table->entries[i]);
+      }
+    }
+    iree_hal_resource_set_table_free(set);
+  } else {
+    for (iree_hal_resource_set_chunk_t* chunk = set->chunk_head; chunk;
+         chunk = iree_hal_resource_set_chunk_is_stored_inline(chunk)
+                     ? NULL
+                     : chunk->next_chunk) {
+      for (iree_host_size_t i = 0; i < chunk->count; ++i) {
+        iree_hal_resource_set_table_insert(new_table, chunk->resources[i]);
+      }
+    }
+  }
+  set->table = new_table;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+//===----------------------------------------------------------------------===//
+// iree_hal_resource_set_t
+//===----------------------------------------------------------------------===//
+
 IREE_API_EXPORT iree_status_t iree_hal_resource_set_allocate(
     iree_arena_block_pool_t* block_pool, iree_hal_resource_set_t** out_set) {
   IREE_TRACE_ZONE_BEGIN(z0);
@@ -52,6 +150,8 @@ IREE_API_EXPORT iree_status_t iree_hal_resource_set_allocate(
 
 static void iree_hal_resource_set_release_blocks(iree_hal_resource_set_t* set,
                                                  bool preserve_set) {
+  if (set->table) iree_hal_resource_set_table_free(set);
+
   // Release all resources in all chunks and stitch together the blocks in a
   // linked list. We do this first so that we can release all of the chunks back
   // to the block pool in one operation. Ideally we'd maintain the linked list
@@ -245,10 +345,30 @@ static iree_status_t iree_hal_resource_set_insert_1(
     return iree_ok_status();
   }
 
-  // Miss - insert into the main list (slow path).
+  // Miss - check the table if the set has grown large enough to have one.
+  // The table is created as the first chunk spills so that small sets never
+  // pay for it.
+  iree_hal_resource_set_chunk_t* chunk = set->chunk_head;
+  if (!set->table && chunk->count == chunk->capacity) {
+    IREE_RETURN_IF_ERROR(
+        iree_hal_resource_set_table_reserve(set, chunk->count + 1));
+  }
+  if (set->table) {
+    if (iree_hal_resource_set_table_contains(set->table, resource)) {
+      memmove(&set->mru[1], &set->mru[0],
+              sizeof(set->mru[0]) * (IREE_ARRAYSIZE(set->mru) - 1));
+      set->mru[0] = resource;
+      return iree_ok_status();
+    }
+    IREE_RETURN_IF_ERROR(
+        iree_hal_resource_set_table_reserve(set, set->table->count + 1));
+  }
+
+  // Insert into the main list (slow path).
   // Note that we do this before updating the MRU in case allocation fails - we
   // don't want to keep the pointer around unless we've really retained it.
   IREE_RETURN_IF_ERROR(iree_hal_resource_set_insert_retain(set, resource));
+  if (set->table) iree_hal_resource_set_table_insert(set->table, resource);
 
   // Shift the MRU down and insert the new item at the head.
   memmove(&set->mru[1], &set->mru[0],
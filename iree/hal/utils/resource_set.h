@@ -66,6 +66,20 @@ typedef struct iree_hal_resource_set_chunk_t {
 #define IREE_HAL_RESOURCE_SET_MRU_SIZE \
   (iree_hardware_constructive_interference_size / sizeof(uintptr_t))
 
+// Minimum capacity of the hash table built once a set spills its first chunk.
+#define IREE_HAL_RESOURCE_SET_MIN_TABLE_CAPACITY 64
+
+// Open-addressing hash table of all resources retained by a set.
+// Allocated from the block allocator of the set block pool and grown to keep
+// the load factor under 1/2.
+typedef struct iree_hal_resource_set_table_t {
+  // Power-of-two number of entries.
+  iree_host_size_t capacity;
+  // Number of non-NULL entries.
+  iree_host_size_t count;
+  iree_hal_resource_t* entries[];
+} iree_hal_resource_set_table_t;
+
 // "Efficient" append-only set for retaining a set of resources.
 // This is a non-deterministic data structure that tries to reduce the amount of
 // overhead involved in tracking a reasonably-sized set of resources (~dozens to
@@ -86,6 +100,12 @@ typedef struct iree_hal_resource_set_chunk_t {
 // whatever user code may need to do to maintain proper lifetime - or as small
 // in terms of code-size.
 //
+// Sets that grow beyond their first chunk (large command buffers touching
+// thousands of buffers) additionally build a hash table of their resources so
+// that MRU misses are deduplicated exactly. Without it every miss is retained
+// again and both the set storage and the retain/release traffic grow with the
+// number of insertions instead of the number of unique resources.
+//
 // **WARNING**: thread-unsafe insertion: it's assumed that sets are constructed
 // by a single thread, sealed, and then released at once at a future time point.
 // Multiple threads needing to insert into a set should have their own sets and
@@ -111,6 +131,9 @@ typedef struct iree_hal_resource_set_t {
 
   // Linked list of storage chunks.
   iree_hal_resource_set_chunk_t* chunk_head;
+
+  // Hash table of all retained resources; NULL until the first chunk spills.
+  iree_hal_resource_set_table_t* table;
 } iree_hal_resource_set_t;
 
 // Allocates a new resource from the given |block_pool|.
@@ -280,6 +280,9 @@ int main(int argc, char** argv) {
     benchmark_def.user_data = (void*)4096u;
     iree_benchmark_register(iree_make_cstring_view("randomized_4096"),
                             &benchmark_def);
+    benchmark_def.user_data = (void*)16384u;
+    iree_benchmark_register(iree_make_cstring_view("randomized_16384"),
+                            &benchmark_def);
   }
 
   iree_benchmark_run_specified();
@@ -252,6 +252,42 @@ TEST_F(ResourceSetTest, RedundantInsertion) {
   EXPECT_EQ(live_bitmap, 0u);
 }
 
+// Tests that sets spilling their first chunk deduplicate resources that have
+// fallen out of the MRU instead of retaining them again.
+TEST_F(ResourceSetTest, LargeSetDeduplication) {
+  auto resource_set = make_resource_set(&block_pool);
+
+  iree_hal_resource_t* resources[32] = {NULL};
+  uint32_t live_bitmap = 0u;
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(resources); ++i) {
+    IREE_ASSERT_OK(iree_hal_test_resource_create(
+        i, &live_bitmap, host_allocator, &resources[i]));
+  }
+
+  // Insert all resources multiple times; each pass misses the MRU.
+  for (int pass = 0; pass < 3; ++pass) {
+    IREE_ASSERT_OK(iree_hal_resource_set_insert(
+        resource_set.get(), IREE_ARRAYSIZE(resources), resources));
+  }
+  ASSERT_NE(resource_set->table, nullptr);
+  EXPECT_EQ(resource_set->table->count, IREE_ARRAYSIZE(resources));
+
+  // Each resource should be retained by the set exactly once.
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(resources); ++i) {
+    EXPECT_EQ(iree_atomic_load_int32(&resources[i]->ref_count,
+                                     iree_memory_order_relaxed),
+              2);
+    iree_hal_resource_release(resources[i]);
+  }
+  EXPECT_EQ(live_bitmap, 0xFFFFFFFFu);
+
+  // Reset drops the table along with the resources and the set is usable
+  // again afterward.
+  iree_hal_resource_set_reset(resource_set.get());
+  EXPECT_EQ(live_bitmap, 0u);
+  EXPECT_EQ(resource_set->table, nullptr);
+}
+
 }  // namespace
 }  // namespace hal
 }  // namespace iree
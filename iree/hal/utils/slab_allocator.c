@@ -0,0 +1,487 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/utils/slab_allocator.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "iree/base/internal/math.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/tracing.h"
+#include "iree/hal/detail.h"
+
+// A single base allocation divided into equally sized blocks.
+typedef struct iree_hal_slab_t {
+  struct iree_hal_slab_t* next;
+  // Base allocator buffer; one reference is owned by the slab and one by each
+  // subspan buffer allocated from it.
+  iree_hal_buffer_t* buffer;
+  uint32_t block_count;
+  uint32_t free_count;
+  // One bit per block; set bits indicate free blocks.
+  uint64_t free_bitmap[];
+} iree_hal_slab_t;
+
+// Slabs for allocations with the same requested memory type and usage.
+typedef struct iree_hal_slab_heap_t {
+  iree_hal_memory_type_t memory_type;
+  iree_hal_buffer_usage_t allowed_usage;
+  // Singly-linked slab lists for each block class.
+  iree_hal_slab_t* slabs[IREE_HAL_SLAB_ALLOCATOR_MAX_BLOCK_CLASS_COUNT];
+} iree_hal_slab_heap_t;
+
+typedef struct iree_hal_slab_allocator_t {
+  iree_hal_resource_t resource;
+  iree_allocator_t host_allocator;
+  iree_hal_allocator_t* base_allocator;
+
+  // log2 of the smallest block size.
+  int min_block_size_log2;
+  // Total number of block classes from min_block_size to max_block_size.
+  int block_class_count;
+  iree_device_size_t max_block_size;
+  iree_device_size_t slab_size;
+
+  // Guards all heap and slab state.
+  iree_slim_mutex_t mutex;
+
+  iree_host_size_t heap_count;
+  iree_hal_slab_heap_t heaps[IREE_HAL_SLAB_ALLOCATOR_MAX_HEAP_COUNT];
+} iree_hal_slab_allocator_t;
+
+static const iree_hal_allocator_vtable_t iree_hal_slab_allocator_vtable;
+
+static iree_hal_slab_allocator_t* iree_hal_slab_allocator_cast(
+    iree_hal_allocator_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value, &iree_hal_slab_allocator_vtable);
+  return (iree_hal_slab_allocator_t*)base_value;
+}
+
+IREE_API_EXPORT void iree_hal_slab_allocator_params_initialize(
+    iree_hal_slab_allocator_params_t* out_params) {
+  memset(out_params, 0, sizeof(*out_params));
+  out_params->min_block_size = 256;
+  out_params->max_block_size = 64 * 1024;
+  out_params->slab_size = 1024 * 1024;
+}
+
+static bool iree_hal_slab_allocator_is_pow2(iree_device_size_t value) {
+  return value != 0 && (value & (value - 1)) == 0;
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_slab_allocator_create(
+    iree_hal_allocator_t* base_allocator,
+    const iree_hal_slab_allocator_params_t* params,
+    iree_allocator_t host_allocator, iree_hal_allocator_t** out_allocator) {
+  IREE_ASSERT_ARGUMENT(base_allocator);
+  IREE_ASSERT_ARGUMENT(params);
+  IREE_ASSERT_ARGUMENT(out_allocator);
+  *out_allocator = NULL;
+
+  if (!iree_hal_slab_allocator_is_pow2(params->min_block_size) ||
+      !iree_hal_slab_allocator_is_pow2(params->max_block_size) ||
+      params->min_block_size > params->max_block_size) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "block sizes must be powers of two with min <= max; "
+        "min=%" PRIdsz ", max=%" PRIdsz,
+        params->min_block_size, params->max_block_size);
+  }
+  if (params->slab_size < params->max_block_size ||
+      (params->slab_size % params->max_block_size) != 0) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "slab size %" PRIdsz
+        " must be a multiple of the max block size %" PRIdsz,
+        params->slab_size, params->max_block_size);
+  }
+  if (params->slab_size / params->min_block_size > UINT32_MAX) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "slab size %" PRIdsz " has too many blocks",
+                            params->slab_size);
+  }
+  int min_block_size_log2 =
+      iree_math_count_trailing_zeros_u64(params->min_block_size);
+  int max_block_size_log2 =
+      iree_math_count_trailing_zeros_u64(params->max_block_size);
+  int block_class_count = max_block_size_log2 - min_block_size_log2 + 1;
+  if (block_class_count > IREE_HAL_SLAB_ALLOCATOR_MAX_BLOCK_CLASS_COUNT) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "%d block classes requested but only %d supported",
+                            block_class_count,
+                            IREE_HAL_SLAB_ALLOCATOR_MAX_BLOCK_CLASS_COUNT);
+  }
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_slab_allocator_t* allocator = NULL;
+  iree_status_t status = iree_allocator_malloc(
+      host_allocator, sizeof(*allocator), (void**)&allocator);
+  if (iree_status_is_ok(status)) {
+    memset(allocator, 0, sizeof(*allocator));
+    iree_hal_resource_initialize(&iree_hal_slab_allocator_vtable,
+                                 &allocator->resource);
+    allocator->host_allocator = host_allocator;
+    allocator->base_allocator = base_allocator;
+    iree_hal_allocator_retain(base_allocator);
+    allocator->min_block_size_log2 = min_block_size_log2;
+    allocator->block_class_count = block_class_count;
+    allocator->max_block_size = params->max_block_size;
+    allocator->slab_size = params->slab_size;
+    iree_slim_mutex_initialize(&allocator->mutex);
+    *out_allocator = (iree_hal_allocator_t*)allocator;
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_hal_slab_free(iree_hal_slab_allocator_t* allocator,
+                               iree_hal_slab_t* slab) {
+  iree_hal_buffer_release(slab->buffer);
+  iree_allocator_free(allocator->host_allocator, slab);
+}
+
+// Frees all empty slabs in all heaps.
+// Must be called with the mutex held.
+static void iree_hal_slab_allocator_free_empty_slabs_locked(
+    iree_hal_slab_allocator_t* allocator) {
+  for (iree_host_size_t i = 0; i < allocator->heap_count; ++i) {
+    iree_hal_slab_heap_t* heap = &allocator->heaps[i];
+    for (int j = 0; j < allocator->block_class_count; ++j) {
+      iree_hal_slab_t** link = &heap->slabs[j];
+      while (*link) {
+        iree_hal_slab_t* slab = *link;
+        if (slab->free_count == slab->block_count) {
+          *link = slab->next;
+          iree_hal_slab_free(allocator, slab);
+        } else {
+          link = &slab->next;
+        }
+      }
+    }
+  }
+}
+
+static void iree_hal_slab_allocator_destroy(
+    iree_hal_allocator_t* base_allocator) {
+  iree_hal_slab_allocator_t* allocator =
+      iree_hal_slab_allocator_cast(base_allocator);
+  iree_allocator_t host_allocator = allocator->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_slab_allocator_free_empty_slabs_locked(allocator);
+  for (iree_host_size_t i = 0; i < allocator->heap_count; ++i) {
+    for (int j = 0; j < allocator->block_class_count; ++j) {
+      IREE_ASSERT(!allocator->heaps[i].slabs[j],
+                  "buffers still live in the slab allocator");
+    }
+  }
+  iree_slim_mutex_deinitialize(&allocator->mutex);
+  iree_hal_allocator_release(allocator->base_allocator);
+  iree_allocator_free(host_allocator, allocator);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+static iree_allocator_t iree_hal_slab_allocator_host_allocator(
+    const iree_hal_allocator_t* base_allocator) {
+  iree_hal_slab_allocator_t* allocator =
+      (iree_hal_slab_allocator_t*)base_allocator;
+  return allocator->host_allocator;
+}
+
+static iree_status_t iree_hal_slab_allocator_trim(
+    iree_hal_allocator_t* base_allocator) {
+  iree_hal_slab_allocator_t* allocator =
+      iree_hal_slab_allocator_cast(base_allocator);
+  iree_slim_mutex_lock(&allocator->mutex);
+  iree_hal_slab_allocator_free_empty_slabs_locked(allocator);
+  iree_slim_mutex_unlock(&allocator->mutex);
+  return iree_hal_allocator_trim(allocator->base_allocator);
+}
+
+static void iree_hal_slab_allocator_query_statistics(
+    iree_hal_allocator_t* base_allocator,
+    iree_hal_allocator_statistics_t* out_statistics) {
+  // Slabs are the only allocations made and they are reported by the base.
+  iree_hal_slab_allocator_t* allocator =
+      iree_hal_slab_allocator_cast(base_allocator);
+  iree_hal_allocator_query_statistics(allocator->base_allocator,
+                                      out_statistics);
+}
+
+static iree_hal_buffer_compatibility_t
+iree_hal_slab_allocator_query_buffer_compatibility(
+    iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_buffer_usage_t allowed_usage,
+    iree_hal_buffer_usage_t intended_usage,
+    iree_device_size_t allocation_size) {
+  iree_hal_slab_allocator_t* allocator =
+      iree_hal_slab_allocator_cast(base_allocator);
+  return iree_hal_allocator_query_buffer_compatibility(
+      allocator->base_allocator, memory_type, allowed_usage, intended_usage,
+      allocation_size);
+}
+
+// Returns the index of the smallest block class that can hold |size| bytes.
+static int iree_hal_slab_allocator_block_class(
+    iree_hal_slab_allocator_t* allocator, iree_device_size_t size) {
+  if (size <= ((iree_device_size_t)1 << allocator->min_block_size_log2)) {
+    return 0;
+  }
+  int size_log2 = 64 - iree_math_count_leading_zeros_u64(size - 1);
+  return size_log2 - allocator->min_block_size_log2;
+}
+
+// Returns the heap for the given parameters, creating it if needed.
+// Returns NULL if all heaps are in use by other parameters.
+// Must be called with the mutex held.
+static iree_hal_slab_heap_t* iree_hal_slab_allocator_find_heap_locked(
+    iree_hal_slab_allocator_t* allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_buffer_usage_t allowed_usage) {
+  for (iree_host_size_t i = 0; i < allocator->heap_count; ++i) {
+    iree_hal_slab_heap_t* heap = &allocator->heaps[i];
+    if (heap->memory_type == memory_type &&
+        heap->allowed_usage == allowed_usage) {
+      return heap;
+    }
+  }
+  if (allocator->heap_count == IREE_ARRAYSIZE(allocator->heaps)) return NULL;
+  iree_hal_slab_heap_t* heap = &allocator->heaps[allocator->heap_count++];
+  heap->memory_type = memory_type;
+  heap->allowed_usage = allowed_usage;
+  return heap;
+}
+
+// Allocates a new slab from the base allocator.
+static iree_status_t iree_hal_slab_allocator_allocate_slab(
+    iree_hal_slab_allocator_t* allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_buffer_usage_t allowed_usage, int block_class,
+    iree_hal_slab_t** out_slab) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  uint32_t block_count = (uint32_t)(allocator->slab_size >>
+                                    (allocator->min_block_size_log2 +
+                                     block_class));
+  iree_host_size_t word_count = iree_host_align(block_count, 64) / 64;
+  iree_hal_slab_t* slab = NULL;
+  iree_status_t status = iree_allocator_malloc(
+      allocator->host_allocator,
+      sizeof(*slab) + word_count * sizeof(slab->free_bitmap[0]),
+      (void**)&slab);
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_allocator_allocate_buffer(
+        allocator->base_allocator, memory_type, allowed_usage,
+        allocator->slab_size, iree_const_byte_span_empty(), &slab->buffer);
+  }
+  if (iree_status_is_ok(status)) {
+    slab->next = NULL;
+    slab->block_count = block_count;
+    slab->free_count = block_count;
+    memset(slab->free_bitmap, 0xFF, word_count * sizeof(slab->free_bitmap[0]));
+    if (block_count % 64) {
+      slab->free_bitmap[word_count - 1] = (1ull << (block_count % 64)) - 1;
+    }
+    *out_slab = slab;
+  } else {
+    iree_allocator_free(allocator->host_allocator, slab);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Acquires a free block from |slab| and returns its index.
+// The slab must have at least one free block.
+static uint32_t iree_hal_slab_acquire_block(iree_hal_slab_t* slab) {
+  for (iree_host_size_t i = 0;; ++i) {
+    uint64_t word = slab->free_bitmap[i];
+    if (!word) continue;
+    int bit = iree_math_count_trailing_zeros_u64(word);
+    slab->free_bitmap[i] = word & ~(1ull << bit);
+    --slab->free_count;
+    return (uint32_t)(i * 64 + bit);
+  }
+}
+
+static void iree_hal_slab_release_block(iree_hal_slab_t* slab,
+                                        uint32_t block_index) {
+  slab->free_bitmap[block_index / 64] |= 1ull << (block_index % 64);
+  ++slab->free_count;
+}
+
+static iree_status_t iree_hal_slab_allocator_allocate_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_buffer_usage_t allowed_usage, iree_host_size_t allocation_size,
+    iree_const_byte_span_t initial_data, iree_hal_buffer_t** out_buffer) {
+  iree_hal_slab_allocator_t* allocator =
+      iree_hal_slab_allocator_cast(base_allocator);
+
+  // Large buffers gain nothing from suballocation and buffers with initial data
+  // are usually long-lived constants we don't want pinning slabs.
+  if (allocation_size == 0 || allocation_size > allocator->max_block_size ||
+      !iree_const_byte_span_is_empty(initial_data)) {
+    return iree_hal_allocator_allocate_buffer(allocator->base_allocator,
+                                              memory_type, allowed_usage,
+                                              allocation_size, initial_data,
+                                              out_buffer);
+  }
+
+  int block_class =
+      iree_hal_slab_allocator_block_class(allocator, allocation_size);
+  iree_slim_mutex_lock(&allocator->mutex);
+  iree_hal_slab_heap_t* heap = iree_hal_slab_allocator_find_heap_locked(
+      allocator, memory_type, allowed_usage);
+  if (!heap) {
+    iree_slim_mutex_unlock(&allocator->mutex);
+    return iree_hal_allocator_allocate_buffer(allocator->base_allocator,
+                                              memory_type, allowed_usage,
+                                              allocation_size, initial_data,
+                                              out_buffer);
+  }
+
+  // Find a slab with a free block, moving it to the front of the list so that
+  // subsequent allocations find it first.
+  iree_hal_slab_t** link = &heap->slabs[block_class];
+  while (*link && (*link)->free_count == 0) link = &(*link)->next;
+  iree_hal_slab_t* slab = *link;
+  iree_status_t status = iree_ok_status();
+  if (slab) {
+    *link = slab->next;
+  } else {
+    // Slab allocation is rare enough that we keep the lock held to avoid
+    // racing other threads into allocating redundant slabs.
+    status = iree_hal_slab_allocator_allocate_slab(
+        allocator, memory_type, allowed_usage, block_class, &slab);
+  }
+  uint32_t block_index = 0;
+  if (iree_status_is_ok(status)) {
+    slab->next = heap->slabs[block_class];
+    heap->slabs[block_class] = slab;
+    block_index = iree_hal_slab_acquire_block(slab);
+    iree_hal_buffer_retain(slab->buffer);  // +1 for the subspan
+  }
+  iree_slim_mutex_unlock(&allocator->mutex);
+  IREE_RETURN_IF_ERROR(status);
+
+  iree_device_size_t block_offset =
+      (iree_device_size_t)block_index
+      << (allocator->min_block_size_log2 + block_class);
+  status = iree_hal_subspan_buffer_create(
+      slab->buffer, block_offset, allocation_size, base_allocator,
+      allocator->host_allocator, out_buffer);
+  if (!iree_status_is_ok(status)) {
+    iree_slim_mutex_lock(&allocator->mutex);
+    iree_hal_slab_release_block(slab, block_index);
+    iree_slim_mutex_unlock(&allocator->mutex);
+  }
+  iree_hal_buffer_release(slab->buffer);  // -1 now owned by the subspan
+  return status;
+}
+
+// Returns the link pointing at the slab that owns |buffer| and the head of the
+// list containing it in |out_list|.
+// Must be called with the mutex held.
+static iree_hal_slab_t** iree_hal_slab_allocator_find_slab_locked(
+    iree_hal_slab_allocator_t* allocator, iree_hal_buffer_t* buffer,
+    int block_class, iree_hal_slab_t** out_list) {
+  for (iree_host_size_t i = 0; i < allocator->heap_count; ++i) {
+    iree_hal_slab_t** link = &allocator->heaps[i].slabs[block_class];
+    *out_list = *link;
+    while (*link) {
+      if ((*link)->buffer == buffer->allocated_buffer) return link;
+      link = &(*link)->next;
+    }
+  }
+  return NULL;
+}
+
+static void iree_hal_slab_allocator_deallocate_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_buffer_t* buffer) {
+  iree_hal_slab_allocator_t* allocator =
+      iree_hal_slab_allocator_cast(base_allocator);
+  int block_class =
+      iree_hal_slab_allocator_block_class(allocator, buffer->byte_length);
+  uint32_t block_index = (uint32_t)(
+      buffer->byte_offset >> (allocator->min_block_size_log2 + block_class));
+
+  iree_hal_slab_t* empty_slab = NULL;
+  iree_slim_mutex_lock(&allocator->mutex);
+  iree_hal_slab_t* list = NULL;
+  iree_hal_slab_t** link = iree_hal_slab_allocator_find_slab_locked(
+      allocator, buffer, block_class, &list);
+  IREE_ASSERT(link, "subspan buffer not allocated from this slab allocator");
+  iree_hal_slab_t* slab = *link;
+  iree_hal_slab_release_block(slab, block_index);
+  if (slab->free_count == slab->block_count) {
+    // Keep one empty slab around in each class to avoid thrashing when a
+    // single buffer is repeatedly allocated and released.
+    for (iree_hal_slab_t* other = list; other; other = other->next) {
+      if (other != slab && other->free_count == other->block_count) {
+        empty_slab = slab;
+        *link = slab->next;
+        break;
+      }
+    }
+  }
+  iree_slim_mutex_unlock(&allocator->mutex);
+
+  // Drops the subspan reference to the slab buffer.
+  iree_hal_buffer_destroy(buffer);
+  if (empty_slab) iree_hal_slab_free(allocator, empty_slab);
+}
+
+static iree_status_t iree_hal_slab_allocator_wrap_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_memory_access_t allowed_access,
+    iree_hal_buffer_usage_t allowed_usage, iree_byte_span_t data,
+    iree_allocator_t data_allocator, iree_hal_buffer_t** out_buffer) {
+  iree_hal_slab_allocator_t* allocator =
+      iree_hal_slab_allocator_cast(base_allocator);
+  return iree_hal_allocator_wrap_buffer(allocator->base_allocator, memory_type,
+                                        allowed_access, allowed_usage, data,
+                                        data_allocator, out_buffer);
+}
+
+static iree_status_t iree_hal_slab_allocator_import_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_memory_access_t allowed_access,
+    iree_hal_buffer_usage_t allowed_usage,
+    iree_hal_external_buffer_t* external_buffer,
+    iree_hal_buffer_t** out_buffer) {
+  iree_hal_slab_allocator_t* allocator =
+      iree_hal_slab_allocator_cast(base_allocator);
+  return iree_hal_allocator_import_buffer(allocator->base_allocator,
+                                          memory_type, allowed_access,
+                                          allowed_usage, external_buffer,
+                                          out_buffer);
+}
+
+static iree_status_t iree_hal_slab_allocator_export_buffer(
+    iree_hal_allocator_t* base_allocator, iree_hal_buffer_t* buffer,
+    iree_hal_external_buffer_type_t requested_type,
+    iree_hal_external_buffer_flags_t requested_flags,
+    iree_hal_external_buffer_t* out_external_buffer) {
+  iree_hal_slab_allocator_t* allocator =
+      iree_hal_slab_allocator_cast(base_allocator);
+  return iree_hal_allocator_export_buffer(allocator->base_allocator, buffer,
+                                          requested_type, requested_flags,
+                                          out_external_buffer);
+}
+
+static const iree_hal_allocator_vtable_t iree_hal_slab_allocator_vtable = {
+    .destroy = iree_hal_slab_allocator_destroy,
+    .host_allocator = iree_hal_slab_allocator_host_allocator,
+    .trim = iree_hal_slab_allocator_trim,
+    .query_statistics = iree_hal_slab_allocator_query_statistics,
+    .query_buffer_compatibility =
+        iree_hal_slab_allocator_query_buffer_compatibility,
+    .allocate_buffer = iree_hal_slab_allocator_allocate_buffer,
+    .deallocate_buffer = iree_hal_slab_allocator_deallocate_buffer,
+    .wrap_buffer = iree_hal_slab_allocator_wrap_buffer,
+    .import_buffer = iree_hal_slab_allocator_import_buffer,
+    .export_buffer = iree_hal_slab_allocator_export_buffer,
+};
@@ -0,0 +1,70 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_UTILS_SLAB_ALLOCATOR_H_
+#define IREE_HAL_UTILS_SLAB_ALLOCATOR_H_
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Maximum number of unique (memory type, allowed usage) pairs that can be
+// suballocated by a single slab allocator. Allocations with parameters beyond
+// the first pairs seen are passed through to the underlying allocator.
+#define IREE_HAL_SLAB_ALLOCATOR_MAX_HEAP_COUNT 8
+
+// Maximum number of power-of-two block sizes a slab allocator supports.
+#define IREE_HAL_SLAB_ALLOCATOR_MAX_BLOCK_CLASS_COUNT 16
+
+// Parameters configuring an iree_hal_slab_allocator_t.
+// Must be initialized with iree_hal_slab_allocator_params_initialize prior to
+// use.
+typedef struct iree_hal_slab_allocator_params_t {
+  // Smallest block size in bytes; power-of-two. All suballocations are aligned
+  // to at least this value within their slab.
+  iree_device_size_t min_block_size;
+
+  // Largest block size in bytes; power-of-two. Allocations larger than this are
+  // passed through to the underlying allocator.
+  iree_device_size_t max_block_size;
+
+  // Size in bytes of each slab allocated from the underlying allocator.
+  // Must be a multiple of max_block_size.
+  iree_device_size_t slab_size;
+} iree_hal_slab_allocator_params_t;
+
+// Initializes |out_params| to default values.
+IREE_API_EXPORT void iree_hal_slab_allocator_params_initialize(
+    iree_hal_slab_allocator_params_t* out_params);
+
+// Creates an allocator that carves small buffers out of large slabs allocated
+// from |base_allocator|, which is retained for the lifetime of the slab
+// allocator. Each slab is divided into fixed-size blocks of a single
+// power-of-two size and the buffers returned are subspans of the slab buffer
+// so they can be used with any backend that supports subspans. Subspans taken
+// from a returned buffer retain it so its block is not reused while they are
+// live.
+//
+// Allocations larger than the max block size or with initial data (usually
+// long-lived constants) are passed through to |base_allocator|.
+//
+// Slabs are returned to |base_allocator| when they become empty, keeping at
+// most one empty slab per block size to avoid thrashing, and during
+// iree_hal_allocator_trim. All buffers must be released before the slab
+// allocator is destroyed.
+IREE_API_EXPORT iree_status_t iree_hal_slab_allocator_create(
+    iree_hal_allocator_t* base_allocator,
+    const iree_hal_slab_allocator_params_t* params,
+    iree_allocator_t host_allocator, iree_hal_allocator_t** out_allocator);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_UTILS_SLAB_ALLOCATOR_H_
@@ -0,0 +1,219 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/utils/slab_allocator.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace iree {
+namespace hal {
+namespace {
+
+using ::iree::testing::status::StatusIs;
+
+static const iree_hal_memory_type_t kMemoryType =
+    IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE;
+static const iree_hal_buffer_usage_t kUsage = IREE_HAL_BUFFER_USAGE_DISPATCH |
+                                              IREE_HAL_BUFFER_USAGE_TRANSFER |
+                                              IREE_HAL_BUFFER_USAGE_MAPPING;
+
+static const iree_device_size_t kSlabSize = 4096;
+
+struct SlabAllocatorTest : public ::testing::Test {
+  iree_allocator_t host_allocator = iree_allocator_system();
+  iree_hal_allocator_t* heap_allocator = NULL;
+  iree_hal_allocator_t* allocator = NULL;
+
+  void SetUp() override {
+    IREE_ASSERT_OK(iree_hal_allocator_create_heap(
+        iree_make_cstring_view("heap"), host_allocator, host_allocator,
+        &heap_allocator));
+    iree_hal_slab_allocator_params_t params;
+    iree_hal_slab_allocator_params_initialize(&params);
+    params.min_block_size = 64;
+    params.max_block_size = 1024;
+    params.slab_size = kSlabSize;
+    IREE_ASSERT_OK(iree_hal_slab_allocator_create(
+        heap_allocator, &params, host_allocator, &allocator));
+  }
+
+  void TearDown() override {
+    iree_hal_allocator_release(allocator);
+    iree_hal_allocator_release(heap_allocator);
+  }
+
+  iree_hal_buffer_t* Allocate(iree_device_size_t size) {
+    iree_hal_buffer_t* buffer = NULL;
+    IREE_CHECK_OK(iree_hal_allocator_allocate_buffer(
+        allocator, kMemoryType, kUsage, size, iree_const_byte_span_empty(),
+        &buffer));
+    return buffer;
+  }
+
+  iree_device_size_t QueryBaseBytesLive() {
+    iree_hal_allocator_statistics_t statistics;
+    iree_hal_allocator_query_statistics(allocator, &statistics);
+#if IREE_STATISTICS_ENABLE
+    return (statistics.host_bytes_allocated - statistics.host_bytes_freed) +
+           (statistics.device_bytes_allocated - statistics.device_bytes_freed);
+#else
+    return 0;
+#endif  // IREE_STATISTICS_ENABLE
+  }
+};
+
+TEST_F(SlabAllocatorTest, InvalidParams) {
+  iree_hal_slab_allocator_params_t params;
+  iree_hal_slab_allocator_params_initialize(&params);
+  params.slab_size = params.max_block_size + 1;
+  iree_hal_allocator_t* invalid_allocator = NULL;
+  EXPECT_THAT(Status(iree_hal_slab_allocator_create(
+                  heap_allocator, &params, host_allocator, &invalid_allocator)),
+              StatusIs(StatusCode::kInvalidArgument));
+}
+
+// Tests that small buffers are suballocated from a shared slab and don't alias.
+TEST_F(SlabAllocatorTest, SuballocateFromSlab) {
+  // 4096 / 64 = 64 blocks per slab.
+  std::vector<iree_hal_buffer_t*> buffers;
+  for (int i = 0; i < 64; ++i) {
+    buffers.push_back(Allocate(33));
+    EXPECT_EQ(33, iree_hal_buffer_byte_length(buffers.back()));
+  }
+  iree_hal_buffer_t* slab_buffer = iree_hal_buffer_allocated_buffer(buffers[0]);
+  for (int i = 0; i < 64; ++i) {
+    EXPECT_EQ(slab_buffer, iree_hal_buffer_allocated_buffer(buffers[i]));
+    EXPECT_EQ(0, iree_hal_buffer_byte_offset(buffers[i]) % 64);
+    uint8_t pattern = (uint8_t)i;
+    IREE_ASSERT_OK(iree_hal_buffer_fill(buffers[i], 0, IREE_WHOLE_BUFFER,
+                                        &pattern, sizeof(pattern)));
+  }
+#if IREE_STATISTICS_ENABLE
+  EXPECT_EQ(kSlabSize, QueryBaseBytesLive());
+#endif  // IREE_STATISTICS_ENABLE
+
+  // Contents must not have been overwritten by neighboring blocks.
+  for (int i = 0; i < 64; ++i) {
+    uint8_t data[33];
+    IREE_ASSERT_OK(
+        iree_hal_buffer_read_data(buffers[i], 0, data, sizeof(data)));
+    for (size_t j = 0; j < sizeof(data); ++j) {
+      ASSERT_EQ((uint8_t)i, data[j]);
+    }
+  }
+
+  // Freed blocks are reused.
+  iree_device_size_t freed_offset = iree_hal_buffer_byte_offset(buffers[7]);
+  iree_hal_buffer_release(buffers[7]);
+  buffers[7] = Allocate(64);
+  EXPECT_EQ(slab_buffer, iree_hal_buffer_allocated_buffer(buffers[7]));
+  EXPECT_EQ(freed_offset, iree_hal_buffer_byte_offset(buffers[7]));
+
+  // The slab is full and the next allocation needs a new one.
+  iree_hal_buffer_t* overflow_buffer = Allocate(64);
+  EXPECT_NE(slab_buffer, iree_hal_buffer_allocated_buffer(overflow_buffer));
+#if IREE_STATISTICS_ENABLE
+  EXPECT_EQ(2 * kSlabSize, QueryBaseBytesLive());
+#endif  // IREE_STATISTICS_ENABLE
+  iree_hal_buffer_release(overflow_buffer);
+
+  for (auto* buffer : buffers) iree_hal_buffer_release(buffer);
+  IREE_ASSERT_OK(iree_hal_allocator_trim(allocator));
+#if IREE_STATISTICS_ENABLE
+  EXPECT_EQ(0, QueryBaseBytesLive());
+#endif  // IREE_STATISTICS_ENABLE
+}
+
+// Tests that subspans of a block keep the block reserved after it is released.
+TEST_F(SlabAllocatorTest, SubspanRetainsBlock) {
+  iree_hal_buffer_t* block_buffer = Allocate(64);
+  iree_hal_buffer_t* subspan_buffer = NULL;
+  IREE_ASSERT_OK(
+      iree_hal_buffer_subspan(block_buffer, 16, 32, &subspan_buffer));
+  iree_device_size_t subspan_offset =
+      iree_hal_buffer_byte_offset(subspan_buffer);
+  iree_hal_buffer_release(block_buffer);
+
+  // The new block must not overlap the range still referenced by the subspan.
+  iree_hal_buffer_t* new_buffer = Allocate(64);
+  iree_device_size_t new_offset = iree_hal_buffer_byte_offset(new_buffer);
+  EXPECT_TRUE(iree_hal_buffer_allocated_buffer(new_buffer) !=
+                  iree_hal_buffer_allocated_buffer(subspan_buffer) ||
+              new_offset + 64 <= subspan_offset ||
+              subspan_offset + 32 <= new_offset);
+
+  uint8_t pattern = 0xAB;
+  IREE_ASSERT_OK(iree_hal_buffer_fill(subspan_buffer, 0, IREE_WHOLE_BUFFER,
+                                      &pattern, sizeof(pattern)));
+  uint8_t other_pattern = 0xCD;
+  IREE_ASSERT_OK(iree_hal_buffer_fill(new_buffer, 0, IREE_WHOLE_BUFFER,
+                                      &other_pattern, sizeof(other_pattern)));
+  uint8_t data[32];
+  IREE_ASSERT_OK(
+      iree_hal_buffer_read_data(subspan_buffer, 0, data, sizeof(data)));
+  for (size_t i = 0; i < sizeof(data); ++i) {
+    ASSERT_EQ(pattern, data[i]);
+  }
+
+  // Releasing the subspan returns the block to the slab.
+  iree_hal_buffer_release(subspan_buffer);
+  iree_hal_buffer_t* reused_buffer = Allocate(64);
+  EXPECT_EQ(subspan_offset - 16, iree_hal_buffer_byte_offset(reused_buffer));
+  iree_hal_buffer_release(reused_buffer);
+  iree_hal_buffer_release(new_buffer);
+}
+
+// Tests that each block size gets its own slabs.
+TEST_F(SlabAllocatorTest, BlockClasses) {
+  iree_hal_buffer_t* small_buffer = Allocate(64);
+  iree_hal_buffer_t* large_buffer = Allocate(1000);
+  EXPECT_NE(iree_hal_buffer_allocated_buffer(small_buffer),
+            iree_hal_buffer_allocated_buffer(large_buffer));
+  EXPECT_EQ(0, iree_hal_buffer_byte_offset(large_buffer) % 1024);
+  iree_hal_buffer_release(small_buffer);
+  iree_hal_buffer_release(large_buffer);
+}
+
+// Tests that only one empty slab is retained per block class.
+TEST_F(SlabAllocatorTest, ReleaseEmptySlabs) {
+  // 4096 / 1024 = 4 blocks per slab; allocate 3 slabs worth.
+  std::vector<iree_hal_buffer_t*> buffers;
+  for (int i = 0; i < 12; ++i) buffers.push_back(Allocate(1024));
+#if IREE_STATISTICS_ENABLE
+  EXPECT_EQ(3 * kSlabSize, QueryBaseBytesLive());
+#endif  // IREE_STATISTICS_ENABLE
+  for (auto* buffer : buffers) iree_hal_buffer_release(buffer);
+#if IREE_STATISTICS_ENABLE
+  EXPECT_EQ(kSlabSize, QueryBaseBytesLive());
+#endif  // IREE_STATISTICS_ENABLE
+}
+
+// Tests that large allocations and those with initial data are passed through.
+TEST_F(SlabAllocatorTest, PassThrough) {
+  iree_hal_buffer_t* large_buffer = Allocate(1025);
+  EXPECT_EQ(large_buffer, iree_hal_buffer_allocated_buffer(large_buffer));
+  iree_hal_buffer_release(large_buffer);
+
+  uint8_t initial_data[16] = {0};
+  iree_hal_buffer_t* constant_buffer = NULL;
+  IREE_ASSERT_OK(iree_hal_allocator_allocate_buffer(
+      allocator, kMemoryType, kUsage, sizeof(initial_data),
+      iree_make_const_byte_span(initial_data, sizeof(initial_data)),
+      &constant_buffer));
+  EXPECT_EQ(constant_buffer, iree_hal_buffer_allocated_buffer(constant_buffer));
+  iree_hal_buffer_release(constant_buffer);
+}
+
+}  // namespace
+}  // namespace hal
+}  // namespace iree
@@ -156,12 +156,75 @@ enum iree_hal_vulkan_device_flag_bits_t {
   // May be removed in future versions when timeline semaphores can be assumed
   // present on all platforms (looking at you, Android ಠ_ಠ).
   IREE_HAL_VULKAN_DEVICE_FORCE_TIMELINE_SEMAPHORE_EMULATION = 1u << 0,
+
+  // Allows allocations to exceed the memory budget of the heap they are made
+  // from. By default allocations that would exceed the budget (as reported by
+  // VK_EXT_memory_budget or estimated from the heap size) fail with
+  // IREE_STATUS_RESOURCE_EXHAUSTED instead of relying on the implementation or
+  // platform to handle oversubscription.
+  IREE_HAL_VULKAN_DEVICE_IGNORE_MEMORY_BUDGET = 1u << 1,
 };
 typedef uint32_t iree_hal_vulkan_device_flags_t;
 
+// Parameters of a memory pool dedicated to one usage class of allocations.
+// Segregating allocations with different lifetimes (long-lived constants,
+// short-lived transients, and staging buffers) into their own blocks reduces
+// fragmentation of the default pools.
+typedef struct iree_hal_vulkan_memory_pool_params_t {
+  // Size in bytes of each block of device memory the pool suballocates from.
+  // 0 disables the pool and allocations of its class use the default pools.
+  iree_device_size_t block_size;
+  // Maximum size in bytes of device memory the pool may hold, rounded up to a
+  // whole number of blocks. Allocations that do not fit fail with
+  // IREE_STATUS_RESOURCE_EXHAUSTED. 0 is unlimited.
+  iree_device_size_t max_size;
+} iree_hal_vulkan_memory_pool_params_t;
+
 typedef struct iree_hal_vulkan_device_options_t {
   // Flags controlling device behavior.
   iree_hal_vulkan_device_flags_t flags;
+
+  // Number of threads used to create executable pipelines asynchronously.
+  // Executables prepared with aliased data have their pipelines created in
+  // the background and dispatches block only on the executables they use.
+  // 0 creates all pipelines synchronously when the executable is prepared.
+  iree_host_size_t executable_load_worker_count;
+
+  // Optional directory used to persist the device VkPipelineCache across
+  // processes. The cache file is keyed by the physical device and driver
+  // version so the directory may be shared by multiple devices. The directory
+  // must exist. Empty disables persistent caching. The path is copied by
+  // drivers and devices and need not outlive their creation.
+  iree_string_view_t executable_cache_path;
+
+  // Number of dispatches of an entry point with the same push constant values
+  // after which a pipeline specialized on those values is created. Only
+  // applies to executables compiled with specializable push constants
+  // (`--iree-vulkan-specialize-push-constants`) and allows drivers to fold
+  // values such as dynamic dimensions. Specialized pipelines are created while
+  // recording the dispatch and persisted in the pipeline cache. 0 disables
+  // specialization.
+  uint32_t pipeline_specialization_threshold;
+
+  // Capacity in bytes of the ring buffer used to stage host-to-device uploads
+  // (iree_hal_device_transfer_range and buffer initial data) into buffers that
+  // are not host-mappable. Staged uploads are copied on the transfer queue and
+  // return once the data has been staged; subsequent submissions wait on the
+  // copies with semaphores such that uploads overlap with in-flight work.
+  // Uploads larger than the capacity are split. 0 performs all uploads
+  // synchronously. Requires native timeline semaphores.
+  iree_device_size_t staging_buffer_capacity;
+
+  // Preferred size in bytes of the blocks of the default memory pools of
+  // heaps larger than 1GB. Smaller heaps use blocks of 1/8th their size.
+  iree_device_size_t large_heap_block_size;
+
+  // Pool for device-local buffers with IREE_HAL_BUFFER_USAGE_CONSTANT.
+  iree_hal_vulkan_memory_pool_params_t constant_pool;
+  // Pool for device-local buffers with IREE_HAL_MEMORY_TYPE_TRANSIENT.
+  iree_hal_vulkan_memory_pool_params_t transient_pool;
+  // Pool for host-local transfer buffers used to stage uploads and readbacks.
+  iree_hal_vulkan_memory_pool_params_t staging_pool;
 } iree_hal_vulkan_device_options_t;
 
 IREE_API_EXPORT void iree_hal_vulkan_device_options_initialize(
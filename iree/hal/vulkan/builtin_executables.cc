@@ -160,6 +160,7 @@ iree_status_t BuiltinExecutables::FillBufferUnaligned(
 
   iree_hal_descriptor_set_binding_t binding;
   binding.binding = 0;
+  binding.buffer_slot = 0;
   binding.buffer = target_buffer;
   binding.offset = 0;
   binding.length = IREE_WHOLE_BUFFER;
@@ -24,6 +24,41 @@ namespace vulkan {
 
 namespace {
 
+static void PopulateDescriptorBufferInfo(
+    const iree_hal_descriptor_set_binding_t& binding,
+    VkDescriptorBufferInfo* out_info) {
+  out_info->buffer = iree_hal_vulkan_vma_buffer_handle(
+      iree_hal_buffer_allocated_buffer(binding.buffer));
+  out_info->offset =
+      iree_hal_buffer_byte_offset(binding.buffer) + binding.offset;
+  if (binding.length == IREE_WHOLE_BUFFER) {
+    out_info->range = VK_WHOLE_SIZE;
+  } else {
+    // Round up to a multiple of 32-bit. 32-bit is the most native bitwidth on
+    // GPUs; it has the best support compared to other bitwidths. We use VMA
+    // to manage GPU memory for us and VMA should already handled proper
+    // alignment when performing allocations; here we just need to provide the
+    // proper "view" to Vulkan drivers over the allocated memory.
+    //
+    // Note this is needed because we can see unusal buffers like
+    // tensor<3xi8>. Depending on GPU capabilities, this might not always be
+    // directly supported by the hardware. Under such circumstances, we need
+    // to emulate i8 support with i32. Shader CodeGen takes care of that: the
+    // shader will read the buffer as tensor<i32> and perform bit shifts to
+    // extract each byte and conduct computations. The extra additional byte
+    // is read but not really used by the shader. Here in application we need
+    // to match the ABI and provide the buffer as 32-bit aligned, otherwise
+    // the whole read by the shader is considered as out of bounds per the
+    // Vulkan spec. See
+    // https://github.com/google/iree/issues/2022#issuecomment-640617234 for
+    // more details.
+    out_info->range = iree_device_align(
+        std::min(binding.length, iree_hal_buffer_byte_length(binding.buffer) -
+                                     binding.offset),
+        4);
+  }
+}
+
 static void PopulateDescriptorSetWriteInfos(
     iree_host_size_t binding_count,
     const iree_hal_descriptor_set_binding_t* bindings, VkDescriptorSet dst_set,
@@ -38,36 +73,7 @@ static void PopulateDescriptorSetWriteInfos(
     const auto& binding = bindings[i];
 
     auto& buffer_info = buffer_infos[i];
-    buffer_info.buffer = iree_hal_vulkan_vma_buffer_handle(
-        iree_hal_buffer_allocated_buffer(binding.buffer));
-    buffer_info.offset =
-        iree_hal_buffer_byte_offset(binding.buffer) + binding.offset;
-    if (binding.length == IREE_WHOLE_BUFFER) {
-      buffer_info.range = VK_WHOLE_SIZE;
-    } else {
-      // Round up to a multiple of 32-bit. 32-bit is the most native bitwidth on
-      // GPUs; it has the best support compared to other bitwidths. We use VMA
-      // to manage GPU memory for us and VMA should already handled proper
-      // alignment when performing allocations; here we just need to provide the
-      // proper "view" to Vulkan drivers over the allocated memory.
-      //
-      // Note this is needed because we can see unusal buffers like
-      // tensor<3xi8>. Depending on GPU capabilities, this might not always be
-      // directly supported by the hardware. Under such circumstances, we need
-      // to emulate i8 support with i32. Shader CodeGen takes care of that: the
-      // shader will read the buffer as tensor<i32> and perform bit shifts to
-      // extract each byte and conduct computations. The extra additional byte
-      // is read but not really used by the shader. Here in application we need
-      // to match the ABI and provide the buffer as 32-bit aligned, otherwise
-      // the whole read by the shader is considered as out of bounds per the
-      // Vulkan spec. See
-      // https://github.com/google/iree/issues/2022#issuecomment-640617234 for
-      // more details.
-      buffer_info.range = iree_device_align(
-          std::min(binding.length, iree_hal_buffer_byte_length(binding.buffer) -
-                                       binding.offset),
-          4);
-    }
+    PopulateDescriptorBufferInfo(binding, &buffer_info);
 
     auto& write_info = write_infos[i];
     write_info.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
@@ -86,6 +92,27 @@ static void PopulateDescriptorSetWriteInfos(
   *out_infos = write_infos.data();
 }
 
+// Populates the descriptor data read by |update_template| from |bindings|.
+// Returns NULL if the template cannot be used because the bindings do not
+// cover the whole descriptor set.
+static const VkDescriptorBufferInfo* PopulateDescriptorUpdateTemplateData(
+    const iree_hal_vulkan_descriptor_update_template_t* update_template,
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_binding_t* bindings, Arena* arena) {
+  if (!update_template || binding_count != update_template->binding_count) {
+    return nullptr;
+  }
+  arena->Reset();
+  auto buffer_infos =
+      arena->AllocateSpan<VkDescriptorBufferInfo>(update_template->slot_count);
+  for (iree_host_size_t i = 0; i < binding_count; ++i) {
+    const auto& binding = bindings[i];
+    if (binding.binding >= update_template->slot_count) return nullptr;
+    PopulateDescriptorBufferInfo(binding, &buffer_infos[binding.binding]);
+  }
+  return buffer_infos.data();
+}
+
 static VkDescriptorSetAllocateInfo PopulateDescriptorSetsAllocateInfo(
     const DescriptorPool& descriptor_pool,
     iree_hal_descriptor_set_layout_t* set_layout) {
@@ -191,6 +218,25 @@ iree_status_t DescriptorSetArena::BindDescriptorSet(
                        "vkAllocateDescriptorSets");
   }
 
+  // Update the whole set with a single template call when possible. This
+  // avoids building and validating VkWriteDescriptorSet structs per binding.
+  const iree_hal_vulkan_descriptor_update_template_t* update_template =
+      iree_hal_vulkan_native_executable_layout_update_template(
+          executable_layout, set);
+  const VkDescriptorBufferInfo* template_data =
+      PopulateDescriptorUpdateTemplateData(update_template, binding_count,
+                                           bindings, &scratch_arena_);
+  if (template_data) {
+    syms().vkUpdateDescriptorSetWithTemplate(
+        *logical_device_, descriptor_set, update_template->handle,
+        template_data);
+    syms().vkCmdBindDescriptorSets(
+        command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+        iree_hal_vulkan_native_executable_layout_handle(executable_layout),
+        set, 1, &descriptor_set, 0, nullptr);
+    return iree_ok_status();
+  }
+
   // Get a list of VkWriteDescriptorSet structs with all bound buffers.
   iree_host_size_t write_info_count = 0;
   VkWriteDescriptorSet* write_infos = NULL;
@@ -225,6 +271,20 @@ void DescriptorSetArena::PushDescriptorSet(
   VkPipelineLayout device_executable_layout =
       iree_hal_vulkan_native_executable_layout_handle(executable_layout);
 
+  // Push the whole set with a single template call when possible.
+  const iree_hal_vulkan_descriptor_update_template_t* update_template =
+      iree_hal_vulkan_native_executable_layout_update_template(
+          executable_layout, set);
+  const VkDescriptorBufferInfo* template_data =
+      PopulateDescriptorUpdateTemplateData(update_template, binding_count,
+                                           bindings, &scratch_arena_);
+  if (template_data) {
+    syms().vkCmdPushDescriptorSetWithTemplateKHR(
+        command_buffer, update_template->handle, device_executable_layout, set,
+        template_data);
+    return;
+  }
+
   // Get a list of VkWriteDescriptorSet structs with all bound buffers.
   iree_host_size_t write_info_count = 0;
   VkWriteDescriptorSet* write_infos = NULL;
@@ -28,6 +28,9 @@
 
 using namespace iree::hal::vulkan;
 
+// Maximum number of regions coalesced into a single vkCmdCopyBuffer.
+#define IREE_HAL_VULKAN_MAX_COALESCED_COPY_REGIONS 32
+
 // Command buffer implementation that directly maps to VkCommandBuffer.
 // This records the commands on the calling thread without additional threading
 // indirection.
@@ -35,6 +38,8 @@ typedef struct iree_hal_vulkan_direct_command_buffer_t {
   iree_hal_command_buffer_t base;
   VkDeviceHandle* logical_device;
   iree_hal_vulkan_tracing_context_t* tracing_context;
+  // Records dispatch queries while device profiling is active. May be NULL.
+  iree_hal_vulkan_dispatch_profiler_t* dispatch_profiler;
   iree_arena_block_pool_t* block_pool;
 
   VkCommandPoolHandle* command_pool;
@@ -57,13 +62,31 @@ typedef struct iree_hal_vulkan_direct_command_buffer_t {
   BuiltinExecutables* builtin_executables;
 
   // Shadow copy of push constants used during normal operation, for restoring
-  // after builtin_executables uses vkCmdPushConstants. Size must be greater
+  // after builtin_executables uses vkCmdPushConstants and for selecting
+  // pipelines specialized on the push constant values. Size must be greater
   // than or equal to the push constant memory used by builtin_executables.
   // TODO(scotttodd): use [maxPushConstantsSize - 16, maxPushConstantsSize]
   //                  instead of [0, 16] to reduce frequency of updates
-  uint8_t push_constants_storage[IREE_HAL_VULKAN_BUILTIN_PUSH_CONSTANT_COUNT];
+  uint32_t push_constants_storage
+      [IREE_HAL_VULKAN_MAX_SPECIALIZED_PUSH_CONSTANT_COUNT];
+
+  // Consecutive copies between the same pair of buffers are batched into a
+  // single multi-region vkCmdCopyBuffer. HAL commands are unordered without an
+  // intervening barrier so this preserves semantics as long as the batch is
+  // flushed before any other command is recorded.
+  struct {
+    VkBuffer source_buffer;
+    VkBuffer target_buffer;
+    uint32_t region_count;
+    VkBufferCopy regions[IREE_HAL_VULKAN_MAX_COALESCED_COPY_REGIONS];
+  } pending_copies;
 } iree_hal_vulkan_direct_command_buffer_t;
 
+static_assert(IREE_HAL_VULKAN_MAX_SPECIALIZED_PUSH_CONSTANT_COUNT *
+                      sizeof(uint32_t) >=
+                  IREE_HAL_VULKAN_BUILTIN_PUSH_CONSTANT_COUNT,
+              "push constant shadow must cover the builtin push constants");
+
 namespace {
 extern const iree_hal_command_buffer_vtable_t
     iree_hal_vulkan_direct_command_buffer_vtable;
@@ -85,6 +108,7 @@ iree_status_t iree_hal_vulkan_direct_command_buffer_allocate(
     iree_hal_command_category_t command_categories,
     iree_hal_queue_affinity_t queue_affinity,
     iree_hal_vulkan_tracing_context_t* tracing_context,
+    iree_hal_vulkan_dispatch_profiler_t* dispatch_profiler,
     iree::hal::vulkan::DescriptorPoolCache* descriptor_pool_cache,
     iree::hal::vulkan::BuiltinExecutables* builtin_executables,
     iree_arena_block_pool_t* block_pool,
@@ -117,6 +141,7 @@ iree_status_t iree_hal_vulkan_direct_command_buffer_allocate(
         &iree_hal_vulkan_direct_command_buffer_vtable, &command_buffer->base);
     command_buffer->logical_device = logical_device;
     command_buffer->tracing_context = tracing_context;
+    command_buffer->dispatch_profiler = dispatch_profiler;
     command_buffer->block_pool = block_pool;
     command_buffer->command_pool = command_pool;
     command_buffer->handle = handle;
@@ -127,6 +152,7 @@ iree_status_t iree_hal_vulkan_direct_command_buffer_allocate(
     new (&command_buffer->descriptor_set_group) DescriptorSetGroup();
 
     command_buffer->builtin_executables = builtin_executables;
+    command_buffer->pending_copies.region_count = 0;
     status = iree_hal_resource_set_allocate(block_pool,
                                             &command_buffer->resource_set);
   }
@@ -147,6 +173,20 @@ static void iree_hal_vulkan_direct_command_buffer_reset(
   // in-flight so this is safe.
   IREE_IGNORE_ERROR(command_buffer->descriptor_set_group.Reset());
   iree_hal_resource_set_reset(command_buffer->resource_set);
+  command_buffer->pending_copies.region_count = 0;
+}
+
+// Records any copies batched by copy_buffer. Must be called before recording
+// any other command into the VkCommandBuffer.
+static void iree_hal_vulkan_direct_command_buffer_flush_copies(
+    iree_hal_vulkan_direct_command_buffer_t* command_buffer) {
+  if (command_buffer->pending_copies.region_count == 0) return;
+  command_buffer->syms->vkCmdCopyBuffer(
+      command_buffer->handle, command_buffer->pending_copies.source_buffer,
+      command_buffer->pending_copies.target_buffer,
+      command_buffer->pending_copies.region_count,
+      command_buffer->pending_copies.regions);
+  command_buffer->pending_copies.region_count = 0;
 }
 
 bool iree_hal_vulkan_direct_command_buffer_isa(
@@ -204,10 +244,17 @@ static iree_status_t iree_hal_vulkan_direct_command_buffer_begin(
   VkCommandBufferBeginInfo begin_info;
   begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
   begin_info.pNext = NULL;
-  begin_info.flags = iree_all_bits_set(command_buffer->base.mode,
-                                       IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT)
-                         ? VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
-                         : 0;
+  begin_info.flags = 0;
+  if (iree_all_bits_set(command_buffer->base.mode,
+                        IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT)) {
+    begin_info.flags |= VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  } else if (iree_all_bits_set(command_buffer->base.mode,
+                               IREE_HAL_COMMAND_BUFFER_MODE_REUSABLE)) {
+    // Reusable command buffers may be resubmitted before the prior submission
+    // has completed on the device (ordered by semaphores) and must be allowed
+    // to be pending multiple times.
+    begin_info.flags |= VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+  }
   begin_info.pInheritanceInfo = NULL;
   VK_RETURN_IF_ERROR(command_buffer->syms->vkBeginCommandBuffer(
                          command_buffer->handle, &begin_info),
@@ -228,6 +275,8 @@ static iree_status_t iree_hal_vulkan_direct_command_buffer_end(
   iree_hal_vulkan_direct_command_buffer_t* command_buffer =
       iree_hal_vulkan_direct_command_buffer_cast(base_command_buffer);
 
+  iree_hal_vulkan_direct_command_buffer_flush_copies(command_buffer);
+
   IREE_VULKAN_TRACE_ZONE_END(command_buffer->tracing_context,
                              command_buffer->handle);
 
@@ -248,6 +297,7 @@ static void iree_hal_vulkan_direct_command_buffer_begin_debug_group(
     const iree_hal_label_location_t* location) {
   iree_hal_vulkan_direct_command_buffer_t* command_buffer =
       iree_hal_vulkan_direct_command_buffer_cast(base_command_buffer);
+  iree_hal_vulkan_direct_command_buffer_flush_copies(command_buffer);
   IREE_VULKAN_TRACE_ZONE_BEGIN_EXTERNAL(
       command_buffer->tracing_context, command_buffer->handle,
       location ? location->file.data : NULL, location ? location->file.size : 0,
@@ -278,6 +328,7 @@ static void iree_hal_vulkan_direct_command_buffer_end_debug_group(
     iree_hal_command_buffer_t* base_command_buffer) {
   iree_hal_vulkan_direct_command_buffer_t* command_buffer =
       iree_hal_vulkan_direct_command_buffer_cast(base_command_buffer);
+  iree_hal_vulkan_direct_command_buffer_flush_copies(command_buffer);
   if (command_buffer->syms->vkCmdEndDebugUtilsLabelEXT) {
     command_buffer->syms->vkCmdEndDebugUtilsLabelEXT(command_buffer->handle);
   }
@@ -361,6 +412,8 @@ static iree_status_t iree_hal_vulkan_direct_command_buffer_execution_barrier(
   iree_allocator_t host_allocator =
       command_buffer->logical_device->host_allocator();
 
+  iree_hal_vulkan_direct_command_buffer_flush_copies(command_buffer);
+
   iree_inline_array(VkMemoryBarrier, memory_barrier_infos, memory_barrier_count,
                     host_allocator);
   for (int i = 0; i < memory_barrier_count; ++i) {
@@ -417,6 +470,8 @@ static iree_status_t iree_hal_vulkan_direct_command_buffer_signal_event(
   IREE_RETURN_IF_ERROR(
       iree_hal_resource_set_insert(command_buffer->resource_set, 1, &event));
 
+  iree_hal_vulkan_direct_command_buffer_flush_copies(command_buffer);
+
   command_buffer->syms->vkCmdSetEvent(
       command_buffer->handle, iree_hal_vulkan_native_event_handle(event),
       iree_hal_vulkan_convert_pipeline_stage_flags(source_stage_mask));
@@ -433,6 +488,8 @@ static iree_status_t iree_hal_vulkan_direct_command_buffer_reset_event(
   IREE_RETURN_IF_ERROR(
       iree_hal_resource_set_insert(command_buffer->resource_set, 1, &event));
 
+  iree_hal_vulkan_direct_command_buffer_flush_copies(command_buffer);
+
   command_buffer->syms->vkCmdResetEvent(
       command_buffer->handle, iree_hal_vulkan_native_event_handle(event),
       iree_hal_vulkan_convert_pipeline_stage_flags(source_stage_mask));
@@ -457,6 +514,8 @@ static iree_status_t iree_hal_vulkan_direct_command_buffer_wait_events(
   IREE_RETURN_IF_ERROR(iree_hal_resource_set_insert(
       command_buffer->resource_set, event_count, events));
 
+  iree_hal_vulkan_direct_command_buffer_flush_copies(command_buffer);
+
   iree_inline_array(VkEvent, event_handles, event_count, host_allocator);
   for (int i = 0; i < event_count; ++i) {
     *iree_inline_array_at(event_handles, i) =
@@ -553,6 +612,8 @@ static iree_status_t iree_hal_vulkan_direct_command_buffer_fill_buffer(
   IREE_RETURN_IF_ERROR(iree_hal_resource_set_insert(
       command_buffer->resource_set, 1, &target_buffer));
 
+  iree_hal_vulkan_direct_command_buffer_flush_copies(command_buffer);
+
   // vkCmdFillBuffer requires a 4 byte alignment for the offset, pattern, and
   // length. We use a polyfill here that fills the unaligned start and end of
   // fill operations, if needed.
@@ -610,6 +671,8 @@ static iree_status_t iree_hal_vulkan_direct_command_buffer_update_buffer(
   IREE_RETURN_IF_ERROR(iree_hal_resource_set_insert(
       command_buffer->resource_set, 1, &target_buffer));
 
+  iree_hal_vulkan_direct_command_buffer_flush_copies(command_buffer);
+
   // Vulkan only allows updates of <= 65536 because you really, really, really
   // shouldn't do large updates like this (as it wastes command buffer space and
   // may be slower than just using write-through mapped memory). The
@@ -651,9 +714,31 @@ static iree_status_t iree_hal_vulkan_direct_command_buffer_copy_buffer(
   region.srcOffset = iree_hal_buffer_byte_offset(source_buffer) + source_offset;
   region.dstOffset = iree_hal_buffer_byte_offset(target_buffer) + target_offset;
   region.size = length;
-  command_buffer->syms->vkCmdCopyBuffer(command_buffer->handle,
-                                        source_device_buffer,
-                                        target_device_buffer, 1, &region);
+
+  // Copies within the same buffer are recorded directly: the source and target
+  // regions of a single vkCmdCopyBuffer must not overlap and checking that
+  // across a batch isn't worth it for what is a rare case.
+  if (source_device_buffer == target_device_buffer) {
+    iree_hal_vulkan_direct_command_buffer_flush_copies(command_buffer);
+    command_buffer->syms->vkCmdCopyBuffer(command_buffer->handle,
+                                          source_device_buffer,
+                                          target_device_buffer, 1, &region);
+    return iree_ok_status();
+  }
+
+  // Start a new batch if this copy is between a different pair of buffers or
+  // the current batch is full.
+  auto& pending_copies = command_buffer->pending_copies;
+  if (pending_copies.region_count > 0 &&
+      (pending_copies.source_buffer != source_device_buffer ||
+       pending_copies.target_buffer != target_device_buffer ||
+       pending_copies.region_count ==
+           IREE_ARRAYSIZE(pending_copies.regions))) {
+    iree_hal_vulkan_direct_command_buffer_flush_copies(command_buffer);
+  }
+  pending_copies.source_buffer = source_device_buffer;
+  pending_copies.target_buffer = target_device_buffer;
+  pending_copies.regions[pending_copies.region_count++] = region;
 
   return iree_ok_status();
 }
@@ -666,10 +751,10 @@ static iree_status_t iree_hal_vulkan_direct_command_buffer_push_constants(
       iree_hal_vulkan_direct_command_buffer_cast(base_command_buffer);
 
   iree_host_size_t storage_size =
-      IREE_ARRAYSIZE(command_buffer->push_constants_storage);
+      sizeof(command_buffer->push_constants_storage);
   if (offset < storage_size) {
-    memcpy(command_buffer->push_constants_storage + offset, values,
-           std::min(values_length, storage_size) - offset);
+    memcpy((uint8_t*)command_buffer->push_constants_storage + offset, values,
+           std::min(values_length, storage_size - offset));
   }
 
   command_buffer->syms->vkCmdPushConstants(
@@ -745,6 +830,8 @@ static iree_status_t iree_hal_vulkan_direct_command_buffer_dispatch(
   iree_hal_vulkan_direct_command_buffer_t* command_buffer =
       iree_hal_vulkan_direct_command_buffer_cast(base_command_buffer);
 
+  iree_hal_vulkan_direct_command_buffer_flush_copies(command_buffer);
+
   IREE_TRACE({
     iree_hal_vulkan_source_location_t source_location;
     iree_hal_vulkan_native_executable_entry_point_source_location(
@@ -762,14 +849,21 @@ static iree_status_t iree_hal_vulkan_direct_command_buffer_dispatch(
   // Get the compiled and linked pipeline for the specified entry point and
   // bind it to the command buffer.
   VkPipeline pipeline_handle = VK_NULL_HANDLE;
-  IREE_RETURN_IF_ERROR(
-      iree_hal_vulkan_native_executable_pipeline_for_entry_point(
-          executable, entry_point, &pipeline_handle));
+  IREE_RETURN_IF_ERROR(iree_hal_vulkan_native_executable_pipeline_for_dispatch(
+      executable, entry_point,
+      IREE_ARRAYSIZE(command_buffer->push_constants_storage),
+      command_buffer->push_constants_storage, &pipeline_handle));
   command_buffer->syms->vkCmdBindPipeline(
       command_buffer->handle, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_handle);
 
+  const uint32_t workgroup_count[3] = {workgroup_x, workgroup_y, workgroup_z};
+  uint32_t profile_slot = iree_hal_vulkan_dispatch_profiler_record_begin(
+      command_buffer->dispatch_profiler, command_buffer->handle, executable,
+      entry_point, workgroup_count);
   command_buffer->syms->vkCmdDispatch(command_buffer->handle, workgroup_x,
                                       workgroup_y, workgroup_z);
+  iree_hal_vulkan_dispatch_profiler_record_end(
+      command_buffer->dispatch_profiler, command_buffer->handle, profile_slot);
 
   IREE_VULKAN_TRACE_ZONE_END(command_buffer->tracing_context,
                              command_buffer->handle);
@@ -789,6 +883,8 @@ static iree_status_t iree_hal_vulkan_direct_command_buffer_dispatch_indirect(
   IREE_RETURN_IF_ERROR(iree_hal_resource_set_insert(
       command_buffer->resource_set, IREE_ARRAYSIZE(resources), resources));
 
+  iree_hal_vulkan_direct_command_buffer_flush_copies(command_buffer);
+
   iree_hal_vulkan_source_location_t source_location;
   iree_hal_vulkan_native_executable_entry_point_source_location(
       executable, entry_point, &source_location);
@@ -801,17 +897,23 @@ static iree_status_t iree_hal_vulkan_direct_command_buffer_dispatch_indirect(
   // Get the compiled and linked pipeline for the specified entry point and
   // bind it to the command buffer.
   VkPipeline pipeline_handle = VK_NULL_HANDLE;
-  IREE_RETURN_IF_ERROR(
-      iree_hal_vulkan_native_executable_pipeline_for_entry_point(
-          executable, entry_point, &pipeline_handle));
+  IREE_RETURN_IF_ERROR(iree_hal_vulkan_native_executable_pipeline_for_dispatch(
+      executable, entry_point,
+      IREE_ARRAYSIZE(command_buffer->push_constants_storage),
+      command_buffer->push_constants_storage, &pipeline_handle));
   command_buffer->syms->vkCmdBindPipeline(
       command_buffer->handle, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_handle);
 
   VkBuffer workgroups_device_buffer = iree_hal_vulkan_vma_buffer_handle(
       iree_hal_buffer_allocated_buffer(workgroups_buffer));
   workgroups_offset += iree_hal_buffer_byte_offset(workgroups_buffer);
+  uint32_t profile_slot = iree_hal_vulkan_dispatch_profiler_record_begin(
+      command_buffer->dispatch_profiler, command_buffer->handle, executable,
+      entry_point, /*workgroup_count=*/NULL);
   command_buffer->syms->vkCmdDispatchIndirect(
       command_buffer->handle, workgroups_device_buffer, workgroups_offset);
+  iree_hal_vulkan_dispatch_profiler_record_end(
+      command_buffer->dispatch_profiler, command_buffer->handle, profile_slot);
 
   IREE_VULKAN_TRACE_ZONE_END(command_buffer->tracing_context,
                              command_buffer->handle);
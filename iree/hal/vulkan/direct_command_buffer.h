@@ -11,6 +11,7 @@
 #include "iree/hal/api.h"
 #include "iree/hal/vulkan/builtin_executables.h"
 #include "iree/hal/vulkan/descriptor_pool_cache.h"
+#include "iree/hal/vulkan/dispatch_profiler.h"
 #include "iree/hal/vulkan/handle_util.h"
 #include "iree/hal/vulkan/tracing.h"
 
@@ -32,6 +33,7 @@ iree_status_t iree_hal_vulkan_direct_command_buffer_allocate(
     iree_hal_command_category_t command_categories,
     iree_hal_queue_affinity_t queue_affinity,
     iree_hal_vulkan_tracing_context_t* tracing_context,
+    iree_hal_vulkan_dispatch_profiler_t* dispatch_profiler,
     iree::hal::vulkan::DescriptorPoolCache* descriptor_pool_cache,
     iree::hal::vulkan::BuiltinExecutables* builtin_executables,
     iree_arena_block_pool_t* block_pool,
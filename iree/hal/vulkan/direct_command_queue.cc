@@ -20,16 +20,81 @@ namespace iree {
 namespace hal {
 namespace vulkan {
 
+// Converts |timeout| to a relative timeout in nanoseconds for Vulkan waits.
+static iree_status_t ConvertTimeout(iree_timeout_t timeout,
+                                    uint64_t* out_timeout_ns) {
+  iree_time_t deadline_ns = iree_timeout_as_deadline_ns(timeout);
+  if (deadline_ns == IREE_TIME_INFINITE_PAST) {
+    // Do not wait.
+    *out_timeout_ns = 0;
+  } else if (deadline_ns == IREE_TIME_INFINITE_FUTURE) {
+    // Wait forever.
+    *out_timeout_ns = UINT64_MAX;
+  } else {
+    // Convert to relative time in nanoseconds.
+    // The implementation may not wait with this granularity (like by 10000x).
+    iree_time_t now_ns = iree_time_now();
+    if (deadline_ns < now_ns) {
+      return iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
+    }
+    *out_timeout_ns = (uint64_t)(deadline_ns - now_ns);
+  }
+  return iree_ok_status();
+}
+
+// static
+iree_status_t DirectCommandQueue::Create(
+    VkDeviceHandle* logical_device,
+    iree_hal_command_category_t supported_categories, VkQueue queue,
+    DirectCommandQueue** out_queue) {
+  *out_queue = nullptr;
+
+  VkSemaphoreTypeCreateInfo timeline_create_info;
+  timeline_create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+  timeline_create_info.pNext = nullptr;
+  timeline_create_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+  timeline_create_info.initialValue = 0;
+
+  VkSemaphoreCreateInfo create_info;
+  create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+  create_info.pNext = &timeline_create_info;
+  create_info.flags = 0;
+  VkSemaphore timeline_semaphore = VK_NULL_HANDLE;
+  VK_RETURN_IF_ERROR(logical_device->syms()->vkCreateSemaphore(
+                         *logical_device, &create_info,
+                         logical_device->allocator(), &timeline_semaphore),
+                     "vkCreateSemaphore");
+
+  *out_queue = new DirectCommandQueue(logical_device, supported_categories,
+                                      queue, timeline_semaphore);
+  return iree_ok_status();
+}
+
 DirectCommandQueue::DirectCommandQueue(
     VkDeviceHandle* logical_device,
-    iree_hal_command_category_t supported_categories, VkQueue queue)
-    : CommandQueue(logical_device, supported_categories, queue) {}
+    iree_hal_command_category_t supported_categories, VkQueue queue,
+    VkSemaphore timeline_semaphore)
+    : CommandQueue(logical_device, supported_categories, queue),
+      timeline_semaphore_(timeline_semaphore) {}
 
-DirectCommandQueue::~DirectCommandQueue() = default;
+DirectCommandQueue::~DirectCommandQueue() {
+  IREE_TRACE_SCOPE0("DirectCommandQueue::dtor");
+  iree_slim_mutex_lock(&queue_mutex_);
+  syms()->vkQueueWaitIdle(queue_);
+  std::vector<iree_hal_resource_t*> resources;
+  DrainRetainedResources(UINT64_MAX, &resources);
+  iree_slim_mutex_unlock(&queue_mutex_);
+  for (iree_hal_resource_t* resource : resources) {
+    iree_hal_resource_release(resource);
+  }
+  syms()->vkDestroySemaphore(*logical_device_, timeline_semaphore_,
+                             logical_device_->allocator());
+}
 
 iree_status_t DirectCommandQueue::TranslateBatchInfo(
     const iree_hal_submission_batch_t* batch, VkSubmitInfo* submit_info,
-    VkTimelineSemaphoreSubmitInfo* timeline_submit_info, Arena* arena) {
+    VkTimelineSemaphoreSubmitInfo* timeline_submit_info,
+    uint64_t** queue_semaphore_value, Arena* arena) {
   // TODO(benvanik): see if we can go to finer-grained stages.
   // For example, if this was just queue ownership transfers then we can use
   // the pseudo-stage of VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT.
@@ -49,15 +114,20 @@ iree_status_t DirectCommandQueue::TranslateBatchInfo(
     wait_dst_stage_masks[i] = dst_stage_mask;
   }
 
+  iree_host_size_t signal_count =
+      batch->signal_semaphores.count + (queue_semaphore_value ? 1 : 0);
   auto signal_semaphore_handles =
-      arena->AllocateSpan<VkSemaphore>(batch->signal_semaphores.count);
-  auto signal_semaphore_values =
-      arena->AllocateSpan<uint64_t>(batch->signal_semaphores.count);
+      arena->AllocateSpan<VkSemaphore>(signal_count);
+  auto signal_semaphore_values = arena->AllocateSpan<uint64_t>(signal_count);
   for (iree_host_size_t i = 0; i < batch->signal_semaphores.count; ++i) {
     signal_semaphore_handles[i] = iree_hal_vulkan_native_semaphore_handle(
         batch->signal_semaphores.semaphores[i]);
     signal_semaphore_values[i] = batch->signal_semaphores.payload_values[i];
   }
+  if (queue_semaphore_value) {
+    signal_semaphore_handles[signal_count - 1] = timeline_semaphore_;
+    *queue_semaphore_value = &signal_semaphore_values[signal_count - 1];
+  }
 
   auto command_buffer_handles =
       arena->AllocateSpan<VkCommandBuffer>(batch->command_buffer_count);
@@ -92,86 +162,204 @@ iree_status_t DirectCommandQueue::TranslateBatchInfo(
   return iree_ok_status();
 }
 
+iree_status_t DirectCommandQueue::TranslateBatchInfo2(
+    const iree_hal_submission_batch_t* batch, VkSubmitInfo2KHR* submit_info,
+    uint64_t** queue_semaphore_value, Arena* arena) {
+  // TODO(benvanik): see if we can go to finer-grained stages.
+  VkPipelineStageFlags2KHR wait_stage_mask =
+      VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR |
+      VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR;
+
+  auto wait_semaphore_infos = arena->AllocateSpan<VkSemaphoreSubmitInfoKHR>(
+      batch->wait_semaphores.count);
+  for (iree_host_size_t i = 0; i < batch->wait_semaphores.count; ++i) {
+    VkSemaphoreSubmitInfoKHR* info = &wait_semaphore_infos[i];
+    info->sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO_KHR;
+    info->pNext = nullptr;
+    info->semaphore = iree_hal_vulkan_native_semaphore_handle(
+        batch->wait_semaphores.semaphores[i]);
+    info->value = batch->wait_semaphores.payload_values[i];
+    info->stageMask = wait_stage_mask;
+    info->deviceIndex = 0;
+  }
+
+  iree_host_size_t signal_count =
+      batch->signal_semaphores.count + (queue_semaphore_value ? 1 : 0);
+  auto signal_semaphore_infos =
+      arena->AllocateSpan<VkSemaphoreSubmitInfoKHR>(signal_count);
+  for (iree_host_size_t i = 0; i < signal_count; ++i) {
+    VkSemaphoreSubmitInfoKHR* info = &signal_semaphore_infos[i];
+    info->sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO_KHR;
+    info->pNext = nullptr;
+    if (i < batch->signal_semaphores.count) {
+      info->semaphore = iree_hal_vulkan_native_semaphore_handle(
+          batch->signal_semaphores.semaphores[i]);
+      info->value = batch->signal_semaphores.payload_values[i];
+    } else {
+      info->semaphore = timeline_semaphore_;
+      info->value = 0;
+      *queue_semaphore_value = &info->value;
+    }
+    info->stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT_KHR;
+    info->deviceIndex = 0;
+  }
+
+  auto command_buffer_infos = arena->AllocateSpan<VkCommandBufferSubmitInfoKHR>(
+      batch->command_buffer_count);
+  for (iree_host_size_t i = 0; i < batch->command_buffer_count; ++i) {
+    VkCommandBufferSubmitInfoKHR* info = &command_buffer_infos[i];
+    info->sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO_KHR;
+    info->pNext = nullptr;
+    info->commandBuffer =
+        iree_hal_vulkan_direct_command_buffer_handle(batch->command_buffers[i]);
+    info->deviceMask = 0;
+  }
+
+  submit_info->sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2_KHR;
+  submit_info->pNext = nullptr;
+  submit_info->flags = 0;
+  submit_info->waitSemaphoreInfoCount =
+      static_cast<uint32_t>(wait_semaphore_infos.size());
+  submit_info->pWaitSemaphoreInfos = wait_semaphore_infos.data();
+  submit_info->commandBufferInfoCount =
+      static_cast<uint32_t>(command_buffer_infos.size());
+  submit_info->pCommandBufferInfos = command_buffer_infos.data();
+  submit_info->signalSemaphoreInfoCount =
+      static_cast<uint32_t>(signal_semaphore_infos.size());
+  submit_info->pSignalSemaphoreInfos = signal_semaphore_infos.data();
+
+  return iree_ok_status();
+}
+
+void DirectCommandQueue::DrainRetainedResources(
+    uint64_t completed_value,
+    std::vector<iree_hal_resource_t*>* out_resources) {
+  // Resources are retained in submission order so completed ones are a prefix.
+  auto it = retained_resources_.begin();
+  for (; it != retained_resources_.end() && it->value <= completed_value;
+       ++it) {
+    out_resources->push_back(it->resource);
+  }
+  retained_resources_.erase(retained_resources_.begin(), it);
+}
+
 iree_status_t DirectCommandQueue::Submit(
     iree_host_size_t batch_count, const iree_hal_submission_batch_t* batches) {
+  return SubmitAndRetain(batch_count, batches, 0, nullptr);
+}
+
+iree_status_t DirectCommandQueue::SubmitAndRetain(
+    iree_host_size_t batch_count, const iree_hal_submission_batch_t* batches,
+    iree_host_size_t resource_count, iree_hal_resource_t* const* resources) {
   IREE_TRACE_SCOPE0("DirectCommandQueue::Submit");
+  if (batch_count == 0) return iree_ok_status();
 
-  // Map the submission batches to VkSubmitInfos.
+  // Map the submission batches to Vk*SubmitInfos with a single call into the
+  // driver for all of them. The last batch additionally signals the queue
+  // timeline; the value is assigned under the lock so values are in order.
   // Note that we must keep all arrays referenced alive until submission
   // completes and since there are a bunch of them we use an arena.
   Arena arena(4 * 1024);
-  auto submit_infos = arena.AllocateSpan<VkSubmitInfo>(batch_count);
-  auto timeline_submit_infos =
-      arena.AllocateSpan<VkTimelineSemaphoreSubmitInfo>(batch_count);
-  for (int i = 0; i < batch_count; ++i) {
-    IREE_RETURN_IF_ERROR(TranslateBatchInfo(&batches[i], &submit_infos[i],
-                                            &timeline_submit_infos[i], &arena));
+  uint64_t* queue_semaphore_value = nullptr;
+  const bool use_submit2 =
+      logical_device_->enabled_extensions().synchronization_2;
+  Span<VkSubmitInfo2KHR> submit_infos2(nullptr, 0);
+  Span<VkSubmitInfo> submit_infos(nullptr, 0);
+  if (use_submit2) {
+    submit_infos2 = arena.AllocateSpan<VkSubmitInfo2KHR>(batch_count);
+    for (iree_host_size_t i = 0; i < batch_count; ++i) {
+      IREE_RETURN_IF_ERROR(TranslateBatchInfo2(
+          &batches[i], &submit_infos2[i],
+          i == batch_count - 1 ? &queue_semaphore_value : nullptr, &arena));
+    }
+  } else {
+    submit_infos = arena.AllocateSpan<VkSubmitInfo>(batch_count);
+    auto timeline_submit_infos =
+        arena.AllocateSpan<VkTimelineSemaphoreSubmitInfo>(batch_count);
+    for (iree_host_size_t i = 0; i < batch_count; ++i) {
+      IREE_RETURN_IF_ERROR(TranslateBatchInfo(
+          &batches[i], &submit_infos[i], &timeline_submit_infos[i],
+          i == batch_count - 1 ? &queue_semaphore_value : nullptr, &arena));
+    }
   }
 
+  std::vector<iree_hal_resource_t*> completed_resources;
   iree_slim_mutex_lock(&queue_mutex_);
-  iree_status_t status = VK_RESULT_TO_STATUS(
-      syms()->vkQueueSubmit(queue_, static_cast<uint32_t>(submit_infos.size()),
-                            submit_infos.data(), VK_NULL_HANDLE),
-      "vkQueueSubmit");
+  uint64_t value = timeline_value_ + 1;
+  *queue_semaphore_value = value;
+  iree_status_t status = iree_ok_status();
+  if (use_submit2) {
+    status = VK_RESULT_TO_STATUS(
+        syms()->vkQueueSubmit2KHR(queue_,
+                                  static_cast<uint32_t>(submit_infos2.size()),
+                                  submit_infos2.data(), VK_NULL_HANDLE),
+        "vkQueueSubmit2KHR");
+  } else {
+    status = VK_RESULT_TO_STATUS(
+        syms()->vkQueueSubmit(queue_,
+                              static_cast<uint32_t>(submit_infos.size()),
+                              submit_infos.data(), VK_NULL_HANDLE),
+        "vkQueueSubmit");
+  }
+  if (iree_status_is_ok(status)) {
+    timeline_value_ = value;
+    for (iree_host_size_t i = 0; i < resource_count; ++i) {
+      iree_hal_resource_retain(resources[i]);
+      retained_resources_.push_back({value, resources[i]});
+    }
+    // Opportunistically release resources from submissions that have since
+    // completed. This is a cheap query and avoids a separate reclaim thread.
+    uint64_t completed_value = 0;
+    if (!retained_resources_.empty() &&
+        syms()->vkGetSemaphoreCounterValue(*logical_device_,
+                                           timeline_semaphore_,
+                                           &completed_value) == VK_SUCCESS) {
+      DrainRetainedResources(completed_value, &completed_resources);
+    }
+  }
   iree_slim_mutex_unlock(&queue_mutex_);
-  IREE_RETURN_IF_ERROR(status);
+  for (iree_hal_resource_t* resource : completed_resources) {
+    iree_hal_resource_release(resource);
+  }
 
-  return iree_ok_status();
+  return status;
 }
 
 iree_status_t DirectCommandQueue::WaitIdle(iree_timeout_t timeout) {
   iree_time_t deadline_ns = iree_timeout_as_deadline_ns(timeout);
+  std::vector<iree_hal_resource_t*> completed_resources;
+  iree_status_t status = iree_ok_status();
   if (deadline_ns == IREE_TIME_INFINITE_FUTURE) {
     // Fast path for using vkQueueWaitIdle, which is usually cheaper (as it
     // requires fewer calls into the driver).
     IREE_TRACE_SCOPE0("DirectCommandQueue::WaitIdle#vkQueueWaitIdle");
     iree_slim_mutex_lock(&queue_mutex_);
-    iree_status_t status =
+    status =
         VK_RESULT_TO_STATUS(syms()->vkQueueWaitIdle(queue_), "vkQueueWaitIdle");
+    if (iree_status_is_ok(status)) {
+      DrainRetainedResources(UINT64_MAX, &completed_resources);
+    }
     iree_slim_mutex_unlock(&queue_mutex_);
-    iree_hal_vulkan_tracing_context_collect(tracing_context(), VK_NULL_HANDLE);
-    return status;
-  }
-
-  IREE_TRACE_SCOPE0("DirectCommandQueue::WaitIdle#Fence");
-
-  // Create a new fence just for this wait. This keeps us thread-safe as the
-  // behavior of wait+reset is racey.
-  VkFenceCreateInfo create_info;
-  create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-  create_info.pNext = nullptr;
-  create_info.flags = 0;
-  VkFence fence = VK_NULL_HANDLE;
-  VK_RETURN_IF_ERROR(
-      syms()->vkCreateFence(*logical_device_, &create_info,
-                            logical_device_->allocator(), &fence),
-      "vkCreateFence");
-
-  uint64_t timeout_ns;
-  if (deadline_ns == IREE_TIME_INFINITE_PAST) {
-    // Do not wait.
-    timeout_ns = 0;
-  } else if (deadline_ns == IREE_TIME_INFINITE_FUTURE) {
-    // Wait forever.
-    timeout_ns = UINT64_MAX;
   } else {
-    // Convert to relative time in nanoseconds.
-    // The implementation may not wait with this granularity (like by 10000x).
-    iree_time_t now_ns = iree_time_now();
-    if (deadline_ns < now_ns) {
-      return iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
-    }
-    timeout_ns = (uint64_t)(deadline_ns - now_ns);
-  }
+    // Wait for the queue timeline to reach the value signaled by the last
+    // submission. Unlike waiting on a fence this requires no submission.
+    IREE_TRACE_SCOPE0("DirectCommandQueue::WaitIdle#vkWaitSemaphores");
+    uint64_t timeout_ns = 0;
+    IREE_RETURN_IF_ERROR(ConvertTimeout(timeout, &timeout_ns));
 
-  iree_slim_mutex_lock(&queue_mutex_);
-  iree_status_t status = VK_RESULT_TO_STATUS(
-      syms()->vkQueueSubmit(queue_, 0, nullptr, fence), "vkQueueSubmit");
-  iree_slim_mutex_unlock(&queue_mutex_);
+    iree_slim_mutex_lock(&queue_mutex_);
+    uint64_t value = timeline_value_;
+    iree_slim_mutex_unlock(&queue_mutex_);
 
-  if (iree_status_is_ok(status)) {
-    VkResult result = syms()->vkWaitForFences(*logical_device_, 1, &fence,
-                                              VK_TRUE, timeout_ns);
+    VkSemaphoreWaitInfo wait_info;
+    wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    wait_info.pNext = nullptr;
+    wait_info.flags = 0;
+    wait_info.semaphoreCount = 1;
+    wait_info.pSemaphores = &timeline_semaphore_;
+    wait_info.pValues = &value;
+    VkResult result =
+        syms()->vkWaitSemaphores(*logical_device_, &wait_info, timeout_ns);
     switch (result) {
       case VK_SUCCESS:
         status = iree_ok_status();
@@ -180,12 +368,18 @@ iree_status_t DirectCommandQueue::WaitIdle(iree_timeout_t timeout) {
         status = iree_status_from_code(IREE_STATUS_DEADLINE_EXCEEDED);
         break;
       default:
-        status = VK_RESULT_TO_STATUS(result, "vkWaitForFences");
+        status = VK_RESULT_TO_STATUS(result, "vkWaitSemaphores");
         break;
     }
+    if (iree_status_is_ok(status)) {
+      iree_slim_mutex_lock(&queue_mutex_);
+      DrainRetainedResources(value, &completed_resources);
+      iree_slim_mutex_unlock(&queue_mutex_);
+    }
+  }
+  for (iree_hal_resource_t* resource : completed_resources) {
+    iree_hal_resource_release(resource);
   }
-
-  syms()->vkDestroyFence(*logical_device_, fence, logical_device_->allocator());
 
   iree_hal_vulkan_tracing_context_collect(tracing_context(), VK_NULL_HANDLE);
 
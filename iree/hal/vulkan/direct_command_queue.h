@@ -7,6 +7,8 @@
 #ifndef IREE_HAL_VULKAN_DIRECT_COMMAND_QUEUE_H_
 #define IREE_HAL_VULKAN_DIRECT_COMMAND_QUEUE_H_
 
+#include <vector>
+
 #include "iree/base/api.h"
 #include "iree/hal/api.h"
 #include "iree/hal/vulkan/command_queue.h"
@@ -18,22 +20,70 @@ namespace hal {
 namespace vulkan {
 
 // Command queue implementation directly maps to VkQueue.
+// Requires native timeline semaphores: all waits, including those on values
+// that have not yet been signaled, are performed by the device and the host
+// never blocks as part of a submission.
 class DirectCommandQueue final : public CommandQueue {
  public:
-  DirectCommandQueue(VkDeviceHandle* logical_device,
-                     iree_hal_command_category_t supported_categories,
-                     VkQueue queue);
+  // Creates a queue wrapping |queue| in |out_queue|.
+  static iree_status_t Create(VkDeviceHandle* logical_device,
+                              iree_hal_command_category_t supported_categories,
+                              VkQueue queue, DirectCommandQueue** out_queue);
+
   ~DirectCommandQueue() override;
 
   iree_status_t Submit(iree_host_size_t batch_count,
                        const iree_hal_submission_batch_t* batches) override;
 
+  // Submits |batches| and retains |resources| until the device has completed
+  // the submission such that callers may release them immediately.
+  iree_status_t SubmitAndRetain(iree_host_size_t batch_count,
+                                const iree_hal_submission_batch_t* batches,
+                                iree_host_size_t resource_count,
+                                iree_hal_resource_t* const* resources);
+
   iree_status_t WaitIdle(iree_timeout_t timeout) override;
 
  private:
+  // A resource retained until |timeline_semaphore_| reaches |value|.
+  struct RetainedResource {
+    uint64_t value;
+    iree_hal_resource_t* resource;
+  };
+
+  DirectCommandQueue(VkDeviceHandle* logical_device,
+                     iree_hal_command_category_t supported_categories,
+                     VkQueue queue, VkSemaphore timeline_semaphore);
+
+  // Translates |batch| into |submit_info| for vkQueueSubmit. If
+  // |queue_semaphore_value| is provided the submission also signals
+  // |timeline_semaphore_| to the value stored there prior to submission.
   iree_status_t TranslateBatchInfo(
       const iree_hal_submission_batch_t* batch, VkSubmitInfo* submit_info,
-      VkTimelineSemaphoreSubmitInfo* timeline_submit_info, Arena* arena);
+      VkTimelineSemaphoreSubmitInfo* timeline_submit_info,
+      uint64_t** queue_semaphore_value, Arena* arena);
+
+  // Translates |batch| into |submit_info| for vkQueueSubmit2KHR.
+  // See TranslateBatchInfo.
+  iree_status_t TranslateBatchInfo2(const iree_hal_submission_batch_t* batch,
+                                    VkSubmitInfo2KHR* submit_info,
+                                    uint64_t** queue_semaphore_value,
+                                    Arena* arena);
+
+  // Removes all resources retained by submissions that have completed up to
+  // |completed_value| and appends them to |out_resources| for release outside
+  // of the lock. Must be called with |queue_mutex_| held.
+  void DrainRetainedResources(uint64_t completed_value,
+                              std::vector<iree_hal_resource_t*>* out_resources);
+
+  // Timeline semaphore signaled by each submission with increasing values.
+  // Used to track queue progress without additional submissions or fences.
+  VkSemaphore timeline_semaphore_;
+  // Last value |timeline_semaphore_| will be signaled to.
+  uint64_t timeline_value_ IREE_GUARDED_BY(queue_mutex_) = 0;
+  // Resources retained by in-flight submissions in submission order.
+  std::vector<RetainedResource> retained_resources_
+      IREE_GUARDED_BY(queue_mutex_);
 };
 
 }  // namespace vulkan
@@ -0,0 +1,549 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/vulkan/dispatch_profiler.h"
+
+#include <cstring>
+#include <ctime>
+
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/target_platform.h"
+#include "iree/base/tracing.h"
+#include "iree/hal/utils/dispatch_profiler.h"
+#include "iree/hal/vulkan/native_executable.h"
+#include "iree/hal/vulkan/status_util.h"
+
+using namespace iree::hal::vulkan;
+
+// Maximum number of dispatches read back from the query pools in one call.
+#define IREE_HAL_VULKAN_DISPATCH_PROFILER_READBACK_CAPACITY 256
+
+typedef struct iree_hal_vulkan_query_result_t {
+  uint64_t value;
+  uint64_t availability;  // non-zero if available
+} iree_hal_vulkan_query_result_t;
+
+// Metadata of a dispatch recorded into a query slot.
+typedef struct iree_hal_vulkan_profiled_dispatch_t {
+  uint32_t entry_point;
+  uint32_t workgroup_count[3];
+  // True if a pipeline statistics query was recorded for the dispatch.
+  bool has_statistics;
+  iree_host_size_t name_length;
+  char name[IREE_HAL_DISPATCH_PROFILER_MAX_NAME_LENGTH];
+} iree_hal_vulkan_profiled_dispatch_t;
+
+struct iree_hal_vulkan_dispatch_profiler_t {
+  VkDeviceHandle* logical_device;
+  iree_allocator_t host_allocator;
+  bool pipeline_statistics_enabled;
+
+  // Number of nanoseconds per timestamp tick.
+  float timestamp_period;
+
+  // Host clock domain timestamps are calibrated against or
+  // VK_TIME_DOMAIN_DEVICE_EXT if calibration is not available.
+  VkTimeDomainEXT time_domain;
+
+  // Stores the completed dispatches until they are delivered to the sink.
+  iree_hal_dispatch_profiler_t profiler;
+
+  // Guards the fields below.
+  iree_slim_mutex_t mutex;
+
+  // True if dispatches record pipeline statistics queries.
+  bool capture_statistics;
+
+  // Device timestamp and the corresponding iree_time_now() time at the last
+  // calibration. Both are 0 when uncalibrated.
+  uint64_t calibration_device_ticks;
+  iree_time_t calibration_host_ns;
+
+  // Query pools created when profiling first begins. Slot i uses timestamp
+  // queries 2*i and 2*i+1 and statistics query i.
+  VkQueryPool timestamp_pool;
+  VkQueryPool statistics_pool;
+
+  // Ring of query slots. Slots in [tail, head) have been recorded and not
+  // yet read back.
+  uint32_t head;
+  uint32_t tail;
+  iree_hal_vulkan_profiled_dispatch_t* dispatches;
+
+  // Readback storage for a contiguous range of slots.
+  iree_hal_vulkan_query_result_t
+      timestamp_results[IREE_HAL_VULKAN_DISPATCH_PROFILER_READBACK_CAPACITY *
+                        2];
+  iree_hal_vulkan_query_result_t
+      statistics_results[IREE_HAL_VULKAN_DISPATCH_PROFILER_READBACK_CAPACITY];
+};
+
+// Returns the host clock domain that calibrated timestamps can be converted
+// from or VK_TIME_DOMAIN_DEVICE_EXT if there is none.
+static VkTimeDomainEXT iree_hal_vulkan_dispatch_profiler_query_time_domain(
+    VkPhysicalDevice physical_device, VkDeviceHandle* logical_device) {
+#if defined(IREE_PLATFORM_WINDOWS)
+  // TODO(benvanik): convert QPC timestamps to iree_time_now().
+  return VK_TIME_DOMAIN_DEVICE_EXT;
+#else
+  const auto& syms = logical_device->syms();
+  if (!logical_device->enabled_extensions().calibrated_timestamps ||
+      !syms->vkGetPhysicalDeviceCalibrateableTimeDomainsEXT) {
+    return VK_TIME_DOMAIN_DEVICE_EXT;
+  }
+  uint32_t time_domain_count = 0;
+  if (syms->vkGetPhysicalDeviceCalibrateableTimeDomainsEXT(
+          physical_device, &time_domain_count, NULL) != VK_SUCCESS) {
+    return VK_TIME_DOMAIN_DEVICE_EXT;
+  }
+  VkTimeDomainEXT* time_domains = (VkTimeDomainEXT*)iree_alloca(
+      time_domain_count * sizeof(VkTimeDomainEXT));
+  if (syms->vkGetPhysicalDeviceCalibrateableTimeDomainsEXT(
+          physical_device, &time_domain_count, time_domains) != VK_SUCCESS) {
+    return VK_TIME_DOMAIN_DEVICE_EXT;
+  }
+  for (uint32_t i = 0; i < time_domain_count; ++i) {
+    if (time_domains[i] == VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT) {
+      return time_domains[i];
+    }
+  }
+  return VK_TIME_DOMAIN_DEVICE_EXT;
+#endif  // IREE_PLATFORM_WINDOWS
+}
+
+// Correlates the device timestamp counter with iree_time_now(). Leaves the
+// profiler uncalibrated if the device cannot provide calibrated timestamps.
+static void iree_hal_vulkan_dispatch_profiler_calibrate(
+    iree_hal_vulkan_dispatch_profiler_t* profiler) {
+  profiler->calibration_device_ticks = 0;
+  profiler->calibration_host_ns = 0;
+#if !defined(IREE_PLATFORM_WINDOWS)
+  if (profiler->time_domain != VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT) return;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  VkCalibratedTimestampInfoEXT timestamp_infos[2];
+  timestamp_infos[0].sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+  timestamp_infos[0].pNext = NULL;
+  timestamp_infos[0].timeDomain = VK_TIME_DOMAIN_DEVICE_EXT;
+  timestamp_infos[1].sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+  timestamp_infos[1].pNext = NULL;
+  timestamp_infos[1].timeDomain = profiler->time_domain;
+  uint64_t timestamps[2] = {0, 0};
+  uint64_t max_deviation = 0;
+  VkResult result =
+      profiler->logical_device->syms()->vkGetCalibratedTimestampsEXT(
+          *profiler->logical_device, IREE_ARRAYSIZE(timestamps),
+          timestamp_infos, timestamps, &max_deviation);
+  if (result == VK_SUCCESS) {
+    // CLOCK_MONOTONIC and the realtime clock used by iree_time_now() are read
+    // back-to-back to translate between them.
+    struct timespec monotonic_time;
+    clock_gettime(CLOCK_MONOTONIC, &monotonic_time);
+    iree_time_t now_ns = iree_time_now();
+    iree_time_t monotonic_ns =
+        (iree_time_t)monotonic_time.tv_sec * 1000000000ll +
+        monotonic_time.tv_nsec;
+    profiler->calibration_device_ticks = timestamps[0];
+    profiler->calibration_host_ns =
+        (iree_time_t)timestamps[1] + (now_ns - monotonic_ns);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+#endif  // !IREE_PLATFORM_WINDOWS
+}
+
+// Converts a device timestamp to nanoseconds in the calibrated domain.
+static iree_time_t iree_hal_vulkan_dispatch_profiler_convert_timestamp(
+    iree_hal_vulkan_dispatch_profiler_t* profiler, uint64_t ticks) {
+  int64_t delta_ticks = (int64_t)(ticks - profiler->calibration_device_ticks);
+  return profiler->calibration_host_ns +
+         (iree_time_t)((double)delta_ticks * profiler->timestamp_period);
+}
+
+// Resets a range of queries from the host.
+static void iree_hal_vulkan_dispatch_profiler_reset_queries(
+    iree_hal_vulkan_dispatch_profiler_t* profiler, VkQueryPool query_pool,
+    uint32_t query_index, uint32_t query_count) {
+  if (query_pool == VK_NULL_HANDLE || !query_count) return;
+  const auto& syms = profiler->logical_device->syms();
+  PFN_vkResetQueryPool vkResetQueryPool_fn = syms->vkResetQueryPool
+                                                 ? syms->vkResetQueryPool
+                                                 : syms->vkResetQueryPoolEXT;
+  vkResetQueryPool_fn(*profiler->logical_device, query_pool, query_index,
+                      query_count);
+}
+
+// Creates the query pools and slot storage if they do not yet exist.
+// Must be called with the profiler mutex held.
+static iree_status_t iree_hal_vulkan_dispatch_profiler_prepare(
+    iree_hal_vulkan_dispatch_profiler_t* profiler) {
+  if (profiler->dispatches) return iree_ok_status();
+  IREE_TRACE_ZONE_BEGIN(z0);
+  VkDeviceHandle* logical_device = profiler->logical_device;
+  const auto& syms = logical_device->syms();
+
+  VkQueryPoolCreateInfo pool_info;
+  memset(&pool_info, 0, sizeof(pool_info));
+  pool_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+  pool_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+  pool_info.queryCount = IREE_HAL_VULKAN_DISPATCH_PROFILER_QUERY_CAPACITY * 2;
+  iree_status_t status = VK_RESULT_TO_STATUS(
+      syms->vkCreateQueryPool(*logical_device, &pool_info,
+                              logical_device->allocator(),
+                              &profiler->timestamp_pool),
+      "vkCreateQueryPool");
+
+  if (iree_status_is_ok(status) && profiler->pipeline_statistics_enabled) {
+    memset(&pool_info, 0, sizeof(pool_info));
+    pool_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    pool_info.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+    pool_info.queryCount = IREE_HAL_VULKAN_DISPATCH_PROFILER_QUERY_CAPACITY;
+    pool_info.pipelineStatistics =
+        VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+    status = VK_RESULT_TO_STATUS(
+        syms->vkCreateQueryPool(*logical_device, &pool_info,
+                                logical_device->allocator(),
+                                &profiler->statistics_pool),
+        "vkCreateQueryPool");
+  }
+
+  iree_hal_vulkan_profiled_dispatch_t* dispatches = NULL;
+  if (iree_status_is_ok(status)) {
+    status = iree_allocator_malloc(
+        profiler->host_allocator,
+        IREE_HAL_VULKAN_DISPATCH_PROFILER_QUERY_CAPACITY * sizeof(*dispatches),
+        (void**)&dispatches);
+  }
+
+  if (iree_status_is_ok(status)) {
+    // All queries must be reset before first use.
+    iree_hal_vulkan_dispatch_profiler_reset_queries(
+        profiler, profiler->timestamp_pool, 0,
+        IREE_HAL_VULKAN_DISPATCH_PROFILER_QUERY_CAPACITY * 2);
+    iree_hal_vulkan_dispatch_profiler_reset_queries(
+        profiler, profiler->statistics_pool, 0,
+        IREE_HAL_VULKAN_DISPATCH_PROFILER_QUERY_CAPACITY);
+    profiler->dispatches = dispatches;
+    profiler->head = 0;
+    profiler->tail = 0;
+  } else {
+    syms->vkDestroyQueryPool(*logical_device, profiler->timestamp_pool,
+                             logical_device->allocator());
+    syms->vkDestroyQueryPool(*logical_device, profiler->statistics_pool,
+                             logical_device->allocator());
+    profiler->timestamp_pool = VK_NULL_HANDLE;
+    profiler->statistics_pool = VK_NULL_HANDLE;
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+iree_status_t iree_hal_vulkan_dispatch_profiler_allocate(
+    VkPhysicalDevice physical_device, VkDeviceHandle* logical_device,
+    bool pipeline_statistics_enabled, iree_allocator_t host_allocator,
+    iree_hal_vulkan_dispatch_profiler_t** out_profiler) {
+  IREE_ASSERT_ARGUMENT(logical_device);
+  IREE_ASSERT_ARGUMENT(out_profiler);
+  *out_profiler = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_vulkan_dispatch_profiler_t* profiler = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, sizeof(*profiler),
+                                (void**)&profiler));
+  memset(profiler, 0, sizeof(*profiler));
+  profiler->logical_device = logical_device;
+  profiler->host_allocator = host_allocator;
+  profiler->pipeline_statistics_enabled = pipeline_statistics_enabled;
+
+  VkPhysicalDeviceProperties device_properties;
+  logical_device->syms()->vkGetPhysicalDeviceProperties(physical_device,
+                                                        &device_properties);
+  profiler->timestamp_period = device_properties.limits.timestampPeriod;
+  profiler->time_domain = iree_hal_vulkan_dispatch_profiler_query_time_domain(
+      physical_device, logical_device);
+
+  iree_hal_dispatch_profiler_initialize(host_allocator, &profiler->profiler);
+  iree_slim_mutex_initialize(&profiler->mutex);
+
+  *out_profiler = profiler;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+void iree_hal_vulkan_dispatch_profiler_free(
+    iree_hal_vulkan_dispatch_profiler_t* profiler) {
+  if (!profiler) return;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  VkDeviceHandle* logical_device = profiler->logical_device;
+  const auto& syms = logical_device->syms();
+  syms->vkDestroyQueryPool(*logical_device, profiler->timestamp_pool,
+                           logical_device->allocator());
+  syms->vkDestroyQueryPool(*logical_device, profiler->statistics_pool,
+                           logical_device->allocator());
+  iree_allocator_free(profiler->host_allocator, profiler->dispatches);
+
+  iree_slim_mutex_deinitialize(&profiler->mutex);
+  iree_hal_dispatch_profiler_deinitialize(&profiler->profiler);
+  iree_allocator_free(profiler->host_allocator, profiler);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+iree_status_t iree_hal_vulkan_dispatch_profiler_begin(
+    iree_hal_vulkan_dispatch_profiler_t* profiler,
+    const iree_hal_device_profiling_options_t* options) {
+  IREE_ASSERT_ARGUMENT(profiler);
+  IREE_ASSERT_ARGUMENT(options);
+  iree_hal_device_profiling_mode_t supported_modes =
+      IREE_HAL_DEVICE_PROFILING_MODE_DISPATCH_TIMESTAMPS;
+  if (profiler->pipeline_statistics_enabled) {
+    supported_modes |= IREE_HAL_DEVICE_PROFILING_MODE_DISPATCH_STATISTICS;
+  }
+  if (options->mode & ~supported_modes) {
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "unsupported profiling mode 0x%08X",
+                            options->mode);
+  }
+  if (!profiler->logical_device->enabled_extensions().host_query_reset) {
+    // Slots are reset from the host once read back so that stale results are
+    // never observed before the command buffers reusing them execute.
+    return iree_make_status(
+        IREE_STATUS_UNIMPLEMENTED,
+        "device profiling requires VK_EXT_host_query_reset or Vulkan 1.2");
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // The lock is held across beginning the base profiler so that no dispatch
+  // can acquire a slot before the ring and calibration are reset.
+  iree_slim_mutex_lock(&profiler->mutex);
+  iree_status_t status = iree_ok_status();
+  if (iree_hal_dispatch_profiler_is_active(&profiler->profiler)) {
+    status = iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                              "device is already profiling");
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_vulkan_dispatch_profiler_prepare(profiler);
+  }
+  if (iree_status_is_ok(status)) {
+    profiler->capture_statistics = iree_all_bits_set(
+        options->mode, IREE_HAL_DEVICE_PROFILING_MODE_DISPATCH_STATISTICS);
+    iree_hal_vulkan_dispatch_profiler_calibrate(profiler);
+    iree_hal_device_profiling_options_t base_options = *options;
+    base_options.mode &= IREE_HAL_DEVICE_PROFILING_MODE_DISPATCH_TIMESTAMPS;
+    status = iree_hal_dispatch_profiler_begin(&profiler->profiler,
+                                              &base_options);
+  }
+  iree_slim_mutex_unlock(&profiler->mutex);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Reads back all slots that have completed in ring order and appends them to
+// the base profiler. Stops at the first slot that has not yet completed.
+// Must be called with the profiler mutex held.
+static void iree_hal_vulkan_dispatch_profiler_collect(
+    iree_hal_vulkan_dispatch_profiler_t* profiler) {
+  VkDeviceHandle* logical_device = profiler->logical_device;
+  const auto& syms = logical_device->syms();
+  while (profiler->tail != profiler->head) {
+    // Compute the contiguous range of slots to read. If the ring wraps around
+    // the remainder is handled in the next iteration.
+    uint32_t base_slot = profiler->tail;
+    uint32_t slot_count =
+        profiler->head > base_slot
+            ? profiler->head - base_slot
+            : IREE_HAL_VULKAN_DISPATCH_PROFILER_QUERY_CAPACITY - base_slot;
+    slot_count = iree_min(slot_count,
+                          IREE_HAL_VULKAN_DISPATCH_PROFILER_READBACK_CAPACITY);
+
+    // VK_NOT_READY is returned if any query is unavailable; the availability
+    // of each query is checked below.
+    VkResult result = syms->vkGetQueryPoolResults(
+        *logical_device, profiler->timestamp_pool, base_slot * 2,
+        slot_count * 2, sizeof(profiler->timestamp_results),
+        profiler->timestamp_results, sizeof(profiler->timestamp_results[0]),
+        VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+    if (result != VK_SUCCESS && result != VK_NOT_READY) break;
+    if (profiler->statistics_pool != VK_NULL_HANDLE) {
+      result = syms->vkGetQueryPoolResults(
+          *logical_device, profiler->statistics_pool, base_slot, slot_count,
+          sizeof(profiler->statistics_results), profiler->statistics_results,
+          sizeof(profiler->statistics_results[0]),
+          VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+      if (result != VK_SUCCESS && result != VK_NOT_READY) break;
+    }
+
+    uint32_t ready_count = 0;
+    for (uint32_t i = 0; i < slot_count; ++i) {
+      const iree_hal_vulkan_profiled_dispatch_t* slot =
+          &profiler->dispatches[base_slot + i];
+      const iree_hal_vulkan_query_result_t* begin_result =
+          &profiler->timestamp_results[i * 2 + 0];
+      const iree_hal_vulkan_query_result_t* end_result =
+          &profiler->timestamp_results[i * 2 + 1];
+      if (!end_result->availability || !begin_result->availability) break;
+      if (slot->has_statistics &&
+          !profiler->statistics_results[i].availability) {
+        break;
+      }
+      ready_count = i + 1;
+
+      iree_hal_device_profiling_dispatch_t dispatch;
+      memset(&dispatch, 0, sizeof(dispatch));
+      dispatch.entry_point_name =
+          iree_make_string_view(slot->name, slot->name_length);
+      dispatch.entry_point = slot->entry_point;
+      memcpy(dispatch.workgroup_count, slot->workgroup_count,
+             sizeof(dispatch.workgroup_count));
+      dispatch.begin_time_ns =
+          iree_hal_vulkan_dispatch_profiler_convert_timestamp(
+              profiler, begin_result->value);
+      dispatch.end_time_ns =
+          iree_hal_vulkan_dispatch_profiler_convert_timestamp(
+              profiler, end_result->value);
+      if (slot->has_statistics) {
+        dispatch.invocation_count = profiler->statistics_results[i].value;
+      }
+      iree_hal_dispatch_profiler_append(&profiler->profiler, &dispatch);
+    }
+    if (!ready_count) break;
+
+    // Reset the slots read back so they are unavailable until reused.
+    iree_hal_vulkan_dispatch_profiler_reset_queries(
+        profiler, profiler->timestamp_pool, base_slot * 2, ready_count * 2);
+    iree_hal_vulkan_dispatch_profiler_reset_queries(
+        profiler, profiler->statistics_pool, base_slot, ready_count);
+    profiler->tail = (base_slot + ready_count) %
+                     IREE_HAL_VULKAN_DISPATCH_PROFILER_QUERY_CAPACITY;
+    if (ready_count < slot_count) break;
+  }
+}
+
+iree_status_t iree_hal_vulkan_dispatch_profiler_flush(
+    iree_hal_vulkan_dispatch_profiler_t* profiler) {
+  IREE_ASSERT_ARGUMENT(profiler);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_slim_mutex_lock(&profiler->mutex);
+  if (iree_hal_dispatch_profiler_is_active(&profiler->profiler)) {
+    iree_hal_vulkan_dispatch_profiler_collect(profiler);
+  }
+  iree_slim_mutex_unlock(&profiler->mutex);
+  iree_status_t status = iree_hal_dispatch_profiler_flush(&profiler->profiler);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+iree_status_t iree_hal_vulkan_dispatch_profiler_end(
+    iree_hal_vulkan_dispatch_profiler_t* profiler) {
+  IREE_ASSERT_ARGUMENT(profiler);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_slim_mutex_lock(&profiler->mutex);
+  if (iree_hal_dispatch_profiler_is_active(&profiler->profiler)) {
+    iree_hal_vulkan_dispatch_profiler_collect(profiler);
+
+    // Drop the slots of dispatches that have not completed. Their queries are
+    // reset such that reusing the slots does not observe their results.
+    uint32_t outstanding_count =
+        (profiler->head + IREE_HAL_VULKAN_DISPATCH_PROFILER_QUERY_CAPACITY -
+         profiler->tail) %
+        IREE_HAL_VULKAN_DISPATCH_PROFILER_QUERY_CAPACITY;
+    iree_hal_dispatch_profiler_append_dropped(&profiler->profiler,
+                                              outstanding_count);
+    while (profiler->tail != profiler->head) {
+      uint32_t base_slot = profiler->tail;
+      uint32_t slot_count =
+          profiler->head > base_slot
+              ? profiler->head - base_slot
+              : IREE_HAL_VULKAN_DISPATCH_PROFILER_QUERY_CAPACITY - base_slot;
+      iree_hal_vulkan_dispatch_profiler_reset_queries(
+          profiler, profiler->timestamp_pool, base_slot * 2, slot_count * 2);
+      iree_hal_vulkan_dispatch_profiler_reset_queries(
+          profiler, profiler->statistics_pool, base_slot, slot_count);
+      profiler->tail = (base_slot + slot_count) %
+                       IREE_HAL_VULKAN_DISPATCH_PROFILER_QUERY_CAPACITY;
+    }
+  }
+  iree_slim_mutex_unlock(&profiler->mutex);
+  iree_status_t status = iree_hal_dispatch_profiler_end(&profiler->profiler);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+uint32_t iree_hal_vulkan_dispatch_profiler_record_begin(
+    iree_hal_vulkan_dispatch_profiler_t* profiler,
+    VkCommandBuffer command_buffer, iree_hal_executable_t* executable,
+    int32_t entry_point, const uint32_t* workgroup_count) {
+  if (!profiler || !iree_hal_dispatch_profiler_is_active(&profiler->profiler)) {
+    return IREE_HAL_VULKAN_DISPATCH_PROFILER_NO_SLOT;
+  }
+
+  iree_slim_mutex_lock(&profiler->mutex);
+  if (!iree_hal_dispatch_profiler_is_active(&profiler->profiler)) {
+    // Raced with the end of profiling.
+    iree_slim_mutex_unlock(&profiler->mutex);
+    return IREE_HAL_VULKAN_DISPATCH_PROFILER_NO_SLOT;
+  }
+  uint32_t next_head = (profiler->head + 1) %
+                       IREE_HAL_VULKAN_DISPATCH_PROFILER_QUERY_CAPACITY;
+  if (next_head == profiler->tail) {
+    // All slots are outstanding; the device must be flushed more frequently.
+    iree_slim_mutex_unlock(&profiler->mutex);
+    iree_hal_dispatch_profiler_append_dropped(&profiler->profiler, 1);
+    return IREE_HAL_VULKAN_DISPATCH_PROFILER_NO_SLOT;
+  }
+  uint32_t slot_index = profiler->head;
+  profiler->head = next_head;
+  bool capture_statistics = profiler->capture_statistics;
+  iree_slim_mutex_unlock(&profiler->mutex);
+
+  // The slot is owned by this command buffer until it is read back and is not
+  // read until its queries become available.
+  iree_hal_vulkan_profiled_dispatch_t* slot =
+      &profiler->dispatches[slot_index];
+  iree_hal_vulkan_source_location_t source_location;
+  iree_hal_vulkan_native_executable_entry_point_source_location(
+      executable, entry_point, &source_location);
+  slot->entry_point = (uint32_t)entry_point;
+  if (workgroup_count) {
+    memcpy(slot->workgroup_count, workgroup_count,
+           sizeof(slot->workgroup_count));
+  } else {
+    // Indirect dispatch counts are only known on the device.
+    memset(slot->workgroup_count, 0, sizeof(slot->workgroup_count));
+  }
+  slot->has_statistics = capture_statistics;
+  slot->name_length = iree_min(source_location.func_name.size,
+                               IREE_ARRAYSIZE(slot->name) - 1);
+  memcpy(slot->name, source_location.func_name.data, slot->name_length);
+  slot->name[slot->name_length] = 0;
+
+  const auto& syms = profiler->logical_device->syms();
+  syms->vkCmdWriteTimestamp(command_buffer,
+                            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                            profiler->timestamp_pool, slot_index * 2 + 0);
+  if (capture_statistics) {
+    syms->vkCmdBeginQuery(command_buffer, profiler->statistics_pool,
+                          slot_index, 0);
+  }
+  return slot_index;
+}
+
+void iree_hal_vulkan_dispatch_profiler_record_end(
+    iree_hal_vulkan_dispatch_profiler_t* profiler,
+    VkCommandBuffer command_buffer, uint32_t slot_index) {
+  if (slot_index == IREE_HAL_VULKAN_DISPATCH_PROFILER_NO_SLOT) return;
+  const auto& syms = profiler->logical_device->syms();
+  if (profiler->dispatches[slot_index].has_statistics) {
+    syms->vkCmdEndQuery(command_buffer, profiler->statistics_pool, slot_index);
+  }
+  syms->vkCmdWriteTimestamp(command_buffer,
+                            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                            profiler->timestamp_pool, slot_index * 2 + 1);
+}
@@ -0,0 +1,99 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_VULKAN_DISPATCH_PROFILER_H_
+#define IREE_HAL_VULKAN_DISPATCH_PROFILER_H_
+
+// clang-format off: must be included before all other headers.
+#include "iree/hal/vulkan/vulkan_headers.h"
+// clang-format on
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/hal/vulkan/handle_util.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Maximum number of profiled dispatches that may be outstanding between
+// flushes. Dispatches recorded while the ring is full are reported as dropped.
+#define IREE_HAL_VULKAN_DISPATCH_PROFILER_QUERY_CAPACITY 4096
+
+// Returned by iree_hal_vulkan_dispatch_profiler_record_begin when the dispatch
+// is not being profiled.
+#define IREE_HAL_VULKAN_DISPATCH_PROFILER_NO_SLOT UINT32_MAX
+
+// Implements the iree_hal_device_profiling_* API for Vulkan devices using GPU
+// timestamp and pipeline statistics queries. Unlike the tracing context this
+// does not depend on Tracy and the results are delivered to the profiling
+// sink provided by the application.
+//
+// Each profiled dispatch acquires a slot in a ring of queries when it is
+// recorded and the results are read back without waiting when the device is
+// flushed; dispatches that have not yet completed are delivered by a later
+// flush. When VK_EXT_calibrated_timestamps is available with a host clock
+// domain timestamps are converted to iree_time_now() nanoseconds, otherwise
+// only the differences between them are meaningful.
+//
+// Timestamps are written at the bottom of the pipe around each dispatch and
+// as with tracing this serializes dispatches that could otherwise overlap.
+// Only command buffers recorded while profiling is active are profiled.
+//
+// Thread-safe: command buffers may record from multiple threads.
+typedef struct iree_hal_vulkan_dispatch_profiler_t
+    iree_hal_vulkan_dispatch_profiler_t;
+
+// Allocates a profiler for |logical_device| in the inactive state. Query pools
+// are created when profiling first begins. |pipeline_statistics_enabled| must
+// only be set if the pipelineStatisticsQuery feature was enabled on the device.
+iree_status_t iree_hal_vulkan_dispatch_profiler_allocate(
+    VkPhysicalDevice physical_device,
+    iree::hal::vulkan::VkDeviceHandle* logical_device,
+    bool pipeline_statistics_enabled, iree_allocator_t host_allocator,
+    iree_hal_vulkan_dispatch_profiler_t** out_profiler);
+
+// Frees |profiler| and its query pools. All command buffers recorded while
+// profiling must have completed.
+void iree_hal_vulkan_dispatch_profiler_free(
+    iree_hal_vulkan_dispatch_profiler_t* profiler);
+
+// Begins profiling as with iree_hal_device_profiling_begin.
+iree_status_t iree_hal_vulkan_dispatch_profiler_begin(
+    iree_hal_vulkan_dispatch_profiler_t* profiler,
+    const iree_hal_device_profiling_options_t* options);
+
+// Reads back all completed dispatches and delivers them to the sink as with
+// iree_hal_device_profiling_flush.
+iree_status_t iree_hal_vulkan_dispatch_profiler_flush(
+    iree_hal_vulkan_dispatch_profiler_t* profiler);
+
+// Ends profiling as with iree_hal_device_profiling_end. Dispatches that have
+// not completed are dropped.
+iree_status_t iree_hal_vulkan_dispatch_profiler_end(
+    iree_hal_vulkan_dispatch_profiler_t* profiler);
+
+// Records the query commands preceding a dispatch of |entry_point| in
+// |executable| into |command_buffer| if profiling is active. |workgroup_count|
+// may be NULL for indirect dispatches. Returns the slot that must be passed to
+// iree_hal_vulkan_dispatch_profiler_record_end after the dispatch is recorded
+// or IREE_HAL_VULKAN_DISPATCH_PROFILER_NO_SLOT if not profiling. |profiler|
+// may be NULL.
+uint32_t iree_hal_vulkan_dispatch_profiler_record_begin(
+    iree_hal_vulkan_dispatch_profiler_t* profiler,
+    VkCommandBuffer command_buffer, iree_hal_executable_t* executable,
+    int32_t entry_point, const uint32_t* workgroup_count);
+
+// Records the query commands following the dispatch profiled in |slot|.
+void iree_hal_vulkan_dispatch_profiler_record_end(
+    iree_hal_vulkan_dispatch_profiler_t* profiler,
+    VkCommandBuffer command_buffer, uint32_t slot);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_VULKAN_DISPATCH_PROFILER_H_
@@ -45,7 +45,7 @@ namespace vulkan {
   DEV_PFN(REQUIRED, vkBeginCommandBuffer)                               \
   DEV_PFN(EXCLUDED, vkCmdBeginConditionalRenderingEXT)                  \
   DEV_PFN(OPTIONAL, vkCmdBeginDebugUtilsLabelEXT)                       \
-  DEV_PFN(EXCLUDED, vkCmdBeginQuery)                                    \
+  DEV_PFN(REQUIRED, vkCmdBeginQuery)                                    \
   DEV_PFN(EXCLUDED, vkCmdBeginQueryIndexedEXT)                          \
   DEV_PFN(EXCLUDED, vkCmdBeginRenderPass)                               \
   DEV_PFN(EXCLUDED, vkCmdBeginRenderPass2KHR)                           \
@@ -88,7 +88,7 @@ namespace vulkan {
   DEV_PFN(EXCLUDED, vkCmdDrawMeshTasksNV)                               \
   DEV_PFN(EXCLUDED, vkCmdEndConditionalRenderingEXT)                    \
   DEV_PFN(OPTIONAL, vkCmdEndDebugUtilsLabelEXT)                         \
-  DEV_PFN(EXCLUDED, vkCmdEndQuery)                                      \
+  DEV_PFN(REQUIRED, vkCmdEndQuery)                                      \
   DEV_PFN(EXCLUDED, vkCmdEndQueryIndexedEXT)                            \
   DEV_PFN(EXCLUDED, vkCmdEndRenderPass)                                 \
   DEV_PFN(EXCLUDED, vkCmdEndRenderPass2KHR)                             \
@@ -102,7 +102,7 @@ namespace vulkan {
   DEV_PFN(EXCLUDED, vkCmdProcessCommandsNVX)                            \
   DEV_PFN(REQUIRED, vkCmdPushConstants)                                 \
   DEV_PFN(OPTIONAL, vkCmdPushDescriptorSetKHR)                          \
-  DEV_PFN(EXCLUDED, vkCmdPushDescriptorSetWithTemplateKHR)              \
+  DEV_PFN(OPTIONAL, vkCmdPushDescriptorSetWithTemplateKHR)              \
   DEV_PFN(EXCLUDED, vkCmdReserveSpaceForCommandsNVX)                    \
   DEV_PFN(REQUIRED, vkCmdResetEvent)                                    \
   DEV_PFN(REQUIRED, vkCmdResetQueryPool)                                \
@@ -154,8 +154,8 @@ namespace vulkan {
   DEV_PFN(REQUIRED, vkCreateComputePipelines)                           \
   DEV_PFN(REQUIRED, vkCreateDescriptorPool)                             \
   DEV_PFN(REQUIRED, vkCreateDescriptorSetLayout)                        \
-  DEV_PFN(EXCLUDED, vkCreateDescriptorUpdateTemplate)                   \
-  DEV_PFN(EXCLUDED, vkCreateDescriptorUpdateTemplateKHR)                \
+  DEV_PFN(OPTIONAL, vkCreateDescriptorUpdateTemplate)                   \
+  DEV_PFN(OPTIONAL, vkCreateDescriptorUpdateTemplateKHR)                \
   DEV_PFN(REQUIRED, vkCreateEvent)                                      \
   DEV_PFN(REQUIRED, vkCreateFence)                                      \
   DEV_PFN(EXCLUDED, vkCreateFramebuffer)                                \
@@ -186,8 +186,8 @@ namespace vulkan {
   DEV_PFN(REQUIRED, vkDestroyCommandPool)                               \
   DEV_PFN(REQUIRED, vkDestroyDescriptorPool)                            \
   DEV_PFN(REQUIRED, vkDestroyDescriptorSetLayout)                       \
-  DEV_PFN(EXCLUDED, vkDestroyDescriptorUpdateTemplate)                  \
-  DEV_PFN(EXCLUDED, vkDestroyDescriptorUpdateTemplateKHR)               \
+  DEV_PFN(OPTIONAL, vkDestroyDescriptorUpdateTemplate)                  \
+  DEV_PFN(OPTIONAL, vkDestroyDescriptorUpdateTemplateKHR)               \
   DEV_PFN(REQUIRED, vkDestroyDevice)                                    \
   DEV_PFN(REQUIRED, vkDestroyEvent)                                     \
   DEV_PFN(REQUIRED, vkDestroyFence)                                     \
@@ -281,8 +281,8 @@ namespace vulkan {
   DEV_PFN(EXCLUDED, vkTrimCommandPoolKHR)                               \
   DEV_PFN(REQUIRED, vkUnmapMemory)                                      \
   DEV_PFN(EXCLUDED, vkUnregisterObjectsNVX)                             \
-  DEV_PFN(EXCLUDED, vkUpdateDescriptorSetWithTemplate)                  \
-  DEV_PFN(EXCLUDED, vkUpdateDescriptorSetWithTemplateKHR)               \
+  DEV_PFN(OPTIONAL, vkUpdateDescriptorSetWithTemplate)                  \
+  DEV_PFN(OPTIONAL, vkUpdateDescriptorSetWithTemplateKHR)               \
   DEV_PFN(REQUIRED, vkUpdateDescriptorSets)                             \
   DEV_PFN(REQUIRED, vkWaitForFences)                                    \
                                                                         \
@@ -339,8 +339,8 @@ namespace vulkan {
   INS_PFN(EXCLUDED, vkGetPhysicalDeviceImageFormatProperties2)          \
   INS_PFN(EXCLUDED, vkGetPhysicalDeviceImageFormatProperties2KHR)       \
   INS_PFN(REQUIRED, vkGetPhysicalDeviceMemoryProperties)                \
-  INS_PFN(EXCLUDED, vkGetPhysicalDeviceMemoryProperties2)               \
-  INS_PFN(EXCLUDED, vkGetPhysicalDeviceMemoryProperties2KHR)            \
+  INS_PFN(OPTIONAL, vkGetPhysicalDeviceMemoryProperties2)               \
+  INS_PFN(OPTIONAL, vkGetPhysicalDeviceMemoryProperties2KHR)            \
   INS_PFN(EXCLUDED, vkGetPhysicalDeviceMultisamplePropertiesEXT)        \
   INS_PFN(EXCLUDED, vkGetPhysicalDevicePresentRectanglesKHR)            \
   INS_PFN(REQUIRED, vkGetPhysicalDeviceProperties)                      \
@@ -367,6 +367,7 @@ namespace vulkan {
   DEV_PFN(OPTIONAL, vkQueueInsertDebugUtilsLabelEXT)                    \
   DEV_PFN(EXCLUDED, vkQueuePresentKHR)                                  \
   DEV_PFN(REQUIRED, vkQueueSubmit)                                      \
+  DEV_PFN(OPTIONAL, vkQueueSubmit2KHR)                                  \
   DEV_PFN(REQUIRED, vkQueueWaitIdle)
 
 #ifdef VK_USE_PLATFORM_ANDROID_KHR
@@ -258,6 +258,18 @@ void DynamicSymbols::FixupExtensionFunctions() {
   this->vkSignalSemaphore = this->vkSignalSemaphore
                                 ? this->vkSignalSemaphore
                                 : this->vkSignalSemaphoreKHR;
+  this->vkCreateDescriptorUpdateTemplate =
+      this->vkCreateDescriptorUpdateTemplate
+          ? this->vkCreateDescriptorUpdateTemplate
+          : this->vkCreateDescriptorUpdateTemplateKHR;
+  this->vkDestroyDescriptorUpdateTemplate =
+      this->vkDestroyDescriptorUpdateTemplate
+          ? this->vkDestroyDescriptorUpdateTemplate
+          : this->vkDestroyDescriptorUpdateTemplateKHR;
+  this->vkUpdateDescriptorSetWithTemplate =
+      this->vkUpdateDescriptorSetWithTemplate
+          ? this->vkUpdateDescriptorSetWithTemplate
+          : this->vkUpdateDescriptorSetWithTemplateKHR;
 }
 
 }  // namespace vulkan
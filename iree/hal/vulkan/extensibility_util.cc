@@ -207,6 +207,12 @@ iree_hal_vulkan_populate_enabled_device_extensions(
     } else if (strcmp(extension_name,
                       VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME) == 0) {
       extensions.calibrated_timestamps = true;
+    } else if (strcmp(extension_name,
+                      VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME) == 0) {
+      extensions.synchronization_2 = true;
+    } else if (strcmp(extension_name, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) ==
+               0) {
+      extensions.memory_budget = true;
     }
   }
   return extensions;
@@ -229,5 +235,8 @@ iree_hal_vulkan_infer_enabled_device_extensions(
   if (device_syms->vkGetCalibratedTimestampsEXT) {
     extensions.calibrated_timestamps = true;
   }
+  if (device_syms->vkQueueSubmit2KHR) {
+    extensions.synchronization_2 = true;
+  }
   return extensions;
 }
@@ -80,6 +80,10 @@ typedef struct iree_hal_vulkan_device_extensions_t {
   bool host_query_reset : 1;
   // VK_EXT_calibrated_timestamps is enabled.
   bool calibrated_timestamps : 1;
+  // VK_KHR_synchronization2 is enabled and vkQueueSubmit2KHR is valid.
+  bool synchronization_2 : 1;
+  // VK_EXT_memory_budget is enabled.
+  bool memory_budget : 1;
 } iree_hal_vulkan_device_extensions_t;
 
 // Returns a bitfield with all of the provided extension names.
@@ -0,0 +1,425 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/vulkan/indirect_command_buffer.h"
+
+#include <cstddef>
+#include <cstring>
+
+#include "iree/base/api.h"
+#include "iree/base/tracing.h"
+#include "iree/hal/utils/deferred_command_buffer.h"
+
+// Command buffer implementation that records commands in memory and resolves
+// them against submission binding tables into direct command buffers.
+typedef struct iree_hal_vulkan_indirect_command_buffer_t {
+  iree_hal_command_buffer_t base;
+  iree_allocator_t host_allocator;
+  // Device used to create resolved command buffers. Unretained as devices
+  // outlive their command buffers.
+  iree_hal_device_t* device;
+
+  // Recorded commands with bindings that may reference binding table slots.
+  iree_hal_command_buffer_t* deferred_command_buffer;
+
+  // Direct command buffer produced by the last resolve, if any, and a copy of
+  // the binding table it was resolved with. The buffers in the table are kept
+  // live by the resource set of the resolved command buffer.
+  iree_hal_command_buffer_t* resolved_command_buffer;
+  iree_host_size_t resolved_binding_count;
+  iree_host_size_t resolved_binding_capacity;
+  iree_hal_buffer_binding_t* resolved_bindings;
+} iree_hal_vulkan_indirect_command_buffer_t;
+
+namespace {
+extern const iree_hal_command_buffer_vtable_t
+    iree_hal_vulkan_indirect_command_buffer_vtable;
+}  // namespace
+
+static iree_hal_vulkan_indirect_command_buffer_t*
+iree_hal_vulkan_indirect_command_buffer_cast(
+    iree_hal_command_buffer_t* base_value) {
+  IREE_HAL_ASSERT_TYPE(base_value,
+                       &iree_hal_vulkan_indirect_command_buffer_vtable);
+  return (iree_hal_vulkan_indirect_command_buffer_t*)base_value;
+}
+
+iree_status_t iree_hal_vulkan_indirect_command_buffer_create(
+    iree_hal_device_t* device, iree_hal_command_buffer_mode_t mode,
+    iree_hal_command_category_t command_categories,
+    iree_hal_queue_affinity_t queue_affinity,
+    iree_arena_block_pool_t* block_pool, iree_allocator_t host_allocator,
+    iree_hal_command_buffer_t** out_command_buffer) {
+  IREE_ASSERT_ARGUMENT(device);
+  IREE_ASSERT_ARGUMENT(block_pool);
+  IREE_ASSERT_ARGUMENT(out_command_buffer);
+  *out_command_buffer = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_vulkan_indirect_command_buffer_t* command_buffer = NULL;
+  iree_status_t status = iree_allocator_malloc(
+      host_allocator, sizeof(*command_buffer), (void**)&command_buffer);
+  if (iree_status_is_ok(status)) {
+    memset(command_buffer, 0, sizeof(*command_buffer));
+    iree_hal_command_buffer_initialize(
+        device, mode, command_categories, queue_affinity,
+        &iree_hal_vulkan_indirect_command_buffer_vtable, &command_buffer->base);
+    command_buffer->host_allocator = host_allocator;
+    command_buffer->device = device;
+    status = iree_hal_deferred_command_buffer_create(
+        device, mode, command_categories, block_pool, host_allocator,
+        &command_buffer->deferred_command_buffer);
+  }
+
+  if (iree_status_is_ok(status)) {
+    *out_command_buffer = &command_buffer->base;
+  } else if (command_buffer) {
+    iree_hal_command_buffer_release(&command_buffer->base);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+bool iree_hal_vulkan_indirect_command_buffer_isa(
+    iree_hal_command_buffer_t* command_buffer) {
+  return iree_hal_command_buffer_dyn_cast(
+      command_buffer, &iree_hal_vulkan_indirect_command_buffer_vtable);
+}
+
+static void* iree_hal_vulkan_indirect_command_buffer_dyn_cast(
+    iree_hal_command_buffer_t* command_buffer, const void* vtable) {
+  if (vtable == &iree_hal_vulkan_indirect_command_buffer_vtable) {
+    IREE_HAL_ASSERT_TYPE(command_buffer, vtable);
+    return command_buffer;
+  }
+  return NULL;
+}
+
+// Drops the resolved command buffer such that the next resolve records anew.
+static void iree_hal_vulkan_indirect_command_buffer_reset_resolved(
+    iree_hal_vulkan_indirect_command_buffer_t* command_buffer) {
+  iree_hal_command_buffer_release(command_buffer->resolved_command_buffer);
+  command_buffer->resolved_command_buffer = NULL;
+  command_buffer->resolved_binding_count = 0;
+}
+
+static void iree_hal_vulkan_indirect_command_buffer_destroy(
+    iree_hal_command_buffer_t* base_command_buffer) {
+  iree_hal_vulkan_indirect_command_buffer_t* command_buffer =
+      iree_hal_vulkan_indirect_command_buffer_cast(base_command_buffer);
+  iree_allocator_t host_allocator = command_buffer->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_vulkan_indirect_command_buffer_reset_resolved(command_buffer);
+  iree_allocator_free(host_allocator, command_buffer->resolved_bindings);
+  iree_hal_command_buffer_release(command_buffer->deferred_command_buffer);
+  iree_allocator_free(host_allocator, command_buffer);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+// Returns true if |binding_table| matches the table last resolved against.
+static bool iree_hal_vulkan_indirect_command_buffer_is_resolved(
+    iree_hal_vulkan_indirect_command_buffer_t* command_buffer,
+    iree_hal_buffer_binding_table_t binding_table) {
+  if (!command_buffer->resolved_command_buffer ||
+      command_buffer->resolved_binding_count != binding_table.count) {
+    return false;
+  }
+  for (iree_host_size_t i = 0; i < binding_table.count; ++i) {
+    const iree_hal_buffer_binding_t* lhs =
+        &command_buffer->resolved_bindings[i];
+    const iree_hal_buffer_binding_t* rhs = &binding_table.bindings[i];
+    if (lhs->buffer != rhs->buffer || lhs->offset != rhs->offset ||
+        lhs->length != rhs->length) {
+      return false;
+    }
+  }
+  return true;
+}
+
+iree_status_t iree_hal_vulkan_indirect_command_buffer_resolve(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_buffer_binding_table_t binding_table,
+    iree_hal_command_buffer_t** out_resolved_command_buffer) {
+  iree_hal_vulkan_indirect_command_buffer_t* command_buffer =
+      iree_hal_vulkan_indirect_command_buffer_cast(base_command_buffer);
+  *out_resolved_command_buffer = NULL;
+
+  // Fast path for resubmitting with the same bindings: the VkCommandBuffer
+  // already references the right buffers and can be submitted as-is.
+  if (iree_hal_vulkan_indirect_command_buffer_is_resolved(command_buffer,
+                                                          binding_table)) {
+    *out_resolved_command_buffer = command_buffer->resolved_command_buffer;
+    return iree_ok_status();
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Prior resolved command buffers may still be in-flight and cannot be
+  // re-recorded so a new one is recorded for the new bindings.
+  iree_hal_command_buffer_t* resolved_command_buffer = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_command_buffer_create(
+              command_buffer->device,
+              command_buffer->base.mode &
+                  ~IREE_HAL_COMMAND_BUFFER_MODE_INDIRECT_BINDINGS,
+              command_buffer->base.allowed_categories,
+              command_buffer->base.queue_affinity, &resolved_command_buffer));
+  iree_status_t status = iree_hal_deferred_command_buffer_apply(
+      command_buffer->deferred_command_buffer, resolved_command_buffer,
+      binding_table);
+
+  // Remember the table so that the next submission can reuse the recording.
+  if (iree_status_is_ok(status) &&
+      binding_table.count > command_buffer->resolved_binding_capacity) {
+    status = iree_allocator_realloc(
+        command_buffer->host_allocator,
+        binding_table.count * sizeof(*command_buffer->resolved_bindings),
+        (void**)&command_buffer->resolved_bindings);
+    if (iree_status_is_ok(status)) {
+      command_buffer->resolved_binding_capacity = binding_table.count;
+    }
+  }
+  if (iree_status_is_ok(status)) {
+    iree_hal_vulkan_indirect_command_buffer_reset_resolved(command_buffer);
+    if (binding_table.count > 0) {
+      memcpy(command_buffer->resolved_bindings, binding_table.bindings,
+             binding_table.count * sizeof(*command_buffer->resolved_bindings));
+    }
+    command_buffer->resolved_binding_count = binding_table.count;
+    command_buffer->resolved_command_buffer = resolved_command_buffer;
+    *out_resolved_command_buffer = resolved_command_buffer;
+  } else {
+    iree_hal_command_buffer_release(resolved_command_buffer);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static iree_status_t iree_hal_vulkan_indirect_command_buffer_begin(
+    iree_hal_command_buffer_t* base_command_buffer) {
+  iree_hal_vulkan_indirect_command_buffer_t* command_buffer =
+      iree_hal_vulkan_indirect_command_buffer_cast(base_command_buffer);
+  iree_hal_vulkan_indirect_command_buffer_reset_resolved(command_buffer);
+  return iree_hal_command_buffer_begin(command_buffer->deferred_command_buffer);
+}
+
+static iree_status_t iree_hal_vulkan_indirect_command_buffer_end(
+    iree_hal_command_buffer_t* base_command_buffer) {
+  iree_hal_vulkan_indirect_command_buffer_t* command_buffer =
+      iree_hal_vulkan_indirect_command_buffer_cast(base_command_buffer);
+  return iree_hal_command_buffer_end(command_buffer->deferred_command_buffer);
+}
+
+static void iree_hal_vulkan_indirect_command_buffer_begin_debug_group(
+    iree_hal_command_buffer_t* base_command_buffer, iree_string_view_t label,
+    iree_hal_label_color_t label_color,
+    const iree_hal_label_location_t* location) {
+  iree_hal_vulkan_indirect_command_buffer_t* command_buffer =
+      iree_hal_vulkan_indirect_command_buffer_cast(base_command_buffer);
+  iree_hal_command_buffer_begin_debug_group(
+      command_buffer->deferred_command_buffer, label, label_color, location);
+}
+
+static void iree_hal_vulkan_indirect_command_buffer_end_debug_group(
+    iree_hal_command_buffer_t* base_command_buffer) {
+  iree_hal_vulkan_indirect_command_buffer_t* command_buffer =
+      iree_hal_vulkan_indirect_command_buffer_cast(base_command_buffer);
+  iree_hal_command_buffer_end_debug_group(
+      command_buffer->deferred_command_buffer);
+}
+
+static iree_status_t iree_hal_vulkan_indirect_command_buffer_execution_barrier(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_execution_stage_t source_stage_mask,
+    iree_hal_execution_stage_t target_stage_mask,
+    iree_hal_execution_barrier_flags_t flags,
+    iree_host_size_t memory_barrier_count,
+    const iree_hal_memory_barrier_t* memory_barriers,
+    iree_host_size_t buffer_barrier_count,
+    const iree_hal_buffer_barrier_t* buffer_barriers) {
+  iree_hal_vulkan_indirect_command_buffer_t* command_buffer =
+      iree_hal_vulkan_indirect_command_buffer_cast(base_command_buffer);
+  return iree_hal_command_buffer_execution_barrier(
+      command_buffer->deferred_command_buffer, source_stage_mask,
+      target_stage_mask, flags, memory_barrier_count, memory_barriers,
+      buffer_barrier_count, buffer_barriers);
+}
+
+static iree_status_t iree_hal_vulkan_indirect_command_buffer_signal_event(
+    iree_hal_command_buffer_t* base_command_buffer, iree_hal_event_t* event,
+    iree_hal_execution_stage_t source_stage_mask) {
+  iree_hal_vulkan_indirect_command_buffer_t* command_buffer =
+      iree_hal_vulkan_indirect_command_buffer_cast(base_command_buffer);
+  return iree_hal_command_buffer_signal_event(
+      command_buffer->deferred_command_buffer, event, source_stage_mask);
+}
+
+static iree_status_t iree_hal_vulkan_indirect_command_buffer_reset_event(
+    iree_hal_command_buffer_t* base_command_buffer, iree_hal_event_t* event,
+    iree_hal_execution_stage_t source_stage_mask) {
+  iree_hal_vulkan_indirect_command_buffer_t* command_buffer =
+      iree_hal_vulkan_indirect_command_buffer_cast(base_command_buffer);
+  return iree_hal_command_buffer_reset_event(
+      command_buffer->deferred_command_buffer, event, source_stage_mask);
+}
+
+static iree_status_t iree_hal_vulkan_indirect_command_buffer_wait_events(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_host_size_t event_count, const iree_hal_event_t** events,
+    iree_hal_execution_stage_t source_stage_mask,
+    iree_hal_execution_stage_t target_stage_mask,
+    iree_host_size_t memory_barrier_count,
+    const iree_hal_memory_barrier_t* memory_barriers,
+    iree_host_size_t buffer_barrier_count,
+    const iree_hal_buffer_barrier_t* buffer_barriers) {
+  iree_hal_vulkan_indirect_command_buffer_t* command_buffer =
+      iree_hal_vulkan_indirect_command_buffer_cast(base_command_buffer);
+  return iree_hal_command_buffer_wait_events(
+      command_buffer->deferred_command_buffer, event_count, events,
+      source_stage_mask, target_stage_mask, memory_barrier_count,
+      memory_barriers, buffer_barrier_count, buffer_barriers);
+}
+
+static iree_status_t iree_hal_vulkan_indirect_command_buffer_discard_buffer(
+    iree_hal_command_buffer_t* base_command_buffer, iree_hal_buffer_t* buffer) {
+  iree_hal_vulkan_indirect_command_buffer_t* command_buffer =
+      iree_hal_vulkan_indirect_command_buffer_cast(base_command_buffer);
+  return iree_hal_command_buffer_discard_buffer(
+      command_buffer->deferred_command_buffer, buffer);
+}
+
+static iree_status_t iree_hal_vulkan_indirect_command_buffer_fill_buffer(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_buffer_t* target_buffer, iree_device_size_t target_offset,
+    iree_device_size_t length, const void* pattern,
+    iree_host_size_t pattern_length) {
+  iree_hal_vulkan_indirect_command_buffer_t* command_buffer =
+      iree_hal_vulkan_indirect_command_buffer_cast(base_command_buffer);
+  return iree_hal_command_buffer_fill_buffer(
+      command_buffer->deferred_command_buffer, target_buffer, target_offset,
+      length, pattern, pattern_length);
+}
+
+static iree_status_t iree_hal_vulkan_indirect_command_buffer_update_buffer(
+    iree_hal_command_buffer_t* base_command_buffer, const void* source_buffer,
+    iree_host_size_t source_offset, iree_hal_buffer_t* target_buffer,
+    iree_device_size_t target_offset, iree_device_size_t length) {
+  iree_hal_vulkan_indirect_command_buffer_t* command_buffer =
+      iree_hal_vulkan_indirect_command_buffer_cast(base_command_buffer);
+  return iree_hal_command_buffer_update_buffer(
+      command_buffer->deferred_command_buffer, source_buffer, source_offset,
+      target_buffer, target_offset, length);
+}
+
+static iree_status_t iree_hal_vulkan_indirect_command_buffer_copy_buffer(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_buffer_t* source_buffer, iree_device_size_t source_offset,
+    iree_hal_buffer_t* target_buffer, iree_device_size_t target_offset,
+    iree_device_size_t length) {
+  iree_hal_vulkan_indirect_command_buffer_t* command_buffer =
+      iree_hal_vulkan_indirect_command_buffer_cast(base_command_buffer);
+  return iree_hal_command_buffer_copy_buffer(
+      command_buffer->deferred_command_buffer, source_buffer, source_offset,
+      target_buffer, target_offset, length);
+}
+
+static iree_status_t iree_hal_vulkan_indirect_command_buffer_push_constants(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_executable_layout_t* executable_layout, iree_host_size_t offset,
+    const void* values, iree_host_size_t values_length) {
+  iree_hal_vulkan_indirect_command_buffer_t* command_buffer =
+      iree_hal_vulkan_indirect_command_buffer_cast(base_command_buffer);
+  return iree_hal_command_buffer_push_constants(
+      command_buffer->deferred_command_buffer, executable_layout, offset,
+      values, values_length);
+}
+
+static iree_status_t
+iree_hal_vulkan_indirect_command_buffer_push_descriptor_set(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_executable_layout_t* executable_layout, uint32_t set,
+    iree_host_size_t binding_count,
+    const iree_hal_descriptor_set_binding_t* bindings) {
+  iree_hal_vulkan_indirect_command_buffer_t* command_buffer =
+      iree_hal_vulkan_indirect_command_buffer_cast(base_command_buffer);
+  return iree_hal_command_buffer_push_descriptor_set(
+      command_buffer->deferred_command_buffer, executable_layout, set,
+      binding_count, bindings);
+}
+
+static iree_status_t
+iree_hal_vulkan_indirect_command_buffer_bind_descriptor_set(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_executable_layout_t* executable_layout, uint32_t set,
+    iree_hal_descriptor_set_t* descriptor_set,
+    iree_host_size_t dynamic_offset_count,
+    const iree_device_size_t* dynamic_offsets) {
+  iree_hal_vulkan_indirect_command_buffer_t* command_buffer =
+      iree_hal_vulkan_indirect_command_buffer_cast(base_command_buffer);
+  return iree_hal_command_buffer_bind_descriptor_set(
+      command_buffer->deferred_command_buffer, executable_layout, set,
+      descriptor_set, dynamic_offset_count, dynamic_offsets);
+}
+
+static iree_status_t iree_hal_vulkan_indirect_command_buffer_dispatch(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_executable_t* executable, int32_t entry_point,
+    uint32_t workgroup_x, uint32_t workgroup_y, uint32_t workgroup_z) {
+  iree_hal_vulkan_indirect_command_buffer_t* command_buffer =
+      iree_hal_vulkan_indirect_command_buffer_cast(base_command_buffer);
+  return iree_hal_command_buffer_dispatch(
+      command_buffer->deferred_command_buffer, executable, entry_point,
+      workgroup_x, workgroup_y, workgroup_z);
+}
+
+static iree_status_t iree_hal_vulkan_indirect_command_buffer_dispatch_indirect(
+    iree_hal_command_buffer_t* base_command_buffer,
+    iree_hal_executable_t* executable, int32_t entry_point,
+    iree_hal_buffer_t* workgroups_buffer,
+    iree_device_size_t workgroups_offset) {
+  iree_hal_vulkan_indirect_command_buffer_t* command_buffer =
+      iree_hal_vulkan_indirect_command_buffer_cast(base_command_buffer);
+  return iree_hal_command_buffer_dispatch_indirect(
+      command_buffer->deferred_command_buffer, executable, entry_point,
+      workgroups_buffer, workgroups_offset);
+}
+
+namespace {
+const iree_hal_command_buffer_vtable_t
+    iree_hal_vulkan_indirect_command_buffer_vtable = {
+        /*.destroy=*/iree_hal_vulkan_indirect_command_buffer_destroy,
+        /*.dyn_cast=*/iree_hal_vulkan_indirect_command_buffer_dyn_cast,
+        /*.begin=*/iree_hal_vulkan_indirect_command_buffer_begin,
+        /*.end=*/iree_hal_vulkan_indirect_command_buffer_end,
+        /*.begin_debug_group=*/
+        iree_hal_vulkan_indirect_command_buffer_begin_debug_group,
+        /*.end_debug_group=*/
+        iree_hal_vulkan_indirect_command_buffer_end_debug_group,
+        /*.execution_barrier=*/
+        iree_hal_vulkan_indirect_command_buffer_execution_barrier,
+        /*.signal_event=*/
+        iree_hal_vulkan_indirect_command_buffer_signal_event,
+        /*.reset_event=*/iree_hal_vulkan_indirect_command_buffer_reset_event,
+        /*.wait_events=*/iree_hal_vulkan_indirect_command_buffer_wait_events,
+        /*.discard_buffer=*/
+        iree_hal_vulkan_indirect_command_buffer_discard_buffer,
+        /*.fill_buffer=*/iree_hal_vulkan_indirect_command_buffer_fill_buffer,
+        /*.update_buffer=*/
+        iree_hal_vulkan_indirect_command_buffer_update_buffer,
+        /*.copy_buffer=*/iree_hal_vulkan_indirect_command_buffer_copy_buffer,
+        /*.push_constants=*/
+        iree_hal_vulkan_indirect_command_buffer_push_constants,
+        /*.push_descriptor_set=*/
+        iree_hal_vulkan_indirect_command_buffer_push_descriptor_set,
+        /*.bind_descriptor_set=*/
+        iree_hal_vulkan_indirect_command_buffer_bind_descriptor_set,
+        /*.dispatch=*/iree_hal_vulkan_indirect_command_buffer_dispatch,
+        /*.dispatch_indirect=*/
+        iree_hal_vulkan_indirect_command_buffer_dispatch_indirect,
+};
+}  // namespace
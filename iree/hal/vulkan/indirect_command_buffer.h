@@ -0,0 +1,57 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_VULKAN_INDIRECT_COMMAND_BUFFER_H_
+#define IREE_HAL_VULKAN_INDIRECT_COMMAND_BUFFER_H_
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+typedef struct iree_arena_block_pool_t iree_arena_block_pool_t;
+
+// Creates a command buffer recorded with
+// IREE_HAL_COMMAND_BUFFER_MODE_INDIRECT_BINDINGS.
+//
+// Commands are recorded in memory and resolved against the binding table of
+// each submission into a direct command buffer created from |device|. The
+// resolved VkCommandBuffer is kept and resubmitted as-is for as long as the
+// binding table does not change such that reusable command buffers submitted
+// with the same buffers every time (as with static graphs) are only recorded
+// into Vulkan once.
+//
+// NOTE: the |block_pool| must remain live for the lifetime of the command
+// buffers that use it.
+iree_status_t iree_hal_vulkan_indirect_command_buffer_create(
+    iree_hal_device_t* device, iree_hal_command_buffer_mode_t mode,
+    iree_hal_command_category_t command_categories,
+    iree_hal_queue_affinity_t queue_affinity,
+    iree_arena_block_pool_t* block_pool, iree_allocator_t host_allocator,
+    iree_hal_command_buffer_t** out_command_buffer);
+
+// Returns true if |command_buffer| is a Vulkan indirect command buffer.
+bool iree_hal_vulkan_indirect_command_buffer_isa(
+    iree_hal_command_buffer_t* command_buffer);
+
+// Returns a direct command buffer containing the recorded commands with all
+// indirect bindings resolved against |binding_table|. The command buffer
+// returned by the prior call is returned again if |binding_table| references
+// the same buffer ranges. The returned command buffer is owned by
+// |command_buffer| and must be retained by the caller until all submissions
+// of it have completed.
+iree_status_t iree_hal_vulkan_indirect_command_buffer_resolve(
+    iree_hal_command_buffer_t* command_buffer,
+    iree_hal_buffer_binding_table_t binding_table,
+    iree_hal_command_buffer_t** out_resolved_command_buffer);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_VULKAN_INDIRECT_COMMAND_BUFFER_H_
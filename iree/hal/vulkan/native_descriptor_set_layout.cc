@@ -8,6 +8,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 
 #include "iree/base/api.h"
 #include "iree/base/tracing.h"
@@ -22,6 +23,9 @@ typedef struct iree_hal_vulkan_native_descriptor_set_layout_t {
   iree_hal_resource_t resource;
   VkDeviceHandle* logical_device;
   VkDescriptorSetLayout handle;
+  iree_hal_descriptor_set_layout_usage_type_t usage_type;
+  iree_host_size_t binding_count;
+  iree_hal_descriptor_set_layout_binding_t bindings[];
 } iree_hal_vulkan_native_descriptor_set_layout_t;
 
 namespace {
@@ -111,15 +115,22 @@ iree_status_t iree_hal_vulkan_native_descriptor_set_layout_create(
               logical_device, usage_type, binding_count, bindings, &handle));
 
   iree_hal_vulkan_native_descriptor_set_layout_t* descriptor_set_layout = NULL;
-  iree_status_t status = iree_allocator_malloc(logical_device->host_allocator(),
-                                               sizeof(*descriptor_set_layout),
-                                               (void**)&descriptor_set_layout);
+  iree_host_size_t total_size =
+      sizeof(*descriptor_set_layout) +
+      binding_count * sizeof(*descriptor_set_layout->bindings);
+  iree_status_t status =
+      iree_allocator_malloc(logical_device->host_allocator(), total_size,
+                            (void**)&descriptor_set_layout);
   if (iree_status_is_ok(status)) {
     iree_hal_resource_initialize(
         &iree_hal_vulkan_native_descriptor_set_layout_vtable,
         &descriptor_set_layout->resource);
     descriptor_set_layout->logical_device = logical_device;
     descriptor_set_layout->handle = handle;
+    descriptor_set_layout->usage_type = usage_type;
+    descriptor_set_layout->binding_count = binding_count;
+    memcpy(descriptor_set_layout->bindings, bindings,
+           binding_count * sizeof(*descriptor_set_layout->bindings));
     *out_descriptor_set_layout =
         (iree_hal_descriptor_set_layout_t*)descriptor_set_layout;
   } else {
@@ -154,6 +165,26 @@ VkDescriptorSetLayout iree_hal_vulkan_native_descriptor_set_layout_handle(
   return descriptor_set_layout->handle;
 }
 
+iree_hal_descriptor_set_layout_usage_type_t
+iree_hal_vulkan_native_descriptor_set_layout_usage_type(
+    iree_hal_descriptor_set_layout_t* base_descriptor_set_layout) {
+  iree_hal_vulkan_native_descriptor_set_layout_t* descriptor_set_layout =
+      iree_hal_vulkan_native_descriptor_set_layout_cast(
+          base_descriptor_set_layout);
+  return descriptor_set_layout->usage_type;
+}
+
+const iree_hal_descriptor_set_layout_binding_t*
+iree_hal_vulkan_native_descriptor_set_layout_bindings(
+    iree_hal_descriptor_set_layout_t* base_descriptor_set_layout,
+    iree_host_size_t* out_binding_count) {
+  iree_hal_vulkan_native_descriptor_set_layout_t* descriptor_set_layout =
+      iree_hal_vulkan_native_descriptor_set_layout_cast(
+          base_descriptor_set_layout);
+  *out_binding_count = descriptor_set_layout->binding_count;
+  return descriptor_set_layout->bindings;
+}
+
 namespace {
 const iree_hal_descriptor_set_layout_vtable_t
     iree_hal_vulkan_native_descriptor_set_layout_vtable = {
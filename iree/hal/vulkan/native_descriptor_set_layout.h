@@ -27,6 +27,17 @@ iree_status_t iree_hal_vulkan_native_descriptor_set_layout_create(
 VkDescriptorSetLayout iree_hal_vulkan_native_descriptor_set_layout_handle(
     iree_hal_descriptor_set_layout_t* base_descriptor_set_layout);
 
+// Returns the usage type the descriptor set layout was created with.
+iree_hal_descriptor_set_layout_usage_type_t
+iree_hal_vulkan_native_descriptor_set_layout_usage_type(
+    iree_hal_descriptor_set_layout_t* base_descriptor_set_layout);
+
+// Returns the bindings the descriptor set layout was created with.
+const iree_hal_descriptor_set_layout_binding_t*
+iree_hal_vulkan_native_descriptor_set_layout_bindings(
+    iree_hal_descriptor_set_layout_t* base_descriptor_set_layout,
+    iree_host_size_t* out_binding_count);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
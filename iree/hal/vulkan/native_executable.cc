@@ -11,6 +11,7 @@
 #include <cstring>
 
 #include "iree/base/api.h"
+#include "iree/base/internal/synchronization.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/vulkan/dynamic_symbol_tables.h"
 #include "iree/hal/vulkan/dynamic_symbols.h"
@@ -26,11 +27,57 @@
 
 using namespace iree::hal::vulkan;
 
+// A 4-byte specialization constant value.
+typedef struct iree_hal_vulkan_specialization_constant_t {
+  uint32_t constant_id;
+  uint32_t value;
+} iree_hal_vulkan_specialization_constant_t;
+
+// Push constant values an entry point has been dispatched with.
+typedef struct iree_hal_vulkan_pipeline_specialization_t {
+  // Values of the leading specializable push constants of the entry point.
+  uint32_t values[IREE_HAL_VULKAN_MAX_SPECIALIZED_PUSH_CONSTANT_COUNT];
+  // Number of dispatches that used the values until the pipeline is created.
+  uint32_t use_count;
+  // Pipeline specialized on the values or VK_NULL_HANDLE until |use_count|
+  // reaches the specialization threshold of the executable.
+  VkPipeline pipeline;
+} iree_hal_vulkan_pipeline_specialization_t;
+
 typedef struct iree_hal_vulkan_entry_point_t {
   VkPipeline pipeline;
   iree_string_view_t name;
+
+  // Number of leading push constants pipelines may be specialized on or 0 if
+  // the entry point is not specialized.
+  iree_host_size_t specializable_push_constant_count;
+  // Tracked push constant values with storage for
+  // IREE_HAL_VULKAN_MAX_PIPELINE_SPECIALIZATION_COUNT. Guarded by the
+  // specialization mutex of the executable.
+  iree_host_size_t specialization_count;
+  iree_hal_vulkan_pipeline_specialization_t* specializations;
 } iree_hal_vulkan_entry_point_t;
 
+// Populates |out_info| to reference |constant_count| 4-byte |constants|.
+// |out_entries| must have storage for |constant_count| entries. Both arrays
+// must remain valid until the pipelines using |out_info| have been created.
+static void iree_hal_vulkan_populate_specialization_info(
+    iree_host_size_t constant_count,
+    const iree_hal_vulkan_specialization_constant_t* constants,
+    VkSpecializationMapEntry* out_entries, VkSpecializationInfo* out_info) {
+  for (iree_host_size_t i = 0; i < constant_count; ++i) {
+    out_entries[i].constantID = constants[i].constant_id;
+    out_entries[i].offset =
+        (uint32_t)(i * sizeof(constants[0]) +
+                   offsetof(iree_hal_vulkan_specialization_constant_t, value));
+    out_entries[i].size = sizeof(constants[i].value);
+  }
+  out_info->mapEntryCount = (uint32_t)constant_count;
+  out_info->pMapEntries = out_entries;
+  out_info->dataSize = constant_count * sizeof(constants[0]);
+  out_info->pData = constants;
+}
+
 static iree_status_t iree_hal_vulkan_create_shader_module(
     VkDeviceHandle* logical_device, iree_const_byte_span_t code,
     VkShaderModule* out_shader_module) {
@@ -61,15 +108,27 @@ static iree_status_t iree_hal_vulkan_create_pipelines(
     iree_SpirVExecutableDef_table_t executable_def,
     VkShaderModule shader_module, iree_host_size_t executable_layout_count,
     iree_hal_executable_layout_t* const* executable_layouts,
+    iree_host_size_t specialization_constant_count,
+    const iree_hal_vulkan_specialization_constant_t* specialization_constants,
     iree_host_size_t pipeline_count,
     iree_hal_vulkan_entry_point_t* out_entry_points) {
   IREE_TRACE_SCOPE();
   VkComputePipelineCreateInfo* create_infos = NULL;
   IREE_RETURN_IF_ERROR(iree_allocator_malloc(
       logical_device->host_allocator(),
-      pipeline_count * sizeof(VkComputePipelineCreateInfo),
+      pipeline_count * sizeof(VkComputePipelineCreateInfo) +
+          specialization_constant_count * sizeof(VkSpecializationMapEntry),
       (void**)&create_infos));
 
+  // All pipelines share the static specialization constants.
+  VkSpecializationInfo specialization_info;
+  if (specialization_constant_count > 0) {
+    iree_hal_vulkan_populate_specialization_info(
+        specialization_constant_count, specialization_constants,
+        (VkSpecializationMapEntry*)(create_infos + pipeline_count),
+        &specialization_info);
+  }
+
   flatbuffers_string_vec_t entry_points_vec =
       iree_SpirVExecutableDef_entry_points_get(executable_def);
   for (iree_host_size_t entry_ordinal = 0; entry_ordinal < pipeline_count;
@@ -101,7 +160,8 @@ static iree_status_t iree_hal_vulkan_create_pipelines(
     stage_create_info->module = shader_module;
     stage_create_info->pName =
         flatbuffers_string_vec_at(entry_points_vec, entry_ordinal);
-    stage_create_info->pSpecializationInfo = NULL;
+    stage_create_info->pSpecializationInfo =
+        specialization_constant_count > 0 ? &specialization_info : NULL;
   }
 
   VkPipeline* pipelines =
@@ -133,8 +193,14 @@ static void iree_hal_vulkan_destroy_pipeline(VkDeviceHandle* logical_device,
 // runtime. There are still some conditions we must be aware of (such as omitted
 // names on functions with internal linkage), however we shouldn't need to
 // bounds check anything within the flatbuffer after this succeeds.
+//
+// Executables prepared with
+// IREE_HAL_EXECUTABLE_CACHING_MODE_DISABLE_VERIFICATION come from trusted
+// sources and only have their file identifier checked. This avoids walking
+// executables that may be hundreds of MB at load time.
 static iree_status_t iree_hal_spirv_executable_flatbuffer_verify(
     iree_const_byte_span_t flatbuffer_data,
+    iree_hal_executable_caching_mode_t caching_mode,
     iree_host_size_t expected_entry_point_count) {
   if (!flatbuffer_data.data || flatbuffer_data.data_length < 16) {
     return iree_make_status(
@@ -143,6 +209,18 @@ static iree_status_t iree_hal_spirv_executable_flatbuffer_verify(
         flatbuffer_data.data_length);
   }
 
+  if (iree_all_bits_set(
+          caching_mode,
+          IREE_HAL_EXECUTABLE_CACHING_MODE_DISABLE_VERIFICATION)) {
+    if (!iree_SpirVExecutableDef_as_root(flatbuffer_data.data)) {
+      return iree_make_status(
+          IREE_STATUS_INVALID_ARGUMENT,
+          "executable is missing the expected '"
+          iree_SpirVExecutableDef_file_identifier "' file identifier");
+    }
+    return iree_ok_status();
+  }
+
   // Run flatcc generated verification. This ensures all pointers are in-bounds
   // and that we can safely walk the file, but not that the actual contents of
   // the flatbuffer meet our expectations.
@@ -181,12 +259,54 @@ static iree_status_t iree_hal_spirv_executable_flatbuffer_verify(
                             "executable SPIR-V code is missing/empty");
   }
 
-  // TODO(benvanik): pull PopulateSpecializationInfo from history and update.
-  // For now the compiler isn't generating them, and we don't use them.
-  if (iree_SpirVExecutableDef_specialization_info_is_present(executable_def)) {
-    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
-                            "executable uses SPIR-V specialization constants; "
-                            "they need to be revived");
+  // Specialization constant IDs [0, 2 * count) of the entry point with the most
+  // specializable push constants are reserved for push constant
+  // specialization and must not be provided statically.
+  uint32_t reserved_constant_id_count = 0;
+  flatbuffers_uint32_vec_t specializable_counts_vec =
+      iree_SpirVExecutableDef_specializable_push_constant_counts_get(
+          executable_def);
+  if (specializable_counts_vec) {
+    if (flatbuffers_uint32_vec_len(specializable_counts_vec) !=
+        entry_point_count) {
+      return iree_make_status(
+          IREE_STATUS_INVALID_ARGUMENT,
+          "executable specializable push constant counts (%zu) must match the "
+          "entry point count (%zu)",
+          flatbuffers_uint32_vec_len(specializable_counts_vec),
+          entry_point_count);
+    }
+    for (size_t i = 0; i < entry_point_count; ++i) {
+      uint32_t count = flatbuffers_uint32_vec_at(specializable_counts_vec, i);
+      if (count > UINT32_MAX / 2) {
+        return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                                "executable entry point %zu has an invalid "
+                                "specializable push constant count %u",
+                                i, count);
+      }
+      reserved_constant_id_count =
+          iree_max(reserved_constant_id_count, 2 * count);
+    }
+  }
+
+  iree_VkSpecializationInfoDef_table_t specialization_info_def =
+      iree_SpirVExecutableDef_specialization_info_get(executable_def);
+  iree_VkSpecializationMapEntryDef_vec_t map_entries_vec =
+      specialization_info_def
+          ? iree_VkSpecializationInfoDef_map_entries_get(
+                specialization_info_def)
+          : NULL;
+  for (size_t i = 0; i < iree_VkSpecializationMapEntryDef_vec_len(
+                             map_entries_vec);
+       ++i) {
+    uint32_t constant_id = iree_VkSpecializationMapEntryDef_constant_id_get(
+        iree_VkSpecializationMapEntryDef_vec_at(map_entries_vec, i));
+    if (constant_id < reserved_constant_id_count) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "executable specialization constant %u is "
+                              "reserved for push constant specialization",
+                              constant_id);
+    }
   }
 
   return iree_ok_status();
@@ -195,6 +315,34 @@ static iree_status_t iree_hal_spirv_executable_flatbuffer_verify(
 typedef struct iree_hal_vulkan_native_executable_t {
   iree_hal_resource_t resource;
   VkDeviceHandle* logical_device;
+
+  // Creates the pipelines, possibly on a pool worker. Pipelines are only valid
+  // once the preparation completes.
+  iree_hal_preparation_t preparation;
+  VkPipelineCache pipeline_cache;
+  iree_hal_executable_caching_mode_t caching_mode;
+  // References the executable data which must remain live until the
+  // preparation completes.
+  iree_SpirVExecutableDef_table_t executable_def;
+  // Destroyed once the pipelines have been created unless pipelines
+  // specialized on push constant values may be created later on.
+  VkShaderModule shader_module;
+  // Retained layouts referenced by the pipelines, one per entry point.
+  iree_hal_executable_layout_t** executable_layouts;
+
+  // Static specialization constants applied to all pipelines.
+  iree_host_size_t specialization_constant_count;
+  iree_hal_vulkan_specialization_constant_t* specialization_constants;
+
+  // Number of dispatches with the same push constant values after which a
+  // pipeline specialized on them is created. 0 if disabled.
+  uint32_t specialization_threshold;
+  // True if any entry point may have specialized pipelines created.
+  bool is_specializable;
+  // Guards the specialization state of all entry points. Specialized
+  // pipelines are created with the mutex held.
+  iree_slim_mutex_t specialization_mutex;
+
   iree_host_size_t entry_point_count;
   iree_hal_vulkan_entry_point_t entry_points[];
 } iree_hal_vulkan_native_executable_t;
@@ -210,9 +358,102 @@ iree_hal_vulkan_native_executable_cast(iree_hal_executable_t* base_value) {
   return (iree_hal_vulkan_native_executable_t*)base_value;
 }
 
+// Creates the pipelines for all entry points. Drivers compile the SPIR-V to
+// device code here and this dominates executable creation time.
+static iree_status_t iree_hal_vulkan_native_executable_create_pipelines(
+    void* user_data) {
+  iree_hal_vulkan_native_executable_t* executable =
+      (iree_hal_vulkan_native_executable_t*)user_data;
+  iree_status_t status = iree_hal_vulkan_create_pipelines(
+      executable->logical_device, executable->pipeline_cache,
+      executable->caching_mode, executable->executable_def,
+      executable->shader_module, executable->entry_point_count,
+      executable->executable_layouts,
+      executable->specialization_constant_count,
+      executable->specialization_constants, executable->entry_point_count,
+      executable->entry_points);
+  if (!executable->is_specializable) {
+    iree_hal_vulkan_destroy_shader_module(executable->logical_device,
+                                          executable->shader_module);
+    executable->shader_module = VK_NULL_HANDLE;
+  }
+  return status;
+}
+
+// Creates a pipeline for |entry_ordinal| with its leading specializable push
+// constants specialized to |values|.
+static iree_status_t
+iree_hal_vulkan_native_executable_create_specialized_pipeline(
+    iree_hal_vulkan_native_executable_t* executable,
+    iree_host_size_t entry_ordinal, const uint32_t* values,
+    VkPipeline* out_pipeline) {
+  IREE_TRACE_SCOPE();
+  VkDeviceHandle* logical_device = executable->logical_device;
+  iree_hal_vulkan_entry_point_t* entry_point =
+      &executable->entry_points[entry_ordinal];
+
+  // Each push constant is specialized with a value and a boolean selecting it.
+  iree_host_size_t constant_count =
+      executable->specialization_constant_count +
+      2 * entry_point->specializable_push_constant_count;
+  iree_hal_vulkan_specialization_constant_t* constants = NULL;
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+      logical_device->host_allocator(),
+      constant_count * (sizeof(*constants) + sizeof(VkSpecializationMapEntry)),
+      (void**)&constants));
+  memcpy(constants, executable->specialization_constants,
+         executable->specialization_constant_count * sizeof(*constants));
+  iree_hal_vulkan_specialization_constant_t* push_constants =
+      constants + executable->specialization_constant_count;
+  for (iree_host_size_t i = 0;
+       i < entry_point->specializable_push_constant_count; ++i) {
+    push_constants[2 * i + 0].constant_id = (uint32_t)(2 * i + 0);
+    push_constants[2 * i + 0].value = values[i];
+    push_constants[2 * i + 1].constant_id = (uint32_t)(2 * i + 1);
+    push_constants[2 * i + 1].value = VK_TRUE;
+  }
+  VkSpecializationInfo specialization_info;
+  iree_hal_vulkan_populate_specialization_info(
+      constant_count, constants,
+      (VkSpecializationMapEntry*)(constants + constant_count),
+      &specialization_info);
+
+  VkComputePipelineCreateInfo create_info;
+  create_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+  create_info.pNext = NULL;
+  create_info.flags = 0;
+  if (!iree_all_bits_set(executable->caching_mode,
+                         IREE_HAL_EXECUTABLE_CACHING_MODE_ALLOW_OPTIMIZATION)) {
+    create_info.flags |= VK_PIPELINE_CREATE_DISABLE_OPTIMIZATION_BIT;
+  }
+  create_info.layout = iree_hal_vulkan_native_executable_layout_handle(
+      executable->executable_layouts[entry_ordinal]);
+  create_info.basePipelineHandle = VK_NULL_HANDLE;
+  create_info.basePipelineIndex = -1;
+  create_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  create_info.stage.pNext = NULL;
+  create_info.stage.flags = 0;
+  create_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+  create_info.stage.module = executable->shader_module;
+  // Names reference the executable flatbuffer and are NUL-terminated.
+  create_info.stage.pName = entry_point->name.data;
+  create_info.stage.pSpecializationInfo = &specialization_info;
+
+  iree_status_t status = VK_RESULT_TO_STATUS(
+      logical_device->syms()->vkCreateComputePipelines(
+          *logical_device, executable->pipeline_cache, 1, &create_info,
+          logical_device->allocator(), out_pipeline),
+      "vkCreateComputePipelines");
+
+  iree_allocator_free(logical_device->host_allocator(), constants);
+  return status;
+}
+
 iree_status_t iree_hal_vulkan_native_executable_create(
     iree::hal::vulkan::VkDeviceHandle* logical_device,
     VkPipelineCache pipeline_cache,
+    iree_hal_preparation_pool_t* preparation_pool,
+    uint32_t specialization_threshold,
     const iree_hal_executable_spec_t* executable_spec,
     iree_hal_executable_t** out_executable) {
   IREE_ASSERT_ARGUMENT(logical_device);
@@ -224,7 +465,7 @@ iree_status_t iree_hal_vulkan_native_executable_create(
   // Verify and fetch the executable flatbuffer wrapper.
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
       z0, iree_hal_spirv_executable_flatbuffer_verify(
-              executable_spec->executable_data,
+              executable_spec->executable_data, executable_spec->caching_mode,
               executable_spec->executable_layout_count));
   iree_SpirVExecutableDef_table_t executable_def =
       iree_SpirVExecutableDef_as_root(executable_spec->executable_data.data);
@@ -241,44 +482,114 @@ iree_status_t iree_hal_vulkan_native_executable_create(
                   flatbuffers_uint32_vec_len(code_vec) * sizeof(uint32_t)),
               &shader_module));
 
-  // Create pipelines for each entry point.
   flatbuffers_string_vec_t entry_points_vec =
       iree_SpirVExecutableDef_entry_points_get(executable_def);
   iree_host_size_t entry_point_count =
       flatbuffers_string_vec_len(entry_points_vec);
+  iree_VkSpecializationInfoDef_table_t specialization_info_def =
+      iree_SpirVExecutableDef_specialization_info_get(executable_def);
+  iree_VkSpecializationMapEntryDef_vec_t map_entries_vec =
+      specialization_info_def
+          ? iree_VkSpecializationInfoDef_map_entries_get(
+                specialization_info_def)
+          : NULL;
+  iree_host_size_t specialization_constant_count =
+      iree_VkSpecializationMapEntryDef_vec_len(map_entries_vec);
+
+  // Specialized pipelines need the shader module to outlive preparation and
+  // storage to track the push constant values of each entry point.
+  flatbuffers_uint32_vec_t specializable_counts_vec =
+      specialization_threshold > 0
+          ? iree_SpirVExecutableDef_specializable_push_constant_counts_get(
+                executable_def)
+          : NULL;
+  bool is_specializable = false;
+  for (iree_host_size_t i = 0;
+       i < flatbuffers_uint32_vec_len(specializable_counts_vec); ++i) {
+    is_specializable |=
+        flatbuffers_uint32_vec_at(specializable_counts_vec, i) > 0;
+  }
 
   iree_hal_vulkan_native_executable_t* executable = NULL;
   iree_host_size_t total_size =
       sizeof(*executable) +
-      entry_point_count * sizeof(*executable->entry_points);
+      entry_point_count * sizeof(*executable->entry_points) +
+      entry_point_count * sizeof(*executable->executable_layouts) +
+      specialization_constant_count *
+          sizeof(*executable->specialization_constants);
+  iree_host_size_t specializations_offset = total_size;
+  if (is_specializable) {
+    total_size += entry_point_count *
+                  IREE_HAL_VULKAN_MAX_PIPELINE_SPECIALIZATION_COUNT *
+                  sizeof(iree_hal_vulkan_pipeline_specialization_t);
+  }
   iree_status_t status = iree_allocator_malloc(logical_device->host_allocator(),
                                                total_size, (void**)&executable);
-  if (iree_status_is_ok(status)) {
-    iree_hal_resource_initialize(&iree_hal_vulkan_native_executable_vtable,
-                                 &executable->resource);
-    executable->logical_device = logical_device;
-    executable->entry_point_count = entry_point_count;
-    memset(executable->entry_points, 0,
-           entry_point_count * sizeof(*executable->entry_points));
+  if (!iree_status_is_ok(status)) {
+    iree_hal_vulkan_destroy_shader_module(logical_device, shader_module);
+    IREE_TRACE_ZONE_END(z0);
+    return status;
   }
-  if (iree_status_is_ok(status)) {
-    status = iree_hal_vulkan_create_pipelines(
-        logical_device, pipeline_cache, executable_spec->caching_mode,
-        executable_def, shader_module, executable_spec->executable_layout_count,
-        executable_spec->executable_layouts, executable->entry_point_count,
-        executable->entry_points);
+  memset(executable, 0, total_size);
+  iree_hal_resource_initialize(&iree_hal_vulkan_native_executable_vtable,
+                               &executable->resource);
+  executable->logical_device = logical_device;
+  executable->pipeline_cache = pipeline_cache;
+  executable->caching_mode = executable_spec->caching_mode;
+  executable->executable_def = executable_def;
+  executable->shader_module = shader_module;
+  executable->executable_layouts =
+      (iree_hal_executable_layout_t**)((uint8_t*)executable +
+                                       sizeof(*executable) +
+                                       entry_point_count *
+                                           sizeof(*executable->entry_points));
+  executable->specialization_constant_count = specialization_constant_count;
+  executable->specialization_constants =
+      (iree_hal_vulkan_specialization_constant_t*)(executable
+                                                       ->executable_layouts +
+                                                   entry_point_count);
+  for (iree_host_size_t i = 0; i < specialization_constant_count; ++i) {
+    iree_VkSpecializationMapEntryDef_table_t map_entry_def =
+        iree_VkSpecializationMapEntryDef_vec_at(map_entries_vec, i);
+    executable->specialization_constants[i].constant_id =
+        iree_VkSpecializationMapEntryDef_constant_id_get(map_entry_def);
+    executable->specialization_constants[i].value =
+        iree_VkSpecializationMapEntryDef_uint32_value_get(map_entry_def);
   }
-  iree_hal_vulkan_destroy_shader_module(logical_device, shader_module);
-
-  if (iree_status_is_ok(status)) {
-    flatbuffers_string_vec_t entry_points_vec =
-        iree_SpirVExecutableDef_entry_points_get(executable_def);
-    for (iree_host_size_t i = 0; i < entry_point_count; ++i) {
-      flatbuffers_string_t name =
-          flatbuffers_string_vec_at(entry_points_vec, i);
-      executable->entry_points[i].name =
-          iree_make_string_view(name, flatbuffers_string_len(name));
+  executable->specialization_threshold = specialization_threshold;
+  executable->is_specializable = is_specializable;
+  iree_slim_mutex_initialize(&executable->specialization_mutex);
+  executable->entry_point_count = entry_point_count;
+  for (iree_host_size_t i = 0; i < entry_point_count; ++i) {
+    flatbuffers_string_t name = flatbuffers_string_vec_at(entry_points_vec, i);
+    executable->entry_points[i].name =
+        iree_make_string_view(name, flatbuffers_string_len(name));
+    if (is_specializable) {
+      executable->entry_points[i].specializable_push_constant_count =
+          iree_min(flatbuffers_uint32_vec_at(specializable_counts_vec, i),
+                   IREE_HAL_VULKAN_MAX_SPECIALIZED_PUSH_CONSTANT_COUNT);
+      executable->entry_points[i].specializations =
+          (iree_hal_vulkan_pipeline_specialization_t*)((uint8_t*)executable +
+                                                       specializations_offset) +
+          i * IREE_HAL_VULKAN_MAX_PIPELINE_SPECIALIZATION_COUNT;
     }
+    executable->executable_layouts[i] = executable_spec->executable_layouts[i];
+    iree_hal_executable_layout_retain(executable->executable_layouts[i]);
+  }
+
+  // Pipeline creation can only be deferred if the executable data outlives
+  // the call; otherwise create inline so that failures are reported
+  // immediately.
+  if (!iree_all_bits_set(
+          executable_spec->caching_mode,
+          IREE_HAL_EXECUTABLE_CACHING_MODE_ALIAS_PROVIDED_DATA)) {
+    preparation_pool = NULL;
+  }
+  iree_hal_preparation_initialize(
+      preparation_pool, iree_hal_vulkan_native_executable_create_pipelines,
+      executable, &executable->preparation);
+  if (!preparation_pool) {
+    status = iree_hal_preparation_wait(&executable->preparation);
   }
 
   if (iree_status_is_ok(status)) {
@@ -299,10 +610,23 @@ static void iree_hal_vulkan_native_executable_destroy(
       executable->logical_device->host_allocator();
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  // Cancels or waits for any pending pipeline creation.
+  iree_hal_preparation_deinitialize(&executable->preparation);
+  iree_hal_vulkan_destroy_shader_module(executable->logical_device,
+                                        executable->shader_module);
+
   for (iree_host_size_t i = 0; i < executable->entry_point_count; ++i) {
+    iree_hal_vulkan_entry_point_t* entry_point = &executable->entry_points[i];
+    for (iree_host_size_t j = 0; j < entry_point->specialization_count; ++j) {
+      iree_hal_vulkan_destroy_pipeline(
+          executable->logical_device,
+          entry_point->specializations[j].pipeline);
+    }
     iree_hal_vulkan_destroy_pipeline(executable->logical_device,
-                                     executable->entry_points[i].pipeline);
+                                     entry_point->pipeline);
+    iree_hal_executable_layout_release(executable->executable_layouts[i]);
   }
+  iree_slim_mutex_deinitialize(&executable->specialization_mutex);
   iree_allocator_free(host_allocator, executable);
 
   IREE_TRACE_ZONE_END(z0);
@@ -333,10 +657,76 @@ iree_status_t iree_hal_vulkan_native_executable_pipeline_for_entry_point(
     return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
                             "invalid entry point ordinal %zu", entry_ordinal);
   }
+  *out_pipeline_handle = VK_NULL_HANDLE;
+  IREE_RETURN_IF_ERROR(iree_hal_preparation_wait(&executable->preparation));
   *out_pipeline_handle = executable->entry_points[entry_ordinal].pipeline;
   return iree_ok_status();
 }
 
+iree_status_t iree_hal_vulkan_native_executable_pipeline_for_dispatch(
+    iree_hal_executable_t* base_executable, iree_host_size_t entry_ordinal,
+    iree_host_size_t push_constant_count, const uint32_t* push_constants,
+    VkPipeline* out_pipeline_handle) {
+  iree_hal_vulkan_native_executable_t* executable =
+      iree_hal_vulkan_native_executable_cast(base_executable);
+  IREE_RETURN_IF_ERROR(
+      iree_hal_vulkan_native_executable_pipeline_for_entry_point(
+          base_executable, entry_ordinal, out_pipeline_handle));
+  iree_hal_vulkan_entry_point_t* entry_point =
+      &executable->entry_points[entry_ordinal];
+  iree_host_size_t value_count = entry_point->specializable_push_constant_count;
+  if (value_count == 0 || push_constant_count < value_count) {
+    return iree_ok_status();
+  }
+  iree_host_size_t values_size = value_count * sizeof(push_constants[0]);
+
+  iree_slim_mutex_lock(&executable->specialization_mutex);
+
+  // Find the values or start tracking them, replacing the least used values
+  // that have not been specialized yet once all slots are in use.
+  iree_hal_vulkan_pipeline_specialization_t* specialization = NULL;
+  iree_hal_vulkan_pipeline_specialization_t* replaceable = NULL;
+  for (iree_host_size_t i = 0; i < entry_point->specialization_count; ++i) {
+    iree_hal_vulkan_pipeline_specialization_t* candidate =
+        &entry_point->specializations[i];
+    if (memcmp(candidate->values, push_constants, values_size) == 0) {
+      specialization = candidate;
+      break;
+    }
+    if (candidate->pipeline == VK_NULL_HANDLE &&
+        (!replaceable || candidate->use_count < replaceable->use_count)) {
+      replaceable = candidate;
+    }
+  }
+  if (!specialization) {
+    if (entry_point->specialization_count <
+        IREE_HAL_VULKAN_MAX_PIPELINE_SPECIALIZATION_COUNT) {
+      specialization =
+          &entry_point->specializations[entry_point->specialization_count++];
+    } else {
+      specialization = replaceable;
+    }
+    if (specialization) {
+      memcpy(specialization->values, push_constants, values_size);
+      specialization->use_count = 0;
+    }
+  }
+
+  iree_status_t status = iree_ok_status();
+  if (specialization && specialization->pipeline == VK_NULL_HANDLE &&
+      ++specialization->use_count >= executable->specialization_threshold) {
+    status = iree_hal_vulkan_native_executable_create_specialized_pipeline(
+        executable, entry_ordinal, specialization->values,
+        &specialization->pipeline);
+  }
+  if (specialization && specialization->pipeline != VK_NULL_HANDLE) {
+    *out_pipeline_handle = specialization->pipeline;
+  }
+
+  iree_slim_mutex_unlock(&executable->specialization_mutex);
+  return status;
+}
+
 namespace {
 const iree_hal_executable_vtable_t iree_hal_vulkan_native_executable_vtable = {
     /*.destroy=*/iree_hal_vulkan_native_executable_destroy,
@@ -13,12 +13,21 @@
 
 #include "iree/base/api.h"
 #include "iree/hal/api.h"
+#include "iree/hal/utils/preparation_pool.h"
 #include "iree/hal/vulkan/handle_util.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif  // __cplusplus
 
+// Maximum number of leading push constants specialized pipelines are keyed on.
+// Executables exposing more only specialize the first ones.
+#define IREE_HAL_VULKAN_MAX_SPECIALIZED_PUSH_CONSTANT_COUNT 16
+
+// Maximum number of specialized pipelines tracked per entry point. Dispatches
+// with values beyond those use the generic pipeline.
+#define IREE_HAL_VULKAN_MAX_PIPELINE_SPECIALIZATION_COUNT 4
+
 typedef struct iree_hal_vulkan_source_location_t {
   iree_string_view_t file_name;
   int line;
@@ -28,9 +37,19 @@ typedef struct iree_hal_vulkan_source_location_t {
 // Creates a wrapper for one or more VkPipelines that are sourced from the same
 // IREE executable. Each of the pipelines will share the same shader module
 // and just differs by the entry point into the shader module they reference.
+//
+// If |preparation_pool| is provided and the executable data is aliased the
+// pipelines are created asynchronously on the pool and creation failures are
+// reported when the executable is first dispatched.
+//
+// Entry points exposing push constants as specialization constants get a
+// pipeline specialized on their values once the same values have been
+// dispatched |specialization_threshold| times. 0 disables specialization.
 iree_status_t iree_hal_vulkan_native_executable_create(
     iree::hal::vulkan::VkDeviceHandle* logical_device,
     VkPipelineCache pipeline_cache,
+    iree_hal_preparation_pool_t* preparation_pool,
+    uint32_t specialization_threshold,
     const iree_hal_executable_spec_t* executable_spec,
     iree_hal_executable_t** out_executable);
 
@@ -40,11 +59,22 @@ void iree_hal_vulkan_native_executable_entry_point_source_location(
     iree_hal_executable_t* executable, iree_host_size_t entry_ordinal,
     iree_hal_vulkan_source_location_t* out_source_location);
 
-// Returns the cached VkPipeline for the given executable |entry_ordinal|.
+// Returns the cached VkPipeline for the given executable |entry_ordinal|,
+// blocking until the pipelines have been created.
 iree_status_t iree_hal_vulkan_native_executable_pipeline_for_entry_point(
     iree_hal_executable_t* executable, iree_host_size_t entry_ordinal,
     VkPipeline* out_pipeline_handle);
 
+// Returns the VkPipeline to dispatch |entry_ordinal| with when the leading
+// |push_constant_count| push constants hold |push_constants|. Returns a
+// pipeline specialized on the values if the entry point supports it and the
+// values recur, creating it if needed, and the generic pipeline otherwise.
+// Blocks until the pipelines have been created.
+iree_status_t iree_hal_vulkan_native_executable_pipeline_for_dispatch(
+    iree_hal_executable_t* executable, iree_host_size_t entry_ordinal,
+    iree_host_size_t push_constant_count, const uint32_t* push_constants,
+    VkPipeline* out_pipeline_handle);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
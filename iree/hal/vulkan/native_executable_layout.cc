@@ -8,11 +8,13 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 
 #include "iree/base/api.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/vulkan/dynamic_symbol_tables.h"
 #include "iree/hal/vulkan/dynamic_symbols.h"
+#include "iree/hal/vulkan/extensibility_util.h"
 #include "iree/hal/vulkan/native_descriptor_set_layout.h"
 #include "iree/hal/vulkan/status_util.h"
 #include "iree/hal/vulkan/util/ref_ptr.h"
@@ -23,10 +25,17 @@ typedef struct iree_hal_vulkan_native_executable_layout_t {
   iree_hal_resource_t resource;
   VkDeviceHandle* logical_device;
   VkPipelineLayout handle;
+  // One update template per set layout, stored after |set_layouts|.
+  iree_hal_vulkan_descriptor_update_template_t* update_templates;
   iree_host_size_t set_layout_count;
   iree_hal_descriptor_set_layout_t* set_layouts[];
 } iree_hal_vulkan_native_executable_layout_t;
 
+// Maximum binding ordinal + 1 of a descriptor set that is updated with a
+// template. Templates index descriptor data by binding ordinal and sets with
+// sparser bindings fall back to VkWriteDescriptorSet.
+#define IREE_HAL_VULKAN_MAX_UPDATE_TEMPLATE_SLOT_COUNT 64
+
 namespace {
 extern const iree_hal_executable_layout_vtable_t
     iree_hal_vulkan_native_executable_layout_vtable;
@@ -81,6 +90,89 @@ static void iree_hal_vulkan_destroy_pipeline_layout(
                                                   logical_device->allocator());
 }
 
+static iree_status_t iree_hal_vulkan_create_descriptor_update_template(
+    VkDeviceHandle* logical_device, VkPipelineLayout pipeline_layout,
+    uint32_t set, iree_hal_descriptor_set_layout_t* set_layout,
+    iree_hal_vulkan_descriptor_update_template_t* out_template) {
+  memset(out_template, 0, sizeof(*out_template));
+  const auto& syms = logical_device->syms();
+  if (!syms->vkCreateDescriptorUpdateTemplate) return iree_ok_status();
+
+  // Push descriptor templates can only be used with set layouts created for
+  // pushing; other sets are pushed with VkWriteDescriptorSet.
+  VkDescriptorUpdateTemplateType template_type =
+      VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+  if (logical_device->enabled_extensions().push_descriptors) {
+    if (!syms->vkCmdPushDescriptorSetWithTemplateKHR ||
+        iree_hal_vulkan_native_descriptor_set_layout_usage_type(set_layout) !=
+            IREE_HAL_DESCRIPTOR_SET_LAYOUT_USAGE_TYPE_PUSH_ONLY) {
+      return iree_ok_status();
+    }
+    template_type = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_PUSH_DESCRIPTORS_KHR;
+  }
+
+  iree_host_size_t binding_count = 0;
+  const iree_hal_descriptor_set_layout_binding_t* bindings =
+      iree_hal_vulkan_native_descriptor_set_layout_bindings(set_layout,
+                                                            &binding_count);
+  if (binding_count == 0) return iree_ok_status();
+  iree_host_size_t slot_count = 0;
+  for (iree_host_size_t i = 0; i < binding_count; ++i) {
+    slot_count =
+        iree_max(slot_count, (iree_host_size_t)bindings[i].binding + 1);
+  }
+  if (slot_count > IREE_HAL_VULKAN_MAX_UPDATE_TEMPLATE_SLOT_COUNT) {
+    return iree_ok_status();
+  }
+
+  // Descriptor data is an array of VkDescriptorBufferInfo indexed by binding
+  // ordinal so that bindings can be written in any order.
+  VkDescriptorUpdateTemplateEntry* entries =
+      (VkDescriptorUpdateTemplateEntry*)iree_alloca(
+          binding_count * sizeof(VkDescriptorUpdateTemplateEntry));
+  for (iree_host_size_t i = 0; i < binding_count; ++i) {
+    VkDescriptorUpdateTemplateEntry* entry = &entries[i];
+    entry->dstBinding = bindings[i].binding;
+    entry->dstArrayElement = 0;
+    entry->descriptorCount = 1;
+    entry->descriptorType = static_cast<VkDescriptorType>(bindings[i].type);
+    entry->offset = bindings[i].binding * sizeof(VkDescriptorBufferInfo);
+    entry->stride = sizeof(VkDescriptorBufferInfo);
+  }
+
+  VkDescriptorUpdateTemplateCreateInfo create_info;
+  create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+  create_info.pNext = nullptr;
+  create_info.flags = 0;
+  create_info.descriptorUpdateEntryCount = (uint32_t)binding_count;
+  create_info.pDescriptorUpdateEntries = entries;
+  create_info.templateType = template_type;
+  create_info.descriptorSetLayout =
+      iree_hal_vulkan_native_descriptor_set_layout_handle(set_layout);
+  create_info.pipelineBindPoint = VK_PIPELINE_BIND_POINT_COMPUTE;
+  create_info.pipelineLayout = pipeline_layout;
+  create_info.set = set;
+  VK_RETURN_IF_ERROR(
+      syms->vkCreateDescriptorUpdateTemplate(*logical_device, &create_info,
+                                             logical_device->allocator(),
+                                             &out_template->handle),
+      "vkCreateDescriptorUpdateTemplate");
+  out_template->binding_count = binding_count;
+  out_template->slot_count = slot_count;
+  return iree_ok_status();
+}
+
+static void iree_hal_vulkan_destroy_descriptor_update_templates(
+    VkDeviceHandle* logical_device, iree_host_size_t count,
+    iree_hal_vulkan_descriptor_update_template_t* update_templates) {
+  for (iree_host_size_t i = 0; i < count; ++i) {
+    if (update_templates[i].handle == VK_NULL_HANDLE) continue;
+    logical_device->syms()->vkDestroyDescriptorUpdateTemplate(
+        *logical_device, update_templates[i].handle,
+        logical_device->allocator());
+  }
+}
+
 iree_status_t iree_hal_vulkan_native_executable_layout_create(
     iree::hal::vulkan::VkDeviceHandle* logical_device,
     iree_host_size_t push_constant_count, iree_host_size_t set_layout_count,
@@ -101,9 +193,27 @@ iree_status_t iree_hal_vulkan_native_executable_layout_create(
   iree_hal_vulkan_native_executable_layout_t* executable_layout = NULL;
   iree_host_size_t total_size =
       sizeof(*executable_layout) +
-      set_layout_count * sizeof(*executable_layout->set_layouts);
+      set_layout_count * sizeof(*executable_layout->set_layouts) +
+      set_layout_count * sizeof(*executable_layout->update_templates);
   iree_status_t status = iree_allocator_malloc(
       logical_device->host_allocator(), total_size, (void**)&executable_layout);
+  if (iree_status_is_ok(status)) {
+    uint8_t* update_templates_ptr =
+        (uint8_t*)executable_layout + sizeof(*executable_layout) +
+        set_layout_count * sizeof(*executable_layout->set_layouts);
+    executable_layout->update_templates =
+        (iree_hal_vulkan_descriptor_update_template_t*)update_templates_ptr;
+    for (iree_host_size_t i = 0; i < set_layout_count; ++i) {
+      if (iree_status_is_ok(status)) {
+        status = iree_hal_vulkan_create_descriptor_update_template(
+            logical_device, handle, (uint32_t)i, set_layouts[i],
+            &executable_layout->update_templates[i]);
+      } else {
+        memset(&executable_layout->update_templates[i], 0,
+               sizeof(executable_layout->update_templates[i]));
+      }
+    }
+  }
   if (iree_status_is_ok(status)) {
     iree_hal_resource_initialize(
         &iree_hal_vulkan_native_executable_layout_vtable,
@@ -117,6 +227,12 @@ iree_status_t iree_hal_vulkan_native_executable_layout_create(
     }
     *out_executable_layout = (iree_hal_executable_layout_t*)executable_layout;
   } else {
+    if (executable_layout) {
+      iree_hal_vulkan_destroy_descriptor_update_templates(
+          logical_device, set_layout_count,
+          executable_layout->update_templates);
+      iree_allocator_free(logical_device->host_allocator(), executable_layout);
+    }
     iree_hal_vulkan_destroy_pipeline_layout(logical_device, handle);
   }
 
@@ -132,6 +248,9 @@ static void iree_hal_vulkan_native_executable_layout_destroy(
       executable_layout->logical_device->host_allocator();
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  iree_hal_vulkan_destroy_descriptor_update_templates(
+      executable_layout->logical_device, executable_layout->set_layout_count,
+      executable_layout->update_templates);
   iree_hal_vulkan_destroy_pipeline_layout(executable_layout->logical_device,
                                           executable_layout->handle);
   for (iree_host_size_t i = 0; i < executable_layout->set_layout_count; ++i) {
@@ -167,6 +286,20 @@ iree_hal_descriptor_set_layout_t* iree_hal_vulkan_native_executable_layout_set(
   return executable_layout->set_layouts[set_index];
 }
 
+const iree_hal_vulkan_descriptor_update_template_t*
+iree_hal_vulkan_native_executable_layout_update_template(
+    iree_hal_executable_layout_t* base_executable_layout,
+    iree_host_size_t set_index) {
+  iree_hal_vulkan_native_executable_layout_t* executable_layout =
+      iree_hal_vulkan_native_executable_layout_cast(base_executable_layout);
+  if (IREE_UNLIKELY(set_index >= executable_layout->set_layout_count)) {
+    return NULL;
+  }
+  const iree_hal_vulkan_descriptor_update_template_t* update_template =
+      &executable_layout->update_templates[set_index];
+  return update_template->handle != VK_NULL_HANDLE ? update_template : NULL;
+}
+
 namespace {
 const iree_hal_executable_layout_vtable_t
     iree_hal_vulkan_native_executable_layout_vtable = {
@@ -19,6 +19,17 @@
 extern "C" {
 #endif  // __cplusplus
 
+// A VkDescriptorUpdateTemplate used to update or push one descriptor set of
+// an executable layout with a single call. The template reads an array of
+// |slot_count| VkDescriptorBufferInfo indexed by binding ordinal.
+typedef struct iree_hal_vulkan_descriptor_update_template_t {
+  VkDescriptorUpdateTemplate handle;
+  // Number of bindings in the set layout; all must be provided when updating.
+  iree_host_size_t binding_count;
+  // Number of VkDescriptorBufferInfo entries read: the max binding ordinal + 1.
+  iree_host_size_t slot_count;
+} iree_hal_vulkan_descriptor_update_template_t;
+
 // Creates a VkPipelineLayout-based executable layout composed of one or more
 // descriptor set layouts.
 iree_status_t iree_hal_vulkan_native_executable_layout_create(
@@ -40,6 +51,13 @@ iree_hal_descriptor_set_layout_t* iree_hal_vulkan_native_executable_layout_set(
     iree_hal_executable_layout_t* executable_layout,
     iree_host_size_t set_index);
 
+// Returns the update template for the descriptor set with the given
+// |set_index| or NULL if the set must be updated with VkWriteDescriptorSet.
+const iree_hal_vulkan_descriptor_update_template_t*
+iree_hal_vulkan_native_executable_layout_update_template(
+    iree_hal_executable_layout_t* executable_layout,
+    iree_host_size_t set_index);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
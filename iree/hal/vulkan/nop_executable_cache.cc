@@ -18,6 +18,9 @@ using namespace iree::hal::vulkan;
 typedef struct iree_hal_vulkan_nop_executable_cache_t {
   iree_hal_resource_t resource;
   VkDeviceHandle* logical_device;
+  VkPipelineCache pipeline_cache;
+  iree_hal_preparation_pool_t* preparation_pool;
+  uint32_t specialization_threshold;
 } iree_hal_vulkan_nop_executable_cache_t;
 
 namespace {
@@ -35,7 +38,9 @@ iree_hal_vulkan_nop_executable_cache_cast(
 
 iree_status_t iree_hal_vulkan_nop_executable_cache_create(
     iree::hal::vulkan::VkDeviceHandle* logical_device,
-    iree_string_view_t identifier,
+    VkPipelineCache pipeline_cache,
+    iree_hal_preparation_pool_t* preparation_pool,
+    uint32_t specialization_threshold, iree_string_view_t identifier,
     iree_hal_executable_cache_t** out_executable_cache) {
   IREE_ASSERT_ARGUMENT(out_executable_cache);
   *out_executable_cache = NULL;
@@ -49,6 +54,9 @@ iree_status_t iree_hal_vulkan_nop_executable_cache_create(
     iree_hal_resource_initialize(&iree_hal_vulkan_nop_executable_cache_vtable,
                                  &executable_cache->resource);
     executable_cache->logical_device = logical_device;
+    executable_cache->pipeline_cache = pipeline_cache;
+    executable_cache->preparation_pool = preparation_pool;
+    executable_cache->specialization_threshold = specialization_threshold;
 
     *out_executable_cache = (iree_hal_executable_cache_t*)executable_cache;
   }
@@ -85,8 +93,10 @@ static iree_status_t iree_hal_vulkan_nop_executable_cache_prepare_executable(
   iree_hal_vulkan_nop_executable_cache_t* executable_cache =
       iree_hal_vulkan_nop_executable_cache_cast(base_executable_cache);
   return iree_hal_vulkan_native_executable_create(
-      executable_cache->logical_device,
-      /*pipeline_cache=*/VK_NULL_HANDLE, executable_spec, out_executable);
+      executable_cache->logical_device, executable_cache->pipeline_cache,
+      executable_cache->preparation_pool,
+      executable_cache->specialization_threshold, executable_spec,
+      out_executable);
 }
 
 namespace {
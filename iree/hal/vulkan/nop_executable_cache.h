@@ -9,18 +9,26 @@
 
 #include "iree/base/api.h"
 #include "iree/hal/api.h"
+#include "iree/hal/utils/preparation_pool.h"
 #include "iree/hal/vulkan/handle_util.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif  // __cplusplus
 
-// Creates a no-op executable cache that does not cache at all.
+// Creates an executable cache that does not cache executables in memory.
 // This is useful to isolate pipeline caching behavior and verify compilation
 // behavior.
+//
+// |pipeline_cache| is optional and used when creating all pipelines.
+// |preparation_pool| is optional. Both must outlive the cache and all
+// executables prepared from it. |specialization_threshold| is passed to all
+// executables (see iree_hal_vulkan_native_executable_create).
 iree_status_t iree_hal_vulkan_nop_executable_cache_create(
     iree::hal::vulkan::VkDeviceHandle* logical_device,
-    iree_string_view_t identifier,
+    VkPipelineCache pipeline_cache,
+    iree_hal_preparation_pool_t* preparation_pool,
+    uint32_t specialization_threshold, iree_string_view_t identifier,
     iree_hal_executable_cache_t** out_executable_cache);
 
 #ifdef __cplusplus
@@ -0,0 +1,169 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/vulkan/pipeline_cache.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+
+#include "iree/base/internal/file_io.h"
+#include "iree/base/tracing.h"
+#include "iree/hal/vulkan/dynamic_symbols.h"
+#include "iree/hal/vulkan/status_util.h"
+
+using namespace iree::hal::vulkan;
+
+// Maximum length of the cache file path including the NUL terminator.
+#define IREE_HAL_VULKAN_PIPELINE_CACHE_MAX_PATH_LENGTH 2048
+
+struct iree_hal_vulkan_pipeline_cache_t {
+  VkDeviceHandle* logical_device;
+  VkPipelineCache handle;
+  // Path of the cache file or empty if it could not be formed.
+  char path[IREE_HAL_VULKAN_PIPELINE_CACHE_MAX_PATH_LENGTH];
+};
+
+// Formats the cache file path for |physical_device| into |cache|->path.
+static void iree_hal_vulkan_pipeline_cache_format_path(
+    iree_hal_vulkan_pipeline_cache_t* cache, VkPhysicalDevice physical_device,
+    iree_string_view_t directory) {
+  VkPhysicalDeviceProperties properties;
+  cache->logical_device->syms()->vkGetPhysicalDeviceProperties(physical_device,
+                                                               &properties);
+  char uuid[VK_UUID_SIZE * 2 + 1];
+  for (int i = 0; i < VK_UUID_SIZE; ++i) {
+    snprintf(&uuid[i * 2], 3, "%02x", properties.pipelineCacheUUID[i]);
+  }
+  int length = snprintf(cache->path, sizeof(cache->path),
+                        "%.*s/%08x-%08x-%08x-%s.vkpipelinecache",
+                        (int)directory.size, directory.data,
+                        properties.vendorID, properties.deviceID,
+                        properties.driverVersion, uuid);
+  if (length <= 0 || length >= (int)sizeof(cache->path)) {
+    cache->path[0] = 0;
+  }
+}
+
+iree_status_t iree_hal_vulkan_pipeline_cache_create(
+    VkDeviceHandle* logical_device, VkPhysicalDevice physical_device,
+    iree_string_view_t directory,
+    iree_hal_vulkan_pipeline_cache_t** out_cache) {
+  IREE_ASSERT_ARGUMENT(logical_device);
+  IREE_ASSERT_ARGUMENT(out_cache);
+  *out_cache = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_vulkan_pipeline_cache_t* cache = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(logical_device->host_allocator(),
+                                sizeof(*cache), (void**)&cache));
+  memset(cache, 0, sizeof(*cache));
+  cache->logical_device = logical_device;
+  iree_hal_vulkan_pipeline_cache_format_path(cache, physical_device,
+                                             directory);
+
+  // Seed the cache with the previous contents if available. Implementations
+  // ignore data with a mismatched header so any failures just start empty.
+  iree_byte_span_t initial_data = iree_make_byte_span(NULL, 0);
+#if IREE_FILE_IO_ENABLE
+  if (cache->path[0]) {
+    iree_status_ignore(iree_file_read_contents(
+        cache->path, logical_device->host_allocator(), &initial_data));
+  }
+#endif  // IREE_FILE_IO_ENABLE
+
+  VkPipelineCacheCreateInfo create_info;
+  create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+  create_info.pNext = NULL;
+  create_info.flags = 0;
+  create_info.initialDataSize = initial_data.data_length;
+  create_info.pInitialData = initial_data.data;
+  iree_status_t status = VK_RESULT_TO_STATUS(
+      logical_device->syms()->vkCreatePipelineCache(
+          *logical_device, &create_info, logical_device->allocator(),
+          &cache->handle),
+      "vkCreatePipelineCache");
+  iree_allocator_free(logical_device->host_allocator(), initial_data.data);
+
+  if (iree_status_is_ok(status)) {
+    *out_cache = cache;
+  } else {
+    iree_allocator_free(logical_device->host_allocator(), cache);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+void iree_hal_vulkan_pipeline_cache_free(
+    iree_hal_vulkan_pipeline_cache_t* cache) {
+  if (!cache) return;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  VkDeviceHandle* logical_device = cache->logical_device;
+  iree_status_ignore(iree_hal_vulkan_pipeline_cache_flush(cache));
+  logical_device->syms()->vkDestroyPipelineCache(
+      *logical_device, cache->handle, logical_device->allocator());
+  iree_allocator_free(logical_device->host_allocator(), cache);
+  IREE_TRACE_ZONE_END(z0);
+}
+
+VkPipelineCache iree_hal_vulkan_pipeline_cache_handle(
+    iree_hal_vulkan_pipeline_cache_t* cache) {
+  return cache->handle;
+}
+
+iree_status_t iree_hal_vulkan_pipeline_cache_flush(
+    iree_hal_vulkan_pipeline_cache_t* cache) {
+  IREE_ASSERT_ARGUMENT(cache);
+#if IREE_FILE_IO_ENABLE
+  if (!cache->path[0]) return iree_ok_status();
+  IREE_TRACE_ZONE_BEGIN(z0);
+  VkDeviceHandle* logical_device = cache->logical_device;
+
+  size_t data_size = 0;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, VK_RESULT_TO_STATUS(logical_device->syms()->vkGetPipelineCacheData(
+                                  *logical_device, cache->handle, &data_size,
+                                  NULL),
+                              "vkGetPipelineCacheData"));
+  void* data = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(logical_device->host_allocator(), data_size,
+                                &data));
+  iree_status_t status = VK_RESULT_TO_STATUS(
+      logical_device->syms()->vkGetPipelineCacheData(
+          *logical_device, cache->handle, &data_size, data),
+      "vkGetPipelineCacheData");
+
+  char temp_path[IREE_HAL_VULKAN_PIPELINE_CACHE_MAX_PATH_LENGTH + 32];
+  snprintf(temp_path, sizeof(temp_path), "%s.%016" PRIx64 ".tmp", cache->path,
+           (uint64_t)iree_time_now() ^ (uint64_t)(uintptr_t)cache);
+  if (iree_status_is_ok(status)) {
+    status = iree_file_write_contents(
+        temp_path, iree_make_const_byte_span(data, data_size));
+  }
+  if (iree_status_is_ok(status)) {
+    // rename does not replace existing files on all platforms.
+    bool renamed = rename(temp_path, cache->path) == 0;
+    if (!renamed) {
+      remove(cache->path);
+      renamed = rename(temp_path, cache->path) == 0;
+    }
+    if (!renamed) {
+      remove(temp_path);
+      status = iree_make_status(IREE_STATUS_UNAVAILABLE,
+                                "failed to replace pipeline cache file '%s'",
+                                cache->path);
+    }
+  }
+  iree_allocator_free(logical_device->host_allocator(), data);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+#else
+  return iree_ok_status();
+#endif  // IREE_FILE_IO_ENABLE
+}
@@ -0,0 +1,58 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_VULKAN_PIPELINE_CACHE_H_
+#define IREE_HAL_VULKAN_PIPELINE_CACHE_H_
+
+// clang-format off: must be included before all other headers.
+#include "iree/hal/vulkan/vulkan_headers.h"
+// clang-format on
+
+#include "iree/base/api.h"
+#include "iree/hal/vulkan/handle_util.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// A VkPipelineCache persisted to a file on disk.
+//
+// The cache file is keyed by the physical device vendor, device, driver
+// version, and pipeline cache UUID so that a cache directory may be shared
+// across devices and driver upgrades. Implementations also validate the cache
+// header and ignore incompatible data.
+//
+// The cache is loaded when created and written back when flushed or freed.
+// Writes go to a temporary file that is renamed into place so that processes
+// sharing the directory never observe partial writes.
+typedef struct iree_hal_vulkan_pipeline_cache_t
+    iree_hal_vulkan_pipeline_cache_t;
+
+// Creates a pipeline cache persisted under |directory| for |physical_device|.
+// The directory must exist. A missing or unreadable cache file starts with an
+// empty cache.
+iree_status_t iree_hal_vulkan_pipeline_cache_create(
+    iree::hal::vulkan::VkDeviceHandle* logical_device,
+    VkPhysicalDevice physical_device, iree_string_view_t directory,
+    iree_hal_vulkan_pipeline_cache_t** out_cache);
+
+// Flushes and frees |cache|. The pipeline cache must not be in use.
+void iree_hal_vulkan_pipeline_cache_free(
+    iree_hal_vulkan_pipeline_cache_t* cache);
+
+// Returns the VkPipelineCache used when creating pipelines.
+VkPipelineCache iree_hal_vulkan_pipeline_cache_handle(
+    iree_hal_vulkan_pipeline_cache_t* cache);
+
+// Writes the current contents of |cache| to disk.
+iree_status_t iree_hal_vulkan_pipeline_cache_flush(
+    iree_hal_vulkan_pipeline_cache_t* cache);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_VULKAN_PIPELINE_CACHE_H_
@@ -30,6 +30,26 @@ IREE_FLAG(bool, vulkan_force_timeline_semaphore_emulation, false,
 IREE_FLAG(bool, vulkan_tracing, true,
           "Enables Vulkan tracing (if IREE tracing is enabled).");
 
+IREE_FLAG(string, vulkan_executable_cache_path, "",
+          "Directory used to persist the Vulkan pipeline cache across runs. "
+          "Disabled if empty.");
+
+IREE_FLAG(int32_t, vulkan_pipeline_specialization_threshold, 2,
+          "Number of dispatches with the same push constant values after "
+          "which a pipeline specialized on them is created. 0 disables "
+          "specialization.");
+
+IREE_FLAG(int64_t, vulkan_staging_buffer_capacity, 16 * 1024 * 1024,
+          "Capacity in bytes of the ring buffer used to stage uploads on the "
+          "transfer queue. 0 performs uploads synchronously.");
+
+IREE_FLAG(bool, vulkan_ignore_memory_budget, false,
+          "Allows allocations to exceed the heap memory budget instead of "
+          "failing with RESOURCE_EXHAUSTED.");
+IREE_FLAG(int64_t, vulkan_transient_memory_limit, 0,
+          "Maximum bytes of device memory held by the transient buffer pool. "
+          "0 is unlimited.");
+
 static iree_status_t iree_hal_vulkan_create_driver_with_flags(
     iree_string_view_t identifier, iree_allocator_t allocator,
     iree_hal_driver_t** out_driver) {
@@ -68,6 +88,18 @@ static iree_status_t iree_hal_vulkan_create_driver_with_flags(
     driver_options.device_options.flags |=
         IREE_HAL_VULKAN_DEVICE_FORCE_TIMELINE_SEMAPHORE_EMULATION;
   }
+  if (FLAG_vulkan_ignore_memory_budget) {
+    driver_options.device_options.flags |=
+        IREE_HAL_VULKAN_DEVICE_IGNORE_MEMORY_BUDGET;
+  }
+  driver_options.device_options.transient_pool.max_size =
+      (iree_device_size_t)FLAG_vulkan_transient_memory_limit;
+  driver_options.device_options.executable_cache_path =
+      iree_make_cstring_view(FLAG_vulkan_executable_cache_path);
+  driver_options.device_options.staging_buffer_capacity =
+      (iree_device_size_t)FLAG_vulkan_staging_buffer_capacity;
+  driver_options.device_options.pipeline_specialization_threshold =
+      (uint32_t)iree_max(0, FLAG_vulkan_pipeline_specialization_threshold);
 
   // Load the Vulkan library. This will fail if the library cannot be found or
   // does not have the expected functions.
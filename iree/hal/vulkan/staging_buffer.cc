@@ -0,0 +1,256 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/hal/vulkan/staging_buffer.h"
+
+#include <cstring>
+
+#include "iree/base/tracing.h"
+
+// Alignment of each reserved range. Keeps host copies into the ring aligned.
+#define IREE_HAL_VULKAN_STAGING_BUFFER_ALIGNMENT 64
+
+// A committed upload that has not yet been observed as completed.
+typedef struct iree_hal_vulkan_staging_inflight_t {
+  // Ring position immediately following the last range of the upload.
+  iree_device_size_t end_position;
+  // Staging semaphore value signaled when the upload completes.
+  uint64_t value;
+} iree_hal_vulkan_staging_inflight_t;
+
+struct iree_hal_vulkan_staging_buffer_t {
+  iree_allocator_t host_allocator;
+  iree_hal_buffer_t* buffer;
+  iree_hal_buffer_mapping_t mapping;
+  bool is_coherent;
+  iree_device_size_t capacity;
+  iree_hal_semaphore_t* semaphore;
+
+  // Monotonically increasing ring positions; the buffer offset of a position
+  // is the position modulo |capacity|. Ranges in [retired, committed) are
+  // in-flight and ranges in [committed, reserved) are being written.
+  iree_device_size_t retired_position;
+  iree_device_size_t committed_position;
+  iree_device_size_t reserved_position;
+
+  // Last value committed and (eventually) signaled on |semaphore|.
+  uint64_t committed_value;
+
+  // FIFO of in-flight uploads in commit order.
+  iree_host_size_t inflight_head;
+  iree_host_size_t inflight_count;
+  iree_hal_vulkan_staging_inflight_t
+      inflight[IREE_HAL_VULKAN_STAGING_BUFFER_MAX_INFLIGHT_COUNT];
+};
+
+iree_status_t iree_hal_vulkan_staging_buffer_create(
+    iree_hal_device_t* device, iree_device_size_t capacity,
+    iree_allocator_t host_allocator,
+    iree_hal_vulkan_staging_buffer_t** out_staging_buffer) {
+  IREE_ASSERT_ARGUMENT(device);
+  IREE_ASSERT_ARGUMENT(out_staging_buffer);
+  *out_staging_buffer = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, capacity);
+
+  capacity = iree_device_align(capacity,
+                               IREE_HAL_VULKAN_STAGING_BUFFER_ALIGNMENT);
+  iree_hal_vulkan_staging_buffer_t* staging_buffer = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, sizeof(*staging_buffer),
+                                (void**)&staging_buffer));
+  memset(staging_buffer, 0, sizeof(*staging_buffer));
+  staging_buffer->host_allocator = host_allocator;
+  staging_buffer->capacity = capacity;
+
+  iree_status_t status = iree_hal_allocator_allocate_buffer(
+      iree_hal_device_allocator(device),
+      IREE_HAL_MEMORY_TYPE_HOST_LOCAL | IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE,
+      IREE_HAL_BUFFER_USAGE_TRANSFER | IREE_HAL_BUFFER_USAGE_MAPPING, capacity,
+      iree_const_byte_span_empty(), &staging_buffer->buffer);
+  if (iree_status_is_ok(status)) {
+    staging_buffer->is_coherent =
+        iree_all_bits_set(iree_hal_buffer_memory_type(staging_buffer->buffer),
+                          IREE_HAL_MEMORY_TYPE_HOST_COHERENT);
+    status = iree_hal_buffer_map_range(
+        staging_buffer->buffer, IREE_HAL_MAPPING_MODE_PERSISTENT,
+        IREE_HAL_MEMORY_ACCESS_WRITE, 0, capacity, &staging_buffer->mapping);
+  }
+  if (iree_status_is_ok(status)) {
+    status =
+        iree_hal_semaphore_create(device, 0ull, &staging_buffer->semaphore);
+  }
+
+  if (iree_status_is_ok(status)) {
+    *out_staging_buffer = staging_buffer;
+  } else {
+    iree_hal_vulkan_staging_buffer_free(staging_buffer);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+void iree_hal_vulkan_staging_buffer_free(
+    iree_hal_vulkan_staging_buffer_t* staging_buffer) {
+  if (!staging_buffer) return;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_semaphore_release(staging_buffer->semaphore);
+  if (staging_buffer->mapping.contents.data) {
+    iree_status_ignore(iree_hal_buffer_unmap_range(&staging_buffer->mapping));
+  }
+  iree_hal_buffer_release(staging_buffer->buffer);
+  iree_allocator_free(staging_buffer->host_allocator, staging_buffer);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+iree_device_size_t iree_hal_vulkan_staging_buffer_capacity(
+    iree_hal_vulkan_staging_buffer_t* staging_buffer) {
+  return staging_buffer->capacity;
+}
+
+iree_hal_semaphore_t* iree_hal_vulkan_staging_buffer_semaphore(
+    iree_hal_vulkan_staging_buffer_t* staging_buffer) {
+  return staging_buffer->semaphore;
+}
+
+uint64_t iree_hal_vulkan_staging_buffer_next_value(
+    iree_hal_vulkan_staging_buffer_t* staging_buffer) {
+  return staging_buffer->committed_value + 1;
+}
+
+// Retires all in-flight uploads that completed by |completed_value|.
+static void iree_hal_vulkan_staging_buffer_retire(
+    iree_hal_vulkan_staging_buffer_t* staging_buffer,
+    uint64_t completed_value) {
+  while (staging_buffer->inflight_count > 0) {
+    const iree_hal_vulkan_staging_inflight_t* inflight =
+        &staging_buffer->inflight[staging_buffer->inflight_head];
+    if (inflight->value > completed_value) break;
+    staging_buffer->retired_position = inflight->end_position;
+    staging_buffer->inflight_head =
+        (staging_buffer->inflight_head + 1) %
+        IREE_HAL_VULKAN_STAGING_BUFFER_MAX_INFLIGHT_COUNT;
+    --staging_buffer->inflight_count;
+  }
+}
+
+iree_status_t iree_hal_vulkan_staging_buffer_reserve(
+    iree_hal_vulkan_staging_buffer_t* staging_buffer, iree_device_size_t length,
+    iree_timeout_t timeout, iree_hal_vulkan_staging_range_t* out_range) {
+  IREE_ASSERT_ARGUMENT(staging_buffer);
+  IREE_ASSERT_ARGUMENT(out_range);
+  memset(out_range, 0, sizeof(*out_range));
+  iree_device_size_t capacity = staging_buffer->capacity;
+  iree_device_size_t aligned_length =
+      iree_device_align(length, IREE_HAL_VULKAN_STAGING_BUFFER_ALIGNMENT);
+  if (aligned_length > capacity) {
+    return iree_make_status(
+        IREE_STATUS_OUT_OF_RANGE,
+        "staging reservation of %" PRIu64
+        " bytes exceeds the staging buffer capacity of %" PRIu64 " bytes",
+        (uint64_t)length, (uint64_t)capacity);
+  }
+
+  // Ranges never wrap: if the range would cross the end of the buffer we skip
+  // the remainder and start again at the beginning.
+  iree_device_size_t position = staging_buffer->reserved_position;
+  iree_device_size_t offset = position % capacity;
+  if (offset + aligned_length > capacity) {
+    position += capacity - offset;
+    offset = 0;
+  }
+  iree_device_size_t end_position = position + aligned_length;
+
+  // Retire completed uploads until the range (and the in-flight entry it will
+  // be committed into) is available. This only blocks when the ring is full.
+  iree_convert_timeout_to_absolute(&timeout);
+  while (end_position - staging_buffer->retired_position > capacity ||
+         staging_buffer->inflight_count ==
+             IREE_HAL_VULKAN_STAGING_BUFFER_MAX_INFLIGHT_COUNT) {
+    if (staging_buffer->inflight_count == 0) {
+      if (staging_buffer->committed_position !=
+          staging_buffer->reserved_position) {
+        // Only uncommitted reservations remain and they need the space.
+        return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                                "staging buffer exhausted by uncommitted "
+                                "reservations");
+      }
+      // The ring is empty and any skipped remainder is unused.
+      staging_buffer->retired_position = position;
+      break;
+    }
+    uint64_t completed_value = 0;
+    IREE_RETURN_IF_ERROR(
+        iree_hal_semaphore_query(staging_buffer->semaphore, &completed_value));
+    if (completed_value <
+        staging_buffer->inflight[staging_buffer->inflight_head].value) {
+      IREE_TRACE_ZONE_BEGIN_NAMED(z0, "iree_hal_vulkan_staging_buffer_wait");
+      completed_value =
+          staging_buffer->inflight[staging_buffer->inflight_head].value;
+      iree_status_t status = iree_hal_semaphore_wait(
+          staging_buffer->semaphore, completed_value, timeout);
+      IREE_TRACE_ZONE_END(z0);
+      IREE_RETURN_IF_ERROR(status);
+    }
+    iree_hal_vulkan_staging_buffer_retire(staging_buffer, completed_value);
+  }
+
+  staging_buffer->reserved_position = end_position;
+  out_range->buffer = staging_buffer->buffer;
+  out_range->offset = offset;
+  out_range->data = staging_buffer->mapping.contents.data + offset;
+  out_range->length = length;
+  return iree_ok_status();
+}
+
+iree_status_t iree_hal_vulkan_staging_buffer_flush(
+    iree_hal_vulkan_staging_buffer_t* staging_buffer) {
+  IREE_ASSERT_ARGUMENT(staging_buffer);
+  if (staging_buffer->is_coherent) return iree_ok_status();
+  iree_device_size_t start_position = staging_buffer->committed_position;
+  iree_device_size_t end_position = staging_buffer->reserved_position;
+  if (start_position == end_position) return iree_ok_status();
+
+  // The reserved ranges may wrap around the end of the buffer in which case
+  // they are flushed in two parts.
+  iree_device_size_t capacity = staging_buffer->capacity;
+  iree_device_size_t length = end_position - start_position;
+  iree_device_size_t offset = start_position % capacity;
+  iree_device_size_t head_length = iree_min(length, capacity - offset);
+  IREE_RETURN_IF_ERROR(iree_hal_buffer_flush_range(&staging_buffer->mapping,
+                                                   offset, head_length));
+  if (head_length < length) {
+    IREE_RETURN_IF_ERROR(iree_hal_buffer_flush_range(
+        &staging_buffer->mapping, 0, length - head_length));
+  }
+  return iree_ok_status();
+}
+
+void iree_hal_vulkan_staging_buffer_commit(
+    iree_hal_vulkan_staging_buffer_t* staging_buffer) {
+  IREE_ASSERT_ARGUMENT(staging_buffer);
+  if (staging_buffer->committed_position ==
+      staging_buffer->reserved_position) {
+    return;
+  }
+  // Capacity for the entry was ensured when the ranges were reserved.
+  iree_host_size_t index = (staging_buffer->inflight_head +
+                            staging_buffer->inflight_count) %
+                           IREE_HAL_VULKAN_STAGING_BUFFER_MAX_INFLIGHT_COUNT;
+  ++staging_buffer->inflight_count;
+  staging_buffer->inflight[index].end_position =
+      staging_buffer->reserved_position;
+  staging_buffer->inflight[index].value = ++staging_buffer->committed_value;
+  staging_buffer->committed_position = staging_buffer->reserved_position;
+}
+
+void iree_hal_vulkan_staging_buffer_discard(
+    iree_hal_vulkan_staging_buffer_t* staging_buffer) {
+  IREE_ASSERT_ARGUMENT(staging_buffer);
+  staging_buffer->reserved_position = staging_buffer->committed_position;
+}
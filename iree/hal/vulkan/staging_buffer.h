@@ -0,0 +1,103 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_HAL_VULKAN_STAGING_BUFFER_H_
+#define IREE_HAL_VULKAN_STAGING_BUFFER_H_
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Maximum number of committed uploads that may be in-flight at once.
+// Reserving space beyond this waits for the oldest upload to complete.
+#define IREE_HAL_VULKAN_STAGING_BUFFER_MAX_INFLIGHT_COUNT 64
+
+// A range of a staging buffer reserved for writing by the host.
+typedef struct iree_hal_vulkan_staging_range_t {
+  // Staging buffer containing the range. Not retained.
+  iree_hal_buffer_t* buffer;
+  // Offset of the range in |buffer|.
+  iree_device_size_t offset;
+  // Host pointer to the start of the range in the persistent mapping.
+  uint8_t* data;
+  // Length of the range in bytes.
+  iree_device_size_t length;
+} iree_hal_vulkan_staging_range_t;
+
+// A persistently mapped host-local ring buffer used to stage uploads.
+//
+// Ranges are reserved in ring order and are in-flight until a submission
+// reading from them signals the staging semaphore to the value returned by
+// iree_hal_vulkan_staging_buffer_next_value. Reservations retire in-flight
+// ranges as the semaphore advances and only block when the ring is full.
+//
+// Usage:
+//   iree_hal_vulkan_staging_buffer_reserve(staging, length, timeout, &range);
+//   memcpy(range.data, ...);
+//   iree_hal_vulkan_staging_buffer_flush(staging);
+//   <submit a copy from range.buffer signaling the staging semaphore to
+//    iree_hal_vulkan_staging_buffer_next_value(staging)>
+//   if (submitted) iree_hal_vulkan_staging_buffer_commit(staging);
+//   else iree_hal_vulkan_staging_buffer_discard(staging);
+//
+// Thread-compatible: callers must serialize reservation through
+// commit/discard and must submit in commit order.
+typedef struct iree_hal_vulkan_staging_buffer_t
+    iree_hal_vulkan_staging_buffer_t;
+
+// Creates a staging buffer of |capacity| bytes allocated from the allocator of
+// |device| along with the timeline semaphore used to track its uploads.
+iree_status_t iree_hal_vulkan_staging_buffer_create(
+    iree_hal_device_t* device, iree_device_size_t capacity,
+    iree_allocator_t host_allocator,
+    iree_hal_vulkan_staging_buffer_t** out_staging_buffer);
+
+// Frees |staging_buffer|. All uploads from it must have completed.
+void iree_hal_vulkan_staging_buffer_free(
+    iree_hal_vulkan_staging_buffer_t* staging_buffer);
+
+// Returns the maximum length that may be reserved at once.
+iree_device_size_t iree_hal_vulkan_staging_buffer_capacity(
+    iree_hal_vulkan_staging_buffer_t* staging_buffer);
+
+// Returns the timeline semaphore signaled by uploads from the staging buffer.
+iree_hal_semaphore_t* iree_hal_vulkan_staging_buffer_semaphore(
+    iree_hal_vulkan_staging_buffer_t* staging_buffer);
+
+// Returns the semaphore value the submission consuming the ranges reserved
+// since the last commit must signal.
+uint64_t iree_hal_vulkan_staging_buffer_next_value(
+    iree_hal_vulkan_staging_buffer_t* staging_buffer);
+
+// Reserves a contiguous |length| byte range for writing by the host, waiting
+// up to |timeout| for in-flight uploads to complete if the ring is full.
+iree_status_t iree_hal_vulkan_staging_buffer_reserve(
+    iree_hal_vulkan_staging_buffer_t* staging_buffer, iree_device_size_t length,
+    iree_timeout_t timeout, iree_hal_vulkan_staging_range_t* out_range);
+
+// Flushes host writes to all ranges reserved since the last commit. Must be
+// called prior to submitting work that reads from them.
+iree_status_t iree_hal_vulkan_staging_buffer_flush(
+    iree_hal_vulkan_staging_buffer_t* staging_buffer);
+
+// Marks all ranges reserved since the last commit as in-flight until the
+// staging semaphore reaches the value returned by
+// iree_hal_vulkan_staging_buffer_next_value prior to the commit.
+void iree_hal_vulkan_staging_buffer_commit(
+    iree_hal_vulkan_staging_buffer_t* staging_buffer);
+
+// Returns all ranges reserved since the last commit to the ring.
+void iree_hal_vulkan_staging_buffer_discard(
+    iree_hal_vulkan_staging_buffer_t* staging_buffer);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_HAL_VULKAN_STAGING_BUFFER_H_
@@ -18,12 +18,46 @@
 
 using namespace iree::hal::vulkan;
 
+// Usage classes of allocations serviced from dedicated pools.
+typedef enum iree_hal_vulkan_vma_pool_class_e {
+  IREE_HAL_VULKAN_VMA_POOL_CLASS_CONSTANT = 0,
+  IREE_HAL_VULKAN_VMA_POOL_CLASS_TRANSIENT,
+  IREE_HAL_VULKAN_VMA_POOL_CLASS_STAGING,
+  IREE_HAL_VULKAN_VMA_POOL_CLASS_COUNT,  // used for sizing lookup tables
+  // Allocations made from the default pools.
+  IREE_HAL_VULKAN_VMA_POOL_CLASS_NONE = IREE_HAL_VULKAN_VMA_POOL_CLASS_COUNT,
+} iree_hal_vulkan_vma_pool_class_t;
+
+typedef struct iree_hal_vulkan_vma_pool_t {
+  // VK_NULL_HANDLE if the pool is disabled.
+  VmaPool handle;
+  // Memory type all blocks of the pool are allocated from.
+  uint32_t memory_type_index;
+} iree_hal_vulkan_vma_pool_t;
+
 typedef struct iree_hal_vulkan_vma_allocator_t {
   iree_hal_resource_t resource;
   iree_hal_device_t* device;  // unretained to avoid cycles
   iree_allocator_t host_allocator;
   VmaAllocator vma;
 
+  // Queue families buffers are shared across. If more than one then buffers
+  // are created with VK_SHARING_MODE_CONCURRENT.
+  uint32_t queue_family_count;
+  uint32_t queue_family_indices[IREE_HAL_VULKAN_VMA_MAX_QUEUE_FAMILY_COUNT];
+
+  // True if all device-local memory types are also host-visible as is common
+  // on integrated GPUs with unified memory (Mali, Adreno, etc). Device-local
+  // allocations are then made mappable so that transfers can map and memcpy
+  // instead of staging through host-local memory and a queue copy.
+  bool is_unified_memory;
+
+  // Allocations fail instead of exceeding the heap memory budget.
+  bool enforce_memory_budget;
+
+  // Dedicated pools for each usage class.
+  iree_hal_vulkan_vma_pool_t pools[IREE_HAL_VULKAN_VMA_POOL_CLASS_COUNT];
+
   IREE_STATISTICS(VkPhysicalDeviceMemoryProperties memory_props;)
   IREE_STATISTICS(iree_hal_allocator_statistics_t statistics;)
 } iree_hal_vulkan_vma_allocator_t;
@@ -81,15 +115,223 @@ static void VKAPI_PTR iree_hal_vulkan_vma_free_callback(
 
 #endif  // IREE_STATISTICS_ENABLE
 
+// Returns true if every device-local memory type in |memory_props| is also
+// host-visible. Discrete GPUs with resizable BAR expose some device-local
+// host-visible types but also have device-local only types, which remain the
+// preferred location for device data.
+static bool iree_hal_vulkan_vma_allocator_is_unified_memory(
+    const VkPhysicalDeviceMemoryProperties* memory_props) {
+  bool has_device_local = false;
+  for (uint32_t i = 0; i < memory_props->memoryTypeCount; ++i) {
+    VkMemoryPropertyFlags flags = memory_props->memoryTypes[i].propertyFlags;
+    if (!iree_all_bits_set(flags, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)) {
+      continue;
+    }
+    // Lazily allocated memory is never host-visible and only used for
+    // transient allocations.
+    if (iree_all_bits_set(flags, VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)) {
+      continue;
+    }
+    if (!iree_all_bits_set(flags, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)) {
+      return false;
+    }
+    has_device_local = true;
+  }
+  return has_device_local;
+}
+
+// Returns the usage class of allocations of the given |memory_type| and
+// |allowed_usage| with a dedicated pool.
+static iree_hal_vulkan_vma_pool_class_t
+iree_hal_vulkan_vma_allocator_pool_class(
+    iree_hal_memory_type_t memory_type, iree_hal_buffer_usage_t allowed_usage) {
+  if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL)) {
+    if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_TRANSIENT)) {
+      return IREE_HAL_VULKAN_VMA_POOL_CLASS_TRANSIENT;
+    } else if (iree_all_bits_set(allowed_usage,
+                                 IREE_HAL_BUFFER_USAGE_CONSTANT)) {
+      return IREE_HAL_VULKAN_VMA_POOL_CLASS_CONSTANT;
+    }
+  } else if (iree_all_bits_set(memory_type,
+                               IREE_HAL_MEMORY_TYPE_HOST_VISIBLE) &&
+             iree_all_bits_set(allowed_usage, IREE_HAL_BUFFER_USAGE_TRANSFER)) {
+    return IREE_HAL_VULKAN_VMA_POOL_CLASS_STAGING;
+  }
+  return IREE_HAL_VULKAN_VMA_POOL_CLASS_NONE;
+}
+
+static void iree_hal_vulkan_vma_allocator_populate_buffer_create_info(
+    iree_hal_vulkan_vma_allocator_t* allocator,
+    iree_hal_buffer_usage_t allowed_usage, iree_device_size_t allocation_size,
+    VkBufferCreateInfo* out_create_info) {
+  out_create_info->sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+  out_create_info->pNext = NULL;
+  out_create_info->flags = 0;
+  out_create_info->size = allocation_size;
+  out_create_info->usage = 0;
+  if (iree_all_bits_set(allowed_usage, IREE_HAL_BUFFER_USAGE_TRANSFER)) {
+    out_create_info->usage |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    out_create_info->usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+  }
+  if (iree_all_bits_set(allowed_usage, IREE_HAL_BUFFER_USAGE_DISPATCH)) {
+    out_create_info->usage |= VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+    out_create_info->usage |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    out_create_info->usage |= VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+  }
+  if (allocator->queue_family_count > 1) {
+    out_create_info->sharingMode = VK_SHARING_MODE_CONCURRENT;
+    out_create_info->queueFamilyIndexCount = allocator->queue_family_count;
+    out_create_info->pQueueFamilyIndices = allocator->queue_family_indices;
+  } else {
+    out_create_info->sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    out_create_info->queueFamilyIndexCount = 0;
+    out_create_info->pQueueFamilyIndices = NULL;
+  }
+}
+
+// Populates the VMA allocation info for a buffer of |memory_type| and
+// |allowed_usage|. Both may be extended with additional bits the allocation
+// will have on unified memory systems.
+static void iree_hal_vulkan_vma_allocator_populate_allocation_create_info(
+    iree_hal_vulkan_vma_allocator_t* allocator,
+    iree_hal_memory_type_t* memory_type, iree_hal_buffer_usage_t* allowed_usage,
+    VmaAllocationCreateFlags flags, VmaAllocationCreateInfo* out_create_info) {
+  out_create_info->flags = flags;
+  out_create_info->usage = VMA_MEMORY_USAGE_UNKNOWN;
+  out_create_info->requiredFlags = 0;
+  out_create_info->preferredFlags = 0;
+  out_create_info->memoryTypeBits = 0;  // Automatic selection.
+  out_create_info->pool = VK_NULL_HANDLE;
+  out_create_info->pUserData = NULL;
+  if (allocator->is_unified_memory &&
+      iree_all_bits_set(*memory_type, IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL) &&
+      !iree_all_bits_set(*memory_type, IREE_HAL_MEMORY_TYPE_TRANSIENT)) {
+    // On unified memory systems device-local memory is always host-visible
+    // and making it mappable lets uploads (including the initial data) and
+    // readbacks map and memcpy directly. The requiredFlags below ensure we
+    // get a device-local host-visible memory type.
+    *memory_type |= IREE_HAL_MEMORY_TYPE_HOST_VISIBLE;
+    *allowed_usage |= IREE_HAL_BUFFER_USAGE_MAPPING;
+    out_create_info->requiredFlags |= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+  }
+  if (iree_all_bits_set(*memory_type, IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL)) {
+    if (iree_all_bits_set(*memory_type, IREE_HAL_MEMORY_TYPE_HOST_VISIBLE)) {
+      // Device-local, host-visible.
+      out_create_info->usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
+      out_create_info->preferredFlags |= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    } else {
+      // Device-local only.
+      out_create_info->usage = VMA_MEMORY_USAGE_GPU_ONLY;
+      out_create_info->requiredFlags |= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    }
+  } else {
+    if (iree_all_bits_set(*memory_type, IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE)) {
+      // Host-local, device-visible.
+      out_create_info->usage = VMA_MEMORY_USAGE_GPU_TO_CPU;
+    } else {
+      // Host-local only.
+      out_create_info->usage = VMA_MEMORY_USAGE_CPU_ONLY;
+    }
+  }
+  if (iree_all_bits_set(*memory_type, IREE_HAL_MEMORY_TYPE_HOST_CACHED)) {
+    out_create_info->requiredFlags |= VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+  }
+  if (iree_all_bits_set(*memory_type, IREE_HAL_MEMORY_TYPE_HOST_COHERENT)) {
+    out_create_info->requiredFlags |= VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+  }
+  if (iree_all_bits_set(*memory_type, IREE_HAL_MEMORY_TYPE_TRANSIENT)) {
+    out_create_info->preferredFlags |= VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+  }
+  if (iree_all_bits_set(*allowed_usage, IREE_HAL_BUFFER_USAGE_MAPPING)) {
+    out_create_info->requiredFlags |= VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+    // Keep mappable allocations persistently mapped such that mapping ranges
+    // of the buffer is a pointer offset instead of a vkMapMemory call.
+    out_create_info->flags |= VMA_ALLOCATION_CREATE_MAPPED_BIT;
+  }
+}
+
+// Creates the dedicated pool for |pool_class| with |params|, if enabled.
+// The pool memory type is selected as if allocating a buffer of the class.
+static iree_status_t iree_hal_vulkan_vma_allocator_create_pool(
+    iree_hal_vulkan_vma_allocator_t* allocator,
+    iree_hal_vulkan_vma_pool_class_t pool_class,
+    const iree_hal_vulkan_memory_pool_params_t* params) {
+  if (params->block_size == 0) return iree_ok_status();
+  iree_hal_memory_type_t memory_type = IREE_HAL_MEMORY_TYPE_NONE;
+  iree_hal_buffer_usage_t allowed_usage = IREE_HAL_BUFFER_USAGE_TRANSFER;
+  switch (pool_class) {
+    case IREE_HAL_VULKAN_VMA_POOL_CLASS_CONSTANT:
+      memory_type = IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL;
+      allowed_usage |=
+          IREE_HAL_BUFFER_USAGE_CONSTANT | IREE_HAL_BUFFER_USAGE_DISPATCH;
+      break;
+    case IREE_HAL_VULKAN_VMA_POOL_CLASS_TRANSIENT:
+      memory_type =
+          IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_TRANSIENT;
+      allowed_usage |= IREE_HAL_BUFFER_USAGE_DISPATCH;
+      break;
+    default:
+    case IREE_HAL_VULKAN_VMA_POOL_CLASS_STAGING:
+      memory_type =
+          IREE_HAL_MEMORY_TYPE_HOST_LOCAL | IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE;
+      allowed_usage |= IREE_HAL_BUFFER_USAGE_MAPPING;
+      break;
+  }
+  VkBufferCreateInfo buffer_create_info;
+  iree_hal_vulkan_vma_allocator_populate_buffer_create_info(
+      allocator, allowed_usage, /*allocation_size=*/4, &buffer_create_info);
+  VmaAllocationCreateInfo allocation_create_info;
+  iree_hal_vulkan_vma_allocator_populate_allocation_create_info(
+      allocator, &memory_type, &allowed_usage, /*flags=*/0,
+      &allocation_create_info);
+
+  iree_hal_vulkan_vma_pool_t* pool = &allocator->pools[pool_class];
+  VK_RETURN_IF_ERROR(vmaFindMemoryTypeIndexForBufferInfo(
+                         allocator->vma, &buffer_create_info,
+                         &allocation_create_info, &pool->memory_type_index),
+                     "vmaFindMemoryTypeIndexForBufferInfo");
+
+  VmaPoolCreateInfo pool_create_info;
+  memset(&pool_create_info, 0, sizeof(pool_create_info));
+  pool_create_info.memoryTypeIndex = pool->memory_type_index;
+  // Pools only ever contain buffers.
+  pool_create_info.flags = VMA_POOL_CREATE_IGNORE_BUFFER_IMAGE_GRANULARITY_BIT;
+  // Limits smaller than a block shrink the block to the limit.
+  VkDeviceSize block_size = params->block_size;
+  if (params->max_size && params->max_size < block_size) {
+    block_size = params->max_size;
+  }
+  pool_create_info.blockSize = block_size;
+  pool_create_info.minBlockCount = 0;
+  pool_create_info.maxBlockCount =
+      (size_t)((params->max_size + block_size - 1) / block_size);
+  pool_create_info.frameInUseCount = 0;
+  return VK_RESULT_TO_STATUS(
+      vmaCreatePool(allocator->vma, &pool_create_info, &pool->handle),
+      "vmaCreatePool");
+}
+
 iree_status_t iree_hal_vulkan_vma_allocator_create(
-    VkInstance instance, VkPhysicalDevice physical_device,
-    VkDeviceHandle* logical_device, iree_hal_device_t* device,
-    VmaRecordSettings record_settings, iree_hal_allocator_t** out_allocator) {
+    const iree_hal_vulkan_device_options_t* options,
+    iree_hal_vulkan_device_extensions_t device_extensions, VkInstance instance,
+    VkPhysicalDevice physical_device, VkDeviceHandle* logical_device,
+    iree_hal_device_t* device, VmaRecordSettings record_settings,
+    iree_host_size_t queue_family_count, const uint32_t* queue_family_indices,
+    iree_hal_allocator_t** out_allocator) {
+  IREE_ASSERT_ARGUMENT(options);
   IREE_ASSERT_ARGUMENT(instance);
   IREE_ASSERT_ARGUMENT(physical_device);
   IREE_ASSERT_ARGUMENT(logical_device);
   IREE_ASSERT_ARGUMENT(device);
+  IREE_ASSERT_ARGUMENT(!queue_family_count || queue_family_indices);
   IREE_ASSERT_ARGUMENT(out_allocator);
+  if (queue_family_count > IREE_HAL_VULKAN_VMA_MAX_QUEUE_FAMILY_COUNT) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "buffers may be shared across at most %d queue "
+                            "families (%" PRIhsz " requested)",
+                            IREE_HAL_VULKAN_VMA_MAX_QUEUE_FAMILY_COUNT,
+                            queue_family_count);
+  }
   IREE_TRACE_ZONE_BEGIN(z0);
 
   iree_allocator_t host_allocator = logical_device->host_allocator();
@@ -97,10 +339,17 @@ iree_status_t iree_hal_vulkan_vma_allocator_create(
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
       z0, iree_allocator_malloc(host_allocator, sizeof(*allocator),
                                 (void**)&allocator));
+  memset(allocator, 0, sizeof(*allocator));
   iree_hal_resource_initialize(&iree_hal_vulkan_vma_allocator_vtable,
                                &allocator->resource);
   allocator->host_allocator = host_allocator;
+  allocator->enforce_memory_budget = !iree_all_bits_set(
+      options->flags, IREE_HAL_VULKAN_DEVICE_IGNORE_MEMORY_BUDGET);
   allocator->device = device;
+  allocator->queue_family_count = (uint32_t)queue_family_count;
+  for (iree_host_size_t i = 0; i < queue_family_count; ++i) {
+    allocator->queue_family_indices[i] = queue_family_indices[i];
+  }
 
   const auto& syms = logical_device->syms();
   VmaVulkanFunctions vulkan_fns;
@@ -126,6 +375,10 @@ iree_status_t iree_hal_vulkan_vma_allocator_create(
   vulkan_fns.vkCreateImage = syms->vkCreateImage;
   vulkan_fns.vkDestroyImage = syms->vkDestroyImage;
   vulkan_fns.vkCmdCopyBuffer = syms->vkCmdCopyBuffer;
+  vulkan_fns.vkGetPhysicalDeviceMemoryProperties2KHR =
+      syms->vkGetPhysicalDeviceMemoryProperties2
+          ? syms->vkGetPhysicalDeviceMemoryProperties2
+          : syms->vkGetPhysicalDeviceMemoryProperties2KHR;
 
   VmaDeviceMemoryCallbacks device_memory_callbacks;
   memset(&device_memory_callbacks, 0, sizeof(device_memory_callbacks));
@@ -138,10 +391,15 @@ iree_status_t iree_hal_vulkan_vma_allocator_create(
   VmaAllocatorCreateInfo create_info;
   memset(&create_info, 0, sizeof(create_info));
   create_info.flags = 0;
+  if (device_extensions.memory_budget &&
+      vulkan_fns.vkGetPhysicalDeviceMemoryProperties2KHR) {
+    // Without the extension VMA estimates budgets from the heap sizes.
+    create_info.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+  }
   create_info.physicalDevice = physical_device;
   create_info.device = *logical_device;
   create_info.instance = instance;
-  create_info.preferredLargeHeapBlockSize = 64 * 1024 * 1024;
+  create_info.preferredLargeHeapBlockSize = options->large_heap_block_size;
   create_info.pAllocationCallbacks = logical_device->allocator();
   create_info.pDeviceMemoryCallbacks = &device_memory_callbacks;
   create_info.frameInUseCount = 0;
@@ -155,16 +413,38 @@ iree_status_t iree_hal_vulkan_vma_allocator_create(
   if (iree_status_is_ok(status)) {
     allocator->vma = vma;
 
+    const VkPhysicalDeviceMemoryProperties* memory_props = NULL;
+    vmaGetMemoryProperties(allocator->vma, &memory_props);
+    allocator->is_unified_memory =
+        iree_hal_vulkan_vma_allocator_is_unified_memory(memory_props);
+    if (allocator->is_unified_memory) {
+      IREE_TRACE_ZONE_APPEND_TEXT(z0, "unified memory");
+    }
     IREE_STATISTICS({
-      const VkPhysicalDeviceMemoryProperties* memory_props = NULL;
-      vmaGetMemoryProperties(allocator->vma, &memory_props);
       memcpy(&allocator->memory_props, memory_props,
              sizeof(allocator->memory_props));
     });
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_vulkan_vma_allocator_create_pool(
+        allocator, IREE_HAL_VULKAN_VMA_POOL_CLASS_CONSTANT,
+        &options->constant_pool);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_vulkan_vma_allocator_create_pool(
+        allocator, IREE_HAL_VULKAN_VMA_POOL_CLASS_TRANSIENT,
+        &options->transient_pool);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_vulkan_vma_allocator_create_pool(
+        allocator, IREE_HAL_VULKAN_VMA_POOL_CLASS_STAGING,
+        &options->staging_pool);
+  }
 
+  if (iree_status_is_ok(status)) {
     *out_allocator = (iree_hal_allocator_t*)allocator;
   } else {
-    vmaDestroyAllocator(vma);
+    iree_hal_allocator_release((iree_hal_allocator_t*)allocator);
   }
 
   IREE_TRACE_ZONE_END(z0);
@@ -178,6 +458,11 @@ static void iree_hal_vulkan_vma_allocator_destroy(
   iree_allocator_t host_allocator = allocator->host_allocator;
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(allocator->pools); ++i) {
+    if (allocator->pools[i].handle) {
+      vmaDestroyPool(allocator->vma, allocator->pools[i].handle);
+    }
+  }
   vmaDestroyAllocator(allocator->vma);
   iree_allocator_free(host_allocator, allocator);
 
@@ -203,6 +488,31 @@ static void iree_hal_vulkan_vma_allocator_query_statistics(
     iree_hal_vulkan_vma_allocator_t* allocator =
         iree_hal_vulkan_vma_allocator_cast(base_allocator);
     memcpy(out_statistics, &allocator->statistics, sizeof(*out_statistics));
+
+    // Budgets are tracked per heap; report those of the device-local heaps.
+    VmaBudget budgets[VK_MAX_MEMORY_HEAPS];
+    vmaGetBudget(allocator->vma, budgets);
+    for (uint32_t i = 0; i < allocator->memory_props.memoryHeapCount; ++i) {
+      if (!iree_all_bits_set(allocator->memory_props.memoryHeaps[i].flags,
+                             VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)) {
+        continue;
+      }
+      out_statistics->device_bytes_reserved += budgets[i].blockBytes;
+      out_statistics->device_bytes_budget += budgets[i].budget;
+      out_statistics->device_bytes_usage += budgets[i].usage;
+    }
+
+    iree_device_size_t* pool_bytes_live[] = {
+        &out_statistics->constant_bytes_live,
+        &out_statistics->transient_bytes_live,
+        &out_statistics->staging_bytes_live,
+    };
+    for (iree_host_size_t i = 0; i < IREE_ARRAYSIZE(allocator->pools); ++i) {
+      if (!allocator->pools[i].handle) continue;
+      VmaPoolStats pool_stats;
+      vmaGetPoolStats(allocator->vma, allocator->pools[i].handle, &pool_stats);
+      *pool_bytes_live[i] = pool_stats.size - pool_stats.unusedSize;
+    }
   });
 }
 
@@ -259,79 +569,51 @@ static iree_status_t iree_hal_vulkan_vma_allocator_allocate_internal(
   // act safely even on buffer ranges that are not naturally aligned.
   allocation_size = iree_host_align(allocation_size, 4);
 
+  // Classify before the memory type is adjusted for unified memory.
+  iree_hal_vulkan_vma_pool_class_t pool_class =
+      iree_hal_vulkan_vma_allocator_pool_class(memory_type, allowed_usage);
+
   VkBufferCreateInfo buffer_create_info;
-  buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-  buffer_create_info.pNext = NULL;
-  buffer_create_info.flags = 0;
-  buffer_create_info.size = allocation_size;
-  buffer_create_info.usage = 0;
-  if (iree_all_bits_set(allowed_usage, IREE_HAL_BUFFER_USAGE_TRANSFER)) {
-    buffer_create_info.usage |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-    buffer_create_info.usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
-  }
-  if (iree_all_bits_set(allowed_usage, IREE_HAL_BUFFER_USAGE_DISPATCH)) {
-    buffer_create_info.usage |= VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-    buffer_create_info.usage |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
-    buffer_create_info.usage |= VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
-  }
-  buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-  buffer_create_info.queueFamilyIndexCount = 0;
-  buffer_create_info.pQueueFamilyIndices = NULL;
+  iree_hal_vulkan_vma_allocator_populate_buffer_create_info(
+      allocator, allowed_usage, allocation_size, &buffer_create_info);
 
+  if (allocator->enforce_memory_budget) {
+    flags |= VMA_ALLOCATION_CREATE_WITHIN_BUDGET_BIT;
+  }
   VmaAllocationCreateInfo allocation_create_info;
-  allocation_create_info.flags = flags;
-  allocation_create_info.usage = VMA_MEMORY_USAGE_UNKNOWN;
-  allocation_create_info.requiredFlags = 0;
-  allocation_create_info.preferredFlags = 0;
-  allocation_create_info.memoryTypeBits = 0;  // Automatic selection.
-  allocation_create_info.pool = VK_NULL_HANDLE;
-  allocation_create_info.pUserData = NULL;
-  if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL)) {
-    if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_HOST_VISIBLE)) {
-      // Device-local, host-visible.
-      allocation_create_info.usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
-      allocation_create_info.preferredFlags |=
-          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
-    } else {
-      // Device-local only.
-      allocation_create_info.usage = VMA_MEMORY_USAGE_GPU_ONLY;
-      allocation_create_info.requiredFlags |=
-          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+  iree_hal_vulkan_vma_allocator_populate_allocation_create_info(
+      allocator, &memory_type, &allowed_usage, flags, &allocation_create_info);
+
+  // Use the dedicated pool of the class if its memory type satisfies the
+  // requirements of the allocation (such as when host caching is requested).
+  if (pool_class != IREE_HAL_VULKAN_VMA_POOL_CLASS_NONE &&
+      allocator->pools[pool_class].handle) {
+    const iree_hal_vulkan_vma_pool_t* pool = &allocator->pools[pool_class];
+    VmaAllocationCreateInfo pool_create_info = allocation_create_info;
+    pool_create_info.memoryTypeBits = 1u << pool->memory_type_index;
+    uint32_t memory_type_index = 0;
+    if (vmaFindMemoryTypeIndexForBufferInfo(
+            allocator->vma, &buffer_create_info, &pool_create_info,
+            &memory_type_index) == VK_SUCCESS) {
+      allocation_create_info.pool = pool->handle;
     }
-  } else {
-    if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE)) {
-      // Host-local, device-visible.
-      allocation_create_info.usage = VMA_MEMORY_USAGE_GPU_TO_CPU;
-    } else {
-      // Host-local only.
-      allocation_create_info.usage = VMA_MEMORY_USAGE_CPU_ONLY;
-    }
-  }
-  if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_HOST_CACHED)) {
-    allocation_create_info.requiredFlags |= VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
-  }
-  if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_HOST_COHERENT)) {
-    allocation_create_info.requiredFlags |=
-        VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-  }
-  if (iree_all_bits_set(memory_type, IREE_HAL_MEMORY_TYPE_TRANSIENT)) {
-    allocation_create_info.preferredFlags |=
-        VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
-  }
-  if (iree_all_bits_set(allowed_usage, IREE_HAL_BUFFER_USAGE_MAPPING)) {
-    allocation_create_info.requiredFlags |= VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
   }
 
-  // TODO(benvanik): if on a unified memory system and initial data is present
-  // we could set the mapping bit and ensure a much more efficient upload.
-
   VkBuffer handle = VK_NULL_HANDLE;
   VmaAllocation allocation = VK_NULL_HANDLE;
   VmaAllocationInfo allocation_info;
-  VK_RETURN_IF_ERROR(vmaCreateBuffer(allocator->vma, &buffer_create_info,
-                                     &allocation_create_info, &handle,
-                                     &allocation, &allocation_info),
-                     "vmaCreateBuffer");
+  VkResult result = vmaCreateBuffer(allocator->vma, &buffer_create_info,
+                                    &allocation_create_info, &handle,
+                                    &allocation, &allocation_info);
+  if (result == VK_ERROR_OUT_OF_DEVICE_MEMORY) {
+    // Either the heap budget or the pool limit would be exceeded.
+    return iree_make_status(
+        IREE_STATUS_RESOURCE_EXHAUSTED,
+        "allocation of %" PRIhsz
+        "B failed: heap memory budget or pool limit exceeded",
+        allocation_size);
+  }
+  VK_RETURN_IF_ERROR(result, "vmaCreateBuffer");
 
   iree_hal_buffer_t* buffer = NULL;
   iree_status_t status = iree_hal_vulkan_vma_buffer_wrap(
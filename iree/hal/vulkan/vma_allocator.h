@@ -9,6 +9,8 @@
 
 #include "iree/base/api.h"
 #include "iree/hal/api.h"
+#include "iree/hal/vulkan/api.h"
+#include "iree/hal/vulkan/extensibility_util.h"
 #include "iree/hal/vulkan/handle_util.h"
 #include "iree/hal/vulkan/internal_vk_mem_alloc.h"  // IWYU pragma: export
 
@@ -16,6 +18,9 @@
 extern "C" {
 #endif  // __cplusplus
 
+// Maximum number of queue families buffers may be shared across.
+#define IREE_HAL_VULKAN_VMA_MAX_QUEUE_FAMILY_COUNT 2
+
 // Creates a VMA-based allocator that performs internal suballocation and a
 // bunch of other fancy things.
 //
@@ -30,13 +35,26 @@ extern "C" {
 // VMA is internally synchronized and the functionality exposed on the HAL
 // interface is thread-safe.
 //
+// Buffers are shared concurrently across all |queue_family_indices| so that
+// they may be used by queues of different families (such as a dedicated
+// transfer queue) without ownership transfers. At most
+// IREE_HAL_VULKAN_VMA_MAX_QUEUE_FAMILY_COUNT unique families may be provided.
+//
+// Allocations are serviced from dedicated pools per usage class as configured
+// by |options| and fail gracefully when exceeding the heap memory budget
+// unless IREE_HAL_VULKAN_DEVICE_IGNORE_MEMORY_BUDGET is set. Budgets are
+// queried with VK_EXT_memory_budget when enabled in |device_extensions|.
+//
 // More information:
 //   https://github.com/GPUOpen-LibrariesAndSDKs/VulkanMemoryAllocator
 //   https://gpuopen-librariesandsdks.github.io/VulkanMemoryAllocator/html/
 iree_status_t iree_hal_vulkan_vma_allocator_create(
-    VkInstance instance, VkPhysicalDevice physical_device,
+    const iree_hal_vulkan_device_options_t* options,
+    iree_hal_vulkan_device_extensions_t device_extensions, VkInstance instance,
+    VkPhysicalDevice physical_device,
     iree::hal::vulkan::VkDeviceHandle* logical_device,
     iree_hal_device_t* device, VmaRecordSettings record_settings,
+    iree_host_size_t queue_family_count, const uint32_t* queue_family_indices,
     iree_hal_allocator_t** out_allocator);
 
 #ifdef __cplusplus
@@ -115,10 +115,14 @@ static iree_status_t iree_hal_vulkan_vma_buffer_map_range(
       iree_hal_buffer_validate_usage(iree_hal_buffer_allowed_usage(base_buffer),
                                      IREE_HAL_BUFFER_USAGE_MAPPING));
 
-  uint8_t* data_ptr = nullptr;
-  VK_RETURN_IF_ERROR(
-      vmaMapMemory(buffer->vma, buffer->allocation, (void**)&data_ptr),
-      "vmaMapMemory");
+  // Persistently mapped allocations are used as-is and otherwise the memory is
+  // mapped for the duration of the mapping.
+  uint8_t* data_ptr = (uint8_t*)buffer->allocation_info.pMappedData;
+  if (!data_ptr) {
+    VK_RETURN_IF_ERROR(
+        vmaMapMemory(buffer->vma, buffer->allocation, (void**)&data_ptr),
+        "vmaMapMemory");
+  }
   mapping->contents =
       iree_make_byte_span(data_ptr + local_byte_offset, local_byte_length);
 
@@ -140,7 +144,9 @@ static iree_status_t iree_hal_vulkan_vma_buffer_unmap_range(
     iree_device_size_t local_byte_length, iree_hal_buffer_mapping_t* mapping) {
   iree_hal_vulkan_vma_buffer_t* buffer =
       iree_hal_vulkan_vma_buffer_cast(base_buffer);
-  vmaUnmapMemory(buffer->vma, buffer->allocation);
+  if (!buffer->allocation_info.pMappedData) {
+    vmaUnmapMemory(buffer->vma, buffer->allocation);
+  }
   return iree_ok_status();
 }
 
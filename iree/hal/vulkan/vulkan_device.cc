@@ -12,26 +12,32 @@
 #include <vector>
 
 #include "iree/base/internal/arena.h"
+#include "iree/base/internal/atomics.h"
 #include "iree/base/internal/math.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/utils/buffer_transfer.h"
+#include "iree/hal/utils/preparation_pool.h"
 #include "iree/hal/vulkan/api.h"
 #include "iree/hal/vulkan/builtin_executables.h"
 #include "iree/hal/vulkan/command_queue.h"
 #include "iree/hal/vulkan/descriptor_pool_cache.h"
 #include "iree/hal/vulkan/direct_command_buffer.h"
 #include "iree/hal/vulkan/direct_command_queue.h"
+#include "iree/hal/vulkan/dispatch_profiler.h"
 #include "iree/hal/vulkan/dynamic_symbols.h"
 #include "iree/hal/vulkan/emulated_semaphore.h"
 #include "iree/hal/vulkan/extensibility_util.h"
 #include "iree/hal/vulkan/handle_util.h"
+#include "iree/hal/vulkan/indirect_command_buffer.h"
 #include "iree/hal/vulkan/native_descriptor_set.h"
 #include "iree/hal/vulkan/native_descriptor_set_layout.h"
 #include "iree/hal/vulkan/native_event.h"
 #include "iree/hal/vulkan/native_executable_layout.h"
 #include "iree/hal/vulkan/native_semaphore.h"
 #include "iree/hal/vulkan/nop_executable_cache.h"
+#include "iree/hal/vulkan/pipeline_cache.h"
 #include "iree/hal/vulkan/serializing_command_queue.h"
+#include "iree/hal/vulkan/staging_buffer.h"
 #include "iree/hal/vulkan/status_util.h"
 #include "iree/hal/vulkan/timepoint_util.h"
 #include "iree/hal/vulkan/tracing.h"
@@ -89,6 +95,20 @@ IREE_API_EXPORT iree_status_t iree_hal_vulkan_query_extensibility_set(
   ADD_EXT(IREE_HAL_VULKAN_EXTENSIBILITY_DEVICE_EXTENSIONS_OPTIONAL,
           VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
 
+  // VK_KHR_synchronization2:
+  // lets all batches of a submission go to the queue with a single
+  // vkQueueSubmit2KHR call carrying per-semaphore values and stage masks.
+  // Queues fall back to vkQueueSubmit with timeline submit infos without it.
+  ADD_EXT(IREE_HAL_VULKAN_EXTENSIBILITY_DEVICE_EXTENSIONS_OPTIONAL,
+          VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+
+  // VK_EXT_memory_budget:
+  // reports the memory budget of each heap so that allocations can fail
+  // gracefully before the platform kills the process for exceeding it (as is
+  // common on mobile). Budgets are estimated from the heap sizes without it.
+  ADD_EXT(IREE_HAL_VULKAN_EXTENSIBILITY_DEVICE_EXTENSIONS_OPTIONAL,
+          VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
   //===--------------------------------------------------------------------===//
   // Vulkan forward-compatibility shims
   //===--------------------------------------------------------------------===//
@@ -132,25 +152,20 @@ IREE_API_EXPORT iree_status_t iree_hal_vulkan_query_extensibility_set(
             VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
   }
 
-#if IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION
-  if (iree_all_bits_set(requested_features,
-                        IREE_HAL_VULKAN_FEATURE_ENABLE_TRACING)) {
-    // VK_EXT_host_query_reset:
-    // optionally allows for vkResetQueryPool to be used to reset query pools
-    // from the host without needing to do an expensive vkCmdResetQueryPool
-    // submission.
-    ADD_EXT(IREE_HAL_VULKAN_EXTENSIBILITY_DEVICE_EXTENSIONS_OPTIONAL,
-            VK_EXT_HOST_QUERY_RESET_EXTENSION_NAME);
-
-    // VK_EXT_calibrated_timestamps:
-    // optionally provides more accurate timestamps that correspond to the
-    // system time. If this is not present then tracy will attempt calibration
-    // itself and have some per-run variance in the skew (up to many
-    // milliseconds).
-    ADD_EXT(IREE_HAL_VULKAN_EXTENSIBILITY_DEVICE_EXTENSIONS_OPTIONAL,
-            VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME);
-  }
-#endif  // IREE_TRACING_FEATURES & IREE_TRACING_FEATURE_INSTRUMENTATION
+  // VK_EXT_host_query_reset:
+  // optionally allows for vkResetQueryPool to be used to reset query pools
+  // from the host without needing to do an expensive vkCmdResetQueryPool
+  // submission. Required for device profiling.
+  ADD_EXT(IREE_HAL_VULKAN_EXTENSIBILITY_DEVICE_EXTENSIONS_OPTIONAL,
+          VK_EXT_HOST_QUERY_RESET_EXTENSION_NAME);
+
+  // VK_EXT_calibrated_timestamps:
+  // optionally provides more accurate timestamps that correspond to the
+  // system time. If this is not present then tracy will attempt calibration
+  // itself and have some per-run variance in the skew (up to many
+  // milliseconds) and device profiling reports device-relative timestamps.
+  ADD_EXT(IREE_HAL_VULKAN_EXTENSIBILITY_DEVICE_EXTENSIONS_OPTIONAL,
+          VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME);
 
   *out_string_count = string_count;
   return status;
@@ -358,6 +373,9 @@ typedef struct iree_hal_vulkan_device_t {
   // |queue_count| tracing contexts, if tracing is enabled.
   iree_hal_vulkan_tracing_context_t** queue_tracing_contexts;
 
+  // Captures dispatch timestamps and statistics while profiling.
+  iree_hal_vulkan_dispatch_profiler_t* dispatch_profiler;
+
   DescriptorPoolCache* descriptor_pool_cache;
 
   VkCommandPoolHandle* dispatch_command_pool;
@@ -372,6 +390,26 @@ typedef struct iree_hal_vulkan_device_t {
   TimePointFencePool* fence_pool;
 
   BuiltinExecutables* builtin_executables;
+
+  // Optional pool used to create executable pipelines asynchronously.
+  iree_hal_preparation_pool_t* preparation_pool;
+
+  // Optional persistent cache shared by all pipelines created on the device.
+  iree_hal_vulkan_pipeline_cache_t* pipeline_cache;
+  // Dispatch count after which executables specialize pipelines on recurring
+  // push constant values. 0 if disabled.
+  uint32_t pipeline_specialization_threshold;
+
+  // Ring buffer used to stage uploads on the transfer queue, created on first
+  // use. 0 capacity if uploads are performed synchronously.
+  iree_device_size_t staging_buffer_capacity;
+  iree_slim_mutex_t staging_mutex;
+  iree_hal_vulkan_staging_buffer_t* staging_buffer;
+  // Staging semaphore value signaled by the last upload submitted and the
+  // last value observed as completed. Accessed without |staging_mutex| when
+  // submitting work that must wait on uploads.
+  iree_atomic_int64_t staging_pending_value;
+  iree_atomic_int64_t staging_retired_value;
 } iree_hal_vulkan_device_t;
 
 namespace {
@@ -388,6 +426,14 @@ IREE_API_EXPORT void iree_hal_vulkan_device_options_initialize(
     iree_hal_vulkan_device_options_t* out_options) {
   memset(out_options, 0, sizeof(*out_options));
   out_options->flags = 0;
+  out_options->executable_load_worker_count = 4;
+  out_options->executable_cache_path = iree_string_view_empty();
+  out_options->pipeline_specialization_threshold = 2;
+  out_options->staging_buffer_capacity = 16 * 1024 * 1024;
+  out_options->large_heap_block_size = 64 * 1024 * 1024;
+  out_options->constant_pool.block_size = 32 * 1024 * 1024;
+  out_options->transient_pool.block_size = 64 * 1024 * 1024;
+  out_options->staging_pool.block_size = 16 * 1024 * 1024;
 }
 
 // Creates a transient command pool for the given queue family.
@@ -416,10 +462,11 @@ static iree_status_t iree_hal_vulkan_create_transient_command_pool(
 }
 
 // Creates a command queue of the given queue family.
-static CommandQueue* iree_hal_vulkan_device_create_queue(
+static iree_status_t iree_hal_vulkan_device_create_queue(
     VkDeviceHandle* logical_device,
     iree_hal_command_category_t command_category, uint32_t queue_family_index,
-    uint32_t queue_index, TimePointFencePool* fence_pool) {
+    uint32_t queue_index, TimePointFencePool* fence_pool,
+    CommandQueue** out_queue) {
   VkQueue queue = VK_NULL_HANDLE;
   logical_device->syms()->vkGetDeviceQueue(*logical_device, queue_family_index,
                                            queue_index, &queue);
@@ -427,11 +474,16 @@ static CommandQueue* iree_hal_vulkan_device_create_queue(
   // When emulating timeline semaphores we use a special queue that allows us to
   // sequence the semaphores correctly.
   if (fence_pool != NULL) {
-    return new SerializingCommandQueue(logical_device, command_category, queue,
-                                       fence_pool);
+    *out_queue = new SerializingCommandQueue(logical_device, command_category,
+                                             queue, fence_pool);
+    return iree_ok_status();
   }
 
-  return new DirectCommandQueue(logical_device, command_category, queue);
+  DirectCommandQueue* direct_queue = NULL;
+  IREE_RETURN_IF_ERROR(DirectCommandQueue::Create(
+      logical_device, command_category, queue, &direct_queue));
+  *out_queue = direct_queue;
+  return iree_ok_status();
 }
 
 // Creates command queues for the given sets of queues and populates the
@@ -464,9 +516,10 @@ static iree_status_t iree_hal_vulkan_device_initialize_command_queues(
     iree_string_view_t queue_name =
         iree_make_string_view(queue_name_buffer, queue_name_length);
 
-    CommandQueue* queue = iree_hal_vulkan_device_create_queue(
+    CommandQueue* queue = NULL;
+    IREE_RETURN_IF_ERROR(iree_hal_vulkan_device_create_queue(
         device->logical_device, IREE_HAL_COMMAND_CATEGORY_ANY,
-        compute_queue_set->queue_family_index, i, device->fence_pool);
+        compute_queue_set->queue_family_index, i, device->fence_pool, &queue));
 
     iree_host_size_t queue_index = device->queue_count++;
     device->queues[queue_index] = queue;
@@ -502,9 +555,11 @@ static iree_status_t iree_hal_vulkan_device_initialize_command_queues(
     iree_string_view_t queue_name =
         iree_make_string_view(queue_name_buffer, queue_name_length);
 
-    CommandQueue* queue = iree_hal_vulkan_device_create_queue(
+    CommandQueue* queue = NULL;
+    IREE_RETURN_IF_ERROR(iree_hal_vulkan_device_create_queue(
         device->logical_device, IREE_HAL_COMMAND_CATEGORY_TRANSFER,
-        transfer_queue_set->queue_family_index, i, device->fence_pool);
+        transfer_queue_set->queue_family_index, i, device->fence_pool,
+        &queue));
 
     iree_host_size_t queue_index = device->queue_count++;
     device->queues[queue_index] = queue;
@@ -530,6 +585,7 @@ static iree_status_t iree_hal_vulkan_device_create_internal(
     const iree_hal_vulkan_device_options_t* options, VkInstance instance,
     VkPhysicalDevice physical_device, VkDeviceHandle* logical_device,
     const iree_hal_vulkan_device_extensions_t* device_extensions,
+    bool pipeline_statistics_enabled,
     const iree_hal_vulkan_queue_set_t* compute_queue_set,
     const iree_hal_vulkan_queue_set_t* transfer_queue_set,
     iree_allocator_t host_allocator, iree_hal_device_t** out_device) {
@@ -561,6 +617,8 @@ static iree_status_t iree_hal_vulkan_device_create_internal(
   buffer_ptr += iree_string_view_append_to_buffer(
       identifier, &device->identifier, (char*)buffer_ptr);
   device->flags = options->flags;
+  device->pipeline_specialization_threshold =
+      options->pipeline_specialization_threshold;
 
   device->device_extensions = *device_extensions;
   device->instance = instance;
@@ -570,6 +628,7 @@ static iree_status_t iree_hal_vulkan_device_create_internal(
 
   iree_arena_block_pool_initialize(32 * 1024, host_allocator,
                                    &device->block_pool);
+  iree_slim_mutex_initialize(&device->staging_mutex);
 
   // Point the queue storage into the new device allocation. The queues
   // themselves are populated
@@ -588,11 +647,24 @@ static iree_status_t iree_hal_vulkan_device_create_internal(
 
   // Create the device memory allocator that will service all buffer
   // allocation requests.
+  // Buffers are shared with the transfer queue family (if different) so that
+  // uploads staged on the transfer queue need no ownership transfers.
   VmaRecordSettings vma_record_settings;
   memset(&vma_record_settings, 0, sizeof(vma_record_settings));
+  uint32_t queue_family_indices[2] = {
+      compute_queue_set->queue_family_index,
+      transfer_queue_set->queue_family_index,
+  };
+  iree_host_size_t queue_family_count = 1;
+  if (transfer_queue_set->queue_indices != 0 &&
+      transfer_queue_set->queue_family_index !=
+          compute_queue_set->queue_family_index) {
+    queue_family_count = 2;
+  }
   iree_status_t status = iree_hal_vulkan_vma_allocator_create(
-      instance, physical_device, logical_device, (iree_hal_device_t*)device,
-      vma_record_settings, &device->device_allocator);
+      options, device_extensions, instance, physical_device, logical_device,
+      (iree_hal_device_t*)device, vma_record_settings, queue_family_count,
+      queue_family_indices, &device->device_allocator);
 
   // Create command pools for each queue family. If we don't have a transfer
   // queue then we'll ignore that one and just use the dispatch pool.
@@ -626,6 +698,11 @@ static iree_status_t iree_hal_vulkan_device_create_internal(
         TimePointFencePool::Create(device->logical_device, &device->fence_pool);
   }
 
+  // Staged uploads rely on the device ordering work with timeline semaphores.
+  if (!emulate_timeline_semaphores) {
+    device->staging_buffer_capacity = options->staging_buffer_capacity;
+  }
+
   // Initialize queues now that we've completed the rest of the device
   // initialization; this happens last as the queues require the pools allocated
   // above.
@@ -635,6 +712,26 @@ static iree_status_t iree_hal_vulkan_device_create_internal(
         transfer_queue_set);
   }
 
+  if (iree_status_is_ok(status) &&
+      !iree_string_view_is_empty(options->executable_cache_path)) {
+    status = iree_hal_vulkan_pipeline_cache_create(
+        device->logical_device, physical_device,
+        options->executable_cache_path, &device->pipeline_cache);
+  }
+
+  if (iree_status_is_ok(status) && options->executable_load_worker_count > 0) {
+    status = iree_hal_preparation_pool_create(
+        iree_make_cstring_view("iree-vulkan-load"),
+        options->executable_load_worker_count, host_allocator,
+        &device->preparation_pool);
+  }
+
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_vulkan_dispatch_profiler_allocate(
+        physical_device, device->logical_device, pipeline_statistics_enabled,
+        host_allocator, &device->dispatch_profiler);
+  }
+
   if (iree_status_is_ok(status)) {
     device->builtin_executables =
         new BuiltinExecutables(device->logical_device);
@@ -654,12 +751,23 @@ static void iree_hal_vulkan_device_destroy(iree_hal_device_t* base_device) {
   iree_allocator_t host_allocator = iree_hal_device_host_allocator(base_device);
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  // Executables hold no references to the pool so any pending pipeline
+  // creation must complete before the resources it uses are torn down.
+  iree_hal_preparation_pool_free(device->preparation_pool);
+
   // Drop all command queues. These may wait until idle in their destructor.
   for (iree_host_size_t i = 0; i < device->queue_count; ++i) {
     delete device->queues[i];
     iree_hal_vulkan_tracing_context_free(device->queue_tracing_contexts[i]);
   }
 
+  // Query pools may be freed now that no command buffers are executing.
+  iree_hal_vulkan_dispatch_profiler_free(device->dispatch_profiler);
+
+  // All uploads have completed now that the queues are idle.
+  iree_hal_vulkan_staging_buffer_free(device->staging_buffer);
+  iree_slim_mutex_deinitialize(&device->staging_mutex);
+
   // Drop command pools now that we know there are no more outstanding command
   // buffers.
   delete device->dispatch_command_pool;
@@ -672,6 +780,9 @@ static void iree_hal_vulkan_device_destroy(iree_hal_device_t* base_device) {
   delete device->semaphore_pool;
   delete device->fence_pool;
 
+  // Persists the pipelines created during the lifetime of the device.
+  iree_hal_vulkan_pipeline_cache_free(device->pipeline_cache);
+
   // There should be no more buffers live that use the allocator.
   iree_hal_allocator_release(device->device_allocator);
 
@@ -795,6 +906,14 @@ iree_status_t iree_hal_vulkan_device_create(
   features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
   device_create_info.pNext = &features2;
 
+  // Pipeline statistics are only used for profiling but are cheap to enable.
+  VkPhysicalDeviceFeatures supported_features;
+  memset(&supported_features, 0, sizeof(supported_features));
+  instance_syms->vkGetPhysicalDeviceFeatures(physical_device,
+                                             &supported_features);
+  features2.features.pipelineStatisticsQuery =
+      supported_features.pipelineStatisticsQuery;
+
   VkPhysicalDeviceTimelineSemaphoreFeatures semaphore_features;
   bool emulate_timeline_semaphores =
       !enabled_device_extensions.timeline_semaphore ||
@@ -810,6 +929,16 @@ iree_status_t iree_hal_vulkan_device_create(
     semaphore_features.timelineSemaphore = VK_TRUE;
   }
 
+  VkPhysicalDeviceSynchronization2FeaturesKHR synchronization_2_features;
+  if (enabled_device_extensions.synchronization_2) {
+    memset(&synchronization_2_features, 0, sizeof(synchronization_2_features));
+    synchronization_2_features.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+    synchronization_2_features.pNext = features2.pNext;
+    features2.pNext = &synchronization_2_features;
+    synchronization_2_features.synchronization2 = VK_TRUE;
+  }
+
   VkPhysicalDeviceHostQueryResetFeaturesEXT host_query_reset_features;
   if (enabled_device_extensions.host_query_reset) {
     memset(&host_query_reset_features, 0, sizeof(host_query_reset_features));
@@ -848,6 +977,7 @@ iree_status_t iree_hal_vulkan_device_create(
     status = iree_hal_vulkan_device_create_internal(
         driver, identifier, enabled_features, options, instance,
         physical_device, logical_device, &enabled_device_extensions,
+        features2.features.pipelineStatisticsQuery == VK_TRUE,
         &compute_queue_set, &transfer_queue_set, host_allocator, out_device);
   }
 
@@ -903,7 +1033,8 @@ IREE_API_EXPORT iree_status_t iree_hal_vulkan_wrap_device(
   iree_status_t status = iree_hal_vulkan_device_create_internal(
       /*driver=*/NULL, identifier, enabled_features, options, instance,
       physical_device, logical_device_handle, &enabled_device_extensions,
-      compute_queue_set, transfer_queue_set, host_allocator, out_device);
+      /*pipeline_statistics_enabled=*/false, compute_queue_set,
+      transfer_queue_set, host_allocator, out_device);
 
   logical_device_handle->ReleaseReference();
   return status;
@@ -986,6 +1117,21 @@ static iree_status_t iree_hal_vulkan_device_create_command_buffer(
     iree_hal_command_buffer_t** out_command_buffer) {
   iree_hal_vulkan_device_t* device = iree_hal_vulkan_device_cast(base_device);
 
+  if (iree_all_bits_set(mode,
+                        IREE_HAL_COMMAND_BUFFER_MODE_INDIRECT_BINDINGS)) {
+    // Bindings are resolved on submit into direct command buffers that the
+    // queue retains until they complete, which relies on the queue timeline
+    // only available with native timeline semaphores.
+    if (device->fence_pool != NULL) {
+      return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                              "indirect command buffer bindings require "
+                              "native timeline semaphores");
+    }
+    return iree_hal_vulkan_indirect_command_buffer_create(
+        base_device, mode, command_categories, queue_affinity,
+        &device->block_pool, device->host_allocator, out_command_buffer);
+  }
+
   // TODO(scotttodd): revisit queue selection logic and remove this
   //   * the unaligned buffer fill polyfill and tracing timestamp queries may
   //     both insert dispatches into command buffers that at compile time are
@@ -1017,7 +1163,8 @@ static iree_status_t iree_hal_vulkan_device_create_command_buffer(
   return iree_hal_vulkan_direct_command_buffer_allocate(
       base_device, device->logical_device, command_pool, mode,
       command_categories, queue_affinity, queue->tracing_context(),
-      device->descriptor_pool_cache, device->builtin_executables,
+      device->dispatch_profiler, device->descriptor_pool_cache,
+      device->builtin_executables,
       &device->block_pool, out_command_buffer);
 }
 
@@ -1054,8 +1201,14 @@ static iree_status_t iree_hal_vulkan_device_create_executable_cache(
     iree_hal_device_t* base_device, iree_string_view_t identifier,
     iree_hal_executable_cache_t** out_executable_cache) {
   iree_hal_vulkan_device_t* device = iree_hal_vulkan_device_cast(base_device);
+  VkPipelineCache pipeline_cache =
+      device->pipeline_cache
+          ? iree_hal_vulkan_pipeline_cache_handle(device->pipeline_cache)
+          : VK_NULL_HANDLE;
   return iree_hal_vulkan_nop_executable_cache_create(
-      device->logical_device, identifier, out_executable_cache);
+      device->logical_device, pipeline_cache, device->preparation_pool,
+      device->pipeline_specialization_threshold, identifier,
+      out_executable_cache);
 }
 
 static iree_status_t iree_hal_vulkan_device_create_executable_layout(
@@ -1082,6 +1235,270 @@ static iree_status_t iree_hal_vulkan_device_create_semaphore(
                                                  initial_value, out_semaphore);
 }
 
+static iree_status_t iree_hal_vulkan_device_wait_semaphores(
+    iree_hal_device_t* base_device, iree_hal_wait_mode_t wait_mode,
+    const iree_hal_semaphore_list_t* semaphore_list, iree_timeout_t timeout);
+
+static iree_status_t iree_hal_vulkan_device_queue_alloca(
+    iree_hal_device_t* base_device, iree_hal_queue_affinity_t queue_affinity,
+    const iree_hal_semaphore_list_t wait_semaphore_list,
+    const iree_hal_semaphore_list_t signal_semaphore_list,
+    iree_hal_memory_type_t memory_type, iree_hal_buffer_usage_t allowed_usage,
+    iree_device_size_t allocation_size, iree_hal_buffer_t** out_buffer) {
+  iree_hal_vulkan_device_t* device = iree_hal_vulkan_device_cast(base_device);
+  CommandQueue* queue = iree_hal_vulkan_device_select_queue(
+      device, IREE_HAL_COMMAND_CATEGORY_ANY, queue_affinity);
+
+  // TODO(benvanik): pool transient allocations per queue. The memory is
+  // allocated immediately and only its availability is ordered on the queue.
+  iree_hal_buffer_t* buffer = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_allocator_allocate_buffer(
+      device->device_allocator, memory_type, allowed_usage, allocation_size,
+      iree_const_byte_span_empty(), &buffer));
+
+  iree_hal_submission_batch_t batch;
+  memset(&batch, 0, sizeof(batch));
+  batch.wait_semaphores = wait_semaphore_list;
+  batch.signal_semaphores = signal_semaphore_list;
+  batch.binding_table = iree_hal_buffer_binding_table_empty();
+  iree_status_t status = queue->Submit(1, &batch);
+  if (iree_status_is_ok(status)) {
+    *out_buffer = buffer;
+  } else {
+    iree_hal_buffer_release(buffer);
+  }
+  return status;
+}
+
+static iree_status_t iree_hal_vulkan_device_queue_dealloca(
+    iree_hal_device_t* base_device, iree_hal_queue_affinity_t queue_affinity,
+    const iree_hal_semaphore_list_t wait_semaphore_list,
+    const iree_hal_semaphore_list_t signal_semaphore_list,
+    iree_hal_buffer_t* buffer) {
+  iree_hal_vulkan_device_t* device = iree_hal_vulkan_device_cast(base_device);
+  CommandQueue* queue = iree_hal_vulkan_device_select_queue(
+      device, IREE_HAL_COMMAND_CATEGORY_ANY, queue_affinity);
+
+  iree_hal_submission_batch_t batch;
+  memset(&batch, 0, sizeof(batch));
+  batch.signal_semaphores = signal_semaphore_list;
+  batch.binding_table = iree_hal_buffer_binding_table_empty();
+
+  if (device->fence_pool == NULL) {
+    // Native timeline semaphores: the queue waits on the device and retains
+    // the buffer until the submission completes so that the caller may release
+    // it immediately.
+    batch.wait_semaphores = wait_semaphore_list;
+    iree_hal_resource_t* resource = (iree_hal_resource_t*)buffer;
+    return static_cast<DirectCommandQueue*>(queue)->SubmitAndRetain(
+        1, &batch, 1, &resource);
+  }
+
+  // Emulated timeline semaphores: waiting on the host ensures all work using
+  // the buffer has completed such that the caller may release it immediately.
+  IREE_RETURN_IF_ERROR(iree_hal_vulkan_device_wait_semaphores(
+      base_device, IREE_HAL_WAIT_MODE_ALL, &wait_semaphore_list,
+      iree_infinite_timeout()));
+  return queue->Submit(1, &batch);
+}
+
+// Returns the staging semaphore and value that work submitted to the device
+// must wait on for all staged uploads to have completed. |out_semaphore| is
+// NULL if no uploads are pending.
+static iree_status_t iree_hal_vulkan_device_query_pending_upload(
+    iree_hal_vulkan_device_t* device, iree_hal_semaphore_t** out_semaphore,
+    uint64_t* out_value) {
+  *out_semaphore = NULL;
+  *out_value = 0ull;
+  uint64_t pending_value = (uint64_t)iree_atomic_load_int64(
+      &device->staging_pending_value, iree_memory_order_acquire);
+  uint64_t retired_value = (uint64_t)iree_atomic_load_int64(
+      &device->staging_retired_value, iree_memory_order_relaxed);
+  if (pending_value <= retired_value) return iree_ok_status();
+
+  // The staging buffer is created before the first pending value is
+  // published.
+  iree_hal_semaphore_t* semaphore =
+      iree_hal_vulkan_staging_buffer_semaphore(device->staging_buffer);
+  uint64_t current_value = 0ull;
+  IREE_RETURN_IF_ERROR(iree_hal_semaphore_query(semaphore, &current_value));
+  if (current_value >= pending_value) {
+    // Racing stores may publish an older value; that only costs a query.
+    iree_atomic_store_int64(&device->staging_retired_value,
+                            (int64_t)current_value, iree_memory_order_relaxed);
+    return iree_ok_status();
+  }
+  *out_semaphore = semaphore;
+  *out_value = pending_value;
+  return iree_ok_status();
+}
+
+// Populates |out_wait_semaphores| with |wait_semaphores| and |semaphore| at
+// |value|, allocating the new list from |arena|.
+static iree_status_t iree_hal_vulkan_device_append_upload_wait(
+    iree_arena_allocator_t* arena,
+    const iree_hal_semaphore_list_t* wait_semaphores,
+    iree_hal_semaphore_t* semaphore, uint64_t value,
+    iree_hal_semaphore_list_t* out_wait_semaphores) {
+  iree_host_size_t count = wait_semaphores->count + 1;
+  iree_hal_semaphore_t** semaphores = NULL;
+  IREE_RETURN_IF_ERROR(iree_arena_allocate(
+      arena, count * sizeof(*semaphores), (void**)&semaphores));
+  uint64_t* payload_values = NULL;
+  IREE_RETURN_IF_ERROR(iree_arena_allocate(
+      arena, count * sizeof(*payload_values), (void**)&payload_values));
+  for (iree_host_size_t i = 0; i < wait_semaphores->count; ++i) {
+    semaphores[i] = wait_semaphores->semaphores[i];
+    payload_values[i] = wait_semaphores->payload_values[i];
+  }
+  semaphores[count - 1] = semaphore;
+  payload_values[count - 1] = value;
+  out_wait_semaphores->count = count;
+  out_wait_semaphores->semaphores = semaphores;
+  out_wait_semaphores->payload_values = payload_values;
+  return iree_ok_status();
+}
+
+// Stages |data_length| bytes of |source_data| and submits a copy of them into
+// |target_buffer| on the transfer queue. Must be called with the staging
+// mutex held.
+static iree_status_t iree_hal_vulkan_device_stage_upload_chunk(
+    iree_hal_vulkan_device_t* device, const uint8_t* source_data,
+    iree_hal_buffer_t* target_buffer, iree_device_size_t target_offset,
+    iree_device_size_t data_length, iree_timeout_t timeout) {
+  iree_hal_vulkan_staging_buffer_t* staging_buffer = device->staging_buffer;
+  iree_hal_vulkan_staging_range_t range;
+  IREE_RETURN_IF_ERROR(iree_hal_vulkan_staging_buffer_reserve(
+      staging_buffer, data_length, timeout, &range));
+  memcpy(range.data, source_data, data_length);
+  iree_status_t status = iree_hal_vulkan_staging_buffer_flush(staging_buffer);
+
+  // Without dedicated transfer queues the transfer queues are the dispatch
+  // queues and the dispatch command pool must be used.
+  CommandQueue* queue = device->transfer_queues[0];
+  VkCommandPoolHandle* command_pool = device->transfer_command_pool
+                                          ? device->transfer_command_pool
+                                          : device->dispatch_command_pool;
+  iree_hal_command_buffer_t* command_buffer = NULL;
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_vulkan_direct_command_buffer_allocate(
+        (iree_hal_device_t*)device, device->logical_device, command_pool,
+        IREE_HAL_COMMAND_BUFFER_MODE_ONE_SHOT,
+        IREE_HAL_COMMAND_CATEGORY_TRANSFER, IREE_HAL_QUEUE_AFFINITY_ANY,
+        queue->tracing_context(), /*dispatch_profiler=*/NULL,
+        device->descriptor_pool_cache, device->builtin_executables,
+        &device->block_pool, &command_buffer);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_command_buffer_begin(command_buffer);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_command_buffer_copy_buffer(
+        command_buffer, range.buffer, range.offset, target_buffer,
+        target_offset, data_length);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_command_buffer_end(command_buffer);
+  }
+
+  // The target buffer is retained with the command buffer until the copy
+  // completes so that callers may release it immediately.
+  uint64_t signal_value =
+      iree_hal_vulkan_staging_buffer_next_value(staging_buffer);
+  if (iree_status_is_ok(status)) {
+    iree_hal_semaphore_t* semaphore =
+        iree_hal_vulkan_staging_buffer_semaphore(staging_buffer);
+    iree_hal_submission_batch_t batch;
+    memset(&batch, 0, sizeof(batch));
+    batch.command_buffer_count = 1;
+    batch.command_buffers = &command_buffer;
+    batch.signal_semaphores.count = 1;
+    batch.signal_semaphores.semaphores = &semaphore;
+    batch.signal_semaphores.payload_values = &signal_value;
+    iree_hal_resource_t* resources[2] = {
+        (iree_hal_resource_t*)command_buffer,
+        (iree_hal_resource_t*)target_buffer,
+    };
+    status = static_cast<DirectCommandQueue*>(queue)->SubmitAndRetain(
+        1, &batch, IREE_ARRAYSIZE(resources), resources);
+  }
+  iree_hal_command_buffer_release(command_buffer);
+
+  if (iree_status_is_ok(status)) {
+    iree_hal_vulkan_staging_buffer_commit(staging_buffer);
+    iree_atomic_store_int64(&device->staging_pending_value,
+                            (int64_t)signal_value, iree_memory_order_release);
+  } else {
+    iree_hal_vulkan_staging_buffer_discard(staging_buffer);
+  }
+  return status;
+}
+
+// Uploads |data_length| bytes of |source_data| into |target_buffer| through
+// the staging buffer without waiting for the copy to complete. Work submitted
+// afterward waits on the upload, see
+// iree_hal_vulkan_device_query_pending_upload.
+static iree_status_t iree_hal_vulkan_device_stage_upload(
+    iree_hal_vulkan_device_t* device, const uint8_t* source_data,
+    iree_hal_buffer_t* target_buffer, iree_device_size_t target_offset,
+    iree_device_size_t data_length, iree_timeout_t timeout) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, data_length);
+  iree_slim_mutex_lock(&device->staging_mutex);
+
+  iree_status_t status = iree_ok_status();
+  if (!device->staging_buffer) {
+    status = iree_hal_vulkan_staging_buffer_create(
+        (iree_hal_device_t*)device, device->staging_buffer_capacity,
+        device->host_allocator, &device->staging_buffer);
+  }
+
+  // Uploads larger than the staging buffer are split into chunks that are each
+  // submitted once staged.
+  iree_device_size_t chunk_capacity =
+      iree_status_is_ok(status)
+          ? iree_hal_vulkan_staging_buffer_capacity(device->staging_buffer)
+          : 0;
+  iree_convert_timeout_to_absolute(&timeout);
+  for (iree_device_size_t offset = 0;
+       offset < data_length && iree_status_is_ok(status);
+       offset += chunk_capacity) {
+    status = iree_hal_vulkan_device_stage_upload_chunk(
+        device, source_data + offset, target_buffer, target_offset + offset,
+        iree_min(chunk_capacity, data_length - offset), timeout);
+  }
+
+  iree_slim_mutex_unlock(&device->staging_mutex);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static iree_status_t iree_hal_vulkan_device_transfer_range(
+    iree_hal_device_t* base_device, iree_hal_transfer_buffer_t source,
+    iree_device_size_t source_offset, iree_hal_transfer_buffer_t target,
+    iree_device_size_t target_offset, iree_device_size_t data_length,
+    iree_hal_transfer_buffer_flags_t flags, iree_timeout_t timeout) {
+  iree_hal_vulkan_device_t* device = iree_hal_vulkan_device_cast(base_device);
+
+  // Only uploads from host memory into buffers that cannot be mapped are
+  // staged; mappable targets are written directly by the host and downloads
+  // must complete before returning.
+  bool is_upload = !source.device_buffer && target.device_buffer;
+  if (!is_upload || device->staging_buffer_capacity == 0 ||
+      iree_all_bits_set(iree_hal_buffer_allowed_usage(target.device_buffer),
+                        IREE_HAL_BUFFER_USAGE_MAPPING)) {
+    return iree_hal_device_submit_transfer_range_and_wait(
+        base_device, source, source_offset, target, target_offset,
+        data_length, flags, timeout);
+  }
+  if (data_length == IREE_WHOLE_BUFFER) {
+    data_length = source.host_buffer.data_length - source_offset;
+  }
+  return iree_hal_vulkan_device_stage_upload(
+      device, source.host_buffer.data + source_offset, target.device_buffer,
+      target_offset, data_length, timeout);
+}
+
 static iree_status_t iree_hal_vulkan_device_queue_submit(
     iree_hal_device_t* base_device,
     iree_hal_command_category_t command_categories,
@@ -1090,7 +1507,83 @@ static iree_status_t iree_hal_vulkan_device_queue_submit(
   iree_hal_vulkan_device_t* device = iree_hal_vulkan_device_cast(base_device);
   CommandQueue* queue = iree_hal_vulkan_device_select_queue(
       device, command_categories, queue_affinity);
-  return queue->Submit(batch_count, batches);
+
+  iree_host_size_t indirect_count = 0;
+  for (iree_host_size_t i = 0; i < batch_count; ++i) {
+    for (iree_host_size_t j = 0; j < batches[i].command_buffer_count; ++j) {
+      if (iree_hal_vulkan_indirect_command_buffer_isa(
+              batches[i].command_buffers[j])) {
+        ++indirect_count;
+      }
+    }
+  }
+  iree_hal_semaphore_t* upload_semaphore = NULL;
+  uint64_t upload_value = 0ull;
+  IREE_RETURN_IF_ERROR(iree_hal_vulkan_device_query_pending_upload(
+      device, &upload_semaphore, &upload_value));
+  if (indirect_count == 0 && !upload_semaphore) {
+    return queue->Submit(batch_count, batches);
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Resolve indirect command buffers against the binding table of their batch.
+  // The resolved command buffers are retained by the queue until the
+  // submission completes as the indirect command buffer may replace them on
+  // its next submission while they are still in-flight.
+  iree_arena_allocator_t arena;
+  iree_arena_initialize(&device->block_pool, &arena);
+  iree_hal_submission_batch_t* resolved_batches = NULL;
+  iree_hal_resource_t** resources = NULL;
+  iree_status_t status = iree_arena_allocate(
+      &arena, batch_count * sizeof(*resolved_batches),
+      (void**)&resolved_batches);
+  if (iree_status_is_ok(status) && indirect_count > 0) {
+    status = iree_arena_allocate(&arena, indirect_count * sizeof(*resources),
+                                 (void**)&resources);
+  }
+  iree_host_size_t resource_count = 0;
+  for (iree_host_size_t i = 0; i < batch_count && iree_status_is_ok(status);
+       ++i) {
+    const iree_hal_submission_batch_t* batch = &batches[i];
+    resolved_batches[i] = *batch;
+    resolved_batches[i].binding_table = iree_hal_buffer_binding_table_empty();
+    if (upload_semaphore) {
+      status = iree_hal_vulkan_device_append_upload_wait(
+          &arena, &batch->wait_semaphores, upload_semaphore, upload_value,
+          &resolved_batches[i].wait_semaphores);
+    }
+    if (!iree_status_is_ok(status) || indirect_count == 0) continue;
+    iree_hal_command_buffer_t** command_buffers = NULL;
+    status = iree_arena_allocate(
+        &arena, batch->command_buffer_count * sizeof(*command_buffers),
+        (void**)&command_buffers);
+    for (iree_host_size_t j = 0;
+         j < batch->command_buffer_count && iree_status_is_ok(status); ++j) {
+      command_buffers[j] = batch->command_buffers[j];
+      if (!iree_hal_vulkan_indirect_command_buffer_isa(command_buffers[j])) {
+        continue;
+      }
+      status = iree_hal_vulkan_indirect_command_buffer_resolve(
+          batch->command_buffers[j], batch->binding_table,
+          &command_buffers[j]);
+      if (iree_status_is_ok(status)) {
+        resources[resource_count++] = (iree_hal_resource_t*)command_buffers[j];
+      }
+    }
+    resolved_batches[i].command_buffers = command_buffers;
+  }
+  if (iree_status_is_ok(status)) {
+    if (resource_count > 0) {
+      status = static_cast<DirectCommandQueue*>(queue)->SubmitAndRetain(
+          batch_count, resolved_batches, resource_count, resources);
+    } else {
+      status = queue->Submit(batch_count, resolved_batches);
+    }
+  }
+  iree_arena_deinitialize(&arena);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
 }
 
 static iree_status_t iree_hal_vulkan_device_submit_and_wait(
@@ -1133,6 +1626,26 @@ static iree_status_t iree_hal_vulkan_device_wait_idle(
   return iree_ok_status();
 }
 
+static iree_status_t iree_hal_vulkan_device_profiling_begin(
+    iree_hal_device_t* base_device,
+    const iree_hal_device_profiling_options_t* options) {
+  iree_hal_vulkan_device_t* device = iree_hal_vulkan_device_cast(base_device);
+  return iree_hal_vulkan_dispatch_profiler_begin(device->dispatch_profiler,
+                                                 options);
+}
+
+static iree_status_t iree_hal_vulkan_device_profiling_flush(
+    iree_hal_device_t* base_device) {
+  iree_hal_vulkan_device_t* device = iree_hal_vulkan_device_cast(base_device);
+  return iree_hal_vulkan_dispatch_profiler_flush(device->dispatch_profiler);
+}
+
+static iree_status_t iree_hal_vulkan_device_profiling_end(
+    iree_hal_device_t* base_device) {
+  iree_hal_vulkan_device_t* device = iree_hal_vulkan_device_cast(base_device);
+  return iree_hal_vulkan_dispatch_profiler_end(device->dispatch_profiler);
+}
+
 namespace {
 const iree_hal_device_vtable_t iree_hal_vulkan_device_vtable = {
     /*.destroy=*/iree_hal_vulkan_device_destroy,
@@ -1151,11 +1664,16 @@ const iree_hal_device_vtable_t iree_hal_vulkan_device_vtable = {
     /*.create_executable_layout=*/
     iree_hal_vulkan_device_create_executable_layout,
     /*.create_semaphore=*/iree_hal_vulkan_device_create_semaphore,
-    /*.transfer_range=*/iree_hal_device_submit_transfer_range_and_wait,
+    /*.transfer_range=*/iree_hal_vulkan_device_transfer_range,
+    /*.queue_alloca=*/iree_hal_vulkan_device_queue_alloca,
+    /*.queue_dealloca=*/iree_hal_vulkan_device_queue_dealloca,
     /*.queue_submit=*/iree_hal_vulkan_device_queue_submit,
     /*.submit_and_wait=*/
     iree_hal_vulkan_device_submit_and_wait,
     /*.wait_semaphores=*/iree_hal_vulkan_device_wait_semaphores,
     /*.wait_idle=*/iree_hal_vulkan_device_wait_idle,
+    /*.profiling_begin=*/iree_hal_vulkan_device_profiling_begin,
+    /*.profiling_flush=*/iree_hal_vulkan_device_profiling_flush,
+    /*.profiling_end=*/iree_hal_vulkan_device_profiling_end,
 };
 }  // namespace
@@ -14,14 +14,30 @@
 #include <string.h>
 
 #include "iree/base/api.h"
+#include "iree/base/internal/synchronization.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/api.h"
+#include "iree/hal/utils/object_pool.h"
 #include "iree/vm/api.h"
 
 // Limit the number of bindings we pass down through the HAL. This can be tuned
 // in the future but right now guards the stack from blowing up during calls.
 #define IREE_HAL_MODULE_MAX_DESCRIPTOR_BINDING_COUNT ((iree_host_size_t)32)
 
+// Buffer views and subspan buffers are created on nearly every invocation and
+// are recycled through a per-device object pool. Blocks are sized to hold a
+// subspan buffer or a buffer view with up to this many dimensions; higher
+// ranks fall back to the host allocator.
+#define IREE_HAL_MODULE_OBJECT_POOL_INLINE_SHAPE_RANK ((iree_host_size_t)6)
+
+// Maximum number of freed objects retained by the object pool.
+#define IREE_HAL_MODULE_OBJECT_POOL_MAX_FREE_COUNT ((iree_host_size_t)256)
+
+// Limit the number of push constants a packed command stream may update in a
+// single command. Matches the limit most backends place on push constant
+// ranges and keeps the decode scratch on the stack.
+#define IREE_HAL_MODULE_MAX_PUSH_CONSTANT_COUNT ((iree_host_size_t)64)
+
 //===----------------------------------------------------------------------===//
 // Type registration
 //===----------------------------------------------------------------------===//
@@ -117,6 +133,12 @@ IREE_VM_DEFINE_TYPE_ADAPTERS(iree_hal_semaphore, iree_hal_semaphore_t);
 typedef struct iree_hal_module_t {
   iree_allocator_t host_allocator;
   iree_hal_device_t* shared_device;
+  // Optional registry shared with other modules; NULL if not sharing.
+  iree_hal_executable_registry_t* executable_registry;
+  // Additional caching mode bits used when preparing executables.
+  iree_hal_executable_caching_mode_t executable_caching_mode;
+  // Pool of host memory for buffer views and subspan buffers.
+  iree_hal_object_pool_t* object_pool;
   // TODO(benvanik): types.
 } iree_hal_module_t;
 
@@ -127,13 +149,27 @@ typedef struct iree_hal_module_state_t {
   iree_allocator_t host_allocator;
   iree_hal_device_t* shared_device;
   iree_hal_executable_cache_t* executable_cache;
-
+  // Optional registry shared with other contexts; NULL if not sharing.
+  iree_hal_executable_registry_t* executable_registry;
+  // Additional caching mode bits used when preparing executables.
+  iree_hal_executable_caching_mode_t executable_caching_mode;
+  // Shared with the module and all other states.
+  iree_hal_object_pool_t* object_pool;
+  // Allocator returned for the shared device in place of its own allocator;
+  // NULL if not overridden.
+  iree_hal_allocator_t* device_allocator;
+
+  // Guards submissions such that signal values are submitted in order when
+  // multiple modules are initialized concurrently.
+  iree_slim_mutex_t submit_mutex;
   iree_hal_semaphore_t* submit_semaphore;
   uint64_t submit_value;
 } iree_hal_module_state_t;
 
 static void IREE_API_PTR iree_hal_module_destroy(void* base_module) {
   iree_hal_module_t* module = IREE_HAL_MODULE_CAST(base_module);
+  iree_hal_object_pool_release(module->object_pool);
+  iree_hal_executable_registry_release(module->executable_registry);
   iree_hal_device_release(module->shared_device);
 }
 
@@ -151,12 +187,18 @@ iree_hal_module_alloc_state(void* self, iree_allocator_t host_allocator,
   state->host_allocator = host_allocator;
   state->shared_device = module->shared_device;
   iree_hal_device_retain(state->shared_device);
+  state->executable_registry = module->executable_registry;
+  iree_hal_executable_registry_retain(state->executable_registry);
+  state->executable_caching_mode = module->executable_caching_mode;
+  state->object_pool = module->object_pool;
+  iree_hal_object_pool_retain(state->object_pool);
 
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
       z0, iree_hal_executable_cache_create(state->shared_device,
                                            iree_string_view_empty(),
                                            &state->executable_cache));
 
+  iree_slim_mutex_initialize(&state->submit_mutex);
   state->submit_value = 0ull;
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
       z0, iree_hal_semaphore_create(state->shared_device, state->submit_value,
@@ -173,19 +215,74 @@ iree_hal_module_free_state(void* self, iree_vm_module_state_t* module_state) {
 
   iree_hal_module_state_t* state = (iree_hal_module_state_t*)module_state;
   iree_hal_semaphore_release(state->submit_semaphore);
+  iree_slim_mutex_deinitialize(&state->submit_mutex);
   iree_hal_executable_cache_release(state->executable_cache);
+  if (state->executable_registry) {
+    // Release any shared objects that were only in use by this context.
+    iree_hal_executable_registry_trim(state->executable_registry);
+    iree_hal_executable_registry_release(state->executable_registry);
+  }
+  iree_hal_allocator_release(state->device_allocator);
+  iree_hal_object_pool_release(state->object_pool);
   iree_hal_device_release(state->shared_device);
   iree_allocator_free(state->host_allocator, state);
 
   IREE_TRACE_ZONE_END(z0);
 }
 
+static iree_status_t IREE_API_PTR iree_hal_module_clone_state(
+    void* self, iree_allocator_t host_allocator,
+    iree_vm_module_state_t* source_module_state,
+    iree_vm_module_state_t** out_module_state) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_hal_module_state_t* source_state =
+      (iree_hal_module_state_t*)source_module_state;
+  iree_hal_module_state_t* state = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0,
+      iree_allocator_malloc(host_allocator, sizeof(*state), (void**)&state));
+  memset(state, 0, sizeof(*state));
+  state->host_allocator = host_allocator;
+  state->shared_device = source_state->shared_device;
+  iree_hal_device_retain(state->shared_device);
+  state->executable_registry = source_state->executable_registry;
+  iree_hal_executable_registry_retain(state->executable_registry);
+  state->object_pool = source_state->object_pool;
+  iree_hal_object_pool_retain(state->object_pool);
+  state->device_allocator = source_state->device_allocator;
+  iree_hal_allocator_retain(state->device_allocator);
+
+  // Executables prepared by the source context remain valid and are shared
+  // along with the cache used to prepare them.
+  state->executable_cache = source_state->executable_cache;
+  iree_hal_executable_cache_retain(state->executable_cache);
+
+  // Submissions are tracked per context so that waits in one context do not
+  // depend on work submitted by another.
+  iree_slim_mutex_initialize(&state->submit_mutex);
+  state->submit_value = 0ull;
+  iree_status_t status = iree_hal_semaphore_create(
+      state->shared_device, state->submit_value, &state->submit_semaphore);
+
+  if (iree_status_is_ok(status)) {
+    *out_module_state = (iree_vm_module_state_t*)state;
+  } else {
+    iree_hal_module_free_state(self, (iree_vm_module_state_t*)state);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
 static iree_status_t IREE_API_PTR iree_hal_module_notify(
     void* self, iree_vm_module_state_t* module_state, iree_vm_signal_t signal) {
   iree_hal_module_state_t* state = (iree_hal_module_state_t*)module_state;
   switch (signal) {
     case IREE_VM_SIGNAL_SUSPEND:
     case IREE_VM_SIGNAL_LOW_MEMORY:
+      if (state->executable_registry) {
+        iree_hal_executable_registry_trim(state->executable_registry);
+      }
       return iree_hal_device_trim(state->shared_device);
     default:
       return iree_ok_status();
@@ -222,27 +319,66 @@ IREE_VM_ABI_EXPORT(iree_hal_module_ex_submit_and_wait,  //
   batch.command_buffer_count = IREE_ARRAYSIZE(command_buffer_ptrs);
   batch.command_buffers = command_buffer_ptrs;
 
+  // Only the submission is serialized; concurrent callers wait on their own
+  // signal values.
+  iree_slim_mutex_lock(&state->submit_mutex);
   uint64_t next_semaphore_value = ++state->submit_value;
   iree_hal_semaphore_t* signal_semaphore_ptrs[] = {state->submit_semaphore};
   uint64_t signal_semaphore_values[] = {next_semaphore_value};
   batch.signal_semaphores.count = IREE_ARRAYSIZE(signal_semaphore_ptrs);
   batch.signal_semaphores.semaphores = signal_semaphore_ptrs;
   batch.signal_semaphores.payload_values = signal_semaphore_values;
+  iree_status_t status = iree_hal_device_queue_submit(
+      device, IREE_HAL_COMMAND_CATEGORY_ANY, 0, 1, &batch);
+  iree_slim_mutex_unlock(&state->submit_mutex);
+  IREE_RETURN_IF_ERROR(status);
 
-  iree_status_t status = iree_hal_device_submit_and_wait(
-      device, IREE_HAL_COMMAND_CATEGORY_ANY, 0, 1, &batch,
-      state->submit_semaphore, next_semaphore_value, iree_infinite_timeout());
-  if (!iree_status_is_ok(status)) {
-    return status;
-  }
-
-  return iree_ok_status();
+  return iree_hal_semaphore_wait(state->submit_semaphore, next_semaphore_value,
+                                 iree_infinite_timeout());
 }
 
 //===----------------------------------------------------------------------===//
 // iree_hal_allocator_t
 //===----------------------------------------------------------------------===//
 
+// Names |buffer| after the program location that requested it when allocation
+// events are being listened to such that allocations can be attributed to the
+// resources they were made for. Uses the source location of the calling frame
+// when available and otherwise falls back to the calling function name.
+static void iree_hal_module_name_buffer(iree_vm_stack_t* stack,
+                                        iree_allocator_t host_allocator,
+                                        iree_hal_buffer_t* buffer) {
+  if (IREE_LIKELY(!iree_hal_allocator_has_event_listener())) return;
+  iree_vm_stack_frame_t* caller_frame =
+      iree_vm_stack_frame_parent(iree_vm_stack_current_frame(stack));
+  if (!caller_frame) return;
+
+  iree_string_builder_t builder;
+  iree_string_builder_initialize(host_allocator, &builder);
+  iree_vm_source_location_t source_location;
+  iree_status_t status = iree_vm_module_resolve_source_location(
+      caller_frame->function.module, caller_frame, &source_location);
+  if (iree_status_is_ok(status)) {
+    status = iree_vm_source_location_format(
+        &source_location, IREE_VM_SOURCE_LOCATION_FORMAT_FLAG_SINGLE_LINE,
+        &builder);
+  } else {
+    iree_status_ignore(status);
+    iree_string_view_t module_name =
+        iree_vm_module_name(caller_frame->function.module);
+    iree_string_view_t function_name =
+        iree_vm_function_name(&caller_frame->function);
+    status = iree_string_builder_append_format(
+        &builder, "%.*s.%.*s@%d", (int)module_name.size, module_name.data,
+        (int)function_name.size, function_name.data, (int)caller_frame->pc);
+  }
+  if (iree_status_is_ok(status)) {
+    iree_hal_allocator_name_buffer(buffer, iree_string_builder_view(&builder));
+  }
+  iree_status_ignore(status);
+  iree_string_builder_deinitialize(&builder);
+}
+
 IREE_VM_ABI_EXPORT(iree_hal_module_allocator_allocate,  //
                    iree_hal_module_state_t,             //
                    riii, r) {
@@ -256,10 +392,73 @@ IREE_VM_ABI_EXPORT(iree_hal_module_allocator_allocate,  //
   IREE_RETURN_IF_ERROR(iree_hal_allocator_allocate_buffer(
       allocator, memory_types, buffer_usage, allocation_size,
       iree_const_byte_span_empty(), &buffer));
+  iree_hal_module_name_buffer(stack, state->host_allocator, buffer);
   rets->r0 = iree_hal_buffer_move_ref(buffer);
   return iree_ok_status();
 }
 
+IREE_VM_ABI_EXPORT(iree_hal_module_allocator_import,  //
+                   iree_hal_module_state_t,           //
+                   rrriii, r) {
+  iree_hal_allocator_t* allocator = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_allocator_check_deref(args->r0, &allocator));
+  iree_hal_buffer_t* source = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_buffer_check_deref(args->r1, &source));
+  iree_vm_buffer_t* message = NULL;
+  IREE_RETURN_IF_ERROR(iree_vm_buffer_check_deref(args->r2, &message));
+  iree_string_view_t message_str IREE_ATTRIBUTE_UNUSED =
+      iree_vm_buffer_as_string(message);
+  iree_vm_size_t minimum_length = (iree_vm_size_t)args->i3;
+  iree_hal_memory_type_t memory_types = (iree_hal_memory_type_t)args->i4;
+  iree_hal_buffer_usage_t buffer_usage = (iree_hal_buffer_usage_t)args->i5;
+
+  iree_device_size_t length = iree_hal_buffer_byte_length(source);
+  if (length < minimum_length) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "%.*s buffer byte length %" PRIdsz " less than expected minimum %d",
+        (int)message_str.size, message_str.data, length, minimum_length);
+  }
+
+  // Use the buffer as-is if it has all of the type and usage bits the program
+  // requires and the allocator can dispatch against it. This is the common
+  // case on CPU and unified memory devices and avoids any copies.
+  iree_hal_memory_type_t actual_memory_type =
+      iree_hal_buffer_memory_type(source);
+  iree_hal_buffer_usage_t actual_buffer_usage =
+      iree_hal_buffer_allowed_usage(source);
+  iree_hal_buffer_compatibility_t compatibility =
+      iree_hal_allocator_query_buffer_compatibility(
+          allocator, actual_memory_type, actual_buffer_usage, buffer_usage,
+          length);
+  if (iree_all_bits_set(actual_memory_type, memory_types) &&
+      iree_all_bits_set(actual_buffer_usage, buffer_usage) &&
+      iree_all_bits_set(compatibility,
+                        IREE_HAL_BUFFER_COMPATIBILITY_QUEUE_DISPATCH)) {
+    rets->r0 = iree_hal_buffer_retain_ref(source);
+    return iree_ok_status();
+  }
+
+  // Incompatible; copy the contents into a new buffer from the allocator.
+  // This requires the source to be mappable by the host.
+  iree_hal_buffer_mapping_t source_mapping;
+  IREE_RETURN_IF_ERROR(iree_hal_buffer_map_range(
+      source, IREE_HAL_MAPPING_MODE_SCOPED, IREE_HAL_MEMORY_ACCESS_READ, 0,
+      length, &source_mapping));
+  iree_hal_buffer_t* buffer = NULL;
+  iree_status_t status = iree_hal_allocator_allocate_buffer(
+      allocator, memory_types, buffer_usage, (iree_host_size_t)length,
+      iree_make_const_byte_span(source_mapping.contents.data,
+                                source_mapping.contents.data_length),
+      &buffer);
+  iree_status_ignore(iree_hal_buffer_unmap_range(&source_mapping));
+  if (iree_status_is_ok(status)) {
+    iree_hal_module_name_buffer(stack, state->host_allocator, buffer);
+    rets->r0 = iree_hal_buffer_move_ref(buffer);
+  }
+  return status;
+}
+
 static iree_status_t iree_hal_module_map_data_ctl(
     void* self, iree_allocator_command_t command, const void* params,
     void** inout_ptr) {
@@ -379,6 +578,7 @@ IREE_VM_ABI_EXPORT(iree_hal_module_allocator_wrap_byte_buffer,  //
           iree_make_const_byte_span(source->data.data + offset, length),
           &buffer),
       "failed to allocate buffer of length %d", length);
+  iree_hal_module_name_buffer(stack, state->host_allocator, buffer);
 
   rets->r0 = iree_hal_buffer_move_ref(buffer);
   return iree_ok_status();
@@ -492,8 +692,9 @@ IREE_VM_ABI_EXPORT(iree_hal_module_buffer_subspan,  //
 
   iree_hal_buffer_t* subspan_buffer = NULL;
   IREE_RETURN_IF_ERROR(
-      iree_hal_buffer_subspan(source_buffer, source_offset, length,
-                              &subspan_buffer),
+      iree_hal_buffer_subspan_with_allocator(
+          source_buffer, source_offset, length,
+          iree_hal_object_pool_allocator(state->object_pool), &subspan_buffer),
       "invalid subspan of an existing buffer (source_offset=%d, length=%d)",
       source_offset, length);
   rets->r0 = iree_hal_buffer_move_ref(subspan_buffer);
@@ -574,7 +775,7 @@ IREE_VM_ABI_EXPORT(iree_hal_module_buffer_view_create,  //
   iree_hal_buffer_view_t* buffer_view = NULL;
   IREE_RETURN_IF_ERROR(iree_hal_buffer_view_create(
       source_buffer, shape_dims, shape_rank, element_type, encoding_type,
-      state->host_allocator, &buffer_view));
+      iree_hal_object_pool_allocator(state->object_pool), &buffer_view));
   rets->r0 = iree_hal_buffer_view_move_ref(buffer_view);
   return iree_ok_status();
 }
@@ -1005,6 +1206,7 @@ IREE_VM_ABI_EXPORT(iree_hal_module_command_buffer_push_descriptor_set,  //
     IREE_RETURN_IF_ERROR(
         iree_hal_buffer_check_deref(args->a3[i].r1, &bindings[i].buffer));
     bindings[i].binding = (uint32_t)args->a3[i].i0;
+    bindings[i].buffer_slot = 0;
     bindings[i].offset = (iree_device_size_t)args->a3[i].i2;
     bindings[i].length = (iree_device_size_t)args->a3[i].i3;
   }
@@ -1070,6 +1272,296 @@ IREE_VM_ABI_EXPORT(iree_hal_module_command_buffer_dispatch_indirect,  //
       workgroups_offset);
 }
 
+// Opcodes of the packed command stream recorded by
+// hal.command_buffer.execute_commands. Must match the values the compiler
+// emits in PackCommandBuffers.cpp.
+//
+// The stream is a sequence of little-endian uint32 words. Each command begins
+// with a header word of `opcode | (operand_count << 8)` followed by
+// |operand_count| operand words. An operand word with the high bit set is an
+// index into the dynamic i32 values passed alongside the stream; otherwise it
+// is the immediate value itself. Operands naming refs are indices into the
+// refs list.
+enum iree_hal_module_command_opcode_e {
+  IREE_HAL_MODULE_COMMAND_EXECUTION_BARRIER = 1,
+  IREE_HAL_MODULE_COMMAND_FILL_BUFFER = 2,
+  IREE_HAL_MODULE_COMMAND_COPY_BUFFER = 3,
+  IREE_HAL_MODULE_COMMAND_PUSH_CONSTANTS = 4,
+  IREE_HAL_MODULE_COMMAND_PUSH_DESCRIPTOR_SET = 5,
+  IREE_HAL_MODULE_COMMAND_DISPATCH = 6,
+  IREE_HAL_MODULE_COMMAND_DISPATCH_INDIRECT = 7,
+};
+
+#define IREE_HAL_MODULE_COMMAND_DYNAMIC_BIT 0x80000000u
+
+typedef struct iree_hal_module_command_reader_t {
+  const iree_vm_list_t* refs;
+  const iree_vm_abi_i_t* values;
+  iree_host_size_t value_count;
+  // Operands of the command currently being decoded.
+  const uint32_t* operands;
+  iree_host_size_t operand_count;
+} iree_hal_module_command_reader_t;
+
+// Resolves operand |i| of the current command to its i32 value.
+static iree_status_t iree_hal_module_command_reader_i32(
+    iree_hal_module_command_reader_t* reader, iree_host_size_t i,
+    uint32_t* out_value) {
+  if (IREE_UNLIKELY(i >= reader->operand_count)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "command operand %zu out of range (%zu operands)",
+                            i, reader->operand_count);
+  }
+  uint32_t word = iree_unaligned_load_le_u32(&reader->operands[i]);
+  if (!(word & IREE_HAL_MODULE_COMMAND_DYNAMIC_BIT)) {
+    *out_value = word;
+    return iree_ok_status();
+  }
+  iree_host_size_t value_ordinal = word & ~IREE_HAL_MODULE_COMMAND_DYNAMIC_BIT;
+  if (IREE_UNLIKELY(value_ordinal >= reader->value_count)) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "dynamic value %zu out of range (%zu values)",
+                            value_ordinal, reader->value_count);
+  }
+  *out_value = (uint32_t)reader->values[value_ordinal].i0;
+  return iree_ok_status();
+}
+
+// Resolves operand |i| of the current command to the ref it indexes.
+static iree_status_t iree_hal_module_command_reader_ref(
+    iree_hal_module_command_reader_t* reader, iree_host_size_t i,
+    iree_vm_ref_t* out_ref) {
+  uint32_t ref_ordinal = 0;
+  IREE_RETURN_IF_ERROR(
+      iree_hal_module_command_reader_i32(reader, i, &ref_ordinal));
+  return iree_vm_list_get_ref_assign(reader->refs, ref_ordinal, out_ref);
+}
+
+static iree_status_t iree_hal_module_command_buffer_execute_command(
+    iree_hal_command_buffer_t* command_buffer, uint32_t opcode,
+    iree_hal_module_command_reader_t* reader) {
+  iree_vm_ref_t ref = {0};
+  switch (opcode) {
+    case IREE_HAL_MODULE_COMMAND_EXECUTION_BARRIER: {
+      uint32_t source_stage_mask = 0;
+      uint32_t target_stage_mask = 0;
+      uint32_t flags = 0;
+      IREE_RETURN_IF_ERROR(
+          iree_hal_module_command_reader_i32(reader, 0, &source_stage_mask));
+      IREE_RETURN_IF_ERROR(
+          iree_hal_module_command_reader_i32(reader, 1, &target_stage_mask));
+      IREE_RETURN_IF_ERROR(
+          iree_hal_module_command_reader_i32(reader, 2, &flags));
+      iree_hal_memory_barrier_t global_barrier;
+      global_barrier.source_scope = IREE_HAL_ACCESS_SCOPE_DISPATCH_WRITE;
+      global_barrier.target_scope = IREE_HAL_ACCESS_SCOPE_DISPATCH_READ;
+      return iree_hal_command_buffer_execution_barrier(
+          command_buffer, (iree_hal_execution_stage_t)source_stage_mask,
+          (iree_hal_execution_stage_t)target_stage_mask,
+          (iree_hal_execution_barrier_flags_t)flags, 1, &global_barrier, 0,
+          NULL);
+    }
+    case IREE_HAL_MODULE_COMMAND_FILL_BUFFER: {
+      iree_hal_buffer_t* target_buffer = NULL;
+      uint32_t target_offset = 0;
+      uint32_t length = 0;
+      uint32_t pattern = 0;
+      uint32_t pattern_length = 0;
+      IREE_RETURN_IF_ERROR(iree_hal_module_command_reader_ref(reader, 0, &ref));
+      IREE_RETURN_IF_ERROR(iree_hal_buffer_check_deref(ref, &target_buffer));
+      IREE_RETURN_IF_ERROR(
+          iree_hal_module_command_reader_i32(reader, 1, &target_offset));
+      IREE_RETURN_IF_ERROR(
+          iree_hal_module_command_reader_i32(reader, 2, &length));
+      IREE_RETURN_IF_ERROR(
+          iree_hal_module_command_reader_i32(reader, 3, &pattern));
+      IREE_RETURN_IF_ERROR(
+          iree_hal_module_command_reader_i32(reader, 4, &pattern_length));
+      return iree_hal_command_buffer_fill_buffer(command_buffer, target_buffer,
+                                                 target_offset, length,
+                                                 &pattern, pattern_length);
+    }
+    case IREE_HAL_MODULE_COMMAND_COPY_BUFFER: {
+      iree_hal_buffer_t* source_buffer = NULL;
+      uint32_t source_offset = 0;
+      iree_hal_buffer_t* target_buffer = NULL;
+      uint32_t target_offset = 0;
+      uint32_t length = 0;
+      IREE_RETURN_IF_ERROR(iree_hal_module_command_reader_ref(reader, 0, &ref));
+      IREE_RETURN_IF_ERROR(iree_hal_buffer_check_deref(ref, &source_buffer));
+      IREE_RETURN_IF_ERROR(
+          iree_hal_module_command_reader_i32(reader, 1, &source_offset));
+      IREE_RETURN_IF_ERROR(iree_hal_module_command_reader_ref(reader, 2, &ref));
+      IREE_RETURN_IF_ERROR(iree_hal_buffer_check_deref(ref, &target_buffer));
+      IREE_RETURN_IF_ERROR(
+          iree_hal_module_command_reader_i32(reader, 3, &target_offset));
+      IREE_RETURN_IF_ERROR(
+          iree_hal_module_command_reader_i32(reader, 4, &length));
+      return iree_hal_command_buffer_copy_buffer(command_buffer, source_buffer,
+                                                 source_offset, target_buffer,
+                                                 target_offset, length);
+    }
+    case IREE_HAL_MODULE_COMMAND_PUSH_CONSTANTS: {
+      iree_hal_executable_layout_t* executable_layout = NULL;
+      uint32_t offset = 0;
+      IREE_RETURN_IF_ERROR(iree_hal_module_command_reader_ref(reader, 0, &ref));
+      IREE_RETURN_IF_ERROR(
+          iree_hal_executable_layout_check_deref(ref, &executable_layout));
+      IREE_RETURN_IF_ERROR(
+          iree_hal_module_command_reader_i32(reader, 1, &offset));
+      iree_host_size_t value_count = reader->operand_count - 2;
+      if (IREE_UNLIKELY(value_count >
+                        IREE_HAL_MODULE_MAX_PUSH_CONSTANT_COUNT)) {
+        return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                                "push constant count %zu > %zu", value_count,
+                                IREE_HAL_MODULE_MAX_PUSH_CONSTANT_COUNT);
+      }
+      uint32_t values[IREE_HAL_MODULE_MAX_PUSH_CONSTANT_COUNT];
+      for (iree_host_size_t i = 0; i < value_count; ++i) {
+        IREE_RETURN_IF_ERROR(
+            iree_hal_module_command_reader_i32(reader, 2 + i, &values[i]));
+      }
+      return iree_hal_command_buffer_push_constants(
+          command_buffer, executable_layout, offset * sizeof(uint32_t), values,
+          value_count * sizeof(uint32_t));
+    }
+    case IREE_HAL_MODULE_COMMAND_PUSH_DESCRIPTOR_SET: {
+      iree_hal_executable_layout_t* executable_layout = NULL;
+      uint32_t set = 0;
+      IREE_RETURN_IF_ERROR(iree_hal_module_command_reader_ref(reader, 0, &ref));
+      IREE_RETURN_IF_ERROR(
+          iree_hal_executable_layout_check_deref(ref, &executable_layout));
+      IREE_RETURN_IF_ERROR(iree_hal_module_command_reader_i32(reader, 1, &set));
+      if (IREE_UNLIKELY((reader->operand_count - 2) % 4 != 0)) {
+        return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                                "malformed push_descriptor_set command");
+      }
+      iree_host_size_t binding_count = (reader->operand_count - 2) / 4;
+      if (IREE_UNLIKELY(binding_count >
+                        IREE_HAL_MODULE_MAX_DESCRIPTOR_BINDING_COUNT)) {
+        return iree_make_status(
+            IREE_STATUS_OUT_OF_RANGE, "binding count %zu > %zu",
+            binding_count, IREE_HAL_MODULE_MAX_DESCRIPTOR_BINDING_COUNT);
+      }
+      iree_hal_descriptor_set_binding_t
+          bindings[IREE_HAL_MODULE_MAX_DESCRIPTOR_BINDING_COUNT];
+      for (iree_host_size_t i = 0; i < binding_count; ++i) {
+        iree_host_size_t base = 2 + i * 4;
+        uint32_t binding = 0;
+        uint32_t offset = 0;
+        uint32_t length = 0;
+        IREE_RETURN_IF_ERROR(
+            iree_hal_module_command_reader_i32(reader, base + 0, &binding));
+        IREE_RETURN_IF_ERROR(
+            iree_hal_module_command_reader_ref(reader, base + 1, &ref));
+        IREE_RETURN_IF_ERROR(
+            iree_hal_buffer_check_deref(ref, &bindings[i].buffer));
+        IREE_RETURN_IF_ERROR(
+            iree_hal_module_command_reader_i32(reader, base + 2, &offset));
+        IREE_RETURN_IF_ERROR(
+            iree_hal_module_command_reader_i32(reader, base + 3, &length));
+        bindings[i].binding = binding;
+        bindings[i].buffer_slot = 0;
+        bindings[i].offset = (iree_device_size_t)offset;
+        bindings[i].length = (iree_device_size_t)length;
+      }
+      return iree_hal_command_buffer_push_descriptor_set(
+          command_buffer, executable_layout, set, binding_count, bindings);
+    }
+    case IREE_HAL_MODULE_COMMAND_DISPATCH: {
+      iree_hal_executable_t* executable = NULL;
+      uint32_t entry_point = 0;
+      uint32_t workgroup_x = 0;
+      uint32_t workgroup_y = 0;
+      uint32_t workgroup_z = 0;
+      IREE_RETURN_IF_ERROR(iree_hal_module_command_reader_ref(reader, 0, &ref));
+      IREE_RETURN_IF_ERROR(iree_hal_executable_check_deref(ref, &executable));
+      IREE_RETURN_IF_ERROR(
+          iree_hal_module_command_reader_i32(reader, 1, &entry_point));
+      IREE_RETURN_IF_ERROR(
+          iree_hal_module_command_reader_i32(reader, 2, &workgroup_x));
+      IREE_RETURN_IF_ERROR(
+          iree_hal_module_command_reader_i32(reader, 3, &workgroup_y));
+      IREE_RETURN_IF_ERROR(
+          iree_hal_module_command_reader_i32(reader, 4, &workgroup_z));
+      return iree_hal_command_buffer_dispatch(command_buffer, executable,
+                                              entry_point, workgroup_x,
+                                              workgroup_y, workgroup_z);
+    }
+    case IREE_HAL_MODULE_COMMAND_DISPATCH_INDIRECT: {
+      iree_hal_executable_t* executable = NULL;
+      uint32_t entry_point = 0;
+      iree_hal_buffer_t* workgroups_buffer = NULL;
+      uint32_t workgroups_offset = 0;
+      IREE_RETURN_IF_ERROR(iree_hal_module_command_reader_ref(reader, 0, &ref));
+      IREE_RETURN_IF_ERROR(iree_hal_executable_check_deref(ref, &executable));
+      IREE_RETURN_IF_ERROR(
+          iree_hal_module_command_reader_i32(reader, 1, &entry_point));
+      IREE_RETURN_IF_ERROR(iree_hal_module_command_reader_ref(reader, 2, &ref));
+      IREE_RETURN_IF_ERROR(
+          iree_hal_buffer_check_deref(ref, &workgroups_buffer));
+      IREE_RETURN_IF_ERROR(
+          iree_hal_module_command_reader_i32(reader, 3, &workgroups_offset));
+      return iree_hal_command_buffer_dispatch_indirect(
+          command_buffer, executable, entry_point, workgroups_buffer,
+          workgroups_offset);
+    }
+    default:
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "unknown packed command opcode %u", opcode);
+  }
+}
+
+// Records an entire packed command stream with a single VM call. The compiler
+// emits this in place of runs of individual command_buffer.* calls to avoid the
+// per-call marshaling overhead when recording large command buffers.
+IREE_VM_ABI_EXPORT(iree_hal_module_command_buffer_execute_commands,  //
+                   iree_hal_module_state_t,                          //
+                   rrrCiD, v) {
+  iree_hal_command_buffer_t* command_buffer = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_hal_command_buffer_check_deref(args->r0, &command_buffer));
+  iree_vm_buffer_t* commands = NULL;
+  IREE_RETURN_IF_ERROR(iree_vm_buffer_check_deref(args->r1, &commands));
+  iree_vm_list_t* refs = NULL;
+  IREE_RETURN_IF_ERROR(iree_vm_list_check_deref(args->r2, &refs));
+
+  iree_byte_span_t command_data = iree_vm_buffer_data(commands);
+  if (IREE_UNLIKELY(command_data.data_length % sizeof(uint32_t) != 0)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "packed command stream length %zu is not a "
+                            "multiple of the word size",
+                            command_data.data_length);
+  }
+  const uint32_t* words = (const uint32_t*)command_data.data;
+  iree_host_size_t word_count = command_data.data_length / sizeof(uint32_t);
+
+  iree_hal_module_command_reader_t reader = {
+      .refs = refs,
+      .values = args->a3,
+      .value_count = args->a3_count,
+      .operands = NULL,
+      .operand_count = 0,
+  };
+  iree_host_size_t word_offset = 0;
+  while (word_offset < word_count) {
+    uint32_t header = iree_unaligned_load_le_u32(&words[word_offset++]);
+    uint32_t opcode = header & 0xFFu;
+    iree_host_size_t operand_count = header >> 8;
+    if (IREE_UNLIKELY(operand_count > word_count - word_offset)) {
+      return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                              "packed command at word %zu overruns the stream",
+                              word_offset - 1);
+    }
+    reader.operands = &words[word_offset];
+    reader.operand_count = operand_count;
+    IREE_RETURN_IF_ERROR(iree_hal_module_command_buffer_execute_command(
+        command_buffer, opcode, &reader));
+    word_offset += operand_count;
+  }
+  return iree_ok_status();
+}
+
 //===----------------------------------------------------------------------===//
 // iree_hal_descriptor_set_t
 //===----------------------------------------------------------------------===//
@@ -1097,6 +1589,7 @@ IREE_VM_ABI_EXPORT(iree_hal_module_descriptor_set_create,  //
     IREE_RETURN_IF_ERROR(
         iree_hal_buffer_check_deref(args->a2[i].r1, &bindings[i].buffer));
     bindings[i].binding = (uint32_t)args->a2[i].i0;
+    bindings[i].buffer_slot = 0;
     bindings[i].offset = (iree_device_size_t)args->a2[i].i2;
     bindings[i].length = (iree_device_size_t)args->a2[i].i3;
   }
@@ -1136,8 +1629,15 @@ IREE_VM_ABI_EXPORT(iree_hal_module_descriptor_set_layout_create,  //
   }
 
   iree_hal_descriptor_set_layout_t* descriptor_set_layout = NULL;
-  IREE_RETURN_IF_ERROR(iree_hal_descriptor_set_layout_create(
-      device, usage_type, binding_count, bindings, &descriptor_set_layout));
+  if (state->executable_registry) {
+    IREE_RETURN_IF_ERROR(
+        iree_hal_executable_registry_descriptor_set_layout_create(
+            state->executable_registry, device, usage_type, binding_count,
+            bindings, &descriptor_set_layout));
+  } else {
+    IREE_RETURN_IF_ERROR(iree_hal_descriptor_set_layout_create(
+        device, usage_type, binding_count, bindings, &descriptor_set_layout));
+  }
   rets->r0 = iree_hal_descriptor_set_layout_move_ref(descriptor_set_layout);
   return iree_ok_status();
 }
@@ -1151,7 +1651,11 @@ IREE_VM_ABI_EXPORT(iree_hal_module_device_allocator,  //
                    r, r) {
   iree_hal_device_t* device = NULL;
   IREE_RETURN_IF_ERROR(iree_hal_device_check_deref(args->r0, &device));
-  rets->r0 = iree_hal_allocator_retain_ref(iree_hal_device_allocator(device));
+  iree_hal_allocator_t* allocator = iree_hal_device_allocator(device);
+  if (state->device_allocator && device == state->shared_device) {
+    allocator = state->device_allocator;
+  }
+  rets->r0 = iree_hal_allocator_retain_ref(allocator);
   return iree_ok_status();
 }
 
@@ -1208,6 +1712,7 @@ IREE_VM_ABI_EXPORT(iree_hal_module_executable_create,  //
   if (iree_status_is_ok(status)) {
     iree_hal_executable_spec_t spec;
     iree_hal_executable_spec_initialize(&spec);
+    spec.caching_mode |= state->executable_caching_mode;
     spec.caching_mode |=
         executable_data->access == IREE_VM_BUFFER_ACCESS_ORIGIN_MODULE
             ? IREE_HAL_EXECUTABLE_CACHING_MODE_ALIAS_PROVIDED_DATA
@@ -1217,8 +1722,14 @@ IREE_VM_ABI_EXPORT(iree_hal_module_executable_create,  //
         executable_data->data.data, executable_data->data.data_length);
     spec.executable_layout_count = executable_layout_count;
     spec.executable_layouts = executable_layouts;
-    status = iree_hal_executable_cache_prepare_executable(
-        state->executable_cache, &spec, &executable);
+    if (state->executable_registry) {
+      status = iree_hal_executable_registry_prepare_executable(
+          state->executable_registry, device, state->executable_cache, &spec,
+          &executable);
+    } else {
+      status = iree_hal_executable_cache_prepare_executable(
+          state->executable_cache, &spec, &executable);
+    }
   }
 
   iree_allocator_free(state->host_allocator, executable_layouts);
@@ -1243,9 +1754,15 @@ IREE_VM_ABI_EXPORT(iree_hal_module_executable_layout_create,  //
                               &set_layout_count, &set_layouts);
 
   iree_hal_executable_layout_t* executable_layout = NULL;
-  IREE_RETURN_IF_ERROR(iree_hal_executable_layout_create(
-      device, push_constants, set_layout_count, set_layouts,
-      &executable_layout));
+  if (state->executable_registry) {
+    IREE_RETURN_IF_ERROR(iree_hal_executable_registry_executable_layout_create(
+        state->executable_registry, device, push_constants, set_layout_count,
+        set_layouts, &executable_layout));
+  } else {
+    IREE_RETURN_IF_ERROR(iree_hal_executable_layout_create(
+        device, push_constants, set_layout_count, set_layouts,
+        &executable_layout));
+  }
   rets->r0 = iree_hal_executable_layout_move_ref(executable_layout);
   return iree_ok_status();
 }
@@ -1372,6 +1889,14 @@ static const iree_vm_native_module_descriptor_t iree_hal_module_descriptor_ = {
 IREE_API_EXPORT iree_status_t
 iree_hal_module_create(iree_hal_device_t* device, iree_allocator_t allocator,
                        iree_vm_module_t** out_module) {
+  return iree_hal_module_create_with_executable_registry(
+      device, /*executable_registry=*/NULL, allocator, out_module);
+}
+
+IREE_API_EXPORT iree_status_t iree_hal_module_create_with_executable_registry(
+    iree_hal_device_t* device,
+    iree_hal_executable_registry_t* executable_registry,
+    iree_allocator_t allocator, iree_vm_module_t** out_module) {
   IREE_ASSERT_ARGUMENT(device);
   IREE_ASSERT_ARGUMENT(out_module);
   *out_module = NULL;
@@ -1382,6 +1907,7 @@ iree_hal_module_create(iree_hal_device_t* device, iree_allocator_t allocator,
       .destroy = iree_hal_module_destroy,
       .alloc_state = iree_hal_module_alloc_state,
       .free_state = iree_hal_module_free_state,
+      .clone_state = iree_hal_module_clone_state,
       .notify = iree_hal_module_notify,
   };
 
@@ -1403,17 +1929,48 @@ iree_hal_module_create(iree_hal_device_t* device, iree_allocator_t allocator,
   module->host_allocator = allocator;
   module->shared_device = device;
   iree_hal_device_retain(module->shared_device);
+  module->executable_registry = executable_registry;
+  iree_hal_executable_registry_retain(module->executable_registry);
+
+  iree_host_size_t object_block_size = iree_max(
+      sizeof(iree_hal_buffer_t),
+      iree_hal_buffer_view_allocation_size(
+          IREE_HAL_MODULE_OBJECT_POOL_INLINE_SHAPE_RANK));
+  status = iree_hal_object_pool_create(
+      object_block_size, IREE_HAL_MODULE_OBJECT_POOL_MAX_FREE_COUNT, allocator,
+      &module->object_pool);
+  if (!iree_status_is_ok(status)) {
+    iree_vm_module_release(base_module);
+    return status;
+  }
 
   *out_module = base_module;
   return iree_ok_status();
 }
 
+IREE_API_EXPORT void iree_hal_module_set_executable_caching_mode(
+    iree_vm_module_t* base_module,
+    iree_hal_executable_caching_mode_t caching_mode) {
+  IREE_ASSERT_ARGUMENT(base_module);
+  iree_hal_module_t* module = IREE_HAL_MODULE_CAST(base_module);
+  module->executable_caching_mode = caching_mode;
+}
+
 IREE_API_EXPORT iree_hal_device_t* iree_hal_module_state_device(
     iree_vm_module_state_t* module_state) {
   iree_hal_module_state_t* state = (iree_hal_module_state_t*)module_state;
   return state->shared_device;
 }
 
+IREE_API_EXPORT void iree_hal_module_state_set_device_allocator(
+    iree_vm_module_state_t* module_state, iree_hal_allocator_t* allocator) {
+  IREE_ASSERT_ARGUMENT(module_state);
+  iree_hal_module_state_t* state = (iree_hal_module_state_t*)module_state;
+  iree_hal_allocator_retain(allocator);
+  iree_hal_allocator_release(state->device_allocator);
+  state->device_allocator = allocator;
+}
+
 //===--------------------------------------------------------------------===//
 // Utilities
 //===--------------------------------------------------------------------===//
@@ -11,6 +11,7 @@
 
 #include "iree/base/api.h"
 #include "iree/hal/api.h"
+#include "iree/hal/utils/executable_registry.h"
 #include "iree/vm/api.h"
 
 IREE_VM_DECLARE_TYPE_ADAPTERS(iree_hal_allocator, iree_hal_allocator_t);
@@ -46,11 +47,41 @@ IREE_API_EXPORT iree_status_t
 iree_hal_module_create(iree_hal_device_t* device, iree_allocator_t allocator,
                        iree_vm_module_t** out_module);
 
+// Creates the HAL module initialized to use a specific |device| and share
+// executables and layouts through |executable_registry|.
+// Any number of modules and contexts may share the same registry (such as one
+// context per tenant) and will receive the same executables when loading the
+// same programs instead of each preparing their own copy. Registered objects
+// no longer used by any context are released when contexts are freed.
+IREE_API_EXPORT iree_status_t iree_hal_module_create_with_executable_registry(
+    iree_hal_device_t* device,
+    iree_hal_executable_registry_t* executable_registry,
+    iree_allocator_t allocator, iree_vm_module_t** out_module);
+
+// Sets additional |caching_mode| bits used when preparing all executables
+// loaded by contexts using |module|. Only contexts created after the call are
+// affected.
+//
+// Programs from trusted sources (such as those whose signature or hash was
+// checked by the hosting application) may use
+// IREE_HAL_EXECUTABLE_CACHING_MODE_DISABLE_VERIFICATION to skip the
+// verification of executable contents on devices that support it.
+IREE_API_EXPORT void iree_hal_module_set_executable_caching_mode(
+    iree_vm_module_t* module, iree_hal_executable_caching_mode_t caching_mode);
+
 // Returns the device currently in use by the HAL module.
 // Returns NULL if no device has been initialized yet.
 IREE_API_EXPORT iree_hal_device_t* iree_hal_module_state_device(
     iree_vm_module_state_t* module_state);
 
+// Sets the |allocator| that programs running in the context owning
+// |module_state| use to allocate buffers on the module device in place of the
+// device allocator. The allocator must be compatible with the device allocator
+// (such as one wrapping it) and is retained by the state. Contexts cloned from
+// the context inherit the allocator. Pass NULL to use the device allocator.
+IREE_API_EXPORT void iree_hal_module_state_set_device_allocator(
+    iree_vm_module_state_t* module_state, iree_hal_allocator_t* allocator);
+
 // TODO(benvanik): generate these list helpers:
 
 IREE_API_EXPORT iree_hal_buffer_view_t* iree_vm_list_get_buffer_view_assign(
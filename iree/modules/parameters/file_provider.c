@@ -0,0 +1,313 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/modules/parameters/file_provider.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "iree/base/internal/file_io.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/tracing.h"
+
+// A file referenced by one or more entries.
+// Mapped lazily on first use and unmapped when the provider is destroyed.
+typedef struct iree_parameters_file_t {
+  struct iree_parameters_file_t* next;
+  // NUL-terminated path stored inline after the struct.
+  iree_string_view_t path;
+  bool is_mapped;
+  iree_const_byte_span_t contents;
+  iree_allocator_t contents_allocator;
+} iree_parameters_file_t;
+
+typedef struct iree_parameters_file_entry_t {
+  struct iree_parameters_file_entry_t* next;
+  // Key stored inline after the struct.
+  iree_string_view_t key;
+  iree_parameters_file_t* file;
+  uint64_t file_offset;
+  uint64_t length;
+} iree_parameters_file_entry_t;
+
+typedef struct iree_parameters_file_provider_t {
+  iree_parameters_provider_t base;
+  iree_allocator_t host_allocator;
+
+  // Guards the file and entry lists and lazy file mapping. Loads only hold the
+  // lock while resolving the entry; mapped contents are stable until destroy.
+  iree_slim_mutex_t mutex;
+
+  // Lookups are linear; parameter counts are expected to be small relative to
+  // the load costs.
+  iree_parameters_file_t* files;
+  iree_parameters_file_entry_t* entries;
+} iree_parameters_file_provider_t;
+
+static const iree_parameters_provider_vtable_t
+    iree_parameters_file_provider_vtable;
+
+static iree_parameters_file_provider_t* iree_parameters_file_provider_cast(
+    iree_parameters_provider_t* base_value) {
+  return (iree_parameters_file_provider_t*)base_value;
+}
+
+IREE_API_EXPORT iree_status_t iree_parameters_file_provider_create(
+    iree_allocator_t host_allocator,
+    iree_parameters_provider_t** out_provider) {
+  IREE_ASSERT_ARGUMENT(out_provider);
+  *out_provider = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_parameters_file_provider_t* provider = NULL;
+  iree_status_t status = iree_allocator_malloc(
+      host_allocator, sizeof(*provider), (void**)&provider);
+  if (iree_status_is_ok(status)) {
+    memset(provider, 0, sizeof(*provider));
+    iree_parameters_provider_initialize(&iree_parameters_file_provider_vtable,
+                                        &provider->base);
+    provider->host_allocator = host_allocator;
+    iree_slim_mutex_initialize(&provider->mutex);
+    *out_provider = &provider->base;
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_parameters_file_provider_destroy(
+    iree_parameters_provider_t* base_provider) {
+  iree_parameters_file_provider_t* provider =
+      iree_parameters_file_provider_cast(base_provider);
+  iree_allocator_t host_allocator = provider->host_allocator;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_parameters_file_entry_t* entry = provider->entries;
+  while (entry) {
+    iree_parameters_file_entry_t* next = entry->next;
+    iree_allocator_free(host_allocator, entry);
+    entry = next;
+  }
+  iree_parameters_file_t* file = provider->files;
+  while (file) {
+    iree_parameters_file_t* next = file->next;
+    if (file->is_mapped) {
+      iree_allocator_free(file->contents_allocator,
+                          (void*)file->contents.data);
+    }
+    iree_allocator_free(host_allocator, file);
+    file = next;
+  }
+
+  iree_slim_mutex_deinitialize(&provider->mutex);
+  iree_allocator_free(host_allocator, provider);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+// Returns the file with the given |path|, registering it if needed.
+// Must be called with the provider lock held.
+static iree_status_t iree_parameters_file_provider_get_file(
+    iree_parameters_file_provider_t* provider, iree_string_view_t path,
+    iree_parameters_file_t** out_file) {
+  for (iree_parameters_file_t* file = provider->files; file;
+       file = file->next) {
+    if (iree_string_view_equal(file->path, path)) {
+      *out_file = file;
+      return iree_ok_status();
+    }
+  }
+  iree_parameters_file_t* file = NULL;
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+      provider->host_allocator, sizeof(*file) + path.size + /*NUL=*/1,
+      (void**)&file));
+  memset(file, 0, sizeof(*file));
+  char* path_storage = (char*)file + sizeof(*file);
+  memcpy(path_storage, path.data, path.size);
+  path_storage[path.size] = 0;
+  file->path = iree_make_string_view(path_storage, path.size);
+  file->next = provider->files;
+  provider->files = file;
+  *out_file = file;
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_status_t iree_parameters_file_provider_add_entry(
+    iree_parameters_provider_t* base_provider, iree_string_view_t key,
+    iree_string_view_t path, uint64_t file_offset, uint64_t length) {
+  IREE_ASSERT_ARGUMENT(base_provider);
+  if (base_provider->vtable != &iree_parameters_file_provider_vtable) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "provider is not a file provider");
+  }
+  iree_parameters_file_provider_t* provider =
+      iree_parameters_file_provider_cast(base_provider);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_TEXT(z0, key.data, key.size);
+
+  iree_slim_mutex_lock(&provider->mutex);
+
+  iree_status_t status = iree_ok_status();
+  for (iree_parameters_file_entry_t* entry = provider->entries; entry;
+       entry = entry->next) {
+    if (iree_string_view_equal(entry->key, key)) {
+      status = iree_make_status(IREE_STATUS_ALREADY_EXISTS,
+                                "parameter '%.*s' already registered",
+                                (int)key.size, key.data);
+      break;
+    }
+  }
+
+  iree_parameters_file_t* file = NULL;
+  if (iree_status_is_ok(status)) {
+    status = iree_parameters_file_provider_get_file(provider, path, &file);
+  }
+
+  iree_parameters_file_entry_t* entry = NULL;
+  if (iree_status_is_ok(status)) {
+    status = iree_allocator_malloc(provider->host_allocator,
+                                   sizeof(*entry) + key.size, (void**)&entry);
+  }
+  if (iree_status_is_ok(status)) {
+    char* key_storage = (char*)entry + sizeof(*entry);
+    memcpy(key_storage, key.data, key.size);
+    entry->key = iree_make_string_view(key_storage, key.size);
+    entry->file = file;
+    entry->file_offset = file_offset;
+    entry->length = length;
+    entry->next = provider->entries;
+    provider->entries = entry;
+  }
+
+  iree_slim_mutex_unlock(&provider->mutex);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Resolves the host memory backing the parameter named |key|, mapping its
+// file if this is the first use.
+static iree_status_t iree_parameters_file_provider_resolve(
+    iree_parameters_file_provider_t* provider, iree_string_view_t key,
+    iree_const_byte_span_t* out_contents) {
+  iree_parameters_file_entry_t* entry = provider->entries;
+  while (entry && !iree_string_view_equal(entry->key, key)) {
+    entry = entry->next;
+  }
+  if (!entry) {
+    return iree_make_status(IREE_STATUS_NOT_FOUND,
+                            "parameter '%.*s' not found", (int)key.size,
+                            key.data);
+  }
+
+  iree_parameters_file_t* file = entry->file;
+  if (!file->is_mapped) {
+    IREE_TRACE_ZONE_BEGIN_NAMED(z0, "iree_parameters_file_map");
+    IREE_TRACE_ZONE_APPEND_TEXT(z0, file->path.data, file->path.size);
+    iree_status_t status =
+        iree_file_map_contents(file->path.data, provider->host_allocator,
+                               &file->contents, &file->contents_allocator);
+    IREE_TRACE_ZONE_END(z0);
+    IREE_RETURN_IF_ERROR(status, "mapping parameter file '%.*s'",
+                         (int)file->path.size, file->path.data);
+    file->is_mapped = true;
+  }
+
+  uint64_t file_length = file->contents.data_length;
+  uint64_t length = entry->length;
+  if (length == IREE_WHOLE_BUFFER && entry->file_offset <= file_length) {
+    length = file_length - entry->file_offset;
+  }
+  if (entry->file_offset > file_length ||
+      length > file_length - entry->file_offset) {
+    return iree_make_status(
+        IREE_STATUS_OUT_OF_RANGE,
+        "parameter '%.*s' range %" PRIu64 "+%" PRIu64
+        " exceeds file '%.*s' length %" PRIu64,
+        (int)key.size, key.data, entry->file_offset, length,
+        (int)file->path.size, file->path.data, file_length);
+  }
+  *out_contents = iree_make_const_byte_span(
+      file->contents.data + entry->file_offset, (iree_host_size_t)length);
+  return iree_ok_status();
+}
+
+// Releases the provider reference held by a buffer wrapping mapped contents.
+static iree_status_t iree_parameters_file_provider_buffer_ctl(
+    void* self, iree_allocator_command_t command, const void* params,
+    void** inout_ptr) {
+  IREE_ASSERT_EQ(command, IREE_ALLOCATOR_COMMAND_FREE);
+  if (IREE_UNLIKELY(command != IREE_ALLOCATOR_COMMAND_FREE)) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION);
+  }
+  iree_parameters_provider_release((iree_parameters_provider_t*)self);
+  return iree_ok_status();
+}
+
+static iree_status_t iree_parameters_file_provider_load(
+    iree_parameters_provider_t* base_provider, iree_string_view_t key,
+    iree_device_size_t offset, iree_device_size_t length,
+    iree_hal_allocator_t* device_allocator, iree_hal_memory_type_t memory_types,
+    iree_hal_buffer_usage_t buffer_usage, iree_hal_buffer_t** out_buffer) {
+  iree_parameters_file_provider_t* provider =
+      iree_parameters_file_provider_cast(base_provider);
+
+  iree_const_byte_span_t contents = iree_const_byte_span_empty();
+  iree_slim_mutex_lock(&provider->mutex);
+  iree_status_t status =
+      iree_parameters_file_provider_resolve(provider, key, &contents);
+  iree_slim_mutex_unlock(&provider->mutex);
+  IREE_RETURN_IF_ERROR(status);
+
+  if (length == IREE_WHOLE_BUFFER && offset <= contents.data_length) {
+    length = contents.data_length - offset;
+  }
+  if (offset > contents.data_length ||
+      length > contents.data_length - offset) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "load range %" PRIu64 "+%" PRIu64
+                            " exceeds parameter '%.*s' length %zu",
+                            (uint64_t)offset, (uint64_t)length, (int)key.size,
+                            key.data, contents.data_length);
+  }
+  iree_byte_span_t data =
+      iree_make_byte_span((uint8_t*)contents.data + offset, length);
+
+  // Try aliasing the mapped file; the buffer keeps the provider (and with it
+  // the mapping) alive for as long as the buffer exists.
+  iree_hal_buffer_compatibility_t compatibility =
+      iree_hal_allocator_query_buffer_compatibility(
+          device_allocator, memory_types, buffer_usage, buffer_usage, length);
+  if (iree_all_bits_set(compatibility,
+                        IREE_HAL_BUFFER_COMPATIBILITY_IMPORTABLE)) {
+    iree_allocator_t data_allocator = {
+        .self = base_provider,
+        .ctl = iree_parameters_file_provider_buffer_ctl,
+    };
+    status = iree_hal_allocator_wrap_buffer(
+        device_allocator, memory_types, IREE_HAL_MEMORY_ACCESS_READ,
+        buffer_usage, data, data_allocator, out_buffer);
+    if (iree_status_is_ok(status)) {
+      iree_parameters_provider_retain(base_provider);
+      return status;
+    }
+    // Fall back to copying; the import may fail for reasons the compatibility
+    // query could not predict (alignment, address space, etc).
+    iree_status_ignore(status);
+  }
+
+  // Copy the parameter into a new buffer. This only touches the mapped pages
+  // being loaded.
+  return iree_hal_allocator_allocate_buffer(
+      device_allocator, memory_types, buffer_usage, length,
+      iree_make_const_byte_span(data.data, data.data_length), out_buffer);
+}
+
+static const iree_parameters_provider_vtable_t
+    iree_parameters_file_provider_vtable = {
+        .destroy = iree_parameters_file_provider_destroy,
+        .load = iree_parameters_file_provider_load,
+};
@@ -0,0 +1,47 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_MODULES_PARAMETERS_FILE_PROVIDER_H_
+#define IREE_MODULES_PARAMETERS_FILE_PROVIDER_H_
+
+#include <stdint.h>
+
+#include "iree/base/api.h"
+#include "iree/modules/parameters/provider.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Creates a parameter provider that serves parameters from ranges of files on
+// disk. Entries are registered with iree_parameters_file_provider_add_entry
+// and any number of entries may reference the same file, allowing a single
+// archive to hold all of the parameters of a model.
+//
+// Files are memory-mapped the first time one of their entries is loaded and
+// remain mapped until the provider is destroyed. When the device allocator
+// can import host memory the loaded buffers alias the mapped pages and no
+// parameter data is read until it is touched; otherwise the requested range is
+// copied into a new device buffer.
+IREE_API_EXPORT iree_status_t iree_parameters_file_provider_create(
+    iree_allocator_t host_allocator, iree_parameters_provider_t** out_provider);
+
+// Registers a parameter named |key| stored in |length| bytes of the file at
+// |path| starting at |file_offset|. |length| may be IREE_WHOLE_BUFFER to
+// indicate the parameter extends to the end of the file. The range is
+// validated when the file is first mapped.
+//
+// Fails if |provider| was not created with
+// iree_parameters_file_provider_create or |key| is already registered.
+IREE_API_EXPORT iree_status_t iree_parameters_file_provider_add_entry(
+    iree_parameters_provider_t* provider, iree_string_view_t key,
+    iree_string_view_t path, uint64_t file_offset, uint64_t length);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_MODULES_PARAMETERS_FILE_PROVIDER_H_
@@ -0,0 +1,136 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/modules/parameters/file_provider.h"
+
+#include <cstdlib>
+#include <string>
+
+#include "iree/base/api.h"
+#include "iree/base/internal/file_io.h"
+#include "iree/base/logging.h"
+#include "iree/base/status_cc.h"
+#include "iree/hal/api.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+#if IREE_FILE_IO_ENABLE
+
+namespace iree {
+namespace {
+
+using ::iree::testing::status::StatusIs;
+
+static const iree_hal_memory_type_t kMemoryTypes =
+    IREE_HAL_MEMORY_TYPE_HOST_LOCAL | IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE;
+static const iree_hal_buffer_usage_t kUsage =
+    IREE_HAL_BUFFER_USAGE_CONSTANT | IREE_HAL_BUFFER_USAGE_TRANSFER |
+    IREE_HAL_BUFFER_USAGE_MAPPING;
+
+std::string GetUniquePath(const char* unique_name) {
+  char* test_tmpdir = getenv("TEST_TMPDIR");
+  if (!test_tmpdir) {
+    test_tmpdir = getenv("TMPDIR");
+  }
+  if (!test_tmpdir) {
+    test_tmpdir = getenv("TEMP");
+  }
+  IREE_CHECK(test_tmpdir) << "TEST_TMPDIR/TMPDIR/TEMP not defined";
+  return test_tmpdir + std::string("/iree_test_") + unique_name;
+}
+
+struct FileProviderTest : public ::testing::Test {
+  iree_allocator_t host_allocator = iree_allocator_system();
+  iree_hal_allocator_t* device_allocator = NULL;
+  iree_parameters_provider_t* provider = NULL;
+  std::string archive_path;
+
+  void SetUp() override {
+    IREE_ASSERT_OK(iree_hal_allocator_create_heap(
+        iree_make_cstring_view("heap"), host_allocator, host_allocator,
+        &device_allocator));
+    IREE_ASSERT_OK(
+        iree_parameters_file_provider_create(host_allocator, &provider));
+
+    // Two parameters packed back to back in one archive.
+    archive_path = GetUniquePath("FileProviderArchive");
+    std::string contents = "0123456789abcdef";
+    IREE_ASSERT_OK(iree_file_write_contents(
+        archive_path.c_str(),
+        iree_make_const_byte_span(contents.data(), contents.size())));
+    iree_string_view_t path = iree_make_string_view(archive_path.data(),
+                                                    archive_path.size());
+    IREE_ASSERT_OK(iree_parameters_file_provider_add_entry(
+        provider, iree_make_cstring_view("digits"), path, 0, 10));
+    IREE_ASSERT_OK(iree_parameters_file_provider_add_entry(
+        provider, iree_make_cstring_view("letters"), path, 10,
+        IREE_WHOLE_BUFFER));
+  }
+
+  void TearDown() override {
+    iree_parameters_provider_release(provider);
+    iree_hal_allocator_release(device_allocator);
+  }
+
+  std::string Load(const char* key, iree_device_size_t offset,
+                   iree_device_size_t length) {
+    iree_hal_buffer_t* buffer = NULL;
+    IREE_CHECK_OK(iree_parameters_provider_load(
+        provider, iree_make_cstring_view(key), offset, length,
+        device_allocator, kMemoryTypes, kUsage, &buffer));
+    std::string result(iree_hal_buffer_byte_length(buffer), '\0');
+    IREE_CHECK_OK(iree_hal_buffer_read_data(buffer, 0, &result[0],
+                                            result.size()));
+    iree_hal_buffer_release(buffer);
+    return result;
+  }
+};
+
+TEST_F(FileProviderTest, LoadWholeParameters) {
+  EXPECT_EQ("0123456789", Load("digits", 0, IREE_WHOLE_BUFFER));
+  EXPECT_EQ("abcdef", Load("letters", 0, IREE_WHOLE_BUFFER));
+}
+
+TEST_F(FileProviderTest, LoadSubranges) {
+  EXPECT_EQ("345", Load("digits", 3, 3));
+  EXPECT_EQ("ef", Load("letters", 4, IREE_WHOLE_BUFFER));
+}
+
+// Tests that loaded buffers keep the provider mappings alive.
+TEST_F(FileProviderTest, BufferOutlivesProvider) {
+  iree_hal_buffer_t* buffer = NULL;
+  IREE_ASSERT_OK(iree_parameters_provider_load(
+      provider, iree_make_cstring_view("letters"), 0, IREE_WHOLE_BUFFER,
+      device_allocator, kMemoryTypes, kUsage, &buffer));
+  iree_parameters_provider_release(provider);
+  provider = NULL;
+  char data[6];
+  IREE_ASSERT_OK(iree_hal_buffer_read_data(buffer, 0, data, sizeof(data)));
+  EXPECT_EQ("abcdef", std::string(data, sizeof(data)));
+  iree_hal_buffer_release(buffer);
+}
+
+TEST_F(FileProviderTest, Errors) {
+  iree_hal_buffer_t* buffer = NULL;
+  EXPECT_THAT(Status(iree_parameters_provider_load(
+                  provider, iree_make_cstring_view("missing"), 0,
+                  IREE_WHOLE_BUFFER, device_allocator, kMemoryTypes, kUsage,
+                  &buffer)),
+              StatusIs(StatusCode::kNotFound));
+  EXPECT_THAT(Status(iree_parameters_provider_load(
+                  provider, iree_make_cstring_view("digits"), 8, 4,
+                  device_allocator, kMemoryTypes, kUsage, &buffer)),
+              StatusIs(StatusCode::kOutOfRange));
+  EXPECT_THAT(Status(iree_parameters_file_provider_add_entry(
+                  provider, iree_make_cstring_view("digits"),
+                  iree_make_cstring_view("other"), 0, 1)),
+              StatusIs(StatusCode::kAlreadyExists));
+}
+
+}  // namespace
+}  // namespace iree
+
+#endif  // IREE_FILE_IO_ENABLE
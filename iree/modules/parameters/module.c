@@ -0,0 +1,187 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/modules/parameters/module.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "iree/base/api.h"
+#include "iree/base/tracing.h"
+#include "iree/hal/api.h"
+#include "iree/modules/hal/module.h"
+#include "iree/vm/api.h"
+
+//===----------------------------------------------------------------------===//
+// Module type definitions
+//===----------------------------------------------------------------------===//
+
+typedef struct iree_parameters_module_t {
+  iree_allocator_t host_allocator;
+  iree_parameters_provider_t* provider;
+} iree_parameters_module_t;
+
+#define IREE_PARAMETERS_MODULE_CAST(module)        \
+  (iree_parameters_module_t*)((uint8_t*)(module) + \
+                              iree_vm_native_module_size());
+
+typedef struct iree_parameters_module_state_t {
+  iree_allocator_t host_allocator;
+  // Unowned reference to the module provider.
+  iree_parameters_provider_t* provider;
+} iree_parameters_module_state_t;
+
+static void IREE_API_PTR iree_parameters_module_destroy(void* base_module) {
+  iree_parameters_module_t* module = IREE_PARAMETERS_MODULE_CAST(base_module);
+  iree_parameters_provider_release(module->provider);
+}
+
+static iree_status_t IREE_API_PTR
+iree_parameters_module_alloc_state(void* self, iree_allocator_t host_allocator,
+                                   iree_vm_module_state_t** out_module_state) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_parameters_module_t* module = IREE_PARAMETERS_MODULE_CAST(self);
+  iree_parameters_module_state_t* state = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0,
+      iree_allocator_malloc(host_allocator, sizeof(*state), (void**)&state));
+  memset(state, 0, sizeof(*state));
+  state->host_allocator = host_allocator;
+  state->provider = module->provider;
+
+  *out_module_state = (iree_vm_module_state_t*)state;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+static void IREE_API_PTR iree_parameters_module_free_state(
+    void* self, iree_vm_module_state_t* module_state) {
+  iree_parameters_module_state_t* state =
+      (iree_parameters_module_state_t*)module_state;
+  iree_allocator_free(state->host_allocator, state);
+}
+
+//===----------------------------------------------------------------------===//
+// Exported functions
+//===----------------------------------------------------------------------===//
+
+IREE_VM_ABI_EXPORT(iree_parameters_module_load,     //
+                   iree_parameters_module_state_t,  //
+                   riirii, r) {
+  iree_hal_allocator_t* allocator = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_allocator_check_deref(args->r0, &allocator));
+  iree_hal_memory_type_t memory_types = (iree_hal_memory_type_t)args->i1;
+  iree_hal_buffer_usage_t buffer_usage = (iree_hal_buffer_usage_t)args->i2;
+  iree_vm_buffer_t* key = NULL;
+  IREE_RETURN_IF_ERROR(iree_vm_buffer_check_deref(args->r3, &key));
+  iree_string_view_t key_str = iree_vm_buffer_as_string(key);
+  iree_vm_size_t offset = (iree_vm_size_t)args->i4;
+  iree_vm_size_t length = (iree_vm_size_t)args->i5;
+  if (offset < 0 || length < -1) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "invalid parameter range %d+%d", offset, length);
+  }
+
+  iree_hal_buffer_t* buffer = NULL;
+  IREE_RETURN_IF_ERROR(iree_parameters_provider_load(
+      state->provider, key_str, (iree_device_size_t)offset,
+      length == -1 ? IREE_WHOLE_BUFFER : (iree_device_size_t)length, allocator,
+      memory_types, buffer_usage, &buffer));
+  rets->r0 = iree_hal_buffer_move_ref(buffer);
+  return iree_ok_status();
+}
+
+//===----------------------------------------------------------------------===//
+// VM module interface implementation
+//===----------------------------------------------------------------------===//
+
+// NOTE: this must match the ordering of the iree_parameters_module_exports_
+// table.
+static const iree_vm_native_function_ptr_t iree_parameters_module_funcs_[] = {
+#define EXPORT_FN(name, target_fn, arg_types, ret_types)       \
+  {                                                            \
+      .shim = (iree_vm_native_function_shim_t)                 \
+          iree_vm_shim_##arg_types##_##ret_types,              \
+      .target = (iree_vm_native_function_target_t)(target_fn), \
+  },
+#include "iree/modules/parameters/exports.inl"  // IWYU pragma: keep
+#undef EXPORT_FN
+};
+
+// NOTE: 0 length, but can't express that in C.
+static const iree_vm_native_import_descriptor_t
+    iree_parameters_module_imports_[1];
+
+static const iree_vm_native_export_descriptor_t
+    iree_parameters_module_exports_[] = {
+#define EXPORT_FN(name, target_fn, arg_types, ret_types)           \
+  {                                                                \
+      .local_name = iree_string_view_literal(name),                \
+      .calling_convention =                                        \
+          iree_string_view_literal("0" #arg_types "_" #ret_types), \
+      .reflection_attr_count = 0,                                  \
+      .reflection_attrs = NULL,                                    \
+  },
+#include "iree/modules/parameters/exports.inl"  // IWYU pragma: keep
+#undef EXPORT_FN
+};
+static_assert(IREE_ARRAYSIZE(iree_parameters_module_funcs_) ==
+                  IREE_ARRAYSIZE(iree_parameters_module_exports_),
+              "function pointer table must be 1:1 with exports");
+
+static const iree_vm_native_module_descriptor_t
+    iree_parameters_module_descriptor_ = {
+        .module_name = iree_string_view_literal("parameters"),
+        .import_count = 0,  // workaround for 0-length C struct
+        .imports = iree_parameters_module_imports_,
+        .export_count = IREE_ARRAYSIZE(iree_parameters_module_exports_),
+        .exports = iree_parameters_module_exports_,
+        .function_count = IREE_ARRAYSIZE(iree_parameters_module_funcs_),
+        .functions = iree_parameters_module_funcs_,
+        .reflection_attr_count = 0,
+        .reflection_attrs = NULL,
+};
+
+IREE_API_EXPORT iree_status_t iree_parameters_module_create(
+    iree_parameters_provider_t* provider, iree_allocator_t allocator,
+    iree_vm_module_t** out_module) {
+  IREE_ASSERT_ARGUMENT(provider);
+  IREE_ASSERT_ARGUMENT(out_module);
+  *out_module = NULL;
+
+  // Setup the interface with the functions we implement ourselves. Any function
+  // we omit will be handled by the base native module.
+  static const iree_vm_module_t interface = {
+      .destroy = iree_parameters_module_destroy,
+      .alloc_state = iree_parameters_module_alloc_state,
+      .free_state = iree_parameters_module_free_state,
+  };
+
+  // Allocate shared module state.
+  iree_host_size_t total_size =
+      iree_vm_native_module_size() + sizeof(iree_parameters_module_t);
+  iree_vm_module_t* base_module = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_allocator_malloc(allocator, total_size, (void**)&base_module));
+  memset(base_module, 0, total_size);
+  iree_status_t status = iree_vm_native_module_initialize(
+      &interface, &iree_parameters_module_descriptor_, allocator, base_module);
+  if (!iree_status_is_ok(status)) {
+    iree_allocator_free(allocator, base_module);
+    return status;
+  }
+
+  iree_parameters_module_t* module = IREE_PARAMETERS_MODULE_CAST(base_module);
+  module->host_allocator = allocator;
+  module->provider = provider;
+  iree_parameters_provider_retain(module->provider);
+
+  *out_module = base_module;
+  return iree_ok_status();
+}
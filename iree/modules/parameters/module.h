@@ -0,0 +1,43 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_MODULES_PARAMETERS_MODULE_H_
+#define IREE_MODULES_PARAMETERS_MODULE_H_
+
+#include <stdint.h>
+
+#include "iree/base/api.h"
+#include "iree/modules/parameters/provider.h"
+#include "iree/vm/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Creates the parameters module serving parameters from |provider|, which is
+// retained for the lifetime of the module. Each context using this module
+// shares the provider.
+//
+// The module exports:
+//   parameters.load(%allocator : !hal.allocator,
+//                   %memory_types : i32, %buffer_usage : i32,
+//                   %key : !util.buffer, %offset : i32, %length : i32)
+//       -> !hal.buffer
+// which loads a (sub)range of the parameter named %key into a buffer
+// compatible with %allocator. A %length of -1 loads through the end of the
+// parameter. Programs are expected to call it from their initializers so that
+// parameter I/O happens once at context creation.
+//
+// The HAL types must be registered with iree_hal_module_register_types.
+IREE_API_EXPORT iree_status_t iree_parameters_module_create(
+    iree_parameters_provider_t* provider, iree_allocator_t allocator,
+    iree_vm_module_t** out_module);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_MODULES_PARAMETERS_MODULE_H_
@@ -0,0 +1,49 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/modules/parameters/provider.h"
+
+#include "iree/base/tracing.h"
+
+IREE_API_EXPORT void iree_parameters_provider_initialize(
+    const iree_parameters_provider_vtable_t* vtable,
+    iree_parameters_provider_t* out_provider) {
+  iree_atomic_ref_count_init(&out_provider->ref_count);
+  out_provider->vtable = vtable;
+}
+
+IREE_API_EXPORT void iree_parameters_provider_retain(
+    iree_parameters_provider_t* provider) {
+  if (IREE_LIKELY(provider)) {
+    iree_atomic_ref_count_inc(&provider->ref_count);
+  }
+}
+
+IREE_API_EXPORT void iree_parameters_provider_release(
+    iree_parameters_provider_t* provider) {
+  if (IREE_LIKELY(provider) &&
+      iree_atomic_ref_count_dec(&provider->ref_count) == 1) {
+    provider->vtable->destroy(provider);
+  }
+}
+
+IREE_API_EXPORT iree_status_t iree_parameters_provider_load(
+    iree_parameters_provider_t* provider, iree_string_view_t key,
+    iree_device_size_t offset, iree_device_size_t length,
+    iree_hal_allocator_t* device_allocator, iree_hal_memory_type_t memory_types,
+    iree_hal_buffer_usage_t buffer_usage, iree_hal_buffer_t** out_buffer) {
+  IREE_ASSERT_ARGUMENT(provider);
+  IREE_ASSERT_ARGUMENT(device_allocator);
+  IREE_ASSERT_ARGUMENT(out_buffer);
+  *out_buffer = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_TEXT(z0, key.data, key.size);
+  iree_status_t status =
+      provider->vtable->load(provider, key, offset, length, device_allocator,
+                             memory_types, buffer_usage, out_buffer);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
@@ -0,0 +1,82 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_MODULES_PARAMETERS_PROVIDER_H_
+#define IREE_MODULES_PARAMETERS_PROVIDER_H_
+
+#include <stdint.h>
+
+#include "iree/base/api.h"
+#include "iree/base/internal/atomics.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+//===----------------------------------------------------------------------===//
+// iree_parameters_provider_t
+//===----------------------------------------------------------------------===//
+
+typedef struct iree_parameters_provider_t iree_parameters_provider_t;
+
+typedef struct iree_parameters_provider_vtable_t {
+  void(IREE_API_PTR* destroy)(iree_parameters_provider_t* provider);
+
+  iree_status_t(IREE_API_PTR* load)(iree_parameters_provider_t* provider,
+                                    iree_string_view_t key,
+                                    iree_device_size_t offset,
+                                    iree_device_size_t length,
+                                    iree_hal_allocator_t* device_allocator,
+                                    iree_hal_memory_type_t memory_types,
+                                    iree_hal_buffer_usage_t buffer_usage,
+                                    iree_hal_buffer_t** out_buffer);
+} iree_parameters_provider_vtable_t;
+
+// A source of named parameters (weights, embeddings, etc) stored outside of
+// the module that uses them. Programs reference parameters by key and the
+// provider decides where the bytes come from, allowing parameters to be
+// updated or shared across modules without recompiling.
+//
+// Providers are thread-safe and may be used from multiple contexts at once.
+struct iree_parameters_provider_t {
+  iree_atomic_ref_count_t ref_count;
+  const iree_parameters_provider_vtable_t* vtable;
+};
+
+// Initializes the base provider fields. For use by implementations only.
+IREE_API_EXPORT void iree_parameters_provider_initialize(
+    const iree_parameters_provider_vtable_t* vtable,
+    iree_parameters_provider_t* out_provider);
+
+// Retains the given |provider| for the caller.
+IREE_API_EXPORT void iree_parameters_provider_retain(
+    iree_parameters_provider_t* provider);
+
+// Releases the given |provider| from the caller.
+IREE_API_EXPORT void iree_parameters_provider_release(
+    iree_parameters_provider_t* provider);
+
+// Loads |length| bytes starting at |offset| of the parameter named |key| into
+// a buffer compatible with |device_allocator|. |length| may be
+// IREE_WHOLE_BUFFER to load through the end of the parameter.
+//
+// Providers are expected to avoid copies where possible: when the parameter
+// storage is host memory and the allocator can import it with the requested
+// memory type and usage the returned buffer will alias the storage directly.
+// Because of this the returned buffer only allows IREE_HAL_MEMORY_ACCESS_READ
+// and programs that need to mutate a parameter must copy it first.
+IREE_API_EXPORT iree_status_t iree_parameters_provider_load(
+    iree_parameters_provider_t* provider, iree_string_view_t key,
+    iree_device_size_t offset, iree_device_size_t length,
+    iree_hal_allocator_t* device_allocator, iree_hal_memory_type_t memory_types,
+    iree_hal_buffer_usage_t buffer_usage, iree_hal_buffer_t** out_buffer);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_MODULES_PARAMETERS_PROVIDER_H_
@@ -23,6 +23,12 @@
 
 // clang-format off
 
-EXPORT_FN("_placeholder", iree_vmvx_module_placeholder, v, v)
+EXPORT_FN("add.2d.f32", iree_vmvx_module_add_2d_f32, riiriiriiii, v)
+EXPORT_FN("copy.2d.x32", iree_vmvx_module_copy_2d_x32, riiriiii, v)
+EXPORT_FN("fill.2d.x32", iree_vmvx_module_fill_2d_x32, iriiii, v)
+EXPORT_FN("fma.2d.f32", iree_vmvx_module_fma_2d_f32, riiriiriiriiii, v)
+EXPORT_FN("matmul.f32f32f32", iree_vmvx_module_matmul_f32f32f32, riiriiriiiii, v)
+EXPORT_FN("mul.2d.f32", iree_vmvx_module_mul_2d_f32, riiriiriiii, v)
+EXPORT_FN("sub.2d.f32", iree_vmvx_module_sub_2d_f32, riiriiriiii, v)
 
 // clang-format on
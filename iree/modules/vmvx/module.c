@@ -91,13 +91,240 @@ iree_vmvx_module_free_state(void* self, iree_vm_module_state_t* module_state) {
 }
 
 //===----------------------------------------------------------------------===//
-// TODO
+// Buffer access
 //===----------------------------------------------------------------------===//
 
-// Placeholder to make the function pointer arrays happy (they can't be empty).
-IREE_VM_ABI_EXPORT(iree_vmvx_module_placeholder,  //
+// Verifies and returns a pointer to a 2D strided range of |buffer_ref|.
+//
+// All offsets, strides, and sizes are in elements of |element_size| bytes. The
+// range covers |size0| rows of |size1| contiguous elements with each row
+// starting |stride| elements after the previous one. Ranges with no elements
+// return NULL and are always valid.
+static iree_status_t iree_vmvx_map_2d(iree_vm_ref_t buffer_ref, bool writable,
+                                      iree_host_size_t element_size,
+                                      int32_t offset, int32_t stride,
+                                      int32_t size0, int32_t size1,
+                                      void** out_data) {
+  *out_data = NULL;
+  iree_vm_buffer_t* buffer = NULL;
+  IREE_RETURN_IF_ERROR(iree_vm_buffer_check_deref(buffer_ref, &buffer));
+  if (writable &&
+      !iree_all_bits_set(buffer->access, IREE_VM_BUFFER_ACCESS_MUTABLE)) {
+    return iree_make_status(IREE_STATUS_PERMISSION_DENIED,
+                            "buffer is read-only and cannot be written");
+  }
+  if (offset < 0 || stride < 0 || size0 < 0 || size1 < 0) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "negative offset/stride/size in buffer range");
+  }
+  if (size0 == 0 || size1 == 0) return iree_ok_status();
+
+  // One past the last element touched by the range, computed in 64-bits as the
+  // operands are only bounded by int32_t.
+  uint64_t end = (uint64_t)offset + (uint64_t)(size0 - 1) * (uint64_t)stride +
+                 (uint64_t)size1;
+  iree_host_size_t buffer_length = buffer->data.data_length;
+  if (end > buffer_length / element_size) {
+    return iree_make_status(
+        IREE_STATUS_OUT_OF_RANGE,
+        "buffer range [%d, %" PRIu64 ") of %" PRIhsz
+        "-byte elements out of bounds of a buffer with length %" PRIhsz,
+        offset, end, element_size, buffer_length);
+  }
+  *out_data = buffer->data.data + (iree_host_size_t)offset * element_size;
+  return iree_ok_status();
+}
+
+//===----------------------------------------------------------------------===//
+// Data movement
+//===----------------------------------------------------------------------===//
+
+IREE_VM_ABI_EXPORT(iree_vmvx_module_copy_2d_x32,  //
                    iree_vmvx_module_state_t,      //
-                   v, v) {
+                   riiriiii, v) {
+  int32_t size0 = args->i6;
+  int32_t size1 = args->i7;
+  const uint32_t* src = NULL;
+  IREE_RETURN_IF_ERROR(iree_vmvx_map_2d(args->r0, /*writable=*/false,
+                                        sizeof(*src), args->i1, args->i2,
+                                        size0, size1, (void**)&src));
+  uint32_t* dst = NULL;
+  IREE_RETURN_IF_ERROR(iree_vmvx_map_2d(args->r3, /*writable=*/true,
+                                        sizeof(*dst), args->i4, args->i5,
+                                        size0, size1, (void**)&dst));
+  if (!src || !dst) return iree_ok_status();
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_host_size_t row_length = (iree_host_size_t)size1 * sizeof(*dst);
+  for (int32_t i = 0; i < size0; ++i) {
+    memmove(dst + (iree_host_size_t)i * args->i5,
+            src + (iree_host_size_t)i * args->i2, row_length);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+IREE_VM_ABI_EXPORT(iree_vmvx_module_fill_2d_x32,  //
+                   iree_vmvx_module_state_t,      //
+                   iriiii, v) {
+  uint32_t value = (uint32_t)args->i0;
+  int32_t size0 = args->i4;
+  int32_t size1 = args->i5;
+  uint32_t* out = NULL;
+  IREE_RETURN_IF_ERROR(iree_vmvx_map_2d(args->r1, /*writable=*/true,
+                                        sizeof(*out), args->i2, args->i3,
+                                        size0, size1, (void**)&out));
+  if (!out) return iree_ok_status();
+  IREE_TRACE_ZONE_BEGIN(z0);
+  for (int32_t i = 0; i < size0; ++i) {
+    uint32_t* IREE_RESTRICT out_row = out + (iree_host_size_t)i * args->i3;
+    for (int32_t j = 0; j < size1; ++j) out_row[j] = value;
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+//===----------------------------------------------------------------------===//
+// Elementwise arithmetic
+//===----------------------------------------------------------------------===//
+
+// Defines a 2D elementwise binary op export computing `out = lhs <op> rhs`.
+// The inner loop is over contiguous elements so that the compiler is able to
+// vectorize it for whatever SIMD the runtime is built for.
+#define IREE_VMVX_DEFINE_BINARY_2D_F32(name, op)                              \
+  IREE_VM_ABI_EXPORT(iree_vmvx_module_##name##_2d_f32,                        \
+                     iree_vmvx_module_state_t, riiriiriiii, v) {              \
+    int32_t size0 = args->i9;                                                 \
+    int32_t size1 = args->i10;                                                \
+    const float* lhs = NULL;                                                  \
+    IREE_RETURN_IF_ERROR(iree_vmvx_map_2d(args->r0, /*writable=*/false,       \
+                                          sizeof(*lhs), args->i1, args->i2,   \
+                                          size0, size1, (void**)&lhs));       \
+    const float* rhs = NULL;                                                  \
+    IREE_RETURN_IF_ERROR(iree_vmvx_map_2d(args->r3, /*writable=*/false,       \
+                                          sizeof(*rhs), args->i4, args->i5,   \
+                                          size0, size1, (void**)&rhs));       \
+    float* out = NULL;                                                        \
+    IREE_RETURN_IF_ERROR(iree_vmvx_map_2d(args->r6, /*writable=*/true,        \
+                                          sizeof(*out), args->i7, args->i8,   \
+                                          size0, size1, (void**)&out));       \
+    if (!lhs || !rhs || !out) return iree_ok_status();                        \
+    IREE_TRACE_ZONE_BEGIN(z0);                                                \
+    for (int32_t i = 0; i < size0; ++i) {                                     \
+      const float* lhs_row = lhs + (iree_host_size_t)i * args->i2;            \
+      const float* rhs_row = rhs + (iree_host_size_t)i * args->i5;            \
+      float* out_row = out + (iree_host_size_t)i * args->i8;                  \
+      for (int32_t j = 0; j < size1; ++j) {                                   \
+        out_row[j] = lhs_row[j] op rhs_row[j];                                \
+      }                                                                       \
+    }                                                                         \
+    IREE_TRACE_ZONE_END(z0);                                                  \
+    return iree_ok_status();                                                  \
+  }
+
+IREE_VMVX_DEFINE_BINARY_2D_F32(add, +)
+IREE_VMVX_DEFINE_BINARY_2D_F32(mul, *)
+IREE_VMVX_DEFINE_BINARY_2D_F32(sub, -)
+
+// Computes `out = a * b + c`. |c| and |out| commonly alias (accumulation into
+// the output) and each output element is only written after its inputs have
+// been read.
+IREE_VM_ABI_EXPORT(iree_vmvx_module_fma_2d_f32,  //
+                   iree_vmvx_module_state_t,     //
+                   riiriiriiriiii, v) {
+  int32_t size0 = args->i12;
+  int32_t size1 = args->i13;
+  const float* a = NULL;
+  IREE_RETURN_IF_ERROR(iree_vmvx_map_2d(args->r0, /*writable=*/false,
+                                        sizeof(*a), args->i1, args->i2, size0,
+                                        size1, (void**)&a));
+  const float* b = NULL;
+  IREE_RETURN_IF_ERROR(iree_vmvx_map_2d(args->r3, /*writable=*/false,
+                                        sizeof(*b), args->i4, args->i5, size0,
+                                        size1, (void**)&b));
+  const float* c = NULL;
+  IREE_RETURN_IF_ERROR(iree_vmvx_map_2d(args->r6, /*writable=*/false,
+                                        sizeof(*c), args->i7, args->i8, size0,
+                                        size1, (void**)&c));
+  float* out = NULL;
+  IREE_RETURN_IF_ERROR(iree_vmvx_map_2d(args->r9, /*writable=*/true,
+                                        sizeof(*out), args->i10, args->i11,
+                                        size0, size1, (void**)&out));
+  if (!a || !b || !c || !out) return iree_ok_status();
+  IREE_TRACE_ZONE_BEGIN(z0);
+  for (int32_t i = 0; i < size0; ++i) {
+    const float* a_row = a + (iree_host_size_t)i * args->i2;
+    const float* b_row = b + (iree_host_size_t)i * args->i5;
+    const float* c_row = c + (iree_host_size_t)i * args->i8;
+    float* out_row = out + (iree_host_size_t)i * args->i11;
+    for (int32_t j = 0; j < size1; ++j) {
+      out_row[j] = a_row[j] * b_row[j] + c_row[j];
+    }
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+//===----------------------------------------------------------------------===//
+// Matrix multiplication
+//===----------------------------------------------------------------------===//
+
+// Tile sizes of the matmul kernel chosen such that a tile of the RHS and the
+// rows of the output it updates stay resident in L1 across the M loop.
+#define IREE_VMVX_MATMUL_TILE_N 256
+#define IREE_VMVX_MATMUL_TILE_K 32
+
+// Accumulates `out[m][n] += lhs[m][k] * rhs[k][n]` over one tile of N and K.
+// The innermost loop runs over contiguous output and RHS elements and
+// vectorizes without any cross-lane reduction.
+static void iree_vmvx_matmul_tile_f32(
+    const float* IREE_RESTRICT lhs, int32_t lhs_stride,
+    const float* IREE_RESTRICT rhs, int32_t rhs_stride,
+    float* IREE_RESTRICT out, int32_t out_stride, int32_t m, int32_t n,
+    int32_t k) {
+  for (int32_t i = 0; i < m; ++i) {
+    const float* lhs_row = lhs + (iree_host_size_t)i * lhs_stride;
+    float* IREE_RESTRICT out_row = out + (iree_host_size_t)i * out_stride;
+    for (int32_t kk = 0; kk < k; ++kk) {
+      const float lhs_value = lhs_row[kk];
+      const float* IREE_RESTRICT rhs_row =
+          rhs + (iree_host_size_t)kk * rhs_stride;
+      for (int32_t j = 0; j < n; ++j) {
+        out_row[j] += lhs_value * rhs_row[j];
+      }
+    }
+  }
+}
+
+IREE_VM_ABI_EXPORT(iree_vmvx_module_matmul_f32f32f32,  //
+                   iree_vmvx_module_state_t,           //
+                   riiriiriiiii, v) {
+  int32_t m = args->i9;
+  int32_t n = args->i10;
+  int32_t k = args->i11;
+  const float* lhs = NULL;
+  IREE_RETURN_IF_ERROR(iree_vmvx_map_2d(args->r0, /*writable=*/false,
+                                        sizeof(*lhs), args->i1, args->i2, m,
+                                        k, (void**)&lhs));
+  const float* rhs = NULL;
+  IREE_RETURN_IF_ERROR(iree_vmvx_map_2d(args->r3, /*writable=*/false,
+                                        sizeof(*rhs), args->i4, args->i5, k,
+                                        n, (void**)&rhs));
+  float* out = NULL;
+  IREE_RETURN_IF_ERROR(iree_vmvx_map_2d(args->r6, /*writable=*/true,
+                                        sizeof(*out), args->i7, args->i8, m, n,
+                                        (void**)&out));
+  if (!lhs || !rhs || !out) return iree_ok_status();
+  IREE_TRACE_ZONE_BEGIN(z0);
+  for (int32_t j0 = 0; j0 < n; j0 += IREE_VMVX_MATMUL_TILE_N) {
+    int32_t tile_n = iree_min(IREE_VMVX_MATMUL_TILE_N, n - j0);
+    for (int32_t k0 = 0; k0 < k; k0 += IREE_VMVX_MATMUL_TILE_K) {
+      int32_t tile_k = iree_min(IREE_VMVX_MATMUL_TILE_K, k - k0);
+      iree_vmvx_matmul_tile_f32(
+          lhs + k0, args->i2, rhs + (iree_host_size_t)k0 * args->i5 + j0,
+          args->i5, out + j0, args->i8, m, tile_n, tile_k);
+    }
+  }
+  IREE_TRACE_ZONE_END(z0);
   return iree_ok_status();
 }
 
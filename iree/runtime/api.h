@@ -13,8 +13,10 @@
 #include "iree/vm/api.h"    // IWYU pragma: export
 
 // Runtime API:
+#include "iree/runtime/batcher.h"   // IWYU pragma: export
 #include "iree/runtime/call.h"      // IWYU pragma: export
 #include "iree/runtime/instance.h"  // IWYU pragma: export
+#include "iree/runtime/pipeline.h"  // IWYU pragma: export
 #include "iree/runtime/session.h"   // IWYU pragma: export
 
 #endif  // IREE_RUNTIME_API_H_
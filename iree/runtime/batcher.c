@@ -0,0 +1,563 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/runtime/batcher.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/tracing.h"
+#include "iree/modules/hal/module.h"
+#include "iree/runtime/call.h"
+#include "iree/runtime/session.h"
+
+// Maximum rank of batched buffer views including the batch dimension.
+#define IREE_RUNTIME_BATCHER_MAX_RANK 16
+
+//===----------------------------------------------------------------------===//
+// iree_runtime_batcher_options_t
+//===----------------------------------------------------------------------===//
+
+IREE_API_EXPORT void iree_runtime_batcher_options_initialize(
+    iree_runtime_batcher_options_t* out_options) {
+  memset(out_options, 0, sizeof(*out_options));
+  out_options->max_batch_size = IREE_RUNTIME_BATCHER_DEFAULT_MAX_BATCH_SIZE;
+  out_options->max_delay_ns = IREE_RUNTIME_BATCHER_DEFAULT_MAX_DELAY_NS;
+}
+
+//===----------------------------------------------------------------------===//
+// iree_runtime_batcher_t
+//===----------------------------------------------------------------------===//
+
+typedef enum iree_runtime_batcher_request_state_e {
+  // Request is queued waiting to be taken by a batch.
+  IREE_RUNTIME_BATCHER_REQUEST_STATE_PENDING = 0,
+  // Request is at the head of the queue and its caller is responsible for
+  // forming and executing the next batch.
+  IREE_RUNTIME_BATCHER_REQUEST_STATE_LEADING = 1,
+  // Request was executed as part of a batch and its status is available.
+  IREE_RUNTIME_BATCHER_REQUEST_STATE_COMPLETED = 2,
+} iree_runtime_batcher_request_state_t;
+
+// A single-example call waiting on a batch.
+// Requests live on the stack of the thread calling iree_runtime_batcher_call
+// and must not be accessed by other threads once marked completed.
+typedef struct iree_runtime_batcher_request_t {
+  struct iree_runtime_batcher_request_t* next;
+  iree_vm_list_t* inputs;
+  iree_vm_list_t* outputs;
+  // Time by which a batch led by this request must be dispatched.
+  iree_time_t deadline_ns;
+  // Result of the batch containing the request; set prior to completion.
+  iree_status_t status;
+  // iree_runtime_batcher_request_state_t.
+  iree_atomic_int32_t state;
+} iree_runtime_batcher_request_t;
+
+typedef struct iree_runtime_batcher_variant_state_t {
+  // Static batch size of the function or 0 if dynamic.
+  iree_host_size_t batch_size;
+  // Reusable call state; only used by the current batch leader.
+  iree_runtime_call_t call;
+} iree_runtime_batcher_variant_state_t;
+
+struct iree_runtime_batcher_t {
+  iree_atomic_ref_count_t ref_count;
+  iree_allocator_t host_allocator;
+  iree_runtime_session_t* session;
+  iree_host_size_t max_batch_size;
+  iree_duration_t max_delay_ns;
+
+  // Guards the pending request queue and leadership.
+  iree_slim_mutex_t mutex;
+  // Posted whenever requests are enqueued, promoted to leader, or completed.
+  iree_notification_t notification;
+
+  // FIFO of requests not yet taken by a batch.
+  iree_runtime_batcher_request_t* pending_head;
+  iree_runtime_batcher_request_t* pending_tail;
+  // Number of requests in the pending queue. Updated under the mutex but
+  // atomic so that leaders can wait for the batch to fill without the lock.
+  iree_atomic_int32_t pending_count;
+  // True if a request has been made the leader and will form the next batch.
+  bool has_leader;
+
+  // Transfer commands used to gather a single batched input. Only used by the
+  // current batch leader. Sized to the maximum padded batch size.
+  iree_host_size_t transfer_command_capacity;
+  iree_hal_transfer_command_t* transfer_commands;
+
+  iree_host_size_t variant_count;
+  iree_runtime_batcher_variant_state_t variants[];
+};
+
+static void iree_runtime_batcher_destroy(iree_runtime_batcher_t* batcher);
+
+IREE_API_EXPORT iree_status_t iree_runtime_batcher_create(
+    iree_runtime_session_t* session,
+    const iree_runtime_batcher_options_t* options,
+    iree_host_size_t variant_count,
+    const iree_runtime_batcher_variant_t* variants,
+    iree_allocator_t host_allocator, iree_runtime_batcher_t** out_batcher) {
+  IREE_ASSERT_ARGUMENT(session);
+  IREE_ASSERT_ARGUMENT(options);
+  IREE_ASSERT_ARGUMENT(!variant_count || variants);
+  IREE_ASSERT_ARGUMENT(out_batcher);
+  *out_batcher = NULL;
+
+  if (variant_count == 0) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "at least one function variant is required");
+  }
+  if (options->max_batch_size == 0 || options->max_batch_size > INT32_MAX) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "max_batch_size must be in (0, INT32_MAX]");
+  }
+  bool has_dynamic_variant = false;
+  iree_host_size_t max_static_batch_size = 0;
+  for (iree_host_size_t i = 0; i < variant_count; ++i) {
+    if (variants[i].batch_size == 0) {
+      has_dynamic_variant = true;
+    } else {
+      max_static_batch_size =
+          iree_max(max_static_batch_size, variants[i].batch_size);
+    }
+  }
+  if (!has_dynamic_variant && options->max_batch_size > max_static_batch_size) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "max_batch_size %" PRIhsz
+        " exceeds the largest static batch size %" PRIhsz
+        " and no dynamic batch variant was provided",
+        options->max_batch_size, max_static_batch_size);
+  }
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Allocate the batcher, its variants, and the transfer command storage as a
+  // single slab.
+  iree_host_size_t transfer_command_capacity =
+      iree_max(options->max_batch_size, max_static_batch_size);
+  iree_host_size_t commands_offset = iree_host_align(
+      sizeof(iree_runtime_batcher_t) +
+          variant_count * sizeof(iree_runtime_batcher_variant_state_t),
+      iree_max_align_t);
+  iree_host_size_t total_size =
+      commands_offset +
+      transfer_command_capacity * sizeof(iree_hal_transfer_command_t);
+  iree_runtime_batcher_t* batcher = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0,
+      iree_allocator_malloc(host_allocator, total_size, (void**)&batcher));
+  memset(batcher, 0, total_size);
+  iree_atomic_ref_count_init(&batcher->ref_count);
+  batcher->host_allocator = host_allocator;
+  batcher->session = session;
+  iree_runtime_session_retain(session);
+  batcher->max_batch_size = options->max_batch_size;
+  batcher->max_delay_ns = options->max_delay_ns;
+  iree_slim_mutex_initialize(&batcher->mutex);
+  iree_notification_initialize(&batcher->notification);
+  batcher->transfer_command_capacity = transfer_command_capacity;
+  batcher->transfer_commands =
+      (iree_hal_transfer_command_t*)((uint8_t*)batcher + commands_offset);
+
+  iree_status_t status = iree_ok_status();
+  for (iree_host_size_t i = 0; i < variant_count; ++i) {
+    batcher->variants[i].batch_size = variants[i].batch_size;
+    status = iree_runtime_call_initialize(session, variants[i].function,
+                                          &batcher->variants[i].call);
+    if (!iree_status_is_ok(status)) break;
+    ++batcher->variant_count;
+  }
+
+  if (iree_status_is_ok(status)) {
+    *out_batcher = batcher;
+  } else {
+    iree_runtime_batcher_release(batcher);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_runtime_batcher_destroy(iree_runtime_batcher_t* batcher) {
+  IREE_ASSERT_ARGUMENT(batcher);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  for (iree_host_size_t i = 0; i < batcher->variant_count; ++i) {
+    iree_runtime_call_deinitialize(&batcher->variants[i].call);
+  }
+  iree_notification_deinitialize(&batcher->notification);
+  iree_slim_mutex_deinitialize(&batcher->mutex);
+  iree_runtime_session_release(batcher->session);
+
+  iree_allocator_free(batcher->host_allocator, batcher);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+IREE_API_EXPORT void iree_runtime_batcher_retain(
+    iree_runtime_batcher_t* batcher) {
+  if (batcher) {
+    iree_atomic_ref_count_inc(&batcher->ref_count);
+  }
+}
+
+IREE_API_EXPORT void iree_runtime_batcher_release(
+    iree_runtime_batcher_t* batcher) {
+  if (batcher && iree_atomic_ref_count_dec(&batcher->ref_count) == 1) {
+    iree_runtime_batcher_destroy(batcher);
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// Batch formation
+//===----------------------------------------------------------------------===//
+
+// Returns true if the inputs of |a| and |b| have identical shapes and types
+// and can be gathered into the same batch.
+static bool iree_runtime_batcher_requests_compatible(
+    const iree_runtime_batcher_request_t* a,
+    const iree_runtime_batcher_request_t* b) {
+  iree_host_size_t input_count = iree_vm_list_size(a->inputs);
+  if (iree_vm_list_size(b->inputs) != input_count) return false;
+  for (iree_host_size_t i = 0; i < input_count; ++i) {
+    iree_hal_buffer_view_t* a_view =
+        (iree_hal_buffer_view_t*)iree_vm_list_get_ref_deref(
+            a->inputs, i, iree_hal_buffer_view_get_descriptor());
+    iree_hal_buffer_view_t* b_view =
+        (iree_hal_buffer_view_t*)iree_vm_list_get_ref_deref(
+            b->inputs, i, iree_hal_buffer_view_get_descriptor());
+    if (!a_view || !b_view) return false;
+    if (iree_hal_buffer_view_element_type(a_view) !=
+            iree_hal_buffer_view_element_type(b_view) ||
+        iree_hal_buffer_view_encoding_type(a_view) !=
+            iree_hal_buffer_view_encoding_type(b_view)) {
+      return false;
+    }
+    iree_host_size_t rank = iree_hal_buffer_view_shape_rank(a_view);
+    if (iree_hal_buffer_view_shape_rank(b_view) != rank) return false;
+    for (iree_host_size_t j = 0; j < rank; ++j) {
+      if (iree_hal_buffer_view_shape_dim(a_view, j) !=
+          iree_hal_buffer_view_shape_dim(b_view, j)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Selects the variant used to execute a batch of |count| requests.
+// Prefers an exactly matching static variant, then the dynamic variant, and
+// lastly the smallest static variant that can hold the batch.
+static iree_runtime_batcher_variant_state_t*
+iree_runtime_batcher_select_variant(iree_runtime_batcher_t* batcher,
+                                    iree_host_size_t count) {
+  iree_runtime_batcher_variant_state_t* dynamic_variant = NULL;
+  iree_runtime_batcher_variant_state_t* static_variant = NULL;
+  for (iree_host_size_t i = 0; i < batcher->variant_count; ++i) {
+    iree_runtime_batcher_variant_state_t* variant = &batcher->variants[i];
+    if (variant->batch_size == 0) {
+      if (!dynamic_variant) dynamic_variant = variant;
+    } else if (variant->batch_size >= count &&
+               (!static_variant ||
+                variant->batch_size < static_variant->batch_size)) {
+      static_variant = variant;
+    }
+  }
+  if (static_variant && static_variant->batch_size == count) {
+    return static_variant;
+  }
+  return dynamic_variant ? dynamic_variant : static_variant;
+}
+
+// Gathers input |input_index| of the |count| requests starting at |head| into
+// a new batched buffer view of |batch_size| examples and appends it to
+// |batch_inputs|. Padding examples replicate the last request.
+static iree_status_t iree_runtime_batcher_gather_input(
+    iree_runtime_batcher_t* batcher, iree_runtime_batcher_request_t* head,
+    iree_host_size_t count, iree_host_size_t batch_size,
+    iree_host_size_t input_index, iree_vm_list_t* batch_inputs) {
+  iree_hal_buffer_view_t* example_view =
+      (iree_hal_buffer_view_t*)iree_vm_list_get_ref_deref(
+          head->inputs, input_index, iree_hal_buffer_view_get_descriptor());
+  if (!example_view) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "input %" PRIhsz " is not a buffer view",
+                            input_index);
+  }
+
+  iree_hal_dim_t shape[IREE_RUNTIME_BATCHER_MAX_RANK];
+  iree_host_size_t example_rank = 0;
+  IREE_RETURN_IF_ERROR(iree_hal_buffer_view_shape(
+      example_view, IREE_ARRAYSIZE(shape) - 1, &shape[1], &example_rank));
+  shape[0] = (iree_hal_dim_t)batch_size;
+  iree_device_size_t example_length =
+      iree_hal_buffer_view_byte_length(example_view);
+
+  iree_hal_buffer_t* batch_buffer = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_allocator_allocate_buffer(
+      iree_runtime_session_device_allocator(batcher->session),
+      IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL,
+      IREE_HAL_BUFFER_USAGE_DISPATCH | IREE_HAL_BUFFER_USAGE_TRANSFER,
+      example_length * batch_size, iree_const_byte_span_empty(),
+      &batch_buffer));
+
+  // Copy all examples into the batch with a single device transfer.
+  iree_runtime_batcher_request_t* request = head;
+  for (iree_host_size_t i = 0; i < batch_size; ++i) {
+    iree_hal_buffer_view_t* source_view =
+        (iree_hal_buffer_view_t*)iree_vm_list_get_ref_deref(
+            request->inputs, input_index,
+            iree_hal_buffer_view_get_descriptor());
+    iree_hal_transfer_command_t* command = &batcher->transfer_commands[i];
+    command->type = IREE_HAL_TRANSFER_COMMAND_TYPE_COPY;
+    command->copy.source_buffer = iree_hal_buffer_view_buffer(source_view);
+    command->copy.source_offset = 0;
+    command->copy.target_buffer = batch_buffer;
+    command->copy.target_offset = i * example_length;
+    command->copy.length = example_length;
+    if (i + 1 < count) request = request->next;
+  }
+  iree_status_t status = iree_hal_device_transfer_and_wait(
+      iree_runtime_session_device(batcher->session),
+      /*wait_semaphore=*/NULL, /*wait_value=*/0ull, batch_size,
+      batcher->transfer_commands, iree_infinite_timeout());
+
+  iree_hal_buffer_view_t* batch_view = NULL;
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_buffer_view_create(
+        batch_buffer, shape, example_rank + 1,
+        iree_hal_buffer_view_element_type(example_view),
+        iree_hal_buffer_view_encoding_type(example_view),
+        batcher->host_allocator, &batch_view);
+  }
+  iree_hal_buffer_release(batch_buffer);
+  if (iree_status_is_ok(status)) {
+    iree_vm_ref_t batch_view_ref = iree_hal_buffer_view_move_ref(batch_view);
+    status = iree_vm_list_push_ref_move(batch_inputs, &batch_view_ref);
+    iree_vm_ref_release(&batch_view_ref);
+  }
+  return status;
+}
+
+// Scatters output |output_index| from |batch_outputs| to the |count| requests
+// starting at |head| as subspans of the batched buffer.
+static iree_status_t iree_runtime_batcher_scatter_output(
+    iree_runtime_batcher_t* batcher, iree_vm_list_t* batch_outputs,
+    iree_host_size_t output_index, iree_host_size_t batch_size,
+    iree_runtime_batcher_request_t* head, iree_host_size_t count) {
+  iree_hal_buffer_view_t* batch_view =
+      (iree_hal_buffer_view_t*)iree_vm_list_get_ref_deref(
+          batch_outputs, output_index, iree_hal_buffer_view_get_descriptor());
+  if (!batch_view) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "batched output %" PRIhsz " is not a buffer view",
+                            output_index);
+  }
+
+  iree_hal_dim_t shape[IREE_RUNTIME_BATCHER_MAX_RANK];
+  iree_host_size_t rank = 0;
+  IREE_RETURN_IF_ERROR(iree_hal_buffer_view_shape(
+      batch_view, IREE_ARRAYSIZE(shape), shape, &rank));
+  if (rank < 1 || shape[0] != (iree_hal_dim_t)batch_size) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "batched output %" PRIhsz
+                            " does not have a leading batch dimension of "
+                            "%" PRIhsz,
+                            output_index, batch_size);
+  }
+  iree_hal_buffer_t* batch_buffer = iree_hal_buffer_view_buffer(batch_view);
+  iree_device_size_t example_length =
+      iree_hal_buffer_view_byte_length(batch_view) / batch_size;
+
+  iree_runtime_batcher_request_t* request = head;
+  for (iree_host_size_t i = 0; i < count; ++i, request = request->next) {
+    iree_hal_buffer_t* example_buffer = NULL;
+    IREE_RETURN_IF_ERROR(iree_hal_buffer_subspan(
+        batch_buffer, i * example_length, example_length, &example_buffer));
+    iree_hal_buffer_view_t* example_view = NULL;
+    iree_status_t status = iree_hal_buffer_view_create(
+        example_buffer, &shape[1], rank - 1,
+        iree_hal_buffer_view_element_type(batch_view),
+        iree_hal_buffer_view_encoding_type(batch_view),
+        batcher->host_allocator, &example_view);
+    iree_hal_buffer_release(example_buffer);
+    IREE_RETURN_IF_ERROR(status);
+    iree_vm_ref_t example_view_ref =
+        iree_hal_buffer_view_move_ref(example_view);
+    status = iree_vm_list_push_ref_move(request->outputs, &example_view_ref);
+    iree_vm_ref_release(&example_view_ref);
+    IREE_RETURN_IF_ERROR(status);
+  }
+  return iree_ok_status();
+}
+
+// Executes a batch of the |count| requests starting at |head|.
+static iree_status_t iree_runtime_batcher_execute(
+    iree_runtime_batcher_t* batcher, iree_runtime_batcher_request_t* head,
+    iree_host_size_t count) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)count);
+
+  iree_runtime_batcher_variant_state_t* variant =
+      iree_runtime_batcher_select_variant(batcher, count);
+  iree_host_size_t batch_size =
+      variant->batch_size ? variant->batch_size : count;
+  iree_runtime_call_t* call = &variant->call;
+  iree_runtime_call_reset(call);
+
+  iree_runtime_batcher_request_t* request = head;
+  for (iree_host_size_t i = 0; i < count; ++i, request = request->next) {
+    iree_status_ignore(iree_vm_list_resize(request->outputs, 0));
+  }
+
+  iree_status_t status = iree_ok_status();
+  iree_host_size_t input_count = iree_vm_list_size(head->inputs);
+  for (iree_host_size_t i = 0; i < input_count && iree_status_is_ok(status);
+       ++i) {
+    status = iree_runtime_batcher_gather_input(batcher, head, count,
+                                               batch_size, i, call->inputs);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_runtime_call_invoke(call, /*flags=*/0);
+  }
+  iree_host_size_t output_count = iree_vm_list_size(call->outputs);
+  for (iree_host_size_t i = 0; i < output_count && iree_status_is_ok(status);
+       ++i) {
+    status = iree_runtime_batcher_scatter_output(batcher, call->outputs, i,
+                                                 batch_size, head, count);
+  }
+
+  // Drop the batched buffers; the scattered results keep the output
+  // allocations live for as long as the callers retain them.
+  iree_runtime_call_reset(call);
+  if (!iree_status_is_ok(status)) {
+    request = head;
+    for (iree_host_size_t i = 0; i < count; ++i, request = request->next) {
+      iree_status_ignore(iree_vm_list_resize(request->outputs, 0));
+    }
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static bool iree_runtime_batcher_is_full(void* arg) {
+  iree_runtime_batcher_t* batcher = (iree_runtime_batcher_t*)arg;
+  return iree_atomic_load_int32(&batcher->pending_count,
+                                iree_memory_order_acquire) >=
+         (int32_t)batcher->max_batch_size;
+}
+
+static bool iree_runtime_batcher_request_is_ready(void* arg) {
+  iree_runtime_batcher_request_t* request =
+      (iree_runtime_batcher_request_t*)arg;
+  return iree_atomic_load_int32(&request->state, iree_memory_order_acquire) !=
+         IREE_RUNTIME_BATCHER_REQUEST_STATE_PENDING;
+}
+
+// Forms and executes a batch led by |leader|, which must be at the head of the
+// pending queue. Upon return |leader| and all other requests in the batch have
+// been completed and the next pending request (if any) has been promoted.
+static void iree_runtime_batcher_lead(iree_runtime_batcher_t* batcher,
+                                      iree_runtime_batcher_request_t* leader) {
+  // Wait for the batch to fill or for the leader to reach its deadline.
+  iree_notification_await(&batcher->notification, iree_runtime_batcher_is_full,
+                          batcher, iree_make_deadline(leader->deadline_ns));
+
+  // Take as many compatible requests as we can in arrival order.
+  iree_slim_mutex_lock(&batcher->mutex);
+  IREE_ASSERT_EQ(batcher->pending_head, leader);
+  iree_runtime_batcher_request_t* tail = leader;
+  iree_host_size_t count = 1;
+  while (count < batcher->max_batch_size && tail->next &&
+         iree_runtime_batcher_requests_compatible(leader, tail->next)) {
+    tail = tail->next;
+    ++count;
+  }
+  batcher->pending_head = tail->next;
+  if (!batcher->pending_head) batcher->pending_tail = NULL;
+  iree_atomic_fetch_sub_int32(&batcher->pending_count, (int32_t)count,
+                              iree_memory_order_release);
+  iree_slim_mutex_unlock(&batcher->mutex);
+
+  iree_status_t status = iree_runtime_batcher_execute(batcher, leader, count);
+
+  // Hand off leadership to the next pending request, if any.
+  iree_slim_mutex_lock(&batcher->mutex);
+  if (batcher->pending_head) {
+    iree_atomic_store_int32(&batcher->pending_head->state,
+                            IREE_RUNTIME_BATCHER_REQUEST_STATE_LEADING,
+                            iree_memory_order_release);
+  } else {
+    batcher->has_leader = false;
+  }
+  iree_slim_mutex_unlock(&batcher->mutex);
+
+  // Complete all requests in the batch. Requests may be deallocated by their
+  // callers as soon as they are marked completed.
+  iree_runtime_batcher_request_t* request = leader;
+  for (iree_host_size_t i = 0; i < count; ++i) {
+    iree_runtime_batcher_request_t* next_request = request->next;
+    request->status = i + 1 < count ? iree_status_clone(status) : status;
+    iree_atomic_store_int32(&request->state,
+                            IREE_RUNTIME_BATCHER_REQUEST_STATE_COMPLETED,
+                            iree_memory_order_release);
+    request = next_request;
+  }
+  iree_notification_post(&batcher->notification, IREE_ALL_WAITERS);
+}
+
+IREE_API_EXPORT iree_status_t iree_runtime_batcher_call(
+    iree_runtime_batcher_t* batcher, iree_vm_list_t* inputs,
+    iree_vm_list_t* outputs) {
+  IREE_ASSERT_ARGUMENT(batcher);
+  IREE_ASSERT_ARGUMENT(inputs);
+  IREE_ASSERT_ARGUMENT(outputs);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_runtime_batcher_request_t request;
+  memset(&request, 0, sizeof(request));
+  request.inputs = inputs;
+  request.outputs = outputs;
+  request.deadline_ns = iree_time_now() + batcher->max_delay_ns;
+
+  // Enqueue the request. If there is no leader then the request becomes the
+  // leader of the next batch.
+  iree_slim_mutex_lock(&batcher->mutex);
+  if (batcher->pending_tail) {
+    batcher->pending_tail->next = &request;
+  } else {
+    batcher->pending_head = &request;
+  }
+  batcher->pending_tail = &request;
+  iree_atomic_fetch_add_int32(&batcher->pending_count, 1,
+                              iree_memory_order_release);
+  if (!batcher->has_leader) {
+    batcher->has_leader = true;
+    iree_atomic_store_int32(&request.state,
+                            IREE_RUNTIME_BATCHER_REQUEST_STATE_LEADING,
+                            iree_memory_order_relaxed);
+  }
+  iree_slim_mutex_unlock(&batcher->mutex);
+  iree_notification_post(&batcher->notification, IREE_ALL_WAITERS);
+
+  // Wait until the request is either completed as part of another batch or
+  // promoted to lead the next batch.
+  iree_notification_await(&batcher->notification,
+                          iree_runtime_batcher_request_is_ready, &request,
+                          iree_infinite_timeout());
+  if (iree_atomic_load_int32(&request.state, iree_memory_order_acquire) ==
+      IREE_RUNTIME_BATCHER_REQUEST_STATE_LEADING) {
+    iree_runtime_batcher_lead(batcher, &request);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return request.status;
+}
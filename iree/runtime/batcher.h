@@ -0,0 +1,127 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_RUNTIME_BATCHER_H_
+#define IREE_RUNTIME_BATCHER_H_
+
+#include <stdint.h>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/vm/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+typedef struct iree_runtime_session_t iree_runtime_session_t;
+
+//===----------------------------------------------------------------------===//
+// iree_runtime_batcher_options_t
+//===----------------------------------------------------------------------===//
+
+// Default maximum number of requests coalesced into a single batch.
+#define IREE_RUNTIME_BATCHER_DEFAULT_MAX_BATCH_SIZE 8
+
+// Default maximum time a request will wait for others to join its batch.
+#define IREE_RUNTIME_BATCHER_DEFAULT_MAX_DELAY_NS (2 * 1000000ll)  // 2ms
+
+// Options used to configure batcher behavior.
+typedef struct iree_runtime_batcher_options_t {
+  // Maximum number of requests coalesced into a single batch. Batches are
+  // dispatched as soon as this many requests are pending.
+  iree_host_size_t max_batch_size;
+
+  // Maximum time the first request in a batch waits for additional requests
+  // before the batch is dispatched with however many requests are pending.
+  // A value of 0 dispatches immediately with whatever requests have already
+  // arrived.
+  iree_duration_t max_delay_ns;
+} iree_runtime_batcher_options_t;
+
+// Initializes |out_options| to its default values.
+IREE_API_EXPORT void iree_runtime_batcher_options_initialize(
+    iree_runtime_batcher_options_t* out_options);
+
+//===----------------------------------------------------------------------===//
+// iree_runtime_batcher_t
+//===----------------------------------------------------------------------===//
+
+// A function that can be invoked with batched inputs.
+// Each input and output of the function must be a buffer view with a leading
+// batch dimension. Functions compiled for a dynamic batch dimension can be
+// registered with a |batch_size| of 0 and will be invoked with exactly as many
+// requests as are pending. Functions compiled for a static batch dimension are
+// invoked with batches padded up to their |batch_size|.
+typedef struct iree_runtime_batcher_variant_t {
+  iree_vm_function_t function;
+  iree_host_size_t batch_size;
+} iree_runtime_batcher_variant_t;
+
+// Coalesces concurrent single-example calls into batched calls.
+//
+// Callers use iree_runtime_batcher_call with inputs and outputs for a single
+// example (without the batch dimension) from as many threads as they want.
+// Requests that arrive within the configured delay of each other are coalesced
+// into a single batch and the nearest batch variant of the function is invoked
+// on the thread of the first request of the batch; the other requests block
+// until the batch completes with their results.
+//
+// Input examples are gathered into batched device buffers with
+// iree_hal_device_transfer_range and never staged on the host. Results are
+// scattered as buffer views of subspans of the batched output buffers so that
+// no copies are performed; note that this keeps the entire batched output
+// allocation live until all requests in the batch release their results.
+//
+// Requests are batched in arrival order and only requests whose inputs have
+// matching shapes and element types are coalesced together. Those that do not
+// match the first pending request wait for a subsequent batch.
+//
+// Only one batch executes at a time. The batcher invokes functions within the
+// session context and callers must not concurrently use the session context
+// for other calls while the batcher is in use.
+//
+// Thread-safe.
+typedef struct iree_runtime_batcher_t iree_runtime_batcher_t;
+
+// Creates a batcher executing the given function |variants| within |session|.
+// At least one variant must be provided and if none have a dynamic batch size
+// then |options|.max_batch_size must be no larger than the largest static
+// batch size.
+IREE_API_EXPORT iree_status_t iree_runtime_batcher_create(
+    iree_runtime_session_t* session,
+    const iree_runtime_batcher_options_t* options,
+    iree_host_size_t variant_count,
+    const iree_runtime_batcher_variant_t* variants,
+    iree_allocator_t host_allocator, iree_runtime_batcher_t** out_batcher);
+
+// Retains the given |batcher| for the caller.
+IREE_API_EXPORT void iree_runtime_batcher_retain(
+    iree_runtime_batcher_t* batcher);
+
+// Releases the given |batcher| from the caller.
+// No calls may be in progress when the last reference is released.
+IREE_API_EXPORT void iree_runtime_batcher_release(
+    iree_runtime_batcher_t* batcher);
+
+// Synchronously invokes the batched function with a single example.
+//
+// |inputs| must contain one buffer view per function input with the shape of
+// a single example (the batched shape with the leading batch dimension
+// removed). Upon success |outputs| is populated with one buffer view per
+// function output with the leading batch dimension removed.
+//
+// Blocks until the batch containing the request has completed. If the batch
+// fails all requests in it fail with the same status.
+IREE_API_EXPORT iree_status_t iree_runtime_batcher_call(
+    iree_runtime_batcher_t* batcher, iree_vm_list_t* inputs,
+    iree_vm_list_t* outputs);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_RUNTIME_BATCHER_H_
@@ -0,0 +1,300 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/runtime/batcher.h"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/modules/hal/module.h"
+#include "iree/runtime/api.h"
+#include "iree/runtime/testdata/batch_mul_module_c.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+#include "iree/vm/api.h"
+
+namespace {
+
+// A single-example request and its results.
+struct Example {
+  std::vector<float> lhs;
+  std::vector<float> rhs;
+  iree_vm_list_t* inputs = NULL;
+  iree_vm_list_t* outputs = NULL;
+  iree_status_code_t status_code = IREE_STATUS_OK;
+
+  ~Example() {
+    iree_vm_list_release(inputs);
+    iree_vm_list_release(outputs);
+  }
+};
+
+class BatcherTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    iree_runtime_instance_options_t instance_options;
+    iree_runtime_instance_options_initialize(IREE_API_VERSION_LATEST,
+                                             &instance_options);
+    iree_runtime_instance_options_use_all_available_drivers(&instance_options);
+    IREE_ASSERT_OK(iree_runtime_instance_create(
+        &instance_options, iree_allocator_system(), &instance_));
+
+    iree_hal_device_t* device = NULL;
+    IREE_ASSERT_OK(iree_runtime_instance_try_create_default_device(
+        instance_, iree_make_cstring_view("vmvx-sync"), &device));
+    iree_runtime_session_options_t session_options;
+    iree_runtime_session_options_initialize(&session_options);
+    iree_status_t status = iree_runtime_session_create_with_device(
+        instance_, &session_options, device, iree_allocator_system(),
+        &session_);
+    iree_hal_device_release(device);
+    IREE_ASSERT_OK(status);
+
+    const iree_file_toc_t* module_file =
+        iree_runtime_testdata_batch_mul_module_create();
+    IREE_ASSERT_OK(iree_runtime_session_append_bytecode_module_from_memory(
+        session_,
+        iree_make_const_byte_span(module_file->data, module_file->size),
+        iree_allocator_null()));
+  }
+
+  void TearDown() override {
+    iree_runtime_batcher_release(batcher_);
+    iree_runtime_session_release(session_);
+    iree_runtime_instance_release(instance_);
+  }
+
+  // Creates |batcher_| with the given function variants by name.
+  void CreateBatcher(iree_host_size_t max_batch_size,
+                     iree_duration_t max_delay_ns,
+                     std::vector<std::pair<const char*, iree_host_size_t>>
+                         named_variants) {
+    std::vector<iree_runtime_batcher_variant_t> variants(named_variants.size());
+    for (size_t i = 0; i < named_variants.size(); ++i) {
+      IREE_ASSERT_OK(iree_runtime_session_lookup_function(
+          session_, iree_make_cstring_view(named_variants[i].first),
+          &variants[i].function));
+      variants[i].batch_size = named_variants[i].second;
+    }
+    iree_runtime_batcher_options_t options;
+    iree_runtime_batcher_options_initialize(&options);
+    options.max_batch_size = max_batch_size;
+    options.max_delay_ns = max_delay_ns;
+    IREE_ASSERT_OK(iree_runtime_batcher_create(
+        session_, &options, variants.size(), variants.data(),
+        iree_allocator_system(), &batcher_));
+  }
+
+  // Appends a buffer view of |values| to |list|.
+  void PushExampleInput(const std::vector<float>& values,
+                        iree_vm_list_t* list) {
+    iree_hal_dim_t shape[1] = {(iree_hal_dim_t)values.size()};
+    iree_hal_buffer_view_t* buffer_view = NULL;
+    IREE_ASSERT_OK(iree_hal_buffer_view_allocate_buffer(
+        iree_runtime_session_device_allocator(session_), shape,
+        IREE_ARRAYSIZE(shape), IREE_HAL_ELEMENT_TYPE_FLOAT_32,
+        IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR,
+        IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL, IREE_HAL_BUFFER_USAGE_ALL,
+        iree_make_const_byte_span(values.data(),
+                                  values.size() * sizeof(float)),
+        &buffer_view));
+    iree_vm_ref_t buffer_view_ref = iree_hal_buffer_view_move_ref(buffer_view);
+    IREE_ASSERT_OK(iree_vm_list_push_ref_move(list, &buffer_view_ref));
+  }
+
+  // Prepares |example| with |input_count| inputs of |element_count| values.
+  void PrepareExample(Example* example, int seed,
+                      iree_host_size_t element_count,
+                      iree_host_size_t input_count = 2) {
+    example->lhs.resize(element_count);
+    example->rhs.resize(element_count);
+    for (iree_host_size_t i = 0; i < element_count; ++i) {
+      example->lhs[i] = (float)(seed * 10 + i);
+      example->rhs[i] = (float)(seed + 1);
+    }
+    IREE_ASSERT_OK(iree_vm_list_create(/*element_type=*/NULL, input_count,
+                                       iree_allocator_system(),
+                                       &example->inputs));
+    IREE_ASSERT_OK(iree_vm_list_create(/*element_type=*/NULL, 1,
+                                       iree_allocator_system(),
+                                       &example->outputs));
+    PushExampleInput(example->lhs, example->inputs);
+    if (input_count > 1) PushExampleInput(example->rhs, example->inputs);
+  }
+
+  // Issues all |examples| concurrently from one thread each.
+  void CallConcurrently(std::vector<Example>& examples) {
+    std::atomic<bool> start = {false};
+    std::vector<std::thread> threads;
+    for (auto& example : examples) {
+      threads.emplace_back([&]() {
+        while (!start.load()) std::this_thread::yield();
+        iree_status_t status = iree_runtime_batcher_call(
+            batcher_, example.inputs, example.outputs);
+        example.status_code = iree_status_code(status);
+        iree_status_ignore(status);
+      });
+    }
+    start.store(true);
+    for (auto& thread : threads) thread.join();
+  }
+
+  // Returns the single output of |example|.
+  iree_hal_buffer_view_t* GetOutput(const Example& example) {
+    return (iree_hal_buffer_view_t*)iree_vm_list_get_ref_deref(
+        example.outputs, 0, iree_hal_buffer_view_get_descriptor());
+  }
+
+  // Returns the buffer backing the batch that produced |example|'s result.
+  iree_hal_buffer_t* GetBatchBuffer(const Example& example) {
+    return iree_hal_buffer_allocated_buffer(
+        iree_hal_buffer_view_buffer(GetOutput(example)));
+  }
+
+  // Checks that |example| succeeded with the product of its inputs.
+  void ExpectProduct(const Example& example) {
+    ASSERT_EQ(IREE_STATUS_OK, example.status_code);
+    ASSERT_EQ(1, iree_vm_list_size(example.outputs));
+    iree_hal_buffer_view_t* output = GetOutput(example);
+    ASSERT_TRUE(output);
+    ASSERT_EQ(1, iree_hal_buffer_view_shape_rank(output));
+    ASSERT_EQ(example.lhs.size(), iree_hal_buffer_view_shape_dim(output, 0));
+    std::vector<float> values(example.lhs.size());
+    IREE_ASSERT_OK(iree_hal_device_transfer_range(
+        iree_runtime_session_device(session_),
+        iree_hal_make_device_transfer_buffer(
+            iree_hal_buffer_view_buffer(output)),
+        0,
+        iree_hal_make_host_transfer_buffer_span(
+            values.data(), values.size() * sizeof(float)),
+        0, values.size() * sizeof(float), IREE_HAL_TRANSFER_BUFFER_FLAG_DEFAULT,
+        iree_infinite_timeout()));
+    for (size_t i = 0; i < values.size(); ++i) {
+      EXPECT_EQ(example.lhs[i] * example.rhs[i], values[i]) << "element " << i;
+    }
+  }
+
+  iree_runtime_instance_t* instance_ = NULL;
+  iree_runtime_session_t* session_ = NULL;
+  iree_runtime_batcher_t* batcher_ = NULL;
+};
+
+// A single request is executed on its own once its deadline passes.
+TEST_F(BatcherTest, SingleRequest) {
+  CreateBatcher(/*max_batch_size=*/4, /*max_delay_ns=*/0,
+                {{"module.batch_mul", 0}});
+  Example example;
+  PrepareExample(&example, 1, 4);
+  IREE_ASSERT_OK(
+      iree_runtime_batcher_call(batcher_, example.inputs, example.outputs));
+  ExpectProduct(example);
+}
+
+// Requests that cannot fill a batch are dispatched together once the deadline
+// of the first request passes.
+TEST_F(BatcherTest, DeadlineFormsPartialBatch) {
+  static const iree_duration_t kMaxDelayNs = 500 * 1000000ll;
+  CreateBatcher(/*max_batch_size=*/8, kMaxDelayNs, {{"module.batch_mul", 0}});
+  std::vector<Example> examples(3);
+  for (int i = 0; i < 3; ++i) PrepareExample(&examples[i], i, 4);
+
+  iree_time_t start_ns = iree_time_now();
+  CallConcurrently(examples);
+  EXPECT_GE(iree_time_now() - start_ns, kMaxDelayNs);
+
+  for (auto& example : examples) ExpectProduct(example);
+  EXPECT_EQ(GetBatchBuffer(examples[0]), GetBatchBuffer(examples[1]));
+  EXPECT_EQ(GetBatchBuffer(examples[0]), GetBatchBuffer(examples[2]));
+}
+
+// A full batch is dispatched without waiting for the deadline.
+TEST_F(BatcherTest, FullBatchSkipsDeadline) {
+  CreateBatcher(/*max_batch_size=*/4, IREE_DURATION_INFINITE,
+                {{"module.batch_mul", 0}});
+  std::vector<Example> examples(4);
+  for (int i = 0; i < 4; ++i) PrepareExample(&examples[i], i, 4);
+  CallConcurrently(examples);
+  for (auto& example : examples) {
+    ExpectProduct(example);
+    EXPECT_EQ(GetBatchBuffer(examples[0]), GetBatchBuffer(example));
+  }
+}
+
+// Batches smaller than the static variant are padded and the padding is not
+// returned to callers.
+TEST_F(BatcherTest, StaticVariantPadsBatch) {
+  CreateBatcher(/*max_batch_size=*/4, /*max_delay_ns=*/0,
+                {{"module.batch_mul_4", 4}});
+  std::vector<Example> examples(2);
+  for (int i = 0; i < 2; ++i) PrepareExample(&examples[i], i, 4);
+  CallConcurrently(examples);
+  for (auto& example : examples) ExpectProduct(example);
+}
+
+// Requests with different example shapes are never gathered into the same
+// batch but all complete.
+TEST_F(BatcherTest, MixedShapesSplitBatches) {
+  CreateBatcher(/*max_batch_size=*/4, /*max_delay_ns=*/100 * 1000000ll,
+                {{"module.batch_mul", 0}});
+  std::vector<Example> examples(4);
+  for (int i = 0; i < 4; ++i) {
+    PrepareExample(&examples[i], i, i % 2 ? 8 : 4);
+  }
+  CallConcurrently(examples);
+  for (auto& example : examples) ExpectProduct(example);
+  EXPECT_NE(GetBatchBuffer(examples[0]), GetBatchBuffer(examples[1]));
+  EXPECT_NE(GetBatchBuffer(examples[0]), GetBatchBuffer(examples[3]));
+  EXPECT_NE(GetBatchBuffer(examples[2]), GetBatchBuffer(examples[1]));
+  EXPECT_NE(GetBatchBuffer(examples[2]), GetBatchBuffer(examples[3]));
+}
+
+// A failing batch fails every request in it with the same status and returns
+// no outputs.
+TEST_F(BatcherTest, FailureFansOut) {
+  CreateBatcher(/*max_batch_size=*/3, /*max_delay_ns=*/500 * 1000000ll,
+                {{"module.batch_mul", 0}});
+  std::vector<Example> examples(3);
+  for (int i = 0; i < 3; ++i) {
+    // The function takes two inputs; invoking it with one fails the batch.
+    PrepareExample(&examples[i], i, 4, /*input_count=*/1);
+  }
+  CallConcurrently(examples);
+  EXPECT_NE(IREE_STATUS_OK, examples[0].status_code);
+  for (auto& example : examples) {
+    EXPECT_EQ(examples[0].status_code, example.status_code);
+    EXPECT_EQ(0, iree_vm_list_size(example.outputs));
+  }
+
+  // The batcher remains usable after a failed batch.
+  Example example;
+  PrepareExample(&example, 5, 4);
+  IREE_ASSERT_OK(
+      iree_runtime_batcher_call(batcher_, example.inputs, example.outputs));
+  ExpectProduct(example);
+}
+
+// Rejects configurations that cannot execute a full batch.
+TEST_F(BatcherTest, RejectsUndersizedStaticVariants) {
+  iree_runtime_batcher_variant_t variant;
+  IREE_ASSERT_OK(iree_runtime_session_lookup_function(
+      session_, iree_make_cstring_view("module.batch_mul_4"),
+      &variant.function));
+  variant.batch_size = 4;
+  iree_runtime_batcher_options_t options;
+  iree_runtime_batcher_options_initialize(&options);
+  options.max_batch_size = 8;
+  iree_status_t status = iree_runtime_batcher_create(
+      session_, &options, 1, &variant, iree_allocator_system(), &batcher_);
+  EXPECT_EQ(IREE_STATUS_INVALID_ARGUMENT, iree_status_code(status));
+  iree_status_ignore(status);
+  EXPECT_EQ(NULL, batcher_);
+}
+
+}  // namespace
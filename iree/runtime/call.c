@@ -10,6 +10,7 @@
 #include <string.h>
 
 #include "iree/base/api.h"
+#include "iree/base/tracing.h"
 #include "iree/modules/hal/module.h"
 #include "iree/runtime/session.h"
 
@@ -50,6 +51,12 @@ IREE_API_EXPORT iree_status_t iree_runtime_call_initialize(
         /*element_type=*/NULL, results.size, host_allocator,
         &out_call->outputs);
   }
+  if (iree_status_is_ok(status)) {
+    out_call->stack_storage.data_length = IREE_VM_STACK_DEFAULT_SIZE;
+    status = iree_allocator_malloc(host_allocator,
+                                   out_call->stack_storage.data_length,
+                                   (void**)&out_call->stack_storage.data);
+  }
 
   if (!iree_status_is_ok(status)) {
     iree_runtime_call_deinitialize(out_call);
@@ -70,6 +77,10 @@ IREE_API_EXPORT void iree_runtime_call_deinitialize(iree_runtime_call_t* call) {
   IREE_ASSERT_ARGUMENT(call);
   iree_vm_list_release(call->inputs);
   iree_vm_list_release(call->outputs);
+  if (call->session) {
+    iree_allocator_free(iree_runtime_session_host_allocator(call->session),
+                        call->stack_storage.data);
+  }
   iree_runtime_session_release(call->session);
 }
 
@@ -93,8 +104,49 @@ IREE_API_EXPORT iree_vm_list_t* iree_runtime_call_outputs(
 
 IREE_API_EXPORT iree_status_t iree_runtime_call_invoke(
     iree_runtime_call_t* call, iree_runtime_call_flags_t flags) {
-  return iree_runtime_session_call(call->session, &call->function, call->inputs,
-                                   call->outputs);
+  IREE_ASSERT_ARGUMENT(call);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_allocator_t host_allocator =
+      iree_runtime_session_host_allocator(call->session);
+
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_runtime_session_admit_call(call->session, &call->function));
+  iree_host_size_t stack_storage_capacity = 0;
+  iree_status_t status = iree_vm_invoke_with_stack_storage(
+      iree_runtime_session_context(call->session), call->function,
+      IREE_VM_INVOCATION_FLAG_NONE, /*policy=*/NULL, call->inputs,
+      call->outputs, call->stack_storage, host_allocator,
+      &stack_storage_capacity);
+
+  // If the stack had to grow then enlarge the retained storage so that the
+  // next invocation doesn't need to. The contents need not be preserved and
+  // failing to grow only means the next invocation grows the stack again.
+  if (iree_status_is_ok(status) &&
+      stack_storage_capacity > call->stack_storage.data_length) {
+    IREE_TRACE_ZONE_APPEND_VALUE(z0, stack_storage_capacity);
+    void* new_storage = NULL;
+    if (iree_status_consume_code(iree_allocator_malloc(
+            host_allocator, stack_storage_capacity, &new_storage)) ==
+        IREE_STATUS_OK) {
+      iree_allocator_free(host_allocator, call->stack_storage.data);
+      call->stack_storage =
+          iree_make_byte_span(new_storage, stack_storage_capacity);
+    }
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+IREE_API_EXPORT iree_status_t iree_runtime_call_invoke_async(
+    iree_runtime_call_t* call, iree_runtime_call_flags_t flags,
+    iree_hal_semaphore_t* wait_semaphore, uint64_t wait_value,
+    iree_hal_semaphore_t* signal_semaphore, uint64_t signal_value) {
+  IREE_ASSERT_ARGUMENT(call);
+  IREE_ASSERT_ARGUMENT(signal_semaphore);
+  return iree_runtime_session_call_async(
+      call->session, &call->function, call->inputs, call->outputs,
+      wait_semaphore, wait_value, signal_semaphore, signal_value);
 }
 
 //===----------------------------------------------------------------------===//
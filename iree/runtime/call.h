@@ -41,6 +41,10 @@ typedef uint32_t iree_runtime_call_flags_t;
 // call like this callers are required to either reset the call, copy their
 // data out, or reset the particular output they are consuming.
 //
+// The VM stack storage is also retained across invocations and sized to what
+// prior invocations required such that once warm repeated calls to the same
+// function perform no heap allocations of their own.
+//
 // Thread-compatible; these are designed to be stack-local or embedded in a user
 // data structure that can provide synchronization when required.
 typedef struct iree_runtime_call_t {
@@ -48,6 +52,7 @@ typedef struct iree_runtime_call_t {
   iree_vm_function_t function;
   iree_vm_list_t* inputs;
   iree_vm_list_t* outputs;
+  iree_byte_span_t stack_storage;
 } iree_runtime_call_t;
 
 // Initializes call state for a call to |function| within |session|.
@@ -92,6 +97,21 @@ IREE_API_EXPORT iree_vm_list_t* iree_runtime_call_outputs(
 IREE_API_EXPORT iree_status_t iree_runtime_call_invoke(
     iree_runtime_call_t* call, iree_runtime_call_flags_t flags);
 
+// Asynchronously invokes the call and returns as soon as it has been enqueued.
+// The call begins after the optional |wait_semaphore| reaches |wait_value| and
+// |signal_semaphore| is signaled to |signal_value| when it completes (or failed
+// with the call status). This allows callers to prepare the inputs of
+// subsequent calls while prior calls execute.
+//
+// The inputs list must not be modified and the outputs list must not be
+// accessed until |signal_semaphore| has been signaled. Callers issuing multiple
+// concurrent calls should use one iree_runtime_call_t per in-flight call.
+// See iree_runtime_session_call_async for more information.
+IREE_API_EXPORT iree_status_t iree_runtime_call_invoke_async(
+    iree_runtime_call_t* call, iree_runtime_call_flags_t flags,
+    iree_hal_semaphore_t* wait_semaphore, uint64_t wait_value,
+    iree_hal_semaphore_t* signal_semaphore, uint64_t signal_value);
+
 //===----------------------------------------------------------------------===//
 // Helpers for defining call I/O
 //===----------------------------------------------------------------------===//
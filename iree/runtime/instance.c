@@ -49,6 +49,9 @@ struct iree_runtime_instance_t {
   // An optional driver registry used to enumerate and create HAL devices.
   iree_hal_driver_registry_t* driver_registry;
 
+  // An optional executable registry shared by all sessions.
+  iree_hal_executable_registry_t* executable_registry;
+
   // TODO(#5724): we should have a device cache here so that multiple sessions
   // can find the same devices. This may mean a new HAL type like
   // iree_hal_device_pool_t to prevent too much coupling and make weak
@@ -88,6 +91,9 @@ IREE_API_EXPORT iree_status_t iree_runtime_instance_create(
   instance->driver_registry = options->driver_registry;
   // TODO(benvanik): driver registry ref counting.
 
+  instance->executable_registry = options->executable_registry;
+  iree_hal_executable_registry_retain(instance->executable_registry);
+
   *out_instance = instance;
   IREE_TRACE_ZONE_END(z0);
   return iree_ok_status();
@@ -97,6 +103,7 @@ static void iree_runtime_instance_destroy(iree_runtime_instance_t* instance) {
   IREE_ASSERT_ARGUMENT(instance);
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  iree_hal_executable_registry_release(instance->executable_registry);
   iree_allocator_free(instance->host_allocator, instance);
 
   IREE_TRACE_ZONE_END(z0);
@@ -128,6 +135,13 @@ iree_runtime_instance_driver_registry(const iree_runtime_instance_t* instance) {
   return instance->driver_registry;
 }
 
+IREE_API_EXPORT iree_hal_executable_registry_t*
+iree_runtime_instance_executable_registry(
+    const iree_runtime_instance_t* instance) {
+  IREE_ASSERT_ARGUMENT(instance);
+  return instance->executable_registry;
+}
+
 IREE_API_EXPORT iree_status_t iree_runtime_instance_try_create_default_device(
     iree_runtime_instance_t* instance, iree_string_view_t driver_name,
     iree_hal_device_t** out_device) {
@@ -9,6 +9,7 @@
 
 #include "iree/base/api.h"
 #include "iree/hal/api.h"
+#include "iree/hal/utils/executable_registry.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -60,6 +61,12 @@ typedef struct iree_runtime_instance_options_t {
   // When not provided a device must be specified when creating sessions via
   // iree_runtime_session_create_with_device.
   iree_hal_driver_registry_t* driver_registry;
+
+  // An optional executable registry shared by all sessions in the instance.
+  // Sessions loading the same programs on the same device will share
+  // executables instead of each preparing their own copy. The same registry
+  // may be provided to multiple instances.
+  iree_hal_executable_registry_t* executable_registry;
 } iree_runtime_instance_options_t;
 
 // Initializes |out_options| to its default values.
@@ -110,6 +117,11 @@ iree_runtime_instance_host_allocator(const iree_runtime_instance_t* instance);
 IREE_API_EXPORT iree_hal_driver_registry_t*
 iree_runtime_instance_driver_registry(const iree_runtime_instance_t* instance);
 
+// Returns the optional executable registry shared by sessions in the instance.
+IREE_API_EXPORT iree_hal_executable_registry_t*
+iree_runtime_instance_executable_registry(
+    const iree_runtime_instance_t* instance);
+
 // TODO(#5724): remove this once user modules query devices themselves.
 IREE_API_EXPORT iree_status_t iree_runtime_instance_try_create_default_device(
     iree_runtime_instance_t* instance, iree_string_view_t driver_name,
@@ -0,0 +1,255 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/runtime/pipeline.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/tracing.h"
+#include "iree/modules/hal/module.h"
+#include "iree/runtime/session.h"
+
+//===----------------------------------------------------------------------===//
+// iree_runtime_pipeline_t
+//===----------------------------------------------------------------------===//
+
+typedef struct iree_runtime_pipeline_stage_state_t {
+  iree_runtime_session_t* session;
+  iree_vm_function_t function;
+  // Device of |session|; owned by the session.
+  iree_hal_device_t* device;
+  // Number of results produced by |function| used to size the list passed to
+  // the next stage.
+  iree_host_size_t result_count;
+  // True if the inputs of the stage are produced on a different device and
+  // must be transferred prior to execution.
+  bool transfer_inputs;
+  // Held while a call is executing the stage.
+  iree_slim_mutex_t mutex;
+} iree_runtime_pipeline_stage_state_t;
+
+struct iree_runtime_pipeline_t {
+  iree_atomic_ref_count_t ref_count;
+  iree_allocator_t host_allocator;
+  iree_host_size_t stage_count;
+  iree_runtime_pipeline_stage_state_t stages[];
+};
+
+static void iree_runtime_pipeline_destroy(iree_runtime_pipeline_t* pipeline);
+
+IREE_API_EXPORT iree_status_t iree_runtime_pipeline_create(
+    iree_host_size_t stage_count, const iree_runtime_pipeline_stage_t* stages,
+    iree_allocator_t host_allocator, iree_runtime_pipeline_t** out_pipeline) {
+  IREE_ASSERT_ARGUMENT(!stage_count || stages);
+  IREE_ASSERT_ARGUMENT(out_pipeline);
+  *out_pipeline = NULL;
+
+  if (stage_count == 0) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "at least one stage is required");
+  }
+  for (iree_host_size_t i = 0; i < stage_count; ++i) {
+    if (!stages[i].session) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "stage %" PRIhsz " has no session", i);
+    }
+  }
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_runtime_pipeline_t* pipeline = NULL;
+  iree_host_size_t total_size =
+      sizeof(*pipeline) + stage_count * sizeof(pipeline->stages[0]);
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0,
+      iree_allocator_malloc(host_allocator, total_size, (void**)&pipeline));
+  iree_atomic_ref_count_init(&pipeline->ref_count);
+  pipeline->host_allocator = host_allocator;
+
+  iree_status_t status = iree_ok_status();
+  for (iree_host_size_t i = 0; i < stage_count; ++i) {
+    iree_runtime_pipeline_stage_state_t* stage = &pipeline->stages[i];
+    iree_vm_function_signature_t signature =
+        iree_vm_function_signature(&stages[i].function);
+    iree_string_view_t arguments;
+    iree_string_view_t results;
+    status = iree_vm_function_call_get_cconv_fragments(&signature, &arguments,
+                                                       &results);
+    if (!iree_status_is_ok(status)) break;
+
+    stage->session = stages[i].session;
+    iree_runtime_session_retain(stage->session);
+    stage->function = stages[i].function;
+    stage->device = iree_runtime_session_device(stage->session);
+    stage->result_count = results.size;
+    stage->transfer_inputs =
+        i > 0 && stage->device != pipeline->stages[i - 1].device;
+    iree_slim_mutex_initialize(&stage->mutex);
+    ++pipeline->stage_count;
+  }
+
+  if (iree_status_is_ok(status)) {
+    *out_pipeline = pipeline;
+  } else {
+    iree_runtime_pipeline_release(pipeline);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static void iree_runtime_pipeline_destroy(iree_runtime_pipeline_t* pipeline) {
+  IREE_ASSERT_ARGUMENT(pipeline);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  for (iree_host_size_t i = 0; i < pipeline->stage_count; ++i) {
+    iree_runtime_pipeline_stage_state_t* stage = &pipeline->stages[i];
+    iree_slim_mutex_deinitialize(&stage->mutex);
+    iree_runtime_session_release(stage->session);
+  }
+
+  iree_allocator_free(pipeline->host_allocator, pipeline);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+IREE_API_EXPORT void iree_runtime_pipeline_retain(
+    iree_runtime_pipeline_t* pipeline) {
+  if (pipeline) {
+    iree_atomic_ref_count_inc(&pipeline->ref_count);
+  }
+}
+
+IREE_API_EXPORT void iree_runtime_pipeline_release(
+    iree_runtime_pipeline_t* pipeline) {
+  if (pipeline && iree_atomic_ref_count_dec(&pipeline->ref_count) == 1) {
+    iree_runtime_pipeline_destroy(pipeline);
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// Execution
+//===----------------------------------------------------------------------===//
+
+// Copies |source_view| into a new device-local buffer view on |device|.
+// The transfer is issued on the consuming device so that devices with access
+// to the source memory can copy directly from it.
+static iree_status_t iree_runtime_pipeline_transfer_buffer_view(
+    iree_hal_device_t* device, iree_hal_buffer_view_t* source_view,
+    iree_allocator_t host_allocator, iree_hal_buffer_view_t** out_view) {
+  *out_view = NULL;
+  iree_device_size_t byte_length =
+      iree_hal_buffer_view_byte_length(source_view);
+
+  iree_hal_buffer_t* target_buffer = NULL;
+  IREE_RETURN_IF_ERROR(iree_hal_allocator_allocate_buffer(
+      iree_hal_device_allocator(device), IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL,
+      IREE_HAL_BUFFER_USAGE_DISPATCH | IREE_HAL_BUFFER_USAGE_TRANSFER,
+      byte_length, iree_const_byte_span_empty(), &target_buffer));
+
+  iree_status_t status = iree_hal_device_transfer_range(
+      device,
+      iree_hal_make_device_transfer_buffer(
+          iree_hal_buffer_view_buffer(source_view)),
+      0, iree_hal_make_device_transfer_buffer(target_buffer), 0, byte_length,
+      IREE_HAL_TRANSFER_BUFFER_FLAG_DEFAULT, iree_infinite_timeout());
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_buffer_view_create(
+        target_buffer, iree_hal_buffer_view_shape_dims(source_view),
+        iree_hal_buffer_view_shape_rank(source_view),
+        iree_hal_buffer_view_element_type(source_view),
+        iree_hal_buffer_view_encoding_type(source_view), host_allocator,
+        out_view);
+  }
+
+  iree_hal_buffer_release(target_buffer);
+  return status;
+}
+
+// Replaces all buffer views in |list| with copies resident on |device|.
+// Other values are passed through unchanged.
+static iree_status_t iree_runtime_pipeline_transfer_list(
+    iree_hal_device_t* device, iree_vm_list_t* list,
+    iree_allocator_t host_allocator) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_status_t status = iree_ok_status();
+  for (iree_host_size_t i = 0; i < iree_vm_list_size(list); ++i) {
+    iree_hal_buffer_view_t* source_view =
+        (iree_hal_buffer_view_t*)iree_vm_list_get_ref_deref(
+            list, i, iree_hal_buffer_view_get_descriptor());
+    if (!source_view) continue;
+    iree_hal_buffer_view_t* target_view = NULL;
+    status = iree_runtime_pipeline_transfer_buffer_view(
+        device, source_view, host_allocator, &target_view);
+    if (!iree_status_is_ok(status)) break;
+    iree_vm_ref_t target_ref = iree_hal_buffer_view_move_ref(target_view);
+    status = iree_vm_list_set_ref_move(list, i, &target_ref);
+    if (!iree_status_is_ok(status)) {
+      iree_vm_ref_release(&target_ref);
+      break;
+    }
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Executes |stage| with |inputs| and populates |outputs|.
+// Must be called with the stage mutex held.
+static iree_status_t iree_runtime_pipeline_run_stage(
+    iree_runtime_pipeline_t* pipeline,
+    iree_runtime_pipeline_stage_state_t* stage, iree_vm_list_t* inputs,
+    iree_vm_list_t* outputs) {
+  if (stage->transfer_inputs) {
+    IREE_RETURN_IF_ERROR(iree_runtime_pipeline_transfer_list(
+        stage->device, inputs, pipeline->host_allocator));
+  }
+  return iree_runtime_session_call(stage->session, &stage->function, inputs,
+                                   outputs);
+}
+
+IREE_API_EXPORT iree_status_t iree_runtime_pipeline_call(
+    iree_runtime_pipeline_t* pipeline, iree_vm_list_t* inputs,
+    iree_vm_list_t* outputs) {
+  IREE_ASSERT_ARGUMENT(pipeline);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Stages are acquired hand-over-hand: the next stage is acquired before
+  // releasing the current one so that calls cannot overtake each other and
+  // each stage is free to execute the following call as soon as the current
+  // call moves on.
+  iree_status_t status = iree_ok_status();
+  iree_vm_list_t* stage_inputs = inputs;
+  iree_runtime_pipeline_stage_state_t* previous_stage = NULL;
+  for (iree_host_size_t i = 0; i < pipeline->stage_count; ++i) {
+    iree_runtime_pipeline_stage_state_t* stage = &pipeline->stages[i];
+    iree_slim_mutex_lock(&stage->mutex);
+    if (previous_stage) iree_slim_mutex_unlock(&previous_stage->mutex);
+    previous_stage = stage;
+
+    // Intermediate results are stored in a list owned by this call.
+    iree_vm_list_t* stage_outputs = outputs;
+    if (i + 1 < pipeline->stage_count) {
+      status = iree_vm_list_create(/*element_type=*/NULL, stage->result_count,
+                                   pipeline->host_allocator, &stage_outputs);
+      if (!iree_status_is_ok(status)) break;
+    }
+
+    status = iree_runtime_pipeline_run_stage(pipeline, stage, stage_inputs,
+                                             stage_outputs);
+    if (stage_inputs != inputs) iree_vm_list_release(stage_inputs);
+    stage_inputs = stage_outputs;
+    if (!iree_status_is_ok(status)) break;
+  }
+  if (previous_stage) iree_slim_mutex_unlock(&previous_stage->mutex);
+  if (stage_inputs != inputs && stage_inputs != outputs) {
+    iree_vm_list_release(stage_inputs);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
@@ -0,0 +1,92 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_RUNTIME_PIPELINE_H_
+#define IREE_RUNTIME_PIPELINE_H_
+
+#include <stdint.h>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/vm/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+typedef struct iree_runtime_session_t iree_runtime_session_t;
+
+//===----------------------------------------------------------------------===//
+// iree_runtime_pipeline_t
+//===----------------------------------------------------------------------===//
+
+// A single stage of a pipeline executing |function| within |session|.
+// The device the stage executes on is the device of the session.
+typedef struct iree_runtime_pipeline_stage_t {
+  iree_runtime_session_t* session;
+  iree_vm_function_t function;
+} iree_runtime_pipeline_stage_t;
+
+// Executes a model partitioned into sequential stages across one or more
+// devices with pipeline parallelism.
+//
+// Each stage is a function within a session bound to the device the stage
+// executes on; usually each stage holds a contiguous range of layers of a
+// model too large for a single device. The outputs of each stage are passed
+// as the inputs to the next stage and the inputs and outputs of the pipeline
+// are the inputs of the first stage and the outputs of the last stage.
+//
+// Buffer views produced by a stage on one device and consumed by a stage on
+// another device are copied into device-local buffers of the consuming device
+// with iree_hal_device_transfer_range on the consuming device. Devices that
+// support direct access to each other perform these as peer-to-peer copies
+// without staging through the host; for CUDA devices peer access must first be
+// enabled with iree_hal_cuda_device_enable_peer_access.
+//
+// Callers use iree_runtime_pipeline_call from as many threads as they want and
+// calls flow through the stages in order: while one call executes a stage the
+// next call may execute the preceding stage such that all devices are kept
+// busy when there are at least as many concurrent calls as stages. Each stage
+// executes a single call at a time and callers must not concurrently use the
+// stage sessions for other calls while the pipeline is in use.
+//
+// Thread-safe.
+typedef struct iree_runtime_pipeline_t iree_runtime_pipeline_t;
+
+// Creates a pipeline executing the given |stages| in order.
+// At least one stage must be provided and all stage sessions are retained by
+// the pipeline.
+IREE_API_EXPORT iree_status_t iree_runtime_pipeline_create(
+    iree_host_size_t stage_count, const iree_runtime_pipeline_stage_t* stages,
+    iree_allocator_t host_allocator, iree_runtime_pipeline_t** out_pipeline);
+
+// Retains the given |pipeline| for the caller.
+IREE_API_EXPORT void iree_runtime_pipeline_retain(
+    iree_runtime_pipeline_t* pipeline);
+
+// Releases the given |pipeline| from the caller.
+// No calls may be in progress when the last reference is released.
+IREE_API_EXPORT void iree_runtime_pipeline_release(
+    iree_runtime_pipeline_t* pipeline);
+
+// Synchronously invokes all stages of the pipeline in order.
+//
+// |inputs| must match the signature of the first stage function and be
+// compatible with the device of the first stage. |outputs| is populated after
+// the last stage completes with its outputs. List ownership remains with the
+// caller.
+//
+// Blocks until the last stage completes. If any stage fails the call fails
+// with its status and the remaining stages are not executed.
+IREE_API_EXPORT iree_status_t iree_runtime_pipeline_call(
+    iree_runtime_pipeline_t* pipeline, iree_vm_list_t* inputs,
+    iree_vm_list_t* outputs);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_RUNTIME_PIPELINE_H_
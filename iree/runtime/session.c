@@ -11,8 +11,11 @@
 
 #include "iree/base/internal/atomics.h"
 #include "iree/base/internal/file_io.h"
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/internal/threading.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/api.h"
+#include "iree/hal/utils/budget_allocator.h"
 #include "iree/modules/hal/module.h"
 #include "iree/runtime/instance.h"
 #include "iree/vm/api.h"
@@ -27,12 +30,29 @@ IREE_API_EXPORT void iree_runtime_session_options_initialize(
   memset(out_options, 0, sizeof(*out_options));
   out_options->context_flags = IREE_VM_CONTEXT_FLAG_NONE;
   out_options->builtin_modules = IREE_RUNTIME_SESSION_BUILTIN_ALL;
+  out_options->device_memory_budget = 0;
+  out_options->device_memory_budget_wait = IREE_DURATION_INFINITE;
 }
 
 //===----------------------------------------------------------------------===//
 // iree_runtime_session_t
 //===----------------------------------------------------------------------===//
 
+// An asynchronous call queued for execution on the session worker.
+typedef struct iree_runtime_session_async_call_t {
+  struct iree_runtime_session_async_call_t* next;
+  iree_vm_function_t function;
+  // Lists and semaphores are retained until the call completes.
+  iree_vm_list_t* input_list;
+  iree_vm_list_t* output_list;
+  // Optional semaphore the call waits on before executing.
+  iree_hal_semaphore_t* wait_semaphore;
+  uint64_t wait_value;
+  // Semaphore signaled (or failed) when the call completes.
+  iree_hal_semaphore_t* signal_semaphore;
+  uint64_t signal_value;
+} iree_runtime_session_async_call_t;
+
 struct iree_runtime_session_t {
   iree_atomic_ref_count_t ref_count;
 
@@ -61,8 +81,68 @@ struct iree_runtime_session_t {
   // lookup. An application directly using the API may never need this, or could
   // perform VM calls into HAL module exports to gain more portability.
   iree_vm_module_state_t* hal_module_state;
+
+  // The HAL module the state above belongs to; retained by the context.
+  iree_vm_module_t* hal_module;
+
+  // Budget allocator wrapping the device allocator used for all allocations
+  // made by the session or NULL if the session has no device memory budget.
+  iree_hal_allocator_t* device_allocator;
+  iree_hal_budget_allocator_params_t device_memory_budget;
+
+  // Worker executing asynchronous calls in submission order.
+  // The thread is created on the first asynchronous call.
+  struct {
+    // Guards the queue, thread creation, and exit flag.
+    iree_slim_mutex_t mutex;
+    iree_runtime_session_async_call_t* queue_head;
+    iree_runtime_session_async_call_t* queue_tail;
+    bool exit_requested;
+    // Posted when calls are enqueued, exit is requested, or the worker exits.
+    iree_notification_t notification;
+    iree_thread_t* thread;
+    // Set by the worker once it has drained the queue and is exiting.
+    iree_atomic_int32_t has_exited;
+    // VM stack storage retained across calls; only used by the worker.
+    iree_byte_span_t stack_storage;
+  } async;
 };
 
+// Allocates a session within |instance| without a context.
+static iree_status_t iree_runtime_session_allocate(
+    iree_runtime_instance_t* instance, iree_allocator_t host_allocator,
+    iree_runtime_session_t** out_session) {
+  iree_runtime_session_t* session = NULL;
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(host_allocator, sizeof(*session),
+                                             (void**)&session));
+  session->host_allocator = host_allocator;
+  iree_atomic_ref_count_init(&session->ref_count);
+  iree_slim_mutex_initialize(&session->async.mutex);
+  iree_notification_initialize(&session->async.notification);
+
+  session->instance = instance;
+  iree_runtime_instance_retain(session->instance);
+
+  *out_session = session;
+  return iree_ok_status();
+}
+
+// Routes all allocations made by |session| through a budget allocator limiting
+// them to |params| if the budget is set.
+static iree_status_t iree_runtime_session_initialize_budget(
+    iree_runtime_session_t* session,
+    const iree_hal_budget_allocator_params_t* params) {
+  session->device_memory_budget = *params;
+  if (params->max_allocated_bytes == 0) return iree_ok_status();
+  IREE_RETURN_IF_ERROR(iree_hal_budget_allocator_create(
+      iree_hal_device_allocator(
+          iree_hal_module_state_device(session->hal_module_state)),
+      params, session->host_allocator, &session->device_allocator));
+  iree_hal_module_state_set_device_allocator(session->hal_module_state,
+                                             session->device_allocator);
+  return iree_ok_status();
+}
+
 IREE_API_EXPORT iree_status_t iree_runtime_session_create_with_device(
     iree_runtime_instance_t* instance,
     const iree_runtime_session_options_t* options, iree_hal_device_t* device,
@@ -77,13 +157,7 @@ IREE_API_EXPORT iree_status_t iree_runtime_session_create_with_device(
   // Allocate the session state.
   iree_runtime_session_t* session = NULL;
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
-      z0, iree_allocator_malloc(host_allocator, sizeof(*session),
-                                (void**)&session));
-  session->host_allocator = host_allocator;
-  iree_atomic_ref_count_init(&session->ref_count);
-
-  session->instance = instance;
-  iree_runtime_instance_retain(session->instance);
+      z0, iree_runtime_session_allocate(instance, host_allocator, &session));
 
   // Create the context empty so that we can add our modules to it.
   iree_status_t status = iree_vm_context_create(
@@ -94,16 +168,26 @@ IREE_API_EXPORT iree_status_t iree_runtime_session_create_with_device(
   // Lower-level usage of the VM can avoid the HAL if it's not required.
   iree_vm_module_t* hal_module = NULL;
   if (iree_status_is_ok(status)) {
-    status = iree_hal_module_create(device, host_allocator, &hal_module);
+    status = iree_hal_module_create_with_executable_registry(
+        device, iree_runtime_instance_executable_registry(instance),
+        host_allocator, &hal_module);
   }
   if (iree_status_is_ok(status)) {
     status = iree_vm_context_register_modules(session->context, &hal_module, 1);
   }
   if (iree_status_is_ok(status)) {
+    session->hal_module = hal_module;
     status = iree_vm_context_resolve_module_state(session->context, hal_module,
                                                   &session->hal_module_state);
   }
   iree_vm_module_release(hal_module);
+  if (iree_status_is_ok(status)) {
+    iree_hal_budget_allocator_params_t budget_params;
+    iree_hal_budget_allocator_params_initialize(&budget_params);
+    budget_params.max_allocated_bytes = options->device_memory_budget;
+    budget_params.max_wait_duration = options->device_memory_budget_wait;
+    status = iree_runtime_session_initialize_budget(session, &budget_params);
+  }
 
   if (iree_status_is_ok(status)) {
     *out_session = session;
@@ -114,11 +198,77 @@ IREE_API_EXPORT iree_status_t iree_runtime_session_create_with_device(
   return status;
 }
 
+IREE_API_EXPORT iree_status_t iree_runtime_session_fork(
+    const iree_runtime_session_t* session, iree_allocator_t host_allocator,
+    iree_runtime_session_t** out_session) {
+  IREE_ASSERT_ARGUMENT(session);
+  IREE_ASSERT_ARGUMENT(out_session);
+  *out_session = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_runtime_session_t* forked_session = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_runtime_session_allocate(session->instance, host_allocator,
+                                        &forked_session));
+
+  // Clone the context with all loaded modules; this skips module
+  // initialization for all modules that support cloning their state.
+  iree_status_t status = iree_vm_context_clone(session->context, host_allocator,
+                                               &forked_session->context);
+  if (iree_status_is_ok(status)) {
+    forked_session->hal_module = session->hal_module;
+    status = iree_vm_context_resolve_module_state(
+        forked_session->context, forked_session->hal_module,
+        &forked_session->hal_module_state);
+  }
+  if (iree_status_is_ok(status)) {
+    // The forked session gets its own budget of the same size in place of the
+    // budget allocator inherited by the cloned HAL module state.
+    iree_hal_module_state_set_device_allocator(forked_session->hal_module_state,
+                                               NULL);
+    status = iree_runtime_session_initialize_budget(
+        forked_session, &session->device_memory_budget);
+  }
+
+  if (iree_status_is_ok(status)) {
+    *out_session = forked_session;
+  } else {
+    iree_runtime_session_release(forked_session);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+static bool iree_runtime_session_async_worker_has_exited(void* arg) {
+  iree_runtime_session_t* session = (iree_runtime_session_t*)arg;
+  return iree_atomic_load_int32(&session->async.has_exited,
+                                iree_memory_order_acquire) != 0;
+}
+
 static void iree_runtime_session_destroy(iree_runtime_session_t* session) {
   IREE_ASSERT_ARGUMENT(session);
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  // The worker drains any remaining asynchronous calls before exiting. A
+  // thread that has not yet started holds its own reference such that
+  // releasing ours would not join it so we wait for the worker to exit first.
+  if (session->async.thread) {
+    iree_slim_mutex_lock(&session->async.mutex);
+    session->async.exit_requested = true;
+    iree_slim_mutex_unlock(&session->async.mutex);
+    iree_notification_post(&session->async.notification, IREE_ALL_WAITERS);
+    iree_notification_await(&session->async.notification,
+                            iree_runtime_session_async_worker_has_exited,
+                            session, iree_infinite_timeout());
+    iree_thread_release(session->async.thread);
+  }
+  iree_allocator_free(session->host_allocator,
+                      session->async.stack_storage.data);
+  iree_notification_deinitialize(&session->async.notification);
+  iree_slim_mutex_deinitialize(&session->async.mutex);
+
   iree_vm_context_release(session->context);
+  iree_hal_allocator_release(session->device_allocator);
   iree_runtime_instance_release(session->instance);
 
   iree_allocator_free(session->host_allocator, session);
@@ -166,6 +316,7 @@ IREE_API_EXPORT iree_hal_device_t* iree_runtime_session_device(
 
 IREE_API_EXPORT iree_hal_allocator_t* iree_runtime_session_device_allocator(
     const iree_runtime_session_t* session) {
+  if (session->device_allocator) return session->device_allocator;
   iree_hal_device_t* device = iree_runtime_session_device(session);
   if (!device) return NULL;
   return iree_hal_device_allocator(device);
@@ -223,23 +374,21 @@ iree_runtime_session_append_bytecode_module_from_file(
   IREE_TRACE_ZONE_BEGIN(z0);
   IREE_TRACE_ZONE_APPEND_TEXT(z0, file_path);
 
-  // TODO(#3909): actually map the memory here. For now we just load the
-  // contents.
-  iree_allocator_t flatbuffer_allocator =
-      iree_runtime_session_host_allocator(session);
-  iree_byte_span_t flatbuffer_data;
+  // Map the file contents into memory, where supported, such that the module
+  // and any rodata it references alias the file without a copy. The module
+  // takes ownership of the mapping and unmaps it when destroyed.
+  iree_const_byte_span_t flatbuffer_data = iree_const_byte_span_empty();
+  iree_allocator_t flatbuffer_allocator = iree_allocator_null();
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
-      z0, iree_file_read_contents(file_path, flatbuffer_allocator,
-                                  &flatbuffer_data));
+      z0, iree_file_map_contents(file_path,
+                                 iree_runtime_session_host_allocator(session),
+                                 &flatbuffer_data, &flatbuffer_allocator));
 
   iree_status_t status =
       iree_runtime_session_append_bytecode_module_from_memory(
-          session,
-          iree_make_const_byte_span(flatbuffer_data.data,
-                                    flatbuffer_data.data_length),
-          flatbuffer_allocator);
+          session, flatbuffer_data, flatbuffer_allocator);
   if (!iree_status_is_ok(status)) {
-    iree_allocator_free(flatbuffer_allocator, flatbuffer_data.data);
+    iree_allocator_free(flatbuffer_allocator, (void*)flatbuffer_data.data);
   }
 
   IREE_TRACE_ZONE_END(z0);
@@ -260,6 +409,22 @@ IREE_API_EXPORT iree_status_t iree_runtime_session_lookup_function(
   return status;
 }
 
+IREE_API_EXPORT iree_status_t iree_runtime_session_admit_call(
+    iree_runtime_session_t* session, const iree_vm_function_t* function) {
+  IREE_ASSERT_ARGUMENT(session);
+  IREE_ASSERT_ARGUMENT(function);
+  if (!session->device_allocator) return iree_ok_status();
+  iree_string_view_t transient_size_str = iree_vm_function_reflection_attr(
+      function, iree_make_cstring_view("iree.peak_transient_size"));
+  uint64_t transient_size = 0;
+  if (iree_string_view_is_empty(transient_size_str) ||
+      !iree_string_view_atoi_uint64(transient_size_str, &transient_size)) {
+    return iree_ok_status();
+  }
+  return iree_hal_budget_allocator_admit(session->device_allocator,
+                                         transient_size);
+}
+
 IREE_API_EXPORT iree_status_t iree_runtime_session_call(
     iree_runtime_session_t* session, const iree_vm_function_t* function,
     iree_vm_list_t* input_list, iree_vm_list_t* output_list) {
@@ -267,6 +432,8 @@ IREE_API_EXPORT iree_status_t iree_runtime_session_call(
   IREE_ASSERT_ARGUMENT(function);
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_runtime_session_admit_call(session, function));
   iree_status_t status =
       iree_vm_invoke(iree_runtime_session_context(session), *function,
                      IREE_VM_INVOCATION_FLAG_NONE,
@@ -287,6 +454,152 @@ IREE_API_EXPORT iree_status_t iree_runtime_session_call_by_name(
   return iree_runtime_session_call(session, &function, input_list, output_list);
 }
 
+// Executes a single asynchronous |call| on the session worker and signals (or
+// fails) its semaphore. Releases all resources retained by the call.
+static void iree_runtime_session_async_call_run(
+    iree_runtime_session_t* session, iree_runtime_session_async_call_t* call) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_status_t status =
+      iree_runtime_session_admit_call(session, &call->function);
+  if (iree_status_is_ok(status) && call->wait_semaphore) {
+    status = iree_hal_semaphore_wait(call->wait_semaphore, call->wait_value,
+                                     iree_infinite_timeout());
+  }
+
+  if (iree_status_is_ok(status)) {
+    iree_host_size_t stack_storage_capacity = 0;
+    status = iree_vm_invoke_with_stack_storage(
+        session->context, call->function, IREE_VM_INVOCATION_FLAG_NONE,
+        /*policy=*/NULL, call->input_list, call->output_list,
+        session->async.stack_storage, session->host_allocator,
+        &stack_storage_capacity);
+
+    // Grow the retained stack storage to what the call required so that
+    // subsequent calls need not grow it; see iree_runtime_call_invoke.
+    if (iree_status_is_ok(status) &&
+        stack_storage_capacity > session->async.stack_storage.data_length) {
+      void* new_storage = NULL;
+      if (iree_status_consume_code(iree_allocator_malloc(
+              session->host_allocator, stack_storage_capacity,
+              &new_storage)) == IREE_STATUS_OK) {
+        iree_allocator_free(session->host_allocator,
+                            session->async.stack_storage.data);
+        session->async.stack_storage =
+            iree_make_byte_span(new_storage, stack_storage_capacity);
+      }
+    }
+  }
+
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_semaphore_signal(call->signal_semaphore,
+                                       call->signal_value);
+  }
+  if (!iree_status_is_ok(status)) {
+    iree_hal_semaphore_fail(call->signal_semaphore, status);
+  }
+
+  iree_hal_semaphore_release(call->signal_semaphore);
+  iree_hal_semaphore_release(call->wait_semaphore);
+  iree_vm_list_release(call->output_list);
+  iree_vm_list_release(call->input_list);
+  iree_allocator_free(session->host_allocator, call);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+static int iree_runtime_session_async_worker_main(void* entry_arg) {
+  iree_runtime_session_t* session = (iree_runtime_session_t*)entry_arg;
+  for (;;) {
+    iree_wait_token_t wait_token =
+        iree_notification_prepare_wait(&session->async.notification);
+    iree_slim_mutex_lock(&session->async.mutex);
+    iree_runtime_session_async_call_t* call = session->async.queue_head;
+    if (call) {
+      session->async.queue_head = call->next;
+      if (!session->async.queue_head) session->async.queue_tail = NULL;
+    }
+    bool exit_requested = session->async.exit_requested;
+    iree_slim_mutex_unlock(&session->async.mutex);
+
+    if (call) {
+      iree_notification_cancel_wait(&session->async.notification);
+      iree_runtime_session_async_call_run(session, call);
+    } else if (exit_requested) {
+      iree_notification_cancel_wait(&session->async.notification);
+      iree_atomic_store_int32(&session->async.has_exited, 1,
+                              iree_memory_order_release);
+      iree_notification_post(&session->async.notification, IREE_ALL_WAITERS);
+      break;
+    } else {
+      iree_notification_commit_wait(&session->async.notification, wait_token,
+                                    IREE_TIME_INFINITE_FUTURE);
+    }
+  }
+  return 0;
+}
+
+IREE_API_EXPORT iree_status_t iree_runtime_session_call_async(
+    iree_runtime_session_t* session, const iree_vm_function_t* function,
+    iree_vm_list_t* input_list, iree_vm_list_t* output_list,
+    iree_hal_semaphore_t* wait_semaphore, uint64_t wait_value,
+    iree_hal_semaphore_t* signal_semaphore, uint64_t signal_value) {
+  IREE_ASSERT_ARGUMENT(session);
+  IREE_ASSERT_ARGUMENT(function);
+  IREE_ASSERT_ARGUMENT(signal_semaphore);
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_runtime_session_async_call_t* call = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(session->host_allocator, sizeof(*call),
+                                (void**)&call));
+  call->function = *function;
+  call->input_list = input_list;
+  iree_vm_list_retain(input_list);
+  call->output_list = output_list;
+  iree_vm_list_retain(output_list);
+  call->wait_semaphore = wait_semaphore;
+  iree_hal_semaphore_retain(wait_semaphore);
+  call->wait_value = wait_value;
+  call->signal_semaphore = signal_semaphore;
+  iree_hal_semaphore_retain(signal_semaphore);
+  call->signal_value = signal_value;
+
+  iree_status_t status = iree_ok_status();
+  iree_slim_mutex_lock(&session->async.mutex);
+  if (!session->async.thread) {
+    iree_thread_create_params_t thread_params;
+    memset(&thread_params, 0, sizeof(thread_params));
+    thread_params.name = iree_make_cstring_view("iree-session-async");
+    thread_params.priority_class = IREE_THREAD_PRIORITY_CLASS_NORMAL;
+    status = iree_thread_create(iree_runtime_session_async_worker_main,
+                                session, thread_params,
+                                session->host_allocator,
+                                &session->async.thread);
+  }
+  if (iree_status_is_ok(status)) {
+    if (session->async.queue_tail) {
+      session->async.queue_tail->next = call;
+    } else {
+      session->async.queue_head = call;
+    }
+    session->async.queue_tail = call;
+  }
+  iree_slim_mutex_unlock(&session->async.mutex);
+
+  if (iree_status_is_ok(status)) {
+    iree_notification_post(&session->async.notification, 1);
+  } else {
+    iree_hal_semaphore_release(call->signal_semaphore);
+    iree_hal_semaphore_release(call->wait_semaphore);
+    iree_vm_list_release(call->output_list);
+    iree_vm_list_release(call->input_list);
+    iree_allocator_free(session->host_allocator, call);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
 IREE_API_EXPORT iree_status_t iree_runtime_session_call_direct(
     iree_runtime_session_t* session, const iree_vm_function_call_t* call) {
   IREE_ASSERT_ARGUMENT(session);
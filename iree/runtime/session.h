@@ -61,6 +61,17 @@ typedef struct iree_runtime_session_options_t {
   // Session creation will fail if a requested module is not built into the
   // runtime binary.
   iree_runtime_session_builtins_t builtin_modules;
+
+  // Total size in bytes of the device buffers the session may have live at
+  // once, including those allocated by the caller from
+  // iree_runtime_session_device_allocator. 0 disables the budget.
+  // See iree/hal/utils/budget_allocator.h.
+  iree_device_size_t device_memory_budget;
+
+  // Maximum duration an allocation that would exceed the device memory budget
+  // waits for other buffers of the session to be released (such as those in
+  // use by outstanding asynchronous calls) before failing.
+  iree_duration_t device_memory_budget_wait;
 } iree_runtime_session_options_t;
 
 // Initializes |out_options| to its default values.
@@ -88,6 +99,24 @@ IREE_API_EXPORT iree_status_t iree_runtime_session_create_with_device(
     const iree_runtime_session_options_t* options, iree_hal_device_t* device,
     iree_allocator_t host_allocator, iree_runtime_session_t** out_session);
 
+// Creates a new session with a copy of the context of |session|.
+// Rather than rerunning module initialization (such as uploading constants and
+// preparing executables) the state of each loaded module is cloned: immutable
+// resources and HAL objects are shared with |session| and mutable globals are
+// copied such that the sessions execute independently after forking. See
+// iree_vm_context_clone for details.
+//
+// This allows a fully-initialized session to be used as a template for cheaply
+// creating per-request or per-client sessions. |session| must not be used
+// concurrently while forking and no modules can be appended to the forked
+// session.
+//
+// |host_allocator| will be used to allocate the session and any associated
+// resources. |out_session| must be released by the caller.
+IREE_API_EXPORT iree_status_t iree_runtime_session_fork(
+    const iree_runtime_session_t* session, iree_allocator_t host_allocator,
+    iree_runtime_session_t** out_session);
+
 // Retains the given |session| for the caller.
 IREE_API_EXPORT void iree_runtime_session_retain(
     iree_runtime_session_t* session);
@@ -121,7 +150,9 @@ IREE_API_EXPORT iree_hal_device_t* iree_runtime_session_device(
 
 // Returns the device allocator used to allocate compatible buffers.
 // Buffers from other allocators may not be compatible and require importing
-// prior to being usable by the session.
+// prior to being usable by the session. When the session has a device memory
+// budget the allocator counts buffers against it and all buffers allocated
+// from it must be released before the session.
 //
 // NOTE: this device allocator will not be available until initialized by a
 // user module and will return NULL if queried prior.
@@ -183,6 +214,15 @@ IREE_API_EXPORT iree_status_t iree_runtime_session_lookup_function(
     const iree_runtime_session_t* session, iree_string_view_t full_name,
     iree_vm_function_t* out_function);
 
+// Checks whether a call to |function| can be admitted under the device memory
+// budget of |session|. Functions are annotated by the compiler with the peak
+// size of the transient memory they require when it is known statically.
+// Returns IREE_STATUS_RESOURCE_EXHAUSTED if it exceeds the entire budget such
+// that the call can be rejected before it starts instead of failing partway
+// through. Calls issued through the session are checked automatically.
+IREE_API_EXPORT iree_status_t iree_runtime_session_admit_call(
+    iree_runtime_session_t* session, const iree_vm_function_t* function);
+
 // Synchronously issues a generic function call.
 //
 // |input_list| is used to pass values and objects into the target function and
@@ -208,6 +248,27 @@ IREE_API_EXPORT iree_status_t iree_runtime_session_call_by_name(
     iree_runtime_session_t* session, iree_string_view_t full_name,
     iree_vm_list_t* input_list, iree_vm_list_t* output_list);
 
+// Asynchronously issues a generic function call.
+//
+// The call is enqueued on a session worker thread and this returns as soon as
+// it has been enqueued such that the caller can continue preparing subsequent
+// requests while the call executes. Calls are executed in the order they are
+// enqueued. When |wait_semaphore| is provided the call will not begin until it
+// reaches |wait_value|. Upon completion |signal_semaphore| is signaled to
+// |signal_value| or failed with the status of the call.
+//
+// |input_list| and |output_list| are retained until the call completes. The
+// caller must not modify |input_list| or access |output_list| until
+// |signal_semaphore| has been signaled.
+//
+// The session context is thread-compatible and callers must not issue
+// synchronous calls on the session while asynchronous calls are outstanding.
+IREE_API_EXPORT iree_status_t iree_runtime_session_call_async(
+    iree_runtime_session_t* session, const iree_vm_function_t* function,
+    iree_vm_list_t* input_list, iree_vm_list_t* output_list,
+    iree_hal_semaphore_t* wait_semaphore, uint64_t wait_value,
+    iree_hal_semaphore_t* signal_semaphore, uint64_t signal_value);
+
 // Synchronously issues a direct function call.
 // This bypasses signature verification and directly calls through the VM ABI.
 // Though still safe(ish) the errors reported on a signature mismatch will be
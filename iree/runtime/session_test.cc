@@ -0,0 +1,267 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/runtime/session.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/modules/hal/module.h"
+#include "iree/runtime/api.h"
+#include "iree/runtime/testdata/simple_mul_module_c.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+#include "iree/vm/api.h"
+
+namespace {
+
+// Bounds all waits in these tests so that a lost signal fails the test instead
+// of hanging it.
+static const iree_duration_t kWaitTimeoutNs = 10 * 1000000000ll;
+
+// Number of elements in each simple_mul operand.
+static const iree_host_size_t kElementCount = 4;
+
+class SessionAsyncTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    iree_runtime_instance_options_t instance_options;
+    iree_runtime_instance_options_initialize(IREE_API_VERSION_LATEST,
+                                             &instance_options);
+    iree_runtime_instance_options_use_all_available_drivers(&instance_options);
+    IREE_ASSERT_OK(iree_runtime_instance_create(
+        &instance_options, iree_allocator_system(), &instance_));
+
+    IREE_ASSERT_OK(iree_runtime_instance_try_create_default_device(
+        instance_, iree_make_cstring_view("vmvx-sync"), &device_));
+    iree_runtime_session_options_t session_options;
+    iree_runtime_session_options_initialize(&session_options);
+    IREE_ASSERT_OK(iree_runtime_session_create_with_device(
+        instance_, &session_options, device_, iree_allocator_system(),
+        &session_));
+
+    const iree_file_toc_t* module_file =
+        iree_runtime_testdata_simple_mul_module_create();
+    IREE_ASSERT_OK(iree_runtime_session_append_bytecode_module_from_memory(
+        session_,
+        iree_make_const_byte_span(module_file->data, module_file->size),
+        iree_allocator_null()));
+    IREE_ASSERT_OK(iree_runtime_session_lookup_function(
+        session_, iree_make_cstring_view("module.simple_mul"), &function_));
+  }
+
+  void TearDown() override {
+    iree_runtime_session_release(session_);
+    iree_hal_device_release(device_);
+    iree_runtime_instance_release(instance_);
+  }
+
+  iree_hal_semaphore_t* CreateSemaphore() {
+    iree_hal_semaphore_t* semaphore = NULL;
+    IREE_CHECK_OK(iree_hal_semaphore_create(device_, 0ull, &semaphore));
+    return semaphore;
+  }
+
+  // Returns a new list holding |input_count| operands of |value|.
+  iree_vm_list_t* CreateInputs(float value, iree_host_size_t input_count = 2) {
+    iree_vm_list_t* list = NULL;
+    IREE_CHECK_OK(iree_vm_list_create(/*element_type=*/NULL, input_count,
+                                      iree_allocator_system(), &list));
+    std::vector<float> values(kElementCount, value);
+    iree_hal_dim_t shape[1] = {(iree_hal_dim_t)kElementCount};
+    for (iree_host_size_t i = 0; i < input_count; ++i) {
+      iree_hal_buffer_view_t* buffer_view = NULL;
+      IREE_CHECK_OK(iree_hal_buffer_view_allocate_buffer(
+          iree_runtime_session_device_allocator(session_), shape,
+          IREE_ARRAYSIZE(shape), IREE_HAL_ELEMENT_TYPE_FLOAT_32,
+          IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR,
+          IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL, IREE_HAL_BUFFER_USAGE_ALL,
+          iree_make_const_byte_span(values.data(),
+                                    values.size() * sizeof(float)),
+          &buffer_view));
+      iree_vm_ref_t buffer_view_ref =
+          iree_hal_buffer_view_move_ref(buffer_view);
+      IREE_CHECK_OK(iree_vm_list_push_ref_move(list, &buffer_view_ref));
+    }
+    return list;
+  }
+
+  iree_vm_list_t* CreateOutputs() {
+    iree_vm_list_t* list = NULL;
+    IREE_CHECK_OK(iree_vm_list_create(/*element_type=*/NULL, 1,
+                                      iree_allocator_system(), &list));
+    return list;
+  }
+
+  // Checks that |outputs| holds the square of |value| from CreateInputs.
+  void ExpectSquare(iree_vm_list_t* outputs, float value) {
+    ASSERT_EQ(1, iree_vm_list_size(outputs));
+    iree_hal_buffer_view_t* output =
+        (iree_hal_buffer_view_t*)iree_vm_list_get_ref_deref(
+            outputs, 0, iree_hal_buffer_view_get_descriptor());
+    ASSERT_TRUE(output);
+    std::vector<float> values(kElementCount);
+    IREE_ASSERT_OK(iree_hal_device_transfer_range(
+        device_,
+        iree_hal_make_device_transfer_buffer(
+            iree_hal_buffer_view_buffer(output)),
+        0,
+        iree_hal_make_host_transfer_buffer_span(
+            values.data(), values.size() * sizeof(float)),
+        0, values.size() * sizeof(float), IREE_HAL_TRANSFER_BUFFER_FLAG_DEFAULT,
+        iree_infinite_timeout()));
+    for (size_t i = 0; i < values.size(); ++i) {
+      EXPECT_EQ(value * value, values[i]) << "element " << i;
+    }
+  }
+
+  iree_runtime_instance_t* instance_ = NULL;
+  iree_hal_device_t* device_ = NULL;
+  iree_runtime_session_t* session_ = NULL;
+  iree_vm_function_t function_;
+};
+
+// Signals the semaphore once the call completes with its results.
+TEST_F(SessionAsyncTest, CallSignalsSemaphore) {
+  iree_hal_semaphore_t* semaphore = CreateSemaphore();
+  iree_vm_list_t* inputs = CreateInputs(3.0f);
+  iree_vm_list_t* outputs = CreateOutputs();
+
+  IREE_ASSERT_OK(iree_runtime_session_call_async(
+      session_, &function_, inputs, outputs, /*wait_semaphore=*/NULL, 0ull,
+      semaphore, 1ull));
+  IREE_ASSERT_OK(
+      iree_hal_semaphore_wait(semaphore, 1ull, iree_make_timeout(kWaitTimeoutNs)));
+  ExpectSquare(outputs, 3.0f);
+
+  iree_vm_list_release(outputs);
+  iree_vm_list_release(inputs);
+  iree_hal_semaphore_release(semaphore);
+}
+
+// Does not begin the call until the wait semaphore reaches its value.
+TEST_F(SessionAsyncTest, CallWaitsOnSemaphore) {
+  iree_hal_semaphore_t* wait_semaphore = CreateSemaphore();
+  iree_hal_semaphore_t* signal_semaphore = CreateSemaphore();
+  iree_vm_list_t* inputs = CreateInputs(2.0f);
+  iree_vm_list_t* outputs = CreateOutputs();
+
+  IREE_ASSERT_OK(iree_runtime_session_call_async(
+      session_, &function_, inputs, outputs, wait_semaphore, 1ull,
+      signal_semaphore, 1ull));
+  iree_status_t status = iree_hal_semaphore_wait(
+      signal_semaphore, 1ull, iree_make_timeout(100 * 1000000ll));
+  EXPECT_EQ(IREE_STATUS_DEADLINE_EXCEEDED, iree_status_code(status));
+  iree_status_ignore(status);
+
+  IREE_ASSERT_OK(iree_hal_semaphore_signal(wait_semaphore, 1ull));
+  IREE_ASSERT_OK(iree_hal_semaphore_wait(signal_semaphore, 1ull,
+                                         iree_make_timeout(kWaitTimeoutNs)));
+  ExpectSquare(outputs, 2.0f);
+
+  iree_vm_list_release(outputs);
+  iree_vm_list_release(inputs);
+  iree_hal_semaphore_release(signal_semaphore);
+  iree_hal_semaphore_release(wait_semaphore);
+}
+
+// Fails the signal semaphore with the status of a failing call and leaves the
+// session usable for subsequent calls.
+TEST_F(SessionAsyncTest, CallFailureFailsSemaphore) {
+  iree_hal_semaphore_t* semaphore = CreateSemaphore();
+  // simple_mul takes two inputs; invoking it with one fails the call.
+  iree_vm_list_t* inputs = CreateInputs(1.0f, /*input_count=*/1);
+  iree_vm_list_t* outputs = CreateOutputs();
+
+  IREE_ASSERT_OK(iree_runtime_session_call_async(
+      session_, &function_, inputs, outputs, /*wait_semaphore=*/NULL, 0ull,
+      semaphore, 1ull));
+  iree_status_t status =
+      iree_hal_semaphore_wait(semaphore, 1ull, iree_make_timeout(kWaitTimeoutNs));
+  EXPECT_EQ(IREE_STATUS_ABORTED, iree_status_code(status));
+  iree_status_ignore(status);
+  uint64_t value = 0;
+  status = iree_hal_semaphore_query(semaphore, &value);
+  EXPECT_NE(IREE_STATUS_OK, iree_status_code(status));
+  EXPECT_NE(IREE_STATUS_ABORTED, iree_status_code(status));
+  iree_status_ignore(status);
+  iree_vm_list_release(outputs);
+  iree_vm_list_release(inputs);
+  iree_hal_semaphore_release(semaphore);
+
+  semaphore = CreateSemaphore();
+  inputs = CreateInputs(4.0f);
+  outputs = CreateOutputs();
+  IREE_ASSERT_OK(iree_runtime_session_call_async(
+      session_, &function_, inputs, outputs, /*wait_semaphore=*/NULL, 0ull,
+      semaphore, 1ull));
+  IREE_ASSERT_OK(
+      iree_hal_semaphore_wait(semaphore, 1ull, iree_make_timeout(kWaitTimeoutNs)));
+  ExpectSquare(outputs, 4.0f);
+  iree_vm_list_release(outputs);
+  iree_vm_list_release(inputs);
+  iree_hal_semaphore_release(semaphore);
+}
+
+// Fails the call without executing it when its wait semaphore fails.
+TEST_F(SessionAsyncTest, WaitFailureFailsCall) {
+  iree_hal_semaphore_t* wait_semaphore = CreateSemaphore();
+  iree_hal_semaphore_t* signal_semaphore = CreateSemaphore();
+  iree_vm_list_t* inputs = CreateInputs(2.0f);
+  iree_vm_list_t* outputs = CreateOutputs();
+
+  IREE_ASSERT_OK(iree_runtime_session_call_async(
+      session_, &function_, inputs, outputs, wait_semaphore, 1ull,
+      signal_semaphore, 1ull));
+  iree_hal_semaphore_fail(wait_semaphore,
+                          iree_status_from_code(IREE_STATUS_DATA_LOSS));
+  iree_status_t status = iree_hal_semaphore_wait(
+      signal_semaphore, 1ull, iree_make_timeout(kWaitTimeoutNs));
+  EXPECT_EQ(IREE_STATUS_ABORTED, iree_status_code(status));
+  iree_status_ignore(status);
+  EXPECT_EQ(0, iree_vm_list_size(outputs));
+
+  iree_vm_list_release(outputs);
+  iree_vm_list_release(inputs);
+  iree_hal_semaphore_release(signal_semaphore);
+  iree_hal_semaphore_release(wait_semaphore);
+}
+
+// Releasing the session executes all queued calls before returning.
+TEST_F(SessionAsyncTest, ReleaseDrainsQueue) {
+  static const int kCallCount = 8;
+  iree_hal_semaphore_t* wait_semaphore = CreateSemaphore();
+  iree_hal_semaphore_t* signal_semaphore = CreateSemaphore();
+  std::vector<iree_vm_list_t*> inputs(kCallCount);
+  std::vector<iree_vm_list_t*> outputs(kCallCount);
+  for (int i = 0; i < kCallCount; ++i) {
+    inputs[i] = CreateInputs((float)i);
+    outputs[i] = CreateOutputs();
+    // Hold the first call until all are queued so that they are still pending
+    // when the session is released.
+    IREE_ASSERT_OK(iree_runtime_session_call_async(
+        session_, &function_, inputs[i], outputs[i],
+        i == 0 ? wait_semaphore : NULL, 1ull, signal_semaphore, i + 1ull));
+  }
+  IREE_ASSERT_OK(iree_hal_semaphore_signal(wait_semaphore, 1ull));
+  iree_runtime_session_release(session_);
+  session_ = NULL;
+
+  uint64_t value = 0;
+  IREE_ASSERT_OK(iree_hal_semaphore_query(signal_semaphore, &value));
+  EXPECT_EQ((uint64_t)kCallCount, value);
+  for (int i = 0; i < kCallCount; ++i) {
+    ExpectSquare(outputs[i], (float)i);
+    iree_vm_list_release(outputs[i]);
+    iree_vm_list_release(inputs[i]);
+  }
+  iree_hal_semaphore_release(signal_semaphore);
+  iree_hal_semaphore_release(wait_semaphore);
+}
+
+}  // namespace
@@ -0,0 +1,13 @@
+// Elementwise multiplies with a leading batch dimension used by the batcher
+// and session tests. @batch_mul accepts any batch size and example shape while
+// @batch_mul_4 only accepts batches of 4 examples of 4 elements.
+
+func @batch_mul(%arg0: tensor<?x?xf32>, %arg1: tensor<?x?xf32>) -> tensor<?x?xf32> {
+  %0 = "mhlo.multiply"(%arg0, %arg1) : (tensor<?x?xf32>, tensor<?x?xf32>) -> tensor<?x?xf32>
+  return %0 : tensor<?x?xf32>
+}
+
+func @batch_mul_4(%arg0: tensor<4x4xf32>, %arg1: tensor<4x4xf32>) -> tensor<4x4xf32> {
+  %0 = "mhlo.multiply"(%arg0, %arg1) : (tensor<4x4xf32>, tensor<4x4xf32>) -> tensor<4x4xf32>
+  return %0 : tensor<4x4xf32>
+}
@@ -25,12 +25,29 @@ extern "C" {
 // iree_task_affinity_set_t
 //===----------------------------------------------------------------------===//
 
+// A bitmask of workers within a single worker cluster.
+//
+// Executors partition their workers into clusters of up to
+// IREE_TASK_AFFINITY_SET_CLUSTER_WORKER_COUNT workers such that each cluster
+// can be represented with a single machine word. Bit N of the set refers to
+// worker N of a cluster (global worker index = cluster_index * 64 + N).
+//
+// When used as a task affinity the set applies to every cluster: a task with an
+// affinity of 0b101 may be executed by workers 0 and 2 of any cluster. On
+// executors with 64 or fewer workers there is only a single cluster and this
+// is equivalent to a flat worker bitmask.
 typedef uint64_t iree_task_affinity_set_t;
 
+// Number of workers that can be represented within a single cluster.
+#define IREE_TASK_AFFINITY_SET_CLUSTER_WORKER_COUNT \
+  (sizeof(iree_task_affinity_set_t) * 8)
+
 // Allows for only a specific worker to be selected.
+// For executors with more than one cluster this selects the worker with the
+// same position within each cluster.
 static inline iree_task_affinity_set_t iree_task_affinity_for_worker(
-    uint8_t worker_index) {
-  return 1ull << worker_index;
+    iree_host_size_t worker_index) {
+  return 1ull << (worker_index % IREE_TASK_AFFINITY_SET_CLUSTER_WORKER_COUNT);
 }
 
 // Allows for a range of workers to be selected.
@@ -49,6 +66,34 @@ static inline iree_task_affinity_set_t iree_task_affinity_for_any_worker(void) {
 #define iree_task_affinity_set_count_ones iree_math_count_ones_u64
 #define iree_task_affinity_set_rotr iree_math_rotr_u64
 
+//===----------------------------------------------------------------------===//
+// iree_task_cluster_mask_t
+//===----------------------------------------------------------------------===//
+
+// Maximum number of worker clusters an executor may have.
+#define IREE_TASK_EXECUTOR_MAX_CLUSTER_COUNT                                \
+  ((IREE_TASK_EXECUTOR_MAX_WORKER_COUNT +                                   \
+    IREE_TASK_AFFINITY_SET_CLUSTER_WORKER_COUNT - 1) /                      \
+   IREE_TASK_AFFINITY_SET_CLUSTER_WORKER_COUNT)
+
+// A bitmask of worker clusters; bit N refers to cluster N.
+typedef uint64_t iree_task_cluster_mask_t;
+static_assert(IREE_TASK_EXECUTOR_MAX_CLUSTER_COUNT <=
+                  sizeof(iree_task_cluster_mask_t) * 8,
+              "cluster mask must be able to represent all clusters");
+
+// Returns the index of the cluster containing |worker_index|.
+static inline iree_host_size_t iree_task_affinity_cluster_for_worker(
+    iree_host_size_t worker_index) {
+  return worker_index / IREE_TASK_AFFINITY_SET_CLUSTER_WORKER_COUNT;
+}
+
+// Returns the global index of the worker at |bit| within |cluster_index|.
+static inline iree_host_size_t iree_task_affinity_worker_index(
+    iree_host_size_t cluster_index, int bit) {
+  return cluster_index * IREE_TASK_AFFINITY_SET_CLUSTER_WORKER_COUNT + bit;
+}
+
 //===----------------------------------------------------------------------===//
 // iree_atomic_task_affinity_set_t
 //===----------------------------------------------------------------------===//
@@ -78,6 +123,104 @@ static inline iree_task_affinity_set_t iree_atomic_task_affinity_set_fetch_or(
   return iree_atomic_fetch_or_int64(set, value, order);
 }
 
+//===----------------------------------------------------------------------===//
+// iree_atomic_task_worker_set_t
+//===----------------------------------------------------------------------===//
+
+// A two-level set of workers spanning all clusters of an executor.
+//
+// Each cluster has its own word of worker bits on its own cache line so that
+// workers toggling their bits (such as when going idle) only contend with other
+// workers in the same cluster. A summary mask of clusters that may have any
+// worker bits set allows scans to skip empty clusters without touching them:
+// finding an idle worker across 256 workers is a ctz on the summary followed by
+// a ctz on the cluster word instead of a walk over all workers.
+//
+// The summary is conservative: a cluster bit may be set when the cluster has no
+// worker bits set (and scanners must handle finding nothing) but is never clear
+// for a cluster that has bits set once all in-flight updates have completed.
+typedef struct iree_atomic_task_worker_set_t {
+  // Bit N is set if cluster N may have any worker bits set.
+  iree_atomic_int64_t cluster_mask;
+  uint8_t _padding0[iree_hardware_destructive_interference_size -
+                    sizeof(iree_atomic_int64_t)];
+  struct {
+    // Worker bits for the cluster.
+    iree_atomic_task_affinity_set_t worker_mask;
+    uint8_t _padding[iree_hardware_destructive_interference_size -
+                     sizeof(iree_atomic_task_affinity_set_t)];
+  } clusters[IREE_TASK_EXECUTOR_MAX_CLUSTER_COUNT];
+} iree_atomic_task_worker_set_t;
+
+// Returns the summary mask of clusters that may have worker bits set.
+static inline iree_task_cluster_mask_t
+iree_atomic_task_worker_set_load_clusters(iree_atomic_task_worker_set_t* set,
+                                          iree_memory_order_t order) {
+  return (iree_task_cluster_mask_t)iree_atomic_load_int64(&set->cluster_mask,
+                                                          order);
+}
+
+// Returns the worker bits set for |cluster_index|.
+static inline iree_task_affinity_set_t iree_atomic_task_worker_set_load(
+    iree_atomic_task_worker_set_t* set, iree_host_size_t cluster_index,
+    iree_memory_order_t order) {
+  return iree_atomic_task_affinity_set_load(
+      &set->clusters[cluster_index].worker_mask, order);
+}
+
+// Stores the worker bits of |cluster_index| and updates the summary mask.
+// Only safe to use during initialization when no other threads may be
+// accessing the set.
+static inline void iree_atomic_task_worker_set_store(
+    iree_atomic_task_worker_set_t* set, iree_host_size_t cluster_index,
+    iree_task_affinity_set_t value, iree_memory_order_t order) {
+  iree_atomic_task_affinity_set_store(&set->clusters[cluster_index].worker_mask,
+                                      value, order);
+  iree_task_cluster_mask_t cluster_bit = 1ull << cluster_index;
+  if (value) {
+    iree_atomic_fetch_or_int64(&set->cluster_mask, cluster_bit, order);
+  } else {
+    iree_atomic_fetch_and_int64(&set->cluster_mask, ~cluster_bit, order);
+  }
+}
+
+// Sets |worker_bits| in |cluster_index| and returns the prior worker bits.
+static inline iree_task_affinity_set_t iree_atomic_task_worker_set_fetch_or(
+    iree_atomic_task_worker_set_t* set, iree_host_size_t cluster_index,
+    iree_task_affinity_set_t worker_bits, iree_memory_order_t order) {
+  iree_task_affinity_set_t prior_bits = iree_atomic_task_affinity_set_fetch_or(
+      &set->clusters[cluster_index].worker_mask, worker_bits, order);
+  iree_task_cluster_mask_t cluster_bit = 1ull << cluster_index;
+  // Avoid the RMW on the shared summary in the common case of the cluster
+  // already being marked.
+  if (!(iree_atomic_task_worker_set_load_clusters(set, order) & cluster_bit)) {
+    iree_atomic_fetch_or_int64(&set->cluster_mask, cluster_bit, order);
+  }
+  return prior_bits;
+}
+
+// Clears all bits in |cluster_index| that are not in |worker_bits| and returns
+// the prior worker bits.
+static inline iree_task_affinity_set_t iree_atomic_task_worker_set_fetch_and(
+    iree_atomic_task_worker_set_t* set, iree_host_size_t cluster_index,
+    iree_task_affinity_set_t worker_bits, iree_memory_order_t order) {
+  iree_atomic_task_affinity_set_t* cluster_worker_mask =
+      &set->clusters[cluster_index].worker_mask;
+  iree_task_affinity_set_t prior_bits = iree_atomic_task_affinity_set_fetch_and(
+      cluster_worker_mask, worker_bits, order);
+  if (prior_bits && !(prior_bits & worker_bits)) {
+    // We cleared the last bits in the cluster; clear the summary bit and then
+    // recheck in case another thread set new bits in-between the two (it may
+    // have seen the summary bit still set and skipped setting it).
+    iree_task_cluster_mask_t cluster_bit = 1ull << cluster_index;
+    iree_atomic_fetch_and_int64(&set->cluster_mask, ~cluster_bit, order);
+    if (iree_atomic_task_affinity_set_load(cluster_worker_mask, order)) {
+      iree_atomic_fetch_or_int64(&set->cluster_mask, cluster_bit, order);
+    }
+  }
+  return prior_bits;
+}
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
@@ -25,15 +25,52 @@ IREE_FLAG(
     "threads for potential latency additions later on as threads take longer\n"
     "to wake on their first use.");
 
+IREE_FLAG(
+    bool, task_scheduling_weight_by_core_capacity, false,
+    "Weights the number of dispatch tiles each worker reserves at a time by\n"
+    "the relative capacity of its core so that workers on efficiency cores\n"
+    "of heterogeneous (big.LITTLE/hybrid) systems do not delay dispatches by\n"
+    "executing their tail.");
+
+IREE_FLAG(
+    bool, task_scheduling_deterministic, false,
+    "Assigns tasks and dispatch tiles to workers statically, disables work\n"
+    "stealing, and pins workers to their processors so that runs are\n"
+    "reproducible when measuring performance. Any imbalance across workers\n"
+    "directly adds latency; not intended for production use.");
+
+IREE_FLAG(
+    bool, task_scheduling_locality_tile_order, false,
+    "Executes dispatch tiles in column panels instead of linear order so\n"
+    "that tiles executed close together in time share operand data.");
+
+IREE_FLAG(
+    bool, task_scheduling_sticky_tile_affinity, false,
+    "Assigns the same tiles of consecutive dispatches with the same grid to\n"
+    "the same workers so that consumers find the results of their producers\n"
+    "in the private caches of the worker. Disables dynamic balancing of tiles\n"
+    "across workers.");
+
 // TODO(benvanik): enable this when we use it - though hopefully we don't!
 IREE_FLAG(
     int32_t, task_worker_local_memory, 0,  // 64 * 1024,
     "Specifies the bytes of per-worker local memory allocated for use by\n"
-    "dispatched tiles. Tiles may use less than this but will fail to dispatch\n"
-    "if they require more. Conceptually it is like a stack reservation and\n"
-    "should be treated the same way: the source programs must be built to\n"
-    "only use a specific maximum amount of local memory and the runtime must\n"
-    "be configured to make at least that amount of local memory available.");
+    "dispatched tiles when each worker starts. Workers grow their local\n"
+    "memory on demand when tiles require more and keep it at its high-water\n"
+    "mark until trimmed; this only avoids the allocation on first use.");
+
+IREE_FLAG(
+    int32_t, task_worker_spin_us, 0,
+    "Maximum duration in microseconds each worker spins waiting for new work\n"
+    "before parking its thread. Spinning trades CPU time and power for lower\n"
+    "latency when work arrives in quick succession (such as sequences of\n"
+    "small dispatches). 0 parks workers as soon as they run out of work.");
+
+IREE_FLAG(
+    bool, task_worker_spin_adaptive, true,
+    "Adapts the duration each worker spins (up to --task_worker_spin_us)\n"
+    "based on how long it has recently waited for new work. Workers that\n"
+    "usually wait longer than the maximum spin duration park immediately.");
 
 //===----------------------------------------------------------------------===//
 // Topology configuration
@@ -52,7 +89,13 @@ IREE_FLAG(
     "   cores up to the value specified by --task_topology_max_group_count.\n"
     "   This optimizes for temporal and spatial cache locality but may suffer\n"
     "   from oversubscription if there are other processes trying to use the\n"
-    "   same cores.\n");
+    "   same cores.\n"
+    " 'numa_nodes':\n"
+    "   Creates one group per physical core distributed evenly across all\n"
+    "   NUMA nodes up to the value specified by\n"
+    "   --task_topology_max_group_count. Workers keep their local memory on\n"
+    "   their own node and prefer stealing work from workers on the same\n"
+    "   node.\n");
 
 IREE_FLAG(
     int32_t, task_topology_group_count, 0,
@@ -61,6 +104,13 @@ IREE_FLAG(
     "heuristic defined by --task_topology_mode= to automatically select the\n"
     "worker count and distribution.");
 
+IREE_FLAG(
+    int32_t, task_topology_core_class, -1,
+    "Restricts the 'physical_cores' topology mode to only the cores of the\n"
+    "given class on heterogeneous systems: 0 for the highest performance\n"
+    "cores (big/performance cores), 1 for the next class, etc. -1 uses all\n"
+    "cores.");
+
 IREE_FLAG(
     int32_t, task_topology_max_group_count, 8,
     "Sets a maximum value on the worker count that can be automatically\n"
@@ -80,13 +130,28 @@ iree_status_t iree_task_executor_create_from_flags(
   *out_executor = NULL;
   IREE_TRACE_ZONE_BEGIN(z0);
 
-  iree_task_scheduling_mode_t scheduling_mode = 0;
+  iree_task_executor_options_t options;
+  iree_task_executor_options_initialize(&options);
   if (FLAG_task_scheduling_defer_worker_startup) {
-    scheduling_mode |= IREE_TASK_SCHEDULING_MODE_DEFER_WORKER_STARTUP;
+    options.scheduling_mode |= IREE_TASK_SCHEDULING_MODE_DEFER_WORKER_STARTUP;
   }
-
-  iree_host_size_t worker_local_memory =
+  if (FLAG_task_scheduling_weight_by_core_capacity) {
+    options.scheduling_mode |=
+        IREE_TASK_SCHEDULING_MODE_WEIGHT_BY_CORE_CAPACITY;
+  }
+  if (FLAG_task_scheduling_deterministic) {
+    options.scheduling_mode |= IREE_TASK_SCHEDULING_MODE_DETERMINISTIC;
+  }
+  if (FLAG_task_scheduling_locality_tile_order) {
+    options.scheduling_mode |= IREE_TASK_SCHEDULING_MODE_LOCALITY_TILE_ORDER;
+  }
+  if (FLAG_task_scheduling_sticky_tile_affinity) {
+    options.scheduling_mode |= IREE_TASK_SCHEDULING_MODE_STICKY_TILE_AFFINITY;
+  }
+  options.worker_local_memory_size =
       (iree_host_size_t)FLAG_task_worker_local_memory;
+  options.worker_spin_ns = (iree_duration_t)FLAG_task_worker_spin_us * 1000;
+  options.worker_spin_adaptive = FLAG_task_worker_spin_adaptive;
 
   iree_status_t status = iree_ok_status();
 
@@ -97,11 +162,20 @@ iree_status_t iree_task_executor_create_from_flags(
     iree_task_topology_initialize_from_group_count(
         FLAG_task_topology_group_count, &topology);
   } else if (strcmp(FLAG_task_topology_mode, "physical_cores") == 0) {
-    iree_task_topology_initialize_from_physical_cores(
-        FLAG_task_topology_max_group_count, &topology);
+    if (FLAG_task_topology_core_class >= 0) {
+      iree_task_topology_initialize_from_physical_cores_with_core_class(
+          (uint32_t)FLAG_task_topology_core_class,
+          FLAG_task_topology_max_group_count, &topology);
+    } else {
+      iree_task_topology_initialize_from_physical_cores(
+          FLAG_task_topology_max_group_count, &topology);
+    }
   } else if (strcmp(FLAG_task_topology_mode, "unique_l2_cache_groups") == 0) {
     iree_task_topology_initialize_from_unique_l2_cache_groups(
         FLAG_task_topology_max_group_count, &topology);
+  } else if (strcmp(FLAG_task_topology_mode, "numa_nodes") == 0) {
+    iree_task_topology_initialize_from_numa_nodes(
+        FLAG_task_topology_max_group_count, &topology);
   } else {
     status = iree_make_status(
         IREE_STATUS_INVALID_ARGUMENT,
@@ -111,9 +185,8 @@ iree_status_t iree_task_executor_create_from_flags(
   }
 
   if (iree_status_is_ok(status)) {
-    status = iree_task_executor_create(scheduling_mode, &topology,
-                                       worker_local_memory, host_allocator,
-                                       out_executor);
+    status = iree_task_executor_create_with_options(
+        &options, &topology, host_allocator, out_executor);
   }
 
   iree_task_topology_deinitialize(&topology);
@@ -6,10 +6,12 @@
 
 #include "iree/task/executor.h"
 
+#include <inttypes.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <string.h>
 
+#include "iree/base/internal/fpu_state.h"
 #include "iree/base/internal/math.h"
 #include "iree/base/tracing.h"
 #include "iree/task/affinity_set.h"
@@ -24,11 +26,39 @@
 
 static void iree_task_executor_destroy(iree_task_executor_t* executor);
 
+void iree_task_executor_options_initialize(
+    iree_task_executor_options_t* out_options) {
+  memset(out_options, 0, sizeof(*out_options));
+  out_options->scheduling_mode = IREE_TASK_SCHEDULING_MODE_RESERVED;
+  out_options->worker_local_memory_size = 0;
+  out_options->worker_spin_ns = IREE_TASK_EXECUTOR_DEFAULT_WORKER_SPIN_NS;
+  out_options->worker_spin_adaptive = true;
+}
+
 iree_status_t iree_task_executor_create(
     iree_task_scheduling_mode_t scheduling_mode,
     const iree_task_topology_t* topology,
     iree_host_size_t worker_local_memory_size, iree_allocator_t allocator,
     iree_task_executor_t** out_executor) {
+  iree_task_executor_options_t options;
+  iree_task_executor_options_initialize(&options);
+  options.scheduling_mode = scheduling_mode;
+  options.worker_local_memory_size = worker_local_memory_size;
+  return iree_task_executor_create_with_options(&options, topology, allocator,
+                                                out_executor);
+}
+
+iree_status_t iree_task_executor_create_with_options(
+    const iree_task_executor_options_t* options,
+    const iree_task_topology_t* topology, iree_allocator_t allocator,
+    iree_task_executor_t** out_executor) {
+  IREE_ASSERT_ARGUMENT(options);
+  if (options->worker_spin_ns < 0) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "worker spin duration must be >= 0");
+  }
+  iree_host_size_t worker_local_memory_size =
+      options->worker_local_memory_size;
   iree_host_size_t worker_count = iree_task_topology_group_count(topology);
   if (worker_count > IREE_TASK_EXECUTOR_MAX_WORKER_COUNT) {
     return iree_make_status(
@@ -49,11 +79,14 @@ iree_status_t iree_task_executor_create(
   IREE_ASSERT_ARGUMENT(out_executor);
   *out_executor = NULL;
 
-  // The executor is followed in memory by worker[] + worker_local_memory[].
+  // The executor is followed in memory by worker[].
   // The whole point is that we don't want destructive sharing between workers
   // so ensure we are aligned to at least the destructive interference size.
-  worker_local_memory_size = iree_host_align(
-      worker_local_memory_size, iree_hardware_destructive_interference_size);
+  // Worker local memory is allocated by each worker from its own thread (see
+  // iree_task_worker_main) so that its pages are placed on its own NUMA node.
+  worker_local_memory_size =
+      iree_host_align(worker_local_memory_size,
+                      IREE_TASK_EXECUTOR_WORKER_LOCAL_MEMORY_ALIGNMENT);
   IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)worker_local_memory_size);
   iree_host_size_t executor_base_size =
       iree_host_align(sizeof(iree_task_executor_t),
@@ -61,8 +94,7 @@ iree_status_t iree_task_executor_create(
   iree_host_size_t worker_list_size =
       iree_host_align(worker_count * sizeof(iree_task_worker_t),
                       iree_hardware_destructive_interference_size);
-  iree_host_size_t executor_size = executor_base_size + worker_list_size +
-                                   worker_count * worker_local_memory_size;
+  iree_host_size_t executor_size = executor_base_size + worker_list_size;
 
   iree_task_executor_t* executor = NULL;
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
@@ -70,8 +102,17 @@ iree_status_t iree_task_executor_create(
   memset(executor, 0, executor_size);
   iree_atomic_ref_count_init(&executor->ref_count);
   executor->allocator = allocator;
-  executor->scheduling_mode = scheduling_mode;
-  iree_atomic_task_slist_initialize(&executor->incoming_ready_slist);
+  executor->scheduling_mode = options->scheduling_mode;
+  executor->worker_local_memory_size = worker_local_memory_size;
+  executor->worker_spin_ns = options->worker_spin_ns;
+  executor->worker_spin_adaptive = options->worker_spin_adaptive;
+  executor->external_worker_wake = options->external_worker_wake;
+  if (executor->external_worker_wake.fn) {
+    // External workers have no threads to suspend or spin.
+    executor->scheduling_mode &=
+        ~IREE_TASK_SCHEDULING_MODE_DEFER_WORKER_STARTUP;
+    executor->worker_spin_ns = 0;
+  }
   iree_slim_mutex_initialize(&executor->coordinator_mutex);
 
   // Simple PRNG used to generate seeds for the per-worker PRNGs used to
@@ -86,7 +127,11 @@ iree_status_t iree_task_executor_create(
   iree_prng_minilcg128_initialize(iree_prng_splitmix64_next(&seed_prng),
                                   &executor->donation_theft_prng);
 
-  iree_status_t status = iree_ok_status();
+  // Queue of incoming ready tasks. This must be initialized first as destroy
+  // expects it to have been.
+  iree_status_t status = iree_mpmc_segmented_queue_initialize(
+      IREE_TASK_EXECUTOR_INCOMING_READY_SEGMENT_CAPACITY, allocator,
+      &executor->incoming_ready_queue);
 
   // Pool used for system events; exposed to users of the task system to ensure
   // we minimize the number of live events and reduce overheads in
@@ -118,44 +163,64 @@ iree_status_t iree_task_executor_create(
                                          &executor->poller);
   }
 
+  // Tiling decisions made against the cache sizes must hold on every worker so
+  // the smallest of each level is used. A level is unknown if it is unknown
+  // for any group.
+  if (iree_status_is_ok(status)) {
+    executor->cache_sizes =
+        iree_task_topology_get_group(topology, 0)->cache_sizes;
+    for (iree_host_size_t i = 1; i < worker_count; ++i) {
+      const iree_task_topology_cache_sizes_t* cache_sizes =
+          &iree_task_topology_get_group(topology, i)->cache_sizes;
+      executor->cache_sizes.l1d =
+          iree_min(executor->cache_sizes.l1d, cache_sizes->l1d);
+      executor->cache_sizes.l2 =
+          iree_min(executor->cache_sizes.l2, cache_sizes->l2);
+      executor->cache_sizes.l3 =
+          iree_min(executor->cache_sizes.l3, cache_sizes->l3);
+    }
+  }
+
   // Bring up the workers; the threads will be created here but be suspended
   // (if the platform supports it) awaiting the first tasks getting scheduled.
   if (iree_status_is_ok(status)) {
     executor->worker_count = worker_count;
     executor->workers =
         (iree_task_worker_t*)((uint8_t*)executor + executor_base_size);
-    uint8_t* worker_local_memory =
-        (uint8_t*)executor->workers + worker_list_size;
-
-    iree_task_affinity_set_t worker_idle_mask = 0;
-    iree_task_affinity_set_t worker_live_mask = 0;
-    iree_task_affinity_set_t worker_suspend_mask = 0;
     for (iree_host_size_t i = 0; i < worker_count; ++i) {
-      iree_task_affinity_set_t worker_bit = iree_task_affinity_for_worker(i);
-      worker_idle_mask |= worker_bit;
-      worker_live_mask |= worker_bit;
-      if (executor->scheduling_mode &
-          IREE_TASK_SCHEDULING_MODE_DEFER_WORKER_STARTUP) {
-        worker_suspend_mask |= worker_bit;
-      }
-
       iree_task_worker_t* worker = &executor->workers[i];
       status = iree_task_worker_initialize(
-          executor, i, iree_task_topology_get_group(topology, i),
-          iree_make_byte_span(worker_local_memory, worker_local_memory_size),
-          &seed_prng, worker);
-      worker_local_memory += worker_local_memory_size;
+          executor, i, iree_task_topology_get_group(topology, i), &seed_prng,
+          worker);
       if (!iree_status_is_ok(status)) break;
     }
-    iree_atomic_task_affinity_set_store(&executor->worker_live_mask,
-                                        worker_live_mask,
-                                        iree_memory_order_relaxed);
-    iree_atomic_task_affinity_set_store(&executor->worker_suspend_mask,
-                                        worker_suspend_mask,
+
+    // Mark all workers in each cluster as idle and live (and suspended if
+    // they were created that way).
+    executor->cluster_count =
+        iree_task_affinity_cluster_for_worker(worker_count - 1) + 1;
+    for (iree_host_size_t cluster_i = 0; cluster_i < executor->cluster_count;
+         ++cluster_i) {
+      iree_host_size_t cluster_worker_count =
+          iree_min(worker_count - iree_task_affinity_worker_index(cluster_i, 0),
+                   IREE_TASK_AFFINITY_SET_CLUSTER_WORKER_COUNT);
+      iree_task_affinity_set_t cluster_worker_mask =
+          cluster_worker_count == IREE_TASK_AFFINITY_SET_CLUSTER_WORKER_COUNT
+              ? iree_task_affinity_for_any_worker()
+              : (1ull << cluster_worker_count) - 1;
+      iree_atomic_task_worker_set_store(&executor->worker_live_mask, cluster_i,
+                                        cluster_worker_mask,
                                         iree_memory_order_relaxed);
-    iree_atomic_task_affinity_set_store(&executor->worker_idle_mask,
-                                        worker_idle_mask,
+      if (executor->scheduling_mode &
+          IREE_TASK_SCHEDULING_MODE_DEFER_WORKER_STARTUP) {
+        iree_atomic_task_worker_set_store(&executor->worker_suspend_mask,
+                                          cluster_i, cluster_worker_mask,
+                                          iree_memory_order_relaxed);
+      }
+      iree_atomic_task_worker_set_store(&executor->worker_idle_mask, cluster_i,
+                                        cluster_worker_mask,
                                         iree_memory_order_relaxed);
+    }
   }
 
   if (!iree_status_is_ok(status)) {
@@ -199,7 +264,7 @@ static void iree_task_executor_destroy(iree_task_executor_t* executor) {
 
   iree_event_pool_free(executor->event_pool);
   iree_slim_mutex_deinitialize(&executor->coordinator_mutex);
-  iree_atomic_task_slist_deinitialize(&executor->incoming_ready_slist);
+  iree_mpmc_segmented_queue_deinitialize(&executor->incoming_ready_queue);
   iree_task_pool_deinitialize(&executor->transient_task_pool);
   iree_allocator_free(executor->allocator, executor);
 
@@ -219,12 +284,94 @@ void iree_task_executor_release(iree_task_executor_t* executor) {
 }
 
 void iree_task_executor_trim(iree_task_executor_t* executor) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Workers release their local memory asynchronously the next time they are
+  // not executing anything; it'll be reallocated on demand by any dispatch
+  // that needs it.
+  for (iree_host_size_t i = 0; i < executor->worker_count; ++i) {
+    iree_task_worker_request_trim(&executor->workers[i]);
+  }
+
   // TODO(benvanik): figure out a good way to do this; the pools require that
   // no tasks are in-flight to trim but our caller can't reliably make that
   // guarantee. We'd need some global executor lock that we did here and
   // on submit - or rework pools to not have this limitation.
   // iree_task_pool_trim(&executor->fence_task_pool);
   // iree_task_pool_trim(&executor->transient_task_pool);
+
+  IREE_TRACE_ZONE_END(z0);
+}
+
+iree_host_size_t iree_task_executor_worker_count(
+    iree_task_executor_t* executor) {
+  return executor->worker_count;
+}
+
+iree_task_topology_cache_sizes_t iree_task_executor_cache_sizes(
+    iree_task_executor_t* executor) {
+  return executor->cache_sizes;
+}
+
+iree_status_t iree_task_executor_query_statistics(
+    iree_task_executor_t* executor, iree_host_size_t worker_capacity,
+    iree_task_worker_statistics_t* out_worker_statistics,
+    iree_host_size_t* out_worker_count) {
+  IREE_ASSERT_ARGUMENT(executor);
+  IREE_ASSERT_ARGUMENT(!worker_capacity || out_worker_statistics);
+  IREE_ASSERT_ARGUMENT(out_worker_count);
+  *out_worker_count = executor->worker_count;
+  if (worker_capacity < executor->worker_count) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "statistics capacity %" PRIhsz
+                            " insufficient for %" PRIhsz " workers",
+                            worker_capacity, executor->worker_count);
+  }
+  for (iree_host_size_t i = 0; i < executor->worker_count; ++i) {
+    iree_task_worker_query_statistics(&executor->workers[i],
+                                      &out_worker_statistics[i]);
+  }
+  return iree_ok_status();
+}
+
+iree_status_t iree_task_executor_statistics_fprint(
+    FILE* file, iree_task_executor_t* executor) {
+#if IREE_STATISTICS_ENABLE
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_host_size_t worker_count = 0;
+  iree_task_worker_statistics_t* statistics = NULL;
+  iree_status_t status = iree_allocator_malloc(
+      executor->allocator, executor->worker_count * sizeof(*statistics),
+      (void**)&statistics);
+  if (iree_status_is_ok(status)) {
+    status = iree_task_executor_query_statistics(
+        executor, executor->worker_count, statistics, &worker_count);
+  }
+
+  if (iree_status_is_ok(status)) {
+    fprintf(file, "[[ iree_task_executor_t statistics ]]\n");
+    fprintf(file,
+            "worker |      tasks |      tiles |  steals (hit/try) | "
+            "executing ms |  parked ms\n");
+    for (iree_host_size_t i = 0; i < worker_count; ++i) {
+      const iree_task_worker_statistics_t* worker = &statistics[i];
+      fprintf(file,
+              "%6" PRIhsz " | %10" PRIu64 " | %10" PRIu64 " | %8" PRIu64
+              "/%-8" PRIu64 " | %12.3f | %10.3f\n",
+              i, worker->task_count, worker->tile_count,
+              worker->steal_success_count, worker->steal_attempt_count,
+              worker->executing_ns / 1000000.0, worker->parked_ns / 1000000.0);
+    }
+  }
+
+  iree_allocator_free(executor->allocator, statistics);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+#else
+  // No-op.
+  return iree_ok_status();
+#endif  // IREE_STATISTICS_ENABLE
 }
 
 iree_event_pool_t* iree_task_executor_event_pool(
@@ -343,13 +490,24 @@ void iree_task_executor_schedule_ready_tasks(
 
 void iree_task_executor_merge_submission(iree_task_executor_t* executor,
                                          iree_task_submission_t* submission) {
-  // Concatenate all of the incoming tasks into the submission list.
-  // Note that the submission stores tasks in LIFO order such that when they are
-  // put into the LIFO atomic slist they match the order across all concats
-  // (earlier concats are later in the LIFO list).
-  iree_atomic_task_slist_concat(&executor->incoming_ready_slist,
-                                submission->ready_list.head,
-                                submission->ready_list.tail);
+  // Enqueue all of the incoming tasks in the order they were submitted.
+  // Note that the submission stores tasks in LIFO order and we reverse it
+  // before enqueuing.
+  iree_task_list_reverse(&submission->ready_list);
+  iree_task_t* task = NULL;
+  while ((task = iree_task_list_pop_front(&submission->ready_list))) {
+    iree_status_t status = iree_mpmc_segmented_queue_enqueue(
+        &executor->incoming_ready_queue, task);
+    if (IREE_UNLIKELY(!iree_status_is_ok(status))) {
+      // Unable to grow the queue; fail the scope of the task as we would if
+      // it had failed to execute and drop it along with its dependents.
+      iree_task_scope_fail(task->scope, status);
+      iree_task_list_t discard_worklist;
+      iree_task_list_initialize(&discard_worklist);
+      iree_task_discard(task, &discard_worklist);
+      iree_task_list_discard(&discard_worklist);
+    }
+  }
 
   // Enqueue waiting tasks with the poller immediately: this may issue a
   // syscall to kick the poller. If we see bad context switches here then we
@@ -418,8 +576,13 @@ void iree_task_executor_coordinate(iree_task_executor_t* executor,
     // various places and have no relation - hopefully leading to better average
     // latency.
     iree_task_submission_t pending_submission;
-    iree_task_submission_initialize_from_lifo_slist(
-        &executor->incoming_ready_slist, &pending_submission);
+    iree_task_submission_initialize(&pending_submission);
+    void* incoming_task = NULL;
+    while (iree_mpmc_segmented_queue_try_dequeue(
+        &executor->incoming_ready_queue, &incoming_task)) {
+      iree_task_list_push_back(&pending_submission.ready_list,
+                               (iree_task_t*)incoming_task);
+    }
     if (iree_task_list_is_empty(&pending_submission.ready_list)) break;
 
     // Scratch coordinator submission batch used during scheduling to batch up
@@ -428,8 +591,7 @@ void iree_task_executor_coordinate(iree_task_executor_t* executor,
     // coordinator is random it's better to ensure that these bytes never incur
     // a cache miss by making them live here in the stack of the chosen thread.
     iree_task_post_batch_t* post_batch =
-        iree_alloca(sizeof(iree_task_post_batch_t) +
-                    executor->worker_count * sizeof(iree_task_list_t));
+        iree_alloca(iree_task_post_batch_size(executor->worker_count));
     iree_task_post_batch_initialize(executor, current_worker, post_batch);
 
     // Schedule all ready tasks in this batch. Some may complete inline (such
@@ -452,34 +614,36 @@ void iree_task_executor_coordinate(iree_task_executor_t* executor,
 }
 
 static iree_task_t* iree_task_executor_try_steal_task_from_affinity_set(
-    iree_task_executor_t* executor, iree_task_affinity_set_t victim_mask,
-    uint32_t max_theft_attempts, int rotation_offset,
-    iree_task_queue_t* local_task_queue) {
+    iree_task_executor_t* executor, iree_host_size_t cluster_index,
+    iree_task_affinity_set_t victim_mask, uint32_t max_theft_attempts,
+    int rotation_offset, iree_task_queue_t* local_task_queue) {
   if (!victim_mask) return NULL;
   max_theft_attempts = iree_min(max_theft_attempts,
                                 iree_task_affinity_set_count_ones(victim_mask));
-  victim_mask = iree_task_affinity_set_rotr(victim_mask, rotation_offset);
 
-  int worker_index = rotation_offset;
+  int victim_bit_base = rotation_offset;
   iree_task_affinity_set_t mask =
-      iree_task_affinity_set_rotr(victim_mask, worker_index);
+      iree_task_affinity_set_rotr(victim_mask, rotation_offset);
   for (uint32_t i = 0; i < max_theft_attempts; ++i) {
     // Find the last set bit and skip to it. This avoids the need for doing
     // a full O(n) scan and instead gets us at O(popcnt) * O(ctz).
     //
     // Example: sharing mask = 0b01010101
-    //          mask_rotation = 3 (randomly selected)
+    //          rotation_offset = 3 (randomly selected)
     //          mask = 0b01010101 rotr 3 = 0b10101010
     //          for (i = 0; i < 4; ++i)
     //            offset = ctz(0b10101010) = 1
-    //            mask_rotation += 1 = 4
-    //            mask >>= 1 = 0b01010101
-    //            victim_index = 4 % 64 = 4
+    //            victim_bit = 3 + 1 = 4
+    //            victim_bit_base += 1 + 1 = 5
+    //            mask >>= 2 = 0b00101010
     int offset = iree_task_affinity_set_count_trailing_zeros(mask);
-    int victim_index = (worker_index + offset) % executor->worker_count;
-    worker_index += offset + 1;
+    int victim_bit = (victim_bit_base + offset) %
+                     IREE_TASK_AFFINITY_SET_CLUSTER_WORKER_COUNT;
+    victim_bit_base += offset + 1;
     mask = iree_shr(mask, offset + 1);
-    iree_task_worker_t* victim_worker = &executor->workers[victim_index];
+    iree_task_worker_t* victim_worker =
+        &executor->workers[iree_task_affinity_worker_index(cluster_index,
+                                                           victim_bit)];
 
     // Policy: steal a chunk of tasks at the tail of the victim queue.
     // This will steal multiple tasks from the victim up to the specified max
@@ -497,6 +661,17 @@ static iree_task_t* iree_task_executor_try_steal_task_from_affinity_set(
   return NULL;
 }
 
+// Returns a mask of workers in |cluster_index| that are live and not idle.
+static iree_task_affinity_set_t iree_task_executor_busy_worker_mask(
+    iree_task_executor_t* executor, iree_host_size_t cluster_index) {
+  return iree_atomic_task_worker_set_load(&executor->worker_live_mask,
+                                          cluster_index,
+                                          iree_memory_order_relaxed) &
+         ~iree_atomic_task_worker_set_load(&executor->worker_idle_mask,
+                                           cluster_index,
+                                           iree_memory_order_relaxed);
+}
+
 // Tries to steal an entire task from a sibling worker (based on topology).
 // Returns a task that is available (has not yet begun processing at all).
 // May steal multiple tasks and add them to the |local_task_queue|.
@@ -504,7 +679,10 @@ static iree_task_t* iree_task_executor_try_steal_task_from_affinity_set(
 // We do a scan through ideal victims indicated by the
 // |constructive_sharing_mask|; these are the workers most likely to have some
 // cache benefits to taking their work as they share some level of the cache
-// hierarchy and should be better to steal from than any random worker.
+// hierarchy and should be better to steal from than any random worker. After
+// that we try the workers on the same NUMA node per |numa_node_mask| and then
+// any other worker in our cluster. Only once our cluster has nothing to offer
+// do we start touching the worker masks of other clusters.
 //
 // To prevent biasing any particular victim we use a fast prng function to
 // select where in the set of potential victims defined by the topology
@@ -512,19 +690,17 @@ static iree_task_t* iree_task_executor_try_steal_task_from_affinity_set(
 // instead of bouncing around at random we just select the starting point in
 // our search and then go in-order.
 iree_task_t* iree_task_executor_try_steal_task(
-    iree_task_executor_t* executor,
+    iree_task_executor_t* executor, iree_host_size_t cluster_index,
     iree_task_affinity_set_t constructive_sharing_mask,
-    uint32_t max_theft_attempts, iree_prng_minilcg128_state_t* theft_prng,
+    iree_task_affinity_set_t numa_node_mask, uint32_t max_theft_attempts,
+    iree_prng_minilcg128_state_t* theft_prng,
     iree_task_queue_t* local_task_queue) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
   // Limit the workers we will steal from to the ones that are currently live
   // and not idle.
   iree_task_affinity_set_t victim_mask =
-      iree_atomic_task_affinity_set_load(&executor->worker_live_mask,
-                                         iree_memory_order_relaxed) &
-      ~iree_atomic_task_affinity_set_load(&executor->worker_idle_mask,
-                                          iree_memory_order_relaxed);
+      iree_task_executor_busy_worker_mask(executor, cluster_index);
 
   // TODO(benvanik): it may be possible to rework this such that we better
   // use the prng; for example, instead of all this rotating stuff we could just
@@ -539,16 +715,59 @@ iree_task_t* iree_task_executor_try_steal_task(
   // that we won't need to go back to main memory (or higher cache tiers) in the
   // event that the thief and victim are running close to each other in time.
   iree_task_t* task = iree_task_executor_try_steal_task_from_affinity_set(
-      executor, victim_mask & constructive_sharing_mask, max_theft_attempts,
-      rotation_offset, local_task_queue);
+      executor, cluster_index, victim_mask & constructive_sharing_mask,
+      max_theft_attempts, rotation_offset, local_task_queue);
   if (task) {
     IREE_TRACE_ZONE_APPEND_TEXT(z0, "local");
-  } else {
+    IREE_TRACE_ZONE_END(z0);
+    return task;
+  }
+  victim_mask &= ~constructive_sharing_mask;
+
+  // Next try the workers on the same NUMA node. Though they may not share any
+  // caches with us the memory their tasks touch is likely to be attached to
+  // the same memory controller and stealing from them avoids crossing the node
+  // interconnect. On single-node systems the mask includes all workers and
+  // this is where all non-local theft happens.
+  task = iree_task_executor_try_steal_task_from_affinity_set(
+      executor, cluster_index, victim_mask & numa_node_mask, max_theft_attempts,
+      rotation_offset, local_task_queue);
+  if (task) {
+    IREE_TRACE_ZONE_APPEND_TEXT(z0, "node-local");
+    IREE_TRACE_ZONE_END(z0);
+    return task;
+  }
+  victim_mask &= ~numa_node_mask;
+
+  // Fall back to remote workers in our cluster; better to pay for the remote
+  // memory traffic than to leave the worker idle.
+  task = iree_task_executor_try_steal_task_from_affinity_set(
+      executor, cluster_index, victim_mask, max_theft_attempts, rotation_offset,
+      local_task_queue);
+  if (task) {
+    IREE_TRACE_ZONE_APPEND_TEXT(z0, "non-local");
+    IREE_TRACE_ZONE_END(z0);
+    return task;
+  }
+
+  // Finally try the other clusters starting with the one after ours so that
+  // thieves from different clusters don't all pile on to cluster 0.
+  iree_task_cluster_mask_t cluster_mask =
+      iree_atomic_task_worker_set_load_clusters(&executor->worker_live_mask,
+                                                iree_memory_order_relaxed) &
+      ~(1ull << cluster_index);
+  for (iree_host_size_t i = 1; i < executor->cluster_count && cluster_mask;
+       ++i) {
+    iree_host_size_t other_cluster_index =
+        (cluster_index + i) % executor->cluster_count;
+    if (!(cluster_mask & (1ull << other_cluster_index))) continue;
     task = iree_task_executor_try_steal_task_from_affinity_set(
-        executor, victim_mask & ~constructive_sharing_mask, max_theft_attempts,
-        rotation_offset, local_task_queue);
+        executor, other_cluster_index,
+        iree_task_executor_busy_worker_mask(executor, other_cluster_index),
+        max_theft_attempts, rotation_offset, local_task_queue);
     if (task) {
-      IREE_TRACE_ZONE_APPEND_TEXT(z0, "non-local");
+      IREE_TRACE_ZONE_APPEND_TEXT(z0, "remote-cluster");
+      break;
     }
   }
 
@@ -556,19 +775,163 @@ iree_task_t* iree_task_executor_try_steal_task(
   return task;
 }
 
+iree_status_t iree_task_executor_run_worker(iree_task_executor_t* executor,
+                                            iree_host_size_t worker_index) {
+  IREE_ASSERT_ARGUMENT(executor);
+  if (IREE_UNLIKELY(!executor->external_worker_wake.fn)) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "executor workers are not external");
+  }
+  if (IREE_UNLIKELY(worker_index >= executor->worker_count)) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "worker %" PRIhsz " out of range (%" PRIhsz
+                            " workers)",
+                            worker_index, executor->worker_count);
+  }
+  iree_task_worker_run_external(&executor->workers[worker_index]);
+  return iree_ok_status();
+}
+
+// State of a thread donated to the executor with
+// iree_task_executor_donate_caller.
+typedef struct iree_task_executor_donation_t {
+  // Queue receiving tasks stolen beyond the one executed immediately. All
+  // tasks must be executed before the donation ends as the donor owns them.
+  iree_task_queue_t task_queue;
+  // Local memory used by dispatch shards executed on the donated thread.
+  // Allocated on demand with |local_memory_allocation| as the base pointer.
+  iree_byte_span_t local_memory;
+  void* local_memory_allocation;
+} iree_task_executor_donation_t;
+
+// Ensures the donation has at least |minimum_size| bytes of local memory.
+static iree_status_t iree_task_executor_donation_reserve_local_memory(
+    iree_task_executor_t* executor, iree_task_executor_donation_t* donation,
+    iree_host_size_t minimum_size) {
+  if (IREE_LIKELY(minimum_size <= donation->local_memory.data_length)) {
+    return iree_ok_status();
+  }
+  iree_allocator_free(executor->allocator, donation->local_memory_allocation);
+  donation->local_memory_allocation = NULL;
+  donation->local_memory = iree_make_byte_span(NULL, 0);
+  iree_host_size_t new_size = iree_host_align(
+      minimum_size, IREE_TASK_EXECUTOR_WORKER_LOCAL_MEMORY_ALIGNMENT);
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+      executor->allocator,
+      new_size + IREE_TASK_EXECUTOR_WORKER_LOCAL_MEMORY_ALIGNMENT - 1,
+      &donation->local_memory_allocation));
+  donation->local_memory = iree_make_byte_span(
+      (void*)iree_host_align((uintptr_t)donation->local_memory_allocation,
+                             IREE_TASK_EXECUTOR_WORKER_LOCAL_MEMORY_ALIGNMENT),
+      new_size);
+  return iree_ok_status();
+}
+
+// Executes a |task| stolen from a worker on the donated thread.
+// Mirrors worker execution but as the donated thread is not a worker the task
+// is never preempted and runs with full capacity.
+static void iree_task_executor_donation_execute(
+    iree_task_executor_t* executor, iree_task_executor_donation_t* donation,
+    iree_task_t* task) {
+  iree_task_submission_t pending_submission;
+  iree_task_submission_initialize(&pending_submission);
+  switch (task->type) {
+    case IREE_TASK_TYPE_CALL: {
+      iree_task_call_execute((iree_task_call_t*)task, &pending_submission);
+      break;
+    }
+    case IREE_TASK_TYPE_DISPATCH_SHARD: {
+      // On failure the shard is still executed and will fail the dispatch as
+      // the local memory is insufficient.
+      iree_task_dispatch_shard_t* shard_task =
+          (iree_task_dispatch_shard_t*)task;
+      iree_status_ignore(iree_task_executor_donation_reserve_local_memory(
+          executor, donation,
+          iree_task_dispatch_shard_parent(shard_task)->local_memory_size));
+      bool preempted = false;
+      iree_task_dispatch_shard_execute(
+          shard_task, donation->local_memory,
+          IREE_TASK_TOPOLOGY_GROUP_CAPACITY_MAX, /*preemption_flag=*/NULL,
+          &pending_submission, &preempted);
+      break;
+    }
+    default:
+      IREE_ASSERT_UNREACHABLE("incorrect task type for donated execution");
+      break;
+  }
+
+  // Newly ready tasks are scheduled immediately so that workers (and this
+  // thread) can pick them up without waiting for a worker to coordinate.
+  if (!iree_task_submission_is_empty(&pending_submission)) {
+    iree_task_executor_submit(executor, &pending_submission);
+    iree_task_executor_flush(executor);
+  }
+}
+
+// Returns true if |wait_source| has resolved (successfully or not) or can no
+// longer be queried.
+static bool iree_task_executor_is_wait_source_resolved(
+    iree_wait_source_t wait_source) {
+  iree_status_code_t wait_status_code = IREE_STATUS_OK;
+  iree_status_t status = iree_wait_source_query(wait_source, &wait_status_code);
+  if (!iree_status_is_ok(status)) {
+    iree_status_ignore(status);
+    return true;
+  }
+  return wait_status_code != IREE_STATUS_DEFERRED;
+}
+
 iree_status_t iree_task_executor_donate_caller(iree_task_executor_t* executor,
                                                iree_wait_source_t wait_source,
                                                iree_timeout_t timeout) {
   IREE_TRACE_ZONE_BEGIN(z0);
+  iree_convert_timeout_to_absolute(&timeout);
+  iree_time_t deadline_ns = iree_timeout_as_deadline_ns(timeout);
 
   // Perform an immediate flush/coordination (in case the caller queued).
   iree_task_executor_flush(executor);
 
-  // Wait until completed.
-  // TODO(benvanik): make this steal tasks until wait_handle resolves?
-  // Somewhat dangerous as we don't know what kind of thread we are running on;
-  // it may have a smaller stack than we are expecting or have some weird thread
-  // local state (FPU rounding modes/etc).
+  // Steal and execute tasks from the workers until the wait source resolves
+  // or there is no work available to steal. We don't know what kind of thread
+  // we are running on so we set the FPU state we require and use our own local
+  // memory; the caller stack is only used for the tile functions themselves
+  // just as when executing on a worker.
+  iree_fpu_state_t fpu_state =
+      iree_fpu_state_push(IREE_FPU_STATE_FLAG_FLUSH_DENORMALS_TO_ZERO);
+  iree_task_executor_donation_t donation;
+  memset(&donation, 0, sizeof(donation));
+  iree_task_queue_initialize(&donation.task_queue);
+  while (true) {
+    iree_task_t* task = iree_task_queue_pop_front(&donation.task_queue);
+    if (!task) {
+      // Only stop once all tasks we have taken ownership of have executed.
+      if (iree_task_executor_is_wait_source_resolved(wait_source) ||
+          iree_time_now() >= deadline_ns) {
+        break;
+      }
+      // In deterministic mode the caller only waits as which tasks it would
+      // steal depends on timing.
+      if (executor->scheduling_mode & IREE_TASK_SCHEDULING_MODE_DETERMINISTIC) {
+        break;
+      }
+      task = iree_task_executor_try_steal_task(
+          executor, /*cluster_index=*/0, iree_task_affinity_for_any_worker(),
+          iree_task_affinity_for_any_worker(),
+          (uint32_t)executor->worker_count, &executor->donation_theft_prng,
+          &donation.task_queue);
+      if (!task) break;
+    }
+    IREE_TRACE_ZONE_BEGIN_NAMED(z_task,
+                                "iree_task_executor_donate_caller_execute");
+    iree_task_executor_donation_execute(executor, &donation, task);
+    IREE_TRACE_ZONE_END(z_task);
+  }
+  iree_task_queue_deinitialize(&donation.task_queue);
+  iree_allocator_free(executor->allocator, donation.local_memory_allocation);
+  iree_fpu_state_pop(fpu_state);
+
+  // Wait until completed; if we executed the last of the work this will
+  // return immediately.
   iree_status_t status = iree_wait_source_wait_one(wait_source, timeout);
 
   IREE_TRACE_ZONE_END(z0);
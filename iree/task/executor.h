@@ -7,7 +7,9 @@
 #ifndef IREE_TASK_EXECUTOR_H_
 #define IREE_TASK_EXECUTOR_H_
 
+#include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
 
 #include "iree/base/api.h"
 #include "iree/base/internal/atomics.h"
@@ -112,15 +114,15 @@ extern "C" {
 //      the ready_list. If it is initially waiting on an external resource such
 //      as iree_wait_handle_t then it is placed into the waiting_list.
 //
-// 2. iree_task_executor_submit (LIFO, atomic slist)
-//    Submissions have their task thread-local lists concatenated into a LIFO
-//    incoming_ready_slist or the wait poller shared by the executor.
+// 2. iree_task_executor_submit (FIFO, MPMC queue)
+//    Submissions have their task thread-local lists enqueued in order into the
+//    FIFO incoming_ready_queue or the wait poller shared by the executor.
 //
 // 3. iree_task_executor_flush (or a worker puts on its coordinator hat 🎩)
 //
-//   a. Tasks are flushed from the incoming_ready_slist into a coordinator-local
-//      FIFO task queue. This centralizes enqueuing from all threads into a
-//      single ordered list.
+//   a. Tasks are dequeued from the incoming_ready_queue into a
+//      coordinator-local FIFO task queue. This centralizes enqueuing from all
+//      threads into a single ordered list.
 //
 //   b. iree_task_executor_schedule_ready_tasks: walks the FIFO task queue and
 //      builds a iree_task_post_batch_t containing the per-worker tasks
@@ -143,7 +145,7 @@ extern "C" {
 //
 //    c. Any tasks in the local_task_queue are executed until empty.
 //       Tasks are retired and dependent tasks (via completion_task or barriers)
-//       are made ready and placed in the executor incoming_ready_slist as with
+//       are made ready and placed in the executor incoming_ready_queue as with
 //       iree_task_executor_submit.
 //
 //    d. If no more thread-local work is available and the mailbox_slist is
@@ -220,16 +222,22 @@ extern "C" {
 // Scaling Up
 //==============================================================================
 //
-// The task system has an implicit limit of 64 workers. This intentional
-// limitation simplifies several parts of the code while also preventing misuse:
-// it rarely (if ever) makes sense to have more than 64 compute-dominated
-// threads working on a single problem. Achieving high performance in such
-// situations requires extremely careful control over the OS scheduler, memory
-// bandwidth consumption, and synchronization. It's always possible to make the
-// problem more compute-bound or very carefully try to fit in specific cache
-// sizes to avoid more constrained bandwidth paths but it's a non-portable
-// whack-a-mole style solution that is in conflict with a lot of what IREE seeks
-// to do with respect to low-latency and multi-tenant workloads.
+// The task system supports up to IREE_TASK_EXECUTOR_MAX_WORKER_COUNT workers
+// (256 by default). Workers are partitioned into clusters of 64 so that each
+// cluster can be tracked with a single bitmask and a summary mask of clusters
+// lets the scheduler find idle workers and theft victims without walking every
+// worker. Workers prefer stealing from their own cluster and only touch other
+// clusters when theirs is out of work. Task affinity sets remain 64 bits and
+// apply to the same worker positions within every cluster.
+//
+// Even so it rarely (if ever) makes sense to have more than 64
+// compute-dominated threads working on a single problem. Achieving high
+// performance in such situations requires extremely careful control over the
+// OS scheduler, memory bandwidth consumption, and synchronization. It's always
+// possible to make the problem more compute-bound or very carefully try to fit
+// in specific cache sizes to avoid more constrained bandwidth paths but it's a
+// non-portable whack-a-mole style solution that is in conflict with a lot of
+// what IREE seeks to do with respect to low-latency and multi-tenant workloads.
 //
 // If more than 64 unique L1/L2 caches (or realistically more than probably ~32)
 // are available *and* all of them are attached to the same memory controllers
@@ -282,19 +290,137 @@ enum iree_task_scheduling_mode_bits_t {
   // much faster schedule all worker quantums and in many cases all workers will
   // begin processing simultaneously immediately after the submission is made.
   IREE_TASK_SCHEDULING_MODE_DEFER_WORKER_STARTUP = 1u << 0,
+
+  // Weights the distribution of dispatch tiles across workers by the relative
+  // capacity of the cores they are mapped to (see
+  // iree_task_topology_group_t::capacity). Workers on lower capacity cores
+  // (such as the little cores of ARM big.LITTLE or the efficiency cores of
+  // hybrid x86) reserve proportionally fewer tiles at a time so that they do
+  // not end up holding the tail of the dispatch while higher capacity workers
+  // sit idle.
+  //
+  // Has no effect on topologies where all groups have the same capacity.
+  IREE_TASK_SCHEDULING_MODE_WEIGHT_BY_CORE_CAPACITY = 1u << 1,
+
+  // Makes the placement of work on workers a function of only the submitted
+  // work and the topology so that repeated runs execute the same tiles on the
+  // same workers. Intended for reproducible performance measurement where
+  // run-to-run variance from dynamic load balancing obscures the effect of
+  // the change being measured; the cost is that any imbalance between workers
+  // (other processes, frequency scaling, uneven tiles) directly adds latency.
+  //
+  // When set:
+  //  - tasks are posted to the lowest-indexed live worker in their affinity
+  //    set instead of the posting worker or an idle one;
+  //  - dispatch shard i is always posted to worker i and executes a fixed
+  //    contiguous range of the tiles instead of reserving them dynamically;
+  //  - workers and donated caller threads never steal tasks;
+  //  - workers with a specified ideal thread affinity are pinned to exactly
+  //    that processor (excluding its SMT siblings).
+  //
+  // Workers always run with a fixed FPU state (denormals flushed to zero)
+  // regardless of this mode.
+  IREE_TASK_SCHEDULING_MODE_DETERMINISTIC = 1u << 2,
+
+  // Executes the tiles of each dispatch in column panels of
+  // IREE_TASK_DISPATCH_TILE_PANEL_WIDTH tiles instead of in linear x-major
+  // order. Tiles executed close together in time then share both their rows
+  // and their columns of the grid and for dispatches like matmuls the operand
+  // slices they read stay resident in cache across consecutive tiles.
+  //
+  // Each row of a panel is still contiguous in the linear order so range
+  // dispatch functions (iree_task_dispatch_t::range_fn) remain usable though
+  // they are called with at most a panel width of tiles at a time.
+  IREE_TASK_SCHEDULING_MODE_LOCALITY_TILE_ORDER = 1u << 3,
+
+  // Assigns each dispatch shard a fixed contiguous range of the tiles and
+  // posts shard i to worker i such that the same tiles of consecutive
+  // dispatches with the same grid execute on the same worker. Producer tiles
+  // then leave their results in the private caches of the worker executing
+  // the corresponding consumer tiles.
+  //
+  // Unlike IREE_TASK_SCHEDULING_MODE_DETERMINISTIC workers may still steal
+  // shards that have not yet started so an overloaded worker does not hold
+  // up the dispatch indefinitely, but tiles are no longer balanced across
+  // shards dynamically and uneven tiles directly add latency.
+  IREE_TASK_SCHEDULING_MODE_STICKY_TILE_AFFINITY = 1u << 4,
 };
 typedef uint32_t iree_task_scheduling_mode_t;
 
 // Base task system executor interface.
 typedef struct iree_task_executor_t iree_task_executor_t;
 
+// Function called when the external worker at |worker_index| has work
+// available and must be run by a host thread with
+// iree_task_executor_run_worker. Called from arbitrary threads (including
+// threads running other workers) and must not block.
+typedef void(IREE_API_PTR* iree_task_executor_worker_wake_fn_t)(
+    void* user_data, iree_host_size_t worker_index);
+
+// Callback used to wake external workers.
+typedef struct iree_task_executor_worker_wake_callback_t {
+  iree_task_executor_worker_wake_fn_t fn;
+  void* user_data;
+} iree_task_executor_worker_wake_callback_t;
+
+// Options controlling executor behavior.
+// Initialize with iree_task_executor_options_initialize to get the defaults.
+typedef struct iree_task_executor_options_t {
+  // Specifies the scheduling mode used for configuring how (or if) work is
+  // balanced across queues.
+  iree_task_scheduling_mode_t scheduling_mode;
+
+  // Defines the bytes of local memory each worker allocates when it starts.
+  // See iree_task_executor_create.
+  iree_host_size_t worker_local_memory_size;
+
+  // Maximum duration each worker will spin waiting for new work to arrive
+  // before parking its thread. Spinning trades CPU time (and power) for lower
+  // wake latency when work arrives in quick succession such as when running
+  // sequences of small dispatches. 0 parks immediately.
+  iree_duration_t worker_spin_ns;
+
+  // Adapts the duration each worker spins based on the recently observed
+  // durations between running out of work and new work arriving. Workers that
+  // have been idle for longer than |worker_spin_ns| recently will park without
+  // spinning and workers that have received work quickly will spin only about
+  // as long as they have been waiting. Ignored if |worker_spin_ns| is 0.
+  bool worker_spin_adaptive;
+
+  // If set the executor creates no worker threads and instead each worker of
+  // the topology is run by host threads (such as those of an application
+  // thread pool) with iree_task_executor_run_worker whenever the callback
+  // indicates that the worker has work available. This avoids oversubscribing
+  // cores when the hosting application already has its own pool.
+  //
+  // The topology is still used to determine the number of workers and the
+  // cache sharing relationships used for work stealing but thread affinities
+  // are left to the host. IREE_TASK_SCHEDULING_MODE_DEFER_WORKER_STARTUP and
+  // worker spinning are ignored as host threads return as soon as the worker
+  // runs out of work.
+  iree_task_executor_worker_wake_callback_t external_worker_wake;
+} iree_task_executor_options_t;
+
+// Initializes |out_options| to its default values.
+void iree_task_executor_options_initialize(
+    iree_task_executor_options_t* out_options);
+
+// Creates a task executor using the specified topology and |options|.
+//
+// |topology| is only used during creation and need not live beyond this call.
+// |out_executor| must be released by the caller.
+iree_status_t iree_task_executor_create_with_options(
+    const iree_task_executor_options_t* options,
+    const iree_task_topology_t* topology, iree_allocator_t allocator,
+    iree_task_executor_t** out_executor);
+
 // Creates a task executor using the specified topology.
 //
-// |worker_local_memory_size| defines the bytes to be allocated and reserved for
-// each worker to use for local memory operations. Will be rounded up to the
-// next power of two. Dispatches performed will be able to request up to this
-// amount of memory for their invocations and no more. May be 0 if no worker
-// local memory is required.
+// |worker_local_memory_size| defines the bytes of local memory each worker
+// allocates when it starts. Will be rounded up to the next page. Workers grow
+// their local memory on demand when a dispatch requires more and retain it at
+// its high-water mark until the executor is trimmed. May be 0 to only allocate
+// local memory once a dispatch requires it.
 //
 // |topology| is only used during creation and need not live beyond this call.
 // |out_executor| must be released by the caller.
@@ -311,8 +437,18 @@ void iree_task_executor_retain(iree_task_executor_t* executor);
 void iree_task_executor_release(iree_task_executor_t* executor);
 
 // Trims pools and caches used by the executor and its workers.
+// Worker local memory is released asynchronously as workers go idle.
 void iree_task_executor_trim(iree_task_executor_t* executor);
 
+// Returns the total number of workers in |executor|.
+iree_host_size_t iree_task_executor_worker_count(
+    iree_task_executor_t* executor);
+
+// Returns the smallest size of each cache level used by the cores the
+// |executor| workers are mapped to. Sizes unknown for any worker are 0.
+iree_task_topology_cache_sizes_t iree_task_executor_cache_sizes(
+    iree_task_executor_t* executor);
+
 // Returns an iree_event_t pool managed by the executor.
 // Users of the task system should acquire their transient events from this.
 // Long-lived events should be allocated on their own in order to avoid
@@ -352,6 +488,64 @@ void iree_task_executor_submit(iree_task_executor_t* executor,
 // after the flush has occurred but prior to this call returning.
 void iree_task_executor_flush(iree_task_executor_t* executor);
 
+// Scheduling statistics of a single executor worker since executor creation.
+// Work performed by threads donated with iree_task_executor_donate_caller is
+// not attributed to any worker.
+typedef struct iree_task_worker_statistics_t {
+  // Number of tasks (calls and dispatch shards) executed.
+  uint64_t task_count;
+  // Number of dispatch tiles executed across all dispatch shards.
+  uint64_t tile_count;
+  // Number of times the worker ran out of its own work and tried to steal
+  // tasks from other workers.
+  uint64_t steal_attempt_count;
+  // Number of steal attempts that found at least one task.
+  uint64_t steal_success_count;
+  // Total duration spent executing tasks.
+  iree_duration_t executing_ns;
+  // Total duration spent parked waiting for work to be posted. Spinning prior
+  // to parking is included in neither this nor |executing_ns|.
+  iree_duration_t parked_ns;
+} iree_task_worker_statistics_t;
+
+// Queries the scheduling statistics of each worker in |executor|.
+// |out_worker_count| is always set to the total number of workers and up to
+// |worker_capacity| entries of |out_worker_statistics| are populated. Returns
+// IREE_STATUS_OUT_OF_RANGE if the capacity is insufficient; callers can query
+// with a capacity of 0 to get the required count.
+//
+// Counters are updated with relaxed atomics by each worker and may tear with
+// respect to each other if work is executing during the query.
+//
+// NOTE: statistics may be compiled out in some configurations
+// (IREE_STATISTICS_ENABLE) and all counters will be 0.
+//
+// Safe to call from any thread.
+iree_status_t iree_task_executor_query_statistics(
+    iree_task_executor_t* executor, iree_host_size_t worker_capacity,
+    iree_task_worker_statistics_t* out_worker_statistics,
+    iree_host_size_t* out_worker_count);
+
+// Prints the current per-worker statistics of |executor| to |file|.
+// No-op if statistics are not enabled (IREE_STATISTICS_ENABLE).
+iree_status_t iree_task_executor_statistics_fprint(
+    FILE* file, iree_task_executor_t* executor);
+
+// Runs the external worker at |worker_index| on the calling thread until it
+// has no more work available and then returns.
+//
+// Only valid on executors created with
+// iree_task_executor_options_t::external_worker_wake. Must be called exactly
+// once for each time the wake callback is issued for the worker and never
+// otherwise; the executor ensures that it never issues a wake for a worker
+// that is already running such that each worker is only ever run by a single
+// thread at a time. The worker executes on the calling thread with the FPU
+// state it requires and restores the caller FPU state before returning.
+//
+// The executor must remain live until all issued wakes have been run.
+iree_status_t iree_task_executor_run_worker(iree_task_executor_t* executor,
+                                            iree_host_size_t worker_index);
+
 // Donates the calling thread to the executor until either |wait_source|
 // resolves or |timeout| is exceeded. Flushes any pending task batches prior
 // to doing any work or waiting.
@@ -359,7 +553,11 @@ void iree_task_executor_flush(iree_task_executor_t* executor);
 // If there are no tasks available then the calling thread will block as if
 // iree_wait_source_wait_one had been used on |wait_source|. If tasks are ready
 // then the caller will not block prior to starting to perform work on behalf of
-// the executor.
+// the executor: tasks are stolen from the workers and executed on the calling
+// thread until |wait_source| resolves or no more tasks are available to steal,
+// after which the caller waits for any remaining work to complete. Tasks the
+// caller has begun executing must complete before the call returns and as such
+// the call may return slightly after |timeout| is exceeded.
 //
 // Donation is intended as an optimization to elide context switches when the
 // caller would have waited anyway; now instead of performing a kernel wait and
@@ -8,6 +8,7 @@
 #define IREE_TASK_EXECUTOR_IMPL_H_
 
 #include "iree/base/internal/math.h"
+#include "iree/base/internal/mpmc_queue.h"
 #include "iree/base/internal/prng.h"
 #include "iree/base/internal/synchronization.h"
 #include "iree/base/internal/wait_handle.h"
@@ -34,6 +35,19 @@ struct iree_task_executor_t {
   // TODO(benvanik): make mutable; currently always the same reserved value.
   iree_task_scheduling_mode_t scheduling_mode;
 
+  // Bytes of local memory each worker allocates when it starts. Workers grow
+  // their local memory beyond this on demand.
+  iree_host_size_t worker_local_memory_size;
+
+  // Maximum duration workers spin waiting for work before parking and whether
+  // they adapt the duration to observed idle periods.
+  iree_duration_t worker_spin_ns;
+  bool worker_spin_adaptive;
+
+  // Callback used to wake external workers that are run by host threads. If
+  // not set the workers each run on their own thread.
+  iree_task_executor_worker_wake_callback_t external_worker_wake;
+
   // State used by the work-stealing operations performed by donated threads.
   // This is **NOT SYNCHRONIZED** and relies on the fact that we actually don't
   // much care about the precise selection of workers enough to mind any tears
@@ -52,21 +66,17 @@ struct iree_task_executor_t {
   // Increasing the size larger than these will waste memory.
   iree_task_pool_t transient_task_pool;
 
-  // A list of incoming tasks that are ready to execute immediately.
-  // The list is LIFO and we require that task lists are reversed by the
-  // submitter so we can use iree_atomic_slist_concat to quickly prepend the
-  // LIFO list to the atomic slist. By doing this we can construct the task
-  // lists in LIFO order prior to submission, concat with a pointer swap into
-  // this list, flush from the list in LIFO order during coordination, and do a
-  // single LIFO->FIFO conversion while distributing work. What could have been
-  // half a dozen task list pointer walks and inverted sequential memory access
-  // becomes one.
+  // A FIFO queue of incoming tasks that are ready to execute immediately.
+  // Each task is enqueued individually by submitters (and workers retiring
+  // tasks) and dequeued in order during coordination. Unlike an atomic slist
+  // this retains the order of tasks across concurrent submissions such that
+  // earlier work is always scheduled first under contention.
   //
   // Example:
-  //   existing tasks: C B A
+  //   existing tasks: A B C
   //        new tasks: 1 2 3
-  //    updated tasks: 3 2 1 C B A
-  iree_atomic_task_slist_t incoming_ready_slist;
+  //    updated tasks: A B C 1 2 3
+  iree_mpmc_segmented_queue_t incoming_ready_queue;
 
   // iree_event_t pool used to acquire system wait handles.
   // Many subsystems interacting with the executor will need events to park
@@ -86,27 +96,34 @@ struct iree_task_executor_t {
   // existing computation on the workers to finish).
   iree_task_poller_t poller;
 
-  // A bitset indicating which workers are live and usable; all attempts to
+  // A set indicating which workers are live and usable; all attempts to
   // push work onto a particular worker should check first with this mask. This
   // may change over time either automatically or by user request ("don't use
   // these cores for awhile I'm going to be using them" etc).
-  iree_atomic_task_affinity_set_t worker_live_mask;
+  iree_atomic_task_worker_set_t worker_live_mask;
 
-  // A bitset indicating which workers may be suspended and need to be resumed
+  // A set indicating which workers may be suspended and need to be resumed
   // via iree_thread_resume prior to them being able to execute work.
-  iree_atomic_task_affinity_set_t worker_suspend_mask;
+  iree_atomic_task_worker_set_t worker_suspend_mask;
 
-  // A bitset indicating which workers are currently idle. Used to bias incoming
+  // A set indicating which workers are currently idle. Used to bias incoming
   // tasks to workers that aren't doing much else. This is a balance of latency
   // to wake the idle workers vs. latency to wait for existing work to complete
   // on already woken workers.
-  iree_atomic_task_affinity_set_t worker_idle_mask;
+  iree_atomic_task_worker_set_t worker_idle_mask;
 
   // Specifies how many workers threads there are.
   // For now this number is fixed per executor however if we wanted to enable
   // live join/leave behavior we could change this to a registration mechanism.
   iree_host_size_t worker_count;
   iree_task_worker_t* workers;  // [worker_count]
+
+  // Smallest cache sizes of the cores the workers are mapped to.
+  iree_task_topology_cache_sizes_t cache_sizes;
+
+  // Number of worker clusters the workers are partitioned into. Each cluster
+  // contains up to IREE_TASK_AFFINITY_SET_CLUSTER_WORKER_COUNT workers.
+  iree_host_size_t cluster_count;
 };
 
 // Merges a submission into the primary FIFO queues.
@@ -138,10 +155,17 @@ void iree_task_executor_coordinate(iree_task_executor_t* executor,
 // Tries to steal an entire task from a sibling worker (based on topology).
 // Returns a task that is available (has not yet begun processing at all).
 // May steal multiple tasks and add them to the |local_task_queue|.
+//
+// Victims are tried in order of locality: first those in the
+// |constructive_sharing_mask|, then those on the same NUMA node as indicated by
+// |numa_node_mask|, then any remaining worker in the thief's |cluster_index|,
+// and finally workers in any other cluster. Both masks are relative to
+// |cluster_index|.
 iree_task_t* iree_task_executor_try_steal_task(
-    iree_task_executor_t* executor,
+    iree_task_executor_t* executor, iree_host_size_t cluster_index,
     iree_task_affinity_set_t constructive_sharing_mask,
-    uint32_t max_theft_attempts, iree_prng_minilcg128_state_t* theft_prng,
+    iree_task_affinity_set_t numa_node_mask, uint32_t max_theft_attempts,
+    iree_prng_minilcg128_state_t* theft_prng,
     iree_task_queue_t* local_task_queue);
 
 #ifdef __cplusplus
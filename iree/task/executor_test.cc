@@ -6,9 +6,15 @@
 
 #include "iree/task/executor.h"
 
+#include <condition_variable>
 #include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #include "iree/base/internal/prng.h"
+#include "iree/base/internal/wait_handle.h"
 #include "iree/base/tracing.h"
 #include "iree/task/topology_cpuinfo.h"
 #include "iree/testing/gtest.h"
@@ -169,4 +175,465 @@ TEST(ExecutorTest, Any) {
   iree_task_executor_release(executor);
 }
 
+// Submits a dispatch of |tile_count| tiles each requiring |local_memory_size|
+// bytes of local memory to |executor| and waits for it to complete, returning
+// the number of tiles that were executed with valid local memory.
+static int32_t RunTileCountingDispatch(iree_task_executor_t* executor,
+                                       uint32_t tile_count,
+                                       uint32_t local_memory_size = 0) {
+  iree_task_scope_t scope_a;
+  iree_task_scope_initialize(iree_make_cstring_view("a"), &scope_a);
+
+  struct TileCountingContext {
+    uint32_t local_memory_size;
+    iree_atomic_int32_t executed_count;
+  } context = {local_memory_size, IREE_ATOMIC_VAR_INIT(0)};
+  const uint32_t workgroup_size[3] = {1, 1, 1};
+  const uint32_t workgroup_count[3] = {tile_count, 1, 1};
+  iree_task_dispatch_t dispatch;
+  iree_task_dispatch_initialize(
+      &scope_a,
+      iree_task_make_dispatch_closure(
+          [](void* user_context, const iree_task_tile_context_t* tile_context,
+             iree_task_submission_t* pending_submission) {
+            auto* context = (TileCountingContext*)user_context;
+            iree_byte_span_t local_memory = tile_context->local_memory;
+            if (local_memory.data_length != context->local_memory_size) {
+              return iree_ok_status();
+            }
+            if (local_memory.data_length) {
+              if ((uintptr_t)local_memory.data % iree_max_align_t) {
+                return iree_ok_status();
+              }
+              local_memory.data[0] = 1;
+              local_memory.data[local_memory.data_length - 1] = 1;
+            }
+            iree_atomic_fetch_add_int32(&context->executed_count, 1,
+                                        iree_memory_order_relaxed);
+            return iree_ok_status();
+          },
+          (void*)&context),
+      workgroup_size, workgroup_count, &dispatch);
+  dispatch.local_memory_size = local_memory_size;
+
+  iree_task_fence_t* fence = NULL;
+  IREE_CHECK_OK(iree_task_executor_acquire_fence(executor, &scope_a, &fence));
+  iree_task_set_completion_task(&dispatch.header, &fence->header);
+
+  iree_task_submission_t submission;
+  iree_task_submission_initialize(&submission);
+  iree_task_submission_enqueue(&submission, &dispatch.header);
+  iree_task_executor_submit(executor, &submission);
+  iree_task_executor_flush(executor);
+
+  IREE_CHECK_OK(iree_task_scope_wait_idle(&scope_a, IREE_TIME_INFINITE_FUTURE));
+  IREE_CHECK_OK(iree_task_scope_consume_status(&scope_a));
+  iree_task_scope_deinitialize(&scope_a);
+  return iree_atomic_load_int32(&context.executed_count,
+                                iree_memory_order_relaxed);
+}
+
+// Tests that executors with more workers than fit in a single worker cluster
+// distribute and complete all work.
+TEST(ExecutorTest, MultipleClusters) {
+  IREE_TRACE_SCOPE0("ExecutorTest::MultipleClusters");
+
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_group_count(/*group_count=*/100,
+                                                 &topology);
+  iree_task_executor_t* executor = NULL;
+  IREE_CHECK_OK(iree_task_executor_create(
+      IREE_TASK_SCHEDULING_MODE_RESERVED, &topology,
+      /*worker_local_memory_size=*/0, iree_allocator_system(), &executor));
+  iree_task_topology_deinitialize(&topology);
+
+  EXPECT_EQ(512, RunTileCountingDispatch(executor, 512));
+
+  iree_task_executor_release(executor);
+}
+
+// Tests that workers spinning while idle still pick up all work and exit.
+TEST(ExecutorTest, WorkerSpin) {
+  IREE_TRACE_SCOPE0("ExecutorTest::WorkerSpin");
+
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_group_count(/*group_count=*/4, &topology);
+  for (bool adaptive : {false, true}) {
+    iree_task_executor_options_t options;
+    iree_task_executor_options_initialize(&options);
+    options.worker_spin_ns = 100 * 1000;
+    options.worker_spin_adaptive = adaptive;
+    iree_task_executor_t* executor = NULL;
+    IREE_CHECK_OK(iree_task_executor_create_with_options(
+        &options, &topology, iree_allocator_system(), &executor));
+
+    // Run a few back-to-back dispatches such that workers are likely to
+    // receive new work while spinning.
+    for (int i = 0; i < 8; ++i) {
+      EXPECT_EQ(64, RunTileCountingDispatch(executor, 64));
+    }
+
+    iree_task_executor_release(executor);
+  }
+  iree_task_topology_deinitialize(&topology);
+}
+
+// Tests that invalid spin durations are rejected.
+TEST(ExecutorTest, WorkerSpinInvalid) {
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_group_count(/*group_count=*/1, &topology);
+  iree_task_executor_options_t options;
+  iree_task_executor_options_initialize(&options);
+  options.worker_spin_ns = -1;
+  iree_task_executor_t* executor = NULL;
+  iree_status_t status = iree_task_executor_create_with_options(
+      &options, &topology, iree_allocator_system(), &executor);
+  EXPECT_TRUE(iree_status_is_invalid_argument(status));
+  iree_status_ignore(status);
+  iree_task_topology_deinitialize(&topology);
+}
+
+// Runs a dispatch of |tile_count| tiles on |executor| and returns the thread
+// that executed each tile.
+static std::vector<std::thread::id> RunTileThreadRecordingDispatch(
+    iree_task_executor_t* executor, uint32_t tile_count) {
+  iree_task_scope_t scope_a;
+  iree_task_scope_initialize(iree_make_cstring_view("a"), &scope_a);
+
+  std::vector<std::thread::id> tile_threads(tile_count);
+  const uint32_t workgroup_size[3] = {1, 1, 1};
+  const uint32_t workgroup_count[3] = {tile_count, 1, 1};
+  iree_task_dispatch_t dispatch;
+  iree_task_dispatch_initialize(
+      &scope_a,
+      iree_task_make_dispatch_closure(
+          [](void* user_context, const iree_task_tile_context_t* tile_context,
+             iree_task_submission_t* pending_submission) {
+            auto* tile_threads = (std::vector<std::thread::id>*)user_context;
+            (*tile_threads)[tile_context->workgroup_xyz[0]] =
+                std::this_thread::get_id();
+            return iree_ok_status();
+          },
+          (void*)&tile_threads),
+      workgroup_size, workgroup_count, &dispatch);
+
+  iree_task_fence_t* fence = NULL;
+  IREE_CHECK_OK(iree_task_executor_acquire_fence(executor, &scope_a, &fence));
+  iree_task_set_completion_task(&dispatch.header, &fence->header);
+
+  iree_task_submission_t submission;
+  iree_task_submission_initialize(&submission);
+  iree_task_submission_enqueue(&submission, &dispatch.header);
+  iree_task_executor_submit(executor, &submission);
+  iree_task_executor_flush(executor);
+
+  IREE_CHECK_OK(iree_task_scope_wait_idle(&scope_a, IREE_TIME_INFINITE_FUTURE));
+  IREE_CHECK_OK(iree_task_scope_consume_status(&scope_a));
+  iree_task_scope_deinitialize(&scope_a);
+  return tile_threads;
+}
+
+// Tests that in deterministic mode each worker executes the same contiguous
+// slice of the grid on every run.
+TEST(ExecutorTest, DeterministicTileAssignment) {
+  IREE_TRACE_SCOPE0("ExecutorTest::DeterministicTileAssignment");
+
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_group_count(/*group_count=*/4, &topology);
+  iree_task_executor_t* executor = NULL;
+  IREE_CHECK_OK(iree_task_executor_create(
+      IREE_TASK_SCHEDULING_MODE_DETERMINISTIC, &topology,
+      /*worker_local_memory_size=*/0, iree_allocator_system(), &executor));
+  iree_task_topology_deinitialize(&topology);
+
+  // 4 shards of 16 tiles each; every tile of a slice runs on the same thread
+  // and each slice on a different one.
+  std::vector<std::thread::id> tile_threads =
+      RunTileThreadRecordingDispatch(executor, 64);
+  for (uint32_t i = 0; i < 64; ++i) {
+    EXPECT_EQ(tile_threads[i / 16 * 16], tile_threads[i]);
+  }
+  for (uint32_t i = 16; i < 64; i += 16) {
+    EXPECT_NE(tile_threads[i - 16], tile_threads[i]);
+  }
+
+  // Subsequent runs must produce the same assignment.
+  for (int run = 0; run < 4; ++run) {
+    EXPECT_EQ(tile_threads, RunTileThreadRecordingDispatch(executor, 64));
+  }
+
+  iree_task_executor_release(executor);
+}
+
+// Tests that worker local memory grows on demand beyond the initial size and
+// can be trimmed and regrown.
+TEST(ExecutorTest, WorkerLocalMemoryGrowth) {
+  IREE_TRACE_SCOPE0("ExecutorTest::WorkerLocalMemoryGrowth");
+
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_group_count(/*group_count=*/4, &topology);
+  iree_task_executor_t* executor = NULL;
+  IREE_CHECK_OK(iree_task_executor_create(
+      IREE_TASK_SCHEDULING_MODE_RESERVED, &topology,
+      /*worker_local_memory_size=*/4096, iree_allocator_system(), &executor));
+  iree_task_topology_deinitialize(&topology);
+
+  // Within the initial size, from the block pool, and from the system.
+  EXPECT_EQ(64, RunTileCountingDispatch(executor, 64, 1024));
+  EXPECT_EQ(64, RunTileCountingDispatch(executor, 64, 32 * 1024));
+  EXPECT_EQ(64, RunTileCountingDispatch(executor, 64, 1024 * 1024));
+  // Smaller dispatches reuse the high-water mark allocation.
+  EXPECT_EQ(64, RunTileCountingDispatch(executor, 64, 4096));
+
+  iree_task_executor_trim(executor);
+  EXPECT_EQ(64, RunTileCountingDispatch(executor, 64, 0));
+  EXPECT_EQ(64, RunTileCountingDispatch(executor, 64, 256 * 1024));
+
+  iree_task_executor_release(executor);
+}
+
+// Tests that per-worker statistics can be queried and stay consistent.
+TEST(ExecutorTest, QueryStatistics) {
+  IREE_TRACE_SCOPE0("ExecutorTest::QueryStatistics");
+
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_group_count(/*group_count=*/4, &topology);
+  iree_task_executor_t* executor = NULL;
+  IREE_CHECK_OK(iree_task_executor_create(
+      IREE_TASK_SCHEDULING_MODE_RESERVED, &topology,
+      /*worker_local_memory_size=*/0, iree_allocator_system(), &executor));
+  iree_task_topology_deinitialize(&topology);
+
+  // Querying with insufficient capacity returns the required count.
+  iree_host_size_t worker_count = 0;
+  iree_status_t status = iree_task_executor_query_statistics(
+      executor, /*worker_capacity=*/0, NULL, &worker_count);
+  EXPECT_TRUE(iree_status_is_out_of_range(status));
+  iree_status_ignore(status);
+  EXPECT_EQ(4, worker_count);
+
+  EXPECT_EQ(256, RunTileCountingDispatch(executor, 256));
+
+  std::vector<iree_task_worker_statistics_t> statistics(worker_count);
+  IREE_CHECK_OK(iree_task_executor_query_statistics(
+      executor, statistics.size(), statistics.data(), &worker_count));
+  uint64_t tile_count = 0;
+  for (const auto& worker : statistics) {
+    tile_count += worker.tile_count;
+    EXPECT_LE(worker.steal_success_count, worker.steal_attempt_count);
+    EXPECT_GE(worker.executing_ns, 0);
+    EXPECT_GE(worker.parked_ns, 0);
+  }
+  // Workers update their counters after retiring their tasks and may not have
+  // done so yet when the dispatch is observed as complete.
+  EXPECT_LE(tile_count, 256);
+
+  iree_task_executor_release(executor);
+}
+
+// Tests that the executor reports the smallest cache sizes of its groups.
+TEST(ExecutorTest, CacheSizes) {
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_group_count(/*group_count=*/3, &topology);
+  const iree_task_topology_cache_sizes_t group_cache_sizes[3] = {
+      {32 * 1024, 1024 * 1024, 0},
+      {48 * 1024, 512 * 1024, 8 * 1024 * 1024},
+      {32 * 1024, 2048 * 1024, 8 * 1024 * 1024},
+  };
+  for (iree_host_size_t i = 0; i < 3; ++i) {
+    topology.groups[i].cache_sizes = group_cache_sizes[i];
+  }
+  iree_task_executor_t* executor = NULL;
+  IREE_CHECK_OK(iree_task_executor_create(
+      IREE_TASK_SCHEDULING_MODE_RESERVED, &topology,
+      /*worker_local_memory_size=*/0, iree_allocator_system(), &executor));
+  iree_task_topology_deinitialize(&topology);
+
+  iree_task_topology_cache_sizes_t cache_sizes =
+      iree_task_executor_cache_sizes(executor);
+  EXPECT_EQ(32 * 1024, cache_sizes.l1d);
+  EXPECT_EQ(512 * 1024, cache_sizes.l2);
+  EXPECT_EQ(0, cache_sizes.l3);
+
+  iree_task_executor_release(executor);
+}
+
+// Tests that callers donated to the executor help execute the work they are
+// waiting on and return once it has completed.
+TEST(ExecutorTest, DonateCaller) {
+  IREE_TRACE_SCOPE0("ExecutorTest::DonateCaller");
+
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_group_count(/*group_count=*/2, &topology);
+  iree_task_executor_t* executor = NULL;
+  IREE_CHECK_OK(iree_task_executor_create(
+      IREE_TASK_SCHEDULING_MODE_RESERVED, &topology,
+      /*worker_local_memory_size=*/0, iree_allocator_system(), &executor));
+  iree_task_topology_deinitialize(&topology);
+
+  iree_task_scope_t scope_a;
+  iree_task_scope_initialize(iree_make_cstring_view("a"), &scope_a);
+  iree_event_t event;
+  IREE_CHECK_OK(iree_event_initialize(/*initial_state=*/false, &event));
+
+  // A dispatch requiring local memory followed by a call that signals the
+  // event the caller donates itself waiting on.
+  iree_atomic_int32_t executed_count = IREE_ATOMIC_VAR_INIT(0);
+  const uint32_t workgroup_size[3] = {1, 1, 1};
+  const uint32_t workgroup_count[3] = {256, 1, 1};
+  iree_task_dispatch_t dispatch;
+  iree_task_dispatch_initialize(
+      &scope_a,
+      iree_task_make_dispatch_closure(
+          [](void* user_context, const iree_task_tile_context_t* tile_context,
+             iree_task_submission_t* pending_submission) {
+            if (tile_context->local_memory.data_length != 1024) {
+              return iree_make_status(IREE_STATUS_INTERNAL);
+            }
+            simulate_work(tile_context);
+            iree_atomic_fetch_add_int32((iree_atomic_int32_t*)user_context, 1,
+                                        iree_memory_order_relaxed);
+            return iree_ok_status();
+          },
+          (void*)&executed_count),
+      workgroup_size, workgroup_count, &dispatch);
+  dispatch.local_memory_size = 1024;
+  iree_task_call_t call;
+  iree_task_call_initialize(
+      &scope_a,
+      iree_task_make_call_closure(
+          [](void* user_context, iree_task_t* task,
+             iree_task_submission_t* pending_submission) {
+            iree_event_set((iree_event_t*)user_context);
+            return iree_ok_status();
+          },
+          (void*)&event),
+      &call);
+  iree_task_set_completion_task(&dispatch.header, &call.header);
+
+  iree_task_submission_t submission;
+  iree_task_submission_initialize(&submission);
+  iree_task_submission_enqueue(&submission, &dispatch.header);
+  iree_task_executor_submit(executor, &submission);
+  IREE_CHECK_OK(iree_task_executor_donate_caller(
+      executor, iree_event_await(&event), iree_infinite_timeout()));
+  EXPECT_EQ(256, iree_atomic_load_int32(&executed_count,
+                                        iree_memory_order_relaxed));
+
+  IREE_CHECK_OK(iree_task_scope_wait_idle(&scope_a, IREE_TIME_INFINITE_FUTURE));
+  IREE_CHECK_OK(iree_task_scope_consume_status(&scope_a));
+  iree_event_deinitialize(&event);
+  iree_task_scope_deinitialize(&scope_a);
+  iree_task_executor_release(executor);
+}
+
+// A minimal host thread pool that runs external executor workers when woken.
+class HostThreadPool {
+ public:
+  explicit HostThreadPool(int thread_count) {
+    for (int i = 0; i < thread_count; ++i) {
+      threads_.emplace_back([this]() { Run(); });
+    }
+  }
+
+  ~HostThreadPool() { Stop(); }
+
+  // Runs all pending wakes and joins all threads.
+  void Stop() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      exiting_ = true;
+    }
+    cond_.notify_all();
+    for (auto& thread : threads_) thread.join();
+    threads_.clear();
+  }
+
+  void Attach(iree_task_executor_t* executor) { executor_ = executor; }
+
+  iree_task_executor_worker_wake_callback_t wake_callback() {
+    iree_task_executor_worker_wake_callback_t callback;
+    callback.fn = [](void* user_data, iree_host_size_t worker_index) {
+      auto* pool = (HostThreadPool*)user_data;
+      {
+        std::lock_guard<std::mutex> lock(pool->mutex_);
+        pool->pending_.push_back(worker_index);
+        ++pool->wake_count_;
+      }
+      pool->cond_.notify_one();
+    };
+    callback.user_data = this;
+    return callback;
+  }
+
+  int wake_count() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return wake_count_;
+  }
+
+ private:
+  void Run() {
+    while (true) {
+      iree_host_size_t worker_index = 0;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_.wait(lock, [this]() { return exiting_ || !pending_.empty(); });
+        if (pending_.empty()) return;
+        worker_index = pending_.front();
+        pending_.pop_front();
+      }
+      IREE_CHECK_OK(iree_task_executor_run_worker(executor_, worker_index));
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::deque<iree_host_size_t> pending_;
+  bool exiting_ = false;
+  int wake_count_ = 0;
+  iree_task_executor_t* executor_ = NULL;
+  std::vector<std::thread> threads_;
+};
+
+// Tests that executors with external workers run all work on host threads.
+TEST(ExecutorTest, ExternalWorkers) {
+  IREE_TRACE_SCOPE0("ExecutorTest::ExternalWorkers");
+
+  HostThreadPool pool(/*thread_count=*/3);
+
+  iree_task_topology_t topology;
+  iree_task_topology_initialize_from_group_count(/*group_count=*/4, &topology);
+  iree_task_executor_options_t options;
+  iree_task_executor_options_initialize(&options);
+  options.external_worker_wake = pool.wake_callback();
+  iree_task_executor_t* executor = NULL;
+  IREE_CHECK_OK(iree_task_executor_create_with_options(
+      &options, &topology, iree_allocator_system(), &executor));
+  iree_task_topology_deinitialize(&topology);
+  pool.Attach(executor);
+
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_EQ(256, RunTileCountingDispatch(executor, 256, 1024));
+  }
+  EXPECT_GT(pool.wake_count(), 0);
+
+  // Running workers on executors with their own threads is not allowed.
+  iree_task_executor_t* threaded_executor = NULL;
+  iree_task_topology_initialize_from_group_count(/*group_count=*/1, &topology);
+  IREE_CHECK_OK(iree_task_executor_create(
+      IREE_TASK_SCHEDULING_MODE_RESERVED, &topology,
+      /*worker_local_memory_size=*/0, iree_allocator_system(),
+      &threaded_executor));
+  iree_task_topology_deinitialize(&topology);
+  iree_status_t status = iree_task_executor_run_worker(threaded_executor, 0);
+  EXPECT_TRUE(iree_status_is_failed_precondition(status));
+  iree_status_ignore(status);
+  iree_task_executor_release(threaded_executor);
+
+  // Workers may still be running after their tasks have retired so stop the
+  // pool before releasing the executor.
+  pool.Stop();
+  iree_task_executor_release(executor);
+}
+
 }  // namespace
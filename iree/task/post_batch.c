@@ -22,9 +22,21 @@ void iree_task_post_batch_initialize(iree_task_executor_t* executor,
                                      iree_task_post_batch_t* out_post_batch) {
   out_post_batch->executor = executor;
   out_post_batch->current_worker = current_worker;
-  out_post_batch->worker_pending_mask = 0;
+  out_post_batch->cluster_pending_mask = 0;
+  memset(&out_post_batch->worker_pending_masks, 0,
+         sizeof(out_post_batch->worker_pending_masks));
   memset(&out_post_batch->worker_pending_lifos, 0,
-         executor->worker_count * sizeof(iree_task_list_t));
+         IREE_TASK_PRIORITY_COUNT * executor->worker_count *
+             sizeof(iree_task_list_t));
+}
+
+// Returns the pending task list for |worker_index| at |priority|.
+static inline iree_task_list_t* iree_task_post_batch_pending_lifo(
+    iree_task_post_batch_t* post_batch, iree_task_priority_t priority,
+    iree_host_size_t worker_index) {
+  iree_host_size_t worker_count = post_batch->executor->worker_count;
+  return &post_batch->worker_pending_lifos[priority * worker_count +
+                                           worker_index];
 }
 
 iree_host_size_t iree_task_post_batch_worker_count(
@@ -32,33 +44,75 @@ iree_host_size_t iree_task_post_batch_worker_count(
   return post_batch->executor->worker_count;
 }
 
-static iree_host_size_t iree_task_post_batch_select_random_worker(
-    iree_task_post_batch_t* post_batch, iree_task_affinity_set_t affinity_set) {
-  iree_task_affinity_set_t worker_live_mask =
-      iree_atomic_task_affinity_set_load(
-          &post_batch->executor->worker_live_mask, iree_memory_order_relaxed);
-  iree_task_affinity_set_t valid_worker_mask = affinity_set & worker_live_mask;
-  if (!valid_worker_mask) {
-    // No valid workers as desired; for now just bail to worker 0.
-    return 0;
+// Scans the clusters that may have bits set in |worker_set| and returns the
+// first live worker that is in both |worker_set| and |affinity_set|. Clusters
+// are scanned starting with the one the current worker is in (if any) so that
+// work stays close to where it was produced; in deterministic scheduling mode
+// scanning always starts with the first cluster. If |exclude_pending| is true
+// then workers already holding pending tasks in the batch are skipped.
+static bool iree_task_post_batch_find_worker(
+    iree_task_post_batch_t* post_batch,
+    iree_atomic_task_worker_set_t* worker_set, bool exclude_pending,
+    iree_task_affinity_set_t affinity_set, iree_host_size_t* out_worker_index) {
+  iree_task_executor_t* executor = post_batch->executor;
+  iree_task_cluster_mask_t cluster_mask =
+      iree_atomic_task_worker_set_load_clusters(worker_set,
+                                                iree_memory_order_relaxed);
+  iree_host_size_t base_cluster_index =
+      post_batch->current_worker &&
+              !(executor->scheduling_mode &
+                IREE_TASK_SCHEDULING_MODE_DETERMINISTIC)
+          ? post_batch->current_worker->cluster_index
+          : 0;
+  for (iree_host_size_t i = 0; i < executor->cluster_count && cluster_mask;
+       ++i) {
+    iree_host_size_t cluster_index =
+        (base_cluster_index + i) % executor->cluster_count;
+    if (!(cluster_mask & (1ull << cluster_index))) continue;
+    iree_task_affinity_set_t worker_mask =
+        affinity_set &
+        iree_atomic_task_worker_set_load(worker_set, cluster_index,
+                                         iree_memory_order_relaxed) &
+        iree_atomic_task_worker_set_load(&executor->worker_live_mask,
+                                         cluster_index,
+                                         iree_memory_order_relaxed);
+    if (exclude_pending) {
+      worker_mask &= ~post_batch->worker_pending_masks[cluster_index];
+    }
+    if (worker_mask) {
+      *out_worker_index = iree_task_affinity_worker_index(
+          cluster_index,
+          iree_task_affinity_set_count_trailing_zeros(worker_mask));
+      return true;
+    }
   }
-
-  // TODO(benvanik): rotate through workers here. Instead, if the affinity set
-  // has the current_worker allowed we just use that to avoid needing a
-  // cross-thread hop.
-  return iree_task_affinity_set_count_trailing_zeros(valid_worker_mask);
+  return false;
 }
 
 iree_host_size_t iree_task_post_batch_select_worker(
     iree_task_post_batch_t* post_batch, iree_task_affinity_set_t affinity_set) {
-  if (post_batch->current_worker) {
+  iree_host_size_t worker_index = 0;
+  if (post_batch->executor->scheduling_mode &
+      IREE_TASK_SCHEDULING_MODE_DETERMINISTIC) {
+    // Placement must not depend on which worker is posting or which workers
+    // happen to be idle right now; always use the first eligible worker.
+    iree_task_post_batch_find_worker(
+        post_batch, &post_batch->executor->worker_live_mask,
+        /*exclude_pending=*/false, affinity_set, &worker_index);
+    return worker_index;
+  }
+
+  iree_task_worker_t* current_worker = post_batch->current_worker;
+  if (current_worker) {
     // Posting from a worker - prefer sending right back to this worker if we
     // haven't already scheduled for it.
-    if ((affinity_set & post_batch->current_worker->worker_bit) &&
-        !(post_batch->worker_pending_mask &
-          post_batch->current_worker->worker_bit)) {
-      return iree_task_affinity_set_count_trailing_zeros(
-          post_batch->current_worker->worker_bit);
+    if ((affinity_set & current_worker->worker_bit) &&
+        !(post_batch->worker_pending_masks[current_worker->cluster_index] &
+          current_worker->worker_bit)) {
+      return iree_task_affinity_worker_index(
+          current_worker->cluster_index,
+          iree_task_affinity_set_count_trailing_zeros(
+              current_worker->worker_bit));
     }
   }
 
@@ -68,33 +122,45 @@ iree_host_size_t iree_task_post_batch_select_worker(
   // worker's queue to finish. Note that we only consider workers idle if we
   // ourselves in this batch haven't already queued work for them (as then they
   // aren't going to be idle).
-  iree_task_affinity_set_t worker_idle_mask =
-      iree_atomic_task_affinity_set_load(
-          &post_batch->executor->worker_idle_mask, iree_memory_order_relaxed);
-  worker_idle_mask &= ~post_batch->worker_pending_mask;
-  iree_task_affinity_set_t idle_affinity_set = affinity_set & worker_idle_mask;
-  if (idle_affinity_set) {
-    return iree_task_post_batch_select_random_worker(post_batch,
-                                                     idle_affinity_set);
+  if (iree_task_post_batch_find_worker(
+          post_batch, &post_batch->executor->worker_idle_mask,
+          /*exclude_pending=*/true, affinity_set, &worker_index)) {
+    return worker_index;
   }
 
   // No more workers are idle; farm out at random. In the worst case work
   // stealing will help balance things out on the backend.
-  return iree_task_post_batch_select_random_worker(post_batch, affinity_set);
+  // TODO(benvanik): rotate through workers here. Instead, if the affinity set
+  // has the current_worker allowed we just use that to avoid needing a
+  // cross-thread hop.
+  if (iree_task_post_batch_find_worker(
+          post_batch, &post_batch->executor->worker_live_mask,
+          /*exclude_pending=*/false, affinity_set, &worker_index)) {
+    return worker_index;
+  }
+
+  // No valid workers as desired; for now just bail to worker 0.
+  return 0;
 }
 
 void iree_task_post_batch_enqueue(iree_task_post_batch_t* post_batch,
                                   iree_host_size_t worker_index,
                                   iree_task_t* task) {
-  iree_task_list_push_front(&post_batch->worker_pending_lifos[worker_index],
-                            task);
-  post_batch->worker_pending_mask |=
+  iree_task_priority_t priority = iree_task_scope_priority(task->scope);
+  iree_task_list_push_front(
+      iree_task_post_batch_pending_lifo(post_batch, priority, worker_index),
+      task);
+  iree_host_size_t cluster_index =
+      iree_task_affinity_cluster_for_worker(worker_index);
+  post_batch->worker_pending_masks[cluster_index] |=
       iree_task_affinity_for_worker(worker_index);
+  post_batch->cluster_pending_mask |= 1ull << cluster_index;
 }
 
-// Wakes each worker indicated in the |wake_mask|, if needed.
+// Wakes each worker in |cluster_index| indicated in the |wake_mask|, if needed.
 static void iree_task_post_batch_wake_workers(
-    iree_task_post_batch_t* post_batch, iree_task_affinity_set_t wake_mask) {
+    iree_task_post_batch_t* post_batch, iree_host_size_t cluster_index,
+    iree_task_affinity_set_t wake_mask) {
   IREE_TRACE_ZONE_BEGIN(z0);
   IREE_TRACE_ZONE_APPEND_VALUE(z0, iree_math_count_ones_u64(wake_mask));
 
@@ -103,88 +169,124 @@ static void iree_task_post_batch_wake_workers(
   // Wake workers that may be suspended. We fetch the set of workers we need to
   // wake (hopefully none in the common case) and mark that we've woken them so
   // that we don't double-resume.
-  iree_task_affinity_set_t resume_mask =
-      iree_atomic_task_affinity_set_fetch_and(&executor->worker_suspend_mask,
-                                              ~wake_mask,
-                                              iree_memory_order_acquire);
+  iree_task_affinity_set_t resume_mask = iree_atomic_task_worker_set_fetch_and(
+      &executor->worker_suspend_mask, cluster_index, ~wake_mask,
+      iree_memory_order_acquire);
   resume_mask &= wake_mask;
   if (IREE_UNLIKELY(resume_mask)) {
     int resume_count = iree_task_affinity_set_count_ones(resume_mask);
-    int worker_index = 0;
+    int worker_bit = 0;
     for (int i = 0; i < resume_count; ++i) {
-      int offset = iree_task_affinity_set_count_trailing_zeros(resume_mask) + 1;
-      int resume_index = worker_index + offset;
-      worker_index += offset + 1;
+      int offset = iree_task_affinity_set_count_trailing_zeros(resume_mask);
+      int resume_bit = worker_bit + offset;
+      worker_bit += offset + 1;
       resume_mask = iree_shr(resume_mask, offset + 1);
-      iree_thread_resume(executor->workers[resume_index].thread);
+      iree_thread_resume(
+          executor
+              ->workers[iree_task_affinity_worker_index(cluster_index,
+                                                        resume_bit)]
+              .thread);
     }
   }
 
-  // TODO(#4016): use a FUTEX_WAKE_BITSET here to wake all of the workers that
-  // have pending work in a single syscall (vs. popcnt(worker_pending_mask)
-  // syscalls). This will reduce wake latency for workers later in the set;
-  // for example today worker[31] will wait until workers[0-30] have had their
-  // syscalls performed before it's even requested to wake. This also loses
-  // information the kernel could use to avoid core migration as it knows when N
-  // threads will be needed simultaneously and can hopefully perform any needed
-  // migrations prior to beginning execution.
+  // Post the notifications of all workers together so that workers later in
+  // the set don't have to wait for the wakes of all prior workers before they
+  // can observe that they have work: spinning workers and those that have not
+  // yet gone to sleep see it immediately and only workers actually waiting in
+  // the kernel cost a syscall. Workers are the only thing that can wait on
+  // these notifications so posting is almost always either free (an atomic
+  // RMW) or required to actually wake the worker.
+  iree_notification_t* notifications[64];
+  iree_host_size_t notification_count = 0;
   int wake_count = iree_task_affinity_set_count_ones(wake_mask);
-  int worker_index = 0;
+  int worker_bit = 0;
   for (int i = 0; i < wake_count; ++i) {
     int offset = iree_task_affinity_set_count_trailing_zeros(wake_mask);
-    int wake_index = worker_index + offset;
-    worker_index += offset + 1;
+    int wake_bit = worker_bit + offset;
+    worker_bit += offset + 1;
     wake_mask = iree_shr(wake_mask, offset + 1);
-
-    // Wake workers if they are waiting - workers are the only thing that can
-    // wait on this notification so this should almost always be either free (an
-    // atomic load) if a particular worker isn't waiting or it's required to
-    // actually wake it and we can't avoid it.
-    iree_task_worker_t* worker = &executor->workers[wake_index];
-    iree_notification_post(&worker->wake_notification, 1);
+    iree_task_worker_t* worker =
+        &executor->workers[iree_task_affinity_worker_index(cluster_index,
+                                                           wake_bit)];
+    if (executor->external_worker_wake.fn) {
+      // Workers running on host threads are woken by their callback.
+      iree_task_worker_wake(worker);
+    } else {
+      notifications[notification_count++] = &worker->wake_notification;
+    }
   }
+  iree_notification_post_many(notifications, notification_count, 1);
 
   IREE_TRACE_ZONE_END(z0);
 }
 
-bool iree_task_post_batch_submit(iree_task_post_batch_t* post_batch) {
-  if (!post_batch->worker_pending_mask) return false;
-
-  IREE_TRACE_ZONE_BEGIN(z0);
-
+// Posts the pending tasks of all workers in |cluster_index| and wakes them.
+// Returns the number of workers posted to.
+static int iree_task_post_batch_submit_cluster(
+    iree_task_post_batch_t* post_batch, iree_host_size_t cluster_index) {
   // Run through each worker that has a bit set in the pending mask and post
   // the pending tasks.
-  iree_task_affinity_set_t worker_mask = post_batch->worker_pending_mask;
-  post_batch->worker_pending_mask = 0;
-  int worker_index = 0;
+  iree_task_affinity_set_t worker_mask =
+      post_batch->worker_pending_masks[cluster_index];
+  post_batch->worker_pending_masks[cluster_index] = 0;
+  int worker_bit = 0;
   int post_count = iree_task_affinity_set_count_ones(worker_mask);
   iree_task_affinity_set_t worker_wake_mask = 0;
   for (int i = 0; i < post_count; ++i) {
     int offset = iree_task_affinity_set_count_trailing_zeros(worker_mask);
-    int target_index = worker_index + offset;
-    worker_index += offset + 1;
+    int target_bit = worker_bit + offset;
+    worker_bit += offset + 1;
     worker_mask = iree_shr(worker_mask, offset + 1);
 
+    iree_host_size_t target_index =
+        iree_task_affinity_worker_index(cluster_index, target_bit);
     iree_task_worker_t* worker = &post_batch->executor->workers[target_index];
-    iree_task_list_t* target_pending_lifo =
-        &post_batch->worker_pending_lifos[target_index];
-    if (worker == post_batch->current_worker) {
-      // Fast-path for posting to self; this happens when a worker plays the
-      // role of coordinator and we want to ensure we aren't doing a fully
-      // block-and-flush loop when we could just be popping the next new task
-      // off the list.
-      iree_task_queue_append_from_lifo_list_unsafe(&worker->local_task_queue,
-                                                   target_pending_lifo);
-    } else {
-      iree_task_worker_post_tasks(worker, target_pending_lifo);
-      worker_wake_mask |= iree_task_affinity_for_worker(target_index);
+    for (int priority = 0; priority < IREE_TASK_PRIORITY_COUNT; ++priority) {
+      iree_task_list_t* target_pending_lifo = iree_task_post_batch_pending_lifo(
+          post_batch, (iree_task_priority_t)priority, target_index);
+      if (iree_task_list_is_empty(target_pending_lifo)) continue;
+      if (worker == post_batch->current_worker) {
+        // Fast-path for posting to self; this happens when a worker plays the
+        // role of coordinator and we want to ensure we aren't doing a fully
+        // block-and-flush loop when we could just be popping the next new
+        // task off the list.
+        iree_task_queue_append_from_lifo_list_unsafe(
+            iree_task_worker_queue_for_priority(worker, priority),
+            target_pending_lifo);
+      } else {
+        iree_task_worker_post_tasks(worker, priority, target_pending_lifo);
+        worker_wake_mask |= iree_task_affinity_for_worker(target_index);
+      }
     }
   }
 
   // Wake all workers that now have pending work. If a worker is not already
   // waiting this will be cheap (no syscall).
   if (worker_wake_mask != 0) {
-    iree_task_post_batch_wake_workers(post_batch, worker_wake_mask);
+    iree_task_post_batch_wake_workers(post_batch, cluster_index,
+                                      worker_wake_mask);
+  }
+
+  return post_count;
+}
+
+bool iree_task_post_batch_submit(iree_task_post_batch_t* post_batch) {
+  if (!post_batch->cluster_pending_mask) return false;
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Run through each cluster that has any workers with pending tasks.
+  iree_task_cluster_mask_t cluster_mask = post_batch->cluster_pending_mask;
+  post_batch->cluster_pending_mask = 0;
+  int post_count = 0;
+  iree_host_size_t cluster_index = 0;
+  while (cluster_mask) {
+    int offset = iree_math_count_trailing_zeros_u64(cluster_mask);
+    cluster_index += offset;
+    cluster_mask = iree_shr(cluster_mask, offset + 1);
+    post_count +=
+        iree_task_post_batch_submit_cluster(post_batch, cluster_index);
+    ++cluster_index;
   }
 
   IREE_TRACE_ZONE_END(z0);
@@ -13,6 +13,7 @@
 #include "iree/task/affinity_set.h"
 #include "iree/task/executor.h"
 #include "iree/task/list.h"
+#include "iree/task/scope.h"
 #include "iree/task/task.h"
 #include "iree/task/tuning.h"
 
@@ -35,14 +36,29 @@ typedef struct iree_task_post_batch_t {
   // May be NULL if not being posted from a worker (such as a submission).
   iree_task_worker_t* current_worker;
 
-  // A bitmask of workers indicating which have pending tasks in their lists.
-  // Used to quickly scan the lists and perform the posts only when required.
-  iree_task_affinity_set_t worker_pending_mask;
+  // A bitmask of clusters indicating which have bits set in
+  // |worker_pending_masks|.
+  iree_task_cluster_mask_t cluster_pending_mask;
 
-  // A per-worker LIFO task list waiting to be posted.
+  // Per-cluster bitmasks of workers indicating which have pending tasks in
+  // their lists. Used to quickly scan the lists and perform the posts only when
+  // required.
+  iree_task_affinity_set_t
+      worker_pending_masks[IREE_TASK_EXECUTOR_MAX_CLUSTER_COUNT];
+
+  // A per-worker LIFO task list waiting to be posted for each priority.
+  // Indexed by priority * worker_count + worker_index; see
+  // iree_task_post_batch_size.
   iree_task_list_t worker_pending_lifos[0];
 } iree_task_post_batch_t;
 
+// Returns the total size in bytes of a post batch for |worker_count| workers.
+static inline iree_host_size_t iree_task_post_batch_size(
+    iree_host_size_t worker_count) {
+  return sizeof(iree_task_post_batch_t) +
+         IREE_TASK_PRIORITY_COUNT * worker_count * sizeof(iree_task_list_t);
+}
+
 void iree_task_post_batch_initialize(iree_task_executor_t* executor,
                                      iree_task_worker_t* current_worker,
                                      iree_task_post_batch_t* out_post_batch);
@@ -57,7 +73,8 @@ iree_host_size_t iree_task_post_batch_select_worker(
 
 // Enqueues a task to the given worker. Note that the pending work lists for
 // each work is kept in LIFO order so that we can easily concatenate it with the
-// worker mailbox slist that's in LIFO order.
+// worker mailbox slist that's in LIFO order. Tasks are posted to the worker
+// mailbox matching the priority of their scope.
 void iree_task_post_batch_enqueue(iree_task_post_batch_t* post_batch,
                                   iree_host_size_t worker_index,
                                   iree_task_t* task);
@@ -9,82 +9,212 @@
 #include <stddef.h>
 #include <string.h>
 
+static_assert((IREE_TASK_QUEUE_CAPACITY & (IREE_TASK_QUEUE_CAPACITY - 1)) == 0,
+              "queue capacity must be a power of two");
+
+#define iree_task_queue_slot(queue, index) \
+  (&(queue)->tasks[(index) & (IREE_TASK_QUEUE_CAPACITY - 1)])
+
 void iree_task_queue_initialize(iree_task_queue_t* out_queue) {
   memset(out_queue, 0, sizeof(*out_queue));
-  iree_slim_mutex_initialize(&out_queue->mutex);
-  iree_task_list_initialize(&out_queue->list);
+  iree_task_list_initialize(&out_queue->overflow_list);
 }
 
 void iree_task_queue_deinitialize(iree_task_queue_t* queue) {
-  iree_task_list_discard(&queue->list);
-  iree_slim_mutex_deinitialize(&queue->mutex);
+  // Gather all remaining tasks so that they can be discarded together.
+  iree_task_list_t list;
+  iree_task_list_initialize(&list);
+  iree_task_t* task = NULL;
+  while ((task = iree_task_queue_pop_front(queue)) != NULL) {
+    iree_task_list_push_back(&list, task);
+  }
+  iree_task_list_discard(&list);
+}
+
+// Returns the number of tasks in the deque (excluding the overflow list) as
+// seen by the owner.
+static int64_t iree_task_queue_deque_size(iree_task_queue_t* queue) {
+  int64_t bottom =
+      iree_atomic_load_int64(&queue->bottom, iree_memory_order_relaxed);
+  int64_t top = iree_atomic_load_int64(&queue->top, iree_memory_order_acquire);
+  return bottom - top;
 }
 
 bool iree_task_queue_is_empty(iree_task_queue_t* queue) {
-  iree_slim_mutex_lock(&queue->mutex);
-  bool is_empty = iree_task_list_is_empty(&queue->list);
-  iree_slim_mutex_unlock(&queue->mutex);
-  return is_empty;
+  return !queue->front_task && iree_task_queue_deque_size(queue) <= 0 &&
+         iree_task_list_is_empty(&queue->overflow_list);
+}
+
+// Moves up to the available capacity of tasks from the FIFO |list| to the
+// bottom of the deque such that the first task in the list is the next popped.
+// Tasks that do not fit remain in |list|.
+static void iree_task_queue_fill_from_fifo_list(iree_task_queue_t* queue,
+                                                iree_task_list_t* list) {
+  int64_t bottom =
+      iree_atomic_load_int64(&queue->bottom, iree_memory_order_relaxed);
+  int64_t top = iree_atomic_load_int64(&queue->top, iree_memory_order_acquire);
+  int64_t available = IREE_TASK_QUEUE_CAPACITY - (bottom - top);
+  if (available <= 0 || iree_task_list_is_empty(list)) return;
+
+  // Count how many tasks we'll be pushing so that we can place the first task
+  // of the list at the very bottom.
+  int64_t count = 0;
+  for (iree_task_t* p = list->head; p && count < available; p = p->next_task) {
+    ++count;
+  }
+
+  // Fill in the slots from the bottom up; the slots are not visible to thieves
+  // until we publish the new bottom below.
+  for (int64_t i = count - 1; i >= 0; --i) {
+    iree_task_t* task = iree_task_list_pop_front(list);
+    iree_atomic_store_intptr(iree_task_queue_slot(queue, bottom + i),
+                             (intptr_t)task, iree_memory_order_relaxed);
+  }
+  iree_atomic_thread_fence(iree_memory_order_release);
+  iree_atomic_store_int64(&queue->bottom, bottom + count,
+                          iree_memory_order_relaxed);
+}
+
+// Pushes all tasks from the FIFO |list| to the queue such that the first task
+// in the list is the next popped. Tasks that do not fit in the deque are moved
+// to the overflow list.
+static void iree_task_queue_push_fifo_list(iree_task_queue_t* queue,
+                                           iree_task_list_t* list) {
+  iree_task_queue_fill_from_fifo_list(queue, list);
+  if (!iree_task_list_is_empty(list)) {
+    iree_task_list_append(&queue->overflow_list, list);
+  }
 }
 
 void iree_task_queue_push_front(iree_task_queue_t* queue, iree_task_t* task) {
-  iree_slim_mutex_lock(&queue->mutex);
-  iree_task_list_push_front(&queue->list, task);
-  iree_slim_mutex_unlock(&queue->mutex);
+  if (iree_task_queue_deque_size(queue) >= IREE_TASK_QUEUE_CAPACITY) {
+    // Deque is full; hold the task in the front slot so that it is still the
+    // next popped. A task already in the slot is no longer next and goes
+    // ahead of the overflow list.
+    if (queue->front_task) {
+      iree_task_list_push_front(&queue->overflow_list, queue->front_task);
+    }
+    queue->front_task = task;
+    return;
+  }
+  iree_task_list_t list;
+  iree_task_list_initialize(&list);
+  iree_task_list_push_back(&list, task);
+  iree_task_queue_fill_from_fifo_list(queue, &list);
 }
 
 void iree_task_queue_append_from_lifo_list_unsafe(iree_task_queue_t* queue,
                                                   iree_task_list_t* list) {
-  // NOTE: reversing the list outside of the lock.
   iree_task_list_reverse(list);
-  iree_slim_mutex_lock(&queue->mutex);
-  iree_task_list_append(&queue->list, list);
-  iree_slim_mutex_unlock(&queue->mutex);
+  iree_task_queue_push_fifo_list(queue, list);
 }
 
 iree_task_t* iree_task_queue_flush_from_lifo_slist(
     iree_task_queue_t* queue, iree_atomic_task_slist_t* source_slist) {
-  // Perform the flush and swap outside of the lock; acquiring the list is
-  // atomic and then we own it exclusively.
+  // Acquiring the list is atomic and then we own it exclusively.
   iree_task_list_t suffix;
   iree_task_list_initialize(&suffix);
   const bool did_flush = iree_atomic_task_slist_flush(
       source_slist, IREE_ATOMIC_SLIST_FLUSH_ORDER_APPROXIMATE_FIFO,
       &suffix.head, &suffix.tail);
 
-  // Append the tasks and pop off the front for return.
-  iree_slim_mutex_lock(&queue->mutex);
-  if (did_flush) iree_task_list_append(&queue->list, &suffix);
-  iree_task_t* next_task = iree_task_list_pop_front(&queue->list);
-  iree_slim_mutex_unlock(&queue->mutex);
+  // Push the tasks and pop off the front for return.
+  if (did_flush) iree_task_queue_push_fifo_list(queue, &suffix);
+  return iree_task_queue_pop_front(queue);
+}
 
-  return next_task;
+// Pops a task from the bottom of the deque, racing thieves for the last task.
+static iree_task_t* iree_task_queue_pop_deque(iree_task_queue_t* queue) {
+  int64_t bottom =
+      iree_atomic_load_int64(&queue->bottom, iree_memory_order_relaxed) - 1;
+  iree_atomic_store_int64(&queue->bottom, bottom, iree_memory_order_relaxed);
+  iree_atomic_thread_fence(iree_memory_order_seq_cst);
+  int64_t top = iree_atomic_load_int64(&queue->top, iree_memory_order_relaxed);
+  if (top > bottom) {
+    // Empty; restore bottom.
+    iree_atomic_store_int64(&queue->bottom, bottom + 1,
+                            iree_memory_order_relaxed);
+    return NULL;
+  }
+  iree_task_t* task = (iree_task_t*)iree_atomic_load_intptr(
+      iree_task_queue_slot(queue, bottom), iree_memory_order_relaxed);
+  if (top == bottom) {
+    // Last task in the deque; race any thieves for it.
+    if (!iree_atomic_compare_exchange_strong_int64(
+            &queue->top, &top, top + 1, iree_memory_order_seq_cst,
+            iree_memory_order_relaxed)) {
+      task = NULL;  // lost the race
+    }
+    iree_atomic_store_int64(&queue->bottom, bottom + 1,
+                            iree_memory_order_relaxed);
+  }
+  return task;
 }
 
 iree_task_t* iree_task_queue_pop_front(iree_task_queue_t* queue) {
-  iree_slim_mutex_lock(&queue->mutex);
-  iree_task_t* next_task = iree_task_list_pop_front(&queue->list);
-  iree_slim_mutex_unlock(&queue->mutex);
-  return next_task;
+  if (queue->front_task) {
+    iree_task_t* task = queue->front_task;
+    queue->front_task = NULL;
+    return task;
+  }
+
+  iree_task_t* task = iree_task_queue_pop_deque(queue);
+  if (task || iree_task_list_is_empty(&queue->overflow_list)) return task;
+
+  // Deque has drained; refill it from the overflow list so that the tasks are
+  // available to thieves again.
+  iree_task_queue_fill_from_fifo_list(queue, &queue->overflow_list);
+  return iree_task_queue_pop_deque(queue);
+}
+
+// Tries to steal a single task from the top of the deque.
+// Returns NULL if the deque was empty or another thread took the task first.
+static iree_task_t* iree_task_queue_steal_one(iree_task_queue_t* queue,
+                                              int64_t* out_size) {
+  int64_t top = iree_atomic_load_int64(&queue->top, iree_memory_order_acquire);
+  iree_atomic_thread_fence(iree_memory_order_seq_cst);
+  int64_t bottom =
+      iree_atomic_load_int64(&queue->bottom, iree_memory_order_acquire);
+  *out_size = bottom - top;
+  if (top >= bottom) return NULL;
+  iree_task_t* task = (iree_task_t*)iree_atomic_load_intptr(
+      iree_task_queue_slot(queue, top), iree_memory_order_relaxed);
+  if (!iree_atomic_compare_exchange_strong_int64(&queue->top, &top, top + 1,
+                                                 iree_memory_order_seq_cst,
+                                                 iree_memory_order_relaxed)) {
+    return NULL;  // lost the race to the owner or another thief
+  }
+  return task;
 }
 
 iree_task_t* iree_task_queue_try_steal(iree_task_queue_t* source_queue,
                                        iree_task_queue_t* target_queue,
                                        iree_host_size_t max_tasks) {
-  // First attempt to steal up to max_tasks from the source queue.
+  // Steal the first task; this also tells us how many tasks there were so that
+  // we can take up to half of them. We always take the last task as the victim
+  // is likely working on their last item and we can help them out by popping
+  // this off. It also has the side-effect of handling cases of donated workers
+  // wanting to steal all tasks to synchronously execute things.
+  int64_t size = 0;
+  iree_task_t* first_task = iree_task_queue_steal_one(source_queue, &size);
+  if (!first_task) return NULL;
+  int64_t steal_count = iree_min((int64_t)max_tasks, (size + 1) / 2);
+
+  // Tasks at the top of the deque are the last the victim would have gotten to
+  // so each additional task taken precedes the prior one in FIFO order.
   iree_task_list_t stolen_tasks;
   iree_task_list_initialize(&stolen_tasks);
-  iree_slim_mutex_lock(&source_queue->mutex);
-  iree_task_list_split(&source_queue->list, max_tasks, &stolen_tasks);
-  iree_slim_mutex_unlock(&source_queue->mutex);
-
-  // Add any stolen tasks to the target queue and pop off the head for return.
-  iree_task_t* next_task = NULL;
-  if (!iree_task_list_is_empty(&stolen_tasks)) {
-    iree_slim_mutex_lock(&target_queue->mutex);
-    iree_task_list_append(&target_queue->list, &stolen_tasks);
-    next_task = iree_task_list_pop_front(&target_queue->list);
-    iree_slim_mutex_unlock(&target_queue->mutex);
+  iree_task_list_push_front(&stolen_tasks, first_task);
+  for (int64_t i = 1; i < steal_count; ++i) {
+    int64_t remaining_size = 0;
+    iree_task_t* task =
+        iree_task_queue_steal_one(source_queue, &remaining_size);
+    if (!task) break;  // drained or contended; take what we have
+    iree_task_list_push_front(&stolen_tasks, task);
   }
+
+  // Return the first of the stolen tasks and queue up the rest locally.
+  iree_task_t* next_task = iree_task_list_pop_front(&stolen_tasks);
+  iree_task_queue_push_fifo_list(target_queue, &stolen_tasks);
   return next_task;
 }
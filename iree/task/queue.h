@@ -10,66 +10,52 @@
 #include <stdbool.h>
 
 #include "iree/base/api.h"
-#include "iree/base/internal/synchronization.h"
+#include "iree/base/internal/atomics.h"
 #include "iree/task/list.h"
 #include "iree/task/task.h"
+#include "iree/task/tuning.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif  // __cplusplus
 
-// A simple work-stealing LIFO queue modeled on a Chase-Lev concurrent deque.
+// A work-stealing queue implemented as a Chase-Lev concurrent deque.
 // This is used by workers to maintain their thread-local working lists. The
-// workers keep the tasks they will process in FIFO order. They allow it to
-// empty and then refresh it with more tasks from the incoming worker mailbox.
+// workers pop the tasks they will process from the bottom of the deque and
+// refresh it with more tasks from the incoming worker mailbox once it empties.
 // The performance bias here is to the workers as they are >90% of the
 // accesses and the only other accesses are thieves that hopefully we can just
 // improve our distribution to vs. introducing a slowdown here.
 //
-// A futex is used to synchronize access; because the common case is that of
-// only the worker that owns the queue touching it for pushing and popping items
-// this puts us into the sweet-spot of uncontended lightweight exclusive locks.
-// Since futices are effectively just single machine words managed with atomic
-// ops we can avoid a lot of the traditional atomic tomfoolery one finds in
-// systems like these that originated prior to the introduction of futices while
-// also keeping the tiny overhead of the pure atomic solutions.
+// The owner pushes and pops at the bottom of the deque with plain loads and
+// stores and only needs an atomic read-modify-write when racing thieves for the
+// very last task. Thieves take tasks from the top with a compare-and-swap and
+// never block the owner (or each other): a failed CAS just means someone else
+// got the task first. This keeps local pops free of any shared lock that
+// thieves may be holding.
 //
-// We can also take advantage of the futex providing an actual exclusive region
-// such that our data structure can be whatever we want as opposed to needing to
-// be something that someone had figured out how to make atomic. For example,
-// common implementations of work-stealing queues are all bounded as unbounded
-// atomic deques are an unsolved problem in CS.
+// Tasks pushed together as a batch (such as those flushed from the mailbox) are
+// stored such that the owner pops them in FIFO order. Batches themselves are
+// LIFO: a newly pushed batch is popped by the owner before older tasks. In
+// practice the owner only refreshes the queue when it is empty and the
+// ordering across batches rarely matters.
 //
-// Very rarely when another worker runs out of work it'll try to steal tasks
-// from nearby workers and use this queue type to do it: the assumption is that
-// it's better to take the last task the victim worker will get to so that in a
-// long list of tasks it remains chugging through the head of the list with good
-// cache locality. If we end up with a lot of theft, though, it's possible for
-// the cache benefits of the pop_back approach to the worker to outweigh the
-// cache pessimism for all thieves. Let's hope we can schedule deterministic-
-// enough tiles such that theft is rare!
+// When another worker runs out of work it'll try to steal tasks from nearby
+// workers: the top of the deque holds the tasks the owner will get to last so
+// the owner keeps chugging through its most recent tasks with good cache
+// locality while thieves take the ones it would otherwise have reached much
+// later. Theft is batched so that when a remote worker has to perform a theft
+// it takes up to half of the tasks (task by task from the top) to reduce the
+// total overhead when there is high imbalance in workloads.
 //
-// Our queue variant here is tuned for the use case we have: we exclusively
-// push in multiple tasks at a time (flushed from the mailbox) and exclusively
-// pop a single task a time (what to work on next). The stealing part is batched
-// so that when a remote worker has to perform a theft it takes a good chunk of
-// tasks in one go (hopefully roughly half) to reduce the total overhead when
-// there is high imbalance in workloads.
+// The deque has a fixed capacity of IREE_TASK_QUEUE_CAPACITY tasks. If the
+// owner pushes more than fit the excess is kept in an owner-only overflow list
+// that is moved into the deque as space becomes available. Tasks in the
+// overflow list are not visible to thieves until they are moved. A task pushed
+// to the front while the deque is full is held in an owner-only front slot
+// that is popped before the deque so that it still runs next.
 //
-// Flushing from the mailbox slist (LIFO) to our list (FIFO) requires a full
-// walk of the incoming task linked list. This is generally fine as the number
-// of tasks in any given flush is low(ish) and by walking in reverse order to
-// then process forward the cache should be hot as the worker starts making its
-// way back through the tasks. As we walk forward we'll be using the task fields
-// for execution and retiring of tasks (notifing dependencies/etc) and the
-// intrusive next pointer sitting next to those should be in-cache when we need
-// to access it. This, combined with slab allocation of tasks in command buffers
-// to begin with gives us the (probabilistically) same characteristics of a flat
-// array walked with an index as is common in other work queues but with the
-// flexibility to reorder tasks as we see fit (theft, redistribution/rotation,
-// reprioritization, etc).
-//
-// Similar concepts, though implemented with atomics:
+// See:
 //   "Dynamic Circular Work-Stealing Deque":
 //   http://citeseerx.ist.psu.edu/viewdoc/download?doi=10.1.1.170.1097&rep=rep1&type=pdf
 //   "Correct and Efficient Work-Stealing for Weak Memory Models":
@@ -78,8 +64,6 @@ extern "C" {
 //   https://blog.molecular-matters.com/2015/08/24/job-system-2-0-lock-free-work-stealing-part-1-basics/
 //
 // Useful diagram from https://github.com/injinj/WSQ
-// Much of this implementation is inspired from that; though significant
-// reworking was required for our FIFO->LIFO->FIFO sandwich.
 //  +--------+ <- tasks[0]
 //  |  top   | <- stealers consume here: task = tasks[top++]
 //  |        |
@@ -90,24 +74,27 @@ extern "C" {
 //  |        |    owner consumes here:  task = tasks[--bottom]
 //  |        |
 //  +--------+ <- tasks[IREE_TASK_QUEUE_CAPACITY-1]
-//
-// Unlike that implementation, though, our task list is unbounded because we use
-// a linked list. To keep our options open, though, I've left the API of this
-// implementation compatible with classic atomic work-stealing queues. I'm
-// hopeful this will not need to be revisted for awhile, though!
-//
-// Future improvement idea: have the owner of the queue maintain a theft point
-// skip list that makes it possible for thieves to quickly come in and slice
-// off batches of tasks at the tail of the queue. Since we are a singly-linked
-// list we can't easily just walk backward and we don't want to be introducing
-// cache line contention as thieves start touching the same tasks as the worker
-// is while processing.
 typedef struct iree_task_queue_t {
-  // Must be held when manipulating the queue. >90% accesses are by the owner.
-  iree_slim_mutex_t mutex;
+  // Index of the next task thieves will take. Only ever incremented, either by
+  // thieves or by the owner when racing for the last task.
+  iree_atomic_int64_t top;
+
+  // Keeps thieves hammering on |top| from contending with the owner.
+  uint8_t _top_padding[iree_hardware_destructive_interference_size -
+                       sizeof(iree_atomic_int64_t)];
+
+  // Index one past the most recently pushed task. Only written by the owner.
+  iree_atomic_int64_t bottom;
 
-  // FIFO task list.
-  iree_task_list_t list IREE_GUARDED_BY(mutex);
+  // FIFO list of tasks that did not fit in |tasks|. Only accessed by the owner.
+  iree_task_list_t overflow_list;
+
+  // Task pushed to the front while the deque was full. Popped before any task
+  // in the deque. Only accessed by the owner.
+  iree_task_t* front_task;
+
+  // Circular buffer of iree_task_t* indexed by top/bottom modulo capacity.
+  iree_atomic_intptr_t tasks[IREE_TASK_QUEUE_CAPACITY];
 } iree_task_queue_t;
 
 // Initializes a work-stealing task queue in-place.
@@ -119,9 +106,11 @@ void iree_task_queue_deinitialize(iree_task_queue_t* queue);
 
 // Returns true if the queue is empty.
 // Note that due to races this may return both false-positives and -negatives.
+//
+// Must only be called from the owning worker's thread.
 bool iree_task_queue_is_empty(iree_task_queue_t* queue);
 
-// Pushes a task to the front of the queue.
+// Pushes a task to the front of the queue such that it is the next popped.
 // Always prefer the multi-push variants (prepend/append) when adding more than
 // one task to the queue. This is mostly useful for exceptional cases such as
 // when a task may yield and need to be reprocessed after the worker resumes.
@@ -129,7 +118,8 @@ bool iree_task_queue_is_empty(iree_task_queue_t* queue);
 // Must only be called from the owning worker's thread.
 void iree_task_queue_push_front(iree_task_queue_t* queue, iree_task_t* task);
 
-// Appends a LIFO |list| of tasks to the queue.
+// Adds a LIFO |list| of tasks to the queue. The tasks will be popped in FIFO
+// order before any tasks already in the queue.
 //
 // Must only be called from the owning worker's thread.
 void iree_task_queue_append_from_lifo_list_unsafe(iree_task_queue_t* queue,
@@ -150,11 +140,13 @@ iree_task_t* iree_task_queue_pop_front(iree_task_queue_t* queue);
 
 // Tries to steal up to |max_tasks| from the back of the queue.
 // Returns NULL if no tasks are available and otherwise up to |max_tasks| tasks
-// that were at the tail of the |source_queue| will be moved to the
-// |target_queue| and the first of the stolen tasks is returned.
+// (and no more than half of the available tasks, unless there is only one)
+// that were at the tail of the |source_queue| are taken. The first of the
+// stolen tasks is returned and the rest are pushed to the |target_queue|.
 //
-// It's expected this is not called from the queue's owning worker, though it's
-// valid to do so.
+// Must be called from the thread owning |target_queue|. It's expected this is
+// not called from the |source_queue|'s owning worker, though it's valid to do
+// so.
 iree_task_t* iree_task_queue_try_steal(iree_task_queue_t* source_queue,
                                        iree_task_queue_t* target_queue,
                                        iree_host_size_t max_tasks);
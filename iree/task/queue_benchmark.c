@@ -0,0 +1,241 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "iree/base/api.h"
+#include "iree/base/internal/atomics.h"
+#include "iree/base/internal/threading.h"
+#include "iree/task/queue.h"
+#include "iree/testing/benchmark.h"
+
+// Number of tasks pushed to the queue in each benchmark batch.
+#define IREE_TASK_QUEUE_BENCHMARK_BATCH_SIZE 128
+
+// Maximum number of thief threads used by the theft benchmarks.
+#define IREE_TASK_QUEUE_BENCHMARK_MAX_THIEVES 16
+
+// Initializes |tasks| and links them into a LIFO |out_list| as a worker would
+// receive them from its mailbox.
+static void iree_task_queue_benchmark_make_lifo_list(
+    iree_host_size_t count, iree_task_t* tasks, iree_task_list_t* out_list) {
+  iree_task_list_initialize(out_list);
+  for (iree_host_size_t i = 0; i < count; ++i) {
+    iree_task_list_push_front(out_list, &tasks[i]);
+  }
+}
+
+// Measures the cost of the owner pushing a single task and popping it back off
+// as happens when a worker yields a task it is processing.
+static iree_status_t iree_task_queue_benchmark_push_pop(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  iree_task_queue_t queue;
+  iree_task_queue_initialize(&queue);
+  iree_task_t task;
+  memset(&task, 0, sizeof(task));
+  while (iree_benchmark_keep_running(benchmark_state, /*batch_count=*/1)) {
+    iree_task_queue_push_front(&queue, &task);
+    iree_task_t* popped_task = iree_task_queue_pop_front(&queue);
+    if (popped_task != &task) {
+      return iree_make_status(IREE_STATUS_INTERNAL, "queue corrupted");
+    }
+  }
+  iree_task_queue_deinitialize(&queue);
+  return iree_ok_status();
+}
+
+// Measures the per-task cost of the owner appending a batch of tasks and then
+// popping them all in the uncontended case.
+static iree_status_t iree_task_queue_benchmark_append_pop(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  iree_task_queue_t queue;
+  iree_task_queue_initialize(&queue);
+  iree_task_t tasks[IREE_TASK_QUEUE_BENCHMARK_BATCH_SIZE];
+  memset(tasks, 0, sizeof(tasks));
+  while (iree_benchmark_keep_running(
+      benchmark_state,
+      /*batch_count=*/IREE_TASK_QUEUE_BENCHMARK_BATCH_SIZE)) {
+    iree_task_list_t list;
+    iree_task_queue_benchmark_make_lifo_list(IREE_ARRAYSIZE(tasks), tasks,
+                                             &list);
+    iree_task_queue_append_from_lifo_list_unsafe(&queue, &list);
+    while (iree_task_queue_pop_front(&queue)) {
+    }
+  }
+  iree_task_queue_deinitialize(&queue);
+  return iree_ok_status();
+}
+
+typedef struct iree_task_queue_benchmark_thief_t {
+  iree_task_queue_t* victim_queue;
+  iree_atomic_int32_t* should_exit;
+  iree_atomic_int64_t* stolen_count;
+  iree_task_queue_t local_queue;
+} iree_task_queue_benchmark_thief_t;
+
+static int iree_task_queue_benchmark_thief_main(void* entry_arg) {
+  iree_task_queue_benchmark_thief_t* thief =
+      (iree_task_queue_benchmark_thief_t*)entry_arg;
+  while (!iree_atomic_load_int32(thief->should_exit,
+                                 iree_memory_order_acquire)) {
+    iree_task_t* task = iree_task_queue_try_steal(
+        thief->victim_queue, &thief->local_queue, /*max_tasks=*/8);
+    int64_t stolen_count = 0;
+    while (task) {
+      ++stolen_count;
+      task = iree_task_queue_pop_front(&thief->local_queue);
+    }
+    if (stolen_count) {
+      // Releases the tasks back to the owner for reuse.
+      iree_atomic_fetch_add_int64(thief->stolen_count, stolen_count,
+                                  iree_memory_order_release);
+    }
+  }
+  return 0;
+}
+
+// Measures the per-task cost of the owner appending and popping batches of
+// tasks while thieves continuously try to steal from it. The owner and thieves
+// together drain each batch before the next is appended such that the
+// reported time is the owner-observed cost of processing a task under
+// contention.
+//
+// user_data is the number of thief threads.
+static iree_status_t iree_task_queue_benchmark_steal_n(
+    const iree_benchmark_def_t* benchmark_def,
+    iree_benchmark_state_t* benchmark_state) {
+  iree_allocator_t host_allocator = benchmark_state->host_allocator;
+  iree_host_size_t thief_count =
+      (iree_host_size_t)(uintptr_t)benchmark_def->user_data;
+
+  iree_task_queue_t queue;
+  iree_task_queue_initialize(&queue);
+  iree_task_t tasks[IREE_TASK_QUEUE_BENCHMARK_BATCH_SIZE];
+  memset(tasks, 0, sizeof(tasks));
+
+  iree_atomic_int32_t should_exit = IREE_ATOMIC_VAR_INIT(0);
+  iree_atomic_int64_t stolen_count = IREE_ATOMIC_VAR_INIT(0);
+  iree_task_queue_benchmark_thief_t
+      thieves[IREE_TASK_QUEUE_BENCHMARK_MAX_THIEVES];
+  iree_thread_t* threads[IREE_TASK_QUEUE_BENCHMARK_MAX_THIEVES] = {0};
+  iree_status_t status = iree_ok_status();
+  iree_host_size_t created_count = 0;
+  for (iree_host_size_t i = 0; i < thief_count; ++i) {
+    thieves[i].victim_queue = &queue;
+    thieves[i].should_exit = &should_exit;
+    thieves[i].stolen_count = &stolen_count;
+    iree_task_queue_initialize(&thieves[i].local_queue);
+    iree_thread_create_params_t params;
+    memset(&params, 0, sizeof(params));
+    params.name = iree_make_cstring_view("thief");
+    status = iree_thread_create(iree_task_queue_benchmark_thief_main,
+                                &thieves[i], params, host_allocator,
+                                &threads[i]);
+    if (!iree_status_is_ok(status)) {
+      iree_task_queue_deinitialize(&thieves[i].local_queue);
+      break;
+    }
+    ++created_count;
+  }
+
+  int64_t pushed_count = 0;
+  int64_t popped_count = 0;
+  while (iree_status_is_ok(status) &&
+         iree_benchmark_keep_running(
+             benchmark_state,
+             /*batch_count=*/IREE_TASK_QUEUE_BENCHMARK_BATCH_SIZE)) {
+    iree_task_list_t list;
+    iree_task_queue_benchmark_make_lifo_list(IREE_ARRAYSIZE(tasks), tasks,
+                                             &list);
+    iree_task_queue_append_from_lifo_list_unsafe(&queue, &list);
+    pushed_count += IREE_ARRAYSIZE(tasks);
+    while (iree_task_queue_pop_front(&queue)) {
+      ++popped_count;
+    }
+    // Wait for thieves to finish with any tasks they took from this batch
+    // before we reuse them; they only ever hold on to them briefly.
+    while (popped_count + iree_atomic_load_int64(&stolen_count,
+                                                 iree_memory_order_acquire) <
+           pushed_count) {
+    }
+  }
+
+  if (pushed_count) {
+    char label[32];
+    snprintf(label, sizeof(label), "stolen=%d%%",
+             (int)(iree_atomic_load_int64(&stolen_count,
+                                          iree_memory_order_relaxed) *
+                   100 / pushed_count));
+    iree_benchmark_set_label(benchmark_state, label);
+  }
+
+  iree_atomic_store_int32(&should_exit, 1, iree_memory_order_release);
+  for (iree_host_size_t i = 0; i < created_count; ++i) {
+    iree_thread_release(threads[i]);  // joins
+    iree_task_queue_deinitialize(&thieves[i].local_queue);
+  }
+  iree_task_queue_deinitialize(&queue);
+  return status;
+}
+
+int main(int argc, char** argv) {
+  iree_benchmark_initialize(&argc, argv);
+
+  {
+    iree_benchmark_def_t benchmark_def = {
+        .flags = IREE_BENCHMARK_FLAG_MEASURE_PROCESS_CPU_TIME |
+                 IREE_BENCHMARK_FLAG_USE_REAL_TIME,
+        .time_unit = IREE_BENCHMARK_UNIT_NANOSECOND,
+        .minimum_duration_ns = 0,
+        .iteration_count = 0,
+        .run = iree_task_queue_benchmark_push_pop,
+    };
+    iree_benchmark_register(iree_make_cstring_view("push_pop"),
+                            &benchmark_def);
+  }
+
+  {
+    iree_benchmark_def_t benchmark_def = {
+        .flags = IREE_BENCHMARK_FLAG_MEASURE_PROCESS_CPU_TIME |
+                 IREE_BENCHMARK_FLAG_USE_REAL_TIME,
+        .time_unit = IREE_BENCHMARK_UNIT_NANOSECOND,
+        .minimum_duration_ns = 0,
+        .iteration_count = 0,
+        .run = iree_task_queue_benchmark_append_pop,
+    };
+    iree_benchmark_register(iree_make_cstring_view("append_pop"),
+                            &benchmark_def);
+  }
+
+  // iree_task_queue_benchmark_steal_n
+  {
+    iree_benchmark_def_t benchmark_def = {
+        .flags = IREE_BENCHMARK_FLAG_USE_REAL_TIME,
+        .time_unit = IREE_BENCHMARK_UNIT_NANOSECOND,
+        .minimum_duration_ns = 0,
+        .iteration_count = 0,
+        .run = iree_task_queue_benchmark_steal_n,
+    };
+    benchmark_def.user_data = (void*)0u;
+    iree_benchmark_register(iree_make_cstring_view("steal_0"), &benchmark_def);
+    benchmark_def.user_data = (void*)1u;
+    iree_benchmark_register(iree_make_cstring_view("steal_1"), &benchmark_def);
+    benchmark_def.user_data = (void*)3u;
+    iree_benchmark_register(iree_make_cstring_view("steal_3"), &benchmark_def);
+    benchmark_def.user_data = (void*)7u;
+    iree_benchmark_register(iree_make_cstring_view("steal_7"), &benchmark_def);
+    benchmark_def.user_data = (void*)15u;
+    iree_benchmark_register(iree_make_cstring_view("steal_15"),
+                            &benchmark_def);
+  }
+
+  iree_benchmark_run_specified();
+  return 0;
+}
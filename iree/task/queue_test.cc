@@ -6,6 +6,12 @@
 
 #include "iree/task/queue.h"
 
+#include <atomic>
+#include <cstring>
+#include <set>
+#include <thread>
+#include <vector>
+
 #include "iree/testing/gtest.h"
 
 namespace {
@@ -250,13 +256,14 @@ TEST(QueueTest, TryStealIntoExisting) {
   iree_task_t task_existing = {0};
   iree_task_queue_push_front(&target_queue, &task_existing);
 
-  EXPECT_EQ(&task_existing,
+  // The stolen task is returned directly and the existing task is untouched.
+  EXPECT_EQ(&task_b,
             iree_task_queue_try_steal(&source_queue, &target_queue, 1));
 
   EXPECT_EQ(&task_a, iree_task_queue_pop_front(&source_queue));
   EXPECT_TRUE(iree_task_queue_is_empty(&source_queue));
 
-  EXPECT_EQ(&task_b, iree_task_queue_pop_front(&target_queue));
+  EXPECT_EQ(&task_existing, iree_task_queue_pop_front(&target_queue));
   EXPECT_TRUE(iree_task_queue_is_empty(&target_queue));
 
   iree_task_queue_deinitialize(&source_queue);
@@ -319,4 +326,190 @@ TEST(QueueTest, TryStealAll) {
   iree_task_queue_deinitialize(&target_queue);
 }
 
+TEST(QueueTest, TryStealManyIntoExisting) {
+  iree_task_queue_t source_queue;
+  iree_task_queue_initialize(&source_queue);
+  iree_task_queue_t target_queue;
+  iree_task_queue_initialize(&target_queue);
+
+  iree_task_t task_a = {0};
+  iree_task_t task_b = {0};
+  iree_task_t task_c = {0};
+  iree_task_t task_d = {0};
+  iree_task_queue_push_front(&source_queue, &task_d);
+  iree_task_queue_push_front(&source_queue, &task_c);
+  iree_task_queue_push_front(&source_queue, &task_b);
+  iree_task_queue_push_front(&source_queue, &task_a);
+
+  iree_task_t task_existing = {0};
+  iree_task_queue_push_front(&target_queue, &task_existing);
+
+  // Stolen tasks other than the returned one are queued in order ahead of
+  // the existing target tasks.
+  EXPECT_EQ(&task_c,
+            iree_task_queue_try_steal(&source_queue, &target_queue, 2));
+  EXPECT_EQ(&task_d, iree_task_queue_pop_front(&target_queue));
+  EXPECT_EQ(&task_existing, iree_task_queue_pop_front(&target_queue));
+  EXPECT_TRUE(iree_task_queue_is_empty(&target_queue));
+
+  EXPECT_EQ(&task_a, iree_task_queue_pop_front(&source_queue));
+  EXPECT_EQ(&task_b, iree_task_queue_pop_front(&source_queue));
+  EXPECT_TRUE(iree_task_queue_is_empty(&source_queue));
+
+  iree_task_queue_deinitialize(&source_queue);
+  iree_task_queue_deinitialize(&target_queue);
+}
+
+// Tests that batches of tasks are popped in FIFO order with newer batches
+// popped before older ones.
+TEST(QueueTest, AppendListBatches) {
+  iree_task_queue_t queue;
+  iree_task_queue_initialize(&queue);
+
+  iree_task_t task_a = {0};
+  iree_task_t task_b = {0};
+  iree_task_list_t list0 = {0};
+  iree_task_list_push_front(&list0, &task_a);
+  iree_task_list_push_front(&list0, &task_b);
+  iree_task_queue_append_from_lifo_list_unsafe(&queue, &list0);
+
+  iree_task_t task_c = {0};
+  iree_task_t task_d = {0};
+  iree_task_list_t list1 = {0};
+  iree_task_list_push_front(&list1, &task_c);
+  iree_task_list_push_front(&list1, &task_d);
+  iree_task_queue_append_from_lifo_list_unsafe(&queue, &list1);
+
+  EXPECT_EQ(&task_c, iree_task_queue_pop_front(&queue));
+  EXPECT_EQ(&task_d, iree_task_queue_pop_front(&queue));
+  EXPECT_EQ(&task_a, iree_task_queue_pop_front(&queue));
+  EXPECT_EQ(&task_b, iree_task_queue_pop_front(&queue));
+  EXPECT_TRUE(iree_task_queue_is_empty(&queue));
+
+  iree_task_queue_deinitialize(&queue);
+}
+
+// Tests that more tasks than fit in the deque are retained and popped.
+TEST(QueueTest, Overflow) {
+  iree_task_queue_t queue;
+  iree_task_queue_initialize(&queue);
+
+  std::vector<iree_task_t> tasks(IREE_TASK_QUEUE_CAPACITY * 2 + 3);
+  memset(tasks.data(), 0, tasks.size() * sizeof(iree_task_t));
+  iree_task_list_t list = {0};
+  for (auto& task : tasks) {
+    iree_task_list_push_front(&list, &task);
+  }
+  iree_task_queue_append_from_lifo_list_unsafe(&queue, &list);
+  EXPECT_TRUE(iree_task_list_is_empty(&list));
+
+  // Every task must come back out exactly once.
+  std::set<iree_task_t*> popped_tasks;
+  while (iree_task_t* task = iree_task_queue_pop_front(&queue)) {
+    EXPECT_TRUE(popped_tasks.insert(task).second);
+  }
+  EXPECT_EQ(tasks.size(), popped_tasks.size());
+  EXPECT_TRUE(iree_task_queue_is_empty(&queue));
+
+  iree_task_queue_deinitialize(&queue);
+}
+
+// Tests that a task pushed to the front of a full queue is the next popped.
+TEST(QueueTest, PushFrontFull) {
+  iree_task_queue_t queue;
+  iree_task_queue_initialize(&queue);
+
+  std::vector<iree_task_t> tasks(IREE_TASK_QUEUE_CAPACITY + 1);
+  memset(tasks.data(), 0, tasks.size() * sizeof(iree_task_t));
+  iree_task_list_t list = {0};
+  for (auto& task : tasks) {
+    iree_task_list_push_front(&list, &task);
+  }
+  iree_task_queue_append_from_lifo_list_unsafe(&queue, &list);
+
+  iree_task_t task_a = {0};
+  iree_task_queue_push_front(&queue, &task_a);
+  iree_task_t task_b = {0};
+  iree_task_queue_push_front(&queue, &task_b);
+  EXPECT_EQ(&task_b, iree_task_queue_pop_front(&queue));
+
+  // The front task is not visible to thieves.
+  iree_task_t task_c = {0};
+  iree_task_queue_push_front(&queue, &task_c);
+  iree_task_queue_t target_queue;
+  iree_task_queue_initialize(&target_queue);
+  iree_task_t* stolen_task = iree_task_queue_try_steal(&queue, &target_queue, 1);
+  EXPECT_NE(&task_c, stolen_task);
+  EXPECT_EQ(&task_c, iree_task_queue_pop_front(&queue));
+  iree_task_queue_deinitialize(&target_queue);
+
+  // Every remaining task comes back out exactly once.
+  std::set<iree_task_t*> popped_tasks;
+  while (iree_task_t* task = iree_task_queue_pop_front(&queue)) {
+    EXPECT_TRUE(popped_tasks.insert(task).second);
+  }
+  EXPECT_EQ(tasks.size(), popped_tasks.size());
+  EXPECT_EQ(1u, popped_tasks.count(&task_a));
+  EXPECT_EQ(0u, popped_tasks.count(stolen_task));
+  EXPECT_TRUE(iree_task_queue_is_empty(&queue));
+
+  iree_task_queue_deinitialize(&queue);
+}
+
+// Tests that concurrent owner pops and thefts hand out each task exactly once.
+TEST(QueueTest, ConcurrentSteal) {
+  static constexpr int kThiefCount = 4;
+  static constexpr int kBatchCount = 64;
+  static constexpr int kBatchSize = 128;
+
+  iree_task_queue_t queue;
+  iree_task_queue_initialize(&queue);
+
+  // Each task is used only once so that thieves can't observe reuse.
+  std::vector<iree_task_t> tasks(kBatchCount * kBatchSize);
+  memset(tasks.data(), 0, tasks.size() * sizeof(iree_task_t));
+  std::vector<std::atomic<int>> seen_counts(tasks.size());
+  for (auto& seen_count : seen_counts) seen_count = 0;
+  auto mark_seen = [&](iree_task_t* task) {
+    seen_counts[task - tasks.data()].fetch_add(1);
+  };
+
+  std::atomic<bool> should_exit = {false};
+  std::vector<std::thread> thieves;
+  for (int i = 0; i < kThiefCount; ++i) {
+    thieves.emplace_back([&]() {
+      iree_task_queue_t local_queue;
+      iree_task_queue_initialize(&local_queue);
+      while (!should_exit) {
+        iree_task_t* task = iree_task_queue_try_steal(&queue, &local_queue, 4);
+        while (task) {
+          mark_seen(task);
+          task = iree_task_queue_pop_front(&local_queue);
+        }
+      }
+      iree_task_queue_deinitialize(&local_queue);
+    });
+  }
+
+  for (int i = 0; i < kBatchCount; ++i) {
+    iree_task_list_t list = {0};
+    for (int j = 0; j < kBatchSize; ++j) {
+      iree_task_list_push_front(&list, &tasks[i * kBatchSize + j]);
+    }
+    iree_task_queue_append_from_lifo_list_unsafe(&queue, &list);
+    while (iree_task_t* task = iree_task_queue_pop_front(&queue)) {
+      mark_seen(task);
+    }
+  }
+
+  should_exit = true;
+  for (auto& thief : thieves) thief.join();
+
+  for (size_t i = 0; i < seen_counts.size(); ++i) {
+    EXPECT_EQ(1, seen_counts[i].load()) << "task " << i;
+  }
+
+  iree_task_queue_deinitialize(&queue);
+}
+
 }  // namespace
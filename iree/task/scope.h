@@ -20,6 +20,22 @@
 extern "C" {
 #endif  // __cplusplus
 
+// Scheduling priority of the tasks within a scope.
+// Workers always execute available tasks from higher priority scopes before
+// those from lower priority scopes and dispatches from lower priority scopes
+// yield to higher priority work posted to their worker at tile reservation
+// boundaries. This allows a latency-critical workload to share an executor
+// (and its threads) with a background workload without queuing behind it.
+typedef enum iree_task_priority_e {
+  // Default priority used for throughput-oriented work.
+  IREE_TASK_PRIORITY_NORMAL = 0,
+  // Latency-critical work that preempts normal priority work.
+  IREE_TASK_PRIORITY_HIGH = 1,
+} iree_task_priority_t;
+
+// Total number of task priorities.
+#define IREE_TASK_PRIORITY_COUNT 2
+
 // A loose way of grouping tasks within the task system.
 // Each scope represents a unique collection of tasks that have some related
 // properties - most often their producer - that need to carry along some
@@ -46,6 +62,9 @@ typedef struct iree_task_scope_t {
   // Name used for logging and tracing.
   char name[16];
 
+  // Scheduling priority of all tasks in the scope.
+  iree_task_priority_t priority;
+
   // Base color used for tasks in this scope.
   // The color will be modulated based on task type.
   IREE_TRACE(uint32_t task_trace_color;)
@@ -98,6 +117,15 @@ void iree_task_scope_deinitialize(iree_task_scope_t* scope);
 // string.
 iree_string_view_t iree_task_scope_name(iree_task_scope_t* scope);
 
+// Returns the scheduling priority of tasks in the scope.
+iree_task_priority_t iree_task_scope_priority(const iree_task_scope_t* scope);
+
+// Sets the scheduling priority of tasks in the scope. Scopes default to
+// IREE_TASK_PRIORITY_NORMAL. Only affects tasks that are scheduled after the
+// call and should usually be set before submitting any tasks.
+void iree_task_scope_set_priority(iree_task_scope_t* scope,
+                                  iree_task_priority_t priority);
+
 // Returns and resets the statistics for the scope.
 // Statistics may experience tearing (non-atomic update across fields) if this
 // is performed while tasks are in-flight.
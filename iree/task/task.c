@@ -10,12 +10,14 @@
 #include <string.h>
 
 #include "iree/base/tracing.h"
+#include "iree/task/executor_impl.h"
 #include "iree/task/list.h"
 #include "iree/task/pool.h"
 #include "iree/task/post_batch.h"
 #include "iree/task/scope.h"
 #include "iree/task/submission.h"
 #include "iree/task/task_impl.h"
+#include "iree/task/topology.h"
 #include "iree/task/tuning.h"
 
 //==============================================================================
@@ -529,6 +531,10 @@ static void iree_task_dispatch_initialize_base(
   memcpy(out_task->workgroup_size, workgroup_size,
          sizeof(out_task->workgroup_size));
   out_task->local_memory_size = 0;
+  out_task->tiles_per_reservation_hint = 0;
+  out_task->profile_fn = NULL;
+  out_task->range_fn = NULL;
+  out_task->issue_time = 0;
   iree_atomic_store_intptr(&out_task->status, 0, iree_memory_order_release);
   memset(&out_task->statistics, 0, sizeof(out_task->statistics));
 
@@ -568,6 +574,7 @@ void iree_task_dispatch_issue(iree_task_dispatch_t* dispatch_task,
   // Mark the dispatch as having been issued; the next time it retires it'll be
   // because all work has completed.
   dispatch_task->header.flags |= IREE_TASK_FLAG_DISPATCH_RETIRE;
+  if (dispatch_task->profile_fn) dispatch_task->issue_time = iree_time_now();
 
   // Fetch the workgroup count (directly or indirectly).
   if (dispatch_task->header.flags & IREE_TASK_FLAG_DISPATCH_INDIRECT) {
@@ -575,8 +582,8 @@ void iree_task_dispatch_issue(iree_task_dispatch_t* dispatch_task,
     // indirection buffer have been satisfied and its safe to read. We perform
     // the indirection here and convert the dispatch to a direct one such that
     // following code can read the value.
-    // TODO(benvanik): non-one-shot command buffers won't be able to do this as
-    // the intent is that they can be dynamic per execution.
+    // Producers that reuse the task (such as reusable command buffers) must
+    // restore the pointer and flag prior to issuing it again.
     const uint32_t* source_ptr = dispatch_task->workgroup_count.ptr;
     memcpy(dispatch_task->workgroup_count.value, source_ptr,
            sizeof(dispatch_task->workgroup_count.value));
@@ -603,28 +610,60 @@ void iree_task_dispatch_issue(iree_task_dispatch_t* dispatch_task,
   iree_host_size_t worker_count = iree_task_post_batch_worker_count(post_batch);
   iree_host_size_t shard_count =
       iree_min(dispatch_task->tile_count, worker_count);
+  dispatch_task->shard_count = (uint32_t)shard_count;
 
   // Compute how many tiles we want each shard to reserve at a time from the
   // larger grid. A higher number reduces overhead and improves locality while
   // a lower number reduces maximum worst-case latency (coarser work stealing).
-  if (dispatch_task->tile_count <
-      worker_count * IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION) {
+  // This is only the starting point: shards adapt it as they execute.
+  uint32_t tiles_per_reservation =
+      dispatch_task->tiles_per_reservation_hint
+          ? dispatch_task->tiles_per_reservation_hint
+          : IREE_TASK_DISPATCH_INITIAL_TILES_PER_SHARD_RESERVATION;
+  tiles_per_reservation =
+      iree_min(tiles_per_reservation,
+               (uint32_t)IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION);
+  if (dispatch_task->tile_count < worker_count * tiles_per_reservation) {
     // Grid is small - allow it to be eagerly sliced up.
-    dispatch_task->tiles_per_reservation = 1;
-  } else {
-    dispatch_task->tiles_per_reservation =
-        IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION;
+    tiles_per_reservation = 1;
+  }
+  iree_atomic_store_int32(&dispatch_task->tiles_per_reservation,
+                          (int32_t)tiles_per_reservation,
+                          iree_memory_order_relaxed);
+
+  // Traverse the grid in column panels when requested. Grids that are only a
+  // single row or panel wide gain nothing from it.
+  const iree_task_scheduling_mode_t scheduling_mode =
+      post_batch->executor->scheduling_mode;
+  dispatch_task->tile_panel_width = 0;
+  if ((scheduling_mode & IREE_TASK_SCHEDULING_MODE_LOCALITY_TILE_ORDER) &&
+      workgroup_count[0] > IREE_TASK_DISPATCH_TILE_PANEL_WIDTH &&
+      workgroup_count[1] > 1) {
+    dispatch_task->tile_panel_width = IREE_TASK_DISPATCH_TILE_PANEL_WIDTH;
   }
 
-  // Randomize starting worker.
-  iree_host_size_t worker_offset = iree_task_post_batch_select_worker(
-      post_batch, dispatch_task->header.affinity_set);
+  // Randomize starting worker. In deterministic and sticky modes shard i
+  // always runs on worker i and executes the i-th contiguous slice of the grid
+  // so that the tiles each worker executes are fixed from dispatch to dispatch.
+  const bool fixed_shards =
+      (scheduling_mode & (IREE_TASK_SCHEDULING_MODE_DETERMINISTIC |
+                          IREE_TASK_SCHEDULING_MODE_STICKY_TILE_AFFINITY)) != 0;
+  iree_host_size_t worker_offset =
+      fixed_shards ? 0
+                   : iree_task_post_batch_select_worker(
+                         post_batch, dispatch_task->header.affinity_set);
   iree_host_size_t worker_index = worker_offset;
 
   for (iree_host_size_t i = 0; i < shard_count; ++i) {
     // Allocate and initialize the shard.
     iree_task_dispatch_shard_t* shard_task =
         iree_task_dispatch_shard_allocate(dispatch_task, shard_task_pool);
+    if (fixed_shards) {
+      shard_task->tile_index =
+          (uint32_t)((uint64_t)dispatch_task->tile_count * i / shard_count);
+      shard_task->tile_end = (uint32_t)((uint64_t)dispatch_task->tile_count *
+                                        (i + 1) / shard_count);
+    }
 
     // Enqueue on the worker selected for the task.
     iree_task_post_batch_enqueue(post_batch, worker_index % worker_count,
@@ -671,6 +710,12 @@ void iree_task_dispatch_retire(iree_task_dispatch_t* dispatch_task,
   iree_status_t status = (iree_status_t)iree_atomic_exchange_intptr(
       &dispatch_task->status, 0, iree_memory_order_seq_cst);
 
+  if (dispatch_task->profile_fn && iree_status_is_ok(status)) {
+    dispatch_task->profile_fn(dispatch_task->closure.user_context,
+                              dispatch_task, dispatch_task->issue_time,
+                              iree_time_now());
+  }
+
   iree_task_retire(&dispatch_task->header, pending_submission, status);
   IREE_TRACE_ZONE_END(z0);
 }
@@ -679,16 +724,13 @@ void iree_task_dispatch_retire(iree_task_dispatch_t* dispatch_task,
 // IREE_TASK_TYPE_DISPATCH_SHARD
 //==============================================================================
 
-static inline iree_task_dispatch_t* iree_task_dispatch_shard_parent(
-    iree_task_dispatch_shard_t* task) {
-  return (iree_task_dispatch_t*)task->header.completion_task;
-}
-
 void iree_task_dispatch_shard_initialize(iree_task_dispatch_t* dispatch_task,
                                          iree_task_dispatch_shard_t* out_task) {
   iree_task_initialize(IREE_TASK_TYPE_DISPATCH_SHARD,
                        dispatch_task->header.scope, &out_task->header);
   iree_task_set_completion_task(&out_task->header, &dispatch_task->header);
+  out_task->tile_index = 0;
+  out_task->tile_end = 0;
 }
 
 iree_task_dispatch_shard_t* iree_task_dispatch_shard_allocate(
@@ -705,10 +747,129 @@ iree_task_dispatch_shard_t* iree_task_dispatch_shard_allocate(
   return shard_task;
 }
 
-void iree_task_dispatch_shard_execute(
+// Scales |tiles_per_reservation| by the relative |worker_capacity| of the
+// worker executing a shard such that workers on lower capacity cores reserve
+// proportionally fewer tiles.
+static inline uint32_t iree_task_dispatch_scale_tiles_per_reservation(
+    uint32_t tiles_per_reservation, uint32_t worker_capacity) {
+  if (worker_capacity >= IREE_TASK_TOPOLOGY_GROUP_CAPACITY_MAX) {
+    return tiles_per_reservation;
+  }
+  uint64_t scaled_size = (uint64_t)tiles_per_reservation * worker_capacity /
+                         IREE_TASK_TOPOLOGY_GROUP_CAPACITY_MAX;
+  return (uint32_t)iree_max(scaled_size, 1);
+}
+
+// Returns a new reservation size for |dispatch_task| scaled from
+// |tiles_per_reservation| such that reservations take roughly
+// IREE_TASK_DISPATCH_TARGET_RESERVATION_DURATION_NS given that |tile_count|
+// tiles were just executed in |duration_ns|. The result is published to the
+// dispatch normalized to a full capacity worker so that shards that have yet
+// to start begin with it after scaling by their own |worker_capacity|.
+static uint32_t iree_task_dispatch_adapt_tiles_per_reservation(
+    iree_task_dispatch_t* dispatch_task, uint32_t tiles_per_reservation,
+    uint32_t tile_count, iree_duration_t duration_ns,
+    uint32_t worker_capacity) {
+  uint64_t target_size =
+      (uint64_t)tile_count * IREE_TASK_DISPATCH_TARGET_RESERVATION_DURATION_NS /
+      (uint64_t)iree_max(duration_ns, 1);
+  // Growth is limited per sample so that a single unusually fast reservation
+  // (such as one that ran entirely out of cache) does not overshoot. Shrinking
+  // is not limited as oversized reservations are what hurt load balance.
+  uint64_t max_size =
+      iree_min((uint64_t)tiles_per_reservation * 4,
+               (uint64_t)IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION);
+  uint32_t new_size = (uint32_t)iree_max(iree_min(target_size, max_size), 1);
+  uint64_t published_size = new_size;
+  if (worker_capacity < IREE_TASK_TOPOLOGY_GROUP_CAPACITY_MAX) {
+    published_size = iree_min(
+        published_size * IREE_TASK_TOPOLOGY_GROUP_CAPACITY_MAX /
+            iree_max(worker_capacity, 1),
+        (uint64_t)IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION);
+  }
+  iree_atomic_store_int32(&dispatch_task->tiles_per_reservation,
+                          (int32_t)published_size, iree_memory_order_relaxed);
+  return new_size;
+}
+
+// Clamps |tiles_per_reservation| such that the tiles remaining after
+// |tile_end| can still be divided among all shards of |dispatch_task|.
+// Like guided scheduling this keeps reservations large while there's plenty
+// of work and shrinks them toward single tiles at the tail of the grid where
+// one shard holding an oversized reservation would delay the whole dispatch.
+// The limit is scaled by |worker_capacity| as lower capacity workers take
+// longer to execute the same number of tiles.
+static inline uint32_t iree_task_dispatch_clamp_tiles_per_reservation(
+    const iree_task_dispatch_t* dispatch_task, uint32_t tiles_per_reservation,
+    uint32_t tile_end, uint32_t worker_capacity) {
+  if (dispatch_task->shard_count <= 1) return tiles_per_reservation;
+  uint32_t remaining_count = dispatch_task->tile_count - tile_end;
+  uint32_t max_size = iree_task_dispatch_scale_tiles_per_reservation(
+      remaining_count / (2 * dispatch_task->shard_count), worker_capacity);
+  return iree_max(iree_min(tiles_per_reservation, max_size), 1);
+}
+
+// Reserves the next |tiles_per_reservation| tiles for the shard |task| and
+// returns the index of the first. The end of the range must be clamped to
+// iree_task_dispatch_shard_tile_limit and there are no tiles remaining if the
+// returned index is at or beyond it. Tiles come from the fixed range of the
+// shard when statically assigned and otherwise from the shared dispatch grid.
+static inline uint32_t iree_task_dispatch_shard_reserve_tiles(
+    iree_task_dispatch_shard_t* task, iree_task_dispatch_t* dispatch_task,
+    uint32_t tiles_per_reservation) {
+  if (task->tile_end) {
+    uint32_t tile_base = task->tile_index;
+    task->tile_index = iree_min(tile_base + tiles_per_reservation,
+                                task->tile_end);
+    return tile_base;
+  }
+  return (uint32_t)iree_atomic_fetch_add_int32(&dispatch_task->tile_index,
+                                               tiles_per_reservation,
+                                               iree_memory_order_relaxed);
+}
+
+// Returns the exclusive upper bound of the tiles the shard |task| may reserve.
+static inline uint32_t iree_task_dispatch_shard_tile_limit(
+    const iree_task_dispatch_shard_t* task,
+    const iree_task_dispatch_t* dispatch_task) {
+  return task->tile_end ? task->tile_end : dispatch_task->tile_count;
+}
+
+// Returns the number of tiles starting at |tile_index| in execution order and
+// ending before |tile_end| that are contiguous in the linear x-major order of
+// the grid and stores the linear index of the first in |out_linear_index|.
+// Without column panels execution order is the linear order and the whole
+// range is one run; with them each row of a panel is a run.
+static inline uint32_t iree_task_dispatch_tile_run(
+    const iree_task_dispatch_t* dispatch_task, uint32_t tile_index,
+    uint32_t tile_end, uint32_t* out_linear_index) {
+  const uint32_t panel_width = dispatch_task->tile_panel_width;
+  if (!panel_width) {
+    *out_linear_index = tile_index;
+    return tile_end - tile_index;
+  }
+  // Panels are traversed left to right within each xy slice of the grid and
+  // all panels but the last in a slice are a full panel_width wide.
+  const uint32_t count_x = dispatch_task->workgroup_count.value[0];
+  const uint32_t count_y = dispatch_task->workgroup_count.value[1];
+  const uint32_t slice_size = count_x * count_y;
+  const uint32_t slice_base = tile_index - tile_index % slice_size;
+  const uint32_t slice_index = tile_index - slice_base;
+  const uint32_t panel_x = slice_index / (panel_width * count_y) * panel_width;
+  const uint32_t panel_index = slice_index - panel_x * count_y;
+  const uint32_t row_width = iree_min(panel_width, count_x - panel_x);
+  const uint32_t row = panel_index / row_width;
+  const uint32_t column = panel_index % row_width;
+  *out_linear_index = slice_base + row * count_x + panel_x + column;
+  return iree_min(row_width - column, tile_end - tile_index);
+}
+
+uint32_t iree_task_dispatch_shard_execute(
     iree_task_dispatch_shard_t* task, iree_byte_span_t worker_local_memory,
-    iree_task_submission_t* pending_submission) {
+    uint32_t worker_capacity, iree_atomic_int32_t* preemption_flag,
+    iree_task_submission_t* pending_submission, bool* out_preempted) {
   IREE_TRACE_ZONE_BEGIN(z0);
+  *out_preempted = false;
 
   iree_task_dispatch_t* dispatch_task = iree_task_dispatch_shard_parent(task);
   IREE_TRACE_ZONE_APPEND_VALUE(z0, dispatch_task->dispatch_id);
@@ -729,7 +890,7 @@ void iree_task_dispatch_shard_execute(
                          worker_local_memory.data_length));
     iree_task_retire(&task->header, pending_submission, iree_ok_status());
     IREE_TRACE_ZONE_END(z0);
-    return;
+    return 0;
   }
   iree_byte_span_t local_memory = iree_make_byte_span(
       worker_local_memory.data, dispatch_task->local_memory_size);
@@ -750,61 +911,129 @@ void iree_task_dispatch_shard_execute(
   iree_task_dispatch_statistics_t shard_statistics;
   memset(&shard_statistics, 0, sizeof(shard_statistics));
   tile_context.statistics = &shard_statistics;
+  uint32_t executed_tile_count = 0;
 
   // Loop over all tiles until they are all processed.
-  const uint32_t tile_count = dispatch_task->tile_count;
-  const uint32_t tiles_per_reservation = dispatch_task->tiles_per_reservation;
-  uint32_t tile_base = iree_atomic_fetch_add_int32(&dispatch_task->tile_index,
-                                                   tiles_per_reservation,
-                                                   iree_memory_order_relaxed);
+  // The first few reservations are timed to adapt the reservation size to the
+  // cost of the tiles in this dispatch.
+  const uint32_t tile_count =
+      iree_task_dispatch_shard_tile_limit(task, dispatch_task);
+  uint32_t tiles_per_reservation =
+      iree_task_dispatch_scale_tiles_per_reservation(
+          (uint32_t)iree_atomic_load_int32(
+              &dispatch_task->tiles_per_reservation, iree_memory_order_relaxed),
+          worker_capacity);
+  int timed_reservation_count =
+      IREE_TASK_DISPATCH_TARGET_RESERVATION_DURATION_NS > 0
+          ? IREE_TASK_DISPATCH_TIMED_RESERVATION_COUNT
+          : 0;
+  uint32_t tile_base = iree_task_dispatch_shard_reserve_tiles(
+      task, dispatch_task, tiles_per_reservation);
   while (tile_base < tile_count) {
     const uint32_t tile_range =
         iree_min(tile_base + tiles_per_reservation, tile_count);
-    for (uint32_t tile_index = tile_base; tile_index < tile_range;
-         ++tile_index) {
-      // TODO(benvanik): faster math here, especially knowing we pull off N
-      // sequential indices per reservation.
-      uint32_t tile_i = tile_index;
-      tile_context.workgroup_xyz[0] = tile_i % workgroup_count_x;
-      tile_i /= workgroup_count_x;
-      tile_context.workgroup_xyz[1] = tile_i % workgroup_count_y;
-      tile_i /= workgroup_count_y;
-      tile_context.workgroup_xyz[2] = tile_i;
-
-      IREE_TRACE_ZONE_BEGIN_NAMED(z_tile,
-                                  "iree_task_dispatch_shard_execute_tile");
-      IREE_TRACE_ZONE_SET_COLOR(z_tile, iree_task_tile_to_color(&tile_context));
-
-      // NOTE: these are useful for debugging but dramatically increase our
-      // cost here; only enable if needed for tracking work distribution:
-      IREE_TRACE_ZONE_APPEND_VALUE(z_tile, tile_context.workgroup_xyz[0]);
-      IREE_TRACE_ZONE_APPEND_VALUE(z_tile, tile_context.workgroup_xyz[1]);
-      IREE_TRACE_ZONE_APPEND_VALUE(z_tile, tile_context.workgroup_xyz[2]);
-      // IREE_TRACE_ZONE_APPEND_VALUE(z_tile, (uint64_t)task->closure.fn);
-
-      iree_status_t status =
-          dispatch_task->closure.fn(dispatch_task->closure.user_context,
-                                    &tile_context, pending_submission);
-
-      IREE_TRACE_ZONE_END(z_tile);
-
-      // If any tile fails we bail early from the loop. This doesn't match
-      // what an accelerator would do but saves some unneeded work.
-      // Note that other shards may have completed execution, be executing
-      // concurrently with this one, or still be pending - this does not
-      // have any influence on them and they may continue to execute even
-      // after we bail from here.
-      if (!iree_status_is_ok(status)) {
-        // Propagate failures to the dispatch task.
-        iree_task_try_set_status(&dispatch_task->status, status);
-        goto abort_shard;  // out of the while-for nest
+    const iree_time_t reservation_start_ns =
+        timed_reservation_count > 0 ? iree_time_now() : 0;
+    for (uint32_t run_base = tile_base; run_base < tile_range;) {
+      uint32_t linear_base = 0;
+      const uint32_t run_count = iree_task_dispatch_tile_run(
+          dispatch_task, run_base, tile_range, &linear_base);
+      run_base += run_count;
+
+      if (dispatch_task->range_fn) {
+        uint32_t tile_i = linear_base;
+        tile_context.workgroup_xyz[0] = tile_i % workgroup_count_x;
+        tile_i /= workgroup_count_x;
+        tile_context.workgroup_xyz[1] = tile_i % workgroup_count_y;
+        tile_i /= workgroup_count_y;
+        tile_context.workgroup_xyz[2] = tile_i;
+
+        IREE_TRACE_ZONE_BEGIN_NAMED(z_range,
+                                    "iree_task_dispatch_shard_execute_range");
+        IREE_TRACE_ZONE_APPEND_VALUE(z_range, run_count);
+        iree_status_t status = dispatch_task->range_fn(
+            dispatch_task->closure.user_context, &tile_context, linear_base,
+            run_count, pending_submission);
+        executed_tile_count += run_count;
+        IREE_TRACE_ZONE_END(z_range);
+
+        if (!iree_status_is_ok(status)) {
+          iree_task_try_set_status(&dispatch_task->status, status);
+          goto abort_shard;  // out of the while loop
+        }
+        continue;
+      }
+
+      for (uint32_t tile_index = linear_base;
+           tile_index < linear_base + run_count; ++tile_index) {
+        // TODO(benvanik): faster math here, especially knowing we pull off N
+        // sequential indices per reservation.
+        uint32_t tile_i = tile_index;
+        tile_context.workgroup_xyz[0] = tile_i % workgroup_count_x;
+        tile_i /= workgroup_count_x;
+        tile_context.workgroup_xyz[1] = tile_i % workgroup_count_y;
+        tile_i /= workgroup_count_y;
+        tile_context.workgroup_xyz[2] = tile_i;
+
+        IREE_TRACE_ZONE_BEGIN_NAMED(z_tile,
+                                    "iree_task_dispatch_shard_execute_tile");
+        IREE_TRACE_ZONE_SET_COLOR(z_tile,
+                                  iree_task_tile_to_color(&tile_context));
+
+        // NOTE: these are useful for debugging but dramatically increase our
+        // cost here; only enable if needed for tracking work distribution:
+        IREE_TRACE_ZONE_APPEND_VALUE(z_tile, tile_context.workgroup_xyz[0]);
+        IREE_TRACE_ZONE_APPEND_VALUE(z_tile, tile_context.workgroup_xyz[1]);
+        IREE_TRACE_ZONE_APPEND_VALUE(z_tile, tile_context.workgroup_xyz[2]);
+        // IREE_TRACE_ZONE_APPEND_VALUE(z_tile, (uint64_t)task->closure.fn);
+
+        iree_status_t status =
+            dispatch_task->closure.fn(dispatch_task->closure.user_context,
+                                      &tile_context, pending_submission);
+        ++executed_tile_count;
+
+        IREE_TRACE_ZONE_END(z_tile);
+
+        // If any tile fails we bail early from the loop. This doesn't match
+        // what an accelerator would do but saves some unneeded work.
+        // Note that other shards may have completed execution, be executing
+        // concurrently with this one, or still be pending - this does not
+        // have any influence on them and they may continue to execute even
+        // after we bail from here.
+        if (!iree_status_is_ok(status)) {
+          // Propagate failures to the dispatch task.
+          iree_task_try_set_status(&dispatch_task->status, status);
+          goto abort_shard;  // out of the while-for nest
+        }
       }
     }
 
+    // Adjust the size of the next reservation based on how long this one took
+    // and how much of the grid remains.
+    if (timed_reservation_count > 0) {
+      --timed_reservation_count;
+      tiles_per_reservation = iree_task_dispatch_adapt_tiles_per_reservation(
+          dispatch_task, tiles_per_reservation, tile_range - tile_base,
+          iree_time_now() - reservation_start_ns, worker_capacity);
+    }
+    tiles_per_reservation = iree_task_dispatch_clamp_tiles_per_reservation(
+        dispatch_task, tiles_per_reservation, tile_range, worker_capacity);
+
+    // Yield to higher priority work before reserving more tiles. The shard is
+    // not retired and the caller will requeue it to continue with whatever
+    // tiles remain; other shards may still pick them up in the meantime.
+    if (preemption_flag &&
+        iree_atomic_load_int32(preemption_flag, iree_memory_order_relaxed)) {
+      iree_task_dispatch_statistics_merge(&shard_statistics,
+                                          &dispatch_task->statistics);
+      *out_preempted = true;
+      IREE_TRACE_ZONE_END(z0);
+      return executed_tile_count;
+    }
+
     // Try to grab the next slice of tiles.
-    tile_base = iree_atomic_fetch_add_int32(&dispatch_task->tile_index,
-                                            tiles_per_reservation,
-                                            iree_memory_order_relaxed);
+    tile_base = iree_task_dispatch_shard_reserve_tiles(task, dispatch_task,
+                                                       tiles_per_reservation);
   }
 abort_shard:
 
@@ -818,4 +1047,5 @@ abort_shard:
   // propagated to the dispatch and it'll clean up after all shards are joined.
   iree_task_retire(&task->header, pending_submission, iree_ok_status());
   IREE_TRACE_ZONE_END(z0);
+  return executed_tile_count;
 }
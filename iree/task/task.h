@@ -161,6 +161,8 @@ struct iree_alignas(iree_max_align_t) iree_task_t {
   // of the specific work being performed. For example, some dispatches can be
   // limited to run on certain microarchitectures that workers have affinity
   // with at the OS scheduler level (such as little.BIG topologies).
+  // On executors with more than 64 workers the set applies to each cluster of
+  // 64 workers (see iree_task_affinity_set_t).
   iree_task_affinity_set_t affinity_set;
 
   // Total number of dependent tasks still outstanding. Decremented each time
@@ -553,6 +555,14 @@ typedef iree_status_t(IREE_API_PTR* iree_task_dispatch_closure_fn_t)(
     void* user_context, const iree_task_tile_context_t* tile_context,
     iree_task_submission_t* pending_submission);
 
+// Function called with a contiguous range of tiles of a dispatch in place of
+// calling the closure function per tile. Tiles are linearized in x-major order
+// and |tile_context| holds the workgroup_xyz of the first tile, |tile_base|.
+typedef iree_status_t(IREE_API_PTR* iree_task_dispatch_range_fn_t)(
+    void* user_context, const iree_task_tile_context_t* tile_context,
+    uint32_t tile_base, uint32_t tile_count,
+    iree_task_submission_t* pending_submission);
+
 // A function closure representing the function to call and its arguments.
 typedef struct iree_task_dispatch_closure_t {
   // Function called per tile invocation.
@@ -579,6 +589,12 @@ static inline iree_task_dispatch_closure_t iree_task_make_dispatch_closure(
 // IREE_TASK_TYPE_DISPATCH
 //==============================================================================
 
+// Function called when a dispatch with profiling enabled retires successfully.
+// |issue_time| and |retire_time| bound the execution of all tiles.
+typedef void(IREE_API_PTR* iree_task_dispatch_profile_fn_t)(
+    void* user_context, const iree_task_dispatch_t* task,
+    iree_time_t issue_time, iree_time_t retire_time);
+
 // An execution request across a tiled grid.
 // Dispatches are fork points where zero or more dispatch shard tasks are
 // spawned and processed prior to joining again on the dispatch completion task.
@@ -589,6 +605,13 @@ static inline iree_task_dispatch_closure_t iree_task_make_dispatch_closure(
 // forking. If any dimension of the workgroup count is zero then the dispatch is
 // skipped and the completion task will be readied immediately.
 //
+// Shards reserve contiguous ranges of tiles from the grid. The size of each
+// reservation adapts to the measured cost of the tiles (see
+// IREE_TASK_DISPATCH_TARGET_RESERVATION_DURATION_NS): cheap tiles are reserved
+// in large batches to amortize the shared reservation counter while expensive
+// tiles are reserved a few at a time. The reservation size also shrinks as the
+// grid is exhausted so that the tail of the dispatch balances across shards.
+//
 // Example:
 //   dispatch([5, 1, 1])
 //     forked into shards based on affinity/scheduling parameters:
@@ -623,6 +646,26 @@ typedef iree_alignas(iree_max_align_t) struct iree_task_dispatch_t {
   // dispatch closure.
   uint32_t local_memory_size;
 
+  // Optional number of tiles to fetch per reservation from the grid before the
+  // cost of the tiles has been measured or 0 to use the default. Producers that
+  // know their tiles are very cheap or very expensive can use this to skip the
+  // initial adaptation. Bounded by
+  // IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION.
+  uint32_t tiles_per_reservation_hint;
+
+  // Optional function called with the closure user context when the dispatch
+  // retires. The issue time is only sampled when this is set so that dispatches
+  // that are not profiled pay no cost.
+  iree_task_dispatch_profile_fn_t profile_fn;
+
+  // Optional function called with the closure user context once per range of
+  // tiles reserved by a shard instead of calling the closure once per tile.
+  // This lets the callee amortize per-call setup across the whole range.
+  iree_task_dispatch_range_fn_t range_fn;
+
+  // Time at which the dispatch was issued; valid only with |profile_fn|.
+  iree_time_t issue_time;
+
   // Resulting status from the dispatch available once all workgroups have
   // completed (or would have completed). If multiple shards processing the
   // workgroups hit an error the first will be taken and the result ignored. A
@@ -636,10 +679,21 @@ typedef iree_alignas(iree_max_align_t) struct iree_task_dispatch_t {
   // The total number of tiles in the dispatch bounding tile_index.
   uint32_t tile_count;
 
-  // Maximum number of tiles to fetch per tile reservation from the grid.
-  // Bounded by IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION and a
-  // reasonable number chosen based on the tile and shard counts.
-  uint32_t tiles_per_reservation;
+  // The number of shards the dispatch was split into when issued.
+  uint32_t shard_count;
+
+  // Width in tiles of the column panels the grid is traversed in or 0 if tiles
+  // are executed in linear x-major order. Chosen when the dispatch is issued
+  // (see IREE_TASK_SCHEDULING_MODE_LOCALITY_TILE_ORDER).
+  uint32_t tile_panel_width;
+
+  // Number of tiles to fetch per tile reservation from the grid.
+  // Starts from tiles_per_reservation_hint (or a default chosen based on the
+  // tile and shard counts) and is adapted by shards as they measure how long
+  // tiles take to execute such that shards starting later begin with a
+  // reservation size reflecting the measured cost. Bounded by
+  // IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION.
+  iree_atomic_int32_t tiles_per_reservation;
 
   // The tail tile index; the next reservation will start from here.
   // This is used by shards to slice off the work to perform in their inner
@@ -673,6 +727,13 @@ typedef iree_alignas(iree_max_align_t) struct {
 
   // NOTE: the parent dispatch task this shard is applied to is in the
   // header.completion_task field.
+
+  // Next tile and end of the fixed tile range [tile_index, tile_end) executed
+  // by the shard when tiles are statically assigned (such as in deterministic
+  // scheduling mode). When tile_end is 0 the shard instead reserves tiles from
+  // the shared dispatch iteration space.
+  uint32_t tile_index;
+  uint32_t tile_end;
 } iree_task_dispatch_shard_t;
 
 void iree_task_dispatch_shard_initialize(iree_task_dispatch_t* dispatch_task,
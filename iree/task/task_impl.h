@@ -102,6 +102,12 @@ void iree_task_dispatch_retire(iree_task_dispatch_t* dispatch_task,
 // IREE_TASK_TYPE_DISPATCH_SHARD
 //==============================================================================
 
+// Returns the parent dispatch task that |task| is a shard of.
+static inline iree_task_dispatch_t* iree_task_dispatch_shard_parent(
+    iree_task_dispatch_shard_t* task) {
+  return (iree_task_dispatch_t*)task->header.completion_task;
+}
+
 // Allocates a dispatch shard task from the shared executor task pool.
 // The shard will be released back to the pool when it has completed execution.
 iree_task_dispatch_shard_t* iree_task_dispatch_shard_allocate(
@@ -114,11 +120,23 @@ iree_task_dispatch_shard_t* iree_task_dispatch_shard_allocate(
 // |worker_local_memory| is a block of memory exclusively available to the shard
 // during execution. Contents are undefined both before and after execution.
 //
+// |worker_capacity| is the relative capacity of the executing worker in the
+// range (0, IREE_TASK_TOPOLOGY_GROUP_CAPACITY_MAX] used to scale how many tiles
+// the shard reserves at a time.
+//
+// If |preemption_flag| is provided it is checked before each tile reservation
+// and if non-zero the shard stops executing without being retired and
+// |out_preempted| is set to true. The caller must requeue the shard to have it
+// continue with the remaining tiles later on.
+//
 // Errors are propagated to the parent scope and the dispatch will fail once
 // all shards have completed.
-void iree_task_dispatch_shard_execute(
+//
+// Returns the number of tiles executed by the shard.
+uint32_t iree_task_dispatch_shard_execute(
     iree_task_dispatch_shard_t* task, iree_byte_span_t worker_local_memory,
-    iree_task_submission_t* pending_submission);
+    uint32_t worker_capacity, iree_atomic_int32_t* preemption_flag,
+    iree_task_submission_t* pending_submission, bool* out_preempted);
 
 #ifdef __cplusplus
 }  // extern "C"
@@ -62,6 +62,28 @@ class GridCoverage {
     return iree_ok_status();
   }
 
+  static iree_status_t Range(void* user_context,
+                             const iree_task_tile_context_t* tile_context,
+                             uint32_t tile_base, uint32_t tile_count,
+                             iree_task_submission_t* pending_submission) {
+    GridCoverage* coverage = reinterpret_cast<GridCoverage*>(user_context);
+    uint32_t first_slot =
+        tile_context->workgroup_xyz[2] * (tile_context->workgroup_count[1] *
+                                          tile_context->workgroup_count[0]) +
+        tile_context->workgroup_xyz[1] * tile_context->workgroup_count[0] +
+        tile_context->workgroup_xyz[0];
+    if (first_slot != tile_base) {
+      return iree_make_status(IREE_STATUS_INTERNAL,
+                              "range base %u does not match first tile %u",
+                              tile_base, first_slot);
+    }
+    for (uint32_t slot = tile_base; slot < tile_base + tile_count; ++slot) {
+      iree_atomic_fetch_add_int32(&coverage->storage_[slot], 1,
+                                  iree_memory_order_seq_cst);
+    }
+    return iree_ok_status();
+  }
+
  private:
   size_t workgroup_count_;
   std::unique_ptr<iree_atomic_int32_t[]> storage_;
@@ -69,9 +91,23 @@ class GridCoverage {
 
 class TaskDispatchTest : public TaskTest {
  public:
+  // Replaces the executor created by the fixture with one using
+  // |scheduling_mode|.
+  void RecreateExecutor(iree_task_scheduling_mode_t scheduling_mode) {
+    iree_task_executor_release(executor_);
+    executor_ = NULL;
+    iree_task_topology_t topology;
+    iree_task_topology_initialize_from_group_count(8, &topology);
+    IREE_ASSERT_OK(iree_task_executor_create(
+        scheduling_mode, &topology, /*worker_local_memory_size=*/(64 * 1024),
+        iree_allocator_system(), &executor_));
+    iree_task_topology_deinitialize(&topology);
+  }
+
   void DispatchAndVerifyGrid(const uint32_t workgroup_size[3],
                              const uint32_t workgroup_count[3],
-                             uint32_t dispatch_flags) {
+                             uint32_t dispatch_flags,
+                             uint32_t tiles_per_reservation_hint = 0) {
     IREE_TRACE_SCOPE();
     GridCoverage coverage(workgroup_count);
     iree_task_dispatch_t task;
@@ -80,6 +116,7 @@ class TaskDispatchTest : public TaskTest {
         iree_task_make_dispatch_closure(GridCoverage::Tile, (void*)&coverage),
         workgroup_size, workgroup_count, &task);
     task.header.flags |= dispatch_flags;
+    task.tiles_per_reservation_hint = tiles_per_reservation_hint;
     IREE_ASSERT_OK(SubmitTasksAndWaitIdle(&task.header, &task.header));
     EXPECT_TRUE(coverage.Verify());
   }
@@ -113,6 +150,125 @@ TEST_F(TaskDispatchTest, Issue345) {
   DispatchAndVerifyGrid(kWorkgroupSize, kWorkgroupCount, IREE_TASK_FLAG_NONE);
 }
 
+// Large enough that reservations grow from their initial size and then shrink
+// again at the tail of the grid.
+TEST_F(TaskDispatchTest, IssueLarge) {
+  IREE_TRACE_SCOPE();
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {512, 64, 3};
+  DispatchAndVerifyGrid(kWorkgroupSize, kWorkgroupCount, IREE_TASK_FLAG_NONE);
+}
+
+// Dispatches with a range function must cover the grid exactly once with
+// whatever reservation sizes the shards pick.
+TEST_F(TaskDispatchTest, IssueRanges) {
+  IREE_TRACE_SCOPE();
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {512, 64, 3};
+  GridCoverage coverage(kWorkgroupCount);
+  iree_task_dispatch_t task;
+  iree_task_dispatch_initialize(
+      &scope_,
+      iree_task_make_dispatch_closure(GridCoverage::Tile, (void*)&coverage),
+      kWorkgroupSize, kWorkgroupCount, &task);
+  task.range_fn = GridCoverage::Range;
+  IREE_ASSERT_OK(SubmitTasksAndWaitIdle(&task.header, &task.header));
+  EXPECT_TRUE(coverage.Verify());
+}
+
+// Column panel tile order and sticky shards must still cover the grid exactly
+// once, including the narrower last panel of each slice and ranges that are
+// split into one call per panel row.
+TEST_F(TaskDispatchTest, IssueLocalityOrdered) {
+  IREE_TRACE_SCOPE();
+  RecreateExecutor(IREE_TASK_SCHEDULING_MODE_LOCALITY_TILE_ORDER |
+                   IREE_TASK_SCHEDULING_MODE_STICKY_TILE_AFFINITY);
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {37, 13, 3};
+  DispatchAndVerifyGrid(kWorkgroupSize, kWorkgroupCount, IREE_TASK_FLAG_NONE);
+
+  GridCoverage coverage(kWorkgroupCount);
+  iree_task_dispatch_t task;
+  iree_task_dispatch_initialize(
+      &scope_,
+      iree_task_make_dispatch_closure(GridCoverage::Tile, (void*)&coverage),
+      kWorkgroupSize, kWorkgroupCount, &task);
+  task.range_fn = GridCoverage::Range;
+  IREE_ASSERT_OK(SubmitTasksAndWaitIdle(&task.header, &task.header));
+  EXPECT_TRUE(coverage.Verify());
+}
+
+// Issues a large normal priority dispatch alongside a high priority one in
+// another scope such that normal priority shards are preempted while the high
+// priority shards execute. Both grids must be fully covered exactly once.
+TEST_F(TaskDispatchTest, IssueConcurrentPriorities) {
+  IREE_TRACE_SCOPE();
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kNormalWorkgroupCount[3] = {512, 64, 3};
+  const uint32_t kHighWorkgroupCount[3] = {128, 16, 1};
+
+  iree_task_scope_t high_scope;
+  iree_task_scope_initialize(iree_make_cstring_view("high"), &high_scope);
+  iree_task_scope_set_priority(&high_scope, IREE_TASK_PRIORITY_HIGH);
+
+  GridCoverage normal_coverage(kNormalWorkgroupCount);
+  iree_task_dispatch_t normal_task;
+  iree_task_dispatch_initialize(
+      &scope_,
+      iree_task_make_dispatch_closure(GridCoverage::Tile,
+                                      (void*)&normal_coverage),
+      kWorkgroupSize, kNormalWorkgroupCount, &normal_task);
+  iree_task_fence_t* normal_fence = NULL;
+  IREE_ASSERT_OK(
+      iree_task_executor_acquire_fence(executor_, &scope_, &normal_fence));
+  iree_task_set_completion_task(&normal_task.header, &normal_fence->header);
+
+  GridCoverage high_coverage(kHighWorkgroupCount);
+  iree_task_dispatch_t high_task;
+  iree_task_dispatch_initialize(
+      &high_scope,
+      iree_task_make_dispatch_closure(GridCoverage::Tile,
+                                      (void*)&high_coverage),
+      kWorkgroupSize, kHighWorkgroupCount, &high_task);
+  iree_task_fence_t* high_fence = NULL;
+  IREE_ASSERT_OK(
+      iree_task_executor_acquire_fence(executor_, &high_scope, &high_fence));
+  iree_task_set_completion_task(&high_task.header, &high_fence->header);
+
+  // Submit the normal priority work first so that it is executing by the time
+  // the high priority work arrives.
+  iree_task_submission_t submission;
+  iree_task_submission_initialize(&submission);
+  iree_task_submission_enqueue(&submission, &normal_task.header);
+  iree_task_executor_submit(executor_, &submission);
+  iree_task_executor_flush(executor_);
+  iree_task_submission_initialize(&submission);
+  iree_task_submission_enqueue(&submission, &high_task.header);
+  iree_task_executor_submit(executor_, &submission);
+  iree_task_executor_flush(executor_);
+
+  IREE_ASSERT_OK(
+      iree_task_scope_wait_idle(&high_scope, IREE_TIME_INFINITE_FUTURE));
+  IREE_ASSERT_OK(iree_task_scope_wait_idle(&scope_, IREE_TIME_INFINITE_FUTURE));
+  EXPECT_TRUE(high_coverage.Verify());
+  EXPECT_TRUE(normal_coverage.Verify());
+
+  iree_task_scope_deinitialize(&high_scope);
+}
+
+TEST_F(TaskDispatchTest, IssueReservationHint) {
+  IREE_TRACE_SCOPE();
+  const uint32_t kWorkgroupSize[3] = {1, 1, 1};
+  const uint32_t kWorkgroupCount[3] = {1000, 3, 1};
+  DispatchAndVerifyGrid(kWorkgroupSize, kWorkgroupCount, IREE_TASK_FLAG_NONE,
+                        /*tiles_per_reservation_hint=*/1);
+  DispatchAndVerifyGrid(kWorkgroupSize, kWorkgroupCount, IREE_TASK_FLAG_NONE,
+                        /*tiles_per_reservation_hint=*/64);
+  // Hints beyond the maximum reservation size are clamped.
+  DispatchAndVerifyGrid(kWorkgroupSize, kWorkgroupCount, IREE_TASK_FLAG_NONE,
+                        /*tiles_per_reservation_hint=*/UINT32_MAX);
+}
+
 TEST_F(TaskDispatchTest, IssueIndirect) {
   IREE_TRACE_SCOPE();
 
@@ -21,12 +21,29 @@ extern "C" {
 
 // A bitmask indicating which other groups from 0 to N may constructively share
 // caches. For example, a value of 0b1100 indicates that group 2 and 3 share.
+//
+// Topologies with more than IREE_TASK_TOPOLOGY_GROUP_BIT_COUNT groups are split
+// into clusters of that many groups matching the executor worker clusters and
+// masks only reference groups in the same cluster: bit N in the mask of group G
+// refers to group (G / 64) * 64 + N.
 typedef uint64_t iree_task_topology_group_mask_t;
 
 #define IREE_TASK_TOPOLOGY_GROUP_MASK_ALL UINT64_MAX
 #define IREE_TASK_TOPOLOGY_GROUP_BIT_COUNT \
   (sizeof(iree_task_topology_group_mask_t) * 8)
 
+// Capacity of the highest performance cores in the system.
+// Matches the scale Linux uses for cpu_capacity.
+#define IREE_TASK_TOPOLOGY_GROUP_CAPACITY_MAX 1024
+
+// Sizes in bytes of the data caches used by a processor.
+// Each size is 0 if unknown.
+typedef struct iree_task_topology_cache_sizes_t {
+  uint32_t l1d;
+  uint32_t l2;
+  uint32_t l3;
+} iree_task_topology_cache_sizes_t;
+
 // Information about a particular group within the topology.
 // Groups may be of varying levels of granularity even within the same topology
 // based on how the topology is defined.
@@ -41,6 +58,26 @@ typedef struct iree_task_topology_group_t {
   // Processor index in the cpuinfo set.
   uint32_t processor_index;
 
+  // NUMA node the processor is attached to or 0 if the system has only a
+  // single node (or the information is not available).
+  uint32_t numa_node;
+
+  // Class of the core the group is mapped to with 0 being the highest
+  // performance class. Heterogeneous systems (such as ARM big.LITTLE or hybrid
+  // x86 with performance and efficiency cores) have one class per kind of core
+  // ordered by decreasing capacity while homogeneous systems only have class 0.
+  uint32_t core_class;
+
+  // Relative compute capacity of the core the group is mapped to in the range
+  // (0, IREE_TASK_TOPOLOGY_GROUP_CAPACITY_MAX] where the highest performance
+  // cores in the system have the maximum capacity. Used to weight how much
+  // work is distributed to each worker when enabled by the scheduling mode.
+  uint32_t capacity;
+
+  // Sizes of the caches used by the core the group is mapped to. Executables
+  // may use these to select code tuned for the cache hierarchy.
+  iree_task_topology_cache_sizes_t cache_sizes;
+
   // Ideal thread affinity for threads within this group.
   // All threads within the group share the same affinity and this is what
   // allows us to model Simultaneous Multi-Threading (SMT) (aka hyperthreading).
@@ -52,6 +89,12 @@ typedef struct iree_task_topology_group_t {
   // workers in a group all share an L2 cache then the groups indicated here may
   // all share the same L3 cache.
   iree_task_topology_group_mask_t constructive_sharing_mask;
+
+  // A bitmask of other group indices that are attached to the same NUMA node.
+  // Workers of this group can access the memory local to these other groups
+  // without crossing the node interconnect and should prefer them when
+  // stealing work over groups on remote nodes.
+  iree_task_topology_group_mask_t numa_node_mask;
 } iree_task_topology_group_t;
 
 // Initializes |out_group| with a |group_index| derived name.
@@ -79,6 +122,8 @@ typedef struct iree_task_topology_t {
   iree_host_size_t group_count;
   iree_task_topology_group_t groups[IREE_TASK_EXECUTOR_MAX_WORKER_COUNT];
 } iree_task_topology_t;
+static_assert(IREE_TASK_EXECUTOR_MAX_WORKER_COUNT <= UINT8_MAX + 1,
+              "group_index must be able to represent all groups");
 
 // Initializes an empty task topology.
 void iree_task_topology_initialize(iree_task_topology_t* out_topology);
@@ -8,6 +8,15 @@
 
 #include <cpuinfo.h>
 #include <stdio.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <dirent.h>
+#endif  // __linux__
+
+#if defined(__EMSCRIPTEN__)
+#include <emscripten/threading.h>
+#endif  // __EMSCRIPTEN__
 
 #include "iree/base/api.h"
 #include "iree/base/internal/math.h"
@@ -95,33 +104,136 @@ static void iree_task_topology_set_affinity_from_processor(
 #endif  // cpuinfo-like platform field
 }
 
-// Returns a bitset with all *processors* that share the same |cache|.
-static uint64_t iree_task_topology_calculate_cache_bits(
-    const struct cpuinfo_cache* cache) {
-  if (!cache) return 0;
-  uint64_t mask = 0;
-  for (uint32_t processor_i = 0; processor_i < cache->processor_count;
-       ++processor_i) {
-    uint32_t i = cache->processor_start + processor_i;
-    if (i < IREE_TASK_TOPOLOGY_GROUP_BIT_COUNT) {
-      mask |= 1ull << i;
+// Returns the NUMA node the given |processor| is attached to.
+// Returns 0 if the platform does not expose NUMA information or the system only
+// has a single node.
+static uint32_t iree_task_topology_query_numa_node(
+    const struct cpuinfo_processor* processor) {
+#if defined(__linux__)
+  // sysfs exposes the node of each CPU as a nodeN entry in its directory:
+  //   /sys/devices/system/cpu/cpu3/node1 -> ../../node/node1
+  // cpuinfo doesn't surface this so we go and look ourselves. This only happens
+  // during topology construction and the files are in-memory so it's cheap.
+  char cpu_path[64];
+  snprintf(cpu_path, IREE_ARRAYSIZE(cpu_path), "/sys/devices/system/cpu/cpu%u",
+           processor->linux_id);
+  DIR* dir = opendir(cpu_path);
+  if (!dir) return 0;
+  uint32_t numa_node = 0;
+  struct dirent* entry = NULL;
+  while ((entry = readdir(dir)) != NULL) {
+    unsigned int node_id = 0;
+    if (strncmp(entry->d_name, "node", 4) == 0 &&
+        sscanf(entry->d_name + 4, "%u", &node_id) == 1) {
+      numa_node = node_id;
+      break;
     }
   }
-  return mask;
+  closedir(dir);
+  return numa_node;
+#else
+  // TODO(benvanik): GetNumaProcessorNodeEx on Windows.
+  return 0;
+#endif  // __linux__
 }
 
-// Constructs a constructive sharing mask for all *processors* that share the
-// same cache as the specified |processor|.
-static uint64_t iree_task_topology_calculate_constructive_sharing_mask(
-    const struct cpuinfo_processor* processor) {
-  uint64_t mask = 0;
-  mask |= iree_task_topology_calculate_cache_bits(processor->cache.l1i);
-  mask |= iree_task_topology_calculate_cache_bits(processor->cache.l1d);
-  mask |= iree_task_topology_calculate_cache_bits(processor->cache.l2);
+// Returns the relative compute capacity of |core| in the range
+// (0, IREE_TASK_TOPOLOGY_GROUP_CAPACITY_MAX]. |max_frequency| is the highest
+// frequency of any core in the system or 0 if not known.
+static uint32_t iree_task_topology_query_core_capacity(
+    const struct cpuinfo_core* core, uint64_t max_frequency) {
+#if defined(__linux__)
+  // sysfs exposes the capacity the scheduler uses for each CPU on systems with
+  // asymmetric cores (such as ARM big.LITTLE/DynamIQ) already normalized such
+  // that the highest performance cores have a capacity of 1024:
+  //   /sys/devices/system/cpu/cpu3/cpu_capacity -> 446
+  // This accounts for both frequency and microarchitecture differences.
+  char capacity_path[64];
+  snprintf(capacity_path, IREE_ARRAYSIZE(capacity_path),
+           "/sys/devices/system/cpu/cpu%u/cpu_capacity",
+           cpuinfo_get_processor(core->processor_start)->linux_id);
+  FILE* file = fopen(capacity_path, "r");
+  if (file) {
+    unsigned int capacity = 0;
+    int count = fscanf(file, "%u", &capacity);
+    fclose(file);
+    if (count == 1 && capacity > 0) {
+      return iree_min(capacity, IREE_TASK_TOPOLOGY_GROUP_CAPACITY_MAX);
+    }
+  }
+#endif  // __linux__
+
+  // Fall back to scaling by the maximum frequency of the core. This ignores
+  // microarchitecture differences but still orders the core classes.
+  if (core->frequency && max_frequency) {
+    uint64_t capacity =
+        core->frequency * IREE_TASK_TOPOLOGY_GROUP_CAPACITY_MAX / max_frequency;
+    return (uint32_t)iree_max(
+        iree_min(capacity, IREE_TASK_TOPOLOGY_GROUP_CAPACITY_MAX), 1);
+  }
+  return IREE_TASK_TOPOLOGY_GROUP_CAPACITY_MAX;
+}
+
+// Queries the capacity and core class of every core in the system.
+// |out_capacities| and |out_core_classes| must have storage for
+// cpuinfo_get_cores_count() values. Cores are classified by capacity: all cores
+// with the highest capacity are class 0, those with the next highest are
+// class 1, etc.
+static void iree_task_topology_query_core_classes(uint32_t* out_capacities,
+                                                  uint32_t* out_core_classes) {
+  uint32_t core_count = cpuinfo_get_cores_count();
+  uint64_t max_frequency = 0;
+  for (uint32_t i = 0; i < core_count; ++i) {
+    max_frequency = iree_max(max_frequency, cpuinfo_get_core(i)->frequency);
+  }
+  for (uint32_t i = 0; i < core_count; ++i) {
+    out_capacities[i] = iree_task_topology_query_core_capacity(
+        cpuinfo_get_core(i), max_frequency);
+  }
+
+  // Gather the unique capacities in descending order; the index of a capacity
+  // in the list is the core class. There are usually only 1-3 unique values.
+  uint32_t* unique_capacities =
+      (uint32_t*)iree_alloca(core_count * sizeof(uint32_t));
+  uint32_t unique_count = 0;
+  for (uint32_t i = 0; i < core_count; ++i) {
+    uint32_t j = 0;
+    while (j < unique_count && unique_capacities[j] > out_capacities[i]) ++j;
+    if (j < unique_count && unique_capacities[j] == out_capacities[i]) continue;
+    memmove(&unique_capacities[j + 1], &unique_capacities[j],
+            (unique_count - j) * sizeof(uint32_t));
+    unique_capacities[j] = out_capacities[i];
+    ++unique_count;
+  }
+  for (uint32_t i = 0; i < core_count; ++i) {
+    uint32_t core_class = 0;
+    while (unique_capacities[core_class] != out_capacities[i]) ++core_class;
+    out_core_classes[i] = core_class;
+  }
+}
+
+// Returns true if |processor| and |other_processor| share some level of the
+// cache hierarchy that makes them likely to constructively share.
+static bool iree_task_topology_processors_share_cache(
+    const struct cpuinfo_processor* processor,
+    const struct cpuinfo_processor* other_processor) {
   // TODO(benvanik): include L3 here too (for systems that have it)? Or use L3
   // info purely for distribution and focus the group mask on lower-latency
   // caches?
-  return mask;
+  return (processor->cache.l1i &&
+          processor->cache.l1i == other_processor->cache.l1i) ||
+         (processor->cache.l1d &&
+          processor->cache.l1d == other_processor->cache.l1d) ||
+         (processor->cache.l2 &&
+          processor->cache.l2 == other_processor->cache.l2);
+}
+
+// Returns true if groups |i| and |j| are in the same group cluster and can
+// reference each other in their group masks.
+static bool iree_task_topology_groups_in_same_cluster(iree_host_size_t i,
+                                                      iree_host_size_t j) {
+  return i / IREE_TASK_TOPOLOGY_GROUP_BIT_COUNT ==
+         j / IREE_TASK_TOPOLOGY_GROUP_BIT_COUNT;
 }
 
 // Populates |our_group| with the information from |core|.
@@ -140,6 +252,16 @@ static void iree_task_topology_group_initialize_from_core(
       cpuinfo_get_processor(processor_i);
   iree_task_topology_set_affinity_from_processor(
       processor, &out_group->ideal_thread_affinity);
+  out_group->numa_node = iree_task_topology_query_numa_node(processor);
+  if (processor->cache.l1d) {
+    out_group->cache_sizes.l1d = processor->cache.l1d->size;
+  }
+  if (processor->cache.l2) {
+    out_group->cache_sizes.l2 = processor->cache.l2->size;
+  }
+  if (processor->cache.l3) {
+    out_group->cache_sizes.l3 = processor->cache.l3->size;
+  }
 }
 
 // Fixes constructive_sharing_mask values such that they represent other chosen
@@ -148,23 +270,21 @@ static void iree_task_topology_group_initialize_from_core(
 // processor IDs a particular group is mapped to.
 static void iree_task_topology_fixup_constructive_sharing_masks(
     iree_task_topology_t* topology) {
-  // O(n^2), but n is always <= 64 (and often <= 8).
+  // O(n^2), but n is always <= 256 (and often <= 8).
   for (iree_host_size_t i = 0; i < topology->group_count; ++i) {
     iree_task_topology_group_t* group = &topology->groups[i];
-
-    // Compute the processors that we can constructively share with.
-    uint64_t constructive_sharing_mask =
-        iree_task_topology_calculate_constructive_sharing_mask(
-            cpuinfo_get_processor(group->processor_index));
+    const struct cpuinfo_processor* processor =
+        cpuinfo_get_processor(group->processor_index);
 
     iree_task_topology_group_mask_t group_mask = 0;
     for (iree_host_size_t j = 0; j < topology->group_count; ++j) {
-      if (i == j) continue;
+      if (i == j || !iree_task_topology_groups_in_same_cluster(i, j)) continue;
       const iree_task_topology_group_t* other_group = &topology->groups[j];
-      uint64_t group_processor_bits =
-          iree_math_rotl_u64(1ull, other_group->processor_index);
-      if (constructive_sharing_mask & group_processor_bits) {
-        group_mask |= iree_math_rotl_u64(1ull, other_group->group_index);
+      if (iree_task_topology_processors_share_cache(
+              processor,
+              cpuinfo_get_processor(other_group->processor_index))) {
+        group_mask |= 1ull << (other_group->group_index %
+                               IREE_TASK_TOPOLOGY_GROUP_BIT_COUNT);
       }
     }
 
@@ -172,6 +292,44 @@ static void iree_task_topology_fixup_constructive_sharing_masks(
   }
 }
 
+// Fixes numa_node_mask values such that they contain all other groups in the
+// topology that are attached to the same NUMA node.
+static void iree_task_topology_fixup_numa_node_masks(
+    iree_task_topology_t* topology) {
+  for (iree_host_size_t i = 0; i < topology->group_count; ++i) {
+    iree_task_topology_group_t* group = &topology->groups[i];
+    iree_task_topology_group_mask_t group_mask = 0;
+    for (iree_host_size_t j = 0; j < topology->group_count; ++j) {
+      if (i == j || !iree_task_topology_groups_in_same_cluster(i, j)) continue;
+      const iree_task_topology_group_t* other_group = &topology->groups[j];
+      if (other_group->numa_node == group->numa_node) {
+        group_mask |= 1ull << (other_group->group_index %
+                               IREE_TASK_TOPOLOGY_GROUP_BIT_COUNT);
+      }
+    }
+    group->numa_node_mask = group_mask;
+  }
+}
+
+// Populates the core_class and capacity of all groups in |topology| from the
+// cores they are mapped to.
+static void iree_task_topology_fixup_core_classes(
+    iree_task_topology_t* topology) {
+  uint32_t core_count = cpuinfo_get_cores_count();
+  uint32_t* capacities = (uint32_t*)iree_alloca(core_count * sizeof(uint32_t));
+  uint32_t* core_classes =
+      (uint32_t*)iree_alloca(core_count * sizeof(uint32_t));
+  iree_task_topology_query_core_classes(capacities, core_classes);
+  for (iree_host_size_t i = 0; i < topology->group_count; ++i) {
+    iree_task_topology_group_t* group = &topology->groups[i];
+    uint32_t core_i =
+        (uint32_t)(cpuinfo_get_processor(group->processor_index)->core -
+                   cpuinfo_get_cores());
+    group->core_class = core_classes[core_i];
+    group->capacity = capacities[core_i];
+  }
+}
+
 // Initializes |out_topology| with a standardized behavior when cpuinfo is not
 // available (unsupported arch, failed to query, etc).
 static void iree_task_topology_initialize_fallback(
@@ -183,6 +341,16 @@ static void iree_task_topology_initialize_fallback(
   // either get cpuinfo working for their platform or manually construct the
   // topology themselves.
   iree_host_size_t group_count = 1;
+#if defined(IREE_PLATFORM_EMSCRIPTEN)
+  // Browsers expose the number of logical cores (navigator.hardwareConcurrency)
+  // but nothing about their layout. Each group is backed by a web worker so
+  // only builds with pthreads enabled get more than one.
+  if (emscripten_has_threading_support()) {
+    iree_host_size_t core_count =
+        (iree_host_size_t)iree_max(1, emscripten_num_logical_cores());
+    group_count = iree_min(core_count, max_group_count);
+  }
+#endif  // IREE_PLATFORM_EMSCRIPTEN
   iree_task_topology_initialize_from_group_count(group_count, out_topology);
   IREE_TRACE_ZONE_END(z0);
 }
@@ -213,10 +381,65 @@ void iree_task_topology_initialize_from_physical_cores_with_uarch(
       out_topology);
 }
 
+typedef struct iree_task_topology_core_class_filter_t {
+  uint32_t core_class;
+  // Core class of each core in cpuinfo order.
+  const uint32_t* core_classes;
+} iree_task_topology_core_class_filter_t;
+
+// Matches only cores with the core class specified by the
+// iree_task_topology_core_class_filter_t in |user_data|.
+static bool iree_task_topology_core_filter_core_class(
+    const struct cpuinfo_core* core, uintptr_t user_data) {
+  const iree_task_topology_core_class_filter_t* filter =
+      (const iree_task_topology_core_class_filter_t*)user_data;
+  return filter->core_classes[core - cpuinfo_get_cores()] ==
+         filter->core_class;
+}
+
+void iree_task_topology_initialize_from_physical_cores_with_core_class(
+    uint32_t core_class, iree_host_size_t max_core_count,
+    iree_task_topology_t* out_topology) {
+  if (!iree_task_topology_is_cpuinfo_available()) {
+    iree_task_topology_initialize_from_physical_cores(max_core_count,
+                                                      out_topology);
+    return;
+  }
+
+  uint32_t core_count = cpuinfo_get_cores_count();
+  uint32_t* capacities = (uint32_t*)iree_alloca(core_count * sizeof(uint32_t));
+  uint32_t* core_classes =
+      (uint32_t*)iree_alloca(core_count * sizeof(uint32_t));
+  iree_task_topology_query_core_classes(capacities, core_classes);
+  bool has_core_class = false;
+  for (uint32_t i = 0; i < core_count; ++i) {
+    if (core_classes[i] == core_class) {
+      has_core_class = true;
+      break;
+    }
+  }
+  if (!has_core_class) {
+    // Requested class does not exist on this system (such as efficiency cores
+    // on a homogeneous system); use all cores instead of none.
+    iree_task_topology_initialize_from_physical_cores(max_core_count,
+                                                      out_topology);
+    return;
+  }
+
+  iree_task_topology_core_class_filter_t filter = {
+      .core_class = core_class,
+      .core_classes = core_classes,
+  };
+  iree_task_topology_initialize_from_physical_cores_with_filter(
+      iree_task_topology_core_filter_core_class, (uintptr_t)&filter,
+      max_core_count, out_topology);
+}
+
 void iree_task_topology_initialize_from_physical_cores_with_filter(
     iree_task_topology_core_filter_t filter_fn, uintptr_t filter_fn_data,
     iree_host_size_t max_core_count, iree_task_topology_t* out_topology) {
-  max_core_count = iree_min(max_core_count, IREE_TASK_TOPOLOGY_GROUP_BIT_COUNT);
+  max_core_count =
+      iree_min(max_core_count, IREE_TASK_EXECUTOR_MAX_WORKER_COUNT);
   if (!iree_task_topology_is_cpuinfo_available()) {
     iree_task_topology_initialize_fallback(max_core_count, out_topology);
     return;
@@ -256,6 +479,8 @@ void iree_task_topology_initialize_from_physical_cores_with_filter(
   }
 
   iree_task_topology_fixup_constructive_sharing_masks(out_topology);
+  iree_task_topology_fixup_numa_node_masks(out_topology);
+  iree_task_topology_fixup_core_classes(out_topology);
   IREE_TRACE_ZONE_END(z0);
 }
 
@@ -273,6 +498,7 @@ void iree_task_topology_initialize_from_unique_l2_cache_groups(
 
   iree_host_size_t cache_count = cpuinfo_get_l2_caches_count();
   cache_count = iree_min(cache_count, max_group_count);
+  cache_count = iree_min(cache_count, IREE_TASK_EXECUTOR_MAX_WORKER_COUNT);
 
   iree_task_topology_initialize(out_topology);
 
@@ -296,5 +522,83 @@ void iree_task_topology_initialize_from_unique_l2_cache_groups(
   }
 
   iree_task_topology_fixup_constructive_sharing_masks(out_topology);
+  iree_task_topology_fixup_numa_node_masks(out_topology);
+  iree_task_topology_fixup_core_classes(out_topology);
+  IREE_TRACE_ZONE_END(z0);
+}
+
+void iree_task_topology_initialize_from_numa_nodes(
+    iree_host_size_t max_group_count, iree_task_topology_t* out_topology) {
+  max_group_count =
+      iree_min(max_group_count, IREE_TASK_EXECUTOR_MAX_WORKER_COUNT);
+  if (!iree_task_topology_is_cpuinfo_available()) {
+    iree_task_topology_initialize_fallback(max_group_count, out_topology);
+    return;
+  }
+
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, max_group_count);
+
+  // Query the node of each core. Nodes are usually densely numbered from 0 but
+  // we don't rely on that beyond sizing the per-node scratch storage.
+  uint32_t core_count = cpuinfo_get_cores_count();
+  uint32_t* core_numa_nodes =
+      (uint32_t*)iree_alloca(core_count * sizeof(uint32_t));
+  uint32_t numa_node_count = 0;
+  for (uint32_t i = 0; i < core_count; ++i) {
+    const struct cpuinfo_core* core = cpuinfo_get_core(i);
+    core_numa_nodes[i] = iree_task_topology_query_numa_node(
+        cpuinfo_get_processor(core->processor_start));
+    numa_node_count = iree_max(numa_node_count, core_numa_nodes[i] + 1);
+  }
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, numa_node_count);
+
+  // Count the cores available on each node.
+  uint32_t* node_core_counts =
+      (uint32_t*)iree_alloca(numa_node_count * sizeof(uint32_t));
+  uint32_t* node_group_counts =
+      (uint32_t*)iree_alloca(numa_node_count * sizeof(uint32_t));
+  memset(node_core_counts, 0, numa_node_count * sizeof(uint32_t));
+  memset(node_group_counts, 0, numa_node_count * sizeof(uint32_t));
+  for (uint32_t i = 0; i < core_count; ++i) {
+    ++node_core_counts[core_numa_nodes[i]];
+  }
+
+  // Distribute the groups round-robin across the nodes so that when the group
+  // count is less than the core count all nodes (and their memory controllers)
+  // are used evenly instead of filling up node 0 first.
+  iree_host_size_t group_count = iree_min(core_count, max_group_count);
+  for (iree_host_size_t assigned = 0; assigned < group_count;) {
+    for (uint32_t node = 0; node < numa_node_count && assigned < group_count;
+         ++node) {
+      if (node_group_counts[node] < node_core_counts[node]) {
+        ++node_group_counts[node];
+        ++assigned;
+      }
+    }
+  }
+
+  // Emit groups in node-major order so that workers on the same node have
+  // adjacent indices; this keeps the per-node masks contiguous and makes
+  // traces easier to read.
+  iree_task_topology_initialize(out_topology);
+  uint32_t group_i = 0;
+  for (uint32_t node = 0; node < numa_node_count; ++node) {
+    uint32_t node_group_i = 0;
+    for (uint32_t core_i = 0;
+         core_i < core_count && node_group_i < node_group_counts[node];
+         ++core_i) {
+      if (core_numa_nodes[core_i] != node) continue;
+      iree_task_topology_group_initialize_from_core(
+          group_i, cpuinfo_get_core(core_i), &out_topology->groups[group_i]);
+      ++group_i;
+      ++node_group_i;
+    }
+  }
+  out_topology->group_count = group_i;
+
+  iree_task_topology_fixup_constructive_sharing_masks(out_topology);
+  iree_task_topology_fixup_numa_node_masks(out_topology);
+  iree_task_topology_fixup_core_classes(out_topology);
   IREE_TRACE_ZONE_END(z0);
 }
@@ -35,6 +35,22 @@ void iree_task_topology_initialize_from_physical_cores_with_uarch(
     uint32_t cpuinfo_uarch, iree_host_size_t max_core_count,
     iree_task_topology_t* out_topology);
 
+// Initializes a topology with one group for each physical core in the machine
+// of the given |core_class|. Class 0 contains the highest performance cores in
+// the system (such as the big cores of ARM big.LITTLE or the performance cores
+// of hybrid x86) and higher classes contain progressively lower capacity
+// cores. Use this to pin executors running latency-critical work to only the
+// highest performance cores.
+//
+// Core capacities are queried from the OS when available (cpu_capacity on
+// Linux/Android) and otherwise derived from the maximum core frequencies.
+// If neither is available or the system has no cores of |core_class| this
+// falls back to the same behavior as
+// iree_task_topology_initialize_from_physical_cores.
+void iree_task_topology_initialize_from_physical_cores_with_core_class(
+    uint32_t core_class, iree_host_size_t max_core_count,
+    iree_task_topology_t* out_topology);
+
 // Returns true if the given |core| passes the filter and should be included.
 // |user_data| is the value passed alongside the filter function.
 typedef bool (*iree_task_topology_core_filter_t)(
@@ -58,11 +74,21 @@ void iree_task_topology_initialize_from_physical_cores_with_filter(
 void iree_task_topology_initialize_from_unique_l2_cache_groups(
     iree_host_size_t max_group_count, iree_task_topology_t* out_topology);
 
+// Initializes a topology with one group for each physical core in the machine
+// distributed evenly across all NUMA nodes. Groups are ordered by node and each
+// group records the node it is attached to such that workers prefer stealing
+// from others on the same node and keep their local memory node-local.
+//
+// On systems with a single NUMA node (or where node information is not
+// available) this is equivalent to
+// iree_task_topology_initialize_from_physical_cores without the rotation.
+void iree_task_topology_initialize_from_numa_nodes(
+    iree_host_size_t max_group_count, iree_task_topology_t* out_topology);
+
 // TODO(#4654): more helpers and better defaults for the platforms we support.
 // Users can always make their own but just using these is the common path.
 // Ideas:
 // - _from_unique_l2_cache_groups but with a min/max count (N% utilization)
-// - cluster filtering (big/little cores on ARM)
 
 #ifdef __cplusplus
 }  // extern "C"
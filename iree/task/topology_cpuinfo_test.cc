@@ -29,6 +29,8 @@ static void EnsureTopologyValid(iree_host_size_t max_group_count,
     const iree_task_topology_group_t* group =
         iree_task_topology_get_group(topology, i);
     EXPECT_EQ(i, group->group_index);
+    EXPECT_GT(group->capacity, 0);
+    EXPECT_LE(group->capacity, IREE_TASK_TOPOLOGY_GROUP_CAPACITY_MAX);
   }
 }
 
@@ -41,4 +43,49 @@ TEST(TopologyTest, FromPhysicalCores) {
   iree_task_topology_deinitialize(&topology);
 }
 
+TEST(TopologyTest, FromPhysicalCoresWithCoreClass) {
+  static constexpr iree_host_size_t kMaxGroupCount = 4;
+  iree_task_topology_t topology;
+  iree_task_topology_initialize(&topology);
+  // Class 0 always exists and only contains the highest capacity cores.
+  iree_task_topology_initialize_from_physical_cores_with_core_class(
+      /*core_class=*/0, kMaxGroupCount, &topology);
+  EnsureTopologyValid(kMaxGroupCount, &topology);
+  for (iree_host_size_t i = 0; i < iree_task_topology_group_count(&topology);
+       ++i) {
+    const iree_task_topology_group_t* group =
+        iree_task_topology_get_group(&topology, i);
+    EXPECT_EQ(0, group->core_class);
+    EXPECT_EQ(iree_task_topology_get_group(&topology, 0)->capacity,
+              group->capacity);
+  }
+  iree_task_topology_deinitialize(&topology);
+}
+
+TEST(TopologyTest, FromNUMANodes) {
+  static constexpr iree_host_size_t kMaxGroupCount = 4;
+  iree_task_topology_t topology;
+  iree_task_topology_initialize(&topology);
+  iree_task_topology_initialize_from_numa_nodes(kMaxGroupCount, &topology);
+  EnsureTopologyValid(kMaxGroupCount, &topology);
+  // Groups must be emitted in node-major order and each group must only claim
+  // to share a node with groups that actually do.
+  for (iree_host_size_t i = 0; i < iree_task_topology_group_count(&topology);
+       ++i) {
+    const iree_task_topology_group_t* group =
+        iree_task_topology_get_group(&topology, i);
+    if (i > 0) {
+      EXPECT_GE(group->numa_node,
+                iree_task_topology_get_group(&topology, i - 1)->numa_node);
+    }
+    for (iree_host_size_t j = 0; j < iree_task_topology_group_count(&topology);
+         ++j) {
+      if (i == j || !(group->numa_node_mask & (1ull << j))) continue;
+      EXPECT_EQ(group->numa_node,
+                iree_task_topology_get_group(&topology, j)->numa_node);
+    }
+  }
+  iree_task_topology_deinitialize(&topology);
+}
+
 }  // namespace
@@ -60,6 +60,12 @@ TEST(TopologyTest, Construction) {
     const iree_task_topology_group_t* group =
         iree_task_topology_get_group(&topology, i);
     EXPECT_EQ(i, group->group_index);
+    // Manually constructed groups default to a single shared NUMA node.
+    EXPECT_EQ(0, group->numa_node);
+    EXPECT_EQ(IREE_TASK_TOPOLOGY_GROUP_MASK_ALL, group->numa_node_mask);
+    // And a single class of full capacity cores.
+    EXPECT_EQ(0, group->core_class);
+    EXPECT_EQ(IREE_TASK_TOPOLOGY_GROUP_CAPACITY_MAX, group->capacity);
   }
 
   iree_task_topology_deinitialize(&topology);
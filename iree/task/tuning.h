@@ -12,10 +12,45 @@ extern "C" {
 #endif  // __cplusplus
 
 // Maximum number of workers that an executor can manage.
-// A 64 worker hard limit is based on us using uint64_t as a bitmask to select
-// workers. It's easy to go smaller (just use fewer bits) if it's known that
-// only <64 will ever be used (such as for devices with 2 cores).
-#define IREE_TASK_EXECUTOR_MAX_WORKER_COUNT (64)
+// Workers are tracked in clusters of 64 (one uint64_t bitmask each) with a
+// summary mask of clusters (see iree_atomic_task_worker_set_t) and this limit
+// only bounds the storage reserved for the clusters and topologies. It's easy
+// to go smaller if it's known that only a few workers will ever be used (such
+// as for devices with 2 cores) and doing so reduces the size of topologies and
+// post batches. Going larger than 256 requires widening the topology group
+// index.
+#if !defined(IREE_TASK_EXECUTOR_MAX_WORKER_COUNT)
+#define IREE_TASK_EXECUTOR_MAX_WORKER_COUNT (256)
+#endif  // !IREE_TASK_EXECUTOR_MAX_WORKER_COUNT
+
+// Alignment of each worker's local memory allocation.
+// Allocations are aligned to (at least) the common page size so that no page is
+// shared between two workers. This allows the pages of each allocation to be
+// placed on the NUMA node of the worker that first touches them and avoids
+// false sharing at any level of the memory hierarchy.
+#define IREE_TASK_EXECUTOR_WORKER_LOCAL_MEMORY_ALIGNMENT (4096)
+
+// Size in bytes of the blocks in each worker's local memory block pool.
+// Local memory requirements that fit within a block (including the alignment
+// padding) are served from the pool and reuse the same block as the local
+// memory grows; larger requirements are allocated directly from the system.
+#define IREE_TASK_EXECUTOR_WORKER_LOCAL_MEMORY_BLOCK_SIZE (64 * 1024)
+
+// Default maximum duration in nanoseconds that workers spin waiting for new
+// work before parking. 0 disables spinning such that workers park as soon as
+// they run out of work.
+#define IREE_TASK_EXECUTOR_DEFAULT_WORKER_SPIN_NS (0)
+
+// Controls how quickly workers using adaptive spinning react to changes in the
+// observed idle durations. Each new sample moves the running estimate by
+// 1/(1 << shift) of the difference between it and the estimate: larger values
+// smooth out noise while smaller values respond faster to phase changes.
+#define IREE_TASK_EXECUTOR_WORKER_SPIN_ESTIMATE_SHIFT (3)
+
+// Number of tasks that fit in each worker's lock-free local task queue.
+// Tasks beyond this are kept in an overflow list only visible to the owning
+// worker until space is available. Must be a power of two.
+#define IREE_TASK_QUEUE_CAPACITY (256)
 
 // Initial number of shard tasks that are allocated in the executor pool.
 // Increasing this number will decrease initial allocation storms in cases of
@@ -23,6 +58,11 @@ extern "C" {
 // at the cost of a higher minimum memory consumption.
 #define IREE_TASK_EXECUTOR_INITIAL_SHARD_RESERVATION_PER_WORKER (4)
 
+// Number of tasks that fit in each segment of the executor incoming ready
+// queue. Segments are allocated as more tasks are in flight between submission
+// and coordination and recycled once drained. Must be a power of two.
+#define IREE_TASK_EXECUTOR_INCOMING_READY_SEGMENT_CAPACITY 256
+
 // Maximum number of events retained by the executor event pool.
 #define IREE_TASK_EXECUTOR_EVENT_POOL_CAPACITY 64
 
@@ -76,12 +116,12 @@ extern "C" {
 // In real-time systems too few tasks is better (slightly more work for much
 // lower variance in execution) while in batch mode systems too many tasks is
 // better (as latencies don't matter so long as throughput is maximized).
-#define IREE_TASK_EXECUTOR_MAX_THEFT_TASK_COUNT \
-  IREE_TASK_EXECUTOR_MAX_WORKER_COUNT
+#define IREE_TASK_EXECUTOR_MAX_THEFT_TASK_COUNT (64)
 
-// Number of tiles that will be batched into a single reservation from the grid.
-// This is a maximum; if there are fewer tiles that would otherwise allow for
-// maximum parallelism then this may be ignored.
+// Maximum number of tiles that will be batched into a single reservation from
+// the grid. Reservation sizes adapt per dispatch (see
+// IREE_TASK_DISPATCH_TARGET_RESERVATION_DURATION_NS) and this bounds how far
+// they can grow when tiles are very cheap.
 //
 // The more tiles reserved at a time the higher the chance for latency to
 // increase as many reserved tiles are held up on one worker while another may
@@ -91,7 +131,35 @@ extern "C" {
 // destroying behavior where multiple workers all stomp on the same cache lines
 // (as say worker 0 and worker 1 both fight over sequential tiles adjacent in
 // memory).
-#define IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION (8)
+#define IREE_TASK_DISPATCH_MAX_TILES_PER_SHARD_RESERVATION (256)
+
+// Number of tiles that will be batched into the first reservations of a
+// dispatch before anything is known about how long its tiles take to execute.
+// Dispatches may override this with iree_task_dispatch_t::tiles_per_reservation
+// (such as from executable hints). If there are fewer tiles than would allow
+// for maximum parallelism then this may be ignored.
+#define IREE_TASK_DISPATCH_INITIAL_TILES_PER_SHARD_RESERVATION (8)
+
+// Target duration of each reservation of tiles from a dispatch grid.
+// Shards time their first reservations and grow or shrink the number of tiles
+// reserved at a time toward this duration. Short durations keep workers
+// responsive and the tail of a dispatch balanced while long durations amortize
+// the cost of the shared atomic reservation over more tiles.
+//
+// Set to 0 to disable adaptation and always use the initial reservation size.
+#define IREE_TASK_DISPATCH_TARGET_RESERVATION_DURATION_NS (20 * 1000)
+
+// Number of reservations each shard times to adapt the reservation size.
+// Tiles in a dispatch generally have uniform cost and after a few samples
+// timing is stopped to avoid the overhead of querying the clock. The
+// reservation size may still shrink afterward to balance the tail of the grid.
+#define IREE_TASK_DISPATCH_TIMED_RESERVATION_COUNT (4)
+
+// Width in tiles of the column panels dispatch grids are traversed in when
+// IREE_TASK_SCHEDULING_MODE_LOCALITY_TILE_ORDER is enabled. Wider panels give
+// longer contiguous runs of tiles (and range calls) while narrower panels
+// reuse more of the data along y at the cost of less reuse along x.
+#define IREE_TASK_DISPATCH_TILE_PANEL_WIDTH (8)
 
 // Whether to enable per-tile colors for each tile tracing zone based on the
 // tile grid xyz. Not cheap and can be disabled to reduce tracing overhead.
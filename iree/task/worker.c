@@ -20,23 +20,69 @@
 
 static int iree_task_worker_main(iree_task_worker_t* worker);
 
+#if IREE_STATISTICS_ENABLE
+// Adds |delta| to a worker |counter|. Only the worker thread writes its
+// counters so this avoids the cost of an atomic read-modify-write.
+static inline void iree_task_worker_counter_add(iree_atomic_int64_t* counter,
+                                                int64_t delta) {
+  iree_atomic_store_int64(
+      counter,
+      iree_atomic_load_int64(counter, iree_memory_order_relaxed) + delta,
+      iree_memory_order_relaxed);
+}
+#define IREE_TASK_WORKER_COUNT(worker, counter, delta) \
+  iree_task_worker_counter_add(&(worker)->counters.counter, (delta))
+#define IREE_TASK_WORKER_TIME_NOW() iree_time_now()
+#else
+#define IREE_TASK_WORKER_COUNT(worker, counter, delta) (void)(delta)
+#define IREE_TASK_WORKER_TIME_NOW() 0
+#endif  // IREE_STATISTICS_ENABLE
+
 iree_status_t iree_task_worker_initialize(
     iree_task_executor_t* executor, iree_host_size_t worker_index,
     const iree_task_topology_group_t* topology_group,
-    iree_byte_span_t local_memory, iree_prng_splitmix64_state_t* seed_prng,
-    iree_task_worker_t* out_worker) {
+    iree_prng_splitmix64_state_t* seed_prng, iree_task_worker_t* out_worker) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
   out_worker->executor = executor;
   out_worker->worker_bit = iree_task_affinity_for_worker(worker_index);
+  out_worker->cluster_index =
+      iree_task_affinity_cluster_for_worker(worker_index);
   out_worker->ideal_thread_affinity = topology_group->ideal_thread_affinity;
+  if (executor->scheduling_mode & IREE_TASK_SCHEDULING_MODE_DETERMINISTIC) {
+    // Pin to exactly the ideal processor instead of letting the thread move
+    // between it and its SMT siblings.
+    out_worker->ideal_thread_affinity.smt = 0;
+  }
   out_worker->constructive_sharing_mask =
       topology_group->constructive_sharing_mask;
+  out_worker->numa_node_mask = topology_group->numa_node_mask;
   out_worker->max_theft_attempts =
       executor->worker_count / IREE_TASK_EXECUTOR_MAX_THEFT_ATTEMPTS_DIVISOR;
+  out_worker->capacity = IREE_TASK_TOPOLOGY_GROUP_CAPACITY_MAX;
+  if ((executor->scheduling_mode &
+       IREE_TASK_SCHEDULING_MODE_WEIGHT_BY_CORE_CAPACITY) &&
+      topology_group->capacity > 0) {
+    out_worker->capacity = iree_min(topology_group->capacity,
+                                    IREE_TASK_TOPOLOGY_GROUP_CAPACITY_MAX);
+  }
   iree_prng_minilcg128_initialize(iree_prng_splitmix64_next(seed_prng),
                                   &out_worker->theft_prng);
-  out_worker->local_memory = local_memory;
+  iree_arena_block_pool_initialize(
+      IREE_TASK_EXECUTOR_WORKER_LOCAL_MEMORY_BLOCK_SIZE, executor->allocator,
+      &out_worker->local_block_pool);
+  iree_arena_initialize(&out_worker->local_block_pool,
+                        &out_worker->local_arena);
+  out_worker->local_memory = iree_make_byte_span(NULL, 0);
+  iree_atomic_store_int32(&out_worker->local_memory_trim_requested, 0,
+                          iree_memory_order_relaxed);
+  out_worker->spin_ns = executor->worker_spin_ns;
+  // Start out assuming work arrives quickly so that we spin until we learn
+  // otherwise.
+  out_worker->idle_estimate_ns =
+      executor->worker_spin_adaptive && executor->worker_spin_ns > 0
+          ? iree_max(executor->worker_spin_ns / 2, 1)
+          : 0;
 
   iree_task_worker_state_t initial_state = IREE_TASK_WORKER_STATE_RUNNING;
   if (executor->scheduling_mode &
@@ -52,8 +98,23 @@ iree_status_t iree_task_worker_initialize(
 
   iree_notification_initialize(&out_worker->wake_notification);
   iree_notification_initialize(&out_worker->state_notification);
+  iree_atomic_store_int32(&out_worker->external_wake_count, 0,
+                          iree_memory_order_relaxed);
   iree_atomic_task_slist_initialize(&out_worker->mailbox_slist);
+  iree_atomic_task_slist_initialize(&out_worker->priority_mailbox_slist);
+  iree_atomic_store_int32(&out_worker->priority_pending, 0,
+                          iree_memory_order_relaxed);
   iree_task_queue_initialize(&out_worker->local_task_queue);
+  iree_task_queue_initialize(&out_worker->priority_task_queue);
+#if IREE_STATISTICS_ENABLE
+  memset(&out_worker->counters, 0, sizeof(out_worker->counters));
+#endif  // IREE_STATISTICS_ENABLE
+
+  // External workers are run by host threads and have no thread of their own.
+  if (executor->external_worker_wake.fn) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_ok_status();
+  }
 
   iree_thread_create_params_t thread_params;
   memset(&thread_params, 0, sizeof(thread_params));
@@ -131,41 +192,174 @@ void iree_task_worker_deinitialize(iree_task_worker_t* worker) {
   // get anything more posted to it) and then discarding everything we still
   // have a reference to.
   iree_atomic_task_slist_discard(&worker->mailbox_slist);
-  iree_task_list_discard(&worker->local_task_queue.list);
+  iree_atomic_task_slist_discard(&worker->priority_mailbox_slist);
+  iree_task_queue_deinitialize(&worker->local_task_queue);
+  iree_task_queue_deinitialize(&worker->priority_task_queue);
+
+  // The worker thread has exited and can no longer be using its local memory.
+  iree_arena_deinitialize(&worker->local_arena);
+  iree_arena_block_pool_deinitialize(&worker->local_block_pool);
+  worker->local_memory = iree_make_byte_span(NULL, 0);
 
   iree_notification_deinitialize(&worker->wake_notification);
   iree_notification_deinitialize(&worker->state_notification);
   iree_atomic_task_slist_deinitialize(&worker->mailbox_slist);
-  iree_task_queue_deinitialize(&worker->local_task_queue);
+  iree_atomic_task_slist_deinitialize(&worker->priority_mailbox_slist);
 
   IREE_TRACE_ZONE_END(z0);
 }
 
+void iree_task_worker_request_trim(iree_task_worker_t* worker) {
+  iree_atomic_store_int32(&worker->local_memory_trim_requested, 1,
+                          iree_memory_order_release);
+  // Kick the worker in case it is waiting for work so that it trims now instead
+  // of whenever it next runs out of work.
+  iree_task_worker_wake(worker);
+}
+
+void iree_task_worker_wake(iree_task_worker_t* worker) {
+  const iree_task_executor_worker_wake_callback_t* external_worker_wake =
+      &worker->executor->external_worker_wake;
+  if (!external_worker_wake->fn) {
+    iree_notification_post(&worker->wake_notification, 1);
+    return;
+  }
+  // Only the first wake since the worker last ran needs to be issued; the
+  // host thread running the worker will observe any subsequent wakes prior to
+  // returning and keep running.
+  if (iree_atomic_fetch_add_int32(&worker->external_wake_count, 1,
+                                  iree_memory_order_acq_rel) == 0) {
+    iree_host_size_t worker_index =
+        (iree_host_size_t)(worker - worker->executor->workers);
+    external_worker_wake->fn(external_worker_wake->user_data, worker_index);
+  }
+}
+
 void iree_task_worker_post_tasks(iree_task_worker_t* worker,
+                                 iree_task_priority_t priority,
                                  iree_task_list_t* list) {
   // Move the list into the mailbox. Note that the mailbox is LIFO and this list
   // is concatenated with its current order preserved (which should be LIFO).
-  iree_atomic_task_slist_concat(&worker->mailbox_slist, list->head, list->tail);
+  if (priority == IREE_TASK_PRIORITY_HIGH) {
+    iree_atomic_task_slist_concat(&worker->priority_mailbox_slist, list->head,
+                                  list->tail);
+    // Set after the tasks are visible so that a worker observing the flag is
+    // guaranteed to find them when it flushes the mailbox.
+    iree_atomic_store_int32(&worker->priority_pending, 1,
+                            iree_memory_order_release);
+  } else {
+    iree_atomic_task_slist_concat(&worker->mailbox_slist, list->head,
+                                  list->tail);
+  }
   memset(list, 0, sizeof(*list));
 }
 
+void iree_task_worker_query_statistics(
+    iree_task_worker_t* worker, iree_task_worker_statistics_t* out_statistics) {
+  memset(out_statistics, 0, sizeof(*out_statistics));
+#if IREE_STATISTICS_ENABLE
+  iree_task_worker_counters_t* counters = &worker->counters;
+  out_statistics->task_count = (uint64_t)iree_atomic_load_int64(
+      &counters->task_count, iree_memory_order_relaxed);
+  out_statistics->tile_count = (uint64_t)iree_atomic_load_int64(
+      &counters->tile_count, iree_memory_order_relaxed);
+  out_statistics->steal_attempt_count = (uint64_t)iree_atomic_load_int64(
+      &counters->steal_attempt_count, iree_memory_order_relaxed);
+  out_statistics->steal_success_count = (uint64_t)iree_atomic_load_int64(
+      &counters->steal_success_count, iree_memory_order_relaxed);
+  out_statistics->executing_ns = iree_atomic_load_int64(
+      &counters->executing_ns, iree_memory_order_relaxed);
+  out_statistics->parked_ns =
+      iree_atomic_load_int64(&counters->parked_ns, iree_memory_order_relaxed);
+#endif  // IREE_STATISTICS_ENABLE
+}
+
 iree_task_t* iree_task_worker_try_steal_task(iree_task_worker_t* worker,
                                              iree_task_queue_t* target_queue,
                                              iree_host_size_t max_tasks) {
   // Try to grab tasks from the worker; if more than one task is stolen then the
   // first will be returned and the remaining will be added to the target queue.
+  // High priority tasks are stolen first so that idle workers help finish
+  // latency-critical work before anything else.
   iree_task_t* task = iree_task_queue_try_steal(
+      &worker->priority_task_queue, target_queue,
+      /*max_tasks=*/IREE_TASK_EXECUTOR_MAX_THEFT_TASK_COUNT);
+  if (task) return task;
+  task = iree_task_queue_try_steal(
       &worker->local_task_queue, target_queue,
       /*max_tasks=*/IREE_TASK_EXECUTOR_MAX_THEFT_TASK_COUNT);
   if (task) return task;
 
-  // If we still didn't steal any tasks then let's try the slist instead.
+  // If we still didn't steal any tasks then let's try the slists instead.
+  task = iree_atomic_task_slist_pop(&worker->priority_mailbox_slist);
+  if (task) return task;
   task = iree_atomic_task_slist_pop(&worker->mailbox_slist);
   if (task) return task;
 
   return NULL;
 }
 
+// Ensures the worker has at least |minimum_size| bytes of local memory.
+// If the current local memory is too small it is replaced with a larger
+// allocation that becomes the new high-water mark and is retained for future
+// dispatches until the worker is trimmed. Contents are not preserved.
+//
+// Must only be called from the worker thread.
+static iree_status_t iree_task_worker_reserve_local_memory(
+    iree_task_worker_t* worker, iree_host_size_t minimum_size) {
+  if (IREE_LIKELY(minimum_size <= worker->local_memory.data_length)) {
+    return iree_ok_status();
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Grow geometrically so that a sequence of dispatches each requiring a bit
+  // more than the last doesn't reallocate every time.
+  iree_host_size_t new_size = iree_host_align(
+      iree_max(minimum_size, worker->local_memory.data_length * 2),
+      IREE_TASK_EXECUTOR_WORKER_LOCAL_MEMORY_ALIGNMENT);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)new_size);
+
+  // Drop the old allocation first so that its block can be reused if the new
+  // size still fits. We over-allocate to be able to align the base address as
+  // the allocator makes no such guarantees.
+  iree_arena_reset(&worker->local_arena);
+  worker->local_memory = iree_make_byte_span(NULL, 0);
+  void* base_ptr = NULL;
+  iree_status_t status = iree_arena_allocate(
+      &worker->local_arena,
+      new_size + IREE_TASK_EXECUTOR_WORKER_LOCAL_MEMORY_ALIGNMENT - 1,
+      &base_ptr);
+  if (iree_status_is_ok(status)) {
+    worker->local_memory = iree_make_byte_span(
+        (void*)iree_host_align(
+            (uintptr_t)base_ptr,
+            IREE_TASK_EXECUTOR_WORKER_LOCAL_MEMORY_ALIGNMENT),
+        new_size);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Releases the worker local memory if a trim has been requested.
+// Must only be called from the worker thread while no dispatch is using the
+// local memory.
+static void iree_task_worker_trim_local_memory_if_requested(
+    iree_task_worker_t* worker) {
+  if (IREE_LIKELY(!iree_atomic_load_int32(&worker->local_memory_trim_requested,
+                                          iree_memory_order_relaxed))) {
+    return;
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_atomic_store_int32(&worker->local_memory_trim_requested, 0,
+                          iree_memory_order_relaxed);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, (int64_t)worker->local_memory.data_length);
+  iree_arena_reset(&worker->local_arena);
+  iree_arena_block_pool_trim(&worker->local_block_pool);
+  worker->local_memory = iree_make_byte_span(NULL, 0);
+  IREE_TRACE_ZONE_END(z0);
+}
+
 // Executes a task on a worker.
 // Only task types that are scheduled to workers are handled; all others must be
 // handled by the coordinator during scheduling.
@@ -186,9 +380,28 @@ static void iree_task_worker_execute(
       break;
     }
     case IREE_TASK_TYPE_DISPATCH_SHARD: {
-      iree_task_dispatch_shard_execute((iree_task_dispatch_shard_t*)task,
-                                       worker->local_memory,
-                                       pending_submission);
+      // Grow the worker local memory if the dispatch needs more than we have.
+      // On failure the shard is still executed and will fail the dispatch as
+      // the local memory is insufficient.
+      iree_task_dispatch_shard_t* shard_task =
+          (iree_task_dispatch_shard_t*)task;
+      iree_status_ignore(iree_task_worker_reserve_local_memory(
+          worker,
+          iree_task_dispatch_shard_parent(shard_task)->local_memory_size));
+      // Normal priority shards yield when high priority work is posted to us
+      // and are requeued to continue after it has been executed.
+      iree_atomic_int32_t* preemption_flag =
+          iree_task_scope_priority(task->scope) < IREE_TASK_PRIORITY_HIGH
+              ? &worker->priority_pending
+              : NULL;
+      bool preempted = false;
+      uint32_t tile_count = iree_task_dispatch_shard_execute(
+          shard_task, worker->local_memory, worker->capacity, preemption_flag,
+          pending_submission, &preempted);
+      IREE_TASK_WORKER_COUNT(worker, tile_count, tile_count);
+      if (preempted) {
+        iree_task_queue_push_front(&worker->local_task_queue, task);
+      }
       break;
     }
     default:
@@ -207,10 +420,21 @@ static bool iree_task_worker_pump_once(
     iree_task_worker_t* worker, iree_task_submission_t* pending_submission) {
   IREE_TRACE_ZONE_BEGIN(z0);
 
+  // High priority work is always executed first: check the local priority
+  // queue and then the priority mailbox before any normal priority work. The
+  // pending flag is cleared before flushing so that a post racing with the
+  // flush leaves it set and we check again on the next pump.
+  iree_task_t* task = iree_task_queue_pop_front(&worker->priority_task_queue);
+  if (!task && iree_atomic_exchange_int32(&worker->priority_pending, 0,
+                                          iree_memory_order_acquire)) {
+    task = iree_task_queue_flush_from_lifo_slist(
+        &worker->priority_task_queue, &worker->priority_mailbox_slist);
+  }
+
   // Check the local work queue for any work we know we should start
   // processing immediately. Other workers may try to steal some of this work
   // if we take too long.
-  iree_task_t* task = iree_task_queue_pop_front(&worker->local_task_queue);
+  if (!task) task = iree_task_queue_pop_front(&worker->local_task_queue);
 
   // Check the mailbox to see if we have incoming work that has been posted.
   // We try to greedily move it to our local work list so that we can work
@@ -229,12 +453,17 @@ static bool iree_task_worker_pump_once(
   // If we ran out of work assigned to this specific worker try to steal some
   // from other workers that we hopefully share some of the cache hierarchy
   // with. Their tasks will be moved from their local queue into ours and the
-  // the first task in the queue is popped off and returned.
-  if (!task) {
+  // the first task in the queue is popped off and returned. Stealing is
+  // disabled in deterministic mode as what is stolen depends on timing.
+  if (!task && !(worker->executor->scheduling_mode &
+                 IREE_TASK_SCHEDULING_MODE_DETERMINISTIC)) {
     task = iree_task_executor_try_steal_task(
-        worker->executor, worker->constructive_sharing_mask,
+        worker->executor, worker->cluster_index,
+        worker->constructive_sharing_mask, worker->numa_node_mask,
         worker->max_theft_attempts, &worker->theft_prng,
         &worker->local_task_queue);
+    IREE_TASK_WORKER_COUNT(worker, steal_attempt_count, 1);
+    IREE_TASK_WORKER_COUNT(worker, steal_success_count, task ? 1 : 0);
   }
 
   // No tasks to run; let the caller know we want to wait for more.
@@ -245,12 +474,140 @@ static bool iree_task_worker_pump_once(
 
   // Execute the task (may call out to arbitrary user code and may submit more
   // tasks for execution).
+  iree_time_t execute_start_ns = IREE_TASK_WORKER_TIME_NOW();
   iree_task_worker_execute(worker, task, pending_submission);
+  IREE_TASK_WORKER_COUNT(worker, task_count, 1);
+  IREE_TASK_WORKER_COUNT(worker, executing_ns,
+                         IREE_TASK_WORKER_TIME_NOW() - execute_start_ns);
 
   IREE_TRACE_ZONE_END(z0);
   return true;  // try again
 }
 
+// Returns the duration the worker should spin waiting for new work before
+// parking based on its configuration and recently observed idle durations.
+static iree_duration_t iree_task_worker_select_spin_duration(
+    iree_task_worker_t* worker) {
+  if (!worker->idle_estimate_ns) return worker->spin_ns;
+  // If new work has recently taken longer to arrive than we are willing to
+  // spin then spinning would just burn the core before we park anyway.
+  if (worker->idle_estimate_ns > worker->spin_ns) return 0;
+  // Leave some slack for jitter in the arrival times.
+  return iree_min(worker->spin_ns, 2 * worker->idle_estimate_ns);
+}
+
+// Updates the running estimate of the worker idle duration with a new sample.
+static void iree_task_worker_update_idle_estimate(iree_task_worker_t* worker,
+                                                  iree_duration_t idle_ns) {
+  if (!worker->idle_estimate_ns) return;
+  // Clamp the samples so that a single long idle period (such as between
+  // requests) doesn't prevent spinning for a long time afterward.
+  idle_ns = iree_min(idle_ns, 2 * worker->spin_ns);
+  iree_duration_t estimate_ns =
+      worker->idle_estimate_ns +
+      (idle_ns - worker->idle_estimate_ns) /
+          (1 << IREE_TASK_EXECUTOR_WORKER_SPIN_ESTIMATE_SHIFT);
+  // Never let the estimate reach 0 as that is used to indicate the fixed
+  // policy.
+  worker->idle_estimate_ns = iree_max(estimate_ns, 1);
+}
+
+// Waits for new work to be posted to the worker.
+// The wait was prepared with |wait_token| and will be committed or cancelled.
+// If spinning is enabled the worker first spins for a (possibly adaptive)
+// duration so that work arriving shortly after the worker ran out avoids the
+// latency of parking and waking the thread.
+static void iree_task_worker_wait_for_work(iree_task_worker_t* worker,
+                                           iree_wait_token_t wait_token) {
+  iree_time_t idle_start_ns = 0;
+  if (worker->spin_ns > 0) {
+    idle_start_ns = iree_time_now();
+    iree_duration_t spin_ns = iree_task_worker_select_spin_duration(worker);
+    bool did_notify = false;
+    if (spin_ns > 0) {
+      IREE_TRACE_ZONE_BEGIN_NAMED(z_spin,
+                                  "iree_task_worker_main_pump_spin_wait");
+      did_notify = iree_notification_spin_wait(
+          &worker->wake_notification, wait_token, idle_start_ns + spin_ns);
+      IREE_TRACE_ZONE_END(z_spin);
+    }
+    if (did_notify) {
+      iree_notification_cancel_wait(&worker->wake_notification);
+      iree_task_worker_update_idle_estimate(worker,
+                                            iree_time_now() - idle_start_ns);
+      return;
+    }
+  }
+
+  IREE_TRACE_ZONE_BEGIN_NAMED(z_wait, "iree_task_worker_main_pump_wake_wait");
+  iree_time_t park_start_ns = IREE_TASK_WORKER_TIME_NOW();
+  iree_notification_commit_wait(&worker->wake_notification, wait_token,
+                                IREE_TIME_INFINITE_FUTURE);
+  IREE_TASK_WORKER_COUNT(worker, parked_ns,
+                         IREE_TASK_WORKER_TIME_NOW() - park_start_ns);
+  IREE_TRACE_ZONE_END(z_wait);
+
+  if (worker->spin_ns > 0) {
+    iree_task_worker_update_idle_estimate(worker,
+                                          iree_time_now() - idle_start_ns);
+  }
+}
+
+// Marks the worker as busy in the executor idle mask.
+static void iree_task_worker_mark_busy(iree_task_worker_t* worker) {
+  iree_atomic_task_worker_set_fetch_and(&worker->executor->worker_idle_mask,
+                                        worker->cluster_index,
+                                        ~worker->worker_bit,
+                                        iree_memory_order_seq_cst);
+}
+
+// Pumps all ready tasks in the worker queue, marks the worker idle, and then
+// self-nominates as coordinator to distribute any newly ready work.
+// Returns true if more work is available to the worker and it should pump
+// again instead of waiting.
+static bool iree_task_worker_pump_until_idle(iree_task_worker_t* worker) {
+  iree_task_submission_t pending_submission;
+  iree_task_submission_initialize(&pending_submission);
+
+  while (iree_task_worker_pump_once(worker, &pending_submission)) {
+    // All work done ^, which will return false when the worker should wait.
+  }
+
+  // Now that we aren't executing anything we can release local memory if
+  // the executor was trimmed.
+  iree_task_worker_trim_local_memory_if_requested(worker);
+
+  bool schedule_dirty = false;
+  if (!iree_task_submission_is_empty(&pending_submission)) {
+    iree_task_executor_merge_submission(worker->executor, &pending_submission);
+    schedule_dirty = true;
+  }
+
+  // We've finished all the work we have scheduled so set our idle flag.
+  // This ensures that if any other thread comes in and wants to give us
+  // work we will properly coordinate/wake below.
+  iree_atomic_task_worker_set_fetch_or(&worker->executor->worker_idle_mask,
+                                       worker->cluster_index,
+                                       worker->worker_bit,
+                                       iree_memory_order_seq_cst);
+
+  // When we encounter a complete lack of work we can self-nominate to check
+  // the global work queue and distribute work to other threads. Only one
+  // coordinator can be running at a time so we also ensure that if another
+  // is doing its work we gracefully wait for it. It's fine to block in here
+  // as the next thing we'd have done is go idle anyway.
+
+  // First self-nominate; this *may* do something or just be ignored (if
+  // another worker is already coordinating).
+  iree_task_executor_coordinate(worker->executor, worker);
+
+  // If nothing has been enqueued since we started (so even coordination didn't
+  // find anything) we can go idle.
+  return schedule_dirty ||
+         !iree_task_queue_is_empty(&worker->priority_task_queue) ||
+         !iree_task_queue_is_empty(&worker->local_task_queue);
+}
+
 // Alternates between pumping ready tasks in the worker queue and waiting
 // for more tasks to arrive. Only returns when the worker has been asked by
 // the executor to exit.
@@ -264,9 +621,7 @@ static void iree_task_worker_pump_until_exit(iree_task_worker_t* worker) {
     // structures we use.
     iree_wait_token_t wait_token =
         iree_notification_prepare_wait(&worker->wake_notification);
-    iree_atomic_task_affinity_set_fetch_and(&worker->executor->worker_idle_mask,
-                                            ~worker->worker_bit,
-                                            iree_memory_order_seq_cst);
+    iree_task_worker_mark_busy(worker);
 
     // Check state to see if we've been asked to exit.
     if (iree_atomic_load_int32(&worker->state, iree_memory_order_seq_cst) ==
@@ -277,50 +632,11 @@ static void iree_task_worker_pump_until_exit(iree_task_worker_t* worker) {
       break;
     }
 
-    iree_task_submission_t pending_submission;
-    iree_task_submission_initialize(&pending_submission);
-
-    while (iree_task_worker_pump_once(worker, &pending_submission)) {
-      // All work done ^, which will return false when the worker should wait.
-    }
-
-    bool schedule_dirty = false;
-    if (!iree_task_submission_is_empty(&pending_submission)) {
-      iree_task_executor_merge_submission(worker->executor,
-                                          &pending_submission);
-      schedule_dirty = true;
-    }
-
-    // We've finished all the work we have scheduled so set our idle flag.
-    // This ensures that if any other thread comes in and wants to give us
-    // work we will properly coordinate/wake below.
-    iree_atomic_task_affinity_set_fetch_or(&worker->executor->worker_idle_mask,
-                                           worker->worker_bit,
-                                           iree_memory_order_seq_cst);
-
-    // When we encounter a complete lack of work we can self-nominate to check
-    // the global work queue and distribute work to other threads. Only one
-    // coordinator can be running at a time so we also ensure that if another
-    // is doing its work we gracefully wait for it. It's fine to block in here
-    // as the next thing we'd have done is go idle anyway.
-
-    // First self-nominate; this *may* do something or just be ignored (if
-    // another worker is already coordinating).
-    iree_task_executor_coordinate(worker->executor, worker);
-
-    // If nothing has been enqueued since we started this loop (so even
-    // coordination didn't find anything) we go idle. Otherwise we fall
-    // through and try the loop again.
-    if (schedule_dirty ||
-        !iree_task_queue_is_empty(&worker->local_task_queue)) {
+    if (iree_task_worker_pump_until_idle(worker)) {
       // Have more work to do; loop around to try another pump.
       iree_notification_cancel_wait(&worker->wake_notification);
     } else {
-      IREE_TRACE_ZONE_BEGIN_NAMED(z_wait,
-                                  "iree_task_worker_main_pump_wake_wait");
-      iree_notification_commit_wait(&worker->wake_notification, wait_token,
-                                    IREE_TIME_INFINITE_FUTURE);
-      IREE_TRACE_ZONE_END(z_wait);
+      iree_task_worker_wait_for_work(worker, wait_token);
     }
 
     // Wait completed.
@@ -329,6 +645,34 @@ static void iree_task_worker_pump_until_exit(iree_task_worker_t* worker) {
   }
 }
 
+void iree_task_worker_run_external(iree_task_worker_t* worker) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // The host thread may have any FPU state; set what we need and restore the
+  // host state when we return.
+  iree_fpu_state_t fpu_state =
+      iree_fpu_state_push(IREE_FPU_STATE_FLAG_FLUSH_DENORMALS_TO_ZERO);
+
+  // Consume all wakes issued up to this point and keep running until no more
+  // arrive while we are processing work. Wakes issued after we have consumed
+  // the count will again issue the executor callback to have a host thread
+  // run us.
+  int32_t wake_count = iree_atomic_load_int32(&worker->external_wake_count,
+                                              iree_memory_order_acquire);
+  do {
+    do {
+      iree_task_worker_mark_busy(worker);
+    } while (iree_task_worker_pump_until_idle(worker));
+    wake_count = iree_atomic_fetch_sub_int32(&worker->external_wake_count,
+                                             wake_count,
+                                             iree_memory_order_acq_rel) -
+                 wake_count;
+  } while (wake_count > 0);
+
+  iree_fpu_state_pop(fpu_state);
+  IREE_TRACE_ZONE_END(z0);
+}
+
 // Thread entry point for each worker.
 static int iree_task_worker_main(iree_task_worker_t* worker) {
   IREE_TRACE_ZONE_BEGIN(thread_zone);
@@ -341,6 +685,19 @@ static int iree_task_worker_main(iree_task_worker_t* worker) {
   // TODO(benvanik): call this after waking in case CPU hotplugging happens.
   iree_thread_request_affinity(worker->thread, worker->ideal_thread_affinity);
 
+  // Allocate and touch the initial worker local memory from the worker thread
+  // now that we are (hopefully) running on the desired processor. With the
+  // default first-touch policy of most operating systems the pages end up on
+  // the NUMA node of the worker instead of the node of whichever thread created
+  // the executor. Failure is not fatal as the local memory will be grown on
+  // demand by any dispatch that requires it.
+  iree_status_t reserve_status = iree_task_worker_reserve_local_memory(
+      worker, worker->executor->worker_local_memory_size);
+  if (iree_status_is_ok(reserve_status) && worker->local_memory.data_length) {
+    memset(worker->local_memory.data, 0, worker->local_memory.data_length);
+  }
+  iree_status_ignore(reserve_status);
+
   // Enter the running state immediately. Note that we could have been requested
   // to exit while suspended/still starting up, so check that here before we
   // mess with any data structures.
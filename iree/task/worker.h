@@ -11,6 +11,7 @@
 #include <stdint.h>
 
 #include "iree/base/api.h"
+#include "iree/base/internal/arena.h"
 #include "iree/base/internal/prng.h"
 #include "iree/base/internal/synchronization.h"
 #include "iree/base/internal/threading.h"
@@ -50,6 +51,19 @@ typedef enum iree_task_worker_state_e {
   IREE_TASK_WORKER_STATE_ZOMBIE = 3,
 } iree_task_worker_state_t;
 
+#if IREE_STATISTICS_ENABLE
+// Scheduling counters of a worker; see iree_task_worker_statistics_t.
+// Only ever written by the worker thread and read by any thread.
+typedef struct iree_task_worker_counters_t {
+  iree_atomic_int64_t task_count;
+  iree_atomic_int64_t tile_count;
+  iree_atomic_int64_t steal_attempt_count;
+  iree_atomic_int64_t steal_success_count;
+  iree_atomic_int64_t executing_ns;
+  iree_atomic_int64_t parked_ns;
+} iree_task_worker_counters_t;
+#endif  // IREE_STATISTICS_ENABLE
+
 // A worker within the executor pool.
 //
 // NOTE: fields in here are touched from multiple threads with lock-free
@@ -66,6 +80,16 @@ typedef struct iree_task_worker_t {
   // LAYOUT: must be 64b away from local_task_queue.
   iree_atomic_task_slist_t mailbox_slist;
 
+  // A LIFO mailbox used by coordinators to post IREE_TASK_PRIORITY_HIGH tasks
+  // to this worker. Flushed into |priority_task_queue| and always drained
+  // before any normal priority work.
+  iree_atomic_task_slist_t priority_mailbox_slist;
+
+  // Non-zero when tasks may have been posted to |priority_mailbox_slist| since
+  // the worker last flushed it. Checked by normal priority dispatch shards at
+  // tile reservation boundaries to yield to the high priority work.
+  iree_atomic_int32_t priority_pending;
+
   // Current state of the worker (iree_task_worker_state_t).
   // LAYOUT: frequent access; next to wake_notification as they are always
   //         accessed together.
@@ -80,13 +104,23 @@ typedef struct iree_task_worker_t {
   // Notification signaled when the worker changes any state.
   iree_notification_t state_notification;
 
+  // Number of wakes issued to an external worker that have not yet been
+  // consumed by iree_task_worker_run_external. The executor wake callback is
+  // only issued when this transitions from 0 such that only a single host
+  // thread runs the worker at a time. Unused if the worker has a thread.
+  iree_atomic_int32_t external_wake_count;
+
   // Parent executor that can be used to access the global work queue or task
   // pool. Executors always outlive the workers they own.
   iree_task_executor_t* executor;
 
-  // Bit the worker represents in the various worker bitsets.
+  // Bit the worker represents in the various worker bitsets of its cluster.
   iree_task_affinity_set_t worker_bit;
 
+  // Index of the worker cluster the worker belongs to; |worker_bit| and the
+  // topology masks below are all relative to this cluster.
+  iree_host_size_t cluster_index;
+
   // Ideal thread affinity for the worker thread.
   iree_thread_affinity_t ideal_thread_affinity;
 
@@ -97,15 +131,33 @@ typedef struct iree_task_worker_t {
   // all share the same L3 cache.
   iree_task_affinity_set_t constructive_sharing_mask;
 
+  // A bitmask of other group indices that are attached to the same NUMA node as
+  // this worker. These are preferred theft victims after the constructive
+  // sharing set as their tasks (and the memory they touch) are node-local.
+  iree_task_affinity_set_t numa_node_mask;
+
   // Maximum number of attempts to make when trying to steal tasks from other
   // workers. This could be 64 (try stealing from all workers) or just a handful
   // (try stealing from these 3 other cores that share your L3 cache).
   uint32_t max_theft_attempts;
 
+  // Relative capacity of the core the worker is mapped to used to weight the
+  // dispatch tiles the worker reserves. IREE_TASK_TOPOLOGY_GROUP_CAPACITY_MAX
+  // unless IREE_TASK_SCHEDULING_MODE_WEIGHT_BY_CORE_CAPACITY is set.
+  uint32_t capacity;
+
   // Rotation counter for work stealing (ensures we don't favor one victim).
   // Only ever touched by the worker thread as it steals work.
   iree_prng_minilcg128_state_t theft_prng;
 
+  // Maximum duration the worker spins waiting for new work before parking.
+  iree_duration_t spin_ns;
+
+  // Running estimate of how long the worker waits for new work after running
+  // out, used to select the spin duration when adaptive spinning is enabled.
+  // 0 if adaptive spinning is disabled. Only ever touched by the worker thread.
+  iree_duration_t idle_estimate_ns;
+
   // Thread handle of the worker. If the thread has exited the handle will
   // remain valid so that the executor can query its state.
   iree_thread_t* thread;
@@ -122,16 +174,43 @@ typedef struct iree_task_worker_t {
   // interference) this is the only place padding should be added.
   // uint8_t _padding[8];
 
-  // Pointer to local memory available for use exclusively by the worker.
-  // The base address should be aligned to avoid false sharing with other
-  // workers.
+  // Block pool backing local_arena. Owned by the worker so that its blocks are
+  // only ever allocated and touched by the worker thread after it has applied
+  // its affinity and under a first-touch NUMA policy the pages are placed on
+  // the node the worker runs on.
+  iree_arena_block_pool_t local_block_pool;
+
+  // Arena holding the current local_memory allocation. Grown on demand when a
+  // dispatch requires more local memory than is available and otherwise
+  // retained at its high-water mark across dispatches and submissions until
+  // trimmed. Only ever touched by the worker thread.
+  iree_arena_allocator_t local_arena;
+
+  // Local memory available for use exclusively by the worker.
+  // The base address is aligned to
+  // IREE_TASK_EXECUTOR_WORKER_LOCAL_MEMORY_ALIGNMENT to avoid false sharing
+  // with other workers.
   iree_byte_span_t local_memory;
 
+  // Nonzero when the worker has been asked to release its local memory the next
+  // time it runs out of work. See iree_task_worker_request_trim.
+  iree_atomic_int32_t local_memory_trim_requested;
+
   // Worker-local FIFO queue containing the tasks that will be processed by the
   // worker. This queue supports work-stealing by other workers if they run out
   // of work of their own.
   // LAYOUT: must be 64b away from mailbox_slist.
   iree_task_queue_t local_task_queue;
+
+  // Worker-local FIFO queue containing IREE_TASK_PRIORITY_HIGH tasks. Always
+  // drained before |local_task_queue| and also supports work-stealing.
+  iree_task_queue_t priority_task_queue;
+
+#if IREE_STATISTICS_ENABLE
+  // Scheduling counters. Only touched by the worker thread outside of queries
+  // so they live next to the local queue the worker is already pounding on.
+  iree_task_worker_counters_t counters;
+#endif  // IREE_STATISTICS_ENABLE
 } iree_task_worker_t;
 static_assert(offsetof(iree_task_worker_t, mailbox_slist) +
                       sizeof(iree_atomic_task_slist_t) <
@@ -146,11 +225,13 @@ static_assert(offsetof(iree_task_worker_t, local_task_queue) >=
 // tasks. Where supported the worker will be created in a suspended state so
 // that we aren't creating a thundering herd on startup:
 // https://en.wikipedia.org/wiki/Thundering_herd_problem
+//
+// If the executor has external workers no thread is created and the worker
+// must instead be run by host threads with iree_task_worker_run_external.
 iree_status_t iree_task_worker_initialize(
     iree_task_executor_t* executor, iree_host_size_t worker_index,
     const iree_task_topology_group_t* topology_group,
-    iree_byte_span_t local_memory, iree_prng_splitmix64_state_t* seed_prng,
-    iree_task_worker_t* out_worker);
+    iree_prng_splitmix64_state_t* seed_prng, iree_task_worker_t* out_worker);
 
 // Deinitializes a worker that has successfully exited. The worker must be in
 // the IREE_TASK_WORKER_STATE_ZOMBIE state.
@@ -163,13 +244,50 @@ void iree_task_worker_deinitialize(iree_task_worker_t* worker);
 // May be called from any thread (including the worker thread).
 void iree_task_worker_request_exit(iree_task_worker_t* worker);
 
-// Posts a FIFO list of tasks to the worker mailbox. The target worker takes
-// ownership of the tasks and will be woken if it is currently idle.
+// Requests that the worker release its local memory back to the system the
+// next time it runs out of work. The local memory will be reallocated on demand
+// by the next dispatch that requires it.
+//
+// May be called from any thread (including the worker thread).
+void iree_task_worker_request_trim(iree_task_worker_t* worker);
+
+// Wakes the worker if it is idle so that it processes any posted tasks.
+// Threaded workers are notified while external workers have the executor wake
+// callback issued if they are not already running.
+//
+// May be called from any thread (including the worker thread).
+void iree_task_worker_wake(iree_task_worker_t* worker);
+
+// Runs an external worker on the calling thread until it has consumed all
+// issued wakes and runs out of work.
+//
+// Must only be called once per wake callback issued for the worker.
+void iree_task_worker_run_external(iree_task_worker_t* worker);
+
+// Returns the local queue of |worker| holding tasks of |priority|.
+static inline iree_task_queue_t* iree_task_worker_queue_for_priority(
+    iree_task_worker_t* worker, iree_task_priority_t priority) {
+  return priority == IREE_TASK_PRIORITY_HIGH ? &worker->priority_task_queue
+                                             : &worker->local_task_queue;
+}
+
+// Posts a FIFO list of tasks of |priority| to the worker mailbox. The target
+// worker takes ownership of the tasks and will be woken if it is currently
+// idle. High priority tasks preempt any normal priority dispatch the worker is
+// executing at its next tile reservation boundary.
 //
 // May be called from any thread (including the worker thread).
 void iree_task_worker_post_tasks(iree_task_worker_t* worker,
+                                 iree_task_priority_t priority,
                                  iree_task_list_t* list);
 
+// Queries the scheduling statistics of the worker since it was initialized.
+// All values are 0 if statistics are not enabled (IREE_STATISTICS_ENABLE).
+//
+// May be called from any thread (including the worker thread).
+void iree_task_worker_query_statistics(
+    iree_task_worker_t* worker, iree_task_worker_statistics_t* out_statistics);
+
 // Tries to steal up to |max_tasks| from the back of the queue.
 // Returns NULL if no tasks are available and otherwise up to |max_tasks| tasks
 // that were at the tail of the worker FIFO will be moved to the |target_queue|
@@ -78,6 +78,23 @@ void iree_benchmark_set_bytes_processed(iree_benchmark_state_t* state,
 void iree_benchmark_set_items_processed(iree_benchmark_state_t* state,
                                         int64_t items);
 
+enum iree_benchmark_counter_flag_bits_t {
+  IREE_BENCHMARK_COUNTER_FLAG_NONE = 0u,
+  // Divides the value by the elapsed time to report a per-second rate.
+  IREE_BENCHMARK_COUNTER_FLAG_RATE = 1u << 0,
+  // Divides the value by the iteration count to report a per-step average.
+  IREE_BENCHMARK_COUNTER_FLAG_AVERAGE_ITERATIONS = 1u << 1,
+};
+typedef uint32_t iree_benchmark_counter_flags_t;
+
+// Adds a user counter |name| with the given value that will be displayed
+// alongside the report line.
+//
+// REQUIRES: must only be called outside of the benchmark step loop.
+void iree_benchmark_set_counter(iree_benchmark_state_t* state,
+                                const char* name, double value,
+                                iree_benchmark_counter_flags_t flags);
+
 //===----------------------------------------------------------------------===//
 // iree_benchmark_def_t
 //===----------------------------------------------------------------------===//
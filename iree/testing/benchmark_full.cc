@@ -69,6 +69,21 @@ void iree_benchmark_set_items_processed(iree_benchmark_state_t* state,
   s.SetItemsProcessed(items);
 }
 
+void iree_benchmark_set_counter(iree_benchmark_state_t* state,
+                                const char* name, double value,
+                                iree_benchmark_counter_flags_t flags) {
+  auto& s = GetBenchmarkState(state);
+  int counter_flags = benchmark::Counter::kDefaults;
+  if (flags & IREE_BENCHMARK_COUNTER_FLAG_RATE) {
+    counter_flags |= benchmark::Counter::kIsRate;
+  }
+  if (flags & IREE_BENCHMARK_COUNTER_FLAG_AVERAGE_ITERATIONS) {
+    counter_flags |= benchmark::Counter::kAvgIterations;
+  }
+  s.counters[name] = benchmark::Counter(
+      value, static_cast<benchmark::Counter::Flags>(counter_flags));
+}
+
 //===----------------------------------------------------------------------===//
 // iree_benchmark_def_t
 //===----------------------------------------------------------------------===//
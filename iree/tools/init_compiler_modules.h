@@ -8,6 +8,7 @@
 #define IREE_TOOLS_INIT_COMPILER_MODULES_H_
 
 #include "iree/compiler/Dialect/Modules/Check/IR/CheckDialect.h"
+#include "iree/compiler/Dialect/Modules/Parameters/IR/ParametersDialect.h"
 
 namespace mlir {
 namespace iree_compiler {
@@ -15,7 +16,8 @@ namespace iree_compiler {
 // Add all the IREE compiler module dialects to the provided registry.
 inline void registerIreeCompilerModuleDialects(DialectRegistry &registry) {
   // clang-format off
-  registry.insert<IREE::Check::CheckDialect>();
+  registry.insert<IREE::Check::CheckDialect,
+                  IREE::Parameters::ParametersDialect>();
   // clang-format on
 }
 
@@ -20,6 +20,7 @@
 #include "iree/compiler/ConstEval/Passes.h"
 #include "iree/compiler/Dialect/Flow/Transforms/Passes.h"
 #include "iree/compiler/Dialect/HAL/Transforms/Passes.h"
+#include "iree/compiler/Dialect/Modules/Parameters/Transforms/Passes.h"
 #include "iree/compiler/Dialect/Modules/VMVX/Transforms/Passes.h"
 #include "iree/compiler/Dialect/Stream/Transforms/Passes.h"
 #include "iree/compiler/Dialect/Util/Transforms/Passes.h"
@@ -49,6 +50,7 @@ inline void registerAllIreePasses() {
   IREE::Flow::registerFlowPasses();
   IREE::HAL::registerHALPasses();
   IREE::LinalgExt::registerPasses();
+  IREE::Parameters::registerParametersPasses();
   IREE::Stream::registerStreamPasses();
   IREE::Util::registerTransformPasses();
   IREE::VM::registerVMPasses();
@@ -4,10 +4,14 @@
 // See https://llvm.org/LICENSE.txt for license information.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
+#include <algorithm>
 #include <array>
+#include <cinttypes>
 #include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <iterator>
+#include <map>
 #include <string>
 #include <type_traits>
 #include <utility>
@@ -27,6 +31,11 @@
 #include "iree/vm/bytecode_module.h"
 #include "iree/vm/ref_cc.h"
 
+#if defined(IREE_HAVE_TASK_DRIVER)
+#include "iree/hal/local/task_device.h"
+#include "iree/task/executor.h"
+#endif  // IREE_HAVE_TASK_DRIVER
+
 IREE_FLAG(string, module_file, "-",
           "File containing the module to load that contains the entry "
           "function. Defaults to stdin.");
@@ -43,11 +52,28 @@ IREE_FLAG(string, entry_function, "",
           "to run. If this is not set, all the exported functions will be "
           "benchmarked and they are expected to not have input arguments.");
 
+IREE_FLAG(string, exported_benchmark_type, "",
+          "When benchmarking all exported functions only runs those whose "
+          "'benchmark' reflection attribute matches this value, such as "
+          "'entry' or 'dispatch' for functions created by "
+          "--iree-flow-export-benchmark-funcs.");
+
 IREE_FLAG(string, driver, "vmvx", "Backend driver to use.");
 
 IREE_FLAG(bool, print_statistics, false,
           "Prints runtime statistics to stderr on exit.");
 
+IREE_FLAG(int32_t, statistical_iterations, 0,
+          "When > 0 each function is invoked this many times after warmup and "
+          "wall time percentiles and a per-dispatch breakdown are printed to "
+          "stdout instead of running Google Benchmark.");
+IREE_FLAG(int32_t, statistical_warmup_iterations, 5,
+          "Number of untimed invocations performed before the timed "
+          "iterations of --statistical_iterations.");
+IREE_FLAG(string, statistical_format, "csv",
+          "Output format of --statistical_iterations results: 'csv' or "
+          "'json'.");
+
 static iree_status_t parse_function_input(iree_string_view_t flag_name,
                                           void* storage,
                                           iree_string_view_t value) {
@@ -76,6 +102,10 @@ IREE_FLAG_CALLBACK(
     "  2x2xi32=1 2 3 4\n"
     "Optionally, brackets may be used to separate the element values:\n"
     "  2x2xi32=[[1 2][3 4]]\n"
+    "Buffers may be loaded from binary NPY or safetensors files with:\n"
+    "  @path.npy\n"
+    "  @path.safetensors (all tensors ordered by name)\n"
+    "  @path.safetensors:name\n"
     "Each occurrence of the flag indicates an input in the order they were\n"
     "specified on the command line.");
 
@@ -130,6 +160,268 @@ void RegisterModuleBenchmarks(const std::string& function_name,
       ->Unit(benchmark::kMillisecond);
 }
 
+//===----------------------------------------------------------------------===//
+// Statistical benchmarking
+//===----------------------------------------------------------------------===//
+
+// A function benchmarked with --statistical_iterations.
+struct StatisticalFunction {
+  std::string name;
+  iree_vm_function_t function;
+  iree_vm_list_t* inputs;
+};
+
+// Aggregate timing of all invocations of a single dispatch.
+struct DispatchTiming {
+  std::string name;
+  uint64_t count = 0;
+  iree_duration_t total_ns = 0;
+  iree_duration_t min_ns = IREE_DURATION_INFINITE;
+  iree_duration_t max_ns = 0;
+};
+
+// Results of benchmarking a single function.
+struct StatisticalResult {
+  std::string name;
+  // Per-iteration durations.
+  std::vector<iree_duration_t> wall_ns;
+  std::vector<iree_duration_t> device_ns;
+  // Dispatches sorted by descending total time.
+  std::vector<DispatchTiming> dispatches;
+  uint64_t dropped_dispatch_count = 0;
+  bool profiled = false;
+};
+
+// Collects the dispatches reported by the device during one iteration.
+struct DispatchCollector {
+  std::vector<std::pair<iree_time_t, iree_time_t>> intervals;
+  std::map<std::string, DispatchTiming> timings;
+  uint64_t dropped_count = 0;
+
+  static iree_status_t Sink(
+      void* user_data, iree_host_size_t dispatch_count,
+      const iree_hal_device_profiling_dispatch_t* dispatches,
+      iree_host_size_t dropped_count) {
+    auto* collector = reinterpret_cast<DispatchCollector*>(user_data);
+    collector->dropped_count += dropped_count;
+    for (iree_host_size_t i = 0; i < dispatch_count; ++i) {
+      const auto& dispatch = dispatches[i];
+      collector->intervals.emplace_back(dispatch.begin_time_ns,
+                                        dispatch.end_time_ns);
+      std::string name =
+          iree_string_view_is_empty(dispatch.entry_point_name)
+              ? "entry_point_" + std::to_string(dispatch.entry_point)
+              : std::string(dispatch.entry_point_name.data,
+                            dispatch.entry_point_name.size);
+      auto& timing = collector->timings[name];
+      iree_duration_t duration_ns =
+          dispatch.end_time_ns - dispatch.begin_time_ns;
+      timing.name = name;
+      ++timing.count;
+      timing.total_ns += duration_ns;
+      timing.min_ns = std::min(timing.min_ns, duration_ns);
+      timing.max_ns = std::max(timing.max_ns, duration_ns);
+    }
+    return iree_ok_status();
+  }
+
+  // Returns the time at least one dispatch was executing since the last call
+  // and resets the intervals. Concurrent dispatches are only counted once.
+  iree_duration_t TakeBusyDuration() {
+    std::sort(intervals.begin(), intervals.end());
+    iree_duration_t busy_ns = 0;
+    iree_time_t end_ns = IREE_TIME_INFINITE_PAST;
+    for (const auto& interval : intervals) {
+      iree_time_t begin_ns = std::max(interval.first, end_ns);
+      if (interval.second > begin_ns) {
+        busy_ns += interval.second - begin_ns;
+        end_ns = interval.second;
+      }
+    }
+    intervals.clear();
+    return busy_ns;
+  }
+};
+
+// Returns the |percentile| of the sorted |values| using the nearest rank.
+static iree_duration_t Percentile(const std::vector<iree_duration_t>& values,
+                                  int percentile) {
+  if (values.empty()) return 0;
+  size_t rank = (percentile * values.size() + 99) / 100;
+  return values[std::max<size_t>(rank, 1) - 1];
+}
+
+static double ToMilliseconds(iree_duration_t duration_ns) {
+  return duration_ns / 1000000.0;
+}
+
+static iree_status_t RunStatisticalFunction(iree_hal_device_t* device,
+                                            iree_vm_context_t* context,
+                                            const StatisticalFunction& function,
+                                            StatisticalResult* out_result) {
+  IREE_TRACE_SCOPE_DYNAMIC(function.name.c_str());
+  out_result->name = function.name;
+
+  auto invoke = [&]() -> iree_status_t {
+    vm::ref<iree_vm_list_t> outputs;
+    IREE_RETURN_IF_ERROR(iree_vm_list_create(/*element_type=*/nullptr, 16,
+                                             iree_allocator_system(),
+                                             &outputs));
+    return iree_vm_invoke(context, function.function,
+                          IREE_VM_INVOCATION_FLAG_NONE, /*policy=*/nullptr,
+                          function.inputs, outputs.get(),
+                          iree_allocator_system());
+  };
+
+  for (int32_t i = 0; i < FLAG_statistical_warmup_iterations; ++i) {
+    IREE_RETURN_IF_ERROR(invoke());
+  }
+
+  // Devices that cannot profile still get wall time percentiles.
+  DispatchCollector collector;
+  iree_hal_device_profiling_options_t options;
+  memset(&options, 0, sizeof(options));
+  options.mode = IREE_HAL_DEVICE_PROFILING_MODE_DISPATCH_TIMESTAMPS;
+  options.sink.fn = DispatchCollector::Sink;
+  options.sink.user_data = &collector;
+  iree_status_t status = iree_hal_device_profiling_begin(device, &options);
+  if (iree_status_is_unimplemented(status)) {
+    iree_status_ignore(status);
+    status = iree_ok_status();
+  } else if (iree_status_is_ok(status)) {
+    out_result->profiled = true;
+  }
+
+  for (int32_t i = 0; i < FLAG_statistical_iterations; ++i) {
+    if (!iree_status_is_ok(status)) break;
+    iree_time_t start_ns = iree_time_now();
+    status = invoke();
+    out_result->wall_ns.push_back(iree_time_now() - start_ns);
+    if (iree_status_is_ok(status) && out_result->profiled) {
+      status = iree_hal_device_profiling_flush(device);
+      out_result->device_ns.push_back(collector.TakeBusyDuration());
+    }
+  }
+
+  if (out_result->profiled) {
+    status = iree_status_join(status, iree_hal_device_profiling_end(device));
+  }
+  IREE_RETURN_IF_ERROR(status);
+
+  for (auto& it : collector.timings) {
+    out_result->dispatches.push_back(std::move(it.second));
+  }
+  std::sort(out_result->dispatches.begin(), out_result->dispatches.end(),
+            [](const DispatchTiming& lhs, const DispatchTiming& rhs) {
+              return lhs.total_ns > rhs.total_ns;
+            });
+  out_result->dropped_dispatch_count = collector.dropped_count;
+  return iree_ok_status();
+}
+
+// Per-iteration host overhead: wall time not covered by device execution.
+static std::vector<iree_duration_t> HostOverhead(
+    const StatisticalResult& result) {
+  std::vector<iree_duration_t> host_ns;
+  for (size_t i = 0; i < result.device_ns.size(); ++i) {
+    host_ns.push_back(std::max<iree_duration_t>(
+        result.wall_ns[i] - result.device_ns[i], 0));
+  }
+  return host_ns;
+}
+
+static void PrintStatisticalResultsCSV(
+    const std::vector<StatisticalResult>& results) {
+  fprintf(stdout,
+          "function,iterations,wall_p50_ms,wall_p90_ms,wall_p99_ms,"
+          "device_p50_ms,device_p90_ms,device_p99_ms,host_p50_ms,host_p90_ms,"
+          "host_p99_ms,dropped_dispatches\n");
+  for (const auto& result : results) {
+    auto wall_ns = result.wall_ns;
+    auto device_ns = result.device_ns;
+    auto host_ns = HostOverhead(result);
+    std::sort(wall_ns.begin(), wall_ns.end());
+    std::sort(device_ns.begin(), device_ns.end());
+    std::sort(host_ns.begin(), host_ns.end());
+    fprintf(stdout, "%s,%zu", result.name.c_str(), wall_ns.size());
+    for (const auto* values : {&wall_ns, &device_ns, &host_ns}) {
+      for (int percentile : {50, 90, 99}) {
+        fprintf(stdout, ",%.6f",
+                ToMilliseconds(Percentile(*values, percentile)));
+      }
+    }
+    fprintf(stdout, ",%" PRIu64 "\n", result.dropped_dispatch_count);
+  }
+
+  fprintf(stdout,
+          "\nfunction,dispatch,count,total_ms,mean_ms,min_ms,max_ms,"
+          "percent_of_device\n");
+  for (const auto& result : results) {
+    iree_duration_t device_total_ns = 0;
+    for (const auto& dispatch : result.dispatches) {
+      device_total_ns += dispatch.total_ns;
+    }
+    for (const auto& dispatch : result.dispatches) {
+      fprintf(stdout, "%s,%s,%" PRIu64 ",%.6f,%.6f,%.6f,%.6f,%.2f\n",
+              result.name.c_str(), dispatch.name.c_str(), dispatch.count,
+              ToMilliseconds(dispatch.total_ns),
+              ToMilliseconds(dispatch.total_ns / (int64_t)dispatch.count),
+              ToMilliseconds(dispatch.min_ns), ToMilliseconds(dispatch.max_ns),
+              device_total_ns ? 100.0 * dispatch.total_ns / device_total_ns
+                              : 0.0);
+    }
+  }
+}
+
+static void PrintJSONPercentiles(const char* key,
+                                 std::vector<iree_duration_t> values) {
+  std::sort(values.begin(), values.end());
+  fprintf(stdout, "\"%s\": {\"p50\": %.6f, \"p90\": %.6f, \"p99\": %.6f}",
+          key, ToMilliseconds(Percentile(values, 50)),
+          ToMilliseconds(Percentile(values, 90)),
+          ToMilliseconds(Percentile(values, 99)));
+}
+
+static std::string EscapeJSON(const std::string& value) {
+  std::string escaped;
+  for (char c : value) {
+    if (c == '"' || c == '\\') escaped.push_back('\\');
+    escaped.push_back(c);
+  }
+  return escaped;
+}
+
+static void PrintStatisticalResultsJSON(
+    const std::vector<StatisticalResult>& results) {
+  fprintf(stdout, "{\"benchmarks\": [");
+  for (size_t i = 0; i < results.size(); ++i) {
+    const auto& result = results[i];
+    fprintf(stdout, "%s\n  {\"function\": \"%s\", \"iterations\": %zu, ",
+            i ? "," : "", EscapeJSON(result.name).c_str(),
+            result.wall_ns.size());
+    PrintJSONPercentiles("wall_time_ms", result.wall_ns);
+    if (result.profiled) {
+      fprintf(stdout, ", ");
+      PrintJSONPercentiles("device_time_ms", result.device_ns);
+      fprintf(stdout, ", ");
+      PrintJSONPercentiles("host_overhead_ms", HostOverhead(result));
+    }
+    fprintf(stdout, ", \"dropped_dispatches\": %" PRIu64 ", \"dispatches\": [",
+            result.dropped_dispatch_count);
+    for (size_t j = 0; j < result.dispatches.size(); ++j) {
+      const auto& dispatch = result.dispatches[j];
+      fprintf(stdout,
+              "%s\n    {\"name\": \"%s\", \"count\": %" PRIu64
+              ", \"total_ms\": %.6f, \"min_ms\": %.6f, \"max_ms\": %.6f}",
+              j ? "," : "", EscapeJSON(dispatch.name).c_str(), dispatch.count,
+              ToMilliseconds(dispatch.total_ns),
+              ToMilliseconds(dispatch.min_ns), ToMilliseconds(dispatch.max_ns));
+    }
+    fprintf(stdout, "]}");
+  }
+  fprintf(stdout, "\n]}\n");
+}
+
 iree_status_t GetModuleContentsFromFlags(std::string* out_contents) {
   IREE_TRACE_SCOPE0("GetModuleContentsFromFlags");
   auto module_file = std::string(FLAG_module_file);
@@ -163,6 +455,13 @@ class IREEBenchmark {
     if (FLAG_print_statistics) {
       IREE_IGNORE_ERROR(iree_hal_allocator_statistics_fprint(
           stderr, iree_hal_device_allocator(device_)));
+#if defined(IREE_HAVE_TASK_DRIVER)
+      iree_task_executor_t* executor = iree_hal_task_device_executor(device_);
+      if (executor) {
+        IREE_IGNORE_ERROR(
+            iree_task_executor_statistics_fprint(stderr, executor));
+      }
+#endif  // IREE_HAVE_TASK_DRIVER
     }
     iree_hal_device_release(device_);
     iree_vm_instance_release(instance_);
@@ -184,6 +483,30 @@ class IREEBenchmark {
     return iree_ok_status();
   }
 
+  // Runs all functions registered for statistical benchmarking and prints
+  // the results to stdout in the format selected by --statistical_format.
+  iree_status_t RunStatistical() {
+    IREE_TRACE_SCOPE0("IREEBenchmark::RunStatistical");
+    std::string format = FLAG_statistical_format;
+    if (format != "csv" && format != "json") {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "unsupported --statistical_format '%s'; expected "
+                              "'csv' or 'json'",
+                              format.c_str());
+    }
+    std::vector<StatisticalResult> results(statistical_functions_.size());
+    for (size_t i = 0; i < statistical_functions_.size(); ++i) {
+      IREE_RETURN_IF_ERROR(RunStatisticalFunction(
+          device_, context_, statistical_functions_[i], &results[i]));
+    }
+    if (format == "json") {
+      PrintStatisticalResultsJSON(results);
+    } else {
+      PrintStatisticalResultsCSV(results);
+    }
+    return iree_ok_status();
+  }
+
  private:
   iree_status_t Init() {
     IREE_TRACE_SCOPE0("IREEBenchmark::Init");
@@ -229,12 +552,14 @@ class IREEBenchmark {
         iree::span<const std::string>{FLAG_function_inputs.data(),
                                       FLAG_function_inputs.size()},
         &inputs_));
-    RegisterModuleBenchmarks(function_name, context_, function, inputs_.get());
+    RegisterFunction(function_name, function, inputs_.get());
     return iree_ok_status();
   }
 
   iree_status_t RegisterAllExportedFunctions() {
     IREE_TRACE_SCOPE0("IREEBenchmark::RegisterAllExportedFunctions");
+    iree_string_view_t required_type =
+        iree_make_cstring_view(FLAG_exported_benchmark_type);
     iree_vm_module_signature_t signature =
         input_module_->signature(input_module_->self);
     for (iree_host_size_t i = 0; i < signature.export_function_count; ++i) {
@@ -245,8 +570,13 @@ class IREEBenchmark {
 
       // We run anything with the 'benchmark' attribute.
       // If the attribute is not present we'll run anything that looks runnable.
-      bool known_benchmark = !iree_string_view_is_empty(
-          iree_vm_function_reflection_attr(&function, IREE_SV("benchmark")));
+      iree_string_view_t benchmark_type =
+          iree_vm_function_reflection_attr(&function, IREE_SV("benchmark"));
+      bool known_benchmark = !iree_string_view_is_empty(benchmark_type);
+      if (!iree_string_view_is_empty(required_type) &&
+          !iree_string_view_equal(benchmark_type, required_type)) {
+        continue;
+      }
       if (!known_benchmark) {
         if (iree_string_view_starts_with(function_name,
                                          iree_make_cstring_view("__")) ||
@@ -269,15 +599,25 @@ class IREEBenchmark {
         }
       }
 
-      iree::RegisterModuleBenchmarks(
-          std::string(function_name.data, function_name.size), context_,
-          function,
-          /*inputs=*/nullptr);
+      RegisterFunction(std::string(function_name.data, function_name.size),
+                       function, /*inputs=*/nullptr);
     }
     return iree_ok_status();
   }
 
+  // Registers |function| with Google Benchmark or for statistical benchmarking
+  // based on the flags.
+  void RegisterFunction(const std::string& function_name,
+                        iree_vm_function_t function, iree_vm_list_t* inputs) {
+    if (FLAG_statistical_iterations > 0) {
+      statistical_functions_.push_back({function_name, function, inputs});
+    } else {
+      RegisterModuleBenchmarks(function_name, context_, function, inputs);
+    }
+  }
+
   std::string module_data_;
+  std::vector<StatisticalFunction> statistical_functions_;
   iree_vm_instance_t* instance_ = nullptr;
   iree_hal_device_t* device_ = nullptr;
   iree_vm_module_t* hal_module_ = nullptr;
@@ -302,11 +642,15 @@ int main(int argc, char** argv) {
 
   iree::IREEBenchmark iree_benchmark;
   iree_status_t status = iree_benchmark.Register();
+  if (iree_status_is_ok(status) && FLAG_statistical_iterations > 0) {
+    status = iree_benchmark.RunStatistical();
+  } else if (iree_status_is_ok(status)) {
+    ::benchmark::RunSpecifiedBenchmarks();
+  }
   if (!iree_status_is_ok(status)) {
     int ret = static_cast<int>(iree_status_code(status));
     std::cout << iree::Status(std::move(status)) << std::endl;
     return ret;
   }
-  ::benchmark::RunSpecifiedBenchmarks();
   return 0;
 }
@@ -0,0 +1,341 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// Measures the throughput and tail latency of a function invoked concurrently
+// by multiple clients sharing a single device.
+//
+// Each client runs on its own thread with its own VM context over the shared
+// device, mirroring a server handling independent requests. Clients either
+// issue requests back-to-back (closed loop) or on a Poisson arrival schedule
+// (open loop) where latency includes any time spent waiting behind prior
+// requests of the same client. The benchmark is repeated for each client
+// count in --client_counts so that contention in the executor and device
+// queues shows up as throughput flattening and tail latency growing with the
+// number of clients.
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "iree/base/api.h"
+#include "iree/base/internal/flags.h"
+#include "iree/base/status_cc.h"
+#include "iree/base/tracing.h"
+#include "iree/hal/api.h"
+#include "iree/hal/drivers/init.h"
+#include "iree/modules/hal/module.h"
+#include "iree/tools/utils/vm_util.h"
+#include "iree/vm/api.h"
+#include "iree/vm/bytecode_module.h"
+#include "iree/vm/ref_cc.h"
+
+IREE_FLAG(string, module_file, "-",
+          "File containing the module to load that contains the entry "
+          "function. Defaults to stdin.");
+
+IREE_FLAG(string, entry_function, "",
+          "Name of a function contained in the module specified by module_file "
+          "to run.");
+
+IREE_FLAG(string, driver, "dylib", "Backend driver to use.");
+
+IREE_FLAG(string, client_counts, "1,2,4,8",
+          "Comma-separated list of concurrent client counts to benchmark.");
+
+IREE_FLAG(int32_t, requests_per_client, 100,
+          "Number of timed requests issued by each client.");
+
+IREE_FLAG(int32_t, warmup_requests, 5,
+          "Number of untimed requests issued by each client before timing.");
+
+IREE_FLAG(double, arrival_rate, 0.0,
+          "Mean requests per second issued by each client on a Poisson "
+          "arrival schedule. 0 issues requests back-to-back.");
+
+static iree_status_t parse_function_input(iree_string_view_t flag_name,
+                                          void* storage,
+                                          iree_string_view_t value) {
+  auto* list = (std::vector<std::string>*)storage;
+  list->push_back(std::string(value.data, value.size));
+  return iree_ok_status();
+}
+static void print_function_input(iree_string_view_t flag_name, void* storage,
+                                 FILE* file) {
+  auto* list = (std::vector<std::string>*)storage;
+  if (list->empty()) {
+    fprintf(file, "# --%.*s=\n", (int)flag_name.size, flag_name.data);
+  } else {
+    for (size_t i = 0; i < list->size(); ++i) {
+      fprintf(file, "--%.*s=\"%s\"\n", (int)flag_name.size, flag_name.data,
+              list->at(i).c_str());
+    }
+  }
+}
+static std::vector<std::string> FLAG_function_inputs;
+IREE_FLAG_CALLBACK(
+    parse_function_input, print_function_input, &FLAG_function_inputs,
+    function_input,
+    "An input value or buffer of the format:\n"
+    "  [shape]xtype=[value]\n"
+    "  2x2xi32=1 2 3 4\n"
+    "Buffers may be loaded from binary NPY or safetensors files with:\n"
+    "  @path.npy\n"
+    "  @path.safetensors (all tensors ordered by name)\n"
+    "  @path.safetensors:name\n"
+    "Each occurrence of the flag indicates an input in the order they were\n"
+    "specified on the command line. Each client parses its own copy.");
+
+namespace iree {
+namespace {
+
+// Resources shared by all clients.
+struct SharedState {
+  std::string module_data;
+  iree_vm_instance_t* instance = nullptr;
+  iree_hal_device_t* device = nullptr;
+  iree_vm_module_t* hal_module = nullptr;
+  iree_vm_module_t* input_module = nullptr;
+
+  ~SharedState() {
+    iree_vm_module_release(input_module);
+    iree_vm_module_release(hal_module);
+    iree_hal_device_release(device);
+    iree_vm_instance_release(instance);
+  }
+};
+
+// A single client issuing requests from its own thread and context.
+struct Client {
+  iree_vm_context_t* context = nullptr;
+  iree_vm_function_t function;
+  vm::ref<iree_vm_list_t> inputs;
+  uint32_t seed = 0;
+
+  // Outputs of the run.
+  std::vector<iree_duration_t> latencies_ns;
+  iree_status_t status = iree_ok_status();
+
+  ~Client() {
+    iree_status_ignore(status);
+    inputs.reset();
+    iree_vm_context_release(context);
+  }
+};
+
+static iree_status_t LoadSharedState(SharedState* state) {
+  IREE_TRACE_SCOPE0("LoadSharedState");
+  std::string module_file = FLAG_module_file;
+  if (module_file == "-") {
+    state->module_data = std::string{std::istreambuf_iterator<char>(std::cin),
+                                     std::istreambuf_iterator<char>()};
+  } else {
+    IREE_RETURN_IF_ERROR(
+        GetFileContents(module_file.c_str(), &state->module_data));
+  }
+  IREE_RETURN_IF_ERROR(iree_hal_module_register_types());
+  IREE_RETURN_IF_ERROR(
+      iree_vm_instance_create(iree_allocator_system(), &state->instance));
+  IREE_RETURN_IF_ERROR(CreateDevice(FLAG_driver, &state->device));
+  IREE_RETURN_IF_ERROR(iree_hal_module_create(
+      state->device, iree_allocator_system(), &state->hal_module));
+  return iree_vm_bytecode_module_create(
+      iree_make_const_byte_span((void*)state->module_data.data(),
+                                state->module_data.size()),
+      iree_allocator_null(), iree_allocator_system(), &state->input_module);
+}
+
+static iree_status_t InitializeClient(const SharedState& state,
+                                      iree_host_size_t client_index,
+                                      Client* client) {
+  // Order matters. The input module will likely be dependent on the hal
+  // module.
+  iree_vm_module_t* modules[2] = {state.hal_module, state.input_module};
+  IREE_RETURN_IF_ERROR(iree_vm_context_create_with_modules(
+      state.instance, IREE_VM_CONTEXT_FLAG_NONE, modules,
+      IREE_ARRAYSIZE(modules), iree_allocator_system(), &client->context));
+  std::string function_name = FLAG_entry_function;
+  IREE_RETURN_IF_ERROR(
+      state.input_module->lookup_function(
+          state.input_module->self, IREE_VM_FUNCTION_LINKAGE_EXPORT,
+          iree_string_view_t{function_name.data(), function_name.size()},
+          &client->function),
+      "looking up function '%s'", function_name.c_str());
+  IREE_RETURN_IF_ERROR(ParseToVariantList(
+      iree_hal_device_allocator(state.device),
+      iree::span<const std::string>{FLAG_function_inputs.data(),
+                                    FLAG_function_inputs.size()},
+      &client->inputs));
+  client->seed = (uint32_t)client_index;
+  return iree_ok_status();
+}
+
+static iree_status_t InvokeOnce(Client* client) {
+  vm::ref<iree_vm_list_t> outputs;
+  IREE_RETURN_IF_ERROR(iree_vm_list_create(/*element_type=*/nullptr, 16,
+                                           iree_allocator_system(), &outputs));
+  return iree_vm_invoke(client->context, client->function,
+                        IREE_VM_INVOCATION_FLAG_NONE, /*policy=*/nullptr,
+                        client->inputs.get(), outputs.get(),
+                        iree_allocator_system());
+}
+
+// Issues all requests of |client|; runs on the client thread.
+static iree_status_t RunClient(Client* client, iree_time_t start_time_ns) {
+  IREE_TRACE_SCOPE0("RunClient");
+  for (int32_t i = 0; i < FLAG_warmup_requests; ++i) {
+    IREE_RETURN_IF_ERROR(InvokeOnce(client));
+  }
+
+  // Wait for all clients to finish warming up so that they start together.
+  iree_wait_until(start_time_ns);
+
+  std::mt19937 rng(client->seed);
+  std::exponential_distribution<double> interarrival_s(
+      FLAG_arrival_rate > 0.0 ? FLAG_arrival_rate : 1.0);
+  iree_time_t arrival_time_ns = start_time_ns;
+  client->latencies_ns.reserve(FLAG_requests_per_client);
+  for (int32_t i = 0; i < FLAG_requests_per_client; ++i) {
+    if (FLAG_arrival_rate > 0.0) {
+      // Open loop: requests arrive on schedule regardless of how long prior
+      // requests took and latency is measured from the arrival time.
+      arrival_time_ns += (iree_duration_t)(interarrival_s(rng) * 1e9);
+      iree_wait_until(arrival_time_ns);
+    } else {
+      arrival_time_ns = iree_time_now();
+    }
+    IREE_RETURN_IF_ERROR(InvokeOnce(client));
+    client->latencies_ns.push_back(iree_time_now() - arrival_time_ns);
+  }
+  return iree_ok_status();
+}
+
+// Returns the |percentile| of the sorted |values| using the nearest rank.
+static iree_duration_t Percentile(const std::vector<iree_duration_t>& values,
+                                  int percentile) {
+  if (values.empty()) return 0;
+  size_t rank = (percentile * values.size() + 99) / 100;
+  return values[std::max<size_t>(rank, 1) - 1];
+}
+
+static double ToMilliseconds(iree_duration_t duration_ns) {
+  return duration_ns / 1000000.0;
+}
+
+// Runs the benchmark with |client_count| concurrent clients and prints a row
+// of results.
+static iree_status_t RunWithClientCount(const SharedState& state,
+                                        iree_host_size_t client_count) {
+  IREE_TRACE_SCOPE0("RunWithClientCount");
+  std::vector<Client> clients(client_count);
+  for (iree_host_size_t i = 0; i < client_count; ++i) {
+    IREE_RETURN_IF_ERROR(InitializeClient(state, i, &clients[i]));
+  }
+
+  // Give the clients time to warm up before the shared start time. Warmup is
+  // usually dominated by first-use costs (executable loading, allocator
+  // growth) and is bounded here only to keep the start synchronized.
+  iree_time_t start_time_ns = iree_time_now() + 500 * 1000000ll;
+  std::vector<std::thread> threads;
+  threads.reserve(client_count);
+  for (auto& client : clients) {
+    threads.emplace_back([&client, start_time_ns]() {
+      client.status = RunClient(&client, start_time_ns);
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  iree_time_t end_time_ns = iree_time_now();
+
+  std::vector<iree_duration_t> latencies_ns;
+  for (auto& client : clients) {
+    iree_status_t status = client.status;
+    client.status = iree_ok_status();
+    IREE_RETURN_IF_ERROR(status);
+    latencies_ns.insert(latencies_ns.end(), client.latencies_ns.begin(),
+                        client.latencies_ns.end());
+  }
+  std::sort(latencies_ns.begin(), latencies_ns.end());
+
+  // Warmup may overrun the start time; measure from whichever is later.
+  iree_duration_t elapsed_ns =
+      end_time_ns - std::min(start_time_ns, end_time_ns);
+  double throughput =
+      elapsed_ns ? latencies_ns.size() / (elapsed_ns / 1e9) : 0.0;
+  fprintf(stdout, "%zu,%zu,%.3f,%.6f,%.6f,%.6f,%.6f\n", client_count,
+          latencies_ns.size(), throughput,
+          ToMilliseconds(Percentile(latencies_ns, 50)),
+          ToMilliseconds(Percentile(latencies_ns, 90)),
+          ToMilliseconds(Percentile(latencies_ns, 99)),
+          ToMilliseconds(latencies_ns.empty() ? 0 : latencies_ns.back()));
+  fflush(stdout);
+  return iree_ok_status();
+}
+
+static iree_status_t ParseClientCounts(
+    std::vector<iree_host_size_t>* out_counts) {
+  iree_string_view_t remaining = iree_make_cstring_view(FLAG_client_counts);
+  while (!iree_string_view_is_empty(remaining)) {
+    iree_string_view_t value;
+    iree_string_view_split(remaining, ',', &value, &remaining);
+    value = iree_string_view_trim(value);
+    uint32_t count = 0;
+    if (!iree_string_view_atoi_uint32(value, &count) || count == 0) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "invalid client count '%.*s'", (int)value.size,
+                              value.data);
+    }
+    out_counts->push_back(count);
+  }
+  if (out_counts->empty()) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "at least one client count is required");
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t Run() {
+  IREE_TRACE_SCOPE0("Run");
+  if (iree_string_view_is_empty(iree_make_cstring_view(FLAG_entry_function))) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "no --entry_function= specified");
+  }
+  std::vector<iree_host_size_t> client_counts;
+  IREE_RETURN_IF_ERROR(ParseClientCounts(&client_counts));
+
+  SharedState state;
+  IREE_RETURN_IF_ERROR(LoadSharedState(&state));
+
+  fprintf(stdout,
+          "clients,requests,throughput_rps,latency_p50_ms,latency_p90_ms,"
+          "latency_p99_ms,latency_max_ms\n");
+  for (iree_host_size_t client_count : client_counts) {
+    IREE_RETURN_IF_ERROR(RunWithClientCount(state, client_count));
+  }
+  return iree_ok_status();
+}
+
+}  // namespace
+}  // namespace iree
+
+int main(int argc, char** argv) {
+  IREE_TRACE_SCOPE0("main");
+  iree_flags_parse_checked(IREE_FLAGS_PARSE_MODE_DEFAULT, &argc, &argv);
+  IREE_CHECK_OK(iree_hal_register_all_available_drivers(
+      iree_hal_driver_registry_default()));
+  iree_status_t status = iree::Run();
+  if (!iree_status_is_ok(status)) {
+    int ret = static_cast<int>(iree_status_code(status));
+    std::cout << iree::Status(std::move(status)) << std::endl;
+    return ret;
+  }
+  return 0;
+}
@@ -14,6 +14,8 @@
 #include "iree/base/api.h"
 #include "iree/base/internal/file_path.h"
 #include "iree/base/internal/flags.h"
+#include "iree/base/internal/math.h"
+#include "iree/base/internal/threading.h"
 #include "iree/hal/api.h"
 #include "iree/hal/drivers/init.h"
 #include "iree/testing/benchmark.h"
@@ -30,6 +32,91 @@ IREE_FLAG(int32_t, call_iterations, 1,
           "Number of times to invoke each call in the trace. May break usage "
           "with stateful models.");
 
+IREE_FLAG(int32_t, replay_concurrency, 1,
+          "Number of replays of each trace to run concurrently against a "
+          "single shared HAL device created from --driver. Each replay has its "
+          "own VM context and issues its calls from its own thread.");
+
+IREE_FLAG(bool, report_call_latencies, true,
+          "Reports the p50/p90/p99 latency of each call in the trace as "
+          "benchmark counters (`callN_p50_ms` etc).");
+
+//===----------------------------------------------------------------------===//
+// Call latency histograms
+//===----------------------------------------------------------------------===//
+
+// Each power of two of nanoseconds is split into this many buckets such that
+// reported percentiles are within 25% of the true value.
+#define IREE_REPLAY_LATENCY_SUB_BUCKET_BITS 2
+#define IREE_REPLAY_LATENCY_BUCKET_COUNT \
+  (64 << IREE_REPLAY_LATENCY_SUB_BUCKET_BITS)
+
+// Log-linear histogram of call latencies in nanoseconds.
+typedef struct iree_replay_latency_histogram_t {
+  uint64_t sample_count;
+  uint64_t bucket_counts[IREE_REPLAY_LATENCY_BUCKET_COUNT];
+} iree_replay_latency_histogram_t;
+
+static iree_host_size_t iree_replay_latency_bucket_index(uint64_t value) {
+  const uint64_t sub_bucket_count = 1ull << IREE_REPLAY_LATENCY_SUB_BUCKET_BITS;
+  // Small values are stored exactly.
+  if (value < sub_bucket_count) return (iree_host_size_t)value;
+  int msb = 63 - iree_math_count_leading_zeros_u64(value);
+  uint64_t sub_bucket = (value >> (msb - IREE_REPLAY_LATENCY_SUB_BUCKET_BITS)) &
+                        (sub_bucket_count - 1);
+  return ((iree_host_size_t)msb << IREE_REPLAY_LATENCY_SUB_BUCKET_BITS) +
+         (iree_host_size_t)sub_bucket;
+}
+
+// Returns the smallest value stored in the bucket at |bucket_index|.
+static uint64_t iree_replay_latency_bucket_lower_bound(
+    iree_host_size_t bucket_index) {
+  const uint64_t sub_bucket_count = 1ull << IREE_REPLAY_LATENCY_SUB_BUCKET_BITS;
+  if (bucket_index < sub_bucket_count) return bucket_index;
+  int msb = (int)(bucket_index >> IREE_REPLAY_LATENCY_SUB_BUCKET_BITS);
+  uint64_t sub_bucket = bucket_index & (sub_bucket_count - 1);
+  return (sub_bucket_count + sub_bucket)
+         << (msb - IREE_REPLAY_LATENCY_SUB_BUCKET_BITS);
+}
+
+static void iree_replay_latency_histogram_record(
+    iree_replay_latency_histogram_t* histogram, iree_duration_t latency_ns) {
+  uint64_t value = latency_ns > 0 ? (uint64_t)latency_ns : 0;
+  ++histogram->bucket_counts[iree_replay_latency_bucket_index(value)];
+  ++histogram->sample_count;
+}
+
+// Accumulates the samples of |source| into |target|.
+static void iree_replay_latency_histogram_merge(
+    const iree_replay_latency_histogram_t* source,
+    iree_replay_latency_histogram_t* target) {
+  for (iree_host_size_t i = 0; i < IREE_REPLAY_LATENCY_BUCKET_COUNT; ++i) {
+    target->bucket_counts[i] += source->bucket_counts[i];
+  }
+  target->sample_count += source->sample_count;
+}
+
+// Returns the approximate latency in nanoseconds at |percentile| (0-100),
+// reported as the lower bound of the bucket containing it.
+static uint64_t iree_replay_latency_histogram_percentile(
+    const iree_replay_latency_histogram_t* histogram, double percentile) {
+  if (!histogram->sample_count) return 0;
+  uint64_t rank =
+      (uint64_t)((percentile / 100.0) * (double)histogram->sample_count + 0.5);
+  if (rank < 1) rank = 1;
+  uint64_t seen_count = 0;
+  for (iree_host_size_t i = 0; i < IREE_REPLAY_LATENCY_BUCKET_COUNT; ++i) {
+    seen_count += histogram->bucket_counts[i];
+    if (seen_count >= rank) return iree_replay_latency_bucket_lower_bound(i);
+  }
+  return iree_replay_latency_bucket_lower_bound(
+      IREE_REPLAY_LATENCY_BUCKET_COUNT - 1);
+}
+
+//===----------------------------------------------------------------------===//
+// Trace benchmarks
+//===----------------------------------------------------------------------===//
+
 // A benchmark registration for each file to run.
 typedef struct iree_replay_benchmark_registration_t {
   iree_benchmark_def_t benchmark_def;  // Must be first.
@@ -47,6 +134,8 @@ typedef struct iree_replay_benchmark_call_t {
   iree_vm_function_t function;
   iree_vm_list_t* input_list;
   iree_vm_list_t* output_list;
+  // Latency of each invocation of the call.
+  iree_replay_latency_histogram_t* latencies;
 } iree_replay_benchmark_call_t;
 
 // A growable list of calls.
@@ -72,6 +161,7 @@ static void iree_replay_benchmark_call_list_deinitialize(
   for (size_t i = 0; i < list->count; ++i) {
     iree_vm_list_release(list->items[i].input_list);
     iree_vm_list_release(list->items[i].output_list);
+    free(list->items[i].latencies);
   }
   free(list->items);
   memset(list, 0, sizeof(*list));
@@ -112,6 +202,12 @@ static iree_status_t iree_replay_benchmark_prepare_call(
       iree_vm_list_create(/*element_type=*/NULL, /*initial_capacity=*/8,
                           replay->host_allocator, &call->output_list));
 
+  call->latencies = (iree_replay_latency_histogram_t*)calloc(
+      1, sizeof(*call->latencies));
+  if (!call->latencies) {
+    return iree_make_status(IREE_STATUS_RESOURCE_EXHAUSTED,
+                            "allocating latency histogram");
+  }
   return iree_ok_status();
 }
 
@@ -190,47 +286,194 @@ static iree_status_t iree_replay_benchmark_load_trace(
   return status;
 }
 
+// A single replay of a trace with its own VM context and calls.
+typedef struct iree_replay_benchmark_replay_t {
+  iree_trace_replay_t replay;
+  iree_replay_benchmark_call_list_t call_list;
+  // Result of the last iteration when run on a worker thread.
+  iree_status_t status;
+} iree_replay_benchmark_replay_t;
+
+// Initializes |out_replay| and loads the trace of |registration| into it.
+// When provided all HAL modules in the trace use |shared_device|.
+static iree_status_t iree_replay_benchmark_replay_initialize(
+    const iree_replay_benchmark_registration_t* registration,
+    iree_hal_device_t* shared_device,
+    iree_replay_benchmark_replay_t* out_replay) {
+  memset(out_replay, 0, sizeof(*out_replay));
+  IREE_RETURN_IF_ERROR(iree_trace_replay_initialize(
+      registration->root_path, registration->instance,
+      IREE_VM_CONTEXT_FLAG_NONE, iree_allocator_system(), &out_replay->replay));
+  iree_trace_replay_set_hal_driver_override(
+      &out_replay->replay, iree_make_cstring_view(FLAG_driver));
+  if (shared_device) {
+    iree_trace_replay_set_hal_device_override(&out_replay->replay,
+                                              shared_device);
+  }
+
+  // Load YAML file and setup replay state with all modules loaded and ready.
+  iree_replay_benchmark_call_list_initialize(&out_replay->call_list);
+  return iree_replay_benchmark_load_trace(
+      registration->file_path, &out_replay->replay, &out_replay->call_list);
+}
+
+static void iree_replay_benchmark_replay_deinitialize(
+    iree_replay_benchmark_replay_t* replay,
+    iree_trace_replay_shutdown_flags_t flags) {
+  iree_replay_benchmark_call_list_deinitialize(&replay->call_list);
+  iree_trace_replay_deinitialize(&replay->replay, flags);
+}
+
+// Calls the functions within the trace of |replay| in order.
+static iree_status_t iree_replay_benchmark_replay_run(
+    iree_replay_benchmark_replay_t* replay) {
+  for (size_t i = 0; i < replay->call_list.count; ++i) {
+    iree_replay_benchmark_call_t* call = &replay->call_list.items[i];
+    for (int32_t j = 0; j < FLAG_call_iterations; ++j) {
+      iree_time_t start_time_ns = iree_time_now();
+      IREE_RETURN_IF_ERROR(iree_vm_invoke(
+          replay->replay.context, call->function, IREE_VM_INVOCATION_FLAG_NONE,
+          /*policy=*/NULL, call->input_list, call->output_list,
+          replay->replay.host_allocator));
+      iree_replay_latency_histogram_record(call->latencies,
+                                           iree_time_now() - start_time_ns);
+      IREE_RETURN_IF_ERROR(iree_vm_list_resize(call->output_list, 0));
+    }
+  }
+  return iree_ok_status();
+}
+
+static int iree_replay_benchmark_replay_thread_main(void* entry_arg) {
+  iree_replay_benchmark_replay_t* replay =
+      (iree_replay_benchmark_replay_t*)entry_arg;
+  replay->status = iree_replay_benchmark_replay_run(replay);
+  return 0;
+}
+
+// Runs one iteration of each of the |replay_count| |replays|: the first on the
+// calling thread and the others on their own threads.
+static iree_status_t iree_replay_benchmark_run_concurrently(
+    iree_host_size_t replay_count, iree_replay_benchmark_replay_t* replays,
+    iree_thread_t** threads) {
+  iree_status_t status = iree_ok_status();
+  iree_host_size_t thread_count = 0;
+  for (iree_host_size_t i = 1; i < replay_count; ++i) {
+    iree_thread_create_params_t thread_params;
+    memset(&thread_params, 0, sizeof(thread_params));
+    thread_params.name = iree_make_cstring_view("iree-replay");
+    status = iree_thread_create(iree_replay_benchmark_replay_thread_main,
+                                &replays[i], thread_params,
+                                iree_allocator_system(), &threads[i]);
+    if (!iree_status_is_ok(status)) break;
+    ++thread_count;
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_replay_benchmark_replay_run(&replays[0]);
+  }
+  // Releasing the threads joins them.
+  for (iree_host_size_t i = 1; i <= thread_count; ++i) {
+    iree_thread_release(threads[i]);
+    threads[i] = NULL;
+    if (iree_status_is_ok(status)) {
+      status = replays[i].status;
+    } else {
+      iree_status_ignore(replays[i].status);
+    }
+    replays[i].status = iree_ok_status();
+  }
+  return status;
+}
+
+// Reports the latency percentiles of each call across all |replays| as
+// benchmark counters.
+static void iree_replay_benchmark_report_latencies(
+    iree_benchmark_state_t* benchmark_state, iree_host_size_t replay_count,
+    iree_replay_benchmark_replay_t* replays) {
+  iree_replay_latency_histogram_t* histogram =
+      (iree_replay_latency_histogram_t*)malloc(sizeof(*histogram));
+  if (!histogram) return;
+  for (size_t i = 0; i < replays[0].call_list.count; ++i) {
+    memset(histogram, 0, sizeof(*histogram));
+    for (iree_host_size_t j = 0; j < replay_count; ++j) {
+      iree_replay_latency_histogram_merge(
+          replays[j].call_list.items[i].latencies, histogram);
+    }
+    static const double kPercentiles[] = {50.0, 90.0, 99.0};
+    for (iree_host_size_t j = 0; j < IREE_ARRAYSIZE(kPercentiles); ++j) {
+      char name[64];
+      snprintf(name, sizeof(name), "call%zu_p%d_ms", i, (int)kPercentiles[j]);
+      iree_benchmark_set_counter(
+          benchmark_state, name,
+          iree_replay_latency_histogram_percentile(histogram,
+                                                   kPercentiles[j]) /
+              1e6,
+          IREE_BENCHMARK_COUNTER_FLAG_NONE);
+    }
+  }
+  free(histogram);
+}
+
 // Benchmark function that runs a trace file.
 static iree_status_t iree_replay_benchmark_run_file(
     const iree_benchmark_def_t* benchmark_def,
     iree_benchmark_state_t* benchmark_state) {
   const iree_replay_benchmark_registration_t* registration =
       (const iree_replay_benchmark_registration_t*)benchmark_def->user_data;
+  iree_host_size_t replay_count =
+      FLAG_replay_concurrency > 1 ? (iree_host_size_t)FLAG_replay_concurrency
+                                  : 1;
+
+  // Concurrent replays share a single device such that they contend for it as
+  // independent requests would.
+  iree_hal_device_t* shared_device = NULL;
+  if (replay_count > 1) {
+    iree_hal_driver_t* driver = NULL;
+    IREE_RETURN_IF_ERROR(iree_hal_driver_registry_try_create_by_name(
+        iree_hal_driver_registry_default(),
+        iree_make_cstring_view(FLAG_driver), iree_allocator_system(),
+        &driver));
+    iree_status_t status = iree_hal_driver_create_default_device(
+        driver, iree_allocator_system(), &shared_device);
+    iree_hal_driver_release(driver);
+    IREE_RETURN_IF_ERROR(status);
+  }
 
   // Setup replay state used for this benchmark.
-  iree_trace_replay_t replay;
-  IREE_RETURN_IF_ERROR(iree_trace_replay_initialize(
-      registration->root_path, registration->instance,
-      IREE_VM_CONTEXT_FLAG_NONE, iree_allocator_system(), &replay));
-  iree_trace_replay_set_hal_driver_override(
-      &replay, iree_make_cstring_view(FLAG_driver));
-
-  // Load YAML file and setup replay state with all modules loaded and ready.
-  iree_replay_benchmark_call_list_t call_list;
-  iree_replay_benchmark_call_list_initialize(&call_list);
-  IREE_RETURN_IF_ERROR(iree_replay_benchmark_load_trace(registration->file_path,
-                                                        &replay, &call_list));
+  iree_replay_benchmark_replay_t* replays =
+      (iree_replay_benchmark_replay_t*)calloc(replay_count, sizeof(*replays));
+  iree_thread_t** threads =
+      (iree_thread_t**)calloc(replay_count, sizeof(*threads));
+  for (iree_host_size_t i = 0; i < replay_count; ++i) {
+    IREE_RETURN_IF_ERROR(iree_replay_benchmark_replay_initialize(
+        registration, shared_device, &replays[i]));
+  }
+  iree_hal_device_release(shared_device);
 
   // Call the functions within the trace in order.
+  int64_t iteration_count = 0;
   while (iree_benchmark_keep_running(benchmark_state,
                                      /*batch_count=*/FLAG_call_iterations)) {
-    for (size_t i = 0; i < call_list.count; ++i) {
-      iree_replay_benchmark_call_t* call = &call_list.items[i];
-      for (int32_t j = 0; j < FLAG_call_iterations; ++j) {
-        IREE_RETURN_IF_ERROR(iree_vm_invoke(
-            replay.context, call->function, IREE_VM_INVOCATION_FLAG_NONE,
-            /*policy=*/NULL, call->input_list, call->output_list,
-            replay.host_allocator));
-        IREE_RETURN_IF_ERROR(iree_vm_list_resize(call->output_list, 0));
-      }
-    }
+    IREE_RETURN_IF_ERROR(
+        iree_replay_benchmark_run_concurrently(replay_count, replays, threads));
+    ++iteration_count;
+  }
+  // Items are complete replays of the trace across all concurrent replays.
+  iree_benchmark_set_items_processed(benchmark_state,
+                                     iteration_count * (int64_t)replay_count);
+  if (FLAG_report_call_latencies) {
+    iree_replay_benchmark_report_latencies(benchmark_state, replay_count,
+                                           replays);
   }
 
-  iree_replay_benchmark_call_list_deinitialize(&call_list);
-  iree_trace_replay_deinitialize(
-      &replay, FLAG_print_statistics
-                   ? IREE_TRACE_REPLAY_SHUTDOWN_PRINT_STATISTICS
-                   : IREE_TRACE_REPLAY_SHUTDOWN_QUIET);
+  // The device is shared so statistics are only printed once.
+  for (iree_host_size_t i = 0; i < replay_count; ++i) {
+    iree_replay_benchmark_replay_deinitialize(
+        &replays[i], FLAG_print_statistics && i == 0
+                         ? IREE_TRACE_REPLAY_SHUTDOWN_PRINT_STATISTICS
+                         : IREE_TRACE_REPLAY_SHUTDOWN_QUIET);
+  }
+  free(threads);
+  free(replays);
   return iree_ok_status();
 }
 
@@ -0,0 +1,311 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+// Benchmarks the matmuls in traces produced by generate_e2e_matmul_tests.py.
+//
+// This consumes the same traces as iree-e2e-matmul-test so that codegen
+// changes can be evaluated for performance on the exact shapes and types that
+// are checked for correctness. Each `call` event is run repeatedly and the
+// achieved GFLOP/s is reported per shape. Results are printed as a
+// human-readable table to stderr and a CSV table to stdout:
+//
+//   $ generate_e2e_matmul_tests.py --lhs_rhs_type=f32 --shapes=large \
+//       --output_code=matmul.mlir --output_trace=matmul.yaml
+//   $ iree-translate ... matmul.mlir -o matmul.vmfb
+//   $ iree-e2e-matmul-benchmark --driver=dylib --peak_gflops=150 matmul.yaml
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "iree/base/api.h"
+#include "iree/base/internal/file_path.h"
+#include "iree/base/internal/flags.h"
+#include "iree/hal/api.h"
+#include "iree/hal/drivers/init.h"
+#include "iree/modules/hal/module.h"
+#include "iree/tools/utils/trace_replay.h"
+#include "iree/tools/utils/yaml_util.h"
+#include "iree/vm/api.h"
+
+IREE_FLAG(bool, trace_execution, false, "Traces VM execution to stderr.");
+
+IREE_FLAG(string, driver, "vmvx", "Backend driver to use.");
+
+IREE_FLAG(int32_t, benchmark_warmup_iterations, 1,
+          "Number of untimed iterations run before timing each matmul.");
+
+IREE_FLAG(int32_t, benchmark_min_iterations, 10,
+          "Minimum number of timed iterations of each matmul.");
+
+IREE_FLAG(int32_t, benchmark_min_time_ms, 500,
+          "Minimum total time spent on the timed iterations of each matmul.");
+
+IREE_FLAG(double, peak_gflops, 0.0,
+          "Theoretical peak GFLOP/s of the device used to report the fraction "
+          "of peak achieved by each matmul. Omitted from the report if 0.");
+
+// Helper to get a list item as a buffer_view.
+static iree_status_t iree_get_buffer_view_list_item(
+    iree_vm_list_t* list, iree_host_size_t i,
+    iree_hal_buffer_view_t** out_value) {
+  iree_vm_variant_t variant = iree_vm_variant_empty();
+  IREE_RETURN_IF_ERROR(iree_vm_list_get_variant(list, i, &variant));
+  if (!iree_vm_variant_is_ref(variant)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "expected list item %zu to be a ref", i);
+  }
+  return iree_hal_buffer_view_check_deref(variant.ref, out_value);
+}
+
+// Obtains the {m,k,n}_size values of the matmul with |input_list| operands
+// (lhs, rhs, acc).
+static iree_status_t get_matmul_sizes(iree_vm_list_t* input_list,
+                                      iree_hal_dim_t* m_size,
+                                      iree_hal_dim_t* k_size,
+                                      iree_hal_dim_t* n_size) {
+  iree_hal_buffer_view_t* lhs = NULL;
+  iree_hal_buffer_view_t* rhs = NULL;
+  IREE_RETURN_IF_ERROR(iree_get_buffer_view_list_item(input_list, 0, &lhs));
+  IREE_RETURN_IF_ERROR(iree_get_buffer_view_list_item(input_list, 1, &rhs));
+  if (iree_hal_buffer_view_shape_rank(lhs) != 2 ||
+      iree_hal_buffer_view_shape_rank(rhs) != 2) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "expected matrix (2D tensor) operands");
+  }
+  *m_size = iree_hal_buffer_view_shape_dim(lhs, 0);
+  *k_size = iree_hal_buffer_view_shape_dim(lhs, 1);
+  *n_size = iree_hal_buffer_view_shape_dim(rhs, 1);
+  if (iree_hal_buffer_view_shape_dim(rhs, 0) != *k_size) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "mismatched matrix shapes in matmul: %dx%d * %dx%d",
+                            *m_size, *k_size,
+                            iree_hal_buffer_view_shape_dim(rhs, 0), *n_size);
+  }
+  return iree_ok_status();
+}
+
+// Invokes |function| with |input_list| and discards the results.
+static iree_status_t invoke_matmul(iree_trace_replay_t* replay,
+                                   iree_vm_function_t function,
+                                   iree_vm_list_t* input_list) {
+  iree_vm_list_t* output_list = NULL;
+  IREE_RETURN_IF_ERROR(iree_vm_list_create(/*element_type=*/NULL,
+                                           /*initial_capacity=*/8,
+                                           replay->host_allocator,
+                                           &output_list));
+  iree_status_t status = iree_vm_invoke(
+      replay->context, function, IREE_VM_INVOCATION_FLAG_NONE,
+      /*policy=*/NULL, input_list, output_list, replay->host_allocator);
+  iree_vm_list_release(output_list);
+  return status;
+}
+
+// Prints the table headers for the results printed by print_result.
+static void print_header(void) {
+  fprintf(stderr, "%-40s %-8s %-6s %6s %6s %6s %8s %12s %10s%s\n", "function",
+          "driver", "type", "m", "k", "n", "iters", "time(us)", "GFLOP/s",
+          FLAG_peak_gflops > 0.0 ? "   %peak" : "");
+  fprintf(stdout,
+          "function,driver,type,m,k,n,iterations,mean_time_us,gflops,"
+          "peak_fraction\n");
+}
+
+// Prints the result of benchmarking one matmul to both tables.
+static void print_result(iree_string_view_t function_name,
+                         const char* element_type, iree_hal_dim_t m_size,
+                         iree_hal_dim_t k_size, iree_hal_dim_t n_size,
+                         int64_t iterations, iree_duration_t total_ns) {
+  double mean_time_us = (double)total_ns / (double)iterations / 1e3;
+  double flops = 2.0 * (double)m_size * (double)k_size * (double)n_size;
+  double gflops = flops / (mean_time_us * 1e3);
+  double peak_fraction =
+      FLAG_peak_gflops > 0.0 ? gflops / FLAG_peak_gflops : 0.0;
+  fprintf(stderr, "%-40.*s %-8s %-6s %6d %6d %6d %8" PRIi64 " %12.2f %10.2f",
+          (int)function_name.size, function_name.data, FLAG_driver,
+          element_type, (int)m_size, (int)k_size, (int)n_size, iterations,
+          mean_time_us, gflops);
+  if (FLAG_peak_gflops > 0.0) {
+    fprintf(stderr, " %7.1f%%", peak_fraction * 100.0);
+  }
+  fprintf(stderr, "\n");
+  fprintf(stdout, "%.*s,%s,%s,%d,%d,%d,%" PRIi64 ",%.3f,%.3f,%.4f\n",
+          (int)function_name.size, function_name.data, FLAG_driver,
+          element_type, (int)m_size, (int)k_size, (int)n_size, iterations,
+          mean_time_us, gflops, peak_fraction);
+}
+
+// Special handler for function calls in a e2e matmul test trace.
+// Assumes that all calls are to functions that take 3 inputs (lhs, rhs, acc)
+// and return the result of a matmul (lhs*rhs+acc).
+static iree_status_t replay_event_call(iree_trace_replay_t* replay,
+                                       yaml_document_t* document,
+                                       yaml_node_t* event_node) {
+  yaml_node_t* function_node = NULL;
+  IREE_RETURN_IF_ERROR(iree_yaml_mapping_find(
+      document, event_node, iree_make_cstring_view("function"),
+      &function_node));
+  iree_string_view_t function_name = iree_yaml_node_as_string(function_node);
+
+  iree_vm_function_t function;
+  iree_vm_list_t* input_list = NULL;
+  IREE_RETURN_IF_ERROR(iree_trace_replay_event_call_prepare(
+      replay, document, event_node, &function, &input_list));
+
+  iree_hal_dim_t m_size = 0, k_size = 0, n_size = 0;
+  iree_status_t status =
+      get_matmul_sizes(input_list, &m_size, &k_size, &n_size);
+
+  char element_type[16] = {0};
+  if (iree_status_is_ok(status)) {
+    iree_hal_buffer_view_t* lhs = NULL;
+    status = iree_get_buffer_view_list_item(input_list, 0, &lhs);
+    iree_host_size_t element_type_length = 0;
+    if (iree_status_is_ok(status)) {
+      status = iree_hal_format_element_type(
+          iree_hal_buffer_view_element_type(lhs), sizeof(element_type) - 1,
+          element_type, &element_type_length);
+    }
+  }
+
+  // The same inputs are reused across iterations. Inputs the function mutates
+  // in place (such as the accumulator) change value but not the work done.
+  for (int32_t i = 0;
+       i < FLAG_benchmark_warmup_iterations && iree_status_is_ok(status); ++i) {
+    status = invoke_matmul(replay, function, input_list);
+  }
+
+  int64_t iterations = 0;
+  iree_duration_t min_time_ns =
+      (iree_duration_t)FLAG_benchmark_min_time_ms * 1000000ll;
+  iree_time_t start_ns = iree_time_now();
+  iree_time_t end_ns = start_ns;
+  while (iree_status_is_ok(status) &&
+         (iterations < FLAG_benchmark_min_iterations ||
+          end_ns - start_ns < min_time_ns)) {
+    status = invoke_matmul(replay, function, input_list);
+    end_ns = iree_time_now();
+    ++iterations;
+  }
+
+  if (iree_status_is_ok(status) && iterations > 0) {
+    print_result(function_name, element_type, m_size, k_size, n_size,
+                 iterations, end_ns - start_ns);
+  }
+
+  iree_vm_list_release(input_list);
+  return status;
+}
+
+static iree_status_t iree_e2e_matmul_benchmark_trace_replay_event(
+    iree_trace_replay_t* replay, yaml_document_t* document,
+    yaml_node_t* event_node) {
+  if (event_node->type != YAML_MAPPING_NODE) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "(%zu): expected mapping node",
+                            event_node->start_mark.line);
+  }
+  yaml_node_t* type_node = NULL;
+  IREE_RETURN_IF_ERROR(iree_yaml_mapping_find(
+      document, event_node, iree_make_cstring_view("type"), &type_node));
+  if (iree_yaml_string_equal(type_node, iree_make_cstring_view("call"))) {
+    return replay_event_call(replay, document, event_node);
+  } else {
+    return iree_trace_replay_event(replay, document, event_node);
+  }
+}
+
+// Runs the trace in |file| using |root_path| as the base for any path lookups
+// required for external files referenced in |file|.
+static iree_status_t run_trace_file(iree_string_view_t root_path, FILE* file,
+                                    iree_vm_instance_t* instance) {
+  iree_trace_replay_t replay;
+  IREE_RETURN_IF_ERROR(iree_trace_replay_initialize(
+      root_path, instance,
+      FLAG_trace_execution ? IREE_VM_CONTEXT_FLAG_TRACE_EXECUTION
+                           : IREE_VM_CONTEXT_FLAG_NONE,
+      iree_allocator_system(), &replay));
+  iree_trace_replay_set_hal_driver_override(
+      &replay, iree_make_cstring_view(FLAG_driver));
+
+  yaml_parser_t parser;
+  if (!yaml_parser_initialize(&parser)) {
+    iree_trace_replay_deinitialize(&replay, IREE_TRACE_REPLAY_SHUTDOWN_QUIET);
+    return iree_make_status(IREE_STATUS_INTERNAL,
+                            "yaml_parser_initialize failed");
+  }
+  yaml_parser_set_input_file(&parser, file);
+
+  iree_status_t status = iree_ok_status();
+  for (bool document_eof = false; !document_eof;) {
+    yaml_document_t document;
+    if (!yaml_parser_load(&parser, &document)) {
+      status = iree_status_from_yaml_parser_error(&parser);
+      break;
+    }
+    yaml_node_t* event_node = yaml_document_get_root_node(&document);
+    if (event_node) {
+      status = iree_e2e_matmul_benchmark_trace_replay_event(&replay, &document,
+                                                            event_node);
+    } else {
+      document_eof = true;
+    }
+    yaml_document_delete(&document);
+    if (!iree_status_is_ok(status)) break;
+  }
+
+  yaml_parser_delete(&parser);
+  iree_trace_replay_deinitialize(&replay, IREE_TRACE_REPLAY_SHUTDOWN_QUIET);
+  return status;
+}
+
+// Runs each of the given traces files sequentially in isolated contexts.
+static iree_status_t run_trace_files(int file_count, char** file_paths,
+                                     iree_vm_instance_t* instance) {
+  for (int i = 0; i < file_count; ++i) {
+    iree_string_view_t file_path = iree_make_cstring_view(file_paths[i]);
+    iree_string_view_t root_path = iree_file_path_dirname(file_path);
+    FILE* file = fopen(file_paths[i], "rb");
+    if (!file) {
+      return iree_make_status(iree_status_code_from_errno(errno),
+                              "failed to open trace file '%.*s'",
+                              (int)file_path.size, file_path.data);
+    }
+    iree_status_t status = run_trace_file(root_path, file, instance);
+    fclose(file);
+    IREE_RETURN_IF_ERROR(status, "replaying trace file '%.*s'",
+                         (int)file_path.size, file_path.data);
+  }
+  return iree_ok_status();
+}
+
+int main(int argc, char** argv) {
+  iree_flags_parse_checked(IREE_FLAGS_PARSE_MODE_DEFAULT, &argc, &argv);
+  if (argc <= 1) {
+    fprintf(stderr,
+            "no trace files provided; pass one or more yaml file paths");
+    return 1;
+  }
+
+  iree_vm_instance_t* instance = NULL;
+  iree_status_t status =
+      iree_vm_instance_create(iree_allocator_system(), &instance);
+  if (iree_status_is_ok(status)) {
+    IREE_CHECK_OK(iree_hal_register_all_available_drivers(
+        iree_hal_driver_registry_default()));
+    print_header();
+    status = run_trace_files(argc - 1, argv + 1, instance);
+  }
+  iree_vm_instance_release(instance);
+  if (!iree_status_is_ok(status)) {
+    iree_status_fprint(stderr, status);
+    iree_status_free(status);
+    return 1;
+  }
+  return 0;
+}
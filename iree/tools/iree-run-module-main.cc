@@ -4,10 +4,9 @@
 // See https://llvm.org/LICENSE.txt for license information.
 // SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
 
-#include <array>
 #include <cstdio>
+#include <cstring>
 #include <iostream>
-#include <iterator>
 #include <string>
 #include <utility>
 #include <vector>
@@ -20,6 +19,9 @@
 #include "iree/hal/api.h"
 #include "iree/hal/drivers/init.h"
 #include "iree/modules/hal/module.h"
+#include "iree/modules/parameters/file_provider.h"
+#include "iree/modules/parameters/module.h"
+#include "iree/tools/utils/allocation_timeline.h"
 #include "iree/tools/utils/vm_util.h"
 #include "iree/vm/api.h"
 #include "iree/vm/bytecode_module.h"
@@ -35,6 +37,16 @@ IREE_FLAG(string, entry_function, "",
 
 IREE_FLAG(bool, trace_execution, false, "Traces VM execution to stderr.");
 
+IREE_FLAG(string, sample_execution, "",
+          "Samples VM execution and writes the collapsed stacks to the given\n"
+          "file for use with flamegraph tools. Stack weights are the wall\n"
+          "time attributed to each stack in nanoseconds.");
+IREE_FLAG(int32_t, sample_interval_us, 100,
+          "Interval between VM execution samples in microseconds.");
+IREE_FLAG(bool, sample_source_locations, false,
+          "Includes source locations from the module debug database in the\n"
+          "sampled stacks.");
+
 IREE_FLAG(string, driver, "vmvx", "Backend driver to use.");
 
 IREE_FLAG(int32_t, print_max_element_count, 1024,
@@ -44,6 +56,75 @@ IREE_FLAG(int32_t, print_max_element_count, 1024,
 IREE_FLAG(bool, print_statistics, false,
           "Prints runtime statistics to stderr on exit.");
 
+IREE_FLAG(bool, print_allocation_timeline, false,
+          "Prints a timeline of HAL buffer allocations to stderr on exit\n"
+          "showing the peak memory of module loading and the invocation and\n"
+          "the allocations live at each peak.");
+IREE_FLAG(string, allocation_events_file, "",
+          "Writes all HAL buffer allocation events as CSV to the given file.");
+
+// Writes |builder| to the file at |path|.
+static iree_status_t WriteStringToFile(const char* path,
+                                       const iree_string_builder_t* builder) {
+  FILE* file = fopen(path, "wb");
+  if (!file) {
+    return iree_make_status(IREE_STATUS_PERMISSION_DENIED,
+                            "unable to open '%s' for writing", path);
+  }
+  iree_status_t status = iree_ok_status();
+  if (fwrite(iree_string_builder_buffer(builder), 1,
+             iree_string_builder_size(builder),
+             file) != iree_string_builder_size(builder)) {
+    status = iree_make_status(IREE_STATUS_DATA_LOSS, "failed to write '%s'",
+                              path);
+  }
+  fclose(file);
+  return status;
+}
+
+// Writes the samples recorded by |sampler| to --sample_execution.
+static iree_status_t WriteSamples(iree_vm_sampler_t* sampler) {
+  iree_string_builder_t builder;
+  iree_string_builder_initialize(iree_allocator_system(), &builder);
+  iree_status_t status = iree_vm_sampler_format_collapsed(
+      sampler,
+      FLAG_sample_source_locations
+          ? IREE_VM_SAMPLER_FORMAT_FLAG_SOURCE_LOCATIONS
+          : IREE_VM_SAMPLER_FORMAT_FLAG_NONE,
+      &builder);
+  if (iree_status_is_ok(status)) {
+    status = WriteStringToFile(FLAG_sample_execution, &builder);
+  }
+  iree_string_builder_deinitialize(&builder);
+  return status;
+}
+
+// Reports the allocations recorded by |timeline| as requested by the
+// --print_allocation_timeline and --allocation_events_file flags.
+static iree_status_t ReportAllocationTimeline(
+    iree_allocation_timeline_t* timeline) {
+  iree_string_builder_t builder;
+  iree_string_builder_initialize(iree_allocator_system(), &builder);
+  iree_status_t status = iree_ok_status();
+  if (FLAG_print_allocation_timeline) {
+    status = iree_allocation_timeline_format(timeline, &builder);
+    if (iree_status_is_ok(status)) {
+      fprintf(stderr, "%.*s", (int)iree_string_builder_size(&builder),
+              iree_string_builder_buffer(&builder));
+    }
+  }
+  if (iree_status_is_ok(status) && strlen(FLAG_allocation_events_file) > 0) {
+    iree_string_builder_deinitialize(&builder);
+    iree_string_builder_initialize(iree_allocator_system(), &builder);
+    status = iree_allocation_timeline_format_csv(timeline, &builder);
+    if (iree_status_is_ok(status)) {
+      status = WriteStringToFile(FLAG_allocation_events_file, &builder);
+    }
+  }
+  iree_string_builder_deinitialize(&builder);
+  return status;
+}
+
 static iree_status_t parse_function_input(iree_string_view_t flag_name,
                                           void* storage,
                                           iree_string_view_t value) {
@@ -72,27 +153,131 @@ IREE_FLAG_CALLBACK(
     "  2x2xi32=1 2 3 4\n"
     "Optionally, brackets may be used to separate the element values:\n"
     "  2x2xi32=[[1 2][3 4]]\n"
+    "Buffers may be loaded from binary NPY or safetensors files with:\n"
+    "  @path.npy\n"
+    "  @path.safetensors (all tensors ordered by name)\n"
+    "  @path.safetensors:name\n"
     "Each occurrence of the flag indicates an input in the order they were\n"
     "specified on the command line.");
 
+static std::vector<std::string> FLAG_function_outputs;
+IREE_FLAG_CALLBACK(
+    parse_function_input, print_function_input, &FLAG_function_outputs,
+    function_output,
+    "Where to output a result of the function, one occurrence per result in\n"
+    "order. Results are printed by default or with `-` and may be written to\n"
+    "a binary NPY file with:\n"
+    "  @path.npy");
+
+struct ParameterFlag {
+  std::string key;
+  std::string path;
+};
+static iree_status_t parse_parameter(iree_string_view_t flag_name,
+                                     void* storage, iree_string_view_t value) {
+  auto* list = (std::vector<ParameterFlag>*)storage;
+  iree_string_view_t key = iree_string_view_empty();
+  iree_string_view_t path = iree_string_view_empty();
+  if (iree_string_view_split(value, '=', &key, &path) == -1 ||
+      iree_string_view_is_empty(key) || iree_string_view_is_empty(path)) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "parameter '%.*s' not of the form key=path",
+                            (int)value.size, value.data);
+  }
+  list->push_back({std::string(key.data, key.size),
+                   std::string(path.data, path.size)});
+  return iree_ok_status();
+}
+static void print_parameter(iree_string_view_t flag_name, void* storage,
+                            FILE* file) {
+  auto* list = (std::vector<ParameterFlag>*)storage;
+  if (list->empty()) {
+    fprintf(file, "# --%.*s=\n", (int)flag_name.size, flag_name.data);
+  } else {
+    for (const auto& parameter : *list) {
+      fprintf(file, "--%.*s=\"%s=%s\"\n", (int)flag_name.size, flag_name.data,
+              parameter.key.c_str(), parameter.path.c_str());
+    }
+  }
+}
+static std::vector<ParameterFlag> FLAG_parameters;
+IREE_FLAG_CALLBACK(
+    parse_parameter, print_parameter, &FLAG_parameters, parameter,
+    "A named parameter served to the program from a file of the format:\n"
+    "  key=path\n"
+    "The whole file is used as the parameter contents and is memory-mapped on\n"
+    "first use. Each occurrence of the flag registers one parameter.\n"
+    "Modules compiled with --iree-opt-externalize-parameters load the\n"
+    "`<key>.bin` files written to\n"
+    "--iree-opt-externalize-parameters-directory.");
+
 namespace iree {
 namespace {
 
-iree_status_t GetModuleContentsFromFlags(std::string* out_contents) {
-  IREE_TRACE_SCOPE0("GetModuleContentsFromFlags");
+iree_status_t CreateModuleFromFlags(iree_vm_module_t** out_module) {
+  IREE_TRACE_SCOPE0("CreateModuleFromFlags");
   auto module_file = std::string(FLAG_module_file);
+  iree_const_byte_span_t module_data = iree_const_byte_span_empty();
+  iree_allocator_t module_data_allocator = iree_allocator_null();
   if (module_file == "-") {
-    *out_contents = std::string{std::istreambuf_iterator<char>(std::cin),
-                                std::istreambuf_iterator<char>()};
+    iree_byte_span_t stdin_data = iree_byte_span_empty();
+    IREE_RETURN_IF_ERROR(
+        iree_stdin_read_contents(iree_allocator_system(), &stdin_data));
+    module_data =
+        iree_make_const_byte_span(stdin_data.data, stdin_data.data_length);
+    module_data_allocator = iree_allocator_system();
   } else {
-    IREE_RETURN_IF_ERROR(GetFileContents(module_file.c_str(), out_contents));
+    // Map the file so that rodata is used in-place without copies.
+    IREE_RETURN_IF_ERROR(iree_file_map_contents(
+        module_file.c_str(), iree_allocator_system(), &module_data,
+        &module_data_allocator));
   }
-  return iree_ok_status();
+  iree_status_t status = iree_vm_bytecode_module_create(
+      module_data, module_data_allocator, iree_allocator_system(), out_module);
+  if (!iree_status_is_ok(status)) {
+    iree_allocator_free(module_data_allocator, (void*)module_data.data);
+  }
+  return status;
+}
+
+// Creates a parameters module serving the --parameter= flags.
+// Returns NULL if no parameters were specified.
+iree_status_t CreateParametersModuleFromFlags(iree_vm_module_t** out_module) {
+  *out_module = nullptr;
+  if (FLAG_parameters.empty()) return iree_ok_status();
+  IREE_TRACE_SCOPE0("CreateParametersModuleFromFlags");
+  iree_parameters_provider_t* provider = nullptr;
+  IREE_RETURN_IF_ERROR(
+      iree_parameters_file_provider_create(iree_allocator_system(), &provider));
+  iree_status_t status = iree_ok_status();
+  for (const auto& parameter : FLAG_parameters) {
+    status = iree_parameters_file_provider_add_entry(
+        provider,
+        iree_make_string_view(parameter.key.data(), parameter.key.size()),
+        iree_make_string_view(parameter.path.data(), parameter.path.size()),
+        /*file_offset=*/0, IREE_WHOLE_BUFFER);
+    if (!iree_status_is_ok(status)) break;
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_parameters_module_create(provider, iree_allocator_system(),
+                                           out_module);
+  }
+  iree_parameters_provider_release(provider);
+  return status;
 }
 
 iree_status_t Run() {
   IREE_TRACE_SCOPE0("iree-run-module");
 
+  iree_allocation_timeline_t* allocation_timeline = nullptr;
+  if (FLAG_print_allocation_timeline ||
+      strlen(FLAG_allocation_events_file) > 0) {
+    IREE_RETURN_IF_ERROR(iree_allocation_timeline_create(
+        iree_allocator_system(), &allocation_timeline));
+    IREE_RETURN_IF_ERROR(iree_allocation_timeline_begin_phase(
+        allocation_timeline, IREE_SV("load")));
+  }
+
   IREE_RETURN_IF_ERROR(iree_hal_module_register_types(),
                        "registering HAL types");
   iree_vm_instance_t* instance = nullptr;
@@ -100,12 +285,8 @@ iree_status_t Run() {
       iree_vm_instance_create(iree_allocator_system(), &instance),
       "creating instance");
 
-  std::string module_data;
-  IREE_RETURN_IF_ERROR(GetModuleContentsFromFlags(&module_data));
   iree_vm_module_t* input_module = nullptr;
-  IREE_RETURN_IF_ERROR(iree_vm_bytecode_module_create(
-      iree_make_const_byte_span((void*)module_data.data(), module_data.size()),
-      iree_allocator_null(), iree_allocator_system(), &input_module));
+  IREE_RETURN_IF_ERROR(CreateModuleFromFlags(&input_module));
 
   iree_hal_device_t* device = nullptr;
   IREE_RETURN_IF_ERROR(CreateDevice(FLAG_driver, &device));
@@ -113,9 +294,14 @@ iree_status_t Run() {
   IREE_RETURN_IF_ERROR(
       iree_hal_module_create(device, iree_allocator_system(), &hal_module));
 
+  iree_vm_module_t* parameters_module = nullptr;
+  IREE_RETURN_IF_ERROR(CreateParametersModuleFromFlags(&parameters_module));
+
   iree_vm_context_t* context = nullptr;
   // Order matters. The input module will likely be dependent on the hal module.
-  std::array<iree_vm_module_t*, 2> modules = {hal_module, input_module};
+  std::vector<iree_vm_module_t*> modules = {hal_module};
+  if (parameters_module) modules.push_back(parameters_module);
+  modules.push_back(input_module);
   IREE_RETURN_IF_ERROR(
       iree_vm_context_create_with_modules(
           instance,
@@ -124,6 +310,14 @@ iree_status_t Run() {
           modules.data(), modules.size(), iree_allocator_system(), &context),
       "creating context");
 
+  iree_vm_sampler_t* sampler = nullptr;
+  if (strlen(FLAG_sample_execution) > 0) {
+    IREE_RETURN_IF_ERROR(iree_vm_sampler_create(
+        (iree_duration_t)FLAG_sample_interval_us * 1000,
+        iree_allocator_system(), &sampler));
+    iree_vm_context_set_sampler(context, sampler);
+  }
+
   std::string function_name = std::string(FLAG_entry_function);
   iree_vm_function_t function;
   if (function_name.empty()) {
@@ -149,6 +343,13 @@ iree_status_t Run() {
   IREE_RETURN_IF_ERROR(iree_vm_list_create(/*element_type=*/nullptr, 16,
                                            iree_allocator_system(), &outputs));
 
+  if (allocation_timeline) {
+    std::string phase_name = "invoke @" + function_name;
+    IREE_RETURN_IF_ERROR(iree_allocation_timeline_begin_phase(
+        allocation_timeline,
+        iree_make_string_view(phase_name.data(), phase_name.size())));
+  }
+
   std::cout << "EXEC @" << function_name << "\n";
   IREE_RETURN_IF_ERROR(
       iree_vm_invoke(context, function, IREE_VM_INVOCATION_FLAG_NONE,
@@ -156,13 +357,29 @@ iree_status_t Run() {
                      iree_allocator_system()),
       "invoking function '%s'", function_name.c_str());
 
+  if (sampler) {
+    IREE_RETURN_IF_ERROR(WriteSamples(sampler), "writing execution samples");
+    iree_vm_context_set_sampler(context, nullptr);
+    iree_vm_sampler_release(sampler);
+  }
+
   IREE_RETURN_IF_ERROR(
-      PrintVariantList(outputs.get(), (size_t)FLAG_print_max_element_count),
-      "printing results");
+      OutputVariantList(outputs.get(),
+                        iree::span<const std::string>{
+                            FLAG_function_outputs.data(),
+                            FLAG_function_outputs.size()},
+                        (size_t)FLAG_print_max_element_count, &std::cout),
+      "outputting results");
+
+  if (allocation_timeline) {
+    IREE_RETURN_IF_ERROR(iree_allocation_timeline_begin_phase(
+        allocation_timeline, IREE_SV("unload")));
+  }
 
   inputs.reset();
   outputs.reset();
   iree_vm_module_release(hal_module);
+  iree_vm_module_release(parameters_module);
   iree_vm_module_release(input_module);
   iree_vm_context_release(context);
 
@@ -173,6 +390,12 @@ iree_status_t Run() {
 
   iree_hal_device_release(device);
   iree_vm_instance_release(instance);
+
+  if (allocation_timeline) {
+    IREE_RETURN_IF_ERROR(ReportAllocationTimeline(allocation_timeline),
+                         "reporting allocation timeline");
+    iree_allocation_timeline_destroy(allocation_timeline);
+  }
   return iree_ok_status();
 }
 
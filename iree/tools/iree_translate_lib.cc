@@ -6,11 +6,21 @@
 
 #include "iree/tools/iree_translate_lib.h"
 
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <string>
 #include <type_traits>
 
+#if defined(_WIN32)
+// clang-format off: windows.h must be included before psapi.h.
+#include <windows.h>
+#include <psapi.h>
+// clang-format on
+#else
+#include <sys/resource.h>
+#endif  // _WIN32
+
 #include "iree/compiler/Dialect/VM/Target/init_targets.h"
 #include "iree/tools/init_compiler_modules.h"
 #include "iree/tools/init_iree_dialects.h"
@@ -21,10 +31,12 @@
 #include "iree/tools/init_xla_dialects.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/InitLLVM.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/SMLoc.h"
 #include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/Timer.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Support/raw_ostream.h"
 #include "mlir/IR/AsmState.h"
@@ -40,6 +52,57 @@
 #include "mlir/Target/LLVMIR/Dialect/LLVMIR/LLVMToLLVMIRTranslation.h"
 #include "mlir/Translation.h"
 
+// Returns the peak resident set size of the process in bytes or 0 if it cannot
+// be queried on the host.
+static uint64_t getPeakResidentMemoryBytes() {
+#if defined(_WIN32)
+  PROCESS_MEMORY_COUNTERS counters;
+  if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+    return 0;
+  }
+  return static_cast<uint64_t>(counters.PeakWorkingSetSize);
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#if defined(__APPLE__)
+  // ru_maxrss is in bytes on Darwin.
+  return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+  // ru_maxrss is in kilobytes on Linux and the BSDs.
+  return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif  // __APPLE__
+#endif  // _WIN32
+}
+
+// Enables the MLIR pass timing instrumentation (-mlir-timing) on all pass
+// managers that apply the default timing command line options. The option
+// is owned by MLIR and only reachable through the registered option map.
+static void enablePassTiming() {
+  auto &options = llvm::cl::getRegisteredOptions();
+  auto it = options.find("mlir-timing");
+  if (it == options.end()) return;
+  auto *timingOption = static_cast<llvm::cl::opt<bool> *>(it->second);
+  *timingOption = true;
+}
+
+// Prints the compile-time summary to stderr. The key/value lines are kept
+// stable so that CI can scrape them for regression tracking.
+static void printCompileTimeReport(double wallTimeSeconds) {
+  auto &os = llvm::errs();
+  os << "===" << std::string(73, '-') << "===\n";
+  os << "                         IREE Compile-Time Report\n";
+  os << "===" << std::string(73, '-') << "===\n";
+  os << "  Total Wall Time: " << llvm::format("%.4f", wallTimeSeconds)
+     << " s\n";
+  uint64_t peakBytes = getPeakResidentMemoryBytes();
+  if (peakBytes) {
+    os << "  Peak Memory (RSS): "
+       << llvm::format("%.1f", peakBytes / (1024.0 * 1024.0)) << " MiB\n";
+  } else {
+    os << "  Peak Memory (RSS): unavailable\n";
+  }
+}
+
 int mlir::iree_compiler::runIreeTranslateMain(int argc, char **argv) {
   llvm::InitLLVM y(argc, argv);
   mlir::DialectRegistry registry;
@@ -83,6 +146,13 @@ int mlir::iree_compiler::runIreeTranslateMain(int argc, char **argv) {
                      "process each chunk independently"),
       llvm::cl::init(false));
 
+  llvm::cl::opt<bool> compileTimeReport(
+      "iree-compile-time-report",
+      llvm::cl::desc("Prints a compile-time report with the wall time of each "
+                     "pass (as with -mlir-timing), the total wall time, and "
+                     "the peak memory usage of the process to stderr"),
+      llvm::cl::init(false));
+
   // Add flags for all the registered translations.
   llvm::cl::opt<const mlir::TranslateFunction *, false, mlir::TranslationParser>
       translationRequested("", llvm::cl::desc("Translation to perform"),
@@ -90,6 +160,9 @@ int mlir::iree_compiler::runIreeTranslateMain(int argc, char **argv) {
 
   llvm::cl::ParseCommandLineOptions(argc, argv, "IREE translation driver\n");
 
+  if (compileTimeReport) enablePassTiming();
+  llvm::TimeRecord startTime = llvm::TimeRecord::getCurrentTime(/*Start=*/true);
+
   std::string errorMessage;
   auto input = mlir::openInputFile(inputFilename, &errorMessage);
   if (!input) {
@@ -132,6 +205,12 @@ int mlir::iree_compiler::runIreeTranslateMain(int argc, char **argv) {
     if (failed(processBuffer(std::move(input), output->os()))) return 1;
   }
 
+  if (compileTimeReport) {
+    llvm::TimeRecord endTime =
+        llvm::TimeRecord::getCurrentTime(/*Start=*/false);
+    printCompileTimeReport(endTime.getWallTime() - startTime.getWallTime());
+  }
+
   output->keep();
   return 0;
 }
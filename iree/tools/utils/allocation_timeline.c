@@ -0,0 +1,608 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/tools/utils/allocation_timeline.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "iree/base/internal/synchronization.h"
+#include "iree/base/tracing.h"
+
+// Width in characters of the bars used to render live bytes.
+#define IREE_ALLOCATION_TIMELINE_BAR_WIDTH 40
+
+//===----------------------------------------------------------------------===//
+// Storage
+//===----------------------------------------------------------------------===//
+
+// A recorded allocation event. Names are stored in the timeline name arena.
+typedef struct iree_allocation_timeline_event_t {
+  iree_hal_allocator_event_type_t type;
+  iree_host_size_t phase;
+  iree_time_t timestamp_ns;
+  const iree_hal_allocator_t* allocator;
+  const iree_hal_buffer_t* buffer;
+  iree_device_size_t allocation_size;
+  iree_hal_memory_type_t memory_type;
+  iree_hal_buffer_usage_t allowed_usage;
+  iree_host_size_t name_offset;
+  iree_host_size_t name_length;
+} iree_allocation_timeline_event_t;
+
+typedef struct iree_allocation_timeline_phase_t {
+  iree_host_size_t name_offset;
+  iree_host_size_t name_length;
+  iree_host_size_t first_event;
+  iree_time_t start_ns;
+} iree_allocation_timeline_phase_t;
+
+struct iree_allocation_timeline_t {
+  iree_allocator_t host_allocator;
+  iree_time_t creation_ns;
+
+  iree_slim_mutex_t mutex;
+  iree_host_size_t event_count;
+  iree_host_size_t event_capacity;
+  iree_allocation_timeline_event_t* events;
+  iree_host_size_t phase_count;
+  iree_host_size_t phase_capacity;
+  iree_allocation_timeline_phase_t* phases;
+  // Number of events that could not be recorded due to allocation failures.
+  iree_host_size_t dropped_count;
+  // Arena holding all event and phase names.
+  iree_string_builder_t names;
+};
+
+// Ensures |*inout_data| has room for at least |count| elements, doubling the
+// capacity as needed.
+static iree_status_t iree_allocation_timeline_reserve(
+    iree_allocator_t host_allocator, iree_host_size_t element_size,
+    iree_host_size_t count, iree_host_size_t* inout_capacity,
+    void** inout_data) {
+  if (IREE_LIKELY(count <= *inout_capacity)) return iree_ok_status();
+  iree_host_size_t new_capacity = iree_max(64, *inout_capacity * 2);
+  while (new_capacity < count) new_capacity *= 2;
+  IREE_RETURN_IF_ERROR(iree_allocator_realloc(
+      host_allocator, new_capacity * element_size, inout_data));
+  *inout_capacity = new_capacity;
+  return iree_ok_status();
+}
+
+// Stores |name| in the name arena and returns its location.
+static iree_status_t iree_allocation_timeline_store_name(
+    iree_allocation_timeline_t* timeline, iree_string_view_t name,
+    iree_host_size_t* out_offset, iree_host_size_t* out_length) {
+  *out_offset = iree_string_builder_size(&timeline->names);
+  *out_length = 0;
+  if (iree_string_view_is_empty(name)) return iree_ok_status();
+  IREE_RETURN_IF_ERROR(
+      iree_string_builder_append_string(&timeline->names, name));
+  *out_length = name.size;
+  return iree_ok_status();
+}
+
+static iree_string_view_t iree_allocation_timeline_name(
+    const iree_allocation_timeline_t* timeline, iree_host_size_t offset,
+    iree_host_size_t length) {
+  return iree_make_string_view(
+      iree_string_builder_buffer(&timeline->names) + offset, length);
+}
+
+// Appends a new phase; must be called with the lock held.
+static iree_status_t iree_allocation_timeline_append_phase(
+    iree_allocation_timeline_t* timeline, iree_string_view_t name) {
+  IREE_RETURN_IF_ERROR(iree_allocation_timeline_reserve(
+      timeline->host_allocator, sizeof(*timeline->phases),
+      timeline->phase_count + 1, &timeline->phase_capacity,
+      (void**)&timeline->phases));
+  iree_allocation_timeline_phase_t* phase =
+      &timeline->phases[timeline->phase_count];
+  IREE_RETURN_IF_ERROR(iree_allocation_timeline_store_name(
+      timeline, name, &phase->name_offset, &phase->name_length));
+  phase->first_event = timeline->event_count;
+  phase->start_ns = iree_time_now();
+  ++timeline->phase_count;
+  return iree_ok_status();
+}
+
+static void iree_allocation_timeline_on_event(
+    void* user_data, const iree_hal_allocator_event_t* event) {
+  iree_allocation_timeline_t* timeline =
+      (iree_allocation_timeline_t*)user_data;
+  iree_slim_mutex_lock(&timeline->mutex);
+  iree_status_t status = iree_allocation_timeline_reserve(
+      timeline->host_allocator, sizeof(*timeline->events),
+      timeline->event_count + 1, &timeline->event_capacity,
+      (void**)&timeline->events);
+  iree_allocation_timeline_event_t* record = NULL;
+  if (iree_status_is_ok(status)) {
+    record = &timeline->events[timeline->event_count];
+    status = iree_allocation_timeline_store_name(
+        timeline, event->name, &record->name_offset, &record->name_length);
+  }
+  if (iree_status_is_ok(status)) {
+    record->type = event->type;
+    record->phase = timeline->phase_count - 1;
+    record->timestamp_ns = event->timestamp_ns;
+    record->allocator = event->allocator;
+    record->buffer = event->buffer;
+    record->allocation_size = event->allocation_size;
+    record->memory_type = event->memory_type;
+    record->allowed_usage = event->allowed_usage;
+    ++timeline->event_count;
+  } else {
+    // Events are dropped instead of failing the allocation being reported.
+    iree_status_ignore(status);
+    ++timeline->dropped_count;
+  }
+  iree_slim_mutex_unlock(&timeline->mutex);
+}
+
+iree_status_t iree_allocation_timeline_create(
+    iree_allocator_t host_allocator,
+    iree_allocation_timeline_t** out_timeline) {
+  IREE_ASSERT_ARGUMENT(out_timeline);
+  *out_timeline = NULL;
+  if (iree_hal_allocator_has_event_listener()) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "an allocation event listener is already set");
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_allocation_timeline_t* timeline = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(host_allocator, sizeof(*timeline),
+                                (void**)&timeline));
+  memset(timeline, 0, sizeof(*timeline));
+  timeline->host_allocator = host_allocator;
+  timeline->creation_ns = iree_time_now();
+  iree_slim_mutex_initialize(&timeline->mutex);
+  iree_string_builder_initialize(host_allocator, &timeline->names);
+
+  // Implicit phase covering everything before the first named phase.
+  iree_status_t status =
+      iree_allocation_timeline_append_phase(timeline, iree_string_view_empty());
+
+  if (iree_status_is_ok(status)) {
+    iree_hal_allocator_event_listener_t listener = {
+        .fn = iree_allocation_timeline_on_event,
+        .user_data = timeline,
+    };
+    iree_hal_allocator_set_event_listener(listener);
+    *out_timeline = timeline;
+  } else {
+    iree_allocation_timeline_destroy(timeline);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+void iree_allocation_timeline_destroy(iree_allocation_timeline_t* timeline) {
+  if (!timeline) return;
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_hal_allocator_event_listener_t listener = {NULL, NULL};
+  iree_hal_allocator_set_event_listener(listener);
+  iree_allocator_t host_allocator = timeline->host_allocator;
+  iree_string_builder_deinitialize(&timeline->names);
+  iree_allocator_free(host_allocator, timeline->phases);
+  iree_allocator_free(host_allocator, timeline->events);
+  iree_slim_mutex_deinitialize(&timeline->mutex);
+  iree_allocator_free(host_allocator, timeline);
+  IREE_TRACE_ZONE_END(z0);
+}
+
+iree_status_t iree_allocation_timeline_begin_phase(
+    iree_allocation_timeline_t* timeline, iree_string_view_t name) {
+  IREE_ASSERT_ARGUMENT(timeline);
+  iree_slim_mutex_lock(&timeline->mutex);
+  iree_status_t status = iree_allocation_timeline_append_phase(timeline, name);
+  iree_slim_mutex_unlock(&timeline->mutex);
+  return status;
+}
+
+//===----------------------------------------------------------------------===//
+// Replay
+//===----------------------------------------------------------------------===//
+
+// An allocation that is live at some point during replay.
+typedef struct iree_allocation_timeline_live_t {
+  const iree_hal_buffer_t* buffer;
+  const iree_allocation_timeline_event_t* allocate_event;
+  const iree_allocation_timeline_event_t* name_event;
+} iree_allocation_timeline_live_t;
+
+// Set of allocations of a single allocator live during replay.
+typedef struct iree_allocation_timeline_replay_t {
+  const iree_hal_allocator_t* allocator;
+  iree_allocator_t host_allocator;
+  iree_host_size_t count;
+  iree_host_size_t capacity;
+  iree_allocation_timeline_live_t* entries;
+  iree_device_size_t live_bytes;
+} iree_allocation_timeline_replay_t;
+
+static void iree_allocation_timeline_replay_initialize(
+    const iree_hal_allocator_t* allocator, iree_allocator_t host_allocator,
+    iree_allocation_timeline_replay_t* out_replay) {
+  memset(out_replay, 0, sizeof(*out_replay));
+  out_replay->allocator = allocator;
+  out_replay->host_allocator = host_allocator;
+}
+
+static void iree_allocation_timeline_replay_deinitialize(
+    iree_allocation_timeline_replay_t* replay) {
+  iree_allocator_free(replay->host_allocator, replay->entries);
+  memset(replay, 0, sizeof(*replay));
+}
+
+static void iree_allocation_timeline_replay_reset(
+    iree_allocation_timeline_replay_t* replay) {
+  replay->count = 0;
+  replay->live_bytes = 0;
+}
+
+// Applies |event| to the live set. Deallocations of buffers that were never
+// seen allocated (such as those allocated before the timeline was created)
+// are ignored. Buffers are usually freed in roughly the reverse order they
+// were allocated so the live set is searched from the most recent entries.
+static iree_status_t iree_allocation_timeline_replay_apply(
+    iree_allocation_timeline_replay_t* replay,
+    const iree_allocation_timeline_event_t* event) {
+  switch (event->type) {
+    case IREE_HAL_ALLOCATOR_EVENT_TYPE_ALLOCATE: {
+      if (event->allocator != replay->allocator) break;
+      IREE_RETURN_IF_ERROR(iree_allocation_timeline_reserve(
+          replay->host_allocator, sizeof(*replay->entries), replay->count + 1,
+          &replay->capacity, (void**)&replay->entries));
+      iree_allocation_timeline_live_t* entry = &replay->entries[replay->count];
+      entry->buffer = event->buffer;
+      entry->allocate_event = event;
+      entry->name_event = NULL;
+      ++replay->count;
+      replay->live_bytes += event->allocation_size;
+      break;
+    }
+    case IREE_HAL_ALLOCATOR_EVENT_TYPE_DEALLOCATE: {
+      if (event->allocator != replay->allocator) break;
+      for (iree_host_size_t i = replay->count; i > 0; --i) {
+        iree_allocation_timeline_live_t* entry = &replay->entries[i - 1];
+        if (entry->buffer != event->buffer) continue;
+        replay->live_bytes -= entry->allocate_event->allocation_size;
+        *entry = replay->entries[--replay->count];
+        break;
+      }
+      break;
+    }
+    case IREE_HAL_ALLOCATOR_EVENT_TYPE_NAME: {
+      // Names apply to the buffer regardless of which allocator it is nested
+      // in such that underlying allocators inherit the names of their users.
+      for (iree_host_size_t i = replay->count; i > 0; --i) {
+        iree_allocation_timeline_live_t* entry = &replay->entries[i - 1];
+        if (entry->buffer != event->buffer) continue;
+        entry->name_event = event;
+        break;
+      }
+      break;
+    }
+    default:
+      break;
+  }
+  return iree_ok_status();
+}
+
+//===----------------------------------------------------------------------===//
+// Formatting
+//===----------------------------------------------------------------------===//
+
+static int iree_allocation_timeline_live_compare(const void* a, const void* b) {
+  iree_device_size_t size_a =
+      ((const iree_allocation_timeline_live_t*)a)->allocate_event->
+      allocation_size;
+  iree_device_size_t size_b =
+      ((const iree_allocation_timeline_live_t*)b)->allocate_event->
+      allocation_size;
+  return size_a < size_b ? 1 : (size_a > size_b ? -1 : 0);
+}
+
+static double iree_allocation_timeline_ms(iree_time_t duration_ns) {
+  return (double)duration_ns / 1000000.0;
+}
+
+static iree_status_t iree_allocation_timeline_append_bar(
+    iree_device_size_t value, iree_device_size_t max_value,
+    iree_string_builder_t* builder) {
+  iree_host_size_t width = 0;
+  if (max_value > 0) {
+    width = (iree_host_size_t)(
+        (value * IREE_ALLOCATION_TIMELINE_BAR_WIDTH + max_value - 1) /
+        max_value);
+  }
+  for (iree_host_size_t i = 0; i < width; ++i) {
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_cstring(builder, "#"));
+  }
+  return iree_ok_status();
+}
+
+// Formats the memory of |allocator| over the events of |phase_index|.
+// Skips allocators that have no live memory or events during the phase.
+static iree_status_t iree_allocation_timeline_format_allocator(
+    const iree_allocation_timeline_t* timeline, iree_host_size_t phase_index,
+    iree_time_t end_ns, const iree_hal_allocator_t* allocator,
+    iree_allocation_timeline_replay_t* replay, iree_string_builder_t* builder) {
+  const iree_allocation_timeline_phase_t* phase =
+      &timeline->phases[phase_index];
+  iree_host_size_t first_event = phase->first_event;
+  iree_host_size_t end_event = timeline->event_count;
+  if (phase_index + 1 < timeline->phase_count) {
+    end_event = timeline->phases[phase_index + 1].first_event;
+  }
+
+  // Replay up to the start of the phase to find the live bytes carried in.
+  iree_allocation_timeline_replay_reset(replay);
+  replay->allocator = allocator;
+  for (iree_host_size_t i = 0; i < first_event; ++i) {
+    IREE_RETURN_IF_ERROR(
+        iree_allocation_timeline_replay_apply(replay, &timeline->events[i]));
+  }
+  iree_device_size_t start_bytes = replay->live_bytes;
+
+  // Replay the phase tracking the peak and the maximum per time bucket.
+  // Buckets without any events hold the live bytes carried into them.
+  iree_time_t duration_ns = iree_max(1, end_ns - phase->start_ns);
+  iree_device_size_t buckets[IREE_ALLOCATION_TIMELINE_BUCKET_COUNT];
+  for (iree_host_size_t i = 0; i < IREE_ALLOCATION_TIMELINE_BUCKET_COUNT; ++i) {
+    buckets[i] = start_bytes;
+  }
+  iree_host_size_t current_bucket = 0;
+  iree_device_size_t peak_bytes = start_bytes;
+  iree_host_size_t peak_event = first_event;
+  bool any_events = false;
+  for (iree_host_size_t i = first_event; i < end_event; ++i) {
+    const iree_allocation_timeline_event_t* event = &timeline->events[i];
+    if (event->allocator == allocator) any_events = true;
+    iree_host_size_t bucket = (iree_host_size_t)(
+        (iree_max(0, event->timestamp_ns - phase->start_ns) *
+         IREE_ALLOCATION_TIMELINE_BUCKET_COUNT) /
+        duration_ns);
+    bucket = iree_min(bucket, IREE_ALLOCATION_TIMELINE_BUCKET_COUNT - 1);
+    for (; current_bucket < bucket; ++current_bucket) {
+      buckets[current_bucket + 1] = replay->live_bytes;
+    }
+    IREE_RETURN_IF_ERROR(iree_allocation_timeline_replay_apply(replay, event));
+    buckets[bucket] = iree_max(buckets[bucket], replay->live_bytes);
+    if (replay->live_bytes > peak_bytes) {
+      peak_bytes = replay->live_bytes;
+      peak_event = i + 1;
+    }
+  }
+  iree_device_size_t end_bytes = replay->live_bytes;
+  for (; current_bucket + 1 < IREE_ALLOCATION_TIMELINE_BUCKET_COUNT;
+       ++current_bucket) {
+    buckets[current_bucket + 1] = end_bytes;
+  }
+  if (!any_events && start_bytes == 0) return iree_ok_status();
+
+  iree_time_t peak_ns = peak_event > first_event
+                            ? timeline->events[peak_event - 1].timestamp_ns
+                            : phase->start_ns;
+  IREE_RETURN_IF_ERROR(iree_string_builder_append_format(
+      builder,
+      "  allocator %p: %12" PRIu64 "B peak at +%.3fms (%" PRIu64
+      "B at start, %" PRIu64 "B at end)\n",
+      (const void*)allocator, (uint64_t)peak_bytes,
+      iree_allocation_timeline_ms(peak_ns - phase->start_ns),
+      (uint64_t)start_bytes, (uint64_t)end_bytes));
+
+  // Live bytes over time.
+  for (iree_host_size_t i = 0; i < IREE_ALLOCATION_TIMELINE_BUCKET_COUNT; ++i) {
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_format(
+        builder, "    +%10.3fms %12" PRIu64 "B |",
+        iree_allocation_timeline_ms(
+            (duration_ns * (iree_time_t)i) /
+            IREE_ALLOCATION_TIMELINE_BUCKET_COUNT),
+        (uint64_t)buckets[i]));
+    IREE_RETURN_IF_ERROR(
+        iree_allocation_timeline_append_bar(buckets[i], peak_bytes, builder));
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_cstring(builder, "\n"));
+  }
+
+  // Replay again up to the peak to list what was holding memory.
+  iree_allocation_timeline_replay_reset(replay);
+  for (iree_host_size_t i = 0; i < peak_event; ++i) {
+    IREE_RETURN_IF_ERROR(
+        iree_allocation_timeline_replay_apply(replay, &timeline->events[i]));
+  }
+  if (replay->count == 0) return iree_ok_status();
+  qsort(replay->entries, replay->count, sizeof(*replay->entries),
+        iree_allocation_timeline_live_compare);
+  IREE_RETURN_IF_ERROR(iree_string_builder_append_format(
+      builder, "    %" PRIhsz " allocations live at peak:\n", replay->count));
+  iree_host_size_t listed_count =
+      iree_min(replay->count, IREE_ALLOCATION_TIMELINE_MAX_PEAK_ALLOCATIONS);
+  for (iree_host_size_t i = 0; i < listed_count; ++i) {
+    const iree_allocation_timeline_live_t* entry = &replay->entries[i];
+    iree_bitfield_string_temp_t temp;
+    iree_string_view_t memory_type = iree_hal_memory_type_format(
+        entry->allocate_event->memory_type, &temp);
+    iree_string_view_t name =
+        entry->name_event
+            ? iree_allocation_timeline_name(timeline,
+                                            entry->name_event->name_offset,
+                                            entry->name_event->name_length)
+            : IREE_SV("(unnamed)");
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_format(
+        builder, "      %12" PRIu64 "B %.*s %.*s\n",
+        (uint64_t)entry->allocate_event->allocation_size,
+        (int)memory_type.size, memory_type.data, (int)name.size, name.data));
+  }
+  if (replay->count > listed_count) {
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_format(
+        builder, "      ... %" PRIhsz " more\n", replay->count - listed_count));
+  }
+  return iree_ok_status();
+}
+
+// Collects the unique allocators that recorded allocations.
+static iree_status_t iree_allocation_timeline_collect_allocators(
+    const iree_allocation_timeline_t* timeline, iree_host_size_t* out_count,
+    iree_host_size_t* inout_capacity,
+    const iree_hal_allocator_t*** inout_allocators) {
+  *out_count = 0;
+  for (iree_host_size_t i = 0; i < timeline->event_count; ++i) {
+    const iree_allocation_timeline_event_t* event = &timeline->events[i];
+    if (event->type != IREE_HAL_ALLOCATOR_EVENT_TYPE_ALLOCATE) continue;
+    bool found = false;
+    for (iree_host_size_t j = 0; j < *out_count; ++j) {
+      if ((*inout_allocators)[j] == event->allocator) {
+        found = true;
+        break;
+      }
+    }
+    if (found) continue;
+    IREE_RETURN_IF_ERROR(iree_allocation_timeline_reserve(
+        timeline->host_allocator, sizeof(**inout_allocators), *out_count + 1,
+        inout_capacity, (void**)inout_allocators));
+    (*inout_allocators)[(*out_count)++] = event->allocator;
+  }
+  return iree_ok_status();
+}
+
+static iree_status_t iree_allocation_timeline_format_locked(
+    const iree_allocation_timeline_t* timeline,
+    iree_string_builder_t* builder) {
+  iree_host_size_t allocator_count = 0;
+  iree_host_size_t allocator_capacity = 0;
+  const iree_hal_allocator_t** allocators = NULL;
+  iree_status_t status = iree_allocation_timeline_collect_allocators(
+      timeline, &allocator_count, &allocator_capacity, &allocators);
+
+  iree_allocation_timeline_replay_t replay;
+  iree_allocation_timeline_replay_initialize(NULL, timeline->host_allocator,
+                                             &replay);
+  for (iree_host_size_t i = 0;
+       i < timeline->phase_count && iree_status_is_ok(status); ++i) {
+    const iree_allocation_timeline_phase_t* phase = &timeline->phases[i];
+    bool is_last = i + 1 == timeline->phase_count;
+    iree_host_size_t end_event =
+        is_last ? timeline->event_count : timeline->phases[i + 1].first_event;
+    // The implicit phase is only interesting if something happened in it.
+    if (i == 0 && phase->name_length == 0 && end_event == 0) continue;
+    iree_time_t end_ns = phase->start_ns;
+    if (!is_last) {
+      end_ns = timeline->phases[i + 1].start_ns;
+    } else if (end_event > phase->first_event) {
+      end_ns = timeline->events[end_event - 1].timestamp_ns;
+    }
+
+    iree_string_view_t name = iree_allocation_timeline_name(
+        timeline, phase->name_offset, phase->name_length);
+    if (iree_string_view_is_empty(name)) name = IREE_SV("(startup)");
+    status = iree_string_builder_append_format(
+        builder,
+        "[[ memory timeline: %.*s ]] %.3fms, %" PRIhsz " events\n",
+        (int)name.size, name.data,
+        iree_allocation_timeline_ms(end_ns - phase->start_ns),
+        end_event - phase->first_event);
+    for (iree_host_size_t j = 0;
+         j < allocator_count && iree_status_is_ok(status); ++j) {
+      status = iree_allocation_timeline_format_allocator(
+          timeline, i, end_ns, allocators[j], &replay, builder);
+    }
+  }
+  if (iree_status_is_ok(status) && timeline->dropped_count > 0) {
+    status = iree_string_builder_append_format(
+        builder, "(%" PRIhsz " events dropped; results are incomplete)\n",
+        timeline->dropped_count);
+  }
+  iree_allocation_timeline_replay_deinitialize(&replay);
+  iree_allocator_free(timeline->host_allocator, (void*)allocators);
+  return status;
+}
+
+iree_status_t iree_allocation_timeline_format(
+    iree_allocation_timeline_t* timeline, iree_string_builder_t* builder) {
+  IREE_ASSERT_ARGUMENT(timeline);
+  IREE_ASSERT_ARGUMENT(builder);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_slim_mutex_lock(&timeline->mutex);
+  iree_status_t status =
+      iree_allocation_timeline_format_locked(timeline, builder);
+  iree_slim_mutex_unlock(&timeline->mutex);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+// Appends |value| as a quoted CSV field.
+static iree_status_t iree_allocation_timeline_append_csv_string(
+    iree_string_view_t value, iree_string_builder_t* builder) {
+  IREE_RETURN_IF_ERROR(iree_string_builder_append_cstring(builder, "\""));
+  for (iree_host_size_t i = 0; i < value.size; ++i) {
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_string(
+        builder, iree_make_string_view(&value.data[i], 1)));
+    if (value.data[i] == '"') {
+      IREE_RETURN_IF_ERROR(iree_string_builder_append_cstring(builder, "\""));
+    }
+  }
+  return iree_string_builder_append_cstring(builder, "\"");
+}
+
+static iree_status_t iree_allocation_timeline_format_csv_locked(
+    const iree_allocation_timeline_t* timeline,
+    iree_string_builder_t* builder) {
+  IREE_RETURN_IF_ERROR(iree_string_builder_append_cstring(
+      builder,
+      "timestamp_ns,phase,event,allocator,buffer,allocation_size,memory_type,"
+      "allowed_usage,name\n"));
+  for (iree_host_size_t i = 0; i < timeline->event_count; ++i) {
+    const iree_allocation_timeline_event_t* event = &timeline->events[i];
+    const iree_allocation_timeline_phase_t* phase =
+        &timeline->phases[event->phase];
+    const char* type_name = "allocate";
+    if (event->type == IREE_HAL_ALLOCATOR_EVENT_TYPE_DEALLOCATE) {
+      type_name = "deallocate";
+    } else if (event->type == IREE_HAL_ALLOCATOR_EVENT_TYPE_NAME) {
+      type_name = "name";
+    }
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_format(
+        builder, "%" PRId64 ",", event->timestamp_ns - timeline->creation_ns));
+    IREE_RETURN_IF_ERROR(iree_allocation_timeline_append_csv_string(
+        iree_allocation_timeline_name(timeline, phase->name_offset,
+                                      phase->name_length),
+        builder));
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_format(
+        builder, ",%s,%p,%p,%" PRIu64 ",", type_name,
+        (const void*)event->allocator, (const void*)event->buffer,
+        (uint64_t)event->allocation_size));
+    iree_bitfield_string_temp_t temp;
+    IREE_RETURN_IF_ERROR(iree_allocation_timeline_append_csv_string(
+        iree_hal_memory_type_format(event->memory_type, &temp), builder));
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_cstring(builder, ","));
+    IREE_RETURN_IF_ERROR(iree_allocation_timeline_append_csv_string(
+        iree_hal_buffer_usage_format(event->allowed_usage, &temp), builder));
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_cstring(builder, ","));
+    IREE_RETURN_IF_ERROR(iree_allocation_timeline_append_csv_string(
+        iree_allocation_timeline_name(timeline, event->name_offset,
+                                      event->name_length),
+        builder));
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_cstring(builder, "\n"));
+  }
+  return iree_ok_status();
+}
+
+iree_status_t iree_allocation_timeline_format_csv(
+    iree_allocation_timeline_t* timeline, iree_string_builder_t* builder) {
+  IREE_ASSERT_ARGUMENT(timeline);
+  IREE_ASSERT_ARGUMENT(builder);
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_slim_mutex_lock(&timeline->mutex);
+  iree_status_t status =
+      iree_allocation_timeline_format_csv_locked(timeline, builder);
+  iree_slim_mutex_unlock(&timeline->mutex);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
@@ -0,0 +1,65 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_TOOLS_UTILS_ALLOCATION_TIMELINE_H_
+#define IREE_TOOLS_UTILS_ALLOCATION_TIMELINE_H_
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Maximum number of live allocations listed per allocator at its peak.
+#define IREE_ALLOCATION_TIMELINE_MAX_PEAK_ALLOCATIONS 16
+
+// Number of time buckets the live memory of each phase is rendered with.
+#define IREE_ALLOCATION_TIMELINE_BUCKET_COUNT 24
+
+// Records HAL allocation events and renders per-phase memory timelines.
+//
+// The timeline is installed as the process-wide allocation event listener
+// (see iree_hal_allocator_set_event_listener) and records every event in
+// order. Users delimit phases of interest, such as module loading and each
+// invocation, with iree_allocation_timeline_begin_phase and then render the
+// timeline to find when memory peaks and which allocations are live at the
+// peak. Buffers allocated from the HAL module are named with the program
+// location they were allocated by.
+//
+// Thread-safe; events may arrive from any thread.
+typedef struct iree_allocation_timeline_t iree_allocation_timeline_t;
+
+// Creates a new timeline and installs it as the allocation event listener.
+// Only one timeline may be installed at a time.
+iree_status_t iree_allocation_timeline_create(
+    iree_allocator_t host_allocator, iree_allocation_timeline_t** out_timeline);
+
+// Uninstalls the timeline as the allocation event listener and frees it.
+void iree_allocation_timeline_destroy(iree_allocation_timeline_t* timeline);
+
+// Begins a new phase named |name|. All events recorded until the next phase
+// begins are attributed to it. Events recorded before the first phase are
+// attributed to an implicit unnamed phase.
+iree_status_t iree_allocation_timeline_begin_phase(
+    iree_allocation_timeline_t* timeline, iree_string_view_t name);
+
+// Appends a human-readable rendering of each phase to |builder|: the peak live
+// bytes of each allocator, the largest allocations live at that peak, and the
+// live bytes over the duration of the phase.
+iree_status_t iree_allocation_timeline_format(
+    iree_allocation_timeline_t* timeline, iree_string_builder_t* builder);
+
+// Appends all recorded events to |builder| as CSV with a header row.
+// Timestamps are relative to the creation of the timeline.
+iree_status_t iree_allocation_timeline_format_csv(
+    iree_allocation_timeline_t* timeline, iree_string_builder_t* builder);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_TOOLS_UTILS_ALLOCATION_TIMELINE_H_
@@ -0,0 +1,134 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/tools/utils/allocation_timeline.h"
+
+#include <string>
+
+#include "iree/base/api.h"
+#include "iree/hal/api.h"
+#include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+
+namespace iree {
+namespace {
+
+using ::iree::testing::status::StatusIs;
+using ::testing::HasSubstr;
+using ::testing::Not;
+
+static const iree_hal_memory_type_t kMemoryType =
+    IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE;
+static const iree_hal_buffer_usage_t kUsage =
+    IREE_HAL_BUFFER_USAGE_DISPATCH | IREE_HAL_BUFFER_USAGE_TRANSFER;
+
+struct AllocationTimelineTest : public ::testing::Test {
+  iree_allocator_t host_allocator = iree_allocator_system();
+  iree_hal_allocator_t* heap_allocator = NULL;
+  iree_allocation_timeline_t* timeline = NULL;
+
+  void SetUp() override {
+    IREE_ASSERT_OK(iree_hal_allocator_create_heap(
+        iree_make_cstring_view("heap"), host_allocator, host_allocator,
+        &heap_allocator));
+    IREE_ASSERT_OK(iree_allocation_timeline_create(host_allocator, &timeline));
+  }
+
+  void TearDown() override {
+    iree_allocation_timeline_destroy(timeline);
+    iree_hal_allocator_release(heap_allocator);
+  }
+
+  iree_hal_buffer_t* Allocate(iree_device_size_t size) {
+    iree_hal_buffer_t* buffer = NULL;
+    IREE_CHECK_OK(iree_hal_allocator_allocate_buffer(
+        heap_allocator, kMemoryType, kUsage, size, iree_const_byte_span_empty(),
+        &buffer));
+    return buffer;
+  }
+
+  std::string Format() {
+    iree_string_builder_t builder;
+    iree_string_builder_initialize(host_allocator, &builder);
+    IREE_CHECK_OK(iree_allocation_timeline_format(timeline, &builder));
+    std::string result(iree_string_builder_buffer(&builder),
+                       iree_string_builder_size(&builder));
+    iree_string_builder_deinitialize(&builder);
+    return result;
+  }
+
+  std::string FormatCSV() {
+    iree_string_builder_t builder;
+    iree_string_builder_initialize(host_allocator, &builder);
+    IREE_CHECK_OK(iree_allocation_timeline_format_csv(timeline, &builder));
+    std::string result(iree_string_builder_buffer(&builder),
+                       iree_string_builder_size(&builder));
+    iree_string_builder_deinitialize(&builder);
+    return result;
+  }
+};
+
+TEST_F(AllocationTimelineTest, OnlyOneListener) {
+  iree_allocation_timeline_t* other_timeline = NULL;
+  EXPECT_THAT(
+      Status(iree_allocation_timeline_create(host_allocator, &other_timeline)),
+      StatusIs(StatusCode::kFailedPrecondition));
+}
+
+// Tests that the peak is found within a phase and attributed to the named
+// allocations live at the time.
+TEST_F(AllocationTimelineTest, PeakInPhase) {
+  IREE_ASSERT_OK(
+      iree_allocation_timeline_begin_phase(timeline, IREE_SV("invoke")));
+  iree_hal_buffer_t* buffer0 = Allocate(1000);
+  iree_hal_allocator_name_buffer(buffer0, IREE_SV("transient0"));
+  iree_hal_buffer_t* buffer1 = Allocate(2000);
+  iree_hal_allocator_name_buffer(buffer1, IREE_SV("transient1"));
+  iree_hal_buffer_release(buffer0);
+  iree_hal_buffer_release(buffer1);
+  iree_hal_buffer_t* buffer2 = Allocate(500);
+  iree_hal_buffer_release(buffer2);
+
+  std::string result = Format();
+  EXPECT_THAT(result, HasSubstr("memory timeline: invoke"));
+  EXPECT_THAT(result, HasSubstr("3000B peak"));
+  EXPECT_THAT(result, HasSubstr("2 allocations live at peak"));
+  EXPECT_THAT(result, HasSubstr("transient0"));
+  EXPECT_THAT(result, HasSubstr("transient1"));
+  // Empty implicit phases are not rendered.
+  EXPECT_THAT(result, Not(HasSubstr("(startup)")));
+}
+
+// Tests that allocations live across phases count toward later phases.
+TEST_F(AllocationTimelineTest, CarryAcrossPhases) {
+  IREE_ASSERT_OK(
+      iree_allocation_timeline_begin_phase(timeline, IREE_SV("load")));
+  iree_hal_buffer_t* constants = Allocate(4000);
+  IREE_ASSERT_OK(
+      iree_allocation_timeline_begin_phase(timeline, IREE_SV("invoke")));
+  iree_hal_buffer_t* transient = Allocate(1000);
+  iree_hal_buffer_release(transient);
+
+  std::string result = Format();
+  EXPECT_THAT(result, HasSubstr("4000B at start"));
+  EXPECT_THAT(result, HasSubstr("5000B peak"));
+  iree_hal_buffer_release(constants);
+}
+
+TEST_F(AllocationTimelineTest, CSV) {
+  iree_hal_buffer_t* buffer = Allocate(128);
+  iree_hal_allocator_name_buffer(buffer, IREE_SV("a \"quoted\" name"));
+  iree_hal_buffer_release(buffer);
+
+  std::string result = FormatCSV();
+  EXPECT_THAT(result, HasSubstr("timestamp_ns,phase,event,"));
+  EXPECT_THAT(result, HasSubstr(",allocate,"));
+  EXPECT_THAT(result, HasSubstr(",deallocate,"));
+  EXPECT_THAT(result, HasSubstr("\"a \"\"quoted\"\" name\""));
+}
+
+}  // namespace
+}  // namespace iree
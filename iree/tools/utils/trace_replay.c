@@ -44,6 +44,7 @@ void iree_trace_replay_deinitialize(iree_trace_replay_t* replay,
         stderr, iree_hal_device_allocator(replay->device)));
   }
   iree_hal_device_release(replay->device);
+  iree_hal_device_release(replay->device_override);
 
   memset(replay, 0, sizeof(*replay));
 }
@@ -53,6 +54,13 @@ void iree_trace_replay_set_hal_driver_override(iree_trace_replay_t* replay,
   replay->driver = driver;
 }
 
+void iree_trace_replay_set_hal_device_override(iree_trace_replay_t* replay,
+                                               iree_hal_device_t* device) {
+  iree_hal_device_retain(device);
+  iree_hal_device_release(replay->device_override);
+  replay->device_override = device;
+}
+
 iree_status_t iree_trace_replay_event_context_load(iree_trace_replay_t* replay,
                                                    yaml_document_t* document,
                                                    yaml_node_t* event_node) {
@@ -71,6 +79,13 @@ iree_status_t iree_trace_replay_event_context_load(iree_trace_replay_t* replay,
 static iree_status_t iree_trace_replay_create_device(
     iree_trace_replay_t* replay, yaml_node_t* driver_node,
     iree_allocator_t host_allocator, iree_hal_device_t** out_device) {
+  // Use the device override if provided; it is shared with other replays.
+  if (replay->device_override) {
+    iree_hal_device_retain(replay->device_override);
+    *out_device = replay->device_override;
+    return iree_ok_status();
+  }
+
   // Use the provided driver name or override with the --driver= flag.
   iree_string_view_t driver_name = iree_yaml_node_as_string(driver_node);
   if (iree_string_view_is_empty(driver_name)) {
@@ -125,30 +140,35 @@ static iree_status_t iree_trace_replay_load_bytecode_module(
   IREE_RETURN_IF_ERROR(iree_yaml_mapping_find(
       document, module_node, iree_make_cstring_view("path"), &path_node));
 
-  // Load bytecode file (or stdin) contents into memory.
-  iree_byte_span_t flatbuffer_data;
+  // Load bytecode file (or stdin) contents into memory. Files are mapped so
+  // that large modules are not copied.
+  iree_const_byte_span_t flatbuffer_data = iree_const_byte_span_empty();
+  iree_allocator_t flatbuffer_allocator = iree_allocator_null();
   iree_status_t status = iree_ok_status();
   if (iree_yaml_string_equal(path_node, iree_make_cstring_view("<stdin>"))) {
-    status = iree_stdin_read_contents(replay->host_allocator, &flatbuffer_data);
+    iree_byte_span_t stdin_data = iree_byte_span_empty();
+    status = iree_stdin_read_contents(replay->host_allocator, &stdin_data);
+    flatbuffer_data =
+        iree_make_const_byte_span(stdin_data.data, stdin_data.data_length);
+    flatbuffer_allocator = replay->host_allocator;
   } else {
     char* full_path = NULL;
     IREE_RETURN_IF_ERROR(iree_file_path_join(
         replay->root_path, iree_yaml_node_as_string(path_node),
         replay->host_allocator, &full_path));
-    status = iree_file_read_contents(full_path, replay->host_allocator,
-                                     &flatbuffer_data);
+    status = iree_file_map_contents(full_path, replay->host_allocator,
+                                    &flatbuffer_data, &flatbuffer_allocator);
     iree_allocator_free(replay->host_allocator, full_path);
   }
 
   // Load and verify the bytecode module.
   iree_vm_module_t* module = NULL;
   if (iree_status_is_ok(status)) {
-    status = iree_vm_bytecode_module_create(
-        iree_make_const_byte_span(flatbuffer_data.data,
-                                  flatbuffer_data.data_length),
-        replay->host_allocator, replay->host_allocator, &module);
+    status = iree_vm_bytecode_module_create(flatbuffer_data,
+                                            flatbuffer_allocator,
+                                            replay->host_allocator, &module);
     if (!iree_status_is_ok(status)) {
-      iree_allocator_free(replay->host_allocator, flatbuffer_data.data);
+      iree_allocator_free(flatbuffer_allocator, (void*)flatbuffer_data.data);
     }
   }
 
@@ -720,6 +740,49 @@ static iree_status_t iree_trace_replay_parse_hal_buffer(
   return status;
 }
 
+// Allocates a buffer view with its contents initialized from the binary file
+// referenced by |contents_file_node|. The file is mapped and must contain
+// exactly the bytes of the buffer view.
+static iree_status_t iree_trace_replay_load_hal_buffer_view_file(
+    iree_trace_replay_t* replay, yaml_node_t* contents_file_node,
+    const iree_hal_dim_t* shape, iree_host_size_t shape_rank,
+    iree_hal_element_type_t element_type,
+    iree_hal_encoding_type_t encoding_type,
+    iree_hal_buffer_view_t** out_buffer_view) {
+  iree_device_size_t allocation_size = 0;
+  IREE_RETURN_IF_ERROR(iree_hal_buffer_compute_view_size(
+      shape, shape_rank, element_type, encoding_type, &allocation_size));
+
+  char* full_path = NULL;
+  IREE_RETURN_IF_ERROR(iree_file_path_join(
+      replay->root_path, iree_yaml_node_as_string(contents_file_node),
+      replay->host_allocator, &full_path));
+  iree_const_byte_span_t contents = iree_const_byte_span_empty();
+  iree_allocator_t contents_allocator = iree_allocator_null();
+  iree_status_t status = iree_file_map_contents(
+      full_path, replay->host_allocator, &contents, &contents_allocator);
+  if (iree_status_is_ok(status) && contents.data_length != allocation_size) {
+    status = iree_make_status(
+        IREE_STATUS_OUT_OF_RANGE,
+        "(%zu): contents_file '%s' has %zu bytes but the buffer view requires "
+        "%" PRIu64,
+        contents_file_node->start_mark.line, full_path, contents.data_length,
+        (uint64_t)allocation_size);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_hal_buffer_view_allocate_buffer(
+        iree_hal_device_allocator(replay->device), shape, shape_rank,
+        element_type, encoding_type,
+        IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE,
+        IREE_HAL_BUFFER_USAGE_DISPATCH | IREE_HAL_BUFFER_USAGE_TRANSFER |
+            IREE_HAL_BUFFER_USAGE_MAPPING,
+        contents, out_buffer_view);
+  }
+  iree_allocator_free(contents_allocator, (void*)contents.data);
+  iree_allocator_free(replay->host_allocator, full_path);
+  return status;
+}
+
 // Parses a !hal.buffer_view and appends it to |target_list|.
 //
 // ```yaml
@@ -729,6 +792,14 @@ static iree_status_t iree_trace_replay_parse_hal_buffer(
 // contents: !!binary |
 //   AACAPwAAAEAAAEBAAACAQA==
 // ```
+// or, with the contents stored in a binary file relative to the root path
+// (such as tensors of recorded requests):
+// ```yaml
+// shape:
+// - 4
+// element_type: 553648160
+// contents_file: inputs/request0_arg0.bin
+// ```
 static iree_status_t iree_trace_replay_parse_hal_buffer_view(
     iree_trace_replay_t* replay, yaml_document_t* document,
     yaml_node_t* value_node, iree_vm_list_t* target_list) {
@@ -767,12 +838,24 @@ static iree_status_t iree_trace_replay_parse_hal_buffer_view(
       document, value_node, iree_make_cstring_view("contents_generator"),
       &generator_node));
 
+  yaml_node_t* contents_file_node = NULL;
+  IREE_RETURN_IF_ERROR(iree_yaml_mapping_try_find(
+      document, value_node, iree_make_cstring_view("contents_file"),
+      &contents_file_node));
+
   iree_hal_buffer_view_t* buffer_view = NULL;
-  if (contents_node && generator_node) {
+  if ((contents_node != NULL) + (generator_node != NULL) +
+          (contents_file_node != NULL) >
+      1) {
     return iree_make_status(
         IREE_STATUS_INVALID_ARGUMENT,
-        "(%zu): cannot have both contents and contents_generator",
-        generator_node->start_mark.line);
+        "(%zu): only one of contents, contents_generator, and contents_file "
+        "may be specified",
+        value_node->start_mark.line);
+  } else if (contents_file_node) {
+    IREE_RETURN_IF_ERROR(iree_trace_replay_load_hal_buffer_view_file(
+        replay, contents_file_node, shape, shape_rank, element_type,
+        encoding_type, &buffer_view));
   } else if (contents_node || generator_node) {
     iree_trace_replay_generation_params_t params = {
         .replay = replay,
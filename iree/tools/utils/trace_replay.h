@@ -28,6 +28,7 @@ typedef struct iree_trace_replay_t {
   iree_vm_instance_t* instance;
   iree_vm_context_flags_t context_flags;
   iree_string_view_t driver;
+  iree_hal_device_t* device_override;
 
   iree_vm_context_t* context;
   iree_hal_device_t* device;
@@ -49,6 +50,14 @@ void iree_trace_replay_deinitialize(iree_trace_replay_t* replay,
 void iree_trace_replay_set_hal_driver_override(iree_trace_replay_t* replay,
                                                iree_string_view_t driver);
 
+// Overrides the HAL device used in the trace with the given |device|.
+// Takes precedence over any driver specified in the trace or with
+// iree_trace_replay_set_hal_driver_override. Multiple replays may share the
+// same device to replay traces concurrently against it. The device is retained
+// until the replay is deinitialized.
+void iree_trace_replay_set_hal_device_override(iree_trace_replay_t* replay,
+                                               iree_hal_device_t* device);
+
 // Replays the given |event_node| against the replay context.
 // Automatically switches between the default iree_trace_replay_event_* methods.
 iree_status_t iree_trace_replay_event(iree_trace_replay_t* replay,
@@ -6,9 +6,14 @@
 
 #include "iree/tools/utils/vm_util.h"
 
+#include <atomic>
+#include <cctype>
 #include <cerrno>
+#include <cinttypes>
 #include <cstdint>
 #include <cstdio>
+#include <cstring>
+#include <map>
 #include <ostream>
 #include <type_traits>
 #include <vector>
@@ -68,6 +73,615 @@ Status GetFileContents(const char* path, std::string* out_contents) {
   return status;
 }
 
+namespace {
+
+// Inputs loaded from files are only wrapped in place when the data is at
+// least this aligned; executables may assume the alignment of device
+// allocations for their bindings.
+constexpr uintptr_t kFileDataAlignment = 64;
+
+// A memory-mapped input file shared by all buffers wrapping its contents.
+// Each wrapping buffer holds a reference through the allocator returned by
+// Retain and the mapping is released along with the last of them.
+class MappedFile {
+ public:
+  static Status Open(const char* path, MappedFile** out_file) {
+    MappedFile* file = new MappedFile();
+    iree_status_t status =
+        iree_file_map_contents(path, iree_allocator_system(), &file->contents_,
+                               &file->deallocator_);
+    if (!iree_status_is_ok(status)) {
+      file->Release();
+      return iree_status_annotate_f(status, "mapping input file '%s'", path);
+    }
+    *out_file = file;
+    return OkStatus();
+  }
+
+  iree_const_byte_span_t contents() const { return contents_; }
+
+  // Returns an allocator that releases the reference it holds on |this| when
+  // asked to free the mapped contents.
+  iree_allocator_t Retain() {
+    ref_count_.fetch_add(1, std::memory_order_relaxed);
+    return iree_allocator_t{this, MappedFile::Ctl};
+  }
+
+  void Release() {
+    if (ref_count_.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this;
+  }
+
+ private:
+  MappedFile() = default;
+  ~MappedFile() {
+    iree_allocator_free(deallocator_, const_cast<uint8_t*>(contents_.data));
+  }
+
+  static iree_status_t Ctl(void* self, iree_allocator_command_t command,
+                           const void* params, void** inout_ptr) {
+    if (command != IREE_ALLOCATOR_COMMAND_FREE) {
+      return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                              "mapped files can only be freed");
+    }
+    reinterpret_cast<MappedFile*>(self)->Release();
+    return iree_ok_status();
+  }
+
+  std::atomic<int32_t> ref_count_{1};
+  iree_const_byte_span_t contents_ = iree_const_byte_span_empty();
+  iree_allocator_t deallocator_ = iree_allocator_null();
+};
+
+// Minimal parser for the header dictionaries of NPY files (Python literals)
+// and safetensors files (JSON). Only the subset the formats use is supported:
+// dictionaries with string keys, strings, integers, booleans, and lists or
+// tuples of integers. Other values can only be skipped.
+class HeaderParser {
+ public:
+  explicit HeaderParser(iree_string_view_t text) : text_(text) {}
+
+  // Consumes |c| if it is the next non-whitespace character.
+  bool Consume(char c) {
+    SkipWhitespace();
+    if (pos_ >= text_.size || text_.data[pos_] != c) return false;
+    ++pos_;
+    return true;
+  }
+
+  bool ParseString(std::string* out_value) {
+    SkipWhitespace();
+    if (pos_ >= text_.size) return false;
+    char quote = text_.data[pos_];
+    if (quote != '\'' && quote != '"') return false;
+    size_t end = pos_ + 1;
+    while (end < text_.size && text_.data[end] != quote) {
+      // Escapes are not expected in names or dtypes and are kept verbatim.
+      if (text_.data[end] == '\\') ++end;
+      ++end;
+    }
+    if (end >= text_.size) return false;
+    out_value->assign(text_.data + pos_ + 1, end - pos_ - 1);
+    pos_ = end + 1;
+    return true;
+  }
+
+  bool ParseInteger(int64_t* out_value) {
+    return iree_string_view_atoi_int64(ParseToken(), out_value);
+  }
+
+  bool ParseBool(bool* out_value) {
+    iree_string_view_t token = ParseToken();
+    if (iree_string_view_equal(token, IREE_SV("True")) ||
+        iree_string_view_equal(token, IREE_SV("true"))) {
+      *out_value = true;
+      return true;
+    } else if (iree_string_view_equal(token, IREE_SV("False")) ||
+               iree_string_view_equal(token, IREE_SV("false"))) {
+      *out_value = false;
+      return true;
+    }
+    return false;
+  }
+
+  // Parses a tuple `(1, 2,)` or list `[1, 2]` of integers.
+  bool ParseIntegerList(std::vector<int64_t>* out_values) {
+    out_values->clear();
+    char close;
+    if (Consume('(')) {
+      close = ')';
+    } else if (Consume('[')) {
+      close = ']';
+    } else {
+      return false;
+    }
+    while (!Consume(close)) {
+      int64_t value = 0;
+      if (!ParseInteger(&value)) return false;
+      out_values->push_back(value);
+      if (!Consume(',')) return Consume(close);
+    }
+    return true;
+  }
+
+  // Skips over the next value of any supported kind, including nested
+  // dictionaries and lists.
+  bool SkipValue() {
+    SkipWhitespace();
+    if (pos_ >= text_.size) return false;
+    char c = text_.data[pos_];
+    if (c == '\'' || c == '"') {
+      std::string unused;
+      return ParseString(&unused);
+    } else if (c == '{' || c == '[' || c == '(') {
+      char close = c == '{' ? '}' : (c == '[' ? ']' : ')');
+      ++pos_;
+      while (!Consume(close)) {
+        if (!SkipValue()) return false;
+        if (close == '}' && (!Consume(':') || !SkipValue())) return false;
+        if (!Consume(',')) return Consume(close);
+      }
+      return true;
+    }
+    iree_string_view_t token = ParseToken();
+    return !iree_string_view_is_empty(token);
+  }
+
+ private:
+  void SkipWhitespace() {
+    while (pos_ < text_.size && isspace((unsigned char)text_.data[pos_])) {
+      ++pos_;
+    }
+  }
+
+  // Returns the bare token (number or identifier) at the current position.
+  iree_string_view_t ParseToken() {
+    SkipWhitespace();
+    size_t start = pos_;
+    while (pos_ < text_.size &&
+           (isalnum((unsigned char)text_.data[pos_]) ||
+            text_.data[pos_] == '-' || text_.data[pos_] == '+' ||
+            text_.data[pos_] == '.')) {
+      ++pos_;
+    }
+    return iree_make_string_view(text_.data + start, pos_ - start);
+  }
+
+  iree_string_view_t text_;
+  size_t pos_ = 0;
+};
+
+// Converts file dimensions into a HAL shape.
+Status ConvertShape(const std::vector<int64_t>& dims,
+                    std::vector<iree_hal_dim_t>* out_shape) {
+  out_shape->clear();
+  for (int64_t dim : dims) {
+    if (dim < 0 || dim > INT32_MAX) {
+      return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                              "dimension %" PRId64 " out of range", dim);
+    }
+    out_shape->push_back((iree_hal_dim_t)dim);
+  }
+  return OkStatus();
+}
+
+// Maps an NPY array-protocol type string such as `<f4` to an element type.
+bool ParseNpyDescr(const std::string& descr,
+                   iree_hal_element_type_t* out_element_type) {
+  if (descr.size() < 3) return false;
+  // The host is little-endian; big-endian data is only accepted when the
+  // byte order does not matter.
+  char byte_order = descr[0];
+  char kind = descr[1];
+  int32_t byte_count = 0;
+  if (!iree_string_view_atoi_int32(
+          iree_make_string_view(descr.data() + 2, descr.size() - 2),
+          &byte_count)) {
+    return false;
+  }
+  if (byte_order != '<' && byte_order != '|' && byte_order != '=' &&
+      !(byte_order == '>' && byte_count == 1)) {
+    return false;
+  }
+  iree_hal_numerical_type_t numerical_type;
+  switch (kind) {
+    case 'f':
+      if (byte_count != 2 && byte_count != 4 && byte_count != 8) return false;
+      numerical_type = IREE_HAL_NUMERICAL_TYPE_FLOAT_IEEE;
+      break;
+    case 'i':
+      numerical_type = IREE_HAL_NUMERICAL_TYPE_INTEGER_SIGNED;
+      break;
+    case 'u':
+      numerical_type = IREE_HAL_NUMERICAL_TYPE_INTEGER_UNSIGNED;
+      break;
+    case 'b':
+      // Booleans are stored as one byte per element like i1 tensors.
+      numerical_type = IREE_HAL_NUMERICAL_TYPE_INTEGER;
+      break;
+    default:
+      return false;
+  }
+  if (byte_count != 1 && byte_count != 2 && byte_count != 4 &&
+      byte_count != 8) {
+    return false;
+  }
+  *out_element_type = IREE_HAL_ELEMENT_TYPE_VALUE(numerical_type,
+                                                  byte_count * 8);
+  return true;
+}
+
+// Maps a safetensors dtype such as `F32` to an element type.
+bool ParseSafetensorsDtype(const std::string& dtype,
+                           iree_hal_element_type_t* out_element_type) {
+  if (dtype == "BOOL") {
+    *out_element_type = IREE_HAL_ELEMENT_TYPE_INT_8;
+    return true;
+  }
+  iree_string_view_t bit_count_str =
+      iree_make_string_view(dtype.data(), dtype.size());
+  iree_hal_numerical_type_t numerical_type;
+  if (iree_string_view_consume_prefix(&bit_count_str, IREE_SV("BF"))) {
+    numerical_type = IREE_HAL_NUMERICAL_TYPE_FLOAT_BRAIN;
+  } else if (iree_string_view_consume_prefix(&bit_count_str, IREE_SV("F"))) {
+    numerical_type = IREE_HAL_NUMERICAL_TYPE_FLOAT_IEEE;
+  } else if (iree_string_view_consume_prefix(&bit_count_str, IREE_SV("I"))) {
+    numerical_type = IREE_HAL_NUMERICAL_TYPE_INTEGER_SIGNED;
+  } else if (iree_string_view_consume_prefix(&bit_count_str, IREE_SV("U"))) {
+    numerical_type = IREE_HAL_NUMERICAL_TYPE_INTEGER_UNSIGNED;
+  } else {
+    return false;
+  }
+  int32_t bit_count = 0;
+  if (!iree_string_view_atoi_int32(bit_count_str, &bit_count) ||
+      (bit_count != 8 && bit_count != 16 && bit_count != 32 &&
+       bit_count != 64)) {
+    return false;
+  }
+  *out_element_type = IREE_HAL_ELEMENT_TYPE_VALUE(numerical_type, bit_count);
+  return true;
+}
+
+// Creates a buffer view with the contents of |data| within |file|.
+// Buffer views that are only read by the program wrap the mapped file
+// contents when the allocator can import them and the data is suitably
+// aligned; otherwise (or for storage references that may be written) the data
+// is copied into a new allocation.
+Status CreateBufferViewFromFile(iree_hal_allocator_t* allocator,
+                                MappedFile* file,
+                                const std::vector<iree_hal_dim_t>& shape,
+                                iree_hal_element_type_t element_type,
+                                iree_const_byte_span_t data,
+                                bool is_storage_reference,
+                                iree_hal_buffer_view_t** out_buffer_view) {
+  iree_device_size_t byte_length = 0;
+  IREE_RETURN_IF_ERROR(iree_hal_buffer_compute_view_size(
+      shape.data(), shape.size(), element_type,
+      IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR, &byte_length));
+  if (byte_length != data.data_length) {
+    return iree_make_status(
+        IREE_STATUS_OUT_OF_RANGE,
+        "file data length %zu does not match the shape and type (%" PRIu64
+        " bytes)",
+        data.data_length, (uint64_t)byte_length);
+  }
+
+  const iree_hal_memory_type_t memory_type =
+      IREE_HAL_MEMORY_TYPE_DEVICE_LOCAL | IREE_HAL_MEMORY_TYPE_HOST_VISIBLE;
+  const iree_hal_buffer_usage_t allowed_usage =
+      IREE_HAL_BUFFER_USAGE_DISPATCH | IREE_HAL_BUFFER_USAGE_TRANSFER |
+      IREE_HAL_BUFFER_USAGE_MAPPING;
+  bool wrap_allowed =
+      !is_storage_reference &&
+      ((uintptr_t)data.data % kFileDataAlignment) == 0 &&
+      iree_all_bits_set(iree_hal_allocator_query_buffer_compatibility(
+                            allocator, memory_type, allowed_usage,
+                            IREE_HAL_BUFFER_USAGE_MAPPING, byte_length),
+                        IREE_HAL_BUFFER_COMPATIBILITY_IMPORTABLE);
+  if (!wrap_allowed) {
+    return iree_hal_buffer_view_allocate_buffer(
+        allocator, shape.data(), shape.size(), element_type,
+        IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR, memory_type, allowed_usage,
+        data, out_buffer_view);
+  }
+
+  // The mapping is read-only and so is the wrapping buffer.
+  iree_allocator_t data_allocator = file->Retain();
+  iree_hal_buffer_t* buffer = nullptr;
+  iree_status_t status = iree_hal_allocator_wrap_buffer(
+      allocator, memory_type, IREE_HAL_MEMORY_ACCESS_READ, allowed_usage,
+      iree_make_byte_span(const_cast<uint8_t*>(data.data), data.data_length),
+      data_allocator, &buffer);
+  if (!iree_status_is_ok(status)) {
+    // The buffer did not take ownership of the reference.
+    file->Release();
+    return status;
+  }
+  status = iree_hal_buffer_view_create(
+      buffer, shape.data(), shape.size(), element_type,
+      IREE_HAL_ENCODING_TYPE_DENSE_ROW_MAJOR,
+      iree_hal_allocator_host_allocator(allocator), out_buffer_view);
+  iree_hal_buffer_release(buffer);
+  return status;
+}
+
+// Appends |buffer_view| to |list| as either a buffer view or, for storage
+// references, its underlying buffer.
+Status PushBufferView(iree_hal_buffer_view_t* buffer_view,
+                      bool is_storage_reference, iree_vm_list_t* list) {
+  if (is_storage_reference) {
+    auto buffer_ref =
+        iree_hal_buffer_retain_ref(iree_hal_buffer_view_buffer(buffer_view));
+    iree_hal_buffer_view_release(buffer_view);
+    return iree_vm_list_push_ref_move(list, &buffer_ref);
+  }
+  auto buffer_view_ref = iree_hal_buffer_view_move_ref(buffer_view);
+  return iree_vm_list_push_ref_move(list, &buffer_view_ref);
+}
+
+// Loads the single array of an NPY file.
+// https://numpy.org/doc/stable/reference/generated/numpy.lib.format.html
+Status LoadNpyFile(iree_hal_allocator_t* allocator, MappedFile* file,
+                   bool is_storage_reference, iree_vm_list_t* list) {
+  iree_const_byte_span_t contents = file->contents();
+  static const uint8_t kMagic[6] = {0x93, 'N', 'U', 'M', 'P', 'Y'};
+  if (contents.data_length < 10 ||
+      memcmp(contents.data, kMagic, sizeof(kMagic)) != 0) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "not an NPY file (missing magic)");
+  }
+  uint8_t major_version = contents.data[6];
+  size_t header_offset = 0;
+  size_t header_length = 0;
+  if (major_version == 1) {
+    header_offset = 10;
+    header_length = (size_t)contents.data[8] | ((size_t)contents.data[9] << 8);
+  } else if (major_version == 2 || major_version == 3) {
+    header_offset = 12;
+    if (contents.data_length < header_offset) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "truncated NPY header");
+    }
+    header_length = (size_t)contents.data[8] |
+                    ((size_t)contents.data[9] << 8) |
+                    ((size_t)contents.data[10] << 16) |
+                    ((size_t)contents.data[11] << 24);
+  } else {
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "unsupported NPY version %u", major_version);
+  }
+  if (header_offset + header_length > contents.data_length) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "truncated NPY header");
+  }
+
+  std::string descr;
+  bool fortran_order = false;
+  std::vector<int64_t> dims;
+  bool has_descr = false;
+  bool has_shape = false;
+  HeaderParser parser(iree_make_string_view(
+      (const char*)contents.data + header_offset, header_length));
+  bool valid = parser.Consume('{');
+  while (valid && !parser.Consume('}')) {
+    std::string key;
+    valid = parser.ParseString(&key) && parser.Consume(':');
+    if (!valid) break;
+    if (key == "descr") {
+      valid = has_descr = parser.ParseString(&descr);
+    } else if (key == "fortran_order") {
+      valid = parser.ParseBool(&fortran_order);
+    } else if (key == "shape") {
+      valid = has_shape = parser.ParseIntegerList(&dims);
+    } else {
+      valid = parser.SkipValue();
+    }
+    if (valid && !parser.Consume(',')) {
+      valid = parser.Consume('}');
+      break;
+    }
+  }
+  if (!valid || !has_descr || !has_shape) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "malformed NPY header");
+  }
+  if (fortran_order) {
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "Fortran-order NPY arrays are not supported");
+  }
+  iree_hal_element_type_t element_type = IREE_HAL_ELEMENT_TYPE_NONE;
+  if (!ParseNpyDescr(descr, &element_type)) {
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "unsupported NPY dtype '%s'", descr.c_str());
+  }
+  std::vector<iree_hal_dim_t> shape;
+  IREE_RETURN_IF_ERROR(ConvertShape(dims, &shape));
+
+  size_t data_offset = header_offset + header_length;
+  iree_hal_buffer_view_t* buffer_view = nullptr;
+  IREE_RETURN_IF_ERROR(CreateBufferViewFromFile(
+      allocator, file, shape, element_type,
+      iree_make_const_byte_span(contents.data + data_offset,
+                                contents.data_length - data_offset),
+      is_storage_reference, &buffer_view));
+  return PushBufferView(buffer_view, is_storage_reference, list);
+}
+
+// Loads tensors from a safetensors file: only |tensor_name| if not empty or
+// otherwise all tensors in the file ordered by name.
+// https://github.com/huggingface/safetensors#format
+Status LoadSafetensorsFile(iree_hal_allocator_t* allocator, MappedFile* file,
+                           const std::string& tensor_name,
+                           bool is_storage_reference, iree_vm_list_t* list) {
+  iree_const_byte_span_t contents = file->contents();
+  if (contents.data_length < 8) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "truncated safetensors header");
+  }
+  uint64_t header_length = 0;
+  for (int i = 7; i >= 0; --i) {
+    header_length = (header_length << 8) | contents.data[i];
+  }
+  if (header_length > contents.data_length - 8) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "truncated safetensors header");
+  }
+  size_t data_offset = 8 + (size_t)header_length;
+  size_t data_length = contents.data_length - data_offset;
+
+  struct Tensor {
+    iree_hal_element_type_t element_type = IREE_HAL_ELEMENT_TYPE_NONE;
+    std::vector<iree_hal_dim_t> shape;
+    uint64_t begin = 0;
+    uint64_t end = 0;
+  };
+  std::map<std::string, Tensor> tensors;
+  HeaderParser parser(iree_make_string_view((const char*)contents.data + 8,
+                                            (size_t)header_length));
+  bool valid = parser.Consume('{');
+  while (valid && !parser.Consume('}')) {
+    std::string name;
+    valid = parser.ParseString(&name) && parser.Consume(':');
+    if (!valid) break;
+    if (name == "__metadata__") {
+      valid = parser.SkipValue();
+    } else {
+      Tensor tensor;
+      std::string dtype;
+      std::vector<int64_t> dims;
+      std::vector<int64_t> offsets;
+      valid = parser.Consume('{');
+      while (valid && !parser.Consume('}')) {
+        std::string key;
+        valid = parser.ParseString(&key) && parser.Consume(':');
+        if (!valid) break;
+        if (key == "dtype") {
+          valid = parser.ParseString(&dtype);
+        } else if (key == "shape") {
+          valid = parser.ParseIntegerList(&dims);
+        } else if (key == "data_offsets") {
+          valid = parser.ParseIntegerList(&offsets);
+        } else {
+          valid = parser.SkipValue();
+        }
+        if (valid && !parser.Consume(',')) {
+          valid = parser.Consume('}');
+          break;
+        }
+      }
+      if (!valid || offsets.size() != 2 || offsets[0] < 0 ||
+          offsets[0] > offsets[1] || (uint64_t)offsets[1] > data_length) {
+        return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                                "malformed safetensors entry '%s'",
+                                name.c_str());
+      }
+      if (!ParseSafetensorsDtype(dtype, &tensor.element_type)) {
+        return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                                "unsupported safetensors dtype '%s' of '%s'",
+                                dtype.c_str(), name.c_str());
+      }
+      IREE_RETURN_IF_ERROR(ConvertShape(dims, &tensor.shape),
+                           "tensor '%s'", name.c_str());
+      tensor.begin = (uint64_t)offsets[0];
+      tensor.end = (uint64_t)offsets[1];
+      tensors[name] = std::move(tensor);
+    }
+    if (valid && !parser.Consume(',')) {
+      valid = parser.Consume('}');
+      break;
+    }
+  }
+  if (!valid) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "malformed safetensors header");
+  }
+
+  for (const auto& it : tensors) {
+    if (!tensor_name.empty() && it.first != tensor_name) continue;
+    const Tensor& tensor = it.second;
+    iree_hal_buffer_view_t* buffer_view = nullptr;
+    IREE_RETURN_IF_ERROR(
+        CreateBufferViewFromFile(
+            allocator, file, tensor.shape, tensor.element_type,
+            iree_make_const_byte_span(
+                contents.data + data_offset + tensor.begin,
+                (iree_host_size_t)(tensor.end - tensor.begin)),
+            is_storage_reference, &buffer_view),
+        "tensor '%s'", it.first.c_str());
+    IREE_RETURN_IF_ERROR(
+        PushBufferView(buffer_view, is_storage_reference, list));
+  }
+  if (!tensor_name.empty() && tensors.count(tensor_name) == 0) {
+    return iree_make_status(IREE_STATUS_NOT_FOUND,
+                            "tensor '%s' not found", tensor_name.c_str());
+  }
+  return OkStatus();
+}
+
+// Loads the inputs from the file referenced by |file_spec|:
+//   path.npy: the array in the file
+//   path.safetensors: all tensors in the file ordered by name
+//   path.safetensors:name: the tensor |name| in the file
+Status LoadFileInputs(iree_hal_allocator_t* allocator,
+                      iree_string_view_t file_spec, bool is_storage_reference,
+                      iree_vm_list_t* list) {
+  std::string path(file_spec.data, file_spec.size);
+  std::string tensor_name;
+  size_t extension_pos = path.rfind(".safetensors");
+  bool is_safetensors = extension_pos != std::string::npos;
+  if (is_safetensors) {
+    size_t suffix_pos = extension_pos + strlen(".safetensors");
+    if (suffix_pos < path.size() && path[suffix_pos] == ':') {
+      tensor_name = path.substr(suffix_pos + 1);
+      path.resize(suffix_pos);
+    } else if (suffix_pos != path.size()) {
+      is_safetensors = false;
+    }
+  }
+
+  MappedFile* file = nullptr;
+  IREE_RETURN_IF_ERROR(MappedFile::Open(path.c_str(), &file));
+  Status status =
+      is_safetensors
+          ? LoadSafetensorsFile(allocator, file, tensor_name,
+                                is_storage_reference, list)
+          : LoadNpyFile(allocator, file, is_storage_reference, list);
+  file->Release();
+  IREE_RETURN_IF_ERROR(status.release(), "loading '%s'", path.c_str());
+  return OkStatus();
+}
+
+// Returns the NPY array-protocol type string for |element_type|.
+bool FormatNpyDescr(iree_hal_element_type_t element_type,
+                    std::string* out_descr) {
+  if (!iree_hal_element_is_byte_aligned(element_type)) return false;
+  size_t byte_count = iree_hal_element_dense_byte_count(element_type);
+  if (byte_count != 1 && byte_count != 2 && byte_count != 4 &&
+      byte_count != 8) {
+    return false;
+  }
+  char kind;
+  switch (iree_hal_element_numerical_type(element_type)) {
+    case IREE_HAL_NUMERICAL_TYPE_FLOAT_IEEE:
+      if (byte_count == 1) return false;
+      kind = 'f';
+      break;
+    case IREE_HAL_NUMERICAL_TYPE_INTEGER:
+    case IREE_HAL_NUMERICAL_TYPE_INTEGER_SIGNED:
+      kind = 'i';
+      break;
+    case IREE_HAL_NUMERICAL_TYPE_INTEGER_UNSIGNED:
+      kind = 'u';
+      break;
+    default:
+      return false;
+  }
+  *out_descr = std::string(byte_count == 1 ? "|" : "<") + kind +
+               std::to_string(byte_count);
+  return true;
+}
+
+}  // namespace
+
 Status ParseToVariantList(iree_hal_allocator_t* allocator,
                           iree::span<const std::string> input_strings,
                           iree_vm_list_t** out_list) {
@@ -79,6 +693,17 @@ Status ParseToVariantList(iree_hal_allocator_t* allocator,
   for (size_t i = 0; i < input_strings.size(); ++i) {
     iree_string_view_t input_view = iree_string_view_trim(iree_make_string_view(
         input_strings[i].data(), input_strings[i].size()));
+    iree_string_view_t file_view = input_view;
+    bool is_file_storage_reference = iree_string_view_consume_prefix(
+        &file_view, iree_make_cstring_view("&"));
+    if (iree_string_view_consume_prefix(&file_view,
+                                        iree_make_cstring_view("@"))) {
+      // Binary file containing one or more buffers.
+      IREE_RETURN_IF_ERROR(LoadFileInputs(allocator, file_view,
+                                          is_file_storage_reference,
+                                          variant_list.get()));
+      continue;
+    }
     bool has_equal =
         iree_string_view_find_char(input_view, '=', 0) != IREE_STRING_VIEW_NPOS;
     bool has_x =
@@ -91,20 +716,11 @@ Status ParseToVariantList(iree_hal_allocator_t* allocator,
       IREE_RETURN_IF_ERROR(
           iree_hal_buffer_view_parse(input_view, allocator, &buffer_view),
           "parsing value '%.*s'", (int)input_view.size, input_view.data);
-      if (is_storage_reference) {
-        // Storage buffer reference; just take the storage for the buffer view -
-        // it'll still have whatever contents were specified (or 0) but we'll
-        // discard the metadata.
-        auto buffer_ref = iree_hal_buffer_retain_ref(
-            iree_hal_buffer_view_buffer(buffer_view));
-        iree_hal_buffer_view_release(buffer_view);
-        IREE_RETURN_IF_ERROR(
-            iree_vm_list_push_ref_move(variant_list.get(), &buffer_ref));
-      } else {
-        auto buffer_view_ref = iree_hal_buffer_view_move_ref(buffer_view);
-        IREE_RETURN_IF_ERROR(
-            iree_vm_list_push_ref_move(variant_list.get(), &buffer_view_ref));
-      }
+      // Storage buffer references just take the storage for the buffer view -
+      // it'll still have whatever contents were specified (or 0) but we'll
+      // discard the metadata.
+      IREE_RETURN_IF_ERROR(PushBufferView(buffer_view, is_storage_reference,
+                                          variant_list.get()));
     } else {
       // Scalar.
       bool has_dot = iree_string_view_find_char(input_view, '.', 0) !=
@@ -134,64 +750,166 @@ Status ParseToVariantList(iree_hal_allocator_t* allocator,
   return OkStatus();
 }
 
+namespace {
+
+// Prints result |i| of a variant list.
+Status PrintVariant(iree_host_size_t i, iree_vm_variant_t variant,
+                    size_t max_element_count, std::ostream* os) {
+  *os << "result[" << i << "]: ";
+  if (iree_vm_variant_is_value(variant)) {
+    switch (variant.type.value_type) {
+      case IREE_VM_VALUE_TYPE_I8:
+        *os << "i8=" << variant.i8 << "\n";
+        break;
+      case IREE_VM_VALUE_TYPE_I16:
+        *os << "i16=" << variant.i16 << "\n";
+        break;
+      case IREE_VM_VALUE_TYPE_I32:
+        *os << "i32=" << variant.i32 << "\n";
+        break;
+      case IREE_VM_VALUE_TYPE_I64:
+        *os << "i64=" << variant.i64 << "\n";
+        break;
+      case IREE_VM_VALUE_TYPE_F32:
+        *os << "f32=" << variant.f32 << "\n";
+        break;
+      case IREE_VM_VALUE_TYPE_F64:
+        *os << "f64=" << variant.f64 << "\n";
+        break;
+      default:
+        *os << "?\n";
+        break;
+    }
+  } else if (iree_vm_variant_is_ref(variant)) {
+    iree_string_view_t type_name = iree_vm_ref_type_name(variant.type.ref_type);
+    *os << std::string(type_name.data, type_name.size) << "\n";
+    if (iree_hal_buffer_view_isa(variant.ref)) {
+      auto* buffer_view = iree_hal_buffer_view_deref(variant.ref);
+      std::string result_str(4096, '\0');
+      iree_status_t status;
+      do {
+        iree_host_size_t actual_length = 0;
+        status = iree_hal_buffer_view_format(buffer_view, max_element_count,
+                                             result_str.size() + 1,
+                                             &result_str[0], &actual_length);
+        result_str.resize(actual_length);
+      } while (iree_status_is_out_of_range(status));
+      IREE_RETURN_IF_ERROR(status);
+      *os << result_str << "\n";
+    } else {
+      // TODO(benvanik): a way for ref types to describe themselves.
+      *os << "(no printer)\n";
+    }
+  } else {
+    *os << "(null)\n";
+  }
+  return OkStatus();
+}
+
+}  // namespace
+
 Status PrintVariantList(iree_vm_list_t* variant_list, size_t max_element_count,
                         std::ostream* os) {
   for (iree_host_size_t i = 0; i < iree_vm_list_size(variant_list); ++i) {
     iree_vm_variant_t variant = iree_vm_variant_empty();
     IREE_RETURN_IF_ERROR(iree_vm_list_get_variant(variant_list, i, &variant),
                          "variant %zu not present", i);
+    IREE_RETURN_IF_ERROR(PrintVariant(i, variant, max_element_count, os));
+  }
+  return OkStatus();
+}
 
-    *os << "result[" << i << "]: ";
-    if (iree_vm_variant_is_value(variant)) {
-      switch (variant.type.value_type) {
-        case IREE_VM_VALUE_TYPE_I8:
-          *os << "i8=" << variant.i8 << "\n";
-          break;
-        case IREE_VM_VALUE_TYPE_I16:
-          *os << "i16=" << variant.i16 << "\n";
-          break;
-        case IREE_VM_VALUE_TYPE_I32:
-          *os << "i32=" << variant.i32 << "\n";
-          break;
-        case IREE_VM_VALUE_TYPE_I64:
-          *os << "i64=" << variant.i64 << "\n";
-          break;
-        case IREE_VM_VALUE_TYPE_F32:
-          *os << "f32=" << variant.f32 << "\n";
-          break;
-        case IREE_VM_VALUE_TYPE_F64:
-          *os << "f64=" << variant.f64 << "\n";
-          break;
-        default:
-          *os << "?\n";
-          break;
-      }
-    } else if (iree_vm_variant_is_ref(variant)) {
-      iree_string_view_t type_name =
-          iree_vm_ref_type_name(variant.type.ref_type);
-      *os << std::string(type_name.data, type_name.size) << "\n";
-      if (iree_hal_buffer_view_isa(variant.ref)) {
-        auto* buffer_view = iree_hal_buffer_view_deref(variant.ref);
-        std::string result_str(4096, '\0');
-        iree_status_t status;
-        do {
-          iree_host_size_t actual_length = 0;
-          status = iree_hal_buffer_view_format(buffer_view, max_element_count,
-                                               result_str.size() + 1,
-                                               &result_str[0], &actual_length);
-          result_str.resize(actual_length);
-        } while (iree_status_is_out_of_range(status));
-        IREE_RETURN_IF_ERROR(status);
-        *os << result_str << "\n";
-      } else {
-        // TODO(benvanik): a way for ref types to describe themselves.
-        *os << "(no printer)\n";
-      }
-    } else {
-      *os << "(null)\n";
-    }
+Status WriteBufferViewToNpyFile(iree_hal_buffer_view_t* buffer_view,
+                                const char* path) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  std::string descr;
+  if (!FormatNpyDescr(iree_hal_buffer_view_element_type(buffer_view),
+                      &descr)) {
+    IREE_TRACE_ZONE_END(z0);
+    return iree_make_status(IREE_STATUS_UNIMPLEMENTED,
+                            "element type %08X has no NPY equivalent",
+                            iree_hal_buffer_view_element_type(buffer_view));
+  }
+  std::string header = "{'descr': '" + descr +
+                       "', 'fortran_order': False, 'shape': (";
+  iree_host_size_t rank = iree_hal_buffer_view_shape_rank(buffer_view);
+  for (iree_host_size_t i = 0; i < rank; ++i) {
+    if (i > 0) header += ", ";
+    header += std::to_string(iree_hal_buffer_view_shape_dim(buffer_view, i));
+  }
+  // Python tuples of one element require a trailing comma.
+  if (rank == 1) header += ",";
+  header += "), }";
+  // The header is padded with spaces and terminated with a newline such that
+  // the data that follows is 64 byte aligned.
+  constexpr size_t kPreambleLength = 10;
+  size_t padded_length =
+      iree_host_align(kPreambleLength + header.size() + 1, 64) -
+      kPreambleLength;
+  header.resize(padded_length - 1, ' ');
+  header += '\n';
+  uint8_t preamble[kPreambleLength] = {
+      0x93, 'N', 'U', 'M', 'P', 'Y', 1, 0,
+      (uint8_t)(padded_length & 0xFF), (uint8_t)(padded_length >> 8),
+  };
+
+  iree_hal_buffer_mapping_t mapping;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_hal_buffer_map_range(
+              iree_hal_buffer_view_buffer(buffer_view),
+              IREE_HAL_MAPPING_MODE_SCOPED, IREE_HAL_MEMORY_ACCESS_READ, 0,
+              iree_hal_buffer_view_byte_length(buffer_view), &mapping));
+  iree_status_t status = iree_ok_status();
+  FILE* file = fopen(path, "wb");
+  if (file == NULL) {
+    status = iree_make_status(iree_status_code_from_errno(errno),
+                              "failed to open file '%s'", path);
   }
+  if (iree_status_is_ok(status) &&
+      (fwrite(preamble, sizeof(preamble), 1, file) != 1 ||
+       fwrite(header.data(), header.size(), 1, file) != 1 ||
+       (mapping.contents.data_length > 0 &&
+        fwrite(mapping.contents.data, mapping.contents.data_length, 1, file) !=
+            1))) {
+    status = iree_make_status(iree_status_code_from_errno(errno),
+                              "unable to write file contents of '%s'", path);
+  }
+  if (file) fclose(file);
+  iree_status_ignore(iree_hal_buffer_unmap_range(&mapping));
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
 
+Status OutputVariantList(iree_vm_list_t* variant_list,
+                         iree::span<const std::string> output_specs,
+                         size_t max_element_count, std::ostream* os) {
+  for (iree_host_size_t i = 0; i < iree_vm_list_size(variant_list); ++i) {
+    iree_vm_variant_t variant = iree_vm_variant_empty();
+    IREE_RETURN_IF_ERROR(iree_vm_list_get_variant(variant_list, i, &variant),
+                         "variant %zu not present", i);
+    iree_string_view_t output_spec = iree_string_view_empty();
+    if (i < output_specs.size()) {
+      output_spec = iree_string_view_trim(iree_make_string_view(
+          output_specs[i].data(), output_specs[i].size()));
+    }
+    if (!iree_string_view_consume_prefix(&output_spec, IREE_SV("@"))) {
+      IREE_RETURN_IF_ERROR(PrintVariant(i, variant, max_element_count, os));
+      continue;
+    }
+    std::string path(output_spec.data, output_spec.size);
+    if (!iree_vm_variant_is_ref(variant) ||
+        !iree_hal_buffer_view_isa(variant.ref)) {
+      return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                              "result[%zu] is not a buffer view and cannot be "
+                              "written to '%s'",
+                              i, path.c_str());
+    }
+    IREE_RETURN_IF_ERROR(
+        WriteBufferViewToNpyFile(iree_hal_buffer_view_deref(variant.ref),
+                                 path.c_str()),
+        "writing result[%zu]", i);
+    *os << "result[" << i << "]: written to " << path << "\n";
+  }
   return OkStatus();
 }
 
@@ -31,6 +31,14 @@ Status GetFileContents(const char* path, std::string* out_contents);
 // Buffers should be in the IREE standard shaped buffer format:
 //   [shape]xtype=[value]
 // described in iree/hal/api.h
+// Buffers may also be loaded from binary files with a leading `@`:
+//   @path.npy: the array stored in a NumPy NPY file
+//   @path.safetensors: all tensors in a safetensors file ordered by name
+//   @path.safetensors:name: the tensor |name| in a safetensors file
+// Files are memory-mapped and the buffers alias the mapping without a copy
+// when the allocator can import host memory and the data is 64-byte aligned.
+// Such buffers are read-only; storage references (`&@path.npy`) are always
+// copied so that they can be written.
 // Uses |allocator| to allocate the buffers.
 // Uses descriptors in |descs| for type information and validation.
 // The returned variant list must be freed by the caller.
@@ -56,6 +64,19 @@ inline Status PrintVariantList(iree_vm_list_t* variant_list,
   return PrintVariantList(variant_list, max_element_count, &std::cout);
 }
 
+// Writes |buffer_view| to |path| as a NumPy NPY file. The buffer contents are
+// mapped and written as-is without any formatting.
+Status WriteBufferViewToNpyFile(iree_hal_buffer_view_t* buffer_view,
+                                const char* path);
+
+// Outputs a variant list as with PrintVariantList except that results whose
+// corresponding entry in |output_specs| is of the form `@path.npy` are written
+// to that file with WriteBufferViewToNpyFile instead of being printed. Results
+// without an entry (or with any other entry, such as `-`) are printed.
+Status OutputVariantList(iree_vm_list_t* variant_list,
+                         iree::span<const std::string> output_specs,
+                         size_t max_element_count, std::ostream* os);
+
 // Creates the default device for |driver| in |out_device|.
 // The returned |out_device| must be released by the caller.
 Status CreateDevice(const char* driver_name, iree_hal_device_t** out_device);
@@ -6,7 +6,12 @@
 
 #include "iree/tools/utils/vm_util.h"
 
+#include <cstdlib>
+#include <cstring>
+
 #include "iree/base/api.h"
+#include "iree/base/internal/file_io.h"
+#include "iree/base/logging.h"
 #include "iree/hal/api.h"
 #include "iree/hal/vmvx/registration/driver_module.h"
 #include "iree/modules/hal/module.h"
@@ -18,6 +23,18 @@
 namespace iree {
 namespace {
 
+std::string GetUniquePath(const char* unique_name) {
+  char* test_tmpdir = getenv("TEST_TMPDIR");
+  if (!test_tmpdir) {
+    test_tmpdir = getenv("TMPDIR");
+  }
+  if (!test_tmpdir) {
+    test_tmpdir = getenv("TEMP");
+  }
+  IREE_CHECK(test_tmpdir) << "TEST_TMPDIR/TMPDIR/TEMP not defined";
+  return test_tmpdir + std::string("/iree_vm_util_test_") + unique_name;
+}
+
 class VmUtilTest : public ::testing::Test {
  protected:
   static void SetUpTestSuite() {
@@ -95,5 +112,56 @@ TEST_F(VmUtilTest, ParsePrintMultipleBufferViews) {
                           buf_string2 + "\n");
 }
 
+TEST_F(VmUtilTest, WriteParseNpyBufferView) {
+  std::string buf_string = "2x2xi32=[42 43][44 45]";
+  vm::ref<iree_vm_list_t> variant_list;
+  IREE_ASSERT_OK(ParseToVariantList(
+      allocator_, std::vector<std::string>{buf_string}, &variant_list));
+  auto path = GetUniquePath("WriteParseNpyBufferView.npy");
+  IREE_ASSERT_OK(OutputVariantList(variant_list.get(),
+                                   std::vector<std::string>{"@" + path},
+                                   /*max_element_count=*/1024, &std::cout));
+
+  vm::ref<iree_vm_list_t> file_list;
+  IREE_ASSERT_OK(ParseToVariantList(
+      allocator_, std::vector<std::string>{"@" + path}, &file_list));
+  std::stringstream os;
+  IREE_ASSERT_OK(PrintVariantList(file_list.get(), &os));
+  EXPECT_EQ(os.str(),
+            std::string("result[0]: hal.buffer_view\n") + buf_string + "\n");
+}
+
+TEST_F(VmUtilTest, ParseSafetensors) {
+  // Tensors are listed out of order and must be returned ordered by name.
+  std::string header =
+      "{\"b\":{\"dtype\":\"F32\",\"shape\":[2],\"data_offsets\":[0,8]},"
+      "\"__metadata__\":{\"format\":\"pt\"},"
+      "\"a\":{\"dtype\":\"I32\",\"shape\":[],\"data_offsets\":[8,12]}}";
+  std::string contents(8, '\0');
+  for (int i = 0; i < 8; ++i) {
+    contents[i] = (char)((uint64_t)header.size() >> (i * 8));
+  }
+  contents += header;
+  const float b_data[2] = {1.0f, 2.0f};
+  const int32_t a_data = 7;
+  contents.append((const char*)b_data, sizeof(b_data));
+  contents.append((const char*)&a_data, sizeof(a_data));
+  auto path = GetUniquePath("ParseSafetensors.safetensors");
+  IREE_ASSERT_OK(iree_file_write_contents(
+      path.c_str(),
+      iree_make_const_byte_span(contents.data(), contents.size())));
+
+  vm::ref<iree_vm_list_t> variant_list;
+  IREE_ASSERT_OK(ParseToVariantList(
+      allocator_, std::vector<std::string>{"@" + path, "@" + path + ":b"},
+      &variant_list));
+  std::stringstream os;
+  IREE_ASSERT_OK(PrintVariantList(variant_list.get(), &os));
+  EXPECT_EQ(os.str(),
+            "result[0]: hal.buffer_view\ni32=7\n"
+            "result[1]: hal.buffer_view\n2xf32=1 2\n"
+            "result[2]: hal.buffer_view\n2xf32=1 2\n");
+}
+
 }  // namespace
 }  // namespace iree
@@ -17,6 +17,7 @@
 #include "iree/vm/module.h"         // IWYU pragma: export
 #include "iree/vm/native_module.h"  // IWYU pragma: export
 #include "iree/vm/ref.h"            // IWYU pragma: export
+#include "iree/vm/sampler.h"        // IWYU pragma: export
 #include "iree/vm/shims.h"          // IWYU pragma: export
 #include "iree/vm/stack.h"          // IWYU pragma: export
 #include "iree/vm/type_def.h"       // IWYU pragma: export
@@ -224,47 +224,62 @@ IREE_API_EXPORT iree_status_t iree_vm_buffer_fill_bytes(
                                       &value);
 }
 
+// Fills |target| with repeated copies of the |pattern_length| byte |pattern|.
+// |target_length| must be a multiple of |pattern_length|.
+//
+// Patterns made of a single repeated byte (such as 0 or -1) are filled with
+// memset. Other patterns are written once and then doubled with memcpy so
+// that large fills use the platform's vectorized bulk copy instead of a
+// per-element loop.
+static void iree_vm_buffer_fill_pattern(uint8_t* target,
+                                        iree_host_size_t target_length,
+                                        const uint8_t* pattern,
+                                        iree_host_size_t pattern_length) {
+  if (!target_length) return;
+  bool is_byte_splat = true;
+  for (iree_host_size_t i = 1; i < pattern_length; ++i) {
+    if (pattern[i] != pattern[0]) {
+      is_byte_splat = false;
+      break;
+    }
+  }
+  if (is_byte_splat) {
+    memset(target, pattern[0], target_length);
+    return;
+  }
+  memcpy(target, pattern, pattern_length);
+  iree_host_size_t filled_length = pattern_length;
+  while (filled_length < target_length) {
+    iree_host_size_t chunk_length =
+        iree_min(filled_length, target_length - filled_length);
+    memcpy(target + filled_length, target, chunk_length);
+    filled_length += chunk_length;
+  }
+}
+
 IREE_API_EXPORT iree_status_t iree_vm_buffer_fill_elements(
     const iree_vm_buffer_t* target_buffer, iree_host_size_t target_offset,
     iree_host_size_t element_count, iree_host_size_t element_length,
     const void* value) {
   IREE_ASSERT_ARGUMENT(target_buffer);
-  iree_byte_span_t span;
-  IREE_RETURN_IF_ERROR(iree_vm_buffer_map_rw(target_buffer, target_offset,
-                                             element_count * element_length,
-                                             element_length, &span));
   switch (element_length) {
-    case 1: {
-      const uint8_t pattern_value = *(const uint8_t*)value;
-      memset(span.data, pattern_value, span.data_length);
-    } break;
-    case 2: {
-      const uint16_t pattern_value = *(const uint16_t*)value;
-      uint16_t* target_ptr = (uint16_t*)span.data;
-      for (iree_host_size_t i = 0; i < element_count; ++i) {
-        target_ptr[i] = pattern_value;
-      }
-    } break;
-    case 4: {
-      const uint32_t pattern_value = *(const uint32_t*)value;
-      uint32_t* target_ptr = (uint32_t*)span.data;
-      for (iree_host_size_t i = 0; i < element_count; ++i) {
-        target_ptr[i] = pattern_value;
-      }
-    } break;
-    case 8: {
-      const uint64_t pattern_value = *(const uint64_t*)value;
-      uint64_t* target_ptr = (uint64_t*)span.data;
-      for (iree_host_size_t i = 0; i < element_count; ++i) {
-        target_ptr[i] = pattern_value;
-      }
-    } break;
+    case 1:
+    case 2:
+    case 4:
+    case 8:
+      break;
     default:
       return iree_make_status(
           IREE_STATUS_INVALID_ARGUMENT,
           "invalid element length %d; expected one of [1, 2, 4, 8]",
           (int)element_length);
   }
+  iree_byte_span_t span;
+  IREE_RETURN_IF_ERROR(iree_vm_buffer_map_rw(target_buffer, target_offset,
+                                             element_count * element_length,
+                                             element_length, &span));
+  iree_vm_buffer_fill_pattern(span.data, span.data_length,
+                              (const uint8_t*)value, element_length);
   return iree_ok_status();
 }
 
@@ -48,4 +48,28 @@ TEST_F(VMBufferTest, Initialize) {
   ASSERT_TRUE(did_free);
 }
 
+// Tests filling with patterns that are and are not a single repeated byte.
+TEST_F(VMBufferTest, FillElements) {
+  uint32_t data[7] = {0};
+  iree_vm_buffer_t buffer;
+  iree_vm_buffer_initialize(
+      IREE_VM_BUFFER_ACCESS_MUTABLE | IREE_VM_BUFFER_ACCESS_ORIGIN_HOST,
+      iree_make_byte_span(data, sizeof(data)), iree_allocator_null(), &buffer);
+
+  uint32_t splat_value = 0xABABABABu;
+  IREE_CHECK_OK(iree_vm_buffer_fill_elements(
+      &buffer, 0, IREE_ARRAYSIZE(data), sizeof(splat_value), &splat_value));
+  for (uint32_t value : data) EXPECT_EQ(splat_value, value);
+
+  uint32_t pattern_value = 0x01020304u;
+  IREE_CHECK_OK(iree_vm_buffer_fill_elements(&buffer, sizeof(uint32_t), 5,
+                                             sizeof(pattern_value),
+                                             &pattern_value));
+  EXPECT_EQ(splat_value, data[0]);
+  for (int i = 1; i < 6; ++i) EXPECT_EQ(pattern_value, data[i]);
+  EXPECT_EQ(splat_value, data[6]);
+
+  iree_vm_buffer_deinitialize(&buffer);
+}
+
 }  // namespace
@@ -111,6 +111,8 @@ static iree_status_t iree_vm_bytecode_function_enter(
     return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
                             "import ordinal out of range");
   }
+  IREE_RETURN_IF_ERROR(
+      iree_vm_bytecode_module_verify_function(module, function.ordinal));
   const iree_vm_FunctionDescriptor_t* target_descriptor =
       &module->function_descriptor_table[function.ordinal];
 
@@ -461,10 +463,70 @@ static void iree_vm_bytecode_populate_import_cconv_arguments(
   }
 }
 
+// Populates fixed signature import call arguments using the marshaling plan
+// precomputed when the import was resolved. Unlike the cconv path this writes
+// every byte of |storage| and it need not be zeroed.
+static void iree_vm_bytecode_populate_import_fixed_arguments(
+    const iree_vm_bytecode_import_t* IREE_RESTRICT import,
+    const iree_vm_registers_t caller_registers,
+    const iree_vm_register_list_t* IREE_RESTRICT src_reg_list,
+    iree_byte_span_t storage) {
+  uint8_t* IREE_RESTRICT p = storage.data;
+  for (uint8_t i = 0; i < import->argument_count; ++i) {
+    uint16_t src_reg = src_reg_list->registers[i];
+    uint32_t value_bit = 1u << i;
+    if (import->argument_ref_mask & value_bit) {
+      // Refs are borrowed by the callee and not retained.
+      memcpy(p, &caller_registers.ref[src_reg & caller_registers.ref_mask],
+             sizeof(iree_vm_ref_t));
+      p += sizeof(iree_vm_ref_t);
+    } else if (import->argument_i64_mask & value_bit) {
+      memcpy(p,
+             &caller_registers.i32[src_reg & (caller_registers.i32_mask & ~1)],
+             sizeof(int64_t));
+      p += sizeof(int64_t);
+    } else {
+      memcpy(p, &caller_registers.i32[src_reg & caller_registers.i32_mask],
+             sizeof(int32_t));
+      p += sizeof(int32_t);
+    }
+  }
+}
+
+// Marshals fixed signature import call results from |storage| into
+// |dst_reg_list| using the marshaling plan precomputed when the import was
+// resolved.
+static void iree_vm_bytecode_marshal_import_fixed_results(
+    const iree_vm_bytecode_import_t* IREE_RESTRICT import,
+    iree_byte_span_t storage,
+    const iree_vm_register_list_t* IREE_RESTRICT dst_reg_list,
+    const iree_vm_registers_t caller_registers) {
+  uint8_t* IREE_RESTRICT p = storage.data;
+  for (uint8_t i = 0; i < import->result_count && i < dst_reg_list->size;
+       ++i) {
+    uint16_t dst_reg = dst_reg_list->registers[i];
+    uint32_t value_bit = 1u << i;
+    if (import->result_ref_mask & value_bit) {
+      iree_vm_ref_move(
+          (iree_vm_ref_t*)p,
+          &caller_registers.ref[dst_reg & caller_registers.ref_mask]);
+      p += sizeof(iree_vm_ref_t);
+    } else if (import->result_i64_mask & value_bit) {
+      memcpy(&caller_registers.i32[dst_reg & (caller_registers.i32_mask & ~1)],
+             p, sizeof(int64_t));
+      p += sizeof(int64_t);
+    } else {
+      memcpy(&caller_registers.i32[dst_reg & caller_registers.i32_mask], p,
+             sizeof(int32_t));
+      p += sizeof(int32_t);
+    }
+  }
+}
+
 // Issues a populated import call and marshals the results into |dst_reg_list|.
 static iree_status_t iree_vm_bytecode_issue_import_call(
     iree_vm_stack_t* stack, const iree_vm_function_call_t call,
-    iree_string_view_t cconv_results,
+    const iree_vm_bytecode_import_t* IREE_RESTRICT import,
     const iree_vm_register_list_t* IREE_RESTRICT dst_reg_list,
     iree_vm_stack_frame_t** out_caller_frame,
     iree_vm_registers_t* out_caller_registers,
@@ -485,8 +547,24 @@ static iree_status_t iree_vm_bytecode_issue_import_call(
   *out_caller_registers =
       iree_vm_bytecode_get_register_storage(*out_caller_frame);
 
+#if IREE_VM_EXECUTION_SAMPLING_ENABLE
+  // Imports are where most of the time in host code is spent and any elapsed
+  // time is attributed to the import at its call site.
+  iree_vm_sampler_t* sampler = iree_vm_stack_sampler(stack);
+  if (IREE_UNLIKELY(sampler)) {
+    iree_vm_sampler_tick(sampler, stack, &call.function);
+  }
+#endif  // IREE_VM_EXECUTION_SAMPLING_ENABLE
+
   // Marshal outputs from the ABI results buffer to registers.
   iree_vm_registers_t caller_registers = *out_caller_registers;
+  if (IREE_LIKELY(import->has_fixed_results)) {
+    iree_vm_bytecode_marshal_import_fixed_results(import, call.results,
+                                                  dst_reg_list,
+                                                  caller_registers);
+    return iree_ok_status();
+  }
+  iree_string_view_t cconv_results = import->results;
   uint8_t* IREE_RESTRICT p = call.results.data;
   for (iree_host_size_t i = 0; i < cconv_results.size && i < dst_reg_list->size;
        ++i) {
@@ -545,17 +623,22 @@ static iree_status_t iree_vm_bytecode_call_import(
   // Marshal inputs from registers to the ABI arguments buffer.
   call.arguments.data_length = import->argument_buffer_size;
   call.arguments.data = iree_alloca(call.arguments.data_length);
-  memset(call.arguments.data, 0, call.arguments.data_length);
-  iree_vm_bytecode_populate_import_cconv_arguments(
-      import->arguments, caller_registers,
-      /*segment_size_list=*/NULL, src_reg_list, call.arguments);
+  if (IREE_LIKELY(import->has_fixed_arguments)) {
+    iree_vm_bytecode_populate_import_fixed_arguments(
+        import, caller_registers, src_reg_list, call.arguments);
+  } else {
+    memset(call.arguments.data, 0, call.arguments.data_length);
+    iree_vm_bytecode_populate_import_cconv_arguments(
+        import->arguments, caller_registers,
+        /*segment_size_list=*/NULL, src_reg_list, call.arguments);
+  }
 
   // Issue the call and handle results.
   call.results.data_length = import->result_buffer_size;
   call.results.data = iree_alloca(call.results.data_length);
   memset(call.results.data, 0, call.results.data_length);
-  return iree_vm_bytecode_issue_import_call(stack, call, import->results,
-                                            dst_reg_list, out_caller_frame,
+  return iree_vm_bytecode_issue_import_call(stack, call, import, dst_reg_list,
+                                            out_caller_frame,
                                             out_caller_registers, out_result);
 }
 
@@ -599,8 +682,8 @@ static iree_status_t iree_vm_bytecode_call_import_variadic(
   call.results.data_length = import->result_buffer_size;
   call.results.data = iree_alloca(call.results.data_length);
   memset(call.results.data, 0, call.results.data_length);
-  return iree_vm_bytecode_issue_import_call(stack, call, import->results,
-                                            dst_reg_list, out_caller_frame,
+  return iree_vm_bytecode_issue_import_call(stack, call, import, dst_reg_list,
+                                            out_caller_frame,
                                             out_caller_registers, out_result);
 }
 
@@ -643,6 +726,10 @@ iree_status_t iree_vm_bytecode_dispatch(
   iree_vm_source_offset_t pc = current_frame->pc;
   const int32_t entry_frame_depth = current_frame->depth;
 
+#if IREE_VM_EXECUTION_SAMPLING_ENABLE
+  iree_vm_sampler_t* sampler = iree_vm_stack_sampler(stack);
+#endif  // IREE_VM_EXECUTION_SAMPLING_ENABLE
+
   BEGIN_DISPATCH_CORE() {
     //===------------------------------------------------------------------===//
     // Globals
@@ -1367,6 +1454,7 @@ iree_status_t iree_vm_bytecode_dispatch(
       int32_t block_pc = VM_DecBranchTarget("dest");
       const iree_vm_register_remap_list_t* remap_list =
           VM_DecBranchOperands("operands");
+      IREE_DISPATCH_SAMPLE();
       pc = block_pc;
       iree_vm_bytecode_dispatch_remap_branch_registers(regs, remap_list);
     });
@@ -1379,6 +1467,7 @@ iree_status_t iree_vm_bytecode_dispatch(
       int32_t false_block_pc = VM_DecBranchTarget("false_dest");
       const iree_vm_register_remap_list_t* false_remap_list =
           VM_DecBranchOperands("false_operands");
+      IREE_DISPATCH_SAMPLE();
       if (condition) {
         pc = true_block_pc;
         iree_vm_bytecode_dispatch_remap_branch_registers(regs, true_remap_list);
@@ -1389,6 +1478,36 @@ iree_status_t iree_vm_bytecode_dispatch(
       }
     });
 
+    // Fused compare-and-branch superinstructions emitted by the compiler in
+    // place of a comparison whose result is only used by the vm.cond_br
+    // following it. The comparison result is never materialized.
+#define DISPATCH_OP_CORE_COND_BRANCH_CMP_I32(op_name, op_func)            \
+  DISPATCH_OP(CORE, op_name, {                                            \
+    int32_t lhs = VM_DecOperandRegI32("lhs");                             \
+    int32_t rhs = VM_DecOperandRegI32("rhs");                             \
+    int32_t true_block_pc = VM_DecBranchTarget("true_dest");              \
+    const iree_vm_register_remap_list_t* true_remap_list =                \
+        VM_DecBranchOperands("true_operands");                            \
+    int32_t false_block_pc = VM_DecBranchTarget("false_dest");            \
+    const iree_vm_register_remap_list_t* false_remap_list =               \
+        VM_DecBranchOperands("false_operands");                           \
+    IREE_DISPATCH_SAMPLE();                                               \
+    if (op_func(lhs, rhs)) {                                              \
+      pc = true_block_pc;                                                 \
+      iree_vm_bytecode_dispatch_remap_branch_registers(regs,              \
+                                                       true_remap_list);  \
+    } else {                                                              \
+      pc = false_block_pc;                                                \
+      iree_vm_bytecode_dispatch_remap_branch_registers(regs,              \
+                                                       false_remap_list); \
+    }                                                                     \
+  });
+
+    DISPATCH_OP_CORE_COND_BRANCH_CMP_I32(CondBranchEQI32, vm_cmp_eq_i32);
+    DISPATCH_OP_CORE_COND_BRANCH_CMP_I32(CondBranchNEI32, vm_cmp_ne_i32);
+    DISPATCH_OP_CORE_COND_BRANCH_CMP_I32(CondBranchLTI32S, vm_cmp_lt_i32s);
+    DISPATCH_OP_CORE_COND_BRANCH_CMP_I32(CondBranchLTI32U, vm_cmp_lt_i32u);
+
     DISPATCH_OP(CORE, Call, {
       int32_t function_ordinal = VM_DecFuncAttr("callee");
       const iree_vm_register_list_t* src_reg_list =
@@ -1408,6 +1527,7 @@ iree_status_t iree_vm_bytecode_dispatch(
       } else {
         // Switch execution to the target function and continue running in the
         // bytecode dispatcher.
+        IREE_DISPATCH_SAMPLE();
         IREE_RETURN_IF_ERROR(iree_vm_bytecode_internal_enter(
             stack, current_frame->function.module, function_ordinal,
             src_reg_list, dst_reg_list, &current_frame, &regs));
@@ -1450,6 +1570,7 @@ iree_status_t iree_vm_bytecode_dispatch(
       const iree_vm_register_list_t* src_reg_list =
           VM_DecVariadicOperands("operands");
       current_frame->pc = pc;
+      IREE_DISPATCH_SAMPLE();
 
       if (current_frame->depth <= entry_frame_depth) {
         // Return from the top-level entry frame - return back to call().
@@ -137,6 +137,18 @@ static inline const iree_vm_type_def_t* iree_vm_map_type(
 #define IREE_DISPATCH_TRACE_INSTRUCTION(...)
 #endif  // IREE_VM_EXECUTION_TRACING_ENABLE
 
+#if IREE_VM_EXECUTION_SAMPLING_ENABLE
+// Offers the sampler a chance to record the stack at the current |pc|.
+// Only used at control flow instructions to keep the overhead low.
+#define IREE_DISPATCH_SAMPLE()                             \
+  if (IREE_UNLIKELY(sampler)) {                            \
+    current_frame->pc = pc;                                \
+    iree_vm_sampler_tick(sampler, stack, /*callee=*/NULL); \
+  }
+#else
+#define IREE_DISPATCH_SAMPLE()
+#endif  // IREE_VM_EXECUTION_SAMPLING_ENABLE
+
 #if defined(IREE_COMPILER_MSVC) && !defined(IREE_COMPILER_CLANG)
 #define IREE_DISPATCH_MODE_SWITCH 1
 #else
@@ -16,7 +16,7 @@
 #include "iree/vm/bytecode_module_impl.h"
 
 // Perform an strcmp between a flatbuffers string and an IREE string view.
-static bool iree_vm_flatbuffer_strcmp(flatbuffers_string_t lhs,
+static int iree_vm_flatbuffer_strcmp(flatbuffers_string_t lhs,
                                       iree_string_view_t rhs) {
   size_t lhs_size = flatbuffers_string_len(lhs);
   int x = strncmp(lhs, rhs.data, lhs_size < rhs.size ? lhs_size : rhs.size);
@@ -196,32 +196,51 @@ static iree_status_t iree_vm_bytecode_module_flatbuffer_verify(
     }
   }
 
-  flatbuffers_uint8_vec_t bytecode_data =
-      iree_vm_BytecodeModuleDef_bytecode_data(module_def);
-  for (size_t i = 0;
-       i < iree_vm_FunctionDescriptor_vec_len(function_descriptors); ++i) {
-    iree_vm_FunctionDescriptor_struct_t function_descriptor =
-        iree_vm_FunctionDescriptor_vec_at(function_descriptors, i);
-    if (function_descriptor->bytecode_offset < 0 ||
-        function_descriptor->bytecode_offset +
-                function_descriptor->bytecode_length >
-            flatbuffers_uint8_vec_len(bytecode_data)) {
-      return iree_make_status(
-          IREE_STATUS_INVALID_ARGUMENT,
-          "functions[%zu] descriptor bytecode span out of range (0 < %d < %zu)",
-          i, function_descriptor->bytecode_offset,
-          flatbuffers_uint8_vec_len(bytecode_data));
-    }
-    if (function_descriptor->i32_register_count > IREE_I32_REGISTER_COUNT ||
-        function_descriptor->ref_register_count > IREE_REF_REGISTER_COUNT) {
-      return iree_make_status(
-          IREE_STATUS_INVALID_ARGUMENT,
-          "functions[%zu] descriptor register count out of range", i);
-    }
+  if (iree_vm_ExportFunctionDef_vec_len(exported_functions) > UINT16_MAX) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT, "export count out of range (%zu > %u)",
+        iree_vm_ExportFunctionDef_vec_len(exported_functions), UINT16_MAX);
+  }
+  if (iree_vm_FunctionDescriptor_vec_len(function_descriptors) > UINT16_MAX) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "function descriptor count out of range (%zu > %u)",
+        iree_vm_FunctionDescriptor_vec_len(function_descriptors), UINT16_MAX);
+  }
 
-    // TODO(benvanik): run bytecode verifier on contents.
+  // NOTE: function descriptors are verified lazily on first call; see
+  // iree_vm_bytecode_module_verify_function.
+
+  return iree_ok_status();
+}
+
+iree_status_t iree_vm_bytecode_module_verify_function_slow(
+    iree_vm_bytecode_module_t* module, uint16_t function_ordinal) {
+  const iree_vm_FunctionDescriptor_t* function_descriptor =
+      &module->function_descriptor_table[function_ordinal];
+  if (function_descriptor->bytecode_offset < 0 ||
+      function_descriptor->bytecode_offset +
+              function_descriptor->bytecode_length >
+          module->bytecode_data.data_length) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "functions[%u] descriptor bytecode span out of range (0 < %d < %zu)",
+        function_ordinal, function_descriptor->bytecode_offset,
+        module->bytecode_data.data_length);
+  }
+  if (function_descriptor->i32_register_count > IREE_I32_REGISTER_COUNT ||
+      function_descriptor->ref_register_count > IREE_REF_REGISTER_COUNT) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "functions[%u] descriptor register count out of range",
+        function_ordinal);
   }
 
+  // TODO(benvanik): run bytecode verifier on contents.
+
+  iree_atomic_fetch_or_int32(
+      &module->verified_function_bits[function_ordinal / 32],
+      (int32_t)(1u << (function_ordinal % 32)), iree_memory_order_relaxed);
   return iree_ok_status();
 }
 
@@ -437,7 +456,8 @@ static iree_status_t iree_vm_bytecode_module_lookup_function(
   out_function->linkage = linkage;
   out_function->module = &module->interface;
 
-  // NOTE: we could organize imports/exports alphabetically so we could bsearch.
+  // NOTE: imports are only looked up by importing modules during resolution and
+  // are scanned linearly; exports use the index built on module creation.
   if (linkage == IREE_VM_FUNCTION_LINKAGE_IMPORT) {
     iree_vm_ImportFunctionDef_vec_t imported_functions =
         iree_vm_BytecodeModuleDef_imported_functions(module->def);
@@ -453,17 +473,25 @@ static iree_status_t iree_vm_bytecode_module_lookup_function(
       }
     }
   } else if (linkage == IREE_VM_FUNCTION_LINKAGE_EXPORT) {
+    // Binary search the exports sorted by name.
     iree_vm_ExportFunctionDef_vec_t exported_functions =
         iree_vm_BytecodeModuleDef_exported_functions(module->def);
-    for (size_t ordinal = 0;
-         ordinal < iree_vm_ExportFunctionDef_vec_len(exported_functions);
-         ++ordinal) {
+    iree_host_size_t low = 0;
+    iree_host_size_t high = module->export_count;
+    while (low < high) {
+      iree_host_size_t mid = low + (high - low) / 2;
+      uint16_t ordinal = module->sorted_export_ordinals[mid];
       iree_vm_ExportFunctionDef_table_t export_def =
           iree_vm_ExportFunctionDef_vec_at(exported_functions, ordinal);
-      if (iree_vm_flatbuffer_strcmp(
-              iree_vm_ExportFunctionDef_local_name(export_def), name) == 0) {
+      int cmp = iree_vm_flatbuffer_strcmp(
+          iree_vm_ExportFunctionDef_local_name(export_def), name);
+      if (cmp == 0) {
         out_function->ordinal = ordinal;
         return iree_ok_status();
+      } else if (cmp < 0) {
+        low = mid + 1;
+      } else {
+        high = mid;
       }
     }
   }
@@ -744,6 +772,97 @@ static void iree_vm_bytecode_module_free_state(
   IREE_TRACE_ZONE_END(z0);
 }
 
+static iree_status_t iree_vm_bytecode_module_clone_state(
+    void* self, iree_allocator_t allocator,
+    iree_vm_module_state_t* source_module_state,
+    iree_vm_module_state_t** out_module_state) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_ASSERT_ARGUMENT(source_module_state);
+  IREE_ASSERT_ARGUMENT(out_module_state);
+  *out_module_state = NULL;
+
+  iree_vm_module_state_t* module_state = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_vm_bytecode_module_alloc_state(self, allocator, &module_state));
+  iree_vm_bytecode_module_state_t* state =
+      (iree_vm_bytecode_module_state_t*)module_state;
+  iree_vm_bytecode_module_state_t* source_state =
+      (iree_vm_bytecode_module_state_t*)source_module_state;
+
+  // Primitive globals are copied such that stores in either state are not
+  // visible to the other.
+  memcpy(state->rwdata_storage.data, source_state->rwdata_storage.data,
+         state->rwdata_storage.data_length);
+
+  // Ref globals share the referenced objects with the source state. Stores to
+  // the globals replace the references in only one state but mutations made
+  // to the contents of the shared objects (such as writes into buffers) are
+  // visible to both.
+  //
+  // Rodata buffers are embedded in the state storage and references to those
+  // of the source state are remapped to the matching buffers of the new state.
+  iree_vm_buffer_t* source_rodata_begin = source_state->rodata_ref_table;
+  iree_vm_buffer_t* source_rodata_end =
+      source_rodata_begin + source_state->rodata_ref_count;
+  for (iree_host_size_t i = 0; i < state->global_ref_count; ++i) {
+    iree_vm_ref_t* source_ref = &source_state->global_ref_table[i];
+    iree_vm_buffer_t* rodata = (iree_vm_buffer_t*)source_ref->ptr;
+    if (rodata >= source_rodata_begin && rodata < source_rodata_end) {
+      iree_status_t status = iree_vm_ref_wrap_retain(
+          &state->rodata_ref_table[rodata - source_rodata_begin],
+          source_ref->type, &state->global_ref_table[i]);
+      if (!iree_status_is_ok(status)) {
+        iree_vm_bytecode_module_free_state(self, module_state);
+        IREE_TRACE_ZONE_END(z0);
+        return status;
+      }
+    } else {
+      iree_vm_ref_retain(source_ref, &state->global_ref_table[i]);
+    }
+  }
+
+  *out_module_state = module_state;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+// Computes the fixed marshaling plan of a cconv |fragment| as stored in
+// iree_vm_bytecode_import_t. Returns false if the fragment is variadic or has
+// too many values to be represented.
+static bool iree_vm_bytecode_compute_fixed_cconv_plan(
+    iree_string_view_t fragment, uint8_t* out_count, uint32_t* out_ref_mask,
+    uint32_t* out_i64_mask) {
+  *out_count = 0;
+  *out_ref_mask = 0;
+  *out_i64_mask = 0;
+  uint8_t count = 0;
+  uint32_t ref_mask = 0;
+  uint32_t i64_mask = 0;
+  for (iree_host_size_t i = 0; i < fragment.size; ++i) {
+    if (fragment.data[i] == IREE_VM_CCONV_TYPE_VOID) continue;
+    if (count >= 32) return false;
+    switch (fragment.data[i]) {
+      case IREE_VM_CCONV_TYPE_I32:
+      case IREE_VM_CCONV_TYPE_F32:
+        break;
+      case IREE_VM_CCONV_TYPE_I64:
+      case IREE_VM_CCONV_TYPE_F64:
+        i64_mask |= 1u << count;
+        break;
+      case IREE_VM_CCONV_TYPE_REF:
+        ref_mask |= 1u << count;
+        break;
+      default:
+        return false;
+    }
+    ++count;
+  }
+  *out_count = count;
+  *out_ref_mask = ref_mask;
+  *out_i64_mask = i64_mask;
+  return true;
+}
+
 static iree_status_t iree_vm_bytecode_module_resolve_import(
     void* self, iree_vm_module_state_t* module_state, iree_host_size_t ordinal,
     const iree_vm_function_t* function,
@@ -785,6 +904,15 @@ static iree_status_t iree_vm_bytecode_module_resolve_import(
   import->argument_buffer_size = (uint16_t)argument_buffer_size;
   import->result_buffer_size = (uint16_t)result_buffer_size;
 
+  // Bind fixed signatures to marshaling plans so that calls don't need to
+  // walk the calling convention per value.
+  import->has_fixed_arguments = iree_vm_bytecode_compute_fixed_cconv_plan(
+      import->arguments, &import->argument_count, &import->argument_ref_mask,
+      &import->argument_i64_mask);
+  import->has_fixed_results = iree_vm_bytecode_compute_fixed_cconv_plan(
+      import->results, &import->result_count, &import->result_ref_mask,
+      &import->result_i64_mask);
+
   return iree_ok_status();
 }
 
@@ -844,6 +972,65 @@ static iree_status_t iree_vm_bytecode_module_begin_call(
   return status;
 }
 
+// Compares the local names of exports |lhs_ordinal| and |rhs_ordinal|.
+static int iree_vm_bytecode_module_compare_exports(
+    iree_vm_ExportFunctionDef_vec_t exported_functions, uint16_t lhs_ordinal,
+    uint16_t rhs_ordinal) {
+  flatbuffers_string_t lhs_name = iree_vm_ExportFunctionDef_local_name(
+      iree_vm_ExportFunctionDef_vec_at(exported_functions, lhs_ordinal));
+  flatbuffers_string_t rhs_name = iree_vm_ExportFunctionDef_local_name(
+      iree_vm_ExportFunctionDef_vec_at(exported_functions, rhs_ordinal));
+  return iree_vm_flatbuffer_strcmp(
+      lhs_name, iree_make_string_view(rhs_name,
+                                      flatbuffers_string_len(rhs_name)));
+}
+
+// Sifts |ordinals|[|root|] down the max-heap of |count| ordinals.
+static void iree_vm_bytecode_module_sift_down_export(
+    iree_vm_ExportFunctionDef_vec_t exported_functions, uint16_t* ordinals,
+    iree_host_size_t root, iree_host_size_t count) {
+  for (iree_host_size_t child = 2 * root + 1; child < count;
+       child = 2 * root + 1) {
+    if (child + 1 < count &&
+        iree_vm_bytecode_module_compare_exports(
+            exported_functions, ordinals[child], ordinals[child + 1]) < 0) {
+      ++child;
+    }
+    if (iree_vm_bytecode_module_compare_exports(
+            exported_functions, ordinals[root], ordinals[child]) >= 0) {
+      break;
+    }
+    uint16_t temp = ordinals[root];
+    ordinals[root] = ordinals[child];
+    ordinals[child] = temp;
+    root = child;
+  }
+}
+
+// Sorts the ordinals of all |export_count| exports by their local names into
+// |out_sorted_ordinals| for binary searching in lookup_function. This is an
+// in-place heapsort as qsort does not take a context for the comparator.
+static void iree_vm_bytecode_module_sort_exports(
+    iree_vm_ExportFunctionDef_vec_t exported_functions,
+    iree_host_size_t export_count, uint16_t* out_sorted_ordinals) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  for (iree_host_size_t i = 0; i < export_count; ++i) {
+    out_sorted_ordinals[i] = (uint16_t)i;
+  }
+  for (iree_host_size_t i = export_count / 2; i > 0; --i) {
+    iree_vm_bytecode_module_sift_down_export(
+        exported_functions, out_sorted_ordinals, i - 1, export_count);
+  }
+  for (iree_host_size_t i = export_count; i > 1; --i) {
+    uint16_t temp = out_sorted_ordinals[0];
+    out_sorted_ordinals[0] = out_sorted_ordinals[i - 1];
+    out_sorted_ordinals[i - 1] = temp;
+    iree_vm_bytecode_module_sift_down_export(exported_functions,
+                                             out_sorted_ordinals, 0, i - 1);
+  }
+  IREE_TRACE_ZONE_END(z0);
+}
+
 IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_create(
     iree_const_byte_span_t flatbuffer_data,
     iree_allocator_t flatbuffer_allocator, iree_allocator_t allocator,
@@ -875,18 +1062,46 @@ IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_create(
   iree_vm_TypeDef_vec_t type_defs = iree_vm_BytecodeModuleDef_types(module_def);
   size_t type_table_size =
       iree_vm_TypeDef_vec_len(type_defs) * sizeof(iree_vm_type_def_t);
-
+  iree_vm_FunctionDescriptor_vec_t function_descriptors =
+      iree_vm_BytecodeModuleDef_function_descriptors(module_def);
+  iree_host_size_t function_descriptor_count =
+      iree_vm_FunctionDescriptor_vec_len(function_descriptors);
+  iree_host_size_t verified_function_bits_size =
+      iree_host_align(iree_host_align(function_descriptor_count, 32) / 32 *
+                          sizeof(iree_atomic_int32_t),
+                      sizeof(uint16_t));
+  iree_vm_ExportFunctionDef_vec_t exported_functions =
+      iree_vm_BytecodeModuleDef_exported_functions(module_def);
+  iree_host_size_t export_count =
+      iree_vm_ExportFunctionDef_vec_len(exported_functions);
+  iree_host_size_t sorted_export_ordinals_size =
+      export_count * sizeof(uint16_t);
+
+  // The type table is trailing the module struct and the verification bits and
+  // export index follow it in the same allocation.
+  iree_host_size_t module_size =
+      iree_host_align(sizeof(iree_vm_bytecode_module_t) + type_table_size,
+                      iree_alignof(iree_atomic_int32_t));
   iree_vm_bytecode_module_t* module = NULL;
   IREE_RETURN_AND_END_ZONE_IF_ERROR(
-      z0, iree_allocator_malloc(allocator, sizeof(*module) + type_table_size,
+      z0, iree_allocator_malloc(allocator,
+                                module_size + verified_function_bits_size +
+                                    sorted_export_ordinals_size,
                                 (void**)&module));
   module->allocator = allocator;
 
-  iree_vm_FunctionDescriptor_vec_t function_descriptors =
-      iree_vm_BytecodeModuleDef_function_descriptors(module_def);
-  module->function_descriptor_count =
-      iree_vm_FunctionDescriptor_vec_len(function_descriptors);
+  module->function_descriptor_count = function_descriptor_count;
   module->function_descriptor_table = function_descriptors;
+  module->verified_function_bits =
+      (iree_atomic_int32_t*)((uint8_t*)module + module_size);
+  memset(module->verified_function_bits, 0, verified_function_bits_size);
+
+  module->export_count = export_count;
+  module->sorted_export_ordinals =
+      (uint16_t*)((uint8_t*)module->verified_function_bits +
+                  verified_function_bits_size);
+  iree_vm_bytecode_module_sort_exports(exported_functions, export_count,
+                                       module->sorted_export_ordinals);
 
   flatbuffers_uint8_vec_t bytecode_data =
       iree_vm_BytecodeModuleDef_bytecode_data(module_def);
@@ -918,6 +1133,7 @@ IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_create(
 #endif  // IREE_VM_BACKTRACE_ENABLE
   module->interface.alloc_state = iree_vm_bytecode_module_alloc_state;
   module->interface.free_state = iree_vm_bytecode_module_free_state;
+  module->interface.clone_state = iree_vm_bytecode_module_clone_state;
   module->interface.resolve_import = iree_vm_bytecode_module_resolve_import;
   module->interface.notify = iree_vm_bytecode_module_notify;
   module->interface.begin_call = iree_vm_bytecode_module_begin_call;
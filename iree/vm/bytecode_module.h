@@ -20,6 +20,11 @@ extern "C" {
 // If a |flatbuffer_allocator| is provided then it will be used to free the
 // |flatbuffer_data| when the module is destroyed and otherwise the ownership of
 // the flatbuffer_data remains with the caller.
+//
+// |flatbuffer_data| is never written and may be read-only memory such as a
+// mapped file. Rodata segments reference it directly and the HAL module maps
+// them into device buffers with iree_hal_allocator_wrap_buffer where the device
+// can access host memory, so constants are loaded without any copies.
 IREE_API_EXPORT iree_status_t iree_vm_bytecode_module_create(
     iree_const_byte_span_t flatbuffer_data,
     iree_allocator_t flatbuffer_allocator, iree_allocator_t allocator,
@@ -259,6 +259,98 @@ static void BM_CallInternalFuncBytecode(benchmark::State& state) {
 }
 BENCHMARK(BM_CallInternalFuncBytecode);
 
+// Forwards to the system allocator and counts allocations made through it.
+static iree_status_t CountingAllocatorCtl(void* self,
+                                          iree_allocator_command_t command,
+                                          const void* params,
+                                          void** inout_ptr) {
+  if (command != IREE_ALLOCATOR_COMMAND_FREE) {
+    ++*reinterpret_cast<int64_t*>(self);
+  }
+  return iree_allocator_system_ctl(NULL, command, params, inout_ptr);
+}
+
+// Measures repeated iree_vm_invoke_with_stack_storage calls reusing the same
+// stack storage and input/output lists. Fails if any invocation after the
+// first allocates.
+static void BM_ReusedInvocationBytecode(benchmark::State& state) {
+  iree_vm_instance_t* instance = NULL;
+  IREE_CHECK_OK(iree_vm_instance_create(iree_allocator_system(), &instance));
+
+  iree_vm_module_t* import_module = NULL;
+  IREE_CHECK_OK(
+      native_import_module_create(iree_allocator_system(), &import_module));
+
+  const auto* module_file_toc =
+      iree_vm_bytecode_module_benchmark_module_create();
+  iree_vm_module_t* bytecode_module = nullptr;
+  IREE_CHECK_OK(iree_vm_bytecode_module_create(
+      iree_const_byte_span_t{
+          reinterpret_cast<const uint8_t*>(module_file_toc->data),
+          module_file_toc->size},
+      iree_allocator_null(), iree_allocator_system(), &bytecode_module));
+
+  std::array<iree_vm_module_t*, 2> modules = {import_module, bytecode_module};
+  iree_vm_context_t* context = NULL;
+  IREE_CHECK_OK(iree_vm_context_create_with_modules(
+      instance, IREE_VM_CONTEXT_FLAG_NONE, modules.data(), modules.size(),
+      iree_allocator_system(), &context));
+
+  iree_vm_function_t function;
+  IREE_CHECK_OK(iree_vm_context_resolve_function(
+      context,
+      iree_make_cstring_view("bytecode_module_benchmark.call_internal_func"),
+      &function));
+
+  iree_vm_type_def_t element_type =
+      iree_vm_type_def_make_value_type(IREE_VM_VALUE_TYPE_I32);
+  iree_host_size_t list_storage_size =
+      iree_vm_list_storage_size(&element_type, 1);
+  std::vector<uint8_t> inputs_storage(list_storage_size);
+  std::vector<uint8_t> outputs_storage(list_storage_size);
+  iree_vm_list_t* inputs = NULL;
+  IREE_CHECK_OK(iree_vm_list_initialize(
+      iree_make_byte_span(inputs_storage.data(), inputs_storage.size()),
+      &element_type, 1, &inputs));
+  iree_vm_list_t* outputs = NULL;
+  IREE_CHECK_OK(iree_vm_list_initialize(
+      iree_make_byte_span(outputs_storage.data(), outputs_storage.size()),
+      &element_type, 1, &outputs));
+  iree_vm_value_t arg0 = iree_vm_value_make_i32(100);
+  IREE_CHECK_OK(iree_vm_list_push_value(inputs, &arg0));
+
+  int64_t allocation_count = 0;
+  iree_allocator_t counting_allocator = {&allocation_count,
+                                         CountingAllocatorCtl};
+  std::vector<uint8_t> stack_storage(IREE_VM_STACK_DEFAULT_SIZE);
+  iree_host_size_t stack_storage_capacity = 0;
+  IREE_CHECK_OK(iree_vm_invoke_with_stack_storage(
+      context, function, IREE_VM_INVOCATION_FLAG_NONE, /*policy=*/NULL, inputs,
+      outputs, iree_make_byte_span(stack_storage.data(), stack_storage.size()),
+      counting_allocator, &stack_storage_capacity));
+  stack_storage.resize(stack_storage_capacity);
+  allocation_count = 0;
+
+  while (state.KeepRunning()) {
+    IREE_CHECK_OK(iree_vm_invoke_with_stack_storage(
+        context, function, IREE_VM_INVOCATION_FLAG_NONE, /*policy=*/NULL,
+        inputs, outputs,
+        iree_make_byte_span(stack_storage.data(), stack_storage.size()),
+        counting_allocator, /*out_stack_storage_capacity=*/NULL));
+  }
+  if (allocation_count != 0) {
+    state.SkipWithError("reused invocations performed heap allocations");
+  }
+
+  iree_vm_list_deinitialize(inputs);
+  iree_vm_list_deinitialize(outputs);
+  iree_vm_module_release(import_module);
+  iree_vm_module_release(bytecode_module);
+  iree_vm_context_release(context);
+  iree_vm_instance_release(instance);
+}
+BENCHMARK(BM_ReusedInvocationBytecode);
+
 static void BM_CallImportedFuncBytecode(benchmark::State& state) {
   IREE_CHECK_OK(RunFunction(
       state,
@@ -16,6 +16,7 @@
 #endif  // _MSC_VER
 
 #include "iree/base/api.h"
+#include "iree/base/internal/atomics.h"
 #include "iree/vm/api.h"
 
 // NOTE: include order matters:
@@ -54,6 +55,17 @@ typedef struct iree_vm_bytecode_module_t {
   iree_host_size_t function_descriptor_count;
   const iree_vm_FunctionDescriptor_t* function_descriptor_table;
 
+  // Bitmap with one bit per internal function indicating whether its
+  // descriptor has been verified. Functions are verified on first entry so
+  // that load time does not scale with the number of functions in the module.
+  // Bits are only ever set and verification is idempotent so racing entries
+  // from multiple threads are benign.
+  iree_atomic_int32_t* verified_function_bits;
+
+  // Export ordinals sorted by export name for binary search lookups.
+  iree_host_size_t export_count;
+  uint16_t* sorted_export_ordinals;
+
   // A pointer to the bytecode data embedded within the module.
   iree_const_byte_span_t bytecode_data;
 
@@ -90,6 +102,19 @@ typedef struct iree_vm_bytecode_import_t {
   // don't support variadic values (yet).
   uint16_t argument_buffer_size;
   uint16_t result_buffer_size;
+
+  // Precomputed marshaling plans for fixed signatures used to bypass walking
+  // the calling convention fragments on each call. Bit i of each mask is set
+  // if value i is a ref or a 64-bit value, and otherwise it is 32-bit. Only
+  // valid when |has_fixed_arguments|/|has_fixed_results| is set.
+  bool has_fixed_arguments;
+  bool has_fixed_results;
+  uint8_t argument_count;
+  uint8_t result_count;
+  uint32_t argument_ref_mask;
+  uint32_t argument_i64_mask;
+  uint32_t result_ref_mask;
+  uint32_t result_i64_mask;
 } iree_vm_bytecode_import_t;
 
 // Per-instance module state.
@@ -120,6 +145,23 @@ typedef struct iree_vm_bytecode_module_state_t {
   iree_allocator_t allocator;
 } iree_vm_bytecode_module_state_t;
 
+// Verifies the descriptor of internal function |function_ordinal| if it has
+// not yet been verified. Must be called before the function is entered.
+iree_status_t iree_vm_bytecode_module_verify_function_slow(
+    iree_vm_bytecode_module_t* module, uint16_t function_ordinal);
+
+static inline iree_status_t iree_vm_bytecode_module_verify_function(
+    iree_vm_bytecode_module_t* module, uint16_t function_ordinal) {
+  int32_t bits = iree_atomic_load_int32(
+      &module->verified_function_bits[function_ordinal / 32],
+      iree_memory_order_relaxed);
+  if (IREE_LIKELY(bits & (1u << (function_ordinal % 32)))) {
+    return iree_ok_status();
+  }
+  return iree_vm_bytecode_module_verify_function_slow(module,
+                                                      function_ordinal);
+}
+
 // Begins (or resumes) execution of the current frame and continues until
 // either a yield or return. |out_result| will contain the result status for
 // continuation, if needed.
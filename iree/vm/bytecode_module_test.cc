@@ -10,10 +10,149 @@
 
 #include "iree/vm/bytecode_module.h"
 
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "iree/base/logging.h"
+#include "iree/base/status_cc.h"
 #include "iree/testing/gtest.h"
+#include "iree/testing/status_matchers.h"
+#include "iree/vm/api.h"
+
+// NOTE: include order matters:
+#include "iree/base/internal/flatcc/parsing.h"
+#include "iree/schemas/bytecode_module_def_reader.h"
+
+// Compiled module embedded here to avoid file IO:
+#include "iree/vm/test/all_bytecode_modules.h"
 
 namespace {
 
-// TODO(benvanik): bytecode_module_test.cc for flatbuffer/module implementation.
+// Loads a mutable copy of the arithmetic_ops test module and exposes its
+// function descriptors so that tests can corrupt them before creating the
+// module.
+class VMBytecodeModuleTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    IREE_CHECK_OK(iree_vm_register_builtin_types());
+    IREE_CHECK_OK(iree_vm_instance_create(iree_allocator_system(), &instance_));
+
+    const struct iree_file_toc_t* module_file_toc =
+        all_bytecode_modules_c_create();
+    for (size_t i = 0; i < all_bytecode_modules_c_size(); ++i) {
+      if (strcmp(module_file_toc[i].name, "arithmetic_ops.vmfb") == 0) {
+        // Copied into an allocation with the alignment flatbuffers require.
+        flatbuffer_data_.resize(
+            (module_file_toc[i].size + sizeof(uint64_t) - 1) /
+            sizeof(uint64_t));
+        memcpy(flatbuffer_data_.data(), module_file_toc[i].data,
+               module_file_toc[i].size);
+        flatbuffer_size_ = module_file_toc[i].size;
+      }
+    }
+    ASSERT_NE(0u, flatbuffer_size_);
+  }
+
+  virtual void TearDown() {
+    iree_vm_context_release(context_);
+    iree_vm_module_release(bytecode_module_);
+    iree_vm_instance_release(instance_);
+  }
+
+  iree_vm_BytecodeModuleDef_table_t module_def() {
+    return iree_vm_BytecodeModuleDef_as_root(flatbuffer_data_.data());
+  }
+
+  // Returns the name of export |export_ordinal|.
+  std::string GetExportName(size_t export_ordinal) {
+    flatbuffers_string_t name = iree_vm_ExportFunctionDef_local_name(
+        iree_vm_ExportFunctionDef_vec_at(
+            iree_vm_BytecodeModuleDef_exported_functions(module_def()),
+            export_ordinal));
+    return std::string(name, flatbuffers_string_len(name));
+  }
+
+  // Returns the mutable descriptor of the function behind |export_ordinal|.
+  iree_vm_FunctionDescriptor_t* GetExportDescriptor(size_t export_ordinal) {
+    size_t internal_ordinal = iree_vm_ExportFunctionDef_internal_ordinal(
+        iree_vm_ExportFunctionDef_vec_at(
+            iree_vm_BytecodeModuleDef_exported_functions(module_def()),
+            export_ordinal));
+    return const_cast<iree_vm_FunctionDescriptor_t*>(
+        iree_vm_FunctionDescriptor_vec_at(
+            iree_vm_BytecodeModuleDef_function_descriptors(module_def()),
+            internal_ordinal));
+  }
+
+  iree_status_t CreateModule() {
+    IREE_RETURN_IF_ERROR(iree_vm_bytecode_module_create(
+        iree_make_const_byte_span(flatbuffer_data_.data(), flatbuffer_size_),
+        iree_allocator_null(), iree_allocator_system(), &bytecode_module_));
+    return iree_vm_context_create_with_modules(
+        instance_, IREE_VM_CONTEXT_FLAG_NONE, &bytecode_module_, 1,
+        iree_allocator_system(), &context_);
+  }
+
+  iree_status_t RunFunction(const std::string& function_name) {
+    iree_vm_function_t function;
+    IREE_RETURN_IF_ERROR(bytecode_module_->lookup_function(
+        bytecode_module_->self, IREE_VM_FUNCTION_LINKAGE_EXPORT,
+        iree_make_string_view(function_name.data(), function_name.size()),
+        &function));
+    return iree_vm_invoke(context_, function, IREE_VM_INVOCATION_FLAG_NONE,
+                          /*policy=*/nullptr, /*inputs=*/nullptr,
+                          /*outputs=*/nullptr, iree_allocator_system());
+  }
+
+  iree_vm_instance_t* instance_ = nullptr;
+  iree_vm_context_t* context_ = nullptr;
+  iree_vm_module_t* bytecode_module_ = nullptr;
+  std::vector<uint64_t> flatbuffer_data_;
+  size_t flatbuffer_size_ = 0;
+};
+
+// Every export is found by name through the sorted export index.
+TEST_F(VMBytecodeModuleTest, LookupAllExportsByName) {
+  IREE_ASSERT_OK(CreateModule());
+  size_t export_count = iree_vm_ExportFunctionDef_vec_len(
+      iree_vm_BytecodeModuleDef_exported_functions(module_def()));
+  ASSERT_GT(export_count, 0u);
+  for (size_t i = 0; i < export_count; ++i) {
+    iree_vm_function_t function;
+    std::string name = GetExportName(i);
+    IREE_ASSERT_OK(bytecode_module_->lookup_function(
+        bytecode_module_->self, IREE_VM_FUNCTION_LINKAGE_EXPORT,
+        iree_make_string_view(name.data(), name.size()), &function));
+    iree_string_view_t function_name = iree_vm_function_name(&function);
+    EXPECT_EQ(name, std::string(function_name.data, function_name.size));
+  }
+
+  iree_vm_function_t function;
+  iree_status_t status = bytecode_module_->lookup_function(
+      bytecode_module_->self, IREE_VM_FUNCTION_LINKAGE_EXPORT,
+      iree_make_cstring_view("_not_an_export"), &function);
+  EXPECT_EQ(IREE_STATUS_NOT_FOUND, iree_status_code(status));
+  iree_status_ignore(status);
+}
+
+// A function with an out of range bytecode span does not fail module creation
+// as functions are verified lazily; the failure is reported when the function
+// is first called and on every subsequent call while other functions remain
+// usable.
+TEST_F(VMBytecodeModuleTest, BytecodeSpanVerifiedOnFirstCall) {
+  ASSERT_GT(iree_vm_ExportFunctionDef_vec_len(
+                iree_vm_BytecodeModuleDef_exported_functions(module_def())),
+            1u);
+  GetExportDescriptor(0)->bytecode_offset = (int32_t)flatbuffer_size_;
+  IREE_ASSERT_OK(CreateModule());
+
+  for (int i = 0; i < 2; ++i) {
+    iree_status_t status = RunFunction(GetExportName(0));
+    EXPECT_EQ(IREE_STATUS_INVALID_ARGUMENT, iree_status_code(status));
+    iree_status_ignore(status);
+  }
+  IREE_EXPECT_OK(RunFunction(GetExportName(1)));
+}
 
 }  // namespace
@@ -11,7 +11,9 @@
 #include <string.h>
 
 #include "iree/base/internal/atomics.h"
+#include "iree/base/internal/threading.h"
 #include "iree/base/tracing.h"
+#include "iree/vm/sampler.h"
 
 struct iree_vm_context_t {
   iree_atomic_ref_count_t ref_count;
@@ -27,6 +29,9 @@ struct iree_vm_context_t {
   // Configuration flags.
   iree_vm_context_flags_t flags;
 
+  // Optional sampler recording invocations made to the context.
+  iree_vm_sampler_t* sampler;
+
   struct {
     iree_host_size_t count;
     iree_host_size_t capacity;
@@ -202,6 +207,138 @@ static void iree_vm_context_release_modules(iree_vm_context_t* context,
   IREE_TRACE_ZONE_END(z0);
 }
 
+// Runs the `__init` function of |module|, if present, on a new inline stack.
+static iree_status_t iree_vm_context_run_initializer(iree_vm_context_t* context,
+                                                     iree_vm_module_t* module) {
+  IREE_VM_INLINE_STACK_INITIALIZE(
+      stack,
+      context->flags & IREE_VM_CONTEXT_FLAG_TRACE_EXECUTION
+          ? IREE_VM_INVOCATION_FLAG_TRACE_EXECUTION
+          : IREE_VM_INVOCATION_FLAG_NONE,
+      iree_vm_context_state_resolver(context), context->allocator);
+  iree_status_t status = iree_vm_context_run_function(
+      stack, module, iree_make_cstring_view("__init"));
+  iree_vm_stack_deinitialize(stack);
+  return status;
+}
+
+// Sets |out_wave| to the initialization wave of |module| such that it is one
+// past the latest wave of any module in |batch| that it imports from. Modules
+// that import from nothing in the batch are initialized in wave 0.
+// Must be called after the imports of |module| have been resolved.
+static iree_status_t iree_vm_context_compute_init_wave(
+    iree_vm_context_t* context, iree_vm_module_t* module,
+    iree_vm_module_t** batch, const iree_host_size_t* batch_waves,
+    iree_host_size_t batch_count, iree_host_size_t* out_wave) {
+  *out_wave = 0;
+  iree_vm_module_signature_t module_signature = module->signature(module->self);
+  for (int i = 0; i < module_signature.import_function_count; ++i) {
+    iree_string_view_t full_name;
+    iree_vm_function_signature_t signature;
+    IREE_RETURN_IF_ERROR(
+        module->get_function(module->self, IREE_VM_FUNCTION_LINKAGE_IMPORT, i,
+                             /*out_function=*/NULL, &full_name, &signature));
+    iree_vm_function_t import_function;
+    IREE_RETURN_IF_ERROR(
+        iree_vm_context_resolve_function(context, full_name, &import_function));
+    for (iree_host_size_t j = 0; j < batch_count; ++j) {
+      if (batch[j] == import_function.module) {
+        *out_wave = iree_max(*out_wave, batch_waves[j] + 1);
+        break;
+      }
+    }
+  }
+  return iree_ok_status();
+}
+
+#if !IREE_SYNCHRONIZATION_DISABLE_UNSAFE
+
+typedef struct iree_vm_context_init_task_t {
+  iree_vm_context_t* context;
+  iree_vm_module_t* module;
+  iree_thread_t* thread;
+  iree_status_t status;
+} iree_vm_context_init_task_t;
+
+static int iree_vm_context_init_task_main(void* entry_arg) {
+  iree_vm_context_init_task_t* task = (iree_vm_context_init_task_t*)entry_arg;
+  task->status = iree_vm_context_run_initializer(task->context, task->module);
+  return 0;
+}
+
+// Runs the `__init` functions of |modules| wave by wave as assigned by
+// iree_vm_context_compute_init_wave. All but one module in each wave are
+// initialized on their own threads while the calling thread handles the last.
+// Returns the first failure encountered; no further waves are run after one
+// fails.
+static iree_status_t iree_vm_context_run_initializers_concurrently(
+    iree_vm_context_t* context, iree_vm_module_t** modules,
+    const iree_host_size_t* waves, iree_host_size_t module_count) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_vm_context_init_task_t* tasks = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(context->allocator,
+                                sizeof(*tasks) * module_count, (void**)&tasks));
+  iree_host_size_t wave_count = 0;
+  for (iree_host_size_t i = 0; i < module_count; ++i) {
+    tasks[i].context = context;
+    tasks[i].module = modules[i];
+    tasks[i].thread = NULL;
+    tasks[i].status = iree_ok_status();
+    wave_count = iree_max(wave_count, waves[i] + 1);
+  }
+
+  iree_status_t status = iree_ok_status();
+  for (iree_host_size_t wave = 0; wave < wave_count; ++wave) {
+    IREE_TRACE_ZONE_BEGIN_NAMED(z1, "iree_vm_context_init_wave");
+
+    // Spawn a thread for every module in the wave except the last, which runs
+    // on the calling thread. Modules that fail to get a thread run inline.
+    iree_vm_context_init_task_t* inline_task = NULL;
+    for (iree_host_size_t i = 0; i < module_count; ++i) {
+      if (waves[i] != wave) continue;
+      iree_vm_context_init_task_t* task = &tasks[i];
+      if (inline_task) {
+        iree_thread_create_params_t params;
+        memset(&params, 0, sizeof(params));
+        params.name = iree_vm_module_name(inline_task->module);
+        iree_status_t create_status = iree_thread_create(
+            iree_vm_context_init_task_main, inline_task, params,
+            context->allocator, &inline_task->thread);
+        if (!iree_status_is_ok(create_status)) {
+          iree_status_ignore(create_status);
+          iree_vm_context_init_task_main(inline_task);
+        }
+      }
+      inline_task = task;
+    }
+    if (inline_task) iree_vm_context_init_task_main(inline_task);
+
+    // Join the wave; releasing a thread waits for it to exit.
+    for (iree_host_size_t i = 0; i < module_count; ++i) {
+      if (waves[i] != wave) continue;
+      iree_thread_release(tasks[i].thread);
+      tasks[i].thread = NULL;
+      if (iree_status_is_ok(status)) {
+        status = tasks[i].status;
+      } else {
+        iree_status_ignore(tasks[i].status);
+      }
+    }
+
+    IREE_TRACE_ZONE_END(z1);
+    if (!iree_status_is_ok(status)) break;
+  }
+
+  iree_allocator_free(context->allocator, tasks);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+#endif  // !IREE_SYNCHRONIZATION_DISABLE_UNSAFE
+
+
 IREE_API_EXPORT iree_status_t iree_vm_context_create(
     iree_vm_instance_t* instance, iree_vm_context_flags_t flags,
     iree_allocator_t allocator, iree_vm_context_t** out_context) {
@@ -209,20 +346,19 @@ IREE_API_EXPORT iree_status_t iree_vm_context_create(
                                              allocator, out_context);
 }
 
-IREE_API_EXPORT iree_status_t iree_vm_context_create_with_modules(
+// Allocates a context with inline storage for |module_count| modules.
+// Contexts with modules are static and frozen upon creation.
+static iree_status_t iree_vm_context_allocate(
     iree_vm_instance_t* instance, iree_vm_context_flags_t flags,
-    iree_vm_module_t** modules, iree_host_size_t module_count,
-    iree_allocator_t allocator, iree_vm_context_t** out_context) {
-  IREE_TRACE_ZONE_BEGIN(z0);
-  IREE_ASSERT_ARGUMENT(out_context);
-  *out_context = NULL;
-
+    iree_host_size_t module_count, iree_allocator_t allocator,
+    iree_vm_context_t** out_context) {
   iree_host_size_t context_size =
       sizeof(iree_vm_context_t) + sizeof(iree_vm_module_t*) * module_count +
       sizeof(iree_vm_module_state_t*) * module_count;
 
   iree_vm_context_t* context = NULL;
-  iree_allocator_malloc(allocator, context_size, (void**)&context);
+  IREE_RETURN_IF_ERROR(
+      iree_allocator_malloc(allocator, context_size, (void**)&context));
   iree_atomic_ref_count_init(&context->ref_count);
   context->instance = instance;
   iree_vm_instance_retain(context->instance);
@@ -245,6 +381,23 @@ IREE_API_EXPORT iree_status_t iree_vm_context_create_with_modules(
   context->list.count = 0;
   context->list.capacity = module_count;
 
+  *out_context = context;
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_context_create_with_modules(
+    iree_vm_instance_t* instance, iree_vm_context_flags_t flags,
+    iree_vm_module_t** modules, iree_host_size_t module_count,
+    iree_allocator_t allocator, iree_vm_context_t** out_context) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_ASSERT_ARGUMENT(out_context);
+  *out_context = NULL;
+
+  iree_vm_context_t* context = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_vm_context_allocate(instance, flags, module_count, allocator,
+                                   &context));
+
   iree_status_t register_status =
       iree_vm_context_register_modules(context, modules, module_count);
   if (!iree_status_is_ok(register_status)) {
@@ -258,6 +411,99 @@ IREE_API_EXPORT iree_status_t iree_vm_context_create_with_modules(
   return iree_ok_status();
 }
 
+// Sets |out_module_state| to a clone of |source_state| for |module| in
+// |context|. Sets |out_needs_init| if the module does not support cloning and
+// a new state was allocated that must have its initializers run.
+static iree_status_t iree_vm_context_clone_module_state(
+    iree_vm_context_t* context, iree_vm_module_t* module,
+    iree_vm_module_state_t* source_state,
+    iree_vm_module_state_t** out_module_state, bool* out_needs_init) {
+  *out_module_state = NULL;
+  *out_needs_init = false;
+  if (module->clone_state) {
+    iree_status_t status = module->clone_state(
+        module->self, context->allocator, source_state, out_module_state);
+    if (!iree_status_is_unimplemented(status)) return status;
+    iree_status_ignore(status);
+  }
+  *out_needs_init = true;
+  return module->alloc_state(module->self, context->allocator,
+                             out_module_state);
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_context_clone(
+    const iree_vm_context_t* source_context, iree_allocator_t allocator,
+    iree_vm_context_t** out_context) {
+  IREE_ASSERT_ARGUMENT(source_context);
+  IREE_ASSERT_ARGUMENT(out_context);
+  *out_context = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_host_size_t module_count = source_context->list.count;
+  iree_vm_context_t* context = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_vm_context_allocate(source_context->instance,
+                                   source_context->flags, module_count,
+                                   allocator, &context));
+
+  // VM stack used to call into module __init methods of modules that could
+  // not be cloned.
+  IREE_VM_INLINE_STACK_INITIALIZE(
+      stack,
+      context->flags & IREE_VM_CONTEXT_FLAG_TRACE_EXECUTION
+          ? IREE_VM_INVOCATION_FLAG_TRACE_EXECUTION
+          : IREE_VM_INVOCATION_FLAG_NONE,
+      iree_vm_context_state_resolver(context), context->allocator);
+
+  // Clone module states in registration order so that imports resolve the
+  // same way they did in the source context.
+  iree_status_t status = iree_ok_status();
+  iree_host_size_t i = 0;
+  for (i = 0; i < module_count; ++i) {
+    iree_vm_module_t* module = source_context->list.modules[i];
+    context->list.modules[i] = module;
+    context->list.module_states[i] = NULL;
+    iree_vm_module_retain(module);
+
+    iree_vm_module_state_t* module_state = NULL;
+    bool needs_init = false;
+    status = iree_vm_context_clone_module_state(
+        context, module, source_context->list.module_states[i], &module_state,
+        &needs_init);
+    if (!iree_status_is_ok(status)) break;
+    context->list.module_states[i] = module_state;
+
+    // Imports reference the states of this context and must be re-resolved.
+    status =
+        iree_vm_context_resolve_module_imports(context, module, module_state);
+    if (!iree_status_is_ok(status)) break;
+
+    ++context->list.count;
+
+    if (needs_init) {
+      status = iree_vm_context_run_function(stack, module,
+                                            iree_make_cstring_view("__init"));
+      if (!iree_status_is_ok(status)) break;
+    }
+  }
+
+  iree_vm_stack_deinitialize(stack);
+
+  if (!iree_status_is_ok(status)) {
+    if (module_count > 0) {
+      iree_vm_context_release_modules(context, 0, i);
+    }
+    context->list.count = 0;
+    iree_vm_context_destroy(context);
+    IREE_TRACE_ZONE_END(z0);
+    return status;
+  }
+
+  *out_context = context;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
 static void iree_vm_context_destroy(iree_vm_context_t* context) {
   if (!context) return;
 
@@ -276,6 +522,9 @@ static void iree_vm_context_destroy(iree_vm_context_t* context) {
     context->list.module_states = NULL;
   }
 
+  iree_vm_sampler_release(context->sampler);
+  context->sampler = NULL;
+
   iree_vm_instance_release(context->instance);
   context->instance = NULL;
 
@@ -309,6 +558,20 @@ iree_vm_context_flags(const iree_vm_context_t* context) {
   return context->flags;
 }
 
+IREE_API_EXPORT void iree_vm_context_set_sampler(iree_vm_context_t* context,
+                                                 iree_vm_sampler_t* sampler) {
+  IREE_ASSERT_ARGUMENT(context);
+  iree_vm_sampler_retain(sampler);
+  iree_vm_sampler_release(context->sampler);
+  context->sampler = sampler;
+}
+
+IREE_API_EXPORT iree_vm_sampler_t* iree_vm_context_sampler(
+    const iree_vm_context_t* context) {
+  IREE_ASSERT_ARGUMENT(context);
+  return context->sampler;
+}
+
 IREE_API_EXPORT iree_status_t iree_vm_context_register_modules(
     iree_vm_context_t* context, iree_vm_module_t** modules,
     iree_host_size_t module_count) {
@@ -365,6 +628,20 @@ IREE_API_EXPORT iree_status_t iree_vm_context_register_modules(
     context->list.capacity = new_capacity;
   }
 
+  // Initialization waves of each module in the batch when running __init
+  // functions concurrently. Modules are initialized in registration order
+  // otherwise.
+  iree_host_size_t* waves = NULL;
+#if !IREE_SYNCHRONIZATION_DISABLE_UNSAFE
+  if ((context->flags & IREE_VM_CONTEXT_FLAG_CONCURRENT_INITIALIZATION) &&
+      module_count > 1) {
+    IREE_RETURN_AND_END_ZONE_IF_ERROR(
+        z0, iree_allocator_malloc(context->allocator,
+                                  sizeof(*waves) * module_count,
+                                  (void**)&waves));
+  }
+#endif  // !IREE_SYNCHRONIZATION_DISABLE_UNSAFE
+
   // VM stack used to call into module __init methods.
   IREE_VM_INLINE_STACK_INITIALIZE(
       stack,
@@ -403,8 +680,23 @@ IREE_API_EXPORT iree_status_t iree_vm_context_register_modules(
       break;
     }
 
+    if (waves) {
+      // The module is not yet counted so its imports cannot resolve to itself.
+      status = iree_vm_context_compute_init_wave(
+          context, module, &context->list.modules[original_count], waves, i,
+          &waves[i]);
+      if (!iree_status_is_ok(status)) {
+        // Cleanup handled below.
+        break;
+      }
+    }
+
     ++context->list.count;
 
+    // __init functions are deferred until all modules have been registered
+    // when running them concurrently.
+    if (waves) continue;
+
     // Run module __init functions, if present.
     // As initialization functions may reference imports we need to perform
     // all of these after we have resolved the imports above.
@@ -418,6 +710,19 @@ IREE_API_EXPORT iree_status_t iree_vm_context_register_modules(
 
   iree_vm_stack_deinitialize(stack);
 
+#if !IREE_SYNCHRONIZATION_DISABLE_UNSAFE
+  if (waves) {
+    if (iree_status_is_ok(status)) {
+      status = iree_vm_context_run_initializers_concurrently(
+          context, &context->list.modules[original_count], waves,
+          module_count);
+      // All modules were registered and must be released on failure.
+      i = module_count - 1;
+    }
+    iree_allocator_free(context->allocator, waves);
+  }
+#endif  // !IREE_SYNCHRONIZATION_DISABLE_UNSAFE
+
   // Cleanup for failure cases during module initialization; we need to
   // ensure we release any modules we'd already initialized.
   if (!iree_status_is_ok(status)) {
@@ -41,6 +41,16 @@ enum iree_vm_context_flag_bits_t {
   // All invocations made to this context - including initializers - will be
   // traced. For fine-grained control use `iree_vm_invocation_flags_t`.
   IREE_VM_CONTEXT_FLAG_TRACE_EXECUTION = 1u << 0,
+
+  // Runs module `__init` functions concurrently when registering multiple
+  // modules at once. Modules are initialized in waves such that a module only
+  // begins initializing after all modules it imports from in the same batch
+  // have completed; the modules within each wave are initialized on their own
+  // threads. All module `__init` functions must be safe to run concurrently
+  // with those of unrelated modules.
+  // Ignored when threading is unavailable
+  // (IREE_SYNCHRONIZATION_DISABLE_UNSAFE).
+  IREE_VM_CONTEXT_FLAG_CONCURRENT_INITIALIZATION = 1u << 1,
 };
 typedef uint32_t iree_vm_context_flags_t;
 
@@ -60,6 +70,20 @@ IREE_API_EXPORT iree_status_t iree_vm_context_create_with_modules(
     iree_vm_module_t** modules, iree_host_size_t module_count,
     iree_allocator_t allocator, iree_vm_context_t** out_context);
 
+// Creates a new context holding the same modules as |source_context| with
+// module state cloned from it instead of being initialized anew. Modules that
+// support cloning share their immutable resources (such as loaded executables
+// and constant buffers) with the source context and copy their mutable state
+// such that the contexts are independent after creation. Modules that do not
+// support cloning are initialized as with iree_vm_context_create_with_modules.
+//
+// The source context must not be used concurrently during cloning. The sampler
+// of the source context, if any, is not carried over.
+// |out_context| must be released by the caller.
+IREE_API_EXPORT iree_status_t iree_vm_context_clone(
+    const iree_vm_context_t* source_context, iree_allocator_t allocator,
+    iree_vm_context_t** out_context);
+
 // Retains the given |context| for the caller.
 IREE_API_EXPORT void iree_vm_context_retain(iree_vm_context_t* context);
 
@@ -73,6 +97,16 @@ IREE_API_EXPORT intptr_t iree_vm_context_id(const iree_vm_context_t* context);
 IREE_API_EXPORT iree_vm_context_flags_t
 iree_vm_context_flags(const iree_vm_context_t* context);
 
+// Sets the |sampler| that records the execution of all subsequent invocations
+// made to |context|. The sampler is retained by the context. Pass NULL to stop
+// sampling. See iree/vm/sampler.h.
+IREE_API_EXPORT void iree_vm_context_set_sampler(iree_vm_context_t* context,
+                                                 iree_vm_sampler_t* sampler);
+
+// Returns the sampler attached to |context|, if any.
+IREE_API_EXPORT iree_vm_sampler_t* iree_vm_context_sampler(
+    const iree_vm_context_t* context);
+
 // Registers a list of modules with the context and resolves imports in the
 // order provided.
 // The modules will be retained by the context until destruction.
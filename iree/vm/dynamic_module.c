@@ -0,0 +1,59 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/vm/dynamic_module.h"
+
+#include <stdio.h>
+
+#include "iree/base/tracing.h"
+
+// Maximum length of a module name; C identifiers are far shorter in practice.
+#define IREE_VM_DYNAMIC_MODULE_MAX_NAME_LENGTH 256
+
+IREE_API_EXPORT iree_status_t iree_vm_dynamic_module_load_from_file(
+    const char* library_path, iree_string_view_t module_name,
+    iree_allocator_t allocator, iree_dynamic_library_t** out_library,
+    iree_vm_module_t** out_module) {
+  IREE_ASSERT_ARGUMENT(library_path);
+  IREE_ASSERT_ARGUMENT(out_library);
+  IREE_ASSERT_ARGUMENT(out_module);
+  *out_library = NULL;
+  *out_module = NULL;
+  if (iree_string_view_is_empty(module_name) ||
+      module_name.size > IREE_VM_DYNAMIC_MODULE_MAX_NAME_LENGTH) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "invalid module name '%.*s'", (int)module_name.size,
+                            module_name.data);
+  }
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_dynamic_library_t* library = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_dynamic_library_load_from_file(
+              library_path, IREE_DYNAMIC_LIBRARY_FLAG_NONE, allocator,
+              &library));
+
+  char symbol_name[IREE_VM_DYNAMIC_MODULE_MAX_NAME_LENGTH + sizeof("_create")];
+  snprintf(symbol_name, sizeof(symbol_name), "%.*s_create",
+           (int)module_name.size, module_name.data);
+  iree_vm_dynamic_module_create_fn_t create_fn = NULL;
+  iree_status_t status = iree_dynamic_library_lookup_symbol(
+      library, symbol_name, (void**)&create_fn);
+  if (iree_status_is_ok(status)) {
+    status = create_fn(allocator, out_module);
+  }
+
+  if (iree_status_is_ok(status)) {
+    *out_library = library;
+  } else {
+    iree_dynamic_library_release(library);
+    status = iree_status_annotate_f(status, "loading module '%.*s' from '%s'",
+                                    (int)module_name.size, module_name.data,
+                                    library_path);
+  }
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
@@ -0,0 +1,41 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_VM_DYNAMIC_MODULE_H_
+#define IREE_VM_DYNAMIC_MODULE_H_
+
+#include "iree/base/api.h"
+#include "iree/base/internal/dynamic_library.h"
+#include "iree/vm/api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// Signature of the `<module_name>_create` function emitted for each module by
+// the C target (-iree-vm-ir-to-c-module).
+typedef iree_status_t(IREE_API_PTR* iree_vm_dynamic_module_create_fn_t)(
+    iree_allocator_t allocator, iree_vm_module_t** out_module);
+
+// Loads a shared library containing a VM module compiled to native code with
+// the C target and creates the module named |module_name| from it.
+// This allows using natively compiled modules without rebuilding the hosting
+// application for each model.
+//
+// The library is located as with iree_dynamic_library_load_from_file and must
+// export the `<module_name>_create` function. The functions of |out_module|
+// reference code within |out_library| and the library must only be released
+// after the module and all contexts using it have been released.
+IREE_API_EXPORT iree_status_t iree_vm_dynamic_module_load_from_file(
+    const char* library_path, iree_string_view_t module_name,
+    iree_allocator_t allocator, iree_dynamic_library_t** out_library,
+    iree_vm_module_t** out_module);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_VM_DYNAMIC_MODULE_H_
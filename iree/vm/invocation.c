@@ -13,6 +13,7 @@
 #include "iree/base/api.h"
 #include "iree/base/tracing.h"
 #include "iree/vm/ref.h"
+#include "iree/vm/sampler.h"
 #include "iree/vm/stack.h"
 #include "iree/vm/value.h"
 
@@ -199,27 +200,82 @@ static iree_status_t iree_vm_invoke_within(
   return iree_ok_status();
 }
 
-IREE_API_EXPORT iree_status_t iree_vm_invoke(
-    iree_vm_context_t* context, iree_vm_function_t function,
-    iree_vm_invocation_flags_t flags, const iree_vm_invocation_policy_t* policy,
+// Invokes |function| on |stack| and deinitializes the stack.
+static iree_status_t iree_vm_invoke_on_stack(
+    iree_vm_context_t* context, iree_vm_stack_t* stack,
+    iree_vm_function_t function, const iree_vm_invocation_policy_t* policy,
     iree_vm_list_t* inputs, iree_vm_list_t* outputs,
-    iree_allocator_t allocator) {
-  IREE_TRACE_ZONE_BEGIN(z0);
+    iree_host_size_t* out_stack_storage_capacity) {
+  iree_status_t status =
+      iree_vm_invoke_within(context, stack, function, policy, inputs, outputs);
+  if (!iree_status_is_ok(status)) {
+    status = IREE_VM_STACK_ANNOTATE_BACKTRACE_IF_ENABLED(stack, status);
+  }
+  if (out_stack_storage_capacity) {
+    *out_stack_storage_capacity = iree_vm_stack_storage_capacity(stack);
+  }
+  iree_vm_stack_deinitialize(stack);
+  return status;
+}
 
+// Returns |flags| with any flags forced by |context| added.
+static iree_vm_invocation_flags_t iree_vm_invoke_resolve_flags(
+    iree_vm_context_t* context, iree_vm_invocation_flags_t flags) {
   // Force tracing if specified on the context.
   if (iree_vm_context_flags(context) & IREE_VM_CONTEXT_FLAG_TRACE_EXECUTION) {
     flags |= IREE_VM_INVOCATION_FLAG_TRACE_EXECUTION;
   }
+  return flags;
+}
+
+// Attaches the sampler of |context| (if any) to |stack|.
+static void iree_vm_invoke_attach_sampler(iree_vm_context_t* context,
+                                          iree_vm_stack_t* stack) {
+  iree_vm_sampler_t* sampler = iree_vm_context_sampler(context);
+  if (!sampler) return;
+  iree_vm_stack_set_sampler(stack, sampler);
+  // Time spent outside of the VM since the last invocation is not sampled.
+  iree_vm_sampler_resume(sampler);
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_invoke(
+    iree_vm_context_t* context, iree_vm_function_t function,
+    iree_vm_invocation_flags_t flags, const iree_vm_invocation_policy_t* policy,
+    iree_vm_list_t* inputs, iree_vm_list_t* outputs,
+    iree_allocator_t allocator) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  flags = iree_vm_invoke_resolve_flags(context, flags);
 
   // Allocate a VM stack on the host stack and initialize it.
   IREE_VM_INLINE_STACK_INITIALIZE(
       stack, flags, iree_vm_context_state_resolver(context), allocator);
+  iree_vm_invoke_attach_sampler(context, stack);
   iree_status_t status =
-      iree_vm_invoke_within(context, stack, function, policy, inputs, outputs);
-  if (!iree_status_is_ok(status)) {
-    status = IREE_VM_STACK_ANNOTATE_BACKTRACE_IF_ENABLED(stack, status);
-  }
-  iree_vm_stack_deinitialize(stack);
+      iree_vm_invoke_on_stack(context, stack, function, policy, inputs, outputs,
+                              /*out_stack_storage_capacity=*/NULL);
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_invoke_with_stack_storage(
+    iree_vm_context_t* context, iree_vm_function_t function,
+    iree_vm_invocation_flags_t flags, const iree_vm_invocation_policy_t* policy,
+    iree_vm_list_t* inputs, iree_vm_list_t* outputs,
+    iree_byte_span_t stack_storage, iree_allocator_t allocator,
+    iree_host_size_t* out_stack_storage_capacity) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  flags = iree_vm_invoke_resolve_flags(context, flags);
+
+  iree_vm_stack_t* stack = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_vm_stack_initialize(stack_storage, flags,
+                                   iree_vm_context_state_resolver(context),
+                                   allocator, &stack));
+  iree_vm_invoke_attach_sampler(context, stack);
+  iree_status_t status =
+      iree_vm_invoke_on_stack(context, stack, function, policy, inputs, outputs,
+                              out_stack_storage_capacity);
 
   IREE_TRACE_ZONE_END(z0);
   return status;
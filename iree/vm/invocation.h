@@ -40,6 +40,21 @@ IREE_API_EXPORT iree_status_t iree_vm_invoke(
     iree_vm_list_t* inputs, iree_vm_list_t* outputs,
     iree_allocator_t allocator);
 
+// Synchronously invokes a function in the VM as with iree_vm_invoke using
+// |stack_storage| for the VM stack in place of storage on the host stack.
+//
+// |allocator| is only used if the stack needs to grow beyond |stack_storage|.
+// If |out_stack_storage_capacity| is provided it receives the stack storage
+// capacity the invocation required. Callers invoking functions repeatedly can
+// size |stack_storage| to the returned capacity such that later invocations of
+// the same function perform no stack allocations.
+IREE_API_EXPORT iree_status_t iree_vm_invoke_with_stack_storage(
+    iree_vm_context_t* context, iree_vm_function_t function,
+    iree_vm_invocation_flags_t flags, const iree_vm_invocation_policy_t* policy,
+    iree_vm_list_t* inputs, iree_vm_list_t* outputs,
+    iree_byte_span_t stack_storage, iree_allocator_t allocator,
+    iree_host_size_t* out_stack_storage_capacity);
+
 // TODO(benvanik): document and implement.
 IREE_API_EXPORT iree_status_t iree_vm_invocation_create(
     iree_vm_context_t* context, iree_vm_function_t function,
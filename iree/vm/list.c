@@ -507,6 +507,121 @@ iree_vm_list_push_value(iree_vm_list_t* list, const iree_vm_value_t* value) {
   return iree_vm_list_set_value(list, i, value);
 }
 
+// Returns true if |a| and |b| are both integer or both floating-point types.
+static bool iree_vm_list_value_types_compatible(iree_vm_value_type_t a,
+                                                iree_vm_value_type_t b) {
+  bool a_is_int = a >= IREE_VM_VALUE_TYPE_I8 && a <= IREE_VM_VALUE_TYPE_I64;
+  bool b_is_int = b >= IREE_VM_VALUE_TYPE_I8 && b <= IREE_VM_VALUE_TYPE_I64;
+  return a == b || (a_is_int && b_is_int);
+}
+
+static iree_status_t iree_vm_list_check_range(const iree_vm_list_t* list,
+                                              iree_host_size_t offset,
+                                              iree_host_size_t count) {
+  if (offset > list->count || count > list->count - offset) {
+    return iree_make_status(IREE_STATUS_OUT_OF_RANGE,
+                            "range [%zu, %zu) out of bounds (%zu)", offset,
+                            offset + count, list->count);
+  }
+  return iree_ok_status();
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_list_get_values_as(
+    const iree_vm_list_t* list, iree_host_size_t offset, iree_host_size_t count,
+    iree_vm_value_type_t value_type, void* out_values) {
+  if (value_type == IREE_VM_VALUE_TYPE_NONE ||
+      value_type > IREE_VM_VALUE_TYPE_MAX) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "invalid value type %d", (int)value_type);
+  }
+  IREE_RETURN_IF_ERROR(iree_vm_list_check_range(list, offset, count));
+  if (count == 0) return iree_ok_status();
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, count);
+
+  // Fast path for dense lists of the requested type.
+  iree_host_size_t value_size = kValueTypeSizes[value_type];
+  if (list->storage_mode == IREE_VM_LIST_STORAGE_MODE_VALUE &&
+      list->element_type.value_type == value_type) {
+    memcpy(out_values,
+           (const uint8_t*)list->storage + offset * list->element_size,
+           count * value_size);
+    IREE_TRACE_ZONE_END(z0);
+    return iree_ok_status();
+  }
+
+  iree_status_t status = iree_ok_status();
+  uint8_t* out_ptr = (uint8_t*)out_values;
+  for (iree_host_size_t i = 0; i < count; ++i) {
+    iree_vm_value_t value;
+    status = iree_vm_list_get_value(list, offset + i, &value);
+    if (!iree_status_is_ok(status)) break;
+    if (!iree_vm_list_value_types_compatible(value.type, value_type)) {
+      status = iree_make_status(
+          IREE_STATUS_INVALID_ARGUMENT,
+          "element at index %zu has value type %d not convertible to %d",
+          offset + i, (int)value.type, (int)value_type);
+      break;
+    }
+    iree_vm_value_t converted_value;
+    iree_vm_list_convert_value_type(&value, value_type, &converted_value);
+    memcpy(out_ptr + i * value_size, converted_value.value_storage,
+           value_size);
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_list_set_values(
+    iree_vm_list_t* list, iree_host_size_t offset, iree_host_size_t count,
+    iree_vm_value_type_t value_type, const void* values) {
+  if (value_type == IREE_VM_VALUE_TYPE_NONE ||
+      value_type > IREE_VM_VALUE_TYPE_MAX) {
+    return iree_make_status(IREE_STATUS_INVALID_ARGUMENT,
+                            "invalid value type %d", (int)value_type);
+  }
+  IREE_RETURN_IF_ERROR(iree_vm_list_check_range(list, offset, count));
+  if (list->storage_mode == IREE_VM_LIST_STORAGE_MODE_REF) {
+    return iree_make_status(IREE_STATUS_FAILED_PRECONDITION,
+                            "list cannot store values");
+  } else if (list->storage_mode == IREE_VM_LIST_STORAGE_MODE_VALUE &&
+             !iree_vm_list_value_types_compatible(
+                 list->element_type.value_type, value_type)) {
+    return iree_make_status(
+        IREE_STATUS_INVALID_ARGUMENT,
+        "value type %d not convertible to list element type %d",
+        (int)value_type, (int)list->element_type.value_type);
+  }
+  if (count == 0) return iree_ok_status();
+  IREE_TRACE_ZONE_BEGIN(z0);
+  IREE_TRACE_ZONE_APPEND_VALUE(z0, count);
+
+  // Fast path for dense lists of the provided type.
+  iree_host_size_t value_size = kValueTypeSizes[value_type];
+  if (list->storage_mode == IREE_VM_LIST_STORAGE_MODE_VALUE &&
+      list->element_type.value_type == value_type) {
+    memcpy((uint8_t*)list->storage + offset * list->element_size, values,
+           count * value_size);
+    IREE_TRACE_ZONE_END(z0);
+    return iree_ok_status();
+  }
+
+  iree_status_t status = iree_ok_status();
+  const uint8_t* value_ptr = (const uint8_t*)values;
+  for (iree_host_size_t i = 0; i < count; ++i) {
+    iree_vm_value_t value;
+    value.type = value_type;
+    value.i64 = 0;
+    memcpy(value.value_storage, value_ptr + i * value_size, value_size);
+    status = iree_vm_list_set_value(list, offset + i, &value);
+    if (!iree_status_is_ok(status)) break;
+  }
+
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
+
 IREE_API_EXPORT void* iree_vm_list_get_ref_deref(
     const iree_vm_list_t* list, iree_host_size_t i,
     const iree_vm_ref_type_descriptor_t* type_descriptor) {
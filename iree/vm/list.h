@@ -121,6 +121,25 @@ IREE_API_EXPORT iree_status_t iree_vm_list_set_value(
 IREE_API_EXPORT iree_status_t
 iree_vm_list_push_value(iree_vm_list_t* list, const iree_vm_value_t* value);
 
+// Copies |count| values starting at index |offset| into |out_values|, which
+// must have storage for |count| densely packed values of |value_type|.
+// Integer values are converted between integer types as with
+// iree_vm_list_get_value_as; converting between integer and floating-point
+// types fails. Lists storing |value_type| directly are copied in bulk.
+IREE_API_EXPORT iree_status_t iree_vm_list_get_values_as(
+    const iree_vm_list_t* list, iree_host_size_t offset, iree_host_size_t count,
+    iree_vm_value_type_t value_type, void* out_values);
+
+// Sets |count| values starting at index |offset| from |values| containing
+// |count| densely packed values of |value_type|. The range must be within the
+// current list size (see iree_vm_list_resize). Integer values are converted to
+// the list element type as with iree_vm_list_set_value; converting between
+// integer and floating-point types fails. Lists storing |value_type| directly
+// are copied in bulk.
+IREE_API_EXPORT iree_status_t iree_vm_list_set_values(
+    iree_vm_list_t* list, iree_host_size_t offset, iree_host_size_t count,
+    iree_vm_value_type_t value_type, const void* values);
+
 // Returns a dereferenced pointer to the given type if the element at the given
 // index matches the type. Returns NULL on error.
 IREE_API_EXPORT void* iree_vm_list_get_ref_deref(
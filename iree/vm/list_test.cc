@@ -383,6 +383,89 @@ TEST_F(VMListTest, ResizeVariant) {
   iree_vm_list_release(list);
 }
 
+// Tests bulk value get/set on a dense list of the same element type.
+TEST_F(VMListTest, BulkValuesI32) {
+  iree_vm_type_def_t element_type =
+      iree_vm_type_def_make_value_type(IREE_VM_VALUE_TYPE_I32);
+  iree_vm_list_t* list = nullptr;
+  IREE_ASSERT_OK(
+      iree_vm_list_create(&element_type, 8, iree_allocator_system(), &list));
+  IREE_ASSERT_OK(iree_vm_list_resize(list, 8));
+
+  int32_t values[4] = {10, 11, 12, 13};
+  IREE_ASSERT_OK(
+      iree_vm_list_set_values(list, 2, 4, IREE_VM_VALUE_TYPE_I32, values));
+
+  int32_t i32_values[8] = {0};
+  IREE_ASSERT_OK(iree_vm_list_get_values_as(list, 0, 8, IREE_VM_VALUE_TYPE_I32,
+                                            i32_values));
+  int32_t expected_i32_values[8] = {0, 0, 10, 11, 12, 13, 0, 0};
+  EXPECT_EQ(0, memcmp(expected_i32_values, i32_values, sizeof(i32_values)));
+
+  // Integer conversion happens per element.
+  int64_t i64_values[4] = {0};
+  IREE_ASSERT_OK(iree_vm_list_get_values_as(list, 2, 4, IREE_VM_VALUE_TYPE_I64,
+                                            i64_values));
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(10 + i, i64_values[i]);
+  }
+
+  // Ranges must be within the list size.
+  EXPECT_THAT(Status(iree_vm_list_get_values_as(
+                  list, 6, 4, IREE_VM_VALUE_TYPE_I32, i32_values)),
+              StatusIs(iree::StatusCode::kOutOfRange));
+  EXPECT_THAT(Status(iree_vm_list_set_values(list, 9, 0,
+                                             IREE_VM_VALUE_TYPE_I32, values)),
+              StatusIs(iree::StatusCode::kOutOfRange));
+
+  // Integer and floating-point types are not interchangeable.
+  float f32_values[4] = {0.0f};
+  EXPECT_THAT(Status(iree_vm_list_get_values_as(
+                  list, 0, 4, IREE_VM_VALUE_TYPE_F32, f32_values)),
+              StatusIs(iree::StatusCode::kInvalidArgument));
+  EXPECT_THAT(Status(iree_vm_list_set_values(list, 0, 4, IREE_VM_VALUE_TYPE_F32,
+                                             f32_values)),
+              StatusIs(iree::StatusCode::kInvalidArgument));
+
+  iree_vm_list_release(list);
+}
+
+// Tests bulk value get/set on a variant list.
+TEST_F(VMListTest, BulkValuesVariant) {
+  iree_vm_type_def_t element_type = iree_vm_type_def_make_variant_type();
+  iree_vm_list_t* list = nullptr;
+  IREE_ASSERT_OK(
+      iree_vm_list_create(&element_type, 4, iree_allocator_system(), &list));
+  IREE_ASSERT_OK(iree_vm_list_resize(list, 4));
+
+  int64_t values[3] = {1, 2, 3};
+  IREE_ASSERT_OK(
+      iree_vm_list_set_values(list, 0, 3, IREE_VM_VALUE_TYPE_I64, values));
+  for (iree_host_size_t i = 0; i < 3; ++i) {
+    iree_vm_variant_t variant = iree_vm_variant_empty();
+    IREE_ASSERT_OK(iree_vm_list_get_variant(list, i, &variant));
+    EXPECT_EQ(IREE_VM_VALUE_TYPE_I64, variant.type.value_type);
+    EXPECT_EQ(values[i], variant.i64);
+  }
+
+  int32_t i32_values[3] = {0};
+  IREE_ASSERT_OK(iree_vm_list_get_values_as(list, 0, 3, IREE_VM_VALUE_TYPE_I32,
+                                            i32_values));
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(values[i], i32_values[i]);
+  }
+
+  // Refs (and empty variants) cannot be read as values.
+  iree_vm_ref_t ref_a = MakeRef<A>(1.0f);
+  IREE_ASSERT_OK(iree_vm_list_set_ref_move(list, 3, &ref_a));
+  int64_t i64_values[4] = {0};
+  EXPECT_THAT(Status(iree_vm_list_get_values_as(
+                  list, 0, 4, IREE_VM_VALUE_TYPE_I64, i64_values)),
+              StatusIs(iree::StatusCode::kFailedPrecondition));
+
+  iree_vm_list_release(list);
+}
+
 // TODO(benvanik): test value get/set.
 
 // TODO(benvanik): test value conversion.
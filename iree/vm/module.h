@@ -381,6 +381,17 @@ typedef struct iree_vm_module_t {
   void(IREE_API_PTR* free_state)(void* self,
                                  iree_vm_module_state_t* module_state);
 
+  // Clones module state data from |source_state| allocated for another
+  // context. The new state must be usable and freeable independently of the
+  // source but may share immutable resources with it. Imports are resolved on
+  // the new state after cloning and no initializers are run.
+  // Optional: if omitted or IREE_STATUS_UNIMPLEMENTED is returned then the
+  // state is allocated and initialized as if the module were newly registered.
+  iree_status_t(IREE_API_PTR* clone_state)(
+      void* self, iree_allocator_t allocator,
+      iree_vm_module_state_t* source_state,
+      iree_vm_module_state_t** out_module_state);
+
   // Resolves the import with the given ordinal to |function|.
   // The function is guaranteed to remain valid for the lifetime of the module
   // state.
@@ -257,6 +257,23 @@ static void IREE_API_PTR iree_vm_native_module_free_state(
   assert(!module_state);
 }
 
+static iree_status_t IREE_API_PTR iree_vm_native_module_clone_state(
+    void* self, iree_allocator_t allocator,
+    iree_vm_module_state_t* source_state,
+    iree_vm_module_state_t** out_module_state) {
+  iree_vm_native_module_t* module = (iree_vm_native_module_t*)self;
+  *out_module_state = NULL;
+  if (module->user_interface.clone_state) {
+    return module->user_interface.clone_state(module->self, allocator,
+                                              source_state, out_module_state);
+  } else if (!module->user_interface.alloc_state) {
+    // Default to no state.
+    return iree_ok_status();
+  }
+  // The context falls back to allocating and initializing a new state.
+  return iree_status_from_code(IREE_STATUS_UNIMPLEMENTED);
+}
+
 static iree_status_t IREE_API_PTR iree_vm_native_module_resolve_import(
     void* self, iree_vm_module_state_t* module_state, iree_host_size_t ordinal,
     const iree_vm_function_t* function,
@@ -436,6 +453,7 @@ IREE_API_EXPORT iree_status_t iree_vm_native_module_initialize(
       iree_vm_native_module_lookup_function;
   module->base_interface.alloc_state = iree_vm_native_module_alloc_state;
   module->base_interface.free_state = iree_vm_native_module_free_state;
+  module->base_interface.clone_state = iree_vm_native_module_clone_state;
   module->base_interface.resolve_import = iree_vm_native_module_resolve_import;
   module->base_interface.notify = iree_vm_native_module_notify;
   module->base_interface.begin_call = iree_vm_native_module_begin_call;
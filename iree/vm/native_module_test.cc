@@ -56,12 +56,18 @@ class VMNativeModuleTest : public ::testing::Test {
 
   StatusOr<int32_t> RunFunction(iree_string_view_t function_name,
                                 int32_t arg0) {
+    return RunFunction(context_, function_name, arg0);
+  }
+
+  StatusOr<int32_t> RunFunction(iree_vm_context_t* context,
+                                iree_string_view_t function_name,
+                                int32_t arg0) {
     // Lookup the entry function. This can be cached in an application if
     // multiple calls will be made.
     iree_vm_function_t function;
     IREE_RETURN_IF_ERROR(
         iree_vm_context_resolve_function(
-            context_, iree_make_cstring_view("module_b.entry"), &function),
+            context, iree_make_cstring_view("module_b.entry"), &function),
         "unable to resolve entry point");
 
     // Setup I/O lists and pass in the argument. The result list will be
@@ -78,7 +84,7 @@ class VMNativeModuleTest : public ::testing::Test {
 
     // Invoke the entry function to do our work. Runs synchronously.
     IREE_RETURN_IF_ERROR(
-        iree_vm_invoke(context_, function, IREE_VM_INVOCATION_FLAG_NONE,
+        iree_vm_invoke(context, function, IREE_VM_INVOCATION_FLAG_NONE,
                        /*policy=*/nullptr, input_list.get(), output_list.get(),
                        iree_allocator_system()));
 
@@ -89,7 +95,6 @@ class VMNativeModuleTest : public ::testing::Test {
     return ret0_value.i32;
   }
 
- private:
   iree_vm_instance_t* instance_ = nullptr;
   iree_vm_context_t* context_ = nullptr;
 };
@@ -106,5 +111,57 @@ TEST_F(VMNativeModuleTest, Example) {
   ASSERT_EQ(v2, 8);
 }
 
+TEST_F(VMNativeModuleTest, CloneContext) {
+  IREE_ASSERT_OK_AND_ASSIGN(
+      int32_t v0, RunFunction(iree_make_cstring_view("module_b.entry"), 1));
+  ASSERT_EQ(v0, 1);
+
+  // The cloned context starts with the state of the source context.
+  iree_vm_context_t* cloned_context = nullptr;
+  IREE_ASSERT_OK(iree_vm_context_clone(context_, iree_allocator_system(),
+                                       &cloned_context));
+  IREE_ASSERT_OK_AND_ASSIGN(
+      int32_t v1, RunFunction(cloned_context,
+                              iree_make_cstring_view("module_b.entry"), 2));
+  ASSERT_EQ(v1, 4);
+
+  // Changes to the state of one context are not visible to the other.
+  IREE_ASSERT_OK_AND_ASSIGN(
+      int32_t v2, RunFunction(iree_make_cstring_view("module_b.entry"), 2));
+  ASSERT_EQ(v2, 4);
+  IREE_ASSERT_OK_AND_ASSIGN(
+      int32_t v3, RunFunction(cloned_context,
+                              iree_make_cstring_view("module_b.entry"), 3));
+  ASSERT_EQ(v3, 8);
+  IREE_ASSERT_OK_AND_ASSIGN(
+      int32_t v4, RunFunction(iree_make_cstring_view("module_b.entry"), 1));
+  ASSERT_EQ(v4, 6);
+
+  iree_vm_context_release(cloned_context);
+}
+
+TEST_F(VMNativeModuleTest, ConcurrentInitialization) {
+  iree_vm_module_t* module_a = nullptr;
+  IREE_ASSERT_OK(module_a_create(iree_allocator_system(), &module_a));
+  iree_vm_module_t* module_b = nullptr;
+  IREE_ASSERT_OK(module_b_create(iree_allocator_system(), &module_b));
+
+  // module_b imports from module_a and must be initialized after it.
+  std::vector<iree_vm_module_t*> modules = {module_a, module_b};
+  iree_vm_context_t* context = nullptr;
+  IREE_ASSERT_OK(iree_vm_context_create_with_modules(
+      instance_, IREE_VM_CONTEXT_FLAG_CONCURRENT_INITIALIZATION, modules.data(),
+      modules.size(), iree_allocator_system(), &context));
+  iree_vm_module_release(module_a);
+  iree_vm_module_release(module_b);
+
+  IREE_ASSERT_OK_AND_ASSIGN(
+      int32_t v0,
+      RunFunction(context, iree_make_cstring_view("module_b.entry"), 1));
+  ASSERT_EQ(v0, 1);
+
+  iree_vm_context_release(context);
+}
+
 }  // namespace
 }  // namespace iree
@@ -194,6 +194,19 @@ module_b_free_state(void* self, iree_vm_module_state_t* module_state) {
   iree_allocator_free(state->allocator, state);
 }
 
+// Clones per-context state from another context. Imports are resolved again
+// after cloning but any other user state is copied.
+static iree_status_t IREE_API_PTR
+module_b_clone_state(void* self, iree_allocator_t allocator,
+                     iree_vm_module_state_t* source_module_state,
+                     iree_vm_module_state_t** out_module_state) {
+  IREE_RETURN_IF_ERROR(module_b_alloc_state(self, allocator, out_module_state));
+  module_b_state_t* source_state = (module_b_state_t*)source_module_state;
+  module_b_state_t* state = (module_b_state_t*)*out_module_state;
+  state->counter = source_state->counter;
+  return iree_ok_status();
+}
+
 // Called once per import function so the module can store the function ref.
 static iree_status_t IREE_API_PTR module_b_resolve_import(
     void* self, iree_vm_module_state_t* module_state, iree_host_size_t ordinal,
@@ -301,6 +314,7 @@ static iree_status_t module_b_create(iree_allocator_t allocator,
   interface.destroy = module_b_destroy;
   interface.alloc_state = module_b_alloc_state;
   interface.free_state = module_b_free_state;
+  interface.clone_state = module_b_clone_state;
   interface.resolve_import = module_b_resolve_import;
   return iree_vm_native_module_create(&interface, &module_b_descriptor_,
                                       allocator, out_module);
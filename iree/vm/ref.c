@@ -29,6 +29,19 @@ static inline volatile iree_atomic_ref_count_t* iree_vm_get_ref_counter_ptr(
                                              ref->offsetof_counter);
 }
 
+// Drops a reference from |counter| and returns true if it was the last one.
+// When the caller holds the only reference no other thread can observe or
+// acquire the object so the atomic read-modify-write is skipped. This is the
+// common case for objects created and consumed within a single invocation and
+// avoids the (comparatively expensive) locked decrement on release.
+static inline bool iree_vm_ref_counter_release(
+    iree_atomic_ref_count_t* counter) {
+  if (iree_atomic_load_int32(counter, iree_memory_order_acquire) == 1) {
+    return true;
+  }
+  return iree_atomic_ref_count_dec(counter) == 1;
+}
+
 IREE_API_EXPORT void iree_vm_ref_object_retain(
     void* ptr, const iree_vm_ref_type_descriptor_t* type_descriptor) {
   if (!ptr) return;
@@ -40,9 +53,10 @@ IREE_API_EXPORT void iree_vm_ref_object_retain(
 IREE_API_EXPORT void iree_vm_ref_object_release(
     void* ptr, const iree_vm_ref_type_descriptor_t* type_descriptor) {
   if (!ptr) return;
-  volatile iree_atomic_ref_count_t* counter =
-      iree_vm_get_raw_counter_ptr(ptr, type_descriptor);
-  if (iree_atomic_ref_count_dec(counter) == 1) {
+  iree_atomic_ref_count_t* counter =
+      (iree_atomic_ref_count_t*)iree_vm_get_raw_counter_ptr(ptr,
+                                                            type_descriptor);
+  if (iree_vm_ref_counter_release(counter)) {
     if (type_descriptor->destroy) {
       // NOTE: this makes us not re-entrant, but I think that's OK.
       type_descriptor->destroy(ptr);
@@ -158,6 +172,15 @@ IREE_API_EXPORT iree_status_t iree_vm_ref_wrap_retain(void* ptr,
 
 IREE_API_EXPORT void iree_vm_ref_retain(iree_vm_ref_t* ref,
                                         iree_vm_ref_t* out_ref) {
+  if (ref->ptr == out_ref->ptr) {
+    // Both already reference the same object (or are both null, or alias):
+    // retaining and then releasing the existing value would cancel out so
+    // skip the counter entirely. The interpreter hits this when registers are
+    // reassigned the value they already hold (such as in loops).
+    *out_ref = *ref;
+    return;
+  }
+
   // NOTE: ref and out_ref may alias or be nested so we retain before we
   // potentially release.
   iree_vm_ref_t temp_ref = *ref;
@@ -211,8 +234,9 @@ IREE_API_EXPORT void iree_vm_ref_release(iree_vm_ref_t* ref) {
   if (ref->type == IREE_VM_REF_TYPE_NULL || ref->ptr == NULL) return;
 
   iree_vm_ref_trace("RELEASE", ref);
-  volatile iree_atomic_ref_count_t* counter = iree_vm_get_ref_counter_ptr(ref);
-  if (iree_atomic_ref_count_dec(counter) == 1) {
+  iree_atomic_ref_count_t* counter =
+      (iree_atomic_ref_count_t*)iree_vm_get_ref_counter_ptr(ref);
+  if (iree_vm_ref_counter_release(counter)) {
     const iree_vm_ref_type_descriptor_t* type_descriptor =
         iree_vm_ref_get_type_descriptor(ref->type);
     if (type_descriptor->destroy) {
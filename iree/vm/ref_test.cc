@@ -185,6 +185,21 @@ TEST(VMRefTest, RetainIntoSelf) {
   iree_vm_ref_release(&a_ref);
 }
 
+// Tests that retaining into a ref already holding the same object leaves the
+// counter unchanged.
+TEST(VMRefTest, RetainIntoSameObject) {
+  iree_vm_ref_t a_ref_0 = MakeRef<A>("AType");
+  iree_vm_ref_t a_ref_1 = {0};
+  iree_vm_ref_retain(&a_ref_0, &a_ref_1);
+  EXPECT_EQ(2, ReadCounter(&a_ref_0));
+  iree_vm_ref_retain(&a_ref_0, &a_ref_1);
+  EXPECT_EQ(1, iree_vm_ref_equal(&a_ref_0, &a_ref_1));
+  EXPECT_EQ(2, ReadCounter(&a_ref_0));
+  iree_vm_ref_release(&a_ref_1);
+  EXPECT_EQ(1, ReadCounter(&a_ref_0));
+  iree_vm_ref_release(&a_ref_0);
+}
+
 // Tests that retaining into out_ref releases the existing contents.
 TEST(VMRefTest, RetainReleasesExisting) {
   iree_vm_ref_t a_ref = MakeRef<A>("AType");
@@ -0,0 +1,303 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include "iree/vm/sampler.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "iree/base/internal/atomics.h"
+#include "iree/base/tracing.h"
+
+// Initial capacity of the sample storage; grows by doubling as required.
+#define IREE_VM_SAMPLER_INITIAL_CAPACITY (64 * 1024)
+
+// A single frame captured in a sample.
+typedef struct iree_vm_sample_frame_t {
+  iree_vm_function_t function;
+  // Program counter within the function or -1 if the frame is a callee that
+  // has already returned (such as an import).
+  iree_vm_source_offset_t pc;
+} iree_vm_sample_frame_t;
+
+// Header of a sample record in the sample storage. |frame_count| frames follow
+// the header ordered from the top of the stack to the bottom.
+typedef struct iree_vm_sample_header_t {
+  iree_host_size_t frame_count;
+  iree_duration_t weight_ns;
+} iree_vm_sample_header_t;
+
+struct iree_vm_sampler_t {
+  iree_atomic_ref_count_t ref_count;
+  iree_allocator_t allocator;
+
+  // Minimum time between samples.
+  iree_duration_t interval_ns;
+  // Time of the last sample (or resume) that the next sample is weighted from.
+  iree_time_t last_sample_time_ns;
+  // Earliest time the next sample may be taken.
+  iree_time_t next_sample_time_ns;
+
+  // Total number of samples in |storage|.
+  iree_host_size_t sample_count;
+  // Packed iree_vm_sample_header_t and frames.
+  iree_host_size_t storage_capacity;
+  iree_host_size_t storage_size;
+  uint8_t* storage;
+};
+
+static void iree_vm_sampler_destroy(iree_vm_sampler_t* sampler);
+
+IREE_API_EXPORT iree_status_t
+iree_vm_sampler_create(iree_duration_t interval_ns, iree_allocator_t allocator,
+                       iree_vm_sampler_t** out_sampler) {
+  IREE_ASSERT_ARGUMENT(out_sampler);
+  *out_sampler = NULL;
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  iree_vm_sampler_t* sampler = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(allocator, sizeof(*sampler), (void**)&sampler));
+  memset(sampler, 0, sizeof(*sampler));
+  iree_atomic_ref_count_init(&sampler->ref_count);
+  sampler->allocator = allocator;
+  sampler->interval_ns =
+      interval_ns > 0 ? interval_ns : IREE_VM_SAMPLER_DEFAULT_INTERVAL_NS;
+
+  *out_sampler = sampler;
+  IREE_TRACE_ZONE_END(z0);
+  return iree_ok_status();
+}
+
+static void iree_vm_sampler_destroy(iree_vm_sampler_t* sampler) {
+  IREE_TRACE_ZONE_BEGIN(z0);
+  iree_allocator_t allocator = sampler->allocator;
+  iree_allocator_free(allocator, sampler->storage);
+  iree_allocator_free(allocator, sampler);
+  IREE_TRACE_ZONE_END(z0);
+}
+
+IREE_API_EXPORT void iree_vm_sampler_retain(iree_vm_sampler_t* sampler) {
+  if (sampler) {
+    iree_atomic_ref_count_inc(&sampler->ref_count);
+  }
+}
+
+IREE_API_EXPORT void iree_vm_sampler_release(iree_vm_sampler_t* sampler) {
+  if (sampler && iree_atomic_ref_count_dec(&sampler->ref_count) == 1) {
+    iree_vm_sampler_destroy(sampler);
+  }
+}
+
+IREE_API_EXPORT iree_host_size_t
+iree_vm_sampler_sample_count(const iree_vm_sampler_t* sampler) {
+  IREE_ASSERT_ARGUMENT(sampler);
+  return sampler->sample_count;
+}
+
+IREE_API_EXPORT void iree_vm_sampler_reset(iree_vm_sampler_t* sampler) {
+  IREE_ASSERT_ARGUMENT(sampler);
+  sampler->sample_count = 0;
+  sampler->storage_size = 0;
+  sampler->last_sample_time_ns = 0;
+  sampler->next_sample_time_ns = 0;
+}
+
+IREE_API_EXPORT void iree_vm_sampler_resume(iree_vm_sampler_t* sampler) {
+  IREE_ASSERT_ARGUMENT(sampler);
+  iree_time_t now_ns = iree_time_now();
+  sampler->last_sample_time_ns = now_ns;
+  sampler->next_sample_time_ns = now_ns + sampler->interval_ns;
+}
+
+// Ensures |sampler| has storage for at least |additional_size| more bytes.
+static bool iree_vm_sampler_reserve(iree_vm_sampler_t* sampler,
+                                    iree_host_size_t additional_size) {
+  iree_host_size_t required_size = sampler->storage_size + additional_size;
+  if (IREE_LIKELY(required_size <= sampler->storage_capacity)) return true;
+  iree_host_size_t new_capacity = sampler->storage_capacity
+                                      ? sampler->storage_capacity
+                                      : IREE_VM_SAMPLER_INITIAL_CAPACITY;
+  while (new_capacity < required_size) new_capacity *= 2;
+  iree_status_t status = iree_allocator_realloc(
+      sampler->allocator, new_capacity, (void**)&sampler->storage);
+  if (!iree_status_is_ok(status)) {
+    // Dropping a sample is preferable to failing the invocation being sampled.
+    iree_status_ignore(status);
+    return false;
+  }
+  sampler->storage_capacity = new_capacity;
+  return true;
+}
+
+IREE_API_EXPORT void iree_vm_sampler_tick(iree_vm_sampler_t* sampler,
+                                          iree_vm_stack_t* stack,
+                                          const iree_vm_function_t* callee) {
+  iree_time_t now_ns = iree_time_now();
+  if (now_ns < sampler->next_sample_time_ns) return;
+  iree_duration_t weight_ns = now_ns - sampler->last_sample_time_ns;
+  sampler->last_sample_time_ns = now_ns;
+  sampler->next_sample_time_ns = now_ns + sampler->interval_ns;
+
+  iree_host_size_t frame_count = callee ? 1 : 0;
+  for (iree_vm_stack_frame_t* frame = iree_vm_stack_current_frame(stack);
+       frame != NULL; frame = iree_vm_stack_frame_parent(frame)) {
+    if (frame->function.module) ++frame_count;
+  }
+  if (!iree_vm_sampler_reserve(
+          sampler, sizeof(iree_vm_sample_header_t) +
+                       frame_count * sizeof(iree_vm_sample_frame_t))) {
+    return;
+  }
+
+  uint8_t* p = sampler->storage + sampler->storage_size;
+  iree_vm_sample_header_t* header = (iree_vm_sample_header_t*)p;
+  header->frame_count = frame_count;
+  header->weight_ns = weight_ns;
+  iree_vm_sample_frame_t* sample_frame =
+      (iree_vm_sample_frame_t*)(p + sizeof(*header));
+  if (callee) {
+    sample_frame->function = *callee;
+    sample_frame->pc = -1;
+    ++sample_frame;
+  }
+  for (iree_vm_stack_frame_t* frame = iree_vm_stack_current_frame(stack);
+       frame != NULL; frame = iree_vm_stack_frame_parent(frame)) {
+    // External frames have no module and only mark transitions into the VM.
+    if (!frame->function.module) continue;
+    sample_frame->function = frame->function;
+    sample_frame->pc = frame->pc;
+    ++sample_frame;
+  }
+  sampler->storage_size += sizeof(*header) + frame_count * sizeof(*sample_frame);
+  ++sampler->sample_count;
+}
+
+// Appends the label of |sample_frame| to |builder|.
+static iree_status_t iree_vm_sampler_format_frame(
+    const iree_vm_sample_frame_t* sample_frame,
+    iree_vm_sampler_format_flags_t flags, iree_string_builder_t* builder) {
+  iree_string_view_t module_name =
+      iree_vm_module_name(sample_frame->function.module);
+  iree_string_view_t function_name =
+      iree_vm_function_name(&sample_frame->function);
+  if (iree_string_view_is_empty(function_name)) {
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_format(
+        builder, "%.*s@%d", (int)module_name.size, module_name.data,
+        (int)sample_frame->function.ordinal));
+  } else {
+    IREE_RETURN_IF_ERROR(iree_string_builder_append_format(
+        builder, "%.*s.%.*s", (int)module_name.size, module_name.data,
+        (int)function_name.size, function_name.data));
+  }
+  if (!(flags & IREE_VM_SAMPLER_FORMAT_FLAG_SOURCE_LOCATIONS) ||
+      sample_frame->pc < 0) {
+    return iree_ok_status();
+  }
+
+  // Source locations are resolved from a stand-in frame as the original frame
+  // is long gone by the time samples are formatted.
+  iree_vm_stack_frame_t frame;
+  memset(&frame, 0, sizeof(frame));
+  frame.function = sample_frame->function;
+  frame.pc = sample_frame->pc;
+  iree_vm_source_location_t source_location;
+  iree_status_t status = iree_vm_module_resolve_source_location(
+      sample_frame->function.module, &frame, &source_location);
+  if (iree_status_is_ok(status)) {
+    status = iree_string_builder_append_cstring(builder, " ");
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_vm_source_location_format(
+        &source_location, IREE_VM_SOURCE_LOCATION_FORMAT_FLAG_SINGLE_LINE,
+        builder);
+  }
+  if (iree_status_is_unavailable(status)) {
+    // Ignore failures when no source location is available.
+    iree_status_ignore(status);
+    return iree_ok_status();
+  }
+  return status;
+}
+
+// A formatted stack and its accumulated weight.
+typedef struct iree_vm_sampler_line_t {
+  iree_string_view_t stack;
+  iree_duration_t weight_ns;
+} iree_vm_sampler_line_t;
+
+static int iree_vm_sampler_line_compare(const void* a, const void* b) {
+  return iree_string_view_compare(((const iree_vm_sampler_line_t*)a)->stack,
+                                  ((const iree_vm_sampler_line_t*)b)->stack);
+}
+
+IREE_API_EXPORT iree_status_t iree_vm_sampler_format_collapsed(
+    const iree_vm_sampler_t* sampler, iree_vm_sampler_format_flags_t flags,
+    iree_string_builder_t* builder) {
+  IREE_ASSERT_ARGUMENT(sampler);
+  IREE_ASSERT_ARGUMENT(builder);
+  if (sampler->sample_count == 0) return iree_ok_status();
+  IREE_TRACE_ZONE_BEGIN(z0);
+
+  // Format every sample into a single buffer. Offsets are recorded instead of
+  // pointers as the buffer may be reallocated while formatting.
+  iree_vm_sampler_line_t* lines = NULL;
+  IREE_RETURN_AND_END_ZONE_IF_ERROR(
+      z0, iree_allocator_malloc(sampler->allocator,
+                                sampler->sample_count * sizeof(*lines),
+                                (void**)&lines));
+  iree_string_builder_t stacks;
+  iree_string_builder_initialize(sampler->allocator, &stacks);
+  iree_status_t status = iree_ok_status();
+  const uint8_t* p = sampler->storage;
+  for (iree_host_size_t i = 0; i < sampler->sample_count; ++i) {
+    const iree_vm_sample_header_t* header = (const iree_vm_sample_header_t*)p;
+    const iree_vm_sample_frame_t* sample_frames =
+        (const iree_vm_sample_frame_t*)(p + sizeof(*header));
+    p += sizeof(*header) + header->frame_count * sizeof(*sample_frames);
+    iree_host_size_t line_offset = iree_string_builder_size(&stacks);
+    // Collapsed stacks are listed from the bottom of the stack to the top.
+    for (iree_host_size_t j = 0;
+         j < header->frame_count && iree_status_is_ok(status); ++j) {
+      if (j > 0) status = iree_string_builder_append_cstring(&stacks, ";");
+      if (iree_status_is_ok(status)) {
+        status = iree_vm_sampler_format_frame(
+            &sample_frames[header->frame_count - j - 1], flags, &stacks);
+      }
+    }
+    if (!iree_status_is_ok(status)) break;
+    lines[i].stack = iree_make_string_view(
+        (const char*)(uintptr_t)line_offset,
+        iree_string_builder_size(&stacks) - line_offset);
+    lines[i].weight_ns = header->weight_ns;
+  }
+
+  // Merge identical stacks.
+  if (iree_status_is_ok(status)) {
+    const char* base = iree_string_builder_buffer(&stacks);
+    for (iree_host_size_t i = 0; i < sampler->sample_count; ++i) {
+      lines[i].stack.data = base + (uintptr_t)lines[i].stack.data;
+    }
+    qsort(lines, sampler->sample_count, sizeof(*lines),
+          iree_vm_sampler_line_compare);
+    for (iree_host_size_t i = 0;
+         i < sampler->sample_count && iree_status_is_ok(status);) {
+      iree_vm_sampler_line_t line = lines[i++];
+      while (i < sampler->sample_count &&
+             iree_string_view_equal(line.stack, lines[i].stack)) {
+        line.weight_ns += lines[i++].weight_ns;
+      }
+      status = iree_string_builder_append_format(
+          builder, "%.*s %" PRId64 "\n", (int)line.stack.size, line.stack.data,
+          (int64_t)line.weight_ns);
+    }
+  }
+
+  iree_string_builder_deinitialize(&stacks);
+  iree_allocator_free(sampler->allocator, lines);
+  IREE_TRACE_ZONE_END(z0);
+  return status;
+}
@@ -0,0 +1,98 @@
+// Copyright 2022 The IREE Authors
+//
+// Licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef IREE_VM_SAMPLER_H_
+#define IREE_VM_SAMPLER_H_
+
+#include <stdint.h>
+
+#include "iree/base/api.h"
+#include "iree/vm/module.h"
+#include "iree/vm/stack.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif  // __cplusplus
+
+// A sampling profiler of VM execution.
+// When attached to a context (see iree_vm_context_set_sampler) the bytecode
+// interpreter periodically records the current function/pc stack of the
+// invocation. Each sample is weighted by the wall time elapsed since the last
+// sample such that the total weight of all samples approximates the time spent
+// executing within the VM, including the time spent in imported functions.
+//
+// Samples are only taken at control flow points (calls, branches, and returns)
+// and after imports return and not at every instruction. This keeps the
+// overhead low enough to profile real programs while still capturing the
+// host-side orchestration code that is hot.
+//
+// The recorded samples can be emitted in the collapsed-stack format used by
+// flamegraph.pl, speedscope, and other flamegraph tools:
+//   module.caller;module.callee;hal.command_buffer.dispatch 12345
+//
+// See iree/base/config.h for the flags that control whether this functionality
+// is available; specifically:
+//   -DIREE_VM_EXECUTION_SAMPLING_ENABLE=1
+//
+// Thread-compatible; a sampler must only be used by one invocation at a time.
+typedef struct iree_vm_sampler_t iree_vm_sampler_t;
+
+// Default interval between samples.
+#define IREE_VM_SAMPLER_DEFAULT_INTERVAL_NS (100 * 1000)
+
+enum iree_vm_sampler_format_flag_bits_t {
+  IREE_VM_SAMPLER_FORMAT_FLAG_NONE = 0u,
+  // Appends the source location of each frame as resolved from the module
+  // debug database (when available). Frames are split by call site.
+  IREE_VM_SAMPLER_FORMAT_FLAG_SOURCE_LOCATIONS = 1u << 0,
+};
+typedef uint32_t iree_vm_sampler_format_flags_t;
+
+// Creates a new sampler recording a sample every |interval_ns| (or
+// IREE_VM_SAMPLER_DEFAULT_INTERVAL_NS if 0).
+// |out_sampler| must be released by the caller.
+IREE_API_EXPORT iree_status_t
+iree_vm_sampler_create(iree_duration_t interval_ns, iree_allocator_t allocator,
+                       iree_vm_sampler_t** out_sampler);
+
+// Retains the given |sampler| for the caller.
+IREE_API_EXPORT void iree_vm_sampler_retain(iree_vm_sampler_t* sampler);
+
+// Releases the given |sampler| from the caller.
+IREE_API_EXPORT void iree_vm_sampler_release(iree_vm_sampler_t* sampler);
+
+// Returns the total number of samples recorded.
+IREE_API_EXPORT iree_host_size_t
+iree_vm_sampler_sample_count(const iree_vm_sampler_t* sampler);
+
+// Discards all recorded samples.
+IREE_API_EXPORT void iree_vm_sampler_reset(iree_vm_sampler_t* sampler);
+
+// Marks the start of execution on a stack. Time elapsed since the last sample
+// is discarded so that time spent outside of the VM is not attributed to the
+// next sample.
+IREE_API_EXPORT void iree_vm_sampler_resume(iree_vm_sampler_t* sampler);
+
+// Records a sample of |stack| if the sampling interval has elapsed since the
+// last sample. |callee| is an optional function that has just returned to the
+// top frame of |stack| and that the elapsed time should be attributed to, such
+// as an import.
+IREE_API_EXPORT void iree_vm_sampler_tick(iree_vm_sampler_t* sampler,
+                                          iree_vm_stack_t* stack,
+                                          const iree_vm_function_t* callee);
+
+// Appends all recorded samples to |builder| in the collapsed-stack format with
+// one line per unique stack and its total weight in nanoseconds.
+// The modules referenced by the samples must still be live.
+IREE_API_EXPORT iree_status_t iree_vm_sampler_format_collapsed(
+    const iree_vm_sampler_t* sampler, iree_vm_sampler_format_flags_t flags,
+    iree_string_builder_t* builder);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif  // __cplusplus
+
+#endif  // IREE_VM_SAMPLER_H_
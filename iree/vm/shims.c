@@ -7,6 +7,7 @@
 #include "iree/vm/shims.h"
 
 IREE_VM_ABI_DEFINE_SHIM(irii, v);
+IREE_VM_ABI_DEFINE_SHIM(iriiii, v);
 IREE_VM_ABI_DEFINE_SHIM(r, i);
 IREE_VM_ABI_DEFINE_SHIM(r, ii);
 IREE_VM_ABI_DEFINE_SHIM(r, iii);
@@ -31,6 +32,11 @@ IREE_VM_ABI_DEFINE_SHIM(riii, r);
 IREE_VM_ABI_DEFINE_SHIM(riii, v);
 IREE_VM_ABI_DEFINE_SHIM(riirii, r);
 IREE_VM_ABI_DEFINE_SHIM(riiirii, r);
+IREE_VM_ABI_DEFINE_SHIM(riiriiii, v);
+IREE_VM_ABI_DEFINE_SHIM(riiriiriiii, v);
+IREE_VM_ABI_DEFINE_SHIM(riiriiriiiii, v);
+IREE_VM_ABI_DEFINE_SHIM(riiriiriiriiii, v);
+IREE_VM_ABI_DEFINE_SHIM(rrrCiD, v);
 IREE_VM_ABI_DEFINE_SHIM(rrrCrD, r);
 IREE_VM_ABI_DEFINE_SHIM(ririi, v);
 IREE_VM_ABI_DEFINE_SHIM(rr, i);
@@ -46,6 +52,7 @@ IREE_VM_ABI_DEFINE_SHIM(rriiii, v);
 IREE_VM_ABI_DEFINE_SHIM(rrirCiD, v);
 IREE_VM_ABI_DEFINE_SHIM(rriri, v);
 IREE_VM_ABI_DEFINE_SHIM(rririi, v);
+IREE_VM_ABI_DEFINE_SHIM(rrriii, r);
 IREE_VM_ABI_DEFINE_SHIM(rrriii, v);
 IREE_VM_ABI_DEFINE_SHIM(v, i);
 IREE_VM_ABI_DEFINE_SHIM(v, r);
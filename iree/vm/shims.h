@@ -191,6 +191,15 @@ IREE_VM_ABI_FIXED_STRUCT(irii, {
   int32_t i3;
 });
 
+IREE_VM_ABI_FIXED_STRUCT(iriiii, {
+  int32_t i0;
+  iree_vm_ref_t r1;
+  int32_t i2;
+  int32_t i3;
+  int32_t i4;
+  int32_t i5;
+});
+
 IREE_VM_ABI_FIXED_STRUCT(r, { iree_vm_ref_t r0; });
 
 IREE_VM_ABI_FIXED_STRUCT(rr, {
@@ -255,6 +264,63 @@ IREE_VM_ABI_FIXED_STRUCT(riiirii, {
   int32_t i6;
 });
 
+IREE_VM_ABI_FIXED_STRUCT(riiriiii, {
+  iree_vm_ref_t r0;
+  int32_t i1;
+  int32_t i2;
+  iree_vm_ref_t r3;
+  int32_t i4;
+  int32_t i5;
+  int32_t i6;
+  int32_t i7;
+});
+
+IREE_VM_ABI_FIXED_STRUCT(riiriiriiii, {
+  iree_vm_ref_t r0;
+  int32_t i1;
+  int32_t i2;
+  iree_vm_ref_t r3;
+  int32_t i4;
+  int32_t i5;
+  iree_vm_ref_t r6;
+  int32_t i7;
+  int32_t i8;
+  int32_t i9;
+  int32_t i10;
+});
+
+IREE_VM_ABI_FIXED_STRUCT(riiriiriiiii, {
+  iree_vm_ref_t r0;
+  int32_t i1;
+  int32_t i2;
+  iree_vm_ref_t r3;
+  int32_t i4;
+  int32_t i5;
+  iree_vm_ref_t r6;
+  int32_t i7;
+  int32_t i8;
+  int32_t i9;
+  int32_t i10;
+  int32_t i11;
+});
+
+IREE_VM_ABI_FIXED_STRUCT(riiriiriiriiii, {
+  iree_vm_ref_t r0;
+  int32_t i1;
+  int32_t i2;
+  iree_vm_ref_t r3;
+  int32_t i4;
+  int32_t i5;
+  iree_vm_ref_t r6;
+  int32_t i7;
+  int32_t i8;
+  iree_vm_ref_t r9;
+  int32_t i10;
+  int32_t i11;
+  int32_t i12;
+  int32_t i13;
+});
+
 IREE_VM_ABI_FIXED_STRUCT(rriiii, {
   iree_vm_ref_t r0;
   iree_vm_ref_t r1;
@@ -357,6 +423,14 @@ IREE_VM_ABI_VLA_STRUCT(rrrCrD, a3_count, a3, {
   iree_vm_abi_r_t a3[0];
 });
 
+IREE_VM_ABI_VLA_STRUCT(rrrCiD, a3_count, a3, {
+  iree_vm_ref_t r0;
+  iree_vm_ref_t r1;
+  iree_vm_ref_t r2;
+  iree_vm_size_t a3_count;
+  iree_vm_abi_i_t a3[0];
+});
+
 IREE_VM_ABI_VLA_STRUCT(rriCiD, a3_count, a3, {
   iree_vm_ref_t r0;
   iree_vm_ref_t r1;
@@ -405,6 +479,7 @@ IREE_VM_ABI_VLA_STRUCT(rriCiriiD, a3_count, a3, {
 //===----------------------------------------------------------------------===//
 
 IREE_VM_ABI_DECLARE_SHIM(irii, v);
+IREE_VM_ABI_DECLARE_SHIM(iriiii, v);
 IREE_VM_ABI_DECLARE_SHIM(r, i);
 IREE_VM_ABI_DECLARE_SHIM(r, ii);
 IREE_VM_ABI_DECLARE_SHIM(r, iii);
@@ -429,6 +504,11 @@ IREE_VM_ABI_DECLARE_SHIM(riii, r);
 IREE_VM_ABI_DECLARE_SHIM(riii, v);
 IREE_VM_ABI_DECLARE_SHIM(riirii, r);
 IREE_VM_ABI_DECLARE_SHIM(riiirii, r);
+IREE_VM_ABI_DECLARE_SHIM(riiriiii, v);
+IREE_VM_ABI_DECLARE_SHIM(riiriiriiii, v);
+IREE_VM_ABI_DECLARE_SHIM(riiriiriiiii, v);
+IREE_VM_ABI_DECLARE_SHIM(riiriiriiriiii, v);
+IREE_VM_ABI_DECLARE_SHIM(rrrCiD, v);
 IREE_VM_ABI_DECLARE_SHIM(rrrCrD, r);
 IREE_VM_ABI_DECLARE_SHIM(ririi, v);
 IREE_VM_ABI_DECLARE_SHIM(rr, i);
@@ -444,6 +524,7 @@ IREE_VM_ABI_DECLARE_SHIM(rriiii, v);
 IREE_VM_ABI_DECLARE_SHIM(rrirCiD, v);
 IREE_VM_ABI_DECLARE_SHIM(rriri, v);
 IREE_VM_ABI_DECLARE_SHIM(rririi, v);
+IREE_VM_ABI_DECLARE_SHIM(rrriii, r);
 IREE_VM_ABI_DECLARE_SHIM(rrriii, v);
 IREE_VM_ABI_DECLARE_SHIM(v, i);
 IREE_VM_ABI_DECLARE_SHIM(v, r);
@@ -188,6 +188,9 @@ struct iree_vm_stack_t {
   // Allocator used for dynamic stack allocations. May be the null allocator
   // if growth is prohibited.
   iree_allocator_t allocator;
+
+  // Optional sampler recording execution on the stack.
+  iree_vm_sampler_t* sampler;
 };
 
 //===----------------------------------------------------------------------===//
@@ -283,6 +286,12 @@ iree_vm_stack_invocation_flags(const iree_vm_stack_t* stack) {
   return stack->flags;
 }
 
+IREE_API_EXPORT iree_host_size_t
+iree_vm_stack_storage_capacity(const iree_vm_stack_t* stack) {
+  return iree_host_align(sizeof(iree_vm_stack_t), 16) +
+         stack->frame_storage_capacity;
+}
+
 IREE_API_EXPORT iree_vm_stack_frame_t* iree_vm_stack_current_frame(
     iree_vm_stack_t* stack) {
   return stack->top ? &stack->top->frame : NULL;
@@ -295,6 +304,25 @@ IREE_API_EXPORT iree_vm_stack_frame_t* iree_vm_stack_parent_frame(
   return parent_header ? &parent_header->frame : NULL;
 }
 
+IREE_API_EXPORT iree_vm_stack_frame_t* iree_vm_stack_frame_parent(
+    iree_vm_stack_frame_t* frame) {
+  iree_vm_stack_frame_header_t* header =
+      (iree_vm_stack_frame_header_t*)((uintptr_t)frame -
+                                      offsetof(iree_vm_stack_frame_header_t,
+                                               frame));
+  return header->parent ? &header->parent->frame : NULL;
+}
+
+IREE_API_EXPORT iree_vm_sampler_t* iree_vm_stack_sampler(
+    const iree_vm_stack_t* stack) {
+  return stack->sampler;
+}
+
+IREE_API_EXPORT void iree_vm_stack_set_sampler(iree_vm_stack_t* stack,
+                                               iree_vm_sampler_t* sampler) {
+  stack->sampler = sampler;
+}
+
 IREE_API_EXPORT iree_status_t iree_vm_stack_query_module_state(
     iree_vm_stack_t* stack, iree_vm_module_t* module,
     iree_vm_module_state_t** out_module_state) {
@@ -52,6 +52,9 @@ enum iree_vm_invocation_flag_bits_t {
 };
 typedef uint32_t iree_vm_invocation_flags_t;
 
+// A sampling profiler of VM execution. See iree/vm/sampler.h.
+typedef struct iree_vm_sampler_t iree_vm_sampler_t;
+
 typedef enum iree_vm_stack_frame_type_e {
   // Represents an `[external]` frame that needs to marshal args/results.
   // These frames have no source location and are tracked so that we know when
@@ -105,6 +108,12 @@ static inline void* iree_vm_stack_frame_storage(iree_vm_stack_frame_t* frame) {
 typedef void(IREE_API_PTR* iree_vm_stack_frame_cleanup_fn_t)(
     iree_vm_stack_frame_t* frame);
 
+// Returns the frame below |frame| in its stack or NULL if |frame| is the
+// bottom-most frame. Can be used to walk the stack starting from
+// iree_vm_stack_current_frame.
+IREE_API_EXPORT iree_vm_stack_frame_t* iree_vm_stack_frame_parent(
+    iree_vm_stack_frame_t* frame);
+
 // A state resolver that can allocate or lookup module state.
 typedef struct iree_vm_state_resolver_t {
   void* self;
@@ -192,6 +201,12 @@ IREE_API_EXPORT void iree_vm_stack_free(iree_vm_stack_t* stack);
 IREE_API_EXPORT iree_vm_invocation_flags_t
 iree_vm_stack_invocation_flags(const iree_vm_stack_t* stack);
 
+// Returns the total size in bytes of the storage |stack| currently uses,
+// including any dynamic growth. Storage of this size passed to
+// iree_vm_stack_initialize is able to hold the same frames without growing.
+IREE_API_EXPORT iree_host_size_t
+iree_vm_stack_storage_capacity(const iree_vm_stack_t* stack);
+
 // Returns the current stack frame or nullptr if the stack is empty.
 IREE_API_EXPORT iree_vm_stack_frame_t* iree_vm_stack_current_frame(
     iree_vm_stack_t* stack);
@@ -200,6 +215,15 @@ IREE_API_EXPORT iree_vm_stack_frame_t* iree_vm_stack_current_frame(
 IREE_API_EXPORT iree_vm_stack_frame_t* iree_vm_stack_parent_frame(
     iree_vm_stack_t* stack);
 
+// Returns the sampler recording execution on |stack| or NULL if not sampled.
+IREE_API_EXPORT iree_vm_sampler_t* iree_vm_stack_sampler(
+    const iree_vm_stack_t* stack);
+
+// Sets the |sampler| that will record execution on |stack|. The sampler is not
+// retained and must remain valid for the lifetime of the stack.
+IREE_API_EXPORT void iree_vm_stack_set_sampler(iree_vm_stack_t* stack,
+                                               iree_vm_sampler_t* sampler);
+
 // Queries the context-specific module state for the given module.
 IREE_API_EXPORT iree_status_t iree_vm_stack_query_module_state(
     iree_vm_stack_t* stack, iree_vm_module_t* module,
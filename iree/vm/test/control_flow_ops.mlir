@@ -85,4 +85,66 @@ vm.module @control_flow_ops {
     vm.fail %code, "unreachable!"
   }
 
+  //===--------------------------------------------------------------------===//
+  // vm.cmp.* + vm.cond_br fusion
+  //===--------------------------------------------------------------------===//
+
+  vm.export @test_cond_br_cmp_eq
+  vm.func @test_cond_br_cmp_eq() {
+    %c1 = vm.const.i32 1 : i32
+    %c1dno = util.do_not_optimize(%c1) : i32
+    %cmp = vm.cmp.eq.i32 %c1dno, %c1 : i32
+    vm.cond_br %cmp, ^bb1, ^bb2
+  ^bb1:
+    vm.return
+  ^bb2:
+    %code = vm.const.i32 4 : i32
+    vm.fail %code, "unreachable!"
+  }
+
+  vm.export @test_cond_br_cmp_ne
+  vm.func @test_cond_br_cmp_ne() {
+    %c1 = vm.const.i32 1 : i32
+    %c1dno = util.do_not_optimize(%c1) : i32
+    %cmp = vm.cmp.ne.i32 %c1dno, %c1 : i32
+    vm.cond_br %cmp, ^bb1, ^bb2
+  ^bb1:
+    %code = vm.const.i32 4 : i32
+    vm.fail %code, "unreachable!"
+  ^bb2:
+    vm.return
+  }
+
+  vm.export @test_cond_br_cmp_lt_s
+  vm.func @test_cond_br_cmp_lt_s() {
+    %cn1 = vm.const.i32 -1 : i32
+    %cn1dno = util.do_not_optimize(%cn1) : i32
+    %c1 = vm.const.i32 1 : i32
+    %c1dno = util.do_not_optimize(%c1) : i32
+    %cmp = vm.cmp.lt.i32.s %cn1dno, %c1dno : i32
+    vm.cond_br %cmp, ^bb1(%cn1dno : i32), ^bb2
+  ^bb1(%arg1 : i32):
+    vm.check.eq %arg1, %cn1dno, "error!" : i32
+    vm.return
+  ^bb2:
+    %code = vm.const.i32 4 : i32
+    vm.fail %code, "unreachable!"
+  }
+
+  vm.export @test_cond_br_cmp_lt_u
+  vm.func @test_cond_br_cmp_lt_u() {
+    %cn1 = vm.const.i32 -1 : i32
+    %cn1dno = util.do_not_optimize(%cn1) : i32
+    %c1 = vm.const.i32 1 : i32
+    %c1dno = util.do_not_optimize(%c1) : i32
+    %cmp = vm.cmp.lt.i32.u %cn1dno, %c1dno : i32
+    vm.cond_br %cmp, ^bb1, ^bb2(%c1dno : i32)
+  ^bb1:
+    %code = vm.const.i32 4 : i32
+    vm.fail %code, "unreachable!"
+  ^bb2(%arg2 : i32):
+    vm.check.eq %arg2, %c1dno, "error!" : i32
+    vm.return
+  }
+
 }
@@ -1131,6 +1131,228 @@ Operation *ReverseOp::getTiledImplementation(OpBuilder &builder,
   return tiledRevOp;
 }
 
+//===----------------------------------------------------------------------===//
+// AttentionOp
+//===----------------------------------------------------------------------===//
+
+static LogicalResult verifyAttentionOp(AttentionOp op) {
+  if (op.getNumInputs() != 3) {
+    return op.emitOpError("expected three input operands");
+  }
+  if (op.getNumOutputs() != 1) {
+    return op.emitOpError("expected one output operand");
+  }
+  ShapedType queryType = op.getQueryType();
+  ShapedType keyType = op.getKeyType();
+  ShapedType valueType = op.getValueType();
+  ShapedType outputType = op.getOutputType();
+  if (queryType.getRank() != 3 || keyType.getRank() != 3 ||
+      valueType.getRank() != 3 || outputType.getRank() != 3) {
+    return op.emitOpError("expected query/key/value/output to be rank 3");
+  }
+  Type elementType = outputType.getElementType();
+  if (!elementType.isa<FloatType>()) {
+    return op.emitOpError("expected float element type");
+  }
+  if (queryType.getElementType() != elementType ||
+      keyType.getElementType() != elementType ||
+      valueType.getElementType() != elementType) {
+    return op.emitOpError(
+        "expected query/key/value/output element types to be identical");
+  }
+  auto isCompatible = [](int64_t a, int64_t b) {
+    return a == ShapedType::kDynamicSize || b == ShapedType::kDynamicSize ||
+           a == b;
+  };
+  ArrayRef<int64_t> queryShape = queryType.getShape();
+  ArrayRef<int64_t> keyShape = keyType.getShape();
+  ArrayRef<int64_t> valueShape = valueType.getShape();
+  ArrayRef<int64_t> outputShape = outputType.getShape();
+  if (!isCompatible(queryShape[0], keyShape[0]) ||
+      !isCompatible(queryShape[0], valueShape[0]) ||
+      !isCompatible(queryShape[0], outputShape[0])) {
+    return op.emitOpError("incompatible batch dimensions");
+  }
+  if (!isCompatible(queryShape[2], keyShape[2])) {
+    return op.emitOpError("incompatible query/key head dimensions");
+  }
+  if (!isCompatible(keyShape[1], valueShape[1])) {
+    return op.emitOpError("incompatible key/value sequence dimensions");
+  }
+  if (!isCompatible(queryShape[1], outputShape[1]) ||
+      !isCompatible(valueShape[2], outputShape[2])) {
+    return op.emitOpError("incompatible output shape");
+  }
+  return success();
+}
+
+bool AttentionOp::payloadUsesValueFromOperand(OpOperand *) { return false; }
+
+SmallVector<StringRef> AttentionOp::getLoopIteratorTypes() {
+  // The (batch, query) loops; the key loop is internal to the op.
+  SmallVector<StringRef> iteratorTypes(2, getParallelIteratorTypeName());
+  return iteratorTypes;
+}
+
+SmallVector<Range> AttentionOp::getIterationDomain(OpBuilder &builder) {
+  Location loc = getLoc();
+  Value zero = builder.create<arith::ConstantIndexOp>(loc, 0);
+  Value one = builder.create<arith::ConstantIndexOp>(loc, 1);
+  SmallVector<Range> ranges;
+  for (auto dim : llvm::seq<int64_t>(0, 2)) {
+    Value ub = getDimValue(builder, loc, query(), dim);
+    ranges.emplace_back(Range{zero, ub, one});
+  }
+  return ranges;
+}
+
+// Generates the implementation for a single query row using an online
+// softmax (https://arxiv.org/abs/1805.02867):
+//   max = -inf, sum = 0, output[b, m, :] = 0
+//   for k in [0, N):
+//     score = dot(query[b, m, :], key[b, k, :])
+//     newMax = max(max, score)
+//     correction = exp(max - newMax)
+//     p = exp(score - newMax)
+//     sum = sum * correction + p
+//     output[b, m, :] = output[b, m, :] * correction + p * value[b, k, :]
+//     max = newMax
+//   output[b, m, :] /= sum
+LogicalResult AttentionOp::generateScalarImplementation(OpBuilder &b,
+                                                        Location loc,
+                                                        ValueRange ivs) {
+  Value batch = ivs[0];
+  Value row = ivs[1];
+  Value zero = b.create<arith::ConstantIndexOp>(loc, 0);
+  Value one = b.create<arith::ConstantIndexOp>(loc, 1);
+  Value keyCount = getDimValue(b, loc, key(), 1);
+  Value headSize = getDimValue(b, loc, query(), 2);
+  Value valueSize = getDimValue(b, loc, value(), 2);
+
+  auto elementType = getOutputType().getElementType().cast<FloatType>();
+  Value zeroF =
+      b.create<arith::ConstantOp>(loc, b.getFloatAttr(elementType, 0.0));
+  Value negInfF = b.create<arith::ConstantOp>(
+      loc, b.getFloatAttr(elementType,
+                          APFloat::getInf(elementType.getFloatSemantics(),
+                                          /*Negative=*/true)));
+
+  b.create<scf::ForOp>(
+      loc, zero, valueSize, one, ValueRange{},
+      [&](OpBuilder &b, Location loc, Value iv, ValueRange) {
+        b.create<memref::StoreOp>(loc, zeroF, output(),
+                                  ValueRange{batch, row, iv});
+        b.create<scf::YieldOp>(loc);
+      });
+
+  auto keyLoop = b.create<scf::ForOp>(
+      loc, zero, keyCount, one, ValueRange{negInfF, zeroF},
+      [&](OpBuilder &b, Location loc, Value k, ValueRange iterArgs) {
+        Value oldMax = iterArgs[0];
+        Value oldSum = iterArgs[1];
+        auto dotLoop = b.create<scf::ForOp>(
+            loc, zero, headSize, one, ValueRange{zeroF},
+            [&](OpBuilder &b, Location loc, Value iv, ValueRange acc) {
+              Value q = b.create<memref::LoadOp>(loc, query(),
+                                                 ValueRange{batch, row, iv});
+              Value kv = b.create<memref::LoadOp>(loc, key(),
+                                                  ValueRange{batch, k, iv});
+              Value product = b.create<arith::MulFOp>(loc, q, kv);
+              Value sum = b.create<arith::AddFOp>(loc, acc[0], product);
+              b.create<scf::YieldOp>(loc, sum);
+            });
+        Value score = dotLoop.getResult(0);
+        Value newMax = b.create<arith::MaxFOp>(loc, oldMax, score);
+        Value correction = b.create<math::ExpOp>(
+            loc, b.create<arith::SubFOp>(loc, oldMax, newMax));
+        Value p = b.create<math::ExpOp>(
+            loc, b.create<arith::SubFOp>(loc, score, newMax));
+        Value newSum = b.create<arith::AddFOp>(
+            loc, b.create<arith::MulFOp>(loc, oldSum, correction), p);
+        b.create<scf::ForOp>(
+            loc, zero, valueSize, one, ValueRange{},
+            [&](OpBuilder &b, Location loc, Value iv, ValueRange) {
+              Value o = b.create<memref::LoadOp>(loc, output(),
+                                                 ValueRange{batch, row, iv});
+              Value v = b.create<memref::LoadOp>(loc, value(),
+                                                 ValueRange{batch, k, iv});
+              Value scaled = b.create<arith::MulFOp>(loc, o, correction);
+              Value weighted = b.create<arith::MulFOp>(loc, p, v);
+              Value updated = b.create<arith::AddFOp>(loc, scaled, weighted);
+              b.create<memref::StoreOp>(loc, updated, output(),
+                                        ValueRange{batch, row, iv});
+              b.create<scf::YieldOp>(loc);
+            });
+        b.create<scf::YieldOp>(loc, ValueRange{newMax, newSum});
+      });
+
+  Value sum = keyLoop.getResult(1);
+  b.create<scf::ForOp>(
+      loc, zero, valueSize, one, ValueRange{},
+      [&](OpBuilder &b, Location loc, Value iv, ValueRange) {
+        Value o = b.create<memref::LoadOp>(loc, output(),
+                                           ValueRange{batch, row, iv});
+        Value normalized = b.create<arith::DivFOp>(loc, o, sum);
+        b.create<memref::StoreOp>(loc, normalized, output(),
+                                  ValueRange{batch, row, iv});
+        b.create<scf::YieldOp>(loc);
+      });
+  return success();
+}
+
+Operation *AttentionOp::getTiledImplementation(
+    OpBuilder &builder, ValueRange outputs, ArrayRef<OpFoldResult> offsets,
+    ArrayRef<OpFoldResult> sizes, SmallVectorImpl<Value> &results) {
+  assert(outputs.size() == 1);
+  assert(offsets.size() == 2 && sizes.size() == 2);
+  Location loc = getLoc();
+  OpFoldResult zeroAttr = builder.getI64IntegerAttr(0);
+  SmallVector<OpFoldResult> strides(3, builder.getI64IntegerAttr(1));
+
+  // Query rows and output rows are tiled; all keys/values of the batch tile
+  // are needed by every query row.
+  SmallVector<OpFoldResult> queryOffsets = {offsets[0], offsets[1], zeroAttr};
+  SmallVector<OpFoldResult> querySizes = {sizes[0], sizes[1],
+                                          getDim(builder, loc, query(), 2)};
+  SmallVector<OpFoldResult> keyOffsets = {offsets[0], zeroAttr, zeroAttr};
+  SmallVector<OpFoldResult> keySizes = {sizes[0],
+                                        getDim(builder, loc, key(), 1),
+                                        getDim(builder, loc, key(), 2)};
+  SmallVector<OpFoldResult> valueSizes = {sizes[0],
+                                          getDim(builder, loc, value(), 1),
+                                          getDim(builder, loc, value(), 2)};
+  SmallVector<OpFoldResult> outputOffsets = {offsets[0], offsets[1], zeroAttr};
+  SmallVector<OpFoldResult> outputSizes = {sizes[0], sizes[1],
+                                           getDim(builder, loc, outputs[0], 2)};
+
+  SmallVector<Value> tiledOperands;
+  tiledOperands.emplace_back(
+      getSlice(builder, loc, query(), queryOffsets, querySizes, strides));
+  tiledOperands.emplace_back(
+      getSlice(builder, loc, key(), keyOffsets, keySizes, strides));
+  tiledOperands.emplace_back(
+      getSlice(builder, loc, value(), keyOffsets, valueSizes, strides));
+  tiledOperands.emplace_back(getSlice(builder, loc, outputs[0], outputOffsets,
+                                      outputSizes, strides));
+
+  SmallVector<Type, 4> resultTypes;
+  if (hasTensorSemantics()) {
+    resultTypes.push_back(tiledOperands[3].getType());
+  }
+
+  Operation *tiledAttentionOp =
+      cast<LinalgExtOp>(getOperation())
+          .clone(builder, loc, resultTypes, tiledOperands);
+
+  for (auto result : llvm::enumerate(tiledAttentionOp->getResults())) {
+    auto insertSliceOp = builder.create<tensor::InsertSliceOp>(
+        loc, result.value(), outputs[result.index()], outputOffsets,
+        outputSizes, strides);
+    results.push_back(insertSliceOp.getResult());
+  }
+  return tiledAttentionOp;
+}
+
 #define DEFINE_OP_GET_EFFECTS(OP_NAME)                                    \
   void OP_NAME::getEffects(                                               \
       SmallVectorImpl<SideEffects::EffectInstance<MemoryEffects::Effect>> \
@@ -1146,6 +1368,7 @@ DEFINE_OP_GET_EFFECTS(SortOp)
 DEFINE_OP_GET_EFFECTS(FftOp)
 DEFINE_OP_GET_EFFECTS(ReverseOp)
 DEFINE_OP_GET_EFFECTS(ScanOp)
+DEFINE_OP_GET_EFFECTS(AttentionOp)
 
 namespace {
 /// This is derived from mlir/lib/Dialect/Linalg/IR/LinalgOps.cpp without any
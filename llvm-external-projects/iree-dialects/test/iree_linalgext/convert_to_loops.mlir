@@ -604,3 +604,59 @@ func @scan_2d(%0: memref<16x32xi32>, %1: memref<16x32xi32>) {
 // CHECK:               memref.store %[[V4]], %[[BUFO]][%[[ARG1]], %[[ARG2]]]
 // CHECK:               memref.store %[[V4]], %[[ACC]][%[[ARG2]]]
 // CHECK:             }
+
+// -----
+
+func @attention(%query: memref<2x40x16xf32>, %key: memref<2x64x16xf32>,
+                %value: memref<2x64x32xf32>, %output: memref<2x40x32xf32>) {
+  iree_linalg_ext.attention
+    ins(%query, %key, %value : memref<2x40x16xf32>, memref<2x64x16xf32>, memref<2x64x32xf32>)
+    outs(%output : memref<2x40x32xf32>)
+  return
+}
+// CHECK-LABEL: func @attention
+//  CHECK-SAME:    %[[QUERY:[a-zA-Z0-9]+]]
+//  CHECK-SAME:    %[[KEY:[a-zA-Z0-9]+]]
+//  CHECK-SAME:    %[[VALUE:[a-zA-Z0-9]+]]
+//  CHECK-SAME:    %[[OUTPUT:[a-zA-Z0-9]+]]
+//   CHECK-DAG:    %[[C0:.+]] = arith.constant 0 : index
+//   CHECK-DAG:    %[[C1:.+]] = arith.constant 1 : index
+//   CHECK-DAG:    %[[C2:.+]] = arith.constant 2 : index
+//   CHECK-DAG:    %[[C16:.+]] = arith.constant 16 : index
+//   CHECK-DAG:    %[[C32:.+]] = arith.constant 32 : index
+//   CHECK-DAG:    %[[C40:.+]] = arith.constant 40 : index
+//   CHECK-DAG:    %[[C64:.+]] = arith.constant 64 : index
+//   CHECK-DAG:    %[[ZERO:.+]] = arith.constant 0.000000e+00 : f32
+//   CHECK-DAG:    %[[NEG_INF:.+]] = arith.constant 0xFF800000 : f32
+//       CHECK:    scf.for %[[B:.+]] = %[[C0]] to %[[C2]] step %[[C1]]
+//       CHECK:      scf.for %[[M:.+]] = %[[C0]] to %[[C40]] step %[[C1]]
+//       CHECK:        scf.for %[[E0:.+]] = %[[C0]] to %[[C32]] step %[[C1]]
+//       CHECK:          memref.store %[[ZERO]], %[[OUTPUT]][%[[B]], %[[M]], %[[E0]]]
+//       CHECK:        %[[STATS:.+]]:2 = scf.for %[[K:.+]] = %[[C0]] to %[[C64]] step %[[C1]]
+//  CHECK-SAME:            iter_args(%[[MAX:.+]] = %[[NEG_INF]], %[[SUM:.+]] = %[[ZERO]])
+//       CHECK:          %[[SCORE:.+]] = scf.for %[[D:.+]] = %[[C0]] to %[[C16]] step %[[C1]]
+//  CHECK-SAME:              iter_args(%[[ACC:.+]] = %[[ZERO]])
+//       CHECK:            %[[Q:.+]] = memref.load %[[QUERY]][%[[B]], %[[M]], %[[D]]]
+//       CHECK:            %[[KV:.+]] = memref.load %[[KEY]][%[[B]], %[[K]], %[[D]]]
+//       CHECK:            %[[QK:.+]] = arith.mulf %[[Q]], %[[KV]]
+//       CHECK:            %[[DOT:.+]] = arith.addf %[[ACC]], %[[QK]]
+//       CHECK:            scf.yield %[[DOT]]
+//       CHECK:          %[[NEW_MAX:.+]] = arith.maxf %[[MAX]], %[[SCORE]]
+//       CHECK:          %[[DIFF:.+]] = arith.subf %[[MAX]], %[[NEW_MAX]]
+//       CHECK:          %[[CORRECTION:.+]] = math.exp %[[DIFF]]
+//       CHECK:          %[[SHIFTED:.+]] = arith.subf %[[SCORE]], %[[NEW_MAX]]
+//       CHECK:          %[[P:.+]] = math.exp %[[SHIFTED]]
+//       CHECK:          %[[SCALED_SUM:.+]] = arith.mulf %[[SUM]], %[[CORRECTION]]
+//       CHECK:          %[[NEW_SUM:.+]] = arith.addf %[[SCALED_SUM]], %[[P]]
+//       CHECK:          scf.for %[[E1:.+]] = %[[C0]] to %[[C32]] step %[[C1]]
+//       CHECK:            %[[O:.+]] = memref.load %[[OUTPUT]][%[[B]], %[[M]], %[[E1]]]
+//       CHECK:            %[[V:.+]] = memref.load %[[VALUE]][%[[B]], %[[K]], %[[E1]]]
+//       CHECK:            %[[SCALED:.+]] = arith.mulf %[[O]], %[[CORRECTION]]
+//       CHECK:            %[[WEIGHTED:.+]] = arith.mulf %[[P]], %[[V]]
+//       CHECK:            %[[UPDATED:.+]] = arith.addf %[[SCALED]], %[[WEIGHTED]]
+//       CHECK:            memref.store %[[UPDATED]], %[[OUTPUT]][%[[B]], %[[M]], %[[E1]]]
+//       CHECK:          scf.yield %[[NEW_MAX]], %[[NEW_SUM]]
+//       CHECK:        scf.for %[[E2:.+]] = %[[C0]] to %[[C32]] step %[[C1]]
+//       CHECK:          %[[O:.+]] = memref.load %[[OUTPUT]][%[[B]], %[[M]], %[[E2]]]
+//       CHECK:          %[[NORMALIZED:.+]] = arith.divf %[[O]], %[[STATS]]#1
+//       CHECK:          memref.store %[[NORMALIZED]], %[[OUTPUT]][%[[B]], %[[M]], %[[E2]]]
@@ -416,3 +416,39 @@ func @reverse_dup_dims(%arg0: tensor<3x5xi32>) -> tensor<3x5xi32> {
          outs(%init : tensor<3x5xi32>) : tensor<3x5xi32>
   return %0 : tensor<3x5xi32>
 }
+
+// -----
+
+func @attention_head_mismatch(%query: tensor<2x40x16xf32>, %key: tensor<2x64x8xf32>,
+                              %value: tensor<2x64x32xf32>) -> tensor<2x40x32xf32> {
+  %init = linalg.init_tensor [2, 40, 32] : tensor<2x40x32xf32>
+  // expected-error @+1 {{incompatible query/key head dimensions}}
+  %0 = iree_linalg_ext.attention
+         ins(%query, %key, %value : tensor<2x40x16xf32>, tensor<2x64x8xf32>, tensor<2x64x32xf32>)
+         outs(%init : tensor<2x40x32xf32>) -> tensor<2x40x32xf32>
+  return %0 : tensor<2x40x32xf32>
+}
+
+// -----
+
+func @attention_sequence_mismatch(%query: tensor<2x40x16xf32>, %key: tensor<2x64x16xf32>,
+                                  %value: tensor<2x48x32xf32>) -> tensor<2x40x32xf32> {
+  %init = linalg.init_tensor [2, 40, 32] : tensor<2x40x32xf32>
+  // expected-error @+1 {{incompatible key/value sequence dimensions}}
+  %0 = iree_linalg_ext.attention
+         ins(%query, %key, %value : tensor<2x40x16xf32>, tensor<2x64x16xf32>, tensor<2x48x32xf32>)
+         outs(%init : tensor<2x40x32xf32>) -> tensor<2x40x32xf32>
+  return %0 : tensor<2x40x32xf32>
+}
+
+// -----
+
+func @attention_integer(%query: tensor<2x40x16xi32>, %key: tensor<2x64x16xi32>,
+                        %value: tensor<2x64x32xi32>) -> tensor<2x40x32xi32> {
+  %init = linalg.init_tensor [2, 40, 32] : tensor<2x40x32xi32>
+  // expected-error @+1 {{expected float element type}}
+  %0 = iree_linalg_ext.attention
+         ins(%query, %key, %value : tensor<2x40x16xi32>, tensor<2x64x16xi32>, tensor<2x64x32xi32>)
+         outs(%init : tensor<2x40x32xi32>) -> tensor<2x40x32xi32>
+  return %0 : tensor<2x40x32xi32>
+}
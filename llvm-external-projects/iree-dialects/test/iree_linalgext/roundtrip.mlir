@@ -492,3 +492,37 @@ func @reverse_multi_dims(%arg0: tensor<3x5xi32>) -> tensor<3x5xi32> {
 //  CHECK-SAME:      dimensions(dense<[0, 1]> : tensor<2xi64>)
 //  CHECK-SAME:      ins(%[[ARG0]]
 //  CHECK-SAME:      outs(%[[INIT]]
+
+// -----
+
+func @attention_tensor(%query: tensor<2x40x16xf32>, %key: tensor<2x64x16xf32>,
+                       %value: tensor<2x64x32xf32>) -> tensor<2x40x32xf32> {
+  %init = linalg.init_tensor [2, 40, 32] : tensor<2x40x32xf32>
+  %0 = iree_linalg_ext.attention
+         ins(%query, %key, %value : tensor<2x40x16xf32>, tensor<2x64x16xf32>, tensor<2x64x32xf32>)
+         outs(%init : tensor<2x40x32xf32>) -> tensor<2x40x32xf32>
+  return %0 : tensor<2x40x32xf32>
+}
+// CHECK-LABEL: func @attention_tensor
+//  CHECK-SAME:   %[[QUERY:[a-zA-Z0-9]+]]: tensor<2x40x16xf32>
+//  CHECK-SAME:   %[[KEY:[a-zA-Z0-9]+]]: tensor<2x64x16xf32>
+//  CHECK-SAME:   %[[VALUE:[a-zA-Z0-9]+]]: tensor<2x64x32xf32>
+//       CHECK:   %[[INIT:.+]] = linalg.init_tensor [2, 40, 32]
+//       CHECK:   %[[RESULT:.+]] = iree_linalg_ext.attention
+//  CHECK-SAME:      ins(%[[QUERY]], %[[KEY]], %[[VALUE]]
+//  CHECK-SAME:      outs(%[[INIT]]
+//       CHECK:   return %[[RESULT]]
+
+// -----
+
+func @attention_memref(%query: memref<?x?x?xf32>, %key: memref<?x?x?xf32>,
+                       %value: memref<?x?x?xf32>, %output: memref<?x?x?xf32>) {
+  iree_linalg_ext.attention
+    ins(%query, %key, %value : memref<?x?x?xf32>, memref<?x?x?xf32>, memref<?x?x?xf32>)
+    outs(%output : memref<?x?x?xf32>)
+  return
+}
+// CHECK-LABEL: func @attention_memref
+//       CHECK:   iree_linalg_ext.attention
+//  CHECK-SAME:      ins(%{{.+}}, %{{.+}}, %{{.+}} : memref<?x?x?xf32>, memref<?x?x?xf32>, memref<?x?x?xf32>)
+//  CHECK-SAME:      outs(%{{.+}} : memref<?x?x?xf32>)
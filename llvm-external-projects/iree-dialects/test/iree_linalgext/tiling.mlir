@@ -1270,3 +1270,36 @@ func @scan_2d_memref(%0: memref<16x32xi32>, %1: memref<16x32xi32>) {
 // CHECK-SAME:       ins(%[[UPDATE_SLICE_IN]]
 // CHECK-SAME:       outs(%[[UPDATE_SLICE_OUT]], %[[UPDATE_SLICE_ACC]]
 //      CHECK:   return
+
+// -----
+
+func @attention(%query: tensor<2x40x16xf32>, %key: tensor<2x64x16xf32>,
+                %value: tensor<2x64x32xf32>) -> tensor<2x40x32xf32> {
+  %init = linalg.init_tensor [2, 40, 32] : tensor<2x40x32xf32>
+  %0 = iree_linalg_ext.attention
+         {__internal_linalg_transform__ = "outer_reduce_input"}
+         ins(%query, %key, %value : tensor<2x40x16xf32>, tensor<2x64x16xf32>, tensor<2x64x32xf32>)
+         outs(%init : tensor<2x40x32xf32>) -> tensor<2x40x32xf32>
+  return %0 : tensor<2x40x32xf32>
+}
+//      CHECK: func @attention(
+// CHECK-SAME:   %[[QUERY:[a-zA-Z0-9_]+]]
+// CHECK-SAME:   %[[KEY:[a-zA-Z0-9_]+]]
+// CHECK-SAME:   %[[VALUE:[a-zA-Z0-9_]+]]
+//  CHECK-DAG:   %[[C0:.+]] = arith.constant 0 : index
+//  CHECK-DAG:   %[[C20:.+]] = arith.constant 20 : index
+//  CHECK-DAG:   %[[C40:.+]] = arith.constant 40 : index
+//      CHECK:   %[[INIT:.+]] = linalg.init_tensor [2, 40, 32]
+//      CHECK:   %[[RESULT:.+]] = scf.for %[[I:.+]] = %[[C0]] to %[[C40]] step %[[C20]]
+// CHECK-SAME:       iter_args(%[[ARG:.+]] = %[[INIT]])
+//      CHECK:     %[[QUERY_SLICE:.+]] = tensor.extract_slice %[[QUERY]][0, %[[I]], 0]
+//      CHECK:     %[[KEY_SLICE:.+]] = tensor.extract_slice %[[KEY]][0, 0, 0] [2, 64, 16]
+//      CHECK:     %[[VALUE_SLICE:.+]] = tensor.extract_slice %[[VALUE]][0, 0, 0] [2, 64, 32]
+//      CHECK:     %[[OUTPUT_SLICE:.+]] = tensor.extract_slice %[[ARG]][0, %[[I]], 0]
+//      CHECK:     %[[TILE:.+]] = iree_linalg_ext.attention
+// CHECK-SAME:         {__internal_linalg_transform__ = "outer_reduce_output"}
+// CHECK-SAME:         ins(%[[QUERY_SLICE]], %[[KEY_SLICE]], %[[VALUE_SLICE]]
+// CHECK-SAME:         outs(%[[OUTPUT_SLICE]]
+//      CHECK:     %[[YIELD:.+]] = tensor.insert_slice %[[TILE]] into %[[ARG]][0, %[[I]], 0]
+//      CHECK:     scf.yield %[[YIELD]]
+//      CHECK:   return %[[RESULT]]
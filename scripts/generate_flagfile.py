@@ -26,12 +26,13 @@ def parse_arguments():
                       help="The name of the IREE driver")
   parser.add_argument("--entry_function",
                       type=str,
-                      required=True,
+                      default="",
                       metavar="<entry-function>",
-                      help="The name of the entry function")
+                      help="The name of the entry function; all exported "
+                      "functions are benchmarked if omitted")
   parser.add_argument("--function_inputs",
                       type=str,
-                      required=True,
+                      default="",
                       metavar="<function-inputs>",
                       help="A list of comma-separated function inputs")
   parser.add_argument("--additional_args",
@@ -49,14 +50,15 @@ def parse_arguments():
 
 
 def main(args):
-  lines = [
-      f"--driver={args.driver}", f"--module_file={args.module_file}",
-      f"--entry_function={args.entry_function}"
-  ]
-  lines.extend([
-      ("--function_input=" + e) for e in args.function_inputs.split(",")
-  ])
-  lines.extend(args.additional_args.split(";"))
+  lines = [f"--driver={args.driver}", f"--module_file={args.module_file}"]
+  if args.entry_function:
+    lines.append(f"--entry_function={args.entry_function}")
+  if args.function_inputs:
+    lines.extend([
+        ("--function_input=" + e) for e in args.function_inputs.split(",")
+    ])
+  if args.additional_args:
+    lines.extend(args.additional_args.split(";"))
   content = "\n".join(lines) + "\n"
 
   with open(args.output, "w") as f: